@@ -0,0 +1,52 @@
+# CREATE INDEX CONCURRENTLY skips all-visible heap pages when validating the
+# new index.  Rows that a transaction which does not yet maintain the index
+# puts onto such a page after the initial build must still get indexed: the
+# change clears the page's visibility map bit, so validation cannot skip it.
+
+setup
+{
+  CREATE EXTENSION amcheck;
+  CREATE TABLE cic_vm (id int, val int)
+    WITH (fillfactor = 50, autovacuum_enabled = off);
+  INSERT INTO cic_vm SELECT g, g FROM generate_series(1, 30000) g;
+}
+
+setup
+{
+  VACUUM cic_vm;
+}
+
+teardown
+{
+  DROP TABLE cic_vm;
+  DROP EXTENSION amcheck;
+}
+
+session "s1"
+step "s1_begin"		{ BEGIN; INSERT INTO cic_vm VALUES (0, 0); }
+step "s1_commit"	{ COMMIT; }
+
+session "s2"
+step "s2_cic"		{ CREATE INDEX CONCURRENTLY cic_vm_val_idx ON cic_vm (val); }
+step "s2_check"		{ SELECT bt_index_check('cic_vm_val_idx', true); }
+step "s2_count"
+{
+  SET enable_seqscan = off;
+  SELECT count(*) FROM cic_vm WHERE val < 0;
+}
+
+session "s3"
+# Starts writing while s2's CIC is still waiting for s1, so it will not see
+# the index until its transaction ends.
+step "s3_begin"		{ BEGIN; UPDATE cic_vm SET val = -val WHERE id = 5000; }
+# Touches pages far away from the one s3_begin touched, which were
+# all-visible when the CIC started.  Whether this happens before or after
+# the initial build, the build cannot see these changes.
+step "s3_update"
+{
+  UPDATE cic_vm SET val = -val WHERE id BETWEEN 20000 AND 20010;
+  INSERT INTO cic_vm SELECT -g, -g FROM generate_series(1, 5) g;
+}
+step "s3_commit"	{ COMMIT; }
+
+permutation "s1_begin" "s2_cic" "s3_begin" "s1_commit" "s3_update" "s3_commit" "s2_check" "s2_count"
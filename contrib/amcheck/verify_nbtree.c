@@ -125,9 +125,10 @@ static void bt_check_every_level(Relation rel, Relation heaprel,
 static BtreeLevel bt_check_level_from_leftmost(BtreeCheckState *state,
 							 BtreeLevel level);
 static void bt_target_page_check(BtreeCheckState *state);
-static ScanKey bt_right_page_check_scankey(BtreeCheckState *state);
+static ScanKey bt_right_page_check_scankey(BtreeCheckState *state,
+							int *keysz);
 static void bt_downlink_check(BtreeCheckState *state, BlockNumber childblock,
-				  ScanKey targetkey);
+				  ScanKey targetkey, int keysz);
 static void bt_downlink_missing_check(BtreeCheckState *state);
 static void bt_tuple_present_callback(Relation index, HeapTuple htup,
 						  Datum *values, bool *isnull,
@@ -135,14 +136,14 @@ static void bt_tuple_present_callback(Relation index, HeapTuple htup,
 static inline bool offset_is_negative_infinity(BTPageOpaque opaque,
 							OffsetNumber offset);
 static inline bool invariant_leq_offset(BtreeCheckState *state,
-					 ScanKey key,
+					 ScanKey key, int keysz,
 					 OffsetNumber upperbound);
 static inline bool invariant_geq_offset(BtreeCheckState *state,
-					 ScanKey key,
+					 ScanKey key, int keysz,
 					 OffsetNumber lowerbound);
 static inline bool invariant_leq_nontarget_offset(BtreeCheckState *state,
 							   Page other,
-							   ScanKey key,
+							   ScanKey key, int keysz,
 							   OffsetNumber upperbound);
 static Page palloc_btree_page(BtreeCheckState *state, BlockNumber blocknum);
 
@@ -835,6 +836,7 @@ bt_target_page_check(BtreeCheckState *state)
 		ItemId		itemid;
 		IndexTuple	itup;
 		ScanKey		skey;
+		int			keysz;
 		size_t		tupsize;
 
 		CHECK_FOR_INTERRUPTS();
@@ -904,10 +906,58 @@ bt_target_page_check(BtreeCheckState *state)
 
 		/* Build insertion scankey for current page offset */
 		skey = _bt_mkscankey(state->rel, itup);
+		keysz = BTreeTupleGetNKeyAtts(itup, state->rel);
+
+		/*
+		 * Every heap TID of a posting list tuple must be valid.  They are
+		 * kept in page order rather than sorted, so there is no order to
+		 * check.
+		 */
+		if (BTreeTupleIsPosting(itup))
+		{
+			int			i;
+
+			for (i = 0; i < BTreeTupleGetNPosting(itup); i++)
+			{
+				if (!ItemPointerIsValid(BTreeTupleGetPostingN(itup, i)))
+					ereport(ERROR,
+							(errcode(ERRCODE_INDEX_CORRUPTED),
+							 errmsg("posting list contains invalid heap TID in index \"%s\"",
+									RelationGetRelationName(state->rel)),
+							 errdetail_internal("Index tid=(%u,%u) posting list offset=%d page lsn=%X/%X.",
+												state->targetblock, offset, i,
+												(uint32) (state->targetlsn >> 32),
+												(uint32) state->targetlsn)));
+			}
+		}
 
 		/* Fingerprint leaf page tuples (those that point to the heap) */
 		if (state->heapallindexed && P_ISLEAF(topaque) && !ItemIdIsDead(itemid))
-			bloom_add_element(state->filter, (unsigned char *) itup, tupsize);
+		{
+			if (!BTreeTupleIsPosting(itup))
+				bloom_add_element(state->filter, (unsigned char *) itup, tupsize);
+			else
+			{
+				int			i;
+
+				/*
+				 * Fingerprint each heap TID of a posting list tuple as the
+				 * plain tuple that it stands for, which is what the heap
+				 * scan will look for
+				 */
+				for (i = 0; i < BTreeTupleGetNPosting(itup); i++)
+				{
+					IndexTuple	logtuple;
+
+					logtuple = _bt_form_posting(itup,
+												BTreeTupleGetPostingN(itup, i),
+												1);
+					bloom_add_element(state->filter, (unsigned char *) logtuple,
+									  IndexTupleSize(logtuple));
+					pfree(logtuple);
+				}
+			}
+		}
 
 		/*
 		 * * High key check *
@@ -930,7 +980,7 @@ bt_target_page_check(BtreeCheckState *state)
 		 * and probably not markedly more effective in practice.
 		 */
 		if (!P_RIGHTMOST(topaque) &&
-			!invariant_leq_offset(state, skey, P_HIKEY))
+			!invariant_leq_offset(state, skey, keysz, P_HIKEY))
 		{
 			char	   *itid,
 					   *htid;
@@ -959,7 +1009,7 @@ bt_target_page_check(BtreeCheckState *state)
 		 * current item is less than or equal to next item (if any).
 		 */
 		if (OffsetNumberNext(offset) <= max &&
-			!invariant_leq_offset(state, skey,
+			!invariant_leq_offset(state, skey, keysz,
 								  OffsetNumberNext(offset)))
 		{
 			char	   *itid,
@@ -1018,12 +1068,13 @@ bt_target_page_check(BtreeCheckState *state)
 		else if (offset == max)
 		{
 			ScanKey		rightkey;
+			int			rightkeysz;
 
 			/* Get item in next/right page */
-			rightkey = bt_right_page_check_scankey(state);
+			rightkey = bt_right_page_check_scankey(state, &rightkeysz);
 
 			if (rightkey &&
-				!invariant_geq_offset(state, rightkey, max))
+				!invariant_geq_offset(state, rightkey, rightkeysz, max))
 			{
 				/*
 				 * As explained at length in bt_right_page_check_scankey(),
@@ -1069,7 +1120,7 @@ bt_target_page_check(BtreeCheckState *state)
 		{
 			BlockNumber childblock = BTreeInnerTupleGetDownLink(itup);
 
-			bt_downlink_check(state, childblock, skey);
+			bt_downlink_check(state, childblock, skey, keysz);
 		}
 	}
 
@@ -1099,10 +1150,11 @@ bt_target_page_check(BtreeCheckState *state)
  * been concurrently deleted.
  */
 static ScanKey
-bt_right_page_check_scankey(BtreeCheckState *state)
+bt_right_page_check_scankey(BtreeCheckState *state, int *keysz)
 {
 	BTPageOpaque opaque;
 	ItemId		rightitem;
+	IndexTuple	firstitup;
 	BlockNumber targetnext;
 	Page		rightpage;
 	OffsetNumber nline;
@@ -1287,11 +1339,12 @@ bt_right_page_check_scankey(BtreeCheckState *state)
 	}
 
 	/*
-	 * Return first real item scankey.  Note that this relies on right page
-	 * memory remaining allocated.
+	 * Return first real item scankey, and its size.  Note that this relies
+	 * on right page memory remaining allocated.
 	 */
-	return _bt_mkscankey(state->rel,
-						 (IndexTuple) PageGetItem(rightpage, rightitem));
+	firstitup = (IndexTuple) PageGetItem(rightpage, rightitem);
+	*keysz = BTreeTupleGetNKeyAtts(firstitup, state->rel);
+	return _bt_mkscankey(state->rel, firstitup);
 }
 
 /*
@@ -1305,7 +1358,7 @@ bt_right_page_check_scankey(BtreeCheckState *state)
  */
 static void
 bt_downlink_check(BtreeCheckState *state, BlockNumber childblock,
-				  ScanKey targetkey)
+				  ScanKey targetkey, int keysz)
 {
 	OffsetNumber offset;
 	OffsetNumber maxoffset;
@@ -1411,7 +1464,7 @@ bt_downlink_check(BtreeCheckState *state, BlockNumber childblock,
 			continue;
 
 		if (!invariant_leq_nontarget_offset(state, child,
-											targetkey, offset))
+											targetkey, keysz, offset))
 			ereport(ERROR,
 					(errcode(ERRCODE_INDEX_CORRUPTED),
 					 errmsg("down-link lower bound invariant violated for index \"%s\"",
@@ -1736,8 +1789,8 @@ offset_is_negative_infinity(BTPageOpaque opaque, OffsetNumber offset)
 	 * within page.
 	 *
 	 * Negative infinity items are a special case among pivot tuples.  They
-	 * always have zero attributes, while all other pivot tuples always have
-	 * nkeyatts attributes.
+	 * always have zero attributes, while all other pivot tuples have between
+	 * one and nkeyatts attributes.
 	 *
 	 * Right-most pages don't have a high key, but could be said to
 	 * conceptually have a "positive infinity" high key.  Thus, there is a
@@ -1759,13 +1812,12 @@ offset_is_negative_infinity(BTPageOpaque opaque, OffsetNumber offset)
  * to corruption.
  */
 static inline bool
-invariant_leq_offset(BtreeCheckState *state, ScanKey key,
+invariant_leq_offset(BtreeCheckState *state, ScanKey key, int keysz,
 					 OffsetNumber upperbound)
 {
-	int16		nkeyatts = IndexRelationGetNumberOfKeyAttributes(state->rel);
 	int32		cmp;
 
-	cmp = _bt_compare(state->rel, nkeyatts, key, state->target, upperbound);
+	cmp = _bt_compare(state->rel, keysz, key, state->target, upperbound);
 
 	return cmp <= 0;
 }
@@ -1778,13 +1830,12 @@ invariant_leq_offset(BtreeCheckState *state, ScanKey key,
  * to corruption.
  */
 static inline bool
-invariant_geq_offset(BtreeCheckState *state, ScanKey key,
+invariant_geq_offset(BtreeCheckState *state, ScanKey key, int keysz,
 					 OffsetNumber lowerbound)
 {
-	int16		nkeyatts = IndexRelationGetNumberOfKeyAttributes(state->rel);
 	int32		cmp;
 
-	cmp = _bt_compare(state->rel, nkeyatts, key, state->target, lowerbound);
+	cmp = _bt_compare(state->rel, keysz, key, state->target, lowerbound);
 
 	return cmp >= 0;
 }
@@ -1801,13 +1852,12 @@ invariant_geq_offset(BtreeCheckState *state, ScanKey key,
  */
 static inline bool
 invariant_leq_nontarget_offset(BtreeCheckState *state,
-							   Page nontarget, ScanKey key,
+							   Page nontarget, ScanKey key, int keysz,
 							   OffsetNumber upperbound)
 {
-	int16		nkeyatts = IndexRelationGetNumberOfKeyAttributes(state->rel);
 	int32		cmp;
 
-	cmp = _bt_compare(state->rel, nkeyatts, key, nontarget, upperbound);
+	cmp = _bt_compare(state->rel, keysz, key, nontarget, upperbound);
 
 	return cmp <= 0;
 }
@@ -13,10 +13,12 @@
 #include "funcapi.h"
 #include "storage/buf_internals.h"
 #include "storage/bufmgr.h"
+#include "storage/pg_shmem.h"
 
 
 #define NUM_BUFFERCACHE_PAGES_MIN_ELEM	8
 #define NUM_BUFFERCACHE_PAGES_ELEM	9
+#define NUM_BUFFERCACHE_NUMA_PAGES_ELEM	2
 
 PG_MODULE_MAGIC;
 
@@ -53,6 +55,16 @@ typedef struct
 	BufferCachePagesRec *record;
 } BufferCachePagesContext;
 
+/*
+ * Function context for pg_buffercache_numa_pages: the NUMA node of each
+ * buffer, or -1 if its memory hasn't been touched yet.
+ */
+typedef struct
+{
+	TupleDesc	tupdesc;
+	int		   *nodes;
+} BufferCacheNumaContext;
+
 
 /*
  * Function returning data from the shared buffer cache - buffer number,
@@ -237,3 +249,86 @@ pg_buffercache_pages(PG_FUNCTION_ARGS)
 	else
 		SRF_RETURN_DONE(funcctx);
 }
+
+/*
+ * Function returning the NUMA node each shared buffer's memory is placed on.
+ * Only the operating system page holding the start of each buffer is looked
+ * at; with huge pages, that covers the whole buffer anyway.
+ */
+PG_FUNCTION_INFO_V1(pg_buffercache_numa_pages);
+
+Datum
+pg_buffercache_numa_pages(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *funcctx;
+	BufferCacheNumaContext *fctx;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		MemoryContext oldcontext;
+		TupleDesc	tupledesc;
+		void	  **pages;
+		int			i;
+
+		funcctx = SRF_FIRSTCALL_INIT();
+
+		/* Switch context when allocating stuff to be used in later calls */
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		fctx = (BufferCacheNumaContext *) palloc(sizeof(BufferCacheNumaContext));
+
+		tupledesc = CreateTemplateTupleDesc(NUM_BUFFERCACHE_NUMA_PAGES_ELEM);
+		TupleDescInitEntry(tupledesc, (AttrNumber) 1, "bufferid",
+						   INT4OID, -1, 0);
+		TupleDescInitEntry(tupledesc, (AttrNumber) 2, "numa_node",
+						   INT4OID, -1, 0);
+		fctx->tupdesc = BlessTupleDesc(tupledesc);
+
+		fctx->nodes = (int *)
+			MemoryContextAllocHuge(CurrentMemoryContext, sizeof(int) * NBuffers);
+
+		/* Set max calls and remember the user function context. */
+		funcctx->max_calls = NBuffers;
+		funcctx->user_fctx = fctx;
+
+		/* Return to original context when allocating transient memory */
+		MemoryContextSwitchTo(oldcontext);
+
+		pages = (void **) MemoryContextAllocHuge(CurrentMemoryContext,
+												 sizeof(void *) * NBuffers);
+		for (i = 0; i < NBuffers; i++)
+			pages[i] = BufferGetBlock(i + 1);
+
+		if (!PGSharedMemoryGetNumaNodes(pages, NBuffers, fctx->nodes))
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("NUMA node information is not supported on this platform")));
+
+		pfree(pages);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+
+	/* Get the saved state */
+	fctx = funcctx->user_fctx;
+
+	if (funcctx->call_cntr < funcctx->max_calls)
+	{
+		uint32		i = funcctx->call_cntr;
+		Datum		values[NUM_BUFFERCACHE_NUMA_PAGES_ELEM];
+		bool		nulls[NUM_BUFFERCACHE_NUMA_PAGES_ELEM];
+		HeapTuple	tuple;
+
+		values[0] = Int32GetDatum(i + 1);
+		nulls[0] = false;
+
+		/* Pages not yet faulted in have no node */
+		values[1] = Int32GetDatum(fctx->nodes[i]);
+		nulls[1] = (fctx->nodes[i] < 0);
+
+		tuple = heap_form_tuple(fctx->tupdesc, values, nulls);
+		SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+	}
+	else
+		SRF_RETURN_DONE(funcctx);
+}
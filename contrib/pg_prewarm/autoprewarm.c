@@ -10,11 +10,16 @@
  *		and we need to lock the relations so that we don't try to prewarm
  *		pages from a relation that is in the process of being dropped.
  *
- *		While prewarming, autoprewarm will use two workers.  There's a
+ *		While prewarming, autoprewarm uses several workers.  There's a
  *		master worker that reads and sorts the list of blocks to be
- *		prewarmed and then launches a per-database worker for each
- *		relevant database in turn.  The former keeps running after the
- *		initial prewarm is complete to update the dump file periodically.
+ *		prewarmed, splits it up by database and tablespace, and launches
+ *		up to autoprewarm_max_workers workers at a time to load those
+ *		parts.  The master keeps running after the initial prewarm is
+ *		complete to update the dump file periodically.
+ *
+ *		On a standby, the master can also fetch the primary's dump file
+ *		now and then and load the blocks listed there, so that the
+ *		standby's cache already matches the primary's at failover.
  *
  *	Copyright (c) 2016-2019, PostgreSQL Global Development Group
  *
@@ -30,8 +35,10 @@
 
 #include "access/heapam.h"
 #include "access/xact.h"
+#include "access/xlog.h"
 #include "catalog/pg_class.h"
 #include "catalog/pg_type.h"
+#include "libpq-fe.h"
 #include "miscadmin.h"
 #include "pgstat.h"
 #include "postmaster/bgworker.h"
@@ -54,6 +61,12 @@
 
 #define AUTOPREWARM_FILE "autoprewarm.blocks"
 
+/* Most per-database workers the master runs at the same time. */
+#define AUTOPREWARM_MAX_WORKERS 32
+
+/* How many block records ahead of the current one a worker prefetches. */
+#define AUTOPREWARM_PREFETCH_DISTANCE 64
+
 /* Metadata for each block we dump. */
 typedef struct BlockInfoRecord
 {
@@ -64,6 +77,15 @@ typedef struct BlockInfoRecord
 	BlockNumber blocknum;
 } BlockInfoRecord;
 
+/* The part of the block list one per-database worker loads. */
+typedef struct AutoPrewarmWorkerSlot
+{
+	Oid			database;		/* database to connect to */
+	int			prewarm_start_idx;	/* first block record to load */
+	int			prewarm_stop_idx;	/* one past the last one */
+	int			prewarmed_blocks;	/* set by the worker as it goes */
+} AutoPrewarmWorkerSlot;
+
 /* Shared state information for autoprewarm bgworker. */
 typedef struct AutoPrewarmSharedState
 {
@@ -71,12 +93,10 @@ typedef struct AutoPrewarmSharedState
 	pid_t		bgworker_pid;	/* for main bgworker */
 	pid_t		pid_using_dumpfile; /* for autoprewarm or block dump */
 
-	/* Following items are for communication with per-database worker */
+	/* Following items are for communication with per-database workers */
 	dsm_handle	block_info_handle;
-	Oid			database;
-	int			prewarm_start_idx;
-	int			prewarm_stop_idx;
-	int			prewarmed_blocks;
+	bool		stop_if_full;	/* stop once there are no free buffers? */
+	AutoPrewarmWorkerSlot workers[AUTOPREWARM_MAX_WORKERS];
 } AutoPrewarmSharedState;
 
 void		_PG_init(void);
@@ -87,9 +107,13 @@ PG_FUNCTION_INFO_V1(autoprewarm_start_worker);
 PG_FUNCTION_INFO_V1(autoprewarm_dump_now);
 
 static void apw_load_buffers(void);
+static void apw_load_primary_buffers(void);
+static void apw_prewarm_blocks(BlockInfoRecord *blocks, int num_elements,
+				   bool stop_if_full);
 static int	apw_dump_now(bool is_bgworker, bool dump_unlogged);
 static void apw_start_master_worker(void);
-static void apw_start_database_worker(void);
+static bool apw_start_database_worker(int slot,
+						  BackgroundWorkerHandle **handle);
 static bool apw_init_shmem(void);
 static void apw_detach_shmem(int code, Datum arg);
 static int	apw_compare_blockinfo(const void *p, const void *q);
@@ -106,6 +130,8 @@ static AutoPrewarmSharedState *apw_state = NULL;
 /* GUC variables. */
 static bool autoprewarm = true; /* start worker? */
 static int	autoprewarm_interval;	/* dump interval */
+static int	autoprewarm_max_workers;	/* per-database workers at a time */
+static char *autoprewarm_primary_conninfo;	/* where a standby gets blocks */
 
 /*
  * Module load callback.
@@ -125,6 +151,29 @@ _PG_init(void)
 							NULL,
 							NULL);
 
+	DefineCustomIntVariable("pg_prewarm.autoprewarm_max_workers",
+							"Sets the maximum number of workers prewarming buffers at the same time.",
+							NULL,
+							&autoprewarm_max_workers,
+							4,
+							1, AUTOPREWARM_MAX_WORKERS,
+							PGC_SIGHUP,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomStringVariable("pg_prewarm.autoprewarm_primary_conninfo",
+							   "Sets the connection string a standby uses to fetch the primary's block dump.",
+							   "If empty, a standby only prewarms from its own dump file.",
+							   &autoprewarm_primary_conninfo,
+							   "",
+							   PGC_SIGHUP,
+							   GUC_SUPERUSER_ONLY,
+							   NULL,
+							   NULL,
+							   NULL);
+
 	if (!process_shared_preload_libraries_in_progress)
 		return;
 
@@ -157,6 +206,7 @@ void
 autoprewarm_main(Datum main_arg)
 {
 	bool		first_time = true;
+	bool		in_recovery;
 	TimestampTz last_dump_time = 0;
 
 	/* Establish signal handlers; once that's done, unblock signals. */
@@ -204,6 +254,8 @@ autoprewarm_main(Datum main_arg)
 		last_dump_time = GetCurrentTimestamp();
 	}
 
+	in_recovery = RecoveryInProgress();
+
 	/* Periodically dump buffers until terminated. */
 	while (!got_sigterm)
 	{
@@ -214,6 +266,20 @@ autoprewarm_main(Datum main_arg)
 			ProcessConfigFile(PGC_SIGHUP);
 		}
 
+		/*
+		 * If we were a standby and have been promoted, our buffers are now
+		 * the ones to keep track of; write them out right away instead of
+		 * leaving whatever the standby dumped last.
+		 */
+		if (in_recovery && !RecoveryInProgress())
+		{
+			in_recovery = false;
+			ereport(LOG,
+					(errmsg("autoprewarm worker noticed promotion, dumping buffers")));
+			last_dump_time = GetCurrentTimestamp();
+			apw_dump_now(true, false);
+		}
+
 		if (autoprewarm_interval <= 0)
 		{
 			/* We're only dumping at shutdown, so just wait forever. */
@@ -237,11 +303,16 @@ autoprewarm_main(Datum main_arg)
 								&secs, &usecs);
 			delay_in_ms = secs + (usecs / 1000);
 
-			/* Perform a dump if it's time. */
+			/*
+			 * Perform a dump if it's time.  A standby also follows the
+			 * primary's dump, if it has been told where to find it.
+			 */
 			if (delay_in_ms <= 0)
 			{
 				last_dump_time = GetCurrentTimestamp();
 				apw_dump_now(true, false);
+				if (in_recovery && autoprewarm_primary_conninfo[0] != '\0')
+					apw_load_primary_buffers();
 				continue;
 			}
 
@@ -264,8 +335,8 @@ autoprewarm_main(Datum main_arg)
 }
 
 /*
- * Read the dump file and launch per-database workers one at a time to
- * prewarm the buffers found there.
+ * Read the dump file and launch per-database workers to prewarm the buffers
+ * found there.
  */
 static void
 apw_load_buffers(void)
@@ -274,7 +345,6 @@ apw_load_buffers(void)
 	int			num_elements,
 				i;
 	BlockInfoRecord *blkinfo;
-	dsm_segment *seg;
 
 	/*
 	 * Skip the prewarm if the dump file is in use; otherwise, prevent any
@@ -320,11 +390,10 @@ apw_load_buffers(void)
 				 errmsg("could not read from file \"%s\": %m",
 						AUTOPREWARM_FILE)));
 
-	/* Allocate a dynamic shared memory segment to store the record data. */
-	seg = dsm_create(sizeof(BlockInfoRecord) * num_elements, 0);
-	blkinfo = (BlockInfoRecord *) dsm_segment_address(seg);
-
 	/* Read records, one per line. */
+	blkinfo = (BlockInfoRecord *)
+		palloc_extended(sizeof(BlockInfoRecord) * num_elements,
+						MCXT_ALLOC_HUGE);
 	for (i = 0; i < num_elements; i++)
 	{
 		unsigned	forknum;
@@ -340,90 +409,255 @@ apw_load_buffers(void)
 
 	FreeFile(file);
 
+	apw_prewarm_blocks(blkinfo, num_elements, true);
+	pfree(blkinfo);
+
+	LWLockAcquire(&apw_state->lock, LW_EXCLUSIVE);
+	apw_state->pid_using_dumpfile = InvalidPid;
+	LWLockRelease(&apw_state->lock);
+}
+
+/*
+ * On a standby, fetch the primary's block dump file over a regular
+ * connection and prewarm the blocks listed there.
+ *
+ * This runs in the master worker, so problems reaching the primary or an
+ * unusable file are only logged; we'll try again at the next interval.
+ * Unlike a prewarm at startup, this keeps going when there are no free
+ * buffers left, since the point is to mirror what the primary has cached.
+ */
+static void
+apw_load_primary_buffers(void)
+{
+	PGconn	   *conn;
+	PGresult   *res;
+	char	   *data;
+	char	   *line;
+	int			num_elements;
+	int			i;
+	BlockInfoRecord *blkinfo;
+
+	conn = PQconnectdb(autoprewarm_primary_conninfo);
+	if (PQstatus(conn) != CONNECTION_OK)
+	{
+		ereport(LOG,
+				(errmsg("autoprewarm could not connect to the primary server: %s",
+						pchomp(PQerrorMessage(conn)))));
+		PQfinish(conn);
+		return;
+	}
+
+	res = PQexec(conn, "SELECT pg_catalog.pg_read_file('" AUTOPREWARM_FILE "')");
+	if (PQresultStatus(res) != PGRES_TUPLES_OK || PQntuples(res) != 1 ||
+		PQgetisnull(res, 0, 0))
+	{
+		ereport(LOG,
+				(errmsg("autoprewarm could not fetch block dump file from the primary server: %s",
+						pchomp(PQresultErrorMessage(res)))));
+		PQclear(res);
+		PQfinish(conn);
+		return;
+	}
+	data = pstrdup(PQgetvalue(res, 0, 0));
+	PQclear(res);
+	PQfinish(conn);
+
+	/* Same format as we read in apw_load_buffers. */
+	if (sscanf(data, "<<%d>>\n", &num_elements) != 1 || num_elements < 0)
+	{
+		ereport(LOG,
+				(errmsg("autoprewarm block dump file of the primary server is corrupted")));
+		pfree(data);
+		return;
+	}
+
+	blkinfo = (BlockInfoRecord *)
+		palloc_extended(sizeof(BlockInfoRecord) * num_elements,
+						MCXT_ALLOC_HUGE);
+	line = strchr(data, '\n');
+	for (i = 0; i < num_elements; i++)
+	{
+		unsigned	forknum;
+
+		if (line == NULL ||
+			sscanf(line + 1, "%u,%u,%u,%u,%u", &blkinfo[i].database,
+				   &blkinfo[i].tablespace, &blkinfo[i].filenode,
+				   &forknum, &blkinfo[i].blocknum) != 5)
+		{
+			ereport(LOG,
+					(errmsg("autoprewarm block dump file of the primary server is corrupted at line %d",
+							i + 2)));
+			pfree(blkinfo);
+			pfree(data);
+			return;
+		}
+		blkinfo[i].forknum = forknum;
+		line = strchr(line + 1, '\n');
+	}
+	pfree(data);
+
+	apw_prewarm_blocks(blkinfo, num_elements, false);
+	pfree(blkinfo);
+}
+
+/*
+ * Prewarm the given blocks, using per-database workers.
+ *
+ * The blocks are sorted and split up into parts with the same database and
+ * tablespace, and up to autoprewarm_max_workers workers at a time load one
+ * part each.  Blocks of global objects are loaded by a worker connected to
+ * the first database in the list.  If stop_if_full is set, no more blocks
+ * are read once there are no free buffers left.
+ */
+static void
+apw_prewarm_blocks(BlockInfoRecord *blocks, int num_elements,
+				   bool stop_if_full)
+{
+	BlockInfoRecord *blkinfo;
+	dsm_segment *seg;
+	BackgroundWorkerHandle *handles[AUTOPREWARM_MAX_WORKERS];
+	Oid			first_db = InvalidOid;
+	int			next_idx = 0;
+	int			nrunning = 0;
+	int			prewarmed_blocks = 0;
+	int			i;
+
+	if (num_elements == 0)
+		return;
+
+	/* Allocate a dynamic shared memory segment to store the record data. */
+	seg = dsm_create(sizeof(BlockInfoRecord) * num_elements, 0);
+	blkinfo = (BlockInfoRecord *) dsm_segment_address(seg);
+	memcpy(blkinfo, blocks, sizeof(BlockInfoRecord) * num_elements);
+
 	/* Sort the blocks to be loaded. */
 	pg_qsort(blkinfo, num_elements, sizeof(BlockInfoRecord),
 			 apw_compare_blockinfo);
 
+	/* Global objects sort first; find a database to load them from. */
+	for (i = 0; i < num_elements; i++)
+	{
+		if (blkinfo[i].database != InvalidOid)
+		{
+			first_db = blkinfo[i].database;
+			break;
+		}
+	}
+
+	/*
+	 * If only BlockRecordInfos belonging to global objects exist, we can't
+	 * prewarm without a database connection, so just bail out.
+	 */
+	if (first_db == InvalidOid)
+		next_idx = num_elements;
+
 	/* Populate shared memory state. */
 	apw_state->block_info_handle = dsm_segment_handle(seg);
-	apw_state->prewarm_start_idx = apw_state->prewarm_stop_idx = 0;
-	apw_state->prewarmed_blocks = 0;
+	apw_state->stop_if_full = stop_if_full;
+	memset(handles, 0, sizeof(handles));
 
-	/* Get the info position of the first block of the next database. */
-	while (apw_state->prewarm_start_idx < num_elements)
+	for (;;)
 	{
-		int			j = apw_state->prewarm_start_idx;
-		Oid			current_db = blkinfo[j].database;
+		/* Collect the workers that are done. */
+		for (i = 0; i < AUTOPREWARM_MAX_WORKERS; i++)
+		{
+			pid_t		pid;
 
-		/*
-		 * Advance the prewarm_stop_idx to the first BlockRecordInfo that does
-		 * not belong to this database.
-		 */
-		j++;
-		while (j < num_elements)
+			if (handles[i] == NULL ||
+				GetBackgroundWorkerPid(handles[i], &pid) != BGWH_STOPPED)
+				continue;
+
+			prewarmed_blocks += apw_state->workers[i].prewarmed_blocks;
+			pfree(handles[i]);
+			handles[i] = NULL;
+			nrunning--;
+		}
+
+		/* Launch workers for the next parts of the list, if any. */
+		while (next_idx < num_elements && nrunning < autoprewarm_max_workers &&
+			   !got_sigterm)
 		{
-			if (current_db != blkinfo[j].database)
+			AutoPrewarmWorkerSlot *worker;
+			int			slot;
+			int			j = next_idx;
+
+			/* If we've run out of free buffers, don't launch another worker. */
+			if (stop_if_full && !have_free_buffer())
 			{
-				/*
-				 * Combine BlockRecordInfos for global objects with those of
-				 * the database.
-				 */
-				if (current_db != InvalidOid)
-					break;
-				current_db = blkinfo[j].database;
+				next_idx = num_elements;
+				break;
 			}
 
-			j++;
-		}
+			for (slot = 0; handles[slot] != NULL; slot++)
+				;
+			worker = &apw_state->workers[slot];
 
-		/*
-		 * If we reach this point with current_db == InvalidOid, then only
-		 * BlockRecordInfos belonging to global objects exist.  We can't
-		 * prewarm without a database connection, so just bail out.
-		 */
-		if (current_db == InvalidOid)
-			break;
+			/*
+			 * Advance j to the first BlockRecordInfo that does not belong to
+			 * this database and tablespace.
+			 */
+			j++;
+			while (j < num_elements &&
+				   blkinfo[j].database == blkinfo[next_idx].database &&
+				   blkinfo[j].tablespace == blkinfo[next_idx].tablespace)
+				j++;
+
+			/* Configure database and range for the per-database worker. */
+			worker->database = OidIsValid(blkinfo[next_idx].database) ?
+				blkinfo[next_idx].database : first_db;
+			worker->prewarm_start_idx = next_idx;
+			worker->prewarm_stop_idx = j;
+			worker->prewarmed_blocks = 0;
+
+			if (!apw_start_database_worker(slot, &handles[slot]))
+			{
+				/* Try again once one of ours has exited, if there's any. */
+				if (nrunning > 0)
+					break;
+				ereport(ERROR,
+						(errcode(ERRCODE_INSUFFICIENT_RESOURCES),
+						 errmsg("registering dynamic bgworker autoprewarm failed"),
+						 errhint("Consider increasing configuration parameter \"max_worker_processes\".")));
+			}
 
-		/* Configure stop point and database for next per-database worker. */
-		apw_state->prewarm_stop_idx = j;
-		apw_state->database = current_db;
-		Assert(apw_state->prewarm_start_idx < apw_state->prewarm_stop_idx);
+			nrunning++;
+			next_idx = j;
+		}
 
-		/* If we've run out of free buffers, don't launch another worker. */
-		if (!have_free_buffer())
+		if (nrunning == 0)
 			break;
 
-		/*
-		 * Start a per-database worker to load blocks for this database; this
-		 * function will return once the per-database worker exits.
-		 */
-		apw_start_database_worker();
-
-		/* Prepare for next database. */
-		apw_state->prewarm_start_idx = apw_state->prewarm_stop_idx;
+		/* We are notified when a worker exits; check every second anyway. */
+		(void) WaitLatch(MyLatch,
+						 WL_LATCH_SET | WL_TIMEOUT | WL_EXIT_ON_PM_DEATH,
+						 1000L,
+						 PG_WAIT_EXTENSION);
+		ResetLatch(MyLatch);
 	}
 
 	/* Clean up. */
 	dsm_detach(seg);
 	LWLockAcquire(&apw_state->lock, LW_EXCLUSIVE);
 	apw_state->block_info_handle = DSM_HANDLE_INVALID;
-	apw_state->pid_using_dumpfile = InvalidPid;
 	LWLockRelease(&apw_state->lock);
 
 	/* Report our success. */
 	ereport(LOG,
 			(errmsg("autoprewarm successfully prewarmed %d of %d previously-loaded blocks",
-					apw_state->prewarmed_blocks, num_elements)));
+					prewarmed_blocks, num_elements)));
 }
 
 /*
- * Prewarm all blocks for one database (and possibly also global objects, if
- * those got grouped with this database).
+ * Prewarm the blocks of one part of the list: one tablespace of one database,
+ * or global objects.
  */
 void
 autoprewarm_database_main(Datum main_arg)
 {
 	int			pos;
+	int			prefetch_pos;
+	int			stop;
+	AutoPrewarmWorkerSlot *worker;
 	BlockInfoRecord *block_info;
 	Relation	rel = NULL;
 	BlockNumber nblocks = 0;
@@ -436,34 +670,28 @@ autoprewarm_database_main(Datum main_arg)
 
 	/* Connect to correct database and get block information. */
 	apw_init_shmem();
+	worker = &apw_state->workers[DatumGetInt32(main_arg)];
 	seg = dsm_attach(apw_state->block_info_handle);
 	if (seg == NULL)
 		ereport(ERROR,
 				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
 				 errmsg("could not map dynamic shared memory segment")));
-	BackgroundWorkerInitializeConnectionByOid(apw_state->database, InvalidOid, 0);
+	BackgroundWorkerInitializeConnectionByOid(worker->database, InvalidOid, 0);
 	block_info = (BlockInfoRecord *) dsm_segment_address(seg);
-	pos = apw_state->prewarm_start_idx;
+	pos = prefetch_pos = worker->prewarm_start_idx;
+	stop = worker->prewarm_stop_idx;
 
 	/*
-	 * Loop until we run out of blocks to prewarm or until we run out of free
-	 * buffers.
+	 * Loop until we run out of blocks to prewarm or, if asked to, until we
+	 * run out of free buffers.
 	 */
-	while (pos < apw_state->prewarm_stop_idx && have_free_buffer())
+	while (pos < stop && (!apw_state->stop_if_full || have_free_buffer()))
 	{
 		BlockInfoRecord *blk = &block_info[pos++];
 		Buffer		buf;
 
 		CHECK_FOR_INTERRUPTS();
 
-		/*
-		 * Quit if we've reached records for another database. If previous
-		 * blocks are of some global objects, then continue pre-warming.
-		 */
-		if (old_blk != NULL && old_blk->database != blk->database &&
-			old_blk->database != 0)
-			break;
-
 		/*
 		 * As soon as we encounter a block of a new relation, close the old
 		 * relation. Note that rel will be NULL if try_relation_open failed
@@ -527,12 +755,31 @@ autoprewarm_database_main(Datum main_arg)
 			continue;
 		}
 
+		/*
+		 * Keep read-ahead requests going for the next blocks of this fork,
+		 * so that the reads below rarely have to wait.
+		 */
+		if (prefetch_pos < pos)
+			prefetch_pos = pos;
+		while (prefetch_pos < stop &&
+			   prefetch_pos < pos + AUTOPREWARM_PREFETCH_DISTANCE)
+		{
+			BlockInfoRecord *next_blk = &block_info[prefetch_pos];
+
+			if (next_blk->filenode != blk->filenode ||
+				next_blk->forknum != blk->forknum)
+				break;
+			if (next_blk->blocknum < nblocks)
+				PrefetchBuffer(rel, next_blk->forknum, next_blk->blocknum);
+			prefetch_pos++;
+		}
+
 		/* Prewarm buffer. */
 		buf = ReadBufferExtended(rel, blk->forknum, blk->blocknum, RBM_NORMAL,
 								 NULL);
 		if (BufferIsValid(buf))
 		{
-			apw_state->prewarmed_blocks++;
+			worker->prewarmed_blocks++;
 			ReleaseBuffer(buf);
 		}
 
@@ -828,13 +1075,13 @@ apw_start_master_worker(void)
 }
 
 /*
- * Start autoprewarm per-database worker process.
+ * Start autoprewarm per-database worker process for the given worker slot.
+ * Returns false if no background worker slot is free.
  */
-static void
-apw_start_database_worker(void)
+static bool
+apw_start_database_worker(int slot, BackgroundWorkerHandle **handle)
 {
 	BackgroundWorker worker;
-	BackgroundWorkerHandle *handle;
 
 	MemSet(&worker, 0, sizeof(BackgroundWorker));
 	worker.bgw_flags =
@@ -844,21 +1091,12 @@ apw_start_database_worker(void)
 	strcpy(worker.bgw_function_name, "autoprewarm_database_main");
 	strcpy(worker.bgw_name, "autoprewarm worker");
 	strcpy(worker.bgw_type, "autoprewarm worker");
+	worker.bgw_main_arg = Int32GetDatum(slot);
 
-	/* must set notify PID to wait for shutdown */
+	/* must set notify PID to hear about shutdown */
 	worker.bgw_notify_pid = MyProcPid;
 
-	if (!RegisterDynamicBackgroundWorker(&worker, &handle))
-		ereport(ERROR,
-				(errcode(ERRCODE_INSUFFICIENT_RESOURCES),
-				 errmsg("registering dynamic bgworker autoprewarm failed"),
-				 errhint("Consider increasing configuration parameter \"max_worker_processes\".")));
-
-	/*
-	 * Ignore return value; if it fails, postmaster has died, but we have
-	 * checks for that elsewhere.
-	 */
-	WaitForBackgroundWorkerShutdown(handle);
+	return RegisterDynamicBackgroundWorker(&worker, handle);
 }
 
 /* Compare member elements to check whether they are not equal. */
@@ -873,11 +1111,10 @@ do { \
 /*
  * apw_compare_blockinfo
  *
- * We depend on all records for a particular database being consecutive
- * in the dump file; each per-database worker will preload blocks until
- * it sees a block for some other database.  Sorting by tablespace,
- * filenode, forknum, and blocknum isn't critical for correctness, but
- * helps us get a sequential I/O pattern.
+ * We depend on all records for a particular database and tablespace being
+ * consecutive, since each per-database worker preloads one such run of
+ * records.  Sorting by filenode, forknum, and blocknum isn't critical for
+ * correctness, but helps us get a sequential I/O pattern.
  */
 static int
 apw_compare_blockinfo(const void *p, const void *q)
@@ -195,4 +195,33 @@ DROP FUNCTION PLUS_TWO(INTEGER);
 
 SELECT query, calls, rows FROM pg_stat_statements ORDER BY query COLLATE "C";
 
+--
+-- track planning
+--
+SET pg_stat_statements.track_planning = TRUE;
+SELECT pg_stat_statements_reset();
+
+SELECT 42;
+SELECT 42;
+SELECT 42;
+
+SELECT query, plans, calls, rows FROM pg_stat_statements ORDER BY query COLLATE "C";
+
+SET pg_stat_statements.track_planning = FALSE;
+
+--
+-- WAL usage
+--
+SELECT pg_stat_statements_reset();
+
+CREATE TABLE pgss_wal (a int);
+INSERT INTO pgss_wal SELECT generate_series(1, 10);
+UPDATE pgss_wal SET a = a + 1;
+DROP TABLE pgss_wal;
+
+SELECT query, calls, rows,
+  wal_records > 0 AS wal_records_generated,
+  wal_bytes > 0 AS wal_bytes_generated
+  FROM pg_stat_statements ORDER BY query COLLATE "C";
+
 DROP EXTENSION pg_stat_statements;
@@ -124,6 +124,8 @@ typedef struct TrgmPackedGraph TrgmPackedGraph;
 extern double similarity_threshold;
 extern double word_similarity_threshold;
 extern double strict_word_similarity_threshold;
+extern int	regexp_max_states;
+extern int	regexp_max_trigrams;
 
 extern double index_strategy_get_limit(StrategyNumber strategy);
 extern uint32 trgm2int(trgm *ptr);
@@ -100,6 +100,30 @@ _PG_init(void)
 							 NULL,
 							 NULL,
 							 NULL);
+	DefineCustomIntVariable("pg_trgm.regexp_max_states",
+							"Sets the maximum size of the trigram graph extracted from a regular expression.",
+							"The graph may have up to eight times as many arcs as states.",
+							&regexp_max_states,
+							128,
+							16,
+							INT_MAX / 8,
+							PGC_USERSET,
+							0,
+							NULL,
+							NULL,
+							NULL);
+	DefineCustomIntVariable("pg_trgm.regexp_max_trigrams",
+							"Sets the maximum number of trigrams extracted from a regular expression.",
+							"Regular expressions needing more can't use a trigram index.",
+							&regexp_max_trigrams,
+							256,
+							16,
+							65536,
+							PGC_USERSET,
+							0,
+							NULL,
+							NULL,
+							NULL);
 }
 
 /*
@@ -104,9 +104,9 @@
  * out-arcs leading out of this collection of states that have predictable
  * trigrams, adding their target states to the queue of states to examine.
  *
- * When building the graph, if the number of states or arcs exceed pre-defined
- * limits, we give up and simply mark any states not yet processed as final
- * states.  Roughly speaking, that means that we make use of some portion from
+ * When building the graph, if the number of states or arcs exceed the limits
+ * set by pg_trgm.regexp_max_states, we give up and simply mark any states not
+ * yet processed as final states.  Roughly speaking, that means that we make use of some portion from
  * the beginning of the regexp.  Also, any colors that have too many member
  * characters are treated as "unknown", so that we can't derive trigrams
  * from them.
@@ -138,7 +138,7 @@
  * WISH_TRGM_PENALTY. However, we cannot remove a color trigram if that would
  * lead to merging the initial and final states, so we may not be able to
  * reach WISH_TRGM_PENALTY. It's still okay so long as we have no more than
- * MAX_TRGM_COUNT simple trigrams in total, otherwise we fail.
+ * pg_trgm.regexp_max_trigrams simple trigrams in total, otherwise we fail.
  *
  * 4) Pack the graph into a compact representation
  * -----------------------------------------------
@@ -216,10 +216,18 @@
  *	MAX_TRGM_COUNT - How many simple trigrams we allow to be extracted
  *	WISH_TRGM_PENALTY - Maximum desired sum of color trigram penalties
  *	COLOR_COUNT_LIMIT - Maximum number of characters per color
+ *
+ * The first three are settable, as pg_trgm.regexp_max_states and
+ * pg_trgm.regexp_max_trigrams: complex patterns that overflow the defaults
+ * lose much of their selectivity, or can't use the index at all, and paying
+ * for a bigger graph at plan time can save a lot of heap rechecks.
  */
-#define MAX_EXPANDED_STATES 128
-#define MAX_EXPANDED_ARCS	1024
-#define MAX_TRGM_COUNT		256
+int			regexp_max_states = 128;
+int			regexp_max_trigrams = 256;
+
+#define MAX_EXPANDED_STATES regexp_max_states
+#define MAX_EXPANDED_ARCS	(8 * regexp_max_states)
+#define MAX_TRGM_COUNT		regexp_max_trigrams
 #define WISH_TRGM_PENALTY	16
 #define COLOR_COUNT_LIMIT	256
 
@@ -0,0 +1,48 @@
+/* contrib/pg_wait_sampling/pg_wait_sampling--1.0.sql */
+
+-- complain if script is sourced in psql, rather than via CREATE EXTENSION
+\echo Use "CREATE EXTENSION pg_wait_sampling" to load this file. \quit
+
+-- Register functions.
+CREATE FUNCTION pg_wait_sampling_get_history(
+    OUT pid int4,
+    OUT ts timestamptz,
+    OUT event_type text,
+    OUT event text,
+    OUT queryid int8,
+    OUT datid oid
+)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT VOLATILE PARALLEL SAFE;
+
+CREATE FUNCTION pg_wait_sampling_get_profile(
+    OUT pid int4,
+    OUT event_type text,
+    OUT event text,
+    OUT queryid int8,
+    OUT datid oid,
+    OUT count int8
+)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT VOLATILE PARALLEL SAFE;
+
+CREATE FUNCTION pg_wait_sampling_reset_profile()
+RETURNS void
+AS 'MODULE_PATHNAME'
+LANGUAGE C PARALLEL SAFE;
+
+-- Register views on the functions for ease of use.
+CREATE VIEW pg_wait_sampling_history AS
+  SELECT * FROM pg_wait_sampling_get_history();
+
+GRANT SELECT ON pg_wait_sampling_history TO PUBLIC;
+
+CREATE VIEW pg_wait_sampling_profile AS
+  SELECT * FROM pg_wait_sampling_get_profile();
+
+GRANT SELECT ON pg_wait_sampling_profile TO PUBLIC;
+
+-- Don't want this to be available to non-superusers.
+REVOKE ALL ON FUNCTION pg_wait_sampling_reset_profile() FROM PUBLIC;
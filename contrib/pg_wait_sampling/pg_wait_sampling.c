@@ -0,0 +1,646 @@
+/*-------------------------------------------------------------------------
+ *
+ * pg_wait_sampling.c
+ *		Continuously sample the wait events of all processes.
+ *
+ *		pg_stat_activity only shows what each process is waiting for at the
+ *		moment it is queried.  This module runs a background worker that
+ *		looks at the wait event of every process once per sample period,
+ *		and keeps the observations in shared memory in two forms: a ring
+ *		buffer holding the most recent individual samples ("history"), and
+ *		a hash table counting how often each combination of process, wait
+ *		event, query ID and database has been seen ("profile").  Together
+ *		they allow finding out after the fact what sessions were waiting on
+ *		during a latency spike, without polling from outside.
+ *
+ *		Only processes that are waiting are sampled; a process running on
+ *		CPU has no wait event to record.
+ *
+ *	Copyright (c) 2019, PostgreSQL Global Development Group
+ *
+ *	IDENTIFICATION
+ *		contrib/pg_wait_sampling/pg_wait_sampling.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/htup_details.h"
+#include "funcapi.h"
+#include "miscadmin.h"
+#include "pgstat.h"
+#include "postmaster/bgworker.h"
+#include "storage/ipc.h"
+#include "storage/latch.h"
+#include "storage/lwlock.h"
+#include "storage/proc.h"
+#include "storage/procsignal.h"
+#include "storage/shmem.h"
+#include "utils/builtins.h"
+#include "utils/guc.h"
+#include "utils/timestamp.h"
+
+PG_MODULE_MAGIC;
+
+/* Number of output columns of the SQL functions */
+#define PG_WAIT_SAMPLING_HISTORY_COLS	6
+#define PG_WAIT_SAMPLING_PROFILE_COLS	6
+
+/* One observation of a waiting process */
+typedef struct WaitSample
+{
+	int			pid;
+	uint32		wait_event_info;
+	uint64		queryid;
+	Oid			dbid;
+	TimestampTz ts;
+} WaitSample;
+
+/*
+ * Hash key of the profile.  Any padding must be zeroed before lookups, since
+ * the key is hashed as a blob.
+ */
+typedef struct ProfileKey
+{
+	int			pid;			/* 0 if not tracking per-process */
+	uint32		wait_event_info;
+	uint64		queryid;		/* 0 if not tracking queries */
+	Oid			dbid;
+} ProfileKey;
+
+typedef struct ProfileEntry
+{
+	ProfileKey	key;			/* hash key of entry - MUST BE FIRST */
+	int64		count;			/* number of samples */
+} ProfileEntry;
+
+/*
+ * Shared state.  The history ring follows the struct; history_next is the
+ * slot the next sample will be written to, and history_count the number of
+ * valid slots.  The lock protects all of it, as well as the profile hash.
+ */
+typedef struct WaitSamplingSharedState
+{
+	LWLock	   *lock;
+	int			history_next;
+	int			history_count;
+	WaitSample	history[FLEXIBLE_ARRAY_MEMBER];
+} WaitSamplingSharedState;
+
+void		_PG_init(void);
+void		_PG_fini(void);
+void		pg_wait_sampling_main(Datum main_arg);
+
+PG_FUNCTION_INFO_V1(pg_wait_sampling_get_history);
+PG_FUNCTION_INFO_V1(pg_wait_sampling_get_profile);
+PG_FUNCTION_INFO_V1(pg_wait_sampling_reset_profile);
+
+static Size pgws_memsize(void);
+static void pgws_shmem_startup(void);
+static int	pgws_collect(WaitSample *samples);
+static void pgws_store(WaitSample *samples, int nsamples);
+static void pgws_check_state(void);
+static Tuplestorestate *pgws_begin_result(FunctionCallInfo fcinfo, int ncols);
+static void pgws_set_event(Datum *values, bool *nulls, uint32 wait_event_info);
+static void pgws_sigterm_handler(SIGNAL_ARGS);
+static void pgws_sighup_handler(SIGNAL_ARGS);
+
+/* Flags set by signal handlers */
+static volatile sig_atomic_t got_sigterm = false;
+static volatile sig_atomic_t got_sighup = false;
+
+/* Saved hook values in case of unload */
+static shmem_startup_hook_type prev_shmem_startup_hook = NULL;
+
+/* Links to shared memory state */
+static WaitSamplingSharedState *pgws = NULL;
+static HTAB *pgws_profile = NULL;
+
+/* GUC variables */
+static int	pgws_sample_period;	/* msec between samples */
+static int	pgws_history_size;	/* slots in the history ring */
+static int	pgws_profile_max;	/* max # of profile entries */
+static bool pgws_profile_pid;	/* distinguish processes in the profile? */
+static bool pgws_profile_queries;	/* distinguish queries in both views? */
+
+/*
+ * Module load callback
+ */
+void
+_PG_init(void)
+{
+	BackgroundWorker worker;
+
+	/*
+	 * The shared memory and the collector can only be set up when we're
+	 * loaded via shared_preload_libraries.  If not, fall out without hooking
+	 * into any of the main system; the SQL functions will complain.
+	 */
+	if (!process_shared_preload_libraries_in_progress)
+		return;
+
+	DefineCustomIntVariable("pg_wait_sampling.sample_period",
+							"Sets the time between wait event samples.",
+							NULL,
+							&pgws_sample_period,
+							10,
+							1,
+							INT_MAX,
+							PGC_SIGHUP,
+							GUC_UNIT_MS,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomIntVariable("pg_wait_sampling.history_size",
+							"Sets the number of recent samples kept in the history.",
+							NULL,
+							&pgws_history_size,
+							5000,
+							100,
+							INT_MAX / 2,
+							PGC_POSTMASTER,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomIntVariable("pg_wait_sampling.profile_max",
+							"Sets the maximum number of entries in the wait event profile.",
+							"Samples that would need a new entry once the profile is full are not counted.",
+							&pgws_profile_max,
+							5000,
+							100,
+							INT_MAX,
+							PGC_POSTMASTER,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomBoolVariable("pg_wait_sampling.profile_pid",
+							 "Keeps separate wait event counts for each process.",
+							 NULL,
+							 &pgws_profile_pid,
+							 true,
+							 PGC_SIGHUP,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("pg_wait_sampling.profile_queries",
+							 "Records the query ID along with each wait event sample.",
+							 NULL,
+							 &pgws_profile_queries,
+							 true,
+							 PGC_SIGHUP,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	EmitWarningsOnPlaceholders("pg_wait_sampling");
+
+	/*
+	 * Request additional shared resources.  (These are no-ops if we're not in
+	 * the postmaster process.)  We'll allocate or attach to the shared
+	 * resources in pgws_shmem_startup().
+	 */
+	RequestAddinShmemSpace(pgws_memsize());
+	RequestNamedLWLockTranche("pg_wait_sampling", 1);
+
+	/*
+	 * Install hooks.
+	 */
+	prev_shmem_startup_hook = shmem_startup_hook;
+	shmem_startup_hook = pgws_shmem_startup;
+
+	/* Register the collector. */
+	MemSet(&worker, 0, sizeof(BackgroundWorker));
+	worker.bgw_flags = BGWORKER_SHMEM_ACCESS;
+	worker.bgw_start_time = BgWorkerStart_PostmasterStart;
+	worker.bgw_restart_time = 1;
+	strcpy(worker.bgw_library_name, "pg_wait_sampling");
+	strcpy(worker.bgw_function_name, "pg_wait_sampling_main");
+	strcpy(worker.bgw_name, "pg_wait_sampling collector");
+	strcpy(worker.bgw_type, "pg_wait_sampling collector");
+	RegisterBackgroundWorker(&worker);
+}
+
+/*
+ * Module unload callback
+ */
+void
+_PG_fini(void)
+{
+	/* Uninstall hooks. */
+	shmem_startup_hook = prev_shmem_startup_hook;
+}
+
+/*
+ * Estimate shared memory space needed.
+ */
+static Size
+pgws_memsize(void)
+{
+	Size		size;
+
+	size = MAXALIGN(add_size(offsetof(WaitSamplingSharedState, history),
+							 mul_size(pgws_history_size, sizeof(WaitSample))));
+	size = add_size(size, hash_estimate_size(pgws_profile_max,
+											 sizeof(ProfileEntry)));
+
+	return size;
+}
+
+/*
+ * shmem_startup hook: allocate or attach to shared memory.
+ */
+static void
+pgws_shmem_startup(void)
+{
+	bool		found;
+	HASHCTL		info;
+
+	if (prev_shmem_startup_hook)
+		prev_shmem_startup_hook();
+
+	/* reset in case this is a restart within the postmaster */
+	pgws = NULL;
+	pgws_profile = NULL;
+
+	LWLockAcquire(AddinShmemInitLock, LW_EXCLUSIVE);
+
+	pgws = ShmemInitStruct("pg_wait_sampling",
+						   offsetof(WaitSamplingSharedState, history) +
+						   pgws_history_size * sizeof(WaitSample),
+						   &found);
+
+	if (!found)
+	{
+		/* First time through ... */
+		pgws->lock = &(GetNamedLWLockTranche("pg_wait_sampling"))->lock;
+		pgws->history_next = 0;
+		pgws->history_count = 0;
+	}
+
+	memset(&info, 0, sizeof(info));
+	info.keysize = sizeof(ProfileKey);
+	info.entrysize = sizeof(ProfileEntry);
+	pgws_profile = ShmemInitHash("pg_wait_sampling profile",
+								 pgws_profile_max, pgws_profile_max,
+								 &info,
+								 HASH_ELEM | HASH_BLOBS);
+
+	LWLockRelease(AddinShmemInitLock);
+}
+
+/*
+ * Main entry point of the collector.
+ */
+void
+pg_wait_sampling_main(Datum main_arg)
+{
+	WaitSample *samples;
+
+	/* Establish signal handlers; once that's done, unblock signals. */
+	pqsignal(SIGTERM, pgws_sigterm_handler);
+	pqsignal(SIGHUP, pgws_sighup_handler);
+	pqsignal(SIGUSR1, procsignal_sigusr1_handler);
+	BackgroundWorkerUnblockSignals();
+
+	/* The set of PGPROCs is fixed at startup, so this is big enough */
+	samples = palloc(ProcGlobal->allProcCount * sizeof(WaitSample));
+
+	while (!got_sigterm)
+	{
+		int			nsamples;
+
+		/* In case of a SIGHUP, just reload the configuration. */
+		if (got_sighup)
+		{
+			got_sighup = false;
+			ProcessConfigFile(PGC_SIGHUP);
+		}
+
+		nsamples = pgws_collect(samples);
+		if (nsamples > 0)
+			pgws_store(samples, nsamples);
+
+		(void) WaitLatch(MyLatch,
+						 WL_LATCH_SET | WL_TIMEOUT | WL_EXIT_ON_PM_DEATH,
+						 pgws_sample_period,
+						 PG_WAIT_EXTENSION);
+		ResetLatch(MyLatch);
+	}
+}
+
+/*
+ * Take one sample of the wait event of every process that is waiting, and
+ * return the number of samples written into 'samples'.
+ *
+ * The fields we look at are read without locking, the same way
+ * pg_stat_activity does; a sample may occasionally combine the wait event of
+ * a process with the query ID of the next query it runs, which doesn't
+ * matter for statistical purposes.
+ */
+static int
+pgws_collect(WaitSample *samples)
+{
+	TimestampTz now = GetCurrentTimestamp();
+	int			nsamples = 0;
+	int			i;
+
+	for (i = 0; i < ProcGlobal->allProcCount; i++)
+	{
+		PGPROC	   *proc = &ProcGlobal->allProcs[i];
+		volatile uint32 *wait_event_info = &proc->wait_event_info;
+		WaitSample *sample;
+		int			pid;
+
+		pid = proc->pid;
+		if (pid == 0 || proc == MyProc)
+			continue;
+
+		sample = &samples[nsamples];
+		sample->wait_event_info = *wait_event_info;
+		if (sample->wait_event_info == 0)
+			continue;
+
+		sample->pid = pid;
+		sample->dbid = proc->databaseId;
+		sample->queryid = pgws_profile_queries ?
+			pgstat_get_backend_query_id(proc->backendId) : UINT64CONST(0);
+		sample->ts = now;
+		nsamples++;
+	}
+
+	return nsamples;
+}
+
+/*
+ * Add samples to the history ring and count them in the profile.
+ */
+static void
+pgws_store(WaitSample *samples, int nsamples)
+{
+	int			i;
+
+	LWLockAcquire(pgws->lock, LW_EXCLUSIVE);
+
+	for (i = 0; i < nsamples; i++)
+	{
+		WaitSample *sample = &samples[i];
+		ProfileKey	key;
+		ProfileEntry *entry;
+		bool		found;
+
+		pgws->history[pgws->history_next] = *sample;
+		if (++pgws->history_next >= pgws_history_size)
+			pgws->history_next = 0;
+		if (pgws->history_count < pgws_history_size)
+			pgws->history_count++;
+
+		memset(&key, 0, sizeof(key));
+		key.pid = pgws_profile_pid ? sample->pid : 0;
+		key.wait_event_info = sample->wait_event_info;
+		key.queryid = sample->queryid;
+		key.dbid = sample->dbid;
+
+		/* HASH_ENTER_NULL returns NULL once the table is full */
+		entry = (ProfileEntry *) hash_search(pgws_profile, &key,
+											 HASH_ENTER_NULL, &found);
+		if (entry == NULL)
+			continue;
+		if (!found)
+			entry->count = 0;
+		entry->count++;
+	}
+
+	LWLockRelease(pgws->lock);
+}
+
+/*
+ * Complain unless the shared state has been set up.
+ */
+static void
+pgws_check_state(void)
+{
+	if (!pgws || !pgws_profile)
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("pg_wait_sampling must be loaded via shared_preload_libraries")));
+}
+
+/*
+ * Set up a tuplestore in which to return the result of a SQL function.
+ */
+static Tuplestorestate *
+pgws_begin_result(FunctionCallInfo fcinfo, int ncols)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext per_query_ctx;
+	MemoryContext oldcontext;
+
+	/* check to see if caller supports us returning a tuplestore */
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not " \
+						"allowed in this context")));
+
+	/* Switch into long-lived context to construct returned data structures */
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	/* Build a tuple descriptor for our result type */
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+	if (tupdesc->natts != ncols)
+		elog(ERROR, "incorrect number of output arguments");
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	return tupstore;
+}
+
+/*
+ * Fill in the wait event type and name columns for a wait_event_info.
+ */
+static void
+pgws_set_event(Datum *values, bool *nulls, uint32 wait_event_info)
+{
+	const char *event_type = pgstat_get_wait_event_type(wait_event_info);
+	const char *event = pgstat_get_wait_event(wait_event_info);
+
+	if (event_type)
+		values[0] = CStringGetTextDatum(event_type);
+	else
+		nulls[0] = true;
+	if (event)
+		values[1] = CStringGetTextDatum(event);
+	else
+		nulls[1] = true;
+}
+
+/*
+ * Return the samples in the history ring, oldest first.
+ */
+Datum
+pg_wait_sampling_get_history(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	Tuplestorestate *tupstore;
+	int			slot;
+	int			i;
+
+	pgws_check_state();
+
+	tupstore = pgws_begin_result(fcinfo, PG_WAIT_SAMPLING_HISTORY_COLS);
+
+	LWLockAcquire(pgws->lock, LW_SHARED);
+
+	slot = pgws->history_next - pgws->history_count;
+	if (slot < 0)
+		slot += pgws_history_size;
+
+	for (i = 0; i < pgws->history_count; i++)
+	{
+		WaitSample *sample = &pgws->history[slot];
+		Datum		values[PG_WAIT_SAMPLING_HISTORY_COLS];
+		bool		nulls[PG_WAIT_SAMPLING_HISTORY_COLS];
+
+		memset(values, 0, sizeof(values));
+		memset(nulls, 0, sizeof(nulls));
+
+		values[0] = Int32GetDatum(sample->pid);
+		values[1] = TimestampTzGetDatum(sample->ts);
+		pgws_set_event(&values[2], &nulls[2], sample->wait_event_info);
+		values[4] = Int64GetDatumFast((int64) sample->queryid);
+		values[5] = ObjectIdGetDatum(sample->dbid);
+
+		tuplestore_putvalues(tupstore, rsinfo->setDesc, values, nulls);
+
+		if (++slot >= pgws_history_size)
+			slot = 0;
+	}
+
+	LWLockRelease(pgws->lock);
+
+	/* clean up and return the tuplestore */
+	tuplestore_donestoring(tupstore);
+
+	return (Datum) 0;
+}
+
+/*
+ * Return the accumulated wait event counts.
+ */
+Datum
+pg_wait_sampling_get_profile(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	Tuplestorestate *tupstore;
+	HASH_SEQ_STATUS hash_seq;
+	ProfileEntry *entry;
+
+	pgws_check_state();
+
+	tupstore = pgws_begin_result(fcinfo, PG_WAIT_SAMPLING_PROFILE_COLS);
+
+	LWLockAcquire(pgws->lock, LW_SHARED);
+
+	hash_seq_init(&hash_seq, pgws_profile);
+	while ((entry = hash_seq_search(&hash_seq)) != NULL)
+	{
+		Datum		values[PG_WAIT_SAMPLING_PROFILE_COLS];
+		bool		nulls[PG_WAIT_SAMPLING_PROFILE_COLS];
+
+		memset(values, 0, sizeof(values));
+		memset(nulls, 0, sizeof(nulls));
+
+		if (entry->key.pid != 0)
+			values[0] = Int32GetDatum(entry->key.pid);
+		else
+			nulls[0] = true;
+		pgws_set_event(&values[1], &nulls[1], entry->key.wait_event_info);
+		values[3] = Int64GetDatumFast((int64) entry->key.queryid);
+		values[4] = ObjectIdGetDatum(entry->key.dbid);
+		values[5] = Int64GetDatumFast(entry->count);
+
+		tuplestore_putvalues(tupstore, rsinfo->setDesc, values, nulls);
+	}
+
+	LWLockRelease(pgws->lock);
+
+	/* clean up and return the tuplestore */
+	tuplestore_donestoring(tupstore);
+
+	return (Datum) 0;
+}
+
+/*
+ * Discard the accumulated wait event counts.
+ */
+Datum
+pg_wait_sampling_reset_profile(PG_FUNCTION_ARGS)
+{
+	HASH_SEQ_STATUS hash_seq;
+	ProfileEntry *entry;
+
+	pgws_check_state();
+
+	LWLockAcquire(pgws->lock, LW_EXCLUSIVE);
+
+	hash_seq_init(&hash_seq, pgws_profile);
+	while ((entry = hash_seq_search(&hash_seq)) != NULL)
+		hash_search(pgws_profile, &entry->key, HASH_REMOVE, NULL);
+
+	LWLockRelease(pgws->lock);
+
+	PG_RETURN_VOID();
+}
+
+/*
+ * Signal handler for SIGTERM
+ */
+static void
+pgws_sigterm_handler(SIGNAL_ARGS)
+{
+	int			save_errno = errno;
+
+	got_sigterm = true;
+
+	if (MyProc)
+		SetLatch(&MyProc->procLatch);
+
+	errno = save_errno;
+}
+
+/*
+ * Signal handler for SIGHUP
+ */
+static void
+pgws_sighup_handler(SIGNAL_ARGS)
+{
+	int			save_errno = errno;
+
+	got_sighup = true;
+
+	if (MyProc)
+		SetLatch(&MyProc->procLatch);
+
+	errno = save_errno;
+}
@@ -0,0 +1,25 @@
+CREATE EXTENSION pg_wait_sampling;
+
+--
+-- Our own sleep should be seen by the collector
+--
+SELECT pg_sleep(0.5);
+
+SELECT count(*) > 0 AS sampled FROM pg_wait_sampling_history
+  WHERE pid = pg_backend_pid() AND event_type = 'Timeout' AND event = 'PgSleep';
+
+SELECT count(*) > 0 AS profiled FROM pg_wait_sampling_profile
+  WHERE pid = pg_backend_pid() AND event_type = 'Timeout' AND event = 'PgSleep';
+
+--
+-- Reset discards the profile, but not the history
+--
+SELECT pg_wait_sampling_reset_profile();
+
+SELECT count(*) AS profiled FROM pg_wait_sampling_profile
+  WHERE pid = pg_backend_pid() AND event = 'PgSleep';
+
+SELECT count(*) > 0 AS sampled FROM pg_wait_sampling_history
+  WHERE pid = pg_backend_pid() AND event = 'PgSleep';
+
+DROP EXTENSION pg_wait_sampling;
@@ -58,6 +58,7 @@ typedef struct ConnCacheEntry
 	bool		invalidated;	/* true if reconnect is pending */
 	uint32		server_hashvalue;	/* hash value of foreign server OID */
 	uint32		mapping_hashvalue;	/* hash value of user mapping OID */
+	PgFdwConnState state;		/* extra per-connection state */
 } ConnCacheEntry;
 
 /*
@@ -102,9 +103,12 @@ static bool pgfdw_get_cleanup_result(PGconn *conn, TimestampTz endtime,
  * will_prep_stmt must be true if caller intends to create any prepared
  * statements.  Since those don't go away automatically at transaction end
  * (not even on error), we need this flag to cue manual cleanup.
+ *
+ * If state is not NULL, *state receives the per-connection state that
+ * asynchronous scans use to coordinate their use of the connection.
  */
 PGconn *
-GetConnection(UserMapping *user, bool will_prep_stmt)
+GetConnection(UserMapping *user, bool will_prep_stmt, PgFdwConnState **state)
 {
 	bool		found;
 	ConnCacheEntry *entry;
@@ -196,6 +200,7 @@ GetConnection(UserMapping *user, bool will_prep_stmt)
 		entry->mapping_hashvalue =
 			GetSysCacheHashValue1(USERMAPPINGOID,
 								  ObjectIdGetDatum(user->umid));
+		memset(&entry->state, 0, sizeof(entry->state));
 
 		/* Now try to make the connection */
 		entry->conn = connect_pg_server(server, user);
@@ -204,6 +209,13 @@ GetConnection(UserMapping *user, bool will_prep_stmt)
 			 entry->conn, server->servername, user->umid, user->userid);
 	}
 
+	/*
+	 * An asynchronous scan of some outer query might be waiting for a FETCH
+	 * on this connection; collect its result before we send anything.
+	 */
+	if (entry->state.pendingScan)
+		process_pending_request(&entry->state);
+
 	/*
 	 * Start a new transaction or subtransaction if needed.
 	 */
@@ -212,6 +224,8 @@ GetConnection(UserMapping *user, bool will_prep_stmt)
 	/* Remember if caller will prepare statements */
 	entry->have_prep_stmt |= will_prep_stmt;
 
+	if (state)
+		*state = &entry->state;
 	return entry->conn;
 }
 
@@ -503,10 +517,17 @@ GetPrepStmtNumber(PGconn *conn)
  * This function is interruptible by signals.
  *
  * Caller is responsible for the error handling on the result.
+ *
+ * If state is given, any asynchronous request pending on the connection is
+ * completed first.
  */
 PGresult *
-pgfdw_exec_query(PGconn *conn, const char *query)
+pgfdw_exec_query(PGconn *conn, const char *query, PgFdwConnState *state)
 {
+	/* First, process a pending asynchronous request, if any. */
+	if (state && state->pendingScan)
+		process_pending_request(state);
+
 	/*
 	 * Submit a query.  Since we don't use non-blocking mode, this also can
 	 * block.  But its risk is relatively small, so we ignore that for now.
@@ -689,6 +710,10 @@ pgfdw_xact_callback(XactEvent event, void *arg)
 					 */
 					pgfdw_reject_incomplete_xact_state_change(entry);
 
+					/* Collect any asynchronous FETCH still in flight */
+					if (entry->state.pendingScan)
+						process_pending_request(&entry->state);
+
 					/* Commit all remote transactions during pre-commit */
 					entry->changing_xact_state = true;
 					do_sql_command(entry->conn, "COMMIT TRANSACTION");
@@ -806,6 +831,7 @@ pgfdw_xact_callback(XactEvent event, void *arg)
 
 		/* Reset state to show we're out of a transaction */
 		entry->xact_depth = 0;
+		entry->state.pendingScan = NULL;
 
 		/*
 		 * If the connection isn't in a good idle state, discard it to
@@ -880,6 +906,10 @@ pgfdw_subxact_callback(SubXactEvent event, SubTransactionId mySubid,
 			 */
 			pgfdw_reject_incomplete_xact_state_change(entry);
 
+			/* Collect any asynchronous FETCH still in flight */
+			if (entry->state.pendingScan)
+				process_pending_request(&entry->state);
+
 			/* Commit all remote subtransactions during pre-commit */
 			snprintf(sql, sizeof(sql), "RELEASE SAVEPOINT s%d", curlevel);
 			entry->changing_xact_state = true;
@@ -928,6 +958,13 @@ pgfdw_subxact_callback(SubXactEvent event, SubTransactionId mySubid,
 			entry->changing_xact_state = abort_cleanup_failure;
 		}
 
+		/*
+		 * On abort, any asynchronous FETCH in flight has been cancelled; the
+		 * scan that sent it will complain if it's ever used again.
+		 */
+		if (event == SUBXACT_EVENT_ABORT_SUB)
+			entry->state.pendingScan = NULL;
+
 		/* OK, we're outta that level of subtransaction */
 		entry->xact_depth--;
 	}
@@ -506,7 +506,7 @@ SELECT t1.c1 FROM ft1 t1 WHERE EXISTS (SELECT 1 FROM ft2 t2 WHERE t1.c1 = t2.c1)
 EXPLAIN (VERBOSE, COSTS OFF)
 SELECT t1.c1 FROM ft1 t1 WHERE NOT EXISTS (SELECT 1 FROM ft2 t2 WHERE t1.c1 = t2.c2) ORDER BY t1.c1 OFFSET 100 LIMIT 10;
 SELECT t1.c1 FROM ft1 t1 WHERE NOT EXISTS (SELECT 1 FROM ft2 t2 WHERE t1.c1 = t2.c2) ORDER BY t1.c1 OFFSET 100 LIMIT 10;
--- CROSS JOIN, not pushed down
+-- CROSS JOIN can be pushed down
 EXPLAIN (VERBOSE, COSTS OFF)
 SELECT t1.c1, t2.c1 FROM ft1 t1 CROSS JOIN ft2 t2 ORDER BY t1.c1, t2.c1 OFFSET 100 LIMIT 10;
 SELECT t1.c1, t2.c1 FROM ft1 t1 CROSS JOIN ft2 t2 ORDER BY t1.c1, t2.c1 OFFSET 100 LIMIT 10;
@@ -1879,6 +1879,21 @@ delete from itrtest;
 
 drop index loct1_idx;
 
+-- Rows routed to a local partition are queued up for heap_multi_insert,
+-- while those for the foreign partitions go straight to the remote side
+create table itrtest3 partition of itrtest for values in (3);
+create index on itrtest3 (b);
+insert into itrtest select g % 3 + 1, 'row' || g from generate_series(1, 3000) g;
+select tableoid::regclass, count(*), min(b), max(b) FROM itrtest group by 1 order by 1;
+select count(*) FROM loct1;
+select count(*) FROM loct2;
+set enable_seqscan = off;
+select * FROM itrtest3 where b = 'row2999';
+reset enable_seqscan;
+
+delete from itrtest;
+drop table itrtest3;
+
 -- Test that remote triggers work with insert tuple routing
 create function br_insert_trigfunc() returns trigger as $$
 begin
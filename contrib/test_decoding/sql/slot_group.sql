@@ -0,0 +1,60 @@
+-- predictability
+SET synchronous_commit = on;
+
+-- decoding several slots in a single pass over the WAL
+SELECT 'init' FROM pg_create_logical_replication_slot('regression_slot_g1', 'test_decoding');
+CREATE TABLE slot_group_tbl(id int PRIMARY KEY, data text);
+INSERT INTO slot_group_tbl VALUES (1, 'before g2');
+SELECT 'init' FROM pg_create_logical_replication_slot('regression_slot_g2', 'test_decoding');
+INSERT INTO slot_group_tbl VALUES (2, 'both');
+BEGIN;
+UPDATE slot_group_tbl SET data = 'updated' WHERE id = 1;
+DELETE FROM slot_group_tbl WHERE id = 2;
+COMMIT;
+
+-- the second slot doesn't see what committed before it was created; each
+-- slot's options apply to its own output only
+SELECT slot_name, data FROM pg_logical_slot_group_peek_changes(
+  ARRAY['regression_slot_g1', 'regression_slot_g2'], NULL, NULL,
+  'include-xids', '0', 'skip-empty-xacts', '1');
+
+-- peeking doesn't consume anything
+SELECT slot_name, count(*) FROM pg_logical_slot_group_peek_changes(
+  ARRAY['regression_slot_g2', 'regression_slot_g1'], NULL, NULL,
+  'include-xids', '0', 'skip-empty-xacts', '1')
+  GROUP BY slot_name ORDER BY slot_name;
+
+-- consume the changes of the first slot on its own, then check the group
+SELECT count(*) FROM pg_logical_slot_get_changes('regression_slot_g1', NULL, NULL,
+  'include-xids', '0', 'skip-empty-xacts', '1');
+INSERT INTO slot_group_tbl VALUES (3, 'after');
+SELECT slot_name, data FROM pg_logical_slot_group_get_changes(
+  ARRAY['regression_slot_g1', 'regression_slot_g2'], NULL, NULL,
+  'include-xids', '0', 'skip-empty-xacts', '1');
+
+-- everything was consumed
+SELECT slot_name, data FROM pg_logical_slot_group_get_changes(
+  ARRAY['regression_slot_g1', 'regression_slot_g2'], NULL, NULL,
+  'include-xids', '0', 'skip-empty-xacts', '1');
+SELECT count(*) FROM pg_logical_slot_peek_changes('regression_slot_g2', NULL, NULL,
+  'include-xids', '0', 'skip-empty-xacts', '1');
+
+-- the slots are released again
+SELECT slot_name, active FROM pg_replication_slots
+  WHERE slot_name LIKE 'regression_slot_g%' ORDER BY slot_name;
+
+-- errors
+SELECT * FROM pg_logical_slot_group_peek_changes(NULL, NULL, NULL);
+SELECT * FROM pg_logical_slot_group_peek_changes('{}', NULL, NULL);
+SELECT * FROM pg_logical_slot_group_peek_changes(
+  ARRAY['regression_slot_g1', NULL], NULL, NULL);
+SELECT * FROM pg_logical_slot_group_peek_changes(
+  ARRAY['regression_slot_g1', 'regression_slot_g1'], NULL, NULL);
+SELECT * FROM pg_logical_slot_group_peek_changes(
+  ARRAY['regression_slot_g1', 'nonexistent'], NULL, NULL);
+SELECT * FROM pg_logical_slot_group_peek_changes(
+  ARRAY['regression_slot_g1'], NULL, NULL, 'nonexistent-option', '1');
+
+SELECT pg_drop_replication_slot('regression_slot_g1');
+SELECT pg_drop_replication_slot('regression_slot_g2');
+DROP TABLE slot_group_tbl;
@@ -216,7 +216,7 @@ static BlockNumber
 system_time_nextsampleblock(SampleScanState *node)
 {
 	SystemTimeSamplerData *sampler = (SystemTimeSamplerData *) node->tsm_state;
-	HeapScanDesc scan = node->ss.ss_currentScanDesc;
+	HeapScanDesc scan = (HeapScanDesc) node->ss.ss_currentScanDesc;
 	instr_time	cur_time;
 
 	/* First call within scan? */
@@ -29,6 +29,7 @@
 #include "postmaster/autovacuum.h"
 #include "storage/bufmgr.h"
 #include "storage/freespace.h"
+#include "storage/lmgr.h"
 #include "utils/builtins.h"
 #include "utils/index_selfuncs.h"
 #include "utils/memutils.h"
@@ -98,6 +99,7 @@ brinhandler(PG_FUNCTION_ARGS)
 	amroutine->ampredlocks = false;
 	amroutine->amcanparallel = false;
 	amroutine->amcaninclude = false;
+	amroutine->amsummarizing = true;
 	amroutine->amkeytype = InvalidOid;
 
 	amroutine->ambuild = brinbuild;
@@ -208,9 +210,33 @@ brininsert(Relation idxRel, Datum *values, bool *nulls,
 		brtup = brinGetTupleForHeapBlock(revmap, heapBlk, &buf, &off,
 										 NULL, BUFFER_LOCK_SHARE, NULL);
 
-		/* if range is unsummarized, there's nothing to do */
+		/*
+		 * If the range is unsummarized, there's normally nothing to do.  But
+		 * if auto-summarization is enabled and we just inserted the first
+		 * tuple into the first block of the range, summarize it right away:
+		 * the range is most likely the newest one at the end of the table,
+		 * so it's nearly empty and cheap to scan, and from then on it's kept
+		 * up to date by the code below, rather than being useless to scans
+		 * until it fills and the autovacuum request above is served.  The
+		 * heap scan will see our new tuple, so we're done afterwards.
+		 *
+		 * To serialize against concurrent summarization by VACUUM and
+		 * brin_summarize_range, which hold ShareUpdateExclusiveLock on the
+		 * table, we need that lock too; if it's not immediately available,
+		 * just leave the range to those.
+		 */
 		if (!brtup)
+		{
+			if (autosummarize &&
+				heapBlk == origHeapBlk &&
+				ItemPointerGetOffsetNumber(heaptid) == FirstOffsetNumber &&
+				ConditionalLockRelation(heapRel, ShareUpdateExclusiveLock))
+			{
+				brinsummarize(idxRel, heapRel, heapBlk, true, NULL, NULL);
+				UnlockRelation(heapRel, ShareUpdateExclusiveLock);
+			}
 			break;
+		}
 
 		/* First time through in this statement? */
 		if (bdesc == NULL)
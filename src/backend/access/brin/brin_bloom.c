@@ -0,0 +1,353 @@
+/*
+ * brin_bloom.c
+ *		Implementation of Bloom opclass for BRIN
+ *
+ * A bloom filter summarizes the set of values appearing in a page range in
+ * a fixed amount of space, and can tell that a value does not appear in it
+ * with no false negatives and a bounded rate of false positives.  Unlike
+ * minmax, its effectiveness does not depend on the values within a range
+ * being close together, so it remains useful when a few out-of-order rows
+ * would widen every minmax range to cover most of the key space.  Only
+ * equality searches can be supported.
+ *
+ * The filter is sized from the number of distinct values expected in a page
+ * range, which we estimate as BLOOM_NDISTINCT_FRACTION of the maximum number
+ * of heap tuples the range can hold, and from BLOOM_FALSE_POSITIVE_RATE.
+ * The size is capped at BLOOM_MAX_FILTER_BYTES so that the summary fits on
+ * an index page; a range holding many more distinct values than estimated
+ * merely sees its false positive rate go up.
+ *
+ * Values are hashed once with the data type's hash function (support
+ * procedure BLOOM_PROCNUM_HASH); the probe positions of the individual
+ * "hash functions" are derived from that with double hashing.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *	  src/backend/access/brin/brin_bloom.c
+ */
+#include "postgres.h"
+
+#include <math.h>
+
+#include "access/brin.h"
+#include "access/brin_internal.h"
+#include "access/brin_tuple.h"
+#include "access/genam.h"
+#include "access/hash.h"
+#include "access/htup_details.h"
+#include "access/stratnum.h"
+#include "catalog/pg_type.h"
+#include "utils/builtins.h"
+#include "utils/lsyscache.h"
+#include "utils/rel.h"
+
+
+/* Support procedure number of the type's hash function */
+#define BLOOM_PROCNUM_HASH			11
+
+/* Filter sizing parameters; see file header */
+#define BLOOM_NDISTINCT_FRACTION	0.1
+#define BLOOM_FALSE_POSITIVE_RATE	0.01
+#define BLOOM_MIN_FILTER_BYTES		64
+#define BLOOM_MAX_FILTER_BYTES		(BLCKSZ / 2)
+#define BLOOM_MAX_NHASHES			16
+
+/*
+ * On-disk representation of the filter, stored as a bytea.  A filter with
+ * nhashes == 0 is "saturated": it matches every value.  We produce one if
+ * asked to merge two filters of different geometry, which can happen if the
+ * index's pages_per_range setting was altered.
+ */
+typedef struct BloomFilter
+{
+	int32		vl_len_;		/* varlena header (do not touch directly!) */
+	uint32		nbits;			/* size of the bitmap, in bits */
+	uint16		nhashes;		/* number of probe positions per value */
+	char		bits[FLEXIBLE_ARRAY_MEMBER];
+} BloomFilter;
+
+#define BloomFilterSize(nbits)	(offsetof(BloomFilter, bits) + (nbits) / 8)
+
+static BloomFilter *bloom_create(Relation index);
+static bool bloom_add_hash(BloomFilter *filter, uint32 hash);
+static bool bloom_contains_hash(BloomFilter *filter, uint32 hash);
+static uint32 bloom_hash_value(BrinDesc *bdesc, AttrNumber attno,
+				 Oid colloid, Datum value);
+
+
+Datum
+brin_bloom_opcinfo(PG_FUNCTION_ARGS)
+{
+	BrinOpcInfo *result;
+
+	/*
+	 * We store a single bytea per column; the hash function is looked up
+	 * through the index's support procedure cache, so no opaque state is
+	 * needed.
+	 */
+	result = palloc0(SizeofBrinOpcInfo(1));
+	result->oi_nstored = 1;
+	result->oi_opaque = NULL;
+	result->oi_typcache[0] = lookup_type_cache(BYTEAOID, 0);
+
+	PG_RETURN_POINTER(result);
+}
+
+/*
+ * Add the hash of the given value to the range's filter, creating the filter
+ * if this is the first non-null value seen.  Return true if the filter
+ * changed, i.e. if any of the value's bits was not yet set.
+ */
+Datum
+brin_bloom_add_value(PG_FUNCTION_ARGS)
+{
+	BrinDesc   *bdesc = (BrinDesc *) PG_GETARG_POINTER(0);
+	BrinValues *column = (BrinValues *) PG_GETARG_POINTER(1);
+	Datum		newval = PG_GETARG_DATUM(2);
+	bool		isnull = PG_GETARG_DATUM(3);
+	Oid			colloid = PG_GET_COLLATION();
+	BloomFilter *filter;
+	uint32		hash;
+	bool		updated;
+
+	/*
+	 * If the new value is null, we record that we saw it if it's the first
+	 * one; otherwise, there's nothing to do.
+	 */
+	if (isnull)
+	{
+		if (column->bv_hasnulls)
+			PG_RETURN_BOOL(false);
+
+		column->bv_hasnulls = true;
+		PG_RETURN_BOOL(true);
+	}
+
+	hash = bloom_hash_value(bdesc, column->bv_attno, colloid, newval);
+
+	if (column->bv_allnulls)
+	{
+		filter = bloom_create(bdesc->bd_index);
+		bloom_add_hash(filter, hash);
+		column->bv_values[0] = PointerGetDatum(filter);
+		column->bv_allnulls = false;
+		PG_RETURN_BOOL(true);
+	}
+
+	/*
+	 * The stored value is a private copy made by brin_deform_tuple, or one
+	 * we created ourselves, so it can be modified in place.
+	 */
+	filter = (BloomFilter *) PG_DETOAST_DATUM(column->bv_values[0]);
+	updated = bloom_add_hash(filter, hash);
+	column->bv_values[0] = PointerGetDatum(filter);
+
+	PG_RETURN_BOOL(updated);
+}
+
+/*
+ * Given an index tuple corresponding to a certain page range and a scan key,
+ * return whether the scan key may match a value in the range.
+ */
+Datum
+brin_bloom_consistent(PG_FUNCTION_ARGS)
+{
+	BrinDesc   *bdesc = (BrinDesc *) PG_GETARG_POINTER(0);
+	BrinValues *column = (BrinValues *) PG_GETARG_POINTER(1);
+	ScanKey		key = (ScanKey) PG_GETARG_POINTER(2);
+	Oid			colloid = PG_GET_COLLATION();
+	BloomFilter *filter;
+	uint32		hash;
+
+	Assert(key->sk_attno == column->bv_attno);
+
+	/* handle IS NULL/IS NOT NULL tests */
+	if (key->sk_flags & SK_ISNULL)
+	{
+		if (key->sk_flags & SK_SEARCHNULL)
+		{
+			if (column->bv_allnulls || column->bv_hasnulls)
+				PG_RETURN_BOOL(true);
+			PG_RETURN_BOOL(false);
+		}
+
+		/*
+		 * For IS NOT NULL, we can only skip ranges that are known to have
+		 * only nulls.
+		 */
+		if (key->sk_flags & SK_SEARCHNOTNULL)
+			PG_RETURN_BOOL(!column->bv_allnulls);
+
+		/*
+		 * Neither IS NULL nor IS NOT NULL was used; assume all indexable
+		 * operators are strict and return false.
+		 */
+		PG_RETURN_BOOL(false);
+	}
+
+	/* if the range is all empty, it cannot possibly be consistent */
+	if (column->bv_allnulls)
+		PG_RETURN_BOOL(false);
+
+	if (key->sk_strategy != BTEqualStrategyNumber)
+		elog(ERROR, "invalid strategy number %d", key->sk_strategy);
+
+	filter = (BloomFilter *) PG_DETOAST_DATUM(column->bv_values[0]);
+	hash = bloom_hash_value(bdesc, key->sk_attno, colloid, key->sk_argument);
+
+	PG_RETURN_BOOL(bloom_contains_hash(filter, hash));
+}
+
+/*
+ * Given two BrinValues, update the first of them as a union of the summary
+ * values contained in both.  The second one is untouched.
+ */
+Datum
+brin_bloom_union(PG_FUNCTION_ARGS)
+{
+	BrinValues *col_a = (BrinValues *) PG_GETARG_POINTER(1);
+	BrinValues *col_b = (BrinValues *) PG_GETARG_POINTER(2);
+	BloomFilter *filter_a;
+	BloomFilter *filter_b;
+
+	Assert(col_a->bv_attno == col_b->bv_attno);
+
+	/* Adjust "hasnulls" */
+	if (!col_a->bv_hasnulls && col_b->bv_hasnulls)
+		col_a->bv_hasnulls = true;
+
+	/* If there are no values in B, there's nothing left to do */
+	if (col_b->bv_allnulls)
+		PG_RETURN_VOID();
+
+	filter_b = (BloomFilter *) PG_DETOAST_DATUM(col_b->bv_values[0]);
+
+	/* If A has no values, just copy B's filter */
+	if (col_a->bv_allnulls)
+	{
+		col_a->bv_allnulls = false;
+		col_a->bv_values[0] =
+			PointerGetDatum(pg_detoast_datum_copy((struct varlena *) filter_b));
+		PG_RETURN_VOID();
+	}
+
+	filter_a = (BloomFilter *) PG_DETOAST_DATUM(col_a->bv_values[0]);
+
+	if (filter_a->nhashes != 0)
+	{
+		if (filter_b->nhashes == filter_a->nhashes &&
+			filter_b->nbits == filter_a->nbits)
+		{
+			uint32		i;
+
+			for (i = 0; i < filter_a->nbits / 8; i++)
+				filter_a->bits[i] |= filter_b->bits[i];
+		}
+		else
+		{
+			/* incompatible filters; give up on filtering this range */
+			filter_a->nhashes = 0;
+		}
+	}
+
+	col_a->bv_values[0] = PointerGetDatum(filter_a);
+
+	PG_RETURN_VOID();
+}
+
+/*
+ * Create an empty filter, sized for the page ranges of the given index.
+ */
+static BloomFilter *
+bloom_create(Relation index)
+{
+	double		ndistinct;
+	double		nbits;
+	int			nbytes;
+	int			nhashes;
+	BloomFilter *filter;
+
+	ndistinct = BLOOM_NDISTINCT_FRACTION * MaxHeapTuplesPerPage *
+		BrinGetPagesPerRange(index);
+
+	/* optimal number of bits for the estimated number of values */
+	nbits = ceil(-(ndistinct * log(BLOOM_FALSE_POSITIVE_RATE)) /
+				 (M_LN2 * M_LN2));
+	nbytes = (int) Min(ceil(nbits / 8), (double) BLOOM_MAX_FILTER_BYTES);
+	nbytes = Max(nbytes, BLOOM_MIN_FILTER_BYTES);
+
+	/* and the optimal number of probes for the size we actually use */
+	nhashes = (int) rint((nbytes * 8) / ndistinct * M_LN2);
+	nhashes = Max(nhashes, 1);
+	nhashes = Min(nhashes, BLOOM_MAX_NHASHES);
+
+	filter = (BloomFilter *) palloc0(BloomFilterSize(nbytes * 8));
+	SET_VARSIZE(filter, BloomFilterSize(nbytes * 8));
+	filter->nbits = nbytes * 8;
+	filter->nhashes = nhashes;
+
+	return filter;
+}
+
+/*
+ * Set the bits for the given hash value.  Returns true if any of them was
+ * not set already.
+ */
+static bool
+bloom_add_hash(BloomFilter *filter, uint32 hash)
+{
+	uint64		h1 = hash;
+	uint64		h2 = DatumGetUInt32(hash_uint32(hash)) | 1;
+	bool		updated = false;
+	int			i;
+
+	for (i = 0; i < filter->nhashes; i++)
+	{
+		uint32		bit = (uint32) ((h1 + i * h2) % filter->nbits);
+		char		mask = (char) (1 << (bit % 8));
+
+		if ((filter->bits[bit / 8] & mask) == 0)
+		{
+			filter->bits[bit / 8] |= mask;
+			updated = true;
+		}
+	}
+
+	return updated;
+}
+
+/*
+ * Test whether all the bits for the given hash value are set.
+ */
+static bool
+bloom_contains_hash(BloomFilter *filter, uint32 hash)
+{
+	uint64		h1 = hash;
+	uint64		h2 = DatumGetUInt32(hash_uint32(hash)) | 1;
+	int			i;
+
+	for (i = 0; i < filter->nhashes; i++)
+	{
+		uint32		bit = (uint32) ((h1 + i * h2) % filter->nbits);
+
+		if ((filter->bits[bit / 8] & (1 << (bit % 8))) == 0)
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Hash a value of the indexed column with the opclass' hash function.
+ */
+static uint32
+bloom_hash_value(BrinDesc *bdesc, AttrNumber attno, Oid colloid, Datum value)
+{
+	FmgrInfo   *hashFn;
+
+	hashFn = index_getprocinfo(bdesc->bd_index, attno, BLOOM_PROCNUM_HASH);
+
+	return DatumGetUInt32(FunctionCall1Coll(hashFn, colloid, value));
+}
@@ -0,0 +1,645 @@
+/*
+ * brin_minmax_multi.c
+ *		Implementation of Multi Min/Max opclass for BRIN
+ *
+ * Plain minmax keeps a single [min, max] interval per page range, so a single
+ * outlier in an otherwise well-correlated range makes the interval, and
+ * hence the range, match almost any query.  This opclass instead keeps up to
+ * MINMAX_MULTI_MAX_RANGES disjoint intervals per page range.  Values falling
+ * into an existing interval don't change the summary; any other value is
+ * added as a new single-point interval, and when there are too many
+ * intervals the two that are closest to each other are merged.  Closeness is
+ * measured by a type-specific distance function, support procedure
+ * MINMAX_MULTI_PROCNUM_DISTANCE, which returns the distance between two
+ * values as a float8.
+ *
+ * The summary is stored as a one-dimensional array of the indexed type,
+ * holding the lower and upper bound of each interval in ascending order.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *	  src/backend/access/brin/brin_minmax_multi.c
+ */
+#include "postgres.h"
+
+#include <math.h>
+
+#include "access/brin_internal.h"
+#include "access/brin_tuple.h"
+#include "access/genam.h"
+#include "access/stratnum.h"
+#include "catalog/pg_amop.h"
+#include "catalog/pg_type.h"
+#include "utils/array.h"
+#include "utils/builtins.h"
+#include "utils/date.h"
+#include "utils/lsyscache.h"
+#include "utils/rel.h"
+#include "utils/syscache.h"
+#include "utils/timestamp.h"
+
+
+/* Support procedure number of the distance function */
+#define MINMAX_MULTI_PROCNUM_DISTANCE	11
+
+/* Maximum number of intervals kept per page range */
+#define MINMAX_MULTI_MAX_RANGES			16
+
+typedef struct MinmaxMultiOpaque
+{
+	Oid			cached_subtype;
+	FmgrInfo	strategy_procinfos[BTMaxStrategyNumber];
+} MinmaxMultiOpaque;
+
+/*
+ * Working representation of a summary: nranges intervals, with the bounds
+ * of interval i in values[2 * i] and values[2 * i + 1].  ranges_deserialize
+ * leaves room for one more interval, so that a new one can be added before
+ * merging.  For by-reference types the values point into 'array', which is
+ * the detoasted summary.
+ */
+typedef struct MinmaxMultiRanges
+{
+	int			nranges;
+	Datum	   *values;
+	ArrayType  *array;			/* NULL if not deserialized */
+	Datum		summary;		/* the summary it came from */
+} MinmaxMultiRanges;
+
+static void ranges_deserialize(Form_pg_attribute attr, Datum summary,
+				   MinmaxMultiRanges *ranges);
+static Datum ranges_serialize(Form_pg_attribute attr,
+				 MinmaxMultiRanges *ranges);
+static void ranges_free(MinmaxMultiRanges *ranges);
+static void ranges_reduce(BrinDesc *bdesc, AttrNumber attno, Oid colloid,
+			  MinmaxMultiRanges *ranges, int maxranges);
+static bool minmax_multi_compare(BrinDesc *bdesc, AttrNumber attno,
+					 Oid subtype, uint16 strategynum, Oid colloid,
+					 Datum value1, Datum value2);
+static FmgrInfo *minmax_multi_get_strategy_procinfo(BrinDesc *bdesc,
+								   uint16 attno, Oid subtype,
+								   uint16 strategynum);
+
+
+Datum
+brin_minmax_multi_opcinfo(PG_FUNCTION_ARGS)
+{
+	Oid			typoid = PG_GETARG_OID(0);
+	Oid			arraytypoid;
+	BrinOpcInfo *result;
+
+	arraytypoid = get_array_type(typoid);
+	if (!OidIsValid(arraytypoid))
+		elog(ERROR, "could not find array type for data type %u", typoid);
+
+	/*
+	 * opaque->strategy_procinfos is initialized lazily; here it is set to
+	 * all-uninitialized by palloc0 which sets fn_oid to InvalidOid.
+	 */
+	result = palloc0(MAXALIGN(SizeofBrinOpcInfo(1)) +
+					 sizeof(MinmaxMultiOpaque));
+	result->oi_nstored = 1;
+	result->oi_opaque = (MinmaxMultiOpaque *)
+		MAXALIGN((char *) result + SizeofBrinOpcInfo(1));
+	result->oi_typcache[0] = lookup_type_cache(arraytypoid, 0);
+
+	PG_RETURN_POINTER(result);
+}
+
+/*
+ * Examine the given index tuple (which contains partial status of a certain
+ * page range) by comparing it to the given value that comes from another heap
+ * tuple.  If the new value is not covered by any of the intervals, add it
+ * and return true.  Otherwise, return false and do not modify in this case.
+ */
+Datum
+brin_minmax_multi_add_value(PG_FUNCTION_ARGS)
+{
+	BrinDesc   *bdesc = (BrinDesc *) PG_GETARG_POINTER(0);
+	BrinValues *column = (BrinValues *) PG_GETARG_POINTER(1);
+	Datum		newval = PG_GETARG_DATUM(2);
+	bool		isnull = PG_GETARG_DATUM(3);
+	Oid			colloid = PG_GET_COLLATION();
+	Form_pg_attribute attr;
+	AttrNumber	attno;
+	MinmaxMultiRanges ranges;
+	Datum		newsummary;
+	int			i;
+
+	/*
+	 * If the new value is null, we record that we saw it if it's the first
+	 * one; otherwise, there's nothing to do.
+	 */
+	if (isnull)
+	{
+		if (column->bv_hasnulls)
+			PG_RETURN_BOOL(false);
+
+		column->bv_hasnulls = true;
+		PG_RETURN_BOOL(true);
+	}
+
+	attno = column->bv_attno;
+	attr = TupleDescAttr(bdesc->bd_tupdesc, attno - 1);
+
+	if (column->bv_allnulls)
+	{
+		ranges.nranges = 0;
+		ranges.values = palloc(sizeof(Datum) * 2);
+		ranges.array = NULL;
+	}
+	else
+		ranges_deserialize(attr, column->bv_values[0], &ranges);
+
+	/*
+	 * Find the first interval whose upper bound is not less than the new
+	 * value.  If the value is within that interval, there's nothing to do.
+	 */
+	for (i = 0; i < ranges.nranges; i++)
+	{
+		if (!minmax_multi_compare(bdesc, attno, attr->atttypid,
+								  BTLessStrategyNumber, colloid,
+								  ranges.values[2 * i + 1], newval))
+			break;
+	}
+
+	if (i < ranges.nranges &&
+		minmax_multi_compare(bdesc, attno, attr->atttypid,
+							 BTLessEqualStrategyNumber, colloid,
+							 ranges.values[2 * i], newval))
+	{
+		ranges_free(&ranges);
+		PG_RETURN_BOOL(false);
+	}
+
+	/* Insert a new single-point interval before interval i */
+	memmove(&ranges.values[2 * i + 2], &ranges.values[2 * i],
+			sizeof(Datum) * 2 * (ranges.nranges - i));
+	ranges.values[2 * i] = newval;
+	ranges.values[2 * i + 1] = newval;
+	ranges.nranges++;
+
+	ranges_reduce(bdesc, attno, colloid, &ranges, MINMAX_MULTI_MAX_RANGES);
+
+	/*
+	 * The old summary was palloc'd for us (see brin_deform_tuple), so we can
+	 * free it once the new one is built.
+	 */
+	newsummary = ranges_serialize(attr, &ranges);
+	ranges_free(&ranges);
+	if (!column->bv_allnulls)
+		pfree(DatumGetPointer(column->bv_values[0]));
+	column->bv_values[0] = newsummary;
+	column->bv_allnulls = false;
+
+	PG_RETURN_BOOL(true);
+}
+
+/*
+ * Given an index tuple corresponding to a certain page range and a scan key,
+ * return whether the scan key is consistent with one of the index tuple's
+ * intervals.  Return true if so, false otherwise.
+ */
+Datum
+brin_minmax_multi_consistent(PG_FUNCTION_ARGS)
+{
+	BrinDesc   *bdesc = (BrinDesc *) PG_GETARG_POINTER(0);
+	BrinValues *column = (BrinValues *) PG_GETARG_POINTER(1);
+	ScanKey		key = (ScanKey) PG_GETARG_POINTER(2);
+	Oid			colloid = PG_GET_COLLATION(),
+				subtype;
+	AttrNumber	attno;
+	Form_pg_attribute attr;
+	Datum		value;
+	MinmaxMultiRanges ranges;
+	bool		matches;
+	int			i;
+
+	Assert(key->sk_attno == column->bv_attno);
+
+	/* handle IS NULL/IS NOT NULL tests */
+	if (key->sk_flags & SK_ISNULL)
+	{
+		if (key->sk_flags & SK_SEARCHNULL)
+		{
+			if (column->bv_allnulls || column->bv_hasnulls)
+				PG_RETURN_BOOL(true);
+			PG_RETURN_BOOL(false);
+		}
+
+		/*
+		 * For IS NOT NULL, we can only skip ranges that are known to have
+		 * only nulls.
+		 */
+		if (key->sk_flags & SK_SEARCHNOTNULL)
+			PG_RETURN_BOOL(!column->bv_allnulls);
+
+		/*
+		 * Neither IS NULL nor IS NOT NULL was used; assume all indexable
+		 * operators are strict and return false.
+		 */
+		PG_RETURN_BOOL(false);
+	}
+
+	/* if the range is all empty, it cannot possibly be consistent */
+	if (column->bv_allnulls)
+		PG_RETURN_BOOL(false);
+
+	attno = key->sk_attno;
+	attr = TupleDescAttr(bdesc->bd_tupdesc, attno - 1);
+	subtype = key->sk_subtype;
+	value = key->sk_argument;
+
+	ranges_deserialize(attr, column->bv_values[0], &ranges);
+
+	switch (key->sk_strategy)
+	{
+		case BTLessStrategyNumber:
+		case BTLessEqualStrategyNumber:
+			/* only the overall minimum matters */
+			matches = minmax_multi_compare(bdesc, attno, subtype,
+										   key->sk_strategy, colloid,
+										   ranges.values[0], value);
+			break;
+		case BTEqualStrategyNumber:
+
+			/*
+			 * In the equality case (WHERE col = someval), we want to return
+			 * the current page range if any of the intervals contains the
+			 * scan key.
+			 */
+			matches = false;
+			for (i = 0; i < ranges.nranges; i++)
+			{
+				if (minmax_multi_compare(bdesc, attno, subtype,
+										 BTLessEqualStrategyNumber, colloid,
+										 ranges.values[2 * i], value) &&
+					minmax_multi_compare(bdesc, attno, subtype,
+										 BTGreaterEqualStrategyNumber, colloid,
+										 ranges.values[2 * i + 1], value))
+				{
+					matches = true;
+					break;
+				}
+			}
+			break;
+		case BTGreaterEqualStrategyNumber:
+		case BTGreaterStrategyNumber:
+			/* only the overall maximum matters */
+			matches = minmax_multi_compare(bdesc, attno, subtype,
+										   key->sk_strategy, colloid,
+										   ranges.values[2 * ranges.nranges - 1],
+										   value);
+			break;
+		default:
+			/* shouldn't happen */
+			elog(ERROR, "invalid strategy number %d", key->sk_strategy);
+			matches = false;
+			break;
+	}
+
+	ranges_free(&ranges);
+
+	PG_RETURN_BOOL(matches);
+}
+
+/*
+ * Given two BrinValues, update the first of them as a union of the summary
+ * values contained in both.  The second one is untouched.
+ */
+Datum
+brin_minmax_multi_union(PG_FUNCTION_ARGS)
+{
+	BrinDesc   *bdesc = (BrinDesc *) PG_GETARG_POINTER(0);
+	BrinValues *col_a = (BrinValues *) PG_GETARG_POINTER(1);
+	BrinValues *col_b = (BrinValues *) PG_GETARG_POINTER(2);
+	Oid			colloid = PG_GET_COLLATION();
+	AttrNumber	attno;
+	Form_pg_attribute attr;
+	MinmaxMultiRanges ranges_a;
+	MinmaxMultiRanges ranges_b;
+	MinmaxMultiRanges merged;
+	int			ia,
+				ib;
+
+	Assert(col_a->bv_attno == col_b->bv_attno);
+
+	/* Adjust "hasnulls" */
+	if (!col_a->bv_hasnulls && col_b->bv_hasnulls)
+		col_a->bv_hasnulls = true;
+
+	/* If there are no values in B, there's nothing left to do */
+	if (col_b->bv_allnulls)
+		PG_RETURN_VOID();
+
+	attno = col_a->bv_attno;
+	attr = TupleDescAttr(bdesc->bd_tupdesc, attno - 1);
+
+	/*
+	 * Adjust "allnulls".  If A doesn't have values, just copy the values from
+	 * B into A, and we're done.  We cannot run the operators in this case,
+	 * because values in A might contain garbage.  Note we already established
+	 * that B contains values.
+	 */
+	if (col_a->bv_allnulls)
+	{
+		col_a->bv_allnulls = false;
+		ranges_deserialize(attr, col_b->bv_values[0], &ranges_b);
+		col_a->bv_values[0] = ranges_serialize(attr, &ranges_b);
+		ranges_free(&ranges_b);
+		PG_RETURN_VOID();
+	}
+
+	ranges_deserialize(attr, col_a->bv_values[0], &ranges_a);
+	ranges_deserialize(attr, col_b->bv_values[0], &ranges_b);
+
+	/*
+	 * Merge the two sorted interval lists, coalescing intervals that
+	 * overlap.  This can temporarily produce up to twice the maximum number
+	 * of intervals, so use a larger workspace.
+	 */
+	merged.values = palloc(sizeof(Datum) * 2 *
+						   (ranges_a.nranges + ranges_b.nranges));
+	merged.nranges = 0;
+	ia = ib = 0;
+	while (ia < ranges_a.nranges || ib < ranges_b.nranges)
+	{
+		Datum	   *next;
+		int			n = merged.nranges;
+
+		/* pick the interval with the lower lower bound */
+		if (ib >= ranges_b.nranges ||
+			(ia < ranges_a.nranges &&
+			 minmax_multi_compare(bdesc, attno, attr->atttypid,
+								  BTLessEqualStrategyNumber, colloid,
+								  ranges_a.values[2 * ia],
+								  ranges_b.values[2 * ib])))
+			next = &ranges_a.values[2 * ia++];
+		else
+			next = &ranges_b.values[2 * ib++];
+
+		if (n > 0 &&
+			minmax_multi_compare(bdesc, attno, attr->atttypid,
+								 BTLessEqualStrategyNumber, colloid,
+								 next[0], merged.values[2 * n - 1]))
+		{
+			/* overlaps the previous interval; extend that one if needed */
+			if (minmax_multi_compare(bdesc, attno, attr->atttypid,
+									 BTGreaterStrategyNumber, colloid,
+									 next[1], merged.values[2 * n - 1]))
+				merged.values[2 * n - 1] = next[1];
+		}
+		else
+		{
+			merged.values[2 * n] = next[0];
+			merged.values[2 * n + 1] = next[1];
+			merged.nranges++;
+		}
+	}
+
+	ranges_reduce(bdesc, attno, colloid, &merged, MINMAX_MULTI_MAX_RANGES);
+
+	col_a->bv_values[0] = ranges_serialize(attr, &merged);
+	pfree(merged.values);
+	ranges_free(&ranges_a);
+	ranges_free(&ranges_b);
+	pfree(DatumGetPointer(ranges_a.summary));
+
+	PG_RETURN_VOID();
+}
+
+/*
+ * Distance functions, used to decide which intervals to merge.
+ */
+Datum
+brin_minmax_multi_distance_int4(PG_FUNCTION_ARGS)
+{
+	int32		a = PG_GETARG_INT32(0);
+	int32		b = PG_GETARG_INT32(1);
+
+	PG_RETURN_FLOAT8((float8) b - (float8) a);
+}
+
+Datum
+brin_minmax_multi_distance_int8(PG_FUNCTION_ARGS)
+{
+	int64		a = PG_GETARG_INT64(0);
+	int64		b = PG_GETARG_INT64(1);
+
+	PG_RETURN_FLOAT8((float8) b - (float8) a);
+}
+
+Datum
+brin_minmax_multi_distance_float8(PG_FUNCTION_ARGS)
+{
+	float8		a = PG_GETARG_FLOAT8(0);
+	float8		b = PG_GETARG_FLOAT8(1);
+	float8		delta = b - a;
+
+	/*
+	 * NaN sorts above all other values, and infinities are equal to
+	 * themselves; treat such pairs as adjacent.
+	 */
+	if (isnan(delta))
+		delta = 0.0;
+
+	PG_RETURN_FLOAT8(delta);
+}
+
+Datum
+brin_minmax_multi_distance_date(PG_FUNCTION_ARGS)
+{
+	DateADT		a = PG_GETARG_DATEADT(0);
+	DateADT		b = PG_GETARG_DATEADT(1);
+
+	PG_RETURN_FLOAT8((float8) b - (float8) a);
+}
+
+/* Also used for timestamptz, which has the same representation */
+Datum
+brin_minmax_multi_distance_timestamp(PG_FUNCTION_ARGS)
+{
+	Timestamp	a = PG_GETARG_TIMESTAMP(0);
+	Timestamp	b = PG_GETARG_TIMESTAMP(1);
+
+	PG_RETURN_FLOAT8((float8) b - (float8) a);
+}
+
+/*
+ * Unpack a stored summary into its working representation.  The values
+ * point into the (detoasted) array; the caller must not free it while they
+ * are in use.
+ */
+static void
+ranges_deserialize(Form_pg_attribute attr, Datum summary,
+				   MinmaxMultiRanges *ranges)
+{
+	ArrayType  *array = DatumGetArrayTypeP(summary);
+	Datum	   *elems;
+	int			nelems;
+
+	deconstruct_array(array, attr->atttypid, attr->attlen, attr->attbyval,
+					  attr->attalign, &elems, NULL, &nelems);
+
+	if (nelems < 2 || nelems % 2 != 0 ||
+		nelems > 2 * MINMAX_MULTI_MAX_RANGES)
+		elog(ERROR, "invalid multi-minmax summary with %d values", nelems);
+
+	ranges->values = palloc(sizeof(Datum) * (nelems + 2));
+	memcpy(ranges->values, elems, sizeof(Datum) * nelems);
+	ranges->nranges = nelems / 2;
+	ranges->array = array;
+	ranges->summary = summary;
+	pfree(elems);
+}
+
+/*
+ * Build the array to be stored from the working representation.
+ */
+static Datum
+ranges_serialize(Form_pg_attribute attr, MinmaxMultiRanges *ranges)
+{
+	ArrayType  *array;
+
+	array = construct_array(ranges->values, 2 * ranges->nranges,
+							attr->atttypid, attr->attlen, attr->attbyval,
+							attr->attalign);
+
+	return PointerGetDatum(array);
+}
+
+/*
+ * Release the working representation, including the detoasted copy of the
+ * summary if one was made.
+ */
+static void
+ranges_free(MinmaxMultiRanges *ranges)
+{
+	if (ranges->array != NULL &&
+		(Pointer) ranges->array != DatumGetPointer(ranges->summary))
+		pfree(ranges->array);
+	pfree(ranges->values);
+}
+
+/*
+ * Merge intervals until no more than maxranges are left, always merging the
+ * pair of adjacent intervals with the smallest gap between them.
+ */
+static void
+ranges_reduce(BrinDesc *bdesc, AttrNumber attno, Oid colloid,
+			  MinmaxMultiRanges *ranges, int maxranges)
+{
+	FmgrInfo   *distanceFn = NULL;
+
+	while (ranges->nranges > maxranges)
+	{
+		int			best = 0;
+		float8		bestdist = 0.0;
+		int			i;
+
+		if (distanceFn == NULL)
+			distanceFn = index_getprocinfo(bdesc->bd_index, attno,
+										   MINMAX_MULTI_PROCNUM_DISTANCE);
+
+		for (i = 0; i < ranges->nranges - 1; i++)
+		{
+			float8		dist;
+
+			dist = DatumGetFloat8(FunctionCall2Coll(distanceFn, colloid,
+													ranges->values[2 * i + 1],
+													ranges->values[2 * i + 2]));
+			if (i == 0 || dist < bestdist)
+			{
+				best = i;
+				bestdist = dist;
+			}
+		}
+
+		/* merge interval best + 1 into interval best */
+		ranges->values[2 * best + 1] = ranges->values[2 * best + 3];
+		memmove(&ranges->values[2 * best + 2], &ranges->values[2 * best + 4],
+				sizeof(Datum) * 2 * (ranges->nranges - best - 2));
+		ranges->nranges--;
+	}
+}
+
+/*
+ * Compare two values with the operator for the given strategy.
+ */
+static bool
+minmax_multi_compare(BrinDesc *bdesc, AttrNumber attno, Oid subtype,
+					 uint16 strategynum, Oid colloid,
+					 Datum value1, Datum value2)
+{
+	FmgrInfo   *finfo;
+
+	finfo = minmax_multi_get_strategy_procinfo(bdesc, attno, subtype,
+											   strategynum);
+
+	return DatumGetBool(FunctionCall2Coll(finfo, colloid, value1, value2));
+}
+
+/*
+ * Cache and return the procedure for the given strategy.
+ *
+ * Note: this function mirrors minmax_get_strategy_procinfo; see notes
+ * there.  If changes are made here, see that function too.
+ */
+static FmgrInfo *
+minmax_multi_get_strategy_procinfo(BrinDesc *bdesc, uint16 attno, Oid subtype,
+								   uint16 strategynum)
+{
+	MinmaxMultiOpaque *opaque;
+
+	Assert(strategynum >= 1 &&
+		   strategynum <= BTMaxStrategyNumber);
+
+	opaque = (MinmaxMultiOpaque *) bdesc->bd_info[attno - 1]->oi_opaque;
+
+	/*
+	 * We cache the procedures for the previous subtype in the opaque struct,
+	 * to avoid repetitive syscache lookups.  If the subtype changed,
+	 * invalidate all the cached entries.
+	 */
+	if (opaque->cached_subtype != subtype)
+	{
+		uint16		i;
+
+		for (i = 1; i <= BTMaxStrategyNumber; i++)
+			opaque->strategy_procinfos[i - 1].fn_oid = InvalidOid;
+		opaque->cached_subtype = subtype;
+	}
+
+	if (opaque->strategy_procinfos[strategynum - 1].fn_oid == InvalidOid)
+	{
+		Form_pg_attribute attr;
+		HeapTuple	tuple;
+		Oid			opfamily,
+					oprid;
+		bool		isNull;
+
+		opfamily = bdesc->bd_index->rd_opfamily[attno - 1];
+		attr = TupleDescAttr(bdesc->bd_tupdesc, attno - 1);
+		tuple = SearchSysCache4(AMOPSTRATEGY, ObjectIdGetDatum(opfamily),
+								ObjectIdGetDatum(attr->atttypid),
+								ObjectIdGetDatum(subtype),
+								Int16GetDatum(strategynum));
+
+		if (!HeapTupleIsValid(tuple))
+			elog(ERROR, "missing operator %d(%u,%u) in opfamily %u",
+				 strategynum, attr->atttypid, subtype, opfamily);
+
+		oprid = DatumGetObjectId(SysCacheGetAttr(AMOPSTRATEGY, tuple,
+												 Anum_pg_amop_amopopr, &isNull));
+		ReleaseSysCache(tuple);
+		Assert(!isNull && RegProcedureIsValid(oprid));
+
+		fmgr_info_cxt(get_opcode(oprid),
+					  &opaque->strategy_procinfos[strategynum - 1],
+					  bdesc->bd_context);
+	}
+
+	return &opaque->strategy_procinfos[strategynum - 1];
+}
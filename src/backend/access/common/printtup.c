@@ -17,7 +17,10 @@
 
 #include "access/printtup.h"
 #include "libpq/libpq.h"
+#include "libpq/libpq-be.h"
 #include "libpq/pqformat.h"
+#include "mb/pg_wchar.h"
+#include "miscadmin.h"
 #include "tcop/pquery.h"
 #include "utils/lsyscache.h"
 #include "utils/memdebug.h"
@@ -29,6 +32,7 @@ static void printtup_startup(DestReceiver *self, int operation,
 static bool printtup(TupleTableSlot *slot, DestReceiver *self);
 static bool printtup_20(TupleTableSlot *slot, DestReceiver *self);
 static bool printtup_internal_20(TupleTableSlot *slot, DestReceiver *self);
+static bool printtup_batch(TupleTableSlot *slot, DestReceiver *self);
 static void printtup_shutdown(DestReceiver *self);
 static void printtup_destroy(DestReceiver *self);
 
@@ -58,6 +62,24 @@ typedef struct
 	FmgrInfo	finfo;			/* Precomputed call info for output fn */
 } PrinttupAttrInfo;
 
+/*
+ * Per-attribute part of a batch of rows to be sent in one DataRowBatch
+ * message
+ */
+typedef struct
+{
+	StringInfoData nulls;		/* bitmap, bit set if the value isn't null */
+	StringInfoData lengths;		/* lengths of the non-null values */
+	StringInfoData data;		/* the non-null values */
+	int			width;			/* length common to all values, or -1 */
+} PrinttupBatchAttr;
+
+/* batch width before the first non-null value */
+#define BATCH_WIDTH_UNKNOWN		(-2)
+
+/* send a batch once its values take this much space, even if not full */
+#define BATCH_MAX_BYTES			(1024 * 1024)
+
 typedef struct
 {
 	DestReceiver pub;			/* publicly-known function pointers */
@@ -68,6 +90,13 @@ typedef struct
 	int			nattrs;
 	PrinttupAttrInfo *myinfo;	/* Cached info about each attr */
 	MemoryContext tmpcontext;	/* Memory context for per-row workspace */
+
+	/* used by printtup_batch() only */
+	PrinttupBatchAttr *batch;	/* rows collected, per attr */
+	int			batchnattrs;	/* number of attrs in batch */
+	int			batchrows;		/* number of rows in batch */
+	Size		batchbytes;		/* size of the values in batch */
+	MemoryContext batchcontext; /* Memory context holding batch */
 } DR_printtup;
 
 /* ----------------
@@ -95,6 +124,8 @@ printtup_create_DR(CommandDest dest)
 	self->nattrs = 0;
 	self->myinfo = NULL;
 	self->tmpcontext = NULL;
+	self->batch = NULL;
+	self->batchcontext = NULL;
 
 	return (DestReceiver *) self;
 }
@@ -145,6 +176,20 @@ printtup_startup(DestReceiver *self, int operation, TupleDesc typeinfo)
 												"printtup",
 												ALLOCSET_DEFAULT_SIZES);
 
+	/*
+	 * If the client asked for it in the startup packet, collect the rows
+	 * into batches and send them column by column in DataRowBatch messages
+	 * instead of one DataRow message per row.
+	 */
+	if (PG_PROTOCOL_MAJOR(FrontendProtocol) >= 3 &&
+		MyProcPort != NULL && MyProcPort->row_batch_size > 1)
+	{
+		myState->pub.receiveSlot = printtup_batch;
+		myState->batchcontext = AllocSetContextCreate(CurrentMemoryContext,
+													  "printtup batch",
+													  ALLOCSET_DEFAULT_SIZES);
+	}
+
 	if (PG_PROTOCOL_MAJOR(FrontendProtocol) < 3)
 	{
 		/*
@@ -451,6 +496,173 @@ printtup(TupleTableSlot *slot, DestReceiver *self)
 	return true;
 }
 
+/* ----------------
+ *		printtup_send_batch --- send the rows collected by printtup_batch
+ * ----------------
+ */
+static void
+printtup_send_batch(DR_printtup *myState)
+{
+	StringInfo	buf = &myState->buf;
+	int			i;
+
+	if (myState->batchrows == 0)
+		return;
+
+	pq_beginmessage_reuse(buf, 'b');
+
+	pq_sendint16(buf, myState->batchnattrs);
+	pq_sendint32(buf, myState->batchrows);
+
+	for (i = 0; i < myState->batchnattrs; i++)
+	{
+		PrinttupBatchAttr *thisBatch = myState->batch + i;
+		int			width = thisBatch->width;
+
+		/* an attribute that's null in all rows has no values at all */
+		if (width == BATCH_WIDTH_UNKNOWN)
+			width = 0;
+
+		pq_sendint32(buf, width);
+		pq_sendint32(buf, thisBatch->data.len);
+		pq_sendbytes(buf, thisBatch->nulls.data, thisBatch->nulls.len);
+		if (width < 0)
+			pq_sendbytes(buf, thisBatch->lengths.data,
+						 thisBatch->lengths.len);
+		pq_sendbytes(buf, thisBatch->data.data, thisBatch->data.len);
+
+		resetStringInfo(&thisBatch->nulls);
+		resetStringInfo(&thisBatch->lengths);
+		resetStringInfo(&thisBatch->data);
+		thisBatch->width = BATCH_WIDTH_UNKNOWN;
+	}
+
+	pq_endmessage_reuse(buf);
+
+	myState->batchrows = 0;
+	myState->batchbytes = 0;
+}
+
+/* ----------------
+ *		printtup_batch --- collect a tuple for a DataRowBatch message
+ *
+ * The values are converted as by printtup, but instead of sending them
+ * right away, they are appended to the batch, separately for each
+ * attribute.  The batch is sent once it holds the number of rows the client
+ * asked for, once its values take BATCH_MAX_BYTES, and at shutdown.
+ * ----------------
+ */
+static bool
+printtup_batch(TupleTableSlot *slot, DestReceiver *self)
+{
+	TupleDesc	typeinfo = slot->tts_tupleDescriptor;
+	DR_printtup *myState = (DR_printtup *) self;
+	MemoryContext oldcontext;
+	int			natts = typeinfo->natts;
+	int			row = myState->batchrows;
+	int			i;
+
+	/* Set or update my derived attribute info, if needed */
+	if (myState->attrinfo != typeinfo || myState->nattrs != natts)
+	{
+		/* rows of a different type can't go into the same batch */
+		printtup_send_batch(myState);
+		printtup_prepare_info(myState, typeinfo, natts);
+	}
+
+	if (myState->batch == NULL || myState->batchnattrs != natts)
+	{
+		MemoryContextReset(myState->batchcontext);
+		oldcontext = MemoryContextSwitchTo(myState->batchcontext);
+
+		myState->batch = (PrinttupBatchAttr *)
+			palloc(Max(natts, 1) * sizeof(PrinttupBatchAttr));
+		for (i = 0; i < natts; i++)
+		{
+			PrinttupBatchAttr *thisBatch = myState->batch + i;
+
+			initStringInfo(&thisBatch->nulls);
+			initStringInfo(&thisBatch->lengths);
+			initStringInfo(&thisBatch->data);
+			thisBatch->width = BATCH_WIDTH_UNKNOWN;
+		}
+		myState->batchnattrs = natts;
+		myState->batchrows = 0;
+		myState->batchbytes = 0;
+
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	/* Make sure the tuple is fully deconstructed */
+	slot_getallattrs(slot);
+
+	/* Switch into per-row context so we can recover memory below */
+	oldcontext = MemoryContextSwitchTo(myState->tmpcontext);
+
+	for (i = 0; i < natts; ++i)
+	{
+		PrinttupAttrInfo *thisState = myState->myinfo + i;
+		PrinttupBatchAttr *thisBatch = myState->batch + i;
+		Datum		attr = slot->tts_values[i];
+		char	   *value;
+		int			len;
+
+		if (row % BITS_PER_BYTE == 0)
+			appendStringInfoCharMacro(&thisBatch->nulls, 0);
+
+		if (slot->tts_isnull[i])
+			continue;
+
+		thisBatch->nulls.data[thisBatch->nulls.len - 1] |=
+			1 << (row % BITS_PER_BYTE);
+
+		if (thisState->typisvarlena)
+			VALGRIND_CHECK_MEM_IS_DEFINED(DatumGetPointer(attr),
+										  VARSIZE_ANY(attr));
+
+		if (thisState->format == 0)
+		{
+			/* Text output */
+			char	   *outputstr;
+
+			outputstr = OutputFunctionCall(&thisState->finfo, attr);
+			len = strlen(outputstr);
+			value = pg_server_to_client(outputstr, len);
+			if (value != outputstr)
+				len = strlen(value);
+		}
+		else
+		{
+			/* Binary output */
+			bytea	   *outputbytes;
+
+			outputbytes = SendFunctionCall(&thisState->finfo, attr);
+			value = VARDATA(outputbytes);
+			len = VARSIZE(outputbytes) - VARHDRSZ;
+		}
+
+		if (thisBatch->width == BATCH_WIDTH_UNKNOWN)
+			thisBatch->width = len;
+		else if (thisBatch->width != len)
+			thisBatch->width = -1;
+
+		pq_sendint32(&thisBatch->lengths, len);
+		appendBinaryStringInfo(&thisBatch->data, value, len);
+		myState->batchbytes += len;
+	}
+
+	/* Return to caller's context, and flush row's temporary memory */
+	MemoryContextSwitchTo(oldcontext);
+	MemoryContextReset(myState->tmpcontext);
+
+	myState->batchrows++;
+	if (myState->batchrows >= MyProcPort->row_batch_size ||
+		myState->batchbytes >= BATCH_MAX_BYTES)
+		printtup_send_batch(myState);
+
+	return true;
+}
+
 /* ----------------
  *		printtup_20 --- print a tuple in protocol 2.0
  * ----------------
@@ -538,6 +750,14 @@ printtup_shutdown(DestReceiver *self)
 {
 	DR_printtup *myState = (DR_printtup *) self;
 
+	/* Send the last batch of rows */
+	if (myState->batch)
+		printtup_send_batch(myState);
+	myState->batch = NULL;
+	if (myState->batchcontext)
+		MemoryContextDelete(myState->batchcontext);
+	myState->batchcontext = NULL;
+
 	if (myState->myinfo)
 		pfree(myState->myinfo);
 	myState->myinfo = NULL;
@@ -0,0 +1,404 @@
+/*-------------------------------------------------------------------------
+ *
+ * tidstore.c
+ *	  Compact, ordered storage of heap TIDs.
+ *
+ * A TidStore holds a set of TIDs that is built one heap block at a time, in
+ * increasing block order, and then probed for membership, like the list of
+ * dead tuples VACUUM collects in its first heap pass and checks every index
+ * tuple against.  A flat array of ItemPointerData costs six bytes per TID and
+ * a binary search over all of them per probe; here we store each block
+ * number only once, followed by the block's offsets in whichever of two
+ * representations is smaller:
+ *
+ *	- a sorted array of 16-bit offset numbers, or
+ *	- a bitmap with one bit per offset number up to the largest one present.
+ *
+ * A block with a single TID keeps its offset in the block entry itself.  On
+ * pages where many tuples died, as is typical after bulk updates and
+ * deletes, the bitmap needs well under one byte per TID, and a probe is a
+ * binary search over blocks rather than TIDs followed by a bit test.  The
+ * worst case, one dead tuple per page, costs eight bytes per TID.
+ *
+ * The store is a single chunk of memory containing no pointers: block
+ * entries grow from the start of the chunk and the per-block offset
+ * containers from its end.  That lets the chunk be larger than MaxAllocSize
+ * and be placed in shared memory by the caller.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/access/common/tidstore.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/tidstore.h"
+#include "utils/memutils.h"
+
+/*
+ * One entry per block.  If TIDSTORE_INLINE is set in info, the low 16 bits
+ * are the block's only offset number.  Otherwise info is the distance, in
+ * uint16 words, from the end of the chunk back to the block's container.
+ */
+typedef struct TidStoreEntry
+{
+	BlockNumber blkno;
+	uint32		info;
+} TidStoreEntry;
+
+#define TIDSTORE_INLINE				0x80000000
+
+/*
+ * Container distances must stay below TIDSTORE_INLINE, so that's as many
+ * uint16 words as the chunk may hold.
+ */
+#define TIDSTORE_MAX_BYTES			((Size) (TIDSTORE_INLINE - 1) * sizeof(uint16))
+
+/*
+ * A container starts with a header word.  If TIDSTORE_BITMAP is set, the
+ * remaining bits give the number of bitmap words that follow, where bit
+ * (off - 1) represents offset number off; otherwise they give the number of
+ * sorted offset numbers that follow.
+ */
+#define TIDSTORE_BITMAP				0x8000
+#define TIDSTORE_COUNT_MASK			0x7FFF
+
+#define TIDSTORE_BITS_PER_WORD		16
+#define TIDSTORE_BITMAP_WORDS(maxoff) \
+	(((maxoff) + TIDSTORE_BITS_PER_WORD - 1) / TIDSTORE_BITS_PER_WORD)
+
+/* Most space a single block can take, see TidStoreIsFull */
+#define TIDSTORE_MAX_BLOCK_SPACE \
+	(sizeof(TidStoreEntry) + \
+	 (1 + TIDSTORE_BITMAP_WORDS(MaxOffsetNumber)) * sizeof(uint16))
+
+struct TidStore
+{
+	Size		size;			/* total size of the chunk, in bytes */
+	int64		ntids;			/* # of TIDs stored */
+	int			nblocks;		/* # of entries[] in use */
+	Size		ndatawords;		/* # of uint16 words used at end of chunk */
+	TidStoreEntry entries[FLEXIBLE_ARRAY_MEMBER];
+};
+
+#define TidStoreDataEnd(ts) \
+	((uint16 *) ((char *) (ts) + (ts)->size))
+#define TidStoreFreeSpace(ts) \
+	((ts)->size - offsetof(TidStore, entries) - \
+	 (ts)->nblocks * sizeof(TidStoreEntry) - \
+	 (ts)->ndatawords * sizeof(uint16))
+
+
+/*
+ * TidStoreSize - amount of memory to allocate for a TidStore
+ *
+ * max_bytes is the memory budget; there's no point in allocating more than
+ * max_blocks blocks could ever need, however.  Nor can the store address
+ * more than TIDSTORE_MAX_BYTES; a larger budget is silently reduced, and
+ * the caller just finds the store full sooner.
+ */
+Size
+TidStoreSize(Size max_bytes, BlockNumber max_blocks)
+{
+	Size		size;
+
+	max_bytes = Min(max_bytes, TIDSTORE_MAX_BYTES);
+
+	/* curious coding here to ensure the multiplication can't overflow */
+	if (max_bytes / TIDSTORE_MAX_BLOCK_SPACE > (Size) max_blocks)
+		max_bytes = (Size) max_blocks * TIDSTORE_MAX_BLOCK_SPACE;
+
+	/* always leave room for at least one block */
+	size = offsetof(TidStore, entries) + max_bytes;
+	size = Max(size, offsetof(TidStore, entries) + TIDSTORE_MAX_BLOCK_SPACE);
+
+	return MAXALIGN(size);
+}
+
+/*
+ * TidStoreInitialize - set up an empty TidStore in caller-supplied memory
+ *
+ * size must be a value returned by TidStoreSize.
+ */
+TidStore *
+TidStoreInitialize(void *space, Size size)
+{
+	TidStore   *ts = (TidStore *) space;
+
+	Assert(size == MAXALIGN(size));
+	Assert(size >= offsetof(TidStore, entries) + TIDSTORE_MAX_BLOCK_SPACE);
+	Assert(size - offsetof(TidStore, entries) <= MAXALIGN(TIDSTORE_MAX_BYTES));
+
+	ts->size = size;
+	TidStoreReset(ts);
+
+	return ts;
+}
+
+/*
+ * TidStoreCreate - create an empty TidStore in CurrentMemoryContext
+ */
+TidStore *
+TidStoreCreate(Size max_bytes, BlockNumber max_blocks)
+{
+	Size		size = TidStoreSize(max_bytes, max_blocks);
+
+	return TidStoreInitialize(MemoryContextAllocHuge(CurrentMemoryContext,
+													 size),
+							  size);
+}
+
+/*
+ * TidStoreFree - release a TidStore made by TidStoreCreate
+ */
+void
+TidStoreFree(TidStore *ts)
+{
+	pfree(ts);
+}
+
+/*
+ * TidStoreReset - forget all TIDs, keeping the memory
+ */
+void
+TidStoreReset(TidStore *ts)
+{
+	ts->ntids = 0;
+	ts->nblocks = 0;
+	ts->ndatawords = 0;
+}
+
+/*
+ * TidStoreIsFull - might the TIDs of another block not fit?
+ *
+ * Callers must check this before each TidStoreAddBlock.
+ */
+bool
+TidStoreIsFull(TidStore *ts)
+{
+	return TidStoreFreeSpace(ts) < TIDSTORE_MAX_BLOCK_SPACE;
+}
+
+/*
+ * TidStoreAddBlock - add the TIDs of one block
+ *
+ * blkno must be larger than that of any block added before, and the
+ * noffsets offsets must be sorted and distinct.
+ */
+void
+TidStoreAddBlock(TidStore *ts, BlockNumber blkno,
+				 OffsetNumber *offsets, int noffsets)
+{
+	TidStoreEntry *entry;
+	OffsetNumber maxoff;
+	int			nbitmapwords;
+	uint16	   *container;
+	int			i;
+
+	Assert(noffsets > 0 && noffsets <= MaxOffsetNumber);
+	Assert(ts->nblocks == 0 || ts->entries[ts->nblocks - 1].blkno < blkno);
+
+	if (TidStoreIsFull(ts))
+		elog(ERROR, "out of space in TID store");
+
+	entry = &ts->entries[ts->nblocks];
+	entry->blkno = blkno;
+	ts->nblocks++;
+	ts->ntids += noffsets;
+
+	if (noffsets == 1)
+	{
+		entry->info = TIDSTORE_INLINE | offsets[0];
+		return;
+	}
+
+	maxoff = offsets[noffsets - 1];
+	nbitmapwords = TIDSTORE_BITMAP_WORDS(maxoff);
+
+	if (nbitmapwords <= noffsets)
+	{
+		ts->ndatawords += 1 + nbitmapwords;
+		container = TidStoreDataEnd(ts) - ts->ndatawords;
+		container[0] = TIDSTORE_BITMAP | nbitmapwords;
+		memset(&container[1], 0, nbitmapwords * sizeof(uint16));
+		for (i = 0; i < noffsets; i++)
+		{
+			int			bit = offsets[i] - 1;
+
+			container[1 + bit / TIDSTORE_BITS_PER_WORD] |=
+				(uint16) 1 << (bit % TIDSTORE_BITS_PER_WORD);
+		}
+	}
+	else
+	{
+		ts->ndatawords += 1 + noffsets;
+		container = TidStoreDataEnd(ts) - ts->ndatawords;
+		container[0] = noffsets;
+		for (i = 0; i < noffsets; i++)
+		{
+			Assert(i == 0 || offsets[i - 1] < offsets[i]);
+			container[1 + i] = offsets[i];
+		}
+	}
+
+	Assert(ts->ndatawords < TIDSTORE_INLINE);
+	entry->info = ts->ndatawords;
+}
+
+/*
+ * TidStoreIsMember - is the given TID in the store?
+ */
+bool
+TidStoreIsMember(TidStore *ts, ItemPointer tid)
+{
+	BlockNumber blkno = ItemPointerGetBlockNumber(tid);
+	OffsetNumber off = ItemPointerGetOffsetNumber(tid);
+	int			lo = 0;
+	int			hi = ts->nblocks - 1;
+	TidStoreEntry *entry = NULL;
+	uint16	   *container;
+	int			count;
+
+	/* binary search for the block */
+	while (lo <= hi)
+	{
+		int			mid = lo + (hi - lo) / 2;
+
+		if (ts->entries[mid].blkno < blkno)
+			lo = mid + 1;
+		else if (ts->entries[mid].blkno > blkno)
+			hi = mid - 1;
+		else
+		{
+			entry = &ts->entries[mid];
+			break;
+		}
+	}
+	if (entry == NULL)
+		return false;
+
+	if (entry->info & TIDSTORE_INLINE)
+		return (entry->info & ~TIDSTORE_INLINE) == off;
+
+	container = TidStoreDataEnd(ts) - entry->info;
+	count = container[0] & TIDSTORE_COUNT_MASK;
+
+	if (container[0] & TIDSTORE_BITMAP)
+	{
+		int			bit = off - 1;
+
+		if (bit < 0 || bit >= count * TIDSTORE_BITS_PER_WORD)
+			return false;
+		return (container[1 + bit / TIDSTORE_BITS_PER_WORD] &
+				((uint16) 1 << (bit % TIDSTORE_BITS_PER_WORD))) != 0;
+	}
+	else
+	{
+		/* sorted offsets; binary search them too */
+		lo = 0;
+		hi = count - 1;
+		while (lo <= hi)
+		{
+			int			mid = lo + (hi - lo) / 2;
+
+			if (container[1 + mid] < off)
+				lo = mid + 1;
+			else if (container[1 + mid] > off)
+				hi = mid - 1;
+			else
+				return true;
+		}
+		return false;
+	}
+}
+
+/*
+ * TidStoreNumTids - number of TIDs stored
+ */
+int64
+TidStoreNumTids(TidStore *ts)
+{
+	return ts->ntids;
+}
+
+/*
+ * TidStoreNumBlocks - number of distinct blocks stored
+ */
+int
+TidStoreNumBlocks(TidStore *ts)
+{
+	return ts->nblocks;
+}
+
+/*
+ * TidStoreMinCapacity - number of TIDs an empty store can surely hold
+ *
+ * This is the worst case of one TID per block; stores usually fill up much
+ * later than that.
+ */
+int64
+TidStoreMinCapacity(TidStore *ts)
+{
+	return (ts->size - offsetof(TidStore, entries) - TIDSTORE_MAX_BLOCK_SPACE) /
+		sizeof(TidStoreEntry) + 1;
+}
+
+/*
+ * TidStoreGetBlock - fetch the TIDs of the blockindex'th block, in order
+ *
+ * The block's offsets are stored into "offsets", which must have room for
+ * MaxOffsetNumber entries, and their number into *noffsets.  Returns the
+ * block number.
+ */
+BlockNumber
+TidStoreGetBlock(TidStore *ts, int blockindex,
+				 OffsetNumber *offsets, int *noffsets)
+{
+	TidStoreEntry *entry;
+	uint16	   *container;
+	int			count;
+	int			n = 0;
+	int			i;
+
+	Assert(blockindex >= 0 && blockindex < ts->nblocks);
+	entry = &ts->entries[blockindex];
+
+	if (entry->info & TIDSTORE_INLINE)
+	{
+		offsets[0] = entry->info & ~TIDSTORE_INLINE;
+		*noffsets = 1;
+		return entry->blkno;
+	}
+
+	container = TidStoreDataEnd(ts) - entry->info;
+	count = container[0] & TIDSTORE_COUNT_MASK;
+
+	if (container[0] & TIDSTORE_BITMAP)
+	{
+		for (i = 0; i < count; i++)
+		{
+			uint16		word = container[1 + i];
+			int			bit = 0;
+
+			while (word != 0)
+			{
+				if (word & 1)
+					offsets[n++] = i * TIDSTORE_BITS_PER_WORD + bit + 1;
+				word >>= 1;
+				bit++;
+			}
+		}
+	}
+	else
+	{
+		for (i = 0; i < count; i++)
+			offsets[n++] = container[1 + i];
+	}
+
+	*noffsets = n;
+	return entry->blkno;
+}
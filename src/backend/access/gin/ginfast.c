@@ -226,6 +226,8 @@ ginHeapTupleFastInsert(GinState *ginstate, GinTupleCollector *collector)
 	ginxlogUpdateMeta data;
 	bool		separateList = false;
 	bool		needCleanup = false;
+	bool		requestCleanup = false;
+	uint32		prevPendingPages = 0;
 	int			cleanupSize;
 	bool		needWal;
 
@@ -292,6 +294,7 @@ ginHeapTupleFastInsert(GinState *ginstate, GinTupleCollector *collector)
 		 */
 		LockBuffer(metabuffer, GIN_EXCLUSIVE);
 		metadata = GinPageGetMeta(metapage);
+		prevPendingPages = metadata->nPendingPages;
 
 		if (metadata->head == InvalidBlockNumber)
 		{
@@ -444,10 +447,20 @@ ginHeapTupleFastInsert(GinState *ginstate, GinTupleCollector *collector)
 	 * gin_pending_list_limit.
 	 *
 	 * ginInsertCleanup() should not be called inside our CRIT_SECTION.
+	 *
+	 * With autocleanup, ask autovacuum to do that already when the list
+	 * passes half the limit, so that insertions normally don't need to.  The
+	 * list only grows when a sublist is appended; request the cleanup only
+	 * when that makes it cross the threshold, so that the work item is
+	 * requested once per cycle rather than by every insertion.
 	 */
 	cleanupSize = GinGetPendingListCleanupSize(index);
 	if (metadata->nPendingPages * GIN_PAGE_FREESIZE > cleanupSize * 1024L)
 		needCleanup = true;
+	else if (separateList && GinGetAutoCleanup(index) &&
+			 metadata->nPendingPages * GIN_PAGE_FREESIZE > cleanupSize * 512L &&
+			 prevPendingPages * GIN_PAGE_FREESIZE <= cleanupSize * 512L)
+		requestCleanup = true;
 
 	UnlockReleaseBuffer(metabuffer);
 
@@ -455,10 +468,21 @@ ginHeapTupleFastInsert(GinState *ginstate, GinTupleCollector *collector)
 
 	/*
 	 * Since it could contend with concurrent cleanup process we cleanup
-	 * pending list not forcibly.
+	 * pending list not forcibly.  In particular, if autovacuum is already
+	 * cleaning it up, we don't wait for that.
 	 */
 	if (needCleanup)
 		ginInsertCleanup(ginstate, false, true, false, NULL);
+	else if (requestCleanup)
+	{
+		if (!AutoVacuumRequestWork(AVW_GINCleanPendingList,
+								   RelationGetRelid(index),
+								   InvalidBlockNumber))
+			ereport(LOG,
+					(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+					 errmsg("request for pending list cleanup for GIN index \"%s\" was not recorded",
+							RelationGetRelationName(index))));
+	}
 }
 
 /*
@@ -626,6 +626,43 @@ startScan(IndexScanDesc scan)
 		startScanKey(ginstate, so, so->keys + i);
 }
 
+/*
+ * Return the index of the first item in list[start .. nlist-1] that is
+ * > advancePast, or nlist if there is none.
+ *
+ * The items are sorted, so a binary search lets a scan key that is far
+ * behind the others leap over the items it no longer cares about, instead
+ * of stepping through them one at a time.  That matters for a frequent
+ * entry ANDed with a rare one, where most of the frequent entry's items are
+ * skipped.
+ */
+static int
+entrySkipPast(ItemPointer list, int start, int nlist,
+			  ItemPointerData advancePast)
+{
+	int			lo = start;
+	int			hi = nlist;
+
+	/* Fast path for the common case of no skipping */
+	if (lo >= hi || ginCompareItemPointers(&list[lo], &advancePast) > 0)
+		return lo;
+
+	/* Invariant: list[lo] <= advancePast, and list[hi] > advancePast */
+	if (ginCompareItemPointers(&list[hi - 1], &advancePast) <= 0)
+		return hi;
+	hi--;
+	while (hi - lo > 1)
+	{
+		int			mid = lo + (hi - lo) / 2;
+
+		if (ginCompareItemPointers(&list[mid], &advancePast) <= 0)
+			lo = mid;
+		else
+			hi = mid;
+	}
+	return hi;
+}
+
 /*
  * Load the next batch of item pointers from a posting tree.
  *
@@ -751,22 +788,20 @@ entryLoadMoreItems(GinState *ginstate, GinScanEntry entry,
 
 		entry->list = GinDataLeafPageGetItems(page, &entry->nlist, advancePast);
 
-		for (i = 0; i < entry->nlist; i++)
+		i = entrySkipPast(entry->list, 0, entry->nlist, advancePast);
+		if (i < entry->nlist)
 		{
-			if (ginCompareItemPointers(&advancePast, &entry->list[i]) < 0)
-			{
-				entry->offset = i;
+			entry->offset = i;
 
-				if (GinPageRightMost(page))
-				{
-					/* after processing the copied items, we're done. */
-					UnlockReleaseBuffer(entry->buffer);
-					entry->buffer = InvalidBuffer;
-				}
-				else
-					LockBuffer(entry->buffer, GIN_UNLOCK);
-				return;
+			if (GinPageRightMost(page))
+			{
+				/* after processing the copied items, we're done. */
+				UnlockReleaseBuffer(entry->buffer);
+				entry->buffer = InvalidBuffer;
 			}
+			else
+				LockBuffer(entry->buffer, GIN_UNLOCK);
+			return;
 		}
 	}
 }
@@ -893,6 +928,8 @@ entryGetItem(GinState *ginstate, GinScanEntry entry,
 		 */
 		do
 		{
+			entry->offset = entrySkipPast(entry->list, entry->offset,
+										  entry->nlist, advancePast);
 			if (entry->offset >= entry->nlist)
 			{
 				ItemPointerSetInvalid(&entry->curItem);
@@ -909,6 +946,15 @@ entryGetItem(GinState *ginstate, GinScanEntry entry,
 		/* A posting tree */
 		do
 		{
+			/*
+			 * Skip over items <= advancePast in the current batch.  If that
+			 * exhausts it, entryLoadMoreItems() will see that curItem is
+			 * behind advancePast and re-descend the tree to the right leaf,
+			 * rather than decoding the pages in between.
+			 */
+			entry->offset = entrySkipPast(entry->list, entry->offset,
+										  entry->nlist, advancePast);
+
 			/* If we've processed the current batch, load more items */
 			while (entry->offset >= entry->nlist)
 			{
@@ -15,17 +15,135 @@
 #include "postgres.h"
 
 #include "access/gin_private.h"
+#include "access/gin_tuple.h"
 #include "access/ginxlog.h"
+#include "access/parallel.h"
+#include "access/relscan.h"
+#include "access/xact.h"
 #include "access/xloginsert.h"
 #include "catalog/index.h"
+#include "commands/progress.h"
 #include "miscadmin.h"
+#include "pgstat.h"
 #include "storage/bufmgr.h"
+#include "storage/condition_variable.h"
 #include "storage/smgr.h"
 #include "storage/indexfsm.h"
 #include "storage/predicate.h"
+#include "storage/spin.h"
+#include "tcop/tcopprot.h"		/* pgrminclude ignore */
+#include "utils/datum.h"
 #include "utils/memutils.h"
 #include "utils/rel.h"
+#include "utils/snapmgr.h"
+#include "utils/tuplesort.h"
 
+/* Magic numbers for parallel state sharing */
+#define PARALLEL_KEY_GIN_SHARED			UINT64CONST(0xB000000000000001)
+#define PARALLEL_KEY_TUPLESORT			UINT64CONST(0xB000000000000002)
+#define PARALLEL_KEY_QUERY_TEXT			UINT64CONST(0xB000000000000003)
+
+/*
+ * DISABLE_LEADER_PARTICIPATION disables the leader's participation in
+ * parallel index builds.  This may be useful as a debugging aid.
+#undef DISABLE_LEADER_PARTICIPATION
+ */
+
+/*
+ * Largest number of TIDs put in one GinTuple, keeping tuples well within
+ * MaxAllocSize however much memory the accumulator was allowed.
+ */
+#define GIN_TUPLE_MAX_ITEMS \
+	((int) (MaxAllocSize / 2 / sizeof(ItemPointerData)))
+
+/*
+ * Status for a parallel GIN index build, shared by the leader and all
+ * workers.  See the similar BTShared in nbtsort.c.
+ */
+typedef struct GinShared
+{
+	/*
+	 * These fields are not modified during the build.  They primarily exist
+	 * for the benefit of worker processes that need to create state
+	 * corresponding to that used by the leader.
+	 */
+	Oid			heaprelid;
+	Oid			indexrelid;
+	bool		isconcurrent;
+	int			scantuplesortstates;
+
+	/*
+	 * workersdonecv is used to monitor the progress of workers.  All parallel
+	 * participants must indicate that they are done before leader can use
+	 * mutable state that workers maintain during scan (and before leader can
+	 * proceed to tuplesort_performsort()).
+	 */
+	ConditionVariable workersdonecv;
+
+	/*
+	 * mutex protects all fields before heapdesc.
+	 *
+	 * These fields contain status information of interest to GIN index
+	 * builds that must work just the same when an index is built in
+	 * parallel.
+	 */
+	slock_t		mutex;
+
+	/*
+	 * Mutable state that is maintained by workers, and reported back to
+	 * leader at end of parallel scan.
+	 *
+	 * nparticipantsdone is number of worker processes finished.
+	 *
+	 * reltuples is the total number of input heap tuples.
+	 *
+	 * indtuples is the total number of entries extracted for the index.
+	 *
+	 * brokenhotchain indicates if any worker detected a broken HOT chain
+	 * during build.
+	 */
+	int			nparticipantsdone;
+	double		reltuples;
+	double		indtuples;
+	bool		brokenhotchain;
+
+	/*
+	 * This variable-sized field must come last.
+	 *
+	 * See _gin_parallel_estimate_shared().
+	 */
+	ParallelHeapScanDescData heapdesc;
+} GinShared;
+
+/*
+ * Status for leader in parallel index build.
+ */
+typedef struct GinLeader
+{
+	/* parallel context itself */
+	ParallelContext *pcxt;
+
+	/*
+	 * nparticipanttuplesorts is the exact number of worker processes
+	 * successfully launched, plus one leader process if it participates as a
+	 * worker (only DISABLE_LEADER_PARTICIPATION builds avoid leader
+	 * participating as a worker).
+	 */
+	int			nparticipanttuplesorts;
+
+	/*
+	 * Leader process convenience pointers to shared state (leader avoids TOC
+	 * lookups).
+	 *
+	 * ginshared is the shared state for entire build.  sharedsort is the
+	 * shared, tuplesort-managed state passed to each process tuplesort.
+	 * snapshot is the snapshot used by the scan iff an MVCC snapshot is
+	 * required.
+	 */
+	GinShared  *ginshared;
+	Sharedsort *sharedsort;
+	Snapshot	snapshot;
+} GinLeader;
 
 typedef struct
 {
@@ -35,8 +153,56 @@ typedef struct
 	MemoryContext tmpCtx;
 	MemoryContext funcCtx;
 	BuildAccumulator accum;
+	Size		memlimit;		/* flush accum once it uses this much */
+
+	/*
+	 * In a parallel build, participants flush accum into sortstate rather
+	 * than the index, and the leader merges the results.  leader is set
+	 * only in the leader process.
+	 */
+	GinLeader  *leader;
+	Tuplesortstate *sortstate;
 } GinBuildState;
 
+/*
+ * Entries for one key being gathered by the leader of a parallel build,
+ * before they're inserted into the index.
+ */
+typedef struct GinBuffer
+{
+	OffsetNumber attnum;
+	GinNullCategory category;
+	Datum		key;			/* meaningful only for GIN_CAT_NORM_KEY */
+	int			nitems;
+	int			maxitems;
+	bool		sorted;			/* are items in TID order? */
+	ItemPointerData *items;
+} GinBuffer;
+
+static void ginFlushBuildState(GinBuildState *buildstate, Relation index);
+static GinTuple *_gin_build_tuple(OffsetNumber attrnum,
+				 GinNullCategory category, Datum key, int16 typlen,
+				 bool typbyval, ItemPointerData *items, int nitems);
+static Datum _gin_parse_tuple_key(GinTuple *tuple);
+static int	_gin_compare_keys(GinTuple *a, GinTuple *b, SortSupport ssup);
+static int	_gin_compare_items(const void *a, const void *b);
+static void _gin_begin_parallel(GinBuildState *buildstate, Relation heap,
+					Relation index, bool isconcurrent, int request);
+static void _gin_end_parallel(GinLeader *ginleader);
+static Size _gin_parallel_estimate_shared(Snapshot snapshot);
+static double _gin_parallel_heapscan(GinBuildState *buildstate,
+					   bool *brokenhotchain);
+static void _gin_leader_participate_as_worker(GinBuildState *buildstate,
+								  Relation heap, Relation index);
+static void _gin_parallel_scan_and_build(GinBuildState *buildstate,
+							 GinShared *ginshared,
+							 Sharedsort *sharedsort,
+							 Relation heap, Relation index,
+							 int sortmem);
+static double _gin_parallel_merge(GinBuildState *buildstate, Relation heap,
+					Relation index, bool *brokenhotchain);
+static void _gin_flush_buffer(GinBuildState *buildstate, GinBuffer *buffer);
+
 
 /*
  * Adds array of item pointers to tuple's posting list, or
@@ -285,30 +451,66 @@ ginBuildCallback(Relation index, HeapTuple htup, Datum *values,
 							   values[i], isnull[i],
 							   &htup->t_self);
 
-	/* If we've maxed out our available memory, dump everything to the index */
-	if (buildstate->accum.allocatedMemory >= (Size) maintenance_work_mem * 1024L)
+	/* If we've maxed out our available memory, dump everything */
+	if (buildstate->accum.allocatedMemory >= buildstate->memlimit)
+		ginFlushBuildState(buildstate, index);
+
+	MemoryContextSwitchTo(oldCtx);
+}
+
+/*
+ * Dump all entries in the BuildAccumulator, and reset it.
+ *
+ * Entries go straight into the index in a serial build.  In a parallel
+ * build, they go into the participant's tuplesort instead, for the leader
+ * to merge with everyone else's.
+ */
+static void
+ginFlushBuildState(GinBuildState *buildstate, Relation index)
+{
+	ItemPointerData *list;
+	Datum		key;
+	GinNullCategory category;
+	uint32		nlist;
+	OffsetNumber attnum;
+	MemoryContext oldCtx;
+
+	oldCtx = MemoryContextSwitchTo(buildstate->tmpCtx);
+
+	ginBeginBAScan(&buildstate->accum);
+	while ((list = ginGetBAEntry(&buildstate->accum,
+								 &attnum, &key, &category, &nlist)) != NULL)
 	{
-		ItemPointerData *list;
-		Datum		key;
-		GinNullCategory category;
-		uint32		nlist;
-		OffsetNumber attnum;
-
-		ginBeginBAScan(&buildstate->accum);
-		while ((list = ginGetBAEntry(&buildstate->accum,
-									 &attnum, &key, &category, &nlist)) != NULL)
+		/* there could be many entries, so be willing to abort here */
+		CHECK_FOR_INTERRUPTS();
+
+		if (buildstate->sortstate)
 		{
-			/* there could be many entries, so be willing to abort here */
-			CHECK_FOR_INTERRUPTS();
+			Form_pg_attribute attr = TupleDescAttr(RelationGetDescr(index),
+												   attnum - 1);
+			uint32		i;
+
+			for (i = 0; i < nlist; i += GIN_TUPLE_MAX_ITEMS)
+			{
+				GinTuple   *tup;
+
+				tup = _gin_build_tuple(attnum, category, key,
+									   attr->attlen, attr->attbyval,
+									   list + i,
+									   Min(nlist - i, GIN_TUPLE_MAX_ITEMS));
+				tuplesort_putgintuple(buildstate->sortstate, tup);
+				pfree(tup);
+			}
+		}
+		else
 			ginEntryInsert(&buildstate->ginstate, attnum, key, category,
 						   list, nlist, &buildstate->buildStats);
-		}
-
-		MemoryContextReset(buildstate->tmpCtx);
-		ginInitBA(&buildstate->accum);
 	}
 
 	MemoryContextSwitchTo(oldCtx);
+
+	MemoryContextReset(buildstate->tmpCtx);
+	ginInitBA(&buildstate->accum);
 }
 
 IndexBuildResult *
@@ -319,12 +521,6 @@ ginbuild(Relation heap, Relation index, IndexInfo *indexInfo)
 	GinBuildState buildstate;
 	Buffer		RootBuffer,
 				MetaBuffer;
-	ItemPointerData *list;
-	Datum		key;
-	GinNullCategory category;
-	uint32		nlist;
-	MemoryContext oldCtx;
-	OffsetNumber attnum;
 
 	if (RelationGetNumberOfBlocks(index) != 0)
 		elog(ERROR, "index \"%s\" already contains data",
@@ -389,26 +585,41 @@ ginbuild(Relation heap, Relation index, IndexInfo *indexInfo)
 
 	buildstate.accum.ginstate = &buildstate.ginstate;
 	ginInitBA(&buildstate.accum);
+	buildstate.memlimit = (Size) maintenance_work_mem * 1024L;
+	buildstate.leader = NULL;
+	buildstate.sortstate = NULL;
 
-	/*
-	 * Do the heap scan.  We disallow sync scan here because dataPlaceToPage
-	 * prefers to receive tuples in TID order.
-	 */
-	reltuples = IndexBuildHeapScan(heap, index, indexInfo, false,
-								   ginBuildCallback, (void *) &buildstate, NULL);
+	/* Attempt to launch parallel worker scan when required */
+	if (indexInfo->ii_ParallelWorkers > 0)
+		_gin_begin_parallel(&buildstate, heap, index, indexInfo->ii_Concurrent,
+							indexInfo->ii_ParallelWorkers);
 
-	/* dump remaining entries to the index */
-	oldCtx = MemoryContextSwitchTo(buildstate.tmpCtx);
-	ginBeginBAScan(&buildstate.accum);
-	while ((list = ginGetBAEntry(&buildstate.accum,
-								 &attnum, &key, &category, &nlist)) != NULL)
+	if (buildstate.leader)
 	{
-		/* there could be many entries, so be willing to abort here */
-		CHECK_FOR_INTERRUPTS();
-		ginEntryInsert(&buildstate.ginstate, attnum, key, category,
-					   list, nlist, &buildstate.buildStats);
+		/*
+		 * Merge the entries gathered by all participants into the index.
+		 * The parallel heap scan is already underway, and done if the leader
+		 * participated.
+		 */
+		reltuples = _gin_parallel_merge(&buildstate, heap, index,
+										&indexInfo->ii_BrokenHotChain);
+		_gin_end_parallel(buildstate.leader);
+	}
+	else
+	{
+		/*
+		 * Do the heap scan.  We disallow sync scan here because
+		 * dataPlaceToPage prefers to receive tuples in TID order.
+		 */
+		reltuples = IndexBuildHeapScan(heap, index, indexInfo, false,
+									   ginBuildCallback, (void *) &buildstate,
+									   NULL);
+
+		/* dump remaining entries to the index */
+		pgstat_progress_update_param(PROGRESS_CREATEIDX_SUBPHASE,
+									 PROGRESS_CREATEIDX_SUBPHASE_LOAD);
+		ginFlushBuildState(&buildstate, index);
 	}
-	MemoryContextSwitchTo(oldCtx);
 
 	MemoryContextDelete(buildstate.funcCtx);
 	MemoryContextDelete(buildstate.tmpCtx);
@@ -538,3 +749,634 @@ gininsert(Relation index, Datum *values, bool *isnull,
 
 	return false;
 }
+
+/*
+ * Form a GinTuple holding a key and a sorted array of TIDs, in palloc'd
+ * memory.
+ */
+static GinTuple *
+_gin_build_tuple(OffsetNumber attrnum, GinNullCategory category, Datum key,
+				 int16 typlen, bool typbyval,
+				 ItemPointerData *items, int nitems)
+{
+	GinTuple   *tuple;
+	Size		keylen;
+	Size		tuplen;
+
+	/* Only normal keys have a value to store */
+	if (category != GIN_CAT_NORM_KEY)
+		keylen = 0;
+	else if (typbyval)
+		keylen = sizeof(Datum);
+	else
+		keylen = datumGetSize(key, false, typlen);
+
+	tuplen = GinTupleKeyOffset + SHORTALIGN(keylen) +
+		sizeof(ItemPointerData) * nitems;
+
+	tuple = (GinTuple *) palloc0(tuplen);
+	tuple->tuplen = tuplen;
+	tuple->attrnum = attrnum;
+	tuple->typlen = typlen;
+	tuple->typbyval = typbyval;
+	tuple->category = category;
+	tuple->keylen = keylen;
+	tuple->nitems = nitems;
+
+	if (keylen > 0)
+	{
+		if (typbyval)
+			memcpy(GinTupleGetKeyData(tuple), &key, sizeof(Datum));
+		else
+			memcpy(GinTupleGetKeyData(tuple), DatumGetPointer(key), keylen);
+	}
+
+	memcpy(GinTupleGetItems(tuple), items, sizeof(ItemPointerData) * nitems);
+
+	return tuple;
+}
+
+/*
+ * Get the key stored in a GinTuple.  For pass-by-reference types, the result
+ * points into the tuple.
+ */
+static Datum
+_gin_parse_tuple_key(GinTuple *tuple)
+{
+	Datum		key;
+
+	if (tuple->category != GIN_CAT_NORM_KEY)
+		return (Datum) 0;
+
+	if (tuple->typbyval)
+	{
+		memcpy(&key, GinTupleGetKeyData(tuple), sizeof(Datum));
+		return key;
+	}
+
+	return PointerGetDatum(GinTupleGetKeyData(tuple));
+}
+
+/*
+ * Compare the keys of two GinTuples, in the same way as ginCompareAttEntries
+ * does.  ssup holds the opclass compare function for each index column.
+ */
+static int
+_gin_compare_keys(GinTuple *a, GinTuple *b, SortSupport ssup)
+{
+	if (a->attrnum != b->attrnum)
+		return (a->attrnum < b->attrnum) ? -1 : 1;
+
+	if (a->category != b->category)
+		return (a->category < b->category) ? -1 : 1;
+
+	if (a->category != GIN_CAT_NORM_KEY)
+		return 0;
+
+	return ApplySortComparator(_gin_parse_tuple_key(a), false,
+							   _gin_parse_tuple_key(b), false,
+							   &ssup[a->attrnum - 1]);
+}
+
+/*
+ * Comparator used by tuplesort_begin_index_gin() sorts.
+ *
+ * Tuples with equal keys are ordered by their first TID, which makes it
+ * likely that the leader can append each tuple's TIDs to those it already
+ * has for the key without having to sort them again.
+ */
+int
+_gin_compare_tuples(GinTuple *a, GinTuple *b, SortSupport ssup)
+{
+	int			r;
+
+	r = _gin_compare_keys(a, b, ssup);
+	if (r != 0)
+		return r;
+
+	return ginCompareItemPointers(GinTupleGetItems(a), GinTupleGetItems(b));
+}
+
+/* qsort comparator for ItemPointerData arrays */
+static int
+_gin_compare_items(const void *a, const void *b)
+{
+	return ginCompareItemPointers((ItemPointer) a, (ItemPointer) b);
+}
+
+/*
+ * Create parallel context, and launch workers for leader.
+ *
+ * buildstate argument should be initialized, except for the
+ * parallel-related fields.
+ *
+ * isconcurrent indicates if operation is CREATE INDEX CONCURRENTLY.
+ *
+ * request is the target number of parallel worker processes to launch.
+ *
+ * Sets buildstate's GinLeader, which caller must use to shut down parallel
+ * mode by passing it to _gin_end_parallel() at the very end of its index
+ * build.  If not even a single worker process can be launched, this is
+ * never set, and caller should proceed with a serial index build.
+ */
+static void
+_gin_begin_parallel(GinBuildState *buildstate, Relation heap, Relation index,
+					bool isconcurrent, int request)
+{
+	ParallelContext *pcxt;
+	int			scantuplesortstates;
+	Snapshot	snapshot;
+	Size		estginshared;
+	Size		estsort;
+	GinShared  *ginshared;
+	Sharedsort *sharedsort;
+	GinLeader  *ginleader = (GinLeader *) palloc0(sizeof(GinLeader));
+	bool		leaderparticipates = true;
+	char	   *sharedquery;
+	int			querylen;
+
+#ifdef DISABLE_LEADER_PARTICIPATION
+	leaderparticipates = false;
+#endif
+
+	/*
+	 * Enter parallel mode, and create context for parallel build of gin
+	 * index
+	 */
+	EnterParallelMode();
+	Assert(request > 0);
+	pcxt = CreateParallelContext("postgres", "_gin_parallel_build_main",
+								 request, true);
+	scantuplesortstates = leaderparticipates ? request + 1 : request;
+
+	/*
+	 * Prepare for scan of the base relation.  In a normal index build, we use
+	 * SnapshotAny because we must retrieve all tuples and do our own time
+	 * qual checks (because we have to index RECENTLY_DEAD tuples).  In a
+	 * concurrent build, we take a regular MVCC snapshot and index whatever's
+	 * live according to that.
+	 */
+	if (!isconcurrent)
+		snapshot = SnapshotAny;
+	else
+		snapshot = RegisterSnapshot(GetTransactionSnapshot());
+
+	/*
+	 * Estimate size for our own PARALLEL_KEY_GIN_SHARED workspace, and
+	 * PARALLEL_KEY_TUPLESORT tuplesort workspace
+	 */
+	estginshared = _gin_parallel_estimate_shared(snapshot);
+	shm_toc_estimate_chunk(&pcxt->estimator, estginshared);
+	estsort = tuplesort_estimate_shared(scantuplesortstates);
+	shm_toc_estimate_chunk(&pcxt->estimator, estsort);
+	shm_toc_estimate_keys(&pcxt->estimator, 2);
+
+	/* Finally, estimate PARALLEL_KEY_QUERY_TEXT space */
+	querylen = strlen(debug_query_string);
+	shm_toc_estimate_chunk(&pcxt->estimator, querylen + 1);
+	shm_toc_estimate_keys(&pcxt->estimator, 1);
+
+	/* Everyone's had a chance to ask for space, so now create the DSM */
+	InitializeParallelDSM(pcxt);
+
+	/* Store shared build state, for which we reserved space */
+	ginshared = (GinShared *) shm_toc_allocate(pcxt->toc, estginshared);
+	/* Initialize immutable state */
+	ginshared->heaprelid = RelationGetRelid(heap);
+	ginshared->indexrelid = RelationGetRelid(index);
+	ginshared->isconcurrent = isconcurrent;
+	ginshared->scantuplesortstates = scantuplesortstates;
+	ConditionVariableInit(&ginshared->workersdonecv);
+	SpinLockInit(&ginshared->mutex);
+	/* Initialize mutable state */
+	ginshared->nparticipantsdone = 0;
+	ginshared->reltuples = 0.0;
+	ginshared->indtuples = 0.0;
+	ginshared->brokenhotchain = false;
+	heap_parallelscan_initialize(&ginshared->heapdesc, heap, snapshot);
+
+	/*
+	 * Store shared tuplesort-private state, for which we reserved space.
+	 * Then, initialize opaque state using tuplesort routine.
+	 */
+	sharedsort = (Sharedsort *) shm_toc_allocate(pcxt->toc, estsort);
+	tuplesort_initialize_shared(sharedsort, scantuplesortstates,
+								pcxt->seg);
+
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_GIN_SHARED, ginshared);
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_TUPLESORT, sharedsort);
+
+	/* Store query string for workers */
+	sharedquery = (char *) shm_toc_allocate(pcxt->toc, querylen + 1);
+	memcpy(sharedquery, debug_query_string, querylen + 1);
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_QUERY_TEXT, sharedquery);
+
+	/* Launch workers, saving status for leader/caller */
+	LaunchParallelWorkers(pcxt);
+	ginleader->pcxt = pcxt;
+	ginleader->nparticipanttuplesorts = pcxt->nworkers_launched;
+	if (leaderparticipates)
+		ginleader->nparticipanttuplesorts++;
+	ginleader->ginshared = ginshared;
+	ginleader->sharedsort = sharedsort;
+	ginleader->snapshot = snapshot;
+
+	/* If no workers were successfully launched, back out (do serial build) */
+	if (pcxt->nworkers_launched == 0)
+	{
+		_gin_end_parallel(ginleader);
+		return;
+	}
+
+	/* Save leader state now that it's clear build will be parallel */
+	buildstate->leader = ginleader;
+
+	/* Join heap scan ourselves */
+	if (leaderparticipates)
+		_gin_leader_participate_as_worker(buildstate, heap, index);
+
+	/*
+	 * Caller needs to wait for all launched workers when we return.  Make
+	 * sure that the failure-to-start case will not hang forever.
+	 */
+	WaitForParallelWorkersToAttach(pcxt);
+}
+
+/*
+ * Shut down workers, destroy parallel context, and end parallel mode.
+ */
+static void
+_gin_end_parallel(GinLeader *ginleader)
+{
+	/* Shutdown worker processes */
+	WaitForParallelWorkersToFinish(ginleader->pcxt);
+	/* Free last reference to MVCC snapshot, if one was used */
+	if (IsMVCCSnapshot(ginleader->snapshot))
+		UnregisterSnapshot(ginleader->snapshot);
+	DestroyParallelContext(ginleader->pcxt);
+	ExitParallelMode();
+}
+
+/*
+ * Returns size of shared memory required to store state for a parallel
+ * gin index build based on the snapshot its parallel scan will use.
+ */
+static Size
+_gin_parallel_estimate_shared(Snapshot snapshot)
+{
+	if (!IsMVCCSnapshot(snapshot))
+	{
+		Assert(snapshot == SnapshotAny);
+		return sizeof(GinShared);
+	}
+
+	return add_size(offsetof(GinShared, heapdesc) +
+					offsetof(ParallelHeapScanDescData, phs_snapshot_data),
+					EstimateSnapshotSpace(snapshot));
+}
+
+/*
+ * Within leader, wait for end of heap scan.
+ *
+ * When called, parallel heap scan started by _gin_begin_parallel() will
+ * already be underway within worker processes (when leader participates
+ * as a worker, we should end up here just as workers are finishing).
+ *
+ * Fills in fields needed for ambuild statistics, and lets caller set
+ * field indicating that some worker encountered a broken HOT chain.
+ *
+ * Returns the total number of heap tuples scanned.
+ */
+static double
+_gin_parallel_heapscan(GinBuildState *buildstate, bool *brokenhotchain)
+{
+	GinShared  *ginshared = buildstate->leader->ginshared;
+	int			nparticipanttuplesorts;
+	double		reltuples;
+
+	nparticipanttuplesorts = buildstate->leader->nparticipanttuplesorts;
+	for (;;)
+	{
+		SpinLockAcquire(&ginshared->mutex);
+		if (ginshared->nparticipantsdone == nparticipanttuplesorts)
+		{
+			buildstate->indtuples = ginshared->indtuples;
+			*brokenhotchain = ginshared->brokenhotchain;
+			reltuples = ginshared->reltuples;
+			SpinLockRelease(&ginshared->mutex);
+			break;
+		}
+		SpinLockRelease(&ginshared->mutex);
+
+		ConditionVariableSleep(&ginshared->workersdonecv,
+							   WAIT_EVENT_PARALLEL_CREATE_INDEX_SCAN);
+	}
+
+	ConditionVariableCancelSleep();
+
+	return reltuples;
+}
+
+/*
+ * Within leader, participate as a parallel worker.
+ */
+static void
+_gin_leader_participate_as_worker(GinBuildState *buildstate, Relation heap,
+								  Relation index)
+{
+	GinLeader  *ginleader = buildstate->leader;
+	int			sortmem;
+
+	/*
+	 * Might as well use reliable figure when doling out maintenance_work_mem
+	 * (when requested number of workers were not launched, this will be
+	 * somewhat higher than it is for other workers).
+	 */
+	sortmem = maintenance_work_mem / ginleader->nparticipanttuplesorts;
+
+	/* Perform work common to all participants */
+	_gin_parallel_scan_and_build(buildstate, ginleader->ginshared,
+								 ginleader->sharedsort, heap, index,
+								 sortmem);
+}
+
+/*
+ * Perform a worker's portion of a parallel build.
+ *
+ * Entries are accumulated in buildstate's BuildAccumulator as in a serial
+ * build, but each time it fills up, its contents go into a "partial"
+ * tuplesort instead of the index.  Half of sortmem (in KBs) is used for the
+ * accumulator, and the other half for the tuplesort.
+ *
+ * When this returns, workers are done, and need only release resources.
+ */
+static void
+_gin_parallel_scan_and_build(GinBuildState *buildstate, GinShared *ginshared,
+							 Sharedsort *sharedsort, Relation heap,
+							 Relation index, int sortmem)
+{
+	SortCoordinate coordinate;
+	HeapScanDesc scan;
+	double		reltuples;
+	IndexInfo  *indexInfo;
+
+	/* Initialize local tuplesort coordination state */
+	coordinate = palloc0(sizeof(SortCoordinateData));
+	coordinate->isWorker = true;
+	coordinate->nParticipants = -1;
+	coordinate->sharedsort = sharedsort;
+
+	/* Begin "partial" tuplesort */
+	buildstate->memlimit = (Size) (sortmem / 2) * 1024L;
+	buildstate->sortstate = tuplesort_begin_index_gin(heap, index,
+													  sortmem / 2,
+													  coordinate, false);
+
+	/* Join parallel scan */
+	indexInfo = BuildIndexInfo(index);
+	indexInfo->ii_Concurrent = ginshared->isconcurrent;
+	scan = heap_beginscan_parallel(heap, &ginshared->heapdesc);
+	reltuples = IndexBuildHeapScan(heap, index, indexInfo, true,
+								   ginBuildCallback, (void *) buildstate,
+								   scan);
+
+	/* Dump remaining entries, and execute this worker's part of the sort */
+	ginFlushBuildState(buildstate, index);
+	tuplesort_performsort(buildstate->sortstate);
+
+	/*
+	 * Done.  Record ambuild statistics, and whether we encountered a broken
+	 * HOT chain.
+	 */
+	SpinLockAcquire(&ginshared->mutex);
+	ginshared->nparticipantsdone++;
+	ginshared->reltuples += reltuples;
+	ginshared->indtuples += buildstate->indtuples;
+	if (indexInfo->ii_BrokenHotChain)
+		ginshared->brokenhotchain = true;
+	SpinLockRelease(&ginshared->mutex);
+
+	/* Notify leader */
+	ConditionVariableSignal(&ginshared->workersdonecv);
+
+	/* We can end tuplesort immediately */
+	tuplesort_end(buildstate->sortstate);
+	buildstate->sortstate = NULL;
+}
+
+/*
+ * Perform work within a launched parallel process.
+ */
+void
+_gin_parallel_build_main(dsm_segment *seg, shm_toc *toc)
+{
+	char	   *sharedquery;
+	GinShared  *ginshared;
+	Sharedsort *sharedsort;
+	GinBuildState buildstate;
+	Relation	heapRel;
+	Relation	indexRel;
+	LOCKMODE	heapLockmode;
+	LOCKMODE	indexLockmode;
+	int			sortmem;
+
+	/* Set debug_query_string for individual workers first */
+	sharedquery = shm_toc_lookup(toc, PARALLEL_KEY_QUERY_TEXT, false);
+	debug_query_string = sharedquery;
+
+	/* Report the query string from leader */
+	pgstat_report_activity(STATE_RUNNING, debug_query_string);
+
+	/* Look up gin shared state */
+	ginshared = shm_toc_lookup(toc, PARALLEL_KEY_GIN_SHARED, false);
+
+	/* Open relations using lock modes known to be obtained by index.c */
+	if (!ginshared->isconcurrent)
+	{
+		heapLockmode = ShareLock;
+		indexLockmode = AccessExclusiveLock;
+	}
+	else
+	{
+		heapLockmode = ShareUpdateExclusiveLock;
+		indexLockmode = RowExclusiveLock;
+	}
+
+	/* Open relations within worker */
+	heapRel = heap_open(ginshared->heaprelid, heapLockmode);
+	indexRel = index_open(ginshared->indexrelid, indexLockmode);
+
+	/* Initialize worker's own build state, as ginbuild() does */
+	initGinState(&buildstate.ginstate, indexRel);
+	buildstate.indtuples = 0;
+	memset(&buildstate.buildStats, 0, sizeof(GinStatsData));
+	buildstate.tmpCtx = AllocSetContextCreate(CurrentMemoryContext,
+											  "Gin build temporary context",
+											  ALLOCSET_DEFAULT_SIZES);
+	buildstate.funcCtx = AllocSetContextCreate(CurrentMemoryContext,
+											   "Gin build temporary context for user-defined function",
+											   ALLOCSET_DEFAULT_SIZES);
+	buildstate.accum.ginstate = &buildstate.ginstate;
+	ginInitBA(&buildstate.accum);
+	buildstate.leader = NULL;
+	buildstate.sortstate = NULL;
+
+	/* Look up shared state private to tuplesort.c */
+	sharedsort = shm_toc_lookup(toc, PARALLEL_KEY_TUPLESORT, false);
+	tuplesort_attach_shared(sharedsort, seg);
+
+	/* Perform scan, and sorting of its entries */
+	sortmem = maintenance_work_mem / ginshared->scantuplesortstates;
+	_gin_parallel_scan_and_build(&buildstate, ginshared, sharedsort,
+								 heapRel, indexRel, sortmem);
+
+	MemoryContextDelete(buildstate.funcCtx);
+	MemoryContextDelete(buildstate.tmpCtx);
+
+	index_close(indexRel, indexLockmode);
+	heap_close(heapRel, heapLockmode);
+}
+
+/*
+ * Within leader, merge the sorted entries of all participants into the
+ * index, once the parallel heap scan is complete.
+ *
+ * Participants may each have produced many GinTuples for a key, having
+ * flushed their accumulators several times.  The tuplesort brings them
+ * together, so we can gather all TIDs for the key and insert them with a
+ * single ginEntryInsert() call, at least unless there are too many to keep
+ * in memory.
+ *
+ * Returns the total number of heap tuples scanned.
+ */
+static double
+_gin_parallel_merge(GinBuildState *buildstate, Relation heap, Relation index,
+					bool *brokenhotchain)
+{
+	GinLeader  *ginleader = buildstate->leader;
+	SortCoordinate coordinate;
+	GinBuffer	buffer;
+	GinTuple   *tup;
+	int			maxbuffer;
+	double		reltuples;
+
+	reltuples = _gin_parallel_heapscan(buildstate, brokenhotchain);
+
+	/*
+	 * Take over the runs of all participants, giving the leader's tuplesort
+	 * half of maintenance_work_mem and the TID buffer the other half.
+	 */
+	coordinate = (SortCoordinate) palloc0(sizeof(SortCoordinateData));
+	coordinate->isWorker = false;
+	coordinate->nParticipants = ginleader->nparticipanttuplesorts;
+	coordinate->sharedsort = ginleader->sharedsort;
+
+	buildstate->sortstate = tuplesort_begin_index_gin(heap, index,
+													  maintenance_work_mem / 2,
+													  coordinate, false);
+	pgstat_progress_update_param(PROGRESS_CREATEIDX_SUBPHASE,
+								 PROGRESS_CREATEIDX_SUBPHASE_SORT);
+	tuplesort_performsort(buildstate->sortstate);
+	pgstat_progress_update_param(PROGRESS_CREATEIDX_SUBPHASE,
+								 PROGRESS_CREATEIDX_SUBPHASE_LOAD);
+
+	maxbuffer = Min((Size) (maintenance_work_mem / 2) * 1024L,
+					MaxAllocSize) / sizeof(ItemPointerData);
+
+	memset(&buffer, 0, sizeof(GinBuffer));
+
+	while ((tup = tuplesort_getgintuple(buildstate->sortstate, true)) != NULL)
+	{
+		Datum		key = _gin_parse_tuple_key(tup);
+		MemoryContext oldCtx;
+
+		/* there could be many entries, so be willing to abort here */
+		CHECK_FOR_INTERRUPTS();
+
+		oldCtx = MemoryContextSwitchTo(buildstate->tmpCtx);
+
+		/*
+		 * Insert what we have so far on reaching a new key, or if this
+		 * tuple's TIDs won't fit in the buffer.
+		 */
+		if (buffer.nitems > 0 &&
+			(ginCompareAttEntries(&buildstate->ginstate,
+								  buffer.attnum, buffer.key, buffer.category,
+								  tup->attrnum, key, tup->category) != 0 ||
+			 buffer.nitems + tup->nitems > maxbuffer))
+			_gin_flush_buffer(buildstate, &buffer);
+
+		if (buffer.nitems == 0)
+		{
+			/* tuplesort memory may be reused, so copy the key */
+			buffer.attnum = tup->attrnum;
+			buffer.category = tup->category;
+			if (tup->category == GIN_CAT_NORM_KEY)
+				buffer.key = datumCopy(key, tup->typbyval, tup->typlen);
+			else
+				buffer.key = (Datum) 0;
+			buffer.sorted = true;
+		}
+
+		if (buffer.nitems + tup->nitems > buffer.maxitems)
+		{
+			buffer.maxitems = Max(buffer.maxitems * 2,
+								  buffer.nitems + tup->nitems);
+			buffer.maxitems = Min(buffer.maxitems, Max(maxbuffer, tup->nitems));
+			if (buffer.items == NULL)
+				buffer.items = (ItemPointerData *)
+					palloc(sizeof(ItemPointerData) * buffer.maxitems);
+			else
+				buffer.items = (ItemPointerData *)
+					repalloc(buffer.items,
+							 sizeof(ItemPointerData) * buffer.maxitems);
+		}
+
+		/* TIDs from different participants may interleave */
+		if (buffer.nitems > 0 &&
+			ginCompareItemPointers(&buffer.items[buffer.nitems - 1],
+								   GinTupleGetItems(tup)) > 0)
+			buffer.sorted = false;
+
+		memcpy(&buffer.items[buffer.nitems], GinTupleGetItems(tup),
+			   sizeof(ItemPointerData) * tup->nitems);
+		buffer.nitems += tup->nitems;
+
+		MemoryContextSwitchTo(oldCtx);
+	}
+
+	if (buffer.nitems > 0)
+		_gin_flush_buffer(buildstate, &buffer);
+
+	tuplesort_end(buildstate->sortstate);
+	buildstate->sortstate = NULL;
+
+	return reltuples;
+}
+
+/*
+ * Insert the TIDs gathered for one key into the index, and empty the buffer.
+ */
+static void
+_gin_flush_buffer(GinBuildState *buildstate, GinBuffer *buffer)
+{
+	MemoryContext oldCtx;
+
+	oldCtx = MemoryContextSwitchTo(buildstate->tmpCtx);
+
+	if (!buffer->sorted)
+		qsort(buffer->items, buffer->nitems, sizeof(ItemPointerData),
+			  _gin_compare_items);
+
+	ginEntryInsert(&buildstate->ginstate, buffer->attnum, buffer->key,
+				   buffer->category, buffer->items, buffer->nitems,
+				   &buildstate->buildStats);
+
+	MemoryContextSwitchTo(oldCtx);
+
+	/* The key and buffer space go away here, too */
+	MemoryContextReset(buildstate->tmpCtx);
+	buffer->items = NULL;
+	buffer->nitems = 0;
+	buffer->maxitems = 0;
+}
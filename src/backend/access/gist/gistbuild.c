@@ -27,6 +27,7 @@
 #include "storage/smgr.h"
 #include "utils/memutils.h"
 #include "utils/rel.h"
+#include "utils/tuplesort.h"
 
 /* Step of index tuples for check whether to switch to buffering build mode */
 #define BUFFERING_MODE_SWITCH_CHECK_STEP 256
@@ -49,7 +50,9 @@ typedef enum
 	GIST_BUFFERING_STATS,		/* gathering statistics of index tuple size
 								 * before switching to the buffering build
 								 * mode */
-	GIST_BUFFERING_ACTIVE		/* in buffering build mode */
+	GIST_BUFFERING_ACTIVE,		/* in buffering build mode */
+	GIST_SORTED_BUILD			/* sorting all the tuples, and building the
+								 * tree bottom-up */
 } GistBufferingMode;
 
 /* Working state for gistbuild and its callback */
@@ -72,9 +75,28 @@ typedef struct
 	GISTBuildBuffers *gfbb;
 	HTAB	   *parentMap;
 
+	/*
+	 * Extra data used during a sorted build.  'sortstate' holds the leaf
+	 * tuples being sorted, and 'pages_allocated' is the next block number to
+	 * assign to a finished page.
+	 */
+	Tuplesortstate *sortstate;
+	BlockNumber pages_allocated;
+
 	GistBufferingMode bufferingMode;
 } GISTBuildState;
 
+/*
+ * In a sorted build, the page currently being filled on each level of the
+ * tree.  The pages are kept in local memory and written out directly, one
+ * at a time, as they fill up.
+ */
+typedef struct GistSortedBuildPageState
+{
+	Page		page;
+	struct GistSortedBuildPageState *parent;	/* upper level, if any */
+} GistSortedBuildPageState;
+
 /* prototypes for private functions */
 static void gistInitBuffering(GISTBuildState *buildstate);
 static int	calculatePagesPerBuffer(GISTBuildState *buildstate, int levelStep);
@@ -84,6 +106,20 @@ static void gistBuildCallback(Relation index,
 				  bool *isnull,
 				  bool tupleIsAlive,
 				  void *state);
+static void gistSortedBuildCallback(Relation index,
+						HeapTuple htup,
+						Datum *values,
+						bool *isnull,
+						bool tupleIsAlive,
+						void *state);
+static void gistSortedBuildIndex(GISTBuildState *buildstate);
+static void gistSortedBuildAddTuple(GISTBuildState *buildstate,
+						GistSortedBuildPageState *pagestate,
+						IndexTuple itup);
+static void gistSortedBuildFlushPage(GISTBuildState *buildstate,
+						 GistSortedBuildPageState *pagestate);
+static void gistSortedBuildWritePage(GISTBuildState *buildstate, Page page,
+						 BlockNumber blkno);
 static void gistBufferingBuildInsert(GISTBuildState *buildstate,
 						 IndexTuple itup);
 static bool gistProcessItup(GISTBuildState *buildstate, IndexTuple itup,
@@ -107,9 +143,13 @@ static void gistMemorizeAllDownlinks(GISTBuildState *buildstate, Buffer parent);
 static BlockNumber gistGetParent(GISTBuildState *buildstate, BlockNumber child);
 
 /*
- * Main entry point to GiST index build. Initially calls insert over and over,
- * but switches to more efficient buffering build algorithm after a certain
- * number of tuples (unless buffering mode is disabled).
+ * Main entry point to GiST index build.
+ *
+ * If the opclasses of all the key columns provide a sortsupport function,
+ * and buffering has not been explicitly requested, we sort all the tuples
+ * and pack them into pages bottom-up.  Otherwise, we initially call insert
+ * over and over, but switch to the more efficient buffering build algorithm
+ * after a certain number of tuples (unless buffering mode is disabled).
  */
 IndexBuildResult *
 gistbuild(Relation heap, Relation index, IndexInfo *indexInfo)
@@ -151,6 +191,29 @@ gistbuild(Relation heap, Relation index, IndexInfo *indexInfo)
 	/* Calculate target amount of free space to leave on pages */
 	buildstate.freespace = BLCKSZ * (100 - fillfactor) / 100;
 
+	/*
+	 * Unless buffering was explicitly requested, see if we can sort instead.
+	 * That's only possible if every key column's opclass can order its
+	 * values.
+	 */
+	if (buildstate.bufferingMode != GIST_BUFFERING_STATS)
+	{
+		bool		hasallsortsupports = true;
+		int			i;
+
+		for (i = 0; i < IndexRelationGetNumberOfKeyAttributes(index); i++)
+		{
+			if (!OidIsValid(index_getprocid(index, i + 1,
+											GIST_SORTSUPPORT_PROC)))
+			{
+				hasallsortsupports = false;
+				break;
+			}
+		}
+		if (hasallsortsupports)
+			buildstate.bufferingMode = GIST_SORTED_BUILD;
+	}
+
 	/*
 	 * We expect to be called exactly once for any index relation. If that's
 	 * not the case, big trouble's what we have.
@@ -169,53 +232,77 @@ gistbuild(Relation heap, Relation index, IndexInfo *indexInfo)
 	 */
 	buildstate.giststate->tempCxt = createTempGistContext();
 
-	/* initialize the root page */
-	buffer = gistNewBuffer(index);
-	Assert(BufferGetBlockNumber(buffer) == GIST_ROOT_BLKNO);
-	page = BufferGetPage(buffer);
+	buildstate.indtuples = 0;
+	buildstate.indtuplesSize = 0;
 
-	START_CRIT_SECTION();
+	if (buildstate.bufferingMode == GIST_SORTED_BUILD)
+	{
+		/*
+		 * Sort all the leaf tuples, then build the index pages from them.
+		 */
+		buildstate.sortstate = tuplesort_begin_index_gist(heap,
+														  index,
+														  maintenance_work_mem,
+														  NULL,
+														  false);
 
-	GISTInitBuffer(buffer, F_LEAF);
+		reltuples = IndexBuildHeapScan(heap, index, indexInfo, true,
+									   gistSortedBuildCallback,
+									   (void *) &buildstate, NULL);
 
-	MarkBufferDirty(buffer);
+		tuplesort_performsort(buildstate.sortstate);
 
-	if (RelationNeedsWAL(index))
-	{
-		XLogRecPtr	recptr;
-
-		XLogBeginInsert();
-		XLogRegisterBuffer(0, buffer, REGBUF_WILL_INIT);
+		gistSortedBuildIndex(&buildstate);
 
-		recptr = XLogInsert(RM_GIST_ID, XLOG_GIST_CREATE_INDEX);
-		PageSetLSN(page, recptr);
+		tuplesort_end(buildstate.sortstate);
 	}
 	else
-		PageSetLSN(page, gistGetFakeLSN(heap));
+	{
+		/* initialize the root page */
+		buffer = gistNewBuffer(index);
+		Assert(BufferGetBlockNumber(buffer) == GIST_ROOT_BLKNO);
+		page = BufferGetPage(buffer);
 
-	UnlockReleaseBuffer(buffer);
+		START_CRIT_SECTION();
 
-	END_CRIT_SECTION();
+		GISTInitBuffer(buffer, F_LEAF);
 
-	/* build the index */
-	buildstate.indtuples = 0;
-	buildstate.indtuplesSize = 0;
+		MarkBufferDirty(buffer);
 
-	/*
-	 * Do the heap scan.
-	 */
-	reltuples = IndexBuildHeapScan(heap, index, indexInfo, true,
-								   gistBuildCallback, (void *) &buildstate, NULL);
+		if (RelationNeedsWAL(index))
+		{
+			XLogRecPtr	recptr;
 
-	/*
-	 * If buffering was used, flush out all the tuples that are still in the
-	 * buffers.
-	 */
-	if (buildstate.bufferingMode == GIST_BUFFERING_ACTIVE)
-	{
-		elog(DEBUG1, "all tuples processed, emptying buffers");
-		gistEmptyAllBuffers(&buildstate);
-		gistFreeBuildBuffers(buildstate.gfbb);
+			XLogBeginInsert();
+			XLogRegisterBuffer(0, buffer, REGBUF_WILL_INIT);
+
+			recptr = XLogInsert(RM_GIST_ID, XLOG_GIST_CREATE_INDEX);
+			PageSetLSN(page, recptr);
+		}
+		else
+			PageSetLSN(page, gistGetFakeLSN(heap));
+
+		UnlockReleaseBuffer(buffer);
+
+		END_CRIT_SECTION();
+
+		/*
+		 * Do the heap scan.
+		 */
+		reltuples = IndexBuildHeapScan(heap, index, indexInfo, true,
+									   gistBuildCallback,
+									   (void *) &buildstate, NULL);
+
+		/*
+		 * If buffering was used, flush out all the tuples that are still in
+		 * the buffers.
+		 */
+		if (buildstate.bufferingMode == GIST_BUFFERING_ACTIVE)
+		{
+			elog(DEBUG1, "all tuples processed, emptying buffers");
+			gistEmptyAllBuffers(&buildstate);
+			gistFreeBuildBuffers(buildstate.gfbb);
+		}
 	}
 
 	/* okay, all heap tuples are indexed */
@@ -235,6 +322,212 @@ gistbuild(Relation heap, Relation index, IndexInfo *indexInfo)
 	return result;
 }
 
+/*
+ * Per-tuple callback for IndexBuildHeapScan during a sorted build.
+ */
+static void
+gistSortedBuildCallback(Relation index,
+						HeapTuple htup,
+						Datum *values,
+						bool *isnull,
+						bool tupleIsAlive,
+						void *state)
+{
+	GISTBuildState *buildstate = (GISTBuildState *) state;
+	MemoryContext oldCtx;
+	Datum		compressed_values[INDEX_MAX_KEYS];
+
+	oldCtx = MemoryContextSwitchTo(buildstate->giststate->tempCxt);
+
+	/* Compress the key values, and add the leaf tuple to the sort */
+	gistCompressValues(buildstate->giststate, index,
+					   values, isnull, true, compressed_values);
+
+	tuplesort_putindextuplevalues(buildstate->sortstate,
+								  buildstate->indexrel,
+								  &htup->t_self,
+								  compressed_values, isnull);
+
+	MemoryContextSwitchTo(oldCtx);
+	MemoryContextReset(buildstate->giststate->tempCxt);
+
+	buildstate->indtuples += 1;
+}
+
+/*
+ * Build the index from the sorted leaf tuples.
+ *
+ * The tuples are appended to the current leaf page until it's full.  Each
+ * finished page is written out and its downlink, the union of all the keys
+ * on it, is appended to the current page on the level above in the same
+ * way, adding a level on top whenever the topmost page fills up.  This is
+ * done outside shared buffers, like a B-tree build in nbtsort.c.
+ */
+static void
+gistSortedBuildIndex(GISTBuildState *buildstate)
+{
+	Relation	index = buildstate->indexrel;
+	GistSortedBuildPageState *leafstate;
+	GistSortedBuildPageState *pagestate;
+	IndexTuple	itup;
+	Page		page;
+
+	/*
+	 * The root must be at block 0, but we don't know which page it is until
+	 * all the tuples have been added.  Write a placeholder for it, so that
+	 * the other pages can be appended after it, and overwrite it at the end.
+	 */
+	page = (Page) palloc0(BLCKSZ);
+	RelationOpenSmgr(index);
+	smgrextend(index->rd_smgr, MAIN_FORKNUM, GIST_ROOT_BLKNO,
+			   (char *) page, true);
+	pfree(page);
+	buildstate->pages_allocated = GIST_ROOT_BLKNO + 1;
+
+	leafstate = (GistSortedBuildPageState *)
+		palloc(sizeof(GistSortedBuildPageState));
+	leafstate->page = (Page) palloc(BLCKSZ);
+	leafstate->parent = NULL;
+	gistinitpage(leafstate->page, F_LEAF);
+
+	while ((itup = tuplesort_getindextuple(buildstate->sortstate,
+										   true)) != NULL)
+	{
+		gistSortedBuildAddTuple(buildstate, leafstate, itup);
+		MemoryContextReset(buildstate->giststate->tempCxt);
+	}
+
+	/*
+	 * Write out the partially filled page on each level, from the bottom up.
+	 * The topmost level has a single page, which becomes the root.
+	 */
+	pagestate = leafstate;
+	while (pagestate->parent != NULL)
+	{
+		GistSortedBuildPageState *parent = pagestate->parent;
+
+		gistSortedBuildFlushPage(buildstate, pagestate);
+		pfree(pagestate->page);
+		pfree(pagestate);
+		pagestate = parent;
+	}
+
+	gistSortedBuildWritePage(buildstate, pagestate->page, GIST_ROOT_BLKNO);
+	pfree(pagestate->page);
+	pfree(pagestate);
+
+	/*
+	 * As in nbtsort.c, the pages bypassed shared buffers, so a checkpoint
+	 * that happened during the build didn't flush them.  If they were
+	 * WAL-logged, sync them to disk now, since replay would not start from
+	 * before that checkpoint.
+	 */
+	if (RelationNeedsWAL(index))
+	{
+		RelationOpenSmgr(index);
+		smgrimmedsync(index->rd_smgr, MAIN_FORKNUM);
+	}
+}
+
+/*
+ * Append a tuple to the current page on a level, first writing out the page
+ * if the tuple doesn't fit.
+ */
+static void
+gistSortedBuildAddTuple(GISTBuildState *buildstate,
+						GistSortedBuildPageState *pagestate,
+						IndexTuple itup)
+{
+	if (!gistfitpage(&itup, 1))
+		ereport(ERROR,
+				(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+				 errmsg("index row size %zu exceeds maximum %zu for index \"%s\"",
+						IndexTupleSize(itup), GiSTPageSize,
+						RelationGetRelationName(buildstate->indexrel))));
+
+	if (!PageIsEmpty(pagestate->page) &&
+		gistnospace(pagestate->page, &itup, 1, InvalidOffsetNumber,
+					buildstate->freespace))
+		gistSortedBuildFlushPage(buildstate, pagestate);
+
+	gistfillbuffer(pagestate->page, &itup, 1, InvalidOffsetNumber);
+}
+
+/*
+ * Write out the current page on a level, add its downlink to the level
+ * above, and start a new page on this level.
+ */
+static void
+gistSortedBuildFlushPage(GISTBuildState *buildstate,
+						 GistSortedBuildPageState *pagestate)
+{
+	GISTSTATE  *giststate = buildstate->giststate;
+	IndexTuple *itvec;
+	IndexTuple	downlink;
+	int			vect_len;
+	BlockNumber blkno;
+	bool		isleaf;
+	MemoryContext oldCtx;
+
+	CHECK_FOR_INTERRUPTS();
+
+	blkno = buildstate->pages_allocated++;
+	isleaf = GistPageIsLeaf(pagestate->page);
+
+	/* Form the downlink, covering all the keys on the page */
+	oldCtx = MemoryContextSwitchTo(giststate->tempCxt);
+	itvec = gistextractpage(pagestate->page, &vect_len);
+	downlink = gistunion(buildstate->indexrel, itvec, vect_len, giststate);
+	ItemPointerSetBlockNumber(&(downlink->t_tid), blkno);
+	MemoryContextSwitchTo(oldCtx);
+
+	gistSortedBuildWritePage(buildstate, pagestate->page, blkno);
+	gistinitpage(pagestate->page, isleaf ? F_LEAF : 0);
+
+	/* If this was the topmost level, the new downlink starts a new root */
+	if (pagestate->parent == NULL)
+	{
+		GistSortedBuildPageState *parent;
+
+		parent = (GistSortedBuildPageState *)
+			palloc(sizeof(GistSortedBuildPageState));
+		parent->page = (Page) palloc(BLCKSZ);
+		parent->parent = NULL;
+		gistinitpage(parent->page, 0);
+		pagestate->parent = parent;
+	}
+
+	gistSortedBuildAddTuple(buildstate, pagestate->parent, downlink);
+}
+
+/*
+ * Write a finished page to disk, WAL-logging it if needed.  Pages other than
+ * the root are assigned block numbers in the order they are finished, so
+ * they can simply be appended to the relation.
+ *
+ * Pages must have valid LSNs even if they are not WAL-logged, because GiST
+ * uses them to detect concurrent page splits.
+ */
+static void
+gistSortedBuildWritePage(GISTBuildState *buildstate, Page page,
+						 BlockNumber blkno)
+{
+	Relation	index = buildstate->indexrel;
+
+	if (RelationNeedsWAL(index))
+		log_newpage(&index->rd_node, MAIN_FORKNUM, blkno, page, true);
+	else
+		PageSetLSN(page, gistGetFakeLSN(index));
+
+	PageSetChecksumInplace(page, blkno);
+
+	RelationOpenSmgr(index);
+	if (blkno == GIST_ROOT_BLKNO)
+		smgrwrite(index->rd_smgr, MAIN_FORKNUM, blkno, (char *) page, true);
+	else
+		smgrextend(index->rd_smgr, MAIN_FORKNUM, blkno, (char *) page, true);
+}
+
 /*
  * Validator for "buffering" reloption on GiST indexes. Allows "on", "off"
  * and "auto" values.
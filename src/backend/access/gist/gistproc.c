@@ -24,6 +24,7 @@
 #include "utils/builtins.h"
 #include "utils/float.h"
 #include "utils/geo_decls.h"
+#include "utils/sortsupport.h"
 
 
 static bool gist_box_leaf_consistent(BOX *key, BOX *query,
@@ -31,6 +32,13 @@ static bool gist_box_leaf_consistent(BOX *key, BOX *query,
 static bool rtree_internal_consistent(BOX *key, BOX *query,
 						  StrategyNumber strategy);
 
+static uint64 point_zorder_internal(float8 x, float8 y);
+static uint32 float8_ordered_high_bits(float8 f);
+static uint64 spread_bits32(uint32 x);
+static int	gist_bbox_zorder_cmp(Datum a, Datum b, SortSupport ssup);
+static Datum gist_bbox_zorder_abbrev_convert(Datum original, SortSupport ssup);
+static bool gist_bbox_zorder_abbrev_abort(int memtupcount, SortSupport ssup);
+
 /* Minimum accepted ratio of split */
 #define LIMIT_RATIO 0.3
 
@@ -1207,6 +1215,146 @@ gist_point_fetch(PG_FUNCTION_ARGS)
 	PG_RETURN_POINTER(retval);
 }
 
+/*
+ * Sortsupport for point_ops, used for sorted index builds.
+ *
+ * Points are ordered by their Z-order (Morton code) value, which interleaves
+ * the bits of the X and Y coordinates.  Points that are near each other in
+ * the plane mostly end up near each other in that order, so packing the
+ * sorted points into pages produces reasonably tight bounding boxes.  The
+ * values being sorted are the compressed leaf keys, that is, degenerate
+ * boxes whose corners are both the original point.
+ */
+Datum
+gist_point_sortsupport(PG_FUNCTION_ARGS)
+{
+	SortSupport ssup = (SortSupport) PG_GETARG_POINTER(0);
+
+	if (ssup->abbreviate)
+	{
+		ssup->comparator = ssup_datum_unsigned_cmp;
+		ssup->abbrev_converter = gist_bbox_zorder_abbrev_convert;
+		ssup->abbrev_abort = gist_bbox_zorder_abbrev_abort;
+		ssup->abbrev_full_comparator = gist_bbox_zorder_cmp;
+	}
+	else
+		ssup->comparator = gist_bbox_zorder_cmp;
+
+	PG_RETURN_VOID();
+}
+
+static int
+gist_bbox_zorder_cmp(Datum a, Datum b, SortSupport ssup)
+{
+	Point	   *p1 = &(DatumGetBoxP(a)->low);
+	Point	   *p2 = &(DatumGetBoxP(b)->low);
+	uint64		z1;
+	uint64		z2;
+
+	/* Equal points are common enough to be worth a shortcut */
+	if (p1->x == p2->x && p1->y == p2->y)
+		return 0;
+
+	z1 = point_zorder_internal(p1->x, p1->y);
+	z2 = point_zorder_internal(p2->x, p2->y);
+	if (z1 > z2)
+		return 1;
+	else if (z1 < z2)
+		return -1;
+	else
+		return 0;
+}
+
+/*
+ * The abbreviated key is the Z-order value itself, or as much of it as fits
+ * in a Datum.
+ */
+static Datum
+gist_bbox_zorder_abbrev_convert(Datum original, SortSupport ssup)
+{
+	Point	   *p = &(DatumGetBoxP(original)->low);
+	uint64		z;
+
+	z = point_zorder_internal(p->x, p->y);
+
+#if SIZEOF_DATUM == 8
+	return (Datum) z;
+#else
+	return (Datum) (z >> 32);
+#endif
+}
+
+/*
+ * There is no cheaper comparison to fall back to, so never abort.
+ */
+static bool
+gist_bbox_zorder_abbrev_abort(int memtupcount, SortSupport ssup)
+{
+	return false;
+}
+
+/*
+ * Compute the Z-order value of a point from the high 32 bits of each
+ * coordinate, mapped to unsigned integers that sort in the same order as
+ * the floats do.
+ */
+static uint64
+point_zorder_internal(float8 x, float8 y)
+{
+	return spread_bits32(float8_ordered_high_bits(x)) |
+		(spread_bits32(float8_ordered_high_bits(y)) << 1);
+}
+
+/*
+ * Map an IEEE double to the high 32 bits of an unsigned integer with the
+ * same ordering.  Taking the bit pattern as an integer preserves the order
+ * of non-negative values; negative values have the sign bit set and sort
+ * backwards, so they are inverted, while non-negative ones get the sign
+ * bit set to sort after them.  Both zeroes map to the same value, as do all
+ * NaNs, which sort last as they do in float8 comparisons.
+ */
+static uint32
+float8_ordered_high_bits(float8 f)
+{
+	union
+	{
+		float8		f;
+		uint64		i;
+	}			u;
+
+	if (isnan(f))
+		return PG_UINT32_MAX;
+
+	if (f == 0.0)
+		f = 0.0;				/* fold -0 into +0 */
+	u.f = f;
+
+	if ((u.i & UINT64CONST(0x8000000000000000)) != 0)
+		u.i = ~u.i;
+	else
+		u.i |= UINT64CONST(0x8000000000000000);
+
+	return (uint32) (u.i >> 32);
+}
+
+/*
+ * Spread the bits of a 32-bit integer out to the even bit positions of a
+ * 64-bit integer.
+ */
+static uint64
+spread_bits32(uint32 x)
+{
+	uint64		n = x;
+
+	n = (n | (n << 16)) & UINT64CONST(0x0000FFFF0000FFFF);
+	n = (n | (n << 8)) & UINT64CONST(0x00FF00FF00FF00FF);
+	n = (n | (n << 4)) & UINT64CONST(0x0F0F0F0F0F0F0F0F);
+	n = (n | (n << 2)) & UINT64CONST(0x3333333333333333);
+	n = (n | (n << 1)) & UINT64CONST(0x5555555555555555);
+
+	return n;
+}
+
 
 #define point_point_distance(p1,p2) \
 	DatumGetFloat8(DirectFunctionCall2(point_distance, \
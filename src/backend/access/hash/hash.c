@@ -71,6 +71,7 @@ hashhandler(PG_FUNCTION_ARGS)
 	amroutine->ampredlocks = true;
 	amroutine->amcanparallel = false;
 	amroutine->amcaninclude = false;
+	amroutine->amsummarizing = false;
 	amroutine->amkeytype = INT4OID;
 
 	amroutine->ambuild = hashbuild;
@@ -149,18 +150,32 @@ hashbuild(Relation heap, Relation index, IndexInfo *indexInfo)
 	else
 		sort_threshold = Min(sort_threshold, NLocBuffer);
 
-	if (num_buckets >= (uint32) sort_threshold)
-		buildstate.spool = _h_spoolinit(heap, index, num_buckets);
-	else
-		buildstate.spool = NULL;
-
 	/* prepare to build the index */
+	buildstate.spool = NULL;
 	buildstate.indtuples = 0;
 	buildstate.heapRel = heap;
 
-	/* do the heap scan */
-	reltuples = IndexBuildHeapScan(heap, index, indexInfo, true,
-								   hashbuildCallback, (void *) &buildstate, NULL);
+	/*
+	 * Attempt a parallel build when requested.  A parallel build always
+	 * sorts, whatever the index size, since only the leader may insert into
+	 * the index; the participants just hash and sort their share of the
+	 * heap.  If no workers could be launched, fall back to a serial build.
+	 */
+	if (indexInfo->ii_ParallelWorkers > 0)
+		buildstate.spool = _h_parallel_spoolinit(heap, index, indexInfo,
+												 num_buckets, &reltuples,
+												 &buildstate.indtuples);
+
+	if (buildstate.spool == NULL)
+	{
+		if (num_buckets >= (uint32) sort_threshold)
+			buildstate.spool = _h_spoolinit(heap, index, num_buckets);
+
+		/* do the heap scan */
+		reltuples = IndexBuildHeapScan(heap, index, indexInfo, true,
+									   hashbuildCallback, (void *) &buildstate,
+									   NULL);
+	}
 
 	if (buildstate.spool)
 	{
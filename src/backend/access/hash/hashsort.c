@@ -13,6 +13,14 @@
  * hash code value.  That's no big problem though, since we'll still have
  * plenty of locality of access.
  *
+ * A build may also be done in parallel, along the lines of a parallel
+ * B-tree build (see nbtsort.c).  Each participant joins a parallel heap
+ * scan and sorts its share of the tuples by bucket number in a "partial"
+ * tuplesort; the leader then merges all participants' runs and inserts the
+ * tuples into the index in bucket order, just as a serial spooled build
+ * does.  Computing the hash codes and sorting are thus spread over several
+ * processes, while the index itself is only ever written by the leader.
+ *
  *
  * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
  * Portions Copyright (c) 1994, Regents of the University of California
@@ -26,9 +34,118 @@
 #include "postgres.h"
 
 #include "access/hash.h"
+#include "access/parallel.h"
+#include "access/relscan.h"
+#include "access/xact.h"
+#include "catalog/index.h"
 #include "miscadmin.h"
+#include "pgstat.h"
+#include "storage/condition_variable.h"
+#include "storage/spin.h"
+#include "tcop/tcopprot.h"		/* pgrminclude ignore */
+#include "utils/rel.h"
+#include "utils/snapmgr.h"
 #include "utils/tuplesort.h"
 
+/* Magic numbers for parallel state sharing */
+#define PARALLEL_KEY_HASH_SHARED		UINT64CONST(0xC000000000000001)
+#define PARALLEL_KEY_TUPLESORT			UINT64CONST(0xC000000000000002)
+#define PARALLEL_KEY_QUERY_TEXT			UINT64CONST(0xC000000000000003)
+
+/*
+ * DISABLE_LEADER_PARTICIPATION disables the leader's participation in
+ * parallel index builds.  This may be useful as a debugging aid.
+#undef DISABLE_LEADER_PARTICIPATION
+ */
+
+/*
+ * Status for a parallel hash index build, shared by the leader and all
+ * workers.  See the similar BTShared in nbtsort.c.
+ */
+typedef struct HashShared
+{
+	/*
+	 * These fields are not modified during the build.  They primarily exist
+	 * for the benefit of worker processes that need to create state
+	 * corresponding to that used by the leader.
+	 *
+	 * num_buckets is the number of buckets _hash_init() created; every
+	 * participant must sort using the same bucket masks.
+	 */
+	Oid			heaprelid;
+	Oid			indexrelid;
+	bool		isconcurrent;
+	int			scantuplesortstates;
+	uint32		num_buckets;
+
+	/*
+	 * workersdonecv is used to monitor the progress of workers.  All parallel
+	 * participants must indicate that they are done before leader can use
+	 * mutable state that workers maintain during scan (and before leader can
+	 * proceed to tuplesort_performsort()).
+	 */
+	ConditionVariable workersdonecv;
+
+	/*
+	 * mutex protects all fields before heapdesc.
+	 */
+	slock_t		mutex;
+
+	/*
+	 * Mutable state that is maintained by workers, and reported back to
+	 * leader at end of parallel scan.
+	 *
+	 * nparticipantsdone is number of worker processes finished.
+	 *
+	 * reltuples is the total number of input heap tuples.
+	 *
+	 * indtuples is the total number of tuples that made it into the index.
+	 *
+	 * brokenhotchain indicates if any worker detected a broken HOT chain
+	 * during build.
+	 */
+	int			nparticipantsdone;
+	double		reltuples;
+	double		indtuples;
+	bool		brokenhotchain;
+
+	/*
+	 * This variable-sized field must come last.
+	 *
+	 * See _h_parallel_estimate_shared().
+	 */
+	ParallelHeapScanDescData heapdesc;
+} HashShared;
+
+/*
+ * Status for leader in parallel index build.
+ */
+typedef struct HashLeader
+{
+	/* parallel context itself */
+	ParallelContext *pcxt;
+
+	/*
+	 * nparticipanttuplesorts is the exact number of worker processes
+	 * successfully launched, plus one leader process if it participates as a
+	 * worker (only DISABLE_LEADER_PARTICIPATION builds avoid leader
+	 * participating as a worker).
+	 */
+	int			nparticipanttuplesorts;
+
+	/*
+	 * Leader process convenience pointers to shared state (leader avoids TOC
+	 * lookups).
+	 *
+	 * hashshared is the shared state for entire build.  sharedsort is the
+	 * shared, tuplesort-managed state passed to each process tuplesort.
+	 * snapshot is the snapshot used by the scan iff an MVCC snapshot is
+	 * required.
+	 */
+	HashShared *hashshared;
+	Sharedsort *sharedsort;
+	Snapshot	snapshot;
+} HashLeader;
 
 /*
  * Status record for spooling/sorting phase.
@@ -46,8 +163,49 @@ struct HSpool
 	uint32		high_mask;
 	uint32		low_mask;
 	uint32		max_buckets;
+
+	/* set only in the leader of a parallel build */
+	HashLeader *leader;
 };
 
+/* Working state for a participant's share of a parallel heap scan */
+typedef struct HashWorkerState
+{
+	HSpool	   *spool;
+	double		indtuples;		/* # tuples spooled by this participant */
+} HashWorkerState;
+
+static void _h_spool_setmasks(HSpool *hspool, uint32 num_buckets);
+static HashLeader *_h_begin_parallel(Relation heap, Relation index,
+				  bool isconcurrent, int request,
+				  uint32 num_buckets);
+static void _h_end_parallel(HashLeader *hashleader);
+static Size _h_parallel_estimate_shared(Snapshot snapshot);
+static double _h_parallel_heapscan(HashLeader *hashleader,
+					 double *indtuples, bool *brokenhotchain);
+static void _h_parallel_scan_and_sort(HashShared *hashshared,
+						  Sharedsort *sharedsort, Relation heap,
+						  Relation index, int sortmem);
+static void _h_parallel_build_callback(Relation index, HeapTuple htup,
+						   Datum *values, bool *isnull,
+						   bool tupleIsAlive, void *state);
+
+
+/*
+ * Determine the bitmask for hash code values.  Since there are currently
+ * num_buckets buckets in the index, the appropriate mask can be computed
+ * as follows.
+ *
+ * NOTE : This hash mask calculation should be in sync with similar
+ * calculation in _hash_init_metabuffer.
+ */
+static void
+_h_spool_setmasks(HSpool *hspool, uint32 num_buckets)
+{
+	hspool->high_mask = (((uint32) 1) << _hash_log2(num_buckets + 1)) - 1;
+	hspool->low_mask = (hspool->high_mask >> 1);
+	hspool->max_buckets = num_buckets - 1;
+}
 
 /*
  * create and initialize a spool structure
@@ -58,18 +216,7 @@ _h_spoolinit(Relation heap, Relation index, uint32 num_buckets)
 	HSpool	   *hspool = (HSpool *) palloc0(sizeof(HSpool));
 
 	hspool->index = index;
-
-	/*
-	 * Determine the bitmask for hash code values.  Since there are currently
-	 * num_buckets buckets in the index, the appropriate mask can be computed
-	 * as follows.
-	 *
-	 * NOTE : This hash mask calculation should be in sync with similar
-	 * calculation in _hash_init_metabuffer.
-	 */
-	hspool->high_mask = (((uint32) 1) << _hash_log2(num_buckets + 1)) - 1;
-	hspool->low_mask = (hspool->high_mask >> 1);
-	hspool->max_buckets = num_buckets - 1;
+	_h_spool_setmasks(hspool, num_buckets);
 
 	/*
 	 * We size the sort area as maintenance_work_mem rather than work_mem to
@@ -95,6 +242,8 @@ void
 _h_spooldestroy(HSpool *hspool)
 {
 	tuplesort_end(hspool->sortstate);
+	if (hspool->leader)
+		_h_end_parallel(hspool->leader);
 	pfree(hspool);
 }
 
@@ -143,3 +292,433 @@ _h_indexbuild(HSpool *hspool, Relation heapRel)
 		_hash_doinsert(hspool->index, itup, heapRel);
 	}
 }
+
+/*
+ * Create a spool for a parallel build, and fill it by having the leader and
+ * up to indexInfo->ii_ParallelWorkers workers scan the heap together.
+ *
+ * Returns NULL if not even a single worker process could be launched, in
+ * which case the caller should proceed with a serial build.  Otherwise the
+ * heap scan is complete on return: *reltuples and *indtuples are set, and
+ * the spool is ready to be passed to _h_indexbuild().  _h_spooldestroy()
+ * shuts down parallel mode, so it must be called at the very end of the
+ * index build.
+ */
+HSpool *
+_h_parallel_spoolinit(Relation heap, Relation index,
+					  struct IndexInfo *indexInfo, uint32 num_buckets,
+					  double *reltuples, double *indtuples)
+{
+	HashLeader *hashleader;
+	HSpool	   *hspool;
+	SortCoordinate coordinate;
+
+	Assert(indexInfo->ii_ParallelWorkers > 0);
+
+	hashleader = _h_begin_parallel(heap, index, indexInfo->ii_Concurrent,
+								   indexInfo->ii_ParallelWorkers,
+								   num_buckets);
+	if (hashleader == NULL)
+		return NULL;
+
+	/* Wait for the participants to finish their share of the scan */
+	*reltuples = _h_parallel_heapscan(hashleader, indtuples,
+									  &indexInfo->ii_BrokenHotChain);
+
+	/*
+	 * Set up the leader's tuplesort, which merges the runs of all
+	 * participants.  Having done no sorting of its own, the leader can use
+	 * all of maintenance_work_mem for the merge.
+	 */
+	hspool = (HSpool *) palloc0(sizeof(HSpool));
+	hspool->index = index;
+	hspool->leader = hashleader;
+	_h_spool_setmasks(hspool, num_buckets);
+
+	coordinate = (SortCoordinate) palloc0(sizeof(SortCoordinateData));
+	coordinate->isWorker = false;
+	coordinate->nParticipants = hashleader->nparticipanttuplesorts;
+	coordinate->sharedsort = hashleader->sharedsort;
+
+	hspool->sortstate = tuplesort_begin_index_hash(heap,
+												   index,
+												   hspool->high_mask,
+												   hspool->low_mask,
+												   hspool->max_buckets,
+												   maintenance_work_mem,
+												   coordinate,
+												   false);
+
+	return hspool;
+}
+
+/*
+ * Create parallel context, and launch workers for leader.
+ *
+ * isconcurrent indicates if operation is CREATE INDEX CONCURRENTLY.
+ *
+ * request is the target number of parallel worker processes to launch.
+ *
+ * Returns the HashLeader, which must eventually be passed to
+ * _h_end_parallel(), once the leader has joined the heap scan itself
+ * (unless DISABLE_LEADER_PARTICIPATION is defined).  If not even a single
+ * worker process can be launched, returns NULL.
+ */
+static HashLeader *
+_h_begin_parallel(Relation heap, Relation index, bool isconcurrent,
+				  int request, uint32 num_buckets)
+{
+	ParallelContext *pcxt;
+	int			scantuplesortstates;
+	Snapshot	snapshot;
+	Size		esthashshared;
+	Size		estsort;
+	HashShared *hashshared;
+	Sharedsort *sharedsort;
+	HashLeader *hashleader = (HashLeader *) palloc0(sizeof(HashLeader));
+	bool		leaderparticipates = true;
+	char	   *sharedquery;
+	int			querylen;
+
+#ifdef DISABLE_LEADER_PARTICIPATION
+	leaderparticipates = false;
+#endif
+
+	/*
+	 * Enter parallel mode, and create context for parallel build of hash
+	 * index
+	 */
+	EnterParallelMode();
+	Assert(request > 0);
+	pcxt = CreateParallelContext("postgres", "_h_parallel_build_main",
+								 request, true);
+	scantuplesortstates = leaderparticipates ? request + 1 : request;
+
+	/*
+	 * Prepare for scan of the base relation.  In a normal index build, we use
+	 * SnapshotAny because we must retrieve all tuples and do our own time
+	 * qual checks (because we have to index RECENTLY_DEAD tuples).  In a
+	 * concurrent build, we take a regular MVCC snapshot and index whatever's
+	 * live according to that.
+	 */
+	if (!isconcurrent)
+		snapshot = SnapshotAny;
+	else
+		snapshot = RegisterSnapshot(GetTransactionSnapshot());
+
+	/*
+	 * Estimate size for our own PARALLEL_KEY_HASH_SHARED workspace, and
+	 * PARALLEL_KEY_TUPLESORT tuplesort workspace
+	 */
+	esthashshared = _h_parallel_estimate_shared(snapshot);
+	shm_toc_estimate_chunk(&pcxt->estimator, esthashshared);
+	estsort = tuplesort_estimate_shared(scantuplesortstates);
+	shm_toc_estimate_chunk(&pcxt->estimator, estsort);
+	shm_toc_estimate_keys(&pcxt->estimator, 2);
+
+	/* Finally, estimate PARALLEL_KEY_QUERY_TEXT space */
+	querylen = strlen(debug_query_string);
+	shm_toc_estimate_chunk(&pcxt->estimator, querylen + 1);
+	shm_toc_estimate_keys(&pcxt->estimator, 1);
+
+	/* Everyone's had a chance to ask for space, so now create the DSM */
+	InitializeParallelDSM(pcxt);
+
+	/* Store shared build state, for which we reserved space */
+	hashshared = (HashShared *) shm_toc_allocate(pcxt->toc, esthashshared);
+	/* Initialize immutable state */
+	hashshared->heaprelid = RelationGetRelid(heap);
+	hashshared->indexrelid = RelationGetRelid(index);
+	hashshared->isconcurrent = isconcurrent;
+	hashshared->scantuplesortstates = scantuplesortstates;
+	hashshared->num_buckets = num_buckets;
+	ConditionVariableInit(&hashshared->workersdonecv);
+	SpinLockInit(&hashshared->mutex);
+	/* Initialize mutable state */
+	hashshared->nparticipantsdone = 0;
+	hashshared->reltuples = 0.0;
+	hashshared->indtuples = 0.0;
+	hashshared->brokenhotchain = false;
+	heap_parallelscan_initialize(&hashshared->heapdesc, heap, snapshot);
+
+	/*
+	 * Store shared tuplesort-private state, for which we reserved space.
+	 * Then, initialize opaque state using tuplesort routine.
+	 */
+	sharedsort = (Sharedsort *) shm_toc_allocate(pcxt->toc, estsort);
+	tuplesort_initialize_shared(sharedsort, scantuplesortstates,
+								pcxt->seg);
+
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_HASH_SHARED, hashshared);
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_TUPLESORT, sharedsort);
+
+	/* Store query string for workers */
+	sharedquery = (char *) shm_toc_allocate(pcxt->toc, querylen + 1);
+	memcpy(sharedquery, debug_query_string, querylen + 1);
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_QUERY_TEXT, sharedquery);
+
+	/* Launch workers, saving status for leader/caller */
+	LaunchParallelWorkers(pcxt);
+	hashleader->pcxt = pcxt;
+	hashleader->nparticipanttuplesorts = pcxt->nworkers_launched;
+	if (leaderparticipates)
+		hashleader->nparticipanttuplesorts++;
+	hashleader->hashshared = hashshared;
+	hashleader->sharedsort = sharedsort;
+	hashleader->snapshot = snapshot;
+
+	/* If no workers were successfully launched, back out (do serial build) */
+	if (pcxt->nworkers_launched == 0)
+	{
+		_h_end_parallel(hashleader);
+		return NULL;
+	}
+
+	/*
+	 * Join heap scan ourselves.  Might as well use reliable figure when
+	 * doling out maintenance_work_mem (when requested number of workers were
+	 * not launched, this will be somewhat higher than it is for other
+	 * workers).
+	 */
+	if (leaderparticipates)
+		_h_parallel_scan_and_sort(hashshared, sharedsort, heap, index,
+								  maintenance_work_mem /
+								  hashleader->nparticipanttuplesorts);
+
+	/*
+	 * Caller needs to wait for all launched workers when we return.  Make
+	 * sure that the failure-to-start case will not hang forever.
+	 */
+	WaitForParallelWorkersToAttach(pcxt);
+
+	return hashleader;
+}
+
+/*
+ * Shut down workers, destroy parallel context, and end parallel mode.
+ */
+static void
+_h_end_parallel(HashLeader *hashleader)
+{
+	/* Shutdown worker processes */
+	WaitForParallelWorkersToFinish(hashleader->pcxt);
+	/* Free last reference to MVCC snapshot, if one was used */
+	if (IsMVCCSnapshot(hashleader->snapshot))
+		UnregisterSnapshot(hashleader->snapshot);
+	DestroyParallelContext(hashleader->pcxt);
+	ExitParallelMode();
+}
+
+/*
+ * Returns size of shared memory required to store state for a parallel
+ * hash index build based on the snapshot its parallel scan will use.
+ */
+static Size
+_h_parallel_estimate_shared(Snapshot snapshot)
+{
+	if (!IsMVCCSnapshot(snapshot))
+	{
+		Assert(snapshot == SnapshotAny);
+		return sizeof(HashShared);
+	}
+
+	return add_size(offsetof(HashShared, heapdesc) +
+					offsetof(ParallelHeapScanDescData, phs_snapshot_data),
+					EstimateSnapshotSpace(snapshot));
+}
+
+/*
+ * Within leader, wait for end of heap scan.
+ *
+ * When called, parallel heap scan started by _h_begin_parallel() will
+ * already be underway within worker processes (when leader participates
+ * as a worker, we should end up here just as workers are finishing).
+ *
+ * Fills in *indtuples for ambuild statistics, and sets *brokenhotchain if
+ * some worker encountered a broken HOT chain.
+ *
+ * Returns the total number of heap tuples scanned.
+ */
+static double
+_h_parallel_heapscan(HashLeader *hashleader, double *indtuples,
+					 bool *brokenhotchain)
+{
+	HashShared *hashshared = hashleader->hashshared;
+	double		reltuples;
+
+	for (;;)
+	{
+		SpinLockAcquire(&hashshared->mutex);
+		if (hashshared->nparticipantsdone ==
+			hashleader->nparticipanttuplesorts)
+		{
+			*indtuples = hashshared->indtuples;
+			if (hashshared->brokenhotchain)
+				*brokenhotchain = true;
+			reltuples = hashshared->reltuples;
+			SpinLockRelease(&hashshared->mutex);
+			break;
+		}
+		SpinLockRelease(&hashshared->mutex);
+
+		ConditionVariableSleep(&hashshared->workersdonecv,
+							   WAIT_EVENT_PARALLEL_CREATE_INDEX_SCAN);
+	}
+
+	ConditionVariableCancelSleep();
+
+	return reltuples;
+}
+
+/*
+ * Perform a worker's portion of a parallel build.
+ *
+ * The tuples this participant receives from the parallel heap scan are
+ * sorted by bucket number in a "partial" tuplesort, using sortmem KBs.
+ *
+ * When this returns, workers are done, and need only release resources.
+ */
+static void
+_h_parallel_scan_and_sort(HashShared *hashshared, Sharedsort *sharedsort,
+						  Relation heap, Relation index, int sortmem)
+{
+	HashWorkerState wstate;
+	HSpool	   *hspool;
+	SortCoordinate coordinate;
+	HeapScanDesc scan;
+	double		reltuples;
+	IndexInfo  *indexInfo;
+
+	/* Initialize local tuplesort coordination state */
+	coordinate = palloc0(sizeof(SortCoordinateData));
+	coordinate->isWorker = true;
+	coordinate->nParticipants = -1;
+	coordinate->sharedsort = sharedsort;
+
+	/* Begin "partial" tuplesort */
+	hspool = (HSpool *) palloc0(sizeof(HSpool));
+	hspool->index = index;
+	_h_spool_setmasks(hspool, hashshared->num_buckets);
+	hspool->sortstate = tuplesort_begin_index_hash(heap,
+												   index,
+												   hspool->high_mask,
+												   hspool->low_mask,
+												   hspool->max_buckets,
+												   sortmem,
+												   coordinate,
+												   false);
+
+	wstate.spool = hspool;
+	wstate.indtuples = 0;
+
+	/* Join parallel scan */
+	indexInfo = BuildIndexInfo(index);
+	indexInfo->ii_Concurrent = hashshared->isconcurrent;
+	scan = heap_beginscan_parallel(heap, &hashshared->heapdesc);
+	reltuples = IndexBuildHeapScan(heap, index, indexInfo, true,
+								   _h_parallel_build_callback,
+								   (void *) &wstate, scan);
+
+	/* Execute this worker's part of the sort */
+	tuplesort_performsort(hspool->sortstate);
+
+	/*
+	 * Done.  Record ambuild statistics, and whether we encountered a broken
+	 * HOT chain.
+	 */
+	SpinLockAcquire(&hashshared->mutex);
+	hashshared->nparticipantsdone++;
+	hashshared->reltuples += reltuples;
+	hashshared->indtuples += wstate.indtuples;
+	if (indexInfo->ii_BrokenHotChain)
+		hashshared->brokenhotchain = true;
+	SpinLockRelease(&hashshared->mutex);
+
+	/* Notify leader */
+	ConditionVariableSignal(&hashshared->workersdonecv);
+
+	/* We can end tuplesort immediately */
+	_h_spooldestroy(hspool);
+}
+
+/*
+ * Per-tuple callback from IndexBuildHeapScan, for participants in a
+ * parallel build.  This is hashbuildCallback() without the direct-insertion
+ * case, since only the leader writes to the index.
+ */
+static void
+_h_parallel_build_callback(Relation index,
+						   HeapTuple htup,
+						   Datum *values,
+						   bool *isnull,
+						   bool tupleIsAlive,
+						   void *state)
+{
+	HashWorkerState *wstate = (HashWorkerState *) state;
+	Datum		index_values[1];
+	bool		index_isnull[1];
+
+	/* convert data to a hash key; on failure, do not insert anything */
+	if (!_hash_convert_tuple(index,
+							 values, isnull,
+							 index_values, index_isnull))
+		return;
+
+	_h_spool(wstate->spool, &htup->t_self, index_values, index_isnull);
+
+	wstate->indtuples += 1;
+}
+
+/*
+ * Perform work within a launched parallel process.
+ */
+void
+_h_parallel_build_main(dsm_segment *seg, shm_toc *toc)
+{
+	char	   *sharedquery;
+	HashShared *hashshared;
+	Sharedsort *sharedsort;
+	Relation	heapRel;
+	Relation	indexRel;
+	LOCKMODE	heapLockmode;
+	LOCKMODE	indexLockmode;
+	int			sortmem;
+
+	/* Set debug_query_string for individual workers first */
+	sharedquery = shm_toc_lookup(toc, PARALLEL_KEY_QUERY_TEXT, false);
+	debug_query_string = sharedquery;
+
+	/* Report the query string from leader */
+	pgstat_report_activity(STATE_RUNNING, debug_query_string);
+
+	/* Look up hash shared state */
+	hashshared = shm_toc_lookup(toc, PARALLEL_KEY_HASH_SHARED, false);
+
+	/* Open relations using lock modes known to be obtained by index.c */
+	if (!hashshared->isconcurrent)
+	{
+		heapLockmode = ShareLock;
+		indexLockmode = AccessExclusiveLock;
+	}
+	else
+	{
+		heapLockmode = ShareUpdateExclusiveLock;
+		indexLockmode = RowExclusiveLock;
+	}
+
+	/* Open relations within worker */
+	heapRel = heap_open(hashshared->heaprelid, heapLockmode);
+	indexRel = index_open(hashshared->indexrelid, indexLockmode);
+
+	/* Look up shared state private to tuplesort.c */
+	sharedsort = shm_toc_lookup(toc, PARALLEL_KEY_TUPLESORT, false);
+	tuplesort_attach_shared(sharedsort, seg);
+
+	/* Perform scan, and sorting of its tuples */
+	sortmem = maintenance_work_mem / hashshared->scantuplesortstates;
+	_h_parallel_scan_and_sort(hashshared, sharedsort, heapRel, indexRel,
+							  sortmem);
+
+	index_close(indexRel, indexLockmode);
+	heap_close(heapRel, heapLockmode);
+}
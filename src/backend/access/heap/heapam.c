@@ -38,6 +38,8 @@
  */
 #include "postgres.h"
 
+#include <math.h>
+
 #include "access/bufmask.h"
 #include "access/heapam.h"
 #include "access/heapam_xlog.h"
@@ -73,6 +75,7 @@
 #include "utils/lsyscache.h"
 #include "utils/relcache.h"
 #include "utils/snapmgr.h"
+#include "utils/spccache.h"
 #include "utils/syscache.h"
 #include "utils/tqual.h"
 #include "utils/memutils.h"
@@ -82,6 +85,13 @@
 /* GUC variable */
 bool		synchronize_seqscans = true;
 
+/*
+ * Unit of sequential read-ahead, in blocks.  Each unit of the effective I/O
+ * concurrency computed by ComputeIoConcurrency() allows this many blocks to
+ * be in flight ahead of a seqscan; see heap_readahead().
+ */
+#define HEAP_READAHEAD_CHUNK	16
+
 
 static HeapScanDesc heap_beginscan_internal(Relation relation,
 						Snapshot snapshot,
@@ -93,6 +103,7 @@ static HeapScanDesc heap_beginscan_internal(Relation relation,
 						bool is_bitmapscan,
 						bool is_samplescan,
 						bool temp_snap);
+static void heap_readahead(HeapScanDesc scan, BlockNumber page, bool start);
 static void heap_parallelscan_startblock_init(HeapScanDesc scan);
 static BlockNumber heap_parallelscan_nextpage(HeapScanDesc scan);
 static HeapTuple heap_prepare_insert(Relation relation, HeapTuple tup,
@@ -236,7 +247,7 @@ initscan(HeapScanDesc scan, ScanKey key, bool keep_startblock)
 	if (scan->rs_parallel != NULL)
 		scan->rs_nblocks = scan->rs_parallel->phs_nblocks;
 	else
-		scan->rs_nblocks = RelationGetNumberOfBlocks(scan->rs_rd);
+		scan->rs_nblocks = RelationGetNumberOfBlocks(scan->rs_base.rs_rd);
 
 	/*
 	 * If the table is large relative to NBuffers, use a bulk-read access
@@ -250,7 +261,7 @@ initscan(HeapScanDesc scan, ScanKey key, bool keep_startblock)
 	 * Note that heap_parallelscan_initialize has a very similar test; if you
 	 * change this, consider changing that one, too.
 	 */
-	if (!RelationUsesLocalBuffers(scan->rs_rd) &&
+	if (!RelationUsesLocalBuffers(scan->rs_base.rs_rd) &&
 		scan->rs_nblocks > NBuffers / 4)
 	{
 		allow_strat = scan->rs_allow_strat;
@@ -289,7 +300,7 @@ initscan(HeapScanDesc scan, ScanKey key, bool keep_startblock)
 	else if (allow_sync && synchronize_seqscans)
 	{
 		scan->rs_syncscan = true;
-		scan->rs_startblock = ss_get_location(scan->rs_rd, scan->rs_nblocks);
+		scan->rs_startblock = ss_get_location(scan->rs_base.rs_rd, scan->rs_nblocks);
 	}
 	else
 	{
@@ -297,6 +308,36 @@ initscan(HeapScanDesc scan, ScanKey key, bool keep_startblock)
 		scan->rs_startblock = 0;
 	}
 
+	/*
+	 * Plain forward seqscans prefetch the blocks they are about to read; see
+	 * heap_readahead.  Bitmap and sample scans visit blocks in an order we
+	 * cannot predict here, and blocks of a parallel scan are handed out one
+	 * at a time, so none of those can benefit.
+	 *
+	 * System catalogs never have a per-tablespace setting worth looking up,
+	 * and looking one up would need catalog scans of its own (which cannot
+	 * work at all in bootstrap mode), so they just use the global setting.
+	 */
+	scan->rs_prefetch_maximum = 0;
+	if (!scan->rs_bitmapscan && !scan->rs_samplescan &&
+		scan->rs_parallel == NULL &&
+		scan->rs_nblocks > HEAP_READAHEAD_CHUNK)
+	{
+		int			io_concurrency;
+		double		maximum;
+
+		if (IsCatalogRelation(scan->rs_base.rs_rd))
+			io_concurrency = effective_io_concurrency;
+		else
+			io_concurrency =
+				get_tablespace_io_concurrency(scan->rs_base.rs_rd->rd_rel->reltablespace);
+		if (ComputeIoConcurrency(io_concurrency, &maximum))
+			scan->rs_prefetch_maximum = rint(maximum) * HEAP_READAHEAD_CHUNK;
+	}
+	scan->rs_prefetch_target = 0;
+	scan->rs_prefetch_next = InvalidBlockNumber;
+	scan->rs_prefetch_remaining = 0;
+
 	scan->rs_numblocks = InvalidBlockNumber;
 	scan->rs_inited = false;
 	scan->rs_ctup.t_data = NULL;
@@ -310,7 +351,7 @@ initscan(HeapScanDesc scan, ScanKey key, bool keep_startblock)
 	 * copy the scan key, if appropriate
 	 */
 	if (key != NULL)
-		memcpy(scan->rs_key, key, scan->rs_nkeys * sizeof(ScanKeyData));
+		memcpy(scan->rs_base.rs_key, key, scan->rs_base.rs_nkeys * sizeof(ScanKeyData));
 
 	/*
 	 * Currently, we don't have a stats counter for bitmap heap scans (but the
@@ -318,7 +359,7 @@ initscan(HeapScanDesc scan, ScanKey key, bool keep_startblock)
 	 * update stats for tuple fetches there)
 	 */
 	if (!scan->rs_bitmapscan && !scan->rs_samplescan)
-		pgstat_count_heap_scan(scan->rs_rd);
+		pgstat_count_heap_scan(scan->rs_base.rs_rd);
 }
 
 /*
@@ -340,6 +381,78 @@ heap_setscanlimits(HeapScanDesc scan, BlockNumber startBlk, BlockNumber numBlks)
 	scan->rs_numblocks = numBlks;
 }
 
+/*
+ * heap_readahead - prefetch blocks ahead of a forward sequential scan
+ *
+ * "page" is the block the scan is about to read.  We keep a window of up to
+ * rs_prefetch_target blocks beyond it requested from the kernel, so that a
+ * scan that misses the buffer cache doesn't wait for every read in turn.
+ * The window is refilled only once it has drained to half its size, which
+ * keeps the requests large and the bookkeeping cost per block negligible;
+ * the target grows from a small initial value so that scans stopped early by
+ * a LIMIT don't read far past the rows they need.
+ *
+ * "start" is true for the first block of a scan.  The blocks still to be
+ * prefetched are counted from there, since a synchronized or range-limited
+ * scan neither starts at block zero nor necessarily ends at rs_nblocks.
+ */
+static void
+heap_readahead(HeapScanDesc scan, BlockNumber page, bool start)
+{
+	BlockNumber lead;
+	BlockNumber nfetch;
+
+	if (scan->rs_prefetch_maximum <= 0)
+		return;
+
+	if (start)
+	{
+		scan->rs_prefetch_next = page + 1;
+		if (scan->rs_prefetch_next >= scan->rs_nblocks)
+			scan->rs_prefetch_next = 0;
+		if (scan->rs_numblocks != InvalidBlockNumber)
+			scan->rs_prefetch_remaining = scan->rs_numblocks - 1;
+		else
+			scan->rs_prefetch_remaining = scan->rs_nblocks - 1;
+		scan->rs_prefetch_target = Min(HEAP_READAHEAD_CHUNK,
+									   scan->rs_prefetch_maximum);
+	}
+
+	if (scan->rs_prefetch_remaining == 0)
+		return;
+
+	/* number of blocks between page and rs_prefetch_next already requested */
+	if (scan->rs_prefetch_next > page)
+		lead = scan->rs_prefetch_next - page - 1;
+	else
+		lead = scan->rs_prefetch_next + scan->rs_nblocks - page - 1;
+
+	if (lead > scan->rs_prefetch_target / 2)
+		return;
+
+	nfetch = Min(scan->rs_prefetch_target - lead,
+				 scan->rs_prefetch_remaining);
+	scan->rs_prefetch_remaining -= nfetch;
+
+	while (nfetch > 0)
+	{
+		/* don't request past the end of the relation; wrap around instead */
+		BlockNumber nrun = Min(nfetch,
+							   scan->rs_nblocks - scan->rs_prefetch_next);
+
+		PrefetchBufferRange(scan->rs_base.rs_rd, MAIN_FORKNUM,
+							scan->rs_prefetch_next, nrun);
+		nfetch -= nrun;
+		scan->rs_prefetch_next += nrun;
+		if (scan->rs_prefetch_next >= scan->rs_nblocks)
+			scan->rs_prefetch_next = 0;
+	}
+
+	if (scan->rs_prefetch_target < scan->rs_prefetch_maximum)
+		scan->rs_prefetch_target = Min(scan->rs_prefetch_target * 2,
+									   scan->rs_prefetch_maximum);
+}
+
 /*
  * heapgetpage - subroutine for heapgettup()
  *
@@ -376,7 +489,7 @@ heapgetpage(HeapScanDesc scan, BlockNumber page)
 	CHECK_FOR_INTERRUPTS();
 
 	/* read page using selected strategy */
-	scan->rs_cbuf = ReadBufferExtended(scan->rs_rd, MAIN_FORKNUM, page,
+	scan->rs_cbuf = ReadBufferExtended(scan->rs_base.rs_rd, MAIN_FORKNUM, page,
 									   RBM_NORMAL, scan->rs_strategy);
 	scan->rs_cblock = page;
 
@@ -384,12 +497,12 @@ heapgetpage(HeapScanDesc scan, BlockNumber page)
 		return;
 
 	buffer = scan->rs_cbuf;
-	snapshot = scan->rs_snapshot;
+	snapshot = scan->rs_base.rs_snapshot;
 
 	/*
 	 * Prune and repair fragmentation for the whole page, if possible.
 	 */
-	heap_page_prune_opt(scan->rs_rd, buffer);
+	heap_page_prune_opt(scan->rs_base.rs_rd, buffer);
 
 	/*
 	 * We must hold share lock on the buffer content while examining tuple
@@ -399,7 +512,7 @@ heapgetpage(HeapScanDesc scan, BlockNumber page)
 	LockBuffer(buffer, BUFFER_LOCK_SHARE);
 
 	dp = BufferGetPage(buffer);
-	TestForOldSnapshot(snapshot, scan->rs_rd, dp);
+	TestForOldSnapshot(snapshot, scan->rs_base.rs_rd, dp);
 	lines = PageGetMaxOffsetNumber(dp);
 	ntup = 0;
 
@@ -434,7 +547,7 @@ heapgetpage(HeapScanDesc scan, BlockNumber page)
 			HeapTupleData loctup;
 			bool		valid;
 
-			loctup.t_tableOid = RelationGetRelid(scan->rs_rd);
+			loctup.t_tableOid = RelationGetRelid(scan->rs_base.rs_rd);
 			loctup.t_data = (HeapTupleHeader) PageGetItem((Page) dp, lpp);
 			loctup.t_len = ItemIdGetLength(lpp);
 			ItemPointerSet(&(loctup.t_self), page, lineoff);
@@ -444,7 +557,7 @@ heapgetpage(HeapScanDesc scan, BlockNumber page)
 			else
 				valid = HeapTupleSatisfiesVisibility(&loctup, snapshot, buffer);
 
-			CheckForSerializableConflictOut(valid, scan->rs_rd, &loctup,
+			CheckForSerializableConflictOut(valid, scan->rs_base.rs_rd, &loctup,
 											buffer, snapshot);
 
 			if (valid)
@@ -488,7 +601,7 @@ heapgettup(HeapScanDesc scan,
 		   ScanKey key)
 {
 	HeapTuple	tuple = &(scan->rs_ctup);
-	Snapshot	snapshot = scan->rs_snapshot;
+	Snapshot	snapshot = scan->rs_base.rs_snapshot;
 	bool		backward = ScanDirectionIsBackward(dir);
 	BlockNumber page;
 	bool		finished;
@@ -529,7 +642,10 @@ heapgettup(HeapScanDesc scan,
 				}
 			}
 			else
+			{
 				page = scan->rs_startblock; /* first page */
+				heap_readahead(scan, page, true);
+			}
 			heapgetpage(scan, page);
 			lineoff = FirstOffsetNumber;	/* first offnum */
 			scan->rs_inited = true;
@@ -545,7 +661,7 @@ heapgettup(HeapScanDesc scan,
 		LockBuffer(scan->rs_cbuf, BUFFER_LOCK_SHARE);
 
 		dp = BufferGetPage(scan->rs_cbuf);
-		TestForOldSnapshot(snapshot, scan->rs_rd, dp);
+		TestForOldSnapshot(snapshot, scan->rs_base.rs_rd, dp);
 		lines = PageGetMaxOffsetNumber(dp);
 		/* page and lineoff now reference the physically next tid */
 
@@ -575,8 +691,13 @@ heapgettup(HeapScanDesc scan,
 			 * forward scanners.
 			 */
 			scan->rs_syncscan = false;
-			/* start from last page of the scan */
-			if (scan->rs_startblock > 0)
+			/*
+			 * Start from last page of the scan.  Ensure we take into account
+			 * rs_numblocks if it's been adjusted by heap_setscanlimits().
+			 */
+			if (scan->rs_numblocks != InvalidBlockNumber)
+				page = (scan->rs_startblock + scan->rs_numblocks - 1) % scan->rs_nblocks;
+			else if (scan->rs_startblock > 0)
 				page = scan->rs_startblock - 1;
 			else
 				page = scan->rs_nblocks - 1;
@@ -591,7 +712,7 @@ heapgettup(HeapScanDesc scan,
 		LockBuffer(scan->rs_cbuf, BUFFER_LOCK_SHARE);
 
 		dp = BufferGetPage(scan->rs_cbuf);
-		TestForOldSnapshot(snapshot, scan->rs_rd, dp);
+		TestForOldSnapshot(snapshot, scan->rs_base.rs_rd, dp);
 		lines = PageGetMaxOffsetNumber(dp);
 
 		if (!scan->rs_inited)
@@ -626,7 +747,7 @@ heapgettup(HeapScanDesc scan,
 
 		/* Since the tuple was previously fetched, needn't lock page here */
 		dp = BufferGetPage(scan->rs_cbuf);
-		TestForOldSnapshot(snapshot, scan->rs_rd, dp);
+		TestForOldSnapshot(snapshot, scan->rs_base.rs_rd, dp);
 		lineoff = ItemPointerGetOffsetNumber(&(tuple->t_self));
 		lpp = PageGetItemId(dp, lineoff);
 		Assert(ItemIdIsNormal(lpp));
@@ -661,11 +782,11 @@ heapgettup(HeapScanDesc scan,
 													 snapshot,
 													 scan->rs_cbuf);
 
-				CheckForSerializableConflictOut(valid, scan->rs_rd, tuple,
+				CheckForSerializableConflictOut(valid, scan->rs_base.rs_rd, tuple,
 												scan->rs_cbuf, snapshot);
 
 				if (valid && key != NULL)
-					HeapKeyTest(tuple, RelationGetDescr(scan->rs_rd),
+					HeapKeyTest(tuple, RelationGetDescr(scan->rs_base.rs_rd),
 								nkeys, key, valid);
 
 				if (valid)
@@ -734,7 +855,7 @@ heapgettup(HeapScanDesc scan,
 			 * We don't guarantee any specific ordering in general, though.
 			 */
 			if (scan->rs_syncscan)
-				ss_report_location(scan->rs_rd, page);
+				ss_report_location(scan->rs_base.rs_rd, page);
 		}
 
 		/*
@@ -751,12 +872,15 @@ heapgettup(HeapScanDesc scan,
 			return;
 		}
 
+		if (!backward && scan->rs_parallel == NULL)
+			heap_readahead(scan, page, false);
+
 		heapgetpage(scan, page);
 
 		LockBuffer(scan->rs_cbuf, BUFFER_LOCK_SHARE);
 
 		dp = BufferGetPage(scan->rs_cbuf);
-		TestForOldSnapshot(snapshot, scan->rs_rd, dp);
+		TestForOldSnapshot(snapshot, scan->rs_base.rs_rd, dp);
 		lines = PageGetMaxOffsetNumber((Page) dp);
 		linesleft = lines;
 		if (backward)
@@ -833,7 +957,10 @@ heapgettup_pagemode(HeapScanDesc scan,
 				}
 			}
 			else
+			{
 				page = scan->rs_startblock; /* first page */
+				heap_readahead(scan, page, true);
+			}
 			heapgetpage(scan, page);
 			lineindex = 0;
 			scan->rs_inited = true;
@@ -846,7 +973,7 @@ heapgettup_pagemode(HeapScanDesc scan,
 		}
 
 		dp = BufferGetPage(scan->rs_cbuf);
-		TestForOldSnapshot(scan->rs_snapshot, scan->rs_rd, dp);
+		TestForOldSnapshot(scan->rs_base.rs_snapshot, scan->rs_base.rs_rd, dp);
 		lines = scan->rs_ntuples;
 		/* page and lineindex now reference the next visible tid */
 
@@ -876,8 +1003,13 @@ heapgettup_pagemode(HeapScanDesc scan,
 			 * forward scanners.
 			 */
 			scan->rs_syncscan = false;
-			/* start from last page of the scan */
-			if (scan->rs_startblock > 0)
+			/*
+			 * Start from last page of the scan.  Ensure we take into account
+			 * rs_numblocks if it's been adjusted by heap_setscanlimits().
+			 */
+			if (scan->rs_numblocks != InvalidBlockNumber)
+				page = (scan->rs_startblock + scan->rs_numblocks - 1) % scan->rs_nblocks;
+			else if (scan->rs_startblock > 0)
 				page = scan->rs_startblock - 1;
 			else
 				page = scan->rs_nblocks - 1;
@@ -890,7 +1022,7 @@ heapgettup_pagemode(HeapScanDesc scan,
 		}
 
 		dp = BufferGetPage(scan->rs_cbuf);
-		TestForOldSnapshot(scan->rs_snapshot, scan->rs_rd, dp);
+		TestForOldSnapshot(scan->rs_base.rs_snapshot, scan->rs_base.rs_rd, dp);
 		lines = scan->rs_ntuples;
 
 		if (!scan->rs_inited)
@@ -924,7 +1056,7 @@ heapgettup_pagemode(HeapScanDesc scan,
 
 		/* Since the tuple was previously fetched, needn't lock page here */
 		dp = BufferGetPage(scan->rs_cbuf);
-		TestForOldSnapshot(scan->rs_snapshot, scan->rs_rd, dp);
+		TestForOldSnapshot(scan->rs_base.rs_snapshot, scan->rs_base.rs_rd, dp);
 		lineoff = ItemPointerGetOffsetNumber(&(tuple->t_self));
 		lpp = PageGetItemId(dp, lineoff);
 		Assert(ItemIdIsNormal(lpp));
@@ -962,7 +1094,7 @@ heapgettup_pagemode(HeapScanDesc scan,
 			{
 				bool		valid;
 
-				HeapKeyTest(tuple, RelationGetDescr(scan->rs_rd),
+				HeapKeyTest(tuple, RelationGetDescr(scan->rs_base.rs_rd),
 							nkeys, key, valid);
 				if (valid)
 				{
@@ -1024,7 +1156,7 @@ heapgettup_pagemode(HeapScanDesc scan,
 			 * We don't guarantee any specific ordering in general, though.
 			 */
 			if (scan->rs_syncscan)
-				ss_report_location(scan->rs_rd, page);
+				ss_report_location(scan->rs_base.rs_rd, page);
 		}
 
 		/*
@@ -1041,10 +1173,13 @@ heapgettup_pagemode(HeapScanDesc scan,
 			return;
 		}
 
+		if (!backward && scan->rs_parallel == NULL)
+			heap_readahead(scan, page, false);
+
 		heapgetpage(scan, page);
 
 		dp = BufferGetPage(scan->rs_cbuf);
-		TestForOldSnapshot(scan->rs_snapshot, scan->rs_rd, dp);
+		TestForOldSnapshot(scan->rs_base.rs_snapshot, scan->rs_base.rs_rd, dp);
 		lines = scan->rs_ntuples;
 		linesleft = lines;
 		if (backward)
@@ -1485,9 +1620,10 @@ heap_beginscan_internal(Relation relation, Snapshot snapshot,
 	 */
 	scan = (HeapScanDesc) palloc(sizeof(HeapScanDescData));
 
-	scan->rs_rd = relation;
-	scan->rs_snapshot = snapshot;
-	scan->rs_nkeys = nkeys;
+	scan->rs_base.rs_rd = relation;
+	scan->rs_base.rs_snapshot = snapshot;
+	scan->rs_base.rs_nkeys = nkeys;
+	scan->rs_base.rs_projcols = NULL;	/* the heap doesn't use it */
 	scan->rs_bitmapscan = is_bitmapscan;
 	scan->rs_samplescan = is_samplescan;
 	scan->rs_strategy = NULL;	/* set in initscan */
@@ -1523,9 +1659,9 @@ heap_beginscan_internal(Relation relation, Snapshot snapshot,
 	 * initscan() and we don't want to allocate memory again
 	 */
 	if (nkeys > 0)
-		scan->rs_key = (ScanKey) palloc(sizeof(ScanKeyData) * nkeys);
+		scan->rs_base.rs_key = (ScanKey) palloc(sizeof(ScanKeyData) * nkeys);
 	else
-		scan->rs_key = NULL;
+		scan->rs_base.rs_key = NULL;
 
 	initscan(scan, key, false);
 
@@ -1568,7 +1704,7 @@ heap_rescan_set_params(HeapScanDesc scan, ScanKey key,
 	/* adjust parameters */
 	scan->rs_allow_strat = allow_strat;
 	scan->rs_allow_sync = allow_sync;
-	scan->rs_pageatatime = allow_pagemode && IsMVCCSnapshot(scan->rs_snapshot);
+	scan->rs_pageatatime = allow_pagemode && IsMVCCSnapshot(scan->rs_base.rs_snapshot);
 	/* ... and rescan */
 	heap_rescan(scan, key);
 }
@@ -1594,16 +1730,16 @@ heap_endscan(HeapScanDesc scan)
 	/*
 	 * decrement relation reference count and free scan descriptor storage
 	 */
-	RelationDecrementReferenceCount(scan->rs_rd);
+	RelationDecrementReferenceCount(scan->rs_base.rs_rd);
 
-	if (scan->rs_key)
-		pfree(scan->rs_key);
+	if (scan->rs_base.rs_key)
+		pfree(scan->rs_base.rs_key);
 
 	if (scan->rs_strategy != NULL)
 		FreeAccessStrategy(scan->rs_strategy);
 
 	if (scan->rs_temp_snap)
-		UnregisterSnapshot(scan->rs_snapshot);
+		UnregisterSnapshot(scan->rs_base.rs_snapshot);
 
 	pfree(scan);
 }
@@ -1738,7 +1874,7 @@ retry:
 		else
 		{
 			SpinLockRelease(&parallel_scan->phs_mutex);
-			sync_startpage = ss_get_location(scan->rs_rd, scan->rs_nblocks);
+			sync_startpage = ss_get_location(scan->rs_base.rs_rd, scan->rs_nblocks);
 			goto retry;
 		}
 	}
@@ -1795,9 +1931,9 @@ heap_parallelscan_nextpage(HeapScanDesc scan)
 	if (scan->rs_syncscan)
 	{
 		if (page != InvalidBlockNumber)
-			ss_report_location(scan->rs_rd, page);
+			ss_report_location(scan->rs_base.rs_rd, page);
 		else if (nallocated == scan->rs_nblocks)
-			ss_report_location(scan->rs_rd, parallel_scan->phs_startblock);
+			ss_report_location(scan->rs_base.rs_rd, parallel_scan->phs_startblock);
 	}
 
 	return page;
@@ -1815,7 +1951,7 @@ heap_update_snapshot(HeapScanDesc scan, Snapshot snapshot)
 	Assert(IsMVCCSnapshot(snapshot));
 
 	RegisterSnapshot(snapshot);
-	scan->rs_snapshot = snapshot;
+	scan->rs_base.rs_snapshot = snapshot;
 	scan->rs_temp_snap = true;
 }
 
@@ -1831,7 +1967,7 @@ heap_update_snapshot(HeapScanDesc scan, Snapshot snapshot)
 #ifdef HEAPDEBUGALL
 #define HEAPDEBUG_1 \
 	elog(DEBUG2, "heap_getnext([%s,nkeys=%d],dir=%d) called", \
-		 RelationGetRelationName(scan->rs_rd), scan->rs_nkeys, (int) direction)
+		 RelationGetRelationName(scan->rs_base.rs_rd), scan->rs_base.rs_nkeys, (int) direction)
 #define HEAPDEBUG_2 \
 	elog(DEBUG2, "heap_getnext returning EOS")
 #define HEAPDEBUG_3 \
@@ -1852,9 +1988,9 @@ heap_getnext(HeapScanDesc scan, ScanDirection direction)
 
 	if (scan->rs_pageatatime)
 		heapgettup_pagemode(scan, direction,
-							scan->rs_nkeys, scan->rs_key);
+							scan->rs_base.rs_nkeys, scan->rs_base.rs_key);
 	else
-		heapgettup(scan, direction, scan->rs_nkeys, scan->rs_key);
+		heapgettup(scan, direction, scan->rs_base.rs_nkeys, scan->rs_base.rs_key);
 
 	if (scan->rs_ctup.t_data == NULL)
 	{
@@ -1868,7 +2004,7 @@ heap_getnext(HeapScanDesc scan, ScanDirection direction)
 	 */
 	HEAPDEBUG_3;				/* heap_getnext returning tuple */
 
-	pgstat_count_heap_getnext(scan->rs_rd);
+	pgstat_count_heap_getnext(scan->rs_base.rs_rd);
 
 	return &(scan->rs_ctup);
 }
@@ -2380,6 +2516,7 @@ GetBulkInsertState(void)
 	bistate = (BulkInsertState) palloc(sizeof(BulkInsertStateData));
 	bistate->strategy = GetAccessStrategy(BAS_BULKWRITE);
 	bistate->current_buf = InvalidBuffer;
+	bistate->nextended = 0;
 	return bistate;
 }
 
@@ -2404,6 +2541,9 @@ ReleaseBulkInsertStatePin(BulkInsertState bistate)
 	if (bistate->current_buf != InvalidBuffer)
 		ReleaseBuffer(bistate->current_buf);
 	bistate->current_buf = InvalidBuffer;
+
+	/* Caller is probably switching to another relation; start over */
+	bistate->nextended = 0;
 }
 
 
@@ -2563,6 +2703,13 @@ heap_insert(Relation relation, HeapTuple tup, CommandId cid,
 			xlrec.flags |= XLH_INSERT_IS_SPECULATIVE;
 		Assert(ItemPointerGetBlockNumber(&heaptup->t_self) == BufferGetBlockNumber(buffer));
 
+		/*
+		 * Let logical decoding know that this is a chunk of a toasted value,
+		 * which isn't complete until the main table's tuple follows.
+		 */
+		if (IsToastRelation(relation))
+			xlrec.flags |= XLH_INSERT_ON_TOAST_RELATION;
+
 		/*
 		 * For logical decoding, we need the tuple even if we're doing a full
 		 * page write, so make sure it's included even if we take a full-page
@@ -3484,6 +3631,8 @@ simple_heap_delete(Relation relation, ItemPointer tid)
  *	wait - true if should wait for any conflicting update to commit/abort
  *	hufd - output parameter, filled in failure cases (see below)
  *	lockmode - output parameter, filled with lock mode acquired on tuple
+ *	update_indexes - output parameter, set to tell which indexes need entries
+ *		for the new tuple (only meaningful on success)
  *
  * Normal, successful return value is HeapTupleMayBeUpdated, which
  * actually means we *did* update it.  Failure return codes are
@@ -3496,6 +3645,12 @@ simple_heap_delete(Relation relation, ItemPointer tid)
  * update was done.  However, any TOAST changes in the new tuple's
  * data are not reflected into *newtup.
  *
+ * A HOT update is possible even if columns used by summarizing indexes
+ * (such as BRIN) changed, since those indexes only describe which values may
+ * appear within a block range, and the new tuple stays on the same block.
+ * *update_indexes is then TU_Summarizing, meaning the caller must insert new
+ * entries into those indexes only.
+ *
  * In the failure cases, the routine fills *hufd with the tuple's t_ctid,
  * t_xmax (resolving a possible MultiXact, if necessary), and t_cmax
  * (the last only for HeapTupleSelfUpdated, since we
@@ -3505,12 +3660,14 @@ simple_heap_delete(Relation relation, ItemPointer tid)
 HTSU_Result
 heap_update(Relation relation, ItemPointer otid, HeapTuple newtup,
 			CommandId cid, Snapshot crosscheck, bool wait,
-			HeapUpdateFailureData *hufd, LockTupleMode *lockmode)
+			HeapUpdateFailureData *hufd, LockTupleMode *lockmode,
+			TU_UpdateIndexes *update_indexes)
 {
 	HTSU_Result result;
 	TransactionId xid = GetCurrentTransactionId();
 	Bitmapset  *hot_attrs;
 	Bitmapset  *proj_idx_attrs;
+	Bitmapset  *sum_attrs;
 	Bitmapset  *key_attrs;
 	Bitmapset  *id_attrs;
 	Bitmapset  *interesting_attrs;
@@ -3533,6 +3690,7 @@ heap_update(Relation relation, ItemPointer otid, HeapTuple newtup,
 	bool		have_tuple_lock = false;
 	bool		iscombo;
 	bool		use_hot_update = false;
+	bool		summarized_update = false;
 	bool		hot_attrs_checked = false;
 	bool		key_intact;
 	bool		all_visible_cleared = false;
@@ -3576,6 +3734,8 @@ heap_update(Relation relation, ItemPointer otid, HeapTuple newtup,
 	 */
 	hot_attrs = RelationGetIndexAttrBitmap(relation, INDEX_ATTR_BITMAP_HOT);
 	proj_idx_attrs = RelationGetIndexAttrBitmap(relation, INDEX_ATTR_BITMAP_PROJ);
+	sum_attrs = RelationGetIndexAttrBitmap(relation,
+										   INDEX_ATTR_BITMAP_SUMMARIZED);
 	key_attrs = RelationGetIndexAttrBitmap(relation, INDEX_ATTR_BITMAP_KEY);
 	id_attrs = RelationGetIndexAttrBitmap(relation,
 										  INDEX_ATTR_BITMAP_IDENTITY_KEY);
@@ -3599,6 +3759,7 @@ heap_update(Relation relation, ItemPointer otid, HeapTuple newtup,
 	{
 		interesting_attrs = bms_add_members(interesting_attrs, hot_attrs);
 		interesting_attrs = bms_add_members(interesting_attrs, proj_idx_attrs);
+		interesting_attrs = bms_add_members(interesting_attrs, sum_attrs);
 		hot_attrs_checked = true;
 	}
 	interesting_attrs = bms_add_members(interesting_attrs, key_attrs);
@@ -3883,10 +4044,12 @@ l2:
 			ReleaseBuffer(vmbuffer);
 		bms_free(hot_attrs);
 		bms_free(proj_idx_attrs);
+		bms_free(sum_attrs);
 		bms_free(key_attrs);
 		bms_free(id_attrs);
 		bms_free(modified_attrs);
 		bms_free(interesting_attrs);
+		*update_indexes = TU_None;
 		return result;
 	}
 
@@ -4201,6 +4364,13 @@ l2:
 				|| ProjIndexIsUnchanged(relation, &oldtup, newtup)))
 		{
 			use_hot_update = true;
+
+			/*
+			 * If columns of summarizing indexes changed, those indexes need
+			 * to learn the new values even though the update is HOT.
+			 */
+			if (bms_overlap(modified_attrs, sum_attrs))
+				summarized_update = true;
 		}
 	}
 	else
@@ -4364,11 +4534,20 @@ l2:
 
 	bms_free(hot_attrs);
 	bms_free(proj_idx_attrs);
+	bms_free(sum_attrs);
 	bms_free(key_attrs);
 	bms_free(id_attrs);
 	bms_free(modified_attrs);
 	bms_free(interesting_attrs);
 
+	/* Tell the caller which indexes need entries for the new tuple */
+	if (!use_hot_update)
+		*update_indexes = TU_All;
+	else if (summarized_update)
+		*update_indexes = TU_Summarizing;
+	else
+		*update_indexes = TU_None;
+
 	return HeapTupleMayBeUpdated;
 }
 
@@ -4565,10 +4744,11 @@ HeapDetermineModifiedColumns(Relation relation, Bitmapset *interesting_cols,
  * This routine may be used to update a tuple when concurrent updates of
  * the target tuple are not expected (for example, because we have a lock
  * on the relation associated with the tuple).  Any failure is reported
- * via ereport().
+ * via ereport().  *update_indexes is set as for heap_update.
  */
 void
-simple_heap_update(Relation relation, ItemPointer otid, HeapTuple tup)
+simple_heap_update(Relation relation, ItemPointer otid, HeapTuple tup,
+				   TU_UpdateIndexes *update_indexes)
 {
 	HTSU_Result result;
 	HeapUpdateFailureData hufd;
@@ -4577,7 +4757,7 @@ simple_heap_update(Relation relation, ItemPointer otid, HeapTuple tup)
 	result = heap_update(relation, otid, tup,
 						 GetCurrentCommandId(true), InvalidSnapshot,
 						 true /* wait for commit */ ,
-						 &hufd, &lockmode);
+						 &hufd, &lockmode, update_indexes);
 	switch (result)
 	{
 		case HeapTupleSelfUpdated:
@@ -6127,7 +6307,7 @@ heap_lock_updated_tuple(Relation rel, HeapTuple tuple, ItemPointer ctid,
  * An explicit confirmation WAL record also makes logical decoding simpler.
  */
 void
-heap_finish_speculative(Relation relation, HeapTuple tuple)
+heap_finish_speculative(Relation relation, ItemPointer tid)
 {
 	Buffer		buffer;
 	Page		page;
@@ -6135,11 +6315,11 @@ heap_finish_speculative(Relation relation, HeapTuple tuple)
 	ItemId		lp = NULL;
 	HeapTupleHeader htup;
 
-	buffer = ReadBuffer(relation, ItemPointerGetBlockNumber(&(tuple->t_self)));
+	buffer = ReadBuffer(relation, ItemPointerGetBlockNumber(tid));
 	LockBuffer(buffer, BUFFER_LOCK_EXCLUSIVE);
 	page = (Page) BufferGetPage(buffer);
 
-	offnum = ItemPointerGetOffsetNumber(&(tuple->t_self));
+	offnum = ItemPointerGetOffsetNumber(tid);
 	if (PageGetMaxOffsetNumber(page) >= offnum)
 		lp = PageGetItemId(page, offnum);
 
@@ -6155,7 +6335,7 @@ heap_finish_speculative(Relation relation, HeapTuple tuple)
 	/* NO EREPORT(ERROR) from here till changes are logged */
 	START_CRIT_SECTION();
 
-	Assert(HeapTupleHeaderIsSpeculative(tuple->t_data));
+	Assert(HeapTupleHeaderIsSpeculative(htup));
 
 	MarkBufferDirty(buffer);
 
@@ -6163,7 +6343,7 @@ heap_finish_speculative(Relation relation, HeapTuple tuple)
 	 * Replace the speculative insertion token with a real t_ctid, pointing to
 	 * itself like it does on regular tuples.
 	 */
-	htup->t_ctid = tuple->t_self;
+	htup->t_ctid = *tid;
 
 	/* XLOG stuff */
 	if (RelationNeedsWAL(relation))
@@ -6171,7 +6351,7 @@ heap_finish_speculative(Relation relation, HeapTuple tuple)
 		xl_heap_confirm xlrec;
 		XLogRecPtr	recptr;
 
-		xlrec.offnum = ItemPointerGetOffsetNumber(&tuple->t_self);
+		xlrec.offnum = ItemPointerGetOffsetNumber(tid);
 
 		XLogBeginInsert();
 
@@ -6218,10 +6398,9 @@ heap_finish_speculative(Relation relation, HeapTuple tuple)
  * confirmation records.
  */
 void
-heap_abort_speculative(Relation relation, HeapTuple tuple)
+heap_abort_speculative(Relation relation, ItemPointer tid)
 {
 	TransactionId xid = GetCurrentTransactionId();
-	ItemPointer tid = &(tuple->t_self);
 	ItemId		lp;
 	HeapTupleData tp;
 	Page		page;
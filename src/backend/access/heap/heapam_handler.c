@@ -0,0 +1,495 @@
+/*-------------------------------------------------------------------------
+ *
+ * heapam_handler.c
+ *	  heap table access method code
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/access/heap/heapam_handler.c
+ *
+ *
+ * NOTES
+ *	  This file wires up the lower level heapam.c et al routines with the
+ *	  tableam abstraction.
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include <math.h>
+
+#include "access/heapam.h"
+#include "access/htup_details.h"
+#include "access/tableam.h"
+#include "commands/vacuum.h"
+#include "optimizer/plancat.h"
+#include "storage/bufmgr.h"
+#include "utils/builtins.h"
+
+
+/* ------------------------------------------------------------------------
+ * Slot related callbacks for heap AM
+ * ------------------------------------------------------------------------
+ */
+
+static const TupleTableSlotOps *
+heapam_slot_callbacks(Relation relation)
+{
+	return &TTSOpsBufferHeapTuple;
+}
+
+
+/* ------------------------------------------------------------------------
+ * Table scan callbacks for heap AM
+ * ------------------------------------------------------------------------
+ */
+
+static TableScanDesc
+heapam_beginscan(Relation relation, Snapshot snapshot,
+				 int nkeys, ScanKey key,
+				 ParallelTableScanDesc pscan)
+{
+	HeapScanDesc scan;
+
+	if (pscan != NULL)
+		scan = heap_beginscan_parallel(relation, (ParallelHeapScanDesc) pscan);
+	else
+		scan = heap_beginscan(relation, snapshot, nkeys, key);
+
+	return (TableScanDesc) scan;
+}
+
+static void
+heapam_endscan(TableScanDesc sscan)
+{
+	heap_endscan((HeapScanDesc) sscan);
+}
+
+static void
+heapam_rescan(TableScanDesc sscan, ScanKey key)
+{
+	heap_rescan((HeapScanDesc) sscan, key);
+}
+
+static bool
+heapam_getnextslot(TableScanDesc sscan, ScanDirection direction,
+				   TupleTableSlot *slot)
+{
+	HeapScanDesc scan = (HeapScanDesc) sscan;
+	HeapTuple	tuple;
+
+	tuple = heap_getnext(scan, direction);
+	if (tuple == NULL)
+	{
+		ExecClearTuple(slot);
+		return false;
+	}
+
+	/*
+	 * The tuple points into the scan's current page; the slot keeps its own
+	 * pin on the buffer for as long as it holds the tuple.
+	 */
+	ExecStoreBufferHeapTuple(tuple, slot, scan->rs_cbuf);
+	return true;
+}
+
+static void
+heapam_set_tidrange(TableScanDesc sscan, ItemPointer mintid,
+					ItemPointer maxtid)
+{
+	HeapScanDesc scan = (HeapScanDesc) sscan;
+	ItemPointerData highestItem;
+	ItemPointerData lowestItem;
+	BlockNumber startBlk;
+	BlockNumber numBlks;
+
+	/*
+	 * Restart the scan without syncscan: its start block has to be the first
+	 * block of the range, not wherever other scans of the relation happen to
+	 * be.  This also recomputes rs_nblocks.
+	 */
+	heap_rescan_set_params(scan, NULL, scan->rs_allow_strat, false,
+						   scan->rs_pageatatime);
+
+	ItemPointerCopy(mintid, &sscan->rs_mintid);
+	ItemPointerCopy(maxtid, &sscan->rs_maxtid);
+
+	/*
+	 * For relations without any pages, we can simply leave the block range
+	 * unset.  There will be no tuples to scan.
+	 */
+	if (scan->rs_nblocks == 0)
+		return;
+
+	/*
+	 * Set up some ItemPointers which point to the first and last possible
+	 * tuples in the heap.
+	 */
+	ItemPointerSet(&highestItem, scan->rs_nblocks - 1, MaxOffsetNumber);
+	ItemPointerSet(&lowestItem, 0, FirstOffsetNumber);
+
+	/*
+	 * If the given range lies entirely outside the relation, or is empty,
+	 * scan no blocks at all.
+	 */
+	if (ItemPointerCompare(maxtid, &lowestItem) < 0 ||
+		ItemPointerCompare(mintid, &highestItem) > 0 ||
+		ItemPointerCompare(mintid, maxtid) > 0)
+	{
+		heap_setscanlimits(scan, 0, 0);
+		return;
+	}
+
+	/* Clamp the range to the blocks that exist */
+	if (ItemPointerCompare(mintid, &lowestItem) < 0)
+		mintid = &lowestItem;
+	if (ItemPointerCompare(maxtid, &highestItem) > 0)
+		maxtid = &highestItem;
+
+	startBlk = ItemPointerGetBlockNumberNoCheck(mintid);
+	numBlks = ItemPointerGetBlockNumberNoCheck(maxtid) - startBlk + 1;
+
+	heap_setscanlimits(scan, startBlk, numBlks);
+}
+
+static bool
+heapam_getnextslot_tidrange(TableScanDesc sscan, ScanDirection direction,
+							TupleTableSlot *slot)
+{
+	HeapScanDesc scan = (HeapScanDesc) sscan;
+	HeapTuple	tuple;
+
+	/*
+	 * heap_setscanlimits only restricts the scan to whole blocks, so we must
+	 * step over the tuples on the first and last blocks of the range that
+	 * lie outside it.
+	 */
+	for (;;)
+	{
+		tuple = heap_getnext(scan, direction);
+		if (tuple == NULL)
+		{
+			ExecClearTuple(slot);
+			return false;
+		}
+
+		if (ItemPointerCompare(&tuple->t_self, &sscan->rs_mintid) < 0)
+		{
+			/* Before the range: done if scanning backward */
+			if (ScanDirectionIsBackward(direction))
+			{
+				ExecClearTuple(slot);
+				return false;
+			}
+			continue;
+		}
+
+		if (ItemPointerCompare(&tuple->t_self, &sscan->rs_maxtid) > 0)
+		{
+			/* After the range: done if scanning forward */
+			if (ScanDirectionIsForward(direction))
+			{
+				ExecClearTuple(slot);
+				return false;
+			}
+			continue;
+		}
+
+		break;
+	}
+
+	ExecStoreBufferHeapTuple(tuple, slot, scan->rs_cbuf);
+	return true;
+}
+
+
+/* ------------------------------------------------------------------------
+ * Parallel table scan callbacks for heap AM
+ * ------------------------------------------------------------------------
+ */
+
+static Size
+heapam_parallelscan_estimate(Relation rel, Snapshot snapshot)
+{
+	return heap_parallelscan_estimate(snapshot);
+}
+
+static void
+heapam_parallelscan_initialize(Relation rel, ParallelTableScanDesc pscan,
+							   Snapshot snapshot)
+{
+	heap_parallelscan_initialize((ParallelHeapScanDesc) pscan, rel, snapshot);
+}
+
+static void
+heapam_parallelscan_reinitialize(Relation rel, ParallelTableScanDesc pscan)
+{
+	heap_parallelscan_reinitialize((ParallelHeapScanDesc) pscan);
+}
+
+
+/* ------------------------------------------------------------------------
+ * Callbacks for non-modifying operations on individual tuples for heap AM
+ * ------------------------------------------------------------------------
+ */
+
+static bool
+heapam_fetch_row_version(Relation relation, ItemPointer tid,
+						 Snapshot snapshot, TupleTableSlot *slot)
+{
+	BufferHeapTupleTableSlot *bslot = (BufferHeapTupleTableSlot *) slot;
+	Buffer		buffer;
+
+	Assert(TTS_IS_BUFFERTUPLE(slot));
+
+	ExecClearTuple(slot);
+
+	bslot->base.tupdata.t_self = *tid;
+	if (heap_fetch(relation, snapshot, &bslot->base.tupdata, &buffer,
+				   false, NULL))
+	{
+		/* store in slot, transferring existing pin */
+		ExecStoreBufferHeapTuple(&bslot->base.tupdata, slot, buffer);
+		ReleaseBuffer(buffer);
+		return true;
+	}
+
+	return false;
+}
+
+
+/* ------------------------------------------------------------------------
+ * Functions for manipulations of physical tuples for heap AM
+ * ------------------------------------------------------------------------
+ */
+
+static void
+heapam_tuple_insert(Relation relation, TupleTableSlot *slot, CommandId cid,
+					int options, BulkInsertState bistate, ItemPointer tid)
+{
+	bool		shouldFree;
+	HeapTuple	tuple = ExecFetchSlotHeapTuple(slot, true, &shouldFree);
+
+	heap_insert(relation, tuple, cid, options, bistate);
+	ItemPointerCopy(&tuple->t_self, tid);
+
+	if (shouldFree)
+		pfree(tuple);
+}
+
+static void
+heapam_tuple_insert_speculative(Relation relation, TupleTableSlot *slot,
+								CommandId cid, int options,
+								BulkInsertState bistate, uint32 specToken,
+								ItemPointer tid)
+{
+	bool		shouldFree;
+	HeapTuple	tuple = ExecFetchSlotHeapTuple(slot, true, &shouldFree);
+
+	HeapTupleHeaderSetSpeculativeToken(tuple->t_data, specToken);
+	options |= HEAP_INSERT_SPECULATIVE;
+
+	heap_insert(relation, tuple, cid, options, bistate);
+	ItemPointerCopy(&tuple->t_self, tid);
+
+	if (shouldFree)
+		pfree(tuple);
+}
+
+static void
+heapam_tuple_complete_speculative(Relation relation, ItemPointer tid,
+								  bool succeeded)
+{
+	/* adjust the tuple's state accordingly */
+	if (succeeded)
+		heap_finish_speculative(relation, tid);
+	else
+		heap_abort_speculative(relation, tid);
+}
+
+static HTSU_Result
+heapam_tuple_delete(Relation relation, ItemPointer tid, CommandId cid,
+					Snapshot crosscheck, bool wait,
+					HeapUpdateFailureData *hufd, bool changingPart)
+{
+	return heap_delete(relation, tid, cid, crosscheck, wait, hufd,
+					   changingPart);
+}
+
+static HTSU_Result
+heapam_tuple_update(Relation relation, ItemPointer otid, TupleTableSlot *slot,
+					CommandId cid, Snapshot crosscheck, bool wait,
+					HeapUpdateFailureData *hufd, LockTupleMode *lockmode,
+					ItemPointer newtid, TU_UpdateIndexes *update_indexes)
+{
+	bool		shouldFree;
+	HeapTuple	tuple = ExecFetchSlotHeapTuple(slot, true, &shouldFree);
+	HTSU_Result result;
+
+	/*
+	 * heap_update decides which indexes need entries for the new tuple: none
+	 * after a HOT update, unless only summarizing indexes' columns changed.
+	 *
+	 * Note: heap_update returns the tid (location) of the new tuple in the
+	 * t_self field.
+	 */
+	result = heap_update(relation, otid, tuple, cid, crosscheck, wait,
+						 hufd, lockmode, update_indexes);
+	ItemPointerCopy(&tuple->t_self, newtid);
+
+	if (shouldFree)
+		pfree(tuple);
+
+	return result;
+}
+
+
+/* ------------------------------------------------------------------------
+ * Planner related callbacks for heap AM
+ * ------------------------------------------------------------------------
+ */
+
+static void
+heapam_estimate_rel_size(Relation rel, int32 *attr_widths,
+						 BlockNumber *pages, double *tuples,
+						 double *allvisfrac)
+{
+	BlockNumber curpages;
+	BlockNumber relpages;
+	double		reltuples;
+	BlockNumber relallvisible;
+	double		density;
+
+	/* it has storage, ok to call the smgr */
+	curpages = RelationGetNumberOfBlocks(rel);
+
+	/* coerce values in pg_class to more desirable types */
+	relpages = (BlockNumber) rel->rd_rel->relpages;
+	reltuples = (double) rel->rd_rel->reltuples;
+	relallvisible = (BlockNumber) rel->rd_rel->relallvisible;
+
+	/*
+	 * HACK: if the relation has never yet been vacuumed, use a minimum size
+	 * estimate of 10 pages.  The idea here is to avoid assuming a
+	 * newly-created table is really small, even if it currently is, because
+	 * that may not be true once some data gets loaded into it.  Once a vacuum
+	 * or analyze cycle has been done on it, it's more reasonable to believe
+	 * the size is somewhat stable.
+	 *
+	 * (Note that this is only an issue if the plan gets cached and used again
+	 * after the table has been filled.  What we're trying to avoid is using a
+	 * nestloop-type plan on a table that has grown substantially since the
+	 * plan was made.  Normally, autovacuum/autoanalyze will occur once enough
+	 * inserts have happened and cause cached-plan invalidation; but that
+	 * doesn't happen instantaneously, and it won't happen at all for cases
+	 * such as temporary tables.)
+	 *
+	 * We approximate "never vacuumed" by "has relpages = 0", which means this
+	 * will also fire on genuinely empty relations.  Not great, but
+	 * fortunately that's a seldom-seen case in the real world, and it
+	 * shouldn't degrade the quality of the plan too much anyway to err in
+	 * this direction.
+	 *
+	 * If the table has inheritance children, we don't apply this heuristic.
+	 * Totally empty parent tables are quite common, so we should be willing
+	 * to believe that they are empty.
+	 */
+	if (curpages < 10 &&
+		relpages == 0 &&
+		!rel->rd_rel->relhassubclass)
+		curpages = 10;
+
+	/* report estimated # pages */
+	*pages = curpages;
+	/* quick exit if rel is clearly empty */
+	if (curpages == 0)
+	{
+		*tuples = 0;
+		*allvisfrac = 0;
+		return;
+	}
+
+	/* estimate number of tuples from previous tuple density */
+	if (relpages > 0)
+		density = reltuples / (double) relpages;
+	else
+	{
+		/*
+		 * When we have no data because the relation was truncated, estimate
+		 * tuple width from attribute datatypes.  We assume here that the
+		 * pages are completely full, which is OK for tables (since they've
+		 * presumably not been VACUUMed yet).
+		 *
+		 * Note: this code intentionally disregards alignment considerations,
+		 * because (a) that would be gilding the lily considering how crude
+		 * the estimate is, and (b) it creates platform dependencies in the
+		 * default plans which are kind of a headache for regression testing.
+		 */
+		int32		tuple_width;
+
+		tuple_width = get_rel_data_width(rel, attr_widths);
+		tuple_width += MAXALIGN(SizeofHeapTupleHeader);
+		tuple_width += sizeof(ItemIdData);
+		/* note: integer division is intentional here */
+		density = (BLCKSZ - SizeOfPageHeaderData) / tuple_width;
+	}
+	*tuples = rint(density * (double) curpages);
+
+	/*
+	 * We use relallvisible as-is, rather than scaling it up like we do for
+	 * the pages and tuples counts, on the theory that any pages added since
+	 * the last VACUUM are most likely not marked all-visible.  But costsize.c
+	 * wants it converted to a fraction.
+	 */
+	if (relallvisible == 0 || curpages <= 0)
+		*allvisfrac = 0;
+	else if ((double) relallvisible >= curpages)
+		*allvisfrac = 1;
+	else
+		*allvisfrac = (double) relallvisible / curpages;
+}
+
+
+/* ------------------------------------------------------------------------
+ * Definition of the heap table access method.
+ * ------------------------------------------------------------------------
+ */
+
+static const TableAmRoutine heapam_methods = {
+	.type = T_TableAmRoutine,
+
+	.slot_callbacks = heapam_slot_callbacks,
+
+	.scan_begin = heapam_beginscan,
+	.scan_end = heapam_endscan,
+	.scan_rescan = heapam_rescan,
+	.scan_getnextslot = heapam_getnextslot,
+	.scan_set_tidrange = heapam_set_tidrange,
+	.scan_getnextslot_tidrange = heapam_getnextslot_tidrange,
+
+	.parallelscan_estimate = heapam_parallelscan_estimate,
+	.parallelscan_initialize = heapam_parallelscan_initialize,
+	.parallelscan_reinitialize = heapam_parallelscan_reinitialize,
+
+	.tuple_fetch_row_version = heapam_fetch_row_version,
+
+	.tuple_insert = heapam_tuple_insert,
+	.tuple_insert_speculative = heapam_tuple_insert_speculative,
+	.tuple_complete_speculative = heapam_tuple_complete_speculative,
+	.tuple_delete = heapam_tuple_delete,
+	.tuple_update = heapam_tuple_update,
+
+	.relation_vacuum = lazy_vacuum_rel,
+	.relation_acquire_sample_rows = acquire_sample_rows,
+	.relation_estimate_size = heapam_estimate_rel_size,
+};
+
+
+Datum
+heap_tableam_handler(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_POINTER(&heapam_methods);
+}
@@ -23,6 +23,14 @@
 #include "storage/freespace.h"
 #include "storage/lmgr.h"
 #include "storage/smgr.h"
+#include "utils/snapmgr.h"
+
+
+/*
+ * Maximum number of times RelationGetBufferForTuple moves on from a target
+ * page because its buffer lock is busy
+ */
+#define MAX_CONTENDED_TARGETS	4
 
 
 /*
@@ -168,11 +176,45 @@ GetVisibilityMapPins(Relation relation, Buffer buffer1, Buffer buffer2,
 	}
 }
 
+/*
+ * Opportunistically prune a candidate target page before we lock it.
+ *
+ * Pruning normally happens only when a page is read by a scan, so a page
+ * whose tuples were all deleted or updated away can go on looking full to
+ * inserters, and to updates whose new version doesn't fit on the old page,
+ * until some query happens to read it or VACUUM gets to it; meanwhile the
+ * relation is extended instead.  That is what makes queue-like tables with
+ * heavy UPDATE/DELETE churn bloat so quickly.  heap_page_prune_opt() falls
+ * out cheaply if the page has nothing prunable, and does nothing if it can't
+ * get a cleanup lock, e.g. because we ourselves hold another pin on the page.
+ *
+ * The caller must hold a pin on the buffer, but no lock.
+ */
+static void
+PruneTargetPage(Relation relation, Buffer buffer)
+{
+	/* there's no horizon to prune against in bootstrap mode */
+	if (!TransactionIdIsValid(RecentGlobalXmin))
+		return;
+
+	heap_page_prune_opt(relation, buffer);
+}
+
+/*
+ * A bulk insert starts pre-extending the relation by itself only once it has
+ * added this many blocks.  Smaller loads gain little from it, and would just
+ * be left with unused pre-extended pages at the end of the relation.
+ */
+#define BULK_EXTEND_THRESHOLD	1024
+
 /*
  * Extend a relation by multiple blocks to avoid future contention on the
  * relation extension lock.  Our goal is to pre-extend the relation by an
- * amount which ramps up as the degree of contention ramps up, but limiting
- * the result to some sane overall value.
+ * amount which ramps up as the degree of contention ramps up, or, for a
+ * bulk insert, as the amount of data it has loaded so far ramps up, but
+ * limiting the result to some sane overall value.
+ *
+ * The caller holds the relation extension lock.
  */
 static void
 RelationAddExtraBlocks(Relation relation, BulkInsertState bistate)
@@ -184,16 +226,27 @@ RelationAddExtraBlocks(Relation relation, BulkInsertState bistate)
 
 	/* Use the length of the lock wait queue to judge how much to extend. */
 	lockWaiters = RelationExtensionLockWaiterCount(relation);
-	if (lockWaiters <= 0)
-		return;
 
 	/*
 	 * It might seem like multiplying the number of lock waiters by as much as
 	 * 20 is too aggressive, but benchmarking revealed that smaller numbers
-	 * were insufficient.  512 is just an arbitrary cap to prevent
-	 * pathological results.
+	 * were insufficient.
+	 *
+	 * A bulk insert that has already added BULK_EXTEND_THRESHOLD blocks will
+	 * most likely keep going at the same pace, so there we also add as many
+	 * blocks as it has added so far, which doubles the extension every time
+	 * until the cap; that takes the extension lock far less often.
+	 *
+	 * 512 is just an arbitrary cap to prevent pathological results.
 	 */
-	extraBlocks = Min(512, lockWaiters * 20);
+	extraBlocks = lockWaiters * 20;
+	if (bistate && bistate->nextended >= BULK_EXTEND_THRESHOLD)
+		extraBlocks = Max(extraBlocks, bistate->nextended);
+	extraBlocks = Min(512, extraBlocks);
+	if (extraBlocks <= 0)
+		return;
+	if (bistate)
+		bistate->nextended += extraBlocks;
 
 	do
 	{
@@ -323,6 +376,8 @@ RelationGetBufferForTuple(Relation relation, Size len,
 	BlockNumber targetBlock,
 				otherBlock;
 	bool		needLock;
+	bool		bulkExtend;
+	int			ncontended = 0;
 
 	len = MAXALIGN(len);		/* be conservative */
 
@@ -413,13 +468,44 @@ loop:
 		{
 			/* easy case */
 			buffer = ReadBufferBI(relation, targetBlock, bistate);
+			PruneTargetPage(relation, buffer);
 			if (PageIsAllVisible(BufferGetPage(buffer)))
 				visibilitymap_pin(relation, targetBlock, vmbuffer);
-			LockBuffer(buffer, BUFFER_LOCK_EXCLUSIVE);
+
+			/*
+			 * If another backend holds the lock, it is most likely inserting
+			 * into the same page: concurrent inserters all start out with
+			 * the page the FSM handed out last, or the one most recently
+			 * added to the relation.  Rather than queue up behind it, ask
+			 * the FSM for another page, which steps its search pointer past
+			 * this one, and use that as our target from now on; this spreads
+			 * concurrent inserters over different pages.  Only do this a few
+			 * times, so that we don't wander off from a page we're going to
+			 * have to wait for anyway.
+			 */
+			if (!ConditionalLockBuffer(buffer))
+			{
+				BlockNumber altBlock = InvalidBlockNumber;
+
+				if (use_fsm && ncontended < MAX_CONTENDED_TARGETS)
+					altBlock = GetPageWithFreeSpace(relation,
+													len + saveFreeSpace);
+				if (altBlock != InvalidBlockNumber && altBlock != targetBlock)
+				{
+					ReleaseBuffer(buffer);
+					targetBlock = altBlock;
+					ncontended++;
+					continue;
+				}
+				LockBuffer(buffer, BUFFER_LOCK_EXCLUSIVE);
+			}
 		}
 		else if (otherBlock == targetBlock)
 		{
-			/* also easy case */
+			/*
+			 * also easy case; no point trying to prune, since caller holds
+			 * a pin on the old tuple's page
+			 */
 			buffer = otherBuffer;
 			if (PageIsAllVisible(BufferGetPage(buffer)))
 				visibilitymap_pin(relation, targetBlock, vmbuffer);
@@ -429,6 +515,7 @@ loop:
 		{
 			/* lock other buffer first */
 			buffer = ReadBuffer(relation, targetBlock);
+			PruneTargetPage(relation, buffer);
 			if (PageIsAllVisible(BufferGetPage(buffer)))
 				visibilitymap_pin(relation, targetBlock, vmbuffer);
 			LockBuffer(otherBuffer, BUFFER_LOCK_EXCLUSIVE);
@@ -438,6 +525,7 @@ loop:
 		{
 			/* lock target buffer first */
 			buffer = ReadBuffer(relation, targetBlock);
+			PruneTargetPage(relation, buffer);
 			if (PageIsAllVisible(BufferGetPage(buffer)))
 				visibilitymap_pin(relation, targetBlock, vmbuffer);
 			LockBuffer(buffer, BUFFER_LOCK_EXCLUSIVE);
@@ -525,6 +613,7 @@ loop:
 	 * could be accessing them.
 	 */
 	needLock = !RELATION_IS_LOCAL(relation);
+	bulkExtend = false;
 
 	/*
 	 * If we need the lock but are not able to acquire it immediately, we'll
@@ -536,7 +625,18 @@ loop:
 	{
 		if (!use_fsm)
 			LockRelationForExtension(relation, ExclusiveLock);
-		else if (!ConditionalLockRelationForExtension(relation, ExclusiveLock))
+		else if (ConditionalLockRelationForExtension(relation, ExclusiveLock))
+		{
+			/*
+			 * No contention, but a bulk insert that has filled up plenty of
+			 * blocks before will fill up more; see RelationAddExtraBlocks.
+			 * Those blocks are added after our own, below, so that the load
+			 * still fills the relation in block order.
+			 */
+			bulkExtend = (bistate &&
+						  bistate->nextended >= BULK_EXTEND_THRESHOLD);
+		}
+		else
 		{
 			/* Couldn't get the lock immediately; wait for it. */
 			LockRelationForExtension(relation, ExclusiveLock);
@@ -572,6 +672,11 @@ loop:
 	 * rather than relying on the kernel to do it for us?
 	 */
 	buffer = ReadBufferBI(relation, P_NEW, bistate);
+	if (bistate)
+		bistate->nextended++;
+
+	if (bulkExtend)
+		RelationAddExtraBlocks(relation, bistate);
 
 	/*
 	 * We can be certain that locking the otherBuffer first is OK, since it
@@ -23,6 +23,7 @@
 #include "miscadmin.h"
 #include "pgstat.h"
 #include "storage/bufmgr.h"
+#include "storage/freespace.h"
 #include "utils/snapmgr.h"
 #include "utils/rel.h"
 #include "utils/tqual.h"
@@ -136,6 +137,8 @@ heap_page_prune_opt(Relation relation, Buffer buffer)
 
 	if (PageIsFull(page) || PageGetHeapFreeSpace(page) < minfree)
 	{
+		Size		freespace = 0;
+
 		/* OK, try to get exclusive buffer lock */
 		if (!ConditionalLockBufferForCleanup(buffer))
 			return;
@@ -152,11 +155,25 @@ heap_page_prune_opt(Relation relation, Buffer buffer)
 															 * needed */
 
 			/* OK to prune */
-			(void) heap_page_prune(relation, buffer, OldestXmin, true, &ignore);
+			if (heap_page_prune(relation, buffer, OldestXmin, true,
+								&ignore) > 0)
+				freespace = PageGetHeapFreeSpace(page);
 		}
 
 		/* And release buffer lock */
 		LockBuffer(buffer, BUFFER_LOCK_UNLOCK);
+
+		/*
+		 * The FSM most likely still thinks of this page as full, and would
+		 * only learn otherwise at the next VACUUM.  If pruning freed more
+		 * space than minfree, which covers the fill-factor reserve that
+		 * insertions have to leave alone, tell the FSM now, so that
+		 * inserters use the space instead of extending the relation.
+		 */
+		if (freespace > minfree)
+			RecordPageWithFreeSpaceAndPropagate(relation,
+												BufferGetBlockNumber(buffer),
+												freespace);
 	}
 }
 
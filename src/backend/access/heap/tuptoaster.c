@@ -29,6 +29,12 @@
 
 #include <unistd.h>
 #include <fcntl.h>
+#ifdef USE_LZ4
+#include <lz4.h>
+#endif
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
 
 #include "access/genam.h"
 #include "access/heapam.h"
@@ -37,6 +43,7 @@
 #include "catalog/catalog.h"
 #include "common/pg_lzcompress.h"
 #include "miscadmin.h"
+#include "utils/attoptcache.h"
 #include "utils/expandeddatum.h"
 #include "utils/fmgroids.h"
 #include "utils/rel.h"
@@ -53,7 +60,7 @@
 typedef struct toast_compress_header
 {
 	int32		vl_len_;		/* varlena header (do not touch directly!) */
-	int32		rawsize;
+	uint32		rawsize;		/* raw size and compression method */
 } toast_compress_header;
 
 /*
@@ -61,11 +68,18 @@ typedef struct toast_compress_header
  * toast entries.
  */
 #define TOAST_COMPRESS_HDRSZ		((int32) sizeof(toast_compress_header))
-#define TOAST_COMPRESS_RAWSIZE(ptr) (((toast_compress_header *) (ptr))->rawsize)
+#define TOAST_COMPRESS_RAWSIZE(ptr) \
+	(((toast_compress_header *) (ptr))->rawsize & VARLENA_RAWSIZE_MASK)
+#define TOAST_COMPRESS_METHOD(ptr) \
+	(((toast_compress_header *) (ptr))->rawsize >> VARLENA_RAWSIZE_BITS)
 #define TOAST_COMPRESS_RAWDATA(ptr) \
 	(((char *) (ptr)) + TOAST_COMPRESS_HDRSZ)
-#define TOAST_COMPRESS_SET_RAWSIZE(ptr, len) \
-	(((toast_compress_header *) (ptr))->rawsize = (len))
+#define TOAST_COMPRESS_SET_RAWSIZE(ptr, len, cmethod) \
+	(((toast_compress_header *) (ptr))->rawsize = \
+	 ((uint32) (len)) | ((uint32) (cmethod) << VARLENA_RAWSIZE_BITS))
+
+/* GUC variable */
+int			default_toast_compression = TOAST_PGLZ_COMPRESSION_ID;
 
 static void toast_delete_datum(Relation rel, Datum value, bool is_speculative);
 static Datum toast_save_datum(Relation rel, Datum value,
@@ -76,6 +90,9 @@ static struct varlena *toast_fetch_datum(struct varlena *attr);
 static struct varlena *toast_fetch_datum_slice(struct varlena *attr,
 						int32 sliceoffset, int32 length);
 static struct varlena *toast_decompress_datum(struct varlena *attr);
+static struct varlena *toast_decompress_datum_slice(struct varlena *attr,
+							 int32 slicelength);
+static int	toast_column_compression(Relation rel, int attnum);
 static int toast_open_indexes(Relation toastrel,
 				   LOCKMODE lock,
 				   Relation **toastidxs,
@@ -273,8 +290,34 @@ heap_tuple_untoast_attr_slice(struct varlena *attr,
 		if (!VARATT_EXTERNAL_IS_COMPRESSED(toast_pointer))
 			return toast_fetch_datum_slice(attr, sliceoffset, slicelength);
 
-		/* fetch it back (compressed marker will get set automatically) */
-		preslice = toast_fetch_datum(attr);
+		/*
+		 * For a compressed value, fetch only as many chunks as could be
+		 * needed to decompress the requested leading part, assuming pglz.
+		 * If the value turns out to use another method, we don't know how
+		 * much of it is needed, so fetch the whole thing.
+		 */
+		if (slicelength >= 0 && sliceoffset >= 0 &&
+			(int64) sliceoffset + slicelength < toast_pointer.va_rawsize - VARHDRSZ)
+		{
+			int32		max_size;
+
+			max_size = pglz_maximum_compressed_size(sliceoffset + slicelength,
+													toast_pointer.va_extsize -
+													(TOAST_COMPRESS_HDRSZ - VARHDRSZ));
+			preslice = toast_fetch_datum_slice(attr, 0,
+											   max_size +
+											   (TOAST_COMPRESS_HDRSZ - VARHDRSZ));
+			if (TOAST_COMPRESS_METHOD(preslice) != TOAST_PGLZ_COMPRESSION_ID)
+			{
+				pfree(preslice);
+				preslice = toast_fetch_datum(attr);
+			}
+		}
+		else
+		{
+			/* fetch it back (compressed marker will get set automatically) */
+			preslice = toast_fetch_datum(attr);
+		}
 	}
 	else if (VARATT_IS_EXTERNAL_INDIRECT(attr))
 	{
@@ -302,7 +345,13 @@ heap_tuple_untoast_attr_slice(struct varlena *attr,
 	{
 		struct varlena *tmp = preslice;
 
-		preslice = toast_decompress_datum(tmp);
+		/* Decompress enough to encompass the slice, if possible */
+		if (slicelength >= 0 && sliceoffset >= 0 &&
+			(int64) sliceoffset + slicelength < TOAST_COMPRESS_RAWSIZE(tmp))
+			preslice = toast_decompress_datum_slice(tmp,
+													sliceoffset + slicelength);
+		else
+			preslice = toast_decompress_datum(tmp);
 
 		if (tmp != attr)
 			pfree(tmp);
@@ -771,7 +820,8 @@ toast_insert_or_update(Relation rel, HeapTuple newtup, HeapTuple oldtup,
 		if (TupleDescAttr(tupleDesc, i)->attstorage == 'x')
 		{
 			old_value = toast_values[i];
-			new_value = toast_compress_datum(old_value);
+			new_value = toast_compress_datum(old_value,
+											 toast_column_compression(rel, i + 1));
 
 			if (DatumGetPointer(new_value) != NULL)
 			{
@@ -912,7 +962,8 @@ toast_insert_or_update(Relation rel, HeapTuple newtup, HeapTuple oldtup,
 		 */
 		i = biggest_attno;
 		old_value = toast_values[i];
-		new_value = toast_compress_datum(old_value);
+		new_value = toast_compress_datum(old_value,
+										 toast_column_compression(rel, i + 1));
 
 		if (DatumGetPointer(new_value) != NULL)
 		{
@@ -1341,10 +1392,149 @@ toast_build_flattened_tuple(TupleDesc tupleDesc,
 }
 
 
+/* ----------
+ * toast_compression_method_name -
+ *
+ *	Return the name of a compression method
+ * ----------
+ */
+const char *
+toast_compression_method_name(int cmethod)
+{
+	switch (cmethod)
+	{
+		case TOAST_PGLZ_COMPRESSION_ID:
+			return "pglz";
+		case TOAST_LZ4_COMPRESSION_ID:
+			return "lz4";
+		case TOAST_ZSTD_COMPRESSION_ID:
+			return "zstd";
+	}
+	return "unknown";
+}
+
+/* ----------
+ * toast_compression_method_id -
+ *
+ *	Look up a compression method by name.  Returns -1 if the name is
+ *	unknown or the method isn't supported by this build.
+ * ----------
+ */
+int
+toast_compression_method_id(const char *name)
+{
+	if (strcmp(name, "pglz") == 0)
+		return TOAST_PGLZ_COMPRESSION_ID;
+#ifdef USE_LZ4
+	if (strcmp(name, "lz4") == 0)
+		return TOAST_LZ4_COMPRESSION_ID;
+#endif
+#ifdef USE_ZSTD
+	if (strcmp(name, "zstd") == 0)
+		return TOAST_ZSTD_COMPRESSION_ID;
+#endif
+	return -1;
+}
+
+/* ----------
+ * toast_validate_compression_option -
+ *
+ *	Validator for the "compression" attribute option
+ * ----------
+ */
+void
+toast_validate_compression_option(const char *value)
+{
+	if (value == NULL || toast_compression_method_id(value) < 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid value for \"compression\" option"),
+				 errdetail("Valid values are \"pglz\""
+#ifdef USE_LZ4
+						   ", \"lz4\""
+#endif
+#ifdef USE_ZSTD
+						   ", \"zstd\""
+#endif
+						   ".")));
+}
+
+/* ----------
+ * toast_get_compression_id -
+ *
+ *	Return the compression method of a possibly-compressed varlena datum,
+ *	or -1 if it isn't compressed.  For an external datum, the method is
+ *	stored in the toasted data, so we fetch the first chunk.
+ * ----------
+ */
+int
+toast_get_compression_id(struct varlena *attr)
+{
+	int			cmethod = -1;
+
+	if (VARATT_IS_EXTERNAL_ONDISK(attr))
+	{
+		struct varatt_external toast_pointer;
+
+		VARATT_EXTERNAL_GET_POINTER(toast_pointer, attr);
+		if (VARATT_EXTERNAL_IS_COMPRESSED(toast_pointer))
+		{
+			struct varlena *tmp;
+
+			/* the method is in the first word of the data, fetch just that */
+			tmp = toast_fetch_datum_slice(attr, 0,
+										  TOAST_COMPRESS_HDRSZ - VARHDRSZ);
+
+			cmethod = TOAST_COMPRESS_METHOD(tmp);
+			pfree(tmp);
+		}
+	}
+	else if (VARATT_IS_COMPRESSED(attr))
+		cmethod = TOAST_COMPRESS_METHOD(attr);
+
+	return cmethod;
+}
+
+/* ----------
+ * toast_column_compression -
+ *
+ *	Return the compression method to use for attribute attnum of rel:
+ *	its "compression" option if set, else default_toast_compression.
+ * ----------
+ */
+static int
+toast_column_compression(Relation rel, int attnum)
+{
+	AttributeOpts *aopts;
+	int			cmethod = default_toast_compression;
+
+	/* system catalogs can't have attribute options, don't look */
+	if (IsCatalogRelation(rel))
+		return cmethod;
+
+	aopts = get_attribute_options(RelationGetRelid(rel), attnum);
+	if (aopts != NULL)
+	{
+		if (aopts->compressionOffset != 0)
+		{
+			int			id;
+
+			id = toast_compression_method_id((char *) aopts +
+											 aopts->compressionOffset);
+			if (id >= 0)
+				cmethod = id;
+		}
+		pfree(aopts);
+	}
+
+	return cmethod;
+}
+
 /* ----------
  * toast_compress_datum -
  *
- *	Create a compressed version of a varlena datum
+ *	Create a compressed version of a varlena datum, using compression
+ *	method cmethod (a ToastCompressionId)
  *
  *	If we fail (ie, compressed result is actually bigger than original)
  *	then return NULL.  We must not use compressed data if it'd expand
@@ -1355,11 +1545,12 @@ toast_build_flattened_tuple(TupleDesc tupleDesc,
  * ----------
  */
 Datum
-toast_compress_datum(Datum value)
+toast_compress_datum(Datum value, int cmethod)
 {
 	struct varlena *tmp;
 	int32		valsize = VARSIZE_ANY_EXHDR(DatumGetPointer(value));
 	int32		len;
+	int32		maxlen;
 
 	Assert(!VARATT_IS_EXTERNAL(DatumGetPointer(value)));
 	Assert(!VARATT_IS_COMPRESSED(DatumGetPointer(value)));
@@ -1372,8 +1563,27 @@ toast_compress_datum(Datum value)
 		valsize > PGLZ_strategy_default->max_input_size)
 		return PointerGetDatum(NULL);
 
-	tmp = (struct varlena *) palloc(PGLZ_MAX_OUTPUT(valsize) +
-									TOAST_COMPRESS_HDRSZ);
+	switch (cmethod)
+	{
+		case TOAST_PGLZ_COMPRESSION_ID:
+			maxlen = PGLZ_MAX_OUTPUT(valsize);
+			break;
+#ifdef USE_LZ4
+		case TOAST_LZ4_COMPRESSION_ID:
+			maxlen = LZ4_compressBound(valsize);
+			break;
+#endif
+#ifdef USE_ZSTD
+		case TOAST_ZSTD_COMPRESSION_ID:
+			maxlen = ZSTD_compressBound(valsize);
+			break;
+#endif
+		default:
+			elog(ERROR, "unsupported compression method %d", cmethod);
+			maxlen = 0;			/* keep compiler quiet */
+	}
+
+	tmp = (struct varlena *) palloc(maxlen + TOAST_COMPRESS_HDRSZ);
 
 	/*
 	 * We recheck the actual size even if pglz_compress() reports success,
@@ -1385,14 +1595,41 @@ toast_compress_datum(Datum value)
 	 * only one header byte and no padding if the value is short enough.  So
 	 * we insist on a savings of more than 2 bytes to ensure we have a gain.
 	 */
-	len = pglz_compress(VARDATA_ANY(DatumGetPointer(value)),
-						valsize,
-						TOAST_COMPRESS_RAWDATA(tmp),
-						PGLZ_strategy_default);
+	switch (cmethod)
+	{
+#ifdef USE_LZ4
+		case TOAST_LZ4_COMPRESSION_ID:
+			len = LZ4_compress_default(VARDATA_ANY(DatumGetPointer(value)),
+									   TOAST_COMPRESS_RAWDATA(tmp),
+									   valsize, maxlen);
+			if (len <= 0)
+				len = -1;
+			break;
+#endif
+#ifdef USE_ZSTD
+		case TOAST_ZSTD_COMPRESSION_ID:
+			{
+				size_t		zlen;
+
+				zlen = ZSTD_compress(TOAST_COMPRESS_RAWDATA(tmp), maxlen,
+									 VARDATA_ANY(DatumGetPointer(value)),
+									 valsize, ZSTD_CLEVEL_DEFAULT);
+				len = ZSTD_isError(zlen) ? -1 : (int32) zlen;
+			}
+			break;
+#endif
+		default:
+			len = pglz_compress(VARDATA_ANY(DatumGetPointer(value)),
+								valsize,
+								TOAST_COMPRESS_RAWDATA(tmp),
+								PGLZ_strategy_default);
+			break;
+	}
+
 	if (len >= 0 &&
 		len + TOAST_COMPRESS_HDRSZ < valsize - 2)
 	{
-		TOAST_COMPRESS_SET_RAWSIZE(tmp, valsize);
+		TOAST_COMPRESS_SET_RAWSIZE(tmp, valsize, cmethod);
 		SET_VARSIZE_COMPRESSED(tmp, len + TOAST_COMPRESS_HDRSZ);
 		/* successful compression */
 		return PointerGetDatum(tmp);
@@ -1764,7 +2001,7 @@ toast_delete_datum(Relation rel, Datum value, bool is_speculative)
 		 * Have a chunk, delete it
 		 */
 		if (is_speculative)
-			heap_abort_speculative(toastrel, toasttup);
+			heap_abort_speculative(toastrel, &toasttup->t_self);
 		else
 			simple_heap_delete(toastrel, &toasttup->t_self);
 	}
@@ -2068,10 +2305,12 @@ toast_fetch_datum_slice(struct varlena *attr, int32 sliceoffset, int32 length)
 	VARATT_EXTERNAL_GET_POINTER(toast_pointer, attr);
 
 	/*
-	 * It's nonsense to fetch slices of a compressed datum -- this isn't lo_*
-	 * we can't return a compressed datum which is meaningful to toast later
+	 * It's nonsense to fetch slices of a compressed datum unless starting at
+	 * the beginning -- only a leading part of the compressed data can be
+	 * decompressed.  In that case the result is a truncated compressed datum,
+	 * suitable only for toast_decompress_datum_slice.
 	 */
-	Assert(!VARATT_EXTERNAL_IS_COMPRESSED(toast_pointer));
+	Assert(!VARATT_EXTERNAL_IS_COMPRESSED(toast_pointer) || sliceoffset == 0);
 
 	attrsize = toast_pointer.va_extsize;
 	totalchunks = ((attrsize - 1) / TOAST_MAX_CHUNK_SIZE) + 1;
@@ -2087,7 +2326,10 @@ toast_fetch_datum_slice(struct varlena *attr, int32 sliceoffset, int32 length)
 
 	result = (struct varlena *) palloc(length + VARHDRSZ);
 
-	SET_VARSIZE(result, length + VARHDRSZ);
+	if (VARATT_EXTERNAL_IS_COMPRESSED(toast_pointer))
+		SET_VARSIZE_COMPRESSED(result, length + VARHDRSZ);
+	else
+		SET_VARSIZE(result, length + VARHDRSZ);
 
 	if (length == 0)
 		return result;			/* Can save a lot of work at this point! */
@@ -2263,19 +2505,109 @@ static struct varlena *
 toast_decompress_datum(struct varlena *attr)
 {
 	struct varlena *result;
+	int32		rawsize;
+	int32		len;
+
+	Assert(VARATT_IS_COMPRESSED(attr));
+
+	rawsize = TOAST_COMPRESS_RAWSIZE(attr);
+	result = (struct varlena *) palloc(rawsize + VARHDRSZ);
+	SET_VARSIZE(result, rawsize + VARHDRSZ);
+
+	switch (TOAST_COMPRESS_METHOD(attr))
+	{
+		case TOAST_PGLZ_COMPRESSION_ID:
+			len = pglz_decompress(TOAST_COMPRESS_RAWDATA(attr),
+								  VARSIZE(attr) - TOAST_COMPRESS_HDRSZ,
+								  VARDATA(result),
+								  rawsize, true);
+			break;
+		case TOAST_LZ4_COMPRESSION_ID:
+#ifdef USE_LZ4
+			len = LZ4_decompress_safe(TOAST_COMPRESS_RAWDATA(attr),
+									  VARDATA(result),
+									  VARSIZE(attr) - TOAST_COMPRESS_HDRSZ,
+									  rawsize);
+			break;
+#else
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("compression method lz4 not supported"),
+					 errdetail("This functionality requires the server to be built with lz4 support.")));
+#endif
+		case TOAST_ZSTD_COMPRESSION_ID:
+#ifdef USE_ZSTD
+			{
+				size_t		zlen;
+
+				zlen = ZSTD_decompress(VARDATA(result), rawsize,
+									   TOAST_COMPRESS_RAWDATA(attr),
+									   VARSIZE(attr) - TOAST_COMPRESS_HDRSZ);
+				len = ZSTD_isError(zlen) ? -1 : (int32) zlen;
+			}
+			break;
+#else
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("compression method zstd not supported"),
+					 errdetail("This functionality requires the server to be built with zstd support.")));
+#endif
+		default:
+			elog(ERROR, "invalid compression method id %d",
+				 TOAST_COMPRESS_METHOD(attr));
+			len = -1;			/* keep compiler quiet */
+	}
+
+	if (len != rawsize)
+		elog(ERROR, "compressed data is corrupted");
+
+	return result;
+}
+
+/* ----------
+ * toast_decompress_datum_slice -
+ *
+ * Decompress the front of a compressed version of a varlena datum.
+ * offset handling happens in heap_tuple_untoast_attr_slice.
+ * Here we just decompress a slice from the front.  The input may itself
+ * be just the leading part of the compressed data.
+ */
+static struct varlena *
+toast_decompress_datum_slice(struct varlena *attr, int32 slicelength)
+{
+	struct varlena *result;
+	int32		rawsize;
 
 	Assert(VARATT_IS_COMPRESSED(attr));
 
-	result = (struct varlena *)
-		palloc(TOAST_COMPRESS_RAWSIZE(attr) + VARHDRSZ);
-	SET_VARSIZE(result, TOAST_COMPRESS_RAWSIZE(attr) + VARHDRSZ);
+	switch (TOAST_COMPRESS_METHOD(attr))
+	{
+		case TOAST_PGLZ_COMPRESSION_ID:
+			result = (struct varlena *) palloc(slicelength + VARHDRSZ);
+			rawsize = pglz_decompress(TOAST_COMPRESS_RAWDATA(attr),
+									  VARSIZE(attr) - TOAST_COMPRESS_HDRSZ,
+									  VARDATA(result),
+									  slicelength, false);
+			break;
+#ifdef USE_LZ4
+		case TOAST_LZ4_COMPRESSION_ID:
+			result = (struct varlena *) palloc(slicelength + VARHDRSZ);
+			rawsize = LZ4_decompress_safe_partial(TOAST_COMPRESS_RAWDATA(attr),
+												  VARDATA(result),
+												  VARSIZE(attr) - TOAST_COMPRESS_HDRSZ,
+												  slicelength,
+												  slicelength);
+			break;
+#endif
+		default:
+			/* no partial decompression for this method, do it all */
+			return toast_decompress_datum(attr);
+	}
 
-	if (pglz_decompress(TOAST_COMPRESS_RAWDATA(attr),
-						VARSIZE(attr) - TOAST_COMPRESS_HDRSZ,
-						VARDATA(result),
-						TOAST_COMPRESS_RAWSIZE(attr)) < 0)
+	if (rawsize < 0)
 		elog(ERROR, "compressed data is corrupted");
 
+	SET_VARSIZE(result, rawsize + VARHDRSZ);
 	return result;
 }
 
@@ -100,6 +100,8 @@ RelationGetIndexScan(Relation indexRelation, int nkeys, int norderbys)
 		scan->orderByData = NULL;
 
 	scan->xs_want_itup = false; /* may be set later */
+	scan->xs_want_skip = false; /* may be set later */
+	scan->xs_prefetch_maximum = 0;	/* may be set later */
 
 	/*
 	 * During recovery we ignore killed tuples and don't bother to kill them
@@ -468,7 +470,7 @@ systable_recheck_tuple(SysScanDesc sysscan, HeapTuple tup)
 	{
 		HeapScanDesc scan = sysscan->scan;
 
-		Assert(IsMVCCSnapshot(scan->rs_snapshot));
+		Assert(IsMVCCSnapshot(scan->rs_base.rs_snapshot));
 		Assert(tup == &scan->rs_ctup);
 		Assert(BufferIsValid(scan->rs_cbuf));
 		/* must hold a buffer lock to call HeapTupleSatisfiesVisibility */
@@ -0,0 +1,476 @@
+/*-------------------------------------------------------------------------
+ *
+ * nbtdedup.c
+ *	  Deduplicate items in Postgres btrees.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/access/nbtree/nbtdedup.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "access/nbtree.h"
+#include "access/nbtxlog.h"
+#include "access/xloginsert.h"
+#include "miscadmin.h"
+#include "utils/rel.h"
+
+
+
+/*
+ * Can tuples of this index be merged into posting list tuples?
+ *
+ * Unique indexes are never deduplicated, because _bt_check_unique() expects
+ * each leaf tuple to point to exactly one heap tuple, and because duplicates
+ * in a unique index are rare and short-lived anyway.  INCLUDE indexes are
+ * left alone too, since their high keys are formed by truncation and a
+ * posting list would add nothing but complexity there.  Finally, the user
+ * can disable deduplication with the deduplicate_items storage parameter.
+ */
+bool
+_bt_dedup_enabled(Relation rel)
+{
+	return !rel->rd_index->indisunique &&
+		IndexRelationGetNumberOfKeyAttributes(rel) ==
+		IndexRelationGetNumberOfAttributes(rel) &&
+		BTGetDeduplicateItems(rel);
+}
+
+/*
+ * Deduplicate items on a leaf page.  The page will have to be split by
+ * caller if we cannot successfully free at least newitemsz (we also need
+ * space for newitem's line pointer, which isn't included in caller's
+ * newitemsz).
+ *
+ * Runs of adjacent tuples whose keys are binary equal are merged into
+ * posting list tuples.  Requiring binary equality, rather than equality
+ * according to the opclass, means that a posting list never has to hide two
+ * values that could be distinguished by an index-only scan (e.g. numeric
+ * 1.0 and 1.00), at the cost of missing a few opportunities.
+ *
+ * The page is rewritten as a whole in a temporary copy, which replaces the
+ * original inside a critical section.  Caller must hold an exclusive lock on
+ * buf, which must be a leaf page.  Should be called only when the page would
+ * otherwise have to be split.
+ */
+void
+_bt_dedup_one_page(Relation rel, Buffer buf, Size newitemsz)
+{
+	OffsetNumber offnum,
+				minoff,
+				maxoff;
+	Page		page = BufferGetPage(buf);
+	BTPageOpaque opaque = (BTPageOpaque) PageGetSpecialPointer(page);
+	Page		newpage;
+	BTDedupState state;
+	Size		pagesaving = 0;
+
+	Assert(P_ISLEAF(opaque));
+	Assert(_bt_dedup_enabled(rel));
+
+	newitemsz += sizeof(ItemIdData);
+
+	minoff = P_FIRSTDATAKEY(opaque);
+	maxoff = PageGetMaxOffsetNumber(page);
+
+	/* Need at least two data items to have anything to merge */
+	if (maxoff <= minoff)
+		return;
+
+	state = (BTDedupState) palloc(sizeof(BTDedupStateData));
+	state->maxpostingsize = Min(BTMaxItemSize(page) / 2, INDEX_SIZE_MASK);
+	/* Metadata about base tuple of current pending posting list */
+	state->base = NULL;
+	state->baseoff = InvalidOffsetNumber;
+	state->basetupsize = 0;
+	/* Metadata about current pending posting list TIDs */
+	state->htids = palloc(state->maxpostingsize);
+	state->nhtids = 0;
+	state->nitems = 0;
+	state->nintervals = 0;
+
+	/*
+	 * Build the new version of the page in a temporary copy, starting with
+	 * the original page's high key, if any.
+	 */
+	newpage = PageGetTempPageCopySpecial(page);
+	if (!P_RIGHTMOST(opaque))
+	{
+		ItemId		hitemid = PageGetItemId(page, P_HIKEY);
+		Size		hitemsz = ItemIdGetLength(hitemid);
+		IndexTuple	hitem = (IndexTuple) PageGetItem(page, hitemid);
+
+		if (PageAddItem(newpage, (Item) hitem, hitemsz, P_HIKEY,
+						false, false) == InvalidOffsetNumber)
+			elog(ERROR, "deduplication failed to add highkey");
+	}
+
+	for (offnum = minoff;
+		 offnum <= maxoff;
+		 offnum = OffsetNumberNext(offnum))
+	{
+		ItemId		itemid = PageGetItemId(page, offnum);
+		IndexTuple	itup = (IndexTuple) PageGetItem(page, itemid);
+
+		if (offnum == minoff)
+		{
+			/* No previous/base tuple for the data item -- use it as base */
+			_bt_dedup_start_pending(state, itup, offnum);
+		}
+		else if (_bt_dedup_keys_equal(state->base, itup) &&
+				 _bt_dedup_save_htid(state, itup))
+		{
+			/*
+			 * Tuple is equal to base tuple of pending posting list.  Heap
+			 * TID(s) for itup have been saved in state.
+			 */
+		}
+		else
+		{
+			/*
+			 * Tuple is not equal to pending posting list tuple, or
+			 * _bt_dedup_save_htid() opted to not merge current item into
+			 * pending posting list.  Finish the pending posting list and
+			 * start a new one with itup as its base.
+			 */
+			pagesaving += _bt_dedup_finish_pending(newpage, state);
+			_bt_dedup_start_pending(state, itup, offnum);
+		}
+	}
+
+	/* Handle the last item */
+	pagesaving += _bt_dedup_finish_pending(newpage, state);
+
+	/*
+	 * If no items were merged there is no point in writing out the new page;
+	 * the caller will split the original.
+	 */
+	if (state->nintervals == 0)
+	{
+		pfree(newpage);
+		pfree(state->htids);
+		pfree(state);
+		return;
+	}
+
+	/*
+	 * The line pointers' LP_DEAD bits were not carried over to the new page,
+	 * so it has no garbage anymore.
+	 */
+	if (P_HAS_GARBAGE(opaque))
+	{
+		BTPageOpaque nopaque = (BTPageOpaque) PageGetSpecialPointer(newpage);
+
+		nopaque->btpo_flags &= ~BTP_HAS_GARBAGE;
+	}
+
+	START_CRIT_SECTION();
+
+	PageRestoreTempPage(newpage, page);
+	MarkBufferDirty(buf);
+
+	/* XLOG stuff */
+	if (RelationNeedsWAL(rel))
+	{
+		XLogRecPtr	recptr;
+		xl_btree_dedup xlrec_dedup;
+
+		xlrec_dedup.nintervals = state->nintervals;
+
+		XLogBeginInsert();
+		XLogRegisterBuffer(0, buf, REGBUF_STANDARD);
+		XLogRegisterData((char *) &xlrec_dedup, SizeOfBtreeDedup);
+
+		/*
+		 * The intervals array is not in the buffer, but pretend that it is.
+		 * When XLogInsert stores the whole buffer, the array need not be
+		 * stored too.
+		 */
+		XLogRegisterBufData(0, (char *) state->intervals,
+							state->nintervals * sizeof(BTDedupInterval));
+
+		recptr = XLogInsert(RM_BTREE_ID, XLOG_BTREE_DEDUP);
+
+		PageSetLSN(page, recptr);
+	}
+
+	END_CRIT_SECTION();
+
+	elog(DEBUG2, "deduplication of block %u of index \"%s\" saved %zu bytes, need %zu",
+		 BufferGetBlockNumber(buf), RelationGetRelationName(rel),
+		 pagesaving, newitemsz);
+
+	/* be tidy */
+	pfree(state->htids);
+	pfree(state);
+}
+
+/*
+ * Create a new pending posting list tuple based on caller's base tuple.
+ *
+ * Every tuple processed by deduplication either becomes the base tuple for a
+ * posting list, or gets its heap TID(s) accepted into a pending posting list.
+ * A tuple that starts out as the base tuple for a posting list will only
+ * actually be rewritten within _bt_dedup_finish_pending() when it turns out
+ * that there are duplicates that can be merged into the base tuple.
+ */
+void
+_bt_dedup_start_pending(BTDedupState state, IndexTuple base,
+						OffsetNumber baseoff)
+{
+	Assert(state->nhtids == 0);
+	Assert(state->nitems == 0);
+
+	/*
+	 * Copy heap TID(s) from new base tuple for new candidate posting list
+	 * into working state's array
+	 */
+	if (!BTreeTupleIsPosting(base))
+	{
+		memcpy(state->htids, &base->t_tid, sizeof(ItemPointerData));
+		state->nhtids = 1;
+		state->basetupsize = IndexTupleSize(base);
+	}
+	else
+	{
+		int			nposting;
+
+		nposting = BTreeTupleGetNPosting(base);
+		memcpy(state->htids, BTreeTupleGetPosting(base),
+			   sizeof(ItemPointerData) * nposting);
+		state->nhtids = nposting;
+		/* basetupsize should not include existing posting list */
+		state->basetupsize = BTreeTupleGetPostingOffset(base);
+	}
+
+	/*
+	 * Save new base tuple itself -- it'll be needed if we actually create a
+	 * new posting list from new pending posting list.
+	 */
+	state->nitems = 1;
+	state->base = base;
+	state->baseoff = baseoff;
+}
+
+/*
+ * Save itup heap TID(s) into pending posting list where possible.
+ *
+ * Returns bool indicating if the pending posting list managed by state now
+ * includes itup's heap TID(s).  Caller must already know that itup's key is
+ * equal to that of the base tuple.
+ */
+bool
+_bt_dedup_save_htid(BTDedupState state, IndexTuple itup)
+{
+	int			nhtids;
+	ItemPointer htids;
+	Size		mergedtupsz;
+
+	if (!BTreeTupleIsPosting(itup))
+	{
+		nhtids = 1;
+		htids = &itup->t_tid;
+	}
+	else
+	{
+		nhtids = BTreeTupleGetNPosting(itup);
+		htids = BTreeTupleGetPosting(itup);
+	}
+
+	/*
+	 * Don't append (have caller finish pending posting list as-is) if
+	 * appending heap TID(s) from itup would put us over maxpostingsize limit.
+	 *
+	 * This calculation needs to match the code used within
+	 * _bt_form_posting() for new posting list tuples.
+	 */
+	mergedtupsz = MAXALIGN(state->basetupsize +
+						   (state->nhtids + nhtids) * sizeof(ItemPointerData));
+
+	if (mergedtupsz > state->maxpostingsize ||
+		state->nhtids + nhtids > BT_N_KEYS_OFFSET_MASK)
+		return false;
+
+	/*
+	 * Save heap TIDs to pending posting list tuple -- itup can be merged into
+	 * pending posting list
+	 */
+	state->nitems++;
+	memcpy(state->htids + state->nhtids, htids,
+		   sizeof(ItemPointerData) * nhtids);
+	state->nhtids += nhtids;
+
+	return true;
+}
+
+/*
+ * Finalize pending posting list tuple, and add it to the page.  Final tuple
+ * is based on saved base tuple, and saved list of heap TIDs.
+ *
+ * Returns space saving from deduplicating to make a new posting list tuple.
+ * Note that this includes line pointer overhead.  This is zero in the case
+ * where no deduplication was possible.
+ */
+Size
+_bt_dedup_finish_pending(Page newpage, BTDedupState state)
+{
+	OffsetNumber tupoff;
+	Size		tuplesz;
+	Size		spacesaving;
+
+	Assert(state->nitems > 0);
+	Assert(state->nitems <= state->nhtids);
+
+	tupoff = OffsetNumberNext(PageGetMaxOffsetNumber(newpage));
+	if (state->nitems == 1)
+	{
+		/* Use original, unchanged base tuple */
+		tuplesz = IndexTupleSize(state->base);
+		if (PageAddItem(newpage, (Item) state->base, tuplesz, tupoff,
+						false, false) == InvalidOffsetNumber)
+			elog(ERROR, "deduplication failed to add tuple to page");
+
+		spacesaving = 0;
+	}
+	else
+	{
+		IndexTuple	final;
+		Size		origsz;
+
+		/* Form a tuple with a posting list */
+		final = _bt_form_posting(state->base, state->htids, state->nhtids);
+		tuplesz = IndexTupleSize(final);
+		Assert(tuplesz <= state->maxpostingsize);
+
+		if (PageAddItem(newpage, (Item) final, tuplesz, tupoff, false,
+						false) == InvalidOffsetNumber)
+			elog(ERROR, "deduplication failed to add tuple to page");
+
+		/*
+		 * Each merged tuple cost a line pointer and its own key, and the
+		 * replacement costs one line pointer.  Work out the saving from the
+		 * number of heap TIDs, which is what the original tuples' sizes add
+		 * up to when none of them was a posting list tuple already.
+		 */
+		origsz = state->nitems * sizeof(ItemIdData) +
+			state->nitems * state->basetupsize +
+			(state->nhtids - state->nitems) * sizeof(ItemPointerData);
+		spacesaving = origsz > tuplesz + sizeof(ItemIdData) ?
+			origsz - (tuplesz + sizeof(ItemIdData)) : 0;
+
+		pfree(final);
+
+		/* Save final number of items for posting list */
+		state->intervals[state->nintervals].baseoff = state->baseoff;
+		state->intervals[state->nintervals].nitems = state->nitems;
+		/* Increment nintervals, since we wrote a new posting list tuple */
+		state->nintervals++;
+	}
+
+	/* Reset state for next pending posting list */
+	state->nhtids = 0;
+	state->nitems = 0;
+
+	return spacesaving;
+}
+
+/*
+ * Are the keys of two leaf tuples binary equal?
+ *
+ * Only the key portion of the tuples is compared, so a posting list tuple
+ * and a plain tuple with the same key are equal.  Tuples are palloc0()'d by
+ * index_form_tuple(), so alignment padding never differs between tuples
+ * with equal keys.
+ */
+bool
+_bt_dedup_keys_equal(IndexTuple itup1, IndexTuple itup2)
+{
+	Size		keysize1,
+				keysize2;
+
+	keysize1 = BTreeTupleIsPosting(itup1) ?
+		BTreeTupleGetPostingOffset(itup1) : IndexTupleSize(itup1);
+	keysize2 = BTreeTupleIsPosting(itup2) ?
+		BTreeTupleGetPostingOffset(itup2) : IndexTupleSize(itup2);
+
+	if (keysize1 != keysize2)
+		return false;
+
+	/* the null bitmap and the varlena flag must match too */
+	if ((itup1->t_info & (INDEX_NULL_MASK | INDEX_VAR_MASK)) !=
+		(itup2->t_info & (INDEX_NULL_MASK | INDEX_VAR_MASK)))
+		return false;
+
+	return memcmp((char *) itup1 + sizeof(IndexTupleData),
+				  (char *) itup2 + sizeof(IndexTupleData),
+				  keysize1 - sizeof(IndexTupleData)) == 0;
+}
+
+/*
+ * Build a posting list tuple based on caller's "base" index tuple and list of
+ * heap TIDs.  When nhtids == 1, builds a standard non-pivot tuple without a
+ * posting list.  (Posting list tuples can never have a single heap TID, partly
+ * because that ensures that deduplication always reduces final MAXALIGN()'d
+ * size of entire tuple.)
+ *
+ * The heap TIDs are stored in the order given, which is the order that the
+ * merged tuples had on the page, or that the sorted input of an index build
+ * had.  That way deduplication does not change the order in which scans
+ * return duplicates.
+ *
+ * Caller should avoid assuming that the IndexTuple-wise key representation
+ * in base is identical to the representation used within the returned tuple;
+ * only its key portion is copied.
+ */
+IndexTuple
+_bt_form_posting(IndexTuple base, ItemPointer htids, int nhtids)
+{
+	uint32		keysize,
+				newsize;
+	IndexTuple	itup;
+
+	if (BTreeTupleIsPosting(base))
+		keysize = BTreeTupleGetPostingOffset(base);
+	else
+		keysize = IndexTupleSize(base);
+
+	Assert(nhtids > 0 && nhtids <= BT_N_KEYS_OFFSET_MASK);
+
+	/* Determine final size of new tuple */
+	if (nhtids > 1)
+		newsize = MAXALIGN(keysize +
+						   nhtids * sizeof(ItemPointerData));
+	else
+		newsize = keysize;
+
+	Assert(newsize <= INDEX_SIZE_MASK);
+	Assert(newsize == MAXALIGN(newsize));
+
+	/* Allocate memory using palloc0() (matches index_form_tuple()) */
+	itup = palloc0(newsize);
+	memcpy(itup, base, keysize);
+	itup->t_info &= ~INDEX_SIZE_MASK;
+	itup->t_info |= newsize;
+	if (nhtids > 1)
+	{
+		/* Form posting list tuple */
+		BTreeTupleSetPosting(itup, nhtids, keysize);
+		memcpy(BTreeTupleGetPosting(itup), htids,
+			   sizeof(ItemPointerData) * nhtids);
+	}
+	else
+	{
+		/* Form standard non-pivot tuple */
+		itup->t_info &= ~INDEX_ALT_TID_MASK;
+		ItemPointerCopy(htids, &itup->t_tid);
+		Assert(ItemPointerIsValid(&itup->t_tid));
+	}
+
+	return itup;
+}
@@ -24,11 +24,15 @@
 #include "storage/lmgr.h"
 #include "storage/predicate.h"
 #include "storage/smgr.h"
+#include "utils/actualrangecache.h"
 #include "utils/tqual.h"
 
 /* Minimum tree height for application of fastpath optimization */
 #define BTREE_FASTPATH_MIN_LEVEL	2
 
+/* Maximum number of heap blocks visited by one _bt_bottomup_delete call */
+#define BTREE_BOTTOMUP_MAX_HEAP_BLOCKS	6
+
 typedef struct
 {
 	/* context data for _bt_checksplitloc */
@@ -87,6 +91,11 @@ static bool _bt_pgaddtup(Page page, Size itemsize, IndexTuple itup,
 static bool _bt_isequal(TupleDesc itupdesc, Page page, OffsetNumber offnum,
 			int keysz, ScanKey scankey);
 static void _bt_vacuum_one_page(Relation rel, Buffer buffer, Relation heapRel);
+static bool _bt_bottomup_delete(Relation rel, Buffer buffer, Relation heapRel,
+					int keysz, ScanKey scankey);
+static int	_bt_bottomup_tid_cmp(const void *a, const void *b);
+static int	_bt_bottomup_block_cmp(const void *a, const void *b);
+static int	_bt_bottomup_blkno_cmp(const void *a, const void *b);
 
 /*
  *	_bt_doinsert() -- Handle insertion of a single index tuple in the tree.
@@ -278,6 +287,10 @@ top:
 
 	if (checkUnique != UNIQUE_CHECK_EXISTING)
 	{
+		BTPageOpaque lpageop;
+		bool		leftmost;
+		bool		rightmost;
+
 		/*
 		 * The only conflict predicate locking cares about for indexes is when
 		 * an index tuple insert conflicts with an existing lock.  Since the
@@ -291,7 +304,17 @@ top:
 		/* do the insertion */
 		_bt_findinsertloc(rel, &buf, &offset, indnkeyatts, itup_scankey, itup,
 						  stack, heapRel);
+		lpageop = (BTPageOpaque) PageGetSpecialPointer(BufferGetPage(buf));
+		leftmost = P_LEFTMOST(lpageop);
+		rightmost = P_RIGHTMOST(lpageop);
 		_bt_insertonpg(rel, buf, InvalidBuffer, stack, itup, offset, false);
+
+		/*
+		 * The planner's cached endpoints of the index may not include the
+		 * new tuple anymore.
+		 */
+		if (leftmost || rightmost)
+			ActualRangeCacheInserted(rel, leftmost, rightmost);
 	}
 	else
 	{
@@ -553,10 +576,18 @@ _bt_check_unique(Relation rel, IndexTuple itup, Relation heapRel,
 			offset = OffsetNumberNext(offset);
 		else
 		{
-			/* If scankey == hikey we gotta check the next page too */
+			IndexTuple	hikey;
+
+			/*
+			 * If scankey == hikey we gotta check the next page too.  A high
+			 * key with truncated key attributes is never equal: those
+			 * compare as minus infinity.
+			 */
 			if (P_RIGHTMOST(opaque))
 				break;
-			if (!_bt_isequal(itupdesc, page, P_HIKEY,
+			hikey = (IndexTuple) PageGetItem(page, PageGetItemId(page, P_HIKEY));
+			if (BTreeTupleGetNAtts(hikey, rel) < indnkeyatts ||
+				!_bt_isequal(itupdesc, page, P_HIKEY,
 							 indnkeyatts, itup_scankey))
 				break;
 			/* Advance to next non-dead page --- there must be one */
@@ -613,7 +644,9 @@ _bt_check_unique(Relation rel, IndexTuple itup, Relation heapRel,
  *		any existing equal keys because of the way _bt_binsrch() works.
  *
  *		If there's not enough room in the space, we try to make room by
- *		removing any LP_DEAD tuples.
+ *		removing any LP_DEAD tuples, then by removing dead versions of the
+ *		new tuple's duplicates (see _bt_bottomup_delete), and then by
+ *		deduplicating the page.
  *
  *		On entry, *bufptr and *offsetptr point to the first legal position
  *		where the new tuple could be inserted.  The caller should hold an
@@ -768,6 +801,29 @@ _bt_findinsertloc(Relation rel,
 		vacuumed = false;
 	}
 
+	/*
+	 * If the page still doesn't have room for the new tuple, and the new
+	 * tuple has duplicates on the page, those are likely to be older versions
+	 * of the same row, left behind by UPDATEs that could not use HOT.  Check
+	 * them in the heap, and delete the ones that are dead to everyone.
+	 */
+	if (PageGetFreeSpace(page) < itemsz && P_ISLEAF(lpageop) &&
+		_bt_bottomup_delete(rel, buf, heapRel, keysz, scankey))
+		vacuumed = true;
+
+	/*
+	 * If the page still doesn't have room for the new tuple, try to avoid a
+	 * split by merging duplicates into posting list tuples.  This moves
+	 * tuples around, so the hint supplied by the caller can't be used
+	 * afterwards either.
+	 */
+	if (PageGetFreeSpace(page) < itemsz && P_ISLEAF(lpageop) &&
+		_bt_dedup_enabled(rel))
+	{
+		_bt_dedup_one_page(rel, buf, itemsz);
+		vacuumed = true;
+	}
+
 	/*
 	 * Now we are on the right page, so find the insert position. If we moved
 	 * right at all, we know we should insert at the start of the page. If we
@@ -841,7 +897,7 @@ _bt_insertonpg(Relation rel,
 		   BTreeTupleGetNAtts(itup, rel) ==
 		   IndexRelationGetNumberOfAttributes(rel));
 	Assert(P_ISLEAF(lpageop) ||
-		   BTreeTupleGetNAtts(itup, rel) ==
+		   BTreeTupleGetNAtts(itup, rel) <=
 		   IndexRelationGetNumberOfKeyAttributes(rel));
 
 	/* The caller should've finished any incomplete splits already. */
@@ -1129,6 +1185,7 @@ _bt_split(Relation rel, Buffer buf, Buffer cbuf, OffsetNumber firstright,
 	OffsetNumber i;
 	bool		isleaf;
 	IndexTuple	lefthikey;
+	bool		lhikeyformed;
 	int			indnatts = IndexRelationGetNumberOfAttributes(rel);
 	int			indnkeyatts = IndexRelationGetNumberOfKeyAttributes(rel);
 
@@ -1200,7 +1257,8 @@ _bt_split(Relation rel, Buffer buf, Buffer cbuf, OffsetNumber firstright,
 		itemid = PageGetItemId(origpage, P_HIKEY);
 		itemsz = ItemIdGetLength(itemid);
 		item = (IndexTuple) PageGetItem(origpage, itemid);
-		Assert(BTreeTupleGetNAtts(item, rel) == indnkeyatts);
+		Assert(BTreeTupleGetNAtts(item, rel) > 0 &&
+			   BTreeTupleGetNAtts(item, rel) <= indnkeyatts);
 		if (PageAddItem(rightpage, (Item) item, itemsz, rightoff,
 						false, false) == InvalidOffsetNumber)
 		{
@@ -1233,25 +1291,42 @@ _bt_split(Relation rel, Buffer buf, Buffer cbuf, OffsetNumber firstright,
 	}
 
 	/*
-	 * Truncate non-key (INCLUDE) attributes of the high key item before
-	 * inserting it on the left page.  This only needs to happen at the leaf
+	 * Truncate the high key item before inserting it on the left page: drop
+	 * non-key (INCLUDE) attributes, any posting list, and every key
+	 * attribute after the first one that distinguishes it from the last
+	 * item staying on the left page.  This only needs to happen at the leaf
 	 * level, since in general all pivot tuple values originate from leaf
 	 * level high keys.  This isn't just about avoiding unnecessary work,
-	 * though; truncating unneeded key attributes (more aggressive suffix
-	 * truncation) can only be performed at the leaf level anyway.  This is
-	 * because a pivot tuple in a grandparent page must guide a search not
-	 * only to the correct parent page, but also to the correct leaf page.
+	 * though; truncating unneeded key attributes can only be performed at
+	 * the leaf level anyway.  This is because a pivot tuple in a grandparent
+	 * page must guide a search not only to the correct parent page, but also
+	 * to the correct leaf page.
 	 */
-	if (indnatts != indnkeyatts && isleaf)
+	if (isleaf)
 	{
-		lefthikey = _bt_nonkey_truncate(rel, item);
-		itemsz = IndexTupleSize(lefthikey);
-		itemsz = MAXALIGN(itemsz);
+		IndexTuple	lastleft;
+		int			keepnatts;
+
+		if (newitemonleft && newitemoff == firstright)
+			lastleft = newitem;
+		else
+			lastleft = (IndexTuple)
+				PageGetItem(origpage,
+							PageGetItemId(origpage, OffsetNumberPrev(firstright)));
+
+		keepnatts = _bt_keep_natts(rel, lastleft, item);
+		if (keepnatts < indnatts || BTreeTupleIsPosting(item))
+			lefthikey = _bt_truncate(rel, item, keepnatts);
+		else
+			lefthikey = item;
+		itemsz = MAXALIGN(IndexTupleSize(lefthikey));
 	}
 	else
 		lefthikey = item;
+	lhikeyformed = (lefthikey != item);
 
-	Assert(BTreeTupleGetNAtts(lefthikey, rel) == indnkeyatts);
+	Assert(BTreeTupleGetNAtts(lefthikey, rel) > 0 &&
+		   BTreeTupleGetNAtts(lefthikey, rel) <= indnkeyatts);
 	if (PageAddItem(leftpage, (Item) lefthikey, itemsz, leftoff,
 					false, false) == InvalidOffsetNumber)
 	{
@@ -1474,15 +1549,16 @@ _bt_split(Relation rel, Buffer buf, Buffer cbuf, OffsetNumber firstright,
 			XLogRegisterBufData(0, (char *) newitem, MAXALIGN(newitemsz));
 
 		/* Log left page */
-		if (!isleaf || indnatts != indnkeyatts)
+		if (!isleaf || lhikeyformed)
 		{
 			/*
 			 * We must also log the left page's high key.  There are two
 			 * reasons for that: right page's leftmost key is suppressed on
-			 * non-leaf levels and in covering indexes included columns are
-			 * truncated from high keys.  Show it as belonging to the left
-			 * page buffer, so that it is not stored if XLogInsert decides it
-			 * needs a full-page image of the left page.
+			 * non-leaf levels, and at the leaf level the high key may have
+			 * been truncated (see above), so it can differ from the right
+			 * page's first item.  Show it as belonging to the left page
+			 * buffer, so that it is not stored if XLogInsert decides it needs
+			 * a full-page image of the left page.
 			 */
 			itemid = PageGetItemId(origpage, P_HIKEY);
 			item = (IndexTuple) PageGetItem(origpage, itemid);
@@ -2196,7 +2272,8 @@ _bt_newroot(Relation rel, Buffer lbuf, Buffer rbuf)
 	/*
 	 * insert the right page pointer into the new root page.
 	 */
-	Assert(BTreeTupleGetNAtts(right_item, rel) ==
+	Assert(BTreeTupleGetNAtts(right_item, rel) > 0 &&
+		   BTreeTupleGetNAtts(right_item, rel) <=
 		   IndexRelationGetNumberOfKeyAttributes(rel));
 	if (PageAddItem(rootpage, (Item) right_item, right_item_sz, P_FIRSTKEY,
 					false, false) == InvalidOffsetNumber)
@@ -2403,3 +2480,216 @@ _bt_vacuum_one_page(Relation rel, Buffer buffer, Relation heapRel)
 	 * the page.
 	 */
 }
+
+/*
+ * A heap TID of one of the duplicates considered by _bt_bottomup_delete,
+ * and the offset of the leaf item it came from
+ */
+typedef struct BTBottomUpTid
+{
+	ItemPointerData htid;
+	OffsetNumber idxoff;
+} BTBottomUpTid;
+
+/* A run of BTBottomUpTids that point to the same heap block */
+typedef struct BTBottomUpBlock
+{
+	BlockNumber blkno;
+	int			first;			/* index of first TID in the sorted array */
+	int			ntids;
+} BTBottomUpBlock;
+
+/*
+ * _bt_bottomup_delete - delete dead versions of the new tuple's duplicates.
+ *
+ * When an UPDATE cannot use HOT, every index gets a new entry, even the
+ * indexes whose key did not change.  The old entries stay until VACUUM, or
+ * until a scan happens to find them dead and marks them LP_DEAD, so a hot
+ * row can fill a leaf page with its old versions and make it split.  This
+ * is called before that happens: the items on the page that are equal to the
+ * new tuple's key (scankey) are checked against the heap, and those whose
+ * HOT chains are dead to all transactions are deleted, just like LP_DEAD
+ * items in _bt_vacuum_one_page.
+ *
+ * The heap TIDs are visited in heap block order, one buffer lock per block.
+ * To bound the cost of a single insertion, only the
+ * BTREE_BOTTOMUP_MAX_HEAP_BLOCKS heap blocks that the most TIDs point to are
+ * visited; items with a TID on any other block are left alone.  A posting
+ * list tuple is only deleted if all of its heap TIDs are dead.
+ *
+ * Returns true if any items were deleted.
+ */
+static bool
+_bt_bottomup_delete(Relation rel, Buffer buffer, Relation heapRel,
+					int keysz, ScanKey scankey)
+{
+	Page		page = BufferGetPage(buffer);
+	BTPageOpaque opaque = (BTPageOpaque) PageGetSpecialPointer(page);
+	TupleDesc	itupdesc = RelationGetDescr(rel);
+	OffsetNumber dupoff,
+				endoff,
+				offnum,
+				maxoff;
+	OffsetNumber deletable[MaxIndexTuplesPerPage];
+	int			ndeletable = 0;
+	bool		keep[MaxIndexTuplesPerPage + 1];
+	BTBottomUpTid *tids;
+	BTBottomUpBlock *blocks;
+	int			ntids = 0;
+	int			nblocks = 0;
+	int			i;
+	SnapshotData SnapshotNonVacuumable;
+
+	Assert(P_ISLEAF(opaque));
+
+	/* The duplicates start at the first item >= scankey */
+	dupoff = _bt_binsrch(rel, buffer, keysz, scankey, false);
+	maxoff = PageGetMaxOffsetNumber(page);
+
+	/* Collect the heap TIDs of all the duplicates */
+	tids = (BTBottomUpTid *) palloc(sizeof(BTBottomUpTid) * MaxTIDsPerBTreePage);
+	memset(keep, 0, sizeof(keep));
+	for (offnum = dupoff;
+		 offnum <= maxoff && _bt_isequal(itupdesc, page, offnum, keysz, scankey);
+		 offnum = OffsetNumberNext(offnum))
+	{
+		ItemId		itemid = PageGetItemId(page, offnum);
+		IndexTuple	itup;
+
+		/* Items already known to be dead need no heap access */
+		if (ItemIdIsDead(itemid))
+			continue;
+
+		itup = (IndexTuple) PageGetItem(page, itemid);
+		for (i = 0; i < BTreeTupleGetNHeapTIDs(itup); i++)
+		{
+			tids[ntids].htid = *BTreeTupleGetHeapTIDN(itup, i);
+			tids[ntids].idxoff = offnum;
+			ntids++;
+		}
+	}
+	endoff = offnum;
+
+	if (ntids == 0)
+	{
+		pfree(tids);
+		return false;
+	}
+
+	/* Group the TIDs by heap block, and rank blocks by number of TIDs */
+	qsort(tids, ntids, sizeof(BTBottomUpTid), _bt_bottomup_tid_cmp);
+	blocks = (BTBottomUpBlock *) palloc(sizeof(BTBottomUpBlock) * ntids);
+	for (i = 0; i < ntids; i++)
+	{
+		BlockNumber blkno = ItemPointerGetBlockNumber(&tids[i].htid);
+
+		if (nblocks == 0 || blocks[nblocks - 1].blkno != blkno)
+		{
+			blocks[nblocks].blkno = blkno;
+			blocks[nblocks].first = i;
+			blocks[nblocks].ntids = 0;
+			nblocks++;
+		}
+		blocks[nblocks - 1].ntids++;
+	}
+	qsort(blocks, nblocks, sizeof(BTBottomUpBlock), _bt_bottomup_block_cmp);
+
+	/* Items with a TID on a block we won't visit must be kept */
+	for (i = BTREE_BOTTOMUP_MAX_HEAP_BLOCKS; i < nblocks; i++)
+	{
+		int			j;
+
+		for (j = 0; j < blocks[i].ntids; j++)
+			keep[tids[blocks[i].first + j].idxoff] = true;
+	}
+	nblocks = Min(nblocks, BTREE_BOTTOMUP_MAX_HEAP_BLOCKS);
+
+	/* Visit the chosen heap blocks, in block order */
+	qsort(blocks, nblocks, sizeof(BTBottomUpBlock), _bt_bottomup_blkno_cmp);
+	InitNonVacuumableSnapshot(SnapshotNonVacuumable, RecentGlobalXmin);
+	for (i = 0; i < nblocks; i++)
+	{
+		Buffer		hbuffer;
+		int			j;
+
+		hbuffer = ReadBuffer(heapRel, blocks[i].blkno);
+		LockBuffer(hbuffer, BUFFER_LOCK_SHARE);
+
+		for (j = 0; j < blocks[i].ntids; j++)
+		{
+			BTBottomUpTid *tid = &tids[blocks[i].first + j];
+			ItemPointerData htid = tid->htid;
+			HeapTupleData heapTuple;
+			bool		all_dead;
+
+			if (keep[tid->idxoff])
+				continue;
+
+			if (heap_hot_search_buffer(&htid, heapRel, hbuffer,
+									   &SnapshotNonVacuumable, &heapTuple,
+									   &all_dead, true) ||
+				!all_dead)
+				keep[tid->idxoff] = true;
+		}
+
+		UnlockReleaseBuffer(hbuffer);
+	}
+
+	/* Delete the duplicates that turned out to be dead */
+	for (offnum = dupoff; offnum < endoff; offnum = OffsetNumberNext(offnum))
+	{
+		if (!keep[offnum])
+			deletable[ndeletable++] = offnum;
+	}
+
+	if (ndeletable > 0)
+		_bt_delitems_delete(rel, buffer, deletable, ndeletable, heapRel);
+
+	pfree(blocks);
+	pfree(tids);
+
+	return ndeletable > 0;
+}
+
+/*
+ * qsort comparator for BTBottomUpTids, in heap TID order
+ */
+static int
+_bt_bottomup_tid_cmp(const void *a, const void *b)
+{
+	const BTBottomUpTid *ta = (const BTBottomUpTid *) a;
+	const BTBottomUpTid *tb = (const BTBottomUpTid *) b;
+
+	return ItemPointerCompare((ItemPointer) &ta->htid,
+							  (ItemPointer) &tb->htid);
+}
+
+/*
+ * qsort comparator for BTBottomUpBlocks: most TIDs first, then block order
+ */
+static int
+_bt_bottomup_block_cmp(const void *a, const void *b)
+{
+	const BTBottomUpBlock *ba = (const BTBottomUpBlock *) a;
+	const BTBottomUpBlock *bb = (const BTBottomUpBlock *) b;
+
+	if (ba->ntids != bb->ntids)
+		return (ba->ntids > bb->ntids) ? -1 : 1;
+	if (ba->blkno != bb->blkno)
+		return (ba->blkno < bb->blkno) ? -1 : 1;
+	return 0;
+}
+
+/*
+ * qsort comparator for BTBottomUpBlocks, in block order
+ */
+static int
+_bt_bottomup_blkno_cmp(const void *a, const void *b)
+{
+	const BTBottomUpBlock *ba = (const BTBottomUpBlock *) a;
+	const BTBottomUpBlock *bb = (const BTBottomUpBlock *) b;
+
+	if (ba->blkno != bb->blkno)
+		return (ba->blkno < bb->blkno) ? -1 : 1;
+	return 0;
+}
@@ -951,19 +951,58 @@ _bt_page_recyclable(Page page)
  * for the last block in the index, whether or not it contained any items
  * to be removed. This allows us to scan right up to end of index to
  * ensure correct locking.
+ *
+ * The nupdated posting list tuples at offsets updatedoffsets are replaced
+ * with the versions in updated, which lack the heap TIDs that VACUUM
+ * removed.  Replacing happens before deleting, since deleting itemnos moves
+ * the items that follow them.
  */
 void
 _bt_delitems_vacuum(Relation rel, Buffer buf,
 					OffsetNumber *itemnos, int nitems,
-					BlockNumber lastBlockVacuumed)
+					OffsetNumber *updatedoffsets, IndexTuple *updated,
+					int nupdated, BlockNumber lastBlockVacuumed)
 {
 	Page		page = BufferGetPage(buf);
 	BTPageOpaque opaque;
+	char	   *updatedbuf = NULL;
+	Size		updatedbuflen = 0;
+	int			i;
+
+	/*
+	 * Gather the updated tuples into a single chunk for the WAL record, since
+	 * there could be too many of them to register each separately
+	 */
+	if (nupdated > 0 && RelationNeedsWAL(rel))
+	{
+		Size		offset = 0;
+
+		for (i = 0; i < nupdated; i++)
+			updatedbuflen += MAXALIGN(IndexTupleSize(updated[i]));
+
+		updatedbuf = palloc(updatedbuflen);
+		for (i = 0; i < nupdated; i++)
+		{
+			Size		itemsz = MAXALIGN(IndexTupleSize(updated[i]));
+
+			memcpy(updatedbuf + offset, updated[i], itemsz);
+			offset += itemsz;
+		}
+	}
 
 	/* No ereport(ERROR) until changes are logged */
 	START_CRIT_SECTION();
 
 	/* Fix the page */
+	for (i = 0; i < nupdated; i++)
+	{
+		Size		itemsz = MAXALIGN(IndexTupleSize(updated[i]));
+
+		if (!PageIndexTupleOverwrite(page, updatedoffsets[i],
+									 (Item) updated[i], itemsz))
+			elog(PANIC, "failed to update partially dead item in block %u of index \"%s\"",
+				 BufferGetBlockNumber(buf), RelationGetRelationName(rel));
+	}
 	if (nitems > 0)
 		PageIndexMultiDelete(page, itemnos, nitems);
 
@@ -992,6 +1031,8 @@ _bt_delitems_vacuum(Relation rel, Buffer buf,
 		xl_btree_vacuum xlrec_vacuum;
 
 		xlrec_vacuum.lastBlockVacuumed = lastBlockVacuumed;
+		xlrec_vacuum.ndeleted = nitems;
+		xlrec_vacuum.nupdated = nupdated;
 
 		XLogBeginInsert();
 		XLogRegisterBuffer(0, buf, REGBUF_STANDARD);
@@ -1005,12 +1046,23 @@ _bt_delitems_vacuum(Relation rel, Buffer buf,
 		if (nitems > 0)
 			XLogRegisterBufData(0, (char *) itemnos, nitems * sizeof(OffsetNumber));
 
+		/* Likewise for the offsets and new versions of updated tuples */
+		if (nupdated > 0)
+		{
+			XLogRegisterBufData(0, (char *) updatedoffsets,
+								nupdated * sizeof(OffsetNumber));
+			XLogRegisterBufData(0, updatedbuf, updatedbuflen);
+		}
+
 		recptr = XLogInsert(RM_BTREE_ID, XLOG_BTREE_VACUUM);
 
 		PageSetLSN(page, recptr);
 	}
 
 	END_CRIT_SECTION();
+
+	if (updatedbuf != NULL)
+		pfree(updatedbuf);
 }
 
 /*
@@ -1423,7 +1475,7 @@ _bt_pagedel(Relation rel, Buffer buf)
 				itup_scankey = _bt_mkscankey(rel, targetkey);
 				/* find the leftmost leaf page containing this key */
 				stack = _bt_search(rel,
-								   IndexRelationGetNumberOfKeyAttributes(rel),
+								   BTreeTupleGetNKeyAtts(targetkey, rel),
 								   itup_scankey, false, &lbuf, BT_READ, NULL);
 				/* don't need a pin on the page */
 				_bt_relbuf(rel, lbuf);
@@ -96,6 +96,8 @@ static void btvacuumscan(IndexVacuumInfo *info, IndexBulkDeleteResult *stats,
 			 BTCycleId cycleid, TransactionId *oldestBtpoXact);
 static void btvacuumpage(BTVacState *vstate, BlockNumber blkno,
 			 BlockNumber orig_blkno);
+static ItemPointer btvacuumposting(BTVacState *vstate, IndexTuple posting,
+				int *nremaining);
 
 
 /*
@@ -122,6 +124,7 @@ bthandler(PG_FUNCTION_ARGS)
 	amroutine->ampredlocks = true;
 	amroutine->amcanparallel = true;
 	amroutine->amcaninclude = true;
+	amroutine->amsummarizing = false;
 	amroutine->amkeytype = InvalidOid;
 
 	amroutine->ambuild = btbuild;
@@ -233,7 +236,17 @@ btgettuple(IndexScanDesc scan, ScanDirection dir)
 		_bt_start_array_keys(scan, dir);
 	}
 
-	/* This loop handles advancing to the next array elements, if any */
+	/* Likewise, a skip scan starts at the first value of its first column */
+	if (so->skipKey != NULL && !BTScanPosIsValid(so->currPos))
+	{
+		if (!_bt_start_skip_key(scan, dir))
+			return false;
+	}
+
+	/*
+	 * This loop handles advancing to the next array elements, if any, and
+	 * then to the next value of a skip scan's first column.
+	 */
 	do
 	{
 		/*
@@ -261,8 +274,8 @@ btgettuple(IndexScanDesc scan, ScanDirection dir)
 				 */
 				if (so->killedItems == NULL)
 					so->killedItems = (int *)
-						palloc(MaxIndexTuplesPerPage * sizeof(int));
-				if (so->numKilled < MaxIndexTuplesPerPage)
+						palloc(MaxTIDsPerBTreePage * sizeof(int));
+				if (so->numKilled < MaxTIDsPerBTreePage)
 					so->killedItems[so->numKilled++] = so->currPos.itemIndex;
 			}
 
@@ -275,8 +288,13 @@ btgettuple(IndexScanDesc scan, ScanDirection dir)
 		/* If we have a tuple, return it ... */
 		if (res)
 			break;
-		/* ... otherwise see if we have more array keys to deal with */
-	} while (so->numArrayKeys && _bt_advance_array_keys(scan, dir));
+		/* ... otherwise see if we have more array or skip keys to deal with */
+	} while ((so->numArrayKeys && _bt_advance_array_keys(scan, dir)) ||
+			 (so->skipKey != NULL && _bt_advance_skip_key(scan, dir)));
+
+	/* ... after starting reads of the heap blocks the caller needs next */
+	if (res && scan->xs_prefetch_maximum > 0)
+		_bt_prefetch_heap(scan, dir);
 
 	return res;
 }
@@ -303,7 +321,14 @@ btgetbitmap(IndexScanDesc scan, TIDBitmap *tbm)
 		_bt_start_array_keys(scan, ForwardScanDirection);
 	}
 
-	/* This loop handles advancing to the next array elements, if any */
+	/* Likewise for a skip scan */
+	if (so->skipKey != NULL)
+	{
+		if (!_bt_start_skip_key(scan, ForwardScanDirection))
+			return ntids;
+	}
+
+	/* This loop handles advancing to the next array or skip keys, if any */
 	do
 	{
 		/* Fetch the first page & tuple */
@@ -333,8 +358,11 @@ btgetbitmap(IndexScanDesc scan, TIDBitmap *tbm)
 				ntids++;
 			}
 		}
-		/* Now see if we have more array keys to deal with */
-	} while (so->numArrayKeys && _bt_advance_array_keys(scan, ForwardScanDirection));
+		/* Now see if we have more array or skip keys to deal with */
+	} while ((so->numArrayKeys &&
+			  _bt_advance_array_keys(scan, ForwardScanDirection)) ||
+			 (so->skipKey != NULL &&
+			  _bt_advance_skip_key(scan, ForwardScanDirection)));
 
 	return ntids;
 }
@@ -358,8 +386,9 @@ btbeginscan(Relation rel, int nkeys, int norderbys)
 	so = (BTScanOpaque) palloc(sizeof(BTScanOpaqueData));
 	BTScanPosInvalidate(so->currPos);
 	BTScanPosInvalidate(so->markPos);
+	/* leave room for a skip scan's extra key */
 	if (scan->numberOfKeys > 0)
-		so->keyData = (ScanKey) palloc(scan->numberOfKeys * sizeof(ScanKeyData));
+		so->keyData = (ScanKey) palloc((scan->numberOfKeys + 1) * sizeof(ScanKeyData));
 	else
 		so->keyData = NULL;
 
@@ -367,10 +396,14 @@ btbeginscan(Relation rel, int nkeys, int norderbys)
 	so->numArrayKeys = 0;
 	so->arrayKeys = NULL;
 	so->arrayContext = NULL;
+	so->skipKey = NULL;
 
 	so->killedItems = NULL;		/* until needed */
 	so->numKilled = 0;
 
+	so->prefetchTarget = 0;
+	so->prefetchBlock = InvalidBlockNumber;
+
 	/*
 	 * We don't know yet whether the scan will be index-only, so we do not
 	 * allocate the tuple workspace arrays until btrescan.  However, we set up
@@ -406,6 +439,8 @@ btrescan(IndexScanDesc scan, ScanKey scankey, int nscankeys,
 
 	so->markItemIndex = -1;
 	so->arrayKeyCount = 0;
+	so->prefetchTarget = 0;
+	so->prefetchBlock = InvalidBlockNumber;
 	BTScanPosUnpinIfPinned(so->markPos);
 	BTScanPosInvalidate(so->markPos);
 
@@ -443,6 +478,9 @@ btrescan(IndexScanDesc scan, ScanKey scankey, int nscankeys,
 
 	/* If any keys are SK_SEARCHARRAY type, set up array-key info */
 	_bt_preprocess_array_keys(scan);
+
+	/* And set up a skip scan, if requested and useful */
+	_bt_preprocess_skip_key(scan);
 }
 
 /*
@@ -470,7 +508,7 @@ btendscan(IndexScanDesc scan)
 	/* Release storage */
 	if (so->keyData != NULL)
 		pfree(so->keyData);
-	/* so->arrayKeyData and so->arrayKeys are in arrayContext */
+	/* so->arrayKeyData, so->arrayKeys and so->skipKey are in arrayContext */
 	if (so->arrayContext != NULL)
 		MemoryContextDelete(so->arrayContext);
 	if (so->killedItems != NULL)
@@ -506,9 +544,11 @@ btmarkpos(IndexScanDesc scan)
 		so->markItemIndex = -1;
 	}
 
-	/* Also record the current positions of any array keys */
+	/* Also record the current positions of any array and skip keys */
 	if (so->numArrayKeys)
 		_bt_mark_array_keys(scan);
+	if (so->skipKey != NULL)
+		_bt_mark_skip_key(scan);
 }
 
 /*
@@ -519,9 +559,11 @@ btrestrpos(IndexScanDesc scan)
 {
 	BTScanOpaque so = (BTScanOpaque) scan->opaque;
 
-	/* Restore the marked positions of any array keys */
+	/* Restore the marked positions of any array and skip keys */
 	if (so->numArrayKeys)
 		_bt_restore_array_keys(scan);
+	if (so->skipKey != NULL)
+		_bt_restore_skip_key(scan);
 
 	if (so->markItemIndex >= 0)
 	{
@@ -1060,7 +1102,8 @@ btvacuumscan(IndexVacuumInfo *info, IndexBulkDeleteResult *stats,
 								 RBM_NORMAL, info->strategy);
 		LockBufferForCleanup(buf);
 		_bt_checkpage(rel, buf);
-		_bt_delitems_vacuum(rel, buf, NULL, 0, vstate.lastBlockVacuumed);
+		_bt_delitems_vacuum(rel, buf, NULL, 0, NULL, NULL, 0,
+							vstate.lastBlockVacuumed);
 		_bt_relbuf(rel, buf);
 	}
 
@@ -1181,6 +1224,11 @@ restart:
 	{
 		OffsetNumber deletable[MaxOffsetNumber];
 		int			ndeletable;
+		OffsetNumber updatedoffsets[MaxIndexTuplesPerPage];
+		IndexTuple	updated[MaxIndexTuplesPerPage];
+		int			nupdatable;
+		int			nhtidsdead,
+					nhtidslive;
 		OffsetNumber offnum,
 					minoff,
 					maxoff;
@@ -1220,6 +1268,9 @@ restart:
 		 * callback function.
 		 */
 		ndeletable = 0;
+		nupdatable = 0;
+		nhtidsdead = 0;
+		nhtidslive = 0;
 		minoff = P_FIRSTDATAKEY(opaque);
 		maxoff = PageGetMaxOffsetNumber(page);
 		if (callback)
@@ -1256,17 +1307,55 @@ restart:
 				 * applies to *any* type of index that marks index tuples as
 				 * killed.
 				 */
-				if (callback(htup, callback_state))
-					deletable[ndeletable++] = offnum;
+				if (!BTreeTupleIsPosting(itup))
+				{
+					if (callback(htup, callback_state))
+					{
+						deletable[ndeletable++] = offnum;
+						nhtidsdead++;
+					}
+					else
+						nhtidslive++;
+				}
+				else
+				{
+					ItemPointer remaining;
+					int			nremaining;
+
+					/*
+					 * A posting list tuple is deleted when all of its heap
+					 * TIDs are dead, and replaced with a smaller version of
+					 * itself when only some of them are
+					 */
+					remaining = btvacuumposting(vstate, itup, &nremaining);
+					if (nremaining == 0)
+						deletable[ndeletable++] = offnum;
+					else if (remaining != NULL)
+					{
+						Assert(nupdatable < MaxIndexTuplesPerPage);
+						updatedoffsets[nupdatable] = offnum;
+						updated[nupdatable] = _bt_form_posting(itup, remaining,
+															   nremaining);
+						nupdatable++;
+					}
+					if (remaining != NULL)
+						pfree(remaining);
+					nhtidsdead += BTreeTupleGetNPosting(itup) - nremaining;
+					nhtidslive += nremaining;
+				}
 			}
 		}
+		else
+			nhtidslive = maxoff - minoff + 1;
 
 		/*
 		 * Apply any needed deletes.  We issue just one _bt_delitems_vacuum()
 		 * call per page, so as to minimize WAL traffic.
 		 */
-		if (ndeletable > 0)
+		if (ndeletable > 0 || nupdatable > 0)
 		{
+			int			i;
+
 			/*
 			 * Notice that the issued XLOG_BTREE_VACUUM WAL record includes
 			 * all information to the replay code to allow it to get a cleanup
@@ -1282,6 +1371,7 @@ restart:
 			 * that.
 			 */
 			_bt_delitems_vacuum(rel, buf, deletable, ndeletable,
+								updatedoffsets, updated, nupdatable,
 								vstate->lastBlockVacuumed);
 
 			/*
@@ -1291,9 +1381,12 @@ restart:
 			if (blkno > vstate->lastBlockVacuumed)
 				vstate->lastBlockVacuumed = blkno;
 
-			stats->tuples_removed += ndeletable;
+			stats->tuples_removed += nhtidsdead;
 			/* must recompute maxoff */
 			maxoff = PageGetMaxOffsetNumber(page);
+
+			for (i = 0; i < nupdatable; i++)
+				pfree(updated[i]);
 		}
 		else
 		{
@@ -1323,7 +1416,7 @@ restart:
 		if (minoff > maxoff)
 			delete_now = (blkno == orig_blkno);
 		else
-			stats->num_index_tuples += maxoff - minoff + 1;
+			stats->num_index_tuples += nhtidslive;
 	}
 
 	if (delete_now)
@@ -1366,6 +1459,47 @@ restart:
 	}
 }
 
+/*
+ * btvacuumposting --- determine which heap TIDs of a posting list tuple are
+ * still needed
+ *
+ * Calls the bulk delete callback for each heap TID of the posting list tuple.
+ * Returns NULL if all of them are still live, else a palloc'd array of the
+ * ones that are, and sets *nremaining to the number of live TIDs.
+ */
+static ItemPointer
+btvacuumposting(BTVacState *vstate, IndexTuple posting, int *nremaining)
+{
+	int			nitem = BTreeTupleGetNPosting(posting);
+	ItemPointer items = BTreeTupleGetPosting(posting);
+	ItemPointer remaining = NULL;
+	int			live = 0;
+	int			i;
+
+	for (i = 0; i < nitem; i++)
+	{
+		if (!vstate->callback(items + i, vstate->callback_state))
+		{
+			/* Live heap TID */
+			if (remaining != NULL)
+				remaining[live] = items[i];
+			live++;
+		}
+		else if (remaining == NULL)
+		{
+			/*
+			 * First dead heap TID.  Copy the live ones seen so far into a new
+			 * array.
+			 */
+			remaining = palloc(sizeof(ItemPointerData) * nitem);
+			memcpy(remaining, items, sizeof(ItemPointerData) * live);
+		}
+	}
+
+	*nremaining = live;
+	return remaining;
+}
+
 /*
  *	btcanreturn() -- Check whether btree indexes support index-only scans.
  *
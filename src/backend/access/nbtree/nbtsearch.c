@@ -29,6 +29,12 @@ static bool _bt_readpage(IndexScanDesc scan, ScanDirection dir,
 			 OffsetNumber offnum);
 static void _bt_saveitem(BTScanOpaque so, int itemIndex,
 			 OffsetNumber offnum, IndexTuple itup);
+static int _bt_setuppostingitems(BTScanOpaque so, int itemIndex,
+					  OffsetNumber offnum, ItemPointer heapTid,
+					  IndexTuple itup);
+static inline void _bt_savepostingitem(BTScanOpaque so, int itemIndex,
+					OffsetNumber offnum, ItemPointer heapTid,
+					int tupleOffset);
 static bool _bt_steppage(IndexScanDesc scan, ScanDirection dir);
 static bool _bt_readnextpage(IndexScanDesc scan, BlockNumber blkno, ScanDirection dir);
 static bool _bt_parallel_readpage(IndexScanDesc scan, BlockNumber blkno,
@@ -452,6 +458,10 @@ _bt_binsrch(Relation rel,
  * does not matter.  This convention allows us to implement the Lehman and
  * Yao convention that the first down-link pointer is before the first key.
  * See backend/access/nbtree/README for details.
+ *
+ * Similarly, key attributes that were truncated away from a pivot tuple (see
+ * _bt_keep_natts()) are treated as minus infinity: if the scankey is equal
+ * to all the attributes the pivot kept but has more, it is greater.
  *----------
  */
 int32
@@ -464,6 +474,7 @@ _bt_compare(Relation rel,
 	TupleDesc	itupdesc = RelationGetDescr(rel);
 	BTPageOpaque opaque = (BTPageOpaque) PageGetSpecialPointer(page);
 	IndexTuple	itup;
+	int			ncmpkey;
 	int			i;
 
 	Assert(_bt_check_natts(rel, page, offnum));
@@ -489,7 +500,8 @@ _bt_compare(Relation rel,
 	 * _bt_first).
 	 */
 
-	for (i = 1; i <= keysz; i++)
+	ncmpkey = Min(keysz, BTreeTupleGetNAtts(itup, rel));
+	for (i = 1; i <= ncmpkey; i++)
 	{
 		Datum		datum;
 		bool		isNull;
@@ -540,6 +552,10 @@ _bt_compare(Relation rel,
 		scankey++;
 	}
 
+	/* scankey is greater if the rest of the tuple's key is minus infinity */
+	if (ncmpkey < keysz)
+		return 1;
+
 	/* if we get here, the keys are equal */
 	return 0;
 }
@@ -1193,6 +1209,72 @@ _bt_next(IndexScanDesc scan, ScanDirection dir)
 	return true;
 }
 
+/*
+ *	_bt_prefetch_heap() -- Prefetch heap blocks the scan will fetch next.
+ *
+ *		Called after an item has been returned, when the caller asked for
+ *		prefetching by setting scan->xs_prefetch_maximum.  We issue prefetch
+ *		requests for the heap blocks of the items in so->currPos that follow
+ *		the current one, up to so->prefetchTarget items ahead of it, so that
+ *		the heap fetches of a scan that misses the cache don't each wait for
+ *		a read in turn.  Like a bitmap heap scan, the distance starts small
+ *		and grows with each item returned, so that a scan stopped early by a
+ *		LIMIT doesn't read far past the rows it needs.
+ *
+ *		Only the items already read from the current leaf page are looked at.
+ *		Consecutive items pointing to the same heap block (as in a scan of a
+ *		well-correlated index) are only prefetched once.
+ */
+void
+_bt_prefetch_heap(IndexScanDesc scan, ScanDirection dir)
+{
+#ifdef USE_PREFETCH
+	BTScanOpaque so = (BTScanOpaque) scan->opaque;
+	BTScanPos	pos = &so->currPos;
+	int			maximum = scan->xs_prefetch_maximum;
+	int			i;
+
+	if (so->prefetchTarget < maximum)
+		so->prefetchTarget = (so->prefetchTarget == 0) ? 1 :
+			Min(so->prefetchTarget * 2, maximum);
+
+	if (ScanDirectionIsForward(dir))
+	{
+		int			last = Min(pos->itemIndex + so->prefetchTarget,
+							   pos->lastItem);
+
+		for (i = Max(pos->prefetchItem, pos->itemIndex + 1); i <= last; i++)
+		{
+			BlockNumber blkno = ItemPointerGetBlockNumber(&pos->items[i].heapTid);
+
+			if (blkno != so->prefetchBlock)
+			{
+				PrefetchBuffer(scan->heapRelation, MAIN_FORKNUM, blkno);
+				so->prefetchBlock = blkno;
+			}
+		}
+		pos->prefetchItem = Max(pos->prefetchItem, last + 1);
+	}
+	else
+	{
+		int			first = Max(pos->itemIndex - so->prefetchTarget,
+								pos->firstItem);
+
+		for (i = Min(pos->prefetchItem, pos->itemIndex - 1); i >= first; i--)
+		{
+			BlockNumber blkno = ItemPointerGetBlockNumber(&pos->items[i].heapTid);
+
+			if (blkno != so->prefetchBlock)
+			{
+				PrefetchBuffer(scan->heapRelation, MAIN_FORKNUM, blkno);
+				so->prefetchBlock = blkno;
+			}
+		}
+		pos->prefetchItem = Min(pos->prefetchItem, first - 1);
+	}
+#endif							/* USE_PREFETCH */
+}
+
 /*
  *	_bt_readpage() -- Load data from current index page into so->currPos
  *
@@ -1287,28 +1369,57 @@ _bt_readpage(IndexScanDesc scan, ScanDirection dir, OffsetNumber offnum)
 			if (itup != NULL)
 			{
 				/* tuple passes all scan key conditions, so remember it */
-				_bt_saveitem(so, itemIndex, offnum, itup);
-				itemIndex++;
+				if (!BTreeTupleIsPosting(itup))
+				{
+					_bt_saveitem(so, itemIndex, offnum, itup);
+					itemIndex++;
+				}
+				else
+				{
+					int			tupleOffset;
+					int			i;
+
+					/*
+					 * Set up state to return posting list, and remember first
+					 * TID
+					 */
+					tupleOffset =
+						_bt_setuppostingitems(so, itemIndex, offnum,
+											  BTreeTupleGetPostingN(itup, 0),
+											  itup);
+					itemIndex++;
+					/* Remember additional TIDs */
+					for (i = 1; i < BTreeTupleGetNPosting(itup); i++)
+					{
+						_bt_savepostingitem(so, itemIndex, offnum,
+											BTreeTupleGetPostingN(itup, i),
+											tupleOffset);
+						itemIndex++;
+					}
+				}
 			}
 			if (!continuescan)
 			{
 				/* there can't be any more matches, so stop */
 				so->currPos.moreRight = false;
+				if (so->skipKey != NULL)
+					_bt_skip_note_next(scan, dir, page, offnum);
 				break;
 			}
 
 			offnum = OffsetNumberNext(offnum);
 		}
 
-		Assert(itemIndex <= MaxIndexTuplesPerPage);
+		Assert(itemIndex <= MaxTIDsPerBTreePage);
 		so->currPos.firstItem = 0;
 		so->currPos.lastItem = itemIndex - 1;
 		so->currPos.itemIndex = 0;
+		so->currPos.prefetchItem = 0;
 	}
 	else
 	{
 		/* load items[] in descending order */
-		itemIndex = MaxIndexTuplesPerPage;
+		itemIndex = MaxTIDsPerBTreePage;
 
 		offnum = Min(offnum, maxoff);
 
@@ -1318,13 +1429,47 @@ _bt_readpage(IndexScanDesc scan, ScanDirection dir, OffsetNumber offnum)
 			if (itup != NULL)
 			{
 				/* tuple passes all scan key conditions, so remember it */
-				itemIndex--;
-				_bt_saveitem(so, itemIndex, offnum, itup);
+				if (!BTreeTupleIsPosting(itup))
+				{
+					itemIndex--;
+					_bt_saveitem(so, itemIndex, offnum, itup);
+				}
+				else
+				{
+					int			tupleOffset;
+					int			i;
+
+					/*
+					 * Set up state to return posting list, and remember first
+					 * TID.
+					 *
+					 * Note that we deliberately save/return items from
+					 * posting lists in posting list order for backwards
+					 * scans.  This allows _bt_killitems() to make a
+					 * consistent assumption about the order of items
+					 * associated with the same posting list tuple.
+					 */
+					itemIndex--;
+					tupleOffset =
+						_bt_setuppostingitems(so, itemIndex, offnum,
+											  BTreeTupleGetPostingN(itup, 0),
+											  itup);
+					/* Remember additional TIDs */
+					for (i = 1; i < BTreeTupleGetNPosting(itup); i++)
+					{
+						itemIndex--;
+						_bt_savepostingitem(so, itemIndex, offnum,
+											BTreeTupleGetPostingN(itup, i),
+											tupleOffset);
+					}
+				}
 			}
 			if (!continuescan)
 			{
 				/* there can't be any more matches, so stop */
 				so->currPos.moreLeft = false;
+				if (so->skipKey != NULL)
+					_bt_skip_note_next(scan, dir, page, offnum);
 				break;
 			}
 
@@ -1333,8 +1478,9 @@ _bt_readpage(IndexScanDesc scan, ScanDirection dir, OffsetNumber offnum)
 
 		Assert(itemIndex >= 0);
 		so->currPos.firstItem = itemIndex;
-		so->currPos.lastItem = MaxIndexTuplesPerPage - 1;
-		so->currPos.itemIndex = MaxIndexTuplesPerPage - 1;
+		so->currPos.lastItem = MaxTIDsPerBTreePage - 1;
+		so->currPos.itemIndex = MaxTIDsPerBTreePage - 1;
+		so->currPos.prefetchItem = MaxTIDsPerBTreePage - 1;
 	}
 
 	return (so->currPos.firstItem <= so->currPos.lastItem);
@@ -1359,6 +1505,74 @@ _bt_saveitem(BTScanOpaque so, int itemIndex,
 	}
 }
 
+/*
+ * Setup state to save TIDs/items from a single posting list tuple.
+ *
+ * Saves an index item into so->currPos.items[itemIndex] for TID that is
+ * returned to scan first.  Second or subsequent TIDs for posting list should
+ * be saved by calling _bt_savepostingitem().
+ *
+ * Returns an offset into tuple storage space that main tuple is stored at if
+ * needed.  For index-only scans, a single copy of the tuple's key, in the
+ * form of a plain tuple without the posting list, is shared by all of the
+ * items.
+ */
+static int
+_bt_setuppostingitems(BTScanOpaque so, int itemIndex, OffsetNumber offnum,
+					  ItemPointer heapTid, IndexTuple itup)
+{
+	BTScanPosItem *currItem = &so->currPos.items[itemIndex];
+
+	Assert(BTreeTupleIsPosting(itup));
+
+	currItem->heapTid = *heapTid;
+	currItem->indexOffset = offnum;
+	if (so->currTuples)
+	{
+		/* Save base IndexTuple (truncate posting list) */
+		IndexTuple	base;
+		Size		itupsz = BTreeTupleGetPostingOffset(itup);
+
+		itupsz = MAXALIGN(itupsz);
+		currItem->tupleOffset = so->currPos.nextTupleOffset;
+		base = (IndexTuple) (so->currTuples + so->currPos.nextTupleOffset);
+		memcpy(base, itup, itupsz);
+		/* Defensively reduce work area index tuple header size */
+		base->t_info &= ~(INDEX_SIZE_MASK | INDEX_ALT_TID_MASK);
+		base->t_info |= itupsz;
+		base->t_tid = *heapTid;
+		so->currPos.nextTupleOffset += itupsz;
+
+		return currItem->tupleOffset;
+	}
+
+	return 0;
+}
+
+/*
+ * Save an index item into so->currPos.items[itemIndex] for current posting
+ * tuple.
+ *
+ * Assumes that _bt_setuppostingitems() has already been called for current
+ * posting list tuple.  Caller passes its return value as tupleOffset.
+ */
+static inline void
+_bt_savepostingitem(BTScanOpaque so, int itemIndex, OffsetNumber offnum,
+					ItemPointer heapTid, int tupleOffset)
+{
+	BTScanPosItem *currItem = &so->currPos.items[itemIndex];
+
+	currItem->heapTid = *heapTid;
+	currItem->indexOffset = offnum;
+
+	/*
+	 * Have index-only scans return the same base IndexTuple for every TID
+	 * that originates from the same posting list
+	 */
+	if (so->currTuples)
+		currItem->tupleOffset = tupleOffset;
+}
+
 /*
  *	_bt_steppage() -- Step to next page containing valid data for scan
  *
@@ -1993,3 +2207,128 @@ _bt_initialize_more_data(BTScanOpaque so, ScanDirection dir)
 	so->numKilled = 0;			/* just paranoia */
 	so->markItemIndex = -1;		/* ditto */
 }
+
+/*
+ *	_bt_skip_find_value() -- Find the next value for a skip scan
+ *
+ * Looks up the first index entry beyond the skip key's current value in
+ * the given direction, or the first entry in that direction if the skip key
+ * has no value yet, and sets the skip key to that entry's first column.
+ * Returns false if there is no such entry.
+ *
+ * This is a simplified version of what _bt_first and _bt_endpoint do to
+ * position a scan.  Since we examine index contents on each page we visit,
+ * we must predicate-lock it, as a scan of the same range would.
+ */
+bool
+_bt_skip_find_value(IndexScanDesc scan, ScanDirection dir)
+{
+	Relation	rel = scan->indexRelation;
+	BTScanOpaque so = (BTScanOpaque) scan->opaque;
+	Buffer		buf;
+	Page		page;
+	BTPageOpaque opaque;
+	OffsetNumber offnum;
+	IndexTuple	itup;
+	Datum		value;
+	bool		isnull;
+
+	if (!so->skipKey->cur_valid)
+	{
+		buf = _bt_get_endpoint(rel, 0, ScanDirectionIsBackward(dir),
+							   scan->xs_snapshot);
+		if (!BufferIsValid(buf))
+		{
+			/* empty index, so lock the whole relation */
+			PredicateLockRelation(rel, scan->xs_snapshot);
+			return false;
+		}
+		page = BufferGetPage(buf);
+		opaque = (BTPageOpaque) PageGetSpecialPointer(page);
+		if (ScanDirectionIsForward(dir))
+			offnum = P_FIRSTDATAKEY(opaque);
+		else
+			offnum = PageGetMaxOffsetNumber(page);
+	}
+	else
+	{
+		ScanKey		cur = &so->arrayKeyData[0];
+		ScanKeyData scankey;
+		BTStack		stack;
+		bool		nextkey = ScanDirectionIsForward(dir);
+
+		/*
+		 * Build a one-column insertion scankey from the skip key, and find
+		 * the first item > it (forward), or the last item < it (backward,
+		 * by finding the first item >= it and backing up one).
+		 */
+		ScanKeyEntryInitializeWithInfo(&scankey,
+									   (cur->sk_flags & SK_ISNULL) |
+									   (rel->rd_indoption[0] << SK_BT_INDOPTION_SHIFT),
+									   1,
+									   InvalidStrategy,
+									   InvalidOid,
+									   rel->rd_indcollation[0],
+									   index_getprocinfo(rel, 1, BTORDER_PROC),
+									   cur->sk_argument);
+
+		stack = _bt_search(rel, 1, &scankey, nextkey, &buf, BT_READ,
+						   scan->xs_snapshot);
+		_bt_freestack(stack);
+		if (!BufferIsValid(buf))
+		{
+			PredicateLockRelation(rel, scan->xs_snapshot);
+			return false;
+		}
+
+		offnum = _bt_binsrch(rel, buf, 1, &scankey, nextkey);
+		if (!nextkey)
+			offnum = OffsetNumberPrev(offnum);
+	}
+
+	/* Step to neighboring pages until we're on an item */
+	for (;;)
+	{
+		BlockNumber blkno = BufferGetBlockNumber(buf);
+
+		page = BufferGetPage(buf);
+		opaque = (BTPageOpaque) PageGetSpecialPointer(page);
+
+		if (!P_IGNORE(opaque))
+		{
+			PredicateLockPage(rel, blkno, scan->xs_snapshot);
+			if (offnum >= P_FIRSTDATAKEY(opaque) &&
+				offnum <= PageGetMaxOffsetNumber(page))
+				break;
+		}
+
+		if (ScanDirectionIsForward(dir))
+		{
+			if (P_RIGHTMOST(opaque))
+			{
+				_bt_relbuf(rel, buf);
+				return false;
+			}
+			buf = _bt_relandgetbuf(rel, buf, opaque->btpo_next, BT_READ);
+			page = BufferGetPage(buf);
+			TestForOldSnapshot(scan->xs_snapshot, rel, page);
+			opaque = (BTPageOpaque) PageGetSpecialPointer(page);
+			offnum = P_FIRSTDATAKEY(opaque);
+		}
+		else
+		{
+			buf = _bt_walk_left(rel, buf, scan->xs_snapshot);
+			if (!BufferIsValid(buf))
+				return false;
+			offnum = PageGetMaxOffsetNumber(BufferGetPage(buf));
+		}
+	}
+
+	itup = (IndexTuple) PageGetItem(page, PageGetItemId(page, offnum));
+	value = index_getattr(itup, 1, RelationGetDescr(rel), &isnull);
+	_bt_skip_set_value(scan, value, isnull);
+
+	_bt_relbuf(rel, buf);
+
+	return true;
+}
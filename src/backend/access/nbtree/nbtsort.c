@@ -46,6 +46,18 @@
  * This code isn't concerned about the FSM at all. The caller is responsible
  * for initializing that.
  *
+ * Parallel builds normally have each participant sort its share of the heap,
+ * and then have the leader merge the resulting runs and load every leaf page
+ * itself.  For large indexes that serial tail dominates, so when there is
+ * enough memory we instead range-partition the keys: the leader picks
+ * splitter keys from a block sample of the heap before launching workers,
+ * each participant routes its tuples into one sort per key range, and once
+ * the scan is over participants take turns merging a range and writing its
+ * leaf pages into a shared temporary file.  The leader then only has to copy
+ * those pages into place, fix up the pages at range boundaries, and build
+ * the (much smaller) upper levels.  Equal keys always fall into the same
+ * range, so uniqueness checking and deduplication work as in a serial build.
+ *
  * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
  * Portions Copyright (c) 1994, Regents of the University of California
  *
@@ -64,11 +76,15 @@
 #include "access/xlog.h"
 #include "access/xloginsert.h"
 #include "catalog/index.h"
+#include "commands/progress.h"
 #include "miscadmin.h"
 #include "pgstat.h"
+#include "storage/buffile.h"
+#include "storage/sharedfileset.h"
 #include "storage/smgr.h"
 #include "tcop/tcopprot.h"		/* pgrminclude ignore */
 #include "utils/rel.h"
+#include "utils/sampling.h"
 #include "utils/sortsupport.h"
 #include "utils/tuplesort.h"
 
@@ -78,6 +94,7 @@
 #define PARALLEL_KEY_TUPLESORT			UINT64CONST(0xA000000000000002)
 #define PARALLEL_KEY_TUPLESORT_SPOOL2	UINT64CONST(0xA000000000000003)
 #define PARALLEL_KEY_QUERY_TEXT			UINT64CONST(0xA000000000000004)
+#define PARALLEL_KEY_BTREE_RANGES		UINT64CONST(0xA000000000000005)
 
 /*
  * DISABLE_LEADER_PARTICIPATION disables the leader's participation in
@@ -85,6 +102,25 @@
 #undef DISABLE_LEADER_PARTICIPATION
  */
 
+/*
+ * DISABLE_RANGE_PARTITIONING makes parallel builds always merge all worker
+ * runs and load the leaf level in the leader, as a debugging aid.
+#undef DISABLE_RANGE_PARTITIONING
+ */
+
+/*
+ * Number of sample tuples gathered per key range when choosing splitters.
+ * We sample that many heap blocks, too.
+ */
+#define BTREE_SAMPLE_PER_RANGE		100
+
+/*
+ * Range partitioning splits each participant's share of maintenance_work_mem
+ * between one sort per range.  Don't bother if that leaves each sort with
+ * less than this much memory (in kilobytes).
+ */
+#define BTREE_MIN_RANGE_SORT_MEM	1024
+
 /*
  * Status record for spooling/sorting phase.  (Note we may have two of
  * these due to the special requirements for uniqueness-checking with
@@ -116,6 +152,16 @@ typedef struct BTShared
 	bool		isconcurrent;
 	int			scantuplesortstates;
 
+	/*
+	 * nranges is the number of key ranges that the leaf level is built in, or
+	 * 1 if the build is not range partitioned.  In the former case there are
+	 * nranges tuplesort states (and nranges more for spool2) under each
+	 * tuplesort TOC entry, each participant sorts into all of them, and the
+	 * leaf pages built for each range go in a file in leaffileset.
+	 */
+	int			nranges;
+	SharedFileSet leaffileset;
+
 	/*
 	 * workersdonecv is used to monitor the progress of workers.  All parallel
 	 * participants must indicate that they are done before leader can use
@@ -154,6 +200,20 @@ typedef struct BTShared
 	double		indtuples;
 	bool		brokenhotchain;
 
+	/*
+	 * State for range partitioned builds.
+	 *
+	 * nparticipants is the number of participants that will take part in the
+	 * scan, or -1 until the leader knows how many workers were launched.
+	 * Participants must wait for all of them to finish scanning before they
+	 * can merge any range.  nextrange is the next range that no participant
+	 * has claimed yet, and nrangesdone the number of ranges whose leaf pages
+	 * are complete.
+	 */
+	int			nparticipants;
+	int			nextrange;
+	int			nrangesdone;
+
 	/*
 	 * This variable-sized field must come last.
 	 *
@@ -162,6 +222,26 @@ typedef struct BTShared
 	ParallelHeapScanDescData heapdesc;
 } BTShared;
 
+/*
+ * Key ranges of a range partitioned parallel build.  This is allocated in the
+ * dynamic shared memory segment, under its own TOC entry.
+ *
+ * npages[r] is the number of leaf pages built for range r, valid once it is
+ * done (protected by BTShared's mutex).  The nranges - 1 splitter tuples
+ * follow the array, each MAXALIGN'd.  Range r holds keys that are >= splitter
+ * r - 1 and < splitter r.
+ */
+typedef struct BTRanges
+{
+	int			nranges;
+	BlockNumber npages[FLEXIBLE_ARRAY_MEMBER];
+} BTRanges;
+
+#define BTRangesSplitters(ranges) \
+	((char *) (ranges) + \
+	 MAXALIGN(offsetof(BTRanges, npages) + \
+			  sizeof(BlockNumber) * (ranges)->nranges))
+
 /*
  * Status for leader in parallel index build.
  */
@@ -186,12 +266,14 @@ typedef struct BTLeader
 	 * shared, tuplesort-managed state passed to each process tuplesort.
 	 * sharedsort2 is the corresponding btspool2 shared state, used only when
 	 * building unique indexes.  snapshot is the snapshot used by the scan iff
-	 * an MVCC snapshot is required.
+	 * an MVCC snapshot is required.  ranges is the key range state of a
+	 * range partitioned build, else NULL.
 	 */
 	BTShared   *btshared;
 	Sharedsort *sharedsort;
 	Sharedsort *sharedsort2;
 	Snapshot	snapshot;
+	BTRanges   *ranges;
 } BTLeader;
 
 /*
@@ -220,6 +302,18 @@ typedef struct BTBuildState
 	 * BTBuildState.  Workers have their own spool and spool2, though.)
 	 */
 	BTLeader   *btleader;
+
+	/*
+	 * In a participant of a range partitioned build, tuples go into one of
+	 * nranges tuplesorts (and rangesorts2, if there is a spool2) according
+	 * to the nranges - 1 splitters, instead of into spool and spool2.
+	 * splitkeys is used to compare keys against the splitters.
+	 */
+	int			nranges;
+	IndexTuple *splitters;
+	SortSupport splitkeys;
+	Tuplesortstate **rangesorts;
+	Tuplesortstate **rangesorts2;
 } BTBuildState;
 
 /*
@@ -257,8 +351,29 @@ typedef struct BTWriteState
 	BlockNumber btws_pages_alloced; /* # pages allocated */
 	BlockNumber btws_pages_written; /* # pages written out */
 	Page		btws_zeropage;	/* workspace for filling zeroes */
+	BufFile    *btws_leaffile;	/* write leaf level only, to this file? */
 } BTWriteState;
 
+/*
+ * Working state for sampling the heap to choose key range splitters.
+ */
+typedef struct BTSampleState
+{
+	IndexTuple *tuples;			/* sample so far */
+	int			ntuples;		/* number of tuples in sample */
+	int			maxtuples;		/* target sample size */
+	double		seen;			/* number of tuples considered */
+	SamplerRandomState randstate;
+} BTSampleState;
+
+/* Passed to _bt_sample_cmp() */
+typedef struct BTKeyCompare
+{
+	SortSupport sortKeys;
+	int			keysz;
+	TupleDesc	tupdesc;
+} BTKeyCompare;
+
 
 static double _bt_spools_heapscan(Relation heap, Relation index,
 					BTBuildState *buildstate, IndexInfo *indexInfo);
@@ -266,6 +381,7 @@ static void _bt_spooldestroy(BTSpool *btspool);
 static void _bt_spool(BTSpool *btspool, ItemPointer self,
 		  Datum *values, bool *isnull);
 static void _bt_leafbuild(BTSpool *btspool, BTSpool *btspool2);
+static void _bt_rangebuild(BTLeader *btleader, BTSpool *btspool);
 static void _bt_build_callback(Relation index, HeapTuple htup, Datum *values,
 				   bool *isnull, bool tupleIsAlive, void *state);
 static Page _bt_blnewpage(uint32 level);
@@ -273,9 +389,17 @@ static BTPageState *_bt_pagestate(BTWriteState *wstate, uint32 level);
 static void _bt_slideleft(Page page);
 static void _bt_sortaddtup(Page page, Size itemsize,
 			   IndexTuple itup, OffsetNumber itup_off);
+static IndexTuple _bt_sethighkey(BTWriteState *wstate, Page page,
+			   OffsetNumber last_off);
+static void _bt_buildlink(BTWriteState *wstate, BTPageState *state,
+			  Page opage, BlockNumber oblkno, IndexTuple hikey);
 static void _bt_buildadd(BTWriteState *wstate, BTPageState *state,
 			 IndexTuple itup);
+static void _bt_sort_dedup_finish_pending(BTWriteState *wstate,
+							  BTPageState *state,
+							  BTDedupState dstate);
 static void _bt_uppershutdown(BTWriteState *wstate, BTPageState *state);
+static SortSupport _bt_build_sortkeys(Relation index);
 static void _bt_load(BTWriteState *wstate,
 		 BTSpool *btspool, BTSpool *btspool2);
 static void _bt_begin_parallel(BTBuildState *buildstate, bool isconcurrent,
@@ -287,7 +411,24 @@ static double _bt_parallel_heapscan(BTBuildState *buildstate,
 static void _bt_leader_participate_as_worker(BTBuildState *buildstate);
 static void _bt_parallel_scan_and_sort(BTSpool *btspool, BTSpool *btspool2,
 						   BTShared *btshared, Sharedsort *sharedsort,
-						   Sharedsort *sharedsort2, int sortmem);
+						   Sharedsort *sharedsort2, BTRanges *ranges,
+						   int sortmem);
+static void _bt_parallel_build_ranges(BTSpool *btspool, BTShared *btshared,
+						  BTRanges *ranges, Sharedsort *sharedsort,
+						  Sharedsort *sharedsort2);
+static Sharedsort *_bt_range_sharedsort(BTShared *btshared,
+					 Sharedsort *sharedsort, int range);
+static void _bt_range_filename(char *name, int range);
+static int _bt_sample_splitters(Relation heap, Relation index,
+					 bool isconcurrent, int nranges,
+					 IndexTuple **splitters);
+static void _bt_sample_callback(Relation index, HeapTuple htup,
+					Datum *values, bool *isnull,
+					bool tupleIsAlive, void *state);
+static int	_bt_sample_cmp(const void *a, const void *b, void *arg);
+static int	_bt_keyrange(BTBuildState *buildstate, Relation index,
+			 Datum *values, bool *isnull);
+static Page _bt_range_readpage(BufFile *file);
 
 
 /*
@@ -312,6 +453,11 @@ btbuild(Relation heap, Relation index, IndexInfo *indexInfo)
 	buildstate.spool2 = NULL;
 	buildstate.indtuples = 0;
 	buildstate.btleader = NULL;
+	buildstate.nranges = 1;
+	buildstate.splitters = NULL;
+	buildstate.splitkeys = NULL;
+	buildstate.rangesorts = NULL;
+	buildstate.rangesorts2 = NULL;
 
 	/*
 	 * We expect to be called exactly once for any index relation. If that's
@@ -323,12 +469,22 @@ btbuild(Relation heap, Relation index, IndexInfo *indexInfo)
 
 	reltuples = _bt_spools_heapscan(heap, index, &buildstate, indexInfo);
 
+	pgstat_progress_update_param(PROGRESS_CREATEIDX_TUPLES_TOTAL,
+								 (int64) buildstate.indtuples);
+
 	/*
 	 * Finish the build by (1) completing the sort of the spool file, (2)
 	 * inserting the sorted tuples into btree pages and (3) building the upper
 	 * levels.  Finally, it may also be necessary to end use of parallelism.
+	 *
+	 * In a range partitioned parallel build, participants have already done
+	 * the first two steps for each key range, so we only have to stitch
+	 * their leaf pages together.
 	 */
-	_bt_leafbuild(buildstate.spool, buildstate.spool2);
+	if (buildstate.btleader && buildstate.btleader->ranges)
+		_bt_rangebuild(buildstate.btleader, buildstate.spool);
+	else
+		_bt_leafbuild(buildstate.spool, buildstate.spool2);
 	_bt_spooldestroy(buildstate.spool);
 	if (buildstate.spool2)
 		_bt_spooldestroy(buildstate.spool2);
@@ -369,6 +525,7 @@ _bt_spools_heapscan(Relation heap, Relation index, BTBuildState *buildstate,
 	BTSpool    *btspool = (BTSpool *) palloc0(sizeof(BTSpool));
 	SortCoordinate coordinate = NULL;
 	double		reltuples = 0;
+	bool		ranged = false;
 
 	/*
 	 * We size the sort area as maintenance_work_mem rather than work_mem to
@@ -390,9 +547,13 @@ _bt_spools_heapscan(Relation heap, Relation index, BTBuildState *buildstate,
 
 	/*
 	 * If parallel build requested and at least one worker process was
-	 * successfully launched, set up coordination state
+	 * successfully launched, set up coordination state.  A range partitioned
+	 * build needs no leader tuplesort at all, since participants merge each
+	 * range themselves.
 	 */
-	if (buildstate->btleader)
+	if (buildstate->btleader && buildstate->btleader->ranges)
+		ranged = true;
+	else if (buildstate->btleader)
 	{
 		coordinate = (SortCoordinate) palloc0(sizeof(SortCoordinateData));
 		coordinate->isWorker = false;
@@ -422,10 +583,11 @@ _bt_spools_heapscan(Relation heap, Relation index, BTBuildState *buildstate,
 	 * on the amount of memory used by a CREATE INDEX operation, regardless of
 	 * the use of parallelism or any other factor.
 	 */
-	buildstate->spool->sortstate =
-		tuplesort_begin_index_btree(heap, index, buildstate->isunique,
-									maintenance_work_mem, coordinate,
-									false);
+	if (!ranged)
+		buildstate->spool->sortstate =
+			tuplesort_begin_index_btree(heap, index, buildstate->isunique,
+										maintenance_work_mem, coordinate,
+										false);
 
 	/*
 	 * If building a unique index, put dead tuples in a second spool to keep
@@ -444,7 +606,7 @@ _bt_spools_heapscan(Relation heap, Relation index, BTBuildState *buildstate,
 		/* Save as secondary spool */
 		buildstate->spool2 = btspool2;
 
-		if (buildstate->btleader)
+		if (buildstate->btleader && !ranged)
 		{
 			/*
 			 * Set up non-private state that is passed to
@@ -462,9 +624,10 @@ _bt_spools_heapscan(Relation heap, Relation index, BTBuildState *buildstate,
 		 * We expect that the second one (for dead tuples) won't get very
 		 * full, so we give it only work_mem
 		 */
-		buildstate->spool2->sortstate =
-			tuplesort_begin_index_btree(heap, index, false, work_mem,
-										coordinate2, false);
+		if (!ranged)
+			buildstate->spool2->sortstate =
+				tuplesort_begin_index_btree(heap, index, false, work_mem,
+											coordinate2, false);
 	}
 
 	/* Fill spool using either serial or parallel heap scan */
@@ -493,7 +656,8 @@ _bt_spools_heapscan(Relation heap, Relation index, BTBuildState *buildstate,
 static void
 _bt_spooldestroy(BTSpool *btspool)
 {
-	tuplesort_end(btspool->sortstate);
+	if (btspool->sortstate)
+		tuplesort_end(btspool->sortstate);
 	pfree(btspool);
 }
 
@@ -524,9 +688,13 @@ _bt_leafbuild(BTSpool *btspool, BTSpool *btspool2)
 	}
 #endif							/* BTREE_BUILD_STATS */
 
+	pgstat_progress_update_param(PROGRESS_CREATEIDX_SUBPHASE,
+								 PROGRESS_CREATEIDX_SUBPHASE_SORT);
 	tuplesort_performsort(btspool->sortstate);
 	if (btspool2)
 		tuplesort_performsort(btspool2->sortstate);
+	pgstat_progress_update_param(PROGRESS_CREATEIDX_SUBPHASE,
+								 PROGRESS_CREATEIDX_SUBPHASE_LOAD);
 
 	wstate.heap = btspool->heap;
 	wstate.index = btspool->index;
@@ -541,6 +709,7 @@ _bt_leafbuild(BTSpool *btspool, BTSpool *btspool2)
 	wstate.btws_pages_alloced = BTREE_METAPAGE + 1;
 	wstate.btws_pages_written = 0;
 	wstate.btws_zeropage = NULL;	/* until needed */
+	wstate.btws_leaffile = NULL;
 
 	_bt_load(&wstate, btspool, btspool2);
 }
@@ -562,7 +731,24 @@ _bt_build_callback(Relation index,
 	 * insert the index tuple into the appropriate spool file for subsequent
 	 * processing
 	 */
-	if (tupleIsAlive || buildstate->spool2 == NULL)
+	if (buildstate->nranges > 1)
+	{
+		int			range = _bt_keyrange(buildstate, index, values, isnull);
+
+		if (tupleIsAlive || buildstate->rangesorts2 == NULL)
+			tuplesort_putindextuplevalues(buildstate->rangesorts[range],
+										  index, &htup->t_self,
+										  values, isnull);
+		else
+		{
+			/* dead tuples are put into spool2 */
+			buildstate->havedead = true;
+			tuplesort_putindextuplevalues(buildstate->rangesorts2[range],
+										  index, &htup->t_self,
+										  values, isnull);
+		}
+	}
+	else if (tupleIsAlive || buildstate->spool2 == NULL)
 		_bt_spool(buildstate->spool, &htup->t_self, values, isnull);
 	else
 	{
@@ -607,6 +793,23 @@ _bt_blnewpage(uint32 level)
 static void
 _bt_blwritepage(BTWriteState *wstate, Page page, BlockNumber blkno)
 {
+	/*
+	 * Leaf pages built for one key range just go to a temporary file, in
+	 * order.  The leader fixes their sibling links and writes them out for
+	 * real later.
+	 */
+	if (wstate->btws_leaffile)
+	{
+		Assert(blkno == wstate->btws_pages_written);
+		if (BufFileWrite(wstate->btws_leaffile, page, BLCKSZ) != BLCKSZ)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not write to temporary file: %m")));
+		wstate->btws_pages_written++;
+		pfree(page);
+		return;
+	}
+
 	/* Ensure rd_smgr is open (could have been closed by relcache flush!) */
 	RelationOpenSmgr(wstate->index);
 
@@ -753,6 +956,120 @@ _bt_sortaddtup(Page page,
 		elog(ERROR, "failed to add item to the index page");
 }
 
+/*
+ * Turn the last item on a page being built into its high key.
+ *
+ * The item at last_off is moved into the P_HIKEY slot (which every page being
+ * built keeps allocated), and truncated as needed.  Returns a pointer to the
+ * high key on the page.
+ */
+static IndexTuple
+_bt_sethighkey(BTWriteState *wstate, Page page, OffsetNumber last_off)
+{
+	BTPageOpaque opaque = (BTPageOpaque) PageGetSpecialPointer(page);
+	int			indnatts = IndexRelationGetNumberOfAttributes(wstate->index);
+	int			indnkeyatts = IndexRelationGetNumberOfKeyAttributes(wstate->index);
+	ItemId		ii;
+	ItemId		hii;
+	IndexTuple	oitup;
+
+	ii = PageGetItemId(page, last_off);
+	hii = PageGetItemId(page, P_HIKEY);
+	*hii = *ii;
+	ItemIdSetUnused(ii);		/* redundant */
+	((PageHeader) page)->pd_lower -= sizeof(ItemIdData);
+	oitup = (IndexTuple) PageGetItem(page, hii);
+
+	if (P_ISLEAF(opaque))
+	{
+		int			keepnatts = indnkeyatts;
+
+		/*
+		 * Truncate high key on leaf level: remove any non-key attributes
+		 * (if we're building an INCLUDE index), any posting list, and the
+		 * key attributes that aren't needed to distinguish it from the last
+		 * item remaining on the page.  This is only done at the leaf level
+		 * because downlinks in internal pages are either negative infinity
+		 * items, or get their contents from copying from one level down.
+		 * See also: _bt_split().
+		 */
+		if (last_off > P_FIRSTKEY)
+		{
+			IndexTuple	lastleft;
+
+			lastleft = (IndexTuple)
+				PageGetItem(page, PageGetItemId(page, OffsetNumberPrev(last_off)));
+			keepnatts = _bt_keep_natts(wstate->index, lastleft, oitup);
+		}
+
+		if (keepnatts < indnatts || BTreeTupleIsPosting(oitup))
+		{
+			IndexTuple	truncated;
+			Size		truncsz;
+
+			/*
+			 * Since the truncated tuple is probably smaller than the
+			 * original, it cannot just be copied in place (besides, we want
+			 * to actually save space on the leaf page).  We delete the
+			 * original high key, and add our own truncated high key at the
+			 * same offset.
+			 *
+			 * Note that the page layout won't be changed very much.  oitup
+			 * is already located at the physical beginning of tuple space,
+			 * so we only shift the line pointer array back and forth, and
+			 * overwrite the latter portion of the space occupied by the
+			 * original tuple.  This is fairly cheap.
+			 */
+			truncated = _bt_truncate(wstate->index, oitup, keepnatts);
+			truncsz = IndexTupleSize(truncated);
+			PageIndexTupleDelete(page, P_HIKEY);
+			_bt_sortaddtup(page, truncsz, truncated, P_HIKEY);
+			pfree(truncated);
+
+			/* oitup should continue to point to the page's high key */
+			hii = PageGetItemId(page, P_HIKEY);
+			oitup = (IndexTuple) PageGetItem(page, hii);
+		}
+	}
+
+	return oitup;
+}
+
+/*
+ * Link a finished page into its parent, using its minimum key (which is kept
+ * in state), and then replace the minimum key with a copy of the page's high
+ * key, since that is the minimum key of the page that follows it.  We have to
+ * copy that off the old page, not the new one, in case we are not at leaf
+ * level.
+ *
+ * If we don't have a parent, we have to create one; this adds a new btree
+ * level.  When building only the leaf level, there is no parent to link to.
+ */
+static void
+_bt_buildlink(BTWriteState *wstate, BTPageState *state, Page opage,
+			  BlockNumber oblkno, IndexTuple hikey)
+{
+	BTPageOpaque opageop PG_USED_FOR_ASSERTS_ONLY =
+	(BTPageOpaque) PageGetSpecialPointer(opage);
+
+	if (wstate->btws_leaffile == NULL)
+	{
+		if (state->btps_next == NULL)
+			state->btps_next = _bt_pagestate(wstate, state->btps_level + 1);
+
+		Assert(BTreeTupleGetNAtts(state->btps_minkey, wstate->index) <=
+			   IndexRelationGetNumberOfKeyAttributes(wstate->index) ||
+			   P_LEFTMOST(opageop));
+		Assert(BTreeTupleGetNAtts(state->btps_minkey, wstate->index) == 0 ||
+			   !P_LEFTMOST(opageop));
+		BTreeInnerTupleSetDownLink(state->btps_minkey, oblkno);
+		_bt_buildadd(wstate, state->btps_next, state->btps_minkey);
+	}
+	pfree(state->btps_minkey);
+
+	state->btps_minkey = CopyIndexTuple(hikey);
+}
+
 /*----------
  * Add an item to a disk page from the sort output.
  *
@@ -796,8 +1113,6 @@ _bt_buildadd(BTWriteState *wstate, BTPageState *state, IndexTuple itup)
 	OffsetNumber last_off;
 	Size		pgspc;
 	Size		itupsz;
-	int			indnatts = IndexRelationGetNumberOfAttributes(wstate->index);
-	int			indnkeyatts = IndexRelationGetNumberOfKeyAttributes(wstate->index);
 
 	/*
 	 * This is a handy place to check for cancel interrupts during the btree
@@ -850,9 +1165,7 @@ _bt_buildadd(BTWriteState *wstate, BTPageState *state, IndexTuple itup)
 		Page		opage = npage;
 		BlockNumber oblkno = nblkno;
 		ItemId		ii;
-		ItemId		hii;
 		IndexTuple	oitup;
-		BTPageOpaque opageop = (BTPageOpaque) PageGetSpecialPointer(opage);
 
 		/* Create new page of same level */
 		npage = _bt_blnewpage(state->btps_level);
@@ -875,70 +1188,13 @@ _bt_buildadd(BTWriteState *wstate, BTPageState *state, IndexTuple itup)
 		/*
 		 * Move 'last' into the high key position on opage
 		 */
-		hii = PageGetItemId(opage, P_HIKEY);
-		*hii = *ii;
-		ItemIdSetUnused(ii);	/* redundant */
-		((PageHeader) opage)->pd_lower -= sizeof(ItemIdData);
-
-		if (indnkeyatts != indnatts && P_ISLEAF(opageop))
-		{
-			IndexTuple	truncated;
-			Size		truncsz;
-
-			/*
-			 * Truncate any non-key attributes from high key on leaf level
-			 * (i.e. truncate on leaf level if we're building an INCLUDE
-			 * index).  This is only done at the leaf level because downlinks
-			 * in internal pages are either negative infinity items, or get
-			 * their contents from copying from one level down.  See also:
-			 * _bt_split().
-			 *
-			 * Since the truncated tuple is probably smaller than the
-			 * original, it cannot just be copied in place (besides, we want
-			 * to actually save space on the leaf page).  We delete the
-			 * original high key, and add our own truncated high key at the
-			 * same offset.
-			 *
-			 * Note that the page layout won't be changed very much.  oitup is
-			 * already located at the physical beginning of tuple space, so we
-			 * only shift the line pointer array back and forth, and overwrite
-			 * the latter portion of the space occupied by the original tuple.
-			 * This is fairly cheap.
-			 */
-			truncated = _bt_nonkey_truncate(wstate->index, oitup);
-			truncsz = IndexTupleSize(truncated);
-			PageIndexTupleDelete(opage, P_HIKEY);
-			_bt_sortaddtup(opage, truncsz, truncated, P_HIKEY);
-			pfree(truncated);
-
-			/* oitup should continue to point to the page's high key */
-			hii = PageGetItemId(opage, P_HIKEY);
-			oitup = (IndexTuple) PageGetItem(opage, hii);
-		}
-
-		/*
-		 * Link the old page into its parent, using its minimum key. If we
-		 * don't have a parent, we have to create one; this adds a new btree
-		 * level.
-		 */
-		if (state->btps_next == NULL)
-			state->btps_next = _bt_pagestate(wstate, state->btps_level + 1);
-
-		Assert(BTreeTupleGetNAtts(state->btps_minkey, wstate->index) ==
-			   IndexRelationGetNumberOfKeyAttributes(wstate->index) ||
-			   P_LEFTMOST(opageop));
-		Assert(BTreeTupleGetNAtts(state->btps_minkey, wstate->index) == 0 ||
-			   !P_LEFTMOST(opageop));
-		BTreeInnerTupleSetDownLink(state->btps_minkey, oblkno);
-		_bt_buildadd(wstate, state->btps_next, state->btps_minkey);
-		pfree(state->btps_minkey);
+		oitup = _bt_sethighkey(wstate, opage, last_off);
 
 		/*
-		 * Save a copy of the minimum key for the new page.  We have to copy
-		 * it off the old page, not the new one, in case we are not at leaf
-		 * level.
+		 * Link the old page into its parent, and save its high key as the
+		 * minimum key for the new page.
 		 */
-		state->btps_minkey = CopyIndexTuple(oitup);
+		_bt_buildlink(wstate, state, opage, oblkno, oitup);
 
 		/*
 		 * Set the sibling links for both pages.
@@ -991,6 +1247,37 @@ _bt_buildadd(BTWriteState *wstate, BTPageState *state, IndexTuple itup)
 	state->btps_lastoff = last_off;
 }
 
+/*
+ * Finalize pending posting list tuple, and add it to the index.  Final tuple
+ * is based on saved base tuple, and saved list of heap TIDs.
+ *
+ * This is almost like _bt_dedup_finish_pending(), but it adds a new tuple
+ * using _bt_buildadd().
+ */
+static void
+_bt_sort_dedup_finish_pending(BTWriteState *wstate, BTPageState *state,
+							  BTDedupState dstate)
+{
+	Assert(dstate->nitems > 0);
+
+	if (dstate->nitems == 1)
+		_bt_buildadd(wstate, state, dstate->base);
+	else
+	{
+		IndexTuple	postingtuple;
+
+		/* form a tuple with a posting list */
+		postingtuple = _bt_form_posting(dstate->base,
+										dstate->htids,
+										dstate->nhtids);
+		_bt_buildadd(wstate, state, postingtuple);
+		pfree(postingtuple);
+	}
+
+	dstate->nhtids = 0;
+	dstate->nitems = 0;
+}
+
 /*
  * Finish writing out the completed btree.
  */
@@ -1029,7 +1316,7 @@ _bt_uppershutdown(BTWriteState *wstate, BTPageState *state)
 		}
 		else
 		{
-			Assert(BTreeTupleGetNAtts(s->btps_minkey, wstate->index) ==
+			Assert(BTreeTupleGetNAtts(s->btps_minkey, wstate->index) <=
 				   IndexRelationGetNumberOfKeyAttributes(wstate->index) ||
 				   P_LEFTMOST(opaque));
 			Assert(BTreeTupleGetNAtts(s->btps_minkey, wstate->index) == 0 ||
@@ -1060,6 +1347,48 @@ _bt_uppershutdown(BTWriteState *wstate, BTPageState *state)
 	_bt_blwritepage(wstate, metapage, BTREE_METAPAGE);
 }
 
+/*
+ * Prepare SortSupport data for comparing the key columns of index tuples
+ * outside of tuplesort.c.
+ */
+static SortSupport
+_bt_build_sortkeys(Relation index)
+{
+	int			keysz = IndexRelationGetNumberOfKeyAttributes(index);
+	ScanKey		indexScanKey;
+	SortSupport sortKeys;
+	int			i;
+
+	indexScanKey = _bt_mkscankey_nodata(index);
+	sortKeys = (SortSupport) palloc0(keysz * sizeof(SortSupportData));
+
+	for (i = 0; i < keysz; i++)
+	{
+		SortSupport sortKey = sortKeys + i;
+		ScanKey		scanKey = indexScanKey + i;
+		int16		strategy;
+
+		sortKey->ssup_cxt = CurrentMemoryContext;
+		sortKey->ssup_collation = scanKey->sk_collation;
+		sortKey->ssup_nulls_first =
+			(scanKey->sk_flags & SK_BT_NULLS_FIRST) != 0;
+		sortKey->ssup_attno = scanKey->sk_attno;
+		/* Abbreviation is not supported here */
+		sortKey->abbreviate = false;
+
+		AssertState(sortKey->ssup_attno != 0);
+
+		strategy = (scanKey->sk_flags & SK_BT_DESC) != 0 ?
+			BTGreaterStrategyNumber : BTLessStrategyNumber;
+
+		PrepareSortSupportFromIndexRel(index, strategy, sortKey);
+	}
+
+	_bt_freeskey(indexScanKey);
+
+	return sortKeys;
+}
+
 /*
  * Read tuples in correct sort order from tuplesort, and load them into
  * btree leaves.
@@ -1075,8 +1404,8 @@ _bt_load(BTWriteState *wstate, BTSpool *btspool, BTSpool *btspool2)
 	TupleDesc	tupdes = RelationGetDescr(wstate->index);
 	int			i,
 				keysz = IndexRelationGetNumberOfKeyAttributes(wstate->index);
-	ScanKey		indexScanKey = NULL;
 	SortSupport sortKeys;
+	int64		tuples_done = 0;
 
 	if (merge)
 	{
@@ -1088,34 +1417,7 @@ _bt_load(BTWriteState *wstate, BTSpool *btspool, BTSpool *btspool2)
 		/* the preparation of merge */
 		itup = tuplesort_getindextuple(btspool->sortstate, true);
 		itup2 = tuplesort_getindextuple(btspool2->sortstate, true);
-		indexScanKey = _bt_mkscankey_nodata(wstate->index);
-
-		/* Prepare SortSupport data for each column */
-		sortKeys = (SortSupport) palloc0(keysz * sizeof(SortSupportData));
-
-		for (i = 0; i < keysz; i++)
-		{
-			SortSupport sortKey = sortKeys + i;
-			ScanKey		scanKey = indexScanKey + i;
-			int16		strategy;
-
-			sortKey->ssup_cxt = CurrentMemoryContext;
-			sortKey->ssup_collation = scanKey->sk_collation;
-			sortKey->ssup_nulls_first =
-				(scanKey->sk_flags & SK_BT_NULLS_FIRST) != 0;
-			sortKey->ssup_attno = scanKey->sk_attno;
-			/* Abbreviation is not supported here */
-			sortKey->abbreviate = false;
-
-			AssertState(sortKey->ssup_attno != 0);
-
-			strategy = (scanKey->sk_flags & SK_BT_DESC) != 0 ?
-				BTGreaterStrategyNumber : BTLessStrategyNumber;
-
-			PrepareSortSupportFromIndexRel(wstate->index, strategy, sortKey);
-		}
-
-		_bt_freeskey(indexScanKey);
+		sortKeys = _bt_build_sortkeys(wstate->index);
 
 		for (;;)
 		{
@@ -1169,12 +1471,95 @@ _bt_load(BTWriteState *wstate, BTSpool *btspool, BTSpool *btspool2)
 				_bt_buildadd(wstate, state, itup2);
 				itup2 = tuplesort_getindextuple(btspool2->sortstate, true);
 			}
+
+			/* Report progress */
+			pgstat_progress_update_param(PROGRESS_CREATEIDX_TUPLES_DONE,
+										 ++tuples_done);
 		}
 		pfree(sortKeys);
 	}
+	else if (_bt_dedup_enabled(wstate->index))
+	{
+		BTDedupState dstate;
+
+		/*
+		 * Merge is unnecessary, but tuples with equal keys are merged into
+		 * posting list tuples as they come out of the sort
+		 */
+		dstate = (BTDedupState) palloc(sizeof(BTDedupStateData));
+		dstate->maxpostingsize = 0; /* set later */
+		dstate->base = NULL;
+		dstate->baseoff = InvalidOffsetNumber;
+		dstate->basetupsize = 0;
+		dstate->htids = NULL;
+		dstate->nhtids = 0;
+		dstate->nitems = 0;
+		dstate->nintervals = 0; /* unused */
+
+		while ((itup = tuplesort_getindextuple(btspool->sortstate,
+											   true)) != NULL)
+		{
+			/* When we see first tuple, create first index page */
+			if (state == NULL)
+			{
+				state = _bt_pagestate(wstate, 0);
+
+				/*
+				 * Limit posting list tuples to the same size as
+				 * _bt_dedup_one_page() does
+				 */
+				dstate->maxpostingsize = Min(BTMaxItemSize(state->btps_page) / 2,
+											 INDEX_SIZE_MASK);
+				dstate->htids = palloc(dstate->maxpostingsize);
+
+				/* start new pending posting list with itup copy */
+				_bt_dedup_start_pending(dstate, CopyIndexTuple(itup),
+										InvalidOffsetNumber);
+			}
+			else if (_bt_dedup_keys_equal(dstate->base, itup) &&
+					 _bt_dedup_save_htid(dstate, itup))
+			{
+				/*
+				 * Tuple is equal to base tuple of pending posting list.  Heap
+				 * TID from itup has been saved in state.
+				 */
+			}
+			else
+			{
+				/*
+				 * Tuple is not equal to pending posting list tuple, or
+				 * _bt_dedup_save_htid() opted to not merge current item into
+				 * pending posting list.
+				 */
+				_bt_sort_dedup_finish_pending(wstate, state, dstate);
+				pfree(dstate->base);
+
+				/* start new pending posting list with itup copy */
+				_bt_dedup_start_pending(dstate, CopyIndexTuple(itup),
+										InvalidOffsetNumber);
+			}
+
+			/* Report progress */
+			pgstat_progress_update_param(PROGRESS_CREATEIDX_TUPLES_DONE,
+										 ++tuples_done);
+		}
+
+		if (state)
+		{
+			/*
+			 * Handle the last item (there must be a last item when the
+			 * tuplesort returned one or more tuples)
+			 */
+			_bt_sort_dedup_finish_pending(wstate, state, dstate);
+			pfree(dstate->base);
+			pfree(dstate->htids);
+		}
+
+		pfree(dstate);
+	}
 	else
 	{
-		/* merge is unnecessary */
+		/* merging and deduplication are both unnecessary */
 		while ((itup = tuplesort_getindextuple(btspool->sortstate,
 											   true)) != NULL)
 		{
@@ -1183,7 +1568,28 @@ _bt_load(BTWriteState *wstate, BTSpool *btspool, BTSpool *btspool2)
 				state = _bt_pagestate(wstate, 0);
 
 			_bt_buildadd(wstate, state, itup);
+
+			/* Report progress */
+			pgstat_progress_update_param(PROGRESS_CREATEIDX_TUPLES_DONE,
+										 ++tuples_done);
+		}
+	}
+
+	/*
+	 * When building one key range of the leaf level, the last page is left
+	 * open: the leader will add the high key linking it to the next range, or
+	 * make it the rightmost page.
+	 */
+	if (wstate->btws_leaffile)
+	{
+		if (state)
+		{
+			_bt_blwritepage(wstate, state->btps_page, state->btps_blkno);
+			if (state->btps_minkey)
+				pfree(state->btps_minkey);
+			pfree(state);
 		}
+		return;
 	}
 
 	/* Close down final pages and write the metapage */
@@ -1212,51 +1618,260 @@ _bt_load(BTWriteState *wstate, BTSpool *btspool, BTSpool *btspool2)
 }
 
 /*
- * Create parallel context, and launch workers for leader.
- *
- * buildstate argument should be initialized (with the exception of the
- * tuplesort state in spools, which may later be created based on shared
- * state initially set up here).
- *
- * isconcurrent indicates if operation is CREATE INDEX CONCURRENTLY.
+ * Finish a range partitioned parallel build, once participants have built the
+ * leaf pages of every key range.
  *
- * request is the target number of parallel worker processes to launch.
- *
- * Sets buildstate's BTLeader, which caller must use to shut down parallel
- * mode by passing it to _bt_end_parallel() at the very end of its index
- * build.  If not even a single worker process can be launched, this is
- * never set, and caller should proceed with a serial index build.
+ * The pages of each range go into the index one after another, and we link
+ * each into its parent as we go, just as _bt_buildadd() does when it
+ * finishes a page.  Only the last page of each range needs more work: it has
+ * no high key yet, since its builder didn't know what came next.  We keep it
+ * as the current page of the leaf level's BTPageState, using the machinery
+ * in _bt_buildadd() to give it the first key of the next range as a high key
+ * (splitting it if that doesn't fit), and _bt_uppershutdown() to finish the
+ * last one as the rightmost leaf page.
  */
 static void
-_bt_begin_parallel(BTBuildState *buildstate, bool isconcurrent, int request)
+_bt_rangebuild(BTLeader *btleader, BTSpool *btspool)
 {
-	ParallelContext *pcxt;
-	int			scantuplesortstates;
-	Snapshot	snapshot;
-	Size		estbtshared;
-	Size		estsort;
-	BTShared   *btshared;
-	Sharedsort *sharedsort;
-	Sharedsort *sharedsort2;
-	BTSpool    *btspool = buildstate->spool;
-	BTLeader   *btleader = (BTLeader *) palloc0(sizeof(BTLeader));
-	bool		leaderparticipates = true;
-	char	   *sharedquery;
-	int			querylen;
+	BTShared   *btshared = btleader->btshared;
+	BTRanges   *ranges = btleader->ranges;
+	BTWriteState wstate;
+	BTPageState *state = NULL;
+	int			range;
 
-#ifdef DISABLE_LEADER_PARTICIPATION
-	leaderparticipates = false;
-#endif
+#ifdef BTREE_BUILD_STATS
+	if (log_btree_build_stats)
+	{
+		ShowUsage("BTREE BUILD (Spool) STATISTICS");
+		ResetUsage();
+	}
+#endif							/* BTREE_BUILD_STATS */
+
+	/* the workers sort and load their ranges concurrently */
+	pgstat_progress_update_param(PROGRESS_CREATEIDX_SUBPHASE,
+								 PROGRESS_CREATEIDX_SUBPHASE_LOAD);
+
+	/* Wait for all ranges to be built */
+	for (;;)
+	{
+		SpinLockAcquire(&btshared->mutex);
+		if (btshared->nrangesdone == ranges->nranges)
+		{
+			SpinLockRelease(&btshared->mutex);
+			break;
+		}
+		SpinLockRelease(&btshared->mutex);
+
+		ConditionVariableSleep(&btshared->workersdonecv,
+							   WAIT_EVENT_PARALLEL_CREATE_INDEX_SCAN);
+	}
+
+	ConditionVariableCancelSleep();
+
+	wstate.heap = btspool->heap;
+	wstate.index = btspool->index;
+	wstate.btws_use_wal = XLogIsNeeded() && RelationNeedsWAL(wstate.index);
+	/* reserve the metapage */
+	wstate.btws_pages_alloced = BTREE_METAPAGE + 1;
+	wstate.btws_pages_written = 0;
+	wstate.btws_zeropage = NULL;	/* until needed */
+	wstate.btws_leaffile = NULL;
+
+	for (range = 0; range < ranges->nranges; range++)
+	{
+		BlockNumber npages = ranges->npages[range];
+		BlockNumber base;
+		BlockNumber prevblk;
+		BlockNumber i;
+		char		filename[MAXPGPATH];
+		BufFile    *file;
+		Page		page;
+		IndexTuple	first;
+		Page		prevpage = NULL;
+
+		/* Nothing to do for ranges that turned out to be empty */
+		if (npages == 0)
+			continue;
+
+		_bt_range_filename(filename, range);
+		file = BufFileOpenShared(&btshared->leaffileset, filename);
+		page = _bt_range_readpage(file);
+		first = (IndexTuple) PageGetItem(page, PageGetItemId(page, P_FIRSTKEY));
+
+		if (state == NULL)
+		{
+			/*
+			 * This is the first page on the leaf level.  Its minimum key is a
+			 * minus infinity downlink.
+			 */
+			state = (BTPageState *) palloc0(sizeof(BTPageState));
+			state->btps_minkey = CopyIndexTuple(first);
+			/* _bt_sortaddtup() will perform full truncation later */
+			BTreeTupleSetNAtts(state->btps_minkey, 0);
+			state->btps_level = 0;
+			state->btps_full = RelationGetTargetPageFreeSpace(wstate.index,
+															  BTREE_DEFAULT_FILLFACTOR);
+			state->btps_next = NULL;
+			prevblk = P_NONE;
+		}
+		else
+		{
+			IndexTuple	hikey;
+
+			/*
+			 * Finish off the last page of the previous range, with this
+			 * range's first key as its high key.  Adding that key as an item
+			 * first takes care of splitting the page if there's no room.
+			 */
+			_bt_buildadd(&wstate, state, first);
+			hikey = _bt_sethighkey(&wstate, state->btps_page,
+								   state->btps_lastoff);
+			_bt_buildlink(&wstate, state, state->btps_page,
+						  state->btps_blkno, hikey);
+			prevpage = state->btps_page;
+			prevblk = state->btps_blkno;
+		}
+
+		/* The range's pages go in consecutive blocks */
+		base = wstate.btws_pages_alloced;
+		wstate.btws_pages_alloced += npages;
+
+		if (prevpage)
+		{
+			BTPageOpaque opaque = (BTPageOpaque) PageGetSpecialPointer(prevpage);
+
+			opaque->btpo_next = base;
+			_bt_blwritepage(&wstate, prevpage, prevblk);
+		}
+
+		for (i = 0; i < npages; i++)
+		{
+			BlockNumber blkno = base + i;
+			BTPageOpaque opaque;
+
+			if (i > 0)
+				page = _bt_range_readpage(file);
+			opaque = (BTPageOpaque) PageGetSpecialPointer(page);
+			opaque->btpo_prev = prevblk;
+
+			if (i < npages - 1)
+			{
+				IndexTuple	hikey;
+
+				hikey = (IndexTuple) PageGetItem(page,
+												 PageGetItemId(page, P_HIKEY));
+				opaque->btpo_next = blkno + 1;
+				_bt_buildlink(&wstate, state, page, blkno, hikey);
+				_bt_blwritepage(&wstate, page, blkno);
+			}
+			else
+			{
+				/* Last page of the range stays open */
+				opaque->btpo_next = P_NONE;
+				state->btps_page = page;
+				state->btps_blkno = blkno;
+				state->btps_lastoff = PageGetMaxOffsetNumber(page);
+			}
+			prevblk = blkno;
+		}
+
+		BufFileClose(file);
+	}
+
+	/* Close down final pages and write the metapage */
+	_bt_uppershutdown(&wstate, state);
+
+	/* See _bt_load() about why this is necessary */
+	if (RelationNeedsWAL(wstate.index))
+	{
+		RelationOpenSmgr(wstate.index);
+		smgrimmedsync(wstate.index->rd_smgr, MAIN_FORKNUM);
+	}
+}
+
+/*
+ * Read the next leaf page of a key range into newly allocated workspace.
+ */
+static Page
+_bt_range_readpage(BufFile *file)
+{
+	Page		page = (Page) palloc(BLCKSZ);
+
+	if (BufFileRead(file, page, BLCKSZ) != BLCKSZ)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not read from temporary file: %m")));
+
+	return page;
+}
+
+/*
+ * Create parallel context, and launch workers for leader.
+ *
+ * buildstate argument should be initialized (with the exception of the
+ * tuplesort state in spools, which may later be created based on shared
+ * state initially set up here).
+ *
+ * isconcurrent indicates if operation is CREATE INDEX CONCURRENTLY.
+ *
+ * request is the target number of parallel worker processes to launch.
+ *
+ * Sets buildstate's BTLeader, which caller must use to shut down parallel
+ * mode by passing it to _bt_end_parallel() at the very end of its index
+ * build.  If not even a single worker process can be launched, this is
+ * never set, and caller should proceed with a serial index build.
+ */
+static void
+_bt_begin_parallel(BTBuildState *buildstate, bool isconcurrent, int request)
+{
+	ParallelContext *pcxt;
+	int			scantuplesortstates;
+	Snapshot	snapshot;
+	Size		estbtshared;
+	Size		estsort;
+	BTShared   *btshared;
+	Sharedsort *sharedsort;
+	Sharedsort *sharedsort2;
+	BTSpool    *btspool = buildstate->spool;
+	BTLeader   *btleader = (BTLeader *) palloc0(sizeof(BTLeader));
+	bool		leaderparticipates = true;
+	char	   *sharedquery;
+	int			querylen;
+	int			nranges = 1;
+	IndexTuple *splitters = NULL;
+	Size		estranges = 0;
+	BTRanges   *ranges = NULL;
+	int			i;
+
+#ifdef DISABLE_LEADER_PARTICIPATION
+	leaderparticipates = false;
+#endif
 
-	/*
-	 * Enter parallel mode, and create context for parallel build of btree
-	 * index
-	 */
-	EnterParallelMode();
 	Assert(request > 0);
+	scantuplesortstates = leaderparticipates ? request + 1 : request;
+
+	/*
+	 * Decide whether to range partition the build, with one key range per
+	 * planned participant.  Each participant needs a tuplesort per range, so
+	 * make sure that they all get a reasonable amount of memory.  The
+	 * splitters are chosen before entering parallel mode, since sampling may
+	 * have to wait for concurrent transactions just like the scan proper.
+	 */
+#ifndef DISABLE_RANGE_PARTITIONING
+	if (maintenance_work_mem / scantuplesortstates / scantuplesortstates >=
+		BTREE_MIN_RANGE_SORT_MEM)
+		nranges = _bt_sample_splitters(btspool->heap, btspool->index,
+									   isconcurrent, scantuplesortstates,
+									   &splitters) + 1;
+#endif
+
+	/*
+	 * Enter parallel mode, and create context for parallel build of btree
+	 * index
+	 */
+	EnterParallelMode();
 	pcxt = CreateParallelContext("postgres", "_bt_parallel_build_main",
 								 request, true);
-	scantuplesortstates = leaderparticipates ? request + 1 : request;
 
 	/*
 	 * Prepare for scan of the base relation.  In a normal index build, we use
@@ -1276,9 +1891,22 @@ _bt_begin_parallel(BTBuildState *buildstate, bool isconcurrent, int request)
 	 */
 	estbtshared = _bt_parallel_estimate_shared(snapshot);
 	shm_toc_estimate_chunk(&pcxt->estimator, estbtshared);
-	estsort = tuplesort_estimate_shared(scantuplesortstates);
+	estsort = mul_size(MAXALIGN(tuplesort_estimate_shared(scantuplesortstates)),
+					   nranges);
 	shm_toc_estimate_chunk(&pcxt->estimator, estsort);
 
+	/* Range partitioned builds also need PARALLEL_KEY_BTREE_RANGES */
+	if (nranges > 1)
+	{
+		estranges = MAXALIGN(offsetof(BTRanges, npages) +
+							 sizeof(BlockNumber) * nranges);
+		for (i = 0; i < nranges - 1; i++)
+			estranges = add_size(estranges,
+								 MAXALIGN(IndexTupleSize(splitters[i])));
+		shm_toc_estimate_chunk(&pcxt->estimator, estranges);
+		shm_toc_estimate_keys(&pcxt->estimator, 1);
+	}
+
 	/*
 	 * Unique case requires a second spool, and so we may have to account for
 	 * another shared workspace for that -- PARALLEL_KEY_TUPLESORT_SPOOL2
@@ -1307,6 +1935,9 @@ _bt_begin_parallel(BTBuildState *buildstate, bool isconcurrent, int request)
 	btshared->isunique = btspool->isunique;
 	btshared->isconcurrent = isconcurrent;
 	btshared->scantuplesortstates = scantuplesortstates;
+	btshared->nranges = nranges;
+	if (nranges > 1)
+		SharedFileSetInit(&btshared->leaffileset, pcxt->seg);
 	ConditionVariableInit(&btshared->workersdonecv);
 	SpinLockInit(&btshared->mutex);
 	/* Initialize mutable state */
@@ -1315,6 +1946,9 @@ _bt_begin_parallel(BTBuildState *buildstate, bool isconcurrent, int request)
 	btshared->havedead = false;
 	btshared->indtuples = 0.0;
 	btshared->brokenhotchain = false;
+	btshared->nparticipants = -1;
+	btshared->nextrange = 0;
+	btshared->nrangesdone = 0;
 	heap_parallelscan_initialize(&btshared->heapdesc, btspool->heap, snapshot);
 
 	/*
@@ -1322,8 +1956,9 @@ _bt_begin_parallel(BTBuildState *buildstate, bool isconcurrent, int request)
 	 * Then, initialize opaque state using tuplesort routine.
 	 */
 	sharedsort = (Sharedsort *) shm_toc_allocate(pcxt->toc, estsort);
-	tuplesort_initialize_shared(sharedsort, scantuplesortstates,
-								pcxt->seg);
+	for (i = 0; i < nranges; i++)
+		tuplesort_initialize_shared(_bt_range_sharedsort(btshared, sharedsort, i),
+									scantuplesortstates, pcxt->seg);
 
 	shm_toc_insert(pcxt->toc, PARALLEL_KEY_BTREE_SHARED, btshared);
 	shm_toc_insert(pcxt->toc, PARALLEL_KEY_TUPLESORT, sharedsort);
@@ -1339,12 +1974,33 @@ _bt_begin_parallel(BTBuildState *buildstate, bool isconcurrent, int request)
 		 * routine.
 		 */
 		sharedsort2 = (Sharedsort *) shm_toc_allocate(pcxt->toc, estsort);
-		tuplesort_initialize_shared(sharedsort2, scantuplesortstates,
-									pcxt->seg);
+		for (i = 0; i < nranges; i++)
+			tuplesort_initialize_shared(_bt_range_sharedsort(btshared,
+															 sharedsort2, i),
+										scantuplesortstates, pcxt->seg);
 
 		shm_toc_insert(pcxt->toc, PARALLEL_KEY_TUPLESORT_SPOOL2, sharedsort2);
 	}
 
+	/* Store key ranges and splitters, if range partitioning */
+	if (nranges > 1)
+	{
+		char	   *ptr;
+
+		ranges = (BTRanges *) shm_toc_allocate(pcxt->toc, estranges);
+		ranges->nranges = nranges;
+		ptr = BTRangesSplitters(ranges);
+		for (i = 0; i < nranges - 1; i++)
+		{
+			memcpy(ptr, splitters[i], IndexTupleSize(splitters[i]));
+			ptr += MAXALIGN(IndexTupleSize(splitters[i]));
+			pfree(splitters[i]);
+		}
+		pfree(splitters);
+
+		shm_toc_insert(pcxt->toc, PARALLEL_KEY_BTREE_RANGES, ranges);
+	}
+
 	/* Store query string for workers */
 	sharedquery = (char *) shm_toc_allocate(pcxt->toc, querylen + 1);
 	memcpy(sharedquery, debug_query_string, querylen + 1);
@@ -1360,6 +2016,16 @@ _bt_begin_parallel(BTBuildState *buildstate, bool isconcurrent, int request)
 	btleader->sharedsort = sharedsort;
 	btleader->sharedsort2 = sharedsort2;
 	btleader->snapshot = snapshot;
+	btleader->ranges = ranges;
+
+	/*
+	 * Tell participants in a range partitioned build how many of them have to
+	 * finish scanning before any range can be merged
+	 */
+	SpinLockAcquire(&btshared->mutex);
+	btshared->nparticipants = btleader->nparticipanttuplesorts;
+	SpinLockRelease(&btshared->mutex);
+	ConditionVariableBroadcast(&btshared->workersdonecv);
 
 	/* If no workers were successfully launched, back out (do serial build) */
 	if (pcxt->nworkers_launched == 0)
@@ -1371,6 +2037,14 @@ _bt_begin_parallel(BTBuildState *buildstate, bool isconcurrent, int request)
 	/* Save leader state now that it's clear build will be parallel */
 	buildstate->btleader = btleader;
 
+	/*
+	 * In a range partitioned build, participants wait for each other before
+	 * merging ranges, so make sure that none of the workers failed to start
+	 * before we join them.
+	 */
+	if (ranges && leaderparticipates)
+		WaitForParallelWorkersToAttach(pcxt);
+
 	/* Join heap scan ourselves */
 	if (leaderparticipates)
 		_bt_leader_participate_as_worker(buildstate);
@@ -1499,7 +2173,7 @@ _bt_leader_participate_as_worker(BTBuildState *buildstate)
 	/* Perform work common to all participants */
 	_bt_parallel_scan_and_sort(leaderworker, leaderworker2, btleader->btshared,
 							   btleader->sharedsort, btleader->sharedsort2,
-							   sortmem);
+							   btleader->ranges, sortmem);
 
 #ifdef BTREE_BUILD_STATS
 	if (log_btree_build_stats)
@@ -1522,11 +2196,13 @@ _bt_parallel_build_main(dsm_segment *seg, shm_toc *toc)
 	BTShared   *btshared;
 	Sharedsort *sharedsort;
 	Sharedsort *sharedsort2;
+	BTRanges   *ranges;
 	Relation	heapRel;
 	Relation	indexRel;
 	LOCKMODE	heapLockmode;
 	LOCKMODE	indexLockmode;
 	int			sortmem;
+	int			i;
 
 #ifdef BTREE_BUILD_STATS
 	if (log_btree_build_stats)
@@ -1567,7 +2243,9 @@ _bt_parallel_build_main(dsm_segment *seg, shm_toc *toc)
 
 	/* Look up shared state private to tuplesort.c */
 	sharedsort = shm_toc_lookup(toc, PARALLEL_KEY_TUPLESORT, false);
-	tuplesort_attach_shared(sharedsort, seg);
+	for (i = 0; i < btshared->nranges; i++)
+		tuplesort_attach_shared(_bt_range_sharedsort(btshared, sharedsort, i),
+								seg);
 	if (!btshared->isunique)
 	{
 		btspool2 = NULL;
@@ -1584,13 +2262,25 @@ _bt_parallel_build_main(dsm_segment *seg, shm_toc *toc)
 		btspool2->isunique = false;
 		/* Look up shared state private to tuplesort.c */
 		sharedsort2 = shm_toc_lookup(toc, PARALLEL_KEY_TUPLESORT_SPOOL2, false);
-		tuplesort_attach_shared(sharedsort2, seg);
+		for (i = 0; i < btshared->nranges; i++)
+			tuplesort_attach_shared(_bt_range_sharedsort(btshared,
+														 sharedsort2, i),
+									seg);
 	}
 
+	/* Look up key ranges, and attach to leaf page files */
+	if (btshared->nranges > 1)
+	{
+		ranges = shm_toc_lookup(toc, PARALLEL_KEY_BTREE_RANGES, false);
+		SharedFileSetAttach(&btshared->leaffileset, seg);
+	}
+	else
+		ranges = NULL;
+
 	/* Perform sorting of spool, and possibly a spool2 */
 	sortmem = maintenance_work_mem / btshared->scantuplesortstates;
 	_bt_parallel_scan_and_sort(btspool, btspool2, btshared, sharedsort,
-							   sharedsort2, sortmem);
+							   sharedsort2, ranges, sortmem);
 
 #ifdef BTREE_BUILD_STATS
 	if (log_btree_build_stats)
@@ -1614,37 +2304,110 @@ _bt_parallel_build_main(dsm_segment *seg, shm_toc *toc)
  * sortmem is the amount of working memory to use within each worker,
  * expressed in KBs.
  *
+ * In a range partitioned build (ranges is not NULL), there is a "partial"
+ * tuplesort for each key range instead, and once all participants have
+ * finished scanning this goes on to merge ranges and build their leaf pages.
+ *
  * When this returns, workers are done, and need only release resources.
  */
 static void
 _bt_parallel_scan_and_sort(BTSpool *btspool, BTSpool *btspool2,
 						   BTShared *btshared, Sharedsort *sharedsort,
-						   Sharedsort *sharedsort2, int sortmem)
+						   Sharedsort *sharedsort2, BTRanges *ranges,
+						   int sortmem)
 {
 	SortCoordinate coordinate;
 	BTBuildState buildstate;
 	HeapScanDesc scan;
 	double		reltuples;
 	IndexInfo  *indexInfo;
+	int			i;
 
-	/* Initialize local tuplesort coordination state */
-	coordinate = palloc0(sizeof(SortCoordinateData));
-	coordinate->isWorker = true;
-	coordinate->nParticipants = -1;
-	coordinate->sharedsort = sharedsort;
+	/* Fill in buildstate for _bt_build_callback() */
+	buildstate.isunique = btshared->isunique;
+	buildstate.havedead = false;
+	buildstate.heap = btspool->heap;
+	buildstate.spool = btspool;
+	buildstate.spool2 = btspool2;
+	buildstate.indtuples = 0;
+	buildstate.btleader = NULL;
+	buildstate.nranges = 1;
+	buildstate.splitters = NULL;
+	buildstate.splitkeys = NULL;
+	buildstate.rangesorts = NULL;
+	buildstate.rangesorts2 = NULL;
+
+	if (ranges)
+	{
+		int			rangemem = Max(sortmem / ranges->nranges, 64);
+		char	   *ptr;
+
+		/* Set up splitters, and a "partial" tuplesort for each range */
+		buildstate.nranges = ranges->nranges;
+		buildstate.splitters = (IndexTuple *)
+			palloc(sizeof(IndexTuple) * (ranges->nranges - 1));
+		ptr = BTRangesSplitters(ranges);
+		for (i = 0; i < ranges->nranges - 1; i++)
+		{
+			buildstate.splitters[i] = (IndexTuple) ptr;
+			ptr += MAXALIGN(IndexTupleSize(buildstate.splitters[i]));
+		}
+		buildstate.splitkeys = _bt_build_sortkeys(btspool->index);
 
-	/* Begin "partial" tuplesort */
-	btspool->sortstate = tuplesort_begin_index_btree(btspool->heap,
-													 btspool->index,
-													 btspool->isunique,
-													 sortmem, coordinate,
-													 false);
+		buildstate.rangesorts = (Tuplesortstate **)
+			palloc(sizeof(Tuplesortstate *) * ranges->nranges);
+		if (btspool2)
+			buildstate.rangesorts2 = (Tuplesortstate **)
+				palloc(sizeof(Tuplesortstate *) * ranges->nranges);
+
+		for (i = 0; i < ranges->nranges; i++)
+		{
+			coordinate = palloc0(sizeof(SortCoordinateData));
+			coordinate->isWorker = true;
+			coordinate->nParticipants = -1;
+			coordinate->sharedsort = _bt_range_sharedsort(btshared,
+														  sharedsort, i);
+			buildstate.rangesorts[i] =
+				tuplesort_begin_index_btree(btspool->heap, btspool->index,
+											btspool->isunique, rangemem,
+											coordinate, false);
+
+			if (btspool2)
+			{
+				coordinate = palloc0(sizeof(SortCoordinateData));
+				coordinate->isWorker = true;
+				coordinate->nParticipants = -1;
+				coordinate->sharedsort = _bt_range_sharedsort(btshared,
+															  sharedsort2, i);
+				buildstate.rangesorts2[i] =
+					tuplesort_begin_index_btree(btspool->heap, btspool->index,
+												false,
+												Min(rangemem, work_mem),
+												coordinate, false);
+			}
+		}
+	}
+	else
+	{
+		/* Initialize local tuplesort coordination state */
+		coordinate = palloc0(sizeof(SortCoordinateData));
+		coordinate->isWorker = true;
+		coordinate->nParticipants = -1;
+		coordinate->sharedsort = sharedsort;
+
+		/* Begin "partial" tuplesort */
+		btspool->sortstate = tuplesort_begin_index_btree(btspool->heap,
+														 btspool->index,
+														 btspool->isunique,
+														 sortmem, coordinate,
+														 false);
+	}
 
 	/*
 	 * Just as with serial case, there may be a second spool.  If so, a
 	 * second, dedicated spool2 partial tuplesort is required.
 	 */
-	if (btspool2)
+	if (btspool2 && !ranges)
 	{
 		SortCoordinate coordinate2;
 
@@ -1664,15 +2427,6 @@ _bt_parallel_scan_and_sort(BTSpool *btspool, BTSpool *btspool2,
 										false);
 	}
 
-	/* Fill in buildstate for _bt_build_callback() */
-	buildstate.isunique = btshared->isunique;
-	buildstate.havedead = false;
-	buildstate.heap = btspool->heap;
-	buildstate.spool = btspool;
-	buildstate.spool2 = btspool2;
-	buildstate.indtuples = 0;
-	buildstate.btleader = NULL;
-
 	/* Join parallel scan */
 	indexInfo = BuildIndexInfo(btspool->index);
 	indexInfo->ii_Concurrent = btshared->isconcurrent;
@@ -1688,9 +2442,21 @@ _bt_parallel_scan_and_sort(BTSpool *btspool, BTSpool *btspool2,
 	 * tuplesort_performsort() for spool2 if it ends up containing no dead
 	 * tuples (this is disallowed for workers by tuplesort).
 	 */
-	tuplesort_performsort(btspool->sortstate);
-	if (btspool2)
-		tuplesort_performsort(btspool2->sortstate);
+	if (ranges)
+	{
+		for (i = 0; i < ranges->nranges; i++)
+		{
+			tuplesort_performsort(buildstate.rangesorts[i]);
+			if (btspool2)
+				tuplesort_performsort(buildstate.rangesorts2[i]);
+		}
+	}
+	else
+	{
+		tuplesort_performsort(btspool->sortstate);
+		if (btspool2)
+			tuplesort_performsort(btspool2->sortstate);
+	}
 
 	/*
 	 * Done.  Record ambuild statistics, and whether we encountered a broken
@@ -1706,11 +2472,378 @@ _bt_parallel_scan_and_sort(BTSpool *btspool, BTSpool *btspool2,
 		btshared->brokenhotchain = true;
 	SpinLockRelease(&btshared->mutex);
 
-	/* Notify leader */
-	ConditionVariableSignal(&btshared->workersdonecv);
+	/* Notify leader, and other participants waiting to merge ranges */
+	ConditionVariableBroadcast(&btshared->workersdonecv);
 
 	/* We can end tuplesorts immediately */
-	tuplesort_end(btspool->sortstate);
-	if (btspool2)
-		tuplesort_end(btspool2->sortstate);
+	if (ranges)
+	{
+		for (i = 0; i < ranges->nranges; i++)
+		{
+			tuplesort_end(buildstate.rangesorts[i]);
+			if (btspool2)
+				tuplesort_end(buildstate.rangesorts2[i]);
+		}
+
+		/* Now help build the leaf level, one key range at a time */
+		_bt_parallel_build_ranges(btspool, btshared, ranges, sharedsort,
+								  sharedsort2);
+	}
+	else
+	{
+		tuplesort_end(btspool->sortstate);
+		if (btspool2)
+			tuplesort_end(btspool2->sortstate);
+	}
+}
+
+/*
+ * Build the leaf pages of key ranges, once every participant has sorted its
+ * share of the input.
+ *
+ * Each participant, including any participating leader, claims ranges until
+ * none are left.  A range is built by merging the runs of all participants
+ * for that range, just like a serial leader does with the runs of a whole
+ * parallel sort, and pages are written to a shared temporary file for the
+ * leader to copy into the index in _bt_rangebuild().
+ */
+static void
+_bt_parallel_build_ranges(BTSpool *btspool, BTShared *btshared,
+						  BTRanges *ranges, Sharedsort *sharedsort,
+						  Sharedsort *sharedsort2)
+{
+	int			nparticipants;
+	bool		havedead;
+
+	/* Wait for all participants to finish scanning and sorting */
+	for (;;)
+	{
+		SpinLockAcquire(&btshared->mutex);
+		nparticipants = btshared->nparticipants;
+		if (nparticipants > 0 &&
+			btshared->nparticipantsdone == nparticipants)
+		{
+			havedead = btshared->havedead;
+			SpinLockRelease(&btshared->mutex);
+			break;
+		}
+		SpinLockRelease(&btshared->mutex);
+
+		ConditionVariableSleep(&btshared->workersdonecv,
+							   WAIT_EVENT_PARALLEL_CREATE_INDEX_SCAN);
+	}
+
+	ConditionVariableCancelSleep();
+
+	for (;;)
+	{
+		int			range;
+		BTSpool    *rangespool;
+		BTSpool    *rangespool2 = NULL;
+		SortCoordinate coordinate;
+		BTWriteState wstate;
+		char		filename[MAXPGPATH];
+
+		SpinLockAcquire(&btshared->mutex);
+		range = btshared->nextrange++;
+		SpinLockRelease(&btshared->mutex);
+
+		if (range >= ranges->nranges)
+			break;
+
+		/* Take over this range's runs from all participants */
+		rangespool = (BTSpool *) palloc0(sizeof(BTSpool));
+		rangespool->heap = btspool->heap;
+		rangespool->index = btspool->index;
+		rangespool->isunique = btspool->isunique;
+
+		coordinate = (SortCoordinate) palloc0(sizeof(SortCoordinateData));
+		coordinate->isWorker = false;
+		coordinate->nParticipants = nparticipants;
+		coordinate->sharedsort = _bt_range_sharedsort(btshared, sharedsort,
+													  range);
+
+		/* Ranges are merged concurrently, so share out memory between them */
+		rangespool->sortstate =
+			tuplesort_begin_index_btree(rangespool->heap, rangespool->index,
+										rangespool->isunique,
+										maintenance_work_mem / nparticipants,
+										coordinate, false);
+		tuplesort_performsort(rangespool->sortstate);
+
+		/* Dead tuples are needed only for unique index builds */
+		if (havedead)
+		{
+			SortCoordinate coordinate2;
+
+			rangespool2 = (BTSpool *) palloc0(sizeof(BTSpool));
+			rangespool2->heap = btspool->heap;
+			rangespool2->index = btspool->index;
+			rangespool2->isunique = false;
+
+			coordinate2 = (SortCoordinate) palloc0(sizeof(SortCoordinateData));
+			coordinate2->isWorker = false;
+			coordinate2->nParticipants = nparticipants;
+			coordinate2->sharedsort = _bt_range_sharedsort(btshared,
+														   sharedsort2, range);
+
+			rangespool2->sortstate =
+				tuplesort_begin_index_btree(rangespool2->heap,
+											rangespool2->index, false,
+											work_mem, coordinate2, false);
+			tuplesort_performsort(rangespool2->sortstate);
+		}
+
+		/* Write out the range's leaf pages */
+		_bt_range_filename(filename, range);
+		wstate.heap = btspool->heap;
+		wstate.index = btspool->index;
+		wstate.btws_use_wal = false;
+		wstate.btws_pages_alloced = 0;
+		wstate.btws_pages_written = 0;
+		wstate.btws_zeropage = NULL;
+		wstate.btws_leaffile = BufFileCreateShared(&btshared->leaffileset,
+												   filename);
+
+		_bt_load(&wstate, rangespool, rangespool2);
+
+		BufFileExportShared(wstate.btws_leaffile);
+		BufFileClose(wstate.btws_leaffile);
+
+		_bt_spooldestroy(rangespool);
+		if (rangespool2)
+			_bt_spooldestroy(rangespool2);
+
+		SpinLockAcquire(&btshared->mutex);
+		ranges->npages[range] = wstate.btws_pages_written;
+		btshared->nrangesdone++;
+		SpinLockRelease(&btshared->mutex);
+
+		/* Notify leader */
+		ConditionVariableBroadcast(&btshared->workersdonecv);
+	}
+}
+
+/*
+ * Return a pointer to shared tuplesort state for a key range, within an
+ * array of nranges such states.
+ */
+static Sharedsort *
+_bt_range_sharedsort(BTShared *btshared, Sharedsort *sharedsort, int range)
+{
+	Size		estsort;
+
+	estsort = MAXALIGN(tuplesort_estimate_shared(btshared->scantuplesortstates));
+
+	return (Sharedsort *) ((char *) sharedsort + estsort * range);
+}
+
+/*
+ * Name of the shared temporary file holding a key range's leaf pages.
+ */
+static void
+_bt_range_filename(char *name, int range)
+{
+	snprintf(name, MAXPGPATH, "btleaf.%d", range);
+}
+
+/*
+ * Choose up to nranges - 1 splitters that divide the keys to be indexed into
+ * key ranges of roughly equal size, based on a random sample of heap tuples.
+ *
+ * Returns the number of splitters chosen, palloc'd in *splitters.  Zero is
+ * returned if we fail to find enough distinct keys, in which case the caller
+ * should not partition the build.
+ */
+static int
+_bt_sample_splitters(Relation heap, Relation index, bool isconcurrent,
+					 int nranges, IndexTuple **splitters)
+{
+	IndexInfo  *indexInfo;
+	BTSampleState sample;
+	BlockSamplerData bs;
+	int			nsplitters = 0;
+	int			i;
+
+	indexInfo = BuildIndexInfo(index);
+	indexInfo->ii_Concurrent = isconcurrent;
+
+	sample.maxtuples = BTREE_SAMPLE_PER_RANGE * nranges;
+	sample.tuples = (IndexTuple *) palloc(sample.maxtuples * sizeof(IndexTuple));
+	sample.ntuples = 0;
+	sample.seen = 0;
+	sampler_random_init_state(random(), sample.randstate);
+
+	BlockSampler_Init(&bs, RelationGetNumberOfBlocks(heap), sample.maxtuples,
+					  random());
+	while (BlockSampler_HasMore(&bs))
+	{
+		BlockNumber blkno = BlockSampler_Next(&bs);
+
+		CHECK_FOR_INTERRUPTS();
+
+		IndexBuildHeapRangeScan(heap, index, indexInfo, false, false,
+								blkno, 1, _bt_sample_callback,
+								(void *) &sample, NULL);
+	}
+
+	*splitters = NULL;
+	if (sample.ntuples >= nranges)
+	{
+		BTKeyCompare cmp;
+		IndexTuple	prev = sample.tuples[0];
+
+		cmp.sortKeys = _bt_build_sortkeys(index);
+		cmp.keysz = IndexRelationGetNumberOfKeyAttributes(index);
+		cmp.tupdesc = RelationGetDescr(index);
+
+		qsort_arg(sample.tuples, sample.ntuples, sizeof(IndexTuple),
+				  _bt_sample_cmp, &cmp);
+
+		/*
+		 * Take evenly spaced sample tuples, skipping duplicate keys: all
+		 * tuples with equal keys must go in the same range.
+		 */
+		*splitters = (IndexTuple *) palloc((nranges - 1) * sizeof(IndexTuple));
+		for (i = 1; i < nranges; i++)
+		{
+			IndexTuple	candidate;
+
+			candidate = sample.tuples[(int) ((int64) i * sample.ntuples / nranges)];
+			if (_bt_sample_cmp(&candidate, &prev, &cmp) == 0)
+				continue;
+			(*splitters)[nsplitters++] = CopyIndexTuple(candidate);
+			prev = candidate;
+		}
+
+		pfree(cmp.sortKeys);
+
+		if (nsplitters == 0)
+		{
+			pfree(*splitters);
+			*splitters = NULL;
+		}
+	}
+
+	for (i = 0; i < sample.ntuples; i++)
+		pfree(sample.tuples[i]);
+	pfree(sample.tuples);
+	pfree(indexInfo);
+
+	return nsplitters;
+}
+
+/*
+ * Per-tuple callback for heap sampling.  Keeps a simple random sample of the
+ * index tuples seen, using Vitter's Algorithm R.
+ */
+static void
+_bt_sample_callback(Relation index,
+					HeapTuple htup,
+					Datum *values,
+					bool *isnull,
+					bool tupleIsAlive,
+					void *state)
+{
+	BTSampleState *sample = (BTSampleState *) state;
+	IndexTuple	itup;
+
+	if (sample->ntuples < sample->maxtuples)
+	{
+		itup = index_form_tuple(RelationGetDescr(index), values, isnull);
+		sample->tuples[sample->ntuples++] = itup;
+	}
+	else
+	{
+		int64		k;
+
+		k = (int64) (sampler_random_fract(sample->randstate) *
+					 (sample->seen + 1));
+		if (k < sample->maxtuples)
+		{
+			itup = index_form_tuple(RelationGetDescr(index), values, isnull);
+			pfree(sample->tuples[k]);
+			sample->tuples[k] = itup;
+		}
+	}
+
+	sample->seen += 1;
+}
+
+/*
+ * qsort_arg comparator for sampled index tuples, comparing key attributes
+ */
+static int
+_bt_sample_cmp(const void *a, const void *b, void *arg)
+{
+	IndexTuple	itup1 = *(const IndexTuple *) a;
+	IndexTuple	itup2 = *(const IndexTuple *) b;
+	BTKeyCompare *cmp = (BTKeyCompare *) arg;
+	int			i;
+
+	for (i = 1; i <= cmp->keysz; i++)
+	{
+		SortSupport entry = cmp->sortKeys + i - 1;
+		Datum		attrDatum1,
+					attrDatum2;
+		bool		isNull1,
+					isNull2;
+		int32		compare;
+
+		attrDatum1 = index_getattr(itup1, i, cmp->tupdesc, &isNull1);
+		attrDatum2 = index_getattr(itup2, i, cmp->tupdesc, &isNull2);
+
+		compare = ApplySortComparator(attrDatum1, isNull1,
+									  attrDatum2, isNull2,
+									  entry);
+		if (compare != 0)
+			return compare;
+	}
+
+	return 0;
+}
+
+/*
+ * Determine the key range an index tuple belongs to.
+ *
+ * Range i holds keys that are >= splitter i - 1, and < splitter i.  Only key
+ * attributes are compared, so that equal keys never go in different ranges.
+ */
+static int
+_bt_keyrange(BTBuildState *buildstate, Relation index, Datum *values,
+			 bool *isnull)
+{
+	TupleDesc	tupdes = RelationGetDescr(index);
+	int			keysz = IndexRelationGetNumberOfKeyAttributes(index);
+	int			lo = 0;
+	int			hi = buildstate->nranges - 1;
+
+	while (lo < hi)
+	{
+		int			mid = lo + (hi - lo) / 2;
+		IndexTuple	splitter = buildstate->splitters[mid];
+		int32		compare = 0;
+		int			i;
+
+		for (i = 1; i <= keysz; i++)
+		{
+			SortSupport entry = buildstate->splitkeys + i - 1;
+			Datum		attrDatum;
+			bool		isNull;
+
+			attrDatum = index_getattr(splitter, i, tupdes, &isNull);
+			compare = ApplySortComparator(values[i - 1], isnull[i - 1],
+										  attrDatum, isNull,
+										  entry);
+			if (compare != 0)
+				break;
+		}
+
+		if (compare >= 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
 }
@@ -22,6 +22,7 @@
 #include "access/relscan.h"
 #include "miscadmin.h"
 #include "utils/array.h"
+#include "utils/datum.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/rel.h"
@@ -56,7 +57,10 @@ static bool _bt_check_rowcompare(ScanKey skey,
  *		Build an insertion scan key that contains comparison data from itup
  *		as well as comparator routines appropriate to the key datatypes.
  *
- *		The result is intended for use with _bt_compare().
+ *		The result is intended for use with _bt_compare().  If itup is a
+ *		pivot tuple whose trailing key attributes were truncated away, the
+ *		scan key only covers the attributes it still has, so callers must
+ *		use BTreeTupleGetNKeyAtts(itup, rel) as the key size.
  */
 ScanKey
 _bt_mkscankey(Relation rel, IndexTuple itup)
@@ -65,18 +69,20 @@ _bt_mkscankey(Relation rel, IndexTuple itup)
 	TupleDesc	itupdesc;
 	int			indnatts PG_USED_FOR_ASSERTS_ONLY;
 	int			indnkeyatts;
+	int			tupnkeyatts;
 	int16	   *indoption;
 	int			i;
 
 	itupdesc = RelationGetDescr(rel);
 	indnatts = IndexRelationGetNumberOfAttributes(rel);
 	indnkeyatts = IndexRelationGetNumberOfKeyAttributes(rel);
+	tupnkeyatts = BTreeTupleGetNKeyAtts(itup, rel);
 	indoption = rel->rd_indoption;
 
 	Assert(indnkeyatts > 0);
 	Assert(indnkeyatts <= indnatts);
 	Assert(BTreeTupleGetNAtts(itup, rel) == indnatts ||
-		   BTreeTupleGetNAtts(itup, rel) == indnkeyatts);
+		   BTreeTupleGetNAtts(itup, rel) <= indnkeyatts);
 
 	/*
 	 * We'll execute search using scan key constructed on key columns. Non-key
@@ -84,7 +90,7 @@ _bt_mkscankey(Relation rel, IndexTuple itup)
 	 */
 	skey = (ScanKey) palloc(indnkeyatts * sizeof(ScanKeyData));
 
-	for (i = 0; i < indnkeyatts; i++)
+	for (i = 0; i < tupnkeyatts; i++)
 	{
 		FmgrInfo   *procinfo;
 		Datum		arg;
@@ -667,14 +673,315 @@ _bt_restore_array_keys(IndexScanDesc scan)
 	}
 }
 
+/*
+ *	_bt_preprocess_skip_key() -- Set up a skip scan, if requested
+ *
+ * Without a key on the first index column, keys on the later columns can't
+ * limit the portion of the index that is scanned.  If the caller has asked
+ * for a skip scan (because the planner expects the first column to have few
+ * distinct values), and the second column has keys, we instead add an
+ * equality key on the first column in front of the other keys, and run one
+ * primitive index scan per distinct value of the first column, much as if
+ * the query had said "col1 = ANY(all values of col1)".  The values are found
+ * as we go: _bt_readpage notes the one it runs into at the end of each
+ * primitive scan (see _bt_skip_note_next), and otherwise
+ * _bt_skip_find_value looks up the next one in the index.
+ *
+ * The modified keys are set up in so->arrayKeyData, with the skip key
+ * first, so that _bt_preprocess_keys marks the keys on the second column as
+ * required just as it would for a real equality key.
+ *
+ * Parallel scans don't skip, since the participants would each have to
+ * find their own way through the distinct values.
+ */
+void
+_bt_preprocess_skip_key(IndexScanDesc scan)
+{
+	BTScanOpaque so = (BTScanOpaque) scan->opaque;
+	Relation	rel = scan->indexRelation;
+	Form_pg_attribute attr = TupleDescAttr(RelationGetDescr(rel), 0);
+	ScanKey		inkeys;
+	Oid			eq_opr;
+	int			i;
+	MemoryContext oldContext;
+
+	so->skipKey = NULL;
+
+	/*
+	 * The input keys are sorted by attribute, so there must be no key on the
+	 * first column and at least one on the second if the first key is on the
+	 * second column.
+	 */
+	if (!scan->xs_want_skip ||
+		scan->parallel_scan != NULL ||
+		so->numArrayKeys < 0 ||
+		IndexRelationGetNumberOfKeyAttributes(rel) < 2 ||
+		scan->numberOfKeys < 1 ||
+		scan->keyData[0].sk_attno != 2)
+		return;
+
+	eq_opr = get_opfamily_member(rel->rd_opfamily[0],
+								 rel->rd_opcintype[0],
+								 rel->rd_opcintype[0],
+								 BTEqualStrategyNumber);
+	if (!OidIsValid(eq_opr))
+		return;					/* shouldn't happen, but just scan it all */
+
+	/*
+	 * Allocate the skip scan's data in the array context, resetting it if a
+	 * previous rescan cycle left anything there that the array keys don't
+	 * still need.
+	 */
+	if (so->arrayContext == NULL)
+		so->arrayContext = AllocSetContextCreate(CurrentMemoryContext,
+												 "BTree array context",
+												 ALLOCSET_SMALL_SIZES);
+	else if (so->numArrayKeys == 0)
+		MemoryContextReset(so->arrayContext);
+
+	oldContext = MemoryContextSwitchTo(so->arrayContext);
+
+	inkeys = (ScanKey) palloc((scan->numberOfKeys + 1) * sizeof(ScanKeyData));
+	ScanKeyEntryInitialize(&inkeys[0],
+						   0,
+						   1,
+						   BTEqualStrategyNumber,
+						   InvalidOid,
+						   rel->rd_indcollation[0],
+						   get_opcode(eq_opr),
+						   (Datum) 0);
+	memcpy(inkeys + 1,
+		   so->arrayKeyData != NULL ? so->arrayKeyData : scan->keyData,
+		   scan->numberOfKeys * sizeof(ScanKeyData));
+
+	/* the array keys moved up one place */
+	for (i = 0; i < so->numArrayKeys; i++)
+		so->arrayKeys[i].scan_key++;
+	so->arrayKeyData = inkeys;
+
+	so->skipKey = (BTSkipKeyInfo *) palloc0(sizeof(BTSkipKeyInfo));
+	so->skipKey->attlen = attr->attlen;
+	so->skipKey->attbyval = attr->attbyval;
+
+	MemoryContextSwitchTo(oldContext);
+}
+
+/*
+ * _bt_start_skip_key() -- Initialize the skip key at start of a scan
+ *
+ * Finds the first value of the first index column in the scan direction.
+ * Returns false if the index is empty.
+ */
+bool
+_bt_start_skip_key(IndexScanDesc scan, ScanDirection dir)
+{
+	BTScanOpaque so = (BTScanOpaque) scan->opaque;
+	BTSkipKeyInfo *skip = so->skipKey;
+
+	if (skip->next_valid && !skip->next_null && !skip->attbyval)
+		pfree(DatumGetPointer(skip->next_value));
+	skip->next_valid = false;
+
+	/* forget the current value, so that we look for the first one */
+	if (skip->cur_valid)
+	{
+		ScanKey		skey = &so->arrayKeyData[0];
+
+		if (!(skey->sk_flags & SK_ISNULL) && !skip->attbyval)
+			pfree(DatumGetPointer(skey->sk_argument));
+		skip->cur_valid = false;
+	}
+
+	return _bt_skip_find_value(scan, dir);
+}
+
+/*
+ * _bt_advance_skip_key() -- Advance to the next value of the first column
+ *
+ * Returns true if there is another value to consider, false if not.  On
+ * true result, the skip key is set to the new value.  The caller must have
+ * finished the primitive scan for the current value, so that any next value
+ * noted by _bt_readpage is the right one.
+ */
+bool
+_bt_advance_skip_key(IndexScanDesc scan, ScanDirection dir)
+{
+	BTScanOpaque so = (BTScanOpaque) scan->opaque;
+	BTSkipKeyInfo *skip = so->skipKey;
+
+	if (skip->next_valid)
+	{
+		skip->next_valid = false;
+		if (skip->next_dir == dir)
+		{
+			_bt_skip_set_value(scan, skip->next_value, skip->next_null);
+			if (!skip->next_null && !skip->attbyval)
+				pfree(DatumGetPointer(skip->next_value));
+			return true;
+		}
+		/* noted while scanning the other way, so useless */
+		if (!skip->next_null && !skip->attbyval)
+			pfree(DatumGetPointer(skip->next_value));
+	}
+
+	return _bt_skip_find_value(scan, dir);
+}
+
+/*
+ * _bt_skip_set_value() -- Store a copy of value in the skip key
+ */
+void
+_bt_skip_set_value(IndexScanDesc scan, Datum value, bool isnull)
+{
+	BTScanOpaque so = (BTScanOpaque) scan->opaque;
+	BTSkipKeyInfo *skip = so->skipKey;
+	ScanKey		skey = &so->arrayKeyData[0];
+
+	if (skip->cur_valid && !(skey->sk_flags & SK_ISNULL) && !skip->attbyval)
+		pfree(DatumGetPointer(skey->sk_argument));
+
+	if (isnull)
+	{
+		/* It's an IS NULL key now; _bt_fix_scankey_strategy does the rest */
+		skey->sk_flags |= (SK_ISNULL | SK_SEARCHNULL);
+		skey->sk_argument = (Datum) 0;
+	}
+	else
+	{
+		MemoryContext oldContext;
+
+		skey->sk_flags &= ~(SK_ISNULL | SK_SEARCHNULL);
+		skey->sk_strategy = BTEqualStrategyNumber;
+		skey->sk_subtype = InvalidOid;
+		skey->sk_collation = scan->indexRelation->rd_indcollation[0];
+
+		oldContext = MemoryContextSwitchTo(so->arrayContext);
+		skey->sk_argument = datumCopy(value, skip->attbyval, skip->attlen);
+		MemoryContextSwitchTo(oldContext);
+	}
+
+	skip->cur_valid = true;
+}
+
+/*
+ * Are the skip key's current value and the given one the same?
+ */
+static bool
+_bt_skip_same_value(IndexScanDesc scan, Datum value, bool isnull)
+{
+	BTScanOpaque so = (BTScanOpaque) scan->opaque;
+	Relation	rel = scan->indexRelation;
+	ScanKey		skey = &so->arrayKeyData[0];
+
+	if (isnull || (skey->sk_flags & SK_ISNULL))
+		return isnull && (skey->sk_flags & SK_ISNULL) != 0;
+
+	return DatumGetInt32(FunctionCall2Coll(index_getprocinfo(rel, 1,
+															 BTORDER_PROC),
+										   rel->rd_indcollation[0],
+										   value,
+										   skey->sk_argument)) == 0;
+}
+
+/*
+ * _bt_skip_note_next() -- Remember the next value for a skip scan
+ *
+ * Called by _bt_readpage for the tuple at offnum that ended the current
+ * primitive scan.  If the tuple no longer matches the skip key, its first
+ * column holds the next value in the scan direction, which saves
+ * _bt_advance_skip_key from descending the tree to find it.
+ *
+ * Caller must hold pin and lock on the index page.
+ */
+void
+_bt_skip_note_next(IndexScanDesc scan, ScanDirection dir, Page page,
+				   OffsetNumber offnum)
+{
+	BTScanOpaque so = (BTScanOpaque) scan->opaque;
+	BTSkipKeyInfo *skip = so->skipKey;
+	IndexTuple	itup;
+	Datum		value;
+	bool		isnull;
+	MemoryContext oldContext;
+
+	itup = (IndexTuple) PageGetItem(page, PageGetItemId(page, offnum));
+	value = index_getattr(itup, 1, RelationGetDescr(scan->indexRelation),
+						  &isnull);
+
+	if (_bt_skip_same_value(scan, value, isnull))
+		return;					/* stopped by a key on a later column */
+
+	if (skip->next_valid && !skip->next_null && !skip->attbyval)
+		pfree(DatumGetPointer(skip->next_value));
+
+	oldContext = MemoryContextSwitchTo(so->arrayContext);
+	skip->next_value = isnull ? (Datum) 0 :
+		datumCopy(value, skip->attbyval, skip->attlen);
+	MemoryContextSwitchTo(oldContext);
+	skip->next_null = isnull;
+	skip->next_dir = dir;
+	skip->next_valid = true;
+}
+
+/*
+ * _bt_mark_skip_key() -- Handle the skip key during btmarkpos
+ */
+void
+_bt_mark_skip_key(IndexScanDesc scan)
+{
+	BTScanOpaque so = (BTScanOpaque) scan->opaque;
+	BTSkipKeyInfo *skip = so->skipKey;
+	ScanKey		skey = &so->arrayKeyData[0];
+	MemoryContext oldContext;
+
+	if (skip->mark_valid && !skip->mark_null && !skip->attbyval)
+		pfree(DatumGetPointer(skip->mark_value));
+	skip->mark_valid = skip->cur_valid;
+	if (!skip->cur_valid)
+		return;
+
+	skip->mark_null = (skey->sk_flags & SK_ISNULL) != 0;
+	oldContext = MemoryContextSwitchTo(so->arrayContext);
+	skip->mark_value = skip->mark_null ? (Datum) 0 :
+		datumCopy(skey->sk_argument, skip->attbyval, skip->attlen);
+	MemoryContextSwitchTo(oldContext);
+}
+
+/*
+ * _bt_restore_skip_key() -- Handle the skip key during btrestrpos
+ *
+ * As for array keys, we must redo _bt_preprocess_keys if the value changed.
+ */
+void
+_bt_restore_skip_key(IndexScanDesc scan)
+{
+	BTScanOpaque so = (BTScanOpaque) scan->opaque;
+	BTSkipKeyInfo *skip = so->skipKey;
+
+	/* whatever comes after the current position, it isn't that any more */
+	if (skip->next_valid && !skip->next_null && !skip->attbyval)
+		pfree(DatumGetPointer(skip->next_value));
+	skip->next_valid = false;
+
+	if (!skip->mark_valid ||
+		(skip->cur_valid &&
+		 _bt_skip_same_value(scan, skip->mark_value, skip->mark_null)))
+		return;
+
+	_bt_skip_set_value(scan, skip->mark_value, skip->mark_null);
+	_bt_preprocess_keys(scan);
+	Assert(so->qual_ok);
+}
+
 
 /*
  *	_bt_preprocess_keys() -- Preprocess scan keys
  *
  * The given search-type keys (in scan->keyData[] or so->arrayKeyData[])
  * are copied to so->keyData[] with possible transformation.
- * scan->numberOfKeys is the number of input keys, so->numberOfKeys gets
- * the number of output keys (possibly less, never greater).
+ * scan->numberOfKeys is the number of input keys (plus one for a skip scan,
+ * see _bt_preprocess_skip_key), so->numberOfKeys gets the number of output
+ * keys (possibly less, never greater).
  *
  * The output keys are marked with additional sk_flag bits beyond the
  * system-standard bits supplied by the caller.  The DESC and NULLS_FIRST
@@ -784,6 +1091,10 @@ _bt_preprocess_keys(IndexScanDesc scan)
 	else
 		inkeys = scan->keyData;
 
+	/* A skip scan's key on the first column comes before the others */
+	if (so->skipKey != NULL)
+		numberOfKeys++;
+
 	outkeys = so->keyData;
 	cur = &inkeys[0];
 	/* we check that input keys are correctly ordered */
@@ -1812,8 +2123,43 @@ _bt_killitems(IndexScanDesc scan)
 		{
 			ItemId		iid = PageGetItemId(page, offnum);
 			IndexTuple	ituple = (IndexTuple) PageGetItem(page, iid);
+			bool		killtuple = false;
+
+			if (BTreeTupleIsPosting(ituple))
+			{
+				int			pi = i + 1;
+				int			nposting = BTreeTupleGetNPosting(ituple);
+				int			j;
+
+				/*
+				 * A posting list tuple can only be marked dead when all of
+				 * its heap TIDs were killed.  _bt_readpage() saved them as
+				 * consecutive items in posting list order whatever the scan
+				 * direction, so they appear consecutively in killedItems[]
+				 * too.
+				 */
+				for (j = 0; j < nposting; j++)
+				{
+					ItemPointer item = BTreeTupleGetPostingN(ituple, j);
+
+					if (!ItemPointerEquals(item, &kitem->heapTid))
+						break;	/* out of posting list loop */
+
+					/* kitem must have matching offnum when heap TIDs match */
+					Assert(kitem->indexOffset == offnum);
+
+					/* Read-ahead to later kitems here */
+					if (pi < numKilled)
+						kitem = &so->currPos.items[so->killedItems[pi++]];
+				}
 
-			if (ItemPointerEquals(&ituple->t_tid, &kitem->heapTid))
+				if (j == nposting)
+					killtuple = true;
+			}
+			else if (ItemPointerEquals(&ituple->t_tid, &kitem->heapTid))
+				killtuple = true;
+
+			if (killtuple)
 			{
 				/* found the item */
 				ItemIdMarkDead(iid);
@@ -2083,36 +2429,91 @@ btproperty(Oid index_oid, int attno,
 }
 
 /*
- *	_bt_nonkey_truncate() -- create tuple without non-key suffix attributes.
+ *	_bt_keep_natts() -- number of attributes a new pivot tuple must keep.
  *
- * Returns truncated index tuple allocated in caller's memory context, with key
- * attributes copied from caller's itup argument.  Currently, suffix truncation
- * is only performed to create pivot tuples in INCLUDE indexes, but some day it
- * could be generalized to remove suffix attributes after the first
- * distinguishing key attribute.
+ * Called when a leaf page is split between lastleft and firstright, to find
+ * how many leading key attributes of firstright its high key needs so that
+ * it still separates the two halves: the attributes up to and including the
+ * first one on which lastleft and firstright differ.  The attributes after
+ * that can be truncated away; _bt_compare() treats them as minus infinity,
+ * which still makes the pivot greater than every item on the left half.
+ * When the items are equal on all key attributes (duplicates), every key
+ * attribute has to be kept.
+ *
+ * Attributes are compared using the opclass's ordering support function,
+ * not by their binary representation, since the pivot only has to be
+ * correctly ordered against the items around it.
+ */
+int
+_bt_keep_natts(Relation rel, IndexTuple lastleft, IndexTuple firstright)
+{
+	TupleDesc	itupdesc = RelationGetDescr(rel);
+	int			nkeyatts = IndexRelationGetNumberOfKeyAttributes(rel);
+	int			keepnatts;
+
+	for (keepnatts = 1; keepnatts < nkeyatts; keepnatts++)
+	{
+		Datum		datum1,
+					datum2;
+		bool		isNull1,
+					isNull2;
+
+		datum1 = index_getattr(lastleft, keepnatts, itupdesc, &isNull1);
+		datum2 = index_getattr(firstright, keepnatts, itupdesc, &isNull2);
+
+		if (isNull1 != isNull2)
+			break;
+		if (!isNull1 &&
+			DatumGetInt32(FunctionCall2Coll(index_getprocinfo(rel, keepnatts,
+															  BTORDER_PROC),
+											rel->rd_indcollation[keepnatts - 1],
+											datum1, datum2)) != 0)
+			break;
+	}
+
+	return keepnatts;
+}
+
+/*
+ *	_bt_truncate() -- create a pivot tuple from a leaf tuple.
+ *
+ * Returns a high key for a leaf page, allocated in caller's memory context,
+ * holding the first keepnatts attributes of caller's itup (see
+ * _bt_keep_natts()).  Non-key (INCLUDE) attributes are always removed, and
+ * so is the posting list of a posting list tuple.
  *
  * Truncated tuple is guaranteed to be no larger than the original, which is
  * important for staying under the 1/3 of a page restriction on tuple size.
  *
  * Note that returned tuple's t_tid offset will hold the number of attributes
- * present, so the original item pointer offset is not represented.  Caller
- * should only change truncated tuple's downlink.
+ * present when any were truncated, so the original item pointer offset is
+ * not represented.  Caller should only change truncated tuple's downlink.
  */
 IndexTuple
-_bt_nonkey_truncate(Relation rel, IndexTuple itup)
+_bt_truncate(Relation rel, IndexTuple itup, int keepnatts)
 {
-	int			nkeyattrs = IndexRelationGetNumberOfKeyAttributes(rel);
+	int			natts = IndexRelationGetNumberOfAttributes(rel);
 	IndexTuple	truncated;
 
 	/*
-	 * We should only ever truncate leaf index tuples, which must have both
-	 * key and non-key attributes.  It's never okay to truncate a second time.
+	 * We should only ever truncate leaf index tuples, which have all of the
+	 * index's attributes.  It's never okay to truncate a second time.
 	 */
-	Assert(BTreeTupleGetNAtts(itup, rel) ==
-		   IndexRelationGetNumberOfAttributes(rel));
+	Assert(BTreeTupleGetNAtts(itup, rel) == natts);
+	Assert(keepnatts > 0 &&
+		   keepnatts <= IndexRelationGetNumberOfKeyAttributes(rel));
 
-	truncated = index_truncate_tuple(RelationGetDescr(rel), itup, nkeyattrs);
-	BTreeTupleSetNAtts(truncated, nkeyattrs);
+	if (keepnatts == natts)
+	{
+		/* Nothing to truncate but a posting list; keep its first heap TID */
+		Assert(BTreeTupleIsPosting(itup));
+		return _bt_form_posting(itup, BTreeTupleGetPosting(itup), 1);
+	}
+
+	truncated = index_truncate_tuple(RelationGetDescr(rel), itup, keepnatts);
+	if (BTreeTupleIsPosting(itup))
+		truncated->t_tid = *BTreeTupleGetPosting(itup);
+	BTreeTupleSetNAtts(truncated, keepnatts);
 
 	return truncated;
 }
@@ -2175,12 +2576,24 @@ _bt_check_natts(Relation rel, Page page, OffsetNumber offnum)
 			 */
 			Assert(!P_RIGHTMOST(opaque));
 
-			/* Page high key tuple contains only key attributes */
-			return BTreeTupleGetNAtts(itup, rel) == nkeyatts;
+			/* Page high key tuple is never a posting list tuple */
+			if (BTreeTupleIsPosting(itup))
+				return false;
+
+			/*
+			 * Page high key tuple contains only key attributes, and maybe
+			 * only some leading ones (see _bt_keep_natts())
+			 */
+			return BTreeTupleGetNAtts(itup, rel) > 0 &&
+				BTreeTupleGetNAtts(itup, rel) <= nkeyatts;
 		}
 	}
 	else						/* !P_ISLEAF(opaque) */
 	{
+		/* Pivot tuples are never posting list tuples */
+		if (BTreeTupleIsPosting(itup))
+			return false;
+
 		if (offnum == P_FIRSTDATAKEY(opaque))
 		{
 			/*
@@ -2207,9 +2620,11 @@ _bt_check_natts(Relation rel, Page page, OffsetNumber offnum)
 		{
 			/*
 			 * Tuple contains only key attributes despite on is it page high
-			 * key or not
+			 * key or not, and maybe only some leading ones, as it originates
+			 * from a leaf page high key
 			 */
-			return BTreeTupleGetNAtts(itup, rel) == nkeyatts;
+			return BTreeTupleGetNAtts(itup, rel) > 0 &&
+				BTreeTupleGetNAtts(itup, rel) <= nkeyatts;
 		}
 
 	}
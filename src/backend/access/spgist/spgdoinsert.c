@@ -21,6 +21,7 @@
 #include "access/xloginsert.h"
 #include "miscadmin.h"
 #include "storage/bufmgr.h"
+#include "storage/predicate.h"
 #include "utils/rel.h"
 
 
@@ -456,6 +457,9 @@ moveLeafs(Relation index, SpGistState *state,
 	nblkno = BufferGetBlockNumber(nbuf);
 	Assert(nblkno != current->blkno);
 
+	/* scans that saw the chain must see it on its new page too */
+	PredicateLockPageSplit(index, current->blkno, nblkno);
+
 	leafdata = leafptr = palloc(size);
 
 	START_CRIT_SECTION();
@@ -1109,6 +1113,17 @@ doPickSplit(Relation index, SpGistState *state,
 
 	leafdata = leafptr = (char *) palloc(totalLeafSizes);
 
+	/*
+	 * Scans that saw the old leaf tuples must also see the new inner tuple
+	 * and whichever leaf tuples go elsewhere.
+	 */
+	if (newInnerBuffer != InvalidBuffer && newInnerBuffer != parent->buffer)
+		PredicateLockPageSplit(index, current->blkno,
+							   BufferGetBlockNumber(newInnerBuffer));
+	if (newLeafBuffer != InvalidBuffer)
+		PredicateLockPageSplit(index, current->blkno,
+							   BufferGetBlockNumber(newLeafBuffer));
+
 	/* Here we begin making the changes to the target pages */
 	START_CRIT_SECTION();
 
@@ -1592,6 +1607,9 @@ spgAddNodeAction(Relation index, SpGistState *state,
 		if (current->blkno == saveCurrent.blkno)
 			elog(ERROR, "SPGiST new buffer shouldn't be same as old buffer");
 
+		/* scans that saw the inner tuple must see it on its new page too */
+		PredicateLockPageSplit(index, saveCurrent.blkno, current->blkno);
+
 		/*
 		 * New current and parent buffer will both be modified; but note that
 		 * parent buffer could be same as either new or old current.
@@ -1786,6 +1804,10 @@ spgSplitNodeAction(Relation index, SpGistState *state,
 									GBUF_INNER_PARITY(current->blkno + 1),
 									postfixTuple->size + sizeof(ItemIdData),
 									&xlrec.newPage);
+
+		/* scans that saw the old tuple must see the postfix tuple too */
+		PredicateLockPageSplit(index, current->blkno,
+							   BufferGetBlockNumber(newBuffer));
 	}
 
 	START_CRIT_SECTION();
@@ -2049,6 +2071,21 @@ spgdoinsert(Relation index, SpGistState *state,
 						sizeToSplit;
 
 			leafTuple = spgFormLeafTuple(state, heapPtr, leafDatum, isnull);
+
+			/*
+			 * Check for conflicts with serializable transactions that have
+			 * read this leaf page, and, unless we're just adding to an
+			 * existing chain here, with those that have read the parent
+			 * page, whose downlink or tuples we might be about to change.
+			 */
+			CheckForSerializableConflictIn(index, NULL, current.buffer);
+			if (parent.buffer != InvalidBuffer &&
+				parent.buffer != current.buffer &&
+				(current.offnum == InvalidOffsetNumber ||
+				 leafTuple->size + sizeof(ItemIdData) >
+				 SpGistPageGetFreeSpace(current.page, 1)))
+				CheckForSerializableConflictIn(index, NULL, parent.buffer);
+
 			if (leafTuple->size + sizeof(ItemIdData) <=
 				SpGistPageGetFreeSpace(current.page, 1))
 			{
@@ -2184,6 +2221,12 @@ spgdoinsert(Relation index, SpGistState *state,
 					/* AddNode is not sensible if nodes don't have labels */
 					if (in.nodeLabels == NULL)
 						elog(ERROR, "cannot add a node to an inner tuple without node labels");
+					/* The inner tuple may move, changing the parent too */
+					CheckForSerializableConflictIn(index, NULL, current.buffer);
+					if (parent.buffer != InvalidBuffer &&
+						parent.buffer != current.buffer)
+						CheckForSerializableConflictIn(index, NULL,
+													   parent.buffer);
 					/* Add node to inner tuple, per request */
 					spgAddNodeAction(index, state, innerTuple,
 									 &current, &parent,
@@ -2198,6 +2241,7 @@ spgdoinsert(Relation index, SpGistState *state,
 					break;
 				case spgSplitTuple:
 					/* Split inner tuple, per request */
+					CheckForSerializableConflictIn(index, NULL, current.buffer);
 					spgSplitNodeAction(index, state, innerTuple,
 									   &current, &out);
 
@@ -0,0 +1,141 @@
+/*-------------------------------------------------------------------------
+ *
+ * tableamapi.c
+ *	  Support routines for API for Postgres table access methods.
+ *
+ * Copyright (c) 2019, PostgreSQL Global Development Group
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/access/table/tableamapi.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/tableam.h"
+#include "access/xact.h"
+#include "commands/defrem.h"
+#include "utils/fmgroids.h"
+
+
+/* GUC variable */
+char	   *default_table_access_method = DEFAULT_TABLE_ACCESS_METHOD;
+
+
+/*
+ * GetTableAmRoutine - call the specified access method handler routine to get
+ * its TableAmRoutine struct.
+ *
+ * Unlike index AMs, table AMs return a pointer to a struct that lives for the
+ * life of the server, so the result is neither copied nor palloc'd.  If the
+ * handler is built-in, no catalog access is needed, which makes this safe to
+ * use while bootstrapping.
+ */
+const TableAmRoutine *
+GetTableAmRoutine(Oid amhandler)
+{
+	Datum		datum;
+	const TableAmRoutine *routine;
+
+	datum = OidFunctionCall0(amhandler);
+	routine = (const TableAmRoutine *) DatumGetPointer(datum);
+
+	if (routine == NULL || !IsA(routine, TableAmRoutine))
+		elog(ERROR, "table access method handler function %u did not return a TableAmRoutine struct",
+			 amhandler);
+
+	/*
+	 * Assert that all required callbacks are present.  That makes it a bit
+	 * easier to keep AMs up to date, e.g. when forward porting them to a new
+	 * major version.
+	 */
+	Assert(routine->slot_callbacks != NULL);
+
+	Assert(routine->scan_begin != NULL);
+	Assert(routine->scan_end != NULL);
+	Assert(routine->scan_rescan != NULL);
+	Assert(routine->scan_getnextslot != NULL);
+	Assert(routine->scan_set_tidrange != NULL);
+	Assert(routine->scan_getnextslot_tidrange != NULL);
+
+	Assert(routine->parallelscan_estimate != NULL);
+	Assert(routine->parallelscan_initialize != NULL);
+	Assert(routine->parallelscan_reinitialize != NULL);
+
+	Assert(routine->tuple_fetch_row_version != NULL);
+
+	Assert(routine->tuple_insert != NULL);
+	Assert(routine->tuple_insert_speculative != NULL);
+	Assert(routine->tuple_complete_speculative != NULL);
+	Assert(routine->tuple_delete != NULL);
+	Assert(routine->tuple_update != NULL);
+
+	Assert(routine->relation_vacuum != NULL);
+	Assert(routine->relation_acquire_sample_rows != NULL);
+	Assert(routine->relation_estimate_size != NULL);
+
+	return routine;
+}
+
+/*
+ * GetHeapamTableAmRoutine - the heap's TableAmRoutine
+ *
+ * Used where the relcache can't look up pg_class.relam, as for sequences.
+ */
+const TableAmRoutine *
+GetHeapamTableAmRoutine(void)
+{
+	return GetTableAmRoutine(F_HEAP_TABLEAM_HANDLER);
+}
+
+/* check_hook: validate new default_table_access_method */
+bool
+check_default_table_access_method(char **newval, void **extra,
+								  GucSource source)
+{
+	if (**newval == '\0')
+	{
+		GUC_check_errdetail("%s cannot be empty.",
+							"default_table_access_method");
+		return false;
+	}
+
+	if (strlen(*newval) >= NAMEDATALEN)
+	{
+		GUC_check_errdetail("%s is too long (maximum %d characters).",
+							"default_table_access_method", NAMEDATALEN - 1);
+		return false;
+	}
+
+	/*
+	 * If we aren't inside a transaction, we cannot do database access so
+	 * cannot verify the name.  Must accept the value on faith.
+	 */
+	if (IsTransactionState())
+	{
+		if (!OidIsValid(get_table_am_oid(*newval, true)))
+		{
+			/*
+			 * When source == PGC_S_TEST, don't throw a hard error for a
+			 * nonexistent table access method, only a NOTICE.  See comments
+			 * in guc.h.
+			 */
+			if (source == PGC_S_TEST)
+			{
+				ereport(NOTICE,
+						(errcode(ERRCODE_UNDEFINED_OBJECT),
+						 errmsg("table access method \"%s\" does not exist",
+								*newval)));
+			}
+			else
+			{
+				GUC_check_errdetail("Table access method \"%s\" does not exist.",
+									*newval);
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
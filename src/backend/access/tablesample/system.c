@@ -180,7 +180,7 @@ static BlockNumber
 system_nextsampleblock(SampleScanState *node)
 {
 	SystemSamplerData *sampler = (SystemSamplerData *) node->tsm_state;
-	HeapScanDesc scan = node->ss.ss_currentScanDesc;
+	HeapScanDesc scan = (HeapScanDesc) node->ss.ss_currentScanDesc;
 	BlockNumber nextblock = sampler->nextblock;
 	uint32		hashinput[2];
 
@@ -87,6 +87,9 @@ static SlruCtlData ClogCtlData;
 
 #define ClogCtl (&ClogCtlData)
 
+/* GUC parameter */
+int			transaction_buffers = 0;
+
 
 static int	ZeroCLOGPage(int pageno, bool writeXlog);
 static bool CLOGPagePrecedes(int page1, int page2);
@@ -678,11 +681,18 @@ TransactionIdGetStatus(TransactionId xid, XLogRecPtr *lsn)
  * configurations.  The following formula seems to represent a reasonable
  * compromise: people with very low values for shared_buffers will get fewer
  * CLOG buffers as well, and everyone else will get 128.
+ *
+ * Buffer lookups only search one bank of the pool, so a larger pool no
+ * longer makes them slower.  (XXX that should move the sweet spot beyond 128
+ * buffers, but we haven't retested.)  transaction_buffers can be set to use
+ * a fixed number instead.
  */
 Size
 CLOGShmemBuffers(void)
 {
-	return Min(128, Max(4, NBuffers / 512));
+	if (transaction_buffers == 0)
+		return SimpleLruAutotuneBuffers(512, 128);
+	return transaction_buffers;
 }
 
 /*
@@ -699,7 +709,7 @@ CLOGShmemInit(void)
 {
 	ClogCtl->PagePrecedes = CLOGPagePrecedes;
 	SimpleLruInit(ClogCtl, "clog", CLOGShmemBuffers(), CLOG_LSNS_PER_PAGE,
-				  CLogControlLock, "pg_xact", LWTRANCHE_CLOG_BUFFERS);
+				  CLogControlLock, "pg_xact", LWTRANCHE_CLOG_BUFFERS, 0);
 }
 
 /*
@@ -749,12 +759,12 @@ ZeroCLOGPage(int pageno, bool writeXlog)
 
 /*
  * This must be called ONCE during postmaster or standalone-backend startup,
- * after StartupXLOG has initialized ShmemVariableCache->nextXid.
+ * after StartupXLOG has initialized ShmemVariableCache->nextFullXid.
  */
 void
 StartupCLOG(void)
 {
-	TransactionId xid = ShmemVariableCache->nextXid;
+	TransactionId xid = XidFromFullTransactionId(ShmemVariableCache->nextFullXid);
 	int			pageno = TransactionIdToPage(xid);
 
 	LWLockAcquire(CLogControlLock, LW_EXCLUSIVE);
@@ -773,7 +783,7 @@ StartupCLOG(void)
 void
 TrimCLOG(void)
 {
-	TransactionId xid = ShmemVariableCache->nextXid;
+	TransactionId xid = XidFromFullTransactionId(ShmemVariableCache->nextFullXid);
 	int			pageno = TransactionIdToPage(xid);
 
 	LWLockAcquire(CLogControlLock, LW_EXCLUSIVE);
@@ -14,6 +14,8 @@
 
 #include "postgres.h"
 
+#include "access/gin.h"
+#include "access/hash.h"
 #include "access/nbtree.h"
 #include "access/parallel.h"
 #include "access/session.h"
@@ -23,6 +25,9 @@
 #include "catalog/index.h"
 #include "catalog/namespace.h"
 #include "commands/async.h"
+#include "commands/cluster.h"
+#include "commands/copy.h"
+#include "commands/vacuum.h"
 #include "executor/execParallel.h"
 #include "libpq/libpq.h"
 #include "libpq/pqformat.h"
@@ -138,6 +143,24 @@ static const struct
 	},
 	{
 		"_bt_parallel_build_main", _bt_parallel_build_main
+	},
+	{
+		"_gin_parallel_build_main", _gin_parallel_build_main
+	},
+	{
+		"_h_parallel_build_main", _h_parallel_build_main
+	},
+	{
+		"lazy_parallel_vacuum_main", lazy_parallel_vacuum_main
+	},
+	{
+		"analyze_parallel_sample_main", analyze_parallel_sample_main
+	},
+	{
+		"cluster_parallel_scan_main", cluster_parallel_scan_main
+	},
+	{
+		"ParallelCopyMain", ParallelCopyMain
 	}
 };
 
@@ -307,7 +330,8 @@ InitializeParallelDSM(ParallelContext *pcxt)
 	else
 	{
 		pcxt->nworkers = 0;
-		pcxt->private_memory = MemoryContextAlloc(TopMemoryContext, segsize);
+		pcxt->private_memory = MemoryContextAllocHuge(TopMemoryContext,
+													  segsize);
 		pcxt->toc = shm_toc_create(PARALLEL_MAGIC, pcxt->private_memory,
 								   segsize);
 	}
@@ -7,17 +7,25 @@
  * buffers.  Under ordinary circumstances we expect that write
  * traffic will occur mostly to the latest page (and to the just-prior
  * page, soon after a page transition).  Read traffic will probably touch
- * a larger span of pages, but in any case a fairly small number of page
- * buffers should be sufficient.  So, we just search the buffers using plain
- * linear search; there's no need for a hashtable or anything fancy.
- * The management algorithm is straight LRU except that we will never swap
- * out the latest page (since we know it's going to be hit again eventually).
+ * a larger span of pages, and workloads with many subtransactions or
+ * multixacts can need a large number of page buffers to avoid thrashing.
+ * To keep lookups cheap however large the pool is, the buffers are divided
+ * into banks of SLRU_BANK_SIZE slots, and a page can only be held by a slot
+ * of the bank its page number maps to; we search just that bank using plain
+ * linear search.  The management algorithm is straight LRU within each bank,
+ * except that we will never swap out the latest page (since we know it's
+ * going to be hit again eventually).
  *
  * We use a control LWLock to protect the shared data structures, plus
  * per-buffer LWLocks that synchronize I/O for each buffer.  The control lock
  * must be held to examine or modify any shared state.  A process that is
  * reading in or writing out a page buffer does not hold the control lock,
- * only the per-buffer lock for the buffer it is working on.
+ * only the per-buffer lock for the buffer it is working on.  An SLRU can
+ * instead be set up with one control lock per bank, so that processes
+ * working on pages of different banks do not contend with each other; in
+ * that case "the control lock" below means the lock of the bank in question,
+ * as returned by SimpleLruGetBankLock(), and operations that cover the whole
+ * SLRU visit the banks one at a time.
  *
  * "Holding the control lock" means exclusive lock in all cases except for
  * SimpleLruReadPage_ReadOnly(); see comments for SlruRecentlyUsed() for
@@ -87,13 +95,14 @@ typedef struct SlruFlushData *SlruFlush;
  *
  * The reason for the if-test is that there are often many consecutive
  * accesses to the same page (particularly the latest page).  By suppressing
- * useless increments of cur_lru_count, we reduce the probability that old
- * pages' counts will "wrap around" and make them appear recently used.
+ * useless increments of the bank's LRU counter, we reduce the probability
+ * that old pages' counts will "wrap around" and make them appear recently
+ * used.
  *
  * We allow this code to be executed concurrently by multiple processes within
  * SimpleLruReadPage_ReadOnly().  As long as int reads and writes are atomic,
  * this should not cause any completely-bogus values to enter the computation.
- * However, it is possible for either cur_lru_count or individual
+ * However, it is possible for either bank_cur_lru_count or individual
  * page_lru_count entries to be "reset" to lower values than they should have,
  * in case a process is delayed while it executes this macro.  With care in
  * SlruSelectLRUPage(), this does little harm, and in any case the absolute
@@ -102,13 +111,23 @@ typedef struct SlruFlushData *SlruFlush;
  */
 #define SlruRecentlyUsed(shared, slotno)	\
 	do { \
-		int		new_lru_count = (shared)->cur_lru_count; \
+		int		bankno = (slotno) / (shared)->bank_size; \
+		int		new_lru_count = (shared)->bank_cur_lru_count[bankno]; \
 		if (new_lru_count != (shared)->page_lru_count[slotno]) { \
-			(shared)->cur_lru_count = ++new_lru_count; \
+			(shared)->bank_cur_lru_count[bankno] = ++new_lru_count; \
 			(shared)->page_lru_count[slotno] = new_lru_count; \
 		} \
 	} while (0)
 
+/* First slot of the bank that can hold the given page */
+#define SlruPageBankStart(shared, pageno) \
+	(((uint32) (pageno) % (shared)->num_banks) * (shared)->bank_size)
+
+/* The control lock protecting the given slot; see notes at top of file */
+#define SlruSlotLock(shared, slotno) \
+	((shared)->bank_locks == NULL ? (shared)->ControlLock : \
+	 &(shared)->bank_locks[(slotno) / (shared)->bank_size].lock)
+
 /* Saved info for SlruReportIOError */
 typedef enum
 {
@@ -124,6 +143,7 @@ static SlruErrorCause slru_errcause;
 static int	slru_errno;
 
 
+static int	SlruNumSlots(int nslots);
 static void SimpleLruZeroLSNs(SlruCtl ctl, int slotno);
 static void SimpleLruWaitIO(SlruCtl ctl, int slotno);
 static void SlruInternalWritePage(SlruCtl ctl, int slotno, SlruFlush fdata);
@@ -137,6 +157,29 @@ static bool SlruScanDirCbDeleteCutoff(SlruCtl ctl, char *filename,
 						  int segpage, void *data);
 static void SlruInternalDeleteSegment(SlruCtl ctl, char *filename);
 
+/*
+ * Compute a default number of buffers for an SLRU whose size is configured
+ * as 0: one buffer per 'divisor' shared buffers, but at least one bank and at
+ * most 'max' buffers.
+ */
+int
+SimpleLruAutotuneBuffers(int divisor, int max)
+{
+	return Min(max, Max(SLRU_BANK_SIZE, NBuffers / divisor));
+}
+
+/*
+ * Return the number of slots we actually use for a requested pool size: a
+ * pool larger than one bank is rounded down to a whole number of banks.
+ */
+static int
+SlruNumSlots(int nslots)
+{
+	if (nslots > SLRU_BANK_SIZE)
+		nslots -= nslots % SLRU_BANK_SIZE;
+	return nslots;
+}
+
 /*
  * Initialization of shared memory
  */
@@ -145,6 +188,10 @@ Size
 SimpleLruShmemSize(int nslots, int nlsns)
 {
 	Size		sz;
+	int			nbanks;
+
+	nslots = SlruNumSlots(nslots);
+	nbanks = Max(nslots / SLRU_BANK_SIZE, 1);
 
 	/* we assume nslots isn't so large as to risk overflow */
 	sz = MAXALIGN(sizeof(SlruSharedData));
@@ -153,7 +200,9 @@ SimpleLruShmemSize(int nslots, int nlsns)
 	sz += MAXALIGN(nslots * sizeof(bool));	/* page_dirty[] */
 	sz += MAXALIGN(nslots * sizeof(int));	/* page_number[] */
 	sz += MAXALIGN(nslots * sizeof(int));	/* page_lru_count[] */
+	sz += MAXALIGN(nbanks * sizeof(int));	/* bank_cur_lru_count[] */
 	sz += MAXALIGN(nslots * sizeof(LWLockPadded));	/* buffer_locks[] */
+	sz += MAXALIGN(nbanks * sizeof(LWLockPadded));	/* bank_locks[] */
 
 	if (nlsns > 0)
 		sz += MAXALIGN(nslots * nlsns * sizeof(XLogRecPtr));	/* group_lsn[] */
@@ -161,9 +210,19 @@ SimpleLruShmemSize(int nslots, int nlsns)
 	return BUFFERALIGN(sz) + BLCKSZ * nslots;
 }
 
+/*
+ * Set up the shared memory of an SLRU, or attach to it.
+ *
+ * nslots is the requested number of page buffers; see SlruNumSlots().  If
+ * ctllock is NULL, each bank of buffers gets its own control lock, in tranche
+ * bank_tranche_id; otherwise ctllock protects the whole SLRU and
+ * bank_tranche_id is ignored.  tranche_id is the tranche of the per-buffer
+ * I/O locks.
+ */
 void
 SimpleLruInit(SlruCtl ctl, const char *name, int nslots, int nlsns,
-			  LWLock *ctllock, const char *subdir, int tranche_id)
+			  LWLock *ctllock, const char *subdir, int tranche_id,
+			  int bank_tranche_id)
 {
 	SlruShared	shared;
 	bool		found;
@@ -178,18 +237,24 @@ SimpleLruInit(SlruCtl ctl, const char *name, int nslots, int nlsns,
 		char	   *ptr;
 		Size		offset;
 		int			slotno;
+		int			nbanks;
+		int			bankno;
+		LWLockPadded *bank_locks;
 
 		Assert(!found);
 
+		nslots = SlruNumSlots(nslots);
+		nbanks = Max(nslots / SLRU_BANK_SIZE, 1);
+
 		memset(shared, 0, sizeof(SlruSharedData));
 
 		shared->ControlLock = ctllock;
 
 		shared->num_slots = nslots;
+		shared->num_banks = nbanks;
+		shared->bank_size = nslots / nbanks;
 		shared->lsn_groups_per_page = nlsns;
 
-		shared->cur_lru_count = 0;
-
 		/* shared->latest_page_number will be set later */
 
 		ptr = (char *) shared;
@@ -204,10 +269,14 @@ SimpleLruInit(SlruCtl ctl, const char *name, int nslots, int nlsns,
 		offset += MAXALIGN(nslots * sizeof(int));
 		shared->page_lru_count = (int *) (ptr + offset);
 		offset += MAXALIGN(nslots * sizeof(int));
+		shared->bank_cur_lru_count = (int *) (ptr + offset);
+		offset += MAXALIGN(nbanks * sizeof(int));
 
 		/* Initialize LWLocks */
 		shared->buffer_locks = (LWLockPadded *) (ptr + offset);
 		offset += MAXALIGN(nslots * sizeof(LWLockPadded));
+		bank_locks = (LWLockPadded *) (ptr + offset);
+		offset += MAXALIGN(nbanks * sizeof(LWLockPadded));
 
 		if (nlsns > 0)
 		{
@@ -219,6 +288,20 @@ SimpleLruInit(SlruCtl ctl, const char *name, int nslots, int nlsns,
 		strlcpy(shared->lwlock_tranche_name, name, SLRU_MAX_NAME_LENGTH);
 		shared->lwlock_tranche_id = tranche_id;
 
+		if (ctllock == NULL)
+		{
+			Assert(strlen(name) + sizeof("_bank") < SLRU_MAX_NAME_LENGTH);
+			snprintf(shared->bank_tranche_name, SLRU_MAX_NAME_LENGTH,
+					 "%s_bank", name);
+			shared->bank_tranche_id = bank_tranche_id;
+			shared->bank_locks = bank_locks;
+			for (bankno = 0; bankno < nbanks; bankno++)
+				LWLockInitialize(&bank_locks[bankno].lock, bank_tranche_id);
+		}
+
+		for (bankno = 0; bankno < nbanks; bankno++)
+			shared->bank_cur_lru_count[bankno] = 0;
+
 		ptr += BUFFERALIGN(offset);
 		for (slotno = 0; slotno < nslots; slotno++)
 		{
@@ -238,9 +321,12 @@ SimpleLruInit(SlruCtl ctl, const char *name, int nslots, int nlsns,
 	else
 		Assert(found);
 
-	/* Register SLRU tranche in the main tranches array */
+	/* Register SLRU tranches in the main tranches array */
 	LWLockRegisterTranche(shared->lwlock_tranche_id,
 						  shared->lwlock_tranche_name);
+	if (shared->bank_locks != NULL)
+		LWLockRegisterTranche(shared->bank_tranche_id,
+							  shared->bank_tranche_name);
 
 	/*
 	 * Initialize the unshared control struct, including directory path. We
@@ -257,7 +343,8 @@ SimpleLruInit(SlruCtl ctl, const char *name, int nslots, int nlsns,
  * The page is not actually written, just set up in shared memory.
  * The slot number of the new page is returned.
  *
- * Control lock must be held at entry, and will be held at exit.
+ * Control lock for the page's bank must be held at entry, and will be held
+ * at exit.
  */
 int
 SimpleLruZeroPage(SlruCtl ctl, int pageno)
@@ -321,12 +408,13 @@ static void
 SimpleLruWaitIO(SlruCtl ctl, int slotno)
 {
 	SlruShared	shared = ctl->shared;
+	LWLock	   *ctllock = SlruSlotLock(shared, slotno);
 
 	/* See notes at top of file */
-	LWLockRelease(shared->ControlLock);
+	LWLockRelease(ctllock);
 	LWLockAcquire(&shared->buffer_locks[slotno].lock, LW_SHARED);
 	LWLockRelease(&shared->buffer_locks[slotno].lock);
-	LWLockAcquire(shared->ControlLock, LW_EXCLUSIVE);
+	LWLockAcquire(ctllock, LW_EXCLUSIVE);
 
 	/*
 	 * If the slot is still in an io-in-progress state, then either someone
@@ -369,13 +457,15 @@ SimpleLruWaitIO(SlruCtl ctl, int slotno)
  * Return value is the shared-buffer slot number now holding the page.
  * The buffer's LRU access info is updated.
  *
- * Control lock must be held at entry, and will be held at exit.
+ * Control lock for the page's bank must be held at entry, and will be held
+ * at exit.
  */
 int
 SimpleLruReadPage(SlruCtl ctl, int pageno, bool write_ok,
 				  TransactionId xid)
 {
 	SlruShared	shared = ctl->shared;
+	LWLock	   *ctllock = SimpleLruGetBankLock(ctl, pageno);
 
 	/* Outer loop handles restart if we must wait for someone else's I/O */
 	for (;;)
@@ -421,7 +511,7 @@ SimpleLruReadPage(SlruCtl ctl, int pageno, bool write_ok,
 		LWLockAcquire(&shared->buffer_locks[slotno].lock, LW_EXCLUSIVE);
 
 		/* Release control lock while doing I/O */
-		LWLockRelease(shared->ControlLock);
+		LWLockRelease(ctllock);
 
 		/* Do the read */
 		ok = SlruPhysicalReadPage(ctl, pageno, slotno);
@@ -430,7 +520,7 @@ SimpleLruReadPage(SlruCtl ctl, int pageno, bool write_ok,
 		SimpleLruZeroLSNs(ctl, slotno);
 
 		/* Re-acquire control lock and update page state */
-		LWLockAcquire(shared->ControlLock, LW_EXCLUSIVE);
+		LWLockAcquire(ctllock, LW_EXCLUSIVE);
 
 		Assert(shared->page_number[slotno] == pageno &&
 			   shared->page_status[slotno] == SLRU_PAGE_READ_IN_PROGRESS &&
@@ -460,20 +550,24 @@ SimpleLruReadPage(SlruCtl ctl, int pageno, bool write_ok,
  * Return value is the shared-buffer slot number now holding the page.
  * The buffer's LRU access info is updated.
  *
- * Control lock must NOT be held at entry, but will be held at exit.
- * It is unspecified whether the lock will be shared or exclusive.
+ * Control lock for the page's bank must NOT be held at entry, but will be
+ * held at exit.  It is unspecified whether the lock will be shared or
+ * exclusive.
  */
 int
 SimpleLruReadPage_ReadOnly(SlruCtl ctl, int pageno, TransactionId xid)
 {
 	SlruShared	shared = ctl->shared;
+	LWLock	   *ctllock = SimpleLruGetBankLock(ctl, pageno);
+	int			bankstart = SlruPageBankStart(shared, pageno);
+	int			bankend = bankstart + shared->bank_size;
 	int			slotno;
 
 	/* Try to find the page while holding only shared lock */
-	LWLockAcquire(shared->ControlLock, LW_SHARED);
+	LWLockAcquire(ctllock, LW_SHARED);
 
 	/* See if page is already in a buffer */
-	for (slotno = 0; slotno < shared->num_slots; slotno++)
+	for (slotno = bankstart; slotno < bankend; slotno++)
 	{
 		if (shared->page_number[slotno] == pageno &&
 			shared->page_status[slotno] != SLRU_PAGE_EMPTY &&
@@ -486,8 +580,8 @@ SimpleLruReadPage_ReadOnly(SlruCtl ctl, int pageno, TransactionId xid)
 	}
 
 	/* No luck, so switch to normal exclusive lock and do regular read */
-	LWLockRelease(shared->ControlLock);
-	LWLockAcquire(shared->ControlLock, LW_EXCLUSIVE);
+	LWLockRelease(ctllock);
+	LWLockAcquire(ctllock, LW_EXCLUSIVE);
 
 	return SimpleLruReadPage(ctl, pageno, true, xid);
 }
@@ -501,12 +595,14 @@ SimpleLruReadPage_ReadOnly(SlruCtl ctl, int pageno, TransactionId xid)
  * the write).  However, we *do* attempt a fresh write even if the page
  * is already being written; this is for checkpoints.
  *
- * Control lock must be held at entry, and will be held at exit.
+ * Control lock for the slot's bank must be held at entry, and will be held
+ * at exit.
  */
 static void
 SlruInternalWritePage(SlruCtl ctl, int slotno, SlruFlush fdata)
 {
 	SlruShared	shared = ctl->shared;
+	LWLock	   *ctllock = SlruSlotLock(shared, slotno);
 	int			pageno = shared->page_number[slotno];
 	bool		ok;
 
@@ -537,7 +633,7 @@ SlruInternalWritePage(SlruCtl ctl, int slotno, SlruFlush fdata)
 	LWLockAcquire(&shared->buffer_locks[slotno].lock, LW_EXCLUSIVE);
 
 	/* Release control lock while doing I/O */
-	LWLockRelease(shared->ControlLock);
+	LWLockRelease(ctllock);
 
 	/* Do the write */
 	ok = SlruPhysicalWritePage(ctl, pageno, slotno, fdata);
@@ -552,7 +648,7 @@ SlruInternalWritePage(SlruCtl ctl, int slotno, SlruFlush fdata)
 	}
 
 	/* Re-acquire control lock and update page state */
-	LWLockAcquire(shared->ControlLock, LW_EXCLUSIVE);
+	LWLockAcquire(ctllock, LW_EXCLUSIVE);
 
 	Assert(shared->page_number[slotno] == pageno &&
 		   shared->page_status[slotno] == SLRU_PAGE_WRITE_IN_PROGRESS);
@@ -966,6 +1062,9 @@ static int
 SlruSelectLRUPage(SlruCtl ctl, int pageno)
 {
 	SlruShared	shared = ctl->shared;
+	int			bankno = (uint32) pageno % shared->num_banks;
+	int			bankstart = bankno * shared->bank_size;
+	int			bankend = bankstart + shared->bank_size;
 
 	/* Outer loop handles restart after I/O */
 	for (;;)
@@ -980,7 +1079,7 @@ SlruSelectLRUPage(SlruCtl ctl, int pageno)
 		int			best_invalid_page_number = 0;	/* keep compiler quiet */
 
 		/* See if page already has a buffer assigned */
-		for (slotno = 0; slotno < shared->num_slots; slotno++)
+		for (slotno = bankstart; slotno < bankend; slotno++)
 		{
 			if (shared->page_number[slotno] == pageno &&
 				shared->page_status[slotno] != SLRU_PAGE_EMPTY)
@@ -988,10 +1087,11 @@ SlruSelectLRUPage(SlruCtl ctl, int pageno)
 		}
 
 		/*
-		 * If we find any EMPTY slot, just select that one. Else choose a
-		 * victim page to replace.  We normally take the least recently used
-		 * valid page, but we will never take the slot containing
-		 * latest_page_number, even if it appears least recently used.  We
+		 * If we find any EMPTY slot in the page's bank, just select that one.
+		 * Else choose a victim page of the bank to replace.  We normally take
+		 * the least recently used valid page, but we will never take the slot
+		 * containing latest_page_number, even if it appears least recently
+		 * used.  We
 		 * will select a slot that is already I/O busy only if there is no
 		 * other choice: a read-busy slot will not be least recently used once
 		 * the read finishes, and waiting for an I/O on a write-busy slot is
@@ -1006,16 +1106,16 @@ SlruSelectLRUPage(SlruCtl ctl, int pageno)
 		 * acquire the same lru_count values.  In that case we break ties by
 		 * choosing the furthest-back page.
 		 *
-		 * Notice that this next line forcibly advances cur_lru_count to a
-		 * value that is certainly beyond any value that will be in the
-		 * page_lru_count array after the loop finishes.  This ensures that
-		 * the next execution of SlruRecentlyUsed will mark the page newly
-		 * used, even if it's for a page that has the current counter value.
-		 * That gets us back on the path to having good data when there are
-		 * multiple pages with the same lru_count.
+		 * Notice that this next line forcibly advances the bank's LRU counter
+		 * to a value that is certainly beyond any value that will be in the
+		 * bank's page_lru_count entries after the loop finishes.  This ensures
+		 * that the next execution of SlruRecentlyUsed will mark the page
+		 * newly used, even if it's for a page that has the current counter
+		 * value.  That gets us back on the path to having good data when
+		 * there are multiple pages with the same lru_count.
 		 */
-		cur_count = (shared->cur_lru_count)++;
-		for (slotno = 0; slotno < shared->num_slots; slotno++)
+		cur_count = (shared->bank_cur_lru_count[bankno])++;
+		for (slotno = bankstart; slotno < bankend; slotno++)
 		{
 			int			this_delta;
 			int			this_page_number;
@@ -1065,11 +1165,11 @@ SlruSelectLRUPage(SlruCtl ctl, int pageno)
 		}
 
 		/*
-		 * If all pages (except possibly the latest one) are I/O busy, we'll
-		 * have to wait for an I/O to complete and then retry.  In that
-		 * unhappy case, we choose to wait for the I/O on the least recently
-		 * used slot, on the assumption that it was likely initiated first of
-		 * all the I/Os in progress and may therefore finish first.
+		 * If all pages of the bank (except possibly the latest one) are I/O
+		 * busy, we'll have to wait for an I/O to complete and then retry.  In
+		 * that unhappy case, we choose to wait for the I/O on the least
+		 * recently used slot, on the assumption that it was likely initiated
+		 * first of all the I/Os in progress and may therefore finish first.
 		 */
 		if (best_valid_delta < 0)
 		{
@@ -1110,14 +1210,17 @@ SimpleLruFlush(SlruCtl ctl, bool allow_redirtied)
 	bool		ok;
 
 	/*
-	 * Find and write dirty pages
+	 * Find and write dirty pages, one bank at a time
 	 */
 	fdata.num_files = 0;
 
-	LWLockAcquire(shared->ControlLock, LW_EXCLUSIVE);
-
 	for (slotno = 0; slotno < shared->num_slots; slotno++)
 	{
+		LWLock	   *ctllock = SlruSlotLock(shared, slotno);
+
+		if (slotno % shared->bank_size == 0)
+			LWLockAcquire(ctllock, LW_EXCLUSIVE);
+
 		SlruInternalWritePage(ctl, slotno, &fdata);
 
 		/*
@@ -1129,9 +1232,10 @@ SimpleLruFlush(SlruCtl ctl, bool allow_redirtied)
 			   shared->page_status[slotno] == SLRU_PAGE_EMPTY ||
 			   (shared->page_status[slotno] == SLRU_PAGE_VALID &&
 				!shared->page_dirty[slotno]));
-	}
 
-	LWLockRelease(shared->ControlLock);
+		if ((slotno + 1) % shared->bank_size == 0)
+			LWLockRelease(ctllock);
+	}
 
 	/*
 	 * Now fsync and close any files that were open
@@ -1168,7 +1272,7 @@ void
 SimpleLruTruncate(SlruCtl ctl, int cutoffPage)
 {
 	SlruShared	shared = ctl->shared;
-	int			slotno;
+	int			bankstart;
 
 	/*
 	 * The cutoff point is the start of the segment containing cutoffPage.
@@ -1179,59 +1283,70 @@ SimpleLruTruncate(SlruCtl ctl, int cutoffPage)
 	 * Scan shared memory and remove any pages preceding the cutoff page, to
 	 * ensure we won't rewrite them later.  (Since this is normally called in
 	 * or just after a checkpoint, any dirty pages should have been flushed
-	 * already ... we're just being extra careful here.)
-	 */
-	LWLockAcquire(shared->ControlLock, LW_EXCLUSIVE);
-
-restart:;
-
-	/*
-	 * While we are holding the lock, make an important safety check: the
-	 * planned cutoff point must be <= the current endpoint page. Otherwise we
-	 * have already wrapped around, and proceeding with the truncation would
-	 * risk removing the current segment.
+	 * already ... we're just being extra careful here.)  We visit the banks
+	 * one at a time.
 	 */
-	if (ctl->PagePrecedes(shared->latest_page_number, cutoffPage))
+	for (bankstart = 0; bankstart < shared->num_slots;
+		 bankstart += shared->bank_size)
 	{
-		LWLockRelease(shared->ControlLock);
-		ereport(LOG,
-				(errmsg("could not truncate directory \"%s\": apparent wraparound",
-						ctl->Dir)));
-		return;
-	}
+		LWLock	   *ctllock = SlruSlotLock(shared, bankstart);
+		int			slotno;
 
-	for (slotno = 0; slotno < shared->num_slots; slotno++)
-	{
-		if (shared->page_status[slotno] == SLRU_PAGE_EMPTY)
-			continue;
-		if (!ctl->PagePrecedes(shared->page_number[slotno], cutoffPage))
-			continue;
+		LWLockAcquire(ctllock, LW_EXCLUSIVE);
 
+restart:
 		/*
-		 * If page is clean, just change state to EMPTY (expected case).
+		 * While we are holding the lock, make an important safety check: the
+		 * planned cutoff point must be <= the current endpoint page.
+		 * Otherwise we have already wrapped around, and proceeding with the
+		 * truncation would risk removing the current segment.  (With bank
+		 * locks, the lock we hold may not be the one protecting
+		 * latest_page_number, but a stale value can only be older and so
+		 * make this check stricter.)
 		 */
-		if (shared->page_status[slotno] == SLRU_PAGE_VALID &&
-			!shared->page_dirty[slotno])
+		if (ctl->PagePrecedes(shared->latest_page_number, cutoffPage))
 		{
-			shared->page_status[slotno] = SLRU_PAGE_EMPTY;
-			continue;
+			LWLockRelease(ctllock);
+			ereport(LOG,
+					(errmsg("could not truncate directory \"%s\": apparent wraparound",
+							ctl->Dir)));
+			return;
 		}
 
-		/*
-		 * Hmm, we have (or may have) I/O operations acting on the page, so
-		 * we've got to wait for them to finish and then start again. This is
-		 * the same logic as in SlruSelectLRUPage.  (XXX if page is dirty,
-		 * wouldn't it be OK to just discard it without writing it?  For now,
-		 * keep the logic the same as it was.)
-		 */
-		if (shared->page_status[slotno] == SLRU_PAGE_VALID)
-			SlruInternalWritePage(ctl, slotno, NULL);
-		else
-			SimpleLruWaitIO(ctl, slotno);
-		goto restart;
-	}
+		for (slotno = bankstart; slotno < bankstart + shared->bank_size;
+			 slotno++)
+		{
+			if (shared->page_status[slotno] == SLRU_PAGE_EMPTY)
+				continue;
+			if (!ctl->PagePrecedes(shared->page_number[slotno], cutoffPage))
+				continue;
+
+			/*
+			 * If page is clean, just change state to EMPTY (expected case).
+			 */
+			if (shared->page_status[slotno] == SLRU_PAGE_VALID &&
+				!shared->page_dirty[slotno])
+			{
+				shared->page_status[slotno] = SLRU_PAGE_EMPTY;
+				continue;
+			}
+
+			/*
+			 * Hmm, we have (or may have) I/O operations acting on the page,
+			 * so we've got to wait for them to finish and then start again.
+			 * This is the same logic as in SlruSelectLRUPage.  (XXX if page
+			 * is dirty, wouldn't it be OK to just discard it without writing
+			 * it?  For now, keep the logic the same as it was.)
+			 */
+			if (shared->page_status[slotno] == SLRU_PAGE_VALID)
+				SlruInternalWritePage(ctl, slotno, NULL);
+			else
+				SimpleLruWaitIO(ctl, slotno);
+			goto restart;
+		}
 
-	LWLockRelease(shared->ControlLock);
+		LWLockRelease(ctllock);
+	}
 
 	/* Now we can remove the old segment(s) */
 	(void) SlruScanDirectory(ctl, SlruScanDirCbDeleteCutoff, &cutoffPage);
@@ -1261,55 +1376,73 @@ void
 SlruDeleteSegment(SlruCtl ctl, int segno)
 {
 	SlruShared	shared = ctl->shared;
-	int			slotno;
+	int			bankstart;
 	char		path[MAXPGPATH];
-	bool		did_write;
 
-	/* Clean out any possibly existing references to the segment. */
-	LWLockAcquire(shared->ControlLock, LW_EXCLUSIVE);
-restart:
-	did_write = false;
-	for (slotno = 0; slotno < shared->num_slots; slotno++)
+	/*
+	 * Clean out any possibly existing references to the segment, one bank at
+	 * a time.  With a single control lock, keep holding it until the file is
+	 * gone.  With bank locks, callers have to ensure that nobody tries to
+	 * read the segment's pages in the meantime.
+	 */
+	for (bankstart = 0; bankstart < shared->num_slots;
+		 bankstart += shared->bank_size)
 	{
-		int			pagesegno = shared->page_number[slotno] / SLRU_PAGES_PER_SEGMENT;
+		LWLock	   *ctllock = SlruSlotLock(shared, bankstart);
+		int			slotno;
+		bool		did_write;
 
-		if (shared->page_status[slotno] == SLRU_PAGE_EMPTY)
-			continue;
+		if (bankstart == 0 || shared->bank_locks != NULL)
+			LWLockAcquire(ctllock, LW_EXCLUSIVE);
+restart:
+		did_write = false;
+		for (slotno = bankstart; slotno < bankstart + shared->bank_size;
+			 slotno++)
+		{
+			int			pagesegno = shared->page_number[slotno] / SLRU_PAGES_PER_SEGMENT;
 
-		/* not the segment we're looking for */
-		if (pagesegno != segno)
-			continue;
+			if (shared->page_status[slotno] == SLRU_PAGE_EMPTY)
+				continue;
 
-		/* If page is clean, just change state to EMPTY (expected case). */
-		if (shared->page_status[slotno] == SLRU_PAGE_VALID &&
-			!shared->page_dirty[slotno])
-		{
-			shared->page_status[slotno] = SLRU_PAGE_EMPTY;
-			continue;
+			/* not the segment we're looking for */
+			if (pagesegno != segno)
+				continue;
+
+			/* If page is clean, just change state to EMPTY (expected case). */
+			if (shared->page_status[slotno] == SLRU_PAGE_VALID &&
+				!shared->page_dirty[slotno])
+			{
+				shared->page_status[slotno] = SLRU_PAGE_EMPTY;
+				continue;
+			}
+
+			/* Same logic as SimpleLruTruncate() */
+			if (shared->page_status[slotno] == SLRU_PAGE_VALID)
+				SlruInternalWritePage(ctl, slotno, NULL);
+			else
+				SimpleLruWaitIO(ctl, slotno);
+
+			did_write = true;
 		}
 
-		/* Same logic as SimpleLruTruncate() */
-		if (shared->page_status[slotno] == SLRU_PAGE_VALID)
-			SlruInternalWritePage(ctl, slotno, NULL);
-		else
-			SimpleLruWaitIO(ctl, slotno);
+		/*
+		 * Be extra careful and re-check. The IO functions release the control
+		 * lock, so new pages could have been read in.
+		 */
+		if (did_write)
+			goto restart;
 
-		did_write = true;
+		if (shared->bank_locks != NULL)
+			LWLockRelease(ctllock);
 	}
 
-	/*
-	 * Be extra careful and re-check. The IO functions release the control
-	 * lock, so new pages could have been read in.
-	 */
-	if (did_write)
-		goto restart;
-
 	snprintf(path, MAXPGPATH, "%s/%04X", ctl->Dir, segno);
 	ereport(DEBUG2,
 			(errmsg("removing file \"%s\"", path)));
 	unlink(path);
 
-	LWLockRelease(shared->ControlLock);
+	if (shared->bank_locks == NULL)
+		LWLockRelease(shared->ControlLock);
 }
 
 /*
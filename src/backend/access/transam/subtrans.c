@@ -19,6 +19,21 @@
  * data across crashes.  During database startup, we simply force the
  * currently-active page of SUBTRANS to zeroes.
  *
+ * Once a backend has more subtransactions than fit in its PGPROC subxid
+ * cache, every snapshot taken while it runs is marked suboverflowed, and
+ * every visibility check against such a snapshot needs the topmost parent of
+ * the XID in question, which means walking pg_subtrans.  To keep that off the
+ * SLRU in the common case, XID assignment also records each new XID and its
+ * topmost parent in a small direct-mapped array in shared memory, the
+ * topmost cache.  A slot holds the most recently assigned XID that maps to
+ * it, together with that XID's topmost parent, packed into a single 64-bit
+ * atomic so that readers need no lock.  Since the parent of an XID never
+ * changes, a slot whose XID matches the one looked up can be trusted; any
+ * other slot contents just mean we have to consult pg_subtrans.  The cache
+ * starts out empty at postmaster start and is only filled on a primary, so
+ * XIDs assigned before the last restart or during recovery always take the
+ * slow path.
+ *
  * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
  * Portions Copyright (c) 1994, Regents of the University of California
  *
@@ -32,6 +47,8 @@
 #include "access/subtrans.h"
 #include "access/transam.h"
 #include "pg_trace.h"
+#include "port/atomics.h"
+#include "storage/shmem.h"
 #include "utils/snapmgr.h"
 
 
@@ -62,7 +79,22 @@ static SlruCtlData SubTransCtlData;
 
 #define SubTransCtl  (&SubTransCtlData)
 
+/*
+ * Slots of the topmost cache: the low half holds the XID, the high half its
+ * topmost parent (the XID itself for a top-level transaction).
+ */
+#define TopmostCacheSlot(xid) ((xid) % (TransactionId) subtransaction_topmost_cache)
+#define TopmostCacheEntry(xid, topxid) \
+	(((uint64) (topxid) << 32) | (uint64) (xid))
+
+static pg_atomic_uint64 *TopmostCache = NULL;
+
+/* GUC parameters */
+int			subtransaction_buffers = 0;
+int			subtransaction_topmost_cache = 65536;
 
+
+static int	SUBTRANSShmemBuffers(void);
 static int	ZeroSUBTRANSPage(int pageno);
 static bool SubTransPagePrecedes(int page1, int page2);
 
@@ -77,11 +109,12 @@ SubTransSetParent(TransactionId xid, TransactionId parent)
 	int			entryno = TransactionIdToEntry(xid);
 	int			slotno;
 	TransactionId *ptr;
+	LWLock	   *lock = SimpleLruGetBankLock(SubTransCtl, pageno);
 
 	Assert(TransactionIdIsValid(parent));
 	Assert(TransactionIdFollows(xid, parent));
 
-	LWLockAcquire(SubtransControlLock, LW_EXCLUSIVE);
+	LWLockAcquire(lock, LW_EXCLUSIVE);
 
 	slotno = SimpleLruReadPage(SubTransCtl, pageno, true, xid);
 	ptr = (TransactionId *) SubTransCtl->shared->page_buffer[slotno];
@@ -99,7 +132,7 @@ SubTransSetParent(TransactionId xid, TransactionId parent)
 		SubTransCtl->shared->page_dirty[slotno] = true;
 	}
 
-	LWLockRelease(SubtransControlLock);
+	LWLockRelease(lock);
 }
 
 /*
@@ -129,7 +162,7 @@ SubTransGetParent(TransactionId xid)
 
 	parent = *ptr;
 
-	LWLockRelease(SubtransControlLock);
+	LWLockRelease(SimpleLruGetBankLock(SubTransCtl, pageno));
 
 	return parent;
 }
@@ -155,6 +188,16 @@ SubTransGetTopmostTransaction(TransactionId xid)
 	/* Can't ask about stuff that might not be around anymore */
 	Assert(TransactionIdFollowsOrEquals(xid, TransactionXmin));
 
+	/* Try the topmost cache first */
+	if (subtransaction_topmost_cache > 0 && TransactionIdIsNormal(xid))
+	{
+		uint64		entry;
+
+		entry = pg_atomic_read_u64(&TopmostCache[TopmostCacheSlot(xid)]);
+		if ((TransactionId) entry == xid)
+			return (TransactionId) (entry >> 32);
+	}
+
 	while (TransactionIdIsValid(parentXid))
 	{
 		previousXid = parentXid;
@@ -177,6 +220,42 @@ SubTransGetTopmostTransaction(TransactionId xid)
 	return previousXid;
 }
 
+/*
+ * SubTransRecordTopmost
+ *
+ * Remember the topmost parent of a newly assigned XID in the topmost cache,
+ * displacing whatever XID occupied its slot.  topxid is the XID itself for a
+ * top-level transaction.
+ *
+ * This is called by GetNewTransactionId while holding XidGenLock, so the
+ * entry is in place before anybody could see the XID as assigned and have a
+ * reason to ask about it.
+ */
+void
+SubTransRecordTopmost(TransactionId xid, TransactionId topxid)
+{
+	Assert(TransactionIdIsNormal(xid));
+	Assert(TransactionIdIsNormal(topxid));
+
+	if (subtransaction_topmost_cache > 0)
+		pg_atomic_write_u64(&TopmostCache[TopmostCacheSlot(xid)],
+							TopmostCacheEntry(xid, topxid));
+}
+
+
+/*
+ * Number of shared SUBTRANS buffers.
+ *
+ * Unless set explicitly with subtransaction_buffers, this scales with
+ * shared_buffers the same way as the number of CLOG buffers does.
+ */
+static int
+SUBTRANSShmemBuffers(void)
+{
+	if (subtransaction_buffers == 0)
+		return SimpleLruAutotuneBuffers(512, 1024);
+	return subtransaction_buffers;
+}
 
 /*
  * Initialization of shared memory for SUBTRANS
@@ -184,18 +263,44 @@ SubTransGetTopmostTransaction(TransactionId xid)
 Size
 SUBTRANSShmemSize(void)
 {
-	return SimpleLruShmemSize(NUM_SUBTRANS_BUFFERS, 0);
+	return add_size(SimpleLruShmemSize(SUBTRANSShmemBuffers(), 0),
+					mul_size(subtransaction_topmost_cache,
+							 sizeof(pg_atomic_uint64)));
 }
 
 void
 SUBTRANSShmemInit(void)
 {
+	bool		found;
+
+	/*
+	 * Subtransaction lookups come from every backend checking visibility of
+	 * subcommitted XIDs, so SUBTRANS uses one control lock per bank of
+	 * buffers rather than a single one.
+	 */
 	SubTransCtl->PagePrecedes = SubTransPagePrecedes;
-	SimpleLruInit(SubTransCtl, "subtrans", NUM_SUBTRANS_BUFFERS, 0,
-				  SubtransControlLock, "pg_subtrans",
-				  LWTRANCHE_SUBTRANS_BUFFERS);
+	SimpleLruInit(SubTransCtl, "subtrans", SUBTRANSShmemBuffers(), 0,
+				  NULL, "pg_subtrans",
+				  LWTRANCHE_SUBTRANS_BUFFERS, LWTRANCHE_SUBTRANS_BANKS);
 	/* Override default assumption that writes should be fsync'd */
 	SubTransCtl->do_fsync = false;
+
+	if (subtransaction_topmost_cache > 0)
+	{
+		TopmostCache = (pg_atomic_uint64 *)
+			ShmemInitStruct("subtrans topmost cache",
+							mul_size(subtransaction_topmost_cache,
+									 sizeof(pg_atomic_uint64)),
+							&found);
+		if (!found)
+		{
+			int			i;
+
+			/* InvalidTransactionId never matches a lookup */
+			for (i = 0; i < subtransaction_topmost_cache; i++)
+				pg_atomic_init_u64(&TopmostCache[i], 0);
+		}
+	}
 }
 
 /*
@@ -212,8 +317,9 @@ void
 BootStrapSUBTRANS(void)
 {
 	int			slotno;
+	LWLock	   *lock = SimpleLruGetBankLock(SubTransCtl, 0);
 
-	LWLockAcquire(SubtransControlLock, LW_EXCLUSIVE);
+	LWLockAcquire(lock, LW_EXCLUSIVE);
 
 	/* Create and zero the first page of the subtrans log */
 	slotno = ZeroSUBTRANSPage(0);
@@ -222,7 +328,7 @@ BootStrapSUBTRANS(void)
 	SimpleLruWritePage(SubTransCtl, slotno);
 	Assert(!SubTransCtl->shared->page_dirty[slotno]);
 
-	LWLockRelease(SubtransControlLock);
+	LWLockRelease(lock);
 }
 
 /*
@@ -231,7 +337,7 @@ BootStrapSUBTRANS(void)
  * The page is not actually written, just set up in shared memory.
  * The slot number of the new page is returned.
  *
- * Control lock must be held at entry, and will be held at exit.
+ * The page's bank lock must be held at entry, and will be held at exit.
  */
 static int
 ZeroSUBTRANSPage(int pageno)
@@ -241,7 +347,7 @@ ZeroSUBTRANSPage(int pageno)
 
 /*
  * This must be called ONCE during postmaster or standalone-backend startup,
- * after StartupXLOG has initialized ShmemVariableCache->nextXid.
+ * after StartupXLOG has initialized ShmemVariableCache->nextFullXid.
  *
  * oldestActiveXID is the oldest XID of any prepared transaction, or nextXid
  * if there are none.
@@ -258,22 +364,25 @@ StartupSUBTRANS(TransactionId oldestActiveXID)
 	 * Whenever we advance into a new page, ExtendSUBTRANS will likewise zero
 	 * the new page without regard to whatever was previously on disk.
 	 */
-	LWLockAcquire(SubtransControlLock, LW_EXCLUSIVE);
-
 	startPage = TransactionIdToPage(oldestActiveXID);
-	endPage = TransactionIdToPage(ShmemVariableCache->nextXid);
+	endPage = TransactionIdToPage(XidFromFullTransactionId(ShmemVariableCache->nextFullXid));
 
-	while (startPage != endPage)
+	for (;;)
 	{
+		LWLock	   *lock = SimpleLruGetBankLock(SubTransCtl, startPage);
+
+		LWLockAcquire(lock, LW_EXCLUSIVE);
 		(void) ZeroSUBTRANSPage(startPage);
+		LWLockRelease(lock);
+
+		if (startPage == endPage)
+			break;
+
 		startPage++;
 		/* must account for wraparound */
 		if (startPage > TransactionIdToPage(MaxTransactionId))
 			startPage = 0;
 	}
-	(void) ZeroSUBTRANSPage(startPage);
-
-	LWLockRelease(SubtransControlLock);
 }
 
 /*
@@ -324,6 +433,7 @@ void
 ExtendSUBTRANS(TransactionId newestXact)
 {
 	int			pageno;
+	LWLock	   *lock;
 
 	/*
 	 * No work except at first XID of a page.  But beware: just after
@@ -335,12 +445,13 @@ ExtendSUBTRANS(TransactionId newestXact)
 
 	pageno = TransactionIdToPage(newestXact);
 
-	LWLockAcquire(SubtransControlLock, LW_EXCLUSIVE);
+	lock = SimpleLruGetBankLock(SubTransCtl, pageno);
+	LWLockAcquire(lock, LW_EXCLUSIVE);
 
 	/* Zero the page */
 	ZeroSUBTRANSPage(pageno);
 
-	LWLockRelease(SubtransControlLock);
+	LWLockRelease(lock);
 }
 
 
@@ -34,19 +34,24 @@
 #include "access/xact.h"
 #include "access/xlog_internal.h"
 #include "access/xloginsert.h"
+#include "access/xlogprefetch.h"
+#include "access/xlogworker.h"
 #include "access/xlogreader.h"
 #include "access/xlogutils.h"
 #include "catalog/catversion.h"
 #include "catalog/pg_control.h"
 #include "catalog/pg_database.h"
 #include "commands/tablespace.h"
+#include "executor/instrument.h"
 #include "miscadmin.h"
 #include "pgstat.h"
 #include "port/atomics.h"
 #include "postmaster/bgwriter.h"
+#include "postmaster/pgarch.h"
 #include "postmaster/walwriter.h"
 #include "postmaster/startup.h"
 #include "replication/basebackup.h"
+#include "replication/basebackup_incremental.h"
 #include "replication/logical.h"
 #include "replication/slot.h"
 #include "replication/origin.h"
@@ -54,6 +59,7 @@
 #include "replication/walreceiver.h"
 #include "replication/walsender.h"
 #include "storage/bufmgr.h"
+#include "storage/doublewrite.h"
 #include "storage/fd.h"
 #include "storage/ipc.h"
 #include "storage/large_object.h"
@@ -91,7 +97,7 @@ char	   *XLogArchiveCommand = NULL;
 bool		EnableHotStandby = false;
 bool		fullPageWrites = true;
 bool		wal_log_hints = false;
-bool		wal_compression = false;
+int			wal_compression = WAL_COMPRESSION_NONE;
 char	   *wal_consistency_checking_string = NULL;
 bool	   *wal_consistency_checking = NULL;
 bool		log_checkpoints = false;
@@ -100,6 +106,8 @@ int			wal_level = WAL_LEVEL_MINIMAL;
 int			CommitDelay = 0;	/* precommit delay in microseconds */
 int			CommitSiblings = 5; /* # concurrent xacts needed to sleep */
 int			wal_retrieve_retry_interval = 5000;
+bool		wal_init_zero = true;
+int			wal_preallocate_segments = 0;
 
 #ifdef WAL_DEBUG
 bool		XLOG_DEBUG = false;
@@ -112,7 +120,15 @@ int			wal_segment_size = DEFAULT_XLOG_SEG_SIZE;
  * to happen concurrently, but adds some CPU overhead to flushing the WAL,
  * which needs to iterate all the locks.
  */
-#define NUM_XLOGINSERT_LOCKS  8
+int			wal_insert_locks = 8;
+
+/*
+ * When the WAL writer initializes WAL buffers ahead of insertions, it
+ * initializes at most this many pages before releasing WALBufMappingLock
+ * again, so that inserters that need a page right away don't have to wait
+ * for long.
+ */
+#define XLOG_PREINIT_BATCH	16
 
 /*
  * Max distance from last checkpoint, before triggering a new xlog-based
@@ -162,6 +178,30 @@ const struct config_enum_entry archive_mode_options[] = {
 	{NULL, 0, false}
 };
 
+/*
+ * "on" means pglz, which was the only method before; likewise we accept all
+ * the likely variants of "on" and "off".  Only the methods this build
+ * supports are accepted.
+ */
+const struct config_enum_entry wal_compression_options[] = {
+	{"pglz", WAL_COMPRESSION_PGLZ, false},
+#ifdef USE_LZ4
+	{"lz4", WAL_COMPRESSION_LZ4, false},
+#endif
+#ifdef USE_ZSTD
+	{"zstd", WAL_COMPRESSION_ZSTD, false},
+#endif
+	{"on", WAL_COMPRESSION_PGLZ, false},
+	{"off", WAL_COMPRESSION_NONE, false},
+	{"true", WAL_COMPRESSION_PGLZ, true},
+	{"false", WAL_COMPRESSION_NONE, true},
+	{"yes", WAL_COMPRESSION_PGLZ, true},
+	{"no", WAL_COMPRESSION_NONE, true},
+	{"1", WAL_COMPRESSION_PGLZ, true},
+	{"0", WAL_COMPRESSION_NONE, true},
+	{NULL, 0, false}
+};
+
 const struct config_enum_entry recovery_target_action_options[] = {
 	{"pause", RECOVERY_TARGET_ACTION_PAUSE, false},
 	{"promote", RECOVERY_TARGET_ACTION_PROMOTE, false},
@@ -589,13 +629,21 @@ typedef struct XLogCtlData
 	/* Protected by info_lck: */
 	XLogwrtRqst LogwrtRqst;
 	XLogRecPtr	RedoRecPtr;		/* a recent copy of Insert->RedoRecPtr */
-	uint32		ckptXidEpoch;	/* nextXID & epoch of latest checkpoint */
-	TransactionId ckptXid;
+	FullTransactionId ckptFullXid;	/* nextFullXid of latest checkpoint */
 	XLogRecPtr	asyncXactLSN;	/* LSN of newest async commit/abort */
 	XLogRecPtr	replicationSlotMinLSN;	/* oldest LSN needed by any slot */
 
 	XLogSegNo	lastRemovedSegNo;	/* latest removed/recycled XLOG segment */
 
+	/*
+	 * All WAL insertions before this point are known to have finished, as
+	 * determined by an earlier WaitXLogInsertionsToFinish() call.  Since new
+	 * insertions only ever go after the head of reserved WAL, this can only
+	 * advance.  It lets WaitXLogInsertionsToFinish() skip scanning all the
+	 * insertion locks when the wait it's asked for is already over.
+	 */
+	pg_atomic_uint64 insertsFinishedUpto;
+
 	/* Fake LSN counter, for unlogged relations. Protected by ulsn_lck. */
 	XLogRecPtr	unloggedLSN;
 	slock_t		ulsn_lck;
@@ -878,6 +926,7 @@ static XLogRecPtr XLogGetReplicationSlotMinimumLSN(void);
 static void AdvanceXLInsertBuffer(XLogRecPtr upto, bool opportunistic);
 static bool XLogCheckpointNeeded(XLogSegNo new_segno);
 static void XLogWrite(XLogwrtRqst WriteRqst, bool flexible);
+static void XLogFlushGroup(XLogRecPtr upto);
 static bool InstallXLogFileSegment(XLogSegNo *segno, char *tmppath,
 					   bool find_free, XLogSegNo max_segno,
 					   bool use_lock);
@@ -957,6 +1006,9 @@ static void WALInsertLockUpdateInsertingAt(XLogRecPtr insertingAt);
  * 'flags' gives more in-depth control on the record being inserted. See
  * XLogSetRecordFlags() for details.
  *
+ * 'num_fpi' is the number of full-page images in the record, for WAL usage
+ * accounting.
+ *
  * The first XLogRecData in the chain must be for the record header, and its
  * data must be MAXALIGNed.  XLogInsertRecord fills in the xl_prev and
  * xl_crc fields in the header, the rest of the header must already be filled
@@ -971,7 +1023,8 @@ static void WALInsertLockUpdateInsertingAt(XLogRecPtr insertingAt);
 XLogRecPtr
 XLogInsertRecord(XLogRecData *rdata,
 				 XLogRecPtr fpw_lsn,
-				 uint8 flags)
+				 uint8 flags,
+				 int num_fpi)
 {
 	XLogCtlInsert *Insert = &XLogCtl->Insert;
 	pg_crc32c	rdata_crc;
@@ -1008,8 +1061,8 @@ XLogInsertRecord(XLogRecData *rdata,
 	 * To keep track of which insertions are still in-progress, each concurrent
 	 * inserter acquires an insertion lock. In addition to just indicating that
 	 * an insertion is in progress, the lock tells others how far the inserter
-	 * has progressed. There is a small fixed number of insertion locks,
-	 * determined by NUM_XLOGINSERT_LOCKS. When an inserter crosses a page
+	 * has progressed. There is a small number of insertion locks, set by
+	 * wal_insert_locks. When an inserter crosses a page
 	 * boundary, it updates the value stored in the lock to the how far it has
 	 * inserted, to allow the previous buffer to be flushed.
 	 *
@@ -1226,6 +1279,18 @@ XLogInsertRecord(XLogRecData *rdata,
 	ProcLastRecPtr = StartPos;
 	XactLastRecEnd = EndPos;
 
+	/* Report WAL traffic to the instrumentation and the statistics */
+	if (inserted)
+	{
+		pgWalUsage.wal_records++;
+		pgWalUsage.wal_fpi += num_fpi;
+		pgWalUsage.wal_bytes += rechdr->xl_tot_len;
+
+		WalStats.m_wal_records++;
+		WalStats.m_wal_fpi += num_fpi;
+		WalStats.m_wal_bytes += rechdr->xl_tot_len;
+	}
+
 	return EndPos;
 }
 
@@ -1631,7 +1696,7 @@ WALInsertLockAcquire(void)
 	static int	lockToTry = -1;
 
 	if (lockToTry == -1)
-		lockToTry = MyProc->pgprocno % NUM_XLOGINSERT_LOCKS;
+		lockToTry = MyProc->pgprocno % wal_insert_locks;
 	MyLockNo = lockToTry;
 
 	/*
@@ -1649,7 +1714,7 @@ WALInsertLockAcquire(void)
 		 * than locks, it still helps to distribute the inserters evenly
 		 * across the locks.
 		 */
-		lockToTry = (lockToTry + 1) % NUM_XLOGINSERT_LOCKS;
+		lockToTry = (lockToTry + 1) % wal_insert_locks;
 	}
 }
 
@@ -1667,7 +1732,7 @@ WALInsertLockAcquireExclusive(void)
 	 * indicator is set to 0xFFFFFFFFFFFFFFFF, which is higher than any real
 	 * XLogRecPtr value, to make sure that no-one blocks waiting on those.
 	 */
-	for (i = 0; i < NUM_XLOGINSERT_LOCKS - 1; i++)
+	for (i = 0; i < wal_insert_locks - 1; i++)
 	{
 		LWLockAcquire(&WALInsertLocks[i].l.lock, LW_EXCLUSIVE);
 		LWLockUpdateVar(&WALInsertLocks[i].l.lock,
@@ -1693,7 +1758,7 @@ WALInsertLockRelease(void)
 	{
 		int			i;
 
-		for (i = 0; i < NUM_XLOGINSERT_LOCKS; i++)
+		for (i = 0; i < wal_insert_locks; i++)
 			LWLockReleaseClearVar(&WALInsertLocks[i].l.lock,
 								  &WALInsertLocks[i].l.insertingAt,
 								  0);
@@ -1721,8 +1786,8 @@ WALInsertLockUpdateInsertingAt(XLogRecPtr insertingAt)
 		 * We use the last lock to mark our actual position, see comments in
 		 * WALInsertLockAcquireExclusive.
 		 */
-		LWLockUpdateVar(&WALInsertLocks[NUM_XLOGINSERT_LOCKS - 1].l.lock,
-						&WALInsertLocks[NUM_XLOGINSERT_LOCKS - 1].l.insertingAt,
+		LWLockUpdateVar(&WALInsertLocks[wal_insert_locks - 1].l.lock,
+						&WALInsertLocks[wal_insert_locks - 1].l.insertingAt,
 						insertingAt);
 	}
 	else
@@ -1751,12 +1816,23 @@ WaitXLogInsertionsToFinish(XLogRecPtr upto)
 	uint64		bytepos;
 	XLogRecPtr	reservedUpto;
 	XLogRecPtr	finishedUpto;
+	XLogRecPtr	knownFinished;
 	XLogCtlInsert *Insert = &XLogCtl->Insert;
 	int			i;
 
 	if (MyProc == NULL)
 		elog(PANIC, "cannot wait without a PGPROC structure");
 
+	/*
+	 * If an earlier call already found all insertions up to the requested
+	 * point finished, there's nothing to wait for.  This saves scanning all
+	 * the insertion locks, which gets expensive with many of them, at the
+	 * cost of not moving the return value forward as far as we might.
+	 */
+	knownFinished = pg_atomic_read_u64(&XLogCtl->insertsFinishedUpto);
+	if (upto <= knownFinished)
+		return knownFinished;
+
 	/* Read the current insert position */
 	SpinLockAcquire(&Insert->insertpos_lck);
 	bytepos = Insert->CurrBytePos;
@@ -1789,7 +1865,7 @@ WaitXLogInsertionsToFinish(XLogRecPtr upto)
 	 * out for any insertion that's still in progress.
 	 */
 	finishedUpto = reservedUpto;
-	for (i = 0; i < NUM_XLOGINSERT_LOCKS; i++)
+	for (i = 0; i < wal_insert_locks; i++)
 	{
 		XLogRecPtr	insertingat = InvalidXLogRecPtr;
 
@@ -1825,6 +1901,15 @@ WaitXLogInsertionsToFinish(XLogRecPtr upto)
 		if (insertingat != InvalidXLogRecPtr && insertingat < finishedUpto)
 			finishedUpto = insertingat;
 	}
+
+	/* Advertise what we found, unless someone else got further already */
+	while (knownFinished < finishedUpto)
+	{
+		if (pg_atomic_compare_exchange_u64(&XLogCtl->insertsFinishedUpto,
+										   &knownFinished, finishedUpto))
+			break;
+	}
+
 	return finishedUpto;
 }
 
@@ -1950,6 +2035,70 @@ GetXLogBuffer(XLogRecPtr ptr)
 	return cachedPos + ptr % XLOG_BLCKSZ;
 }
 
+/*
+ * Read 'count' bytes of WAL starting at 'startptr' from the WAL buffers into
+ * 'buf', as far as they're still resident there.
+ *
+ * Returns the number of bytes read, which is less than 'count' if the WAL
+ * following them isn't in the buffers anymore (or, when called in recovery
+ * or for another timeline, never was); the caller has to read the rest from
+ * the WAL files.  The caller must only ask for WAL that has already been
+ * flushed, so that the buffers hold complete data for it.
+ *
+ * This takes no locks.  A page is only used if xlblocks shows it's loaded
+ * both before and after copying it, see AdvanceXLInsertBuffer().
+ */
+Size
+XLogReadFromBuffers(char *buf, XLogRecPtr startptr, Size count,
+					TimeLineID tli)
+{
+	/*
+	 * A torn read of xlblocks could make a recycled buffer look like the
+	 * page we want, so this needs atomic 8-byte reads.
+	 */
+#ifndef PG_HAVE_8BYTE_SINGLE_COPY_ATOMICITY
+	return 0;
+#else
+	XLogRecPtr	ptr = startptr;
+	Size		nbytes = count;
+	char	   *dst = buf;
+
+	/* the WAL buffers are only used for the timeline we insert on */
+	if (RecoveryInProgress() || tli != XLogCtl->ThisTimeLineID)
+		return 0;
+
+	while (nbytes > 0)
+	{
+		uint32		offset = ptr % XLOG_BLCKSZ;
+		int			idx = XLogRecPtrToBufIdx(ptr);
+		XLogRecPtr	expectedEndPtr = ptr - offset + XLOG_BLCKSZ;
+		Size		npagebytes;
+
+		npagebytes = Min(nbytes, XLOG_BLCKSZ - offset);
+
+		if (*((volatile XLogRecPtr *) &XLogCtl->xlblocks[idx]) != expectedEndPtr)
+			break;
+
+		pg_read_barrier();
+
+		memcpy(dst, XLogCtl->pages + idx * (Size) XLOG_BLCKSZ + offset,
+			   npagebytes);
+
+		/* make sure the page wasn't replaced while we copied it */
+		pg_read_barrier();
+
+		if (*((volatile XLogRecPtr *) &XLogCtl->xlblocks[idx]) != expectedEndPtr)
+			break;
+
+		dst += npagebytes;
+		ptr += npagebytes;
+		nbytes -= npagebytes;
+	}
+
+	return count - nbytes;
+#endif
+}
+
 /*
  * Converts a "usable byte position" to XLogRecPtr. A usable byte position
  * is the position starting from the beginning of WAL, excluding all WAL
@@ -2093,8 +2242,16 @@ AdvanceXLInsertBuffer(XLogRecPtr upto, bool opportunistic)
 	XLogRecPtr	NewPageBeginPtr;
 	XLogPageHeader NewPage;
 	int			npages = 0;
+	bool		locked = true;
 
-	LWLockAcquire(WALBufMappingLock, LW_EXCLUSIVE);
+	/*
+	 * When just pre-initializing pages, don't queue up behind inserters that
+	 * need a page; whoever holds the lock is initializing pages anyway.
+	 */
+	if (!opportunistic)
+		LWLockAcquire(WALBufMappingLock, LW_EXCLUSIVE);
+	else if (!LWLockConditionalAcquire(WALBufMappingLock, LW_EXCLUSIVE))
+		return;
 
 	/*
 	 * Now that we have the lock, check if someone initialized the page
@@ -2158,6 +2315,7 @@ AdvanceXLInsertBuffer(XLogRecPtr upto, bool opportunistic)
 					WriteRqst.Flush = 0;
 					XLogWrite(WriteRqst, false);
 					LWLockRelease(WALWriteLock);
+					WalStats.m_wal_buffers_full++;
 					TRACE_POSTGRESQL_WAL_BUFFER_WRITE_DIRTY_DONE();
 				}
 				/* Re-acquire WALBufMappingLock and retry */
@@ -2177,6 +2335,15 @@ AdvanceXLInsertBuffer(XLogRecPtr upto, bool opportunistic)
 
 		NewPage = (XLogPageHeader) (XLogCtl->pages + nextidx * (Size) XLOG_BLCKSZ);
 
+		/*
+		 * XLogReadFromBuffers() copies pages without holding any lock, and
+		 * trusts the copy if xlblocks shows the same page before and after.
+		 * Invalidate the old page before overwriting it, so that a reader
+		 * can't miss that the buffer was recycled under it.
+		 */
+		*((volatile XLogRecPtr *) &XLogCtl->xlblocks[nextidx]) = InvalidXLogRecPtr;
+		pg_write_barrier();
+
 		/*
 		 * Be sure to re-zero the buffer so that bytes beyond what we've
 		 * written will look like zeroes and not valid XLOG records...
@@ -2235,8 +2402,23 @@ AdvanceXLInsertBuffer(XLogRecPtr upto, bool opportunistic)
 		XLogCtl->InitializedUpTo = NewPageEndPtr;
 
 		npages++;
+
+		/*
+		 * When pre-initializing pages, release the lock every so often, to
+		 * let inserters waiting for the page we just initialized go ahead.
+		 */
+		if (opportunistic && npages % XLOG_PREINIT_BATCH == 0)
+		{
+			LWLockRelease(WALBufMappingLock);
+			if (!LWLockConditionalAcquire(WALBufMappingLock, LW_EXCLUSIVE))
+			{
+				locked = false;
+				break;
+			}
+		}
 	}
-	LWLockRelease(WALBufMappingLock);
+	if (locked)
+		LWLockRelease(WALBufMappingLock);
 
 #ifdef WAL_DEBUG
 	if (XLOG_DEBUG && npages > 0)
@@ -2797,13 +2979,13 @@ UpdateMinRecoveryPoint(XLogRecPtr lsn, bool force)
  * Ensure that all XLOG data through the given position is flushed to disk.
  *
  * NOTE: this differs from XLogWrite mainly in that the WALWriteLock is not
- * already held, and we try to avoid acquiring it if possible.
+ * already held; concurrent requests are batched into a single write and
+ * fsync by XLogFlushGroup.
  */
 void
 XLogFlush(XLogRecPtr record)
 {
 	XLogRecPtr	WriteRqstPtr;
-	XLogwrtRqst WriteRqst;
 
 	/*
 	 * During REDO, we are reading not writing WAL.  Therefore, instead of
@@ -2843,92 +3025,26 @@ XLogFlush(XLogRecPtr record)
 	/* initialize to given target; may increase below */
 	WriteRqstPtr = record;
 
-	/*
-	 * Now wait until we get the write lock, or someone else does the flush
-	 * for us.
-	 */
-	for (;;)
+	/* read LogwrtResult and update local state */
+	SpinLockAcquire(&XLogCtl->info_lck);
+	if (WriteRqstPtr < XLogCtl->LogwrtRqst.Write)
+		WriteRqstPtr = XLogCtl->LogwrtRqst.Write;
+	LogwrtResult = XLogCtl->LogwrtResult;
+	SpinLockRelease(&XLogCtl->info_lck);
+
+	/* done already? */
+	if (record > LogwrtResult.Flush)
 	{
 		XLogRecPtr	insertpos;
 
-		/* read LogwrtResult and update local state */
-		SpinLockAcquire(&XLogCtl->info_lck);
-		if (WriteRqstPtr < XLogCtl->LogwrtRqst.Write)
-			WriteRqstPtr = XLogCtl->LogwrtRqst.Write;
-		LogwrtResult = XLogCtl->LogwrtResult;
-		SpinLockRelease(&XLogCtl->info_lck);
-
-		/* done already? */
-		if (record <= LogwrtResult.Flush)
-			break;
-
 		/*
 		 * Before actually performing the write, wait for all in-flight
 		 * insertions to the pages we're about to write to finish.
 		 */
 		insertpos = WaitXLogInsertionsToFinish(WriteRqstPtr);
 
-		/*
-		 * Try to get the write lock. If we can't get it immediately, wait
-		 * until it's released, and recheck if we still need to do the flush
-		 * or if the backend that held the lock did it for us already. This
-		 * helps to maintain a good rate of group committing when the system
-		 * is bottlenecked by the speed of fsyncing.
-		 */
-		if (!LWLockAcquireOrWait(WALWriteLock, LW_EXCLUSIVE))
-		{
-			/*
-			 * The lock is now free, but we didn't acquire it yet. Before we
-			 * do, loop back to check if someone else flushed the record for
-			 * us already.
-			 */
-			continue;
-		}
-
-		/* Got the lock; recheck whether request is satisfied */
-		LogwrtResult = XLogCtl->LogwrtResult;
-		if (record <= LogwrtResult.Flush)
-		{
-			LWLockRelease(WALWriteLock);
-			break;
-		}
-
-		/*
-		 * Sleep before flush! By adding a delay here, we may give further
-		 * backends the opportunity to join the backlog of group commit
-		 * followers; this can significantly improve transaction throughput,
-		 * at the risk of increasing transaction latency.
-		 *
-		 * We do not sleep if enableFsync is not turned on, nor if there are
-		 * fewer than CommitSiblings other backends with active transactions.
-		 */
-		if (CommitDelay > 0 && enableFsync &&
-			MinimumActiveBackends(CommitSiblings))
-		{
-			pg_usleep(CommitDelay);
-
-			/*
-			 * Re-check how far we can now flush the WAL. It's generally not
-			 * safe to call WaitXLogInsertionsToFinish while holding
-			 * WALWriteLock, because an in-progress insertion might need to
-			 * also grab WALWriteLock to make progress. But we know that all
-			 * the insertions up to insertpos have already finished, because
-			 * that's what the earlier WaitXLogInsertionsToFinish() returned.
-			 * We're only calling it again to allow insertpos to be moved
-			 * further forward, not to actually wait for anyone.
-			 */
-			insertpos = WaitXLogInsertionsToFinish(insertpos);
-		}
-
-		/* try to write/flush later additions to XLOG as well */
-		WriteRqst.Write = insertpos;
-		WriteRqst.Flush = insertpos;
-
-		XLogWrite(WriteRqst, false);
-
-		LWLockRelease(WALWriteLock);
-		/* done */
-		break;
+		/* Have the WAL flushed through insertpos, by us or a group leader */
+		XLogFlushGroup(insertpos);
 	}
 
 	END_CRIT_SECTION();
@@ -2964,6 +3080,163 @@ XLogFlush(XLogRecPtr record)
 			 (uint32) (LogwrtResult.Flush >> 32), (uint32) LogwrtResult.Flush);
 }
 
+/*
+ * Flush WAL through the given position as part of a group.
+ *
+ * Backends that need WAL flushed add themselves to a list of processes
+ * waiting for a flush.  The first process to add itself to the list becomes
+ * the group leader.  It acquires WALWriteLock, which typically means waiting
+ * for the previous group's flush to finish, and more backends can join the
+ * group meanwhile.  Then it takes the whole list, and writes and flushes WAL
+ * through the furthest position requested by any member with a single
+ * XLogWrite().  The other members just sleep until the leader wakes them up,
+ * so WALWriteLock isn't handed from one committing process to the next, each
+ * of them rechecking how far WAL has been flushed in turn.
+ *
+ * Each member must already have waited for all WAL insertions up to the
+ * position it passes in to finish.  That way the leader doesn't have to wait
+ * for insertions while holding WALWriteLock, which isn't safe, since an
+ * in-progress insertion might need WALWriteLock to make progress.
+ *
+ * This is modeled on the group XID status update in clog.c.
+ */
+static void
+XLogFlushGroup(XLogRecPtr upto)
+{
+	volatile PROC_HDR *procglobal = ProcGlobal;
+	PGPROC	   *proc = MyProc;
+	uint32		nextidx;
+	uint32		wakeidx;
+	XLogRecPtr	flushupto;
+
+	Assert(proc != NULL);
+
+	/* Add ourselves to the list of processes needing a WAL flush. */
+	proc->flushGroupMember = true;
+	proc->flushGroupMemberLsn = upto;
+
+	nextidx = pg_atomic_read_u32(&procglobal->flushGroupFirst);
+
+	while (true)
+	{
+		pg_atomic_write_u32(&proc->flushGroupNext, nextidx);
+
+		if (pg_atomic_compare_exchange_u32(&procglobal->flushGroupFirst,
+										   &nextidx,
+										   (uint32) proc->pgprocno))
+			break;
+	}
+
+	/*
+	 * If the list was not empty, the leader will flush WAL for us. It is
+	 * impossible to have followers without a leader because the first
+	 * process that has added itself to the list will always have nextidx as
+	 * INVALID_PGPROCNO.
+	 */
+	if (nextidx != INVALID_PGPROCNO)
+	{
+		int			extraWaits = 0;
+
+		/* Sleep until the leader has flushed WAL. */
+		pgstat_report_wait_start(WAIT_EVENT_WAL_GROUP_FLUSH);
+		for (;;)
+		{
+			/* acts as a read barrier */
+			PGSemaphoreLock(proc->sem);
+			if (!proc->flushGroupMember)
+				break;
+			extraWaits++;
+		}
+		pgstat_report_wait_end();
+
+		Assert(pg_atomic_read_u32(&proc->flushGroupNext) == INVALID_PGPROCNO);
+
+		/* Fix semaphore count for any absorbed wakeups */
+		while (extraWaits-- > 0)
+			PGSemaphoreUnlock(proc->sem);
+
+		/* update local state */
+		SpinLockAcquire(&XLogCtl->info_lck);
+		LogwrtResult = XLogCtl->LogwrtResult;
+		SpinLockRelease(&XLogCtl->info_lck);
+		return;
+	}
+
+	/* We are the leader.  Acquire the lock on behalf of everyone. */
+	LWLockAcquire(WALWriteLock, LW_EXCLUSIVE);
+
+	/*
+	 * Sleep before flush! By adding a delay here, we may give further
+	 * backends the opportunity to join the group; this can significantly
+	 * improve transaction throughput, at the risk of increasing transaction
+	 * latency.
+	 *
+	 * We do not sleep if enableFsync is not turned on, nor if there are fewer
+	 * than CommitSiblings other backends with active transactions.
+	 */
+	if (CommitDelay > 0 && enableFsync &&
+		MinimumActiveBackends(CommitSiblings))
+		pg_usleep(CommitDelay);
+
+	/*
+	 * Now clear the list of processes waiting for a flush, saving a pointer
+	 * to the head of the list.  Trying to pop elements one at a time could
+	 * lead to an ABA problem.
+	 */
+	nextidx = pg_atomic_exchange_u32(&procglobal->flushGroupFirst,
+									 INVALID_PGPROCNO);
+
+	/* Remember head of list so we can perform wakeups after dropping lock. */
+	wakeidx = nextidx;
+
+	/* Walk the list to find how far we need to flush. */
+	flushupto = upto;
+	while (nextidx != INVALID_PGPROCNO)
+	{
+		PGPROC	   *member = &ProcGlobal->allProcs[nextidx];
+
+		if (member->flushGroupMemberLsn > flushupto)
+			flushupto = member->flushGroupMemberLsn;
+
+		/* Move to next proc in list. */
+		nextidx = pg_atomic_read_u32(&member->flushGroupNext);
+	}
+
+	/* Recheck whether someone else, like the WAL writer, did it already */
+	LogwrtResult = XLogCtl->LogwrtResult;
+	if (flushupto > LogwrtResult.Flush)
+	{
+		XLogwrtRqst WriteRqst;
+
+		WriteRqst.Write = flushupto;
+		WriteRqst.Flush = flushupto;
+		XLogWrite(WriteRqst, false);
+	}
+
+	LWLockRelease(WALWriteLock);
+
+	/*
+	 * Now that we've released the lock, go back and wake everybody up.  We
+	 * don't do this under the lock so as to keep lock hold times to a
+	 * minimum.
+	 */
+	while (wakeidx != INVALID_PGPROCNO)
+	{
+		PGPROC	   *member = &ProcGlobal->allProcs[wakeidx];
+
+		wakeidx = pg_atomic_read_u32(&member->flushGroupNext);
+		pg_atomic_write_u32(&member->flushGroupNext, INVALID_PGPROCNO);
+
+		/* ensure all previous writes are visible before follower continues. */
+		pg_write_barrier();
+
+		member->flushGroupMember = false;
+
+		if (member != MyProc)
+			PGSemaphoreUnlock(member->sem);
+	}
+}
+
 /*
  * Write & flush xlog, but without specifying exactly where to.
  *
@@ -3034,6 +3307,13 @@ XLogBackgroundFlush(void)
 				XLogFileClose();
 			}
 		}
+
+		/*
+		 * Backends flushing WAL themselves at commit may have freed up WAL
+		 * buffers since we last looked, so initialize them for future use
+		 * even though we had nothing to write.
+		 */
+		AdvanceXLInsertBuffer(InvalidXLogRecPtr, true);
 		return false;
 	}
 
@@ -3114,6 +3394,68 @@ XLogBackgroundFlush(void)
 	return true;
 }
 
+/*
+ * Create WAL segments ahead of the current insert position, so that backends
+ * moving into a new segment find it ready, rather than having to create and
+ * zero-fill it themselves while everyone else waits for them.
+ *
+ * We try to have wal_preallocate_segments segments in place beyond the one
+ * being inserted into.  Segments left behind by checkpoints for recycling
+ * count too, of course.  At most one segment is created per call, so that
+ * the caller, the background walwriter process, doesn't hold off flushing
+ * WAL for long.
+ *
+ * Returns true if a segment was created.
+ */
+bool
+XLogBackgroundPreallocate(void)
+{
+	static TimeLineID lastTLI = 0;
+	static XLogSegNo lastSegNo = 0;
+	XLogSegNo	insertSegNo;
+	XLogSegNo	segno;
+
+	/* This also initializes ThisTimeLineID, if need be */
+	if (wal_preallocate_segments <= 0 || RecoveryInProgress())
+		return false;
+
+	XLByteToSeg(GetXLogInsertRecPtr(), insertSegNo, wal_segment_size);
+
+	/*
+	 * Segments up to lastSegNo are known to exist already, since we made
+	 * sure of that earlier.  Future segments are never removed, except by a
+	 * timeline switch, after which they're named differently.
+	 */
+	if (lastTLI != ThisTimeLineID)
+	{
+		lastTLI = ThisTimeLineID;
+		lastSegNo = 0;
+	}
+
+	for (segno = Max(insertSegNo, lastSegNo) + 1;
+		 segno <= insertSegNo + wal_preallocate_segments;
+		 segno++)
+	{
+		bool		use_existent = true;
+		int			fd;
+
+		fd = XLogFileInit(segno, &use_existent, true);
+		close(fd);
+		lastSegNo = segno;
+
+		if (!use_existent)
+		{
+			char		fname[MAXFNAMELEN];
+
+			XLogFileName(fname, ThisTimeLineID, segno, wal_segment_size);
+			elog(DEBUG2, "preallocated WAL segment %s", fname);
+			return true;
+		}
+	}
+
+	return false;
+}
+
 /*
  * Test whether XLOG data has been flushed up to (at least) the given position.
  *
@@ -3263,31 +3605,80 @@ XLogFileInit(XLogSegNo logsegno, bool *use_existent, bool use_lock)
 	 * fsync below) that all the indirect blocks are down on disk.  Therefore,
 	 * fdatasync(2) or O_DSYNC will be sufficient to sync future writes to the
 	 * log file.
+	 *
+	 * If wal_init_zero is off, we instead let posix_fallocate() reserve the
+	 * space without writing it, which is much cheaper.  On file systems that
+	 * track such space as unwritten, the first write to each part of the
+	 * file then also changes file metadata, making a sync of it dearer; and
+	 * on copy-on-write file systems zero-filling is pointless anyway.  Where
+	 * posix_fallocate() is unavailable, we just write the last byte, so that
+	 * the file at least has the expected size.
 	 */
 	memset(zbuffer.data, 0, XLOG_BLCKSZ);
-	for (nbytes = 0; nbytes < wal_segment_size; nbytes += XLOG_BLCKSZ)
+	if (wal_init_zero)
 	{
-		errno = 0;
+		for (nbytes = 0; nbytes < wal_segment_size; nbytes += XLOG_BLCKSZ)
+		{
+			errno = 0;
+			pgstat_report_wait_start(WAIT_EVENT_WAL_INIT_WRITE);
+			if ((int) write(fd, zbuffer.data, XLOG_BLCKSZ) != (int) XLOG_BLCKSZ)
+			{
+				int			save_errno = errno;
+
+				/*
+				 * If we fail to make the file, delete it to release disk
+				 * space
+				 */
+				unlink(tmppath);
+
+				close(fd);
+
+				/* if write didn't set errno, assume problem is no disk space */
+				errno = save_errno ? save_errno : ENOSPC;
+
+				ereport(ERROR,
+						(errcode_for_file_access(),
+						 errmsg("could not write to file \"%s\": %m", tmppath)));
+			}
+			pgstat_report_wait_end();
+		}
+	}
+	else
+	{
+		int			rc;
+
 		pgstat_report_wait_start(WAIT_EVENT_WAL_INIT_WRITE);
-		if ((int) write(fd, zbuffer.data, XLOG_BLCKSZ) != (int) XLOG_BLCKSZ)
+#ifdef HAVE_POSIX_FALLOCATE
+		/* retry if interrupted, unless there is an interrupt pending */
+		do
+		{
+			rc = posix_fallocate(fd, 0, wal_segment_size);
+		} while (rc == EINTR && !(ProcDiePending || QueryCancelPending));
+
+		/* posix_fallocate() returns the error number instead of setting it */
+		errno = rc;
+#else
+		errno = 0;
+		rc = 0;
+		if (pg_pwrite(fd, zbuffer.data, 1, wal_segment_size - 1) != 1)
+			rc = errno ? errno : ENOSPC;
+		errno = rc;
+#endif
+		pgstat_report_wait_end();
+
+		if (rc != 0)
 		{
 			int			save_errno = errno;
 
-			/*
-			 * If we fail to make the file, delete it to release disk space
-			 */
 			unlink(tmppath);
-
 			close(fd);
-
-			/* if write didn't set errno, assume problem is no disk space */
-			errno = save_errno ? save_errno : ENOSPC;
+			errno = save_errno;
 
 			ereport(ERROR,
 					(errcode_for_file_access(),
-					 errmsg("could not write to file \"%s\": %m", tmppath)));
+					 errmsg("could not allocate space for file \"%s\": %m",
+							tmppath)));
 		}
-		pgstat_report_wait_end();
 	}
 
 	pgstat_report_wait_start(WAIT_EVENT_WAL_INIT_SYNC);
@@ -4963,7 +5354,7 @@ XLOGShmemSize(void)
 	size = sizeof(XLogCtlData);
 
 	/* WAL insertion locks, plus alignment */
-	size = add_size(size, mul_size(sizeof(WALInsertLockPadded), NUM_XLOGINSERT_LOCKS + 1));
+	size = add_size(size, mul_size(sizeof(WALInsertLockPadded), wal_insert_locks + 1));
 	/* xlblocks array */
 	size = add_size(size, mul_size(sizeof(XLogRecPtr), XLOGbuffers));
 	/* extra alignment padding for XLOG I/O buffers */
@@ -5055,10 +5446,10 @@ XLOGShmemInit(void)
 		((uintptr_t) allocptr) % sizeof(WALInsertLockPadded);
 	WALInsertLocks = XLogCtl->Insert.WALInsertLocks =
 		(WALInsertLockPadded *) allocptr;
-	allocptr += sizeof(WALInsertLockPadded) * NUM_XLOGINSERT_LOCKS;
+	allocptr += sizeof(WALInsertLockPadded) * wal_insert_locks;
 
 	LWLockRegisterTranche(LWTRANCHE_WAL_INSERT, "wal_insert");
-	for (i = 0; i < NUM_XLOGINSERT_LOCKS; i++)
+	for (i = 0; i < wal_insert_locks; i++)
 	{
 		LWLockInitialize(&WALInsertLocks[i].l.lock, LWTRANCHE_WAL_INSERT);
 		WALInsertLocks[i].l.insertingAt = InvalidXLogRecPtr;
@@ -5087,6 +5478,7 @@ XLOGShmemInit(void)
 	SpinLockInit(&XLogCtl->info_lck);
 	SpinLockInit(&XLogCtl->ulsn_lck);
 	InitSharedLatch(&XLogCtl->recoveryWakeupLatch);
+	pg_atomic_init_u64(&XLogCtl->insertsFinishedUpto, InvalidXLogRecPtr);
 }
 
 /*
@@ -5155,8 +5547,8 @@ BootStrapXLOG(void)
 	checkPoint.ThisTimeLineID = ThisTimeLineID;
 	checkPoint.PrevTimeLineID = ThisTimeLineID;
 	checkPoint.fullPageWrites = fullPageWrites;
-	checkPoint.nextXidEpoch = 0;
-	checkPoint.nextXid = FirstNormalTransactionId;
+	checkPoint.nextFullXid =
+		FullTransactionIdFromEpochAndXid(0, FirstNormalTransactionId);
 	checkPoint.nextOid = FirstBootstrapObjectId;
 	checkPoint.nextMulti = FirstMultiXactId;
 	checkPoint.nextMultiOffset = 0;
@@ -5169,7 +5561,7 @@ BootStrapXLOG(void)
 	checkPoint.time = (pg_time_t) time(NULL);
 	checkPoint.oldestActiveXid = InvalidTransactionId;
 
-	ShmemVariableCache->nextXid = checkPoint.nextXid;
+	ShmemVariableCache->nextFullXid = checkPoint.nextFullXid;
 	ShmemVariableCache->nextOid = checkPoint.nextOid;
 	ShmemVariableCache->oidCount = 0;
 	MultiXactSetNextMXact(checkPoint.nextMulti, checkPoint.nextMultiOffset);
@@ -6362,6 +6754,15 @@ StartupXLOG(void)
 	replay_image_masked = (char *) palloc(BLCKSZ);
 	master_image_masked = (char *) palloc(BLCKSZ);
 
+	/*
+	 * An incremental backup lacks most of the relation data; it has to be
+	 * combined with the backups it is based on before it can be used.
+	 */
+	if (stat(INCREMENTAL_BACKUP_FILE, &st) == 0)
+		ereport(FATAL,
+				(errmsg("data directory contains an incremental backup"),
+				 errhint("Use pg_combinebackup to reconstruct a full data directory from it and the backups it depends on.")));
+
 	if (read_backup_label(&checkPointLoc, &backupEndRequired,
 						  &backupFromStandby))
 	{
@@ -6594,7 +6995,8 @@ StartupXLOG(void)
 							 wasShutdown ? "true" : "false")));
 	ereport(DEBUG1,
 			(errmsg_internal("next transaction ID: %u:%u; next OID: %u",
-							 checkPoint.nextXidEpoch, checkPoint.nextXid,
+							 EpochFromFullTransactionId(checkPoint.nextFullXid),
+							 XidFromFullTransactionId(checkPoint.nextFullXid),
 							 checkPoint.nextOid)));
 	ereport(DEBUG1,
 			(errmsg_internal("next MultiXactId: %u; next MultiXactOffset: %u",
@@ -6609,12 +7011,12 @@ StartupXLOG(void)
 			(errmsg_internal("commit timestamp Xid oldest/newest: %u/%u",
 							 checkPoint.oldestCommitTsXid,
 							 checkPoint.newestCommitTsXid)));
-	if (!TransactionIdIsNormal(checkPoint.nextXid))
+	if (!TransactionIdIsNormal(XidFromFullTransactionId(checkPoint.nextFullXid)))
 		ereport(PANIC,
 				(errmsg("invalid next transaction ID")));
 
 	/* initialize shared memory variables from the checkpoint record */
-	ShmemVariableCache->nextXid = checkPoint.nextXid;
+	ShmemVariableCache->nextFullXid = checkPoint.nextFullXid;
 	ShmemVariableCache->nextOid = checkPoint.nextOid;
 	ShmemVariableCache->oidCount = 0;
 	MultiXactSetNextMXact(checkPoint.nextMulti, checkPoint.nextMultiOffset);
@@ -6623,8 +7025,7 @@ StartupXLOG(void)
 	SetMultiXactIdLimit(checkPoint.oldestMulti, checkPoint.oldestMultiDB, true);
 	SetCommitTsLimit(checkPoint.oldestCommitTsXid,
 					 checkPoint.newestCommitTsXid);
-	XLogCtl->ckptXidEpoch = checkPoint.nextXidEpoch;
-	XLogCtl->ckptXid = checkPoint.nextXid;
+	XLogCtl->ckptFullXid = checkPoint.nextFullXid;
 
 	/*
 	 * Initialize replication slots, before there's a chance to remove
@@ -6728,6 +7129,23 @@ StartupXLOG(void)
 		InRecovery = true;
 	}
 
+	/*
+	 * Reset pgstat data if we need recovery, because it may be invalid after
+	 * recovery.  Otherwise load the statistics saved at the last shutdown.
+	 */
+	if (InRecovery)
+		pgstat_reset_all();
+	else
+		pgstat_restore_stats();
+
+	/*
+	 * Repair any data pages torn by a crash from the double-write file, and
+	 * set it up for this run.  This must happen before replay, which could
+	 * otherwise read the torn pages, and before anyone writes data pages.
+	 * Pages in a base backup are protected by full-page images instead.
+	 */
+	StartupDoubleWrite(InRecovery && !haveBackupLabel, checkPoint.redo);
+
 	/* REDO */
 	if (InRecovery)
 	{
@@ -6823,11 +7241,6 @@ StartupXLOG(void)
 			minRecoveryPointTLI = 0;
 		}
 
-		/*
-		 * Reset pgstat data, because it may be invalid after recovery.
-		 */
-		pgstat_reset_all();
-
 		/*
 		 * If there was a backup label file, it's done its job and the info
 		 * has now been propagated into pg_control.  We must get rid of the
@@ -6895,7 +7308,7 @@ StartupXLOG(void)
 			Assert(TransactionIdIsValid(oldestActiveXID));
 
 			/* Tell procarray about the range of xids it has to deal with */
-			ProcArrayInitRecovery(ShmemVariableCache->nextXid);
+			ProcArrayInitRecovery(XidFromFullTransactionId(ShmemVariableCache->nextFullXid));
 
 			/*
 			 * Startup commit log and subtrans only.  MultiXact and commit
@@ -6925,9 +7338,9 @@ StartupXLOG(void)
 				running.xcnt = nxids;
 				running.subxcnt = 0;
 				running.subxid_overflow = false;
-				running.nextXid = checkPoint.nextXid;
+				running.nextXid = XidFromFullTransactionId(checkPoint.nextFullXid);
 				running.oldestRunningXid = oldestActiveXID;
-				latestCompletedXid = checkPoint.nextXid;
+				latestCompletedXid = XidFromFullTransactionId(checkPoint.nextFullXid);
 				TransactionIdRetreat(latestCompletedXid);
 				Assert(TransactionIdIsNormal(latestCompletedXid));
 				running.latestCompletedXid = latestCompletedXid;
@@ -7012,6 +7425,7 @@ StartupXLOG(void)
 		{
 			ErrorContextCallback errcallback;
 			TimestampTz xtime;
+			XLogPrefetchState *prefetcher;
 
 			InRedo = true;
 
@@ -7019,6 +7433,20 @@ StartupXLOG(void)
 					(errmsg("redo starts at %X/%X",
 							(uint32) (ReadRecPtr >> 32), (uint32) ReadRecPtr)));
 
+			/*
+			 * In crash recovery, find the blocks that are restored from
+			 * full-page images later on, so that redo can skip them until
+			 * then.  All of the WAL to be replayed must be on the
+			 * checkpoint's timeline.  With a backup label we replay the
+			 * least possible, and leave the whole business alone.
+			 */
+			if (recovery_full_page_scan && !ArchiveRecoveryRequested &&
+				!haveBackupLabel && recoveryTargetTLI == ThisTimeLineID)
+				XLogFullPageImageScan(ReadRecPtr, ThisTimeLineID);
+
+			/* Prepare to prefetch blocks that records ahead of us touch */
+			prefetcher = XLogPrefetchBegin();
+
 			/*
 			 * main redo apply loop
 			 */
@@ -7048,6 +7476,15 @@ StartupXLOG(void)
 				/* Handle interrupt signals of startup process */
 				HandleStartupProcInterrupts();
 
+				/*
+				 * Start reads of blocks that upcoming records will need.
+				 * While streaming, only WAL the walreceiver has already
+				 * written is safe to look at.
+				 */
+				XLogPrefetchReadAhead(prefetcher, ReadRecPtr, curFileTLI,
+									  readSource == XLOG_FROM_STREAM ?
+									  receivedUpto : InvalidXLogRecPtr);
+
 				/*
 				 * Pause WAL replay, if requested by a hot-standby session via
 				 * SetRecoveryPause().
@@ -7097,20 +7534,10 @@ StartupXLOG(void)
 				error_context_stack = &errcallback;
 
 				/*
-				 * ShmemVariableCache->nextXid must be beyond record's xid.
-				 *
-				 * We don't expect anyone else to modify nextXid, hence we
-				 * don't need to hold a lock while examining it.  We still
-				 * acquire the lock to modify it, though.
+				 * ShmemVariableCache->nextFullXid must be beyond record's
+				 * xid.
 				 */
-				if (TransactionIdFollowsOrEquals(record->xl_xid,
-												 ShmemVariableCache->nextXid))
-				{
-					LWLockAcquire(XidGenLock, LW_EXCLUSIVE);
-					ShmemVariableCache->nextXid = record->xl_xid;
-					TransactionIdAdvance(ShmemVariableCache->nextXid);
-					LWLockRelease(XidGenLock);
-				}
+				AdvanceNextFullTransactionIdPastXid(record->xl_xid);
 
 				/*
 				 * Before replaying this record, check if this record causes
@@ -7172,8 +7599,12 @@ StartupXLOG(void)
 					TransactionIdIsValid(record->xl_xid))
 					RecordKnownAssignedTransactionIds(record->xl_xid);
 
-				/* Now apply the WAL record itself */
-				RmgrTable[record->xl_rmid].rm_redo(xlogreader);
+				/*
+				 * Now apply the WAL record itself, unless a recovery worker
+				 * will
+				 */
+				if (!RecoveryWorkerDispatch(xlogreader))
+					RmgrTable[record->xl_rmid].rm_redo(xlogreader);
 
 				/*
 				 * After redo, check whether the backup pages associated with
@@ -7246,6 +7677,12 @@ StartupXLOG(void)
 			 * end of main redo apply loop
 			 */
 
+			XLogPrefetchEnd(prefetcher);
+			XLogFullPageImageScanEnd(LastRec);
+
+			/* Wait for the recovery workers to replay what they've got */
+			RecoveryWorkerWaitAll();
+
 			if (reachedStopPoint)
 			{
 				if (!reachedConsistency)
@@ -7690,7 +8127,8 @@ StartupXLOG(void)
 
 	/* also initialize latestCompletedXid, to nextXid - 1 */
 	LWLockAcquire(ProcArrayLock, LW_EXCLUSIVE);
-	ShmemVariableCache->latestCompletedXid = ShmemVariableCache->nextXid;
+	ShmemVariableCache->latestCompletedXid =
+		XidFromFullTransactionId(ShmemVariableCache->nextFullXid);
 	TransactionIdRetreat(ShmemVariableCache->latestCompletedXid);
 	LWLockRelease(ProcArrayLock);
 
@@ -8246,7 +8684,7 @@ GetLastImportantRecPtr(void)
 	XLogRecPtr	res = InvalidXLogRecPtr;
 	int			i;
 
-	for (i = 0; i < NUM_XLOGINSERT_LOCKS; i++)
+	for (i = 0; i < wal_insert_locks; i++)
 	{
 		XLogRecPtr	last_important;
 
@@ -8283,41 +8721,6 @@ GetLastSegSwitchData(XLogRecPtr *lastSwitchLSN)
 	return result;
 }
 
-/*
- * GetNextXidAndEpoch - get the current nextXid value and associated epoch
- *
- * This is exported for use by code that would like to have 64-bit XIDs.
- * We don't really support such things, but all XIDs within the system
- * can be presumed "close to" the result, and thus the epoch associated
- * with them can be determined.
- */
-void
-GetNextXidAndEpoch(TransactionId *xid, uint32 *epoch)
-{
-	uint32		ckptXidEpoch;
-	TransactionId ckptXid;
-	TransactionId nextXid;
-
-	/* Must read checkpoint info first, else have race condition */
-	SpinLockAcquire(&XLogCtl->info_lck);
-	ckptXidEpoch = XLogCtl->ckptXidEpoch;
-	ckptXid = XLogCtl->ckptXid;
-	SpinLockRelease(&XLogCtl->info_lck);
-
-	/* Now fetch current nextXid */
-	nextXid = ReadNewTransactionId();
-
-	/*
-	 * nextXid is certainly logically later than ckptXid.  So if it's
-	 * numerically less, it must have wrapped into the next epoch.
-	 */
-	if (nextXid < ckptXid)
-		ckptXidEpoch++;
-
-	*xid = nextXid;
-	*epoch = ckptXidEpoch;
-}
-
 /*
  * This must be called ONCE during postmaster or standalone-backend shutdown
  */
@@ -8358,7 +8761,8 @@ ShutdownXLOG(int code, Datum arg)
 		 * process one more time at the end of shutdown). The checkpoint
 		 * record will go to the next XLOG file and won't be archived (yet).
 		 */
-		if (XLogArchivingActive() && XLogArchiveCommandSet())
+		if (XLogArchivingActive() &&
+			(XLogArchiveCommandSet() || XLogArchiveLibrary[0] != '\0'))
 			RequestXLogSwitch(false);
 
 		CreateCheckPoint(CHECKPOINT_IS_SHUTDOWN | CHECKPOINT_IMMEDIATE);
@@ -8737,7 +9141,7 @@ CreateCheckPoint(int flags)
 	 * there.
 	 */
 	LWLockAcquire(XidGenLock, LW_SHARED);
-	checkPoint.nextXid = ShmemVariableCache->nextXid;
+	checkPoint.nextFullXid = ShmemVariableCache->nextFullXid;
 	checkPoint.oldestXid = ShmemVariableCache->oldestXid;
 	checkPoint.oldestXidDB = ShmemVariableCache->oldestXidDB;
 	LWLockRelease(XidGenLock);
@@ -8747,11 +9151,6 @@ CreateCheckPoint(int flags)
 	checkPoint.newestCommitTsXid = ShmemVariableCache->newestCommitTsXid;
 	LWLockRelease(CommitTsLock);
 
-	/* Increase XID epoch if we've wrapped around since last checkpoint */
-	checkPoint.nextXidEpoch = ControlFile->checkPointCopy.nextXidEpoch;
-	if (checkPoint.nextXid < ControlFile->checkPointCopy.nextXid)
-		checkPoint.nextXidEpoch++;
-
 	LWLockAcquire(OidGenLock, LW_SHARED);
 	checkPoint.nextOid = ShmemVariableCache->nextOid;
 	if (!shutdown)
@@ -8895,8 +9294,7 @@ CreateCheckPoint(int flags)
 
 	/* Update shared-memory copy of checkpoint XID/epoch */
 	SpinLockAcquire(&XLogCtl->info_lck);
-	XLogCtl->ckptXidEpoch = checkPoint.nextXidEpoch;
-	XLogCtl->ckptXid = checkPoint.nextXid;
+	XLogCtl->ckptFullXid = checkPoint.nextFullXid;
 	SpinLockRelease(&XLogCtl->info_lck);
 
 	/*
@@ -9514,6 +9912,14 @@ UpdateFullPageWrites(void)
 {
 	XLogCtlInsert *Insert = &XLogCtl->Insert;
 	bool		recoveryInProgress;
+	bool		fpw;
+
+	/*
+	 * Full-page images are not needed for torn-page protection while double
+	 * writes provide it.  (They're still taken during online backups; see
+	 * forcePageWrites.)
+	 */
+	fpw = fullPageWrites && !double_writes;
 
 	/*
 	 * Do nothing if full_page_writes has not been changed.
@@ -9522,7 +9928,7 @@ UpdateFullPageWrites(void)
 	 * because we assume that there is no concurrently running process which
 	 * can update it.
 	 */
-	if (fullPageWrites == Insert->fullPageWrites)
+	if (fpw == Insert->fullPageWrites)
 		return;
 
 	/*
@@ -9541,7 +9947,7 @@ UpdateFullPageWrites(void)
 	 * setting it to false, first write the WAL record and then set the global
 	 * flag.
 	 */
-	if (fullPageWrites)
+	if (fpw)
 	{
 		WALInsertLockAcquireExclusive();
 		Insert->fullPageWrites = true;
@@ -9555,12 +9961,12 @@ UpdateFullPageWrites(void)
 	if (XLogStandbyInfoActive() && !recoveryInProgress)
 	{
 		XLogBeginInsert();
-		XLogRegisterData((char *) (&fullPageWrites), sizeof(bool));
+		XLogRegisterData((char *) (&fpw), sizeof(bool));
 
 		XLogInsert(RM_XLOG_ID, XLOG_FPW_CHANGE);
 	}
 
-	if (!fullPageWrites)
+	if (!fpw)
 	{
 		WALInsertLockAcquireExclusive();
 		Insert->fullPageWrites = false;
@@ -9655,7 +10061,7 @@ xlog_redo(XLogReaderState *record)
 		memcpy(&checkPoint, XLogRecGetData(record), sizeof(CheckPoint));
 		/* In a SHUTDOWN checkpoint, believe the counters exactly */
 		LWLockAcquire(XidGenLock, LW_EXCLUSIVE);
-		ShmemVariableCache->nextXid = checkPoint.nextXid;
+		ShmemVariableCache->nextFullXid = checkPoint.nextFullXid;
 		LWLockRelease(XidGenLock);
 		LWLockAcquire(OidGenLock, LW_EXCLUSIVE);
 		ShmemVariableCache->nextOid = checkPoint.nextOid;
@@ -9709,9 +10115,9 @@ xlog_redo(XLogReaderState *record)
 			running.xcnt = nxids;
 			running.subxcnt = 0;
 			running.subxid_overflow = false;
-			running.nextXid = checkPoint.nextXid;
+			running.nextXid = XidFromFullTransactionId(checkPoint.nextFullXid);
 			running.oldestRunningXid = oldestActiveXID;
-			latestCompletedXid = checkPoint.nextXid;
+			latestCompletedXid = XidFromFullTransactionId(checkPoint.nextFullXid);
 			TransactionIdRetreat(latestCompletedXid);
 			Assert(TransactionIdIsNormal(latestCompletedXid));
 			running.latestCompletedXid = latestCompletedXid;
@@ -9723,13 +10129,11 @@ xlog_redo(XLogReaderState *record)
 		}
 
 		/* ControlFile->checkPointCopy always tracks the latest ckpt XID */
-		ControlFile->checkPointCopy.nextXidEpoch = checkPoint.nextXidEpoch;
-		ControlFile->checkPointCopy.nextXid = checkPoint.nextXid;
+		ControlFile->checkPointCopy.nextFullXid = checkPoint.nextFullXid;
 
 		/* Update shared-memory copy of checkpoint XID/epoch */
 		SpinLockAcquire(&XLogCtl->info_lck);
-		XLogCtl->ckptXidEpoch = checkPoint.nextXidEpoch;
-		XLogCtl->ckptXid = checkPoint.nextXid;
+		XLogCtl->ckptFullXid = checkPoint.nextFullXid;
 		SpinLockRelease(&XLogCtl->info_lck);
 
 		/*
@@ -9750,9 +10154,9 @@ xlog_redo(XLogReaderState *record)
 		memcpy(&checkPoint, XLogRecGetData(record), sizeof(CheckPoint));
 		/* In an ONLINE checkpoint, treat the XID counter as a minimum */
 		LWLockAcquire(XidGenLock, LW_EXCLUSIVE);
-		if (TransactionIdPrecedes(ShmemVariableCache->nextXid,
-								  checkPoint.nextXid))
-			ShmemVariableCache->nextXid = checkPoint.nextXid;
+		if (FullTransactionIdPrecedes(ShmemVariableCache->nextFullXid,
+									  checkPoint.nextFullXid))
+			ShmemVariableCache->nextFullXid = checkPoint.nextFullXid;
 		LWLockRelease(XidGenLock);
 
 		/*
@@ -9782,13 +10186,11 @@ xlog_redo(XLogReaderState *record)
 			SetTransactionIdLimit(checkPoint.oldestXid,
 								  checkPoint.oldestXidDB);
 		/* ControlFile->checkPointCopy always tracks the latest ckpt XID */
-		ControlFile->checkPointCopy.nextXidEpoch = checkPoint.nextXidEpoch;
-		ControlFile->checkPointCopy.nextXid = checkPoint.nextXid;
+		ControlFile->checkPointCopy.nextFullXid = checkPoint.nextFullXid;
 
 		/* Update shared-memory copy of checkpoint XID/epoch */
 		SpinLockAcquire(&XLogCtl->info_lck);
-		XLogCtl->ckptXidEpoch = checkPoint.nextXidEpoch;
-		XLogCtl->ckptXid = checkPoint.nextXid;
+		XLogCtl->ckptFullXid = checkPoint.nextFullXid;
 		SpinLockRelease(&XLogCtl->info_lck);
 
 		/* TLI should not change in an on-line checkpoint */
@@ -10029,10 +10431,19 @@ static int
 get_sync_bit(int method)
 {
 	int			o_direct_flag = 0;
+	int			io_direct_flag = 0;
+
+	/*
+	 * If io_direct includes WAL, use O_DIRECT whatever the sync method, and
+	 * even if fsync is disabled.  walreceiver is excluded for the correctness
+	 * reason given below.
+	 */
+	if ((io_direct_flags & IO_DIRECT_WAL) && !AmWalReceiverProcess())
+		io_direct_flag = PG_O_DIRECT;
 
 	/* If fsync is disabled, never open in sync mode */
 	if (!enableFsync)
-		return 0;
+		return io_direct_flag;
 
 	/*
 	 * Optimize writes by bypassing kernel cache with O_DIRECT when using
@@ -10062,14 +10473,14 @@ get_sync_bit(int method)
 		case SYNC_METHOD_FSYNC:
 		case SYNC_METHOD_FSYNC_WRITETHROUGH:
 		case SYNC_METHOD_FDATASYNC:
-			return 0;
+			return io_direct_flag;
 #ifdef OPEN_SYNC_FLAG
 		case SYNC_METHOD_OPEN:
-			return OPEN_SYNC_FLAG | o_direct_flag;
+			return OPEN_SYNC_FLAG | o_direct_flag | io_direct_flag;
 #endif
 #ifdef OPEN_DATASYNC_FLAG
 		case SYNC_METHOD_OPEN_DSYNC:
-			return OPEN_DATASYNC_FLAG | o_direct_flag;
+			return OPEN_DATASYNC_FLAG | o_direct_flag | io_direct_flag;
 #endif
 		default:
 			/* can't happen (unless we are out of sync with option array) */
@@ -12102,6 +12513,9 @@ WaitForWALToBecomeAvailable(XLogRecPtr RecPtr, bool randAccess,
 						streaming_reply_sent = true;
 					}
 
+					/* This is a good time to report our I/O, too */
+					pgstat_flush_io(false);
+
 					/*
 					 * Wait for more WAL to arrive. Time out after 5 seconds
 					 * to react to a trigger file promptly.
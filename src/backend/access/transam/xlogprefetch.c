@@ -0,0 +1,625 @@
+/*-------------------------------------------------------------------------
+ *
+ * xlogprefetch.c
+ *		Prefetching support for WAL replay, and skipping of redo for blocks
+ *		that are overwritten by a full-page image later on.
+ *
+ * During recovery the startup process replays records one at a time, and
+ * each buffer miss in XLogReadBufferForRedo() stalls replay until the read
+ * completes.  When replay is random-read bound, that makes recovery run at
+ * the speed of a single outstanding I/O.
+ *
+ * To do better, we run a second XLogReaderState a little ahead of replay
+ * and, for every block referenced by the records it decodes, ask the kernel
+ * to start reading the block if it isn't in shared buffers already.  By the
+ * time replay reaches the record the read has hopefully completed.  Blocks
+ * that redo won't read, because a full-page image will be restored or the
+ * page will be initialized from scratch, are skipped, and so are repeated
+ * references to the same few blocks.
+ *
+ * The look-ahead reader reads WAL segment files from pg_wal directly.  It
+ * never waits for WAL to arrive and never reads past what the caller says
+ * is known to be valid; whenever it can't read the next record it simply
+ * stops, and starts afresh from the replay position once replay has caught
+ * up with the point of failure.  Prefetching is therefore effective during
+ * crash recovery and on streaming standbys, but not while replaying files
+ * restored from an archive, which are not visible in pg_wal.
+ *
+ * Before crash recovery starts replaying, the same page_read callback is
+ * also used to scan all of the WAL to be replayed once, remembering for each
+ * block the last record that restores a full-page image of it.  Any change
+ * to such a block before that record is wiped out when the image is
+ * restored, so redo needn't read the block to apply it; see
+ * XLogFullPageImageFollows().  With a large max_wal_size most blocks that
+ * crash recovery touches have a full-page image somewhere in the WAL, and
+ * the sequential scan costs much less than the random reads of those blocks
+ * would.  We only do this in crash recovery, where all of the WAL is in
+ * pg_wal up front and replay ends where the scan ends.  Should replay
+ * nevertheless end before an image it relied upon, recovery can't complete;
+ * we leave a file behind so that the next attempt replays everything
+ * without scanning.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/backend/access/transam/xlogprefetch.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "access/xlog.h"
+#include "access/xlog_internal.h"
+#include "access/xlogprefetch.h"
+#include "access/xlogreader.h"
+#include "catalog/pg_control.h"
+#include "miscadmin.h"
+#include "pgstat.h"
+#include "postmaster/startup.h"
+#include "storage/bufmgr.h"
+#include "storage/fd.h"
+#include "storage/smgr.h"
+#include "utils/hsearch.h"
+
+/*
+ * Created in the data directory when replay ended before a full-page image
+ * that redo relied upon, so that the next recovery does without the scan.
+ */
+#define FULL_PAGE_SCAN_FAILED_FILE	"recovery_full_page_scan.failed"
+
+/* GUC variables */
+int			recovery_prefetch_distance = 256 * 1024;
+bool		recovery_full_page_scan = true;
+
+/*
+ * Number of recently prefetched blocks to remember, so that records touching
+ * the same block over and over (e.g. consecutive inserts into one heap page)
+ * cost one prefetch rather than one each.
+ */
+#define XLOGPREFETCH_RECENT_BLOCKS	16
+
+typedef struct XLogPrefetchRecentBlock
+{
+	RelFileNode rnode;
+	ForkNumber	forknum;
+	BlockNumber blkno;
+} XLogPrefetchRecentBlock;
+
+/* State of our page_read callback */
+typedef struct XLogPrefetchPrivate
+{
+	TimeLineID	tli;			/* timeline to read from */
+	XLogRecPtr	limit;			/* don't read beyond this, if valid */
+	int			fd;				/* currently open segment, or -1 */
+	XLogSegNo	segno;			/* segment number of fd */
+} XLogPrefetchPrivate;
+
+struct XLogPrefetchState
+{
+	XLogReaderState *reader;	/* look-ahead reader */
+	XLogPrefetchPrivate private;
+	bool		need_restart;	/* must restart reader at replay position? */
+	XLogRecPtr	retryPtr;		/* after a failure, wait for replay to get
+								 * here before trying again */
+
+	XLogPrefetchRecentBlock recent[XLOGPREFETCH_RECENT_BLOCKS];
+	int			recent_next;	/* next slot of recent[] to overwrite */
+
+	/* counters, reported at end of recovery */
+	uint64		nprefetch;		/* blocks handed to PrefetchSharedBuffer */
+	uint64		nskip_fpw;		/* skipped, a full-page image is restored */
+	uint64		nskip_init;		/* skipped, the page is re-initialized */
+	uint64		nskip_repeat;	/* skipped, block was prefetched recently */
+	uint64		nskip_later_fpw;	/* skipped, a later full-page image wins */
+};
+
+/*
+ * Entry in the table built by XLogFullPageImageScan().  The key is a
+ * XLogPrefetchRecentBlock, which has no padding.
+ */
+typedef struct XLogFullPageImage
+{
+	XLogPrefetchRecentBlock tag;	/* hash key, must be first */
+	XLogRecPtr	lsn;			/* start of last record with image of block */
+} XLogFullPageImage;
+
+static HTAB *fpi_hash = NULL;
+static XLogRecPtr fpi_scan_end = InvalidXLogRecPtr;
+
+/* did we skip the scan because the previous recovery attempt failed? */
+static bool fpi_scan_failed_before = false;
+
+/* highest fpi_hash LSN that redo has relied on, and how often it has */
+static XLogRecPtr fpi_relied_upon = InvalidXLogRecPtr;
+static uint64 fpi_nskipped = 0;
+
+static int	XLogPrefetchPageRead(XLogReaderState *reader,
+					 XLogRecPtr targetPagePtr, int reqLen,
+					 XLogRecPtr targetRecPtr, char *readBuf,
+					 TimeLineID *pageTLI);
+static void XLogPrefetchCloseSegment(XLogPrefetchState *state);
+static XLogRecPtr XLogFullPageImageLookup(RelFileNode rnode,
+						ForkNumber forknum, BlockNumber blkno);
+static void XLogFullPageImageScanFailed(void);
+static void XLogPrefetchRecord(XLogPrefetchState *state,
+				   XLogReaderState *record);
+
+/*
+ * Set up a prefetcher for use by the startup process.
+ */
+XLogPrefetchState *
+XLogPrefetchBegin(void)
+{
+	XLogPrefetchState *state;
+
+	state = palloc0(sizeof(XLogPrefetchState));
+	state->private.fd = -1;
+	state->reader = XLogReaderAllocate(wal_segment_size,
+									   &XLogPrefetchPageRead,
+									   &state->private);
+	if (!state->reader)
+		ereport(ERROR,
+				(errcode(ERRCODE_OUT_OF_MEMORY),
+				 errmsg("out of memory"),
+				 errdetail("Failed while allocating a WAL reading processor.")));
+	state->need_restart = true;
+	state->retryPtr = InvalidXLogRecPtr;
+
+	return state;
+}
+
+/*
+ * Release a prefetcher, after reporting what it did.
+ */
+void
+XLogPrefetchEnd(XLogPrefetchState *state)
+{
+	ereport(DEBUG1,
+			(errmsg_internal("recovery prefetch: " UINT64_FORMAT " blocks prefetched, "
+							 UINT64_FORMAT " skipped for full-page images, "
+							 UINT64_FORMAT " skipped for page initialization, "
+							 UINT64_FORMAT " skipped as repeated, "
+							 UINT64_FORMAT " skipped for later full-page images",
+							 state->nprefetch, state->nskip_fpw,
+							 state->nskip_init, state->nskip_repeat,
+							 state->nskip_later_fpw)));
+
+	XLogPrefetchCloseSegment(state);
+	XLogReaderFree(state->reader);
+	pfree(state);
+}
+
+/*
+ * Decode WAL ahead of replay and prefetch the blocks it references.
+ *
+ * replayPtr is the start of the record about to be replayed, and tli the
+ * timeline of the segment file it was read from.  readLimit, if valid, is
+ * the point up to which WAL in pg_wal is known to be complete; the caller
+ * passes InvalidXLogRecPtr when all of it may be read (crash recovery).
+ *
+ * We decode records until we're recovery_prefetch_distance bytes ahead of
+ * replayPtr, so in steady state each call decodes about as much WAL as is
+ * replayed between calls.
+ */
+void
+XLogPrefetchReadAhead(XLogPrefetchState *state, XLogRecPtr replayPtr,
+					  TimeLineID tli, XLogRecPtr readLimit)
+{
+	XLogReaderState *reader = state->reader;
+	XLogRecPtr	startPtr = InvalidXLogRecPtr;
+
+	if (recovery_prefetch_distance <= 0)
+		return;
+
+	/* After a read failure, wait until replay has passed that point */
+	if (replayPtr < state->retryPtr)
+		return;
+
+	/*
+	 * Restart at the replay position if we haven't started yet, failed
+	 * earlier, fell behind replay, or replay moved to another timeline.
+	 */
+	if (state->need_restart || reader->ReadRecPtr <= replayPtr ||
+		state->private.tli != tli)
+	{
+		XLogPrefetchCloseSegment(state);
+		state->private.tli = tli;
+		state->need_restart = false;
+		startPtr = replayPtr;
+	}
+	state->private.limit = readLimit;
+
+	for (;;)
+	{
+		XLogRecPtr	nextPtr;
+		XLogRecord *record;
+		char	   *errormsg;
+
+		/* far enough ahead? */
+		if (XLogRecPtrIsInvalid(startPtr) &&
+			reader->EndRecPtr >= replayPtr + recovery_prefetch_distance)
+			break;
+
+		nextPtr = XLogRecPtrIsInvalid(startPtr) ? reader->EndRecPtr : startPtr;
+
+		record = XLogReadRecord(reader, startPtr, &errormsg);
+		startPtr = InvalidXLogRecPtr;
+		if (record == NULL)
+		{
+			/*
+			 * Probably the end of the WAL available so far.  Whatever it is,
+			 * replay will deal with it when it gets there.
+			 */
+			state->need_restart = true;
+			state->retryPtr = nextPtr;
+			break;
+		}
+
+		XLogPrefetchRecord(state, reader);
+	}
+}
+
+/*
+ * Prefetch the blocks referenced by the record just decoded.
+ */
+static void
+XLogPrefetchRecord(XLogPrefetchState *state, XLogReaderState *record)
+{
+	int			block_id;
+
+	for (block_id = 0; block_id <= record->max_block_id; block_id++)
+	{
+		RelFileNode rnode;
+		ForkNumber	forknum;
+		BlockNumber blkno;
+		SMgrRelation smgr;
+		int			i;
+
+		if (!XLogRecGetBlockTag(record, block_id, &rnode, &forknum, &blkno))
+			continue;
+
+		/* redo won't read a block it restores from a full-page image */
+		if (XLogRecBlockImageApply(record, block_id))
+		{
+			state->nskip_fpw++;
+			continue;
+		}
+
+		/* ... or one it initializes from scratch */
+		if ((record->blocks[block_id].flags & BKPBLOCK_WILL_INIT) != 0)
+		{
+			state->nskip_init++;
+			continue;
+		}
+
+		/* ... or one whose changes will be overwritten anyway */
+		if (fpi_hash != NULL &&
+			XLogFullPageImageLookup(rnode, forknum, blkno) > record->ReadRecPtr)
+		{
+			state->nskip_later_fpw++;
+			continue;
+		}
+
+		for (i = 0; i < XLOGPREFETCH_RECENT_BLOCKS; i++)
+		{
+			XLogPrefetchRecentBlock *recent = &state->recent[i];
+
+			if (recent->blkno == blkno && recent->forknum == forknum &&
+				RelFileNodeEquals(recent->rnode, rnode))
+				break;
+		}
+		if (i < XLOGPREFETCH_RECENT_BLOCKS)
+		{
+			state->nskip_repeat++;
+			continue;
+		}
+
+		state->recent[state->recent_next].rnode = rnode;
+		state->recent[state->recent_next].forknum = forknum;
+		state->recent[state->recent_next].blkno = blkno;
+		state->recent_next = (state->recent_next + 1) % XLOGPREFETCH_RECENT_BLOCKS;
+
+		smgr = smgropen(rnode, InvalidBackendId);
+		PrefetchSharedBuffer(smgr, forknum, blkno);
+		state->nprefetch++;
+	}
+}
+
+/*
+ * Scan the WAL that crash recovery is about to replay, and remember the last
+ * full-page image that redo will restore for each block.
+ *
+ * startPtr is the start of the first record to be replayed, and tli the
+ * timeline all of the WAL is on.  The scan stops at the first record it
+ * can't read, which is where replay will stop too, or at a record that
+ * might make replay switch to another timeline.
+ *
+ * The table is limited to what fits in maintenance_work_mem.  Once it's
+ * full we only keep track of the blocks already in it, which is still
+ * correct: redo just won't skip anything for the others.
+ *
+ * Nothing is done if the previous attempt at recovery failed because of
+ * the scan, see XLogFullPageImageScanEnd().
+ */
+void
+XLogFullPageImageScan(XLogRecPtr startPtr, TimeLineID tli)
+{
+	XLogPrefetchPrivate private;
+	XLogReaderState *reader;
+	HASHCTL		ctl;
+	long		max_entries;
+	uint64		nrecords = 0;
+	struct stat st;
+
+	Assert(fpi_hash == NULL);
+
+	if (stat(FULL_PAGE_SCAN_FAILED_FILE, &st) == 0)
+	{
+		ereport(LOG,
+				(errmsg("not scanning WAL for full-page images, because the previous recovery attempt ended before one it relied upon")));
+		fpi_scan_failed_before = true;
+		return;
+	}
+
+	memset(&ctl, 0, sizeof(ctl));
+	ctl.keysize = sizeof(XLogPrefetchRecentBlock);
+	ctl.entrysize = sizeof(XLogFullPageImage);
+	fpi_hash = hash_create("recovery full-page images", 1024, &ctl,
+						   HASH_ELEM | HASH_BLOBS);
+	max_entries = (maintenance_work_mem * 1024L) /
+		(MAXALIGN(sizeof(XLogFullPageImage)) + 2 * sizeof(void *));
+	fpi_relied_upon = InvalidXLogRecPtr;
+	fpi_nskipped = 0;
+
+	memset(&private, 0, sizeof(private));
+	private.tli = tli;
+	private.limit = InvalidXLogRecPtr;
+	private.fd = -1;
+	reader = XLogReaderAllocate(wal_segment_size, &XLogPrefetchPageRead,
+								&private);
+	if (!reader)
+		ereport(ERROR,
+				(errcode(ERRCODE_OUT_OF_MEMORY),
+				 errmsg("out of memory"),
+				 errdetail("Failed while allocating a WAL reading processor.")));
+
+	for (;;)
+	{
+		XLogRecord *record;
+		char	   *errormsg;
+		uint8		info;
+		int			block_id;
+
+		record = XLogReadRecord(reader, startPtr, &errormsg);
+		startPtr = InvalidXLogRecPtr;
+		if (record == NULL)
+			break;
+
+		info = XLogRecGetInfo(reader) & ~XLR_INFO_MASK;
+		if (XLogRecGetRmid(reader) == RM_XLOG_ID &&
+			(info == XLOG_END_OF_RECOVERY || info == XLOG_CHECKPOINT_SHUTDOWN))
+			break;
+
+		for (block_id = 0; block_id <= reader->max_block_id; block_id++)
+		{
+			XLogPrefetchRecentBlock tag;
+			XLogFullPageImage *entry;
+
+			if (!XLogRecGetBlockTag(reader, block_id, &tag.rnode,
+									&tag.forknum, &tag.blkno))
+				continue;
+			if (!XLogRecBlockImageApply(reader, block_id))
+				continue;
+
+			entry = hash_search(fpi_hash, &tag, HASH_FIND, NULL);
+			if (entry == NULL && hash_get_num_entries(fpi_hash) < max_entries)
+				entry = hash_search(fpi_hash, &tag, HASH_ENTER, NULL);
+			if (entry != NULL)
+				entry->lsn = reader->ReadRecPtr;
+		}
+
+		if (++nrecords % 65536 == 0)
+			HandleStartupProcInterrupts();
+	}
+	fpi_scan_end = reader->EndRecPtr;
+
+	if (private.fd >= 0)
+		close(private.fd);
+	XLogReaderFree(reader);
+
+	ereport(DEBUG1,
+			(errmsg_internal("found full-page images of %ld blocks in WAL up to %X/%X",
+							 hash_get_num_entries(fpi_hash),
+							 (uint32) (fpi_scan_end >> 32),
+							 (uint32) fpi_scan_end)));
+}
+
+/*
+ * Does a record after the one starting at lsn restore a full-page image of
+ * the given block?  If so, redo of the record at lsn can skip the block.
+ */
+bool
+XLogFullPageImageFollows(RelFileNode rnode, ForkNumber forknum,
+						 BlockNumber blkno, XLogRecPtr lsn)
+{
+	XLogRecPtr	fpiPtr;
+
+	if (fpi_hash == NULL)
+		return false;
+
+	fpiPtr = XLogFullPageImageLookup(rnode, forknum, blkno);
+	if (fpiPtr <= lsn)
+		return false;
+
+	if (fpiPtr > fpi_relied_upon)
+		fpi_relied_upon = fpiPtr;
+	fpi_nskipped++;
+	return true;
+}
+
+/*
+ * Forget the full-page images found by XLogFullPageImageScan(), once replay
+ * is done.  lastReplayedPtr is the start of the last record replayed.
+ *
+ * Skipping a block was only correct if its full-page image was restored
+ * after all, so if replay ended early, for example because it failed to
+ * read WAL that the scan could read, the blocks may now be missing changes.
+ * That can't be repaired, but starting recovery over can.  As it would
+ * likely end in the same place, we first make sure the next attempt doesn't
+ * scan, so that it replays every change; the skipped blocks weren't
+ * modified on disk, so they're still in a state redo can start from.
+ */
+void
+XLogFullPageImageScanEnd(XLogRecPtr lastReplayedPtr)
+{
+	if (fpi_scan_failed_before)
+	{
+		/* this attempt didn't skip anything, so the next one may again */
+		durable_unlink(FULL_PAGE_SCAN_FAILED_FILE, LOG);
+		fpi_scan_failed_before = false;
+	}
+
+	if (fpi_hash == NULL)
+		return;
+
+	if (fpi_relied_upon > lastReplayedPtr)
+	{
+		XLogFullPageImageScanFailed();
+		ereport(PANIC,
+				(errmsg("WAL replay ended at %X/%X, before the full-page image at %X/%X",
+						(uint32) (lastReplayedPtr >> 32),
+						(uint32) lastReplayedPtr,
+						(uint32) (fpi_relied_upon >> 32),
+						(uint32) fpi_relied_upon),
+				 errhint("The next recovery attempt will replay all of the WAL without skipping blocks.")));
+	}
+
+	ereport(DEBUG1,
+			(errmsg_internal("skipped redo of " UINT64_FORMAT " blocks overwritten by later full-page images",
+							 fpi_nskipped)));
+
+	hash_destroy(fpi_hash);
+	fpi_hash = NULL;
+}
+
+/*
+ * Durably create FULL_PAGE_SCAN_FAILED_FILE, just before we PANIC.  Failing
+ * to create it is only logged, since we're about to give up anyway.
+ */
+static void
+XLogFullPageImageScanFailed(void)
+{
+	int			fd;
+
+	fd = OpenTransientFile(FULL_PAGE_SCAN_FAILED_FILE,
+						   O_RDWR | O_CREAT | PG_BINARY);
+	if (fd < 0)
+	{
+		ereport(LOG,
+				(errcode_for_file_access(),
+				 errmsg("could not create file \"%s\": %m",
+						FULL_PAGE_SCAN_FAILED_FILE)));
+		return;
+	}
+	if (pg_fsync(fd) != 0)
+		ereport(LOG,
+				(errcode_for_file_access(),
+				 errmsg("could not fsync file \"%s\": %m",
+						FULL_PAGE_SCAN_FAILED_FILE)));
+	CloseTransientFile(fd);
+
+	fsync_fname(".", true);
+}
+
+/*
+ * Return the start of the last record restoring a full-page image of the
+ * given block, or InvalidXLogRecPtr if none is known.
+ */
+static XLogRecPtr
+XLogFullPageImageLookup(RelFileNode rnode, ForkNumber forknum,
+						BlockNumber blkno)
+{
+	XLogPrefetchRecentBlock tag;
+	XLogFullPageImage *entry;
+
+	tag.rnode = rnode;
+	tag.forknum = forknum;
+	tag.blkno = blkno;
+	entry = hash_search(fpi_hash, &tag, HASH_FIND, NULL);
+
+	return entry ? entry->lsn : InvalidXLogRecPtr;
+}
+
+/*
+ * Close the segment file our page_read callback has open, if any.
+ */
+static void
+XLogPrefetchCloseSegment(XLogPrefetchState *state)
+{
+	if (state->private.fd >= 0)
+	{
+		close(state->private.fd);
+		state->private.fd = -1;
+	}
+}
+
+/*
+ * page_read callback for the look-ahead reader.
+ *
+ * Unlike XLogPageRead() in xlog.c this never waits for WAL to become
+ * available: anything not already present in pg_wal, or beyond the limit
+ * set by our caller, is reported as a read failure.
+ */
+static int
+XLogPrefetchPageRead(XLogReaderState *reader, XLogRecPtr targetPagePtr,
+					 int reqLen, XLogRecPtr targetRecPtr, char *readBuf,
+					 TimeLineID *pageTLI)
+{
+	XLogPrefetchPrivate *private = (XLogPrefetchPrivate *) reader->private_data;
+	XLogSegNo	targetSegNo;
+	uint32		targetPageOff;
+	int			readLen = XLOG_BLCKSZ;
+	int			r;
+
+	if (!XLogRecPtrIsInvalid(private->limit))
+	{
+		if (targetPagePtr + reqLen > private->limit)
+			return -1;
+		if (targetPagePtr + XLOG_BLCKSZ > private->limit)
+			readLen = private->limit - targetPagePtr;
+	}
+
+	XLByteToSeg(targetPagePtr, targetSegNo, reader->wal_segment_size);
+	targetPageOff = XLogSegmentOffset(targetPagePtr, reader->wal_segment_size);
+
+	if (private->fd >= 0 && private->segno != targetSegNo)
+	{
+		close(private->fd);
+		private->fd = -1;
+	}
+
+	if (private->fd < 0)
+	{
+		char		path[MAXPGPATH];
+
+		XLogFilePath(path, private->tli, targetSegNo, reader->wal_segment_size);
+		private->fd = BasicOpenFile(path, O_RDONLY | PG_BINARY);
+		if (private->fd < 0)
+			return -1;
+		private->segno = targetSegNo;
+	}
+
+	pgstat_report_wait_start(WAIT_EVENT_WAL_READ);
+	r = pg_pread(private->fd, readBuf, XLOG_BLCKSZ, (off_t) targetPageOff);
+	pgstat_report_wait_end();
+
+	if (r < readLen)
+		return -1;
+
+	*pageTLI = private->tli;
+	return readLen;
+}
@@ -22,7 +22,9 @@
 #include "access/timeline.h"
 #include "access/xlog.h"
 #include "access/xlog_internal.h"
+#include "access/xlogprefetch.h"
 #include "access/xlogutils.h"
+#include "access/xlogworker.h"
 #include "miscadmin.h"
 #include "pgstat.h"
 #include "storage/smgr.h"
@@ -387,6 +389,23 @@ XLogReadBufferForRedoExtended(XLogReaderState *record,
 	}
 	else
 	{
+		/*
+		 * If a later record restores a full-page image of the block, the
+		 * changes we'd make are overwritten then, so don't bother reading
+		 * the block.  Callers cope with a block that's not there, as they
+		 * must before reaching consistency anyway.  Modes other than
+		 * RBM_NORMAL promise a valid buffer, so don't do it for those, nor
+		 * when the page is to be checked against the record's image.
+		 */
+		if (mode == RBM_NORMAL &&
+			(XLogRecGetInfo(record) & XLR_CHECK_CONSISTENCY) == 0 &&
+			XLogFullPageImageFollows(rnode, forknum, blkno,
+									 record->ReadRecPtr))
+		{
+			*buf = InvalidBuffer;
+			return BLK_NOTFOUND;
+		}
+
 		*buf = XLogReadBufferExtended(rnode, forknum, blkno, mode);
 		if (BufferIsValid(*buf))
 		{
@@ -477,28 +496,48 @@ XLogReadBufferExtended(RelFileNode rnode, ForkNumber forknum,
 		/* OK to extend the file */
 		/* we do this in recovery only - no rel-extension lock needed */
 		Assert(InRecovery);
+
+		/*
+		 * ... except that recovery workers may extend the same relation at
+		 * the same time.  Whoever got here first may have done our work.
+		 */
+		if (AmRecoveryWorker)
+		{
+			LWLockAcquire(RecoveryWorkerExtensionLock, LW_EXCLUSIVE);
+			lastblock = smgrnblocks(smgr, forknum);
+		}
+
 		buffer = InvalidBuffer;
-		do
+		if (blkno < lastblock)
+			buffer = ReadBufferWithoutRelcache(rnode, forknum, blkno,
+											   mode, NULL);
+		else
 		{
-			if (buffer != InvalidBuffer)
+			do
+			{
+				if (buffer != InvalidBuffer)
+				{
+					if (mode == RBM_ZERO_AND_LOCK || mode == RBM_ZERO_AND_CLEANUP_LOCK)
+						LockBuffer(buffer, BUFFER_LOCK_UNLOCK);
+					ReleaseBuffer(buffer);
+				}
+				buffer = ReadBufferWithoutRelcache(rnode, forknum,
+												   P_NEW, mode, NULL);
+			}
+			while (BufferGetBlockNumber(buffer) < blkno);
+			/* Handle the corner case that P_NEW returns non-consecutive pages */
+			if (BufferGetBlockNumber(buffer) != blkno)
 			{
 				if (mode == RBM_ZERO_AND_LOCK || mode == RBM_ZERO_AND_CLEANUP_LOCK)
 					LockBuffer(buffer, BUFFER_LOCK_UNLOCK);
 				ReleaseBuffer(buffer);
+				buffer = ReadBufferWithoutRelcache(rnode, forknum, blkno,
+												   mode, NULL);
 			}
-			buffer = ReadBufferWithoutRelcache(rnode, forknum,
-											   P_NEW, mode, NULL);
-		}
-		while (BufferGetBlockNumber(buffer) < blkno);
-		/* Handle the corner case that P_NEW returns non-consecutive pages */
-		if (BufferGetBlockNumber(buffer) != blkno)
-		{
-			if (mode == RBM_ZERO_AND_LOCK || mode == RBM_ZERO_AND_CLEANUP_LOCK)
-				LockBuffer(buffer, BUFFER_LOCK_UNLOCK);
-			ReleaseBuffer(buffer);
-			buffer = ReadBufferWithoutRelcache(rnode, forknum, blkno,
-											   mode, NULL);
 		}
+
+		if (AmRecoveryWorker)
+			LWLockRelease(RecoveryWorkerExtensionLock);
 	}
 
 	if (mode == RBM_NORMAL)
@@ -0,0 +1,756 @@
+/*-------------------------------------------------------------------------
+ *
+ * xlogworker.c
+ *		Parallel WAL replay by recovery workers.
+ *
+ * The startup process replays WAL one record at a time, so a standby can
+ * fall ever further behind a primary where many backends generate WAL at
+ * once.  When recovery_workers is set, the postmaster starts that many
+ * recovery workers, as background workers, and the startup process hands
+ * some of the records to them instead of replaying them itself.
+ *
+ * Only records that change a single page and nothing else are handed out:
+ * heap inserts, deletes, row locks and updates within a page, and btree leaf
+ * insertions.  Each goes to the worker chosen by hashing its relation and
+ * block number, so all records for a page are replayed by the same worker,
+ * in WAL order, while records for different pages are replayed in parallel.
+ * All other records, including commits, records touching several pages such
+ * as btree page splits, DDL, and records that may have to resolve conflicts
+ * with hot standby queries, are replayed by the startup process itself, once
+ * the workers have replayed everything queued before them.  In particular,
+ * all changes made by a transaction are in place before its commit record
+ * makes them visible to hot standby queries.
+ *
+ * Records are only handed out once recovery has reached a consistent state,
+ * so the workers mostly help a standby keep up with streamed WAL.
+ *
+ * Each worker has a slot in shared memory with a ring buffer of copied
+ * records.  The startup process appends records to it and sets the worker's
+ * latch if it's sleeping; the worker decodes and replays them and sets the
+ * startup process's latch if that is waiting for room in the queue, or for
+ * the worker to catch up.  The slot's spinlock protects the queue positions
+ * and flags; the queue contents are only written by the startup process
+ * ahead of insert_pos and only read by the worker behind it.
+ *
+ * Like the checkpoint writers, the workers are a best-effort addition: when
+ * no worker is attached to a slot, e.g. because it hasn't started yet, the
+ * startup process replays any records left in the slot's queue, and those it
+ * would have queued there, itself.
+ *
+ * Workers hold RecoveryWorkerExtensionLock while extending a relation in
+ * XLogReadBufferExtended(), since two of them may extend the same relation
+ * at once.  They don't receive shared invalidation messages, so the startup
+ * process makes them close all relations after replaying a record that may
+ * drop or truncate some.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/backend/access/transam/xlogworker.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "access/hash.h"
+#include "access/heapam_xlog.h"
+#include "access/nbtxlog.h"
+#include "access/xact.h"
+#include "access/xlog.h"
+#include "access/xlog_internal.h"
+#include "access/xlogworker.h"
+#include "miscadmin.h"
+#include "pgstat.h"
+#include "postmaster/bgworker.h"
+#include "postmaster/startup.h"
+#include "storage/bufmgr.h"
+#include "storage/ipc.h"
+#include "storage/latch.h"
+#include "storage/shmem.h"
+#include "storage/smgr.h"
+#include "storage/spin.h"
+#include "tcop/tcopprot.h"
+#include "utils/guc.h"
+#include "utils/hashutils.h"
+#include "utils/memutils.h"
+#include "utils/resowner.h"
+
+
+/* Size of each worker's queue of records */
+#define RECOVERY_WORKER_QUEUE_SIZE	(1024 * 1024)
+
+/* Larger records are replayed by the startup process */
+#define RECOVERY_WORKER_MAX_ENTRY	(RECOVERY_WORKER_QUEUE_SIZE / 8)
+
+/* A worker idle for this long (in ms) closes its open relations */
+#define RECOVERY_WORKER_IDLE_TIMEOUT	10000
+
+/*
+ * Header of a record in a worker's queue, followed by the XLogRecord.  An
+ * entry never wraps around the end of the queue; if there's not enough room
+ * left, an entry with size 0 marks the rest as unused.
+ */
+typedef struct RecoveryWorkerEntry
+{
+	uint32		size;			/* total size of entry, MAXALIGN'd */
+	XLogRecPtr	ReadRecPtr;		/* start of the record */
+	XLogRecPtr	EndRecPtr;		/* end+1 of the record */
+} RecoveryWorkerEntry;
+
+#define RECOVERY_WORKER_ENTRY_HDRSZ	MAXALIGN(sizeof(RecoveryWorkerEntry))
+
+typedef struct RecoveryWorkerSlot
+{
+	slock_t		mutex;			/* protects the following fields */
+	pid_t		pid;			/* PID of worker, 0 if none is attached */
+	Latch	   *latch;			/* worker's latch, if attached */
+	bool		sleeping;		/* worker waits for records to arrive */
+	bool		waiting;		/* startup process waits for the worker */
+	uint64		insert_pos;		/* # of bytes ever queued */
+	uint64		apply_pos;		/* # of bytes ever replayed */
+} RecoveryWorkerSlot;
+
+typedef struct RecoveryWorkerCtlData
+{
+	/*
+	 * These are only changed by the startup process, and read by workers
+	 * while holding their slot's mutex after it has queued a record.
+	 */
+	Latch	   *startupLatch;	/* startup process's latch */
+	uint64		closeGeneration;	/* advanced to make workers close their
+									 * relations */
+
+	RecoveryWorkerSlot slots[FLEXIBLE_ARRAY_MEMBER];
+} RecoveryWorkerCtlData;
+
+/* GUC variable */
+int			recovery_workers = 0;
+
+/* true in a recovery worker process */
+bool		AmRecoveryWorker = false;
+
+/* Shared memory: control data, followed by the queues of all workers */
+static RecoveryWorkerCtlData *RecoveryWorkerCtl = NULL;
+static char *RecoveryWorkerQueues = NULL;
+
+/* Our slot, in a worker */
+static RecoveryWorkerSlot *MySlot = NULL;
+
+/* Startup process's note of whether any queue may be nonempty */
+static bool records_queued = false;
+
+/* Startup process's reader for records left behind by a worker */
+static XLogReaderState *leftover_reader = NULL;
+
+static volatile sig_atomic_t got_SIGHUP = false;
+
+static void recoveryworker_sighup(SIGNAL_ARGS);
+static void recoveryworker_detach(int code, Datum arg);
+static void recoveryworker_error_callback(void *arg);
+static bool RecoveryWorkerCanReplay(XLogReaderState *record);
+static bool RecoveryWorkerDropsFiles(XLogReaderState *record);
+static bool RecoveryWorkerEnqueue(int worker, XLogReaderState *record);
+static bool RecoveryWorkerTakeOver(int worker);
+static uint64 RecoveryWorkerReplay(char *queue, uint64 pos,
+					 XLogReaderState *reader, MemoryContext redo_context);
+
+#define RecoveryWorkerQueue(worker) \
+	(RecoveryWorkerQueues + (Size) (worker) * RECOVERY_WORKER_QUEUE_SIZE)
+
+
+/*
+ * RecoveryWorkerRegister
+ *		Register the recovery workers as background workers.
+ *
+ * Called by the postmaster, before it computes MaxBackends.
+ */
+void
+RecoveryWorkerRegister(void)
+{
+	BackgroundWorker bgw;
+	int			i;
+
+	for (i = 0; i < recovery_workers; i++)
+	{
+		memset(&bgw, 0, sizeof(bgw));
+		bgw.bgw_flags = BGWORKER_SHMEM_ACCESS;
+		bgw.bgw_start_time = BgWorkerStart_PostmasterStart;
+		snprintf(bgw.bgw_library_name, BGW_MAXLEN, "postgres");
+		snprintf(bgw.bgw_function_name, BGW_MAXLEN, "RecoveryWorkerMain");
+		snprintf(bgw.bgw_name, BGW_MAXLEN, "recovery worker %d", i);
+		snprintf(bgw.bgw_type, BGW_MAXLEN, "recovery worker");
+		bgw.bgw_restart_time = 5;
+		bgw.bgw_notify_pid = 0;
+		bgw.bgw_main_arg = Int32GetDatum(i);
+
+		RegisterBackgroundWorker(&bgw);
+	}
+}
+
+/* Space for the control data, before the queues */
+static Size
+RecoveryWorkerCtlSize(void)
+{
+	return MAXALIGN(add_size(offsetof(RecoveryWorkerCtlData, slots),
+							 mul_size(recovery_workers,
+									  sizeof(RecoveryWorkerSlot))));
+}
+
+/*
+ * RecoveryWorkerShmemSize
+ *		Compute space needed for recovery worker shared memory
+ */
+Size
+RecoveryWorkerShmemSize(void)
+{
+	return add_size(RecoveryWorkerCtlSize(),
+					mul_size(recovery_workers, RECOVERY_WORKER_QUEUE_SIZE));
+}
+
+/*
+ * RecoveryWorkerShmemInit
+ *		Allocate and initialize recovery worker shared memory
+ */
+void
+RecoveryWorkerShmemInit(void)
+{
+	bool		found;
+
+	RecoveryWorkerCtl = (RecoveryWorkerCtlData *)
+		ShmemInitStruct("Recovery Worker Data",
+						RecoveryWorkerShmemSize(),
+						&found);
+	RecoveryWorkerQueues = (char *) RecoveryWorkerCtl + RecoveryWorkerCtlSize();
+
+	if (!found)
+	{
+		int			i;
+
+		MemSet(RecoveryWorkerCtl, 0, RecoveryWorkerCtlSize());
+		for (i = 0; i < recovery_workers; i++)
+			SpinLockInit(&RecoveryWorkerCtl->slots[i].mutex);
+	}
+}
+
+/*
+ * RecoveryWorkerMain
+ *		Main entry point for a recovery worker process.
+ */
+void
+RecoveryWorkerMain(Datum main_arg)
+{
+	int			slotno = DatumGetInt32(main_arg);
+	char	   *queue;
+	XLogReaderState *reader;
+	MemoryContext redo_context;
+	uint64		close_generation;
+
+	pqsignal(SIGHUP, recoveryworker_sighup);
+	pqsignal(SIGTERM, die);
+	BackgroundWorkerUnblockSignals();
+
+	/* Nothing to do once recovery is over, so leave for good */
+	if (!RecoveryInProgress())
+		proc_exit(0);
+
+	Assert(slotno >= 0 && slotno < recovery_workers);
+	MySlot = &RecoveryWorkerCtl->slots[slotno];
+	queue = RecoveryWorkerQueue(slotno);
+
+	SpinLockAcquire(&MySlot->mutex);
+	if (MySlot->pid != 0)
+	{
+		SpinLockRelease(&MySlot->mutex);
+		elog(ERROR, "recovery worker slot %d is already in use by PID %d",
+			 slotno, (int) MySlot->pid);
+	}
+	MySlot->pid = MyProcPid;
+	MySlot->latch = MyLatch;
+	close_generation = RecoveryWorkerCtl->closeGeneration;
+	SpinLockRelease(&MySlot->mutex);
+
+	/*
+	 * Registered before InitBufferPoolBackend()'s callback, so that buffers
+	 * are released before the startup process can take over our records.
+	 */
+	on_shmem_exit(recoveryworker_detach, (Datum) 0);
+
+	InitBufferPoolBackend();
+	CurrentResourceOwner = ResourceOwnerCreate(NULL, "Recovery Worker");
+
+	/*
+	 * Replay like the startup process does.  We're only handed records once
+	 * it has reached consistency, so references to missing pages are errors.
+	 */
+	AmRecoveryWorker = true;
+	InRecovery = true;
+	reachedConsistency = true;
+
+	reader = XLogReaderAllocate(wal_segment_size, NULL, NULL);
+	if (!reader)
+		ereport(ERROR,
+				(errcode(ERRCODE_OUT_OF_MEMORY),
+				 errmsg("out of memory"),
+				 errdetail("Failed while allocating a WAL reading processor.")));
+	redo_context = AllocSetContextCreate(TopMemoryContext,
+										 "Recovery Worker Redo",
+										 ALLOCSET_DEFAULT_SIZES);
+
+	for (;;)
+	{
+		uint64		pos;
+		uint64		end;
+		bool		close_all;
+
+		CHECK_FOR_INTERRUPTS();
+
+		if (got_SIGHUP)
+		{
+			got_SIGHUP = false;
+			ProcessConfigFile(PGC_SIGHUP);
+		}
+
+		SpinLockAcquire(&MySlot->mutex);
+		pos = MySlot->apply_pos;
+		end = MySlot->insert_pos;
+		MySlot->sleeping = (pos == end);
+		close_all = (RecoveryWorkerCtl->closeGeneration != close_generation);
+		close_generation = RecoveryWorkerCtl->closeGeneration;
+		SpinLockRelease(&MySlot->mutex);
+
+		/* Relations may have been dropped since we last replayed anything */
+		if (close_all)
+			smgrcloseall();
+
+		if (pos == end)
+		{
+			int			rc;
+
+			rc = WaitLatch(MyLatch,
+						   WL_LATCH_SET | WL_TIMEOUT | WL_EXIT_ON_PM_DEATH,
+						   RECOVERY_WORKER_IDLE_TIMEOUT,
+						   WAIT_EVENT_RECOVERY_WORKER_MAIN);
+			ResetLatch(MyLatch);
+
+			if (rc & WL_TIMEOUT)
+			{
+				smgrcloseall();
+				if (!RecoveryInProgress())
+					proc_exit(0);
+			}
+			continue;
+		}
+
+		while (pos < end)
+		{
+			bool		wake;
+
+			pos = RecoveryWorkerReplay(queue, pos, reader, redo_context);
+
+			SpinLockAcquire(&MySlot->mutex);
+			MySlot->apply_pos = pos;
+			wake = MySlot->waiting;
+			MySlot->waiting = false;
+			SpinLockRelease(&MySlot->mutex);
+
+			if (wake)
+				SetLatch(RecoveryWorkerCtl->startupLatch);
+		}
+	}
+}
+
+/*
+ * RecoveryWorkerDispatch
+ *		Hand a record over to a recovery worker, if possible.
+ *
+ * Called by the startup process in place of the record's redo function.
+ * Returns true if the record was queued for a worker.  Otherwise, returns
+ * false once the workers have replayed all records queued so far, and the
+ * caller should replay the record itself.
+ */
+bool
+RecoveryWorkerDispatch(XLogReaderState *record)
+{
+	if (recovery_workers == 0)
+		return false;
+
+	if (reachedConsistency && RecoveryWorkerCanReplay(record))
+	{
+		RelFileNode rnode;
+		ForkNumber	forknum;
+		BlockNumber blkno;
+		uint32		hash;
+
+		(void) XLogRecGetBlockTag(record, 0, &rnode, &forknum, &blkno);
+		hash = hash_combine(DatumGetUInt32(hash_uint32(rnode.relNode)),
+							DatumGetUInt32(hash_uint32(blkno)));
+
+		if (RecoveryWorkerEnqueue(hash % recovery_workers, record))
+			return true;
+	}
+
+	RecoveryWorkerWaitAll();
+
+	/*
+	 * The workers are idle now, so they'll see this before replaying any
+	 * records that follow.
+	 */
+	if (RecoveryWorkerDropsFiles(record))
+		RecoveryWorkerCtl->closeGeneration++;
+
+	return false;
+}
+
+/*
+ * RecoveryWorkerWaitAll
+ *		Wait for the recovery workers to replay all records queued so far.
+ *
+ * Records queued for a worker that's gone are replayed by the caller.
+ */
+void
+RecoveryWorkerWaitAll(void)
+{
+	int			i;
+
+	if (!records_queued)
+		return;
+
+	for (i = 0; i < recovery_workers; i++)
+	{
+		RecoveryWorkerSlot *slot = &RecoveryWorkerCtl->slots[i];
+
+		for (;;)
+		{
+			bool		done;
+
+			SpinLockAcquire(&slot->mutex);
+			done = (slot->apply_pos == slot->insert_pos);
+			if (!done)
+				slot->waiting = true;
+			SpinLockRelease(&slot->mutex);
+
+			if (done || RecoveryWorkerTakeOver(i))
+				break;
+
+			(void) WaitLatch(MyLatch,
+							 WL_LATCH_SET | WL_TIMEOUT | WL_EXIT_ON_PM_DEATH,
+							 10, WAIT_EVENT_RECOVERY_WORKER_QUEUE);
+			ResetLatch(MyLatch);
+
+			HandleStartupProcInterrupts();
+		}
+	}
+
+	records_queued = false;
+}
+
+/*
+ * Can a worker replay this record on its own?
+ *
+ * It must touch a single block, through redo code that doesn't look at
+ * anything but that block and related visibility map and free space map
+ * pages, and doesn't need to resolve conflicts with hot standby queries.
+ */
+static bool
+RecoveryWorkerCanReplay(XLogReaderState *record)
+{
+	uint8		info = XLogRecGetInfo(record) & ~XLR_INFO_MASK;
+
+	if (record->max_block_id != 0)
+		return false;
+
+	/* consistency checks need the startup process's view of the page */
+	if ((XLogRecGetInfo(record) & XLR_CHECK_CONSISTENCY) != 0)
+		return false;
+
+	switch (XLogRecGetRmid(record))
+	{
+		case RM_HEAP_ID:
+			switch (info & XLOG_HEAP_OPMASK)
+			{
+				case XLOG_HEAP_INSERT:
+				case XLOG_HEAP_DELETE:
+				case XLOG_HEAP_UPDATE:
+				case XLOG_HEAP_HOT_UPDATE:
+				case XLOG_HEAP_CONFIRM:
+				case XLOG_HEAP_LOCK:
+				case XLOG_HEAP_INPLACE:
+					return true;
+			}
+			break;
+		case RM_HEAP2_ID:
+			switch (info & XLOG_HEAP_OPMASK)
+			{
+				case XLOG_HEAP2_MULTI_INSERT:
+				case XLOG_HEAP2_LOCK_UPDATED:
+					return true;
+			}
+			break;
+		case RM_BTREE_ID:
+			if (info == XLOG_BTREE_INSERT_LEAF)
+				return true;
+			break;
+	}
+
+	return false;
+}
+
+/*
+ * Can replaying this record drop or truncate relations?
+ */
+static bool
+RecoveryWorkerDropsFiles(XLogReaderState *record)
+{
+	uint8		info = XLogRecGetInfo(record) & ~XLR_INFO_MASK;
+
+	switch (XLogRecGetRmid(record))
+	{
+		case RM_SMGR_ID:
+		case RM_DBASE_ID:
+		case RM_TBLSPC_ID:
+			return true;
+		case RM_XACT_ID:
+			switch (info & XLOG_XACT_OPMASK)
+			{
+				case XLOG_XACT_COMMIT:
+				case XLOG_XACT_COMMIT_PREPARED:
+				case XLOG_XACT_ABORT:
+				case XLOG_XACT_ABORT_PREPARED:
+					if (info & XLOG_XACT_HAS_INFO)
+					{
+						xl_xact_xinfo xl_xinfo;
+
+						/* abort records start the same way */
+						memcpy(&xl_xinfo,
+							   XLogRecGetData(record) + MinSizeOfXactCommit,
+							   sizeof(xl_xinfo));
+						return (xl_xinfo.xinfo & XACT_XINFO_HAS_RELFILENODES) != 0;
+					}
+					break;
+			}
+			break;
+	}
+
+	return false;
+}
+
+/*
+ * Append a record to a worker's queue, waiting for room if necessary.
+ *
+ * Returns false if the record is too large, or if no worker is attached to
+ * the slot; in the latter case, any records left in the queue have been
+ * replayed.
+ */
+static bool
+RecoveryWorkerEnqueue(int worker, XLogReaderState *record)
+{
+	RecoveryWorkerSlot *slot = &RecoveryWorkerCtl->slots[worker];
+	char	   *queue = RecoveryWorkerQueue(worker);
+	uint32		reclen = record->decoded_record->xl_tot_len;
+	uint32		size = RECOVERY_WORKER_ENTRY_HDRSZ + MAXALIGN(reclen);
+	RecoveryWorkerEntry *entry;
+	uint64		insert_pos;
+	Size		offset;
+	Size		needed;
+	Latch	   *latch;
+
+	if (size > RECOVERY_WORKER_MAX_ENTRY)
+		return false;
+
+	RecoveryWorkerCtl->startupLatch = MyLatch;
+
+	for (;;)
+	{
+		bool		attached;
+		bool		fits;
+
+		SpinLockAcquire(&slot->mutex);
+		attached = (slot->pid != 0);
+		insert_pos = slot->insert_pos;
+		offset = insert_pos % RECOVERY_WORKER_QUEUE_SIZE;
+		needed = size;
+		if (RECOVERY_WORKER_QUEUE_SIZE - offset < size)
+			needed += RECOVERY_WORKER_QUEUE_SIZE - offset;
+		fits = (RECOVERY_WORKER_QUEUE_SIZE -
+				(insert_pos - slot->apply_pos) >= needed);
+		if (attached && !fits)
+			slot->waiting = true;
+		SpinLockRelease(&slot->mutex);
+
+		if (!attached)
+		{
+			(void) RecoveryWorkerTakeOver(worker);
+			return false;
+		}
+		if (fits)
+			break;
+
+		(void) WaitLatch(MyLatch,
+						 WL_LATCH_SET | WL_TIMEOUT | WL_EXIT_ON_PM_DEATH,
+						 10, WAIT_EVENT_RECOVERY_WORKER_QUEUE);
+		ResetLatch(MyLatch);
+
+		HandleStartupProcInterrupts();
+	}
+
+	/* The space up to needed bytes past insert_pos is ours to fill */
+	if (needed != size)
+	{
+		((RecoveryWorkerEntry *) (queue + offset))->size = 0;
+		offset = 0;
+	}
+	entry = (RecoveryWorkerEntry *) (queue + offset);
+	entry->size = size;
+	entry->ReadRecPtr = record->ReadRecPtr;
+	entry->EndRecPtr = record->EndRecPtr;
+	memcpy((char *) entry + RECOVERY_WORKER_ENTRY_HDRSZ,
+		   record->decoded_record, reclen);
+
+	SpinLockAcquire(&slot->mutex);
+	slot->insert_pos += needed;
+	latch = slot->sleeping ? slot->latch : NULL;
+	slot->sleeping = false;
+	SpinLockRelease(&slot->mutex);
+
+	if (latch)
+		SetLatch(latch);
+
+	records_queued = true;
+
+	return true;
+}
+
+/*
+ * If no worker is attached to a slot, replay the records left in its queue.
+ *
+ * Returns false if a worker is attached.  The records are claimed before
+ * they're replayed, so that a worker attaching meanwhile won't see them.
+ */
+static bool
+RecoveryWorkerTakeOver(int worker)
+{
+	RecoveryWorkerSlot *slot = &RecoveryWorkerCtl->slots[worker];
+	uint64		pos;
+	uint64		end;
+	MemoryContext redo_context;
+
+	SpinLockAcquire(&slot->mutex);
+	if (slot->pid != 0)
+	{
+		SpinLockRelease(&slot->mutex);
+		return false;
+	}
+	pos = slot->apply_pos;
+	end = slot->insert_pos;
+	slot->apply_pos = end;
+	SpinLockRelease(&slot->mutex);
+
+	if (pos == end)
+		return true;
+
+	if (leftover_reader == NULL)
+	{
+		leftover_reader = XLogReaderAllocate(wal_segment_size, NULL, NULL);
+		if (!leftover_reader)
+			ereport(ERROR,
+					(errcode(ERRCODE_OUT_OF_MEMORY),
+					 errmsg("out of memory"),
+					 errdetail("Failed while allocating a WAL reading processor.")));
+	}
+
+	redo_context = AllocSetContextCreate(CurrentMemoryContext,
+										 "Recovery Worker Redo",
+										 ALLOCSET_DEFAULT_SIZES);
+	while (pos < end)
+		pos = RecoveryWorkerReplay(RecoveryWorkerQueue(worker), pos,
+								   leftover_reader, redo_context);
+	MemoryContextDelete(redo_context);
+
+	return true;
+}
+
+/*
+ * Replay the queue entry at 'pos', and return the position of the next one.
+ */
+static uint64
+RecoveryWorkerReplay(char *queue, uint64 pos, XLogReaderState *reader,
+					 MemoryContext redo_context)
+{
+	Size		offset = pos % RECOVERY_WORKER_QUEUE_SIZE;
+	RecoveryWorkerEntry *entry = (RecoveryWorkerEntry *) (queue + offset);
+	XLogRecord *record;
+	ErrorContextCallback errcallback;
+	MemoryContext oldcontext;
+	char	   *errormsg;
+
+	/* skip the unused end of the queue */
+	if (entry->size == 0)
+		return pos + RECOVERY_WORKER_QUEUE_SIZE - offset;
+
+	record = (XLogRecord *) ((char *) entry + RECOVERY_WORKER_ENTRY_HDRSZ);
+	reader->ReadRecPtr = entry->ReadRecPtr;
+	reader->EndRecPtr = entry->EndRecPtr;
+	if (!DecodeXLogRecord(reader, record, &errormsg))
+		elog(ERROR, "could not decode WAL record at %X/%X: %s",
+			 (uint32) (entry->ReadRecPtr >> 32), (uint32) entry->ReadRecPtr,
+			 errormsg);
+
+	/* Setup error traceback support for ereport() */
+	errcallback.callback = recoveryworker_error_callback;
+	errcallback.arg = (void *) reader;
+	errcallback.previous = error_context_stack;
+	error_context_stack = &errcallback;
+
+	oldcontext = MemoryContextSwitchTo(redo_context);
+	RmgrTable[record->xl_rmid].rm_redo(reader);
+	MemoryContextSwitchTo(oldcontext);
+	MemoryContextReset(redo_context);
+
+	error_context_stack = errcallback.previous;
+
+	return pos + entry->size;
+}
+
+/*
+ * Error context callback for replaying a queued record.
+ */
+static void
+recoveryworker_error_callback(void *arg)
+{
+	XLogReaderState *record = (XLogReaderState *) arg;
+
+	errcontext("WAL redo at %X/%X for %s",
+			   (uint32) (record->ReadRecPtr >> 32),
+			   (uint32) record->ReadRecPtr,
+			   RmgrTable[XLogRecGetRmid(record)].rm_name);
+}
+
+/*
+ * Release our slot at process exit.  Any records we didn't replay stay in
+ * the queue, for the startup process or our successor to replay.
+ */
+static void
+recoveryworker_detach(int code, Datum arg)
+{
+	SpinLockAcquire(&MySlot->mutex);
+	MySlot->pid = 0;
+	MySlot->latch = NULL;
+	MySlot->sleeping = false;
+	SpinLockRelease(&MySlot->mutex);
+
+	if (RecoveryWorkerCtl->startupLatch)
+		SetLatch(RecoveryWorkerCtl->startupLatch);
+}
+
+/* SIGHUP: set flag to re-read config file at next convenient time */
+static void
+recoveryworker_sighup(SIGNAL_ARGS)
+{
+	int			save_errno = errno;
+
+	got_SIGHUP = true;
+	SetLatch(MyLatch);
+
+	errno = save_errno;
+}
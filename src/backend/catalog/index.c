@@ -51,6 +51,7 @@
 #include "catalog/storage.h"
 #include "commands/tablecmds.h"
 #include "commands/event_trigger.h"
+#include "commands/progress.h"
 #include "commands/trigger.h"
 #include "executor/executor.h"
 #include "miscadmin.h"
@@ -59,6 +60,7 @@
 #include "optimizer/clauses.h"
 #include "optimizer/planner.h"
 #include "parser/parser.h"
+#include "pgstat.h"
 #include "rewrite/rewriteManip.h"
 #include "storage/bufmgr.h"
 #include "storage/lmgr.h"
@@ -81,10 +83,20 @@
 /* Potentially set by pg_upgrade_support functions */
 Oid			binary_upgrade_next_index_pg_class_oid = InvalidOid;
 
+/*
+ * validate_index skips runs of all-visible heap pages only if they are at
+ * least this long, so as not to defeat OS readahead with lots of short
+ * jumps.
+ */
+#define VALIDATE_SKIP_PAGES_THRESHOLD	((BlockNumber) 32)
+
 /* state info for validate_index bulkdelete callback */
 typedef struct
 {
 	Tuplesortstate *tuplesort;	/* for sorting the index TIDs */
+	uint8	   *skip_blocks;	/* bitmap of heap blocks known to be fully
+								 * indexed, or NULL if there are none */
+	BlockNumber skip_nblocks;	/* number of blocks covered by skip_blocks */
 	/* statistics (for debug purposes only): */
 	double		htups,
 				itups,
@@ -134,6 +146,8 @@ static void IndexCheckExclusion(Relation heapRelation,
 static inline int64 itemptr_encode(ItemPointer itemptr);
 static inline void itemptr_decode(ItemPointer itemptr, int64 encoded);
 static bool validate_index_callback(ItemPointer itemptr, void *opaque);
+static void validate_index_skip_blocks(Relation heapRelation,
+						   v_i_state *state);
 static void validate_index_heapscan(Relation heapRelation,
 						Relation indexRelation,
 						IndexInfo *indexInfo,
@@ -909,6 +923,7 @@ index_create(Relation heapRelation,
 								tableSpaceId,
 								indexRelationId,
 								relFileNode,
+								accessMethodObjectId,
 								indexTupDesc,
 								relkind,
 								relpersistence,
@@ -932,7 +947,6 @@ index_create(Relation heapRelation,
 	 * XXX should have a cleaner way to create cataloged indexes
 	 */
 	indexRelation->rd_rel->relowner = heapRelation->rd_rel->relowner;
-	indexRelation->rd_rel->relam = accessMethodObjectId;
 	indexRelation->rd_rel->relispartition = OidIsValid(parentIndexRelid);
 
 	/*
@@ -1793,6 +1807,7 @@ BuildIndexInfo(Relation index)
 	/* other info */
 	ii->ii_Unique = indexStruct->indisunique;
 	ii->ii_ReadyForInserts = indexStruct->indisready;
+	ii->ii_Summarizing = index->rd_amroutine->amsummarizing;
 	/* assume not doing speculative insertion for now */
 	ii->ii_UniqueOps = NULL;
 	ii->ii_UniqueProcs = NULL;
@@ -2255,12 +2270,14 @@ index_build(Relation heapRelation,
 
 	/*
 	 * Determine worker process details for parallel CREATE INDEX.  Currently,
-	 * only btree has support for parallel builds.
+	 * only btree, gin and hash have support for parallel builds.
 	 *
 	 * Note that planner considers parallel safety for us.
 	 */
 	if (parallel && IsNormalProcessingMode() &&
-		indexRelation->rd_rel->relam == BTREE_AM_OID)
+		(indexRelation->rd_rel->relam == BTREE_AM_OID ||
+		 indexRelation->rd_rel->relam == GIN_AM_OID ||
+		 indexRelation->rd_rel->relam == HASH_AM_OID))
 		indexInfo->ii_ParallelWorkers =
 			plan_create_index_workers(RelationGetRelid(heapRelation),
 									  RelationGetRelid(indexRelation));
@@ -2289,6 +2306,23 @@ index_build(Relation heapRelation,
 						   save_sec_context | SECURITY_RESTRICTED_OPERATION);
 	save_nestlevel = NewGUCNestLevel();
 
+	/*
+	 * Clear the progress counters of any previous index build in this
+	 * command, such as for another index of the same table.
+	 */
+	{
+		const int	index[] = {
+			PROGRESS_CREATEIDX_SUBPHASE,
+			PROGRESS_CREATEIDX_TUPLES_TOTAL,
+			PROGRESS_CREATEIDX_TUPLES_DONE,
+			PROGRESS_CREATEIDX_BLOCKS_TOTAL,
+			PROGRESS_CREATEIDX_BLOCKS_DONE
+		};
+		const int64 val[] = {0, 0, 0, 0, 0};
+
+		pgstat_progress_update_multi_param(5, index, val);
+	}
+
 	/*
 	 * Call the access method's build procedure
 	 */
@@ -2473,6 +2507,7 @@ IndexBuildHeapRangeScan(Relation heapRelation,
 	bool		need_unregister_snapshot = false;
 	TransactionId OldestXmin;
 	BlockNumber root_blkno = InvalidBlockNumber;
+	BlockNumber nblocks;
 	OffsetNumber root_offsets[MaxHeapTuplesPerPage];
 
 	/*
@@ -2555,7 +2590,7 @@ IndexBuildHeapRangeScan(Relation heapRelation,
 		 */
 		Assert(!IsBootstrapProcessingMode());
 		Assert(allow_sync);
-		snapshot = scan->rs_snapshot;
+		snapshot = scan->rs_base.rs_snapshot;
 	}
 
 	/*
@@ -2579,6 +2614,26 @@ IndexBuildHeapRangeScan(Relation heapRelation,
 		Assert(numblocks == InvalidBlockNumber);
 	}
 
+	/* Report the number of blocks we are going to scan */
+	if (scan->rs_parallel != NULL)
+		nblocks = scan->rs_parallel->phs_nblocks;
+	else if (scan->rs_numblocks != InvalidBlockNumber)
+		nblocks = scan->rs_numblocks;
+	else
+		nblocks = scan->rs_nblocks;
+	{
+		const int	index[] = {
+			PROGRESS_CREATEIDX_SUBPHASE,
+			PROGRESS_CREATEIDX_BLOCKS_TOTAL
+		};
+		const int64 val[] = {
+			PROGRESS_CREATEIDX_SUBPHASE_SCAN_TABLE,
+			nblocks
+		};
+
+		pgstat_progress_update_multi_param(2, index, val);
+	}
+
 	reltuples = 0;
 
 	/*
@@ -2618,12 +2673,27 @@ IndexBuildHeapRangeScan(Relation heapRelation,
 		if (scan->rs_cblock != root_blkno)
 		{
 			Page		page = BufferGetPage(scan->rs_cbuf);
+			uint64		blocks_done;
 
 			LockBuffer(scan->rs_cbuf, BUFFER_LOCK_SHARE);
 			heap_get_root_tuples(page, root_offsets);
 			LockBuffer(scan->rs_cbuf, BUFFER_LOCK_UNLOCK);
 
 			root_blkno = scan->rs_cblock;
+
+			/*
+			 * Report scan progress.  In a parallel scan, count the blocks
+			 * handed out to all participants; otherwise, a synchronized scan
+			 * may not have started at the first block.
+			 */
+			if (scan->rs_parallel != NULL)
+				blocks_done =
+					pg_atomic_read_u64(&scan->rs_parallel->phs_nallocated);
+			else
+				blocks_done = (root_blkno + scan->rs_nblocks -
+							   scan->rs_startblock) % scan->rs_nblocks + 1;
+			pgstat_progress_update_param(PROGRESS_CREATEIDX_BLOCKS_DONE,
+										 Min(blocks_done, nblocks));
 		}
 
 		if (snapshot == SnapshotAny)
@@ -3114,6 +3184,16 @@ IndexCheckExclusion(Relation heapRelation,
  * not index).  Then we mark the index "indisvalid" and commit.  Subsequent
  * transactions will be able to use it for queries.
  *
+ * We need not look at heap pages that are all-visible by the time we get
+ * here.  Only VACUUM sets visibility map bits, and it is locked out by the
+ * ShareUpdateExclusiveLock we've held since before the initial build; so
+ * such a page has been all-visible and unmodified since before that build
+ * started, and all its tuples were indexed then.  Changes made to it from
+ * now on come from transactions that insert their own index entries.  We
+ * leave out both the index TIDs and the heap scan for (long enough runs of)
+ * those pages, which keeps the sort and the second scan short for mostly
+ * static tables.
+ *
  * Doing two full table scans is a brute-force strategy.  We could try to be
  * cleverer, eg storing new tuples in a special area of the table (perhaps
  * making the table append-only by setting use_fsm).  However that would
@@ -3178,6 +3258,9 @@ validate_index(Oid heapId, Oid indexId, Snapshot snapshot)
 											NULL, false);
 	state.htups = state.itups = state.tups_inserted = 0;
 
+	/* Decide which heap blocks we can skip, before looking at the index */
+	validate_index_skip_blocks(heapRelation, &state);
+
 	(void) index_bulk_delete(&ivinfo, NULL,
 							 validate_index_callback, (void *) &state);
 
@@ -3195,6 +3278,8 @@ validate_index(Oid heapId, Oid indexId, Snapshot snapshot)
 
 	/* Done with tuplesort object */
 	tuplesort_end(state.tuplesort);
+	if (state.skip_blocks)
+		pfree(state.skip_blocks);
 
 	elog(DEBUG2,
 		 "validate_index found %.0f heap tuples, %.0f index tuples; inserted %.0f missing tuples",
@@ -3251,6 +3336,75 @@ itemptr_decode(ItemPointer itemptr, int64 encoded)
 	ItemPointerSet(itemptr, block, offset);
 }
 
+/*
+ * validate_index_block_skipped - does validate_index skip this heap block?
+ */
+static inline bool
+validate_index_block_skipped(v_i_state *state, BlockNumber blkno)
+{
+	return state->skip_blocks != NULL && blkno < state->skip_nblocks &&
+		(state->skip_blocks[blkno / BITS_PER_BYTE] &
+		 (1 << (blkno % BITS_PER_BYTE))) != 0;
+}
+
+/*
+ * validate_index_skip_blocks - find the heap blocks validate_index can skip
+ *
+ * These are the runs of at least VALIDATE_SKIP_PAGES_THRESHOLD pages that
+ * the visibility map says are all-visible; see validate_index.  We look the
+ * blocks up once and remember the result, because the index TIDs we leave
+ * out of the sort must be exactly those of the blocks we don't scan.
+ */
+static void
+validate_index_skip_blocks(Relation heapRelation, v_i_state *state)
+{
+	BlockNumber nblocks = RelationGetNumberOfBlocks(heapRelation);
+	BlockNumber blkno;
+	BlockNumber run_start = 0;
+	Buffer		vmbuffer = InvalidBuffer;
+	bool		any_skipped = false;
+
+	state->skip_blocks = NULL;
+	state->skip_nblocks = 0;
+	if (nblocks < VALIDATE_SKIP_PAGES_THRESHOLD)
+		return;
+
+	state->skip_blocks = (uint8 *)
+		palloc_extended(nblocks / BITS_PER_BYTE + 1,
+						MCXT_ALLOC_HUGE | MCXT_ALLOC_ZERO);
+	state->skip_nblocks = nblocks;
+
+	for (blkno = 0; blkno <= nblocks; blkno++)
+	{
+		CHECK_FOR_INTERRUPTS();
+
+		if (blkno < nblocks &&
+			VM_ALL_VISIBLE(heapRelation, blkno, &vmbuffer))
+			continue;
+
+		/* blkno ends a run of all-visible blocks; remember it if long */
+		if (blkno - run_start >= VALIDATE_SKIP_PAGES_THRESHOLD)
+		{
+			BlockNumber b;
+
+			for (b = run_start; b < blkno; b++)
+				state->skip_blocks[b / BITS_PER_BYTE] |= 1 << (b % BITS_PER_BYTE);
+			any_skipped = true;
+		}
+		run_start = blkno + 1;
+	}
+
+	if (BufferIsValid(vmbuffer))
+		ReleaseBuffer(vmbuffer);
+
+	if (!any_skipped)
+	{
+		pfree(state->skip_blocks);
+		state->skip_blocks = NULL;
+		state->skip_nblocks = 0;
+	}
+}
+
 /*
  * validate_index_callback - bulkdelete callback to collect the index TIDs
  */
@@ -3258,13 +3412,56 @@ static bool
 validate_index_callback(ItemPointer itemptr, void *opaque)
 {
 	v_i_state  *state = (v_i_state *) opaque;
-	int64		encoded = itemptr_encode(itemptr);
+	int64		encoded;
+
+	/* The heap scan won't look at this block, so don't bother sorting it */
+	if (validate_index_block_skipped(state, ItemPointerGetBlockNumber(itemptr)))
+		return false;
 
+	encoded = itemptr_encode(itemptr);
 	tuplesort_putdatum(state->tuplesort, Int64GetDatum(encoded), false);
 	state->itups += 1;
 	return false;				/* never actually delete anything */
 }
 
+/*
+ * validate_index_getnext - get the next tuple for validate_index_heapscan
+ *
+ * When some blocks are skipped, the scan is limited to one range of blocks
+ * not to be skipped at a time; *run_end is the end of the current range.
+ * Once a range is exhausted, restart the scan on the next one.
+ */
+static HeapTuple
+validate_index_getnext(HeapScanDesc scan, v_i_state *state,
+					   BlockNumber *run_end)
+{
+	HeapTuple	heapTuple;
+
+	while ((heapTuple = heap_getnext(scan, ForwardScanDirection)) == NULL)
+	{
+		BlockNumber start = *run_end;
+		BlockNumber end;
+
+		if (state->skip_blocks == NULL)
+			break;
+
+		while (validate_index_block_skipped(state, start))
+			start++;
+		if (start >= scan->rs_nblocks)
+			break;
+		end = start + 1;
+		while (end < scan->rs_nblocks &&
+			   !validate_index_block_skipped(state, end))
+			end++;
+
+		heap_rescan(scan, NULL);
+		heap_setscanlimits(scan, start, end - start);
+		*run_end = end;
+	}
+
+	return heapTuple;
+}
+
 /*
  * validate_index_heapscan - second table scan for concurrent index build
  *
@@ -3294,6 +3491,7 @@ validate_index_heapscan(Relation heapRelation,
 	ItemPointer indexcursor = NULL;
 	ItemPointerData decoded;
 	bool		tuplesort_empty = false;
+	BlockNumber run_end = 0;
 
 	/*
 	 * sanity checks
@@ -3328,10 +3526,17 @@ validate_index_heapscan(Relation heapRelation,
 								true,	/* buffer access strategy OK */
 								false); /* syncscan not OK */
 
+	/*
+	 * If some blocks can be skipped, start out with an empty range, and let
+	 * validate_index_getnext move on to each range of blocks to scan.
+	 */
+	if (state->skip_blocks != NULL)
+		heap_setscanlimits(scan, 0, 0);
+
 	/*
 	 * Scan all tuples matching the snapshot.
 	 */
-	while ((heapTuple = heap_getnext(scan, ForwardScanDirection)) != NULL)
+	while ((heapTuple = validate_index_getnext(scan, state, &run_end)) != NULL)
 	{
 		ItemPointer heapcursor = &heapTuple->t_self;
 		ItemPointerData rootTuple;
@@ -3909,6 +4114,7 @@ reindex_relation(Oid relid, int flags, int options)
 		List	   *doneIndexes;
 		ListCell   *indexId;
 		char		persistence;
+		int64		nrebuilt = 0;
 
 		if (flags & REINDEX_REL_SUPPRESS_INDEX_USE)
 		{
@@ -3947,6 +4153,10 @@ reindex_relation(Oid relid, int flags, int options)
 
 			CommandCounterIncrement();
 
+			/* Report progress, for CLUSTER's sake */
+			pgstat_progress_update_param(PROGRESS_CLUSTER_INDEX_REBUILD_COUNT,
+										 ++nrebuilt);
+
 			/* Index should no longer be in the pending list */
 			Assert(!ReindexIsProcessingIndex(indexOid));
 
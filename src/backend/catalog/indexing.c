@@ -65,11 +65,14 @@ CatalogCloseIndexes(CatalogIndexState indstate)
  * CatalogIndexInsert - insert index entries for one catalog tuple
  *
  * This should be called for each inserted or updated catalog tuple.
+ * updateIndexes says which indexes need new entries, as reported by
+ * simple_heap_update; inserts always pass TU_All.
  *
  * This is effectively a cut-down version of ExecInsertIndexTuples.
  */
 static void
-CatalogIndexInsert(CatalogIndexState indstate, HeapTuple heapTuple)
+CatalogIndexInsert(CatalogIndexState indstate, HeapTuple heapTuple,
+				   TU_UpdateIndexes updateIndexes)
 {
 	int			i;
 	int			numIndexes;
@@ -81,7 +84,7 @@ CatalogIndexInsert(CatalogIndexState indstate, HeapTuple heapTuple)
 	bool		isnull[INDEX_MAX_KEYS];
 
 	/* HOT update does not require index inserts */
-	if (HeapTupleIsHeapOnly(heapTuple))
+	if (updateIndexes == TU_None)
 		return;
 
 	/*
@@ -112,6 +115,10 @@ CatalogIndexInsert(CatalogIndexState indstate, HeapTuple heapTuple)
 		if (!indexInfo->ii_ReadyForInserts)
 			continue;
 
+		/* After a HOT update, only summarizing indexes need new entries */
+		if (updateIndexes == TU_Summarizing && !indexInfo->ii_Summarizing)
+			continue;
+
 		/*
 		 * Expressional and partial indexes on system catalogs are not
 		 * supported, nor exclusion constraints, nor deferred uniqueness
@@ -169,7 +176,7 @@ CatalogTupleInsert(Relation heapRel, HeapTuple tup)
 
 	simple_heap_insert(heapRel, tup);
 
-	CatalogIndexInsert(indstate, tup);
+	CatalogIndexInsert(indstate, tup, TU_All);
 	CatalogCloseIndexes(indstate);
 }
 
@@ -187,7 +194,7 @@ CatalogTupleInsertWithInfo(Relation heapRel, HeapTuple tup,
 {
 	simple_heap_insert(heapRel, tup);
 
-	CatalogIndexInsert(indstate, tup);
+	CatalogIndexInsert(indstate, tup, TU_All);
 }
 
 /*
@@ -205,12 +212,13 @@ void
 CatalogTupleUpdate(Relation heapRel, ItemPointer otid, HeapTuple tup)
 {
 	CatalogIndexState indstate;
+	TU_UpdateIndexes updateIndexes;
 
 	indstate = CatalogOpenIndexes(heapRel);
 
-	simple_heap_update(heapRel, otid, tup);
+	simple_heap_update(heapRel, otid, tup, &updateIndexes);
 
-	CatalogIndexInsert(indstate, tup);
+	CatalogIndexInsert(indstate, tup, updateIndexes);
 	CatalogCloseIndexes(indstate);
 }
 
@@ -226,9 +234,11 @@ void
 CatalogTupleUpdateWithInfo(Relation heapRel, ItemPointer otid, HeapTuple tup,
 						   CatalogIndexState indstate)
 {
-	simple_heap_update(heapRel, otid, tup);
+	TU_UpdateIndexes updateIndexes;
+
+	simple_heap_update(heapRel, otid, tup, &updateIndexes);
 
-	CatalogIndexInsert(indstate, tup);
+	CatalogIndexInsert(indstate, tup, updateIndexes);
 }
 
 /*
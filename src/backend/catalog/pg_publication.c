@@ -21,6 +21,7 @@
 #include "access/hash.h"
 #include "access/heapam.h"
 #include "access/htup_details.h"
+#include "access/sysattr.h"
 #include "access/xact.h"
 
 #include "catalog/catalog.h"
@@ -34,6 +35,8 @@
 #include "catalog/pg_publication.h"
 #include "catalog/pg_publication_rel.h"
 
+#include "optimizer/var.h"
+
 #include "utils/array.h"
 #include "utils/builtins.h"
 #include "utils/catcache.h"
@@ -138,20 +141,172 @@ pg_relation_is_publishable(PG_FUNCTION_ARGS)
 }
 
 
+/*
+ * Translate a publication column list into an int2vector of attribute
+ * numbers, in attribute number order.  The numbers are also returned as a
+ * bitmapset in *attrs.
+ */
+static int2vector *
+publication_translate_columns(Relation targetrel, List *columns,
+							  Bitmapset **attrs)
+{
+	int16	   *attarray;
+	ListCell   *lc;
+	int			n = 0;
+	int			attnum;
+
+	*attrs = NULL;
+	foreach(lc, columns)
+	{
+		char	   *colname = strVal(lfirst(lc));
+
+		attnum = get_attnum(RelationGetRelid(targetrel), colname);
+		if (attnum == InvalidAttrNumber)
+			ereport(ERROR,
+					(errcode(ERRCODE_UNDEFINED_COLUMN),
+					 errmsg("column \"%s\" of relation \"%s\" does not exist",
+							colname, RelationGetRelationName(targetrel))));
+
+		if (attnum < 0)
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_COLUMN_REFERENCE),
+					 errmsg("cannot use system column \"%s\" in publication column list",
+							colname)));
+
+		if (bms_is_member(attnum, *attrs))
+			ereport(ERROR,
+					(errcode(ERRCODE_DUPLICATE_OBJECT),
+					 errmsg("duplicate column \"%s\" in publication column list",
+							colname)));
+
+		*attrs = bms_add_member(*attrs, attnum);
+	}
+
+	attarray = palloc(sizeof(int16) * list_length(columns));
+	attnum = -1;
+	while ((attnum = bms_next_member(*attrs, attnum)) >= 0)
+		attarray[n++] = attnum;
+
+	return buildint2vector(attarray, n);
+}
+
+/*
+ * Check that the column list and row filter of a publication table still
+ * allow UPDATE and DELETE to be replicated, if the publication publishes
+ * them: the subscriber must receive the replica identity columns to find
+ * the target row, and the old tuple of a decoded change carries only the
+ * replica identity columns, so the row filter must not look at anything
+ * else.
+ *
+ * columns is a set of attribute numbers, or NULL for all columns.
+ */
+static void
+check_publication_rel_filters(Publication *pub, Relation targetrel,
+							  Bitmapset *columns, Node *qual)
+{
+	TupleDesc	desc = RelationGetDescr(targetrel);
+	Bitmapset  *idattrs = NULL;
+	bool		replidentfull;
+	int			i;
+
+	if (!pub->pubactions.pubupdate && !pub->pubactions.pubdelete)
+		return;
+
+	replidentfull =
+		(targetrel->rd_rel->relreplident == REPLICA_IDENTITY_FULL);
+	if (!replidentfull)
+		idattrs = RelationGetIndexAttrBitmap(targetrel,
+											 INDEX_ATTR_BITMAP_IDENTITY_KEY);
+
+	if (columns != NULL)
+	{
+		for (i = 0; i < desc->natts; i++)
+		{
+			Form_pg_attribute att = TupleDescAttr(desc, i);
+
+			if (att->attisdropped)
+				continue;
+
+			/* REPLICA IDENTITY FULL uses all columns as the key */
+			if (!replidentfull &&
+				!bms_is_member(att->attnum - FirstLowInvalidHeapAttributeNumber,
+							   idattrs))
+				continue;
+
+			if (!bms_is_member(att->attnum, columns))
+				ereport(ERROR,
+						(errcode(ERRCODE_INVALID_COLUMN_REFERENCE),
+						 errmsg("cannot use column list for relation \"%s\" in publication \"%s\"",
+								RelationGetRelationName(targetrel), pub->name),
+						 errdetail("The column list of a publication that publishes UPDATE or DELETE must include all replica identity columns.")));
+		}
+	}
+
+	if (qual != NULL && !replidentfull)
+	{
+		Bitmapset  *qualattrs = NULL;
+
+		pull_varattnos(qual, 1, &qualattrs);
+		if (!bms_is_subset(qualattrs, idattrs))
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_COLUMN_REFERENCE),
+					 errmsg("cannot use row filter for relation \"%s\" in publication \"%s\"",
+							RelationGetRelationName(targetrel), pub->name),
+					 errdetail("The row filter of a publication that publishes UPDATE or DELETE can only reference replica identity columns.")));
+	}
+
+	bms_free(idattrs);
+}
+
+/*
+ * Recheck the column lists and row filters of all tables of a publication,
+ * after its published actions changed.
+ */
+void
+publication_check_relation_filters(Oid pubid)
+{
+	Publication *pub = GetPublication(pubid);
+	List	   *relids;
+	ListCell   *lc;
+
+	/* FOR ALL TABLES publications have no filters */
+	if (pub->alltables)
+		return;
+
+	relids = GetPublicationRelations(pubid);
+	foreach(lc, relids)
+	{
+		Oid			relid = lfirst_oid(lc);
+		Bitmapset  *columns;
+		Node	   *qual;
+		Relation	targetrel;
+
+		GetPublicationRelationFilters(pubid, relid, &columns, &qual);
+		if (columns == NULL && qual == NULL)
+			continue;
+
+		targetrel = heap_open(relid, AccessShareLock);
+		check_publication_rel_filters(pub, targetrel, columns, qual);
+		heap_close(targetrel, AccessShareLock);
+	}
+}
+
 /*
  * Insert new publication / relation mapping.
  */
 ObjectAddress
-publication_add_relation(Oid pubid, Relation targetrel,
+publication_add_relation(Oid pubid, PublicationRelInfo *pri,
 						 bool if_not_exists)
 {
 	Relation	rel;
+	Relation	targetrel = pri->relation;
 	HeapTuple	tup;
 	Datum		values[Natts_pg_publication_rel];
 	bool		nulls[Natts_pg_publication_rel];
 	Oid			relid = RelationGetRelid(targetrel);
 	Oid			prrelid;
 	Publication *pub = GetPublication(pubid);
+	Bitmapset  *columns = NULL;
 	ObjectAddress myself,
 				referenced;
 
@@ -190,6 +345,22 @@ publication_add_relation(Oid pubid, Relation targetrel,
 	values[Anum_pg_publication_rel_prrelid - 1] =
 		ObjectIdGetDatum(relid);
 
+	if (pri->columns != NIL)
+		values[Anum_pg_publication_rel_prattrs - 1] =
+			PointerGetDatum(publication_translate_columns(targetrel,
+														  pri->columns,
+														  &columns));
+	else
+		nulls[Anum_pg_publication_rel_prattrs - 1] = true;
+
+	if (pri->whereClause != NULL)
+		values[Anum_pg_publication_rel_prqual - 1] =
+			CStringGetTextDatum(nodeToString(pri->whereClause));
+	else
+		nulls[Anum_pg_publication_rel_prqual - 1] = true;
+
+	check_publication_rel_filters(pub, targetrel, columns, pri->whereClause);
+
 	tup = heap_form_tuple(RelationGetDescr(rel), values, nulls);
 
 	/* Insert tuple into catalog. */
@@ -206,6 +377,26 @@ publication_add_relation(Oid pubid, Relation targetrel,
 	ObjectAddressSet(referenced, RelationRelationId, relid);
 	recordDependencyOn(&myself, &referenced, DEPENDENCY_AUTO);
 
+	/*
+	 * Add dependencies on the columns of the column list and row filter, so
+	 * that they can't be dropped from under the publication.
+	 */
+	if (columns != NULL)
+	{
+		int			attnum = -1;
+
+		while ((attnum = bms_next_member(columns, attnum)) >= 0)
+		{
+			ObjectAddressSubSet(referenced, RelationRelationId, relid, attnum);
+			recordDependencyOn(&myself, &referenced, DEPENDENCY_NORMAL);
+		}
+	}
+
+	if (pri->whereClause != NULL)
+		recordDependencyOnSingleRelExpr(&myself, pri->whereClause, relid,
+										DEPENDENCY_NORMAL, DEPENDENCY_NORMAL,
+										false);
+
 	/* Close the table. */
 	heap_close(rel, RowExclusiveLock);
 
@@ -284,6 +475,48 @@ GetPublicationRelations(Oid pubid)
 	return result;
 }
 
+/*
+ * Gets the column list and row filter of a relation in a publication.
+ *
+ * *columns is set to the set of published attribute numbers, or NULL if all
+ * columns are published; *qual to the row filter, or NULL if all rows are
+ * published.  Both are allocated in the current memory context.
+ */
+void
+GetPublicationRelationFilters(Oid pubid, Oid relid,
+							  Bitmapset **columns, Node **qual)
+{
+	HeapTuple	tup;
+	Datum		datum;
+	bool		isnull;
+
+	*columns = NULL;
+	*qual = NULL;
+
+	tup = SearchSysCache2(PUBLICATIONRELMAP, ObjectIdGetDatum(relid),
+						  ObjectIdGetDatum(pubid));
+	if (!HeapTupleIsValid(tup))
+		return;
+
+	datum = SysCacheGetAttr(PUBLICATIONRELMAP, tup,
+							Anum_pg_publication_rel_prattrs, &isnull);
+	if (!isnull)
+	{
+		int2vector *attrs = (int2vector *) DatumGetPointer(datum);
+		int			i;
+
+		for (i = 0; i < attrs->dim1; i++)
+			*columns = bms_add_member(*columns, attrs->values[i]);
+	}
+
+	datum = SysCacheGetAttr(PUBLICATIONRELMAP, tup,
+							Anum_pg_publication_rel_prqual, &isnull);
+	if (!isnull)
+		*qual = stringToNode(TextDatumGetCString(datum));
+
+	ReleaseSysCache(tup);
+}
+
 /*
  * Gets list of publication oids for publications marked as FOR ALL TABLES.
  */
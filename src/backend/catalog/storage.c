@@ -26,6 +26,7 @@
 #include "access/xlogutils.h"
 #include "catalog/storage.h"
 #include "catalog/storage_xlog.h"
+#include "commands/sequence.h"
 #include "storage/freespace.h"
 #include "storage/smgr.h"
 #include "utils/memutils.h"
@@ -336,6 +337,10 @@ smgrDoPendingDeletes(bool isCommit)
 
 				srel = smgropen(pending->relnode, pending->backend);
 
+				/* a sequence's shared cache entry dies with its storage */
+				if (pending->backend == InvalidBackendId)
+					SequenceCacheForget(pending->relnode);
+
 				/* allocate the initial array, or extend it, if needed */
 				if (maxrels == 0)
 				{
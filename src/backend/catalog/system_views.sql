@@ -291,6 +291,9 @@ CREATE VIEW pg_prepared_xacts AS
 CREATE VIEW pg_prepared_statements AS
     SELECT * FROM pg_prepared_statement() AS P;
 
+CREATE VIEW pg_catalog_caches AS
+    SELECT * FROM pg_catalog_caches() AS C;
+
 CREATE VIEW pg_seclabels AS
 SELECT
 	l.objoid, l.classoid, l.objsubid,
@@ -506,6 +509,12 @@ CREATE VIEW pg_config AS
 REVOKE ALL on pg_config FROM PUBLIC;
 REVOKE EXECUTE ON FUNCTION pg_config() FROM PUBLIC;
 
+CREATE VIEW pg_backend_memory_contexts AS
+    SELECT * FROM pg_get_backend_memory_contexts();
+
+REVOKE ALL ON pg_backend_memory_contexts FROM PUBLIC;
+REVOKE EXECUTE ON FUNCTION pg_get_backend_memory_contexts() FROM PUBLIC;
+
 -- Statistics views
 
 CREATE VIEW pg_stat_all_tables AS
@@ -708,6 +717,7 @@ CREATE VIEW pg_stat_activity AS
             S.state,
             S.backend_xid,
             s.backend_xmin,
+            S.query_id,
             S.query,
             S.backend_type
     FROM pg_stat_get_activity(NULL) AS S
@@ -872,6 +882,15 @@ CREATE VIEW pg_stat_archiver AS
         s.stats_reset
     FROM pg_stat_get_archiver() s;
 
+CREATE VIEW pg_stat_wal AS
+    SELECT
+        s.wal_records,
+        s.wal_fpi,
+        s.wal_bytes,
+        s.wal_buffers_full,
+        s.stats_reset
+    FROM pg_stat_get_wal() s;
+
 CREATE VIEW pg_stat_bgwriter AS
     SELECT
         pg_stat_get_bgwriter_timed_checkpoints() AS checkpoints_timed,
@@ -886,6 +905,35 @@ CREATE VIEW pg_stat_bgwriter AS
         pg_stat_get_buf_alloc() AS buffers_alloc,
         pg_stat_get_bgwriter_stat_reset_time() AS stats_reset;
 
+CREATE VIEW pg_stat_lock_timing AS
+    SELECT
+        s.locktype,
+        s.name,
+        s.wait_count,
+        s.wait_time,
+        s.max_wait_time,
+        s.hold_count,
+        s.hold_time,
+        s.hold_histogram,
+        s.stats_reset
+    FROM pg_stat_get_lock_timing() s;
+
+CREATE VIEW pg_stat_io AS
+    SELECT
+        s.backend_type,
+        s.io_object,
+        s.io_context,
+        s.reads,
+        s.read_time,
+        s.writes,
+        s.write_time,
+        s.extends,
+        s.extend_time,
+        s.fsyncs,
+        s.fsync_time,
+        s.stats_reset
+    FROM pg_stat_get_io() s;
+
 CREATE VIEW pg_stat_progress_vacuum AS
 	SELECT
 		S.pid AS pid, S.datid AS datid, D.datname AS datname,
@@ -904,6 +952,94 @@ CREATE VIEW pg_stat_progress_vacuum AS
     FROM pg_stat_get_progress_info('VACUUM') AS S
 		LEFT JOIN pg_database D ON S.datid = D.oid;
 
+CREATE VIEW pg_stat_progress_cluster AS
+	SELECT
+		S.pid AS pid, S.datid AS datid, D.datname AS datname,
+		S.relid AS relid,
+		CASE S.param1 WHEN 1 THEN 'CLUSTER'
+					  WHEN 2 THEN 'VACUUM FULL'
+					  END AS command,
+		CASE S.param2 WHEN 0 THEN 'initializing'
+					  WHEN 1 THEN 'seq scanning heap'
+					  WHEN 2 THEN 'index scanning heap'
+					  WHEN 3 THEN 'sorting tuples'
+					  WHEN 4 THEN 'writing new heap'
+					  WHEN 5 THEN 'swapping relation files'
+					  WHEN 6 THEN 'rebuilding index'
+					  WHEN 7 THEN 'performing final cleanup'
+					  END AS phase,
+		CAST(S.param3 AS oid) AS cluster_index_relid,
+		S.param4 AS heap_tuples_scanned,
+		S.param5 AS heap_tuples_written,
+		S.param6 AS heap_blks_total,
+		S.param7 AS heap_blks_scanned,
+		S.param8 AS index_rebuild_count
+    FROM pg_stat_get_progress_info('CLUSTER') AS S
+		LEFT JOIN pg_database D ON S.datid = D.oid;
+
+CREATE VIEW pg_stat_progress_create_index AS
+	SELECT
+		S.pid AS pid, S.datid AS datid, D.datname AS datname,
+		S.relid AS relid,
+		CAST(S.param2 AS oid) AS index_relid,
+		CASE S.param1 WHEN 1 THEN 'CREATE INDEX'
+					  WHEN 2 THEN 'CREATE INDEX CONCURRENTLY'
+					  END AS command,
+		CASE S.param3 WHEN 0 THEN 'initializing'
+					  WHEN 1 THEN 'waiting for writers before build'
+					  WHEN 2 THEN 'building index' ||
+						CASE S.param11 WHEN 1 THEN ': scanning table'
+									   WHEN 2 THEN ': sorting tuples'
+									   WHEN 3 THEN ': loading tuples'
+									   ELSE ''
+									   END
+					  WHEN 3 THEN 'waiting for writers before validation'
+					  WHEN 4 THEN 'validating index'
+					  WHEN 5 THEN 'waiting for old snapshots'
+					  END AS phase,
+		S.param14 AS blocks_total,
+		S.param15 AS blocks_done,
+		S.param12 AS tuples_total,
+		S.param13 AS tuples_done,
+		S.param4 AS partitions_total,
+		S.param5 AS partitions_done
+    FROM pg_stat_get_progress_info('CREATE INDEX') AS S
+		LEFT JOIN pg_database D ON S.datid = D.oid;
+
+CREATE VIEW pg_stat_progress_copy AS
+	SELECT
+		S.pid AS pid, S.datid AS datid, D.datname AS datname,
+		S.relid AS relid,
+		CASE S.param1 WHEN 1 THEN 'COPY FROM'
+					  WHEN 2 THEN 'COPY TO'
+					  END AS command,
+		CASE S.param2 WHEN 1 THEN 'FILE'
+					  WHEN 2 THEN 'PROGRAM'
+					  WHEN 3 THEN 'PIPE'
+					  WHEN 4 THEN 'CALLBACK'
+					  END AS "type",
+		S.param3 AS bytes_processed,
+		S.param4 AS bytes_total,
+		S.param5 AS tuples_processed
+    FROM pg_stat_get_progress_info('COPY') AS S
+		LEFT JOIN pg_database D ON S.datid = D.oid;
+
+CREATE VIEW pg_stat_progress_basebackup AS
+	SELECT
+		S.pid AS pid,
+		CASE S.param1 WHEN 0 THEN 'initializing'
+					  WHEN 1 THEN 'waiting for checkpoint to finish'
+					  WHEN 2 THEN 'estimating backup size'
+					  WHEN 3 THEN 'streaming database files'
+					  WHEN 4 THEN 'waiting for wal archiving to finish'
+					  WHEN 5 THEN 'transferring wal files'
+					  END AS phase,
+		CASE S.param2 WHEN -1 THEN NULL ELSE S.param2 END AS backup_total,
+		S.param3 AS backup_streamed,
+		S.param4 AS tablespaces_total,
+		S.param5 AS tablespaces_streamed
+    FROM pg_stat_get_progress_info('BASEBACKUP') AS S;
+
 CREATE VIEW pg_user_mappings AS
     SELECT
         U.oid       AS umid,
@@ -936,7 +1072,8 @@ REVOKE ALL ON pg_replication_origin_status FROM public;
 
 -- All columns of pg_subscription except subconninfo are readable.
 REVOKE ALL ON pg_subscription FROM public;
-GRANT SELECT (subdbid, subname, subowner, subenabled, subslotname, subpublications)
+GRANT SELECT (subdbid, subname, subowner, subenabled, substream, subbinary,
+              subslotname, subpublications)
     ON pg_subscription TO public;
 
 
@@ -1075,6 +1212,22 @@ LANGUAGE INTERNAL
 VOLATILE ROWS 1000 COST 1000
 AS 'pg_logical_slot_peek_binary_changes';
 
+CREATE OR REPLACE FUNCTION pg_logical_slot_group_get_changes(
+    IN slot_names name[], IN upto_lsn pg_lsn, IN upto_nchanges int, VARIADIC options text[] DEFAULT '{}',
+    OUT slot_name name, OUT lsn pg_lsn, OUT xid xid, OUT data text)
+RETURNS SETOF RECORD
+LANGUAGE INTERNAL
+VOLATILE ROWS 1000 COST 1000
+AS 'pg_logical_slot_group_get_changes';
+
+CREATE OR REPLACE FUNCTION pg_logical_slot_group_peek_changes(
+    IN slot_names name[], IN upto_lsn pg_lsn, IN upto_nchanges int, VARIADIC options text[] DEFAULT '{}',
+    OUT slot_name name, OUT lsn pg_lsn, OUT xid xid, OUT data text)
+RETURNS SETOF RECORD
+LANGUAGE INTERNAL
+VOLATILE ROWS 1000 COST 1000
+AS 'pg_logical_slot_group_peek_changes';
+
 CREATE OR REPLACE FUNCTION pg_create_physical_replication_slot(
     IN slot_name name, IN immediately_reserve boolean DEFAULT false,
     IN temporary boolean DEFAULT false,
@@ -1142,6 +1295,7 @@ REVOKE EXECUTE ON FUNCTION pg_wal_replay_pause() FROM public;
 REVOKE EXECUTE ON FUNCTION pg_wal_replay_resume() FROM public;
 REVOKE EXECUTE ON FUNCTION pg_rotate_logfile() FROM public;
 REVOKE EXECUTE ON FUNCTION pg_reload_conf() FROM public;
+REVOKE EXECUTE ON FUNCTION pg_log_backend_memory_contexts(integer) FROM public;
 REVOKE EXECUTE ON FUNCTION pg_current_logfile() FROM public;
 REVOKE EXECUTE ON FUNCTION pg_current_logfile(text) FROM public;
 REVOKE EXECUTE ON FUNCTION pg_promote(boolean, integer) FROM public;
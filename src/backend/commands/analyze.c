@@ -17,7 +17,9 @@
 #include <math.h>
 
 #include "access/multixact.h"
+#include "access/parallel.h"
 #include "access/sysattr.h"
+#include "access/tableam.h"
 #include "access/transam.h"
 #include "access/tupconvert.h"
 #include "access/tuptoaster.h"
@@ -47,6 +49,8 @@
 #include "storage/lmgr.h"
 #include "storage/proc.h"
 #include "storage/procarray.h"
+#include "storage/shm_mq.h"
+#include "tcop/tcopprot.h"
 #include "utils/acl.h"
 #include "utils/attoptcache.h"
 #include "utils/builtins.h"
@@ -56,6 +60,7 @@
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/pg_rusage.h"
+#include "utils/spccache.h"
 #include "utils/sampling.h"
 #include "utils/sortsupport.h"
 #include "utils/syscache.h"
@@ -72,6 +77,63 @@ typedef struct AnlIndexData
 	int			attr_cnt;
 } AnlIndexData;
 
+/* State of the block sample scan of one participant in acquire_sample_rows */
+typedef struct AnlSampleState
+{
+	HeapTuple  *rows;			/* the reservoir, targrows entries */
+	int			targrows;		/* size of the reservoir */
+	int			numrows;		/* # rows now in reservoir */
+	double		samplerows;		/* total # rows collected */
+	double		liverows;		/* # live rows seen */
+	double		deadrows;		/* # dead rows seen */
+	BlockNumber scannedblocks;	/* # blocks scanned */
+	double		rowstoskip;		/* -1 means not set yet */
+	ReservoirStateData rstate;
+} AnlSampleState;
+
+/*
+ * Parallel block sampling.
+ *
+ * Each worker scans a range of the sample blocks and, once done, sends the
+ * leader an AnlWorkerResult followed by the rows in its reservoir, each as
+ * its t_self followed by the tuple data.  Worker i uses the i'th queue in
+ * the PARALLEL_ANALYZE_KEY_QUEUES area.
+ */
+#define PARALLEL_ANALYZE_KEY_SHARED			1
+#define PARALLEL_ANALYZE_KEY_QUEUES			2
+#define PARALLEL_ANALYZE_KEY_QUERY_TEXT		3
+
+#define PARALLEL_ANALYZE_QUEUE_SIZE		65536
+
+/* minimum number of sample blocks per participant */
+#define PARALLEL_ANALYZE_MIN_BLOCKS		1024
+
+/* end of participant i's range of the nsampleblocks sample blocks */
+#define PARALLEL_ANALYZE_RANGE_END(nsampleblocks, nparticipants, i) \
+	((int) (((int64) (nsampleblocks) * ((i) + 1)) / (nparticipants)))
+
+/* Shared by the leader and the workers, in the DSM segment */
+typedef struct AnlParallelShared
+{
+	Oid			relid;			/* relation to sample */
+	TransactionId OldestXmin;	/* cutoff for HeapTupleSatisfiesVacuum */
+	BlockNumber totalblocks;	/* size of the relation */
+	long		randseed;		/* seed of the block sampler */
+	int			targrows;		/* size of each reservoir */
+	int			nsampleblocks;	/* # blocks in the sample */
+	int			nparticipants;	/* # workers planned, plus the leader */
+} AnlParallelShared;
+
+/* What a worker reports about its range before sending its rows */
+typedef struct AnlWorkerResult
+{
+	int			numrows;		/* # rows in its reservoir */
+	double		samplerows;
+	double		liverows;
+	double		deadrows;
+	BlockNumber scannedblocks;
+} AnlWorkerResult;
+
 
 /* Default statistics target (GUC parameter) */
 int			default_statistics_target = 100;
@@ -91,9 +153,18 @@ static void compute_index_stats(Relation onerel, double totalrows,
 					MemoryContext col_context);
 static VacAttrStats *examine_attribute(Relation onerel, int attnum,
 				  Node *index_expr);
-static int acquire_sample_rows(Relation onerel, int elevel,
-					HeapTuple *rows, int targrows,
-					double *totalrows, double *totaldeadrows);
+static void sample_block_range(Relation onerel, TransactionId OldestXmin,
+				   BlockNumber totalblocks, long randseed,
+				   int startblk, int endblk, AnlSampleState *st);
+static int	analyze_parallel_workers(Relation onerel, int nsampleblocks);
+static void parallel_sample_blocks(Relation onerel, int elevel, int nworkers,
+					   TransactionId OldestXmin, BlockNumber totalblocks,
+					   long randseed, int nsampleblocks, AnlSampleState *st);
+static void merge_sample_counts(AnlWorkerResult *results, int nparticipants,
+					int targrows, int *nkeep);
+static bool sample_select(ReservoirState rs, int *ntosee, int *ntokeep);
+static void parallel_sample_lost_worker(ParallelContext *pcxt,
+							shm_mq_handle **mqh, int nlaunched);
 static int	compare_rows(const void *a, const void *b);
 static int acquire_inherited_sample_rows(Relation onerel, int elevel,
 							  HeapTuple *rows, int targrows,
@@ -195,8 +266,8 @@ analyze_rel(Oid relid, RangeVar *relation, int options,
 	if (onerel->rd_rel->relkind == RELKIND_RELATION ||
 		onerel->rd_rel->relkind == RELKIND_MATVIEW)
 	{
-		/* Regular table, so we'll use the regular row acquisition function */
-		acquirefunc = acquire_sample_rows;
+		/* Regular table, so let its access method acquire the rows */
+		acquirefunc = onerel->rd_tableam->relation_acquire_sample_rows;
 		/* Also get regular table's size */
 		relpages = RelationGetNumberOfBlocks(onerel);
 	}
@@ -996,21 +1067,25 @@ examine_attribute(Relation onerel, int attnum, Node *index_expr)
  * unbiased estimates of the average numbers of live and dead rows per
  * block.  The previous sampling method put too much credence in the row
  * density near the start of the table.
+ *
+ * Reading the sample blocks is the expensive part for large tables, so
+ * when there are enough of them it is spread over parallel workers; see
+ * parallel_sample_blocks.
+ *
+ * This is the heap table access method's relation_acquire_sample_rows
+ * callback.
  */
-static int
+int
 acquire_sample_rows(Relation onerel, int elevel,
 					HeapTuple *rows, int targrows,
 					double *totalrows, double *totaldeadrows)
 {
-	int			numrows = 0;	/* # rows now in reservoir */
-	double		samplerows = 0; /* total # rows collected */
-	double		liverows = 0;	/* # live rows seen */
-	double		deadrows = 0;	/* # dead rows seen */
-	double		rowstoskip = -1;	/* -1 means not set yet */
+	AnlSampleState st;
 	BlockNumber totalblocks;
 	TransactionId OldestXmin;
-	BlockSamplerData bs;
-	ReservoirStateData rstate;
+	long		randseed;
+	int			nsampleblocks;
+	int			nworkers;
 
 	Assert(targrows > 0);
 
@@ -1020,12 +1095,129 @@ acquire_sample_rows(Relation onerel, int elevel,
 	OldestXmin = GetOldestXmin(onerel, PROCARRAY_FLAGS_VACUUM);
 
 	/* Prepare for sampling block numbers */
-	BlockSampler_Init(&bs, totalblocks, targrows, random());
+	randseed = random();
+	nsampleblocks = (int) Min((BlockNumber) targrows, totalblocks);
+
 	/* Prepare for sampling rows */
-	reservoir_init_selection_state(&rstate, targrows);
+	memset(&st, 0, sizeof(st));
+	st.rows = rows;
+	st.targrows = targrows;
+	st.rowstoskip = -1;
+	reservoir_init_selection_state(&st.rstate, targrows);
+
+	nworkers = analyze_parallel_workers(onerel, nsampleblocks);
+	if (nworkers > 0)
+		parallel_sample_blocks(onerel, elevel, nworkers, OldestXmin,
+							   totalblocks, randseed, nsampleblocks, &st);
+	else
+	{
+		sample_block_range(onerel, OldestXmin, totalblocks, randseed,
+						   0, nsampleblocks, &st);
+
+		/*
+		 * If we didn't find as many tuples as we wanted then we're done. No
+		 * sort is needed, since they're already in order.
+		 *
+		 * Otherwise we need to sort the collected tuples by position
+		 * (itempointer). It's not worth worrying about corner cases where
+		 * the tuples are already sorted.
+		 */
+		if (st.numrows == targrows)
+			qsort((void *) rows, st.numrows, sizeof(HeapTuple), compare_rows);
+	}
+
+	/*
+	 * Estimate total numbers of live and dead rows in relation, extrapolating
+	 * on the assumption that the average tuple density in pages we didn't
+	 * scan is the same as in the pages we did scan.  Since what we scanned is
+	 * a random sample of the pages in the relation, this should be a good
+	 * assumption.
+	 */
+	if (st.scannedblocks > 0)
+	{
+		*totalrows = floor((st.liverows / st.scannedblocks) * totalblocks + 0.5);
+		*totaldeadrows = floor((st.deadrows / st.scannedblocks) * totalblocks + 0.5);
+	}
+	else
+	{
+		*totalrows = 0.0;
+		*totaldeadrows = 0.0;
+	}
+
+	/*
+	 * Emit some interesting relation info
+	 */
+	ereport(elevel,
+			(errmsg("\"%s\": scanned %d of %u pages, "
+					"containing %.0f live rows and %.0f dead rows; "
+					"%d rows in sample, %.0f estimated total rows",
+					RelationGetRelationName(onerel),
+					(int) st.scannedblocks, totalblocks,
+					st.liverows, st.deadrows,
+					st.numrows, *totalrows)));
+
+	return st.numrows;
+}
+
+/*
+ * sample_block_range -- scan part of the block sample
+ *
+ * The block sampler is run from the start with the given seed, so every
+ * caller using the same seed sees the same sequence of sample blocks; we
+ * process the startblk'th up to (but not including) the endblk'th of them.
+ * Rows found are counted in *st and fed into its reservoir, which may
+ * already hold rows from an earlier call.
+ */
+static void
+sample_block_range(Relation onerel, TransactionId OldestXmin,
+				   BlockNumber totalblocks, long randseed,
+				   int startblk, int endblk, AnlSampleState *st)
+{
+	BlockSamplerData bs;
+	BlockSamplerData prefetch_bs;
+	int			prefetch_maximum = 0;
+	int			prefetchblk = 0;
+	int			blk;
+
+	BlockSampler_Init(&bs, totalblocks, st->targrows, randseed);
+	for (blk = 0; blk < startblk && BlockSampler_HasMore(&bs); blk++)
+		(void) BlockSampler_Next(&bs);
+
+	/*
+	 * The sampled blocks are scattered over the whole relation, so reading
+	 * them one by one leaves the disk idle most of the time.  A second block
+	 * sampler initialized with the same seed produces the same sequence of
+	 * blocks; we run it ahead of the main one and prefetch what it returns,
+	 * keeping the tablespace's effective_io_concurrency worth of reads in
+	 * flight.
+	 */
+	{
+		int			io_concurrency;
+		double		maximum;
+
+		io_concurrency =
+			get_tablespace_io_concurrency(onerel->rd_rel->reltablespace);
+		if (ComputeIoConcurrency(io_concurrency, &maximum))
+			prefetch_maximum = (int) rint(maximum);
+	}
+	if (prefetch_maximum > 0)
+	{
+		BlockSampler_Init(&prefetch_bs, totalblocks, st->targrows, randseed);
+		for (prefetchblk = 0;
+			 prefetchblk < startblk && BlockSampler_HasMore(&prefetch_bs);
+			 prefetchblk++)
+			(void) BlockSampler_Next(&prefetch_bs);
+		while (prefetchblk < startblk + prefetch_maximum &&
+			   prefetchblk < endblk && BlockSampler_HasMore(&prefetch_bs))
+		{
+			PrefetchBuffer(onerel, MAIN_FORKNUM,
+						   BlockSampler_Next(&prefetch_bs));
+			prefetchblk++;
+		}
+	}
 
 	/* Outer loop over blocks to sample */
-	while (BlockSampler_HasMore(&bs))
+	for (; blk < endblk && BlockSampler_HasMore(&bs); blk++)
 	{
 		BlockNumber targblock = BlockSampler_Next(&bs);
 		Buffer		targbuffer;
@@ -1035,6 +1227,15 @@ acquire_sample_rows(Relation onerel, int elevel,
 
 		vacuum_delay_point();
 
+		/* keep the prefetch sampler the same distance ahead of us */
+		if (prefetch_maximum > 0 && prefetchblk < endblk &&
+			BlockSampler_HasMore(&prefetch_bs))
+		{
+			PrefetchBuffer(onerel, MAIN_FORKNUM,
+						   BlockSampler_Next(&prefetch_bs));
+			prefetchblk++;
+		}
+
 		/*
 		 * We must maintain a pin on the target page's buffer to ensure that
 		 * the maxoffset value stays good (else concurrent VACUUM might delete
@@ -1068,7 +1269,7 @@ acquire_sample_rows(Relation onerel, int elevel,
 			if (!ItemIdIsNormal(itemid))
 			{
 				if (ItemIdIsDead(itemid))
-					deadrows += 1;
+					st->deadrows += 1;
 				continue;
 			}
 
@@ -1084,13 +1285,13 @@ acquire_sample_rows(Relation onerel, int elevel,
 			{
 				case HEAPTUPLE_LIVE:
 					sample_it = true;
-					liverows += 1;
+					st->liverows += 1;
 					break;
 
 				case HEAPTUPLE_DEAD:
 				case HEAPTUPLE_RECENTLY_DEAD:
 					/* Count dead and recently-dead rows */
-					deadrows += 1;
+					st->deadrows += 1;
 					break;
 
 				case HEAPTUPLE_INSERT_IN_PROGRESS:
@@ -1117,7 +1318,7 @@ acquire_sample_rows(Relation onerel, int elevel,
 					if (TransactionIdIsCurrentTransactionId(HeapTupleHeaderGetXmin(targtuple.t_data)))
 					{
 						sample_it = true;
-						liverows += 1;
+						st->liverows += 1;
 					}
 					break;
 
@@ -1147,11 +1348,11 @@ acquire_sample_rows(Relation onerel, int elevel,
 					 * results if the concurrent transaction never commits.
 					 */
 					if (TransactionIdIsCurrentTransactionId(HeapTupleHeaderGetUpdateXid(targtuple.t_data)))
-						deadrows += 1;
+						st->deadrows += 1;
 					else
 					{
 						sample_it = true;
-						liverows += 1;
+						st->liverows += 1;
 					}
 					break;
 
@@ -1174,8 +1375,8 @@ acquire_sample_rows(Relation onerel, int elevel,
 				 * we've passed over so far, so when we fall off the end of
 				 * the relation we're done.
 				 */
-				if (numrows < targrows)
-					rows[numrows++] = heap_copytuple(&targtuple);
+				if (st->numrows < st->targrows)
+					st->rows[st->numrows++] = heap_copytuple(&targtuple);
 				else
 				{
 					/*
@@ -1184,75 +1385,454 @@ acquire_sample_rows(Relation onerel, int elevel,
 					 * must use the not-yet-incremented value of samplerows as
 					 * t.
 					 */
-					if (rowstoskip < 0)
-						rowstoskip = reservoir_get_next_S(&rstate, samplerows, targrows);
+					if (st->rowstoskip < 0)
+						st->rowstoskip = reservoir_get_next_S(&st->rstate,
+															 st->samplerows,
+															 st->targrows);
 
-					if (rowstoskip <= 0)
+					if (st->rowstoskip <= 0)
 					{
 						/*
 						 * Found a suitable tuple, so save it, replacing one
 						 * old tuple at random
 						 */
-						int			k = (int) (targrows * sampler_random_fract(rstate.randstate));
+						int			k = (int) (st->targrows * sampler_random_fract(st->rstate.randstate));
 
-						Assert(k >= 0 && k < targrows);
-						heap_freetuple(rows[k]);
-						rows[k] = heap_copytuple(&targtuple);
+						Assert(k >= 0 && k < st->targrows);
+						heap_freetuple(st->rows[k]);
+						st->rows[k] = heap_copytuple(&targtuple);
 					}
 
-					rowstoskip -= 1;
+					st->rowstoskip -= 1;
 				}
 
-				samplerows += 1;
+				st->samplerows += 1;
 			}
 		}
 
 		/* Now release the lock and pin on the page */
 		UnlockReleaseBuffer(targbuffer);
+		st->scannedblocks++;
 	}
+}
 
-	/*
-	 * If we didn't find as many tuples as we wanted then we're done. No sort
-	 * is needed, since they're already in order.
-	 *
-	 * Otherwise we need to sort the collected tuples by position
-	 * (itempointer). It's not worth worrying about corner cases where the
-	 * tuples are already sorted.
-	 */
-	if (numrows == targrows)
-		qsort((void *) rows, numrows, sizeof(HeapTuple), compare_rows);
+/*
+ * analyze_parallel_workers -- decide how many workers should help sample
+ *
+ * Each participant, the leader included, should get at least
+ * PARALLEL_ANALYZE_MIN_BLOCKS sample blocks to read; below that, starting
+ * the workers costs more than it saves.
+ */
+static int
+analyze_parallel_workers(Relation onerel, int nsampleblocks)
+{
+	int			nworkers;
+
+	/* Autovacuum is meant to run in the background, so leave it alone */
+	if (IsAutoVacuumWorkerProcess() || IsInParallelMode())
+		return 0;
+
+	/* Workers could not see dirty pages in our local buffers */
+	if (RelationUsesLocalBuffers(onerel))
+		return 0;
+
+	nworkers = nsampleblocks / PARALLEL_ANALYZE_MIN_BLOCKS - 1;
+	nworkers = Min(nworkers, max_parallel_maintenance_workers);
+
+	return Max(nworkers, 0);
+}
+
+/*
+ * parallel_sample_blocks -- read the block sample with parallel workers
+ *
+ * The sample blocks are divided into nworkers + 1 consecutive ranges of
+ * (nearly) equal size; participant i, with the leader being participant 0
+ * and worker n participant n + 1, runs sample_block_range on the i'th of
+ * them with a reservoir of its own.  The workers then report their counts
+ * and send us their reservoirs, and we merge the reservoirs into *st.
+ *
+ * Every participant's reservoir is a simple random sample of the rows it
+ * saw, so for the union to be one as well we must take from each a number
+ * of rows following the multivariate hypergeometric distribution over the
+ * participants' row counts, which is what merge_sample_counts draws.
+ * Which rows we keep from each reservoir is then decided by selection
+ * sampling as they stream past.
+ */
+static void
+parallel_sample_blocks(Relation onerel, int elevel, int nworkers,
+					   TransactionId OldestXmin, BlockNumber totalblocks,
+					   long randseed, int nsampleblocks, AnlSampleState *st)
+{
+	ParallelContext *pcxt;
+	AnlParallelShared *shared;
+	char	   *sharedquery;
+	char	   *queues;
+	shm_mq_handle **mqh;
+	AnlWorkerResult *results;
+	int		   *nkeep;
+	int			nparticipants = nworkers + 1;
+	int			nlaunched;
+	int			querylen;
+	int			nrows;
+	int			i;
+
+	EnterParallelMode();
+	pcxt = CreateParallelContext("postgres", "analyze_parallel_sample_main",
+								 nworkers, true);
+
+	shm_toc_estimate_chunk(&pcxt->estimator, sizeof(AnlParallelShared));
+	shm_toc_estimate_chunk(&pcxt->estimator,
+						   mul_size(PARALLEL_ANALYZE_QUEUE_SIZE, nworkers));
+	querylen = strlen(debug_query_string);
+	shm_toc_estimate_chunk(&pcxt->estimator, querylen + 1);
+	shm_toc_estimate_keys(&pcxt->estimator, 3);
+
+	InitializeParallelDSM(pcxt);
+
+	shared = (AnlParallelShared *) shm_toc_allocate(pcxt->toc,
+													sizeof(AnlParallelShared));
+	shared->relid = RelationGetRelid(onerel);
+	shared->OldestXmin = OldestXmin;
+	shared->totalblocks = totalblocks;
+	shared->randseed = randseed;
+	shared->targrows = st->targrows;
+	shared->nsampleblocks = nsampleblocks;
+	shared->nparticipants = nparticipants;
+	shm_toc_insert(pcxt->toc, PARALLEL_ANALYZE_KEY_SHARED, shared);
+
+	queues = shm_toc_allocate(pcxt->toc,
+							  mul_size(PARALLEL_ANALYZE_QUEUE_SIZE, nworkers));
+	for (i = 0; i < nworkers; i++)
+	{
+		shm_mq	   *mq;
+
+		mq = shm_mq_create(queues + (Size) i * PARALLEL_ANALYZE_QUEUE_SIZE,
+						   PARALLEL_ANALYZE_QUEUE_SIZE);
+		shm_mq_set_receiver(mq, MyProc);
+	}
+	shm_toc_insert(pcxt->toc, PARALLEL_ANALYZE_KEY_QUEUES, queues);
+
+	sharedquery = (char *) shm_toc_allocate(pcxt->toc, querylen + 1);
+	memcpy(sharedquery, debug_query_string, querylen + 1);
+	shm_toc_insert(pcxt->toc, PARALLEL_ANALYZE_KEY_QUERY_TEXT, sharedquery);
+
+	LaunchParallelWorkers(pcxt);
+	nlaunched = pcxt->nworkers_launched;
+
+	ereport(elevel,
+			(errmsg(ngettext("launched %d parallel analyze worker (planned: %d)",
+							 "launched %d parallel analyze workers (planned: %d)",
+							 nlaunched),
+					nlaunched, nworkers)));
+
+	mqh = (shm_mq_handle **) palloc0(sizeof(shm_mq_handle *) * nworkers);
+	for (i = 0; i < nlaunched; i++)
+	{
+		shm_mq	   *mq;
+
+		mq = (shm_mq *) (queues + (Size) i * PARALLEL_ANALYZE_QUEUE_SIZE);
+		mqh[i] = shm_mq_attach(mq, pcxt->seg, pcxt->worker[i].bgwhandle);
+	}
 
 	/*
-	 * Estimate total numbers of live and dead rows in relation, extrapolating
-	 * on the assumption that the average tuple density in pages we didn't
-	 * scan is the same as in the pages we did scan.  Since what we scanned is
-	 * a random sample of the pages in the relation, this should be a good
-	 * assumption.
+	 * Do our own share.  Workers are launched in order, so if not all of
+	 * them could be, the ones missing are the last ones, and their ranges
+	 * follow each other at the end of the sample.
 	 */
-	if (bs.m > 0)
+	sample_block_range(onerel, OldestXmin, totalblocks, randseed,
+					   0, PARALLEL_ANALYZE_RANGE_END(nsampleblocks, nparticipants, 0),
+					   st);
+	if (nlaunched < nworkers)
+		sample_block_range(onerel, OldestXmin, totalblocks, randseed,
+						   PARALLEL_ANALYZE_RANGE_END(nsampleblocks, nparticipants, nlaunched),
+						   nsampleblocks, st);
+
+	/* Collect the workers' counts */
+	results = (AnlWorkerResult *) palloc0(sizeof(AnlWorkerResult) * nparticipants);
+	results[0].numrows = st->numrows;
+	results[0].samplerows = st->samplerows;
+	for (i = 0; i < nlaunched; i++)
 	{
-		*totalrows = floor((liverows / bs.m) * totalblocks + 0.5);
-		*totaldeadrows = floor((deadrows / bs.m) * totalblocks + 0.5);
+		AnlWorkerResult *result = &results[i + 1];
+		shm_mq_result res;
+		Size		nbytes;
+		void	   *data;
+
+		res = shm_mq_receive(mqh[i], &nbytes, &data, false);
+		if (res != SHM_MQ_SUCCESS)
+			parallel_sample_lost_worker(pcxt, mqh, nlaunched);
+		Assert(nbytes == sizeof(AnlWorkerResult));
+		memcpy(result, data, sizeof(AnlWorkerResult));
+
+		st->samplerows += result->samplerows;
+		st->liverows += result->liverows;
+		st->deadrows += result->deadrows;
+		st->scannedblocks += result->scannedblocks;
 	}
-	else
+
+	/* Decide how many rows to keep from each participant, and keep them */
+	nkeep = (int *) palloc(sizeof(int) * nparticipants);
+	merge_sample_counts(results, nlaunched + 1, st->targrows, nkeep);
+
+	nrows = 0;
 	{
-		*totalrows = 0.0;
-		*totaldeadrows = 0.0;
+		int			ntosee = results[0].numrows;
+		int			ntokeep = nkeep[0];
+
+		for (i = 0; i < results[0].numrows; i++)
+		{
+			if (sample_select(&st->rstate, &ntosee, &ntokeep))
+				st->rows[nrows++] = st->rows[i];
+			else
+				heap_freetuple(st->rows[i]);
+		}
+	}
+	for (i = 0; i < nlaunched; i++)
+	{
+		int			ntosee = results[i + 1].numrows;
+		int			ntokeep = nkeep[i + 1];
+
+		while (ntokeep > 0)
+		{
+			shm_mq_result res;
+			Size		nbytes;
+			char	   *data;
+
+			res = shm_mq_receive(mqh[i], &nbytes, (void **) &data, false);
+			if (res != SHM_MQ_SUCCESS)
+				parallel_sample_lost_worker(pcxt, mqh, nlaunched);
+
+			if (sample_select(&st->rstate, &ntosee, &ntokeep))
+			{
+				HeapTuple	tuple;
+				Size		len = nbytes - sizeof(ItemPointerData);
+
+				Assert(nbytes >= sizeof(ItemPointerData));
+				tuple = (HeapTuple) palloc(HEAPTUPLESIZE + len);
+				memcpy(&tuple->t_self, data, sizeof(ItemPointerData));
+				tuple->t_len = len;
+				tuple->t_tableOid = RelationGetRelid(onerel);
+				tuple->t_data = (HeapTupleHeader) ((char *) tuple + HEAPTUPLESIZE);
+				memcpy(tuple->t_data, data + sizeof(ItemPointerData), len);
+				st->rows[nrows++] = tuple;
+			}
+		}
+
+		/* We don't need the rest of this reservoir; let the worker go */
+		shm_mq_detach(mqh[i]);
+		mqh[i] = NULL;
+	}
+	Assert(nrows <= st->targrows);
+	st->numrows = nrows;
+
+	WaitForParallelWorkersToFinish(pcxt);
+	DestroyParallelContext(pcxt);
+	ExitParallelMode();
+
+	/* The ranges were merged in order, but the reservoirs weren't sorted */
+	qsort((void *) st->rows, st->numrows, sizeof(HeapTuple), compare_rows);
+
+	pfree(nkeep);
+	pfree(results);
+	pfree(mqh);
+}
+
+/*
+ * merge_sample_counts -- decide how many sample rows to take from each
+ * participant of a parallel sample
+ *
+ * If all the rows seen fit into the sample, we take all of them.  Otherwise
+ * we draw targrows rows one at a time without replacement from the union of
+ * the rows the participants saw, and count for each participant how many of
+ * them came from it.  That count never exceeds the size of its reservoir,
+ * since the reservoir holds min(targrows, rows seen) rows.
+ */
+static void
+merge_sample_counts(AnlWorkerResult *results, int nparticipants,
+					int targrows, int *nkeep)
+{
+	SamplerRandomState randstate;
+	double	   *remaining;
+	double		total = 0;
+	int			i,
+				k;
+
+	for (i = 0; i < nparticipants; i++)
+		total += results[i].samplerows;
+
+	if (total <= targrows)
+	{
+		for (i = 0; i < nparticipants; i++)
+			nkeep[i] = results[i].numrows;
+		return;
 	}
 
+	sampler_random_init_state(random(), randstate);
+	remaining = (double *) palloc(sizeof(double) * nparticipants);
+	for (i = 0; i < nparticipants; i++)
+	{
+		remaining[i] = results[i].samplerows;
+		nkeep[i] = 0;
+	}
+
+	for (k = 0; k < targrows; k++)
+	{
+		double		r = floor(sampler_random_fract(randstate) * total);
+
+		for (i = 0; i < nparticipants - 1; i++)
+		{
+			if (r < remaining[i])
+				break;
+			r -= remaining[i];
+		}
+		Assert(remaining[i] >= 1);
+		remaining[i] -= 1;
+		total -= 1;
+		nkeep[i]++;
+	}
+
+	pfree(remaining);
+}
+
+/*
+ * sample_select -- selection sampling (Knuth's Algorithm S)
+ *
+ * Decides whether to keep the next of *ntosee items when we want *ntokeep
+ * of them, uniformly at random, and updates both counts.
+ */
+static bool
+sample_select(ReservoirState rs, int *ntosee, int *ntokeep)
+{
+	bool		keep;
+
+	Assert(*ntosee >= *ntokeep);
+	keep = (*ntokeep > 0 &&
+			sampler_random_fract(rs->randstate) * *ntosee < *ntokeep);
+	(*ntosee)--;
+	if (keep)
+		(*ntokeep)--;
+	return keep;
+}
+
+/*
+ * parallel_sample_lost_worker -- report a worker that quit on us
+ *
+ * Detach from the other workers' queues first, so that they stop
+ * trying to send us their rows and exit; WaitForParallelWorkersToFinish
+ * will then report the error that made the worker quit, if there was one.
+ */
+static void
+parallel_sample_lost_worker(ParallelContext *pcxt, shm_mq_handle **mqh,
+							int nlaunched)
+{
+	int			i;
+
+	for (i = 0; i < nlaunched; i++)
+	{
+		if (mqh[i] != NULL)
+			shm_mq_detach(mqh[i]);
+		mqh[i] = NULL;
+	}
+
+	WaitForParallelWorkersToFinish(pcxt);
+
+	elog(ERROR, "lost connection to parallel ANALYZE worker");
+}
+
+/*
+ * analyze_parallel_sample_main -- entry point of a parallel ANALYZE worker
+ *
+ * Reads this worker's range of the block sample into a reservoir of its
+ * own and sends the leader its counts, followed by the rows in the
+ * reservoir for as long as the leader wants them.
+ */
+void
+analyze_parallel_sample_main(dsm_segment *seg, shm_toc *toc)
+{
+	AnlParallelShared *shared;
+	AnlSampleState st;
+	AnlWorkerResult result;
+	Relation	onerel;
+	char	   *queues;
+	shm_mq	   *mq;
+	shm_mq_handle *mqh;
+	int			participant = ParallelWorkerNumber + 1;
+	int			i;
+
+	/* Set debug_query_string for individual workers first */
+	debug_query_string = shm_toc_lookup(toc, PARALLEL_ANALYZE_KEY_QUERY_TEXT,
+										false);
+
+	/* Report the query string from leader */
+	pgstat_report_activity(STATE_RUNNING, debug_query_string);
+
+	shared = (AnlParallelShared *) shm_toc_lookup(toc,
+												  PARALLEL_ANALYZE_KEY_SHARED,
+												  false);
+	queues = shm_toc_lookup(toc, PARALLEL_ANALYZE_KEY_QUEUES, false);
+	mq = (shm_mq *) (queues +
+					 (Size) ParallelWorkerNumber * PARALLEL_ANALYZE_QUEUE_SIZE);
+	shm_mq_set_sender(mq, MyProc);
+	mqh = shm_mq_attach(mq, seg, NULL);
+
+	/* The leader holds at least this lock already */
+	onerel = heap_open(shared->relid, AccessShareLock);
+
 	/*
-	 * Emit some interesting relation info
+	 * Each worker applies the cost-based vacuum delay on its own, starting
+	 * from a zero balance.
 	 */
-	ereport(elevel,
-			(errmsg("\"%s\": scanned %d of %u pages, "
-					"containing %.0f live rows and %.0f dead rows; "
-					"%d rows in sample, %.0f estimated total rows",
-					RelationGetRelationName(onerel),
-					bs.m, totalblocks,
-					liverows, deadrows,
-					numrows, *totalrows)));
+	VacuumCostActive = (VacuumCostDelay > 0);
+	VacuumCostBalance = 0;
+	VacuumPageHit = 0;
+	VacuumPageMiss = 0;
+	VacuumPageDirty = 0;
+	vac_strategy = GetAccessStrategy(BAS_VACUUM);
+
+	memset(&st, 0, sizeof(st));
+	st.rows = (HeapTuple *) palloc(shared->targrows * sizeof(HeapTuple));
+	st.targrows = shared->targrows;
+	st.rowstoskip = -1;
+	reservoir_init_selection_state(&st.rstate, shared->targrows);
+
+	sample_block_range(onerel, shared->OldestXmin, shared->totalblocks,
+					   shared->randseed,
+					   PARALLEL_ANALYZE_RANGE_END(shared->nsampleblocks,
+												  shared->nparticipants,
+												  participant - 1),
+					   PARALLEL_ANALYZE_RANGE_END(shared->nsampleblocks,
+												  shared->nparticipants,
+												  participant),
+					   &st);
+
+	result.numrows = st.numrows;
+	result.samplerows = st.samplerows;
+	result.liverows = st.liverows;
+	result.deadrows = st.deadrows;
+	result.scannedblocks = st.scannedblocks;
 
-	return numrows;
+	/*
+	 * If the leader detaches, it either has all the rows it wants from us or
+	 * is erroring out; either way we're done.
+	 */
+	if (shm_mq_send(mqh, sizeof(result), &result, false) == SHM_MQ_SUCCESS)
+	{
+		for (i = 0; i < st.numrows; i++)
+		{
+			HeapTuple	tuple = st.rows[i];
+			shm_mq_iovec iov[2];
+
+			iov[0].data = (char *) &tuple->t_self;
+			iov[0].len = sizeof(ItemPointerData);
+			iov[1].data = (char *) tuple->t_data;
+			iov[1].len = tuple->t_len;
+			if (shm_mq_sendv(mqh, iov, 2, false) != SHM_MQ_SUCCESS)
+				break;
+		}
+	}
+
+	heap_close(onerel, AccessShareLock);
+	FreeAccessStrategy(vac_strategy);
 }
 
 /*
@@ -1364,8 +1944,8 @@ acquire_inherited_sample_rows(Relation onerel, int elevel,
 		if (childrel->rd_rel->relkind == RELKIND_RELATION ||
 			childrel->rd_rel->relkind == RELKIND_MATVIEW)
 		{
-			/* Regular table, so use the regular row acquisition function */
-			acquirefunc = acquire_sample_rows;
+			/* Regular table, so let its access method acquire the rows */
+			acquirefunc = childrel->rd_tableam->relation_acquire_sample_rows;
 			relpages = RelationGetNumberOfBlocks(childrel);
 		}
 		else if (childrel->rd_rel->relkind == RELKIND_FOREIGN_TABLE)
@@ -73,10 +73,14 @@
  *	  Finally, after we are out of the transaction altogether, we check if
  *	  we need to signal listening backends.  In SignalBackends() we scan the
  *	  list of listening backends and send a PROCSIG_NOTIFY_INTERRUPT signal
- *	  to every listening backend (we don't know which backend is listening on
- *	  which channel so we must signal them all). We can exclude backends that
- *	  are already up to date, though.  We don't bother with a self-signal
- *	  either, but just process the queue directly.
+ *	  to those that might be listening on one of the channels we notified.
+ *	  Each listening backend advertises its channels in the shared array as
+ *	  a small bitmap of channel name hashes, which may report channels it
+ *	  isn't listening on but never misses one.  Backends that can't be
+ *	  interested are left alone unless they have fallen behind by more than
+ *	  QUEUE_CLEANUP_DELAY pages, in which case we wake them anyway so that
+ *	  they advance their pointers and the queue can be truncated.  We don't
+ *	  bother with a self-signal either, but just process the queue directly.
  *
  * 5. Upon receipt of a PROCSIG_NOTIFY_INTERRUPT signal, the signal handler
  *	  sets the process's latch, which triggers the event to be processed
@@ -104,7 +108,7 @@
  * frontend during startup.)  The above design guarantees that notifies from
  * other backends will never be missed by ignoring self-notifies.
  *
- * The amount of shared memory used for notify management (NUM_ASYNC_BUFFERS)
+ * The amount of shared memory used for notify management (notify_buffers)
  * can be varied without affecting anything but performance.  The maximum
  * amount of notification data that can be queued at one time is determined
  * by slru.c's wraparound limit; see QUEUE_MAX_PAGE below.
@@ -117,6 +121,7 @@
 #include <unistd.h>
 #include <signal.h>
 
+#include "access/hash.h"
 #include "access/parallel.h"
 #include "access/slru.h"
 #include "access/transam.h"
@@ -211,6 +216,19 @@ typedef struct QueuePosition
 	 (x).page != (y).page ? (x) : \
 	 (x).offset > (y).offset ? (x) : (y))
 
+/*
+ * Bitmap of channel name hashes.  A bit is set for each channel of interest,
+ * so a channel whose bit is clear is surely not of interest; collisions
+ * merely cost a useless wakeup.
+ */
+#define CHANNEL_FILTER_WORDS		4
+#define CHANNEL_FILTER_BITS			(CHANNEL_FILTER_WORDS * 64)
+
+typedef struct ChannelFilter
+{
+	uint64		words[CHANNEL_FILTER_WORDS];
+} ChannelFilter;
+
 /*
  * Struct describing a listening backend's status
  */
@@ -219,6 +237,7 @@ typedef struct QueueBackendStatus
 	int32		pid;			/* either a PID or InvalidPid */
 	Oid			dboid;			/* backend's database OID, or InvalidOid */
 	QueuePosition pos;			/* backend has read queue up to here */
+	ChannelFilter channels;		/* channels it is (maybe) listening on */
 } QueueBackendStatus;
 
 /*
@@ -259,6 +278,7 @@ static AsyncQueueControl *asyncQueueControl;
 #define QUEUE_BACKEND_PID(i)		(asyncQueueControl->backend[i].pid)
 #define QUEUE_BACKEND_DBOID(i)		(asyncQueueControl->backend[i].dboid)
 #define QUEUE_BACKEND_POS(i)		(asyncQueueControl->backend[i].pos)
+#define QUEUE_BACKEND_CHANNELS(i)	(asyncQueueControl->backend[i].channels)
 
 /*
  * The SLRU buffer area through which we access the notification queue
@@ -269,6 +289,13 @@ static SlruCtlData AsyncCtlData;
 #define QUEUE_PAGESIZE				BLCKSZ
 #define QUEUE_FULL_WARN_INTERVAL	5000	/* warn at most once every 5s */
 
+/*
+ * How many pages a listening backend may lag behind the queue head before
+ * SignalBackends() wakes it even though it's not interested in what was
+ * sent, so that it doesn't hold back truncation of the queue forever.
+ */
+#define QUEUE_CLEANUP_DELAY			4
+
 /*
  * slru.c currently assumes that all filenames are four characters of hex
  * digits. That means that we can use segments 0000 through FFFF.
@@ -346,6 +373,17 @@ typedef struct Notification
 
 static List *pendingNotifies = NIL; /* list of Notifications */
 
+/*
+ * Channels of all notifications made in the current transaction, including
+ * aborted subtransactions.  Async_Notify() uses this to skip the search for
+ * a duplicate when the channel hasn't been notified yet, which is the common
+ * case for payload-free notifications.
+ */
+static ChannelFilter pendingNotifyChannels;
+
+/* Channels we queued notifications for, and thus need to signal about */
+static ChannelFilter sentNotifyChannels;
+
 static List *upperPendingNotifies = NIL;	/* list of upper-xact lists */
 
 /*
@@ -366,11 +404,19 @@ static bool amRegisteredListener = false;
 /* has this backend sent notifications in the current transaction? */
 static bool backendHasSentNotifications = false;
 
-/* GUC parameter */
+/* GUC parameters */
 bool		Trace_notify = false;
+int			notify_buffers = 16;
 
 /* local function prototypes */
 static bool asyncQueuePagePrecedes(int p, int q);
+static int	asyncQueuePageDiff(int p, int q);
+static void ChannelFilterAdd(ChannelFilter *filter, const char *channel);
+static bool ChannelFilterContains(const ChannelFilter *filter,
+					  const char *channel);
+static bool ChannelFilterOverlaps(const ChannelFilter *a,
+					  const ChannelFilter *b);
+static void asyncQueueAdvertiseChannels(void);
 static void queue_listen(ListenActionKind action, const char *channel);
 static void Async_UnlistenOnExit(int code, Datum arg);
 static void Exec_ListenPreCommit(void);
@@ -401,6 +447,16 @@ static void ClearPendingActionsAndNotifies(void);
  */
 static bool
 asyncQueuePagePrecedes(int p, int q)
+{
+	return asyncQueuePageDiff(p, q) < 0;
+}
+
+/*
+ * Compute the difference between two queue page numbers (i.e., p - q),
+ * accounting for wraparound.
+ */
+static int
+asyncQueuePageDiff(int p, int q)
 {
 	int			diff;
 
@@ -416,7 +472,49 @@ asyncQueuePagePrecedes(int p, int q)
 		diff -= QUEUE_MAX_PAGE + 1;
 	else if (diff < -((QUEUE_MAX_PAGE + 1) / 2))
 		diff += QUEUE_MAX_PAGE + 1;
-	return diff < 0;
+	return diff;
+}
+
+/*
+ * Add a channel to a channel filter.
+ */
+static void
+ChannelFilterAdd(ChannelFilter *filter, const char *channel)
+{
+	uint32		bit;
+
+	bit = DatumGetUInt32(hash_any((const unsigned char *) channel,
+								  strlen(channel))) % CHANNEL_FILTER_BITS;
+	filter->words[bit / 64] |= UINT64CONST(1) << (bit % 64);
+}
+
+/*
+ * Might the channel have been added to the filter?
+ */
+static bool
+ChannelFilterContains(const ChannelFilter *filter, const char *channel)
+{
+	uint32		bit;
+
+	bit = DatumGetUInt32(hash_any((const unsigned char *) channel,
+								  strlen(channel))) % CHANNEL_FILTER_BITS;
+	return (filter->words[bit / 64] & (UINT64CONST(1) << (bit % 64))) != 0;
+}
+
+/*
+ * Might the two filters have a channel in common?
+ */
+static bool
+ChannelFilterOverlaps(const ChannelFilter *a, const ChannelFilter *b)
+{
+	int			i;
+
+	for (i = 0; i < CHANNEL_FILTER_WORDS; i++)
+	{
+		if ((a->words[i] & b->words[i]) != 0)
+			return true;
+	}
+	return false;
 }
 
 /*
@@ -431,7 +529,7 @@ AsyncShmemSize(void)
 	size = mul_size(MaxBackends + 1, sizeof(QueueBackendStatus));
 	size = add_size(size, offsetof(AsyncQueueControl, backend));
 
-	size = add_size(size, SimpleLruShmemSize(NUM_ASYNC_BUFFERS, 0));
+	size = add_size(size, SimpleLruShmemSize(notify_buffers, 0));
 
 	return size;
 }
@@ -472,6 +570,7 @@ AsyncShmemInit(void)
 			QUEUE_BACKEND_PID(i) = InvalidPid;
 			QUEUE_BACKEND_DBOID(i) = InvalidOid;
 			SET_QUEUE_POS(QUEUE_BACKEND_POS(i), 0, 0);
+			MemSet(&QUEUE_BACKEND_CHANNELS(i), 0, sizeof(ChannelFilter));
 		}
 	}
 
@@ -479,8 +578,8 @@ AsyncShmemInit(void)
 	 * Set up SLRU management of the pg_notify data.
 	 */
 	AsyncCtl->PagePrecedes = asyncQueuePagePrecedes;
-	SimpleLruInit(AsyncCtl, "async", NUM_ASYNC_BUFFERS, 0,
-				  AsyncCtlLock, "pg_notify", LWTRANCHE_ASYNC_BUFFERS);
+	SimpleLruInit(AsyncCtl, "async", notify_buffers, 0,
+				  AsyncCtlLock, "pg_notify", LWTRANCHE_ASYNC_BUFFERS, 0);
 	/* Override default assumption that writes should be fsync'd */
 	AsyncCtl->do_fsync = false;
 
@@ -570,9 +669,14 @@ Async_Notify(const char *channel, const char *payload)
 					 errmsg("payload string too long")));
 	}
 
-	/* no point in making duplicate entries in the list ... */
-	if (AsyncExistsPendingNotify(channel, payload))
+	/*
+	 * No point in making duplicate entries in the list ...  but don't bother
+	 * searching for one if this channel hasn't been notified at all yet.
+	 */
+	if (ChannelFilterContains(&pendingNotifyChannels, channel) &&
+		AsyncExistsPendingNotify(channel, payload))
 		return;
+	ChannelFilterAdd(&pendingNotifyChannels, channel);
 
 	/*
 	 * The notification list needs to live until end of transaction, so store
@@ -791,6 +895,17 @@ PreCommit_Notify(void)
 		{
 			case LISTEN_LISTEN:
 				Exec_ListenPreCommit();
+
+				/*
+				 * Advertise the channel before we commit, so that nobody who
+				 * commits a notification on it after us skips signalling us.
+				 * UNLISTEN only clears channels after commit; until then we
+				 * may get useless signals, which is harmless.
+				 */
+				LWLockAcquire(AsyncQueueLock, LW_SHARED);
+				ChannelFilterAdd(&QUEUE_BACKEND_CHANNELS(MyBackendId),
+								 actrec->channel);
+				LWLockRelease(AsyncQueueLock);
 				break;
 			case LISTEN_UNLISTEN:
 				/* there is no Exec_UnlistenPreCommit() */
@@ -834,7 +949,15 @@ PreCommit_Notify(void)
 						 AccessExclusiveLock);
 
 		/* Now push the notifications into the queue */
+		if (!backendHasSentNotifications)
+			MemSet(&sentNotifyChannels, 0, sizeof(ChannelFilter));
 		backendHasSentNotifications = true;
+		foreach(p, pendingNotifies)
+		{
+			Notification *n = (Notification *) lfirst(p);
+
+			ChannelFilterAdd(&sentNotifyChannels, n->channel);
+		}
 
 		nextNotify = list_head(pendingNotifies);
 		while (nextNotify != NULL)
@@ -907,11 +1030,33 @@ AtCommit_Notify(void)
 	/* If no longer listening to anything, get out of listener array */
 	if (amRegisteredListener && listenChannels == NIL)
 		asyncQueueUnregister();
+	else if (amRegisteredListener && pendingActions != NIL)
+		asyncQueueAdvertiseChannels();
 
 	/* And clean up */
 	ClearPendingActionsAndNotifies();
 }
 
+/*
+ * Publish exactly the channels in listenChannels as the ones we listen on,
+ * undoing any channels advertised for a LISTEN that didn't commit, or that
+ * has been undone by UNLISTEN since.
+ */
+static void
+asyncQueueAdvertiseChannels(void)
+{
+	ChannelFilter filter;
+	ListCell   *p;
+
+	MemSet(&filter, 0, sizeof(filter));
+	foreach(p, listenChannels)
+		ChannelFilterAdd(&filter, (char *) lfirst(p));
+
+	LWLockAcquire(AsyncQueueLock, LW_SHARED);
+	QUEUE_BACKEND_CHANNELS(MyBackendId) = filter;
+	LWLockRelease(AsyncQueueLock);
+}
+
 /*
  * Exec_ListenPreCommit --- subroutine for PreCommit_Notify
  *
@@ -979,6 +1124,7 @@ Exec_ListenPreCommit(void)
 	QUEUE_BACKEND_POS(MyBackendId) = max;
 	QUEUE_BACKEND_PID(MyBackendId) = MyProcPid;
 	QUEUE_BACKEND_DBOID(MyBackendId) = MyDatabaseId;
+	MemSet(&QUEUE_BACKEND_CHANNELS(MyBackendId), 0, sizeof(ChannelFilter));
 	LWLockRelease(AsyncQueueLock);
 
 	/* Now we are listed in the global array, so remember we're listening */
@@ -1180,6 +1326,15 @@ IsListeningOn(const char *channel)
 	return false;
 }
 
+/*
+ * Test whether we are listening on any channel at all.
+ */
+bool
+IsListeningOnAnyChannel(void)
+{
+	return listenChannels != NIL;
+}
+
 /*
  * Remove our entry from the listeners array when we are no longer listening
  * on any channel.  NB: must not fail if we're already not listening.
@@ -1539,18 +1694,31 @@ SignalBackends(void)
 	LWLockAcquire(AsyncQueueLock, LW_EXCLUSIVE);
 	for (i = 1; i <= MaxBackends; i++)
 	{
+		QueuePosition pos;
+
 		pid = QUEUE_BACKEND_PID(i);
-		if (pid != InvalidPid && pid != MyProcPid)
-		{
-			QueuePosition pos = QUEUE_BACKEND_POS(i);
+		if (pid == InvalidPid || pid == MyProcPid)
+			continue;
 
-			if (!QUEUE_POS_EQUAL(pos, QUEUE_HEAD))
-			{
-				pids[count] = pid;
-				ids[count] = i;
-				count++;
-			}
-		}
+		pos = QUEUE_BACKEND_POS(i);
+		if (QUEUE_POS_EQUAL(pos, QUEUE_HEAD))
+			continue;			/* already up to date */
+
+		/*
+		 * Backends that can't be listening on any of our channels needn't
+		 * read our notifications now, unless they're far enough behind to
+		 * be holding up queue truncation.
+		 */
+		if ((QUEUE_BACKEND_DBOID(i) != MyDatabaseId ||
+			 !ChannelFilterOverlaps(&QUEUE_BACKEND_CHANNELS(i),
+									&sentNotifyChannels)) &&
+			asyncQueuePageDiff(QUEUE_POS_PAGE(QUEUE_HEAD),
+							   QUEUE_POS_PAGE(pos)) < QUEUE_CLEANUP_DELAY)
+			continue;
+
+		pids[count] = pid;
+		ids[count] = i;
+		count++;
 	}
 	LWLockRelease(AsyncQueueLock);
 
@@ -1595,6 +1763,8 @@ AtAbort_Notify(void)
 	 */
 	if (amRegisteredListener && listenChannels == NIL)
 		asyncQueueUnregister();
+	else if (amRegisteredListener && pendingActions != NIL)
+		asyncQueueAdvertiseChannels();
 
 	/* And clean up */
 	ClearPendingActionsAndNotifies();
@@ -2177,4 +2347,5 @@ ClearPendingActionsAndNotifies(void)
 	 */
 	pendingActions = NIL;
 	pendingNotifies = NIL;
+	MemSet(&pendingNotifyChannels, 0, sizeof(ChannelFilter));
 }
@@ -19,6 +19,7 @@
 
 #include "access/amapi.h"
 #include "access/multixact.h"
+#include "access/parallel.h"
 #include "access/relscan.h"
 #include "access/rewriteheap.h"
 #include "access/transam.h"
@@ -34,14 +35,19 @@
 #include "catalog/objectaccess.h"
 #include "catalog/toasting.h"
 #include "commands/cluster.h"
+#include "commands/progress.h"
 #include "commands/tablecmds.h"
 #include "commands/vacuum.h"
 #include "miscadmin.h"
 #include "optimizer/planner.h"
+#include "pgstat.h"
 #include "storage/bufmgr.h"
+#include "storage/condition_variable.h"
 #include "storage/lmgr.h"
 #include "storage/predicate.h"
 #include "storage/smgr.h"
+#include "storage/spin.h"
+#include "tcop/tcopprot.h"
 #include "utils/acl.h"
 #include "utils/fmgroids.h"
 #include "utils/inval.h"
@@ -66,6 +72,51 @@ typedef struct
 	Oid			indexOid;
 } RelToCluster;
 
+/*
+ * Parallel scan and sort.
+ *
+ * When CLUSTER scans and sorts the old heap, the scan can be done by
+ * parallel workers with the leader participating, each feeding the tuples
+ * it finds into its own "partial" tuplesort, the runs of which the leader
+ * then merges just like a parallel CREATE INDEX does.  Only the leader
+ * writes the new heap.
+ */
+#define PARALLEL_CLUSTER_KEY_SHARED			1
+#define PARALLEL_CLUSTER_KEY_TUPLESORT		2
+#define PARALLEL_CLUSTER_KEY_QUERY_TEXT		3
+
+/* Shared by the leader and the workers, in the DSM segment */
+typedef struct ClusterShared
+{
+	/* Immutable state */
+	Oid			heaprelid;
+	Oid			indexrelid;
+	TransactionId OldestXmin;
+	int			scantuplesortstates;
+
+	/* Workers signal the leader through this when they are done scanning */
+	ConditionVariable workersdonecv;
+
+	/* Mutable state, protected by mutex */
+	slock_t		mutex;
+	int			nparticipantsdone;
+	double		num_tuples;
+	double		tups_vacuumed;
+	double		tups_recently_dead;
+
+	/* Parallel scan of the old heap, with SnapshotAny (must come last) */
+	ParallelHeapScanDescData heapdesc;
+} ClusterShared;
+
+/* Leader's state of a parallel scan and sort */
+typedef struct ClusterLeader
+{
+	ParallelContext *pcxt;
+	int			nparticipanttuplesorts;
+	ClusterShared *shared;
+	Sharedsort *sharedsort;
+} ClusterLeader;
+
 
 static void rebuild_relation(Relation OldHeap, Oid indexOid, bool verbose);
 static void copy_heap_data(Oid OIDNewHeap, Oid OIDOldHeap, Oid OIDOldIndex,
@@ -76,6 +127,20 @@ static void reform_and_rewrite_tuple(HeapTuple tuple,
 						 TupleDesc oldTupDesc, TupleDesc newTupDesc,
 						 Datum *values, bool *isnull,
 						 RewriteState rwstate);
+static bool cluster_tuple_isdead(Relation OldHeap, HeapTuple tuple, Buffer buf,
+					 TransactionId OldestXmin, bool is_system_catalog,
+					 double *tups_recently_dead);
+static ClusterLeader *cluster_begin_parallel(Relation OldHeap,
+					   Relation OldIndex, TransactionId OldestXmin,
+					   int request);
+static void cluster_parallel_heapscan(ClusterLeader *clleader,
+						  double *num_tuples, double *tups_vacuumed,
+						  double *tups_recently_dead);
+static void cluster_end_parallel(ClusterLeader *clleader);
+static void cluster_parallel_scan_and_sort(Relation OldHeap,
+							   Relation OldIndex, ClusterShared *shared,
+							   Sharedsort *sharedsort, int sortmem,
+							   bool progress);
 
 
 /*---------------------------------------------------------------------------
@@ -275,6 +340,14 @@ cluster_rel(Oid tableOid, Oid indexOid, int options)
 	/* Check for user-requested abort. */
 	CHECK_FOR_INTERRUPTS();
 
+	pgstat_progress_start_command(PROGRESS_COMMAND_CLUSTER, tableOid);
+	if (OidIsValid(indexOid))
+		pgstat_progress_update_param(PROGRESS_CLUSTER_COMMAND,
+									 PROGRESS_CLUSTER_COMMAND_CLUSTER);
+	else
+		pgstat_progress_update_param(PROGRESS_CLUSTER_COMMAND,
+									 PROGRESS_CLUSTER_COMMAND_VACUUM_FULL);
+
 	/*
 	 * We grab exclusive access to the target rel and index for the duration
 	 * of the transaction.  (This is redundant for the single-transaction
@@ -285,7 +358,10 @@ cluster_rel(Oid tableOid, Oid indexOid, int options)
 
 	/* If the table has gone away, we can skip processing it */
 	if (!OldHeap)
+	{
+		pgstat_progress_end_command();
 		return;
+	}
 
 	/*
 	 * Since we may open a new transaction for each relation, we have to check
@@ -304,6 +380,7 @@ cluster_rel(Oid tableOid, Oid indexOid, int options)
 		if (!pg_class_ownercheck(tableOid, GetUserId()))
 		{
 			relation_close(OldHeap, AccessExclusiveLock);
+			pgstat_progress_end_command();
 			return;
 		}
 
@@ -318,6 +395,7 @@ cluster_rel(Oid tableOid, Oid indexOid, int options)
 		if (RELATION_IS_OTHER_TEMP(OldHeap))
 		{
 			relation_close(OldHeap, AccessExclusiveLock);
+			pgstat_progress_end_command();
 			return;
 		}
 
@@ -329,6 +407,7 @@ cluster_rel(Oid tableOid, Oid indexOid, int options)
 			if (!SearchSysCacheExists1(RELOID, ObjectIdGetDatum(indexOid)))
 			{
 				relation_close(OldHeap, AccessExclusiveLock);
+				pgstat_progress_end_command();
 				return;
 			}
 
@@ -339,6 +418,7 @@ cluster_rel(Oid tableOid, Oid indexOid, int options)
 			if (!HeapTupleIsValid(tuple))	/* probably can't happen */
 			{
 				relation_close(OldHeap, AccessExclusiveLock);
+				pgstat_progress_end_command();
 				return;
 			}
 			indexForm = (Form_pg_index) GETSTRUCT(tuple);
@@ -346,6 +426,7 @@ cluster_rel(Oid tableOid, Oid indexOid, int options)
 			{
 				ReleaseSysCache(tuple);
 				relation_close(OldHeap, AccessExclusiveLock);
+				pgstat_progress_end_command();
 				return;
 			}
 			ReleaseSysCache(tuple);
@@ -400,6 +481,7 @@ cluster_rel(Oid tableOid, Oid indexOid, int options)
 		!RelationIsPopulated(OldHeap))
 	{
 		relation_close(OldHeap, AccessExclusiveLock);
+		pgstat_progress_end_command();
 		return;
 	}
 
@@ -415,6 +497,8 @@ cluster_rel(Oid tableOid, Oid indexOid, int options)
 	rebuild_relation(OldHeap, indexOid, verbose);
 
 	/* NB: rebuild_relation does heap_close() on OldHeap */
+
+	pgstat_progress_end_command();
 }
 
 /*
@@ -682,6 +766,7 @@ make_new_heap(Oid OIDOldHeap, Oid NewTableSpace, char relpersistence,
 										  InvalidOid,
 										  InvalidOid,
 										  OldHeap->rd_rel->relowner,
+										  OldHeap->rd_rel->relam,
 										  OldHeapDesc,
 										  NIL,
 										  RELKIND_RELATION,
@@ -764,6 +849,7 @@ copy_heap_data(Oid OIDNewHeap, Oid OIDOldHeap, Oid OIDOldIndex, bool verbose,
 	bool	   *isnull;
 	IndexScanDesc indexScan;
 	HeapScanDesc heapScan;
+	BlockNumber prev_cblock = InvalidBlockNumber;
 	bool		use_wal;
 	bool		is_system_catalog;
 	TransactionId OldestXmin;
@@ -772,6 +858,7 @@ copy_heap_data(Oid OIDNewHeap, Oid OIDOldHeap, Oid OIDOldIndex, bool verbose,
 	RewriteState rwstate;
 	bool		use_sort;
 	Tuplesortstate *tuplesort;
+	ClusterLeader *clleader = NULL;
 	double		num_tuples = 0,
 				tups_vacuumed = 0,
 				tups_recently_dead = 0;
@@ -908,11 +995,38 @@ copy_heap_data(Oid OIDNewHeap, Oid OIDOldHeap, Oid OIDOldIndex, bool verbose,
 	else
 		use_sort = false;
 
-	/* Set up sorting if wanted */
+	/*
+	 * Set up sorting if wanted.  The scan and sort can be done by parallel
+	 * workers, if the planner thinks that worthwhile and it's safe; the
+	 * leader then only has to merge their sorted runs.  System catalogs are
+	 * always done serially.
+	 */
 	if (use_sort)
+	{
+		SortCoordinate coordinate = NULL;
+
+		if (!is_system_catalog)
+		{
+			int			nworkers;
+
+			nworkers = plan_create_index_workers(OIDOldHeap, OIDOldIndex);
+			if (nworkers > 0)
+				clleader = cluster_begin_parallel(OldHeap, OldIndex,
+												  OldestXmin, nworkers);
+		}
+
+		if (clleader != NULL)
+		{
+			coordinate = (SortCoordinate) palloc0(sizeof(SortCoordinateData));
+			coordinate->isWorker = false;
+			coordinate->nParticipants = clleader->nparticipanttuplesorts;
+			coordinate->sharedsort = clleader->sharedsort;
+		}
+
 		tuplesort = tuplesort_begin_cluster(oldTupDesc, OldIndex,
 											maintenance_work_mem,
-											NULL, false);
+											coordinate, false);
+	}
 	else
 		tuplesort = NULL;
 
@@ -923,14 +1037,42 @@ copy_heap_data(Oid OIDNewHeap, Oid OIDOldHeap, Oid OIDOldIndex, bool verbose,
 	 */
 	if (OldIndex != NULL && !use_sort)
 	{
+		const int	ci_index[] = {
+			PROGRESS_CLUSTER_PHASE,
+			PROGRESS_CLUSTER_INDEX_RELID
+		};
+		int64		ci_val[2];
+
+		/* Set phase and OIDOldIndex to columns */
+		ci_val[0] = PROGRESS_CLUSTER_PHASE_INDEX_SCAN_HEAP;
+		ci_val[1] = OIDOldIndex;
+		pgstat_progress_update_multi_param(2, ci_index, ci_val);
+
 		heapScan = NULL;
 		indexScan = index_beginscan(OldHeap, OldIndex, SnapshotAny, 0, 0);
 		index_rescan(indexScan, NULL, 0, NULL, 0);
 	}
+	else if (clleader != NULL)
+	{
+		/*
+		 * The participants are already scanning; cluster_begin_parallel has
+		 * set the phase and the total heap blocks.
+		 */
+		heapScan = NULL;
+		indexScan = NULL;
+	}
 	else
 	{
+		/* In scan-and-sort mode and also VACUUM FULL, set phase */
+		pgstat_progress_update_param(PROGRESS_CLUSTER_PHASE,
+									 PROGRESS_CLUSTER_PHASE_SEQ_SCAN_HEAP);
+
 		heapScan = heap_beginscan(OldHeap, SnapshotAny, 0, (ScanKey) NULL);
 		indexScan = NULL;
+
+		/* Set total heap blocks */
+		pgstat_progress_update_param(PROGRESS_CLUSTER_TOTAL_HEAP_BLKS,
+									 heapScan->rs_nblocks);
 	}
 
 	/* Log what we're doing */
@@ -940,6 +1082,12 @@ copy_heap_data(Oid OIDNewHeap, Oid OIDOldHeap, Oid OIDOldIndex, bool verbose,
 						get_namespace_name(RelationGetNamespace(OldHeap)),
 						RelationGetRelationName(OldHeap),
 						RelationGetRelationName(OldIndex))));
+	else if (clleader != NULL)
+		ereport(elevel,
+				(errmsg("clustering \"%s.%s\" using parallel sequential scan and sort with %d workers",
+						get_namespace_name(RelationGetNamespace(OldHeap)),
+						RelationGetRelationName(OldHeap),
+						clleader->pcxt->nworkers_launched)));
 	else if (tuplesort != NULL)
 		ereport(elevel,
 				(errmsg("clustering \"%s.%s\" using sequential scan and sort",
@@ -951,115 +1099,121 @@ copy_heap_data(Oid OIDNewHeap, Oid OIDOldHeap, Oid OIDOldIndex, bool verbose,
 						get_namespace_name(RelationGetNamespace(OldHeap)),
 						RelationGetRelationName(OldHeap))));
 
-	/*
-	 * Scan through the OldHeap, either in OldIndex order or sequentially;
-	 * copy each tuple into the NewHeap, or transiently to the tuplesort
-	 * module.  Note that we don't bother sorting dead tuples (they won't get
-	 * to the new table anyway).
-	 */
-	for (;;)
+	if (clleader != NULL)
 	{
-		HeapTuple	tuple;
-		Buffer		buf;
-		bool		isdead;
-
-		CHECK_FOR_INTERRUPTS();
-
-		if (indexScan != NULL)
+		/*
+		 * The participants of the parallel scan do what the loop below does
+		 * in the serial case, each into its own tuplesort.  Wait for them to
+		 * finish, and collect their counts.
+		 */
+		cluster_parallel_heapscan(clleader, &num_tuples, &tups_vacuumed,
+								  &tups_recently_dead);
+	}
+	else
+	{
+		/*
+		 * Scan through the OldHeap, either in OldIndex order or
+		 * sequentially; copy each tuple into the NewHeap, or transiently to
+		 * the tuplesort module.  Note that we don't bother sorting dead
+		 * tuples (they won't get to the new table anyway).
+		 */
+		for (;;)
 		{
-			tuple = index_getnext(indexScan, ForwardScanDirection);
-			if (tuple == NULL)
-				break;
-
-			/* Since we used no scan keys, should never need to recheck */
-			if (indexScan->xs_recheck)
-				elog(ERROR, "CLUSTER does not support lossy index conditions");
+			HeapTuple	tuple;
+			Buffer		buf;
+			bool		isdead;
 
-			buf = indexScan->xs_cbuf;
-		}
-		else
-		{
-			tuple = heap_getnext(heapScan, ForwardScanDirection);
-			if (tuple == NULL)
-				break;
+			CHECK_FOR_INTERRUPTS();
 
-			buf = heapScan->rs_cbuf;
-		}
+			if (indexScan != NULL)
+			{
+				tuple = index_getnext(indexScan, ForwardScanDirection);
+				if (tuple == NULL)
+					break;
 
-		LockBuffer(buf, BUFFER_LOCK_SHARE);
+				/* Since we used no scan keys, should never need to recheck */
+				if (indexScan->xs_recheck)
+					elog(ERROR, "CLUSTER does not support lossy index conditions");
 
-		switch (HeapTupleSatisfiesVacuum(tuple, OldestXmin, buf))
-		{
-			case HEAPTUPLE_DEAD:
-				/* Definitely dead */
-				isdead = true;
-				break;
-			case HEAPTUPLE_RECENTLY_DEAD:
-				tups_recently_dead += 1;
-				/* fall through */
-			case HEAPTUPLE_LIVE:
-				/* Live or recently dead, must copy it */
-				isdead = false;
-				break;
-			case HEAPTUPLE_INSERT_IN_PROGRESS:
+				buf = indexScan->xs_cbuf;
+			}
+			else
+			{
+				tuple = heap_getnext(heapScan, ForwardScanDirection);
+				if (tuple == NULL)
+				{
+					/* report that the whole table has been scanned */
+					pgstat_progress_update_param(PROGRESS_CLUSTER_HEAP_BLKS_SCANNED,
+												 heapScan->rs_nblocks);
+					break;
+				}
 
-				/*
-				 * Since we hold exclusive lock on the relation, normally the
-				 * only way to see this is if it was inserted earlier in our
-				 * own transaction.  However, it can happen in system
-				 * catalogs, since we tend to release write lock before commit
-				 * there.  Give a warning if neither case applies; but in any
-				 * case we had better copy it.
-				 */
-				if (!is_system_catalog &&
-					!TransactionIdIsCurrentTransactionId(HeapTupleHeaderGetXmin(tuple->t_data)))
-					elog(WARNING, "concurrent insert in progress within table \"%s\"",
-						 RelationGetRelationName(OldHeap));
-				/* treat as live */
-				isdead = false;
-				break;
-			case HEAPTUPLE_DELETE_IN_PROGRESS:
+				buf = heapScan->rs_cbuf;
 
 				/*
-				 * Similar situation to INSERT_IN_PROGRESS case.
+				 * In scan-and-sort mode and also VACUUM FULL, report the number
+				 * of blocks scanned so far.  A synchronized scan may not have
+				 * started at block 0.
 				 */
-				if (!is_system_catalog &&
-					!TransactionIdIsCurrentTransactionId(HeapTupleHeaderGetUpdateXid(tuple->t_data)))
-					elog(WARNING, "concurrent delete in progress within table \"%s\"",
-						 RelationGetRelationName(OldHeap));
-				/* treat as recently dead */
-				tups_recently_dead += 1;
-				isdead = false;
-				break;
-			default:
-				elog(ERROR, "unexpected HeapTupleSatisfiesVacuum result");
-				isdead = false; /* keep compiler quiet */
-				break;
-		}
+				if (prev_cblock != heapScan->rs_cblock)
+				{
+					pgstat_progress_update_param(PROGRESS_CLUSTER_HEAP_BLKS_SCANNED,
+												 (heapScan->rs_cblock +
+												  heapScan->rs_nblocks -
+												  heapScan->rs_startblock
+												  ) % heapScan->rs_nblocks + 1);
+					prev_cblock = heapScan->rs_cblock;
+				}
+			}
 
-		LockBuffer(buf, BUFFER_LOCK_UNLOCK);
+			isdead = cluster_tuple_isdead(OldHeap, tuple, buf, OldestXmin,
+										  is_system_catalog,
+										  &tups_recently_dead);
 
-		if (isdead)
-		{
-			tups_vacuumed += 1;
-			/* heap rewrite module still needs to see it... */
-			if (rewrite_heap_dead_tuple(rwstate, tuple))
+			if (isdead)
 			{
-				/* A previous recently-dead tuple is now known dead */
 				tups_vacuumed += 1;
-				tups_recently_dead -= 1;
+				/* heap rewrite module still needs to see it... */
+				if (rewrite_heap_dead_tuple(rwstate, tuple))
+				{
+					/* A previous recently-dead tuple is now known dead */
+					tups_vacuumed += 1;
+					tups_recently_dead -= 1;
+				}
+				continue;
 			}
-			continue;
-		}
 
-		num_tuples += 1;
-		if (tuplesort != NULL)
-			tuplesort_putheaptuple(tuplesort, tuple);
-		else
-			reform_and_rewrite_tuple(tuple,
-									 oldTupDesc, newTupDesc,
-									 values, isnull,
-									 rwstate);
+			num_tuples += 1;
+			if (tuplesort != NULL)
+			{
+				tuplesort_putheaptuple(tuplesort, tuple);
+
+				/* In scan-and-sort mode, report increase in number of tuples scanned */
+				pgstat_progress_update_param(PROGRESS_CLUSTER_HEAP_TUPLES_SCANNED,
+											 (int64) num_tuples);
+			}
+			else
+			{
+				const int	ct_index[] = {
+					PROGRESS_CLUSTER_HEAP_TUPLES_SCANNED,
+					PROGRESS_CLUSTER_HEAP_TUPLES_WRITTEN
+				};
+				int64		ct_val[2];
+
+				reform_and_rewrite_tuple(tuple,
+										 oldTupDesc, newTupDesc,
+										 values, isnull,
+										 rwstate);
+
+				/*
+				 * In indexscan mode and also VACUUM FULL, report increase in
+				 * number of tuples scanned and written
+				 */
+				ct_val[0] = (int64) num_tuples;
+				ct_val[1] = (int64) num_tuples;
+				pgstat_progress_update_multi_param(2, ct_index, ct_val);
+			}
+		}
 	}
 
 	if (indexScan != NULL)
@@ -1073,8 +1227,18 @@ copy_heap_data(Oid OIDNewHeap, Oid OIDOldHeap, Oid OIDOldIndex, bool verbose,
 	 */
 	if (tuplesort != NULL)
 	{
+		double		n_tuples = 0;
+
+		/* Report that we are now sorting tuples */
+		pgstat_progress_update_param(PROGRESS_CLUSTER_PHASE,
+									 PROGRESS_CLUSTER_PHASE_SORT_TUPLES);
+
 		tuplesort_performsort(tuplesort);
 
+		/* Report that we are now writing new heap */
+		pgstat_progress_update_param(PROGRESS_CLUSTER_PHASE,
+									 PROGRESS_CLUSTER_PHASE_WRITE_NEW_HEAP);
+
 		for (;;)
 		{
 			HeapTuple	tuple;
@@ -1085,13 +1249,21 @@ copy_heap_data(Oid OIDNewHeap, Oid OIDOldHeap, Oid OIDOldIndex, bool verbose,
 			if (tuple == NULL)
 				break;
 
+			n_tuples += 1;
 			reform_and_rewrite_tuple(tuple,
 									 oldTupDesc, newTupDesc,
 									 values, isnull,
 									 rwstate);
+			/* Report n_tuples */
+			pgstat_progress_update_param(PROGRESS_CLUSTER_HEAP_TUPLES_WRITTEN,
+										 (int64) n_tuples);
 		}
 
 		tuplesort_end(tuplesort);
+
+		/* The workers' runs were merged, so they can be let go */
+		if (clleader != NULL)
+			cluster_end_parallel(clleader);
 	}
 
 	/* Write out any remaining tuples, and fsync if needed */
@@ -1530,6 +1702,10 @@ finish_heap_swap(Oid OIDOldHeap, Oid OIDNewHeap,
 	/* Zero out possible results from swapped_relation_files */
 	memset(mapped_tables, 0, sizeof(mapped_tables));
 
+	/* Report that we are now swapping relation files */
+	pgstat_progress_update_param(PROGRESS_CLUSTER_PHASE,
+								 PROGRESS_CLUSTER_PHASE_SWAP_REL_FILES);
+
 	/*
 	 * Swap the contents of the heap relations (including any toast tables).
 	 * Also set old heap's relfrozenxid to frozenXid.
@@ -1574,8 +1750,16 @@ finish_heap_swap(Oid OIDOldHeap, Oid OIDNewHeap,
 	else if (newrelpersistence == RELPERSISTENCE_PERMANENT)
 		reindex_flags |= REINDEX_REL_FORCE_INDEXES_PERMANENT;
 
+	/* Report that we are now reindexing relations */
+	pgstat_progress_update_param(PROGRESS_CLUSTER_PHASE,
+								 PROGRESS_CLUSTER_PHASE_REBUILD_INDEX);
+
 	reindex_relation(OIDOldHeap, reindex_flags, 0);
 
+	/* Report that we are now doing clean up */
+	pgstat_progress_update_param(PROGRESS_CLUSTER_PHASE,
+								 PROGRESS_CLUSTER_PHASE_FINAL_CLEANUP);
+
 	/*
 	 * If the relation being rebuild is pg_class, swap_relation_files()
 	 * couldn't update pg_class's own pg_class entry (check comments in
@@ -1782,3 +1966,344 @@ reform_and_rewrite_tuple(HeapTuple tuple,
 
 	heap_freetuple(copiedTuple);
 }
+
+/*
+ * cluster_tuple_isdead - is a tuple of the old heap dead to CLUSTER?
+ *
+ * Runs HeapTupleSatisfiesVacuum on the tuple, which is on buffer buf, and
+ * decides whether it must be copied to the new heap; recently dead tuples
+ * that must be are also counted into *tups_recently_dead.
+ */
+static bool
+cluster_tuple_isdead(Relation OldHeap, HeapTuple tuple, Buffer buf,
+					 TransactionId OldestXmin, bool is_system_catalog,
+					 double *tups_recently_dead)
+{
+	bool		isdead;
+
+	LockBuffer(buf, BUFFER_LOCK_SHARE);
+
+	switch (HeapTupleSatisfiesVacuum(tuple, OldestXmin, buf))
+	{
+		case HEAPTUPLE_DEAD:
+			/* Definitely dead */
+			isdead = true;
+			break;
+		case HEAPTUPLE_RECENTLY_DEAD:
+			*tups_recently_dead += 1;
+			/* fall through */
+		case HEAPTUPLE_LIVE:
+			/* Live or recently dead, must copy it */
+			isdead = false;
+			break;
+		case HEAPTUPLE_INSERT_IN_PROGRESS:
+
+			/*
+			 * Since we hold exclusive lock on the relation, normally the
+			 * only way to see this is if it was inserted earlier in our
+			 * own transaction.  However, it can happen in system
+			 * catalogs, since we tend to release write lock before commit
+			 * there.  Give a warning if neither case applies; but in any
+			 * case we had better copy it.
+			 */
+			if (!is_system_catalog &&
+				!TransactionIdIsCurrentTransactionId(HeapTupleHeaderGetXmin(tuple->t_data)))
+				elog(WARNING, "concurrent insert in progress within table \"%s\"",
+					 RelationGetRelationName(OldHeap));
+			/* treat as live */
+			isdead = false;
+			break;
+		case HEAPTUPLE_DELETE_IN_PROGRESS:
+
+			/*
+			 * Similar situation to INSERT_IN_PROGRESS case.
+			 */
+			if (!is_system_catalog &&
+				!TransactionIdIsCurrentTransactionId(HeapTupleHeaderGetUpdateXid(tuple->t_data)))
+				elog(WARNING, "concurrent delete in progress within table \"%s\"",
+					 RelationGetRelationName(OldHeap));
+			/* treat as recently dead */
+			*tups_recently_dead += 1;
+			isdead = false;
+			break;
+		default:
+			elog(ERROR, "unexpected HeapTupleSatisfiesVacuum result");
+			isdead = false; /* keep compiler quiet */
+			break;
+	}
+
+	LockBuffer(buf, BUFFER_LOCK_UNLOCK);
+
+	return isdead;
+}
+
+/*
+ * cluster_begin_parallel - start a parallel scan and sort of the old heap
+ *
+ * request is the number of workers to ask for.  Launches them, takes part in
+ * the scan itself, and returns the state the leader needs to merge the
+ * sorted runs and eventually shut down parallel mode with
+ * cluster_end_parallel.  If not even a single worker could be launched,
+ * returns NULL, and the caller should proceed with a serial scan.
+ */
+static ClusterLeader *
+cluster_begin_parallel(Relation OldHeap, Relation OldIndex,
+					   TransactionId OldestXmin, int request)
+{
+	ParallelContext *pcxt;
+	ClusterShared *shared;
+	Sharedsort *sharedsort;
+	ClusterLeader *clleader;
+	int			scantuplesortstates = request + 1;
+	Size		estsort;
+	char	   *sharedquery;
+	int			querylen;
+
+	EnterParallelMode();
+	pcxt = CreateParallelContext("postgres", "cluster_parallel_scan_main",
+								 request, true);
+
+	/*
+	 * Estimate size for PARALLEL_CLUSTER_KEY_SHARED, which needs no space
+	 * for a snapshot since the parallel scan uses SnapshotAny, the shared
+	 * tuplesort state and the query text.
+	 */
+	shm_toc_estimate_chunk(&pcxt->estimator, sizeof(ClusterShared));
+	estsort = tuplesort_estimate_shared(scantuplesortstates);
+	shm_toc_estimate_chunk(&pcxt->estimator, estsort);
+	querylen = strlen(debug_query_string);
+	shm_toc_estimate_chunk(&pcxt->estimator, querylen + 1);
+	shm_toc_estimate_keys(&pcxt->estimator, 3);
+
+	InitializeParallelDSM(pcxt);
+
+	shared = (ClusterShared *) shm_toc_allocate(pcxt->toc,
+												sizeof(ClusterShared));
+	shared->heaprelid = RelationGetRelid(OldHeap);
+	shared->indexrelid = RelationGetRelid(OldIndex);
+	shared->OldestXmin = OldestXmin;
+	shared->scantuplesortstates = scantuplesortstates;
+	ConditionVariableInit(&shared->workersdonecv);
+	SpinLockInit(&shared->mutex);
+	shared->nparticipantsdone = 0;
+	shared->num_tuples = 0;
+	shared->tups_vacuumed = 0;
+	shared->tups_recently_dead = 0;
+	heap_parallelscan_initialize(&shared->heapdesc, OldHeap, SnapshotAny);
+	shm_toc_insert(pcxt->toc, PARALLEL_CLUSTER_KEY_SHARED, shared);
+
+	sharedsort = (Sharedsort *) shm_toc_allocate(pcxt->toc, estsort);
+	tuplesort_initialize_shared(sharedsort, scantuplesortstates, pcxt->seg);
+	shm_toc_insert(pcxt->toc, PARALLEL_CLUSTER_KEY_TUPLESORT, sharedsort);
+
+	sharedquery = (char *) shm_toc_allocate(pcxt->toc, querylen + 1);
+	memcpy(sharedquery, debug_query_string, querylen + 1);
+	shm_toc_insert(pcxt->toc, PARALLEL_CLUSTER_KEY_QUERY_TEXT, sharedquery);
+
+	LaunchParallelWorkers(pcxt);
+
+	clleader = (ClusterLeader *) palloc0(sizeof(ClusterLeader));
+	clleader->pcxt = pcxt;
+	clleader->nparticipanttuplesorts = pcxt->nworkers_launched + 1;
+	clleader->shared = shared;
+	clleader->sharedsort = sharedsort;
+
+	/* If no workers were successfully launched, back out (do serial scan) */
+	if (pcxt->nworkers_launched == 0)
+	{
+		cluster_end_parallel(clleader);
+		return NULL;
+	}
+
+	pgstat_progress_update_param(PROGRESS_CLUSTER_PHASE,
+								 PROGRESS_CLUSTER_PHASE_SEQ_SCAN_HEAP);
+	pgstat_progress_update_param(PROGRESS_CLUSTER_TOTAL_HEAP_BLKS,
+								 shared->heapdesc.phs_nblocks);
+
+	/* Join the scan ourselves, with our share of maintenance_work_mem */
+	cluster_parallel_scan_and_sort(OldHeap, OldIndex, shared, sharedsort,
+								   maintenance_work_mem /
+								   clleader->nparticipanttuplesorts,
+								   true);
+
+	/*
+	 * Caller needs to wait for all launched workers when we return.  Make
+	 * sure that the failure-to-start case will not hang forever.
+	 */
+	WaitForParallelWorkersToAttach(pcxt);
+
+	return clleader;
+}
+
+/*
+ * cluster_parallel_heapscan - within leader, wait for end of the heap scan
+ *
+ * Returns the participants' totals of the counts copy_heap_data reports.
+ */
+static void
+cluster_parallel_heapscan(ClusterLeader *clleader, double *num_tuples,
+						  double *tups_vacuumed, double *tups_recently_dead)
+{
+	ClusterShared *shared = clleader->shared;
+
+	for (;;)
+	{
+		SpinLockAcquire(&shared->mutex);
+		if (shared->nparticipantsdone == clleader->nparticipanttuplesorts)
+		{
+			*num_tuples = shared->num_tuples;
+			*tups_vacuumed = shared->tups_vacuumed;
+			*tups_recently_dead = shared->tups_recently_dead;
+			SpinLockRelease(&shared->mutex);
+			break;
+		}
+		SpinLockRelease(&shared->mutex);
+
+		ConditionVariableSleep(&shared->workersdonecv,
+							   WAIT_EVENT_PARALLEL_CLUSTER_SCAN);
+	}
+
+	ConditionVariableCancelSleep();
+
+	/* Report that the whole table has been scanned */
+	pgstat_progress_update_param(PROGRESS_CLUSTER_HEAP_BLKS_SCANNED,
+								 shared->heapdesc.phs_nblocks);
+	pgstat_progress_update_param(PROGRESS_CLUSTER_HEAP_TUPLES_SCANNED,
+								 (int64) *num_tuples);
+}
+
+/*
+ * cluster_end_parallel - shut down workers, destroy parallel context, and
+ * end parallel mode
+ */
+static void
+cluster_end_parallel(ClusterLeader *clleader)
+{
+	WaitForParallelWorkersToFinish(clleader->pcxt);
+	DestroyParallelContext(clleader->pcxt);
+	ExitParallelMode();
+	pfree(clleader);
+}
+
+/*
+ * cluster_parallel_scan_and_sort - a participant's part of the scan and sort
+ *
+ * Scans blocks of the old heap until the parallel scan runs out of them, and
+ * feeds the tuples to be copied into a "partial" tuplesort.  sortmem is the
+ * amount of working memory to use, in KBs.  progress is true in the leader,
+ * which reports the number of heap blocks scanned so far.
+ *
+ * Dead tuples are only counted.  A serial scan also passes them to
+ * rewrite_heap_dead_tuple, but in scan-and-sort mode no live tuple has been
+ * handed to the rewrite module yet at that point, so there are no update
+ * chains for that to resolve.
+ */
+static void
+cluster_parallel_scan_and_sort(Relation OldHeap, Relation OldIndex,
+							   ClusterShared *shared, Sharedsort *sharedsort,
+							   int sortmem, bool progress)
+{
+	SortCoordinate coordinate;
+	Tuplesortstate *tuplesort;
+	HeapScanDesc heapScan;
+	HeapTuple	tuple;
+	BlockNumber prev_cblock = InvalidBlockNumber;
+	double		num_tuples = 0,
+				tups_vacuumed = 0,
+				tups_recently_dead = 0;
+
+	coordinate = (SortCoordinate) palloc0(sizeof(SortCoordinateData));
+	coordinate->isWorker = true;
+	coordinate->nParticipants = -1;
+	coordinate->sharedsort = sharedsort;
+	tuplesort = tuplesort_begin_cluster(RelationGetDescr(OldHeap), OldIndex,
+										sortmem, coordinate, false);
+
+	heapScan = heap_beginscan_parallel(OldHeap, &shared->heapdesc);
+	while ((tuple = heap_getnext(heapScan, ForwardScanDirection)) != NULL)
+	{
+		CHECK_FOR_INTERRUPTS();
+
+		/*
+		 * Blocks are handed out in order, so the number handed out so far is
+		 * close enough to the number scanned.
+		 */
+		if (progress && prev_cblock != heapScan->rs_cblock)
+		{
+			uint64		nallocated;
+
+			nallocated = pg_atomic_read_u64(&shared->heapdesc.phs_nallocated);
+			pgstat_progress_update_param(PROGRESS_CLUSTER_HEAP_BLKS_SCANNED,
+										 Min(nallocated,
+											 shared->heapdesc.phs_nblocks));
+			prev_cblock = heapScan->rs_cblock;
+		}
+
+		/* System catalogs are never scanned in parallel */
+		if (cluster_tuple_isdead(OldHeap, tuple, heapScan->rs_cbuf,
+								 shared->OldestXmin, false,
+								 &tups_recently_dead))
+		{
+			tups_vacuumed += 1;
+			continue;
+		}
+
+		num_tuples += 1;
+		tuplesort_putheaptuple(tuplesort, tuple);
+	}
+	heap_endscan(heapScan);
+
+	/* Execute this participant's part of the sort */
+	tuplesort_performsort(tuplesort);
+
+	SpinLockAcquire(&shared->mutex);
+	shared->nparticipantsdone++;
+	shared->num_tuples += num_tuples;
+	shared->tups_vacuumed += tups_vacuumed;
+	shared->tups_recently_dead += tups_recently_dead;
+	SpinLockRelease(&shared->mutex);
+
+	/* Notify leader */
+	ConditionVariableBroadcast(&shared->workersdonecv);
+
+	/* We can end the tuplesort immediately */
+	tuplesort_end(tuplesort);
+}
+
+/*
+ * cluster_parallel_scan_main - perform work within a launched parallel
+ * process
+ */
+void
+cluster_parallel_scan_main(dsm_segment *seg, shm_toc *toc)
+{
+	char	   *sharedquery;
+	ClusterShared *shared;
+	Sharedsort *sharedsort;
+	Relation	OldHeap;
+	Relation	OldIndex;
+
+	/* Set debug_query_string for individual workers first */
+	sharedquery = shm_toc_lookup(toc, PARALLEL_CLUSTER_KEY_QUERY_TEXT, false);
+	debug_query_string = sharedquery;
+
+	/* Report the query string from leader */
+	pgstat_report_activity(STATE_RUNNING, debug_query_string);
+
+	shared = shm_toc_lookup(toc, PARALLEL_CLUSTER_KEY_SHARED, false);
+
+	/* Open relations using the lock mode the leader holds */
+	OldHeap = heap_open(shared->heaprelid, AccessExclusiveLock);
+	OldIndex = index_open(shared->indexrelid, AccessExclusiveLock);
+
+	sharedsort = shm_toc_lookup(toc, PARALLEL_CLUSTER_KEY_TUPLESORT, false);
+	tuplesort_attach_shared(sharedsort, seg);
+
+	cluster_parallel_scan_and_sort(OldHeap, OldIndex, shared, sharedsort,
+								   maintenance_work_mem /
+								   shared->scantuplesortstates,
+								   false);
+
+	index_close(OldIndex, AccessExclusiveLock);
+	heap_close(OldHeap, AccessExclusiveLock);
+}
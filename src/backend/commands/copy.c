@@ -20,17 +20,23 @@
 
 #include "access/heapam.h"
 #include "access/htup_details.h"
+#include "access/parallel.h"
 #include "access/sysattr.h"
+#include "access/tableam.h"
 #include "access/xact.h"
 #include "access/xlog.h"
 #include "catalog/dependency.h"
+#include "catalog/pg_am.h"
 #include "catalog/pg_authid.h"
+#include "catalog/pg_proc.h"
 #include "catalog/pg_type.h"
 #include "commands/copy.h"
 #include "commands/defrem.h"
+#include "commands/progress.h"
 #include "commands/trigger.h"
 #include "executor/execPartition.h"
 #include "executor/executor.h"
+#include "executor/nodeModifyTable.h"
 #include "executor/tuptable.h"
 #include "foreign/fdwapi.h"
 #include "libpq/libpq.h"
@@ -41,9 +47,13 @@
 #include "optimizer/planner.h"
 #include "nodes/makefuncs.h"
 #include "parser/parse_relation.h"
+#include "pgstat.h"
 #include "port/pg_bswap.h"
+#include "port/simd.h"
+#include "postmaster/bgworker_internals.h"
 #include "rewrite/rewriteHandler.h"
 #include "storage/fd.h"
+#include "storage/shm_mq.h"
 #include "tcop/tcopprot.h"
 #include "utils/builtins.h"
 #include "utils/lsyscache.h"
@@ -91,6 +101,58 @@ typedef enum CopyInsertMethod
 	CIM_MULTI_CONDITIONAL		/* use heap_multi_insert only if valid */
 } CopyInsertMethod;
 
+/*
+ * No more than this many tuples per CopyMultiInsertBuffer, and in total over
+ * all the buffers of a CopyMultiInsertInfo.
+ */
+#define MAX_BUFFERED_TUPLES		1000
+
+/*
+ * Flush the buffers if the tuples stored in them take up more than this many
+ * bytes, to avoid using large amounts of memory when the tuples are
+ * exceptionally wide.
+ */
+#define MAX_BUFFERED_BYTES		65535
+
+/*
+ * When copying into a partitioned table, keep at most this many partitions'
+ * buffers after a flush.  Each buffer holds a BulkInsertState, which keeps a
+ * heap page pinned.
+ */
+#define MAX_PARTITION_BUFFERS	32
+
+/*
+ * Tuples buffered for a heap_multi_insert() into one relation.
+ */
+typedef struct CopyMultiInsertBuffer
+{
+	HeapTuple	tuples[MAX_BUFFERED_TUPLES];	/* buffered tuples */
+	uint64		linenos[MAX_BUFFERED_TUPLES];	/* their input lines, for
+												 * error context */
+	ResultRelInfo *resultRelInfo;	/* relation the tuples go to */
+	BulkInsertState bistate;	/* BulkInsertState for this relation */
+	int			nused;			/* number of 'tuples' in use */
+} CopyMultiInsertBuffer;
+
+/*
+ * The multi-insert buffers of a COPY FROM.  There's a single buffer when
+ * copying into a plain table.  When copying into a partitioned table, there's
+ * one for each partition that tuples were recently routed to, so that input
+ * interleaving tuples of several partitions still gets inserted in batches.
+ * All the buffers are flushed together once enough tuples are buffered.
+ */
+typedef struct CopyMultiInsertInfo
+{
+	List	   *multiInsertBuffers; /* list of CopyMultiInsertBuffer */
+	int			bufferedTuples; /* number of tuples in all the buffers */
+	Size		bufferedBytes;	/* size of those tuples */
+	CopyState	cstate;			/* COPY state */
+	EState	   *estate;			/* executor state used for COPY */
+	CommandId	mycid;			/* command ID used for COPY */
+	int			hi_options;		/* heap insert options */
+	MemoryContext context;		/* holds the buffered tuples */
+} CopyMultiInsertInfo;
+
 /*
  * This struct contains all the state variables used throughout a COPY
  * operation. For simplicity, we use the same struct for all variants of COPY,
@@ -117,6 +179,7 @@ typedef struct CopyStateData
 	bool		is_copy_from;	/* COPY TO, or COPY FROM? */
 	bool		reached_eof;	/* true if we read to end of copy data (not
 								 * all copy_dest types maintain this) */
+	uint64		bytes_processed;	/* # of bytes read or written so far */
 	EolType		eol_type;		/* EOL type of input */
 	int			file_encoding;	/* file or remote side's character encoding */
 	bool		need_transcoding;	/* file encoding diff from server? */
@@ -149,6 +212,7 @@ typedef struct CopyStateData
 	bool		convert_selectively;	/* do selective binary conversion? */
 	List	   *convert_select; /* list of column names (can be NIL) */
 	bool	   *convert_select_flags;	/* per-column CSV/TEXT CS flags */
+	int			nworkers;		/* # of parallel workers requested */
 
 	/* these are just for error messages, see CopyFromErrorCallback */
 	const char *cur_relname;	/* table name for error messages */
@@ -178,8 +242,18 @@ typedef struct CopyStateData
 	int		   *defmap;			/* array of default att numbers */
 	ExprState **defexprs;		/* array of default att expressions */
 	bool		volatile_defexprs;	/* is any of defexprs volatile? */
+	bool		parallel_safe_defexprs; /* can defexprs run in parallel mode? */
 	List	   *range_table;
 
+	/*
+	 * Parallel COPY FROM: the column and option lists are kept so that the
+	 * workers can set up the same parsing state.  pcopy is set while the
+	 * workers are running.
+	 */
+	List	   *attnamelist;
+	List	   *options;
+	struct ParallelCopyState *pcopy;
+
 	TransitionCaptureState *transition_capture;
 
 	/*
@@ -229,6 +303,54 @@ typedef struct
 	uint64		processed;		/* # of tuples processed */
 } DR_copy;
 
+/*
+ * Parallel COPY FROM.
+ *
+ * The leader reads the input and splits it into lines, which it sends to
+ * the workers in chunks of about PARALLEL_COPY_CHUNK_SIZE bytes.  A chunk
+ * consists of the line number of its first line, followed by the lines,
+ * each preceded by its length as a uint32.  The workers split the lines
+ * into fields, run the input functions, and send the resulting tuples back
+ * as minimal tuples, preceded by their line number.  The leader computes
+ * defaults and does the insertion as in a serial COPY.
+ *
+ * Each worker has one queue for input and one for output, both in the
+ * PARALLEL_COPY_KEY_QUEUES area: worker i's input queue is the (2 * i)'th
+ * and its output queue the (2 * i + 1)'th.
+ */
+#define PARALLEL_COPY_KEY_SHARED		1
+#define PARALLEL_COPY_KEY_OPTIONS		2
+#define PARALLEL_COPY_KEY_ATTNAMES		3
+#define PARALLEL_COPY_KEY_QUEUES		4
+#define PARALLEL_COPY_KEY_QUERY_TEXT	5
+
+#define PARALLEL_COPY_CHUNK_SIZE	65536
+#define PARALLEL_COPY_QUEUE_SIZE	(4 * PARALLEL_COPY_CHUNK_SIZE)
+
+/* Shared by the leader and the workers, in the DSM segment */
+typedef struct ParallelCopyShared
+{
+	Oid			relid;			/* target relation */
+} ParallelCopyShared;
+
+/* Leader's private state, while the workers are running */
+typedef struct ParallelCopyState
+{
+	ParallelContext *pcxt;
+	int			nworkers;		/* # of workers launched */
+	shm_mq_handle **input_queues;	/* to each worker, NULL once detached */
+	shm_mq_handle **output_queues;	/* from each worker, NULL once detached */
+	uint64	   *nchunks_sent;	/* # of chunks sent to each worker */
+	int			noutputs;		/* # of output queues still attached */
+	int			next_input;		/* worker to send the next chunk to */
+	int			next_output;	/* worker to receive the next tuple from */
+	StringInfoData chunk;		/* chunk waiting to be sent */
+	bool		chunk_ready;	/* is chunk filled but not yet sent? */
+	bool		input_done;		/* all input sent, input queues detached? */
+	bool		reached_eof;	/* no more lines to read? */
+	uint64		read_lineno;	/* line number of the last line read */
+} ParallelCopyState;
+
 
 /*
  * These macros centralize code used to process line_buf and raw_buf buffers.
@@ -304,6 +426,7 @@ static CopyState BeginCopy(ParseState *pstate, bool is_from, Relation rel,
 		  List *options);
 static void EndCopy(CopyState cstate);
 static void ClosePipeToProgram(CopyState cstate);
+static void CopyStartProgress(CopyState cstate, int64 bytes_total);
 static CopyState BeginCopyTo(ParseState *pstate, Relation rel, RawStmt *query,
 			Oid queryRelId, const char *filename, bool is_program,
 			List *attnamelist, List *options);
@@ -312,12 +435,31 @@ static uint64 DoCopyTo(CopyState cstate);
 static uint64 CopyTo(CopyState cstate);
 static void CopyOneRowTo(CopyState cstate,
 			 Datum *values, bool *nulls);
-static void CopyFromInsertBatch(CopyState cstate, EState *estate,
-					CommandId mycid, int hi_options,
-					ResultRelInfo *resultRelInfo, TupleTableSlot *myslot,
-					BulkInsertState bistate,
-					int nBufferedTuples, HeapTuple *bufferedTuples,
-					uint64 firstBufferedLineNo);
+static void CopyMultiInsertInfoInit(CopyMultiInsertInfo *miinfo,
+						ResultRelInfo *rri, CopyState cstate,
+						EState *estate, CommandId mycid, int hi_options);
+static void CopyMultiInsertInfoSetupBuffer(CopyMultiInsertInfo *miinfo,
+							   ResultRelInfo *rri);
+static void CopyMultiInsertInfoStore(CopyMultiInsertInfo *miinfo,
+						 ResultRelInfo *rri, HeapTuple tuple,
+						 uint64 lineno);
+static void CopyMultiInsertInfoFlush(CopyMultiInsertInfo *miinfo,
+						 ResultRelInfo *curr_rri, TupleTableSlot *myslot);
+static void CopyMultiInsertInfoCleanup(CopyMultiInsertInfo *miinfo);
+static void CopyMultiInsertBufferFlush(CopyMultiInsertInfo *miinfo,
+						   CopyMultiInsertBuffer *buffer,
+						   TupleTableSlot *myslot);
+static void CopyMultiInsertBufferCleanup(CopyMultiInsertBuffer *buffer);
+static void CopyConvertFields(CopyState cstate, char **field_strings,
+				  int fldct, Datum *values, bool *nulls);
+static bool CopyFromParallelSafe(CopyState cstate);
+static void BeginParallelCopy(CopyState cstate);
+static void EndParallelCopy(CopyState cstate);
+static bool ParallelCopyFillChunk(CopyState cstate);
+static bool ParallelCopySendInput(CopyState cstate);
+static bool CopyReadParallelTuple(CopyState cstate, Datum *values, bool *nulls);
+static void ParallelCopyLostWorker(ParallelCopyState *pcopy);
+static int	ParallelCopyNoData(void *outbuf, int minread, int maxread);
 static bool CopyReadLine(CopyState cstate);
 static bool CopyReadLineText(CopyState cstate);
 static int	CopyReadAttributesText(CopyState cstate);
@@ -546,6 +688,10 @@ CopySendEndOfRow(CopyState cstate)
 			break;
 	}
 
+	cstate->bytes_processed += fe_msgbuf->len;
+	pgstat_progress_update_param(PROGRESS_COPY_BYTES_PROCESSED,
+								 cstate->bytes_processed);
+
 	resetStringInfo(fe_msgbuf);
 }
 
@@ -665,6 +811,10 @@ CopyGetData(CopyState cstate, void *databuf, int minread, int maxread)
 			break;
 	}
 
+	cstate->bytes_processed += bytesread;
+	pgstat_progress_update_param(PROGRESS_COPY_BYTES_PROCESSED,
+								 cstate->bytes_processed);
+
 	return bytesread;
 }
 
@@ -1208,6 +1358,22 @@ ProcessCopyOptions(ParseState *pstate,
 								defel->defname),
 						 parser_errposition(pstate, defel->location)));
 		}
+		else if (strcmp(defel->defname, "parallel") == 0)
+		{
+			if (cstate->nworkers > 0)
+				ereport(ERROR,
+						(errcode(ERRCODE_SYNTAX_ERROR),
+						 errmsg("conflicting or redundant options"),
+						 parser_errposition(pstate, defel->location)));
+			cstate->nworkers = defGetInt32(defel);
+			if (cstate->nworkers < 0 ||
+				cstate->nworkers > MAX_PARALLEL_WORKER_LIMIT)
+				ereport(ERROR,
+						(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+						 errmsg("argument to option \"%s\" must be between 0 and %d",
+								defel->defname, MAX_PARALLEL_WORKER_LIMIT),
+						 parser_errposition(pstate, defel->location)));
+		}
 		else if (strcmp(defel->defname, "encoding") == 0)
 		{
 			if (cstate->file_encoding >= 0)
@@ -1361,6 +1527,16 @@ ProcessCopyOptions(ParseState *pstate,
 				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
 				 errmsg("COPY force null only available using COPY FROM")));
 
+	/* Check parallel */
+	if (cstate->nworkers > 0 && !is_from)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("COPY PARALLEL only available using COPY FROM")));
+	if (cstate->nworkers > 0 && cstate->binary)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("COPY PARALLEL not available in BINARY mode")));
+
 	/* Don't allow the delimiter to appear in the null string. */
 	if (strchr(cstate->null_print, cstate->delim[0]) != NULL)
 		ereport(ERROR,
@@ -1512,7 +1688,8 @@ BeginCopy(ParseState *pstate,
 		}
 
 		/* plan the query */
-		plan = pg_plan_query(query, CURSOR_OPT_PARALLEL_OK, NULL);
+		plan = pg_plan_query(query, pstate->p_sourcetext,
+							 CURSOR_OPT_PARALLEL_OK, NULL);
 
 		/*
 		 * With row level security and a user using "COPY relation TO", we
@@ -1734,6 +1911,9 @@ ClosePipeToProgram(CopyState cstate)
 static void
 EndCopy(CopyState cstate)
 {
+	if (!IsParallelWorker())
+		pgstat_progress_end_command();
+
 	if (cstate->is_program)
 	{
 		ClosePipeToProgram(cstate);
@@ -1751,6 +1931,55 @@ EndCopy(CopyState cstate)
 	pfree(cstate);
 }
 
+/*
+ * Start reporting the command's progress; called once the source or
+ * destination has been opened.  bytes_total is the size of the input file,
+ * or 0 if not known.
+ *
+ * Parallel workers don't report: the leader reads all the input and inserts
+ * all the rows, so its counters already cover the whole command.
+ */
+static void
+CopyStartProgress(CopyState cstate, int64 bytes_total)
+{
+	const int	index[] = {
+		PROGRESS_COPY_COMMAND,
+		PROGRESS_COPY_TYPE,
+		PROGRESS_COPY_BYTES_TOTAL
+	};
+	int64		val[3];
+
+	if (IsParallelWorker())
+		return;
+
+	pgstat_progress_start_command(PROGRESS_COMMAND_COPY,
+								  cstate->rel ? RelationGetRelid(cstate->rel) :
+								  InvalidOid);
+
+	val[0] = cstate->is_copy_from ? PROGRESS_COPY_COMMAND_FROM :
+		PROGRESS_COPY_COMMAND_TO;
+	switch (cstate->copy_dest)
+	{
+		case COPY_FILE:
+			if (cstate->is_program)
+				val[1] = PROGRESS_COPY_TYPE_PROGRAM;
+			else if (cstate->filename != NULL)
+				val[1] = PROGRESS_COPY_TYPE_FILE;
+			else
+				val[1] = PROGRESS_COPY_TYPE_PIPE;	/* stdin/stdout */
+			break;
+		case COPY_OLD_FE:
+		case COPY_NEW_FE:
+			val[1] = PROGRESS_COPY_TYPE_PIPE;
+			break;
+		case COPY_CALLBACK:
+			val[1] = PROGRESS_COPY_TYPE_CALLBACK;
+			break;
+	}
+	val[2] = bytes_total;
+	pgstat_progress_update_multi_param(3, index, val);
+}
+
 /*
  * Setup CopyState to read tuples from a table or a query for COPY TO.
  */
@@ -1883,6 +2112,8 @@ BeginCopyTo(ParseState *pstate,
 		}
 	}
 
+	CopyStartProgress(cstate, 0);
+
 	MemoryContextSwitchTo(oldcontext);
 
 	return cstate;
@@ -2065,7 +2296,8 @@ CopyTo(CopyState cstate)
 
 			/* Format and send the data */
 			CopyOneRowTo(cstate, values, nulls);
-			processed++;
+			pgstat_progress_update_param(PROGRESS_COPY_TUPLES_PROCESSED,
+										 ++processed);
 		}
 
 		heap_endscan(scandesc);
@@ -2297,27 +2529,18 @@ CopyFrom(CopyState cstate)
 	MemoryContext oldcontext = CurrentMemoryContext;
 
 	PartitionTupleRouting *proute = NULL;
-	ExprContext *secondaryExprContext = NULL;
 	ErrorContextCallback errcallback;
 	CommandId	mycid = GetCurrentCommandId(true);
 	int			hi_options = 0; /* start with default heap_insert options */
 	BulkInsertState bistate;
 	CopyInsertMethod insertMethod;
+	CopyMultiInsertInfo multiInsertInfo = {0};	/* pacify compiler */
 	uint64		processed = 0;
-	int			nBufferedTuples = 0;
+	ListCell   *lc;
 	bool		has_before_insert_row_trig;
 	bool		has_instead_insert_row_trig;
 	bool		leafpart_use_multi_insert = false;
 
-#define MAX_BUFFERED_TUPLES 1000
-#define RECHECK_MULTI_INSERT_THRESHOLD 1000
-	HeapTuple  *bufferedTuples = NULL;	/* initialize to silence warning */
-	Size		bufferedTuplesSize = 0;
-	uint64		firstBufferedLineNo = 0;
-	uint64		lastPartitionSampleLineNo = 0;
-	uint64		nPartitionChanges = 0;
-	double		avgTuplesPerPartChange = 0;
-
 	Assert(cstate->rel);
 
 	/*
@@ -2509,8 +2732,11 @@ CopyFrom(CopyState cstate)
 
 	if (resultRelInfo->ri_FdwRoutine != NULL &&
 		resultRelInfo->ri_FdwRoutine->BeginForeignInsert != NULL)
+	{
 		resultRelInfo->ri_FdwRoutine->BeginForeignInsert(mtstate,
 														 resultRelInfo);
+		ExecSetForeignInsertBatchSize(resultRelInfo);
+	}
 
 	/* Prepare to catch AFTER triggers. */
 	AfterTriggerBeginQuery();
@@ -2560,8 +2786,8 @@ CopyFrom(CopyState cstate)
 		 * For partitioned tables we can't support multi-inserts when there
 		 * are any statement level insert triggers. It might be possible to
 		 * allow partitioned tables with such triggers in the future, but for
-		 * now, CopyFromInsertBatch expects that any before row insert and
-		 * statement level insert triggers are on the same relation.
+		 * now, CopyMultiInsertBufferFlush expects that any before row insert
+		 * and statement level insert triggers are on the same relation.
 		 */
 		insertMethod = CIM_SINGLE;
 	}
@@ -2580,12 +2806,20 @@ CopyFrom(CopyState cstate)
 		 */
 		insertMethod = CIM_SINGLE;
 	}
+	else if (proute == NULL &&
+			 cstate->rel->rd_rel->relam != HEAP_TABLE_AM_OID)
+	{
+		/*
+		 * The table access method API has no multi-insert callback yet, so
+		 * only heap tables can use heap_multi_insert.
+		 */
+		insertMethod = CIM_SINGLE;
+	}
 	else
 	{
 		/*
 		 * For partitioned tables, we may still be able to perform bulk
-		 * inserts for sets of consecutive tuples which belong to the same
-		 * partition.  However, the possibility of this depends on which types
+		 * inserts.  However, the possibility of this depends on which types
 		 * of triggers exist on the partition.  We must disable bulk inserts
 		 * if the partition is a foreign table or it has any before row insert
 		 * or insert instead triggers (same as we checked above for the parent
@@ -2595,27 +2829,18 @@ CopyFrom(CopyState cstate)
 		 * flag that we must later determine if we can use bulk-inserts for
 		 * the partition being inserted into.
 		 *
-		 * Normally, when performing bulk inserts we just flush the insert
-		 * buffer whenever it becomes full, but for the partitioned table
-		 * case, we flush it whenever the current tuple does not belong to the
-		 * same partition as the previous tuple, and since we flush the
-		 * previous partition's buffer once the new tuple has already been
-		 * built, we're unable to reset the estate since we'd free the memory
-		 * in which the new tuple is stored.  To work around this we maintain
-		 * a secondary expression context and alternate between these when the
-		 * partition changes.  This does mean we do store the first new tuple
-		 * in a different context than subsequent tuples, but that does not
-		 * matter, providing we don't free anything while it's still needed.
+		 * Each partition that can use bulk inserts gets its own buffer, and
+		 * all the buffers are flushed together when they hold enough tuples,
+		 * so input that goes back and forth between partitions is still
+		 * inserted in batches.
 		 */
 		if (proute)
-		{
 			insertMethod = CIM_MULTI_CONDITIONAL;
-			secondaryExprContext = CreateExprContext(estate);
-		}
 		else
 			insertMethod = CIM_MULTI;
 
-		bufferedTuples = palloc(MAX_BUFFERED_TUPLES * sizeof(HeapTuple));
+		CopyMultiInsertInfoInit(&multiInsertInfo, resultRelInfo, cstate,
+								estate, mycid, hi_options);
 	}
 
 	has_before_insert_row_trig = (resultRelInfo->ri_TrigDesc &&
@@ -2638,6 +2863,10 @@ CopyFrom(CopyState cstate)
 	bistate = GetBulkInsertState();
 	econtext = GetPerTupleExprContext(estate);
 
+	/* Hand the parsing of the input over to parallel workers, if possible */
+	if (cstate->nworkers > 0)
+		BeginParallelCopy(cstate);
+
 	/* Set up callback to identify error line number */
 	errcallback.callback = CopyFromErrorCallback;
 	errcallback.arg = (void *) cstate;
@@ -2651,15 +2880,11 @@ CopyFrom(CopyState cstate)
 
 		CHECK_FOR_INTERRUPTS();
 
-		if (nBufferedTuples == 0)
-		{
-			/*
-			 * Reset the per-tuple exprcontext. We can only do this if the
-			 * tuple buffer is empty. (Calling the context the per-tuple
-			 * memory context is a bit of a misnomer now.)
-			 */
-			ResetPerTupleExprContext(estate);
-		}
+		/*
+		 * Reset the per-tuple exprcontext.  Buffered tuples are copied into
+		 * the multi-insert memory context, so this is always safe.
+		 */
+		ResetPerTupleExprContext(estate);
 
 		/* Switch into its memory context */
 		MemoryContextSwitchTo(GetPerTupleMemoryContext(estate));
@@ -2698,76 +2923,6 @@ CopyFrom(CopyState cstate)
 
 			if (prevResultRelInfo != resultRelInfo)
 			{
-				/* Check if we can multi-insert into this partition */
-				if (insertMethod == CIM_MULTI_CONDITIONAL)
-				{
-					/*
-					 * When performing bulk-inserts into partitioned tables we
-					 * must insert the tuples seen so far to the heap whenever
-					 * the partition changes.
-					 */
-					if (nBufferedTuples > 0)
-					{
-						ExprContext *swapcontext;
-
-						CopyFromInsertBatch(cstate, estate, mycid, hi_options,
-											prevResultRelInfo, myslot, bistate,
-											nBufferedTuples, bufferedTuples,
-											firstBufferedLineNo);
-						nBufferedTuples = 0;
-						bufferedTuplesSize = 0;
-
-						Assert(secondaryExprContext);
-
-						/*
-						 * Normally we reset the per-tuple context whenever
-						 * the bufferedTuples array is empty at the beginning
-						 * of the loop, however, it is possible since we flush
-						 * the buffer here that the buffer is never empty at
-						 * the start of the loop.  To prevent the per-tuple
-						 * context from never being reset we maintain a second
-						 * context and alternate between them when the
-						 * partition changes.  We can now reset
-						 * secondaryExprContext as this is no longer needed,
-						 * since we just flushed any tuples stored in it.  We
-						 * also now switch over to the other context.  This
-						 * does mean that the first tuple in the buffer won't
-						 * be in the same context as the others, but that does
-						 * not matter since we only reset it after the flush.
-						 */
-						ReScanExprContext(secondaryExprContext);
-
-						swapcontext = secondaryExprContext;
-						secondaryExprContext = estate->es_per_tuple_exprcontext;
-						estate->es_per_tuple_exprcontext = swapcontext;
-					}
-
-					nPartitionChanges++;
-
-					/*
-					 * Here we adaptively enable multi-inserts based on the
-					 * average number of tuples from recent multi-insert
-					 * batches.  We recalculate the average every
-					 * RECHECK_MULTI_INSERT_THRESHOLD tuples instead of taking
-					 * the average over the whole copy.  This allows us to
-					 * enable multi-inserts when we get periods in the copy
-					 * stream that have tuples commonly belonging to the same
-					 * partition, and disable when the partition is changing
-					 * too often.
-					 */
-					if (unlikely(lastPartitionSampleLineNo <= (cstate->cur_lineno -
-															   RECHECK_MULTI_INSERT_THRESHOLD)
-								 && cstate->cur_lineno >= RECHECK_MULTI_INSERT_THRESHOLD))
-					{
-						avgTuplesPerPartChange =
-							(cstate->cur_lineno - lastPartitionSampleLineNo) /
-							(double) nPartitionChanges;
-
-						lastPartitionSampleLineNo = cstate->cur_lineno;
-						nPartitionChanges = 0;
-					}
-				}
-
 				/* Determine which triggers exist on this partition */
 				has_before_insert_row_trig = (resultRelInfo->ri_TrigDesc &&
 											  resultRelInfo->ri_TrigDesc->trig_insert_before_row);
@@ -2776,17 +2931,34 @@ CopyFrom(CopyState cstate)
 											   resultRelInfo->ri_TrigDesc->trig_insert_instead_row);
 
 				/*
-				 * Tests have shown that using multi-inserts when the
-				 * partition changes on every tuple slightly decreases the
-				 * performance, however, there are benefits even when only
-				 * some batches have just 2 tuples, so let's enable
-				 * multi-inserts even when the average is quite low.
+				 * Disable multi-inserts when the partition has BEFORE/INSTEAD
+				 * OF triggers, or if the partition is a foreign partition or
+				 * not a heap.
 				 */
 				leafpart_use_multi_insert = insertMethod == CIM_MULTI_CONDITIONAL &&
-					avgTuplesPerPartChange >= 1.3 &&
 					!has_before_insert_row_trig &&
 					!has_instead_insert_row_trig &&
-					resultRelInfo->ri_FdwRoutine == NULL;
+					resultRelInfo->ri_FdwRoutine == NULL &&
+					resultRelInfo->ri_RelationDesc->rd_rel->relam == HEAP_TABLE_AM_OID;
+
+				/* Set up the multi-insert buffer to use for this partition */
+				if (leafpart_use_multi_insert)
+				{
+					if (resultRelInfo->ri_CopyMultiInsertBuffer == NULL)
+						CopyMultiInsertInfoSetupBuffer(&multiInsertInfo,
+													   resultRelInfo);
+				}
+				else if (insertMethod == CIM_MULTI_CONDITIONAL &&
+						 multiInsertInfo.bufferedTuples > 0)
+				{
+					/*
+					 * Flush pending inserts if this partition can't use
+					 * batching, so that the rows are visible to its triggers
+					 * and in the order of the input.
+					 */
+					CopyMultiInsertInfoFlush(&multiInsertInfo, resultRelInfo,
+											 myslot);
+				}
 
 				/*
 				 * We'd better make the bulk insert mechanism gets a new
@@ -2903,28 +3075,29 @@ CopyFrom(CopyState cstate)
 				 */
 				if (insertMethod == CIM_MULTI || leafpart_use_multi_insert)
 				{
-					/* Add this tuple to the tuple buffer */
-					if (nBufferedTuples == 0)
-						firstBufferedLineNo = cstate->cur_lineno;
-					bufferedTuples[nBufferedTuples++] = tuple;
-					bufferedTuplesSize += tuple->t_len;
+					/* Add this tuple to the partition's tuple buffer */
+					CopyMultiInsertInfoStore(&multiInsertInfo, resultRelInfo,
+											 tuple, cstate->cur_lineno);
 
 					/*
-					 * If the buffer filled up, flush it.  Also flush if the
-					 * total size of all the tuples in the buffer becomes
-					 * large, to avoid using large amounts of memory for the
-					 * buffer when the tuples are exceptionally wide.
+					 * If enough tuples have been buffered, over all the
+					 * buffers, flush them all.
 					 */
-					if (nBufferedTuples == MAX_BUFFERED_TUPLES ||
-						bufferedTuplesSize > 65535)
-					{
-						CopyFromInsertBatch(cstate, estate, mycid, hi_options,
-											resultRelInfo, myslot, bistate,
-											nBufferedTuples, bufferedTuples,
-											firstBufferedLineNo);
-						nBufferedTuples = 0;
-						bufferedTuplesSize = 0;
-					}
+					if (multiInsertInfo.bufferedTuples >= MAX_BUFFERED_TUPLES ||
+						multiInsertInfo.bufferedBytes > MAX_BUFFERED_BYTES)
+						CopyMultiInsertInfoFlush(&multiInsertInfo,
+												 resultRelInfo, myslot);
+				}
+				else if (resultRelInfo->ri_FdwRoutine != NULL &&
+						 ExecForeignInsertCanBatch(mtstate, resultRelInfo))
+				{
+					/*
+					 * Queue the tuple up for the FDW, which takes them a
+					 * batch at a time.  Tuples of a full batch the FDW did
+					 * not insert after all don't count as processed.
+					 */
+					processed -= ExecForeignInsertBuffer(mtstate, resultRelInfo,
+														 slot, NULL);
 				}
 				else
 				{
@@ -2952,8 +3125,9 @@ CopyFrom(CopyState cstate)
 						tuple->t_tableOid = RelationGetRelid(resultRelInfo->ri_RelationDesc);
 					}
 					else
-						heap_insert(resultRelInfo->ri_RelationDesc, tuple,
-									mycid, hi_options, bistate);
+						table_tuple_insert(resultRelInfo->ri_RelationDesc, slot,
+										   mycid, hi_options, bistate,
+										   &(tuple->t_self));
 
 					/* And create index entries for it */
 					if (resultRelInfo->ri_NumIndices > 0)
@@ -2962,7 +3136,8 @@ CopyFrom(CopyState cstate)
 															   estate,
 															   false,
 															   NULL,
-															   NIL);
+															   NIL,
+															   false);
 
 					/* AFTER ROW INSERT Triggers */
 					ExecARInsertTriggers(estate, resultRelInfo, tuple,
@@ -2977,27 +3152,29 @@ CopyFrom(CopyState cstate)
 			 * or FDW; this is the same definition used by nodeModifyTable.c
 			 * for counting tuples inserted by an INSERT command.
 			 */
-			processed++;
+			pgstat_progress_update_param(PROGRESS_COPY_TUPLES_PROCESSED,
+										 ++processed);
 		}
 	}
 
 	/* Flush any remaining buffered tuples */
-	if (nBufferedTuples > 0)
+	if (insertMethod != CIM_SINGLE)
 	{
-		if (insertMethod == CIM_MULTI_CONDITIONAL)
-		{
-			CopyFromInsertBatch(cstate, estate, mycid, hi_options,
-								prevResultRelInfo, myslot, bistate,
-								nBufferedTuples, bufferedTuples,
-								firstBufferedLineNo);
-		}
-		else
-			CopyFromInsertBatch(cstate, estate, mycid, hi_options,
-								resultRelInfo, myslot, bistate,
-								nBufferedTuples, bufferedTuples,
-								firstBufferedLineNo);
+		if (multiInsertInfo.bufferedTuples > 0)
+			CopyMultiInsertInfoFlush(&multiInsertInfo, NULL, myslot);
+
+		/* Tear down the multi-insert buffer data */
+		CopyMultiInsertInfoCleanup(&multiInsertInfo);
 	}
 
+	/* Likewise any tuples still queued for batched foreign inserts */
+	foreach(lc, mtstate->mt_batchrels)
+		processed -= ExecForeignInsertFlush(mtstate,
+											(ResultRelInfo *) lfirst(lc));
+
+	if (cstate->pcopy)
+		EndParallelCopy(cstate);
+
 	/* Done, clean up */
 	error_context_stack = errcallback.previous;
 
@@ -3051,18 +3228,164 @@ CopyFrom(CopyState cstate)
 }
 
 /*
- * A subroutine of CopyFrom, to write the current batch of buffered heap
- * tuples to the heap. Also updates indexes and runs AFTER ROW INSERT
- * triggers.
+ * Set up the multi-insert state of a CopyFrom.  When copying into a plain
+ * table, its buffer is set up right away; partitions get theirs as tuples are
+ * first routed to them.
+ */
+static void
+CopyMultiInsertInfoInit(CopyMultiInsertInfo *miinfo, ResultRelInfo *rri,
+						CopyState cstate, EState *estate, CommandId mycid,
+						int hi_options)
+{
+	miinfo->multiInsertBuffers = NIL;
+	miinfo->bufferedTuples = 0;
+	miinfo->bufferedBytes = 0;
+	miinfo->cstate = cstate;
+	miinfo->estate = estate;
+	miinfo->mycid = mycid;
+	miinfo->hi_options = hi_options;
+	miinfo->context = AllocSetContextCreate(CurrentMemoryContext,
+											"COPY multi-insert tuples",
+											ALLOCSET_DEFAULT_SIZES);
+
+	/*
+	 * Only set up the buffer when not inserting into a partitioned table.
+	 * Buffers for partitioned tables will just be set up when we need to
+	 * send tuples their way for the first time.
+	 */
+	if (rri->ri_RelationDesc->rd_rel->relkind != RELKIND_PARTITIONED_TABLE)
+		CopyMultiInsertInfoSetupBuffer(miinfo, rri);
+}
+
+/*
+ * Make a new buffer for tuples going to 'rri', and track it in 'miinfo'.
+ */
+static void
+CopyMultiInsertInfoSetupBuffer(CopyMultiInsertInfo *miinfo,
+							   ResultRelInfo *rri)
+{
+	CopyMultiInsertBuffer *buffer;
+
+	Assert(rri->ri_CopyMultiInsertBuffer == NULL);
+
+	buffer = (CopyMultiInsertBuffer *) palloc(sizeof(CopyMultiInsertBuffer));
+	buffer->resultRelInfo = rri;
+	buffer->bistate = GetBulkInsertState();
+	buffer->nused = 0;
+
+	rri->ri_CopyMultiInsertBuffer = buffer;
+	miinfo->multiInsertBuffers = lappend(miinfo->multiInsertBuffers, buffer);
+}
+
+/*
+ * Add a copy of 'tuple', read from input line 'lineno', to the buffer of
+ * 'rri'.  The caller must flush the buffers when they hold enough tuples,
+ * which also guarantees that no single buffer overflows.
+ */
+static void
+CopyMultiInsertInfoStore(CopyMultiInsertInfo *miinfo, ResultRelInfo *rri,
+						 HeapTuple tuple, uint64 lineno)
+{
+	CopyMultiInsertBuffer *buffer = rri->ri_CopyMultiInsertBuffer;
+	MemoryContext oldcontext;
+
+	Assert(buffer != NULL);
+	Assert(buffer->nused < MAX_BUFFERED_TUPLES);
+
+	oldcontext = MemoryContextSwitchTo(miinfo->context);
+	buffer->tuples[buffer->nused] = heap_copytuple(tuple);
+	MemoryContextSwitchTo(oldcontext);
+
+	buffer->linenos[buffer->nused] = lineno;
+	buffer->nused++;
+
+	miinfo->bufferedTuples++;
+	miinfo->bufferedBytes += tuple->t_len;
+}
+
+/*
+ * Write out all the buffered tuples, then forget the buffers beyond
+ * MAX_PARTITION_BUFFERS.  'curr_rri' is the relation that the current tuple
+ * goes to, whose buffer is kept in any case; it may be NULL.
+ */
+static void
+CopyMultiInsertInfoFlush(CopyMultiInsertInfo *miinfo, ResultRelInfo *curr_rri,
+						 TupleTableSlot *myslot)
+{
+	ListCell   *lc;
+
+	foreach(lc, miinfo->multiInsertBuffers)
+	{
+		CopyMultiInsertBuffer *buffer = (CopyMultiInsertBuffer *) lfirst(lc);
+
+		if (buffer->nused > 0)
+			CopyMultiInsertBufferFlush(miinfo, buffer, myslot);
+	}
+
+	miinfo->bufferedTuples = 0;
+	miinfo->bufferedBytes = 0;
+	MemoryContextReset(miinfo->context);
+
+	/*
+	 * Trim the list of tracked buffers down if it's getting long, dropping
+	 * the ones that were set up earliest.  Those are likely to be for
+	 * partitions that we're not inserting into anymore, if the input is
+	 * ordered in some way.
+	 */
+	while (list_length(miinfo->multiInsertBuffers) > MAX_PARTITION_BUFFERS)
+	{
+		CopyMultiInsertBuffer *buffer;
+
+		buffer = (CopyMultiInsertBuffer *) linitial(miinfo->multiInsertBuffers);
+
+		/* Never drop the current relation's buffer; move it to the end */
+		if (buffer->resultRelInfo == curr_rri)
+		{
+			miinfo->multiInsertBuffers =
+				list_delete_first(miinfo->multiInsertBuffers);
+			miinfo->multiInsertBuffers =
+				lappend(miinfo->multiInsertBuffers, buffer);
+			buffer = (CopyMultiInsertBuffer *) linitial(miinfo->multiInsertBuffers);
+		}
+
+		CopyMultiInsertBufferCleanup(buffer);
+		miinfo->multiInsertBuffers =
+			list_delete_first(miinfo->multiInsertBuffers);
+	}
+}
+
+/*
+ * Drop all the buffers.  They must have been flushed already.
+ */
+static void
+CopyMultiInsertInfoCleanup(CopyMultiInsertInfo *miinfo)
+{
+	ListCell   *lc;
+
+	foreach(lc, miinfo->multiInsertBuffers)
+		CopyMultiInsertBufferCleanup((CopyMultiInsertBuffer *) lfirst(lc));
+
+	list_free(miinfo->multiInsertBuffers);
+	miinfo->multiInsertBuffers = NIL;
+	MemoryContextDelete(miinfo->context);
+}
+
+/*
+ * Write the tuples in 'buffer' to its relation's heap.  Also updates indexes
+ * and runs AFTER ROW INSERT triggers.
  */
 static void
-CopyFromInsertBatch(CopyState cstate, EState *estate, CommandId mycid,
-					int hi_options, ResultRelInfo *resultRelInfo,
-					TupleTableSlot *myslot, BulkInsertState bistate,
-					int nBufferedTuples, HeapTuple *bufferedTuples,
-					uint64 firstBufferedLineNo)
+CopyMultiInsertBufferFlush(CopyMultiInsertInfo *miinfo,
+						   CopyMultiInsertBuffer *buffer,
+						   TupleTableSlot *myslot)
 {
+	CopyState	cstate = miinfo->cstate;
+	EState	   *estate = miinfo->estate;
+	ResultRelInfo *resultRelInfo = buffer->resultRelInfo;
+	ResultRelInfo *save_rri = estate->es_result_relation_info;
+	TupleTableSlot *slot = myslot;
 	MemoryContext oldcontext;
+	int			nused = buffer->nused;
 	int			i;
 	uint64		save_cur_lineno;
 	bool		line_buf_valid = cstate->line_buf_valid;
@@ -3074,17 +3397,28 @@ CopyFromInsertBatch(CopyState cstate, EState *estate, CommandId mycid,
 	cstate->line_buf_valid = false;
 	save_cur_lineno = cstate->cur_lineno;
 
+	/*
+	 * The buffer may be for another partition than the one the current tuple
+	 * goes to, so point ExecInsertIndexTuples() to the right one.  Tuples
+	 * converted to a partition's rowtype must also be stored in a slot of
+	 * that rowtype.
+	 */
+	estate->es_result_relation_info = resultRelInfo;
+	if (resultRelInfo->ri_PartitionInfo &&
+		resultRelInfo->ri_PartitionInfo->pi_PartitionTupleSlot)
+		slot = resultRelInfo->ri_PartitionInfo->pi_PartitionTupleSlot;
+
 	/*
 	 * heap_multi_insert leaks memory, so switch to short-lived memory context
 	 * before calling it.
 	 */
 	oldcontext = MemoryContextSwitchTo(GetPerTupleMemoryContext(estate));
 	heap_multi_insert(resultRelInfo->ri_RelationDesc,
-					  bufferedTuples,
-					  nBufferedTuples,
-					  mycid,
-					  hi_options,
-					  bistate);
+					  buffer->tuples,
+					  nused,
+					  miinfo->mycid,
+					  miinfo->hi_options,
+					  buffer->bistate);
 	MemoryContextSwitchTo(oldcontext);
 
 	/*
@@ -3093,20 +3427,21 @@ CopyFromInsertBatch(CopyState cstate, EState *estate, CommandId mycid,
 	 */
 	if (resultRelInfo->ri_NumIndices > 0)
 	{
-		for (i = 0; i < nBufferedTuples; i++)
+		for (i = 0; i < nused; i++)
 		{
 			List	   *recheckIndexes;
 
-			cstate->cur_lineno = firstBufferedLineNo + i;
-			ExecStoreHeapTuple(bufferedTuples[i], myslot, false);
+			cstate->cur_lineno = buffer->linenos[i];
+			ExecStoreHeapTuple(buffer->tuples[i], slot, false);
 			recheckIndexes =
-				ExecInsertIndexTuples(myslot, &(bufferedTuples[i]->t_self),
-									  estate, false, NULL, NIL);
+				ExecInsertIndexTuples(slot, &(buffer->tuples[i]->t_self),
+									  estate, false, NULL, NIL, false);
 			ExecARInsertTriggers(estate, resultRelInfo,
-								 bufferedTuples[i],
+								 buffer->tuples[i],
 								 recheckIndexes, cstate->transition_capture);
 			list_free(recheckIndexes);
 		}
+		ExecClearTuple(slot);
 	}
 
 	/*
@@ -3117,20 +3452,37 @@ CopyFromInsertBatch(CopyState cstate, EState *estate, CommandId mycid,
 			 (resultRelInfo->ri_TrigDesc->trig_insert_after_row ||
 			  resultRelInfo->ri_TrigDesc->trig_insert_new_table))
 	{
-		for (i = 0; i < nBufferedTuples; i++)
+		for (i = 0; i < nused; i++)
 		{
-			cstate->cur_lineno = firstBufferedLineNo + i;
+			cstate->cur_lineno = buffer->linenos[i];
 			ExecARInsertTriggers(estate, resultRelInfo,
-								 bufferedTuples[i],
+								 buffer->tuples[i],
 								 NIL, cstate->transition_capture);
 		}
 	}
 
+	buffer->nused = 0;
+
+	estate->es_result_relation_info = save_rri;
+
 	/* reset cur_lineno and line_buf_valid to what they were */
 	cstate->line_buf_valid = line_buf_valid;
 	cstate->cur_lineno = save_cur_lineno;
 }
 
+/*
+ * Free a buffer, which must be empty, and unlink it from its relation.
+ */
+static void
+CopyMultiInsertBufferCleanup(CopyMultiInsertBuffer *buffer)
+{
+	Assert(buffer->nused == 0);
+
+	FreeBulkInsertState(buffer->bistate);
+	buffer->resultRelInfo->ri_CopyMultiInsertBuffer = NULL;
+	pfree(buffer);
+}
+
 /*
  * Setup to read tuples from a file for COPY FROM.
  *
@@ -3163,10 +3515,19 @@ BeginCopyFrom(ParseState *pstate,
 	ExprState **defexprs;
 	MemoryContext oldcontext;
 	bool		volatile_defexprs;
+	bool		parallel_safe_defexprs;
+	int64		bytes_total = 0;
 
 	cstate = BeginCopy(pstate, true, rel, NULL, InvalidOid, attnamelist, options);
 	oldcontext = MemoryContextSwitchTo(cstate->copycontext);
 
+	/* Remember what parallel workers will need to set up their state */
+	if (cstate->nworkers > 0)
+	{
+		cstate->attnamelist = copyObject(attnamelist);
+		cstate->options = copyObject(options);
+	}
+
 	/* Initialize state variables */
 	cstate->reached_eof = false;
 	cstate->eol_type = EOL_UNKNOWN;
@@ -3190,6 +3551,7 @@ BeginCopyFrom(ParseState *pstate,
 	num_phys_attrs = tupDesc->natts;
 	num_defaults = 0;
 	volatile_defexprs = false;
+	parallel_safe_defexprs = true;
 
 	/*
 	 * Pick up the required catalog information for each attribute in the
@@ -3252,6 +3614,14 @@ BeginCopyFrom(ParseState *pstate,
 				 */
 				if (!volatile_defexprs)
 					volatile_defexprs = contain_volatile_functions_not_nextval((Node *) defexpr);
+
+				/*
+				 * With PARALLEL, defaults are computed by the leader while in
+				 * parallel mode, where nextval() and other volatile functions
+				 * that may write to the database can't be executed.
+				 */
+				if (parallel_safe_defexprs)
+					parallel_safe_defexprs = !contain_volatile_functions((Node *) defexpr);
 			}
 		}
 	}
@@ -3262,6 +3632,7 @@ BeginCopyFrom(ParseState *pstate,
 	cstate->defmap = defmap;
 	cstate->defexprs = defexprs;
 	cstate->volatile_defexprs = volatile_defexprs;
+	cstate->parallel_safe_defexprs = parallel_safe_defexprs;
 	cstate->num_defaults = num_defaults;
 	cstate->is_program = is_program;
 
@@ -3320,9 +3691,13 @@ BeginCopyFrom(ParseState *pstate,
 				ereport(ERROR,
 						(errcode(ERRCODE_WRONG_OBJECT_TYPE),
 						 errmsg("\"%s\" is a directory", cstate->filename)));
+
+			bytes_total = st.st_size;
 		}
 	}
 
+	CopyStartProgress(cstate, bytes_total);
+
 	if (cstate->binary)
 	{
 		/* Read and verify binary header */
@@ -3431,6 +3806,91 @@ NextCopyFromRawFields(CopyState cstate, char ***fields, int *nfields)
 	return true;
 }
 
+/*
+ * Convert the raw fields of a text or CSV line into column values, applying
+ * FORCE_NOT_NULL and FORCE_NULL.  This is shared by NextCopyFrom and the
+ * parallel COPY workers.
+ */
+static void
+CopyConvertFields(CopyState cstate, char **field_strings, int fldct,
+				  Datum *values, bool *nulls)
+{
+	TupleDesc	tupDesc = RelationGetDescr(cstate->rel);
+	AttrNumber	attr_count = list_length(cstate->attnumlist);
+	FmgrInfo   *in_functions = cstate->in_functions;
+	Oid		   *typioparams = cstate->typioparams;
+	ListCell   *cur;
+	int			fieldno;
+	char	   *string;
+
+	/* check for overflowing fields */
+	if (attr_count > 0 && fldct > attr_count)
+		ereport(ERROR,
+				(errcode(ERRCODE_BAD_COPY_FILE_FORMAT),
+				 errmsg("extra data after last expected column")));
+
+	fieldno = 0;
+
+	/* Loop to read the user attributes on the line. */
+	foreach(cur, cstate->attnumlist)
+	{
+		int			attnum = lfirst_int(cur);
+		int			m = attnum - 1;
+		Form_pg_attribute att = TupleDescAttr(tupDesc, m);
+
+		if (fieldno >= fldct)
+			ereport(ERROR,
+					(errcode(ERRCODE_BAD_COPY_FILE_FORMAT),
+					 errmsg("missing data for column \"%s\"",
+							NameStr(att->attname))));
+		string = field_strings[fieldno++];
+
+		if (cstate->convert_select_flags &&
+			!cstate->convert_select_flags[m])
+		{
+			/* ignore input field, leaving column as NULL */
+			continue;
+		}
+
+		if (cstate->csv_mode)
+		{
+			if (string == NULL &&
+				cstate->force_notnull_flags[m])
+			{
+				/*
+				 * FORCE_NOT_NULL option is set and column is NULL -
+				 * convert it to the NULL string.
+				 */
+				string = cstate->null_print;
+			}
+			else if (string != NULL && cstate->force_null_flags[m]
+					 && strcmp(string, cstate->null_print) == 0)
+			{
+				/*
+				 * FORCE_NULL option is set and column matches the NULL
+				 * string. It must have been quoted, or otherwise the
+				 * string would already have been set to NULL. Convert it
+				 * to NULL as specified.
+				 */
+				string = NULL;
+			}
+		}
+
+		cstate->cur_attname = NameStr(att->attname);
+		cstate->cur_attval = string;
+		values[m] = InputFunctionCall(&in_functions[m],
+									  string,
+									  typioparams[m],
+									  att->atttypmod);
+		if (string != NULL)
+			nulls[m] = false;
+		cstate->cur_attname = NULL;
+		cstate->cur_attval = NULL;
+	}
+
+	Assert(fieldno == attr_count);
+}
+
 /*
  * Read next tuple from file for COPY FROM. Return false if no more tuples.
  *
@@ -3464,84 +3924,22 @@ NextCopyFrom(CopyState cstate, ExprContext *econtext,
 	MemSet(values, 0, num_phys_attrs * sizeof(Datum));
 	MemSet(nulls, true, num_phys_attrs * sizeof(bool));
 
-	if (!cstate->binary)
+	if (cstate->pcopy)
+	{
+		/* the fields were already converted by a parallel worker */
+		if (!CopyReadParallelTuple(cstate, values, nulls))
+			return false;
+	}
+	else if (!cstate->binary)
 	{
 		char	  **field_strings;
-		ListCell   *cur;
 		int			fldct;
-		int			fieldno;
-		char	   *string;
 
 		/* read raw fields in the next line */
 		if (!NextCopyFromRawFields(cstate, &field_strings, &fldct))
 			return false;
 
-		/* check for overflowing fields */
-		if (attr_count > 0 && fldct > attr_count)
-			ereport(ERROR,
-					(errcode(ERRCODE_BAD_COPY_FILE_FORMAT),
-					 errmsg("extra data after last expected column")));
-
-		fieldno = 0;
-
-		/* Loop to read the user attributes on the line. */
-		foreach(cur, cstate->attnumlist)
-		{
-			int			attnum = lfirst_int(cur);
-			int			m = attnum - 1;
-			Form_pg_attribute att = TupleDescAttr(tupDesc, m);
-
-			if (fieldno >= fldct)
-				ereport(ERROR,
-						(errcode(ERRCODE_BAD_COPY_FILE_FORMAT),
-						 errmsg("missing data for column \"%s\"",
-								NameStr(att->attname))));
-			string = field_strings[fieldno++];
-
-			if (cstate->convert_select_flags &&
-				!cstate->convert_select_flags[m])
-			{
-				/* ignore input field, leaving column as NULL */
-				continue;
-			}
-
-			if (cstate->csv_mode)
-			{
-				if (string == NULL &&
-					cstate->force_notnull_flags[m])
-				{
-					/*
-					 * FORCE_NOT_NULL option is set and column is NULL -
-					 * convert it to the NULL string.
-					 */
-					string = cstate->null_print;
-				}
-				else if (string != NULL && cstate->force_null_flags[m]
-						 && strcmp(string, cstate->null_print) == 0)
-				{
-					/*
-					 * FORCE_NULL option is set and column matches the NULL
-					 * string. It must have been quoted, or otherwise the
-					 * string would already have been set to NULL. Convert it
-					 * to NULL as specified.
-					 */
-					string = NULL;
-				}
-			}
-
-			cstate->cur_attname = NameStr(att->attname);
-			cstate->cur_attval = string;
-			values[m] = InputFunctionCall(&in_functions[m],
-										  string,
-										  typioparams[m],
-										  att->atttypmod);
-			if (string != NULL)
-				nulls[m] = false;
-			cstate->cur_attname = NULL;
-			cstate->cur_attval = NULL;
-		}
-
-		Assert(fieldno == attr_count);
+		CopyConvertFields(cstate, field_strings, fldct, values, nulls);
 	}
 	else
 	{
@@ -3638,6 +4036,602 @@ EndCopyFrom(CopyState cstate)
 	EndCopy(cstate);
 }
 
+/*
+ * Can the COPY FROM use parallel workers?
+ *
+ * The leader computes the defaults and inserts the rows while in parallel
+ * mode, and the workers run the input functions, so everything involved
+ * must be safe for that.  Anything out of the ordinary just makes us fall
+ * back to a serial COPY.
+ */
+static bool
+CopyFromParallelSafe(CopyState cstate)
+{
+	Relation	rel = cstate->rel;
+	TupleDesc	tupDesc = RelationGetDescr(rel);
+	ListCell   *cur;
+
+	/* no tuple routing, and no foreign tables */
+	if (rel->rd_rel->relkind != RELKIND_RELATION)
+		return false;
+
+	/* triggers, including foreign key checks, could run anything */
+	if (rel->trigdesc != NULL)
+		return false;
+
+	if (!cstate->parallel_safe_defexprs)
+		return false;
+
+	foreach(cur, cstate->attnumlist)
+	{
+		int			m = lfirst_int(cur) - 1;
+		Oid			typid = TupleDescAttr(tupDesc, m)->atttypid;
+		Oid			elemtype;
+
+		if (func_parallel(cstate->in_functions[m].fn_oid) != PROPARALLEL_SAFE)
+			return false;
+
+		/* nor do we want to guess what domain constraints will call */
+		if (getBaseType(typid) != typid)
+			return false;
+		elemtype = get_element_type(typid);
+		if (OidIsValid(elemtype) && getBaseType(elemtype) != elemtype)
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Launch parallel workers to parse the input of a COPY FROM, if possible.
+ * On success, cstate->pcopy is set and NextCopyFrom fetches the tuples from
+ * the workers from then on.
+ */
+static void
+BeginParallelCopy(CopyState cstate)
+{
+	ParallelCopyState *pcopy;
+	ParallelContext *pcxt;
+	ParallelCopyShared *shared;
+	const char *query = debug_query_string ? debug_query_string : "";
+	char	   *options_str;
+	char	   *attnames_str;
+	char	   *ptr;
+	char	   *queues;
+	Size		options_len;
+	Size		attnames_len;
+	Size		query_len;
+	Size		queues_size;
+	int			nworkers;
+	int			i;
+	MemoryContext oldcontext;
+
+	nworkers = Min(cstate->nworkers, max_parallel_maintenance_workers);
+	if (nworkers <= 0 || !CopyFromParallelSafe(cstate))
+		return;
+
+	/* The insertions need an XID, and we can't assign one in parallel mode */
+	(void) GetCurrentTransactionId();
+
+	EnterParallelMode();
+	pcxt = CreateParallelContext("postgres", "ParallelCopyMain",
+								 nworkers, true);
+
+	options_str = nodeToString(cstate->options);
+	options_len = strlen(options_str) + 1;
+	attnames_str = nodeToString(cstate->attnamelist);
+	attnames_len = strlen(attnames_str) + 1;
+	query_len = strlen(query) + 1;
+	queues_size = mul_size(2 * nworkers, PARALLEL_COPY_QUEUE_SIZE);
+
+	shm_toc_estimate_chunk(&pcxt->estimator, sizeof(ParallelCopyShared));
+	shm_toc_estimate_chunk(&pcxt->estimator, options_len);
+	shm_toc_estimate_chunk(&pcxt->estimator, attnames_len);
+	shm_toc_estimate_chunk(&pcxt->estimator, queues_size);
+	shm_toc_estimate_chunk(&pcxt->estimator, query_len);
+	shm_toc_estimate_keys(&pcxt->estimator, 5);
+
+	InitializeParallelDSM(pcxt);
+
+	shared = (ParallelCopyShared *)
+		shm_toc_allocate(pcxt->toc, sizeof(ParallelCopyShared));
+	shared->relid = RelationGetRelid(cstate->rel);
+	shm_toc_insert(pcxt->toc, PARALLEL_COPY_KEY_SHARED, shared);
+
+	ptr = (char *) shm_toc_allocate(pcxt->toc, options_len);
+	memcpy(ptr, options_str, options_len);
+	shm_toc_insert(pcxt->toc, PARALLEL_COPY_KEY_OPTIONS, ptr);
+
+	ptr = (char *) shm_toc_allocate(pcxt->toc, attnames_len);
+	memcpy(ptr, attnames_str, attnames_len);
+	shm_toc_insert(pcxt->toc, PARALLEL_COPY_KEY_ATTNAMES, ptr);
+
+	ptr = (char *) shm_toc_allocate(pcxt->toc, query_len);
+	memcpy(ptr, query, query_len);
+	shm_toc_insert(pcxt->toc, PARALLEL_COPY_KEY_QUERY_TEXT, ptr);
+
+	queues = (char *) shm_toc_allocate(pcxt->toc, queues_size);
+	for (i = 0; i < nworkers; i++)
+	{
+		shm_mq	   *mq;
+
+		mq = shm_mq_create(queues + (Size) (2 * i) * PARALLEL_COPY_QUEUE_SIZE,
+						   PARALLEL_COPY_QUEUE_SIZE);
+		shm_mq_set_sender(mq, MyProc);
+		mq = shm_mq_create(queues + (Size) (2 * i + 1) * PARALLEL_COPY_QUEUE_SIZE,
+						   PARALLEL_COPY_QUEUE_SIZE);
+		shm_mq_set_receiver(mq, MyProc);
+	}
+	shm_toc_insert(pcxt->toc, PARALLEL_COPY_KEY_QUEUES, queues);
+
+	LaunchParallelWorkers(pcxt);
+
+	/* If no workers could be launched, do it the serial way */
+	if (pcxt->nworkers_launched == 0)
+	{
+		DestroyParallelContext(pcxt);
+		ExitParallelMode();
+		return;
+	}
+
+	oldcontext = MemoryContextSwitchTo(cstate->copycontext);
+
+	pcopy = (ParallelCopyState *) palloc0(sizeof(ParallelCopyState));
+	pcopy->pcxt = pcxt;
+	pcopy->nworkers = pcxt->nworkers_launched;
+	pcopy->input_queues = (shm_mq_handle **)
+		palloc(pcopy->nworkers * sizeof(shm_mq_handle *));
+	pcopy->output_queues = (shm_mq_handle **)
+		palloc(pcopy->nworkers * sizeof(shm_mq_handle *));
+	pcopy->nchunks_sent = (uint64 *) palloc0(pcopy->nworkers * sizeof(uint64));
+	for (i = 0; i < pcopy->nworkers; i++)
+	{
+		shm_mq	   *mq;
+
+		mq = (shm_mq *) (queues + (Size) (2 * i) * PARALLEL_COPY_QUEUE_SIZE);
+		pcopy->input_queues[i] =
+			shm_mq_attach(mq, pcxt->seg, pcxt->worker[i].bgwhandle);
+		mq = (shm_mq *) (queues + (Size) (2 * i + 1) * PARALLEL_COPY_QUEUE_SIZE);
+		pcopy->output_queues[i] =
+			shm_mq_attach(mq, pcxt->seg, pcxt->worker[i].bgwhandle);
+	}
+	pcopy->noutputs = pcopy->nworkers;
+	initStringInfo(&pcopy->chunk);
+
+	MemoryContextSwitchTo(oldcontext);
+
+	cstate->pcopy = pcopy;
+}
+
+/*
+ * Wait for the parallel workers to exit, and end parallel mode.  All the
+ * queues have been detached by now.
+ */
+static void
+EndParallelCopy(CopyState cstate)
+{
+	ParallelCopyState *pcopy = cstate->pcopy;
+
+	WaitForParallelWorkersToFinish(pcopy->pcxt);
+	DestroyParallelContext(pcopy->pcxt);
+	ExitParallelMode();
+
+	cstate->pcopy = NULL;
+}
+
+/*
+ * Read input lines into pcopy->chunk, until it's full or the input ends.
+ * Returns false if there were no more lines.
+ */
+static bool
+ParallelCopyFillChunk(CopyState cstate)
+{
+	ParallelCopyState *pcopy = cstate->pcopy;
+	uint64		save_cur_lineno = cstate->cur_lineno;
+
+	resetStringInfo(&pcopy->chunk);
+
+	while (!pcopy->reached_eof && pcopy->chunk.len < PARALLEL_COPY_CHUNK_SIZE)
+	{
+		bool		skip;
+		uint32		len;
+
+		/* on input just throw the header line away */
+		skip = (pcopy->read_lineno == 0 && cstate->header_line);
+
+		/* get the right line number into any errors CopyReadLine reports */
+		cstate->cur_lineno = ++pcopy->read_lineno;
+
+		if (CopyReadLine(cstate))
+		{
+			/*
+			 * EOF at start of line means we're done.  If we see EOF after
+			 * some characters, we act as though it was newline followed by
+			 * EOF, as NextCopyFromRawFields does.
+			 */
+			pcopy->reached_eof = true;
+			if (cstate->line_buf.len == 0)
+				break;
+		}
+
+		if (skip)
+			continue;
+
+		if (pcopy->chunk.len == 0)
+			appendBinaryStringInfo(&pcopy->chunk,
+								   (char *) &pcopy->read_lineno,
+								   sizeof(uint64));
+		len = cstate->line_buf.len;
+		appendBinaryStringInfo(&pcopy->chunk, (char *) &len, sizeof(uint32));
+		appendBinaryStringInfo(&pcopy->chunk, cstate->line_buf.data, len);
+	}
+
+	/* line_buf has nothing to do with the tuple being inserted */
+	cstate->line_buf_valid = false;
+	cstate->cur_lineno = save_cur_lineno;
+
+	return pcopy->chunk.len > 0;
+}
+
+/*
+ * Send chunks of input to the workers, until their queues are full or all
+ * the input has been sent.  Returns true if any progress was made.
+ *
+ * The chunks are dealt out round-robin.  A chunk that didn't fit in a queue
+ * must be finished on the same queue, since part of it may have been written
+ * already.
+ */
+static bool
+ParallelCopySendInput(CopyState cstate)
+{
+	ParallelCopyState *pcopy = cstate->pcopy;
+	bool		progress = false;
+	int			i;
+
+	while (!pcopy->input_done)
+	{
+		shm_mq_result res;
+		int			n;
+
+		if (!pcopy->chunk_ready)
+		{
+			if (!ParallelCopyFillChunk(cstate))
+			{
+				/* no more input; detaching tells the workers so */
+				for (i = 0; i < pcopy->nworkers; i++)
+				{
+					if (pcopy->input_queues[i] != NULL)
+					{
+						shm_mq_detach(pcopy->input_queues[i]);
+						pcopy->input_queues[i] = NULL;
+					}
+				}
+				pcopy->input_done = true;
+				return true;
+			}
+			pcopy->chunk_ready = true;
+			progress = true;
+		}
+
+		/* find the next worker still accepting input */
+		for (n = 0; n < pcopy->nworkers; n++)
+		{
+			if (pcopy->input_queues[pcopy->next_input] != NULL)
+				break;
+			pcopy->next_input = (pcopy->next_input + 1) % pcopy->nworkers;
+		}
+		if (n == pcopy->nworkers)
+			ParallelCopyLostWorker(pcopy);
+		i = pcopy->next_input;
+
+		res = shm_mq_send(pcopy->input_queues[i], pcopy->chunk.len,
+						  pcopy->chunk.data, true);
+		if (res == SHM_MQ_WOULD_BLOCK)
+			break;
+		if (res == SHM_MQ_DETACHED)
+		{
+			/*
+			 * The worker exited.  If it never got any input, it probably just
+			 * failed to start, and the others can do its share.
+			 */
+			if (pcopy->nchunks_sent[i] > 0)
+				ParallelCopyLostWorker(pcopy);
+			shm_mq_detach(pcopy->input_queues[i]);
+			pcopy->input_queues[i] = NULL;
+			continue;
+		}
+
+		pcopy->nchunks_sent[i]++;
+		pcopy->chunk_ready = false;
+		pcopy->next_input = (i + 1) % pcopy->nworkers;
+		progress = true;
+	}
+
+	return progress;
+}
+
+/*
+ * Fetch the next tuple parsed by the parallel workers into values and
+ * nulls, sending them more input as needed.  Returns false once all the
+ * input has been processed.
+ */
+static bool
+CopyReadParallelTuple(CopyState cstate, Datum *values, bool *nulls)
+{
+	ParallelCopyState *pcopy = cstate->pcopy;
+	TupleDesc	tupDesc = RelationGetDescr(cstate->rel);
+
+	for (;;)
+	{
+		bool		progress;
+		int			n;
+
+		progress = ParallelCopySendInput(cstate);
+
+		/* try each worker in turn, starting where we left off */
+		for (n = 0; n < pcopy->nworkers && pcopy->noutputs > 0; n++)
+		{
+			int			i = pcopy->next_output;
+			shm_mq_result res;
+			Size		nbytes;
+			void	   *data;
+			MinimalTuple mtup;
+			HeapTupleData htup;
+
+			pcopy->next_output = (i + 1) % pcopy->nworkers;
+			if (pcopy->output_queues[i] == NULL)
+				continue;
+
+			res = shm_mq_receive(pcopy->output_queues[i], &nbytes, &data, true);
+			if (res == SHM_MQ_WOULD_BLOCK)
+				continue;
+			if (res == SHM_MQ_DETACHED)
+			{
+				/*
+				 * A worker finishes once we have detached its input queue and
+				 * it has sent us all its tuples.  Exiting before that is
+				 * harmless only if it never got any input.
+				 */
+				if (pcopy->input_queues[i] != NULL)
+				{
+					if (pcopy->nchunks_sent[i] > 0)
+						ParallelCopyLostWorker(pcopy);
+					shm_mq_detach(pcopy->input_queues[i]);
+					pcopy->input_queues[i] = NULL;
+				}
+				shm_mq_detach(pcopy->output_queues[i]);
+				pcopy->output_queues[i] = NULL;
+				pcopy->noutputs--;
+				continue;
+			}
+
+			/*
+			 * The message is the line number followed by the minimal tuple.
+			 * Copy the tuple out of the queue, so that it's suitably aligned
+			 * and stays valid after the next receive.
+			 */
+			Assert(nbytes > sizeof(uint64));
+			memcpy(&cstate->cur_lineno, data, sizeof(uint64));
+			mtup = (MinimalTuple) palloc(nbytes - sizeof(uint64));
+			memcpy(mtup, (char *) data + sizeof(uint64), nbytes - sizeof(uint64));
+
+			htup.t_len = mtup->t_len + MINIMAL_TUPLE_OFFSET;
+			htup.t_data = (HeapTupleHeader) ((char *) mtup - MINIMAL_TUPLE_OFFSET);
+			heap_deform_tuple(&htup, tupDesc, values, nulls);
+
+			return true;
+		}
+
+		if (pcopy->noutputs == 0)
+		{
+			/* all the workers are done; they had better have had all input */
+			if (!pcopy->input_done)
+				ParallelCopyLostWorker(pcopy);
+			return false;
+		}
+
+		if (!progress)
+		{
+			(void) WaitLatch(MyLatch, WL_LATCH_SET | WL_EXIT_ON_PM_DEATH, -1L,
+							 WAIT_EVENT_PARALLEL_COPY);
+			ResetLatch(MyLatch);
+		}
+
+		CHECK_FOR_INTERRUPTS();
+	}
+}
+
+/*
+ * A parallel worker exited without processing all the input sent to it,
+ * which normally means that it failed.  Detach from all the queues, so that
+ * the other workers exit too, and wait for them, to report the error the
+ * worker sent us.  If there was none, complain here.
+ */
+static void
+ParallelCopyLostWorker(ParallelCopyState *pcopy)
+{
+	int			i;
+
+	for (i = 0; i < pcopy->nworkers; i++)
+	{
+		if (pcopy->input_queues[i] != NULL)
+		{
+			shm_mq_detach(pcopy->input_queues[i]);
+			pcopy->input_queues[i] = NULL;
+		}
+		if (pcopy->output_queues[i] != NULL)
+		{
+			shm_mq_detach(pcopy->output_queues[i]);
+			pcopy->output_queues[i] = NULL;
+		}
+	}
+
+	WaitForParallelWorkersToFinish(pcopy->pcxt);
+
+	elog(ERROR, "lost connection to parallel COPY worker");
+}
+
+/*
+ * Data source callback for the workers' CopyState, which never reads any
+ * input itself.
+ */
+static int
+ParallelCopyNoData(void *outbuf, int minread, int maxread)
+{
+	elog(ERROR, "parallel COPY worker cannot read input");
+	return 0;					/* keep compiler quiet */
+}
+
+/*
+ * Main entry point for parallel COPY FROM worker processes.
+ *
+ * The leader holds RowExclusiveLock on the table, so opening it here can't
+ * block, since we're in its lock group.
+ */
+void
+ParallelCopyMain(dsm_segment *seg, shm_toc *toc)
+{
+	ParallelCopyShared *shared;
+	char	   *sharedquery;
+	char	   *queues;
+	List	   *options;
+	List	   *attnamelist;
+	Relation	rel;
+	TupleDesc	tupDesc;
+	CopyState	cstate;
+	shm_mq	   *mq;
+	shm_mq_handle *input_queue;
+	shm_mq_handle *output_queue;
+	Datum	   *values;
+	bool	   *nulls;
+	MemoryContext tupcontext;
+	MemoryContext oldcontext;
+	ErrorContextCallback errcallback;
+	bool		done = false;
+
+	/* Set debug_query_string for individual workers first */
+	sharedquery = shm_toc_lookup(toc, PARALLEL_COPY_KEY_QUERY_TEXT, false);
+	debug_query_string = sharedquery;
+
+	/* Report the query string from leader */
+	pgstat_report_activity(STATE_RUNNING, debug_query_string);
+
+	shared = (ParallelCopyShared *) shm_toc_lookup(toc,
+												   PARALLEL_COPY_KEY_SHARED,
+												   false);
+	options = (List *)
+		stringToNode(shm_toc_lookup(toc, PARALLEL_COPY_KEY_OPTIONS, false));
+	attnamelist = (List *)
+		stringToNode(shm_toc_lookup(toc, PARALLEL_COPY_KEY_ATTNAMES, false));
+
+	rel = heap_open(shared->relid, AccessShareLock);
+	tupDesc = RelationGetDescr(rel);
+
+	cstate = BeginCopyFrom(NULL, rel, NULL, false, ParallelCopyNoData,
+						   attnamelist, options);
+
+	/* The lines were already converted to the server encoding */
+	cstate->line_buf_converted = true;
+
+	queues = shm_toc_lookup(toc, PARALLEL_COPY_KEY_QUEUES, false);
+	mq = (shm_mq *) (queues +
+					 (Size) (2 * ParallelWorkerNumber) * PARALLEL_COPY_QUEUE_SIZE);
+	shm_mq_set_receiver(mq, MyProc);
+	input_queue = shm_mq_attach(mq, seg, NULL);
+	mq = (shm_mq *) (queues +
+					 (Size) (2 * ParallelWorkerNumber + 1) * PARALLEL_COPY_QUEUE_SIZE);
+	shm_mq_set_sender(mq, MyProc);
+	output_queue = shm_mq_attach(mq, seg, NULL);
+
+	values = (Datum *) palloc(tupDesc->natts * sizeof(Datum));
+	nulls = (bool *) palloc(tupDesc->natts * sizeof(bool));
+	tupcontext = AllocSetContextCreate(CurrentMemoryContext,
+									   "COPY worker tuple context",
+									   ALLOCSET_DEFAULT_SIZES);
+
+	/* Set up callback to identify error line number */
+	errcallback.callback = CopyFromErrorCallback;
+	errcallback.arg = (void *) cstate;
+	errcallback.previous = error_context_stack;
+	error_context_stack = &errcallback;
+
+	while (!done)
+	{
+		shm_mq_result res;
+		Size		nbytes;
+		void	   *data;
+		char	   *ptr;
+		char	   *end;
+		uint64		lineno;
+
+		/* the leader detaches once it has sent all the input */
+		res = shm_mq_receive(input_queue, &nbytes, &data, false);
+		if (res != SHM_MQ_SUCCESS)
+			break;
+
+		ptr = (char *) data;
+		end = ptr + nbytes;
+		memcpy(&lineno, ptr, sizeof(uint64));
+		ptr += sizeof(uint64);
+
+		while (ptr < end)
+		{
+			uint32		len;
+			int			fldct;
+			MinimalTuple tuple;
+			shm_mq_iovec iov[2];
+
+			CHECK_FOR_INTERRUPTS();
+
+			memcpy(&len, ptr, sizeof(uint32));
+			ptr += sizeof(uint32);
+			resetStringInfo(&cstate->line_buf);
+			appendBinaryStringInfo(&cstate->line_buf, ptr, len);
+			ptr += len;
+			cstate->line_buf_valid = true;
+			cstate->cur_lineno = lineno++;
+
+			MemoryContextReset(tupcontext);
+			oldcontext = MemoryContextSwitchTo(tupcontext);
+
+			/* Parse the line into de-escaped field values */
+			if (cstate->csv_mode)
+				fldct = CopyReadAttributesCSV(cstate);
+			else
+				fldct = CopyReadAttributesText(cstate);
+
+			MemSet(values, 0, tupDesc->natts * sizeof(Datum));
+			MemSet(nulls, true, tupDesc->natts * sizeof(bool));
+			CopyConvertFields(cstate, cstate->raw_fields, fldct, values, nulls);
+
+			tuple = heap_form_minimal_tuple(tupDesc, values, nulls);
+
+			MemoryContextSwitchTo(oldcontext);
+
+			iov[0].data = (char *) &cstate->cur_lineno;
+			iov[0].len = sizeof(uint64);
+			iov[1].data = (char *) tuple;
+			iov[1].len = tuple->t_len;
+			res = shm_mq_sendv(output_queue, iov, 2, false);
+			if (res != SHM_MQ_SUCCESS)
+			{
+				/* the leader has given up */
+				done = true;
+				break;
+			}
+		}
+	}
+
+	error_context_stack = errcallback.previous;
+
+	shm_mq_detach(output_queue);
+	shm_mq_detach(input_queue);
+
+	MemoryContextDelete(tupcontext);
+	EndCopyFrom(cstate);
+	heap_close(rel, AccessShareLock);
+}
+
 /*
  * Read the next input line and stash it in line_buf, with conversion to
  * server encoding.
@@ -3732,6 +4726,50 @@ CopyReadLine(CopyState cstate)
 	return result;
 }
 
+/*
+ * The COPY FROM parsing loops examine their input byte by byte, because any
+ * byte might need special treatment.  Most input bytes don't, though, so the
+ * loops first try to skip over whole blocks of COPY_SCAN_BLOCK bytes that
+ * contain none of the characters they care about, using vector instructions
+ * where available.  A block that does contain one is then processed byte by
+ * byte as before, and the next vector scan starts after it.
+ */
+#define COPY_SCAN_BLOCK 16		/* sizeof(Vector8) */
+
+/*
+ * Return the number of leading bytes of s[0 .. len - 1] that can be skipped
+ * because they're in whole blocks containing none of c1 to c4.  Callers
+ * looking for fewer characters pass some of them twice.
+ */
+static inline int
+CopySkipPlainChars(const char *s, int len, char c1, char c2, char c3, char c4)
+{
+	int			i = 0;
+
+#ifndef USE_NO_SIMD
+	const Vector8 v1 = vector8_broadcast((uint8) c1);
+	const Vector8 v2 = vector8_broadcast((uint8) c2);
+	const Vector8 v3 = vector8_broadcast((uint8) c3);
+	const Vector8 v4 = vector8_broadcast((uint8) c4);
+
+	for (; i + COPY_SCAN_BLOCK <= len; i += COPY_SCAN_BLOCK)
+	{
+		Vector8		chunk;
+		Vector8		match;
+
+		vector8_load(&chunk, (const uint8 *) s + i);
+		match = vector8_or(vector8_or(vector8_eq(chunk, v1),
+									  vector8_eq(chunk, v2)),
+						   vector8_or(vector8_eq(chunk, v3),
+									  vector8_eq(chunk, v4)));
+		if (vector8_is_highbit_set(match))
+			break;
+	}
+#endif
+
+	return i;
+}
+
 /*
  * CopyReadLineText - inner loop of CopyReadLine for text mode
  */
@@ -3753,6 +4791,12 @@ CopyReadLineText(CopyState cstate)
 	char		quotec = '\0';
 	char		escapec = '\0';
 
+	/* block scanning, see CopySkipPlainChars */
+	bool		scan_blocks;
+	int			scan_resume = 0;
+	char		scanc1;
+	char		scanc2;
+
 	if (cstate->csv_mode)
 	{
 		quotec = cstate->quote[0];
@@ -3762,6 +4806,23 @@ CopyReadLineText(CopyState cstate)
 			escapec = '\0';
 	}
 
+	/*
+	 * Besides newlines, a backslash matters in text mode, and the quote and
+	 * escape characters in CSV mode.  A backslash also starts the
+	 * end-of-copy marker in CSV mode, but only as the first character on a
+	 * line, which is never skipped.  In encodings where the trailing bytes
+	 * of multibyte characters can look like ASCII, we must look at every
+	 * byte to know where the characters start.
+	 */
+	scan_blocks = !cstate->encoding_embeds_ascii;
+	if (cstate->csv_mode)
+	{
+		scanc1 = quotec;
+		scanc2 = escapec ? escapec : quotec;
+	}
+	else
+		scanc1 = scanc2 = '\\';
+
 	mblen_str[1] = '\0';
 
 	/*
@@ -3815,6 +4876,7 @@ CopyReadLineText(CopyState cstate)
 			if (!CopyLoadRawBuf(cstate))
 				hit_eof = true;
 			raw_buf_ptr = 0;
+			scan_resume = 0;
 			copy_buf_len = cstate->raw_buf_len;
 
 			/*
@@ -3829,6 +4891,28 @@ CopyReadLineText(CopyState cstate)
 			need_data = false;
 		}
 
+		/*
+		 * Skip any blocks of ordinary characters.  Only the characters the
+		 * CSV state depends on stop the scan, and anything skipped is not
+		 * the escape character, so we can't be just after one.
+		 */
+		if (scan_blocks && raw_buf_ptr >= scan_resume && !first_char_in_line)
+		{
+			int			skip;
+
+			skip = CopySkipPlainChars(copy_raw_buf + raw_buf_ptr,
+									  copy_buf_len - raw_buf_ptr,
+									  '\n', '\r', scanc1, scanc2);
+			raw_buf_ptr += skip;
+			scan_resume = raw_buf_ptr + COPY_SCAN_BLOCK;
+			if (skip > 0)
+			{
+				last_was_esc = false;
+				if (raw_buf_ptr >= copy_buf_len)
+					continue;
+			}
+		}
+
 		/* OK to fetch a character */
 		prev_raw_ptr = raw_buf_ptr;
 		c = copy_raw_buf[raw_buf_ptr++];
@@ -4130,6 +5214,7 @@ CopyReadAttributesText(CopyState cstate)
 	char	   *output_ptr;
 	char	   *cur_ptr;
 	char	   *line_end_ptr;
+	char	   *scan_resume;
 
 	/*
 	 * We need a special case for zero-column tables: check that the input
@@ -4160,6 +5245,7 @@ CopyReadAttributesText(CopyState cstate)
 	/* set pointer variables for loop */
 	cur_ptr = cstate->line_buf.data;
 	line_end_ptr = cstate->line_buf.data + cstate->line_buf.len;
+	scan_resume = cur_ptr;
 
 	/* Outer loop iterates over fields */
 	fieldno = 0;
@@ -4198,6 +5284,19 @@ CopyReadAttributesText(CopyState cstate)
 		{
 			char		c;
 
+			/* copy any blocks of ordinary characters in one go */
+			if (cur_ptr >= scan_resume)
+			{
+				int			nplain;
+
+				nplain = CopySkipPlainChars(cur_ptr, line_end_ptr - cur_ptr,
+											delimc, '\\', delimc, delimc);
+				memcpy(output_ptr, cur_ptr, nplain);
+				output_ptr += nplain;
+				cur_ptr += nplain;
+				scan_resume = cur_ptr + COPY_SCAN_BLOCK;
+			}
+
 			end_ptr = cur_ptr;
 			if (cur_ptr >= line_end_ptr)
 				break;
@@ -4360,6 +5459,7 @@ CopyReadAttributesCSV(CopyState cstate)
 	char	   *output_ptr;
 	char	   *cur_ptr;
 	char	   *line_end_ptr;
+	char	   *scan_resume;
 
 	/*
 	 * We need a special case for zero-column tables: check that the input
@@ -4390,6 +5490,7 @@ CopyReadAttributesCSV(CopyState cstate)
 	/* set pointer variables for loop */
 	cur_ptr = cstate->line_buf.data;
 	line_end_ptr = cstate->line_buf.data + cstate->line_buf.len;
+	scan_resume = cur_ptr;
 
 	/* Outer loop iterates over fields */
 	fieldno = 0;
@@ -4427,6 +5528,19 @@ CopyReadAttributesCSV(CopyState cstate)
 			/* Not in quote */
 			for (;;)
 			{
+				/* copy any blocks of ordinary characters in one go */
+				if (cur_ptr >= scan_resume)
+				{
+					int			nplain;
+
+					nplain = CopySkipPlainChars(cur_ptr, line_end_ptr - cur_ptr,
+												delimc, quotec, delimc, quotec);
+					memcpy(output_ptr, cur_ptr, nplain);
+					output_ptr += nplain;
+					cur_ptr += nplain;
+					scan_resume = cur_ptr + COPY_SCAN_BLOCK;
+				}
+
 				end_ptr = cur_ptr;
 				if (cur_ptr >= line_end_ptr)
 					goto endfield;
@@ -4450,6 +5564,19 @@ CopyReadAttributesCSV(CopyState cstate)
 			/* In quote */
 			for (;;)
 			{
+				/* likewise, but only the quote and escape are special here */
+				if (cur_ptr >= scan_resume)
+				{
+					int			nplain;
+
+					nplain = CopySkipPlainChars(cur_ptr, line_end_ptr - cur_ptr,
+												escapec, quotec, escapec, quotec);
+					memcpy(output_ptr, cur_ptr, nplain);
+					output_ptr += nplain;
+					cur_ptr += nplain;
+					scan_resume = cur_ptr + COPY_SCAN_BLOCK;
+				}
+
 				end_ptr = cur_ptr;
 				if (cur_ptr >= line_end_ptr)
 					ereport(ERROR,
@@ -4915,7 +6042,8 @@ copy_dest_receive(TupleTableSlot *slot, DestReceiver *self)
 
 	/* And send the data */
 	CopyOneRowTo(cstate, slot->tts_values, slot->tts_isnull);
-	myState->processed++;
+	pgstat_progress_update_param(PROGRESS_COPY_TUPLES_PROCESSED,
+								 ++myState->processed);
 
 	return true;
 }
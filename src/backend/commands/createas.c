@@ -27,6 +27,7 @@
 #include "access/reloptions.h"
 #include "access/htup_details.h"
 #include "access/sysattr.h"
+#include "access/tableam.h"
 #include "access/xact.h"
 #include "access/xlog.h"
 #include "catalog/namespace.h"
@@ -106,6 +107,7 @@ create_ctas_internal(List *attrList, IntoClause *into)
 	create->options = into->options;
 	create->oncommit = into->onCommit;
 	create->tablespacename = into->tableSpaceName;
+	create->accessMethod = into->accessMethod;
 	create->if_not_exists = false;
 
 	/*
@@ -137,9 +139,17 @@ create_ctas_internal(List *attrList, IntoClause *into)
 	{
 		/* StoreViewQuery scribbles on tree, so make a copy */
 		Query	   *query = (Query *) copyObject(into->viewQuery);
+		Relation	rel;
 
 		StoreViewQuery(intoRelationAddr.objectId, query, false);
 		CommandCounterIncrement();
+
+		/* Set up incremental maintenance if the view asks for it. */
+		rel = heap_open(intoRelationAddr.objectId, NoLock);
+		if (RelationIsIncrementallyMaintained(rel))
+			CreateMatViewMaintenanceTriggers(intoRelationAddr.objectId,
+											 (Query *) into->viewQuery);
+		heap_close(rel, NoLock);
 	}
 
 	return intoRelationAddr;
@@ -327,7 +337,8 @@ ExecCreateTableAs(CreateTableAsStmt *stmt, const char *queryString,
 		Assert(query->commandType == CMD_SELECT);
 
 		/* plan the query */
-		plan = pg_plan_query(query, CURSOR_OPT_PARALLEL_OK, params);
+		plan = pg_plan_query(query, queryString, CURSOR_OPT_PARALLEL_OK,
+							 params);
 
 		/*
 		 * Use a snapshot with an updated command ID to ensure this query sees
@@ -570,19 +581,14 @@ static bool
 intorel_receive(TupleTableSlot *slot, DestReceiver *self)
 {
 	DR_intorel *myState = (DR_intorel *) self;
-	HeapTuple	tuple;
-
-	/*
-	 * get the heap tuple out of the tuple table slot, making sure we have a
-	 * writable copy
-	 */
-	tuple = ExecCopySlotHeapTuple(slot);
-
-	heap_insert(myState->rel,
-				tuple,
-				myState->output_cid,
-				myState->hi_options,
-				myState->bistate);
+	ItemPointerData tid;
+
+	table_tuple_insert(myState->rel,
+					   slot,
+					   myState->output_cid,
+					   myState->hi_options,
+					   myState->bistate,
+					   &tid);
 
 	/* We know this is a newly created relation, so there are no indexes */
 
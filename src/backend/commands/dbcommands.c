@@ -54,6 +54,7 @@
 #include "storage/lmgr.h"
 #include "storage/ipc.h"
 #include "storage/procarray.h"
+#include "storage/relsizecache.h"
 #include "storage/smgr.h"
 #include "utils/acl.h"
 #include "utils/builtins.h"
@@ -930,6 +931,9 @@ dropdb(const char *dbname, bool missing_ok)
 	 */
 	DropDatabaseBuffers(db_id);
 
+	/* Likewise for any cached relation sizes */
+	RelSizeCacheForgetDatabase(db_id);
+
 	/*
 	 * Tell the stats collector to forget it immediately, too.
 	 */
@@ -1207,6 +1211,9 @@ movedb(const char *dbname, const char *tblspcname)
 	 */
 	DropDatabaseBuffers(db_id);
 
+	/* The same reasoning applies to cached relation sizes */
+	RelSizeCacheForgetDatabase(db_id);
+
 	/*
 	 * Check for existence of files in the target directory, i.e., objects of
 	 * this database that are already in the target tablespace.  We can't
@@ -2113,6 +2120,9 @@ dbase_redo(XLogReaderState *record)
 		 */
 		FlushDatabaseBuffers(xlrec->src_db_id);
 
+		/* Sizes cached for files we just removed are no longer valid */
+		RelSizeCacheForgetDatabase(xlrec->db_id);
+
 		/*
 		 * Copy this subdirectory to the new location
 		 *
@@ -2149,6 +2159,9 @@ dbase_redo(XLogReaderState *record)
 		/* Drop pages for this database that are in the shared buffer cache */
 		DropDatabaseBuffers(xlrec->db_id);
 
+		/* Likewise for any cached relation sizes */
+		RelSizeCacheForgetDatabase(xlrec->db_id);
+
 		/* Also, clean out any fsync requests that might be pending in md.c */
 		ForgetDatabaseFsyncRequests(xlrec->db_id);
 
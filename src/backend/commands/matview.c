@@ -16,32 +16,47 @@
 
 #include "access/htup_details.h"
 #include "access/multixact.h"
+#include "access/tableam.h"
 #include "access/xact.h"
 #include "access/xlog.h"
 #include "catalog/catalog.h"
+#include "catalog/dependency.h"
 #include "catalog/indexing.h"
 #include "catalog/namespace.h"
 #include "catalog/pg_am.h"
+#include "catalog/pg_inherits.h"
 #include "catalog/pg_opclass.h"
 #include "catalog/pg_operator.h"
+#include "catalog/pg_trigger.h"
 #include "commands/cluster.h"
 #include "commands/matview.h"
 #include "commands/tablecmds.h"
 #include "commands/tablespace.h"
+#include "commands/trigger.h"
 #include "executor/executor.h"
 #include "executor/spi.h"
+#include "executor/tstoreReceiver.h"
 #include "miscadmin.h"
+#include "nodes/makefuncs.h"
+#include "nodes/nodeFuncs.h"
+#include "optimizer/clauses.h"
 #include "parser/parse_relation.h"
+#include "parser/parser.h"
 #include "pgstat.h"
 #include "rewrite/rewriteHandler.h"
 #include "storage/lmgr.h"
 #include "storage/smgr.h"
 #include "tcop/tcopprot.h"
 #include "utils/builtins.h"
+#include "utils/guc.h"
 #include "utils/lsyscache.h"
+#include "utils/memutils.h"
+#include "utils/queryenvironment.h"
 #include "utils/rel.h"
+#include "utils/rls.h"
 #include "utils/snapmgr.h"
 #include "utils/syscache.h"
+#include "utils/typcache.h"
 
 
 typedef struct
@@ -55,8 +70,28 @@ typedef struct
 	BulkInsertState bistate;	/* bulk insert state */
 } DR_transientrel;
 
+/*
+ * A statement in progress on a base table of an incrementally maintained
+ * materialized view over a join.  These are kept in TopTransactionContext.
+ */
+typedef struct IvmPendingStatement
+{
+	Oid			matviewOid;		/* the view to maintain */
+	Oid			relid;			/* the base table being modified */
+	SubTransactionId subid;		/* subtransaction the statement started in */
+} IvmPendingStatement;
+
+/* Names of the ephemeral relations used during incremental maintenance */
+#define IVM_CHANGES_ENR		"__ivm_changes"
+#define IVM_DELTA_ENR		"__ivm_delta"
+
+/* Source text reported for the delta queries we plan and run ourselves */
+#define IVM_QUERY_STRING	"incremental materialized view maintenance"
+
 static int	matview_maintenance_depth = 0;
 
+static List *ivm_pending_statements = NIL;
+
 static void transientrel_startup(DestReceiver *self, int operation, TupleDesc typeinfo);
 static bool transientrel_receive(TupleTableSlot *slot, DestReceiver *self);
 static void transientrel_shutdown(DestReceiver *self);
@@ -70,6 +105,17 @@ static void refresh_by_heap_swap(Oid matviewOid, Oid OIDNewHeap, char relpersist
 static bool is_usable_unique_index(Relation indexRel);
 static void OpenMatViewIncrementalMaintenance(void);
 static void CloseMatViewIncrementalMaintenance(void);
+static Query *get_matview_query(Relation matviewRel);
+static List *check_ivm_query(Query *query);
+static bool check_ivm_query_walker(Node *node, void *context);
+static void create_ivm_trigger(Oid relid, const ObjectAddress *matviewAddr,
+				   int16 timing, int16 events);
+static List *ivm_base_tables(Query *query, Oid matviewOid);
+static void ivm_check_pending_statements(Relation matviewRel, Oid relid);
+static Tuplestorestate *ivm_compute_delta(Relation matviewRel, Query *query,
+				  Relation baseRel, Tuplestorestate *changes);
+static void ivm_apply_delta(Relation matviewRel, Tuplestorestate *delta,
+				bool insert);
 
 /*
  * SetMatViewPopulatedState
@@ -111,6 +157,50 @@ SetMatViewPopulatedState(Relation relation, bool newstate)
 	CommandCounterIncrement();
 }
 
+/*
+ * get_matview_query
+ *		Return the query stored in a materialized view's SELECT rule.
+ *
+ * The result points into the relcache entry, so callers that want to modify
+ * it must make a copy.
+ */
+static Query *
+get_matview_query(Relation matviewRel)
+{
+	RewriteRule *rule;
+	List	   *actions;
+
+	/* Problems at this point are internal errors, so elog is sufficient. */
+	if (matviewRel->rd_rel->relhasrules == false ||
+		matviewRel->rd_rules->numLocks < 1)
+		elog(ERROR,
+			 "materialized view \"%s\" is missing rewrite information",
+			 RelationGetRelationName(matviewRel));
+
+	if (matviewRel->rd_rules->numLocks > 1)
+		elog(ERROR,
+			 "materialized view \"%s\" has too many rules",
+			 RelationGetRelationName(matviewRel));
+
+	rule = matviewRel->rd_rules->rules[0];
+	if (rule->event != CMD_SELECT || !(rule->isInstead))
+		elog(ERROR,
+			 "the rule for materialized view \"%s\" is not a SELECT INSTEAD OF rule",
+			 RelationGetRelationName(matviewRel));
+
+	actions = rule->actions;
+	if (list_length(actions) != 1)
+		elog(ERROR,
+			 "the rule for materialized view \"%s\" is not a single action",
+			 RelationGetRelationName(matviewRel));
+
+	/*
+	 * The stored query was rewritten at the time of the MV definition, but
+	 * has not been scribbled on by the planner.
+	 */
+	return linitial_node(Query, actions);
+}
+
 /*
  * ExecRefreshMatView -- execute a REFRESH MATERIALIZED VIEW command
  *
@@ -137,8 +227,6 @@ ExecRefreshMatView(RefreshMatViewStmt *stmt, const char *queryString,
 {
 	Oid			matviewOid;
 	Relation	matviewRel;
-	RewriteRule *rule;
-	List	   *actions;
 	Query	   *dataQuery;
 	Oid			tableSpace;
 	Oid			relowner;
@@ -184,32 +272,8 @@ ExecRefreshMatView(RefreshMatViewStmt *stmt, const char *queryString,
 				(errcode(ERRCODE_SYNTAX_ERROR),
 				 errmsg("CONCURRENTLY and WITH NO DATA options cannot be used together")));
 
-	/*
-	 * Check that everything is correct for a refresh. Problems at this point
-	 * are internal errors, so elog is sufficient.
-	 */
-	if (matviewRel->rd_rel->relhasrules == false ||
-		matviewRel->rd_rules->numLocks < 1)
-		elog(ERROR,
-			 "materialized view \"%s\" is missing rewrite information",
-			 RelationGetRelationName(matviewRel));
-
-	if (matviewRel->rd_rules->numLocks > 1)
-		elog(ERROR,
-			 "materialized view \"%s\" has too many rules",
-			 RelationGetRelationName(matviewRel));
-
-	rule = matviewRel->rd_rules->rules[0];
-	if (rule->event != CMD_SELECT || !(rule->isInstead))
-		elog(ERROR,
-			 "the rule for materialized view \"%s\" is not a SELECT INSTEAD OF rule",
-			 RelationGetRelationName(matviewRel));
-
-	actions = rule->actions;
-	if (list_length(actions) != 1)
-		elog(ERROR,
-			 "the rule for materialized view \"%s\" is not a single action",
-			 RelationGetRelationName(matviewRel));
+	/* Check that everything is correct for a refresh. */
+	dataQuery = get_matview_query(matviewRel);
 
 	/*
 	 * Check that there is a unique index with no WHERE clause on one or more
@@ -244,12 +308,6 @@ ExecRefreshMatView(RefreshMatViewStmt *stmt, const char *queryString,
 					 errhint("Create a unique index with no WHERE clause on one or more columns of the materialized view.")));
 	}
 
-	/*
-	 * The stored query was rewritten at the time of the MV definition, but
-	 * has not been scribbled on by the planner.
-	 */
-	dataQuery = linitial_node(Query, actions);
-
 	/*
 	 * Check for active uses of the relation in the current transaction, such
 	 * as open scans.
@@ -388,7 +446,7 @@ refresh_matview_datafill(DestReceiver *dest, Query *query,
 	CHECK_FOR_INTERRUPTS();
 
 	/* Plan the query which will generate data for the refresh. */
-	plan = pg_plan_query(query, 0, NULL);
+	plan = pg_plan_query(query, queryString, 0, NULL);
 
 	/*
 	 * Use a snapshot with an updated command ID to ensure this query sees
@@ -475,25 +533,17 @@ static bool
 transientrel_receive(TupleTableSlot *slot, DestReceiver *self)
 {
 	DR_transientrel *myState = (DR_transientrel *) self;
-	HeapTuple	tuple;
-
-	/*
-	 * get the heap tuple out of the tuple table slot, making sure we have a
-	 * writable copy
-	 */
-	tuple = ExecCopySlotHeapTuple(slot);
+	ItemPointerData tid;
 
-	heap_insert(myState->transientrel,
-				tuple,
-				myState->output_cid,
-				myState->hi_options,
-				myState->bistate);
+	table_tuple_insert(myState->transientrel,
+					   slot,
+					   myState->output_cid,
+					   myState->hi_options,
+					   myState->bistate,
+					   &tid);
 
 	/* We know this is a newly created relation, so there are no indexes */
 
-	/* Free the copied tuple. */
-	heap_freetuple(tuple);
-
 	return true;
 }
 
@@ -926,3 +976,814 @@ CloseMatViewIncrementalMaintenance(void)
 	matview_maintenance_depth--;
 	Assert(matview_maintenance_depth >= 0);
 }
+
+/*
+ * Incremental maintenance
+ *
+ * A materialized view created WITH (incremental_maintenance) is kept up to
+ * date by AFTER ... FOR EACH STATEMENT triggers on each of its base tables.
+ * The triggers receive the rows changed by the statement as transition
+ * tables.  Substituting a transition table for its base table in a copy of
+ * the view's query and running that gives exactly the rows to be added to or
+ * removed from the view, as long as the query is a plain select-project-join
+ * over tables; check_ivm_query() enforces that when the view is created.
+ *
+ * For a view over a join, the delta is computed against the current contents
+ * of the other tables.  That is only right if no other base table of the view
+ * is modified by the same statement, which BEFORE STATEMENT triggers keep
+ * track of, and if our snapshot sees the changes made by every transaction
+ * that maintained the view before us.  The latter is ensured by taking an
+ * ExclusiveLock on the view before a new snapshot, which doesn't work in the
+ * transaction-snapshot isolation levels.
+ */
+
+/*
+ * CreateMatViewMaintenanceTriggers
+ *		Create the triggers that maintain a materialized view incrementally.
+ *
+ * viewQuery is the view's query as it came out of parse analysis.  We raise
+ * an error if it's not something we know how to maintain.
+ */
+void
+CreateMatViewMaintenanceTriggers(Oid matviewOid, Query *viewQuery)
+{
+	ObjectAddress matviewAddr;
+	List	   *relids;
+	ListCell   *lc;
+
+	relids = check_ivm_query(viewQuery);
+
+	ObjectAddressSet(matviewAddr, RelationRelationId, matviewOid);
+
+	foreach(lc, relids)
+	{
+		Oid			relid = lfirst_oid(lc);
+
+		if (list_length(relids) > 1)
+			create_ivm_trigger(relid, &matviewAddr, TRIGGER_TYPE_BEFORE,
+							   TRIGGER_TYPE_INSERT | TRIGGER_TYPE_UPDATE |
+							   TRIGGER_TYPE_DELETE);
+		create_ivm_trigger(relid, &matviewAddr, TRIGGER_TYPE_AFTER,
+						   TRIGGER_TYPE_INSERT);
+		create_ivm_trigger(relid, &matviewAddr, TRIGGER_TYPE_AFTER,
+						   TRIGGER_TYPE_UPDATE);
+		create_ivm_trigger(relid, &matviewAddr, TRIGGER_TYPE_AFTER,
+						   TRIGGER_TYPE_DELETE);
+		create_ivm_trigger(relid, &matviewAddr, TRIGGER_TYPE_AFTER,
+						   TRIGGER_TYPE_TRUNCATE);
+	}
+}
+
+/*
+ * check_ivm_query
+ *		Make sure a materialized view's query can be maintained incrementally.
+ *
+ * Returns the OIDs of the tables the query reads.
+ */
+static List *
+check_ivm_query(Query *query)
+{
+	List	   *relids = NIL;
+	ListCell   *lc;
+	int			ncolumns = 0;
+	const char *feature = NULL;
+
+	if (query->hasAggs)
+		feature = "aggregate functions";
+	else if (query->groupClause != NIL || query->groupingSets != NIL)
+		feature = "GROUP BY";
+	else if (query->havingQual != NULL)
+		feature = "HAVING";
+	else if (query->hasWindowFuncs)
+		feature = "window functions";
+	else if (query->distinctClause != NIL)
+		feature = "DISTINCT";
+	else if (query->sortClause != NIL)
+		feature = "ORDER BY";
+	else if (query->limitCount != NULL || query->limitOffset != NULL)
+		feature = "LIMIT and OFFSET";
+	else if (query->setOperations != NULL)
+		feature = "UNION, INTERSECT, or EXCEPT";
+	else if (query->cteList != NIL)
+		feature = "WITH";
+	else if (query->hasSubLinks)
+		feature = "subqueries";
+	else if (query->hasTargetSRFs)
+		feature = "set-returning functions";
+	else if (query->rowMarks != NIL)
+		feature = "FOR UPDATE and FOR SHARE";
+	else if (contain_mutable_functions((Node *) query))
+		feature = "mutable functions";
+
+	if (feature != NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("incrementally maintained materialized views do not support %s",
+						feature)));
+
+	foreach(lc, query->rtable)
+	{
+		RangeTblEntry *rte = lfirst_node(RangeTblEntry, lc);
+
+		switch (rte->rtekind)
+		{
+			case RTE_RELATION:
+				if (rte->relkind != RELKIND_RELATION)
+					ereport(ERROR,
+							(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+							 errmsg("incrementally maintained materialized views can only read from tables"),
+							 errdetail("\"%s\" is not a table.",
+									   get_rel_name(rte->relid))));
+				if (rte->tablesample != NULL)
+					ereport(ERROR,
+							(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+							 errmsg("TABLESAMPLE is not supported in incrementally maintained materialized views")));
+				if (list_member_oid(relids, rte->relid))
+					ereport(ERROR,
+							(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+							 errmsg("incrementally maintained materialized views cannot read a table more than once"),
+							 errdetail("\"%s\" appears more than once in the query.",
+									   get_rel_name(rte->relid))));
+				if (has_subclass(rte->relid))
+					ereport(ERROR,
+							(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+							 errmsg("incrementally maintained materialized views cannot read inheritance parents"),
+							 errdetail("\"%s\" has inheritance children.",
+									   get_rel_name(rte->relid))));
+				if (check_enable_rls(rte->relid, InvalidOid, false) == RLS_ENABLED)
+					ereport(ERROR,
+							(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+							 errmsg("incrementally maintained materialized views cannot read tables with row-level security"),
+							 errdetail("Row-level security is enabled for \"%s\".",
+									   get_rel_name(rte->relid))));
+				relids = lappend_oid(relids, rte->relid);
+				break;
+			case RTE_JOIN:
+				if (rte->jointype != JOIN_INNER)
+					ereport(ERROR,
+							(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+							 errmsg("outer joins are not supported in incrementally maintained materialized views")));
+				break;
+			default:
+				ereport(ERROR,
+						(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+						 errmsg("incrementally maintained materialized views can only read from tables")));
+				break;
+		}
+	}
+
+	/*
+	 * System columns differ between a table and its transition tables, and
+	 * whole-row references would have the wrong row type once a transition
+	 * table is substituted.
+	 */
+	(void) query_tree_walker(query, check_ivm_query_walker, NULL, 0);
+
+	/* Deleting rows from the view needs equality on every column. */
+	foreach(lc, query->targetList)
+	{
+		TargetEntry *tle = lfirst_node(TargetEntry, lc);
+		Oid			typid;
+		TypeCacheEntry *typentry;
+
+		if (tle->resjunk)
+			continue;
+
+		typid = exprType((Node *) tle->expr);
+		typentry = lookup_type_cache(typid, TYPECACHE_EQ_OPR);
+		if (!OidIsValid(typentry->eq_opr))
+			ereport(ERROR,
+					(errcode(ERRCODE_UNDEFINED_FUNCTION),
+					 errmsg("could not identify an equality operator for type %s",
+							format_type_be(typid)),
+					 errdetail("Every column of an incrementally maintained materialized view needs an equality operator.")));
+		ncolumns++;
+	}
+
+	if (ncolumns == 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("incrementally maintained materialized views must have at least one column")));
+
+	return relids;
+}
+
+static bool
+check_ivm_query_walker(Node *node, void *context)
+{
+	if (node == NULL)
+		return false;
+	if (IsA(node, Var) && ((Var *) node)->varattno <= 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("system columns and whole-row references are not supported in incrementally maintained materialized views")));
+	return expression_tree_walker(node, check_ivm_query_walker, context);
+}
+
+/*
+ * create_ivm_trigger
+ *		Create one internal statement-level trigger on a base table.
+ *
+ * AFTER triggers get the transition tables their event provides.  The
+ * trigger is dropped along with the view.
+ */
+static void
+create_ivm_trigger(Oid relid, const ObjectAddress *matviewAddr,
+				   int16 timing, int16 events)
+{
+	CreateTrigStmt *ivm_trigger;
+	ObjectAddress trigAddr;
+	List	   *transitionRels = NIL;
+
+	ivm_trigger = makeNode(CreateTrigStmt);
+	ivm_trigger->relation = NULL;
+	ivm_trigger->row = false;
+	ivm_trigger->timing = timing;
+	ivm_trigger->events = events;
+
+	if (timing == TRIGGER_TYPE_BEFORE)
+	{
+		ivm_trigger->trigname = "IVM_trigger_before";
+		ivm_trigger->funcname = SystemFuncName("ivm_immediate_before");
+	}
+	else
+	{
+		switch (events)
+		{
+			case TRIGGER_TYPE_INSERT:
+				ivm_trigger->trigname = "IVM_trigger_ins";
+				break;
+			case TRIGGER_TYPE_UPDATE:
+				ivm_trigger->trigname = "IVM_trigger_upd";
+				break;
+			case TRIGGER_TYPE_DELETE:
+				ivm_trigger->trigname = "IVM_trigger_del";
+				break;
+			case TRIGGER_TYPE_TRUNCATE:
+				ivm_trigger->trigname = "IVM_trigger_truncate";
+				break;
+			default:
+				elog(ERROR, "unrecognized trigger event: %d", events);
+		}
+		ivm_trigger->funcname = SystemFuncName("ivm_immediate_maintenance");
+
+		if (events & (TRIGGER_TYPE_UPDATE | TRIGGER_TYPE_DELETE))
+		{
+			TriggerTransition *tt = makeNode(TriggerTransition);
+
+			tt->name = "__ivm_oldtable";
+			tt->isNew = false;
+			tt->isTable = true;
+			transitionRels = lappend(transitionRels, tt);
+		}
+		if (events & (TRIGGER_TYPE_INSERT | TRIGGER_TYPE_UPDATE))
+		{
+			TriggerTransition *tt = makeNode(TriggerTransition);
+
+			tt->name = "__ivm_newtable";
+			tt->isNew = true;
+			tt->isTable = true;
+			transitionRels = lappend(transitionRels, tt);
+		}
+	}
+
+	ivm_trigger->columns = NIL;
+	ivm_trigger->transitionRels = transitionRels;
+	ivm_trigger->whenClause = NULL;
+	ivm_trigger->isconstraint = false;
+	ivm_trigger->deferrable = false;
+	ivm_trigger->initdeferred = false;
+	ivm_trigger->constrrel = NULL;
+	ivm_trigger->args = list_make1(makeString(psprintf("%u",
+													   matviewAddr->objectId)));
+
+	trigAddr = CreateTrigger(ivm_trigger, NULL, relid, InvalidOid, InvalidOid,
+							 InvalidOid, InvalidOid, InvalidOid, NULL,
+							 true, false);
+
+	recordDependencyOn(&trigAddr, matviewAddr, DEPENDENCY_AUTO);
+
+	/* Make changes-so-far visible */
+	CommandCounterIncrement();
+}
+
+/*
+ * ivm_base_tables
+ *		Return the OIDs of the tables read by a materialized view's query.
+ *
+ * The stored query also contains entries for the view itself as OLD and NEW,
+ * which we must skip.
+ */
+static List *
+ivm_base_tables(Query *query, Oid matviewOid)
+{
+	List	   *relids = NIL;
+	ListCell   *lc;
+
+	foreach(lc, query->rtable)
+	{
+		RangeTblEntry *rte = lfirst_node(RangeTblEntry, lc);
+
+		if (rte->rtekind == RTE_RELATION && rte->relid != matviewOid)
+			relids = lappend_oid(relids, rte->relid);
+	}
+
+	return relids;
+}
+
+/*
+ * Fetch the materialized view OID a maintenance trigger was created for.
+ */
+static Oid
+ivm_trigger_matview(FunctionCallInfo fcinfo, const char *funcname)
+{
+	TriggerData *trigdata = (TriggerData *) fcinfo->context;
+
+	if (!CALLED_AS_TRIGGER(fcinfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_E_R_I_E_TRIGGER_PROTOCOL_VIOLATED),
+				 errmsg("function \"%s\" was not called by trigger manager",
+						funcname)));
+	if (!TRIGGER_FIRED_FOR_STATEMENT(trigdata->tg_event) ||
+		trigdata->tg_trigger->tgnargs != 1)
+		ereport(ERROR,
+				(errcode(ERRCODE_E_R_I_E_TRIGGER_PROTOCOL_VIOLATED),
+				 errmsg("function \"%s\" must be fired for STATEMENT",
+						funcname)));
+
+	return atooid(trigdata->tg_trigger->tgargs[0]);
+}
+
+/*
+ * ivm_immediate_before
+ *		BEFORE STATEMENT trigger on the base tables of a view over a join.
+ *
+ * Remembers that a statement is modifying the table, so that
+ * ivm_check_pending_statements() can tell whether the other tables of the
+ * join are stable.
+ */
+Datum
+ivm_immediate_before(PG_FUNCTION_ARGS)
+{
+	TriggerData *trigdata = (TriggerData *) fcinfo->context;
+	Oid			matviewOid;
+	IvmPendingStatement *pending;
+	MemoryContext oldcxt;
+
+	matviewOid = ivm_trigger_matview(fcinfo, "ivm_immediate_before");
+
+	oldcxt = MemoryContextSwitchTo(TopTransactionContext);
+	pending = (IvmPendingStatement *) palloc(sizeof(IvmPendingStatement));
+	pending->matviewOid = matviewOid;
+	pending->relid = RelationGetRelid(trigdata->tg_relation);
+	pending->subid = GetCurrentSubTransactionId();
+	ivm_pending_statements = lappend(ivm_pending_statements, pending);
+	MemoryContextSwitchTo(oldcxt);
+
+	return PointerGetDatum(NULL);
+}
+
+/*
+ * ivm_check_pending_statements
+ *		Forget the statement on relid that has just finished, and complain if
+ *		another base table of the view is modified by a statement in progress.
+ */
+static void
+ivm_check_pending_statements(Relation matviewRel, Oid relid)
+{
+	Oid			matviewOid = RelationGetRelid(matviewRel);
+	IvmPendingStatement *finished = NULL;
+	ListCell   *lc;
+
+	foreach(lc, ivm_pending_statements)
+	{
+		IvmPendingStatement *pending = (IvmPendingStatement *) lfirst(lc);
+
+		if (pending->matviewOid == matviewOid && pending->relid == relid)
+			finished = pending;
+	}
+
+	if (finished != NULL)
+	{
+		ivm_pending_statements = list_delete_ptr(ivm_pending_statements,
+												 finished);
+		pfree(finished);
+	}
+
+	foreach(lc, ivm_pending_statements)
+	{
+		IvmPendingStatement *pending = (IvmPendingStatement *) lfirst(lc);
+
+		if (pending->matviewOid == matviewOid && pending->relid != relid)
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("cannot maintain materialized view \"%s\" incrementally",
+							RelationGetRelationName(matviewRel)),
+					 errdetail("Tables \"%s\" and \"%s\" of the view are modified by the same statement.",
+							   get_rel_name(relid),
+							   get_rel_name(pending->relid))));
+	}
+}
+
+/*
+ * ivm_immediate_maintenance
+ *		AFTER STATEMENT trigger that applies a statement's changes to a base
+ *		table to an incrementally maintained materialized view.
+ */
+Datum
+ivm_immediate_maintenance(PG_FUNCTION_ARGS)
+{
+	TriggerData *trigdata = (TriggerData *) fcinfo->context;
+	Relation	baseRel = trigdata->tg_relation;
+	Oid			matviewOid;
+	Relation	matviewRel;
+	Query	   *query;
+	bool		isjoin;
+	Oid			relowner;
+	Oid			save_userid;
+	int			save_sec_context;
+	int			save_nestlevel;
+	int			old_depth = matview_maintenance_depth;
+
+	matviewOid = ivm_trigger_matview(fcinfo, "ivm_immediate_maintenance");
+
+	/*
+	 * Serialize with other maintenance and with REFRESH ... CONCURRENTLY.
+	 * Readers of the view aren't blocked.
+	 */
+	matviewRel = heap_open(matviewOid, ExclusiveLock);
+
+	query = get_matview_query(matviewRel);
+	isjoin = list_length(ivm_base_tables(query, matviewOid)) > 1;
+
+	/* Emptying any table of a join empties the view, so TRUNCATE is safe. */
+	if (isjoin && !TRIGGER_FIRED_BY_TRUNCATE(trigdata->tg_event))
+	{
+		ivm_check_pending_statements(matviewRel, RelationGetRelid(baseRel));
+
+		if (IsolationUsesXactSnapshot())
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("cannot maintain materialized view \"%s\" incrementally",
+							RelationGetRelationName(matviewRel)),
+					 errdetail("Materialized views over joins can only be maintained in READ COMMITTED transactions.")));
+	}
+
+	/* Nothing to do until the view is populated by REFRESH. */
+	if (!RelationIsPopulated(matviewRel))
+	{
+		heap_close(matviewRel, NoLock);
+		return PointerGetDatum(NULL);
+	}
+
+	/* Run as the view's owner, as REFRESH does. */
+	relowner = matviewRel->rd_rel->relowner;
+	GetUserIdAndSecContext(&save_userid, &save_sec_context);
+	SetUserIdAndSecContext(relowner,
+						   save_sec_context | SECURITY_RESTRICTED_OPERATION);
+	save_nestlevel = NewGUCNestLevel();
+
+	/* Look at the other tables as of after we got the lock. */
+	CommandCounterIncrement();
+	PushActiveSnapshot(GetTransactionSnapshot());
+
+	PG_TRY();
+	{
+		if (TRIGGER_FIRED_BY_TRUNCATE(trigdata->tg_event))
+			ivm_apply_delta(matviewRel, NULL, false);
+		else
+		{
+			Tuplestorestate *delta;
+
+			/* Remove the rows for old tuples before adding the new ones. */
+			if (trigdata->tg_oldtable != NULL)
+			{
+				delta = ivm_compute_delta(matviewRel, query, baseRel,
+										  trigdata->tg_oldtable);
+				ivm_apply_delta(matviewRel, delta, false);
+				tuplestore_end(delta);
+			}
+			if (trigdata->tg_newtable != NULL)
+			{
+				delta = ivm_compute_delta(matviewRel, query, baseRel,
+										  trigdata->tg_newtable);
+				ivm_apply_delta(matviewRel, delta, true);
+				tuplestore_end(delta);
+			}
+		}
+	}
+	PG_CATCH();
+	{
+		matview_maintenance_depth = old_depth;
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+	Assert(matview_maintenance_depth == old_depth);
+
+	PopActiveSnapshot();
+
+	heap_close(matviewRel, NoLock);
+
+	/* Roll back any GUC changes */
+	AtEOXact_GUC(false, save_nestlevel);
+
+	/* Restore userid and security context */
+	SetUserIdAndSecContext(save_userid, save_sec_context);
+
+	return PointerGetDatum(NULL);
+}
+
+/*
+ * ivm_compute_delta
+ *		Run the view's query with baseRel replaced by the given transition
+ *		table, returning the rows of the view that derive from those tuples.
+ */
+static Tuplestorestate *
+ivm_compute_delta(Relation matviewRel, Query *query, Relation baseRel,
+				  Tuplestorestate *changes)
+{
+	Query	   *copied_query;
+	QueryEnvironment *queryEnv;
+	EphemeralNamedRelation enr;
+	TupleDesc	tupdesc = RelationGetDescr(baseRel);
+	List	   *rewritten;
+	PlannedStmt *plan;
+	QueryDesc  *queryDesc;
+	DestReceiver *dest;
+	Tuplestorestate *delta;
+	ListCell   *lc;
+	int			attno;
+
+	enr = (EphemeralNamedRelation) palloc0(sizeof(EphemeralNamedRelationData));
+	enr->md.name = IVM_CHANGES_ENR;
+	enr->md.reliddesc = RelationGetRelid(baseRel);
+	enr->md.tupdesc = NULL;
+	enr->md.enrtype = ENR_NAMED_TUPLESTORE;
+	enr->md.enrtuples = tuplestore_tuple_count(changes);
+	enr->reldata = changes;
+
+	queryEnv = create_queryEnv();
+	register_ENR(queryEnv, enr);
+
+	/*
+	 * Substitute the transition table for the base table, copying the column
+	 * information the way addRangeTableEntryForENR() does.  We still insist
+	 * that the owner can read the table.
+	 */
+	copied_query = copyObject(query);
+	foreach(lc, copied_query->rtable)
+	{
+		RangeTblEntry *rte = lfirst_node(RangeTblEntry, lc);
+
+		if (rte->rtekind != RTE_RELATION ||
+			rte->relid != RelationGetRelid(baseRel))
+			continue;
+
+		if (!ExecCheckRTPerms(list_make1(rte), true))
+			elog(ERROR, "permission check for incremental maintenance failed");
+
+		rte->rtekind = RTE_NAMEDTUPLESTORE;
+		rte->relkind = 0;
+		rte->tablesample = NULL;
+		rte->inh = false;
+		rte->enrname = enr->md.name;
+		rte->enrtuples = enr->md.enrtuples;
+		rte->coltypes = NIL;
+		rte->coltypmods = NIL;
+		rte->colcollations = NIL;
+		for (attno = 1; attno <= tupdesc->natts; attno++)
+		{
+			Form_pg_attribute att = TupleDescAttr(tupdesc, attno - 1);
+
+			if (att->attisdropped)
+			{
+				rte->coltypes = lappend_oid(rte->coltypes, InvalidOid);
+				rte->coltypmods = lappend_int(rte->coltypmods, 0);
+				rte->colcollations = lappend_oid(rte->colcollations,
+												 InvalidOid);
+			}
+			else
+			{
+				rte->coltypes = lappend_oid(rte->coltypes, att->atttypid);
+				rte->coltypmods = lappend_int(rte->coltypmods,
+											  att->atttypmod);
+				rte->colcollations = lappend_oid(rte->colcollations,
+												 att->attcollation);
+			}
+		}
+		rte->requiredPerms = 0;
+		rte->checkAsUser = InvalidOid;
+		rte->selectedCols = NULL;
+		break;
+	}
+
+	/* The other tables mustn't have grown children since the view was made. */
+	foreach(lc, copied_query->rtable)
+	{
+		RangeTblEntry *rte = lfirst_node(RangeTblEntry, lc);
+
+		if (rte->rtekind == RTE_RELATION &&
+			rte->relid != RelationGetRelid(matviewRel) &&
+			has_subclass(rte->relid))
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("cannot maintain materialized view \"%s\" incrementally",
+							RelationGetRelationName(matviewRel)),
+					 errdetail("\"%s\" has inheritance children.",
+							   get_rel_name(rte->relid))));
+	}
+
+	AcquireRewriteLocks(copied_query, true, false);
+	rewritten = QueryRewrite(copied_query);
+
+	/* SELECT should never rewrite to more or less than one SELECT query */
+	if (list_length(rewritten) != 1)
+		elog(ERROR, "unexpected rewrite result for incremental maintenance");
+	copied_query = (Query *) linitial(rewritten);
+
+	CHECK_FOR_INTERRUPTS();
+
+	plan = pg_plan_query(copied_query, IVM_QUERY_STRING, 0, NULL);
+
+	delta = tuplestore_begin_heap(false, false, work_mem);
+	dest = CreateDestReceiver(DestTuplestore);
+	SetTuplestoreDestReceiverParams(dest, delta, CurrentMemoryContext, false);
+
+	queryDesc = CreateQueryDesc(plan, IVM_QUERY_STRING,
+								GetActiveSnapshot(), InvalidSnapshot,
+								dest, NULL, queryEnv, 0);
+
+	ExecutorStart(queryDesc, 0);
+	ExecutorRun(queryDesc, ForwardScanDirection, 0L, true);
+	ExecutorFinish(queryDesc);
+	ExecutorEnd(queryDesc);
+
+	FreeQueryDesc(queryDesc);
+	dest->rDestroy(dest);
+
+	return delta;
+}
+
+/*
+ * ivm_apply_delta
+ *		Insert the rows of delta into the view, or delete them from it.
+ *
+ * The view can contain duplicate rows, so each row of delta must remove only
+ * one matching row.  We group the delta, count the copies of each row, and
+ * delete that many matching rows by ctid.  A NULL delta means to empty the
+ * view.
+ */
+static void
+ivm_apply_delta(Relation matviewRel, Tuplestorestate *delta, bool insert)
+{
+	StringInfoData querybuf;
+	char	   *matviewname;
+	TupleDesc	tupdesc = RelationGetDescr(matviewRel);
+
+	if (delta != NULL && tuplestore_tuple_count(delta) == 0)
+		return;
+
+	matviewname = quote_qualified_identifier(get_namespace_name(RelationGetNamespace(matviewRel)),
+											 RelationGetRelationName(matviewRel));
+	initStringInfo(&querybuf);
+
+	if (SPI_connect() != SPI_OK_CONNECT)
+		elog(ERROR, "SPI_connect failed");
+
+	if (delta != NULL)
+	{
+		EphemeralNamedRelation enr;
+
+		enr = (EphemeralNamedRelation) palloc0(sizeof(EphemeralNamedRelationData));
+		enr->md.name = IVM_DELTA_ENR;
+		enr->md.reliddesc = InvalidOid;
+		enr->md.tupdesc = tupdesc;
+		enr->md.enrtype = ENR_NAMED_TUPLESTORE;
+		enr->md.enrtuples = tuplestore_tuple_count(delta);
+		enr->reldata = delta;
+
+		if (SPI_register_relation(enr) != SPI_OK_REL_REGISTER)
+			elog(ERROR, "SPI_register_relation failed");
+	}
+
+	if (delta == NULL)
+		appendStringInfo(&querybuf, "DELETE FROM %s", matviewname);
+	else if (insert)
+		appendStringInfo(&querybuf, "INSERT INTO %s SELECT * FROM %s",
+						 matviewname, IVM_DELTA_ENR);
+	else
+	{
+		StringInfoData columns;
+		StringInfoData quals;
+		int			i;
+
+		initStringInfo(&columns);
+		initStringInfo(&quals);
+
+		for (i = 0; i < tupdesc->natts; i++)
+		{
+			Form_pg_attribute attr = TupleDescAttr(tupdesc, i);
+			const char *colname = quote_identifier(NameStr(attr->attname));
+			const char *mvcol = quote_qualified_identifier("mv",
+														   NameStr(attr->attname));
+			const char *deltacol = quote_qualified_identifier("d",
+															  NameStr(attr->attname));
+			TypeCacheEntry *typentry;
+
+			typentry = lookup_type_cache(attr->atttypid, TYPECACHE_EQ_OPR);
+			if (!OidIsValid(typentry->eq_opr))
+				ereport(ERROR,
+						(errcode(ERRCODE_UNDEFINED_FUNCTION),
+						 errmsg("could not identify an equality operator for type %s",
+								format_type_be(attr->atttypid))));
+
+			if (i > 0)
+			{
+				appendStringInfoString(&columns, ", ");
+				appendStringInfoString(&quals, " AND ");
+			}
+			appendStringInfoString(&columns, colname);
+
+			appendStringInfoString(&quals, "(");
+			generate_operator_clause(&quals, mvcol, attr->atttypid,
+									 typentry->eq_opr,
+									 deltacol, attr->atttypid);
+			appendStringInfo(&quals, " OR (%s IS NULL AND %s IS NULL))",
+							 mvcol, deltacol);
+		}
+
+		appendStringInfo(&querybuf,
+						 "DELETE FROM %s WHERE ctid OPERATOR(pg_catalog.=) ANY "
+						 "(SELECT m.tid FROM "
+						 "(SELECT mv.ctid AS tid, d.__ivm_count, "
+						 "pg_catalog.row_number() OVER (PARTITION BY d.__ivm_group) AS __ivm_number "
+						 "FROM %s mv, "
+						 "(SELECT %s, pg_catalog.count(*) AS __ivm_count, "
+						 "pg_catalog.row_number() OVER () AS __ivm_group "
+						 "FROM %s GROUP BY %s) d "
+						 "WHERE %s) m "
+						 "WHERE m.__ivm_number OPERATOR(pg_catalog.<=) m.__ivm_count)",
+						 matviewname, matviewname, columns.data,
+						 IVM_DELTA_ENR, columns.data, quals.data);
+	}
+
+	OpenMatViewIncrementalMaintenance();
+
+	if (SPI_exec(querybuf.data, 0) != (insert ? SPI_OK_INSERT : SPI_OK_DELETE))
+		elog(ERROR, "SPI_exec failed: %s", querybuf.data);
+
+	CloseMatViewIncrementalMaintenance();
+
+	if (SPI_finish() != SPI_OK_FINISH)
+		elog(ERROR, "SPI_finish failed");
+}
+
+/*
+ * AtEOXact_MatView
+ *		Forget statements in progress at transaction end.
+ *
+ * The list itself lives in TopTransactionContext, so there is nothing to
+ * free.
+ */
+void
+AtEOXact_MatView(bool isCommit)
+{
+	ivm_pending_statements = NIL;
+}
+
+/*
+ * AtEOSubXact_MatView
+ *		Forget the statements of an aborted subtransaction, or hand those of a
+ *		committed one to its parent.
+ */
+void
+AtEOSubXact_MatView(bool isCommit, SubTransactionId mySubid,
+					SubTransactionId parentSubid)
+{
+	List	   *remaining = NIL;
+	ListCell   *lc;
+	MemoryContext oldcxt;
+
+	if (ivm_pending_statements == NIL)
+		return;
+
+	oldcxt = MemoryContextSwitchTo(TopTransactionContext);
+	foreach(lc, ivm_pending_statements)
+	{
+		IvmPendingStatement *pending = (IvmPendingStatement *) lfirst(lc);
+
+		if (pending->subid == mySubid)
+		{
+			if (!isCommit)
+			{
+				pfree(pending);
+				continue;
+			}
+			pending->subid = parentSubid;
+		}
+		remaining = lappend(remaining, pending);
+	}
+	list_free(ivm_pending_statements);
+	ivm_pending_statements = remaining;
+	MemoryContextSwitchTo(oldcxt);
+}
@@ -29,6 +29,7 @@
 #include "parser/parse_collate.h"
 #include "parser/parse_expr.h"
 #include "parser/parse_type.h"
+#include "portability/instr_time.h"
 #include "rewrite/rewriteHandler.h"
 #include "tcop/pquery.h"
 #include "tcop/utility.h"
@@ -210,6 +211,7 @@ ExecuteQuery(ExecuteStmt *stmt, IntoClause *intoClause,
 	char	   *query_string;
 	int			eflags;
 	long		count;
+	instr_time	starttime;
 
 	/* Look it up in the hash table */
 	entry = FetchPreparedStatement(stmt->name, true);
@@ -301,8 +303,27 @@ ExecuteQuery(ExecuteStmt *stmt, IntoClause *intoClause,
 	 */
 	PortalStart(portal, paramLI, eflags, GetActiveSnapshot());
 
+	if (plan_cache_mode == PLAN_CACHE_MODE_ADAPTIVE)
+		INSTR_TIME_SET_CURRENT(starttime);
+
 	(void) PortalRun(portal, count, false, true, dest, dest, completionTag);
 
+	/*
+	 * Report the run time for the plan cache's benefit.  Running the query
+	 * could conceivably have dropped the prepared statement, so look it up
+	 * again.
+	 */
+	if (plan_cache_mode == PLAN_CACHE_MODE_ADAPTIVE &&
+		FetchPreparedStatement(stmt->name, false) == entry)
+	{
+		instr_time	duration;
+
+		INSTR_TIME_SET_CURRENT(duration);
+		INSTR_TIME_SUBTRACT(duration, starttime);
+		CachedPlanRecordRuntime(entry->plansource, cplan,
+								INSTR_TIME_GET_MILLISEC(duration));
+	}
+
 	PortalDrop(portal, false);
 
 	if (estate)
@@ -594,6 +615,16 @@ DropPreparedStatement(const char *stmt_name, bool showError)
 	}
 }
 
+/*
+ * Report whether there are any prepared statements.
+ */
+bool
+HavePreparedStatements(void)
+{
+	return prepared_queries != NULL &&
+		hash_get_num_entries(prepared_queries) > 0;
+}
+
 /*
  * Drop all cached statements.
  */
@@ -29,6 +29,7 @@
 #include "catalog/objectaccess.h"
 #include "catalog/objectaddress.h"
 #include "catalog/pg_inherits.h"
+#include "catalog/pg_proc.h"
 #include "catalog/pg_type.h"
 #include "catalog/pg_publication.h"
 #include "catalog/pg_publication_rel.h"
@@ -38,6 +39,12 @@
 #include "commands/event_trigger.h"
 #include "commands/publicationcmds.h"
 
+#include "nodes/nodeFuncs.h"
+
+#include "parser/parse_clause.h"
+#include "parser/parse_collate.h"
+#include "parser/parse_relation.h"
+
 #include "utils/array.h"
 #include "utils/builtins.h"
 #include "utils/catcache.h"
@@ -56,6 +63,7 @@ static void CloseTableList(List *rels);
 static void PublicationAddTables(Oid pubid, List *rels, bool if_not_exists,
 					 AlterPublicationStmt *stmt);
 static void PublicationDropTables(Oid pubid, List *rels, bool missing_ok);
+static Node *transformPublicationWhereClause(Relation rel, Node *whereClause);
 
 static void
 parse_publication_options(List *options,
@@ -289,6 +297,10 @@ AlterPublicationOptions(AlterPublicationStmt *stmt, Relation rel,
 
 	pubform = (Form_pg_publication) GETSTRUCT(tup);
 
+	/* Column lists and row filters rely on the published actions. */
+	if (publish_given)
+		publication_check_relation_filters(pubform->oid);
+
 	/* Invalidate the relcache. */
 	if (pubform->puballtables)
 	{
@@ -357,31 +369,45 @@ AlterPublicationTables(AlterPublicationStmt *stmt, Relation rel,
 		List	   *delrels = NIL;
 		ListCell   *oldlc;
 
-		/* Calculate which relations to drop. */
+		/*
+		 * Calculate which relations to drop.  A relation that stays in the
+		 * publication is dropped and added back too if either its old or its
+		 * new entry has a column list or row filter, so that those get
+		 * replaced.
+		 */
 		foreach(oldlc, oldrelids)
 		{
 			Oid			oldrelid = lfirst_oid(oldlc);
 			ListCell   *newlc;
-			bool		found = false;
+			PublicationRelInfo *newpri = NULL;
+			PublicationRelInfo *oldpri;
 
 			foreach(newlc, rels)
 			{
-				Relation	newrel = (Relation) lfirst(newlc);
+				PublicationRelInfo *pri = (PublicationRelInfo *) lfirst(newlc);
 
-				if (RelationGetRelid(newrel) == oldrelid)
+				if (RelationGetRelid(pri->relation) == oldrelid)
 				{
-					found = true;
+					newpri = pri;
 					break;
 				}
 			}
 
-			if (!found)
+			if (newpri != NULL &&
+				newpri->columns == NIL && newpri->whereClause == NULL)
 			{
-				Relation	oldrel = heap_open(oldrelid,
-											   ShareUpdateExclusiveLock);
+				Bitmapset  *oldcolumns;
+				Node	   *oldqual;
 
-				delrels = lappend(delrels, oldrel);
+				GetPublicationRelationFilters(pubid, oldrelid,
+											  &oldcolumns, &oldqual);
+				if (oldcolumns == NULL && oldqual == NULL)
+					continue;
 			}
+
+			oldpri = palloc0(sizeof(PublicationRelInfo));
+			oldpri->relation = heap_open(oldrelid, ShareUpdateExclusiveLock);
+			delrels = lappend(delrels, oldpri);
 		}
 
 		/* And drop them. */
@@ -494,7 +520,9 @@ RemovePublicationRelById(Oid proid)
 }
 
 /*
- * Open relations specified by a RangeVar list.
+ * Open relations specified by a list of PublicationTable or RangeVar nodes,
+ * returning a list of PublicationRelInfo.  Inheritance children get the
+ * column list and row filter of their parent.
  * The returned tables are locked in ShareUpdateExclusiveLock mode.
  */
 static List *
@@ -509,10 +537,25 @@ OpenTableList(List *tables)
 	 */
 	foreach(lc, tables)
 	{
-		RangeVar   *rv = castNode(RangeVar, lfirst(lc));
-		bool		recurse = rv->inh;
+		RangeVar   *rv;
+		List	   *columns = NIL;
+		Node	   *whereClause = NULL;
+		bool		recurse;
 		Relation	rel;
 		Oid			myrelid;
+		PublicationRelInfo *pri;
+
+		if (IsA(lfirst(lc), PublicationTable))
+		{
+			PublicationTable *pt = (PublicationTable *) lfirst(lc);
+
+			rv = pt->relation;
+			columns = pt->columns;
+			whereClause = pt->whereClause;
+		}
+		else
+			rv = castNode(RangeVar, lfirst(lc));
+		recurse = rv->inh;
 
 		/* Allow query cancel in case this takes a long time */
 		CHECK_FOR_INTERRUPTS();
@@ -533,7 +576,11 @@ OpenTableList(List *tables)
 			continue;
 		}
 
-		rels = lappend(rels, rel);
+		pri = palloc(sizeof(PublicationRelInfo));
+		pri->relation = rel;
+		pri->columns = columns;
+		pri->whereClause = whereClause;
+		rels = lappend(rels, pri);
 		relids = lappend_oid(relids, myrelid);
 
 		/* Add children of this rel, if requested */
@@ -561,7 +608,11 @@ OpenTableList(List *tables)
 
 				/* find_all_inheritors already got lock */
 				rel = heap_open(childrelid, NoLock);
-				rels = lappend(rels, rel);
+				pri = palloc(sizeof(PublicationRelInfo));
+				pri->relation = rel;
+				pri->columns = columns;
+				pri->whereClause = whereClause;
+				rels = lappend(rels, pri);
 				relids = lappend_oid(relids, childrelid);
 			}
 		}
@@ -582,10 +633,93 @@ CloseTableList(List *rels)
 
 	foreach(lc, rels)
 	{
-		Relation	rel = (Relation) lfirst(lc);
+		PublicationRelInfo *pri = (PublicationRelInfo *) lfirst(lc);
+
+		heap_close(pri->relation, NoLock);
+	}
+}
+
+/*
+ * Check that a node of a row filter can be evaluated during logical
+ * decoding.  Decoding uses a historic catalog snapshot, under which only
+ * catalog contents can be trusted, so the filter must be built from
+ * immutable built-in functions and types only.
+ */
+static bool
+publication_where_func_checker(Oid func_id, void *context)
+{
+	return func_id >= FirstNormalObjectId ||
+		func_volatile(func_id) != PROVOLATILE_IMMUTABLE;
+}
+
+static bool
+publication_where_walker(Node *node, Relation rel)
+{
+	if (node == NULL)
+		return false;
+
+	if (IsA(node, Var))
+	{
+		Var		   *var = (Var *) node;
 
-		heap_close(rel, NoLock);
+		if (var->varattno == 0)
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("cannot use whole-row reference in publication WHERE expression")));
+		if (var->varattno < 0)
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("cannot use system column \"%s\" in publication WHERE expression",
+							get_attname(RelationGetRelid(rel), var->varattno,
+										false))));
+		if (var->vartype >= FirstNormalObjectId)
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("cannot use column of user-defined type in publication WHERE expression")));
 	}
+	else if (IsA(node, Const))
+	{
+		if (((Const *) node)->consttype >= FirstNormalObjectId)
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("cannot use constant of user-defined type in publication WHERE expression")));
+	}
+	else if (check_functions_in_node(node, publication_where_func_checker,
+									 NULL))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("publication WHERE expression can only use immutable built-in functions and operators")));
+
+	return expression_tree_walker(node, publication_where_walker,
+								  (void *) rel);
+}
+
+/*
+ * Transform the row filter of a publication table into a boolean expression
+ * over the columns of rel.
+ */
+static Node *
+transformPublicationWhereClause(Relation rel, Node *whereClause)
+{
+	ParseState *pstate;
+	RangeTblEntry *rte;
+	Node	   *qual;
+
+	pstate = make_parsestate(NULL);
+	rte = addRangeTableEntryForRelation(pstate, rel, AccessShareLock,
+										NULL, false, false);
+	addRTEtoQuery(pstate, rte, false, true, true);
+
+	qual = transformWhereClause(pstate, copyObject(whereClause),
+								EXPR_KIND_PUBLICATION_WHERE,
+								"PUBLICATION WHERE");
+	assign_expr_collations(pstate, qual);
+
+	(void) publication_where_walker(qual, rel);
+
+	free_parsestate(pstate);
+
+	return qual;
 }
 
 /*
@@ -601,7 +735,8 @@ PublicationAddTables(Oid pubid, List *rels, bool if_not_exists,
 
 	foreach(lc, rels)
 	{
-		Relation	rel = (Relation) lfirst(lc);
+		PublicationRelInfo *pri = (PublicationRelInfo *) lfirst(lc);
+		Relation	rel = pri->relation;
 		ObjectAddress obj;
 
 		/* Must be owner of the table or superuser. */
@@ -609,7 +744,11 @@ PublicationAddTables(Oid pubid, List *rels, bool if_not_exists,
 			aclcheck_error(ACLCHECK_NOT_OWNER, get_relkind_objtype(rel->rd_rel->relkind),
 						   RelationGetRelationName(rel));
 
-		obj = publication_add_relation(pubid, rel, if_not_exists);
+		if (pri->whereClause != NULL)
+			pri->whereClause = transformPublicationWhereClause(rel,
+															   pri->whereClause);
+
+		obj = publication_add_relation(pubid, pri, if_not_exists);
 		if (stmt)
 		{
 			EventTriggerCollectSimpleCommand(obj, InvalidObjectAddress,
@@ -633,7 +772,8 @@ PublicationDropTables(Oid pubid, List *rels, bool missing_ok)
 
 	foreach(lc, rels)
 	{
-		Relation	rel = (Relation) lfirst(lc);
+		PublicationRelInfo *pri = (PublicationRelInfo *) lfirst(lc);
+		Relation	rel = pri->relation;
 		Oid			relid = RelationGetRelid(rel);
 
 		prid = GetSysCacheOid2(PUBLICATIONRELMAP, Anum_pg_publication_rel_oid,
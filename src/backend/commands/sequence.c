@@ -37,7 +37,9 @@
 #include "parser/parse_type.h"
 #include "storage/lmgr.h"
 #include "storage/proc.h"
+#include "storage/shmem.h"
 #include "storage/smgr.h"
+#include "storage/spin.h"
 #include "utils/acl.h"
 #include "utils/builtins.h"
 #include "utils/lsyscache.h"
@@ -53,6 +55,41 @@
  */
 #define SEQ_LOG_VALS	32
 
+/*
+ * Shared sequence cache.
+ *
+ * When shared_sequence_cache is set, nextval() on a permanent, non-cycling
+ * sequence hands out values from a range kept in shared memory, and only
+ * locks the sequence's buffer when the range has been used up.  Each refill
+ * WAL-logs SEQ_SHARED_LOG_VALS values at once and leaves the tuple's
+ * last_value at the end of the logged range, as if one backend had cached
+ * all of them.  As the page then never claims fewer values than have been
+ * handed out, values taken from the range need no WAL after a checkpoint
+ * either; after a crash the sequence simply continues past the range.
+ *
+ * Entries are keyed by the sequence's relfilenode, so rewriting the
+ * sequence implicitly leaves the old entry unused; it is removed when the
+ * old storage is unlinked.  setval() and ALTER SEQUENCE remove the entry
+ * explicitly.
+ */
+#define SEQ_SHARED_LOG_VALS	1024
+
+typedef struct SeqSharedEntry
+{
+	RelFileNode node;			/* hash key; must be first */
+	slock_t		mutex;			/* protects the fields below */
+	bool		empty;			/* no values left in the range? */
+	int64		next;			/* next value to hand out */
+	int64		last;			/* last value of the range */
+	int64		increment;		/* copy of the sequence's increment */
+	int64		cache;			/* copy of the sequence's cache size */
+} SeqSharedEntry;
+
+/* GUC variable */
+int			shared_sequence_cache = 0;
+
+static HTAB *SeqSharedHash = NULL;
+
 /*
  * The "special area" of a sequence's buffer page looks like this.
  */
@@ -105,6 +142,8 @@ static void init_params(ParseState *pstate, List *options, bool for_identity,
 			bool *need_seq_rewrite,
 			List **owned_by);
 static void do_setval(Oid relid, int64 next, bool iscalled);
+static SeqSharedEntry *seq_shared_enter(RelFileNode node);
+static bool seq_shared_fetch(RelFileNode node, SeqTable elm);
 static void process_owned_by(Relation seqrel, List *owned_by, bool for_identity);
 
 
@@ -456,6 +495,9 @@ AlterSequence(ParseState *pstate, AlterSeqStmt *stmt)
 	/* lock page's buffer and read tuple into new sequence structure */
 	(void) read_seq_tuple(seqrel, &buf, &datatuple);
 
+	/* values cached in shared memory may not fit the new parameters */
+	SequenceCacheForget(seqrel->rd_node);
+
 	/* copy the existing sequence data tuple, so it can be modified locally */
 	newdatatuple = heap_copytuple(&datatuple);
 	newdataform = (Form_pg_sequence_data) GETSTRUCT(newdatatuple);
@@ -586,6 +628,7 @@ nextval_internal(Oid relid, bool check_permissions)
 				rescnt = 0;
 	bool		cycle;
 	bool		logit = false;
+	SeqSharedEntry *shared = NULL;
 
 	/* open and lock sequence */
 	init_sequence(relid, &elm, &seqrel);
@@ -619,6 +662,15 @@ nextval_internal(Oid relid, bool check_permissions)
 		return elm->last;
 	}
 
+	/* take values from the shared cache, if there are any */
+	if (SeqSharedHash != NULL && RelationNeedsWAL(seqrel) &&
+		seq_shared_fetch(seqrel->rd_node, elm))
+	{
+		relation_close(seqrel, NoLock);
+		last_used_seq = elm;
+		return elm->last;
+	}
+
 	pgstuple = SearchSysCache1(SEQRELID, ObjectIdGetDatum(relid));
 	if (!HeapTupleIsValid(pgstuple))
 		elog(ERROR, "cache lookup failed for sequence %u", relid);
@@ -634,6 +686,24 @@ nextval_internal(Oid relid, bool check_permissions)
 	seq = read_seq_tuple(seqrel, &buf, &seqdatatuple);
 	page = BufferGetPage(buf);
 
+	/*
+	 * If the sequence can use the shared cache, and nobody refilled it while
+	 * we waited for the buffer lock, we'll refill it.  A sequence that
+	 * cycles can't, because the range of values wouldn't be contiguous.
+	 */
+	if (SeqSharedHash != NULL && RelationNeedsWAL(seqrel) &&
+		!cycle && incby != PG_INT64_MIN)
+	{
+		if (seq_shared_fetch(seqrel->rd_node, elm))
+		{
+			UnlockReleaseBuffer(buf);
+			relation_close(seqrel, NoLock);
+			last_used_seq = elm;
+			return elm->last;
+		}
+		shared = seq_shared_enter(seqrel->rd_node);
+	}
+
 	elm->increment = incby;
 	last = next = result = seq->last_value;
 	fetch = cache;
@@ -655,7 +725,13 @@ nextval_internal(Oid relid, bool check_permissions)
 	 * checkpoint would fail to advance the sequence past the logged values.
 	 * In this case we may as well fetch extra values.
 	 */
-	if (log < fetch || !seq->is_called)
+	if (shared != NULL)
+	{
+		/* refill the shared cache, always logging */
+		fetch = log = fetch + SEQ_SHARED_LOG_VALS;
+		logit = true;
+	}
+	else if (log < fetch || !seq->is_called)
 	{
 		/* forced log to satisfy local demand for values */
 		fetch = log = fetch + SEQ_LOG_VALS;
@@ -800,13 +876,36 @@ nextval_internal(Oid relid, bool check_permissions)
 		PageSetLSN(page, recptr);
 	}
 
-	/* Now update sequence tuple to the intended final state */
-	seq->last_value = last;		/* last fetched number */
+	/*
+	 * Now update sequence tuple to the intended final state.  If the rest of
+	 * the logged values go to the shared cache, they count as fetched.
+	 */
+	if (shared != NULL)
+	{
+		seq->last_value = next;
+		seq->log_cnt = 0;
+	}
+	else
+	{
+		seq->last_value = last; /* last fetched number */
+		seq->log_cnt = log;		/* how much is logged */
+	}
 	seq->is_called = true;
-	seq->log_cnt = log;			/* how much is logged */
 
 	END_CRIT_SECTION();
 
+	if (shared != NULL)
+	{
+		SpinLockAcquire(&shared->mutex);
+		shared->empty = (next == last);
+		if (!shared->empty)
+			shared->next = last + incby;
+		shared->last = next;
+		shared->increment = incby;
+		shared->cache = cache;
+		SpinLockRelease(&shared->mutex);
+	}
+
 	UnlockReleaseBuffer(buf);
 
 	relation_close(seqrel, NoLock);
@@ -937,6 +1036,9 @@ do_setval(Oid relid, int64 next, bool iscalled)
 	/* lock page' buffer and read tuple */
 	seq = read_seq_tuple(seqrel, &buf, &seqdatatuple);
 
+	/* values cached in shared memory are based on the old state */
+	SequenceCacheForget(seqrel->rd_node);
+
 	if ((next < minv) || (next > maxv))
 	{
 		char		bufv[100],
@@ -1083,6 +1185,139 @@ create_seq_hashtable(void)
 							 HASH_ELEM | HASH_BLOBS);
 }
 
+/*
+ * Report shared memory space needed by the shared sequence cache.
+ */
+Size
+SequenceShmemSize(void)
+{
+	if (shared_sequence_cache <= 0)
+		return 0;
+	return hash_estimate_size(shared_sequence_cache, sizeof(SeqSharedEntry));
+}
+
+/*
+ * Allocate and initialize the shared sequence cache, if enabled.
+ */
+void
+SequenceShmemInit(void)
+{
+	HASHCTL		info;
+
+	if (shared_sequence_cache <= 0)
+		return;
+
+	MemSet(&info, 0, sizeof(info));
+	info.keysize = sizeof(RelFileNode);
+	info.entrysize = sizeof(SeqSharedEntry);
+
+	SeqSharedHash = ShmemInitHash("Shared Sequence Cache",
+								  shared_sequence_cache,
+								  shared_sequence_cache,
+								  &info,
+								  HASH_ELEM | HASH_BLOBS);
+}
+
+/*
+ * Forget the shared cache entry for a sequence's storage, if any.
+ *
+ * Called whenever the sequence's state changes other than by nextval(), and
+ * when the storage goes away.  For the former, the caller must hold the
+ * sequence's buffer lock, so that nobody refills the entry from the old
+ * state.
+ */
+void
+SequenceCacheForget(RelFileNode node)
+{
+	if (SeqSharedHash == NULL)
+		return;
+
+	LWLockAcquire(SequenceCacheLock, LW_EXCLUSIVE);
+	(void) hash_search(SeqSharedHash, &node, HASH_REMOVE, NULL);
+	LWLockRelease(SequenceCacheLock);
+}
+
+/*
+ * Find or create the shared cache entry for a sequence's storage, for the
+ * caller to refill.  The caller must hold the sequence's buffer lock.
+ * Returns NULL if the cache is full.
+ */
+static SeqSharedEntry *
+seq_shared_enter(RelFileNode node)
+{
+	SeqSharedEntry *entry;
+	bool		found;
+
+	LWLockAcquire(SequenceCacheLock, LW_EXCLUSIVE);
+	entry = (SeqSharedEntry *)
+		hash_search(SeqSharedHash, &node, HASH_ENTER_NULL, &found);
+	if (entry != NULL && !found)
+	{
+		SpinLockInit(&entry->mutex);
+		entry->empty = true;
+	}
+	LWLockRelease(SequenceCacheLock);
+
+	/*
+	 * Entries are only removed while holding the buffer lock, which we do,
+	 * so it's safe to keep using the entry without SequenceCacheLock.
+	 */
+	return entry;
+}
+
+/*
+ * Take the next values from the shared cache for nextval(), filling the
+ * backend-local cache in elm just like nextval_internal() would.  Returns
+ * false if the sequence has no shared cache entry or the range is used up.
+ */
+static bool
+seq_shared_fetch(RelFileNode node, SeqTable elm)
+{
+	SeqSharedEntry *entry;
+	bool		result = false;
+
+	LWLockAcquire(SequenceCacheLock, LW_SHARED);
+	entry = (SeqSharedEntry *)
+		hash_search(SeqSharedHash, &node, HASH_FIND, NULL);
+	if (entry != NULL)
+	{
+		SpinLockAcquire(&entry->mutex);
+		if (!entry->empty)
+		{
+			int64		incby = entry->increment;
+			uint64		left;
+			int64		n;
+
+			/*
+			 * Count the values left, in unsigned arithmetic since the
+			 * difference may not fit in an int64.
+			 */
+			if (incby > 0)
+				left = ((uint64) entry->last - (uint64) entry->next) /
+					(uint64) incby + 1;
+			else
+				left = ((uint64) entry->next - (uint64) entry->last) /
+					((uint64) 0 - (uint64) incby) + 1;
+			n = (left < (uint64) entry->cache) ? (int64) left : entry->cache;
+
+			elm->increment = incby;
+			elm->last = entry->next;
+			elm->cached = entry->next + (n - 1) * incby;
+			elm->last_valid = true;
+
+			if (elm->cached == entry->last)
+				entry->empty = true;
+			else
+				entry->next = elm->cached + incby;
+			result = true;
+		}
+		SpinLockRelease(&entry->mutex);
+	}
+	LWLockRelease(SequenceCacheLock);
+
+	return result;
+}
+
 /*
  * Given a relation OID, open and lock the sequence.  p_elm and p_rel are
  * output parameters.
@@ -33,6 +33,7 @@
 #include "commands/defrem.h"
 #include "commands/trigger.h"
 #include "executor/executor.h"
+#include "lib/ilist.h"
 #include "miscadmin.h"
 #include "nodes/bitmapset.h"
 #include "nodes/makefuncs.h"
@@ -45,6 +46,7 @@
 #include "parser/parsetree.h"
 #include "pgstat.h"
 #include "rewrite/rewriteManip.h"
+#include "storage/buffile.h"
 #include "storage/bufmgr.h"
 #include "storage/lmgr.h"
 #include "tcop/utility.h"
@@ -56,6 +58,7 @@
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/rel.h"
+#include "utils/resowner.h"
 #include "utils/snapmgr.h"
 #include "utils/syscache.h"
 #include "utils/tqual.h"
@@ -3715,6 +3718,22 @@ typedef struct AfterTriggerEventDataZeroCtids
  * array).  The space between CHUNK_DATA_START and freeptr is occupied by
  * AfterTriggerEventData records; the space between endfree and endptr is
  * occupied by AfterTriggerSharedData records.
+ *
+ * A chunk's storage is allocated separately from the chunk header, so that
+ * the storage can be written out to a temporary file when the resident
+ * chunks of all event lists would exceed work_mem.  The header stays put,
+ * so list links and saved AfterTriggerEventList values remain valid; the
+ * storage is read back in, possibly at a different address, the next time
+ * the chunk is scanned.  Since events find their shared records by relative
+ * offset, and AfterTriggerEventList remembers the tail position as an offset
+ * too, nothing inside a chunk needs adjusting when it moves.  When spilled,
+ * only the used parts (the events and the shared records) are written.
+ *
+ * The last chunk of a list (next == NULL) is never spilled, since that's
+ * where new events get added.  Code that keeps pointers into a chunk across
+ * an operation that might spill chunks, such as adding events or firing
+ * triggers, must pin the chunk while doing so.  A pin leaked by an error
+ * merely keeps that chunk in memory for the rest of the transaction.
  */
 typedef struct AfterTriggerEventChunk
 {
@@ -3722,22 +3741,36 @@ typedef struct AfterTriggerEventChunk
 	char	   *freeptr;		/* start of free space in chunk */
 	char	   *endfree;		/* end of free space in chunk */
 	char	   *endptr;			/* end of chunk */
-	/* event data follows here */
+	char	   *data;			/* chunk storage, or NULL if spilled */
+	Size		size;			/* allocated size of chunk storage */
+	int			pincount;		/* # of scans that need it to stay resident */
+	dlist_node	resident_node;	/* link in afterTriggers.resident_chunks */
+	/* these fields are valid only while the chunk is spilled: */
+	Size		spill_eventbytes;	/* bytes of event records */
+	Size		spill_sharedbytes;	/* bytes of shared records */
+	/* location of this chunk's space in the spill file, if any: */
+	int			spill_fileno;	/* -1 if no space assigned yet */
+	off_t		spill_offset;
+	Size		spill_space;	/* bytes of space at that location */
 } AfterTriggerEventChunk;
 
-#define CHUNK_DATA_START(cptr) ((char *) (cptr) + MAXALIGN(sizeof(AfterTriggerEventChunk)))
+#define CHUNK_DATA_START(cptr) ((cptr)->data)
 
 /* A list of events */
 typedef struct AfterTriggerEventList
 {
 	AfterTriggerEventChunk *head;
 	AfterTriggerEventChunk *tail;
-	char	   *tailfree;		/* freeptr of tail chunk */
+	Size		tailfree;		/* offset of freeptr in tail chunk */
 } AfterTriggerEventList;
 
-/* Macros to help in iterating over a list of events */
+/*
+ * Macros to help in iterating over a list of events.  Each chunk is made
+ * resident as the scan reaches it.
+ */
 #define for_each_chunk(cptr, evtlist) \
-	for (cptr = (evtlist).head; cptr != NULL; cptr = cptr->next)
+	for (cptr = afterTriggerLoadChunk((evtlist).head); cptr != NULL; \
+		 cptr = afterTriggerLoadChunk(cptr->next))
 #define for_each_event(eptr, cptr) \
 	for (eptr = (AfterTriggerEvent) CHUNK_DATA_START(cptr); \
 		 (char *) eptr < (cptr)->freeptr; \
@@ -3748,7 +3781,8 @@ typedef struct AfterTriggerEventList
 
 /* Macros for iterating from a start point that might not be list start */
 #define for_each_chunk_from(cptr) \
-	for (; cptr != NULL; cptr = cptr->next)
+	for (cptr = afterTriggerLoadChunk(cptr); cptr != NULL; \
+		 cptr = afterTriggerLoadChunk(cptr->next))
 #define for_each_event_from(eptr, cptr) \
 	for (; \
 		 (char *) eptr < (cptr)->freeptr; \
@@ -3775,6 +3809,12 @@ typedef struct AfterTriggerEventList
  * end of the list, so it is relatively easy to discard them.  The event
  * list chunks themselves are stored in event_cxt.
  *
+ * resident_chunks lists the event chunks of all lists whose storage is in
+ * memory, most recently scanned first, and resident_bytes is the total size
+ * of their storage.  When that exceeds work_mem, the least recently used
+ * chunks are written out to spill_file, a temporary file that lives until
+ * end of transaction; spill_end_fileno/spill_end_offset is its end.
+ *
  * query_depth is the current depth of nested AfterTriggerBeginQuery calls
  * (-1 when the stack is empty).
  *
@@ -3841,6 +3881,13 @@ typedef struct AfterTriggersData
 	AfterTriggerEventList events;	/* deferred-event list */
 	MemoryContext event_cxt;	/* memory context for events, if any */
 
+	/* spilling of event chunks: */
+	dlist_head	resident_chunks;	/* in-memory chunks, in LRU order */
+	Size		resident_bytes; /* total storage of above chunks */
+	BufFile    *spill_file;		/* temp file for spilled chunks, or NULL */
+	int			spill_end_fileno;	/* current end of spill_file */
+	off_t		spill_end_offset;
+
 	/* per-query-level data: */
 	AfterTriggersQueryData *query_stack;	/* array of structs shown below */
 	int			query_depth;	/* current index in above array */
@@ -3897,6 +3944,7 @@ static SetConstraintState SetConstraintStateCopy(SetConstraintState state);
 static SetConstraintState SetConstraintStateAddItem(SetConstraintState state,
 						  Oid tgoid, bool tgisdeferred);
 static void cancel_prior_stmt_triggers(Oid relid, CmdType cmdType, int tgevent);
+static AfterTriggerEventChunk *afterTriggerLoadChunk(AfterTriggerEventChunk *chunk);
 
 
 /*
@@ -3978,6 +4026,210 @@ afterTriggerCheckState(AfterTriggerShared evtshared)
 }
 
 
+/* ----------
+ * afterTriggerSpillChunk()
+ *
+ *	Write the storage of an event chunk out to the spill file, and free it.
+ * ----------
+ */
+static void
+afterTriggerSpillChunk(AfterTriggerEventChunk *chunk)
+{
+	Size		eventbytes = chunk->freeptr - chunk->data;
+	Size		sharedbytes = chunk->endptr - chunk->endfree;
+	bool		append;
+	int			fileno;
+	off_t		offset;
+
+	Assert(chunk->data != NULL && chunk->pincount == 0 && chunk->next != NULL);
+
+	/* Create the spill file if we didn't already */
+	if (afterTriggers.spill_file == NULL)
+	{
+		MemoryContext oldcxt;
+		ResourceOwner saveResourceOwner;
+
+		/*
+		 * The file must survive subtransaction abort, since spilled chunks
+		 * of the deferred-event list do.  AfterTriggerEndXact closes it.
+		 */
+		oldcxt = MemoryContextSwitchTo(afterTriggers.event_cxt);
+		saveResourceOwner = CurrentResourceOwner;
+		CurrentResourceOwner = TopTransactionResourceOwner;
+
+		afterTriggers.spill_file = BufFileCreateTemp(false);
+
+		CurrentResourceOwner = saveResourceOwner;
+		MemoryContextSwitchTo(oldcxt);
+
+		afterTriggers.spill_end_fileno = 0;
+		afterTriggers.spill_end_offset = 0;
+	}
+
+	/*
+	 * A chunk that was spilled before is written back to the same place, as
+	 * long as it hasn't outgrown that space (which can happen only if it was
+	 * the tail of a list in the meantime).  Otherwise, append it to the file.
+	 * We don't try to reuse the space of chunks that have been freed.
+	 */
+	append = (chunk->spill_fileno < 0 ||
+			  chunk->spill_space < eventbytes + sharedbytes);
+	if (append)
+	{
+		fileno = afterTriggers.spill_end_fileno;
+		offset = afterTriggers.spill_end_offset;
+	}
+	else
+	{
+		fileno = chunk->spill_fileno;
+		offset = chunk->spill_offset;
+	}
+
+	if (BufFileSeek(afterTriggers.spill_file, fileno, offset, SEEK_SET) != 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not seek in trigger event temporary file: %m")));
+	if (BufFileWrite(afterTriggers.spill_file,
+					 chunk->data, eventbytes) != eventbytes ||
+		BufFileWrite(afterTriggers.spill_file,
+					 chunk->endfree, sharedbytes) != sharedbytes)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not write to trigger event temporary file: %m")));
+
+	/*
+	 * Only once the write has succeeded, take ownership of the appended space
+	 * and advance the end of file; if we failed partway, the next append
+	 * simply overwrites whatever we managed to write.
+	 */
+	if (append)
+	{
+		chunk->spill_fileno = fileno;
+		chunk->spill_offset = offset;
+		chunk->spill_space = eventbytes + sharedbytes;
+		BufFileTell(afterTriggers.spill_file,
+					&afterTriggers.spill_end_fileno,
+					&afterTriggers.spill_end_offset);
+	}
+
+	/* Now release the storage */
+	chunk->spill_eventbytes = eventbytes;
+	chunk->spill_sharedbytes = sharedbytes;
+	dlist_delete(&chunk->resident_node);
+	afterTriggers.resident_bytes -= chunk->size;
+	pfree(chunk->data);
+	chunk->data = NULL;
+	chunk->freeptr = chunk->endfree = chunk->endptr = NULL;
+}
+
+/* ----------
+ * afterTriggerMakeRoom()
+ *
+ *	Spill least recently used event chunks until another "needed" bytes of
+ *	chunk storage fit in work_mem, or until no more chunks can be spilled.
+ * ----------
+ */
+static void
+afterTriggerMakeRoom(Size needed)
+{
+	Size		limit = (Size) work_mem * 1024L;
+	dlist_node *cur;
+	dlist_node *prev;
+
+	if (afterTriggers.resident_bytes + needed <= limit)
+		return;
+
+	/* Scan from the least recently used end of the list */
+	for (cur = afterTriggers.resident_chunks.head.prev;
+		 cur != &afterTriggers.resident_chunks.head;
+		 cur = prev)
+	{
+		AfterTriggerEventChunk *chunk =
+		dlist_container(AfterTriggerEventChunk, resident_node, cur);
+
+		prev = cur->prev;
+
+		/* Can't spill tail chunks, nor chunks that somebody is scanning */
+		if (chunk->next == NULL || chunk->pincount > 0)
+			continue;
+
+		afterTriggerSpillChunk(chunk);
+
+		if (afterTriggers.resident_bytes + needed <= limit)
+			break;
+	}
+}
+
+/* ----------
+ * afterTriggerLoadChunk()
+ *
+ *	Make sure the storage of an event chunk is in memory, reading it back
+ *	from the spill file if necessary.  For the convenience of the iteration
+ *	macros, the chunk is returned, and NULL is accepted.
+ * ----------
+ */
+static AfterTriggerEventChunk *
+afterTriggerLoadChunk(AfterTriggerEventChunk *chunk)
+{
+	Size		eventbytes;
+	Size		sharedbytes;
+
+	if (chunk == NULL)
+		return NULL;
+
+	if (chunk->data != NULL)
+	{
+		/* Already resident; just mark it as most recently used */
+		dlist_move_head(&afterTriggers.resident_chunks, &chunk->resident_node);
+		return chunk;
+	}
+
+	afterTriggerMakeRoom(chunk->size);
+
+	chunk->data = MemoryContextAlloc(afterTriggers.event_cxt, chunk->size);
+	eventbytes = chunk->spill_eventbytes;
+	sharedbytes = chunk->spill_sharedbytes;
+	chunk->freeptr = chunk->data + eventbytes;
+	chunk->endptr = chunk->data + chunk->size;
+	chunk->endfree = chunk->endptr - sharedbytes;
+	dlist_push_head(&afterTriggers.resident_chunks, &chunk->resident_node);
+	afterTriggers.resident_bytes += chunk->size;
+
+	if (BufFileSeek(afterTriggers.spill_file,
+					chunk->spill_fileno, chunk->spill_offset,
+					SEEK_SET) != 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not seek in trigger event temporary file: %m")));
+	if (BufFileRead(afterTriggers.spill_file,
+					chunk->data, eventbytes) != eventbytes ||
+		BufFileRead(afterTriggers.spill_file,
+					chunk->endfree, sharedbytes) != sharedbytes)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not read from trigger event temporary file: %m")));
+
+	return chunk;
+}
+
+/* ----------
+ * afterTriggerFreeChunk()
+ *
+ *	Release an event chunk, whether it's resident or spilled.
+ * ----------
+ */
+static void
+afterTriggerFreeChunk(AfterTriggerEventChunk *chunk)
+{
+	if (chunk->data != NULL)
+	{
+		dlist_delete(&chunk->resident_node);
+		afterTriggers.resident_bytes -= chunk->size;
+		pfree(chunk->data);
+	}
+	pfree(chunk);
+}
+
 /* ----------
  * afterTriggerAddEvent()
  *
@@ -4007,10 +4259,14 @@ afterTriggerAddEvent(AfterTriggerEventList *events,
 
 		/* Create event context if we didn't already */
 		if (afterTriggers.event_cxt == NULL)
+		{
 			afterTriggers.event_cxt =
 				AllocSetContextCreate(TopTransactionContext,
 									  "AfterTriggerEvents",
 									  ALLOCSET_DEFAULT_SIZES);
+			dlist_init(&afterTriggers.resident_chunks);
+			afterTriggers.resident_bytes = 0;
+		}
 
 		/*
 		 * Chunk size starts at 1KB and is allowed to increase up to 1MB.
@@ -4039,7 +4295,7 @@ afterTriggerAddEvent(AfterTriggerEventList *events,
 		else
 		{
 			/* preceding chunk size... */
-			chunksize = chunk->endptr - (char *) chunk;
+			chunksize = chunk->size;
 			/* check number of shared records in preceding chunk */
 			if ((chunk->endptr - chunk->endfree) <=
 				(100 * sizeof(AfterTriggerSharedData)))
@@ -4048,11 +4304,28 @@ afterTriggerAddEvent(AfterTriggerEventList *events,
 				chunksize /= 2; /* too many shared records */
 			chunksize = Min(chunksize, MAX_CHUNK_SIZE);
 		}
-		chunk = MemoryContextAlloc(afterTriggers.event_cxt, chunksize);
+
+		/*
+		 * Make room for the new chunk by spilling older ones if need be.  If
+		 * the caller is scanning a chunk of this or another list, it has that
+		 * chunk pinned, and the chunk holding evtshared is among those.
+		 */
+		afterTriggerMakeRoom(chunksize);
+
+		chunk = MemoryContextAlloc(afterTriggers.event_cxt,
+								   sizeof(AfterTriggerEventChunk));
 		chunk->next = NULL;
+		chunk->data = MemoryContextAlloc(afterTriggers.event_cxt, chunksize);
+		chunk->size = chunksize;
+		chunk->pincount = 0;
+		chunk->spill_fileno = -1;
+		chunk->spill_offset = 0;
+		chunk->spill_space = 0;
 		chunk->freeptr = CHUNK_DATA_START(chunk);
-		chunk->endptr = chunk->endfree = (char *) chunk + chunksize;
+		chunk->endptr = chunk->endfree = chunk->data + chunksize;
 		Assert(chunk->endfree - chunk->freeptr >= needed);
+		dlist_push_head(&afterTriggers.resident_chunks, &chunk->resident_node);
+		afterTriggers.resident_bytes += chunksize;
 
 		if (events->head == NULL)
 			events->head = chunk;
@@ -4092,7 +4365,7 @@ afterTriggerAddEvent(AfterTriggerEventList *events,
 	newevent->ate_flags |= (char *) newshared - (char *) newevent;
 
 	chunk->freeptr += eventsize;
-	events->tailfree = chunk->freeptr;
+	events->tailfree = chunk->freeptr - CHUNK_DATA_START(chunk);
 }
 
 /* ----------
@@ -4109,10 +4382,10 @@ afterTriggerFreeEventList(AfterTriggerEventList *events)
 	while ((chunk = events->head) != NULL)
 	{
 		events->head = chunk->next;
-		pfree(chunk);
+		afterTriggerFreeChunk(chunk);
 	}
 	events->tail = NULL;
-	events->tailfree = NULL;
+	events->tailfree = 0;
 }
 
 /* ----------
@@ -4141,11 +4414,12 @@ afterTriggerRestoreEventList(AfterTriggerEventList *events,
 		for (chunk = events->tail->next; chunk != NULL; chunk = next_chunk)
 		{
 			next_chunk = chunk->next;
-			pfree(chunk);
+			afterTriggerFreeChunk(chunk);
 		}
 		/* and clean up the tail chunk to be the right length */
 		events->tail->next = NULL;
-		events->tail->freeptr = events->tailfree;
+		chunk = afterTriggerLoadChunk(events->tail);
+		chunk->freeptr = CHUNK_DATA_START(chunk) + events->tailfree;
 
 		/*
 		 * We don't make any effort to remove now-unused shared data records.
@@ -4184,13 +4458,13 @@ afterTriggerDeleteHeadEventChunk(AfterTriggersQueryData *qs)
 		{
 			table->after_trig_events.head = NULL;
 			table->after_trig_events.tail = NULL;
-			table->after_trig_events.tailfree = NULL;
+			table->after_trig_events.tailfree = 0;
 		}
 	}
 
 	/* Now we can flush the head chunk */
 	qs->events.head = target->next;
-	pfree(target);
+	afterTriggerFreeChunk(target);
 }
 
 
@@ -4419,43 +4693,51 @@ afterTriggerMarkEvents(AfterTriggerEventList *events,
 	AfterTriggerEvent event;
 	AfterTriggerEventChunk *chunk;
 
-	for_each_event_chunk(event, chunk, *events)
+	for_each_chunk(chunk, *events)
 	{
-		AfterTriggerShared evtshared = GetTriggerSharedData(event);
-		bool		defer_it = false;
+		/* adding to move_list mustn't spill the chunk we're scanning */
+		chunk->pincount++;
 
-		if (!(event->ate_flags &
-			  (AFTER_TRIGGER_DONE | AFTER_TRIGGER_IN_PROGRESS)))
+		for_each_event(event, chunk)
 		{
-			/*
-			 * This trigger hasn't been called or scheduled yet. Check if we
-			 * should call it now.
-			 */
-			if (immediate_only && afterTriggerCheckState(evtshared))
-			{
-				defer_it = true;
-			}
-			else
+			AfterTriggerShared evtshared = GetTriggerSharedData(event);
+			bool		defer_it = false;
+
+			if (!(event->ate_flags &
+				  (AFTER_TRIGGER_DONE | AFTER_TRIGGER_IN_PROGRESS)))
 			{
 				/*
-				 * Mark it as to be fired in this firing cycle.
+				 * This trigger hasn't been called or scheduled yet. Check if
+				 * we should call it now.
 				 */
-				evtshared->ats_firing_id = afterTriggers.firing_counter;
-				event->ate_flags |= AFTER_TRIGGER_IN_PROGRESS;
-				found = true;
+				if (immediate_only && afterTriggerCheckState(evtshared))
+				{
+					defer_it = true;
+				}
+				else
+				{
+					/*
+					 * Mark it as to be fired in this firing cycle.
+					 */
+					evtshared->ats_firing_id = afterTriggers.firing_counter;
+					event->ate_flags |= AFTER_TRIGGER_IN_PROGRESS;
+					found = true;
+				}
 			}
-		}
 
-		/*
-		 * If it's deferred, move it to move_list, if requested.
-		 */
-		if (defer_it && move_list != NULL)
-		{
-			/* add it to move_list */
-			afterTriggerAddEvent(move_list, event, evtshared);
-			/* mark original copy "done" so we don't do it again */
-			event->ate_flags |= AFTER_TRIGGER_DONE;
+			/*
+			 * If it's deferred, move it to move_list, if requested.
+			 */
+			if (defer_it && move_list != NULL)
+			{
+				/* add it to move_list */
+				afterTriggerAddEvent(move_list, event, evtshared);
+				/* mark original copy "done" so we don't do it again */
+				event->ate_flags |= AFTER_TRIGGER_DONE;
+			}
 		}
+
+		chunk->pincount--;
 	}
 
 	return found;
@@ -4517,6 +4799,9 @@ afterTriggerInvokeEvents(AfterTriggerEventList *events,
 		AfterTriggerEvent event;
 		bool		all_fired_in_chunk = true;
 
+		/* the triggers we fire mustn't cause this chunk to be spilled */
+		chunk->pincount++;
+
 		for_each_event(event, chunk)
 		{
 			AfterTriggerShared evtshared = GetTriggerSharedData(event);
@@ -4591,9 +4876,15 @@ afterTriggerInvokeEvents(AfterTriggerEventList *events,
 			 * list, since we'd fail to fix their copies of tailfree.
 			 */
 			if (chunk == events->tail)
-				events->tailfree = chunk->freeptr;
+				events->tailfree = 0;
 		}
+
+		chunk->pincount--;
 	}
+
+	/* Look up the foreign keys RI triggers queued while firing these */
+	RI_FlushPendingChecks();
+
 	if (slot1 != NULL)
 	{
 		ExecDropSingleTupleTableSlot(slot1);
@@ -5039,11 +5330,19 @@ AfterTriggerEndXact(bool isCommit)
 	 */
 	if (afterTriggers.event_cxt)
 	{
+		/* The spill file's BufFile struct lives in event_cxt */
+		if (afterTriggers.spill_file)
+		{
+			BufFile    *file = afterTriggers.spill_file;
+
+			afterTriggers.spill_file = NULL;
+			BufFileClose(file);
+		}
 		MemoryContextDelete(afterTriggers.event_cxt);
 		afterTriggers.event_cxt = NULL;
 		afterTriggers.events.head = NULL;
 		afterTriggers.events.tail = NULL;
-		afterTriggers.events.tailfree = NULL;
+		afterTriggers.events.tailfree = 0;
 	}
 
 	/*
@@ -5054,6 +5353,9 @@ AfterTriggerEndXact(bool isCommit)
 	afterTriggers.trans_stack = NULL;
 	afterTriggers.maxtransdepth = 0;
 
+	/* Likewise any foreign-key checks RI triggers queued up */
+	RI_DiscardPendingChecks(1);
+
 
 	/*
 	 * Forget the query stack and constraint-related state information.  As
@@ -5147,6 +5449,9 @@ AfterTriggerEndSubXact(bool isCommit)
 	}
 	else
 	{
+		/* Forget any foreign-key checks the subxact left queued up */
+		RI_DiscardPendingChecks(my_level);
+
 		/*
 		 * Aborting.  It is possible subxact start failed before calling
 		 * AfterTriggerBeginSubXact, in which case we mustn't risk touching
@@ -5259,7 +5564,7 @@ AfterTriggerEnlargeQueryState(void)
 
 		qs->events.head = NULL;
 		qs->events.tail = NULL;
-		qs->events.tailfree = NULL;
+		qs->events.tailfree = 0;
 		qs->fdw_tuplestore = NULL;
 		qs->tables = NIL;
 
@@ -6127,8 +6432,9 @@ cancel_prior_stmt_triggers(Oid relid, CmdType cmdType, int tgevent)
 
 		if (table->after_trig_events.tail)
 		{
-			chunk = table->after_trig_events.tail;
-			event = (AfterTriggerEvent) table->after_trig_events.tailfree;
+			chunk = afterTriggerLoadChunk(table->after_trig_events.tail);
+			event = (AfterTriggerEvent)
+				(CHUNK_DATA_START(chunk) + table->after_trig_events.tailfree);
 		}
 		else
 		{
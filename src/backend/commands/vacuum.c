@@ -28,6 +28,7 @@
 #include "access/heapam.h"
 #include "access/htup_details.h"
 #include "access/multixact.h"
+#include "access/tableam.h"
 #include "access/transam.h"
 #include "access/xact.h"
 #include "catalog/namespace.h"
@@ -137,6 +138,9 @@ ExecVacuum(VacuumStmt *vacstmt, bool isTopLevel)
 	/* user-invoked vacuum never uses this parameter */
 	params.log_min_duration = -1;
 
+	params.nworkers = vacstmt->nworkers;
+	params.index_cleanup = vacstmt->index_cleanup;
+
 	/* Now go through the common routine */
 	vacuum(vacstmt->options, vacstmt->rels, &params, NULL, isTopLevel);
 }
@@ -212,6 +216,14 @@ vacuum(int options, List *relations, VacuumParams *params,
 				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
 				 errmsg("VACUUM option DISABLE_PAGE_SKIPPING cannot be used with FULL")));
 
+	/*
+	 * Sanity check PARALLEL option.
+	 */
+	if ((options & VACOPT_FULL) != 0 && params->nworkers > 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("VACUUM option PARALLEL cannot be used with FULL")));
+
 	/*
 	 * Send info about dead objects to the statistics collector, unless we are
 	 * in autovacuum --- autovacuum.c does this for itself.
@@ -1530,6 +1542,7 @@ vacuum_rel(Oid relid, RangeVar *relation, int options, VacuumParams *params)
 	Oid			save_userid;
 	int			save_sec_context;
 	int			save_nestlevel;
+	VacuumParams rel_params;
 
 	Assert(params != NULL);
 
@@ -1672,6 +1685,21 @@ vacuum_rel(Oid relid, RangeVar *relation, int options, VacuumParams *params)
 	onerelid = onerel->rd_lockInfo.lockRelId;
 	LockRelationIdForSession(&onerelid, lmode);
 
+	/*
+	 * Set index_cleanup option based on reloptions if not yet set.  This is
+	 * done on a local copy, since the caller's params are reused for other
+	 * relations, including our own TOAST table, which has its own setting.
+	 */
+	rel_params = *params;
+	if (rel_params.index_cleanup == VACOPT_TERNARY_DEFAULT)
+	{
+		if (onerel->rd_options == NULL ||
+			((StdRdOptions *) onerel->rd_options)->vacuum_index_cleanup)
+			rel_params.index_cleanup = VACOPT_TERNARY_ENABLED;
+		else
+			rel_params.index_cleanup = VACOPT_TERNARY_DISABLED;
+	}
+
 	/*
 	 * Remember the relation's TOAST relation for later, if the caller asked
 	 * us to process it.  In VACUUM FULL, though, the toast table is
@@ -1711,7 +1739,7 @@ vacuum_rel(Oid relid, RangeVar *relation, int options, VacuumParams *params)
 		cluster_rel(relid, InvalidOid, cluster_options);
 	}
 	else
-		lazy_vacuum_rel(onerel, options, params, vac_strategy);
+		table_relation_vacuum(onerel, options, &rel_params, vac_strategy);
 
 	/* Roll back any GUC changes executed by index functions */
 	AtEOXact_GUC(false, save_nestlevel);
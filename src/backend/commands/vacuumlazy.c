@@ -4,23 +4,35 @@
  *	  Concurrent ("lazy") vacuuming.
  *
  *
- * The major space usage for LAZY VACUUM is storage for the array of dead tuple
- * TIDs.  We want to ensure we can vacuum even the very largest relations with
+ * The major space usage for LAZY VACUUM is storage for the dead tuple TIDs.
+ * We want to ensure we can vacuum even the very largest relations with
  * finite memory space usage.  To do that, we set upper bounds on the number of
  * tuples we will keep track of at once.
  *
  * We are willing to use at most maintenance_work_mem (or perhaps
  * autovacuum_work_mem) memory space to keep track of dead tuples.  We
- * initially allocate an array of TIDs of that size, with an upper limit that
- * depends on table size (this limit ensures we don't allocate a huge area
- * uselessly for vacuuming small tables).  If the array threatens to overflow,
- * we suspend the heap scan phase and perform a pass of index cleanup and page
- * compaction, then resume the heap scan with an empty TID array.
+ * initially allocate a TidStore (see access/common/tidstore.c) of that size,
+ * with an upper limit that depends on table size (this limit ensures we don't
+ * allocate a huge area uselessly for vacuuming small tables).  The store
+ * keeps each page's dead tuples as an offset bitmap or array, which needs much
+ * less than a TID's six bytes per tuple on pages with many dead tuples.  If
+ * the store threatens to overflow, we suspend the heap scan phase and perform
+ * a pass of index cleanup and page compaction, then resume the heap scan with
+ * an empty store.
  *
  * If we're processing a table with no indexes, we can just vacuum each page
  * as we go; there's no need to save up multiple tuples to minimize the number
  * of index scans performed.  So we don't use maintenance_work_mem memory for
- * the TID array, just enough to hold as many heap tuples as fit on one page.
+ * a TidStore, just the array of the current page's dead item offsets.
+ *
+ * VACUUM (PARALLEL n) spreads the index passes over up to n background
+ * workers, using the ParallelContext machinery of access/transam/parallel.c.
+ * The TidStore then lives in the parallel DSM segment for the whole heap
+ * scan, so that workers can test TIDs against it, and each participant,
+ * the leader included, repeatedly claims the next index not yet processed
+ * and bulk-deletes or cleans it up on its own.  Index statistics are
+ * collected in the DSM segment too, and written to pg_class by the leader
+ * only once parallel mode has ended.
  *
  *
  * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
@@ -41,7 +53,10 @@
 #include "access/heapam_xlog.h"
 #include "access/htup_details.h"
 #include "access/multixact.h"
+#include "access/parallel.h"
+#include "access/tidstore.h"
 #include "access/transam.h"
+#include "access/xact.h"
 #include "access/visibilitymap.h"
 #include "access/xlog.h"
 #include "catalog/storage.h"
@@ -55,6 +70,7 @@
 #include "storage/bufmgr.h"
 #include "storage/freespace.h"
 #include "storage/lmgr.h"
+#include "tcop/tcopprot.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/pg_rusage.h"
@@ -92,13 +108,6 @@
 #define VACUUM_FSM_EVERY_PAGES \
 	((BlockNumber) (((uint64) 8 * 1024 * 1024 * 1024) / BLCKSZ))
 
-/*
- * Guesstimation of number of dead tuples per page.  This is used to
- * provide an upper limit to memory allocated when vacuuming small
- * tables.
- */
-#define LAZY_ALLOC_TUPLES		MaxHeapTuplesPerPage
-
 /*
  * Before we consider skipping a page that's marked as clean in
  * visibility map, we must've seen at least this many clean pages.
@@ -111,10 +120,70 @@
  */
 #define PREFETCH_SIZE			((BlockNumber) 32)
 
+/*
+ * Threshold that controls whether we bypass index vacuuming and heap
+ * vacuuming as an optimization: if fewer than this fraction of the table's
+ * pages have dead item identifiers left after pruning, and their TIDs would
+ * take less than BYPASS_MAX_DEAD_BYTES of memory, the final round of index
+ * vacuuming is skipped and the LP_DEAD items are left for a later VACUUM.
+ */
+#define BYPASS_THRESHOLD_PAGES	0.02	/* i.e. 2% of rel_pages */
+#define BYPASS_MAX_DEAD_BYTES	(32L * 1024L * 1024L)
+
+/*
+ * DSM keys for parallel index vacuuming.  Unlike other parallel execution
+ * code, since we don't need to worry about DSM keys conflicting with
+ * plan_node_id we can use small integers.
+ */
+#define PARALLEL_VACUUM_KEY_SHARED			1
+#define PARALLEL_VACUUM_KEY_DEAD_TUPLES		2
+#define PARALLEL_VACUUM_KEY_QUERY_TEXT		3
+
+/*
+ * Per-index slot in LVShared.  stats is only valid if updated is set;
+ * otherwise the index AM hasn't returned any statistics yet.
+ */
+typedef struct LVSharedIndStats
+{
+	Oid			indexoid;
+	bool		updated;
+	IndexBulkDeleteResult stats;
+} LVSharedIndStats;
+
+/*
+ * State shared between the leader and the workers of a parallel index
+ * vacuum.  The fields up to nextindex are set by the leader before each
+ * index pass.
+ */
+typedef struct LVShared
+{
+	int			elevel;
+	bool		for_cleanup;	/* amvacuumcleanup rather than ambulkdelete? */
+	double		reltuples;		/* num_heap_tuples for the index AMs */
+	bool		estimated_count;	/* is reltuples an estimate? */
+
+	/* the next index to be processed is indstats[nextindex] */
+	pg_atomic_uint32 nextindex;
+
+	int			nindexes;
+	LVSharedIndStats indstats[FLEXIBLE_ARRAY_MEMBER];
+} LVShared;
+
+/* Leader's handle on a parallel index vacuum */
+typedef struct LVParallelState
+{
+	ParallelContext *pcxt;
+	LVShared   *lvshared;
+	TidStore   *dead_tuples;	/* in the DSM segment */
+	bool		launched;		/* have workers been launched yet? */
+} LVParallelState;
+
 typedef struct LVRelStats
 {
 	/* hasindex = true means two-pass strategy; false means one-pass */
 	bool		hasindex;
+	/* useindex = false means indexes are neither vacuumed nor cleaned up */
+	bool		useindex;
 	/* Overall statistics about rel */
 	BlockNumber old_rel_pages;	/* previous value of pg_class.relpages */
 	BlockNumber rel_pages;		/* total number of pages */
@@ -129,11 +198,12 @@ typedef struct LVRelStats
 	BlockNumber pages_removed;
 	double		tuples_deleted;
 	BlockNumber nonempty_pages; /* actually, last nonempty page + 1 */
-	/* List of TIDs of tuples we intend to delete */
-	/* NB: this list is ordered by TID address */
-	int			num_dead_tuples;	/* current # of entries */
-	int			max_dead_tuples;	/* # slots allocated in array */
-	ItemPointer dead_tuples;	/* array of ItemPointerData */
+	/* TIDs of tuples we intend to delete, or NULL if no indexes */
+	TidStore   *dead_tuples;
+	int64		num_dead_tuples;	/* # of TIDs in dead_tuples */
+	/* Dead item offsets found on the page being scanned, in order */
+	int			num_page_dead;
+	OffsetNumber page_dead[MaxHeapTuplesPerPage];
 	int			num_index_scans;
 	TransactionId latestRemovedXid;
 	bool		lock_waiter_detected;
@@ -153,26 +223,47 @@ static BufferAccessStrategy vac_strategy;
 /* non-export function prototypes */
 static void lazy_scan_heap(Relation onerel, int options,
 			   LVRelStats *vacrelstats, Relation *Irel, int nindexes,
-			   bool aggressive);
+			   bool aggressive, int nworkers);
 static void lazy_vacuum_heap(Relation onerel, LVRelStats *vacrelstats);
 static bool lazy_check_needs_freeze(Buffer buf, bool *hastup);
+static void lazy_vacuum_all_indexes(Relation *Irel,
+						IndexBulkDeleteResult **stats, int nindexes,
+						LVRelStats *vacrelstats, LVParallelState *lps);
+static void lazy_cleanup_all_indexes(Relation *Irel,
+						 IndexBulkDeleteResult **stats, int nindexes,
+						 LVRelStats *vacrelstats, LVParallelState *lps);
 static void lazy_vacuum_index(Relation indrel,
 				  IndexBulkDeleteResult **stats,
-				  LVRelStats *vacrelstats);
+				  TidStore *dead_tuples, double reltuples);
 static void lazy_cleanup_index(Relation indrel,
-				   IndexBulkDeleteResult *stats,
-				   LVRelStats *vacrelstats);
-static int lazy_vacuum_page(Relation onerel, BlockNumber blkno, Buffer buffer,
-				 int tupindex, LVRelStats *vacrelstats, Buffer *vmbuffer);
+				   IndexBulkDeleteResult **stats,
+				   double reltuples, bool estimated_count);
+static void update_index_statistics(Relation *Irel,
+						IndexBulkDeleteResult **stats, int nindexes);
+static LVParallelState *begin_parallel_vacuum(Relation onerel,
+					  Relation *Irel, int nindexes,
+					  BlockNumber nblocks, int nrequested);
+static void end_parallel_vacuum(LVParallelState *lps,
+					IndexBulkDeleteResult **stats, int nindexes);
+static void lazy_parallel_vacuum_indexes(LVParallelState *lps,
+							 Relation *Irel, bool for_cleanup,
+							 double reltuples, bool estimated_count);
+static void parallel_vacuum_indexes(Relation *Irel, LVShared *lvshared,
+						TidStore *dead_tuples);
+static void lazy_vacuum_page(Relation onerel, BlockNumber blkno, Buffer buffer,
+				 OffsetNumber *deadoffsets, int ndead,
+				 LVRelStats *vacrelstats, Buffer *vmbuffer);
 static bool should_attempt_truncation(LVRelStats *vacrelstats);
 static void lazy_truncate_heap(Relation onerel, LVRelStats *vacrelstats);
 static BlockNumber count_nondeletable_pages(Relation onerel,
 						 LVRelStats *vacrelstats);
-static void lazy_space_alloc(LVRelStats *vacrelstats, BlockNumber relblocks);
+static Size dead_tuples_max_bytes(void);
+static void lazy_space_alloc(LVRelStats *vacrelstats, BlockNumber relblocks,
+				 LVParallelState *lps);
 static void lazy_record_dead_tuple(LVRelStats *vacrelstats,
 					   ItemPointer itemptr);
+static void lazy_record_dead_page(LVRelStats *vacrelstats, BlockNumber blkno);
 static bool lazy_tid_reaped(ItemPointer itemptr, void *state);
-static int	vac_cmp_itemptr(const void *left, const void *right);
 static bool heap_page_is_all_visible(Relation rel, Buffer buf,
 						 TransactionId *visibility_cutoff_xid, bool *all_frozen);
 
@@ -260,9 +351,12 @@ lazy_vacuum_rel(Relation onerel, int options, VacuumParams *params,
 	/* Open all indexes of the relation */
 	vac_open_indexes(onerel, RowExclusiveLock, &nindexes, &Irel);
 	vacrelstats->hasindex = (nindexes > 0);
+	vacrelstats->useindex = (nindexes > 0 &&
+							 params->index_cleanup == VACOPT_TERNARY_ENABLED);
 
 	/* Do the vacuuming */
-	lazy_scan_heap(onerel, options, vacrelstats, Irel, nindexes, aggressive);
+	lazy_scan_heap(onerel, options, vacrelstats, Irel, nindexes, aggressive,
+				   params->nworkers);
 
 	/* Done with indexes */
 	vac_close_indexes(nindexes, Irel, NoLock);
@@ -468,10 +562,16 @@ vacuum_log_cleanup_info(Relation rel, LVRelStats *vacrelstats)
  *		If there are no indexes then we can reclaim line pointers on the fly;
  *		dead line pointers need only be retained until all index pointers that
  *		reference them have been killed.
+ *
+ *		Tuples are normally frozen only once they are older than FreezeLimit.
+ *		But when a page that we are dirtying anyway is about to become
+ *		all-visible, we freeze every tuple on it, so that it can be marked
+ *		all-frozen right away instead of having to be read and written again
+ *		by a later aggressive vacuum.
  */
 static void
 lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
-			   Relation *Irel, int nindexes, bool aggressive)
+			   Relation *Irel, int nindexes, bool aggressive, int nworkers)
 {
 	BlockNumber nblocks,
 				blkno;
@@ -486,8 +586,10 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 				live_tuples,	/* live tuples (reltuples estimate) */
 				tups_vacuumed,	/* tuples cleaned up by vacuum */
 				nkeep,			/* dead-but-not-removable tuples */
-				nunused;		/* unused item pointers */
+				nunused,		/* unused item pointers */
+				ntupgone;		/* dead tuples removed without pruning */
 	IndexBulkDeleteResult **indstats;
+	LVParallelState *lps = NULL;
 	int			i;
 	PGRUsage	ru0;
 	Buffer		vmbuffer = InvalidBuffer;
@@ -518,7 +620,7 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 
 	empty_pages = vacuumed_pages = 0;
 	next_fsm_block_to_vacuum = (BlockNumber) 0;
-	num_tuples = live_tuples = tups_vacuumed = nkeep = nunused = 0;
+	num_tuples = live_tuples = tups_vacuumed = nkeep = nunused = ntupgone = 0;
 
 	indstats = (IndexBulkDeleteResult **)
 		palloc0(nindexes * sizeof(IndexBulkDeleteResult *));
@@ -530,13 +632,22 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 	vacrelstats->nonempty_pages = 0;
 	vacrelstats->latestRemovedXid = InvalidTransactionId;
 
-	lazy_space_alloc(vacrelstats, nblocks);
+	/*
+	 * If parallel index vacuuming was requested and there's more than one
+	 * index, so that it could help, set up the parallel context now: the
+	 * dead tuples have to be stored in its DSM segment from the start.
+	 */
+	if (vacrelstats->useindex && nworkers > 0 && nindexes > 1)
+		lps = begin_parallel_vacuum(onerel, Irel, nindexes, nblocks, nworkers);
+
+	lazy_space_alloc(vacrelstats, nblocks, lps);
 	frozen = palloc(sizeof(xl_heap_freeze_tuple) * MaxHeapTuplesPerPage);
 
 	/* Report that we're scanning the heap, advertising total # of blocks */
 	initprog_val[0] = PROGRESS_VACUUM_PHASE_SCAN_HEAP;
 	initprog_val[1] = nblocks;
-	initprog_val[2] = vacrelstats->max_dead_tuples;
+	initprog_val[2] = vacrelstats->dead_tuples ?
+		TidStoreMinCapacity(vacrelstats->dead_tuples) : MaxHeapTuplesPerPage;
 	pgstat_progress_update_multi_param(3, initprog_index, initprog_val);
 
 	/*
@@ -621,7 +732,9 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 		bool		tupgone,
 					hastup;
 		int			prev_dead_count;
+		int			npruned;
 		int			nfrozen;
+		TransactionId freeze_cutoff;
 		Size		freespace;
 		bool		all_visible_according_to_vm = false;
 		bool		all_visible;
@@ -714,8 +827,8 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 		 * If we are close to overrunning the available space for dead-tuple
 		 * TIDs, pause and do a cycle of vacuuming before we tackle this page.
 		 */
-		if ((vacrelstats->max_dead_tuples - vacrelstats->num_dead_tuples) < MaxHeapTuplesPerPage &&
-			vacrelstats->num_dead_tuples > 0)
+		if (vacrelstats->num_dead_tuples > 0 &&
+			TidStoreIsFull(vacrelstats->dead_tuples))
 		{
 			const int	hvp_index[] = {
 				PROGRESS_VACUUM_PHASE,
@@ -743,10 +856,8 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 										 PROGRESS_VACUUM_PHASE_VACUUM_INDEX);
 
 			/* Remove index entries */
-			for (i = 0; i < nindexes; i++)
-				lazy_vacuum_index(Irel[i],
-								  &indstats[i],
-								  vacrelstats);
+			lazy_vacuum_all_indexes(Irel, indstats, nindexes,
+									vacrelstats, lps);
 
 			/*
 			 * Report that we are now vacuuming the heap.  We also increase
@@ -766,6 +877,7 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 			 * not to reset latestRemovedXid since we want that value to be
 			 * valid.
 			 */
+			TidStoreReset(vacrelstats->dead_tuples);
 			vacrelstats->num_dead_tuples = 0;
 			vacrelstats->num_index_scans++;
 
@@ -945,8 +1057,9 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 		 *
 		 * We count tuples removed by the pruning step as removed by VACUUM.
 		 */
-		tups_vacuumed += heap_page_prune(onerel, buf, OldestXmin, false,
-										 &vacrelstats->latestRemovedXid);
+		npruned = heap_page_prune(onerel, buf, OldestXmin, false,
+								  &vacrelstats->latestRemovedXid);
+		tups_vacuumed += npruned;
 
 		/*
 		 * Now scan the page to collect vacuumable items and check for tuples
@@ -957,6 +1070,7 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 		nfrozen = 0;
 		hastup = false;
 		prev_dead_count = vacrelstats->num_dead_tuples;
+		vacrelstats->num_page_dead = 0;
 		maxoff = PageGetMaxOffsetNumber(page);
 
 		/*
@@ -1044,9 +1158,13 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 					 * horizon alive.  heap_prepare_freeze_tuple() is prepared
 					 * to detect that case and abort the transaction,
 					 * preventing corruption.
+					 *
+					 * If index cleanup is disabled, we can't remove the
+					 * tuple's index entries, so we must keep it as well.
 					 */
 					if (HeapTupleIsHotUpdated(&tuple) ||
-						HeapTupleIsHeapOnly(&tuple))
+						HeapTupleIsHeapOnly(&tuple) ||
+						(nindexes > 0 && !vacrelstats->useindex))
 						nkeep += 1;
 					else
 						tupgone = true; /* we can delete the tuple */
@@ -1139,6 +1257,7 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 				HeapTupleHeaderAdvanceLatestRemovedXid(tuple.t_data,
 													   &vacrelstats->latestRemovedXid);
 				tups_vacuumed += 1;
+				ntupgone += 1;
 				has_dead_tuples = true;
 			}
 			else
@@ -1164,6 +1283,48 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 			}
 		}						/* scan along page */
 
+		/*
+		 * If the page is going to be all-visible, and we're going to dirty it
+		 * anyway because pruning changed it, some tuple is old enough to need
+		 * freezing, or PD_ALL_VISIBLE has to be set, freeze all of its tuples
+		 * that can be frozen rather than just those older than FreezeLimit.
+		 * On an all-visible page every tuple was inserted by a committed
+		 * transaction older than OldestXmin, and any xmax it has belongs to a
+		 * locker or an aborted updater, so it's safe to use OldestXmin as the
+		 * cutoff for heap_prepare_freeze_tuple.  This
+		 * only makes the freeze record bigger, whereas leaving the page
+		 * unfrozen means an aggressive vacuum has to read and dirty it again.
+		 */
+		freeze_cutoff = FreezeLimit;
+		if (all_visible && !all_frozen &&
+			(nfrozen > 0 || npruned > 0 || !PageIsAllVisible(page)))
+		{
+			freeze_cutoff = OldestXmin;
+			nfrozen = 0;
+			all_frozen = true;
+
+			for (offnum = FirstOffsetNumber;
+				 offnum <= maxoff;
+				 offnum = OffsetNumberNext(offnum))
+			{
+				ItemId		itemid = PageGetItemId(page, offnum);
+				bool		tuple_totally_frozen;
+
+				if (!ItemIdIsNormal(itemid))
+					continue;
+
+				if (heap_prepare_freeze_tuple((HeapTupleHeader) PageGetItem(page, itemid),
+											  relfrozenxid, relminmxid,
+											  freeze_cutoff, MultiXactCutoff,
+											  &frozen[nfrozen],
+											  &tuple_totally_frozen))
+					frozen[nfrozen++].offset = offnum;
+
+				if (!tuple_totally_frozen)
+					all_frozen = false;
+			}
+		}
+
 		/*
 		 * If we froze any tuples, mark the buffer dirty, and write a WAL
 		 * record recording the changes.  We must log the changes to be
@@ -1192,7 +1353,7 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 			{
 				XLogRecPtr	recptr;
 
-				recptr = log_heap_freeze(onerel, buf, FreezeLimit,
+				recptr = log_heap_freeze(onerel, buf, freeze_cutoff,
 										 frozen, nfrozen);
 				PageSetLSN(page, recptr);
 			}
@@ -1202,13 +1363,19 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 
 		/*
 		 * If there are no indexes then we can vacuum the page right now
-		 * instead of doing a second scan.
+		 * instead of doing a second scan.  Otherwise, remember its dead
+		 * tuples for the index and heap vacuuming passes, unless index
+		 * cleanup is disabled: then the dead item pointers must stay until
+		 * a later VACUUM removes their index entries, and we just forget
+		 * them.
 		 */
 		if (nindexes == 0 &&
-			vacrelstats->num_dead_tuples > 0)
+			vacrelstats->num_page_dead > 0)
 		{
 			/* Remove tuples from heap */
-			lazy_vacuum_page(onerel, blkno, buf, 0, vacrelstats, &vmbuffer);
+			lazy_vacuum_page(onerel, blkno, buf, vacrelstats->page_dead,
+							 vacrelstats->num_page_dead, vacrelstats,
+							 &vmbuffer);
 			has_dead_tuples = false;
 
 			/*
@@ -1216,7 +1383,7 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 			 * not to reset latestRemovedXid since we want that value to be
 			 * valid.
 			 */
-			vacrelstats->num_dead_tuples = 0;
+			vacrelstats->num_page_dead = 0;
 			vacuumed_pages++;
 
 			/*
@@ -1232,6 +1399,13 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 				next_fsm_block_to_vacuum = blkno;
 			}
 		}
+		else if (vacrelstats->num_page_dead > 0)
+		{
+			if (vacrelstats->useindex)
+				lazy_record_dead_page(vacrelstats, blkno);
+			else
+				vacrelstats->num_page_dead = 0;
+		}
 
 		freespace = PageGetHeapFreeSpace(page);
 
@@ -1364,9 +1538,31 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 		vmbuffer = InvalidBuffer;
 	}
 
-	/* If any tuples need to be deleted, perform final vacuum cycle */
-	/* XXX put a threshold on min number of tuples here? */
-	if (vacrelstats->num_dead_tuples > 0)
+	/*
+	 * If any tuples need to be deleted, perform final vacuum cycle.  But if
+	 * this would be the only cycle and just a few pages have dead items,
+	 * don't bother: scanning every index to remove a handful of TIDs costs
+	 * far more than the space it reclaims.  The dead items were already
+	 * reduced to LP_DEAD stubs by pruning, so we can leave them for the next
+	 * VACUUM.  Tuples we found dead only after pruning still have storage
+	 * and were not frozen, so their presence rules this out.
+	 */
+	if (vacrelstats->num_dead_tuples > 0 &&
+		vacrelstats->num_index_scans == 0 && ntupgone == 0 &&
+		TidStoreNumBlocks(vacrelstats->dead_tuples) <
+		(double) nblocks * BYPASS_THRESHOLD_PAGES &&
+		vacrelstats->num_dead_tuples <
+		BYPASS_MAX_DEAD_BYTES / sizeof(ItemPointerData))
+	{
+		ereport(elevel,
+				(errmsg("\"%s\": index scan bypassed: %d pages from table (%.2f%% of total) have " INT64_FORMAT " dead item identifiers",
+						RelationGetRelationName(onerel),
+						TidStoreNumBlocks(vacrelstats->dead_tuples),
+						100.0 * TidStoreNumBlocks(vacrelstats->dead_tuples) /
+						nblocks,
+						vacrelstats->num_dead_tuples)));
+	}
+	else if (vacrelstats->num_dead_tuples > 0)
 	{
 		const int	hvp_index[] = {
 			PROGRESS_VACUUM_PHASE,
@@ -1382,10 +1578,7 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 									 PROGRESS_VACUUM_PHASE_VACUUM_INDEX);
 
 		/* Remove index entries */
-		for (i = 0; i < nindexes; i++)
-			lazy_vacuum_index(Irel[i],
-							  &indstats[i],
-							  vacrelstats);
+		lazy_vacuum_all_indexes(Irel, indstats, nindexes, vacrelstats, lps);
 
 		/* Report that we are now vacuuming the heap */
 		hvp_val[0] = PROGRESS_VACUUM_PHASE_VACUUM_HEAP;
@@ -1411,9 +1604,27 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 	pgstat_progress_update_param(PROGRESS_VACUUM_PHASE,
 								 PROGRESS_VACUUM_PHASE_INDEX_CLEANUP);
 
-	/* Do post-vacuum cleanup and statistics update for each index */
-	for (i = 0; i < nindexes; i++)
-		lazy_cleanup_index(Irel[i], indstats[i], vacrelstats);
+	/*
+	 * Do post-vacuum cleanup for each index.  This happens even if we
+	 * bypassed index vacuuming above; each index AM decides for itself
+	 * whether there's anything to do (see vacuum_cleanup_index_scale_factor
+	 * for btree).
+	 */
+	if (vacrelstats->useindex)
+		lazy_cleanup_all_indexes(Irel, indstats, nindexes, vacrelstats, lps);
+
+	/*
+	 * End parallel mode before updating index statistics, which can't be
+	 * done while in it.  This also releases the dead tuple store.
+	 */
+	if (lps)
+	{
+		end_parallel_vacuum(lps, indstats, nindexes);
+		vacrelstats->dead_tuples = NULL;
+	}
+
+	if (vacrelstats->useindex)
+		update_index_statistics(Irel, indstats, nindexes);
 
 	/* If no indexes, make log report that lazy_vacuum_heap would've made */
 	if (vacuumed_pages)
@@ -1470,16 +1681,21 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 static void
 lazy_vacuum_heap(Relation onerel, LVRelStats *vacrelstats)
 {
-	int			tupindex;
+	TidStore   *dead_tuples = vacrelstats->dead_tuples;
+	int			nblocks = TidStoreNumBlocks(dead_tuples);
+	int			blockindex;
+	OffsetNumber deadoffsets[MaxOffsetNumber];
+	int			ndead;
+	int64		ntuples;
 	int			npages;
 	PGRUsage	ru0;
 	Buffer		vmbuffer = InvalidBuffer;
 
 	pg_rusage_init(&ru0);
 	npages = 0;
+	ntuples = 0;
 
-	tupindex = 0;
-	while (tupindex < vacrelstats->num_dead_tuples)
+	for (blockindex = 0; blockindex < nblocks; blockindex++)
 	{
 		BlockNumber tblk;
 		Buffer		buf;
@@ -1488,17 +1704,17 @@ lazy_vacuum_heap(Relation onerel, LVRelStats *vacrelstats)
 
 		vacuum_delay_point();
 
-		tblk = ItemPointerGetBlockNumber(&vacrelstats->dead_tuples[tupindex]);
+		tblk = TidStoreGetBlock(dead_tuples, blockindex, deadoffsets, &ndead);
 		buf = ReadBufferExtended(onerel, MAIN_FORKNUM, tblk, RBM_NORMAL,
 								 vac_strategy);
 		if (!ConditionalLockBufferForCleanup(buf))
 		{
 			ReleaseBuffer(buf);
-			++tupindex;
 			continue;
 		}
-		tupindex = lazy_vacuum_page(onerel, tblk, buf, tupindex, vacrelstats,
-									&vmbuffer);
+		lazy_vacuum_page(onerel, tblk, buf, deadoffsets, ndead, vacrelstats,
+						 &vmbuffer);
+		ntuples += ndead;
 
 		/* Now that we've compacted the page, record its available space */
 		page = BufferGetPage(buf);
@@ -1516,9 +1732,9 @@ lazy_vacuum_heap(Relation onerel, LVRelStats *vacrelstats)
 	}
 
 	ereport(elevel,
-			(errmsg("\"%s\": removed %d row versions in %d pages",
+			(errmsg("\"%s\": removed %.0f row versions in %d pages",
 					RelationGetRelationName(onerel),
-					tupindex, npages),
+					(double) ntuples, npages),
 			 errdetail_internal("%s", pg_rusage_show(&ru0))));
 }
 
@@ -1528,17 +1744,17 @@ lazy_vacuum_heap(Relation onerel, LVRelStats *vacrelstats)
  *
  * Caller must hold pin and buffer cleanup lock on the buffer.
  *
- * tupindex is the index in vacrelstats->dead_tuples of the first dead
- * tuple for this page.  We assume the rest follow sequentially.
- * The return value is the first tupindex after the tuples of this page.
+ * deadoffsets[] holds the ndead offsets of the page's dead items.
  */
-static int
+static void
 lazy_vacuum_page(Relation onerel, BlockNumber blkno, Buffer buffer,
-				 int tupindex, LVRelStats *vacrelstats, Buffer *vmbuffer)
+				 OffsetNumber *deadoffsets, int ndead,
+				 LVRelStats *vacrelstats, Buffer *vmbuffer)
 {
 	Page		page = BufferGetPage(buffer);
 	OffsetNumber unused[MaxOffsetNumber];
 	int			uncnt = 0;
+	int			i;
 	TransactionId visibility_cutoff_xid;
 	bool		all_frozen;
 
@@ -1546,16 +1762,11 @@ lazy_vacuum_page(Relation onerel, BlockNumber blkno, Buffer buffer,
 
 	START_CRIT_SECTION();
 
-	for (; tupindex < vacrelstats->num_dead_tuples; tupindex++)
+	for (i = 0; i < ndead; i++)
 	{
-		BlockNumber tblk;
-		OffsetNumber toff;
+		OffsetNumber toff = deadoffsets[i];
 		ItemId		itemid;
 
-		tblk = ItemPointerGetBlockNumber(&vacrelstats->dead_tuples[tupindex]);
-		if (tblk != blkno)
-			break;				/* past end of tuples for this block */
-		toff = ItemPointerGetOffsetNumber(&vacrelstats->dead_tuples[tupindex]);
 		itemid = PageGetItemId(page, toff);
 		ItemIdSetUnused(itemid);
 		unused[uncnt++] = toff;
@@ -1619,8 +1830,6 @@ lazy_vacuum_page(Relation onerel, BlockNumber blkno, Buffer buffer,
 			visibilitymap_set(onerel, blkno, buffer, InvalidXLogRecPtr,
 							  *vmbuffer, visibility_cutoff_xid, flags);
 	}
-
-	return tupindex;
 }
 
 /*
@@ -1676,16 +1885,75 @@ lazy_check_needs_freeze(Buffer buf, bool *hastup)
 }
 
 
+/*
+ *	lazy_vacuum_all_indexes() -- vacuum all indexes of the relation.
+ *
+ *		Delete all the index entries pointing to tuples listed in
+ *		vacrelstats->dead_tuples, in parallel if lps is given.
+ */
+static void
+lazy_vacuum_all_indexes(Relation *Irel, IndexBulkDeleteResult **stats,
+						int nindexes, LVRelStats *vacrelstats,
+						LVParallelState *lps)
+{
+	int			i;
+
+	/* We can only provide an approximate value of num_heap_tuples here */
+	if (lps)
+		lazy_parallel_vacuum_indexes(lps, Irel, false,
+									 vacrelstats->old_live_tuples, true);
+	else
+	{
+		for (i = 0; i < nindexes; i++)
+			lazy_vacuum_index(Irel[i], &stats[i], vacrelstats->dead_tuples,
+							  vacrelstats->old_live_tuples);
+	}
+}
+
+/*
+ *	lazy_cleanup_all_indexes() -- do post-vacuum cleanup for all indexes.
+ *
+ *		The resulting statistics are left in stats[], or in the DSM segment
+ *		if lps is given; see update_index_statistics.
+ */
+static void
+lazy_cleanup_all_indexes(Relation *Irel, IndexBulkDeleteResult **stats,
+						 int nindexes, LVRelStats *vacrelstats,
+						 LVParallelState *lps)
+{
+	bool		estimated_count;
+	int			i;
+
+	/*
+	 * Now we can provide a better estimate of total number of surviving
+	 * tuples (we assume indexes are more interested in that than in the
+	 * number of nominally live tuples).
+	 */
+	estimated_count = (vacrelstats->tupcount_pages < vacrelstats->rel_pages);
+
+	if (lps)
+		lazy_parallel_vacuum_indexes(lps, Irel, true,
+									 vacrelstats->new_rel_tuples,
+									 estimated_count);
+	else
+	{
+		for (i = 0; i < nindexes; i++)
+			lazy_cleanup_index(Irel[i], &stats[i],
+							   vacrelstats->new_rel_tuples, estimated_count);
+	}
+}
+
 /*
  *	lazy_vacuum_index() -- vacuum one index relation.
  *
  *		Delete all the index entries pointing to tuples listed in
- *		vacrelstats->dead_tuples, and update running statistics.
+ *		dead_tuples, and update running statistics.  reltuples is the
+ *		number of heap tuples to report to the index AM.
  */
 static void
 lazy_vacuum_index(Relation indrel,
 				  IndexBulkDeleteResult **stats,
-				  LVRelStats *vacrelstats)
+				  TidStore *dead_tuples, double reltuples)
 {
 	IndexVacuumInfo ivinfo;
 	PGRUsage	ru0;
@@ -1696,28 +1964,30 @@ lazy_vacuum_index(Relation indrel,
 	ivinfo.analyze_only = false;
 	ivinfo.estimated_count = true;
 	ivinfo.message_level = elevel;
-	/* We can only provide an approximate value of num_heap_tuples here */
-	ivinfo.num_heap_tuples = vacrelstats->old_live_tuples;
+	ivinfo.num_heap_tuples = reltuples;
 	ivinfo.strategy = vac_strategy;
 
 	/* Do bulk deletion */
 	*stats = index_bulk_delete(&ivinfo, *stats,
-							   lazy_tid_reaped, (void *) vacrelstats);
+							   lazy_tid_reaped, (void *) dead_tuples);
 
 	ereport(elevel,
-			(errmsg("scanned index \"%s\" to remove %d row versions",
+			(errmsg("scanned index \"%s\" to remove %.0f row versions",
 					RelationGetRelationName(indrel),
-					vacrelstats->num_dead_tuples),
+					(double) TidStoreNumTids(dead_tuples)),
 			 errdetail_internal("%s", pg_rusage_show(&ru0))));
 }
 
 /*
  *	lazy_cleanup_index() -- do post-vacuum cleanup for one index relation.
+ *
+ *		The index's statistics are returned in *stats, for
+ *		update_index_statistics to store in pg_class.
  */
 static void
 lazy_cleanup_index(Relation indrel,
-				   IndexBulkDeleteResult *stats,
-				   LVRelStats *vacrelstats)
+				   IndexBulkDeleteResult **stats,
+				   double reltuples, bool estimated_count)
 {
 	IndexVacuumInfo ivinfo;
 	PGRUsage	ru0;
@@ -1726,49 +1996,310 @@ lazy_cleanup_index(Relation indrel,
 
 	ivinfo.index = indrel;
 	ivinfo.analyze_only = false;
-	ivinfo.estimated_count = (vacrelstats->tupcount_pages < vacrelstats->rel_pages);
+	ivinfo.estimated_count = estimated_count;
 	ivinfo.message_level = elevel;
-
-	/*
-	 * Now we can provide a better estimate of total number of surviving
-	 * tuples (we assume indexes are more interested in that than in the
-	 * number of nominally live tuples).
-	 */
-	ivinfo.num_heap_tuples = vacrelstats->new_rel_tuples;
+	ivinfo.num_heap_tuples = reltuples;
 	ivinfo.strategy = vac_strategy;
 
-	stats = index_vacuum_cleanup(&ivinfo, stats);
+	*stats = index_vacuum_cleanup(&ivinfo, *stats);
 
-	if (!stats)
+	if (!*stats)
 		return;
 
-	/*
-	 * Now update statistics in pg_class, but only if the index says the count
-	 * is accurate.
-	 */
-	if (!stats->estimated_count)
-		vac_update_relstats(indrel,
-							stats->num_pages,
-							stats->num_index_tuples,
-							0,
-							false,
-							InvalidTransactionId,
-							InvalidMultiXactId,
-							false);
-
 	ereport(elevel,
 			(errmsg("index \"%s\" now contains %.0f row versions in %u pages",
 					RelationGetRelationName(indrel),
-					stats->num_index_tuples,
-					stats->num_pages),
+					(*stats)->num_index_tuples,
+					(*stats)->num_pages),
 			 errdetail("%.0f index row versions were removed.\n"
 					   "%u index pages have been deleted, %u are currently reusable.\n"
 					   "%s.",
-					   stats->tuples_removed,
-					   stats->pages_deleted, stats->pages_free,
+					   (*stats)->tuples_removed,
+					   (*stats)->pages_deleted, (*stats)->pages_free,
 					   pg_rusage_show(&ru0))));
+}
+
+/*
+ *	update_index_statistics() -- update pg_class entries of all indexes.
+ *
+ *		This is done only for indexes that say their tuple count is
+ *		accurate.  The stats[] entries are freed.
+ */
+static void
+update_index_statistics(Relation *Irel, IndexBulkDeleteResult **stats,
+						int nindexes)
+{
+	int			i;
 
-	pfree(stats);
+	Assert(!IsInParallelMode());
+
+	for (i = 0; i < nindexes; i++)
+	{
+		if (stats[i] == NULL)
+			continue;
+
+		if (!stats[i]->estimated_count)
+			vac_update_relstats(Irel[i],
+								stats[i]->num_pages,
+								stats[i]->num_index_tuples,
+								0,
+								false,
+								InvalidTransactionId,
+								InvalidMultiXactId,
+								false);
+
+		pfree(stats[i]);
+		stats[i] = NULL;
+	}
+}
+
+/*
+ * begin_parallel_vacuum - set up parallel index vacuuming
+ *
+ * Enters parallel mode and creates a parallel context whose DSM segment
+ * holds the dead tuple store and the per-index statistics.  Workers are
+ * launched separately for each index pass.  Returns NULL, leaving the
+ * caller to vacuum indexes serially, if no workers could be used.
+ */
+static LVParallelState *
+begin_parallel_vacuum(Relation onerel, Relation *Irel, int nindexes,
+					  BlockNumber nblocks, int nrequested)
+{
+	LVParallelState *lps;
+	ParallelContext *pcxt;
+	LVShared   *lvshared;
+	Size		est_shared;
+	Size		est_deadtuples;
+	char	   *sharedquery;
+	int			querylen;
+	int			nworkers;
+	int			i;
+
+	/*
+	 * The leader processes indexes too, so more than nindexes - 1 workers
+	 * would never have anything to do.
+	 */
+	nworkers = Min(nrequested, nindexes - 1);
+	nworkers = Min(nworkers, max_parallel_maintenance_workers);
+	if (nworkers <= 0)
+		return NULL;
+
+	/* Workers could not see dirty pages in our local buffers */
+	if (RelationUsesLocalBuffers(onerel))
+		return NULL;
+
+	EnterParallelMode();
+	pcxt = CreateParallelContext("postgres", "lazy_parallel_vacuum_main",
+								 nworkers, true);
+
+	/* Estimate space for LVShared -- PARALLEL_VACUUM_KEY_SHARED */
+	est_shared = add_size(offsetof(LVShared, indstats),
+						  mul_size(sizeof(LVSharedIndStats), nindexes));
+	shm_toc_estimate_chunk(&pcxt->estimator, est_shared);
+
+	/* Estimate space for the TidStore -- PARALLEL_VACUUM_KEY_DEAD_TUPLES */
+	est_deadtuples = TidStoreSize(dead_tuples_max_bytes(), nblocks);
+	shm_toc_estimate_chunk(&pcxt->estimator, est_deadtuples);
+
+	/* Finally, estimate PARALLEL_VACUUM_KEY_QUERY_TEXT space */
+	querylen = strlen(debug_query_string);
+	shm_toc_estimate_chunk(&pcxt->estimator, querylen + 1);
+	shm_toc_estimate_keys(&pcxt->estimator, 3);
+
+	InitializeParallelDSM(pcxt);
+
+	lvshared = (LVShared *) shm_toc_allocate(pcxt->toc, est_shared);
+	MemSet(lvshared, 0, est_shared);
+	lvshared->elevel = elevel;
+	pg_atomic_init_u32(&lvshared->nextindex, 0);
+	lvshared->nindexes = nindexes;
+	for (i = 0; i < nindexes; i++)
+		lvshared->indstats[i].indexoid = RelationGetRelid(Irel[i]);
+	shm_toc_insert(pcxt->toc, PARALLEL_VACUUM_KEY_SHARED, lvshared);
+
+	lps = (LVParallelState *) palloc0(sizeof(LVParallelState));
+	lps->pcxt = pcxt;
+	lps->lvshared = lvshared;
+	lps->dead_tuples =
+		TidStoreInitialize(shm_toc_allocate(pcxt->toc, est_deadtuples),
+						   est_deadtuples);
+	shm_toc_insert(pcxt->toc, PARALLEL_VACUUM_KEY_DEAD_TUPLES,
+				   lps->dead_tuples);
+
+	/* Store query string for workers */
+	sharedquery = (char *) shm_toc_allocate(pcxt->toc, querylen + 1);
+	memcpy(sharedquery, debug_query_string, querylen + 1);
+	shm_toc_insert(pcxt->toc, PARALLEL_VACUUM_KEY_QUERY_TEXT, sharedquery);
+
+	return lps;
+}
+
+/*
+ * end_parallel_vacuum - copy index statistics out of the DSM segment, then
+ * destroy the parallel context and end parallel mode
+ */
+static void
+end_parallel_vacuum(LVParallelState *lps, IndexBulkDeleteResult **stats,
+					int nindexes)
+{
+	int			i;
+
+	for (i = 0; i < nindexes; i++)
+	{
+		LVSharedIndStats *indstats = &lps->lvshared->indstats[i];
+
+		if (indstats->updated)
+		{
+			stats[i] = (IndexBulkDeleteResult *)
+				palloc(sizeof(IndexBulkDeleteResult));
+			memcpy(stats[i], &indstats->stats, sizeof(IndexBulkDeleteResult));
+		}
+		else
+			stats[i] = NULL;
+	}
+
+	DestroyParallelContext(lps->pcxt);
+	ExitParallelMode();
+	pfree(lps);
+}
+
+/*
+ * lazy_parallel_vacuum_indexes - run one index pass with parallel workers
+ *
+ * Launches the workers, processes indexes alongside them, and waits for
+ * all of them to finish.
+ */
+static void
+lazy_parallel_vacuum_indexes(LVParallelState *lps, Relation *Irel,
+							 bool for_cleanup, double reltuples,
+							 bool estimated_count)
+{
+	LVShared   *lvshared = lps->lvshared;
+
+	lvshared->for_cleanup = for_cleanup;
+	lvshared->reltuples = reltuples;
+	lvshared->estimated_count = estimated_count;
+	pg_atomic_write_u32(&lvshared->nextindex, 0);
+
+	if (lps->launched)
+		ReinitializeParallelDSM(lps->pcxt);
+	LaunchParallelWorkers(lps->pcxt);
+	lps->launched = true;
+
+	if (for_cleanup)
+		ereport(elevel,
+				(errmsg(ngettext("launched %d parallel vacuum worker for index cleanup (planned: %d)",
+								 "launched %d parallel vacuum workers for index cleanup (planned: %d)",
+								 lps->pcxt->nworkers_launched),
+						lps->pcxt->nworkers_launched, lps->pcxt->nworkers)));
+	else
+		ereport(elevel,
+				(errmsg(ngettext("launched %d parallel vacuum worker for index vacuuming (planned: %d)",
+								 "launched %d parallel vacuum workers for index vacuuming (planned: %d)",
+								 lps->pcxt->nworkers_launched),
+						lps->pcxt->nworkers_launched, lps->pcxt->nworkers)));
+
+	/* Process indexes ourselves until none are left */
+	parallel_vacuum_indexes(Irel, lvshared, lps->dead_tuples);
+
+	WaitForParallelWorkersToFinish(lps->pcxt);
+}
+
+/*
+ * parallel_vacuum_indexes - process indexes until none are left
+ *
+ * This is run by the leader and every worker.  Each index is claimed by
+ * exactly one participant, which keeps its statistics in the DSM segment.
+ */
+static void
+parallel_vacuum_indexes(Relation *Irel, LVShared *lvshared,
+						TidStore *dead_tuples)
+{
+	for (;;)
+	{
+		uint32		idx;
+		LVSharedIndStats *indstats;
+		IndexBulkDeleteResult *stats;
+
+		idx = pg_atomic_fetch_add_u32(&lvshared->nextindex, 1);
+		if (idx >= lvshared->nindexes)
+			break;
+
+		indstats = &lvshared->indstats[idx];
+		stats = indstats->updated ? &indstats->stats : NULL;
+
+		if (lvshared->for_cleanup)
+			lazy_cleanup_index(Irel[idx], &stats, lvshared->reltuples,
+							   lvshared->estimated_count);
+		else
+			lazy_vacuum_index(Irel[idx], &stats, dead_tuples,
+							  lvshared->reltuples);
+
+		/*
+		 * The index AM may have returned newly palloc'd statistics, which
+		 * must be copied into shared memory for the leader to see.
+		 */
+		if (stats == NULL)
+			indstats->updated = false;
+		else if (stats != &indstats->stats)
+		{
+			memcpy(&indstats->stats, stats, sizeof(IndexBulkDeleteResult));
+			indstats->updated = true;
+			pfree(stats);
+		}
+	}
+}
+
+/*
+ * Main entry point for parallel index vacuum worker processes.
+ *
+ * The leader holds the locks on the table and its indexes throughout, so
+ * opening the indexes here can't block, since we're in its lock group.
+ */
+void
+lazy_parallel_vacuum_main(dsm_segment *seg, shm_toc *toc)
+{
+	LVShared   *lvshared;
+	TidStore   *dead_tuples;
+	Relation   *indrels;
+	char	   *sharedquery;
+	int			i;
+
+	/* Set debug_query_string for individual workers first */
+	sharedquery = shm_toc_lookup(toc, PARALLEL_VACUUM_KEY_QUERY_TEXT, false);
+	debug_query_string = sharedquery;
+
+	/* Report the query string from leader */
+	pgstat_report_activity(STATE_RUNNING, debug_query_string);
+
+	lvshared = (LVShared *) shm_toc_lookup(toc, PARALLEL_VACUUM_KEY_SHARED,
+										   false);
+	dead_tuples = (TidStore *) shm_toc_lookup(toc,
+											  PARALLEL_VACUUM_KEY_DEAD_TUPLES,
+											  false);
+	elevel = lvshared->elevel;
+
+	indrels = (Relation *) palloc(lvshared->nindexes * sizeof(Relation));
+	for (i = 0; i < lvshared->nindexes; i++)
+		indrels[i] = index_open(lvshared->indstats[i].indexoid,
+								RowExclusiveLock);
+
+	/*
+	 * Each worker applies the cost-based vacuum delay on its own, starting
+	 * from a zero balance.
+	 */
+	VacuumCostActive = (VacuumCostDelay > 0);
+	VacuumCostBalance = 0;
+	VacuumPageHit = 0;
+	VacuumPageMiss = 0;
+	VacuumPageDirty = 0;
+	vac_strategy = GetAccessStrategy(BAS_VACUUM);
+
+	parallel_vacuum_indexes(indrels, lvshared, dead_tuples);
+
+	for (i = 0; i < lvshared->nindexes; i++)
+		index_close(indrels[i], RowExclusiveLock);
+	FreeAccessStrategy(vac_strategy);
 }
 
 /*
@@ -2074,113 +2605,86 @@ count_nondeletable_pages(Relation onerel, LVRelStats *vacrelstats)
 }
 
 /*
- * lazy_space_alloc - space allocation decisions for lazy vacuum
- *
- * See the comments at the head of this file for rationale.
+ * dead_tuples_max_bytes - memory budget for the dead tuple store
  */
-static void
-lazy_space_alloc(LVRelStats *vacrelstats, BlockNumber relblocks)
+static Size
+dead_tuples_max_bytes(void)
 {
-	long		maxtuples;
 	int			vac_work_mem = IsAutoVacuumWorkerProcess() &&
 	autovacuum_work_mem != -1 ?
 	autovacuum_work_mem : maintenance_work_mem;
 
-	if (vacrelstats->hasindex)
-	{
-		maxtuples = (vac_work_mem * 1024L) / sizeof(ItemPointerData);
-		maxtuples = Min(maxtuples, INT_MAX);
-		maxtuples = Min(maxtuples, MaxAllocSize / sizeof(ItemPointerData));
+	return (Size) vac_work_mem * 1024;
+}
 
-		/* curious coding here to ensure the multiplication can't overflow */
-		if ((BlockNumber) (maxtuples / LAZY_ALLOC_TUPLES) > relblocks)
-			maxtuples = relblocks * LAZY_ALLOC_TUPLES;
+/*
+ * lazy_space_alloc - space allocation decisions for lazy vacuum
+ *
+ * See the comments at the head of this file for rationale.  If lps is
+ * given, the dead tuple store it has set up in its DSM segment is used.
+ */
+static void
+lazy_space_alloc(LVRelStats *vacrelstats, BlockNumber relblocks,
+				 LVParallelState *lps)
+{
+	vacrelstats->num_dead_tuples = 0;
+	vacrelstats->num_page_dead = 0;
 
-		/* stay sane if small maintenance_work_mem */
-		maxtuples = Max(maxtuples, MaxHeapTuplesPerPage);
-	}
+	/*
+	 * The store may exceed MaxAllocSize, so unlike the flat TID array we
+	 * used to have, all of maintenance_work_mem can be used.
+	 */
+	if (lps)
+		vacrelstats->dead_tuples = lps->dead_tuples;
+	else if (vacrelstats->useindex)
+		vacrelstats->dead_tuples = TidStoreCreate(dead_tuples_max_bytes(),
+												  relblocks);
 	else
-	{
-		maxtuples = MaxHeapTuplesPerPage;
-	}
-
-	vacrelstats->num_dead_tuples = 0;
-	vacrelstats->max_dead_tuples = (int) maxtuples;
-	vacrelstats->dead_tuples = (ItemPointer)
-		palloc(maxtuples * sizeof(ItemPointerData));
+		vacrelstats->dead_tuples = NULL;
 }
 
 /*
  * lazy_record_dead_tuple - remember one deletable tuple
+ *
+ * The tuple must be on the page being scanned; its offset is added to
+ * vacrelstats->page_dead until lazy_record_dead_page is called.
  */
 static void
 lazy_record_dead_tuple(LVRelStats *vacrelstats,
 					   ItemPointer itemptr)
 {
-	/*
-	 * The array shouldn't overflow under normal behavior, but perhaps it
-	 * could if we are given a really small maintenance_work_mem. In that
-	 * case, just forget the last few tuples (we'll get 'em next time).
-	 */
-	if (vacrelstats->num_dead_tuples < vacrelstats->max_dead_tuples)
-	{
-		vacrelstats->dead_tuples[vacrelstats->num_dead_tuples] = *itemptr;
-		vacrelstats->num_dead_tuples++;
-		pgstat_progress_update_param(PROGRESS_VACUUM_NUM_DEAD_TUPLES,
-									 vacrelstats->num_dead_tuples);
-	}
+	Assert(vacrelstats->num_page_dead < MaxHeapTuplesPerPage);
+	vacrelstats->page_dead[vacrelstats->num_page_dead++] =
+		ItemPointerGetOffsetNumber(itemptr);
 }
 
 /*
- *	lazy_tid_reaped() -- is a particular tid deletable?
- *
- *		This has the right signature to be an IndexBulkDeleteCallback.
+ * lazy_record_dead_page - move the dead tuples of a page into dead_tuples
  *
- *		Assumes dead_tuples array is in sorted order.
+ * The caller has already made sure the store has room for them.
  */
-static bool
-lazy_tid_reaped(ItemPointer itemptr, void *state)
+static void
+lazy_record_dead_page(LVRelStats *vacrelstats, BlockNumber blkno)
 {
-	LVRelStats *vacrelstats = (LVRelStats *) state;
-	ItemPointer res;
-
-	res = (ItemPointer) bsearch((void *) itemptr,
-								(void *) vacrelstats->dead_tuples,
-								vacrelstats->num_dead_tuples,
-								sizeof(ItemPointerData),
-								vac_cmp_itemptr);
-
-	return (res != NULL);
+	TidStoreAddBlock(vacrelstats->dead_tuples, blkno,
+					 vacrelstats->page_dead, vacrelstats->num_page_dead);
+	vacrelstats->num_dead_tuples += vacrelstats->num_page_dead;
+	vacrelstats->num_page_dead = 0;
+	pgstat_progress_update_param(PROGRESS_VACUUM_NUM_DEAD_TUPLES,
+								 vacrelstats->num_dead_tuples);
 }
 
 /*
- * Comparator routines for use with qsort() and bsearch().
+ *	lazy_tid_reaped() -- is a particular tid deletable?
+ *
+ *		This has the right signature to be an IndexBulkDeleteCallback.
  */
-static int
-vac_cmp_itemptr(const void *left, const void *right)
+static bool
+lazy_tid_reaped(ItemPointer itemptr, void *state)
 {
-	BlockNumber lblk,
-				rblk;
-	OffsetNumber loff,
-				roff;
-
-	lblk = ItemPointerGetBlockNumber((ItemPointer) left);
-	rblk = ItemPointerGetBlockNumber((ItemPointer) right);
-
-	if (lblk < rblk)
-		return -1;
-	if (lblk > rblk)
-		return 1;
-
-	loff = ItemPointerGetOffsetNumber((ItemPointer) left);
-	roff = ItemPointerGetOffsetNumber((ItemPointer) right);
-
-	if (loff < roff)
-		return -1;
-	if (loff > roff)
-		return 1;
+	TidStore   *dead_tuples = (TidStore *) state;
 
-	return 0;
+	return TidStoreIsMember(dead_tuples, itemptr);
 }
 
 /*
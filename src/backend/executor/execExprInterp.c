@@ -159,6 +159,8 @@ static Datum ExecJustAssignInnerVar(ExprState *state, ExprContext *econtext, boo
 static Datum ExecJustAssignOuterVar(ExprState *state, ExprContext *econtext, bool *isnull);
 static Datum ExecJustAssignScanVar(ExprState *state, ExprContext *econtext, bool *isnull);
 static Datum ExecJustApplyFuncToCase(ExprState *state, ExprContext *econtext, bool *isnull);
+static bool ExecIsSimpleScanQual(ExprState *state);
+static Datum ExecJustSimpleScanQual(ExprState *state, ExprContext *econtext, bool *isnull);
 
 
 /*
@@ -260,6 +262,11 @@ ExecReadyInterpretedExpr(ExprState *state)
 		state->evalfunc_private = (void *) ExecJustConst;
 		return;
 	}
+	else if (ExecIsSimpleScanQual(state))
+	{
+		state->evalfunc_private = (void *) ExecJustSimpleScanQual;
+		return;
+	}
 
 #if defined(EEO_USE_COMPUTED_GOTO)
 
@@ -390,6 +397,7 @@ ExecInterpExpr(ExprState *state, ExprContext *econtext, bool *isnull)
 		&&CASE_EEOP_AGG_STRICT_INPUT_CHECK,
 		&&CASE_EEOP_AGG_INIT_TRANS,
 		&&CASE_EEOP_AGG_STRICT_TRANS_CHECK,
+		&&CASE_EEOP_AGG_PLAIN_PERGROUP_NULLCHECK,
 		&&CASE_EEOP_AGG_PLAIN_TRANS_BYVAL,
 		&&CASE_EEOP_AGG_PLAIN_TRANS,
 		&&CASE_EEOP_AGG_ORDERED_TRANS_DATUM,
@@ -1590,6 +1598,25 @@ ExecInterpExpr(ExprState *state, ExprContext *econtext, bool *isnull)
 			EEO_NEXT();
 		}
 
+		/*
+		 * Skip the transitions of a hashed grouping set whose group isn't in
+		 * memory; the input tuple has been spilled to disk for it instead.
+		 */
+		EEO_CASE(EEOP_AGG_PLAIN_PERGROUP_NULLCHECK)
+		{
+			AggState   *aggstate;
+			AggStatePerGroup pergroup_allaggs;
+
+			aggstate = op->d.agg_plain_pergroup_nullcheck.aggstate;
+			pergroup_allaggs = aggstate->all_pergroups
+				[op->d.agg_plain_pergroup_nullcheck.setoff];
+
+			if (pergroup_allaggs == NULL)
+				EEO_JUMP(op->d.agg_plain_pergroup_nullcheck.jumpnull);
+
+			EEO_NEXT();
+		}
+
 		/*
 		 * Evaluate aggregate transition / combine function that has a
 		 * by-value transition type. That's a separate case from the
@@ -2106,6 +2133,105 @@ ExecJustApplyFuncToCase(ExprState *state, ExprContext *econtext, bool *isnull)
 	return d;
 }
 
+/*
+ * Check whether the expression is a qual consisting only of tests of single
+ * scan Vars, e.g. "a > 10 AND b IS NOT NULL".  Such filters are very common
+ * in scans, so it's worth evaluating them without the full interpreter.
+ *
+ * The steps then are a SCAN_FETCHSOME, followed by one (SCAN_VAR, test,
+ * QUAL) triple per qual, where the test is a strict function, whose other
+ * arguments have to be constants as their steps would be present otherwise,
+ * or a null test.  A final DONE step ends the expression.
+ */
+static bool
+ExecIsSimpleScanQual(ExprState *state)
+{
+	int			off;
+
+	if (state->steps_len < 5 || (state->steps_len - 2) % 3 != 0)
+		return false;
+
+	if (state->steps[0].opcode != EEOP_SCAN_FETCHSOME)
+		return false;
+
+	for (off = 1; off < state->steps_len - 1; off += 3)
+	{
+		ExprEvalOp	testop = state->steps[off + 1].opcode;
+
+		if (state->steps[off].opcode != EEOP_SCAN_VAR)
+			return false;
+		if (testop != EEOP_FUNCEXPR_STRICT &&
+			testop != EEOP_NULLTEST_ISNULL &&
+			testop != EEOP_NULLTEST_ISNOTNULL)
+			return false;
+		if (state->steps[off + 2].opcode != EEOP_QUAL)
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Evaluate a qual recognized by ExecIsSimpleScanQual.
+ *
+ * The needed columns are deformed once, then the tests are applied in a
+ * tight loop, stopping at the first one that isn't satisfied, just as the
+ * QUAL steps of the interpreter would.
+ */
+static Datum
+ExecJustSimpleScanQual(ExprState *state, ExprContext *econtext, bool *isnull)
+{
+	TupleTableSlot *slot = econtext->ecxt_scantuple;
+	ExprEvalStep *op = &state->steps[0];
+	ExprEvalStep *last = &state->steps[state->steps_len - 1];
+
+	CheckOpSlotCompatibility(op, slot);
+
+	slot_getsomeattrs(slot, op->d.fetch.last_var);
+
+	*isnull = false;
+
+	for (op++; op < last; op += 3)
+	{
+		ExprEvalStep *varop = op;
+		ExprEvalStep *testop = op + 1;
+		int			attnum = varop->d.var.attnum;
+		bool		result;
+
+		Assert(attnum >= 0 && attnum < slot->tts_nvalid);
+		*varop->resvalue = slot->tts_values[attnum];
+		*varop->resnull = slot->tts_isnull[attnum];
+
+		/* not direct-threaded, so the opcodes can be tested as they are */
+		if (testop->opcode == EEOP_FUNCEXPR_STRICT)
+		{
+			FunctionCallInfo fcinfo = testop->d.func.fcinfo_data;
+			bool	   *argnull = fcinfo->argnull;
+			int			argno;
+			Datum		d;
+
+			/* strict function, so a NULL argument makes the qual fail */
+			for (argno = 0; argno < testop->d.func.nargs; argno++)
+			{
+				if (argnull[argno])
+					return BoolGetDatum(false);
+			}
+			fcinfo->isnull = false;
+			d = testop->d.func.fn_addr(fcinfo);
+			result = !fcinfo->isnull && DatumGetBool(d);
+		}
+		else if (testop->opcode == EEOP_NULLTEST_ISNULL)
+			result = slot->tts_isnull[attnum];
+		else
+			result = !slot->tts_isnull[attnum];
+
+		if (!result)
+			return BoolGetDatum(false);
+	}
+
+	return BoolGetDatum(true);
+}
+
 #if defined(EEO_USE_COMPUTED_GOTO)
 /*
  * Comparator used when building address->opcode lookup table for
@@ -4110,6 +4236,19 @@ ExecEvalAggOrderedTransDatum(ExprState *state, ExprEvalStep *op,
 	AggStatePerTrans pertrans = op->d.agg_trans.pertrans;
 	int			setno = op->d.agg_trans.setno;
 
+	if (pertrans->hashDistinct && !pertrans->distincthashes[setno].spilled)
+	{
+		TupleTableSlot *slot = pertrans->sortslot;
+
+		ExecClearTuple(slot);
+		slot->tts_values[0] = *op->resvalue;
+		slot->tts_isnull[0] = *op->resnull;
+		ExecStoreVirtualTuple(slot);
+		ExecAggDistinctHashInsert(op->d.agg_trans.aggstate, pertrans,
+								  setno, slot);
+		return;
+	}
+
 	tuplesort_putdatum(pertrans->sortstates[setno],
 					   *op->resvalue, *op->resnull);
 }
@@ -4127,5 +4266,11 @@ ExecEvalAggOrderedTransTuple(ExprState *state, ExprEvalStep *op,
 	ExecClearTuple(pertrans->sortslot);
 	pertrans->sortslot->tts_nvalid = pertrans->numInputs;
 	ExecStoreVirtualTuple(pertrans->sortslot);
-	tuplesort_puttupleslot(pertrans->sortstates[setno], pertrans->sortslot);
+
+	if (pertrans->hashDistinct && !pertrans->distincthashes[setno].spilled)
+		ExecAggDistinctHashInsert(op->d.agg_trans.aggstate, pertrans,
+								  setno, pertrans->sortslot);
+	else
+		tuplesort_puttupleslot(pertrans->sortstates[setno],
+							   pertrans->sortslot);
 }
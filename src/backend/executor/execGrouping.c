@@ -142,6 +142,10 @@ execTuplesHashPrepare(int numCols,
  *	tablecxt: memory context in which to store table and table entries
  *	tempcxt: short-lived context for evaluation hash and comparison functions
  *
+ * BuildTupleHashTableExt additionally takes metacxt, which holds the table
+ * itself while tablecxt holds only the entries; that lets a caller free all
+ * entries at once by resetting tablecxt after ResetTupleHashTable.
+ *
  * The function arrays may be made with execTuplesHashPrepare().  Note they
  * are not cross-type functions, but expect to see the table datatype(s)
  * on both sides.
@@ -158,6 +162,24 @@ BuildTupleHashTable(PlanState *parent,
 					long nbuckets, Size additionalsize,
 					MemoryContext tablecxt, MemoryContext tempcxt,
 					bool use_variable_hash_iv)
+{
+	return BuildTupleHashTableExt(parent, inputDesc, numCols, keyColIdx,
+								  eqfuncoids, hashfunctions,
+								  nbuckets, additionalsize,
+								  tablecxt, tablecxt, tempcxt,
+								  use_variable_hash_iv);
+}
+
+TupleHashTable
+BuildTupleHashTableExt(PlanState *parent,
+					   TupleDesc inputDesc,
+					   int numCols, AttrNumber *keyColIdx,
+					   const Oid *eqfuncoids,
+					   FmgrInfo *hashfunctions,
+					   long nbuckets, Size additionalsize,
+					   MemoryContext metacxt,
+					   MemoryContext tablecxt, MemoryContext tempcxt,
+					   bool use_variable_hash_iv)
 {
 	TupleHashTable hashtable;
 	Size		entrysize = sizeof(TupleHashEntryData) + additionalsize;
@@ -169,7 +191,7 @@ BuildTupleHashTable(PlanState *parent,
 	nbuckets = Min(nbuckets, (long) ((work_mem * 1024L) / entrysize));
 
 	hashtable = (TupleHashTable)
-		MemoryContextAlloc(tablecxt, sizeof(TupleHashTableData));
+		MemoryContextAlloc(metacxt, sizeof(TupleHashTableData));
 
 	hashtable->numCols = numCols;
 	hashtable->keyColIdx = keyColIdx;
@@ -195,9 +217,9 @@ BuildTupleHashTable(PlanState *parent,
 	else
 		hashtable->hash_iv = 0;
 
-	hashtable->hashtab = tuplehash_create(tablecxt, nbuckets, hashtable);
+	hashtable->hashtab = tuplehash_create(metacxt, nbuckets, hashtable);
 
-	oldcontext = MemoryContextSwitchTo(hashtable->tablecxt);
+	oldcontext = MemoryContextSwitchTo(metacxt);
 
 	/*
 	 * We copy the input tuple descriptor just for safety --- we assume all
@@ -221,6 +243,18 @@ BuildTupleHashTable(PlanState *parent,
 	return hashtable;
 }
 
+/*
+ * Remove all entries from a TupleHashTable
+ *
+ * This doesn't free the memory the entries' tuples occupy; callers that
+ * built the table with a separate tablecxt should reset that context.
+ */
+void
+ResetTupleHashTable(TupleHashTable hashtable)
+{
+	tuplehash_reset(hashtable->hashtab);
+}
+
 /*
  * Find or create a hashtable entry for the tuple group containing the
  * given tuple.  The tuple must be the same type as the hashtable entries.
@@ -282,6 +316,31 @@ LookupTupleHashEntry(TupleHashTable hashtable, TupleTableSlot *slot,
 	return entry;
 }
 
+/*
+ * Compute the hash value of the given tuple, exactly as the hashtable itself
+ * would for lookups and insertions.  The tuple must be the same type as the
+ * hashtable entries.  This is for callers that need to divide tuples up
+ * consistently with the table, e.g. into partitions to be spilled to disk.
+ */
+uint32
+TupleHashTableHashSlot(TupleHashTable hashtable, TupleTableSlot *slot)
+{
+	MemoryContext oldContext;
+	uint32		hash;
+
+	/* Need to run the hash functions in short-lived context */
+	oldContext = MemoryContextSwitchTo(hashtable->tempcxt);
+
+	hashtable->inputslot = slot;
+	hashtable->in_hash_funcs = hashtable->tab_hash_funcs;
+
+	hash = TupleHashTableHash(hashtable->hashtab, NULL);
+
+	MemoryContextSwitchTo(oldContext);
+
+	return hash;
+}
+
 /*
  * Search for a hashtable entry matching the given tuple.  No entry is
  * created if there's not a match.  This is similar to the non-creating
@@ -374,8 +433,7 @@ TupleHashTableHash(struct tuplehash_hash *tb, const MinimalTuple tuple)
 		{
 			uint32		hkey;
 
-			hkey = DatumGetUInt32(FunctionCall1(&hashfunctions[i],
-												attr));
+			hkey = hash_datum_fast(&hashfunctions[i], InvalidOid, attr);
 			hashkey ^= hkey;
 		}
 	}
@@ -262,8 +262,12 @@ ExecCloseIndices(ResultRelInfo *resultRelInfo)
  *		If 'arbiterIndexes' is nonempty, noDupErr applies only to
  *		those indexes.  NIL means noDupErr applies to all indexes.
  *
- *		CAUTION: this must not be called for a HOT update.
- *		We can't defend against that here for lack of info.
+ *		If 'onlySummarizing' is true, entries are inserted only into
+ *		summarizing indexes; that is what a HOT update which changed their
+ *		columns needs (see heap_update).
+ *
+ *		CAUTION: this must not be called with onlySummarizing false for
+ *		a HOT update.  We can't defend against that here for lack of info.
  *		Should we change the API to make it safer?
  * ----------------------------------------------------------------
  */
@@ -273,7 +277,8 @@ ExecInsertIndexTuples(TupleTableSlot *slot,
 					  EState *estate,
 					  bool noDupErr,
 					  bool *specConflict,
-					  List *arbiterIndexes)
+					  List *arbiterIndexes,
+					  bool onlySummarizing)
 {
 	List	   *result = NIL;
 	ResultRelInfo *resultRelInfo;
@@ -324,6 +329,13 @@ ExecInsertIndexTuples(TupleTableSlot *slot,
 		if (!indexInfo->ii_ReadyForInserts)
 			continue;
 
+		/*
+		 * Skip processing of non-summarizing indexes if we only update
+		 * summarizing indexes
+		 */
+		if (onlySummarizing && !indexInfo->ii_Summarizing)
+			continue;
+
 		/* Check for partial index */
 		if (indexInfo->ii_Predicate != NIL)
 		{
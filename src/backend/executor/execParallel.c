@@ -33,6 +33,7 @@
 #include "executor/nodeHashjoin.h"
 #include "executor/nodeIndexscan.h"
 #include "executor/nodeIndexonlyscan.h"
+#include "executor/nodeRedistribute.h"
 #include "executor/nodeSeqscan.h"
 #include "executor/nodeSort.h"
 #include "executor/nodeSubplan.h"
@@ -64,6 +65,7 @@
 #define PARALLEL_KEY_DSA				UINT64CONST(0xE000000000000007)
 #define PARALLEL_KEY_QUERY_TEXT		UINT64CONST(0xE000000000000008)
 #define PARALLEL_KEY_JIT_INSTRUMENTATION UINT64CONST(0xE000000000000009)
+#define PARALLEL_KEY_WAL_USAGE			UINT64CONST(0xE00000000000000A)
 
 #define PARALLEL_TUPLE_QUEUE_SIZE		65536
 
@@ -112,6 +114,7 @@ typedef struct ExecParallelEstimateContext
 {
 	ParallelContext *pcxt;
 	int			nnodes;
+	bool		has_redistribute;
 } ExecParallelEstimateContext;
 
 /* Context object for ExecParallelInitializeDSM. */
@@ -130,6 +133,8 @@ static bool ExecParallelInitializeDSM(PlanState *node,
 						  ExecParallelInitializeDSMContext *d);
 static shm_mq_handle **ExecParallelSetupTupleQueues(ParallelContext *pcxt,
 							 bool reinitialize);
+static bool ExecParallelSetParticipants(PlanState *planstate,
+							ParallelContext *pcxt);
 static bool ExecParallelReInitializeDSM(PlanState *planstate,
 							ParallelContext *pcxt);
 static bool ExecParallelRetrieveInstrumentation(PlanState *planstate,
@@ -226,6 +231,8 @@ ExecSerializePlan(Plan *plan, EState *estate)
 static bool
 ExecParallelEstimate(PlanState *planstate, ExecParallelEstimateContext *e)
 {
+	ListCell   *lc;
+
 	if (planstate == NULL)
 		return false;
 
@@ -282,11 +289,20 @@ ExecParallelEstimate(PlanState *planstate, ExecParallelEstimateContext *e)
 			/* even when not parallel-aware, for EXPLAIN ANALYZE */
 			ExecSortEstimate((SortState *) planstate, e->pcxt);
 			break;
+		case T_RedistributeState:
+			ExecRedistributeEstimate((RedistributeState *) planstate,
+									 e->pcxt);
+			e->has_redistribute = true;
+			break;
 
 		default:
 			break;
 	}
 
+	/* Hashed subplans may share their hash table. */
+	foreach(lc, planstate->subPlan)
+		ExecSubPlanEstimate(lfirst_node(SubPlanState, lc), e->pcxt);
+
 	return planstate_tree_walker(planstate, ExecParallelEstimate, e);
 }
 
@@ -425,6 +441,8 @@ static bool
 ExecParallelInitializeDSM(PlanState *planstate,
 						  ExecParallelInitializeDSMContext *d)
 {
+	ListCell   *lc;
+
 	if (planstate == NULL)
 		return false;
 
@@ -495,11 +513,18 @@ ExecParallelInitializeDSM(PlanState *planstate,
 			/* even when not parallel-aware, for EXPLAIN ANALYZE */
 			ExecSortInitializeDSM((SortState *) planstate, d->pcxt);
 			break;
+		case T_RedistributeState:
+			ExecRedistributeInitializeDSM((RedistributeState *) planstate,
+										  d->pcxt);
+			break;
 
 		default:
 			break;
 	}
 
+	foreach(lc, planstate->subPlan)
+		ExecSubPlanInitializeDSM(lfirst_node(SubPlanState, lc), d->pcxt);
+
 	return planstate_tree_walker(planstate, ExecParallelInitializeDSM, d);
 }
 
@@ -573,6 +598,7 @@ ExecInitParallelPlan(PlanState *planstate, EState *estate,
 	char	   *pstmt_space;
 	char	   *paramlistinfo_space;
 	BufferUsage *bufusage_space;
+	WalUsage   *walusage_space;
 	SharedExecutorInstrumentation *instrumentation = NULL;
 	SharedJitInstrumentation *jit_instrumentation = NULL;
 	int			pstmt_len;
@@ -646,6 +672,11 @@ ExecInitParallelPlan(PlanState *planstate, EState *estate,
 						   mul_size(sizeof(BufferUsage), pcxt->nworkers));
 	shm_toc_estimate_keys(&pcxt->estimator, 1);
 
+	/* Same thing for WalUsage. */
+	shm_toc_estimate_chunk(&pcxt->estimator,
+						   mul_size(sizeof(WalUsage), pcxt->nworkers));
+	shm_toc_estimate_keys(&pcxt->estimator, 1);
+
 	/* Estimate space for tuple queues. */
 	shm_toc_estimate_chunk(&pcxt->estimator,
 						   mul_size(PARALLEL_TUPLE_QUEUE_SIZE, pcxt->nworkers));
@@ -657,7 +688,9 @@ ExecInitParallelPlan(PlanState *planstate, EState *estate,
 	 */
 	e.pcxt = pcxt;
 	e.nnodes = 0;
+	e.has_redistribute = false;
 	ExecParallelEstimate(planstate, &e);
+	pei->has_redistribute = e.has_redistribute;
 
 	/* Estimate space for instrumentation, if required. */
 	if (estate->es_instrument)
@@ -728,6 +761,12 @@ ExecInitParallelPlan(PlanState *planstate, EState *estate,
 	shm_toc_insert(pcxt->toc, PARALLEL_KEY_BUFFER_USAGE, bufusage_space);
 	pei->buffer_usage = bufusage_space;
 
+	/* Same for WalUsage. */
+	walusage_space = shm_toc_allocate(pcxt->toc,
+									  mul_size(sizeof(WalUsage), pcxt->nworkers));
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_WAL_USAGE, walusage_space);
+	pei->wal_usage = walusage_space;
+
 	/* Set up the tuple queues that the workers will write into. */
 	pei->tqueue = ExecParallelSetupTupleQueues(pcxt, false);
 
@@ -823,6 +862,44 @@ ExecInitParallelPlan(PlanState *planstate, EState *estate,
 	return pei;
 }
 
+/*
+ * Tell the parallel-aware nodes that need it how many workers were actually
+ * launched.  This must be called right after LaunchParallelWorkers().
+ *
+ * Redistribute nodes in the workers can't start exchanging tuples before
+ * they know who they are exchanging them with, so they wait for this.  We
+ * then also wait for all the workers to attach, so that a worker that fails
+ * to start is reported instead of leaving the others waiting for its tuples.
+ */
+void
+ExecParallelWorkersLaunched(ParallelExecutorInfo *pei)
+{
+	if (!pei->has_redistribute)
+		return;
+
+	ExecParallelSetParticipants(pei->planstate, pei->pcxt);
+
+	if (pei->pcxt->nworkers_launched > 0)
+		WaitForParallelWorkersToAttach(pei->pcxt);
+}
+
+/*
+ * Planstate tree walker for ExecParallelWorkersLaunched().
+ */
+static bool
+ExecParallelSetParticipants(PlanState *planstate, ParallelContext *pcxt)
+{
+	if (planstate == NULL)
+		return false;
+
+	if (IsA(planstate, RedistributeState))
+		ExecRedistributeSetParticipants((RedistributeState *) planstate,
+										pcxt);
+
+	return planstate_tree_walker(planstate, ExecParallelSetParticipants,
+								 pcxt);
+}
+
 /*
  * Set up tuple queue readers to read the results of a parallel subplan.
  *
@@ -955,6 +1032,10 @@ ExecParallelReInitializeDSM(PlanState *planstate,
 				ExecHashJoinReInitializeDSM((HashJoinState *) planstate,
 											pcxt);
 			break;
+		case T_RedistributeState:
+			ExecRedistributeReInitializeDSM((RedistributeState *) planstate,
+											pcxt);
+			break;
 		case T_HashState:
 		case T_SortState:
 			/* these nodes have DSM state, but no reinitialization is required */
@@ -1109,11 +1190,11 @@ ExecParallelFinish(ParallelExecutorInfo *pei)
 	WaitForParallelWorkersToFinish(pei->pcxt);
 
 	/*
-	 * Next, accumulate buffer usage.  (This must wait for the workers to
-	 * finish, or we might get incomplete data.)
+	 * Next, accumulate buffer and WAL usage.  (This must wait for the workers
+	 * to finish, or we might get incomplete data.)
 	 */
 	for (i = 0; i < nworkers; i++)
-		InstrAccumParallelQuery(&pei->buffer_usage[i]);
+		InstrAccumParallelQuery(&pei->buffer_usage[i], &pei->wal_usage[i]);
 
 	pei->finished = true;
 }
@@ -1252,6 +1333,8 @@ ExecParallelReportInstrumentation(PlanState *planstate,
 static bool
 ExecParallelInitializeWorker(PlanState *planstate, ParallelWorkerContext *pwcxt)
 {
+	ListCell   *lc;
+
 	if (planstate == NULL)
 		return false;
 
@@ -1303,11 +1386,18 @@ ExecParallelInitializeWorker(PlanState *planstate, ParallelWorkerContext *pwcxt)
 			/* even when not parallel-aware, for EXPLAIN ANALYZE */
 			ExecSortInitializeWorker((SortState *) planstate, pwcxt);
 			break;
+		case T_RedistributeState:
+			ExecRedistributeInitializeWorker((RedistributeState *) planstate,
+											 pwcxt);
+			break;
 
 		default:
 			break;
 	}
 
+	foreach(lc, planstate->subPlan)
+		ExecSubPlanInitializeWorker(lfirst_node(SubPlanState, lc), pwcxt);
+
 	return planstate_tree_walker(planstate, ExecParallelInitializeWorker,
 								 pwcxt);
 }
@@ -1333,6 +1423,7 @@ ParallelQueryMain(dsm_segment *seg, shm_toc *toc)
 {
 	FixedParallelExecutorState *fpes;
 	BufferUsage *buffer_usage;
+	WalUsage   *wal_usage;
 	DestReceiver *receiver;
 	QueryDesc  *queryDesc;
 	SharedExecutorInstrumentation *instrumentation;
@@ -1406,9 +1497,11 @@ ParallelQueryMain(dsm_segment *seg, shm_toc *toc)
 	/* Shut down the executor */
 	ExecutorFinish(queryDesc);
 
-	/* Report buffer usage during parallel execution. */
+	/* Report buffer and WAL usage during parallel execution. */
 	buffer_usage = shm_toc_lookup(toc, PARALLEL_KEY_BUFFER_USAGE, false);
-	InstrEndParallelQuery(&buffer_usage[ParallelWorkerNumber]);
+	wal_usage = shm_toc_lookup(toc, PARALLEL_KEY_WAL_USAGE, false);
+	InstrEndParallelQuery(&buffer_usage[ParallelWorkerNumber],
+						  &wal_usage[ParallelWorkerNumber]);
 
 	/* Report instrumentation data if any instrumentation options are set. */
 	if (instrumentation != NULL)
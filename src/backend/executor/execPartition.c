@@ -18,6 +18,7 @@
 #include "catalog/pg_type.h"
 #include "executor/execPartition.h"
 #include "executor/executor.h"
+#include "executor/nodeModifyTable.h"
 #include "foreign/fdwapi.h"
 #include "mb/pg_wchar.h"
 #include "miscadmin.h"
@@ -124,6 +125,13 @@ struct PartitionTupleRouting
  *		routing it through this table). A NULL value is stored if no tuple
  *		conversion is required.
  *
+ * last_found_datum_index, last_found_part_index, last_found_count
+ *		The bound offset and partition index that get_partition_for_tuple
+ *		returned last for a list or range partitioned table, and how many
+ *		tuples in a row have gone to that partition.  Used to skip the binary
+ *		search of the bounds when the input is sorted or clustered on the
+ *		partition key, as with time-ordered data.
+ *
  * indexes
  *		Array of partdesc->nparts elements.  For leaf partitions the index
  *		corresponds to the partition's ResultRelInfo in the encapsulating
@@ -141,9 +149,20 @@ typedef struct PartitionDispatchData
 	PartitionDesc partdesc;
 	TupleTableSlot *tupslot;
 	AttrNumber *tupmap;
+	int			last_found_datum_index;
+	int			last_found_part_index;
+	int			last_found_count;
 	int			indexes[FLEXIBLE_ARRAY_MEMBER];
 } PartitionDispatchData;
 
+/*
+ * The number of consecutive tuples that must go to the same partition before
+ * get_partition_for_tuple starts checking the last found partition first.
+ * Checking it costs one or two comparisons that are wasted when the partition
+ * changes often, so only bother once the input looks sorted.
+ */
+#define PARTITION_CACHED_FIND_THRESHOLD	16
+
 /* struct to hold result relations coming from UPDATE subplans */
 typedef struct SubplanResultRelHashElem
 {
@@ -926,8 +945,14 @@ ExecInitRoutingInfo(ModifyTableState *mtstate,
 	 */
 	if (partRelInfo->ri_FdwRoutine != NULL &&
 		partRelInfo->ri_FdwRoutine->BeginForeignInsert != NULL)
+	{
 		partRelInfo->ri_FdwRoutine->BeginForeignInsert(mtstate, partRelInfo);
 
+		/* Rows routed here by INSERT or COPY may be sent in batches */
+		if (mtstate && mtstate->operation == CMD_INSERT)
+			ExecSetForeignInsertBatchSize(partRelInfo);
+	}
+
 	partRelInfo->ri_PartitionInfo = partrouteinfo;
 
 	/*
@@ -1019,6 +1044,10 @@ ExecInitPartitionDispatchInfo(PartitionTupleRouting *proute, Oid partoid,
 		pd->tupslot = NULL;
 	}
 
+	pd->last_found_datum_index = -1;
+	pd->last_found_part_index = -1;
+	pd->last_found_count = 0;
+
 	/*
 	 * Initialize with -1 to signify that the corresponding partition's
 	 * ResultRelInfo or PartitionDispatch has not been created yet.
@@ -1196,16 +1225,81 @@ FormPartitionKeyDatum(PartitionDispatch pd,
  *
  * Return value is index of the partition (>= 0 and < partdesc->nparts) if one
  * found or -1 if none found.
+ *
+ * Once enough consecutive tuples have gone to the same list or range
+ * partition, we first check whether the tuple belongs to that partition
+ * again before searching the bounds; see PARTITION_CACHED_FIND_THRESHOLD.
  */
 static int
 get_partition_for_tuple(PartitionDispatch pd, Datum *values, bool *isnull)
 {
-	int			bound_offset;
+	int			bound_offset = -1;
 	int			part_index = -1;
 	PartitionKey key = pd->key;
 	PartitionDesc partdesc = pd->partdesc;
 	PartitionBoundInfo boundinfo = partdesc->boundinfo;
 
+	if (pd->last_found_count >= PARTITION_CACHED_FIND_THRESHOLD)
+	{
+		int			last_datum_offset = pd->last_found_datum_index;
+
+		if (key->strategy == PARTITION_STRATEGY_LIST)
+		{
+			if (!isnull[0] &&
+				DatumGetInt32(FunctionCall2Coll(&key->partsupfunc[0],
+												key->partcollation[0],
+												boundinfo->datums[last_datum_offset][0],
+												values[0])) == 0)
+			{
+				pd->last_found_count++;
+				return pd->last_found_part_index;
+			}
+		}
+		else
+		{
+			bool		fits = true;
+			int			i;
+
+			Assert(key->strategy == PARTITION_STRATEGY_RANGE);
+
+			for (i = 0; i < key->partnatts; i++)
+			{
+				if (isnull[i])
+				{
+					fits = false;
+					break;
+				}
+			}
+
+			/*
+			 * The tuple belongs to the same partition if it's still at or
+			 * above the bound at the cached offset and below the next bound.
+			 */
+			if (fits && last_datum_offset >= 0)
+				fits = partition_rbound_datum_cmp(key->partsupfunc,
+												  key->partcollation,
+												  boundinfo->datums[last_datum_offset],
+												  boundinfo->kind[last_datum_offset],
+												  values,
+												  key->partnatts) <= 0;
+			if (fits && last_datum_offset + 1 < boundinfo->ndatums)
+				fits = partition_rbound_datum_cmp(key->partsupfunc,
+												  key->partcollation,
+												  boundinfo->datums[last_datum_offset + 1],
+												  boundinfo->kind[last_datum_offset + 1],
+												  values,
+												  key->partnatts) > 0;
+			if (fits)
+			{
+				pd->last_found_count++;
+				return pd->last_found_part_index;
+			}
+		}
+
+		/* Not the same partition anymore; do a full search */
+		pd->last_found_count = 0;
+	}
+
 	/* Route as appropriate based on partitioning strategy. */
 	switch (key->strategy)
 	{
@@ -1286,6 +1380,27 @@ get_partition_for_tuple(PartitionDispatch pd, Datum *values, bool *isnull)
 				 (int) key->strategy);
 	}
 
+	/*
+	 * Remember where we found a list or range partition, so that we can try
+	 * it first for the next tuples.  bound_offset is only set by the list
+	 * and range searches; the NULL-accepting list partition and the default
+	 * partition are not covered by any bound offset, so they are never
+	 * cached.
+	 */
+	if (part_index >= 0 && bound_offset >= 0)
+	{
+		if (pd->last_found_datum_index == bound_offset)
+			pd->last_found_count++;
+		else
+		{
+			pd->last_found_datum_index = bound_offset;
+			pd->last_found_part_index = part_index;
+			pd->last_found_count = 1;
+		}
+	}
+	else
+		pd->last_found_count = 0;
+
 	/*
 	 * part_index < 0 means we failed to find a partition of this parent. Use
 	 * the default partition, if there is one.
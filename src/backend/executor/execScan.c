@@ -19,6 +19,7 @@
 #include "postgres.h"
 
 #include "executor/executor.h"
+#include "executor/nodeHashjoin.h"
 #include "miscadmin.h"
 #include "utils/memutils.h"
 
@@ -125,6 +126,7 @@ ExecScan(ScanState *node,
 	ExprContext *econtext;
 	ExprState  *qual;
 	ProjectionInfo *projInfo;
+	List	   *hjfilters;
 
 	/*
 	 * Fetch data from node
@@ -132,6 +134,7 @@ ExecScan(ScanState *node,
 	qual = node->ps.qual;
 	projInfo = node->ps.ps_ProjInfo;
 	econtext = node->ps.ps_ExprContext;
+	hjfilters = node->ss_HashJoinFilters;
 
 	/* interrupt checks are in ExecScanFetch */
 
@@ -139,7 +142,7 @@ ExecScan(ScanState *node,
 	 * If we have neither a qual to check nor a projection to do, just skip
 	 * all the overhead and return the raw scan tuple.
 	 */
-	if (!qual && !projInfo)
+	if (!qual && !projInfo && hjfilters == NIL)
 	{
 		ResetExprContext(econtext);
 		return ExecScanFetch(node, accessMtd, recheckMtd);
@@ -186,8 +189,12 @@ ExecScan(ScanState *node,
 		 * check for non-null qual here to avoid a function call to ExecQual()
 		 * when the qual is null ... saves only a few cycles, but they add up
 		 * ...
+		 *
+		 * Then check it against the filters of any hash joins above us, which
+		 * know that tuples they can't join to may be discarded right away.
 		 */
-		if (qual == NULL || ExecQual(qual, econtext))
+		if ((qual == NULL || ExecQual(qual, econtext)) &&
+			(hjfilters == NIL || ExecHashJoinFilterTuple(hjfilters, econtext)))
 		{
 			/*
 			 * Found a satisfactory scan tuple.
@@ -881,7 +881,12 @@ slot_deform_heap_tuple(TupleTableSlot *slot, HeapTuple tuple, uint32 *offp,
 
 	tp = (char *) tup + tup->t_hoff;
 
-	for (; attnum < natts; attnum++)
+	/*
+	 * First walk the attributes whose offset can be cached in the tuple
+	 * descriptor, i.e. those before the first NULL or variable-width value
+	 * of this tuple.
+	 */
+	for (; !slow && attnum < natts; attnum++)
 	{
 		Form_pg_attribute thisatt = TupleDescAttr(tupleDesc, attnum);
 
@@ -895,7 +900,7 @@ slot_deform_heap_tuple(TupleTableSlot *slot, HeapTuple tuple, uint32 *offp,
 
 		isnull[attnum] = false;
 
-		if (!slow && thisatt->attcacheoff >= 0)
+		if (thisatt->attcacheoff >= 0)
 			off = thisatt->attcacheoff;
 		else if (thisatt->attlen == -1)
 		{
@@ -905,8 +910,7 @@ slot_deform_heap_tuple(TupleTableSlot *slot, HeapTuple tuple, uint32 *offp,
 			 * pad bytes in any case: then the offset will be valid for either
 			 * an aligned or unaligned value.
 			 */
-			if (!slow &&
-				off == att_align_nominal(off, thisatt->attalign))
+			if (off == att_align_nominal(off, thisatt->attalign))
 				thisatt->attcacheoff = off;
 			else
 			{
@@ -919,9 +923,7 @@ slot_deform_heap_tuple(TupleTableSlot *slot, HeapTuple tuple, uint32 *offp,
 		{
 			/* not varlena, so safe to use att_align_nominal */
 			off = att_align_nominal(off, thisatt->attalign);
-
-			if (!slow)
-				thisatt->attcacheoff = off;
+			thisatt->attcacheoff = off;
 		}
 
 		values[attnum] = fetchatt(thisatt, tp + off);
@@ -932,6 +934,33 @@ slot_deform_heap_tuple(TupleTableSlot *slot, HeapTuple tuple, uint32 *offp,
 			slow = true;		/* can't use attcacheoff anymore */
 	}
 
+	/*
+	 * The offsets of the remaining attributes depend on the values before
+	 * them, so they have to be computed from the current offset.  In wide
+	 * tables with varlena or nullable columns near the front that's most of
+	 * the attributes, so keep this loop free of attcacheoff checks.
+	 */
+	for (; attnum < natts; attnum++)
+	{
+		Form_pg_attribute thisatt = TupleDescAttr(tupleDesc, attnum);
+
+		if (hasnulls && att_isnull(attnum, bp))
+		{
+			values[attnum] = (Datum) 0;
+			isnull[attnum] = true;
+			continue;
+		}
+
+		isnull[attnum] = false;
+
+		off = att_align_pointer(off, thisatt->attalign, thisatt->attlen,
+								tp + off);
+
+		values[attnum] = fetchatt(thisatt, tp + off);
+
+		off = att_addlength_pointer(off, thisatt->attlen, tp + off);
+	}
+
 	/*
 	 * Save state for next execution
 	 */
@@ -55,6 +55,7 @@
 #include "parser/parsetree.h"
 #include "storage/lmgr.h"
 #include "utils/builtins.h"
+#include "utils/guc.h"
 #include "utils/memutils.h"
 #include "utils/rel.h"
 #include "utils/typcache.h"
@@ -617,6 +618,45 @@ ExecFreeExprContext(PlanState *planstate)
 	planstate->ps_ExprContext = NULL;
 }
 
+/* ----------------
+ *		ExecCheckRowEstimate
+ *
+ * Called by materializing nodes (Hash, Sort) once they have read all of
+ * their input, to compare the number of rows read with the planner's
+ * estimate.  If they differ by at least log_misestimate_factor, a message
+ * is logged, at most once per node, so that the badly-estimated queries can
+ * be found without waiting for them to complete and without running them
+ * under EXPLAIN ANALYZE.
+ * ----------------
+ */
+void
+ExecCheckRowEstimate(PlanState *planstate, const char *nodename,
+					 double estimated_rows, double actual_rows)
+{
+	double		est;
+	double		act;
+	double		factor;
+
+	if (log_misestimate_factor <= 0 || planstate->misestimate_logged)
+		return;
+
+	/* the planner never estimates less than one row, so clamp both */
+	est = Max(estimated_rows, 1.0);
+	act = Max(actual_rows, 1.0);
+	factor = (act > est) ? act / est : est / act;
+
+	if (factor < log_misestimate_factor)
+		return;
+
+	planstate->misestimate_logged = true;
+
+	ereport(LOG,
+			(errmsg("row count estimate for input of %s node was off by a factor of %.0f",
+					nodename, factor),
+			 errdetail("Estimated %.0f rows, read %.0f rows.",
+					   estimated_rows, actual_rows)));
+}
+
 
 /* ----------------------------------------------------------------
  *				  Scan node support
@@ -17,12 +17,58 @@
 
 #include "executor/instrument.h"
 
+/*
+ * On x86-64, plan nodes can be timed with the CPU's time stamp counter.
+ * Reading it with RDTSC takes a few nanoseconds, while clock_gettime() can
+ * be many times slower, particularly on virtual machines whose clock source
+ * is not the TSC (pg_test_timing shows how slow).  Since node timing reads
+ * the clock twice per tuple per node, that largely determines the overhead of
+ * EXPLAIN ANALYZE.  We use the TSC only if the CPU reports it as invariant,
+ * meaning it ticks at a constant rate regardless of frequency scaling and
+ * sleep states, and convert cycles to seconds with a rate measured against
+ * the system clock the first time it's needed in a process.
+ */
+#if defined(__x86_64__) && defined(HAVE__GET_CPUID)
+#define HAVE_INSTR_TSC 1
+#include <cpuid.h>
+#include <x86intrin.h>
+#elif defined(_M_AMD64) && defined(HAVE__CPUID)
+#define HAVE_INSTR_TSC 1
+#include <intrin.h>
+#endif
+
+#ifdef HAVE_INSTR_TSC
+#define INSTR_READ_TSC()	((uint64) __rdtsc())
+#else
+#define INSTR_READ_TSC()	((uint64) 0)
+#endif
+
+/* How long to measure the TSC rate for, in microseconds */
+#define TSC_CALIBRATION_USEC	1000
+
+#define InstrTimerRunning(instr) \
+	((instr)->use_tsc ? (instr)->startcycles != 0 : \
+	 !INSTR_TIME_IS_ZERO((instr)->starttime))
+
+/* GUC variables */
+int			instrument_timing_sample_rate = 1;
+bool		instrument_timing_use_tsc = true;
+
 BufferUsage pgBufferUsage;
 static BufferUsage save_pgBufferUsage;
+WalUsage	pgWalUsage;
+static WalUsage save_pgWalUsage;
+
+/* 0 if not checked yet, 1 if the TSC can be used, -1 if not */
+static int	tsc_state = 0;
+static double tsc_seconds_per_cycle;
 
+static bool InstrTscUsable(void);
+static double InstrGetCounter(Instrumentation *instr);
 static void BufferUsageAdd(BufferUsage *dst, const BufferUsage *add);
 static void BufferUsageAccumDiff(BufferUsage *dst,
 					 const BufferUsage *add, const BufferUsage *sub);
+static void WalUsageAdd(WalUsage *dst, const WalUsage *add);
 
 
 /* Allocate new instrumentation structure(s) */
@@ -33,16 +79,22 @@ InstrAlloc(int n, int instrument_options)
 
 	/* initialize all fields to zeroes, then modify as needed */
 	instr = palloc0(n * sizeof(Instrumentation));
-	if (instrument_options & (INSTRUMENT_BUFFERS | INSTRUMENT_TIMER))
+	if (instrument_options & (INSTRUMENT_BUFFERS | INSTRUMENT_TIMER | INSTRUMENT_WAL))
 	{
 		bool		need_buffers = (instrument_options & INSTRUMENT_BUFFERS) != 0;
+		bool		need_wal = (instrument_options & INSTRUMENT_WAL) != 0;
 		bool		need_timer = (instrument_options & INSTRUMENT_TIMER) != 0;
+		bool		use_tsc = need_timer && instrument_timing_use_tsc &&
+		InstrTscUsable();
 		int			i;
 
 		for (i = 0; i < n; i++)
 		{
 			instr[i].need_bufusage = need_buffers;
+			instr[i].need_walusage = need_wal;
 			instr[i].need_timer = need_timer;
+			instr[i].use_tsc = use_tsc;
+			instr[i].sample_rate = instrument_timing_sample_rate;
 		}
 	}
 
@@ -55,20 +107,42 @@ InstrInit(Instrumentation *instr, int instrument_options)
 {
 	memset(instr, 0, sizeof(Instrumentation));
 	instr->need_bufusage = (instrument_options & INSTRUMENT_BUFFERS) != 0;
+	instr->need_walusage = (instrument_options & INSTRUMENT_WAL) != 0;
 	instr->need_timer = (instrument_options & INSTRUMENT_TIMER) != 0;
+	instr->use_tsc = instr->need_timer && instrument_timing_use_tsc &&
+		InstrTscUsable();
+	instr->sample_rate = instrument_timing_sample_rate;
 }
 
 /* Entry to a plan node */
 void
 InstrStartNode(Instrumentation *instr)
 {
-	if (instr->need_timer &&
-		!INSTR_TIME_SET_CURRENT_LAZY(instr->starttime))
-		elog(ERROR, "InstrStartNode called twice in a row");
+	/*
+	 * Time only every sample_rate'th iteration.  The first iteration of each
+	 * cycle is always timed, so that the startup time is exact.
+	 */
+	if (instr->need_timer)
+	{
+		if (instr->iterations++ % instr->sample_rate == 0)
+		{
+			if (InstrTimerRunning(instr))
+				elog(ERROR, "InstrStartNode called twice in a row");
+
+			if (instr->use_tsc)
+				instr->startcycles = INSTR_READ_TSC();
+			else
+				INSTR_TIME_SET_CURRENT(instr->starttime);
+			instr->timed_iterations++;
+		}
+	}
 
 	/* save buffer usage totals at node entry, if needed */
 	if (instr->need_bufusage)
 		instr->bufusage_start = pgBufferUsage;
+
+	if (instr->need_walusage)
+		instr->walusage_start = pgWalUsage;
 }
 
 /* Exit from a plan node */
@@ -83,13 +157,27 @@ InstrStopNode(Instrumentation *instr, double nTuples)
 	/* let's update the time only if the timer was requested */
 	if (instr->need_timer)
 	{
-		if (INSTR_TIME_IS_ZERO(instr->starttime))
+		if (InstrTimerRunning(instr))
+		{
+			if (instr->use_tsc)
+			{
+				uint64		endcycles = INSTR_READ_TSC();
+
+				/* the TSCs of different CPUs might be slightly out of sync */
+				if (endcycles > instr->startcycles)
+					instr->cycles += endcycles - instr->startcycles;
+				instr->startcycles = 0;
+			}
+			else
+			{
+				INSTR_TIME_SET_CURRENT(endtime);
+				INSTR_TIME_ACCUM_DIFF(instr->counter, endtime, instr->starttime);
+
+				INSTR_TIME_SET_ZERO(instr->starttime);
+			}
+		}
+		else if (instr->sample_rate == 1)
 			elog(ERROR, "InstrStopNode called without start");
-
-		INSTR_TIME_SET_CURRENT(endtime);
-		INSTR_TIME_ACCUM_DIFF(instr->counter, endtime, instr->starttime);
-
-		INSTR_TIME_SET_ZERO(instr->starttime);
 	}
 
 	/* Add delta of buffer usage since entry to node's totals */
@@ -97,11 +185,15 @@ InstrStopNode(Instrumentation *instr, double nTuples)
 		BufferUsageAccumDiff(&instr->bufusage,
 							 &pgBufferUsage, &instr->bufusage_start);
 
+	if (instr->need_walusage)
+		WalUsageAccumDiff(&instr->walusage,
+						  &pgWalUsage, &instr->walusage_start);
+
 	/* Is this the first tuple of this cycle? */
 	if (!instr->running)
 	{
 		instr->running = true;
-		instr->firsttuple = INSTR_TIME_GET_DOUBLE(instr->counter);
+		instr->firsttuple = InstrGetCounter(instr);
 	}
 }
 
@@ -115,11 +207,23 @@ InstrEndLoop(Instrumentation *instr)
 	if (!instr->running)
 		return;
 
-	if (!INSTR_TIME_IS_ZERO(instr->starttime))
+	if (InstrTimerRunning(instr))
 		elog(ERROR, "InstrEndLoop called on running node");
 
 	/* Accumulate per-cycle statistics into totals */
-	totaltime = INSTR_TIME_GET_DOUBLE(instr->counter);
+	totaltime = InstrGetCounter(instr);
+
+	/*
+	 * If only some iterations were timed, extrapolate the total from those.
+	 * The first iteration is left out of that, since it often includes much
+	 * of the node's startup work; its time is already in firsttuple.
+	 */
+	if (instr->timed_iterations > 1 &&
+		instr->timed_iterations < instr->iterations)
+		totaltime = instr->firsttuple +
+			(totaltime - instr->firsttuple) *
+			(double) (instr->iterations - 1) /
+			(double) (instr->timed_iterations - 1);
 
 	instr->startup += instr->firsttuple;
 	instr->total += totaltime;
@@ -130,6 +234,10 @@ InstrEndLoop(Instrumentation *instr)
 	instr->running = false;
 	INSTR_TIME_SET_ZERO(instr->starttime);
 	INSTR_TIME_SET_ZERO(instr->counter);
+	instr->startcycles = 0;
+	instr->cycles = 0;
+	instr->iterations = 0;
+	instr->timed_iterations = 0;
 	instr->firsttuple = 0;
 	instr->tuplecount = 0;
 }
@@ -147,6 +255,9 @@ InstrAggNode(Instrumentation *dst, Instrumentation *add)
 		dst->firsttuple = add->firsttuple;
 
 	INSTR_TIME_ADD(dst->counter, add->counter);
+	dst->cycles += add->cycles;
+	dst->iterations += add->iterations;
+	dst->timed_iterations += add->timed_iterations;
 
 	dst->tuplecount += add->tuplecount;
 	dst->startup += add->startup;
@@ -160,6 +271,9 @@ InstrAggNode(Instrumentation *dst, Instrumentation *add)
 	/* Add delta of buffer usage since entry to node's totals */
 	if (dst->need_bufusage)
 		BufferUsageAdd(&dst->bufusage, &add->bufusage);
+
+	if (dst->need_walusage)
+		WalUsageAdd(&dst->walusage, &add->walusage);
 }
 
 /* note current values during parallel executor startup */
@@ -167,21 +281,90 @@ void
 InstrStartParallelQuery(void)
 {
 	save_pgBufferUsage = pgBufferUsage;
+	save_pgWalUsage = pgWalUsage;
 }
 
 /* report usage after parallel executor shutdown */
 void
-InstrEndParallelQuery(BufferUsage *result)
+InstrEndParallelQuery(BufferUsage *bufusage, WalUsage *walusage)
 {
-	memset(result, 0, sizeof(BufferUsage));
-	BufferUsageAccumDiff(result, &pgBufferUsage, &save_pgBufferUsage);
+	memset(bufusage, 0, sizeof(BufferUsage));
+	BufferUsageAccumDiff(bufusage, &pgBufferUsage, &save_pgBufferUsage);
+	memset(walusage, 0, sizeof(WalUsage));
+	WalUsageAccumDiff(walusage, &pgWalUsage, &save_pgWalUsage);
 }
 
 /* accumulate work done by workers in leader's stats */
 void
-InstrAccumParallelQuery(BufferUsage *result)
+InstrAccumParallelQuery(BufferUsage *bufusage, WalUsage *walusage)
 {
-	BufferUsageAdd(&pgBufferUsage, result);
+	BufferUsageAdd(&pgBufferUsage, bufusage);
+	WalUsageAdd(&pgWalUsage, walusage);
+}
+
+/*
+ * Check whether the TSC can be used for timing, measuring its rate the first
+ * time through.
+ */
+static bool
+InstrTscUsable(void)
+{
+#ifdef HAVE_INSTR_TSC
+	if (tsc_state == 0)
+	{
+		unsigned int exx[4] = {0, 0, 0, 0};
+		instr_time	start;
+		instr_time	elapsed;
+		uint64		startcycles;
+		uint64		endcycles;
+
+		tsc_state = -1;
+
+#if defined(HAVE__GET_CPUID)
+		if (!__get_cpuid(0x80000007, &exx[0], &exx[1], &exx[2], &exx[3]))
+			return false;
+#else
+		__cpuid((int *) exx, 0x80000000);
+		if (exx[0] < 0x80000007)
+			return false;
+		__cpuid((int *) exx, 0x80000007);
+#endif
+
+		/* the invariant TSC flag is bit 8 of EDX */
+		if ((exx[3] & (1 << 8)) == 0)
+			return false;
+
+		INSTR_TIME_SET_CURRENT(start);
+		startcycles = INSTR_READ_TSC();
+		do
+		{
+			INSTR_TIME_SET_CURRENT(elapsed);
+			endcycles = INSTR_READ_TSC();
+			INSTR_TIME_SUBTRACT(elapsed, start);
+		} while (INSTR_TIME_GET_MICROSEC(elapsed) < TSC_CALIBRATION_USEC);
+
+		if (endcycles <= startcycles)
+			return false;
+
+		tsc_seconds_per_cycle = INSTR_TIME_GET_DOUBLE(elapsed) /
+			(double) (endcycles - startcycles);
+		tsc_state = 1;
+	}
+
+	return tsc_state > 0;
+#else
+	return false;
+#endif
+}
+
+/* Accumulated runtime of the current cycle, in seconds */
+static double
+InstrGetCounter(Instrumentation *instr)
+{
+	if (instr->use_tsc)
+		return (double) instr->cycles * tsc_seconds_per_cycle;
+
+	return INSTR_TIME_GET_DOUBLE(instr->counter);
 }
 
 /* dst += add */
@@ -223,3 +406,21 @@ BufferUsageAccumDiff(BufferUsage *dst,
 	INSTR_TIME_ACCUM_DIFF(dst->blk_write_time,
 						  add->blk_write_time, sub->blk_write_time);
 }
+
+/* dst += add */
+static void
+WalUsageAdd(WalUsage *dst, const WalUsage *add)
+{
+	dst->wal_records += add->wal_records;
+	dst->wal_fpi += add->wal_fpi;
+	dst->wal_bytes += add->wal_bytes;
+}
+
+/* dst += add - sub */
+void
+WalUsageAccumDiff(WalUsage *dst, const WalUsage *add, const WalUsage *sub)
+{
+	dst->wal_records += add->wal_records - sub->wal_records;
+	dst->wal_fpi += add->wal_fpi - sub->wal_fpi;
+	dst->wal_bytes += add->wal_bytes - sub->wal_bytes;
+}
@@ -194,6 +194,29 @@
  *	  transition values.  hashcontext is the single context created to support
  *	  all hash tables.
  *
+ *	  Spilling hashed aggregation to disk:
+ *
+ *	  When the planner's estimate of the number of groups is too low, the hash
+ *	  table of an AGG_HASHED node could grow far beyond work_mem.  To prevent
+ *	  that, once the table holds as many groups as we estimate fit into
+ *	  work_mem, we stop creating new groups: input tuples that belong to a
+ *	  group already in the table are still aggregated, while the others are
+ *	  written out, partitioned by hash value, to the tapes of a logical tape
+ *	  set.  After the in-memory groups have been emitted, the table is reset
+ *	  and each partition is processed in turn as a "batch" of input, using
+ *	  further bits of the hash value to partition again if a batch still
+ *	  doesn't fit.
+ *
+ *	  With several hashed grouping sets (including those of AGG_MIXED), all
+ *	  the hash tables share the memory budget, and an input tuple is spilled
+ *	  separately for each grouping set whose group isn't in memory; the
+ *	  transition expression then skips those grouping sets, since their
+ *	  pergroup pointers are NULL (see EEOP_AGG_PLAIN_PERGROUP_NULLCHECK).
+ *	  Each batch belongs to a single grouping set and is processed with only
+ *	  that set's hash table.  In AGG_MIXED mode the batches are processed
+ *	  after the sorted grouping sets and the in-memory hashed groups have
+ *	  been returned.
+ *
  *    Transition / Combine function invocation:
  *
  *    For performance reasons transition functions, including combine
@@ -216,6 +239,8 @@
 
 #include "postgres.h"
 
+#include <math.h>
+
 #include "access/htup_details.h"
 #include "catalog/objectaccess.h"
 #include "catalog/pg_aggregate.h"
@@ -232,6 +257,9 @@
 #include "parser/parse_coerce.h"
 #include "utils/acl.h"
 #include "utils/builtins.h"
+#include "utils/dynahash.h"
+#include "utils/fmgroids.h"
+#include "utils/logtape.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/syscache.h"
@@ -239,6 +267,54 @@
 #include "utils/datum.h"
 
 
+/*
+ * Parameters for spilling hashed aggregation.  We create enough partitions
+ * that each is expected to fit into work_mem with some room to spare, within
+ * the given bounds; each partition's tape has a write buffer of its own, so
+ * that all of them together don't take more than a quarter of work_mem.
+ */
+#define HASHAGG_PARTITION_FACTOR 1.50
+#define HASHAGG_MIN_PARTITIONS 4
+#define HASHAGG_MAX_PARTITIONS 256
+#define HASHAGG_WRITE_BUFFER_SIZE BLCKSZ
+#define HASHAGG_READ_BUFFER_SIZE BLCKSZ
+
+/*
+ * A logical tape set holding the partitions of one spill.  It's shared by
+ * the batches made from those partitions, and closed once all of them have
+ * been processed.
+ */
+typedef struct HashAggTapeSet
+{
+	LogicalTapeSet *lts;
+	int			nbatches;		/* # of batches still reading from lts */
+} HashAggTapeSet;
+
+/*
+ * Partitions being written while the hash table is full.  Tape i holds the
+ * input tuples whose hash values, after skipping the bits already used by
+ * earlier partitioning, start with the partition_bits bits of i.
+ */
+typedef struct HashAggSpill
+{
+	HashAggTapeSet *tapeset;
+	int			npartitions;
+	int			partition_bits;
+	int64	   *ntuples;		/* # of tuples written to each partition */
+} HashAggSpill;
+
+/*
+ * A spilled partition of one hashed grouping set waiting to be aggregated.
+ */
+typedef struct HashAggBatch
+{
+	int			setno;			/* grouping set the tuples belong to */
+	HashAggTapeSet *tapeset;
+	int			tapenum;
+	int			used_bits;		/* # of hash bits that led to this batch */
+	int64		ntuples;
+} HashAggBatch;
+
 static void select_current_set(AggState *aggstate, int setno, bool is_hash);
 static void initialize_phase(AggState *aggstate, int newphase);
 static TupleTableSlot *fetch_input_tuple(AggState *aggstate);
@@ -249,6 +325,12 @@ static void advance_transition_function(AggState *aggstate,
 							AggStatePerTrans pertrans,
 							AggStatePerGroup pergroupstate);
 static void advance_aggregates(AggState *aggstate);
+static void initialize_ordered_sort(AggStatePerTrans pertrans, int setno);
+static void spill_distinct_hash(AggState *aggstate, AggStatePerTrans pertrans,
+					int setno);
+static void process_hashed_distinct_aggregate(AggState *aggstate,
+								  AggStatePerTrans pertrans,
+								  AggStatePerGroup pergroupstate);
 static void process_ordered_aggregate_single(AggState *aggstate,
 								 AggStatePerTrans pertrans,
 								 AggStatePerGroup pergroupstate);
@@ -273,10 +355,21 @@ static TupleTableSlot *project_aggregates(AggState *aggstate);
 static Bitmapset *find_unaggregated_cols(AggState *aggstate);
 static bool find_unaggregated_cols_walker(Node *node, Bitmapset **colnos);
 static void build_hash_table(AggState *aggstate);
+static void build_hash_table_set(AggState *aggstate, int setno, long nbuckets);
+static void hash_agg_set_limits(AggState *aggstate);
+static Size hash_agg_trans_space(Aggref *aggref, Form_pg_aggregate aggform);
 static TupleHashEntryData *lookup_hash_entry(AggState *aggstate);
-static void lookup_hash_entries(AggState *aggstate);
+static bool lookup_hash_entries(AggState *aggstate);
+static void hash_spill_tuple(AggState *aggstate, int setno, double ngroups_est,
+				 TupleTableSlot *inputslot);
+static void hash_spill_finish(AggState *aggstate);
+static TupleTableSlot *hash_batch_read_tuple(AggState *aggstate,
+					  HashAggBatch *batch);
+static void hash_tapeset_release(AggState *aggstate, HashAggTapeSet *tapeset);
+static void hash_agg_reset_spill(AggState *aggstate);
 static TupleTableSlot *agg_retrieve_direct(AggState *aggstate);
 static void agg_fill_hash_table(AggState *aggstate);
+static bool agg_refill_hash_table(AggState *aggstate);
 static TupleTableSlot *agg_retrieve_hash_table(AggState *aggstate);
 static Datum GetAggInitVal(Datum textInitVal, Oid transtype);
 static void build_pertrans_for_aggref(AggStatePerTrans pertrans,
@@ -433,34 +526,27 @@ initialize_aggregate(AggState *aggstate, AggStatePerTrans pertrans,
 		 * operation?  Clean it up if so.
 		 */
 		if (pertrans->sortstates[aggstate->current_set])
+		{
 			tuplesort_end(pertrans->sortstates[aggstate->current_set]);
-
+			pertrans->sortstates[aggstate->current_set] = NULL;
+		}
 
 		/*
-		 * We use a plain Datum sorter when there's a single input column;
-		 * otherwise sort the full tuple.  (See comments for
-		 * process_ordered_aggregate_single.)
+		 * With hashed DISTINCT, start with an empty hashtable instead; the
+		 * sort is only begun if the table has to be spilled.
 		 */
-		if (pertrans->numInputs == 1)
+		if (pertrans->hashDistinct)
 		{
-			Form_pg_attribute attr = TupleDescAttr(pertrans->sortdesc, 0);
+			AggDistinctHashData *dh =
+			&pertrans->distincthashes[aggstate->current_set];
 
-			pertrans->sortstates[aggstate->current_set] =
-				tuplesort_begin_datum(attr->atttypid,
-									  pertrans->sortOperators[0],
-									  pertrans->sortCollations[0],
-									  pertrans->sortNullsFirst[0],
-									  work_mem, NULL, false);
+			ResetTupleHashTable(dh->hashtable);
+			MemoryContextReset(dh->tablecxt);
+			dh->spaceUsed = 0;
+			dh->spilled = false;
 		}
 		else
-			pertrans->sortstates[aggstate->current_set] =
-				tuplesort_begin_heap(pertrans->sortdesc,
-									 pertrans->numSortCols,
-									 pertrans->sortColIdx,
-									 pertrans->sortOperators,
-									 pertrans->sortCollations,
-									 pertrans->sortNullsFirst,
-									 work_mem, NULL, false);
+			initialize_ordered_sort(pertrans, aggstate->current_set);
 	}
 
 	/*
@@ -494,6 +580,44 @@ initialize_aggregate(AggState *aggstate, AggStatePerTrans pertrans,
 	pergroupstate->noTransValue = pertrans->initValueIsNull;
 }
 
+/*
+ * Begin the sort object of a DISTINCT/ORDER BY aggregate for one grouping set.
+ *
+ * The sort lives in CurrentMemoryContext, which should be the per-query
+ * context.
+ */
+static void
+initialize_ordered_sort(AggStatePerTrans pertrans, int setno)
+{
+	Assert(pertrans->sortstates[setno] == NULL);
+
+	/*
+	 * We use a plain Datum sorter when there's a single input column;
+	 * otherwise sort the full tuple.  (See comments for
+	 * process_ordered_aggregate_single.)
+	 */
+	if (pertrans->numInputs == 1)
+	{
+		Form_pg_attribute attr = TupleDescAttr(pertrans->sortdesc, 0);
+
+		pertrans->sortstates[setno] =
+			tuplesort_begin_datum(attr->atttypid,
+								  pertrans->sortOperators[0],
+								  pertrans->sortCollations[0],
+								  pertrans->sortNullsFirst[0],
+								  work_mem, NULL, false);
+	}
+	else
+		pertrans->sortstates[setno] =
+			tuplesort_begin_heap(pertrans->sortdesc,
+								 pertrans->numSortCols,
+								 pertrans->sortColIdx,
+								 pertrans->sortOperators,
+								 pertrans->sortCollations,
+								 pertrans->sortNullsFirst,
+								 work_mem, NULL, false);
+}
+
 /*
  * Initialize all aggregate transition states for a new group of input values.
  *
@@ -682,6 +806,129 @@ advance_aggregates(AggState *aggstate)
 							  &dummynull);
 }
 
+/*
+ * Add an input value of a hashed DISTINCT aggregate to the hashtable of the
+ * given grouping set.  The value has been stored in slot, which must match
+ * pertrans->sortdesc.
+ *
+ * Duplicates are discarded here.  Once the distinct values exceed work_mem,
+ * they are moved into the sort object, and further values are sorted as
+ * usual (see ExecEvalAggOrderedTransDatum/Tuple).
+ */
+void
+ExecAggDistinctHashInsert(AggState *aggstate, AggStatePerTrans pertrans,
+						  int setno, TupleTableSlot *slot)
+{
+	AggDistinctHashData *dh = &pertrans->distincthashes[setno];
+	TupleHashEntryData *entry;
+	bool		isnew;
+
+	Assert(!dh->spilled);
+
+	entry = LookupTupleHashEntry(dh->hashtable, slot, &isnew);
+	if (isnew)
+	{
+		dh->spaceUsed += dh->hashtable->entrysize + entry->firstTuple->t_len;
+		if (dh->spaceUsed > work_mem * 1024L)
+			spill_distinct_hash(aggstate, pertrans, setno);
+	}
+}
+
+/*
+ * Move the contents of a DISTINCT aggregate's hashtable into a newly begun
+ * sort object, and switch the rest of the group to sorting.
+ */
+static void
+spill_distinct_hash(AggState *aggstate, AggStatePerTrans pertrans, int setno)
+{
+	AggDistinctHashData *dh = &pertrans->distincthashes[setno];
+	TupleTableSlot *slot = pertrans->distinctslot;
+	Tuplesortstate *sortstate;
+	TupleHashIterator iter;
+	TupleHashEntryData *entry;
+	MemoryContext oldContext;
+
+	oldContext = MemoryContextSwitchTo(aggstate->ss.ps.state->es_query_cxt);
+	initialize_ordered_sort(pertrans, setno);
+	MemoryContextSwitchTo(oldContext);
+	sortstate = pertrans->sortstates[setno];
+
+	InitTupleHashIterator(dh->hashtable, &iter);
+	while ((entry = ScanTupleHashTable(dh->hashtable, &iter)) != NULL)
+	{
+		ExecStoreMinimalTuple(entry->firstTuple, slot, false);
+
+		if (pertrans->numInputs == 1)
+		{
+			Datum		value;
+			bool		isnull;
+
+			value = slot_getattr(slot, 1, &isnull);
+			tuplesort_putdatum(sortstate, value, isnull);
+		}
+		else
+			tuplesort_puttupleslot(sortstate, slot);
+	}
+	TermTupleHashIterator(&iter);
+	ExecClearTuple(slot);
+
+	ResetTupleHashTable(dh->hashtable);
+	MemoryContextReset(dh->tablecxt);
+	dh->spaceUsed = 0;
+	dh->spilled = true;
+}
+
+/*
+ * Run the transition function for a hashed DISTINCT aggregate that doesn't
+ * care about the order of its input, directly on the hashtable's entries.
+ *
+ * This function handles only one grouping set (already set in
+ * aggstate->current_set).
+ */
+static void
+process_hashed_distinct_aggregate(AggState *aggstate,
+								  AggStatePerTrans pertrans,
+								  AggStatePerGroup pergroupstate)
+{
+	AggDistinctHashData *dh = &pertrans->distincthashes[aggstate->current_set];
+	ExprContext *tmpcontext = aggstate->tmpcontext;
+	FunctionCallInfo fcinfo = &pertrans->transfn_fcinfo;
+	TupleTableSlot *slot = pertrans->distinctslot;
+	int			numTransInputs = pertrans->numTransInputs;
+	TupleHashIterator iter;
+	TupleHashEntryData *entry;
+	int			i;
+
+	Assert(!dh->spilled);
+
+	InitTupleHashIterator(dh->hashtable, &iter);
+	while ((entry = ScanTupleHashTable(dh->hashtable, &iter)) != NULL)
+	{
+		CHECK_FOR_INTERRUPTS();
+
+		ExecStoreMinimalTuple(entry->firstTuple, slot, false);
+		slot_getsomeattrs(slot, numTransInputs);
+
+		/* Start from 1, since the 0th arg will be the transition value */
+		for (i = 0; i < numTransInputs; i++)
+		{
+			fcinfo->arg[i + 1] = slot->tts_values[i];
+			fcinfo->argnull[i + 1] = slot->tts_isnull[i];
+		}
+
+		advance_transition_function(aggstate, pertrans, pergroupstate);
+
+		/* Reset context each time */
+		ResetExprContext(tmpcontext);
+	}
+	TermTupleHashIterator(&iter);
+	ExecClearTuple(slot);
+
+	ResetTupleHashTable(dh->hashtable);
+	MemoryContextReset(dh->tablecxt);
+	dh->spaceUsed = 0;
+}
+
 /*
  * Run the transition function for a DISTINCT or ORDER BY aggregate
  * with only one input.  This is called after we have completed
@@ -1143,6 +1390,23 @@ finalize_aggregates(AggState *aggstate,
 			Assert(aggstate->aggstrategy != AGG_HASHED &&
 				   aggstate->aggstrategy != AGG_MIXED);
 
+			/*
+			 * If the distinct values are still in the hashtable, either feed
+			 * them to the transfn directly, or sort them if order matters.
+			 */
+			if (pertrans->hashDistinct &&
+				!pertrans->distincthashes[aggstate->current_set].spilled)
+			{
+				if (pertrans->distinctUnordered)
+				{
+					process_hashed_distinct_aggregate(aggstate,
+													  pertrans,
+													  pergroupstate);
+					continue;
+				}
+				spill_distinct_hash(aggstate, pertrans, aggstate->current_set);
+			}
+
 			if (pertrans->numInputs == 1)
 				process_ordered_aggregate_single(aggstate,
 												 pertrans,
@@ -1259,38 +1523,56 @@ find_unaggregated_cols_walker(Node *node, Bitmapset **colnos)
  * The hash tables always live in the hashcontext's per-tuple memory context
  * (there is only one of these for all tables together, since they are all
  * reset at the same time).
+ *
+ * If the table may spill, there's no point in making it bigger than the
+ * number of groups we'll keep in memory.
  */
 static void
 build_hash_table(AggState *aggstate)
 {
-	MemoryContext tmpmem = aggstate->tmpcontext->ecxt_per_tuple_memory;
-	Size		additionalsize;
 	int			i;
 
 	Assert(aggstate->aggstrategy == AGG_HASHED || aggstate->aggstrategy == AGG_MIXED);
 
-	additionalsize = aggstate->numtrans * sizeof(AggStatePerGroupData);
-
 	for (i = 0; i < aggstate->num_hashes; ++i)
 	{
 		AggStatePerHash perhash = &aggstate->perhash[i];
+		long		nbuckets = perhash->aggnode->numGroups;
 
 		Assert(perhash->aggnode->numGroups > 0);
 
-		perhash->hashtable = BuildTupleHashTable(&aggstate->ss.ps,
-												 perhash->hashslot->tts_tupleDescriptor,
-												 perhash->numCols,
-												 perhash->hashGrpColIdxHash,
-												 perhash->eqfuncoids,
-												 perhash->hashfunctions,
-												 perhash->aggnode->numGroups,
-												 additionalsize,
-												 aggstate->hashcontext->ecxt_per_tuple_memory,
-												 tmpmem,
-												 DO_AGGSPLIT_SKIPFINAL(aggstate->aggsplit));
+		if (aggstate->hash_can_spill)
+			nbuckets = Min(nbuckets, aggstate->hash_ngroups_limit);
+
+		build_hash_table_set(aggstate, i, nbuckets);
 	}
 }
 
+/*
+ * Build the hash table of a single grouping set.
+ */
+static void
+build_hash_table_set(AggState *aggstate, int setno, long nbuckets)
+{
+	AggStatePerHash perhash = &aggstate->perhash[setno];
+	MemoryContext tmpmem = aggstate->tmpcontext->ecxt_per_tuple_memory;
+	Size		additionalsize;
+
+	additionalsize = aggstate->numtrans * sizeof(AggStatePerGroupData);
+
+	perhash->hashtable = BuildTupleHashTable(&aggstate->ss.ps,
+											 perhash->hashslot->tts_tupleDescriptor,
+											 perhash->numCols,
+											 perhash->hashGrpColIdxHash,
+											 perhash->eqfuncoids,
+											 perhash->hashfunctions,
+											 nbuckets,
+											 additionalsize,
+											 aggstate->hashcontext->ecxt_per_tuple_memory,
+											 tmpmem,
+											 DO_AGGSPLIT_SKIPFINAL(aggstate->aggsplit));
+}
+
 /*
  * Compute columns that actually need to be stored in hashtable entries.  The
  * incoming tuples from the child plan node will contain grouping columns,
@@ -1434,12 +1716,82 @@ hash_agg_entry_size(int numAggs)
 	return entrysize;
 }
 
+/*
+ * Work out how many groups the hash table may hold before we start spilling.
+ *
+ * This uses the same per-group estimate as the planner's choice of hashed
+ * aggregation: the table entry, the representative tuple, and the space
+ * taken by the transition values.
+ */
+static void
+hash_agg_set_limits(AggState *aggstate)
+{
+	Plan	   *outerPlan = outerPlan(aggstate->ss.ps.plan);
+	Size		entrysize;
+
+	entrysize = hash_agg_entry_size(aggstate->numtrans) +
+		MAXALIGN(SizeofMinimalTupleHeader) +
+		MAXALIGN(outerPlan->plan_width) +
+		aggstate->hash_trans_space;
+
+	aggstate->hash_ngroups_limit = Max((work_mem * 1024L) / entrysize, 1);
+}
+
+/*
+ * Estimate the per-group memory taken by the transition value of an
+ * aggregate, beyond the AggStatePerGroupData itself.  This must match
+ * get_agg_clause_costs_walker().
+ */
+static Size
+hash_agg_trans_space(Aggref *aggref, Form_pg_aggregate aggform)
+{
+	Oid			aggtranstype = aggref->aggtranstype;
+
+	if (!get_typbyval(aggtranstype))
+	{
+		int32		avgwidth;
+
+		if (aggform->aggtransspace > 0)
+			avgwidth = aggform->aggtransspace;
+		else if (aggform->aggtransfn == F_ARRAY_APPEND)
+			avgwidth = ALLOCSET_SMALL_INITSIZE;
+		else
+		{
+			int32		aggtranstypmod = -1;
+
+			if (aggref->args)
+			{
+				TargetEntry *tle = (TargetEntry *) linitial(aggref->args);
+
+				if (aggtranstype == exprType((Node *) tle->expr))
+					aggtranstypmod = exprTypmod((Node *) tle->expr);
+			}
+
+			avgwidth = get_typavgwidth(aggtranstype, aggtranstypmod);
+		}
+
+		return MAXALIGN(avgwidth) + 2 * sizeof(void *);
+	}
+	else if (aggtranstype == INTERNALOID)
+	{
+		if (aggform->aggtransspace > 0)
+			return aggform->aggtransspace;
+		else
+			return ALLOCSET_DEFAULT_INITSIZE;
+	}
+
+	return 0;
+}
+
 /*
  * Find or create a hashtable entry for the tuple group containing the current
  * tuple (already set in tmpcontext's outertuple slot), in the current grouping
  * set (which the caller must have selected - note that initialize_aggregate
  * depends on this).
  *
+ * If the hash table is full, no new entry is created: the tuple is spilled
+ * to disk instead, and NULL is returned.
+ *
  * When called, CurrentMemoryContext should be the per-query context.
  */
 static TupleHashEntryData *
@@ -1465,6 +1817,26 @@ lookup_hash_entry(AggState *aggstate)
 	}
 	ExecStoreVirtualTuple(hashslot);
 
+	/* once the table is full, only tuples of existing groups are absorbed */
+	if (aggstate->hash_spill_mode)
+	{
+		entry = LookupTupleHashEntry(perhash->hashtable, hashslot, NULL);
+		if (entry == NULL)
+		{
+			double		ngroups_est;
+
+			/* groups expected in this batch, or in this set's whole input */
+			if (aggstate->hash_batches_used > 0)
+				ngroups_est = aggstate->hash_ngroups_est;
+			else
+				ngroups_est = perhash->aggnode->numGroups;
+
+			hash_spill_tuple(aggstate, aggstate->current_set, ngroups_est,
+							 inputslot);
+		}
+		return entry;
+	}
+
 	/* find or create the hashtable entry using the filtered tuple */
 	entry = LookupTupleHashEntry(perhash->hashtable, hashslot, &isnew);
 
@@ -1489,6 +1861,15 @@ lookup_hash_entry(AggState *aggstate)
 
 			initialize_aggregate(aggstate, pertrans, pergroupstate);
 		}
+
+		/*
+		 * Stop creating groups once the tables are as big as we can afford,
+		 * unless we've run out of hash bits to partition by.
+		 */
+		if (aggstate->hash_can_spill &&
+			++aggstate->hash_ngroups_current >= aggstate->hash_ngroups_limit &&
+			aggstate->hash_used_bits < 32)
+			aggstate->hash_spill_mode = true;
 	}
 
 	return entry;
@@ -1498,20 +1879,247 @@ lookup_hash_entry(AggState *aggstate)
  * Look up hash entries for the current tuple in all hashed grouping sets,
  * returning an array of pergroup pointers suitable for advance_aggregates.
  *
+ * The pergroup pointer of a grouping set is set to NULL if the tuple was
+ * spilled to disk for it instead; the transition expression skips such sets.
+ * Returns false if that happened for all of them, in which case the caller
+ * needn't advance the aggregates at all (unless there are sorted grouping
+ * sets to advance, too).
+ *
  * Be aware that lookup_hash_entry can reset the tmpcontext.
  */
-static void
+static bool
 lookup_hash_entries(AggState *aggstate)
 {
 	int			numHashes = aggstate->num_hashes;
 	AggStatePerGroup *pergroup = aggstate->hash_pergroup;
+	bool		any_found = false;
 	int			setno;
 
 	for (setno = 0; setno < numHashes; setno++)
 	{
+		TupleHashEntryData *entry;
+
 		select_current_set(aggstate, setno, true);
-		pergroup[setno] = lookup_hash_entry(aggstate)->additional;
+		entry = lookup_hash_entry(aggstate);
+		if (entry == NULL)
+		{
+			pergroup[setno] = NULL;
+			continue;
+		}
+		pergroup[setno] = entry->additional;
+		any_found = true;
+	}
+
+	return any_found;
+}
+
+/*
+ * Write the current input tuple, whose group isn't in the hash table of the
+ * given grouping set, to the partition of that set's current spill its hash
+ * value belongs to.  The spill is started if this is the first such tuple;
+ * ngroups_est is the number of groups expected in the input being read.
+ *
+ * The caller must already have stored the tuple's grouping columns in the
+ * set's hashslot, as the partition is chosen by the same hash value the
+ * hash table uses.
+ */
+static void
+hash_spill_tuple(AggState *aggstate, int setno, double ngroups_est,
+				 TupleTableSlot *inputslot)
+{
+	AggStatePerHash perhash = &aggstate->perhash[setno];
+	HashAggSpill *spill = aggstate->hash_spills[setno];
+	uint32		hash;
+	int			partition;
+	MinimalTuple tuple;
+	bool		shouldFree;
+
+	if (spill == NULL)
+	{
+		double		npartitions;
+		long		max_partitions;
+		int			partition_bits;
+
+		/*
+		 * Choose the number of partitions from the number of groups we expect
+		 * that don't fit, rounded up to a power of 2.
+		 */
+		npartitions = ceil((ngroups_est -
+							aggstate->hash_ngroups_limit) *
+						   HASHAGG_PARTITION_FACTOR /
+						   aggstate->hash_ngroups_limit);
+		npartitions = Max(npartitions, HASHAGG_MIN_PARTITIONS);
+		npartitions = Min(npartitions, HASHAGG_MAX_PARTITIONS);
+		partition_bits = my_log2((long) npartitions);
+
+		/* but don't let the tapes' buffers eat up work_mem */
+		max_partitions = (work_mem * 1024L) / 4 / HASHAGG_WRITE_BUFFER_SIZE;
+		while (partition_bits > 1 && (1L << partition_bits) > max_partitions)
+			partition_bits--;
+		partition_bits = Min(partition_bits, 32 - aggstate->hash_used_bits);
+
+		spill = (HashAggSpill *) palloc(sizeof(HashAggSpill));
+		spill->partition_bits = partition_bits;
+		spill->npartitions = 1 << partition_bits;
+		spill->ntuples = (int64 *) palloc0(sizeof(int64) * spill->npartitions);
+		spill->tapeset = (HashAggTapeSet *) palloc(sizeof(HashAggTapeSet));
+
+		/*
+		 * The partitions are written to in no particular order, which would
+		 * defeat the chunking of compressed tapes, so don't compress them.
+		 */
+		spill->tapeset->lts = LogicalTapeSetCreate(spill->npartitions,
+												   NULL, NULL, -1,
+												   TAPE_COMPRESSION_NONE);
+		spill->tapeset->nbatches = 0;
+		aggstate->hash_spills[setno] = spill;
 	}
+
+	hash = TupleHashTableHashSlot(perhash->hashtable, perhash->hashslot);
+	partition = (hash << aggstate->hash_used_bits) >>
+		(32 - spill->partition_bits);
+
+	tuple = ExecFetchSlotMinimalTuple(inputslot, &shouldFree);
+	LogicalTapeWrite(spill->tapeset->lts, partition,
+					 (void *) tuple, tuple->t_len);
+	spill->ntuples[partition]++;
+
+	if (shouldFree)
+		pfree(tuple);
+}
+
+/*
+ * Done writing the current spills: turn their non-empty partitions into
+ * batches to be processed later.
+ */
+static void
+hash_spill_finish(AggState *aggstate)
+{
+	int			setno;
+
+	if (!aggstate->hash_can_spill)
+		return;
+
+	for (setno = 0; setno < aggstate->num_hashes; setno++)
+	{
+		HashAggSpill *spill = aggstate->hash_spills[setno];
+		int			i;
+
+		if (spill == NULL)
+			continue;
+
+		for (i = 0; i < spill->npartitions; i++)
+		{
+			HashAggBatch *batch;
+
+			if (spill->ntuples[i] == 0)
+				continue;
+
+			LogicalTapeRewindForRead(spill->tapeset->lts, i,
+									 HASHAGG_READ_BUFFER_SIZE);
+
+			batch = (HashAggBatch *) palloc(sizeof(HashAggBatch));
+			batch->setno = setno;
+			batch->tapeset = spill->tapeset;
+			batch->tapenum = i;
+			batch->used_bits = aggstate->hash_used_bits + spill->partition_bits;
+			batch->ntuples = spill->ntuples[i];
+			spill->tapeset->nbatches++;
+
+			aggstate->hash_batches = lappend(aggstate->hash_batches, batch);
+		}
+
+		/* can't happen, as every spill writes at least one tuple */
+		Assert(spill->tapeset->nbatches > 0);
+
+		pfree(spill->ntuples);
+		pfree(spill);
+		aggstate->hash_spills[setno] = NULL;
+	}
+}
+
+/*
+ * Read the next tuple of a batch into hash_spill_slot; returns NULL at the
+ * end of the batch.
+ */
+static TupleTableSlot *
+hash_batch_read_tuple(AggState *aggstate, HashAggBatch *batch)
+{
+	LogicalTapeSet *lts = batch->tapeset->lts;
+	uint32		t_len;
+	MinimalTuple tuple;
+	size_t		nread;
+
+	nread = LogicalTapeRead(lts, batch->tapenum, &t_len, sizeof(t_len));
+	if (nread == 0)
+		return NULL;
+	if (nread != sizeof(t_len))
+		elog(ERROR, "unexpected end of data");
+
+	tuple = (MinimalTuple) palloc(t_len);
+	tuple->t_len = t_len;
+	nread = LogicalTapeRead(lts, batch->tapenum,
+							(char *) tuple + sizeof(t_len),
+							t_len - sizeof(t_len));
+	if (nread != t_len - sizeof(t_len))
+		elog(ERROR, "unexpected end of data");
+
+	return ExecStoreMinimalTuple(tuple, aggstate->hash_spill_slot, true);
+}
+
+/*
+ * A batch reading from the given tape set is done.  Close the tape set,
+ * freeing its disk space, if that was the last one.
+ */
+static void
+hash_tapeset_release(AggState *aggstate, HashAggTapeSet *tapeset)
+{
+	Assert(tapeset->nbatches > 0);
+
+	if (--tapeset->nbatches > 0)
+		return;
+
+	aggstate->hash_disk_used +=
+		LogicalTapeSetBlocks(tapeset->lts) * (BLCKSZ / 1024);
+	LogicalTapeSetClose(tapeset->lts);
+	pfree(tapeset);
+}
+
+/*
+ * Throw away any spilled data, e.g. when rescanning.
+ */
+static void
+hash_agg_reset_spill(AggState *aggstate)
+{
+	ListCell   *lc;
+	int			setno;
+
+	for (setno = 0; setno < aggstate->num_hashes; setno++)
+	{
+		HashAggSpill *spill = aggstate->hash_spills[setno];
+
+		if (spill == NULL)
+			continue;
+
+		LogicalTapeSetClose(spill->tapeset->lts);
+		pfree(spill->tapeset);
+		pfree(spill->ntuples);
+		pfree(spill);
+		aggstate->hash_spills[setno] = NULL;
+	}
+
+	foreach(lc, aggstate->hash_batches)
+	{
+		HashAggBatch *batch = (HashAggBatch *) lfirst(lc);
+
+		hash_tapeset_release(aggstate, batch->tapeset);
+		pfree(batch);
+	}
+	list_free(aggstate->hash_batches);
+	aggstate->hash_batches = NIL;
+
+	if (aggstate->hash_spill_slot)
+		ExecClearTuple(aggstate->hash_spill_slot);
 }
 
 /*
@@ -1665,6 +2273,8 @@ agg_retrieve_direct(AggState *aggstate)
 				 */
 				initialize_phase(aggstate, 0);
 				aggstate->table_filled = true;
+				/* groups that didn't fit are processed after these */
+				hash_spill_finish(aggstate);
 				ResetTupleHashIterator(aggstate->perhash[0].hashtable,
 									   &aggstate->perhash[0].hashiter);
 				select_current_set(aggstate, 0, true);
@@ -1922,11 +2532,12 @@ agg_fill_hash_table(AggState *aggstate)
 		/* set up for lookup_hash_entries and advance_aggregates */
 		tmpcontext->ecxt_outertuple = outerslot;
 
-		/* Find or build hashtable entries */
-		lookup_hash_entries(aggstate);
-
-		/* Advance the aggregates (or combine functions) */
-		advance_aggregates(aggstate);
+		/* Find or build hashtable entries, unless the tuple was spilled */
+		if (lookup_hash_entries(aggstate))
+		{
+			/* Advance the aggregates (or combine functions) */
+			advance_aggregates(aggstate);
+		}
 
 		/*
 		 * Reset per-input-tuple context after each tuple, but note that the
@@ -1935,6 +2546,9 @@ agg_fill_hash_table(AggState *aggstate)
 		ResetExprContext(aggstate->tmpcontext);
 	}
 
+	/* the rest of the input is on disk now, if it didn't all fit */
+	hash_spill_finish(aggstate);
+
 	aggstate->table_filled = true;
 	/* Initialize to walk the first hash table */
 	select_current_set(aggstate, 0, true);
@@ -1942,6 +2556,85 @@ agg_fill_hash_table(AggState *aggstate)
 						   &aggstate->perhash[0].hashiter);
 }
 
+/*
+ * ExecAgg for hashed case: after the groups in the hash table have all been
+ * returned, start over with an empty table and fill it from the next batch of
+ * spilled tuples.  Returns false if there are no batches left.
+ */
+static bool
+agg_refill_hash_table(AggState *aggstate)
+{
+	ExprContext *tmpcontext = aggstate->tmpcontext;
+	AggStatePerGroup *pergroup = aggstate->hash_pergroup;
+	HashAggBatch *batch;
+	TupleTableSlot *slot;
+	int			setno;
+
+	if (aggstate->hash_batches == NIL)
+		return false;
+
+	batch = (HashAggBatch *) linitial(aggstate->hash_batches);
+	aggstate->hash_batches = list_delete_first(aggstate->hash_batches);
+
+	/*
+	 * Release the groups of the previous batch.  The groups we returned last
+	 * are no longer referenced once we've been called for another tuple.
+	 * Only the batch's own grouping set gets a hash table again; the others
+	 * are neither filled nor scanned anymore.
+	 */
+	ReScanExprContext(aggstate->hashcontext);
+	for (setno = 0; setno < aggstate->num_hashes; setno++)
+		aggstate->perhash[setno].hashtable = NULL;
+	build_hash_table_set(aggstate, batch->setno,
+						 Max(Min(batch->ntuples, aggstate->hash_ngroups_limit), 1));
+
+	aggstate->hash_spill_mode = false;
+	aggstate->hash_ngroups_current = 0;
+	aggstate->hash_ngroups_est = batch->ntuples;
+	aggstate->hash_used_bits = batch->used_bits;
+	aggstate->hash_batches_used++;
+
+	/* the transitions of the other grouping sets are skipped */
+	for (setno = 0; setno < aggstate->num_hashes; setno++)
+		pergroup[setno] = NULL;
+	select_current_set(aggstate, batch->setno, true);
+
+	for (;;)
+	{
+		TupleHashEntryData *entry;
+
+		CHECK_FOR_INTERRUPTS();
+
+		slot = hash_batch_read_tuple(aggstate, batch);
+		if (slot == NULL)
+			break;
+
+		/* set up for lookup_hash_entry and advance_aggregates */
+		tmpcontext->ecxt_outertuple = slot;
+
+		/* a batch that doesn't fit either is partitioned further */
+		entry = lookup_hash_entry(aggstate);
+		if (entry != NULL)
+		{
+			pergroup[batch->setno] = entry->additional;
+			advance_aggregates(aggstate);
+		}
+
+		ResetExprContext(aggstate->tmpcontext);
+	}
+
+	hash_tapeset_release(aggstate, batch->tapeset);
+
+	hash_spill_finish(aggstate);
+
+	select_current_set(aggstate, batch->setno, true);
+	ResetTupleHashIterator(aggstate->perhash[batch->setno].hashtable,
+						   &aggstate->perhash[batch->setno].hashiter);
+	pfree(batch);
+
+	return true;
+}
+
 /*
  * ExecAgg for hashed case: retrieving groups from hash table
  */
@@ -1990,7 +2683,9 @@ agg_retrieve_hash_table(AggState *aggstate)
 		{
 			int			nextset = aggstate->current_set + 1;
 
-			if (nextset < aggstate->num_hashes)
+			/* once processing batches, only one of them is filled at a time */
+			if (nextset < aggstate->num_hashes &&
+				aggstate->hash_batches_used == 0)
 			{
 				/*
 				 * Switch to next grouping set, reinitialize, and restart the
@@ -2004,6 +2699,13 @@ agg_retrieve_hash_table(AggState *aggstate)
 
 				continue;
 			}
+			else if (agg_refill_hash_table(aggstate))
+			{
+				/* go on with the groups of a spilled batch */
+				perhash = &aggstate->perhash[aggstate->current_set];
+
+				continue;
+			}
 			else
 			{
 				/* No more hashtables, so done */
@@ -2163,6 +2865,16 @@ ExecInitAgg(Agg *node, EState *estate, int eflags)
 	aggstate->maxsets = numGroupingSets;
 	aggstate->numphases = numPhases;
 
+	/*
+	 * Hashed aggregation may spill to disk, separately for each hashed
+	 * grouping set; see the file header comments.
+	 */
+	aggstate->hash_can_spill = (node->aggstrategy == AGG_HASHED ||
+								node->aggstrategy == AGG_MIXED);
+	if (aggstate->hash_can_spill)
+		aggstate->hash_spills = (HashAggSpill **)
+			palloc0(sizeof(HashAggSpill *) * numHashes);
+
 	aggstate->aggcontexts = (ExprContext **)
 		palloc0(sizeof(ExprContext *) * numGroupingSets);
 
@@ -2218,6 +2930,18 @@ ExecInitAgg(Agg *node, EState *estate, int eflags)
 		aggstate->sort_slot = ExecInitExtraTupleSlot(estate, scanDesc,
 													 &TTSOpsMinimalTuple);
 
+	/*
+	 * Spilled tuples are read back into a minimal tuple slot, so input
+	 * tuples may then come from either that or the outer plan's slot.
+	 */
+	if (aggstate->hash_can_spill)
+	{
+		aggstate->hash_spill_slot = ExecInitExtraTupleSlot(estate, scanDesc,
+														   &TTSOpsMinimalTuple);
+		aggstate->ss.ps.outeropsset = true;
+		aggstate->ss.ps.outeropsfixed = false;
+	}
+
 	/*
 	 * Initialize result type, slot and projection.
 	 */
@@ -2445,7 +3169,6 @@ ExecInitAgg(Agg *node, EState *estate, int eflags)
 		aggstate->hash_pergroup = pergroups;
 
 		find_hash_columns(aggstate);
-		build_hash_table(aggstate);
 		aggstate->table_filled = false;
 	}
 
@@ -2776,6 +3499,19 @@ ExecInitAgg(Agg *node, EState *estate, int eflags)
 									  initValue, initValueIsNull,
 									  inputTypes, numArguments);
 			peragg->transno = transno;
+
+			/*
+			 * Aggregates with a combine function already see their input
+			 * in arbitrary order under parallel aggregation, so the order
+			 * in which hashed DISTINCT values arrive can't matter either.
+			 */
+			pertrans->distinctUnordered = pertrans->hashDistinct &&
+				aggref->aggorder == NIL &&
+				OidIsValid(aggform->aggcombinefn);
+
+			if (aggstate->hash_can_spill)
+				aggstate->hash_trans_space +=
+					hash_agg_trans_space(aggref, aggform);
 		}
 		ReleaseSysCache(aggTuple);
 	}
@@ -2787,6 +3523,20 @@ ExecInitAgg(Agg *node, EState *estate, int eflags)
 	aggstate->numaggs = aggno + 1;
 	aggstate->numtrans = transno + 1;
 
+	/*
+	 * Now that we know the transition states, build the hash tables, sized
+	 * no larger than what may be kept in memory if we can spill.
+	 */
+	if (use_hashing)
+	{
+		if (aggstate->hash_can_spill)
+		{
+			hash_agg_set_limits(aggstate);
+			aggstate->hash_ngroups_est = node->numGroups;
+		}
+		build_hash_table(aggstate);
+	}
+
 	/*
 	 * Last, check whether any more aggregates got added onto the node while
 	 * we processed the expressions for the aggregate arguments (including not
@@ -2814,6 +3564,7 @@ ExecInitAgg(Agg *node, EState *estate, int eflags)
 		AggStatePerPhase phase = &aggstate->phases[phaseidx];
 		bool		dohash = false;
 		bool		dosort = false;
+		bool		nullcheck;
 
 		/* phase 0 doesn't necessarily exist */
 		if (!phase->aggnode)
@@ -2831,11 +3582,14 @@ ExecInitAgg(Agg *node, EState *estate, int eflags)
 		else if (aggstate->aggstrategy == AGG_MIXED && phaseidx == 0)
 		{
 			/*
-			 * No need to compute a transition function for an AGG_MIXED phase
-			 * 0 - the contents of the hashtables will have been computed
-			 * during phase 1.
+			 * The contents of the hashtables of an AGG_MIXED phase 0 are
+			 * computed during phase 1, but if groups were spilled, phase 0
+			 * will need to aggregate the spilled batches.
 			 */
-			continue;
+			if (!aggstate->hash_can_spill)
+				continue;
+			dohash = true;
+			dosort = false;
 		}
 		else if (phase->aggstrategy == AGG_PLAIN ||
 				 phase->aggstrategy == AGG_SORTED)
@@ -2851,7 +3605,16 @@ ExecInitAgg(Agg *node, EState *estate, int eflags)
 		else
 			Assert(false);
 
-		phase->evaltrans = ExecBuildAggTrans(aggstate, phase, dosort, dohash);
+		/*
+		 * Hashed grouping sets whose tuple got spilled have to be skipped,
+		 * unless that's the only thing to advance and the whole transition
+		 * can be skipped instead.
+		 */
+		nullcheck = dohash && aggstate->hash_can_spill &&
+			(numHashes > 1 || aggstate->aggstrategy == AGG_MIXED);
+
+		phase->evaltrans = ExecBuildAggTrans(aggstate, phase, dosort, dohash,
+											 nullcheck);
 
 	}
 
@@ -3142,6 +3905,54 @@ build_pertrans_for_aggref(AggStatePerTrans pertrans,
 									   pertrans->sortColIdx,
 									   ops,
 									   &aggstate->ss.ps);
+
+		/*
+		 * If all the DISTINCT columns are hashable, deduplicate the input
+		 * in per-grouping-set hashtables before it reaches the sort.
+		 */
+		pertrans->hashDistinct = true;
+		foreach(lc, aggref->aggdistinct)
+		{
+			if (!((SortGroupClause *) lfirst(lc))->hashable)
+				pertrans->hashDistinct = false;
+		}
+
+		if (pertrans->hashDistinct)
+		{
+			Oid		   *eqfuncoids;
+			FmgrInfo   *hashfunctions;
+			int			setno;
+
+			execTuplesHashPrepare(numDistinctCols, ops,
+								  &eqfuncoids, &hashfunctions);
+
+			pertrans->distinctslot =
+				ExecInitExtraTupleSlot(estate, pertrans->sortdesc,
+									   &TTSOpsMinimalTuple);
+			pertrans->distincthashes = (AggDistinctHashData *)
+				palloc0(sizeof(AggDistinctHashData) * numGroupingSets);
+
+			for (setno = 0; setno < numGroupingSets; setno++)
+			{
+				AggDistinctHashData *dh = &pertrans->distincthashes[setno];
+
+				dh->tablecxt = AllocSetContextCreate(CurrentMemoryContext,
+													 "AggDistinctHash",
+													 ALLOCSET_DEFAULT_SIZES);
+				dh->hashtable =
+					BuildTupleHashTableExt(&aggstate->ss.ps,
+										   pertrans->sortdesc,
+										   numDistinctCols,
+										   pertrans->sortColIdx,
+										   eqfuncoids,
+										   hashfunctions,
+										   256, 0,
+										   CurrentMemoryContext,
+										   dh->tablecxt,
+										   aggstate->tmpcontext->ecxt_per_tuple_memory,
+										   false);
+			}
+		}
 		pfree(ops);
 	}
 
@@ -3339,6 +4150,10 @@ ExecEndAgg(AggState *node)
 	if (node->hashcontext)
 		ReScanExprContext(node->hashcontext);
 
+	/* And the tape sets of any spilled groups */
+	if (node->hash_can_spill)
+		hash_agg_reset_spill(node);
+
 	/*
 	 * We don't actually free any ExprContexts here (see comment in
 	 * ExecFreeExprContext), just unlinking the output one from the plan node
@@ -3380,10 +4195,12 @@ ExecReScanAgg(AggState *node)
 		 * If we do have the hash table, and the subplan does not have any
 		 * parameter changes, and none of our own parameter changes affect
 		 * input expressions of the aggregated functions, then we can just
-		 * rescan the existing hash table; no need to build it again.
+		 * rescan the existing hash table; no need to build it again.  That's
+		 * not possible if some groups were spilled to disk, though.
 		 */
 		if (outerPlan->chgParam == NULL &&
-			!bms_overlap(node->ss.ps.chgParam, aggnode->aggParams))
+			!bms_overlap(node->ss.ps.chgParam, aggnode->aggParams) &&
+			node->hash_batches == NIL && node->hash_batches_used == 0)
 		{
 			ResetTupleHashIterator(node->perhash[0].hashtable,
 								   &node->perhash[0].hashiter);
@@ -3440,6 +4257,17 @@ ExecReScanAgg(AggState *node)
 	if (node->aggstrategy == AGG_HASHED || node->aggstrategy == AGG_MIXED)
 	{
 		ReScanExprContext(node->hashcontext);
+		/* Forget about spilled groups */
+		if (node->hash_can_spill)
+		{
+			hash_agg_reset_spill(node);
+			node->hash_spill_mode = false;
+			node->hash_ngroups_current = 0;
+			node->hash_ngroups_est = aggnode->numGroups;
+			node->hash_used_bits = 0;
+			node->hash_batches_used = 0;
+			node->hash_disk_used = 0;
+		}
 		/* Rebuild an empty hash table */
 		build_hash_table(node);
 		node->table_filled = false;
@@ -25,6 +25,13 @@
  *		until the subplan stops returning tuples, at which point that
  *		plan is shut down and the next started up.
  *
+ *		When some subplans are foreign scans whose FDW can run them
+ *		asynchronously, the Append instead starts all of those at once,
+ *		and returns tuples from whichever subplan has some ready, so that
+ *		the remote servers work concurrently rather than one at a time.
+ *		The order of the tuples an Append returns isn't promised to
+ *		anyone, so this is invisible except in timing.
+ *
  *		Append nodes don't make use of their left and right
  *		subtrees, rather they maintain a list of subplans so
  *		a typical append node looks like this in the plan tree:
@@ -60,7 +67,11 @@
 #include "executor/execdebug.h"
 #include "executor/execPartition.h"
 #include "executor/nodeAppend.h"
+#include "executor/nodeForeignscan.h"
 #include "miscadmin.h"
+#include "optimizer/cost.h"
+#include "pgstat.h"
+#include "storage/latch.h"
 
 /* Shared state for parallel-aware Append. */
 struct ParallelAppendState
@@ -81,7 +92,9 @@ struct ParallelAppendState
 #define NO_MATCHING_SUBPLANS		-2
 
 static TupleTableSlot *ExecAppend(PlanState *pstate);
+static TupleTableSlot *ExecAppendAsync(PlanState *pstate);
 static bool choose_next_subplan_locally(AppendState *node);
+static bool choose_next_subplan_async(AppendState *node);
 static bool choose_next_subplan_for_leader(AppendState *node);
 static bool choose_next_subplan_for_worker(AppendState *node);
 static void mark_invalid_subplans_as_finished(AppendState *node);
@@ -244,6 +257,33 @@ ExecInitAppend(Append *node, EState *estate, int eflags)
 	/* For parallel query, this will be overridden later. */
 	appendstate->choose_next_subplan = choose_next_subplan_locally;
 
+	/*
+	 * Find out which subplans can be run asynchronously.  That's only done
+	 * for forward-only scans outside parallel query and EvalPlanQual, which
+	 * have their own ideas about the order in which subplans are visited.
+	 */
+	appendstate->as_asyncplans = NULL;
+	appendstate->as_remaining = NULL;
+	appendstate->as_async_begun = false;
+	if (enable_async_append &&
+		!node->plan.parallel_aware &&
+		estate->es_epqTuple == NULL &&
+		!(eflags & (EXEC_FLAG_BACKWARD | EXEC_FLAG_EXPLAIN_ONLY)))
+	{
+		for (i = 0; i < nplans; i++)
+		{
+			PlanState  *subnode = appendplanstates[i];
+
+			if (IsA(subnode, ForeignScanState) &&
+				ExecForeignScanAsyncCapable((ForeignScanState *) subnode))
+				appendstate->as_asyncplans =
+					bms_add_member(appendstate->as_asyncplans, i);
+		}
+
+		if (appendstate->as_asyncplans != NULL)
+			appendstate->ps.ExecProcNode = ExecAppendAsync;
+	}
+
 	return appendstate;
 }
 
@@ -307,6 +347,87 @@ ExecAppend(PlanState *pstate)
 	}
 }
 
+/* ----------------------------------------------------------------
+ *	   ExecAppendAsync
+ *
+ *		ExecAppend variant used when some subplans are asynchronous.
+ *		Rather than draining the subplans in order, we switch away from
+ *		an asynchronous subplan as soon as it would have to wait for its
+ *		remote server, and continue with one that has tuples ready.
+ * ----------------------------------------------------------------
+ */
+static TupleTableSlot *
+ExecAppendAsync(PlanState *pstate)
+{
+	AppendState *node = castNode(AppendState, pstate);
+
+	/* Nothing to do if there are no matching subplans */
+	if (node->as_whichplan == NO_MATCHING_SUBPLANS)
+		return ExecClearTuple(node->ps.ps_ResultTupleSlot);
+
+	if (!node->as_async_begun)
+	{
+		int			i;
+
+		if (node->as_valid_subplans == NULL)
+			node->as_valid_subplans =
+				ExecFindMatchingSubPlans(node->as_prune_state);
+		bms_free(node->as_remaining);
+		node->as_remaining = bms_copy(node->as_valid_subplans);
+		node->as_whichplan = INVALID_SUBPLAN_INDEX;
+
+		/*
+		 * Send off the first request of every asynchronous subplan, so that
+		 * the remote servers all start working while we wait for the first
+		 * of them, or run the synchronous subplans.
+		 */
+		i = -1;
+		while ((i = bms_next_member(node->as_asyncplans, i)) >= 0)
+		{
+			if (bms_is_member(i, node->as_remaining))
+				(void) ExecForeignScanAsyncRequest((ForeignScanState *) node->appendplans[i]);
+		}
+		node->as_async_begun = true;
+	}
+
+	for (;;)
+	{
+		PlanState  *subnode;
+		TupleTableSlot *result;
+
+		CHECK_FOR_INTERRUPTS();
+
+		if (node->as_whichplan == INVALID_SUBPLAN_INDEX &&
+			!choose_next_subplan_async(node))
+			return ExecClearTuple(node->ps.ps_ResultTupleSlot);
+
+		Assert(node->as_whichplan >= 0 && node->as_whichplan < node->as_nplans);
+		subnode = node->appendplans[node->as_whichplan];
+
+		/*
+		 * If an asynchronous subplan has used up the tuples it had, it has
+		 * now sent off its next request; go find something else to do while
+		 * that is being answered.
+		 */
+		if (bms_is_member(node->as_whichplan, node->as_asyncplans) &&
+			ExecForeignScanAsyncRequest((ForeignScanState *) subnode) != PGINVALID_SOCKET)
+		{
+			node->as_whichplan = INVALID_SUBPLAN_INDEX;
+			continue;
+		}
+
+		result = ExecProcNode(subnode);
+
+		if (!TupIsNull(result))
+			return result;
+
+		/* This subplan is done; choose another */
+		node->as_remaining = bms_del_member(node->as_remaining,
+											node->as_whichplan);
+		node->as_whichplan = INVALID_SUBPLAN_INDEX;
+	}
+}
+
 /* ----------------------------------------------------------------
  *		ExecEndAppend
  *
@@ -374,6 +495,9 @@ ExecReScanAppend(AppendState *node)
 
 	/* Let choose_next_subplan_* function handle setting the first subplan */
 	node->as_whichplan = INVALID_SUBPLAN_INDEX;
+
+	/* Asynchronous subplans will be started afresh by ExecAppendAsync */
+	node->as_async_begun = false;
 }
 
 /* ----------------------------------------------------------------
@@ -499,6 +623,95 @@ choose_next_subplan_locally(AppendState *node)
 	return true;
 }
 
+/* ----------------------------------------------------------------
+ *		choose_next_subplan_async
+ *
+ *		Choose next subplan for an Append with asynchronous subplans,
+ *		returning false if there are no more.
+ *
+ *		Asynchronous subplans that have tuples ready come first, then the
+ *		synchronous ones, which we run while the remote servers work.  If
+ *		only asynchronous subplans that are still waiting for their remote
+ *		servers remain, sleep until one of them has an answer.
+ * ----------------------------------------------------------------
+ */
+static bool
+choose_next_subplan_async(AppendState *node)
+{
+	int			nremaining;
+	pgsocket   *socks;
+	WaitEvent  *events;
+
+	Assert(node->as_whichplan == INVALID_SUBPLAN_INDEX);
+
+	nremaining = bms_num_members(node->as_remaining);
+	if (nremaining == 0)
+		return false;
+
+	socks = (pgsocket *) palloc(nremaining * sizeof(pgsocket));
+	events = (WaitEvent *) palloc(nremaining * sizeof(WaitEvent));
+
+	for (;;)
+	{
+		WaitEventSet *set;
+		int			firstsync = -1;
+		int			nsocks = 0;
+		int			i;
+
+		i = -1;
+		while ((i = bms_next_member(node->as_remaining, i)) >= 0)
+		{
+			pgsocket	sock;
+
+			if (!bms_is_member(i, node->as_asyncplans))
+			{
+				if (firstsync < 0)
+					firstsync = i;
+				continue;
+			}
+
+			sock = ExecForeignScanAsyncRequest((ForeignScanState *) node->appendplans[i]);
+			if (sock == PGINVALID_SOCKET)
+			{
+				node->as_whichplan = i;
+				break;
+			}
+			socks[nsocks++] = sock;
+		}
+
+		if (node->as_whichplan == INVALID_SUBPLAN_INDEX && firstsync >= 0)
+			node->as_whichplan = firstsync;
+		if (node->as_whichplan != INVALID_SUBPLAN_INDEX)
+			break;
+
+		/*
+		 * Wait for any of the sockets to become readable.  Nothing between
+		 * creating and freeing the set can throw, so it can't be leaked.
+		 */
+		Assert(nsocks > 0);
+		set = CreateWaitEventSet(CurrentMemoryContext, nsocks + 2);
+		AddWaitEventToSet(set, WL_LATCH_SET, PGINVALID_SOCKET, MyLatch, NULL);
+		if (IsUnderPostmaster)
+			AddWaitEventToSet(set, WL_EXIT_ON_PM_DEATH, PGINVALID_SOCKET,
+							  NULL, NULL);
+		for (i = 0; i < nsocks; i++)
+			AddWaitEventToSet(set, WL_SOCKET_READABLE, socks[i], NULL, NULL);
+		(void) WaitEventSetWait(set, -1L, events, nremaining,
+								WAIT_EVENT_APPEND_READY);
+		FreeWaitEventSet(set);
+
+		ResetLatch(MyLatch);
+		CHECK_FOR_INTERRUPTS();
+
+		/* Loop back and ask the subplans again, which consumes the input */
+	}
+
+	pfree(socks);
+	pfree(events);
+
+	return true;
+}
+
 /* ----------------------------------------------------------------
  *		choose_next_subplan_for_leader
  *
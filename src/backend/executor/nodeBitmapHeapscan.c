@@ -91,7 +91,7 @@ BitmapHeapNext(BitmapHeapScanState *node)
 	 */
 	econtext = node->ss.ps.ps_ExprContext;
 	slot = node->ss.ss_ScanTupleSlot;
-	scan = node->ss.ss_currentScanDesc;
+	scan = (HeapScanDesc) node->ss.ss_currentScanDesc;
 	tbm = node->tbm;
 	if (pstate == NULL)
 		tbmiterator = node->tbmiterator;
@@ -331,10 +331,10 @@ BitmapHeapNext(BitmapHeapScanState *node)
 
 			scan->rs_ctup.t_data = (HeapTupleHeader) PageGetItem((Page) dp, lp);
 			scan->rs_ctup.t_len = ItemIdGetLength(lp);
-			scan->rs_ctup.t_tableOid = scan->rs_rd->rd_id;
+			scan->rs_ctup.t_tableOid = scan->rs_base.rs_rd->rd_id;
 			ItemPointerSet(&scan->rs_ctup.t_self, tbmres->blockno, targoffset);
 
-			pgstat_count_heap_fetch(scan->rs_rd);
+			pgstat_count_heap_fetch(scan->rs_base.rs_rd);
 
 			/*
 			 * Set up the result slot to point to this tuple.  Note that the
@@ -392,17 +392,17 @@ bitgetpage(HeapScanDesc scan, TBMIterateResult *tbmres)
 	Assert(page < scan->rs_nblocks);
 
 	scan->rs_cbuf = ReleaseAndReadBuffer(scan->rs_cbuf,
-										 scan->rs_rd,
+										 scan->rs_base.rs_rd,
 										 page);
 	buffer = scan->rs_cbuf;
-	snapshot = scan->rs_snapshot;
+	snapshot = scan->rs_base.rs_snapshot;
 
 	ntup = 0;
 
 	/*
 	 * Prune and repair fragmentation for the whole page, if possible.
 	 */
-	heap_page_prune_opt(scan->rs_rd, buffer);
+	heap_page_prune_opt(scan->rs_base.rs_rd, buffer);
 
 	/*
 	 * We must hold share lock on the buffer content while examining tuple
@@ -430,7 +430,7 @@ bitgetpage(HeapScanDesc scan, TBMIterateResult *tbmres)
 			HeapTupleData heapTuple;
 
 			ItemPointerSet(&tid, page, offnum);
-			if (heap_hot_search_buffer(&tid, scan->rs_rd, buffer, snapshot,
+			if (heap_hot_search_buffer(&tid, scan->rs_base.rs_rd, buffer, snapshot,
 									   &heapTuple, NULL, true))
 				scan->rs_vistuples[ntup++] = ItemPointerGetOffsetNumber(&tid);
 		}
@@ -456,15 +456,15 @@ bitgetpage(HeapScanDesc scan, TBMIterateResult *tbmres)
 				continue;
 			loctup.t_data = (HeapTupleHeader) PageGetItem((Page) dp, lp);
 			loctup.t_len = ItemIdGetLength(lp);
-			loctup.t_tableOid = scan->rs_rd->rd_id;
+			loctup.t_tableOid = scan->rs_base.rs_rd->rd_id;
 			ItemPointerSet(&loctup.t_self, page, offnum);
 			valid = HeapTupleSatisfiesVisibility(&loctup, snapshot, buffer);
 			if (valid)
 			{
 				scan->rs_vistuples[ntup++] = offnum;
-				PredicateLockTuple(scan->rs_rd, &loctup, snapshot);
+				PredicateLockTuple(scan->rs_base.rs_rd, &loctup, snapshot);
 			}
-			CheckForSerializableConflictOut(valid, scan->rs_rd, &loctup,
+			CheckForSerializableConflictOut(valid, scan->rs_base.rs_rd, &loctup,
 											buffer, snapshot);
 		}
 	}
@@ -594,20 +594,52 @@ BitmapAdjustPrefetchTarget(BitmapHeapScanState *node)
 #endif							/* USE_PREFETCH */
 }
 
+/*
+ * BitmapPrefetchBlock - Add a block to the run of blocks to be prefetched
+ *
+ * Bitmaps often have runs of consecutive heap blocks.  Rather than issuing a
+ * separate request for each, we accumulate a run in *runstart and *runlen,
+ * and hand it to PrefetchBufferRange() once the next block to prefetch
+ * doesn't extend it.  Caller must flush any remaining run at the end.
+ */
+static inline void
+BitmapPrefetchBlock(Relation rel, BlockNumber blockno,
+					BlockNumber *runstart, BlockNumber *runlen)
+{
+	if (*runlen > 0 && blockno == *runstart + *runlen)
+	{
+		(*runlen)++;
+		return;
+	}
+
+	if (*runlen > 0)
+		PrefetchBufferRange(rel, MAIN_FORKNUM, *runstart, *runlen);
+	*runstart = blockno;
+	*runlen = 1;
+}
+
 /*
  * BitmapPrefetch - Prefetch, if prefetch_pages are behind prefetch_target
+ *
+ * We wait until the prefetch iterator has fallen behind by half of
+ * prefetch_target before topping it up, so that requests are issued in
+ * batches that BitmapPrefetchBlock() can combine into runs.
  */
 static inline void
 BitmapPrefetch(BitmapHeapScanState *node, HeapScanDesc scan)
 {
 #ifdef USE_PREFETCH
 	ParallelBitmapHeapState *pstate = node->pstate;
+	Relation	rel = scan->rs_base.rs_rd;
+	BlockNumber runstart = InvalidBlockNumber;
+	BlockNumber runlen = 0;
 
 	if (pstate == NULL)
 	{
 		TBMIterator *prefetch_iterator = node->prefetch_iterator;
 
-		if (prefetch_iterator)
+		if (prefetch_iterator &&
+			node->prefetch_pages <= node->prefetch_target / 2)
 		{
 			while (node->prefetch_pages < node->prefetch_target)
 			{
@@ -641,40 +673,44 @@ BitmapPrefetch(BitmapHeapScanState *node, HeapScanDesc scan)
 											 &node->pvmbuffer));
 
 				if (!skip_fetch)
-					PrefetchBuffer(scan->rs_rd, MAIN_FORKNUM, tbmpre->blockno);
+					BitmapPrefetchBlock(rel, tbmpre->blockno,
+										&runstart, &runlen);
 			}
 		}
 
+		if (runlen > 0)
+			PrefetchBufferRange(rel, MAIN_FORKNUM, runstart, runlen);
 		return;
 	}
 
-	if (pstate->prefetch_pages < pstate->prefetch_target)
+	if (pstate->prefetch_pages <= pstate->prefetch_target / 2)
 	{
 		TBMSharedIterator *prefetch_iterator = node->shared_prefetch_iterator;
 
 		if (prefetch_iterator)
 		{
-			while (1)
+			int			nprefetch = 0;
+
+			/*
+			 * Recheck under the mutex. If some other process has already
+			 * done enough prefetching then we need not to do anything.
+			 * Otherwise, take on all of the prefetching still needed at
+			 * once.
+			 */
+			SpinLockAcquire(&pstate->mutex);
+			if (pstate->prefetch_pages <= pstate->prefetch_target / 2 &&
+				pstate->prefetch_pages < pstate->prefetch_target)
+			{
+				nprefetch = pstate->prefetch_target - pstate->prefetch_pages;
+				pstate->prefetch_pages += nprefetch;
+			}
+			SpinLockRelease(&pstate->mutex);
+
+			while (nprefetch-- > 0)
 			{
 				TBMIterateResult *tbmpre;
-				bool		do_prefetch = false;
 				bool		skip_fetch;
 
-				/*
-				 * Recheck under the mutex. If some other process has already
-				 * done enough prefetching then we need not to do anything.
-				 */
-				SpinLockAcquire(&pstate->mutex);
-				if (pstate->prefetch_pages < pstate->prefetch_target)
-				{
-					pstate->prefetch_pages++;
-					do_prefetch = true;
-				}
-				SpinLockRelease(&pstate->mutex);
-
-				if (!do_prefetch)
-					return;
-
 				tbmpre = tbm_shared_iterate(prefetch_iterator);
 				if (tbmpre == NULL)
 				{
@@ -692,8 +728,12 @@ BitmapPrefetch(BitmapHeapScanState *node, HeapScanDesc scan)
 											 &node->pvmbuffer));
 
 				if (!skip_fetch)
-					PrefetchBuffer(scan->rs_rd, MAIN_FORKNUM, tbmpre->blockno);
+					BitmapPrefetchBlock(rel, tbmpre->blockno,
+										&runstart, &runlen);
 			}
+
+			if (runlen > 0)
+				PrefetchBufferRange(rel, MAIN_FORKNUM, runstart, runlen);
 		}
 	}
 #endif							/* USE_PREFETCH */
@@ -741,7 +781,7 @@ ExecReScanBitmapHeapScan(BitmapHeapScanState *node)
 	PlanState  *outerPlan = outerPlanState(node);
 
 	/* rescan to release any page pin */
-	heap_rescan(node->ss.ss_currentScanDesc, NULL);
+	heap_rescan((HeapScanDesc) node->ss.ss_currentScanDesc, NULL);
 
 	/* release bitmaps and buffers if any */
 	if (node->tbmiterator)
@@ -790,7 +830,7 @@ ExecEndBitmapHeapScan(BitmapHeapScanState *node)
 	/*
 	 * extract information from the node
 	 */
-	scanDesc = node->ss.ss_currentScanDesc;
+	scanDesc = (HeapScanDesc) node->ss.ss_currentScanDesc;
 
 	/*
 	 * Free the exprcontext
@@ -953,10 +993,11 @@ ExecInitBitmapHeapScan(BitmapHeapScan *node, EState *estate, int eflags)
 	 * Even though we aren't going to do a conventional seqscan, it is useful
 	 * to create a HeapScanDesc --- most of the fields in it are usable.
 	 */
-	scanstate->ss.ss_currentScanDesc = heap_beginscan_bm(currentRelation,
-														 estate->es_snapshot,
-														 0,
-														 NULL);
+	scanstate->ss.ss_currentScanDesc =
+		(TableScanDesc) heap_beginscan_bm(currentRelation,
+										  estate->es_snapshot,
+										  0,
+										  NULL);
 
 	/*
 	 * all done.
@@ -1104,5 +1145,5 @@ ExecBitmapHeapInitializeWorker(BitmapHeapScanState *node,
 	node->pstate = pstate;
 
 	snapshot = RestoreSnapshot(pstate->phs_snapshot_data);
-	heap_update_snapshot(node->ss.ss_currentScanDesc, snapshot);
+	heap_update_snapshot((HeapScanDesc) node->ss.ss_currentScanDesc, snapshot);
 }
@@ -21,6 +21,7 @@
  */
 #include "postgres.h"
 
+#include "access/relscan.h"
 #include "executor/execdebug.h"
 #include "executor/nodeBitmapIndexscan.h"
 #include "executor/nodeIndexscan.h"
@@ -318,6 +319,7 @@ ExecInitBitmapIndexScan(BitmapIndexScan *node, EState *estate, int eflags)
 		index_beginscan_bitmap(indexstate->biss_RelationDesc,
 							   estate->es_snapshot,
 							   indexstate->biss_NumScanKeys);
+	indexstate->biss_ScanDesc->xs_want_skip = node->indexskip;
 
 	/*
 	 * If no run-time keys to calculate, go ahead and pass the scankeys to the
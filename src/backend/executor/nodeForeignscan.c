@@ -390,3 +390,46 @@ ExecShutdownForeignScan(ForeignScanState *node)
 	if (fdwroutine->ShutdownForeignScan)
 		fdwroutine->ShutdownForeignScan(node);
 }
+
+/* ----------------------------------------------------------------
+ *		ExecForeignScanAsyncCapable
+ *
+ *		Can the FDW run this scan asynchronously under an Append?
+ * ----------------------------------------------------------------
+ */
+bool
+ExecForeignScanAsyncCapable(ForeignScanState *node)
+{
+	FdwRoutine *fdwroutine = node->fdwroutine;
+	ForeignScan *plan = (ForeignScan *) node->ss.ps.plan;
+
+	if (plan->operation != CMD_SELECT)
+		return false;
+	if (fdwroutine->IsForeignScanAsyncCapable == NULL ||
+		fdwroutine->ForeignAsyncRequest == NULL)
+		return false;
+
+	return fdwroutine->IsForeignScanAsyncCapable(node);
+}
+
+/* ----------------------------------------------------------------
+ *		ExecForeignScanAsyncRequest
+ *
+ *		Ask the FDW to make the next tuple of an asynchronous-capable scan
+ *		available without blocking.  Returns PGINVALID_SOCKET if the next
+ *		ExecProcNode() call won't have to wait for the remote side;
+ *		otherwise a request for more data is in flight, and the returned
+ *		socket becomes readable when it may have completed.
+ * ----------------------------------------------------------------
+ */
+pgsocket
+ExecForeignScanAsyncRequest(ForeignScanState *node)
+{
+	FdwRoutine *fdwroutine = node->fdwroutine;
+
+	/* A pending rescan is done by ExecProcNode(); don't run ahead of it */
+	if (node->ss.ps.chgParam != NULL)
+		return PGINVALID_SOCKET;
+
+	return fdwroutine->ForeignAsyncRequest(node);
+}
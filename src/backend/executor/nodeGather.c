@@ -186,6 +186,7 @@ ExecGather(PlanState *pstate)
 			LaunchParallelWorkers(pcxt);
 			/* We save # workers launched for the benefit of EXPLAIN */
 			node->nworkers_launched = pcxt->nworkers_launched;
+			ExecParallelWorkersLaunched(node->pei);
 
 			/* Set up tuple queue readers to read the results. */
 			if (pcxt->nworkers_launched > 0)
@@ -207,9 +208,14 @@ ExecGather(PlanState *pstate)
 			node->nextreader = 0;
 		}
 
-		/* Run plan locally if no workers or enabled and not single-copy. */
+		/*
+		 * Run plan locally if no workers or enabled and not single-copy.  A
+		 * plan that redistributes tuples among the workers can't be run by
+		 * the leader as well, though.
+		 */
 		node->need_to_scan_locally = (node->nreaders == 0)
-			|| (!gather->single_copy && parallel_leader_participation);
+			|| (!gather->single_copy && parallel_leader_participation &&
+				!node->pei->has_redistribute);
 		node->initialized = true;
 	}
 
@@ -54,10 +54,12 @@ typedef struct GMReaderTupleBuffer
 static TupleTableSlot *ExecGatherMerge(PlanState *pstate);
 static int32 heap_compare_slots(Datum a, Datum b, void *arg);
 static TupleTableSlot *gather_merge_getnext(GatherMergeState *gm_state);
+static TupleTableSlot *gather_merge_concat_getnext(GatherMergeState *gm_state);
 static HeapTuple gm_readnext_tuple(GatherMergeState *gm_state, int nreader,
 				  bool nowait, bool *done);
 static void ExecShutdownGatherMergeWorkers(GatherMergeState *node);
 static void gather_merge_setup(GatherMergeState *gm_state);
+static void gather_merge_reset(GatherMergeState *gm_state);
 static void gather_merge_init(GatherMergeState *gm_state);
 static void gather_merge_clear_tuples(GatherMergeState *gm_state);
 static bool gather_merge_readnext(GatherMergeState *gm_state, int reader,
@@ -227,6 +229,7 @@ ExecGatherMerge(PlanState *pstate)
 			LaunchParallelWorkers(pcxt);
 			/* We save # workers launched for the benefit of EXPLAIN */
 			node->nworkers_launched = pcxt->nworkers_launched;
+			ExecParallelWorkersLaunched(node->pei);
 
 			/* Set up tuple queue readers to read the results. */
 			if (pcxt->nworkers_launched > 0)
@@ -247,8 +250,13 @@ ExecGatherMerge(PlanState *pstate)
 			}
 		}
 
-		/* allow leader to participate if enabled or no choice */
-		if (parallel_leader_participation || node->nreaders == 0)
+		/*
+		 * Allow leader to participate if enabled or no choice, except that a
+		 * plan that redistributes tuples among the workers can't be run by
+		 * the leader as well.
+		 */
+		if (node->nreaders == 0 ||
+			(parallel_leader_participation && !node->pei->has_redistribute))
 			node->need_to_scan_locally = true;
 		node->initialized = true;
 	}
@@ -264,7 +272,10 @@ ExecGatherMerge(PlanState *pstate)
 	 * Get next tuple, either from one of our workers, or by running the plan
 	 * ourselves.
 	 */
-	slot = gather_merge_getnext(node);
+	if (castNode(GatherMerge, node->ps.plan)->concat_ranges)
+		slot = gather_merge_concat_getnext(node);
+	else
+		slot = gather_merge_getnext(node);
 	if (TupIsNull(slot))
 		return NULL;
 
@@ -434,17 +445,12 @@ gather_merge_setup(GatherMergeState *gm_state)
 }
 
 /*
- * Initialize the Gather Merge.
- *
- * Reset data structures to ensure they're empty.  Then pull at least one
- * tuple from leader + each worker (or set its "done" indicator), and set up
- * the heap.
+ * Reset the data structures set up by gather_merge_setup to empty.
  */
 static void
-gather_merge_init(GatherMergeState *gm_state)
+gather_merge_reset(GatherMergeState *gm_state)
 {
 	int			nreaders = gm_state->nreaders;
-	bool		nowait = true;
 	int			i;
 
 	/* Assert that gather_merge_setup made enough space */
@@ -467,6 +473,23 @@ gather_merge_init(GatherMergeState *gm_state)
 
 	/* Reset binary heap to empty */
 	binaryheap_reset(gm_state->gm_heap);
+}
+
+/*
+ * Initialize the Gather Merge.
+ *
+ * Reset data structures to ensure they're empty.  Then pull at least one
+ * tuple from leader + each worker (or set its "done" indicator), and set up
+ * the heap.
+ */
+static void
+gather_merge_init(GatherMergeState *gm_state)
+{
+	int			nreaders = gm_state->nreaders;
+	bool		nowait = true;
+	int			i;
+
+	gather_merge_reset(gm_state);
 
 	/*
 	 * First, try to read a tuple from each worker (including leader) in
@@ -590,6 +613,44 @@ gather_merge_getnext(GatherMergeState *gm_state)
 	}
 }
 
+/*
+ * Read the next tuple for gather merge, when the participants produce
+ * disjoint ranges of the sorted output (see nodeRedistribute.c).
+ *
+ * The ranges are in the order of the workers, so we just return all the
+ * tuples of each worker in turn.  The leader only runs the plan itself if
+ * no workers could be launched, in which case it is the only participant.
+ *
+ * Waiting for one worker while the others' queues fill up cannot deadlock,
+ * because each worker sorts its range, and so has finished exchanging tuples
+ * with the other workers before it produces any output.
+ */
+static TupleTableSlot *
+gather_merge_concat_getnext(GatherMergeState *gm_state)
+{
+	if (!gm_state->gm_initialized)
+	{
+		gather_merge_reset(gm_state);
+		gm_state->gm_concat_source = 0;
+		gm_state->gm_initialized = true;
+	}
+
+	while (gm_state->gm_concat_source <= gm_state->nreaders)
+	{
+		int			i = gm_state->gm_concat_source;
+
+		if (gather_merge_readnext(gm_state, i, false))
+			return gm_state->gm_slots[i];
+
+		/* this participant is exhausted, move on to the next one */
+		gm_state->gm_concat_source++;
+	}
+
+	/* All the queues are exhausted */
+	gather_merge_clear_tuples(gm_state);
+	return NULL;
+}
+
 /*
  * Read tuple(s) for given reader in nowait mode, and load into its tuple
  * array, until we have MAX_TUPLE_STORE of them or would have to block.
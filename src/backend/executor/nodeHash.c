@@ -26,6 +26,7 @@
 #include <math.h>
 #include <limits.h>
 
+#include "access/hash.h"
 #include "access/htup_details.h"
 #include "access/parallel.h"
 #include "catalog/pg_statistic.h"
@@ -34,6 +35,7 @@
 #include "executor/hashjoin.h"
 #include "executor/nodeHash.h"
 #include "executor/nodeHashjoin.h"
+#include "lib/bloomfilter.h"
 #include "miscadmin.h"
 #include "pgstat.h"
 #include "port/atomics.h"
@@ -143,6 +145,7 @@ MultiExecPrivateHash(HashState *node)
 	TupleTableSlot *slot;
 	ExprContext *econtext;
 	uint32		hashvalue;
+	double		ntuples = 0;
 
 	/*
 	 * get state info from node
@@ -164,6 +167,7 @@ MultiExecPrivateHash(HashState *node)
 		slot = ExecProcNode(outerNode);
 		if (TupIsNull(slot))
 			break;
+		ntuples += 1;
 		/* We have to compute the hash value */
 		econtext->ecxt_innertuple = slot;
 		if (ExecHashGetHashValue(hashtable, econtext, hashkeys,
@@ -172,6 +176,11 @@ MultiExecPrivateHash(HashState *node)
 		{
 			int			bucketNumber;
 
+			/* remember the hash value, if the join wants a filter */
+			if (node->bloom)
+				bloom_add_element(node->bloom, (unsigned char *) &hashvalue,
+								  sizeof(hashvalue));
+
 			bucketNumber = ExecHashGetSkewBucket(hashtable, hashvalue);
 			if (bucketNumber != INVALID_SKEW_BUCKET_NO)
 			{
@@ -199,6 +208,9 @@ MultiExecPrivateHash(HashState *node)
 		hashtable->spacePeak = hashtable->spaceUsed;
 
 	hashtable->partialTuples = hashtable->totalTuples;
+
+	ExecCheckRowEstimate(&node->ps, "Hash", node->ps.plan->plan_rows,
+						 ntuples);
 }
 
 /* ----------------------------------------------------------------
@@ -315,9 +327,8 @@ MultiExecParallelHash(HashState *node)
 				/*
 				 * Elect one backend to disable any further growth.  Batches
 				 * are now fixed.  While building them we made sure they'd fit
-				 * in our memory budget when we load them back in later (or we
-				 * tried to do that and gave up because we detected extreme
-				 * skew).
+				 * in our memory budget when we load them back in later (except
+				 * for batches that we found to be too skewed to be shrunk).
 				 */
 				pstate->growth = PHJ_GROWTH_DISABLED;
 			}
@@ -509,6 +520,7 @@ ExecHashTableCreate(HashState *state, List *hashOperators, bool keepNulls)
 	hashtable->parallel_state = state->parallel_state;
 	hashtable->area = state->ps.state->es_query_dsa;
 	hashtable->batches = NULL;
+	hashtable->batch_order = NULL;
 
 #ifdef HJDEBUG
 	printf("Hashjoin %p: initial nbatch = %d, nbuckets = %d\n",
@@ -1210,7 +1222,6 @@ ExecParallelHashIncreaseNumBatches(HashJoinTable hashtable)
 									 WAIT_EVENT_HASH_GROW_BATCHES_DECIDING))
 			{
 				bool		space_exhausted = false;
-				bool		extreme_skew_detected = false;
 
 				/* Make sure that we have the current dimensions and buckets. */
 				ExecParallelHashEnsureBatchAccessors(hashtable);
@@ -1225,23 +1236,28 @@ ExecParallelHashIncreaseNumBatches(HashJoinTable hashtable)
 						batch->estimated_size > pstate->space_allowed)
 					{
 						int			parent;
-
-						space_exhausted = true;
+						size_t		parent_ntuples;
 
 						/*
-						 * Did this batch receive ALL of the tuples from its
-						 * parent batch?  That would indicate that further
-						 * repartitioning isn't going to help (the hash values
-						 * are probably all the same).
+						 * Did this batch receive all or nearly all of the
+						 * tuples from its parent batch?  That would indicate
+						 * that further repartitioning isn't going to help it
+						 * (the hash values are probably mostly the same).
+						 * Let it exceed the budget, but don't give up on
+						 * growing for the sake of the other batches.
 						 */
 						parent = i % pstate->old_nbatch;
-						if (batch->ntuples == hashtable->batches[parent].shared->old_ntuples)
-							extreme_skew_detected = true;
+						parent_ntuples =
+							hashtable->batches[parent].shared->old_ntuples;
+						if (batch->ntuples >= parent_ntuples * PHJ_SKEW_FRACTION)
+							batch->skewed = true;
+						else
+							space_exhausted = true;
 					}
 				}
 
 				/* Don't keep growing if it's not helping or we'd overflow. */
-				if (extreme_skew_detected || hashtable->nbatch >= INT_MAX / 2)
+				if (hashtable->nbatch >= INT_MAX / 2)
 					pstate->growth = PHJ_GROWTH_DISABLED;
 				else if (space_exhausted)
 					pstate->growth = PHJ_GROWTH_NEED_MORE_BATCHES;
@@ -1847,7 +1863,7 @@ ExecHashGetHashValue(HashJoinTable hashtable,
 			/* Compute the hash function */
 			uint32		hkey;
 
-			hkey = DatumGetUInt32(FunctionCall1(&hashfunctions[i], keyval));
+			hkey = hash_datum_fast(&hashfunctions[i], InvalidOid, keyval);
 			hashkey ^= hkey;
 		}
 
@@ -2303,8 +2319,8 @@ ExecHashBuildSkewHash(HashJoinTable hashtable, Hash *node, int mcvsToUse)
 			uint32		hashvalue;
 			int			bucket;
 
-			hashvalue = DatumGetUInt32(FunctionCall1(&hashfunctions[0],
-													 sslot.values[i]));
+			hashvalue = hash_datum_fast(&hashfunctions[0], InvalidOid,
+										sslot.values[i]);
 
 			/*
 			 * While we have not hit a hole in the hashtable and have not hit
@@ -2816,9 +2832,11 @@ ExecParallelHashTupleAlloc(HashJoinTable hashtable, size_t size,
 		/*
 		 * Check if our space limit would be exceeded.  To avoid choking on
 		 * very large tuples or very low work_mem setting, we'll always allow
-		 * each backend to allocate at least one chunk.
+		 * each backend to allocate at least one chunk.  A batch we've found
+		 * to be too skewed to shrink is allowed to grow beyond the limit.
 		 */
 		if (hashtable->batches[0].at_least_one_chunk &&
+			!hashtable->batches[0].shared->skewed &&
 			hashtable->batches[0].shared->size +
 			chunk_size > pstate->space_allowed)
 		{
@@ -2982,6 +3000,11 @@ ExecParallelHashCloseBatchAccessors(HashJoinTable hashtable)
 	}
 	pfree(hashtable->batches);
 	hashtable->batches = NULL;
+	if (hashtable->batch_order != NULL)
+	{
+		pfree(hashtable->batch_order);
+		hashtable->batch_order = NULL;
+	}
 }
 
 /*
@@ -3305,6 +3328,7 @@ ExecParallelHashTuplePrealloc(HashJoinTable hashtable, int batchno, size_t size)
 
 	if (pstate->growth != PHJ_GROWTH_DISABLED &&
 		batch->at_least_one_chunk &&
+		!batch->shared->skewed &&
 		(batch->shared->estimated_size + want + HASH_CHUNK_HEADER_SIZE
 		 > pstate->space_allowed))
 	{
@@ -112,7 +112,9 @@
 #include "executor/hashjoin.h"
 #include "executor/nodeHash.h"
 #include "executor/nodeHashjoin.h"
+#include "lib/bloomfilter.h"
 #include "miscadmin.h"
+#include "optimizer/cost.h"
 #include "pgstat.h"
 #include "utils/memutils.h"
 #include "utils/sharedtuplestore.h"
@@ -133,6 +135,16 @@
 /* Returns true if doing null-fill on inner relation */
 #define HJ_FILL_INNER(hjstate)	((hjstate)->hj_NullOuterTupleSlot != NULL)
 
+/*
+ * A hash join filter is dropped if it rejects less than HJ_FILTER_MIN_REJECT
+ * of the first HJ_FILTER_SAMPLE_ROWS rows it sees, and isn't used at all if
+ * more than HJ_FILTER_MAX_FILL of its bits are set once the inner side has
+ * been hashed.
+ */
+#define HJ_FILTER_SAMPLE_ROWS	10000
+#define HJ_FILTER_MIN_REJECT	0.1
+#define HJ_FILTER_MAX_FILL		0.75
+
 static TupleTableSlot *ExecHashJoinOuterGetTuple(PlanState *outerNode,
 						  HashJoinState *hjstate,
 						  uint32 *hashvalue);
@@ -145,7 +157,12 @@ static TupleTableSlot *ExecHashJoinGetSavedTuple(HashJoinState *hjstate,
 						  TupleTableSlot *tupleSlot);
 static bool ExecHashJoinNewBatch(HashJoinState *hjstate);
 static bool ExecParallelHashJoinNewBatch(HashJoinState *hjstate);
+static void ExecParallelHashJoinOrderBatches(HashJoinTable hashtable);
+static int	batch_size_cmp(const void *a, const void *b, void *arg);
 static void ExecParallelHashJoinPartitionOuter(HashJoinState *node);
+static void ExecHashJoinInitFilter(HashJoinState *hjstate);
+static void ExecHashJoinActivateFilter(HashJoinState *hjstate);
+static void ExecHashJoinResetFilter(HashJoinState *hjstate);
 
 
 /* ----------------------------------------------------------------
@@ -287,8 +304,19 @@ ExecHashJoinImpl(PlanState *pstate, bool parallel)
 				 * arrived too late.
 				 */
 				hashNode->hashtable = hashtable;
+				if (node->hj_Filter != NULL)
+					hashNode->bloom =
+						bloom_create((int64) Max(hashNode->ps.plan->plan_rows, 1.0),
+									 work_mem, 0);
 				(void) MultiExecProcNode((PlanState *) hashNode);
 
+				/*
+				 * If the Hash node collected the inner hash values for our
+				 * filter, let the outer scan start using it.
+				 */
+				if (hashNode->bloom != NULL)
+					ExecHashJoinActivateFilter(node);
+
 				/*
 				 * If the inner relation is completely empty, and we're not
 				 * doing a left outer join, we can quit without scanning the
@@ -760,6 +788,9 @@ ExecInitHashJoin(HashJoin *node, EState *estate, int eflags)
 	hjstate->hj_MatchedOuter = false;
 	hjstate->hj_OuterNotEmpty = false;
 
+	/* see if we can filter the outer side while it's being scanned */
+	ExecHashJoinInitFilter(hjstate);
+
 	return hjstate;
 }
 
@@ -777,6 +808,7 @@ ExecEndHashJoin(HashJoinState *node)
 	 */
 	if (node->hj_HashTable)
 	{
+		ExecHashJoinResetFilter(node);
 		ExecHashTableDestroy(node->hj_HashTable);
 		node->hj_HashTable = NULL;
 	}
@@ -1095,7 +1127,8 @@ static bool
 ExecParallelHashJoinNewBatch(HashJoinState *hjstate)
 {
 	HashJoinTable hashtable = hjstate->hj_HashTable;
-	int			start_batchno;
+	int			start_idx;
+	int			idx;
 	int			batchno;
 
 	/*
@@ -1118,11 +1151,17 @@ ExecParallelHashJoinNewBatch(HashJoinState *hjstate)
 	}
 
 	/*
-	 * Search for a batch that isn't done.  We use an atomic counter to start
+	 * Search for a batch that isn't done.  We visit the batches from largest
+	 * to smallest, so that big (typically skewed) batches are started early
+	 * rather than being left to a single participant at the end, and so that
+	 * participants that run out of batches of their own help out with the
+	 * biggest batches still in progress.  We use an atomic counter to start
 	 * our search at a different batch in every participant when there are
 	 * more batches than participants.
 	 */
-	batchno = start_batchno =
+	if (hashtable->batch_order == NULL)
+		ExecParallelHashJoinOrderBatches(hashtable);
+	idx = start_idx =
 		pg_atomic_fetch_add_u32(&hashtable->parallel_state->distributor, 1) %
 		hashtable->nbatch;
 	do
@@ -1131,6 +1170,7 @@ ExecParallelHashJoinNewBatch(HashJoinState *hjstate)
 		MinimalTuple tuple;
 		TupleTableSlot *slot;
 
+		batchno = hashtable->batch_order[idx];
 		if (!hashtable->batches[batchno].done)
 		{
 			SharedTuplestoreAccessor *inner_tuples;
@@ -1205,12 +1245,50 @@ ExecParallelHashJoinNewBatch(HashJoinState *hjstate)
 						 BarrierPhase(batch_barrier));
 			}
 		}
-		batchno = (batchno + 1) % hashtable->nbatch;
-	} while (batchno != start_batchno);
+		idx = (idx + 1) % hashtable->nbatch;
+	} while (idx != start_idx);
 
 	return false;
 }
 
+/*
+ * Sort the batch numbers by decreasing number of inner tuples, for
+ * ExecParallelHashJoinNewBatch.  The batches are fixed once the build is
+ * done, so every participant arrives at the same order.
+ */
+static void
+ExecParallelHashJoinOrderBatches(HashJoinTable hashtable)
+{
+	int			i;
+
+	hashtable->batch_order = (int *)
+		MemoryContextAlloc(hashtable->hashCxt,
+						   sizeof(int) * hashtable->nbatch);
+	for (i = 0; i < hashtable->nbatch; ++i)
+		hashtable->batch_order[i] = i;
+	qsort_arg(hashtable->batch_order, hashtable->nbatch, sizeof(int),
+			  batch_size_cmp, hashtable);
+}
+
+/*
+ * qsort_arg comparator for ExecParallelHashJoinOrderBatches.
+ */
+static int
+batch_size_cmp(const void *a, const void *b, void *arg)
+{
+	HashJoinTable hashtable = (HashJoinTable) arg;
+	int			batchno1 = *(const int *) a;
+	int			batchno2 = *(const int *) b;
+	size_t		ntuples1 = hashtable->batches[batchno1].shared->ntuples;
+	size_t		ntuples2 = hashtable->batches[batchno2].shared->ntuples;
+
+	if (ntuples1 > ntuples2)
+		return -1;
+	if (ntuples1 < ntuples2)
+		return 1;
+	return batchno1 - batchno2;
+}
+
 /*
  * ExecHashJoinSaveTuple
  *		save a tuple to a batch file.
@@ -1344,6 +1422,7 @@ ExecReScanHashJoin(HashJoinState *node)
 		else
 		{
 			/* must destroy and rebuild hash table */
+			ExecHashJoinResetFilter(node);
 			ExecHashTableDestroy(node->hj_HashTable);
 			node->hj_HashTable = NULL;
 			node->hj_JoinState = HJ_BUILD_HASHTABLE;
@@ -1389,6 +1468,208 @@ ExecShutdownHashJoin(HashJoinState *node)
 	}
 }
 
+/*
+ * Return the address of the Var in a hash join filter key, which is either a
+ * Var or a RelabelType over one.
+ */
+static Var **
+ExecHashJoinFilterKeyVar(Expr **key)
+{
+	if (IsA(*key, RelabelType))
+		return (Var **) &((RelabelType *) *key)->arg;
+	return (Var **) key;
+}
+
+/*
+ * ExecHashJoinInitFilter
+ *
+ * Try to set up a Bloom filter of our inner hash values that a scan node on
+ * the outer side can use to throw away rows that can't join.  That's only
+ * correct if the join discards unmatched outer rows, and we have to be able
+ * to compute the outer hash keys from the scan's tuples.  We handle keys
+ * that are plain Vars, and follow them down through the outer side of any
+ * hash joins below us that pass them through unchanged, so that a fact table
+ * joined with several dimension tables is filtered by all of them.  Rows
+ * that such a lower join sees fewer of only make it emit rows that we would
+ * discard anyway.
+ *
+ * A Parallel Hash table is built by several processes, none of which sees
+ * all of the inner hash values, so we don't try it then.
+ */
+static void
+ExecHashJoinInitFilter(HashJoinState *hjstate)
+{
+	HashJoin   *node = (HashJoin *) hjstate->js.ps.plan;
+	Plan	   *hashplan = innerPlan(node);
+	PlanState  *target;
+	List	   *keys = NIL;
+	List	   *tlist;
+	ListCell   *l;
+	HashJoinFilter *filter;
+
+	if (!enable_hashjoin_filter || hashplan->parallel_aware)
+		return;
+
+	if (node->join.jointype != JOIN_INNER &&
+		node->join.jointype != JOIN_SEMI &&
+		node->join.jointype != JOIN_RIGHT)
+		return;
+
+	foreach(l, node->hashclauses)
+	{
+		OpExpr	   *hclause = lfirst_node(OpExpr, l);
+		Expr	   *key = (Expr *) linitial(hclause->args);
+		Var		  **var = ExecHashJoinFilterKeyVar(&key);
+
+		if (!IsA(*var, Var) || (*var)->varno != OUTER_VAR)
+			return;
+		keys = lappend(keys, copyObject(key));
+	}
+
+	/* look through lower hash joins that pass our keys through */
+	target = outerPlanState(hjstate);
+	while (IsA(target, HashJoinState))
+	{
+		tlist = target->plan->targetlist;
+		foreach(l, keys)
+		{
+			Var		  **var = ExecHashJoinFilterKeyVar((Expr **) &lfirst(l));
+			TargetEntry *tle;
+
+			if ((*var)->varattno < 1 || (*var)->varattno > list_length(tlist))
+				return;
+			tle = list_nth_node(TargetEntry, tlist, (*var)->varattno - 1);
+			if (!IsA(tle->expr, Var) || ((Var *) tle->expr)->varno != OUTER_VAR)
+				return;
+			(*var)->varattno = ((Var *) tle->expr)->varattno;
+		}
+		target = outerPlanState(target);
+	}
+
+	if (!IsA(target, SeqScanState) &&
+		!IsA(target, IndexScanState) &&
+		!IsA(target, IndexOnlyScanState) &&
+		!IsA(target, BitmapHeapScanState))
+		return;
+
+	/* not worth it unless the outer side is the bigger one */
+	if (target->plan->plan_rows <= hashplan->plan_rows)
+		return;
+
+	/* finally, replace each key's Var with the scan column it projects */
+	tlist = target->plan->targetlist;
+	foreach(l, keys)
+	{
+		Var		  **var = ExecHashJoinFilterKeyVar((Expr **) &lfirst(l));
+		TargetEntry *tle;
+
+		if ((*var)->varattno < 1 || (*var)->varattno > list_length(tlist))
+			return;
+		tle = list_nth_node(TargetEntry, tlist, (*var)->varattno - 1);
+		if (!IsA(tle->expr, Var))
+			return;
+		*var = (Var *) copyObject(tle->expr);
+	}
+
+	filter = (HashJoinFilter *) palloc0(sizeof(HashJoinFilter));
+	filter->hashkeys = ExecInitExprList(keys, target);
+	((ScanState *) target)->ss_HashJoinFilters =
+		lappend(((ScanState *) target)->ss_HashJoinFilters, filter);
+	hjstate->hj_Filter = filter;
+}
+
+/*
+ * ExecHashJoinActivateFilter
+ *
+ * Called once the Hash node has added all the inner hash values to the Bloom
+ * filter we gave it.  If the filter is too full to reject much, forget it.
+ */
+static void
+ExecHashJoinActivateFilter(HashJoinState *hjstate)
+{
+	HashState  *hashNode = (HashState *) innerPlanState(hjstate);
+	HashJoinFilter *filter = hjstate->hj_Filter;
+	bloom_filter *bloom = hashNode->bloom;
+
+	hashNode->bloom = NULL;
+
+	Assert(filter->bloom == NULL);
+	if (bloom_prop_bits_set(bloom) > HJ_FILTER_MAX_FILL)
+	{
+		bloom_free(bloom);
+		return;
+	}
+
+	filter->hashtable = hjstate->hj_HashTable;
+	filter->bloom = bloom;
+	filter->nchecked = 0;
+	filter->nrejected = 0;
+}
+
+/*
+ * ExecHashJoinResetFilter
+ *
+ * Stop the outer scan from using our filter, before the hash table it
+ * depends on goes away.
+ */
+static void
+ExecHashJoinResetFilter(HashJoinState *hjstate)
+{
+	HashJoinFilter *filter = hjstate->hj_Filter;
+
+	if (filter == NULL)
+		return;
+	if (filter->bloom != NULL)
+		bloom_free(filter->bloom);
+	filter->bloom = NULL;
+	filter->hashtable = NULL;
+}
+
+/*
+ * ExecHashJoinFilterTuple
+ *
+ * Called by ExecScan() for each row that passes a scan node's quals, with the
+ * row stored in econtext's scan tuple.  Returns false if one of the hash
+ * join filters pushed down to the node shows that it can't have a join
+ * partner.
+ */
+bool
+ExecHashJoinFilterTuple(List *filters, ExprContext *econtext)
+{
+	ListCell   *l;
+
+	foreach(l, filters)
+	{
+		HashJoinFilter *filter = (HashJoinFilter *) lfirst(l);
+		uint32		hashvalue;
+
+		if (filter->bloom == NULL)
+			continue;
+
+		/* give up on filters that let nearly everything through */
+		if (filter->nchecked == HJ_FILTER_SAMPLE_ROWS &&
+			filter->nrejected < filter->nchecked * HJ_FILTER_MIN_REJECT)
+		{
+			bloom_free(filter->bloom);
+			filter->bloom = NULL;
+			continue;
+		}
+
+		filter->nchecked += 1;
+		if (!ExecHashGetHashValue(filter->hashtable, econtext,
+								  filter->hashkeys, true, false,
+								  &hashvalue) ||
+			bloom_lacks_element(filter->bloom, (unsigned char *) &hashvalue,
+								sizeof(hashvalue)))
+		{
+			filter->nrejected += 1;
+			return false;
+		}
+	}
+
+	return true;
+}
+
 static void
 ExecParallelHashJoinPartitionOuter(HashJoinState *hjstate)
 {
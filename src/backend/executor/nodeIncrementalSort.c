@@ -0,0 +1,372 @@
+/*-------------------------------------------------------------------------
+ *
+ * nodeIncrementalSort.c
+ *	  Routines to handle incremental sorting of relations.
+ *
+ * An incremental sort is used when the input is already sorted by a prefix
+ * of the requested sort keys, say by (a) when (a, b) is wanted.  Rather than
+ * reading and sorting all of the input before returning the first tuple, as
+ * a Sort node must, we read one group of tuples with equal values of the
+ * presorted columns at a time, sort just that group, and return its tuples
+ * before reading on.  That needs only as much memory as the largest group,
+ * and under a LIMIT it lets us stop after the first few groups.
+ *
+ * To keep the per-sort overhead in check when groups are tiny, each batch
+ * we sort contains at least INCSORT_MIN_BATCH_TUPLES tuples, and then
+ * extends to the end of the group its last tuple belongs to.  A batch can
+ * thus span several groups; since it is sorted by all sort keys, that makes
+ * no difference to the result.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/executor/nodeIncrementalSort.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "executor/execdebug.h"
+#include "executor/executor.h"
+#include "executor/nodeIncrementalSort.h"
+#include "miscadmin.h"
+#include "utils/lsyscache.h"
+#include "utils/tuplesort.h"
+
+/* Minimum number of tuples to sort at a time */
+#define INCSORT_MIN_BATCH_TUPLES	32
+
+
+/* ----------------------------------------------------------------
+ *		incsort_sort_batch
+ *
+ *		Read the next batch of tuples from the outer plan and sort it.
+ * ----------------------------------------------------------------
+ */
+static void
+incsort_sort_batch(IncrementalSortState *node)
+{
+	IncrementalSort *plannode = (IncrementalSort *) node->ss.ps.plan;
+	PlanState  *outerNode = outerPlanState(node);
+	ExprContext *econtext = node->ss.ps.ps_ExprContext;
+	Tuplesortstate *tuplesortstate;
+	int64		ntuples = 0;
+
+	SO1_printf("incsort_sort_batch: %s\n",
+			   "calling tuplesort_begin");
+
+	tuplesortstate = tuplesort_begin_heap(ExecGetResultType(outerNode),
+										  plannode->sort.numCols,
+										  plannode->sort.sortColIdx,
+										  plannode->sort.sortOperators,
+										  plannode->sort.collations,
+										  plannode->sort.nullsFirst,
+										  work_mem,
+										  NULL, false);
+	if (node->bounded)
+		tuplesort_set_bound(tuplesortstate, node->bound - node->nreturned);
+	node->tuplesortstate = (void *) tuplesortstate;
+
+	/* The previous batch may have read our first tuple already */
+	if (!TupIsNull(node->transfer_tuple))
+	{
+		tuplesort_puttupleslot(tuplesortstate, node->transfer_tuple);
+		if (++ntuples == INCSORT_MIN_BATCH_TUPLES)
+			ExecCopySlot(node->group_pivot, node->transfer_tuple);
+		ExecClearTuple(node->transfer_tuple);
+	}
+
+	for (;;)
+	{
+		TupleTableSlot *slot = ExecProcNode(outerNode);
+
+		if (TupIsNull(slot))
+		{
+			node->input_done = true;
+			break;
+		}
+
+		/*
+		 * Once the batch is big enough, end it where the presorted columns
+		 * change.  All tuples added since group_pivot was saved match it, so
+		 * it's enough to compare with that.
+		 */
+		if (ntuples >= INCSORT_MIN_BATCH_TUPLES)
+		{
+			econtext->ecxt_innertuple = node->group_pivot;
+			econtext->ecxt_outertuple = slot;
+			if (!ExecQualAndReset(node->presorted_eq, econtext))
+			{
+				ExecCopySlot(node->transfer_tuple, slot);
+				break;
+			}
+		}
+
+		tuplesort_puttupleslot(tuplesortstate, slot);
+		if (++ntuples == INCSORT_MIN_BATCH_TUPLES)
+			ExecCopySlot(node->group_pivot, slot);
+	}
+
+	tuplesort_performsort(tuplesortstate);
+	node->batch_sorted = true;
+	node->nbatches++;
+
+	/* For EXPLAIN ANALYZE, remember the sort that used the most space */
+	if (node->ss.ps.instrument != NULL)
+	{
+		TuplesortInstrumentation stats;
+
+		tuplesort_get_stats(tuplesortstate, &stats);
+		if (node->nbatches == 1 ||
+			(stats.spaceType == node->sinstrument.spaceType &&
+			 stats.spaceUsed > node->sinstrument.spaceUsed) ||
+			(stats.spaceType == SORT_SPACE_TYPE_DISK &&
+			 node->sinstrument.spaceType != SORT_SPACE_TYPE_DISK))
+			node->sinstrument = stats;
+	}
+
+	SO1_printf("incsort_sort_batch: sorted " INT64_FORMAT " tuples\n",
+			   ntuples);
+}
+
+/* ----------------------------------------------------------------
+ *		ExecIncrementalSort
+ *
+ *		Returns the tuples of the current sorted batch, sorting the next
+ *		batch whenever one is used up.
+ *
+ *		Conditions:
+ *		  -- the outer child returns tuples sorted by the presorted columns.
+ *
+ *		Initial States:
+ *		  -- the outer child is prepared to return the first tuple.
+ * ----------------------------------------------------------------
+ */
+static TupleTableSlot *
+ExecIncrementalSort(PlanState *pstate)
+{
+	IncrementalSortState *node = castNode(IncrementalSortState, pstate);
+	EState	   *estate = node->ss.ps.state;
+	TupleTableSlot *slot = node->ss.ps.ps_ResultTupleSlot;
+
+	CHECK_FOR_INTERRUPTS();
+
+	for (;;)
+	{
+		if (node->batch_sorted)
+		{
+			/*
+			 * Note that we only rely on the slot tuple remaining valid until
+			 * the next fetch from the tuplesort.
+			 */
+			if (tuplesort_gettupleslot((Tuplesortstate *) node->tuplesortstate,
+									   true, false, slot, NULL))
+			{
+				node->nreturned++;
+				return slot;
+			}
+
+			/* done with this batch */
+			tuplesort_end((Tuplesortstate *) node->tuplesortstate);
+			node->tuplesortstate = NULL;
+			node->batch_sorted = false;
+		}
+
+		if (node->input_done)
+			return ExecClearTuple(slot);
+
+		/*
+		 * Want to scan subplan in the forward direction while reading the
+		 * next batch.
+		 */
+		if (ScanDirectionIsForward(estate->es_direction))
+			incsort_sort_batch(node);
+		else
+		{
+			ScanDirection dir = estate->es_direction;
+
+			estate->es_direction = ForwardScanDirection;
+			incsort_sort_batch(node);
+			estate->es_direction = dir;
+		}
+	}
+}
+
+/* ----------------------------------------------------------------
+ *		ExecInitIncrementalSort
+ *
+ *		Creates the run-time state information for the incremental sort
+ *		node produced by the planner and initializes its outer subtree.
+ * ----------------------------------------------------------------
+ */
+IncrementalSortState *
+ExecInitIncrementalSort(IncrementalSort *node, EState *estate, int eflags)
+{
+	IncrementalSortState *incrsortstate;
+	TupleDesc	tupDesc;
+	Oid		   *eqOperators;
+	int			i;
+
+	SO1_printf("ExecInitIncrementalSort: %s\n",
+			   "initializing sort node");
+
+	/*
+	 * We don't keep our output around, so we can't support backward scans or
+	 * mark/restore; the planner must put a Material node on top if needed.
+	 */
+	Assert(!(eflags & (EXEC_FLAG_BACKWARD | EXEC_FLAG_MARK)));
+
+	/*
+	 * create state structure
+	 */
+	incrsortstate = makeNode(IncrementalSortState);
+	incrsortstate->ss.ps.plan = (Plan *) node;
+	incrsortstate->ss.ps.state = estate;
+	incrsortstate->ss.ps.ExecProcNode = ExecIncrementalSort;
+
+	incrsortstate->bounded = false;
+	incrsortstate->nreturned = 0;
+	incrsortstate->batch_sorted = false;
+	incrsortstate->input_done = false;
+	incrsortstate->tuplesortstate = NULL;
+	incrsortstate->nbatches = 0;
+
+	/*
+	 * Miscellaneous initialization
+	 *
+	 * We need an ExprContext to compare the presorted columns of tuples.
+	 */
+	ExecAssignExprContext(estate, &incrsortstate->ss.ps);
+
+	/*
+	 * initialize child nodes
+	 *
+	 * Since we re-read our input on rescan, a REWIND request is passed on.
+	 */
+	outerPlanState(incrsortstate) = ExecInitNode(outerPlan(node), estate, eflags);
+
+	/*
+	 * Initialize scan slot and type.
+	 */
+	ExecCreateScanSlotFromOuterPlan(estate, &incrsortstate->ss, &TTSOpsVirtual);
+
+	/*
+	 * Initialize return slot and type. No need to initialize projection info
+	 * because this node doesn't do projections.
+	 */
+	ExecInitResultTupleSlotTL(&incrsortstate->ss.ps, &TTSOpsMinimalTuple);
+	incrsortstate->ss.ps.ps_ProjInfo = NULL;
+
+	/*
+	 * Slots to keep the tuple that ends the current batch's last group, and
+	 * the one that starts the next batch.
+	 */
+	tupDesc = ExecGetResultType(outerPlanState(incrsortstate));
+	incrsortstate->group_pivot = ExecInitExtraTupleSlot(estate, tupDesc,
+														&TTSOpsMinimalTuple);
+	incrsortstate->transfer_tuple = ExecInitExtraTupleSlot(estate, tupDesc,
+														   &TTSOpsMinimalTuple);
+
+	/*
+	 * Precompute the equality check on the presorted columns, from the
+	 * equality operators matching their sort operators.  The tuples compared
+	 * are from group_pivot and from whatever slot the outer plan returns.
+	 */
+	eqOperators = (Oid *) palloc(node->nPresortedCols * sizeof(Oid));
+	for (i = 0; i < node->nPresortedCols; i++)
+	{
+		Oid			sortop = node->sort.sortOperators[i];
+
+		eqOperators[i] = get_equality_op_for_ordering_op(sortop, NULL);
+		if (!OidIsValid(eqOperators[i]))
+			elog(ERROR, "missing equality operator for ordering operator %u",
+				 sortop);
+	}
+
+	incrsortstate->ss.ps.inneropsset = true;
+	incrsortstate->ss.ps.inneropsfixed = false;
+	incrsortstate->ss.ps.outeropsset = true;
+	incrsortstate->ss.ps.outeropsfixed = false;
+	incrsortstate->presorted_eq =
+		execTuplesMatchPrepare(tupDesc,
+							   node->nPresortedCols,
+							   node->sort.sortColIdx,
+							   eqOperators,
+							   &incrsortstate->ss.ps);
+
+	SO1_printf("ExecInitIncrementalSort: %s\n",
+			   "sort node initialized");
+
+	return incrsortstate;
+}
+
+/* ----------------------------------------------------------------
+ *		ExecEndIncrementalSort(node)
+ * ----------------------------------------------------------------
+ */
+void
+ExecEndIncrementalSort(IncrementalSortState *node)
+{
+	SO1_printf("ExecEndIncrementalSort: %s\n",
+			   "shutting down sort node");
+
+	/*
+	 * clean out the tuple table
+	 */
+	ExecClearTuple(node->ss.ss_ScanTupleSlot);
+	/* must drop pointer to sort result tuple */
+	ExecClearTuple(node->ss.ps.ps_ResultTupleSlot);
+	ExecClearTuple(node->group_pivot);
+	ExecClearTuple(node->transfer_tuple);
+
+	/*
+	 * Release tuplesort resources
+	 */
+	if (node->tuplesortstate != NULL)
+		tuplesort_end((Tuplesortstate *) node->tuplesortstate);
+	node->tuplesortstate = NULL;
+
+	ExecFreeExprContext(&node->ss.ps);
+
+	/*
+	 * shut down the subplan
+	 */
+	ExecEndNode(outerPlanState(node));
+
+	SO1_printf("ExecEndIncrementalSort: %s\n",
+			   "sort node shutdown");
+}
+
+void
+ExecReScanIncrementalSort(IncrementalSortState *node)
+{
+	PlanState  *outerPlan = outerPlanState(node);
+
+	/* must drop pointer to sort result tuple */
+	ExecClearTuple(node->ss.ps.ps_ResultTupleSlot);
+	ExecClearTuple(node->group_pivot);
+	ExecClearTuple(node->transfer_tuple);
+
+	/*
+	 * Unlike a Sort node we never hold all of our output, so we always have
+	 * to start over from the first batch.
+	 */
+	if (node->tuplesortstate != NULL)
+	{
+		tuplesort_end((Tuplesortstate *) node->tuplesortstate);
+		node->tuplesortstate = NULL;
+	}
+	node->batch_sorted = false;
+	node->input_done = false;
+	node->nreturned = 0;
+
+	/*
+	 * if chgParam of subnode is not null then plan will be re-scanned by
+	 * first ExecProcNode.
+	 */
+	if (outerPlan->chgParam == NULL)
+		ExecReScan(outerPlan);
+}
@@ -29,6 +29,8 @@
  */
 #include "postgres.h"
 
+#include <math.h>
+
 #include "access/nbtree.h"
 #include "access/relscan.h"
 #include "catalog/pg_am.h"
@@ -38,11 +40,13 @@
 #include "miscadmin.h"
 #include "nodes/nodeFuncs.h"
 #include "optimizer/clauses.h"
+#include "storage/bufmgr.h"
 #include "utils/array.h"
 #include "utils/datum.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/rel.h"
+#include "utils/spccache.h"
 
 /*
  * When an ordering operator is used, tuples fetched from the index that
@@ -117,6 +121,8 @@ IndexNext(IndexScanState *node)
 								   node->iss_NumOrderByKeys);
 
 		node->iss_ScanDesc = scandesc;
+		scandesc->xs_want_skip = ((IndexScan *) node->ss.ps.plan)->indexskip;
+		scandesc->xs_prefetch_maximum = node->iss_PrefetchMaximum;
 
 		/*
 		 * If no run-time keys to calculate or they are ready, go ahead and
@@ -221,6 +227,7 @@ IndexNextWithReorder(IndexScanState *node)
 								   node->iss_NumOrderByKeys);
 
 		node->iss_ScanDesc = scandesc;
+		scandesc->xs_prefetch_maximum = node->iss_PrefetchMaximum;
 
 		/*
 		 * If no run-time keys to calculate or they are ready, go ahead and
@@ -921,6 +928,7 @@ ExecInitIndexScan(IndexScan *node, EState *estate, int eflags)
 	IndexScanState *indexstate;
 	Relation	currentRelation;
 	bool		relistarget;
+	int			io_concurrency;
 
 	/*
 	 * create state structure
@@ -1001,6 +1009,21 @@ ExecInitIndexScan(IndexScan *node, EState *estate, int eflags)
 	indexstate->iss_RuntimeKeys = NULL;
 	indexstate->iss_NumRuntimeKeys = 0;
 
+	/*
+	 * Determine how far ahead the index AM may prefetch heap blocks, the same
+	 * way as the prefetch distance of a bitmap heap scan.
+	 */
+	indexstate->iss_PrefetchMaximum = target_prefetch_pages;
+	io_concurrency =
+		get_tablespace_io_concurrency(currentRelation->rd_rel->reltablespace);
+	if (io_concurrency != effective_io_concurrency)
+	{
+		double		maximum;
+
+		if (ComputeIoConcurrency(io_concurrency, &maximum))
+			indexstate->iss_PrefetchMaximum = rint(maximum);
+	}
+
 	/*
 	 * build the index scan keys from the index qualification
 	 */
@@ -1724,6 +1747,7 @@ ExecIndexScanInitializeDSM(IndexScanState *node,
 								 node->iss_NumScanKeys,
 								 node->iss_NumOrderByKeys,
 								 piscan);
+	node->iss_ScanDesc->xs_prefetch_maximum = node->iss_PrefetchMaximum;
 
 	/*
 	 * If no run-time keys to calculate or they are ready, go ahead and pass
@@ -1767,6 +1791,7 @@ ExecIndexScanInitializeWorker(IndexScanState *node,
 								 node->iss_NumScanKeys,
 								 node->iss_NumOrderByKeys,
 								 piscan);
+	node->iss_ScanDesc->xs_prefetch_maximum = node->iss_PrefetchMaximum;
 
 	/*
 	 * If no run-time keys to calculate or they are ready, go ahead and pass
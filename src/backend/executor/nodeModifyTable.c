@@ -38,8 +38,13 @@
 #include "postgres.h"
 
 #include "access/htup_details.h"
+#include "access/tableam.h"
 #include "access/xact.h"
+#include "access/stratnum.h"
 #include "catalog/catalog.h"
+#include "catalog/index.h"
+#include "catalog/pg_am.h"
+#include "catalog/pg_index.h"
 #include "commands/trigger.h"
 #include "executor/execPartition.h"
 #include "executor/executor.h"
@@ -50,8 +55,10 @@
 #include "storage/bufmgr.h"
 #include "storage/lmgr.h"
 #include "utils/builtins.h"
+#include "utils/datum.h"
 #include "utils/memutils.h"
 #include "utils/rel.h"
+#include "utils/sortsupport.h"
 #include "utils/tqual.h"
 
 
@@ -69,6 +76,24 @@ static TupleTableSlot *ExecPrepareTupleRouting(ModifyTableState *mtstate,
 						ResultRelInfo *targetRelInfo,
 						TupleTableSlot *slot);
 static ResultRelInfo *getTargetResultRelInfo(ModifyTableState *node);
+static bool ExecMultiInsertCanBatch(ModifyTableState *mtstate,
+						ResultRelInfo *resultRelInfo);
+static void ExecMultiInsertBuffer(ModifyTableState *mtstate,
+					  ResultRelInfo *resultRelInfo, HeapTuple tuple);
+static void ExecMultiInsertFlush(ModifyTableState *mtstate,
+					 ResultRelInfo *resultRelInfo);
+static TupleTableSlot *ExecInsert(ModifyTableState *mtstate,
+		   TupleTableSlot *slot,
+		   TupleTableSlot *planSlot,
+		   EState *estate,
+		   bool canSetTag);
+static int	ExecUpsertArbiterIndex(ResultRelInfo *resultRelInfo);
+static bool ExecUpsertCanBatch(ModifyTableState *mtstate,
+				   ResultRelInfo *resultRelInfo);
+static void ExecUpsertBuffer(ModifyTableState *mtstate,
+				 TupleTableSlot *slot, TupleTableSlot *planSlot);
+static void ExecUpsertFlush(ModifyTableState *mtstate);
+static int	upsert_entry_cmp(const void *a, const void *b, void *arg);
 static void ExecSetupChildParentMapForSubplan(ModifyTableState *mtstate);
 static TupleConversionMap *tupconv_map_for_subplan(ModifyTableState *node,
 						int whichplan);
@@ -244,6 +269,612 @@ ExecCheckTIDVisible(EState *estate,
 	ReleaseBuffer(buffer);
 }
 
+/*
+ * ExecSetForeignInsertBatchSize -- ask the FDW how many rows it wants to
+ * receive per batch when inserting into this foreign result rel
+ *
+ * Must be called after the FDW's BeginForeignModify or BeginForeignInsert
+ * callback, since the answer usually depends on the state set up there.
+ */
+void
+ExecSetForeignInsertBatchSize(ResultRelInfo *resultRelInfo)
+{
+	FdwRoutine *fdwroutine = resultRelInfo->ri_FdwRoutine;
+
+	if (fdwroutine != NULL &&
+		fdwroutine->GetForeignModifyBatchSize != NULL &&
+		fdwroutine->ExecForeignBatchInsert != NULL)
+		resultRelInfo->ri_BatchSize =
+			fdwroutine->GetForeignModifyBatchSize(resultRelInfo);
+	else
+		resultRelInfo->ri_BatchSize = 1;
+}
+
+/*
+ * ExecForeignInsertCanBatch -- can rows inserted into this foreign result
+ * rel be queued up and handed to the FDW a batch at a time?
+ *
+ * Only when nothing needs to look at each row as it is inserted: no
+ * RETURNING list, no WITH CHECK OPTIONs, no AFTER ROW triggers and no
+ * transition tables.  Rows moved into a partition by UPDATE are always
+ * inserted one at a time.
+ */
+bool
+ExecForeignInsertCanBatch(ModifyTableState *mtstate,
+						  ResultRelInfo *resultRelInfo)
+{
+	return resultRelInfo->ri_BatchSize > 1 &&
+		mtstate->operation == CMD_INSERT &&
+		mtstate->mt_transition_capture == NULL &&
+		resultRelInfo->ri_projectReturning == NULL &&
+		resultRelInfo->ri_WithCheckOptions == NIL &&
+		!(resultRelInfo->ri_TrigDesc &&
+		  resultRelInfo->ri_TrigDesc->trig_insert_after_row);
+}
+
+/*
+ * ExecForeignInsertBuffer -- queue up a row for a batched foreign insert
+ *
+ * The row is copied, so the caller's slots can be reused right away.  If
+ * that fills the batch, it is sent to the FDW immediately; the result is the
+ * number of queued rows the FDW then reported as not inserted (see
+ * ExecForeignInsertFlush), and 0 otherwise.  planSlot may be NULL, as it is
+ * for COPY.
+ */
+int
+ExecForeignInsertBuffer(ModifyTableState *mtstate,
+						ResultRelInfo *resultRelInfo,
+						TupleTableSlot *slot, TupleTableSlot *planSlot)
+{
+	EState	   *estate = mtstate->ps.state;
+	MemoryContext oldcontext;
+	int			i = resultRelInfo->ri_NumSlots;
+
+	Assert(ExecForeignInsertCanBatch(mtstate, resultRelInfo));
+
+	oldcontext = MemoryContextSwitchTo(estate->es_query_cxt);
+
+	if (resultRelInfo->ri_Slots == NULL)
+	{
+		resultRelInfo->ri_Slots = (TupleTableSlot **)
+			palloc(sizeof(TupleTableSlot *) * resultRelInfo->ri_BatchSize);
+		resultRelInfo->ri_PlanSlots = (TupleTableSlot **)
+			palloc(sizeof(TupleTableSlot *) * resultRelInfo->ri_BatchSize);
+	}
+
+	if (i >= resultRelInfo->ri_NumSlotsInitialized)
+	{
+		resultRelInfo->ri_Slots[i] =
+			ExecInitExtraTupleSlot(estate, slot->tts_tupleDescriptor,
+								   &TTSOpsVirtual);
+		resultRelInfo->ri_PlanSlots[i] = planSlot == NULL ? NULL :
+			ExecInitExtraTupleSlot(estate, planSlot->tts_tupleDescriptor,
+								   &TTSOpsVirtual);
+		resultRelInfo->ri_NumSlotsInitialized++;
+	}
+
+	ExecCopySlot(resultRelInfo->ri_Slots[i], slot);
+	if (planSlot != NULL)
+		ExecCopySlot(resultRelInfo->ri_PlanSlots[i], planSlot);
+
+	if (i == 0)
+		mtstate->mt_batchrels = list_append_unique_ptr(mtstate->mt_batchrels,
+													   resultRelInfo);
+
+	MemoryContextSwitchTo(oldcontext);
+
+	if (++resultRelInfo->ri_NumSlots < resultRelInfo->ri_BatchSize)
+		return 0;
+
+	return ExecForeignInsertFlush(mtstate, resultRelInfo);
+}
+
+/*
+ * ExecForeignInsertFlush -- send the rows queued up for a foreign result
+ * rel to the FDW
+ *
+ * The rows the FDW reports as inserted are added to es_processed if the
+ * ModifyTable sets the command tag.  Returns the number of queued rows that
+ * were not inserted, e.g. because a trigger on the remote side suppressed
+ * them, for callers keeping their own count.
+ */
+int
+ExecForeignInsertFlush(ModifyTableState *mtstate,
+					   ResultRelInfo *resultRelInfo)
+{
+	EState	   *estate = mtstate->ps.state;
+	int			numSlots = resultRelInfo->ri_NumSlots;
+	int			numInserted = numSlots;
+	int			i;
+
+	if (numSlots == 0)
+		return 0;
+
+	(void) resultRelInfo->ri_FdwRoutine->ExecForeignBatchInsert(estate,
+																resultRelInfo,
+																resultRelInfo->ri_Slots,
+																resultRelInfo->ri_PlanSlots,
+																&numInserted);
+
+	if (mtstate->canSetTag)
+		(estate->es_processed) += numInserted;
+
+	for (i = 0; i < numSlots; i++)
+	{
+		ExecClearTuple(resultRelInfo->ri_Slots[i]);
+		if (resultRelInfo->ri_PlanSlots[i] != NULL)
+			ExecClearTuple(resultRelInfo->ri_PlanSlots[i]);
+	}
+	resultRelInfo->ri_NumSlots = 0;
+
+	return numSlots - numInserted;
+}
+
+/*
+ * Limits on how much ExecMultiInsertBuffer queues up per result rel before
+ * writing the rows out; the same as COPY FROM uses.
+ */
+#define MAX_MULTI_INSERT_TUPLES		1000
+#define MAX_MULTI_INSERT_BYTES		65535
+
+/*
+ * ExecMultiInsertCanBatch -- can rows inserted into this heap result rel be
+ * queued up and written with heap_multi_insert?
+ *
+ * The planner has already ruled out RETURNING, WITH CHECK OPTIONs and
+ * volatile functions.  Here we also need no ON CONFLICT, a heap table without
+ * any row-level insert triggers, since a BEFORE trigger could look for the
+ * rows inserted before it and an AFTER trigger wants each row right away,
+ * and without transition tables.  Foreign tables have their own batching.
+ */
+static bool
+ExecMultiInsertCanBatch(ModifyTableState *mtstate,
+						ResultRelInfo *resultRelInfo)
+{
+	ModifyTable *node = (ModifyTable *) mtstate->ps.plan;
+	TriggerDesc *trigdesc = resultRelInfo->ri_TrigDesc;
+	Relation	rel = resultRelInfo->ri_RelationDesc;
+
+	return node->canMultiInsert &&
+		mtstate->operation == CMD_INSERT &&
+		node->onConflictAction == ONCONFLICT_NONE &&
+		mtstate->mt_transition_capture == NULL &&
+		resultRelInfo->ri_FdwRoutine == NULL &&
+		rel->rd_rel->relkind == RELKIND_RELATION &&
+		rel->rd_rel->relam == HEAP_TABLE_AM_OID &&
+		!(trigdesc &&
+		  (trigdesc->trig_insert_before_row ||
+		   trigdesc->trig_insert_after_row ||
+		   trigdesc->trig_insert_instead_row));
+}
+
+/*
+ * ExecMultiInsertBuffer -- queue up a checked tuple for heap_multi_insert
+ *
+ * The tuple is copied, so the caller's slot can be reused right away.  Once
+ * enough rows or bytes are queued for the rel, they are written out.
+ */
+static void
+ExecMultiInsertBuffer(ModifyTableState *mtstate,
+					  ResultRelInfo *resultRelInfo, HeapTuple tuple)
+{
+	EState	   *estate = mtstate->ps.state;
+	MemoryContext oldcontext;
+
+	Assert(ExecMultiInsertCanBatch(mtstate, resultRelInfo));
+
+	oldcontext = MemoryContextSwitchTo(estate->es_query_cxt);
+
+	if (resultRelInfo->ri_BufferedTuples == NULL)
+	{
+		resultRelInfo->ri_BufferedTuples = (HeapTuple *)
+			palloc(sizeof(HeapTuple) * MAX_MULTI_INSERT_TUPLES);
+		resultRelInfo->ri_BufferedSlot =
+			ExecInitExtraTupleSlot(estate,
+								   RelationGetDescr(resultRelInfo->ri_RelationDesc),
+								   &TTSOpsHeapTuple);
+		resultRelInfo->ri_BulkInsertState = GetBulkInsertState();
+		mtstate->mt_multiinsertrels = lappend(mtstate->mt_multiinsertrels,
+											  resultRelInfo);
+	}
+
+	resultRelInfo->ri_BufferedTuples[resultRelInfo->ri_NumBufferedTuples++] =
+		heap_copytuple(tuple);
+	resultRelInfo->ri_BufferedBytes += tuple->t_len;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	if (resultRelInfo->ri_NumBufferedTuples >= MAX_MULTI_INSERT_TUPLES ||
+		resultRelInfo->ri_BufferedBytes >= MAX_MULTI_INSERT_BYTES)
+		ExecMultiInsertFlush(mtstate, resultRelInfo);
+}
+
+/*
+ * ExecMultiInsertFlush -- write out the tuples queued up for a heap result
+ * rel, and insert their index entries
+ */
+static void
+ExecMultiInsertFlush(ModifyTableState *mtstate,
+					 ResultRelInfo *resultRelInfo)
+{
+	EState	   *estate = mtstate->ps.state;
+	ResultRelInfo *saved_resultRelInfo = estate->es_result_relation_info;
+	HeapTuple  *tuples = resultRelInfo->ri_BufferedTuples;
+	int			ntuples = resultRelInfo->ri_NumBufferedTuples;
+	TupleTableSlot *slot = resultRelInfo->ri_BufferedSlot;
+	MemoryContext oldcontext;
+	int			i;
+
+	if (ntuples == 0)
+		return;
+
+	/*
+	 * heap_multi_insert leaks memory, so switch to short-lived memory context
+	 * before calling it.
+	 */
+	oldcontext = MemoryContextSwitchTo(GetPerTupleMemoryContext(estate));
+	heap_multi_insert(resultRelInfo->ri_RelationDesc, tuples, ntuples,
+					  estate->es_output_cid, 0,
+					  resultRelInfo->ri_BulkInsertState);
+	MemoryContextSwitchTo(oldcontext);
+
+	if (mtstate->canSetTag)
+	{
+		(estate->es_processed) += ntuples;
+		setLastTid(&(tuples[ntuples - 1]->t_self));
+	}
+
+	/* The queue may belong to another partition than the current row's */
+	estate->es_result_relation_info = resultRelInfo;
+
+	for (i = 0; i < ntuples; i++)
+	{
+		/*
+		 * There are no deferrable unique constraints to recheck, since those
+		 * would have come with an AFTER ROW trigger.
+		 */
+		if (resultRelInfo->ri_NumIndices > 0)
+		{
+			List	   *recheckIndexes;
+
+			/*
+			 * Index expressions and predicates are evaluated in the
+			 * per-tuple context, so don't let that pile up over the batch.
+			 * The row being inserted, if any, has already been queued up.
+			 */
+			ResetPerTupleExprContext(estate);
+
+			ExecStoreHeapTuple(tuples[i], slot, false);
+			recheckIndexes = ExecInsertIndexTuples(slot, &(tuples[i]->t_self),
+												   estate, false, NULL, NIL,
+												   false);
+			Assert(recheckIndexes == NIL);
+			ExecClearTuple(slot);
+		}
+		heap_freetuple(tuples[i]);
+	}
+
+	estate->es_result_relation_info = saved_resultRelInfo;
+
+	resultRelInfo->ri_NumBufferedTuples = 0;
+	resultRelInfo->ri_BufferedBytes = 0;
+}
+
+/*
+ * Per-row state of a batch of INSERT ... ON CONFLICT rows being flushed
+ */
+typedef struct UpsertBatchEntry
+{
+	int			pos;			/* position in the queue */
+	Datum	   *values;			/* arbiter index key of the row */
+	bool	   *isnull;
+	bool		probed;			/* was the row probed, or left to ExecInsert? */
+	bool		found;			/* if probed, did it find a conflicting row? */
+	ItemPointerData conflictTid;	/* if so, its TID */
+} UpsertBatchEntry;
+
+typedef struct UpsertBatchSortState
+{
+	SortSupport ssup;			/* one per arbiter index key column */
+	int			nkeys;
+} UpsertBatchSortState;
+
+/*
+ * upsert_key_cmp -- compare the arbiter index keys of two UpsertBatchEntrys
+ */
+static int
+upsert_key_cmp(const UpsertBatchEntry *ea, const UpsertBatchEntry *eb,
+			   UpsertBatchSortState *sortstate)
+{
+	int			k;
+
+	for (k = 0; k < sortstate->nkeys; k++)
+	{
+		int			compare;
+
+		compare = ApplySortComparator(ea->values[k], ea->isnull[k],
+									  eb->values[k], eb->isnull[k],
+									  &sortstate->ssup[k]);
+		if (compare != 0)
+			return compare;
+	}
+
+	return 0;
+}
+
+/*
+ * ExecUpsertArbiterIndex -- position of the ON CONFLICT arbiter index among
+ * the result rel's indexes, if it is the only one and a btree; else -1
+ */
+static int
+ExecUpsertArbiterIndex(ResultRelInfo *resultRelInfo)
+{
+	List	   *arbiterIndexes = resultRelInfo->ri_onConflictArbiterIndexes;
+	int			i;
+
+	if (list_length(arbiterIndexes) != 1)
+		return -1;
+
+	for (i = 0; i < resultRelInfo->ri_NumIndices; i++)
+	{
+		Relation	indexRel = resultRelInfo->ri_IndexRelationDescs[i];
+
+		if (RelationGetRelid(indexRel) == linitial_oid(arbiterIndexes))
+			return indexRel->rd_rel->relam == BTREE_AM_OID ? i : -1;
+	}
+
+	return -1;
+}
+
+/*
+ * ExecUpsertCanBatch -- can INSERT ... ON CONFLICT rows for this result rel
+ * be queued up, so that the arbiter index is probed for a batch of them at
+ * a time?
+ *
+ * The pre-check in ExecInsert is only an optimization, so it does no harm
+ * that a probe done for the batch can be out of date by the time a row is
+ * inserted: the speculative insertion still catches any conflict.  What must
+ * not change is the outcome for rows of the batch that conflict with each
+ * other, so we probe only a single btree arbiter index, and leave rows whose
+ * key repeats within the batch to ExecInsert.  And nothing may see the rows
+ * one by one: no RETURNING, WITH CHECK OPTIONs, volatile functions (checked
+ * by the planner), row-level triggers or transition tables.  Tuple routing is
+ * not supported, since every partition has its own arbiter index.
+ */
+static bool
+ExecUpsertCanBatch(ModifyTableState *mtstate, ResultRelInfo *resultRelInfo)
+{
+	ModifyTable *node = (ModifyTable *) mtstate->ps.plan;
+	TriggerDesc *trigdesc = resultRelInfo->ri_TrigDesc;
+
+	return node->canMultiInsert &&
+		mtstate->operation == CMD_INSERT &&
+		node->onConflictAction != ONCONFLICT_NONE &&
+		mtstate->mt_partition_tuple_routing == NULL &&
+		mtstate->mt_transition_capture == NULL &&
+		mtstate->mt_oc_transition_capture == NULL &&
+		resultRelInfo->ri_FdwRoutine == NULL &&
+		!(trigdesc &&
+		  (trigdesc->trig_insert_before_row ||
+		   trigdesc->trig_insert_after_row ||
+		   trigdesc->trig_insert_instead_row ||
+		   trigdesc->trig_update_before_row ||
+		   trigdesc->trig_update_after_row)) &&
+		ExecUpsertArbiterIndex(resultRelInfo) >= 0;
+}
+
+/*
+ * ExecUpsertBuffer -- queue up an INSERT ... ON CONFLICT row
+ *
+ * The row is copied, so the caller's slots can be reused right away.  Once
+ * the queue is full, the batch is probed and inserted.
+ */
+static void
+ExecUpsertBuffer(ModifyTableState *mtstate,
+				 TupleTableSlot *slot, TupleTableSlot *planSlot)
+{
+	EState	   *estate = mtstate->ps.state;
+	MemoryContext oldcontext;
+	int			i = mtstate->mt_upsert_nslots;
+
+	oldcontext = MemoryContextSwitchTo(estate->es_query_cxt);
+
+	if (mtstate->mt_upsert_slots == NULL)
+	{
+		mtstate->mt_upsert_slots = (TupleTableSlot **)
+			palloc(sizeof(TupleTableSlot *) * MAX_MULTI_INSERT_TUPLES);
+		mtstate->mt_upsert_planslots = (TupleTableSlot **)
+			palloc(sizeof(TupleTableSlot *) * MAX_MULTI_INSERT_TUPLES);
+		mtstate->mt_upsert_cxt = AllocSetContextCreate(estate->es_query_cxt,
+													   "ON CONFLICT batch",
+													   ALLOCSET_DEFAULT_SIZES);
+	}
+
+	if (i >= mtstate->mt_upsert_nslots_init)
+	{
+		mtstate->mt_upsert_slots[i] =
+			ExecInitExtraTupleSlot(estate, slot->tts_tupleDescriptor,
+								   &TTSOpsVirtual);
+		mtstate->mt_upsert_planslots[i] =
+			ExecInitExtraTupleSlot(estate, planSlot->tts_tupleDescriptor,
+								   &TTSOpsVirtual);
+		mtstate->mt_upsert_nslots_init++;
+	}
+
+	ExecCopySlot(mtstate->mt_upsert_slots[i], slot);
+	ExecCopySlot(mtstate->mt_upsert_planslots[i], planSlot);
+
+	MemoryContextSwitchTo(oldcontext);
+
+	if (++mtstate->mt_upsert_nslots >= MAX_MULTI_INSERT_TUPLES)
+		ExecUpsertFlush(mtstate);
+}
+
+/*
+ * ExecUpsertFlush -- probe and insert the queued INSERT ... ON CONFLICT rows
+ *
+ * The rows are sorted on the arbiter index key, so that the probes walk the
+ * index in order.  Then ExecInsert is run for each row, in the order the rows
+ * were queued, handing it the probe result so it can skip its own pre-check.
+ * Running the rows in their original order keeps the order in which they are
+ * written, logged and decoded, and which row's error is reported first, the
+ * same as without batching.
+ */
+static void
+ExecUpsertFlush(ModifyTableState *mtstate)
+{
+	EState	   *estate = mtstate->ps.state;
+	ResultRelInfo *resultRelInfo = mtstate->resultRelInfo;
+	ResultRelInfo *saved_resultRelInfo = estate->es_result_relation_info;
+	int			nslots = mtstate->mt_upsert_nslots;
+	int			indexpos;
+	Relation	indexRel;
+	IndexInfo  *indexInfo;
+	TupleDesc	indexDesc;
+	UpsertBatchEntry *entries;
+	UpsertBatchEntry **bypos;
+	UpsertBatchSortState sortstate;
+	MemoryContext oldcontext;
+	int			i;
+	int			k;
+
+	if (nslots == 0)
+		return;
+
+	estate->es_result_relation_info = resultRelInfo;
+
+	indexpos = ExecUpsertArbiterIndex(resultRelInfo);
+	Assert(indexpos >= 0);
+	indexRel = resultRelInfo->ri_IndexRelationDescs[indexpos];
+	indexInfo = resultRelInfo->ri_IndexRelationInfo[indexpos];
+	indexDesc = RelationGetDescr(indexRel);
+
+	oldcontext = MemoryContextSwitchTo(mtstate->mt_upsert_cxt);
+
+	sortstate.nkeys = indexInfo->ii_NumIndexKeyAttrs;
+	sortstate.ssup = (SortSupport)
+		palloc0(sizeof(SortSupportData) * sortstate.nkeys);
+	for (k = 0; k < sortstate.nkeys; k++)
+	{
+		SortSupport ssup = &sortstate.ssup[k];
+		int16		indoption = indexRel->rd_indoption[k];
+
+		ssup->ssup_cxt = mtstate->mt_upsert_cxt;
+		ssup->ssup_collation = indexRel->rd_indcollation[k];
+		ssup->ssup_nulls_first = (indoption & INDOPTION_NULLS_FIRST) != 0;
+		ssup->ssup_attno = k + 1;
+		ssup->abbreviate = false;
+		PrepareSortSupportFromIndexRel(indexRel,
+									   (indoption & INDOPTION_DESC) != 0 ?
+									   BTGreaterStrategyNumber :
+									   BTLessStrategyNumber,
+									   ssup);
+	}
+
+	/* Compute each row's index key, copying it out of per-tuple memory */
+	entries = (UpsertBatchEntry *) palloc(sizeof(UpsertBatchEntry) * nslots);
+	for (i = 0; i < nslots; i++)
+	{
+		TupleTableSlot *slot = mtstate->mt_upsert_slots[i];
+		UpsertBatchEntry *entry = &entries[i];
+		Datum		values[INDEX_MAX_KEYS];
+		bool		isnull[INDEX_MAX_KEYS];
+
+		ResetPerTupleExprContext(estate);
+		GetPerTupleExprContext(estate)->ecxt_scantuple = slot;
+		FormIndexDatum(indexInfo, slot, estate, values, isnull);
+
+		entry->pos = i;
+		entry->values = (Datum *) palloc(sizeof(Datum) * sortstate.nkeys);
+		entry->isnull = (bool *) palloc(sizeof(bool) * sortstate.nkeys);
+		for (k = 0; k < sortstate.nkeys; k++)
+		{
+			Form_pg_attribute att = TupleDescAttr(indexDesc, k);
+
+			entry->isnull[k] = isnull[k];
+			entry->values[k] = isnull[k] ? (Datum) 0 :
+				datumCopy(values[k], att->attbyval, att->attlen);
+		}
+	}
+
+	qsort_arg(entries, nslots, sizeof(UpsertBatchEntry),
+			  upsert_entry_cmp, &sortstate);
+
+	bypos = (UpsertBatchEntry **) palloc(sizeof(UpsertBatchEntry *) * nslots);
+	for (i = 0; i < nslots; i++)
+		bypos[entries[i].pos] = &entries[i];
+
+	MemoryContextSwitchTo(oldcontext);
+
+	/*
+	 * Probe the arbiter index for the whole batch.  A row with the same key
+	 * as an earlier one in the batch will conflict with whatever that row
+	 * inserted or updated, so it is left to ExecInsert to check it in its
+	 * turn.
+	 */
+	for (i = 0; i < nslots; i++)
+	{
+		UpsertBatchEntry *entry = &entries[i];
+
+		if (i > 0 && upsert_key_cmp(&entries[i - 1], entry, &sortstate) == 0)
+		{
+			entry->probed = false;
+			continue;
+		}
+
+		ResetPerTupleExprContext(estate);
+		entry->probed = true;
+		entry->found =
+			!ExecCheckIndexConstraints(mtstate->mt_upsert_slots[entry->pos],
+									   estate, &entry->conflictTid,
+									   resultRelInfo->ri_onConflictArbiterIndexes);
+	}
+
+	/* Now insert or update the rows, in the order they were queued */
+	for (i = 0; i < nslots; i++)
+	{
+		UpsertBatchEntry *entry = bypos[i];
+
+		ResetPerTupleExprContext(estate);
+		mtstate->mt_upsert_probed = entry->probed;
+		mtstate->mt_upsert_found = entry->found;
+		mtstate->mt_upsert_conflictTid = entry->conflictTid;
+		(void) ExecInsert(mtstate,
+						  mtstate->mt_upsert_slots[i],
+						  mtstate->mt_upsert_planslots[i],
+						  estate, mtstate->canSetTag);
+		mtstate->mt_upsert_probed = false;
+	}
+
+	for (i = 0; i < nslots; i++)
+	{
+		ExecClearTuple(mtstate->mt_upsert_slots[i]);
+		ExecClearTuple(mtstate->mt_upsert_planslots[i]);
+	}
+	mtstate->mt_upsert_nslots = 0;
+	MemoryContextReset(mtstate->mt_upsert_cxt);
+
+	estate->es_result_relation_info = saved_resultRelInfo;
+}
+
+/*
+ * qsort_arg comparator for UpsertBatchEntry, on the arbiter index key and
+ * then the original position, so equal keys stay in order
+ */
+static int
+upsert_entry_cmp(const void *a, const void *b, void *arg)
+{
+	const UpsertBatchEntry *ea = (const UpsertBatchEntry *) a;
+	const UpsertBatchEntry *eb = (const UpsertBatchEntry *) b;
+	int			compare;
+
+	compare = upsert_key_cmp(ea, eb, (UpsertBatchSortState *) arg);
+	if (compare != 0)
+		return compare;
+
+	return ea->pos - eb->pos;
+}
+
 /* ----------------------------------------------------------------
  *		ExecInsert
  *
@@ -316,6 +947,18 @@ ExecInsert(ModifyTableState *mtstate,
 	}
 	else if (resultRelInfo->ri_FdwRoutine)
 	{
+		/*
+		 * If the FDW takes rows in batches, just queue this one up; it gets
+		 * sent along with the rest of the batch once that fills up, or at
+		 * the end of the statement.  Nothing downstream needs to see it.
+		 */
+		if (ExecForeignInsertCanBatch(mtstate, resultRelInfo))
+		{
+			(void) ExecForeignInsertBuffer(mtstate, resultRelInfo,
+										   slot, planSlot);
+			return NULL;
+		}
+
 		/*
 		 * insert into foreign table: let the FDW do it
 		 */
@@ -382,12 +1025,24 @@ ExecInsert(ModifyTableState *mtstate,
 			  resultRelInfo->ri_TrigDesc->trig_insert_before_row)))
 			ExecPartitionCheck(resultRelInfo, slot, estate, true);
 
+		/*
+		 * If nothing needs to see this row as it is inserted, just queue it
+		 * up; it gets written out with the rest of the queue once that fills
+		 * up, or at the end of the statement.
+		 */
+		if (ExecMultiInsertCanBatch(mtstate, resultRelInfo))
+		{
+			ExecMultiInsertBuffer(mtstate, resultRelInfo, tuple);
+			return NULL;
+		}
+
 		if (onconflict != ONCONFLICT_NONE && resultRelInfo->ri_NumIndices > 0)
 		{
 			/* Perform a speculative insertion. */
 			uint32		specToken;
 			ItemPointerData conflictTid;
 			bool		specConflict;
+			bool		noConflict;
 			List	   *arbiterIndexes;
 
 			arbiterIndexes = resultRelInfo->ri_onConflictArbiterIndexes;
@@ -406,8 +1061,22 @@ ExecInsert(ModifyTableState *mtstate,
 			 */
 	vlock:
 			specConflict = false;
-			if (!ExecCheckIndexConstraints(slot, estate, &conflictTid,
-										   arbiterIndexes))
+
+			/*
+			 * If ExecUpsertFlush already probed the arbiter index for this
+			 * row, use that result the first time around.
+			 */
+			if (mtstate->mt_upsert_probed)
+			{
+				mtstate->mt_upsert_probed = false;
+				noConflict = !mtstate->mt_upsert_found;
+				conflictTid = mtstate->mt_upsert_conflictTid;
+			}
+			else
+				noConflict = ExecCheckIndexConstraints(slot, estate,
+													   &conflictTid,
+													   arbiterIndexes);
+			if (!noConflict)
 			{
 				/* committed conflict tuple found */
 				if (onconflict == ONCONFLICT_UPDATE)
@@ -451,24 +1120,23 @@ ExecInsert(ModifyTableState *mtstate,
 			 * waiting for the whole transaction to complete.
 			 */
 			specToken = SpeculativeInsertionLockAcquire(GetCurrentTransactionId());
-			HeapTupleHeaderSetSpeculativeToken(tuple->t_data, specToken);
 
 			/* insert the tuple, with the speculative token */
-			heap_insert(resultRelationDesc, tuple,
-						estate->es_output_cid,
-						HEAP_INSERT_SPECULATIVE,
-						NULL);
+			table_tuple_insert_speculative(resultRelationDesc, slot,
+										   estate->es_output_cid,
+										   0,
+										   NULL,
+										   specToken,
+										   &(tuple->t_self));
 
 			/* insert index entries for tuple */
 			recheckIndexes = ExecInsertIndexTuples(slot, &(tuple->t_self),
 												   estate, true, &specConflict,
-												   arbiterIndexes);
+												   arbiterIndexes, false);
 
 			/* adjust the tuple's state accordingly */
-			if (!specConflict)
-				heap_finish_speculative(resultRelationDesc, tuple);
-			else
-				heap_abort_speculative(resultRelationDesc, tuple);
+			table_complete_speculative(resultRelationDesc, &(tuple->t_self),
+									   !specConflict);
 
 			/*
 			 * Wake up anyone waiting for our decision.  They will re-check
@@ -497,18 +1165,18 @@ ExecInsert(ModifyTableState *mtstate,
 			/*
 			 * insert the tuple normally.
 			 *
-			 * Note: heap_insert returns the tid (location) of the new tuple
-			 * in the t_self field.
+			 * Note: the access method returns the tid (location) of the new
+			 * tuple, which we keep in the t_self field.
 			 */
-			heap_insert(resultRelationDesc, tuple,
-						estate->es_output_cid,
-						0, NULL);
+			table_tuple_insert(resultRelationDesc, slot,
+							   estate->es_output_cid,
+							   0, NULL, &(tuple->t_self));
 
 			/* insert index entries for tuple */
 			if (resultRelInfo->ri_NumIndices > 0)
 				recheckIndexes = ExecInsertIndexTuples(slot, &(tuple->t_self),
 													   estate, false, NULL,
-													   NIL);
+													   NIL, false);
 		}
 	}
 
@@ -689,12 +1357,12 @@ ExecDelete(ModifyTableState *mtstate,
 		 * mode transactions.
 		 */
 ldelete:;
-		result = heap_delete(resultRelationDesc, tupleid,
-							 estate->es_output_cid,
-							 estate->es_crosscheck_snapshot,
-							 true /* wait for commit */ ,
-							 &hufd,
-							 changingPart);
+		result = table_delete(resultRelationDesc, tupleid,
+							  estate->es_output_cid,
+							  estate->es_crosscheck_snapshot,
+							  true /* wait for commit */ ,
+							  &hufd,
+							  changingPart);
 		switch (result)
 		{
 			case HeapTupleSelfUpdated:
@@ -992,6 +1660,7 @@ ExecUpdate(ModifyTableState *mtstate,
 	else
 	{
 		LockTupleMode lockmode;
+		TU_UpdateIndexes update_indexes;
 		bool		partition_constraint_failed;
 
 		/*
@@ -1179,11 +1848,12 @@ lreplace:;
 		 * needed for referential integrity updates in transaction-snapshot
 		 * mode transactions.
 		 */
-		result = heap_update(resultRelationDesc, tupleid, tuple,
-							 estate->es_output_cid,
-							 estate->es_crosscheck_snapshot,
-							 true /* wait for commit */ ,
-							 &hufd, &lockmode);
+		result = table_update(resultRelationDesc, tupleid, slot,
+							  estate->es_output_cid,
+							  estate->es_crosscheck_snapshot,
+							  true /* wait for commit */ ,
+							  &hufd, &lockmode, &(tuple->t_self),
+							  &update_indexes);
 		switch (result)
 		{
 			case HeapTupleSelfUpdated:
@@ -1271,14 +1941,17 @@ lreplace:;
 		/*
 		 * insert index entries for tuple
 		 *
-		 * Note: heap_update returns the tid (location) of the new tuple in
-		 * the t_self field.
+		 * Note: the access method returns the tid (location) of the new
+		 * tuple, which we keep in the t_self field.
 		 *
-		 * If it's a HOT update, we mustn't insert new index entries.
+		 * If it's a HOT update, we mustn't insert new index entries, except
+		 * into summarizing indexes whose columns changed; the access method
+		 * tells us so through update_indexes.
 		 */
-		if (resultRelInfo->ri_NumIndices > 0 && !HeapTupleIsHeapOnly(tuple))
+		if (resultRelInfo->ri_NumIndices > 0 && update_indexes != TU_None)
 			recheckIndexes = ExecInsertIndexTuples(slot, &(tuple->t_self),
-												   estate, false, NULL, NIL);
+												   estate, false, NULL, NIL,
+												   update_indexes == TU_Summarizing);
 	}
 
 	if (canSetTag)
@@ -1827,6 +2500,7 @@ ExecModifyTable(PlanState *pstate)
 	ItemPointerData tuple_ctid;
 	HeapTupleData oldtupdata;
 	HeapTuple	oldtuple;
+	ListCell   *lc;
 
 	CHECK_FOR_INTERRUPTS();
 
@@ -2037,6 +2711,13 @@ ExecModifyTable(PlanState *pstate)
 		switch (operation)
 		{
 			case CMD_INSERT:
+				/* Queue up ON CONFLICT rows to probe them in batches */
+				if (ExecUpsertCanBatch(node, resultRelInfo))
+				{
+					ExecUpsertBuffer(node, slot, planSlot);
+					slot = NULL;
+					break;
+				}
 				/* Prepare for tuple routing if needed. */
 				if (proute)
 					slot = ExecPrepareTupleRouting(node, estate, proute,
@@ -2076,6 +2757,17 @@ ExecModifyTable(PlanState *pstate)
 	/* Restore es_result_relation_info before exiting */
 	estate->es_result_relation_info = saved_resultRelInfo;
 
+	/* Insert the ON CONFLICT rows still queued up */
+	ExecUpsertFlush(node);
+
+	/* Write out whatever is still queued up for heap_multi_insert */
+	foreach(lc, node->mt_multiinsertrels)
+		ExecMultiInsertFlush(node, (ResultRelInfo *) lfirst(lc));
+
+	/* Send along whatever is still queued up for batched foreign inserts */
+	foreach(lc, node->mt_batchrels)
+		(void) ExecForeignInsertFlush(node, (ResultRelInfo *) lfirst(lc));
+
 	/*
 	 * We're done, but fire AFTER STATEMENT triggers before exiting.
 	 */
@@ -2204,6 +2896,10 @@ ExecInitModifyTable(ModifyTable *node, EState *estate, int eflags)
 															 fdw_private,
 															 i,
 															 eflags);
+
+			if (operation == CMD_INSERT &&
+				!(eflags & EXEC_FLAG_EXPLAIN_ONLY))
+				ExecSetForeignInsertBatchSize(resultRelInfo);
 		}
 
 		resultRelInfo++;
@@ -2578,6 +3274,18 @@ void
 ExecEndModifyTable(ModifyTableState *node)
 {
 	int			i;
+	ListCell   *lc;
+
+	/*
+	 * Release the bulk-insert state of rels that used heap_multi_insert
+	 */
+	foreach(lc, node->mt_multiinsertrels)
+	{
+		ResultRelInfo *resultRelInfo = (ResultRelInfo *) lfirst(lc);
+
+		FreeBulkInsertState(resultRelInfo->ri_BulkInsertState);
+		resultRelInfo->ri_BulkInsertState = NULL;
+	}
 
 	/*
 	 * Allow any FDWs to shut down
@@ -0,0 +1,763 @@
+/*-------------------------------------------------------------------------
+ *
+ * nodeRedistribute.c
+ *	  Routines to hash-partition tuples among parallel workers.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * A Redistribute node runs in each worker of a parallel query.  It computes
+ * a hash of the key columns of every tuple from its subplan, and sends the
+ * tuple to the worker that the hash value maps to; in exchange, it returns
+ * the tuples sent to it by the other workers, as well as its own tuples that
+ * map to itself.  Nodes above it thus see every row with a given key in the
+ * same worker, so that they can, for example, finalize a partial aggregate
+ * without the leader having to combine the results of all the workers.
+ *
+ * Alternatively, the tuples can be partitioned into ranges of a sort key,
+ * the first worker getting the lowest keys.  The planner supplies a sorted
+ * sample of the key's values, and once the number of workers is known, we
+ * pick the boundaries between their ranges from it.  If each worker then
+ * sorts its rows, the sorted output is simply the concatenation of the
+ * workers' outputs, in order.
+ *
+ * The workers exchange tuples through a square matrix of shared memory
+ * queues, one for each ordered pair of participants.  Since the number of
+ * workers actually launched is not known when the queues are set up, each
+ * worker waits for the leader to announce it before attaching to them; see
+ * ExecParallelWorkersLaunched().  The leader itself must not run the plan,
+ * because it has no queues.  If the plan is executed outside of a worker,
+ * for instance because no workers could be launched, a Redistribute node
+ * just returns the tuples of its subplan.
+ *
+ * All queue operations are non-blocking.  A worker that cannot send a tuple
+ * keeps it, and keeps reading its incoming queues while it waits, so that no
+ * pair of workers can end up waiting for each other.
+ *
+ * IDENTIFICATION
+ *	  src/backend/executor/nodeRedistribute.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "access/htup_details.h"
+#include "access/parallel.h"
+#include "executor/executor.h"
+#include "executor/nodeRedistribute.h"
+#include "executor/tqueue.h"
+#include "miscadmin.h"
+#include "pgstat.h"
+#include "storage/condition_variable.h"
+#include "storage/shm_mq.h"
+#include "storage/spin.h"
+#include "utils/hashutils.h"
+#include "utils/sortsupport.h"
+
+
+/* Size of each queue between two participants */
+#define REDISTRIBUTE_QUEUE_SIZE		32768
+
+/*
+ * Shared state for a Redistribute node.  It is followed by the queues;
+ * the queue from participant s to participant d is the
+ * (s * maxparticipants + d)'th one.
+ */
+typedef struct ParallelRedistributeState
+{
+	slock_t		mutex;			/* protects nparticipants */
+	ConditionVariable cv;		/* signaled when nparticipants is set */
+	int			nparticipants;	/* number of workers launched, or -1 */
+	int			maxparticipants;	/* number of workers planned */
+} ParallelRedistributeState;
+
+#define RedistributeQueue(pstate, src, dst) \
+	((shm_mq *) ((char *) (pstate) + \
+				 MAXALIGN(sizeof(ParallelRedistributeState)) + \
+				 ((Size) (src) * (pstate)->maxparticipants + (dst)) * \
+				 REDISTRIBUTE_QUEUE_SIZE))
+
+static TupleTableSlot *ExecRedistribute(PlanState *pstate);
+static Size redistribute_shared_size(int nworkers);
+static void redistribute_create_queues(ParallelRedistributeState *pstate);
+static void redistribute_attach(RedistributeState *node);
+static void redistribute_detach_senders(RedistributeState *node);
+static HeapTuple redistribute_readnext(RedistributeState *node);
+static bool redistribute_send(RedistributeState *node, int dest,
+				  HeapTuple tuple);
+static bool redistribute_flush(RedistributeState *node);
+static int	redistribute_destination(RedistributeState *node,
+						 TupleTableSlot *slot);
+static int	redistribute_range_destination(RedistributeState *node,
+							   TupleTableSlot *slot);
+static void redistribute_choose_splitters(RedistributeState *node);
+
+
+/* ----------------------------------------------------------------
+ *		ExecRedistribute
+ * ----------------------------------------------------------------
+ */
+static TupleTableSlot *
+ExecRedistribute(PlanState *pstate)
+{
+	RedistributeState *node = castNode(RedistributeState, pstate);
+	PlanState  *outerNode = outerPlanState(node);
+
+	CHECK_FOR_INTERRUPTS();
+
+	/* Outside of a worker, there's nobody to exchange tuples with. */
+	if (!node->am_worker)
+		return ExecProcNode(outerNode);
+
+	if (!node->initialized)
+		redistribute_attach(node);
+
+	/*
+	 * Reset per-tuple memory context to free any expression evaluation
+	 * storage allocated in the previous tuple cycle, including the tuple we
+	 * returned last time, if it came from another worker.
+	 */
+	ResetExprContext(node->ps.ps_ExprContext);
+
+	for (;;)
+	{
+		bool		progress = false;
+		HeapTuple	tup;
+
+		CHECK_FOR_INTERRUPTS();
+
+		/* Return a tuple sent to us by another worker, if one is ready. */
+		if (node->nreaders > 0)
+		{
+			MemoryContext oldContext;
+
+			oldContext =
+				MemoryContextSwitchTo(node->ps.ps_ExprContext->ecxt_per_tuple_memory);
+			tup = redistribute_readnext(node);
+			MemoryContextSwitchTo(oldContext);
+
+			if (HeapTupleIsValid(tup))
+				return ExecStoreHeapTuple(tup, node->funnel_slot, false);
+		}
+
+		/* Try again to send the tuples that didn't fit last time. */
+		if (node->npending > 0)
+			progress = redistribute_flush(node);
+
+		/* Read more tuples from the subplan only once those are sent. */
+		if (!node->outer_done && node->npending == 0)
+		{
+			TupleTableSlot *slot = ExecProcNode(outerNode);
+			int			dest;
+			bool		should_free;
+
+			if (TupIsNull(slot))
+			{
+				node->outer_done = true;
+				continue;
+			}
+
+			dest = redistribute_destination(node, slot);
+			if (dest == node->myindex)
+				return slot;
+
+			tup = ExecFetchSlotHeapTuple(slot, false, &should_free);
+			if (!redistribute_send(node, dest, tup))
+			{
+				/* Keep it until the queue has room again. */
+				node->pending[dest] = should_free ? tup : heap_copytuple(tup);
+				node->npending++;
+			}
+			else if (should_free)
+				heap_freetuple(tup);
+			continue;
+		}
+
+		/* Tell the other workers when we won't send them any more tuples. */
+		if (node->outer_done && node->npending == 0)
+		{
+			redistribute_detach_senders(node);
+			if (node->nreaders == 0)
+				return NULL;
+		}
+
+		/* Nothing to do until some other worker gets further. */
+		if (!progress)
+		{
+			(void) WaitLatch(MyLatch, WL_LATCH_SET | WL_EXIT_ON_PM_DEATH, 0,
+							 WAIT_EVENT_REDISTRIBUTE_EXCHANGE);
+			ResetLatch(MyLatch);
+		}
+	}
+}
+
+/*
+ * Compute the participant a tuple belongs to, from the hash of its key
+ * columns.  This combines the per-column hash values the same way as
+ * TupleHashTableHash(), except that we start from zero.
+ */
+static int
+redistribute_destination(RedistributeState *node, TupleTableSlot *slot)
+{
+	Redistribute *plan = (Redistribute *) node->ps.plan;
+	MemoryContext oldContext;
+	uint32		hashkey = 0;
+	int			i;
+
+	if (node->nparticipants == 1)
+		return 0;
+
+	if (plan->numCols == 0)
+		return redistribute_range_destination(node, slot);
+
+	oldContext =
+		MemoryContextSwitchTo(node->ps.ps_ExprContext->ecxt_per_tuple_memory);
+
+	for (i = 0; i < plan->numCols; i++)
+	{
+		Datum		attr;
+		bool		isNull;
+
+		/* rotate hashkey left 1 bit at each step */
+		hashkey = (hashkey << 1) | ((hashkey & 0x80000000) ? 1 : 0);
+
+		attr = slot_getattr(slot, plan->hashColIdx[i], &isNull);
+
+		if (!isNull)			/* treat nulls as having hash key 0 */
+			hashkey ^= DatumGetUInt32(FunctionCall1(&node->hashfunctions[i],
+													attr));
+	}
+
+	MemoryContextSwitchTo(oldContext);
+
+	/*
+	 * The low-order bits of some hash functions are poorly distributed for
+	 * small inputs, so mix the bits once more before taking the modulus.
+	 */
+	hashkey = murmurhash32(hashkey);
+
+	return hashkey % (uint32) node->nparticipants;
+}
+
+/*
+ * Compute the participant a tuple belongs to, by binary search for the
+ * number of range boundaries that sort before its key.  Participant i gets
+ * the keys greater than splitters[i - 1] and not greater than splitters[i].
+ */
+static int
+redistribute_range_destination(RedistributeState *node, TupleTableSlot *slot)
+{
+	Redistribute *plan = (Redistribute *) node->ps.plan;
+	Datum		key;
+	bool		isNull;
+	int			lo = 0;
+	int			hi = node->nsplitters;
+
+	key = slot_getattr(slot, plan->rangeColIdx, &isNull);
+
+	while (lo < hi)
+	{
+		int			mid = (lo + hi) / 2;
+
+		if (ApplySortComparator(node->splitters[mid], false,
+								key, isNull,
+								node->rangesortkey) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+/*
+ * Choose the boundaries between the participants' ranges, so that each gets
+ * about the same share of the planner's sample of the key values.
+ */
+static void
+redistribute_choose_splitters(RedistributeState *node)
+{
+	Redistribute *plan = (Redistribute *) node->ps.plan;
+	int			nbounds = list_length(plan->rangeBounds);
+	int			n = node->nparticipants;
+	int			i;
+
+	Assert(nbounds > 0);
+
+	node->nsplitters = n - 1;
+	node->splitters = (Datum *) palloc(Max(n - 1, 1) * sizeof(Datum));
+
+	for (i = 1; i < n; i++)
+	{
+		int			pos = (i * (nbounds - 1) + n / 2) / n;
+		Const	   *bound = (Const *) list_nth(plan->rangeBounds, pos);
+
+		Assert(!bound->constisnull);
+		node->splitters[i - 1] = bound->constvalue;
+	}
+}
+
+/*
+ * Try to send a tuple to the given participant, without waiting.  Returns
+ * false if it has to be tried again later, with exactly the same tuple.
+ *
+ * If the participant has stopped reading, the tuple is silently dropped.
+ */
+static bool
+redistribute_send(RedistributeState *node, int dest, HeapTuple tuple)
+{
+	shm_mq_result result;
+
+	result = shm_mq_send(node->senders[dest], tuple->t_len, tuple->t_data,
+						 true);
+
+	return (result != SHM_MQ_WOULD_BLOCK);
+}
+
+/*
+ * Try again to send the pending tuples.  Returns true if any got sent.
+ */
+static bool
+redistribute_flush(RedistributeState *node)
+{
+	bool		progress = false;
+	int			dest;
+
+	for (dest = 0; dest < node->nparticipants; dest++)
+	{
+		HeapTuple	tup = node->pending[dest];
+
+		if (tup == NULL)
+			continue;
+
+		if (redistribute_send(node, dest, tup))
+		{
+			heap_freetuple(tup);
+			node->pending[dest] = NULL;
+			node->npending--;
+			progress = true;
+		}
+	}
+
+	return progress;
+}
+
+/*
+ * Try to read a tuple from the incoming queues, without waiting.
+ *
+ * Each queue is tried in turn, starting after the one read last time.  Like
+ * gather_readnext(), this removes the queues of the senders that have
+ * finished from the array of active ones.
+ */
+static HeapTuple
+redistribute_readnext(RedistributeState *node)
+{
+	int			nvisited = 0;
+
+	while (node->nreaders > 0 && nvisited < node->nreaders)
+	{
+		TupleQueueReader *reader = node->readers[node->nextreader];
+		HeapTuple	tup;
+		bool		readerdone;
+
+		tup = TupleQueueReaderNext(reader, true, &readerdone);
+
+		if (readerdone)
+		{
+			Assert(!tup);
+			DestroyTupleQueueReader(reader);
+			shm_mq_detach(node->receivers[node->nextreader]);
+			--node->nreaders;
+			memmove(&node->readers[node->nextreader],
+					&node->readers[node->nextreader + 1],
+					sizeof(TupleQueueReader *) * (node->nreaders - node->nextreader));
+			memmove(&node->receivers[node->nextreader],
+					&node->receivers[node->nextreader + 1],
+					sizeof(shm_mq_handle *) * (node->nreaders - node->nextreader));
+			if (node->nextreader >= node->nreaders)
+				node->nextreader = 0;
+			continue;
+		}
+
+		/* Advance nextreader, so that the queues are read fairly. */
+		node->nextreader++;
+		if (node->nextreader >= node->nreaders)
+			node->nextreader = 0;
+
+		if (tup)
+			return tup;
+
+		nvisited++;
+	}
+
+	return NULL;
+}
+
+/*
+ * Wait until the leader has told us how many workers participate, and then
+ * attach to our outgoing and incoming queues.
+ */
+static void
+redistribute_attach(RedistributeState *node)
+{
+	ParallelRedistributeState *pstate = node->pstate;
+	MemoryContext oldContext;
+	int			nparticipants;
+	int			i;
+
+	for (;;)
+	{
+		SpinLockAcquire(&pstate->mutex);
+		nparticipants = pstate->nparticipants;
+		SpinLockRelease(&pstate->mutex);
+
+		if (nparticipants >= 0)
+			break;
+		ConditionVariableSleep(&pstate->cv, WAIT_EVENT_REDISTRIBUTE_START);
+	}
+	ConditionVariableCancelSleep();
+
+	Assert(ParallelWorkerNumber >= 0 && ParallelWorkerNumber < nparticipants);
+
+	oldContext = MemoryContextSwitchTo(node->ps.state->es_query_cxt);
+
+	node->nparticipants = nparticipants;
+	node->myindex = ParallelWorkerNumber;
+	node->senders = (shm_mq_handle **)
+		palloc0(nparticipants * sizeof(shm_mq_handle *));
+	node->pending = (HeapTuple *) palloc0(nparticipants * sizeof(HeapTuple));
+	node->npending = 0;
+	node->receivers = (shm_mq_handle **)
+		palloc(nparticipants * sizeof(shm_mq_handle *));
+	node->readers = (TupleQueueReader **)
+		palloc(nparticipants * sizeof(TupleQueueReader *));
+	node->nreaders = 0;
+	node->nextreader = 0;
+
+	if (((Redistribute *) node->ps.plan)->numCols == 0)
+		redistribute_choose_splitters(node);
+
+	for (i = 0; i < nparticipants; i++)
+	{
+		shm_mq	   *mq;
+		shm_mq_handle *mqh;
+
+		if (i == node->myindex)
+			continue;
+
+		mq = RedistributeQueue(pstate, node->myindex, i);
+		shm_mq_set_sender(mq, MyProc);
+		node->senders[i] = shm_mq_attach(mq, node->seg, NULL);
+
+		mq = RedistributeQueue(pstate, i, node->myindex);
+		shm_mq_set_receiver(mq, MyProc);
+		mqh = shm_mq_attach(mq, node->seg, NULL);
+		node->receivers[node->nreaders] = mqh;
+		node->readers[node->nreaders] = CreateTupleQueueReader(mqh);
+		node->nreaders++;
+	}
+
+	MemoryContextSwitchTo(oldContext);
+
+	node->initialized = true;
+}
+
+/*
+ * Detach from our outgoing queues, so that the receivers know that we are
+ * done, and forget any tuples we could not send.
+ */
+static void
+redistribute_detach_senders(RedistributeState *node)
+{
+	int			i;
+
+	for (i = 0; i < node->nparticipants; i++)
+	{
+		if (node->senders[i] != NULL)
+		{
+			shm_mq_detach(node->senders[i]);
+			node->senders[i] = NULL;
+		}
+		if (node->pending[i] != NULL)
+		{
+			heap_freetuple(node->pending[i]);
+			node->pending[i] = NULL;
+		}
+	}
+	node->npending = 0;
+}
+
+/* ----------------------------------------------------------------
+ *		ExecInitRedistribute
+ * ----------------------------------------------------------------
+ */
+RedistributeState *
+ExecInitRedistribute(Redistribute *node, EState *estate, int eflags)
+{
+	RedistributeState *rstate;
+	Oid		   *eqfuncoids;
+
+	/* check for unsupported flags */
+	Assert(!(eflags & (EXEC_FLAG_BACKWARD | EXEC_FLAG_MARK)));
+
+	/*
+	 * create state structure
+	 */
+	rstate = makeNode(RedistributeState);
+	rstate->ps.plan = (Plan *) node;
+	rstate->ps.state = estate;
+	rstate->ps.ExecProcNode = ExecRedistribute;
+
+	rstate->pstate = NULL;
+	rstate->am_worker = false;
+	rstate->initialized = false;
+	rstate->outer_done = false;
+
+	/*
+	 * Miscellaneous initialization
+	 *
+	 * create expression context for node, used to compute the hash values
+	 * and to hold the tuples received from other workers
+	 */
+	ExecAssignExprContext(estate, &rstate->ps);
+
+	/*
+	 * initialize child nodes
+	 */
+	outerPlanState(rstate) = ExecInitNode(outerPlan(node), estate, eflags);
+
+	/*
+	 * Initialize result type.  We return either the subplan's slot or our
+	 * funnel slot, so the result slot type isn't fixed.  No projection is
+	 * done.
+	 */
+	ExecInitResultTypeTL(&rstate->ps);
+	rstate->ps.resultopsset = true;
+	rstate->ps.resultopsfixed = false;
+	rstate->ps.ps_ProjInfo = NULL;
+
+	rstate->funnel_slot = ExecInitExtraTupleSlot(estate,
+												 ExecGetResultType(&rstate->ps),
+												 &TTSOpsHeapTuple);
+
+	if (node->numCols > 0)
+	{
+		/* Look up the hash functions of the key columns */
+		execTuplesHashPrepare(node->numCols, node->hashOperators,
+							  &eqfuncoids, &rstate->hashfunctions);
+	}
+	else
+	{
+		/* Set up the comparator for the range key */
+		SortSupport sortKey = (SortSupport) palloc0(sizeof(SortSupportData));
+
+		sortKey->ssup_cxt = CurrentMemoryContext;
+		sortKey->ssup_collation = node->rangeCollation;
+		sortKey->ssup_nulls_first = node->rangeNullsFirst;
+		sortKey->ssup_attno = node->rangeColIdx;
+		sortKey->abbreviate = false;
+
+		PrepareSortSupportFromOrderingOp(node->rangeSortOp, sortKey);
+		rstate->rangesortkey = sortKey;
+	}
+
+	return rstate;
+}
+
+/* ----------------------------------------------------------------
+ *		ExecEndRedistribute
+ * ----------------------------------------------------------------
+ */
+void
+ExecEndRedistribute(RedistributeState *node)
+{
+	ExecShutdownRedistribute(node);
+	ExecFreeExprContext(&node->ps);
+	ExecClearTuple(node->funnel_slot);
+	ExecEndNode(outerPlanState(node));
+}
+
+/* ----------------------------------------------------------------
+ *		ExecShutdownRedistribute
+ *
+ *		Detach from all the queues, so that no other worker waits for us.
+ *		If we never attached, we must still wait until we know which
+ *		queues are ours, and attach to them just to detach again.
+ * ----------------------------------------------------------------
+ */
+void
+ExecShutdownRedistribute(RedistributeState *node)
+{
+	int			i;
+
+	if (!node->am_worker || node->pstate == NULL)
+		return;
+
+	if (!node->initialized)
+		redistribute_attach(node);
+
+	node->outer_done = true;
+	redistribute_detach_senders(node);
+
+	for (i = 0; i < node->nreaders; i++)
+	{
+		DestroyTupleQueueReader(node->readers[i]);
+		shm_mq_detach(node->receivers[i]);
+	}
+	node->nreaders = 0;
+}
+
+/* ----------------------------------------------------------------
+ *		ExecReScanRedistribute
+ * ----------------------------------------------------------------
+ */
+void
+ExecReScanRedistribute(RedistributeState *node)
+{
+	PlanState  *outerPlan = outerPlanState(node);
+
+	/* A worker's queues can only be used once. */
+	if (node->am_worker)
+		elog(ERROR, "cannot rescan a Redistribute node in a parallel worker");
+
+	/*
+	 * If chgParam of subnode is not null then plan will be re-scanned by
+	 * first ExecProcNode.
+	 */
+	if (outerPlan->chgParam == NULL)
+		ExecReScan(outerPlan);
+}
+
+/* ----------------------------------------------------------------
+ *						Parallel Query Support
+ * ----------------------------------------------------------------
+ */
+
+/* Size of the shared state for the given number of workers */
+static Size
+redistribute_shared_size(int nworkers)
+{
+	return add_size(MAXALIGN(sizeof(ParallelRedistributeState)),
+					mul_size(mul_size(nworkers, nworkers),
+							 REDISTRIBUTE_QUEUE_SIZE));
+}
+
+/* (Re)create all the queues, and forget the number of participants */
+static void
+redistribute_create_queues(ParallelRedistributeState *pstate)
+{
+	int			src;
+	int			dst;
+
+	pstate->nparticipants = -1;
+
+	for (src = 0; src < pstate->maxparticipants; src++)
+	{
+		for (dst = 0; dst < pstate->maxparticipants; dst++)
+		{
+			if (src != dst)
+				(void) shm_mq_create(RedistributeQueue(pstate, src, dst),
+									 REDISTRIBUTE_QUEUE_SIZE);
+		}
+	}
+}
+
+/* ----------------------------------------------------------------
+ *		ExecRedistributeEstimate
+ *
+ *		Estimate space required for the queues.
+ * ----------------------------------------------------------------
+ */
+void
+ExecRedistributeEstimate(RedistributeState *node, ParallelContext *pcxt)
+{
+	/* don't need this if no workers */
+	if (pcxt->nworkers == 0)
+		return;
+
+	shm_toc_estimate_chunk(&pcxt->estimator,
+						   redistribute_shared_size(pcxt->nworkers));
+	shm_toc_estimate_keys(&pcxt->estimator, 1);
+}
+
+/* ----------------------------------------------------------------
+ *		ExecRedistributeInitializeDSM
+ *
+ *		Set up the shared state and the queues.
+ * ----------------------------------------------------------------
+ */
+void
+ExecRedistributeInitializeDSM(RedistributeState *node, ParallelContext *pcxt)
+{
+	ParallelRedistributeState *pstate;
+
+	/* don't need this if no workers */
+	if (pcxt->nworkers == 0)
+		return;
+
+	pstate = shm_toc_allocate(pcxt->toc,
+							  redistribute_shared_size(pcxt->nworkers));
+	SpinLockInit(&pstate->mutex);
+	ConditionVariableInit(&pstate->cv);
+	pstate->maxparticipants = pcxt->nworkers;
+	redistribute_create_queues(pstate);
+
+	shm_toc_insert(pcxt->toc, node->ps.plan->plan_node_id, pstate);
+	node->pstate = pstate;
+}
+
+/* ----------------------------------------------------------------
+ *		ExecRedistributeReInitializeDSM
+ *
+ *		Reset the queues before launching a fresh batch of workers.
+ * ----------------------------------------------------------------
+ */
+void
+ExecRedistributeReInitializeDSM(RedistributeState *node,
+								ParallelContext *pcxt)
+{
+	if (node->pstate == NULL)
+		return;
+
+	redistribute_create_queues(node->pstate);
+}
+
+/* ----------------------------------------------------------------
+ *		ExecRedistributeSetParticipants
+ *
+ *		Tell the workers how many of them were launched.  Called by the
+ *		leader via ExecParallelWorkersLaunched().
+ * ----------------------------------------------------------------
+ */
+void
+ExecRedistributeSetParticipants(RedistributeState *node,
+								ParallelContext *pcxt)
+{
+	ParallelRedistributeState *pstate = node->pstate;
+
+	if (pstate == NULL)
+		return;
+
+	SpinLockAcquire(&pstate->mutex);
+	pstate->nparticipants = pcxt->nworkers_launched;
+	SpinLockRelease(&pstate->mutex);
+
+	ConditionVariableBroadcast(&pstate->cv);
+}
+
+/* ----------------------------------------------------------------
+ *		ExecRedistributeInitializeWorker
+ *
+ *		Find the shared state in a worker.
+ * ----------------------------------------------------------------
+ */
+void
+ExecRedistributeInitializeWorker(RedistributeState *node,
+								 ParallelWorkerContext *pwcxt)
+{
+	node->pstate = shm_toc_lookup(pwcxt->toc, node->ps.plan->plan_node_id,
+								  false);
+	node->seg = pwcxt->seg;
+	node->am_worker = true;
+}
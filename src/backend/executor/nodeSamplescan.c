@@ -48,6 +48,7 @@ SampleNext(SampleScanState *node)
 {
 	HeapTuple	tuple;
 	TupleTableSlot *slot;
+	HeapScanDesc hscan;
 
 	/*
 	 * if this is first call within a scan, initialize
@@ -61,11 +62,12 @@ SampleNext(SampleScanState *node)
 	tuple = tablesample_getnext(node);
 
 	slot = node->ss.ss_ScanTupleSlot;
+	hscan = (HeapScanDesc) node->ss.ss_currentScanDesc;
 
 	if (tuple)
 		ExecStoreBufferHeapTuple(tuple, /* tuple to store */
 								 slot,	/* slot to store in */
-								 node->ss.ss_currentScanDesc->rs_cbuf); /* tuple's buffer */
+								 hscan->rs_cbuf);	/* tuple's buffer */
 	else
 		ExecClearTuple(slot);
 
@@ -219,7 +221,7 @@ ExecEndSampleScan(SampleScanState *node)
 	 * close heap scan
 	 */
 	if (node->ss.ss_currentScanDesc)
-		heap_endscan(node->ss.ss_currentScanDesc);
+		heap_endscan((HeapScanDesc) node->ss.ss_currentScanDesc);
 }
 
 /* ----------------------------------------------------------------
@@ -318,7 +320,7 @@ tablesample_init(SampleScanState *scanstate)
 	/* Now we can create or reset the HeapScanDesc */
 	if (scanstate->ss.ss_currentScanDesc == NULL)
 	{
-		scanstate->ss.ss_currentScanDesc =
+		scanstate->ss.ss_currentScanDesc = (TableScanDesc)
 			heap_beginscan_sampling(scanstate->ss.ss_currentRelation,
 									scanstate->ss.ps.state->es_snapshot,
 									0, NULL,
@@ -328,7 +330,8 @@ tablesample_init(SampleScanState *scanstate)
 	}
 	else
 	{
-		heap_rescan_set_params(scanstate->ss.ss_currentScanDesc, NULL,
+		heap_rescan_set_params((HeapScanDesc) scanstate->ss.ss_currentScanDesc,
+							   NULL,
 							   scanstate->use_bulkread,
 							   allow_sync,
 							   scanstate->use_pagemode);
@@ -350,9 +353,9 @@ static HeapTuple
 tablesample_getnext(SampleScanState *scanstate)
 {
 	TsmRoutine *tsm = scanstate->tsmroutine;
-	HeapScanDesc scan = scanstate->ss.ss_currentScanDesc;
+	HeapScanDesc scan = (HeapScanDesc) scanstate->ss.ss_currentScanDesc;
 	HeapTuple	tuple = &(scan->rs_ctup);
-	Snapshot	snapshot = scan->rs_snapshot;
+	Snapshot	snapshot = scan->rs_base.rs_snapshot;
 	bool		pagemode = scan->rs_pageatatime;
 	BlockNumber blockno;
 	Page		page;
@@ -435,7 +438,7 @@ tablesample_getnext(SampleScanState *scanstate)
 
 			/* in pagemode, heapgetpage did this for us */
 			if (!pagemode)
-				CheckForSerializableConflictOut(visible, scan->rs_rd, tuple,
+				CheckForSerializableConflictOut(visible, scan->rs_base.rs_rd, tuple,
 												scan->rs_cbuf, snapshot);
 
 			if (visible)
@@ -483,7 +486,7 @@ tablesample_getnext(SampleScanState *scanstate)
 			 * We don't guarantee any specific ordering in general, though.
 			 */
 			if (scan->rs_syncscan)
-				ss_report_location(scan->rs_rd, blockno);
+				ss_report_location(scan->rs_base.rs_rd, blockno);
 
 			finished = (blockno == scan->rs_startblock);
 		}
@@ -515,7 +518,7 @@ tablesample_getnext(SampleScanState *scanstate)
 	}
 
 	/* Count successfully-fetched tuples as heap fetches */
-	pgstat_count_heap_getnext(scan->rs_rd);
+	pgstat_count_heap_getnext(scan->rs_base.rs_rd);
 
 	return &(scan->rs_ctup);
 }
@@ -559,7 +562,7 @@ SampleTupleVisible(HeapTuple tuple, OffsetNumber tupoffset, HeapScanDesc scan)
 	{
 		/* Otherwise, we have to check the tuple individually. */
 		return HeapTupleSatisfiesVisibility(tuple,
-											scan->rs_snapshot,
+											scan->rs_base.rs_snapshot,
 											scan->rs_cbuf);
 	}
 }
@@ -67,6 +67,7 @@ ExecSort(PlanState *pstate)
 		Sort	   *plannode = (Sort *) node->ss.ps.plan;
 		PlanState  *outerNode;
 		TupleDesc	tupDesc;
+		double		ntuples = 0;
 
 		SO1_printf("ExecSort: %s\n",
 				   "sorting subplan");
@@ -110,8 +111,12 @@ ExecSort(PlanState *pstate)
 				break;
 
 			tuplesort_puttupleslot(tuplesortstate, slot);
+			ntuples += 1;
 		}
 
+		ExecCheckRowEstimate(&node->ss.ps, "Sort",
+							 outerNode->plan->plan_rows, ntuples);
+
 		/*
 		 * Complete the sort.
 		 */
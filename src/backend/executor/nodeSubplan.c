@@ -23,23 +23,99 @@
  *	 INTERFACE ROUTINES
  *		ExecSubPlan  - process a subselect
  *		ExecInitSubPlan - initialize a subselect
+ *		ExecSubPlanEstimate - estimate DSM space for a shared hash table
+ *		ExecSubPlanInitializeDSM - set up a shared hash table
+ *		ExecSubPlanInitializeWorker - attach to a shared hash table
  */
 #include "postgres.h"
 
 #include <limits.h>
 #include <math.h>
 
+#include "access/hash.h"
 #include "access/htup_details.h"
 #include "executor/executor.h"
 #include "executor/nodeSubplan.h"
 #include "nodes/makefuncs.h"
 #include "miscadmin.h"
 #include "optimizer/clauses.h"
+#include "pgstat.h"
+#include "storage/condition_variable.h"
+#include "storage/spin.h"
 #include "utils/array.h"
+#include "utils/dsa.h"
+#include "utils/dynahash.h"
+#include "utils/hashutils.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 
 
+/*
+ * Shared hash tables for hashed SubPlans in parallel query.
+ *
+ * A hashed subplan whose plan has no external parameters produces the same
+ * table every time it is evaluated, so there is no point in having every
+ * participant of a parallel query run the subplan and build a private copy.
+ * Instead the first participant to need the table builds it in the query's
+ * DSA area, and everyone else waits for it to be completed and then probes
+ * it read-only.  The control structure lives in the DSM segment, keyed by
+ * plan_id so that SubPlanStates sharing a subplan also share its table.
+ *
+ * Each table is a power-of-two array of bucket heads, each heading a chain
+ * of entries.  An entry is a SubPlanHashEntry header followed by the
+ * projected subplan row in MinimalTuple format.  Entries are carved out of
+ * larger chunks to keep DSA allocation overhead down.
+ */
+#define PARALLEL_KEY_SUBPLAN_HASH(plan_id) \
+	(UINT64CONST(0xE000000100000000) + (plan_id))
+
+#define SUBPLAN_HASH_CHUNK_SIZE		(32 * 1024)
+#define SUBPLAN_HASH_MAX_BUCKETS	(1 << 30)
+
+typedef enum SubPlanHashStatus
+{
+	SUBPLAN_HASH_EMPTY,			/* nobody has started building it */
+	SUBPLAN_HASH_BUILDING,		/* one participant is building it */
+	SUBPLAN_HASH_READY			/* complete and ready to be probed */
+} SubPlanHashStatus;
+
+typedef struct SubPlanSharedTable
+{
+	dsa_pointer buckets;		/* array of nbuckets dsa_pointers */
+	uint32		nbuckets;		/* always a power of 2 */
+	uint32		ntuples;		/* number of entries stored */
+} SubPlanSharedTable;
+
+typedef struct SubPlanHashShared
+{
+	slock_t		mutex;			/* protects status */
+	SubPlanHashStatus status;
+	ConditionVariable cv;		/* signaled when status becomes READY */
+	SubPlanSharedTable hashtable;	/* rows without nulls */
+	SubPlanSharedTable hashnulls;	/* rows with null(s), if wanted */
+	bool		havehashrows;	/* true if hashtable is not empty */
+	bool		havenullrows;	/* true if hashnulls is not empty */
+} SubPlanHashShared;
+
+typedef struct SubPlanHashEntry
+{
+	dsa_pointer next;			/* next entry in same bucket */
+	uint32		hash;			/* hash value of the row */
+	/* MinimalTuple follows, MAXALIGN'd */
+} SubPlanHashEntry;
+
+#define SUBPLAN_HASH_ENTRY_HEADER_SIZE MAXALIGN(sizeof(SubPlanHashEntry))
+#define SubPlanHashEntryTuple(entry) \
+	((MinimalTuple) ((char *) (entry) + SUBPLAN_HASH_ENTRY_HEADER_SIZE))
+
+/* builder's private state for carving entries out of chunks */
+typedef struct SubPlanHashChunkState
+{
+	dsa_pointer chunk;			/* current chunk, or InvalidDsaPointer */
+	Size		used;			/* bytes used in current chunk */
+} SubPlanHashChunkState;
+
+
 static Datum ExecHashSubPlan(SubPlanState *node,
 				ExprContext *econtext,
 				bool *isNull);
@@ -49,6 +125,26 @@ static Datum ExecScanSubPlan(SubPlanState *node,
 static void buildSubPlanHash(SubPlanState *node, ExprContext *econtext);
 static bool findPartialMatch(TupleHashTable hashtable, TupleTableSlot *slot,
 				 FmgrInfo *eqfunctions);
+static bool lookupExactMatch(SubPlanState *node, TupleTableSlot *slot);
+static bool lookupPartialMatch(SubPlanState *node, bool nullrows,
+				   TupleTableSlot *slot);
+static void attachSharedSubPlanHash(SubPlanState *node, ExprContext *econtext);
+static void buildSharedSubPlanHash(SubPlanState *node, ExprContext *econtext);
+static void sharedHashInitTable(dsa_area *area, SubPlanSharedTable *table,
+					long nbuckets);
+static void sharedHashInsert(SubPlanState *node, dsa_area *area,
+				 SubPlanSharedTable *table, SubPlanHashChunkState *cs,
+				 TupleTableSlot *slot);
+static void sharedHashGrow(dsa_area *area, SubPlanSharedTable *table);
+static uint32 sharedHashRow(SubPlanState *node, TupleTableSlot *slot,
+			  FmgrInfo *hashfunctions);
+static bool sharedTuplesMatch(TupleTableSlot *slot1, TupleTableSlot *slot2,
+				  int numCols, AttrNumber *matchColIdx,
+				  FmgrInfo *eqfunctions, MemoryContext evalContext);
+static bool findSharedExactMatch(SubPlanState *node, TupleTableSlot *slot);
+static bool findSharedPartialMatch(SubPlanState *node,
+					   SubPlanSharedTable *table,
+					   TupleTableSlot *slot);
 static bool slotAllNulls(TupleTableSlot *slot);
 static bool slotNoNulls(TupleTableSlot *slot);
 
@@ -113,10 +209,21 @@ ExecHashSubPlan(SubPlanState *node,
 
 	/*
 	 * If first time through or we need to rescan the subplan, build the hash
-	 * table.
+	 * table.  In a parallel query the table may instead be shared with the
+	 * other participants, in which case we only have to attach to it once.
 	 */
-	if (node->hashtable == NULL || planstate->chgParam != NULL)
+	if (node->hash_shared != NULL && planstate->state->es_query_dsa != NULL)
+	{
+		Assert(planstate->chgParam == NULL);
+		if (!node->hash_attached)
+			attachSharedSubPlanHash(node, econtext);
+	}
+	else if (node->hashtable == NULL || planstate->chgParam != NULL ||
+			 node->hash_attached)
+	{
+		node->hash_attached = false;
 		buildSubPlanHash(node, econtext);
+	}
 
 	/*
 	 * The result for an empty subplan is always FALSE; no need to evaluate
@@ -158,16 +265,13 @@ ExecHashSubPlan(SubPlanState *node,
 	if (slotNoNulls(slot))
 	{
 		if (node->havehashrows &&
-			FindTupleHashEntry(node->hashtable,
-							   slot,
-							   node->cur_eq_comp,
-							   node->lhs_hash_funcs) != NULL)
+			lookupExactMatch(node, slot))
 		{
 			ExecClearTuple(slot);
 			return BoolGetDatum(true);
 		}
 		if (node->havenullrows &&
-			findPartialMatch(node->hashnulls, slot, node->cur_eq_funcs))
+			lookupPartialMatch(node, true, slot))
 		{
 			ExecClearTuple(slot);
 			*isNull = true;
@@ -187,7 +291,7 @@ ExecHashSubPlan(SubPlanState *node,
 	 * aren't provably unequal to the LHS; if so, the result is UNKNOWN.
 	 * Otherwise, the result is FALSE.
 	 */
-	if (node->hashnulls == NULL)
+	if (subplan->unknownEqFalse)
 	{
 		ExecClearTuple(slot);
 		return BoolGetDatum(false);
@@ -200,14 +304,14 @@ ExecHashSubPlan(SubPlanState *node,
 	}
 	/* Scan partly-null table first, since more likely to get a match */
 	if (node->havenullrows &&
-		findPartialMatch(node->hashnulls, slot, node->cur_eq_funcs))
+		lookupPartialMatch(node, true, slot))
 	{
 		ExecClearTuple(slot);
 		*isNull = true;
 		return BoolGetDatum(false);
 	}
 	if (node->havehashrows &&
-		findPartialMatch(node->hashtable, slot, node->cur_eq_funcs))
+		lookupPartialMatch(node, false, slot))
 	{
 		ExecClearTuple(slot);
 		*isNull = true;
@@ -217,6 +321,40 @@ ExecHashSubPlan(SubPlanState *node,
 	return BoolGetDatum(false);
 }
 
+/*
+ * lookupExactMatch: does the (local or shared) main hash table contain an
+ * entry equal to the all-non-null LHS tuple?
+ */
+static bool
+lookupExactMatch(SubPlanState *node, TupleTableSlot *slot)
+{
+	if (node->hash_attached)
+		return findSharedExactMatch(node, slot);
+
+	return FindTupleHashEntry(node->hashtable,
+							  slot,
+							  node->cur_eq_comp,
+							  node->lhs_hash_funcs) != NULL;
+}
+
+/*
+ * lookupPartialMatch: does the main table (or, if nullrows, the partly-null
+ * table) contain an entry that is not provably distinct from the tuple?
+ */
+static bool
+lookupPartialMatch(SubPlanState *node, bool nullrows, TupleTableSlot *slot)
+{
+	if (node->hash_attached)
+		return findSharedPartialMatch(node,
+									  nullrows ?
+									  &node->hash_shared->hashnulls :
+									  &node->hash_shared->hashtable,
+									  slot);
+
+	return findPartialMatch(nullrows ? node->hashnulls : node->hashtable,
+							slot, node->cur_eq_funcs);
+}
+
 /*
  * ExecScanSubPlan: default case where we have to rescan subplan each time
  */
@@ -763,6 +901,451 @@ slotNoNulls(TupleTableSlot *slot)
 	return true;
 }
 
+/*
+ * attachSharedSubPlanHash: get access to the shared hash table(s), building
+ * them first if no other participant has done so yet.
+ */
+static void
+attachSharedSubPlanHash(SubPlanState *node, ExprContext *econtext)
+{
+	SubPlanHashShared *shared = node->hash_shared;
+	bool		build = false;
+
+	SpinLockAcquire(&shared->mutex);
+	if (shared->status == SUBPLAN_HASH_EMPTY)
+	{
+		shared->status = SUBPLAN_HASH_BUILDING;
+		build = true;
+	}
+	SpinLockRelease(&shared->mutex);
+
+	if (build)
+	{
+		buildSharedSubPlanHash(node, econtext);
+
+		SpinLockAcquire(&shared->mutex);
+		shared->status = SUBPLAN_HASH_READY;
+		SpinLockRelease(&shared->mutex);
+		ConditionVariableBroadcast(&shared->cv);
+	}
+	else
+	{
+		/* Someone else is building it; wait until they're done */
+		ConditionVariablePrepareToSleep(&shared->cv);
+		for (;;)
+		{
+			bool		ready;
+
+			SpinLockAcquire(&shared->mutex);
+			ready = (shared->status == SUBPLAN_HASH_READY);
+			SpinLockRelease(&shared->mutex);
+			if (ready)
+				break;
+			ConditionVariableSleep(&shared->cv, WAIT_EVENT_SUBPLAN_HASH_BUILD);
+		}
+		ConditionVariableCancelSleep();
+	}
+
+	node->havehashrows = shared->havehashrows;
+	node->havenullrows = shared->havenullrows;
+	node->hash_attached = true;
+}
+
+/*
+ * buildSharedSubPlanHash: load the shared hash table(s) by scanning subplan
+ * output.  This is the shared-memory counterpart of buildSubPlanHash, which
+ * see for more comments.
+ */
+static void
+buildSharedSubPlanHash(SubPlanState *node, ExprContext *econtext)
+{
+	SubPlan    *subplan = node->subplan;
+	PlanState  *planstate = node->planstate;
+	SubPlanHashShared *shared = node->hash_shared;
+	dsa_area   *area = planstate->state->es_query_dsa;
+	int			ncols = list_length(subplan->paramIds);
+	ExprContext *innerecontext = node->innerecontext;
+	SubPlanHashChunkState cs;
+	MemoryContext oldcontext;
+	long		nbuckets;
+	TupleTableSlot *slot;
+
+	Assert(subplan->subLinkType == ANY_SUBLINK);
+
+	nbuckets = (long) Min(planstate->plan->plan_rows,
+						  (double) SUBPLAN_HASH_MAX_BUCKETS);
+	if (nbuckets < 1)
+		nbuckets = 1;
+
+	sharedHashInitTable(area, &shared->hashtable, nbuckets);
+
+	if (!subplan->unknownEqFalse)
+	{
+		if (ncols == 1)
+			nbuckets = 1;		/* there can only be one entry */
+		else
+		{
+			nbuckets /= 16;
+			if (nbuckets < 1)
+				nbuckets = 1;
+		}
+		sharedHashInitTable(area, &shared->hashnulls, nbuckets);
+	}
+
+	cs.chunk = InvalidDsaPointer;
+	cs.used = 0;
+
+	oldcontext = MemoryContextSwitchTo(econtext->ecxt_per_query_memory);
+
+	ExecReScan(planstate);
+
+	for (slot = ExecProcNode(planstate);
+		 !TupIsNull(slot);
+		 slot = ExecProcNode(planstate))
+	{
+		int			col = 1;
+		ListCell   *plst;
+
+		foreach(plst, subplan->paramIds)
+		{
+			int			paramid = lfirst_int(plst);
+			ParamExecData *prmdata;
+
+			prmdata = &(innerecontext->ecxt_param_exec_vals[paramid]);
+			Assert(prmdata->execPlan == NULL);
+			prmdata->value = slot_getattr(slot, col,
+										  &(prmdata->isnull));
+			col++;
+		}
+		slot = ExecProject(node->projRight);
+
+		if (slotNoNulls(slot))
+		{
+			sharedHashInsert(node, area, &shared->hashtable, &cs, slot);
+			shared->havehashrows = true;
+		}
+		else if (!subplan->unknownEqFalse)
+		{
+			sharedHashInsert(node, area, &shared->hashnulls, &cs, slot);
+			shared->havenullrows = true;
+		}
+
+		ResetExprContext(innerecontext);
+	}
+
+	ExecClearTuple(node->projRight->pi_state.resultslot);
+	ExecClearTuple(node->sharedslot);
+
+	MemoryContextSwitchTo(oldcontext);
+}
+
+/*
+ * sharedHashInitTable: allocate an empty shared table with room for about
+ * nbuckets entries.
+ */
+static void
+sharedHashInitTable(dsa_area *area, SubPlanSharedTable *table, long nbuckets)
+{
+	table->nbuckets = ((uint32) 1) << my_log2(nbuckets);
+	table->ntuples = 0;
+	table->buckets =
+		dsa_allocate_extended(area, table->nbuckets * sizeof(dsa_pointer),
+							  DSA_ALLOC_HUGE | DSA_ALLOC_ZERO);
+}
+
+/*
+ * sharedHashInsert: add a projected subplan row to a shared table, unless
+ * an equal row is already present.
+ */
+static void
+sharedHashInsert(SubPlanState *node, dsa_area *area,
+				 SubPlanSharedTable *table, SubPlanHashChunkState *cs,
+				 TupleTableSlot *slot)
+{
+	int			ncols = list_length(node->subplan->paramIds);
+	dsa_pointer *buckets;
+	dsa_pointer entry_dp;
+	SubPlanHashEntry *entry;
+	MinimalTuple tuple;
+	bool		shouldFree;
+	uint32		hash;
+	uint32		bucketno;
+	Size		size;
+
+	hash = sharedHashRow(node, slot, node->tab_hash_funcs);
+	buckets = (dsa_pointer *) dsa_get_address(area, table->buckets);
+	bucketno = hash & (table->nbuckets - 1);
+
+	/* Only one copy of duplicate rows is stored */
+	for (entry_dp = buckets[bucketno];
+		 DsaPointerIsValid(entry_dp);
+		 entry_dp = entry->next)
+	{
+		entry = (SubPlanHashEntry *) dsa_get_address(area, entry_dp);
+		if (entry->hash != hash)
+			continue;
+		ExecStoreMinimalTuple(SubPlanHashEntryTuple(entry), node->sharedslot,
+							  false);
+		if (sharedTuplesMatch(slot, node->sharedslot,
+							  ncols, node->keyColIdx,
+							  node->tab_eq_funcs,
+							  node->hashtempcxt))
+			return;
+	}
+
+	tuple = ExecFetchSlotMinimalTuple(slot, &shouldFree);
+	size = MAXALIGN(SUBPLAN_HASH_ENTRY_HEADER_SIZE + tuple->t_len);
+
+	/*
+	 * Carve the entry out of the current chunk, starting a new one if it
+	 * doesn't fit.  Wide rows get an allocation of their own, so that we
+	 * don't waste most of a chunk on them.
+	 */
+	if (size > SUBPLAN_HASH_CHUNK_SIZE / 4)
+		entry_dp = dsa_allocate_extended(area, size, DSA_ALLOC_HUGE);
+	else
+	{
+		if (!DsaPointerIsValid(cs->chunk) ||
+			cs->used + size > SUBPLAN_HASH_CHUNK_SIZE)
+		{
+			cs->chunk = dsa_allocate(area, SUBPLAN_HASH_CHUNK_SIZE);
+			cs->used = 0;
+		}
+		entry_dp = cs->chunk + cs->used;
+		cs->used += size;
+	}
+
+	entry = (SubPlanHashEntry *) dsa_get_address(area, entry_dp);
+	entry->hash = hash;
+	memcpy(SubPlanHashEntryTuple(entry), tuple, tuple->t_len);
+	if (shouldFree)
+		pfree(tuple);
+
+	entry->next = buckets[bucketno];
+	buckets[bucketno] = entry_dp;
+
+	if (++table->ntuples > table->nbuckets &&
+		table->nbuckets < SUBPLAN_HASH_MAX_BUCKETS)
+		sharedHashGrow(area, table);
+}
+
+/*
+ * sharedHashGrow: double the number of buckets of a shared table.
+ */
+static void
+sharedHashGrow(dsa_area *area, SubPlanSharedTable *table)
+{
+	uint32		newnbuckets = table->nbuckets * 2;
+	dsa_pointer newbuckets_dp;
+	dsa_pointer *oldbuckets;
+	dsa_pointer *newbuckets;
+	uint32		i;
+
+	newbuckets_dp =
+		dsa_allocate_extended(area, (Size) newnbuckets * sizeof(dsa_pointer),
+							  DSA_ALLOC_HUGE | DSA_ALLOC_ZERO);
+	oldbuckets = (dsa_pointer *) dsa_get_address(area, table->buckets);
+	newbuckets = (dsa_pointer *) dsa_get_address(area, newbuckets_dp);
+
+	for (i = 0; i < table->nbuckets; i++)
+	{
+		dsa_pointer entry_dp = oldbuckets[i];
+
+		while (DsaPointerIsValid(entry_dp))
+		{
+			SubPlanHashEntry *entry;
+			dsa_pointer next;
+			uint32		bucketno;
+
+			entry = (SubPlanHashEntry *) dsa_get_address(area, entry_dp);
+			next = entry->next;
+			bucketno = entry->hash & (newnbuckets - 1);
+			entry->next = newbuckets[bucketno];
+			newbuckets[bucketno] = entry_dp;
+			entry_dp = next;
+		}
+	}
+
+	dsa_free(area, table->buckets);
+	table->buckets = newbuckets_dp;
+	table->nbuckets = newnbuckets;
+}
+
+/*
+ * sharedHashRow: compute the hash value of a projected row, combining the
+ * per-column hash values the same way TupleHashTableHash does.
+ */
+static uint32
+sharedHashRow(SubPlanState *node, TupleTableSlot *slot,
+			  FmgrInfo *hashfunctions)
+{
+	int			ncols = list_length(node->subplan->paramIds);
+	uint32		hashkey = 0;
+	MemoryContext oldContext;
+	int			i;
+
+	MemoryContextReset(node->hashtempcxt);
+	oldContext = MemoryContextSwitchTo(node->hashtempcxt);
+
+	for (i = 0; i < ncols; i++)
+	{
+		AttrNumber	att = node->keyColIdx[i];
+		Datum		attr;
+		bool		isNull;
+
+		/* rotate hashkey left 1 bit at each step */
+		hashkey = (hashkey << 1) | ((hashkey & 0x80000000) ? 1 : 0);
+
+		attr = slot_getattr(slot, att, &isNull);
+
+		if (!isNull)			/* treat nulls as having hash key 0 */
+		{
+			uint32		hkey;
+
+			hkey = hash_datum_fast(&hashfunctions[i], InvalidOid, attr);
+			hashkey ^= hkey;
+		}
+	}
+
+	MemoryContextSwitchTo(oldContext);
+
+	return murmurhash32(hashkey);
+}
+
+/*
+ * sharedTuplesMatch
+ *		Return true if two tuples are equal in the indicated fields.
+ *
+ * Unlike execTuplesUnequal, nulls are considered equal to each other here;
+ * this is the notion of equality TupleHashTables use to eliminate duplicate
+ * rows, and we need the same for the shared tables.
+ */
+static bool
+sharedTuplesMatch(TupleTableSlot *slot1,
+				  TupleTableSlot *slot2,
+				  int numCols,
+				  AttrNumber *matchColIdx,
+				  FmgrInfo *eqfunctions,
+				  MemoryContext evalContext)
+{
+	MemoryContext oldContext;
+	bool		result;
+	int			i;
+
+	MemoryContextReset(evalContext);
+	oldContext = MemoryContextSwitchTo(evalContext);
+
+	result = true;
+
+	for (i = numCols; --i >= 0;)
+	{
+		AttrNumber	att = matchColIdx[i];
+		Datum		attr1,
+					attr2;
+		bool		isNull1,
+					isNull2;
+
+		attr1 = slot_getattr(slot1, att, &isNull1);
+		attr2 = slot_getattr(slot2, att, &isNull2);
+
+		if (isNull1 != isNull2)
+		{
+			result = false;
+			break;
+		}
+		if (isNull1)
+			continue;			/* both null: treat as equal */
+
+		if (!DatumGetBool(FunctionCall2(&eqfunctions[i],
+										attr1, attr2)))
+		{
+			result = false;
+			break;
+		}
+	}
+
+	MemoryContextSwitchTo(oldContext);
+
+	return result;
+}
+
+/*
+ * findSharedExactMatch: does the shared main table contain an entry equal
+ * to the (all-non-null) LHS tuple?
+ */
+static bool
+findSharedExactMatch(SubPlanState *node, TupleTableSlot *slot)
+{
+	SubPlanSharedTable *table = &node->hash_shared->hashtable;
+	dsa_area   *area = node->planstate->state->es_query_dsa;
+	ExprContext *econtext = node->innerecontext;
+	dsa_pointer *buckets;
+	dsa_pointer entry_dp;
+	SubPlanHashEntry *entry;
+	uint32		hash;
+
+	hash = sharedHashRow(node, slot, node->lhs_hash_funcs);
+	buckets = (dsa_pointer *) dsa_get_address(area, table->buckets);
+
+	for (entry_dp = buckets[hash & (table->nbuckets - 1)];
+		 DsaPointerIsValid(entry_dp);
+		 entry_dp = entry->next)
+	{
+		entry = (SubPlanHashEntry *) dsa_get_address(area, entry_dp);
+		if (entry->hash != hash)
+			continue;
+		ExecStoreMinimalTuple(SubPlanHashEntryTuple(entry), node->sharedslot,
+							  false);
+
+		/* For crosstype comparisons, the LHS slot must be first */
+		econtext->ecxt_innertuple = slot;
+		econtext->ecxt_outertuple = node->sharedslot;
+		if (ExecQualAndReset(node->cur_eq_comp, econtext))
+			return true;
+	}
+	return false;
+}
+
+/*
+ * findSharedPartialMatch: does the shared table contain an entry that is not
+ * provably distinct from the tuple?  Like findPartialMatch, we have to scan
+ * the whole table.
+ */
+static bool
+findSharedPartialMatch(SubPlanState *node, SubPlanSharedTable *table,
+					   TupleTableSlot *slot)
+{
+	int			ncols = list_length(node->subplan->paramIds);
+	dsa_area   *area = node->planstate->state->es_query_dsa;
+	dsa_pointer *buckets;
+	uint32		i;
+
+	buckets = (dsa_pointer *) dsa_get_address(area, table->buckets);
+
+	for (i = 0; i < table->nbuckets; i++)
+	{
+		dsa_pointer entry_dp;
+		SubPlanHashEntry *entry;
+
+		for (entry_dp = buckets[i];
+			 DsaPointerIsValid(entry_dp);
+			 entry_dp = entry->next)
+		{
+			CHECK_FOR_INTERRUPTS();
+
+			entry = (SubPlanHashEntry *) dsa_get_address(area, entry_dp);
+			ExecStoreMinimalTuple(SubPlanHashEntryTuple(entry),
+								  node->sharedslot, false);
+			if (!execTuplesUnequal(slot, node->sharedslot,
+								   ncols, node->keyColIdx,
+								   node->cur_eq_funcs,
+								   node->hashtempcxt))
+				return true;
+		}
+	}
+	return false;
+}
+
 /* ----------------------------------------------------------------
  *		ExecInitSubPlan
  *
@@ -810,6 +1393,9 @@ ExecInitSubPlan(SubPlan *subplan, PlanState *parent)
 	sstate->tab_eq_funcs = NULL;
 	sstate->lhs_hash_funcs = NULL;
 	sstate->cur_eq_funcs = NULL;
+	sstate->hash_shared = NULL;
+	sstate->hash_attached = false;
+	sstate->sharedslot = NULL;
 
 	/*
 	 * If this is an initplan or MULTIEXPR subplan, it has output parameters
@@ -983,6 +1569,10 @@ ExecInitSubPlan(SubPlan *subplan, PlanState *parent)
 													sstate->planstate,
 													NULL);
 
+		/* and a slot for examining rows of a shared hash table */
+		sstate->sharedslot = ExecInitExtraTupleSlot(estate, tupDescRight,
+													&TTSOpsMinimalTuple);
+
 		/*
 		 * Create comparator for lookups of rows in the table (potentially
 		 * across-type comparison).
@@ -1360,3 +1950,95 @@ ExecAlternativeSubPlan(AlternativeSubPlanState *node,
 
 	return ExecSubPlan(activesp, econtext, isNull);
 }
+
+/* ----------------------------------------------------------------
+ *						Parallel Query Support
+ * ----------------------------------------------------------------
+ */
+
+/*
+ * Can this subplan's hash table be shared among the participants of a
+ * parallel query?  The subplan's output must not depend on any parameters,
+ * since participants may attach to the table at any point during the query.
+ */
+static bool
+ExecSubPlanCanShareHash(SubPlanState *node)
+{
+	return node->subplan->useHashTable &&
+		bms_is_empty(node->planstate->plan->extParam);
+}
+
+/* ----------------------------------------------------------------
+ *		ExecSubPlanEstimate
+ *
+ *		Estimate space required to propagate the shared hash table state.
+ * ----------------------------------------------------------------
+ */
+void
+ExecSubPlanEstimate(SubPlanState *node, ParallelContext *pcxt)
+{
+	if (!ExecSubPlanCanShareHash(node))
+		return;
+
+	shm_toc_estimate_chunk(&pcxt->estimator, sizeof(SubPlanHashShared));
+	shm_toc_estimate_keys(&pcxt->estimator, 1);
+}
+
+/* ----------------------------------------------------------------
+ *		ExecSubPlanInitializeDSM
+ *
+ *		Set up the shared hash table state.  The table itself is built
+ *		lazily, by whichever participant first needs it.
+ * ----------------------------------------------------------------
+ */
+void
+ExecSubPlanInitializeDSM(SubPlanState *node, ParallelContext *pcxt)
+{
+	SubPlanHashShared *shared;
+	uint64		key;
+
+	if (!ExecSubPlanCanShareHash(node))
+		return;
+
+	/* SubPlanStates for the same subplan share a single table */
+	key = PARALLEL_KEY_SUBPLAN_HASH(node->subplan->plan_id);
+	shared = shm_toc_lookup(pcxt->toc, key, true);
+	if (shared == NULL)
+	{
+		shared = shm_toc_allocate(pcxt->toc, sizeof(SubPlanHashShared));
+		SpinLockInit(&shared->mutex);
+		shared->status = SUBPLAN_HASH_EMPTY;
+		ConditionVariableInit(&shared->cv);
+		shared->hashtable.buckets = InvalidDsaPointer;
+		shared->hashtable.nbuckets = 0;
+		shared->hashtable.ntuples = 0;
+		shared->hashnulls.buckets = InvalidDsaPointer;
+		shared->hashnulls.nbuckets = 0;
+		shared->hashnulls.ntuples = 0;
+		shared->havehashrows = false;
+		shared->havenullrows = false;
+		shm_toc_insert(pcxt->toc, key, shared);
+	}
+
+	node->hash_shared = shared;
+	node->hash_attached = false;
+}
+
+/* ----------------------------------------------------------------
+ *		ExecSubPlanInitializeWorker
+ *
+ *		Find the shared hash table state in a parallel worker.
+ * ----------------------------------------------------------------
+ */
+void
+ExecSubPlanInitializeWorker(SubPlanState *node, ParallelWorkerContext *pwcxt)
+{
+	if (!ExecSubPlanCanShareHash(node))
+		return;
+
+	node->hash_shared =
+		shm_toc_lookup(pwcxt->toc,
+					   PARALLEL_KEY_SUBPLAN_HASH(node->subplan->plan_id),
+					   false);
+	node->hash_attached = false;
+}
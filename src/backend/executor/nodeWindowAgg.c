@@ -178,6 +178,7 @@ static void eval_windowfunction(WindowAggState *winstate,
 
 static void begin_partition(WindowAggState *winstate);
 static void spool_tuples(WindowAggState *winstate, int64 pos);
+static void skip_partition(WindowAggState *winstate);
 static void release_partition(WindowAggState *winstate);
 
 static int row_is_in_frame(WindowAggState *winstate, int64 pos,
@@ -1302,6 +1303,58 @@ spool_tuples(WindowAggState *winstate, int64 pos)
 	MemoryContextSwitchTo(oldcontext);
 }
 
+/*
+ * skip_partition
+ * read and discard the rest of the current partition from the outer node,
+ * without storing it into the tuplestore.
+ */
+static void
+skip_partition(WindowAggState *winstate)
+{
+	WindowAgg  *node = (WindowAgg *) winstate->ss.ps.plan;
+	PlanState  *outerPlan = outerPlanState(winstate);
+	TupleTableSlot *outerslot;
+	MemoryContext oldcontext;
+
+	Assert(node->partNumCols > 0);
+
+	if (winstate->partition_spooled)
+		return;					/* whole partition read already */
+
+	/* Must be in query context to call outerplan */
+	oldcontext = MemoryContextSwitchTo(winstate->ss.ps.ps_ExprContext->ecxt_per_query_memory);
+
+	for (;;)
+	{
+		ExprContext *econtext = winstate->tmpcontext;
+
+		CHECK_FOR_INTERRUPTS();
+
+		outerslot = ExecProcNode(outerPlan);
+		if (TupIsNull(outerslot))
+		{
+			/* reached the end of the last partition */
+			winstate->partition_spooled = true;
+			winstate->more_partitions = false;
+			break;
+		}
+
+		econtext->ecxt_innertuple = winstate->first_part_slot;
+		econtext->ecxt_outertuple = outerslot;
+
+		if (!ExecQualAndReset(winstate->partEqfunction, econtext))
+		{
+			/* end of partition; copy the tuple for the next cycle */
+			ExecCopySlot(winstate->first_part_slot, outerslot);
+			winstate->partition_spooled = true;
+			winstate->more_partitions = true;
+			break;
+		}
+	}
+
+	MemoryContextSwitchTo(oldcontext);
+}
+
 /*
  * release_partition
  * clear information kept within a partition, including
@@ -2023,6 +2076,7 @@ ExecWindowAgg(PlanState *pstate)
 {
 	WindowAggState *winstate = castNode(WindowAggState, pstate);
 	ExprContext *econtext;
+	TupleTableSlot *slot;
 	int			i;
 	int			numfuncs;
 
@@ -2098,6 +2152,7 @@ ExecWindowAgg(PlanState *pstate)
 		winstate->all_first = false;
 	}
 
+next_row:
 	if (winstate->buffer == NULL)
 	{
 		/* Initialize for first partition and set current row = 0 */
@@ -2234,7 +2289,33 @@ ExecWindowAgg(PlanState *pstate)
 	 */
 	econtext->ecxt_outertuple = winstate->ss.ss_ScanTupleSlot;
 
-	return ExecProject(winstate->ss.ps.ps_ProjInfo);
+	slot = ExecProject(winstate->ss.ps.ps_ProjInfo);
+
+	/*
+	 * If the planner gave us a run condition, check it.  It only tests
+	 * window functions whose values never go back within a partition, so
+	 * once it fails, it fails for the rest of the partition too, and the
+	 * query above us would throw those rows away anyway.  So skip the rest
+	 * of the partition, or stop altogether if there's only one.
+	 */
+	if (winstate->runcondition != NULL)
+	{
+		econtext->ecxt_scantuple = slot;
+		if (!ExecQual(winstate->runcondition, econtext))
+		{
+			if (((WindowAgg *) winstate->ss.ps.plan)->partNumCols == 0)
+			{
+				winstate->all_done = true;
+				return NULL;
+			}
+
+			skip_partition(winstate);
+			winstate->currentpos = winstate->spooled_rows - 1;
+			goto next_row;
+		}
+	}
+
+	return slot;
 }
 
 /* -----------------
@@ -2506,6 +2587,12 @@ ExecInitWindowAgg(WindowAgg *node, EState *estate, int eflags)
 	winstate->endOffset = ExecInitExpr((Expr *) node->endOffset,
 									   (PlanState *) winstate);
 
+	/*
+	 * The run condition is checked against our own projected output row, not
+	 * the scan tuple, so don't let it assume the scan slot's type.
+	 */
+	winstate->runcondition = ExecInitQual(node->runCondition, NULL);
+
 	/* Lookup in_range support functions if needed */
 	if (OidIsValid(node->startInRangeFunc))
 		fmgr_info(node->startInRangeFunc, &winstate->startInRangeFunc);
@@ -39,6 +39,8 @@ bool		jit_dump_bitcode = false;
 bool		jit_expressions = true;
 bool		jit_profiling_support = false;
 bool		jit_tuple_deforming = true;
+int			jit_deform_cache_size = 256;
+int			jit_warmup_evaluations = 0;
 double		jit_above_cost = 100000;
 double		jit_inline_above_cost = 500000;
 double		jit_optimize_above_cost = 500000;
@@ -20,11 +20,54 @@
 
 #include <llvm-c/Core.h>
 
+#include "access/hash.h"
 #include "access/htup_details.h"
 #include "access/tupdesc_details.h"
 #include "executor/tuptable.h"
 #include "jit/llvmjit.h"
 #include "jit/llvmjit_emit.h"
+#include "utils/hsearch.h"
+#include "utils/memutils.h"
+
+
+/*
+ * Cache of deform functions that have already been emitted in this backend.
+ *
+ * The code generated by slot_compile_deform() depends only on the layout
+ * of the tuple descriptor, the slot type and the number of attributes to
+ * deform; unlike expression code it doesn't embed any pointers to
+ * query-lifetime state.  It can therefore be emitted once into a
+ * session-lifetime module and be called by the code of any later query
+ * deforming the same kind of tuple, which avoids generating, optimizing
+ * and emitting it again for every execution of e.g. a prepared statement.
+ *
+ * Entries are looked up by a hash of the signature built by
+ * deform_cache_signature(); collisions are resolved by comparing the full
+ * signature.  The code of cached functions is never released, so the
+ * number of entries is capped by jit_deform_cache_size.
+ */
+typedef struct DeformCacheVariant
+{
+	int			siglen;
+	char	   *signature;
+	void	   *fn;
+} DeformCacheVariant;
+
+typedef struct DeformCacheEntry
+{
+	uint32		hash;			/* hash key, must be first */
+	List	   *variants;		/* list of DeformCacheVariant */
+} DeformCacheEntry;
+
+static HTAB *deform_cache = NULL;
+static int	deform_cache_entries = 0;
+
+/* session-lifetime context the cached functions are emitted in */
+static LLVMJitContext *deform_cache_context = NULL;
+
+static char *deform_cache_signature(TupleDesc desc,
+					   const TupleTableSlotOps *ops, int natts,
+					   int flags, int *siglen);
 
 
 /*
@@ -751,3 +794,200 @@ slot_compile_deform(LLVMJitContext *context, TupleDesc desc,
 
 	return v_deform_fn;
 }
+
+/*
+ * Like slot_compile_deform(), but use a deform function from the backend's
+ * cache of already emitted functions, emitting and adding one if there's
+ * none for this kind of tuple yet.  The returned value is a constant
+ * pointer to the function that can be called from context's module.
+ *
+ * Falls back to slot_compile_deform() once the cache is full.
+ */
+LLVMValueRef
+slot_compile_deform_cached(LLVMJitContext *context, TupleDesc desc,
+						   const TupleTableSlotOps *ops, int natts)
+{
+	int			cache_flags;
+	char	   *signature;
+	int			siglen;
+	uint32		hash;
+	DeformCacheEntry *entry;
+	DeformCacheVariant *variant;
+	MemoryContext oldcontext;
+	ListCell   *lc;
+	bool		found;
+	LLVMTypeRef deform_sig;
+	LLVMValueRef v_deform_fn;
+	void	   *fn;
+
+	/* same exits as slot_compile_deform */
+	if (ops == &TTSOpsVirtual)
+		return NULL;
+	if (ops != &TTSOpsHeapTuple && ops != &TTSOpsBufferHeapTuple &&
+		ops != &TTSOpsMinimalTuple)
+		return NULL;
+
+	/* signature of the deform functions, as in slot_compile_deform */
+	{
+		LLVMTypeRef param_types[1];
+
+		param_types[0] = l_ptr(StructTupleTableSlot);
+
+		deform_sig = LLVMFunctionType(LLVMVoidType(), param_types,
+									  lengthof(param_types), 0);
+	}
+
+	if (deform_cache == NULL)
+	{
+		HASHCTL		ctl;
+
+		MemSet(&ctl, 0, sizeof(ctl));
+		ctl.keysize = sizeof(uint32);
+		ctl.entrysize = sizeof(DeformCacheEntry);
+		deform_cache = hash_create("JIT deform cache", 64, &ctl,
+								   HASH_ELEM | HASH_BLOBS);
+	}
+
+	/* the generated code only depends on these flags */
+	cache_flags = context->base.flags & (PGJIT_OPT3 | PGJIT_INLINE);
+
+	signature = deform_cache_signature(desc, ops, natts, cache_flags,
+									   &siglen);
+	hash = DatumGetUInt32(hash_any((unsigned char *) signature, siglen));
+
+	entry = (DeformCacheEntry *) hash_search(deform_cache, &hash,
+											 HASH_FIND, NULL);
+	if (entry != NULL)
+	{
+		foreach(lc, entry->variants)
+		{
+			variant = (DeformCacheVariant *) lfirst(lc);
+
+			if (variant->siglen == siglen &&
+				memcmp(variant->signature, signature, siglen) == 0)
+			{
+				pfree(signature);
+				return l_ptr_const(variant->fn, l_ptr(deform_sig));
+			}
+		}
+	}
+
+	if (deform_cache_entries >= jit_deform_cache_size)
+	{
+		pfree(signature);
+		return slot_compile_deform(context, desc, ops, natts);
+	}
+
+	/*
+	 * First use of this kind of tuple, emit the function in the cache's own
+	 * context.  That context isn't owned by any resource owner and lives as
+	 * long as the backend.
+	 */
+	if (deform_cache_context == NULL)
+	{
+		deform_cache_context = MemoryContextAllocZero(TopMemoryContext,
+													  sizeof(LLVMJitContext));
+	}
+	else if (deform_cache_context->module != NULL)
+	{
+		/*
+		 * An error was thrown while a previous function was being emitted.
+		 * We can't tell whether LLVM already took ownership of the module,
+		 * so just forget about it.
+		 */
+		deform_cache_context->module = NULL;
+		deform_cache_context->compiled = true;
+	}
+	deform_cache_context->base.flags = cache_flags | PGJIT_DEFORM;
+	memset(&deform_cache_context->base.instr, 0, sizeof(JitInstrumentation));
+
+	v_deform_fn = slot_compile_deform(deform_cache_context, desc, ops, natts);
+	Assert(v_deform_fn != NULL);
+
+	/* has to be visible to be looked up and called from other modules */
+	LLVMSetLinkage(v_deform_fn, LLVMExternalLinkage);
+
+	fn = llvm_get_function(deform_cache_context,
+						   LLVMGetValueName(v_deform_fn));
+
+	/* charge the work to the context that needed the function */
+	context->base.instr.created_functions +=
+		deform_cache_context->base.instr.created_functions;
+	INSTR_TIME_ADD(context->base.instr.inlining_counter,
+				   deform_cache_context->base.instr.inlining_counter);
+	INSTR_TIME_ADD(context->base.instr.optimization_counter,
+				   deform_cache_context->base.instr.optimization_counter);
+	INSTR_TIME_ADD(context->base.instr.emission_counter,
+				   deform_cache_context->base.instr.emission_counter);
+
+	oldcontext = MemoryContextSwitchTo(TopMemoryContext);
+
+	variant = (DeformCacheVariant *) palloc(sizeof(DeformCacheVariant));
+	variant->siglen = siglen;
+	variant->signature = palloc(siglen);
+	memcpy(variant->signature, signature, siglen);
+	variant->fn = fn;
+
+	entry = (DeformCacheEntry *) hash_search(deform_cache, &hash,
+											 HASH_ENTER, &found);
+	if (!found)
+		entry->variants = NIL;
+	entry->variants = lappend(entry->variants, variant);
+	deform_cache_entries++;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	pfree(signature);
+
+	return l_ptr_const(fn, l_ptr(deform_sig));
+}
+
+/*
+ * Build a signature of everything slot_compile_deform() bases the
+ * generated code on.  The result is palloc'd, its length is returned in
+ * *siglen.
+ */
+static char *
+deform_cache_signature(TupleDesc desc, const TupleTableSlotOps *ops,
+					   int natts, int flags, int *siglen)
+{
+	char	   *signature;
+	char	   *p;
+	char		kind;
+	int			attnum;
+
+	if (ops == &TTSOpsHeapTuple)
+		kind = 'h';
+	else if (ops == &TTSOpsBufferHeapTuple)
+		kind = 'b';
+	else
+		kind = 'm';
+
+	/* header, then four bytes per attribute */
+	signature = palloc(1 + sizeof(int) * 3 + desc->natts * 4);
+	p = signature;
+
+	*p++ = kind;
+	memcpy(p, &flags, sizeof(int));
+	p += sizeof(int);
+	memcpy(p, &natts, sizeof(int));
+	p += sizeof(int);
+	memcpy(p, &desc->natts, sizeof(int));
+	p += sizeof(int);
+
+	for (attnum = 0; attnum < desc->natts; attnum++)
+	{
+		Form_pg_attribute att = TupleDescAttr(desc, attnum);
+
+		memcpy(p, &att->attlen, sizeof(int16));
+		p += sizeof(int16);
+		*p++ = att->attalign;
+		*p++ = (att->attbyval ? 1 : 0) |
+			(att->attnotnull ? 2 : 0) |
+			(att->atthasmissing ? 4 : 0);
+	}
+
+	*siglen = p - signature;
+
+	return signature;
+}
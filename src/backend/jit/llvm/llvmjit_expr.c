@@ -52,10 +52,15 @@ typedef struct CompiledExprState
 {
 	LLVMJitContext *context;
 	const char *funcname;
+
+	/* interpreted evaluation used until the code is emitted */
+	ExprStateEvalFunc interpfunc;
+	int			nevals;
 } CompiledExprState;
 
 
 static Datum ExecRunCompiledExpr(ExprState *state, ExprContext *econtext, bool *isNull);
+static Datum ExecRunCompiledExprWarmup(ExprState *state, ExprContext *econtext, bool *isNull);
 
 static LLVMValueRef BuildV1Call(LLVMJitContext *context, LLVMBuilderRef b,
 			LLVMModuleRef mod, FunctionCallInfo fcinfo,
@@ -322,10 +327,16 @@ llvm_compile_expr(ExprState *state)
 					 */
 					if (tts_ops && desc && (context->base.flags & PGJIT_DEFORM))
 					{
-						l_jit_deform =
-							slot_compile_deform(context, desc,
-												tts_ops,
-												op->d.fetch.last_var);
+						if (jit_deform_cache_size > 0)
+							l_jit_deform =
+								slot_compile_deform_cached(context, desc,
+														   tts_ops,
+														   op->d.fetch.last_var);
+						else
+							l_jit_deform =
+								slot_compile_deform(context, desc,
+													tts_ops,
+													op->d.fetch.last_var);
 					}
 
 					if (l_jit_deform)
@@ -2281,6 +2292,41 @@ llvm_compile_expr(ExprState *state)
 					break;
 				}
 
+			case EEOP_AGG_PLAIN_PERGROUP_NULLCHECK:
+				{
+					int			jumpnull;
+					LLVMValueRef v_aggstatep;
+					LLVMValueRef v_allpergroupsp;
+					LLVMValueRef v_pergroup_allaggs;
+					LLVMValueRef v_setoff;
+
+					jumpnull = op->d.agg_plain_pergroup_nullcheck.jumpnull;
+
+					/*
+					 * pergroup_allaggs = aggstate->all_pergroups
+					 * [op->d.agg_plain_pergroup_nullcheck.setoff];
+					 */
+					v_aggstatep = l_ptr_const(op->d.agg_plain_pergroup_nullcheck.aggstate,
+											  l_ptr(StructAggState));
+					v_allpergroupsp =
+						l_load_struct_gep(b, v_aggstatep,
+										  FIELDNO_AGGSTATE_ALL_PERGROUPS,
+										  "aggstate.all_pergroups");
+					v_setoff =
+						l_int32_const(op->d.agg_plain_pergroup_nullcheck.setoff);
+					v_pergroup_allaggs =
+						l_load_gep1(b, v_allpergroupsp, v_setoff, "");
+
+					LLVMBuildCondBr(b,
+									LLVMBuildICmp(b, LLVMIntEQ,
+												  LLVMBuildPtrToInt(b, v_pergroup_allaggs,
+																	TypeSizeT, ""),
+												  l_sizet_const(0), ""),
+									opblocks[jumpnull],
+									opblocks[i + 1]);
+					break;
+				}
+
 			case EEOP_AGG_PLAIN_TRANS_BYVAL:
 			case EEOP_AGG_PLAIN_TRANS:
 				{
@@ -2517,7 +2563,22 @@ llvm_compile_expr(ExprState *state)
 		cstate->context = context;
 		cstate->funcname = funcname;
 
-		state->evalfunc = ExecRunCompiledExpr;
+		/*
+		 * If requested, first evaluate the expression with the interpreter
+		 * for a while, so that queries that end up evaluating it only a few
+		 * times never pay for optimizing and emitting the code.  The
+		 * interpreter is set up on the same steps; the generated code
+		 * doesn't look at the steps' opcodes, so it isn't affected by the
+		 * interpreter converting them for direct threading.
+		 */
+		if (jit_warmup_evaluations > 0)
+		{
+			ExecReadyInterpretedExpr(state);
+			cstate->interpfunc = (ExprStateEvalFunc) state->evalfunc_private;
+			state->evalfunc = ExecRunCompiledExprWarmup;
+		}
+		else
+			state->evalfunc = ExecRunCompiledExpr;
 		state->evalfunc_private = cstate;
 	}
 
@@ -2558,6 +2619,41 @@ ExecRunCompiledExpr(ExprState *state, ExprContext *econtext, bool *isNull)
 	return func(state, econtext, isNull);
 }
 
+/*
+ * Run compiled expression with the interpreter.
+ *
+ * Used instead of ExecRunCompiledExpr() while the expression has been
+ * evaluated fewer than jit_warmup_evaluations times.  After that, the
+ * emitted function takes over.
+ */
+static Datum
+ExecRunCompiledExprWarmup(ExprState *state, ExprContext *econtext, bool *isNull)
+{
+	CompiledExprState *cstate = state->evalfunc_private;
+
+	if (cstate->nevals >= jit_warmup_evaluations)
+	{
+		/* done warming up, the check was already done on the first call */
+		ExprStateEvalFunc func;
+
+		llvm_enter_fatal_on_oom();
+		func = (ExprStateEvalFunc) llvm_get_function(cstate->context,
+													 cstate->funcname);
+		llvm_leave_fatal_on_oom();
+		Assert(func);
+
+		state->evalfunc = func;
+
+		return func(state, econtext, isNull);
+	}
+
+	if (cstate->nevals == 0)
+		CheckExprStillValid(state, econtext);
+	cstate->nevals++;
+
+	return cstate->interpfunc(state, econtext, isNull);
+}
+
 static LLVMValueRef
 BuildV1Call(LLVMJitContext *context, LLVMBuilderRef b,
 			LLVMModuleRef mod, FunctionCallInfo fcinfo,
@@ -383,6 +383,17 @@ ClientAuthentication(Port *port)
 					 errmsg("connection requires a valid client certificate")));
 	}
 
+	/*
+	 * Peer and ident authentication identify the client by its socket, which
+	 * for a connection made through the connection proxy is the proxy's own.
+	 */
+	if (port->proxied &&
+		(port->hba->auth_method == uaPeer || port->hba->auth_method == uaIdent))
+		ereport(FATAL,
+				(errcode(ERRCODE_INVALID_AUTHORIZATION_SPECIFICATION),
+				 errmsg("%s authentication is not supported for connections through the connection proxy",
+						port->hba->auth_method == uaPeer ? "peer" : "ident")));
+
 	/*
 	 * Now proceed to do the actual authentication check
 	 */
@@ -169,13 +169,29 @@ retry:
 	if (n < 0 && !port->noblock && (errno == EWOULDBLOCK || errno == EAGAIN))
 	{
 		WaitEvent	event;
+		bool		received = false;
 
 		Assert(waitfor);
 
 		ModifyWaitEvent(FeBeWaitSet, 0, waitfor, NULL);
 
-		WaitEventSetWait(FeBeWaitSet, -1 /* no timeout */ , &event, 1,
-						 WAIT_EVENT_CLIENT_READ);
+#ifdef USE_SSL
+		if (port->ssl_in_use)
+			WaitEventSetWait(FeBeWaitSet, -1 /* no timeout */ , &event, 1,
+							 WAIT_EVENT_CLIENT_READ);
+		else
+#endif
+		{
+			/*
+			 * Receive the data as part of the wait, which can save a system
+			 * call.  If that fails with EWOULDBLOCK we'll just wait again.
+			 */
+			WaitEventSetWaitRecv(FeBeWaitSet, 0, ptr, len, &n, &event,
+								 WAIT_EVENT_CLIENT_READ);
+			if ((event.events & WL_SOCKET_READABLE) &&
+				(n >= 0 || (errno != EWOULDBLOCK && errno != EAGAIN)))
+				received = true;
+		}
 
 		/*
 		 * If the postmaster has died, it's not safe to continue running,
@@ -211,7 +227,8 @@ retry:
 			 * socket to become ready again.
 			 */
 		}
-		goto retry;
+		if (!received)
+			goto retry;
 	}
 
 	/*
@@ -57,6 +57,7 @@
  *		pq_flush		- flush pending output
  *		pq_flush_if_writable - flush pending output if writable without blocking
  *		pq_getbyte_if_available - get a byte if available without blocking
+ *		pq_start_compression - compress all further traffic
  *
  * message-level I/O (and old-style-COPY-OUT cruft):
  *		pq_putmessage	- send a normal message (suppressed in COPY OUT mode)
@@ -89,7 +90,9 @@
 #endif
 
 #include "common/ip.h"
+#include "common/zpq_stream.h"
 #include "libpq/libpq.h"
+#include "libpq/pqformat.h"
 #include "miscadmin.h"
 #include "port/pg_bswap.h"
 #include "storage/ipc.h"
@@ -150,6 +153,11 @@ static bool PqCommBusy;			/* busy sending data to the client */
 static bool PqCommReadingMsg;	/* in the middle of reading a message */
 static bool DoingCopyOut;		/* in old-protocol COPY OUT processing */
 
+#ifdef HAVE_LIBZ
+/* compression of the traffic, if the client asked for it */
+static ZpqStream *PqStream = NULL;
+#endif
+
 
 /* Internal functions */
 static void socket_comm_reset(void);
@@ -164,6 +172,14 @@ static void socket_startcopyout(void);
 static void socket_endcopyout(bool errorAbort);
 static int	internal_putbytes(const char *s, size_t len);
 static int	internal_flush(void);
+static ssize_t internal_recv(void *ptr, size_t len);
+static ssize_t internal_send(const char *ptr, size_t len);
+static bool internal_send_pending(void);
+
+#ifdef HAVE_LIBZ
+static ssize_t socket_zpq_tx(void *arg, const void *data, size_t size);
+static ssize_t socket_zpq_rx(void *arg, void *data, size_t size);
+#endif
 
 #ifdef HAVE_UNIX_SOCKETS
 static int	Lock_AF_UNIX(char *unixSocketDir, char *unixSocketPath);
@@ -225,6 +241,9 @@ pq_init(void)
 					  NULL, NULL);
 	AddWaitEventToSet(FeBeWaitSet, WL_LATCH_SET, -1, MyLatch, NULL);
 	AddWaitEventToSet(FeBeWaitSet, WL_POSTMASTER_DEATH, -1, NULL, NULL);
+
+	if (use_io_uring && !WaitEventSetEnableIoUring(FeBeWaitSet))
+		elog(DEBUG1, "could not set up io_uring for client connection: %m");
 }
 
 /* --------------------------------
@@ -960,8 +979,8 @@ pq_recvbuf(void)
 	{
 		int			r;
 
-		r = secure_read(MyProcPort, PqRecvBuffer + PqRecvLength,
-						PQ_RECV_BUFFER_SIZE - PqRecvLength);
+		r = internal_recv(PqRecvBuffer + PqRecvLength,
+						  PQ_RECV_BUFFER_SIZE - PqRecvLength);
 
 		if (r < 0)
 		{
@@ -1052,7 +1071,7 @@ pq_getbyte_if_available(unsigned char *c)
 	/* Put the socket into non-blocking mode */
 	socket_set_nonblocking(true);
 
-	r = secure_read(MyProcPort, c, 1);
+	r = internal_recv(c, 1);
 	if (r < 0)
 	{
 		/*
@@ -1426,13 +1445,13 @@ internal_flush(void)
 	char	   *bufptr = PqSendBuffer + PqSendStart;
 	char	   *bufend = PqSendBuffer + PqSendPointer;
 
-	while (bufptr < bufend)
+	while (bufptr < bufend || internal_send_pending())
 	{
 		int			r;
 
-		r = secure_write(MyProcPort, bufptr, bufend - bufptr);
+		r = internal_send(bufptr, bufend - bufptr);
 
-		if (r <= 0)
+		if (r < 0 || (r == 0 && bufptr < bufend))
 		{
 			if (errno == EINTR)
 				continue;		/* Ok if we were interrupted */
@@ -1497,7 +1516,7 @@ socket_flush_if_writable(void)
 	int			res;
 
 	/* Quick exit if nothing to do */
-	if (PqSendPointer == PqSendStart)
+	if (PqSendPointer == PqSendStart && !internal_send_pending())
 		return 0;
 
 	/* No-op if reentrant call */
@@ -1520,9 +1539,154 @@ socket_flush_if_writable(void)
 static bool
 socket_is_send_pending(void)
 {
-	return (PqSendStart < PqSendPointer);
+	return (PqSendStart < PqSendPointer || internal_send_pending());
 }
 
+/* --------------------------------
+ *		internal_recv - read data from the connection
+ *
+ * Like secure_read(), but decompresses the data if the traffic is
+ * compressed.  Corrupt compressed data is reported here and treated as end
+ * of file.
+ * --------------------------------
+ */
+static ssize_t
+internal_recv(void *ptr, size_t len)
+{
+#ifdef HAVE_LIBZ
+	if (PqStream)
+	{
+		ssize_t		r;
+
+		r = zpq_read(PqStream, ptr, len);
+		if (r == ZPQ_STREAM_ERROR)
+		{
+			/* as elsewhere, this must go *only* to the postmaster log */
+			ereport(COMMERROR,
+					(errcode(ERRCODE_PROTOCOL_VIOLATION),
+					 errmsg("could not decompress data from client: %s",
+							zpq_error(PqStream))));
+			return 0;
+		}
+		return r;
+	}
+#endif
+
+	return secure_read(MyProcPort, ptr, len);
+}
+
+/* --------------------------------
+ *		internal_send - write data to the connection
+ *
+ * Like secure_write(), but compresses the data if the traffic is
+ * compressed.  In that case, some of the data consumed may still be
+ * buffered in the compression stream when this returns, see
+ * internal_send_pending(); len can be 0 to only send that data.
+ * --------------------------------
+ */
+static ssize_t
+internal_send(const char *ptr, size_t len)
+{
+#ifdef HAVE_LIBZ
+	if (PqStream)
+	{
+		ssize_t		r;
+
+		/*
+		 * The stream may first have to send compressed data before it takes
+		 * more input, which isn't a short write.
+		 */
+		do
+		{
+			r = zpq_write(PqStream, ptr, len);
+		} while (r == 0 && len > 0);
+
+		if (r == ZPQ_STREAM_ERROR)
+		{
+			ereport(COMMERROR,
+					(errcode(ERRCODE_INTERNAL_ERROR),
+					 errmsg("could not compress data to client: %s",
+							zpq_error(PqStream))));
+			errno = ECONNRESET;
+			return -1;
+		}
+		return r;
+	}
+#endif
+
+	return secure_write(MyProcPort, (void *) ptr, len);
+}
+
+/* --------------------------------
+ *		internal_send_pending - is compressed data waiting to be sent?
+ * --------------------------------
+ */
+static bool
+internal_send_pending(void)
+{
+#ifdef HAVE_LIBZ
+	if (PqStream)
+		return zpq_buffered_tx(PqStream);
+#endif
+
+	return false;
+}
+
+/* --------------------------------
+ *		pq_start_compression - compress all further traffic
+ *
+ * Called once the client is authenticated, if it asked for compression in
+ * the startup packet.  We tell it which algorithm we use with a
+ * CompressionAck message, and everything sent and received after that
+ * message is compressed.
+ * --------------------------------
+ */
+void
+pq_start_compression(void)
+{
+#ifdef HAVE_LIBZ
+	ZpqStream  *stream;
+	StringInfoData buf;
+
+	Assert(PqStream == NULL);
+
+	/* the client doesn't send anything before it sees our message */
+	Assert(PqRecvPointer == PqRecvLength);
+
+	/* set up the stream first, an error must still go out uncompressed */
+	stream = zpq_create(socket_zpq_tx, socket_zpq_rx, MyProcPort, NULL, 0);
+	if (stream == NULL)
+		ereport(FATAL,
+				(errcode(ERRCODE_OUT_OF_MEMORY),
+				 errmsg("out of memory")));
+
+	pq_beginmessage(&buf, 'z');
+	pq_sendstring(&buf, ZPQ_ALGORITHM_NAME);
+	pq_endmessage(&buf);
+	pq_flush();
+
+	PqStream = stream;
+#endif
+}
+
+#ifdef HAVE_LIBZ
+/*
+ * Callbacks of the compression stream, sending and receiving compressed
+ * data.
+ */
+static ssize_t
+socket_zpq_tx(void *arg, const void *data, size_t size)
+{
+	return secure_write((Port *) arg, (void *) data, size);
+}
+
+static ssize_t
+socket_zpq_rx(void *arg, void *data, size_t size)
+{
+	return secure_read((Port *) arg, data, size);
+}
+#endif
+
 /* --------------------------------
  * Message-level I/O routines begin here.
  *
@@ -72,6 +72,14 @@
  */
 #define PAGES_PER_CHUNK  (BLCKSZ / 32)
 
+/*
+ * A process iterating over a shared TIDBitmap claims up to this many pages at
+ * a time, so that it takes the iterator's lock less often.  Fewer are claimed
+ * once few pages remain, so that the last pages are still spread across all
+ * participants.
+ */
+#define TBM_SHARED_ITERATE_BATCH	8
+
 /* We use BITS_PER_BITMAPWORD and typedef bitmapword from nodes/bitmapset.h */
 
 #define WORDNUM(x)	((x) / BITS_PER_BITMAPWORD)
@@ -211,6 +219,15 @@ typedef struct PTIterationArray
 	int			index[FLEXIBLE_ARRAY_MEMBER];	/* index array */
 } PTIterationArray;
 
+/*
+ * A page claimed from a shared iterator, but not yet returned.
+ */
+typedef struct TBMSharedClaim
+{
+	BlockNumber blockno;		/* lossy page number, if pageidx < 0 */
+	int			pageidx;		/* index into ptpages, or -1 if lossy */
+} TBMSharedClaim;
+
 /*
  * same as TBMIterator, but it is used for joint iteration, therefore this
  * also holds a reference to the shared state.
@@ -221,6 +238,9 @@ struct TBMSharedIterator
 	PTEntryArray *ptbase;		/* pagetable element array */
 	PTIterationArray *ptpages;	/* sorted exact page index list */
 	PTIterationArray *ptchunks; /* sorted lossy page index list */
+	int			nclaimed;		/* number of pages in claimed[] */
+	int			nextclaimed;	/* next claimed[] entry to return */
+	TBMSharedClaim claimed[TBM_SHARED_ITERATE_BATCH];
 	TBMIterateResult output;	/* MUST BE LAST (because variable-size) */
 };
 
@@ -231,6 +251,7 @@ static bool tbm_intersect_page(TIDBitmap *a, PagetableEntry *apage,
 static const PagetableEntry *tbm_find_pageentry(const TIDBitmap *tbm,
 				   BlockNumber pageno);
 static PagetableEntry *tbm_get_pageentry(TIDBitmap *tbm, BlockNumber pageno);
+static void tbm_shared_claim(TBMSharedIterator *iterator);
 static bool tbm_page_is_lossy(const TIDBitmap *tbm, BlockNumber pageno);
 static void tbm_mark_page_lossy(TIDBitmap *tbm, BlockNumber pageno);
 static void tbm_lossify(TIDBitmap *tbm);
@@ -1044,17 +1065,65 @@ tbm_iterate(TBMIterator *iterator)
  *	tbm_shared_iterate - scan through next page of a TIDBitmap
  *
  *	As above, but this will iterate using an iterator which is shared
- *	across multiple processes.  We need to acquire the iterator LWLock,
- *	before accessing the shared members.
+ *	across multiple processes.  Pages are claimed from the shared state a
+ *	few at a time by tbm_shared_claim(); they are only returned here.
  */
 TBMIterateResult *
 tbm_shared_iterate(TBMSharedIterator *iterator)
 {
 	TBMIterateResult *output = &iterator->output;
+	TBMSharedClaim *claim;
+
+	if (iterator->nextclaimed >= iterator->nclaimed)
+	{
+		tbm_shared_claim(iterator);
+		if (iterator->nclaimed == 0)
+		{
+			/* Nothing more in the bitmap */
+			return NULL;
+		}
+	}
+
+	claim = &iterator->claimed[iterator->nextclaimed++];
+
+	if (claim->pageidx < 0)
+	{
+		/* Return a lossy page indicator from the chunk */
+		output->blockno = claim->blockno;
+		output->ntuples = -1;
+		output->recheck = true;
+	}
+	else
+	{
+		PagetableEntry *page;
+		int			ntuples;
+
+		page = &iterator->ptbase->ptentry[iterator->ptpages->index[claim->pageidx]];
+
+		/* scan bitmap to extract individual offset numbers */
+		ntuples = tbm_extract_page_tuple(page, output);
+		output->blockno = page->blockno;
+		output->ntuples = ntuples;
+		output->recheck = page->recheck;
+	}
+
+	return output;
+}
+
+/*
+ * tbm_shared_claim - claim the next few pages from a shared iterator
+ *
+ * We need to acquire the iterator LWLock before accessing the shared
+ * members.  Sets iterator->nclaimed to zero if there are no pages left.
+ */
+static void
+tbm_shared_claim(TBMSharedIterator *iterator)
+{
 	TBMSharedIteratorState *istate = iterator->state;
 	PagetableEntry *ptbase = NULL;
 	int		   *idxpages = NULL;
 	int		   *idxchunks = NULL;
+	int			nwanted;
 
 	if (iterator->ptbase != NULL)
 		ptbase = iterator->ptbase->ptentry;
@@ -1063,75 +1132,83 @@ tbm_shared_iterate(TBMSharedIterator *iterator)
 	if (iterator->ptchunks != NULL)
 		idxchunks = iterator->ptchunks->index;
 
+	iterator->nclaimed = 0;
+	iterator->nextclaimed = 0;
+
 	/* Acquire the LWLock before accessing the shared members */
 	LWLockAcquire(&istate->lock, LW_EXCLUSIVE);
 
 	/*
-	 * If lossy chunk pages remain, make sure we've advanced schunkptr/
-	 * schunkbit to the next set bit.
+	 * Claim fewer pages as we near the end.  Each lossy chunk is counted as
+	 * one page here, so this is only a rough guide.
 	 */
-	while (istate->schunkptr < istate->nchunks)
-	{
-		PagetableEntry *chunk = &ptbase[idxchunks[istate->schunkptr]];
-		int			schunkbit = istate->schunkbit;
-
-		tbm_advance_schunkbit(chunk, &schunkbit);
-		if (schunkbit < PAGES_PER_CHUNK)
-		{
-			istate->schunkbit = schunkbit;
-			break;
-		}
-		/* advance to next chunk */
-		istate->schunkptr++;
-		istate->schunkbit = 0;
-	}
+	nwanted = ((istate->npages - istate->spageptr) +
+			   (istate->nchunks - istate->schunkptr)) / TBM_SHARED_ITERATE_BATCH;
+	nwanted = Max(nwanted, 1);
+	nwanted = Min(nwanted, TBM_SHARED_ITERATE_BATCH);
 
-	/*
-	 * If both chunk and per-page data remain, must output the numerically
-	 * earlier page.
-	 */
-	if (istate->schunkptr < istate->nchunks)
+	while (iterator->nclaimed < nwanted)
 	{
-		PagetableEntry *chunk = &ptbase[idxchunks[istate->schunkptr]];
-		BlockNumber chunk_blockno;
+		TBMSharedClaim *claim = &iterator->claimed[iterator->nclaimed];
 
-		chunk_blockno = chunk->blockno + istate->schunkbit;
-
-		if (istate->spageptr >= istate->npages ||
-			chunk_blockno < ptbase[idxpages[istate->spageptr]].blockno)
+		/*
+		 * If lossy chunk pages remain, make sure we've advanced schunkptr/
+		 * schunkbit to the next set bit.
+		 */
+		while (istate->schunkptr < istate->nchunks)
 		{
-			/* Return a lossy page indicator from the chunk */
-			output->blockno = chunk_blockno;
-			output->ntuples = -1;
-			output->recheck = true;
-			istate->schunkbit++;
+			PagetableEntry *chunk = &ptbase[idxchunks[istate->schunkptr]];
+			int			schunkbit = istate->schunkbit;
 
-			LWLockRelease(&istate->lock);
-			return output;
+			tbm_advance_schunkbit(chunk, &schunkbit);
+			if (schunkbit < PAGES_PER_CHUNK)
+			{
+				istate->schunkbit = schunkbit;
+				break;
+			}
+			/* advance to next chunk */
+			istate->schunkptr++;
+			istate->schunkbit = 0;
 		}
-	}
 
-	if (istate->spageptr < istate->npages)
-	{
-		PagetableEntry *page = &ptbase[idxpages[istate->spageptr]];
-		int			ntuples;
+		/*
+		 * If both chunk and per-page data remain, must output the numerically
+		 * earlier page.
+		 */
+		if (istate->schunkptr < istate->nchunks)
+		{
+			PagetableEntry *chunk = &ptbase[idxchunks[istate->schunkptr]];
+			BlockNumber chunk_blockno;
 
-		/* scan bitmap to extract individual offset numbers */
-		ntuples = tbm_extract_page_tuple(page, output);
-		output->blockno = page->blockno;
-		output->ntuples = ntuples;
-		output->recheck = page->recheck;
-		istate->spageptr++;
+			chunk_blockno = chunk->blockno + istate->schunkbit;
 
-		LWLockRelease(&istate->lock);
+			if (istate->spageptr >= istate->npages ||
+				chunk_blockno < ptbase[idxpages[istate->spageptr]].blockno)
+			{
+				/* Claim a lossy page from the chunk */
+				claim->blockno = chunk_blockno;
+				claim->pageidx = -1;
+				istate->schunkbit++;
+				iterator->nclaimed++;
+				continue;
+			}
+		}
 
-		return output;
+		if (istate->spageptr < istate->npages)
+		{
+			/* Claim an exact page; its tuples are extracted when returned */
+			claim->blockno = InvalidBlockNumber;
+			claim->pageidx = istate->spageptr;
+			istate->spageptr++;
+			iterator->nclaimed++;
+			continue;
+		}
+
+		/* Nothing more in the bitmap */
+		break;
 	}
 
 	LWLockRelease(&istate->lock);
-
-	/* Nothing more in the bitmap */
-	return NULL;
 }
 
 /*
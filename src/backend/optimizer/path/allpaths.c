@@ -18,11 +18,14 @@
 #include <limits.h>
 #include <math.h>
 
+#include "access/stratnum.h"
 #include "access/sysattr.h"
 #include "access/tsmapi.h"
 #include "catalog/pg_class.h"
+#include "catalog/pg_opfamily.h"
 #include "catalog/pg_operator.h"
 #include "catalog/pg_proc.h"
+#include "catalog/pg_type.h"
 #include "foreign/fdwapi.h"
 #include "miscadmin.h"
 #include "nodes/makefuncs.h"
@@ -43,8 +46,10 @@
 #include "optimizer/var.h"
 #include "parser/parse_clause.h"
 #include "parser/parsetree.h"
+#include "partitioning/partbounds.h"
 #include "partitioning/partprune.h"
 #include "rewrite/rewriteManip.h"
+#include "utils/fmgroids.h"
 #include "utils/lsyscache.h"
 
 
@@ -99,6 +104,13 @@ static void generate_mergeappend_paths(PlannerInfo *root, RelOptInfo *rel,
 						   List *live_childrels,
 						   List *all_child_pathkeys,
 						   List *partitioned_rels);
+static void generate_ordered_partial_append_paths(PlannerInfo *root,
+									  RelOptInfo *rel,
+									  List *live_childrels,
+									  List *partitioned_rels,
+									  double partial_rows);
+static bool partition_order_matches_pathkeys(RelOptInfo *rel,
+								 List *pathkeys, bool *reverse);
 static Path *get_cheapest_parameterized_child_path(PlannerInfo *root,
 									  RelOptInfo *rel,
 									  Relids required_outer);
@@ -132,6 +144,8 @@ static bool qual_is_pushdown_safe(Query *subquery, Index rti, Node *qual,
 					  pushdown_safety_info *safetyInfo);
 static void subquery_push_qual(Query *subquery,
 				   RangeTblEntry *rte, Index rti, Node *qual);
+static void check_and_push_window_qual(Query *subquery, Index rti,
+						   Node *qual);
 static void recurse_push_qual(Node *setOp, Query *topquery,
 				  RangeTblEntry *rte, Index rti, Node *qual);
 static void remove_unused_subquery_outputs(Query *subquery, RelOptInfo *rel);
@@ -1638,7 +1652,7 @@ add_paths_to_append_rel(PlannerInfo *root, RelOptInfo *rel,
 	 */
 	if (subpaths_valid)
 		add_path(rel, (Path *) create_append_path(root, rel, subpaths, NIL,
-												  NULL, 0, false,
+												  NIL, NULL, 0, false,
 												  partitioned_rels, -1));
 
 	/*
@@ -1680,7 +1694,7 @@ add_paths_to_append_rel(PlannerInfo *root, RelOptInfo *rel,
 
 		/* Generate a partial append path. */
 		appendpath = create_append_path(root, rel, NIL, partial_subpaths,
-										NULL, parallel_workers,
+										NIL, NULL, parallel_workers,
 										enable_parallel_append,
 										partitioned_rels, -1);
 
@@ -1730,11 +1744,21 @@ add_paths_to_append_rel(PlannerInfo *root, RelOptInfo *rel,
 
 		appendpath = create_append_path(root, rel, pa_nonpartial_subpaths,
 										pa_partial_subpaths,
-										NULL, parallel_workers, true,
+										NIL, NULL, parallel_workers, true,
 										partitioned_rels, partial_rows);
 		add_partial_path(rel, (Path *) appendpath);
 	}
 
+	/*
+	 * If the partitions' bounds already follow an ordering the children can
+	 * produce, a partial Append that runs them in that order yields sorted
+	 * output in each worker, which Gather Merge can use without any sort.
+	 */
+	if (partial_subpaths_valid)
+		generate_ordered_partial_append_paths(root, rel, live_childrels,
+											  partitioned_rels,
+											  partial_rows);
+
 	/*
 	 * Also build unparameterized MergeAppend paths based on the collected
 	 * list of child pathkeys.
@@ -1792,7 +1816,7 @@ add_paths_to_append_rel(PlannerInfo *root, RelOptInfo *rel,
 		if (subpaths_valid)
 			add_path(rel, (Path *)
 					 create_append_path(root, rel, subpaths, NIL,
-										required_outer, 0, false,
+										NIL, required_outer, 0, false,
 										partitioned_rels, -1));
 	}
 }
@@ -1900,6 +1924,165 @@ generate_mergeappend_paths(PlannerInfo *root, RelOptInfo *rel,
 	}
 }
 
+/*
+ * generate_ordered_partial_append_paths
+ *		Generate sorted partial Append paths for a range-partitioned rel
+ *
+ * For a range-partitioned table without a default partition, all the rows of
+ * a partition sort before (or, for descending order, after) those of every
+ * later partition on the partition key.  So if each partition is scanned
+ * with a partial path sorted on a prefix of the partition key, running the
+ * partitions one after the other gives sorted output in every participating
+ * process.  The Append is deliberately not parallel-aware: all processes
+ * work through the partitions in the same order, sharing each partial scan,
+ * rather than being spread out over different partitions.  This is
+ * particularly useful for ORDER BY ... LIMIT over time-partitioned data,
+ * where the later partitions need not be scanned at all.
+ *
+ * We consider each ordering available from the first child's partial
+ * paths, since only those can be available from all the children.
+ */
+static void
+generate_ordered_partial_append_paths(PlannerInfo *root, RelOptInfo *rel,
+									  List *live_childrels,
+									  List *partitioned_rels,
+									  double partial_rows)
+{
+	List	   *ordered_childrels = NIL;
+	RelOptInfo *first_childrel;
+	ListCell   *lcp;
+	int			i;
+
+	if (!IS_SIMPLE_REL(rel) || rel->part_scheme == NULL ||
+		rel->part_scheme->strategy != PARTITION_STRATEGY_RANGE ||
+		rel->boundinfo == NULL ||
+		partition_bound_has_default(rel->boundinfo))
+		return;
+
+	/* Put the live children in partition bound order */
+	for (i = 0; i < rel->nparts; i++)
+	{
+		RelOptInfo *childrel = rel->part_rels[i];
+
+		if (childrel != NULL && list_member_ptr(live_childrels, childrel))
+			ordered_childrels = lappend(ordered_childrels, childrel);
+	}
+	if (ordered_childrels == NIL ||
+		list_length(ordered_childrels) != list_length(live_childrels))
+		return;
+
+	first_childrel = (RelOptInfo *) linitial(ordered_childrels);
+	foreach(lcp, first_childrel->partial_pathlist)
+	{
+		List	   *pathkeys = ((Path *) lfirst(lcp))->pathkeys;
+		List	   *childpaths = NIL;
+		List	   *subpaths = NIL;
+		int			parallel_workers = 0;
+		bool		reverse = false;
+		ListCell   *lcr;
+
+		if (pathkeys == NIL ||
+			!partition_order_matches_pathkeys(rel, pathkeys, &reverse))
+			continue;
+
+		/* Select the cheapest suitably-sorted partial path of each child */
+		foreach(lcr, ordered_childrels)
+		{
+			RelOptInfo *childrel = (RelOptInfo *) lfirst(lcr);
+			Path	   *childpath;
+
+			childpath = get_cheapest_path_for_pathkeys(childrel->partial_pathlist,
+													   pathkeys,
+													   NULL,
+													   TOTAL_COST,
+													   false);
+			if (childpath == NULL)
+				break;
+
+			parallel_workers = Max(parallel_workers,
+								   childpath->parallel_workers);
+			if (reverse)
+				childpaths = lcons(childpath, childpaths);
+			else
+				childpaths = lappend(childpaths, childpath);
+		}
+		if (lcr != NULL)
+			continue;
+
+		/* Flattening child Appends keeps their subpaths in order, too */
+		foreach(lcr, childpaths)
+			accumulate_append_subpath((Path *) lfirst(lcr), &subpaths, NULL);
+
+		Assert(parallel_workers > 0);
+		add_partial_path(rel, (Path *)
+						 create_append_path(root, rel, NIL, subpaths,
+											pathkeys, NULL,
+											parallel_workers, false,
+											partitioned_rels, partial_rows));
+	}
+}
+
+/*
+ * partition_order_matches_pathkeys
+ *		Does scanning rel's partitions in bound order satisfy 'pathkeys'?
+ *
+ * This is so if the pathkeys match a prefix of the partition key, using the
+ * partitioning opfamilies and collations, and are all in the same direction.
+ * *reverse is set to true if that direction is descending, meaning that the
+ * partitions must be scanned in reverse order.
+ */
+static bool
+partition_order_matches_pathkeys(RelOptInfo *rel, List *pathkeys,
+								 bool *reverse)
+{
+	PartitionScheme partscheme = rel->part_scheme;
+	ListCell   *lc;
+	int			keyno = 0;
+
+	if (list_length(pathkeys) > partscheme->partnatts)
+		return false;
+
+	foreach(lc, pathkeys)
+	{
+		PathKey    *pathkey = (PathKey *) lfirst(lc);
+		EquivalenceClass *ec = pathkey->pk_eclass;
+		bool		descending;
+		bool		found = false;
+		ListCell   *lcm;
+
+		if (pathkey->pk_opfamily != partscheme->partopfamily[keyno] ||
+			ec->ec_collation != partscheme->partcollation[keyno])
+			return false;
+
+		descending = (pathkey->pk_strategy == BTGreaterStrategyNumber);
+		if (keyno == 0)
+			*reverse = descending;
+		else if (descending != *reverse)
+			return false;
+
+		foreach(lcm, ec->ec_members)
+		{
+			EquivalenceMember *em = (EquivalenceMember *) lfirst(lcm);
+			Expr	   *expr = em->em_expr;
+
+			while (expr && IsA(expr, RelabelType))
+				expr = ((RelabelType *) expr)->arg;
+
+			if (list_member(rel->partexprs[keyno], expr))
+			{
+				found = true;
+				break;
+			}
+		}
+		if (!found)
+			return false;
+
+		keyno++;
+	}
+
+	return true;
+}
+
 /*
  * get_cheapest_parameterized_child_path
  *		Get cheapest path for this relation that has exactly the requested
@@ -2057,8 +2240,8 @@ set_dummy_rel_pathlist(RelOptInfo *rel)
 	rel->pathlist = NIL;
 	rel->partial_pathlist = NIL;
 
-	add_path(rel, (Path *) create_append_path(NULL, rel, NIL, NIL, NULL,
-											  0, false, NIL, -1));
+	add_path(rel, (Path *) create_append_path(NULL, rel, NIL, NIL, NIL,
+											  NULL, 0, false, NIL, -1));
 
 	/*
 	 * We set the cheapest path immediately, to ensure that IS_DUMMY_REL()
@@ -2189,7 +2372,12 @@ set_subquery_pathlist(PlannerInfo *root, RelOptInfo *rel,
 			}
 			else
 			{
-				/* Keep it in the upper query */
+				/*
+				 * Keep it in the upper query, but a filter on a window
+				 * function might still let the WindowAgg stop early.
+				 */
+				if (!rinfo->pseudoconstant && subquery->windowClause != NIL)
+					check_and_push_window_qual(subquery, rti, clause);
 				upperrestrictlist = lappend(upperrestrictlist, rinfo);
 			}
 		}
@@ -2618,7 +2806,8 @@ generate_gather_paths(PlannerInfo *root, RelOptInfo *rel, bool override_rows)
 
 		rows = subpath->rows * subpath->parallel_workers;
 		path = create_gather_merge_path(root, rel, subpath, rel->reltarget,
-										subpath->pathkeys, NULL, rowsp);
+										subpath->pathkeys, NULL, rowsp,
+										false);
 		add_path(rel, &path->path);
 	}
 }
@@ -2690,7 +2879,8 @@ make_rel_from_joinlist(PlannerInfo *root, List *joinlist)
 	{
 		/*
 		 * Consider the different orders in which we could join the rels,
-		 * using a plugin, GEQO, or the regular join search code.
+		 * using a plugin, GEQO, the greedy search, or the regular join
+		 * search code.
 		 *
 		 * We put the initial_rels list into a PlannerInfo field because
 		 * has_legal_joinclause() needs to look at it (ugly :-().
@@ -2701,6 +2891,8 @@ make_rel_from_joinlist(PlannerInfo *root, List *joinlist)
 			return (*join_search_hook) (root, levels_needed, initial_rels);
 		else if (enable_geqo && levels_needed >= geqo_threshold)
 			return geqo(root, levels_needed, initial_rels);
+		else if (levels_needed >= greedy_join_threshold)
+			return greedy_join_search(root, levels_needed, initial_rels);
 		else
 			return standard_join_search(root, levels_needed, initial_rels);
 	}
@@ -3229,6 +3421,130 @@ qual_is_pushdown_safe(Query *subquery, Index rti, Node *qual,
 	return safe;
 }
 
+/*
+ * check_and_push_window_qual - give a window function filter to the WindowAgg
+ *
+ * A qual such as "rn <= 10" on a subquery output column computed as
+ * row_number(), rank() or dense_rank() can't be pushed into the subquery's
+ * WHERE clause, but these functions never decrease within a partition, so
+ * once the qual fails for a row it fails for all later rows of the partition.
+ * We add an equivalent "function < or <= value" test to the WindowClause's
+ * runCondition, letting the executor skip the rest of the partition as soon
+ * as it fails.  The qual itself must still be evaluated by the upper query;
+ * for "=" only the "<=" half is enforced by the run condition.
+ *
+ * We only do this when the subquery has a single window clause, so that no
+ * other WindowAgg sits above this one needing the rows we skip, and when
+ * nothing between the WindowAgg and the subquery's output could be affected
+ * by missing rows.  Our caller has already checked subquery_is_pushdown_safe,
+ * which rules out LIMIT/OFFSET and set operations.
+ */
+static void
+check_and_push_window_qual(Query *subquery, Index rti, Node *qual)
+{
+	OpExpr	   *opexpr;
+	Node	   *larg;
+	Node	   *rarg;
+	Var		   *var;
+	Node	   *otherexpr;
+	bool		wfunc_left;
+	TargetEntry *tle;
+	WindowFunc *wfunc;
+	WindowClause *wc;
+	int			strategy;
+	Oid			lefttype;
+	Oid			righttype;
+	Oid			opno;
+	Expr	   *runcond;
+
+	if (list_length(subquery->windowClause) != 1 ||
+		subquery->distinctClause != NIL ||
+		subquery->hasTargetSRFs)
+		return;
+
+	if (!is_opclause(qual) || list_length(((OpExpr *) qual)->args) != 2)
+		return;
+	opexpr = (OpExpr *) qual;
+	larg = linitial(opexpr->args);
+	rarg = lsecond(opexpr->args);
+
+	/* One side must be a subquery output column, the other a constant */
+	if (IsA(larg, Var))
+	{
+		var = (Var *) larg;
+		otherexpr = rarg;
+		wfunc_left = true;
+	}
+	else if (IsA(rarg, Var))
+	{
+		var = (Var *) rarg;
+		otherexpr = larg;
+		wfunc_left = false;
+	}
+	else
+		return;
+
+	if (var->varno != rti || var->varlevelsup != 0 || var->varattno <= 0)
+		return;
+	if (!IsA(otherexpr, Const) &&
+		!(IsA(otherexpr, Param) &&
+		  ((Param *) otherexpr)->paramkind == PARAM_EXTERN))
+		return;
+
+	/* The column must be one of the window functions we know about */
+	tle = get_tle_by_resno(subquery->targetList, var->varattno);
+	if (tle == NULL || tle->resjunk || !IsA(tle->expr, WindowFunc))
+		return;
+	wfunc = (WindowFunc *) tle->expr;
+	if (wfunc->winfnoid != F_WINDOW_ROW_NUMBER &&
+		wfunc->winfnoid != F_WINDOW_RANK &&
+		wfunc->winfnoid != F_WINDOW_DENSE_RANK)
+		return;
+	wc = linitial_node(WindowClause, subquery->windowClause);
+	if (wfunc->winref != wc->winref)
+		return;
+
+	/*
+	 * Find out what the operator means, and turn it into "wfunc < value" or
+	 * "wfunc <= value".
+	 */
+	strategy = get_op_opfamily_strategy(opexpr->opno, INTEGER_BTREE_FAM_OID);
+	if (!wfunc_left)
+	{
+		switch (strategy)
+		{
+			case BTGreaterStrategyNumber:
+				strategy = BTLessStrategyNumber;
+				break;
+			case BTGreaterEqualStrategyNumber:
+				strategy = BTLessEqualStrategyNumber;
+				break;
+			case BTEqualStrategyNumber:
+				break;
+			default:
+				return;
+		}
+	}
+	if (strategy == BTEqualStrategyNumber)
+		strategy = BTLessEqualStrategyNumber;
+	if (strategy != BTLessStrategyNumber &&
+		strategy != BTLessEqualStrategyNumber)
+		return;
+
+	lefttype = exprType((Node *) wfunc);
+	righttype = exprType(otherexpr);
+	opno = get_opfamily_member(INTEGER_BTREE_FAM_OID, lefttype, righttype,
+							   strategy);
+	if (!OidIsValid(opno))
+		return;
+
+	runcond = make_opclause(opno, BOOLOID, false,
+							(Expr *) copyObject(wfunc),
+							(Expr *) copyObject(otherexpr),
+							InvalidOid, InvalidOid);
+	wc->runCondition = lappend(wc->runCondition, runcond);
+}
+
 /*
  * subquery_push_qual - push down a qual that we have determined is safe
  */
@@ -3585,7 +3901,9 @@ generate_partitionwise_join_paths(PlannerInfo *root, RelOptInfo *rel)
 	{
 		RelOptInfo *child_rel = part_rels[cnt_parts];
 
-		Assert(child_rel != NULL);
+		/* A missing child-join is known to be empty; see try_partitionwise_join */
+		if (child_rel == NULL)
+			continue;
 
 		/* Add partitionwise join paths for partitioned child-joins. */
 		generate_partitionwise_join_paths(root, child_rel);
@@ -3714,6 +4032,9 @@ print_path(PlannerInfo *root, Path *path, int indent)
 		case T_TidPath:
 			ptype = "TidScan";
 			break;
+		case T_TidRangePath:
+			ptype = "TidRangePath";
+			break;
 		case T_SubqueryScanPath:
 			ptype = "SubqueryScanScan";
 			break;
@@ -3772,6 +4093,10 @@ print_path(PlannerInfo *root, Path *path, int indent)
 			ptype = "Sort";
 			subpath = ((SortPath *) path)->subpath;
 			break;
+		case T_IncrementalSortPath:
+			ptype = "IncrementalSort";
+			subpath = ((SortPath *) path)->subpath;
+			break;
 		case T_GroupPath:
 			ptype = "Group";
 			subpath = ((GroupPath *) path)->subpath;
@@ -65,9 +65,9 @@ static RelOptInfo *find_single_rel_for_clauses(PlannerInfo *root,
  *
  * If the clauses taken together refer to just one relation, we'll try to
  * apply selectivity estimates using any extended statistics for that rel.
- * Currently we only have (soft) functional dependencies, so apply these in as
- * many cases as possible, and fall back on normal estimates for remaining
- * clauses.
+ * We first apply multivariate MCV lists, then (soft) functional dependencies
+ * to the clauses not estimated by them, and fall back on normal estimates
+ * (see clauselist_selectivity_simple) for the remaining clauses.
  *
  * We also recognize "range queries", such as "x > 34 AND x < 42".  Clauses
  * are recognized as possible range query components if they are restriction
@@ -105,9 +105,6 @@ clauselist_selectivity(PlannerInfo *root,
 	Selectivity s1 = 1.0;
 	RelOptInfo *rel;
 	Bitmapset  *estimatedclauses = NULL;
-	RangeQueryClause *rqlist = NULL;
-	ListCell   *l;
-	int			listidx;
 
 	/*
 	 * If there's exactly one clause, just go directly to
@@ -126,20 +123,65 @@ clauselist_selectivity(PlannerInfo *root,
 	{
 		/*
 		 * Perform selectivity estimations on any clauses found applicable by
-		 * dependencies_clauselist_selectivity.  'estimatedclauses' will be
-		 * filled with the 0-based list positions of clauses used that way, so
-		 * that we can ignore them below.
+		 * mcv_clauselist_selectivity.  'estimatedclauses' will be filled
+		 * with the 0-based list positions of clauses used that way, so that
+		 * we can ignore them below.
 		 */
-		s1 *= dependencies_clauselist_selectivity(root, clauses, varRelid,
-												  jointype, sjinfo, rel,
-												  &estimatedclauses);
+		s1 *= mcv_clauselist_selectivity(root, clauses, varRelid,
+										 jointype, sjinfo, rel,
+										 &estimatedclauses);
 
 		/*
-		 * This would be the place to apply any other types of extended
-		 * statistics selectivity estimations for remaining clauses.
+		 * Then apply functional dependencies to the remaining clauses, which
+		 * adds those it uses to 'estimatedclauses' too.
 		 */
+		s1 *= dependencies_clauselist_selectivity(root, clauses, varRelid,
+												  jointype, sjinfo, rel,
+												  &estimatedclauses);
 	}
 
+	/*
+	 * Apply normal selectivity estimates for the remaining clauses.
+	 */
+	return s1 * clauselist_selectivity_simple(root, clauses, varRelid,
+											  jointype, sjinfo,
+											  estimatedclauses);
+}
+
+/*
+ * clauselist_selectivity_simple -
+ *	  Compute the selectivity of an implicitly-ANDed list of boolean
+ *	  expression clauses, without using any extended statistics.
+ *
+ * This is the part of clauselist_selectivity that multiplies together the
+ * selectivities of the individual clauses, handling range queries as
+ * described there.  Clauses whose (0-based) list position is a member of
+ * 'estimatedclauses' are skipped, as they were already estimated by the
+ * caller.  The extended statistics code also uses this to get the estimate
+ * that assumes the columns to be independent.
+ */
+Selectivity
+clauselist_selectivity_simple(PlannerInfo *root,
+							  List *clauses,
+							  int varRelid,
+							  JoinType jointype,
+							  SpecialJoinInfo *sjinfo,
+							  Bitmapset *estimatedclauses)
+{
+	Selectivity s1 = 1.0;
+	RangeQueryClause *rqlist = NULL;
+	ListCell   *l;
+	int			listidx;
+
+	/*
+	 * If there's exactly one clause (and it was not estimated yet), just go
+	 * directly to clause_selectivity(). None of what we might do below is
+	 * relevant.
+	 */
+	if (list_length(clauses) == 1 && bms_is_empty(estimatedclauses))
+		return clause_selectivity(root, (Node *) linitial(clauses),
+								  varRelid, jointype, sjinfo);
+
 	/*
 	 * Apply normal selectivity estimates for remaining clauses. We'll be
 	 * careful to skip any clauses which were already estimated above.
@@ -0,0 +1,251 @@
+/*-------------------------------------------------------------------------
+ *
+ * greedyjoin.c
+ *	  Greedy join order search for large join problems
+ *
+ * standard_join_search() considers every way of joining the input items,
+ * which becomes impractical somewhere beyond a dozen items.  The routines
+ * here instead build the join tree bottom-up by repeatedly joining the pair
+ * of components whose join is cheapest, until a single component is left.
+ * This is the "greedy operator ordering" approach; unlike GEQO it is fully
+ * deterministic, and it can produce bushy plans.
+ *
+ * Each candidate join is planned in a short-lived memory context, in the
+ * same way geqo_eval() does it, so that only the joinrels actually chosen
+ * survive.  Candidate costs are remembered, so that after a merge only the
+ * pairs involving the new component need to be re-planned; the whole search
+ * thus plans O(N^2) joinrels for N input items.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/optimizer/path/greedyjoin.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include <float.h>
+
+#include "optimizer/joininfo.h"
+#include "optimizer/pathnode.h"
+#include "optimizer/paths.h"
+#include "utils/memutils.h"
+
+
+int			greedy_join_threshold;
+
+/* Marker for a candidate pair whose cost has not been computed yet */
+#define GREEDY_COST_UNKNOWN		(-1.0)
+
+static void finish_greedy_joinrel(PlannerInfo *root, RelOptInfo *joinrel,
+					  bool is_top_rel);
+static Cost greedy_join_cost(PlannerInfo *root, MemoryContext tmpcontext,
+				 RelOptInfo *rel1, RelOptInfo *rel2, bool is_top_rel);
+
+
+/*
+ * greedy_join_search
+ *	  Find a join order for 'initial_rels' by greedily joining the cheapest
+ *	  pair of components at each step.
+ *
+ * The arguments and result are as for standard_join_search().
+ *
+ * At each step we only consider joins that make use of a join clause or that
+ * are required by a join order restriction, as in GEQO's desirable_join().
+ * If no such join is legal, we fall back to allowing clauseless joins.
+ */
+RelOptInfo *
+greedy_join_search(PlannerInfo *root, int levels_needed, List *initial_rels)
+{
+	RelOptInfo **rels;
+	int		   *sizes;
+	Cost	   *costs;
+	int			ncomponents;
+	int			i;
+	ListCell   *lc;
+	MemoryContext tmpcontext;
+
+	/* join_rel_level[] shouldn't be in use, so just Assert it isn't */
+	Assert(root->join_rel_level == NULL);
+	Assert(levels_needed == list_length(initial_rels));
+
+	/*
+	 * rels[] holds the current components; a NULL entry is one that has been
+	 * absorbed into another.  costs[] is a levels_needed x levels_needed
+	 * matrix of which only the upper triangle is used.
+	 */
+	rels = (RelOptInfo **) palloc(levels_needed * sizeof(RelOptInfo *));
+	sizes = (int *) palloc(levels_needed * sizeof(int));
+	costs = (Cost *) palloc(levels_needed * levels_needed * sizeof(Cost));
+
+	i = 0;
+	foreach(lc, initial_rels)
+	{
+		rels[i] = (RelOptInfo *) lfirst(lc);
+		sizes[i] = 1;
+		i++;
+	}
+	for (i = 0; i < levels_needed * levels_needed; i++)
+		costs[i] = GREEDY_COST_UNKNOWN;
+
+	/*
+	 * Candidate joins are planned in this context, which is reset after each
+	 * one.  Make it a child of the planner's context, so that it goes away
+	 * even if we error out.
+	 */
+	tmpcontext = AllocSetContextCreate(CurrentMemoryContext,
+									   "greedy join search",
+									   ALLOCSET_DEFAULT_SIZES);
+
+	for (ncomponents = levels_needed; ncomponents > 1; ncomponents--)
+	{
+		int			best_i = -1;
+		int			best_j = -1;
+		Cost		best_cost = DBL_MAX;
+		bool		force;
+		RelOptInfo *joinrel;
+		bool		is_top_rel;
+
+		for (force = false; best_i < 0; force = true)
+		{
+			for (i = 0; i < levels_needed; i++)
+			{
+				int			j;
+
+				if (rels[i] == NULL)
+					continue;
+
+				for (j = i + 1; j < levels_needed; j++)
+				{
+					Cost	   *cost = &costs[i * levels_needed + j];
+
+					if (rels[j] == NULL)
+						continue;
+
+					if (!force &&
+						!have_relevant_joinclause(root, rels[i], rels[j]) &&
+						!have_join_order_restriction(root, rels[i], rels[j]))
+						continue;
+
+					if (*cost == GREEDY_COST_UNKNOWN)
+						*cost = greedy_join_cost(root, tmpcontext,
+												 rels[i], rels[j],
+												 ncomponents == 2);
+
+					/* Ties go to the earliest pair, to keep this stable */
+					if (*cost < best_cost)
+					{
+						best_cost = *cost;
+						best_i = i;
+						best_j = j;
+					}
+				}
+			}
+
+			if (force)
+				break;
+		}
+
+		if (best_i < 0)
+			elog(ERROR, "failed to build any %d-way joins", levels_needed);
+
+		/* Build the chosen joinrel for real, in the planner's context */
+		is_top_rel = (sizes[best_i] + sizes[best_j] == levels_needed);
+		joinrel = make_join_rel(root, rels[best_i], rels[best_j]);
+		if (joinrel == NULL)
+			elog(ERROR, "failed to build any %d-way joins", levels_needed);
+		finish_greedy_joinrel(root, joinrel, is_top_rel);
+
+		/* The new component replaces best_i; best_j is gone */
+		rels[best_i] = joinrel;
+		sizes[best_i] += sizes[best_j];
+		rels[best_j] = NULL;
+
+		/* Forget the costs of all pairs involving the new component */
+		for (i = 0; i < levels_needed; i++)
+		{
+			if (i < best_i)
+				costs[i * levels_needed + best_i] = GREEDY_COST_UNKNOWN;
+			else if (i > best_i)
+				costs[best_i * levels_needed + i] = GREEDY_COST_UNKNOWN;
+		}
+	}
+
+	MemoryContextDelete(tmpcontext);
+
+	for (i = 0; i < levels_needed; i++)
+	{
+		if (rels[i] != NULL)
+			return rels[i];
+	}
+
+	elog(ERROR, "failed to build any %d-way joins", levels_needed);
+	return NULL;				/* keep compiler quiet */
+}
+
+/*
+ * Finish building paths for a joinrel made by make_join_rel(), the way
+ * standard_join_search() does at the end of each level.
+ */
+static void
+finish_greedy_joinrel(PlannerInfo *root, RelOptInfo *joinrel, bool is_top_rel)
+{
+	/* Create paths for partitionwise joins. */
+	generate_partitionwise_join_paths(root, joinrel);
+
+	/*
+	 * Except for the topmost scan/join rel, consider gathering partial paths.
+	 * We'll do the same for the topmost scan/join rel once we know the final
+	 * targetlist (see grouping_planner).
+	 */
+	if (!is_top_rel)
+		generate_gather_paths(root, joinrel, false);
+
+	/* Find and save the cheapest paths for this joinrel */
+	set_cheapest(joinrel);
+}
+
+/*
+ * Estimate the cost of joining rel1 and rel2, as the total cost of the
+ * cheapest path for their join.  Returns DBL_MAX if the join is not legal.
+ *
+ * The joinrel is built in tmpcontext and discarded afterwards.  As in
+ * geqo_eval(), we must make sure that root->join_rel_list and
+ * root->join_rel_hash are left as we found them.
+ */
+static Cost
+greedy_join_cost(PlannerInfo *root, MemoryContext tmpcontext,
+				 RelOptInfo *rel1, RelOptInfo *rel2, bool is_top_rel)
+{
+	MemoryContext oldcxt;
+	RelOptInfo *joinrel;
+	Cost		cost;
+	int			savelength;
+	struct HTAB *savehash;
+
+	oldcxt = MemoryContextSwitchTo(tmpcontext);
+
+	savelength = list_length(root->join_rel_list);
+	savehash = root->join_rel_hash;
+	root->join_rel_hash = NULL;
+
+	joinrel = make_join_rel(root, rel1, rel2);
+	if (joinrel)
+	{
+		finish_greedy_joinrel(root, joinrel, is_top_rel);
+		cost = joinrel->cheapest_total_path->total_cost;
+	}
+	else
+		cost = DBL_MAX;
+
+	root->join_rel_list = list_truncate(root->join_rel_list, savelength);
+	root->join_rel_hash = savehash;
+
+	MemoryContextSwitchTo(oldcxt);
+	MemoryContextReset(tmpcontext);
+
+	return cost;
+}
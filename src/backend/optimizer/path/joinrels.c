@@ -1231,8 +1231,8 @@ mark_dummy_rel(RelOptInfo *rel)
 	rel->partial_pathlist = NIL;
 
 	/* Set up the dummy path */
-	add_path(rel, (Path *) create_append_path(NULL, rel, NIL, NIL, NULL,
-											  0, false, NIL, -1));
+	add_path(rel, (Path *) create_append_path(NULL, rel, NIL, NIL, NIL,
+											  NULL, 0, false, NIL, -1));
 
 	/* Set or update cheapest_total_path and related fields */
 	set_cheapest(rel);
@@ -1294,7 +1294,8 @@ restriction_is_constant_false(List *restrictlist,
  *
  * Partitionwise join is possible when a. Joining relations have same
  * partitioning scheme b. There exists an equi-join between the partition keys
- * of the two relations.
+ * of the two relations c. Each partition of either relation overlaps at most
+ * one partition of the other; see partition_bounds_merge().
  *
  * Partitionwise join is planned as follows (details: optimizer/README.)
  *
@@ -1314,6 +1315,10 @@ try_partitionwise_join(PlannerInfo *root, RelOptInfo *rel1, RelOptInfo *rel2,
 {
 	int			nparts;
 	int			cnt_parts;
+	List	   *parts1 = NIL;
+	List	   *parts2 = NIL;
+	ListCell   *lc1 = NULL;
+	ListCell   *lc2 = NULL;
 
 	/* Guard against stack overflow due to overly deep partition hierarchy. */
 	check_stack_depth();
@@ -1328,9 +1333,12 @@ try_partitionwise_join(PlannerInfo *root, RelOptInfo *rel1, RelOptInfo *rel2,
 	/*
 	 * Since this join relation is partitioned, all the base relations
 	 * participating in this join must be partitioned and so are all the
-	 * intermediate join relations.
+	 * intermediate join relations.  However, an intermediate join relation
+	 * may have been made unpartitioned below, if some of its partitions were
+	 * pruned; then we can't do a partitionwise join with it.
 	 */
-	Assert(IS_PARTITIONED_REL(rel1) && IS_PARTITIONED_REL(rel2));
+	if (!IS_PARTITIONED_REL(rel1) || !IS_PARTITIONED_REL(rel2))
+		return;
 	Assert(REL_HAS_ALL_PART_PROPS(rel1) && REL_HAS_ALL_PART_PROPS(rel2));
 
 	/* The joining relations should have consider_partitionwise_join set. */
@@ -1344,21 +1352,45 @@ try_partitionwise_join(PlannerInfo *root, RelOptInfo *rel1, RelOptInfo *rel2,
 	Assert(joinrel->part_scheme == rel1->part_scheme &&
 		   joinrel->part_scheme == rel2->part_scheme);
 
+	nparts = joinrel->nparts;
+
 	/*
-	 * Since we allow partitionwise join only when the partition bounds of the
-	 * joining relations exactly match, the partition bounds of the join
-	 * should match those of the joining relations.
+	 * If the joining relations have the same partition bounds as the join,
+	 * the partitions at the same positions are to be joined.  Otherwise, the
+	 * bounds of the join were computed by partition_bounds_merge(), maybe
+	 * from another pair of relations that this join can be built from.
+	 * Match up the partitions of these ones the same way; if that produces
+	 * different bounds, we can't use them for a partitionwise join.
 	 */
-	Assert(partition_bounds_equal(joinrel->part_scheme->partnatts,
-								  joinrel->part_scheme->parttyplen,
-								  joinrel->part_scheme->parttypbyval,
-								  joinrel->boundinfo, rel1->boundinfo));
-	Assert(partition_bounds_equal(joinrel->part_scheme->partnatts,
-								  joinrel->part_scheme->parttyplen,
-								  joinrel->part_scheme->parttypbyval,
-								  joinrel->boundinfo, rel2->boundinfo));
-
-	nparts = joinrel->nparts;
+	if (rel1->nparts != nparts || rel2->nparts != nparts ||
+		!partition_bounds_equal(joinrel->part_scheme->partnatts,
+								joinrel->part_scheme->parttyplen,
+								joinrel->part_scheme->parttypbyval,
+								joinrel->boundinfo, rel1->boundinfo) ||
+		!partition_bounds_equal(joinrel->part_scheme->partnatts,
+								joinrel->part_scheme->parttyplen,
+								joinrel->part_scheme->parttypbyval,
+								joinrel->boundinfo, rel2->boundinfo))
+	{
+		PartitionBoundInfo boundinfo;
+
+		boundinfo = partition_bounds_merge(joinrel->part_scheme->partnatts,
+										   joinrel->part_scheme->partsupfunc,
+										   joinrel->part_scheme->partcollation,
+										   rel1->boundinfo, rel1->nparts,
+										   rel2->boundinfo, rel2->nparts,
+										   parent_sjinfo->jointype,
+										   &parts1, &parts2);
+		if (boundinfo == NULL || list_length(parts1) != nparts ||
+			!partition_bounds_equal(joinrel->part_scheme->partnatts,
+									joinrel->part_scheme->parttyplen,
+									joinrel->part_scheme->parttypbyval,
+									joinrel->boundinfo, boundinfo))
+			return;
+
+		lc1 = list_head(parts1);
+		lc2 = list_head(parts2);
+	}
 
 	/*
 	 * Create child-join relations for this partitioned join, if those don't
@@ -1367,8 +1399,8 @@ try_partitionwise_join(PlannerInfo *root, RelOptInfo *rel1, RelOptInfo *rel2,
 	 */
 	for (cnt_parts = 0; cnt_parts < nparts; cnt_parts++)
 	{
-		RelOptInfo *child_rel1 = rel1->part_rels[cnt_parts];
-		RelOptInfo *child_rel2 = rel2->part_rels[cnt_parts];
+		RelOptInfo *child_rel1;
+		RelOptInfo *child_rel2;
 		SpecialJoinInfo *child_sjinfo;
 		List	   *child_restrictlist;
 		RelOptInfo *child_joinrel;
@@ -1376,6 +1408,60 @@ try_partitionwise_join(PlannerInfo *root, RelOptInfo *rel1, RelOptInfo *rel2,
 		AppendRelInfo **appinfos;
 		int			nappinfos;
 
+		if (parts1 == NIL)
+		{
+			child_rel1 = rel1->part_rels[cnt_parts];
+			child_rel2 = rel2->part_rels[cnt_parts];
+		}
+		else
+		{
+			int			idx1 = lfirst_int(lc1);
+			int			idx2 = lfirst_int(lc2);
+
+			child_rel1 = (idx1 >= 0) ? rel1->part_rels[idx1] : NULL;
+			child_rel2 = (idx2 >= 0) ? rel2->part_rels[idx2] : NULL;
+			lc1 = lnext(lc1);
+			lc2 = lnext(lc2);
+		}
+
+		/*
+		 * Partitions pruned during inheritance expansion have no RelOptInfo,
+		 * and neither do partitions that exist on one side only.  If that
+		 * makes this segment of the join certainly empty, we simply don't
+		 * build a child-join for it.  Otherwise, we have nothing to
+		 * build the child-join from, so give up on the partitionwise join and
+		 * mark the join relation as unpartitioned so that later code treats
+		 * it correctly.
+		 */
+		if (child_rel1 == NULL || child_rel2 == NULL)
+		{
+			bool		empty;
+
+			switch (parent_sjinfo->jointype)
+			{
+				case JOIN_INNER:
+				case JOIN_SEMI:
+					empty = true;
+					break;
+				case JOIN_LEFT:
+				case JOIN_ANTI:
+					empty = (child_rel1 == NULL);
+					break;
+				case JOIN_FULL:
+					empty = (child_rel1 == NULL && child_rel2 == NULL);
+					break;
+				default:
+					empty = false;
+					break;
+			}
+
+			if (empty)
+				continue;
+
+			joinrel->nparts = 0;
+			return;
+		}
+
 		/* We should never try to join two overlapping sets of rels. */
 		Assert(!bms_overlap(child_rel1->relids, child_rel2->relids));
 		child_joinrelids = bms_union(child_rel1->relids, child_rel2->relids);
@@ -1408,8 +1494,17 @@ try_partitionwise_join(PlannerInfo *root, RelOptInfo *rel1, RelOptInfo *rel2,
 												 child_sjinfo->jointype);
 			joinrel->part_rels[cnt_parts] = child_joinrel;
 		}
-
-		Assert(bms_equal(child_joinrel->relids, child_joinrelids));
+		else if (!bms_equal(child_joinrel->relids, child_joinrelids))
+		{
+			/*
+			 * Partitions matched up from merged bounds should always make up
+			 * the same child-join, whichever pair of relations they come
+			 * from.  If not, just don't use this pair; the child-joins
+			 * already have paths from the pair that created them.
+			 */
+			Assert(parts1 != NIL);
+			return;
+		}
 
 		populate_joinrel_with_paths(root, child_rel1, child_rel2,
 									child_joinrel, child_sjinfo,
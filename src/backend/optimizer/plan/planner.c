@@ -51,6 +51,7 @@
 #include "parser/analyze.h"
 #include "parser/parsetree.h"
 #include "parser/parse_agg.h"
+#include "parser/parse_oper.h"
 #include "rewrite/rewriteManip.h"
 #include "storage/dsm_impl.h"
 #include "utils/rel.h"
@@ -173,6 +174,7 @@ static void consider_groupingsets_paths(PlannerInfo *root,
 							bool can_hash,
 							grouping_sets_data *gd,
 							const AggClauseCosts *agg_costs,
+							AggSplit aggsplit,
 							double dNumGroups);
 static RelOptInfo *create_window_paths(PlannerInfo *root,
 					RelOptInfo *input_rel,
@@ -197,6 +199,8 @@ static RelOptInfo *create_ordered_paths(PlannerInfo *root,
 					 PathTarget *target,
 					 bool target_parallel_safe,
 					 double limit_tuples);
+static Path *make_range_redistribute_path(PlannerInfo *root,
+							 RelOptInfo *ordered_rel, Path *subpath);
 static PathTarget *make_group_input_target(PlannerInfo *root,
 						PathTarget *final_target);
 static PathTarget *make_partial_grouping_target(PlannerInfo *root,
@@ -228,6 +232,21 @@ static RelOptInfo *create_partial_grouping_paths(PlannerInfo *root,
 							  GroupPathExtraData *extra,
 							  bool force_rel_creation);
 static void gather_grouping_paths(PlannerInfo *root, RelOptInfo *rel);
+static void create_partial_distinct_agg_paths(PlannerInfo *root,
+								  RelOptInfo *input_rel,
+								  RelOptInfo *grouped_rel,
+								  const AggClauseCosts *agg_costs,
+								  double dNumGroups,
+								  GroupPathExtraData *extra);
+static RelOptInfo *eager_agg_rel(PlannerInfo *root, RelOptInfo *input_rel,
+			  RelOptInfo *grouped_rel, GroupPathExtraData *extra);
+static void create_eager_agg_paths(PlannerInfo *root, RelOptInfo *rel,
+					   RelOptInfo *input_rel,
+					   RelOptInfo *partially_grouped_rel,
+					   GroupPathExtraData *extra);
+static RelOptInfo *make_eager_agg_rel(RelOptInfo *rel, PathTarget *target,
+				   double rows);
+static int	group_var_index(List *group_vars, Expr *var);
 static bool can_partial_agg(PlannerInfo *root,
 				const AggClauseCosts *agg_costs);
 static void apply_scanjoin_target_to_paths(PlannerInfo *root,
@@ -262,21 +281,28 @@ static int	common_prefix_cmp(const void *a, const void *b);
  * Note to plugin authors: standard_planner() scribbles on its Query input,
  * so you'd better copy that data structure if you want to plan more than once.
  *
+ * query_string is the source text the Query came from, for the benefit of
+ * plugins; it may be NULL if the caller doesn't have it.
+ *
  *****************************************************************************/
 PlannedStmt *
-planner(Query *parse, int cursorOptions, ParamListInfo boundParams)
+planner(Query *parse, const char *query_string, int cursorOptions,
+		ParamListInfo boundParams)
 {
 	PlannedStmt *result;
 
 	if (planner_hook)
-		result = (*planner_hook) (parse, cursorOptions, boundParams);
+		result = (*planner_hook) (parse, query_string, cursorOptions,
+								  boundParams);
 	else
-		result = standard_planner(parse, cursorOptions, boundParams);
+		result = standard_planner(parse, query_string, cursorOptions,
+								  boundParams);
 	return result;
 }
 
 PlannedStmt *
-standard_planner(Query *parse, int cursorOptions, ParamListInfo boundParams)
+standard_planner(Query *parse, const char *query_string, int cursorOptions,
+				 ParamListInfo boundParams)
 {
 	PlannedStmt *result;
 	PlannerGlobal *glob;
@@ -709,16 +735,6 @@ subquery_planner(PlannerGlobal *glob, Query *parse,
 	 */
 	preprocess_rowmarks(root);
 
-	/*
-	 * Expand any rangetable entries that are inheritance sets into "append
-	 * relations".  This can add entries to the rangetable, but they must be
-	 * plain base relations not joins, so it's OK (and marginally more
-	 * efficient) to do it after checking for join RTEs.  We must do it after
-	 * pulling up subqueries, else we'd fail to handle inherited tables in
-	 * subqueries.
-	 */
-	expand_inherited_tables(root);
-
 	/*
 	 * Set hasHavingQual to remember if HAVING clause is present.  Needed
 	 * because preprocess_expression will reduce a constant-true condition to
@@ -962,6 +978,20 @@ subquery_planner(PlannerGlobal *glob, Query *parse,
 	if (hasOuterJoins)
 		reduce_outer_joins(root);
 
+	/*
+	 * Expand any rangetable entries that are inheritance sets into "append
+	 * relations".  This can add entries to the rangetable, but they must be
+	 * plain base relations not joins, so it's OK (and marginally more
+	 * efficient) to do it after checking for join RTEs.  We must do it after
+	 * pulling up subqueries, else we'd fail to handle inherited tables in
+	 * subqueries.  We do it after expression preprocessing and outer-join
+	 * reduction, so that the quals are in their final form and partitions
+	 * that they rule out can be pruned without even being locked.  (The
+	 * child RTEs are copies of the parent's, and so include its already
+	 * preprocessed expressions.)
+	 */
+	expand_inherited_tables(root);
+
 	/*
 	 * Do the main planning.  If we have an inherited target relation, that
 	 * needs special processing, else go straight to grouping_planner.
@@ -3899,6 +3929,7 @@ create_degenerate_grouping_paths(PlannerInfo *root, RelOptInfo *input_rel,
 							   grouped_rel,
 							   paths,
 							   NIL,
+							   NIL,
 							   NULL,
 							   0,
 							   false,
@@ -3940,6 +3971,7 @@ create_ordinary_grouping_paths(PlannerInfo *root, RelOptInfo *input_rel,
 {
 	Path	   *cheapest_path = input_rel->cheapest_total_path;
 	RelOptInfo *partially_grouped_rel = NULL;
+	RelOptInfo *eager_rel;
 	double		dNumGroups;
 	PartitionwiseAggregateType patype = PARTITIONWISE_AGGREGATE_NONE;
 
@@ -3951,8 +3983,7 @@ create_ordinary_grouping_paths(PlannerInfo *root, RelOptInfo *input_rel,
 	 * partitionwise aggregate is pointless.
 	 */
 	if (extra->patype != PARTITIONWISE_AGGREGATE_NONE &&
-		input_rel->part_scheme && input_rel->part_rels &&
-		!IS_DUMMY_REL(input_rel))
+		IS_PARTITIONED_REL(input_rel))
 	{
 		/*
 		 * If this is the topmost relation or if the parent relation is doing
@@ -3973,6 +4004,9 @@ create_ordinary_grouping_paths(PlannerInfo *root, RelOptInfo *input_rel,
 			patype = PARTITIONWISE_AGGREGATE_NONE;
 	}
 
+	/* See if the aggregation could be pushed below the joins. */
+	eager_rel = eager_agg_rel(root, input_rel, grouped_rel, extra);
+
 	/*
 	 * Before generating paths for grouped_rel, we first generate any possible
 	 * partially grouped paths; that way, later code can easily consider both
@@ -3983,11 +4017,12 @@ create_ordinary_grouping_paths(PlannerInfo *root, RelOptInfo *input_rel,
 		bool		force_rel_creation;
 
 		/*
-		 * If we're doing partitionwise aggregation at this level, force
-		 * creation of a partially_grouped_rel so we can add partitionwise
-		 * paths to it.
+		 * If we're doing partitionwise aggregation at this level, or eager
+		 * aggregation, force creation of a partially_grouped_rel so we can
+		 * add those paths to it.
 		 */
-		force_rel_creation = (patype == PARTITIONWISE_AGGREGATE_PARTIAL);
+		force_rel_creation = (patype == PARTITIONWISE_AGGREGATE_PARTIAL ||
+							  eager_rel != NULL);
 
 		partially_grouped_rel =
 			create_partial_grouping_paths(root,
@@ -3996,6 +4031,10 @@ create_ordinary_grouping_paths(PlannerInfo *root, RelOptInfo *input_rel,
 										  gd,
 										  extra,
 										  force_rel_creation);
+
+		if (eager_rel != NULL)
+			create_eager_agg_paths(root, eager_rel, input_rel,
+								   partially_grouped_rel, extra);
 	}
 
 	/* Set out parameter. */
@@ -4020,10 +4059,9 @@ create_ordinary_grouping_paths(PlannerInfo *root, RelOptInfo *input_rel,
 
 	/* Gather any partially grouped partial paths. */
 	if (partially_grouped_rel && partially_grouped_rel->partial_pathlist)
-	{
 		gather_grouping_paths(root, partially_grouped_rel);
+	if (partially_grouped_rel && partially_grouped_rel->pathlist)
 		set_cheapest(partially_grouped_rel);
-	}
 
 	/*
 	 * Estimate number of groups.
@@ -4038,6 +4076,14 @@ create_ordinary_grouping_paths(PlannerInfo *root, RelOptInfo *input_rel,
 							  partially_grouped_rel, agg_costs, gd,
 							  dNumGroups, extra);
 
+	/*
+	 * DISTINCT aggregates can't be partially aggregated, but workers can
+	 * still remove duplicates from their input for the leader.
+	 */
+	if ((extra->flags & GROUPING_CAN_PARTIAL_AGG) == 0 && gd == NULL)
+		create_partial_distinct_agg_paths(root, input_rel, grouped_rel,
+										  agg_costs, dNumGroups, extra);
+
 	/* Give a helpful error if we failed to find any implementation */
 	if (grouped_rel->pathlist == NIL)
 		ereport(ERROR,
@@ -4076,6 +4122,7 @@ consider_groupingsets_paths(PlannerInfo *root,
 							bool can_hash,
 							grouping_sets_data *gd,
 							const AggClauseCosts *agg_costs,
+							AggSplit aggsplit,
 							double dNumGroups)
 {
 	Query	   *parse = root->parse;
@@ -4238,6 +4285,7 @@ consider_groupingsets_paths(PlannerInfo *root,
 										  path,
 										  (List *) parse->havingQual,
 										  strat,
+										  aggsplit,
 										  new_rollups,
 										  agg_costs,
 										  dNumGroups));
@@ -4395,6 +4443,7 @@ consider_groupingsets_paths(PlannerInfo *root,
 											  path,
 											  (List *) parse->havingQual,
 											  AGG_MIXED,
+											  aggsplit,
 											  rollups,
 											  agg_costs,
 											  dNumGroups));
@@ -4411,6 +4460,7 @@ consider_groupingsets_paths(PlannerInfo *root,
 										  path,
 										  (List *) parse->havingQual,
 										  AGG_SORTED,
+										  aggsplit,
 										  gd->rollups,
 										  agg_costs,
 										  dNumGroups));
@@ -4855,11 +4905,14 @@ create_ordered_paths(PlannerInfo *root,
 
 	foreach(lc, input_rel->pathlist)
 	{
-		Path	   *path = (Path *) lfirst(lc);
+		Path	   *input_path = (Path *) lfirst(lc);
+		Path	   *path = input_path;
 		bool		is_sorted;
+		int			presorted_keys;
 
-		is_sorted = pathkeys_contained_in(root->sort_pathkeys,
-										  path->pathkeys);
+		is_sorted = pathkeys_count_contained_in(root->sort_pathkeys,
+												path->pathkeys,
+												&presorted_keys);
 		if (path == cheapest_input_path || is_sorted)
 		{
 			if (!is_sorted)
@@ -4879,6 +4932,29 @@ create_ordered_paths(PlannerInfo *root,
 
 			add_path(ordered_rel, path);
 		}
+
+		/*
+		 * A path that's sorted by a prefix of the required ordering can be
+		 * sorted incrementally instead, one group of equal prefix keys at a
+		 * time.  That's cheaper than a full sort of the cheapest path if the
+		 * groups are small, and a LIMIT lets it stop after the first few.
+		 */
+		if (!is_sorted && presorted_keys > 0 && enable_incremental_sort)
+		{
+			path = (Path *) create_incremental_sort_path(root,
+														 ordered_rel,
+														 input_path,
+														 root->sort_pathkeys,
+														 presorted_keys,
+														 limit_tuples);
+
+			/* Add projection step if needed */
+			if (path->pathtarget != target)
+				path = apply_projection_to_path(root, ordered_rel,
+												path, target);
+
+			add_path(ordered_rel, path);
+		}
 	}
 
 	/*
@@ -4921,7 +4997,7 @@ create_ordered_paths(PlannerInfo *root,
 										 path,
 										 path->pathtarget,
 										 root->sort_pathkeys, NULL,
-										 &total_groups);
+										 &total_groups, false);
 
 			/* Add projection step if needed */
 			if (path->pathtarget != target)
@@ -4929,6 +5005,42 @@ create_ordered_paths(PlannerInfo *root,
 												path, target);
 
 			add_path(ordered_rel, path);
+
+			/*
+			 * Alternatively, range-partition the rows among the workers on
+			 * the leading sort key first.  Each worker then sorts a disjoint
+			 * range of the output, and Gather Merge need only concatenate
+			 * the workers' results in order.  As with grouping, we only do
+			 * this at the top query level.
+			 */
+			if (enable_redistribute && root->query_level == 1)
+				path = make_range_redistribute_path(root, ordered_rel,
+													cheapest_partial_path);
+			else
+				path = NULL;
+
+			if (path != NULL)
+			{
+				path = (Path *) create_sort_path(root,
+												 ordered_rel,
+												 path,
+												 root->sort_pathkeys,
+												 limit_tuples);
+
+				path = (Path *)
+					create_gather_merge_path(root, ordered_rel,
+											 path,
+											 path->pathtarget,
+											 root->sort_pathkeys, NULL,
+											 &total_groups, true);
+
+				/* Add projection step if needed */
+				if (path->pathtarget != target)
+					path = apply_projection_to_path(root, ordered_rel,
+													path, target);
+
+				add_path(ordered_rel, path);
+			}
 		}
 	}
 
@@ -4956,6 +5068,55 @@ create_ordered_paths(PlannerInfo *root,
 	return ordered_rel;
 }
 
+/*
+ * make_range_redistribute_path
+ *	  Build a Redistribute path that range-partitions the output of the
+ *	  partial path 'subpath' among the workers on the leading key of the
+ *	  query's sort_pathkeys.
+ *
+ * The boundaries between the workers' ranges are chosen from the histogram
+ * of the key expression, so we return NULL if it has none.  Any member of
+ * the pathkey's equivalence class will do for that, since they all have
+ * the same value in the rows we are sorting.
+ */
+static Path *
+make_range_redistribute_path(PlannerInfo *root, RelOptInfo *ordered_rel,
+							 Path *subpath)
+{
+	PathKey    *pathkey = (PathKey *) linitial(root->sort_pathkeys);
+	EquivalenceClass *ec = pathkey->pk_eclass;
+	ListCell   *lc;
+
+	if (ec->ec_has_volatile)
+		return NULL;
+
+	foreach(lc, ec->ec_members)
+	{
+		EquivalenceMember *em = (EquivalenceMember *) lfirst(lc);
+		Oid			sortop;
+		List	   *bounds;
+
+		if (em->em_is_child || em->em_is_const)
+			continue;
+
+		sortop = get_opfamily_member(pathkey->pk_opfamily,
+									 em->em_datatype,
+									 em->em_datatype,
+									 pathkey->pk_strategy);
+		if (!OidIsValid(sortop))
+			continue;
+
+		bounds = get_sort_histogram_bounds(root, (Node *) em->em_expr,
+										   sortop, ec->ec_collation);
+		if (bounds != NIL)
+			return (Path *) create_range_redistribute_path(root, ordered_rel,
+														   subpath, pathkey,
+														   bounds);
+	}
+
+	return NULL;
+}
+
 
 /*
  * make_group_input_target
@@ -5131,7 +5292,18 @@ make_partial_grouping_target(PlannerInfo *root,
 									  PVC_RECURSE_WINDOWFUNCS |
 									  PVC_INCLUDE_PLACEHOLDERS);
 
-	add_new_columns_to_pathtarget(partial_target, non_group_exprs);
+	/*
+	 * GroupingFunc nodes can only be evaluated by the Agg that computes the
+	 * grouping sets, so leave them for the finalize step.  Their arguments
+	 * are grouping columns, which the partial target already has.
+	 */
+	foreach(lc, non_group_exprs)
+	{
+		Node	   *expr = (Node *) lfirst(lc);
+
+		if (!IsA(expr, GroupingFunc))
+			add_new_column_to_pathtarget(partial_target, (Expr *) expr);
+	}
 
 	/*
 	 * Adjust Aggrefs to put them in partial mode.  At this point all Aggrefs
@@ -6121,8 +6293,12 @@ plan_cluster_use_sort(Oid tableOid, Oid indexOid)
  *		Use the planner to decide how many parallel worker processes
  *		CREATE INDEX should request for use
  *
+ * CLUSTER also uses this to decide how many workers should scan and sort
+ * the table when it duplicates the ordering of a btree index by sorting.
+ *
  * tableOid is the table on which the index is to be built.  indexOid is the
- * OID of an index to be created or reindexed (which must be a btree index).
+ * OID of an index to be created or reindexed (which must be a btree, gin or
+ * hash index).
  *
  * Return value is the number of parallel worker processes to request.  It
  * may be unsafe to proceed if this is 0.  Note that this does not include the
@@ -6302,7 +6478,8 @@ add_paths_to_grouping_rel(PlannerInfo *root, RelOptInfo *input_rel,
 				{
 					consider_groupingsets_paths(root, grouped_rel,
 												path, true, can_hash,
-												gd, agg_costs, dNumGroups);
+												gd, agg_costs, AGGSPLIT_SIMPLE,
+												dNumGroups);
 				}
 				else if (parse->hasAggs)
 				{
@@ -6369,7 +6546,13 @@ add_paths_to_grouping_rel(PlannerInfo *root, RelOptInfo *input_rel,
 													 -1.0);
 				}
 
-				if (parse->hasAggs)
+				if (parse->groupingSets)
+					consider_groupingsets_paths(root, grouped_rel,
+												path, true, can_hash,
+												gd, agg_final_costs,
+												AGGSPLIT_FINAL_DESERIAL,
+												dNumGroups);
+				else if (parse->hasAggs)
 					add_path(grouped_rel, (Path *)
 							 create_agg_path(root,
 											 grouped_rel,
@@ -6404,7 +6587,8 @@ add_paths_to_grouping_rel(PlannerInfo *root, RelOptInfo *input_rel,
 			 */
 			consider_groupingsets_paths(root, grouped_rel,
 										cheapest_path, false, true,
-										gd, agg_costs, dNumGroups);
+										gd, agg_costs, AGGSPLIT_SIMPLE,
+										dNumGroups);
 		}
 		else
 		{
@@ -6443,7 +6627,21 @@ add_paths_to_grouping_rel(PlannerInfo *root, RelOptInfo *input_rel,
 		 * grouped path, assuming there is one. Once again, we'll only do this
 		 * if it looks as though the hash table won't exceed work_mem.
 		 */
-		if (partially_grouped_rel && partially_grouped_rel->pathlist)
+		if (partially_grouped_rel && partially_grouped_rel->pathlist &&
+			parse->groupingSets)
+		{
+			/*
+			 * Likewise, try to finalize all the grouping sets by hashing the
+			 * partially grouped rows.
+			 */
+			consider_groupingsets_paths(root, grouped_rel,
+										partially_grouped_rel->cheapest_total_path,
+										false, true,
+										gd, agg_final_costs,
+										AGGSPLIT_FINAL_DESERIAL,
+										dNumGroups);
+		}
+		else if (partially_grouped_rel && partially_grouped_rel->pathlist)
 		{
 			Path	   *path = partially_grouped_rel->cheapest_total_path;
 
@@ -6464,6 +6662,50 @@ add_paths_to_grouping_rel(PlannerInfo *root, RelOptInfo *input_rel,
 										 agg_final_costs,
 										 dNumGroups));
 		}
+
+		/*
+		 * Consider redistributing the cheapest partially grouped partial path
+		 * among the workers on the grouping columns, so that each worker can
+		 * finalize its share of the groups, instead of the leader finalizing
+		 * all of them.  This gives a partial path for grouped_rel, which is
+		 * gathered below.
+		 *
+		 * Redistribute requires every worker to run it, so only do this at
+		 * the top query level and not for child rels, where the path could
+		 * end up below a Parallel Append.
+		 */
+		if (enable_redistribute && parse->groupClause != NIL &&
+			!parse->groupingSets && grouped_rel->consider_parallel && root->query_level == 1 &&
+			!IS_OTHER_REL(grouped_rel) &&
+			partially_grouped_rel && partially_grouped_rel->partial_pathlist)
+		{
+			Path	   *path = linitial(partially_grouped_rel->partial_pathlist);
+			double		dNumWorkerGroups;
+
+			dNumWorkerGroups = clamp_row_est(dNumGroups / path->parallel_workers);
+			hashaggtablesize = estimate_hashagg_tablesize(path,
+														  agg_final_costs,
+														  dNumWorkerGroups);
+
+			if (hashaggtablesize < work_mem * 1024L)
+			{
+				path = (Path *) create_redistribute_path(root,
+														 partially_grouped_rel,
+														 path,
+														 parse->groupClause);
+				add_partial_path(grouped_rel, (Path *)
+								 create_agg_path(root,
+												 grouped_rel,
+												 path,
+												 grouped_rel->reltarget,
+												 AGG_HASHED,
+												 AGGSPLIT_FINAL_DESERIAL,
+												 parse->groupClause,
+												 havingQual,
+												 agg_final_costs,
+												 dNumWorkerGroups));
+			}
+		}
 	}
 
 	/*
@@ -6596,19 +6838,46 @@ create_partial_grouping_paths(PlannerInfo *root,
 		extra->partial_costs_set = true;
 	}
 
-	/* Estimate number of partial groups. */
-	if (cheapest_total_path != NULL)
-		dNumPartialGroups =
-			get_number_of_groups(root,
-								 cheapest_total_path->rows,
-								 gd,
-								 extra->targetList);
-	if (cheapest_partial_path != NULL)
-		dNumPartialPartialGroups =
-			get_number_of_groups(root,
-								 cheapest_partial_path->rows,
-								 gd,
-								 extra->targetList);
+	/*
+	 * With grouping sets, the partial step groups by all the grouping columns
+	 * at once and the finalize step computes the grouping sets from that.
+	 * We only know how to do that by hashing.  (can_partial_agg already
+	 * checked that the whole groupClause is hashable.)
+	 */
+	if (parse->groupingSets)
+	{
+		List	   *groupExprs;
+
+		can_sort = false;
+		can_hash = true;
+
+		groupExprs = get_sortgrouplist_exprs(parse->groupClause,
+											 extra->targetList);
+		if (cheapest_total_path != NULL)
+			dNumPartialGroups = estimate_num_groups(root, groupExprs,
+													cheapest_total_path->rows,
+													NULL);
+		if (cheapest_partial_path != NULL)
+			dNumPartialPartialGroups = estimate_num_groups(root, groupExprs,
+														   cheapest_partial_path->rows,
+														   NULL);
+	}
+	else
+	{
+		/* Estimate number of partial groups. */
+		if (cheapest_total_path != NULL)
+			dNumPartialGroups =
+				get_number_of_groups(root,
+									 cheapest_total_path->rows,
+									 gd,
+									 extra->targetList);
+		if (cheapest_partial_path != NULL)
+			dNumPartialPartialGroups =
+				get_number_of_groups(root,
+									 cheapest_partial_path->rows,
+									 gd,
+									 extra->targetList);
+	}
 
 	if (can_sort && cheapest_total_path != NULL)
 	{
@@ -6823,12 +7092,618 @@ gather_grouping_paths(PlannerInfo *root, RelOptInfo *rel)
 									 rel->reltarget,
 									 root->group_pathkeys,
 									 NULL,
-									 &total_groups);
+									 &total_groups,
+									 false);
 
 		add_path(rel, path);
 	}
 }
 
+/*
+ * create_partial_distinct_agg_paths
+ *
+ * Consider parallel plans for a query whose aggregates are all DISTINCT
+ * aggregates, such as count(DISTINCT x).  Those have no partial mode, since
+ * a value may be seen by more than one worker; but each worker can remove
+ * the duplicate (grouping key, aggregate argument) combinations from its
+ * share of the input with a hashed Agg node that computes no aggregates.
+ * The leader then runs the ordinary aggregation over the gathered, usually
+ * much smaller, input, discarding the duplicates that different workers saw.
+ *
+ * Regular aggregates, FILTER clauses and ordered-set aggregates depend on
+ * every input row, so they make this impossible.
+ */
+static void
+create_partial_distinct_agg_paths(PlannerInfo *root, RelOptInfo *input_rel,
+								  RelOptInfo *grouped_rel,
+								  const AggClauseCosts *agg_costs,
+								  double dNumGroups,
+								  GroupPathExtraData *extra)
+{
+	Query	   *parse = root->parse;
+	List	   *targetList = extra->targetList;
+	Path	   *cheapest_partial_path;
+	PathTarget *dedup_target;
+	List	   *dedup_clauses = NIL;
+	List	   *aggrefs;
+	Index		maxref = 0;
+	bool		found_agg = false;
+	AggClauseCosts dedup_costs;
+	AggStrategy aggstrategy;
+	double		dNumDedupGroups;
+	double		total_groups;
+	Path	   *path;
+	ListCell   *lc;
+
+	if (input_rel->partial_pathlist == NIL || !grouped_rel->consider_parallel)
+		return;
+
+	/*
+	 * Workers hash on the grouping and DISTINCT columns; the leader sorts on
+	 * the grouping columns, since DISTINCT aggregates can't be hashed.
+	 * (GROUPING_CAN_USE_HASH is never set when there are DISTINCT
+	 * aggregates, so check the grouping columns ourselves.)
+	 */
+	if (!grouping_is_hashable(parse->groupClause))
+		return;
+	if (parse->groupClause != NIL &&
+		(extra->flags & GROUPING_CAN_USE_SORT) == 0)
+		return;
+
+	/*
+	 * Columns that are only functionally dependent on the grouping columns
+	 * wouldn't be emitted by the workers.
+	 */
+	if (parse->constraintDeps != NIL)
+		return;
+
+	/* Start with the grouping expressions, keeping their sortgrouprefs */
+	dedup_target = create_empty_pathtarget();
+	foreach(lc, parse->groupClause)
+	{
+		SortGroupClause *sgc = (SortGroupClause *) lfirst(lc);
+		Expr	   *expr = (Expr *) get_sortgroupclause_expr(sgc, targetList);
+
+		add_column_to_pathtarget(dedup_target, expr, sgc->tleSortGroupRef);
+		dedup_clauses = lappend(dedup_clauses, sgc);
+	}
+
+	/* New sortgrouprefs must not collide with any in the query */
+	foreach(lc, targetList)
+		maxref = Max(maxref, ((TargetEntry *) lfirst(lc))->ressortgroupref);
+
+	/* Then add the arguments of the aggregates, all of which are DISTINCT */
+	aggrefs = pull_var_clause((Node *) list_make2(grouped_rel->reltarget->exprs,
+												  extra->havingQual),
+							  PVC_INCLUDE_AGGREGATES |
+							  PVC_RECURSE_WINDOWFUNCS |
+							  PVC_RECURSE_PLACEHOLDERS);
+	foreach(lc, aggrefs)
+	{
+		Aggref	   *aggref = (Aggref *) lfirst(lc);
+		ListCell   *lc2;
+
+		if (!IsA(aggref, Aggref))
+			continue;
+
+		/* (ordered-set aggregates never have aggdistinct) */
+		if (aggref->aggdistinct == NIL || aggref->aggfilter != NULL)
+			return;
+
+		foreach(lc2, aggref->aggdistinct)
+		{
+			SortGroupClause *sgc = (SortGroupClause *) lfirst(lc2);
+			TargetEntry *tle = get_sortgroupclause_tle(sgc, aggref->args);
+			SortGroupClause *newsgc;
+
+			if (!sgc->hashable)
+				return;
+
+			/* already a grouping column, or another aggregate's argument? */
+			if (list_member(dedup_target->exprs, tle->expr))
+				continue;
+
+			newsgc = copyObject(sgc);
+			newsgc->tleSortGroupRef = ++maxref;
+			add_column_to_pathtarget(dedup_target, tle->expr,
+									 newsgc->tleSortGroupRef);
+			dedup_clauses = lappend(dedup_clauses, newsgc);
+		}
+		found_agg = true;
+	}
+
+	if (!found_agg)
+		return;
+
+	set_pathtarget_cost_width(root, dedup_target);
+
+	/* Each worker deduplicates its share of the cheapest partial path */
+	cheapest_partial_path = linitial(input_rel->partial_pathlist);
+	dNumDedupGroups = estimate_num_groups(root, dedup_target->exprs,
+										  cheapest_partial_path->rows,
+										  NULL);
+
+	MemSet(&dedup_costs, 0, sizeof(AggClauseCosts));
+	path = (Path *) create_projection_path(root, grouped_rel,
+										   cheapest_partial_path,
+										   dedup_target);
+	path = (Path *) create_agg_path(root, grouped_rel, path, dedup_target,
+									AGG_HASHED, AGGSPLIT_SIMPLE,
+									dedup_clauses, NIL, &dedup_costs,
+									dNumDedupGroups);
+
+	/* Gather the results, in grouping order if there's a GROUP BY */
+	total_groups = dNumDedupGroups * path->parallel_workers;
+	if (root->group_pathkeys != NIL)
+	{
+		path = (Path *) create_sort_path(root, grouped_rel, path,
+										 root->group_pathkeys, -1.0);
+		path = (Path *) create_gather_merge_path(root, grouped_rel, path,
+												 dedup_target,
+												 root->group_pathkeys,
+												 NULL, &total_groups,
+												 false);
+	}
+	else
+		path = (Path *) create_gather_path(root, grouped_rel, path,
+										   dedup_target, NULL,
+										   &total_groups);
+
+	/* And finally aggregate, eliminating the remaining duplicates */
+	aggstrategy = parse->groupClause != NIL ? AGG_SORTED : AGG_PLAIN;
+	add_path(grouped_rel, (Path *)
+			 create_agg_path(root, grouped_rel, path,
+							 grouped_rel->reltarget,
+							 aggstrategy, AGGSPLIT_SIMPLE,
+							 parse->groupClause,
+							 (List *) extra->havingQual,
+							 agg_costs,
+							 dNumGroups));
+}
+
+/*
+ * eager_agg_rel
+ *	  Find the base relation that partial aggregation could be pushed down
+ *	  to, below the joins of input_rel.
+ *
+ * That requires all the aggregates to use the columns of a single base
+ * relation only, and all the joins to be inner joins.  Returns that relation,
+ * or NULL if there's none.  create_eager_agg_paths() may still find that
+ * partial aggregation isn't possible or worthwhile there.
+ */
+static RelOptInfo *
+eager_agg_rel(PlannerInfo *root, RelOptInfo *input_rel,
+			  RelOptInfo *grouped_rel, GroupPathExtraData *extra)
+{
+	Query	   *parse = root->parse;
+	List	   *aggrefs;
+	ListCell   *lc;
+	int			relid = -1;
+	RelOptInfo *rel;
+
+	if (!enable_eager_aggregate || !parse->hasAggs || parse->groupingSets ||
+		(extra->flags & GROUPING_CAN_PARTIAL_AGG) == 0 ||
+		extra->patype != PARTITIONWISE_AGGREGATE_NONE ||
+		input_rel->reloptkind != RELOPT_JOINREL)
+		return NULL;
+
+	/* Outer joins, lateral references and PlaceHolderVars aren't handled */
+	if (root->join_info_list != NIL || root->hasLateralRTEs ||
+		root->placeholder_list != NIL)
+		return NULL;
+
+	aggrefs = pull_var_clause((Node *) grouped_rel->reltarget->exprs,
+							  PVC_INCLUDE_AGGREGATES |
+							  PVC_RECURSE_WINDOWFUNCS |
+							  PVC_INCLUDE_PLACEHOLDERS);
+	aggrefs = list_concat(aggrefs,
+						  pull_var_clause(extra->havingQual,
+										  PVC_INCLUDE_AGGREGATES |
+										  PVC_INCLUDE_PLACEHOLDERS));
+	foreach(lc, aggrefs)
+	{
+		Node	   *node = (Node *) lfirst(lc);
+		Relids		varnos;
+		int			aggrelid;
+
+		if (!IsA(node, Aggref))
+			continue;
+
+		/* count(*) and the like can be computed anywhere */
+		varnos = pull_varnos(node);
+		if (bms_is_empty(varnos))
+			continue;
+
+		if (!bms_get_singleton_member(varnos, &aggrelid) ||
+			(relid >= 0 && aggrelid != relid))
+			return NULL;
+		relid = aggrelid;
+	}
+	if (relid < 0 || !bms_is_member(relid, input_rel->relids))
+		return NULL;
+
+	rel = find_base_rel(root, relid);
+	if (rel->reloptkind != RELOPT_BASEREL || IS_DUMMY_REL(rel) ||
+		rel->cheapest_total_path == NULL)
+		return NULL;
+
+	return rel;
+}
+
+/*
+ * create_eager_agg_paths
+ *	  Add paths to partially_grouped_rel that partially aggregate the rows of
+ *	  'rel', found by eager_agg_rel(), before joining them to the rest of
+ *	  input_rel.
+ *
+ * The rows of 'rel' are grouped by all its columns that are needed above the
+ * aggregation other than by the aggregates themselves: the grouping columns,
+ * and the columns used in join clauses.  All the rows in one of these
+ * partial groups join to the same rows of the other relations, so the final
+ * aggregation combines each partial state as many times as the original
+ * rows would have been aggregated.  For that to hold, the join clauses must
+ * use the same notion of equality as the grouping, so we only accept
+ * equijoins on plain columns of 'rel', in the operator family of the
+ * grouping operator.
+ *
+ * The grouped relation is joined to the other relations one at a time,
+ * following the join relations built by the join search; the intermediate
+ * and final results get RelOptInfos of their own, which are copies of the
+ * ungrouped join relations with their row estimates scaled down.  The
+ * final join emits the partial grouping target, so its paths can be
+ * finalized like any other partially grouped path.  (Those paths don't
+ * have partially_grouped_rel as their parent, but nothing above cares.)
+ */
+static void
+create_eager_agg_paths(PlannerInfo *root, RelOptInfo *rel,
+					   RelOptInfo *input_rel,
+					   RelOptInfo *partially_grouped_rel,
+					   GroupPathExtraData *extra)
+{
+	Query	   *parse = root->parse;
+	PathTarget *partial_target = partially_grouped_rel->reltarget;
+	Relids		zero_relids = bms_make_singleton(0);
+	List	   *upper_vars;
+	List	   *partial_aggs = NIL;
+	List	   *group_vars = NIL;
+	List	   *group_clauses = NIL;
+	PathTarget *input_target;
+	PathTarget *grouped_target;
+	RelOptInfo *grouped;
+	RelOptInfo *cur_plain;
+	RelOptInfo *cur_grouped;
+	Relids		remaining;
+	Path	   *path;
+	Index		maxref = 0;
+	double		numGroups;
+	ListCell   *lc;
+	ListCell   *lc2;
+	int			i;
+
+	/*
+	 * Collect the partial aggregates, and the Vars needed above the
+	 * aggregation other than in aggregates.
+	 */
+	upper_vars = pull_var_clause((Node *) partial_target->exprs,
+								 PVC_INCLUDE_AGGREGATES |
+								 PVC_INCLUDE_PLACEHOLDERS);
+	foreach(lc, partial_target->exprs)
+	{
+		if (IsA(lfirst(lc), Aggref))
+			partial_aggs = lappend(partial_aggs, lfirst(lc));
+	}
+
+	foreach(lc, parse->targetList)
+	{
+		TargetEntry *tle = (TargetEntry *) lfirst(lc);
+
+		maxref = Max(maxref, tle->ressortgroupref);
+	}
+
+	/*
+	 * Decide which of the columns of rel to group by, and how.
+	 */
+	foreach(lc, rel->reltarget->exprs)
+	{
+		Var		   *var = (Var *) lfirst(lc);
+		SortGroupClause *gc = NULL;
+
+		/* Whole-row and system column references aren't handled */
+		if (!IsA(var, Var) || var->varattno <= 0)
+			return;
+
+		/* Not needed other than by aggregates? */
+		if (!list_member(upper_vars, var) &&
+			bms_is_subset(rel->attr_needed[var->varattno - rel->min_attr],
+						  zero_relids))
+			continue;
+
+		/* Use the query's grouping clause for the column, if any */
+		foreach(lc2, parse->groupClause)
+		{
+			SortGroupClause *qgc = (SortGroupClause *) lfirst(lc2);
+
+			if (equal(get_sortgroupclause_expr(qgc, parse->targetList), var))
+			{
+				gc = qgc;
+				break;
+			}
+		}
+		if (gc == NULL)
+		{
+			Oid			sortop;
+			Oid			eqop;
+			bool		hashable;
+
+			get_sort_group_operators(var->vartype,
+									 false, true, false,
+									 &sortop, &eqop, NULL,
+									 &hashable);
+			gc = makeNode(SortGroupClause);
+			gc->tleSortGroupRef = ++maxref;
+			gc->eqop = eqop;
+			gc->sortop = sortop;
+			gc->nulls_first = false;
+			gc->hashable = hashable;
+		}
+
+		/* We only aggregate by hashing */
+		if (!OidIsValid(gc->eqop) || !gc->hashable)
+			return;
+
+		group_vars = lappend(group_vars, var);
+		group_clauses = lappend(group_clauses, gc);
+	}
+
+	/*
+	 * Check that the joins use the grouping equality of the columns of rel.
+	 */
+	foreach(lc, root->eq_classes)
+	{
+		EquivalenceClass *ec = (EquivalenceClass *) lfirst(lc);
+
+		if (!bms_is_member(rel->relid, ec->ec_relids) ||
+			bms_membership(ec->ec_relids) != BMS_MULTIPLE)
+			continue;
+
+		foreach(lc2, ec->ec_members)
+		{
+			EquivalenceMember *em = (EquivalenceMember *) lfirst(lc2);
+			SortGroupClause *gc;
+			Expr	   *expr;
+			int			ndx;
+			bool		found = false;
+			ListCell   *lc3;
+
+			if (em->em_is_child ||
+				!bms_is_member(rel->relid, em->em_relids))
+				continue;
+
+			expr = em->em_expr;
+			while (IsA(expr, RelabelType))
+				expr = ((RelabelType *) expr)->arg;
+			if (!bms_equal(em->em_relids, rel->relids) || !IsA(expr, Var))
+				return;
+
+			ndx = group_var_index(group_vars, expr);
+			if (ndx < 0)
+				return;
+			gc = (SortGroupClause *) list_nth(group_clauses, ndx);
+
+			foreach(lc3, ec->ec_opfamilies)
+			{
+				if (op_in_opfamily(gc->eqop, lfirst_oid(lc3)))
+				{
+					found = true;
+					break;
+				}
+			}
+			if (!found)
+				return;
+		}
+	}
+
+	/*
+	 * Join clauses that didn't make it into an equivalence class would need
+	 * the same checks, but with only inner joins they're not equijoins, so
+	 * just give up.
+	 */
+	if (rel->joininfo != NIL)
+		return;
+
+	/*
+	 * Don't bother unless the partial aggregation removes a good part of the
+	 * rows.
+	 */
+	numGroups = estimate_num_groups(root, group_vars, rel->rows, NULL);
+	if (numGroups > rel->rows / 2)
+		return;
+
+	/*
+	 * Build the grouped relation.  The input of the aggregation is the
+	 * relation's own target, with the grouping columns labeled.
+	 */
+	input_target = copy_pathtarget(rel->reltarget);
+	input_target->sortgrouprefs = (Index *)
+		palloc0(list_length(input_target->exprs) * sizeof(Index));
+	i = 0;
+	foreach(lc, input_target->exprs)
+	{
+		int			ndx = group_var_index(group_vars, lfirst(lc));
+
+		if (ndx >= 0)
+			input_target->sortgrouprefs[i] =
+				((SortGroupClause *) list_nth(group_clauses, ndx))->tleSortGroupRef;
+		i++;
+	}
+
+	grouped_target = create_empty_pathtarget();
+	foreach(lc, group_vars)
+		add_column_to_pathtarget(grouped_target, (Expr *) lfirst(lc), 0);
+	foreach(lc, partial_aggs)
+		add_column_to_pathtarget(grouped_target, (Expr *) lfirst(lc), 0);
+	set_pathtarget_cost_width(root, grouped_target);
+
+	grouped = make_eager_agg_rel(rel, grouped_target, numGroups);
+
+	path = (Path *) create_projection_path(root, grouped,
+										   rel->cheapest_total_path,
+										   input_target);
+	if (estimate_hashagg_tablesize(path, &extra->agg_partial_costs,
+								   numGroups) >= work_mem * 1024L)
+		return;
+	add_path(grouped, (Path *)
+			 create_agg_path(root,
+							 grouped,
+							 path,
+							 grouped_target,
+							 AGG_HASHED,
+							 AGGSPLIT_INITIAL_SERIAL,
+							 group_clauses,
+							 NIL,
+							 &extra->agg_partial_costs,
+							 numGroups));
+	set_cheapest(grouped);
+
+	/*
+	 * Now join the other relations, one at a time.
+	 */
+	cur_plain = rel;
+	cur_grouped = grouped;
+	remaining = bms_del_member(bms_copy(input_rel->relids), rel->relid);
+	while (!bms_is_empty(remaining))
+	{
+		RelOptInfo *inner_rel;
+		RelOptInfo *joinrel = NULL;
+		RelOptInfo *grouped_join;
+		PathTarget *target;
+		SpecialJoinInfo sjinfo;
+		List	   *restrictlist;
+		int			x = -1;
+
+		/* Find a relation that the join search has joined to cur_plain */
+		while ((x = bms_next_member(remaining, x)) >= 0)
+		{
+			Relids		joinrelids = bms_add_member(bms_copy(cur_plain->relids), x);
+
+			joinrel = find_join_rel(root, joinrelids);
+			bms_free(joinrelids);
+			if (joinrel != NULL && !IS_DUMMY_REL(joinrel))
+				break;
+		}
+		if (x < 0)
+			return;
+		inner_rel = find_base_rel(root, x);
+
+		/* See make_join_rel() */
+		sjinfo.type = T_SpecialJoinInfo;
+		sjinfo.min_lefthand = cur_plain->relids;
+		sjinfo.min_righthand = inner_rel->relids;
+		sjinfo.syn_lefthand = cur_plain->relids;
+		sjinfo.syn_righthand = inner_rel->relids;
+		sjinfo.jointype = JOIN_INNER;
+		sjinfo.lhs_strict = false;
+		sjinfo.delay_upper_joins = false;
+		sjinfo.semi_can_btree = false;
+		sjinfo.semi_can_hash = false;
+		sjinfo.semi_operators = NIL;
+		sjinfo.semi_rhs_exprs = NIL;
+
+		(void) build_join_rel(root, joinrel->relids, cur_plain, inner_rel,
+							  &sjinfo, &restrictlist);
+
+		remaining = bms_del_member(remaining, x);
+		if (bms_is_empty(remaining))
+			target = partial_target;
+		else
+		{
+			/*
+			 * Emit what the ungrouped join does, except for the columns of
+			 * rel that were only needed by the aggregates, plus the partial
+			 * aggregates.
+			 */
+			target = create_empty_pathtarget();
+			foreach(lc, joinrel->reltarget->exprs)
+			{
+				Var		   *var = (Var *) lfirst(lc);
+
+				if (IsA(var, Var) && var->varno == rel->relid &&
+					!list_member(group_vars, var))
+					continue;
+				add_column_to_pathtarget(target, (Expr *) var, 0);
+			}
+			foreach(lc, partial_aggs)
+				add_column_to_pathtarget(target, (Expr *) lfirst(lc), 0);
+			set_pathtarget_cost_width(root, target);
+		}
+
+		grouped_join = make_eager_agg_rel(joinrel, target,
+										  joinrel->rows * numGroups / rel->rows);
+		add_paths_to_joinrel(root, grouped_join, cur_grouped, inner_rel,
+							 JOIN_INNER, &sjinfo, restrictlist);
+		add_paths_to_joinrel(root, grouped_join, inner_rel, cur_grouped,
+							 JOIN_INNER, &sjinfo, restrictlist);
+		if (grouped_join->pathlist == NIL)
+			return;
+		set_cheapest(grouped_join);
+
+		cur_plain = joinrel;
+		cur_grouped = grouped_join;
+	}
+
+	foreach(lc, cur_grouped->pathlist)
+		add_path(partially_grouped_rel, (Path *) lfirst(lc));
+}
+
+/*
+ * make_eager_agg_rel
+ *	  Make a RelOptInfo for partially aggregated rows of 'rel', or for the
+ *	  join of those with other relations.
+ *
+ * It's a copy of the ungrouped relation with the given target and row
+ * estimate, and no paths.  It isn't entered in the planner's lists.
+ */
+static RelOptInfo *
+make_eager_agg_rel(RelOptInfo *rel, PathTarget *target, double rows)
+{
+	RelOptInfo *grouped = makeNode(RelOptInfo);
+
+	memcpy(grouped, rel, sizeof(RelOptInfo));
+	grouped->reltarget = target;
+	grouped->rows = clamp_row_est(rows);
+	grouped->consider_parallel = false;
+	grouped->pathlist = NIL;
+	grouped->ppilist = NIL;
+	grouped->partial_pathlist = NIL;
+	grouped->cheapest_startup_path = NULL;
+	grouped->cheapest_total_path = NULL;
+	grouped->cheapest_unique_path = NULL;
+	grouped->cheapest_parameterized_paths = NIL;
+	grouped->unique_for_rels = NIL;
+	grouped->non_unique_for_rels = NIL;
+
+	return grouped;
+}
+
+/*
+ * group_var_index
+ *	  Return the position of 'var' in group_vars, or -1 if it's not there.
+ */
+static int
+group_var_index(List *group_vars, Expr *var)
+{
+	ListCell   *lc;
+	int			i = 0;
+
+	foreach(lc, group_vars)
+	{
+		if (equal(lfirst(lc), var))
+			return i;
+		i++;
+	}
+	return -1;
+}
+
 /*
  * can_partial_agg
  *
@@ -6848,9 +7723,15 @@ can_partial_agg(PlannerInfo *root, const AggClauseCosts *agg_costs)
 		 */
 		return false;
 	}
-	else if (parse->groupingSets)
+	else if (parse->groupingSets &&
+			 (parse->groupClause == NIL ||
+			  !grouping_is_hashable(parse->groupClause)))
 	{
-		/* We don't know how to do grouping sets in parallel. */
+		/*
+		 * Grouping sets are partially aggregated by hashing on all the
+		 * grouping columns at once, so that the final step can compute each
+		 * grouping set from the partial groups.
+		 */
 		return false;
 	}
 	else if (agg_costs->hasNonPartial || agg_costs->hasNonSerial)
@@ -6936,8 +7817,8 @@ apply_scanjoin_target_to_paths(PlannerInfo *root,
 		 * dummy rel.)
 		 */
 		rel->pathlist = list_make1(create_append_path(root, rel, NIL, NIL,
-													  NULL, 0, false, NIL,
-													  -1));
+													  NIL, NULL, 0, false,
+													  NIL, -1));
 		rel->partial_pathlist = NIL;
 		set_cheapest(rel);
 		Assert(IS_DUMMY_REL(rel));
@@ -7030,6 +7911,10 @@ apply_scanjoin_target_to_paths(PlannerInfo *root,
 			int			nappinfos;
 			List	   *child_scanjoin_targets = NIL;
 
+			/* Skip partitions pruned during inheritance expansion */
+			if (child_rel == NULL)
+				continue;
+
 			/* Translate scan/join targets for this child. */
 			appinfos = find_appinfos_by_relids(root, child_rel->relids,
 											   &nappinfos);
@@ -7131,6 +8016,10 @@ create_partitionwise_grouping_paths(PlannerInfo *root,
 		RelOptInfo *child_grouped_rel;
 		RelOptInfo *child_partially_grouped_rel;
 
+		/* Partitions pruned during inheritance expansion contribute nothing */
+		if (child_input_rel == NULL)
+			continue;
+
 		/* Input child rel must have a path */
 		Assert(child_input_rel->pathlist != NIL);
 
@@ -19,6 +19,7 @@
 #include "catalog/pg_type.h"
 #include "nodes/makefuncs.h"
 #include "nodes/nodeFuncs.h"
+#include "optimizer/clauses.h"
 #include "optimizer/pathnode.h"
 #include "optimizer/planmain.h"
 #include "optimizer/planner.h"
@@ -138,6 +139,10 @@ static List *set_returning_clause_references(PlannerInfo *root,
 								Plan *topplan,
 								Index resultRelation,
 								int rtoffset);
+static List *set_windowagg_runcondition_references(PlannerInfo *root,
+									  List *runcondition,
+									  Plan *plan,
+									  int rtoffset);
 
 
 /*****************************************************************************
@@ -536,6 +541,19 @@ set_plan_refs(PlannerInfo *root, Plan *plan, int rtoffset)
 					fix_scan_list(root, splan->tidquals, rtoffset);
 			}
 			break;
+		case T_TidRangeScan:
+			{
+				TidRangeScan *splan = (TidRangeScan *) plan;
+
+				splan->scan.scanrelid += rtoffset;
+				splan->scan.plan.targetlist =
+					fix_scan_list(root, splan->scan.plan.targetlist, rtoffset);
+				splan->scan.plan.qual =
+					fix_scan_list(root, splan->scan.plan.qual, rtoffset);
+				splan->tidrangequals =
+					fix_scan_list(root, splan->tidrangequals, rtoffset);
+			}
+			break;
 		case T_SubqueryScan:
 			/* Needs special treatment, see comments below */
 			return set_subqueryscan_references(root,
@@ -634,11 +652,28 @@ set_plan_refs(PlannerInfo *root, Plan *plan, int rtoffset)
 			}
 			break;
 
+		case T_Memoize:
+			{
+				Memoize    *mplan = (Memoize *) plan;
+
+				/*
+				 * Memoize does not evaluate its targetlist.  It just uses the
+				 * same targetlist from its outer subnode.
+				 */
+				set_dummy_tlist_references(plan, rtoffset);
+
+				mplan->param_exprs = fix_scan_list(root, mplan->param_exprs,
+												   rtoffset);
+				break;
+			}
+
 		case T_Hash:
 		case T_Material:
 		case T_Sort:
+		case T_IncrementalSort:
 		case T_Unique:
 		case T_SetOp:
+		case T_Redistribute:
 
 			/*
 			 * These plan types don't actually bother to evaluate their
@@ -725,6 +760,15 @@ set_plan_refs(PlannerInfo *root, Plan *plan, int rtoffset)
 			{
 				WindowAgg  *wplan = (WindowAgg *) plan;
 
+				/*
+				 * The run condition refers to our own window functions; do
+				 * this before set_upper_references changes their arguments.
+				 */
+				wplan->runCondition =
+					set_windowagg_runcondition_references(root,
+														  wplan->runCondition,
+														  plan, rtoffset);
+
 				set_upper_references(root, plan, rtoffset);
 
 				/*
@@ -2536,6 +2580,44 @@ set_returning_clause_references(PlannerInfo *root,
 	return rlist;
 }
 
+/*
+ * set_windowagg_runcondition_references
+ *		Convert a WindowAgg's run condition to reference its own output.
+ *
+ * The run condition compares window functions computed by the WindowAgg
+ * itself.  The executor checks it against the node's projected output row,
+ * so we replace each window function with an INDEX_VAR Var referencing the
+ * corresponding entry of the node's targetlist.  If one can't be found, we
+ * just drop the condition; it's only an optimization.
+ */
+static List *
+set_windowagg_runcondition_references(PlannerInfo *root,
+									  List *runcondition,
+									  Plan *plan,
+									  int rtoffset)
+{
+	indexed_tlist *itlist;
+	List	   *result;
+
+	if (runcondition == NIL)
+		return NIL;
+
+	itlist = build_tlist_index(plan->targetlist);
+
+	result = (List *) fix_upper_expr(root,
+									 (Node *) runcondition,
+									 itlist,
+									 INDEX_VAR,
+									 rtoffset);
+
+	pfree(itlist);
+
+	if (contain_window_function((Node *) result))
+		return NIL;
+
+	return result;
+}
+
 
 /*****************************************************************************
  *					QUERY DEPENDENCY MANAGEMENT
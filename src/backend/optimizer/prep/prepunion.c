@@ -39,15 +39,19 @@
 #include "miscadmin.h"
 #include "nodes/makefuncs.h"
 #include "nodes/nodeFuncs.h"
+#include "optimizer/clauses.h"
 #include "optimizer/cost.h"
 #include "optimizer/pathnode.h"
 #include "optimizer/paths.h"
+#include "optimizer/plancat.h"
 #include "optimizer/planmain.h"
 #include "optimizer/planner.h"
 #include "optimizer/prep.h"
 #include "optimizer/tlist.h"
+#include "optimizer/var.h"
 #include "parser/parse_coerce.h"
 #include "parser/parsetree.h"
+#include "partitioning/partprune.h"
 #include "utils/lsyscache.h"
 #include "utils/rel.h"
 #include "utils/selfuncs.h"
@@ -101,11 +105,17 @@ static List *generate_append_tlist(List *colTypes, List *colCollations,
 static List *generate_setop_grouplist(SetOperationStmt *op, List *targetlist);
 static void expand_inherited_rtentry(PlannerInfo *root, RangeTblEntry *rte,
 						 Index rti);
+static List *get_partition_pruning_quals(PlannerInfo *root, Index rti);
+static bool find_restricting_quals(Node *jtnode, Index rti, List **quals,
+					   bool *nulled);
 static void expand_partitioned_rtentry(PlannerInfo *root,
 						   RangeTblEntry *parentrte,
 						   Index parentRTindex, Relation parentrel,
 						   PlanRowMark *top_parentrc, LOCKMODE lockmode,
-						   List **appinfos);
+						   List *prunequals, List **appinfos);
+static Bitmapset *prune_partitions_at_expansion(PlannerInfo *root,
+							  Relation parentrel, Index parentRTindex,
+							  List *prunequals);
 static void expand_single_inheritance_child(PlannerInfo *root,
 								RangeTblEntry *parentrte,
 								Index parentRTindex, Relation parentrel,
@@ -657,7 +667,7 @@ generate_union_paths(SetOperationStmt *op, PlannerInfo *root,
 	 * Append the child results together.
 	 */
 	path = (Path *) create_append_path(root, result_rel, pathlist, NIL,
-									   NULL, 0, false, NIL, -1);
+									   NIL, NULL, 0, false, NIL, -1);
 
 	/*
 	 * For UNION ALL, we just need the Append path.  For UNION, need to add
@@ -712,7 +722,8 @@ generate_union_paths(SetOperationStmt *op, PlannerInfo *root,
 
 		ppath = (Path *)
 			create_append_path(root, result_rel, NIL, partial_pathlist,
-							   NULL, parallel_workers, enable_parallel_append,
+							   NIL, NULL, parallel_workers,
+							   enable_parallel_append,
 							   NIL, -1);
 		ppath = (Path *)
 			create_gather_path(root, result_rel, ppath,
@@ -823,7 +834,7 @@ generate_nonunion_paths(SetOperationStmt *op, PlannerInfo *root,
 	 * Append the child results together.
 	 */
 	path = (Path *) create_append_path(root, result_rel, pathlist, NIL,
-									   NULL, 0, false, NIL, -1);
+									   NIL, NULL, 0, false, NIL, -1);
 
 	/* Identify the grouping semantics */
 	groupList = generate_setop_grouplist(op, tlist);
@@ -1520,6 +1531,7 @@ expand_inherited_rtentry(PlannerInfo *root, RangeTblEntry *rte, Index rti)
 	Relation	oldrelation;
 	LOCKMODE	lockmode;
 	List	   *inhOIDs;
+	List	   *appinfos = NIL;
 	ListCell   *l;
 
 	/* Does RT entry allow inheritance? */
@@ -1549,6 +1561,47 @@ expand_inherited_rtentry(PlannerInfo *root, RangeTblEntry *rte, Index rti)
 	 */
 	lockmode = rte->rellockmode;
 
+	/*
+	 * A partitioned table is expanded following its PartitionDesc, which
+	 * lets us prune partitions before locking and opening them; see
+	 * expand_partitioned_rtentry.
+	 */
+	if (rte->relkind == RELKIND_PARTITIONED_TABLE)
+	{
+		List	   *prunequals = NIL;
+
+		/*
+		 * If parent relation is selected FOR UPDATE/SHARE, we need to mark
+		 * its PlanRowMark as isParent = true, and generate a new PlanRowMark
+		 * for each child.
+		 */
+		oldrc = get_plan_rowmark(root->rowMarks, rti);
+		if (oldrc)
+			oldrc->isParent = true;
+
+		if (enable_partition_pruning)
+			prunequals = get_partition_pruning_quals(root, rti);
+
+		/*
+		 * Must open the parent relation to examine its PartitionDesc.  We
+		 * need not lock it; we assume the rewriter already did.
+		 */
+		oldrelation = heap_open(parentOID, NoLock);
+		Assert(RelationGetPartitionDesc(oldrelation) != NULL);
+
+		/*
+		 * Recursively expand the partitions in the order in which they
+		 * appear in the PartitionDesc.  While at it, also extract the
+		 * partition key columns of all the partitioned tables.
+		 */
+		expand_partitioned_rtentry(root, rte, rti, oldrelation, oldrc,
+								   lockmode, prunequals,
+								   &root->append_rel_list);
+
+		heap_close(oldrelation, NoLock);
+		return;
+	}
+
 	/* Scan for all members of inheritance set, acquire needed locks */
 	inhOIDs = find_all_inheritors(parentOID, lockmode, NULL);
 
@@ -1579,95 +1632,216 @@ expand_inherited_rtentry(PlannerInfo *root, RangeTblEntry *rte, Index rti)
 	 */
 	oldrelation = heap_open(parentOID, NoLock);
 
-	/* Scan the inheritance set and expand it */
-	if (RelationGetPartitionDesc(oldrelation) != NULL)
+	/*
+	 * This table has no partitions.  Expand any plain inheritance children
+	 * in the order the OIDs were returned by find_all_inheritors.
+	 */
+	foreach(l, inhOIDs)
 	{
-		Assert(rte->relkind == RELKIND_PARTITIONED_TABLE);
+		Oid			childOID = lfirst_oid(l);
+		Relation	newrelation;
+		RangeTblEntry *childrte;
+		Index		childRTindex;
+
+		/* Open rel if needed; we already have required locks */
+		if (childOID != parentOID)
+			newrelation = heap_open(childOID, NoLock);
+		else
+			newrelation = oldrelation;
 
 		/*
-		 * If this table has partitions, recursively expand them in the order
-		 * in which they appear in the PartitionDesc.  While at it, also
-		 * extract the partition key columns of all the partitioned tables.
+		 * It is possible that the parent table has children that are temp
+		 * tables of other backends.  We cannot safely access such tables
+		 * (because of buffering issues), and the best thing to do seems to
+		 * be to silently ignore them.
 		 */
-		expand_partitioned_rtentry(root, rte, rti, oldrelation, oldrc,
-								   lockmode, &root->append_rel_list);
+		if (childOID != parentOID && RELATION_IS_OTHER_TEMP(newrelation))
+		{
+			heap_close(newrelation, lockmode);
+			continue;
+		}
+
+		expand_single_inheritance_child(root, rte, rti, oldrelation, oldrc,
+										newrelation,
+										&appinfos, &childrte,
+										&childRTindex);
+
+		/* Close child relations, but keep locks */
+		if (childOID != parentOID)
+			heap_close(newrelation, NoLock);
 	}
+
+	/*
+	 * If all the children were temp tables, pretend it's a non-inheritance
+	 * situation; we don't need Append node in that case.  The duplicate RTE
+	 * we added for the parent table is harmless, so we don't bother to get
+	 * rid of it; ditto for the useless PlanRowMark node.
+	 */
+	if (list_length(appinfos) < 2)
+		rte->inh = false;
 	else
+		root->append_rel_list = list_concat(root->append_rel_list,
+											appinfos);
+
+	heap_close(oldrelation, NoLock);
+}
+
+/*
+ * get_partition_pruning_quals
+ *		Collect the quals of the query that restrict the rows of the
+ *		partitioned table at rangetable index "rti" and are usable for
+ *		pruning its partitions during expansion.
+ *
+ * This runs before deconstruct_jointree() has distributed the quals to
+ * baserels, so we look for them in the jointree ourselves.  We only take
+ * quals that mention no other relation, found in the nodes above "rti" up to
+ * the first outer join at which it is on the nullable side (quals above that
+ * don't restrict its rows).  Pruning with the baserestrictinfo quals later
+ * on, which include quals derived from equivalence classes, may remove more
+ * partitions, but never less.
+ */
+static List *
+get_partition_pruning_quals(PlannerInfo *root, Index rti)
+{
+	List	   *quals = NIL;
+	List	   *result = NIL;
+	bool		nulled = false;
+	ListCell   *lc;
+
+	if (!find_restricting_quals((Node *) root->parse->jointree, rti,
+								&quals, &nulled))
+		return NIL;
+
+	foreach(lc, quals)
 	{
-		List	   *appinfos = NIL;
-		RangeTblEntry *childrte;
-		Index		childRTindex;
+		Node	   *qual = (Node *) lfirst(lc);
+		Relids		relids = pull_varnos(qual);
 
 		/*
-		 * This table has no partitions.  Expand any plain inheritance
-		 * children in the order the OIDs were returned by
-		 * find_all_inheritors.
+		 * Quals mentioning only this relation, or constants (presumably
+		 * false, since constant-true quals have been removed).
 		 */
-		foreach(l, inhOIDs)
-		{
-			Oid			childOID = lfirst_oid(l);
-			Relation	newrelation;
+		if (((bms_membership(relids) == BMS_SINGLETON &&
+			  bms_is_member(rti, relids)) ||
+			 IsA(qual, Const)) &&
+			!contain_volatile_functions(qual))
+			result = lappend(result, qual);
+		bms_free(relids);
+	}
 
-			/* Open rel if needed; we already have required locks */
-			if (childOID != parentOID)
-				newrelation = heap_open(childOID, NoLock);
-			else
-				newrelation = oldrelation;
+	return result;
+}
 
-			/*
-			 * It is possible that the parent table has children that are temp
-			 * tables of other backends.  We cannot safely access such tables
-			 * (because of buffering issues), and the best thing to do seems
-			 * to be to silently ignore them.
-			 */
-			if (childOID != parentOID && RELATION_IS_OTHER_TEMP(newrelation))
+/*
+ * find_restricting_quals
+ *		Recursive workhorse for get_partition_pruning_quals.
+ *
+ * Returns true if "rti" appears below "jtnode".  In that case, the quals of
+ * the nodes on the way that apply to the rows of "rti" are appended to
+ * *quals, and *nulled is set if "rti" is on the nullable side of an outer
+ * join below "jtnode".
+ */
+static bool
+find_restricting_quals(Node *jtnode, Index rti, List **quals, bool *nulled)
+{
+	if (jtnode == NULL)
+		return false;
+	if (IsA(jtnode, RangeTblRef))
+		return ((RangeTblRef *) jtnode)->rtindex == rti;
+	else if (IsA(jtnode, FromExpr))
+	{
+		FromExpr   *f = (FromExpr *) jtnode;
+		ListCell   *l;
+
+		foreach(l, f->fromlist)
+		{
+			if (find_restricting_quals(lfirst(l), rti, quals, nulled))
 			{
-				heap_close(newrelation, lockmode);
-				continue;
+				if (!*nulled)
+					*quals = list_concat(*quals, list_copy((List *) f->quals));
+				return true;
 			}
+		}
+		return false;
+	}
+	else if (IsA(jtnode, JoinExpr))
+	{
+		JoinExpr   *j = (JoinExpr *) jtnode;
 
-			expand_single_inheritance_child(root, rte, rti, oldrelation, oldrc,
-											newrelation,
-											&appinfos, &childrte,
-											&childRTindex);
+		if (find_restricting_quals(j->larg, rti, quals, nulled))
+		{
+			if (*nulled)
+				return true;
 
-			/* Close child relations, but keep locks */
-			if (childOID != parentOID)
-				heap_close(newrelation, NoLock);
+			switch (j->jointype)
+			{
+				case JOIN_INNER:
+					*quals = list_concat(*quals, list_copy((List *) j->quals));
+					break;
+				case JOIN_LEFT:
+				case JOIN_SEMI:
+				case JOIN_ANTI:
+					/* the join quals don't filter the rows of the lefthand side */
+					break;
+				default:
+					*nulled = true;
+					break;
+			}
+			return true;
 		}
+		if (find_restricting_quals(j->rarg, rti, quals, nulled))
+		{
+			if (*nulled)
+				return true;
 
-		/*
-		 * If all the children were temp tables, pretend it's a
-		 * non-inheritance situation; we don't need Append node in that case.
-		 * The duplicate RTE we added for the parent table is harmless, so we
-		 * don't bother to get rid of it; ditto for the useless PlanRowMark
-		 * node.
-		 */
-		if (list_length(appinfos) < 2)
-			rte->inh = false;
-		else
-			root->append_rel_list = list_concat(root->append_rel_list,
-												appinfos);
-
+			switch (j->jointype)
+			{
+				case JOIN_INNER:
+					*quals = list_concat(*quals, list_copy((List *) j->quals));
+					break;
+				case JOIN_LEFT:
+				case JOIN_SEMI:
+				case JOIN_ANTI:
+					/* the join quals filter the righthand side, nothing above */
+					*quals = list_concat(*quals, list_copy((List *) j->quals));
+					*nulled = true;
+					break;
+				default:
+					*nulled = true;
+					break;
+			}
+			return true;
+		}
+		return false;
 	}
-
-	heap_close(oldrelation, NoLock);
+	else
+		elog(ERROR, "unrecognized node type: %d",
+			 (int) nodeTag(jtnode));
+	return false;				/* keep compiler quiet */
 }
 
 /*
  * expand_partitioned_rtentry
  *		Recursively expand an RTE for a partitioned table.
+ *
+ * "prunequals" are quals restricting the rows of the partitioned table, in
+ * terms of "parentRTindex".  Partitions that they prove can't contain any
+ * matching rows are left out of the query entirely; in particular, they are
+ * never locked nor opened, which matters when a table has thousands of
+ * partitions and a query needs only a few of them.  Later code must expect
+ * missing members in the part_rels array of the partitioned rel.
  */
 static void
 expand_partitioned_rtentry(PlannerInfo *root, RangeTblEntry *parentrte,
 						   Index parentRTindex, Relation parentrel,
 						   PlanRowMark *top_parentrc, LOCKMODE lockmode,
-						   List **appinfos)
+						   List *prunequals, List **appinfos)
 {
 	int			i;
 	RangeTblEntry *childrte;
 	Index		childRTindex;
 	PartitionDesc partdesc = RelationGetPartitionDesc(parentrel);
+	Bitmapset  *live_parts;
 
 	check_stack_depth();
 
@@ -1702,13 +1876,20 @@ expand_partitioned_rtentry(PlannerInfo *root, RangeTblEntry *parentrte,
 		return;
 	}
 
-	for (i = 0; i < partdesc->nparts; i++)
+	if (prunequals != NIL)
+		live_parts = prune_partitions_at_expansion(root, parentrel,
+												   parentRTindex, prunequals);
+	else
+		live_parts = bms_add_range(NULL, 0, partdesc->nparts - 1);
+
+	i = -1;
+	while ((i = bms_next_member(live_parts, i)) >= 0)
 	{
 		Oid			childOID = partdesc->oids[i];
 		Relation	childrel;
 
-		/* Open rel; we already have required locks */
-		childrel = heap_open(childOID, NoLock);
+		/* Open rel, acquiring the same lock as the parent's */
+		childrel = heap_open(childOID, lockmode);
 
 		/*
 		 * Temporary partitions belonging to other sessions should have been
@@ -1722,17 +1903,56 @@ expand_partitioned_rtentry(PlannerInfo *root, RangeTblEntry *parentrte,
 										parentrel, top_parentrc, childrel,
 										appinfos, &childrte, &childRTindex);
 
-		/* If this child is itself partitioned, recurse */
+		/*
+		 * If this child is itself partitioned, recurse, with the pruning
+		 * quals translated to refer to it.  Its AppendRelInfo is the one we
+		 * just added.
+		 */
 		if (childrel->rd_rel->relkind == RELKIND_PARTITIONED_TABLE)
+		{
+			List	   *childquals = NIL;
+
+			if (prunequals != NIL)
+			{
+				AppendRelInfo *appinfo = llast_node(AppendRelInfo, *appinfos);
+
+				childquals = (List *)
+					adjust_appendrel_attrs(root, (Node *) prunequals,
+										   1, &appinfo);
+			}
 			expand_partitioned_rtentry(root, childrte, childRTindex,
 									   childrel, top_parentrc, lockmode,
-									   appinfos);
+									   childquals, appinfos);
+		}
 
 		/* Close child relation, but keep locks */
 		heap_close(childrel, NoLock);
 	}
 }
 
+/*
+ * prune_partitions_at_expansion
+ *		Returns the PartitionDesc indexes of the partitions of "parentrel"
+ *		that may contain rows satisfying "prunequals".
+ *
+ * The RelOptInfo for the partitioned table doesn't exist yet, so we make a
+ * temporary one holding just the partitioning properties that partprune.c
+ * needs.
+ */
+static Bitmapset *
+prune_partitions_at_expansion(PlannerInfo *root, Relation parentrel,
+							  Index parentRTindex, List *prunequals)
+{
+	RelOptInfo *rel = makeNode(RelOptInfo);
+
+	rel->reloptkind = RELOPT_BASEREL;
+	rel->relid = parentRTindex;
+	rel->relids = bms_make_singleton(parentRTindex);
+	set_relation_partition_info(root, rel, parentrel);
+
+	return prune_partitions_by_clauses(rel, prunequals);
+}
+
 /*
  * expand_single_inheritance_child
  *		Build a RangeTblEntry and an AppendRelInfo, if appropriate, plus
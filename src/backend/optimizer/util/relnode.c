@@ -16,6 +16,8 @@
 
 #include <limits.h>
 
+#include "access/heapam.h"
+#include "catalog/partition.h"
 #include "miscadmin.h"
 #include "optimizer/clauses.h"
 #include "optimizer/cost.h"
@@ -28,6 +30,7 @@
 #include "optimizer/tlist.h"
 #include "partitioning/partbounds.h"
 #include "utils/hsearch.h"
+#include "utils/rel.h"
 
 
 typedef struct JoinHashEntry
@@ -276,15 +279,25 @@ build_simple_rel(PlannerInfo *root, int relid, RelOptInfo *parent)
 		ListCell   *l;
 		int			nparts = rel->nparts;
 		int			cnt_parts = 0;
+		Relation	relation = NULL;
+		PartitionDesc partdesc = NULL;
 
 		if (nparts > 0)
+		{
 			rel->part_rels = (RelOptInfo **)
-				palloc(sizeof(RelOptInfo *) * nparts);
+				palloc0(sizeof(RelOptInfo *) * nparts);
+
+			/* We need the partition OIDs to place the children; see below */
+			relation = heap_open(rte->relid, NoLock);
+			partdesc = RelationGetPartitionDesc(relation);
+			Assert(partdesc->nparts == nparts);
+		}
 
 		foreach(l, root->append_rel_list)
 		{
 			AppendRelInfo *appinfo = (AppendRelInfo *) lfirst(l);
 			RelOptInfo *childrel;
+			Oid			childoid;
 
 			/* append_rel_list contains all append rels; ignore others */
 			if (appinfo->parent_relid != relid)
@@ -301,14 +314,19 @@ build_simple_rel(PlannerInfo *root, int relid, RelOptInfo *parent)
 			 * The order of partition OIDs in append_rel_list is the same as
 			 * the order in the PartitionDesc, so the order of part_rels will
 			 * also match the PartitionDesc.  See expand_partitioned_rtentry.
+			 * Partitions pruned during expansion have no AppendRelInfo, and
+			 * their entries in part_rels are left NULL.
 			 */
+			childoid = root->simple_rte_array[appinfo->child_relid]->relid;
+			while (cnt_parts < nparts && partdesc->oids[cnt_parts] != childoid)
+				cnt_parts++;
 			Assert(cnt_parts < nparts);
 			rel->part_rels[cnt_parts] = childrel;
 			cnt_parts++;
 		}
 
-		/* We should have seen all the child partitions. */
-		Assert(cnt_parts == nparts);
+		if (relation)
+			heap_close(relation, NoLock);
 	}
 
 	return rel;
@@ -1588,6 +1606,8 @@ build_joinrel_partition_info(RelOptInfo *joinrel, RelOptInfo *outer_rel,
 	int			partnatts;
 	int			cnt;
 	PartitionScheme part_scheme;
+	PartitionBoundInfo boundinfo;
+	int			nparts;
 
 	/* Nothing to do if partitionwise join technique is disabled. */
 	if (!enable_partitionwise_join)
@@ -1624,18 +1644,41 @@ build_joinrel_partition_info(RelOptInfo *joinrel, RelOptInfo *outer_rel,
 		   REL_HAS_ALL_PART_PROPS(inner_rel));
 
 	/*
-	 * For now, our partition matching algorithm can match partitions only
-	 * when the partition bounds of the joining relations are exactly same.
-	 * So, bail out otherwise.
+	 * If the partition bounds of the joining relations are exactly the same,
+	 * so are those of the join.  Otherwise, try to match up the partitions
+	 * that overlap and derive the bounds of the join from them; bail out if
+	 * that fails.  try_partitionwise_join() matches up the partitions again
+	 * for each pair of relations this join is built from.
 	 */
-	if (outer_rel->nparts != inner_rel->nparts ||
-		!partition_bounds_equal(part_scheme->partnatts,
-								part_scheme->parttyplen,
-								part_scheme->parttypbyval,
-								outer_rel->boundinfo, inner_rel->boundinfo))
+	if (outer_rel->nparts == inner_rel->nparts &&
+		partition_bounds_equal(part_scheme->partnatts,
+							   part_scheme->parttyplen,
+							   part_scheme->parttypbyval,
+							   outer_rel->boundinfo, inner_rel->boundinfo))
 	{
-		Assert(!IS_PARTITIONED_REL(joinrel));
-		return;
+		boundinfo = outer_rel->boundinfo;
+		nparts = outer_rel->nparts;
+	}
+	else
+	{
+		List	   *outer_parts;
+		List	   *inner_parts;
+
+		boundinfo = partition_bounds_merge(part_scheme->partnatts,
+										   part_scheme->partsupfunc,
+										   part_scheme->partcollation,
+										   outer_rel->boundinfo,
+										   outer_rel->nparts,
+										   inner_rel->boundinfo,
+										   inner_rel->nparts,
+										   jointype,
+										   &outer_parts, &inner_parts);
+		if (boundinfo == NULL)
+		{
+			Assert(!IS_PARTITIONED_REL(joinrel));
+			return;
+		}
+		nparts = list_length(outer_parts);
 	}
 
 	/*
@@ -1649,15 +1692,15 @@ build_joinrel_partition_info(RelOptInfo *joinrel, RelOptInfo *outer_rel,
 
 	/*
 	 * Join relation is partitioned using the same partitioning scheme as the
-	 * joining relations and has same bounds.
+	 * joining relations.
 	 */
 	joinrel->part_scheme = part_scheme;
-	joinrel->boundinfo = outer_rel->boundinfo;
+	joinrel->boundinfo = boundinfo;
 	partnatts = joinrel->part_scheme->partnatts;
 	joinrel->partexprs = (List **) palloc0(sizeof(List *) * partnatts);
 	joinrel->nullable_partexprs =
 		(List **) palloc0(sizeof(List *) * partnatts);
-	joinrel->nparts = outer_rel->nparts;
+	joinrel->nparts = nparts;
 	joinrel->part_rels =
 		(RelOptInfo **) palloc0(sizeof(RelOptInfo *) * joinrel->nparts);
 
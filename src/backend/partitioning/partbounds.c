@@ -65,6 +65,21 @@ typedef struct PartitionRangeBound
 	bool		lower;			/* this is the lower (vs upper) bound */
 } PartitionRangeBound;
 
+/* Working state of partition_bounds_merge() */
+typedef struct PartitionMergeState
+{
+	JoinType	jointype;		/* type of the join */
+	int		   *outer_map;		/* for each outer partition, the inner one it
+								 * overlaps, or -1 */
+	int		   *inner_map;		/* likewise for inner partitions */
+	int		   *merged_of_outer;	/* for each outer partition, its partition
+									 * in the join, or -1 */
+	int		   *merged_of_inner;	/* likewise for inner partitions */
+	int			nmerged;		/* number of partitions of the join so far */
+	List	   *outer_parts;	/* outer partition of each one, or -1 */
+	List	   *inner_parts;	/* inner partition of each one, or -1 */
+} PartitionMergeState;
+
 static int32 qsort_partition_hbound_cmp(const void *a, const void *b);
 static int32 qsort_partition_list_value_cmp(const void *a, const void *b,
 							   void *arg);
@@ -104,6 +119,22 @@ static void get_range_key_properties(PartitionKey key, int keynum,
 						 Expr **keyCol,
 						 Const **lower_val, Const **upper_val);
 static List *get_range_nulltest(PartitionKey key);
+static bool pair_partitions(PartitionMergeState *st, int outer_index,
+				int inner_index);
+static bool keep_merged_values(PartitionMergeState *st, bool has_outer,
+				   bool has_inner);
+static int get_merged_partition(PartitionMergeState *st, int outer_index,
+					 int inner_index);
+static PartitionBoundInfo merge_list_bounds(FmgrInfo *partsupfunc,
+				  Oid *partcollation, PartitionBoundInfo outer_bi,
+				  PartitionBoundInfo inner_bi, PartitionMergeState *st);
+static PartitionBoundInfo merge_range_bounds(int partnatts,
+				   FmgrInfo *partsupfunc, Oid *partcollation,
+				   PartitionBoundInfo outer_bi, PartitionBoundInfo inner_bi,
+				   PartitionMergeState *st);
+static int get_range_partition_bounds(PartitionBoundInfo bi,
+						   PartitionRangeBound **lbs,
+						   PartitionRangeBound **ubs);
 
 /*
  * get_qual_from_partbound
@@ -857,6 +888,557 @@ partition_bounds_copy(PartitionBoundInfo src,
 	return dest;
 }
 
+/*
+ * partition_bounds_merge
+ *		Match up the partitions of two partitioned relations that are joined
+ *		on their partition keys, and compute the partition bounds of the join.
+ *
+ * This is for relations whose bounds are not equal, as when a partition has
+ * been added to only one of them.  Each partition may overlap at most one
+ * partition of the other relation.  A partition that overlaps none is part of
+ * the join only if the join type keeps its rows: outer partitions for LEFT,
+ * ANTI and FULL joins, inner partitions for FULL joins.  A default partition
+ * is only allowed on one side, and only if all the values that the other
+ * side's partitions accept are in non-default partitions of its own side, so
+ * that it can't match anything.  Hash partitions are only matched when the
+ * bounds are equal.
+ *
+ * Returns the bounds of the join, or NULL if the partitions can't be matched
+ * in this way.  *outer_parts and *inner_parts are set to integer lists with,
+ * for each partition of the join, the indexes of the outer and inner
+ * partitions to be joined, or -1 where the partition doesn't exist on that
+ * side.
+ */
+PartitionBoundInfo
+partition_bounds_merge(int partnatts, FmgrInfo *partsupfunc,
+					   Oid *partcollation,
+					   PartitionBoundInfo outer_bi, int outer_nparts,
+					   PartitionBoundInfo inner_bi, int inner_nparts,
+					   JoinType jointype,
+					   List **outer_parts, List **inner_parts)
+{
+	PartitionMergeState st;
+	PartitionBoundInfo result = NULL;
+	int			i;
+
+	*outer_parts = NIL;
+	*inner_parts = NIL;
+
+	Assert(outer_bi->strategy == inner_bi->strategy);
+	Assert(jointype == JOIN_INNER || jointype == JOIN_LEFT ||
+		   jointype == JOIN_FULL || jointype == JOIN_SEMI ||
+		   jointype == JOIN_ANTI);
+
+	/*
+	 * Default partitions on both sides would have to be joined with each
+	 * other as well as with the other side's regular partitions.
+	 */
+	if (partition_bound_has_default(outer_bi) &&
+		partition_bound_has_default(inner_bi))
+		return NULL;
+
+	st.jointype = jointype;
+	st.outer_map = (int *) palloc(sizeof(int) * outer_nparts);
+	st.inner_map = (int *) palloc(sizeof(int) * inner_nparts);
+	st.merged_of_outer = (int *) palloc(sizeof(int) * outer_nparts);
+	st.merged_of_inner = (int *) palloc(sizeof(int) * inner_nparts);
+	for (i = 0; i < outer_nparts; i++)
+		st.outer_map[i] = st.merged_of_outer[i] = -1;
+	for (i = 0; i < inner_nparts; i++)
+		st.inner_map[i] = st.merged_of_inner[i] = -1;
+	st.nmerged = 0;
+	st.outer_parts = NIL;
+	st.inner_parts = NIL;
+
+	switch (outer_bi->strategy)
+	{
+		case PARTITION_STRATEGY_LIST:
+			result = merge_list_bounds(partsupfunc, partcollation,
+									   outer_bi, inner_bi, &st);
+			break;
+
+		case PARTITION_STRATEGY_RANGE:
+			result = merge_range_bounds(partnatts, partsupfunc,
+										partcollation, outer_bi, inner_bi,
+										&st);
+			break;
+
+		case PARTITION_STRATEGY_HASH:
+			break;
+
+		default:
+			elog(ERROR, "unexpected partition strategy: %d",
+				 (int) outer_bi->strategy);
+	}
+
+	pfree(st.outer_map);
+	pfree(st.inner_map);
+	pfree(st.merged_of_outer);
+	pfree(st.merged_of_inner);
+
+	/* A join without any partitions may as well not be partitioned */
+	if (result == NULL || st.nmerged == 0)
+		return NULL;
+
+	*outer_parts = st.outer_parts;
+	*inner_parts = st.inner_parts;
+	return result;
+}
+
+/*
+ * pair_partitions
+ *		Record that the given outer and inner partitions overlap.
+ *
+ * Returns false, changing nothing, if either of them already overlaps
+ * another partition.
+ */
+static bool
+pair_partitions(PartitionMergeState *st, int outer_index, int inner_index)
+{
+	if (st->outer_map[outer_index] == -1 && st->inner_map[inner_index] == -1)
+	{
+		st->outer_map[outer_index] = inner_index;
+		st->inner_map[inner_index] = outer_index;
+		return true;
+	}
+
+	return st->outer_map[outer_index] == inner_index &&
+		st->inner_map[inner_index] == outer_index;
+}
+
+/*
+ * keep_merged_values
+ *		Can rows with key values in the partitions of only the outer side,
+ *		or only the inner side, be in the result of the join?
+ */
+static bool
+keep_merged_values(PartitionMergeState *st, bool has_outer, bool has_inner)
+{
+	if (has_outer && has_inner)
+		return true;
+	if (has_outer)
+		return st->jointype == JOIN_LEFT || st->jointype == JOIN_ANTI ||
+			st->jointype == JOIN_FULL;
+	return st->jointype == JOIN_FULL;
+}
+
+/*
+ * get_merged_partition
+ *		Return the index of the partition of the join that the given outer or
+ *		inner partition, or pair of them, goes to, assigning the next index
+ *		if it has none yet.
+ */
+static int
+get_merged_partition(PartitionMergeState *st, int outer_index,
+					 int inner_index)
+{
+	int			merged_index;
+
+	if (outer_index < 0)
+		outer_index = st->inner_map[inner_index];
+	else if (inner_index < 0)
+		inner_index = st->outer_map[outer_index];
+
+	if (outer_index >= 0 && st->merged_of_outer[outer_index] >= 0)
+		return st->merged_of_outer[outer_index];
+	if (inner_index >= 0 && st->merged_of_inner[inner_index] >= 0)
+		return st->merged_of_inner[inner_index];
+
+	merged_index = st->nmerged++;
+	if (outer_index >= 0)
+		st->merged_of_outer[outer_index] = merged_index;
+	if (inner_index >= 0)
+		st->merged_of_inner[inner_index] = merged_index;
+	st->outer_parts = lappend_int(st->outer_parts, outer_index);
+	st->inner_parts = lappend_int(st->inner_parts, inner_index);
+
+	return merged_index;
+}
+
+/*
+ * merge_list_bounds
+ *		partition_bounds_merge() for list partitioning
+ *
+ * Values that are accepted on both sides pair up the partitions accepting
+ * them.  A value accepted only on one side can't be matched on the other
+ * unless that side has a default partition, which we don't support.  NULLs
+ * never match anything, since the join operators are strict, but we pair up
+ * the NULL-accepting partitions if we can, so that the outer side's NULLs
+ * needn't be in a partition that exists on one side only.
+ */
+static PartitionBoundInfo
+merge_list_bounds(FmgrInfo *partsupfunc, Oid *partcollation,
+				  PartitionBoundInfo outer_bi, PartitionBoundInfo inner_bi,
+				  PartitionMergeState *st)
+{
+	PartitionBoundInfo merged_bi;
+	int			max_datums = outer_bi->ndatums + inner_bi->ndatums;
+	Datum	  **values = (Datum **) palloc(sizeof(Datum *) * max_datums);
+	int		   *value_outer = (int *) palloc(sizeof(int) * max_datums);
+	int		   *value_inner = (int *) palloc(sizeof(int) * max_datums);
+	int			nvalues = 0;
+	int			outer_pos = 0;
+	int			inner_pos = 0;
+	int			ndatums;
+	int			outer_null_merged = -1;
+	int			inner_null_merged = -1;
+	int			i;
+
+	/* Merge the sorted values of both sides, pairing up the partitions */
+	while (outer_pos < outer_bi->ndatums || inner_pos < inner_bi->ndatums)
+	{
+		int32		cmpval;
+
+		if (outer_pos >= outer_bi->ndatums)
+			cmpval = 1;
+		else if (inner_pos >= inner_bi->ndatums)
+			cmpval = -1;
+		else
+			cmpval = DatumGetInt32(FunctionCall2Coll(&partsupfunc[0],
+													 partcollation[0],
+													 outer_bi->datums[outer_pos][0],
+													 inner_bi->datums[inner_pos][0]));
+
+		if (cmpval == 0)
+		{
+			if (!pair_partitions(st, outer_bi->indexes[outer_pos],
+								 inner_bi->indexes[inner_pos]))
+				return NULL;
+			values[nvalues] = outer_bi->datums[outer_pos];
+			value_outer[nvalues] = outer_bi->indexes[outer_pos++];
+			value_inner[nvalues] = inner_bi->indexes[inner_pos++];
+		}
+		else if (cmpval < 0)
+		{
+			/* The inner side's rows with this value are in its default */
+			if (partition_bound_has_default(inner_bi))
+				return NULL;
+			values[nvalues] = outer_bi->datums[outer_pos];
+			value_outer[nvalues] = outer_bi->indexes[outer_pos++];
+			value_inner[nvalues] = -1;
+		}
+		else
+		{
+			if (partition_bound_has_default(outer_bi))
+				return NULL;
+			values[nvalues] = inner_bi->datums[inner_pos];
+			value_outer[nvalues] = -1;
+			value_inner[nvalues] = inner_bi->indexes[inner_pos++];
+		}
+		nvalues++;
+	}
+
+	if (partition_bound_accepts_nulls(outer_bi) &&
+		partition_bound_accepts_nulls(inner_bi) &&
+		keep_merged_values(st, true, false))
+		(void) pair_partitions(st, outer_bi->null_index,
+							   inner_bi->null_index);
+
+	/* Build the bounds of the join from the values it may contain */
+	merged_bi = (PartitionBoundInfo) palloc(sizeof(PartitionBoundInfoData));
+	merged_bi->strategy = PARTITION_STRATEGY_LIST;
+	merged_bi->kind = NULL;
+	merged_bi->datums = (Datum **) palloc(sizeof(Datum *) * Max(nvalues, 1));
+	merged_bi->indexes = (int *) palloc(sizeof(int) * Max(nvalues, 1));
+
+	ndatums = 0;
+	for (i = 0; i < nvalues; i++)
+	{
+		if (!keep_merged_values(st, value_outer[i] >= 0, value_inner[i] >= 0))
+			continue;
+		merged_bi->datums[ndatums] = values[i];
+		merged_bi->indexes[ndatums] = get_merged_partition(st, value_outer[i],
+														   value_inner[i]);
+		ndatums++;
+	}
+	merged_bi->ndatums = ndatums;
+
+	/*
+	 * The NULL-accepting partitions and the default partition come after the
+	 * values, as in create_list_bounds, so that the merged bounds are in
+	 * canonical form.  The join can only have one NULL-accepting partition.
+	 */
+	if (partition_bound_accepts_nulls(outer_bi) &&
+		keep_merged_values(st, true, false))
+		outer_null_merged = get_merged_partition(st, outer_bi->null_index, -1);
+	if (partition_bound_accepts_nulls(inner_bi) &&
+		keep_merged_values(st, false, true))
+		inner_null_merged = get_merged_partition(st, -1, inner_bi->null_index);
+	if (outer_null_merged >= 0 && inner_null_merged >= 0 &&
+		outer_null_merged != inner_null_merged)
+		return NULL;
+	merged_bi->null_index = Max(outer_null_merged, inner_null_merged);
+
+	merged_bi->default_index = -1;
+	if (partition_bound_has_default(outer_bi) &&
+		keep_merged_values(st, true, false))
+		merged_bi->default_index =
+			get_merged_partition(st, outer_bi->default_index, -1);
+	else if (partition_bound_has_default(inner_bi) &&
+			 keep_merged_values(st, false, true))
+		merged_bi->default_index =
+			get_merged_partition(st, -1, inner_bi->default_index);
+
+	pfree(values);
+	pfree(value_outer);
+	pfree(value_inner);
+
+	return merged_bi;
+}
+
+/*
+ * merge_range_bounds
+ *		partition_bounds_merge() for range partitioning
+ *
+ * The ranges of both sides are walked in order, pairing up the ones that
+ * overlap.  The range of a pair in the join is their intersection for an
+ * INNER or SEMI join, the outer range for a LEFT or ANTI join, and their
+ * union for a FULL join.
+ */
+static PartitionBoundInfo
+merge_range_bounds(int partnatts, FmgrInfo *partsupfunc, Oid *partcollation,
+				   PartitionBoundInfo outer_bi, PartitionBoundInfo inner_bi,
+				   PartitionMergeState *st)
+{
+	PartitionBoundInfo merged_bi;
+	PartitionRangeBound *outer_lbs,
+			   *outer_ubs,
+			   *inner_lbs,
+			   *inner_ubs;
+	PartitionRangeBound *merged_lbs,
+			   *merged_ubs;
+	int		   *merged_outer,
+			   *merged_inner;
+	bool	   *outer_contained,
+			   *inner_contained;
+	int			nouter,
+				ninner,
+				nmerged = 0;
+	int			outer_pos = 0;
+	int			inner_pos = 0;
+	int			ndatums;
+	int			i;
+
+	nouter = get_range_partition_bounds(outer_bi, &outer_lbs, &outer_ubs);
+	ninner = get_range_partition_bounds(inner_bi, &inner_lbs, &inner_ubs);
+	merged_lbs = (PartitionRangeBound *)
+		palloc(sizeof(PartitionRangeBound) * (nouter + ninner));
+	merged_ubs = (PartitionRangeBound *)
+		palloc(sizeof(PartitionRangeBound) * (nouter + ninner));
+	merged_outer = (int *) palloc(sizeof(int) * (nouter + ninner));
+	merged_inner = (int *) palloc(sizeof(int) * (nouter + ninner));
+	outer_contained = (bool *) palloc0(sizeof(bool) * Max(nouter, 1));
+	inner_contained = (bool *) palloc0(sizeof(bool) * Max(ninner, 1));
+
+#define RBOUND_CMP(b1, b2) \
+	partition_rbound_cmp(partnatts, partsupfunc, partcollation, \
+						 (b1)->datums, (b1)->kind, (b1)->lower, (b2))
+
+	while (outer_pos < nouter || inner_pos < ninner)
+	{
+		PartitionRangeBound *olb = &outer_lbs[outer_pos],
+				   *oub = &outer_ubs[outer_pos],
+				   *ilb = &inner_lbs[inner_pos],
+				   *iub = &inner_ubs[inner_pos];
+
+		if (outer_pos < nouter && inner_pos < ninner &&
+			RBOUND_CMP(olb, iub) < 0 && RBOUND_CMP(ilb, oub) < 0)
+		{
+			/* The ranges overlap */
+			int32		lb_cmpval = RBOUND_CMP(olb, ilb);
+			int32		ub_cmpval = RBOUND_CMP(oub, iub);
+
+			if (!pair_partitions(st, olb->index, ilb->index))
+				return NULL;
+
+			outer_contained[outer_pos] = (lb_cmpval >= 0 && ub_cmpval <= 0);
+			inner_contained[inner_pos] = (lb_cmpval <= 0 && ub_cmpval >= 0);
+
+			switch (st->jointype)
+			{
+				case JOIN_INNER:
+				case JOIN_SEMI:
+					merged_lbs[nmerged] = (lb_cmpval > 0) ? *olb : *ilb;
+					merged_ubs[nmerged] = (ub_cmpval < 0) ? *oub : *iub;
+					break;
+				case JOIN_LEFT:
+				case JOIN_ANTI:
+					merged_lbs[nmerged] = *olb;
+					merged_ubs[nmerged] = *oub;
+					break;
+				default:
+					merged_lbs[nmerged] = (lb_cmpval < 0) ? *olb : *ilb;
+					merged_ubs[nmerged] = (ub_cmpval > 0) ? *oub : *iub;
+					break;
+			}
+			merged_outer[nmerged] = olb->index;
+			merged_inner[nmerged] = ilb->index;
+			nmerged++;
+
+			/* Move past the range that ends first, or both */
+			if (ub_cmpval <= 0)
+				outer_pos++;
+			if (ub_cmpval >= 0)
+				inner_pos++;
+		}
+		else if (inner_pos >= ninner ||
+				 (outer_pos < nouter && RBOUND_CMP(oub, ilb) < 0))
+		{
+			/* The outer range comes first and overlaps nothing further */
+			if (st->outer_map[olb->index] == -1 &&
+				keep_merged_values(st, true, false))
+			{
+				merged_lbs[nmerged] = *olb;
+				merged_ubs[nmerged] = *oub;
+				merged_outer[nmerged] = olb->index;
+				merged_inner[nmerged] = -1;
+				nmerged++;
+			}
+			outer_pos++;
+		}
+		else
+		{
+			/* Likewise for the inner range */
+			if (st->inner_map[ilb->index] == -1 &&
+				keep_merged_values(st, false, true))
+			{
+				merged_lbs[nmerged] = *ilb;
+				merged_ubs[nmerged] = *iub;
+				merged_outer[nmerged] = -1;
+				merged_inner[nmerged] = ilb->index;
+				nmerged++;
+			}
+			inner_pos++;
+		}
+	}
+
+	/*
+	 * A default partition can only be left unmatched if all the ranges of
+	 * the other side are within single ranges of its own side.
+	 */
+	if (partition_bound_has_default(outer_bi))
+	{
+		for (i = 0; i < ninner; i++)
+			if (!inner_contained[i])
+				return NULL;
+	}
+	if (partition_bound_has_default(inner_bi))
+	{
+		for (i = 0; i < nouter; i++)
+			if (!outer_contained[i])
+				return NULL;
+	}
+
+	/*
+	 * Build the bounds of the join.  Like create_range_bounds, store only
+	 * the upper bound of contiguous ranges, and give the partitions indexes
+	 * in the order of their ranges.
+	 */
+	merged_bi = (PartitionBoundInfo) palloc(sizeof(PartitionBoundInfoData));
+	merged_bi->strategy = PARTITION_STRATEGY_RANGE;
+	merged_bi->datums = (Datum **) palloc(sizeof(Datum *) * Max(2 * nmerged, 1));
+	merged_bi->kind = (PartitionRangeDatumKind **)
+		palloc(sizeof(PartitionRangeDatumKind *) * Max(2 * nmerged, 1));
+	merged_bi->indexes = (int *) palloc(sizeof(int) * (2 * nmerged + 1));
+	merged_bi->null_index = -1;
+
+	ndatums = 0;
+	for (i = 0; i < nmerged; i++)
+	{
+		PartitionRangeBound *lb = &merged_lbs[i];
+		PartitionRangeBound *ub = &merged_ubs[i];
+		int32		cmpval = -1;
+
+		/*
+		 * Compare the lower bound with the previous upper bound as values,
+		 * ignoring which bound each is.  Empty or overlapping ranges can't
+		 * come from the walk above, but we'd better not build broken bounds.
+		 */
+		if (RBOUND_CMP(lb, ub) >= 0)
+			return NULL;
+		if (i > 0)
+		{
+			PartitionRangeBound *prev_ub = &merged_ubs[i - 1];
+
+			cmpval = partition_rbound_cmp(partnatts, partsupfunc,
+										  partcollation, prev_ub->datums,
+										  prev_ub->kind, true, lb);
+			if (cmpval > 0)
+				return NULL;
+		}
+		if (cmpval < 0)
+		{
+			merged_bi->datums[ndatums] = lb->datums;
+			merged_bi->kind[ndatums] = lb->kind;
+			merged_bi->indexes[ndatums] = -1;
+			ndatums++;
+		}
+		merged_bi->datums[ndatums] = ub->datums;
+		merged_bi->kind[ndatums] = ub->kind;
+		merged_bi->indexes[ndatums] = get_merged_partition(st, merged_outer[i],
+														   merged_inner[i]);
+		ndatums++;
+	}
+	merged_bi->indexes[ndatums] = -1;
+	merged_bi->ndatums = ndatums;
+
+#undef RBOUND_CMP
+
+	merged_bi->default_index = -1;
+	if (partition_bound_has_default(outer_bi) &&
+		keep_merged_values(st, true, false))
+		merged_bi->default_index =
+			get_merged_partition(st, outer_bi->default_index, -1);
+	else if (partition_bound_has_default(inner_bi) &&
+			 keep_merged_values(st, false, true))
+		merged_bi->default_index =
+			get_merged_partition(st, -1, inner_bi->default_index);
+
+	return merged_bi;
+}
+
+/*
+ * get_range_partition_bounds
+ *		Extract the lower and upper bounds of each non-default partition of
+ *		a range partitioned relation, in order, into palloc'd arrays.
+ *
+ * Returns the number of partitions.
+ */
+static int
+get_range_partition_bounds(PartitionBoundInfo bi, PartitionRangeBound **lbs,
+						   PartitionRangeBound **ubs)
+{
+	int			n = 0;
+	int			i;
+
+	*lbs = (PartitionRangeBound *)
+		palloc(sizeof(PartitionRangeBound) * Max(bi->ndatums, 1));
+	*ubs = (PartitionRangeBound *)
+		palloc(sizeof(PartitionRangeBound) * Max(bi->ndatums, 1));
+
+	/*
+	 * The partition with index indexes[i] has datums[i] as upper bound, and
+	 * datums[i - 1] as lower bound; see create_range_bounds.
+	 */
+	for (i = 1; i < bi->ndatums; i++)
+	{
+		if (bi->indexes[i] < 0)
+			continue;
+
+		(*lbs)[n].index = bi->indexes[i];
+		(*lbs)[n].datums = bi->datums[i - 1];
+		(*lbs)[n].kind = bi->kind[i - 1];
+		(*lbs)[n].lower = true;
+		(*ubs)[n].index = bi->indexes[i];
+		(*ubs)[n].datums = bi->datums[i];
+		(*ubs)[n].kind = bi->kind[i];
+		(*ubs)[n].lower = false;
+		n++;
+	}
+
+	return n;
+}
+
 /*
  * check_new_partition_bound
  *
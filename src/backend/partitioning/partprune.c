@@ -442,8 +442,19 @@ make_partitionedrel_pruneinfo(PlannerInfo *root, RelOptInfo *parentrel,
 		for (i = 0; i < nparts; i++)
 		{
 			RelOptInfo *partrel = subpart->part_rels[i];
-			int			subplanidx = relid_subplan_map[partrel->relid] - 1;
-			int			subpartidx = relid_subpart_map[partrel->relid] - 1;
+			int			subplanidx;
+			int			subpartidx;
+
+			/* Partitions pruned during expansion have no RelOptInfo */
+			if (partrel == NULL)
+			{
+				subplan_map[i] = -1;
+				subpart_map[i] = -1;
+				continue;
+			}
+
+			subplanidx = relid_subplan_map[partrel->relid] - 1;
+			subpartidx = relid_subpart_map[partrel->relid] - 1;
 
 			subplan_map[i] = subplanidx;
 			subpart_map[i] = subpartidx;
@@ -549,12 +560,44 @@ Relids
 prune_append_rel_partitions(RelOptInfo *rel)
 {
 	Relids		result;
-	List	   *clauses = rel->baserestrictinfo;
+	Bitmapset  *partindexes;
+	int			i;
+
+	Assert(rel->baserestrictinfo != NIL);
+
+	partindexes = prune_partitions_by_clauses(rel, rel->baserestrictinfo);
+
+	/*
+	 * Add selected partitions' RT indexes to result.  Partitions that were
+	 * already pruned when the inheritance set was expanded have no
+	 * RelOptInfo; skip them.
+	 */
+	i = -1;
+	result = NULL;
+	while ((i = bms_next_member(partindexes, i)) >= 0)
+	{
+		if (rel->part_rels[i] != NULL)
+			result = bms_add_member(result, rel->part_rels[i]->relid);
+	}
+
+	return result;
+}
+
+/*
+ * prune_partitions_by_clauses
+ *		Returns the indexes (in the PartitionDesc, and in rel->part_rels) of
+ *		the partitions of 'rel' that may contain rows satisfying 'clauses'.
+ *
+ * 'clauses' are expressions or RestrictInfos referring to 'rel' by its
+ * relid.  Only the partitioning properties of 'rel' are used, so this also
+ * serves to prune partitions before their RelOptInfos have been built.
+ */
+Bitmapset *
+prune_partitions_by_clauses(RelOptInfo *rel, List *clauses)
+{
 	List	   *pruning_steps;
 	bool		contradictory;
 	PartitionPruneContext context;
-	Bitmapset  *partindexes;
-	int			i;
 
 	Assert(clauses != NIL);
 	Assert(rel->part_scheme != NULL);
@@ -590,15 +633,7 @@ prune_append_rel_partitions(RelOptInfo *rel)
 	context.evalexecparams = false;
 
 	/* Actual pruning happens here. */
-	partindexes = get_matching_partitions(&context, pruning_steps);
-
-	/* Add selected partitions' RT indexes to result. */
-	i = -1;
-	result = NULL;
-	while ((i = bms_next_member(partindexes, i)) >= 0)
-		result = bms_add_member(result, rel->part_rels[i]->relid);
-
-	return result;
+	return get_matching_partitions(&context, pruning_steps);
 }
 
 /*
@@ -30,6 +30,10 @@
 #ifdef HAVE_SYS_SHM_H
 #include <sys/shm.h>
 #endif
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#endif
 
 #include "miscadmin.h"
 #include "portability/mem.h"
@@ -67,6 +71,18 @@
 #define USE_ANONYMOUS_SHMEM
 #endif
 
+/*
+ * NUMA memory policies are set and queried with the raw system calls, so
+ * that we needn't depend on libnuma.  The node masks passed to the kernel
+ * must have room for all nodes it could possibly have; NUMA_MAX_NODES is
+ * comfortably above the largest configuration (CONFIG_NODES_SHIFT = 10).
+ */
+#if defined(__linux__) && defined(SYS_mbind) && defined(SYS_get_mempolicy) && defined(SYS_move_pages)
+#define USE_NUMA_SHMEM
+#define NUMA_MAX_NODES	4096
+#define NUMA_MASK_WORDS (NUMA_MAX_NODES / (8 * sizeof(unsigned long)))
+#endif
+
 
 typedef key_t IpcMemoryKey;		/* shared memory key passed to shmget(2) */
 typedef int IpcMemoryId;		/* shared memory ID returned by shmget(2) */
@@ -81,6 +97,7 @@ static void *AnonymousShmem = NULL;
 #endif
 
 static void *InternalIpcMemoryCreate(IpcMemoryKey memKey, Size size);
+static void ApplyNumaPolicy(void *addr, Size size);
 static void IpcMemoryDetach(int status, Datum shmaddr);
 static void IpcMemoryDelete(int status, Datum shmId);
 static PGShmemHeader *PGSharedMemoryAttach(IpcMemoryKey key,
@@ -446,6 +463,89 @@ GetHugePageSize(Size *hugepagesize, int *mmap_flags)
 
 #endif							/* MAP_HUGETLB */
 
+/*
+ * ApplyNumaPolicy --- set the memory policy of a new segment
+ *
+ * With shared_memory_numa = interleave, spread the pages of the segment
+ * round-robin across all the NUMA nodes we're allowed to use, so that buffer
+ * hits aren't all served from whichever node happened to touch the memory
+ * first.  This must be done before any of the segment is touched, since the
+ * kernel places a page when it is first faulted in.  Failing to set the
+ * policy isn't fatal; we just carry on with the default placement.
+ */
+static void
+ApplyNumaPolicy(void *addr, Size size)
+{
+#ifdef USE_NUMA_SHMEM
+	unsigned long nodemask[NUMA_MASK_WORDS];
+	int			mode;
+	int			nnodes = 0;
+	int			i;
+
+	if (shared_memory_numa == SHMEM_NUMA_OFF)
+		return;
+
+	memset(nodemask, 0, sizeof(nodemask));
+	if (syscall(SYS_get_mempolicy, &mode, nodemask, (unsigned long) NUMA_MAX_NODES,
+				NULL, (unsigned long) MPOL_F_MEMS_ALLOWED) != 0)
+	{
+		ereport(LOG,
+				(errmsg("could not determine NUMA nodes: %m")));
+		return;
+	}
+
+	for (i = 0; i < NUMA_MASK_WORDS; i++)
+	{
+		unsigned long word = nodemask[i];
+
+		for (; word != 0; word &= word - 1)
+			nnodes++;
+	}
+
+	/* Nothing to interleave across on a single node */
+	if (nnodes <= 1)
+		return;
+
+	if (syscall(SYS_mbind, addr, (unsigned long) size, MPOL_INTERLEAVE,
+				nodemask, (unsigned long) NUMA_MAX_NODES, 0) != 0)
+		ereport(LOG,
+				(errmsg("could not interleave shared memory across NUMA nodes: %m")));
+	else
+		elog(DEBUG1, "interleaved shared memory segment of %zu bytes across %d NUMA nodes",
+			 size, nnodes);
+#endif
+}
+
+/*
+ * PGSharedMemoryGetNumaNodes --- report where shared memory pages live
+ *
+ * For each of the count addresses in pages, store the NUMA node of the page
+ * containing it in nodes, or -1 if the page isn't in memory yet.  Returns
+ * false if this isn't supported on this platform.
+ */
+bool
+PGSharedMemoryGetNumaNodes(void **pages, int count, int *nodes)
+{
+#ifdef USE_NUMA_SHMEM
+	int			i;
+
+	/* Passing no target nodes makes move_pages() just report the status */
+	if (syscall(SYS_move_pages, 0, (unsigned long) count, pages, NULL,
+				nodes, 0) != 0)
+		ereport(ERROR,
+				(errmsg("could not get NUMA nodes of shared memory pages: %m")));
+
+	for (i = 0; i < count; i++)
+	{
+		if (nodes[i] < 0)
+			nodes[i] = -1;
+	}
+	return true;
+#else
+	return false;
+#endif
+}
+
 /*
  * Creates an anonymous mmap()ed shared memory segment.
  *
@@ -573,12 +673,20 @@ PGSharedMemoryCreate(Size size, bool makePrivate, int port,
 				 errmsg("huge pages not supported on this platform")));
 #endif
 
+#ifndef USE_NUMA_SHMEM
+	if (shared_memory_numa != SHMEM_NUMA_OFF)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("NUMA memory policies are not supported on this platform")));
+#endif
+
 	/* Room for a header? */
 	Assert(size > MAXALIGN(sizeof(PGShmemHeader)));
 
 #ifdef USE_ANONYMOUS_SHMEM
 	AnonymousShmem = CreateAnonymousSegment(&size);
 	AnonymousShmemSize = size;
+	ApplyNumaPolicy(AnonymousShmem, size);
 
 	/* Register on-exit routine to unmap the anonymous segment */
 	on_shmem_exit(AnonymousShmemDetach, (Datum) 0);
@@ -651,6 +759,11 @@ PGSharedMemoryCreate(Size size, bool makePrivate, int port,
 		 */
 	}
 
+#ifndef USE_ANONYMOUS_SHMEM
+	/* The System V segment is the real one, so set its policy */
+	ApplyNumaPolicy(memAddress, sysvsize);
+#endif
+
 	/*
 	 * OK, we created a new segment.  Mark it as created by this process. The
 	 * order of assignments here is critical so that another Postgres process
@@ -192,6 +192,11 @@ PGSharedMemoryCreate(Size size, bool makePrivate, int port,
 	Size		orig_size = size;
 	DWORD		flProtect = PAGE_READWRITE;
 
+	if (shared_memory_numa != SHMEM_NUMA_OFF)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("NUMA memory policies are not supported on this platform")));
+
 	/* Room for a header? */
 	Assert(size > MAXALIGN(sizeof(PGShmemHeader)));
 
@@ -474,6 +479,17 @@ PGSharedMemoryDetach(void)
 	}
 }
 
+/*
+ * PGSharedMemoryGetNumaNodes
+ *
+ * Reporting the NUMA placement of pages isn't supported on Windows.
+ */
+bool
+PGSharedMemoryGetNumaNodes(void **pages, int count, int *nodes)
+{
+	return false;
+}
+
 
 /*
  * pgwin32_SharedMemoryDelete
@@ -116,10 +116,13 @@ int			autovacuum_work_mem = -1;
 int			autovacuum_naptime;
 int			autovacuum_vac_thresh;
 double		autovacuum_vac_scale;
+int			autovacuum_vac_ins_thresh;
+double		autovacuum_vac_ins_scale;
 int			autovacuum_anl_thresh;
 double		autovacuum_anl_scale;
 int			autovacuum_freeze_max_age;
 int			autovacuum_multixact_freeze_max_age;
+int			autovacuum_failsafe_age;
 
 int			autovacuum_vac_cost_delay;
 int			autovacuum_vac_cost_limit;
@@ -184,6 +187,17 @@ typedef struct av_relation
 								 * reloptions, or NULL if none */
 } av_relation;
 
+/*
+ * struct to keep track of the tables that need processing while collecting
+ * them from pg_class, so that they can be sorted by urgency
+ */
+typedef struct av_candidate
+{
+	Oid			ac_relid;
+	bool		ac_wraparound;	/* is a vacuum forced for wraparound? */
+	double		ac_score;		/* see relation_needs_vacanalyze */
+} av_candidate;
+
 /* struct to keep track of tables to vacuum and/or analyze, after rechecking */
 typedef struct autovac_table
 {
@@ -330,15 +344,15 @@ static void relation_needs_vacanalyze(Oid relid, AutoVacOpts *relopts,
 						  Form_pg_class classForm,
 						  PgStat_StatTabEntry *tabentry,
 						  int effective_multixact_freeze_max_age,
-						  bool *dovacuum, bool *doanalyze, bool *wraparound);
+						  bool *dovacuum, bool *doanalyze, bool *wraparound,
+						  double *score);
+static bool relation_needs_failsafe(Form_pg_class classForm);
+static int	av_candidate_comparator(const void *a, const void *b);
 
 static void autovacuum_do_vac_analyze(autovac_table *tab,
 						  BufferAccessStrategy bstrategy);
 static AutoVacOpts *extract_autovac_opts(HeapTuple tup,
 					 TupleDesc pg_class_desc);
-static PgStat_StatTabEntry *get_pgstat_tabentry_relid(Oid relid, bool isshared,
-						  PgStat_StatDBEntry *shared,
-						  PgStat_StatDBEntry *dbentry);
 static void perform_work_item(AutoVacuumWorkItem *workitem);
 static void autovac_report_activity(autovac_table *tab);
 static void autovac_report_workitem(AutoVacuumWorkItem *workitem,
@@ -1936,11 +1950,12 @@ do_autovacuum(void)
 	Form_pg_database dbForm;
 	List	   *table_oids = NIL;
 	List	   *orphan_oids = NIL;
+	av_candidate *candidates;
+	int			ncandidates = 0;
+	int			maxcandidates = 64;
 	HASHCTL		ctl;
 	HTAB	   *table_toast_map;
 	ListCell   *volatile cell;
-	PgStat_StatDBEntry *shared;
-	PgStat_StatDBEntry *dbentry;
 	BufferAccessStrategy bstrategy;
 	ScanKeyData key;
 	TupleDesc	pg_class_desc;
@@ -1959,12 +1974,6 @@ do_autovacuum(void)
 										  ALLOCSET_DEFAULT_SIZES);
 	MemoryContextSwitchTo(AutovacMemCxt);
 
-	/*
-	 * may be NULL if we couldn't find an entry (only happens if we are
-	 * forcing a vacuum for anti-wrap purposes).
-	 */
-	dbentry = pgstat_fetch_stat_dbentry(MyDatabaseId);
-
 	/* Start a transaction so our commands have one to play into. */
 	StartTransactionCommand();
 
@@ -2012,9 +2021,6 @@ do_autovacuum(void)
 	/* StartTransactionCommand changed elsewhere */
 	MemoryContextSwitchTo(AutovacMemCxt);
 
-	/* The database hash where pgstat keeps shared relations */
-	shared = pgstat_fetch_stat_dbentry(InvalidOid);
-
 	classRel = heap_open(RelationRelationId, AccessShareLock);
 
 	/* create a copy so we can use it after closing pg_class */
@@ -2044,6 +2050,8 @@ do_autovacuum(void)
 	 * wide tables there might be proportionally much more activity in the
 	 * TOAST table than in its parent.
 	 */
+	candidates = (av_candidate *) palloc(maxcandidates * sizeof(av_candidate));
+
 	relScan = heap_beginscan_catalog(classRel, 0, NULL);
 
 	/*
@@ -2059,6 +2067,7 @@ do_autovacuum(void)
 		bool		dovacuum;
 		bool		doanalyze;
 		bool		wraparound;
+		double		score;
 
 		if (classForm->relkind != RELKIND_RELATION &&
 			classForm->relkind != RELKIND_MATVIEW)
@@ -2092,17 +2101,28 @@ do_autovacuum(void)
 
 		/* Fetch reloptions and the pgstat entry for this table */
 		relopts = extract_autovac_opts(tuple, pg_class_desc);
-		tabentry = get_pgstat_tabentry_relid(relid, classForm->relisshared,
-											 shared, dbentry);
+		tabentry = pgstat_fetch_stat_tabentry_extended(classForm->relisshared,
+													   relid);
 
 		/* Check if it needs vacuum or analyze */
 		relation_needs_vacanalyze(relid, relopts, classForm, tabentry,
 								  effective_multixact_freeze_max_age,
-								  &dovacuum, &doanalyze, &wraparound);
+								  &dovacuum, &doanalyze, &wraparound, &score);
 
-		/* Relations that need work are added to table_oids */
+		/* Relations that need work are added to the candidates */
 		if (dovacuum || doanalyze)
-			table_oids = lappend_oid(table_oids, relid);
+		{
+			if (ncandidates >= maxcandidates)
+			{
+				maxcandidates *= 2;
+				candidates = (av_candidate *)
+					repalloc(candidates, maxcandidates * sizeof(av_candidate));
+			}
+			candidates[ncandidates].ac_relid = relid;
+			candidates[ncandidates].ac_wraparound = wraparound;
+			candidates[ncandidates].ac_score = score;
+			ncandidates++;
+		}
 
 		/*
 		 * Remember TOAST associations for the second pass.  Note: we must do
@@ -2151,6 +2171,7 @@ do_autovacuum(void)
 		bool		dovacuum;
 		bool		doanalyze;
 		bool		wraparound;
+		double		score;
 
 		/*
 		 * We cannot safely process other backends' temp tables, so skip 'em.
@@ -2176,21 +2197,45 @@ do_autovacuum(void)
 		}
 
 		/* Fetch the pgstat entry for this table */
-		tabentry = get_pgstat_tabentry_relid(relid, classForm->relisshared,
-											 shared, dbentry);
+		tabentry = pgstat_fetch_stat_tabentry_extended(classForm->relisshared,
+													   relid);
 
 		relation_needs_vacanalyze(relid, relopts, classForm, tabentry,
 								  effective_multixact_freeze_max_age,
-								  &dovacuum, &doanalyze, &wraparound);
+								  &dovacuum, &doanalyze, &wraparound, &score);
 
 		/* ignore analyze for toast tables */
 		if (dovacuum)
-			table_oids = lappend_oid(table_oids, relid);
+		{
+			if (ncandidates >= maxcandidates)
+			{
+				maxcandidates *= 2;
+				candidates = (av_candidate *)
+					repalloc(candidates, maxcandidates * sizeof(av_candidate));
+			}
+			candidates[ncandidates].ac_relid = relid;
+			candidates[ncandidates].ac_wraparound = wraparound;
+			candidates[ncandidates].ac_score = score;
+			ncandidates++;
+		}
 	}
 
 	heap_endscan(relScan);
 	heap_close(classRel, AccessShareLock);
 
+	/*
+	 * Process the tables most in need of attention first: those that must be
+	 * vacuumed to prevent wraparound, then the others in decreasing order of
+	 * how far they are past their thresholds.  Otherwise a heavily bloated
+	 * table might have to wait for any number of tables that barely passed
+	 * theirs, just because they come first in pg_class.
+	 */
+	qsort(candidates, ncandidates, sizeof(av_candidate),
+		  av_candidate_comparator);
+	for (i = 0; i < ncandidates; i++)
+		table_oids = lappend_oid(table_oids, candidates[i].ac_relid);
+	pfree(candidates);
+
 	/*
 	 * Recheck orphan temporary tables, and if they still seem orphaned, drop
 	 * them.  We'll eat a transaction per dropped table, which might seem
@@ -2393,10 +2438,11 @@ do_autovacuum(void)
 		 * It could have changed if something else processed the table while
 		 * we weren't looking.
 		 *
-		 * Note: we have a special case in pgstat code to ensure that the
-		 * stats we read are as up-to-date as possible, to avoid the problem
-		 * that somebody just finished vacuuming this table.  The window to
-		 * the race condition is not closed but it is very small.
+		 * Note: table_recheck_autovac discards our pgstat snapshot, so the
+		 * stats we read come straight from shared memory and are as
+		 * up-to-date as possible, to avoid the problem that somebody just
+		 * finished vacuuming this table.  The window to the race condition
+		 * is not closed but it is very small.
 		 */
 		MemoryContextSwitchTo(AutovacMemCxt);
 		tab = table_recheck_autovac(relid, table_toast_map, pg_class_desc,
@@ -2658,6 +2704,10 @@ perform_work_item(AutoVacuumWorkItem *workitem)
 									ObjectIdGetDatum(workitem->avw_relation),
 									Int64GetDatum((int64) workitem->avw_blockNumber));
 				break;
+			case AVW_GINCleanPendingList:
+				DirectFunctionCall1(gin_clean_pending_list,
+									ObjectIdGetDatum(workitem->avw_relation));
+				break;
 			default:
 				elog(WARNING, "unrecognized work item found: type %d",
 					 workitem->avw_type);
@@ -2736,30 +2786,6 @@ extract_autovac_opts(HeapTuple tup, TupleDesc pg_class_desc)
 	return av;
 }
 
-/*
- * get_pgstat_tabentry_relid
- *
- * Fetch the pgstat entry of a table, either local to a database or shared.
- */
-static PgStat_StatTabEntry *
-get_pgstat_tabentry_relid(Oid relid, bool isshared, PgStat_StatDBEntry *shared,
-						  PgStat_StatDBEntry *dbentry)
-{
-	PgStat_StatTabEntry *tabentry = NULL;
-
-	if (isshared)
-	{
-		if (PointerIsValid(shared))
-			tabentry = hash_search(shared->tables, &relid,
-								   HASH_FIND, NULL);
-	}
-	else if (PointerIsValid(dbentry))
-		tabentry = hash_search(dbentry->tables, &relid,
-							   HASH_FIND, NULL);
-
-	return tabentry;
-}
-
 /*
  * table_recheck_autovac
  *
@@ -2779,17 +2805,13 @@ table_recheck_autovac(Oid relid, HTAB *table_toast_map,
 	bool		doanalyze;
 	autovac_table *tab = NULL;
 	PgStat_StatTabEntry *tabentry;
-	PgStat_StatDBEntry *shared;
-	PgStat_StatDBEntry *dbentry;
 	bool		wraparound;
+	double		score;
 	AutoVacOpts *avopts;
 
 	/* use fresh stats */
 	autovac_refresh_stats();
 
-	shared = pgstat_fetch_stat_dbentry(InvalidOid);
-	dbentry = pgstat_fetch_stat_dbentry(MyDatabaseId);
-
 	/* fetch the relation's relcache entry */
 	classTup = SearchSysCacheCopy1(RELOID, ObjectIdGetDatum(relid));
 	if (!HeapTupleIsValid(classTup))
@@ -2813,12 +2835,12 @@ table_recheck_autovac(Oid relid, HTAB *table_toast_map,
 	}
 
 	/* fetch the pgstat table entry */
-	tabentry = get_pgstat_tabentry_relid(relid, classForm->relisshared,
-										 shared, dbentry);
+	tabentry = pgstat_fetch_stat_tabentry_extended(classForm->relisshared,
+												   relid);
 
 	relation_needs_vacanalyze(relid, avopts, classForm, tabentry,
 							  effective_multixact_freeze_max_age,
-							  &dovacuum, &doanalyze, &wraparound);
+							  &dovacuum, &doanalyze, &wraparound, &score);
 
 	/* ignore ANALYZE for toast tables */
 	if (classForm->relkind == RELKIND_TOASTVALUE)
@@ -2893,6 +2915,9 @@ table_recheck_autovac(Oid relid, HTAB *table_toast_map,
 		tab->at_params.multixact_freeze_table_age = multixact_freeze_table_age;
 		tab->at_params.is_wraparound = wraparound;
 		tab->at_params.log_min_duration = log_min_duration;
+		/* autovacuum never vacuums indexes in parallel */
+		tab->at_params.nworkers = 0;
+		tab->at_params.index_cleanup = VACOPT_TERNARY_DEFAULT;
 		tab->at_vacuum_cost_limit = vac_cost_limit;
 		tab->at_vacuum_cost_delay = vac_cost_delay;
 		tab->at_relname = NULL;
@@ -2906,6 +2931,17 @@ table_recheck_autovac(Oid relid, HTAB *table_toast_map,
 		tab->at_dobalance =
 			!(avopts && (avopts->vacuum_cost_limit > 0 ||
 						 avopts->vacuum_cost_delay > 0));
+
+		/*
+		 * A table that's getting dangerously close to wraparound is vacuumed
+		 * at full speed, leaving the other workers' share of the cost limit
+		 * to them.
+		 */
+		if (wraparound && relation_needs_failsafe(classForm))
+		{
+			tab->at_vacuum_cost_delay = 0;
+			tab->at_dobalance = false;
+		}
 	}
 
 	heap_freetuple(classTup);
@@ -2930,6 +2966,12 @@ table_recheck_autovac(Oid relid, HTAB *table_toast_map,
  *
  * threshold = vac_base_thresh + vac_scale_factor * reltuples
  *
+ * or if the number of tuples inserted since the last vacuum exceeds a
+ * threshold computed the same way from vac_ins_base_thresh and
+ * vac_ins_scale_factor.  The latter makes sure that insert-mostly tables get
+ * their pages marked all-visible and frozen a bit at a time, rather than in
+ * one go by an anti-wraparound vacuum.
+ *
  * For analyze, the analysis done is that the number of tuples inserted,
  * deleted and updated since the last analyze exceeds a threshold calculated
  * in the same fashion as above.  Note that the collector actually stores
@@ -2948,7 +2990,15 @@ table_recheck_autovac(Oid relid, HTAB *table_toast_map,
  * A table whose vac_base_thresh value is < 0 takes the base value from the
  * autovacuum_vacuum_threshold GUC variable.  Similarly, a vac_scale_factor
  * value < 0 is substituted with the value of
- * autovacuum_vacuum_scale_factor GUC variable.  Ditto for analyze.
+ * autovacuum_vacuum_scale_factor GUC variable.  Ditto for analyze.  For the
+ * insert threshold, -1 is a valid value that disables insert vacuums, so
+ * only values < -1 are substituted with autovacuum_vacuum_insert_threshold.
+ *
+ * *score is set to a measure of how urgently the table needs attention: the
+ * largest of the ratios between each of the counts above and its threshold,
+ * and between the table's relfrozenxid and relminmxid ages and their
+ * freeze_max_age limits.  A table that needs nothing done gets a score of at
+ * most 1.
  */
 static void
 relation_needs_vacanalyze(Oid relid,
@@ -2959,7 +3009,8 @@ relation_needs_vacanalyze(Oid relid,
  /* output params below */
 						  bool *dovacuum,
 						  bool *doanalyze,
-						  bool *wraparound)
+						  bool *wraparound,
+						  double *score)
 {
 	bool		force_vacuum;
 	bool		av_enabled;
@@ -2967,16 +3018,20 @@ relation_needs_vacanalyze(Oid relid,
 
 	/* constants from reloptions or GUC variables */
 	int			vac_base_thresh,
+				vac_ins_base_thresh,
 				anl_base_thresh;
 	float4		vac_scale_factor,
+				vac_ins_scale_factor,
 				anl_scale_factor;
 
 	/* thresholds calculated from above constants */
 	float4		vacthresh,
+				vacinsthresh,
 				anlthresh;
 
 	/* number of vacuum (resp. analyze) tuples at this time */
 	float4		vactuples,
+				instuples,
 				anltuples;
 
 	/* freeze parameters */
@@ -3003,6 +3058,15 @@ relation_needs_vacanalyze(Oid relid,
 		? relopts->vacuum_threshold
 		: autovacuum_vac_thresh;
 
+	vac_ins_scale_factor = (relopts && relopts->vacuum_ins_scale_factor >= 0)
+		? relopts->vacuum_ins_scale_factor
+		: autovacuum_vac_ins_scale;
+
+	/* -1 is used to disable insert vacuums */
+	vac_ins_base_thresh = (relopts && relopts->vacuum_ins_threshold >= -1)
+		? relopts->vacuum_ins_threshold
+		: autovacuum_vac_ins_thresh;
+
 	anl_scale_factor = (relopts && relopts->analyze_scale_factor >= 0)
 		? relopts->analyze_scale_factor
 		: autovacuum_anl_scale;
@@ -3038,6 +3102,15 @@ relation_needs_vacanalyze(Oid relid,
 	}
 	*wraparound = force_vacuum;
 
+	*score = 0;
+	if (TransactionIdIsNormal(classForm->relfrozenxid))
+		*score = (double) (recentXid - classForm->relfrozenxid) /
+			freeze_max_age;
+	if (MultiXactIdIsValid(classForm->relminmxid))
+		*score = Max(*score,
+					 (double) (recentMulti - classForm->relminmxid) /
+					 Max(multixact_freeze_max_age, 1));
+
 	/* User disabled it in pg_class.reloptions?  (But ignore if at risk) */
 	if (!av_enabled && !force_vacuum)
 	{
@@ -3057,9 +3130,11 @@ relation_needs_vacanalyze(Oid relid,
 	{
 		reltuples = classForm->reltuples;
 		vactuples = tabentry->n_dead_tuples;
+		instuples = tabentry->inserts_since_vacuum;
 		anltuples = tabentry->changes_since_analyze;
 
 		vacthresh = (float4) vac_base_thresh + vac_scale_factor * reltuples;
+		vacinsthresh = (float4) vac_ins_base_thresh + vac_ins_scale_factor * reltuples;
 		anlthresh = (float4) anl_base_thresh + anl_scale_factor * reltuples;
 
 		/*
@@ -3067,13 +3142,25 @@ relation_needs_vacanalyze(Oid relid,
 		 * reset, because if that happens, the last vacuum and analyze counts
 		 * will be reset too.
 		 */
-		elog(DEBUG3, "%s: vac: %.0f (threshold %.0f), anl: %.0f (threshold %.0f)",
-			 NameStr(classForm->relname),
-			 vactuples, vacthresh, anltuples, anlthresh);
+		if (vac_ins_base_thresh >= 0)
+			elog(DEBUG3, "%s: vac: %.0f (threshold %.0f), ins: %.0f (threshold %.0f), anl: %.0f (threshold %.0f)",
+				 NameStr(classForm->relname),
+				 vactuples, vacthresh, instuples, vacinsthresh, anltuples, anlthresh);
+		else
+			elog(DEBUG3, "%s: vac: %.0f (threshold %.0f), ins: (disabled), anl: %.0f (threshold %.0f)",
+				 NameStr(classForm->relname),
+				 vactuples, vacthresh, anltuples, anlthresh);
 
 		/* Determine if this table needs vacuum or analyze. */
-		*dovacuum = force_vacuum || (vactuples > vacthresh);
+		*dovacuum = force_vacuum || (vactuples > vacthresh) ||
+			(vac_ins_base_thresh >= 0 && instuples > vacinsthresh);
 		*doanalyze = (anltuples > anlthresh);
+
+		*score = Max(*score, vactuples / Max(vacthresh, 1));
+		if (vac_ins_base_thresh >= 0)
+			*score = Max(*score, instuples / Max(vacinsthresh, 1));
+		if (*doanalyze)
+			*score = Max(*score, anltuples / Max(anlthresh, 1));
 	}
 	else
 	{
@@ -3091,6 +3178,40 @@ relation_needs_vacanalyze(Oid relid,
 		*doanalyze = false;
 }
 
+/*
+ * relation_needs_failsafe
+ *
+ * Is the table's relfrozenxid or relminmxid older than autovacuum_failsafe_age?
+ */
+static bool
+relation_needs_failsafe(Form_pg_class classForm)
+{
+	if (TransactionIdIsNormal(classForm->relfrozenxid) &&
+		recentXid - classForm->relfrozenxid > (uint32) autovacuum_failsafe_age)
+		return true;
+	if (MultiXactIdIsValid(classForm->relminmxid) &&
+		recentMulti - classForm->relminmxid > (uint32) autovacuum_failsafe_age)
+		return true;
+	return false;
+}
+
+/*
+ * qsort comparator for av_candidate: wraparound first, then by descending
+ * score
+ */
+static int
+av_candidate_comparator(const void *a, const void *b)
+{
+	const av_candidate *ca = (const av_candidate *) a;
+	const av_candidate *cb = (const av_candidate *) b;
+
+	if (ca->ac_wraparound != cb->ac_wraparound)
+		return ca->ac_wraparound ? -1 : 1;
+	if (ca->ac_score != cb->ac_score)
+		return (ca->ac_score > cb->ac_score) ? -1 : 1;
+	return 0;
+}
+
 /*
  * autovacuum_do_vac_analyze
  *		Vacuum and/or analyze the specified table
@@ -3173,6 +3294,10 @@ autovac_report_workitem(AutoVacuumWorkItem *workitem,
 			snprintf(activity, MAX_AUTOVAC_ACTIV_LEN,
 					 "autovacuum: BRIN summarize");
 			break;
+		case AVW_GINCleanPendingList:
+			snprintf(activity, MAX_AUTOVAC_ACTIV_LEN,
+					 "autovacuum: GIN pending list cleanup");
+			break;
 	}
 
 	/*
@@ -3345,8 +3470,8 @@ AutoVacuumShmemInit(void)
  *
  * Cause the next pgstats read operation to obtain fresh data, but throttle
  * such refreshing in the autovacuum launcher.  This is mostly to avoid
- * rereading the pgstats files too many times in quick succession when there
- * are many databases.
+ * copying the shared pgstats entries too many times in quick succession
+ * when there are many databases.
  *
  * Note: we avoid throttling in the autovac worker, as it would be
  * counterproductive in the recheck logic.
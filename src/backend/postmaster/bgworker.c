@@ -16,10 +16,12 @@
 
 #include "libpq/pqsignal.h"
 #include "access/parallel.h"
+#include "access/xlogworker.h"
 #include "miscadmin.h"
 #include "pgstat.h"
 #include "port/atomics.h"
 #include "postmaster/bgworker_internals.h"
+#include "postmaster/ckptwriter.h"
 #include "postmaster/postmaster.h"
 #include "replication/logicallauncher.h"
 #include "replication/logicalworker.h"
@@ -129,6 +131,15 @@ static const struct
 	},
 	{
 		"ApplyWorkerMain", ApplyWorkerMain
+	},
+	{
+		"CkptWriterMain", CkptWriterMain
+	},
+	{
+		"RecoveryWorkerMain", RecoveryWorkerMain
+	},
+	{
+		"ParallelApplyWorkerMain", ParallelApplyWorkerMain
 	}
 };
 
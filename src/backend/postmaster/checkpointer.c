@@ -42,6 +42,7 @@
 #include <unistd.h>
 
 #include "access/xlog.h"
+#include "access/hash.h"
 #include "access/xlog_internal.h"
 #include "libpq/pqsignal.h"
 #include "miscadmin.h"
@@ -52,6 +53,7 @@
 #include "storage/condition_variable.h"
 #include "storage/fd.h"
 #include "storage/ipc.h"
+#include "storage/lockstats.h"
 #include "storage/lwlock.h"
 #include "storage/proc.h"
 #include "storage/shmem.h"
@@ -99,11 +101,27 @@
  * counts the subset of those writes that also had to do their own fsync,
  * because the checkpointer failed to absorb their request.
  *
- * The requests array holds fsync requests sent by backends and not yet
- * absorbed by the checkpointer.
+ * Fsync requests sent by backends and not yet absorbed by the checkpointer
+ * are kept in two places.  Requests to fsync a segment, which are by far the
+ * most common kind, go into a hash table that is split into
+ * NUM_FSYNC_REQUEST_PARTITIONS partitions, each with its own lock, so that
+ * backends writing out buffers concurrently rarely wait for each other, and
+ * a repeated request for the same segment just updates the existing entry.
+ * The "control" requests that md.c encodes with special segno values
+ * (forget and unlink requests) must be processed in order, so they go into
+ * the requests array instead, which is protected by CheckpointerCommLock.
  *
- * Unlike the checkpoint fields, num_backend_writes, num_backend_fsync, and
- * the requests fields are protected by CheckpointerCommLock.
+ * To absorb the requests in the order they were made, each request carries
+ * a sequence number: a control request gets the value of control_seq, which
+ * is then advanced, and an fsync request is stamped with the current value
+ * of control_seq, read while holding the partition lock.  An fsync request
+ * stamped with a value <= that of a control request was made before it.
+ * The checkpointer empties the requests array before the partitions, so it
+ * never absorbs a control request without also absorbing every fsync
+ * request that preceded it.
+ *
+ * num_backend_writes, num_backend_fsync and control_seq are atomics, so
+ * that they can be maintained without taking any lock.
  *----------
  */
 typedef struct
@@ -114,6 +132,40 @@ typedef struct
 	/* might add a real request-type field later; not needed yet */
 } CheckpointerRequest;
 
+typedef struct
+{
+	CheckpointerRequest request;	/* must be first */
+	uint64		seq;			/* sequence number, see above */
+	int			slot;			/* hash slot pointing to this entry */
+} FsyncRequestEntry;
+
+/* Number of partitions of the fsync request hash table */
+#define NUM_FSYNC_REQUEST_PARTITIONS	16
+
+/*
+ * Each partition holds up to fsync_partition_size entries, densely packed in
+ * its part of FsyncRequestEntries, and twice as many hash slots in its part of
+ * FsyncRequestSlots, which are indexes into the entries (-1 if unused) and
+ * are searched by linear probing.
+ */
+typedef struct
+{
+	LWLock		lock;			/* protects the partition's entries and slots */
+	int			nused;			/* # of entries in use */
+} FsyncRequestPartitionData;
+
+typedef union
+{
+	FsyncRequestPartitionData data;
+	char		pad[PG_CACHE_LINE_SIZE];	/* avoid false sharing */
+} FsyncRequestPartition;
+
+/* Control requests are rare, so a small queue suffices for them */
+#define MAX_CONTROL_REQUESTS	8192
+
+/* Largest number of pending fsync requests we make room for */
+#define MAX_FSYNC_REQUESTS		(1024 * 1024)
+
 typedef struct
 {
 	pid_t		checkpointer_pid;	/* PID (0 if not started) */
@@ -126,15 +178,27 @@ typedef struct
 
 	int			ckpt_flags;		/* checkpoint flags, as defined in xlog.h */
 
-	uint32		num_backend_writes; /* counts user backend buffer writes */
-	uint32		num_backend_fsync;	/* counts user backend fsync calls */
+	pg_atomic_uint32 num_backend_writes;	/* counts user backend buffer
+											 * writes */
+	pg_atomic_uint32 num_backend_fsync; /* counts user backend fsync calls */
+
+	pg_atomic_uint64 control_seq;	/* next control request's seq */
 
-	int			num_requests;	/* current # of requests */
+	FsyncRequestPartition partitions[NUM_FSYNC_REQUEST_PARTITIONS];
+
+	int			num_requests;	/* current # of control requests */
 	int			max_requests;	/* allocated array size */
-	CheckpointerRequest requests[FLEXIBLE_ARRAY_MEMBER];
+	FsyncRequestEntry requests[FLEXIBLE_ARRAY_MEMBER];
 } CheckpointerShmemStruct;
 
 static CheckpointerShmemStruct *CheckpointerShmem;
+static FsyncRequestEntry *FsyncRequestEntries;
+static int *FsyncRequestSlots;
+static int	fsync_partition_size;
+
+/* checkpointer-local copies of requests being absorbed */
+static FsyncRequestEntry *absorbed_control;
+static FsyncRequestEntry *absorbed_fsync;
 
 /* interval for calling AbsorbFsyncRequests in CheckpointWriteDelay */
 #define WRITES_PER_ABSORB		1000
@@ -171,7 +235,11 @@ static pg_time_t last_xlog_switch_time;
 static void CheckArchiveTimeout(void);
 static bool IsCheckpointOnSchedule(double progress);
 static bool ImmediateCheckpointRequested(void);
-static bool CompactCheckpointerRequestQueue(void);
+static int	FsyncPartitionSize(void);
+static int	ControlQueueSize(void);
+static bool ForwardControlRequest(RelFileNode rnode, ForkNumber forknum,
+					  BlockNumber segno);
+static int	fsync_request_seq_cmp(const void *a, const void *b);
 static void UpdateSharedMemoryConfig(void);
 
 /* Signal handlers */
@@ -382,6 +450,9 @@ CheckpointerMain(void)
 			ExitOnAnyError = true;
 			/* Close down the database */
 			ShutdownXLOG(0, 0);
+			/* Write out the statistics now that nothing else reports them */
+			pgstat_send_bgwriter();
+			pgstat_before_server_shutdown(0, 0);
 			/* Normal exit from the checkpointer is here */
 			proc_exit(0);		/* done */
 		}
@@ -522,6 +593,7 @@ CheckpointerMain(void)
 		 * stats message types.)
 		 */
 		pgstat_send_bgwriter();
+		LockStatsFlush(false);
 
 		/*
 		 * Sleep until we are signaled or it's time for another checkpoint or
@@ -880,16 +952,43 @@ CheckpointerShmemSize(void)
 {
 	Size		size;
 
-	/*
-	 * Currently, the size of the requests[] array is arbitrarily set equal to
-	 * NBuffers.  This may prove too large or small ...
-	 */
 	size = offsetof(CheckpointerShmemStruct, requests);
-	size = add_size(size, mul_size(NBuffers, sizeof(CheckpointerRequest)));
+	size = add_size(size, mul_size(ControlQueueSize(),
+								   sizeof(FsyncRequestEntry)));
+	size = MAXALIGN(size);
+	size = add_size(size, mul_size(mul_size(NUM_FSYNC_REQUEST_PARTITIONS,
+											FsyncPartitionSize()),
+								   sizeof(FsyncRequestEntry) + 2 * sizeof(int)));
 
 	return size;
 }
 
+/*
+ * Number of fsync requests each partition of the hash table can hold.
+ *
+ * In total, we make room for as many requests as there are shared buffers,
+ * which is enough for every buffer to have been written out to a different
+ * segment.  Past MAX_FSYNC_REQUESTS that is absurd, since that many segments
+ * are a petabyte of data.
+ */
+static int
+FsyncPartitionSize(void)
+{
+	int			nrequests = Min(Max(NBuffers, 1024), MAX_FSYNC_REQUESTS);
+
+	return (nrequests + NUM_FSYNC_REQUEST_PARTITIONS - 1) /
+		NUM_FSYNC_REQUEST_PARTITIONS;
+}
+
+/*
+ * Number of control requests the requests array can hold.
+ */
+static int
+ControlQueueSize(void)
+{
+	return Min(NBuffers, MAX_CONTROL_REQUESTS);
+}
+
 /*
  * CheckpointerShmemInit
  *		Allocate and initialize checkpointer-related shared memory
@@ -898,6 +997,8 @@ void
 CheckpointerShmemInit(void)
 {
 	Size		size = CheckpointerShmemSize();
+	Size		offset;
+	int			nentries;
 	bool		found;
 
 	CheckpointerShmem = (CheckpointerShmemStruct *)
@@ -905,16 +1006,36 @@ CheckpointerShmemInit(void)
 						size,
 						&found);
 
+	fsync_partition_size = FsyncPartitionSize();
+	nentries = NUM_FSYNC_REQUEST_PARTITIONS * fsync_partition_size;
+
+	offset = offsetof(CheckpointerShmemStruct, requests) +
+		ControlQueueSize() * sizeof(FsyncRequestEntry);
+	offset = MAXALIGN(offset);
+	FsyncRequestEntries = (FsyncRequestEntry *)
+		((char *) CheckpointerShmem + offset);
+	FsyncRequestSlots = (int *) (FsyncRequestEntries + nentries);
+
 	if (!found)
 	{
+		int			i;
+
 		/*
 		 * First time through, so initialize.  Note that we zero the whole
-		 * requests array; this is so that CompactCheckpointerRequestQueue can
-		 * assume that any pad bytes in the request structs are zeroes.
+		 * thing, including any pad bytes in the request structs, which the
+		 * hash table relies on since it compares requests as blobs.
 		 */
 		MemSet(CheckpointerShmem, 0, size);
 		SpinLockInit(&CheckpointerShmem->ckpt_lck);
-		CheckpointerShmem->max_requests = NBuffers;
+		pg_atomic_init_u32(&CheckpointerShmem->num_backend_writes, 0);
+		pg_atomic_init_u32(&CheckpointerShmem->num_backend_fsync, 0);
+		pg_atomic_init_u64(&CheckpointerShmem->control_seq, 0);
+		for (i = 0; i < NUM_FSYNC_REQUEST_PARTITIONS; i++)
+			LWLockInitialize(&CheckpointerShmem->partitions[i].data.lock,
+							 LWTRANCHE_FSYNC_REQUEST);
+		for (i = 0; i < 2 * nentries; i++)
+			FsyncRequestSlots[i] = -1;
+		CheckpointerShmem->max_requests = ControlQueueSize();
 	}
 }
 
@@ -1081,20 +1202,24 @@ RequestCheckpoint(int flags)
  * use high values for special flags; that's all internal to md.c, which
  * see for details.)
  *
- * To avoid holding the lock for longer than necessary, we normally write
- * to the requests[] queue without checking for duplicates.  The checkpointer
- * will have to eliminate dups internally anyway.  However, if we discover
- * that the queue is full, we make a pass over the entire queue to compact
- * it.  This is somewhat expensive, but the alternative is for the backend
- * to perform its own fsync, which is far more expensive in practice.  It
- * is theoretically possible a backend fsync might still be necessary, if
- * the queue is full and contains no duplicate entries.  In that case, we
- * let the backend know by returning false.
+ * Requests to fsync a segment are entered into the partitioned hash table,
+ * so a backend only has to lock the partition its request falls into, and
+ * a request that is already pending costs no extra space.  If that
+ * partition is full, we let the backend know by returning false, and it will
+ * have to perform its own fsync.  Control requests go into the requests[]
+ * queue; if that is full, we also return false, and the caller is expected
+ * to retry after a while.
  */
 bool
 ForwardFsyncRequest(RelFileNode rnode, ForkNumber forknum, BlockNumber segno)
 {
-	CheckpointerRequest *request;
+	CheckpointerRequest request;
+	FsyncRequestPartitionData *partition;
+	FsyncRequestEntry *entries;
+	int		   *slots;
+	uint32		hashcode;
+	int			nslots;
+	int			slot;
 	bool		too_full;
 
 	if (!IsUnderPostmaster)
@@ -1103,42 +1228,80 @@ ForwardFsyncRequest(RelFileNode rnode, ForkNumber forknum, BlockNumber segno)
 	if (AmCheckpointerProcess())
 		elog(ERROR, "ForwardFsyncRequest must not be called in checkpointer");
 
-	LWLockAcquire(CheckpointerCommLock, LW_EXCLUSIVE);
+	/*
+	 * The special segno values md.c uses for control requests are all far
+	 * above any real segment number.
+	 */
+	if (segno > MaxBlockNumber / RELSEG_SIZE)
+		return ForwardControlRequest(rnode, forknum, segno);
 
 	/* Count all backend writes regardless of if they fit in the queue */
 	if (!AmBackgroundWriterProcess())
-		CheckpointerShmem->num_backend_writes++;
+		pg_atomic_fetch_add_u32(&CheckpointerShmem->num_backend_writes, 1);
 
-	/*
-	 * If the checkpointer isn't running or the request queue is full, the
-	 * backend will have to perform its own fsync request.  But before forcing
-	 * that to happen, we can try to compact the request queue.
-	 */
-	if (CheckpointerShmem->checkpointer_pid == 0 ||
-		(CheckpointerShmem->num_requests >= CheckpointerShmem->max_requests &&
-		 !CompactCheckpointerRequestQueue()))
+	/* If the checkpointer isn't running, the backend must fsync itself */
+	if (CheckpointerShmem->checkpointer_pid == 0)
 	{
-		/*
-		 * Count the subset of writes where backends have to do their own
-		 * fsync
-		 */
 		if (!AmBackgroundWriterProcess())
-			CheckpointerShmem->num_backend_fsync++;
-		LWLockRelease(CheckpointerCommLock);
+			pg_atomic_fetch_add_u32(&CheckpointerShmem->num_backend_fsync, 1);
 		return false;
 	}
 
-	/* OK, insert request */
-	request = &CheckpointerShmem->requests[CheckpointerShmem->num_requests++];
-	request->rnode = rnode;
-	request->forknum = forknum;
-	request->segno = segno;
+	/* Request structs are hashed and compared as blobs, so zero padding */
+	MemSet(&request, 0, sizeof(request));
+	request.rnode = rnode;
+	request.forknum = forknum;
+	request.segno = segno;
 
-	/* If queue is more than half full, nudge the checkpointer to empty it */
-	too_full = (CheckpointerShmem->num_requests >=
-				CheckpointerShmem->max_requests / 2);
+	hashcode = DatumGetUInt32(hash_any((const unsigned char *) &request,
+									   sizeof(request)));
+	partition = &CheckpointerShmem->partitions[hashcode % NUM_FSYNC_REQUEST_PARTITIONS].data;
+	entries = FsyncRequestEntries +
+		(hashcode % NUM_FSYNC_REQUEST_PARTITIONS) * fsync_partition_size;
+	nslots = 2 * fsync_partition_size;
+	slots = FsyncRequestSlots +
+		(hashcode % NUM_FSYNC_REQUEST_PARTITIONS) * nslots;
 
-	LWLockRelease(CheckpointerCommLock);
+	LWLockAcquire(&partition->lock, LW_EXCLUSIVE);
+
+	/*
+	 * There are twice as many slots as entries, so the probe loop always
+	 * finds either our request or a free slot.
+	 */
+	slot = (hashcode / NUM_FSYNC_REQUEST_PARTITIONS) % nslots;
+	while (slots[slot] >= 0 &&
+		   memcmp(&entries[slots[slot]].request, &request,
+				  sizeof(request)) != 0)
+		slot = (slot + 1) % nslots;
+
+	if (slots[slot] < 0)
+	{
+		FsyncRequestEntry *entry;
+
+		if (partition->nused >= fsync_partition_size)
+		{
+			LWLockRelease(&partition->lock);
+			if (!AmBackgroundWriterProcess())
+				pg_atomic_fetch_add_u32(&CheckpointerShmem->num_backend_fsync, 1);
+			return false;
+		}
+
+		entry = &entries[partition->nused];
+		entry->request = request;
+		entry->slot = slot;
+		slots[slot] = partition->nused++;
+	}
+
+	/*
+	 * Stamp the request, whether new or not, so that it sorts after any
+	 * control request already made; see AbsorbFsyncRequests.
+	 */
+	entries[slots[slot]].seq = pg_atomic_read_u64(&CheckpointerShmem->control_seq);
+
+	/* If partition is more than half full, nudge the checkpointer to empty it */
+	too_full = (partition->nused >= fsync_partition_size / 2);
+
+	LWLockRelease(&partition->lock);
 
 	/* ... but not till after we release the lock */
 	if (too_full && ProcGlobal->checkpointerLatch)
@@ -1148,117 +1311,44 @@ ForwardFsyncRequest(RelFileNode rnode, ForkNumber forknum, BlockNumber segno)
 }
 
 /*
- * CompactCheckpointerRequestQueue
- *		Remove duplicates from the request queue to avoid backend fsyncs.
- *		Returns "true" if any entries were removed.
+ * ForwardControlRequest
+ *		Enter a control request into the requests[] queue.
  *
- * Although a full fsync request queue is not common, it can lead to severe
- * performance problems when it does happen.  So far, this situation has
- * only been observed to occur when the system is under heavy write load,
- * and especially during the "sync" phase of a checkpoint.  Without this
- * logic, each backend begins doing an fsync for every block written, which
- * gets very expensive and can slow down the whole system.
- *
- * Trying to do this every time the queue is full could lose if there
- * aren't any removable entries.  But that should be vanishingly rare in
- * practice: there's one queue entry per shared buffer.
+ * Returns false if the checkpointer isn't running or the queue is full.
  */
 static bool
-CompactCheckpointerRequestQueue(void)
+ForwardControlRequest(RelFileNode rnode, ForkNumber forknum,
+					  BlockNumber segno)
 {
-	struct CheckpointerSlotMapping
-	{
-		CheckpointerRequest request;
-		int			slot;
-	};
-
-	int			n,
-				preserve_count;
-	int			num_skipped = 0;
-	HASHCTL		ctl;
-	HTAB	   *htab;
-	bool	   *skip_slot;
-
-	/* must hold CheckpointerCommLock in exclusive mode */
-	Assert(LWLockHeldByMe(CheckpointerCommLock));
-
-	/* Initialize skip_slot array */
-	skip_slot = palloc0(sizeof(bool) * CheckpointerShmem->num_requests);
-
-	/* Initialize temporary hash table */
-	MemSet(&ctl, 0, sizeof(ctl));
-	ctl.keysize = sizeof(CheckpointerRequest);
-	ctl.entrysize = sizeof(struct CheckpointerSlotMapping);
-	ctl.hcxt = CurrentMemoryContext;
-
-	htab = hash_create("CompactCheckpointerRequestQueue",
-					   CheckpointerShmem->num_requests,
-					   &ctl,
-					   HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
-
-	/*
-	 * The basic idea here is that a request can be skipped if it's followed
-	 * by a later, identical request.  It might seem more sensible to work
-	 * backwards from the end of the queue and check whether a request is
-	 * *preceded* by an earlier, identical request, in the hopes of doing less
-	 * copying.  But that might change the semantics, if there's an
-	 * intervening FORGET_RELATION_FSYNC or FORGET_DATABASE_FSYNC request, so
-	 * we do it this way.  It would be possible to be even smarter if we made
-	 * the code below understand the specific semantics of such requests (it
-	 * could blow away preceding entries that would end up being canceled
-	 * anyhow), but it's not clear that the extra complexity would buy us
-	 * anything.
-	 */
-	for (n = 0; n < CheckpointerShmem->num_requests; n++)
-	{
-		CheckpointerRequest *request;
-		struct CheckpointerSlotMapping *slotmap;
-		bool		found;
-
-		/*
-		 * We use the request struct directly as a hashtable key.  This
-		 * assumes that any padding bytes in the structs are consistently the
-		 * same, which should be okay because we zeroed them in
-		 * CheckpointerShmemInit.  Note also that RelFileNode had better
-		 * contain no pad bytes.
-		 */
-		request = &CheckpointerShmem->requests[n];
-		slotmap = hash_search(htab, request, HASH_ENTER, &found);
-		if (found)
-		{
-			/* Duplicate, so mark the previous occurrence as skippable */
-			skip_slot[slotmap->slot] = true;
-			num_skipped++;
-		}
-		/* Remember slot containing latest occurrence of this request value */
-		slotmap->slot = n;
-	}
+	FsyncRequestEntry *entry;
+	bool		too_full;
 
-	/* Done with the hash table. */
-	hash_destroy(htab);
+	LWLockAcquire(CheckpointerCommLock, LW_EXCLUSIVE);
 
-	/* If no duplicates, we're out of luck. */
-	if (!num_skipped)
+	if (CheckpointerShmem->checkpointer_pid == 0 ||
+		CheckpointerShmem->num_requests >= CheckpointerShmem->max_requests)
 	{
-		pfree(skip_slot);
+		LWLockRelease(CheckpointerCommLock);
 		return false;
 	}
 
-	/* We found some duplicates; remove them. */
-	preserve_count = 0;
-	for (n = 0; n < CheckpointerShmem->num_requests; n++)
-	{
-		if (skip_slot[n])
-			continue;
-		CheckpointerShmem->requests[preserve_count++] = CheckpointerShmem->requests[n];
-	}
-	ereport(DEBUG1,
-			(errmsg("compacted fsync request queue from %d entries to %d entries",
-					CheckpointerShmem->num_requests, preserve_count)));
-	CheckpointerShmem->num_requests = preserve_count;
+	/* OK, insert request */
+	entry = &CheckpointerShmem->requests[CheckpointerShmem->num_requests++];
+	entry->request.rnode = rnode;
+	entry->request.forknum = forknum;
+	entry->request.segno = segno;
+	entry->seq = pg_atomic_fetch_add_u64(&CheckpointerShmem->control_seq, 1);
+
+	/* If queue is more than half full, nudge the checkpointer to empty it */
+	too_full = (CheckpointerShmem->num_requests >=
+				CheckpointerShmem->max_requests / 2);
+
+	LWLockRelease(CheckpointerCommLock);
+
+	/* ... but not till after we release the lock */
+	if (too_full && ProcGlobal->checkpointerLatch)
+		SetLatch(ProcGlobal->checkpointerLatch);
 
-	/* Cleanup. */
-	pfree(skip_slot);
 	return true;
 }
 
@@ -1274,38 +1364,55 @@ CompactCheckpointerRequestQueue(void)
 void
 AbsorbFsyncRequests(void)
 {
-	CheckpointerRequest *requests = NULL;
-	CheckpointerRequest *request;
-	int			n;
+	int			ncontrol;
+	int			nfsync;
+	int			i;
+	int			j;
 
 	if (!AmCheckpointerProcess())
 		return;
 
-	LWLockAcquire(CheckpointerCommLock, LW_EXCLUSIVE);
-
 	/* Transfer stats counts into pending pgstats message */
-	BgWriterStats.m_buf_written_backend += CheckpointerShmem->num_backend_writes;
-	BgWriterStats.m_buf_fsync_backend += CheckpointerShmem->num_backend_fsync;
+	BgWriterStats.m_buf_written_backend +=
+		pg_atomic_exchange_u32(&CheckpointerShmem->num_backend_writes, 0);
+	BgWriterStats.m_buf_fsync_backend +=
+		pg_atomic_exchange_u32(&CheckpointerShmem->num_backend_fsync, 0);
 
-	CheckpointerShmem->num_backend_writes = 0;
-	CheckpointerShmem->num_backend_fsync = 0;
+	/*
+	 * We can't palloc once the requests are gone from shared memory, so set
+	 * up room for as many as there can be beforehand.
+	 */
+	if (absorbed_control == NULL)
+	{
+		absorbed_control = (FsyncRequestEntry *)
+			MemoryContextAlloc(TopMemoryContext,
+							   CheckpointerShmem->max_requests *
+							   sizeof(FsyncRequestEntry));
+		absorbed_fsync = (FsyncRequestEntry *)
+			MemoryContextAlloc(TopMemoryContext,
+							   (Size) NUM_FSYNC_REQUEST_PARTITIONS *
+							   fsync_partition_size *
+							   sizeof(FsyncRequestEntry));
+	}
 
 	/*
-	 * We try to avoid holding the lock for a long time by copying the request
-	 * array, and processing the requests after releasing the lock.
+	 * We try to avoid holding the locks for a long time by copying the
+	 * requests, and processing them after releasing the locks.
 	 *
 	 * Once we have cleared the requests from shared memory, we have to PANIC
 	 * if we then fail to absorb them (eg, because our hashtable runs out of
 	 * memory).  This is because the system cannot run safely if we are unable
 	 * to fsync what we have been told to fsync.  Fortunately, the hashtable
 	 * is so small that the problem is quite unlikely to arise in practice.
+	 *
+	 * The control requests must be collected first; see the comments above
+	 * CheckpointerShmemStruct.
 	 */
-	n = CheckpointerShmem->num_requests;
-	if (n > 0)
-	{
-		requests = (CheckpointerRequest *) palloc(n * sizeof(CheckpointerRequest));
-		memcpy(requests, CheckpointerShmem->requests, n * sizeof(CheckpointerRequest));
-	}
+	LWLockAcquire(CheckpointerCommLock, LW_EXCLUSIVE);
+
+	ncontrol = CheckpointerShmem->num_requests;
+	memcpy(absorbed_control, CheckpointerShmem->requests,
+		   ncontrol * sizeof(FsyncRequestEntry));
 
 	START_CRIT_SECTION();
 
@@ -1313,13 +1420,66 @@ AbsorbFsyncRequests(void)
 
 	LWLockRelease(CheckpointerCommLock);
 
-	for (request = requests; n > 0; request++, n--)
-		RememberFsyncRequest(request->rnode, request->forknum, request->segno);
+	nfsync = 0;
+	for (i = 0; i < NUM_FSYNC_REQUEST_PARTITIONS; i++)
+	{
+		FsyncRequestPartitionData *partition = &CheckpointerShmem->partitions[i].data;
+		FsyncRequestEntry *entries = FsyncRequestEntries + i * fsync_partition_size;
+		int		   *slots = FsyncRequestSlots + i * 2 * fsync_partition_size;
+
+		LWLockAcquire(&partition->lock, LW_EXCLUSIVE);
+		for (j = 0; j < partition->nused; j++)
+		{
+			absorbed_fsync[nfsync++] = entries[j];
+			slots[entries[j].slot] = -1;
+		}
+		partition->nused = 0;
+		LWLockRelease(&partition->lock);
+	}
+
+	/*
+	 * Pass on the fsync requests in sequence, each before the control
+	 * requests made after it.
+	 */
+	if (nfsync > 1)
+		qsort(absorbed_fsync, nfsync, sizeof(FsyncRequestEntry),
+			  fsync_request_seq_cmp);
+
+	j = 0;
+	for (i = 0; i < ncontrol; i++)
+	{
+		FsyncRequestEntry *control = &absorbed_control[i];
+
+		for (; j < nfsync && absorbed_fsync[j].seq <= control->seq; j++)
+			RememberFsyncRequest(absorbed_fsync[j].request.rnode,
+								 absorbed_fsync[j].request.forknum,
+								 absorbed_fsync[j].request.segno);
+		RememberFsyncRequest(control->request.rnode,
+							 control->request.forknum,
+							 control->request.segno);
+	}
+	for (; j < nfsync; j++)
+		RememberFsyncRequest(absorbed_fsync[j].request.rnode,
+							 absorbed_fsync[j].request.forknum,
+							 absorbed_fsync[j].request.segno);
 
 	END_CRIT_SECTION();
+}
 
-	if (requests)
-		pfree(requests);
+/*
+ * qsort comparator for FsyncRequestEntry, by sequence number
+ */
+static int
+fsync_request_seq_cmp(const void *a, const void *b)
+{
+	const FsyncRequestEntry *ea = (const FsyncRequestEntry *) a;
+	const FsyncRequestEntry *eb = (const FsyncRequestEntry *) b;
+
+	if (ea->seq < eb->seq)
+		return -1;
+	if (ea->seq > eb->seq)
+		return 1;
+	return 0;
 }
 
 /*
@@ -0,0 +1,496 @@
+/*-------------------------------------------------------------------------
+ *
+ * ckptwriter.c
+ *	  Checkpoint writer processes
+ *
+ * A single process can't keep enough writes in flight to saturate storage
+ * made of many independent devices, so when checkpoint_writers is set, the
+ * postmaster starts that many checkpoint writers, as background workers.
+ * BufferSync() then doesn't write the buffers to be checkpointed itself, but
+ * hands them out in batches, in the sorted order it would have written them
+ * in, and keeps pacing the checkpoint with CheckpointWriteDelay() as usual.
+ * Each tablespace gets its own writer where possible; if there are fewer
+ * tablespaces than writers, successive batches for a tablespace rotate
+ * among several writers.
+ *
+ * Each writer has a slot in shared memory, holding at most one batch.  The
+ * checkpointer fills in the batch and sets the writer's latch; the writer
+ * writes out the buffers, counts the ones it actually wrote, and sets the
+ * checkpointer's latch when done.  The slot's spinlock protects all of this.
+ *
+ * The writers are a best-effort addition: a checkpoint also has to work when
+ * they are not running, e.g. for the shutdown checkpoint, which takes place
+ * after they have been told to exit.  So if the checkpointer finds that a
+ * writer's slot is unused, it writes the buffers itself, including any batch
+ * its previous owner left unfinished.  Since writing a buffer that is no
+ * longer dirty does nothing, a batch that ends up written twice is harmless.
+ *
+ * As writers are not the checkpointer, they forward fsync requests for the
+ * segments they write like any backend.  The checkpointer waits for all
+ * batches to be done before absorbing those requests for the sync phase.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/postmaster/ckptwriter.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "miscadmin.h"
+#include "pgstat.h"
+#include "postmaster/bgworker.h"
+#include "postmaster/bgwriter.h"
+#include "postmaster/ckptwriter.h"
+#include "storage/buf_internals.h"
+#include "storage/bufmgr.h"
+#include "storage/ipc.h"
+#include "storage/latch.h"
+#include "storage/proc.h"
+#include "storage/shmem.h"
+#include "storage/smgr.h"
+#include "storage/spin.h"
+#include "tcop/tcopprot.h"
+#include "utils/guc.h"
+#include "utils/memutils.h"
+#include "utils/resowner.h"
+
+
+/* Number of buffers handed to a writer at a time */
+#define CKPT_WRITER_BATCH_SIZE	64
+
+/* A writer idle for this long (in ms) closes its open relations */
+#define CKPT_WRITER_IDLE_TIMEOUT	10000
+
+typedef struct CkptWriterSlot
+{
+	slock_t		mutex;			/* protects the following fields */
+	pid_t		pid;			/* PID of writer, 0 if none is attached */
+	Latch	   *latch;			/* writer's latch, if attached */
+	int			nwritten;		/* # of buffers written, not yet collected */
+	int			nbuffers;		/* # of buffers in batch, 0 if idle */
+	int			buf_ids[CKPT_WRITER_BATCH_SIZE];
+} CkptWriterSlot;
+
+/* GUC variable */
+int			checkpoint_writers = 0;
+
+/* Array of checkpoint_writers slots, in shared memory */
+static CkptWriterSlot *CkptWriterSlots = NULL;
+
+/* Our slot, in a writer */
+static CkptWriterSlot *MySlot = NULL;
+
+/* Checkpointer's batches being filled, one per writer */
+static int *pending_buf_ids = NULL;
+static int *pending_nbuffers = NULL;
+
+/* Checkpointer's count of buffers queued for each stream (tablespace) */
+static int	num_streams;
+static int *stream_nqueued = NULL;
+
+/* Checkpointer's count of buffers it wrote in place of a writer */
+static int	fallback_written;
+static WritebackContext fallback_wb_context;
+
+static volatile sig_atomic_t got_SIGHUP = false;
+
+static void ckptwriter_sighup(SIGNAL_ARGS);
+static void ckptwriter_detach(int code, Datum arg);
+static bool CkptWriterDispatch(int writer, bool wait);
+
+
+/*
+ * CkptWriterRegister
+ *		Register the checkpoint writers as background workers.
+ *
+ * Called by the postmaster, before it computes MaxBackends.
+ */
+void
+CkptWriterRegister(void)
+{
+	BackgroundWorker bgw;
+	int			i;
+
+	for (i = 0; i < checkpoint_writers; i++)
+	{
+		memset(&bgw, 0, sizeof(bgw));
+		bgw.bgw_flags = BGWORKER_SHMEM_ACCESS;
+		bgw.bgw_start_time = BgWorkerStart_PostmasterStart;
+		snprintf(bgw.bgw_library_name, BGW_MAXLEN, "postgres");
+		snprintf(bgw.bgw_function_name, BGW_MAXLEN, "CkptWriterMain");
+		snprintf(bgw.bgw_name, BGW_MAXLEN, "checkpoint writer %d", i);
+		snprintf(bgw.bgw_type, BGW_MAXLEN, "checkpoint writer");
+		bgw.bgw_restart_time = 5;
+		bgw.bgw_notify_pid = 0;
+		bgw.bgw_main_arg = Int32GetDatum(i);
+
+		RegisterBackgroundWorker(&bgw);
+	}
+}
+
+/*
+ * CkptWriterShmemSize
+ *		Compute space needed for checkpoint writer shared memory
+ */
+Size
+CkptWriterShmemSize(void)
+{
+	return mul_size(checkpoint_writers, sizeof(CkptWriterSlot));
+}
+
+/*
+ * CkptWriterShmemInit
+ *		Allocate and initialize checkpoint writer shared memory
+ */
+void
+CkptWriterShmemInit(void)
+{
+	bool		found;
+
+	CkptWriterSlots = (CkptWriterSlot *)
+		ShmemInitStruct("Checkpoint Writer Data",
+						CkptWriterShmemSize(),
+						&found);
+
+	if (!found)
+	{
+		int			i;
+
+		MemSet(CkptWriterSlots, 0, CkptWriterShmemSize());
+		for (i = 0; i < checkpoint_writers; i++)
+			SpinLockInit(&CkptWriterSlots[i].mutex);
+	}
+}
+
+/*
+ * CkptWriterMain
+ *		Main entry point for a checkpoint writer process.
+ */
+void
+CkptWriterMain(Datum main_arg)
+{
+	int			slotno = DatumGetInt32(main_arg);
+	WritebackContext wb_context;
+
+	pqsignal(SIGHUP, ckptwriter_sighup);
+	pqsignal(SIGTERM, die);
+	BackgroundWorkerUnblockSignals();
+
+	Assert(slotno >= 0 && slotno < checkpoint_writers);
+	MySlot = &CkptWriterSlots[slotno];
+
+	SpinLockAcquire(&MySlot->mutex);
+	if (MySlot->pid != 0)
+	{
+		SpinLockRelease(&MySlot->mutex);
+		elog(ERROR, "checkpoint writer slot %d is already in use by PID %d",
+			 slotno, (int) MySlot->pid);
+	}
+	MySlot->pid = MyProcPid;
+	MySlot->latch = MyLatch;
+	SpinLockRelease(&MySlot->mutex);
+
+	/*
+	 * Registered before InitBufferPoolBackend()'s callback, so that buffers
+	 * are released before a leftover batch can be picked up by someone else.
+	 */
+	on_shmem_exit(ckptwriter_detach, (Datum) 0);
+
+	InitBufferPoolBackend();
+	CurrentResourceOwner = ResourceOwnerCreate(NULL, "Checkpoint Writer");
+
+	WritebackContextInit(&wb_context, &checkpoint_flush_after);
+
+	/* A batch may have been left behind by our predecessor */
+	SetLatch(MyLatch);
+
+	for (;;)
+	{
+		int			buf_ids[CKPT_WRITER_BATCH_SIZE];
+		int			nbuffers;
+		int			nwritten;
+		int			rc;
+
+		rc = WaitLatch(MyLatch,
+					   WL_LATCH_SET | WL_TIMEOUT | WL_EXIT_ON_PM_DEATH,
+					   CKPT_WRITER_IDLE_TIMEOUT,
+					   WAIT_EVENT_CHECKPOINT_WRITER_MAIN);
+		ResetLatch(MyLatch);
+
+		CHECK_FOR_INTERRUPTS();
+
+		if (got_SIGHUP)
+		{
+			got_SIGHUP = false;
+			ProcessConfigFile(PGC_SIGHUP);
+		}
+
+		/*
+		 * Like the checkpointer after each checkpoint, close the relations
+		 * we have open once idle for a while, so that we don't keep files of
+		 * dropped relations open indefinitely.
+		 */
+		if (rc & WL_TIMEOUT)
+			smgrcloseall();
+
+		SpinLockAcquire(&MySlot->mutex);
+		nbuffers = MySlot->nbuffers;
+		memcpy(buf_ids, MySlot->buf_ids, nbuffers * sizeof(int));
+		SpinLockRelease(&MySlot->mutex);
+
+		if (nbuffers == 0)
+			continue;
+
+		nwritten = CheckpointWriteBuffers(buf_ids, nbuffers, &wb_context);
+		IssuePendingWritebacks(&wb_context);
+
+		SpinLockAcquire(&MySlot->mutex);
+		MySlot->nwritten += nwritten;
+		MySlot->nbuffers = 0;
+		SpinLockRelease(&MySlot->mutex);
+
+		if (ProcGlobal->checkpointerLatch)
+			SetLatch(ProcGlobal->checkpointerLatch);
+	}
+}
+
+/*
+ * CkptWriterStartBatches
+ *		Prepare to hand out the buffers of a checkpoint.
+ *
+ * The buffers will be queued in 'nstreams' streams, one per tablespace.
+ * Returns false if there are no writers, and the caller should write the
+ * buffers itself.
+ */
+bool
+CkptWriterStartBatches(int nstreams)
+{
+	int			i;
+
+	if (checkpoint_writers == 0 || !AmCheckpointerProcess())
+		return false;
+
+	if (pending_buf_ids == NULL)
+	{
+		pending_buf_ids = (int *)
+			MemoryContextAlloc(TopMemoryContext,
+							   checkpoint_writers * CKPT_WRITER_BATCH_SIZE *
+							   sizeof(int));
+		pending_nbuffers = (int *)
+			MemoryContextAlloc(TopMemoryContext,
+							   checkpoint_writers * sizeof(int));
+	}
+
+	for (i = 0; i < checkpoint_writers; i++)
+	{
+		CkptWriterSlot *slot = &CkptWriterSlots[i];
+
+		pending_nbuffers[i] = 0;
+
+		SpinLockAcquire(&slot->mutex);
+		slot->nwritten = 0;
+		SpinLockRelease(&slot->mutex);
+	}
+
+	num_streams = nstreams;
+	stream_nqueued = (int *) palloc0(nstreams * sizeof(int));
+
+	fallback_written = 0;
+	WritebackContextInit(&fallback_wb_context, &checkpoint_flush_after);
+
+	return true;
+}
+
+/*
+ * CkptWriterQueueBuffer
+ *		Add a buffer of the given stream to the batch of its current writer.
+ *
+ * A full batch is handed over, waiting for the writer to finish the
+ * previous one if necessary.
+ */
+void
+CkptWriterQueueBuffer(int stream, int buf_id)
+{
+	int			writer;
+
+	Assert(stream >= 0 && stream < num_streams);
+
+	/*
+	 * With at least as many streams as writers, this always picks the same
+	 * writer for a stream.  Otherwise the stream's batches rotate among the
+	 * writers whose number is congruent to it modulo num_streams.
+	 */
+	writer = (stream + num_streams *
+			  (stream_nqueued[stream]++ / CKPT_WRITER_BATCH_SIZE)) %
+		checkpoint_writers;
+
+	pending_buf_ids[writer * CKPT_WRITER_BATCH_SIZE +
+					pending_nbuffers[writer]++] = buf_id;
+
+	if (pending_nbuffers[writer] == CKPT_WRITER_BATCH_SIZE)
+		(void) CkptWriterDispatch(writer, true);
+}
+
+/*
+ * CkptWriterFinishBatches
+ *		Hand over all partial batches, and wait for all writers to finish.
+ *
+ * Returns the total number of buffers written since CkptWriterStartBatches.
+ */
+int
+CkptWriterFinishBatches(void)
+{
+	int			nwritten;
+	int			i;
+
+	for (i = 0; i < checkpoint_writers; i++)
+	{
+		if (pending_nbuffers[i] > 0)
+			(void) CkptWriterDispatch(i, true);
+	}
+
+	for (;;)
+	{
+		bool		busy = false;
+
+		for (i = 0; i < checkpoint_writers; i++)
+		{
+			if (!CkptWriterDispatch(i, false))
+				busy = true;
+		}
+		if (!busy)
+			break;
+
+		(void) WaitLatch(MyLatch,
+						 WL_LATCH_SET | WL_TIMEOUT | WL_EXIT_ON_PM_DEATH,
+						 10, WAIT_EVENT_CHECKPOINT_WRITE_BATCH);
+		ResetLatch(MyLatch);
+
+		/* keep the fsync request table from filling up meanwhile */
+		AbsorbFsyncRequests();
+	}
+
+	IssuePendingWritebacks(&fallback_wb_context);
+
+	pfree(stream_nqueued);
+	stream_nqueued = NULL;
+
+	nwritten = fallback_written;
+	for (i = 0; i < checkpoint_writers; i++)
+	{
+		CkptWriterSlot *slot = &CkptWriterSlots[i];
+
+		SpinLockAcquire(&slot->mutex);
+		nwritten += slot->nwritten;
+		slot->nwritten = 0;
+		SpinLockRelease(&slot->mutex);
+	}
+
+	return nwritten;
+}
+
+/*
+ * Hand the checkpointer's pending batch for a writer, if any, over to it.
+ *
+ * If the writer is still busy with its previous batch, wait for it if 'wait'
+ * is true, else return false.  If no writer is attached to the slot, write
+ * both the pending batch and any batch left in the slot ourselves.  Returns
+ * true once the pending batch has been handed over or written.
+ */
+static bool
+CkptWriterDispatch(int writer, bool wait)
+{
+	CkptWriterSlot *slot = &CkptWriterSlots[writer];
+	int		   *buf_ids = &pending_buf_ids[writer * CKPT_WRITER_BATCH_SIZE];
+
+	for (;;)
+	{
+		int			leftover[CKPT_WRITER_BATCH_SIZE];
+		int			nleftover = 0;
+		Latch	   *latch = NULL;
+		bool		attached;
+
+		SpinLockAcquire(&slot->mutex);
+		attached = (slot->pid != 0);
+		if (!attached)
+		{
+			nleftover = slot->nbuffers;
+			memcpy(leftover, slot->buf_ids, nleftover * sizeof(int));
+			slot->nbuffers = 0;
+		}
+		else if (slot->nbuffers == 0 && pending_nbuffers[writer] > 0)
+		{
+			memcpy(slot->buf_ids, buf_ids,
+				   pending_nbuffers[writer] * sizeof(int));
+			slot->nbuffers = pending_nbuffers[writer];
+			latch = slot->latch;
+			pending_nbuffers[writer] = 0;
+		}
+		else if (slot->nbuffers == 0)
+		{
+			/* nothing pending, and the writer is idle */
+			SpinLockRelease(&slot->mutex);
+			return true;
+		}
+		SpinLockRelease(&slot->mutex);
+
+		if (latch)
+		{
+			SetLatch(latch);
+			return true;
+		}
+
+		if (!attached)
+		{
+			fallback_written += CheckpointWriteBuffers(leftover, nleftover,
+													   &fallback_wb_context);
+			fallback_written += CheckpointWriteBuffers(buf_ids,
+													   pending_nbuffers[writer],
+													   &fallback_wb_context);
+			pending_nbuffers[writer] = 0;
+			return true;
+		}
+
+		if (!wait)
+			return false;
+
+		(void) WaitLatch(MyLatch,
+						 WL_LATCH_SET | WL_TIMEOUT | WL_EXIT_ON_PM_DEATH,
+						 10, WAIT_EVENT_CHECKPOINT_WRITE_BATCH);
+		ResetLatch(MyLatch);
+
+		/* keep the fsync request table from filling up meanwhile */
+		AbsorbFsyncRequests();
+	}
+}
+
+/*
+ * Release our slot at process exit.  Any batch we didn't finish stays in
+ * the slot, for the checkpointer or our successor to write.
+ */
+static void
+ckptwriter_detach(int code, Datum arg)
+{
+	SpinLockAcquire(&MySlot->mutex);
+	MySlot->pid = 0;
+	MySlot->latch = NULL;
+	SpinLockRelease(&MySlot->mutex);
+
+	if (ProcGlobal->checkpointerLatch)
+		SetLatch(ProcGlobal->checkpointerLatch);
+}
+
+/* SIGHUP: set flag to re-read config file at next convenient time */
+static void
+ckptwriter_sighup(SIGNAL_ARGS)
+{
+	int			save_errno = errno;
+
+	got_SIGHUP = true;
+	SetLatch(MyLatch);
+
+	errno = save_errno;
+}
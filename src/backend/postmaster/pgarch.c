@@ -12,6 +12,10 @@
  *	processes then communicate using signals. All functions
  *	executed by postmaster are included in this file.
  *
+ *	Files are archived either by running archive_command, possibly
+ *	several copies at once (see archive_workers), or by calling into an
+ *	archive module loaded from archive_library.
+ *
  *	Initial author: Simon Riggs		simon@2ndquadrant.com
  *
  * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
@@ -45,7 +49,6 @@
 #include "storage/fd.h"
 #include "storage/ipc.h"
 #include "storage/latch.h"
-#include "storage/pg_shmem.h"
 #include "storage/pmsignal.h"
 #include "utils/guc.h"
 #include "utils/ps_status.h"
@@ -72,6 +75,17 @@
  */
 #define NUM_ORPHAN_CLEANUP_RETRIES 3
 
+/*
+ * Number of oldest .ready files collected by one scan of the archive status
+ * directory when archiving several files concurrently.
+ */
+#define NUM_FILES_PER_DIRECTORY_SCAN 64
+
+
+/* GUC variables */
+char	   *XLogArchiveLibrary = "";
+int			archive_workers = 1;
+
 
 /* ----------
  * Local data
@@ -88,6 +102,24 @@ static volatile sig_atomic_t got_SIGTERM = false;
 static volatile sig_atomic_t wakened = false;
 static volatile sig_atomic_t ready_to_stop = false;
 
+/*
+ * Callbacks of the archive module named by archive_library, if any.
+ */
+static ArchiveModuleCallbacks ArchiveCallbacks;
+static bool archive_module_loaded = false;
+
+#ifndef WIN32
+/*
+ * State of one concurrently running archive_command.
+ */
+typedef struct ArchiveWorker
+{
+	pid_t		pid;			/* child running the command, or 0 if free */
+	char		xlog[MAX_XFN_CHARS + 1];	/* file being archived */
+	char		command[MAXPGPATH]; /* command as executed */
+} ArchiveWorker;
+#endif
+
 /* ----------
  * Local function forward declarations
  * ----------
@@ -106,7 +138,18 @@ static void pgarch_MainLoop(void);
 static void pgarch_ArchiverCopyLoop(void);
 static bool pgarch_archiveXlog(char *xlog);
 static bool pgarch_readyXlog(char *xlog);
+static int pgarch_readyXlogs(char (*xlogs)[MAX_XFN_CHARS + 1], int maxfiles);
 static void pgarch_archiveDone(char *xlog);
+static bool pgarch_archivingConfigured(void);
+static void pgarch_buildCommand(char *xlogarchcmd, const char *xlog);
+static void pgarch_reportFailure(int rc, const char *xlogarchcmd, int elevel);
+static void LoadArchiveLibrary(void);
+static void pgarch_shutdownModule(int code, Datum arg);
+#ifndef WIN32
+static void pgarch_ParallelCopyLoop(void);
+static bool pgarch_checkOrphan(const char *xlog);
+static pid_t pgarch_startCommand(const char *xlogarchcmd);
+#endif
 
 
 /* ------------------------------------------------------------
@@ -167,9 +210,12 @@ pgarch_start(void)
 			/* Close the postmaster's sockets */
 			ClosePostmasterPorts(false);
 
-			/* Drop our connection to postmaster's shared memory, as well */
+			/*
+			 * Drop our connection to postmaster's dynamic shared memory.  We
+			 * stay attached to the main segment, which holds the shared
+			 * archiver statistics.
+			 */
 			dsm_detach_all();
-			PGSharedMemoryDetach();
 
 			PgArchiverMain(0, NULL);
 			break;
@@ -246,8 +292,13 @@ PgArchiverMain(int argc, char *argv[])
 	 */
 	init_ps_display("archiver", "", "", "");
 
+	/* Load the archive module, if one is configured */
+	LoadArchiveLibrary();
+
 	pgarch_MainLoop();
 
+	pgarch_shutdownModule(0, 0);
+
 	exit(0);
 }
 
@@ -426,6 +477,15 @@ pgarch_ArchiverCopyLoop(void)
 {
 	char		xlog[MAX_XFN_CHARS + 1];
 
+#ifndef WIN32
+	/* Run several copies of archive_command at once, if so configured */
+	if (!archive_module_loaded && archive_workers > 1)
+	{
+		pgarch_ParallelCopyLoop();
+		return;
+	}
+#endif
+
 	/*
 	 * loop through all xlogs with archive_status of .ready and archive
 	 * them...mostly we expect this to be a single file, though it is possible
@@ -464,12 +524,8 @@ pgarch_ArchiverCopyLoop(void)
 			}
 
 			/* can't do anything if no command ... */
-			if (!XLogArchiveCommandSet())
-			{
-				ereport(WARNING,
-						(errmsg("archive_mode enabled, yet archive_command is not set")));
+			if (!pgarch_archivingConfigured())
 				return;
-			}
 
 			/*
 			 * Since archive status files are not removed in a durable manner,
@@ -545,10 +601,42 @@ pgarch_ArchiverCopyLoop(void)
 	}
 }
 
+/*
+ * pgarch_archivingConfigured
+ *
+ * Check whether archiving is set up well enough to try it, complaining if
+ * not
+ */
+static bool
+pgarch_archivingConfigured(void)
+{
+	if (archive_module_loaded)
+	{
+		if (ArchiveCallbacks.check_configured_cb != NULL &&
+			!ArchiveCallbacks.check_configured_cb())
+		{
+			ereport(WARNING,
+					(errmsg("archive_mode enabled, yet archive module \"%s\" is not configured",
+							XLogArchiveLibrary)));
+			return false;
+		}
+		return true;
+	}
+
+	if (!XLogArchiveCommandSet())
+	{
+		ereport(WARNING,
+				(errmsg("archive_mode enabled, yet archive_command is not set")));
+		return false;
+	}
+	return true;
+}
+
 /*
  * pgarch_archiveXlog
  *
- * Invokes system(3) to copy one archive file to wherever it should go
+ * Invokes system(3), or the archive module, to copy one archive file to
+ * wherever it should go
  *
  * Returns true if successful
  */
@@ -556,18 +644,87 @@ static bool
 pgarch_archiveXlog(char *xlog)
 {
 	char		xlogarchcmd[MAXPGPATH];
-	char		pathname[MAXPGPATH];
 	char		activitymsg[MAXFNAMELEN + 16];
+	int			rc;
+
+	/* Report archive activity in PS display */
+	snprintf(activitymsg, sizeof(activitymsg), "archiving %s", xlog);
+
+	if (archive_module_loaded)
+	{
+		char		pathname[MAXPGPATH];
+
+		snprintf(pathname, MAXPGPATH, XLOGDIR "/%s", xlog);
+
+		set_ps_display(activitymsg, false);
+
+		if (!ArchiveCallbacks.archive_file_cb(xlog, pathname))
+		{
+			ereport(LOG,
+					(errmsg("archive module \"%s\" failed to archive write-ahead log file \"%s\"",
+							XLogArchiveLibrary, xlog)));
+
+			snprintf(activitymsg, sizeof(activitymsg), "failed on %s", xlog);
+			set_ps_display(activitymsg, false);
+
+			return false;
+		}
+	}
+	else
+	{
+		pgarch_buildCommand(xlogarchcmd, xlog);
+
+		ereport(DEBUG3,
+				(errmsg_internal("executing archive command \"%s\"",
+								 xlogarchcmd)));
+
+		set_ps_display(activitymsg, false);
+
+		rc = system(xlogarchcmd);
+		if (rc != 0)
+		{
+			/*
+			 * If either the shell itself, or a called command, died on a
+			 * signal, abort the archiver.  We do this because system()
+			 * ignores SIGINT and SIGQUIT while waiting; so a signal is very
+			 * likely something that should have interrupted us too.  Also die
+			 * if the shell got a hard "command not found" type of error.  If
+			 * we overreact it's no big deal, the postmaster will just start
+			 * the archiver again.
+			 */
+			pgarch_reportFailure(rc, xlogarchcmd,
+								 wait_result_is_any_signal(rc, true) ? FATAL : LOG);
+
+			snprintf(activitymsg, sizeof(activitymsg), "failed on %s", xlog);
+			set_ps_display(activitymsg, false);
+
+			return false;
+		}
+	}
+	elog(DEBUG1, "archived write-ahead log file \"%s\"", xlog);
+
+	snprintf(activitymsg, sizeof(activitymsg), "last was %s", xlog);
+	set_ps_display(activitymsg, false);
+
+	return true;
+}
+
+/*
+ * pgarch_buildCommand
+ *
+ * Construct the archive_command to run for the given file into xlogarchcmd,
+ * which must be MAXPGPATH bytes long
+ */
+static void
+pgarch_buildCommand(char *xlogarchcmd, const char *xlog)
+{
+	char		pathname[MAXPGPATH];
 	char	   *dp;
 	char	   *endp;
 	const char *sp;
-	int			rc;
 
 	snprintf(pathname, MAXPGPATH, XLOGDIR "/%s", xlog);
 
-	/*
-	 * construct the command to be executed
-	 */
 	dp = xlogarchcmd;
 	endp = xlogarchcmd + MAXPGPATH - 1;
 	*endp = '\0';
@@ -611,83 +768,375 @@ pgarch_archiveXlog(char *xlog)
 		}
 	}
 	*dp = '\0';
+}
+
+/*
+ * pgarch_reportFailure
+ *
+ * Report that archive command xlogarchcmd failed with wait status rc
+ */
+static void
+pgarch_reportFailure(int rc, const char *xlogarchcmd, int elevel)
+{
+	if (WIFEXITED(rc))
+	{
+		ereport(elevel,
+				(errmsg("archive command failed with exit code %d",
+						WEXITSTATUS(rc)),
+				 errdetail("The failed archive command was: %s",
+						   xlogarchcmd)));
+	}
+	else if (WIFSIGNALED(rc))
+	{
+#if defined(WIN32)
+		ereport(elevel,
+				(errmsg("archive command was terminated by exception 0x%X",
+						WTERMSIG(rc)),
+				 errhint("See C include file \"ntstatus.h\" for a description of the hexadecimal value."),
+				 errdetail("The failed archive command was: %s",
+						   xlogarchcmd)));
+#else
+		ereport(elevel,
+				(errmsg("archive command was terminated by signal %d: %s",
+						WTERMSIG(rc), pg_strsignal(WTERMSIG(rc))),
+				 errdetail("The failed archive command was: %s",
+						   xlogarchcmd)));
+#endif
+	}
+	else
+	{
+		ereport(elevel,
+				(errmsg("archive command exited with unrecognized status %d",
+						rc),
+				 errdetail("The failed archive command was: %s",
+						   xlogarchcmd)));
+	}
+}
 
-	ereport(DEBUG3,
-			(errmsg_internal("executing archive command \"%s\"",
-							 xlogarchcmd)));
+#ifndef WIN32
+/*
+ * pgarch_ParallelCopyLoop
+ *
+ * Like the serial loop in pgarch_ArchiverCopyLoop, but keeps up to
+ * archive_workers copies of archive_command running at once, each on a
+ * different file.  Files are still started oldest first, but may complete
+ * in any order; that's fine since each is only marked done once it has been
+ * archived.  When a command fails, we stop starting new ones, let the others
+ * finish, and then retry, giving up for now after NUM_ARCHIVE_RETRIES
+ * consecutive failed rounds.
+ */
+static void
+pgarch_ParallelCopyLoop(void)
+{
+	ArchiveWorker workers[MAX_ARCHIVE_WORKERS];
+	char		batch[NUM_FILES_PER_DIRECTORY_SCAN][MAX_XFN_CHARS + 1];
+	char		failed_xlog[MAX_XFN_CHARS + 1];
+	char		fatal_command[MAXPGPATH];
+	int			fatal_rc = 0;
+	int			failures = 0;
 
-	/* Report archive activity in PS display */
-	snprintf(activitymsg, sizeof(activitymsg), "archiving %s", xlog);
-	set_ps_display(activitymsg, false);
+	memset(workers, 0, sizeof(workers));
+	failed_xlog[0] = '\0';
 
-	rc = system(xlogarchcmd);
-	if (rc != 0)
+	for (;;)
 	{
-		/*
-		 * If either the shell itself, or a called command, died on a signal,
-		 * abort the archiver.  We do this because system() ignores SIGINT and
-		 * SIGQUIT while waiting; so a signal is very likely something that
-		 * should have interrupted us too.  Also die if the shell got a hard
-		 * "command not found" type of error.  If we overreact it's no big
-		 * deal, the postmaster will just start the archiver again.
-		 */
-		int			lev = wait_result_is_any_signal(rc, true) ? FATAL : LOG;
+		int			nbatch = 0;
+		int			nextbatch = 0;
+		int			nrunning = 0;
+		bool		rescanned = false;
+		bool		stop = false;
+		bool		failed = false;
 
-		if (WIFEXITED(rc))
-		{
-			ereport(lev,
-					(errmsg("archive command failed with exit code %d",
-							WEXITSTATUS(rc)),
-					 errdetail("The failed archive command was: %s",
-							   xlogarchcmd)));
-		}
-		else if (WIFSIGNALED(rc))
+		for (;;)
 		{
-#if defined(WIN32)
-			ereport(lev,
-					(errmsg("archive command was terminated by exception 0x%X",
-							WTERMSIG(rc)),
-					 errhint("See C include file \"ntstatus.h\" for a description of the hexadecimal value."),
-					 errdetail("The failed archive command was: %s",
-							   xlogarchcmd)));
-#else
-			ereport(lev,
-					(errmsg("archive command was terminated by signal %d: %s",
-							WTERMSIG(rc), pg_strsignal(WTERMSIG(rc))),
-					 errdetail("The failed archive command was: %s",
-							   xlogarchcmd)));
-#endif
+			/* Start as many commands as we're allowed to */
+			while (!stop && nrunning < Min(archive_workers, MAX_ARCHIVE_WORKERS))
+			{
+				char	   *xlog;
+				ArchiveWorker *worker = NULL;
+				bool		busy = false;
+				int			i;
+
+				/* See pgarch_ArchiverCopyLoop for these checks */
+				if (got_SIGTERM || !PostmasterIsAlive())
+				{
+					stop = true;
+					break;
+				}
+				if (got_SIGHUP)
+				{
+					got_SIGHUP = false;
+					ProcessConfigFile(PGC_SIGHUP);
+				}
+				if (!pgarch_archivingConfigured())
+				{
+					stop = true;
+					break;
+				}
+
+				/* Get the next file, rescanning the directory as needed */
+				if (nextbatch >= nbatch)
+				{
+					/* Another scan won't help if all of this one's are busy */
+					if (rescanned)
+						break;
+					nbatch = pgarch_readyXlogs(batch,
+											   NUM_FILES_PER_DIRECTORY_SCAN);
+					nextbatch = 0;
+					rescanned = true;
+					if (nbatch == 0)
+						break;
+				}
+				xlog = batch[nextbatch++];
+
+				/* Skip it if it's already being archived */
+				for (i = 0; i < MAX_ARCHIVE_WORKERS; i++)
+				{
+					if (workers[i].pid == 0)
+					{
+						if (worker == NULL)
+							worker = &workers[i];
+					}
+					else if (strcmp(workers[i].xlog, xlog) == 0)
+						busy = true;
+				}
+				if (busy)
+					continue;
+				Assert(worker != NULL);
+
+				if (!pgarch_checkOrphan(xlog))
+					continue;
+
+				pgarch_buildCommand(worker->command, xlog);
+				ereport(DEBUG3,
+						(errmsg_internal("executing archive command \"%s\"",
+										 worker->command)));
+				worker->pid = pgarch_startCommand(worker->command);
+				if (worker->pid < 0)
+				{
+					worker->pid = 0;
+					ereport(LOG,
+							(errmsg("could not fork archive command: %m")));
+					strlcpy(failed_xlog, xlog, sizeof(failed_xlog));
+					stop = true;
+					failed = true;
+					break;
+				}
+				strlcpy(worker->xlog, xlog, sizeof(worker->xlog));
+				nrunning++;
+
+				/* a scan after starting something might find more */
+				rescanned = false;
+			}
+
+			if (nrunning == 0)
+				break;
+
+			/* Wait for any of the running commands to finish */
+			{
+				ArchiveWorker *worker = NULL;
+				pid_t		pid;
+				int			rc;
+				int			i;
+
+				pid = waitpid(-1, &rc, 0);
+				if (pid < 0)
+				{
+					if (errno == EINTR)
+						continue;
+					/* shouldn't happen; forget about the children */
+					ereport(LOG,
+							(errmsg("could not wait for archive command: %m")));
+					memset(workers, 0, sizeof(workers));
+					nrunning = 0;
+					failed = true;
+					break;
+				}
+
+				for (i = 0; i < MAX_ARCHIVE_WORKERS; i++)
+				{
+					if (workers[i].pid == pid)
+					{
+						worker = &workers[i];
+						break;
+					}
+				}
+				if (worker == NULL)
+					continue;	/* not one of ours */
+
+				worker->pid = 0;
+				nrunning--;
+
+				if (rc == 0)
+				{
+					char		activitymsg[MAXFNAMELEN + 16];
+
+					elog(DEBUG1, "archived write-ahead log file \"%s\"",
+						 worker->xlog);
+					pgarch_archiveDone(worker->xlog);
+					pgstat_send_archiver(worker->xlog, false);
+
+					snprintf(activitymsg, sizeof(activitymsg), "last was %s",
+							 worker->xlog);
+					set_ps_display(activitymsg, false);
+				}
+				else
+				{
+					/*
+					 * A signal or a hard shell failure would make the serial
+					 * loop abort the archiver; do the same, but only once the
+					 * other commands are done, so that a new archiver won't
+					 * start working on the same files meanwhile.
+					 */
+					if (wait_result_is_any_signal(rc, true) && fatal_rc == 0)
+					{
+						fatal_rc = rc;
+						strlcpy(fatal_command, worker->command,
+								sizeof(fatal_command));
+					}
+					else
+						pgarch_reportFailure(rc, worker->command, LOG);
+
+					pgstat_send_archiver(worker->xlog, true);
+					strlcpy(failed_xlog, worker->xlog, sizeof(failed_xlog));
+					stop = true;
+					failed = true;
+				}
+			}
 		}
-		else
+
+		if (fatal_rc != 0)
+			pgarch_reportFailure(fatal_rc, fatal_command, FATAL);
+
+		if (!failed)
+			return;
+
+		if (++failures >= NUM_ARCHIVE_RETRIES)
 		{
-			ereport(lev,
-					(errmsg("archive command exited with unrecognized status %d",
-							rc),
-					 errdetail("The failed archive command was: %s",
-							   xlogarchcmd)));
+			ereport(WARNING,
+					(errmsg("archiving write-ahead log file \"%s\" failed too many times, will try again later",
+							failed_xlog)));
+			return;				/* give up archiving for now */
 		}
+		if (got_SIGTERM || !PostmasterIsAlive())
+			return;
+		pg_usleep(1000000L);	/* wait a bit before retrying */
+	}
+}
 
-		snprintf(activitymsg, sizeof(activitymsg), "failed on %s", xlog);
-		set_ps_display(activitymsg, false);
+/*
+ * pgarch_checkOrphan
+ *
+ * Returns true if the segment xlog still exists.  If it doesn't, its status
+ * file is an orphan, see pgarch_ArchiverCopyLoop; try to remove that, and
+ * return false.  If the removal fails, the file will turn up again in the
+ * next directory scan, and we'll retry then.
+ */
+static bool
+pgarch_checkOrphan(const char *xlog)
+{
+	struct stat stat_buf;
+	char		pathname[MAXPGPATH];
+	char		xlogready[MAXPGPATH];
 
-		return false;
+	snprintf(pathname, MAXPGPATH, XLOGDIR "/%s", xlog);
+	if (stat(pathname, &stat_buf) == 0 || errno != ENOENT)
+		return true;
+
+	StatusFilePath(xlogready, xlog, ".ready");
+	if (unlink(xlogready) == 0)
+		ereport(WARNING,
+				(errmsg("removed orphan archive status file \"%s\"",
+						xlogready)));
+	else
+		ereport(WARNING,
+				(errmsg("removal of orphan archive status file \"%s\" failed, will try again later",
+						xlogready)));
+	return false;
+}
+
+/*
+ * pgarch_startCommand
+ *
+ * Start xlogarchcmd in a child process, the way system(3) would, but without
+ * waiting for it.  Returns the child's PID, or -1 if we couldn't fork.
+ */
+static pid_t
+pgarch_startCommand(const char *xlogarchcmd)
+{
+	pid_t		pid;
+
+	pid = fork_process();
+	if (pid == 0)
+	{
+		/* in the child; signal dispositions are reset by exec */
+		execl("/bin/sh", "sh", "-c", xlogarchcmd, (char *) NULL);
+		_exit(127);
 	}
-	elog(DEBUG1, "archived write-ahead log file \"%s\"", xlog);
+	return pid;
+}
+#endif							/* !WIN32 */
 
-	snprintf(activitymsg, sizeof(activitymsg), "last was %s", xlog);
-	set_ps_display(activitymsg, false);
+/*
+ * LoadArchiveLibrary
+ *
+ * Load the archive module named by archive_library, if any, and collect its
+ * callbacks.
+ */
+static void
+LoadArchiveLibrary(void)
+{
+	ArchiveModuleInit archive_init;
 
-	return true;
+	if (XLogArchiveLibrary[0] == '\0')
+		return;
+
+	memset(&ArchiveCallbacks, 0, sizeof(ArchiveCallbacks));
+
+	archive_init = (ArchiveModuleInit)
+		load_external_function(XLogArchiveLibrary,
+							   "_PG_archive_module_init", false, NULL);
+	if (archive_init == NULL)
+		ereport(ERROR,
+				(errmsg("archive modules have to define the symbol %s",
+						"_PG_archive_module_init")));
+
+	(*archive_init) (&ArchiveCallbacks);
+
+	if (ArchiveCallbacks.archive_file_cb == NULL)
+		ereport(ERROR,
+				(errmsg("archive modules must register an archive callback")));
+
+	archive_module_loaded = true;
+
+	/* Give the module a chance to clean up, however we exit */
+	on_proc_exit(pgarch_shutdownModule, 0);
+}
+
+/*
+ * pgarch_shutdownModule
+ *
+ * Call the archive module's shutdown callback, if there is one and it
+ * hasn't been called yet.
+ */
+static void
+pgarch_shutdownModule(int code, Datum arg)
+{
+	if (archive_module_loaded && ArchiveCallbacks.shutdown_cb != NULL)
+	{
+		archive_module_loaded = false;
+		ArchiveCallbacks.shutdown_cb();
+	}
 }
 
 /*
  * pgarch_readyXlog
  *
  * Return name of the oldest xlog file that has not yet been archived.
- * No notification is set that file archiving is now in progress, so
- * this would need to be extended if multiple concurrent archival
- * tasks were created. If a failure occurs, we will completely
- * re-copy the file at the next available opportunity.
+ * No notification is set that file archiving is now in progress;
+ * pgarch_ParallelCopyLoop keeps track of the files it is working on
+ * itself. If a failure occurs, we will completely re-copy the file at
+ * the next available opportunity.
  *
  * It is important that we return the oldest, so that we archive xlogs
  * in order that they were written, for two reasons:
@@ -704,18 +1153,32 @@ pgarch_archiveXlog(char *xlog)
  */
 static bool
 pgarch_readyXlog(char *xlog)
+{
+	return pgarch_readyXlogs((char (*)[MAX_XFN_CHARS + 1]) xlog, 1) > 0;
+}
+
+/*
+ * pgarch_readyXlogs
+ *
+ * Like pgarch_readyXlog, but returns the names of up to maxfiles of the
+ * oldest files not yet archived, oldest first, and their number.
+ */
+static int
+pgarch_readyXlogs(char (*xlogs)[MAX_XFN_CHARS + 1], int maxfiles)
 {
 	/*
 	 * open xlog status directory and read through list of xlogs that have the
-	 * .ready suffix, looking for earliest file. It is possible to optimise
+	 * .ready suffix, looking for earliest files. It is possible to optimise
 	 * this code, though only a single file is expected on the vast majority
 	 * of calls, so....
 	 */
 	char		XLogArchiveStatusDir[MAXPGPATH];
 	DIR		   *rldir;
 	struct dirent *rlde;
-	bool		found = false;
-	bool		historyFound = false;
+	int			nfound = 0;
+	int			nhistory = 0;
+
+	Assert(maxfiles > 0);
 
 	snprintf(XLogArchiveStatusDir, MAXPGPATH, XLOGDIR "/archive_status");
 	rldir = AllocateDir(XLogArchiveStatusDir);
@@ -725,6 +1188,7 @@ pgarch_readyXlog(char *xlog)
 		int			basenamelen = (int) strlen(rlde->d_name) - 6;
 		char		basename[MAX_XFN_CHARS + 1];
 		bool		ishistory;
+		int			pos;
 
 		/* Ignore entries with unexpected number of characters */
 		if (basenamelen < MIN_XFN_CHARS ||
@@ -747,28 +1211,47 @@ pgarch_readyXlog(char *xlog)
 		ishistory = IsTLHistoryFileName(basename);
 
 		/*
-		 * Consume the file to archive.  History files have the highest
-		 * priority.  If this is the first file or the first history file
-		 * ever, copy it.  In the presence of a history file already chosen as
-		 * target, ignore all other files except history files which have been
-		 * generated for an older timeline than what is already chosen as
-		 * target to archive.
+		 * Find where this file goes in the output, which we keep sorted.
+		 * History files have the highest priority, so they all come before
+		 * other files; within each group, older names come first.  If the
+		 * output is full, a file that sorts after all of it is dropped.
 		 */
-		if (!found || (ishistory && !historyFound))
+		if (ishistory)
+		{
+			for (pos = 0; pos < nhistory; pos++)
+			{
+				if (strcmp(basename, xlogs[pos]) < 0)
+					break;
+			}
+		}
+		else
 		{
-			strcpy(xlog, basename);
-			found = true;
-			historyFound = ishistory;
+			for (pos = nhistory; pos < nfound; pos++)
+			{
+				if (strcmp(basename, xlogs[pos]) < 0)
+					break;
+			}
 		}
-		else if (ishistory || !historyFound)
+		if (pos >= maxfiles)
+			continue;
+
+		/* Make room, pushing the newest file out if we're full */
+		if (nfound == maxfiles)
 		{
-			if (strcmp(basename, xlog) < 0)
-				strcpy(xlog, basename);
+			if (nhistory == nfound)
+				nhistory--;
+			nfound--;
 		}
+		memmove(xlogs[pos + 1], xlogs[pos],
+				(nfound - pos) * sizeof(xlogs[0]));
+		strcpy(xlogs[pos], basename);
+		nfound++;
+		if (ishistory)
+			nhistory++;
 	}
 	FreeDir(rldir);
 
-	return found;
+	return nfound;
 }
 
 /*
@@ -1,12 +1,20 @@
 /* ----------
  * pgstat.c
  *
- *	All the statistics collector stuff hacked up in one big, ugly file.
+ *	Activity and usage statistics, all hacked up in one big, ugly file.
  *
- *	TODO:	- Separate collector, postmaster and backend stuff
- *			  into different files.
+ *	Backends accumulate their table and function counts locally, and at most
+ *	every PGSTAT_STAT_INTERVAL milliseconds add them into hash tables that
+ *	live in a dynamic shared memory area (see StatsShmemInit).  Readers copy
+ *	the entries they look at into a local snapshot that lasts until the end
+ *	of the transaction, so that repeated queries give consistent answers.
+ *
+ *	The statistics are written to PGSTAT_STAT_PERMANENT_FILENAME at clean
+ *	shutdown and read back by the startup process; after a crash, or when
+ *	starting a standby, they are discarded.
  *
- *			- Add some automatic call for pgstat vacuuming.
+ *	TODO:	- Separate backend and shared-memory stuff
+ *			  into different files.
  *
  *			- Add a pgstat config column to pg_database, so this
  *			  entire thing can be enabled/disabled on a per db basis.
@@ -22,15 +30,7 @@
 #include <fcntl.h>
 #include <sys/param.h>
 #include <sys/time.h>
-#include <sys/socket.h>
-#include <netdb.h>
-#include <netinet/in.h>
-#include <arpa/inet.h>
-#include <signal.h>
 #include <time.h>
-#ifdef HAVE_SYS_SELECT_H
-#include <sys/select.h>
-#endif
 
 #include "pgstat.h"
 
@@ -41,29 +41,27 @@
 #include "access/xact.h"
 #include "catalog/pg_database.h"
 #include "catalog/pg_proc.h"
-#include "common/ip.h"
+#include "lib/dshash.h"
 #include "libpq/libpq.h"
-#include "libpq/pqsignal.h"
 #include "mb/pg_wchar.h"
 #include "miscadmin.h"
 #include "pg_trace.h"
 #include "postmaster/autovacuum.h"
-#include "postmaster/fork_process.h"
 #include "postmaster/postmaster.h"
 #include "replication/walsender.h"
 #include "storage/backendid.h"
-#include "storage/dsm.h"
 #include "storage/fd.h"
 #include "storage/ipc.h"
-#include "storage/latch.h"
 #include "storage/lmgr.h"
-#include "storage/pg_shmem.h"
+#include "storage/lockstats.h"
+#include "storage/lwlock.h"
 #include "storage/procsignal.h"
+#include "storage/shmem.h"
 #include "storage/sinvaladt.h"
+#include "storage/spin.h"
 #include "utils/ascii.h"
 #include "utils/guc.h"
 #include "utils/memutils.h"
-#include "utils/ps_status.h"
 #include "utils/rel.h"
 #include "utils/snapmgr.h"
 #include "utils/timestamp.h"
@@ -74,37 +72,27 @@
  * Timer definitions.
  * ----------
  */
-#define PGSTAT_STAT_INTERVAL	500 /* Minimum time between stats file
-									 * updates; in milliseconds. */
-
-#define PGSTAT_RETRY_DELAY		10	/* How long to wait between checks for a
-									 * new file; in milliseconds. */
-
-#define PGSTAT_MAX_WAIT_TIME	10000	/* Maximum time to wait for a stats
-										 * file update; in milliseconds. */
-
-#define PGSTAT_INQ_INTERVAL		640 /* How often to ping the collector for a
-									 * new file; in milliseconds. */
-
-#define PGSTAT_RESTART_INTERVAL 60	/* How often to attempt to restart a
-									 * failed statistics collector; in
-									 * seconds. */
-
-#define PGSTAT_POLL_LOOP_COUNT	(PGSTAT_MAX_WAIT_TIME / PGSTAT_RETRY_DELAY)
-#define PGSTAT_INQ_LOOP_COUNT	(PGSTAT_INQ_INTERVAL / PGSTAT_RETRY_DELAY)
-
-/* Minimum receive buffer size for the collector's socket. */
-#define PGSTAT_MIN_RCVBUF		(100 * 1024)
+#define PGSTAT_STAT_INTERVAL	500 /* Minimum time between flushes of the
+									 * local counts to shared memory; in
+									 * milliseconds. */
 
 
 /* ----------
- * The initial size hints for the hash tables used in the collector.
+ * The initial size hints for the local snapshot hash tables.
  * ----------
  */
 #define PGSTAT_DB_HASH_SIZE		16
 #define PGSTAT_TAB_HASH_SIZE	512
 #define PGSTAT_FUNCTION_HASH_SIZE	512
 
+/* ----------
+ * Space reserved in the main shared memory segment for the DSA area holding
+ * the shared hash tables, on top of the DSA control data.  The area grows
+ * into additional DSM segments when this is exhausted.
+ * ----------
+ */
+#define PGSTAT_DSA_INITIAL_SIZE	(256 * 1024)
+
 
 /* ----------
  * Total number of backends including auxiliary
@@ -127,36 +115,120 @@ bool		pgstat_track_counts = false;
 int			pgstat_track_functions = TRACK_FUNC_OFF;
 int			pgstat_track_activity_query_size = 1024;
 
-/* ----------
- * Built from GUC parameter
- * ----------
+/*
+ * BgWriter global statistics counters (unused in other processes).
+ * They are added to the shared totals by pgstat_send_bgwriter().
+ * We assume this inits to zeroes.
  */
-char	   *pgstat_stat_directory = NULL;
-char	   *pgstat_stat_filename = NULL;
-char	   *pgstat_stat_tmpname = NULL;
+PgStat_BgWriterCounts BgWriterStats;
 
 /*
- * BgWriter global statistics counters (unused in other processes).
- * Stored directly in a stats message structure so it can be sent
- * without needing to copy things around.  We assume this inits to zeroes.
+ * WAL generation counters of this process, added to the shared totals by
+ * pgstat_flush_wal().  We assume this inits to zeroes.
  */
-PgStat_MsgBgWriter BgWriterStats;
+PgStat_WalCounts WalStats;
 
 /* ----------
- * Local data
+ * Shared memory data structures
  * ----------
  */
-NON_EXEC_STATIC pgsocket pgStatSock = PGINVALID_SOCKET;
 
-static struct sockaddr_storage pgStatAddr;
+/*
+ * Control data of the shared statistics, in the main shared memory segment.
+ * The per-database, per-table and per-function statistics are kept in
+ * dshash tables in a DSA area that is created in place right after this
+ * struct, so that it exists as long as the main segment does.
+ *
+ * The global (bgwriter), archiver, WAL and I/O statistics are of fixed size, so
+ * they are kept here directly.  They are protected by spinlocks rather than
+ * LWLocks, because the archiver has no PGPROC.  The I/O statistics have a
+ * spinlock of their own, as every kind of process adds to them.
+ */
+struct PgStat_ShmemControl
+{
+	dshash_table_handle db_hash_handle;
+	dshash_table_handle tab_hash_handle;
+	dshash_table_handle func_hash_handle;
+
+	slock_t		mutex;			/* protects the following three fields */
+	PgStat_GlobalStats global_stats;
+	PgStat_ArchiverStats archiver_stats;
+	PgStat_WalStats wal_stats;
+
+	slock_t		io_mutex;		/* protects io_stats */
+	PgStat_IOStats io_stats;
+};
+
+#define PgStatDSAPlace(ctl) \
+	((char *) (ctl) + MAXALIGN(sizeof(PgStat_ShmemControl)))
+
+/*
+ * The shared hash tables for tables and functions hold the objects of all
+ * databases, so they are keyed by database OID as well as object OID.
+ * Shared catalogs are filed under InvalidOid.  The database hash table is
+ * keyed by the database OID that starts PgStat_StatDBEntry.
+ */
+typedef struct PgStat_HashKey
+{
+	Oid			databaseid;
+	Oid			objectid;
+} PgStat_HashKey;
+
+typedef struct PgStat_SharedTabEntry
+{
+	PgStat_HashKey key;
+	PgStat_StatTabEntry stats;
+} PgStat_SharedTabEntry;
+
+typedef struct PgStat_SharedFuncEntry
+{
+	PgStat_HashKey key;
+	PgStat_StatFuncEntry stats;
+} PgStat_SharedFuncEntry;
+
+static const dshash_parameters db_hash_params = {
+	sizeof(Oid),
+	sizeof(PgStat_StatDBEntry),
+	dshash_memcmp,
+	dshash_memhash,
+	LWTRANCHE_STATS_HASH
+};
+
+static const dshash_parameters tab_hash_params = {
+	sizeof(PgStat_HashKey),
+	sizeof(PgStat_SharedTabEntry),
+	dshash_memcmp,
+	dshash_memhash,
+	LWTRANCHE_STATS_HASH
+};
+
+static const dshash_parameters func_hash_params = {
+	sizeof(PgStat_HashKey),
+	sizeof(PgStat_SharedFuncEntry),
+	dshash_memcmp,
+	dshash_memhash,
+	LWTRANCHE_STATS_HASH
+};
+
+NON_EXEC_STATIC PgStat_ShmemControl *pgStatShmem = NULL;
 
-static time_t last_pgstat_start_time;
+/*
+ * This process's attachment to the shared hash tables, or NULL if we are
+ * not attached (because we haven't got that far, or are exiting).
+ */
+static dsa_area *pgStatArea = NULL;
+static dshash_table *pgStatDBShared = NULL;
+static dshash_table *pgStatTabShared = NULL;
+static dshash_table *pgStatFuncShared = NULL;
 
-static bool pgStatRunningInCollector = false;
+/* ----------
+ * Local data
+ * ----------
+ */
 
 /*
  * Structures in which backends store per-table info that's waiting to be
- * sent to the collector.
+ * flushed to shared memory.
  *
  * NOTE: once allocated, TabStatusArray structures are never moved or deleted
  * for the life of the backend.  Also, we zero out the t_id fields of the
@@ -191,14 +263,14 @@ typedef struct TabStatHashEntry
 static HTAB *pgStatTabHash = NULL;
 
 /*
- * Backends store per-function info that's waiting to be sent to the collector
- * in this hash table (indexed by function OID).
+ * Backends store per-function info that's waiting to be flushed to shared
+ * memory in this hash table (indexed by function OID).
  */
 static HTAB *pgStatFunctions = NULL;
 
 /*
  * Indicates if backend has some function stats that it hasn't yet
- * sent to the collector.
+ * flushed to shared memory.
  */
 static bool have_function_stats = false;
 
@@ -238,10 +310,14 @@ typedef struct TwoPhasePgStatRecord
 } TwoPhasePgStatRecord;
 
 /*
- * Info about current "snapshot" of stats file
+ * Info about the current "snapshot" of the shared statistics.  Entries are
+ * copied into these hash tables the first time they are looked at, and kept
+ * until pgstat_clear_snapshot().
  */
 static MemoryContext pgStatLocalContext = NULL;
-static HTAB *pgStatDBHash = NULL;
+static HTAB *pgStatDBSnapshot = NULL;
+static HTAB *pgStatTabSnapshot = NULL;
+static HTAB *pgStatFuncSnapshot = NULL;
 
 /* Status for backends including auxiliary */
 static LocalPgBackendStatus *localBackendStatusTable = NULL;
@@ -250,23 +326,21 @@ static LocalPgBackendStatus *localBackendStatusTable = NULL;
 static int	localNumBackends = 0;
 
 /*
- * Cluster wide statistics, kept in the stats collector.
- * Contains statistics that are not collected per database
- * or per table.
+ * Snapshot of the cluster wide statistics, that are not collected per
+ * database or per table.  Valid if have_global_snapshot is set.
  */
 static PgStat_ArchiverStats archiverStats;
 static PgStat_GlobalStats globalStats;
+static PgStat_WalStats walStats;
+static PgStat_IOStats ioStats;
+static bool have_global_snapshot = false;
 
 /*
- * List of OIDs of databases we need to write out.  If an entry is InvalidOid,
- * it means to write only the shared-catalog stats ("DB 0"); otherwise, we
- * will write both that DB's data and the shared stats.
+ * I/O counts of this process not yet added to the shared totals.  The
+ * backend type is implied; it is looked up when they are flushed.
  */
-static List *pending_write_requests = NIL;
-
-/* Signal handler flags */
-static volatile bool need_exit = false;
-static volatile bool got_SIGHUP = false;
+static PgStat_IOCounts pendingIOStats[IOOBJECT_NUM_TYPES][IOCONTEXT_NUM_TYPES];
+static bool have_iostats = false;
 
 /*
  * Total time charged to functions so far in the current backend.
@@ -280,35 +354,30 @@ static instr_time total_func_time;
  * Local function forward declarations
  * ----------
  */
-#ifdef EXEC_BACKEND
-static pid_t pgstat_forkexec(void);
-#endif
-
-NON_EXEC_STATIC void PgstatCollectorMain(int argc, char *argv[]) pg_attribute_noreturn();
-static void pgstat_exit(SIGNAL_ARGS);
+static void pgstat_attach_shmem(void);
+static void pgstat_detach_shmem(void);
+static void pgstat_shutdown_hook(int code, Datum arg);
 static void pgstat_beshutdown_hook(int code, Datum arg);
-static void pgstat_sighup_handler(SIGNAL_ARGS);
-
-static PgStat_StatDBEntry *pgstat_get_db_entry(Oid databaseid, bool create);
-static PgStat_StatTabEntry *pgstat_get_tab_entry(PgStat_StatDBEntry *dbentry,
-					 Oid tableoid, bool create);
-static void pgstat_write_statsfiles(bool permanent, bool allDbs);
-static void pgstat_write_db_statsfile(PgStat_StatDBEntry *dbentry, bool permanent);
-static HTAB *pgstat_read_statsfiles(Oid onlydb, bool permanent, bool deep);
-static void pgstat_read_db_statsfile(Oid databaseid, HTAB *tabhash, HTAB *funchash, bool permanent);
-static void backend_read_statsfile(void);
-static void pgstat_read_current_status(void);
 
-static bool pgstat_write_statsfile_needed(void);
-static bool pgstat_db_requested(Oid databaseid);
+static void reset_dbentry_counters(PgStat_StatDBEntry *dbentry);
+static PgStat_StatDBEntry *pgstat_get_db_entry(Oid databaseid);
+static PgStat_SharedTabEntry *pgstat_get_tab_entry(Oid databaseid,
+					 Oid tableoid);
+static void pgstat_drop_db_objects(Oid databaseid);
+static void pgstat_write_statsfile(void);
+static void pgstat_read_current_status(void);
 
-static void pgstat_send_tabstat(PgStat_MsgTabstat *tsmsg);
-static void pgstat_send_funcstats(void);
+static void pgstat_flush_tabstat(PgStat_TableStatus *entry,
+					 PgStat_StatDBEntry *dbsums);
+static void pgstat_flush_dbstat(Oid databaseid, PgStat_StatDBEntry *dbsums);
+static void pgstat_flush_funcstats(void);
 static HTAB *pgstat_collect_oids(Oid catalogid, AttrNumber anum_oid);
 
 static PgStat_TableStatus *get_tabstat_entry(Oid rel_id, bool isshared);
 
 static void pgstat_setup_memcxt(void);
+static void pgstat_setup_snapshot(void);
+static void pgstat_snapshot_global(void);
 
 static const char *pgstat_get_wait_activity(WaitEventActivity w);
 static const char *pgstat_get_wait_client(WaitEventClient w);
@@ -316,320 +385,108 @@ static const char *pgstat_get_wait_ipc(WaitEventIPC w);
 static const char *pgstat_get_wait_timeout(WaitEventTimeout w);
 static const char *pgstat_get_wait_io(WaitEventIO w);
 
-static void pgstat_setheader(PgStat_MsgHdr *hdr, StatMsgType mtype);
-static void pgstat_send(void *msg, int len);
-
-static void pgstat_recv_inquiry(PgStat_MsgInquiry *msg, int len);
-static void pgstat_recv_tabstat(PgStat_MsgTabstat *msg, int len);
-static void pgstat_recv_tabpurge(PgStat_MsgTabpurge *msg, int len);
-static void pgstat_recv_dropdb(PgStat_MsgDropdb *msg, int len);
-static void pgstat_recv_resetcounter(PgStat_MsgResetcounter *msg, int len);
-static void pgstat_recv_resetsharedcounter(PgStat_MsgResetsharedcounter *msg, int len);
-static void pgstat_recv_resetsinglecounter(PgStat_MsgResetsinglecounter *msg, int len);
-static void pgstat_recv_autovac(PgStat_MsgAutovacStart *msg, int len);
-static void pgstat_recv_vacuum(PgStat_MsgVacuum *msg, int len);
-static void pgstat_recv_analyze(PgStat_MsgAnalyze *msg, int len);
-static void pgstat_recv_archiver(PgStat_MsgArchiver *msg, int len);
-static void pgstat_recv_bgwriter(PgStat_MsgBgWriter *msg, int len);
-static void pgstat_recv_funcstat(PgStat_MsgFuncstat *msg, int len);
-static void pgstat_recv_funcpurge(PgStat_MsgFuncpurge *msg, int len);
-static void pgstat_recv_recoveryconflict(PgStat_MsgRecoveryConflict *msg, int len);
-static void pgstat_recv_deadlock(PgStat_MsgDeadlock *msg, int len);
-static void pgstat_recv_tempfile(PgStat_MsgTempFile *msg, int len);
-
 /* ------------------------------------------------------------
  * Public functions called from postmaster follow
  * ------------------------------------------------------------
  */
 
-/* ----------
- * pgstat_init() -
- *
- *	Called from postmaster at startup. Create the resources required
- *	by the statistics collector process.  If unable to do so, do not
- *	fail --- better to let the postmaster start with stats collection
- *	disabled.
- * ----------
+/*
+ * Size of the in-place DSA area for the shared hash tables
  */
-void
-pgstat_init(void)
+static Size
+pgstat_dsa_init_size(void)
 {
-	ACCEPT_TYPE_ARG3 alen;
-	struct addrinfo *addrs = NULL,
-			   *addr,
-				hints;
-	int			ret;
-	fd_set		rset;
-	struct timeval tv;
-	char		test_byte;
-	int			sel_res;
-	int			tries = 0;
-
-#define TESTBYTEVAL ((char) 199)
-
-	/*
-	 * This static assertion verifies that we didn't mess up the calculations
-	 * involved in selecting maximum payload sizes for our UDP messages.
-	 * Because the only consequence of overrunning PGSTAT_MAX_MSG_SIZE would
-	 * be silent performance loss from fragmentation, it seems worth having a
-	 * compile-time cross-check that we didn't.
-	 */
-	StaticAssertStmt(sizeof(PgStat_Msg) <= PGSTAT_MAX_MSG_SIZE,
-					 "maximum stats message size exceeds PGSTAT_MAX_MSG_SIZE");
-
-	/*
-	 * Create the UDP socket for sending and receiving statistic messages
-	 */
-	hints.ai_flags = AI_PASSIVE;
-	hints.ai_family = AF_UNSPEC;
-	hints.ai_socktype = SOCK_DGRAM;
-	hints.ai_protocol = 0;
-	hints.ai_addrlen = 0;
-	hints.ai_addr = NULL;
-	hints.ai_canonname = NULL;
-	hints.ai_next = NULL;
-	ret = pg_getaddrinfo_all("localhost", NULL, &hints, &addrs);
-	if (ret || !addrs)
-	{
-		ereport(LOG,
-				(errmsg("could not resolve \"localhost\": %s",
-						gai_strerror(ret))));
-		goto startup_failed;
-	}
+	return MAXALIGN(dsa_minimum_size() + PGSTAT_DSA_INITIAL_SIZE);
+}
 
-	/*
-	 * On some platforms, pg_getaddrinfo_all() may return multiple addresses
-	 * only one of which will actually work (eg, both IPv6 and IPv4 addresses
-	 * when kernel will reject IPv6).  Worse, the failure may occur at the
-	 * bind() or perhaps even connect() stage.  So we must loop through the
-	 * results till we find a working combination. We will generate LOG
-	 * messages, but no error, for bogus combinations.
-	 */
-	for (addr = addrs; addr; addr = addr->ai_next)
-	{
-#ifdef HAVE_UNIX_SOCKETS
-		/* Ignore AF_UNIX sockets, if any are returned. */
-		if (addr->ai_family == AF_UNIX)
-			continue;
-#endif
+/*
+ * StatsShmemSize
+ *		Compute space needed for the shared statistics
+ */
+Size
+StatsShmemSize(void)
+{
+	Size		size;
 
-		if (++tries > 1)
-			ereport(LOG,
-					(errmsg("trying another address for the statistics collector")));
+	size = MAXALIGN(sizeof(PgStat_ShmemControl));
+	size = add_size(size, pgstat_dsa_init_size());
 
-		/*
-		 * Create the socket.
-		 */
-		if ((pgStatSock = socket(addr->ai_family, SOCK_DGRAM, 0)) == PGINVALID_SOCKET)
-		{
-			ereport(LOG,
-					(errcode_for_socket_access(),
-					 errmsg("could not create socket for statistics collector: %m")));
-			continue;
-		}
+	return size;
+}
 
-		/*
-		 * Bind it to a kernel assigned port on localhost and get the assigned
-		 * port via getsockname().
-		 */
-		if (bind(pgStatSock, addr->ai_addr, addr->ai_addrlen) < 0)
-		{
-			ereport(LOG,
-					(errcode_for_socket_access(),
-					 errmsg("could not bind socket for statistics collector: %m")));
-			closesocket(pgStatSock);
-			pgStatSock = PGINVALID_SOCKET;
-			continue;
-		}
+/*
+ * StatsShmemInit
+ *		Allocate and initialize the shared statistics
+ *
+ * The postmaster (or a standalone backend) creates the DSA area and the hash
+ * tables in it; backends attach to them in pgstat_initialize().
+ */
+void
+StatsShmemInit(void)
+{
+	bool		found;
 
-		alen = sizeof(pgStatAddr);
-		if (getsockname(pgStatSock, (struct sockaddr *) &pgStatAddr, &alen) < 0)
-		{
-			ereport(LOG,
-					(errcode_for_socket_access(),
-					 errmsg("could not get address of socket for statistics collector: %m")));
-			closesocket(pgStatSock);
-			pgStatSock = PGINVALID_SOCKET;
-			continue;
-		}
+	pgStatShmem = (PgStat_ShmemControl *)
+		ShmemInitStruct("Shared Statistics", StatsShmemSize(), &found);
 
-		/*
-		 * Connect the socket to its own address.  This saves a few cycles by
-		 * not having to respecify the target address on every send. This also
-		 * provides a kernel-level check that only packets from this same
-		 * address will be received.
-		 */
-		if (connect(pgStatSock, (struct sockaddr *) &pgStatAddr, alen) < 0)
-		{
-			ereport(LOG,
-					(errcode_for_socket_access(),
-					 errmsg("could not connect socket for statistics collector: %m")));
-			closesocket(pgStatSock);
-			pgStatSock = PGINVALID_SOCKET;
-			continue;
-		}
+	if (!IsUnderPostmaster)
+	{
+		dsa_area   *area;
+		dshash_table *dsh;
 
-		/*
-		 * Try to send and receive a one-byte test message on the socket. This
-		 * is to catch situations where the socket can be created but will not
-		 * actually pass data (for instance, because kernel packet filtering
-		 * rules prevent it).
-		 */
-		test_byte = TESTBYTEVAL;
+		Assert(!found);
 
-retry1:
-		if (send(pgStatSock, &test_byte, 1, 0) != 1)
-		{
-			if (errno == EINTR)
-				goto retry1;	/* if interrupted, just retry */
-			ereport(LOG,
-					(errcode_for_socket_access(),
-					 errmsg("could not send test message on socket for statistics collector: %m")));
-			closesocket(pgStatSock);
-			pgStatSock = PGINVALID_SOCKET;
-			continue;
-		}
+		area = dsa_create_in_place(PgStatDSAPlace(pgStatShmem),
+								   pgstat_dsa_init_size(),
+								   LWTRANCHE_STATS_DSA, NULL);
+		dsa_pin(area);
 
 		/*
-		 * There could possibly be a little delay before the message can be
-		 * received.  We arbitrarily allow up to half a second before deciding
-		 * it's broken.
+		 * Limit the area to its in-place part while creating the hash
+		 * tables, so that they are sure to end up in the main shared memory
+		 * segment rather than in a DSM segment created by the postmaster.
 		 */
-		for (;;)				/* need a loop to handle EINTR */
-		{
-			FD_ZERO(&rset);
-			FD_SET(pgStatSock, &rset);
-
-			tv.tv_sec = 0;
-			tv.tv_usec = 500000;
-			sel_res = select(pgStatSock + 1, &rset, NULL, NULL, &tv);
-			if (sel_res >= 0 || errno != EINTR)
-				break;
-		}
-		if (sel_res < 0)
-		{
-			ereport(LOG,
-					(errcode_for_socket_access(),
-					 errmsg("select() failed in statistics collector: %m")));
-			closesocket(pgStatSock);
-			pgStatSock = PGINVALID_SOCKET;
-			continue;
-		}
-		if (sel_res == 0 || !FD_ISSET(pgStatSock, &rset))
-		{
-			/*
-			 * This is the case we actually think is likely, so take pains to
-			 * give a specific message for it.
-			 *
-			 * errno will not be set meaningfully here, so don't use it.
-			 */
-			ereport(LOG,
-					(errcode(ERRCODE_CONNECTION_FAILURE),
-					 errmsg("test message did not get through on socket for statistics collector")));
-			closesocket(pgStatSock);
-			pgStatSock = PGINVALID_SOCKET;
-			continue;
-		}
-
-		test_byte++;			/* just make sure variable is changed */
-
-retry2:
-		if (recv(pgStatSock, &test_byte, 1, 0) != 1)
-		{
-			if (errno == EINTR)
-				goto retry2;	/* if interrupted, just retry */
-			ereport(LOG,
-					(errcode_for_socket_access(),
-					 errmsg("could not receive test message on socket for statistics collector: %m")));
-			closesocket(pgStatSock);
-			pgStatSock = PGINVALID_SOCKET;
-			continue;
-		}
-
-		if (test_byte != TESTBYTEVAL)	/* strictly paranoia ... */
-		{
-			ereport(LOG,
-					(errcode(ERRCODE_INTERNAL_ERROR),
-					 errmsg("incorrect test message transmission on socket for statistics collector")));
-			closesocket(pgStatSock);
-			pgStatSock = PGINVALID_SOCKET;
-			continue;
-		}
-
-		/* If we get here, we have a working socket */
-		break;
-	}
-
-	/* Did we find a working address? */
-	if (!addr || pgStatSock == PGINVALID_SOCKET)
-		goto startup_failed;
-
-	/*
-	 * Set the socket to non-blocking IO.  This ensures that if the collector
-	 * falls behind, statistics messages will be discarded; backends won't
-	 * block waiting to send messages to the collector.
-	 */
-	if (!pg_set_noblock(pgStatSock))
-	{
-		ereport(LOG,
-				(errcode_for_socket_access(),
-				 errmsg("could not set statistics collector socket to nonblocking mode: %m")));
-		goto startup_failed;
-	}
-
-	/*
-	 * Try to ensure that the socket's receive buffer is at least
-	 * PGSTAT_MIN_RCVBUF bytes, so that it won't easily overflow and lose
-	 * data.  Use of UDP protocol means that we are willing to lose data under
-	 * heavy load, but we don't want it to happen just because of ridiculously
-	 * small default buffer sizes (such as 8KB on older Windows versions).
-	 */
-	{
-		int			old_rcvbuf;
-		int			new_rcvbuf;
-		ACCEPT_TYPE_ARG3 rcvbufsize = sizeof(old_rcvbuf);
-
-		if (getsockopt(pgStatSock, SOL_SOCKET, SO_RCVBUF,
-					   (char *) &old_rcvbuf, &rcvbufsize) < 0)
-		{
-			elog(LOG, "getsockopt(SO_RCVBUF) failed: %m");
-			/* if we can't get existing size, always try to set it */
-			old_rcvbuf = 0;
-		}
-
-		new_rcvbuf = PGSTAT_MIN_RCVBUF;
-		if (old_rcvbuf < new_rcvbuf)
-		{
-			if (setsockopt(pgStatSock, SOL_SOCKET, SO_RCVBUF,
-						   (char *) &new_rcvbuf, sizeof(new_rcvbuf)) < 0)
-				elog(LOG, "setsockopt(SO_RCVBUF) failed: %m");
-		}
+		dsa_set_size_limit(area, pgstat_dsa_init_size());
+
+		dsh = dshash_create(area, &db_hash_params, NULL);
+		pgStatShmem->db_hash_handle = dshash_get_hash_table_handle(dsh);
+		dshash_detach(dsh);
+
+		dsh = dshash_create(area, &tab_hash_params, NULL);
+		pgStatShmem->tab_hash_handle = dshash_get_hash_table_handle(dsh);
+		dshash_detach(dsh);
+
+		dsh = dshash_create(area, &func_hash_params, NULL);
+		pgStatShmem->func_hash_handle = dshash_get_hash_table_handle(dsh);
+		dshash_detach(dsh);
+
+		dsa_set_size_limit(area, -1);
+		dsa_detach(area);
+
+		SpinLockInit(&pgStatShmem->mutex);
+		MemSet(&pgStatShmem->global_stats, 0, sizeof(PgStat_GlobalStats));
+		MemSet(&pgStatShmem->archiver_stats, 0, sizeof(PgStat_ArchiverStats));
+		pgStatShmem->global_stats.stat_reset_timestamp = GetCurrentTimestamp();
+		pgStatShmem->archiver_stats.stat_reset_timestamp =
+			pgStatShmem->global_stats.stat_reset_timestamp;
+		MemSet(&pgStatShmem->wal_stats, 0, sizeof(PgStat_WalStats));
+		pgStatShmem->wal_stats.stat_reset_timestamp =
+			pgStatShmem->global_stats.stat_reset_timestamp;
+
+		SpinLockInit(&pgStatShmem->io_mutex);
+		MemSet(&pgStatShmem->io_stats, 0, sizeof(PgStat_IOStats));
+		pgStatShmem->io_stats.stat_reset_timestamp =
+			pgStatShmem->global_stats.stat_reset_timestamp;
 	}
-
-	pg_freeaddrinfo_all(hints.ai_family, addrs);
-
-	return;
-
-startup_failed:
-	ereport(LOG,
-			(errmsg("disabling statistics collector for lack of working socket")));
-
-	if (addrs)
-		pg_freeaddrinfo_all(hints.ai_family, addrs);
-
-	if (pgStatSock != PGINVALID_SOCKET)
-		closesocket(pgStatSock);
-	pgStatSock = PGINVALID_SOCKET;
-
-	/*
-	 * Adjust GUC variables to suppress useless activity, and for debugging
-	 * purposes (seeing track_counts off is a clue that we failed here). We
-	 * use PGC_S_OVERRIDE because there is no point in trying to turn it back
-	 * on from postgresql.conf without a restart.
-	 */
-	SetConfigOption("track_counts", "off", PGC_INTERNAL, PGC_S_OVERRIDE);
+	else
+		Assert(found);
 }
 
+/* ------------------------------------------------------------
+ * Functions called from the startup process and at server shutdown follow
+ * ------------------------------------------------------------
+ */
+
 /*
  * subroutine for pgstat_reset_all
  */
@@ -647,8 +504,8 @@ pgstat_reset_remove_files(const char *directory)
 		Oid			tmp_oid;
 
 		/*
-		 * Skip directory entries that don't match the file names we write.
-		 * See get_dbstat_filename for the database-specific pattern.
+		 * Skip directory entries that don't match the file names we write,
+		 * or that older releases wrote per database.
 		 */
 		if (strncmp(entry->d_name, "global.", 7) == 0)
 			nchars = 7;
@@ -679,120 +536,206 @@ pgstat_reset_remove_files(const char *directory)
  * pgstat_reset_all() -
  *
  * Remove the stats files.  This is currently used only if WAL
- * recovery is needed after a crash.
+ * recovery is needed after a crash, in which case the shared statistics
+ * are empty anyway since shared memory has just been created.
  */
 void
 pgstat_reset_all(void)
 {
-	pgstat_reset_remove_files(pgstat_stat_directory);
 	pgstat_reset_remove_files(PGSTAT_STAT_PERMANENT_DIRECTORY);
 }
 
-#ifdef EXEC_BACKEND
-
-/*
- * pgstat_forkexec() -
+/* ----------
+ * pgstat_restore_stats() -
  *
- * Format up the arglist for, then fork and exec, statistics collector process
+ *	Load the statistics saved by the last clean shutdown into shared memory,
+ *	then remove the file; the shared memory contents are now
+ *	authoritative, and the file would be out of date after a crash.
+ *	Called by the startup process (or a standalone backend) when no WAL
+ *	recovery is needed.
+ * ----------
  */
-static pid_t
-pgstat_forkexec(void)
+void
+pgstat_restore_stats(void)
 {
-	char	   *av[10];
-	int			ac = 0;
-
-	av[ac++] = "postgres";
-	av[ac++] = "--forkcol";
-	av[ac++] = NULL;			/* filled in by postmaster_forkexec */
-
-	av[ac] = NULL;
-	Assert(ac < lengthof(av));
-
-	return postmaster_forkexec(ac, av);
-}
-#endif							/* EXEC_BACKEND */
-
+	PgStat_StatDBEntry dbbuf;
+	PgStat_SharedTabEntry tabbuf;
+	PgStat_SharedFuncEntry funcbuf;
+	PgStat_GlobalStats global;
+	PgStat_ArchiverStats archiver;
+	FILE	   *fpin;
+	int32		format_id;
+	bool		found;
+	const char *statfile = PGSTAT_STAT_PERMANENT_FILENAME;
 
-/*
- * pgstat_start() -
- *
- *	Called from postmaster at startup or after an existing collector
- *	died.  Attempt to fire up a fresh statistics collector.
- *
- *	Returns PID of child process, or 0 if fail.
- *
- *	Note: if fail, we will be called again from the postmaster main loop.
- */
-int
-pgstat_start(void)
-{
-	time_t		curtime;
-	pid_t		pgStatPid;
+	pgstat_attach_shmem();
 
 	/*
-	 * Check that the socket is there, else pgstat_init failed and we can do
-	 * nothing useful.
+	 * Try to open the stats file.  If it doesn't exist, we simply start from
+	 * scratch with empty counters.
 	 */
-	if (pgStatSock == PGINVALID_SOCKET)
-		return 0;
+	if ((fpin = AllocateFile(statfile, PG_BINARY_R)) == NULL)
+	{
+		if (errno != ENOENT)
+			ereport(LOG,
+					(errcode_for_file_access(),
+					 errmsg("could not open statistics file \"%s\": %m",
+							statfile)));
+		return;
+	}
 
 	/*
-	 * Do nothing if too soon since last collector start.  This is a safety
-	 * valve to protect against continuous respawn attempts if the collector
-	 * is dying immediately at launch.  Note that since we will be re-called
-	 * from the postmaster main loop, we will get another chance later.
+	 * Verify it's of the expected format.
 	 */
-	curtime = time(NULL);
-	if ((unsigned int) (curtime - last_pgstat_start_time) <
-		(unsigned int) PGSTAT_RESTART_INTERVAL)
-		return 0;
-	last_pgstat_start_time = curtime;
+	if (fread(&format_id, 1, sizeof(format_id), fpin) != sizeof(format_id) ||
+		format_id != PGSTAT_FILE_FORMAT_ID)
+	{
+		ereport(LOG,
+				(errmsg("corrupted statistics file \"%s\"", statfile)));
+		goto done;
+	}
 
 	/*
-	 * Okay, fork off the collector.
+	 * Read global, archiver, WAL and I/O stats structs
 	 */
-#ifdef EXEC_BACKEND
-	switch ((pgStatPid = pgstat_forkexec()))
-#else
-	switch ((pgStatPid = fork_process()))
-#endif
+	if (fread(&global, 1, sizeof(global), fpin) != sizeof(global) ||
+		fread(&archiver, 1, sizeof(archiver), fpin) != sizeof(archiver) ||
+		fread(&walStats, 1, sizeof(walStats), fpin) != sizeof(walStats) ||
+		fread(&ioStats, 1, sizeof(ioStats), fpin) != sizeof(ioStats))
 	{
-		case -1:
-			ereport(LOG,
-					(errmsg("could not fork statistics collector: %m")));
-			return 0;
+		ereport(LOG,
+				(errmsg("corrupted statistics file \"%s\"", statfile)));
+		goto done;
+	}
+
+	global.stats_timestamp = 0;
+	SpinLockAcquire(&pgStatShmem->mutex);
+	memcpy(&pgStatShmem->global_stats, &global, sizeof(global));
+	memcpy(&pgStatShmem->archiver_stats, &archiver, sizeof(archiver));
+	memcpy(&pgStatShmem->wal_stats, &walStats, sizeof(walStats));
+	SpinLockRelease(&pgStatShmem->mutex);
 
-#ifndef EXEC_BACKEND
-		case 0:
-			/* in postmaster child ... */
-			InitPostmasterChild();
+	SpinLockAcquire(&pgStatShmem->io_mutex);
+	memcpy(&pgStatShmem->io_stats, &ioStats, sizeof(ioStats));
+	SpinLockRelease(&pgStatShmem->io_mutex);
+
+	/*
+	 * Read the database, table and function entries, and put them into
+	 * place.
+	 */
+	for (;;)
+	{
+		switch (fgetc(fpin))
+		{
+				/*
+				 * 'D'	A PgStat_StatDBEntry struct describing a database
+				 * follows.
+				 */
+			case 'D':
+				{
+					PgStat_StatDBEntry *dbentry;
+
+					if (fread(&dbbuf, 1, sizeof(dbbuf), fpin) != sizeof(dbbuf))
+						goto corrupted;
+
+					dbentry = (PgStat_StatDBEntry *)
+						dshash_find_or_insert(pgStatDBShared,
+											  &dbbuf.databaseid, &found);
+					if (!found)
+						memcpy(dbentry, &dbbuf, sizeof(dbbuf));
+					dshash_release_lock(pgStatDBShared, dbentry);
+					if (found)
+						goto corrupted;
+					break;
+				}
 
-			/* Close the postmaster's sockets */
-			ClosePostmasterPorts(false);
+				/*
+				 * 'T'	A PgStat_StatTabEntry follows, with its hash key.
+				 */
+			case 'T':
+				{
+					PgStat_SharedTabEntry *tabentry;
+
+					if (fread(&tabbuf, 1, sizeof(tabbuf), fpin) != sizeof(tabbuf))
+						goto corrupted;
+
+					tabentry = (PgStat_SharedTabEntry *)
+						dshash_find_or_insert(pgStatTabShared,
+											  &tabbuf.key, &found);
+					if (!found)
+						memcpy(tabentry, &tabbuf, sizeof(tabbuf));
+					dshash_release_lock(pgStatTabShared, tabentry);
+					if (found)
+						goto corrupted;
+					break;
+				}
 
-			/* Drop our connection to postmaster's shared memory, as well */
-			dsm_detach_all();
-			PGSharedMemoryDetach();
+				/*
+				 * 'F'	A PgStat_StatFuncEntry follows, with its hash key.
+				 */
+			case 'F':
+				{
+					PgStat_SharedFuncEntry *funcentry;
+
+					if (fread(&funcbuf, 1, sizeof(funcbuf), fpin) != sizeof(funcbuf))
+						goto corrupted;
+
+					funcentry = (PgStat_SharedFuncEntry *)
+						dshash_find_or_insert(pgStatFuncShared,
+											  &funcbuf.key, &found);
+					if (!found)
+						memcpy(funcentry, &funcbuf, sizeof(funcbuf));
+					dshash_release_lock(pgStatFuncShared, funcentry);
+					if (found)
+						goto corrupted;
+					break;
+				}
 
-			PgstatCollectorMain(0, NULL);
-			break;
-#endif
+			case 'E':
+				goto done;
 
-		default:
-			return (int) pgStatPid;
+			default:
+				goto corrupted;
+		}
 	}
 
-	/* shouldn't get here */
-	return 0;
-}
+corrupted:
+	ereport(LOG,
+			(errmsg("corrupted statistics file \"%s\"", statfile)));
 
-void
-allow_immediate_pgstat_restart(void)
-{
-	last_pgstat_start_time = 0;
+done:
+	FreeFile(fpin);
+
+	elog(DEBUG2, "removing permanent stats file \"%s\"", statfile);
+	unlink(statfile);
 }
 
-/* ------------------------------------------------------------
+/* ----------
+ * pgstat_before_server_shutdown() -
+ *
+ *	Save the shared statistics, so that they survive a clean shutdown.
+ *	Called by the checkpointer after the shutdown checkpoint, and in a
+ *	standalone backend as a before_shmem_exit callback.  Nothing is written
+ *	when exiting because of an error, since the statistics of a crashed
+ *	server are thrown away anyway.
+ * ----------
+ */
+void
+pgstat_before_server_shutdown(int code, Datum arg)
+{
+	if (pgStatArea == NULL)
+		return;
+
+	/* Don't lose whatever this process itself has done */
+	if (OidIsValid(MyDatabaseId))
+		pgstat_report_stat(true);
+
+	if (code == 0)
+		pgstat_write_statsfile();
+}
+
+
+/* ------------------------------------------------------------
  * Public functions used by backends follow
  *------------------------------------------------------------
  */
@@ -802,9 +745,9 @@ allow_immediate_pgstat_restart(void)
  * pgstat_report_stat() -
  *
  *	Must be called by processes that performs DML: tcop/postgres.c, logical
- *	receiver processes, SPI worker, etc. to send the so far collected
- *	per-table and function usage statistics to the collector.  Note that this
- *	is called only when not within a transaction, so it is fair to use
+ *	receiver processes, SPI worker, etc. to flush the so far collected
+ *	per-table and function usage statistics to shared memory.  Note that
+ *	this is called only when not within a transaction, so it is fair to use
  *	transaction stop time as an approximation of current time.
  * ----------
  */
@@ -816,20 +759,32 @@ pgstat_report_stat(bool force)
 	static TimestampTz last_report = 0;
 
 	TimestampTz now;
-	PgStat_MsgTabstat regular_msg;
-	PgStat_MsgTabstat shared_msg;
+	PgStat_StatDBEntry regular_sums;
+	PgStat_StatDBEntry shared_sums;
+	bool		have_regular = false;
+	bool		have_shared = false;
 	TabStatusArray *tsa;
 	int			i;
 
+	/* Lock timing, I/O and WAL counts are flushed on their own schedule */
+	LockStatsFlush(force);
+	pgstat_flush_io(force);
+	pgstat_flush_wal(force);
+
 	/* Don't expend a clock check if nothing to do */
 	if ((pgStatTabList == NULL || pgStatTabList->tsa_used == 0) &&
 		pgStatXactCommit == 0 && pgStatXactRollback == 0 &&
 		!have_function_stats)
 		return;
 
+	/* It's unlikely we'd get here unattached, but maybe not impossible */
+	if (pgStatArea == NULL)
+		return;
+
 	/*
-	 * Don't send a message unless it's been at least PGSTAT_STAT_INTERVAL
-	 * msec since we last sent one, or the caller wants to force stats out.
+	 * Don't flush unless it's been at least PGSTAT_STAT_INTERVAL msec since
+	 * we last did, or the caller wants to force stats out.  This bounds the
+	 * traffic on the shared hash tables' locks.
 	 */
 	now = GetCurrentTransactionStopTimestamp();
 	if (!force &&
@@ -850,22 +805,18 @@ pgstat_report_stat(bool force)
 
 	/*
 	 * Scan through the TabStatusArray struct(s) to find tables that actually
-	 * have counts, and build messages to send.  We have to separate shared
-	 * relations from regular ones because the databaseid field in the message
-	 * header has to depend on that.
+	 * have counts, and add those into the shared table entries.  The
+	 * database-wide sums are accumulated locally, separately for shared
+	 * relations, and added to the database entries once at the end.
 	 */
-	regular_msg.m_databaseid = MyDatabaseId;
-	shared_msg.m_databaseid = InvalidOid;
-	regular_msg.m_nentries = 0;
-	shared_msg.m_nentries = 0;
+	MemSet(&regular_sums, 0, sizeof(PgStat_StatDBEntry));
+	MemSet(&shared_sums, 0, sizeof(PgStat_StatDBEntry));
 
 	for (tsa = pgStatTabList; tsa != NULL; tsa = tsa->tsa_next)
 	{
 		for (i = 0; i < tsa->tsa_used; i++)
 		{
 			PgStat_TableStatus *entry = &tsa->tsa_entries[i];
-			PgStat_MsgTabstat *this_msg;
-			PgStat_TableEntry *this_ent;
 
 			/* Shouldn't have any pending transaction-dependent counts */
 			Assert(entry->trans == NULL);
@@ -878,18 +829,15 @@ pgstat_report_stat(bool force)
 					   sizeof(PgStat_TableCounts)) == 0)
 				continue;
 
-			/*
-			 * OK, insert data into the appropriate message, and send if full.
-			 */
-			this_msg = entry->t_shared ? &shared_msg : &regular_msg;
-			this_ent = &this_msg->m_entry[this_msg->m_nentries];
-			this_ent->t_id = entry->t_id;
-			memcpy(&this_ent->t_counts, &entry->t_counts,
-				   sizeof(PgStat_TableCounts));
-			if (++this_msg->m_nentries >= PGSTAT_NUM_TABENTRIES)
+			if (entry->t_shared)
 			{
-				pgstat_send_tabstat(this_msg);
-				this_msg->m_nentries = 0;
+				pgstat_flush_tabstat(entry, &shared_sums);
+				have_shared = true;
+			}
+			else
+			{
+				pgstat_flush_tabstat(entry, &regular_sums);
+				have_regular = true;
 			}
 		}
 		/* zero out TableStatus structs after use */
@@ -899,115 +847,160 @@ pgstat_report_stat(bool force)
 	}
 
 	/*
-	 * Send partial messages.  Make sure that any pending xact commit/abort
-	 * gets counted, even if there are no table stats to send.
+	 * Flush the database-wide counts.  Make sure that any pending xact
+	 * commit/abort gets counted, even if there are no table stats.  The
+	 * accumulated xact and I/O timing counts always go to our own database.
 	 */
-	if (regular_msg.m_nentries > 0 ||
-		pgStatXactCommit > 0 || pgStatXactRollback > 0)
-		pgstat_send_tabstat(&regular_msg);
-	if (shared_msg.m_nentries > 0)
-		pgstat_send_tabstat(&shared_msg);
-
-	/* Now, send function statistics */
-	pgstat_send_funcstats();
+	if (have_regular || pgStatXactCommit > 0 || pgStatXactRollback > 0)
+	{
+		regular_sums.n_xact_commit = pgStatXactCommit;
+		regular_sums.n_xact_rollback = pgStatXactRollback;
+		regular_sums.n_block_read_time = pgStatBlockReadTime;
+		regular_sums.n_block_write_time = pgStatBlockWriteTime;
+		pgStatXactCommit = 0;
+		pgStatXactRollback = 0;
+		pgStatBlockReadTime = 0;
+		pgStatBlockWriteTime = 0;
+
+		pgstat_flush_dbstat(MyDatabaseId, &regular_sums);
+	}
+	if (have_shared)
+		pgstat_flush_dbstat(InvalidOid, &shared_sums);
+
+	/* Now, flush function statistics */
+	pgstat_flush_funcstats();
 }
 
 /*
- * Subroutine for pgstat_report_stat: finish and send a tabstat message
+ * Subroutine for pgstat_report_stat: add one table's counts into its shared
+ * entry, and into the database-wide sums in *dbsums
  */
 static void
-pgstat_send_tabstat(PgStat_MsgTabstat *tsmsg)
+pgstat_flush_tabstat(PgStat_TableStatus *entry, PgStat_StatDBEntry *dbsums)
 {
-	int			n;
-	int			len;
+	PgStat_TableCounts *counts = &entry->t_counts;
+	PgStat_SharedTabEntry *shent;
+	PgStat_StatTabEntry *tabentry;
 
-	/* It's unlikely we'd get here with no socket, but maybe not impossible */
-	if (pgStatSock == PGINVALID_SOCKET)
-		return;
+	shent = pgstat_get_tab_entry(entry->t_shared ? InvalidOid : MyDatabaseId,
+								 entry->t_id);
+	tabentry = &shent->stats;
+
+	tabentry->numscans += counts->t_numscans;
+	tabentry->tuples_returned += counts->t_tuples_returned;
+	tabentry->tuples_fetched += counts->t_tuples_fetched;
+	tabentry->tuples_inserted += counts->t_tuples_inserted;
+	tabentry->tuples_updated += counts->t_tuples_updated;
+	tabentry->tuples_deleted += counts->t_tuples_deleted;
+	tabentry->tuples_hot_updated += counts->t_tuples_hot_updated;
+	/* If table was truncated, first reset the live/dead counters */
+	if (counts->t_truncated)
+	{
+		tabentry->n_live_tuples = 0;
+		tabentry->n_dead_tuples = 0;
+	}
+	tabentry->n_live_tuples += counts->t_delta_live_tuples;
+	tabentry->n_dead_tuples += counts->t_delta_dead_tuples;
+	tabentry->changes_since_analyze += counts->t_changed_tuples;
+	tabentry->inserts_since_vacuum += counts->t_tuples_inserted;
+	tabentry->blocks_fetched += counts->t_blocks_fetched;
+	tabentry->blocks_hit += counts->t_blocks_hit;
+
+	/* Clamp n_live_tuples in case of negative delta_live_tuples */
+	tabentry->n_live_tuples = Max(tabentry->n_live_tuples, 0);
+	/* Likewise for n_dead_tuples */
+	tabentry->n_dead_tuples = Max(tabentry->n_dead_tuples, 0);
+
+	dshash_release_lock(pgStatTabShared, shent);
 
 	/*
-	 * Report and reset accumulated xact commit/rollback and I/O timings
-	 * whenever we send a normal tabstat message
+	 * Add per-table stats to the per-database sums, too.
 	 */
-	if (OidIsValid(tsmsg->m_databaseid))
-	{
-		tsmsg->m_xact_commit = pgStatXactCommit;
-		tsmsg->m_xact_rollback = pgStatXactRollback;
-		tsmsg->m_block_read_time = pgStatBlockReadTime;
-		tsmsg->m_block_write_time = pgStatBlockWriteTime;
-		pgStatXactCommit = 0;
-		pgStatXactRollback = 0;
-		pgStatBlockReadTime = 0;
-		pgStatBlockWriteTime = 0;
-	}
-	else
-	{
-		tsmsg->m_xact_commit = 0;
-		tsmsg->m_xact_rollback = 0;
-		tsmsg->m_block_read_time = 0;
-		tsmsg->m_block_write_time = 0;
-	}
+	dbsums->n_tuples_returned += counts->t_tuples_returned;
+	dbsums->n_tuples_fetched += counts->t_tuples_fetched;
+	dbsums->n_tuples_inserted += counts->t_tuples_inserted;
+	dbsums->n_tuples_updated += counts->t_tuples_updated;
+	dbsums->n_tuples_deleted += counts->t_tuples_deleted;
+	dbsums->n_blocks_fetched += counts->t_blocks_fetched;
+	dbsums->n_blocks_hit += counts->t_blocks_hit;
+}
 
-	n = tsmsg->m_nentries;
-	len = offsetof(PgStat_MsgTabstat, m_entry[0]) +
-		n * sizeof(PgStat_TableEntry);
+/*
+ * Subroutine for pgstat_report_stat: add the sums of pgstat_flush_tabstat,
+ * and the xact and timing counts, into a database's shared entry
+ */
+static void
+pgstat_flush_dbstat(Oid databaseid, PgStat_StatDBEntry *dbsums)
+{
+	PgStat_StatDBEntry *dbentry;
 
-	pgstat_setheader(&tsmsg->m_hdr, PGSTAT_MTYPE_TABSTAT);
-	pgstat_send(tsmsg, len);
+	dbentry = pgstat_get_db_entry(databaseid);
+
+	dbentry->n_xact_commit += dbsums->n_xact_commit;
+	dbentry->n_xact_rollback += dbsums->n_xact_rollback;
+	dbentry->n_block_read_time += dbsums->n_block_read_time;
+	dbentry->n_block_write_time += dbsums->n_block_write_time;
+	dbentry->n_tuples_returned += dbsums->n_tuples_returned;
+	dbentry->n_tuples_fetched += dbsums->n_tuples_fetched;
+	dbentry->n_tuples_inserted += dbsums->n_tuples_inserted;
+	dbentry->n_tuples_updated += dbsums->n_tuples_updated;
+	dbentry->n_tuples_deleted += dbsums->n_tuples_deleted;
+	dbentry->n_blocks_fetched += dbsums->n_blocks_fetched;
+	dbentry->n_blocks_hit += dbsums->n_blocks_hit;
+
+	dshash_release_lock(pgStatDBShared, dbentry);
 }
 
 /*
- * Subroutine for pgstat_report_stat: populate and send a function stat message
+ * Subroutine for pgstat_report_stat: add function counts to shared memory
  */
 static void
-pgstat_send_funcstats(void)
+pgstat_flush_funcstats(void)
 {
 	/* we assume this inits to all zeroes: */
 	static const PgStat_FunctionCounts all_zeroes;
 
-	PgStat_MsgFuncstat msg;
 	PgStat_BackendFunctionEntry *entry;
 	HASH_SEQ_STATUS fstat;
 
 	if (pgStatFunctions == NULL)
 		return;
 
-	pgstat_setheader(&msg.m_hdr, PGSTAT_MTYPE_FUNCSTAT);
-	msg.m_databaseid = MyDatabaseId;
-	msg.m_nentries = 0;
-
 	hash_seq_init(&fstat, pgStatFunctions);
 	while ((entry = (PgStat_BackendFunctionEntry *) hash_seq_search(&fstat)) != NULL)
 	{
-		PgStat_FunctionEntry *m_ent;
+		PgStat_SharedFuncEntry *shent;
+		PgStat_HashKey key;
+		bool		found;
 
 		/* Skip it if no counts accumulated since last time */
 		if (memcmp(&entry->f_counts, &all_zeroes,
 				   sizeof(PgStat_FunctionCounts)) == 0)
 			continue;
 
-		/* need to convert format of time accumulators */
-		m_ent = &msg.m_entry[msg.m_nentries];
-		m_ent->f_id = entry->f_id;
-		m_ent->f_numcalls = entry->f_counts.f_numcalls;
-		m_ent->f_total_time = INSTR_TIME_GET_MICROSEC(entry->f_counts.f_total_time);
-		m_ent->f_self_time = INSTR_TIME_GET_MICROSEC(entry->f_counts.f_self_time);
-
-		if (++msg.m_nentries >= PGSTAT_NUM_FUNCENTRIES)
+		key.databaseid = MyDatabaseId;
+		key.objectid = entry->f_id;
+		shent = (PgStat_SharedFuncEntry *)
+			dshash_find_or_insert(pgStatFuncShared, &key, &found);
+		if (!found)
 		{
-			pgstat_send(&msg, offsetof(PgStat_MsgFuncstat, m_entry[0]) +
-						msg.m_nentries * sizeof(PgStat_FunctionEntry));
-			msg.m_nentries = 0;
+			MemSet(&shent->stats, 0, sizeof(PgStat_StatFuncEntry));
+			shent->stats.functionid = entry->f_id;
 		}
 
+		/* need to convert format of time accumulators */
+		shent->stats.f_numcalls += entry->f_counts.f_numcalls;
+		shent->stats.f_total_time +=
+			INSTR_TIME_GET_MICROSEC(entry->f_counts.f_total_time);
+		shent->stats.f_self_time +=
+			INSTR_TIME_GET_MICROSEC(entry->f_counts.f_self_time);
+
+		dshash_release_lock(pgStatFuncShared, shent);
+
 		/* reset the entry's counts */
 		MemSet(&entry->f_counts, 0, sizeof(PgStat_FunctionCounts));
 	}
 
-	if (msg.m_nentries > 0)
-		pgstat_send(&msg, offsetof(PgStat_MsgFuncstat, m_entry[0]) +
-					msg.m_nentries * sizeof(PgStat_FunctionEntry));
-
 	have_function_stats = false;
 }
 
@@ -1015,63 +1008,55 @@ pgstat_send_funcstats(void)
 /* ----------
  * pgstat_vacuum_stat() -
  *
- *	Will tell the collector about objects he can get rid of.
+ *	Remove the statistics of objects that no longer exist.
  * ----------
  */
 void
 pgstat_vacuum_stat(void)
 {
 	HTAB	   *htab;
-	PgStat_MsgTabpurge msg;
-	PgStat_MsgFuncpurge f_msg;
-	HASH_SEQ_STATUS hstat;
+	dshash_seq_status hstat;
 	PgStat_StatDBEntry *dbentry;
-	PgStat_StatTabEntry *tabentry;
-	PgStat_StatFuncEntry *funcentry;
-	int			len;
+	PgStat_SharedTabEntry *tabentry;
+	PgStat_SharedFuncEntry *funcentry;
+	List	   *dead_dbs = NIL;
+	ListCell   *lc;
+	bool		have_funcs = false;
 
-	if (pgStatSock == PGINVALID_SOCKET)
+	if (pgStatArea == NULL)
 		return;
 
-	/*
-	 * If not done for this transaction, read the statistics collector stats
-	 * file into some hash tables.
-	 */
-	backend_read_statsfile();
-
 	/*
 	 * Read pg_database and make a list of OIDs of all existing databases
 	 */
 	htab = pgstat_collect_oids(DatabaseRelationId, Anum_pg_database_oid);
 
 	/*
-	 * Search the database hash table for dead databases and tell the
-	 * collector to drop them.
+	 * Search the database hash table for dead databases.  Dropping them
+	 * means scanning the other hash tables, so just remember them here.
 	 */
-	hash_seq_init(&hstat, pgStatDBHash);
-	while ((dbentry = (PgStat_StatDBEntry *) hash_seq_search(&hstat)) != NULL)
+	dshash_seq_init(&hstat, pgStatDBShared, false);
+	while ((dbentry = (PgStat_StatDBEntry *) dshash_seq_next(&hstat)) != NULL)
 	{
 		Oid			dbid = dbentry->databaseid;
 
-		CHECK_FOR_INTERRUPTS();
-
 		/* the DB entry for shared tables (with InvalidOid) is never dropped */
 		if (OidIsValid(dbid) &&
 			hash_search(htab, (void *) &dbid, HASH_FIND, NULL) == NULL)
-			pgstat_drop_database(dbid);
+			dead_dbs = lappend_oid(dead_dbs, dbid);
 	}
+	dshash_seq_term(&hstat);
 
 	/* Clean up */
 	hash_destroy(htab);
 
-	/*
-	 * Lookup our own database entry; if not found, nothing more to do.
-	 */
-	dbentry = (PgStat_StatDBEntry *) hash_search(pgStatDBHash,
-												 (void *) &MyDatabaseId,
-												 HASH_FIND, NULL);
-	if (dbentry == NULL || dbentry->tables == NULL)
-		return;
+	foreach(lc, dead_dbs)
+	{
+		CHECK_FOR_INTERRUPTS();
+
+		pgstat_drop_database(lfirst_oid(lc));
+	}
+	list_free(dead_dbs);
 
 	/*
 	 * Similarly to above, make a list of all known relations in this DB.
@@ -1079,112 +1064,59 @@ pgstat_vacuum_stat(void)
 	htab = pgstat_collect_oids(RelationRelationId, Anum_pg_class_oid);
 
 	/*
-	 * Initialize our messages table counter to zero
-	 */
-	msg.m_nentries = 0;
-
-	/*
-	 * Check for all tables listed in stats hashtable if they still exist.
+	 * Check for all tables of this DB listed in the stats hashtable if they
+	 * still exist, and remove the ones that don't.
 	 */
-	hash_seq_init(&hstat, dbentry->tables);
-	while ((tabentry = (PgStat_StatTabEntry *) hash_seq_search(&hstat)) != NULL)
+	dshash_seq_init(&hstat, pgStatTabShared, true);
+	while ((tabentry = (PgStat_SharedTabEntry *) dshash_seq_next(&hstat)) != NULL)
 	{
-		Oid			tabid = tabentry->tableid;
-
-		CHECK_FOR_INTERRUPTS();
-
-		if (hash_search(htab, (void *) &tabid, HASH_FIND, NULL) != NULL)
+		if (tabentry->key.databaseid != MyDatabaseId)
 			continue;
 
-		/*
-		 * Not there, so add this table's Oid to the message
-		 */
-		msg.m_tableid[msg.m_nentries++] = tabid;
-
-		/*
-		 * If the message is full, send it out and reinitialize to empty
-		 */
-		if (msg.m_nentries >= PGSTAT_NUM_TABPURGE)
-		{
-			len = offsetof(PgStat_MsgTabpurge, m_tableid[0])
-				+ msg.m_nentries * sizeof(Oid);
-
-			pgstat_setheader(&msg.m_hdr, PGSTAT_MTYPE_TABPURGE);
-			msg.m_databaseid = MyDatabaseId;
-			pgstat_send(&msg, len);
-
-			msg.m_nentries = 0;
-		}
-	}
-
-	/*
-	 * Send the rest
-	 */
-	if (msg.m_nentries > 0)
-	{
-		len = offsetof(PgStat_MsgTabpurge, m_tableid[0])
-			+ msg.m_nentries * sizeof(Oid);
+		if (hash_search(htab, (void *) &tabentry->key.objectid,
+						HASH_FIND, NULL) != NULL)
+			continue;
 
-		pgstat_setheader(&msg.m_hdr, PGSTAT_MTYPE_TABPURGE);
-		msg.m_databaseid = MyDatabaseId;
-		pgstat_send(&msg, len);
+		dshash_delete_current(&hstat);
 	}
+	dshash_seq_term(&hstat);
 
 	/* Clean up */
 	hash_destroy(htab);
 
 	/*
 	 * Now repeat the above steps for functions.  However, we needn't bother
-	 * in the common case where no function stats are being collected.
+	 * reading pg_proc in the common case where no function stats are being
+	 * collected in this DB.
 	 */
-	if (dbentry->functions != NULL &&
-		hash_get_num_entries(dbentry->functions) > 0)
+	dshash_seq_init(&hstat, pgStatFuncShared, false);
+	while ((funcentry = (PgStat_SharedFuncEntry *) dshash_seq_next(&hstat)) != NULL)
 	{
-		htab = pgstat_collect_oids(ProcedureRelationId, Anum_pg_proc_oid);
-
-		pgstat_setheader(&f_msg.m_hdr, PGSTAT_MTYPE_FUNCPURGE);
-		f_msg.m_databaseid = MyDatabaseId;
-		f_msg.m_nentries = 0;
-
-		hash_seq_init(&hstat, dbentry->functions);
-		while ((funcentry = (PgStat_StatFuncEntry *) hash_seq_search(&hstat)) != NULL)
+		if (funcentry->key.databaseid == MyDatabaseId)
 		{
-			Oid			funcid = funcentry->functionid;
+			have_funcs = true;
+			break;
+		}
+	}
+	dshash_seq_term(&hstat);
 
-			CHECK_FOR_INTERRUPTS();
+	if (have_funcs)
+	{
+		htab = pgstat_collect_oids(ProcedureRelationId, Anum_pg_proc_oid);
 
-			if (hash_search(htab, (void *) &funcid, HASH_FIND, NULL) != NULL)
+		dshash_seq_init(&hstat, pgStatFuncShared, true);
+		while ((funcentry = (PgStat_SharedFuncEntry *) dshash_seq_next(&hstat)) != NULL)
+		{
+			if (funcentry->key.databaseid != MyDatabaseId)
 				continue;
 
-			/*
-			 * Not there, so add this function's Oid to the message
-			 */
-			f_msg.m_functionid[f_msg.m_nentries++] = funcid;
-
-			/*
-			 * If the message is full, send it out and reinitialize to empty
-			 */
-			if (f_msg.m_nentries >= PGSTAT_NUM_FUNCPURGE)
-			{
-				len = offsetof(PgStat_MsgFuncpurge, m_functionid[0])
-					+ f_msg.m_nentries * sizeof(Oid);
-
-				pgstat_send(&f_msg, len);
-
-				f_msg.m_nentries = 0;
-			}
-		}
-
-		/*
-		 * Send the rest
-		 */
-		if (f_msg.m_nentries > 0)
-		{
-			len = offsetof(PgStat_MsgFuncpurge, m_functionid[0])
-				+ f_msg.m_nentries * sizeof(Oid);
+			if (hash_search(htab, (void *) &funcentry->key.objectid,
+							HASH_FIND, NULL) != NULL)
+				continue;
 
-			pgstat_send(&f_msg, len);
+			dshash_delete_current(&hstat);
 		}
+		dshash_seq_term(&hstat);
 
 		hash_destroy(htab);
 	}
@@ -1242,33 +1174,33 @@ pgstat_collect_oids(Oid catalogid, AttrNumber anum_oid)
 }
 
 
+
+
 /* ----------
  * pgstat_drop_database() -
  *
- *	Tell the collector that we just dropped a database.
- *	(If the message gets lost, we will still clean the dead DB eventually
- *	via future invocations of pgstat_vacuum_stat().)
+ *	Remove the statistics of a database we just dropped, together with
+ *	those of its tables and functions.  (If we don't get here, we will
+ *	still clean the dead DB eventually via future invocations of
+ *	pgstat_vacuum_stat().)
  * ----------
  */
 void
 pgstat_drop_database(Oid databaseid)
 {
-	PgStat_MsgDropdb msg;
-
-	if (pgStatSock == PGINVALID_SOCKET)
+	if (pgStatArea == NULL)
 		return;
 
-	pgstat_setheader(&msg.m_hdr, PGSTAT_MTYPE_DROPDB);
-	msg.m_databaseid = databaseid;
-	pgstat_send(&msg, sizeof(msg));
+	pgstat_drop_db_objects(databaseid);
+	(void) dshash_delete_key(pgStatDBShared, &databaseid);
 }
 
 
 /* ----------
  * pgstat_drop_relation() -
  *
- *	Tell the collector that we just dropped a relation.
- *	(If the message gets lost, we will still clean the dead entry eventually
+ *	Remove the statistics of a relation we just dropped.
+ *	(If we don't get here, we will still clean the dead entry eventually
  *	via future invocations of pgstat_vacuum_stat().)
  *
  *	Currently not used for lack of any good place to call it; we rely
@@ -1279,20 +1211,14 @@ pgstat_drop_database(Oid databaseid)
 void
 pgstat_drop_relation(Oid relid)
 {
-	PgStat_MsgTabpurge msg;
-	int			len;
+	PgStat_HashKey key;
 
-	if (pgStatSock == PGINVALID_SOCKET)
+	if (pgStatArea == NULL)
 		return;
 
-	msg.m_tableid[0] = relid;
-	msg.m_nentries = 1;
-
-	len = offsetof(PgStat_MsgTabpurge, m_tableid[0]) + sizeof(Oid);
-
-	pgstat_setheader(&msg.m_hdr, PGSTAT_MTYPE_TABPURGE);
-	msg.m_databaseid = MyDatabaseId;
-	pgstat_send(&msg, len);
+	key.databaseid = MyDatabaseId;
+	key.objectid = relid;
+	(void) dshash_delete_key(pgStatTabShared, &key);
 }
 #endif							/* NOT_USED */
 
@@ -1300,7 +1226,7 @@ pgstat_drop_relation(Oid relid)
 /* ----------
  * pgstat_reset_counters() -
  *
- *	Tell the statistics collector to reset counters for our database.
+ *	Reset counters for our database.
  *
  *	Permission checking for this function is managed through the normal
  *	GRANT system.
@@ -1309,20 +1235,31 @@ pgstat_drop_relation(Oid relid)
 void
 pgstat_reset_counters(void)
 {
-	PgStat_MsgResetcounter msg;
+	PgStat_StatDBEntry *dbentry;
+
+	if (pgStatArea == NULL)
+		return;
 
-	if (pgStatSock == PGINVALID_SOCKET)
+	/*
+	 * Lookup the database in the hashtable.  Nothing to do if not there.
+	 */
+	dbentry = (PgStat_StatDBEntry *)
+		dshash_find(pgStatDBShared, &MyDatabaseId, true);
+	if (dbentry == NULL)
 		return;
 
-	pgstat_setheader(&msg.m_hdr, PGSTAT_MTYPE_RESETCOUNTER);
-	msg.m_databaseid = MyDatabaseId;
-	pgstat_send(&msg, sizeof(msg));
+	/* Reset database-level stats */
+	reset_dbentry_counters(dbentry);
+	dshash_release_lock(pgStatDBShared, dbentry);
+
+	/* We simply throw away all the database's table and function entries */
+	pgstat_drop_db_objects(MyDatabaseId);
 }
 
 /* ----------
  * pgstat_reset_shared_counters() -
  *
- *	Tell the statistics collector to reset cluster-wide shared counters.
+ *	Reset cluster-wide shared counters.
  *
  *	Permission checking for this function is managed through the normal
  *	GRANT system.
@@ -1331,29 +1268,62 @@ pgstat_reset_counters(void)
 void
 pgstat_reset_shared_counters(const char *target)
 {
-	PgStat_MsgResetsharedcounter msg;
+	TimestampTz now;
 
-	if (pgStatSock == PGINVALID_SOCKET)
+	if (strcmp(target, "locks") == 0)
+	{
+		/* Lock timing statistics are kept separately, see lockstats.c */
+		LockStatsReset();
 		return;
+	}
 
-	if (strcmp(target, "archiver") == 0)
-		msg.m_resettarget = RESET_ARCHIVER;
-	else if (strcmp(target, "bgwriter") == 0)
-		msg.m_resettarget = RESET_BGWRITER;
-	else
+	if (strcmp(target, "archiver") != 0 &&
+		strcmp(target, "bgwriter") != 0 &&
+		strcmp(target, "io") != 0 &&
+		strcmp(target, "wal") != 0)
 		ereport(ERROR,
 				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
 				 errmsg("unrecognized reset target: \"%s\"", target),
-				 errhint("Target must be \"archiver\" or \"bgwriter\".")));
+				 errhint("Target must be \"archiver\", \"bgwriter\", \"io\", \"locks\" or \"wal\".")));
 
-	pgstat_setheader(&msg.m_hdr, PGSTAT_MTYPE_RESETSHAREDCOUNTER);
-	pgstat_send(&msg, sizeof(msg));
+	now = GetCurrentTimestamp();
+
+	if (strcmp(target, "io") == 0)
+	{
+		/* Reset the I/O statistics for the cluster. */
+		SpinLockAcquire(&pgStatShmem->io_mutex);
+		MemSet(&pgStatShmem->io_stats, 0, sizeof(PgStat_IOStats));
+		pgStatShmem->io_stats.stat_reset_timestamp = now;
+		SpinLockRelease(&pgStatShmem->io_mutex);
+		return;
+	}
+
+	SpinLockAcquire(&pgStatShmem->mutex);
+	if (strcmp(target, "archiver") == 0)
+	{
+		/* Reset the archiver statistics for the cluster. */
+		MemSet(&pgStatShmem->archiver_stats, 0, sizeof(PgStat_ArchiverStats));
+		pgStatShmem->archiver_stats.stat_reset_timestamp = now;
+	}
+	else if (strcmp(target, "wal") == 0)
+	{
+		/* Reset the WAL statistics for the cluster. */
+		MemSet(&pgStatShmem->wal_stats, 0, sizeof(PgStat_WalStats));
+		pgStatShmem->wal_stats.stat_reset_timestamp = now;
+	}
+	else
+	{
+		/* Reset the global background writer statistics for the cluster. */
+		MemSet(&pgStatShmem->global_stats, 0, sizeof(PgStat_GlobalStats));
+		pgStatShmem->global_stats.stat_reset_timestamp = now;
+	}
+	SpinLockRelease(&pgStatShmem->mutex);
 }
 
 /* ----------
  * pgstat_reset_single_counter() -
  *
- *	Tell the statistics collector to reset a single counter.
+ *	Reset the statistics of a single table or function of our database.
  *
  *	Permission checking for this function is managed through the normal
  *	GRANT system.
@@ -1362,17 +1332,28 @@ pgstat_reset_shared_counters(const char *target)
 void
 pgstat_reset_single_counter(Oid objoid, PgStat_Single_Reset_Type type)
 {
-	PgStat_MsgResetsinglecounter msg;
+	PgStat_StatDBEntry *dbentry;
+	PgStat_HashKey key;
 
-	if (pgStatSock == PGINVALID_SOCKET)
+	if (pgStatArea == NULL)
 		return;
 
-	pgstat_setheader(&msg.m_hdr, PGSTAT_MTYPE_RESETSINGLECOUNTER);
-	msg.m_databaseid = MyDatabaseId;
-	msg.m_resettype = type;
-	msg.m_objectid = objoid;
+	dbentry = (PgStat_StatDBEntry *)
+		dshash_find(pgStatDBShared, &MyDatabaseId, true);
+	if (dbentry == NULL)
+		return;
+
+	/* Set the reset timestamp for the whole database */
+	dbentry->stat_reset_timestamp = GetCurrentTimestamp();
+	dshash_release_lock(pgStatDBShared, dbentry);
 
-	pgstat_send(&msg, sizeof(msg));
+	/* Remove object if it exists, ignore it if not */
+	key.databaseid = MyDatabaseId;
+	key.objectid = objoid;
+	if (type == RESET_TABLE)
+		(void) dshash_delete_key(pgStatTabShared, &key);
+	else if (type == RESET_FUNCTION)
+		(void) dshash_delete_key(pgStatFuncShared, &key);
 }
 
 /* ----------
@@ -1380,54 +1361,84 @@ pgstat_reset_single_counter(Oid objoid, PgStat_Single_Reset_Type type)
  *
  *	Called from autovacuum.c to report startup of an autovacuum process.
  *	We are called before InitPostgres is done, so can't rely on MyDatabaseId;
- *	the db OID must be passed in, instead.
+ *	the db OID must be passed in, instead.  For the same reason, we may have
+ *	to attach to the shared statistics here.
  * ----------
  */
 void
 pgstat_report_autovac(Oid dboid)
 {
-	PgStat_MsgAutovacStart msg;
-
-	if (pgStatSock == PGINVALID_SOCKET)
-		return;
+	PgStat_StatDBEntry *dbentry;
 
-	pgstat_setheader(&msg.m_hdr, PGSTAT_MTYPE_AUTOVAC_START);
-	msg.m_databaseid = dboid;
-	msg.m_start_time = GetCurrentTimestamp();
+	pgstat_attach_shmem();
 
-	pgstat_send(&msg, sizeof(msg));
+	/*
+	 * Store the last autovacuum time in the database's hashtable entry.
+	 */
+	dbentry = pgstat_get_db_entry(dboid);
+	dbentry->last_autovac_time = GetCurrentTimestamp();
+	dshash_release_lock(pgStatDBShared, dbentry);
 }
 
 
 /* ---------
  * pgstat_report_vacuum() -
  *
- *	Tell the collector about the table we just vacuumed.
+ *	Report about the table we just vacuumed.
  * ---------
  */
 void
 pgstat_report_vacuum(Oid tableoid, bool shared,
 					 PgStat_Counter livetuples, PgStat_Counter deadtuples)
 {
-	PgStat_MsgVacuum msg;
+	PgStat_SharedTabEntry *shent;
+	PgStat_StatTabEntry *tabentry;
+	TimestampTz now;
 
-	if (pgStatSock == PGINVALID_SOCKET || !pgstat_track_counts)
+	if (pgStatArea == NULL || !pgstat_track_counts)
 		return;
 
-	pgstat_setheader(&msg.m_hdr, PGSTAT_MTYPE_VACUUM);
-	msg.m_databaseid = shared ? InvalidOid : MyDatabaseId;
-	msg.m_tableoid = tableoid;
-	msg.m_autovacuum = IsAutoVacuumWorkerProcess();
-	msg.m_vacuumtime = GetCurrentTimestamp();
-	msg.m_live_tuples = livetuples;
-	msg.m_dead_tuples = deadtuples;
-	pgstat_send(&msg, sizeof(msg));
+	now = GetCurrentTimestamp();
+
+	/*
+	 * Store the data in the table's hashtable entry.
+	 */
+	shent = pgstat_get_tab_entry(shared ? InvalidOid : MyDatabaseId,
+								 tableoid);
+	tabentry = &shent->stats;
+
+	tabentry->n_live_tuples = livetuples;
+	tabentry->n_dead_tuples = deadtuples;
+
+	/*
+	 * It is quite possible that a non-aggressive VACUUM ended up skipping
+	 * various pages, however, we'll zero the insert counter here regardless.
+	 * It's currently used only to track when we need to perform an "insert"
+	 * autovacuum, which are mainly intended to freeze newly inserted tuples.
+	 * Zeroing this may just mean we'll not try to vacuum the table again
+	 * until enough tuples have been inserted to trigger another insert
+	 * autovacuum.
+	 */
+	tabentry->inserts_since_vacuum = 0;
+
+	if (IsAutoVacuumWorkerProcess())
+	{
+		tabentry->autovac_vacuum_timestamp = now;
+		tabentry->autovac_vacuum_count++;
+	}
+	else
+	{
+		tabentry->vacuum_timestamp = now;
+		tabentry->vacuum_count++;
+	}
+
+	dshash_release_lock(pgStatTabShared, shent);
 }
 
 /* --------
  * pgstat_report_analyze() -
  *
- *	Tell the collector about the table we just analyzed.
+ *	Report about the table we just analyzed.
  *
  * Caller must provide new live- and dead-tuples estimates, as well as a
  * flag indicating whether to reset the changes_since_analyze counter.
@@ -1438,9 +1449,11 @@ pgstat_report_analyze(Relation rel,
 					  PgStat_Counter livetuples, PgStat_Counter deadtuples,
 					  bool resetcounter)
 {
-	PgStat_MsgAnalyze msg;
+	PgStat_SharedTabEntry *shent;
+	PgStat_StatTabEntry *tabentry;
+	TimestampTz now;
 
-	if (pgStatSock == PGINVALID_SOCKET || !pgstat_track_counts)
+	if (pgStatArea == NULL || !pgstat_track_counts)
 		return;
 
 	/*
@@ -1448,9 +1461,9 @@ pgstat_report_analyze(Relation rel,
 	 * already inserted and/or deleted rows in the target table. ANALYZE will
 	 * have counted such rows as live or dead respectively. Because we will
 	 * report our counts of such rows at transaction end, we should subtract
-	 * off these counts from what we send to the collector now, else they'll
-	 * be double-counted after commit.  (This approach also ensures that the
-	 * collector ends up with the right numbers if we abort instead of
+	 * off these counts from what we store now, else they'll be
+	 * double-counted after commit.  (This approach also ensures that the
+	 * shared entry ends up with the right numbers if we abort instead of
 	 * committing.)
 	 */
 	if (rel->pgstat_info != NULL)
@@ -1469,129 +1482,141 @@ pgstat_report_analyze(Relation rel,
 		deadtuples = Max(deadtuples, 0);
 	}
 
-	pgstat_setheader(&msg.m_hdr, PGSTAT_MTYPE_ANALYZE);
-	msg.m_databaseid = rel->rd_rel->relisshared ? InvalidOid : MyDatabaseId;
-	msg.m_tableoid = RelationGetRelid(rel);
-	msg.m_autovacuum = IsAutoVacuumWorkerProcess();
-	msg.m_resetcounter = resetcounter;
-	msg.m_analyzetime = GetCurrentTimestamp();
-	msg.m_live_tuples = livetuples;
-	msg.m_dead_tuples = deadtuples;
-	pgstat_send(&msg, sizeof(msg));
+	now = GetCurrentTimestamp();
+
+	/*
+	 * Store the data in the table's hashtable entry.
+	 */
+	shent = pgstat_get_tab_entry(rel->rd_rel->relisshared ?
+								 InvalidOid : MyDatabaseId,
+								 RelationGetRelid(rel));
+	tabentry = &shent->stats;
+
+	tabentry->n_live_tuples = livetuples;
+	tabentry->n_dead_tuples = deadtuples;
+
+	/*
+	 * If commanded, reset changes_since_analyze to zero.  This forgets any
+	 * changes that were committed while the ANALYZE was in progress, but we
+	 * have no good way to estimate how many of those there were.
+	 */
+	if (resetcounter)
+		tabentry->changes_since_analyze = 0;
+
+	if (IsAutoVacuumWorkerProcess())
+	{
+		tabentry->autovac_analyze_timestamp = now;
+		tabentry->autovac_analyze_count++;
+	}
+	else
+	{
+		tabentry->analyze_timestamp = now;
+		tabentry->analyze_count++;
+	}
+
+	dshash_release_lock(pgStatTabShared, shent);
 }
 
 /* --------
  * pgstat_report_recovery_conflict() -
  *
- *	Tell the collector about a Hot Standby recovery conflict.
+ *	Report a Hot Standby recovery conflict.
  * --------
  */
 void
 pgstat_report_recovery_conflict(int reason)
 {
-	PgStat_MsgRecoveryConflict msg;
+	PgStat_StatDBEntry *dbentry;
+
+	if (pgStatArea == NULL || !pgstat_track_counts)
+		return;
 
-	if (pgStatSock == PGINVALID_SOCKET || !pgstat_track_counts)
+	/*
+	 * Since we drop the information about the database as soon as it
+	 * replicates, there is no point in counting database conflicts.
+	 */
+	if (reason == PROCSIG_RECOVERY_CONFLICT_DATABASE)
 		return;
 
-	pgstat_setheader(&msg.m_hdr, PGSTAT_MTYPE_RECOVERYCONFLICT);
-	msg.m_databaseid = MyDatabaseId;
-	msg.m_reason = reason;
-	pgstat_send(&msg, sizeof(msg));
+	dbentry = pgstat_get_db_entry(MyDatabaseId);
+
+	switch (reason)
+	{
+		case PROCSIG_RECOVERY_CONFLICT_TABLESPACE:
+			dbentry->n_conflict_tablespace++;
+			break;
+		case PROCSIG_RECOVERY_CONFLICT_LOCK:
+			dbentry->n_conflict_lock++;
+			break;
+		case PROCSIG_RECOVERY_CONFLICT_SNAPSHOT:
+			dbentry->n_conflict_snapshot++;
+			break;
+		case PROCSIG_RECOVERY_CONFLICT_BUFFERPIN:
+			dbentry->n_conflict_bufferpin++;
+			break;
+		case PROCSIG_RECOVERY_CONFLICT_STARTUP_DEADLOCK:
+			dbentry->n_conflict_startup_deadlock++;
+			break;
+	}
+
+	dshash_release_lock(pgStatDBShared, dbentry);
 }
 
 /* --------
  * pgstat_report_deadlock() -
  *
- *	Tell the collector about a deadlock detected.
+ *	Report a deadlock detected.
  * --------
  */
 void
 pgstat_report_deadlock(void)
 {
-	PgStat_MsgDeadlock msg;
+	PgStat_StatDBEntry *dbentry;
 
-	if (pgStatSock == PGINVALID_SOCKET || !pgstat_track_counts)
+	if (pgStatArea == NULL || !pgstat_track_counts)
 		return;
 
-	pgstat_setheader(&msg.m_hdr, PGSTAT_MTYPE_DEADLOCK);
-	msg.m_databaseid = MyDatabaseId;
-	pgstat_send(&msg, sizeof(msg));
+	dbentry = pgstat_get_db_entry(MyDatabaseId);
+	dbentry->n_deadlocks++;
+	dshash_release_lock(pgStatDBShared, dbentry);
 }
 
 /* --------
  * pgstat_report_tempfile() -
  *
- *	Tell the collector about a temporary file.
+ *	Report a temporary file.
  * --------
  */
 void
 pgstat_report_tempfile(size_t filesize)
 {
-	PgStat_MsgTempFile msg;
+	PgStat_StatDBEntry *dbentry;
 
-	if (pgStatSock == PGINVALID_SOCKET || !pgstat_track_counts)
+	if (pgStatArea == NULL || !pgstat_track_counts)
 		return;
 
-	pgstat_setheader(&msg.m_hdr, PGSTAT_MTYPE_TEMPFILE);
-	msg.m_databaseid = MyDatabaseId;
-	msg.m_filesize = filesize;
-	pgstat_send(&msg, sizeof(msg));
+	dbentry = pgstat_get_db_entry(MyDatabaseId);
+	dbentry->n_temp_bytes += filesize;
+	dbentry->n_temp_files += 1;
+	dshash_release_lock(pgStatDBShared, dbentry);
 }
 
 
-/* ----------
- * pgstat_ping() -
- *
- *	Send some junk data to the collector to increase traffic.
- * ----------
+/*
+ * Initialize function call usage data.
+ * Called by the executor before invoking a function.
  */
 void
-pgstat_ping(void)
+pgstat_init_function_usage(FunctionCallInfoData *fcinfo,
+						   PgStat_FunctionCallUsage *fcu)
 {
-	PgStat_MsgDummy msg;
+	PgStat_BackendFunctionEntry *htabent;
+	bool		found;
 
-	if (pgStatSock == PGINVALID_SOCKET)
-		return;
-
-	pgstat_setheader(&msg.m_hdr, PGSTAT_MTYPE_DUMMY);
-	pgstat_send(&msg, sizeof(msg));
-}
-
-/* ----------
- * pgstat_send_inquiry() -
- *
- *	Notify collector that we need fresh data.
- * ----------
- */
-static void
-pgstat_send_inquiry(TimestampTz clock_time, TimestampTz cutoff_time, Oid databaseid)
-{
-	PgStat_MsgInquiry msg;
-
-	pgstat_setheader(&msg.m_hdr, PGSTAT_MTYPE_INQUIRY);
-	msg.clock_time = clock_time;
-	msg.cutoff_time = cutoff_time;
-	msg.databaseid = databaseid;
-	pgstat_send(&msg, sizeof(msg));
-}
-
-
-/*
- * Initialize function call usage data.
- * Called by the executor before invoking a function.
- */
-void
-pgstat_init_function_usage(FunctionCallInfoData *fcinfo,
-						   PgStat_FunctionCallUsage *fcu)
-{
-	PgStat_BackendFunctionEntry *htabent;
-	bool		found;
-
-	if (pgstat_track_functions <= fcinfo->flinfo->fn_stats)
-	{
-		/* stats not wanted */
-		fcu->fs = NULL;
+	if (pgstat_track_functions <= fcinfo->flinfo->fn_stats)
+	{
+		/* stats not wanted */
+		fcu->fs = NULL;
 		return;
 	}
 
@@ -1727,7 +1752,7 @@ pgstat_initstats(Relation rel)
 		return;
 	}
 
-	if (pgStatSock == PGINVALID_SOCKET || !pgstat_track_counts)
+	if (pgStatArea == NULL || !pgstat_track_counts)
 	{
 		/* We're not counting at all */
 		rel->pgstat_info = NULL;
@@ -2279,7 +2304,7 @@ AtPrepare_PgStat(void)
  *
  * All we need do here is unlink the transaction stats state from the
  * nontransactional state.  The nontransactional action counts will be
- * reported to the stats collector immediately, while the effects on live
+ * flushed to shared memory as usual, while the effects on live
  * and dead tuple counts are preserved in the 2PC state file.
  *
  * Note: AtEOXact_PgStat is not called during PREPARE.
@@ -2383,25 +2408,49 @@ pgstat_twophase_postabort(TransactionId xid, uint16 info,
  *
  *	Support function for the SQL-callable pgstat* functions. Returns
  *	the collected statistics for one database or NULL. NULL doesn't mean
- *	that the database doesn't exist, it is just not yet known by the
- *	collector, so the caller is better off to report ZERO instead.
+ *	that the database doesn't exist, it is just not yet known to the
+ *	statistics system, so the caller is better off to report ZERO instead.
+ *
+ *	The result is a copy in our snapshot, which remains unchanged until
+ *	pgstat_clear_snapshot() is called.
  * ----------
  */
 PgStat_StatDBEntry *
 pgstat_fetch_stat_dbentry(Oid dbid)
 {
+	PgStat_StatDBEntry *dbentry;
+	PgStat_StatDBEntry *shent;
+	PgStat_StatDBEntry dbbuf;
+
+	if (pgStatArea == NULL)
+		return NULL;
+
 	/*
-	 * If not done for this transaction, read the statistics collector stats
-	 * file into some hash tables.
+	 * If we have already looked at this database in this transaction,
+	 * return the same values again.
 	 */
-	backend_read_statsfile();
+	pgstat_setup_snapshot();
+	dbentry = (PgStat_StatDBEntry *) hash_search(pgStatDBSnapshot,
+												 (void *) &dbid,
+												 HASH_FIND, NULL);
+	if (dbentry != NULL)
+		return dbentry;
 
 	/*
-	 * Lookup the requested database; return NULL if not found
+	 * Else copy the shared entry into the snapshot; return NULL if not found
 	 */
-	return (PgStat_StatDBEntry *) hash_search(pgStatDBHash,
-											  (void *) &dbid,
-											  HASH_FIND, NULL);
+	shent = (PgStat_StatDBEntry *) dshash_find(pgStatDBShared, &dbid, false);
+	if (shent == NULL)
+		return NULL;
+	memcpy(&dbbuf, shent, sizeof(PgStat_StatDBEntry));
+	dshash_release_lock(pgStatDBShared, shent);
+
+	dbentry = (PgStat_StatDBEntry *) hash_search(pgStatDBSnapshot,
+												 (void *) &dbid,
+												 HASH_ENTER, NULL);
+	memcpy(dbentry, &dbbuf, sizeof(PgStat_StatDBEntry));
+
+	return dbentry;
 }
 
 
@@ -2410,56 +2459,67 @@ pgstat_fetch_stat_dbentry(Oid dbid)
  *
  *	Support function for the SQL-callable pgstat* functions. Returns
  *	the collected statistics for one table or NULL. NULL doesn't mean
- *	that the table doesn't exist, it is just not yet known by the
- *	collector, so the caller is better off to report ZERO instead.
+ *	that the table doesn't exist, it is just not yet known to the
+ *	statistics system, so the caller is better off to report ZERO instead.
  * ----------
  */
 PgStat_StatTabEntry *
 pgstat_fetch_stat_tabentry(Oid relid)
 {
-	Oid			dbid;
-	PgStat_StatDBEntry *dbentry;
 	PgStat_StatTabEntry *tabentry;
 
 	/*
-	 * If not done for this transaction, read the statistics collector stats
-	 * file into some hash tables.
+	 * Look in our database first.  If we don't find it, maybe it's a shared
+	 * table.
 	 */
-	backend_read_statsfile();
+	tabentry = pgstat_fetch_stat_tabentry_extended(false, relid);
+	if (tabentry == NULL)
+		tabentry = pgstat_fetch_stat_tabentry_extended(true, relid);
 
-	/*
-	 * Lookup our database, then look in its table hash table.
-	 */
-	dbid = MyDatabaseId;
-	dbentry = (PgStat_StatDBEntry *) hash_search(pgStatDBHash,
-												 (void *) &dbid,
-												 HASH_FIND, NULL);
-	if (dbentry != NULL && dbentry->tables != NULL)
-	{
-		tabentry = (PgStat_StatTabEntry *) hash_search(dbentry->tables,
-													   (void *) &relid,
-													   HASH_FIND, NULL);
-		if (tabentry)
-			return tabentry;
-	}
+	return tabentry;
+}
 
-	/*
-	 * If we didn't find it, maybe it's a shared table.
-	 */
-	dbid = InvalidOid;
-	dbentry = (PgStat_StatDBEntry *) hash_search(pgStatDBHash,
-												 (void *) &dbid,
-												 HASH_FIND, NULL);
-	if (dbentry != NULL && dbentry->tables != NULL)
-	{
-		tabentry = (PgStat_StatTabEntry *) hash_search(dbentry->tables,
-													   (void *) &relid,
-													   HASH_FIND, NULL);
-		if (tabentry)
-			return tabentry;
-	}
 
-	return NULL;
+/* ----------
+ * pgstat_fetch_stat_tabentry_extended() -
+ *
+ *	Like pgstat_fetch_stat_tabentry(), but for callers who know whether the
+ *	table is a shared catalog, so that only one lookup is needed.
+ * ----------
+ */
+PgStat_StatTabEntry *
+pgstat_fetch_stat_tabentry_extended(bool shared, Oid relid)
+{
+	PgStat_SharedTabEntry *tabentry;
+	PgStat_SharedTabEntry *shent;
+	PgStat_SharedTabEntry tabbuf;
+	PgStat_HashKey key;
+
+	if (pgStatArea == NULL)
+		return NULL;
+
+	key.databaseid = shared ? InvalidOid : MyDatabaseId;
+	key.objectid = relid;
+
+	pgstat_setup_snapshot();
+	tabentry = (PgStat_SharedTabEntry *) hash_search(pgStatTabSnapshot,
+													 (void *) &key,
+													 HASH_FIND, NULL);
+	if (tabentry != NULL)
+		return &tabentry->stats;
+
+	shent = (PgStat_SharedTabEntry *) dshash_find(pgStatTabShared, &key, false);
+	if (shent == NULL)
+		return NULL;
+	memcpy(&tabbuf, shent, sizeof(PgStat_SharedTabEntry));
+	dshash_release_lock(pgStatTabShared, shent);
+
+	tabentry = (PgStat_SharedTabEntry *) hash_search(pgStatTabSnapshot,
+													 (void *) &key,
+													 HASH_ENTER, NULL);
+	memcpy(tabentry, &tabbuf, sizeof(PgStat_SharedTabEntry));
+
+	return &tabentry->stats;
 }
 
 
@@ -2473,22 +2533,36 @@ pgstat_fetch_stat_tabentry(Oid relid)
 PgStat_StatFuncEntry *
 pgstat_fetch_stat_funcentry(Oid func_id)
 {
-	PgStat_StatDBEntry *dbentry;
-	PgStat_StatFuncEntry *funcentry = NULL;
+	PgStat_SharedFuncEntry *funcentry;
+	PgStat_SharedFuncEntry *shent;
+	PgStat_SharedFuncEntry funcbuf;
+	PgStat_HashKey key;
 
-	/* load the stats file if needed */
-	backend_read_statsfile();
+	if (pgStatArea == NULL)
+		return NULL;
 
-	/* Lookup our database, then find the requested function.  */
-	dbentry = pgstat_fetch_stat_dbentry(MyDatabaseId);
-	if (dbentry != NULL && dbentry->functions != NULL)
-	{
-		funcentry = (PgStat_StatFuncEntry *) hash_search(dbentry->functions,
-														 (void *) &func_id,
-														 HASH_FIND, NULL);
-	}
+	key.databaseid = MyDatabaseId;
+	key.objectid = func_id;
+
+	pgstat_setup_snapshot();
+	funcentry = (PgStat_SharedFuncEntry *) hash_search(pgStatFuncSnapshot,
+													   (void *) &key,
+													   HASH_FIND, NULL);
+	if (funcentry != NULL)
+		return &funcentry->stats;
+
+	shent = (PgStat_SharedFuncEntry *) dshash_find(pgStatFuncShared, &key, false);
+	if (shent == NULL)
+		return NULL;
+	memcpy(&funcbuf, shent, sizeof(PgStat_SharedFuncEntry));
+	dshash_release_lock(pgStatFuncShared, shent);
 
-	return funcentry;
+	funcentry = (PgStat_SharedFuncEntry *) hash_search(pgStatFuncSnapshot,
+													   (void *) &key,
+													   HASH_ENTER, NULL);
+	memcpy(funcentry, &funcbuf, sizeof(PgStat_SharedFuncEntry));
+
+	return &funcentry->stats;
 }
 
 
@@ -2562,7 +2636,7 @@ pgstat_fetch_stat_numbackends(void)
 PgStat_ArchiverStats *
 pgstat_fetch_stat_archiver(void)
 {
-	backend_read_statsfile();
+	pgstat_snapshot_global();
 
 	return &archiverStats;
 }
@@ -2579,12 +2653,52 @@ pgstat_fetch_stat_archiver(void)
 PgStat_GlobalStats *
 pgstat_fetch_global(void)
 {
-	backend_read_statsfile();
+	pgstat_snapshot_global();
 
 	return &globalStats;
 }
 
 
+/*
+ * ---------
+ * pgstat_fetch_stat_wal() -
+ *
+ *	Support function for the SQL-callable pgstat* functions. Returns
+ *	a pointer to the WAL statistics struct.  Our own pending counts are
+ *	flushed first, so that they are included.
+ * ---------
+ */
+PgStat_WalStats *
+pgstat_fetch_stat_wal(void)
+{
+	if (!have_global_snapshot)
+		pgstat_flush_wal(true);
+	pgstat_snapshot_global();
+
+	return &walStats;
+}
+
+
+/*
+ * ---------
+ * pgstat_fetch_stat_io() -
+ *
+ *	Support function for the SQL-callable pgstat* functions. Returns
+ *	a pointer to the I/O statistics struct.  Our own pending counts are
+ *	flushed first, so that they are included.
+ * ---------
+ */
+PgStat_IOStats *
+pgstat_fetch_stat_io(void)
+{
+	if (!have_global_snapshot)
+		pgstat_flush_io(true);
+	pgstat_snapshot_global();
+
+	return &ioStats;
+}
+
+
 /* ------------------------------------------------------------
  * Functions for management of the shared-memory PgBackendStatus array
  * ------------------------------------------------------------
@@ -2737,7 +2851,8 @@ CreateSharedBackendStatus(void)
 /* ----------
  * pgstat_initialize() -
  *
- *	Initialize pgstats state, and set up our on-proc-exit hook.
+ *	Initialize pgstats state, attach to the shared statistics, and set up
+ *	our on-proc-exit hooks.
  *	Called from InitPostgres and AuxiliaryProcessMain. For auxiliary process,
  *	MyBackendId is invalid. Otherwise, MyBackendId must be set,
  *	but we must not have started any transaction yet (since the
@@ -2770,8 +2885,11 @@ pgstat_initialize(void)
 		MyBEEntry = &BackendStatusArray[MaxBackends + MyAuxProcType];
 	}
 
-	/* Set up a process-exit hook to clean up */
+	pgstat_attach_shmem();
+
+	/* Set up process-exit hooks to clean up */
 	on_shmem_exit(pgstat_beshutdown_hook, 0);
+	before_shmem_exit(pgstat_shutdown_hook, 0);
 }
 
 /* ----------
@@ -2919,6 +3037,7 @@ pgstat_bestart(void)
 	beentry->st_state = STATE_UNDEFINED;
 	beentry->st_appname[0] = '\0';
 	beentry->st_activity_raw[0] = '\0';
+	beentry->st_query_id = UINT64CONST(0);
 	/* Also make sure the last byte in each string area is always 0 */
 	beentry->st_clienthostname[NAMEDATALEN - 1] = '\0';
 	beentry->st_appname[NAMEDATALEN - 1] = '\0';
@@ -2942,26 +3061,39 @@ pgstat_bestart(void)
 /*
  * Shut down a single backend's statistics reporting at process exit.
  *
- * Flush any remaining statistics counts out to the collector.
- * Without this, operations triggered during backend exit (such as
- * temp table deletions) won't be counted.
- *
- * Lastly, clear out our entry in the PgBackendStatus array.
+ * Flush any remaining statistics counts out to shared memory, and detach
+ * from it.  Without this, operations triggered during backend exit (such as
+ * temp table deletions) won't be counted.  This is a before_shmem_exit
+ * callback, because the shared hash tables may live in DSM segments that
+ * are detached before the on_shmem_exit callbacks run.
  */
 static void
-pgstat_beshutdown_hook(int code, Datum arg)
+pgstat_shutdown_hook(int code, Datum arg)
 {
-	volatile PgBackendStatus *beentry = MyBEEntry;
-
 	/*
-	 * If we got as far as discovering our own database ID, we can report what
-	 * we did to the collector.  Otherwise, we'd be sending an invalid
-	 * database ID, so forget it.  (This means that accesses to pg_database
-	 * during failed backend starts might never get counted.)
+	 * If we got as far as discovering our own database ID, we can report
+	 * what we did.  Otherwise, we'd be reporting an invalid database ID, so
+	 * forget it.  (This means that accesses to pg_database during failed
+	 * backend starts might never get counted.)
 	 */
 	if (OidIsValid(MyDatabaseId))
 		pgstat_report_stat(true);
 
+	/* I/O and WAL are not attributed to a database, so count them anyway */
+	pgstat_flush_io(true);
+	pgstat_flush_wal(true);
+
+	pgstat_detach_shmem();
+}
+
+/*
+ * Clear out our entry in the PgBackendStatus array at process exit.
+ */
+static void
+pgstat_beshutdown_hook(int code, Datum arg)
+{
+	volatile PgBackendStatus *beentry = MyBEEntry;
+
 	/*
 	 * Clear my status entry, following the protocol of bumping st_changecount
 	 * before and after.  We use a volatile pointer here to ensure the
@@ -3015,6 +3147,7 @@ pgstat_report_activity(BackendState state, const char *cmd_str)
 			beentry->st_state_start_timestamp = 0;
 			beentry->st_activity_raw[0] = '\0';
 			beentry->st_activity_start_timestamp = 0;
+			beentry->st_query_id = UINT64CONST(0);
 			/* st_xact_start_timestamp and wait_event_info are also disabled */
 			beentry->st_xact_start_timestamp = 0;
 			proc->wait_event_info = 0;
@@ -3047,6 +3180,13 @@ pgstat_report_activity(BackendState state, const char *cmd_str)
 	beentry->st_state = state;
 	beentry->st_state_start_timestamp = current_timestamp;
 
+	/*
+	 * A new statement's query identifier is only known after parse analysis;
+	 * don't go on showing the previous statement's meanwhile.
+	 */
+	if (state == STATE_RUNNING)
+		beentry->st_query_id = UINT64CONST(0);
+
 	if (cmd_str != NULL)
 	{
 		memcpy((char *) beentry->st_activity_raw, cmd_str, len);
@@ -3057,6 +3197,31 @@ pgstat_report_activity(BackendState state, const char *cmd_str)
 	pgstat_increment_changecount_after(beentry);
 }
 
+/* ----------
+ * pgstat_report_query_id() -
+ *
+ *	Called to report the query identifier of the statement being run.
+ *	Only the top-level statement's identifier is shown, so unless force is
+ *	true, this does nothing if one has already been reported since the
+ *	statement started.
+ * ----------
+ */
+void
+pgstat_report_query_id(uint64 query_id, bool force)
+{
+	volatile PgBackendStatus *beentry = MyBEEntry;
+
+	if (!beentry || !pgstat_track_activities)
+		return;
+
+	if (beentry->st_query_id != UINT64CONST(0) && !force)
+		return;
+
+	pgstat_increment_changecount_before(beentry);
+	beentry->st_query_id = query_id;
+	pgstat_increment_changecount_after(beentry);
+}
+
 /*-----------
  * pgstat_progress_start_command() -
  *
@@ -3227,7 +3392,6 @@ pgstat_read_current_status(void)
 #endif
 	int			i;
 
-	Assert(!pgStatRunningInCollector);
 	if (localBackendStatusTable)
 		return;					/* already done */
 
@@ -3488,14 +3652,17 @@ pgstat_get_wait_activity(WaitEventActivity w)
 		case WAIT_EVENT_CHECKPOINTER_MAIN:
 			event_name = "CheckpointerMain";
 			break;
+		case WAIT_EVENT_CHECKPOINT_WRITER_MAIN:
+			event_name = "CheckpointWriterMain";
+			break;
 		case WAIT_EVENT_LOGICAL_APPLY_MAIN:
 			event_name = "LogicalApplyMain";
 			break;
 		case WAIT_EVENT_LOGICAL_LAUNCHER_MAIN:
 			event_name = "LogicalLauncherMain";
 			break;
-		case WAIT_EVENT_PGSTAT_MAIN:
-			event_name = "PgStatMain";
+		case WAIT_EVENT_PROXY_MAIN:
+			event_name = "ProxyMain";
 			break;
 		case WAIT_EVENT_RECOVERY_WAL_ALL:
 			event_name = "RecoveryWalAll";
@@ -3503,6 +3670,12 @@ pgstat_get_wait_activity(WaitEventActivity w)
 		case WAIT_EVENT_RECOVERY_WAL_STREAM:
 			event_name = "RecoveryWalStream";
 			break;
+		case WAIT_EVENT_RECOVERY_WORKER_MAIN:
+			event_name = "RecoveryWorkerMain";
+			break;
+		case WAIT_EVENT_SPARE_BACKEND_MAIN:
+			event_name = "SpareBackendMain";
+			break;
 		case WAIT_EVENT_SYSLOGGER_MAIN:
 			event_name = "SysLoggerMain";
 			break;
@@ -3577,6 +3750,9 @@ pgstat_get_wait_ipc(WaitEventIPC w)
 
 	switch (w)
 	{
+		case WAIT_EVENT_APPEND_READY:
+			event_name = "AppendReady";
+			break;
 		case WAIT_EVENT_BGWORKER_SHUTDOWN:
 			event_name = "BgWorkerShutdown";
 			break;
@@ -3586,6 +3762,9 @@ pgstat_get_wait_ipc(WaitEventIPC w)
 		case WAIT_EVENT_BTREE_PAGE:
 			event_name = "BtreePage";
 			break;
+		case WAIT_EVENT_CHECKPOINT_WRITE_BATCH:
+			event_name = "CheckpointWriteBatch";
+			break;
 		case WAIT_EVENT_CLOG_GROUP_UPDATE:
 			event_name = "ClogGroupUpdate";
 			break;
@@ -3637,6 +3816,9 @@ pgstat_get_wait_ipc(WaitEventIPC w)
 		case WAIT_EVENT_HASH_GROW_BUCKETS_REINSERTING:
 			event_name = "Hash/GrowBuckets/Reinserting";
 			break;
+		case WAIT_EVENT_LOGICAL_PARALLEL_APPLY_STATE_CHANGE:
+			event_name = "LogicalParallelApplyStateChange";
+			break;
 		case WAIT_EVENT_LOGICAL_SYNC_DATA:
 			event_name = "LogicalSyncData";
 			break;
@@ -3658,6 +3840,12 @@ pgstat_get_wait_ipc(WaitEventIPC w)
 		case WAIT_EVENT_PARALLEL_BITMAP_SCAN:
 			event_name = "ParallelBitmapScan";
 			break;
+		case WAIT_EVENT_PARALLEL_CLUSTER_SCAN:
+			event_name = "ParallelClusterScan";
+			break;
+		case WAIT_EVENT_PARALLEL_COPY:
+			event_name = "ParallelCopy";
+			break;
 		case WAIT_EVENT_PARALLEL_CREATE_INDEX_SCAN:
 			event_name = "ParallelCreateIndexScan";
 			break;
@@ -3670,6 +3858,15 @@ pgstat_get_wait_ipc(WaitEventIPC w)
 		case WAIT_EVENT_PROMOTE:
 			event_name = "Promote";
 			break;
+		case WAIT_EVENT_RECOVERY_WORKER_QUEUE:
+			event_name = "RecoveryWorkerQueue";
+			break;
+		case WAIT_EVENT_REDISTRIBUTE_EXCHANGE:
+			event_name = "RedistributeExchange";
+			break;
+		case WAIT_EVENT_REDISTRIBUTE_START:
+			event_name = "RedistributeStart";
+			break;
 		case WAIT_EVENT_REPLICATION_ORIGIN_DROP:
 			event_name = "ReplicationOriginDrop";
 			break;
@@ -3679,9 +3876,15 @@ pgstat_get_wait_ipc(WaitEventIPC w)
 		case WAIT_EVENT_SAFE_SNAPSHOT:
 			event_name = "SafeSnapshot";
 			break;
+		case WAIT_EVENT_SUBPLAN_HASH_BUILD:
+			event_name = "SubPlanHashBuild";
+			break;
 		case WAIT_EVENT_SYNC_REP:
 			event_name = "SyncRep";
 			break;
+		case WAIT_EVENT_WAL_GROUP_FLUSH:
+			event_name = "WALGroupFlush";
+			break;
 			/* no default case, so that compiler will warn */
 	}
 
@@ -3780,6 +3983,15 @@ pgstat_get_wait_io(WaitEventIO w)
 		case WAIT_EVENT_DATA_FILE_WRITE:
 			event_name = "DataFileWrite";
 			break;
+		case WAIT_EVENT_DOUBLE_WRITE_READ:
+			event_name = "DoubleWriteRead";
+			break;
+		case WAIT_EVENT_DOUBLE_WRITE_SYNC:
+			event_name = "DoubleWriteSync";
+			break;
+		case WAIT_EVENT_DOUBLE_WRITE_WRITE:
+			event_name = "DoubleWriteWrite";
+			break;
 		case WAIT_EVENT_DSM_FILL_ZERO_WRITE:
 			event_name = "DSMFillZeroWrite";
 			break;
@@ -3941,6 +4153,68 @@ pgstat_get_wait_io(WaitEventIO w)
 }
 
 
+/* ----------
+ * pgstat_get_my_query_id() -
+ *
+ *	Return the query identifier our own backend last reported, or 0.
+ * ----------
+ */
+uint64
+pgstat_get_my_query_id(void)
+{
+	if (!MyBEEntry)
+		return UINT64CONST(0);
+
+	/*
+	 * We only read our own entry, which only we write, so there's no need to
+	 * follow the changecount protocol.
+	 */
+	return MyBEEntry->st_query_id;
+}
+
+/* ----------
+ * pgstat_get_backend_query_id() -
+ *
+ *	Return the query ID of the statement being run by the backend with the
+ *	given BackendId, or 0 if there is none.  This reads the shared entry
+ *	directly rather than taking a local snapshot of all entries, so that it
+ *	is cheap enough to be called at a high frequency, e.g. by a wait event
+ *	sampler.
+ * ----------
+ */
+uint64
+pgstat_get_backend_query_id(BackendId backendid)
+{
+	volatile PgBackendStatus *vbeentry;
+	uint64		query_id;
+
+	if (BackendStatusArray == NULL || backendid < 1 || backendid > MaxBackends)
+		return UINT64CONST(0);
+
+	vbeentry = &BackendStatusArray[backendid - 1];
+
+	for (;;)
+	{
+		int			before_changecount;
+		int			after_changecount;
+
+		pgstat_save_changecount_before(vbeentry, before_changecount);
+
+		query_id = vbeentry->st_query_id;
+
+		pgstat_save_changecount_after(vbeentry, after_changecount);
+
+		if (before_changecount == after_changecount &&
+			(before_changecount & 1) == 0)
+			break;
+
+		/* Make sure we can break out of loop if stuck... */
+		CHECK_FOR_INTERRUPTS();
+	}
+
+	return query_id;
+}
+
 /* ----------
  * pgstat_get_backend_current_activity() -
  *
@@ -4145,95 +4419,75 @@ pgstat_get_backend_desc(BackendType backendType)
  */
 
 
-/* ----------
- * pgstat_setheader() -
- *
- *		Set common header fields in a statistics message
- * ----------
- */
-static void
-pgstat_setheader(PgStat_MsgHdr *hdr, StatMsgType mtype)
-{
-	hdr->m_type = mtype;
-}
-
-
-/* ----------
- * pgstat_send() -
- *
- *		Send out one statistics message to the collector
- * ----------
- */
-static void
-pgstat_send(void *msg, int len)
-{
-	int			rc;
-
-	if (pgStatSock == PGINVALID_SOCKET)
-		return;
-
-	((PgStat_MsgHdr *) msg)->m_size = len;
-
-	/* We'll retry after EINTR, but ignore all other failures */
-	do
-	{
-		rc = send(pgStatSock, msg, len, 0);
-	} while (rc < 0 && errno == EINTR);
-
-#ifdef USE_ASSERT_CHECKING
-	/* In debug builds, log send failures ... */
-	if (rc < 0)
-		elog(LOG, "could not send to statistics collector: %m");
-#endif
-}
-
 /* ----------
  * pgstat_send_archiver() -
  *
- *	Tell the collector about the WAL file that we successfully
+ *	Record in the shared statistics the WAL file that we successfully
  *	archived or failed to archive.
  * ----------
  */
 void
 pgstat_send_archiver(const char *xlog, bool failed)
 {
-	PgStat_MsgArchiver msg;
+	PgStat_ArchiverStats *archiver = &pgStatShmem->archiver_stats;
+	TimestampTz now = GetCurrentTimestamp();
 
-	/*
-	 * Prepare and send the message
-	 */
-	pgstat_setheader(&msg.m_hdr, PGSTAT_MTYPE_ARCHIVER);
-	msg.m_failed = failed;
-	StrNCpy(msg.m_xlog, xlog, sizeof(msg.m_xlog));
-	msg.m_timestamp = GetCurrentTimestamp();
-	pgstat_send(&msg, sizeof(msg));
+	SpinLockAcquire(&pgStatShmem->mutex);
+	if (failed)
+	{
+		/* Failed archival attempt */
+		++archiver->failed_count;
+		StrNCpy(archiver->last_failed_wal, xlog,
+				sizeof(archiver->last_failed_wal));
+		archiver->last_failed_timestamp = now;
+	}
+	else
+	{
+		/* Successful archival operation */
+		++archiver->archived_count;
+		StrNCpy(archiver->last_archived_wal, xlog,
+				sizeof(archiver->last_archived_wal));
+		archiver->last_archived_timestamp = now;
+	}
+	SpinLockRelease(&pgStatShmem->mutex);
 }
 
 /* ----------
  * pgstat_send_bgwriter() -
  *
- *		Send bgwriter statistics to the collector
+ *		Add the bgwriter statistics counters to the shared totals
  * ----------
  */
 void
 pgstat_send_bgwriter(void)
 {
 	/* We assume this initializes to zeroes */
-	static const PgStat_MsgBgWriter all_zeroes;
+	static const PgStat_BgWriterCounts all_zeroes;
+	PgStat_GlobalStats *global = &pgStatShmem->global_stats;
+
+	/* The bgwriter and checkpointer report their I/O and WAL from here, too */
+	pgstat_flush_io(false);
+	pgstat_flush_wal(false);
 
 	/*
 	 * This function can be called even if nothing at all has happened. In
-	 * this case, avoid sending a completely empty message to the stats
-	 * collector.
+	 * this case, avoid taking the lock for nothing.
 	 */
-	if (memcmp(&BgWriterStats, &all_zeroes, sizeof(PgStat_MsgBgWriter)) == 0)
+	if (memcmp(&BgWriterStats, &all_zeroes, sizeof(PgStat_BgWriterCounts)) == 0)
 		return;
 
-	/*
-	 * Prepare and send the message
-	 */
-	pgstat_setheader(&BgWriterStats.m_hdr, PGSTAT_MTYPE_BGWRITER);
-	pgstat_send(&BgWriterStats, sizeof(BgWriterStats));
+	SpinLockAcquire(&pgStatShmem->mutex);
+	global->timed_checkpoints += BgWriterStats.m_timed_checkpoints;
+	global->requested_checkpoints += BgWriterStats.m_requested_checkpoints;
+	global->checkpoint_write_time += BgWriterStats.m_checkpoint_write_time;
+	global->checkpoint_sync_time += BgWriterStats.m_checkpoint_sync_time;
+	global->buf_written_checkpoints += BgWriterStats.m_buf_written_checkpoints;
+	global->buf_written_clean += BgWriterStats.m_buf_written_clean;
+	global->maxwritten_clean += BgWriterStats.m_maxwritten_clean;
+	global->buf_written_backend += BgWriterStats.m_buf_written_backend;
+	global->buf_fsync_backend += BgWriterStats.m_buf_fsync_backend;
+	global->buf_alloc += BgWriterStats.m_buf_alloc;
+	SpinLockRelease(&pgStatShmem->mutex);
 
 	/*
 	 * Clear out the statistics buffer, so it can be re-used.
@@ -4241,300 +4495,278 @@ pgstat_send_bgwriter(void)
 	MemSet(&BgWriterStats, 0, sizeof(BgWriterStats));
 }
 
-
 /* ----------
- * PgstatCollectorMain() -
+ * pgstat_count_io_op() -
  *
- *	Start up the statistics collector process.  This is the body of the
- *	postmaster child process.
+ *	Count one I/O operation, without timing information.
+ * ----------
+ */
+void
+pgstat_count_io_op(IOObject io_object, IOContext io_context, IOOp io_op)
+{
+	pendingIOStats[io_object][io_context].counts[io_op]++;
+	have_iostats = true;
+}
+
+/* ----------
+ * pgstat_count_io_op_time() -
  *
- *	The argc/argv parameters are valid only in EXEC_BACKEND case.
+ *	Count one I/O operation that took 'io_time'.  Callers measure that only
+ *	when track_io_timing is enabled, and pass a zero time otherwise.
  * ----------
  */
-NON_EXEC_STATIC void
-PgstatCollectorMain(int argc, char *argv[])
+void
+pgstat_count_io_op_time(IOObject io_object, IOContext io_context, IOOp io_op,
+						instr_time io_time)
 {
-	int			len;
-	PgStat_Msg	msg;
-	int			wr;
+	PgStat_IOCounts *pending = &pendingIOStats[io_object][io_context];
 
-	/*
-	 * Ignore all signals usually bound to some action in the postmaster,
-	 * except SIGHUP and SIGQUIT.  Note we don't need a SIGUSR1 handler to
-	 * support latch operations, because we only use a local latch.
-	 */
-	pqsignal(SIGHUP, pgstat_sighup_handler);
-	pqsignal(SIGINT, SIG_IGN);
-	pqsignal(SIGTERM, SIG_IGN);
-	pqsignal(SIGQUIT, pgstat_exit);
-	pqsignal(SIGALRM, SIG_IGN);
-	pqsignal(SIGPIPE, SIG_IGN);
-	pqsignal(SIGUSR1, SIG_IGN);
-	pqsignal(SIGUSR2, SIG_IGN);
-	/* Reset some signals that are accepted by postmaster but not here */
-	pqsignal(SIGCHLD, SIG_DFL);
-	PG_SETMASK(&UnBlockSig);
+	pending->counts[io_op]++;
+	pending->times[io_op] += INSTR_TIME_GET_MICROSEC(io_time);
+	have_iostats = true;
+}
 
-	/*
-	 * Identify myself via ps
-	 */
-	init_ps_display("stats collector", "", "", "");
+/* ----------
+ * pgstat_flush_io() -
+ *
+ *	Add the I/O counts of this process to the shared totals for its backend
+ *	type.  Unless 'force' is true, this does nothing if the previous flush
+ *	was less than PGSTAT_STAT_INTERVAL msec ago.
+ *
+ *	The counts are kept if we don't know our backend type yet, which is the
+ *	case before pgstat_bestart(); they will be added by a later call.
+ * ----------
+ */
+void
+pgstat_flush_io(bool force)
+{
+	static TimestampTz last_flush = 0;
+	PgStat_IOCounts (*shared)[IOCONTEXT_NUM_TYPES];
+	int			io_object;
+	int			io_context;
+	int			io_op;
 
-	/*
-	 * Read in existing stats files or initialize the stats to zero.
-	 */
-	pgStatRunningInCollector = true;
-	pgStatDBHash = pgstat_read_statsfiles(InvalidOid, true, true);
+	if (!have_iostats || pgStatShmem == NULL)
+		return;
 
-	/*
-	 * Loop to process messages until we get SIGQUIT or detect ungraceful
-	 * death of our parent postmaster.
-	 *
-	 * For performance reasons, we don't want to do ResetLatch/WaitLatch after
-	 * every message; instead, do that only after a recv() fails to obtain a
-	 * message.  (This effectively means that if backends are sending us stuff
-	 * like mad, we won't notice postmaster death until things slack off a
-	 * bit; which seems fine.)	To do that, we have an inner loop that
-	 * iterates as long as recv() succeeds.  We do recognize got_SIGHUP inside
-	 * the inner loop, which means that such interrupts will get serviced but
-	 * the latch won't get cleared until next time there is a break in the
-	 * action.
-	 */
-	for (;;)
+	if (MyBEEntry == NULL || MyBEEntry->st_procpid != MyProcPid)
+		return;
+
+	if (!force)
 	{
-		/* Clear any already-pending wakeups */
-		ResetLatch(MyLatch);
+		TimestampTz now = GetCurrentTimestamp();
 
-		/*
-		 * Quit if we get SIGQUIT from the postmaster.
-		 */
-		if (need_exit)
-			break;
-
-		/*
-		 * Inner loop iterates as long as we keep getting messages, or until
-		 * need_exit becomes set.
-		 */
-		while (!need_exit)
-		{
-			/*
-			 * Reload configuration if we got SIGHUP from the postmaster.
-			 */
-			if (got_SIGHUP)
-			{
-				got_SIGHUP = false;
-				ProcessConfigFile(PGC_SIGHUP);
-			}
-
-			/*
-			 * Write the stats file(s) if a new request has arrived that is
-			 * not satisfied by existing file(s).
-			 */
-			if (pgstat_write_statsfile_needed())
-				pgstat_write_statsfiles(false, false);
-
-			/*
-			 * Try to receive and process a message.  This will not block,
-			 * since the socket is set to non-blocking mode.
-			 *
-			 * XXX On Windows, we have to force pgwin32_recv to cooperate,
-			 * despite the previous use of pg_set_noblock() on the socket.
-			 * This is extremely broken and should be fixed someday.
-			 */
-#ifdef WIN32
-			pgwin32_noblock = 1;
-#endif
+		if (!TimestampDifferenceExceeds(last_flush, now, PGSTAT_STAT_INTERVAL))
+			return;
+		last_flush = now;
+	}
 
-			len = recv(pgStatSock, (char *) &msg,
-					   sizeof(PgStat_Msg), 0);
+	shared = pgStatShmem->io_stats.stats[MyBEEntry->st_backendType];
 
-#ifdef WIN32
-			pgwin32_noblock = 0;
-#endif
+	SpinLockAcquire(&pgStatShmem->io_mutex);
+	for (io_object = 0; io_object < IOOBJECT_NUM_TYPES; io_object++)
+	{
+		for (io_context = 0; io_context < IOCONTEXT_NUM_TYPES; io_context++)
+		{
+			PgStat_IOCounts *pending = &pendingIOStats[io_object][io_context];
 
-			if (len < 0)
+			for (io_op = 0; io_op < IOOP_NUM_TYPES; io_op++)
 			{
-				if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
-					break;		/* out of inner loop */
-				ereport(ERROR,
-						(errcode_for_socket_access(),
-						 errmsg("could not read statistics message: %m")));
+				shared[io_object][io_context].counts[io_op] +=
+					pending->counts[io_op];
+				shared[io_object][io_context].times[io_op] +=
+					pending->times[io_op];
 			}
+		}
+	}
+	SpinLockRelease(&pgStatShmem->io_mutex);
 
-			/*
-			 * We ignore messages that are smaller than our common header
-			 */
-			if (len < sizeof(PgStat_MsgHdr))
-				continue;
-
-			/*
-			 * The received length must match the length in the header
-			 */
-			if (msg.msg_hdr.m_size != len)
-				continue;
-
-			/*
-			 * O.K. - we accept this message.  Process it.
-			 */
-			switch (msg.msg_hdr.m_type)
-			{
-				case PGSTAT_MTYPE_DUMMY:
-					break;
-
-				case PGSTAT_MTYPE_INQUIRY:
-					pgstat_recv_inquiry((PgStat_MsgInquiry *) &msg, len);
-					break;
-
-				case PGSTAT_MTYPE_TABSTAT:
-					pgstat_recv_tabstat((PgStat_MsgTabstat *) &msg, len);
-					break;
-
-				case PGSTAT_MTYPE_TABPURGE:
-					pgstat_recv_tabpurge((PgStat_MsgTabpurge *) &msg, len);
-					break;
-
-				case PGSTAT_MTYPE_DROPDB:
-					pgstat_recv_dropdb((PgStat_MsgDropdb *) &msg, len);
-					break;
-
-				case PGSTAT_MTYPE_RESETCOUNTER:
-					pgstat_recv_resetcounter((PgStat_MsgResetcounter *) &msg,
-											 len);
-					break;
-
-				case PGSTAT_MTYPE_RESETSHAREDCOUNTER:
-					pgstat_recv_resetsharedcounter(
-												   (PgStat_MsgResetsharedcounter *) &msg,
-												   len);
-					break;
-
-				case PGSTAT_MTYPE_RESETSINGLECOUNTER:
-					pgstat_recv_resetsinglecounter(
-												   (PgStat_MsgResetsinglecounter *) &msg,
-												   len);
-					break;
-
-				case PGSTAT_MTYPE_AUTOVAC_START:
-					pgstat_recv_autovac((PgStat_MsgAutovacStart *) &msg, len);
-					break;
-
-				case PGSTAT_MTYPE_VACUUM:
-					pgstat_recv_vacuum((PgStat_MsgVacuum *) &msg, len);
-					break;
+	MemSet(pendingIOStats, 0, sizeof(pendingIOStats));
+	have_iostats = false;
+}
 
-				case PGSTAT_MTYPE_ANALYZE:
-					pgstat_recv_analyze((PgStat_MsgAnalyze *) &msg, len);
-					break;
+/* ----------
+ * pgstat_flush_wal() -
+ *
+ *	Add the WAL generation counts of this process to the shared totals.
+ *	Unless 'force' is true, this does nothing if the previous flush was less
+ *	than PGSTAT_STAT_INTERVAL msec ago.
+ * ----------
+ */
+void
+pgstat_flush_wal(bool force)
+{
+	/* We assume this initializes to zeroes */
+	static const PgStat_WalCounts all_zeroes;
+	static TimestampTz last_flush = 0;
+	PgStat_WalStats *wal;
 
-				case PGSTAT_MTYPE_ARCHIVER:
-					pgstat_recv_archiver((PgStat_MsgArchiver *) &msg, len);
-					break;
+	if (pgStatShmem == NULL ||
+		memcmp(&WalStats, &all_zeroes, sizeof(PgStat_WalCounts)) == 0)
+		return;
 
-				case PGSTAT_MTYPE_BGWRITER:
-					pgstat_recv_bgwriter((PgStat_MsgBgWriter *) &msg, len);
-					break;
+	if (!force)
+	{
+		TimestampTz now = GetCurrentTimestamp();
 
-				case PGSTAT_MTYPE_FUNCSTAT:
-					pgstat_recv_funcstat((PgStat_MsgFuncstat *) &msg, len);
-					break;
+		if (!TimestampDifferenceExceeds(last_flush, now, PGSTAT_STAT_INTERVAL))
+			return;
+		last_flush = now;
+	}
 
-				case PGSTAT_MTYPE_FUNCPURGE:
-					pgstat_recv_funcpurge((PgStat_MsgFuncpurge *) &msg, len);
-					break;
+	wal = &pgStatShmem->wal_stats;
 
-				case PGSTAT_MTYPE_RECOVERYCONFLICT:
-					pgstat_recv_recoveryconflict((PgStat_MsgRecoveryConflict *) &msg, len);
-					break;
+	SpinLockAcquire(&pgStatShmem->mutex);
+	wal->wal_records += WalStats.m_wal_records;
+	wal->wal_fpi += WalStats.m_wal_fpi;
+	wal->wal_bytes += WalStats.m_wal_bytes;
+	wal->wal_buffers_full += WalStats.m_wal_buffers_full;
+	SpinLockRelease(&pgStatShmem->mutex);
 
-				case PGSTAT_MTYPE_DEADLOCK:
-					pgstat_recv_deadlock((PgStat_MsgDeadlock *) &msg, len);
-					break;
+	MemSet(&WalStats, 0, sizeof(WalStats));
+}
 
-				case PGSTAT_MTYPE_TEMPFILE:
-					pgstat_recv_tempfile((PgStat_MsgTempFile *) &msg, len);
-					break;
+/* ----------
+ * pgstat_get_io_object_name() -
+ *
+ *	Return a string representing the given I/O object, for the pg_stat_io
+ *	view.
+ * ----------
+ */
+const char *
+pgstat_get_io_object_name(IOObject io_object)
+{
+	switch (io_object)
+	{
+		case IOOBJECT_RELATION:
+			return "relation";
+		case IOOBJECT_TEMP_RELATION:
+			return "temp relation";
+	}
 
-				default:
-					break;
-			}
-		}						/* end of inner message-processing loop */
-
-		/* Sleep until there's something to do */
-#ifndef WIN32
-		wr = WaitLatchOrSocket(MyLatch,
-							   WL_LATCH_SET | WL_POSTMASTER_DEATH | WL_SOCKET_READABLE,
-							   pgStatSock, -1L,
-							   WAIT_EVENT_PGSTAT_MAIN);
-#else
+	elog(ERROR, "unrecognized IOObject value: %d", io_object);
+	return NULL;				/* keep compiler quiet */
+}
 
-		/*
-		 * Windows, at least in its Windows Server 2003 R2 incarnation,
-		 * sometimes loses FD_READ events.  Waking up and retrying the recv()
-		 * fixes that, so don't sleep indefinitely.  This is a crock of the
-		 * first water, but until somebody wants to debug exactly what's
-		 * happening there, this is the best we can do.  The two-second
-		 * timeout matches our pre-9.2 behavior, and needs to be short enough
-		 * to not provoke "using stale statistics" complaints from
-		 * backend_read_statsfile.
-		 */
-		wr = WaitLatchOrSocket(MyLatch,
-							   WL_LATCH_SET | WL_POSTMASTER_DEATH | WL_SOCKET_READABLE | WL_TIMEOUT,
-							   pgStatSock,
-							   2 * 1000L /* msec */ ,
-							   WAIT_EVENT_PGSTAT_MAIN);
-#endif
+/* ----------
+ * pgstat_get_io_context_name() -
+ *
+ *	Return a string representing the given I/O context, for the pg_stat_io
+ *	view.
+ * ----------
+ */
+const char *
+pgstat_get_io_context_name(IOContext io_context)
+{
+	switch (io_context)
+	{
+		case IOCONTEXT_NORMAL:
+			return "normal";
+		case IOCONTEXT_VACUUM:
+			return "vacuum";
+		case IOCONTEXT_BULKREAD:
+			return "bulkread";
+		case IOCONTEXT_BULKWRITE:
+			return "bulkwrite";
+	}
 
-		/*
-		 * Emergency bailout if postmaster has died.  This is to avoid the
-		 * necessity for manual cleanup of all postmaster children.
-		 */
-		if (wr & WL_POSTMASTER_DEATH)
-			break;
-	}							/* end of outer loop */
+	elog(ERROR, "unrecognized IOContext value: %d", io_context);
+	return NULL;				/* keep compiler quiet */
+}
 
+/* ----------
+ * pgstat_tracks_io_object() -
+ *
+ *	Can processes of the given type do I/O on the given object in the given
+ *	context at all?  The pg_stat_io view leaves out the combinations that
+ *	cannot occur, which would only ever show zeroes.
+ * ----------
+ */
+bool
+pgstat_tracks_io_object(BackendType bktype, IOObject io_object,
+						IOContext io_context)
+{
 	/*
-	 * Save the final stats to reuse at next startup.
+	 * Temporary relations live in local buffers, which are not used with a
+	 * buffer access strategy, and only regular backends and background
+	 * workers can have them.
 	 */
-	pgstat_write_statsfiles(true, true);
+	if (io_object == IOOBJECT_TEMP_RELATION)
+		return io_context == IOCONTEXT_NORMAL &&
+			(bktype == B_BACKEND || bktype == B_BG_WORKER);
+
+	/* Auxiliary processes don't use buffer access strategies */
+	if (io_context != IOCONTEXT_NORMAL)
+		return bktype == B_BACKEND || bktype == B_BG_WORKER ||
+			bktype == B_AUTOVAC_WORKER || bktype == B_WAL_SENDER;
 
-	exit(0);
+	return true;
 }
 
 
-/* SIGQUIT signal handler for collector process */
+/* ----------
+ * pgstat_attach_shmem() -
+ *
+ *	Attach to the shared hash tables, unless we already did.  The
+ *	attachment is kept until pgstat_detach_shmem() at process exit.
+ * ----------
+ */
 static void
-pgstat_exit(SIGNAL_ARGS)
+pgstat_attach_shmem(void)
 {
-	int			save_errno = errno;
+	MemoryContext oldcontext;
+
+	if (pgStatArea != NULL)
+		return;
+
+	oldcontext = MemoryContextSwitchTo(TopMemoryContext);
 
-	need_exit = true;
-	SetLatch(MyLatch);
+	pgStatArea = dsa_attach_in_place(PgStatDSAPlace(pgStatShmem), NULL);
+	dsa_pin_mapping(pgStatArea);
 
-	errno = save_errno;
+	pgStatDBShared = dshash_attach(pgStatArea, &db_hash_params,
+								   pgStatShmem->db_hash_handle, NULL);
+	pgStatTabShared = dshash_attach(pgStatArea, &tab_hash_params,
+									pgStatShmem->tab_hash_handle, NULL);
+	pgStatFuncShared = dshash_attach(pgStatArea, &func_hash_params,
+									 pgStatShmem->func_hash_handle, NULL);
+
+	MemoryContextSwitchTo(oldcontext);
 }
 
-/* SIGHUP handler for collector process */
+/* ----------
+ * pgstat_detach_shmem() -
+ *
+ *	Detach from the shared hash tables.  Afterwards, reporting functions
+ *	silently do nothing.
+ * ----------
+ */
 static void
-pgstat_sighup_handler(SIGNAL_ARGS)
+pgstat_detach_shmem(void)
 {
-	int			save_errno = errno;
+	if (pgStatArea == NULL)
+		return;
 
-	got_SIGHUP = true;
-	SetLatch(MyLatch);
+	dshash_detach(pgStatDBShared);
+	dshash_detach(pgStatTabShared);
+	dshash_detach(pgStatFuncShared);
+	dsa_detach(pgStatArea);
 
-	errno = save_errno;
+	pgStatDBShared = NULL;
+	pgStatTabShared = NULL;
+	pgStatFuncShared = NULL;
+	pgStatArea = NULL;
 }
 
 /*
  * Subroutine to clear stats in a database entry
  *
- * Tables and functions hashes are initialized to empty.
+ * The database's tables and functions are not affected; see
+ * pgstat_drop_db_objects.
  */
 static void
 reset_dbentry_counters(PgStat_StatDBEntry *dbentry)
 {
-	HASHCTL		hash_ctl;
-
 	dbentry->n_xact_commit = 0;
 	dbentry->n_xact_rollback = 0;
 	dbentry->n_blocks_fetched = 0;
@@ -4557,48 +4789,25 @@ reset_dbentry_counters(PgStat_StatDBEntry *dbentry)
 	dbentry->n_block_write_time = 0;
 
 	dbentry->stat_reset_timestamp = GetCurrentTimestamp();
-	dbentry->stats_timestamp = 0;
-
-	memset(&hash_ctl, 0, sizeof(hash_ctl));
-	hash_ctl.keysize = sizeof(Oid);
-	hash_ctl.entrysize = sizeof(PgStat_StatTabEntry);
-	dbentry->tables = hash_create("Per-database table",
-								  PGSTAT_TAB_HASH_SIZE,
-								  &hash_ctl,
-								  HASH_ELEM | HASH_BLOBS);
-
-	hash_ctl.keysize = sizeof(Oid);
-	hash_ctl.entrysize = sizeof(PgStat_StatFuncEntry);
-	dbentry->functions = hash_create("Per-database function",
-									 PGSTAT_FUNCTION_HASH_SIZE,
-									 &hash_ctl,
-									 HASH_ELEM | HASH_BLOBS);
 }
 
 /*
- * Lookup the hash table entry for the specified database. If no hash
- * table entry exists, initialize it, if the create parameter is true.
- * Else, return NULL.
+ * Lookup the shared hash table entry for the specified database, creating
+ * it if it doesn't exist yet.
+ *
+ * The entry is returned exclusively locked; the caller must release it with
+ * dshash_release_lock() before looking up any other shared entry.
  */
 static PgStat_StatDBEntry *
-pgstat_get_db_entry(Oid databaseid, bool create)
+pgstat_get_db_entry(Oid databaseid)
 {
 	PgStat_StatDBEntry *result;
 	bool		found;
-	HASHACTION	action = (create ? HASH_ENTER : HASH_FIND);
 
-	/* Lookup or create the hash table entry for this database */
-	result = (PgStat_StatDBEntry *) hash_search(pgStatDBHash,
-												&databaseid,
-												action, &found);
-
-	if (!create && !found)
-		return NULL;
+	result = (PgStat_StatDBEntry *)
+		dshash_find_or_insert(pgStatDBShared, &databaseid, &found);
 
-	/*
-	 * If not found, initialize the new one.  This creates empty hash tables
-	 * for tables and functions, too.
-	 */
+	/* If not found, initialize the new one. */
 	if (!found)
 		reset_dbentry_counters(result);
 
@@ -4607,77 +4816,82 @@ pgstat_get_db_entry(Oid databaseid, bool create)
 
 
 /*
- * Lookup the hash table entry for the specified table. If no hash
- * table entry exists, initialize it, if the create parameter is true.
- * Else, return NULL.
+ * Lookup the shared hash table entry for the specified table, creating it
+ * if it doesn't exist yet.  As with pgstat_get_db_entry, the entry is
+ * returned exclusively locked.
  */
-static PgStat_StatTabEntry *
-pgstat_get_tab_entry(PgStat_StatDBEntry *dbentry, Oid tableoid, bool create)
+static PgStat_SharedTabEntry *
+pgstat_get_tab_entry(Oid databaseid, Oid tableoid)
 {
-	PgStat_StatTabEntry *result;
+	PgStat_SharedTabEntry *result;
+	PgStat_HashKey key;
 	bool		found;
-	HASHACTION	action = (create ? HASH_ENTER : HASH_FIND);
-
-	/* Lookup or create the hash table entry for this table */
-	result = (PgStat_StatTabEntry *) hash_search(dbentry->tables,
-												 &tableoid,
-												 action, &found);
 
-	if (!create && !found)
-		return NULL;
+	key.databaseid = databaseid;
+	key.objectid = tableoid;
+	result = (PgStat_SharedTabEntry *)
+		dshash_find_or_insert(pgStatTabShared, &key, &found);
 
 	/* If not found, initialize the new one. */
 	if (!found)
 	{
-		result->numscans = 0;
-		result->tuples_returned = 0;
-		result->tuples_fetched = 0;
-		result->tuples_inserted = 0;
-		result->tuples_updated = 0;
-		result->tuples_deleted = 0;
-		result->tuples_hot_updated = 0;
-		result->n_live_tuples = 0;
-		result->n_dead_tuples = 0;
-		result->changes_since_analyze = 0;
-		result->blocks_fetched = 0;
-		result->blocks_hit = 0;
-		result->vacuum_timestamp = 0;
-		result->vacuum_count = 0;
-		result->autovac_vacuum_timestamp = 0;
-		result->autovac_vacuum_count = 0;
-		result->analyze_timestamp = 0;
-		result->analyze_count = 0;
-		result->autovac_analyze_timestamp = 0;
-		result->autovac_analyze_count = 0;
+		MemSet(&result->stats, 0, sizeof(PgStat_StatTabEntry));
+		result->stats.tableid = tableoid;
 	}
 
 	return result;
 }
 
+/*
+ * Remove the shared entries of all tables and functions of a database
+ */
+static void
+pgstat_drop_db_objects(Oid databaseid)
+{
+	dshash_seq_status hstat;
+	PgStat_SharedTabEntry *tabentry;
+	PgStat_SharedFuncEntry *funcentry;
+
+	dshash_seq_init(&hstat, pgStatTabShared, true);
+	while ((tabentry = (PgStat_SharedTabEntry *) dshash_seq_next(&hstat)) != NULL)
+	{
+		if (tabentry->key.databaseid == databaseid)
+			dshash_delete_current(&hstat);
+	}
+	dshash_seq_term(&hstat);
+
+	dshash_seq_init(&hstat, pgStatFuncShared, true);
+	while ((funcentry = (PgStat_SharedFuncEntry *) dshash_seq_next(&hstat)) != NULL)
+	{
+		if (funcentry->key.databaseid == databaseid)
+			dshash_delete_current(&hstat);
+	}
+	dshash_seq_term(&hstat);
+}
+
 
 /* ----------
- * pgstat_write_statsfiles() -
- *		Write the global statistics file, as well as requested DB files.
- *
- *	'permanent' specifies writing to the permanent files not temporary ones.
- *	When true (happens only when the collector is shutting down), also remove
- *	the temporary files so that backends starting up under a new postmaster
- *	can't read old data before the new collector is ready.
+ * pgstat_write_statsfile() -
+ *		Write the shared statistics to the permanent stats file.
  *
- *	When 'allDbs' is false, only the requested databases (listed in
- *	pending_write_requests) will be written; otherwise, all databases
- *	will be written.
+ *	The file consists of a format ID, the global and archiver stats structs,
+ *	and then one record per database, table and function, each tagged with
+ *	a letter ('D', 'T' or 'F'), and finally 'E'.
  * ----------
  */
 static void
-pgstat_write_statsfiles(bool permanent, bool allDbs)
+pgstat_write_statsfile(void)
 {
-	HASH_SEQ_STATUS hstat;
+	dshash_seq_status hstat;
 	PgStat_StatDBEntry *dbentry;
+	PgStat_SharedTabEntry *tabentry;
+	PgStat_SharedFuncEntry *funcentry;
+	PgStat_GlobalStats global;
+	PgStat_ArchiverStats archiver;
 	FILE	   *fpout;
 	int32		format_id;
-	const char *tmpfile = permanent ? PGSTAT_STAT_PERMANENT_TMPFILE : pgstat_stat_tmpname;
-	const char *statfile = permanent ? PGSTAT_STAT_PERMANENT_FILENAME : pgstat_stat_filename;
+	const char *tmpfile = PGSTAT_STAT_PERMANENT_TMPFILE;
+	const char *statfile = PGSTAT_STAT_PERMANENT_FILENAME;
 	int			rc;
 
 	elog(DEBUG2, "writing stats file \"%s\"", statfile);
@@ -4695,11 +4909,6 @@ pgstat_write_statsfiles(bool permanent, bool allDbs)
 		return;
 	}
 
-	/*
-	 * Set the timestamp of the stats file.
-	 */
-	globalStats.stats_timestamp = GetCurrentTimestamp();
-
 	/*
 	 * Write the file header --- currently just a format ID.
 	 */
@@ -4708,47 +4917,61 @@ pgstat_write_statsfiles(bool permanent, bool allDbs)
 	(void) rc;					/* we'll check for error with ferror */
 
 	/*
-	 * Write global stats struct
+	 * Write global, archiver, WAL and I/O stats structs
 	 */
-	rc = fwrite(&globalStats, sizeof(globalStats), 1, fpout);
+	SpinLockAcquire(&pgStatShmem->mutex);
+	memcpy(&global, &pgStatShmem->global_stats, sizeof(global));
+	memcpy(&archiver, &pgStatShmem->archiver_stats, sizeof(archiver));
+	memcpy(&walStats, &pgStatShmem->wal_stats, sizeof(walStats));
+	SpinLockRelease(&pgStatShmem->mutex);
+
+	SpinLockAcquire(&pgStatShmem->io_mutex);
+	memcpy(&ioStats, &pgStatShmem->io_stats, sizeof(ioStats));
+	SpinLockRelease(&pgStatShmem->io_mutex);
+
+	global.stats_timestamp = GetCurrentTimestamp();
+	rc = fwrite(&global, sizeof(global), 1, fpout);
 	(void) rc;					/* we'll check for error with ferror */
-
-	/*
-	 * Write archiver stats struct
-	 */
-	rc = fwrite(&archiverStats, sizeof(archiverStats), 1, fpout);
+	rc = fwrite(&archiver, sizeof(archiver), 1, fpout);
+	(void) rc;					/* we'll check for error with ferror */
+	rc = fwrite(&walStats, sizeof(walStats), 1, fpout);
+	(void) rc;					/* we'll check for error with ferror */
+	rc = fwrite(&ioStats, sizeof(ioStats), 1, fpout);
 	(void) rc;					/* we'll check for error with ferror */
 
 	/*
-	 * Walk through the database table.
+	 * Walk through the database, table and function hash tables.
 	 */
-	hash_seq_init(&hstat, pgStatDBHash);
-	while ((dbentry = (PgStat_StatDBEntry *) hash_seq_search(&hstat)) != NULL)
+	dshash_seq_init(&hstat, pgStatDBShared, false);
+	while ((dbentry = (PgStat_StatDBEntry *) dshash_seq_next(&hstat)) != NULL)
 	{
-		/*
-		 * Write out the table and function stats for this DB into the
-		 * appropriate per-DB stat file, if required.
-		 */
-		if (allDbs || pgstat_db_requested(dbentry->databaseid))
-		{
-			/* Make DB's timestamp consistent with the global stats */
-			dbentry->stats_timestamp = globalStats.stats_timestamp;
+		fputc('D', fpout);
+		rc = fwrite(dbentry, sizeof(PgStat_StatDBEntry), 1, fpout);
+		(void) rc;				/* we'll check for error with ferror */
+	}
+	dshash_seq_term(&hstat);
 
-			pgstat_write_db_statsfile(dbentry, permanent);
-		}
+	dshash_seq_init(&hstat, pgStatTabShared, false);
+	while ((tabentry = (PgStat_SharedTabEntry *) dshash_seq_next(&hstat)) != NULL)
+	{
+		fputc('T', fpout);
+		rc = fwrite(tabentry, sizeof(PgStat_SharedTabEntry), 1, fpout);
+		(void) rc;				/* we'll check for error with ferror */
+	}
+	dshash_seq_term(&hstat);
 
-		/*
-		 * Write out the DB entry. We don't write the tables or functions
-		 * pointers, since they're of no use to any other process.
-		 */
-		fputc('D', fpout);
-		rc = fwrite(dbentry, offsetof(PgStat_StatDBEntry, tables), 1, fpout);
+	dshash_seq_init(&hstat, pgStatFuncShared, false);
+	while ((funcentry = (PgStat_SharedFuncEntry *) dshash_seq_next(&hstat)) != NULL)
+	{
+		fputc('F', fpout);
+		rc = fwrite(funcentry, sizeof(PgStat_SharedFuncEntry), 1, fpout);
 		(void) rc;				/* we'll check for error with ferror */
 	}
+	dshash_seq_term(&hstat);
 
 	/*
 	 * No more output to be done. Close the temp file and replace the old
-	 * pgstat.stat with it.  The ferror() check replaces testing for error
+	 * global.stat with it.  The ferror() check replaces testing for error
 	 * after each individual fputc or fwrite above.
 	 */
 	fputc('E', fpout);
@@ -4778,1559 +5001,123 @@ pgstat_write_statsfiles(bool permanent, bool allDbs)
 						tmpfile, statfile)));
 		unlink(tmpfile);
 	}
-
-	if (permanent)
-		unlink(pgstat_stat_filename);
-
-	/*
-	 * Now throw away the list of requests.  Note that requests sent after we
-	 * started the write are still waiting on the network socket.
-	 */
-	list_free(pending_write_requests);
-	pending_write_requests = NIL;
 }
 
-/*
- * return the filename for a DB stat file; filename is the output buffer,
- * of length len.
+
+/* ----------
+ * pgstat_setup_memcxt() -
+ *
+ *	Create pgStatLocalContext, if not already done.
+ * ----------
  */
 static void
-get_dbstat_filename(bool permanent, bool tempname, Oid databaseid,
-					char *filename, int len)
+pgstat_setup_memcxt(void)
 {
-	int			printed;
-
-	/* NB -- pgstat_reset_remove_files knows about the pattern this uses */
-	printed = snprintf(filename, len, "%s/db_%u.%s",
-					   permanent ? PGSTAT_STAT_PERMANENT_DIRECTORY :
-					   pgstat_stat_directory,
-					   databaseid,
-					   tempname ? "tmp" : "stat");
-	if (printed >= len)
-		elog(ERROR, "overlength pgstat path");
+	if (!pgStatLocalContext)
+		pgStatLocalContext = AllocSetContextCreate(TopMemoryContext,
+												   "Statistics snapshot",
+												   ALLOCSET_SMALL_SIZES);
 }
 
+
 /* ----------
- * pgstat_write_db_statsfile() -
- *		Write the stat file for a single database.
+ * pgstat_setup_snapshot() -
  *
- *	If writing to the permanent file (happens when the collector is
- *	shutting down only), remove the temporary file so that backends
- *	starting up under a new postmaster can't read the old data before
- *	the new collector is ready.
+ *	Create the hash tables of the current snapshot, if not already done.
  * ----------
  */
 static void
-pgstat_write_db_statsfile(PgStat_StatDBEntry *dbentry, bool permanent)
+pgstat_setup_snapshot(void)
 {
-	HASH_SEQ_STATUS tstat;
-	HASH_SEQ_STATUS fstat;
-	PgStat_StatTabEntry *tabentry;
-	PgStat_StatFuncEntry *funcentry;
-	FILE	   *fpout;
-	int32		format_id;
-	Oid			dbid = dbentry->databaseid;
-	int			rc;
-	char		tmpfile[MAXPGPATH];
-	char		statfile[MAXPGPATH];
-
-	get_dbstat_filename(permanent, true, dbid, tmpfile, MAXPGPATH);
-	get_dbstat_filename(permanent, false, dbid, statfile, MAXPGPATH);
+	HASHCTL		hash_ctl;
 
-	elog(DEBUG2, "writing stats file \"%s\"", statfile);
+	if (pgStatDBSnapshot != NULL)
+		return;
 
 	/*
-	 * Open the statistics temp file to write out the current values.
+	 * The tables will live in pgStatLocalContext.
 	 */
-	fpout = AllocateFile(tmpfile, PG_BINARY_W);
-	if (fpout == NULL)
-	{
-		ereport(LOG,
-				(errcode_for_file_access(),
-				 errmsg("could not open temporary statistics file \"%s\": %m",
-						tmpfile)));
+	pgstat_setup_memcxt();
+
+	memset(&hash_ctl, 0, sizeof(hash_ctl));
+	hash_ctl.keysize = sizeof(Oid);
+	hash_ctl.entrysize = sizeof(PgStat_StatDBEntry);
+	hash_ctl.hcxt = pgStatLocalContext;
+	pgStatDBSnapshot = hash_create("Databases snapshot",
+								   PGSTAT_DB_HASH_SIZE,
+								   &hash_ctl,
+								   HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+
+	hash_ctl.keysize = sizeof(PgStat_HashKey);
+	hash_ctl.entrysize = sizeof(PgStat_SharedTabEntry);
+	pgStatTabSnapshot = hash_create("Tables snapshot",
+									PGSTAT_TAB_HASH_SIZE,
+									&hash_ctl,
+									HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+
+	hash_ctl.keysize = sizeof(PgStat_HashKey);
+	hash_ctl.entrysize = sizeof(PgStat_SharedFuncEntry);
+	pgStatFuncSnapshot = hash_create("Functions snapshot",
+									 PGSTAT_FUNCTION_HASH_SIZE,
+									 &hash_ctl,
+									 HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+}
+
+
+/* ----------
+ * pgstat_snapshot_global() -
+ *
+ *	Copy the global, archiver, WAL and I/O statistics into our snapshot, if not
+ *	already done.  The time of the copy is recorded as the snapshot's
+ *	timestamp.
+ * ----------
+ */
+static void
+pgstat_snapshot_global(void)
+{
+	if (have_global_snapshot)
 		return;
-	}
 
-	/*
-	 * Write the file header --- currently just a format ID.
-	 */
-	format_id = PGSTAT_FILE_FORMAT_ID;
-	rc = fwrite(&format_id, sizeof(format_id), 1, fpout);
-	(void) rc;					/* we'll check for error with ferror */
+	SpinLockAcquire(&pgStatShmem->mutex);
+	memcpy(&globalStats, &pgStatShmem->global_stats, sizeof(globalStats));
+	memcpy(&archiverStats, &pgStatShmem->archiver_stats, sizeof(archiverStats));
+	memcpy(&walStats, &pgStatShmem->wal_stats, sizeof(walStats));
+	SpinLockRelease(&pgStatShmem->mutex);
 
-	/*
-	 * Walk through the database's access stats per table.
-	 */
-	hash_seq_init(&tstat, dbentry->tables);
-	while ((tabentry = (PgStat_StatTabEntry *) hash_seq_search(&tstat)) != NULL)
-	{
-		fputc('T', fpout);
-		rc = fwrite(tabentry, sizeof(PgStat_StatTabEntry), 1, fpout);
-		(void) rc;				/* we'll check for error with ferror */
-	}
+	SpinLockAcquire(&pgStatShmem->io_mutex);
+	memcpy(&ioStats, &pgStatShmem->io_stats, sizeof(ioStats));
+	SpinLockRelease(&pgStatShmem->io_mutex);
 
-	/*
-	 * Walk through the database's function stats table.
-	 */
-	hash_seq_init(&fstat, dbentry->functions);
-	while ((funcentry = (PgStat_StatFuncEntry *) hash_seq_search(&fstat)) != NULL)
-	{
-		fputc('F', fpout);
-		rc = fwrite(funcentry, sizeof(PgStat_StatFuncEntry), 1, fpout);
-		(void) rc;				/* we'll check for error with ferror */
-	}
+	globalStats.stats_timestamp = GetCurrentTimestamp();
+	have_global_snapshot = true;
+}
 
-	/*
-	 * No more output to be done. Close the temp file and replace the old
-	 * pgstat.stat with it.  The ferror() check replaces testing for error
-	 * after each individual fputc or fwrite above.
-	 */
-	fputc('E', fpout);
-
-	if (ferror(fpout))
-	{
-		ereport(LOG,
-				(errcode_for_file_access(),
-				 errmsg("could not write temporary statistics file \"%s\": %m",
-						tmpfile)));
-		FreeFile(fpout);
-		unlink(tmpfile);
-	}
-	else if (FreeFile(fpout) < 0)
-	{
-		ereport(LOG,
-				(errcode_for_file_access(),
-				 errmsg("could not close temporary statistics file \"%s\": %m",
-						tmpfile)));
-		unlink(tmpfile);
-	}
-	else if (rename(tmpfile, statfile) < 0)
-	{
-		ereport(LOG,
-				(errcode_for_file_access(),
-				 errmsg("could not rename temporary statistics file \"%s\" to \"%s\": %m",
-						tmpfile, statfile)));
-		unlink(tmpfile);
-	}
-
-	if (permanent)
-	{
-		get_dbstat_filename(false, false, dbid, statfile, MAXPGPATH);
-
-		elog(DEBUG2, "removing temporary stats file \"%s\"", statfile);
-		unlink(statfile);
-	}
-}
-
-/* ----------
- * pgstat_read_statsfiles() -
- *
- *	Reads in some existing statistics collector files and returns the
- *	databases hash table that is the top level of the data.
- *
- *	If 'onlydb' is not InvalidOid, it means we only want data for that DB
- *	plus the shared catalogs ("DB 0").  We'll still populate the DB hash
- *	table for all databases, but we don't bother even creating table/function
- *	hash tables for other databases.
- *
- *	'permanent' specifies reading from the permanent files not temporary ones.
- *	When true (happens only when the collector is starting up), remove the
- *	files after reading; the in-memory status is now authoritative, and the
- *	files would be out of date in case somebody else reads them.
- *
- *	If a 'deep' read is requested, table/function stats are read, otherwise
- *	the table/function hash tables remain empty.
- * ----------
- */
-static HTAB *
-pgstat_read_statsfiles(Oid onlydb, bool permanent, bool deep)
-{
-	PgStat_StatDBEntry *dbentry;
-	PgStat_StatDBEntry dbbuf;
-	HASHCTL		hash_ctl;
-	HTAB	   *dbhash;
-	FILE	   *fpin;
-	int32		format_id;
-	bool		found;
-	const char *statfile = permanent ? PGSTAT_STAT_PERMANENT_FILENAME : pgstat_stat_filename;
-
-	/*
-	 * The tables will live in pgStatLocalContext.
-	 */
-	pgstat_setup_memcxt();
-
-	/*
-	 * Create the DB hashtable
-	 */
-	memset(&hash_ctl, 0, sizeof(hash_ctl));
-	hash_ctl.keysize = sizeof(Oid);
-	hash_ctl.entrysize = sizeof(PgStat_StatDBEntry);
-	hash_ctl.hcxt = pgStatLocalContext;
-	dbhash = hash_create("Databases hash", PGSTAT_DB_HASH_SIZE, &hash_ctl,
-						 HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
-
-	/*
-	 * Clear out global and archiver statistics so they start from zero in
-	 * case we can't load an existing statsfile.
-	 */
-	memset(&globalStats, 0, sizeof(globalStats));
-	memset(&archiverStats, 0, sizeof(archiverStats));
-
-	/*
-	 * Set the current timestamp (will be kept only in case we can't load an
-	 * existing statsfile).
-	 */
-	globalStats.stat_reset_timestamp = GetCurrentTimestamp();
-	archiverStats.stat_reset_timestamp = globalStats.stat_reset_timestamp;
-
-	/*
-	 * Try to open the stats file. If it doesn't exist, the backends simply
-	 * return zero for anything and the collector simply starts from scratch
-	 * with empty counters.
-	 *
-	 * ENOENT is a possibility if the stats collector is not running or has
-	 * not yet written the stats file the first time.  Any other failure
-	 * condition is suspicious.
-	 */
-	if ((fpin = AllocateFile(statfile, PG_BINARY_R)) == NULL)
-	{
-		if (errno != ENOENT)
-			ereport(pgStatRunningInCollector ? LOG : WARNING,
-					(errcode_for_file_access(),
-					 errmsg("could not open statistics file \"%s\": %m",
-							statfile)));
-		return dbhash;
-	}
-
-	/*
-	 * Verify it's of the expected format.
-	 */
-	if (fread(&format_id, 1, sizeof(format_id), fpin) != sizeof(format_id) ||
-		format_id != PGSTAT_FILE_FORMAT_ID)
-	{
-		ereport(pgStatRunningInCollector ? LOG : WARNING,
-				(errmsg("corrupted statistics file \"%s\"", statfile)));
-		goto done;
-	}
-
-	/*
-	 * Read global stats struct
-	 */
-	if (fread(&globalStats, 1, sizeof(globalStats), fpin) != sizeof(globalStats))
-	{
-		ereport(pgStatRunningInCollector ? LOG : WARNING,
-				(errmsg("corrupted statistics file \"%s\"", statfile)));
-		memset(&globalStats, 0, sizeof(globalStats));
-		goto done;
-	}
-
-	/*
-	 * In the collector, disregard the timestamp we read from the permanent
-	 * stats file; we should be willing to write a temp stats file immediately
-	 * upon the first request from any backend.  This only matters if the old
-	 * file's timestamp is less than PGSTAT_STAT_INTERVAL ago, but that's not
-	 * an unusual scenario.
-	 */
-	if (pgStatRunningInCollector)
-		globalStats.stats_timestamp = 0;
-
-	/*
-	 * Read archiver stats struct
-	 */
-	if (fread(&archiverStats, 1, sizeof(archiverStats), fpin) != sizeof(archiverStats))
-	{
-		ereport(pgStatRunningInCollector ? LOG : WARNING,
-				(errmsg("corrupted statistics file \"%s\"", statfile)));
-		memset(&archiverStats, 0, sizeof(archiverStats));
-		goto done;
-	}
-
-	/*
-	 * We found an existing collector stats file. Read it and put all the
-	 * hashtable entries into place.
-	 */
-	for (;;)
-	{
-		switch (fgetc(fpin))
-		{
-				/*
-				 * 'D'	A PgStat_StatDBEntry struct describing a database
-				 * follows.
-				 */
-			case 'D':
-				if (fread(&dbbuf, 1, offsetof(PgStat_StatDBEntry, tables),
-						  fpin) != offsetof(PgStat_StatDBEntry, tables))
-				{
-					ereport(pgStatRunningInCollector ? LOG : WARNING,
-							(errmsg("corrupted statistics file \"%s\"",
-									statfile)));
-					goto done;
-				}
-
-				/*
-				 * Add to the DB hash
-				 */
-				dbentry = (PgStat_StatDBEntry *) hash_search(dbhash,
-															 (void *) &dbbuf.databaseid,
-															 HASH_ENTER,
-															 &found);
-				if (found)
-				{
-					ereport(pgStatRunningInCollector ? LOG : WARNING,
-							(errmsg("corrupted statistics file \"%s\"",
-									statfile)));
-					goto done;
-				}
-
-				memcpy(dbentry, &dbbuf, sizeof(PgStat_StatDBEntry));
-				dbentry->tables = NULL;
-				dbentry->functions = NULL;
-
-				/*
-				 * In the collector, disregard the timestamp we read from the
-				 * permanent stats file; we should be willing to write a temp
-				 * stats file immediately upon the first request from any
-				 * backend.
-				 */
-				if (pgStatRunningInCollector)
-					dbentry->stats_timestamp = 0;
-
-				/*
-				 * Don't create tables/functions hashtables for uninteresting
-				 * databases.
-				 */
-				if (onlydb != InvalidOid)
-				{
-					if (dbbuf.databaseid != onlydb &&
-						dbbuf.databaseid != InvalidOid)
-						break;
-				}
-
-				memset(&hash_ctl, 0, sizeof(hash_ctl));
-				hash_ctl.keysize = sizeof(Oid);
-				hash_ctl.entrysize = sizeof(PgStat_StatTabEntry);
-				hash_ctl.hcxt = pgStatLocalContext;
-				dbentry->tables = hash_create("Per-database table",
-											  PGSTAT_TAB_HASH_SIZE,
-											  &hash_ctl,
-											  HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
-
-				hash_ctl.keysize = sizeof(Oid);
-				hash_ctl.entrysize = sizeof(PgStat_StatFuncEntry);
-				hash_ctl.hcxt = pgStatLocalContext;
-				dbentry->functions = hash_create("Per-database function",
-												 PGSTAT_FUNCTION_HASH_SIZE,
-												 &hash_ctl,
-												 HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
-
-				/*
-				 * If requested, read the data from the database-specific
-				 * file.  Otherwise we just leave the hashtables empty.
-				 */
-				if (deep)
-					pgstat_read_db_statsfile(dbentry->databaseid,
-											 dbentry->tables,
-											 dbentry->functions,
-											 permanent);
-
-				break;
-
-			case 'E':
-				goto done;
-
-			default:
-				ereport(pgStatRunningInCollector ? LOG : WARNING,
-						(errmsg("corrupted statistics file \"%s\"",
-								statfile)));
-				goto done;
-		}
-	}
-
-done:
-	FreeFile(fpin);
-
-	/* If requested to read the permanent file, also get rid of it. */
-	if (permanent)
-	{
-		elog(DEBUG2, "removing permanent stats file \"%s\"", statfile);
-		unlink(statfile);
-	}
-
-	return dbhash;
-}
-
-
-/* ----------
- * pgstat_read_db_statsfile() -
- *
- *	Reads in the existing statistics collector file for the given database,
- *	filling the passed-in tables and functions hash tables.
- *
- *	As in pgstat_read_statsfiles, if the permanent file is requested, it is
- *	removed after reading.
- *
- *	Note: this code has the ability to skip storing per-table or per-function
- *	data, if NULL is passed for the corresponding hashtable.  That's not used
- *	at the moment though.
- * ----------
- */
-static void
-pgstat_read_db_statsfile(Oid databaseid, HTAB *tabhash, HTAB *funchash,
-						 bool permanent)
-{
-	PgStat_StatTabEntry *tabentry;
-	PgStat_StatTabEntry tabbuf;
-	PgStat_StatFuncEntry funcbuf;
-	PgStat_StatFuncEntry *funcentry;
-	FILE	   *fpin;
-	int32		format_id;
-	bool		found;
-	char		statfile[MAXPGPATH];
-
-	get_dbstat_filename(permanent, false, databaseid, statfile, MAXPGPATH);
-
-	/*
-	 * Try to open the stats file. If it doesn't exist, the backends simply
-	 * return zero for anything and the collector simply starts from scratch
-	 * with empty counters.
-	 *
-	 * ENOENT is a possibility if the stats collector is not running or has
-	 * not yet written the stats file the first time.  Any other failure
-	 * condition is suspicious.
-	 */
-	if ((fpin = AllocateFile(statfile, PG_BINARY_R)) == NULL)
-	{
-		if (errno != ENOENT)
-			ereport(pgStatRunningInCollector ? LOG : WARNING,
-					(errcode_for_file_access(),
-					 errmsg("could not open statistics file \"%s\": %m",
-							statfile)));
-		return;
-	}
-
-	/*
-	 * Verify it's of the expected format.
-	 */
-	if (fread(&format_id, 1, sizeof(format_id), fpin) != sizeof(format_id) ||
-		format_id != PGSTAT_FILE_FORMAT_ID)
-	{
-		ereport(pgStatRunningInCollector ? LOG : WARNING,
-				(errmsg("corrupted statistics file \"%s\"", statfile)));
-		goto done;
-	}
-
-	/*
-	 * We found an existing collector stats file. Read it and put all the
-	 * hashtable entries into place.
-	 */
-	for (;;)
-	{
-		switch (fgetc(fpin))
-		{
-				/*
-				 * 'T'	A PgStat_StatTabEntry follows.
-				 */
-			case 'T':
-				if (fread(&tabbuf, 1, sizeof(PgStat_StatTabEntry),
-						  fpin) != sizeof(PgStat_StatTabEntry))
-				{
-					ereport(pgStatRunningInCollector ? LOG : WARNING,
-							(errmsg("corrupted statistics file \"%s\"",
-									statfile)));
-					goto done;
-				}
-
-				/*
-				 * Skip if table data not wanted.
-				 */
-				if (tabhash == NULL)
-					break;
-
-				tabentry = (PgStat_StatTabEntry *) hash_search(tabhash,
-															   (void *) &tabbuf.tableid,
-															   HASH_ENTER, &found);
-
-				if (found)
-				{
-					ereport(pgStatRunningInCollector ? LOG : WARNING,
-							(errmsg("corrupted statistics file \"%s\"",
-									statfile)));
-					goto done;
-				}
-
-				memcpy(tabentry, &tabbuf, sizeof(tabbuf));
-				break;
-
-				/*
-				 * 'F'	A PgStat_StatFuncEntry follows.
-				 */
-			case 'F':
-				if (fread(&funcbuf, 1, sizeof(PgStat_StatFuncEntry),
-						  fpin) != sizeof(PgStat_StatFuncEntry))
-				{
-					ereport(pgStatRunningInCollector ? LOG : WARNING,
-							(errmsg("corrupted statistics file \"%s\"",
-									statfile)));
-					goto done;
-				}
-
-				/*
-				 * Skip if function data not wanted.
-				 */
-				if (funchash == NULL)
-					break;
-
-				funcentry = (PgStat_StatFuncEntry *) hash_search(funchash,
-																 (void *) &funcbuf.functionid,
-																 HASH_ENTER, &found);
-
-				if (found)
-				{
-					ereport(pgStatRunningInCollector ? LOG : WARNING,
-							(errmsg("corrupted statistics file \"%s\"",
-									statfile)));
-					goto done;
-				}
-
-				memcpy(funcentry, &funcbuf, sizeof(funcbuf));
-				break;
-
-				/*
-				 * 'E'	The EOF marker of a complete stats file.
-				 */
-			case 'E':
-				goto done;
-
-			default:
-				ereport(pgStatRunningInCollector ? LOG : WARNING,
-						(errmsg("corrupted statistics file \"%s\"",
-								statfile)));
-				goto done;
-		}
-	}
-
-done:
-	FreeFile(fpin);
-
-	if (permanent)
-	{
-		elog(DEBUG2, "removing permanent stats file \"%s\"", statfile);
-		unlink(statfile);
-	}
-}
-
-/* ----------
- * pgstat_read_db_statsfile_timestamp() -
- *
- *	Attempt to determine the timestamp of the last db statfile write.
- *	Returns true if successful; the timestamp is stored in *ts.
- *
- *	This needs to be careful about handling databases for which no stats file
- *	exists, such as databases without a stat entry or those not yet written:
- *
- *	- if there's a database entry in the global file, return the corresponding
- *	stats_timestamp value.
- *
- *	- if there's no db stat entry (e.g. for a new or inactive database),
- *	there's no stats_timestamp value, but also nothing to write so we return
- *	the timestamp of the global statfile.
- * ----------
- */
-static bool
-pgstat_read_db_statsfile_timestamp(Oid databaseid, bool permanent,
-								   TimestampTz *ts)
-{
-	PgStat_StatDBEntry dbentry;
-	PgStat_GlobalStats myGlobalStats;
-	PgStat_ArchiverStats myArchiverStats;
-	FILE	   *fpin;
-	int32		format_id;
-	const char *statfile = permanent ? PGSTAT_STAT_PERMANENT_FILENAME : pgstat_stat_filename;
-
-	/*
-	 * Try to open the stats file.  As above, anything but ENOENT is worthy of
-	 * complaining about.
-	 */
-	if ((fpin = AllocateFile(statfile, PG_BINARY_R)) == NULL)
-	{
-		if (errno != ENOENT)
-			ereport(pgStatRunningInCollector ? LOG : WARNING,
-					(errcode_for_file_access(),
-					 errmsg("could not open statistics file \"%s\": %m",
-							statfile)));
-		return false;
-	}
-
-	/*
-	 * Verify it's of the expected format.
-	 */
-	if (fread(&format_id, 1, sizeof(format_id), fpin) != sizeof(format_id) ||
-		format_id != PGSTAT_FILE_FORMAT_ID)
-	{
-		ereport(pgStatRunningInCollector ? LOG : WARNING,
-				(errmsg("corrupted statistics file \"%s\"", statfile)));
-		FreeFile(fpin);
-		return false;
-	}
-
-	/*
-	 * Read global stats struct
-	 */
-	if (fread(&myGlobalStats, 1, sizeof(myGlobalStats),
-			  fpin) != sizeof(myGlobalStats))
-	{
-		ereport(pgStatRunningInCollector ? LOG : WARNING,
-				(errmsg("corrupted statistics file \"%s\"", statfile)));
-		FreeFile(fpin);
-		return false;
-	}
-
-	/*
-	 * Read archiver stats struct
-	 */
-	if (fread(&myArchiverStats, 1, sizeof(myArchiverStats),
-			  fpin) != sizeof(myArchiverStats))
-	{
-		ereport(pgStatRunningInCollector ? LOG : WARNING,
-				(errmsg("corrupted statistics file \"%s\"", statfile)));
-		FreeFile(fpin);
-		return false;
-	}
-
-	/* By default, we're going to return the timestamp of the global file. */
-	*ts = myGlobalStats.stats_timestamp;
-
-	/*
-	 * We found an existing collector stats file.  Read it and look for a
-	 * record for the requested database.  If found, use its timestamp.
-	 */
-	for (;;)
-	{
-		switch (fgetc(fpin))
-		{
-				/*
-				 * 'D'	A PgStat_StatDBEntry struct describing a database
-				 * follows.
-				 */
-			case 'D':
-				if (fread(&dbentry, 1, offsetof(PgStat_StatDBEntry, tables),
-						  fpin) != offsetof(PgStat_StatDBEntry, tables))
-				{
-					ereport(pgStatRunningInCollector ? LOG : WARNING,
-							(errmsg("corrupted statistics file \"%s\"",
-									statfile)));
-					goto done;
-				}
-
-				/*
-				 * If this is the DB we're looking for, save its timestamp and
-				 * we're done.
-				 */
-				if (dbentry.databaseid == databaseid)
-				{
-					*ts = dbentry.stats_timestamp;
-					goto done;
-				}
-
-				break;
-
-			case 'E':
-				goto done;
-
-			default:
-				ereport(pgStatRunningInCollector ? LOG : WARNING,
-						(errmsg("corrupted statistics file \"%s\"",
-								statfile)));
-				goto done;
-		}
-	}
-
-done:
-	FreeFile(fpin);
-	return true;
-}
-
-/*
- * If not already done, read the statistics collector stats file into
- * some hash tables.  The results will be kept until pgstat_clear_snapshot()
- * is called (typically, at end of transaction).
- */
-static void
-backend_read_statsfile(void)
-{
-	TimestampTz min_ts = 0;
-	TimestampTz ref_ts = 0;
-	Oid			inquiry_db;
-	int			count;
-
-	/* already read it? */
-	if (pgStatDBHash)
-		return;
-	Assert(!pgStatRunningInCollector);
-
-	/*
-	 * In a normal backend, we check staleness of the data for our own DB, and
-	 * so we send MyDatabaseId in inquiry messages.  In the autovac launcher,
-	 * check staleness of the shared-catalog data, and send InvalidOid in
-	 * inquiry messages so as not to force writing unnecessary data.
-	 */
-	if (IsAutoVacuumLauncherProcess())
-		inquiry_db = InvalidOid;
-	else
-		inquiry_db = MyDatabaseId;
-
-	/*
-	 * Loop until fresh enough stats file is available or we ran out of time.
-	 * The stats inquiry message is sent repeatedly in case collector drops
-	 * it; but not every single time, as that just swamps the collector.
-	 */
-	for (count = 0; count < PGSTAT_POLL_LOOP_COUNT; count++)
-	{
-		bool		ok;
-		TimestampTz file_ts = 0;
-		TimestampTz cur_ts;
-
-		CHECK_FOR_INTERRUPTS();
-
-		ok = pgstat_read_db_statsfile_timestamp(inquiry_db, false, &file_ts);
-
-		cur_ts = GetCurrentTimestamp();
-		/* Calculate min acceptable timestamp, if we didn't already */
-		if (count == 0 || cur_ts < ref_ts)
-		{
-			/*
-			 * We set the minimum acceptable timestamp to PGSTAT_STAT_INTERVAL
-			 * msec before now.  This indirectly ensures that the collector
-			 * needn't write the file more often than PGSTAT_STAT_INTERVAL. In
-			 * an autovacuum worker, however, we want a lower delay to avoid
-			 * using stale data, so we use PGSTAT_RETRY_DELAY (since the
-			 * number of workers is low, this shouldn't be a problem).
-			 *
-			 * We don't recompute min_ts after sleeping, except in the
-			 * unlikely case that cur_ts went backwards.  So we might end up
-			 * accepting a file a bit older than PGSTAT_STAT_INTERVAL.  In
-			 * practice that shouldn't happen, though, as long as the sleep
-			 * time is less than PGSTAT_STAT_INTERVAL; and we don't want to
-			 * tell the collector that our cutoff time is less than what we'd
-			 * actually accept.
-			 */
-			ref_ts = cur_ts;
-			if (IsAutoVacuumWorkerProcess())
-				min_ts = TimestampTzPlusMilliseconds(ref_ts,
-													 -PGSTAT_RETRY_DELAY);
-			else
-				min_ts = TimestampTzPlusMilliseconds(ref_ts,
-													 -PGSTAT_STAT_INTERVAL);
-		}
-
-		/*
-		 * If the file timestamp is actually newer than cur_ts, we must have
-		 * had a clock glitch (system time went backwards) or there is clock
-		 * skew between our processor and the stats collector's processor.
-		 * Accept the file, but send an inquiry message anyway to make
-		 * pgstat_recv_inquiry do a sanity check on the collector's time.
-		 */
-		if (ok && file_ts > cur_ts)
-		{
-			/*
-			 * A small amount of clock skew between processors isn't terribly
-			 * surprising, but a large difference is worth logging.  We
-			 * arbitrarily define "large" as 1000 msec.
-			 */
-			if (file_ts >= TimestampTzPlusMilliseconds(cur_ts, 1000))
-			{
-				char	   *filetime;
-				char	   *mytime;
-
-				/* Copy because timestamptz_to_str returns a static buffer */
-				filetime = pstrdup(timestamptz_to_str(file_ts));
-				mytime = pstrdup(timestamptz_to_str(cur_ts));
-				elog(LOG, "stats collector's time %s is later than backend local time %s",
-					 filetime, mytime);
-				pfree(filetime);
-				pfree(mytime);
-			}
-
-			pgstat_send_inquiry(cur_ts, min_ts, inquiry_db);
-			break;
-		}
-
-		/* Normal acceptance case: file is not older than cutoff time */
-		if (ok && file_ts >= min_ts)
-			break;
-
-		/* Not there or too old, so kick the collector and wait a bit */
-		if ((count % PGSTAT_INQ_LOOP_COUNT) == 0)
-			pgstat_send_inquiry(cur_ts, min_ts, inquiry_db);
-
-		pg_usleep(PGSTAT_RETRY_DELAY * 1000L);
-	}
-
-	if (count >= PGSTAT_POLL_LOOP_COUNT)
-		ereport(LOG,
-				(errmsg("using stale statistics instead of current ones "
-						"because stats collector is not responding")));
-
-	/*
-	 * Autovacuum launcher wants stats about all databases, but a shallow read
-	 * is sufficient.  Regular backends want a deep read for just the tables
-	 * they can see (MyDatabaseId + shared catalogs).
-	 */
-	if (IsAutoVacuumLauncherProcess())
-		pgStatDBHash = pgstat_read_statsfiles(InvalidOid, false, false);
-	else
-		pgStatDBHash = pgstat_read_statsfiles(MyDatabaseId, false, true);
-}
-
-
-/* ----------
- * pgstat_setup_memcxt() -
- *
- *	Create pgStatLocalContext, if not already done.
- * ----------
- */
-static void
-pgstat_setup_memcxt(void)
-{
-	if (!pgStatLocalContext)
-		pgStatLocalContext = AllocSetContextCreate(TopMemoryContext,
-												   "Statistics snapshot",
-												   ALLOCSET_SMALL_SIZES);
-}
-
-
-/* ----------
- * pgstat_clear_snapshot() -
- *
- *	Discard any data collected in the current transaction.  Any subsequent
- *	request will cause new snapshots to be read.
- *
- *	This is also invoked during transaction commit or abort to discard
- *	the no-longer-wanted snapshot.
- * ----------
- */
-void
-pgstat_clear_snapshot(void)
-{
-	/* Release memory, if any was allocated */
-	if (pgStatLocalContext)
-		MemoryContextDelete(pgStatLocalContext);
-
-	/* Reset variables */
-	pgStatLocalContext = NULL;
-	pgStatDBHash = NULL;
-	localBackendStatusTable = NULL;
-	localNumBackends = 0;
-}
-
-
-/* ----------
- * pgstat_recv_inquiry() -
- *
- *	Process stat inquiry requests.
- * ----------
- */
-static void
-pgstat_recv_inquiry(PgStat_MsgInquiry *msg, int len)
-{
-	PgStat_StatDBEntry *dbentry;
-
-	elog(DEBUG2, "received inquiry for database %u", msg->databaseid);
-
-	/*
-	 * If there's already a write request for this DB, there's nothing to do.
-	 *
-	 * Note that if a request is found, we return early and skip the below
-	 * check for clock skew.  This is okay, since the only way for a DB
-	 * request to be present in the list is that we have been here since the
-	 * last write round.  It seems sufficient to check for clock skew once per
-	 * write round.
-	 */
-	if (list_member_oid(pending_write_requests, msg->databaseid))
-		return;
-
-	/*
-	 * Check to see if we last wrote this database at a time >= the requested
-	 * cutoff time.  If so, this is a stale request that was generated before
-	 * we updated the DB file, and we don't need to do so again.
-	 *
-	 * If the requestor's local clock time is older than stats_timestamp, we
-	 * should suspect a clock glitch, ie system time going backwards; though
-	 * the more likely explanation is just delayed message receipt.  It is
-	 * worth expending a GetCurrentTimestamp call to be sure, since a large
-	 * retreat in the system clock reading could otherwise cause us to neglect
-	 * to update the stats file for a long time.
-	 */
-	dbentry = pgstat_get_db_entry(msg->databaseid, false);
-	if (dbentry == NULL)
-	{
-		/*
-		 * We have no data for this DB.  Enter a write request anyway so that
-		 * the global stats will get updated.  This is needed to prevent
-		 * backend_read_statsfile from waiting for data that we cannot supply,
-		 * in the case of a new DB that nobody has yet reported any stats for.
-		 * See the behavior of pgstat_read_db_statsfile_timestamp.
-		 */
-	}
-	else if (msg->clock_time < dbentry->stats_timestamp)
-	{
-		TimestampTz cur_ts = GetCurrentTimestamp();
-
-		if (cur_ts < dbentry->stats_timestamp)
-		{
-			/*
-			 * Sure enough, time went backwards.  Force a new stats file write
-			 * to get back in sync; but first, log a complaint.
-			 */
-			char	   *writetime;
-			char	   *mytime;
-
-			/* Copy because timestamptz_to_str returns a static buffer */
-			writetime = pstrdup(timestamptz_to_str(dbentry->stats_timestamp));
-			mytime = pstrdup(timestamptz_to_str(cur_ts));
-			elog(LOG,
-				 "stats_timestamp %s is later than collector's time %s for database %u",
-				 writetime, mytime, dbentry->databaseid);
-			pfree(writetime);
-			pfree(mytime);
-		}
-		else
-		{
-			/*
-			 * Nope, it's just an old request.  Assuming msg's clock_time is
-			 * >= its cutoff_time, it must be stale, so we can ignore it.
-			 */
-			return;
-		}
-	}
-	else if (msg->cutoff_time <= dbentry->stats_timestamp)
-	{
-		/* Stale request, ignore it */
-		return;
-	}
-
-	/*
-	 * We need to write this DB, so create a request.
-	 */
-	pending_write_requests = lappend_oid(pending_write_requests,
-										 msg->databaseid);
-}
-
-
-/* ----------
- * pgstat_recv_tabstat() -
- *
- *	Count what the backend has done.
- * ----------
- */
-static void
-pgstat_recv_tabstat(PgStat_MsgTabstat *msg, int len)
-{
-	PgStat_StatDBEntry *dbentry;
-	PgStat_StatTabEntry *tabentry;
-	int			i;
-	bool		found;
-
-	dbentry = pgstat_get_db_entry(msg->m_databaseid, true);
-
-	/*
-	 * Update database-wide stats.
-	 */
-	dbentry->n_xact_commit += (PgStat_Counter) (msg->m_xact_commit);
-	dbentry->n_xact_rollback += (PgStat_Counter) (msg->m_xact_rollback);
-	dbentry->n_block_read_time += msg->m_block_read_time;
-	dbentry->n_block_write_time += msg->m_block_write_time;
-
-	/*
-	 * Process all table entries in the message.
-	 */
-	for (i = 0; i < msg->m_nentries; i++)
-	{
-		PgStat_TableEntry *tabmsg = &(msg->m_entry[i]);
-
-		tabentry = (PgStat_StatTabEntry *) hash_search(dbentry->tables,
-													   (void *) &(tabmsg->t_id),
-													   HASH_ENTER, &found);
-
-		if (!found)
-		{
-			/*
-			 * If it's a new table entry, initialize counters to the values we
-			 * just got.
-			 */
-			tabentry->numscans = tabmsg->t_counts.t_numscans;
-			tabentry->tuples_returned = tabmsg->t_counts.t_tuples_returned;
-			tabentry->tuples_fetched = tabmsg->t_counts.t_tuples_fetched;
-			tabentry->tuples_inserted = tabmsg->t_counts.t_tuples_inserted;
-			tabentry->tuples_updated = tabmsg->t_counts.t_tuples_updated;
-			tabentry->tuples_deleted = tabmsg->t_counts.t_tuples_deleted;
-			tabentry->tuples_hot_updated = tabmsg->t_counts.t_tuples_hot_updated;
-			tabentry->n_live_tuples = tabmsg->t_counts.t_delta_live_tuples;
-			tabentry->n_dead_tuples = tabmsg->t_counts.t_delta_dead_tuples;
-			tabentry->changes_since_analyze = tabmsg->t_counts.t_changed_tuples;
-			tabentry->blocks_fetched = tabmsg->t_counts.t_blocks_fetched;
-			tabentry->blocks_hit = tabmsg->t_counts.t_blocks_hit;
-
-			tabentry->vacuum_timestamp = 0;
-			tabentry->vacuum_count = 0;
-			tabentry->autovac_vacuum_timestamp = 0;
-			tabentry->autovac_vacuum_count = 0;
-			tabentry->analyze_timestamp = 0;
-			tabentry->analyze_count = 0;
-			tabentry->autovac_analyze_timestamp = 0;
-			tabentry->autovac_analyze_count = 0;
-		}
-		else
-		{
-			/*
-			 * Otherwise add the values to the existing entry.
-			 */
-			tabentry->numscans += tabmsg->t_counts.t_numscans;
-			tabentry->tuples_returned += tabmsg->t_counts.t_tuples_returned;
-			tabentry->tuples_fetched += tabmsg->t_counts.t_tuples_fetched;
-			tabentry->tuples_inserted += tabmsg->t_counts.t_tuples_inserted;
-			tabentry->tuples_updated += tabmsg->t_counts.t_tuples_updated;
-			tabentry->tuples_deleted += tabmsg->t_counts.t_tuples_deleted;
-			tabentry->tuples_hot_updated += tabmsg->t_counts.t_tuples_hot_updated;
-			/* If table was truncated, first reset the live/dead counters */
-			if (tabmsg->t_counts.t_truncated)
-			{
-				tabentry->n_live_tuples = 0;
-				tabentry->n_dead_tuples = 0;
-			}
-			tabentry->n_live_tuples += tabmsg->t_counts.t_delta_live_tuples;
-			tabentry->n_dead_tuples += tabmsg->t_counts.t_delta_dead_tuples;
-			tabentry->changes_since_analyze += tabmsg->t_counts.t_changed_tuples;
-			tabentry->blocks_fetched += tabmsg->t_counts.t_blocks_fetched;
-			tabentry->blocks_hit += tabmsg->t_counts.t_blocks_hit;
-		}
-
-		/* Clamp n_live_tuples in case of negative delta_live_tuples */
-		tabentry->n_live_tuples = Max(tabentry->n_live_tuples, 0);
-		/* Likewise for n_dead_tuples */
-		tabentry->n_dead_tuples = Max(tabentry->n_dead_tuples, 0);
-
-		/*
-		 * Add per-table stats to the per-database entry, too.
-		 */
-		dbentry->n_tuples_returned += tabmsg->t_counts.t_tuples_returned;
-		dbentry->n_tuples_fetched += tabmsg->t_counts.t_tuples_fetched;
-		dbentry->n_tuples_inserted += tabmsg->t_counts.t_tuples_inserted;
-		dbentry->n_tuples_updated += tabmsg->t_counts.t_tuples_updated;
-		dbentry->n_tuples_deleted += tabmsg->t_counts.t_tuples_deleted;
-		dbentry->n_blocks_fetched += tabmsg->t_counts.t_blocks_fetched;
-		dbentry->n_blocks_hit += tabmsg->t_counts.t_blocks_hit;
-	}
-}
-
-
-/* ----------
- * pgstat_recv_tabpurge() -
- *
- *	Arrange for dead table removal.
- * ----------
- */
-static void
-pgstat_recv_tabpurge(PgStat_MsgTabpurge *msg, int len)
-{
-	PgStat_StatDBEntry *dbentry;
-	int			i;
-
-	dbentry = pgstat_get_db_entry(msg->m_databaseid, false);
-
-	/*
-	 * No need to purge if we don't even know the database.
-	 */
-	if (!dbentry || !dbentry->tables)
-		return;
-
-	/*
-	 * Process all table entries in the message.
-	 */
-	for (i = 0; i < msg->m_nentries; i++)
-	{
-		/* Remove from hashtable if present; we don't care if it's not. */
-		(void) hash_search(dbentry->tables,
-						   (void *) &(msg->m_tableid[i]),
-						   HASH_REMOVE, NULL);
-	}
-}
-
-
-/* ----------
- * pgstat_recv_dropdb() -
- *
- *	Arrange for dead database removal
- * ----------
- */
-static void
-pgstat_recv_dropdb(PgStat_MsgDropdb *msg, int len)
-{
-	Oid			dbid = msg->m_databaseid;
-	PgStat_StatDBEntry *dbentry;
-
-	/*
-	 * Lookup the database in the hashtable.
-	 */
-	dbentry = pgstat_get_db_entry(dbid, false);
-
-	/*
-	 * If found, remove it (along with the db statfile).
-	 */
-	if (dbentry)
-	{
-		char		statfile[MAXPGPATH];
-
-		get_dbstat_filename(false, false, dbid, statfile, MAXPGPATH);
-
-		elog(DEBUG2, "removing stats file \"%s\"", statfile);
-		unlink(statfile);
-
-		if (dbentry->tables != NULL)
-			hash_destroy(dbentry->tables);
-		if (dbentry->functions != NULL)
-			hash_destroy(dbentry->functions);
-
-		if (hash_search(pgStatDBHash,
-						(void *) &dbid,
-						HASH_REMOVE, NULL) == NULL)
-			ereport(ERROR,
-					(errmsg("database hash table corrupted during cleanup --- abort")));
-	}
-}
-
-
-/* ----------
- * pgstat_recv_resetcounter() -
- *
- *	Reset the statistics for the specified database.
- * ----------
- */
-static void
-pgstat_recv_resetcounter(PgStat_MsgResetcounter *msg, int len)
-{
-	PgStat_StatDBEntry *dbentry;
-
-	/*
-	 * Lookup the database in the hashtable.  Nothing to do if not there.
-	 */
-	dbentry = pgstat_get_db_entry(msg->m_databaseid, false);
-
-	if (!dbentry)
-		return;
-
-	/*
-	 * We simply throw away all the database's table entries by recreating a
-	 * new hash table for them.
-	 */
-	if (dbentry->tables != NULL)
-		hash_destroy(dbentry->tables);
-	if (dbentry->functions != NULL)
-		hash_destroy(dbentry->functions);
-
-	dbentry->tables = NULL;
-	dbentry->functions = NULL;
-
-	/*
-	 * Reset database-level stats, too.  This creates empty hash tables for
-	 * tables and functions.
-	 */
-	reset_dbentry_counters(dbentry);
-}
-
-/* ----------
- * pgstat_recv_resetshared() -
- *
- *	Reset some shared statistics of the cluster.
- * ----------
- */
-static void
-pgstat_recv_resetsharedcounter(PgStat_MsgResetsharedcounter *msg, int len)
-{
-	if (msg->m_resettarget == RESET_BGWRITER)
-	{
-		/* Reset the global background writer statistics for the cluster. */
-		memset(&globalStats, 0, sizeof(globalStats));
-		globalStats.stat_reset_timestamp = GetCurrentTimestamp();
-	}
-	else if (msg->m_resettarget == RESET_ARCHIVER)
-	{
-		/* Reset the archiver statistics for the cluster. */
-		memset(&archiverStats, 0, sizeof(archiverStats));
-		archiverStats.stat_reset_timestamp = GetCurrentTimestamp();
-	}
-
-	/*
-	 * Presumably the sender of this message validated the target, don't
-	 * complain here if it's not valid
-	 */
-}
-
-/* ----------
- * pgstat_recv_resetsinglecounter() -
- *
- *	Reset a statistics for a single object
- * ----------
- */
-static void
-pgstat_recv_resetsinglecounter(PgStat_MsgResetsinglecounter *msg, int len)
-{
-	PgStat_StatDBEntry *dbentry;
-
-	dbentry = pgstat_get_db_entry(msg->m_databaseid, false);
-
-	if (!dbentry)
-		return;
-
-	/* Set the reset timestamp for the whole database */
-	dbentry->stat_reset_timestamp = GetCurrentTimestamp();
-
-	/* Remove object if it exists, ignore it if not */
-	if (msg->m_resettype == RESET_TABLE)
-		(void) hash_search(dbentry->tables, (void *) &(msg->m_objectid),
-						   HASH_REMOVE, NULL);
-	else if (msg->m_resettype == RESET_FUNCTION)
-		(void) hash_search(dbentry->functions, (void *) &(msg->m_objectid),
-						   HASH_REMOVE, NULL);
-}
-
-/* ----------
- * pgstat_recv_autovac() -
- *
- *	Process an autovacuum signalling message.
- * ----------
- */
-static void
-pgstat_recv_autovac(PgStat_MsgAutovacStart *msg, int len)
-{
-	PgStat_StatDBEntry *dbentry;
-
-	/*
-	 * Store the last autovacuum time in the database's hashtable entry.
-	 */
-	dbentry = pgstat_get_db_entry(msg->m_databaseid, true);
-
-	dbentry->last_autovac_time = msg->m_start_time;
-}
-
-/* ----------
- * pgstat_recv_vacuum() -
- *
- *	Process a VACUUM message.
- * ----------
- */
-static void
-pgstat_recv_vacuum(PgStat_MsgVacuum *msg, int len)
-{
-	PgStat_StatDBEntry *dbentry;
-	PgStat_StatTabEntry *tabentry;
-
-	/*
-	 * Store the data in the table's hashtable entry.
-	 */
-	dbentry = pgstat_get_db_entry(msg->m_databaseid, true);
-
-	tabentry = pgstat_get_tab_entry(dbentry, msg->m_tableoid, true);
-
-	tabentry->n_live_tuples = msg->m_live_tuples;
-	tabentry->n_dead_tuples = msg->m_dead_tuples;
-
-	if (msg->m_autovacuum)
-	{
-		tabentry->autovac_vacuum_timestamp = msg->m_vacuumtime;
-		tabentry->autovac_vacuum_count++;
-	}
-	else
-	{
-		tabentry->vacuum_timestamp = msg->m_vacuumtime;
-		tabentry->vacuum_count++;
-	}
-}
-
-/* ----------
- * pgstat_recv_analyze() -
- *
- *	Process an ANALYZE message.
- * ----------
- */
-static void
-pgstat_recv_analyze(PgStat_MsgAnalyze *msg, int len)
-{
-	PgStat_StatDBEntry *dbentry;
-	PgStat_StatTabEntry *tabentry;
-
-	/*
-	 * Store the data in the table's hashtable entry.
-	 */
-	dbentry = pgstat_get_db_entry(msg->m_databaseid, true);
-
-	tabentry = pgstat_get_tab_entry(dbentry, msg->m_tableoid, true);
-
-	tabentry->n_live_tuples = msg->m_live_tuples;
-	tabentry->n_dead_tuples = msg->m_dead_tuples;
-
-	/*
-	 * If commanded, reset changes_since_analyze to zero.  This forgets any
-	 * changes that were committed while the ANALYZE was in progress, but we
-	 * have no good way to estimate how many of those there were.
-	 */
-	if (msg->m_resetcounter)
-		tabentry->changes_since_analyze = 0;
-
-	if (msg->m_autovacuum)
-	{
-		tabentry->autovac_analyze_timestamp = msg->m_analyzetime;
-		tabentry->autovac_analyze_count++;
-	}
-	else
-	{
-		tabentry->analyze_timestamp = msg->m_analyzetime;
-		tabentry->analyze_count++;
-	}
-}
-
-
-/* ----------
- * pgstat_recv_archiver() -
- *
- *	Process a ARCHIVER message.
- * ----------
- */
-static void
-pgstat_recv_archiver(PgStat_MsgArchiver *msg, int len)
-{
-	if (msg->m_failed)
-	{
-		/* Failed archival attempt */
-		++archiverStats.failed_count;
-		memcpy(archiverStats.last_failed_wal, msg->m_xlog,
-			   sizeof(archiverStats.last_failed_wal));
-		archiverStats.last_failed_timestamp = msg->m_timestamp;
-	}
-	else
-	{
-		/* Successful archival operation */
-		++archiverStats.archived_count;
-		memcpy(archiverStats.last_archived_wal, msg->m_xlog,
-			   sizeof(archiverStats.last_archived_wal));
-		archiverStats.last_archived_timestamp = msg->m_timestamp;
-	}
-}
-
-/* ----------
- * pgstat_recv_bgwriter() -
- *
- *	Process a BGWRITER message.
- * ----------
- */
-static void
-pgstat_recv_bgwriter(PgStat_MsgBgWriter *msg, int len)
-{
-	globalStats.timed_checkpoints += msg->m_timed_checkpoints;
-	globalStats.requested_checkpoints += msg->m_requested_checkpoints;
-	globalStats.checkpoint_write_time += msg->m_checkpoint_write_time;
-	globalStats.checkpoint_sync_time += msg->m_checkpoint_sync_time;
-	globalStats.buf_written_checkpoints += msg->m_buf_written_checkpoints;
-	globalStats.buf_written_clean += msg->m_buf_written_clean;
-	globalStats.maxwritten_clean += msg->m_maxwritten_clean;
-	globalStats.buf_written_backend += msg->m_buf_written_backend;
-	globalStats.buf_fsync_backend += msg->m_buf_fsync_backend;
-	globalStats.buf_alloc += msg->m_buf_alloc;
-}
-
-/* ----------
- * pgstat_recv_recoveryconflict() -
- *
- *	Process a RECOVERYCONFLICT message.
- * ----------
- */
-static void
-pgstat_recv_recoveryconflict(PgStat_MsgRecoveryConflict *msg, int len)
-{
-	PgStat_StatDBEntry *dbentry;
-
-	dbentry = pgstat_get_db_entry(msg->m_databaseid, true);
-
-	switch (msg->m_reason)
-	{
-		case PROCSIG_RECOVERY_CONFLICT_DATABASE:
-
-			/*
-			 * Since we drop the information about the database as soon as it
-			 * replicates, there is no point in counting these conflicts.
-			 */
-			break;
-		case PROCSIG_RECOVERY_CONFLICT_TABLESPACE:
-			dbentry->n_conflict_tablespace++;
-			break;
-		case PROCSIG_RECOVERY_CONFLICT_LOCK:
-			dbentry->n_conflict_lock++;
-			break;
-		case PROCSIG_RECOVERY_CONFLICT_SNAPSHOT:
-			dbentry->n_conflict_snapshot++;
-			break;
-		case PROCSIG_RECOVERY_CONFLICT_BUFFERPIN:
-			dbentry->n_conflict_bufferpin++;
-			break;
-		case PROCSIG_RECOVERY_CONFLICT_STARTUP_DEADLOCK:
-			dbentry->n_conflict_startup_deadlock++;
-			break;
-	}
-}
-
-/* ----------
- * pgstat_recv_deadlock() -
- *
- *	Process a DEADLOCK message.
- * ----------
- */
-static void
-pgstat_recv_deadlock(PgStat_MsgDeadlock *msg, int len)
-{
-	PgStat_StatDBEntry *dbentry;
-
-	dbentry = pgstat_get_db_entry(msg->m_databaseid, true);
-
-	dbentry->n_deadlocks++;
-}
-
-/* ----------
- * pgstat_recv_tempfile() -
- *
- *	Process a TEMPFILE message.
- * ----------
- */
-static void
-pgstat_recv_tempfile(PgStat_MsgTempFile *msg, int len)
-{
-	PgStat_StatDBEntry *dbentry;
-
-	dbentry = pgstat_get_db_entry(msg->m_databaseid, true);
-
-	dbentry->n_temp_bytes += msg->m_filesize;
-	dbentry->n_temp_files += 1;
-}
-
-/* ----------
- * pgstat_recv_funcstat() -
- *
- *	Count what the backend has done.
- * ----------
- */
-static void
-pgstat_recv_funcstat(PgStat_MsgFuncstat *msg, int len)
-{
-	PgStat_FunctionEntry *funcmsg = &(msg->m_entry[0]);
-	PgStat_StatDBEntry *dbentry;
-	PgStat_StatFuncEntry *funcentry;
-	int			i;
-	bool		found;
-
-	dbentry = pgstat_get_db_entry(msg->m_databaseid, true);
-
-	/*
-	 * Process all function entries in the message.
-	 */
-	for (i = 0; i < msg->m_nentries; i++, funcmsg++)
-	{
-		funcentry = (PgStat_StatFuncEntry *) hash_search(dbentry->functions,
-														 (void *) &(funcmsg->f_id),
-														 HASH_ENTER, &found);
-
-		if (!found)
-		{
-			/*
-			 * If it's a new function entry, initialize counters to the values
-			 * we just got.
-			 */
-			funcentry->f_numcalls = funcmsg->f_numcalls;
-			funcentry->f_total_time = funcmsg->f_total_time;
-			funcentry->f_self_time = funcmsg->f_self_time;
-		}
-		else
-		{
-			/*
-			 * Otherwise add the values to the existing entry.
-			 */
-			funcentry->f_numcalls += funcmsg->f_numcalls;
-			funcentry->f_total_time += funcmsg->f_total_time;
-			funcentry->f_self_time += funcmsg->f_self_time;
-		}
-	}
-}
-
-/* ----------
- * pgstat_recv_funcpurge() -
- *
- *	Arrange for dead function removal.
- * ----------
- */
-static void
-pgstat_recv_funcpurge(PgStat_MsgFuncpurge *msg, int len)
-{
-	PgStat_StatDBEntry *dbentry;
-	int			i;
-
-	dbentry = pgstat_get_db_entry(msg->m_databaseid, false);
-
-	/*
-	 * No need to purge if we don't even know the database.
-	 */
-	if (!dbentry || !dbentry->functions)
-		return;
-
-	/*
-	 * Process all function entries in the message.
-	 */
-	for (i = 0; i < msg->m_nentries; i++)
-	{
-		/* Remove from hashtable if present; we don't care if it's not. */
-		(void) hash_search(dbentry->functions,
-						   (void *) &(msg->m_functionid[i]),
-						   HASH_REMOVE, NULL);
-	}
-}
 
 /* ----------
- * pgstat_write_statsfile_needed() -
+ * pgstat_clear_snapshot() -
  *
- *	Do we need to write out any stats files?
- * ----------
- */
-static bool
-pgstat_write_statsfile_needed(void)
-{
-	if (pending_write_requests != NIL)
-		return true;
-
-	/* Everything was written recently */
-	return false;
-}
-
-/* ----------
- * pgstat_db_requested() -
+ *	Discard any data collected in the current transaction.  Any subsequent
+ *	request will cause new snapshots to be taken.
  *
- *	Checks whether stats for a particular DB need to be written to a file.
+ *	This is also invoked during transaction commit or abort to discard
+ *	the no-longer-wanted snapshot.
  * ----------
  */
-static bool
-pgstat_db_requested(Oid databaseid)
+void
+pgstat_clear_snapshot(void)
 {
-	/*
-	 * If any requests are outstanding at all, we should write the stats for
-	 * shared catalogs (the "database" with OID 0).  This ensures that
-	 * backends will see up-to-date stats for shared catalogs, even though
-	 * they send inquiry messages mentioning only their own DB.
-	 */
-	if (databaseid == InvalidOid && pending_write_requests != NIL)
-		return true;
-
-	/* Search to see if there's an open request to write this database. */
-	if (list_member_oid(pending_write_requests, databaseid))
-		return true;
+	/* Release memory, if any was allocated */
+	if (pgStatLocalContext)
+		MemoryContextDelete(pgStatLocalContext);
 
-	return false;
+	/* Reset variables */
+	pgStatLocalContext = NULL;
+	pgStatDBSnapshot = NULL;
+	pgStatTabSnapshot = NULL;
+	pgStatFuncSnapshot = NULL;
+	have_global_snapshot = false;
+	localBackendStatusTable = NULL;
+	localNumBackends = 0;
 }
 
 /*
@@ -95,11 +95,13 @@
 
 #include "access/transam.h"
 #include "access/xlog.h"
+#include "access/xlogworker.h"
 #include "bootstrap/bootstrap.h"
 #include "catalog/pg_control.h"
 #include "common/file_perm.h"
 #include "common/ip.h"
 #include "common/string.h"
+#include "common/zpq_stream.h"
 #include "lib/ilist.h"
 #include "libpq/auth.h"
 #include "libpq/libpq.h"
@@ -111,9 +113,11 @@
 #include "port/pg_bswap.h"
 #include "postmaster/autovacuum.h"
 #include "postmaster/bgworker_internals.h"
+#include "postmaster/ckptwriter.h"
 #include "postmaster/fork_process.h"
 #include "postmaster/pgarch.h"
 #include "postmaster/postmaster.h"
+#include "postmaster/proxy.h"
 #include "postmaster/syslogger.h"
 #include "replication/logicallauncher.h"
 #include "replication/walsender.h"
@@ -165,6 +169,11 @@
  * PMChildSlot.
  *
  * Background workers are in this list, too.
+ *
+ * So are "spare" backends, which have been forked ahead of time and are
+ * waiting for us to pass them a client connection; see StartSpareBackend().
+ * While a backend is spare, spare_sock is the socket we will pass the
+ * connection over.
  */
 typedef struct bkend
 {
@@ -180,6 +189,8 @@ typedef struct bkend
 	int			bkend_type;
 	bool		dead_end;		/* is it going to send an error and quit? */
 	bool		bgworker_notify;	/* gets bgworker start/stop notifications */
+	pgsocket	spare_sock;		/* our end of a spare backend's socket pair,
+								 * or PGINVALID_SOCKET */
 	dlist_node	elem;			/* list link in BackendList */
 } Backend;
 
@@ -217,6 +228,9 @@ int			ReservedBackends;
 #define MAXLISTEN	64
 static pgsocket ListenSocket[MAXLISTEN];
 
+/* The socket(s) the connection proxy listens to; see proxy.c */
+static pgsocket ProxyListenSocket[MAXLISTEN];
+
 /*
  * Set by the -o option
  */
@@ -246,6 +260,12 @@ bool		enable_bonjour = false;
 char	   *bonjour_name;
 bool		restart_after_crash = true;
 
+/* Number of spare backends to keep ready for new connections */
+int			prefork_backends = 0;
+
+/* Number of spare backends currently waiting for a connection */
+static int	nSpareBackends = 0;
+
 /* PIDs of special child processes; 0 when not running */
 static pid_t StartupPID = 0,
 			BgWriterPID = 0,
@@ -254,7 +274,7 @@ static pid_t StartupPID = 0,
 			WalReceiverPID = 0,
 			AutoVacPID = 0,
 			PgArchPID = 0,
-			PgStatPID = 0,
+			ProxyPID = 0,
 			SysLoggerPID = 0;
 
 /* Startup process's status */
@@ -409,6 +429,17 @@ static void SendNegotiateProtocolVersion(List *unrecognized_protocol_options);
 static void processCancelRequest(Port *port, void *pkt);
 static int	initMasks(fd_set *rmask);
 static void report_fork_failure_to_client(Port *port, int errnum);
+static void MaintainSpareBackends(bool replace_all);
+static void ForgetSpareBackend(Backend *bp);
+static bool HandOffConnection(Port *port);
+#ifndef EXEC_BACKEND
+static int	StartSpareBackend(void);
+static void SpareBackendMain(pgsocket sock) pg_attribute_noreturn();
+static bool SendConnection(pgsocket sock, Port *port);
+static Port *ReceiveConnection(pgsocket sock);
+static void spare_sighup_handler(SIGNAL_ARGS);
+static void spare_shutdown_handler(SIGNAL_ARGS);
+#endif
 static CAC_state canAcceptConnections(void);
 static bool RandomCancelKey(int32 *cancel_key);
 static void signal_child(pid_t pid, int signal);
@@ -501,7 +532,7 @@ typedef struct
 	PGPROC	   *AuxiliaryProcs;
 	PGPROC	   *PreparedXactProcs;
 	PMSignalData *PMSignalState;
-	InheritableSocket pgStatSock;
+	PgStat_ShmemControl *pgStatShmem;
 	pid_t		PostmasterPid;
 	TimestampTz PgStartTime;
 	TimestampTz PgReloadTime;
@@ -510,6 +541,7 @@ typedef struct
 	bool		IsBinaryUpgrade;
 	int			max_safe_fds;
 	int			MaxBackends;
+	int			FastPathLockGroupsPerBackend;
 #ifdef WIN32
 	HANDLE		PostmasterHandle;
 	HANDLE		initial_signal_pipe;
@@ -981,6 +1013,10 @@ PostmasterMain(int argc, char *argv[])
 	 */
 	ApplyLauncherRegister();
 
+	/* Likewise for the checkpoint writers and recovery workers */
+	CkptWriterRegister();
+	RecoveryWorkerRegister();
+
 	/*
 	 * process any libraries that should be preloaded at postmaster start
 	 */
@@ -999,10 +1035,22 @@ PostmasterMain(int argc, char *argv[])
 	 * charged with closing the sockets again at postmaster shutdown.
 	 */
 	for (i = 0; i < MAXLISTEN; i++)
+	{
 		ListenSocket[i] = PGINVALID_SOCKET;
+		ProxyListenSocket[i] = PGINVALID_SOCKET;
+	}
 
 	on_proc_exit(CloseServerPorts, 0);
 
+#ifdef EXEC_BACKEND
+	if (proxy_port != 0)
+	{
+		ereport(WARNING,
+				(errmsg("connection proxy is not supported by this build")));
+		proxy_port = 0;
+	}
+#endif
+
 	if (ListenAddresses)
 	{
 		char	   *rawstring;
@@ -1038,6 +1086,17 @@ PostmasterMain(int argc, char *argv[])
 										  NULL,
 										  ListenSocket, MAXLISTEN);
 
+			/* The connection proxy listens on the same addresses */
+			if (status == STATUS_OK && proxy_port != 0 &&
+				StreamServerPort(AF_UNSPEC,
+								 strcmp(curhost, "*") == 0 ? NULL : curhost,
+								 (unsigned short) proxy_port,
+								 NULL,
+								 ProxyListenSocket, MAXLISTEN) != STATUS_OK)
+				ereport(WARNING,
+						(errmsg("could not create connection proxy listen socket for \"%s\"",
+								curhost)));
+
 			if (status == STATUS_OK)
 			{
 				success++;
@@ -1130,6 +1189,15 @@ PostmasterMain(int argc, char *argv[])
 									  socketdir,
 									  ListenSocket, MAXLISTEN);
 
+			if (status == STATUS_OK && proxy_port != 0 &&
+				StreamServerPort(AF_UNIX, NULL,
+								 (unsigned short) proxy_port,
+								 socketdir,
+								 ProxyListenSocket, MAXLISTEN) != STATUS_OK)
+				ereport(WARNING,
+						(errmsg("could not create connection proxy Unix-domain socket in directory \"%s\"",
+								socketdir)));
+
 			if (status == STATUS_OK)
 			{
 				success++;
@@ -1159,6 +1227,13 @@ PostmasterMain(int argc, char *argv[])
 		ereport(FATAL,
 				(errmsg("no socket created for listening")));
 
+	/*
+	 * Set up the key that the connection proxy will present to us, if we are
+	 * going to run one.
+	 */
+	if (ProxyListenSocket[0] != PGINVALID_SOCKET)
+		ProxyGenerateKey();
+
 	/*
 	 * If no valid TCP ports, write an empty line for listen address,
 	 * indicating the Unix socket must be used.  Note that this line is not
@@ -1296,12 +1371,6 @@ PostmasterMain(int argc, char *argv[])
 
 	whereToSendOutput = DestNone;
 
-	/*
-	 * Initialize stats collection subsystem (this does NOT start the
-	 * collector process!)
-	 */
-	pgstat_init();
-
 	/*
 	 * Initialize the autovacuum subsystem (again, no process start yet)
 	 */
@@ -1401,6 +1470,11 @@ CloseServerPorts(int status, Datum arg)
 			StreamClose(ListenSocket[i]);
 			ListenSocket[i] = PGINVALID_SOCKET;
 		}
+		if (ProxyListenSocket[i] != PGINVALID_SOCKET)
+		{
+			StreamClose(ProxyListenSocket[i]);
+			ProxyListenSocket[i] = PGINVALID_SOCKET;
+		}
 	}
 
 	/*
@@ -1696,7 +1770,8 @@ ServerLoop(void)
 					port = ConnCreate(ListenSocket[i]);
 					if (port)
 					{
-						BackendStartup(port);
+						if (!HandOffConnection(port))
+							BackendStartup(port);
 
 						/*
 						 * We no longer need the open socket or port structure
@@ -1750,15 +1825,18 @@ ServerLoop(void)
 				start_autovac_launcher = false; /* signal processed */
 		}
 
-		/* If we have lost the stats collector, try to start a new one */
-		if (PgStatPID == 0 &&
-			(pmState == PM_RUN || pmState == PM_HOT_STANDBY))
-			PgStatPID = pgstat_start();
-
 		/* If we have lost the archiver, try to start a new one. */
 		if (PgArchPID == 0 && PgArchStartupAllowed())
 			PgArchPID = pgarch_start();
 
+		/* Likewise the connection proxy, if we're accepting connections. */
+		if (ProxyPID == 0 && ProxyListenSocket[0] != PGINVALID_SOCKET &&
+			(pmState == PM_RUN || pmState == PM_HOT_STANDBY))
+			ProxyPID = proxy_start(ProxyListenSocket, MAXLISTEN);
+
+		/* Replace spare backends that have been used up, or retire them */
+		MaintainSpareBackends(false);
+
 		/* If we need to signal the autovacuum launcher, do so now */
 		if (avlauncher_needs_signal)
 		{
@@ -1893,6 +1971,8 @@ ProcessStartupPacket(Port *port, bool SSLdone)
 	void	   *buf;
 	ProtocolVersion proto;
 	MemoryContext oldcontext;
+	char	   *proxy_key = NULL;
+	char	   *proxy_client = NULL;
 
 	pq_startmsgread();
 	if (pq_getbytes((char *) &len, 4) == EOF)
@@ -2070,6 +2150,47 @@ retry1:
 									valptr),
 							 errhint("Valid values are: \"false\", 0, \"true\", 1, \"database\".")));
 			}
+			else if (strcmp(nameptr, "proxy_key") == 0)
+				proxy_key = pstrdup(valptr);
+			else if (strcmp(nameptr, "proxy_client") == 0)
+				proxy_client = pstrdup(valptr);
+			else if (strcmp(nameptr, "_pq_.compression") == 0)
+			{
+				/*
+				 * The value lists the compression algorithms the client
+				 * supports.  If we support none of them, the traffic just
+				 * isn't compressed.
+				 */
+#ifdef HAVE_LIBZ
+				char	   *algorithms = pstrdup(valptr);
+				char	   *algorithm;
+
+				for (algorithm = strtok(algorithms, ",");
+					 algorithm != NULL;
+					 algorithm = strtok(NULL, ","))
+				{
+					if (strcmp(algorithm, ZPQ_ALGORITHM_NAME) == 0)
+						port->compression = true;
+				}
+				pfree(algorithms);
+#endif
+			}
+			else if (strcmp(nameptr, "_pq_.row_batch_size") == 0)
+			{
+				char	   *endptr;
+				long		val;
+
+				errno = 0;
+				val = strtol(valptr, &endptr, 10);
+				if (errno != 0 || *valptr == '\0' || *endptr != '\0' ||
+					val < 0 || val > INT_MAX)
+					ereport(FATAL,
+							(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+							 errmsg("invalid value for parameter \"%s\": \"%s\"",
+									"_pq_.row_batch_size",
+									valptr)));
+				port->row_batch_size = (int) val;
+			}
 			else if (strncmp(nameptr, "_pq_.", 5) == 0)
 			{
 				/*
@@ -2147,6 +2268,36 @@ retry1:
 		port->guc_options = NIL;
 	}
 
+	/*
+	 * A connection made by the connection proxy identifies itself with the
+	 * proxy key, which only the postmaster's children know.  If it names the
+	 * client it is acting for, we authenticate that client in the usual way;
+	 * otherwise the backend is started for the proxy's session pool, and
+	 * clients are authenticated later, as they are attached to it.
+	 */
+	if (proxy_key != NULL)
+	{
+		if (!ProxyKeyIsValid(proxy_key))
+			ereport(FATAL,
+					(errcode(ERRCODE_INVALID_AUTHORIZATION_SPECIFICATION),
+					 errmsg("invalid connection proxy key")));
+		port->proxied = true;
+
+		/* the proxy has to see the client's messages */
+		port->compression = false;
+		port->row_batch_size = 0;
+
+		if (proxy_client != NULL)
+			ProxySetClientAddress(port, proxy_client);
+		else
+			port->proxy_authenticated = true;
+	}
+	else if (proxy_client != NULL)
+		ereport(FATAL,
+				(errcode(ERRCODE_PROTOCOL_VIOLATION),
+				 errmsg("parameter \"%s\" requires \"%s\"",
+						"proxy_client", "proxy_key")));
+
 	/* Check a user name was given. */
 	if (port->user_name == NULL || port->user_name[0] == '\0')
 		ereport(FATAL,
@@ -2471,7 +2622,7 @@ ClosePostmasterPorts(bool am_syslogger)
 	postmaster_alive_fds[POSTMASTER_FD_OWN] = -1;
 #endif
 
-	/* Close the listen sockets */
+	/* Close the listen sockets, except the ones the connection proxy needs */
 	for (i = 0; i < MAXLISTEN; i++)
 	{
 		if (ListenSocket[i] != PGINVALID_SOCKET)
@@ -2479,6 +2630,31 @@ ClosePostmasterPorts(bool am_syslogger)
 			StreamClose(ListenSocket[i]);
 			ListenSocket[i] = PGINVALID_SOCKET;
 		}
+		if (ProxyListenSocket[i] != PGINVALID_SOCKET && !am_connection_proxy)
+		{
+			StreamClose(ProxyListenSocket[i]);
+			ProxyListenSocket[i] = PGINVALID_SOCKET;
+		}
+	}
+
+	/*
+	 * Close our ends of the spare backends' socket pairs.  This can't be
+	 * postponed like the list itself, since the spare backends must be the
+	 * only processes holding the other ends.
+	 */
+	{
+		dlist_iter	iter;
+
+		dlist_foreach(iter, &BackendList)
+		{
+			Backend    *bp = dlist_container(Backend, elem, iter.cur);
+
+			if (bp->spare_sock != PGINVALID_SOCKET)
+			{
+				closesocket(bp->spare_sock);
+				bp->spare_sock = PGINVALID_SOCKET;
+			}
+		}
 	}
 
 	/* If using syslogger, close the read side of the pipe */
@@ -2587,10 +2763,10 @@ SIGHUP_handler(SIGNAL_ARGS)
 			signal_child(AutoVacPID, SIGHUP);
 		if (PgArchPID != 0)
 			signal_child(PgArchPID, SIGHUP);
+		if (ProxyPID != 0)
+			signal_child(ProxyPID, SIGHUP);
 		if (SysLoggerPID != 0)
 			signal_child(SysLoggerPID, SIGHUP);
-		if (PgStatPID != 0)
-			signal_child(PgStatPID, SIGHUP);
 
 		/* Reload authentication config files too */
 		if (!load_hba())
@@ -2622,6 +2798,9 @@ SIGHUP_handler(SIGNAL_ARGS)
 		/* Update the starting-point file for future children */
 		write_nondefault_variables(PGC_SIGHUP);
 #endif
+
+		/* Spare backends still have the old configuration; replace them */
+		MaintainSpareBackends(true);
 	}
 
 	PG_SETMASK(&UnBlockSig);
@@ -2681,6 +2860,11 @@ pmdie(SIGNAL_ARGS)
 				/* and the walwriter too */
 				if (WalWriterPID != 0)
 					signal_child(WalWriterPID, SIGTERM);
+				/* the connection proxy waits for its clients to go away */
+				if (ProxyPID != 0)
+					signal_child(ProxyPID, SIGTERM);
+				/* spare backends have no clients to wait for */
+				MaintainSpareBackends(false);
 
 				/*
 				 * If we're in recovery, we can't kill the startup process
@@ -2729,6 +2913,9 @@ pmdie(SIGNAL_ARGS)
 				signal_child(BgWriterPID, SIGTERM);
 			if (WalReceiverPID != 0)
 				signal_child(WalReceiverPID, SIGTERM);
+			/* the connection proxy just drops its clients */
+			if (ProxyPID != 0)
+				signal_child(ProxyPID, SIGQUIT);
 			if (pmState == PM_STARTUP || pmState == PM_RECOVERY)
 			{
 				SignalSomeChildren(SIGTERM, BACKEND_TYPE_BGWORKER);
@@ -2921,8 +3108,6 @@ reaper(SIGNAL_ARGS)
 				AutoVacPID = StartAutoVacLauncher();
 			if (PgArchStartupAllowed() && PgArchPID == 0)
 				PgArchPID = pgarch_start();
-			if (PgStatPID == 0)
-				PgStatPID = pgstat_start();
 
 			/* workers may be scheduled to start now */
 			maybe_start_bgworkers();
@@ -2989,13 +3174,6 @@ reaper(SIGNAL_ARGS)
 				SignalChildren(SIGUSR2);
 
 				pmState = PM_SHUTDOWN_2;
-
-				/*
-				 * We can also shut down the stats collector now; there's
-				 * nothing left for it to do.
-				 */
-				if (PgStatPID != 0)
-					signal_child(PgStatPID, SIGQUIT);
 			}
 			else
 			{
@@ -3073,18 +3251,16 @@ reaper(SIGNAL_ARGS)
 		}
 
 		/*
-		 * Was it the statistics collector?  If so, just try to start a new
-		 * one; no need to force reset of the rest of the system.  (If fail,
-		 * we'll try again in future cycles of the main loop.)
+		 * Was it the connection proxy?  Its clients have lost their sessions,
+		 * but there's no need to reset the rest of the system; ServerLoop
+		 * will start a new one.
 		 */
-		if (pid == PgStatPID)
+		if (pid == ProxyPID)
 		{
-			PgStatPID = 0;
+			ProxyPID = 0;
 			if (!EXIT_STATUS_0(exitstatus))
-				LogChildExit(LOG, _("statistics collector process"),
+				LogChildExit(LOG, _("connection proxy process"),
 							 pid, exitstatus);
-			if (pmState == PM_RUN || pmState == PM_HOT_STANDBY)
-				PgStatPID = pgstat_start();
 			continue;
 		}
 
@@ -3305,6 +3481,7 @@ CleanupBackend(int pid,
 				 */
 				BackgroundWorkerStopNotifications(bp->pid);
 			}
+			ForgetSpareBackend(bp);
 			dlist_delete(iter.cur);
 			free(bp);
 			break;
@@ -3408,6 +3585,7 @@ HandleChildCrash(int pid, int exitstatus, const char *procname)
 				ShmemBackendArrayRemove(bp);
 #endif
 			}
+			ForgetSpareBackend(bp);
 			dlist_delete(iter.cur);
 			free(bp);
 			/* Keep looping so we can signal remaining backends */
@@ -3534,22 +3712,17 @@ HandleChildCrash(int pid, int exitstatus, const char *procname)
 		signal_child(PgArchPID, SIGQUIT);
 	}
 
-	/*
-	 * Force a power-cycle of the pgstat process too.  (This isn't absolutely
-	 * necessary, but it seems like a good idea for robustness, and it
-	 * simplifies the state-machine logic in the case where a shutdown request
-	 * arrives during crash processing.)
-	 */
-	if (PgStatPID != 0 && take_action)
+	/* The connection proxy's sessions are gone, so restart it too */
+	if (ProxyPID != 0 && take_action)
 	{
 		ereport(DEBUG2,
 				(errmsg_internal("sending %s to process %d",
 								 "SIGQUIT",
-								 (int) PgStatPID)));
-		signal_child(PgStatPID, SIGQUIT);
-		allow_immediate_pgstat_restart();
+								 (int) ProxyPID)));
+		signal_child(ProxyPID, SIGQUIT);
 	}
 
+
 	/* We do NOT restart the syslogger */
 
 	if (Shutdown != ImmediateShutdown)
@@ -3741,12 +3914,10 @@ PostmasterStateMachine(void)
 					FatalError = true;
 					pmState = PM_WAIT_DEAD_END;
 
-					/* Kill the walsenders, archiver and stats collector too */
+					/* Kill the walsenders and archiver too */
 					SignalChildren(SIGQUIT);
 					if (PgArchPID != 0)
 						signal_child(PgArchPID, SIGQUIT);
-					if (PgStatPID != 0)
-						signal_child(PgStatPID, SIGQUIT);
 				}
 			}
 		}
@@ -3774,19 +3945,19 @@ PostmasterStateMachine(void)
 	{
 		/*
 		 * PM_WAIT_DEAD_END state ends when the BackendList is entirely empty
-		 * (ie, no dead_end children remain), and the archiver and stats
-		 * collector are gone too.
+		 * (ie, no dead_end children remain), and the archiver and connection
+		 * proxy are gone too.
 		 *
-		 * The reason we wait for those two is to protect them against a new
+		 * The reason we wait for the archiver is to protect it against a new
 		 * postmaster starting conflicting subprocesses; this isn't an
 		 * ironclad protection, but it at least helps in the
-		 * shutdown-and-immediately-restart scenario.  Note that they have
+		 * shutdown-and-immediately-restart scenario.  Note that it has
 		 * already been sent appropriate shutdown signals, either during a
 		 * normal state transition leading up to PM_WAIT_DEAD_END, or during
 		 * FatalError processing.
 		 */
 		if (dlist_is_empty(&BackendList) &&
-			PgArchPID == 0 && PgStatPID == 0)
+			PgArchPID == 0 && ProxyPID == 0)
 		{
 			/* These other guys should be dead already */
 			Assert(StartupPID == 0);
@@ -3986,8 +4157,8 @@ TerminateChildren(int signal)
 		signal_child(AutoVacPID, signal);
 	if (PgArchPID != 0)
 		signal_child(PgArchPID, signal);
-	if (PgStatPID != 0)
-		signal_child(PgStatPID, signal);
+	if (ProxyPID != 0)
+		signal_child(ProxyPID, signal);
 }
 
 /*
@@ -4047,6 +4218,7 @@ BackendStartup(Port *port)
 
 	/* Hasn't asked to be notified about any bgworkers yet */
 	bn->bgworker_notify = false;
+	bn->spare_sock = PGINVALID_SOCKET;
 
 #ifdef EXEC_BACKEND
 	pid = backend_forkexec(port);
@@ -4137,6 +4309,459 @@ report_fork_failure_to_client(Port *port, int errnum)
 }
 
 
+/*
+ * MaintainSpareBackends -- start or retire spare backends as needed
+ *
+ * We keep prefork_backends spare backends around whenever we're accepting
+ * connections.  Spare backends beyond that, or all of them once we stop
+ * accepting connections, are sent SIGTERM.  If 'replace_all' is true, all
+ * of them are replaced by new ones, because they were started with settings
+ * that have since been reloaded.
+ */
+static void
+MaintainSpareBackends(bool replace_all)
+{
+	int			target = 0;
+
+#ifndef EXEC_BACKEND
+	if ((pmState == PM_RUN || pmState == PM_HOT_STANDBY) &&
+		Shutdown == NoShutdown && !FatalError)
+		target = prefork_backends;
+#endif
+
+	if (nSpareBackends > target || (replace_all && nSpareBackends > 0))
+	{
+		dlist_iter	iter;
+
+		dlist_foreach(iter, &BackendList)
+		{
+			Backend    *bp = dlist_container(Backend, elem, iter.cur);
+
+			if (bp->spare_sock == PGINVALID_SOCKET)
+				continue;
+
+			ereport(DEBUG2,
+					(errmsg_internal("sending SIGTERM to spare backend %d",
+									 (int) bp->pid)));
+			signal_child(bp->pid, SIGTERM);
+			ForgetSpareBackend(bp);
+			if (!replace_all && nSpareBackends <= target)
+				break;
+		}
+	}
+
+#ifndef EXEC_BACKEND
+	while (nSpareBackends < target && canAcceptConnections() == CAC_OK)
+	{
+		if (StartSpareBackend() != STATUS_OK)
+			break;
+	}
+#endif
+}
+
+/*
+ * ForgetSpareBackend -- stop treating a backend as spare
+ *
+ * This is called when a spare backend has been given a connection, has been
+ * told to exit, or has exited.  It's a no-op for other backends.
+ */
+static void
+ForgetSpareBackend(Backend *bp)
+{
+	if (bp->spare_sock == PGINVALID_SOCKET)
+		return;
+
+	closesocket(bp->spare_sock);
+	bp->spare_sock = PGINVALID_SOCKET;
+	nSpareBackends--;
+}
+
+/*
+ * HandOffConnection -- pass a new connection to a spare backend
+ *
+ * Returns true if a spare backend took the connection.  Otherwise the caller
+ * should start a backend for it with BackendStartup().
+ */
+static bool
+HandOffConnection(Port *port)
+{
+#ifndef EXEC_BACKEND
+	dlist_iter	iter;
+	CAC_state	cac;
+
+	if (nSpareBackends == 0)
+		return false;
+
+	/*
+	 * Leave the cases where the connection may have to be refused to
+	 * BackendStartup().  CAC_TOOMANY is not one of them: the spare backend is
+	 * already counted, so using it doesn't add a child.
+	 */
+	cac = canAcceptConnections();
+	if (cac != CAC_OK && cac != CAC_TOOMANY)
+		return false;
+	port->canAcceptConnections = CAC_OK;
+
+	dlist_foreach(iter, &BackendList)
+	{
+		Backend    *bp = dlist_container(Backend, elem, iter.cur);
+		bool		sent;
+
+		if (bp->spare_sock == PGINVALID_SOCKET)
+			continue;
+
+		sent = SendConnection(bp->spare_sock, port);
+		ForgetSpareBackend(bp);
+		if (sent)
+		{
+			ereport(DEBUG2,
+					(errmsg_internal("passed connection to spare backend, pid=%d socket=%d",
+									 (int) bp->pid, (int) port->sock)));
+			return true;
+		}
+
+		/* Something is wrong with this one, so get rid of it */
+		signal_child(bp->pid, SIGTERM);
+	}
+#endif							/* EXEC_BACKEND */
+
+	return false;
+}
+
+#ifndef EXEC_BACKEND
+
+/*
+ * StartSpareBackend -- start a spare backend process
+ *
+ * A spare backend is forked before there's a client for it.  It does the
+ * parts of backend startup that don't depend on the client, and then waits
+ * for us to pass it a connection over a socket pair; see SpareBackendMain().
+ * That takes the fork and that part of the initialization out of the
+ * connection's startup latency.
+ *
+ * returns: STATUS_ERROR if we couldn't start one, STATUS_OK otherwise.
+ *
+ * Note: if you change this code, also consider BackendStartup.
+ */
+static int
+StartSpareBackend(void)
+{
+	Backend    *bn;
+	pid_t		pid;
+	int			fds[2];
+
+	bn = (Backend *) malloc(sizeof(Backend));
+	if (!bn)
+	{
+		ereport(LOG,
+				(errcode(ERRCODE_OUT_OF_MEMORY),
+				 errmsg("out of memory")));
+		return STATUS_ERROR;
+	}
+
+	if (!RandomCancelKey(&MyCancelKey))
+	{
+		free(bn);
+		ereport(LOG,
+				(errcode(ERRCODE_INTERNAL_ERROR),
+				 errmsg("could not generate random cancel key")));
+		return STATUS_ERROR;
+	}
+
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0)
+	{
+		free(bn);
+		ereport(LOG,
+				(errcode_for_socket_access(),
+				 errmsg("could not create socket pair for spare backend: %m")));
+		return STATUS_ERROR;
+	}
+
+	bn->cancel_key = MyCancelKey;
+	bn->dead_end = false;
+	bn->child_slot = MyPMChildSlot = AssignPostmasterChildSlot();
+	bn->bgworker_notify = false;
+	bn->spare_sock = fds[0];
+
+	pid = fork_process();
+	if (pid == 0)				/* child */
+	{
+		closesocket(fds[0]);
+		free(bn);
+
+		/* Detangle from postmaster */
+		InitPostmasterChild();
+
+		/* Close the postmaster's sockets */
+		ClosePostmasterPorts(false);
+
+		SpareBackendMain(fds[1]);
+	}
+
+	/* in parent */
+	closesocket(fds[1]);
+
+	if (pid < 0)
+	{
+		/* fork failed */
+		int			save_errno = errno;
+
+		(void) ReleasePostmasterChildSlot(bn->child_slot);
+		closesocket(fds[0]);
+		free(bn);
+		errno = save_errno;
+		ereport(LOG,
+				(errmsg("could not fork spare backend process: %m")));
+		return STATUS_ERROR;
+	}
+
+	ereport(DEBUG2,
+			(errmsg_internal("forked new spare backend, pid=%d", (int) pid)));
+
+	bn->pid = pid;
+	bn->bkend_type = BACKEND_TYPE_NORMAL;
+	dlist_push_head(&BackendList, &bn->elem);
+	nSpareBackends++;
+
+	return STATUS_OK;
+}
+
+/* Flags set by the signal handlers of an idle spare backend */
+static volatile sig_atomic_t spare_got_SIGHUP = false;
+static volatile sig_atomic_t spare_shutdown_requested = false;
+
+static void
+spare_sighup_handler(SIGNAL_ARGS)
+{
+	int			save_errno = errno;
+
+	spare_got_SIGHUP = true;
+	SetLatch(MyLatch);
+
+	errno = save_errno;
+}
+
+static void
+spare_shutdown_handler(SIGNAL_ARGS)
+{
+	int			save_errno = errno;
+
+	spare_shutdown_requested = true;
+	SetLatch(MyLatch);
+
+	errno = save_errno;
+}
+
+/*
+ * SpareBackendMain -- main entry point of a spare backend
+ *
+ * Do the client-independent part of backend initialization, wait for the
+ * postmaster to pass us a connection over 'sock', and then carry on like any
+ * other backend.
+ *
+ * Everything after the startup packet stays where it is: InitProcess()
+ * depends on whether the client asks for a walsender, and the caches can't be
+ * loaded before we're registered for invalidation messages.
+ */
+static void
+SpareBackendMain(pgsocket sock)
+{
+	Port	   *port;
+
+	/*
+	 * Until we have a connection we only have to react to a few signals.  The
+	 * postmaster's handlers for the others mustn't run here, so ignore them;
+	 * that can't lose anything, since nobody has a reason to signal us yet.
+	 *
+	 * On SIGHUP, the postmaster replaces all spare backends with new ones
+	 * that have the new configuration, pg_hba.conf and so on; so we just exit
+	 * in that case.
+	 */
+	pqsignal(SIGHUP, spare_sighup_handler);
+	pqsignal(SIGINT, SIG_IGN);
+	pqsignal(SIGTERM, spare_shutdown_handler);
+	pqsignal(SIGQUIT, spare_shutdown_handler);
+	pqsignal(SIGUSR1, SIG_IGN);
+	pqsignal(SIGCHLD, SIG_DFL);
+
+	init_ps_display("spare backend", "", "", "");
+
+	/* Early initialization; PostgresMain won't repeat it */
+	BaseInit();
+
+	PG_SETMASK(&UnBlockSig);
+
+	for (;;)
+	{
+		int			rc;
+
+		if (spare_shutdown_requested || spare_got_SIGHUP)
+			proc_exit(0);
+
+		rc = WaitLatchOrSocket(MyLatch,
+							   WL_LATCH_SET | WL_SOCKET_READABLE | WL_EXIT_ON_PM_DEATH,
+							   sock, -1L,
+							   WAIT_EVENT_SPARE_BACKEND_MAIN);
+		ResetLatch(MyLatch);
+
+		if (rc & WL_SOCKET_READABLE)
+			break;
+	}
+
+	PG_SETMASK(&BlockSig);
+
+	port = ReceiveConnection(sock);
+	closesocket(sock);
+
+	/* If the postmaster gave up on us instead, just go away */
+	if (port == NULL || spare_shutdown_requested)
+		proc_exit(0);
+
+	/*
+	 * A SIGHUP that arrived just now was meant for the backend we're about to
+	 * become, so send it again; it stays pending until PostgresMain is ready.
+	 */
+	if (spare_got_SIGHUP)
+		kill(MyProcPid, SIGHUP);
+
+	/* As far as anyone can tell, the backend starts now */
+	MyStartTimestamp = GetCurrentTimestamp();
+	MyStartTime = timestamptz_to_time_t(MyStartTimestamp);
+
+	/* Perform additional initialization and collect startup packet */
+	BackendInitialize(port);
+
+	/* And run the backend */
+	BackendRun(port);
+}
+
+/*
+ * SendConnection -- pass a client connection to a spare backend
+ *
+ * The socket goes along as SCM_RIGHTS ancillary data, and the Port built by
+ * ConnCreate() as the message body.
+ */
+static bool
+SendConnection(pgsocket sock, Port *port)
+{
+	struct msghdr msg;
+	struct iovec iov;
+	struct cmsghdr *cmsg;
+	union
+	{
+		struct cmsghdr hdr;
+		char		buf[CMSG_SPACE(sizeof(int))];
+	}			cmsgbuf;
+	ssize_t		rc;
+
+	memset(&msg, 0, sizeof(msg));
+	memset(&cmsgbuf, 0, sizeof(cmsgbuf));
+
+	iov.iov_base = port;
+	iov.iov_len = sizeof(Port);
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = cmsgbuf.buf;
+	msg.msg_controllen = sizeof(cmsgbuf.buf);
+
+	cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+	memcpy(CMSG_DATA(cmsg), &port->sock, sizeof(int));
+
+	do
+	{
+		rc = sendmsg(sock, &msg, 0);
+	} while (rc < 0 && errno == EINTR);
+
+	if (rc != sizeof(Port))
+	{
+		if (rc < 0)
+			ereport(LOG,
+					(errcode_for_socket_access(),
+					 errmsg("could not pass connection to spare backend: %m")));
+		else
+			ereport(LOG,
+					(errmsg("could not pass connection to spare backend")));
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ * ReceiveConnection -- receive a client connection from the postmaster
+ *
+ * Returns NULL if the postmaster closed its end instead.
+ */
+static Port *
+ReceiveConnection(pgsocket sock)
+{
+	Port	   *port;
+	struct msghdr msg;
+	struct iovec iov;
+	struct cmsghdr *cmsg;
+	union
+	{
+		struct cmsghdr hdr;
+		char		buf[CMSG_SPACE(sizeof(int))];
+	}			cmsgbuf;
+	ssize_t		rc;
+
+	/* Like ConnCreate(), use malloc so that this outlives PostmasterContext */
+	if (!(port = (Port *) calloc(1, sizeof(Port))))
+		ereport(FATAL,
+				(errcode(ERRCODE_OUT_OF_MEMORY),
+				 errmsg("out of memory")));
+
+	memset(&msg, 0, sizeof(msg));
+	iov.iov_base = port;
+	iov.iov_len = sizeof(Port);
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = cmsgbuf.buf;
+	msg.msg_controllen = sizeof(cmsgbuf.buf);
+
+	do
+	{
+		rc = recvmsg(sock, &msg, MSG_WAITALL);
+	} while (rc < 0 && errno == EINTR);
+
+	if (rc == 0)
+	{
+		free(port);
+		return NULL;
+	}
+	if (rc < 0)
+		ereport(FATAL,
+				(errcode_for_socket_access(),
+				 errmsg("could not receive connection from postmaster: %m")));
+
+	cmsg = CMSG_FIRSTHDR(&msg);
+	if (rc != sizeof(Port) || cmsg == NULL ||
+		cmsg->cmsg_len != CMSG_LEN(sizeof(int)) ||
+		cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+		ereport(FATAL,
+				(errcode(ERRCODE_PROTOCOL_VIOLATION),
+				 errmsg("invalid connection message from postmaster")));
+	memcpy(&port->sock, CMSG_DATA(cmsg), sizeof(int));
+
+	/* The postmaster's GSSAPI state struct is no use to us; make our own */
+	port->gss = NULL;
+#if defined(ENABLE_GSS) || defined(ENABLE_SSPI)
+	port->gss = (pg_gssinfo *) calloc(1, sizeof(pg_gssinfo));
+	if (!port->gss)
+		ereport(FATAL,
+				(errcode(ERRCODE_OUT_OF_MEMORY),
+				 errmsg("out of memory")));
+#endif
+
+	return port;
+}
+
+#endif							/* EXEC_BACKEND */
+
 /*
  * BackendInitialize -- initialize an interactive (postmaster-child)
  *				backend process, and collect the client's startup packet.
@@ -4289,6 +4914,19 @@ BackendInitialize(Port *port)
 	if (status != STATUS_OK)
 		proc_exit(0);
 
+	/*
+	 * For a connection made by the connection proxy, show the address of the
+	 * client it is acting for, if any.
+	 */
+	if (port->proxied)
+	{
+		if (port->remote_port[0] == '\0')
+			snprintf(remote_ps_data, sizeof(remote_ps_data), "%s", port->remote_host);
+		else
+			snprintf(remote_ps_data, sizeof(remote_ps_data), "%s(%s)",
+					 port->remote_host, port->remote_port);
+	}
+
 	/*
 	 * Now that we have the user and database name, we can set the process
 	 * title for ps.  It's good to do this as early as possible in startup.
@@ -4799,6 +5437,7 @@ SubPostmasterMain(int argc, char *argv[])
 		strcmp(argv[1], "--forkavlauncher") == 0 ||
 		strcmp(argv[1], "--forkavworker") == 0 ||
 		strcmp(argv[1], "--forkboot") == 0 ||
+		strcmp(argv[1], "--forkarch") == 0 ||
 		strncmp(argv[1], "--forkbgworker=", 15) == 0)
 		PGSharedMemoryReAttach();
 	else
@@ -4962,16 +5601,12 @@ SubPostmasterMain(int argc, char *argv[])
 	}
 	if (strcmp(argv[1], "--forkarch") == 0)
 	{
-		/* Do not want to attach to shared memory */
-
+		/*
+		 * The archiver stays attached to the main shared memory segment, to
+		 * update the shared archiver statistics, but it has no PGPROC.
+		 */
 		PgArchiverMain(argc, argv); /* does not return */
 	}
-	if (strcmp(argv[1], "--forkcol") == 0)
-	{
-		/* Do not want to attach to shared memory */
-
-		PgstatCollectorMain(argc, argv);	/* does not return */
-	}
 	if (strcmp(argv[1], "--forklog") == 0)
 	{
 		/* Do not want to attach to shared memory */
@@ -5084,12 +5719,6 @@ sigusr1_handler(SIGNAL_ARGS)
 	if (CheckPostmasterSignal(PMSIGNAL_BEGIN_HOT_STANDBY) &&
 		pmState == PM_RECOVERY && Shutdown == NoShutdown)
 	{
-		/*
-		 * Likewise, start other special children as needed.
-		 */
-		Assert(PgStatPID == 0);
-		PgStatPID = pgstat_start();
-
 		ereport(LOG,
 				(errmsg("database system is ready to accept read only connections")));
 
@@ -5421,6 +6050,7 @@ StartAutovacuumWorker(void)
 			bn->dead_end = false;
 			bn->child_slot = MyPMChildSlot = AssignPostmasterChildSlot();
 			bn->bgworker_notify = false;
+			bn->spare_sock = PGINVALID_SOCKET;
 
 			bn->pid = StartAutoVacWorker();
 			if (bn->pid > 0)
@@ -5790,6 +6420,7 @@ assign_backendlist_entry(RegisteredBgWorker *rw)
 	bn->bkend_type = BACKEND_TYPE_BGWORKER;
 	bn->dead_end = false;
 	bn->bgworker_notify = false;
+	bn->spare_sock = PGINVALID_SOCKET;
 
 	rw->rw_backend = bn;
 	rw->rw_child_slot = bn->child_slot;
@@ -5955,7 +6586,7 @@ extern slock_t *ShmemLock;
 extern slock_t *ProcStructLock;
 extern PGPROC *AuxiliaryProcs;
 extern PMSignalData *PMSignalState;
-extern pgsocket pgStatSock;
+extern PgStat_ShmemControl *pgStatShmem;
 extern pg_time_t first_syslogger_file_time;
 
 #ifndef WIN32
@@ -6008,8 +6639,7 @@ save_backend_variables(BackendParameters *param, Port *port,
 	param->AuxiliaryProcs = AuxiliaryProcs;
 	param->PreparedXactProcs = PreparedXactProcs;
 	param->PMSignalState = PMSignalState;
-	if (!write_inheritable_socket(&param->pgStatSock, pgStatSock, childPid))
-		return false;
+	param->pgStatShmem = pgStatShmem;
 
 	param->PostmasterPid = PostmasterPid;
 	param->PgStartTime = PgStartTime;
@@ -6021,6 +6651,7 @@ save_backend_variables(BackendParameters *param, Port *port,
 	param->max_safe_fds = max_safe_fds;
 
 	param->MaxBackends = MaxBackends;
+	param->FastPathLockGroupsPerBackend = FastPathLockGroupsPerBackend;
 
 #ifdef WIN32
 	param->PostmasterHandle = PostmasterHandle;
@@ -6241,7 +6872,7 @@ restore_backend_variables(BackendParameters *param, Port *port)
 	AuxiliaryProcs = param->AuxiliaryProcs;
 	PreparedXactProcs = param->PreparedXactProcs;
 	PMSignalState = param->PMSignalState;
-	read_inheritable_socket(&pgStatSock, &param->pgStatSock);
+	pgStatShmem = param->pgStatShmem;
 
 	PostmasterPid = param->PostmasterPid;
 	PgStartTime = param->PgStartTime;
@@ -6253,6 +6884,7 @@ restore_backend_variables(BackendParameters *param, Port *port)
 	max_safe_fds = param->max_safe_fds;
 
 	MaxBackends = param->MaxBackends;
+	FastPathLockGroupsPerBackend = param->FastPathLockGroupsPerBackend;
 
 #ifdef WIN32
 	PostmasterHandle = param->PostmasterHandle;
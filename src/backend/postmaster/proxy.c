@@ -0,0 +1,1833 @@
+/*-------------------------------------------------------------------------
+ *
+ * proxy.c
+ *	  Connection proxy: transaction-level pooling of backends
+ *
+ * When proxy_port is set, the postmaster listens on that port too, and
+ * starts a connection proxy process to accept the connections made to it.
+ * The proxy keeps a pool of backends for each distinct set of startup
+ * parameters (user, database and so on), and lends a backend to a client
+ * only while it is in a transaction.  Many mostly idle clients can thus
+ * share a few backends, and a new client usually finds a backend that has
+ * already been started up for it.
+ *
+ * The proxy connects to the postmaster like any other client, adding to
+ * the startup packet a secret key that only the postmaster's children know.
+ * A backend started on behalf of a client authenticates that client in the
+ * usual way.  A backend started for the pool in advance has no client to
+ * authenticate; when the proxy hands it a new client, it sends an 'a'
+ * message, and the backend then runs the authentication exchange with that
+ * client.
+ *
+ * Each ReadyForQuery message from a proxied backend carries an extra byte,
+ * which tells whether the session now holds state that would be lost if it
+ * changed hands: SET variables, prepared statements, temporary tables, held
+ * cursors, session-level locks or LISTEN registrations.  A client whose
+ * session holds such state keeps its backend until the state is gone again,
+ * so compared to a direct connection, clients lose only state that does not
+ * usually outlive a transaction, such as the unnamed prepared statement or
+ * the value of currval().
+ *
+ * Everything here runs in one process, without access to shared memory.
+ * SSL is not supported, and neither are replication connections.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/postmaster/proxy.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#ifdef HAVE_NETINET_TCP_H
+#include <netinet/tcp.h>
+#endif
+
+#include "catalog/namespace.h"
+#include "commands/async.h"
+#include "commands/prepare.h"
+#include "common/ip.h"
+#include "lib/ilist.h"
+#include "lib/stringinfo.h"
+#include "libpq/libpq.h"
+#include "libpq/pqformat.h"
+#include "libpq/pqsignal.h"
+#include "miscadmin.h"
+#include "pgstat.h"
+#include "port/pg_bswap.h"
+#include "postmaster/fork_process.h"
+#include "postmaster/postmaster.h"
+#include "postmaster/proxy.h"
+#include "storage/dsm.h"
+#include "storage/ipc.h"
+#include "storage/latch.h"
+#include "storage/lock.h"
+#include "storage/pg_shmem.h"
+#include "utils/builtins.h"
+#include "utils/guc.h"
+#include "utils/memutils.h"
+#include "utils/portal.h"
+#include "utils/ps_status.h"
+#include "utils/timestamp.h"
+#include "utils/varlena.h"
+
+
+/* ----------
+ * Timer definitions.
+ * ----------
+ */
+#define PROXY_RESTART_INTERVAL 10	/* How often to attempt to restart a
+									 * failed connection proxy; in seconds. */
+
+/* Length of the proxy key, in bytes before hex encoding */
+#define PROXY_KEY_BYTES		16
+
+/* Amount of data to read from a socket at a time */
+#define PROXY_READ_SIZE		8192
+
+/*
+ * Stop reading from a connection when this much data is waiting to be sent
+ * on to its peer, and resume once all of it has been sent.
+ */
+#define PROXY_BUFFER_LIMIT	(256 * 1024)
+
+/* Maximum number of events to process per wait */
+#define PROXY_MAX_EVENTS	64
+
+/* Length of a message header: type byte and length word */
+#define PROXY_MSG_HEADER	5
+
+typedef enum ProxyConnState
+{
+	/* clients */
+	PROXY_CLIENT_STARTUP,		/* reading the startup packet */
+	PROXY_CLIENT_IDLE,			/* between transactions, without backend */
+	PROXY_CLIENT_WAITING,		/* waiting for a backend */
+	PROXY_CLIENT_ATTACHED,		/* using a backend */
+	/* backends */
+	PROXY_BACKEND_STARTING,		/* starting up for the pool */
+	PROXY_BACKEND_IDLE,			/* in the pool */
+	PROXY_BACKEND_ATTACHED		/* in use by a client */
+} ProxyConnState;
+
+#define PROXY_IS_CLIENT(conn)	((conn)->state <= PROXY_CLIENT_ATTACHED)
+
+typedef struct SessionPool SessionPool;
+
+/*
+ * A connection, either from a client or to a backend.
+ */
+typedef struct ProxyConn
+{
+	dlist_node	node;			/* list link in proxy_conns */
+	pgsocket	sock;
+	ProxyConnState state;
+	bool		closed;			/* socket has been closed */
+	int			event_pos;		/* position in proxy_wes, or -1 if none */
+	uint32		events;			/* events waited for, if event_pos >= 0 */
+	bool		throttled;		/* not reading until peer has caught up */
+	StringInfoData rbuf;		/* data read; cursor marks consumed data */
+	StringInfoData wbuf;		/* data to send */
+	int			wpos;			/* amount of wbuf already sent */
+	uint32		msg_remaining;	/* bytes left in a message being relayed */
+	struct ProxyConn *peer;		/* client's backend or backend's client */
+	SessionPool *pool;
+
+	/* These fields are used for clients only */
+	SockAddr	raddr;			/* client's address */
+	TimestampTz connect_time;	/* for the startup packet timeout */
+	bool		authenticated;	/* has a backend authenticated it yet? */
+	bool		auth_begun;		/* has its backend begun authenticating it? */
+	int32		cancel_key;		/* key we gave the client */
+	int			pending;		/* number of ReadyForQuery messages due */
+	bool		unsynced;		/* extended query messages not yet synced */
+
+	/* These fields are used for backends only */
+	int32		backend_pid;	/* from BackendKeyData */
+	int32		backend_key;
+} ProxyConn;
+
+/*
+ * A pool of backends for one set of startup parameters.
+ */
+struct SessionPool
+{
+	char	   *params;			/* startup packet parameters */
+	int			paramslen;
+	List	   *idle;			/* idle backends */
+	List	   *waiting;		/* clients waiting for a backend */
+	int			nclients;		/* number of clients */
+	int			nbackends;		/* number of backends, including starting */
+	int			nstarting;		/* number of backends starting for the pool */
+};
+
+/*
+ * GUC parameters
+ */
+int			proxy_port = 0;
+int			session_pool_size = 10;
+
+bool		am_connection_proxy = false;
+
+/*
+ * The key the proxy presents to the postmaster.  It is generated by the
+ * postmaster at startup, and inherited by all its children.
+ */
+static char ProxyKey[PROXY_KEY_BYTES * 2 + 1];
+
+static time_t last_proxy_start_time;
+
+/*
+ * Private state of the proxy process
+ */
+static MemoryContext ProxyContext = NULL;
+static pgsocket *proxy_listen_sockets;
+static int	proxy_nlisten;
+static char proxy_socket_path[MAXPGPATH];
+
+static dlist_head proxy_conns = DLIST_STATIC_INIT(proxy_conns);
+static List *proxy_pools = NIL;
+
+static WaitEventSet *proxy_wes = NULL;
+static int	proxy_wes_space = 0;
+static int	proxy_wes_nevents = 0;
+static bool proxy_wes_rebuild = true;
+
+static bool shutting_down = false;
+
+/*
+ * Flags set by interrupt handlers for later service in the main loop.
+ */
+static volatile sig_atomic_t got_SIGHUP = false;
+static volatile sig_atomic_t got_SIGTERM = false;
+
+/* ----------
+ * Local function forward declarations
+ * ----------
+ */
+static void ConnectionProxyMain(pgsocket *sockets, int nsockets) pg_attribute_noreturn();
+static void proxy_sighup_handler(SIGNAL_ARGS);
+static void proxy_sigterm_handler(SIGNAL_ARGS);
+static void proxy_quickdie(SIGNAL_ARGS);
+static void proxy_begin_shutdown(void);
+static void proxy_update_events(void);
+static long proxy_check_timeouts(void);
+static void proxy_free_closed(void);
+static void proxy_accept(pgsocket listen_sock);
+static ProxyConn *proxy_new_conn(pgsocket sock, ProxyConnState state);
+static void proxy_close(ProxyConn *conn);
+static void proxy_read(ProxyConn *conn);
+static void proxy_flush(ProxyConn *conn);
+static void proxy_compact(StringInfo buf);
+static void proxy_client_startup(ProxyConn *client);
+static void proxy_client_input(ProxyConn *client);
+static void proxy_backend_input(ProxyConn *backend);
+static void proxy_backend_message(ProxyConn *backend, char type,
+					  const char *msg, int msglen);
+static void proxy_backend_failed(ProxyConn *backend, const char *msg,
+					 int msglen);
+static SessionPool *proxy_find_pool(const char *params, int paramslen);
+static void proxy_request_backend(ProxyConn *client);
+static void proxy_attach(ProxyConn *client, ProxyConn *backend);
+static void proxy_detach(ProxyConn *client);
+static void proxy_backend_ready(ProxyConn *backend);
+static void proxy_check_waiters(SessionPool *pool);
+static bool proxy_launch_backend(SessionPool *pool, ProxyConn *client);
+static pgsocket proxy_connect_postmaster(void);
+static void proxy_cancel_request(const char *pkt, int len);
+static void proxy_send_error(ProxyConn *client, int sqlstate,
+				 const char *msg);
+static int	proxy_begin_message(StringInfo buf, char type);
+static void proxy_end_message(StringInfo buf, int start);
+
+
+/* ------------------------------------------------------------
+ * Public functions called from postmaster follow
+ * ------------------------------------------------------------
+ */
+
+/*
+ * proxy_start
+ *
+ *	Called from postmaster at startup or after an existing proxy died.
+ *	Attempt to fire up a fresh connection proxy process, listening on the
+ *	given sockets.
+ *
+ *	Returns PID of child process, or 0 if fail.
+ *
+ *	Note: if fail, we will be called again from the postmaster main loop.
+ */
+int
+proxy_start(pgsocket *sockets, int nsockets)
+{
+#ifndef EXEC_BACKEND
+	time_t		curtime;
+	pid_t		proxyPid;
+
+	/*
+	 * Do nothing if too soon since last proxy start.  This is a safety valve
+	 * to protect against continuous respawn attempts if the proxy is dying
+	 * immediately at launch.
+	 */
+	curtime = time(NULL);
+	if ((unsigned int) (curtime - last_proxy_start_time) <
+		(unsigned int) PROXY_RESTART_INTERVAL)
+		return 0;
+	last_proxy_start_time = curtime;
+
+	switch ((proxyPid = fork_process()))
+	{
+		case -1:
+			ereport(LOG,
+					(errmsg("could not fork connection proxy: %m")));
+			return 0;
+
+		case 0:
+			/* in postmaster child ... */
+			InitPostmasterChild();
+
+			/* Close the postmaster's sockets, except our own */
+			am_connection_proxy = true;
+			ClosePostmasterPorts(false);
+
+			/* Drop our connection to postmaster's shared memory, as well */
+			dsm_detach_all();
+			PGSharedMemoryDetach();
+
+			ConnectionProxyMain(sockets, nsockets);
+			break;
+
+		default:
+			return (int) proxyPid;
+	}
+#endif
+
+	/* shouldn't get here */
+	return 0;
+}
+
+/*
+ * Generate the key that the connection proxy uses to identify itself.
+ */
+void
+ProxyGenerateKey(void)
+{
+	char		buf[PROXY_KEY_BYTES];
+
+	if (!pg_strong_random(buf, sizeof(buf)))
+		ereport(FATAL,
+				(errmsg("could not generate connection proxy key")));
+	hex_encode(buf, sizeof(buf), ProxyKey);
+	ProxyKey[sizeof(ProxyKey) - 1] = '\0';
+}
+
+/* ------------------------------------------------------------
+ * Public functions called from backends follow
+ * ------------------------------------------------------------
+ */
+
+/*
+ * Check the key in the startup packet of a connection that claims to come
+ * from the connection proxy.
+ */
+bool
+ProxyKeyIsValid(const char *key)
+{
+	size_t		keylen = strlen(ProxyKey);
+	int			diff = 0;
+	int			i;
+
+	/* There is no key at all if the proxy is not enabled */
+	if (keylen == 0 || strlen(key) != keylen)
+		return false;
+
+	/* Don't leak the position of the first difference through timing */
+	for (i = 0; i < keylen; i++)
+		diff |= key[i] ^ ProxyKey[i];
+
+	return diff == 0;
+}
+
+/*
+ * Make the port describe the client whose address the connection proxy
+ * passed on to us, so that authentication and logging apply to the client
+ * rather than to the proxy.
+ */
+void
+ProxySetClientAddress(Port *port, const char *client)
+{
+	char		remote_host[NI_MAXHOST];
+	char		remote_port[NI_MAXSERV];
+	size_t		len = strlen(client);
+	int			ret;
+
+	if (len != sizeof(SockAddr) * 2 ||
+		strspn(client, "0123456789abcdef") != len)
+		ereport(FATAL,
+				(errcode(ERRCODE_PROTOCOL_VIOLATION),
+				 errmsg("invalid client address from connection proxy")));
+	hex_decode(client, len, (char *) &port->raddr);
+	if (port->raddr.salen > sizeof(port->raddr.addr))
+		ereport(FATAL,
+				(errcode(ERRCODE_PROTOCOL_VIOLATION),
+				 errmsg("invalid client address from connection proxy")));
+
+	/* Same as in BackendInitialize */
+	remote_host[0] = '\0';
+	remote_port[0] = '\0';
+	if ((ret = pg_getnameinfo_all(&port->raddr.addr, port->raddr.salen,
+								  remote_host, sizeof(remote_host),
+								  remote_port, sizeof(remote_port),
+								  (log_hostname ? 0 : NI_NUMERICHOST) | NI_NUMERICSERV)) != 0)
+		ereport(WARNING,
+				(errmsg_internal("pg_getnameinfo_all() failed: %s",
+								 gai_strerror(ret))));
+
+	port->remote_host = strdup(remote_host);
+	port->remote_port = strdup(remote_port);
+
+	port->remote_hostname = NULL;
+	port->remote_hostname_resolv = 0;
+	port->remote_hostname_errcode = 0;
+	if (log_hostname &&
+		ret == 0 &&
+		strspn(remote_host, "0123456789.") < strlen(remote_host) &&
+		strspn(remote_host, "0123456789ABCDEFabcdef:") < strlen(remote_host))
+		port->remote_hostname = strdup(remote_host);
+}
+
+/*
+ * Does the session hold any state that would be lost, or leak to another
+ * client, if the connection proxy handed the backend to another client?
+ *
+ * This is called between transactions only.
+ */
+bool
+ProxySessionHasState(void)
+{
+	Oid			tempNamespaceId;
+	Oid			tempToastNamespaceId;
+
+	GetTempNamespaceState(&tempNamespaceId, &tempToastNamespaceId);
+
+	return HaveSessionGUCSettings() ||
+		HavePreparedStatements() ||
+		OidIsValid(tempNamespaceId) ||
+		ThereAreHeldPortals() ||
+		LockHaveSessionLocks() ||
+		IsListeningOnAnyChannel();
+}
+
+
+/* ------------------------------------------------------------
+ * Local functions called by the connection proxy follow
+ * ------------------------------------------------------------
+ */
+
+/*
+ * ConnectionProxyMain
+ *
+ *	The main entry point for the connection proxy process.
+ */
+static void
+ConnectionProxyMain(pgsocket *sockets, int nsockets)
+{
+	/*
+	 * Ignore all signals usually bound to some action in the postmaster,
+	 * except for SIGHUP, SIGTERM and SIGQUIT.
+	 */
+	pqsignal(SIGHUP, proxy_sighup_handler);
+	pqsignal(SIGINT, SIG_IGN);
+	pqsignal(SIGTERM, proxy_sigterm_handler);
+	pqsignal(SIGQUIT, proxy_quickdie);
+	pqsignal(SIGALRM, SIG_IGN);
+	pqsignal(SIGPIPE, SIG_IGN);
+	pqsignal(SIGUSR1, SIG_IGN);
+	pqsignal(SIGUSR2, SIG_IGN);
+	/* Reset some signals that are accepted by postmaster but not here */
+	pqsignal(SIGCHLD, SIG_DFL);
+	PG_SETMASK(&UnBlockSig);
+
+	/*
+	 * Identify myself via ps
+	 */
+	init_ps_display("connection proxy", "", "", "");
+
+	ProxyContext = AllocSetContextCreate(TopMemoryContext,
+										 "Connection proxy",
+										 ALLOCSET_DEFAULT_SIZES);
+	MemoryContextSwitchTo(ProxyContext);
+
+	proxy_listen_sockets = sockets;
+	for (proxy_nlisten = 0; proxy_nlisten < nsockets; proxy_nlisten++)
+	{
+		if (sockets[proxy_nlisten] == PGINVALID_SOCKET)
+			break;
+	}
+
+	/*
+	 * We connect to the postmaster through the first Unix-domain socket
+	 * directory, if there is one, and through localhost otherwise.
+	 */
+	proxy_socket_path[0] = '\0';
+#ifdef HAVE_UNIX_SOCKETS
+	if (Unix_socket_directories)
+	{
+		char	   *rawstring = pstrdup(Unix_socket_directories);
+		List	   *elemlist;
+
+		if (SplitDirectoriesString(rawstring, ',', &elemlist) &&
+			elemlist != NIL)
+			UNIXSOCK_PATH(proxy_socket_path, PostPortNumber,
+						  (char *) linitial(elemlist));
+	}
+#endif
+
+	for (;;)
+	{
+		WaitEvent	events[PROXY_MAX_EVENTS];
+		int			nevents;
+		int			i;
+		long		timeout;
+
+		if (got_SIGHUP)
+		{
+			got_SIGHUP = false;
+			ProcessConfigFile(PGC_SIGHUP);
+		}
+
+		if (got_SIGTERM && !shutting_down)
+			proxy_begin_shutdown();
+
+		proxy_free_closed();
+
+		if (shutting_down && dlist_is_empty(&proxy_conns))
+			proc_exit(0);
+
+		timeout = proxy_check_timeouts();
+		proxy_free_closed();
+
+		proxy_update_events();
+
+		nevents = WaitEventSetWait(proxy_wes, timeout,
+								   events, lengthof(events),
+								   WAIT_EVENT_PROXY_MAIN);
+
+		for (i = 0; i < nevents; i++)
+		{
+			WaitEvent  *event = &events[i];
+			ProxyConn  *conn = (ProxyConn *) event->user_data;
+
+			if (event->events & WL_LATCH_SET)
+			{
+				ResetLatch(MyLatch);
+				continue;
+			}
+
+			/* Listen sockets are the only events without a connection */
+			if (conn == NULL)
+			{
+				if (!shutting_down)
+					proxy_accept(event->fd);
+				continue;
+			}
+
+			if (!conn->closed && (event->events & WL_SOCKET_WRITEABLE))
+				proxy_flush(conn);
+			if (!conn->closed && (event->events & WL_SOCKET_READABLE))
+				proxy_read(conn);
+		}
+	}
+}
+
+/* SIGHUP: set flag to re-read config file at next convenient time */
+static void
+proxy_sighup_handler(SIGNAL_ARGS)
+{
+	int			save_errno = errno;
+
+	got_SIGHUP = true;
+	SetLatch(MyLatch);
+
+	errno = save_errno;
+}
+
+/* SIGTERM: disconnect clients as they finish their transactions, then exit */
+static void
+proxy_sigterm_handler(SIGNAL_ARGS)
+{
+	int			save_errno = errno;
+
+	got_SIGTERM = true;
+	SetLatch(MyLatch);
+
+	errno = save_errno;
+}
+
+/* SIGQUIT: drop all connections and exit right away */
+static void
+proxy_quickdie(SIGNAL_ARGS)
+{
+	/*
+	 * We hold no resources other than our sockets, which the kernel will
+	 * close for us; the backends exit when they notice.
+	 */
+	exit(0);
+}
+
+/*
+ * Begin a smart shutdown: stop accepting connections, disconnect all clients
+ * that are not in a transaction, and let the others finish theirs.
+ */
+static void
+proxy_begin_shutdown(void)
+{
+	dlist_iter	iter;
+	int			i;
+
+	shutting_down = true;
+
+	for (i = 0; i < proxy_nlisten; i++)
+		StreamClose(proxy_listen_sockets[i]);
+	proxy_nlisten = 0;
+	proxy_wes_rebuild = true;
+
+	dlist_foreach(iter, &proxy_conns)
+	{
+		ProxyConn  *conn = dlist_container(ProxyConn, node, iter.cur);
+
+		if (conn->closed || conn->peer != NULL)
+			continue;
+
+		if (PROXY_IS_CLIENT(conn) && conn->state != PROXY_CLIENT_STARTUP)
+			proxy_send_error(conn, ERRCODE_ADMIN_SHUTDOWN,
+							 _("terminating connection due to administrator command"));
+		proxy_close(conn);
+	}
+}
+
+/*
+ * Bring the wait event set up to date with what each connection is waiting
+ * for.  Removing a socket from the set requires building it anew.
+ */
+static void
+proxy_update_events(void)
+{
+	dlist_iter	iter;
+	int			nconns = 0;
+	int			nnew = 0;
+
+	dlist_foreach(iter, &proxy_conns)
+	{
+		ProxyConn  *conn = dlist_container(ProxyConn, node, iter.cur);
+		int			pending;
+		uint32		events = 0;
+
+		Assert(!conn->closed);
+
+		/*
+		 * Stop reading from a connection whose data can't be passed on, and
+		 * resume when all of it has been.  A waiting client's data stays here
+		 * until it gets a backend.
+		 */
+		if (conn->state == PROXY_CLIENT_WAITING)
+			pending = conn->rbuf.len - conn->rbuf.cursor;
+		else if (conn->peer)
+			pending = conn->peer->wbuf.len - conn->peer->wpos;
+		else
+			pending = 0;
+		if (pending >= PROXY_BUFFER_LIMIT)
+			conn->throttled = true;
+		else if (pending == 0)
+			conn->throttled = false;
+
+		if (!conn->throttled)
+			events |= WL_SOCKET_READABLE;
+		if (conn->wpos < conn->wbuf.len)
+			events |= WL_SOCKET_WRITEABLE;
+
+		if (events == 0)
+		{
+			if (conn->event_pos >= 0)
+				proxy_wes_rebuild = true;
+		}
+		else if (conn->event_pos < 0)
+			nnew++;
+		else if (!proxy_wes_rebuild && events != conn->events)
+			ModifyWaitEvent(proxy_wes, conn->event_pos, events, NULL);
+
+		conn->events = events;
+		nconns++;
+	}
+
+	if (proxy_wes_nevents + nnew > proxy_wes_space)
+		proxy_wes_rebuild = true;
+
+	if (proxy_wes_rebuild)
+	{
+		int			i;
+
+		if (proxy_wes)
+			FreeWaitEventSet(proxy_wes);
+		proxy_wes_space = Max(2 * (nconns + proxy_nlisten + 2), 64);
+		proxy_wes = CreateWaitEventSet(ProxyContext, proxy_wes_space);
+		AddWaitEventToSet(proxy_wes, WL_LATCH_SET, PGINVALID_SOCKET,
+						  MyLatch, NULL);
+		AddWaitEventToSet(proxy_wes, WL_EXIT_ON_PM_DEATH, PGINVALID_SOCKET,
+						  NULL, NULL);
+		for (i = 0; i < proxy_nlisten; i++)
+			AddWaitEventToSet(proxy_wes, WL_SOCKET_READABLE,
+							  proxy_listen_sockets[i], NULL, NULL);
+		proxy_wes_nevents = 2 + proxy_nlisten;
+
+		dlist_foreach(iter, &proxy_conns)
+		{
+			ProxyConn  *conn = dlist_container(ProxyConn, node, iter.cur);
+
+			conn->event_pos = -1;
+		}
+		proxy_wes_rebuild = false;
+	}
+
+	dlist_foreach(iter, &proxy_conns)
+	{
+		ProxyConn  *conn = dlist_container(ProxyConn, node, iter.cur);
+
+		if (conn->event_pos < 0 && conn->events != 0)
+		{
+			conn->event_pos = AddWaitEventToSet(proxy_wes, conn->events,
+												conn->sock, NULL, conn);
+			proxy_wes_nevents++;
+		}
+	}
+}
+
+/*
+ * Disconnect clients that have not completed their startup packet within
+ * authentication_timeout.  Returns the time in milliseconds until the next
+ * client would time out, or -1 if there is none.
+ */
+static long
+proxy_check_timeouts(void)
+{
+	TimestampTz now = GetCurrentTimestamp();
+	long		timeout = -1;
+	dlist_iter	iter;
+
+	dlist_foreach(iter, &proxy_conns)
+	{
+		ProxyConn  *conn = dlist_container(ProxyConn, node, iter.cur);
+		TimestampTz deadline;
+		long		secs;
+		int			usecs;
+		long		remaining;
+
+		if (conn->closed || conn->state != PROXY_CLIENT_STARTUP)
+			continue;
+
+		deadline = TimestampTzPlusMilliseconds(conn->connect_time,
+											   AuthenticationTimeout * 1000);
+		if (deadline <= now)
+		{
+			proxy_close(conn);
+			continue;
+		}
+
+		TimestampDifference(now, deadline, &secs, &usecs);
+		remaining = secs * 1000 + usecs / 1000 + 1;
+		if (timeout < 0 || remaining < timeout)
+			timeout = remaining;
+	}
+
+	return timeout;
+}
+
+/*
+ * Free the connections that have been closed, and the pools that have no
+ * connections left.
+ */
+static void
+proxy_free_closed(void)
+{
+	dlist_mutable_iter miter;
+	ListCell   *lc;
+	ListCell   *prev;
+	ListCell   *next;
+
+	dlist_foreach_modify(miter, &proxy_conns)
+	{
+		ProxyConn  *conn = dlist_container(ProxyConn, node, miter.cur);
+
+		if (!conn->closed)
+			continue;
+
+		dlist_delete(miter.cur);
+		pfree(conn->rbuf.data);
+		pfree(conn->wbuf.data);
+		pfree(conn);
+	}
+
+	prev = NULL;
+	for (lc = list_head(proxy_pools); lc != NULL; lc = next)
+	{
+		SessionPool *pool = (SessionPool *) lfirst(lc);
+
+		next = lnext(lc);
+		if (pool->nclients == 0 && pool->nbackends == 0)
+		{
+			Assert(pool->idle == NIL && pool->waiting == NIL);
+			proxy_pools = list_delete_cell(proxy_pools, lc, prev);
+			pfree(pool->params);
+			pfree(pool);
+		}
+		else
+			prev = lc;
+	}
+}
+
+/*
+ * Accept a new client connection.
+ */
+static void
+proxy_accept(pgsocket listen_sock)
+{
+	Port		port;
+	ProxyConn  *client;
+
+	memset(&port, 0, sizeof(port));
+	if (StreamConnection(listen_sock, &port) != STATUS_OK)
+	{
+		if (port.sock != PGINVALID_SOCKET)
+			StreamClose(port.sock);
+		return;
+	}
+	if (!pg_set_noblock(port.sock))
+	{
+		ereport(LOG,
+				(errmsg("could not set socket to nonblocking mode: %m")));
+		StreamClose(port.sock);
+		return;
+	}
+
+	client = proxy_new_conn(port.sock, PROXY_CLIENT_STARTUP);
+	client->raddr = port.raddr;
+	client->connect_time = GetCurrentTimestamp();
+	client->cancel_key = (int32) random();
+}
+
+/*
+ * Set up a new connection with the given socket.
+ */
+static ProxyConn *
+proxy_new_conn(pgsocket sock, ProxyConnState state)
+{
+	ProxyConn  *conn = palloc0(sizeof(ProxyConn));
+
+	conn->sock = sock;
+	conn->state = state;
+	conn->event_pos = -1;
+	initStringInfo(&conn->rbuf);
+	initStringInfo(&conn->wbuf);
+	dlist_push_tail(&proxy_conns, &conn->node);
+
+	return conn;
+}
+
+/*
+ * Close a connection.  What has not been sent on it yet is sent if that can
+ * be done without blocking, and lost otherwise.
+ *
+ * A client's backend is closed along with it, since it may be in the middle
+ * of a transaction, and vice versa.  The memory is
+ * freed later, by proxy_free_closed, because the connection may be referred
+ * to by events that have not been processed yet.
+ */
+static void
+proxy_close(ProxyConn *conn)
+{
+	ProxyConn  *peer = conn->peer;
+	SessionPool *pool = conn->pool;
+
+	if (conn->closed)
+		return;
+
+	if (conn->wpos < conn->wbuf.len)
+		(void) send(conn->sock, conn->wbuf.data + conn->wpos,
+					conn->wbuf.len - conn->wpos, 0);
+	StreamClose(conn->sock);
+	conn->closed = true;
+	conn->peer = NULL;
+	proxy_wes_rebuild = true;
+
+	if (pool != NULL)
+	{
+		switch (conn->state)
+		{
+			case PROXY_CLIENT_STARTUP:
+				break;
+			case PROXY_CLIENT_IDLE:
+			case PROXY_CLIENT_WAITING:
+			case PROXY_CLIENT_ATTACHED:
+				pool->waiting = list_delete_ptr(pool->waiting, conn);
+				pool->nclients--;
+				break;
+			case PROXY_BACKEND_STARTING:
+				pool->nstarting--;
+				pool->nbackends--;
+				break;
+			case PROXY_BACKEND_IDLE:
+			case PROXY_BACKEND_ATTACHED:
+				pool->idle = list_delete_ptr(pool->idle, conn);
+				pool->nbackends--;
+				break;
+		}
+	}
+
+	if (peer != NULL)
+	{
+		peer->peer = NULL;
+		proxy_close(peer);
+	}
+
+	/* Start a new backend for the pool if it can use one */
+	if (pool != NULL && !PROXY_IS_CLIENT(conn))
+		proxy_check_waiters(pool);
+}
+
+/*
+ * Read what has arrived on a connection, and process it.
+ */
+static void
+proxy_read(ProxyConn *conn)
+{
+	StringInfo	buf = &conn->rbuf;
+	ssize_t		n;
+
+	for (;;)
+	{
+		enlargeStringInfo(buf, PROXY_READ_SIZE);
+		n = recv(conn->sock, buf->data + buf->len, buf->maxlen - buf->len - 1, 0);
+		if (n > 0)
+			break;
+		if (n < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				return;
+		}
+		/* EOF or error: the other end is gone */
+		proxy_close(conn);
+		return;
+	}
+	buf->len += n;
+	buf->data[buf->len] = '\0';
+
+	if (conn->state == PROXY_CLIENT_STARTUP)
+		proxy_client_startup(conn);
+	if (conn->closed)
+		return;
+	if (PROXY_IS_CLIENT(conn))
+	{
+		if (conn->state != PROXY_CLIENT_STARTUP)
+			proxy_client_input(conn);
+	}
+	else
+		proxy_backend_input(conn);
+}
+
+/*
+ * Send as much of the data waiting on a connection as can be sent without
+ * blocking.
+ */
+static void
+proxy_flush(ProxyConn *conn)
+{
+	StringInfo	buf = &conn->wbuf;
+
+	while (conn->wpos < buf->len)
+	{
+		ssize_t		n;
+
+		n = send(conn->sock, buf->data + conn->wpos, buf->len - conn->wpos, 0);
+		if (n < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				return;
+			/* the other end is gone */
+			conn->wpos = buf->len;
+			proxy_close(conn);
+			return;
+		}
+		conn->wpos += n;
+	}
+
+	/* Everything has been sent; don't hang on to large buffers */
+	conn->wpos = 0;
+	if (buf->maxlen > 4 * PROXY_BUFFER_LIMIT)
+	{
+		pfree(buf->data);
+		initStringInfo(buf);
+	}
+	else
+		resetStringInfo(buf);
+}
+
+/*
+ * Discard the data consumed from a connection's read buffer.
+ */
+static void
+proxy_compact(StringInfo buf)
+{
+	if (buf->cursor == 0)
+		return;
+	buf->len -= buf->cursor;
+	memmove(buf->data, buf->data + buf->cursor, buf->len + 1);
+	buf->cursor = 0;
+}
+
+/*
+ * Process the startup packet of a new client.
+ *
+ * We only check what we need to: the backend checks the rest.
+ */
+static void
+proxy_client_startup(ProxyConn *client)
+{
+	StringInfo	buf = &client->rbuf;
+
+	while (buf->len - buf->cursor >= 4)
+	{
+		char	   *pkt = buf->data + buf->cursor;
+		uint32		len;
+		ProtocolVersion proto;
+		int			offset;
+
+		memcpy(&len, pkt, 4);
+		len = pg_ntoh32(len);
+		if (len < 4 + sizeof(ProtocolVersion) || len > MAX_STARTUP_PACKET_LENGTH)
+		{
+			ereport(COMMERROR,
+					(errcode(ERRCODE_PROTOCOL_VIOLATION),
+					 errmsg("invalid length of startup packet")));
+			proxy_close(client);
+			return;
+		}
+		if (buf->len - buf->cursor < len)
+			return;
+		buf->cursor += len;
+
+		memcpy(&proto, pkt + 4, sizeof(proto));
+		proto = pg_ntoh32(proto);
+
+		if (proto == CANCEL_REQUEST_CODE)
+		{
+			proxy_cancel_request(pkt, len);
+			proxy_close(client);
+			return;
+		}
+
+		if (proto == NEGOTIATE_SSL_CODE)
+		{
+			/* No SSL here; the client may go on without it */
+			appendStringInfoChar(&client->wbuf, 'N');
+			proxy_flush(client);
+			if (client->closed)
+				return;
+			continue;
+		}
+
+		if (PG_PROTOCOL_MAJOR(proto) != 3)
+		{
+			proxy_send_error(client, ERRCODE_FEATURE_NOT_SUPPORTED,
+							 psprintf(_("unsupported frontend protocol %u.%u: connection proxy supports 3.0 to 3.%u"),
+									  PG_PROTOCOL_MAJOR(proto), PG_PROTOCOL_MINOR(proto),
+									  PG_PROTOCOL_MINOR(PG_PROTOCOL_LATEST)));
+			proxy_close(client);
+			return;
+		}
+
+		/* The packet must end with an empty parameter name */
+		if (pkt[len - 1] != '\0')
+		{
+			proxy_send_error(client, ERRCODE_PROTOCOL_VIOLATION,
+							 _("invalid startup packet layout: expected terminator as last byte"));
+			proxy_close(client);
+			return;
+		}
+
+		offset = 4 + sizeof(ProtocolVersion);
+		while (offset < len - 1)
+		{
+			char	   *name = pkt + offset;
+
+			if (strcmp(name, "replication") == 0)
+			{
+				proxy_send_error(client, ERRCODE_FEATURE_NOT_SUPPORTED,
+								 _("replication connections are not supported by the connection proxy"));
+				proxy_close(client);
+				return;
+			}
+			if (strncmp(name, "proxy_", 6) == 0)
+			{
+				proxy_send_error(client, ERRCODE_PROTOCOL_VIOLATION,
+								 psprintf(_("invalid startup packet parameter \"%s\""),
+										  name));
+				proxy_close(client);
+				return;
+			}
+			offset += strlen(name) + 1;
+			if (offset < len - 1)
+				offset += strlen(pkt + offset) + 1;
+		}
+
+		/*
+		 * Find the client's pool.  The parameters are all it takes, since a
+		 * backend started with the same ones has the same session.
+		 */
+		client->pool = proxy_find_pool(pkt + 4 + sizeof(ProtocolVersion),
+									   len - 4 - sizeof(ProtocolVersion) - 1);
+		client->pool->nclients++;
+		client->state = PROXY_CLIENT_IDLE;
+		proxy_compact(buf);
+
+		/* The client expects to be authenticated now, so get it a backend */
+		proxy_request_backend(client);
+		return;
+	}
+}
+
+/*
+ * Process the data a client has sent.
+ *
+ * While the client has a backend, messages are passed on to it as they
+ * arrive, keeping track of the ReadyForQuery messages that the client
+ * expects in return.  Once it has none, the client needs a new backend for
+ * whatever it sends next.
+ */
+static void
+proxy_client_input(ProxyConn *client)
+{
+	StringInfo	buf = &client->rbuf;
+
+	while (buf->cursor < buf->len && !client->closed)
+	{
+		ProxyConn  *backend = client->peer;
+		uint32		n;
+
+		if (client->state != PROXY_CLIENT_ATTACHED)
+		{
+			/* A Terminate message needs no backend */
+			if (buf->data[buf->cursor] == 'X')
+			{
+				proxy_close(client);
+				return;
+			}
+			if (client->state == PROXY_CLIENT_WAITING)
+				break;
+			proxy_request_backend(client);
+			continue;
+		}
+
+		if (client->msg_remaining == 0)
+		{
+			char		type;
+			uint32		len;
+
+			if (buf->len - buf->cursor < PROXY_MSG_HEADER)
+				break;
+			type = buf->data[buf->cursor];
+			memcpy(&len, buf->data + buf->cursor + 1, 4);
+			len = pg_ntoh32(len);
+			if (len < 4)
+			{
+				ereport(COMMERROR,
+						(errcode(ERRCODE_PROTOCOL_VIOLATION),
+						 errmsg("invalid message length")));
+				proxy_close(client);
+				return;
+			}
+
+			switch (type)
+			{
+				case 'Q':		/* simple query */
+				case 'F':		/* fastpath function call */
+					client->pending++;
+					break;
+				case 'S':		/* sync */
+					client->pending++;
+					client->unsynced = false;
+					break;
+				case 'X':		/* terminate */
+					proxy_close(client);
+					return;
+				case 'd':		/* copy data */
+				case 'c':		/* copy done */
+				case 'f':		/* copy fail */
+				case 'H':		/* flush */
+				case 'p':		/* password and other auth responses */
+					break;
+				default:
+					/* an extended query message, which needs a Sync */
+					client->unsynced = true;
+					break;
+			}
+			client->msg_remaining = len + 1;
+		}
+
+		n = Min(buf->len - buf->cursor, client->msg_remaining);
+		appendBinaryStringInfo(&backend->wbuf, buf->data + buf->cursor, n);
+		buf->cursor += n;
+		client->msg_remaining -= n;
+	}
+
+	if (!client->closed)
+	{
+		proxy_compact(buf);
+		if (client->peer)
+			proxy_flush(client->peer);
+	}
+}
+
+/*
+ * Process the data a backend has sent.
+ *
+ * Messages are relayed to the backend's client as they arrive, except for
+ * BackendKeyData and ReadyForQuery messages, which we act on ourselves, and
+ * the messages of a backend starting up for the pool, which has no client.
+ */
+static void
+proxy_backend_input(ProxyConn *backend)
+{
+	StringInfo	buf = &backend->rbuf;
+
+	while (buf->cursor < buf->len && !backend->closed)
+	{
+		ProxyConn  *client = backend->peer;
+		uint32		n;
+
+		if (backend->msg_remaining == 0)
+		{
+			char		type;
+			uint32		len;
+
+			if (buf->len - buf->cursor < PROXY_MSG_HEADER)
+				break;
+			type = buf->data[buf->cursor];
+			memcpy(&len, buf->data + buf->cursor + 1, 4);
+			len = pg_ntoh32(len);
+			if (len < 4)
+			{
+				ereport(LOG,
+						(errcode(ERRCODE_PROTOCOL_VIOLATION),
+						 errmsg("invalid message length from backend")));
+				proxy_close(backend);
+				return;
+			}
+
+			/*
+			 * Until the backend has begun to authenticate a new client, what
+			 * it sends is not meant for that client: an idle backend may
+			 * report parameter values after a configuration reload, before
+			 * it gets to our request to take on the client.
+			 */
+			if (client != NULL && !client->authenticated && !client->auth_begun)
+			{
+				if (type == 'R' || type == 'E' || type == 'v')
+					client->auth_begun = true;
+				else
+				{
+					if (buf->len - buf->cursor < len + 1)
+						break;
+					buf->cursor += len + 1;
+					continue;
+				}
+			}
+
+			if (type == 'K' || type == 'Z' || client == NULL)
+			{
+				/* Wait for the whole message */
+				if (buf->len - buf->cursor < len + 1)
+					break;
+				buf->cursor += len + 1;
+				proxy_backend_message(backend, type,
+									  buf->data + buf->cursor - len + 4,
+									  len - 4);
+				continue;
+			}
+			backend->msg_remaining = len + 1;
+		}
+
+		n = Min(buf->len - buf->cursor, backend->msg_remaining);
+		appendBinaryStringInfo(&client->wbuf, buf->data + buf->cursor, n);
+		buf->cursor += n;
+		backend->msg_remaining -= n;
+	}
+
+	if (!backend->closed)
+	{
+		proxy_compact(buf);
+		if (backend->peer)
+			proxy_flush(backend->peer);
+	}
+}
+
+/*
+ * Act on a complete message from a backend, which is not simply relayed to
+ * its client.  'msg' points to the contents, after the length word.
+ */
+static void
+proxy_backend_message(ProxyConn *backend, char type,
+					  const char *msg, int msglen)
+{
+	ProxyConn  *client = backend->peer;
+
+	switch (type)
+	{
+		case 'K':				/* BackendKeyData */
+			if (msglen == 8)
+			{
+				uint32		pid;
+				uint32		key;
+
+				memcpy(&pid, msg, 4);
+				memcpy(&key, msg + 4, 4);
+				backend->backend_pid = (int32) pg_ntoh32(pid);
+				backend->backend_key = (int32) pg_ntoh32(key);
+			}
+			break;
+
+		case 'Z':				/* ReadyForQuery */
+			{
+				char		status = msglen >= 1 ? msg[0] : 'E';
+				bool		stateless = msglen >= 2 && msg[1] == 'F';
+				int			start;
+
+				if (client == NULL)
+				{
+					/* This completes the startup of a backend for the pool */
+					if (backend->state == PROXY_BACKEND_STARTING)
+						proxy_backend_ready(backend);
+					break;
+				}
+
+				/*
+				 * The first ReadyForQuery after authentication completes the
+				 * client's startup.  Give the client a key of our own for
+				 * cancel requests, since its backend is going to change.
+				 */
+				if (!client->authenticated)
+				{
+					client->authenticated = true;
+					start = proxy_begin_message(&client->wbuf, 'K');
+					pq_sendint32(&client->wbuf, (uint32) MyProcPid);
+					pq_sendint32(&client->wbuf, (uint32) client->cancel_key);
+					proxy_end_message(&client->wbuf, start);
+				}
+
+				start = proxy_begin_message(&client->wbuf, 'Z');
+				pq_sendbyte(&client->wbuf, status);
+				proxy_end_message(&client->wbuf, start);
+
+				if (client->pending > 0)
+					client->pending--;
+
+				/*
+				 * At a transaction boundary, with nothing else in flight, the
+				 * backend can go back to the pool, unless its session holds
+				 * state that belongs to this client.
+				 */
+				if (client->pending == 0 && !client->unsynced &&
+					status == 'I' && stateless &&
+					client->msg_remaining == 0 &&
+					client->rbuf.cursor == client->rbuf.len)
+				{
+					proxy_flush(client);
+					if (!client->closed)
+						proxy_detach(client);
+				}
+			}
+			break;
+
+		case 'E':				/* ErrorResponse */
+			if (backend->state == PROXY_BACKEND_STARTING)
+				proxy_backend_failed(backend, msg - PROXY_MSG_HEADER,
+									 msglen + PROXY_MSG_HEADER);
+			break;
+
+		default:
+			/* anything else from a backend without a client is of no use */
+			break;
+	}
+}
+
+/*
+ * A backend starting up for a pool has reported an error; it will exit
+ * right away.  For lack of a better recipient, pass the error on to the
+ * first waiting client that has already been authenticated.  There will be
+ * another attempt for the other clients.
+ */
+static void
+proxy_backend_failed(ProxyConn *backend, const char *msg, int msglen)
+{
+	SessionPool *pool = backend->pool;
+	ListCell   *lc;
+
+	foreach(lc, pool->waiting)
+	{
+		ProxyConn  *client = (ProxyConn *) lfirst(lc);
+
+		if (client->authenticated)
+		{
+			appendBinaryStringInfo(&client->wbuf, msg, msglen);
+			proxy_close(client);
+			break;
+		}
+	}
+
+	proxy_close(backend);
+}
+
+/*
+ * Find the pool for the given startup parameters, creating it if need be.
+ */
+static SessionPool *
+proxy_find_pool(const char *params, int paramslen)
+{
+	SessionPool *pool;
+	ListCell   *lc;
+
+	foreach(lc, proxy_pools)
+	{
+		pool = (SessionPool *) lfirst(lc);
+
+		if (pool->paramslen == paramslen &&
+			memcmp(pool->params, params, paramslen) == 0)
+			return pool;
+	}
+
+	pool = palloc0(sizeof(SessionPool));
+	pool->params = palloc(paramslen);
+	memcpy(pool->params, params, paramslen);
+	pool->paramslen = paramslen;
+	proxy_pools = lappend(proxy_pools, pool);
+
+	return pool;
+}
+
+/*
+ * Get a backend for a client: an idle one if there is any, and otherwise
+ * wait for one, starting a new backend if the pool is not full.
+ */
+static void
+proxy_request_backend(ProxyConn *client)
+{
+	SessionPool *pool = client->pool;
+
+	Assert(client->state == PROXY_CLIENT_IDLE);
+
+	if (pool->idle != NIL)
+	{
+		ProxyConn  *backend = (ProxyConn *) linitial(pool->idle);
+
+		pool->idle = list_delete_first(pool->idle);
+		proxy_attach(client, backend);
+		return;
+	}
+
+	client->state = PROXY_CLIENT_WAITING;
+	pool->waiting = lappend(pool->waiting, client);
+	proxy_check_waiters(pool);
+}
+
+/*
+ * Give a backend to a client.  A client that has not been authenticated yet
+ * is introduced to the backend, which will authenticate it.
+ */
+static void
+proxy_attach(ProxyConn *client, ProxyConn *backend)
+{
+	client->peer = backend;
+	client->state = PROXY_CLIENT_ATTACHED;
+	backend->peer = client;
+	backend->state = PROXY_BACKEND_ATTACHED;
+
+	if (!client->authenticated)
+	{
+		int			start;
+
+		start = proxy_begin_message(&backend->wbuf, 'a');
+		enlargeStringInfo(&backend->wbuf, sizeof(SockAddr) * 2 + 1);
+		backend->wbuf.len += hex_encode((char *) &client->raddr,
+										sizeof(SockAddr),
+										backend->wbuf.data + backend->wbuf.len);
+		appendStringInfoChar(&backend->wbuf, '\0');
+		proxy_end_message(&backend->wbuf, start);
+		proxy_flush(backend);
+	}
+}
+
+/*
+ * Take a backend away from a client at the end of a transaction.
+ */
+static void
+proxy_detach(ProxyConn *client)
+{
+	ProxyConn  *backend = client->peer;
+
+	client->peer = NULL;
+	client->state = PROXY_CLIENT_IDLE;
+	backend->peer = NULL;
+
+	/* When shutting down, clients are only allowed to finish */
+	if (shutting_down)
+		proxy_close(client);
+
+	proxy_backend_ready(backend);
+}
+
+/*
+ * A backend has become available, either because it has started up or
+ * because its client has finished a transaction.  Give it to the first
+ * waiting client, if there is one.
+ */
+static void
+proxy_backend_ready(ProxyConn *backend)
+{
+	SessionPool *pool = backend->pool;
+	ProxyConn  *client;
+
+	if (backend->state == PROXY_BACKEND_STARTING)
+		pool->nstarting--;
+	backend->state = PROXY_BACKEND_IDLE;
+
+	/* Shrink the pool if session_pool_size has been reduced */
+	if (shutting_down || pool->nbackends > session_pool_size)
+	{
+		proxy_close(backend);
+		return;
+	}
+
+	if (pool->waiting == NIL)
+	{
+		pool->idle = lappend(pool->idle, backend);
+		return;
+	}
+
+	client = (ProxyConn *) linitial(pool->waiting);
+	pool->waiting = list_delete_first(pool->waiting);
+	proxy_attach(client, backend);
+	proxy_client_input(client);
+}
+
+/*
+ * Start as many backends as the pool's waiting clients need, as far as
+ * session_pool_size allows.
+ *
+ * A client that has not been authenticated yet is given a backend of its
+ * own, which authenticates it as it starts up, the same way it would if the
+ * client connected directly.  Backends for other clients are started for
+ * the pool, and given to the first waiting client once they are ready.
+ */
+static void
+proxy_check_waiters(SessionPool *pool)
+{
+	while (pool->waiting != NIL && !shutting_down &&
+		   pool->nbackends < session_pool_size &&
+		   list_length(pool->waiting) > pool->nstarting)
+	{
+		ProxyConn  *client = (ProxyConn *) linitial(pool->waiting);
+
+		if (!client->authenticated)
+		{
+			pool->waiting = list_delete_first(pool->waiting);
+			if (!proxy_launch_backend(pool, client))
+			{
+				proxy_send_error(client, ERRCODE_CONNECTION_FAILURE,
+								 _("connection proxy could not connect to the server"));
+				proxy_close(client);
+			}
+		}
+		else if (!proxy_launch_backend(pool, NULL))
+		{
+			/* There's no point in keeping the clients waiting */
+			while (pool->waiting != NIL)
+			{
+				client = (ProxyConn *) linitial(pool->waiting);
+				proxy_send_error(client, ERRCODE_CONNECTION_FAILURE,
+								 _("connection proxy could not connect to the server"));
+				proxy_close(client);
+			}
+		}
+	}
+}
+
+/*
+ * Start a backend for the given pool.  If 'client' is given, the backend is
+ * started for it, and authenticates it; otherwise the backend is started
+ * for the pool, and needs no authentication.
+ *
+ * Returns false if we could not connect to the postmaster.
+ */
+static bool
+proxy_launch_backend(SessionPool *pool, ProxyConn *client)
+{
+	pgsocket	sock;
+	ProxyConn  *backend;
+	StringInfo	buf;
+	uint32		len;
+
+	sock = proxy_connect_postmaster();
+	if (sock == PGINVALID_SOCKET)
+		return false;
+	if (!pg_set_noblock(sock))
+	{
+		ereport(LOG,
+				(errmsg("could not set socket to nonblocking mode: %m")));
+		StreamClose(sock);
+		return false;
+	}
+
+	backend = proxy_new_conn(sock, PROXY_BACKEND_STARTING);
+	backend->pool = pool;
+	pool->nbackends++;
+
+	/*
+	 * The startup packet is the client's, with our key and possibly the
+	 * client's address added.
+	 */
+	buf = &backend->wbuf;
+	pq_sendint32(buf, 0);		/* length word, filled in below */
+	pq_sendint32(buf, PG_PROTOCOL_LATEST);
+	appendBinaryStringInfo(buf, pool->params, pool->paramslen);
+	appendBinaryStringInfo(buf, "proxy_key", sizeof("proxy_key"));
+	appendBinaryStringInfo(buf, ProxyKey, strlen(ProxyKey) + 1);
+	if (client != NULL)
+	{
+		appendBinaryStringInfo(buf, "proxy_client", sizeof("proxy_client"));
+		enlargeStringInfo(buf, sizeof(SockAddr) * 2 + 1);
+		buf->len += hex_encode((char *) &client->raddr, sizeof(SockAddr),
+							   buf->data + buf->len);
+		appendStringInfoChar(buf, '\0');
+	}
+	appendStringInfoChar(buf, '\0');
+	len = pg_hton32(buf->len);
+	memcpy(buf->data, &len, 4);
+
+	if (client != NULL)
+	{
+		/* The client is attached from the start */
+		client->peer = backend;
+		client->state = PROXY_CLIENT_ATTACHED;
+		backend->peer = client;
+		backend->state = PROXY_BACKEND_ATTACHED;
+	}
+	else
+		pool->nstarting++;
+
+	proxy_flush(backend);
+
+	return true;
+}
+
+/*
+ * Open a connection to the postmaster, in blocking mode.
+ */
+static pgsocket
+proxy_connect_postmaster(void)
+{
+	pgsocket	sock = PGINVALID_SOCKET;
+
+#ifdef HAVE_UNIX_SOCKETS
+	if (proxy_socket_path[0] != '\0')
+	{
+		struct sockaddr_un unp;
+
+		memset(&unp, 0, sizeof(unp));
+		unp.sun_family = AF_UNIX;
+		strlcpy(unp.sun_path, proxy_socket_path, sizeof(unp.sun_path));
+
+		sock = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (sock == PGINVALID_SOCKET)
+		{
+			ereport(LOG,
+					(errcode_for_socket_access(),
+					 errmsg("could not create socket: %m")));
+			return PGINVALID_SOCKET;
+		}
+		if (connect(sock, (struct sockaddr *) &unp, sizeof(unp)) < 0)
+		{
+			ereport(LOG,
+					(errcode_for_socket_access(),
+					 errmsg("connection proxy could not connect to socket \"%s\": %m",
+							proxy_socket_path)));
+			StreamClose(sock);
+			return PGINVALID_SOCKET;
+		}
+		return sock;
+	}
+#endif
+
+	{
+		struct addrinfo hint;
+		struct addrinfo *addrs = NULL;
+		struct addrinfo *addr;
+		char		portstr[32];
+		int			ret;
+
+		MemSet(&hint, 0, sizeof(hint));
+		hint.ai_socktype = SOCK_STREAM;
+		hint.ai_family = AF_UNSPEC;
+		snprintf(portstr, sizeof(portstr), "%d", PostPortNumber);
+
+		ret = pg_getaddrinfo_all("localhost", portstr, &hint, &addrs);
+		if (ret || !addrs)
+		{
+			ereport(LOG,
+					(errmsg("could not resolve \"localhost\": %s",
+							gai_strerror(ret))));
+			if (addrs)
+				pg_freeaddrinfo_all(hint.ai_family, addrs);
+			return PGINVALID_SOCKET;
+		}
+
+		for (addr = addrs; addr; addr = addr->ai_next)
+		{
+			sock = socket(addr->ai_family, SOCK_STREAM, 0);
+			if (sock == PGINVALID_SOCKET)
+				continue;
+			if (connect(sock, addr->ai_addr, addr->ai_addrlen) == 0)
+				break;
+			StreamClose(sock);
+			sock = PGINVALID_SOCKET;
+		}
+		pg_freeaddrinfo_all(hint.ai_family, addrs);
+
+		if (sock == PGINVALID_SOCKET)
+		{
+			ereport(LOG,
+					(errcode_for_socket_access(),
+					 errmsg("connection proxy could not connect to the server on \"localhost\": %m")));
+			return PGINVALID_SOCKET;
+		}
+
+#ifdef TCP_NODELAY
+		{
+			int			on = 1;
+
+			(void) setsockopt(sock, IPPROTO_TCP, TCP_NODELAY,
+							  (char *) &on, sizeof(on));
+		}
+#endif
+	}
+
+	return sock;
+}
+
+/*
+ * Process a cancel request from a client.  If the client it refers to is
+ * using a backend, forward the request to the postmaster, in terms of that
+ * backend.
+ */
+static void
+proxy_cancel_request(const char *pkt, int len)
+{
+	CancelRequestPacket canc;
+	int32		pid;
+	int32		key;
+	dlist_iter	iter;
+
+	if (len != 4 + sizeof(CancelRequestPacket))
+		return;
+	memcpy(&canc, pkt + 4, sizeof(canc));
+	pid = (int32) pg_ntoh32(canc.backendPID);
+	key = (int32) pg_ntoh32(canc.cancelAuthCode);
+
+	if (pid != MyProcPid)
+		return;
+
+	dlist_foreach(iter, &proxy_conns)
+	{
+		ProxyConn  *conn = dlist_container(ProxyConn, node, iter.cur);
+		ProxyConn  *backend = conn->peer;
+
+		if (conn->closed || conn->state != PROXY_CLIENT_ATTACHED ||
+			conn->cancel_key != key)
+			continue;
+
+		if (backend->backend_pid != 0)
+		{
+			pgsocket	sock = proxy_connect_postmaster();
+
+			if (sock != PGINVALID_SOCKET)
+			{
+				uint32		packet[4];
+
+				packet[0] = pg_hton32(sizeof(packet));
+				packet[1] = pg_hton32(CANCEL_REQUEST_CODE);
+				packet[2] = pg_hton32((uint32) backend->backend_pid);
+				packet[3] = pg_hton32((uint32) backend->backend_key);
+				(void) send(sock, (char *) packet, sizeof(packet), 0);
+				StreamClose(sock);
+			}
+		}
+		break;
+	}
+}
+
+/*
+ * Send a FATAL error to a client.  The caller is expected to close it.
+ */
+static void
+proxy_send_error(ProxyConn *client, int sqlstate, const char *msg)
+{
+	StringInfo	buf = &client->wbuf;
+	int			start;
+	const char *code = unpack_sql_state(sqlstate);
+
+	start = proxy_begin_message(buf, 'E');
+	pq_sendbyte(buf, PG_DIAG_SEVERITY);
+	appendBinaryStringInfo(buf, "FATAL", sizeof("FATAL"));
+	pq_sendbyte(buf, PG_DIAG_SEVERITY_NONLOCALIZED);
+	appendBinaryStringInfo(buf, "FATAL", sizeof("FATAL"));
+	pq_sendbyte(buf, PG_DIAG_SQLSTATE);
+	appendBinaryStringInfo(buf, code, strlen(code) + 1);
+	pq_sendbyte(buf, PG_DIAG_MESSAGE_PRIMARY);
+	appendBinaryStringInfo(buf, msg, strlen(msg) + 1);
+	pq_sendbyte(buf, '\0');
+	proxy_end_message(buf, start);
+}
+
+/*
+ * Begin a protocol message in the buffer; returns the offset at which it
+ * starts, to be passed to proxy_end_message.
+ */
+static int
+proxy_begin_message(StringInfo buf, char type)
+{
+	int			start = buf->len;
+
+	pq_sendbyte(buf, type);
+	pq_sendint32(buf, 0);		/* length word, filled in later */
+
+	return start;
+}
+
+/*
+ * Fill in the length word of a message begun with proxy_begin_message.
+ */
+static void
+proxy_end_message(StringInfo buf, int start)
+{
+	uint32		len = pg_hton32(buf->len - start - 1);
+
+	memcpy(buf->data + start + 1, &len, 4);
+}
@@ -223,6 +223,7 @@ WalWriterMain(void)
 	for (;;)
 	{
 		long		cur_timeout;
+		bool		did_work;
 
 		/*
 		 * Advertise whether we might hibernate in this cycle.  We do this
@@ -258,9 +259,13 @@ WalWriterMain(void)
 
 		/*
 		 * Do what we're here for; then, if XLogBackgroundFlush() found useful
-		 * work to do, reset hibernation counter.
+		 * work to do, reset hibernation counter.  We also create future WAL
+		 * segments here, if so configured.
 		 */
-		if (XLogBackgroundFlush())
+		did_work = XLogBackgroundFlush();
+		if (XLogBackgroundPreallocate())
+			did_work = true;
+		if (did_work)
 			left_till_hibernate = LOOPS_UNTIL_HIBERNATE;
 		else if (left_till_hibernate > 0)
 			left_till_hibernate--;
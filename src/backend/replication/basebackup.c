@@ -15,9 +15,19 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <time.h>
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
+#ifdef USE_LZ4
+#include <lz4frame.h>
+#endif
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
 
 #include "access/xlog_internal.h"	/* for pg_start/stop_backup */
 #include "catalog/pg_type.h"
+#include "commands/progress.h"
 #include "common/file_perm.h"
 #include "lib/stringinfo.h"
 #include "libpq/libpq.h"
@@ -29,20 +39,31 @@
 #include "port.h"
 #include "postmaster/syslogger.h"
 #include "replication/basebackup.h"
+#include "replication/basebackup_incremental.h"
 #include "replication/walsender.h"
 #include "replication/walsender_private.h"
 #include "storage/bufpage.h"
 #include "storage/checksum.h"
+#include "storage/doublewrite.h"
 #include "storage/dsm_impl.h"
 #include "storage/fd.h"
 #include "storage/ipc.h"
 #include "storage/reinit.h"
 #include "utils/builtins.h"
+#include "utils/memutils.h"
 #include "utils/ps_status.h"
 #include "utils/relcache.h"
 #include "utils/timestamp.h"
 
 
+typedef enum
+{
+	BACKUP_COMPRESSION_NONE,
+	BACKUP_COMPRESSION_GZIP,
+	BACKUP_COMPRESSION_LZ4,
+	BACKUP_COMPRESSION_ZSTD
+} BackupCompressionMethod;
+
 typedef struct
 {
 	const char *label;
@@ -52,6 +73,10 @@ typedef struct
 	bool		includewal;
 	uint32		maxrate;
 	bool		sendtblspcmapfile;
+	BackupCompressionMethod compression;
+	int			compression_level;	/* -1 means the method's default */
+	int			compression_workers;	/* zstd only */
+	XLogRecPtr	incremental_lsn;	/* invalid for a full backup */
 } basebackup_options;
 
 
@@ -73,12 +98,22 @@ static void SendXlogRecPtrResult(XLogRecPtr ptr, TimeLineID tli);
 static int	compareWalFileNames(const void *a, const void *b);
 static void throttle(size_t increment);
 static bool is_checksummed_file(const char *fullpath, const char *filename);
+static void begin_backup_archive(void);
+static void send_backup_data(const char *data, size_t len);
+static void end_backup_archive(void);
+static void send_copy_data(const char *data, size_t len);
+static bool sendIncrementalFile(FILE *fp, const char *readfilename,
+					const char *tarfilename, struct stat *statbuf);
+static void update_basebackup_progress(int64 delta);
 
 /* Was the backup currently in-progress initiated in recovery mode? */
 static bool backup_started_in_recovery = false;
 
+/* Total size of the backup, or -1 if not known, and bytes streamed so far */
+static int64 backup_total = 0;
+static int64 backup_streamed = 0;
+
 /* Relative path of temporary statistics directory */
-static char *statrelpath = NULL;
 
 /*
  * Size of each block sent into the tar stream for larger files.
@@ -102,6 +137,40 @@ static TimeOffset elapsed_min_unit;
 /* The last check of the transfer rate. */
 static TimestampTz throttled_last;
 
+/*
+ * Server-side compression of the tar archives.  Each archive (one per
+ * tablespace) is compressed as a separate stream, so the client just writes
+ * what it receives into a .tar.gz, .tar.lz4 or .tar.zst file.  Since the
+ * client can't append to a compressed stream, the two zero blocks ending a
+ * tar file are written by us, inside the stream.
+ */
+static BackupCompressionMethod backup_compression = BACKUP_COMPRESSION_NONE;
+static int	backup_compression_level = -1;
+static int	backup_compression_workers = 0;
+
+/* Buffer for compressed output, sent whenever it fills up */
+#define COMPRESS_OUTBUF_SIZE	(TAR_SEND_SIZE * 4)
+static char *compress_outbuf = NULL;
+static size_t compress_outbuf_size = 0;
+
+#ifdef HAVE_LIBZ
+static z_stream gzip_stream;
+static bool gzip_stream_active = false;
+#endif
+#ifdef USE_LZ4
+static LZ4F_compressionContext_t lz4_ctx = NULL;
+static LZ4F_preferences_t lz4_prefs;
+#endif
+#ifdef USE_ZSTD
+static ZSTD_CCtx *zstd_ctx = NULL;
+#endif
+
+/*
+ * For an incremental backup, the start LSN of the prior backup.  Blocks of
+ * relation files whose page LSN is older than this are left out.
+ */
+static XLogRecPtr incremental_lsn = InvalidXLogRecPtr;
+
 /* The starting XLOG position of the base backup. */
 static XLogRecPtr startptr;
 
@@ -122,9 +191,8 @@ static bool noverify_checksums = false;
 static const char *excludeDirContents[] =
 {
 	/*
-	 * Skip temporary statistics files. PG_STAT_TMP_DIR must be skipped even
-	 * when stats_temp_directory is set because PGSS_TEXT_FILE is always
-	 * created there.
+	 * Skip temporary statistics files.  Extensions such as
+	 * pg_stat_statements keep their transient files in PG_STAT_TMP_DIR.
 	 */
 	PG_STAT_TMP_DIR,
 
@@ -180,6 +248,12 @@ static const char *excludeFiles[] =
 	BACKUP_LABEL_FILE,
 	TABLESPACE_MAP,
 
+	/*
+	 * The double-write file only protects against torn writes of the data
+	 * files on this server.
+	 */
+	DOUBLE_WRITE_FILE,
+
 	"postmaster.pid",
 	"postmaster.opts",
 
@@ -230,11 +304,8 @@ perform_base_backup(basebackup_options *opt)
 	TimeLineID	endtli;
 	StringInfo	labelfile;
 	StringInfo	tblspc_map_file = NULL;
-	int			datadirpathlen;
 	List	   *tablespaces = NIL;
 
-	datadirpathlen = strlen(DataDir);
-
 	backup_started_in_recovery = RecoveryInProgress();
 
 	labelfile = makeStringInfo();
@@ -242,6 +313,17 @@ perform_base_backup(basebackup_options *opt)
 
 	total_checksum_failures = 0;
 
+	backup_compression = opt->compression;
+	backup_compression_level = opt->compression_level;
+	backup_compression_workers = opt->compression_workers;
+	incremental_lsn = opt->incremental_lsn;
+
+	backup_total = 0;
+	backup_streamed = 0;
+	pgstat_progress_start_command(PROGRESS_COMMAND_BASEBACKUP, InvalidOid);
+	pgstat_progress_update_param(PROGRESS_BASEBACKUP_PHASE,
+								 PROGRESS_BASEBACKUP_PHASE_WAIT_CHECKPOINT);
+
 	startptr = do_pg_start_backup(opt->label, opt->fastcheckpoint, &starttli,
 								  labelfile, &tablespaces,
 								  tblspc_map_file,
@@ -258,26 +340,56 @@ perform_base_backup(basebackup_options *opt)
 	{
 		ListCell   *lc;
 		tablespaceinfo *ti;
+		int			tblspc_streamed = 0;
+
+		if (incremental_lsn > startptr)
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					 errmsg("incremental backup LSN %X/%X is after the start of this backup at %X/%X",
+							(uint32) (incremental_lsn >> 32),
+							(uint32) incremental_lsn,
+							(uint32) (startptr >> 32), (uint32) startptr)));
 
 		SendXlogRecPtrResult(startptr, starttli);
 
-		/*
-		 * Calculate the relative path of temporary statistics directory in
-		 * order to skip the files which are located in that directory later.
-		 */
-		if (is_absolute_path(pgstat_stat_directory) &&
-			strncmp(pgstat_stat_directory, DataDir, datadirpathlen) == 0)
-			statrelpath = psprintf("./%s", pgstat_stat_directory + datadirpathlen + 1);
-		else if (strncmp(pgstat_stat_directory, "./", 2) != 0)
-			statrelpath = psprintf("./%s", pgstat_stat_directory);
-		else
-			statrelpath = pgstat_stat_directory;
+		pgstat_progress_update_param(PROGRESS_BASEBACKUP_PHASE,
+									 PROGRESS_BASEBACKUP_PHASE_ESTIMATE_BACKUP_SIZE);
 
 		/* Add a node for the base directory at the end */
 		ti = palloc0(sizeof(tablespaceinfo));
 		ti->size = opt->progress ? sendDir(".", 1, true, tablespaces, true) : -1;
 		tablespaces = lappend(tablespaces, ti);
 
+		/*
+		 * The total is only known if the client asked for the sizes to be
+		 * estimated; otherwise report it as unknown.
+		 */
+		if (opt->progress)
+		{
+			foreach(lc, tablespaces)
+			{
+				tablespaceinfo *tmp = (tablespaceinfo *) lfirst(lc);
+
+				backup_total += tmp->size;
+			}
+		}
+		else
+			backup_total = -1;
+
+		{
+			const int	index[] = {
+				PROGRESS_BASEBACKUP_PHASE,
+				PROGRESS_BASEBACKUP_BACKUP_TOTAL,
+				PROGRESS_BASEBACKUP_TBLSPC_TOTAL
+			};
+			const int64 val[] = {
+				PROGRESS_BASEBACKUP_PHASE_STREAM_BACKUP,
+				backup_total, list_length(tablespaces)
+			};
+
+			pgstat_progress_update_multi_param(3, index, val);
+		}
+
 		/* Send tablespace header */
 		SendBackupHeader(tablespaces);
 
@@ -317,6 +429,8 @@ perform_base_backup(basebackup_options *opt)
 			pq_sendint16(&buf, 0);	/* natts */
 			pq_endmessage(&buf);
 
+			begin_backup_archive();
+
 			if (ti->path == NULL)
 			{
 				struct stat statbuf;
@@ -324,6 +438,18 @@ perform_base_backup(basebackup_options *opt)
 				/* In the main tar, include the backup_label first... */
 				sendFileWithContent(BACKUP_LABEL_FILE, labelfile->data);
 
+				/* ... and mark an incremental backup as such */
+				if (!XLogRecPtrIsInvalid(incremental_lsn))
+				{
+					char		incrfile[64];
+
+					snprintf(incrfile, sizeof(incrfile),
+							 INCREMENTAL_BACKUP_LINE,
+							 (uint32) (incremental_lsn >> 32),
+							 (uint32) incremental_lsn);
+					sendFileWithContent(INCREMENTAL_BACKUP_FILE, incrfile);
+				}
+
 				/*
 				 * Send tablespace_map file if required and then the bulk of
 				 * the files.
@@ -358,9 +484,14 @@ perform_base_backup(basebackup_options *opt)
 				Assert(lnext(lc) == NULL);
 			}
 			else
-				pq_putemptymessage('c');	/* CopyDone */
+				end_backup_archive();
+
+			pgstat_progress_update_param(PROGRESS_BASEBACKUP_TBLSPC_STREAMED,
+										 ++tblspc_streamed);
 		}
 
+		pgstat_progress_update_param(PROGRESS_BASEBACKUP_PHASE,
+									 PROGRESS_BASEBACKUP_PHASE_WAIT_WAL_ARCHIVE);
 		endptr = do_pg_stop_backup(labelfile->data, !opt->nowait, &endtli);
 	}
 	PG_END_ENSURE_ERROR_CLEANUP(base_backup_cleanup, (Datum) 0);
@@ -389,6 +520,9 @@ perform_base_backup(basebackup_options *opt)
 		ListCell   *lc;
 		TimeLineID	tli;
 
+		pgstat_progress_update_param(PROGRESS_BASEBACKUP_PHASE,
+									 PROGRESS_BASEBACKUP_PHASE_TRANSFER_WAL);
+
 		/*
 		 * I'd rather not worry about timelines here, so scan pg_wal and
 		 * include all WAL files in the range between 'startptr' and 'endptr',
@@ -538,10 +672,7 @@ perform_base_backup(basebackup_options *opt)
 								fp)) > 0)
 			{
 				CheckXLogRemoved(segno, tli);
-				/* Send the chunk as a CopyData message */
-				if (pq_putmessage('d', buf, cnt))
-					ereport(ERROR,
-							(errmsg("base backup could not send data, aborting backup")));
+				send_backup_data(buf, cnt);
 
 				len += cnt;
 				throttle(cnt);
@@ -600,7 +731,7 @@ perform_base_backup(basebackup_options *opt)
 		}
 
 		/* Send CopyDone message for the last tar file */
-		pq_putemptymessage('c');
+		end_backup_archive();
 	}
 	SendXlogRecPtrResult(endptr, endtli);
 
@@ -620,6 +751,7 @@ perform_base_backup(basebackup_options *opt)
 				 errmsg("checksum verification failure during base backup")));
 	}
 
+	pgstat_progress_end_command();
 }
 
 /*
@@ -650,8 +782,13 @@ parse_basebackup_options(List *options, basebackup_options *opt)
 	bool		o_maxrate = false;
 	bool		o_tablespace_map = false;
 	bool		o_noverify_checksums = false;
+	bool		o_compression = false;
+	bool		o_compression_level = false;
+	bool		o_compression_workers = false;
+	bool		o_incremental = false;
 
 	MemSet(opt, 0, sizeof(*opt));
+	opt->compression_level = -1;
 	foreach(lopt, options)
 	{
 		DefElem    *defel = (DefElem *) lfirst(lopt);
@@ -738,12 +875,131 @@ parse_basebackup_options(List *options, basebackup_options *opt)
 			noverify_checksums = true;
 			o_noverify_checksums = true;
 		}
+		else if (strcmp(defel->defname, "compression") == 0)
+		{
+			char	   *method = strVal(defel->arg);
+
+			if (o_compression)
+				ereport(ERROR,
+						(errcode(ERRCODE_SYNTAX_ERROR),
+						 errmsg("duplicate option \"%s\"", defel->defname)));
+			if (pg_strcasecmp(method, "none") == 0)
+				opt->compression = BACKUP_COMPRESSION_NONE;
+			else if (pg_strcasecmp(method, "gzip") == 0)
+			{
+#ifdef HAVE_LIBZ
+				opt->compression = BACKUP_COMPRESSION_GZIP;
+#else
+				ereport(ERROR,
+						(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+						 errmsg("compression method \"%s\" is not supported by this build",
+								"gzip")));
+#endif
+			}
+			else if (pg_strcasecmp(method, "lz4") == 0)
+			{
+#ifdef USE_LZ4
+				opt->compression = BACKUP_COMPRESSION_LZ4;
+#else
+				ereport(ERROR,
+						(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+						 errmsg("compression method \"%s\" is not supported by this build",
+								"lz4")));
+#endif
+			}
+			else if (pg_strcasecmp(method, "zstd") == 0)
+			{
+#ifdef USE_ZSTD
+				opt->compression = BACKUP_COMPRESSION_ZSTD;
+#else
+				ereport(ERROR,
+						(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+						 errmsg("compression method \"%s\" is not supported by this build",
+								"zstd")));
+#endif
+			}
+			else
+				ereport(ERROR,
+						(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+						 errmsg("unrecognized compression method \"%s\"",
+								method)));
+			o_compression = true;
+		}
+		else if (strcmp(defel->defname, "compression_level") == 0)
+		{
+			if (o_compression_level)
+				ereport(ERROR,
+						(errcode(ERRCODE_SYNTAX_ERROR),
+						 errmsg("duplicate option \"%s\"", defel->defname)));
+			opt->compression_level = intVal(defel->arg);
+			o_compression_level = true;
+		}
+		else if (strcmp(defel->defname, "compression_workers") == 0)
+		{
+			if (o_compression_workers)
+				ereport(ERROR,
+						(errcode(ERRCODE_SYNTAX_ERROR),
+						 errmsg("duplicate option \"%s\"", defel->defname)));
+			opt->compression_workers = intVal(defel->arg);
+			o_compression_workers = true;
+		}
+		else if (strcmp(defel->defname, "incremental") == 0)
+		{
+			uint32		hi,
+						lo;
+
+			if (o_incremental)
+				ereport(ERROR,
+						(errcode(ERRCODE_SYNTAX_ERROR),
+						 errmsg("duplicate option \"%s\"", defel->defname)));
+			if (sscanf(strVal(defel->arg), "%X/%X", &hi, &lo) != 2 ||
+				((uint64) hi << 32 | lo) == InvalidXLogRecPtr)
+				ereport(ERROR,
+						(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+						 errmsg("invalid incremental backup LSN \"%s\"",
+								strVal(defel->arg))));
+			opt->incremental_lsn = (uint64) hi << 32 | lo;
+			o_incremental = true;
+		}
 		else
 			elog(ERROR, "option \"%s\" not recognized",
 				 defel->defname);
 	}
 	if (opt->label == NULL)
 		opt->label = "base backup";
+
+	if (o_compression_level)
+	{
+		int			maxlevel = 0;
+
+		switch (opt->compression)
+		{
+			case BACKUP_COMPRESSION_NONE:
+				ereport(ERROR,
+						(errcode(ERRCODE_SYNTAX_ERROR),
+						 errmsg("COMPRESSION_LEVEL requires a compression method")));
+				break;
+			case BACKUP_COMPRESSION_GZIP:
+				maxlevel = 9;
+				break;
+			case BACKUP_COMPRESSION_LZ4:
+				maxlevel = 12;
+				break;
+			case BACKUP_COMPRESSION_ZSTD:
+				maxlevel = 22;
+				break;
+		}
+		if (opt->compression_level < 1 || opt->compression_level > maxlevel)
+			ereport(ERROR,
+					(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+					 errmsg("%d is outside the valid range for parameter \"%s\" (%d .. %d)",
+							opt->compression_level, "COMPRESSION_LEVEL",
+							1, maxlevel)));
+	}
+	if (o_compression_workers && opt->compression != BACKUP_COMPRESSION_ZSTD)
+		ereport(ERROR,
+				(errcode(ERRCODE_SYNTAX_ERROR),
+				 errmsg("COMPRESSION_WORKERS is only supported with zstd compression")));
 }
 
 
@@ -944,8 +1200,7 @@ sendFileWithContent(const char *filename, const char *content)
 	statbuf.st_size = len;
 
 	_tarWriteHeader(filename, NULL, &statbuf, false);
-	/* Send the contents as a CopyData message */
-	pq_putmessage('d', content, len);
+	send_backup_data(content, len);
 
 	/* Pad to 512 byte boundary, per tar format requirements */
 	pad = ((len + 511) & ~511) - len;
@@ -954,7 +1209,7 @@ sendFileWithContent(const char *filename, const char *content)
 		char		buf[512];
 
 		MemSet(buf, 0, pad);
-		pq_putmessage('d', buf, pad);
+		send_backup_data(buf, pad);
 	}
 }
 
@@ -1181,17 +1436,6 @@ sendDir(const char *path, int basepathlen, bool sizeonly, List *tablespaces,
 		if (excludeFound)
 			continue;
 
-		/*
-		 * Exclude contents of directory specified by statrelpath if not set
-		 * to the default (pg_stat_tmp) which is caught in the loop above.
-		 */
-		if (statrelpath != NULL && strcmp(pathbuf, statrelpath) == 0)
-		{
-			elog(DEBUG1, "contents of directory \"%s\" excluded from backup", statrelpath);
-			size += _tarWriteDir(pathbuf, basepathlen, &statbuf, sizeonly);
-			continue;
-		}
-
 		/*
 		 * We can skip pg_wal, the WAL segments need to be fetched from the
 		 * WAL archive anyway. But include it as an empty directory anyway, so
@@ -1391,6 +1635,17 @@ sendFile(const char *readfilename, const char *tarfilename, struct stat *statbuf
 				 errmsg("could not open file \"%s\": %m", readfilename)));
 	}
 
+	/*
+	 * In an incremental backup, relation files may be sent as just their
+	 * changed blocks.
+	 */
+	if (!XLogRecPtrIsInvalid(incremental_lsn) &&
+		sendIncrementalFile(fp, readfilename, tarfilename, statbuf))
+	{
+		FreeFile(fp);
+		return true;
+	}
+
 	_tarWriteHeader(tarfilename, NULL, statbuf, false);
 
 	if (!noverify_checksums && DataChecksumsEnabled())
@@ -1530,10 +1785,7 @@ sendFile(const char *readfilename, const char *tarfilename, struct stat *statbuf
 			}
 		}
 
-		/* Send the chunk as a CopyData message */
-		if (pq_putmessage('d', buf, cnt))
-			ereport(ERROR,
-					(errmsg("base backup could not send data, aborting backup")));
+		send_backup_data(buf, cnt);
 
 		len += cnt;
 		throttle(cnt);
@@ -1556,7 +1808,7 @@ sendFile(const char *readfilename, const char *tarfilename, struct stat *statbuf
 		while (len < statbuf->st_size)
 		{
 			cnt = Min(sizeof(buf), statbuf->st_size - len);
-			pq_putmessage('d', buf, cnt);
+			send_backup_data(buf, cnt);
 			len += cnt;
 			throttle(cnt);
 		}
@@ -1570,7 +1822,7 @@ sendFile(const char *readfilename, const char *tarfilename, struct stat *statbuf
 	if (pad > 0)
 	{
 		MemSet(buf, 0, pad);
-		pq_putmessage('d', buf, pad);
+		send_backup_data(buf, pad);
 	}
 
 	FreeFile(fp);
@@ -1586,6 +1838,149 @@ sendFile(const char *readfilename, const char *tarfilename, struct stat *statbuf
 	return true;
 }
 
+/*
+ * Send a relation file of an incremental backup as an INCREMENTAL.<name>
+ * file that contains only the blocks modified since incremental_lsn.
+ *
+ * Returns false, without sending anything and with the file rewound to its
+ * start, if the file is not the main fork of a relation or if sending it in
+ * full would not take much more space.  The other forks are always sent in
+ * full, since free space map and visibility map changes don't necessarily
+ * advance the page LSN.
+ *
+ * A block is considered modified if its page LSN is at or after
+ * incremental_lsn; new (all-zero) pages are always sent.  Pages are not
+ * necessarily read consistently, but a torn page can only be one written
+ * after the start of this backup.  Its full-page image in the WAL replayed
+ * on top of the backup restores it no matter what we send, just like for
+ * a full backup.  Checksums are not verified for files sent this way.
+ */
+static bool
+sendIncrementalFile(FILE *fp, const char *readfilename,
+					const char *tarfilename, struct stat *statbuf)
+{
+	const char *filename;
+	int			oidchars;
+	ForkNumber	fork;
+	BlockNumber nblocks;
+	BlockNumber blkno;
+	BlockNumber *changed;
+	IncrementalFileHeader hdr;
+	size_t		hdrlen;
+	struct stat incrstat;
+	char		incrname[MAXPGPATH];
+	char		buf[TAR_SEND_SIZE];
+	size_t		cnt;
+	pgoff_t		len;
+	size_t		pad;
+	int			i;
+
+	filename = last_dir_separator(tarfilename);
+	filename = filename ? filename + 1 : tarfilename;
+
+	if (!is_checksummed_file(readfilename, filename) ||
+		!parse_filename_for_nontemp_relation(filename, &oidchars, &fork) ||
+		fork != MAIN_FORKNUM ||
+		statbuf->st_size <= 0 || statbuf->st_size % BLCKSZ != 0 ||
+		statbuf->st_size > (pgoff_t) RELSEG_SIZE * BLCKSZ)
+		return false;
+
+	nblocks = statbuf->st_size / BLCKSZ;
+	changed = palloc(sizeof(BlockNumber) * nblocks);
+
+	/* First pass: find the blocks to send */
+	hdr.magic = INCREMENTAL_MAGIC;
+	hdr.truncation_block_length = nblocks;
+	hdr.num_blocks = 0;
+	blkno = 0;
+	while (blkno < nblocks &&
+		   (cnt = fread(buf, 1, Min(sizeof(buf), (nblocks - blkno) * BLCKSZ),
+						fp)) > 0)
+	{
+		for (i = 0; i < cnt / BLCKSZ; i++, blkno++)
+		{
+			char	   *page = buf + BLCKSZ * i;
+
+			if (PageIsNew(page) || PageGetLSN(page) >= incremental_lsn)
+				changed[hdr.num_blocks++] = blkno;
+		}
+		if (cnt % BLCKSZ != 0)
+			break;
+	}
+	if (ferror(fp))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not read file \"%s\": %m", readfilename)));
+
+	/*
+	 * Blocks we didn't get to read because the file was truncated meanwhile
+	 * are sent as zeroes; WAL replay will truncate the relation.
+	 */
+	while (blkno < nblocks)
+		changed[hdr.num_blocks++] = blkno++;
+
+	hdrlen = sizeof(hdr) + sizeof(BlockNumber) * hdr.num_blocks;
+	if (hdrlen + (pgoff_t) hdr.num_blocks * BLCKSZ >=
+		statbuf->st_size - statbuf->st_size / 10)
+	{
+		/* Too many changes to be worth it */
+		pfree(changed);
+		if (fseeko(fp, 0, SEEK_SET) != 0)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not seek in file \"%s\": %m",
+							readfilename)));
+		clearerr(fp);
+		return false;
+	}
+
+	/* Second pass: send the header and the blocks */
+	snprintf(incrname, sizeof(incrname), "%.*s%s%s",
+			 (int) (filename - tarfilename), tarfilename,
+			 INCREMENTAL_PREFIX, filename);
+	incrstat = *statbuf;
+	incrstat.st_size = hdrlen + (pgoff_t) hdr.num_blocks * BLCKSZ;
+	_tarWriteHeader(incrname, NULL, &incrstat, false);
+
+	send_backup_data((char *) &hdr, sizeof(hdr));
+	send_backup_data((char *) changed, sizeof(BlockNumber) * hdr.num_blocks);
+	len = hdrlen;
+
+	clearerr(fp);
+	for (i = 0; i < hdr.num_blocks; i++)
+	{
+		if (fseeko(fp, (pgoff_t) changed[i] * BLCKSZ, SEEK_SET) != 0)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not seek in file \"%s\": %m",
+							readfilename)));
+		cnt = fread(buf, 1, BLCKSZ, fp);
+		if (ferror(fp))
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not read file \"%s\": %m", readfilename)));
+		/* If the file was truncated since the first pass, pad with zeros */
+		if (cnt < BLCKSZ)
+			MemSet(buf + cnt, 0, BLCKSZ - cnt);
+
+		send_backup_data(buf, BLCKSZ);
+		len += BLCKSZ;
+		throttle(BLCKSZ);
+	}
+
+	/* Pad to 512 byte boundary, per tar format requirements */
+	pad = ((len + 511) & ~511) - len;
+	if (pad > 0)
+	{
+		MemSet(buf, 0, pad);
+		send_backup_data(buf, pad);
+	}
+
+	pfree(changed);
+
+	return true;
+}
+
 
 static int64
 _tarWriteHeader(const char *filename, const char *linktarget,
@@ -1619,12 +2014,313 @@ _tarWriteHeader(const char *filename, const char *linktarget,
 				elog(ERROR, "unrecognized tar error: %d", rc);
 		}
 
-		pq_putmessage('d', h, sizeof(h));
+		send_backup_data(h, sizeof(h));
 	}
 
 	return sizeof(h);
 }
 
+/*
+ * Start a new tar archive, after its CopyOutResponse has been sent.
+ */
+static void
+begin_backup_archive(void)
+{
+	if (backup_compression == BACKUP_COMPRESSION_NONE)
+		return;
+
+	if (compress_outbuf == NULL)
+	{
+		compress_outbuf = MemoryContextAlloc(TopMemoryContext,
+											 COMPRESS_OUTBUF_SIZE);
+		compress_outbuf_size = COMPRESS_OUTBUF_SIZE;
+	}
+
+	switch (backup_compression)
+	{
+#ifdef HAVE_LIBZ
+		case BACKUP_COMPRESSION_GZIP:
+			if (gzip_stream_active)
+				deflateEnd(&gzip_stream);
+			memset(&gzip_stream, 0, sizeof(gzip_stream));
+			/* 15 + 16 asks for a gzip header and trailer */
+			if (deflateInit2(&gzip_stream,
+							 backup_compression_level < 0 ?
+							 Z_DEFAULT_COMPRESSION : backup_compression_level,
+							 Z_DEFLATED, 15 + 16, 8,
+							 Z_DEFAULT_STRATEGY) != Z_OK)
+				ereport(ERROR,
+						(errmsg("could not initialize compression library: %s",
+								gzip_stream.msg ? gzip_stream.msg : "unknown error")));
+			gzip_stream_active = true;
+			break;
+#endif
+#ifdef USE_LZ4
+		case BACKUP_COMPRESSION_LZ4:
+			{
+				size_t		len;
+
+				if (lz4_ctx == NULL &&
+					LZ4F_isError(LZ4F_createCompressionContext(&lz4_ctx,
+															   LZ4F_VERSION)))
+					ereport(ERROR,
+							(errmsg("could not initialize compression library")));
+				memset(&lz4_prefs, 0, sizeof(lz4_prefs));
+				lz4_prefs.compressionLevel =
+					backup_compression_level < 0 ? 0 : backup_compression_level;
+
+				/* LZ4F_compressUpdate needs room for its worst case */
+				if (compress_outbuf_size < LZ4F_compressBound(TAR_SEND_SIZE,
+															  &lz4_prefs))
+				{
+					compress_outbuf_size = LZ4F_compressBound(TAR_SEND_SIZE,
+															  &lz4_prefs);
+					compress_outbuf = repalloc(compress_outbuf,
+											   compress_outbuf_size);
+				}
+
+				len = LZ4F_compressBegin(lz4_ctx, compress_outbuf,
+										 compress_outbuf_size, &lz4_prefs);
+				if (LZ4F_isError(len))
+					ereport(ERROR,
+							(errmsg("could not compress data: %s",
+									LZ4F_getErrorName(len))));
+				send_copy_data(compress_outbuf, len);
+			}
+			break;
+#endif
+#ifdef USE_ZSTD
+		case BACKUP_COMPRESSION_ZSTD:
+			if (zstd_ctx == NULL && (zstd_ctx = ZSTD_createCCtx()) == NULL)
+				ereport(ERROR,
+						(errmsg("could not initialize compression library")));
+			ZSTD_CCtx_reset(zstd_ctx, ZSTD_reset_session_and_parameters);
+			ZSTD_CCtx_setParameter(zstd_ctx, ZSTD_c_compressionLevel,
+								   backup_compression_level < 0 ?
+								   ZSTD_CLEVEL_DEFAULT : backup_compression_level);
+			if (backup_compression_workers > 0 &&
+				ZSTD_isError(ZSTD_CCtx_setParameter(zstd_ctx, ZSTD_c_nbWorkers,
+													backup_compression_workers)))
+				ereport(ERROR,
+						(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+						 errmsg("could not set compression worker count to %d",
+								backup_compression_workers),
+						 errdetail("The zstd library may have been built without multithreading support.")));
+			break;
+#endif
+		default:
+			elog(ERROR, "unsupported backup compression method %d",
+				 (int) backup_compression);
+	}
+}
+
+/*
+ * Send a chunk of the tar stream as a CopyData message.
+ */
+static void
+send_copy_data(const char *data, size_t len)
+{
+	if (len > 0 && pq_putmessage('d', data, len))
+		ereport(ERROR,
+				(errmsg("base backup could not send data, aborting backup")));
+}
+
+/*
+ * Account for 'delta' more bytes of the tar stream having been sent.  The
+ * count is of uncompressed bytes, so that it's comparable with the total.
+ *
+ * The estimated total doesn't include the WAL that is sent at the end, nor
+ * files that grew during the backup, so once the streamed amount exceeds it
+ * we just keep the total equal to it.
+ */
+static void
+update_basebackup_progress(int64 delta)
+{
+	const int	index[] = {
+		PROGRESS_BASEBACKUP_BACKUP_STREAMED,
+		PROGRESS_BASEBACKUP_BACKUP_TOTAL
+	};
+	int64		val[2];
+	int			nparam = 0;
+
+	backup_streamed += delta;
+	val[nparam++] = backup_streamed;
+
+	if (backup_total > -1 && backup_streamed > backup_total)
+	{
+		backup_total = backup_streamed;
+		val[nparam++] = backup_total;
+	}
+
+	pgstat_progress_update_multi_param(nparam, index, val);
+}
+
+/*
+ * Add data to the current tar archive, compressing it if requested, and
+ * send it to the client.
+ */
+static void
+send_backup_data(const char *data, size_t len)
+{
+	update_basebackup_progress(len);
+
+	switch (backup_compression)
+	{
+		case BACKUP_COMPRESSION_NONE:
+			send_copy_data(data, len);
+			break;
+#ifdef HAVE_LIBZ
+		case BACKUP_COMPRESSION_GZIP:
+			gzip_stream.next_in = (Bytef *) data;
+			gzip_stream.avail_in = len;
+			while (gzip_stream.avail_in > 0)
+			{
+				gzip_stream.next_out = (Bytef *) compress_outbuf;
+				gzip_stream.avail_out = compress_outbuf_size;
+				if (deflate(&gzip_stream, Z_NO_FLUSH) == Z_STREAM_ERROR)
+					ereport(ERROR,
+							(errmsg("could not compress data: %s",
+									gzip_stream.msg ? gzip_stream.msg : "unknown error")));
+				send_copy_data(compress_outbuf, compress_outbuf_size -
+							   gzip_stream.avail_out);
+			}
+			break;
+#endif
+#ifdef USE_LZ4
+		case BACKUP_COMPRESSION_LZ4:
+			while (len > 0)
+			{
+				size_t		chunk = Min(len, TAR_SEND_SIZE);
+				size_t		clen;
+
+				clen = LZ4F_compressUpdate(lz4_ctx, compress_outbuf,
+										   compress_outbuf_size,
+										   data, chunk, NULL);
+				if (LZ4F_isError(clen))
+					ereport(ERROR,
+							(errmsg("could not compress data: %s",
+									LZ4F_getErrorName(clen))));
+				send_copy_data(compress_outbuf, clen);
+				data += chunk;
+				len -= chunk;
+			}
+			break;
+#endif
+#ifdef USE_ZSTD
+		case BACKUP_COMPRESSION_ZSTD:
+			{
+				ZSTD_inBuffer in = {data, len, 0};
+
+				while (in.pos < in.size)
+				{
+					ZSTD_outBuffer out = {compress_outbuf,
+					compress_outbuf_size, 0};
+					size_t		rc;
+
+					rc = ZSTD_compressStream2(zstd_ctx, &out, &in,
+											  ZSTD_e_continue);
+					if (ZSTD_isError(rc))
+						ereport(ERROR,
+								(errmsg("could not compress data: %s",
+										ZSTD_getErrorName(rc))));
+					send_copy_data(compress_outbuf, out.pos);
+				}
+			}
+			break;
+#endif
+		default:
+			elog(ERROR, "unsupported backup compression method %d",
+				 (int) backup_compression);
+	}
+}
+
+/*
+ * Finish the current tar archive and send CopyDone.
+ */
+static void
+end_backup_archive(void)
+{
+	if (backup_compression != BACKUP_COMPRESSION_NONE)
+	{
+		char		zerobuf[1024];
+
+		/* 2 * 512 bytes of empty data end a tar file */
+		MemSet(zerobuf, 0, sizeof(zerobuf));
+		send_backup_data(zerobuf, sizeof(zerobuf));
+	}
+
+	switch (backup_compression)
+	{
+		case BACKUP_COMPRESSION_NONE:
+			break;
+#ifdef HAVE_LIBZ
+		case BACKUP_COMPRESSION_GZIP:
+			{
+				int			rc;
+
+				do
+				{
+					gzip_stream.next_out = (Bytef *) compress_outbuf;
+					gzip_stream.avail_out = compress_outbuf_size;
+					rc = deflate(&gzip_stream, Z_FINISH);
+					if (rc == Z_STREAM_ERROR)
+						ereport(ERROR,
+								(errmsg("could not compress data: %s",
+										gzip_stream.msg ? gzip_stream.msg : "unknown error")));
+					send_copy_data(compress_outbuf, compress_outbuf_size -
+								   gzip_stream.avail_out);
+				} while (rc != Z_STREAM_END);
+
+				deflateEnd(&gzip_stream);
+				gzip_stream_active = false;
+			}
+			break;
+#endif
+#ifdef USE_LZ4
+		case BACKUP_COMPRESSION_LZ4:
+			{
+				size_t		clen;
+
+				clen = LZ4F_compressEnd(lz4_ctx, compress_outbuf,
+										compress_outbuf_size, NULL);
+				if (LZ4F_isError(clen))
+					ereport(ERROR,
+							(errmsg("could not compress data: %s",
+									LZ4F_getErrorName(clen))));
+				send_copy_data(compress_outbuf, clen);
+			}
+			break;
+#endif
+#ifdef USE_ZSTD
+		case BACKUP_COMPRESSION_ZSTD:
+			{
+				ZSTD_inBuffer in = {NULL, 0, 0};
+				size_t		remaining;
+
+				do
+				{
+					ZSTD_outBuffer out = {compress_outbuf,
+					compress_outbuf_size, 0};
+
+					remaining = ZSTD_compressStream2(zstd_ctx, &out, &in,
+													 ZSTD_e_end);
+					if (ZSTD_isError(remaining))
+						ereport(ERROR,
+								(errmsg("could not compress data: %s",
+										ZSTD_getErrorName(remaining))));
+					send_copy_data(compress_outbuf, out.pos);
+				} while (remaining > 0);
+			}
+			break;
+#endif
+		default:
+			elog(ERROR, "unsupported backup compression method %d",
+				 (int) backup_compression);
+	}
+
+	pq_putemptymessage('c');	/* CopyDone */
+}
+
 /*
  * Write tar header for a directory.  If the entry in statbuf is a link then
  * write it as a directory anyway.
@@ -55,6 +55,7 @@ static void libpqrcv_check_conninfo(const char *conninfo);
 static char *libpqrcv_get_conninfo(WalReceiverConn *conn);
 static void libpqrcv_get_senderinfo(WalReceiverConn *conn,
 						char **sender_host, int *sender_port);
+static int	libpqrcv_server_version(WalReceiverConn *conn);
 static char *libpqrcv_identify_system(WalReceiverConn *conn,
 						 TimeLineID *primary_tli,
 						 int *server_version);
@@ -85,6 +86,7 @@ static WalReceiverFunctionsType PQWalReceiverFunctions = {
 	libpqrcv_check_conninfo,
 	libpqrcv_get_conninfo,
 	libpqrcv_get_senderinfo,
+	libpqrcv_server_version,
 	libpqrcv_identify_system,
 	libpqrcv_readtimelinehistoryfile,
 	libpqrcv_startstreaming,
@@ -304,6 +306,16 @@ libpqrcv_get_senderinfo(WalReceiverConn *conn, char **sender_host,
 		*sender_port = atoi(ret);
 }
 
+/*
+ * Return the server version of the connected server, in PG_VERSION_NUM
+ * format.
+ */
+static int
+libpqrcv_server_version(WalReceiverConn *conn)
+{
+	return PQserverVersion(conn->streamConn);
+}
+
 /*
  * Check that primary's system identifier matches ours, and fetch the current
  * timeline ID of the primary.
@@ -414,6 +426,12 @@ libpqrcv_startstreaming(WalReceiverConn *conn,
 		PQfreemem(pubnames_literal);
 		pfree(pubnames_str);
 
+		if (options->proto.logical.streaming)
+			appendStringInfoString(&cmd, ", streaming 'on'");
+
+		if (options->proto.logical.binary)
+			appendStringInfoString(&cmd, ", binary 'true'");
+
 		appendStringInfoChar(&cmd, ')');
 	}
 	else
@@ -962,6 +980,12 @@ libpqrcv_exec(WalReceiverConn *conn, const char *query,
 			walres->status = WALRCV_ERROR;
 			walres->err = pchomp(PQerrorMessage(conn->streamConn));
 			break;
+
+		case PGRES_PIPELINE_SYNC:
+		case PGRES_PIPELINE_ABORTED:
+			walres->status = WALRCV_ERROR;
+			walres->err = _("unexpected pipeline mode");
+			break;
 	}
 
 	PQclear(pgres);
@@ -0,0 +1,952 @@
+/*-------------------------------------------------------------------------
+ * applyparallel.c
+ *	   Parallel apply of logical replication transactions
+ *
+ * Copyright (c) 2016-2019, PostgreSQL Global Development Group
+ *
+ * IDENTIFICATION
+ *	  src/backend/replication/logical/applyparallel.c
+ *
+ * NOTES
+ *	  When max_parallel_apply_workers_per_subscription is set, the apply
+ *	  worker of a subscription (the leader) starts up to that many parallel
+ *	  apply workers, connected to it through one shared memory queue each.
+ *	  The leader then buffers each remote transaction until its COMMIT has
+ *	  been received, and sends the whole transaction to one of the parallel
+ *	  workers, which applies it just like the apply worker would.
+ *
+ *	  Each transaction handed over is numbered by the leader.  Workers may
+ *	  apply transactions concurrently but have to commit them in the order
+ *	  of these numbers, which is the commit order on the publisher; the next
+ *	  number allowed to commit is kept in shared memory.  This keeps the
+ *	  replication origin progress, and so the restart position of the
+ *	  subscription, correct.
+ *
+ *	  To avoid conflicts, a transaction modifying a relation that is also
+ *	  modified by a transaction handed over earlier and not committed yet is
+ *	  sent to the same worker, behind that transaction.  If the relations of
+ *	  the transaction were modified by uncommitted transactions of several
+ *	  workers, the leader first waits for those to commit.  Transactions can
+ *	  still conflict through other means, for example foreign keys or
+ *	  triggers.  To make such conflicts visible to the deadlock detector,
+ *	  the worker applying a transaction holds a lock on its number until it
+ *	  has committed, and a worker waiting for its turn to commit waits on the
+ *	  lock of the transaction that has to commit first.  A deadlock makes
+ *	  one of the workers fail, and the leader and all the workers restart.
+ *
+ *	  The leader still applies some transactions by itself, after waiting for
+ *	  all the transactions handed over to commit: transactions that are too
+ *	  large to be buffered, streamed transactions, and all transactions
+ *	  while the initial synchronization of some table is still in progress,
+ *	  as that needs the leader to know the exact position applied.
+ *
+ *	  Relation and type messages are sent to all the workers in addition to
+ *	  being processed by the leader, so that the relation map of every
+ *	  worker is the one the publisher expects.
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "miscadmin.h"
+#include "pgstat.h"
+
+#include "access/xact.h"
+
+#include "libpq/pqformat.h"
+#include "libpq/pqsignal.h"
+
+#include "postmaster/bgworker.h"
+
+#include "replication/logicallauncher.h"
+#include "replication/logicalproto.h"
+#include "replication/logicalworker.h"
+#include "replication/origin.h"
+#include "replication/worker_internal.h"
+
+#include "storage/condition_variable.h"
+#include "storage/ipc.h"
+#include "storage/latch.h"
+#include "storage/lock.h"
+#include "storage/proc.h"
+#include "storage/shm_mq.h"
+#include "storage/shm_toc.h"
+#include "storage/spin.h"
+
+#include "tcop/tcopprot.h"
+
+#include "utils/guc.h"
+#include "utils/hsearch.h"
+#include "utils/memutils.h"
+
+#define PARALLEL_APPLY_MAGIC		0x50410001
+
+/* Keys in the shared memory table of contents */
+#define PARALLEL_APPLY_KEY_SHARED	1
+#define PARALLEL_APPLY_KEY_MQ(i)	(2 + (i))
+
+/*
+ * Size of the queue of each worker.  This is also the largest transaction
+ * the leader buffers, larger ones are applied by the leader itself.
+ */
+#define PARALLEL_APPLY_QUEUE_SIZE	(16 * 1024 * 1024)
+
+/*
+ * Internal message sent before the messages of each transaction handed over,
+ * carrying the number of the transaction.
+ */
+#define PARALLEL_APPLY_MSG_SEQUENCE	'N'
+
+/* Per-worker state in shared memory */
+typedef struct ParallelApplyWorkerState
+{
+	bool		exited;			/* worker has exited */
+	uint64		current_seq;	/* transaction being applied, or 0 */
+} ParallelApplyWorkerState;
+
+/* State shared between the leader and the workers */
+typedef struct ParallelApplyShared
+{
+	slock_t		mutex;
+	ConditionVariable cv;		/* signalled on any change of state */
+	Latch	   *leader_latch;
+	bool		leader_exited;
+
+	/* Number of the transaction allowed to commit next */
+	uint64		next_commit_seq;
+
+	/* Remote and local end of the last transaction committed by a worker */
+	XLogRecPtr	last_remote_end;
+	XLogRecPtr	last_local_end;
+
+	int			nworkers;
+	ParallelApplyWorkerState workers[FLEXIBLE_ARRAY_MEMBER];
+} ParallelApplyShared;
+
+/* What the leader does with the messages of the current transaction */
+typedef enum ParallelApplyLeaderState
+{
+	PA_STATE_NONE,				/* not in a transaction */
+	PA_STATE_BUFFERING,			/* buffering to hand over at commit */
+	PA_STATE_SERIAL				/* applying by itself */
+} ParallelApplyLeaderState;
+
+/* Last transaction handed over that modified a given remote relation */
+typedef struct ParallelApplyRelEntry
+{
+	LogicalRepRelId relid;		/* hash key */
+	int			worker;
+	uint64		seq;
+} ParallelApplyRelEntry;
+
+/* State common to the leader and the workers */
+static ParallelApplyShared *pa_shared = NULL;
+
+/* Leader state */
+static shm_mq_handle **pa_mqh = NULL;
+static uint64 *pa_worker_last_seq = NULL;
+static int	pa_next_worker = 0;
+static uint64 pa_last_seq = 0;
+static XLogRecPtr pa_reported_remote_end = InvalidXLogRecPtr;
+static HTAB *pa_relhash = NULL;
+static ParallelApplyLeaderState pa_state = PA_STATE_NONE;
+static MemoryContext pa_context = NULL;
+static StringInfoData pa_buffer;
+static List *pa_relids = NIL;
+
+/* Worker state */
+static int	pa_worker_index = -1;
+static uint64 pa_current_seq = 0;
+
+static volatile sig_atomic_t got_SIGHUP = false;
+
+static void pa_leader_shutdown(int code, Datum arg);
+static void pa_worker_shutdown(int code, Datum arg);
+static void pa_check_workers(void);
+static void pa_wait_for_seq(uint64 seq);
+static void pa_send(int worker, Size len, const void *data);
+static void pa_buffer_message(const char *data, int len);
+static void pa_replay_buffer(void);
+static void pa_dispatch_transaction(void);
+static void pa_start_transaction(uint64 seq);
+
+/*
+ * Start the parallel apply workers of the current apply worker, if
+ * configured.  If none can be started, we keep applying serially.
+ */
+void
+pa_start_workers(void)
+{
+	int			nworkers = max_parallel_apply_workers_per_subscription;
+	shm_toc_estimator e;
+	shm_toc    *toc;
+	Size		segsize;
+	Size		sharedsize;
+	dsm_segment *seg;
+	ParallelApplyShared *shared;
+	MemoryContext oldctx;
+	HASHCTL		ctl;
+	int			i;
+
+	Assert(!am_tablesync_worker() && !am_parallel_apply_worker());
+
+	if (nworkers <= 0)
+		return;
+
+	sharedsize = add_size(offsetof(ParallelApplyShared, workers),
+						  mul_size(nworkers, sizeof(ParallelApplyWorkerState)));
+
+	shm_toc_initialize_estimator(&e);
+	shm_toc_estimate_chunk(&e, sharedsize);
+	for (i = 0; i < nworkers; i++)
+		shm_toc_estimate_chunk(&e, PARALLEL_APPLY_QUEUE_SIZE);
+	shm_toc_estimate_keys(&e, 1 + nworkers);
+	segsize = shm_toc_estimate(&e);
+
+	oldctx = MemoryContextSwitchTo(ApplyContext);
+
+	seg = dsm_create(segsize, 0);
+	dsm_pin_mapping(seg);
+	toc = shm_toc_create(PARALLEL_APPLY_MAGIC, dsm_segment_address(seg),
+						 segsize);
+
+	shared = shm_toc_allocate(toc, sharedsize);
+	memset(shared, 0, sharedsize);
+	SpinLockInit(&shared->mutex);
+	ConditionVariableInit(&shared->cv);
+	shared->leader_latch = MyLatch;
+	shared->leader_exited = false;
+	shared->next_commit_seq = 1;
+	shared->last_remote_end = InvalidXLogRecPtr;
+	shared->last_local_end = InvalidXLogRecPtr;
+	shared->nworkers = 0;
+	shm_toc_insert(toc, PARALLEL_APPLY_KEY_SHARED, shared);
+
+	pa_mqh = palloc0(sizeof(shm_mq_handle *) * nworkers);
+	pa_worker_last_seq = palloc0(sizeof(uint64) * nworkers);
+	for (i = 0; i < nworkers; i++)
+	{
+		shm_mq	   *mq;
+
+		mq = shm_mq_create(shm_toc_allocate(toc, PARALLEL_APPLY_QUEUE_SIZE),
+						   PARALLEL_APPLY_QUEUE_SIZE);
+		shm_toc_insert(toc, PARALLEL_APPLY_KEY_MQ(i), mq);
+		shm_mq_set_sender(mq, MyProc);
+		pa_mqh[i] = shm_mq_attach(mq, seg, NULL);
+	}
+
+	pa_shared = shared;
+	before_shmem_exit(pa_leader_shutdown, (Datum) 0);
+
+	/*
+	 * Start the workers one after the other, stopping at the first failure.
+	 * Each worker attaches to its queue before attaching to its slot, so a
+	 * worker that was started can receive.
+	 */
+	for (i = 0; i < nworkers; i++)
+	{
+		if (!logicalrep_worker_launch(MyLogicalRepWorker->dbid,
+									  MySubscription->oid,
+									  MySubscription->name,
+									  MyLogicalRepWorker->userid,
+									  InvalidOid,
+									  dsm_segment_handle(seg), i))
+			break;
+
+		SpinLockAcquire(&shared->mutex);
+		shared->nworkers = i + 1;
+		SpinLockRelease(&shared->mutex);
+	}
+
+	if (shared->nworkers == 0)
+	{
+		ereport(LOG,
+				(errmsg("logical replication apply worker for subscription \"%s\" will apply all transactions because no parallel apply worker could be started",
+						MySubscription->name)));
+
+		pa_shared = NULL;
+		dsm_detach(seg);
+		MemoryContextSwitchTo(oldctx);
+		return;
+	}
+
+	MemSet(&ctl, 0, sizeof(ctl));
+	ctl.keysize = sizeof(LogicalRepRelId);
+	ctl.entrysize = sizeof(ParallelApplyRelEntry);
+	ctl.hcxt = ApplyContext;
+	pa_relhash = hash_create("logical replication parallel apply relations",
+							 256, &ctl,
+							 HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+
+	pa_context = AllocSetContextCreate(ApplyContext,
+									   "ParallelApplyBuffer",
+									   ALLOCSET_DEFAULT_SIZES);
+
+	MemoryContextSwitchTo(oldctx);
+
+	ereport(DEBUG1,
+			(errmsg("logical replication apply worker for subscription \"%s\" started %d parallel apply workers",
+					MySubscription->name, shared->nworkers)));
+}
+
+/*
+ * Let the workers know the leader is gone, so that workers waiting for the
+ * turn to commit don't wait for transactions that will never be sent.
+ */
+static void
+pa_leader_shutdown(int code, Datum arg)
+{
+	if (pa_shared == NULL)
+		return;
+
+	SpinLockAcquire(&pa_shared->mutex);
+	pa_shared->leader_exited = true;
+	SpinLockRelease(&pa_shared->mutex);
+
+	ConditionVariableBroadcast(&pa_shared->cv);
+}
+
+/*
+ * Error out if some worker has exited; the transactions it was applying
+ * would never commit.
+ */
+static void
+pa_check_workers(void)
+{
+	bool		exited = false;
+	int			i;
+
+	SpinLockAcquire(&pa_shared->mutex);
+	for (i = 0; i < pa_shared->nworkers; i++)
+	{
+		if (pa_shared->workers[i].exited)
+			exited = true;
+	}
+	SpinLockRelease(&pa_shared->mutex);
+
+	if (exited)
+		ereport(ERROR,
+				(errmsg("logical replication parallel apply worker for subscription \"%s\" has exited unexpectedly",
+						MySubscription->name)));
+}
+
+/*
+ * Wait until the transaction with the given number has committed.
+ */
+static void
+pa_wait_for_seq(uint64 seq)
+{
+	for (;;)
+	{
+		uint64		next;
+
+		pa_check_workers();
+
+		SpinLockAcquire(&pa_shared->mutex);
+		next = pa_shared->next_commit_seq;
+		SpinLockRelease(&pa_shared->mutex);
+
+		if (next > seq)
+			break;
+
+		(void) WaitLatch(MyLatch,
+						 WL_LATCH_SET | WL_TIMEOUT | WL_EXIT_ON_PM_DEATH,
+						 1000L,
+						 WAIT_EVENT_LOGICAL_PARALLEL_APPLY_STATE_CHANGE);
+		ResetLatch(MyLatch);
+
+		CHECK_FOR_INTERRUPTS();
+	}
+}
+
+/*
+ * Wait until all the transactions handed over have committed.
+ */
+void
+pa_wait_for_all(void)
+{
+	if (pa_shared == NULL)
+		return;
+
+	pa_wait_for_seq(pa_last_seq);
+}
+
+/*
+ * Are there transactions handed over that have not committed yet?
+ */
+bool
+pa_have_pending_txns(void)
+{
+	uint64		next;
+
+	if (pa_shared == NULL)
+		return false;
+
+	SpinLockAcquire(&pa_shared->mutex);
+	next = pa_shared->next_commit_seq;
+	SpinLockRelease(&pa_shared->mutex);
+
+	return pa_last_seq >= next;
+}
+
+/*
+ * Get the remote and local end of the last transaction committed by the
+ * workers, if they have advanced since the last call.
+ */
+bool
+pa_get_progress(XLogRecPtr *remote_end, XLogRecPtr *local_end)
+{
+	if (pa_shared == NULL)
+		return false;
+
+	pa_check_workers();
+
+	SpinLockAcquire(&pa_shared->mutex);
+	*remote_end = pa_shared->last_remote_end;
+	*local_end = pa_shared->last_local_end;
+	SpinLockRelease(&pa_shared->mutex);
+
+	if (*remote_end <= pa_reported_remote_end)
+		return false;
+
+	pa_reported_remote_end = *remote_end;
+	return true;
+}
+
+/*
+ * Send a message to a worker, waiting for space in its queue.
+ */
+static void
+pa_send(int worker, Size len, const void *data)
+{
+	shm_mq_result res;
+
+	res = shm_mq_send(pa_mqh[worker], len, data, false);
+	if (res != SHM_MQ_SUCCESS)
+		ereport(ERROR,
+				(errmsg("lost connection to logical replication parallel apply worker for subscription \"%s\"",
+						MySubscription->name)));
+}
+
+/*
+ * Append a message to the buffered transaction.
+ */
+static void
+pa_buffer_message(const char *data, int len)
+{
+	appendBinaryStringInfo(&pa_buffer, (char *) &len, sizeof(int));
+	appendBinaryStringInfo(&pa_buffer, data, len);
+}
+
+/*
+ * Apply the buffered transaction ourselves.
+ */
+static void
+pa_replay_buffer(void)
+{
+	int			off = 0;
+
+	while (off < pa_buffer.len)
+	{
+		StringInfoData s;
+		int			len;
+
+		memcpy(&len, pa_buffer.data + off, sizeof(int));
+		off += sizeof(int);
+
+		s.data = pa_buffer.data + off;
+		s.len = len;
+		s.cursor = 0;
+		s.maxlen = -1;
+
+		apply_dispatch(&s);
+
+		off += len;
+	}
+
+	MemoryContextReset(pa_context);
+	pa_relids = NIL;
+}
+
+/*
+ * Hand the buffered transaction over to a worker.
+ */
+static void
+pa_dispatch_transaction(void)
+{
+	uint64		seq = ++pa_last_seq;
+	uint64		next;
+	uint64		max_busy_seq = 0;
+	int			nworkers = pa_shared->nworkers;
+	int			worker = -1;
+	bool		conflict = false;
+	ListCell   *lc;
+	StringInfoData msg;
+	int			off;
+	int			i;
+
+	SpinLockAcquire(&pa_shared->mutex);
+	next = pa_shared->next_commit_seq;
+	SpinLockRelease(&pa_shared->mutex);
+
+	/* Find the workers applying uncommitted changes to our relations. */
+	foreach(lc, pa_relids)
+	{
+		LogicalRepRelId relid = lfirst_oid(lc);
+		ParallelApplyRelEntry *entry;
+
+		entry = hash_search(pa_relhash, &relid, HASH_FIND, NULL);
+		if (entry == NULL || entry->seq < next)
+			continue;
+
+		if (worker < 0)
+			worker = entry->worker;
+		else if (worker != entry->worker)
+			conflict = true;
+
+		max_busy_seq = Max(max_busy_seq, entry->seq);
+	}
+
+	/*
+	 * If several workers are applying changes to our relations, we can't
+	 * order the transaction behind all of them; wait for them instead.
+	 */
+	if (conflict)
+	{
+		pa_wait_for_seq(max_busy_seq);
+		worker = -1;
+
+		SpinLockAcquire(&pa_shared->mutex);
+		next = pa_shared->next_commit_seq;
+		SpinLockRelease(&pa_shared->mutex);
+	}
+
+	/* Otherwise prefer an idle worker, else go round robin. */
+	if (worker < 0)
+	{
+		for (i = 0; i < nworkers; i++)
+		{
+			int			candidate = (pa_next_worker + i) % nworkers;
+
+			if (pa_worker_last_seq[candidate] < next)
+			{
+				worker = candidate;
+				break;
+			}
+		}
+
+		if (worker < 0)
+			worker = pa_next_worker;
+		pa_next_worker = (worker + 1) % nworkers;
+	}
+
+	/* Send the number of the transaction, then the transaction. */
+	initStringInfo(&msg);
+	pq_sendbyte(&msg, PARALLEL_APPLY_MSG_SEQUENCE);
+	pq_sendint64(&msg, seq);
+	pa_send(worker, msg.len, msg.data);
+	pfree(msg.data);
+
+	off = 0;
+	while (off < pa_buffer.len)
+	{
+		int			len;
+
+		memcpy(&len, pa_buffer.data + off, sizeof(int));
+		off += sizeof(int);
+		pa_send(worker, len, pa_buffer.data + off);
+		off += len;
+	}
+
+	foreach(lc, pa_relids)
+	{
+		LogicalRepRelId relid = lfirst_oid(lc);
+		ParallelApplyRelEntry *entry;
+
+		entry = hash_search(pa_relhash, &relid, HASH_ENTER, NULL);
+		entry->worker = worker;
+		entry->seq = seq;
+	}
+	pa_worker_last_seq[worker] = seq;
+
+	MemoryContextReset(pa_context);
+	pa_relids = NIL;
+}
+
+/*
+ * Handle a logical replication message received by the leader.
+ *
+ * Returns true if the message was consumed, false if the caller has to
+ * apply it.
+ */
+bool
+pa_handle_message(StringInfo s)
+{
+	char		action;
+	const char *data;
+	int			len;
+	MemoryContext oldctx;
+
+	if (pa_shared == NULL)
+		return false;
+
+	action = s->data[s->cursor];
+	data = s->data + s->cursor;
+	len = s->len - s->cursor;
+
+	/* The workers need to know all relations and types, too. */
+	if (action == 'R' || action == 'Y')
+	{
+		int			i;
+
+		for (i = 0; i < pa_shared->nworkers; i++)
+			pa_send(i, len, data);
+
+		return false;
+	}
+
+	switch (pa_state)
+	{
+		case PA_STATE_NONE:
+			if (action == 'B')
+			{
+				/*
+				 * Table synchronization needs to know what has been applied,
+				 * so apply everything ourselves until it's done.
+				 */
+				if (!AllTablesyncsReady())
+				{
+					pa_wait_for_all();
+					pa_state = PA_STATE_SERIAL;
+					return false;
+				}
+
+				oldctx = MemoryContextSwitchTo(pa_context);
+				initStringInfo(&pa_buffer);
+				MemoryContextSwitchTo(oldctx);
+
+				pa_buffer_message(data, len);
+				pa_state = PA_STATE_BUFFERING;
+				in_remote_transaction = true;
+				return true;
+			}
+
+			/* Streamed transactions are applied by ourselves. */
+			if (action == 'c')
+				pa_wait_for_all();
+
+			return false;
+
+		case PA_STATE_SERIAL:
+			if (action == 'C')
+				pa_state = PA_STATE_NONE;
+
+			return false;
+
+		case PA_STATE_BUFFERING:
+			break;
+	}
+
+	/* Remember the relations modified by the transaction. */
+	if (action == 'I' || action == 'U' || action == 'D' || action == 'T')
+	{
+		StringInfoData m;
+
+		m.data = (char *) data;
+		m.len = len;
+		m.cursor = 1;
+		m.maxlen = -1;
+
+		oldctx = MemoryContextSwitchTo(pa_context);
+		if (action == 'T')
+		{
+			int			nrelids = pq_getmsgint(&m, 4);
+			int			i;
+
+			(void) pq_getmsgint(&m, 1);
+			for (i = 0; i < nrelids; i++)
+				pa_relids = list_append_unique_oid(pa_relids,
+												   pq_getmsgint(&m, 4));
+		}
+		else
+			pa_relids = list_append_unique_oid(pa_relids,
+											   pq_getmsgint(&m, 4));
+		MemoryContextSwitchTo(oldctx);
+	}
+
+	pa_buffer_message(data, len);
+
+	if (action == 'C')
+	{
+		pa_dispatch_transaction();
+		pa_state = PA_STATE_NONE;
+		in_remote_transaction = false;
+		return true;
+	}
+
+	/* Too large to buffer, apply it ourselves. */
+	if (pa_buffer.len > PARALLEL_APPLY_QUEUE_SIZE)
+	{
+		pa_wait_for_all();
+		pa_replay_buffer();
+		pa_state = PA_STATE_SERIAL;
+	}
+
+	return true;
+}
+
+/* SIGHUP: set flag to reload configuration at next convenient time */
+static void
+pa_worker_sighup(SIGNAL_ARGS)
+{
+	int			save_errno = errno;
+
+	got_SIGHUP = true;
+
+	/* Waken anything waiting on the process latch */
+	SetLatch(MyLatch);
+
+	errno = save_errno;
+}
+
+/*
+ * Let the leader and the other workers know we're gone.
+ */
+static void
+pa_worker_shutdown(int code, Datum arg)
+{
+	if (pa_current_seq != 0)
+	{
+		LOCKTAG		tag;
+
+		SET_LOCKTAG_APPLY_TRANSACTION(tag, MyDatabaseId, MySubscription->oid,
+									  (uint32) pa_current_seq);
+		LockRelease(&tag, ExclusiveLock, true);
+		pa_current_seq = 0;
+	}
+
+	SpinLockAcquire(&pa_shared->mutex);
+	pa_shared->workers[pa_worker_index].exited = true;
+	pa_shared->workers[pa_worker_index].current_seq = 0;
+	SpinLockRelease(&pa_shared->mutex);
+
+	ConditionVariableBroadcast(&pa_shared->cv);
+	SetLatch(pa_shared->leader_latch);
+}
+
+/*
+ * Start applying the transaction with the given number, holding its lock
+ * until it has committed.
+ */
+static void
+pa_start_transaction(uint64 seq)
+{
+	LOCKTAG		tag;
+
+	Assert(pa_current_seq == 0);
+
+	SET_LOCKTAG_APPLY_TRANSACTION(tag, MyDatabaseId, MySubscription->oid,
+								  (uint32) seq);
+	(void) LockAcquire(&tag, ExclusiveLock, true, false);
+	pa_current_seq = seq;
+
+	SpinLockAcquire(&pa_shared->mutex);
+	pa_shared->workers[pa_worker_index].current_seq = seq;
+	SpinLockRelease(&pa_shared->mutex);
+
+	ConditionVariableBroadcast(&pa_shared->cv);
+}
+
+/*
+ * Wait until the transaction being applied is the next one to commit.
+ */
+void
+pa_wait_for_commit_turn(void)
+{
+	Assert(pa_current_seq != 0);
+
+	for (;;)
+	{
+		uint64		next;
+		bool		failed;
+		bool		owner_started = false;
+		int			i;
+
+		SpinLockAcquire(&pa_shared->mutex);
+		next = pa_shared->next_commit_seq;
+		failed = pa_shared->leader_exited;
+		for (i = 0; i < pa_shared->nworkers; i++)
+		{
+			if (pa_shared->workers[i].exited)
+				failed = true;
+			if (pa_shared->workers[i].current_seq == next)
+				owner_started = true;
+		}
+		SpinLockRelease(&pa_shared->mutex);
+
+		if (failed)
+			ereport(ERROR,
+					(errmsg("logical replication parallel apply worker for subscription \"%s\" will stop because another apply worker has exited",
+							MySubscription->name)));
+
+		if (next == pa_current_seq)
+			break;
+
+		if (owner_started)
+		{
+			LOCKTAG		tag;
+
+			/*
+			 * Wait on the lock of the transaction to commit first, so that
+			 * the deadlock detector knows if that one waits for us.
+			 */
+			ConditionVariableCancelSleep();
+
+			SET_LOCKTAG_APPLY_TRANSACTION(tag, MyDatabaseId,
+										  MySubscription->oid, (uint32) next);
+			(void) LockAcquire(&tag, ShareLock, true, false);
+			LockRelease(&tag, ShareLock, true);
+			continue;
+		}
+
+		ConditionVariableSleep(&pa_shared->cv,
+							   WAIT_EVENT_LOGICAL_PARALLEL_APPLY_STATE_CHANGE);
+	}
+
+	ConditionVariableCancelSleep();
+}
+
+/*
+ * Let the next transaction commit, and the leader report our progress.
+ */
+void
+pa_commit_done(XLogRecPtr remote_end, XLogRecPtr local_end)
+{
+	LOCKTAG		tag;
+
+	SpinLockAcquire(&pa_shared->mutex);
+	Assert(pa_shared->next_commit_seq == pa_current_seq);
+	pa_shared->next_commit_seq++;
+	pa_shared->last_remote_end = remote_end;
+	if (!XLogRecPtrIsInvalid(local_end))
+		pa_shared->last_local_end = local_end;
+	pa_shared->workers[pa_worker_index].current_seq = 0;
+	SpinLockRelease(&pa_shared->mutex);
+
+	SET_LOCKTAG_APPLY_TRANSACTION(tag, MyDatabaseId, MySubscription->oid,
+								  (uint32) pa_current_seq);
+	LockRelease(&tag, ExclusiveLock, true);
+	pa_current_seq = 0;
+
+	ConditionVariableBroadcast(&pa_shared->cv);
+	SetLatch(pa_shared->leader_latch);
+}
+
+/* Logical Replication parallel apply worker entry point */
+void
+ParallelApplyWorkerMain(Datum main_arg)
+{
+	int			worker_slot = DatumGetInt32(main_arg);
+	dsm_handle	handle;
+	dsm_segment *seg;
+	shm_toc    *toc;
+	shm_mq	   *mq;
+	shm_mq_handle *mqh;
+	char		originname[NAMEDATALEN];
+	RepOriginId originid;
+
+	memcpy(&handle, MyBgworkerEntry->bgw_extra, sizeof(dsm_handle));
+	memcpy(&pa_worker_index, MyBgworkerEntry->bgw_extra + sizeof(dsm_handle),
+		   sizeof(int));
+
+	/* Setup signal handling */
+	pqsignal(SIGHUP, pa_worker_sighup);
+	pqsignal(SIGTERM, die);
+	BackgroundWorkerUnblockSignals();
+
+	/*
+	 * Attach to our queue before attaching to the slot, the leader expects
+	 * to be able to send as soon as we are attached.
+	 */
+	seg = dsm_attach(handle);
+	if (seg == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("could not map dynamic shared memory segment")));
+
+	toc = shm_toc_attach(PARALLEL_APPLY_MAGIC, dsm_segment_address(seg));
+	if (toc == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("invalid magic number in dynamic shared memory segment")));
+
+	pa_shared = shm_toc_lookup(toc, PARALLEL_APPLY_KEY_SHARED, false);
+	mq = shm_toc_lookup(toc, PARALLEL_APPLY_KEY_MQ(pa_worker_index), false);
+	shm_mq_set_receiver(mq, MyProc);
+	mqh = shm_mq_attach(mq, seg, NULL);
+
+	/* Attach to slot */
+	logicalrep_worker_attach(worker_slot);
+
+	before_shmem_exit(pa_worker_shutdown, (Datum) 0);
+
+	InitializeLogRepWorker();
+
+	/* Share the replication origin of the leader. */
+	StartTransactionCommand();
+	snprintf(originname, sizeof(originname), "pg_%u", MySubscription->oid);
+	originid = replorigin_by_name(originname, false);
+	replorigin_session_setup(originid, MyLogicalRepWorker->leader_pid);
+	replorigin_session_origin = originid;
+	CommitTransactionCommand();
+
+	ApplyMessageContext = AllocSetContextCreate(ApplyContext,
+												"ApplyMessageContext",
+												ALLOCSET_DEFAULT_SIZES);
+
+	ereport(DEBUG1,
+			(errmsg("logical replication parallel apply worker for subscription \"%s\" has started",
+					MySubscription->name)));
+
+	for (;;)
+	{
+		shm_mq_result res;
+		Size		len;
+		void	   *data;
+		StringInfoData s;
+
+		CHECK_FOR_INTERRUPTS();
+
+		if (got_SIGHUP)
+		{
+			got_SIGHUP = false;
+			ProcessConfigFile(PGC_SIGHUP);
+		}
+
+		res = shm_mq_receive(mqh, &len, &data, false);
+
+		/* The leader has exited, so do we. */
+		if (res != SHM_MQ_SUCCESS)
+			break;
+
+		MemoryContextSwitchTo(ApplyMessageContext);
+
+		s.data = data;
+		s.len = len;
+		s.cursor = 0;
+		s.maxlen = -1;
+
+		if (len > 0 && s.data[0] == PARALLEL_APPLY_MSG_SEQUENCE)
+		{
+			(void) pq_getmsgbyte(&s);
+			pa_start_transaction(pq_getmsgint64(&s));
+		}
+		else
+			apply_dispatch(&s);
+
+		MemoryContextReset(ApplyMessageContext);
+	}
+
+	proc_exit(0);
+}
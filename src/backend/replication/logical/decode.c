@@ -97,11 +97,23 @@ void
 LogicalDecodingProcessRecord(LogicalDecodingContext *ctx, XLogReaderState *record)
 {
 	XLogRecordBuffer buf;
+	TransactionId txid;
 
 	buf.origptr = ctx->reader->ReadRecPtr;
 	buf.endptr = ctx->reader->EndRecPtr;
 	buf.record = record;
 
+	/*
+	 * The first WAL record of a subtransaction carries the XID of its
+	 * top-level transaction, if wal_level = logical.  Associate the two right
+	 * away, rather than waiting for an assignment or commit record, so that
+	 * the changes of an in-progress transaction can be streamed as a whole.
+	 */
+	txid = XLogRecGetTopXid(record);
+	if (TransactionIdIsValid(txid))
+		ReorderBufferAssignChild(ctx->reorder, txid, XLogRecGetXid(record),
+								 buf.origptr);
+
 	/* cast so we get a warning when new rmgrs are added */
 	switch ((RmgrIds) XLogRecGetRmid(record))
 	{
@@ -496,10 +508,30 @@ DecodeHeapOp(LogicalDecodingContext *ctx, XLogRecordBuffer *buf)
 static inline bool
 FilterByOrigin(LogicalDecodingContext *ctx, RepOriginId origin_id)
 {
-	if (ctx->callbacks.filter_by_origin_cb == NULL)
-		return false;
+	ListCell   *lc;
+
+	if (ctx->group_members == NIL)
+	{
+		if (ctx->callbacks.filter_by_origin_cb == NULL)
+			return false;
+
+		return filter_by_origin_cb_wrapper(ctx, origin_id);
+	}
+
+	/*
+	 * In a decoding group, only filter if no member is interested; the
+	 * group's callbacks in logical.c filter for the individual members.
+	 */
+	foreach(lc, ctx->group_members)
+	{
+		LogicalDecodingContext *member = lfirst(lc);
+
+		if (member->callbacks.filter_by_origin_cb == NULL ||
+			!filter_by_origin_cb_wrapper(member, origin_id))
+			return false;
+	}
 
-	return filter_by_origin_cb_wrapper(ctx, origin_id);
+	return true;
 }
 
 /*
@@ -710,7 +742,9 @@ DecodeInsert(LogicalDecodingContext *ctx, XLogRecordBuffer *buf)
 
 	change->data.tp.clear_toast_afterwards = true;
 
-	ReorderBufferQueueChange(ctx->reorder, XLogRecGetXid(r), buf->origptr, change);
+	ReorderBufferQueueChange(ctx->reorder, XLogRecGetXid(r), buf->origptr,
+							 change,
+							 (xlrec->flags & XLH_INSERT_ON_TOAST_RELATION) != 0);
 }
 
 /*
@@ -777,7 +811,8 @@ DecodeUpdate(LogicalDecodingContext *ctx, XLogRecordBuffer *buf)
 
 	change->data.tp.clear_toast_afterwards = true;
 
-	ReorderBufferQueueChange(ctx->reorder, XLogRecGetXid(r), buf->origptr, change);
+	ReorderBufferQueueChange(ctx->reorder, XLogRecGetXid(r), buf->origptr,
+							 change, false);
 }
 
 /*
@@ -834,7 +869,8 @@ DecodeDelete(LogicalDecodingContext *ctx, XLogRecordBuffer *buf)
 
 	change->data.tp.clear_toast_afterwards = true;
 
-	ReorderBufferQueueChange(ctx->reorder, XLogRecGetXid(r), buf->origptr, change);
+	ReorderBufferQueueChange(ctx->reorder, XLogRecGetXid(r), buf->origptr,
+							 change, false);
 }
 
 /*
@@ -870,7 +906,7 @@ DecodeTruncate(LogicalDecodingContext *ctx, XLogRecordBuffer *buf)
 	memcpy(change->data.truncate.relids, xlrec->relids,
 		   xlrec->nrelids * sizeof(Oid));
 	ReorderBufferQueueChange(ctx->reorder, XLogRecGetXid(r),
-							 buf->origptr, change);
+							 buf->origptr, change, false);
 }
 
 /*
@@ -972,7 +1008,7 @@ DecodeMultiInsert(LogicalDecodingContext *ctx, XLogRecordBuffer *buf)
 			change->data.tp.clear_toast_afterwards = false;
 
 		ReorderBufferQueueChange(ctx->reorder, XLogRecGetXid(r),
-								 buf->origptr, change);
+								 buf->origptr, change, false);
 	}
 	Assert(data == tupledata + tuplelen);
 }
@@ -1007,7 +1043,8 @@ DecodeSpecConfirm(LogicalDecodingContext *ctx, XLogRecordBuffer *buf)
 
 	change->data.tp.clear_toast_afterwards = true;
 
-	ReorderBufferQueueChange(ctx->reorder, XLogRecGetXid(r), buf->origptr, change);
+	ReorderBufferQueueChange(ctx->reorder, XLogRecGetXid(r), buf->origptr,
+							 change, false);
 }
 
 
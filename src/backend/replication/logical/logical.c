@@ -43,6 +43,7 @@
 #include "storage/procarray.h"
 
 #include "utils/memutils.h"
+#include "utils/rel.h"
 
 /* data for errcontext callback */
 typedef struct LogicalErrorCallbackState
@@ -64,10 +65,37 @@ static void change_cb_wrapper(ReorderBuffer *cache, ReorderBufferTXN *txn,
 				  Relation relation, ReorderBufferChange *change);
 static void truncate_cb_wrapper(ReorderBuffer *cache, ReorderBufferTXN *txn,
 					int nrelations, Relation relations[], ReorderBufferChange *change);
+static void stream_start_cb_wrapper(ReorderBuffer *cache, ReorderBufferTXN *txn);
+static void stream_stop_cb_wrapper(ReorderBuffer *cache, ReorderBufferTXN *txn);
+static void stream_abort_cb_wrapper(ReorderBuffer *cache, ReorderBufferTXN *txn,
+						XLogRecPtr abort_lsn);
+static void stream_commit_cb_wrapper(ReorderBuffer *cache, ReorderBufferTXN *txn,
+						 XLogRecPtr commit_lsn);
+static void stream_change_cb_wrapper(ReorderBuffer *cache, ReorderBufferTXN *txn,
+						 Relation relation, ReorderBufferChange *change);
+static void stream_truncate_cb_wrapper(ReorderBuffer *cache, ReorderBufferTXN *txn,
+						   int nrelations, Relation relations[],
+						   ReorderBufferChange *change);
+static void stream_message_cb_wrapper(ReorderBuffer *cache, ReorderBufferTXN *txn,
+						  XLogRecPtr message_lsn, bool transactional,
+						  const char *prefix, Size message_size, const char *message);
 static void message_cb_wrapper(ReorderBuffer *cache, ReorderBufferTXN *txn,
 				   XLogRecPtr message_lsn, bool transactional,
 				   const char *prefix, Size message_size, const char *message);
 
+/* fan ReorderBuffer callbacks out to the members of a decoding group */
+static void group_begin_cb(ReorderBuffer *cache, ReorderBufferTXN *txn);
+static void group_commit_cb(ReorderBuffer *cache, ReorderBufferTXN *txn,
+				XLogRecPtr commit_lsn);
+static void group_change_cb(ReorderBuffer *cache, ReorderBufferTXN *txn,
+				Relation relation, ReorderBufferChange *change);
+static void group_truncate_cb(ReorderBuffer *cache, ReorderBufferTXN *txn,
+				  int nrelations, Relation relations[],
+				  ReorderBufferChange *change);
+static void group_message_cb(ReorderBuffer *cache, ReorderBufferTXN *txn,
+				 XLogRecPtr message_lsn, bool transactional,
+				 const char *prefix, Size message_size, const char *message);
+
 static void LoadOutputPlugin(OutputPluginCallbacks *callbacks, char *plugin);
 
 /*
@@ -194,6 +222,21 @@ StartupDecodingContext(List *output_plugin_options,
 	ctx->reorder->commit = commit_cb_wrapper;
 	ctx->reorder->message = message_cb_wrapper;
 
+	/*
+	 * Streaming of in-progress transactions is possible if the output plugin
+	 * provides the stream callbacks; LoadOutputPlugin checked that it has
+	 * all the required ones if it has any.
+	 */
+	ctx->streaming = !fast_forward && ctx->callbacks.stream_start_cb != NULL;
+
+	ctx->reorder->stream_start = stream_start_cb_wrapper;
+	ctx->reorder->stream_stop = stream_stop_cb_wrapper;
+	ctx->reorder->stream_abort = stream_abort_cb_wrapper;
+	ctx->reorder->stream_commit = stream_commit_cb_wrapper;
+	ctx->reorder->stream_change = stream_change_cb_wrapper;
+	ctx->reorder->stream_truncate = stream_truncate_cb_wrapper;
+	ctx->reorder->stream_message = stream_message_cb_wrapper;
+
 	ctx->out = makeStringInfo();
 	ctx->prepare_write = prepare_write;
 	ctx->write = do_write;
@@ -203,6 +246,8 @@ StartupDecodingContext(List *output_plugin_options,
 
 	ctx->fast_forward = fast_forward;
 
+	ctx->group_start_lsn = start_lsn;
+
 	MemoryContextSwitchTo(old_context);
 
 	return ctx;
@@ -500,15 +545,138 @@ DecodingContextFindStartpoint(LogicalDecodingContext *ctx)
 void
 FreeDecodingContext(LogicalDecodingContext *ctx)
 {
+	ListCell   *lc;
+
 	if (ctx->callbacks.shutdown_cb != NULL)
 		shutdown_cb_wrapper(ctx);
 
+	/* the other members of a decoding group share our infrastructure */
+	foreach(lc, ctx->group_members)
+	{
+		LogicalDecodingContext *member = lfirst(lc);
+
+		if (member != ctx && member->callbacks.shutdown_cb != NULL)
+			shutdown_cb_wrapper(member);
+	}
+
 	ReorderBufferFree(ctx->reorder);
 	FreeSnapshotBuilder(ctx->snapshot_builder);
 	XLogReaderFree(ctx->reader);
 	MemoryContextDelete(ctx->context);
 }
 
+/*
+ * Attach another logical slot to the decoding context ctx, so that both are
+ * decoded from a single pass over the WAL.
+ *
+ * Decoding a slot is dominated by reading and decoding WAL and reassembling
+ * transactions in the reorder buffer, none of which depends on the slot.
+ * Several slots of the same database can therefore share ctx's reader,
+ * snapshot builder and reorder buffer; only the output plugin (possibly a
+ * different one for every slot), its options and its private state are
+ * kept per slot.  Each committed transaction is passed to the output plugin
+ * of every member whose slot hasn't confirmed it yet.
+ *
+ * ctx has to have been created by CreateDecodingContext() for the member
+ * with the oldest confirmed_flush, because decoding starts out from that
+ * slot's restart_lsn.  The slot must have been acquired using
+ * ReplicationSlotAcquireAdditional().  Members write through ctx's output
+ * routines and writer private data, so those have to be set up already.
+ *
+ * Streaming of in-progress transactions is not supported in a group, as
+ * whether a member needs a transaction isn't known before it commits.
+ *
+ * Returns the decoding context of the new member.
+ */
+LogicalDecodingContext *
+DecodingGroupAddMember(LogicalDecodingContext *ctx, ReplicationSlot *slot,
+					   List *output_plugin_options)
+{
+	LogicalDecodingContext *member;
+	MemoryContext context,
+				old_context;
+
+	Assert(!ctx->fast_forward);
+	Assert(slot != ctx->slot);
+
+	/* make sure the passed slot is suitable, these are user facing errors */
+	if (SlotIsPhysical(slot))
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 (errmsg("cannot use physical replication slot for logical decoding"))));
+
+	if (slot->data.database != MyDatabaseId)
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 (errmsg("replication slot \"%s\" was not created in this database",
+						 NameStr(slot->data.name)))));
+
+	if (slot->data.confirmed_flush < ctx->group_start_lsn)
+		elog(ERROR, "replication slot \"%s\" has confirmed less than the slot \"%s\" leading its decoding group",
+			 NameStr(slot->data.name), NameStr(ctx->slot->data.name));
+
+	context = AllocSetContextCreate(ctx->context,
+									"Logical decoding group member",
+									ALLOCSET_DEFAULT_SIZES);
+	old_context = MemoryContextSwitchTo(context);
+	member = palloc0(sizeof(LogicalDecodingContext));
+
+	member->context = context;
+	member->slot = slot;
+
+	LoadOutputPlugin(&member->callbacks, NameStr(slot->data.plugin));
+
+	member->reader = ctx->reader;
+	member->reorder = ctx->reorder;
+	member->snapshot_builder = ctx->snapshot_builder;
+	member->group_start_lsn = slot->data.confirmed_flush;
+
+	member->out = makeStringInfo();
+	member->prepare_write = ctx->prepare_write;
+	member->write = ctx->write;
+	member->update_progress = ctx->update_progress;
+	member->output_writer_private = ctx->output_writer_private;
+
+	member->output_plugin_options = output_plugin_options;
+
+	/* call output plugin initialization callback */
+	if (member->callbacks.startup_cb != NULL)
+		startup_cb_wrapper(member, &member->options, false);
+
+	MemoryContextSwitchTo(ctx->context);
+
+	/* the first member added turns ctx into the group's leader */
+	if (ctx->group_members == NIL)
+	{
+		ctx->group_members = list_make1(ctx);
+
+		ctx->reorder->begin = group_begin_cb;
+		ctx->reorder->apply_change = group_change_cb;
+		ctx->reorder->apply_truncate = group_truncate_cb;
+		ctx->reorder->commit = group_commit_cb;
+		ctx->reorder->message = group_message_cb;
+
+		ctx->streaming = false;
+	}
+	ctx->group_members = lappend(ctx->group_members, member);
+
+	/* group_change_cb filters out rewrites for members not asking for them */
+	if (member->options.receive_rewrites)
+		ctx->reorder->output_rewrites = true;
+
+	MemoryContextSwitchTo(old_context);
+
+	ereport(LOG,
+			(errmsg("starting logical decoding for slot \"%s\"",
+					NameStr(slot->data.name)),
+			 errdetail("Streaming transactions committing after %X/%X, decoding together with slot \"%s\".",
+					   (uint32) (slot->data.confirmed_flush >> 32),
+					   (uint32) slot->data.confirmed_flush,
+					   NameStr(ctx->slot->data.name))));
+
+	return member;
+}
+
 /*
  * Prepare a write using the context's output routine.
  */
@@ -571,6 +739,24 @@ LoadOutputPlugin(OutputPluginCallbacks *callbacks, char *plugin)
 		elog(ERROR, "output plugins have to register a change callback");
 	if (callbacks->commit_cb == NULL)
 		elog(ERROR, "output plugins have to register a commit callback");
+
+	/*
+	 * Streaming is optional, but a plugin that supports it has to register
+	 * all the callbacks needed to send a transaction in pieces.
+	 */
+	if (callbacks->stream_start_cb != NULL ||
+		callbacks->stream_stop_cb != NULL ||
+		callbacks->stream_abort_cb != NULL ||
+		callbacks->stream_commit_cb != NULL ||
+		callbacks->stream_change_cb != NULL)
+	{
+		if (callbacks->stream_start_cb == NULL ||
+			callbacks->stream_stop_cb == NULL ||
+			callbacks->stream_abort_cb == NULL ||
+			callbacks->stream_commit_cb == NULL ||
+			callbacks->stream_change_cb == NULL)
+			elog(ERROR, "output plugins supporting streaming have to register stream start, stop, abort, commit and change callbacks");
+	}
 }
 
 static void
@@ -856,6 +1042,382 @@ message_cb_wrapper(ReorderBuffer *cache, ReorderBufferTXN *txn,
 	error_context_stack = errcallback.previous;
 }
 
+static void
+stream_start_cb_wrapper(ReorderBuffer *cache, ReorderBufferTXN *txn)
+{
+	LogicalDecodingContext *ctx = cache->private_data;
+	LogicalErrorCallbackState state;
+	ErrorContextCallback errcallback;
+
+	Assert(!ctx->fast_forward);
+	Assert(ctx->streaming);
+
+	/* Push callback + info on the error context stack */
+	state.ctx = ctx;
+	state.callback_name = "stream_start";
+	state.report_location = InvalidXLogRecPtr;
+	errcallback.callback = output_plugin_error_callback;
+	errcallback.arg = (void *) &state;
+	errcallback.previous = error_context_stack;
+	error_context_stack = &errcallback;
+
+	/* set output state */
+	ctx->accept_writes = true;
+	ctx->write_xid = txn->xid;
+
+	/*
+	 * There's no LSN to report for a streamed block of changes as a whole,
+	 * so report the position of the record being decoded, which is what
+	 * caused the transaction to be streamed.
+	 */
+	ctx->write_location = ctx->reader->ReadRecPtr;
+
+	/* do the actual work: call callback */
+	ctx->callbacks.stream_start_cb(ctx, txn);
+
+	/* Pop the error context stack */
+	error_context_stack = errcallback.previous;
+}
+
+static void
+stream_stop_cb_wrapper(ReorderBuffer *cache, ReorderBufferTXN *txn)
+{
+	LogicalDecodingContext *ctx = cache->private_data;
+	LogicalErrorCallbackState state;
+	ErrorContextCallback errcallback;
+
+	Assert(!ctx->fast_forward);
+	Assert(ctx->streaming);
+
+	/* Push callback + info on the error context stack */
+	state.ctx = ctx;
+	state.callback_name = "stream_stop";
+	state.report_location = InvalidXLogRecPtr;
+	errcallback.callback = output_plugin_error_callback;
+	errcallback.arg = (void *) &state;
+	errcallback.previous = error_context_stack;
+	error_context_stack = &errcallback;
+
+	/* set output state */
+	ctx->accept_writes = true;
+	ctx->write_xid = txn->xid;
+	ctx->write_location = ctx->reader->ReadRecPtr;
+
+	/* do the actual work: call callback */
+	ctx->callbacks.stream_stop_cb(ctx, txn);
+
+	/* Pop the error context stack */
+	error_context_stack = errcallback.previous;
+}
+
+static void
+stream_abort_cb_wrapper(ReorderBuffer *cache, ReorderBufferTXN *txn,
+						XLogRecPtr abort_lsn)
+{
+	LogicalDecodingContext *ctx = cache->private_data;
+	LogicalErrorCallbackState state;
+	ErrorContextCallback errcallback;
+
+	Assert(!ctx->fast_forward);
+	Assert(ctx->streaming);
+
+	/* Push callback + info on the error context stack */
+	state.ctx = ctx;
+	state.callback_name = "stream_abort";
+	state.report_location = abort_lsn;
+	errcallback.callback = output_plugin_error_callback;
+	errcallback.arg = (void *) &state;
+	errcallback.previous = error_context_stack;
+	error_context_stack = &errcallback;
+
+	/* set output state */
+	ctx->accept_writes = true;
+	ctx->write_xid = txn->xid;
+	ctx->write_location = abort_lsn;
+
+	/* do the actual work: call callback */
+	ctx->callbacks.stream_abort_cb(ctx, txn, abort_lsn);
+
+	/* Pop the error context stack */
+	error_context_stack = errcallback.previous;
+}
+
+static void
+stream_commit_cb_wrapper(ReorderBuffer *cache, ReorderBufferTXN *txn,
+						 XLogRecPtr commit_lsn)
+{
+	LogicalDecodingContext *ctx = cache->private_data;
+	LogicalErrorCallbackState state;
+	ErrorContextCallback errcallback;
+
+	Assert(!ctx->fast_forward);
+	Assert(ctx->streaming);
+
+	/* Push callback + info on the error context stack */
+	state.ctx = ctx;
+	state.callback_name = "stream_commit";
+	state.report_location = txn->final_lsn; /* beginning of commit record */
+	errcallback.callback = output_plugin_error_callback;
+	errcallback.arg = (void *) &state;
+	errcallback.previous = error_context_stack;
+	error_context_stack = &errcallback;
+
+	/* set output state */
+	ctx->accept_writes = true;
+	ctx->write_xid = txn->xid;
+	ctx->write_location = txn->end_lsn; /* points to the end of the record */
+
+	/* do the actual work: call callback */
+	ctx->callbacks.stream_commit_cb(ctx, txn, commit_lsn);
+
+	/* Pop the error context stack */
+	error_context_stack = errcallback.previous;
+}
+
+static void
+stream_change_cb_wrapper(ReorderBuffer *cache, ReorderBufferTXN *txn,
+						 Relation relation, ReorderBufferChange *change)
+{
+	LogicalDecodingContext *ctx = cache->private_data;
+	LogicalErrorCallbackState state;
+	ErrorContextCallback errcallback;
+
+	Assert(!ctx->fast_forward);
+	Assert(ctx->streaming);
+
+	/* Push callback + info on the error context stack */
+	state.ctx = ctx;
+	state.callback_name = "stream_change";
+	state.report_location = change->lsn;
+	errcallback.callback = output_plugin_error_callback;
+	errcallback.arg = (void *) &state;
+	errcallback.previous = error_context_stack;
+	error_context_stack = &errcallback;
+
+	/* set output state */
+	ctx->accept_writes = true;
+	ctx->write_xid = txn->xid;
+
+	/* see change_cb_wrapper */
+	ctx->write_location = change->lsn;
+
+	ctx->callbacks.stream_change_cb(ctx, txn, relation, change);
+
+	/* Pop the error context stack */
+	error_context_stack = errcallback.previous;
+}
+
+static void
+stream_truncate_cb_wrapper(ReorderBuffer *cache, ReorderBufferTXN *txn,
+						   int nrelations, Relation relations[],
+						   ReorderBufferChange *change)
+{
+	LogicalDecodingContext *ctx = cache->private_data;
+	LogicalErrorCallbackState state;
+	ErrorContextCallback errcallback;
+
+	Assert(!ctx->fast_forward);
+	Assert(ctx->streaming);
+
+	if (!ctx->callbacks.stream_truncate_cb)
+		return;
+
+	/* Push callback + info on the error context stack */
+	state.ctx = ctx;
+	state.callback_name = "stream_truncate";
+	state.report_location = change->lsn;
+	errcallback.callback = output_plugin_error_callback;
+	errcallback.arg = (void *) &state;
+	errcallback.previous = error_context_stack;
+	error_context_stack = &errcallback;
+
+	/* set output state */
+	ctx->accept_writes = true;
+	ctx->write_xid = txn->xid;
+
+	/* see change_cb_wrapper */
+	ctx->write_location = change->lsn;
+
+	ctx->callbacks.stream_truncate_cb(ctx, txn, nrelations, relations, change);
+
+	/* Pop the error context stack */
+	error_context_stack = errcallback.previous;
+}
+
+static void
+stream_message_cb_wrapper(ReorderBuffer *cache, ReorderBufferTXN *txn,
+						  XLogRecPtr message_lsn, bool transactional,
+						  const char *prefix, Size message_size,
+						  const char *message)
+{
+	LogicalDecodingContext *ctx = cache->private_data;
+	LogicalErrorCallbackState state;
+	ErrorContextCallback errcallback;
+
+	Assert(!ctx->fast_forward);
+	Assert(ctx->streaming);
+
+	if (ctx->callbacks.stream_message_cb == NULL)
+		return;
+
+	/* Push callback + info on the error context stack */
+	state.ctx = ctx;
+	state.callback_name = "stream_message";
+	state.report_location = message_lsn;
+	errcallback.callback = output_plugin_error_callback;
+	errcallback.arg = (void *) &state;
+	errcallback.previous = error_context_stack;
+	error_context_stack = &errcallback;
+
+	/* set output state */
+	ctx->accept_writes = true;
+	ctx->write_xid = txn->xid;
+	ctx->write_location = message_lsn;
+
+	/* do the actual work: call callback */
+	ctx->callbacks.stream_message_cb(ctx, txn, message_lsn, transactional,
+									 prefix, message_size, message);
+
+	/* Pop the error context stack */
+	error_context_stack = errcallback.previous;
+}
+
+/*
+ * Should the given member of a decoding group skip a transaction, or a
+ * non-transactional message, that committed at lsn?
+ */
+static bool
+group_member_skips(LogicalDecodingContext *member, XLogRecPtr lsn,
+				   RepOriginId origin_id)
+{
+	if (lsn < member->group_start_lsn)
+		return true;
+
+	/* see FilterByOrigin() in decode.c */
+	if (member->callbacks.filter_by_origin_cb != NULL &&
+		filter_by_origin_cb_wrapper(member, origin_id))
+		return true;
+
+	return false;
+}
+
+/*
+ * Callbacks for ReorderBuffers shared by a decoding group.  These pass every
+ * callback on to the regular wrappers of all members interested in the
+ * transaction, temporarily pointing the ReorderBuffer's private data at the
+ * member.
+ */
+static void
+group_begin_cb(ReorderBuffer *cache, ReorderBufferTXN *txn)
+{
+	LogicalDecodingContext *ctx = cache->private_data;
+	ListCell   *lc;
+
+	foreach(lc, ctx->group_members)
+	{
+		LogicalDecodingContext *member = lfirst(lc);
+
+		if (group_member_skips(member, txn->final_lsn, txn->origin_id))
+			continue;
+
+		cache->private_data = member;
+		begin_cb_wrapper(cache, txn);
+	}
+	cache->private_data = ctx;
+}
+
+static void
+group_commit_cb(ReorderBuffer *cache, ReorderBufferTXN *txn,
+				XLogRecPtr commit_lsn)
+{
+	LogicalDecodingContext *ctx = cache->private_data;
+	ListCell   *lc;
+
+	foreach(lc, ctx->group_members)
+	{
+		LogicalDecodingContext *member = lfirst(lc);
+
+		if (group_member_skips(member, txn->final_lsn, txn->origin_id))
+			continue;
+
+		cache->private_data = member;
+		commit_cb_wrapper(cache, txn, commit_lsn);
+	}
+	cache->private_data = ctx;
+}
+
+static void
+group_change_cb(ReorderBuffer *cache, ReorderBufferTXN *txn,
+				Relation relation, ReorderBufferChange *change)
+{
+	LogicalDecodingContext *ctx = cache->private_data;
+	ListCell   *lc;
+
+	foreach(lc, ctx->group_members)
+	{
+		LogicalDecodingContext *member = lfirst(lc);
+
+		if (group_member_skips(member, txn->final_lsn, txn->origin_id))
+			continue;
+
+		/* the ReorderBuffer only checks whether any member wants these */
+		if (relation->rd_rel->relrewrite && !member->options.receive_rewrites)
+			continue;
+
+		cache->private_data = member;
+		change_cb_wrapper(cache, txn, relation, change);
+	}
+	cache->private_data = ctx;
+}
+
+static void
+group_truncate_cb(ReorderBuffer *cache, ReorderBufferTXN *txn,
+				  int nrelations, Relation relations[],
+				  ReorderBufferChange *change)
+{
+	LogicalDecodingContext *ctx = cache->private_data;
+	ListCell   *lc;
+
+	foreach(lc, ctx->group_members)
+	{
+		LogicalDecodingContext *member = lfirst(lc);
+
+		if (group_member_skips(member, txn->final_lsn, txn->origin_id))
+			continue;
+
+		cache->private_data = member;
+		truncate_cb_wrapper(cache, txn, nrelations, relations, change);
+	}
+	cache->private_data = ctx;
+}
+
+static void
+group_message_cb(ReorderBuffer *cache, ReorderBufferTXN *txn,
+				 XLogRecPtr message_lsn, bool transactional,
+				 const char *prefix, Size message_size, const char *message)
+{
+	LogicalDecodingContext *ctx = cache->private_data;
+	ListCell   *lc;
+
+	foreach(lc, ctx->group_members)
+	{
+		LogicalDecodingContext *member = lfirst(lc);
+
+		if (transactional)
+		{
+			if (group_member_skips(member, txn->final_lsn, txn->origin_id))
+				continue;
+		}
+		else if (message_lsn < member->group_start_lsn)
+			continue;
+
+		cache->private_data = member;
+		message_cb_wrapper(cache, txn, message_lsn, transactional, prefix,
+						   message_size, message);
+	}
+	cache->private_data = ctx;
+}
+
 /*
  * Set the required catalog xmin horizon for historic snapshots in the current
  * replication slot.
@@ -1073,3 +1635,108 @@ LogicalConfirmReceivedLocation(XLogRecPtr lsn)
 		SpinLockRelease(&MyReplicationSlot->mutex);
 	}
 }
+
+/*
+ * Handle a consumer's confirmation having received all changes of a decoding
+ * group up to lsn.
+ *
+ * Only the leader's slot, which is MyReplicationSlot, gets to see the
+ * candidate xmin and restart_lsn values computed while decoding.  But once
+ * another member has confirmed the same lsn, the leader's values are just as
+ * valid for it, as decoding from them reproduces what the leader would
+ * decode.  So members whose old values are older simply adopt them.
+ */
+void
+DecodingGroupConfirmReceivedLocation(LogicalDecodingContext *ctx,
+									 XLogRecPtr lsn)
+{
+	ReplicationSlot *leader = ctx->slot;
+	bool		updated_xmin = false;
+	bool		updated_restart = false;
+	ListCell   *lc;
+
+	Assert(MyReplicationSlot == leader);
+
+	LogicalConfirmReceivedLocation(lsn);
+	ReplicationSlotMarkDirty();
+
+	/* ReplicationSlotMarkDirty() and friends act on MyReplicationSlot */
+	PG_TRY();
+	{
+		foreach(lc, ctx->group_members)
+		{
+			LogicalDecodingContext *member = lfirst(lc);
+			ReplicationSlot *slot = member->slot;
+			bool		slot_updated_xmin = false;
+			bool		slot_updated_restart = false;
+
+			/* don't move a member's position backwards */
+			if (member == ctx || lsn <= slot->data.confirmed_flush)
+				continue;
+
+			MyReplicationSlot = slot;
+
+			SpinLockAcquire(&slot->mutex);
+			slot->data.confirmed_flush = lsn;
+
+			if (TransactionIdIsValid(leader->data.catalog_xmin) &&
+				TransactionIdPrecedes(slot->data.catalog_xmin,
+									  leader->data.catalog_xmin))
+			{
+				slot->data.catalog_xmin = leader->data.catalog_xmin;
+				slot_updated_xmin = true;
+
+				/* an older candidate must not undo this later on */
+				if (TransactionIdIsValid(slot->candidate_catalog_xmin) &&
+					TransactionIdPrecedesOrEquals(slot->candidate_catalog_xmin,
+												  slot->data.catalog_xmin))
+				{
+					slot->candidate_catalog_xmin = InvalidTransactionId;
+					slot->candidate_xmin_lsn = InvalidXLogRecPtr;
+				}
+			}
+
+			if (leader->data.restart_lsn > slot->data.restart_lsn)
+			{
+				slot->data.restart_lsn = leader->data.restart_lsn;
+				slot_updated_restart = true;
+
+				if (slot->candidate_restart_valid != InvalidXLogRecPtr &&
+					slot->candidate_restart_lsn <= slot->data.restart_lsn)
+				{
+					slot->candidate_restart_lsn = InvalidXLogRecPtr;
+					slot->candidate_restart_valid = InvalidXLogRecPtr;
+				}
+			}
+			SpinLockRelease(&slot->mutex);
+
+			/* see LogicalConfirmReceivedLocation() and the SQL interface */
+			ReplicationSlotMarkDirty();
+			if (slot_updated_xmin || slot_updated_restart)
+				ReplicationSlotSave();
+
+			if (slot_updated_xmin)
+			{
+				SpinLockAcquire(&slot->mutex);
+				slot->effective_catalog_xmin = slot->data.catalog_xmin;
+				SpinLockRelease(&slot->mutex);
+			}
+
+			updated_xmin |= slot_updated_xmin;
+			updated_restart |= slot_updated_restart;
+		}
+	}
+	PG_CATCH();
+	{
+		MyReplicationSlot = leader;
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+
+	MyReplicationSlot = leader;
+
+	if (updated_xmin)
+		ReplicationSlotsComputeRequiredXmin(false);
+	if (updated_xmin || updated_restart)
+		ReplicationSlotsComputeRequiredLSN();
+}
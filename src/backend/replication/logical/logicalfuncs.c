@@ -105,6 +105,41 @@ LogicalOutputWrite(LogicalDecodingContext *ctx, XLogRecPtr lsn, TransactionId xi
 	p->returned_rows++;
 }
 
+/*
+ * Perform output plugin write into tuplestore, for a decoding group.  Like
+ * LogicalOutputWrite(), but also returns the slot the output is for.
+ */
+static void
+LogicalGroupOutputWrite(LogicalDecodingContext *ctx, XLogRecPtr lsn,
+						TransactionId xid, bool last_write)
+{
+	Datum		values[4];
+	bool		nulls[4];
+	DecodingOutputState *p;
+
+	/* SQL Datums can only be of a limited length... */
+	if (ctx->out->len > MaxAllocSize - VARHDRSZ)
+		elog(ERROR, "too much output for sql interface");
+
+	p = (DecodingOutputState *) ctx->output_writer_private;
+
+	memset(nulls, 0, sizeof(nulls));
+	values[0] = NameGetDatum(&ctx->slot->data.name);
+	values[1] = LSNGetDatum(lsn);
+	values[2] = TransactionIdGetDatum(xid);
+
+	Assert(p->binary_output ||
+		   pg_verify_mbstr(GetDatabaseEncoding(),
+						   ctx->out->data, ctx->out->len,
+						   false));
+
+	values[3] = PointerGetDatum(
+								cstring_to_text_with_len(ctx->out->data, ctx->out->len));
+
+	tuplestore_putvalues(p->tupstore, p->tupdesc, values, nulls);
+	p->returned_rows++;
+}
+
 static void
 check_permissions(void)
 {
@@ -122,6 +157,57 @@ logical_read_local_xlog_page(XLogReaderState *state, XLogRecPtr targetPagePtr,
 								targetRecPtr, cur_page, pageTLI);
 }
 
+/*
+ * Turn the options array passed to the SQL callable logical decoding
+ * functions into a list of DefElems for the output plugin.
+ */
+static List *
+deconstruct_plugin_options(ArrayType *arr)
+{
+	List	   *options = NIL;
+	Size		ndim;
+
+	ndim = ARR_NDIM(arr);
+	if (ndim > 1)
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("array must be one-dimensional")));
+	}
+	else if (array_contains_nulls(arr))
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("array must not contain nulls")));
+	}
+	else if (ndim == 1)
+	{
+		int			nelems;
+		Datum	   *datum_opts;
+		int			i;
+
+		Assert(ARR_ELEMTYPE(arr) == TEXTOID);
+
+		deconstruct_array(arr, TEXTOID, -1, false, 'i',
+						  &datum_opts, NULL, &nelems);
+
+		if (nelems % 2 != 0)
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("array must have even number of elements")));
+
+		for (i = 0; i < nelems; i += 2)
+		{
+			char	   *name = TextDatumGetCString(datum_opts[i]);
+			char	   *opt = TextDatumGetCString(datum_opts[i + 1]);
+
+			options = lappend(options, makeDefElem(name, (Node *) makeString(opt), -1));
+		}
+	}
+
+	return options;
+}
+
 /*
  * Helper function for the various SQL callable logical decoding functions.
  */
@@ -139,8 +225,7 @@ pg_logical_slot_get_changes_guts(FunctionCallInfo fcinfo, bool confirm, bool bin
 	LogicalDecodingContext *ctx;
 	ResourceOwner old_resowner = CurrentResourceOwner;
 	ArrayType  *arr;
-	Size		ndim;
-	List	   *options = NIL;
+	List	   *options;
 	DecodingOutputState *p;
 
 	check_permissions();
@@ -192,43 +277,7 @@ pg_logical_slot_get_changes_guts(FunctionCallInfo fcinfo, bool confirm, bool bin
 	oldcontext = MemoryContextSwitchTo(per_query_ctx);
 
 	/* Deconstruct options array */
-	ndim = ARR_NDIM(arr);
-	if (ndim > 1)
-	{
-		ereport(ERROR,
-				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-				 errmsg("array must be one-dimensional")));
-	}
-	else if (array_contains_nulls(arr))
-	{
-		ereport(ERROR,
-				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-				 errmsg("array must not contain nulls")));
-	}
-	else if (ndim == 1)
-	{
-		int			nelems;
-		Datum	   *datum_opts;
-		int			i;
-
-		Assert(ARR_ELEMTYPE(arr) == TEXTOID);
-
-		deconstruct_array(arr, TEXTOID, -1, false, 'i',
-						  &datum_opts, NULL, &nelems);
-
-		if (nelems % 2 != 0)
-			ereport(ERROR,
-					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-					 errmsg("array must have even number of elements")));
-
-		for (i = 0; i < nelems; i += 2)
-		{
-			char	   *name = TextDatumGetCString(datum_opts[i]);
-			char	   *opt = TextDatumGetCString(datum_opts[i + 1]);
-
-			options = lappend(options, makeDefElem(name, (Node *) makeString(opt), -1));
-		}
-	}
+	options = deconstruct_plugin_options(arr);
 
 	p->tupstore = tuplestore_begin_heap(true, false, work_mem);
 	rsinfo->returnMode = SFRM_Materialize;
@@ -403,6 +452,305 @@ pg_logical_slot_peek_binary_changes(PG_FUNCTION_ARGS)
 	return pg_logical_slot_get_changes_guts(fcinfo, false, true);
 }
 
+/*
+ * Helper function for the SQL callable functions decoding several slots in
+ * one pass over the WAL, see DecodingGroupAddMember().
+ */
+static Datum
+pg_logical_slot_group_get_changes_guts(FunctionCallInfo fcinfo, bool confirm)
+{
+	ArrayType  *names_arr;
+	XLogRecPtr	upto_lsn;
+	int32		upto_nchanges;
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	MemoryContext per_query_ctx;
+	MemoryContext oldcontext;
+	XLogRecPtr	end_of_wal;
+	XLogRecPtr	startptr;
+	LogicalDecodingContext *ctx;
+	ResourceOwner old_resowner = CurrentResourceOwner;
+	ArrayType  *arr;
+	List	   *options;
+	DecodingOutputState *p;
+	Datum	   *names;
+	int			nslots;
+	ReplicationSlot **slots;
+	ReplicationSlot *leader;
+	List	   *members;
+	ListCell   *lc;
+	int			i;
+	int			j;
+
+	check_permissions();
+
+	CheckLogicalDecodingRequirements();
+
+	if (PG_ARGISNULL(0))
+		ereport(ERROR,
+				(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED),
+				 errmsg("slot names array must not be null")));
+	names_arr = PG_GETARG_ARRAYTYPE_P(0);
+
+	if (PG_ARGISNULL(1))
+		upto_lsn = InvalidXLogRecPtr;
+	else
+		upto_lsn = PG_GETARG_LSN(1);
+
+	if (PG_ARGISNULL(2))
+		upto_nchanges = InvalidXLogRecPtr;
+	else
+		upto_nchanges = PG_GETARG_INT32(2);
+
+	if (PG_ARGISNULL(3))
+		ereport(ERROR,
+				(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED),
+				 errmsg("options array must not be null")));
+	arr = PG_GETARG_ARRAYTYPE_P(3);
+
+	/* check to see if caller supports us returning a tuplestore */
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not allowed in this context")));
+
+	/* state to write output to */
+	p = palloc0(sizeof(DecodingOutputState));
+
+	p->binary_output = false;
+
+	/* Build a tuple descriptor for our result type */
+	if (get_call_result_type(fcinfo, NULL, &p->tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	/* Deconstruct slot names array */
+	if (ARR_NDIM(names_arr) > 1)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("array must be one-dimensional")));
+	if (array_contains_nulls(names_arr))
+		ereport(ERROR,
+				(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED),
+				 errmsg("slot name must not be null")));
+
+	Assert(ARR_ELEMTYPE(names_arr) == NAMEOID);
+	deconstruct_array(names_arr, NAMEOID, NAMEDATALEN, false, 'c',
+					  &names, NULL, &nslots);
+
+	if (nslots == 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("at least one slot name must be specified")));
+
+	/* acquiring the same slot twice would silently succeed */
+	for (i = 0; i < nslots; i++)
+	{
+		for (j = 0; j < i; j++)
+		{
+			if (strcmp(NameStr(*DatumGetName(names[i])),
+					   NameStr(*DatumGetName(names[j]))) == 0)
+				ereport(ERROR,
+						(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+						 errmsg("replication slot \"%s\" specified more than once",
+								NameStr(*DatumGetName(names[i])))));
+		}
+	}
+
+	/* Deconstruct options array */
+	options = deconstruct_plugin_options(arr);
+
+	p->tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = p->tupstore;
+	rsinfo->setDesc = p->tupdesc;
+
+	/*
+	 * Compute the current end-of-wal and maintain ThisTimeLineID.
+	 * RecoveryInProgress() will update ThisTimeLineID on promotion.
+	 */
+	if (!RecoveryInProgress())
+		end_of_wal = GetFlushRecPtr();
+	else
+		end_of_wal = GetXLogReplayRecPtr(&ThisTimeLineID);
+
+	slots = palloc0(sizeof(ReplicationSlot *) * nslots);
+
+	/*
+	 * Only one of the slots can be MyReplicationSlot; the others are
+	 * acquired separately and released by us even on error.
+	 */
+	PG_TRY();
+	{
+		for (i = 0; i < nslots; i++)
+			slots[i] = ReplicationSlotAcquireAdditional(NameStr(*DatumGetName(names[i])),
+														true);
+
+		/* decoding has to start out from the oldest confirmed position */
+		leader = slots[0];
+		for (i = 1; i < nslots; i++)
+		{
+			if (slots[i]->data.confirmed_flush < leader->data.confirmed_flush)
+				leader = slots[i];
+		}
+
+		for (i = 0; i < nslots; i++)
+		{
+			if (slots[i] == leader)
+			{
+				slots[i] = NULL;
+				break;
+			}
+		}
+		MyReplicationSlot = leader;
+
+		/* restart at the leader's confirmed_flush */
+		ctx = CreateDecodingContext(InvalidXLogRecPtr,
+									options,
+									false,
+									logical_read_local_xlog_page,
+									LogicalOutputPrepareWrite,
+									LogicalGroupOutputWrite, NULL);
+
+		ctx->output_writer_private = p;
+
+		for (i = 0; i < nslots; i++)
+		{
+			if (slots[i] != NULL)
+				DecodingGroupAddMember(ctx, slots[i], options);
+		}
+
+		MemoryContextSwitchTo(oldcontext);
+
+		/*
+		 * Check whether the output plugins write textual output, as that's
+		 * what we return.
+		 */
+		members = ctx->group_members != NIL ? ctx->group_members :
+			list_make1(ctx);
+		foreach(lc, members)
+		{
+			LogicalDecodingContext *member = lfirst(lc);
+
+			if (member->options.output_type != OUTPUT_PLUGIN_TEXTUAL_OUTPUT)
+				ereport(ERROR,
+						(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+						 errmsg("logical decoding output plugin \"%s\" produces binary output, but function \"%s\" expects textual data",
+								NameStr(member->slot->data.plugin),
+								format_procedure(fcinfo->flinfo->fn_oid))));
+		}
+
+		/*
+		 * Decoding of WAL must start at restart_lsn so that the entirety of
+		 * xacts that committed after the leader's confirmed_flush can be
+		 * accumulated into reorder buffers.  That covers all the other
+		 * members as well, as they have confirmed at least as much.
+		 */
+		startptr = MyReplicationSlot->data.restart_lsn;
+
+		/* invalidate non-timetravel entries */
+		InvalidateSystemCaches();
+
+		/* Decode until we run out of records */
+		while ((startptr != InvalidXLogRecPtr && startptr < end_of_wal) ||
+			   (ctx->reader->EndRecPtr != InvalidXLogRecPtr && ctx->reader->EndRecPtr < end_of_wal))
+		{
+			XLogRecord *record;
+			char	   *errm = NULL;
+
+			record = XLogReadRecord(ctx->reader, startptr, &errm);
+			if (errm)
+				elog(ERROR, "%s", errm);
+
+			startptr = InvalidXLogRecPtr;
+
+			if (record != NULL)
+				LogicalDecodingProcessRecord(ctx, ctx->reader);
+
+			/* check limits */
+			if (upto_lsn != InvalidXLogRecPtr &&
+				upto_lsn <= ctx->reader->EndRecPtr)
+				break;
+			if (upto_nchanges != 0 &&
+				upto_nchanges <= p->returned_rows)
+				break;
+			CHECK_FOR_INTERRUPTS();
+		}
+
+		/* see pg_logical_slot_get_changes_guts() */
+		CurrentResourceOwner = old_resowner;
+
+		/* next time, each slot starts where we left off */
+		if (ctx->reader->EndRecPtr != InvalidXLogRecPtr && confirm)
+		{
+			if (ctx->group_members != NIL)
+				DecodingGroupConfirmReceivedLocation(ctx, ctx->reader->EndRecPtr);
+			else
+			{
+				LogicalConfirmReceivedLocation(ctx->reader->EndRecPtr);
+				ReplicationSlotMarkDirty();
+			}
+		}
+
+		/* free context, call shutdown callbacks */
+		FreeDecodingContext(ctx);
+
+		ReplicationSlotRelease();
+		for (i = 0; i < nslots; i++)
+		{
+			if (slots[i] != NULL)
+			{
+				ReplicationSlotReleaseAdditional(slots[i]);
+				slots[i] = NULL;
+			}
+		}
+
+		InvalidateSystemCaches();
+	}
+	PG_CATCH();
+	{
+		/* clear all timetravel entries */
+		InvalidateSystemCaches();
+
+		/* the leader, if any, is released as MyReplicationSlot */
+		for (i = 0; i < nslots; i++)
+		{
+			if (slots[i] != NULL)
+				ReplicationSlotReleaseAdditional(slots[i]);
+		}
+
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+
+	return (Datum) 0;
+}
+
+/*
+ * SQL function returning the changestreams of several slots as text,
+ * consuming the data.
+ */
+Datum
+pg_logical_slot_group_get_changes(PG_FUNCTION_ARGS)
+{
+	return pg_logical_slot_group_get_changes_guts(fcinfo, true);
+}
+
+/*
+ * SQL function returning the changestreams of several slots as text, only
+ * peeking ahead.
+ */
+Datum
+pg_logical_slot_group_peek_changes(PG_FUNCTION_ARGS)
+{
+	return pg_logical_slot_group_get_changes_guts(fcinfo, false);
+}
+
 
 /*
  * SQL function for writing logical decoding message into WAL.
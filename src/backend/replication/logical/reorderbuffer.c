@@ -34,7 +34,12 @@
  *	  big as the available memory - this module supports spooling the contents
  *	  of a large transactions to disk. When the transaction is replayed the
  *	  contents of individual (sub-)transactions will be read from disk in
- *	  chunks.
+ *	  chunks.  The memory used by all transactions together is limited by
+ *	  logical_decoding_work_mem; once it's exceeded, the largest transaction
+ *	  is spilled.  If the output plugin supports streaming, the largest
+ *	  top-level transaction is instead sent downstream while still in
+ *	  progress (cf. ReorderBufferStreamTXN()), and its changes are discarded
+ *	  from memory.
  *
  *	  This module also has to deal with reassembling toast records from the
  *	  individual chunks stored in WAL. When a new (or initial) version of a
@@ -143,19 +148,14 @@ typedef struct ReorderBufferDiskChange
 } ReorderBufferDiskChange;
 
 /*
- * Maximum number of changes kept in memory, per transaction. After that,
- * changes are spooled to disk.
- *
- * The current value should be sufficient to decode the entire transaction
- * without hitting disk in OLTP workloads, while starting to spool to disk in
- * other workloads reasonably fast.
- *
- * At some point in the future it probably makes sense to have a more elaborate
- * resource management here, but it's not entirely clear what that would look
- * like.
+ * Maximum number of changes restored from disk into memory at a time, per
+ * transaction, when replaying a spilled transaction.
  */
 static const Size max_changes_in_memory = 4096;
 
+/* GUC variable: memory used by decoded changes before spilling, in kB */
+int			logical_decoding_work_mem = 65536;
+
 /* ---------------------------------------
  * primary reorderbuffer support routines
  * ---------------------------------------
@@ -189,7 +189,7 @@ static void ReorderBufferExecuteInvalidations(ReorderBuffer *rb, ReorderBufferTX
  * Disk serialization support functions
  * ---------------------------------------
  */
-static void ReorderBufferCheckSerializeTXN(ReorderBuffer *rb, ReorderBufferTXN *txn);
+static void ReorderBufferCheckMemoryLimit(ReorderBuffer *rb);
 static void ReorderBufferSerializeTXN(ReorderBuffer *rb, ReorderBufferTXN *txn);
 static void ReorderBufferSerializeChange(ReorderBuffer *rb, ReorderBufferTXN *txn,
 							 int fd, ReorderBufferChange *change);
@@ -199,6 +199,7 @@ static void ReorderBufferRestoreChange(ReorderBuffer *rb, ReorderBufferTXN *txn,
 						   char *change);
 static void ReorderBufferRestoreCleanup(ReorderBuffer *rb, ReorderBufferTXN *txn);
 static void ReorderBufferCleanupSerializedTXNs(const char *slotname);
+static void ReorderBufferTruncateTXN(ReorderBuffer *rb, ReorderBufferTXN *txn);
 static void ReorderBufferSerializedPath(char *path, ReplicationSlot *slot,
 							TransactionId xid, XLogSegNo segno);
 
@@ -206,6 +207,24 @@ static void ReorderBufferFreeSnap(ReorderBuffer *rb, Snapshot snap);
 static Snapshot ReorderBufferCopySnap(ReorderBuffer *rb, Snapshot orig_snap,
 					  ReorderBufferTXN *txn, CommandId cid);
 
+/* ---------------------------------------
+ * Streaming of in-progress transactions
+ * ---------------------------------------
+ */
+static bool ReorderBufferCanStartStreaming(ReorderBuffer *rb);
+static bool ReorderBufferTXNIsStreamable(ReorderBufferTXN *txn);
+static void ReorderBufferStreamTXN(ReorderBuffer *rb, ReorderBufferTXN *txn);
+static Snapshot ReorderBufferStreamSnapshot(ReorderBuffer *rb,
+							ReorderBufferTXN *txn);
+
+/* ---------------------------------------
+ * Memory accounting
+ * ---------------------------------------
+ */
+static Size ReorderBufferChangeSize(ReorderBufferChange *change);
+static void ReorderBufferChangeMemoryUpdate(ReorderBuffer *rb,
+								ReorderBufferChange *change, bool addition);
+
 /* ---------------------------------------
  * toast reassembly support
  * ---------------------------------------
@@ -269,6 +288,7 @@ ReorderBufferAllocate(void)
 
 	buffer->outbuf = NULL;
 	buffer->outbufsize = 0;
+	buffer->size = 0;
 
 	buffer->current_restart_decoding_lsn = InvalidXLogRecPtr;
 
@@ -350,6 +370,12 @@ ReorderBufferReturnTXN(ReorderBuffer *rb, ReorderBufferTXN *txn)
 		txn->invalidations = NULL;
 	}
 
+	if (txn->snapshot_now != NULL)
+	{
+		ReorderBufferFreeSnap(rb, txn->snapshot_now);
+		txn->snapshot_now = NULL;
+	}
+
 	pfree(txn);
 }
 
@@ -374,6 +400,9 @@ ReorderBufferGetChange(ReorderBuffer *rb)
 void
 ReorderBufferReturnChange(ReorderBuffer *rb, ReorderBufferChange *change)
 {
+	/* update memory accounting info */
+	ReorderBufferChangeMemoryUpdate(rb, change, false);
+
 	/* free contained data */
 	switch (change->action)
 	{
@@ -575,22 +604,54 @@ ReorderBufferTXNByXid(ReorderBuffer *rb, TransactionId xid, bool create,
 
 /*
  * Queue a change into a transaction so it can be replayed upon commit.
+ *
+ * toast_insert is true for the insertion of a toast chunk, which can't be
+ * streamed without the main tuple following it.
  */
 void
 ReorderBufferQueueChange(ReorderBuffer *rb, TransactionId xid, XLogRecPtr lsn,
-						 ReorderBufferChange *change)
+						 ReorderBufferChange *change, bool toast_insert)
 {
 	ReorderBufferTXN *txn;
 
 	txn = ReorderBufferTXNByXid(rb, xid, true, NULL, lsn, true);
 
+	/*
+	 * Keep track of whether the transaction currently ends in the middle of
+	 * a change that has to be sent as a whole: toast chunks are only useful
+	 * together with the tuple referencing them, and speculative insertions
+	 * have to wait for their confirmation.
+	 */
+	switch (change->action)
+	{
+		case REORDER_BUFFER_CHANGE_INSERT:
+		case REORDER_BUFFER_CHANGE_UPDATE:
+		case REORDER_BUFFER_CHANGE_DELETE:
+			txn->has_partial_change = toast_insert ||
+				!change->data.tp.clear_toast_afterwards;
+			break;
+		case REORDER_BUFFER_CHANGE_INTERNAL_SPEC_INSERT:
+			txn->has_partial_change = true;
+			break;
+		case REORDER_BUFFER_CHANGE_INTERNAL_SPEC_CONFIRM:
+			txn->has_partial_change = false;
+			break;
+		default:
+			break;
+	}
+
 	change->lsn = lsn;
+	change->txn = txn;
 	Assert(InvalidXLogRecPtr != lsn);
 	dlist_push_tail(&txn->changes, &change->node);
 	txn->nentries++;
 	txn->nentries_mem++;
 
-	ReorderBufferCheckSerializeTXN(rb, txn);
+	/* update memory accounting information */
+	ReorderBufferChangeMemoryUpdate(rb, change, true);
+
+	/* check the memory limits and evict something if needed */
+	ReorderBufferCheckMemoryLimit(rb);
 }
 
 /*
@@ -618,7 +679,7 @@ ReorderBufferQueueMessage(ReorderBuffer *rb, TransactionId xid,
 		change->data.msg.message = palloc(message_size);
 		memcpy(change->data.msg.message, message, message_size);
 
-		ReorderBufferQueueChange(rb, xid, lsn, change);
+		ReorderBufferQueueChange(rb, xid, lsn, change, false);
 
 		MemoryContextSwitchTo(oldcontext);
 	}
@@ -801,8 +862,12 @@ ReorderBufferAssignChild(ReorderBuffer *rb, TransactionId xid,
 
 	subtxn->is_known_as_subxact = true;
 	subtxn->toplevel_xid = xid;
+	subtxn->toptxn = txn;
 	Assert(subtxn->nsubtxns == 0);
 
+	/* the changes of the subtransaction now count towards its parent */
+	txn->total_size += subtxn->size;
+
 	/* add to subtransaction list */
 	dlist_push_tail(&txn->subtxns, &subtxn->node);
 	txn->nsubtxns++;
@@ -1267,6 +1332,54 @@ ReorderBufferCleanupTXN(ReorderBuffer *rb, ReorderBufferTXN *txn)
 	ReorderBufferReturnTXN(rb, txn);
 }
 
+/*
+ * Discard the changes of a transaction and its subtransactions that have just
+ * been streamed, both in memory and on disk.  Unlike ReorderBufferCleanupTXN,
+ * the transactions themselves stay around, as the transaction is still in
+ * progress.
+ */
+static void
+ReorderBufferTruncateTXN(ReorderBuffer *rb, ReorderBufferTXN *txn)
+{
+	dlist_mutable_iter iter;
+
+	/* cleanup subtransactions & their changes */
+	dlist_foreach_modify(iter, &txn->subtxns)
+	{
+		ReorderBufferTXN *subtxn;
+
+		subtxn = dlist_container(ReorderBufferTXN, node, iter.cur);
+
+		/* Subtransactions are always associated to the toplevel TXN. */
+		Assert(subtxn->is_known_as_subxact);
+		Assert(subtxn->nsubtxns == 0);
+
+		ReorderBufferTruncateTXN(rb, subtxn);
+	}
+
+	/* cleanup changes in the transaction */
+	dlist_foreach_modify(iter, &txn->changes)
+	{
+		ReorderBufferChange *change;
+
+		change = dlist_container(ReorderBufferChange, node, iter.cur);
+
+		dlist_delete(&change->node);
+		ReorderBufferReturnChange(rb, change);
+	}
+
+	/* remove entries spilled to disk */
+	if (txn->serialized)
+	{
+		ReorderBufferRestoreCleanup(rb, txn);
+		txn->serialized = false;
+	}
+
+	txn->nentries = 0;
+	txn->nentries_mem = 0;
+	txn->streamed = true;
+}
+
 /*
  * Build a hash with a (relfilenode, ctid) -> (cmin, cmax) mapping for use by
  * tqual.c's HeapTupleSatisfiesHistoricMVCC.
@@ -1414,57 +1527,71 @@ ReorderBufferFreeSnap(ReorderBuffer *rb, Snapshot snap)
 }
 
 /*
- * Perform the replay of a transaction and its non-aborted subtransactions.
- *
- * Subtransactions previously have to be processed by
- * ReorderBufferCommitChild(), even if previously assigned to the toplevel
- * transaction with ReorderBufferAssignChild.
- *
- * We currently can only decode a transaction's contents when its commit
- * record is read because that's the only place where we know about cache
- * invalidations. Thus, once a toplevel commit is read, we iterate over the top
- * and subtransactions (using a k-way merge) and replay the changes in lsn
- * order.
+ * Helpers to pass a change to the regular or the streaming variant of the
+ * output plugin callbacks.
  */
-void
-ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
-					XLogRecPtr commit_lsn, XLogRecPtr end_lsn,
-					TimestampTz commit_time,
-					RepOriginId origin_id, XLogRecPtr origin_lsn)
+static inline void
+ReorderBufferApplyChange(ReorderBuffer *rb, ReorderBufferTXN *txn,
+						 Relation relation, ReorderBufferChange *change,
+						 bool streaming)
 {
-	ReorderBufferTXN *txn;
-	volatile Snapshot snapshot_now;
-	volatile CommandId command_id = FirstCommandId;
-	bool		using_subtxn;
-	ReorderBufferIterTXNState *volatile iterstate = NULL;
-
-	txn = ReorderBufferTXNByXid(rb, xid, false, NULL, InvalidXLogRecPtr,
-								false);
+	if (streaming)
+		rb->stream_change(rb, txn, relation, change);
+	else
+		rb->apply_change(rb, txn, relation, change);
+}
 
-	/* unknown transaction, nothing to replay */
-	if (txn == NULL)
-		return;
+static inline void
+ReorderBufferApplyTruncate(ReorderBuffer *rb, ReorderBufferTXN *txn,
+						   int nrelations, Relation *relations,
+						   ReorderBufferChange *change, bool streaming)
+{
+	if (streaming)
+		rb->stream_truncate(rb, txn, nrelations, relations, change);
+	else
+		rb->apply_truncate(rb, txn, nrelations, relations, change);
+}
 
-	txn->final_lsn = commit_lsn;
-	txn->end_lsn = end_lsn;
-	txn->commit_time = commit_time;
-	txn->origin_id = origin_id;
-	txn->origin_lsn = origin_lsn;
+static inline void
+ReorderBufferApplyMessage(ReorderBuffer *rb, ReorderBufferTXN *txn,
+						  ReorderBufferChange *change, bool streaming)
+{
+	if (streaming)
+		rb->stream_message(rb, txn, change->lsn, true,
+						   change->data.msg.prefix,
+						   change->data.msg.message_size,
+						   change->data.msg.message);
+	else
+		rb->message(rb, txn, change->lsn, true,
+					change->data.msg.prefix,
+					change->data.msg.message_size,
+					change->data.msg.message);
+}
 
-	/*
-	 * If this transaction has no snapshot, it didn't make any changes to the
-	 * database, so there's nothing to decode.  Note that
-	 * ReorderBufferCommitChild will have transferred any snapshots from
-	 * subtransactions if there were any.
-	 */
-	if (txn->base_snapshot == NULL)
-	{
-		Assert(txn->ninvalidations == 0);
-		ReorderBufferCleanupTXN(rb, txn);
-		return;
-	}
+/*
+ * Replay the changes of a transaction and its non-aborted subtransactions,
+ * starting with the given snapshot and CommandId.
+ *
+ * If commit_lsn is valid, the transaction has committed, and it's cleaned up
+ * once the changes have been sent.  Otherwise we're streaming changes of a
+ * transaction that is still in progress: the changes sent are discarded, and
+ * the snapshot and CommandId to continue with are remembered in the
+ * transaction.  Streamed changes are sent with the stream_* callbacks, in a
+ * block opened by stream_start and closed by stream_stop.
+ */
+static void
+ReorderBufferProcessTXN(ReorderBuffer *rb, ReorderBufferTXN *txn,
+						XLogRecPtr commit_lsn,
+						volatile Snapshot snapshot_now,
+						volatile CommandId command_id,
+						bool streaming)
+{
+	bool		using_subtxn;
+	bool		in_progress = (commit_lsn == InvalidXLogRecPtr);
+	volatile bool stream_started = false;
+	ReorderBufferIterTXNState *volatile iterstate = NULL;
 
-	snapshot_now = txn->base_snapshot;
+	Assert(streaming || !in_progress);
 
 	/* build data to be able to lookup the CommandIds of catalog tuples */
 	ReorderBufferBuildTupleCidHash(rb, txn);
@@ -1490,11 +1617,12 @@ ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
 		ReorderBufferChange *specinsert = NULL;
 
 		if (using_subtxn)
-			BeginInternalSubTransaction("replay");
+			BeginInternalSubTransaction(streaming ? "stream" : "replay");
 		else
 			StartTransactionCommand();
 
-		rb->begin(rb, txn);
+		if (!streaming)
+			rb->begin(rb, txn);
 
 		iterstate = ReorderBufferIterTXNInit(rb, txn);
 		while ((change = ReorderBufferIterTXNNext(rb, iterstate)) != NULL)
@@ -1502,6 +1630,13 @@ ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
 			Relation	relation = NULL;
 			Oid			reloid;
 
+			/* open the streamed block only once there's something to send */
+			if (streaming && !stream_started)
+			{
+				rb->stream_start(rb, txn);
+				stream_started = true;
+			}
+
 			switch (change->action)
 			{
 				case REORDER_BUFFER_CHANGE_INTERNAL_SPEC_CONFIRM:
@@ -1578,7 +1713,8 @@ ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
 					if (!IsToastRelation(relation))
 					{
 						ReorderBufferToastReplace(rb, txn, relation, change);
-						rb->apply_change(rb, txn, relation, change);
+						ReorderBufferApplyChange(rb, txn, relation, change,
+												 streaming);
 
 						/*
 						 * Only clear reassembled toast chunks if we're sure
@@ -1676,7 +1812,9 @@ ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
 							relations[nrelations++] = relation;
 						}
 
-						rb->apply_truncate(rb, txn, nrelations, relations, change);
+						ReorderBufferApplyTruncate(rb, txn, nrelations,
+												   relations, change,
+												   streaming);
 
 						for (i = 0; i < nrelations; i++)
 							RelationClose(relations[i]);
@@ -1685,10 +1823,7 @@ ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
 					}
 
 				case REORDER_BUFFER_CHANGE_MESSAGE:
-					rb->message(rb, txn, change->lsn, true,
-								change->data.msg.prefix,
-								change->data.msg.message_size,
-								change->data.msg.message);
+					ReorderBufferApplyMessage(rb, txn, change, streaming);
 					break;
 
 				case REORDER_BUFFER_CHANGE_INTERNAL_SNAPSHOT:
@@ -1774,8 +1909,17 @@ ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
 		ReorderBufferIterTXNFinish(rb, iterstate);
 		iterstate = NULL;
 
-		/* call commit callback */
-		rb->commit(rb, txn, commit_lsn);
+		/* close the streamed block, and report a commit */
+		if (streaming)
+		{
+			if (stream_started)
+				rb->stream_stop(rb, txn);
+
+			if (!in_progress)
+				rb->stream_commit(rb, txn, commit_lsn);
+		}
+		else
+			rb->commit(rb, txn, commit_lsn);
 
 		/* this is just a sanity check against bad output plugin behaviour */
 		if (GetCurrentTransactionIdIfAny() != InvalidTransactionId)
@@ -1799,11 +1943,31 @@ ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
 		if (using_subtxn)
 			RollbackAndReleaseCurrentSubTransaction();
 
-		if (snapshot_now->copied)
-			ReorderBufferFreeSnap(rb, snapshot_now);
+		if (in_progress)
+		{
+			/*
+			 * Remember where to continue from when streaming the next block
+			 * of changes.  The snapshot may belong to one of the changes
+			 * about to be freed, so keep a copy of it.
+			 */
+			txn->snapshot_now = ReorderBufferCopySnap(rb, snapshot_now, txn,
+													  command_id);
+			txn->command_id = command_id;
 
-		/* remove potential on-disk data, and deallocate */
-		ReorderBufferCleanupTXN(rb, txn);
+			if (snapshot_now->copied)
+				ReorderBufferFreeSnap(rb, snapshot_now);
+
+			/* discard the changes we just sent */
+			ReorderBufferTruncateTXN(rb, txn);
+		}
+		else
+		{
+			if (snapshot_now->copied)
+				ReorderBufferFreeSnap(rb, snapshot_now);
+
+			/* remove potential on-disk data, and deallocate */
+			ReorderBufferCleanupTXN(rb, txn);
+		}
 	}
 	PG_CATCH();
 	{
@@ -1836,6 +2000,182 @@ ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
 	PG_END_TRY();
 }
 
+/*
+ * Perform the replay of a transaction and its non-aborted subtransactions.
+ *
+ * Subtransactions previously have to be processed by
+ * ReorderBufferCommitChild(), even if previously assigned to the toplevel
+ * transaction with ReorderBufferAssignChild.
+ *
+ * We currently can only decode a transaction's contents when its commit
+ * record is read because that's the only place where we know about cache
+ * invalidations. Thus, once a toplevel commit is read, we iterate over the top
+ * and subtransactions (using a k-way merge) and replay the changes in lsn
+ * order.
+ *
+ * If the transaction has already been streamed in part, the remaining
+ * changes are streamed as well, followed by the stream_commit callback.
+ */
+void
+ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
+					XLogRecPtr commit_lsn, XLogRecPtr end_lsn,
+					TimestampTz commit_time,
+					RepOriginId origin_id, XLogRecPtr origin_lsn)
+{
+	ReorderBufferTXN *txn;
+	Snapshot	snapshot_now;
+	CommandId	command_id = FirstCommandId;
+
+	txn = ReorderBufferTXNByXid(rb, xid, false, NULL, InvalidXLogRecPtr,
+								false);
+
+	/* unknown transaction, nothing to replay */
+	if (txn == NULL)
+		return;
+
+	txn->final_lsn = commit_lsn;
+	txn->end_lsn = end_lsn;
+	txn->commit_time = commit_time;
+	txn->origin_id = origin_id;
+	txn->origin_lsn = origin_lsn;
+
+	/*
+	 * If this transaction has no snapshot, it didn't make any changes to the
+	 * database, so there's nothing to decode.  Note that
+	 * ReorderBufferCommitChild will have transferred any snapshots from
+	 * subtransactions if there were any.
+	 */
+	if (txn->base_snapshot == NULL)
+	{
+		Assert(txn->ninvalidations == 0);
+		ReorderBufferCleanupTXN(rb, txn);
+		return;
+	}
+
+	if (txn->streamed)
+	{
+		command_id = txn->command_id;
+		snapshot_now = ReorderBufferStreamSnapshot(rb, txn);
+	}
+	else
+		snapshot_now = txn->base_snapshot;
+
+	ReorderBufferProcessTXN(rb, txn, commit_lsn, snapshot_now, command_id,
+							txn->streamed);
+}
+
+/*
+ * Can the changes of in-progress transactions be streamed now?
+ *
+ * This requires the output plugin to support streaming, and the snapshot
+ * builder to be consistent: before that, transactions may be missing their
+ * earlier changes.  Neither do we stream anything before the position the
+ * client asked to start at, as that would be output it has already seen.
+ */
+static bool
+ReorderBufferCanStartStreaming(ReorderBuffer *rb)
+{
+	LogicalDecodingContext *ctx = rb->private_data;
+	SnapBuild  *builder = ctx->snapshot_builder;
+
+	if (!ctx->streaming)
+		return false;
+
+	if (SnapBuildCurrentState(builder) < SNAPBUILD_CONSISTENT)
+		return false;
+
+	if (SnapBuildXactNeedsSkip(builder, ctx->reader->EndRecPtr))
+		return false;
+
+	return true;
+}
+
+/*
+ * Can the top-level transaction be streamed in its current state?
+ *
+ * Transactions that modified the catalog are not streamed: decoding their
+ * changes before commit would need the cache invalidations only known at
+ * that point.  Nor do we stream in the middle of a change that has to be
+ * sent as a whole (see ReorderBufferQueueChange).
+ */
+static bool
+ReorderBufferTXNIsStreamable(ReorderBufferTXN *txn)
+{
+	dlist_iter	iter;
+
+	Assert(txn->toptxn == NULL);
+
+	/* no changes to decode yet */
+	if (txn->base_snapshot == NULL)
+		return false;
+
+	if (txn->has_catalog_changes || txn->has_partial_change)
+		return false;
+
+	dlist_foreach(iter, &txn->subtxns)
+	{
+		ReorderBufferTXN *subtxn;
+
+		subtxn = dlist_container(ReorderBufferTXN, node, iter.cur);
+
+		if (subtxn->has_catalog_changes || subtxn->has_partial_change)
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Return the snapshot to continue decoding a streamed transaction with.  It's
+ * rebuilt so that it also covers subtransactions assigned since the previous
+ * block of changes was streamed.
+ */
+static Snapshot
+ReorderBufferStreamSnapshot(ReorderBuffer *rb, ReorderBufferTXN *txn)
+{
+	Snapshot	snap;
+
+	Assert(txn->snapshot_now != NULL);
+
+	snap = ReorderBufferCopySnap(rb, txn->snapshot_now, txn, txn->command_id);
+	ReorderBufferFreeSnap(rb, txn->snapshot_now);
+	txn->snapshot_now = NULL;
+
+	return snap;
+}
+
+/*
+ * Send the changes of a large in-progress transaction downstream, so they
+ * don't have to be kept in memory or spilled to disk until it commits.
+ *
+ * The output plugin gets the changes with the stream_* callbacks, and learns
+ * about the transaction's fate from stream_commit or stream_abort later.
+ */
+static void
+ReorderBufferStreamTXN(ReorderBuffer *rb, ReorderBufferTXN *txn)
+{
+	Snapshot	snapshot_now;
+	CommandId	command_id = FirstCommandId;
+
+	Assert(ReorderBufferTXNIsStreamable(txn));
+
+	if (txn->streamed)
+	{
+		command_id = txn->command_id;
+		snapshot_now = ReorderBufferStreamSnapshot(rb, txn);
+	}
+	else
+		snapshot_now = txn->base_snapshot;
+
+	elog(DEBUG2, "streaming " UINT64_FORMAT " changes in XID %u",
+		 txn->nentries, txn->xid);
+
+	ReorderBufferProcessTXN(rb, txn, InvalidXLogRecPtr, snapshot_now,
+							command_id, true);
+
+	Assert(dlist_is_empty(&txn->changes));
+}
+
 /*
  * Abort a transaction that possibly has previous changes. Needs to be first
  * called for subtransactions and then for the toplevel xid.
@@ -1860,6 +2200,10 @@ ReorderBufferAbort(ReorderBuffer *rb, TransactionId xid, XLogRecPtr lsn)
 	if (txn == NULL)
 		return;
 
+	/* tell the downstream to discard what it got of this transaction */
+	if (txn->streamed)
+		rb->stream_abort(rb, txn, lsn);
+
 	/* cosmetic... */
 	txn->final_lsn = lsn;
 
@@ -1911,6 +2255,9 @@ ReorderBufferAbortOld(ReorderBuffer *rb, TransactionId oldestRunningXid)
 
 			elog(DEBUG2, "aborting old transaction %u", txn->xid);
 
+			if (txn->streamed)
+				rb->stream_abort(rb, txn, txn->final_lsn);
+
 			/* remove potential on-disk data, and deallocate this tx */
 			ReorderBufferCleanupTXN(rb, txn);
 		}
@@ -1944,6 +2291,13 @@ ReorderBufferForget(ReorderBuffer *rb, TransactionId xid, XLogRecPtr lsn)
 	if (txn == NULL)
 		return;
 
+	/*
+	 * A streamed transaction has been sent in part already, so the downstream
+	 * has to be told not to apply it.
+	 */
+	if (txn->streamed)
+		rb->stream_abort(rb, txn, lsn);
+
 	/* cosmetic... */
 	txn->final_lsn = lsn;
 
@@ -2026,7 +2380,7 @@ ReorderBufferAddSnapshot(ReorderBuffer *rb, TransactionId xid,
 	change->data.snapshot = snap;
 	change->action = REORDER_BUFFER_CHANGE_INTERNAL_SNAPSHOT;
 
-	ReorderBufferQueueChange(rb, xid, lsn, change);
+	ReorderBufferQueueChange(rb, xid, lsn, change, false);
 }
 
 /*
@@ -2075,7 +2429,7 @@ ReorderBufferAddNewCommandId(ReorderBuffer *rb, TransactionId xid,
 	change->data.command_id = cid;
 	change->action = REORDER_BUFFER_CHANGE_INTERNAL_COMMAND_ID;
 
-	ReorderBufferQueueChange(rb, xid, lsn, change);
+	ReorderBufferQueueChange(rb, xid, lsn, change, false);
 }
 
 
@@ -2226,19 +2580,172 @@ ReorderBufferSerializeReserve(ReorderBuffer *rb, Size sz)
 }
 
 /*
- * Check whether the transaction tx should spill its data to disk.
+ * Compute the amount of memory used by a change, for the accounting against
+ * logical_decoding_work_mem.
+ */
+static Size
+ReorderBufferChangeSize(ReorderBufferChange *change)
+{
+	Size		sz = sizeof(ReorderBufferChange);
+
+	switch (change->action)
+	{
+			/* fall through these, they're all similar enough */
+		case REORDER_BUFFER_CHANGE_INSERT:
+		case REORDER_BUFFER_CHANGE_UPDATE:
+		case REORDER_BUFFER_CHANGE_DELETE:
+		case REORDER_BUFFER_CHANGE_INTERNAL_SPEC_INSERT:
+			if (change->data.tp.oldtuple)
+				sz += sizeof(ReorderBufferTupleBuf) +
+					change->data.tp.oldtuple->tuple.t_len;
+			if (change->data.tp.newtuple)
+				sz += sizeof(ReorderBufferTupleBuf) +
+					change->data.tp.newtuple->tuple.t_len;
+			break;
+		case REORDER_BUFFER_CHANGE_MESSAGE:
+			sz += strlen(change->data.msg.prefix) + 1 +
+				change->data.msg.message_size;
+			break;
+		case REORDER_BUFFER_CHANGE_INTERNAL_SNAPSHOT:
+			sz += sizeof(SnapshotData) +
+				sizeof(TransactionId) * change->data.snapshot->xcnt +
+				sizeof(TransactionId) * change->data.snapshot->subxcnt;
+			break;
+		case REORDER_BUFFER_CHANGE_TRUNCATE:
+			sz += sizeof(Oid) * change->data.truncate.nrelids;
+			break;
+		case REORDER_BUFFER_CHANGE_INTERNAL_SPEC_CONFIRM:
+		case REORDER_BUFFER_CHANGE_INTERNAL_COMMAND_ID:
+		case REORDER_BUFFER_CHANGE_INTERNAL_TUPLECID:
+			/* ReorderBufferChange contains everything important */
+			break;
+	}
+
+	return sz;
+}
+
+/*
+ * Add or subtract the size of a change to/from the memory accounted to its
+ * transaction, the top-level transaction and the whole reorder buffer.
+ *
+ * Only changes queued in a transaction are accounted for; tuplecids are
+ * kept separately and are not counted.
  */
 static void
-ReorderBufferCheckSerializeTXN(ReorderBuffer *rb, ReorderBufferTXN *txn)
+ReorderBufferChangeMemoryUpdate(ReorderBuffer *rb,
+								ReorderBufferChange *change, bool addition)
 {
-	/*
-	 * TODO: improve accounting so we cheaply can take subtransactions into
-	 * account here.
-	 */
-	if (txn->nentries_mem >= max_changes_in_memory)
+	Size		sz;
+	ReorderBufferTXN *txn = change->txn;
+	ReorderBufferTXN *toptxn;
+
+	if (txn == NULL)
+		return;
+
+	sz = ReorderBufferChangeSize(change);
+	toptxn = txn->toptxn != NULL ? txn->toptxn : txn;
+
+	if (addition)
+	{
+		txn->size += sz;
+		toptxn->total_size += sz;
+		rb->size += sz;
+	}
+	else
+	{
+		Assert(txn->size >= sz && toptxn->total_size >= sz && rb->size >= sz);
+		txn->size -= sz;
+		toptxn->total_size -= sz;
+		rb->size -= sz;
+	}
+}
+
+/*
+ * Find the largest transaction (toplevel or subxact), to spill to disk.
+ *
+ * This walks all the transactions, but is only done once the memory limit
+ * has been reached, and spilling a transaction frees a good deal of memory.
+ */
+static ReorderBufferTXN *
+ReorderBufferLargestTXN(ReorderBuffer *rb)
+{
+	HASH_SEQ_STATUS hash_seq;
+	ReorderBufferTXNByIdEnt *ent;
+	ReorderBufferTXN *largest = NULL;
+
+	hash_seq_init(&hash_seq, rb->by_txn);
+	while ((ent = hash_seq_search(&hash_seq)) != NULL)
+	{
+		ReorderBufferTXN *txn = ent->txn;
+
+		if (largest == NULL || txn->size > largest->size)
+			largest = txn;
+	}
+
+	Assert(largest != NULL);
+	Assert(largest->size > 0 && largest->size <= rb->size);
+
+	return largest;
+}
+
+/*
+ * Find the largest top-level transaction, counting the changes of its
+ * subtransactions, or NULL if there are none with changes in memory.
+ */
+static ReorderBufferTXN *
+ReorderBufferLargestTopTXN(ReorderBuffer *rb)
+{
+	dlist_iter	iter;
+	ReorderBufferTXN *largest = NULL;
+
+	dlist_foreach(iter, &rb->toplevel_by_lsn)
+	{
+		ReorderBufferTXN *txn;
+
+		txn = dlist_container(ReorderBufferTXN, node, iter.cur);
+
+		if (txn->total_size > 0 &&
+			(largest == NULL || txn->total_size > largest->total_size))
+			largest = txn;
+	}
+
+	return largest;
+}
+
+/*
+ * Check whether the memory used by the changes kept in memory exceeds
+ * logical_decoding_work_mem, and if so, evict transactions until it
+ * doesn't.
+ *
+ * If the output plugin supports streaming, the largest top-level
+ * transaction is streamed, if that's possible.  Otherwise, the largest
+ * transaction is spilled to disk.
+ */
+static void
+ReorderBufferCheckMemoryLimit(ReorderBuffer *rb)
+{
+	ReorderBufferTXN *txn;
+
+	while (rb->size >= logical_decoding_work_mem * 1024L)
 	{
-		ReorderBufferSerializeTXN(rb, txn);
-		Assert(txn->nentries_mem == 0);
+		if (ReorderBufferCanStartStreaming(rb) &&
+			(txn = ReorderBufferLargestTopTXN(rb)) != NULL &&
+			ReorderBufferTXNIsStreamable(txn))
+		{
+			ReorderBufferStreamTXN(rb, txn);
+
+			/* all the changes must have been sent and freed */
+			Assert(txn->total_size == 0);
+		}
+		else
+		{
+			txn = ReorderBufferLargestTXN(rb);
+			ReorderBufferSerializeTXN(rb, txn);
+
+			/* all the changes must be on disk now */
+			Assert(txn->size == 0);
+			Assert(txn->nentries_mem == 0);
+		}
 	}
 }
 
@@ -2305,6 +2812,14 @@ ReorderBufferSerializeTXN(ReorderBuffer *rb, ReorderBufferTXN *txn)
 		}
 
 		ReorderBufferSerializeChange(rb, txn, fd, change);
+
+		/*
+		 * Remember the last spilled change, so that cleanup and restore know
+		 * which files to look at even if the transaction is still running.
+		 */
+		if (change->lsn > txn->final_lsn)
+			txn->final_lsn = change->lsn;
+
 		dlist_delete(&change->node);
 		ReorderBufferReturnChange(rb, change);
 
@@ -2778,8 +3293,12 @@ ReorderBufferRestoreChange(ReorderBuffer *rb, ReorderBufferTXN *txn,
 			break;
 	}
 
+	change->txn = txn;
 	dlist_push_tail(&txn->changes, &change->node);
 	txn->nentries_mem++;
+
+	/* update memory accounting information */
+	ReorderBufferChangeMemoryUpdate(rb, change, true);
 }
 
 /*
@@ -3145,9 +3664,14 @@ ReorderBufferToastReplace(ReorderBuffer *rb, ReorderBufferTXN *txn,
 	Assert(newtup->tuple.t_len <= MaxHeapTupleSize);
 	Assert(ReorderBufferTupleBufData(newtup) == newtup->tuple.t_data);
 
+	/* the size of the tuple changes, so keep the accounting in sync */
+	ReorderBufferChangeMemoryUpdate(rb, change, false);
+
 	memcpy(newtup->tuple.t_data, tmphtup->t_data, tmphtup->t_len);
 	newtup->tuple.t_len = tmphtup->t_len;
 
+	ReorderBufferChangeMemoryUpdate(rb, change, true);
+
 	/*
 	 * free resources we won't further need, more persistent stuff will be
 	 * free'd in ReorderBufferToastReset().
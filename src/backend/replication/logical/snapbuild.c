@@ -619,6 +619,7 @@ SnapBuildInitialSnapshot(SnapBuild *builder)
 
 	snap->xcnt = newxcnt;
 	snap->xip = newxip;
+	snap->xipSorted = false;
 
 	return snap;
 }
@@ -95,6 +95,8 @@
 
 #include "commands/copy.h"
 
+#include "nodes/makefuncs.h"
+
 #include "parser/parse_relation.h"
 
 #include "replication/logicallauncher.h"
@@ -110,6 +112,7 @@
 #include "utils/memutils.h"
 
 static bool table_states_valid = false;
+static List *table_states = NIL;	/* tables not yet in READY state */
 
 StringInfo	copybuf = NULL;
 
@@ -330,7 +333,6 @@ process_syncing_tables_for_apply(XLogRecPtr current_lsn)
 		Oid			relid;
 		TimestampTz last_start_time;
 	};
-	static List *table_states = NIL;
 	static HTAB *last_start_times = NULL;
 	ListCell   *lc;
 	bool		started_tx = false;
@@ -513,7 +515,8 @@ process_syncing_tables_for_apply(XLogRecPtr current_lsn)
 												 MySubscription->oid,
 												 MySubscription->name,
 												 MyLogicalRepWorker->userid,
-												 rstate->relid);
+												 rstate->relid,
+												 DSM_HANDLE_INVALID, -1);
 						hentry->last_start_time = now;
 					}
 				}
@@ -528,6 +531,18 @@ process_syncing_tables_for_apply(XLogRecPtr current_lsn)
 	}
 }
 
+/*
+ * Are all the tables of the subscription known to be ready?
+ *
+ * This only looks at the state fetched by the last call of
+ * process_syncing_tables(), and answers false if that became stale.
+ */
+bool
+AllTablesyncsReady(void)
+{
+	return table_states_valid && table_states == NIL;
+}
+
 /*
  * Process possible state change(s) of tables that are being synchronized.
  */
@@ -636,19 +651,27 @@ copy_read_data(void *outbuf, int minread, int maxread)
 
 /*
  * Get information about remote relation in similar fashion the RELATION
- * message provides during replication.
+ * message provides during replication: only the columns that the
+ * subscribed publications publish are returned.
+ *
+ * *qual is set to the list of the publications' row filters, as SQL text,
+ * or NIL if any of the publications publishes all rows.
  */
 static void
 fetch_remote_table_info(char *nspname, char *relname,
-						LogicalRepRelation *lrel)
+						LogicalRepRelation *lrel, List **qual)
 {
 	WalRcvExecResult *res;
 	StringInfoData cmd;
+	StringInfoData pubnames;
 	TupleTableSlot *slot;
 	Oid			tableRow[2] = {OIDOID, CHAROID};
 	Oid			attrRow[4] = {TEXTOID, OIDOID, INT4OID, BOOLOID};
+	Oid			qualRow[1] = {TEXTOID};
 	bool		isnull;
 	int			natt;
+	bool		have_filters;
+	ListCell   *lc;
 
 	lrel->nspname = nspname;
 	lrel->relname = relname;
@@ -685,6 +708,18 @@ fetch_remote_table_info(char *nspname, char *relname,
 	ExecDropSingleTupleTableSlot(slot);
 	walrcv_clear_result(res);
 
+	/* Publication column lists and row filters are new in version 12. */
+	have_filters = walrcv_server_version(wrconn) >= 120000;
+
+	initStringInfo(&pubnames);
+	foreach(lc, MySubscription->publications)
+	{
+		if (lc != list_head(MySubscription->publications))
+			appendStringInfoString(&pubnames, ", ");
+		appendStringInfoString(&pubnames,
+							   quote_literal_cstr(strVal(lfirst(lc))));
+	}
+
 	/* Now fetch columns. */
 	resetStringInfo(&cmd);
 	appendStringInfo(&cmd,
@@ -697,9 +732,21 @@ fetch_remote_table_info(char *nspname, char *relname,
 					 "       ON (i.indexrelid = pg_get_replica_identity_index(%u))"
 					 " WHERE a.attnum > 0::pg_catalog.int2"
 					 "   AND NOT a.attisdropped"
-					 "   AND a.attrelid = %u"
-					 " ORDER BY a.attnum",
+					 "   AND a.attrelid = %u",
 					 lrel->remoteid, lrel->remoteid);
+	if (have_filters)
+		appendStringInfo(&cmd,
+						 "   AND (EXISTS (SELECT 1 FROM pg_catalog.pg_publication p"
+						 "                 WHERE p.pubname IN (%s) AND p.puballtables)"
+						 "        OR EXISTS (SELECT 1 FROM pg_catalog.pg_publication_rel pr"
+						 "                    JOIN pg_catalog.pg_publication p"
+						 "                         ON (p.oid = pr.prpubid)"
+						 "                    WHERE p.pubname IN (%s)"
+						 "                      AND pr.prrelid = a.attrelid"
+						 "                      AND (pr.prattrs IS NULL"
+						 "                           OR a.attnum = ANY(pr.prattrs))))",
+						 pubnames.data, pubnames.data);
+	appendStringInfoString(&cmd, " ORDER BY a.attnum");
 	res = walrcv_exec(wrconn, cmd.data, 4, attrRow);
 
 	if (res->status != WALRCV_OK_TUPLES)
@@ -736,6 +783,56 @@ fetch_remote_table_info(char *nspname, char *relname,
 	lrel->natts = natt;
 
 	walrcv_clear_result(res);
+
+	/*
+	 * Finally fetch the row filters.  A NULL filter means that one of the
+	 * publications publishes all rows, so nothing can be filtered out.
+	 */
+	*qual = NIL;
+	if (have_filters)
+	{
+		bool		all_rows = false;
+
+		resetStringInfo(&cmd);
+		appendStringInfo(&cmd,
+						 "SELECT DISTINCT pg_catalog.pg_get_expr(pr.prqual, pr.prrelid)"
+						 "  FROM pg_catalog.pg_publication p"
+						 "  LEFT JOIN pg_catalog.pg_publication_rel pr"
+						 "       ON (pr.prpubid = p.oid AND pr.prrelid = %u)"
+						 " WHERE p.pubname IN (%s)"
+						 "   AND (p.puballtables OR pr.prrelid IS NOT NULL)",
+						 lrel->remoteid, pubnames.data);
+		res = walrcv_exec(wrconn, cmd.data, 1, qualRow);
+
+		if (res->status != WALRCV_OK_TUPLES)
+			ereport(ERROR,
+					(errmsg("could not fetch row filters for table \"%s.%s\" from publisher: %s",
+							nspname, relname, res->err)));
+
+		slot = MakeSingleTupleTableSlot(res->tupledesc, &TTSOpsMinimalTuple);
+		while (tuplestore_gettupleslot(res->tuplestore, true, false, slot))
+		{
+			Datum		rf = slot_getattr(slot, 1, &isnull);
+
+			if (isnull)
+				all_rows = true;
+			else
+				*qual = lappend(*qual, TextDatumGetCString(rf));
+
+			ExecClearTuple(slot);
+		}
+		ExecDropSingleTupleTableSlot(slot);
+
+		if (all_rows)
+		{
+			list_free_deep(*qual);
+			*qual = NIL;
+		}
+
+		walrcv_clear_result(res);
+	}
+
+	pfree(pubnames.data);
 	pfree(cmd.data);
 }
 
@@ -753,11 +850,14 @@ copy_table(Relation rel)
 	StringInfoData cmd;
 	CopyState	cstate;
 	List	   *attnamelist;
+	List	   *options = NIL;
+	List	   *qual;
 	ParseState *pstate;
+	int			i;
 
 	/* Get the publisher relation info. */
 	fetch_remote_table_info(get_namespace_name(RelationGetNamespace(rel)),
-							RelationGetRelationName(rel), &lrel);
+							RelationGetRelationName(rel), &lrel, &qual);
 
 	/* Put the relation into relmap. */
 	logicalrep_relmap_update(&lrel);
@@ -766,10 +866,51 @@ copy_table(Relation rel)
 	relmapentry = logicalrep_rel_open(lrel.remoteid, NoLock);
 	Assert(rel == relmapentry->localrel);
 
-	/* Start copy on the publisher. */
+	/*
+	 * Start copy on the publisher.  Only the published columns are copied,
+	 * and with row filters only the rows that pass one of them.
+	 */
 	initStringInfo(&cmd);
-	appendStringInfo(&cmd, "COPY %s TO STDOUT",
-					 quote_qualified_identifier(lrel.nspname, lrel.relname));
+	if (qual == NIL)
+	{
+		appendStringInfo(&cmd, "COPY %s",
+						 quote_qualified_identifier(lrel.nspname, lrel.relname));
+		for (i = 0; i < lrel.natts; i++)
+			appendStringInfo(&cmd, "%s%s", i > 0 ? ", " : " (",
+							 quote_identifier(lrel.attnames[i]));
+		if (lrel.natts > 0)
+			appendStringInfoChar(&cmd, ')');
+		appendStringInfoString(&cmd, " TO STDOUT");
+	}
+	else
+	{
+		ListCell   *lc;
+
+		appendStringInfoString(&cmd, "COPY (SELECT ");
+		for (i = 0; i < lrel.natts; i++)
+			appendStringInfo(&cmd, "%s%s", i > 0 ? ", " : "",
+							 quote_identifier(lrel.attnames[i]));
+		appendStringInfo(&cmd, " FROM ONLY %s WHERE ",
+						 quote_qualified_identifier(lrel.nspname, lrel.relname));
+		foreach(lc, qual)
+		{
+			if (lc != list_head(qual))
+				appendStringInfoString(&cmd, " OR ");
+			appendStringInfo(&cmd, "(%s)", (char *) lfirst(lc));
+		}
+		appendStringInfoString(&cmd, ") TO STDOUT");
+	}
+
+	/*
+	 * With the binary option, copy in binary format too.  The column order
+	 * is the same on both sides, see make_copy_attnamelist().
+	 */
+	if (MySubscription->binary)
+	{
+		appendStringInfoString(&cmd, " WITH (FORMAT binary)");
+		options = list_make1(makeDefElem("format",
+										 (Node *) makeString("binary"), -1));
+	}
 	res = walrcv_exec(wrconn, cmd.data, 0, NULL);
 	pfree(cmd.data);
 	if (res->status != WALRCV_OK_COPY_OUT)
@@ -785,7 +926,7 @@ copy_table(Relation rel)
 								  NULL, false, false);
 
 	attnamelist = make_copy_attnamelist(relmapentry);
-	cstate = BeginCopyFrom(pstate, rel, NULL, false, copy_read_data, attnamelist, NIL);
+	cstate = BeginCopyFrom(pstate, rel, NULL, false, copy_read_data, attnamelist, options);
 
 	/* Do the copy */
 	(void) CopyFrom(cstate);
@@ -18,6 +18,15 @@
  *	  This module includes server facing code and shares libpqwalreceiver
  *	  module with walreceiver for providing the libpq specific functionality.
  *
+ *	  If the subscription has streaming enabled, the publisher may send the
+ *	  changes of a large transaction before it commits, in blocks delimited
+ *	  by STREAM START and STREAM STOP messages.  We can't apply them right
+ *	  away, since the transaction may still abort, so they are spooled to a
+ *	  temporary file per remote transaction, and replayed on STREAM COMMIT.
+ *	  The position of the first change of each subtransaction is remembered,
+ *	  so that a subtransaction abort can discard its changes by rewinding the
+ *	  end of the file.
+ *
  *-------------------------------------------------------------------------
  */
 
@@ -69,6 +78,7 @@
 
 #include "rewrite/rewriteHandler.h"
 
+#include "storage/buffile.h"
 #include "storage/bufmgr.h"
 #include "storage/ipc.h"
 #include "storage/lmgr.h"
@@ -82,6 +92,7 @@
 #include "utils/datum.h"
 #include "utils/fmgroids.h"
 #include "utils/guc.h"
+#include "utils/hsearch.h"
 #include "utils/inval.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
@@ -108,7 +119,38 @@ typedef struct SlotErrCallbackArg
 	int			remote_attnum;
 } SlotErrCallbackArg;
 
-static MemoryContext ApplyMessageContext = NULL;
+/*
+ * A subtransaction of a streamed transaction, and the position of its first
+ * change in the spool file.
+ */
+typedef struct StreamSubXact
+{
+	TransactionId xid;
+	int			fileno;
+	off_t		offset;
+} StreamSubXact;
+
+/*
+ * A remote transaction streamed to us while still in progress, and the file
+ * its changes are spooled to until it commits or aborts.  The end of the
+ * valid data in the file is tracked separately from the file size, as an
+ * aborted subtransaction may leave garbage past it.
+ */
+typedef struct StreamXactEntry
+{
+	TransactionId xid;			/* hash key, must be first */
+	BufFile    *file;
+	int			end_fileno;
+	off_t		end_offset;
+	List	   *subxacts;		/* StreamSubXact, in order of first change */
+} StreamXactEntry;
+
+static HTAB *StreamXactHash = NULL;
+
+/* transaction whose block of changes we're currently receiving, if any */
+static StreamXactEntry *stream_xact = NULL;
+
+MemoryContext ApplyMessageContext = NULL;
 MemoryContext ApplyContext = NULL;
 
 WalReceiverConn *wrconn = NULL;
@@ -121,7 +163,7 @@ static XLogRecPtr remote_final_lsn = InvalidXLogRecPtr;
 
 static void send_feedback(XLogRecPtr recvpos, bool force, bool requestReply);
 
-static void store_flush_position(XLogRecPtr remote_lsn);
+static void store_flush_position(XLogRecPtr remote_lsn, XLogRecPtr local_lsn);
 
 static void maybe_reread_subscription(void);
 
@@ -315,13 +357,59 @@ slot_store_error_callback(void *arg)
 }
 
 /*
- * Store data in C string form into slot.
+ * Convert a remote column value, received in text or binary format, to a
+ * Datum of the local column type.
+ */
+static Datum
+slot_input_column(Form_pg_attribute att, LogicalRepTupleData *tupleData,
+				  int remoteattnum)
+{
+	char	   *value = tupleData->values[remoteattnum];
+	Oid			typioparam;
+	Datum		result;
+
+	if (tupleData->binary[remoteattnum])
+	{
+		Oid			typreceive;
+		StringInfoData buf;
+
+		getTypeBinaryInputInfo(att->atttypid, &typreceive, &typioparam);
+
+		buf.data = value;
+		buf.len = tupleData->lengths[remoteattnum];
+		buf.maxlen = buf.len + 1;
+		buf.cursor = 0;
+
+		result = OidReceiveFunctionCall(typreceive, &buf, typioparam,
+										att->atttypmod);
+
+		/* Trouble if it didn't eat the whole buffer */
+		if (buf.cursor != buf.len)
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+					 errmsg("incorrect binary data format in logical replication column %d",
+							remoteattnum + 1)));
+	}
+	else
+	{
+		Oid			typinput;
+
+		getTypeInputInfo(att->atttypid, &typinput, &typioparam);
+		result = OidInputFunctionCall(typinput, value, typioparam,
+									  att->atttypmod);
+	}
+
+	return result;
+}
+
+/*
+ * Store data received from the publisher into slot.
  * This is similar to BuildTupleFromCStrings but TupleTableSlot fits our
  * use better.
  */
 static void
-slot_store_cstrings(TupleTableSlot *slot, LogicalRepRelMapEntry *rel,
-					char **values)
+slot_store_data(TupleTableSlot *slot, LogicalRepRelMapEntry *rel,
+				LogicalRepTupleData *tupleData)
 {
 	int			natts = slot->tts_tupleDescriptor->natts;
 	int			i;
@@ -339,25 +427,20 @@ slot_store_cstrings(TupleTableSlot *slot, LogicalRepRelMapEntry *rel,
 	errcallback.previous = error_context_stack;
 	error_context_stack = &errcallback;
 
-	/* Call the "in" function for each non-dropped attribute */
+	/* Call the "in" or "recv" function for each non-dropped attribute */
 	for (i = 0; i < natts; i++)
 	{
 		Form_pg_attribute att = TupleDescAttr(slot->tts_tupleDescriptor, i);
 		int			remoteattnum = rel->attrmap[i];
 
 		if (!att->attisdropped && remoteattnum >= 0 &&
-			values[remoteattnum] != NULL)
+			tupleData->values[remoteattnum] != NULL)
 		{
-			Oid			typinput;
-			Oid			typioparam;
-
 			errarg.local_attnum = i;
 			errarg.remote_attnum = remoteattnum;
 
-			getTypeInputInfo(att->atttypid, &typinput, &typioparam);
-			slot->tts_values[i] =
-				OidInputFunctionCall(typinput, values[remoteattnum],
-									 typioparam, att->atttypmod);
+			slot->tts_values[i] = slot_input_column(att, tupleData,
+													remoteattnum);
 			slot->tts_isnull[i] = false;
 
 			errarg.local_attnum = -1;
@@ -382,14 +465,14 @@ slot_store_cstrings(TupleTableSlot *slot, LogicalRepRelMapEntry *rel,
 }
 
 /*
- * Modify slot with user data provided as C strings.
+ * Modify slot with user data received from the publisher.
  * This is somewhat similar to heap_modify_tuple but also calls the type
- * input function on the user data as the input is the text representation
- * of the types.
+ * input or receive function on the user data, as the input is the text or
+ * binary representation of the types.
  */
 static void
-slot_modify_cstrings(TupleTableSlot *slot, LogicalRepRelMapEntry *rel,
-					 char **values, bool *replaces)
+slot_modify_data(TupleTableSlot *slot, LogicalRepRelMapEntry *rel,
+				 LogicalRepTupleData *tupleData)
 {
 	int			natts = slot->tts_tupleDescriptor->natts;
 	int			i;
@@ -408,7 +491,7 @@ slot_modify_cstrings(TupleTableSlot *slot, LogicalRepRelMapEntry *rel,
 	errcallback.previous = error_context_stack;
 	error_context_stack = &errcallback;
 
-	/* Call the "in" function for each replaced attribute */
+	/* Call the "in" or "recv" function for each replaced attribute */
 	for (i = 0; i < natts; i++)
 	{
 		Form_pg_attribute att = TupleDescAttr(slot->tts_tupleDescriptor, i);
@@ -417,21 +500,16 @@ slot_modify_cstrings(TupleTableSlot *slot, LogicalRepRelMapEntry *rel,
 		if (remoteattnum < 0)
 			continue;
 
-		if (!replaces[remoteattnum])
+		if (!tupleData->changed[remoteattnum])
 			continue;
 
-		if (values[remoteattnum] != NULL)
+		if (tupleData->values[remoteattnum] != NULL)
 		{
-			Oid			typinput;
-			Oid			typioparam;
-
 			errarg.local_attnum = i;
 			errarg.remote_attnum = remoteattnum;
 
-			getTypeInputInfo(att->atttypid, &typinput, &typioparam);
-			slot->tts_values[i] =
-				OidInputFunctionCall(typinput, values[remoteattnum],
-									 typioparam, att->atttypmod);
+			slot->tts_values[i] = slot_input_column(att, tupleData,
+													remoteattnum);
 			slot->tts_isnull[i] = false;
 
 			errarg.local_attnum = -1;
@@ -468,18 +546,13 @@ apply_handle_begin(StringInfo s)
 }
 
 /*
- * Handle COMMIT message.
- *
- * TODO, support tracking of multiple origins
+ * Finish the local transaction applying a remote one, shared by the
+ * handlers of COMMIT and STREAM COMMIT messages.
  */
 static void
-apply_handle_commit(StringInfo s)
+apply_handle_commit_internal(LogicalRepCommitData *commit_data)
 {
-	LogicalRepCommitData commit_data;
-
-	logicalrep_read_commit(s, &commit_data);
-
-	Assert(commit_data.commit_lsn == remote_final_lsn);
+	Assert(commit_data->commit_lsn == remote_final_lsn);
 
 	/* The synchronization worker runs in single transaction. */
 	if (IsTransactionState() && !am_tablesync_worker())
@@ -488,16 +561,29 @@ apply_handle_commit(StringInfo s)
 		 * Update origin state so we can restart streaming from correct
 		 * position in case of crash.
 		 */
-		replorigin_session_origin_lsn = commit_data.end_lsn;
-		replorigin_session_origin_timestamp = commit_data.committime;
+		replorigin_session_origin_lsn = commit_data->end_lsn;
+		replorigin_session_origin_timestamp = commit_data->committime;
+
+		/* Parallel apply workers commit in the order of the publisher. */
+		if (am_parallel_apply_worker())
+			pa_wait_for_commit_turn();
 
 		CommitTransactionCommand();
 		pgstat_report_stat(false);
 
-		store_flush_position(commit_data.end_lsn);
+		if (am_parallel_apply_worker())
+			pa_commit_done(commit_data->end_lsn, XactLastCommitEnd);
+		else
+			store_flush_position(commit_data->end_lsn, XactLastCommitEnd);
 	}
 	else
 	{
+		if (am_parallel_apply_worker())
+		{
+			pa_wait_for_commit_turn();
+			pa_commit_done(commit_data->end_lsn, InvalidXLogRecPtr);
+		}
+
 		/* Process any invalidation messages that might have accumulated. */
 		AcceptInvalidationMessages();
 		maybe_reread_subscription();
@@ -505,12 +591,31 @@ apply_handle_commit(StringInfo s)
 
 	in_remote_transaction = false;
 
-	/* Process any tables that are being synchronized in parallel. */
-	process_syncing_tables(commit_data.end_lsn);
+	/*
+	 * Process any tables that are being synchronized in parallel.  This is
+	 * left to the leader when applying in parallel.
+	 */
+	if (!am_parallel_apply_worker())
+		process_syncing_tables(commit_data->end_lsn);
 
 	pgstat_report_activity(STATE_IDLE, NULL);
 }
 
+/*
+ * Handle COMMIT message.
+ *
+ * TODO, support tracking of multiple origins
+ */
+static void
+apply_handle_commit(StringInfo s)
+{
+	LogicalRepCommitData commit_data;
+
+	logicalrep_read_commit(s, &commit_data);
+
+	apply_handle_commit_internal(&commit_data);
+}
+
 /*
  * Handle ORIGIN message.
  *
@@ -618,7 +723,7 @@ apply_handle_insert(StringInfo s)
 
 	/* Process and store remote tuple in the slot */
 	oldctx = MemoryContextSwitchTo(GetPerTupleMemoryContext(estate));
-	slot_store_cstrings(remoteslot, rel, newtup.values);
+	slot_store_data(remoteslot, rel, &newtup);
 	slot_fill_defaults(rel, estate, remoteslot);
 	MemoryContextSwitchTo(oldctx);
 
@@ -729,8 +834,8 @@ apply_handle_update(StringInfo s)
 
 	/* Build the search tuple. */
 	oldctx = MemoryContextSwitchTo(GetPerTupleMemoryContext(estate));
-	slot_store_cstrings(remoteslot, rel,
-						has_oldtup ? oldtup.values : newtup.values);
+	slot_store_data(remoteslot, rel,
+					has_oldtup ? &oldtup : &newtup);
 	MemoryContextSwitchTo(oldctx);
 
 	/*
@@ -761,7 +866,7 @@ apply_handle_update(StringInfo s)
 		/* Process and store remote tuple in the slot */
 		oldctx = MemoryContextSwitchTo(GetPerTupleMemoryContext(estate));
 		ExecCopySlot(remoteslot, localslot);
-		slot_modify_cstrings(remoteslot, rel, newtup.values, newtup.changed);
+		slot_modify_data(remoteslot, rel, &newtup);
 		MemoryContextSwitchTo(oldctx);
 
 		EvalPlanQualSetSlot(&epqstate, remoteslot);
@@ -849,7 +954,7 @@ apply_handle_delete(StringInfo s)
 
 	/* Find the tuple using the replica identity index. */
 	oldctx = MemoryContextSwitchTo(GetPerTupleMemoryContext(estate));
-	slot_store_cstrings(remoteslot, rel, oldtup.values);
+	slot_store_data(remoteslot, rel, &oldtup);
 	MemoryContextSwitchTo(oldctx);
 
 	/*
@@ -963,13 +1068,324 @@ apply_handle_truncate(StringInfo s)
 
 
 /*
- * Logical replication protocol message dispatcher.
+ * Look up the state of a streamed transaction, optionally creating it.
+ */
+static StreamXactEntry *
+stream_lookup_xact(TransactionId xid, bool create)
+{
+	StreamXactEntry *entry;
+	bool		found;
+
+	if (StreamXactHash == NULL)
+	{
+		HASHCTL		ctl;
+
+		memset(&ctl, 0, sizeof(ctl));
+		ctl.keysize = sizeof(TransactionId);
+		ctl.entrysize = sizeof(StreamXactEntry);
+		ctl.hcxt = ApplyContext;
+		StreamXactHash = hash_create("logical replication streamed transactions",
+									 16, &ctl,
+									 HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+	}
+
+	entry = hash_search(StreamXactHash, &xid,
+						create ? HASH_ENTER : HASH_FIND, &found);
+
+	if (create)
+	{
+		MemoryContext oldctx;
+
+		if (found)
+			ereport(ERROR,
+					(errcode(ERRCODE_PROTOCOL_VIOLATION),
+					 errmsg_internal("transaction %u streamed twice", xid)));
+
+		/* the file has to survive the local transactions applying changes */
+		oldctx = MemoryContextSwitchTo(ApplyContext);
+		entry->file = BufFileCreateTemp(true);
+		MemoryContextSwitchTo(oldctx);
+
+		entry->end_fileno = 0;
+		entry->end_offset = 0;
+		entry->subxacts = NIL;
+	}
+	else if (!found)
+		ereport(ERROR,
+				(errcode(ERRCODE_PROTOCOL_VIOLATION),
+				 errmsg_internal("unknown streamed transaction %u", xid)));
+
+	return entry;
+}
+
+/*
+ * Forget a streamed transaction, removing its spool file.
+ */
+static void
+stream_cleanup_xact(StreamXactEntry *entry)
+{
+	TransactionId xid = entry->xid;
+
+	BufFileClose(entry->file);
+	list_free_deep(entry->subxacts);
+	hash_search(StreamXactHash, &xid, HASH_REMOVE, NULL);
+}
+
+/*
+ * Handle STREAM START message.
+ */
+static void
+apply_handle_stream_start(StringInfo s)
+{
+	TransactionId xid;
+	bool		first_segment;
+
+	if (stream_xact != NULL || in_remote_transaction)
+		ereport(ERROR,
+				(errcode(ERRCODE_PROTOCOL_VIOLATION),
+				 errmsg("STREAM START message sent out of order")));
+
+	xid = logicalrep_read_stream_start(s, &first_segment);
+
+	stream_xact = stream_lookup_xact(xid, first_segment);
+
+	/* new changes go to the end of the valid data */
+	if (BufFileSeek(stream_xact->file, stream_xact->end_fileno,
+					stream_xact->end_offset, SEEK_SET) != 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not seek in spool file of streamed transaction %u: %m",
+						xid)));
+
+	pgstat_report_activity(STATE_RUNNING, NULL);
+}
+
+/*
+ * Handle STREAM STOP message.
+ */
+static void
+apply_handle_stream_stop(StringInfo s)
+{
+	if (stream_xact == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_PROTOCOL_VIOLATION),
+				 errmsg("STREAM STOP message sent out of order")));
+
+	stream_xact = NULL;
+
+	pgstat_report_activity(STATE_IDLE, NULL);
+}
+
+/*
+ * Spool a change of the transaction being streamed.  The XID of the
+ * (sub)transaction follows the action byte; what is written to the file is
+ * the message without it, so that it can later be applied as it stands.
+ */
+static void
+stream_write_change(char action, StringInfo s)
+{
+	TransactionId xid = pq_getmsgint(s, 4);
+	StreamSubXact *subxact;
+	int			len;
+
+	/* remember where the changes of a new subtransaction start */
+	subxact = (stream_xact->subxacts != NIL) ?
+		(StreamSubXact *) llast(stream_xact->subxacts) : NULL;
+	if (xid != stream_xact->xid && (subxact == NULL || subxact->xid != xid))
+	{
+		ListCell   *lc;
+		MemoryContext oldctx;
+
+		foreach(lc, stream_xact->subxacts)
+		{
+			subxact = (StreamSubXact *) lfirst(lc);
+			if (subxact->xid == xid)
+				break;
+		}
+
+		if (lc == NULL)
+		{
+			oldctx = MemoryContextSwitchTo(ApplyContext);
+			subxact = palloc(sizeof(StreamSubXact));
+			subxact->xid = xid;
+			subxact->fileno = stream_xact->end_fileno;
+			subxact->offset = stream_xact->end_offset;
+			stream_xact->subxacts = lappend(stream_xact->subxacts, subxact);
+			MemoryContextSwitchTo(oldctx);
+		}
+	}
+
+	len = s->len - s->cursor + 1;
+	if (BufFileWrite(stream_xact->file, &len, sizeof(len)) != sizeof(len) ||
+		BufFileWrite(stream_xact->file, &action, 1) != 1 ||
+		BufFileWrite(stream_xact->file, &s->data[s->cursor],
+					 len - 1) != len - 1)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not write to spool file of streamed transaction %u: %m",
+						stream_xact->xid)));
+
+	BufFileTell(stream_xact->file, &stream_xact->end_fileno,
+				&stream_xact->end_offset);
+}
+
+/*
+ * Handle STREAM ABORT message, for a top-level transaction or one of its
+ * subtransactions.
+ */
+static void
+apply_handle_stream_abort(StringInfo s)
+{
+	TransactionId xid;
+	TransactionId subxid;
+	StreamXactEntry *entry;
+	ListCell   *lc;
+	int			i = 0;
+
+	if (stream_xact != NULL || in_remote_transaction)
+		ereport(ERROR,
+				(errcode(ERRCODE_PROTOCOL_VIOLATION),
+				 errmsg("STREAM ABORT message sent out of order")));
+
+	logicalrep_read_stream_abort(s, &xid, &subxid);
+
+	entry = stream_lookup_xact(xid, false);
+
+	if (xid == subxid)
+	{
+		stream_cleanup_xact(entry);
+		return;
+	}
+
+	/*
+	 * Discard the changes of the subtransaction, and of the ones that
+	 * started after it (which must be its children), by moving the end of
+	 * the valid data back.  A subtransaction without changes is not in the
+	 * list, and there is nothing to do.
+	 */
+	foreach(lc, entry->subxacts)
+	{
+		StreamSubXact *subxact = (StreamSubXact *) lfirst(lc);
+
+		if (subxact->xid == subxid)
+		{
+			entry->end_fileno = subxact->fileno;
+			entry->end_offset = subxact->offset;
+			entry->subxacts = list_truncate(entry->subxacts, i);
+			break;
+		}
+		i++;
+	}
+}
+
+/*
+ * Handle STREAM COMMIT message, applying all the spooled changes of the
+ * transaction in a single local transaction.
  */
 static void
+apply_handle_stream_commit(StringInfo s)
+{
+	TransactionId xid;
+	LogicalRepCommitData commit_data;
+	StreamXactEntry *entry;
+	StringInfoData change;
+	int			fileno;
+	off_t		offset;
+	int			nchanges = 0;
+
+	if (stream_xact != NULL || in_remote_transaction)
+		ereport(ERROR,
+				(errcode(ERRCODE_PROTOCOL_VIOLATION),
+				 errmsg("STREAM COMMIT message sent out of order")));
+
+	xid = logicalrep_read_stream_commit(s, &commit_data);
+
+	entry = stream_lookup_xact(xid, false);
+
+	remote_final_lsn = commit_data.commit_lsn;
+	in_remote_transaction = true;
+
+	pgstat_report_activity(STATE_RUNNING, NULL);
+
+	if (BufFileSeek(entry->file, 0, 0, SEEK_SET) != 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not seek in spool file of streamed transaction %u: %m",
+						xid)));
+
+	/* the buffer must survive the reset of the per-message context */
+	change.data = MemoryContextAlloc(ApplyContext, BLCKSZ);
+	change.maxlen = BLCKSZ;
+
+	for (;;)
+	{
+		int			len;
+
+		BufFileTell(entry->file, &fileno, &offset);
+		if (fileno == entry->end_fileno && offset == entry->end_offset)
+			break;
+
+		if (BufFileRead(entry->file, &len, sizeof(len)) != sizeof(len))
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not read from spool file of streamed transaction %u: %m",
+							xid)));
+
+		if (len > change.maxlen)
+		{
+			pfree(change.data);
+			change.data = MemoryContextAlloc(ApplyContext, len);
+			change.maxlen = len;
+		}
+
+		if (BufFileRead(entry->file, change.data, len) != len)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not read from spool file of streamed transaction %u: %m",
+							xid)));
+
+		change.len = len;
+		change.cursor = 0;
+
+		apply_dispatch(&change);
+
+		/* don't accumulate the memory of all the changes */
+		MemoryContextReset(ApplyMessageContext);
+
+		nchanges++;
+		CHECK_FOR_INTERRUPTS();
+	}
+
+	pfree(change.data);
+
+	elog(DEBUG1, "replayed %d changes of streamed transaction %u",
+		 nchanges, xid);
+
+	stream_cleanup_xact(entry);
+
+	apply_handle_commit_internal(&commit_data);
+}
+
+/*
+ * Logical replication protocol message dispatcher.
+ */
+void
 apply_dispatch(StringInfo s)
 {
 	char		action = pq_getmsgbyte(s);
 
+	/*
+	 * While receiving a block of a streamed transaction, data changes are
+	 * spooled rather than applied.  The other messages (relation and type
+	 * descriptions) are processed right away.
+	 */
+	if (stream_xact != NULL &&
+		(action == 'I' || action == 'U' || action == 'D' || action == 'T'))
+	{
+		stream_write_change(action, s);
+		return;
+	}
+
 	switch (action)
 	{
 			/* BEGIN */
@@ -1008,6 +1424,22 @@ apply_dispatch(StringInfo s)
 		case 'O':
 			apply_handle_origin(s);
 			break;
+			/* STREAM START */
+		case 'S':
+			apply_handle_stream_start(s);
+			break;
+			/* STREAM STOP */
+		case 'E':
+			apply_handle_stream_stop(s);
+			break;
+			/* STREAM ABORT */
+		case 'A':
+			apply_handle_stream_abort(s);
+			break;
+			/* STREAM COMMIT */
+		case 'c':
+			apply_handle_stream_commit(s);
+			break;
 		default:
 			ereport(ERROR,
 					(errcode(ERRCODE_PROTOCOL_VIOLATION),
@@ -1034,6 +1466,12 @@ get_flush_position(XLogRecPtr *write, XLogRecPtr *flush,
 {
 	dlist_mutable_iter iter;
 	XLogRecPtr	local_flush = GetFlushRecPtr();
+	XLogRecPtr	pa_remote_end;
+	XLogRecPtr	pa_local_end;
+
+	/* Track what the parallel apply workers have committed meanwhile. */
+	if (pa_get_progress(&pa_remote_end, &pa_local_end))
+		store_flush_position(pa_remote_end, pa_local_end);
 
 	*write = InvalidXLogRecPtr;
 	*flush = InvalidXLogRecPtr;
@@ -1066,14 +1504,15 @@ get_flush_position(XLogRecPtr *write, XLogRecPtr *flush,
 		}
 	}
 
-	*have_pending_txes = !dlist_is_empty(&lsn_mapping);
+	*have_pending_txes = !dlist_is_empty(&lsn_mapping) ||
+		pa_have_pending_txns();
 }
 
 /*
  * Store current remote/local lsn pair in the tracking list.
  */
 static void
-store_flush_position(XLogRecPtr remote_lsn)
+store_flush_position(XLogRecPtr remote_lsn, XLogRecPtr local_lsn)
 {
 	FlushPosition *flushpos;
 
@@ -1082,7 +1521,7 @@ store_flush_position(XLogRecPtr remote_lsn)
 
 	/* Track commit lsn  */
 	flushpos = (FlushPosition *) palloc(sizeof(FlushPosition));
-	flushpos->local_end = XactLastCommitEnd;
+	flushpos->local_end = local_lsn;
 	flushpos->remote_end = remote_lsn;
 
 	dlist_push_tail(&lsn_mapping, &flushpos->node);
@@ -1193,7 +1632,8 @@ LogicalRepApplyLoop(XLogRecPtr last_received)
 
 						UpdateWorkerStats(last_received, send_time, false);
 
-						apply_dispatch(&s);
+						if (!pa_handle_message(&s))
+							apply_dispatch(&s);
 					}
 					else if (c == 'k')
 					{
@@ -1233,8 +1673,12 @@ LogicalRepApplyLoop(XLogRecPtr last_received)
 			AcceptInvalidationMessages();
 			maybe_reread_subscription();
 
-			/* Process any table synchronization changes. */
-			process_syncing_tables(last_received);
+			/*
+			 * Process any table synchronization changes, once the parallel
+			 * apply workers have applied everything received.
+			 */
+			if (!pa_have_pending_txns())
+				process_syncing_tables(last_received);
 		}
 
 		/* Cleanup the memory. */
@@ -1535,6 +1979,34 @@ maybe_reread_subscription(void)
 		proc_exit(0);
 	}
 
+	/*
+	 * Exit if the streaming option was changed. The launcher will start new
+	 * worker.
+	 */
+	if (newsub->stream != MySubscription->stream)
+	{
+		ereport(LOG,
+				(errmsg("logical replication apply worker for subscription \"%s\" will "
+						"restart because the streaming option was changed",
+						MySubscription->name)));
+
+		proc_exit(0);
+	}
+
+	/*
+	 * Exit if the binary option was changed. The launcher will start new
+	 * worker.
+	 */
+	if (newsub->binary != MySubscription->binary)
+	{
+		ereport(LOG,
+				(errmsg("logical replication apply worker for subscription \"%s\" will "
+						"restart because the binary option was changed",
+						MySubscription->name)));
+
+		proc_exit(0);
+	}
+
 	/* Check for other changes that should never happen too. */
 	if (newsub->dbid != MySubscription->dbid)
 	{
@@ -1581,24 +2053,15 @@ logicalrep_worker_sighup(SIGNAL_ARGS)
 	errno = save_errno;
 }
 
-/* Logical Replication Apply worker entry point */
+/*
+ * Common initialization of the apply, table synchronization and parallel
+ * apply workers, once attached to their slot: connect to the database and
+ * load the subscription.
+ */
 void
-ApplyWorkerMain(Datum main_arg)
+InitializeLogRepWorker(void)
 {
-	int			worker_slot = DatumGetInt32(main_arg);
 	MemoryContext oldctx;
-	char		originname[NAMEDATALEN];
-	XLogRecPtr	origin_startpos;
-	char	   *myslotname;
-	WalRcvStreamOptions options;
-
-	/* Attach to slot */
-	logicalrep_worker_attach(worker_slot);
-
-	/* Setup signal handling */
-	pqsignal(SIGHUP, logicalrep_worker_sighup);
-	pqsignal(SIGTERM, die);
-	BackgroundWorkerUnblockSignals();
 
 	/*
 	 * We don't currently need any ResourceOwner in a walreceiver process, but
@@ -1609,9 +2072,6 @@ ApplyWorkerMain(Datum main_arg)
 	MyLogicalRepWorker->last_send_time = MyLogicalRepWorker->last_recv_time =
 		MyLogicalRepWorker->reply_time = GetCurrentTimestamp();
 
-	/* Load the libpq-specific functions */
-	load_file("libpqwalreceiver", false);
-
 	/* Run as replica session replication role. */
 	SetConfigOption("session_replication_role", "replica",
 					PGC_SUSET, PGC_S_OVERRIDE);
@@ -1660,6 +2120,34 @@ ApplyWorkerMain(Datum main_arg)
 								  subscription_change_cb,
 								  (Datum) 0);
 
+	CommitTransactionCommand();
+}
+
+/* Logical Replication Apply worker entry point */
+void
+ApplyWorkerMain(Datum main_arg)
+{
+	int			worker_slot = DatumGetInt32(main_arg);
+	MemoryContext oldctx;
+	char		originname[NAMEDATALEN];
+	XLogRecPtr	origin_startpos;
+	char	   *myslotname;
+	WalRcvStreamOptions options;
+
+	/* Attach to slot */
+	logicalrep_worker_attach(worker_slot);
+
+	/* Setup signal handling */
+	pqsignal(SIGHUP, logicalrep_worker_sighup);
+	pqsignal(SIGTERM, die);
+	BackgroundWorkerUnblockSignals();
+
+	/* Load the libpq-specific functions */
+	load_file("libpqwalreceiver", false);
+
+	InitializeLogRepWorker();
+
+	StartTransactionCommand();
 	if (am_tablesync_worker())
 		ereport(LOG,
 				(errmsg("logical replication table synchronization worker for subscription \"%s\", table \"%s\" has started",
@@ -1714,7 +2202,7 @@ ApplyWorkerMain(Datum main_arg)
 		originid = replorigin_by_name(originname, true);
 		if (!OidIsValid(originid))
 			originid = replorigin_create(originname);
-		replorigin_session_setup(originid);
+		replorigin_session_setup(originid, 0);
 		replorigin_session_origin = originid;
 		origin_startpos = replorigin_session_get_progress(false);
 		CommitTransactionCommand();
@@ -1746,12 +2234,25 @@ ApplyWorkerMain(Datum main_arg)
 	options.logical = true;
 	options.startpoint = origin_startpos;
 	options.slotname = myslotname;
-	options.proto.logical.proto_version = LOGICALREP_PROTO_VERSION_NUM;
 	options.proto.logical.publication_names = MySubscription->publications;
 
+	/*
+	 * Table synchronization workers apply everything in a single transaction
+	 * anyway, so only the apply worker asks for streaming.
+	 */
+	options.proto.logical.streaming =
+		MySubscription->stream && !am_tablesync_worker();
+	options.proto.logical.proto_version = options.proto.logical.streaming ?
+		LOGICALREP_PROTO_STREAM_VERSION_NUM : LOGICALREP_PROTO_VERSION_NUM;
+	options.proto.logical.binary = MySubscription->binary;
+
 	/* Start normal logical streaming replication. */
 	walrcv_startstreaming(wrconn, &options);
 
+	/* Start the parallel apply workers, if any. */
+	if (!am_tablesync_worker())
+		pa_start_workers();
+
 	/* Run the main loop. */
 	LogicalRepApplyLoop(origin_startpos);
 
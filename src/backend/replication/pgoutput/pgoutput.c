@@ -14,10 +14,17 @@
 
 #include "catalog/pg_publication.h"
 
+#include "executor/executor.h"
+
+#include "nodes/makefuncs.h"
+
+#include "optimizer/planner.h"
+
 #include "replication/logical.h"
 #include "replication/logicalproto.h"
 #include "replication/origin.h"
 #include "replication/pgoutput.h"
+#include "utils/builtins.h"
 
 #include "utils/inval.h"
 #include "utils/int8.h"
@@ -44,20 +51,46 @@ static void pgoutput_truncate(LogicalDecodingContext *ctx,
 				  ReorderBufferChange *change);
 static bool pgoutput_origin_filter(LogicalDecodingContext *ctx,
 					   RepOriginId origin_id);
+static void pgoutput_stream_start(LogicalDecodingContext *ctx,
+					  ReorderBufferTXN *txn);
+static void pgoutput_stream_stop(LogicalDecodingContext *ctx,
+					 ReorderBufferTXN *txn);
+static void pgoutput_stream_abort(LogicalDecodingContext *ctx,
+					  ReorderBufferTXN *txn, XLogRecPtr abort_lsn);
+static void pgoutput_stream_commit(LogicalDecodingContext *ctx,
+					   ReorderBufferTXN *txn, XLogRecPtr commit_lsn);
 
 static bool publications_valid;
 
+/* are we inside a block of changes of a streamed transaction? */
+static bool in_streaming;
+
 static List *LoadPublications(List *pubnames);
 static void publication_invalidation_cb(Datum arg, int cacheid,
 							uint32 hashvalue);
 
-/* Entry in the map used to remember which relation schemas we sent. */
+/*
+ * Entry in the map used to remember which relation schemas we sent.
+ *
+ * It also caches the combined column list and row filter of the publications
+ * the relation is in.  A column is sent if any of the publications publishes
+ * it, and a row if any publication's row filter accepts it; a publication
+ * without column list or row filter publishes all columns or rows.  The
+ * executor state of the row filter is built when first needed.
+ */
 typedef struct RelationSyncEntry
 {
 	Oid			relid;			/* relation oid */
 	bool		schema_sent;	/* did we send the schema? */
 	bool		replicate_valid;
 	PublicationActions pubactions;
+
+	MemoryContext filter_cxt;	/* holds the fields below, or NULL */
+	Bitmapset  *columns;		/* published columns, NULL for all */
+	Expr	   *rowfilter;		/* row filter, NULL for all rows */
+	ExprState  *exprstate;		/* its executor state, once built */
+	ExprContext *econtext;		/* context to evaluate it in */
+	TupleTableSlot *scanslot;	/* slot to evaluate it on */
 } RelationSyncEntry;
 
 /* Map used to remember which relation schemas we sent. */
@@ -84,15 +117,29 @@ _PG_output_plugin_init(OutputPluginCallbacks *cb)
 	cb->commit_cb = pgoutput_commit_txn;
 	cb->filter_by_origin_cb = pgoutput_origin_filter;
 	cb->shutdown_cb = pgoutput_shutdown;
+
+	/* transaction streaming */
+	cb->stream_start_cb = pgoutput_stream_start;
+	cb->stream_stop_cb = pgoutput_stream_stop;
+	cb->stream_abort_cb = pgoutput_stream_abort;
+	cb->stream_commit_cb = pgoutput_stream_commit;
+	cb->stream_change_cb = pgoutput_change;
+	cb->stream_truncate_cb = pgoutput_truncate;
 }
 
 static void
 parse_output_parameters(List *options, uint32 *protocol_version,
-						List **publication_names)
+						List **publication_names, bool *enable_streaming,
+						bool *binary)
 {
 	ListCell   *lc;
 	bool		protocol_version_given = false;
 	bool		publication_names_given = false;
+	bool		streaming_given = false;
+	bool		binary_given = false;
+
+	*enable_streaming = false;
+	*binary = false;
 
 	foreach(lc, options)
 	{
@@ -138,6 +185,34 @@ parse_output_parameters(List *options, uint32 *protocol_version,
 						(errcode(ERRCODE_INVALID_NAME),
 						 errmsg("invalid publication_names syntax")));
 		}
+		else if (strcmp(defel->defname, "streaming") == 0)
+		{
+			if (streaming_given)
+				ereport(ERROR,
+						(errcode(ERRCODE_SYNTAX_ERROR),
+						 errmsg("conflicting or redundant options")));
+			streaming_given = true;
+
+			if (!parse_bool(strVal(defel->arg), enable_streaming))
+				ereport(ERROR,
+						(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+						 errmsg("could not parse streaming parameter \"%s\"",
+								strVal(defel->arg))));
+		}
+		else if (strcmp(defel->defname, "binary") == 0)
+		{
+			if (binary_given)
+				ereport(ERROR,
+						(errcode(ERRCODE_SYNTAX_ERROR),
+						 errmsg("conflicting or redundant options")));
+			binary_given = true;
+
+			if (!parse_bool(strVal(defel->arg), binary))
+				ereport(ERROR,
+						(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+						 errmsg("could not parse binary parameter \"%s\"",
+								strVal(defel->arg))));
+		}
 		else
 			elog(ERROR, "unrecognized pgoutput option: %s", defel->defname);
 	}
@@ -172,14 +247,16 @@ pgoutput_startup(LogicalDecodingContext *ctx, OutputPluginOptions *opt,
 		/* Parse the params and ERROR if we see any we don't recognize */
 		parse_output_parameters(ctx->output_plugin_options,
 								&data->protocol_version,
-								&data->publication_names);
+								&data->publication_names,
+								&data->streaming,
+								&data->binary);
 
 		/* Check if we support requested protocol */
-		if (data->protocol_version > LOGICALREP_PROTO_VERSION_NUM)
+		if (data->protocol_version > LOGICALREP_PROTO_MAX_VERSION_NUM)
 			ereport(ERROR,
 					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
 					 errmsg("client sent proto_version=%d but we only support protocol %d or lower",
-							data->protocol_version, LOGICALREP_PROTO_VERSION_NUM)));
+							data->protocol_version, LOGICALREP_PROTO_MAX_VERSION_NUM)));
 
 		if (data->protocol_version < LOGICALREP_PROTO_MIN_VERSION_NUM)
 			ereport(ERROR,
@@ -192,6 +269,13 @@ pgoutput_startup(LogicalDecodingContext *ctx, OutputPluginOptions *opt,
 					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
 					 errmsg("publication_names parameter missing")));
 
+		if (data->streaming &&
+			data->protocol_version < LOGICALREP_PROTO_STREAM_VERSION_NUM)
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("requested proto_version=%d does not support streaming, need %d or higher",
+							data->protocol_version, LOGICALREP_PROTO_STREAM_VERSION_NUM)));
+
 		/* Init publication state. */
 		data->publications = NIL;
 		publications_valid = false;
@@ -202,6 +286,10 @@ pgoutput_startup(LogicalDecodingContext *ctx, OutputPluginOptions *opt,
 		/* Initialize relation schema cache. */
 		init_rel_sync_cache(CacheMemoryContext);
 	}
+
+	/* Only stream in-progress transactions if the client asked for it. */
+	ctx->streaming = data->streaming;
+	in_streaming = false;
 }
 
 /*
@@ -279,6 +367,10 @@ maybe_send_schema(LogicalDecodingContext *ctx,
 			if (att->attisdropped)
 				continue;
 
+			if (relentry->columns != NULL &&
+				!bms_is_member(att->attnum, relentry->columns))
+				continue;
+
 			if (att->atttypid < FirstNormalObjectId)
 				continue;
 
@@ -288,12 +380,50 @@ maybe_send_schema(LogicalDecodingContext *ctx,
 		}
 
 		OutputPluginPrepareWrite(ctx, false);
-		logicalrep_write_rel(ctx->out, relation);
+		logicalrep_write_rel(ctx->out, relation, relentry->columns);
 		OutputPluginWrite(ctx, false);
 		relentry->schema_sent = true;
 	}
 }
 
+/*
+ * Does the row filter of the relation accept the tuple?
+ */
+static bool
+pgoutput_row_filter(Relation relation, RelationSyncEntry *relentry,
+					HeapTuple tuple)
+{
+	Datum		ret;
+	bool		isnull;
+
+	if (relentry->rowfilter == NULL)
+		return true;
+
+	if (relentry->exprstate == NULL)
+	{
+		MemoryContext oldctx = MemoryContextSwitchTo(relentry->filter_cxt);
+		TupleDesc	desc = CreateTupleDescCopy(RelationGetDescr(relation));
+
+		relentry->scanslot = MakeSingleTupleTableSlot(desc, &TTSOpsHeapTuple);
+		relentry->econtext = CreateStandaloneExprContext();
+		relentry->exprstate =
+			ExecInitExpr(expression_planner(copyObject(relentry->rowfilter)),
+						 NULL);
+		MemoryContextSwitchTo(oldctx);
+	}
+
+	ExecStoreHeapTuple(tuple, relentry->scanslot, false);
+	relentry->econtext->ecxt_scantuple = relentry->scanslot;
+
+	ret = ExecEvalExprSwitchContext(relentry->exprstate, relentry->econtext,
+									&isnull);
+
+	ExecClearTuple(relentry->scanslot);
+	ResetExprContext(relentry->econtext);
+
+	return !isnull && DatumGetBool(ret);
+}
+
 /*
  * Sends the decoded DML over wire.
  */
@@ -304,10 +434,18 @@ pgoutput_change(LogicalDecodingContext *ctx, ReorderBufferTXN *txn,
 	PGOutputData *data = (PGOutputData *) ctx->output_plugin_private;
 	MemoryContext old;
 	RelationSyncEntry *relentry;
+	TransactionId xid = InvalidTransactionId;
 
 	if (!is_publishable_relation(relation))
 		return;
 
+	/*
+	 * Changes of a streamed transaction carry the XID of the subtransaction
+	 * they belong to, so that the subscriber can discard them if it aborts.
+	 */
+	if (in_streaming)
+		xid = change->txn->xid;
+
 	relentry = get_rel_sync_entry(data, RelationGetRelid(relation));
 
 	/* First check the table filter */
@@ -332,34 +470,73 @@ pgoutput_change(LogicalDecodingContext *ctx, ReorderBufferTXN *txn,
 	/* Avoid leaking memory by using and resetting our own context */
 	old = MemoryContextSwitchTo(data->context);
 
-	maybe_send_schema(ctx, relation, relentry);
-
-	/* Send the data */
+	/* Send the data, unless the row filter rejects it */
 	switch (change->action)
 	{
 		case REORDER_BUFFER_CHANGE_INSERT:
-			OutputPluginPrepareWrite(ctx, true);
-			logicalrep_write_insert(ctx->out, relation,
-									&change->data.tp.newtuple->tuple);
-			OutputPluginWrite(ctx, true);
-			break;
+			{
+				HeapTuple	newtuple = &change->data.tp.newtuple->tuple;
+
+				if (!pgoutput_row_filter(relation, relentry, newtuple))
+					break;
+
+				maybe_send_schema(ctx, relation, relentry);
+				OutputPluginPrepareWrite(ctx, true);
+				logicalrep_write_insert(ctx->out, xid, relation, newtuple,
+										data->binary, relentry->columns);
+				OutputPluginWrite(ctx, true);
+				break;
+			}
 		case REORDER_BUFFER_CHANGE_UPDATE:
 			{
 				HeapTuple	oldtuple = change->data.tp.oldtuple ?
 				&change->data.tp.oldtuple->tuple : NULL;
-
+				HeapTuple	newtuple = &change->data.tp.newtuple->tuple;
+				bool		new_matches;
+				bool		old_matches;
+
+				/*
+				 * The row filter only references replica identity columns
+				 * (or any column with REPLICA IDENTITY FULL), so if the old
+				 * tuple wasn't logged, the old row matches iff the new one
+				 * does.  A row that starts or stops matching is sent to the
+				 * subscriber as INSERT or DELETE, respectively.
+				 */
+				new_matches = pgoutput_row_filter(relation, relentry, newtuple);
+				old_matches = oldtuple ?
+					pgoutput_row_filter(relation, relentry, oldtuple) :
+					new_matches;
+
+				if (!old_matches && !new_matches)
+					break;
+
+				maybe_send_schema(ctx, relation, relentry);
 				OutputPluginPrepareWrite(ctx, true);
-				logicalrep_write_update(ctx->out, relation, oldtuple,
-										&change->data.tp.newtuple->tuple);
+				if (!old_matches)
+					logicalrep_write_insert(ctx->out, xid, relation, newtuple,
+											data->binary, relentry->columns);
+				else if (!new_matches)
+					logicalrep_write_delete(ctx->out, xid, relation, oldtuple,
+											data->binary, relentry->columns);
+				else
+					logicalrep_write_update(ctx->out, xid, relation, oldtuple,
+											newtuple, data->binary,
+											relentry->columns);
 				OutputPluginWrite(ctx, true);
 				break;
 			}
 		case REORDER_BUFFER_CHANGE_DELETE:
 			if (change->data.tp.oldtuple)
 			{
+				HeapTuple	oldtuple = &change->data.tp.oldtuple->tuple;
+
+				if (!pgoutput_row_filter(relation, relentry, oldtuple))
+					break;
+
+				maybe_send_schema(ctx, relation, relentry);
 				OutputPluginPrepareWrite(ctx, true);
-				logicalrep_write_delete(ctx->out, relation,
-										&change->data.tp.oldtuple->tuple);
+				logicalrep_write_delete(ctx->out, xid, relation, oldtuple,
+										data->binary, relentry->columns);
 				OutputPluginWrite(ctx, true);
 			}
 			else
@@ -384,6 +561,11 @@ pgoutput_truncate(LogicalDecodingContext *ctx, ReorderBufferTXN *txn,
 	int			i;
 	int			nrelids;
 	Oid		   *relids;
+	TransactionId xid = InvalidTransactionId;
+
+	/* see pgoutput_change */
+	if (in_streaming)
+		xid = change->txn->xid;
 
 	old = MemoryContextSwitchTo(data->context);
 
@@ -411,6 +593,7 @@ pgoutput_truncate(LogicalDecodingContext *ctx, ReorderBufferTXN *txn,
 	{
 		OutputPluginPrepareWrite(ctx, true);
 		logicalrep_write_truncate(ctx->out,
+								  xid,
 								  nrelids,
 								  relids,
 								  change->data.truncate.cascade,
@@ -432,6 +615,80 @@ pgoutput_origin_filter(LogicalDecodingContext *ctx,
 	return false;
 }
 
+/*
+ * START STREAM callback
+ *
+ * The relation and type messages sent while streaming (cf.
+ * maybe_send_schema) carry no XID: the subscriber applies them right away,
+ * as they describe the committed schema and are not part of the transaction.
+ */
+static void
+pgoutput_stream_start(LogicalDecodingContext *ctx, ReorderBufferTXN *txn)
+{
+	/* we can't nest streaming of transactions */
+	Assert(!in_streaming);
+
+	OutputPluginPrepareWrite(ctx, true);
+	logicalrep_write_stream_start(ctx->out, txn->xid, !txn->streamed);
+	OutputPluginWrite(ctx, true);
+
+	/* we're streaming a chunk of transaction now */
+	in_streaming = true;
+}
+
+/*
+ * STOP STREAM callback
+ */
+static void
+pgoutput_stream_stop(LogicalDecodingContext *ctx, ReorderBufferTXN *txn)
+{
+	/* we should be streaming a transaction */
+	Assert(in_streaming);
+
+	OutputPluginPrepareWrite(ctx, true);
+	logicalrep_write_stream_stop(ctx->out);
+	OutputPluginWrite(ctx, true);
+
+	/* we've stopped streaming a transaction */
+	in_streaming = false;
+}
+
+/*
+ * ABORT STREAM callback, for a top-level transaction or a subtransaction
+ */
+static void
+pgoutput_stream_abort(LogicalDecodingContext *ctx, ReorderBufferTXN *txn,
+					  XLogRecPtr abort_lsn)
+{
+	ReorderBufferTXN *toptxn = txn->toptxn != NULL ? txn->toptxn : txn;
+
+	/* aborts are only sent between blocks of streamed changes */
+	Assert(!in_streaming);
+	Assert(toptxn->streamed);
+
+	OutputPluginPrepareWrite(ctx, true);
+	logicalrep_write_stream_abort(ctx->out, toptxn->xid, txn->xid);
+	OutputPluginWrite(ctx, true);
+}
+
+/*
+ * COMMIT STREAM callback
+ */
+static void
+pgoutput_stream_commit(LogicalDecodingContext *ctx, ReorderBufferTXN *txn,
+					   XLogRecPtr commit_lsn)
+{
+	/* commits are only sent between blocks of streamed changes */
+	Assert(!in_streaming);
+	Assert(txn->streamed);
+
+	OutputPluginUpdateProgress(ctx);
+
+	OutputPluginPrepareWrite(ctx, true);
+	logicalrep_write_stream_commit(ctx->out, txn, commit_lsn);
+	OutputPluginWrite(ctx, true);
+}
+
 /*
  * Shutdown the output plugin.
  *
@@ -443,6 +700,17 @@ pgoutput_shutdown(LogicalDecodingContext *ctx)
 {
 	if (RelationSyncCache)
 	{
+		HASH_SEQ_STATUS status;
+		RelationSyncEntry *entry;
+
+		/* The row filter contexts are children of CacheMemoryContext. */
+		hash_seq_init(&status, RelationSyncCache);
+		while ((entry = (RelationSyncEntry *) hash_seq_search(&status)) != NULL)
+		{
+			if (entry->filter_cxt != NULL)
+				MemoryContextDelete(entry->filter_cxt);
+		}
+
 		hash_destroy(RelationSyncCache);
 		RelationSyncCache = NULL;
 	}
@@ -540,10 +808,28 @@ get_rel_sync_entry(PGOutputData *data, Oid relid)
 	Assert(entry != NULL);
 
 	/* Not found means schema wasn't sent */
+	if (!found)
+		entry->filter_cxt = NULL;
+
 	if (!found || !entry->replicate_valid)
 	{
 		List	   *pubids = GetRelationPublications(relid);
 		ListCell   *lc;
+		List	   *quals = NIL;
+		bool		all_columns = false;
+		bool		all_rows = false;
+
+		/* Forget the old column list and row filter. */
+		if (entry->filter_cxt != NULL)
+			MemoryContextDelete(entry->filter_cxt);
+		entry->filter_cxt = AllocSetContextCreate(CacheMemoryContext,
+												  "logical replication row filter",
+												  ALLOCSET_SMALL_SIZES);
+		entry->columns = NULL;
+		entry->rowfilter = NULL;
+		entry->exprstate = NULL;
+		entry->econtext = NULL;
+		entry->scanslot = NULL;
 
 		/* Reload publications if needed before use. */
 		if (!publications_valid)
@@ -571,19 +857,52 @@ get_rel_sync_entry(PGOutputData *data, Oid relid)
 
 			if (pub->alltables || list_member_oid(pubids, pub->oid))
 			{
+				Bitmapset  *columns = NULL;
+				Node	   *qual = NULL;
+
 				entry->pubactions.pubinsert |= pub->pubactions.pubinsert;
 				entry->pubactions.pubupdate |= pub->pubactions.pubupdate;
 				entry->pubactions.pubdelete |= pub->pubactions.pubdelete;
 				entry->pubactions.pubtruncate |= pub->pubactions.pubtruncate;
+
+				oldctx = MemoryContextSwitchTo(entry->filter_cxt);
+				if (!pub->alltables)
+					GetPublicationRelationFilters(pub->oid, relid,
+												  &columns, &qual);
+
+				if (columns == NULL)
+					all_columns = true;
+				else if (!all_columns)
+					entry->columns = bms_add_members(entry->columns, columns);
+
+				if (qual == NULL)
+					all_rows = true;
+				else if (!all_rows)
+					quals = lappend(quals, qual);
+				MemoryContextSwitchTo(oldctx);
 			}
 
 			if (entry->pubactions.pubinsert && entry->pubactions.pubupdate &&
-				entry->pubactions.pubdelete && entry->pubactions.pubtruncate)
+				entry->pubactions.pubdelete && entry->pubactions.pubtruncate &&
+				all_columns && all_rows)
 				break;
 		}
 
 		list_free(pubids);
 
+		if (all_columns)
+			entry->columns = NULL;
+
+		if (!all_rows && quals != NIL)
+		{
+			oldctx = MemoryContextSwitchTo(entry->filter_cxt);
+			if (list_length(quals) == 1)
+				entry->rowfilter = (Expr *) linitial(quals);
+			else
+				entry->rowfilter = makeBoolExpr(OR_EXPR, quals, -1);
+			MemoryContextSwitchTo(oldctx);
+		}
+
 		entry->replicate_valid = true;
 	}
 
@@ -625,10 +944,14 @@ rel_sync_cache_relation_cb(Datum arg, Oid relid)
 											  HASH_FIND, NULL);
 
 	/*
-	 * Reset schema sent status as the relation definition may have changed.
+	 * Reset schema sent status as the relation definition may have changed,
+	 * and rebuild the row filter state, which depends on it.
 	 */
 	if (entry != NULL)
+	{
 		entry->schema_sent = false;
+		entry->replicate_valid = false;
+	}
 }
 
 /*
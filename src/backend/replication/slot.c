@@ -99,6 +99,8 @@ ReplicationSlot *MyReplicationSlot = NULL;
 int			max_replication_slots = 0;	/* the maximum number of replication
 										 * slots */
 
+static ReplicationSlot *ReplicationSlotAcquireInternal(const char *name,
+							   bool nowait);
 static void ReplicationSlotDropAcquired(void);
 static void ReplicationSlotDropPtr(ReplicationSlot *slot);
 
@@ -328,13 +330,40 @@ ReplicationSlotCreate(const char *name, bool db_specific,
  */
 void
 ReplicationSlotAcquire(const char *name, bool nowait)
+{
+	Assert(MyReplicationSlot == NULL);
+
+	/* We made this slot active, so it's ours now. */
+	MyReplicationSlot = ReplicationSlotAcquireInternal(name, nowait);
+}
+
+/*
+ * Mark a previously created slot as used by this backend, without making it
+ * MyReplicationSlot.
+ *
+ * This is used to attach further slots to a decoding group driven by
+ * MyReplicationSlot.  The caller must not try to acquire the same slot
+ * twice, and has to release the slot again using
+ * ReplicationSlotReleaseAdditional(), also on error.
+ */
+ReplicationSlot *
+ReplicationSlotAcquireAdditional(const char *name, bool nowait)
+{
+	return ReplicationSlotAcquireInternal(name, nowait);
+}
+
+/*
+ * Workhorse for ReplicationSlotAcquire() and
+ * ReplicationSlotAcquireAdditional().
+ */
+static ReplicationSlot *
+ReplicationSlotAcquireInternal(const char *name, bool nowait)
 {
 	ReplicationSlot *slot;
 	int			active_pid;
 	int			i;
 
 retry:
-	Assert(MyReplicationSlot == NULL);
 
 	/*
 	 * Search for the named slot and mark it active if we find it.  If the
@@ -410,8 +439,7 @@ retry:
 	/* Let everybody know we've modified this slot */
 	ConditionVariableBroadcast(&slot->active_cv);
 
-	/* We made this slot active, so it's ours now. */
-	MyReplicationSlot = slot;
+	return slot;
 }
 
 /*
@@ -472,6 +500,27 @@ ReplicationSlotRelease(void)
 	LWLockRelease(ProcArrayLock);
 }
 
+/*
+ * Release a slot acquired with ReplicationSlotAcquireAdditional().
+ *
+ * Unlike ReplicationSlotRelease() this only needs the slot's spinlock, so
+ * it's safe to call while cleaning up after an error.
+ */
+void
+ReplicationSlotReleaseAdditional(ReplicationSlot *slot)
+{
+	Assert(slot != MyReplicationSlot);
+	Assert(slot->data.persistency != RS_EPHEMERAL);
+
+	if (slot->data.persistency == RS_PERSISTENT)
+	{
+		SpinLockAcquire(&slot->mutex);
+		slot->active_pid = 0;
+		SpinLockRelease(&slot->mutex);
+		ConditionVariableBroadcast(&slot->active_cv);
+	}
+}
+
 /*
  * Cleanup all temporary slots created in current session.
  */
@@ -300,6 +300,7 @@ WalSndErrorCleanup(void)
 	LWLockReleaseAll();
 	ConditionVariableCancelSleep();
 	pgstat_report_wait_end();
+	pgstat_progress_end_command();
 
 	if (sendFile >= 0)
 	{
@@ -1908,10 +1909,13 @@ PhysicalReplicationSlotNewXmin(TransactionId feedbackXmin, TransactionId feedbac
 static bool
 TransactionIdInRecentPast(TransactionId xid, uint32 epoch)
 {
+	FullTransactionId nextFullXid;
 	TransactionId nextXid;
 	uint32		nextEpoch;
 
-	GetNextXidAndEpoch(&nextXid, &nextEpoch);
+	nextFullXid = ReadNextFullTransactionId();
+	nextXid = XidFromFullTransactionId(nextFullXid);
+	nextEpoch = EpochFromFullTransactionId(nextFullXid);
 
 	if (xid <= nextXid)
 	{
@@ -2342,8 +2346,8 @@ WalSndKill(int code, Datum arg)
 /*
  * Read 'count' bytes from WAL into 'buf', starting at location 'startptr'
  *
- * XXX probably this should be improved to suck data directly from the
- * WAL buffers when possible.
+ * WAL that's still in the WAL buffers is copied from there; only the rest
+ * is read from the WAL files.
  *
  * Will open, and keep open, one WAL segment stored in the global file
  * descriptor sendFile. This means if XLogRead is used once, there will
@@ -2358,6 +2362,26 @@ XLogRead(char *buf, XLogRecPtr startptr, Size count)
 	Size		nbytes;
 	XLogSegNo	segno;
 
+	/*
+	 * Recently written WAL is usually still in the WAL buffers, which saves
+	 * every walsender re-reading it from the file just written.  Callers
+	 * only rely on the part of what they ask for that has been flushed, as
+	 * XLogReadFromBuffers() requires; logical decoding reads whole pages, but
+	 * beyond the flush position those are garbage in the files as well.
+	 */
+	if (!sendTimeLineIsHistoric)
+	{
+		Size		nread;
+
+		nread = XLogReadFromBuffers(buf, startptr, count, sendTimeLine);
+		buf += nread;
+		startptr += nread;
+		count -= nread;
+
+		if (count == 0)
+			return;
+	}
+
 retry:
 	p = buf;
 	recptr = startptr;
@@ -0,0 +1,1278 @@
+/*-------------------------------------------------------------------------
+ *
+ * mcv.c
+ *	  POSTGRES multivariate MCV lists
+ *
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *	  src/backend/statistics/mcv.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include <math.h>
+
+#include "access/htup_details.h"
+#include "access/sysattr.h"
+#include "catalog/pg_collation.h"
+#include "catalog/pg_statistic_ext.h"
+#include "fmgr.h"
+#include "funcapi.h"
+#include "miscadmin.h"
+#include "nodes/nodeFuncs.h"
+#include "optimizer/clauses.h"
+#include "optimizer/cost.h"
+#include "parser/parsetree.h"
+#include "statistics/extended_stats_internal.h"
+#include "statistics/statistics.h"
+#include "utils/acl.h"
+#include "utils/array.h"
+#include "utils/builtins.h"
+#include "utils/bytea.h"
+#include "utils/fmgroids.h"
+#include "utils/fmgrprotos.h"
+#include "utils/lsyscache.h"
+#include "utils/selfuncs.h"
+#include "utils/syscache.h"
+#include "utils/typcache.h"
+
+/*
+ * Serialized MCV list, as stored in pg_statistic_ext.stxmcv:
+ *
+ * - varlena header
+ * - magic, type and number of items (uint32 each)
+ * - number of dimensions (AttrNumber)
+ * - type OIDs of the dimensions (Oid each)
+ * - the items, each with
+ *	 - frequency and base frequency (double each)
+ *	 - NULL flags of the dimensions (bool each)
+ *	 - the non-NULL values, one after another
+ *
+ * A value of a fixed-length type occupies typlen bytes, a varlena value is
+ * stored detoasted including its (4-byte) header, and a cstring value
+ * includes its terminating zero byte.  Nothing is aligned, so values are
+ * always copied out with memcpy.
+ */
+#define SizeOfMCVListHeader(ndims) \
+	(3 * sizeof(uint32) + sizeof(AttrNumber) + (ndims) * sizeof(Oid))
+
+#define SizeOfMCVItemHeader(ndims) \
+	(2 * sizeof(double) + (ndims) * sizeof(bool))
+
+/*
+ * A clause that mcv_clauselist_selectivity() knows how to check against the
+ * items of an MCV list: either "Var op Const" (or "Const op Var"), or a
+ * NullTest on a Var.
+ */
+typedef struct MCVClause
+{
+	int			dim;			/* dimension of the Var in the MCV list */
+	bool		is_nulltest;	/* NullTest, rather than an OpExpr? */
+	NullTestType nulltesttype;	/* for NullTest */
+	bool		varonleft;		/* for OpExpr: is the Var the left argument? */
+	FmgrInfo	opproc;			/* for OpExpr: operator's function */
+	Oid			collid;			/* for OpExpr: input collation */
+	Datum		constval;		/* for OpExpr: the constant */
+	bool		constisnull;
+} MCVClause;
+
+static double get_mincount_for_mcv_list(int samplerows, double totalrows);
+static SortItem *build_distinct_groups(int numrows, SortItem *items,
+					  MultiSortSupport mss, int *ndistinct,
+					  int **groupcounts);
+static int	compare_group_counts(const void *a, const void *b, void *arg);
+static double *compute_base_frequencies(MCVList *mcvlist, int numrows,
+						 SortItem *items, MultiSortSupport mss);
+static Size datum_serialized_size(Datum value, int typlen);
+static char *datum_serialize(char *ptr, Datum value, bool typbyval,
+				int typlen);
+static char *datum_deserialize(char *ptr, char *endptr, Datum *value,
+				  bool typbyval, int typlen);
+static bool mcv_is_compatible_clause(PlannerInfo *root, Node *clause,
+						 Index relid, AttrNumber *attnum);
+static bool mcv_item_matches(MCVItem *item, MCVClause *clauses, int nclauses);
+
+
+/*
+ * get_mincount_for_mcv_list
+ *		Determine the minimum number of times a combination of values needs
+ *		to appear in the sample for it to be included in the MCV list.
+ *
+ * We want to keep only combinations that appear "much more often" than
+ * others, just like the per-column MCV lists do (see analyze_mcv_list in
+ * analyze.c).  The threshold is chosen so that the relative standard error
+ * of the frequency estimate of an item is at most 20%, assuming the number
+ * of times it appears in the sample follows a hypergeometric distribution.
+ * Frequencies estimated less accurately than that are not much better than
+ * what the per-column statistics give us.
+ */
+static double
+get_mincount_for_mcv_list(int samplerows, double totalrows)
+{
+	double		n = samplerows;
+	double		N = totalrows;
+	double		numer,
+				denom;
+
+	numer = n * (N - n);
+	denom = N - n + 0.04 * n * (N - 1);
+
+	/* Guard against division by zero (possible if n = N = 1) */
+	if (denom == 0.0)
+		return 0.0;
+
+	return numer / denom;
+}
+
+/*
+ * build_distinct_groups
+ *		Sort the items and collapse them into groups of identical values.
+ *
+ * Returns an array of the distinct items (pointing into the input data),
+ * sorted by decreasing number of occurrences, with the counts returned in
+ * *groupcounts.  On return, the input array is left sorted according to
+ * 'mss'.
+ */
+static SortItem *
+build_distinct_groups(int numrows, SortItem *items, MultiSortSupport mss,
+					  int *ndistinct, int **groupcounts)
+{
+	SortItem   *groups;
+	int		   *counts;
+	int		   *order;
+	SortItem   *result;
+	int		   *result_counts;
+	int			ngroups;
+	int			i;
+
+	qsort_arg((void *) items, numrows, sizeof(SortItem),
+			  multi_sort_compare, mss);
+
+	groups = (SortItem *) palloc(numrows * sizeof(SortItem));
+	counts = (int *) palloc(numrows * sizeof(int));
+
+	ngroups = 0;
+	for (i = 0; i < numrows; i++)
+	{
+		if (ngroups > 0 &&
+			multi_sort_compare(&items[i], &groups[ngroups - 1], mss) == 0)
+		{
+			counts[ngroups - 1]++;
+			continue;
+		}
+
+		groups[ngroups] = items[i];
+		counts[ngroups] = 1;
+		ngroups++;
+	}
+
+	/* order the groups by decreasing count */
+	order = (int *) palloc(ngroups * sizeof(int));
+	for (i = 0; i < ngroups; i++)
+		order[i] = i;
+
+	qsort_arg((void *) order, ngroups, sizeof(int),
+			  compare_group_counts, counts);
+
+	result = (SortItem *) palloc(ngroups * sizeof(SortItem));
+	result_counts = (int *) palloc(ngroups * sizeof(int));
+	for (i = 0; i < ngroups; i++)
+	{
+		result[i] = groups[order[i]];
+		result_counts[i] = counts[order[i]];
+	}
+
+	pfree(order);
+	pfree(counts);
+	pfree(groups);
+
+	*ndistinct = ngroups;
+	*groupcounts = result_counts;
+
+	return result;
+}
+
+/* qsort_arg comparator ordering group indexes by decreasing count */
+static int
+compare_group_counts(const void *a, const void *b, void *arg)
+{
+	int		   *counts = (int *) arg;
+	int			ca = counts[*(const int *) a];
+	int			cb = counts[*(const int *) b];
+
+	if (ca > cb)
+		return -1;
+	if (ca < cb)
+		return 1;
+
+	/* keep the sort deterministic */
+	return (*(const int *) a) - (*(const int *) b);
+}
+
+/*
+ * compute_base_frequencies
+ *		Compute the frequency each MCV item would have if the columns were
+ *		independent, i.e. the product of the per-column frequencies of its
+ *		values in the sample.
+ *
+ * For each dimension we sort the sample by just that column, count the
+ * distinct values, and look up each item's value in the result.
+ */
+static double *
+compute_base_frequencies(MCVList *mcvlist, int numrows, SortItem *items,
+						 MultiSortSupport mss)
+{
+	int			ndims = mcvlist->ndimensions;
+	double	   *result;
+	int			i,
+				dim;
+
+	result = (double *) palloc(mcvlist->nitems * sizeof(double));
+	for (i = 0; i < mcvlist->nitems; i++)
+		result[i] = 1.0;
+
+	for (dim = 0; dim < ndims; dim++)
+	{
+		MultiSortSupport tmp;
+		SortItem   *values;
+		SortItem   *distinct;
+		int		   *counts;
+		int			ndistinct;
+
+		/* a single-dimension sort, using this dimension's sort support */
+		tmp = (MultiSortSupport) palloc0(offsetof(MultiSortSupportData, ssup)
+										 + sizeof(SortSupportData));
+		tmp->ndims = 1;
+		memcpy(&tmp->ssup[0], &mss->ssup[dim], sizeof(SortSupportData));
+
+		values = (SortItem *) palloc(numrows * sizeof(SortItem));
+		for (i = 0; i < numrows; i++)
+		{
+			values[i].values = &items[i].values[dim];
+			values[i].isnull = &items[i].isnull[dim];
+		}
+
+		qsort_arg((void *) values, numrows, sizeof(SortItem),
+				  multi_sort_compare, tmp);
+
+		/* collapse into distinct values, keeping them sorted */
+		distinct = (SortItem *) palloc(numrows * sizeof(SortItem));
+		counts = (int *) palloc(numrows * sizeof(int));
+		ndistinct = 0;
+		for (i = 0; i < numrows; i++)
+		{
+			if (ndistinct > 0 &&
+				multi_sort_compare(&values[i], &distinct[ndistinct - 1],
+								   tmp) == 0)
+			{
+				counts[ndistinct - 1]++;
+				continue;
+			}
+
+			distinct[ndistinct] = values[i];
+			counts[ndistinct] = 1;
+			ndistinct++;
+		}
+
+		/* binary search for the value of each item */
+		for (i = 0; i < mcvlist->nitems; i++)
+		{
+			MCVItem    *item = mcvlist->items[i];
+			SortItem	key;
+			int			lo = 0,
+						hi = ndistinct - 1;
+
+			key.values = &item->values[dim];
+			key.isnull = &item->isnull[dim];
+
+			while (lo <= hi)
+			{
+				int			mid = lo + (hi - lo) / 2;
+				int			cmp = multi_sort_compare(&key, &distinct[mid], tmp);
+
+				if (cmp == 0)
+				{
+					result[i] *= (double) counts[mid] / numrows;
+					break;
+				}
+				else if (cmp < 0)
+					hi = mid - 1;
+				else
+					lo = mid + 1;
+			}
+
+			/* every item was built from the sample, so it must be found */
+			Assert(lo <= hi);
+		}
+
+		pfree(counts);
+		pfree(distinct);
+		pfree(values);
+		pfree(tmp);
+	}
+
+	return result;
+}
+
+/*
+ * statext_mcv_build
+ *		Build the MCV list on the given columns from the sample rows.
+ *
+ * The list contains the most common combinations of values, with their
+ * frequencies in the sample.  Its size is limited by the statistics target
+ * of the columns, and combinations that are not frequent enough for their
+ * frequency to be estimated reliably are left out.  If the combinations
+ * don't appear any more often than each other, or the sample contains no
+ * frequent combinations at all, NULL is returned.
+ */
+MCVList *
+statext_mcv_build(int numrows, HeapTuple *rows, Bitmapset *attrs,
+				  VacAttrStats **stats, double totalrows)
+{
+	int			ndims = bms_num_members(attrs);
+	int			stattarget = 0;
+	int		   *attnums;
+	MultiSortSupport mss;
+	SortItem   *items;
+	Datum	   *values;
+	bool	   *isnull;
+	SortItem   *groups;
+	int		   *counts;
+	int			ngroups;
+	int			nitems;
+	double	   *basefreqs;
+	MCVList    *mcvlist;
+	int			i,
+				j;
+
+	if (numrows == 0)
+		return NULL;
+
+	/* transform the bms into an array, to make accessing i-th member easier */
+	attnums = (int *) palloc(sizeof(int) * ndims);
+	i = 0;
+	j = -1;
+	while ((j = bms_next_member(attrs, j)) >= 0)
+		attnums[i++] = j;
+
+	mss = multi_sort_init(ndims);
+
+	items = (SortItem *) palloc(numrows * sizeof(SortItem));
+	values = (Datum *) palloc(sizeof(Datum) * numrows * ndims);
+	isnull = (bool *) palloc(sizeof(bool) * numrows * ndims);
+
+	for (i = 0; i < numrows; i++)
+	{
+		items[i].values = &values[i * ndims];
+		items[i].isnull = &isnull[i * ndims];
+	}
+
+	for (i = 0; i < ndims; i++)
+	{
+		VacAttrStats *colstat = stats[i];
+		TypeCacheEntry *type;
+
+		type = lookup_type_cache(colstat->attrtypid, TYPECACHE_LT_OPR);
+		if (type->lt_opr == InvalidOid) /* shouldn't happen */
+			elog(ERROR, "cache lookup failed for ordering operator for type %u",
+				 colstat->attrtypid);
+
+		multi_sort_add_dimension(mss, i, type->lt_opr, type->typcollation);
+
+		for (j = 0; j < numrows; j++)
+			items[j].values[i] = heap_getattr(rows[j], attnums[i],
+											  colstat->tupDesc,
+											  &items[j].isnull[i]);
+
+		/* the list may be as long as the largest target of the columns */
+		stattarget = Max(stattarget, colstat->attr->attstattarget);
+	}
+
+	stattarget = Min(stattarget, STATS_MCVLIST_MAX_ITEMS);
+	if (stattarget <= 0)
+		return NULL;
+
+	groups = build_distinct_groups(numrows, items, mss, &ngroups, &counts);
+
+	/*
+	 * If all the combinations fit into the list, keep them all: the list then
+	 * describes the sample exactly.  Otherwise keep only those appearing
+	 * often enough (the groups are sorted by decreasing count).
+	 */
+	nitems = Min(ngroups, stattarget);
+	if (ngroups > nitems)
+	{
+		double		mincount = get_mincount_for_mcv_list(numrows, totalrows);
+
+		for (i = 0; i < nitems; i++)
+		{
+			if (counts[i] < mincount)
+			{
+				nitems = i;
+				break;
+			}
+		}
+	}
+
+	if (nitems == 0)
+		return NULL;
+
+	mcvlist = (MCVList *) palloc0(offsetof(MCVList, items) +
+								  sizeof(MCVItem *) * nitems);
+
+	mcvlist->magic = STATS_MCV_MAGIC;
+	mcvlist->type = STATS_MCV_TYPE_BASIC;
+	mcvlist->nitems = nitems;
+	mcvlist->ndimensions = ndims;
+	for (i = 0; i < ndims; i++)
+		mcvlist->types[i] = stats[i]->attrtypid;
+
+	for (i = 0; i < nitems; i++)
+	{
+		MCVItem    *item = (MCVItem *) palloc(sizeof(MCVItem));
+
+		item->values = (Datum *) palloc(sizeof(Datum) * ndims);
+		item->isnull = (bool *) palloc(sizeof(bool) * ndims);
+		memcpy(item->values, groups[i].values, sizeof(Datum) * ndims);
+		memcpy(item->isnull, groups[i].isnull, sizeof(bool) * ndims);
+		item->frequency = (double) counts[i] / numrows;
+
+		mcvlist->items[i] = item;
+	}
+
+	basefreqs = compute_base_frequencies(mcvlist, numrows, items, mss);
+	for (i = 0; i < nitems; i++)
+		mcvlist->items[i]->base_frequency = basefreqs[i];
+
+	pfree(basefreqs);
+	pfree(counts);
+	pfree(groups);
+	pfree(attnums);
+
+	return mcvlist;
+}
+
+/*
+ * datum_serialized_size
+ *		Number of bytes datum_serialize() needs for a non-NULL value.
+ */
+static Size
+datum_serialized_size(Datum value, int typlen)
+{
+	if (typlen > 0)
+		return typlen;
+	else if (typlen == -1)
+	{
+		struct varlena *v = PG_DETOAST_DATUM(value);
+		Size		len = VARSIZE(v);
+
+		if ((Pointer) v != DatumGetPointer(value))
+			pfree(v);
+		return len;
+	}
+
+	Assert(typlen == -2);
+	return strlen(DatumGetCString(value)) + 1;
+}
+
+/* Serialize a non-NULL value at 'ptr', returning the end of it */
+static char *
+datum_serialize(char *ptr, Datum value, bool typbyval, int typlen)
+{
+	if (typbyval)
+	{
+		Assert(typlen > 0 && typlen <= sizeof(Datum));
+		store_att_byval(ptr, value, typlen);
+		return ptr + typlen;
+	}
+	else if (typlen > 0)
+	{
+		memcpy(ptr, DatumGetPointer(value), typlen);
+		return ptr + typlen;
+	}
+	else if (typlen == -1)
+	{
+		struct varlena *v = PG_DETOAST_DATUM(value);
+		Size		len = VARSIZE(v);
+
+		memcpy(ptr, v, len);
+		if ((Pointer) v != DatumGetPointer(value))
+			pfree(v);
+		return ptr + len;
+	}
+	else
+	{
+		Size		len = strlen(DatumGetCString(value)) + 1;
+
+		Assert(typlen == -2);
+		memcpy(ptr, DatumGetPointer(value), len);
+		return ptr + len;
+	}
+}
+
+/*
+ * Deserialize a value stored at 'ptr', returning the end of it.  Values of
+ * pass-by-reference types are copied into palloc'd memory.
+ */
+static char *
+datum_deserialize(char *ptr, char *endptr, Datum *value, bool typbyval,
+				  int typlen)
+{
+	Size		len;
+
+	if (typlen > 0)
+		len = typlen;
+	else if (typlen == -1)
+	{
+		uint32		hdr;
+
+		if (ptr + VARHDRSZ > endptr)
+			elog(ERROR, "invalid MCV list: value extends past the end");
+		memcpy(&hdr, ptr, VARHDRSZ);
+		len = VARSIZE(&hdr);
+		if (len < VARHDRSZ)
+			elog(ERROR, "invalid MCV list: invalid value length");
+	}
+	else
+	{
+		char	   *end = memchr(ptr, '\0', endptr - ptr);
+
+		Assert(typlen == -2);
+		if (end == NULL)
+			elog(ERROR, "invalid MCV list: value extends past the end");
+		len = end - ptr + 1;
+	}
+
+	if (ptr + len > endptr)
+		elog(ERROR, "invalid MCV list: value extends past the end");
+
+	if (typbyval)
+	{
+		Datum		v = 0;
+
+		/* fetch_att needs an aligned pointer, so copy the value first */
+		memcpy(&v, ptr, len);
+		*value = fetch_att(&v, true, typlen);
+	}
+	else
+	{
+		char	   *copy = palloc(len);
+
+		memcpy(copy, ptr, len);
+		*value = PointerGetDatum(copy);
+	}
+
+	return ptr + len;
+}
+
+/*
+ * statext_mcv_serialize
+ *		Serialize an MCV list into a bytea value (see the format description
+ *		at the top of the file).
+ */
+bytea *
+statext_mcv_serialize(MCVList *mcvlist, VacAttrStats **stats)
+{
+	int			ndims = mcvlist->ndimensions;
+	Size		len;
+	bytea	   *output;
+	char	   *ptr;
+	int			i,
+				dim;
+
+	/* compute the total size first */
+	len = VARHDRSZ + SizeOfMCVListHeader(ndims);
+	for (i = 0; i < mcvlist->nitems; i++)
+	{
+		MCVItem    *item = mcvlist->items[i];
+
+		len += SizeOfMCVItemHeader(ndims);
+		for (dim = 0; dim < ndims; dim++)
+		{
+			if (!item->isnull[dim])
+				len += datum_serialized_size(item->values[dim],
+											 stats[dim]->attrtype->typlen);
+		}
+	}
+
+	output = (bytea *) palloc0(len);
+	SET_VARSIZE(output, len);
+
+	ptr = VARDATA(output);
+
+	memcpy(ptr, &mcvlist->magic, sizeof(uint32));
+	ptr += sizeof(uint32);
+	memcpy(ptr, &mcvlist->type, sizeof(uint32));
+	ptr += sizeof(uint32);
+	memcpy(ptr, &mcvlist->nitems, sizeof(uint32));
+	ptr += sizeof(uint32);
+	memcpy(ptr, &mcvlist->ndimensions, sizeof(AttrNumber));
+	ptr += sizeof(AttrNumber);
+	memcpy(ptr, mcvlist->types, sizeof(Oid) * ndims);
+	ptr += sizeof(Oid) * ndims;
+
+	for (i = 0; i < mcvlist->nitems; i++)
+	{
+		MCVItem    *item = mcvlist->items[i];
+
+		memcpy(ptr, &item->frequency, sizeof(double));
+		ptr += sizeof(double);
+		memcpy(ptr, &item->base_frequency, sizeof(double));
+		ptr += sizeof(double);
+		memcpy(ptr, item->isnull, sizeof(bool) * ndims);
+		ptr += sizeof(bool) * ndims;
+
+		for (dim = 0; dim < ndims; dim++)
+		{
+			if (item->isnull[dim])
+				continue;
+
+			ptr = datum_serialize(ptr, item->values[dim],
+								  stats[dim]->attrtype->typbyval,
+								  stats[dim]->attrtype->typlen);
+		}
+	}
+
+	Assert(ptr == (char *) output + len);
+
+	return output;
+}
+
+/*
+ * statext_mcv_deserialize
+ *		Reads a serialized MCV list back into an MCVList.
+ */
+MCVList *
+statext_mcv_deserialize(bytea *data)
+{
+	uint32		magic;
+	uint32		type;
+	uint32		nitems;
+	AttrNumber	ndims;
+	MCVList    *mcvlist;
+	char	   *ptr;
+	char	   *endptr;
+	int16		typlen[STATS_MAX_DIMENSIONS];
+	bool		typbyval[STATS_MAX_DIMENSIONS];
+	int			i,
+				dim;
+
+	if (data == NULL)
+		return NULL;
+
+	ptr = VARDATA_ANY(data);
+	endptr = ptr + VARSIZE_ANY_EXHDR(data);
+
+	if (endptr - ptr < SizeOfMCVListHeader(0))
+		elog(ERROR, "invalid MCV list size %d (expected at least %d)",
+			 (int) (endptr - ptr), (int) SizeOfMCVListHeader(0));
+
+	memcpy(&magic, ptr, sizeof(uint32));
+	ptr += sizeof(uint32);
+	memcpy(&type, ptr, sizeof(uint32));
+	ptr += sizeof(uint32);
+	memcpy(&nitems, ptr, sizeof(uint32));
+	ptr += sizeof(uint32);
+	memcpy(&ndims, ptr, sizeof(AttrNumber));
+	ptr += sizeof(AttrNumber);
+
+	if (magic != STATS_MCV_MAGIC)
+		elog(ERROR, "invalid MCV magic %u (expected %u)",
+			 magic, STATS_MCV_MAGIC);
+	if (type != STATS_MCV_TYPE_BASIC)
+		elog(ERROR, "invalid MCV type %u (expected %u)",
+			 type, STATS_MCV_TYPE_BASIC);
+	if (nitems == 0 || nitems > STATS_MCVLIST_MAX_ITEMS)
+		elog(ERROR, "invalid number of items in MCV list: %u", nitems);
+	if (ndims < 2 || ndims > STATS_MAX_DIMENSIONS)
+		elog(ERROR, "invalid number of dimensions in MCV list: %d", ndims);
+
+	if (endptr - ptr < sizeof(Oid) * ndims)
+		elog(ERROR, "invalid MCV list: truncated header");
+
+	mcvlist = (MCVList *) palloc0(offsetof(MCVList, items) +
+								  sizeof(MCVItem *) * nitems);
+	mcvlist->magic = magic;
+	mcvlist->type = type;
+	mcvlist->nitems = nitems;
+	mcvlist->ndimensions = ndims;
+
+	memcpy(mcvlist->types, ptr, sizeof(Oid) * ndims);
+	ptr += sizeof(Oid) * ndims;
+
+	for (dim = 0; dim < ndims; dim++)
+		get_typlenbyval(mcvlist->types[dim], &typlen[dim], &typbyval[dim]);
+
+	for (i = 0; i < mcvlist->nitems; i++)
+	{
+		MCVItem    *item = (MCVItem *) palloc(sizeof(MCVItem));
+
+		if (endptr - ptr < SizeOfMCVItemHeader(ndims))
+			elog(ERROR, "invalid MCV list: item extends past the end");
+
+		item->values = (Datum *) palloc0(sizeof(Datum) * ndims);
+		item->isnull = (bool *) palloc(sizeof(bool) * ndims);
+
+		memcpy(&item->frequency, ptr, sizeof(double));
+		ptr += sizeof(double);
+		memcpy(&item->base_frequency, ptr, sizeof(double));
+		ptr += sizeof(double);
+		memcpy(item->isnull, ptr, sizeof(bool) * ndims);
+		ptr += sizeof(bool) * ndims;
+
+		for (dim = 0; dim < ndims; dim++)
+		{
+			if (item->isnull[dim])
+				continue;
+
+			ptr = datum_deserialize(ptr, endptr, &item->values[dim],
+									typbyval[dim], typlen[dim]);
+		}
+
+		mcvlist->items[i] = item;
+	}
+
+	if (ptr != endptr)
+		elog(ERROR, "invalid MCV list: unexpected trailing data");
+
+	return mcvlist;
+}
+
+/*
+ * statext_mcv_load
+ *		Load the MCV list for the indicated pg_statistic_ext tuple
+ */
+MCVList *
+statext_mcv_load(Oid mvoid)
+{
+	MCVList    *result;
+	bool		isnull;
+	Datum		mcvlist;
+	HeapTuple	htup;
+
+	htup = SearchSysCache1(STATEXTOID, ObjectIdGetDatum(mvoid));
+	if (!HeapTupleIsValid(htup))
+		elog(ERROR, "cache lookup failed for statistics object %u", mvoid);
+
+	mcvlist = SysCacheGetAttr(STATEXTOID, htup,
+							  Anum_pg_statistic_ext_stxmcv, &isnull);
+	if (isnull)
+		elog(ERROR,
+			 "requested statistic kind \"%c\" is not yet built for statistics object %u",
+			 STATS_EXT_MCV, mvoid);
+
+	result = statext_mcv_deserialize(DatumGetByteaPP(mcvlist));
+
+	ReleaseSysCache(htup);
+
+	return result;
+}
+
+/*
+ * pg_mcv_list_in		- input routine for type pg_mcv_list.
+ *
+ * pg_mcv_list is real enough to be a table column, but it has no operations
+ * of its own, and disallows input too
+ */
+Datum
+pg_mcv_list_in(PG_FUNCTION_ARGS)
+{
+	/*
+	 * pg_mcv_list stores the data in binary form and parsing text input is
+	 * not needed, so disallow this.
+	 */
+	ereport(ERROR,
+			(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+			 errmsg("cannot accept a value of type %s", "pg_mcv_list")));
+
+	PG_RETURN_VOID();			/* keep compiler quiet */
+}
+
+/*
+ * pg_mcv_list_out		- output routine for type pg_mcv_list.
+ *
+ * MCV lists are serialized into a bytea value, so we simply call byteaout()
+ * to produce their text representation.  Use pg_mcv_list_items() to look at
+ * the individual items.
+ */
+Datum
+pg_mcv_list_out(PG_FUNCTION_ARGS)
+{
+	return byteaout(fcinfo);
+}
+
+/*
+ * pg_mcv_list_recv		- binary input routine for type pg_mcv_list.
+ */
+Datum
+pg_mcv_list_recv(PG_FUNCTION_ARGS)
+{
+	ereport(ERROR,
+			(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+			 errmsg("cannot accept a value of type %s", "pg_mcv_list")));
+
+	PG_RETURN_VOID();			/* keep compiler quiet */
+}
+
+/*
+ * pg_mcv_list_send		- binary output routine for type pg_mcv_list.
+ *
+ * MCV lists are serialized in a bytea value (although the type is named
+ * differently), so let's just send that.
+ */
+Datum
+pg_mcv_list_send(PG_FUNCTION_ARGS)
+{
+	return byteasend(fcinfo);
+}
+
+/*
+ * pg_stats_ext_mcvlist_items
+ *		SRF returning the items of an MCV list, with their values converted
+ *		to text, the NULL flags, frequency and base frequency.
+ */
+Datum
+pg_stats_ext_mcvlist_items(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *funcctx;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		MemoryContext oldcontext;
+		MCVList    *mcvlist;
+		TupleDesc	tupdesc;
+
+		funcctx = SRF_FIRSTCALL_INIT();
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		mcvlist = statext_mcv_deserialize(PG_GETARG_BYTEA_P(0));
+
+		funcctx->user_fctx = mcvlist;
+		funcctx->max_calls = mcvlist->nitems;
+
+		if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("function returning record called in context "
+							"that cannot accept type record")));
+
+		funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+
+	if (funcctx->call_cntr < funcctx->max_calls)
+	{
+		MCVList    *mcvlist = (MCVList *) funcctx->user_fctx;
+		MCVItem    *item = mcvlist->items[funcctx->call_cntr];
+		int			ndims = mcvlist->ndimensions;
+		Datum	   *textvals;
+		bool	   *textnulls;
+		Datum	   *nullvals;
+		int			dims[1];
+		int			lbs[1];
+		Datum		values[5];
+		bool		nulls[5];
+		HeapTuple	tuple;
+		int			dim;
+
+		textvals = (Datum *) palloc(sizeof(Datum) * ndims);
+		textnulls = (bool *) palloc(sizeof(bool) * ndims);
+		nullvals = (Datum *) palloc(sizeof(Datum) * ndims);
+
+		for (dim = 0; dim < ndims; dim++)
+		{
+			nullvals[dim] = BoolGetDatum(item->isnull[dim]);
+			textnulls[dim] = item->isnull[dim];
+
+			if (!item->isnull[dim])
+			{
+				Oid			outfunc;
+				bool		isvarlena;
+
+				getTypeOutputInfo(mcvlist->types[dim], &outfunc, &isvarlena);
+				textvals[dim] =
+					CStringGetTextDatum(OidOutputFunctionCall(outfunc,
+															  item->values[dim]));
+			}
+			else
+				textvals[dim] = (Datum) 0;
+		}
+
+		dims[0] = ndims;
+		lbs[0] = 1;
+
+		values[0] = Int32GetDatum(funcctx->call_cntr);
+		values[1] = PointerGetDatum(construct_md_array(textvals, textnulls,
+													   1, dims, lbs, TEXTOID,
+													   -1, false, 'i'));
+		values[2] = PointerGetDatum(construct_array(nullvals, ndims, BOOLOID,
+													1, true, 'c'));
+		values[3] = Float8GetDatum(item->frequency);
+		values[4] = Float8GetDatum(item->base_frequency);
+
+		memset(nulls, 0, sizeof(nulls));
+
+		tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+
+		SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+	}
+
+	SRF_RETURN_DONE(funcctx);
+}
+
+/*
+ * mcv_is_compatible_clause
+ *		Determines if the clause can be checked against the items of an MCV
+ *		list.
+ *
+ * Accepted are "Var op Const" and "Const op Var" clauses whose operator is
+ * estimated as equality, inequality or a range comparison, and IS [NOT] NULL
+ * tests of a Var.  The Var must be a plain user column of the specified
+ * relation, whose attribute number we return in *attnum on success.
+ *
+ * Matching a clause means evaluating its operator on values from the MCV
+ * list, which could leak them, so if the user cannot read the column we only
+ * accept leakproof operators, as examine_variable does for the per-column
+ * statistics.
+ */
+static bool
+mcv_is_compatible_clause(PlannerInfo *root, Node *clause, Index relid,
+						 AttrNumber *attnum)
+{
+	RestrictInfo *rinfo = (RestrictInfo *) clause;
+	Node	   *node;
+	Var		   *var;
+	RangeTblEntry *rte;
+	Oid			opfuncid = InvalidOid;
+
+	if (!IsA(rinfo, RestrictInfo))
+		return false;
+
+	/* Pseudoconstants are not interesting (they couldn't contain a Var) */
+	if (rinfo->pseudoconstant)
+		return false;
+
+	/* Clauses referencing multiple, or no, varnos are incompatible */
+	if (bms_membership(rinfo->clause_relids) != BMS_SINGLETON)
+		return false;
+
+	node = (Node *) rinfo->clause;
+
+	if (is_opclause(node))
+	{
+		OpExpr	   *expr = (OpExpr *) node;
+		Node	   *left,
+				   *right;
+
+		/* Only expressions with two arguments are candidates. */
+		if (list_length(expr->args) != 2)
+			return false;
+
+		left = (Node *) linitial(expr->args);
+		right = (Node *) lsecond(expr->args);
+
+		/* We need an actual value to evaluate the operator with. */
+		if (IsA(right, Const))
+			var = (Var *) left;
+		else if (IsA(left, Const))
+			var = (Var *) right;
+		else
+			return false;
+
+		switch (get_oprrest(expr->opno))
+		{
+			case F_EQSEL:
+			case F_NEQSEL:
+			case F_SCALARLTSEL:
+			case F_SCALARLESEL:
+			case F_SCALARGTSEL:
+			case F_SCALARGESEL:
+				break;
+
+			default:
+				return false;
+		}
+
+		opfuncid = get_opcode(expr->opno);
+	}
+	else if (IsA(node, NullTest))
+	{
+		NullTest   *expr = (NullTest *) node;
+
+		/* row-type tests have different semantics */
+		if (expr->argisrow)
+			return false;
+
+		var = (Var *) expr->arg;
+	}
+	else
+		return false;
+
+	/*
+	 * We may ignore any RelabelType node above the operand.  (There won't be
+	 * more than one, since eval_const_expressions has been applied already.)
+	 */
+	if (IsA(var, RelabelType))
+		var = (Var *) ((RelabelType *) var)->arg;
+
+	/* We only support plain Vars for now */
+	if (!IsA(var, Var))
+		return false;
+
+	/* Ensure Var is from the correct relation */
+	if (var->varno != relid)
+		return false;
+
+	/* We also better ensure the Var is from the current level */
+	if (var->varlevelsup != 0)
+		return false;
+
+	/* Also ignore system attributes (we don't allow stats on those) */
+	if (!AttrNumberIsForUserDefinedAttr(var->varattno))
+		return false;
+
+	/* Don't evaluate non-leakproof operators on values the user can't see */
+	if (OidIsValid(opfuncid) && !get_func_leakproof(opfuncid))
+	{
+		rte = planner_rt_fetch(relid, root);
+
+		if (pg_class_aclcheck(rte->relid, GetUserId(),
+							  ACL_SELECT) != ACLCHECK_OK &&
+			pg_attribute_aclcheck(rte->relid, var->varattno, GetUserId(),
+								  ACL_SELECT) != ACLCHECK_OK)
+			return false;
+	}
+
+	*attnum = var->varattno;
+	return true;
+}
+
+/*
+ * mcv_item_matches
+ *		Does the MCV item satisfy all the clauses?
+ */
+static bool
+mcv_item_matches(MCVItem *item, MCVClause *clauses, int nclauses)
+{
+	int			i;
+
+	for (i = 0; i < nclauses; i++)
+	{
+		MCVClause  *c = &clauses[i];
+		bool		isnull = item->isnull[c->dim];
+
+		if (c->is_nulltest)
+		{
+			if ((c->nulltesttype == IS_NULL) != isnull)
+				return false;
+			continue;
+		}
+
+		/* the operators are strict, so NULLs never match */
+		if (isnull || c->constisnull)
+			return false;
+
+		if (c->varonleft)
+		{
+			if (!DatumGetBool(FunctionCall2Coll(&c->opproc, c->collid,
+												item->values[c->dim],
+												c->constval)))
+				return false;
+		}
+		else
+		{
+			if (!DatumGetBool(FunctionCall2Coll(&c->opproc, c->collid,
+												c->constval,
+												item->values[c->dim])))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+/*
+ * mcv_clauselist_selectivity
+ *		Return the estimated selectivity of (a subset of) the given clauses
+ *		using an MCV list, or 1.0 if no useful MCV list exists.
+ *
+ * 'estimatedclauses' is an input/output argument: clauses whose (zero-based)
+ * list index is already a member are skipped, and we add the indexes of the
+ * clauses included in the estimate.
+ *
+ * The clauses are checked against each item of the MCV list of the best
+ * matching statistics object.  The items satisfying all of them give us
+ * mcv_sel, their total frequency.  For the part of the table not covered
+ * by the MCV list we fall back on the per-column estimate, from which we
+ * subtract what it assigns to the MCV items (their base frequency, i.e. the
+ * frequency they would have if the columns were independent), and which
+ * cannot exceed the fraction of rows outside the MCV list:
+ *
+ *	   other_sel = Min(simple_sel - mcv_basesel, 1 - mcv_totalsel)
+ *	   sel = mcv_sel + other_sel
+ */
+Selectivity
+mcv_clauselist_selectivity(PlannerInfo *root,
+						   List *clauses,
+						   int varRelid,
+						   JoinType jointype,
+						   SpecialJoinInfo *sjinfo,
+						   RelOptInfo *rel,
+						   Bitmapset **estimatedclauses)
+{
+	ListCell   *l;
+	Bitmapset  *clauses_attnums = NULL;
+	AttrNumber *list_attnums;
+	StatisticExtInfo *stat;
+	MCVList    *mcvlist;
+	MCVClause  *mcvclauses;
+	int			nmcvclauses;
+	List	   *stat_clauses = NIL;
+	Bitmapset  *stat_clause_idxs = NULL;
+	Selectivity simple_sel,
+				mcv_sel = 0.0,
+				mcv_basesel = 0.0,
+				mcv_totalsel = 0.0,
+				other_sel,
+				sel;
+	int			listidx;
+	int			i;
+
+	/* check if there's any stats that might be useful for us. */
+	if (!has_stats_of_kind(rel->statlist, STATS_EXT_MCV))
+		return 1.0;
+
+	list_attnums = (AttrNumber *) palloc(sizeof(AttrNumber) *
+										 list_length(clauses));
+
+	/* collect the attnums of all compatible, not yet estimated clauses */
+	listidx = 0;
+	foreach(l, clauses)
+	{
+		Node	   *clause = (Node *) lfirst(l);
+		AttrNumber	attnum;
+
+		if (!bms_is_member(listidx, *estimatedclauses) &&
+			mcv_is_compatible_clause(root, clause, rel->relid, &attnum))
+		{
+			list_attnums[listidx] = attnum;
+			clauses_attnums = bms_add_member(clauses_attnums, attnum);
+		}
+		else
+			list_attnums[listidx] = InvalidAttrNumber;
+
+		listidx++;
+	}
+
+	/* We need clauses on at least two different columns. */
+	if (bms_num_members(clauses_attnums) < 2)
+	{
+		pfree(list_attnums);
+		return 1.0;
+	}
+
+	/* find the best suited statistics object for these attnums */
+	stat = choose_best_statistics(rel->statlist, clauses_attnums,
+								  STATS_EXT_MCV);
+
+	/* if no matching stats could be found then we've nothing to do */
+	if (!stat)
+	{
+		pfree(list_attnums);
+		return 1.0;
+	}
+
+	/* prepare the clauses covered by the chosen statistics object */
+	mcvclauses = (MCVClause *) palloc0(sizeof(MCVClause) *
+									   list_length(clauses));
+	nmcvclauses = 0;
+
+	listidx = -1;
+	foreach(l, clauses)
+	{
+		RestrictInfo *rinfo = (RestrictInfo *) lfirst(l);
+		MCVClause  *c;
+		int			dim;
+		int			attnum;
+
+		listidx++;
+
+		if (list_attnums[listidx] == InvalidAttrNumber ||
+			!bms_is_member(list_attnums[listidx], stat->keys))
+			continue;
+
+		/* the dimensions are ordered by attnum */
+		dim = 0;
+		attnum = -1;
+		while ((attnum = bms_next_member(stat->keys, attnum)) >= 0 &&
+			   attnum != list_attnums[listidx])
+			dim++;
+
+		c = &mcvclauses[nmcvclauses++];
+		c->dim = dim;
+
+		if (is_opclause(rinfo->clause))
+		{
+			OpExpr	   *expr = (OpExpr *) rinfo->clause;
+			Const	   *cst;
+
+			c->varonleft = !IsA(linitial(expr->args), Const);
+			cst = (Const *) (c->varonleft ? lsecond(expr->args) :
+							 linitial(expr->args));
+			fmgr_info(get_opcode(expr->opno), &c->opproc);
+			c->collid = expr->inputcollid;
+			c->constval = cst->constvalue;
+			c->constisnull = cst->constisnull;
+		}
+		else
+		{
+			c->is_nulltest = true;
+			c->nulltesttype = ((NullTest *) rinfo->clause)->nulltesttype;
+		}
+
+		stat_clauses = lappend(stat_clauses, rinfo);
+		stat_clause_idxs = bms_add_member(stat_clause_idxs, listidx);
+	}
+
+	mcvlist = statext_mcv_load(stat->statOid);
+
+	for (i = 0; i < mcvlist->nitems; i++)
+	{
+		MCVItem    *item = mcvlist->items[i];
+
+		mcv_totalsel += item->frequency;
+
+		if (mcv_item_matches(item, mcvclauses, nmcvclauses))
+		{
+			mcv_sel += item->frequency;
+			mcv_basesel += item->base_frequency;
+		}
+	}
+
+	/* the per-column estimate, assuming the columns are independent */
+	simple_sel = clauselist_selectivity_simple(root, stat_clauses, varRelid,
+											   jointype, sjinfo, NULL);
+
+	other_sel = simple_sel - mcv_basesel;
+	CLAMP_PROBABILITY(other_sel);
+	if (other_sel > 1.0 - mcv_totalsel)
+		other_sel = 1.0 - mcv_totalsel;
+
+	sel = mcv_sel + other_sel;
+	CLAMP_PROBABILITY(sel);
+
+	*estimatedclauses = bms_add_members(*estimatedclauses, stat_clause_idxs);
+
+	list_free(stat_clauses);
+	pfree(mcvclauses);
+	pfree(list_attnums);
+
+	return sel;
+}
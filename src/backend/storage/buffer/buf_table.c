@@ -23,17 +23,66 @@
 
 #include "storage/bufmgr.h"
 #include "storage/buf_internals.h"
+#include "storage/shmem.h"
+#include "utils/hsearch.h"
 
 
-/* entry for buffer lookup hashtable */
+/*
+ * The mapping table is an open-addressing hash table with linear probing,
+ * split into NUM_BUFFER_PARTITIONS independent regions, one per
+ * BufMappingLock partition.  A tag is stored in the region of its hash code's
+ * partition, so a lookup or update only ever touches slots protected by the
+ * partition lock the caller holds.  Compared to a dynahash table, this avoids
+ * chasing bucket chain pointers through shared memory on every lookup.
+ *
+ * Each region has room for twice its fair share of entries, plus some slack
+ * for small tables, which keeps the probe sequences short and makes it
+ * vanishingly unlikely for a region to fill up, even though the partitions'
+ * loads vary.  If one does, we report running out of shared memory, like
+ * dynahash would.
+ */
 typedef struct
 {
 	BufferTag	key;			/* Tag of a disk page */
-	int			id;				/* Associated buffer ID */
+	uint32		hashcode;		/* hash code of key */
+	int			id;				/* Associated buffer ID, or -1 if unused */
 } BufferLookupEnt;
 
-static HTAB *SharedBufHash;
+#define BUF_TABLE_SLACK		64
+
+static BufferLookupEnt *SharedBufTable;
+static int *SharedBufTableUsed;	/* number of entries in each region */
+static uint32 SharedBufTableRegionSize;
+
+static uint32
+BufTableRegionSize(int size)
+{
+	return 2 * (size / NUM_BUFFER_PARTITIONS + 1) + BUF_TABLE_SLACK;
+}
+
+/*
+ * Return the index of the region of the table for 'hashcode', and the slot
+ * within that region where probing for it starts.
+ *
+ * The partition number is taken from the low-order bits of the hash code,
+ * so we use the remaining ones to pick the slot, scaled to the region size
+ * by multiplication instead of a modulo.
+ */
+static inline BufferLookupEnt *
+BufTableRegion(uint32 hashcode)
+{
+	return SharedBufTable +
+		(Size) BufTableHashPartition(hashcode) * SharedBufTableRegionSize;
+}
+
+static inline uint32
+BufTableHomeSlot(uint32 hashcode)
+{
+	uint64		rest = hashcode / NUM_BUFFER_PARTITIONS;
 
+	return (uint32) ((rest * SharedBufTableRegionSize) /
+					 ((UINT64CONST(1) << 32) / NUM_BUFFER_PARTITIONS));
+}
 
 /*
  * Estimate space needed for mapping hashtable
@@ -42,7 +91,13 @@ static HTAB *SharedBufHash;
 Size
 BufTableShmemSize(int size)
 {
-	return hash_estimate_size(size, sizeof(BufferLookupEnt));
+	Size		sz;
+
+	sz = mul_size(mul_size(BufTableRegionSize(size), NUM_BUFFER_PARTITIONS),
+				  sizeof(BufferLookupEnt));
+	sz = add_size(sz, mul_size(NUM_BUFFER_PARTITIONS, sizeof(int)));
+
+	return sz;
 }
 
 /*
@@ -52,19 +107,27 @@ BufTableShmemSize(int size)
 void
 InitBufTable(int size)
 {
-	HASHCTL		info;
+	Size		nslots;
+	bool		found;
 
 	/* assume no locking is needed yet */
 
-	/* BufferTag maps to Buffer */
-	info.keysize = sizeof(BufferTag);
-	info.entrysize = sizeof(BufferLookupEnt);
-	info.num_partitions = NUM_BUFFER_PARTITIONS;
+	SharedBufTableRegionSize = BufTableRegionSize(size);
+	nslots = (Size) SharedBufTableRegionSize * NUM_BUFFER_PARTITIONS;
 
-	SharedBufHash = ShmemInitHash("Shared Buffer Lookup Table",
-								  size, size,
-								  &info,
-								  HASH_ELEM | HASH_BLOBS | HASH_PARTITION);
+	SharedBufTable = (BufferLookupEnt *)
+		ShmemInitStruct("Shared Buffer Lookup Table",
+						BufTableShmemSize(size), &found);
+	SharedBufTableUsed = (int *) (SharedBufTable + nslots);
+
+	if (!found)
+	{
+		Size		i;
+
+		for (i = 0; i < nslots; i++)
+			SharedBufTable[i].id = -1;
+		memset(SharedBufTableUsed, 0, NUM_BUFFER_PARTITIONS * sizeof(int));
+	}
 }
 
 /*
@@ -74,12 +137,12 @@ InitBufTable(int size)
  * This must be passed to the lookup/insert/delete routines along with the
  * tag.  We do it like this because the callers need to know the hash code
  * in order to determine which buffer partition to lock, and we don't want
- * to do the hash computation twice (hash_any is a bit slow).
+ * to do the hash computation twice.
  */
 uint32
 BufTableHashCode(BufferTag *tagPtr)
 {
-	return get_hash_value(SharedBufHash, (void *) tagPtr);
+	return tag_hash((void *) tagPtr, sizeof(BufferTag));
 }
 
 /*
@@ -91,19 +154,21 @@ BufTableHashCode(BufferTag *tagPtr)
 int
 BufTableLookup(BufferTag *tagPtr, uint32 hashcode)
 {
-	BufferLookupEnt *result;
+	BufferLookupEnt *region = BufTableRegion(hashcode);
+	uint32		slot = BufTableHomeSlot(hashcode);
 
-	result = (BufferLookupEnt *)
-		hash_search_with_hash_value(SharedBufHash,
-									(void *) tagPtr,
-									hashcode,
-									HASH_FIND,
-									NULL);
+	for (;;)
+	{
+		BufferLookupEnt *ent = &region[slot];
 
-	if (!result)
-		return -1;
+		if (ent->id < 0)
+			return -1;
+		if (ent->hashcode == hashcode && BUFFERTAGS_EQUAL(ent->key, *tagPtr))
+			return ent->id;
 
-	return result->id;
+		if (++slot == SharedBufTableRegionSize)
+			slot = 0;
+	}
 }
 
 /*
@@ -119,23 +184,37 @@ BufTableLookup(BufferTag *tagPtr, uint32 hashcode)
 int
 BufTableInsert(BufferTag *tagPtr, uint32 hashcode, int buf_id)
 {
-	BufferLookupEnt *result;
-	bool		found;
+	BufferLookupEnt *region = BufTableRegion(hashcode);
+	int		   *used = &SharedBufTableUsed[BufTableHashPartition(hashcode)];
+	uint32		slot = BufTableHomeSlot(hashcode);
+	BufferLookupEnt *ent;
 
 	Assert(buf_id >= 0);		/* -1 is reserved for not-in-table */
 	Assert(tagPtr->blockNum != P_NEW);	/* invalid tag */
 
-	result = (BufferLookupEnt *)
-		hash_search_with_hash_value(SharedBufHash,
-									(void *) tagPtr,
-									hashcode,
-									HASH_ENTER,
-									&found);
+	for (;;)
+	{
+		ent = &region[slot];
+
+		if (ent->id < 0)
+			break;
+		if (ent->hashcode == hashcode && BUFFERTAGS_EQUAL(ent->key, *tagPtr))
+			return ent->id;		/* found something already in the table */
 
-	if (found)					/* found something already in the table */
-		return result->id;
+		if (++slot == SharedBufTableRegionSize)
+			slot = 0;
+	}
 
-	result->id = buf_id;
+	/* Always leave one unused slot, so that probing terminates */
+	if (*used >= (int) SharedBufTableRegionSize - 1)
+		ereport(ERROR,
+				(errcode(ERRCODE_OUT_OF_MEMORY),
+				 errmsg("out of shared memory")));
+
+	ent->key = *tagPtr;
+	ent->hashcode = hashcode;
+	ent->id = buf_id;
+	(*used)++;
 
 	return -1;
 }
@@ -149,15 +228,49 @@ BufTableInsert(BufferTag *tagPtr, uint32 hashcode, int buf_id)
 void
 BufTableDelete(BufferTag *tagPtr, uint32 hashcode)
 {
-	BufferLookupEnt *result;
+	BufferLookupEnt *region = BufTableRegion(hashcode);
+	uint32		slot = BufTableHomeSlot(hashcode);
+	uint32		next;
+
+	for (;;)
+	{
+		BufferLookupEnt *ent = &region[slot];
+
+		if (ent->id < 0)		/* shouldn't happen */
+			elog(ERROR, "shared buffer hash table corrupted");
+		if (ent->hashcode == hashcode && BUFFERTAGS_EQUAL(ent->key, *tagPtr))
+			break;
+
+		if (++slot == SharedBufTableRegionSize)
+			slot = 0;
+	}
+
+	/*
+	 * Rather than leaving a tombstone, move later entries of the probe
+	 * sequence back into the hole, if that doesn't put them in front of
+	 * their home slot, so that lookups can keep stopping at the first unused
+	 * slot.
+	 */
+	next = slot;
+	for (;;)
+	{
+		uint32		home;
+
+		if (++next == SharedBufTableRegionSize)
+			next = 0;
+		if (region[next].id < 0)
+			break;
+
+		/* Entry can't move if its home slot is cyclically in (slot, next] */
+		home = BufTableHomeSlot(region[next].hashcode);
+		if (slot <= next ? (slot < home && home <= next) :
+			(slot < home || home <= next))
+			continue;
 
-	result = (BufferLookupEnt *)
-		hash_search_with_hash_value(SharedBufHash,
-									(void *) tagPtr,
-									hashcode,
-									HASH_REMOVE,
-									NULL);
+		region[slot] = region[next];
+		slot = next;
+	}
 
-	if (!result)				/* shouldn't happen */
-		elog(ERROR, "shared buffer hash table corrupted");
+	region[slot].id = -1;
+	SharedBufTableUsed[BufTableHashPartition(hashcode)]--;
 }
@@ -42,8 +42,10 @@
 #include "pg_trace.h"
 #include "pgstat.h"
 #include "postmaster/bgwriter.h"
+#include "postmaster/ckptwriter.h"
 #include "storage/buf_internals.h"
 #include "storage/bufmgr.h"
+#include "storage/doublewrite.h"
 #include "storage/ipc.h"
 #include "storage/proc.h"
 #include "storage/smgr.h"
@@ -67,6 +69,19 @@
 
 #define DROP_RELS_BSEARCH_THRESHOLD		20
 
+/*
+ * When dropping the buffers of relations whose size is known, look up each
+ * block in the buffer mapping table instead of scanning the whole buffer
+ * pool, if there are fewer blocks than this.
+ */
+#define BUF_DROP_FULL_SCAN_THRESHOLD	(uint64) (NBuffers / 32)
+
+/*
+ * Most the bgwriter scales up its estimate and bgwriter_lru_maxpages by while
+ * backends are writing out dirty victim buffers themselves.
+ */
+#define BGW_MAX_STALL_BOOST		8.0
+
 typedef struct PrivateRefCountEntry
 {
 	Buffer		buffer;
@@ -450,9 +465,13 @@ static BufferDesc *BufferAlloc(SMgrRelation smgr,
 			BlockNumber blockNum,
 			BufferAccessStrategy strategy,
 			bool *foundPtr);
-static void FlushBuffer(BufferDesc *buf, SMgrRelation reln);
+static void FlushBuffer(BufferDesc *buf, SMgrRelation reln,
+			IOContext io_context);
 static void AtProcExit_Buffers(int code, Datum arg);
 static void CheckForBufferLeaks(void);
+static void FindAndDropRelFileNodeBuffers(RelFileNode rnode,
+							  ForkNumber forkNum, BlockNumber nblocks,
+							  BlockNumber firstDelBlock);
 static int	rnode_comparator(const void *p1, const void *p2);
 static int	buffertag_comparator(const void *p1, const void *p2);
 static int	ckpt_buforder_comparator(const void *pa, const void *pb);
@@ -517,6 +536,58 @@ ComputeIoConcurrency(int io_concurrency, double *target)
 	return (new_prefetch_pages >= 0.0 && new_prefetch_pages < (double) INT_MAX);
 }
 
+/*
+ * PrefetchSharedBuffer -- initiate asynchronous read of a block of a
+ *		relation that lives in shared buffers
+ *
+ * This is PrefetchBuffer's work for non-temporary relations, callable with
+ * just an SMgrRelation so that the startup process can prefetch blocks it
+ * will need for WAL replay, where no relcache entry exists.
+ * No-op if prefetching isn't compiled in.
+ */
+void
+PrefetchSharedBuffer(SMgrRelation smgr_reln, ForkNumber forkNum,
+					 BlockNumber blockNum)
+{
+#ifdef USE_PREFETCH
+	BufferTag	newTag;			/* identity of requested block */
+	uint32		newHash;		/* hash value for newTag */
+	LWLock	   *newPartitionLock;	/* buffer partition lock for it */
+	int			buf_id;
+
+	Assert(BlockNumberIsValid(blockNum));
+
+	/* create a tag so we can lookup the buffer */
+	INIT_BUFFERTAG(newTag, smgr_reln->smgr_rnode.node,
+				   forkNum, blockNum);
+
+	/* determine its hash code and partition lock ID */
+	newHash = BufTableHashCode(&newTag);
+	newPartitionLock = BufMappingPartitionLock(newHash);
+
+	/* see if the block is in the buffer pool already */
+	LWLockAcquire(newPartitionLock, LW_SHARED);
+	buf_id = BufTableLookup(&newTag, newHash);
+	LWLockRelease(newPartitionLock);
+
+	/* If not in buffers, initiate prefetch */
+	if (buf_id < 0)
+		smgrprefetch(smgr_reln, forkNum, blockNum, 1);
+
+	/*
+	 * If the block *is* in buffers, we do nothing.  This is not really
+	 * ideal: the block might be just about to be evicted, which would be
+	 * stupid since we know we are going to need it soon.  But the only easy
+	 * answer is to bump the usage_count, which does not seem like a great
+	 * solution: when the caller does ultimately touch the block, usage_count
+	 * would get bumped again, resulting in too much favoritism for blocks
+	 * that are involved in a prefetch sequence. A real fix would involve some
+	 * additional per-buffer state, and it's not clear that there's enough of
+	 * a problem to justify that.
+	 */
+#endif							/* USE_PREFETCH */
+}
+
 /*
  * PrefetchBuffer -- initiate asynchronous read of a block of a relation
  *
@@ -547,41 +618,77 @@ PrefetchBuffer(Relation reln, ForkNumber forkNum, BlockNumber blockNum)
 		LocalPrefetchBuffer(reln->rd_smgr, forkNum, blockNum);
 	}
 	else
+	{
+		/* pass it to the shared buffer version */
+		PrefetchSharedBuffer(reln->rd_smgr, forkNum, blockNum);
+	}
+#endif							/* USE_PREFETCH */
+}
+
+/*
+ * PrefetchBufferRange -- initiate asynchronous read of consecutive blocks
+ *
+ * Like PrefetchBuffer, but for nblocks consecutive blocks starting at
+ * firstBlock.  Blocks already present in shared buffers are skipped, and each
+ * run of consecutive blocks that are not is handed to the storage manager as
+ * a single request, so that a sequential scan can keep several megabytes of
+ * reads in flight at the cost of a few system calls.
+ * No-op if prefetching isn't compiled in.
+ */
+void
+PrefetchBufferRange(Relation reln, ForkNumber forkNum,
+					BlockNumber firstBlock, BlockNumber nblocks)
+{
+#ifdef USE_PREFETCH
+	BlockNumber blockNum;
+	BlockNumber runStart = InvalidBlockNumber;
+
+	Assert(RelationIsValid(reln));
+	Assert(BlockNumberIsValid(firstBlock));
+
+	if (RelationUsesLocalBuffers(reln))
+	{
+		/* temp relations are rarely big enough for this to matter */
+		for (blockNum = firstBlock; blockNum < firstBlock + nblocks; blockNum++)
+			PrefetchBuffer(reln, forkNum, blockNum);
+		return;
+	}
+
+	/* Open it at the smgr level if not already done */
+	RelationOpenSmgr(reln);
+
+	for (blockNum = firstBlock; blockNum < firstBlock + nblocks; blockNum++)
 	{
 		BufferTag	newTag;		/* identity of requested block */
 		uint32		newHash;	/* hash value for newTag */
 		LWLock	   *newPartitionLock;	/* buffer partition lock for it */
 		int			buf_id;
 
-		/* create a tag so we can lookup the buffer */
 		INIT_BUFFERTAG(newTag, reln->rd_smgr->smgr_rnode.node,
 					   forkNum, blockNum);
-
-		/* determine its hash code and partition lock ID */
 		newHash = BufTableHashCode(&newTag);
 		newPartitionLock = BufMappingPartitionLock(newHash);
 
-		/* see if the block is in the buffer pool already */
 		LWLockAcquire(newPartitionLock, LW_SHARED);
 		buf_id = BufTableLookup(&newTag, newHash);
 		LWLockRelease(newPartitionLock);
 
-		/* If not in buffers, initiate prefetch */
 		if (buf_id < 0)
-			smgrprefetch(reln->rd_smgr, forkNum, blockNum);
-
-		/*
-		 * If the block *is* in buffers, we do nothing.  This is not really
-		 * ideal: the block might be just about to be evicted, which would be
-		 * stupid since we know we are going to need it soon.  But the only
-		 * easy answer is to bump the usage_count, which does not seem like a
-		 * great solution: when the caller does ultimately touch the block,
-		 * usage_count would get bumped again, resulting in too much
-		 * favoritism for blocks that are involved in a prefetch sequence. A
-		 * real fix would involve some additional per-buffer state, and it's
-		 * not clear that there's enough of a problem to justify that.
-		 */
+		{
+			/* not in buffers, so extend (or start) the current run */
+			if (runStart == InvalidBlockNumber)
+				runStart = blockNum;
+		}
+		else if (runStart != InvalidBlockNumber)
+		{
+			/* cached block ends the current run; see PrefetchBuffer */
+			smgrprefetch(reln->rd_smgr, forkNum, runStart, blockNum - runStart);
+			runStart = InvalidBlockNumber;
+		}
 	}
+
+	if (runStart != InvalidBlockNumber)
+		smgrprefetch(reln->rd_smgr, forkNum, runStart, blockNum - runStart);
 #endif							/* USE_PREFETCH */
 }
 
@@ -709,6 +816,8 @@ ReadBuffer_common(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 	bool		found;
 	bool		isExtend;
 	bool		isLocalBuf = SmgrIsTemp(smgr);
+	IOObject	io_object;
+	IOContext	io_context;
 
 	*hit = false;
 
@@ -730,6 +839,8 @@ ReadBuffer_common(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 
 	if (isLocalBuf)
 	{
+		io_object = IOOBJECT_TEMP_RELATION;
+		io_context = IOCONTEXT_NORMAL;
 		bufHdr = LocalBufferAlloc(smgr, forkNum, blockNum, &found);
 		if (found)
 			pgBufferUsage.local_blks_hit++;
@@ -745,6 +856,8 @@ ReadBuffer_common(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 		 * lookup the buffer.  IO_IN_PROGRESS is set if the requested block is
 		 * not currently in memory.
 		 */
+		io_object = IOOBJECT_RELATION;
+		io_context = IOContextForStrategy(strategy);
 		bufHdr = BufferAlloc(smgr, relpersistence, forkNum, blockNum,
 							 strategy, &found);
 		if (found)
@@ -865,11 +978,26 @@ ReadBuffer_common(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 
 	if (isExtend)
 	{
+		instr_time	io_start,
+					io_time;
+
 		/* new buffers are zero-filled */
 		MemSet((char *) bufBlock, 0, BLCKSZ);
+
+		INSTR_TIME_SET_ZERO(io_time);
+		if (track_io_timing)
+			INSTR_TIME_SET_CURRENT(io_start);
+
 		/* don't set checksum for all-zero page */
 		smgrextend(smgr, forkNum, blockNum, (char *) bufBlock, false);
 
+		if (track_io_timing)
+		{
+			INSTR_TIME_SET_CURRENT(io_time);
+			INSTR_TIME_SUBTRACT(io_time, io_start);
+		}
+		pgstat_count_io_op_time(io_object, io_context, IOOP_EXTEND, io_time);
+
 		/*
 		 * NB: we're *not* doing a ScheduleBufferTagForWriteback here;
 		 * although we're essentially performing a write. At least on linux
@@ -890,6 +1018,7 @@ ReadBuffer_common(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 			instr_time	io_start,
 						io_time;
 
+			INSTR_TIME_SET_ZERO(io_time);
 			if (track_io_timing)
 				INSTR_TIME_SET_CURRENT(io_start);
 
@@ -902,6 +1031,7 @@ ReadBuffer_common(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 				pgstat_count_buffer_read_time(INSTR_TIME_GET_MICROSEC(io_time));
 				INSTR_TIME_ADD(pgBufferUsage.blk_read_time, io_time);
 			}
+			pgstat_count_io_op_time(io_object, io_context, IOOP_READ, io_time);
 
 			/* check for garbage data */
 			if (!PageIsVerified((Page) bufBlock, blockNum))
@@ -1137,13 +1267,17 @@ BufferAlloc(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 					}
 				}
 
+				/* Let the bgwriter know it didn't keep up */
+				if (strategy == NULL)
+					StrategyCountDirtyVictim();
+
 				/* OK, do the I/O */
 				TRACE_POSTGRESQL_BUFFER_WRITE_DIRTY_START(forkNum, blockNum,
 														  smgr->smgr_rnode.node.spcNode,
 														  smgr->smgr_rnode.node.dbNode,
 														  smgr->smgr_rnode.node.relNode);
 
-				FlushBuffer(buf, NULL);
+				FlushBuffer(buf, NULL, IOContextForStrategy(strategy));
 				LWLockRelease(BufferDescriptorGetContentLock(buf));
 
 				ScheduleBufferTagForWriteback(&BackendWritebackContext,
@@ -1795,6 +1929,7 @@ BufferSync(int flags)
 	int			i;
 	int			mask = BM_DIRTY;
 	WritebackContext wb_context;
+	bool		use_writers;
 
 	/* Make sure we can handle the pin inside SyncOneBuffer */
 	ResourceOwnerEnlargeBuffers(CurrentResourceOwner);
@@ -1952,6 +2087,13 @@ BufferSync(int flags)
 
 	binaryheap_build(ts_heap);
 
+	/*
+	 * If there are checkpoint writer processes, we hand the buffers to them
+	 * instead of writing them ourselves, each tablespace being a separate
+	 * stream of writes.
+	 */
+	use_writers = CkptWriterStartBatches(num_spaces);
+
 	/*
 	 * Iterate through to-be-checkpointed buffers and write the ones (still)
 	 * marked with BM_CHECKPOINT_NEEDED. The writes are balanced between
@@ -1987,7 +2129,9 @@ BufferSync(int flags)
 		 */
 		if (pg_atomic_read_u32(&bufHdr->state) & BM_CHECKPOINT_NEEDED)
 		{
-			if (SyncOneBuffer(buf_id, false, &wb_context) & BUF_WRITTEN)
+			if (use_writers)
+				CkptWriterQueueBuffer(ts_stat - per_ts_stat, buf_id);
+			else if (SyncOneBuffer(buf_id, false, &wb_context) & BUF_WRITTEN)
 			{
 				TRACE_POSTGRESQL_BUFFER_SYNC_WRITTEN(buf_id);
 				BgWriterStats.m_buf_written_checkpoints++;
@@ -2020,6 +2164,15 @@ BufferSync(int flags)
 		CheckpointWriteDelay(flags, (double) num_processed / num_to_scan);
 	}
 
+	/* wait for the writers to finish, and collect their counts */
+	if (use_writers)
+	{
+		int			written = CkptWriterFinishBatches();
+
+		BgWriterStats.m_buf_written_checkpoints += written;
+		num_written += written;
+	}
+
 	/* issue all pending flushes */
 	IssuePendingWritebacks(&wb_context);
 
@@ -2036,6 +2189,40 @@ BufferSync(int flags)
 	TRACE_POSTGRESQL_BUFFER_SYNC_DONE(NBuffers, num_written, num_to_scan);
 }
 
+/*
+ * CheckpointWriteBuffers -- Write out a batch of buffers for a checkpoint.
+ *
+ * This is how the checkpoint writer processes write the buffers BufferSync
+ * hands them.  Buffers no longer marked BM_CHECKPOINT_NEEDED are skipped,
+ * as in BufferSync.  Returns the number of buffers written.
+ */
+int
+CheckpointWriteBuffers(const int *buf_ids, int nbuffers,
+					   WritebackContext *wb_context)
+{
+	int			num_written = 0;
+	int			i;
+
+	/* Make sure we can handle the pin inside SyncOneBuffer */
+	ResourceOwnerEnlargeBuffers(CurrentResourceOwner);
+
+	for (i = 0; i < nbuffers; i++)
+	{
+		BufferDesc *bufHdr = GetBufferDescriptor(buf_ids[i]);
+
+		if (pg_atomic_read_u32(&bufHdr->state) & BM_CHECKPOINT_NEEDED)
+		{
+			if (SyncOneBuffer(buf_ids[i], false, wb_context) & BUF_WRITTEN)
+			{
+				TRACE_POSTGRESQL_BUFFER_SYNC_WRITTEN(buf_ids[i]);
+				num_written++;
+			}
+		}
+	}
+
+	return num_written;
+}
+
 /*
  * BgBufferSync -- Write out some dirty buffers in the pool.
  *
@@ -2054,6 +2241,7 @@ BgBufferSync(WritebackContext *wb_context)
 	int			strategy_buf_id;
 	uint32		strategy_passes;
 	uint32		recent_alloc;
+	uint32		recent_dirty_victims;
 
 	/*
 	 * Information saved between calls so we can determine the strategy
@@ -2069,6 +2257,15 @@ BgBufferSync(WritebackContext *wb_context)
 	static float smoothed_alloc = 0;
 	static float smoothed_density = 10.0;
 
+	/* Previous round's allocations, to see whether demand is growing */
+	static uint32 prev_recent_alloc = 0;
+
+	/*
+	 * Factor by which we currently scale up our estimate and write limit,
+	 * because backends have recently had to write out dirty victims.
+	 */
+	static float stall_boost = 1.0;
+
 	/* Potentially these could be tunables, but for now, not */
 	float		smoothing_samples = 16;
 	float		scan_whole_pool_milliseconds = 120000.0;
@@ -2079,8 +2276,10 @@ BgBufferSync(WritebackContext *wb_context)
 	int			bufs_ahead;
 	float		scans_per_alloc;
 	int			reusable_buffers_est;
+	float		alloc_forecast;
 	int			upcoming_alloc_est;
 	int			min_scan_buffers;
+	int			max_pages;
 
 	/* Variables for the scanning loop proper */
 	int			num_to_scan;
@@ -2095,7 +2294,8 @@ BgBufferSync(WritebackContext *wb_context)
 	 * Find out where the freelist clock sweep currently is, and how many
 	 * buffer allocations have happened since our last call.
 	 */
-	strategy_buf_id = StrategySyncStart(&strategy_passes, &recent_alloc);
+	strategy_buf_id = StrategySyncStart(&strategy_passes, &recent_alloc,
+										&recent_dirty_victims);
 
 	/* Report buffer alloc counts to pgstat */
 	BgWriterStats.m_buf_alloc += recent_alloc;
@@ -2221,8 +2421,31 @@ BgBufferSync(WritebackContext *wb_context)
 		smoothed_alloc += ((float) recent_alloc - smoothed_alloc) /
 			smoothing_samples;
 
+	/*
+	 * The moving average lags behind a burst that is still building up, so
+	 * if allocations grew since the previous round, assume they'll grow as
+	 * much again.
+	 */
+	alloc_forecast = smoothed_alloc;
+	if (recent_alloc > prev_recent_alloc)
+		alloc_forecast += recent_alloc - prev_recent_alloc;
+	prev_recent_alloc = recent_alloc;
+
+	/*
+	 * If backends had to write out dirty victims themselves, we didn't keep
+	 * far enough ahead of them, so step up our estimate and our write limit,
+	 * up to BGW_MAX_STALL_BOOST times.  Once they've stopped doing that, step
+	 * back down gradually.
+	 */
+	if (recent_dirty_victims > 0)
+		stall_boost = Min(stall_boost * 2, BGW_MAX_STALL_BOOST);
+	else
+		stall_boost = Max(stall_boost * 0.75, 1.0);
+
 	/* Scale the estimate by a GUC to allow more aggressive tuning. */
-	upcoming_alloc_est = (int) (smoothed_alloc * bgwriter_lru_multiplier);
+	upcoming_alloc_est = (int) (alloc_forecast * bgwriter_lru_multiplier *
+								stall_boost);
+	max_pages = (int) (bgwriter_lru_maxpages * stall_boost);
 
 	/*
 	 * If recent_alloc remains at zero for many cycles, smoothed_alloc will
@@ -2260,7 +2483,8 @@ BgBufferSync(WritebackContext *wb_context)
 	 * Now write out dirty reusable buffers, working forward from the
 	 * next_to_clean point, until we have lapped the strategy scan, or cleaned
 	 * enough buffers to match our estimate of the next cycle's allocation
-	 * requirements, or hit the bgwriter_lru_maxpages limit.
+	 * requirements, or hit the (possibly boosted) bgwriter_lru_maxpages
+	 * limit.
 	 */
 
 	/* Make sure we can handle the pin inside SyncOneBuffer */
@@ -2273,8 +2497,20 @@ BgBufferSync(WritebackContext *wb_context)
 	/* Execute the LRU scan */
 	while (num_to_scan > 0 && reusable_buffers < upcoming_alloc_est)
 	{
-		int			sync_state = SyncOneBuffer(next_to_clean, true,
-											   wb_context);
+		int			buf_id = next_to_clean;
+		int			sync_state = SyncOneBuffer(buf_id, true, wb_context);
+
+		/*
+		 * Hand reusable buffers over to the freelist, so that backends can
+		 * take them from there rather than having to run the clock sweep
+		 * over the same buffers.  Keep no more there than we expect to be
+		 * allocated before our next round, though; the longer they sit
+		 * there, the more likely they are to be used again, and to have to
+		 * be skipped by whoever pops them.
+		 */
+		if ((sync_state & BUF_REUSABLE) &&
+			StrategyFreeBufferCount() < upcoming_alloc_est)
+			StrategyPutVictimBuffer(GetBufferDescriptor(buf_id));
 
 		if (++next_to_clean >= NBuffers)
 		{
@@ -2286,7 +2522,7 @@ BgBufferSync(WritebackContext *wb_context)
 		if (sync_state & BUF_WRITTEN)
 		{
 			reusable_buffers++;
-			if (++num_written >= bgwriter_lru_maxpages)
+			if (++num_written >= max_pages)
 			{
 				BgWriterStats.m_maxwritten_clean++;
 				break;
@@ -2331,7 +2567,7 @@ BgBufferSync(WritebackContext *wb_context)
 	}
 
 	/* Return true if OK to hibernate */
-	return (bufs_to_lap == 0 && recent_alloc == 0);
+	return (bufs_to_lap == 0 && recent_alloc == 0 && stall_boost == 1.0);
 }
 
 /*
@@ -2397,7 +2633,7 @@ SyncOneBuffer(int buf_id, bool skip_recently_used, WritebackContext *wb_context)
 	PinBuffer_Locked(bufHdr);
 	LWLockAcquire(BufferDescriptorGetContentLock(bufHdr), LW_SHARED);
 
-	FlushBuffer(bufHdr, NULL);
+	FlushBuffer(bufHdr, NULL, IOCONTEXT_NORMAL);
 
 	LWLockRelease(BufferDescriptorGetContentLock(bufHdr));
 
@@ -2665,10 +2901,11 @@ BufferGetTag(Buffer buffer, RelFileNode *rnode, ForkNumber *forknum,
  * written.)
  *
  * If the caller has an smgr reference for the buffer's relation, pass it
- * as the second parameter.  If not, pass NULL.
+ * as the second parameter.  If not, pass NULL.  io_context is what the
+ * write is counted under in pg_stat_io.
  */
 static void
-FlushBuffer(BufferDesc *buf, SMgrRelation reln)
+FlushBuffer(BufferDesc *buf, SMgrRelation reln, IOContext io_context)
 {
 	XLogRecPtr	recptr;
 	ErrorContextCallback errcallback;
@@ -2748,6 +2985,17 @@ FlushBuffer(BufferDesc *buf, SMgrRelation reln)
 	 */
 	bufToWrite = PageSetChecksumCopy((Page) bufBlock, buf->tag.blockNum);
 
+	/*
+	 * If double writes protect against torn pages rather than full-page
+	 * images, the page must be safely in the double-write file before the
+	 * data file write starts.  Pages that have never been WAL-logged need no
+	 * protection, as they'd get no full-page image either.
+	 */
+	if (double_writes && (buf_state & BM_PERMANENT) &&
+		!XLogRecPtrIsInvalid(recptr))
+		bufToWrite = DoubleWritePage(&buf->tag, bufToWrite);
+
+	INSTR_TIME_SET_ZERO(io_time);
 	if (track_io_timing)
 		INSTR_TIME_SET_CURRENT(io_start);
 
@@ -2767,6 +3015,7 @@ FlushBuffer(BufferDesc *buf, SMgrRelation reln)
 		pgstat_count_buffer_write_time(INSTR_TIME_GET_MICROSEC(io_time));
 		INSTR_TIME_ADD(pgBufferUsage.blk_write_time, io_time);
 	}
+	pgstat_count_io_op_time(IOOBJECT_RELATION, io_context, IOOP_WRITE, io_time);
 
 	pgBufferUsage.shared_blks_written++;
 
@@ -2879,23 +3128,35 @@ BufferGetLSNAtomic(Buffer buffer)
  *		that no other process could be trying to load more pages of the
  *		relation into buffers.
  *
- *		XXX currently it sequentially searches the buffer pool, should be
- *		changed to more clever ways of searching.  However, this routine
- *		is used only in code paths that aren't very performance-critical,
- *		and we shouldn't slow down the hot paths to make it faster ...
+ *		If the size of the fork is reliably known, which is the case during
+ *		recovery, and only a few blocks are to be dropped, we look each of
+ *		them up in the buffer mapping table.  Otherwise we sequentially search
+ *		the buffer pool, which can take a while with large shared_buffers.
  * --------------------------------------------------------------------
  */
 void
-DropRelFileNodeBuffers(RelFileNodeBackend rnode, ForkNumber forkNum,
+DropRelFileNodeBuffers(SMgrRelation smgr_reln, ForkNumber forkNum,
 					   BlockNumber firstDelBlock)
 {
+	RelFileNodeBackend rnode = smgr_reln->smgr_rnode;
+	BlockNumber nblocks;
 	int			i;
 
 	/* If it's a local relation, it's localbuf.c's problem. */
 	if (RelFileNodeBackendIsTemp(rnode))
 	{
 		if (rnode.backend == MyBackendId)
-			DropRelFileNodeLocalBuffers(rnode.node, forkNum, firstDelBlock);
+			DropRelFileNodeLocalBuffers(smgr_reln, forkNum, firstDelBlock);
+		return;
+	}
+
+	nblocks = smgrnblocks_cached(smgr_reln, forkNum);
+	if (nblocks != InvalidBlockNumber &&
+		(nblocks <= firstDelBlock ||
+		 nblocks - firstDelBlock < BUF_DROP_FULL_SCAN_THRESHOLD))
+	{
+		FindAndDropRelFileNodeBuffers(rnode.node, forkNum, nblocks,
+									  firstDelBlock);
 		return;
 	}
 
@@ -2940,31 +3201,40 @@ DropRelFileNodeBuffers(RelFileNodeBackend rnode, ForkNumber forkNum,
  *		forks of the specified relations.  It's equivalent to calling
  *		DropRelFileNodeBuffers once per fork per relation with
  *		firstDelBlock = 0.
+ *
+ *		As there, if the sizes of all the forks are known and small enough
+ *		in total, the blocks are looked up individually.
  * --------------------------------------------------------------------
  */
 void
-DropRelFileNodesAllBuffers(RelFileNodeBackend *rnodes, int nnodes)
+DropRelFileNodesAllBuffers(SMgrRelation *smgr_reln, int nnodes)
 {
 	int			i,
 				n = 0;
+	SMgrRelation *rels;
 	RelFileNode *nodes;
+	BlockNumber (*block)[MAX_FORKNUM + 1];
+	uint64		nBlocksToInvalidate = 0;
+	bool		cached = true;
 	bool		use_bsearch;
 
 	if (nnodes == 0)
 		return;
 
-	nodes = palloc(sizeof(RelFileNode) * nnodes);	/* non-local relations */
+	rels = palloc(sizeof(SMgrRelation) * nnodes);	/* non-local relations */
 
 	/* If it's a local relation, it's localbuf.c's problem. */
 	for (i = 0; i < nnodes; i++)
 	{
-		if (RelFileNodeBackendIsTemp(rnodes[i]))
+		RelFileNodeBackend rnode = smgr_reln[i]->smgr_rnode;
+
+		if (RelFileNodeBackendIsTemp(rnode))
 		{
-			if (rnodes[i].backend == MyBackendId)
-				DropRelFileNodeAllLocalBuffers(rnodes[i].node);
+			if (rnode.backend == MyBackendId)
+				DropRelFileNodeAllLocalBuffers(smgr_reln[i]);
 		}
 		else
-			nodes[n++] = rnodes[i].node;
+			rels[n++] = smgr_reln[i];
 	}
 
 	/*
@@ -2973,10 +3243,65 @@ DropRelFileNodesAllBuffers(RelFileNodeBackend *rnodes, int nnodes)
 	 */
 	if (n == 0)
 	{
-		pfree(nodes);
+		pfree(rels);
 		return;
 	}
 
+	/*
+	 * Collect the sizes of all the forks.  If any of them is unknown, or if
+	 * there are too many blocks in total, we must scan the whole pool.
+	 */
+	block = (BlockNumber (*)[MAX_FORKNUM + 1])
+		palloc(sizeof(BlockNumber) * n * (MAX_FORKNUM + 1));
+
+	for (i = 0; i < n && cached; i++)
+	{
+		ForkNumber	fork;
+
+		for (fork = 0; fork <= MAX_FORKNUM; fork++)
+		{
+			/* a fork that doesn't exist has no buffers */
+			block[i][fork] = smgrnblocks_cached(rels[i], fork);
+			if (block[i][fork] == InvalidBlockNumber)
+			{
+				if (smgrexists(rels[i], fork))
+				{
+					cached = false;
+					break;
+				}
+				block[i][fork] = 0;
+			}
+
+			nBlocksToInvalidate += block[i][fork];
+		}
+	}
+
+	if (cached && nBlocksToInvalidate < BUF_DROP_FULL_SCAN_THRESHOLD)
+	{
+		for (i = 0; i < n; i++)
+		{
+			ForkNumber	fork;
+
+			for (fork = 0; fork <= MAX_FORKNUM; fork++)
+			{
+				if (block[i][fork] > 0)
+					FindAndDropRelFileNodeBuffers(rels[i]->smgr_rnode.node,
+												  fork, block[i][fork], 0);
+			}
+		}
+
+		pfree(block);
+		pfree(rels);
+		return;
+	}
+
+	pfree(block);
+
+	nodes = palloc(sizeof(RelFileNode) * n);
+	for (i = 0; i < n; i++)
+		nodes[i] = rels[i]->smgr_rnode.node;
+	pfree(rels);
+
 	/*
 	 * For low number of relations to drop just use a simple walk through, to
 	 * save the bsearch overhead. The threshold to use is rather a guess than
@@ -3034,6 +3359,64 @@ DropRelFileNodesAllBuffers(RelFileNodeBackend *rnodes, int nnodes)
 	pfree(nodes);
 }
 
+/* ---------------------------------------------------------------------
+ *		FindAndDropRelFileNodeBuffers
+ *
+ *		This function performs look up in BufMapping table and removes from the
+ *		buffer pool all the pages of the specified relation fork with block
+ *		number >= firstDelBlock and < nblocks.  The caller must know that no
+ *		block at or beyond nblocks can be in the buffer pool.
+ * --------------------------------------------------------------------
+ */
+static void
+FindAndDropRelFileNodeBuffers(RelFileNode rnode, ForkNumber forkNum,
+							  BlockNumber nblocks, BlockNumber firstDelBlock)
+{
+	BlockNumber curBlock;
+
+	for (curBlock = firstDelBlock; curBlock < nblocks; curBlock++)
+	{
+		uint32		bufHash;	/* hash value for tag */
+		BufferTag	bufTag;		/* identity of requested block */
+		LWLock	   *bufPartitionLock;	/* buffer partition lock for it */
+		int			buf_id;
+		BufferDesc *bufHdr;
+		uint32		buf_state;
+
+		/* create a tag so we can lookup the buffer */
+		INIT_BUFFERTAG(bufTag, rnode, forkNum, curBlock);
+
+		/* determine its hash code and partition lock ID */
+		bufHash = BufTableHashCode(&bufTag);
+		bufPartitionLock = BufMappingPartitionLock(bufHash);
+
+		/* Check that it is in the buffer pool. If not, do nothing. */
+		LWLockAcquire(bufPartitionLock, LW_SHARED);
+		buf_id = BufTableLookup(&bufTag, bufHash);
+		LWLockRelease(bufPartitionLock);
+
+		if (buf_id < 0)
+			continue;
+
+		bufHdr = GetBufferDescriptor(buf_id);
+
+		/*
+		 * We need to lock the buffer header and recheck if the buffer is
+		 * still associated with the same block because the buffer could be
+		 * evicted by some other backend loading blocks for some other
+		 * relation after we release the lock on the BufMapping table.
+		 */
+		buf_state = LockBufHdr(bufHdr);
+
+		if (RelFileNodeEquals(bufHdr->tag.rnode, rnode) &&
+			bufHdr->tag.forkNum == forkNum &&
+			bufHdr->tag.blockNum >= firstDelBlock)
+			InvalidateBuffer(bufHdr);	/* releases spinlock */
+		else
+			UnlockBufHdr(bufHdr, buf_state);
+	}
+}
+
 /* ---------------------------------------------------------------------
  *		DropDatabaseBuffers
  *
@@ -3188,6 +3571,8 @@ FlushRelationBuffers(Relation rel)
 						  bufHdr->tag.blockNum,
 						  localpage,
 						  false);
+				pgstat_count_io_op(IOOBJECT_TEMP_RELATION, IOCONTEXT_NORMAL,
+								   IOOP_WRITE);
 
 				buf_state &= ~(BM_DIRTY | BM_JUST_DIRTIED);
 				pg_atomic_unlocked_write_u32(&bufHdr->state, buf_state);
@@ -3224,7 +3609,7 @@ FlushRelationBuffers(Relation rel)
 		{
 			PinBuffer_Locked(bufHdr);
 			LWLockAcquire(BufferDescriptorGetContentLock(bufHdr), LW_SHARED);
-			FlushBuffer(bufHdr, rel->rd_smgr);
+			FlushBuffer(bufHdr, rel->rd_smgr, IOCONTEXT_NORMAL);
 			LWLockRelease(BufferDescriptorGetContentLock(bufHdr));
 			UnpinBuffer(bufHdr, true);
 		}
@@ -3278,7 +3663,7 @@ FlushDatabaseBuffers(Oid dbid)
 		{
 			PinBuffer_Locked(bufHdr);
 			LWLockAcquire(BufferDescriptorGetContentLock(bufHdr), LW_SHARED);
-			FlushBuffer(bufHdr, NULL);
+			FlushBuffer(bufHdr, NULL, IOCONTEXT_NORMAL);
 			LWLockRelease(BufferDescriptorGetContentLock(bufHdr));
 			UnpinBuffer(bufHdr, true);
 		}
@@ -3305,7 +3690,7 @@ FlushOneBuffer(Buffer buffer)
 
 	Assert(LWLockHeldByMe(BufferDescriptorGetContentLock(bufHdr)));
 
-	FlushBuffer(bufHdr, NULL);
+	FlushBuffer(bufHdr, NULL, IOCONTEXT_NORMAL);
 }
 
 /*
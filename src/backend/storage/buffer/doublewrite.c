@@ -0,0 +1,535 @@
+/*-------------------------------------------------------------------------
+ *
+ * doublewrite.c
+ *	  Torn-page protection for data file writes via a double-write file.
+ *
+ * A data page write that is interrupted by a crash can leave the page on
+ * disk partly old and partly new.  WAL replay cannot repair such a "torn"
+ * page from an incremental record, which is why full_page_writes logs a
+ * full image of each page the first time it is modified after a checkpoint.
+ *
+ * With double_writes enabled, FlushBuffer instead first writes the page into
+ * this process's area of the double-write file and fsyncs that, and only
+ * then writes the data file.  If the data file write is torn, the complete
+ * copy is still in the double-write file, and StartupDoubleWrite puts it
+ * back before WAL replay begins.  Full-page images are then not needed for
+ * torn-page protection, so XLogInsert doesn't take them except while an
+ * online backup is in progress.
+ *
+ * The file is divided into one area per PGPROC, so processes never contend
+ * for it.  Each area consists of two header blocks followed by DW_AREA_SLOTS
+ * page slots.  A header lists the pages held in the slots, with a CRC of
+ * each; the two headers are written alternately with increasing sequence
+ * numbers, so that a torn header write leaves the previous one intact.  A
+ * slot must not be overwritten until the data file write it protects is
+ * known to be on disk, so when an area fills up, the data file segments
+ * written through it are fsync'd before it is started over.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/storage/buffer/doublewrite.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "miscadmin.h"
+#include "pgstat.h"
+#include "port/pg_crc32c.h"
+#include "storage/bufpage.h"
+#include "storage/doublewrite.h"
+#include "storage/fd.h"
+#include "storage/ipc.h"
+#include "storage/proc.h"
+#include "storage/smgr.h"
+#include "utils/hsearch.h"
+#include "utils/memutils.h"
+
+/* Number of page slots in each process's area */
+#define DW_AREA_SLOTS		16
+
+/* Size of one area: two header blocks, then the page slots */
+#define DW_AREA_SIZE		((off_t) (2 + DW_AREA_SLOTS) * BLCKSZ)
+
+#define DW_HEADER_MAGIC		0x44570001
+
+typedef struct DoubleWriteEntry
+{
+	BufferTag	tag;			/* page held in the slot */
+	pg_crc32c	crc;			/* CRC of the slot contents */
+} DoubleWriteEntry;
+
+typedef struct DoubleWriteHeader
+{
+	uint32		magic;			/* DW_HEADER_MAGIC */
+	uint32		nentries;		/* number of slots in use */
+	uint64		seq;			/* the header with the higher seq is current */
+	DoubleWriteEntry entries[DW_AREA_SLOTS];
+	pg_crc32c	crc;			/* CRC of all the above */
+} DoubleWriteHeader;
+
+/* During recovery: the newest copy of each page found in the file */
+typedef struct DoubleWriteCopy
+{
+	BufferTag	tag;			/* hash key; must be first */
+	XLogRecPtr	lsn;			/* LSN of the copy */
+	bool		restored;		/* did we write it back to the data file? */
+	char	   *page;
+} DoubleWriteCopy;
+
+/* GUC variable */
+bool		double_writes = false;
+
+/* This process's area of the double-write file */
+static int	dwFile = -1;
+static off_t dwAreaStart;
+static DoubleWriteHeader dwHeader;
+static PGAlignedBlock dwPage;
+
+static void OpenDoubleWriteArea(void);
+static void SyncDoubleWriteArea(void);
+static void ShutdownDoubleWrite(int code, Datum arg);
+static bool ReadDoubleWriteHeader(int fd, off_t areastart,
+					  DoubleWriteHeader *hdr);
+static void WriteDoubleWriteBlock(const char *block, off_t offset);
+static void RestoreDoubleWritePages(XLogRecPtr redo);
+
+
+/*
+ * DoubleWritePage -- make a durable copy of a page about to be written
+ *
+ * The page goes to the next slot of this process's area of the double-write
+ * file, which is fsync'd before we return.  The caller must write the data
+ * file from the returned copy rather than from the original, since hint bits
+ * may be changing in a shared buffer under share lock, and the two writes
+ * should agree.
+ */
+char *
+DoubleWritePage(const BufferTag *tag, const char *page)
+{
+	DoubleWriteEntry *entry;
+	PGAlignedBlock hdrbuf;
+	int			slot;
+
+	if (dwFile < 0)
+		OpenDoubleWriteArea();
+
+	/* Before reusing the slots, make sure nobody needs them anymore */
+	if (dwHeader.nentries >= DW_AREA_SLOTS)
+		SyncDoubleWriteArea();
+
+	memcpy(dwPage.data, page, BLCKSZ);
+
+	slot = dwHeader.nentries;
+	entry = &dwHeader.entries[slot];
+	entry->tag = *tag;
+	INIT_CRC32C(entry->crc);
+	COMP_CRC32C(entry->crc, dwPage.data, BLCKSZ);
+	FIN_CRC32C(entry->crc);
+
+	WriteDoubleWriteBlock(dwPage.data,
+						  dwAreaStart + (off_t) (2 + slot) * BLCKSZ);
+
+	/*
+	 * Now write out a header listing the new slot, overwriting the older of
+	 * the two headers.
+	 */
+	dwHeader.magic = DW_HEADER_MAGIC;
+	dwHeader.nentries = slot + 1;
+	dwHeader.seq++;
+	INIT_CRC32C(dwHeader.crc);
+	COMP_CRC32C(dwHeader.crc, &dwHeader, offsetof(DoubleWriteHeader, crc));
+	FIN_CRC32C(dwHeader.crc);
+
+	memset(hdrbuf.data, 0, BLCKSZ);
+	memcpy(hdrbuf.data, &dwHeader, sizeof(DoubleWriteHeader));
+	WriteDoubleWriteBlock(hdrbuf.data,
+						  dwAreaStart + (off_t) (dwHeader.seq % 2) * BLCKSZ);
+
+	pgstat_report_wait_start(WAIT_EVENT_DOUBLE_WRITE_SYNC);
+	if (pg_fdatasync(dwFile) != 0)
+		ereport(data_sync_elevel(ERROR),
+				(errcode_for_file_access(),
+				 errmsg("could not fsync file \"%s\": %m",
+						DOUBLE_WRITE_FILE)));
+	pgstat_report_wait_end();
+
+	return dwPage.data;
+}
+
+/*
+ * Open the double-write file and locate this process's area in it.
+ */
+static void
+OpenDoubleWriteArea(void)
+{
+	DoubleWriteHeader prev;
+
+	StaticAssertStmt(sizeof(DoubleWriteHeader) <= BLCKSZ,
+					 "double-write header does not fit in a block");
+
+	if (MyProc == NULL)
+		elog(ERROR, "cannot use double writes without a PGPROC");
+
+	dwFile = BasicOpenFile(DOUBLE_WRITE_FILE, O_RDWR | PG_BINARY);
+	if (dwFile < 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not open file \"%s\": %m",
+						DOUBLE_WRITE_FILE)));
+
+	dwAreaStart = (off_t) MyProc->pgprocno * DW_AREA_SIZE;
+
+	/*
+	 * A previous process may have used this area.  Its pages no longer need
+	 * protection, since it synced them at exit, but we must continue its
+	 * sequence numbering so that our headers take precedence over its.
+	 */
+	if (ReadDoubleWriteHeader(dwFile, dwAreaStart, &prev))
+		dwHeader.seq = prev.seq;
+	else
+		dwHeader.seq = 0;
+	dwHeader.nentries = 0;
+
+	before_shmem_exit(ShutdownDoubleWrite, 0);
+}
+
+/*
+ * Make the data file writes protected by this process's area durable, so
+ * the area can be started over.
+ */
+static void
+SyncDoubleWriteArea(void)
+{
+	int			i;
+
+	for (i = 0; i < dwHeader.nentries; i++)
+	{
+		BufferTag  *tag = &dwHeader.entries[i].tag;
+		SMgrRelation reln;
+		int			j;
+
+		/* Only one fsync per segment file is needed */
+		for (j = 0; j < i; j++)
+		{
+			BufferTag  *prev = &dwHeader.entries[j].tag;
+
+			if (RelFileNodeEquals(prev->rnode, tag->rnode) &&
+				prev->forkNum == tag->forkNum &&
+				prev->blockNum / RELSEG_SIZE == tag->blockNum / RELSEG_SIZE)
+				break;
+		}
+		if (j < i)
+			continue;
+
+		reln = smgropen(tag->rnode, InvalidBackendId);
+		smgrsyncblock(reln, tag->forkNum, tag->blockNum);
+	}
+
+	dwHeader.nentries = 0;
+}
+
+/*
+ * Process-exit callback: the next user of our area will overwrite it, so the
+ * writes it protects must be on disk before we go.
+ */
+static void
+ShutdownDoubleWrite(int code, Datum arg)
+{
+	if (dwHeader.nentries > 0)
+		SyncDoubleWriteArea();
+
+	close(dwFile);
+	dwFile = -1;
+}
+
+/*
+ * Read the current header of the area starting at 'areastart' into *hdr.
+ * Returns false if neither header block holds a valid header.
+ */
+static bool
+ReadDoubleWriteHeader(int fd, off_t areastart, DoubleWriteHeader *hdr)
+{
+	PGAlignedBlock buf;
+	DoubleWriteHeader *cand = (DoubleWriteHeader *) buf.data;
+	bool		found = false;
+	int			i;
+
+	for (i = 0; i < 2; i++)
+	{
+		pg_crc32c	crc;
+		int			r;
+
+		pgstat_report_wait_start(WAIT_EVENT_DOUBLE_WRITE_READ);
+		r = pg_pread(fd, buf.data, BLCKSZ, areastart + (off_t) i * BLCKSZ);
+		pgstat_report_wait_end();
+		if (r < 0)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not read file \"%s\": %m",
+							DOUBLE_WRITE_FILE)));
+		if (r != BLCKSZ)
+			continue;
+
+		if (cand->magic != DW_HEADER_MAGIC || cand->nentries > DW_AREA_SLOTS)
+			continue;
+		INIT_CRC32C(crc);
+		COMP_CRC32C(crc, cand, offsetof(DoubleWriteHeader, crc));
+		FIN_CRC32C(crc);
+		if (!EQ_CRC32C(crc, cand->crc))
+			continue;
+
+		if (!found || cand->seq > hdr->seq)
+		{
+			memcpy(hdr, cand, sizeof(DoubleWriteHeader));
+			found = true;
+		}
+	}
+
+	return found;
+}
+
+/*
+ * Write one block of this process's area.
+ */
+static void
+WriteDoubleWriteBlock(const char *block, off_t offset)
+{
+	int			r;
+
+	errno = 0;
+	pgstat_report_wait_start(WAIT_EVENT_DOUBLE_WRITE_WRITE);
+	r = pg_pwrite(dwFile, block, BLCKSZ, offset);
+	pgstat_report_wait_end();
+	if (r != BLCKSZ)
+	{
+		/* if write didn't set errno, assume problem is no disk space */
+		if (errno == 0)
+			errno = ENOSPC;
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not write to file \"%s\": %m",
+						DOUBLE_WRITE_FILE)));
+	}
+}
+
+/*
+ * StartupDoubleWrite -- repair torn pages, and prepare the file for use
+ *
+ * This is called by the startup process before WAL replay begins, and before
+ * any other process may write data pages.  If we're recovering from a crash,
+ * pages found in the double-write file are first copied back where needed.
+ */
+void
+StartupDoubleWrite(bool crashRecovery, XLogRecPtr redo)
+{
+	int			fd;
+
+	if (crashRecovery)
+		RestoreDoubleWritePages(redo);
+
+	if (!double_writes)
+	{
+		if (unlink(DOUBLE_WRITE_FILE) < 0 && errno != ENOENT)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not remove file \"%s\": %m",
+							DOUBLE_WRITE_FILE)));
+		return;
+	}
+
+	/*
+	 * Start out with an empty file.  It's extended as processes first use
+	 * their areas, but creating it must be made durable here.
+	 */
+	fd = BasicOpenFile(DOUBLE_WRITE_FILE, O_RDWR | O_CREAT | PG_BINARY);
+	if (fd < 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not create file \"%s\": %m",
+						DOUBLE_WRITE_FILE)));
+	if (ftruncate(fd, 0) < 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not truncate file \"%s\": %m",
+						DOUBLE_WRITE_FILE)));
+	if (pg_fsync(fd) != 0)
+		ereport(data_sync_elevel(ERROR),
+				(errcode_for_file_access(),
+				 errmsg("could not fsync file \"%s\": %m",
+						DOUBLE_WRITE_FILE)));
+	if (close(fd))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not close file \"%s\": %m",
+						DOUBLE_WRITE_FILE)));
+
+	fsync_fname(".", true);
+}
+
+/*
+ * Copy pages from the double-write file back into the data files, wherever
+ * the data file might hold a torn write of them.
+ *
+ * Only copies of pages modified at or after 'redo' are considered.  A page
+ * last modified before that was on disk when the checkpoint completed, so a
+ * later write of it can only have changed hint bits; this also disregards
+ * stale copies left behind in areas that weren't reused for a while.  Of
+ * the remaining copies, the one with the highest LSN is the latest version
+ * of the page written.  If the data file has that version or a newer one,
+ * the write was complete; otherwise it was torn, or never happened, and
+ * either way writing back our copy is correct since WAL was flushed past
+ * its LSN before it was written here.
+ */
+static void
+RestoreDoubleWritePages(XLogRecPtr redo)
+{
+	int			fd;
+	struct stat st;
+	off_t		areastart;
+	HASHCTL		hash_ctl;
+	HTAB	   *pages;
+	HASH_SEQ_STATUS status;
+	DoubleWriteCopy *dwpage;
+	MemoryContext restore_cxt;
+	MemoryContext oldcxt;
+	PGAlignedBlock buf;
+	int			nrestored = 0;
+
+	fd = BasicOpenFile(DOUBLE_WRITE_FILE, O_RDONLY | PG_BINARY);
+	if (fd < 0)
+	{
+		if (errno == ENOENT)
+			return;
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not open file \"%s\": %m",
+						DOUBLE_WRITE_FILE)));
+	}
+	if (fstat(fd, &st) < 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not stat file \"%s\": %m",
+						DOUBLE_WRITE_FILE)));
+
+	restore_cxt = AllocSetContextCreate(CurrentMemoryContext,
+										"double-write restore",
+										ALLOCSET_DEFAULT_SIZES);
+	oldcxt = MemoryContextSwitchTo(restore_cxt);
+
+	memset(&hash_ctl, 0, sizeof(hash_ctl));
+	hash_ctl.keysize = sizeof(BufferTag);
+	hash_ctl.entrysize = sizeof(DoubleWriteCopy);
+	hash_ctl.hcxt = restore_cxt;
+	pages = hash_create("double-write pages", 256, &hash_ctl,
+						HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+
+	for (areastart = 0; areastart < st.st_size; areastart += DW_AREA_SIZE)
+	{
+		DoubleWriteHeader hdr;
+		int			i;
+
+		if (!ReadDoubleWriteHeader(fd, areastart, &hdr))
+			continue;
+
+		for (i = 0; i < hdr.nentries; i++)
+		{
+			DoubleWriteEntry *entry = &hdr.entries[i];
+			pg_crc32c	crc;
+			XLogRecPtr	lsn;
+			bool		found;
+			int			r;
+
+			pgstat_report_wait_start(WAIT_EVENT_DOUBLE_WRITE_READ);
+			r = pg_pread(fd, buf.data, BLCKSZ,
+						 areastart + (off_t) (2 + i) * BLCKSZ);
+			pgstat_report_wait_end();
+			if (r < 0)
+				ereport(ERROR,
+						(errcode_for_file_access(),
+						 errmsg("could not read file \"%s\": %m",
+								DOUBLE_WRITE_FILE)));
+
+			/* Skip slots that were being overwritten at the crash */
+			if (r != BLCKSZ)
+				continue;
+			INIT_CRC32C(crc);
+			COMP_CRC32C(crc, buf.data, BLCKSZ);
+			FIN_CRC32C(crc);
+			if (!EQ_CRC32C(crc, entry->crc))
+				continue;
+
+			lsn = PageGetLSN((Page) buf.data);
+			if (lsn < redo)
+				continue;
+
+			dwpage = (DoubleWriteCopy *) hash_search(pages, &entry->tag,
+													 HASH_ENTER, &found);
+			if (!found)
+			{
+				dwpage->page = palloc(BLCKSZ);
+				dwpage->restored = false;
+			}
+			else if (lsn <= dwpage->lsn)
+				continue;
+			dwpage->lsn = lsn;
+			memcpy(dwpage->page, buf.data, BLCKSZ);
+		}
+	}
+
+	if (close(fd))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not close file \"%s\": %m",
+						DOUBLE_WRITE_FILE)));
+
+	hash_seq_init(&status, pages);
+	while ((dwpage = (DoubleWriteCopy *) hash_seq_search(&status)) != NULL)
+	{
+		BufferTag  *tag = &dwpage->tag;
+		SMgrRelation reln = smgropen(tag->rnode, InvalidBackendId);
+
+		/* Nothing to do if the relation was dropped or truncated since */
+		if (!smgrexists(reln, tag->forkNum) ||
+			tag->blockNum >= smgrnblocks(reln, tag->forkNum))
+			continue;
+
+		smgrread(reln, tag->forkNum, tag->blockNum, buf.data);
+		if (PageGetLSN((Page) buf.data) > dwpage->lsn ||
+			memcmp(buf.data, dwpage->page, BLCKSZ) == 0)
+			continue;
+
+		ereport(DEBUG1,
+				(errmsg("restoring block %u of relation %s from double-write file",
+						tag->blockNum,
+						relpathperm(tag->rnode, tag->forkNum))));
+
+		smgrwrite(reln, tag->forkNum, tag->blockNum, dwpage->page, true);
+		dwpage->restored = true;
+		nrestored++;
+	}
+
+	/* The restored pages must be durable before the file is reset */
+	hash_seq_init(&status, pages);
+	while ((dwpage = (DoubleWriteCopy *) hash_seq_search(&status)) != NULL)
+	{
+		if (dwpage->restored)
+			smgrsyncblock(smgropen(dwpage->tag.rnode, InvalidBackendId),
+						  dwpage->tag.forkNum, dwpage->tag.blockNum);
+	}
+
+	if (nrestored > 0)
+		ereport(LOG,
+				(errmsg("restored %d pages from double-write file",
+						nrestored)));
+
+	MemoryContextSwitchTo(oldcxt);
+	MemoryContextDelete(restore_cxt);
+}
@@ -24,11 +24,44 @@
 
 
 /*
- * The shared freelist control information.
+ * The freelist is split into NUM_BUFFER_FREELISTS partitions, each with its
+ * own spinlock and padded to a cache line of its own, so that backends
+ * taking buffers off it don't all contend for a single lock.  A buffer
+ * always goes back to the partition given by its buf_id.  Backends try the
+ * partition picked by their pgprocno first, and then the others in turn.
  */
 typedef struct
 {
 	/* Spinlock: protects the values below */
+	slock_t		lock;
+
+	int			firstFreeBuffer;	/* Head of list of unused buffers */
+	int			lastFreeBuffer; /* Tail of list of unused buffers */
+
+	/*
+	 * NOTE: lastFreeBuffer is undefined when firstFreeBuffer is -1 (that is,
+	 * when the list is empty)
+	 */
+} BufferFreelist;
+
+typedef union BufferFreelistPadded
+{
+	BufferFreelist list;
+	char		pad[PG_CACHE_LINE_SIZE];
+} BufferFreelistPadded;
+
+#define BufferFreelistFor(buf_id) \
+	(&StrategyControl->freelists[(buf_id) % NUM_BUFFER_FREELISTS].list)
+
+/*
+ * The shared freelist control information.
+ */
+typedef struct
+{
+	/*
+	 * Spinlock: protects completePasses and bgwprocno, and wrapping around of
+	 * nextVictimBuffer
+	 */
 	slock_t		buffer_strategy_lock;
 
 	/*
@@ -38,13 +71,8 @@ typedef struct
 	 */
 	pg_atomic_uint32 nextVictimBuffer;
 
-	int			firstFreeBuffer;	/* Head of list of unused buffers */
-	int			lastFreeBuffer; /* Tail of list of unused buffers */
-
-	/*
-	 * NOTE: lastFreeBuffer is undefined when firstFreeBuffer is -1 (that is,
-	 * when the list is empty)
-	 */
+	/* Approximate number of buffers on all the freelists */
+	pg_atomic_uint32 numFreeBuffers;
 
 	/*
 	 * Statistics.  These counters should be wide enough that they can't
@@ -52,17 +80,34 @@ typedef struct
 	 */
 	uint32		completePasses; /* Complete cycles of the clock sweep */
 	pg_atomic_uint32 numBufferAllocs;	/* Buffers allocated since last reset */
+	pg_atomic_uint32 numDirtyVictims;	/* Victims written by their
+										 * allocator since last reset */
 
 	/*
 	 * Bgworker process to be notified upon activity or -1 if none. See
 	 * StrategyNotifyBgWriter.
 	 */
 	int			bgwprocno;
+
+	BufferFreelistPadded freelists[NUM_BUFFER_FREELISTS];
 } BufferStrategyControl;
 
 /* Pointers to shared state */
 static BufferStrategyControl *StrategyControl = NULL;
 
+/*
+ * Backends take buffers from the clock hand in batches of CLOCK_SWEEP_BATCH
+ * consecutive buffers, which they then sweep through on their own.  This
+ * way the hand's cache line is fought over once per batch rather than once
+ * per buffer, in effect giving each backend its own small region to sweep.
+ * When a backend doesn't get to the end of its batch, it uses the rest for
+ * its next allocations.
+ */
+#define CLOCK_SWEEP_BATCH	16
+
+static uint32 sweepNextBuffer;	/* next buffer of our batch, not wrapped */
+static int	sweepBuffersLeft = 0;	/* # of buffers left in our batch */
+
 /*
  * Private (non-shared) state for managing a ring of shared buffers to re-use.
  * This is currently the only kind of BufferAccessStrategy object, but someday
@@ -114,34 +159,37 @@ ClockSweepTick(void)
 {
 	uint32		victim;
 
-	/*
-	 * Atomically move hand ahead one buffer - if there's several processes
-	 * doing this, this can lead to buffers being returned slightly out of
-	 * apparent order.
-	 */
-	victim =
-		pg_atomic_fetch_add_u32(&StrategyControl->nextVictimBuffer, 1);
-
-	if (victim >= NBuffers)
+	if (sweepBuffersLeft == 0)
 	{
-		uint32		originalVictim = victim;
+		uint32		batch = Min(CLOCK_SWEEP_BATCH, NBuffers);
+		uint32		start;
+		uint32		end;
 
-		/* always wrap what we look up in BufferDescriptors */
-		victim = victim % NBuffers;
+		/*
+		 * Atomically move hand ahead a batch of buffers - if there's several
+		 * processes doing this, this can lead to buffers being returned
+		 * slightly out of apparent order.
+		 */
+		start = pg_atomic_fetch_add_u32(&StrategyControl->nextVictimBuffer,
+										batch);
+		end = start + batch;
 
 		/*
-		 * If we're the one that just caused a wraparound, force
+		 * If our batch contains the buffer that wraps around, force
 		 * completePasses to be incremented while holding the spinlock. We
 		 * need the spinlock so StrategySyncStart() can return a consistent
-		 * value consisting of nextVictimBuffer and completePasses.
+		 * value consisting of nextVictimBuffer and completePasses.  As the
+		 * batch is no larger than NBuffers, at most one of its buffers can be
+		 * a multiple of NBuffers.
 		 */
-		if (victim == 0)
+		if ((start > 0 && start % NBuffers == 0) ||
+			(end - 1) / NBuffers > start / NBuffers)
 		{
 			uint32		expected;
 			uint32		wrapped;
 			bool		success = false;
 
-			expected = originalVictim + 1;
+			expected = end;
 
 			while (!success)
 			{
@@ -164,7 +212,18 @@ ClockSweepTick(void)
 				SpinLockRelease(&StrategyControl->buffer_strategy_lock);
 			}
 		}
+
+		sweepNextBuffer = start;
+		sweepBuffersLeft = batch;
 	}
+
+	victim = sweepNextBuffer++;
+	sweepBuffersLeft--;
+
+	/* always wrap what we look up in BufferDescriptors */
+	if (victim >= NBuffers)
+		victim = victim % NBuffers;
+
 	return victim;
 }
 
@@ -179,10 +238,100 @@ ClockSweepTick(void)
 bool
 have_free_buffer()
 {
-	if (StrategyControl->firstFreeBuffer >= 0)
-		return true;
-	else
-		return false;
+	int			i;
+
+	for (i = 0; i < NUM_BUFFER_FREELISTS; i++)
+	{
+		if (StrategyControl->freelists[i].list.firstFreeBuffer >= 0)
+			return true;
+	}
+	return false;
+}
+
+/*
+ * StrategyGetFreeBuffer -- pop a usable buffer off the freelists, if any
+ *
+ * Returns the buffer with its header spinlock held, and its state in
+ * *buf_state, or NULL if the freelists are empty.
+ */
+static BufferDesc *
+StrategyGetFreeBuffer(uint32 *buf_state)
+{
+	int			start;
+	int			i;
+
+	start = MyProc != NULL ? MyProc->pgprocno % NUM_BUFFER_FREELISTS : 0;
+
+	for (i = 0; i < NUM_BUFFER_FREELISTS; i++)
+	{
+		BufferFreelist *freelist;
+
+		freelist = &StrategyControl->freelists[(start + i) % NUM_BUFFER_FREELISTS].list;
+
+		/*
+		 * Check, without acquiring the lock, whether there's buffers in this
+		 * freelist. Since we otherwise don't require a spinlock in every
+		 * StrategyGetBuffer() invocation, it'd be sad to acquire it here -
+		 * uselessly in most cases. That obviously leaves a race where a
+		 * buffer is put on the freelist but we don't see the store yet - but
+		 * that's pretty harmless, it'll just get used during the next buffer
+		 * acquisition.
+		 *
+		 * If there's buffers on the freelist, acquire the spinlock to pop
+		 * one buffer of the freelist. Then check whether that buffer is
+		 * usable and repeat if not.
+		 *
+		 * Note that the freeNext fields are considered to be protected by the
+		 * freelist's spinlock not the individual buffer spinlocks, so it's OK
+		 * to manipulate them without holding the buffer spinlock.
+		 */
+		while (freelist->firstFreeBuffer >= 0)
+		{
+			BufferDesc *buf;
+			uint32		local_buf_state;
+
+			/* Acquire the spinlock to remove element from the freelist */
+			SpinLockAcquire(&freelist->lock);
+
+			if (freelist->firstFreeBuffer < 0)
+			{
+				SpinLockRelease(&freelist->lock);
+				break;
+			}
+
+			buf = GetBufferDescriptor(freelist->firstFreeBuffer);
+			Assert(buf->freeNext != FREENEXT_NOT_IN_LIST);
+
+			/* Unconditionally remove buffer from freelist */
+			freelist->firstFreeBuffer = buf->freeNext;
+			buf->freeNext = FREENEXT_NOT_IN_LIST;
+
+			/*
+			 * Release the lock so someone else can access the freelist while
+			 * we check out this buffer.
+			 */
+			SpinLockRelease(&freelist->lock);
+
+			pg_atomic_fetch_sub_u32(&StrategyControl->numFreeBuffers, 1);
+
+			/*
+			 * If the buffer is pinned or has a nonzero usage_count, we cannot
+			 * use it; discard it and retry.  This happens when a buffer that
+			 * the bgwriter or VACUUM put on the freelist got used again
+			 * before we got to it.
+			 */
+			local_buf_state = LockBufHdr(buf);
+			if (BUF_STATE_GET_REFCOUNT(local_buf_state) == 0
+				&& BUF_STATE_GET_USAGECOUNT(local_buf_state) == 0)
+			{
+				*buf_state = local_buf_state;
+				return buf;
+			}
+			UnlockBufHdr(buf, local_buf_state);
+		}
+	}
+
+	return NULL;
 }
 
 /*
@@ -250,66 +399,15 @@ StrategyGetBuffer(BufferAccessStrategy strategy, uint32 *buf_state)
 	pg_atomic_fetch_add_u32(&StrategyControl->numBufferAllocs, 1);
 
 	/*
-	 * First check, without acquiring the lock, whether there's buffers in the
-	 * freelist. Since we otherwise don't require the spinlock in every
-	 * StrategyGetBuffer() invocation, it'd be sad to acquire it here -
-	 * uselessly in most cases. That obviously leaves a race where a buffer is
-	 * put on the freelist but we don't see the store yet - but that's pretty
-	 * harmless, it'll just get used during the next buffer acquisition.
-	 *
-	 * If there's buffers on the freelist, acquire the spinlock to pop one
-	 * buffer of the freelist. Then check whether that buffer is usable and
-	 * repeat if not.
-	 *
-	 * Note that the freeNext fields are considered to be protected by the
-	 * buffer_strategy_lock not the individual buffer spinlocks, so it's OK to
-	 * manipulate them without holding the spinlock.
+	 * Try the freelists first.  Usually the bgwriter keeps them stocked with
+	 * clean buffers it found ahead of the clock sweep.
 	 */
-	if (StrategyControl->firstFreeBuffer >= 0)
+	buf = StrategyGetFreeBuffer(buf_state);
+	if (buf != NULL)
 	{
-		while (true)
-		{
-			/* Acquire the spinlock to remove element from the freelist */
-			SpinLockAcquire(&StrategyControl->buffer_strategy_lock);
-
-			if (StrategyControl->firstFreeBuffer < 0)
-			{
-				SpinLockRelease(&StrategyControl->buffer_strategy_lock);
-				break;
-			}
-
-			buf = GetBufferDescriptor(StrategyControl->firstFreeBuffer);
-			Assert(buf->freeNext != FREENEXT_NOT_IN_LIST);
-
-			/* Unconditionally remove buffer from freelist */
-			StrategyControl->firstFreeBuffer = buf->freeNext;
-			buf->freeNext = FREENEXT_NOT_IN_LIST;
-
-			/*
-			 * Release the lock so someone else can access the freelist while
-			 * we check out this buffer.
-			 */
-			SpinLockRelease(&StrategyControl->buffer_strategy_lock);
-
-			/*
-			 * If the buffer is pinned or has a nonzero usage_count, we cannot
-			 * use it; discard it and retry.  (This can only happen if VACUUM
-			 * put a valid buffer in the freelist and then someone else used
-			 * it before we got to it.  It's probably impossible altogether as
-			 * of 8.3, but we'd better check anyway.)
-			 */
-			local_buf_state = LockBufHdr(buf);
-			if (BUF_STATE_GET_REFCOUNT(local_buf_state) == 0
-				&& BUF_STATE_GET_USAGECOUNT(local_buf_state) == 0)
-			{
-				if (strategy != NULL)
-					AddBufferToRing(strategy, buf);
-				*buf_state = local_buf_state;
-				return buf;
-			}
-			UnlockBufHdr(buf, local_buf_state);
-
-		}
+		if (strategy != NULL)
+			AddBufferToRing(strategy, buf);
+		return buf;
 	}
 
 	/* Nothing on the freelist, so run the "clock sweep" algorithm */
@@ -363,7 +461,9 @@ StrategyGetBuffer(BufferAccessStrategy strategy, uint32 *buf_state)
 void
 StrategyFreeBuffer(BufferDesc *buf)
 {
-	SpinLockAcquire(&StrategyControl->buffer_strategy_lock);
+	BufferFreelist *freelist = BufferFreelistFor(buf->buf_id);
+
+	SpinLockAcquire(&freelist->lock);
 
 	/*
 	 * It is possible that we are told to put something in the freelist that
@@ -371,13 +471,54 @@ StrategyFreeBuffer(BufferDesc *buf)
 	 */
 	if (buf->freeNext == FREENEXT_NOT_IN_LIST)
 	{
-		buf->freeNext = StrategyControl->firstFreeBuffer;
+		buf->freeNext = freelist->firstFreeBuffer;
 		if (buf->freeNext < 0)
-			StrategyControl->lastFreeBuffer = buf->buf_id;
-		StrategyControl->firstFreeBuffer = buf->buf_id;
+			freelist->lastFreeBuffer = buf->buf_id;
+		freelist->firstFreeBuffer = buf->buf_id;
+		pg_atomic_fetch_add_u32(&StrategyControl->numFreeBuffers, 1);
 	}
 
-	SpinLockRelease(&StrategyControl->buffer_strategy_lock);
+	SpinLockRelease(&freelist->lock);
+}
+
+/*
+ * StrategyPutVictimBuffer: offer a reusable buffer to backends
+ *
+ * The bgwriter calls this for buffers it found clean, unpinned and with zero
+ * usage_count, so that backends can get them off the freelist instead of
+ * running the clock sweep themselves.  Unlike with StrategyFreeBuffer the
+ * buffer keeps its contents, which are only thrown away if no one uses it
+ * before it's taken, and it goes at the tail of the list, so that buffers
+ * are reused roughly in the order the bgwriter found them.
+ */
+void
+StrategyPutVictimBuffer(BufferDesc *buf)
+{
+	BufferFreelist *freelist = BufferFreelistFor(buf->buf_id);
+
+	SpinLockAcquire(&freelist->lock);
+
+	if (buf->freeNext == FREENEXT_NOT_IN_LIST)
+	{
+		buf->freeNext = FREENEXT_END_OF_LIST;
+		if (freelist->firstFreeBuffer < 0)
+			freelist->firstFreeBuffer = buf->buf_id;
+		else
+			GetBufferDescriptor(freelist->lastFreeBuffer)->freeNext = buf->buf_id;
+		freelist->lastFreeBuffer = buf->buf_id;
+		pg_atomic_fetch_add_u32(&StrategyControl->numFreeBuffers, 1);
+	}
+
+	SpinLockRelease(&freelist->lock);
+}
+
+/*
+ * StrategyFreeBufferCount -- approximate number of buffers on the freelists
+ */
+uint32
+StrategyFreeBufferCount(void)
+{
+	return pg_atomic_read_u32(&StrategyControl->numFreeBuffers);
 }
 
 /*
@@ -387,12 +528,14 @@ StrategyFreeBuffer(BufferDesc *buf)
  * BufferSync() will proceed circularly around the buffer array from there.
  *
  * In addition, we return the completed-pass count (which is effectively
- * the higher-order bits of nextVictimBuffer) and the count of recent buffer
- * allocs if non-NULL pointers are passed.  The alloc count is reset after
+ * the higher-order bits of nextVictimBuffer), the count of recent buffer
+ * allocs, and the count of recent allocs that had to write out a dirty
+ * victim, if non-NULL pointers are passed.  The counts are reset after
  * being read.
  */
 int
-StrategySyncStart(uint32 *complete_passes, uint32 *num_buf_alloc)
+StrategySyncStart(uint32 *complete_passes, uint32 *num_buf_alloc,
+				  uint32 *num_dirty_victims)
 {
 	uint32		nextVictimBuffer;
 	int			result;
@@ -416,10 +559,28 @@ StrategySyncStart(uint32 *complete_passes, uint32 *num_buf_alloc)
 	{
 		*num_buf_alloc = pg_atomic_exchange_u32(&StrategyControl->numBufferAllocs, 0);
 	}
+	if (num_dirty_victims)
+	{
+		*num_dirty_victims = pg_atomic_exchange_u32(&StrategyControl->numDirtyVictims, 0);
+	}
 	SpinLockRelease(&StrategyControl->buffer_strategy_lock);
 	return result;
 }
 
+/*
+ * StrategyCountDirtyVictim -- count an allocation that had to write out
+ * the victim buffer
+ *
+ * The bgwriter uses this to tell that it has fallen behind.  Buffers
+ * recycled by a strategy object are not meant to be counted, as writing
+ * those out is expected.
+ */
+void
+StrategyCountDirtyVictim(void)
+{
+	pg_atomic_fetch_add_u32(&StrategyControl->numDirtyVictims, 1);
+}
+
 /*
  * StrategyNotifyBgWriter -- set or clear allocation notification latch
  *
@@ -498,6 +659,8 @@ StrategyInitialize(bool init)
 
 	if (!found)
 	{
+		int			i;
+
 		/*
 		 * Only done once, usually in postmaster
 		 */
@@ -506,11 +669,25 @@ StrategyInitialize(bool init)
 		SpinLockInit(&StrategyControl->buffer_strategy_lock);
 
 		/*
-		 * Grab the whole linked list of free buffers for our strategy. We
-		 * assume it was previously set up by InitBufferPool().
+		 * Grab the linked lists of free buffers for our strategy. We assume
+		 * they were previously set up by InitBufferPool(), with buffer i in
+		 * the list of partition i % NUM_BUFFER_FREELISTS.
 		 */
-		StrategyControl->firstFreeBuffer = 0;
-		StrategyControl->lastFreeBuffer = NBuffers - 1;
+		for (i = 0; i < NUM_BUFFER_FREELISTS; i++)
+		{
+			BufferFreelist *freelist = &StrategyControl->freelists[i].list;
+
+			SpinLockInit(&freelist->lock);
+			if (i < NBuffers)
+			{
+				freelist->firstFreeBuffer = i;
+				freelist->lastFreeBuffer =
+					i + ((NBuffers - 1 - i) / NUM_BUFFER_FREELISTS) * NUM_BUFFER_FREELISTS;
+			}
+			else
+				freelist->firstFreeBuffer = -1;
+		}
+		pg_atomic_init_u32(&StrategyControl->numFreeBuffers, NBuffers);
 
 		/* Initialize the clock sweep pointer */
 		pg_atomic_init_u32(&StrategyControl->nextVictimBuffer, 0);
@@ -518,6 +695,7 @@ StrategyInitialize(bool init)
 		/* Clear statistics */
 		StrategyControl->completePasses = 0;
 		pg_atomic_init_u32(&StrategyControl->numBufferAllocs, 0);
+		pg_atomic_init_u32(&StrategyControl->numDirtyVictims, 0);
 
 		/* No pending notification */
 		StrategyControl->bgwprocno = -1;
@@ -601,6 +779,32 @@ FreeAccessStrategy(BufferAccessStrategy strategy)
 		pfree(strategy);
 }
 
+/*
+ * IOContextForStrategy -- the I/O context to count I/O done with the given
+ *		strategy under, for pg_stat_io
+ */
+IOContext
+IOContextForStrategy(BufferAccessStrategy strategy)
+{
+	/* a "default" strategy is normal access */
+	if (strategy == NULL)
+		return IOCONTEXT_NORMAL;
+
+	switch (strategy->btype)
+	{
+		case BAS_NORMAL:
+			break;
+		case BAS_BULKREAD:
+			return IOCONTEXT_BULKREAD;
+		case BAS_BULKWRITE:
+			return IOCONTEXT_BULKWRITE;
+		case BAS_VACUUM:
+			return IOCONTEXT_VACUUM;
+	}
+
+	return IOCONTEXT_NORMAL;
+}
+
 /*
  * GetBufferFromRing -- returns a buffer from the ring, or NULL if the
  *		ring is empty.
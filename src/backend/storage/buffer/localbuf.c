@@ -46,11 +46,30 @@ int32	   *LocalRefCount = NULL;
 
 static int	nextFreeLocalBuf = 0;
 
+/*
+ * Buffers not holding any page, chained through freeNext.  New buffers are
+ * taken from here before resorting to the clock sweep, so that the space of
+ * dropped temporary tables is reused before any live page is evicted.
+ */
+static int	firstFreeLocalBuf = FREENEXT_END_OF_LIST;
+
+/* Number of buffers holding a page (BM_TAG_VALID) */
+static int	nLocalBufsInUse = 0;
+
 static HTAB *LocalBufHash = NULL;
 
+/*
+ * When dropping the pages of a relation with fewer blocks than this, look
+ * each of them up in the hash table rather than scan all the buffers.
+ */
+#define LOCALBUF_DROP_FULL_SCAN_THRESHOLD	(NLocBuffer / 32)
+
 
 static void InitLocalBuffers(void);
 static Block GetLocalBufferStorage(void);
+static void InvalidateLocalBuffer(BufferDesc *bufHdr);
+static void FindAndDropLocalBuffers(RelFileNode rnode, ForkNumber forkNum,
+						BlockNumber nblocks, BlockNumber firstDelBlock);
 
 
 /*
@@ -85,7 +104,7 @@ LocalPrefetchBuffer(SMgrRelation smgr, ForkNumber forkNum,
 	}
 
 	/* Not in buffers, so initiate prefetch */
-	smgrprefetch(smgr, forkNum, blockNum);
+	smgrprefetch(smgr, forkNum, blockNum, 1);
 #endif							/* USE_PREFETCH */
 }
 
@@ -154,49 +173,66 @@ LocalBufferAlloc(SMgrRelation smgr, ForkNumber forkNum, BlockNumber blockNum,
 		return bufHdr;
 	}
 
-#ifdef LBDEBUG
-	fprintf(stderr, "LB ALLOC (%u,%d,%d) %d\n",
-			smgr->smgr_rnode.node.relNode, forkNum, blockNum,
-			-nextFreeLocalBuf - 1);
-#endif
-
 	/*
-	 * Need to get a new buffer.  We use a clock sweep algorithm (essentially
-	 * the same as what freelist.c does now...)
+	 * Need to get a new buffer.  Take one that holds no page if there is
+	 * any; buffers on the freelist are never pinned.
 	 */
-	trycounter = NLocBuffer;
-	for (;;)
+	if (firstFreeLocalBuf != FREENEXT_END_OF_LIST)
 	{
-		b = nextFreeLocalBuf;
+		b = firstFreeLocalBuf;
+		bufHdr = GetLocalBufferDescriptor(b);
+		firstFreeLocalBuf = bufHdr->freeNext;
+		bufHdr->freeNext = FREENEXT_NOT_IN_LIST;
 
-		if (++nextFreeLocalBuf >= NLocBuffer)
-			nextFreeLocalBuf = 0;
+		Assert(LocalRefCount[b] == 0);
+		buf_state = pg_atomic_read_u32(&bufHdr->state);
+		Assert(!(buf_state & BM_TAG_VALID));
 
-		bufHdr = GetLocalBufferDescriptor(b);
+		LocalRefCount[b]++;
+		ResourceOwnerRememberBuffer(CurrentResourceOwner,
+									BufferDescriptorGetBuffer(bufHdr));
+	}
 
-		if (LocalRefCount[b] == 0)
+	/*
+	 * Otherwise we use a clock sweep algorithm (essentially the same as what
+	 * freelist.c does now...)
+	 */
+	else
+	{
+		trycounter = NLocBuffer;
+		for (;;)
 		{
-			buf_state = pg_atomic_read_u32(&bufHdr->state);
+			b = nextFreeLocalBuf;
 
-			if (BUF_STATE_GET_USAGECOUNT(buf_state) > 0)
-			{
-				buf_state -= BUF_USAGECOUNT_ONE;
-				pg_atomic_unlocked_write_u32(&bufHdr->state, buf_state);
-				trycounter = NLocBuffer;
-			}
-			else
+			if (++nextFreeLocalBuf >= NLocBuffer)
+				nextFreeLocalBuf = 0;
+
+			bufHdr = GetLocalBufferDescriptor(b);
+
+			if (LocalRefCount[b] == 0)
 			{
-				/* Found a usable buffer */
-				LocalRefCount[b]++;
-				ResourceOwnerRememberBuffer(CurrentResourceOwner,
-											BufferDescriptorGetBuffer(bufHdr));
-				break;
+				buf_state = pg_atomic_read_u32(&bufHdr->state);
+
+				if (BUF_STATE_GET_USAGECOUNT(buf_state) > 0)
+				{
+					buf_state -= BUF_USAGECOUNT_ONE;
+					pg_atomic_unlocked_write_u32(&bufHdr->state, buf_state);
+					trycounter = NLocBuffer;
+				}
+				else
+				{
+					/* Found a usable buffer */
+					LocalRefCount[b]++;
+					ResourceOwnerRememberBuffer(CurrentResourceOwner,
+												BufferDescriptorGetBuffer(bufHdr));
+					break;
+				}
 			}
+			else if (--trycounter == 0)
+				ereport(ERROR,
+						(errcode(ERRCODE_INSUFFICIENT_RESOURCES),
+						 errmsg("no empty local buffer available")));
 		}
-		else if (--trycounter == 0)
-			ereport(ERROR,
-					(errcode(ERRCODE_INSUFFICIENT_RESOURCES),
-					 errmsg("no empty local buffer available")));
 	}
 
 	/*
@@ -219,6 +255,8 @@ LocalBufferAlloc(SMgrRelation smgr, ForkNumber forkNum, BlockNumber blockNum,
 				  bufHdr->tag.blockNum,
 				  localpage,
 				  false);
+		pgstat_count_io_op(IOOBJECT_TEMP_RELATION, IOCONTEXT_NORMAL,
+						   IOOP_WRITE);
 
 		/* Mark not-dirty now in case we error out below */
 		buf_state &= ~BM_DIRTY;
@@ -250,6 +288,7 @@ LocalBufferAlloc(SMgrRelation smgr, ForkNumber forkNum, BlockNumber blockNum,
 		CLEAR_BUFFERTAG(bufHdr->tag);
 		buf_state &= ~(BM_VALID | BM_TAG_VALID);
 		pg_atomic_unlocked_write_u32(&bufHdr->state, buf_state);
+		nLocalBufsInUse--;
 	}
 
 	hresult = (LocalBufferLookupEnt *)
@@ -267,6 +306,7 @@ LocalBufferAlloc(SMgrRelation smgr, ForkNumber forkNum, BlockNumber blockNum,
 	buf_state &= ~BUF_USAGECOUNT_MASK;
 	buf_state += BUF_USAGECOUNT_ONE;
 	pg_atomic_unlocked_write_u32(&bufHdr->state, buf_state);
+	nLocalBufsInUse++;
 
 	*foundPtr = false;
 	return bufHdr;
@@ -314,18 +354,34 @@ MarkLocalBufferDirty(Buffer buffer)
  *		out first.  Therefore, this is NOT rollback-able, and so should be
  *		used only with extreme caution!
  *
+ *		If only a few blocks are to be dropped, we look each of them up in
+ *		the hash table rather than scan all the buffers; temporary tables
+ *		are mostly small, while temp_buffers may be large.
+ *
  *		See DropRelFileNodeBuffers in bufmgr.c for more notes.
  */
 void
-DropRelFileNodeLocalBuffers(RelFileNode rnode, ForkNumber forkNum,
+DropRelFileNodeLocalBuffers(SMgrRelation smgr, ForkNumber forkNum,
 							BlockNumber firstDelBlock)
 {
+	RelFileNode rnode = smgr->smgr_rnode.node;
+	BlockNumber nblocks;
 	int			i;
 
+	if (nLocalBufsInUse == 0)
+		return;
+
+	nblocks = smgrexists(smgr, forkNum) ? smgrnblocks(smgr, forkNum) : 0;
+	if (nblocks <= firstDelBlock ||
+		nblocks - firstDelBlock < LOCALBUF_DROP_FULL_SCAN_THRESHOLD)
+	{
+		FindAndDropLocalBuffers(rnode, forkNum, nblocks, firstDelBlock);
+		return;
+	}
+
 	for (i = 0; i < NLocBuffer; i++)
 	{
 		BufferDesc *bufHdr = GetLocalBufferDescriptor(i);
-		LocalBufferLookupEnt *hresult;
 		uint32		buf_state;
 
 		buf_state = pg_atomic_read_u32(&bufHdr->state);
@@ -334,25 +390,7 @@ DropRelFileNodeLocalBuffers(RelFileNode rnode, ForkNumber forkNum,
 			RelFileNodeEquals(bufHdr->tag.rnode, rnode) &&
 			bufHdr->tag.forkNum == forkNum &&
 			bufHdr->tag.blockNum >= firstDelBlock)
-		{
-			if (LocalRefCount[i] != 0)
-				elog(ERROR, "block %u of %s is still referenced (local %u)",
-					 bufHdr->tag.blockNum,
-					 relpathbackend(bufHdr->tag.rnode, MyBackendId,
-									bufHdr->tag.forkNum),
-					 LocalRefCount[i]);
-			/* Remove entry from hashtable */
-			hresult = (LocalBufferLookupEnt *)
-				hash_search(LocalBufHash, (void *) &bufHdr->tag,
-							HASH_REMOVE, NULL);
-			if (!hresult)		/* shouldn't happen */
-				elog(ERROR, "local buffer hash table corrupted");
-			/* Mark buffer invalid */
-			CLEAR_BUFFERTAG(bufHdr->tag);
-			buf_state &= ~BUF_FLAG_MASK;
-			buf_state &= ~BUF_USAGECOUNT_MASK;
-			pg_atomic_unlocked_write_u32(&bufHdr->state, buf_state);
-		}
+			InvalidateLocalBuffer(bufHdr);
 	}
 }
 
@@ -361,45 +399,112 @@ DropRelFileNodeLocalBuffers(RelFileNode rnode, ForkNumber forkNum,
  *		This function removes from the buffer pool all pages of all forks
  *		of the specified relation.
  *
+ *		As in DropRelFileNodeLocalBuffers, the pages of a small relation are
+ *		looked up individually.
+ *
  *		See DropRelFileNodeAllBuffers in bufmgr.c for more notes.
  */
 void
-DropRelFileNodeAllLocalBuffers(RelFileNode rnode)
+DropRelFileNodeAllLocalBuffers(SMgrRelation smgr)
 {
+	RelFileNode rnode = smgr->smgr_rnode.node;
+	BlockNumber nblocks[MAX_FORKNUM + 1];
+	BlockNumber total = 0;
+	ForkNumber	forkNum;
 	int			i;
 
+	if (nLocalBufsInUse == 0)
+		return;
+
+	for (forkNum = 0; forkNum <= MAX_FORKNUM; forkNum++)
+	{
+		nblocks[forkNum] = 0;
+		if (smgrexists(smgr, forkNum))
+			nblocks[forkNum] = smgrnblocks(smgr, forkNum);
+		total += nblocks[forkNum];
+	}
+
+	if (total < LOCALBUF_DROP_FULL_SCAN_THRESHOLD)
+	{
+		for (forkNum = 0; forkNum <= MAX_FORKNUM; forkNum++)
+			FindAndDropLocalBuffers(rnode, forkNum, nblocks[forkNum], 0);
+		return;
+	}
+
 	for (i = 0; i < NLocBuffer; i++)
 	{
 		BufferDesc *bufHdr = GetLocalBufferDescriptor(i);
-		LocalBufferLookupEnt *hresult;
 		uint32		buf_state;
 
 		buf_state = pg_atomic_read_u32(&bufHdr->state);
 
 		if ((buf_state & BM_TAG_VALID) &&
 			RelFileNodeEquals(bufHdr->tag.rnode, rnode))
-		{
-			if (LocalRefCount[i] != 0)
-				elog(ERROR, "block %u of %s is still referenced (local %u)",
-					 bufHdr->tag.blockNum,
-					 relpathbackend(bufHdr->tag.rnode, MyBackendId,
-									bufHdr->tag.forkNum),
-					 LocalRefCount[i]);
-			/* Remove entry from hashtable */
-			hresult = (LocalBufferLookupEnt *)
-				hash_search(LocalBufHash, (void *) &bufHdr->tag,
-							HASH_REMOVE, NULL);
-			if (!hresult)		/* shouldn't happen */
-				elog(ERROR, "local buffer hash table corrupted");
-			/* Mark buffer invalid */
-			CLEAR_BUFFERTAG(bufHdr->tag);
-			buf_state &= ~BUF_FLAG_MASK;
-			buf_state &= ~BUF_USAGECOUNT_MASK;
-			pg_atomic_unlocked_write_u32(&bufHdr->state, buf_state);
-		}
+			InvalidateLocalBuffer(bufHdr);
+	}
+}
+
+/*
+ * FindAndDropLocalBuffers
+ *		Drop the given fork's pages with block numbers from firstDelBlock up
+ *		to nblocks, looking them up in the hash table.
+ */
+static void
+FindAndDropLocalBuffers(RelFileNode rnode, ForkNumber forkNum,
+						BlockNumber nblocks, BlockNumber firstDelBlock)
+{
+	BlockNumber blkno;
+
+	for (blkno = firstDelBlock; blkno < nblocks; blkno++)
+	{
+		BufferTag	tag;
+		LocalBufferLookupEnt *hresult;
+
+		INIT_BUFFERTAG(tag, rnode, forkNum, blkno);
+
+		hresult = (LocalBufferLookupEnt *)
+			hash_search(LocalBufHash, (void *) &tag, HASH_FIND, NULL);
+		if (hresult)
+			InvalidateLocalBuffer(GetLocalBufferDescriptor(hresult->id));
 	}
 }
 
+/*
+ * InvalidateLocalBuffer
+ *		Discard the page held by a local buffer, and put it on the freelist.
+ */
+static void
+InvalidateLocalBuffer(BufferDesc *bufHdr)
+{
+	int			b = -(bufHdr->buf_id + 2);
+	LocalBufferLookupEnt *hresult;
+	uint32		buf_state;
+
+	if (LocalRefCount[b] != 0)
+		elog(ERROR, "block %u of %s is still referenced (local %u)",
+			 bufHdr->tag.blockNum,
+			 relpathbackend(bufHdr->tag.rnode, MyBackendId,
+							bufHdr->tag.forkNum),
+			 LocalRefCount[b]);
+	/* Remove entry from hashtable */
+	hresult = (LocalBufferLookupEnt *)
+		hash_search(LocalBufHash, (void *) &bufHdr->tag,
+					HASH_REMOVE, NULL);
+	if (!hresult)				/* shouldn't happen */
+		elog(ERROR, "local buffer hash table corrupted");
+	/* Mark buffer invalid */
+	CLEAR_BUFFERTAG(bufHdr->tag);
+	buf_state = pg_atomic_read_u32(&bufHdr->state);
+	buf_state &= ~BUF_FLAG_MASK;
+	buf_state &= ~BUF_USAGECOUNT_MASK;
+	pg_atomic_unlocked_write_u32(&bufHdr->state, buf_state);
+	nLocalBufsInUse--;
+
+	/* and make it the first to be reused */
+	bufHdr->freeNext = firstFreeLocalBuf;
+	firstFreeLocalBuf = b;
+}
+
 /*
  * InitLocalBuffers -
  *	  init the local buffer cache. Since most queries (esp. multi-user ones)
@@ -436,6 +541,8 @@ InitLocalBuffers(void)
 				 errmsg("out of memory")));
 
 	nextFreeLocalBuf = 0;
+	firstFreeLocalBuf = (nbufs > 0) ? 0 : FREENEXT_END_OF_LIST;
+	nLocalBufsInUse = 0;
 
 	/* initialize fields that need to start off nonzero */
 	for (i = 0; i < nbufs; i++)
@@ -450,6 +557,9 @@ InitLocalBuffers(void)
 		 */
 		buf->buf_id = -i - 2;
 
+		/* all buffers start out on the freelist, in order */
+		buf->freeNext = (i < nbufs - 1) ? i + 1 : FREENEXT_END_OF_LIST;
+
 		/*
 		 * Intentionally do not initialize the buffer's atomic variable
 		 * (besides zeroing the underlying memory above). That way we get
@@ -745,6 +745,37 @@ BufFileSeekBlock(BufFile *file, long blknum)
 					   SEEK_SET);
 }
 
+/*
+ * BufFilePrefetchBlock --- initiate asynchronous read of blocks
+ *
+ * Advises the kernel that the nblocks BLCKSZ-sized blocks starting at
+ * blknum will be read soon.  Blocks past the end of the file are ignored.
+ * This is a no-op on platforms without posix_fadvise().
+ */
+void
+BufFilePrefetchBlock(BufFile *file, long blknum, int nblocks)
+{
+#ifdef USE_PREFETCH
+	while (nblocks > 0)
+	{
+		int			fileno = (int) (blknum / BUFFILE_SEG_SIZE);
+		long		segblk = blknum % BUFFILE_SEG_SIZE;
+		int			nthistime;
+
+		if (fileno >= file->numFiles)
+			break;
+
+		nthistime = (int) Min((long) nblocks, BUFFILE_SEG_SIZE - segblk);
+		(void) FilePrefetch(file->files[fileno],
+							(off_t) segblk * BLCKSZ,
+							nthistime * BLCKSZ,
+							WAIT_EVENT_BUFFILE_READ);
+		blknum += nthistime;
+		nblocks -= nthistime;
+	}
+#endif							/* USE_PREFETCH */
+}
+
 #ifdef NOT_USED
 /*
  * BufFileTellBlock --- block-oriented tell
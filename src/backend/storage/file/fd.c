@@ -148,6 +148,9 @@ int			max_safe_fds = 32;	/* default if not changed */
 /* Whether it is safe to continue running after fsync() fails. */
 bool		data_sync_retry = false;
 
+/* Which kinds of files to open with O_DIRECT; see io_direct GUC */
+int			io_direct_flags = 0;
+
 /* Debugging.... */
 
 #ifdef FDDEBUG
@@ -1830,6 +1833,41 @@ FileWriteback(File file, off_t offset, off_t nbytes, uint32 wait_event_info)
 	pgstat_report_wait_end();
 }
 
+/*
+ * FileFallocate - reserve space for a byte range of a file
+ *
+ * The file's size is not changed, so the space is invisible to everything
+ * but the filesystem's block allocator: later writes into the range just
+ * don't have to allocate.  This is purely an optimization, so failures
+ * (including lack of support by the platform or filesystem) are ignored.
+ */
+void
+FileFallocate(File file, off_t offset, off_t amount, uint32 wait_event_info)
+{
+#if defined(FALLOC_FL_KEEP_SIZE)
+	int			returnCode;
+
+	Assert(FileIsValid(file));
+
+	DO_DB(elog(LOG, "FileFallocate: %d (%s) " INT64_FORMAT " " INT64_FORMAT,
+			   file, VfdCache[file].fileName,
+			   (int64) offset, (int64) amount));
+
+	if (amount <= 0)
+		return;
+
+	returnCode = FileAccess(file);
+	if (returnCode < 0)
+		return;
+
+	pgstat_report_wait_start(wait_event_info);
+	(void) fallocate(VfdCache[file].fd, FALLOC_FL_KEEP_SIZE, offset, amount);
+	pgstat_report_wait_end();
+#else
+	Assert(FileIsValid(file));
+#endif
+}
+
 int
 FileRead(File file, char *buffer, int amount, off_t offset,
 		 uint32 wait_event_info)
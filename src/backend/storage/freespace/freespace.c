@@ -190,6 +190,61 @@ RecordPageWithFreeSpace(Relation rel, BlockNumber heapBlk, Size spaceAvail)
 	fsm_set_and_search(rel, addr, slot, new_cat, 0);
 }
 
+/*
+ * RecordPageWithFreeSpaceAndPropagate - like RecordPageWithFreeSpace, but
+ *		make the new value visible to searchers right away.
+ *
+ * If the new value raises the maximum of the FSM page covering heapBlk, the
+ * upper levels are raised to match, as far as needed.  That is usually no
+ * more than one or two extra page accesses, so this is cheap enough for use
+ * outside VACUUM, when a page has unexpectedly gained a lot of free space.
+ */
+void
+RecordPageWithFreeSpaceAndPropagate(Relation rel, BlockNumber heapBlk,
+									Size spaceAvail)
+{
+	uint8		new_cat = fsm_space_avail_to_cat(spaceAvail);
+	FSMAddress	addr;
+	uint16		slot;
+
+	/* Get the location of the FSM byte representing the heap block */
+	addr = fsm_get_location(heapBlk, &slot);
+
+	for (;;)
+	{
+		Buffer		buf;
+		Page		page;
+		uint8		old_max;
+
+		buf = fsm_readbuf(rel, addr, addr.level == FSM_BOTTOM_LEVEL);
+		if (!BufferIsValid(buf))
+			break;
+		LockBuffer(buf, BUFFER_LOCK_EXCLUSIVE);
+		page = BufferGetPage(buf);
+
+		old_max = fsm_get_max_avail(page);
+
+		/*
+		 * The bottom level gets the exact value; upper levels only ever need
+		 * to be raised, since they hold the maximum over many heap pages.
+		 */
+		if (addr.level == FSM_BOTTOM_LEVEL ||
+			fsm_get_avail(page, slot) < new_cat)
+		{
+			if (fsm_set_avail(page, slot, new_cat))
+				MarkBufferDirtyHint(buf, false);
+		}
+
+		UnlockReleaseBuffer(buf);
+
+		/* Stop once the page's maximum, as seen by its parent, is unchanged */
+		if (new_cat <= old_max || addr.level == FSM_ROOT_LEVEL)
+			break;
+
+		addr = fsm_get_parent(addr, &slot);
+	}
+}
+
 /*
  * XLogRecordPageWithFreeSpace - like RecordPageWithFreeSpace, for use in
  *		WAL replay
@@ -22,6 +22,11 @@
  * The Windows implementation uses Windows events that are inherited by all
  * postmaster child processes. There's no need for the self-pipe trick there.
  *
+ * On Linux, a WaitEventSet can additionally be switched to waiting through
+ * an io_uring (see WaitEventSetEnableIoUring()).  That allows registering
+ * the wait and receiving from a socket in a single system call, see
+ * WaitEventSetWaitRecv().
+ *
  * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
  * Portions Copyright (c) 1994, Regents of the University of California
  *
@@ -42,6 +47,12 @@
 #ifdef HAVE_POLL_H
 #include <poll.h>
 #endif
+#ifdef HAVE_LINUX_IO_URING_H
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
 
 #include "miscadmin.h"
 #include "pgstat.h"
@@ -52,6 +63,7 @@
 #include "storage/latch.h"
 #include "storage/pmsignal.h"
 #include "storage/shmem.h"
+#include "utils/memutils.h"
 
 /*
  * Select the fd readiness primitive to use. Normally the "most modern"
@@ -72,6 +84,87 @@
 #error "no wait set implementation available"
 #endif
 
+/*
+ * io_uring is not a readiness primitive of its own here, but an optional
+ * alternative way of waiting for the events of an epoll-based set.
+ */
+#if defined(WAIT_USE_EPOLL) && defined(HAVE_LINUX_IO_URING_H) && \
+	defined(__NR_io_uring_setup)
+#define WAIT_USE_IO_URING
+#endif
+
+/* GUC variable */
+bool		use_io_uring = false;
+
+#if defined(WAIT_USE_IO_URING)
+/* Kinds of requests submitted to an io_uring, encoded in their user_data */
+#define RING_REQ_POLL		1	/* POLL_ADD for a WaitEvent */
+#define RING_REQ_RECV_POLL	2	/* POLL_ADD linked to a RING_REQ_RECV */
+#define RING_REQ_RECV		3	/* RECV for WaitEventSetWaitRecv() */
+#define RING_REQ_REMOVE		4	/* POLL_REMOVE of an earlier POLL_ADD */
+
+#define RING_USER_DATA(kind, pos, gen) \
+	(((uint64) (kind) << 56) | ((uint64) (pos) << 32) | (uint64) (gen))
+#define RING_USER_DATA_KIND(ud)	((int) ((ud) >> 56))
+#define RING_USER_DATA_POS(ud)	((int) (((ud) >> 32) & 0xFFFFFF))
+#define RING_USER_DATA_GEN(ud)	((uint32) (ud))
+
+/*
+ * State of an io_uring used by a WaitEventSet.
+ *
+ * Each WaitEvent gets a one-shot POLL_ADD request, which is re-armed by the
+ * next wait after it has completed.  Polls submitted for an event mask that
+ * has since been changed are removed, and their completions recognized by
+ * their generation number and ignored.  When a receive was requested by
+ * WaitEventSetWaitRecv(), the socket's event instead gets a POLL_ADD linked
+ * to a RECV; the poll is needed because the socket is in non-blocking mode,
+ * which the kernel respects by failing the RECV with EAGAIN otherwise.
+ */
+typedef struct WaitEventRing
+{
+	int			fd;
+
+	/* submission queue, shared with the kernel */
+	unsigned   *sq_head;
+	unsigned   *sq_tail;
+	unsigned   *sq_array;
+	unsigned	sq_mask;
+	unsigned	sq_entries;
+	struct io_uring_sqe *sqes;
+	unsigned	sq_local_tail;	/* tail including not yet published SQEs */
+	unsigned	sq_unsubmitted; /* number of published, unsubmitted SQEs */
+
+	/* completion queue, shared with the kernel */
+	unsigned   *cq_head;
+	unsigned   *cq_tail;
+	unsigned	cq_mask;
+	struct io_uring_cqe *cqes;
+
+	/* mappings, for FreeWaitEventSet() */
+	void	   *sq_map;
+	size_t		sq_map_size;
+	void	   *cq_map;
+	size_t		cq_map_size;
+	size_t		sqes_map_size;
+
+	/* per-event poll mask and generation of outstanding POLL_ADD, if any */
+	uint32	   *armed_mask;
+	uint32	   *armed_gen;
+	uint32		next_gen;
+
+	/* receive requested by WaitEventSetWaitRecv(), recv_pos < 0 if none */
+	int			recv_pos;
+	char	   *recv_buf;
+	size_t		recv_len;
+	bool		recv_outstanding;	/* RECV submitted, not completed */
+	uint32		recv_gen;
+	bool		recv_done;		/* RECV completed with recv_result */
+	ssize_t		recv_result;
+	int			recv_errno;
+	bool		recv_unsupported;	/* kernel lacks IORING_OP_RECV */
+} WaitEventRing;
+#endif
+
 /* typedef in latch.h */
 struct WaitEventSet
 {
@@ -104,6 +197,10 @@ struct WaitEventSet
 	int			epoll_fd;
 	/* epoll_wait returns events in a user provided arrays, allocate once */
 	struct epoll_event *epoll_ret_events;
+#if defined(WAIT_USE_IO_URING)
+	/* set up by WaitEventSetEnableIoUring(), else NULL */
+	WaitEventRing *ring;
+#endif
 #elif defined(WAIT_USE_POLL)
 	/* poll expects events to be waited on every poll() call, prepare once */
 	struct pollfd *pollfds;
@@ -136,6 +233,12 @@ static void drainSelfPipe(void);
 
 #if defined(WAIT_USE_EPOLL)
 static void WaitEventAdjustEpoll(WaitEventSet *set, WaitEvent *event, int action);
+#if defined(WAIT_USE_IO_URING)
+static int	WaitEventSetWaitRing(WaitEventSet *set, WaitEvent *occurred_events,
+					 int nevents);
+static void RingFinishRecv(WaitEventSet *set);
+static void RingFree(WaitEventRing *ring);
+#endif
 #elif defined(WAIT_USE_POLL)
 static void WaitEventAdjustPoll(WaitEventSet *set, WaitEvent *event);
 #elif defined(WAIT_USE_WIN32)
@@ -631,6 +734,10 @@ FreeWaitEventSet(WaitEventSet *set)
 {
 #if defined(WAIT_USE_EPOLL)
 	close(set->epoll_fd);
+#if defined(WAIT_USE_IO_URING)
+	if (set->ring != NULL)
+		RingFree(set->ring);
+#endif
 #elif defined(WAIT_USE_WIN32)
 	WaitEvent  *cur_event;
 
@@ -1054,6 +1161,192 @@ WaitEventSetWait(WaitEventSet *set, long timeout,
 	return returned_events;
 }
 
+/*
+ * Make the set wait through an io_uring from now on, if possible.
+ *
+ * Returns false, with errno set, if io_uring is not supported by this build
+ * or by the kernel; the set keeps working as before in that case.
+ *
+ * Only waits without timeout use the ring.  Setting up a ring is much more
+ * expensive than creating an epoll descriptor, so this is only worthwhile
+ * for long-lived sets.
+ */
+bool
+WaitEventSetEnableIoUring(WaitEventSet *set)
+{
+#if defined(WAIT_USE_IO_URING)
+	WaitEventRing *ring;
+	struct io_uring_params params;
+	unsigned	entries;
+	int			save_errno;
+
+	if (set->ring != NULL)
+		return true;
+
+	ring = (WaitEventRing *)
+		MemoryContextAllocZero(GetMemoryChunkContext(set),
+							   sizeof(WaitEventRing) +
+							   2 * sizeof(uint32) * set->nevents_space);
+	ring->armed_mask = (uint32 *) (ring + 1);
+	ring->armed_gen = ring->armed_mask + set->nevents_space;
+	ring->recv_pos = -1;
+
+	/* room for a poll and a removal per event, plus a linked receive */
+	entries = 2 * set->nevents_space + 2;
+
+	memset(&params, 0, sizeof(params));
+	ring->fd = syscall(__NR_io_uring_setup, entries, &params);
+	if (ring->fd < 0)
+	{
+		save_errno = errno;
+		pfree(ring);
+		errno = save_errno;
+		return false;
+	}
+
+	ring->sq_map_size = params.sq_off.array +
+		params.sq_entries * sizeof(unsigned);
+	ring->cq_map_size = params.cq_off.cqes +
+		params.cq_entries * sizeof(struct io_uring_cqe);
+	if (params.features & IORING_FEAT_SINGLE_MMAP)
+		ring->sq_map_size = ring->cq_map_size =
+			Max(ring->sq_map_size, ring->cq_map_size);
+	ring->sqes_map_size = params.sq_entries * sizeof(struct io_uring_sqe);
+
+	ring->sq_map = mmap(NULL, ring->sq_map_size, PROT_READ | PROT_WRITE,
+						MAP_SHARED | MAP_POPULATE, ring->fd,
+						IORING_OFF_SQ_RING);
+	if (ring->sq_map == MAP_FAILED)
+	{
+		ring->sq_map = NULL;
+		goto fail;
+	}
+	if (params.features & IORING_FEAT_SINGLE_MMAP)
+		ring->cq_map = ring->sq_map;
+	else
+	{
+		ring->cq_map = mmap(NULL, ring->cq_map_size, PROT_READ | PROT_WRITE,
+							MAP_SHARED | MAP_POPULATE, ring->fd,
+							IORING_OFF_CQ_RING);
+		if (ring->cq_map == MAP_FAILED)
+		{
+			ring->cq_map = NULL;
+			goto fail;
+		}
+	}
+	ring->sqes = mmap(NULL, ring->sqes_map_size, PROT_READ | PROT_WRITE,
+					  MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+	if (ring->sqes == MAP_FAILED)
+	{
+		ring->sqes = NULL;
+		goto fail;
+	}
+
+	ring->sq_head = (unsigned *) ((char *) ring->sq_map + params.sq_off.head);
+	ring->sq_tail = (unsigned *) ((char *) ring->sq_map + params.sq_off.tail);
+	ring->sq_array = (unsigned *) ((char *) ring->sq_map + params.sq_off.array);
+	ring->sq_mask = *(unsigned *) ((char *) ring->sq_map +
+								   params.sq_off.ring_mask);
+	ring->sq_entries = params.sq_entries;
+	ring->sq_local_tail = *ring->sq_tail;
+
+	ring->cq_head = (unsigned *) ((char *) ring->cq_map + params.cq_off.head);
+	ring->cq_tail = (unsigned *) ((char *) ring->cq_map + params.cq_off.tail);
+	ring->cq_mask = *(unsigned *) ((char *) ring->cq_map +
+								   params.cq_off.ring_mask);
+	ring->cqes = (struct io_uring_cqe *) ((char *) ring->cq_map +
+										  params.cq_off.cqes);
+
+	set->ring = ring;
+	return true;
+
+fail:
+	save_errno = errno;
+	RingFree(ring);
+	errno = save_errno;
+	return false;
+#else
+	errno = ENOSYS;
+	return false;
+#endif
+}
+
+/*
+ * Wait for the events in the set like WaitEventSetWait() does, without
+ * timeout and returning at most one event.  If that event is the socket at
+ * 'pos' becoming readable, also receive up to 'len' bytes from it into 'buf'
+ * and return the result of that in *nread, like recv(2) would; errno is set
+ * if it is -1.
+ *
+ * With an io_uring (see WaitEventSetEnableIoUring()), waiting and receiving
+ * take a single system call rather than two.
+ */
+int
+WaitEventSetWaitRecv(WaitEventSet *set, int pos, void *buf, size_t len,
+					 ssize_t *nread, WaitEvent *occurred_event,
+					 uint32 wait_event_info)
+{
+	int			rc;
+
+	Assert(pos < set->nevents);
+	Assert(set->events[pos].events == WL_SOCKET_READABLE);
+
+#if defined(WAIT_USE_IO_URING)
+	if (set->ring != NULL && !set->ring->recv_unsupported)
+	{
+		WaitEventRing *ring = set->ring;
+
+		ring->recv_pos = pos;
+		ring->recv_buf = buf;
+		ring->recv_len = len;
+		ring->recv_done = false;
+
+		rc = WaitEventSetWait(set, -1, occurred_event, 1, wait_event_info);
+
+		/* Don't leave the kernel with a pointer to the caller's buffer */
+		RingFinishRecv(set);
+		ring->recv_pos = -1;
+
+		/*
+		 * If data was received, report that regardless of what else
+		 * happened.  A latch that was set as well stays set, and an exited
+		 * postmaster will be noticed by the next wait.
+		 */
+		if (ring->recv_done)
+		{
+			occurred_event->pos = pos;
+			occurred_event->user_data = set->events[pos].user_data;
+			occurred_event->events = WL_SOCKET_READABLE;
+			occurred_event->fd = set->events[pos].fd;
+			*nread = ring->recv_result;
+			errno = ring->recv_errno;
+			return 1;
+		}
+
+		/*
+		 * Otherwise the socket can only have been reported if the kernel
+		 * turned out to lack the RECV operation; receive below then.
+		 */
+	}
+	else
+#endif
+		rc = WaitEventSetWait(set, -1, occurred_event, 1, wait_event_info);
+
+	if (rc > 0 && occurred_event->pos == pos &&
+		(occurred_event->events & WL_SOCKET_READABLE))
+	{
+#ifdef WIN32
+		pgwin32_noblock = true;
+#endif
+		*nread = recv(set->events[pos].fd, buf, len, 0);
+#ifdef WIN32
+		pgwin32_noblock = false;
+#endif
+	}
+
+	return rc;
+}
+
 
 #if defined(WAIT_USE_EPOLL)
 
@@ -1074,6 +1367,12 @@ WaitEventSetWaitBlock(WaitEventSet *set, int cur_timeout,
 	WaitEvent  *cur_event;
 	struct epoll_event *cur_epoll_event;
 
+#if defined(WAIT_USE_IO_URING)
+	/* The ring is only used for waits without timeout */
+	if (set->ring != NULL && cur_timeout < 0)
+		return WaitEventSetWaitRing(set, occurred_events, nevents);
+#endif
+
 	/* Sleep */
 	rc = epoll_wait(set->epoll_fd, set->epoll_ret_events,
 					nevents, cur_timeout);
@@ -1182,6 +1481,368 @@ WaitEventSetWaitBlock(WaitEventSet *set, int cur_timeout,
 	return returned_events;
 }
 
+#if defined(WAIT_USE_IO_URING)
+
+/*
+ * Release the kernel resources of a ring.
+ */
+static void
+RingFree(WaitEventRing *ring)
+{
+	if (ring->sqes != NULL)
+		munmap(ring->sqes, ring->sqes_map_size);
+	if (ring->cq_map != NULL && ring->cq_map != ring->sq_map)
+		munmap(ring->cq_map, ring->cq_map_size);
+	if (ring->sq_map != NULL)
+		munmap(ring->sq_map, ring->sq_map_size);
+	if (ring->fd >= 0)
+		close(ring->fd);
+	pfree(ring);
+}
+
+/*
+ * Pass the queued SQEs to the kernel, and wait for at least min_complete
+ * completions.  Returns -1 with errno set on failure.
+ */
+static int
+RingEnter(WaitEventRing *ring, unsigned min_complete)
+{
+	int			rc;
+
+	rc = syscall(__NR_io_uring_enter, ring->fd, ring->sq_unsubmitted,
+				 min_complete, min_complete > 0 ? IORING_ENTER_GETEVENTS : 0,
+				 NULL, 0);
+	if (rc >= 0)
+	{
+		Assert(rc <= ring->sq_unsubmitted);
+		ring->sq_unsubmitted -= rc;
+	}
+	return rc;
+}
+
+/*
+ * Get a zeroed SQE to fill in.  RingPublish() must be called before the
+ * next call.
+ */
+static struct io_uring_sqe *
+RingGetSQE(WaitEventRing *ring)
+{
+	struct io_uring_sqe *sqe;
+
+	/* Make room, if the submission queue is full */
+	while (ring->sq_local_tail - *ring->sq_head >= ring->sq_entries)
+	{
+		if (RingEnter(ring, 0) < 0 && errno != EINTR)
+			elog(ERROR, "io_uring_enter() failed: %m");
+		pg_read_barrier();
+	}
+
+	sqe = &ring->sqes[ring->sq_local_tail & ring->sq_mask];
+	memset(sqe, 0, sizeof(*sqe));
+	return sqe;
+}
+
+/*
+ * Make the SQE returned by the last RingGetSQE() visible to the kernel.
+ */
+static void
+RingPublish(WaitEventRing *ring)
+{
+	unsigned	idx = ring->sq_local_tail & ring->sq_mask;
+
+	ring->sq_array[idx] = idx;
+	ring->sq_local_tail++;
+	pg_write_barrier();
+	*ring->sq_tail = ring->sq_local_tail;
+	ring->sq_unsubmitted++;
+}
+
+static void
+RingSubmitPoll(WaitEventRing *ring, int kind, WaitEvent *event, uint32 mask,
+			   uint32 gen, bool link)
+{
+	struct io_uring_sqe *sqe = RingGetSQE(ring);
+
+	sqe->opcode = IORING_OP_POLL_ADD;
+	sqe->fd = event->fd;
+	sqe->poll_events = mask;
+	if (link)
+		sqe->flags = IOSQE_IO_LINK;
+	sqe->user_data = RING_USER_DATA(kind, event->pos, gen);
+	RingPublish(ring);
+}
+
+static void
+RingSubmitRemove(WaitEventRing *ring, uint64 target)
+{
+	struct io_uring_sqe *sqe = RingGetSQE(ring);
+
+	sqe->opcode = IORING_OP_POLL_REMOVE;
+	sqe->fd = -1;
+	sqe->addr = target;
+	sqe->user_data = RING_USER_DATA(RING_REQ_REMOVE, 0, 0);
+	RingPublish(ring);
+}
+
+/*
+ * Make sure the event has the right request outstanding in the ring.
+ */
+static void
+RingArmEvent(WaitEventSet *set, WaitEvent *event)
+{
+	WaitEventRing *ring = set->ring;
+	int			pos = event->pos;
+	uint32		mask = 0;
+
+	if (pos == ring->recv_pos)
+	{
+		/* A receive replaces any plain poll for this socket */
+		if (ring->armed_mask[pos] != 0)
+		{
+			RingSubmitRemove(ring, RING_USER_DATA(RING_REQ_POLL, pos,
+												  ring->armed_gen[pos]));
+			ring->armed_mask[pos] = 0;
+		}
+
+		if (!ring->recv_outstanding)
+		{
+			struct io_uring_sqe *sqe;
+
+			ring->recv_gen = ++ring->next_gen;
+			RingSubmitPoll(ring, RING_REQ_RECV_POLL, event, POLLIN,
+						   ring->recv_gen, true);
+
+			sqe = RingGetSQE(ring);
+			sqe->opcode = IORING_OP_RECV;
+			sqe->fd = event->fd;
+			sqe->addr = (uint64) (uintptr_t) ring->recv_buf;
+			sqe->len = ring->recv_len;
+			sqe->user_data = RING_USER_DATA(RING_REQ_RECV, pos,
+											ring->recv_gen);
+			RingPublish(ring);
+			ring->recv_outstanding = true;
+		}
+		return;
+	}
+
+	if (event->events == WL_LATCH_SET || event->events == WL_POSTMASTER_DEATH)
+		mask = POLLIN;
+	else
+	{
+		if (event->events & WL_SOCKET_READABLE)
+			mask |= POLLIN;
+		if (event->events & WL_SOCKET_WRITEABLE)
+			mask |= POLLOUT;
+	}
+
+	if (ring->armed_mask[pos] == mask)
+		return;
+
+	/* The event mask was changed; the old poll is of no use anymore */
+	if (ring->armed_mask[pos] != 0)
+		RingSubmitRemove(ring, RING_USER_DATA(RING_REQ_POLL, pos,
+											  ring->armed_gen[pos]));
+
+	ring->armed_gen[pos] = ++ring->next_gen;
+	ring->armed_mask[pos] = mask;
+	RingSubmitPoll(ring, RING_REQ_POLL, event, mask, ring->armed_gen[pos],
+				   false);
+}
+
+/*
+ * Process all available completions, storing up to nevents of the resulting
+ * events in occurred_events.
+ *
+ * Events beyond nevents are simply dropped: their polls are re-armed by the
+ * next wait and complete right away if the condition still holds.  The result
+ * of a receive is never lost, as it is remembered in the ring.
+ */
+static int
+RingReap(WaitEventSet *set, WaitEvent *occurred_events, int nevents)
+{
+	WaitEventRing *ring = set->ring;
+	int			returned_events = 0;
+	unsigned	head = *ring->cq_head;
+
+	for (;;)
+	{
+		struct io_uring_cqe *cqe;
+		uint64		ud;
+		int			res;
+		int			pos;
+		bool		is_recv = false;
+		WaitEvent  *cur_event;
+		uint32		events = 0;
+
+		pg_read_barrier();
+		if (head == *ring->cq_tail)
+			break;
+		pg_read_barrier();
+
+		cqe = &ring->cqes[head & ring->cq_mask];
+		ud = cqe->user_data;
+		res = cqe->res;
+		head++;
+
+		pos = RING_USER_DATA_POS(ud);
+		switch (RING_USER_DATA_KIND(ud))
+		{
+			case RING_REQ_POLL:
+				if (pos >= set->nevents ||
+					ring->armed_mask[pos] == 0 ||
+					ring->armed_gen[pos] != RING_USER_DATA_GEN(ud))
+					continue;	/* stale */
+				ring->armed_mask[pos] = 0;
+				if (res < 0)
+					continue;
+				break;
+
+			case RING_REQ_RECV:
+				Assert(ring->recv_outstanding &&
+					   ring->recv_gen == RING_USER_DATA_GEN(ud));
+				ring->recv_outstanding = false;
+				if (res == -ECANCELED)
+					continue;
+				if (res == -EINVAL || res == -EOPNOTSUPP)
+				{
+					/* kernel too old; caller will do the recv() itself */
+					ring->recv_unsupported = true;
+				}
+				else
+				{
+					ring->recv_done = true;
+					ring->recv_result = res < 0 ? -1 : res;
+					ring->recv_errno = res < 0 ? -res : 0;
+				}
+				is_recv = true;
+				break;
+
+			default:
+				/* RING_REQ_RECV_POLL and RING_REQ_REMOVE need no action */
+				continue;
+		}
+
+		cur_event = &set->events[pos];
+
+		if (is_recv)
+			events = WL_SOCKET_READABLE;
+		else if (cur_event->events == WL_LATCH_SET)
+		{
+			/* There's data in the self-pipe, clear it. */
+			drainSelfPipe();
+
+			if (set->latch->is_set)
+				events = WL_LATCH_SET;
+		}
+		else if (cur_event->events == WL_POSTMASTER_DEATH)
+		{
+			/* See comments in the epoll implementation */
+			if (!PostmasterIsAliveInternal())
+			{
+				if (set->exit_on_postmaster_death)
+					proc_exit(1);
+				events = WL_POSTMASTER_DEATH;
+			}
+		}
+		else
+		{
+			if ((cur_event->events & WL_SOCKET_READABLE) &&
+				(res & (POLLIN | POLLERR | POLLHUP)))
+				events |= WL_SOCKET_READABLE;
+			if ((cur_event->events & WL_SOCKET_WRITEABLE) &&
+				(res & (POLLOUT | POLLERR | POLLHUP)))
+				events |= WL_SOCKET_WRITEABLE;
+		}
+
+		if (events != 0 && returned_events < nevents)
+		{
+			occurred_events->pos = cur_event->pos;
+			occurred_events->user_data = cur_event->user_data;
+			occurred_events->events = events;
+			occurred_events->fd = (events & WL_SOCKET_MASK) ?
+				cur_event->fd : PGINVALID_SOCKET;
+			occurred_events++;
+			returned_events++;
+		}
+	}
+
+	/* Let the kernel reuse the CQEs */
+	pg_memory_barrier();
+	*ring->cq_head = head;
+
+	return returned_events;
+}
+
+/*
+ * Wait using the io_uring set up by WaitEventSetEnableIoUring().
+ *
+ * Re-arming the polls that completed in the last wait, and sleeping, takes a
+ * single io_uring_enter() call.
+ */
+static int
+WaitEventSetWaitRing(WaitEventSet *set, WaitEvent *occurred_events,
+					 int nevents)
+{
+	WaitEventRing *ring = set->ring;
+	int			i;
+
+	for (i = 0; i < set->nevents; i++)
+		RingArmEvent(set, &set->events[i]);
+
+	pg_read_barrier();
+	if (RingEnter(ring, *ring->cq_head == *ring->cq_tail ? 1 : 0) < 0)
+	{
+		/* EINTR is okay, otherwise complain */
+		if (errno != EINTR)
+		{
+			waiting = false;
+
+			/*
+			 * An outstanding receive might still write into the caller's
+			 * buffer at any time, which we can't allow once we've given up
+			 * control.
+			 */
+			ereport(ring->recv_outstanding ? FATAL : ERROR,
+					(errcode_for_socket_access(),
+					 errmsg("io_uring_enter() failed: %m")));
+		}
+	}
+
+	return RingReap(set, occurred_events, nevents);
+}
+
+/*
+ * Make sure the receive requested by WaitEventSetWaitRecv() is not
+ * outstanding anymore, cancelling it if necessary.
+ */
+static void
+RingFinishRecv(WaitEventSet *set)
+{
+	WaitEventRing *ring = set->ring;
+	WaitEvent	dummy;
+
+	if (!ring->recv_outstanding)
+		return;
+
+	/* Removing the poll ahead of it makes the RECV fail with ECANCELED */
+	RingSubmitRemove(ring, RING_USER_DATA(RING_REQ_RECV_POLL, ring->recv_pos,
+										  ring->recv_gen));
+
+	while (ring->recv_outstanding)
+	{
+		pg_read_barrier();
+		if (RingEnter(ring, *ring->cq_head == *ring->cq_tail ? 1 : 0) < 0 &&
+			errno != EINTR)
+			ereport(FATAL,
+					(errcode_for_socket_access(),
+					 errmsg("io_uring_enter() failed: %m")));
+
+		/* Other events found here are dropped, see RingReap() */
+		(void) RingReap(set, &dummy, 0);
+	}
+}
+#endif							/* WAIT_USE_IO_URING */
+
 #elif defined(WAIT_USE_POLL)
 
 /*
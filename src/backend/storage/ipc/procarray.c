@@ -92,6 +92,17 @@ typedef struct ProcArrayStruct
 	/* oldest catalog xmin of any replication slot */
 	TransactionId replication_slot_catalog_xmin;
 
+	/*
+	 * Number of times a transaction with an XID has stopped being shown as
+	 * running, or the set of running XIDs has otherwise changed in a way
+	 * that could make an earlier snapshot wrong.  GetSnapshotData compares
+	 * it with the value saved in the snapshot to see whether the snapshot's
+	 * contents can be reused without looking at the procs.  Zero is never
+	 * used, so that it can mark a snapshot as not reusable.  Must hold
+	 * exclusive ProcArrayLock to change this, and shared lock to read it.
+	 */
+	uint64		xactCompletionCount;
+
 	/* indexes into allPgXact[], has PROCARRAY_MAXPROCS entries */
 	int			pgprocnos[FLEXIBLE_ARRAY_MEMBER];
 } ProcArrayStruct;
@@ -106,6 +117,7 @@ static PGXACT *allPgXact;
  */
 static TransactionId *KnownAssignedXids;
 static bool *KnownAssignedXidsValid;
+static int32 *KnownAssignedXidsNext;
 static TransactionId latestObservedXid = InvalidTransactionId;
 
 /*
@@ -154,6 +166,7 @@ static void DisplayXidCache(void);
 
 /* Primitives for KnownAssignedXids array handling for standby */
 static void KnownAssignedXidsCompress(bool force);
+static inline int KnownAssignedXidsNextValid(int i, int head);
 static void KnownAssignedXidsAdd(TransactionId from_xid, TransactionId to_xid,
 					 bool exclusive_lock);
 static bool KnownAssignedXidsSearch(TransactionId xid, bool remove);
@@ -210,6 +223,8 @@ ProcArrayShmemSize(void)
 								 TOTAL_MAX_CACHED_SUBXIDS));
 		size = add_size(size,
 						mul_size(sizeof(bool), TOTAL_MAX_CACHED_SUBXIDS));
+		size = add_size(size,
+						mul_size(sizeof(int32), TOTAL_MAX_CACHED_SUBXIDS));
 	}
 
 	return size;
@@ -246,6 +261,7 @@ CreateSharedProcArray(void)
 		procArray->lastOverflowedXid = InvalidTransactionId;
 		procArray->replication_slot_xmin = InvalidTransactionId;
 		procArray->replication_slot_catalog_xmin = InvalidTransactionId;
+		procArray->xactCompletionCount = 1;
 	}
 
 	allProcs = ProcGlobal->allProcs;
@@ -263,6 +279,10 @@ CreateSharedProcArray(void)
 			ShmemInitStruct("KnownAssignedXidsValid",
 							mul_size(sizeof(bool), TOTAL_MAX_CACHED_SUBXIDS),
 							&found);
+		KnownAssignedXidsNext = (int32 *)
+			ShmemInitStruct("KnownAssignedXidsNext",
+							mul_size(sizeof(int32), TOTAL_MAX_CACHED_SUBXIDS),
+							&found);
 	}
 
 	/* Register and initialize fields of ProcLWLockTranche */
@@ -352,6 +372,9 @@ ProcArrayRemove(PGPROC *proc, TransactionId latestXid)
 		if (TransactionIdPrecedes(ShmemVariableCache->latestCompletedXid,
 								  latestXid))
 			ShmemVariableCache->latestCompletedXid = latestXid;
+
+		/* Existing snapshots may show the gxact as running */
+		arrayP->xactCompletionCount++;
 	}
 	else
 	{
@@ -467,6 +490,9 @@ ProcArrayEndTransactionInternal(PGPROC *proc, PGXACT *pgxact,
 	if (TransactionIdPrecedes(ShmemVariableCache->latestCompletedXid,
 							  latestXid))
 		ShmemVariableCache->latestCompletedXid = latestXid;
+
+	/* Existing snapshots may show the transaction as running */
+	procArray->xactCompletionCount++;
 }
 
 /*
@@ -602,11 +628,14 @@ ProcArrayClearTransaction(PGPROC *proc)
 	PGXACT	   *pgxact = &allPgXact[proc->pgprocno];
 
 	/*
-	 * We can skip locking ProcArrayLock here, because this action does not
-	 * actually change anyone's view of the set of running XIDs: our entry is
-	 * duplicate with the gxact that has already been inserted into the
-	 * ProcArray.
+	 * This action does not actually change anyone's view of the set of
+	 * running XIDs: our entry is duplicate with the gxact that has already
+	 * been inserted into the ProcArray.  But our own snapshots leave out our
+	 * XID, which from now on belongs to the gxact, so they must not be reused
+	 * by GetSnapshotData; we need the lock to bump xactCompletionCount.
 	 */
+	LWLockAcquire(ProcArrayLock, LW_EXCLUSIVE);
+
 	pgxact->xid = InvalidTransactionId;
 	proc->lxid = InvalidLocalTransactionId;
 	pgxact->xmin = InvalidTransactionId;
@@ -619,6 +648,10 @@ ProcArrayClearTransaction(PGPROC *proc)
 	/* Clear the subtransaction-XID cache too */
 	pgxact->nxids = 0;
 	pgxact->overflowed = false;
+
+	procArray->xactCompletionCount++;
+
+	LWLockRelease(ProcArrayLock);
 }
 
 /*
@@ -664,7 +697,6 @@ ProcArrayApplyRecoveryInfo(RunningTransactions running)
 {
 	TransactionId *xids;
 	int			nxids;
-	TransactionId nextXid;
 	int			i;
 
 	Assert(standbyState >= STANDBY_INITIALIZED);
@@ -882,22 +914,11 @@ ProcArrayApplyRecoveryInfo(RunningTransactions running)
 	LWLockRelease(ProcArrayLock);
 
 	/*
-	 * ShmemVariableCache->nextXid must be beyond any observed xid.
-	 *
-	 * We don't expect anyone else to modify nextXid, hence we don't need to
-	 * hold a lock while examining it.  We still acquire the lock to modify
-	 * it, though.
+	 * ShmemVariableCache->nextFullXid must be beyond any observed xid.
 	 */
-	nextXid = latestObservedXid;
-	TransactionIdAdvance(nextXid);
-	if (TransactionIdFollows(nextXid, ShmemVariableCache->nextXid))
-	{
-		LWLockAcquire(XidGenLock, LW_EXCLUSIVE);
-		ShmemVariableCache->nextXid = nextXid;
-		LWLockRelease(XidGenLock);
-	}
+	AdvanceNextFullTransactionIdPastXid(latestObservedXid);
 
-	Assert(TransactionIdIsValid(ShmemVariableCache->nextXid));
+	Assert(FullTransactionIdIsValid(ShmemVariableCache->nextFullXid));
 
 	KnownAssignedXidsDisplay(trace_recovery(DEBUG3));
 	if (standbyState == STANDBY_SNAPSHOT_READY)
@@ -1479,6 +1500,92 @@ GetMaxSnapshotSubxidCount(void)
 	return TOTAL_MAX_CACHED_SUBXIDS;
 }
 
+/*
+ * GetSnapshotDataReuse -- helper for GetSnapshotData
+ *
+ * If xactCompletionCount hasn't changed since the snapshot was last filled
+ * in, no XID has stopped running since then, and any XID assigned since then
+ * is >= the snapshot's xmax; so the snapshot's contents are exactly what a
+ * scan of the procs would produce now.  Read-mostly workloads take most of
+ * their snapshots this way, without the scan whose cost grows with the
+ * number of connections.  Snapshots taken during recovery, which are built
+ * from KnownAssignedXids, are never reused.
+ *
+ * We don't recompute RecentGlobalXmin and RecentGlobalDataXmin here; the
+ * previous values are still safe, just perhaps more conservative than
+ * needed until the next snapshot that is built from scratch.
+ *
+ * Caller must hold ProcArrayLock.  Returns true, having updated the fields
+ * that differ between calls except those set by
+ * GetSnapshotDataInitOldSnapshot, if the snapshot could be reused.
+ */
+static bool
+GetSnapshotDataReuse(Snapshot snapshot)
+{
+	Assert(LWLockHeldByMe(ProcArrayLock));
+
+	if (snapshot->snapXactCompletionCount == 0 ||
+		snapshot->snapXactCompletionCount != procArray->xactCompletionCount)
+		return false;
+	if (snapshot->takenDuringRecovery)
+		return false;
+
+	/*
+	 * Since no transaction has ended, the oldest running XID is still the
+	 * snapshot's xmin (or none is running, and xmax hasn't moved), so nobody
+	 * can have computed a horizon past it; it's as safe to advertise as if
+	 * we had just computed it.
+	 */
+	if (!TransactionIdIsValid(MyPgXact->xmin))
+		MyPgXact->xmin = TransactionXmin = snapshot->xmin;
+
+	RecentXmin = snapshot->xmin;
+	Assert(TransactionIdPrecedesOrEquals(TransactionXmin, RecentXmin));
+
+	snapshot->curcid = GetCurrentCommandId(false);
+
+	/*
+	 * This is a new snapshot, so set both refcounts are zero, and mark it as
+	 * not copied in persistent memory.
+	 */
+	snapshot->active_count = 0;
+	snapshot->regd_count = 0;
+	snapshot->copied = false;
+
+	return true;
+}
+
+/*
+ * GetSnapshotDataInitOldSnapshot -- helper for GetSnapshotData
+ *
+ * Fill in the fields used by the "snapshot too old" feature.  Must be called
+ * without ProcArrayLock held.
+ */
+static void
+GetSnapshotDataInitOldSnapshot(Snapshot snapshot)
+{
+	if (old_snapshot_threshold < 0)
+	{
+		/*
+		 * If not using "snapshot too old" feature, fill related fields with
+		 * dummy values that don't require any locking.
+		 */
+		snapshot->lsn = InvalidXLogRecPtr;
+		snapshot->whenTaken = 0;
+	}
+	else
+	{
+		/*
+		 * Capture the current time and WAL stream location in case this
+		 * snapshot becomes old enough to need to fall back on the special
+		 * "old snapshot" logic.
+		 */
+		snapshot->lsn = GetXLogInsertRecPtr();
+		snapshot->whenTaken = GetSnapshotCurrentTimestamp();
+		MaintainOldSnapshotTimeMapping(snapshot->whenTaken, snapshot->xmin);
+	}
+}
+
 /*
  * GetSnapshotData -- returns information about running transactions.
  *
@@ -1512,6 +1619,10 @@ GetMaxSnapshotSubxidCount(void)
  *		RecentGlobalDataXmin: the global xmin for non-catalog tables
  *			>= RecentGlobalXmin
  *
+ * If no transaction has ended since the snapshot was last filled in, we
+ * leave its contents alone and skip the scan of the procs altogether; see
+ * GetSnapshotDataReuse.
+ *
  * Note: this function should probably not be called with an argument that's
  * not statically allocated (see xip allocation below).
  */
@@ -1526,6 +1637,7 @@ GetSnapshotData(Snapshot snapshot)
 	int			count = 0;
 	int			subcount = 0;
 	bool		suboverflowed = false;
+	uint64		curXactCompletionCount;
 	TransactionId replication_slot_xmin = InvalidTransactionId;
 	TransactionId replication_slot_catalog_xmin = InvalidTransactionId;
 
@@ -1569,6 +1681,15 @@ GetSnapshotData(Snapshot snapshot)
 	 */
 	LWLockAcquire(ProcArrayLock, LW_SHARED);
 
+	if (GetSnapshotDataReuse(snapshot))
+	{
+		LWLockRelease(ProcArrayLock);
+		GetSnapshotDataInitOldSnapshot(snapshot);
+		return snapshot;
+	}
+
+	curXactCompletionCount = arrayP->xactCompletionCount;
+
 	/* xmax is always latestCompletedXid + 1 */
 	xmax = ShmemVariableCache->latestCompletedXid;
 	Assert(TransactionIdIsNormal(xmax));
@@ -1761,6 +1882,8 @@ GetSnapshotData(Snapshot snapshot)
 	snapshot->xcnt = count;
 	snapshot->subxcnt = subcount;
 	snapshot->suboverflowed = suboverflowed;
+	snapshot->xipSorted = false;
+	snapshot->snapXactCompletionCount = curXactCompletionCount;
 
 	snapshot->curcid = GetCurrentCommandId(false);
 
@@ -1772,26 +1895,7 @@ GetSnapshotData(Snapshot snapshot)
 	snapshot->regd_count = 0;
 	snapshot->copied = false;
 
-	if (old_snapshot_threshold < 0)
-	{
-		/*
-		 * If not using "snapshot too old" feature, fill related fields with
-		 * dummy values that don't require any locking.
-		 */
-		snapshot->lsn = InvalidXLogRecPtr;
-		snapshot->whenTaken = 0;
-	}
-	else
-	{
-		/*
-		 * Capture the current time and WAL stream location in case this
-		 * snapshot becomes old enough to need to fall back on the special
-		 * "old snapshot" logic.
-		 */
-		snapshot->lsn = GetXLogInsertRecPtr();
-		snapshot->whenTaken = GetSnapshotCurrentTimestamp();
-		MaintainOldSnapshotTimeMapping(snapshot->whenTaken, xmin);
-	}
+	GetSnapshotDataInitOldSnapshot(snapshot);
 
 	return snapshot;
 }
@@ -2001,7 +2105,7 @@ GetRunningTransactionData(void)
 
 	latestCompletedXid = ShmemVariableCache->latestCompletedXid;
 
-	oldestRunningXid = ShmemVariableCache->nextXid;
+	oldestRunningXid = XidFromFullTransactionId(ShmemVariableCache->nextFullXid);
 
 	/*
 	 * Spin over procArray collecting all xids
@@ -2093,7 +2197,7 @@ GetRunningTransactionData(void)
 	CurrentRunningXacts->xcnt = count - subcount;
 	CurrentRunningXacts->subxcnt = subcount;
 	CurrentRunningXacts->subxid_overflow = suboverflowed;
-	CurrentRunningXacts->nextXid = ShmemVariableCache->nextXid;
+	CurrentRunningXacts->nextXid = XidFromFullTransactionId(ShmemVariableCache->nextFullXid);
 	CurrentRunningXacts->oldestRunningXid = oldestRunningXid;
 	CurrentRunningXacts->latestCompletedXid = latestCompletedXid;
 
@@ -2138,7 +2242,7 @@ GetOldestActiveTransactionId(void)
 	 * have already completed), when we spin over it.
 	 */
 	LWLockAcquire(XidGenLock, LW_SHARED);
-	oldestRunningXid = ShmemVariableCache->nextXid;
+	oldestRunningXid = XidFromFullTransactionId(ShmemVariableCache->nextFullXid);
 	LWLockRelease(XidGenLock);
 
 	/*
@@ -2206,7 +2310,7 @@ GetOldestSafeDecodingTransactionId(bool catalogOnly)
 	 * a safe, albeit pessimal, value.
 	 */
 	LWLockAcquire(XidGenLock, LW_SHARED);
-	oldestSafeXid = ShmemVariableCache->nextXid;
+	oldestSafeXid = XidFromFullTransactionId(ShmemVariableCache->nextFullXid);
 
 	/*
 	 * If there's already a slot pegging the xmin horizon, we can start with
@@ -3116,6 +3220,9 @@ XidCacheRemoveRunningXids(TransactionId xid,
 							  latestXid))
 		ShmemVariableCache->latestCompletedXid = latestXid;
 
+	/* Existing snapshots may show the subtransactions as running */
+	procArray->xactCompletionCount++;
+
 	LWLockRelease(ProcArrayLock);
 }
 
@@ -3266,12 +3373,8 @@ RecordKnownAssignedTransactionIds(TransactionId xid)
 		 */
 		latestObservedXid = xid;
 
-		/* ShmemVariableCache->nextXid must be beyond any observed xid */
-		next_expected_xid = latestObservedXid;
-		TransactionIdAdvance(next_expected_xid);
-		LWLockAcquire(XidGenLock, LW_EXCLUSIVE);
-		ShmemVariableCache->nextXid = next_expected_xid;
-		LWLockRelease(XidGenLock);
+		/* ShmemVariableCache->nextFullXid must be beyond any observed xid */
+		AdvanceNextFullTransactionIdPastXid(latestObservedXid);
 	}
 }
 
@@ -3362,6 +3465,19 @@ ExpireOldKnownAssignedTransactionIds(TransactionId xid)
  * out the unused entries; that's much cheaper than having to compress the
  * array immediately on every deletion.
  *
+ * Scans that must visit every valid entry, notably snapshot building, would
+ * still have to step over all the gaps, so we also keep a third parallel
+ * array of skip hints, KnownAssignedXidsNext[].  KnownAssignedXidsNext[i] is
+ * a distance such that all entries strictly between i and i plus that
+ * distance are known to be invalid.  Hints start out as 1, which is always
+ * true, and scanning backends lengthen them as they discover runs of invalid
+ * entries, so each gap is typically walked only once after it appears.
+ * Since entries only ever go from valid to invalid between compressions, a
+ * hint never becomes wrong; compression rewrites them all.  The hints are
+ * updated without any lock beyond the shared ProcArrayLock the scanner
+ * already holds: concurrent writers can only overwrite one correct hint with
+ * another, and an int32 store is atomic.
+ *
  * The actually valid items in KnownAssignedXids[] and KnownAssignedXidsValid[]
  * are those with indexes tail <= i < head; items outside this subscript range
  * have unspecified contents.  When head reaches the end of the array, we
@@ -3398,18 +3514,26 @@ ExpireOldKnownAssignedTransactionIds(TransactionId xid)
  *		must happen)
  *	* Compressing the array is O(S) and requires exclusive lock
  *	* Removing an XID is O(logS) and requires exclusive lock
- *	* Taking a snapshot is O(S) and requires shared lock
+ *	* Taking a snapshot is O(N) once the skip hints have caught up with the
+ *		gaps, O(S) at worst, and requires shared lock
  *	* Checking for an XID is O(logS) and requires shared lock
  *
  * In comparison, using a hash table for KnownAssignedXids would mean that
- * taking snapshots would be O(M). If we can maintain S << M then the
- * sorted array technique will deliver significantly faster snapshots.
- * If we try to keep S too small then we will spend too much time compressing,
- * so there is an optimal point for any workload mix. We use a heuristic to
- * decide when to compress the array, though trimming also helps reduce
- * frequency of compressing. The heuristic requires us to track the number of
- * currently valid XIDs in the array.
+ * taking snapshots would be O(M).  Thanks to the skip hints, the spread S
+ * matters much less to snapshot cost than the number of valid entries, so we
+ * can afford to let gaps accumulate and compress only occasionally, which
+ * keeps the startup process from holding ProcArrayLock exclusively for long
+ * stretches while it replays a stream of short transactions.  We use a
+ * heuristic to decide when to compress the array, though trimming also helps
+ * reduce frequency of compressing.  The heuristic requires us to track the
+ * number of currently valid XIDs in the array.
+ */
+
+/*
+ * Opportunistic compression is considered only once per this many calls,
+ * which in practice means once per this many replayed transaction ends.
  */
+#define KAX_COMPRESS_FREQUENCY	128
 
 
 /*
@@ -3442,12 +3566,17 @@ KnownAssignedXidsCompress(bool force)
 		 *
 		 * Heuristic is if we have a large enough current spread and less than
 		 * 50% of the elements are currently in use, then compress. This
-		 * should ensure we compress fairly infrequently. We could compress
-		 * less often though the virtual array would spread out more and
-		 * snapshots would become more expensive.
+		 * should ensure we compress fairly infrequently.  Since snapshots can
+		 * skip over gaps, we also don't bother checking on every call.  The
+		 * counter is local to the startup process, the only caller.
 		 */
+		static int	calls_since_check = 0;
 		int			nelements = head - tail;
 
+		if (++calls_since_check < KAX_COMPRESS_FREQUENCY)
+			return;
+		calls_since_check = 0;
+
 		if (nelements < 4 * PROCARRAY_MAXPROCS ||
 			nelements < 2 * pArray->numKnownAssignedXids)
 			return;
@@ -3464,6 +3593,7 @@ KnownAssignedXidsCompress(bool force)
 		{
 			KnownAssignedXids[compress_index] = KnownAssignedXids[i];
 			KnownAssignedXidsValid[compress_index] = true;
+			KnownAssignedXidsNext[compress_index] = 1;
 			compress_index++;
 		}
 	}
@@ -3472,6 +3602,35 @@ KnownAssignedXidsCompress(bool force)
 	pArray->headKnownAssignedXids = compress_index;
 }
 
+/*
+ * Find the next valid entry after index i, or head if there are none before
+ * head, where i is a valid entry or the tail.  In passing, lengthen i's skip
+ * hint so that the next scan gets there in one step.
+ *
+ * Caller must hold ProcArrayLock in shared or exclusive mode, and must have
+ * fetched head as described for the callers below.
+ */
+static inline int
+KnownAssignedXidsNextValid(int i, int head)
+{
+	int			start = i;
+
+	i += KnownAssignedXidsNext[i];
+	while (i < head && !KnownAssignedXidsValid[i])
+		i += KnownAssignedXidsNext[i];
+
+	/*
+	 * A hint left by a backend that saw a later head can take us past ours;
+	 * everything up to there is invalid or not yet visible to us anyway.
+	 */
+	if (i > head)
+		i = head;
+	else if (i - start > KnownAssignedXidsNext[start])
+		KnownAssignedXidsNext[start] = i - start;
+
+	return i;
+}
+
 /*
  * Add xids into KnownAssignedXids at the head of the array.
  *
@@ -3566,6 +3725,7 @@ KnownAssignedXidsAdd(TransactionId from_xid, TransactionId to_xid,
 	{
 		KnownAssignedXids[head] = next_xid;
 		KnownAssignedXidsValid[head] = true;
+		KnownAssignedXidsNext[head] = 1;
 		TransactionIdAdvance(next_xid);
 		head++;
 	}
@@ -3670,9 +3830,7 @@ KnownAssignedXidsSearch(TransactionId xid, bool remove)
 		 */
 		if (result_index == tail)
 		{
-			tail++;
-			while (tail < head && !KnownAssignedXidsValid[tail])
-				tail++;
+			tail = KnownAssignedXidsNextValid(tail, head);
 			if (tail >= head)
 			{
 				/* Array is empty, so we can reset both pointers */
@@ -3781,7 +3939,7 @@ KnownAssignedXidsRemovePreceding(TransactionId removeXid)
 	tail = pArray->tailKnownAssignedXids;
 	head = pArray->headKnownAssignedXids;
 
-	for (i = tail; i < head; i++)
+	for (i = tail; i < head; i = KnownAssignedXidsNextValid(i, head))
 	{
 		if (KnownAssignedXidsValid[i])
 		{
@@ -3804,11 +3962,9 @@ KnownAssignedXidsRemovePreceding(TransactionId removeXid)
 	/*
 	 * Advance the tail pointer if we've marked the tail item invalid.
 	 */
-	for (i = tail; i < head; i++)
-	{
-		if (KnownAssignedXidsValid[i])
-			break;
-	}
+	i = tail;
+	if (i < head && !KnownAssignedXidsValid[i])
+		i = KnownAssignedXidsNextValid(i, head);
 	if (i >= head)
 	{
 		/* Array is empty, so we can reset both pointers */
@@ -3870,7 +4026,7 @@ KnownAssignedXidsGetAndSetXmin(TransactionId *xarray, TransactionId *xmin,
 	head = procArray->headKnownAssignedXids;
 	SpinLockRelease(&procArray->known_assigned_xids_lck);
 
-	for (i = tail; i < head; i++)
+	for (i = tail; i < head; i = KnownAssignedXidsNextValid(i, head))
 	{
 		/* Skip any gaps in the array */
 		if (KnownAssignedXidsValid[i])
@@ -3920,7 +4076,7 @@ KnownAssignedXidsGetOldestXmin(void)
 	head = procArray->headKnownAssignedXids;
 	SpinLockRelease(&procArray->known_assigned_xids_lck);
 
-	for (i = tail; i < head; i++)
+	for (i = tail; i < head; i = KnownAssignedXidsNextValid(i, head))
 	{
 		/* Skip any gaps in the array */
 		if (KnownAssignedXidsValid[i])
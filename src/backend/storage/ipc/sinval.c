@@ -21,6 +21,8 @@
 #include "storage/proc.h"
 #include "storage/sinvaladt.h"
 #include "utils/inval.h"
+#include "utils/sharedcatcache.h"
+#include "utils/sharedplancache.h"
 
 
 uint64		SharedInvalidMessageCounter;
@@ -44,10 +46,16 @@ volatile sig_atomic_t catchupInterruptPending = false;
 /*
  * SendSharedInvalidMessages
  *	Add shared-cache-invalidation message(s) to the global SI message queue.
+ *
+ * The shared catalog and plan caches, if any, are brought up to date first,
+ * so that no backend can find a stale entry there once it has read the
+ * messages.
  */
 void
 SendSharedInvalidMessages(const SharedInvalidationMessage *msgs, int n)
 {
+	SharedCatCacheInvalidateMessages(msgs, n);
+	SharedPlanCacheInvalidateMessages(msgs, n);
 	SIInsertDataEntries(msgs, n);
 }
 
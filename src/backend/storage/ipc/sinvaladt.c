@@ -43,16 +43,16 @@
  * smallest nextMsgNum --- it may lag behind.  We only update it when
  * SICleanupQueue is called, and we try not to do that often.)
  *
- * In reality, the messages are stored in a circular buffer of MAXNUMMESSAGES
- * entries.  We translate MsgNum values into circular-buffer indexes by
- * computing MsgNum % MAXNUMMESSAGES (this should be fast as long as
- * MAXNUMMESSAGES is a constant and a power of 2).  As long as maxMsgNum
- * doesn't exceed minMsgNum by more than MAXNUMMESSAGES, we have enough space
- * in the buffer.  If the buffer does overflow, we recover by setting the
- * "reset" flag for each backend that has fallen too far behind.  A backend
- * that is in "reset" state is ignored while determining minMsgNum.  When
- * it does finally attempt to receive inval messages, it must discard all
- * its invalidatable state, since it won't know what it missed.
+ * In reality, the messages are stored in a circular buffer of maxNumMessages
+ * entries, a power of 2 fixed at postmaster start (sinval_queue_size).  We
+ * translate MsgNum values into circular-buffer indexes by masking off the
+ * high-order bits of MsgNum.  As long as maxMsgNum doesn't exceed minMsgNum
+ * by more than maxNumMessages, we have enough space in the buffer.  If the
+ * buffer does overflow, we recover by setting the "reset" flag for each
+ * backend that has fallen too far behind.  A backend that is in "reset"
+ * state is ignored while determining minMsgNum.  When it does finally
+ * attempt to receive inval messages, it must discard all its invalidatable
+ * state, since it won't know what it missed.
  *
  * To reduce the probability of needing resets, we send a "catchup" interrupt
  * to any backend that seems to be falling unreasonably far behind.  The
@@ -70,11 +70,20 @@
  * of "stuck" backends, we won't need a lot of extra interrupts, since ones
  * that aren't stuck will propagate their interrupts to the next guy.
  *
+ * Most messages concern the catalogs of a single database, and are of no
+ * interest to backends connected to other databases.  Writers therefore
+ * only set hasMessages for backends that might care, and SICleanupQueue
+ * simply advances the nextMsgNum of any backend all of whose unread messages
+ * belong to other databases, instead of signaling it or, worse, forcing it
+ * into reset state.  This keeps a burst of DDL in one database from making
+ * idle backends elsewhere rebuild their caches from scratch.  A backend
+ * that has not yet advertised its database in PGPROC gets all messages.
+ *
  * We would have problems if the MsgNum values overflow an integer, so
  * whenever minMsgNum exceeds MSGNUMWRAPAROUND, we subtract MSGNUMWRAPAROUND
  * from all the MsgNum variables simultaneously.  MSGNUMWRAPAROUND can be
  * large so that we don't need to do this often.  It must be a multiple of
- * MAXNUMMESSAGES so that the existing circular-buffer entries don't need
+ * maxNumMessages so that the existing circular-buffer entries don't need
  * to be moved when we do it.
  *
  * Access to the shared sinval array is protected by two locks, SInvalReadLock
@@ -107,11 +116,13 @@
 /*
  * Configurable parameters.
  *
- * MAXNUMMESSAGES: max number of shared-inval messages we can buffer.
- * Must be a power of 2 for speed.
+ * sinval_queue_size: max number of shared-inval messages we can buffer.
+ * It is rounded up to a power of 2 for speed, giving maxNumMessages.
+ *
+ * MAX_SINVAL_QUEUE_SIZE: upper limit for maxNumMessages.
  *
  * MSGNUMWRAPAROUND: how often to reduce MsgNum variables to avoid overflow.
- * Must be a multiple of MAXNUMMESSAGES.  Should be large.
+ * Must be a multiple of any maxNumMessages.  Should be large.
  *
  * CLEANUP_MIN: the minimum number of messages that must be in the buffer
  * before we bother to call SICleanupQueue.
@@ -126,14 +137,22 @@
  * iteration of SIInsertDataEntries.  Noncritical but should be less than
  * CLEANUP_QUANTUM, because we only consider calling SICleanupQueue once
  * per iteration.
+ *
+ * MAX_TRACKED_DATABASES: how many distinct databases SICleanupQueue keeps
+ * track of while looking for backends it can advance past other databases'
+ * messages.  Backends of any further databases are treated as interested
+ * in every message.
  */
 
-#define MAXNUMMESSAGES 4096
-#define MSGNUMWRAPAROUND (MAXNUMMESSAGES * 262144)
-#define CLEANUP_MIN (MAXNUMMESSAGES / 2)
-#define CLEANUP_QUANTUM (MAXNUMMESSAGES / 16)
-#define SIG_THRESHOLD (MAXNUMMESSAGES / 2)
+int			sinval_queue_size = 4096;
+
+#define MAX_SINVAL_QUEUE_SIZE (1024 * 1024)
+#define MSGNUMWRAPAROUND (MAX_SINVAL_QUEUE_SIZE * 1024)
+#define CLEANUP_MIN(nmsgs) ((nmsgs) / 2)
+#define CLEANUP_QUANTUM(nmsgs) ((nmsgs) / 16)
+#define SIG_THRESHOLD(nmsgs) ((nmsgs) / 2)
 #define WRITE_QUANTUM 64
+#define MAX_TRACKED_DATABASES 16
 
 /* Per-backend state in shared invalidation structure */
 typedef struct ProcState
@@ -175,13 +194,15 @@ typedef struct SISeg
 	int			nextThreshold;	/* # of messages to call SICleanupQueue */
 	int			lastBackend;	/* index of last active procState entry, +1 */
 	int			maxBackends;	/* size of procState array */
+	int			maxNumMessages; /* size of buffer array, a power of 2 */
 
 	slock_t		msgnumLock;		/* spinlock protecting maxMsgNum */
 
 	/*
-	 * Circular buffer holding shared-inval messages
+	 * Circular buffer holding shared-inval messages (has maxNumMessages
+	 * entries, and lives just after the procState array).
 	 */
-	SharedInvalidationMessage buffer[MAXNUMMESSAGES];
+	SharedInvalidationMessage *buffer;
 
 	/*
 	 * Per-backend invalidation state info (has MaxBackends entries).
@@ -189,6 +210,9 @@ typedef struct SISeg
 	ProcState	procState[FLEXIBLE_ARRAY_MEMBER];
 } SISeg;
 
+/* Translate a MsgNum into a circular-buffer index */
+#define MSGNUM_INDEX(segP, msgnum) ((msgnum) & ((segP)->maxNumMessages - 1))
+
 static SISeg *shmInvalBuffer;	/* pointer to the shared inval buffer */
 
 
@@ -197,6 +221,22 @@ static LocalTransactionId nextLocalTransactionId;
 static void CleanupInvalidationState(int status, Datum arg);
 
 
+/*
+ * SInvalQueueSize --- number of messages in the circular buffer
+ *
+ * This is sinval_queue_size rounded up to the next power of 2.
+ */
+static int
+SInvalQueueSize(void)
+{
+	int			nmsgs = 1024;
+
+	while (nmsgs < sinval_queue_size && nmsgs < MAX_SINVAL_QUEUE_SIZE)
+		nmsgs *= 2;
+
+	return nmsgs;
+}
+
 /*
  * SInvalShmemSize --- return shared-memory space needed
  */
@@ -207,6 +247,9 @@ SInvalShmemSize(void)
 
 	size = offsetof(SISeg, procState);
 	size = add_size(size, mul_size(sizeof(ProcState), MaxBackends));
+	size = MAXALIGN(size);
+	size = add_size(size, mul_size(sizeof(SharedInvalidationMessage),
+								   SInvalQueueSize()));
 
 	return size;
 }
@@ -228,14 +271,19 @@ CreateSharedInvalidationState(void)
 		return;
 
 	/* Clear message counters, save size of procState array, init spinlock */
+	shmInvalBuffer->maxNumMessages = SInvalQueueSize();
 	shmInvalBuffer->minMsgNum = 0;
 	shmInvalBuffer->maxMsgNum = 0;
-	shmInvalBuffer->nextThreshold = CLEANUP_MIN;
+	shmInvalBuffer->nextThreshold = CLEANUP_MIN(shmInvalBuffer->maxNumMessages);
 	shmInvalBuffer->lastBackend = 0;
 	shmInvalBuffer->maxBackends = MaxBackends;
 	SpinLockInit(&shmInvalBuffer->msgnumLock);
 
 	/* The buffer[] array is initially all unused, so we need not fill it */
+	shmInvalBuffer->buffer = (SharedInvalidationMessage *)
+		((char *) shmInvalBuffer +
+		 MAXALIGN(offsetof(SISeg, procState) +
+				  sizeof(ProcState) * MaxBackends));
 
 	/* Mark all backends inactive, and initialize nextLXID */
 	for (i = 0; i < shmInvalBuffer->maxBackends; i++)
@@ -428,6 +476,47 @@ BackendIdGetTransactionIds(int backendID, TransactionId *xid, TransactionId *xmi
 	LWLockRelease(SInvalWriteLock);
 }
 
+/*
+ * SIMessageDatabase
+ *		Return the OID of the only database whose backends care about an
+ *		invalidation message, or InvalidOid if all backends might care.
+ *
+ * This must agree with the filtering in LocalExecuteInvalidationMessage.
+ * smgr invalidations are always processed, so they're of general interest.
+ */
+static inline Oid
+SIMessageDatabase(const SharedInvalidationMessage *msg)
+{
+	if (msg->id >= 0)
+		return msg->cc.dbId;
+	else if (msg->id == SHAREDINVALCATALOG_ID)
+		return msg->cat.dbId;
+	else if (msg->id == SHAREDINVALRELCACHE_ID)
+		return msg->rc.dbId;
+	else if (msg->id == SHAREDINVALRELMAP_ID)
+		return msg->rm.dbId;
+	else if (msg->id == SHAREDINVALSNAPSHOT_ID)
+		return msg->sn.dbId;
+	return InvalidOid;
+}
+
+/*
+ * SIProcDatabase
+ *		Return the database a backend is connected to, or InvalidOid if it
+ *		isn't (yet) connected to one and thus must see every message.
+ *
+ * The PGPROC's databaseId changes only once, when the backend chooses its
+ * database in InitPostgres, which happens before it reads any catalogs of
+ * that database.  If we see the old value we merely fail to skip messages.
+ */
+static inline Oid
+SIProcDatabase(const ProcState *stateP)
+{
+	PGPROC	   *proc = stateP->proc;
+
+	return proc ? proc->databaseId : InvalidOid;
+}
+
 /*
  * SIInsertDataEntries
  *		Add new invalidation message(s) to the buffer.
@@ -452,9 +541,21 @@ SIInsertDataEntries(const SharedInvalidationMessage *data, int n)
 		int			numMsgs;
 		int			max;
 		int			i;
+		Oid			dbId;
 
 		n -= nthistime;
 
+		/*
+		 * If all messages in this group concern the same database, only that
+		 * database's backends need to be told about them.
+		 */
+		dbId = SIMessageDatabase(&data[0]);
+		for (i = 1; i < nthistime && OidIsValid(dbId); i++)
+		{
+			if (SIMessageDatabase(&data[i]) != dbId)
+				dbId = InvalidOid;
+		}
+
 		LWLockAcquire(SInvalWriteLock, LW_EXCLUSIVE);
 
 		/*
@@ -467,7 +568,7 @@ SIInsertDataEntries(const SharedInvalidationMessage *data, int n)
 		for (;;)
 		{
 			numMsgs = segP->maxMsgNum - segP->minMsgNum;
-			if (numMsgs + nthistime > MAXNUMMESSAGES ||
+			if (numMsgs + nthistime > segP->maxNumMessages ||
 				numMsgs >= segP->nextThreshold)
 				SICleanupQueue(true, nthistime);
 			else
@@ -480,7 +581,7 @@ SIInsertDataEntries(const SharedInvalidationMessage *data, int n)
 		max = segP->maxMsgNum;
 		while (nthistime-- > 0)
 		{
-			segP->buffer[max % MAXNUMMESSAGES] = *data++;
+			segP->buffer[MSGNUM_INDEX(segP, max)] = *data++;
 			max++;
 		}
 
@@ -491,15 +592,22 @@ SIInsertDataEntries(const SharedInvalidationMessage *data, int n)
 
 		/*
 		 * Now that the maxMsgNum change is globally visible, we give everyone
-		 * a swift kick to make sure they read the newly added messages.
-		 * Releasing SInvalWriteLock will enforce a full memory barrier, so
-		 * these (unlocked) changes will be committed to memory before we exit
-		 * the function.
+		 * who might care a swift kick to make sure they read the newly added
+		 * messages.  Releasing SInvalWriteLock will enforce a full memory
+		 * barrier, so these (unlocked) changes will be committed to memory
+		 * before we exit the function.
 		 */
 		for (i = 0; i < segP->lastBackend; i++)
 		{
 			ProcState  *stateP = &segP->procState[i];
 
+			if (OidIsValid(dbId))
+			{
+				Oid			procDbId = SIProcDatabase(stateP);
+
+				if (OidIsValid(procDbId) && procDbId != dbId)
+					continue;
+			}
 			stateP->hasMessages = true;
 		}
 
@@ -603,7 +711,7 @@ SIGetDataEntries(SharedInvalidationMessage *data, int datasize)
 	n = 0;
 	while (n < datasize && stateP->nextMsgNum < max)
 	{
-		data[n++] = segP->buffer[stateP->nextMsgNum % MAXNUMMESSAGES];
+		data[n++] = segP->buffer[MSGNUM_INDEX(segP, stateP->nextMsgNum)];
 		stateP->nextMsgNum++;
 	}
 
@@ -649,12 +757,53 @@ SICleanupQueue(bool callerHasWriteLock, int minFree)
 				numMsgs,
 				i;
 	ProcState  *needSig = NULL;
+	int			lastShared;
+	int			lastUntracked;
+	int			ntracked;
+	Oid			trackedDb[MAX_TRACKED_DATABASES];
+	int			trackedLast[MAX_TRACKED_DATABASES];
 
 	/* Lock out all writers and readers */
 	if (!callerHasWriteLock)
 		LWLockAcquire(SInvalWriteLock, LW_EXCLUSIVE);
 	LWLockAcquire(SInvalReadLock, LW_EXCLUSIVE);
 
+	/*
+	 * Find out, for each database appearing in the queue, the number of the
+	 * last message its backends need to see, so that backends that are
+	 * behind only on other databases' messages can be advanced below.
+	 * lastShared is the last message of interest to everybody, and
+	 * lastUntracked the last one for a database we ran out of room for.
+	 */
+	lastShared = lastUntracked = segP->minMsgNum - 1;
+	ntracked = 0;
+	for (i = segP->minMsgNum; i < segP->maxMsgNum; i++)
+	{
+		Oid			dbId = SIMessageDatabase(&segP->buffer[MSGNUM_INDEX(segP, i)]);
+		int			j;
+
+		if (!OidIsValid(dbId))
+		{
+			lastShared = i;
+			continue;
+		}
+		for (j = 0; j < ntracked; j++)
+		{
+			if (trackedDb[j] == dbId)
+				break;
+		}
+		if (j < ntracked)
+			trackedLast[j] = i;
+		else if (ntracked < MAX_TRACKED_DATABASES)
+		{
+			trackedDb[ntracked] = dbId;
+			trackedLast[ntracked] = i;
+			ntracked++;
+		}
+		else
+			lastUntracked = i;
+	}
+
 	/*
 	 * Recompute minMsgNum = minimum of all backends' nextMsgNum, identify the
 	 * furthest-back backend that needs signaling (if any), and reset any
@@ -663,18 +812,46 @@ SICleanupQueue(bool callerHasWriteLock, int minFree)
 	 * a problem even when they are the only active backend.
 	 */
 	min = segP->maxMsgNum;
-	minsig = min - SIG_THRESHOLD;
-	lowbound = min - MAXNUMMESSAGES + minFree;
+	minsig = min - SIG_THRESHOLD(segP->maxNumMessages);
+	lowbound = min - segP->maxNumMessages + minFree;
 
 	for (i = 0; i < segP->lastBackend; i++)
 	{
 		ProcState  *stateP = &segP->procState[i];
 		int			n = stateP->nextMsgNum;
+		Oid			procDbId;
 
 		/* Ignore if inactive or already in reset state */
 		if (stateP->procPid == 0 || stateP->resetState || stateP->sendOnly)
 			continue;
 
+		/*
+		 * If none of the messages this backend hasn't read yet are of
+		 * interest to it, pretend it has read them all.  (We hold
+		 * SInvalReadLock exclusively, so we may change its nextMsgNum.)
+		 */
+		procDbId = SIProcDatabase(stateP);
+		if (n < segP->maxMsgNum && OidIsValid(procDbId))
+		{
+			int			lastNeeded = Max(lastShared, lastUntracked);
+			int			j;
+
+			for (j = 0; j < ntracked; j++)
+			{
+				if (trackedDb[j] == procDbId)
+				{
+					lastNeeded = Max(lastNeeded, trackedLast[j]);
+					break;
+				}
+			}
+			if (lastNeeded < n)
+			{
+				n = stateP->nextMsgNum = segP->maxMsgNum;
+				stateP->hasMessages = false;
+				stateP->signaled = false;
+			}
+		}
+
 		/*
 		 * If we must free some space and this backend is preventing it, force
 		 * him into reset state and then ignore until he catches up.
@@ -720,10 +897,14 @@ SICleanupQueue(bool callerHasWriteLock, int minFree)
 	 * threshold at which we should repeat SICleanupQueue().
 	 */
 	numMsgs = segP->maxMsgNum - segP->minMsgNum;
-	if (numMsgs < CLEANUP_MIN)
-		segP->nextThreshold = CLEANUP_MIN;
+	if (numMsgs < CLEANUP_MIN(segP->maxNumMessages))
+		segP->nextThreshold = CLEANUP_MIN(segP->maxNumMessages);
 	else
-		segP->nextThreshold = (numMsgs / CLEANUP_QUANTUM + 1) * CLEANUP_QUANTUM;
+	{
+		int			quantum = CLEANUP_QUANTUM(segP->maxNumMessages);
+
+		segP->nextThreshold = (numMsgs / quantum + 1) * quantum;
+	}
 
 	/*
 	 * Lastly, signal anyone who needs a catchup interrupt.  Since
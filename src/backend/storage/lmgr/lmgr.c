@@ -20,11 +20,53 @@
 #include "access/xact.h"
 #include "catalog/catalog.h"
 #include "miscadmin.h"
+#include "port/atomics.h"
 #include "storage/lmgr.h"
 #include "storage/procarray.h"
+#include "storage/shmem.h"
+#include "utils/hashutils.h"
 #include "utils/inval.h"
 
 
+/*
+ * Relation extension locks.
+ *
+ * These are not kept in the heavyweight lock table: they are taken very
+ * often, held only briefly, and never held while waiting for any other
+ * heavyweight lock, so they need neither deadlock detection nor release at
+ * transaction end, and the lock manager's overhead just serializes
+ * concurrent extenders.  Instead, each relation is hashed onto one of a
+ * fixed array of LWLocks.  Relations that happen to share a slot interlock
+ * each other's extension needlessly, which is harmless given the number of
+ * slots.  A waiter count is kept alongside each LWLock, because
+ * RelationAddExtraBlocks() judges contention by the number of waiters.
+ *
+ * Unlike a heavyweight lock, an LWLock can't be re-acquired by its holder,
+ * but some callers do that: e.g. extending the FSM while holding the heap's
+ * extension lock takes the lock of the same relation again.  So we keep a
+ * local nesting count per slot.  The count is only trusted while
+ * LWLockHeldByMe() agrees, since LWLockReleaseAll() releases these locks on
+ * error without telling us.
+ */
+#define N_RELEXTLOCK_ENTS	1024
+
+typedef union RelExtLockSlot
+{
+	struct
+	{
+		LWLock		lock;
+		pg_atomic_uint32 nwaiters;
+	}			s;
+	char		pad[PG_CACHE_LINE_SIZE];
+} RelExtLockSlot;
+
+static RelExtLockSlot *RelExtLockArray = NULL;
+
+static int	RelExtLockNestCount[N_RELEXTLOCK_ENTS];
+
+static int	RelExtLockSlotFor(Relation relation);
+
+
 /*
  * Per-backend counter for generating speculative insertion tokens.
  *
@@ -135,6 +177,59 @@ LockRelationOid(Oid relid, LOCKMODE lockmode)
 	}
 }
 
+/*
+ *		LockRelationOids
+ *
+ * Lock a number of relations, given their OIDs and lock modes.  This has the
+ * same effect as calling LockRelationOid() on each of them, but is a lot
+ * cheaper when there are many; see LockAcquireBatch().
+ */
+void
+LockRelationOids(int nrels, const Oid *relids, const LOCKMODE *lockmodes)
+{
+	LOCKTAG    *tags;
+	LOCALLOCK **locallocks;
+	LockAcquireResult *results;
+	bool		need_inval = false;
+	int			i;
+
+	if (nrels <= 0)
+		return;
+
+	tags = (LOCKTAG *) palloc(nrels * sizeof(LOCKTAG));
+	locallocks = (LOCALLOCK **) palloc(nrels * sizeof(LOCALLOCK *));
+	results = (LockAcquireResult *) palloc(nrels * sizeof(LockAcquireResult));
+
+	for (i = 0; i < nrels; i++)
+		SetLocktagRelationOid(&tags[i], relids[i]);
+
+	LockAcquireBatch(nrels, tags, lockmodes, locallocks, results);
+
+	/*
+	 * As in LockRelationOid, absorb invalidation messages unless we already
+	 * had all the locks; but once is enough for the whole batch.
+	 */
+	for (i = 0; i < nrels; i++)
+	{
+		if (results[i] != LOCKACQUIRE_ALREADY_CLEAR)
+			need_inval = true;
+	}
+
+	if (need_inval)
+	{
+		AcceptInvalidationMessages();
+		for (i = 0; i < nrels; i++)
+		{
+			if (results[i] != LOCKACQUIRE_ALREADY_CLEAR)
+				MarkLockClear(locallocks[i]);
+		}
+	}
+
+	pfree(tags);
+	pfree(locallocks);
+	pfree(results);
+}
+
 /*
  *		ConditionalLockRelationOid
  *
@@ -385,12 +480,61 @@ UnlockRelationIdForSession(LockRelId *relid, LOCKMODE lockmode)
 	LockRelease(&tag, lockmode, true);
 }
 
+/*
+ * Report shared memory space needed by RelExtLockShmemInit
+ */
+Size
+RelExtLockShmemSize(void)
+{
+	return mul_size(N_RELEXTLOCK_ENTS, sizeof(RelExtLockSlot));
+}
+
+/*
+ * Allocate and initialize the relation extension locks
+ */
+void
+RelExtLockShmemInit(void)
+{
+	bool		found;
+	int			i;
+
+	RelExtLockArray = (RelExtLockSlot *)
+		ShmemInitStruct("Relation Extension Locks", RelExtLockShmemSize(),
+						&found);
+
+	if (!found)
+	{
+		for (i = 0; i < N_RELEXTLOCK_ENTS; i++)
+		{
+			LWLockInitialize(&RelExtLockArray[i].s.lock,
+							 LWTRANCHE_RELATION_EXTENSION);
+			pg_atomic_init_u32(&RelExtLockArray[i].s.nwaiters, 0);
+		}
+	}
+}
+
+/*
+ * Map a relation to its extension lock slot
+ */
+static int
+RelExtLockSlotFor(Relation relation)
+{
+	uint32		hash;
+
+	hash = hash_combine(murmurhash32(relation->rd_lockInfo.lockRelId.dbId),
+						murmurhash32(relation->rd_lockInfo.lockRelId.relId));
+
+	return hash % N_RELEXTLOCK_ENTS;
+}
+
 /*
  *		LockRelationForExtension
  *
- * This lock tag is used to interlock addition of pages to relations.
+ * This lock is used to interlock addition of pages to relations.
  * We need such locking because bufmgr/smgr definition of P_NEW is not
- * race-condition-proof.
+ * race-condition-proof.  lockmode must be ExclusiveLock, or ShareLock to
+ * merely wait out any extension in progress.  See the comments at the top
+ * of this file for how these locks differ from regular ones.
  *
  * We assume the caller is already holding some type of regular lock on
  * the relation, so no AcceptInvalidationMessages call is needed here.
@@ -398,13 +542,30 @@ UnlockRelationIdForSession(LockRelId *relid, LOCKMODE lockmode)
 void
 LockRelationForExtension(Relation relation, LOCKMODE lockmode)
 {
-	LOCKTAG		tag;
+	int			slotno = RelExtLockSlotFor(relation);
+	RelExtLockSlot *slot = &RelExtLockArray[slotno];
+	LWLockMode	mode;
 
-	SET_LOCKTAG_RELATION_EXTEND(tag,
-								relation->rd_lockInfo.lockRelId.dbId,
-								relation->rd_lockInfo.lockRelId.relId);
+	Assert(lockmode == ExclusiveLock || lockmode == ShareLock);
+	mode = (lockmode == ExclusiveLock) ? LW_EXCLUSIVE : LW_SHARED;
 
-	(void) LockAcquire(&tag, lockmode, false, false);
+	if (LWLockHeldByMe(&slot->s.lock))
+	{
+		if (mode == LW_EXCLUSIVE &&
+			!LWLockHeldByMeInMode(&slot->s.lock, LW_EXCLUSIVE))
+			elog(ERROR, "cannot upgrade relation extension lock of \"%s\"",
+				 RelationGetRelationName(relation));
+		RelExtLockNestCount[slotno]++;
+		return;
+	}
+
+	if (!LWLockConditionalAcquire(&slot->s.lock, mode))
+	{
+		pg_atomic_fetch_add_u32(&slot->s.nwaiters, 1);
+		LWLockAcquire(&slot->s.lock, mode);
+		pg_atomic_fetch_sub_u32(&slot->s.nwaiters, 1);
+	}
+	RelExtLockNestCount[slotno] = 1;
 }
 
 /*
@@ -416,30 +577,40 @@ LockRelationForExtension(Relation relation, LOCKMODE lockmode)
 bool
 ConditionalLockRelationForExtension(Relation relation, LOCKMODE lockmode)
 {
-	LOCKTAG		tag;
+	int			slotno = RelExtLockSlotFor(relation);
+	RelExtLockSlot *slot = &RelExtLockArray[slotno];
+	LWLockMode	mode;
 
-	SET_LOCKTAG_RELATION_EXTEND(tag,
-								relation->rd_lockInfo.lockRelId.dbId,
-								relation->rd_lockInfo.lockRelId.relId);
+	Assert(lockmode == ExclusiveLock || lockmode == ShareLock);
+	mode = (lockmode == ExclusiveLock) ? LW_EXCLUSIVE : LW_SHARED;
 
-	return (LockAcquire(&tag, lockmode, false, true) != LOCKACQUIRE_NOT_AVAIL);
+	if (LWLockHeldByMe(&slot->s.lock))
+	{
+		if (mode == LW_EXCLUSIVE &&
+			!LWLockHeldByMeInMode(&slot->s.lock, LW_EXCLUSIVE))
+			return false;
+		RelExtLockNestCount[slotno]++;
+		return true;
+	}
+
+	if (!LWLockConditionalAcquire(&slot->s.lock, mode))
+		return false;
+	RelExtLockNestCount[slotno] = 1;
+	return true;
 }
 
 /*
  *		RelationExtensionLockWaiterCount
  *
  * Count the number of processes waiting for the given relation extension lock.
+ * Processes waiting for other relations that share its slot are included.
  */
 int
 RelationExtensionLockWaiterCount(Relation relation)
 {
-	LOCKTAG		tag;
-
-	SET_LOCKTAG_RELATION_EXTEND(tag,
-								relation->rd_lockInfo.lockRelId.dbId,
-								relation->rd_lockInfo.lockRelId.relId);
+	RelExtLockSlot *slot = &RelExtLockArray[RelExtLockSlotFor(relation)];
 
-	return LockWaiterCount(&tag);
+	return (int) pg_atomic_read_u32(&slot->s.nwaiters);
 }
 
 /*
@@ -448,13 +619,15 @@ RelationExtensionLockWaiterCount(Relation relation)
 void
 UnlockRelationForExtension(Relation relation, LOCKMODE lockmode)
 {
-	LOCKTAG		tag;
+	int			slotno = RelExtLockSlotFor(relation);
+	RelExtLockSlot *slot = &RelExtLockArray[slotno];
 
-	SET_LOCKTAG_RELATION_EXTEND(tag,
-								relation->rd_lockInfo.lockRelId.dbId,
-								relation->rd_lockInfo.lockRelId.relId);
+	Assert(LWLockHeldByMe(&slot->s.lock));
+	Assert(RelExtLockNestCount[slotno] > 0);
 
-	LockRelease(&tag, lockmode, false);
+	if (--RelExtLockNestCount[slotno] > 0)
+		return;
+	LWLockRelease(&slot->s.lock);
 }
 
 /*
@@ -1115,6 +1288,13 @@ DescribeLockTag(StringInfo buf, const LOCKTAG *tag)
 							 tag->locktag_field3,
 							 tag->locktag_field4);
 			break;
+		case LOCKTAG_APPLY_TRANSACTION:
+			appendStringInfo(buf,
+							 _("remote transaction %u of subscription %u of database %u"),
+							 tag->locktag_field3,
+							 tag->locktag_field2,
+							 tag->locktag_field1);
+			break;
 		default:
 			appendStringInfo(buf,
 							 _("unrecognized locktag type %d"),
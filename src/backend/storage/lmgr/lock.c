@@ -40,6 +40,7 @@
 #include "miscadmin.h"
 #include "pg_trace.h"
 #include "pgstat.h"
+#include "storage/lockstats.h"
 #include "storage/proc.h"
 #include "storage/procarray.h"
 #include "storage/sinvaladt.h"
@@ -53,6 +54,9 @@
 /* This configuration variable is used to set the lock table size */
 int			max_locks_per_xact; /* set by guc.c */
 
+/* Number of fast-path lock slot groups per backend; see proc.h */
+int			FastPathLockGroupsPerBackend = 0;
+
 #define NLOCKENTS() \
 	mul_size(max_locks_per_xact, add_size(MaxBackends, max_prepared_xacts))
 
@@ -163,30 +167,51 @@ typedef struct TwoPhaseLockRecord
 
 
 /*
- * Count of the number of fast path lock slots we believe to be used.  This
- * might be higher than the real number if another backend has transferred
- * our locks to the primary lock table, but it can never be lower than the
- * real value, since only we can acquire locks on our own behalf.
+ * Count of the number of fast path lock slots we believe to be used in each
+ * group.  This might be higher than the real number if another backend has
+ * transferred our locks to the primary lock table, but it can never be lower
+ * than the real value, since only we can acquire locks on our own behalf.
  */
-static int	FastPathLocalUseCount = 0;
+static int	FastPathLocalUseCounts[FP_LOCK_GROUPS_PER_BACKEND_MAX];
 
-/* Macros for manipulating proc->fpLockBits */
+/*
+ * Macros for manipulating proc->fpLockBits.  Slot numbers 'n' are indexes
+ * into the whole fpRelId array; each group's lock modes are kept in their
+ * own element of fpLockBits.
+ */
 #define FAST_PATH_BITS_PER_SLOT			3
 #define FAST_PATH_LOCKNUMBER_OFFSET		1
 #define FAST_PATH_MASK					((1 << FAST_PATH_BITS_PER_SLOT) - 1)
+#define FAST_PATH_GROUP(n) \
+	(AssertMacro((uint32) (n) < FP_LOCK_SLOTS_PER_BACKEND), \
+	 ((n) / FP_LOCK_SLOTS_PER_GROUP))
+#define FAST_PATH_INDEX(n) \
+	(AssertMacro((uint32) (n) < FP_LOCK_SLOTS_PER_BACKEND), \
+	 ((n) % FP_LOCK_SLOTS_PER_GROUP))
+#define FAST_PATH_BITS(proc, n) \
+	((proc)->fpLockBits[FAST_PATH_GROUP(n)])
 #define FAST_PATH_GET_BITS(proc, n) \
-	(((proc)->fpLockBits >> (FAST_PATH_BITS_PER_SLOT * n)) & FAST_PATH_MASK)
+	((FAST_PATH_BITS(proc, n) >> (FAST_PATH_BITS_PER_SLOT * FAST_PATH_INDEX(n))) & FAST_PATH_MASK)
 #define FAST_PATH_BIT_POSITION(n, l) \
 	(AssertMacro((l) >= FAST_PATH_LOCKNUMBER_OFFSET), \
 	 AssertMacro((l) < FAST_PATH_BITS_PER_SLOT+FAST_PATH_LOCKNUMBER_OFFSET), \
-	 AssertMacro((n) < FP_LOCK_SLOTS_PER_BACKEND), \
-	 ((l) - FAST_PATH_LOCKNUMBER_OFFSET + FAST_PATH_BITS_PER_SLOT * (n)))
+	 ((l) - FAST_PATH_LOCKNUMBER_OFFSET + FAST_PATH_BITS_PER_SLOT * FAST_PATH_INDEX(n)))
 #define FAST_PATH_SET_LOCKMODE(proc, n, l) \
-	 (proc)->fpLockBits |= UINT64CONST(1) << FAST_PATH_BIT_POSITION(n, l)
+	 FAST_PATH_BITS(proc, n) |= UINT64CONST(1) << FAST_PATH_BIT_POSITION(n, l)
 #define FAST_PATH_CLEAR_LOCKMODE(proc, n, l) \
-	 (proc)->fpLockBits &= ~(UINT64CONST(1) << FAST_PATH_BIT_POSITION(n, l))
+	 FAST_PATH_BITS(proc, n) &= ~(UINT64CONST(1) << FAST_PATH_BIT_POSITION(n, l))
 #define FAST_PATH_CHECK_LOCKMODE(proc, n, l) \
-	 ((proc)->fpLockBits & (UINT64CONST(1) << FAST_PATH_BIT_POSITION(n, l)))
+	 (FAST_PATH_BITS(proc, n) & (UINT64CONST(1) << FAST_PATH_BIT_POSITION(n, l)))
+
+/*
+ * The group a relation's fast-path lock has to go into, and the first slot
+ * of a group.  The multiplier just spreads consecutive OIDs, which are
+ * common among the partitions of a table, over the groups.
+ */
+#define FAST_PATH_REL_GROUP(relid) \
+	((uint32) (((uint64) (relid) * 49157) % FastPathLockGroupsPerBackend))
+#define FAST_PATH_FIRST_SLOT(group) \
+	((group) * FP_LOCK_SLOTS_PER_GROUP)
 
 /*
  * The fast-path lock mechanism is concerned only with relation locks on
@@ -341,9 +366,13 @@ PROCLOCK_PRINT(const char *where, const PROCLOCK *proclockP)
 
 static uint32 proclock_hash(const void *key, Size keysize);
 static void RemoveLocalLock(LOCALLOCK *locallock);
+static LOCALLOCK *FindOrCreateLocalLock(const LOCKTAG *locktag,
+					  LOCKMODE lockmode);
 static PROCLOCK *SetupLockInTable(LockMethod lockMethodTable, PGPROC *proc,
 				 const LOCKTAG *locktag, uint32 hashcode, LOCKMODE lockmode);
 static void GrantLockLocal(LOCALLOCK *locallock, ResourceOwner owner);
+static void CancelLockRequest(LOCK *lock, PROCLOCK *proclock,
+				  LOCKMODE lockmode, uint32 hashcode);
 static void BeginStrongLockAcquire(LOCALLOCK *locallock, uint32 fasthashcode);
 static void FinishStrongLockAcquire(void);
 static void WaitOnLock(LOCALLOCK *locallock, ResourceOwner owner);
@@ -738,11 +767,9 @@ LockAcquireExtended(const LOCKTAG *locktag,
 {
 	LOCKMETHODID lockmethodid = locktag->locktag_lockmethodid;
 	LockMethod	lockMethodTable;
-	LOCALLOCKTAG localtag;
 	LOCALLOCK  *locallock;
 	LOCK	   *lock;
 	PROCLOCK   *proclock;
-	bool		found;
 	ResourceOwner owner;
 	uint32		hashcode;
 	LWLock	   *partitionLock;
@@ -781,45 +808,7 @@ LockAcquireExtended(const LOCKTAG *locktag,
 	/*
 	 * Find or create a LOCALLOCK entry for this lock and lockmode
 	 */
-	MemSet(&localtag, 0, sizeof(localtag)); /* must clear padding */
-	localtag.lock = *locktag;
-	localtag.mode = lockmode;
-
-	locallock = (LOCALLOCK *) hash_search(LockMethodLocalHash,
-										  (void *) &localtag,
-										  HASH_ENTER, &found);
-
-	/*
-	 * if it's a new locallock object, initialize it
-	 */
-	if (!found)
-	{
-		locallock->lock = NULL;
-		locallock->proclock = NULL;
-		locallock->hashcode = LockTagHashCode(&(localtag.lock));
-		locallock->nLocks = 0;
-		locallock->holdsStrongLockCount = false;
-		locallock->lockCleared = false;
-		locallock->numLockOwners = 0;
-		locallock->maxLockOwners = 8;
-		locallock->lockOwners = NULL;	/* in case next line fails */
-		locallock->lockOwners = (LOCALLOCKOWNER *)
-			MemoryContextAlloc(TopMemoryContext,
-							   locallock->maxLockOwners * sizeof(LOCALLOCKOWNER));
-	}
-	else
-	{
-		/* Make sure there will be room to remember the lock */
-		if (locallock->numLockOwners >= locallock->maxLockOwners)
-		{
-			int			newsize = locallock->maxLockOwners * 2;
-
-			locallock->lockOwners = (LOCALLOCKOWNER *)
-				repalloc(locallock->lockOwners,
-						 newsize * sizeof(LOCALLOCKOWNER));
-			locallock->maxLockOwners = newsize;
-		}
-	}
+	locallock = FindOrCreateLocalLock(locktag, lockmode);
 	hashcode = locallock->hashcode;
 
 	if (locallockp)
@@ -872,7 +861,8 @@ LockAcquireExtended(const LOCKTAG *locktag,
 	 * for now we don't worry about that case either.
 	 */
 	if (EligibleForRelationFastPath(locktag, lockmode) &&
-		FastPathLocalUseCount < FP_LOCK_SLOTS_PER_BACKEND)
+		FastPathLocalUseCounts[FAST_PATH_REL_GROUP(locktag->locktag_field2)] <
+		FP_LOCK_SLOTS_PER_GROUP)
 	{
 		uint32		fasthashcode = FastPathStrongLockHashPartition(hashcode);
 		bool		acquired;
@@ -1002,27 +992,8 @@ LockAcquireExtended(const LOCKTAG *locktag,
 		if (dontWait)
 		{
 			AbortStrongLockAcquire();
-			if (proclock->holdMask == 0)
-			{
-				uint32		proclock_hashcode;
-
-				proclock_hashcode = ProcLockHashCode(&proclock->tag, hashcode);
-				SHMQueueDelete(&proclock->lockLink);
-				SHMQueueDelete(&proclock->procLink);
-				if (!hash_search_with_hash_value(LockMethodProcLockHash,
-												 (void *) &(proclock->tag),
-												 proclock_hashcode,
-												 HASH_REMOVE,
-												 NULL))
-					elog(PANIC, "proclock table corrupted");
-			}
-			else
-				PROCLOCK_PRINT("LockAcquire: NOWAIT", proclock);
-			lock->nRequested--;
-			lock->requested[lockmode]--;
+			CancelLockRequest(lock, proclock, lockmode, hashcode);
 			LOCK_PRINT("LockAcquire: conditional lock failed", lock, lockmode);
-			Assert((lock->nRequested > 0) && (lock->requested[lockmode] >= 0));
-			Assert(lock->nGranted <= lock->nRequested);
 			LWLockRelease(partitionLock);
 			if (locallock->nLocks == 0)
 				RemoveLocalLock(locallock);
@@ -1105,6 +1076,314 @@ LockAcquireExtended(const LOCKTAG *locktag,
 	return LOCKACQUIRE_OK;
 }
 
+/* Work item for LockAcquireBatch's trip through the main lock table */
+typedef struct BatchLockItem
+{
+	int			index;			/* index into the caller's arrays */
+	int			partition;		/* lock partition of the lock */
+} BatchLockItem;
+
+static int
+batch_lock_item_cmp(const void *a, const void *b)
+{
+	const BatchLockItem *ia = (const BatchLockItem *) a;
+	const BatchLockItem *ib = (const BatchLockItem *) b;
+
+	if (ia->partition != ib->partition)
+		return (ia->partition < ib->partition) ? -1 : 1;
+	return (ia->index < ib->index) ? -1 : (ia->index > ib->index);
+}
+
+/*
+ * LockAcquireBatch -- acquire a number of locks at once
+ *
+ * This has the same effect as
+ *		results[i] = LockAcquireExtended(&locktags[i], lockmodes[i],
+ *										 false, false, true, &locallocks[i]);
+ * for each i, but is cheaper when there are many locks: the fast-path locks
+ * are all taken while holding our backendLock once, and the rest are sorted
+ * by lock partition, so that each partition LWLock is acquired only once.
+ *
+ * Only weak locks (RowExclusiveLock or less) of the default lock method are
+ * batched; anything else, and any lock we'd have to wait for, is simply
+ * passed to LockAcquireExtended.  So the locks are not necessarily acquired
+ * in the given order.  If we error out partway, the locks acquired so far
+ * stay held, as they would after a series of LockAcquire calls.
+ */
+void
+LockAcquireBatch(int nlocks, const LOCKTAG *locktags,
+				 const LOCKMODE *lockmodes, LOCALLOCK **locallocks,
+				 LockAcquireResult *results)
+{
+	LockMethod	lockMethodTable = LockMethods[DEFAULT_LOCKMETHOD];
+	ResourceOwner owner = CurrentResourceOwner;
+	BatchLockItem *items;
+	int			nitems = 0;
+	int		   *deferred;
+	int			ndeferred = 0;
+	bool		try_fastpath = false;
+	int			i;
+	int			j;
+
+	if (nlocks <= 0)
+		return;
+
+	items = (BatchLockItem *) palloc(nlocks * sizeof(BatchLockItem));
+	deferred = (int *) palloc(nlocks * sizeof(int));
+
+	/*
+	 * Pass over the locks that can't be batched, and look for the ones we
+	 * already hold.
+	 */
+	for (i = 0; i < nlocks; i++)
+	{
+		const LOCKTAG *locktag = &locktags[i];
+		LOCKMODE	lockmode = lockmodes[i];
+		LOCALLOCK  *locallock;
+
+		if (locktag->locktag_lockmethodid != DEFAULT_LOCKMETHOD ||
+			lockmode <= NoLock || lockmode > RowExclusiveLock)
+		{
+			deferred[ndeferred++] = i;
+			continue;
+		}
+
+		locallock = FindOrCreateLocalLock(locktag, lockmode);
+		locallocks[i] = locallock;
+
+		if (locallock->nLocks > 0)
+		{
+			GrantLockLocal(locallock, owner);
+			results[i] = locallock->lockCleared ?
+				LOCKACQUIRE_ALREADY_CLEAR : LOCKACQUIRE_ALREADY_HELD;
+			continue;
+		}
+
+		items[nitems].index = i;
+		items[nitems].partition = LockHashPartition(locallock->hashcode);
+		nitems++;
+
+		if (EligibleForRelationFastPath(locktag, lockmode))
+			try_fastpath = true;
+	}
+
+	/*
+	 * Take what we can via the fast path.  The comments in
+	 * LockAcquireExtended apply.
+	 */
+	if (try_fastpath)
+	{
+		LWLockAcquire(&MyProc->backendLock, LW_EXCLUSIVE);
+		for (j = 0; j < nitems; j++)
+		{
+			int			idx = items[j].index;
+			const LOCKTAG *locktag = &locktags[idx];
+			LOCKMODE	lockmode = lockmodes[idx];
+			LOCALLOCK  *locallock = locallocks[idx];
+			uint32		fasthashcode;
+
+			if (!EligibleForRelationFastPath(locktag, lockmode) ||
+				FastPathLocalUseCounts[FAST_PATH_REL_GROUP(locktag->locktag_field2)] >=
+				FP_LOCK_SLOTS_PER_GROUP)
+				continue;
+
+			/* The same lock might appear twice in the batch */
+			if (locallock->nLocks > 0)
+			{
+				GrantLockLocal(locallock, owner);
+				results[idx] = LOCKACQUIRE_ALREADY_HELD;
+				items[j].index = -1;
+				continue;
+			}
+
+			fasthashcode = FastPathStrongLockHashPartition(locallock->hashcode);
+			if (FastPathStrongRelationLocks->count[fasthashcode] != 0)
+				continue;
+			if (!FastPathGrantRelationLock(locktag->locktag_field2, lockmode))
+				continue;
+
+			locallock->lock = NULL;
+			locallock->proclock = NULL;
+			GrantLockLocal(locallock, owner);
+			results[idx] = LOCKACQUIRE_OK;
+			items[j].index = -1;
+		}
+		LWLockRelease(&MyProc->backendLock);
+	}
+
+	/*
+	 * Go through the main lock table for the rest, one partition at a time.
+	 * Items already taken care of above have index -1, and are skipped.
+	 */
+	qsort(items, nitems, sizeof(BatchLockItem), batch_lock_item_cmp);
+
+	j = 0;
+	while (j < nitems)
+	{
+		int			partition = items[j].partition;
+		LWLock	   *partitionLock;
+
+		if (items[j].index < 0)
+		{
+			j++;
+			continue;
+		}
+
+		partitionLock = LockHashPartitionLockByIndex(partition);
+		LWLockAcquire(partitionLock, LW_EXCLUSIVE);
+
+		for (; j < nitems && items[j].partition == partition; j++)
+		{
+			int			idx = items[j].index;
+			const LOCKTAG *locktag = &locktags[idx];
+			LOCKMODE	lockmode = lockmodes[idx];
+			LOCALLOCK  *locallock = locallocks[idx];
+			PROCLOCK   *proclock;
+			LOCK	   *lock;
+
+			if (idx < 0)
+				continue;
+
+			if (locallock->nLocks > 0)
+			{
+				GrantLockLocal(locallock, owner);
+				results[idx] = LOCKACQUIRE_ALREADY_HELD;
+				continue;
+			}
+
+			proclock = SetupLockInTable(lockMethodTable, MyProc, locktag,
+										locallock->hashcode, lockmode);
+			if (!proclock)
+			{
+				LWLockRelease(partitionLock);
+				RemoveLocalLock(locallock);
+				ereport(ERROR,
+						(errcode(ERRCODE_OUT_OF_MEMORY),
+						 errmsg("out of shared memory"),
+						 errhint("You might need to increase max_locks_per_transaction.")));
+			}
+			locallock->proclock = proclock;
+			lock = proclock->tag.myLock;
+			locallock->lock = lock;
+
+			/* If we'd have to wait, leave it to LockAcquireExtended */
+			if ((lockMethodTable->conflictTab[lockmode] & lock->waitMask) ||
+				LockCheckConflicts(lockMethodTable, lockmode,
+								   lock, proclock) != STATUS_OK)
+			{
+				CancelLockRequest(lock, proclock, lockmode,
+								  locallock->hashcode);
+				deferred[ndeferred++] = idx;
+				continue;
+			}
+
+			GrantLock(lock, proclock, lockmode);
+			GrantLockLocal(locallock, owner);
+			results[idx] = LOCKACQUIRE_OK;
+		}
+
+		LWLockRelease(partitionLock);
+	}
+
+	/* Finally, acquire the remaining locks the ordinary way */
+	for (i = 0; i < ndeferred; i++)
+	{
+		int			idx = deferred[i];
+
+		results[idx] = LockAcquireExtended(&locktags[idx], lockmodes[idx],
+										   false, false, true,
+										   &locallocks[idx]);
+	}
+
+	pfree(items);
+	pfree(deferred);
+}
+
+/*
+ * Find or create the LOCALLOCK entry for a lock and lockmode, and make sure
+ * there is room in it to remember one more owner.
+ */
+static LOCALLOCK *
+FindOrCreateLocalLock(const LOCKTAG *locktag, LOCKMODE lockmode)
+{
+	LOCALLOCKTAG localtag;
+	LOCALLOCK  *locallock;
+	bool		found;
+
+	MemSet(&localtag, 0, sizeof(localtag)); /* must clear padding */
+	localtag.lock = *locktag;
+	localtag.mode = lockmode;
+
+	locallock = (LOCALLOCK *) hash_search(LockMethodLocalHash,
+										  (void *) &localtag,
+										  HASH_ENTER, &found);
+
+	/*
+	 * if it's a new locallock object, initialize it
+	 */
+	if (!found)
+	{
+		locallock->lock = NULL;
+		locallock->proclock = NULL;
+		locallock->hashcode = LockTagHashCode(&(localtag.lock));
+		locallock->nLocks = 0;
+		locallock->holdsStrongLockCount = false;
+		locallock->lockCleared = false;
+		INSTR_TIME_SET_ZERO(locallock->grantTime);
+		locallock->numLockOwners = 0;
+		locallock->maxLockOwners = 8;
+		locallock->lockOwners = NULL;	/* in case next line fails */
+		locallock->lockOwners = (LOCALLOCKOWNER *)
+			MemoryContextAlloc(TopMemoryContext,
+							   locallock->maxLockOwners * sizeof(LOCALLOCKOWNER));
+	}
+	else
+	{
+		/* Make sure there will be room to remember the lock */
+		if (locallock->numLockOwners >= locallock->maxLockOwners)
+		{
+			int			newsize = locallock->maxLockOwners * 2;
+
+			locallock->lockOwners = (LOCALLOCKOWNER *)
+				repalloc(locallock->lockOwners,
+						 newsize * sizeof(LOCALLOCKOWNER));
+			locallock->maxLockOwners = newsize;
+		}
+	}
+
+	return locallock;
+}
+
+/*
+ * Undo a lock request that SetupLockInTable made but that we have decided
+ * not to wait for.  The caller must hold the partition lock.
+ */
+static void
+CancelLockRequest(LOCK *lock, PROCLOCK *proclock, LOCKMODE lockmode,
+				  uint32 hashcode)
+{
+	if (proclock->holdMask == 0)
+	{
+		uint32		proclock_hashcode;
+
+		proclock_hashcode = ProcLockHashCode(&proclock->tag, hashcode);
+		SHMQueueDelete(&proclock->lockLink);
+		SHMQueueDelete(&proclock->procLink);
+		if (!hash_search_with_hash_value(LockMethodProcLockHash,
+										 (void *) &(proclock->tag),
+										 proclock_hashcode,
+										 HASH_REMOVE,
+										 NULL))
+			elog(PANIC, "proclock table corrupted");
+	}
+	else
+		PROCLOCK_PRINT("LockAcquire: NOWAIT", proclock);
+	lock->nRequested--;
+	lock->requested[lockmode]--;
+	Assert((lock->nRequested > 0) && (lock->requested[lockmode] >= 0));
+	Assert(lock->nGranted <= lock->nRequested);
+}
+
 /*
  * Find or create LOCK and PROCLOCK objects as needed for a new lock
  * request.
@@ -1297,6 +1576,10 @@ RemoveLocalLock(LOCALLOCK *locallock)
 {
 	int			i;
 
+	if (LockStatsTimingStarted(locallock->grantTime))
+		LockStatsCountHold(LOCKSTATS_LOCK_ENTRY(locallock->tag.lock.locktag_type),
+						   locallock->grantTime);
+
 	for (i = locallock->numLockOwners - 1; i >= 0; i--)
 	{
 		if (locallock->lockOwners[i].owner != NULL)
@@ -1606,6 +1889,8 @@ GrantLockLocal(LOCALLOCK *locallock, ResourceOwner owner)
 	Assert(locallock->numLockOwners < locallock->maxLockOwners);
 	/* Count the total */
 	locallock->nLocks++;
+	if (locallock->nLocks == 1)
+		LockStatsStartTiming(locallock->grantTime);
 	/* Count the per-owner lock */
 	for (i = 0; i < locallock->numLockOwners; i++)
 	{
@@ -1725,6 +2010,7 @@ WaitOnLock(LOCALLOCK *locallock, ResourceOwner owner)
 	LOCKMETHODID lockmethodid = LOCALLOCK_LOCKMETHOD(*locallock);
 	LockMethod	lockMethodTable = LockMethods[lockmethodid];
 	char	   *volatile new_status = NULL;
+	instr_time	wait_start;
 
 	LOCK_PRINT("WaitOnLock: sleeping on lock",
 			   locallock->lock, locallock->tag.mode);
@@ -1746,6 +2032,8 @@ WaitOnLock(LOCALLOCK *locallock, ResourceOwner owner)
 	awaitedLock = locallock;
 	awaitedOwner = owner;
 
+	LockStatsStartTiming(wait_start);
+
 	/*
 	 * NOTE: Think not to put any shared-state cleanup after the call to
 	 * ProcSleep, in either the normal or failure path.  The lock state must
@@ -1802,6 +2090,10 @@ WaitOnLock(LOCALLOCK *locallock, ResourceOwner owner)
 
 	awaitedLock = NULL;
 
+	if (LockStatsTimingStarted(wait_start))
+		LockStatsCountWait(LOCKSTATS_LOCK_ENTRY(locallock->tag.lock.locktag_type),
+						   wait_start);
+
 	/* Report change to non-waiting status */
 	if (update_process_title)
 	{
@@ -1986,7 +2278,7 @@ LockRelease(const LOCKTAG *locktag, LOCKMODE lockmode, bool sessionLock)
 
 	/* Attempt fast release of any lock eligible for the fast path. */
 	if (EligibleForRelationFastPath(locktag, lockmode) &&
-		FastPathLocalUseCount > 0)
+		FastPathLocalUseCounts[FAST_PATH_REL_GROUP(locktag->locktag_field2)] > 0)
 	{
 		bool		released;
 
@@ -2380,6 +2672,36 @@ LockReleaseSession(LOCKMETHODID lockmethodid)
 	}
 }
 
+/*
+ * LockHaveSessionLocks -- Report whether the current process holds any
+ *		session locks, such as session-level advisory locks.
+ */
+bool
+LockHaveSessionLocks(void)
+{
+	HASH_SEQ_STATUS status;
+	LOCALLOCK  *locallock;
+
+	hash_seq_init(&status, LockMethodLocalHash);
+
+	while ((locallock = (LOCALLOCK *) hash_seq_search(&status)) != NULL)
+	{
+		int			i;
+
+		/* Session locks are the ones with no resource owner */
+		for (i = 0; i < locallock->numLockOwners; i++)
+		{
+			if (locallock->lockOwners[i].owner == NULL)
+			{
+				hash_seq_term(&status);
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
 /*
  * LockReleaseCurrentOwner
  *		Release all locks belonging to CurrentResourceOwner
@@ -2563,11 +2885,13 @@ LockReassignOwner(LOCALLOCK *locallock, ResourceOwner parent)
 static bool
 FastPathGrantRelationLock(Oid relid, LOCKMODE lockmode)
 {
+	uint32		group = FAST_PATH_REL_GROUP(relid);
+	uint32		first = FAST_PATH_FIRST_SLOT(group);
 	uint32		f;
 	uint32		unused_slot = FP_LOCK_SLOTS_PER_BACKEND;
 
-	/* Scan for existing entry for this relid, remembering empty slot. */
-	for (f = 0; f < FP_LOCK_SLOTS_PER_BACKEND; f++)
+	/* Scan the group for an existing entry, remembering an empty slot. */
+	for (f = first; f < first + FP_LOCK_SLOTS_PER_GROUP; f++)
 	{
 		if (FAST_PATH_GET_BITS(MyProc, f) == 0)
 			unused_slot = f;
@@ -2584,7 +2908,7 @@ FastPathGrantRelationLock(Oid relid, LOCKMODE lockmode)
 	{
 		MyProc->fpRelId[unused_slot] = relid;
 		FAST_PATH_SET_LOCKMODE(MyProc, unused_slot, lockmode);
-		++FastPathLocalUseCount;
+		++FastPathLocalUseCounts[group];
 		return true;
 	}
 
@@ -2600,11 +2924,13 @@ FastPathGrantRelationLock(Oid relid, LOCKMODE lockmode)
 static bool
 FastPathUnGrantRelationLock(Oid relid, LOCKMODE lockmode)
 {
+	uint32		group = FAST_PATH_REL_GROUP(relid);
+	uint32		first = FAST_PATH_FIRST_SLOT(group);
 	uint32		f;
 	bool		result = false;
 
-	FastPathLocalUseCount = 0;
-	for (f = 0; f < FP_LOCK_SLOTS_PER_BACKEND; f++)
+	FastPathLocalUseCounts[group] = 0;
+	for (f = first; f < first + FP_LOCK_SLOTS_PER_GROUP; f++)
 	{
 		if (MyProc->fpRelId[f] == relid
 			&& FAST_PATH_CHECK_LOCKMODE(MyProc, f, lockmode))
@@ -2612,10 +2938,10 @@ FastPathUnGrantRelationLock(Oid relid, LOCKMODE lockmode)
 			Assert(!result);
 			FAST_PATH_CLEAR_LOCKMODE(MyProc, f, lockmode);
 			result = true;
-			/* we continue iterating so as to update FastPathLocalUseCount */
+			/* we continue iterating so as to update FastPathLocalUseCounts */
 		}
 		if (FAST_PATH_GET_BITS(MyProc, f) != 0)
-			++FastPathLocalUseCount;
+			++FastPathLocalUseCounts[group];
 	}
 	return result;
 }
@@ -2633,6 +2959,7 @@ FastPathTransferRelationLocks(LockMethod lockMethodTable, const LOCKTAG *locktag
 {
 	LWLock	   *partitionLock = LockHashPartitionLock(hashcode);
 	Oid			relid = locktag->locktag_field2;
+	uint32		first = FAST_PATH_FIRST_SLOT(FAST_PATH_REL_GROUP(relid));
 	uint32		i;
 
 	/*
@@ -2669,7 +2996,8 @@ FastPathTransferRelationLocks(LockMethod lockMethodTable, const LOCKTAG *locktag
 			continue;
 		}
 
-		for (f = 0; f < FP_LOCK_SLOTS_PER_BACKEND; f++)
+		/* Only the relation's group can hold fast-path locks on it */
+		for (f = first; f < first + FP_LOCK_SLOTS_PER_GROUP; f++)
 		{
 			uint32		lockmode;
 
@@ -2723,11 +3051,12 @@ FastPathGetRelationLockEntry(LOCALLOCK *locallock)
 	PROCLOCK   *proclock = NULL;
 	LWLock	   *partitionLock = LockHashPartitionLock(locallock->hashcode);
 	Oid			relid = locktag->locktag_field2;
+	uint32		first = FAST_PATH_FIRST_SLOT(FAST_PATH_REL_GROUP(relid));
 	uint32		f;
 
 	LWLockAcquire(&MyProc->backendLock, LW_EXCLUSIVE);
 
-	for (f = 0; f < FP_LOCK_SLOTS_PER_BACKEND; f++)
+	for (f = first; f < first + FP_LOCK_SLOTS_PER_GROUP; f++)
 	{
 		uint32		lockmode;
 
@@ -2867,6 +3196,7 @@ GetLockConflicts(const LOCKTAG *locktag, LOCKMODE lockmode)
 	{
 		int			i;
 		Oid			relid = locktag->locktag_field2;
+		uint32		first = FAST_PATH_FIRST_SLOT(FAST_PATH_REL_GROUP(relid));
 		VirtualTransactionId vxid;
 
 		/*
@@ -2904,7 +3234,7 @@ GetLockConflicts(const LOCKTAG *locktag, LOCKMODE lockmode)
 				continue;
 			}
 
-			for (f = 0; f < FP_LOCK_SLOTS_PER_BACKEND; f++)
+			for (f = first; f < first + FP_LOCK_SLOTS_PER_GROUP; f++)
 			{
 				uint32		lockmask;
 
@@ -3429,6 +3759,44 @@ PostPrepare_Locks(TransactionId xid)
 }
 
 
+/*
+ * InitializeFastPathLocks -- choose the number of fast-path lock groups
+ *
+ * Each backend gets about max_locks_per_transaction fast-path slots, which
+ * is what a transaction is expected to need on average, rounded up to a
+ * power-of-2 number of groups.  This must be called after the GUCs have been
+ * loaded and before shared memory is sized.
+ */
+void
+InitializeFastPathLocks(void)
+{
+	int			groups = 1;
+
+	Assert(FastPathLockGroupsPerBackend == 0);
+
+	while (groups * FP_LOCK_SLOTS_PER_GROUP < max_locks_per_xact &&
+		   groups < FP_LOCK_GROUPS_PER_BACKEND_MAX)
+		groups *= 2;
+
+	FastPathLockGroupsPerBackend = groups;
+}
+
+/*
+ * Estimate the shared-memory space for one PGPROC's fast-path lock arrays
+ */
+Size
+FastPathLockShmemSize(void)
+{
+	Size		size = 0;
+
+	size = add_size(size, MAXALIGN(mul_size(FastPathLockGroupsPerBackend,
+											sizeof(uint64))));
+	size = add_size(size, MAXALIGN(mul_size(FP_LOCK_SLOTS_PER_BACKEND,
+											sizeof(Oid))));
+
+	return size;
+}
+
 /*
  * Estimate shared-memory space used for lock tables
  */
@@ -0,0 +1,286 @@
+/*-------------------------------------------------------------------------
+ *
+ * lockstats.c
+ *	  Lock wait and hold time statistics
+ *
+ * When track_lock_timing is enabled, lwlock.c and lock.c time every wait
+ * for a lock and every interval during which a lock is held, and report the
+ * results here.  The counters are accumulated in backend-local memory and
+ * added to the shared totals at most every LOCKSTATS_FLUSH_INTERVAL msec, so
+ * that the lock paths themselves never touch shared state for this.  The
+ * shared totals are plain atomic counters; no lock protects them, which is
+ * what allows LWLocks themselves to be instrumented.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/storage/lmgr/lockstats.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "miscadmin.h"
+#include "port/atomics.h"
+#include "storage/lockstats.h"
+#include "storage/shmem.h"
+#include "utils/timestamp.h"
+
+
+/* Minimum time between flushes of the local counters, in msec */
+#define LOCKSTATS_FLUSH_INTERVAL	500
+
+/* Shared-memory version of LockTimingCounts */
+typedef struct LockStatsEntry
+{
+	pg_atomic_uint64 wait_count;
+	pg_atomic_uint64 wait_time;
+	pg_atomic_uint64 max_wait_time;
+	pg_atomic_uint64 hold_count;
+	pg_atomic_uint64 hold_time;
+	pg_atomic_uint64 hold_hist[LOCKSTATS_HIST_BUCKETS];
+} LockStatsEntry;
+
+typedef struct LockStatsShared
+{
+	pg_atomic_uint64 stats_reset;	/* TimestampTz of last reset */
+	LockStatsEntry entries[LOCKSTATS_NUM_ENTRIES];
+} LockStatsShared;
+
+bool		track_lock_timing = false;
+
+static LockStatsShared *lockStats = NULL;
+
+/* Counts not yet added to the shared totals */
+static LockTimingCounts pendingCounts[LOCKSTATS_NUM_ENTRIES];
+static bool have_pending_counts = false;
+
+static void LockStatsResetEntry(LockStatsEntry *entry);
+
+
+/*
+ * Report a lock wait that started at 'start' and has just ended.
+ */
+void
+LockStatsCountWait(int entry, instr_time start)
+{
+	LockTimingCounts *counts;
+	instr_time	duration;
+	uint64		usecs;
+
+	if (entry < 0)
+		return;
+
+	INSTR_TIME_SET_CURRENT(duration);
+	INSTR_TIME_SUBTRACT(duration, start);
+	usecs = INSTR_TIME_GET_MICROSEC(duration);
+
+	counts = &pendingCounts[entry];
+	counts->wait_count++;
+	counts->wait_time += usecs;
+	if (usecs > counts->max_wait_time)
+		counts->max_wait_time = usecs;
+	have_pending_counts = true;
+}
+
+/*
+ * Report a lock hold that started at 'start' and has just ended.
+ */
+void
+LockStatsCountHold(int entry, instr_time start)
+{
+	LockTimingCounts *counts;
+	instr_time	duration;
+	uint64		usecs;
+	int			bucket;
+
+	if (entry < 0)
+		return;
+
+	INSTR_TIME_SET_CURRENT(duration);
+	INSTR_TIME_SUBTRACT(duration, start);
+	usecs = INSTR_TIME_GET_MICROSEC(duration);
+
+	bucket = 0;
+	while (usecs >> bucket != 0 && bucket < LOCKSTATS_HIST_BUCKETS - 1)
+		bucket++;
+
+	counts = &pendingCounts[entry];
+	counts->hold_count++;
+	counts->hold_time += usecs;
+	counts->hold_hist[bucket]++;
+	have_pending_counts = true;
+}
+
+/*
+ * Add the locally accumulated counts to the shared totals.
+ *
+ * Unless 'force' is true, this does nothing if the previous flush was less
+ * than LOCKSTATS_FLUSH_INTERVAL msec ago.
+ */
+void
+LockStatsFlush(bool force)
+{
+	static TimestampTz last_flush = 0;
+	TimestampTz now;
+	int			i;
+
+	if (!have_pending_counts || lockStats == NULL)
+		return;
+
+	now = GetCurrentTimestamp();
+	if (!force &&
+		!TimestampDifferenceExceeds(last_flush, now, LOCKSTATS_FLUSH_INTERVAL))
+		return;
+	last_flush = now;
+
+	for (i = 0; i < LOCKSTATS_NUM_ENTRIES; i++)
+	{
+		LockTimingCounts *counts = &pendingCounts[i];
+		LockStatsEntry *entry = &lockStats->entries[i];
+		int			j;
+
+		if (counts->wait_count > 0)
+		{
+			uint64		oldmax;
+
+			pg_atomic_fetch_add_u64(&entry->wait_count, counts->wait_count);
+			pg_atomic_fetch_add_u64(&entry->wait_time, counts->wait_time);
+
+			oldmax = pg_atomic_read_u64(&entry->max_wait_time);
+			while (oldmax < counts->max_wait_time)
+			{
+				if (pg_atomic_compare_exchange_u64(&entry->max_wait_time,
+												   &oldmax,
+												   counts->max_wait_time))
+					break;
+			}
+		}
+
+		if (counts->hold_count > 0)
+		{
+			pg_atomic_fetch_add_u64(&entry->hold_count, counts->hold_count);
+			pg_atomic_fetch_add_u64(&entry->hold_time, counts->hold_time);
+			for (j = 0; j < LOCKSTATS_HIST_BUCKETS; j++)
+			{
+				if (counts->hold_hist[j] > 0)
+					pg_atomic_fetch_add_u64(&entry->hold_hist[j],
+											counts->hold_hist[j]);
+			}
+		}
+	}
+
+	MemSet(pendingCounts, 0, sizeof(pendingCounts));
+	have_pending_counts = false;
+}
+
+/*
+ * Report shared memory space needed by LockStatsShmemInit
+ */
+Size
+LockStatsShmemSize(void)
+{
+	return sizeof(LockStatsShared);
+}
+
+/*
+ * Allocate and initialize the shared counters
+ */
+void
+LockStatsShmemInit(void)
+{
+	bool		found;
+	int			i;
+
+	lockStats = (LockStatsShared *)
+		ShmemInitStruct("Lock Timing Stats", LockStatsShmemSize(), &found);
+
+	if (!IsUnderPostmaster)
+	{
+		Assert(!found);
+
+		pg_atomic_init_u64(&lockStats->stats_reset,
+						   (uint64) GetCurrentTimestamp());
+		for (i = 0; i < LOCKSTATS_NUM_ENTRIES; i++)
+		{
+			LockStatsEntry *entry = &lockStats->entries[i];
+			int			j;
+
+			pg_atomic_init_u64(&entry->wait_count, 0);
+			pg_atomic_init_u64(&entry->wait_time, 0);
+			pg_atomic_init_u64(&entry->max_wait_time, 0);
+			pg_atomic_init_u64(&entry->hold_count, 0);
+			pg_atomic_init_u64(&entry->hold_time, 0);
+			for (j = 0; j < LOCKSTATS_HIST_BUCKETS; j++)
+				pg_atomic_init_u64(&entry->hold_hist[j], 0);
+		}
+	}
+	else
+		Assert(found);
+}
+
+/*
+ * Copy the shared totals into 'counts', which must have room for
+ * LOCKSTATS_NUM_ENTRIES entries, and return the time of the last reset.
+ *
+ * Our own pending counts are flushed first, so that they are included.  The
+ * result is not an atomic snapshot; other backends' flushes may be partially
+ * reflected.
+ */
+TimestampTz
+LockStatsFetch(LockTimingCounts *counts)
+{
+	int			i;
+
+	LockStatsFlush(true);
+
+	for (i = 0; i < LOCKSTATS_NUM_ENTRIES; i++)
+	{
+		LockStatsEntry *entry = &lockStats->entries[i];
+		int			j;
+
+		counts[i].wait_count = pg_atomic_read_u64(&entry->wait_count);
+		counts[i].wait_time = pg_atomic_read_u64(&entry->wait_time);
+		counts[i].max_wait_time = pg_atomic_read_u64(&entry->max_wait_time);
+		counts[i].hold_count = pg_atomic_read_u64(&entry->hold_count);
+		counts[i].hold_time = pg_atomic_read_u64(&entry->hold_time);
+		for (j = 0; j < LOCKSTATS_HIST_BUCKETS; j++)
+			counts[i].hold_hist[j] = pg_atomic_read_u64(&entry->hold_hist[j]);
+	}
+
+	return (TimestampTz) pg_atomic_read_u64(&lockStats->stats_reset);
+}
+
+/*
+ * Zero the shared totals, and discard our own pending counts.
+ */
+void
+LockStatsReset(void)
+{
+	int			i;
+
+	MemSet(pendingCounts, 0, sizeof(pendingCounts));
+	have_pending_counts = false;
+
+	for (i = 0; i < LOCKSTATS_NUM_ENTRIES; i++)
+		LockStatsResetEntry(&lockStats->entries[i]);
+
+	pg_atomic_write_u64(&lockStats->stats_reset,
+						(uint64) GetCurrentTimestamp());
+}
+
+static void
+LockStatsResetEntry(LockStatsEntry *entry)
+{
+	int			j;
+
+	pg_atomic_write_u64(&entry->wait_count, 0);
+	pg_atomic_write_u64(&entry->wait_time, 0);
+	pg_atomic_write_u64(&entry->max_wait_time, 0);
+	pg_atomic_write_u64(&entry->hold_count, 0);
+	pg_atomic_write_u64(&entry->hold_time, 0);
+	for (j = 0; j < LOCKSTATS_HIST_BUCKETS; j++)
+		pg_atomic_write_u64(&entry->hold_hist[j], 0);
+}
@@ -82,6 +82,7 @@
 #include "postmaster/postmaster.h"
 #include "replication/slot.h"
 #include "storage/ipc.h"
+#include "storage/lockstats.h"
 #include "storage/predicate.h"
 #include "storage/proc.h"
 #include "storage/proclist.h"
@@ -137,6 +138,7 @@ typedef struct LWLockHandle
 {
 	LWLock	   *lock;
 	LWLockMode	mode;
+	instr_time	acquired;		/* for track_lock_timing, else zero */
 } LWLockHandle;
 
 static int	num_held_lwlocks = 0;
@@ -508,6 +510,8 @@ RegisterLWLockTranches(void)
 	LWLockRegisterTranche(LWTRANCHE_LOCK_MANAGER, "lock_manager");
 	LWLockRegisterTranche(LWTRANCHE_PREDICATE_LOCK_MANAGER,
 						  "predicate_lock_manager");
+	LWLockRegisterTranche(LWTRANCHE_RELATION_EXTENSION,
+						  "relation_extension");
 	LWLockRegisterTranche(LWTRANCHE_PARALLEL_QUERY_DSA,
 						  "parallel_query_dsa");
 	LWLockRegisterTranche(LWTRANCHE_SESSION_DSA,
@@ -521,6 +525,18 @@ RegisterLWLockTranches(void)
 	LWLockRegisterTranche(LWTRANCHE_TBM, "tbm");
 	LWLockRegisterTranche(LWTRANCHE_PARALLEL_APPEND, "parallel_append");
 	LWLockRegisterTranche(LWTRANCHE_PARALLEL_HASH_JOIN, "parallel_hash_join");
+	LWLockRegisterTranche(LWTRANCHE_STATS_DSA, "stats_dsa");
+	LWLockRegisterTranche(LWTRANCHE_STATS_HASH, "stats_hash");
+	LWLockRegisterTranche(LWTRANCHE_SHARED_CATCACHE_DSA,
+						  "shared_catcache_dsa");
+	LWLockRegisterTranche(LWTRANCHE_SHARED_CATCACHE_HASH,
+						  "shared_catcache_hash");
+	LWLockRegisterTranche(LWTRANCHE_SHARED_PLANCACHE_DSA,
+						  "shared_plancache_dsa");
+	LWLockRegisterTranche(LWTRANCHE_SHARED_PLANCACHE_HASH,
+						  "shared_plancache_hash");
+	LWLockRegisterTranche(LWTRANCHE_RELSIZE_CACHE, "relsize_cache");
+	LWLockRegisterTranche(LWTRANCHE_FSYNC_REQUEST, "fsync_request");
 
 	/* Register named tranches. */
 	for (i = 0; i < NamedLWLockTrancheRequests; i++)
@@ -1123,6 +1139,7 @@ LWLockAcquire(LWLock *lock, LWLockMode mode)
 	PGPROC	   *proc = MyProc;
 	bool		result = true;
 	int			extraWaits = 0;
+	instr_time	wait_start;
 #ifdef LWLOCK_STATS
 	lwlock_stats *lwstats;
 
@@ -1237,6 +1254,7 @@ LWLockAcquire(LWLock *lock, LWLockMode mode)
 
 		LWLockReportWaitStart(lock);
 		TRACE_POSTGRESQL_LWLOCK_WAIT_START(T_NAME(lock), mode);
+		LockStatsStartTiming(wait_start);
 
 		for (;;)
 		{
@@ -1246,6 +1264,10 @@ LWLockAcquire(LWLock *lock, LWLockMode mode)
 			extraWaits++;
 		}
 
+		if (LockStatsTimingStarted(wait_start))
+			LockStatsCountWait(LOCKSTATS_LWLOCK_ENTRY(lock->tranche),
+							   wait_start);
+
 		/* Retrying, allow LWLockRelease to release waiters again. */
 		pg_atomic_fetch_or_u32(&lock->state, LW_FLAG_RELEASE_OK);
 
@@ -1271,7 +1293,9 @@ LWLockAcquire(LWLock *lock, LWLockMode mode)
 
 	/* Add lock to list of locks held by this backend */
 	held_lwlocks[num_held_lwlocks].lock = lock;
-	held_lwlocks[num_held_lwlocks++].mode = mode;
+	held_lwlocks[num_held_lwlocks].mode = mode;
+	LockStatsStartTiming(held_lwlocks[num_held_lwlocks].acquired);
+	num_held_lwlocks++;
 
 	/*
 	 * Fix the process wait semaphore's count for any absorbed wakeups.
@@ -1324,7 +1348,9 @@ LWLockConditionalAcquire(LWLock *lock, LWLockMode mode)
 	{
 		/* Add lock to list of locks held by this backend */
 		held_lwlocks[num_held_lwlocks].lock = lock;
-		held_lwlocks[num_held_lwlocks++].mode = mode;
+		held_lwlocks[num_held_lwlocks].mode = mode;
+		LockStatsStartTiming(held_lwlocks[num_held_lwlocks].acquired);
+		num_held_lwlocks++;
 		TRACE_POSTGRESQL_LWLOCK_CONDACQUIRE(T_NAME(lock), mode);
 	}
 	return !mustwait;
@@ -1350,6 +1376,7 @@ LWLockAcquireOrWait(LWLock *lock, LWLockMode mode)
 	PGPROC	   *proc = MyProc;
 	bool		mustwait;
 	int			extraWaits = 0;
+	instr_time	wait_start;
 #ifdef LWLOCK_STATS
 	lwlock_stats *lwstats;
 
@@ -1398,6 +1425,7 @@ LWLockAcquireOrWait(LWLock *lock, LWLockMode mode)
 
 			LWLockReportWaitStart(lock);
 			TRACE_POSTGRESQL_LWLOCK_WAIT_START(T_NAME(lock), mode);
+			LockStatsStartTiming(wait_start);
 
 			for (;;)
 			{
@@ -1407,6 +1435,10 @@ LWLockAcquireOrWait(LWLock *lock, LWLockMode mode)
 				extraWaits++;
 			}
 
+			if (LockStatsTimingStarted(wait_start))
+				LockStatsCountWait(LOCKSTATS_LWLOCK_ENTRY(lock->tranche),
+								   wait_start);
+
 #ifdef LOCK_DEBUG
 			{
 				/* not waiting anymore */
@@ -1452,7 +1484,9 @@ LWLockAcquireOrWait(LWLock *lock, LWLockMode mode)
 		LOG_LWDEBUG("LWLockAcquireOrWait", lock, "succeeded");
 		/* Add lock to list of locks held by this backend */
 		held_lwlocks[num_held_lwlocks].lock = lock;
-		held_lwlocks[num_held_lwlocks++].mode = mode;
+		held_lwlocks[num_held_lwlocks].mode = mode;
+		LockStatsStartTiming(held_lwlocks[num_held_lwlocks].acquired);
+		num_held_lwlocks++;
 		TRACE_POSTGRESQL_LWLOCK_ACQUIRE_OR_WAIT(T_NAME(lock), mode);
 	}
 
@@ -1534,6 +1568,7 @@ LWLockWaitForVar(LWLock *lock, uint64 *valptr, uint64 oldval, uint64 *newval)
 	PGPROC	   *proc = MyProc;
 	int			extraWaits = 0;
 	bool		result = false;
+	instr_time	wait_start;
 #ifdef LWLOCK_STATS
 	lwlock_stats *lwstats;
 
@@ -1614,6 +1649,7 @@ LWLockWaitForVar(LWLock *lock, uint64 *valptr, uint64 oldval, uint64 *newval)
 
 		LWLockReportWaitStart(lock);
 		TRACE_POSTGRESQL_LWLOCK_WAIT_START(T_NAME(lock), LW_EXCLUSIVE);
+		LockStatsStartTiming(wait_start);
 
 		for (;;)
 		{
@@ -1623,6 +1659,10 @@ LWLockWaitForVar(LWLock *lock, uint64 *valptr, uint64 oldval, uint64 *newval)
 			extraWaits++;
 		}
 
+		if (LockStatsTimingStarted(wait_start))
+			LockStatsCountWait(LOCKSTATS_LWLOCK_ENTRY(lock->tranche),
+							   wait_start);
+
 #ifdef LOCK_DEBUG
 		{
 			/* not waiting anymore */
@@ -1742,6 +1782,10 @@ LWLockRelease(LWLock *lock)
 
 	mode = held_lwlocks[i].mode;
 
+	if (LockStatsTimingStarted(held_lwlocks[i].acquired))
+		LockStatsCountHold(LOCKSTATS_LWLOCK_ENTRY(lock->tranche),
+						   held_lwlocks[i].acquired);
+
 	num_held_lwlocks--;
 	for (; i < num_held_lwlocks; i++)
 		held_lwlocks[i] = held_lwlocks[i + 1];
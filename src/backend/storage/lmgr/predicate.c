@@ -359,6 +359,7 @@ static SERIALIZABLEXACT *OldCommittedSxact;
 int			max_predicate_locks_per_xact;	/* set by guc.c */
 int			max_predicate_locks_per_relation;	/* set by guc.c */
 int			max_predicate_locks_per_page;	/* set by guc.c */
+int			serializable_buffers;	/* set by guc.c */
 
 /*
  * This provides a list of objects in order to track transactions
@@ -802,8 +803,8 @@ OldSerXidInit(void)
 	 */
 	OldSerXidSlruCtl->PagePrecedes = OldSerXidPagePrecedesLogically;
 	SimpleLruInit(OldSerXidSlruCtl, "oldserxid",
-				  NUM_OLDSERXID_BUFFERS, 0, OldSerXidLock, "pg_serial",
-				  LWTRANCHE_OLDSERXID_BUFFERS);
+				  serializable_buffers, 0, OldSerXidLock, "pg_serial",
+				  LWTRANCHE_OLDSERXID_BUFFERS, 0);
 	/* Override default assumption that writes should be fsync'd */
 	OldSerXidSlruCtl->do_fsync = false;
 
@@ -1305,7 +1306,7 @@ PredicateLockShmemSize(void)
 
 	/* Shared memory structures for SLRU tracking of old committed xids. */
 	size = add_size(size, sizeof(OldSerXidControlData));
-	size = add_size(size, SimpleLruShmemSize(NUM_OLDSERXID_BUFFERS, 0));
+	size = add_size(size, SimpleLruShmemSize(serializable_buffers, 0));
 
 	return size;
 }
@@ -3270,7 +3271,7 @@ ReleasePredicateLocks(bool isCommit)
 	 * transaction to complete before freeing some RAM; correctness of visible
 	 * behavior is not affected.
 	 */
-	MySerializableXact->finishedBefore = ShmemVariableCache->nextXid;
+	MySerializableXact->finishedBefore = XidFromFullTransactionId(ShmemVariableCache->nextFullXid);
 
 	/*
 	 * If it's not a commit it's a rollback, and we can clear our locks
@@ -3905,6 +3906,7 @@ CheckForSerializableConflictOut(bool visible, Relation relation,
 	SERIALIZABLEXID *sxid;
 	SERIALIZABLEXACT *sxact;
 	HTSV_Result htsvResult;
+	LWLockMode	lockmode = LW_SHARED;
 
 	if (!SerializationNeededForRead(relation, snapshot))
 		return;
@@ -3981,9 +3983,16 @@ CheckForSerializableConflictOut(bool visible, Relation relation,
 
 	/*
 	 * Find sxact or summarized info for the top level xid.
+	 *
+	 * Most reads of a concurrently written tuple turn out not to need any
+	 * changes, for example because the conflict has been flagged already, so
+	 * we start out with a shared lock.  When a change is needed we get an
+	 * exclusive lock instead and start over, because things may have changed
+	 * while we held no lock.
 	 */
 	sxidtag.xid = xid;
-	LWLockAcquire(SerializableXactHashLock, LW_EXCLUSIVE);
+retry:
+	LWLockAcquire(SerializableXactHashLock, lockmode);
 	sxid = (SERIALIZABLEXID *)
 		hash_search(SerializableXidHash, &sxidtag, HASH_FIND, NULL);
 	if (!sxid)
@@ -4015,7 +4024,16 @@ CheckForSerializableConflictOut(bool visible, Relation relation,
 						 errdetail_internal("Reason code: Canceled on identification as a pivot, with conflict out to old committed transaction %u.", xid),
 						 errhint("The transaction might succeed if retried.")));
 
-			MySerializableXact->flags |= SXACT_FLAG_SUMMARY_CONFLICT_OUT;
+			if (!SxactHasSummaryConflictOut(MySerializableXact))
+			{
+				if (lockmode == LW_SHARED)
+				{
+					LWLockRelease(SerializableXactHashLock);
+					lockmode = LW_EXCLUSIVE;
+					goto retry;
+				}
+				MySerializableXact->flags |= SXACT_FLAG_SUMMARY_CONFLICT_OUT;
+			}
 		}
 
 		/* It's not serializable or otherwise not important. */
@@ -4041,6 +4059,12 @@ CheckForSerializableConflictOut(bool visible, Relation relation,
 	{
 		if (!SxactIsPrepared(sxact))
 		{
+			if (lockmode == LW_SHARED)
+			{
+				LWLockRelease(SerializableXactHashLock);
+				lockmode = LW_EXCLUSIVE;
+				goto retry;
+			}
 			sxact->flags |= SXACT_FLAG_DOOMED;
 			LWLockRelease(SerializableXactHashLock);
 			return;
@@ -4086,6 +4110,13 @@ CheckForSerializableConflictOut(bool visible, Relation relation,
 		return;
 	}
 
+	if (lockmode == LW_SHARED)
+	{
+		LWLockRelease(SerializableXactHashLock);
+		lockmode = LW_EXCLUSIVE;
+		goto retry;
+	}
+
 	/*
 	 * Flag the conflict.  But first, if this conflict creates a dangerous
 	 * structure, ereport an error.
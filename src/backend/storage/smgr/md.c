@@ -31,6 +31,7 @@
 #include "pgstat.h"
 #include "portability/instr_time.h"
 #include "postmaster/bgwriter.h"
+#include "access/xlogdefs.h"
 #include "storage/fd.h"
 #include "storage/bufmgr.h"
 #include "storage/relfilenode.h"
@@ -47,9 +48,10 @@
 /*
  * Special values for the segno arg to RememberFsyncRequest.
  *
- * Note that CompactCheckpointerRequestQueue assumes that it's OK to remove an
- * fsync request from the queue if an identical, subsequent request is found.
- * See comments there before making changes here.
+ * The checkpointer keeps only one copy of identical pending fsync requests,
+ * and relies on these values being far above any real segment number to tell
+ * them apart from ordinary requests, which it may reorder relative to each
+ * other.  See comments in checkpointer.c before making changes here.
  */
 #define FORGET_RELATION_FSYNC	(InvalidBlockNumber)
 #define FORGET_DATABASE_FSYNC	(InvalidBlockNumber-1)
@@ -178,6 +180,27 @@ static CycleCtr mdckpt_cycle_ctr = 0;
  */
 #define EXTENSION_DONT_CHECK_SIZE	(1 << 4)
 
+/*
+ * Once a segment has grown to MD_PREALLOC_BLOCKS blocks, mdextend reserves
+ * filesystem space for it this many blocks at a time, so that bulk loads
+ * have the filesystem allocate large extents instead of one block per write.
+ * Smaller relations, which are the large majority, are not affected.
+ */
+#define MD_PREALLOC_BLOCKS		128
+
+/* flags for opening relation segment files */
+#define MD_OPEN_FLAGS \
+	(O_RDWR | PG_BINARY | \
+	 ((io_direct_flags & IO_DIRECT_DATA) ? PG_O_DIRECT : 0))
+
+/*
+ * With io_direct = data, the buffers we read into and write from must be
+ * aligned to PG_IO_ALIGN_SIZE.  Shared buffers always are, but local buffers
+ * and pages built in private memory (e.g. by index builds) need not be; I/O
+ * on those goes through this bounce buffer, allocated on first use.
+ */
+static char *md_bounce_buffer = NULL;
+
 
 /* local routines */
 static void mdunlinkfork(RelFileNodeBackend rnode, ForkNumber forkNum,
@@ -186,6 +209,7 @@ static MdfdVec *mdopen(SMgrRelation reln, ForkNumber forknum, int behavior);
 static void register_dirty_segment(SMgrRelation reln, ForkNumber forknum,
 					   MdfdVec *seg);
 static void register_unlink(RelFileNodeBackend rnode);
+static void mdsync_start_writeback(void);
 static void _fdvec_resize(SMgrRelation reln,
 			  ForkNumber forknum,
 			  int nseg);
@@ -197,6 +221,8 @@ static MdfdVec *_mdfd_getseg(SMgrRelation reln, ForkNumber forkno,
 			 BlockNumber blkno, bool skipFsync, int behavior);
 static BlockNumber _mdnblocks(SMgrRelation reln, ForkNumber forknum,
 		   MdfdVec *seg);
+static char *_mdio_buffer(char *buffer);
+static int	_mdfd_sync(MdfdVec *seg, uint32 wait_event_info);
 
 
 /*
@@ -304,7 +330,7 @@ mdcreate(SMgrRelation reln, ForkNumber forkNum, bool isRedo)
 
 	path = relpath(reln->smgr_rnode, forkNum);
 
-	fd = PathNameOpenFile(path, O_RDWR | O_CREAT | O_EXCL | PG_BINARY);
+	fd = PathNameOpenFile(path, MD_OPEN_FLAGS | O_CREAT | O_EXCL);
 
 	if (fd < 0)
 	{
@@ -317,7 +343,7 @@ mdcreate(SMgrRelation reln, ForkNumber forkNum, bool isRedo)
 		 * already, even if isRedo is not set.  (See also mdopen)
 		 */
 		if (isRedo || IsBootstrapProcessingMode())
-			fd = PathNameOpenFile(path, O_RDWR | PG_BINARY);
+			fd = PathNameOpenFile(path, MD_OPEN_FLAGS);
 		if (fd < 0)
 		{
 			/* be sure to report the error reported by create, not open */
@@ -498,6 +524,8 @@ mdextend(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 	off_t		seekpos;
 	int			nbytes;
 	MdfdVec    *v;
+	char	   *iobuf;
+	BlockNumber segblock;
 
 	/* This assert is too expensive to have on normally ... */
 #ifdef CHECK_WRITE_VS_EXTEND
@@ -522,7 +550,11 @@ mdextend(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 
 	Assert(seekpos < (off_t) BLCKSZ * RELSEG_SIZE);
 
-	if ((nbytes = FileWrite(v->mdfd_vfd, buffer, BLCKSZ, seekpos, WAIT_EVENT_DATA_FILE_EXTEND)) != BLCKSZ)
+	iobuf = _mdio_buffer(buffer);
+	if (iobuf != buffer)
+		memcpy(iobuf, buffer, BLCKSZ);
+
+	if ((nbytes = FileWrite(v->mdfd_vfd, iobuf, BLCKSZ, seekpos, WAIT_EVENT_DATA_FILE_EXTEND)) != BLCKSZ)
 	{
 		if (nbytes < 0)
 			ereport(ERROR,
@@ -539,6 +571,25 @@ mdextend(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 				 errhint("Check free disk space.")));
 	}
 
+	/*
+	 * If we just wrote the first block of a preallocation chunk, reserve
+	 * space for the chunk following it.  Doing it one chunk ahead means that
+	 * the reservation for the blocks we're about to write is normally in
+	 * place already.
+	 */
+	segblock = blocknum % ((BlockNumber) RELSEG_SIZE);
+	if (segblock >= MD_PREALLOC_BLOCKS && segblock % MD_PREALLOC_BLOCKS == 0)
+	{
+		BlockNumber startblock = segblock + MD_PREALLOC_BLOCKS;
+		BlockNumber endblock = Min(startblock + MD_PREALLOC_BLOCKS,
+								   (BlockNumber) RELSEG_SIZE);
+
+		if (startblock < endblock)
+			FileFallocate(v->mdfd_vfd, (off_t) BLCKSZ * startblock,
+						  (off_t) BLCKSZ * (endblock - startblock),
+						  WAIT_EVENT_DATA_FILE_EXTEND);
+	}
+
 	if (!skipFsync && !SmgrIsTemp(reln))
 		register_dirty_segment(reln, forknum, v);
 
@@ -568,7 +619,7 @@ mdopen(SMgrRelation reln, ForkNumber forknum, int behavior)
 
 	path = relpath(reln->smgr_rnode, forknum);
 
-	fd = PathNameOpenFile(path, O_RDWR | PG_BINARY);
+	fd = PathNameOpenFile(path, MD_OPEN_FLAGS);
 
 	if (fd < 0)
 	{
@@ -579,7 +630,7 @@ mdopen(SMgrRelation reln, ForkNumber forknum, int behavior)
 		 * substitute for mdcreate() in bootstrap mode only. (See mdcreate)
 		 */
 		if (IsBootstrapProcessingMode())
-			fd = PathNameOpenFile(path, O_RDWR | O_CREAT | O_EXCL | PG_BINARY);
+			fd = PathNameOpenFile(path, MD_OPEN_FLAGS | O_CREAT | O_EXCL);
 		if (fd < 0)
 		{
 			if ((behavior & EXTENSION_RETURN_NULL) &&
@@ -638,22 +689,58 @@ mdclose(SMgrRelation reln, ForkNumber forknum)
 }
 
 /*
- *	mdprefetch() -- Initiate asynchronous read of the specified block of a relation
+ *	mdprefetch() -- Initiate asynchronous read of the specified blocks of a relation
+ *
+ * As in mdwriteback(), the range is split only at segment boundaries, so a
+ * run of consecutive blocks costs one hint per segment file rather than one
+ * per block.
  */
 void
-mdprefetch(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum)
+mdprefetch(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
+		   BlockNumber nblocks)
 {
 #ifdef USE_PREFETCH
-	off_t		seekpos;
-	MdfdVec    *v;
+	/* Prefetching into the kernel cache is pointless with direct I/O */
+	if (io_direct_flags & IO_DIRECT_DATA)
+		return;
 
-	v = _mdfd_getseg(reln, forknum, blocknum, false, EXTENSION_FAIL);
+	while (nblocks > 0)
+	{
+		BlockNumber nfetch = nblocks;
+		off_t		seekpos;
+		MdfdVec    *v;
+		int			segnum_start,
+					segnum_end;
 
-	seekpos = (off_t) BLCKSZ * (blocknum % ((BlockNumber) RELSEG_SIZE));
+		/*
+		 * A prefetch is only a hint, so a missing segment is not an error:
+		 * WAL replay may ask for blocks of a relation that is created or
+		 * extended by records it hasn't replayed yet.
+		 */
+		v = _mdfd_getseg(reln, forknum, blocknum, false,
+						 EXTENSION_RETURN_NULL);
+		if (!v)
+			return;
 
-	Assert(seekpos < (off_t) BLCKSZ * RELSEG_SIZE);
+		/* compute number of desired reads within the current segment */
+		segnum_start = blocknum / RELSEG_SIZE;
+		segnum_end = (blocknum + nblocks - 1) / RELSEG_SIZE;
+		if (segnum_start != segnum_end)
+			nfetch = RELSEG_SIZE - (blocknum % ((BlockNumber) RELSEG_SIZE));
+
+		Assert(nfetch >= 1);
+		Assert(nfetch <= nblocks);
 
-	(void) FilePrefetch(v->mdfd_vfd, seekpos, BLCKSZ, WAIT_EVENT_DATA_FILE_PREFETCH);
+		seekpos = (off_t) BLCKSZ * (blocknum % ((BlockNumber) RELSEG_SIZE));
+
+		Assert(seekpos < (off_t) BLCKSZ * RELSEG_SIZE);
+
+		(void) FilePrefetch(v->mdfd_vfd, seekpos, BLCKSZ * nfetch,
+							WAIT_EVENT_DATA_FILE_PREFETCH);
+
+		nblocks -= nfetch;
+		blocknum += nfetch;
+	}
 #endif							/* USE_PREFETCH */
 }
 
@@ -667,6 +754,10 @@ void
 mdwriteback(SMgrRelation reln, ForkNumber forknum,
 			BlockNumber blocknum, BlockNumber nblocks)
 {
+	/* With direct I/O there is nothing in the kernel cache to flush */
+	if (io_direct_flags & IO_DIRECT_DATA)
+		return;
+
 	/*
 	 * Issue flush requests in as few requests as possible; have to split at
 	 * segment boundaries though, since those are actually separate files.
@@ -719,6 +810,7 @@ mdread(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 	off_t		seekpos;
 	int			nbytes;
 	MdfdVec    *v;
+	char	   *iobuf;
 
 	TRACE_POSTGRESQL_SMGR_MD_READ_START(forknum, blocknum,
 										reln->smgr_rnode.node.spcNode,
@@ -733,7 +825,10 @@ mdread(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 
 	Assert(seekpos < (off_t) BLCKSZ * RELSEG_SIZE);
 
-	nbytes = FileRead(v->mdfd_vfd, buffer, BLCKSZ, seekpos, WAIT_EVENT_DATA_FILE_READ);
+	iobuf = _mdio_buffer(buffer);
+	nbytes = FileRead(v->mdfd_vfd, iobuf, BLCKSZ, seekpos, WAIT_EVENT_DATA_FILE_READ);
+	if (iobuf != buffer && nbytes > 0)
+		memcpy(buffer, iobuf, nbytes);
 
 	TRACE_POSTGRESQL_SMGR_MD_READ_DONE(forknum, blocknum,
 									   reln->smgr_rnode.node.spcNode,
@@ -784,6 +879,7 @@ mdwrite(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 	off_t		seekpos;
 	int			nbytes;
 	MdfdVec    *v;
+	char	   *iobuf;
 
 	/* This assert is too expensive to have on normally ... */
 #ifdef CHECK_WRITE_VS_EXTEND
@@ -803,7 +899,11 @@ mdwrite(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 
 	Assert(seekpos < (off_t) BLCKSZ * RELSEG_SIZE);
 
-	nbytes = FileWrite(v->mdfd_vfd, buffer, BLCKSZ, seekpos, WAIT_EVENT_DATA_FILE_WRITE);
+	iobuf = _mdio_buffer(buffer);
+	if (iobuf != buffer)
+		memcpy(iobuf, buffer, BLCKSZ);
+
+	nbytes = FileWrite(v->mdfd_vfd, iobuf, BLCKSZ, seekpos, WAIT_EVENT_DATA_FILE_WRITE);
 
 	TRACE_POSTGRESQL_SMGR_MD_WRITE_DONE(forknum, blocknum,
 										reln->smgr_rnode.node.spcNode,
@@ -1011,7 +1111,7 @@ mdimmedsync(SMgrRelation reln, ForkNumber forknum)
 	{
 		MdfdVec    *v = &reln->md_seg_fds[forknum][segno - 1];
 
-		if (FileSync(v->mdfd_vfd, WAIT_EVENT_DATA_FILE_IMMEDIATE_SYNC) < 0)
+		if (_mdfd_sync(v, WAIT_EVENT_DATA_FILE_IMMEDIATE_SYNC) < 0)
 			ereport(data_sync_elevel(ERROR),
 					(errcode_for_file_access(),
 					 errmsg("could not fsync file \"%s\": %m",
@@ -1020,6 +1120,29 @@ mdimmedsync(SMgrRelation reln, ForkNumber forknum)
 	}
 }
 
+/*
+ *	mdsyncblock() -- Immediately sync the segment holding a block.
+ *
+ * Like mdimmedsync, but only the one segment file is synced.  The relation
+ * may have been removed or truncated in the meantime, which is OK.
+ */
+void
+mdsyncblock(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum)
+{
+	MdfdVec    *v;
+
+	v = _mdfd_getseg(reln, forknum, blocknum, true /* not used */ ,
+					 EXTENSION_RETURN_NULL);
+	if (!v)
+		return;
+
+	if (_mdfd_sync(v, WAIT_EVENT_DATA_FILE_IMMEDIATE_SYNC) < 0)
+		ereport(data_sync_elevel(ERROR),
+				(errcode_for_file_access(),
+				 errmsg("could not fsync file \"%s\": %m",
+						FilePathName(v->mdfd_vfd))));
+}
+
 /*
  *	mdsync() -- Sync previous writes to stable storage.
  */
@@ -1099,6 +1222,15 @@ mdsync(void)
 	/* Set flag to detect failure if we don't reach the end of the loop */
 	mdsync_in_progress = true;
 
+	/*
+	 * fsync'ing the segments one at a time leaves the storage with only one
+	 * file's worth of writes to work on at any moment, so first ask the
+	 * kernel to start writing back all of them.  Most of the fsyncs below
+	 * then only have to wait for writes already in flight.
+	 */
+	if (enableFsync)
+		mdsync_start_writeback();
+
 	/* Now scan the hashtable for fsync requests to process */
 	absorb_counter = FSYNCS_PER_ABSORB;
 	hash_seq_init(&hstat, pendingOpsTable);
@@ -1205,7 +1337,7 @@ mdsync(void)
 					INSTR_TIME_SET_CURRENT(sync_start);
 
 					if (seg != NULL &&
-						FileSync(seg->mdfd_vfd, WAIT_EVENT_DATA_FILE_SYNC) >= 0)
+						_mdfd_sync(seg, WAIT_EVENT_DATA_FILE_SYNC) >= 0)
 					{
 						/* Success; update statistics about sync timing */
 						INSTR_TIME_SET_CURRENT(sync_end);
@@ -1314,6 +1446,56 @@ mdsync(void)
 	mdsync_in_progress = false;
 }
 
+/*
+ * mdsync_start_writeback() -- Initiate writeback of segments to be synced.
+ *
+ * This only covers the entries mdsync() is about to process.  Segments that
+ * no longer exist are silently skipped; mdsync() deals with them.
+ */
+static void
+mdsync_start_writeback(void)
+{
+	HASH_SEQ_STATUS hstat;
+	PendingOperationEntry *entry;
+
+	hash_seq_init(&hstat, pendingOpsTable);
+	while ((entry = (PendingOperationEntry *) hash_seq_search(&hstat)) != NULL)
+	{
+		SMgrRelation reln;
+		ForkNumber	forknum;
+
+		if (entry->cycle_ctr == mdsync_cycle_ctr)
+			continue;
+
+		reln = smgropen(entry->rnode, InvalidBackendId);
+
+		for (forknum = 0; forknum <= MAX_FORKNUM; forknum++)
+		{
+			int			segno = -1;
+
+			while ((segno = bms_next_member(entry->requests[forknum],
+											segno)) >= 0)
+			{
+				MdfdVec    *seg;
+				off_t		size;
+
+				seg = _mdfd_getseg(reln, forknum,
+								   (BlockNumber) segno * (BlockNumber) RELSEG_SIZE,
+								   false,
+								   EXTENSION_RETURN_NULL
+								   | EXTENSION_DONT_CHECK_SIZE);
+				if (seg == NULL)
+					continue;
+
+				size = FileSize(seg->mdfd_vfd);
+				if (size > 0)
+					FileWriteback(seg->mdfd_vfd, 0, size,
+								  WAIT_EVENT_DATA_FILE_FLUSH);
+			}
+		}
+	}
+}
+
 /*
  * mdpreckpt() -- Do pre-checkpoint work
  *
@@ -1430,7 +1612,7 @@ register_dirty_segment(SMgrRelation reln, ForkNumber forknum, MdfdVec *seg)
 		ereport(DEBUG1,
 				(errmsg("could not forward fsync request because request queue is full")));
 
-		if (FileSync(seg->mdfd_vfd, WAIT_EVENT_DATA_FILE_SYNC) < 0)
+		if (_mdfd_sync(seg, WAIT_EVENT_DATA_FILE_SYNC) < 0)
 			ereport(data_sync_elevel(ERROR),
 					(errcode_for_file_access(),
 					 errmsg("could not fsync file \"%s\": %m",
@@ -1803,7 +1985,7 @@ _mdfd_openseg(SMgrRelation reln, ForkNumber forknum, BlockNumber segno,
 	fullpath = _mdfd_segpath(reln, forknum, segno);
 
 	/* open the file */
-	fd = PathNameOpenFile(fullpath, O_RDWR | PG_BINARY | oflags);
+	fd = PathNameOpenFile(fullpath, MD_OPEN_FLAGS | oflags);
 
 	pfree(fullpath);
 
@@ -1974,3 +2156,54 @@ _mdnblocks(SMgrRelation reln, ForkNumber forknum, MdfdVec *seg)
 	/* note that this calculation will ignore any partial block at EOF */
 	return (BlockNumber) (len / BLCKSZ);
 }
+
+/*
+ * Return a buffer suitable for reading or writing a block that the caller
+ * wants to have in 'buffer': 'buffer' itself, or the bounce buffer if direct
+ * I/O is in use for data files and 'buffer' is not suitably aligned.  In the
+ * latter case the caller must copy the data in or out.
+ */
+static char *
+_mdio_buffer(char *buffer)
+{
+	if (!(io_direct_flags & IO_DIRECT_DATA) ||
+		(uintptr_t) buffer % PG_IO_ALIGN_SIZE == 0)
+		return buffer;
+
+	if (md_bounce_buffer == NULL)
+		md_bounce_buffer = (char *)
+			TYPEALIGN(PG_IO_ALIGN_SIZE,
+					  MemoryContextAlloc(TopMemoryContext,
+										 BLCKSZ + PG_IO_ALIGN_SIZE));
+
+	return md_bounce_buffer;
+}
+
+/*
+ * fsync a single segment file, counting it in pg_stat_io if successful
+ */
+static int
+_mdfd_sync(MdfdVec *seg, uint32 wait_event_info)
+{
+	instr_time	io_start,
+				io_time;
+	int			ret;
+
+	INSTR_TIME_SET_ZERO(io_time);
+	if (track_io_timing)
+		INSTR_TIME_SET_CURRENT(io_start);
+
+	ret = FileSync(seg->mdfd_vfd, wait_event_info);
+	if (ret < 0)
+		return ret;
+
+	if (track_io_timing)
+	{
+		INSTR_TIME_SET_CURRENT(io_time);
+		INSTR_TIME_SUBTRACT(io_time, io_start);
+	}
+	pgstat_count_io_op_time(IOOBJECT_RELATION, IOCONTEXT_NORMAL, IOOP_FSYNC,
+							io_time);
+
+	return ret;
+}
@@ -0,0 +1,362 @@
+/*-------------------------------------------------------------------------
+ *
+ * relsizecache.c
+ *	  Shared cache of relation fork sizes
+ *
+ * Finding out the size of a relation fork with mdnblocks() costs an lseek()
+ * on each of its segments, which happens every time a query is planned or a
+ * sequential scan starts.  On a busy system, those system calls and the
+ * contention on the kernel's inode locks they cause are significant, so we
+ * remember recently used sizes here, and smgrnblocks() answers from memory
+ * when it can.  Temporary relations are not cached.
+ *
+ * The cache is a set-associative array of smgr_shared_relations entries:
+ * a relation's RelFileNode hashes to one set of RSC_WAYS entries, protected
+ * by one LWLock, and the least recently used entry of the set is replaced
+ * when a new relation is added.  Since all the sizes are also known by the
+ * kernel, any entry can be evicted at any time.
+ *
+ * smgr reports every extension and truncation after performing it.  A size
+ * obtained from the kernel might be outdated by the time it is entered into
+ * the cache, if the relation is extended or truncated meanwhile.  To detect
+ * that, each set has a generation counter that is advanced every time a
+ * size in it changes; a size is only entered if the set's generation is
+ * still what it was when the lookup missed.
+ *
+ * Files are removed or copied in bulk by DROP DATABASE, CREATE DATABASE and
+ * ALTER DATABASE SET TABLESPACE without going through smgr; those must call
+ * RelSizeCacheForgetDatabase().
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/storage/smgr/relsizecache.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "port/atomics.h"
+#include "storage/lwlock.h"
+#include "storage/relsizecache.h"
+#include "storage/shmem.h"
+#include "utils/hashutils.h"
+
+
+/* Number of entries in each set */
+#define RSC_WAYS		8
+
+typedef struct RelSizeCacheEntry
+{
+	RelFileNode rnode;			/* identity of the relation */
+	bool		inuse;			/* is this entry valid? */
+	pg_atomic_uint32 usage;		/* recently used? */
+	BlockNumber nblocks[MAX_FORKNUM + 1];	/* size, or InvalidBlockNumber */
+} RelSizeCacheEntry;
+
+typedef struct RelSizeCacheSet
+{
+	LWLock		lock;			/* protects all fields of the set */
+	uint64		generation;		/* advanced whenever a size changes */
+	int			next_victim;	/* clock hand for replacement */
+	RelSizeCacheEntry entries[RSC_WAYS];
+} RelSizeCacheSet;
+
+int			smgr_shared_relations = 4096;
+
+static RelSizeCacheSet *RelSizeCache = NULL;
+static int	RelSizeCacheNumSets = 0;
+
+static RelSizeCacheSet *RelSizeCacheSetFor(RelFileNode *rnode);
+static RelSizeCacheEntry *RelSizeCacheFind(RelSizeCacheSet *set,
+				 RelFileNode *rnode);
+static void RelSizeCacheUpdate(RelFileNode rnode, ForkNumber forknum,
+				   BlockNumber nblocks, bool extend);
+
+
+/*
+ * Number of sets needed for smgr_shared_relations entries
+ */
+static int
+RelSizeCacheSets(void)
+{
+	return (smgr_shared_relations + RSC_WAYS - 1) / RSC_WAYS;
+}
+
+/*
+ * Report shared memory space needed by RelSizeCacheShmemInit
+ */
+Size
+RelSizeCacheShmemSize(void)
+{
+	return mul_size(RelSizeCacheSets(), sizeof(RelSizeCacheSet));
+}
+
+/*
+ * Allocate and initialize the cache
+ */
+void
+RelSizeCacheShmemInit(void)
+{
+	bool		found;
+	int			i;
+
+	RelSizeCacheNumSets = RelSizeCacheSets();
+	if (RelSizeCacheNumSets == 0)
+		return;
+
+	RelSizeCache = (RelSizeCacheSet *)
+		ShmemInitStruct("Relation Size Cache", RelSizeCacheShmemSize(),
+						&found);
+
+	if (!found)
+	{
+		for (i = 0; i < RelSizeCacheNumSets; i++)
+		{
+			RelSizeCacheSet *set = &RelSizeCache[i];
+			int			j;
+
+			LWLockInitialize(&set->lock, LWTRANCHE_RELSIZE_CACHE);
+			set->generation = 0;
+			set->next_victim = 0;
+			for (j = 0; j < RSC_WAYS; j++)
+			{
+				set->entries[j].inuse = false;
+				pg_atomic_init_u32(&set->entries[j].usage, 0);
+			}
+		}
+	}
+}
+
+/*
+ * Look up the cached size of a relation fork.
+ *
+ * Returns InvalidBlockNumber if it's not cached.  In that case, the caller
+ * may find out the size from the kernel and pass it to RelSizeCacheFill(),
+ * together with the *generation we return.
+ */
+BlockNumber
+RelSizeCacheLookup(RelFileNode rnode, ForkNumber forknum, uint64 *generation)
+{
+	RelSizeCacheSet *set;
+	RelSizeCacheEntry *entry;
+	BlockNumber result = InvalidBlockNumber;
+
+	if (RelSizeCache == NULL)
+	{
+		*generation = 0;
+		return InvalidBlockNumber;
+	}
+
+	set = RelSizeCacheSetFor(&rnode);
+
+	LWLockAcquire(&set->lock, LW_SHARED);
+	entry = RelSizeCacheFind(set, &rnode);
+	if (entry != NULL)
+	{
+		result = entry->nblocks[forknum];
+
+		/* avoid dirtying the cache line if the flag is set already */
+		if (pg_atomic_read_u32(&entry->usage) == 0)
+			pg_atomic_write_u32(&entry->usage, 1);
+	}
+	*generation = set->generation;
+	LWLockRelease(&set->lock);
+
+	return result;
+}
+
+/*
+ * Enter the size of a relation fork, as found out from the kernel after
+ * RelSizeCacheLookup() returned the given generation.
+ *
+ * Nothing happens if the sizes in the set may have changed since then.
+ */
+void
+RelSizeCacheFill(RelFileNode rnode, ForkNumber forknum, BlockNumber nblocks,
+				 uint64 generation)
+{
+	RelSizeCacheSet *set;
+	RelSizeCacheEntry *entry;
+
+	if (RelSizeCache == NULL)
+		return;
+
+	set = RelSizeCacheSetFor(&rnode);
+
+	LWLockAcquire(&set->lock, LW_EXCLUSIVE);
+	if (set->generation != generation)
+	{
+		LWLockRelease(&set->lock);
+		return;
+	}
+
+	entry = RelSizeCacheFind(set, &rnode);
+	if (entry == NULL)
+	{
+		ForkNumber	fork;
+
+		/* run the clock hand until we find an entry not used recently */
+		for (;;)
+		{
+			entry = &set->entries[set->next_victim];
+			set->next_victim = (set->next_victim + 1) % RSC_WAYS;
+
+			if (!entry->inuse || pg_atomic_read_u32(&entry->usage) == 0)
+				break;
+			pg_atomic_write_u32(&entry->usage, 0);
+		}
+
+		entry->rnode = rnode;
+		entry->inuse = true;
+		for (fork = 0; fork <= MAX_FORKNUM; fork++)
+			entry->nblocks[fork] = InvalidBlockNumber;
+	}
+
+	entry->nblocks[forknum] = nblocks;
+	pg_atomic_write_u32(&entry->usage, 1);
+	LWLockRelease(&set->lock);
+}
+
+/*
+ * Report that a relation fork has been extended to at least nblocks blocks.
+ */
+void
+RelSizeCacheExtended(RelFileNode rnode, ForkNumber forknum, BlockNumber nblocks)
+{
+	RelSizeCacheUpdate(rnode, forknum, nblocks, true);
+}
+
+/*
+ * Report that a relation fork has been truncated to nblocks blocks.
+ */
+void
+RelSizeCacheTruncated(RelFileNode rnode, ForkNumber forknum,
+					  BlockNumber nblocks)
+{
+	RelSizeCacheUpdate(rnode, forknum, nblocks, false);
+}
+
+/*
+ * Report that a relation fork, or all of its forks if forknum is
+ * InvalidForkNumber, has been created or removed, and so has an unknown
+ * size.
+ */
+void
+RelSizeCacheForget(RelFileNode rnode, ForkNumber forknum)
+{
+	ForkNumber	fork;
+
+	if (forknum != InvalidForkNumber)
+	{
+		RelSizeCacheUpdate(rnode, forknum, InvalidBlockNumber, false);
+		return;
+	}
+
+	for (fork = 0; fork <= MAX_FORKNUM; fork++)
+		RelSizeCacheUpdate(rnode, fork, InvalidBlockNumber, false);
+}
+
+/*
+ * Remove all the entries of the given database.
+ *
+ * This visits every set, so it's only suitable for rare events.
+ */
+void
+RelSizeCacheForgetDatabase(Oid dbid)
+{
+	int			i;
+
+	if (RelSizeCache == NULL)
+		return;
+
+	for (i = 0; i < RelSizeCacheNumSets; i++)
+	{
+		RelSizeCacheSet *set = &RelSizeCache[i];
+		int			j;
+
+		LWLockAcquire(&set->lock, LW_EXCLUSIVE);
+		set->generation++;
+		for (j = 0; j < RSC_WAYS; j++)
+		{
+			if (set->entries[j].inuse && set->entries[j].rnode.dbNode == dbid)
+				set->entries[j].inuse = false;
+		}
+		LWLockRelease(&set->lock);
+	}
+}
+
+/*
+ * Common code of RelSizeCacheExtended, RelSizeCacheTruncated and
+ * RelSizeCacheForget.
+ *
+ * The set's generation is advanced even if the relation is not cached, so
+ * that a concurrent RelSizeCacheFill() cannot enter a size obtained before
+ * the change.
+ */
+static void
+RelSizeCacheUpdate(RelFileNode rnode, ForkNumber forknum, BlockNumber nblocks,
+				   bool extend)
+{
+	RelSizeCacheSet *set;
+	RelSizeCacheEntry *entry;
+
+	if (RelSizeCache == NULL)
+		return;
+
+	set = RelSizeCacheSetFor(&rnode);
+
+	LWLockAcquire(&set->lock, LW_EXCLUSIVE);
+	set->generation++;
+	entry = RelSizeCacheFind(set, &rnode);
+	if (entry != NULL)
+	{
+		/*
+		 * An extension can't make the fork shorter, and tells us nothing if
+		 * we didn't know the size before.
+		 */
+		if (!extend)
+			entry->nblocks[forknum] = nblocks;
+		else if (entry->nblocks[forknum] != InvalidBlockNumber &&
+				 entry->nblocks[forknum] < nblocks)
+			entry->nblocks[forknum] = nblocks;
+	}
+	LWLockRelease(&set->lock);
+}
+
+/*
+ * Map a relation to its set
+ */
+static RelSizeCacheSet *
+RelSizeCacheSetFor(RelFileNode *rnode)
+{
+	uint32		hash;
+
+	hash = hash_combine(murmurhash32(rnode->relNode),
+						hash_combine(murmurhash32(rnode->dbNode),
+									 murmurhash32(rnode->spcNode)));
+
+	return &RelSizeCache[hash % RelSizeCacheNumSets];
+}
+
+/*
+ * Find a relation's entry in its set, or NULL.  Caller must hold the set's
+ * lock.
+ */
+static RelSizeCacheEntry *
+RelSizeCacheFind(RelSizeCacheSet *set, RelFileNode *rnode)
+{
+	int			i;
+
+	for (i = 0; i < RSC_WAYS; i++)
+	{
+		RelSizeCacheEntry *entry = &set->entries[i];
+
+		if (entry->inuse && RelFileNodeEquals(entry->rnode, *rnode))
+			return entry;
+	}
+
+	return NULL;
+}
@@ -17,9 +17,11 @@
  */
 #include "postgres.h"
 
+#include "access/xlog.h"
 #include "commands/tablespace.h"
 #include "storage/bufmgr.h"
 #include "storage/ipc.h"
+#include "storage/relsizecache.h"
 #include "storage/smgr.h"
 #include "utils/hsearch.h"
 #include "utils/inval.h"
@@ -48,7 +50,7 @@ typedef struct f_smgr
 	void		(*smgr_extend) (SMgrRelation reln, ForkNumber forknum,
 								BlockNumber blocknum, char *buffer, bool skipFsync);
 	void		(*smgr_prefetch) (SMgrRelation reln, ForkNumber forknum,
-								  BlockNumber blocknum);
+								  BlockNumber blocknum, BlockNumber nblocks);
 	void		(*smgr_read) (SMgrRelation reln, ForkNumber forknum,
 							  BlockNumber blocknum, char *buffer);
 	void		(*smgr_write) (SMgrRelation reln, ForkNumber forknum,
@@ -59,6 +61,8 @@ typedef struct f_smgr
 	void		(*smgr_truncate) (SMgrRelation reln, ForkNumber forknum,
 								  BlockNumber nblocks);
 	void		(*smgr_immedsync) (SMgrRelation reln, ForkNumber forknum);
+	void		(*smgr_syncblock) (SMgrRelation reln, ForkNumber forknum,
+								   BlockNumber blocknum);
 	void		(*smgr_pre_ckpt) (void);	/* may be NULL */
 	void		(*smgr_sync) (void);	/* may be NULL */
 	void		(*smgr_post_ckpt) (void);	/* may be NULL */
@@ -82,6 +86,7 @@ static const f_smgr smgrsw[] = {
 		.smgr_nblocks = mdnblocks,
 		.smgr_truncate = mdtruncate,
 		.smgr_immedsync = mdimmedsync,
+		.smgr_syncblock = mdsyncblock,
 		.smgr_pre_ckpt = mdpreckpt,
 		.smgr_sync = mdsync,
 		.smgr_post_ckpt = mdpostckpt
@@ -187,9 +192,12 @@ smgropen(RelFileNode rnode, BackendId backend)
 		reln->smgr_vm_nblocks = InvalidBlockNumber;
 		reln->smgr_which = 0;	/* we only have md.c at present */
 
-		/* mark it not open */
+		/* mark it not open, and of unknown size */
 		for (forknum = 0; forknum <= MAX_FORKNUM; forknum++)
+		{
 			reln->md_num_open_segs[forknum] = 0;
+			reln->smgr_cached_nblocks[forknum] = InvalidBlockNumber;
+		}
 
 		/* it has no owner yet */
 		add_to_unowned_list(reln);
@@ -411,6 +419,9 @@ smgrcreate(SMgrRelation reln, ForkNumber forknum, bool isRedo)
 							isRedo);
 
 	smgrsw[reln->smgr_which].smgr_create(reln, forknum, isRedo);
+
+	if (!SmgrIsTemp(reln))
+		RelSizeCacheForget(reln->smgr_rnode.node, forknum);
 }
 
 /*
@@ -432,15 +443,20 @@ smgrdounlink(SMgrRelation reln, bool isRedo)
 	int			which = reln->smgr_which;
 	ForkNumber	forknum;
 
-	/* Close the forks at smgr level */
-	for (forknum = 0; forknum <= MAX_FORKNUM; forknum++)
-		smgrsw[which].smgr_close(reln, forknum);
-
 	/*
 	 * Get rid of any remaining buffers for the relation.  bufmgr will just
-	 * drop them without bothering to write the contents.
+	 * drop them without bothering to write the contents.  This is done
+	 * before closing the forks, as bufmgr may need to check which of them
+	 * exist.
 	 */
-	DropRelFileNodesAllBuffers(&rnode, 1);
+	DropRelFileNodesAllBuffers(&reln, 1);
+
+	/* Close the forks at smgr level */
+	for (forknum = 0; forknum <= MAX_FORKNUM; forknum++)
+	{
+		smgrsw[which].smgr_close(reln, forknum);
+		reln->smgr_cached_nblocks[forknum] = InvalidBlockNumber;
+	}
 
 	/*
 	 * It'd be nice to tell the stats collector to forget it immediately, too.
@@ -467,6 +483,9 @@ smgrdounlink(SMgrRelation reln, bool isRedo)
 	 * xact.
 	 */
 	smgrsw[which].smgr_unlink(rnode, InvalidForkNumber, isRedo);
+
+	if (!RelFileNodeBackendIsTemp(rnode))
+		RelSizeCacheForget(rnode.node, InvalidForkNumber);
 }
 
 /*
@@ -492,6 +511,14 @@ smgrdounlinkall(SMgrRelation *rels, int nrels, bool isRedo)
 	if (nrels == 0)
 		return;
 
+	/*
+	 * Get rid of any remaining buffers for the relations.  bufmgr will just
+	 * drop them without bothering to write the contents.  This is done
+	 * before closing the forks, as bufmgr may need to check which of them
+	 * exist.
+	 */
+	DropRelFileNodesAllBuffers(rels, nrels);
+
 	/*
 	 * create an array which contains all relations to be dropped, and close
 	 * each relation's forks at the smgr level while at it
@@ -506,15 +533,12 @@ smgrdounlinkall(SMgrRelation *rels, int nrels, bool isRedo)
 
 		/* Close the forks at smgr level */
 		for (forknum = 0; forknum <= MAX_FORKNUM; forknum++)
+		{
 			smgrsw[which].smgr_close(rels[i], forknum);
+			rels[i]->smgr_cached_nblocks[forknum] = InvalidBlockNumber;
+		}
 	}
 
-	/*
-	 * Get rid of any remaining buffers for the relations.  bufmgr will just
-	 * drop them without bothering to write the contents.
-	 */
-	DropRelFileNodesAllBuffers(rnodes, nrels);
-
 	/*
 	 * It'd be nice to tell the stats collector to forget them immediately,
 	 * too. But we can't because we don't know the OIDs.
@@ -545,6 +569,9 @@ smgrdounlinkall(SMgrRelation *rels, int nrels, bool isRedo)
 
 		for (forknum = 0; forknum <= MAX_FORKNUM; forknum++)
 			smgrsw[which].smgr_unlink(rnodes[i], forknum, isRedo);
+
+		if (!RelFileNodeBackendIsTemp(rnodes[i]))
+			RelSizeCacheForget(rnodes[i].node, InvalidForkNumber);
 	}
 
 	pfree(rnodes);
@@ -566,14 +593,15 @@ smgrdounlinkfork(SMgrRelation reln, ForkNumber forknum, bool isRedo)
 	RelFileNodeBackend rnode = reln->smgr_rnode;
 	int			which = reln->smgr_which;
 
-	/* Close the fork at smgr level */
-	smgrsw[which].smgr_close(reln, forknum);
-
 	/*
 	 * Get rid of any remaining buffers for the fork.  bufmgr will just drop
 	 * them without bothering to write the contents.
 	 */
-	DropRelFileNodeBuffers(rnode, forknum, 0);
+	DropRelFileNodeBuffers(reln, forknum, 0);
+
+	/* Close the fork at smgr level */
+	smgrsw[which].smgr_close(reln, forknum);
+	reln->smgr_cached_nblocks[forknum] = InvalidBlockNumber;
 
 	/*
 	 * It'd be nice to tell the stats collector to forget it immediately, too.
@@ -600,6 +628,9 @@ smgrdounlinkfork(SMgrRelation reln, ForkNumber forknum, bool isRedo)
 	 * xact.
 	 */
 	smgrsw[which].smgr_unlink(rnode, forknum, isRedo);
+
+	if (!RelFileNodeBackendIsTemp(rnode))
+		RelSizeCacheForget(rnode.node, forknum);
 }
 
 /*
@@ -617,15 +648,34 @@ smgrextend(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 {
 	smgrsw[reln->smgr_which].smgr_extend(reln, forknum, blocknum,
 										 buffer, skipFsync);
+
+	if (!SmgrIsTemp(reln))
+		RelSizeCacheExtended(reln->smgr_rnode.node, forknum, blocknum + 1);
+
+	/*
+	 * Normally we expect this to increase nblocks by one, but if the cached
+	 * value isn't as expected, just invalidate it so the next call asks the
+	 * kernel.
+	 */
+	if (reln->smgr_cached_nblocks[forknum] == blocknum)
+		reln->smgr_cached_nblocks[forknum] = blocknum + 1;
+	else
+		reln->smgr_cached_nblocks[forknum] = InvalidBlockNumber;
 }
 
 /*
- *	smgrprefetch() -- Initiate asynchronous read of the specified block of a relation.
+ *	smgrprefetch() -- Initiate asynchronous read of the specified blocks of a
+ *					  relation.
+ *
+ *		nblocks consecutive blocks starting at blocknum are requested.  Passing
+ *		a range lets the storage manager issue fewer, larger hints than one
+ *		request per block would.
  */
 void
-smgrprefetch(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum)
+smgrprefetch(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
+			 BlockNumber nblocks)
 {
-	smgrsw[reln->smgr_which].smgr_prefetch(reln, forknum, blocknum);
+	smgrsw[reln->smgr_which].smgr_prefetch(reln, forknum, blocknum, nblocks);
 }
 
 /*
@@ -682,11 +732,52 @@ smgrwriteback(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 /*
  *	smgrnblocks() -- Calculate the number of blocks in the
  *					 supplied relation.
+ *
+ *		The shared relation size cache is consulted first, to save the
+ *		storage manager the trouble of asking the kernel.
  */
 BlockNumber
 smgrnblocks(SMgrRelation reln, ForkNumber forknum)
 {
-	return smgrsw[reln->smgr_which].smgr_nblocks(reln, forknum);
+	BlockNumber result;
+	uint64		generation = 0;
+
+	if (!SmgrIsTemp(reln))
+	{
+		result = RelSizeCacheLookup(reln->smgr_rnode.node, forknum,
+									&generation);
+		if (result != InvalidBlockNumber)
+		{
+			reln->smgr_cached_nblocks[forknum] = result;
+			return result;
+		}
+	}
+
+	result = smgrsw[reln->smgr_which].smgr_nblocks(reln, forknum);
+	reln->smgr_cached_nblocks[forknum] = result;
+
+	if (!SmgrIsTemp(reln))
+		RelSizeCacheFill(reln->smgr_rnode.node, forknum, result, generation);
+
+	return result;
+}
+
+/*
+ *	smgrnblocks_cached() -- Get the cached number of blocks in the supplied
+ *							relation.
+ *
+ *		Returns InvalidBlockNumber if the size is not known.  We only trust
+ *		the cached value during recovery, since the startup process is then
+ *		the only one that can extend or truncate relations, so that its
+ *		cache cannot have been made stale behind its back.
+ */
+BlockNumber
+smgrnblocks_cached(SMgrRelation reln, ForkNumber forknum)
+{
+	if (InRecovery)
+		return reln->smgr_cached_nblocks[forknum];
+
+	return InvalidBlockNumber;
 }
 
 /*
@@ -702,7 +793,7 @@ smgrtruncate(SMgrRelation reln, ForkNumber forknum, BlockNumber nblocks)
 	 * Get rid of any buffers for the about-to-be-deleted blocks. bufmgr will
 	 * just drop them without bothering to write the contents.
 	 */
-	DropRelFileNodeBuffers(reln->smgr_rnode, forknum, nblocks);
+	DropRelFileNodeBuffers(reln, forknum, nblocks);
 
 	/*
 	 * Send a shared-inval message to force other backends to close any smgr
@@ -720,6 +811,16 @@ smgrtruncate(SMgrRelation reln, ForkNumber forknum, BlockNumber nblocks)
 	 * Do the truncation.
 	 */
 	smgrsw[reln->smgr_which].smgr_truncate(reln, forknum, nblocks);
+
+	if (!SmgrIsTemp(reln))
+		RelSizeCacheTruncated(reln->smgr_rnode.node, forknum, nblocks);
+
+	/*
+	 * We might as well update the local smgr_cached_nblocks value.  The
+	 * smgr cache inval message that this function sent will cause other
+	 * backends to invalidate their copies.
+	 */
+	reln->smgr_cached_nblocks[forknum] = nblocks;
 }
 
 /*
@@ -751,6 +852,20 @@ smgrimmedsync(SMgrRelation reln, ForkNumber forknum)
 	smgrsw[reln->smgr_which].smgr_immedsync(reln, forknum);
 }
 
+/*
+ *	smgrsyncblock() -- Force the write of one block to stable storage.
+ *
+ *		This is a cheaper variant of smgrimmedsync, for callers that need a
+ *		particular block write to be durable before they can proceed; it may
+ *		sync other blocks of the relation along with it.  It's not an error
+ *		if the block no longer exists.
+ */
+void
+smgrsyncblock(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum)
+{
+	smgrsw[reln->smgr_which].smgr_syncblock(reln, forknum, blocknum);
+}
+
 
 /*
  *	smgrpreckpt() -- Prepare for checkpoint.
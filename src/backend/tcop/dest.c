@@ -39,6 +39,8 @@
 #include "executor/tstoreReceiver.h"
 #include "libpq/libpq.h"
 #include "libpq/pqformat.h"
+#include "miscadmin.h"
+#include "postmaster/proxy.h"
 #include "utils/portal.h"
 
 
@@ -258,8 +260,19 @@ ReadyForQuery(CommandDest dest)
 			{
 				StringInfoData buf;
 
+				char		status = TransactionBlockStatusCode();
+
 				pq_beginmessage(&buf, 'Z');
-				pq_sendbyte(&buf, TransactionBlockStatusCode());
+				pq_sendbyte(&buf, status);
+
+				/*
+				 * Tell the connection proxy whether this session can be
+				 * handed to another client.  The proxy removes this byte.
+				 */
+				if (MyProcPort && MyProcPort->proxied)
+					pq_sendbyte(&buf,
+								(status == 'I' && !ProxySessionHasState()) ?
+								'F' : 'P');
 				pq_endmessage(&buf);
 			}
 			else
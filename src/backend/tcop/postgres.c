@@ -36,6 +36,7 @@
 #include "rusagestub.h"
 #endif
 
+#include "access/hash.h"
 #include "access/parallel.h"
 #include "access/printtup.h"
 #include "access/xact.h"
@@ -44,6 +45,7 @@
 #include "commands/prepare.h"
 #include "executor/spi.h"
 #include "jit/jit.h"
+#include "lib/ilist.h"
 #include "libpq/libpq.h"
 #include "libpq/pqformat.h"
 #include "libpq/pqsignal.h"
@@ -53,8 +55,10 @@
 #include "pgstat.h"
 #include "pg_trace.h"
 #include "parser/analyze.h"
+#include "parser/parse_expr.h"
 #include "parser/parser.h"
 #include "pg_getopt.h"
+#include "portability/instr_time.h"
 #include "postmaster/autovacuum.h"
 #include "postmaster/postmaster.h"
 #include "replication/logicallauncher.h"
@@ -71,6 +75,7 @@
 #include "tcop/pquery.h"
 #include "tcop/tcopprot.h"
 #include "tcop/utility.h"
+#include "utils/hsearch.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/ps_status.h"
@@ -100,6 +105,9 @@ int			max_stack_depth = 100;
 /* wait N seconds to allow attach from a debugger */
 int			PostAuthDelay = 0;
 
+/* GUC variable: number of raw parse trees cached by exec_simple_query */
+int			parse_tree_cache_size = 0;
+
 
 
 /* ----------------
@@ -157,6 +165,26 @@ static bool stmt_timeout_active = false;
  */
 static CachedPlanSource *unnamed_stmt_psrc = NULL;
 
+/*
+ * Raw parse trees of recent simple-protocol query strings, if
+ * parse_tree_cache_size is set.  The hash table is keyed by a hash of the
+ * query string; a colliding string simply replaces the entry.  Each entry's
+ * query string and parse trees live in a memory context of its own.
+ */
+typedef struct ParseTreeCacheEntry
+{
+	uint32		hash;			/* hash key; must be first */
+	int			settings;		/* parser settings the trees were made with */
+	MemoryContext context;		/* holds query_string and parsetrees */
+	char	   *query_string;
+	List	   *parsetrees;		/* list of RawStmt */
+	dlist_node	lru_node;		/* in ParseTreeCacheLRU, most recent first */
+} ParseTreeCacheEntry;
+
+static HTAB *ParseTreeCache = NULL;
+static dlist_head ParseTreeCacheLRU = DLIST_STATIC_INIT(ParseTreeCacheLRU);
+static int	ParseTreeCacheCount = 0;
+
 /* assorted command-line switches */
 static const char *userDoption = NULL;	/* -D switch */
 static bool EchoQuery = false;	/* -E switch */
@@ -181,6 +209,11 @@ static int	SocketBackend(StringInfo inBuf);
 static int	ReadCommand(StringInfo inBuf);
 static void forbidden_in_wal_sender(char firstchar);
 static List *pg_rewrite_query(Query *query);
+static int	parse_tree_cache_settings(void);
+static List *parse_tree_cache_lookup(const char *query_string, uint32 *hash);
+static void parse_tree_cache_store(const char *query_string, uint32 hash,
+					   List *parsetree_list);
+static void parse_tree_cache_remove(ParseTreeCacheEntry *entry);
 static bool check_log_statement(List *stmt_list);
 static int	errdetail_execute(List *raw_parsetree_list);
 static int	errdetail_params(ParamListInfo params);
@@ -192,6 +225,7 @@ static bool IsTransactionExitStmt(Node *parsetree);
 static bool IsTransactionExitStmtList(List *pstmts);
 static bool IsTransactionStmtList(List *pstmts);
 static void drop_unnamed_stmt(void);
+static void record_plan_runtime(Portal portal, instr_time starttime);
 static void log_disconnections(int code, Datum arg);
 static void enable_statement_timeout(void);
 static void disable_statement_timeout(void);
@@ -431,6 +465,15 @@ SocketBackend(StringInfo inBuf)
 			ignore_till_sync = false;
 			break;
 
+		case 'a':				/* new client */
+			doing_extended_query_message = false;
+			/* only the connection proxy may send this */
+			if (!MyProcPort->proxied)
+				ereport(FATAL,
+						(errcode(ERRCODE_PROTOCOL_VIOLATION),
+						 errmsg("invalid frontend message type %d", qtype)));
+			break;
+
 		case 'B':				/* bind */
 		case 'C':				/* close */
 		case 'D':				/* describe */
@@ -667,6 +710,167 @@ pg_parse_query(const char *query_string)
 	return raw_parsetree_list;
 }
 
+/*
+ * Return a value identifying the settings that affect what the raw parser
+ * makes of a query string, or -1 if its output must not be cached.
+ *
+ * With standard_conforming_strings off, the lexer warns about backslashes
+ * in string literals, and those warnings would be lost for cached trees.
+ */
+static int
+parse_tree_cache_settings(void)
+{
+	if (parse_tree_cache_size <= 0 || !standard_conforming_strings)
+		return -1;
+
+	return (pg_get_client_encoding() << 3) |
+		(backslash_quote << 1) |
+		(operator_precedence_warning ? 1 : 0);
+}
+
+/*
+ * Look up the raw parse trees of a query string in the cache.
+ *
+ * On a hit, returns a copy of them in the current memory context.  On a
+ * miss, returns NIL and sets *hash for parse_tree_cache_store().
+ */
+static List *
+parse_tree_cache_lookup(const char *query_string, uint32 *hash)
+{
+	ParseTreeCacheEntry *entry;
+	int			settings;
+
+	*hash = 0;
+	settings = parse_tree_cache_settings();
+	if (settings < 0)
+	{
+		/* Release the entries if the cache was disabled */
+		while (parse_tree_cache_size <= 0 && ParseTreeCacheCount > 0)
+			parse_tree_cache_remove(dlist_tail_element(ParseTreeCacheEntry,
+													   lru_node,
+													   &ParseTreeCacheLRU));
+		return NIL;
+	}
+
+	*hash = DatumGetUInt32(hash_any((const unsigned char *) query_string,
+									strlen(query_string)));
+	if (ParseTreeCache == NULL)
+		return NIL;
+
+	entry = (ParseTreeCacheEntry *) hash_search(ParseTreeCache, hash,
+												HASH_FIND, NULL);
+	if (entry == NULL || entry->settings != settings ||
+		strcmp(entry->query_string, query_string) != 0)
+		return NIL;
+
+	dlist_move_head(&ParseTreeCacheLRU, &entry->lru_node);
+
+	/* Parse analysis may scribble on its input, so hand out a copy */
+	return copyObject(entry->parsetrees);
+}
+
+/*
+ * Enter the raw parse trees of a query string into the cache, after
+ * parse_tree_cache_lookup() missed and returned the given hash.
+ *
+ * Only plain DML statements are cached: the grammar reports a couple of
+ * deprecated DDL constructs with warnings, which must not be lost, and
+ * utility statements aren't run at a rate where it would matter anyway.
+ * As with prepared statements, the notice about an over-long identifier is
+ * given only when the string is actually parsed.
+ */
+static void
+parse_tree_cache_store(const char *query_string, uint32 hash,
+					   List *parsetree_list)
+{
+	ParseTreeCacheEntry *entry;
+	MemoryContext context;
+	MemoryContext oldcontext;
+	char	   *query_copy;
+	List	   *parsetree_copy;
+	int			settings;
+	bool		found;
+	ListCell   *lc;
+
+	settings = parse_tree_cache_settings();
+	if (settings < 0 || parsetree_list == NIL)
+		return;
+
+	foreach(lc, parsetree_list)
+	{
+		Node	   *stmt = ((RawStmt *) lfirst(lc))->stmt;
+
+		switch (nodeTag(stmt))
+		{
+			case T_SelectStmt:
+				/* SELECT INTO creates a table */
+				if (((SelectStmt *) stmt)->intoClause != NULL)
+					return;
+				break;
+			case T_InsertStmt:
+			case T_UpdateStmt:
+			case T_DeleteStmt:
+				break;
+			default:
+				return;
+		}
+	}
+
+	if (ParseTreeCache == NULL)
+	{
+		HASHCTL		ctl;
+
+		MemSet(&ctl, 0, sizeof(ctl));
+		ctl.keysize = sizeof(uint32);
+		ctl.entrysize = sizeof(ParseTreeCacheEntry);
+		ParseTreeCache = hash_create("Parse tree cache", 64, &ctl,
+									 HASH_ELEM | HASH_BLOBS);
+	}
+
+	/* Make room */
+	while (ParseTreeCacheCount >= parse_tree_cache_size)
+		parse_tree_cache_remove(dlist_tail_element(ParseTreeCacheEntry,
+												   lru_node,
+												   &ParseTreeCacheLRU));
+
+	context = AllocSetContextCreate(TopMemoryContext,
+									"ParseTreeCacheEntry",
+									ALLOCSET_SMALL_SIZES);
+	oldcontext = MemoryContextSwitchTo(context);
+	query_copy = pstrdup(query_string);
+	parsetree_copy = copyObject(parsetree_list);
+	MemoryContextSetIdentifier(context, query_copy);
+	MemoryContextSwitchTo(oldcontext);
+
+	entry = (ParseTreeCacheEntry *) hash_search(ParseTreeCache, &hash,
+												HASH_ENTER, &found);
+	if (found)
+	{
+		/* A different string with the same hash, or different settings */
+		MemoryContextDelete(entry->context);
+		dlist_delete(&entry->lru_node);
+		ParseTreeCacheCount--;
+	}
+	entry->settings = settings;
+	entry->context = context;
+	entry->query_string = query_copy;
+	entry->parsetrees = parsetree_copy;
+	dlist_push_head(&ParseTreeCacheLRU, &entry->lru_node);
+	ParseTreeCacheCount++;
+}
+
+/*
+ * Remove an entry from the parse tree cache.
+ */
+static void
+parse_tree_cache_remove(ParseTreeCacheEntry *entry)
+{
+	dlist_delete(&entry->lru_node);
+	MemoryContextDelete(entry->context);
+	hash_search(ParseTreeCache, &entry->hash, HASH_REMOVE, NULL);
+	ParseTreeCacheCount--;
+}
+
 /*
  * Given a raw parsetree (gram.y output), and optionally information about
  * types of parameter symbols ($n), perform parse analysis and rule rewriting.
@@ -723,6 +927,7 @@ pg_analyze_and_rewrite_params(RawStmt *parsetree,
 	ParseState *pstate;
 	Query	   *query;
 	List	   *querytree_list;
+	JumbleState *jstate = NULL;
 
 	Assert(query_string != NULL);	/* required as of 8.4 */
 
@@ -741,11 +946,16 @@ pg_analyze_and_rewrite_params(RawStmt *parsetree,
 
 	query = transformTopLevelStmt(pstate, parsetree);
 
+	if (IsQueryIdEnabled())
+		jstate = JumbleQuery(query, query_string);
+
 	if (post_parse_analyze_hook)
-		(*post_parse_analyze_hook) (pstate, query);
+		(*post_parse_analyze_hook) (pstate, query, jstate);
 
 	free_parsestate(pstate);
 
+	pgstat_report_query_id(query->queryId, false);
+
 	if (log_parser_stats)
 		ShowUsage("PARSE ANALYSIS STATISTICS");
 
@@ -858,7 +1068,8 @@ pg_rewrite_query(Query *query)
  * This is a thin wrapper around planner() and takes the same parameters.
  */
 PlannedStmt *
-pg_plan_query(Query *querytree, int cursorOptions, ParamListInfo boundParams)
+pg_plan_query(Query *querytree, const char *query_string, int cursorOptions,
+			  ParamListInfo boundParams)
 {
 	PlannedStmt *plan;
 
@@ -875,7 +1086,7 @@ pg_plan_query(Query *querytree, int cursorOptions, ParamListInfo boundParams)
 		ResetUsage();
 
 	/* call the optimizer */
-	plan = planner(querytree, cursorOptions, boundParams);
+	plan = planner(querytree, query_string, cursorOptions, boundParams);
 
 	if (log_planner_stats)
 		ShowUsage("PLANNER STATISTICS");
@@ -943,7 +1154,8 @@ pg_plan_query(Query *querytree, int cursorOptions, ParamListInfo boundParams)
  * The result is a list of PlannedStmt nodes.
  */
 List *
-pg_plan_queries(List *querytrees, int cursorOptions, ParamListInfo boundParams)
+pg_plan_queries(List *querytrees, const char *query_string, int cursorOptions,
+				ParamListInfo boundParams)
 {
 	List	   *stmt_list = NIL;
 	ListCell   *query_list;
@@ -960,12 +1172,14 @@ pg_plan_queries(List *querytrees, int cursorOptions, ParamListInfo boundParams)
 			stmt->commandType = CMD_UTILITY;
 			stmt->canSetTag = query->canSetTag;
 			stmt->utilityStmt = query->utilityStmt;
+			stmt->queryId = query->queryId;
 			stmt->stmt_location = query->stmt_location;
 			stmt->stmt_len = query->stmt_len;
 		}
 		else
 		{
-			stmt = pg_plan_query(query, cursorOptions, boundParams);
+			stmt = pg_plan_query(query, query_string, cursorOptions,
+								 boundParams);
 		}
 
 		stmt_list = lappend(stmt_list, stmt);
@@ -987,6 +1201,7 @@ exec_simple_query(const char *query_string)
 	MemoryContext oldcontext;
 	List	   *parsetree_list;
 	ListCell   *parsetree_item;
+	uint32		query_hash;
 	bool		save_log_statement_stats = log_statement_stats;
 	bool		was_logged = false;
 	bool		use_implicit_block;
@@ -1032,9 +1247,15 @@ exec_simple_query(const char *query_string)
 
 	/*
 	 * Do basic parsing of the query or queries (this should be safe even if
-	 * we are in aborted transaction state!)
+	 * we are in aborted transaction state!), unless we've seen the same
+	 * string recently.
 	 */
-	parsetree_list = pg_parse_query(query_string);
+	parsetree_list = parse_tree_cache_lookup(query_string, &query_hash);
+	if (parsetree_list == NIL)
+	{
+		parsetree_list = pg_parse_query(query_string);
+		parse_tree_cache_store(query_string, query_hash, parsetree_list);
+	}
 
 	/* Log immediately if dictated by log_statement */
 	if (check_log_statement(parsetree_list))
@@ -1140,7 +1361,7 @@ exec_simple_query(const char *query_string)
 		querytree_list = pg_analyze_and_rewrite(parsetree, query_string,
 												NULL, 0, NULL);
 
-		plantree_list = pg_plan_queries(querytree_list,
+		plantree_list = pg_plan_queries(querytree_list, query_string,
 										CURSOR_OPT_PARALLEL_OK, NULL);
 
 		/* Done with the snapshot used for parsing/planning */
@@ -1966,6 +2187,8 @@ exec_execute_message(const char *portal_name, long max_rows)
 	bool		is_xact_command;
 	bool		execute_is_fetch;
 	bool		was_logged = false;
+	bool		time_plan;
+	instr_time	starttime;
 	char		msec_str[32];
 
 	/* Adjust destination to tell printtup.c what to do */
@@ -2096,6 +2319,17 @@ exec_execute_message(const char *portal_name, long max_rows)
 	if (max_rows <= 0)
 		max_rows = FETCH_ALL;
 
+	/*
+	 * In adaptive plan cache mode, measure how long a prepared statement
+	 * takes, if it runs to completion in this one Execute message.
+	 */
+	time_plan = (plan_cache_mode == PLAN_CACHE_MODE_ADAPTIVE &&
+				 portal->cplan != NULL &&
+				 !execute_is_fetch &&
+				 !is_xact_command);
+	if (time_plan)
+		INSTR_TIME_SET_CURRENT(starttime);
+
 	completed = PortalRun(portal,
 						  max_rows,
 						  true, /* always top level */
@@ -2106,6 +2340,9 @@ exec_execute_message(const char *portal_name, long max_rows)
 
 	receiver->rDestroy(receiver);
 
+	if (completed && time_plan)
+		record_plan_runtime(portal, starttime);
+
 	if (completed)
 	{
 		if (is_xact_command)
@@ -2678,6 +2915,41 @@ drop_unnamed_stmt(void)
 	}
 }
 
+/*
+ * Report the run time of a portal made from a prepared statement to the
+ * plan cache.  The portal only remembers the statement's name, so we look
+ * up its CachedPlanSource again; for the unnamed statement, that may since
+ * have been replaced, in which case CachedPlanRecordRuntime() can't tell the
+ * plan apart from a custom one.  That's not worth worrying about.
+ */
+static void
+record_plan_runtime(Portal portal, instr_time starttime)
+{
+	CachedPlanSource *psrc;
+	instr_time	duration;
+
+	if (portal->prepStmtName)
+	{
+		PreparedStatement *pstmt;
+
+		pstmt = FetchPreparedStatement(portal->prepStmtName, false);
+		if (pstmt == NULL)
+			return;
+		psrc = pstmt->plansource;
+	}
+	else
+	{
+		psrc = unnamed_stmt_psrc;
+		if (psrc == NULL)
+			return;
+	}
+
+	INSTR_TIME_SET_CURRENT(duration);
+	INSTR_TIME_SUBTRACT(duration, starttime);
+	CachedPlanRecordRuntime(psrc, portal->cplan,
+							INSTR_TIME_GET_MILLISEC(duration));
+}
+
 
 /* --------------------------------
  *		signal handler routines used in PostgresMain()
@@ -3159,6 +3431,9 @@ ProcessInterrupts(void)
 
 	if (ParallelMessagePending)
 		HandleParallelMessages();
+
+	if (LogMemoryContextPending)
+		ProcessLogMemoryContextInterrupt();
 }
 
 
@@ -3889,8 +4164,11 @@ PostgresMain(int argc, char *argv[],
 	 * *MyProcPort, because ConnCreate() allocated that space with malloc()
 	 * ... else we'd need to copy the Port data first.  Also, subsidiary data
 	 * such as the username isn't lost either; see ProcessStartupPacket().
+	 *
+	 * A backend started by the connection proxy keeps it, since it will need
+	 * the authentication configuration again for later clients.
 	 */
-	if (PostmasterContext)
+	if (PostmasterContext && !(MyProcPort && MyProcPort->proxied))
 	{
 		MemoryContextDelete(PostmasterContext);
 		PostmasterContext = NULL;
@@ -4439,6 +4717,19 @@ PostgresMain(int argc, char *argv[],
 				send_ready_for_query = true;
 				break;
 
+			case 'a':			/* new client */
+				{
+					const char *client;
+
+					/* the client's address, from the connection proxy */
+					client = pq_getmsgstring(&input_message);
+					pq_getmsgend(&input_message);
+
+					ReauthenticateProxiedClient(client);
+					send_ready_for_query = true;
+				}
+				break;
+
 				/*
 				 * 'X' means that the frontend is closing down the socket. EOF
 				 * means unexpected loss of frontend connection. Either way,
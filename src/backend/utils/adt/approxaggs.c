@@ -0,0 +1,576 @@
+/*-------------------------------------------------------------------------
+ *
+ * approxaggs.c
+ *		Approximate aggregate functions.
+ *
+ * approx_count_distinct() estimates the number of distinct input values with
+ * a HyperLogLog sketch, and approx_percentile() estimates a percentile of its
+ * input with a t-digest.  Unlike count(DISTINCT ...) and percentile_cont(),
+ * neither needs to sort its input, and both use a bounded amount of memory
+ * per group.  Their transition states can be merged, so they support partial
+ * and parallel aggregation.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/utils/adt/approxaggs.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include <math.h>
+
+#include "fmgr.h"
+#include "lib/hyperloglog.h"
+#include "libpq/pqformat.h"
+#include "utils/builtins.h"
+#include "utils/float.h"
+#include "utils/hashutils.h"
+#include "utils/typcache.h"
+
+
+/*
+ * approx_count_distinct
+ *
+ * The transition state is a hyperLogLogState with 2^14 registers, which
+ * gives a standard error of about 0.8%.  Input values are hashed with the
+ * default hash opclass of their type, so that values treated as equal by
+ * GROUP BY and DISTINCT are counted once.
+ */
+#define APPROX_COUNT_DISTINCT_BWIDTH	14
+
+static hyperLogLogState *
+makeHyperLogLogState(MemoryContext agg_context)
+{
+	MemoryContext old_context;
+	hyperLogLogState *state;
+
+	old_context = MemoryContextSwitchTo(agg_context);
+	state = (hyperLogLogState *) palloc(sizeof(hyperLogLogState));
+	initHyperLogLog(state, APPROX_COUNT_DISTINCT_BWIDTH);
+	MemoryContextSwitchTo(old_context);
+
+	return state;
+}
+
+Datum
+approx_count_distinct_transfn(PG_FUNCTION_ARGS)
+{
+	hyperLogLogState *state;
+	MemoryContext agg_context;
+	TypeCacheEntry *typentry;
+	uint32		hash;
+
+	if (!AggCheckCallContext(fcinfo, &agg_context))
+		elog(ERROR, "aggregate function called in non-aggregate context");
+
+	state = PG_ARGISNULL(0) ? NULL : (hyperLogLogState *) PG_GETARG_POINTER(0);
+
+	/* NULLs are not counted, as in count(DISTINCT ...) */
+	if (PG_ARGISNULL(1))
+		PG_RETURN_POINTER(state);
+
+	if (state == NULL)
+		state = makeHyperLogLogState(agg_context);
+
+	/* Look up the hash function of the input type once per query */
+	typentry = (TypeCacheEntry *) fcinfo->flinfo->fn_extra;
+	if (typentry == NULL)
+	{
+		Oid			argtype = get_fn_expr_argtype(fcinfo->flinfo, 1);
+
+		if (!OidIsValid(argtype))
+			elog(ERROR, "could not determine input data type");
+
+		typentry = lookup_type_cache(argtype, TYPECACHE_HASH_PROC_FINFO);
+		if (!OidIsValid(typentry->hash_proc_finfo.fn_oid))
+			ereport(ERROR,
+					(errcode(ERRCODE_UNDEFINED_FUNCTION),
+					 errmsg("could not identify a hash function for type %s",
+							format_type_be(argtype))));
+		fcinfo->flinfo->fn_extra = (void *) typentry;
+	}
+
+	hash = DatumGetUInt32(FunctionCall1Coll(&typentry->hash_proc_finfo,
+											PG_GET_COLLATION(),
+											PG_GETARG_DATUM(1)));
+
+	/*
+	 * HyperLogLog depends on the hash bits being uniformly distributed, which
+	 * isn't guaranteed for every type's hash function, so mix them again.
+	 */
+	addHyperLogLog(state, murmurhash32(hash));
+
+	PG_RETURN_POINTER(state);
+}
+
+Datum
+approx_count_distinct_combine(PG_FUNCTION_ARGS)
+{
+	hyperLogLogState *state1;
+	hyperLogLogState *state2;
+	MemoryContext agg_context;
+
+	if (!AggCheckCallContext(fcinfo, &agg_context))
+		elog(ERROR, "aggregate function called in non-aggregate context");
+
+	state1 = PG_ARGISNULL(0) ? NULL : (hyperLogLogState *) PG_GETARG_POINTER(0);
+	state2 = PG_ARGISNULL(1) ? NULL : (hyperLogLogState *) PG_GETARG_POINTER(1);
+
+	if (state2 == NULL)
+		PG_RETURN_POINTER(state1);
+
+	if (state1 == NULL)
+		state1 = makeHyperLogLogState(agg_context);
+
+	mergeHyperLogLog(state1, state2);
+
+	PG_RETURN_POINTER(state1);
+}
+
+/*
+ * approx_count_distinct_serialize
+ *		Serialize the registers of a hyperLogLogState into bytea.
+ */
+Datum
+approx_count_distinct_serialize(PG_FUNCTION_ARGS)
+{
+	hyperLogLogState *state;
+	StringInfoData buf;
+
+	/* Ensure we disallow calling when not in aggregate context */
+	if (!AggCheckCallContext(fcinfo, NULL))
+		elog(ERROR, "aggregate function called in non-aggregate context");
+
+	state = (hyperLogLogState *) PG_GETARG_POINTER(0);
+
+	pq_begintypsend(&buf);
+	pq_sendbyte(&buf, state->registerWidth);
+	pq_sendbytes(&buf, (char *) state->hashesArr, state->nRegisters);
+
+	PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
+}
+
+/*
+ * approx_count_distinct_deserialize
+ *		Deserialize bytea back into a hyperLogLogState.
+ */
+Datum
+approx_count_distinct_deserialize(PG_FUNCTION_ARGS)
+{
+	bytea	   *sstate;
+	hyperLogLogState *result;
+	StringInfoData buf;
+	uint8		bwidth;
+
+	if (!AggCheckCallContext(fcinfo, NULL))
+		elog(ERROR, "aggregate function called in non-aggregate context");
+
+	sstate = PG_GETARG_BYTEA_PP(0);
+
+	/*
+	 * Copy the bytea into a StringInfo so that we can "receive" it using the
+	 * standard recv-function infrastructure.
+	 */
+	initStringInfo(&buf);
+	appendBinaryStringInfo(&buf,
+						   VARDATA_ANY(sstate), VARSIZE_ANY_EXHDR(sstate));
+
+	bwidth = pq_getmsgbyte(&buf);
+	result = makeHyperLogLogState(CurrentMemoryContext);
+	if (bwidth != result->registerWidth)
+		elog(ERROR, "unexpected HyperLogLog bit width %d", bwidth);
+	memcpy(result->hashesArr, pq_getmsgbytes(&buf, result->nRegisters),
+		   result->nRegisters);
+
+	pq_getmsgend(&buf);
+	pfree(buf.data);
+
+	PG_RETURN_POINTER(result);
+}
+
+Datum
+approx_count_distinct_final(PG_FUNCTION_ARGS)
+{
+	hyperLogLogState *state;
+
+	state = PG_ARGISNULL(0) ? NULL : (hyperLogLogState *) PG_GETARG_POINTER(0);
+
+	/* Like count(), return zero rather than NULL for no input */
+	if (state == NULL)
+		PG_RETURN_INT64(0);
+
+	PG_RETURN_INT64((int64) rint(estimateHyperLogLog(state)));
+}
+
+
+/*
+ * approx_percentile
+ *
+ * The transition state is a merging t-digest, as described in Dunning and
+ * Ertl, "Computing Extremely Accurate Quantiles Using t-Digests".  Input
+ * values are buffered as centroids of weight one after the merged centroids;
+ * when the buffer fills, everything is sorted and adjacent centroids are
+ * merged as long as the result stays within the size limit given by the k1
+ * scale function, k(q) = delta / (2 pi) * asin(2q - 1).  That limits
+ * centroids near the tails to few values, which is where percentiles need
+ * the most precision, and keeps the number of merged centroids below delta.
+ *
+ * The state is a flat struct of fixed size, so copying it is trivial.
+ */
+#define TDIGEST_COMPRESSION		100
+#define TDIGEST_MAX_CENTROIDS	(5 * TDIGEST_COMPRESSION)
+
+typedef struct TDigestCentroid
+{
+	double		mean;			/* mean of the values in the centroid */
+	int64		count;			/* number of values in the centroid */
+} TDigestCentroid;
+
+typedef struct TDigestState
+{
+	double		fraction;		/* the percentile to compute */
+	int64		count;			/* number of values added */
+	double		min;			/* smallest value added */
+	double		max;			/* largest value added */
+	int			nmerged;		/* number of merged centroids */
+	int			nbuffered;		/* number of centroids after those */
+	TDigestCentroid centroids[TDIGEST_MAX_CENTROIDS];
+} TDigestState;
+
+static TDigestState *
+makeTDigestState(MemoryContext agg_context, double fraction)
+{
+	TDigestState *state;
+
+	state = (TDigestState *) MemoryContextAlloc(agg_context,
+												sizeof(TDigestState));
+	state->fraction = fraction;
+	state->count = 0;
+	state->min = get_float8_infinity();
+	state->max = -get_float8_infinity();
+	state->nmerged = 0;
+	state->nbuffered = 0;
+
+	return state;
+}
+
+static int
+tdigest_centroid_cmp(const void *a, const void *b)
+{
+	const TDigestCentroid *ca = (const TDigestCentroid *) a;
+	const TDigestCentroid *cb = (const TDigestCentroid *) b;
+
+	return float8_cmp_internal(ca->mean, cb->mean);
+}
+
+/*
+ * Return the largest q such that a centroid starting at q0 can extend to q,
+ * that is, k(q) = k(q0) + 1.
+ */
+static double
+tdigest_qlimit(double q0)
+{
+	double		angle = asin(2.0 * q0 - 1.0) + 2.0 * M_PI / TDIGEST_COMPRESSION;
+
+	if (angle >= M_PI / 2.0)
+		return 1.0;
+	return (sin(angle) + 1.0) / 2.0;
+}
+
+/*
+ * Merge the buffered centroids into the merged ones.
+ *
+ * This only changes how the values added so far are summarized, so it is
+ * fine to do in final and serialization functions.
+ */
+static void
+tdigest_compress(TDigestState *state)
+{
+	TDigestCentroid *c = state->centroids;
+	int			n = state->nmerged + state->nbuffered;
+	double		total = (double) state->count;
+	int64		sofar = 0;
+	double		qlimit;
+	int			out = 0;
+	int			i;
+
+	if (state->nbuffered == 0)
+		return;
+
+	qsort(c, n, sizeof(TDigestCentroid), tdigest_centroid_cmp);
+
+	qlimit = tdigest_qlimit(0.0);
+	for (i = 1; i < n; i++)
+	{
+		int64		proposed = c[out].count + c[i].count;
+
+		if ((double) (sofar + proposed) <= qlimit * total)
+		{
+			c[out].mean += (c[i].mean - c[out].mean) * c[i].count / proposed;
+			c[out].count = proposed;
+		}
+		else
+		{
+			sofar += c[out].count;
+			qlimit = tdigest_qlimit((double) sofar / total);
+			c[++out] = c[i];
+		}
+	}
+
+	state->nmerged = out + 1;
+	state->nbuffered = 0;
+}
+
+/*
+ * Add a centroid (a single value, if count is 1) to the digest.
+ */
+static void
+tdigest_add(TDigestState *state, double mean, int64 count)
+{
+	if (state->nmerged + state->nbuffered >= TDIGEST_MAX_CENTROIDS)
+		tdigest_compress(state);
+
+	state->centroids[state->nmerged + state->nbuffered].mean = mean;
+	state->centroids[state->nmerged + state->nbuffered].count = count;
+	state->nbuffered++;
+	state->count += count;
+}
+
+/*
+ * Estimate the given percentile from a non-empty digest.
+ *
+ * Each centroid is taken to sit at the middle of the ranks it covers, and we
+ * interpolate linearly between neighboring centroids, and between the outer
+ * centroids and the smallest and largest values.
+ */
+static double
+tdigest_percentile(TDigestState *state, double fraction)
+{
+	TDigestCentroid *c = state->centroids;
+	double		target;
+	double		cum = 0.0;
+	double		left = 0.0;
+	double		result;
+	int			n;
+	int			i;
+
+	tdigest_compress(state);
+	n = state->nmerged;
+	Assert(n > 0);
+
+	target = fraction * state->count;
+
+	if (target < c[0].count / 2.0)
+		result = state->min +
+			(c[0].mean - state->min) * target / (c[0].count / 2.0);
+	else
+	{
+		for (i = 0; i < n - 1; i++)
+		{
+			double		right;
+
+			left = cum + c[i].count / 2.0;
+			right = cum + c[i].count + c[i + 1].count / 2.0;
+			if (target <= right)
+				break;
+			cum += c[i].count;
+		}
+
+		if (i < n - 1)
+			result = c[i].mean + (c[i + 1].mean - c[i].mean) *
+				(target - left) / (c[i].count / 2.0 + c[i + 1].count / 2.0);
+		else
+		{
+			left = state->count - c[n - 1].count / 2.0;
+			result = c[n - 1].mean + (state->max - c[n - 1].mean) *
+				(target - left) / (c[n - 1].count / 2.0);
+		}
+	}
+
+	/* Interpolation can't produce values outside the input range */
+	if (result < state->min)
+		result = state->min;
+	if (result > state->max)
+		result = state->max;
+
+	return result;
+}
+
+/*
+ * approx_percentile_transfn
+ *		Add a value to the digest.
+ *
+ * The percentile is taken from the first row; like the fraction argument of
+ * percentile_cont(), it should be the same for every row of a group.
+ */
+Datum
+approx_percentile_transfn(PG_FUNCTION_ARGS)
+{
+	TDigestState *state;
+	MemoryContext agg_context;
+	double		value;
+
+	if (!AggCheckCallContext(fcinfo, &agg_context))
+		elog(ERROR, "aggregate function called in non-aggregate context");
+
+	state = PG_ARGISNULL(0) ? NULL : (TDigestState *) PG_GETARG_POINTER(0);
+
+	/* NULL values are ignored, as by percentile_cont() */
+	if (PG_ARGISNULL(1) || PG_ARGISNULL(2))
+		PG_RETURN_POINTER(state);
+
+	if (state == NULL)
+	{
+		double		fraction = PG_GETARG_FLOAT8(2);
+
+		if (fraction < 0 || fraction > 1 || isnan(fraction))
+			ereport(ERROR,
+					(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+					 errmsg("percentile value %g is not between 0 and 1",
+							fraction)));
+
+		state = makeTDigestState(agg_context, fraction);
+	}
+
+	value = PG_GETARG_FLOAT8(1);
+	if (float8_lt(value, state->min))
+		state->min = value;
+	if (float8_gt(value, state->max))
+		state->max = value;
+	tdigest_add(state, value, 1);
+
+	PG_RETURN_POINTER(state);
+}
+
+Datum
+approx_percentile_combine(PG_FUNCTION_ARGS)
+{
+	TDigestState *state1;
+	TDigestState *state2;
+	MemoryContext agg_context;
+	int			i;
+
+	if (!AggCheckCallContext(fcinfo, &agg_context))
+		elog(ERROR, "aggregate function called in non-aggregate context");
+
+	state1 = PG_ARGISNULL(0) ? NULL : (TDigestState *) PG_GETARG_POINTER(0);
+	state2 = PG_ARGISNULL(1) ? NULL : (TDigestState *) PG_GETARG_POINTER(1);
+
+	if (state2 == NULL)
+		PG_RETURN_POINTER(state1);
+
+	if (state1 == NULL)
+	{
+		state1 = (TDigestState *) MemoryContextAlloc(agg_context,
+													 sizeof(TDigestState));
+		memcpy(state1, state2, sizeof(TDigestState));
+		PG_RETURN_POINTER(state1);
+	}
+
+	for (i = 0; i < state2->nmerged + state2->nbuffered; i++)
+		tdigest_add(state1, state2->centroids[i].mean,
+					state2->centroids[i].count);
+	if (float8_lt(state2->min, state1->min))
+		state1->min = state2->min;
+	if (float8_gt(state2->max, state1->max))
+		state1->max = state2->max;
+
+	PG_RETURN_POINTER(state1);
+}
+
+/*
+ * approx_percentile_serialize
+ *		Serialize the merged centroids of a TDigestState into bytea.
+ */
+Datum
+approx_percentile_serialize(PG_FUNCTION_ARGS)
+{
+	TDigestState *state;
+	StringInfoData buf;
+	int			i;
+
+	/* Ensure we disallow calling when not in aggregate context */
+	if (!AggCheckCallContext(fcinfo, NULL))
+		elog(ERROR, "aggregate function called in non-aggregate context");
+
+	state = (TDigestState *) PG_GETARG_POINTER(0);
+
+	tdigest_compress(state);
+
+	pq_begintypsend(&buf);
+	pq_sendfloat8(&buf, state->fraction);
+	pq_sendint64(&buf, state->count);
+	pq_sendfloat8(&buf, state->min);
+	pq_sendfloat8(&buf, state->max);
+	pq_sendint32(&buf, state->nmerged);
+	for (i = 0; i < state->nmerged; i++)
+	{
+		pq_sendfloat8(&buf, state->centroids[i].mean);
+		pq_sendint64(&buf, state->centroids[i].count);
+	}
+
+	PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
+}
+
+/*
+ * approx_percentile_deserialize
+ *		Deserialize bytea back into a TDigestState.
+ */
+Datum
+approx_percentile_deserialize(PG_FUNCTION_ARGS)
+{
+	bytea	   *sstate;
+	TDigestState *result;
+	StringInfoData buf;
+	int			i;
+
+	if (!AggCheckCallContext(fcinfo, NULL))
+		elog(ERROR, "aggregate function called in non-aggregate context");
+
+	sstate = PG_GETARG_BYTEA_PP(0);
+
+	/*
+	 * Copy the bytea into a StringInfo so that we can "receive" it using the
+	 * standard recv-function infrastructure.
+	 */
+	initStringInfo(&buf);
+	appendBinaryStringInfo(&buf,
+						   VARDATA_ANY(sstate), VARSIZE_ANY_EXHDR(sstate));
+
+	result = makeTDigestState(CurrentMemoryContext, pq_getmsgfloat8(&buf));
+	result->count = pq_getmsgint64(&buf);
+	result->min = pq_getmsgfloat8(&buf);
+	result->max = pq_getmsgfloat8(&buf);
+	result->nmerged = pq_getmsgint(&buf, 4);
+	if (result->nmerged < 0 || result->nmerged > TDIGEST_MAX_CENTROIDS)
+		elog(ERROR, "invalid number of t-digest centroids %d",
+			 result->nmerged);
+	for (i = 0; i < result->nmerged; i++)
+	{
+		result->centroids[i].mean = pq_getmsgfloat8(&buf);
+		result->centroids[i].count = pq_getmsgint64(&buf);
+	}
+
+	pq_getmsgend(&buf);
+	pfree(buf.data);
+
+	PG_RETURN_POINTER(result);
+}
+
+Datum
+approx_percentile_final(PG_FUNCTION_ARGS)
+{
+	TDigestState *state;
+
+	state = PG_ARGISNULL(0) ? NULL : (TDigestState *) PG_GETARG_POINTER(0);
+
+	/* No input, or all NULLs: return NULL, as percentile_cont() does */
+	if (state == NULL || state->count == 0)
+		PG_RETURN_NULL();
+
+	PG_RETURN_FLOAT8(tdigest_percentile(state, state->fraction));
+}
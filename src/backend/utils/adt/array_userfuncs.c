@@ -15,12 +15,14 @@
 #include "catalog/pg_type.h"
 #include "common/int.h"
 #include "utils/array.h"
+#include "utils/arrayaccess.h"
 #include "utils/builtins.h"
 #include "utils/lsyscache.h"
 #include "utils/typcache.h"
 
 
 static Datum array_position_common(FunctionCallInfo fcinfo);
+static bool array_cat_in_place(FunctionCallInfo fcinfo);
 
 
 /*
@@ -260,6 +262,10 @@ array_cat(PG_FUNCTION_ARGS)
 		PG_RETURN_ARRAYTYPE_P(result);
 	}
 
+	/* Try to append onto a read/write expanded first argument in place */
+	if (array_cat_in_place(fcinfo))
+		PG_RETURN_DATUM(PG_GETARG_DATUM(0));
+
 	v1 = PG_GETARG_ARRAYTYPE_P(0);
 	v2 = PG_GETARG_ARRAYTYPE_P(1);
 
@@ -449,6 +455,82 @@ array_cat(PG_FUNCTION_ARGS)
 }
 
 
+/*
+ * array_cat_in_place
+ *		Try to do array_cat's work by modifying its first argument
+ *
+ * If the first argument is a read/write expanded array, as PL/pgSQL passes
+ * for an assignment like "arr := arr || other", and both arrays are
+ * one-dimensional, we can append the second array's elements onto the end of
+ * the first one and return that, rather than building a whole new array.
+ * The result is the same as what the general code computes in that case.
+ *
+ * Returns false, without having changed anything, if the fast path doesn't
+ * apply; the caller must then do it the hard way.  Both arguments must have
+ * been checked to be non-null.
+ */
+static bool
+array_cat_in_place(FunctionCallInfo fcinfo)
+{
+	Datum		arg1 = PG_GETARG_DATUM(0);
+	ExpandedArrayHeader *eah;
+	AnyArrayType *v2;
+	array_iter	iter;
+	int			nitems2;
+	int			indx;
+	int			newdim;
+	int			i;
+
+	if (!VARATT_IS_EXTERNAL_EXPANDED_RW(DatumGetPointer(arg1)))
+		return false;
+
+	/* "arr := arr || arr" would have us reading what we're appending to */
+	if (DatumGetPointer(arg1) == DatumGetPointer(PG_GETARG_DATUM(1)))
+		return false;
+
+	eah = (ExpandedArrayHeader *) DatumGetEOHP(arg1);
+	Assert(eah->ea_magic == EA_MAGIC);
+	v2 = PG_GETARG_ANY_ARRAY_P(1);
+
+	/* Leave empty and multidimensional cases, and all errors, to array_cat */
+	if (eah->ndims != 1 || AARR_NDIM(v2) != 1 ||
+		eah->element_type != AARR_ELEMTYPE(v2))
+		return false;
+
+	/*
+	 * Check up front that the result will be legal, so that we don't fail
+	 * after appending only some of the elements.
+	 */
+	nitems2 = AARR_DIMS(v2)[0];
+	if (pg_add_s32_overflow(eah->dims[0], nitems2, &newdim) ||
+		pg_add_s32_overflow(eah->lbound[0], newdim - 1, &indx))
+		ereport(ERROR,
+				(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+				 errmsg("integer out of range")));
+	(void) ArrayGetNItems(1, &newdim);
+
+	/* Index of first added element is at lbound + dims */
+	indx = eah->lbound[0] + eah->dims[0];
+
+	array_iter_setup(&iter, v2);
+	for (i = 0; i < nitems2; i++)
+	{
+		Datum		elt;
+		bool		isnull;
+
+		elt = array_iter_next(&iter, &isnull, i,
+							  eah->typlen, eah->typbyval, eah->typalign);
+		(void) array_set_element(EOHPGetRWDatum(&eah->hdr),
+								 1, &indx, elt, isnull,
+								 -1, eah->typlen, eah->typbyval,
+								 eah->typalign);
+		indx++;
+	}
+
+	return true;
+}
+
+
 /*
  * ARRAY_AGG(anynonarray) aggregate function
  */
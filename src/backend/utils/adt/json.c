@@ -23,6 +23,7 @@
 #include "mb/pg_wchar.h"
 #include "miscadmin.h"
 #include "parser/parse_coerce.h"
+#include "port/simd.h"
 #include "utils/array.h"
 #include "utils/builtins.h"
 #include "utils/date.h"
@@ -77,6 +78,7 @@ typedef struct JsonAggState
 
 static inline void json_lex(JsonLexContext *lex);
 static inline void json_lex_string(JsonLexContext *lex);
+static inline char *json_skip_plain_chars(char *s, char *end);
 static inline void json_lex_number(JsonLexContext *lex, char *s,
 				bool *num_err, int *total_len);
 static inline void parse_scalar(JsonLexContext *lex, JsonSemAction *sem);
@@ -970,16 +972,32 @@ json_lex_string(JsonLexContext *lex)
 			}
 
 		}
-		else if (lex->strval != NULL)
+		else
 		{
-			if (hi_surrogate != -1)
-				ereport(ERROR,
-						(errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),
-						 errmsg("invalid input syntax for type %s", "json"),
-						 errdetail("Unicode low surrogate must follow a high surrogate."),
-						 report_json_context(lex)));
+			char	   *p;
+
+			/*
+			 * An ordinary character.  Most characters in a string are, so
+			 * find the end of the run of them starting here and deal with
+			 * the whole run at once.
+			 */
+			p = json_skip_plain_chars(s + 1, lex->input + lex->input_length);
+
+			if (lex->strval != NULL)
+			{
+				if (hi_surrogate != -1)
+					ereport(ERROR,
+							(errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),
+							 errmsg("invalid input syntax for type %s", "json"),
+							 errdetail("Unicode low surrogate must follow a high surrogate."),
+							 report_json_context(lex)));
 
-			appendStringInfoChar(lex->strval, *s);
+				appendBinaryStringInfo(lex->strval, s, p - s);
+			}
+
+			/* Continue with the last character of the run. */
+			len += p - s - 1;
+			s = p - 1;
 		}
 
 	}
@@ -996,6 +1014,43 @@ json_lex_string(JsonLexContext *lex)
 	lex->token_terminator = s + 1;
 }
 
+/*
+ * Return a pointer to the first byte in s[0 .. end - 1] that needs attention
+ * inside a string token, that is a double quote, a backslash or a control
+ * character, or end if there is none.  Where vector instructions are
+ * available, blocks of JSON_SCAN_BLOCK bytes are examined at a time.
+ */
+#define JSON_SCAN_BLOCK 16		/* sizeof(Vector8) */
+
+static inline char *
+json_skip_plain_chars(char *s, char *end)
+{
+#ifndef USE_NO_SIMD
+	const Vector8 quote = vector8_broadcast((uint8) '"');
+	const Vector8 backslash = vector8_broadcast((uint8) '\\');
+	const Vector8 control = vector8_broadcast((uint8) 0x1F);
+
+	while (end - s >= JSON_SCAN_BLOCK)
+	{
+		Vector8		chunk;
+		Vector8		match;
+
+		vector8_load(&chunk, (const uint8 *) s);
+		match = vector8_or(vector8_or(vector8_eq(chunk, quote),
+									  vector8_eq(chunk, backslash)),
+						   vector8_le(chunk, control));
+		if (vector8_is_highbit_set(match))
+			break;
+		s += JSON_SCAN_BLOCK;
+	}
+#endif
+
+	while (s < end && *s != '"' && *s != '\\' && (unsigned char) *s >= 32)
+		s++;
+
+	return s;
+}
+
 /*
  * The next token in the input stream is known to be a number; lex it.
  *
@@ -14,6 +14,7 @@
 #include "postgres.h"
 
 #include "access/hash.h"
+#include "access/tuptoaster.h"
 #include "catalog/pg_collation.h"
 #include "miscadmin.h"
 #include "utils/builtins.h"
@@ -33,9 +34,19 @@
 #define JSONB_MAX_ELEMS (Min(MaxAllocSize / sizeof(JsonbValue), JB_CMASK))
 #define JSONB_MAX_PAIRS (Min(MaxAllocSize / sizeof(JsonbPair), JB_CMASK))
 
+/*
+ * findJsonbValueFromDatum() detoasts only a prefix of documents whose raw
+ * size is at least this much; smaller ones are detoasted whole.  The first
+ * fetch reads this many bytes, which usually covers the root's JEntries and
+ * keys.
+ */
+#define JSONB_PARTIAL_DETOAST_MIN	(4 * TOAST_MAX_CHUNK_SIZE)
+#define JSONB_DETOAST_FIRST_PREFIX	TOAST_MAX_CHUNK_SIZE
+
 static void fillJsonbValue(JsonbContainer *container, int index,
 			   char *base_addr, uint32 offset,
 			   JsonbValue *result);
+static int	findJsonbKeyIndex(JsonbContainer *container, JsonbValue *key);
 static bool equalsJsonbScalarValue(JsonbValue *a, JsonbValue *b);
 static int	compareJsonbScalarValue(JsonbValue *a, JsonbValue *b);
 static Jsonb *convertToJsonb(JsonbValue *val);
@@ -362,46 +373,18 @@ findJsonbValueFromContainer(JsonbContainer *container, uint32 flags,
 	{
 		/* Since this is an object, account for *Pairs* of Jentrys */
 		char	   *base_addr = (char *) (children + count * 2);
-		uint32		stopLow = 0,
-					stopHigh = count;
+		int			keyindex = findJsonbKeyIndex(container, key);
 
-		/* Object key passed by caller must be a string */
-		Assert(key->type == jbvString);
-
-		/* Binary search on object/pair keys *only* */
-		while (stopLow < stopHigh)
+		if (keyindex >= 0)
 		{
-			uint32		stopMiddle;
-			int			difference;
-			JsonbValue	candidate;
-
-			stopMiddle = stopLow + (stopHigh - stopLow) / 2;
+			/* Found our key, return corresponding value */
+			int			index = keyindex + count;
 
-			candidate.type = jbvString;
-			candidate.val.string.val =
-				base_addr + getJsonbOffset(container, stopMiddle);
-			candidate.val.string.len = getJsonbLength(container, stopMiddle);
+			fillJsonbValue(container, index, base_addr,
+						   getJsonbOffset(container, index),
+						   result);
 
-			difference = lengthCompareJsonbStringValue(&candidate, key);
-
-			if (difference == 0)
-			{
-				/* Found our key, return corresponding value */
-				int			index = stopMiddle + count;
-
-				fillJsonbValue(container, index, base_addr,
-							   getJsonbOffset(container, index),
-							   result);
-
-				return result;
-			}
-			else
-			{
-				if (difference < 0)
-					stopLow = stopMiddle + 1;
-				else
-					stopHigh = stopMiddle;
-			}
+			return result;
 		}
 	}
 
@@ -410,6 +393,185 @@ findJsonbValueFromContainer(JsonbContainer *container, uint32 flags,
 	return NULL;
 }
 
+/*
+ * Binary search for a key among the keys of an object container.
+ *
+ * Returns the index of the key, or -1 if there's no such key.  Only the
+ * container's JEntries and keys are read, not its values.
+ *
+ * Finding the offset of an arbitrary key means walking back through as many
+ * as JB_OFFSET_STRIDE JEntrys, which would be done for every probe of a
+ * plain binary search.  Instead, as long as more than JB_OFFSET_STRIDE keys
+ * remain, we only probe keys that immediately follow a JEntry that stores
+ * an offset under the current placement heuristic, so that their offsets
+ * come almost for free.  (getJsonbOffset still does the right thing if a
+ * value was built with some other heuristic; it's just slower.)  The last
+ * few candidates are then compared in order, computing each one's offset
+ * from the previous one's.
+ */
+static int
+findJsonbKeyIndex(JsonbContainer *container, JsonbValue *key)
+{
+	int			count = JsonContainerSize(container);
+	char	   *base_addr = (char *) (container->children + count * 2);
+	uint32		stopLow = 0,
+				stopHigh = count;
+	uint32		offset;
+	uint32		i;
+
+	/* Object key passed by caller must be a string */
+	Assert(key->type == jbvString);
+
+	/* Binary search on object/pair keys *only* */
+	while (stopHigh - stopLow > JB_OFFSET_STRIDE)
+	{
+		uint32		stopMiddle;
+		int			difference;
+		JsonbValue	candidate;
+
+		/*
+		 * Move the midpoint to a key following an offset-bearing JEntry.
+		 * There's always one strictly between stopLow and stopHigh, since
+		 * more than JB_OFFSET_STRIDE keys remain.
+		 */
+		stopMiddle = stopLow + (stopHigh - stopLow) / 2;
+		stopMiddle -= (stopMiddle - 1) % JB_OFFSET_STRIDE;
+		if (stopMiddle <= stopLow)
+			stopMiddle += JB_OFFSET_STRIDE;
+		Assert(stopMiddle > stopLow && stopMiddle < stopHigh);
+
+		candidate.type = jbvString;
+		candidate.val.string.val =
+			base_addr + getJsonbOffset(container, stopMiddle);
+		candidate.val.string.len = getJsonbLength(container, stopMiddle);
+
+		difference = lengthCompareJsonbStringValue(&candidate, key);
+
+		if (difference == 0)
+			return stopMiddle;
+		else if (difference < 0)
+			stopLow = stopMiddle + 1;
+		else
+			stopHigh = stopMiddle;
+	}
+
+	/* Scan the remaining candidates in order */
+	offset = getJsonbOffset(container, stopLow);
+	for (i = stopLow; i < stopHigh; i++)
+	{
+		uint32		next_offset = offset;
+		int			difference;
+		JsonbValue	candidate;
+
+		JBE_ADVANCE_OFFSET(next_offset, container->children[i]);
+
+		candidate.type = jbvString;
+		candidate.val.string.val = base_addr + offset;
+		candidate.val.string.len = next_offset - offset;
+
+		difference = lengthCompareJsonbStringValue(&candidate, key);
+
+		if (difference == 0)
+			return i;
+		else if (difference > 0)
+			break;				/* keys are sorted, so it's not here */
+
+		offset = next_offset;
+	}
+
+	return -1;
+}
+
+/*
+ * Fetch at least the first "need" bytes of a jsonb datum's root container,
+ * reusing *prefix if it already has them.  The result is a partially
+ * detoasted Jsonb, only valid as far as the bytes fetched.
+ */
+static Jsonb *
+jsonbFetchPrefix(Datum jsonb, Jsonb *prefix, uint32 need)
+{
+	if (prefix != NULL)
+	{
+		if (VARSIZE(prefix) - VARHDRSZ >= need)
+			return prefix;
+		pfree(prefix);
+	}
+
+	return (Jsonb *) PG_DETOAST_DATUM_SLICE(jsonb, 0, need);
+}
+
+/*
+ * Like findJsonbValueFromContainer() on the root container of a jsonb
+ * datum, but for large toasted documents with an object at the root, only
+ * detoast the part of the datum needed to find the key and its value.
+ *
+ * Locating a key only requires the root's JEntries and keys, which come
+ * before all the values, and the found value's JEntry tells where it ends.
+ * So we fetch a leading slice of the datum, extend it as needed to cover
+ * the keys and then the value, and search the truncated copy; the lookup
+ * never looks past the value it returns.  With pglz compression (or none)
+ * a leading slice is cheap to get, see heap_tuple_untoast_attr_slice().
+ *
+ * The returned value may point into the partially detoasted copy, which is
+ * palloc'd in the current memory context.
+ */
+JsonbValue *
+findJsonbValueFromDatum(Datum jsonb, uint32 flags, JsonbValue *key)
+{
+	struct varlena *attr = (struct varlena *) DatumGetPointer(jsonb);
+	Jsonb	   *jb;
+	Size		rawsize;
+	uint32		count;
+	uint32		base;
+	int			keyindex;
+	int			index;
+
+	if (!VARATT_IS_EXTERNAL_ONDISK(attr) && !VARATT_IS_COMPRESSED(attr))
+		rawsize = 0;
+	else
+		rawsize = toast_raw_datum_size(jsonb) - VARHDRSZ;
+
+	if (rawsize < JSONB_PARTIAL_DETOAST_MIN || !(flags & JB_FOBJECT))
+	{
+		jb = DatumGetJsonbP(jsonb);
+		return findJsonbValueFromContainer(&jb->root, flags, key);
+	}
+
+	/* First get the root header, and likely the JEntries and keys too */
+	jb = jsonbFetchPrefix(jsonb, NULL, JSONB_DETOAST_FIRST_PREFIX);
+
+	if (!JB_ROOT_IS_OBJECT(jb))
+	{
+		/* Arrays (and scalars) have no such layout to exploit */
+		pfree(jb);
+		jb = DatumGetJsonbP(jsonb);
+		return findJsonbValueFromContainer(&jb->root, flags, key);
+	}
+
+	count = JB_ROOT_COUNT(jb);
+	if (count == 0)
+		return NULL;
+
+	/* The JEntries, which give the offsets of all keys and values */
+	base = offsetof(JsonbContainer, children) + 2 * count * sizeof(JEntry);
+	jb = jsonbFetchPrefix(jsonb, jb, base);
+
+	/* The keys, which end where the first value begins */
+	jb = jsonbFetchPrefix(jsonb, jb, base + getJsonbOffset(&jb->root, count));
+
+	keyindex = findJsonbKeyIndex(&jb->root, key);
+	if (keyindex < 0)
+		return NULL;
+
+	/* And finally the value */
+	index = keyindex + count;
+	jb = jsonbFetchPrefix(jsonb, jb,
+						  base + getJsonbOffset(&jb->root, index) +
+						  getJsonbLength(&jb->root, index));
+
+	return findJsonbValueFromContainer(&jb->root, JB_FOBJECT, key);
+}
+
 /*
  * Get i-th value of a Jsonb array.
  *
@@ -715,16 +715,16 @@ json_object_field(PG_FUNCTION_ARGS)
 Datum
 jsonb_object_field(PG_FUNCTION_ARGS)
 {
-	Jsonb	   *jb = PG_GETARG_JSONB_P(0);
 	text	   *key = PG_GETARG_TEXT_PP(1);
+	JsonbValue	kval;
 	JsonbValue *v;
 
-	if (!JB_ROOT_IS_OBJECT(jb))
-		PG_RETURN_NULL();
+	/* Avoid detoasting the whole document just to extract one field */
+	kval.type = jbvString;
+	kval.val.string.val = VARDATA_ANY(key);
+	kval.val.string.len = VARSIZE_ANY_EXHDR(key);
 
-	v = findJsonbValueFromContainerLen(&jb->root, JB_FOBJECT,
-									   VARDATA_ANY(key),
-									   VARSIZE_ANY_EXHDR(key));
+	v = findJsonbValueFromDatum(PG_GETARG_DATUM(0), JB_FOBJECT, &kval);
 
 	if (v != NULL)
 		PG_RETURN_JSONB_P(JsonbValueToJsonb(v));
@@ -751,16 +751,16 @@ json_object_field_text(PG_FUNCTION_ARGS)
 Datum
 jsonb_object_field_text(PG_FUNCTION_ARGS)
 {
-	Jsonb	   *jb = PG_GETARG_JSONB_P(0);
 	text	   *key = PG_GETARG_TEXT_PP(1);
+	JsonbValue	kval;
 	JsonbValue *v;
 
-	if (!JB_ROOT_IS_OBJECT(jb))
-		PG_RETURN_NULL();
+	/* Avoid detoasting the whole document just to extract one field */
+	kval.type = jbvString;
+	kval.val.string.val = VARDATA_ANY(key);
+	kval.val.string.len = VARSIZE_ANY_EXHDR(key);
 
-	v = findJsonbValueFromContainerLen(&jb->root, JB_FOBJECT,
-									   VARDATA_ANY(key),
-									   VARSIZE_ANY_EXHDR(key));
+	v = findJsonbValueFromDatum(PG_GETARG_DATUM(0), JB_FOBJECT, &kval);
 
 	if (v != NULL)
 	{
@@ -33,7 +33,8 @@ const char *const LockTagTypeNames[] = {
 	"speculative token",
 	"object",
 	"userlock",
-	"advisory"
+	"advisory",
+	"applytransaction"
 };
 
 /* This must match enum PredicateLockTargetType (predicate_internals.h) */
@@ -294,6 +295,7 @@ pg_lock_status(PG_FUNCTION_ARGS)
 			case LOCKTAG_OBJECT:
 			case LOCKTAG_USERLOCK:
 			case LOCKTAG_ADVISORY:
+			case LOCKTAG_APPLY_TRANSACTION:
 			default:			/* treat unknown locktags like OBJECT */
 				values[1] = ObjectIdGetDatum(instance->locktag.locktag_field1);
 				values[7] = ObjectIdGetDatum(instance->locktag.locktag_field2);
@@ -330,6 +330,14 @@ typedef struct
  * call to accum_sum_add() will enlarge the buffer, to make room for the
  * extra digit, and set the flag again.
  *
+ * On platforms with 128-bit integers, values of moderate size, which is
+ * what most aggregates see (think of a numeric(18,4) column), bypass the
+ * digit buffers altogether: they are converted to a 128-bit integer in units
+ * of NBASE^-ACCUM_SMALL_RSCALE and added to 'small_sum'.  'small_count'
+ * tracks how many values have been added there, so that it can be moved into
+ * the digit buffers before it risks overflowing.  accum_sum_final() adds the
+ * two parts together.
+ *
  * To initialize a new accumulator, simply reset all fields to zeros.
  *
  * The accumulator does not handle NaNs.
@@ -344,8 +352,25 @@ typedef struct NumericSumAccum
 	bool		have_carry_space;
 	int32	   *pos_digits;
 	int32	   *neg_digits;
+#ifdef HAVE_INT128
+	int128		small_sum;
+	int			small_count;
+#endif
 } NumericSumAccum;
 
+#ifdef HAVE_INT128
+/*
+ * Values taking the small-value path in accum_sum_add() have at most
+ * ACCUM_SMALL_RSCALE fractional and ACCUM_SMALL_MAX_WEIGHT + 1 integral NBASE
+ * digits, that is, at most 8 decimal places and 24 integer digits, so each is
+ * less than 10^32 < 2^107 in absolute value once scaled.  After
+ * ACCUM_SMALL_MAX_COUNT of those, the sum is flushed to the digit buffers.
+ */
+#define ACCUM_SMALL_RSCALE		(8 / DEC_DIGITS)
+#define ACCUM_SMALL_MAX_WEIGHT	(24 / DEC_DIGITS - 1)
+#define ACCUM_SMALL_MAX_COUNT	(1 << 19)
+#endif
+
 
 /*
  * We define our own macros for packing and unpacking abbreviated-key
@@ -546,10 +571,16 @@ static void compute_bucket(Numeric operand, Numeric bound1, Numeric bound2,
 			   const NumericVar *count_var, NumericVar *result_var);
 
 static void accum_sum_add(NumericSumAccum *accum, const NumericVar *var1);
+static void accum_sum_add_digits(NumericSumAccum *accum, const NumericVar *val);
+#ifdef HAVE_INT128
+static void accum_sum_small_var(NumericSumAccum *accum, NumericVar *result);
+static void accum_sum_flush_small(NumericSumAccum *accum);
+#endif
 static void accum_sum_rescale(NumericSumAccum *accum, const NumericVar *val);
 static void accum_sum_carry(NumericSumAccum *accum);
 static void accum_sum_reset(NumericSumAccum *accum);
 static void accum_sum_final(NumericSumAccum *accum, NumericVar *result);
+static void accum_sum_final_digits(NumericSumAccum *accum, NumericVar *result);
 static void accum_sum_copy(NumericSumAccum *dst, NumericSumAccum *src);
 static void accum_sum_combine(NumericSumAccum *accum, NumericSumAccum *accum2);
 
@@ -6934,6 +6965,64 @@ mul_var(const NumericVar *var1, const NumericVar *var2, NumericVar *result,
 		return;
 	}
 
+#ifdef HAVE_INT128
+
+	/*
+	 * If both inputs have at most 16 decimal digits and the product is to be
+	 * computed exactly, which is the common case for columns of moderate
+	 * precision, multiply them as 64-bit integers with a 128-bit result.
+	 * This gives the same result as the general code below, without
+	 * allocating or looping over the accumulator array.
+	 */
+	if (var2ndigits <= 16 / DEC_DIGITS &&
+		res_ndigits == var1ndigits + var2ndigits + 1)
+	{
+		uint64		val1 = 0;
+		uint64		val2 = 0;
+		uint128		prod;
+		uint64		hi;
+		uint64		lo;
+
+		for (i = 0; i < var1ndigits; i++)
+			val1 = val1 * NBASE + var1digits[i];
+		for (i = 0; i < var2ndigits; i++)
+			val2 = val2 * NBASE + var2digits[i];
+
+		/*
+		 * Split the product at 10^16, so that the digits can be extracted
+		 * with 64-bit division.
+		 */
+		prod = (uint128) val1 * val2;
+		hi = (uint64) (prod / UINT64CONST(10000000000000000));
+		lo = (uint64) (prod - (uint128) hi * UINT64CONST(10000000000000000));
+
+		alloc_var(result, res_ndigits);
+		res_digits = result->digits;
+		for (i = res_ndigits - 1; i >= Max(res_ndigits - 16 / DEC_DIGITS, 0); i--)
+		{
+			res_digits[i] = lo % NBASE;
+			lo /= NBASE;
+		}
+		Assert(lo == 0);
+		for (; i >= 0; i--)
+		{
+			res_digits[i] = hi % NBASE;
+			hi /= NBASE;
+		}
+		Assert(hi == 0);
+
+		result->weight = res_weight;
+		result->sign = res_sign;
+
+		/* Round to target rscale (and set result->dscale) */
+		round_var(result, rscale);
+
+		/* Strip leading and trailing zeroes */
+		strip_var(result);
+		return;
+	}
+#endif
+
 	/*
 	 * We do the arithmetic in an array "dig[]" of signed int's.  Since
 	 * INT_MAX is noticeably larger than NBASE*NBASE, this gives us headroom
@@ -6997,10 +7086,21 @@ mul_var(const NumericVar *var1, const NumericVar *var2, NumericVar *result,
 		 *
 		 * As above, digits of var2 can be ignored if they don't contribute,
 		 * so we only include digits for which i1+i2+2 <= res_ndigits - 1.
+		 *
+		 * This inner loop is the performance bottleneck for multiplication,
+		 * so we want to keep it simple enough so that it can be
+		 * auto-vectorized.  Accordingly, process the digits left-to-right
+		 * even though schoolbook multiplication would suggest right-to-left.
+		 * Since we aren't propagating carries in this loop, the order does
+		 * not matter.
 		 */
-		for (i2 = Min(var2ndigits - 1, res_ndigits - i1 - 3), i = i1 + i2 + 2;
-			 i2 >= 0; i2--)
-			dig[i--] += var1digit * var2digits[i2];
+		{
+			int			i2limit = Min(var2ndigits, res_ndigits - i1 - 2);
+			int		   *dig_i1_2 = &dig[i1 + 2];
+
+			for (i2 = 0; i2 < i2limit; i2++)
+				dig_i1_2[i2] += var1digit * var2digits[i2];
+		}
 	}
 
 	/*
@@ -8988,6 +9088,10 @@ accum_sum_reset(NumericSumAccum *accum)
 		accum->pos_digits[i] = 0;
 		accum->neg_digits[i] = 0;
 	}
+#ifdef HAVE_INT128
+	accum->small_sum = 0;
+	accum->small_count = 0;
+#endif
 }
 
 /*
@@ -8995,6 +9099,45 @@ accum_sum_reset(NumericSumAccum *accum)
  */
 static void
 accum_sum_add(NumericSumAccum *accum, const NumericVar *val)
+{
+#ifdef HAVE_INT128
+	int			val_rscale = val->ndigits - val->weight - 1;
+
+	/* Add values of moderate size to small_sum, if they fit */
+	if (val->weight <= ACCUM_SMALL_MAX_WEIGHT &&
+		val_rscale <= ACCUM_SMALL_RSCALE)
+	{
+		int128		newval = 0;
+		int			i;
+
+		if (accum->small_count == ACCUM_SMALL_MAX_COUNT)
+			accum_sum_flush_small(accum);
+
+		for (i = 0; i < val->ndigits; i++)
+			newval = newval * NBASE + val->digits[i];
+		for (i = val_rscale; i < ACCUM_SMALL_RSCALE; i++)
+			newval *= NBASE;
+
+		if (val->sign == NUMERIC_POS)
+			accum->small_sum += newval;
+		else
+			accum->small_sum -= newval;
+		accum->small_count++;
+
+		if (val->dscale > accum->dscale)
+			accum->dscale = val->dscale;
+		return;
+	}
+#endif
+
+	accum_sum_add_digits(accum, val);
+}
+
+/*
+ * Accumulate a new value into the digit buffers.
+ */
+static void
+accum_sum_add_digits(NumericSumAccum *accum, const NumericVar *val)
 {
 	int32	   *accum_digits;
 	int			i,
@@ -9038,6 +9181,39 @@ accum_sum_add(NumericSumAccum *accum, const NumericVar *val)
 	accum->num_uncarried++;
 }
 
+#ifdef HAVE_INT128
+/*
+ * Return the value of small_sum as a NumericVar.
+ */
+static void
+accum_sum_small_var(NumericSumAccum *accum, NumericVar *result)
+{
+	int128_to_numericvar(accum->small_sum, result);
+	if (result->ndigits > 0)
+		result->weight -= ACCUM_SMALL_RSCALE;
+	result->dscale = accum->dscale;
+}
+
+/*
+ * Move the value of small_sum into the digit buffers.
+ */
+static void
+accum_sum_flush_small(NumericSumAccum *accum)
+{
+	NumericVar	tmp_var;
+
+	init_var(&tmp_var);
+	accum_sum_small_var(accum, &tmp_var);
+	strip_var(&tmp_var);
+	if (tmp_var.ndigits > 0)
+		accum_sum_add_digits(accum, &tmp_var);
+	free_var(&tmp_var);
+
+	accum->small_sum = 0;
+	accum->small_count = 0;
+}
+#endif
+
 /*
  * Propagate carries.
  */
@@ -9205,6 +9381,42 @@ accum_sum_rescale(NumericSumAccum *accum, const NumericVar *val)
  */
 static void
 accum_sum_final(NumericSumAccum *accum, NumericVar *result)
+{
+#ifdef HAVE_INT128
+	if (accum->small_count > 0)
+	{
+		NumericVar	small_var;
+
+		/* Add the value of small_sum to that of the digit buffers */
+		init_var(&small_var);
+		accum_sum_small_var(accum, &small_var);
+		if (accum->ndigits == 0)
+			set_var_from_var(&small_var, result);
+		else
+		{
+			NumericVar	digits_var;
+
+			init_var(&digits_var);
+			accum_sum_final_digits(accum, &digits_var);
+			add_var(&digits_var, &small_var, result);
+			free_var(&digits_var);
+		}
+		free_var(&small_var);
+
+		/* Remove leading/trailing zeroes */
+		strip_var(result);
+		return;
+	}
+#endif
+
+	accum_sum_final_digits(accum, result);
+}
+
+/*
+ * Workhorse for accum_sum_final(): return the value of the digit buffers.
+ */
+static void
+accum_sum_final_digits(NumericSumAccum *accum, NumericVar *result)
 {
 	int			i;
 	NumericVar	pos_var;
@@ -9266,6 +9478,10 @@ accum_sum_copy(NumericSumAccum *dst, NumericSumAccum *src)
 	dst->ndigits = src->ndigits;
 	dst->weight = src->weight;
 	dst->dscale = src->dscale;
+#ifdef HAVE_INT128
+	dst->small_sum = src->small_sum;
+	dst->small_count = src->small_count;
+#endif
 }
 
 /*
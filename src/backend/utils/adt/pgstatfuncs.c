@@ -23,18 +23,17 @@
 #include "pgstat.h"
 #include "postmaster/bgworker_internals.h"
 #include "postmaster/postmaster.h"
+#include "storage/lockstats.h"
 #include "storage/proc.h"
 #include "storage/procarray.h"
 #include "utils/acl.h"
+#include "utils/array.h"
 #include "utils/builtins.h"
 #include "utils/inet.h"
 #include "utils/timestamp.h"
 
 #define UINT32_ACCESS_ONCE(var)		 ((uint32)(*((volatile uint32 *)&(var))))
 
-/* Global bgwriter statistics, from bgwriter.c */
-extern PgStat_MsgBgWriter bgwriterStats;
-
 Datum
 pg_stat_get_numscans(PG_FUNCTION_ARGS)
 {
@@ -468,6 +467,14 @@ pg_stat_get_progress_info(PG_FUNCTION_ARGS)
 	/* Translate command name into command type code. */
 	if (pg_strcasecmp(cmd, "VACUUM") == 0)
 		cmdtype = PROGRESS_COMMAND_VACUUM;
+	else if (pg_strcasecmp(cmd, "CLUSTER") == 0)
+		cmdtype = PROGRESS_COMMAND_CLUSTER;
+	else if (pg_strcasecmp(cmd, "CREATE INDEX") == 0)
+		cmdtype = PROGRESS_COMMAND_CREATE_INDEX;
+	else if (pg_strcasecmp(cmd, "COPY") == 0)
+		cmdtype = PROGRESS_COMMAND_COPY;
+	else if (pg_strcasecmp(cmd, "BASEBACKUP") == 0)
+		cmdtype = PROGRESS_COMMAND_BASEBACKUP;
 	else
 		ereport(ERROR,
 				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
@@ -541,7 +548,7 @@ pg_stat_get_progress_info(PG_FUNCTION_ARGS)
 Datum
 pg_stat_get_activity(PG_FUNCTION_ARGS)
 {
-#define PG_STAT_GET_ACTIVITY_COLS	24
+#define PG_STAT_GET_ACTIVITY_COLS	25
 	int			num_backends = pgstat_fetch_stat_numbackends();
 	int			curr_backend;
 	int			pid = PG_ARGISNULL(0) ? -1 : PG_GETARG_INT32(0);
@@ -837,6 +844,11 @@ pg_stat_get_activity(PG_FUNCTION_ARGS)
 			else
 				values[17] =
 					CStringGetTextDatum(pgstat_get_backend_desc(beentry->st_backendType));
+
+			if (beentry->st_query_id != UINT64CONST(0))
+				values[24] = UInt64GetDatum(beentry->st_query_id);
+			else
+				nulls[24] = true;
 		}
 		else
 		{
@@ -853,6 +865,7 @@ pg_stat_get_activity(PG_FUNCTION_ARGS)
 			nulls[13] = true;
 			nulls[14] = true;
 			nulls[17] = true;
+			nulls[24] = true;
 		}
 
 		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
@@ -1882,3 +1895,257 @@ pg_stat_get_archiver(PG_FUNCTION_ARGS)
 	PG_RETURN_DATUM(HeapTupleGetDatum(
 									  heap_form_tuple(tupdesc, values, nulls)));
 }
+
+Datum
+pg_stat_get_wal(PG_FUNCTION_ARGS)
+{
+	TupleDesc	tupdesc;
+	Datum		values[5];
+	bool		nulls[5];
+	char		buf[256];
+	PgStat_WalStats *wal_stats;
+
+	/* Initialise values and NULL flags arrays */
+	MemSet(values, 0, sizeof(values));
+	MemSet(nulls, 0, sizeof(nulls));
+
+	/* Initialise attributes information in the tuple descriptor */
+	tupdesc = CreateTemplateTupleDesc(5);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 1, "wal_records",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 2, "wal_fpi",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 3, "wal_bytes",
+					   NUMERICOID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 4, "wal_buffers_full",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 5, "stats_reset",
+					   TIMESTAMPTZOID, -1, 0);
+
+	BlessTupleDesc(tupdesc);
+
+	/* Get statistics about WAL generation */
+	wal_stats = pgstat_fetch_stat_wal();
+
+	/* Fill values and NULLs */
+	values[0] = Int64GetDatum(wal_stats->wal_records);
+	values[1] = Int64GetDatum(wal_stats->wal_fpi);
+
+	/* Convert to numeric, as the byte count is unsigned */
+	snprintf(buf, sizeof buf, UINT64_FORMAT, wal_stats->wal_bytes);
+	values[2] = DirectFunctionCall3(numeric_in,
+									CStringGetDatum(buf),
+									ObjectIdGetDatum(0),
+									Int32GetDatum(-1));
+
+	values[3] = Int64GetDatum(wal_stats->wal_buffers_full);
+
+	if (wal_stats->stat_reset_timestamp == 0)
+		nulls[4] = true;
+	else
+		values[4] = TimestampTzGetDatum(wal_stats->stat_reset_timestamp);
+
+	/* Returns the record as Datum */
+	PG_RETURN_DATUM(HeapTupleGetDatum(
+									  heap_form_tuple(tupdesc, values, nulls)));
+}
+
+/*
+ * Returns lock wait and hold time statistics, one row per LWLock tranche or
+ * heavyweight lock type that has been waited for or held while
+ * track_lock_timing was enabled.
+ */
+Datum
+pg_stat_get_lock_timing(PG_FUNCTION_ARGS)
+{
+#define PG_STAT_GET_LOCK_TIMING_COLS	9
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext per_query_ctx;
+	MemoryContext oldcontext;
+	LockTimingCounts *counts;
+	TimestampTz stats_reset;
+	int			i;
+
+	/* check to see if caller supports us returning a tuplestore */
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not " \
+						"allowed in this context")));
+
+	/* Build a tuple descriptor for our result type */
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	counts = (LockTimingCounts *)
+		palloc(LOCKSTATS_NUM_ENTRIES * sizeof(LockTimingCounts));
+	stats_reset = LockStatsFetch(counts);
+
+	for (i = 0; i < LOCKSTATS_NUM_ENTRIES; i++)
+	{
+		Datum		values[PG_STAT_GET_LOCK_TIMING_COLS];
+		bool		nulls[PG_STAT_GET_LOCK_TIMING_COLS];
+		Datum		hist[LOCKSTATS_HIST_BUCKETS];
+		LockTimingCounts *c = &counts[i];
+		const char *name;
+		int			j;
+
+		if (c->wait_count == 0 && c->hold_count == 0)
+			continue;
+
+		MemSet(values, 0, sizeof(values));
+		MemSet(nulls, 0, sizeof(nulls));
+
+		if (i < LOCKSTATS_MAX_LWLOCK_TRANCHES)
+		{
+			values[0] = CStringGetTextDatum("LWLock");
+			name = GetLWLockIdentifier(PG_WAIT_LWLOCK, i);
+		}
+		else
+		{
+			values[0] = CStringGetTextDatum("Lock");
+			name = LockTagTypeNames[i - LOCKSTATS_MAX_LWLOCK_TRANCHES];
+		}
+		values[1] = CStringGetTextDatum(name);
+
+		/* times are kept in microseconds, but shown in milliseconds */
+		values[2] = Int64GetDatum((int64) c->wait_count);
+		values[3] = Float8GetDatum(((double) c->wait_time) / 1000.0);
+		values[4] = Float8GetDatum(((double) c->max_wait_time) / 1000.0);
+		values[5] = Int64GetDatum((int64) c->hold_count);
+		values[6] = Float8GetDatum(((double) c->hold_time) / 1000.0);
+
+		for (j = 0; j < LOCKSTATS_HIST_BUCKETS; j++)
+			hist[j] = Int64GetDatum((int64) c->hold_hist[j]);
+		values[7] = PointerGetDatum(construct_array(hist,
+													LOCKSTATS_HIST_BUCKETS,
+													INT8OID, sizeof(int64),
+													FLOAT8PASSBYVAL, 'd'));
+
+		values[8] = TimestampTzGetDatum(stats_reset);
+
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+	}
+
+	pfree(counts);
+
+	/* clean up and return the tuplestore */
+	tuplestore_donestoring(tupstore);
+
+	return (Datum) 0;
+}
+
+/*
+ * Returns I/O statistics, one row per combination of backend type, I/O
+ * object and I/O context that can occur.
+ */
+Datum
+pg_stat_get_io(PG_FUNCTION_ARGS)
+{
+#define PG_STAT_GET_IO_COLS	12
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext per_query_ctx;
+	MemoryContext oldcontext;
+	PgStat_IOStats *io_stats;
+	int			bktype;
+
+	/* check to see if caller supports us returning a tuplestore */
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not " \
+						"allowed in this context")));
+
+	/* Build a tuple descriptor for our result type */
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	io_stats = pgstat_fetch_stat_io();
+
+	for (bktype = 0; bktype < BACKEND_NUM_TYPES; bktype++)
+	{
+		int			io_object;
+
+		for (io_object = 0; io_object < IOOBJECT_NUM_TYPES; io_object++)
+		{
+			int			io_context;
+
+			for (io_context = 0; io_context < IOCONTEXT_NUM_TYPES; io_context++)
+			{
+				Datum		values[PG_STAT_GET_IO_COLS];
+				bool		nulls[PG_STAT_GET_IO_COLS];
+				PgStat_IOCounts *c;
+				int			io_op;
+
+				if (!pgstat_tracks_io_object((BackendType) bktype,
+											 (IOObject) io_object,
+											 (IOContext) io_context))
+					continue;
+
+				c = &io_stats->stats[bktype][io_object][io_context];
+
+				MemSet(values, 0, sizeof(values));
+				MemSet(nulls, 0, sizeof(nulls));
+
+				values[0] = CStringGetTextDatum(pgstat_get_backend_desc((BackendType) bktype));
+				values[1] = CStringGetTextDatum(pgstat_get_io_object_name((IOObject) io_object));
+				values[2] = CStringGetTextDatum(pgstat_get_io_context_name((IOContext) io_context));
+
+				/*
+				 * A count and a time per operation, in IOOp order; times are
+				 * kept in microseconds, but shown in milliseconds
+				 */
+				for (io_op = 0; io_op < IOOP_NUM_TYPES; io_op++)
+				{
+					values[3 + 2 * io_op] = Int64GetDatum(c->counts[io_op]);
+					values[4 + 2 * io_op] =
+						Float8GetDatum(((double) c->times[io_op]) / 1000.0);
+				}
+
+				if (io_stats->stat_reset_timestamp == 0)
+					nulls[11] = true;
+				else
+					values[11] = TimestampTzGetDatum(io_stats->stat_reset_timestamp);
+
+				tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+			}
+		}
+	}
+
+	/* clean up and return the tuplestore */
+	tuplestore_donestoring(tupstore);
+
+	return (Datum) 0;
+}
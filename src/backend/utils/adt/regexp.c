@@ -93,16 +93,28 @@ typedef struct regexp_matches_ctx
 
 /* this is the maximum number of cached regular expressions */
 #ifndef MAX_CACHED_RES
-#define MAX_CACHED_RES	32
+#define MAX_CACHED_RES	64
 #endif
 
-/* this structure describes one cached regular expression */
+/*
+ * this structure describes one cached regular expression
+ *
+ * If every string the RE matches must contain some literal substring, the
+ * longest such substring we could find in the pattern is identified by
+ * cre_lit_off and cre_lit_len (zero if none), as a range of cre_pat.  Plain
+ * boolean matches check for it with memchr() and memcmp() before running the
+ * regex engine, which lets most non-matching strings, in searches like
+ * "col ~ 'ERROR: .* timeout'", be rejected without converting them to
+ * pg_wchar and scanning them with the automaton.
+ */
 typedef struct cached_re_str
 {
 	char	   *cre_pat;		/* original RE (not null terminated!) */
 	int			cre_pat_len;	/* length of original RE, in bytes */
 	int			cre_flags;		/* compile flags: extended,icase etc */
 	Oid			cre_collation;	/* collation to use */
+	int			cre_lit_off;	/* offset of required literal in cre_pat */
+	int			cre_lit_len;	/* length of required literal, or 0 */
 	regex_t		cre_re;			/* the compiled regular expression */
 } cached_re_str;
 
@@ -111,6 +123,12 @@ static cached_re_str re_array[MAX_CACHED_RES];	/* cached re's */
 
 
 /* Local functions */
+static cached_re_str *RE_compile_and_cache_entry(text *text_re, int cflags,
+						   Oid collation);
+static void RE_find_required_literal(const char *pat, int pat_len, int cflags,
+						 int *lit_off, int *lit_len);
+static bool RE_contains_literal(const char *dat, int dat_len,
+					const char *lit, int lit_len);
 static regexp_matches_ctx *setup_regexp_matches(text *orig_str, text *pattern,
 					 pg_re_flags *flags,
 					 Oid collation,
@@ -135,6 +153,17 @@ static Datum build_regexp_split_result(regexp_matches_ctx *splitctx);
  */
 static regex_t *
 RE_compile_and_cache(text *text_re, int cflags, Oid collation)
+{
+	return &RE_compile_and_cache_entry(text_re, cflags, collation)->cre_re;
+}
+
+/*
+ * RE_compile_and_cache_entry - workhorse for RE_compile_and_cache
+ *
+ * Returns the cache entry, rather than just the compiled RE.
+ */
+static cached_re_str *
+RE_compile_and_cache_entry(text *text_re, int cflags, Oid collation)
 {
 	int			text_re_len = VARSIZE_ANY_EXHDR(text_re);
 	char	   *text_re_val = VARDATA_ANY(text_re);
@@ -167,7 +196,7 @@ RE_compile_and_cache(text *text_re, int cflags, Oid collation)
 				re_array[0] = re_temp;
 			}
 
-			return &re_array[0].cre_re;
+			return &re_array[0];
 		}
 	}
 
@@ -226,6 +255,8 @@ RE_compile_and_cache(text *text_re, int cflags, Oid collation)
 	re_temp.cre_pat_len = text_re_len;
 	re_temp.cre_flags = cflags;
 	re_temp.cre_collation = collation;
+	RE_find_required_literal(re_temp.cre_pat, text_re_len, cflags,
+							 &re_temp.cre_lit_off, &re_temp.cre_lit_len);
 
 	/*
 	 * Okay, we have a valid new item in re_temp; insert it into the storage
@@ -245,7 +276,194 @@ RE_compile_and_cache(text *text_re, int cflags, Oid collation)
 	re_array[0] = re_temp;
 	num_res++;
 
-	return &re_array[0].cre_re;
+	return &re_array[0];
+}
+
+/*
+ * RE_find_required_literal - find a literal substring of a RE's matches
+ *
+ * Sets *lit_off and *lit_len to the position in 'pat' of the longest run of
+ * literal characters that every match of the RE must contain, or *lit_len to
+ * zero if we can't find one.  The analysis is deliberately simple: we only
+ * consider case-sensitive AREs without alternation or embedded options, and
+ * only literals outside parentheses and bracket expressions.  It's always
+ * safe to find nothing.
+ *
+ * The literal is found on the pattern's bytes, in the database encoding, and
+ * will be searched for as bytes in the data.  That can produce false hits in
+ * some multibyte encodings, but never false misses, which is all we need.
+ */
+static void
+RE_find_required_literal(const char *pat, int pat_len, int cflags,
+						 int *lit_off, int *lit_len)
+{
+	int			run_start = 0;	/* start of the current literal run */
+	int			last_char = -1; /* start of its last char, -1 if empty */
+	int			depth = 0;		/* parenthesis nesting depth */
+	int			i = 0;
+
+	*lit_off = 0;
+	*lit_len = 0;
+
+	if ((cflags & (REG_ADVANCED | REG_QUOTE | REG_ICASE | REG_EXPANDED)) !=
+		REG_ADVANCED)
+		return;
+	/* "***" introduces directors that can change the interpretation */
+	if (pat_len >= 3 && strncmp(pat, "***", 3) == 0)
+		return;
+
+/* end the current literal run at byte 'end', remembering it if longest */
+#define CLOSE_RUN(end) \
+	do { \
+		if (last_char >= 0 && depth == 0 && (end) - run_start > *lit_len) \
+		{ \
+			*lit_off = run_start; \
+			*lit_len = (end) - run_start; \
+		} \
+		last_char = -1; \
+	} while (0)
+
+	while (i < pat_len)
+	{
+		switch (pat[i])
+		{
+			case '|':
+				/* alternation: nothing in particular is required */
+				*lit_len = 0;
+				return;
+
+			case '(':
+				/* "(?" starts an embedded option setting or a constraint */
+				if (i + 1 < pat_len && pat[i + 1] == '?')
+				{
+					*lit_len = 0;
+					return;
+				}
+				CLOSE_RUN(i);
+				depth++;
+				i++;
+				break;
+
+			case ')':
+				CLOSE_RUN(i);
+				if (depth > 0)
+					depth--;
+				i++;
+				break;
+
+			case '*':
+			case '?':
+			case '{':
+				/* the preceding atom is optional, so drop it from the run */
+				CLOSE_RUN(last_char >= 0 ? last_char : i);
+				/* skip over a bound, as its contents aren't literals */
+				if (pat[i] == '{')
+				{
+					while (i < pat_len && pat[i] != '}')
+						i++;
+				}
+				i++;
+				break;
+
+			case '+':
+				/* the preceding atom is required, but the run ends here */
+				CLOSE_RUN(i);
+				i++;
+				break;
+
+			case '[':
+				/* skip the bracket expression */
+				CLOSE_RUN(i);
+				i++;
+				if (i < pat_len && pat[i] == '^')
+					i++;
+				if (i < pat_len && pat[i] == ']')
+					i++;
+				while (i < pat_len && pat[i] != ']')
+				{
+					/* skip [:class:], [.coll.] and [=equiv=] elements */
+					if (pat[i] == '[' && i + 1 < pat_len &&
+						(pat[i + 1] == ':' || pat[i + 1] == '.' ||
+						 pat[i + 1] == '='))
+					{
+						char		delim = pat[i + 1];
+
+						i += 2;
+						while (i + 1 < pat_len &&
+							   !(pat[i] == delim && pat[i + 1] == ']'))
+							i++;
+						i += 2;
+					}
+					else
+						i++;
+				}
+				i++;
+				break;
+
+			case '\\':
+				CLOSE_RUN(i);
+				if (i + 1 < pat_len && !IS_HIGHBIT_SET(pat[i + 1]) &&
+					!isalnum((unsigned char) pat[i + 1]))
+				{
+					/*
+					 * An escaped punctuation character stands for itself, so
+					 * it can start a new run.
+					 */
+					run_start = last_char = i + 1;
+					i += 2;
+					break;
+				}
+				/* a class escape, constraint escape, backref etc; give up */
+				goto done;
+
+			case '.':
+			case '^':
+			case '$':
+				CLOSE_RUN(i);
+				i++;
+				break;
+
+			default:
+				/* an ordinary character, possibly multibyte */
+				if (last_char < 0)
+					run_start = i;
+				last_char = i;
+				i += pg_mblen(pat + i);
+				break;
+		}
+	}
+
+	CLOSE_RUN(Min(i, pat_len));
+
+done:
+#undef CLOSE_RUN
+	return;
+}
+
+/*
+ * RE_contains_literal - does the data string contain the given literal?
+ */
+static bool
+RE_contains_literal(const char *dat, int dat_len, const char *lit, int lit_len)
+{
+	const char *p = dat;
+	const char *last;
+
+	if (dat_len < lit_len)
+		return false;
+
+	last = dat + dat_len - lit_len;
+	while (p <= last)
+	{
+		p = memchr(p, lit[0], last - p + 1);
+		if (p == NULL)
+			return false;
+		if (memcmp(p + 1, lit + 1, lit_len - 1) == 0)
+			return true;
+		p++;
+	}
+
+	return false;
 }
 
 /*
@@ -344,12 +562,18 @@ RE_compile_and_execute(text *text_re, char *dat, int dat_len,
 					   int cflags, Oid collation,
 					   int nmatch, regmatch_t *pmatch)
 {
-	regex_t    *re;
+	cached_re_str *cre;
 
 	/* Compile RE */
-	re = RE_compile_and_cache(text_re, cflags, collation);
+	cre = RE_compile_and_cache_entry(text_re, cflags, collation);
+
+	/* Quickly rule out data that lacks a literal every match contains */
+	if (cre->cre_lit_len > 0 &&
+		!RE_contains_literal(dat, dat_len, cre->cre_pat + cre->cre_lit_off,
+							 cre->cre_lit_len))
+		return false;
 
-	return RE_execute(re, dat, dat_len, nmatch, pmatch);
+	return RE_execute(&cre->cre_re, dat, dat_len, nmatch, pmatch);
 }
 
 
@@ -30,9 +30,13 @@
 
 #include "postgres.h"
 
+#include "access/genam.h"
+#include "access/heapam.h"
 #include "access/htup_details.h"
+#include "access/stratnum.h"
 #include "access/sysattr.h"
 #include "access/xact.h"
+#include "catalog/pg_am.h"
 #include "catalog/pg_collation.h"
 #include "catalog/pg_constraint.h"
 #include "catalog/pg_operator.h"
@@ -47,6 +51,7 @@
 #include "storage/bufmgr.h"
 #include "utils/acl.h"
 #include "utils/builtins.h"
+#include "utils/datum.h"
 #include "utils/fmgroids.h"
 #include "utils/guc.h"
 #include "utils/inval.h"
@@ -77,13 +82,17 @@
 /* these queries are executed against the PK (referenced) table: */
 #define RI_PLAN_CHECK_LOOKUPPK			1
 #define RI_PLAN_CHECK_LOOKUPPK_FROM_PK	2
-#define RI_PLAN_LAST_ON_PK				RI_PLAN_CHECK_LOOKUPPK_FROM_PK
+#define RI_PLAN_CHECK_LOOKUPPK_BATCH	3
+#define RI_PLAN_LAST_ON_PK				RI_PLAN_CHECK_LOOKUPPK_BATCH
 /* these queries are executed against the FK (referencing) table: */
-#define RI_PLAN_CASCADE_DEL_DODELETE	3
-#define RI_PLAN_CASCADE_UPD_DOUPDATE	4
-#define RI_PLAN_RESTRICT_CHECKREF		5
-#define RI_PLAN_SETNULL_DOUPDATE		6
-#define RI_PLAN_SETDEFAULT_DOUPDATE		7
+#define RI_PLAN_CASCADE_DEL_DODELETE	4
+#define RI_PLAN_CASCADE_UPD_DOUPDATE	5
+#define RI_PLAN_RESTRICT_CHECKREF		6
+#define RI_PLAN_SETNULL_DOUPDATE		7
+#define RI_PLAN_SETDEFAULT_DOUPDATE		8
+
+/* max number of FK rows whose keys are looked up by one batched query */
+#define RI_CHECK_BATCH_SIZE				1024
 
 #define MAX_QUOTED_NAME_LEN  (NAMEDATALEN*2+3)
 #define MAX_QUOTED_REL_NAME_LEN  (MAX_QUOTED_NAME_LEN*2)
@@ -112,6 +121,7 @@ typedef struct RI_ConstraintInfo
 	NameData	conname;		/* name of the FK constraint */
 	Oid			pk_relid;		/* referenced relation */
 	Oid			fk_relid;		/* referencing relation */
+	Oid			conindid;		/* index on the referenced columns */
 	char		confupdtype;	/* foreign key's ON UPDATE action */
 	char		confdeltype;	/* foreign key's ON DELETE action */
 	char		confmatchtype;	/* foreign key's match type */
@@ -175,6 +185,32 @@ typedef struct RI_CompareHashEntry
 } RI_CompareHashEntry;
 
 
+/* ----------
+ * RI_PendingCheck
+ *
+ *	Keys of FK rows that RI_FKey_check has queued up to be looked up in the
+ *	PK table all at once.  There is one of these per constraint, FK relation
+ *	and subtransaction level; they live in ri_pending_cxt until the end of
+ *	the transaction so they can be reused, and are empty except while after
+ *	triggers are being fired.
+ * ----------
+ */
+typedef struct RI_PendingCheck
+{
+	Oid			constraint_id;	/* OID of pg_constraint entry */
+	Oid			fk_relid;		/* relation the queued rows are in */
+	int			nestLevel;		/* subtransaction level they were queued at */
+	int			nrows;			/* number of rows queued */
+	Oid			elemtypes[RI_MAX_NUMKEYS];	/* FK column types, less domains */
+	int16		typlens[RI_MAX_NUMKEYS];
+	bool		typbyvals[RI_MAX_NUMKEYS];
+	char		typaligns[RI_MAX_NUMKEYS];
+	Datum	   *vals[RI_MAX_NUMKEYS];	/* queued values, per key column */
+	MemoryContext valcxt;		/* holds copies of by-reference values */
+	dlist_node	link;			/* link in ri_pending_checks */
+} RI_PendingCheck;
+
+
 /* ----------
  * Local data
  * ----------
@@ -184,6 +220,8 @@ static HTAB *ri_query_cache = NULL;
 static HTAB *ri_compare_cache = NULL;
 static dlist_head ri_constraint_cache_valid_list;
 static int	ri_constraint_cache_valid_count = 0;
+static MemoryContext ri_pending_cxt = NULL;
+static dlist_head ri_pending_checks = DLIST_STATIC_INIT(ri_pending_checks);
 
 
 /* ----------
@@ -240,6 +278,13 @@ static void ri_ReportViolation(const RI_ConstraintInfo *riinfo,
 				   Relation pk_rel, Relation fk_rel,
 				   HeapTuple violator, TupleDesc tupdesc,
 				   int queryno) pg_attribute_noreturn();
+static bool ri_ReferencedKeyExists(const RI_ConstraintInfo *riinfo,
+					   Relation fk_rel, Relation pk_rel,
+					   HeapTuple new_row, bool *found);
+static bool ri_UpdateChainMovedPartitions(Relation rel, ItemPointer ctid);
+static bool ri_QueueCheck(const RI_ConstraintInfo *riinfo,
+			  Relation fk_rel, HeapTuple new_row);
+static void ri_PerformPendingCheck(RI_PendingCheck *pending);
 
 
 /* ----------
@@ -258,6 +303,7 @@ RI_FKey_check(TriggerData *trigdata)
 	Buffer		new_row_buf;
 	RI_QueryKey qkey;
 	SPIPlanPtr	qplan;
+	bool		found;
 	int			i;
 
 	/*
@@ -381,6 +427,36 @@ RI_FKey_check(TriggerData *trigdata)
 			break;
 	}
 
+	/*
+	 * If we can, probe the PK table's unique index for the key directly.
+	 * That's a good deal cheaper than running even a cached query through
+	 * SPI and the executor.
+	 */
+	if (ri_ReferencedKeyExists(riinfo, fk_rel, pk_rel, new_row, &found))
+	{
+		if (!found)
+			ri_ReportViolation(riinfo,
+							   pk_rel, fk_rel,
+							   new_row,
+							   NULL,
+							   RI_PLAN_CHECK_LOOKUPPK);
+
+		heap_close(pk_rel, RowShareLock);
+		return PointerGetDatum(NULL);
+	}
+
+	/*
+	 * Otherwise, rather than looking the key up right away, queue it up if we
+	 * can.  The keys of all the rows checked while firing this batch of
+	 * after-trigger events are then looked up in a few set-oriented queries,
+	 * saving the SPI overhead of a query per row.
+	 */
+	if (ri_QueueCheck(riinfo, fk_rel, new_row))
+	{
+		heap_close(pk_rel, RowShareLock);
+		return PointerGetDatum(NULL);
+	}
+
 	if (SPI_connect() != SPI_OK_CONNECT)
 		elog(ERROR, "SPI_connect failed");
 
@@ -450,6 +526,566 @@ RI_FKey_check(TriggerData *trigdata)
 }
 
 
+/* ----------
+ * ri_ReferencedKeyExists -
+ *
+ *	Look up the key of new_row by probing the PK table's unique index
+ *	directly, and lock the row found FOR KEY SHARE, the way the
+ *	RI_PLAN_CHECK_LOOKUPPK query would.  *found is set to whether the key
+ *	exists.  The key must not contain any nulls.
+ *
+ *	This only works if the index is a btree, and for each key column the
+ *	constraint's equality operator belongs to the index column's operator
+ *	family and takes the FK column's type as is.  If not, returns false
+ *	without looking, and the caller has to use a query.
+ * ----------
+ */
+static bool
+ri_ReferencedKeyExists(const RI_ConstraintInfo *riinfo,
+					   Relation fk_rel, Relation pk_rel,
+					   HeapTuple new_row, bool *found)
+{
+	Relation	idxrel;
+	ScanKeyData skey[RI_MAX_NUMKEYS];
+	IndexScanDesc scan;
+	HeapTuple	tuple;
+	int			nkeys;
+	int			i,
+				j;
+
+	if (!OidIsValid(riinfo->conindid))
+		return false;
+
+	idxrel = index_open(riinfo->conindid, AccessShareLock);
+	nkeys = IndexRelationGetNumberOfKeyAttributes(idxrel);
+
+	if (idxrel->rd_rel->relam != BTREE_AM_OID || nkeys != riinfo->nkeys)
+	{
+		index_close(idxrel, NoLock);
+		return false;
+	}
+
+	/* Build a scan key for each index column, from the matching FK column */
+	for (j = 0; j < nkeys; j++)
+	{
+		Oid			eq_opr;
+		Oid			lefttype;
+		Oid			righttype;
+		Oid			fk_type;
+		Datum		value;
+		bool		isnull;
+
+		for (i = 0; i < riinfo->nkeys; i++)
+		{
+			if (riinfo->pk_attnums[i] == idxrel->rd_index->indkey.values[j])
+				break;
+		}
+		if (i >= riinfo->nkeys)
+		{
+			index_close(idxrel, NoLock);
+			return false;
+		}
+
+		eq_opr = riinfo->pf_eq_oprs[i];
+		op_input_types(eq_opr, &lefttype, &righttype);
+		fk_type = RIAttType(fk_rel, riinfo->fk_attnums[i]);
+
+		if (get_op_opfamily_strategy(eq_opr, idxrel->rd_opfamily[j]) !=
+			BTEqualStrategyNumber ||
+			lefttype != idxrel->rd_opcintype[j] ||
+			(fk_type != righttype && !IsBinaryCoercible(fk_type, righttype)))
+		{
+			index_close(idxrel, NoLock);
+			return false;
+		}
+
+		value = heap_getattr(new_row, riinfo->fk_attnums[i],
+							 RelationGetDescr(fk_rel), &isnull);
+		Assert(!isnull);
+
+		ScanKeyEntryInitialize(&skey[j],
+							   0,
+							   j + 1,
+							   BTEqualStrategyNumber,
+							   righttype,
+							   idxrel->rd_indcollation[j],
+							   get_opcode(eq_opr),
+							   value);
+	}
+
+	/*
+	 * Take a snapshot the same way SPI would for the query, so that we see
+	 * the work of our own transaction up to now.
+	 */
+	PushActiveSnapshot(GetTransactionSnapshot());
+	CommandCounterIncrement();
+	UpdateActiveSnapshotCommandId();
+
+	for (;;)
+	{
+		HeapTupleData locktup;
+		Buffer		buf;
+		HeapUpdateFailureData hufd;
+		HTSU_Result res;
+
+		*found = false;
+
+		scan = index_beginscan(pk_rel, idxrel, GetActiveSnapshot(), nkeys, 0);
+		index_rescan(scan, skey, nkeys, NULL, 0);
+		tuple = index_getnext(scan, ForwardScanDirection);
+		if (tuple != NULL)
+			ItemPointerCopy(&tuple->t_self, &locktup.t_self);
+		index_endscan(scan);
+
+		if (tuple == NULL)
+			break;
+
+		res = heap_lock_tuple(pk_rel, &locktup, GetCurrentCommandId(false),
+							  LockTupleKeyShare,
+							  LockWaitBlock,
+							  true /* follow updates */ ,
+							  &buf, &hufd);
+		ReleaseBuffer(buf);
+
+		switch (res)
+		{
+			case HeapTupleMayBeUpdated:
+				*found = true;
+				break;
+
+			case HeapTupleSelfUpdated:
+
+				/*
+				 * Updated or deleted by our own transaction after the
+				 * snapshot was taken; like nodeLockRows.c, treat the row as
+				 * gone.
+				 */
+				break;
+
+			case HeapTupleUpdated:
+				if (IsolationUsesXactSnapshot())
+					ereport(ERROR,
+							(errcode(ERRCODE_T_R_SERIALIZATION_FAILURE),
+							 errmsg("could not serialize access due to concurrent update")));
+				if (ri_UpdateChainMovedPartitions(pk_rel, &hufd.ctid))
+					ereport(ERROR,
+							(errcode(ERRCODE_T_R_SERIALIZATION_FAILURE),
+							 errmsg("tuple to be locked was already moved to another partition due to concurrent update")));
+
+				/*
+				 * The key was changed or the row deleted by a transaction
+				 * that has committed since our snapshot was taken.  Much as
+				 * EvalPlanQual would recheck the latest version of the row,
+				 * look again with a new snapshot.
+				 */
+				PopActiveSnapshot();
+				PushActiveSnapshot(GetLatestSnapshot());
+				continue;
+
+			case HeapTupleInvisible:
+				elog(ERROR, "attempted to lock invisible tuple");
+				break;
+
+			default:
+				elog(ERROR, "unexpected heap_lock_tuple status: %u", res);
+				break;
+		}
+		break;
+	}
+
+	PopActiveSnapshot();
+
+	/* Keep the lock on the index till end of transaction. */
+	index_close(idxrel, NoLock);
+
+	return true;
+}
+
+/* ----------
+ * ri_UpdateChainMovedPartitions -
+ *
+ *	Follow the update chain starting at ctid, the successor of a row that
+ *	heap_lock_tuple reported as concurrently updated, and report whether
+ *	the row was eventually moved to another partition.  EvalPlanQualFetch
+ *	walks the chain the same way before it gives up on the row.
+ * ----------
+ */
+static bool
+ri_UpdateChainMovedPartitions(Relation rel, ItemPointer ctid)
+{
+	ItemPointerData cur = *ctid;
+	TransactionId priorXmax = InvalidTransactionId;
+
+	for (;;)
+	{
+		HeapTupleData tuple;
+		Buffer		buf;
+		bool		moved;
+		bool		last;
+
+		if (ItemPointerIndicatesMovedPartitions(&cur))
+			return true;
+
+		tuple.t_self = cur;
+		if (!heap_fetch(rel, SnapshotAny, &tuple, &buf, false, NULL))
+			return false;
+
+		/* a recycled line pointer means the chain is broken here */
+		if (TransactionIdIsValid(priorXmax) &&
+			!TransactionIdEquals(priorXmax,
+								 HeapTupleHeaderGetXmin(tuple.t_data)))
+		{
+			ReleaseBuffer(buf);
+			return false;
+		}
+
+		moved = HeapTupleHeaderIndicatesMovedPartitions(tuple.t_data);
+		last = ItemPointerEquals(&tuple.t_self, &tuple.t_data->t_ctid) ||
+			(tuple.t_data->t_infomask & HEAP_XMAX_INVALID) != 0 ||
+			HeapTupleHeaderIsOnlyLocked(tuple.t_data);
+		priorXmax = HeapTupleHeaderGetUpdateXid(tuple.t_data);
+		cur = tuple.t_data->t_ctid;
+		ReleaseBuffer(buf);
+
+		if (moved)
+			return true;
+		if (last)
+			return false;
+	}
+}
+
+/* ----------
+ * ri_QueueCheck -
+ *
+ *	Queue up the key of new_row to be looked up in the PK table later, by
+ *	RI_FlushPendingChecks or once enough keys have been queued.  The key
+ *	must not contain any nulls.  Returns false if the key can't be queued,
+ *	in which case the caller must check it right away.
+ * ----------
+ */
+static bool
+ri_QueueCheck(const RI_ConstraintInfo *riinfo, Relation fk_rel,
+			  HeapTuple new_row)
+{
+	RI_PendingCheck *pending = NULL;
+	int			nestLevel = GetCurrentTransactionNestLevel();
+	MemoryContext oldcxt;
+	dlist_iter	iter;
+	int			i;
+
+	dlist_foreach(iter, &ri_pending_checks)
+	{
+		RI_PendingCheck *p = dlist_container(RI_PendingCheck, link, iter.cur);
+
+		if (p->constraint_id == riinfo->constraint_id &&
+			p->fk_relid == RelationGetRelid(fk_rel) &&
+			p->nestLevel == nestLevel)
+		{
+			pending = p;
+			break;
+		}
+	}
+
+	if (pending == NULL)
+	{
+		Oid			elemtypes[RI_MAX_NUMKEYS];
+
+		/* The values of each key column are passed in as an array */
+		for (i = 0; i < riinfo->nkeys; i++)
+		{
+			elemtypes[i] = getBaseType(RIAttType(fk_rel,
+												 riinfo->fk_attnums[i]));
+			if (!OidIsValid(get_array_type(elemtypes[i])))
+				return false;
+		}
+
+		if (ri_pending_cxt == NULL)
+			ri_pending_cxt = AllocSetContextCreate(TopTransactionContext,
+												   "RI pending checks",
+												   ALLOCSET_DEFAULT_SIZES);
+
+		pending = (RI_PendingCheck *)
+			MemoryContextAllocZero(ri_pending_cxt, sizeof(RI_PendingCheck));
+		pending->constraint_id = riinfo->constraint_id;
+		pending->fk_relid = RelationGetRelid(fk_rel);
+		pending->nestLevel = nestLevel;
+		for (i = 0; i < riinfo->nkeys; i++)
+		{
+			pending->elemtypes[i] = elemtypes[i];
+			get_typlenbyvalalign(elemtypes[i], &pending->typlens[i],
+								 &pending->typbyvals[i],
+								 &pending->typaligns[i]);
+			pending->vals[i] = (Datum *)
+				MemoryContextAlloc(ri_pending_cxt,
+								   sizeof(Datum) * RI_CHECK_BATCH_SIZE);
+		}
+		pending->valcxt = AllocSetContextCreate(ri_pending_cxt,
+												"RI pending check values",
+												ALLOCSET_DEFAULT_SIZES);
+		dlist_push_tail(&ri_pending_checks, &pending->link);
+	}
+
+	oldcxt = MemoryContextSwitchTo(pending->valcxt);
+	for (i = 0; i < riinfo->nkeys; i++)
+	{
+		Datum		value;
+		bool		isnull;
+
+		value = heap_getattr(new_row, riinfo->fk_attnums[i],
+							 RelationGetDescr(fk_rel), &isnull);
+		Assert(!isnull);
+		pending->vals[i][pending->nrows] =
+			datumCopy(value, pending->typbyvals[i], pending->typlens[i]);
+	}
+	MemoryContextSwitchTo(oldcxt);
+
+	if (++pending->nrows >= RI_CHECK_BATCH_SIZE)
+		ri_PerformPendingCheck(pending);
+
+	return true;
+}
+
+/* ----------
+ * ri_PerformPendingCheck -
+ *
+ *	Look up all the keys queued in pending, and empty it.
+ * ----------
+ */
+static void
+ri_PerformPendingCheck(RI_PendingCheck *pending)
+{
+	const RI_ConstraintInfo *riinfo;
+	Relation	fk_rel;
+	Relation	pk_rel;
+	RI_QueryKey qkey;
+	SPIPlanPtr	qplan;
+	Datum		vals[RI_MAX_NUMKEYS];
+	char		nulls[RI_MAX_NUMKEYS];
+	int			spi_result;
+	Oid			save_userid;
+	int			save_sec_context;
+	int			i;
+
+	riinfo = ri_LoadConstraintInfo(pending->constraint_id);
+
+	/* We already hold suitable locks on both tables, from RI_FKey_check */
+	fk_rel = heap_open(pending->fk_relid, NoLock);
+	pk_rel = heap_open(riinfo->pk_relid, RowShareLock);
+
+	if (SPI_connect() != SPI_OK_CONNECT)
+		elog(ERROR, "SPI_connect failed");
+
+	/*
+	 * Fetch or prepare a saved plan for the check
+	 */
+	ri_BuildQueryKey(&qkey, riinfo, RI_PLAN_CHECK_LOOKUPPK_BATCH);
+
+	if ((qplan = ri_FetchPreparedPlan(&qkey)) == NULL)
+	{
+		StringInfoData querybuf;
+		char		pkrelname[MAX_QUOTED_REL_NAME_LEN];
+		char		attname[MAX_QUOTED_NAME_LEN];
+		char		colname[16];
+		const char *querysep;
+		Oid			queryoids[RI_MAX_NUMKEYS];
+
+		/* ----------
+		 * The query string built is
+		 *	SELECT fk.k1 [, ...]
+		 *		   FROM ROWS FROM (pg_catalog.unnest($1) [, ...]) fk (k1 [, ...])
+		 *		   WHERE NOT EXISTS (SELECT 1 FROM ONLY <pktable> x
+		 *							 WHERE pkatt1 = fk.k1 [AND ...]
+		 *							 FOR KEY SHARE OF x)
+		 * The type id's for the $ parameters are arrays of the
+		 * corresponding FK attributes' types, with domains looked through.
+		 * The query returns the keys that are not present in the PK table.
+		 * ----------
+		 */
+		initStringInfo(&querybuf);
+		appendStringInfoString(&querybuf, "SELECT ");
+		for (i = 0; i < riinfo->nkeys; i++)
+			appendStringInfo(&querybuf, "%sfk.k%d", i > 0 ? ", " : "", i + 1);
+		appendStringInfoString(&querybuf, " FROM ROWS FROM (");
+		for (i = 0; i < riinfo->nkeys; i++)
+		{
+			appendStringInfo(&querybuf, "%spg_catalog.unnest($%d)",
+							 i > 0 ? ", " : "", i + 1);
+			queryoids[i] = get_array_type(pending->elemtypes[i]);
+		}
+		appendStringInfoString(&querybuf, ") fk (");
+		for (i = 0; i < riinfo->nkeys; i++)
+			appendStringInfo(&querybuf, "%sk%d", i > 0 ? ", " : "", i + 1);
+		quoteRelationName(pkrelname, pk_rel);
+		appendStringInfo(&querybuf,
+						 ") WHERE NOT EXISTS (SELECT 1 FROM ONLY %s x",
+						 pkrelname);
+		querysep = "WHERE";
+		for (i = 0; i < riinfo->nkeys; i++)
+		{
+			Oid			pk_type = RIAttType(pk_rel, riinfo->pk_attnums[i]);
+
+			quoteOneName(attname,
+						 RIAttName(pk_rel, riinfo->pk_attnums[i]));
+			sprintf(colname, "fk.k%d", i + 1);
+			ri_GenerateQual(&querybuf, querysep,
+							attname, pk_type,
+							riinfo->pf_eq_oprs[i],
+							colname, pending->elemtypes[i]);
+			querysep = "AND";
+		}
+		appendStringInfoString(&querybuf, " FOR KEY SHARE OF x)");
+
+		/* Prepare and save the plan */
+		qplan = ri_PlanCheck(querybuf.data, riinfo->nkeys, queryoids,
+							 &qkey, fk_rel, pk_rel, true);
+	}
+
+	/* Pass the queued values of each key column in as an array */
+	for (i = 0; i < riinfo->nkeys; i++)
+	{
+		vals[i] = PointerGetDatum(construct_array(pending->vals[i],
+												  pending->nrows,
+												  pending->elemtypes[i],
+												  pending->typlens[i],
+												  pending->typbyvals[i],
+												  pending->typaligns[i]));
+		nulls[i] = ' ';
+	}
+
+	/*
+	 * Run the query as the PK table's owner, the same way ri_PerformCheck
+	 * does.  We only need to know about one missing key.
+	 */
+	GetUserIdAndSecContext(&save_userid, &save_sec_context);
+	SetUserIdAndSecContext(RelationGetForm(pk_rel)->relowner,
+						   save_sec_context | SECURITY_LOCAL_USERID_CHANGE |
+						   SECURITY_NOFORCE_RLS);
+
+	spi_result = SPI_execute_snapshot(qplan,
+									  vals, nulls,
+									  InvalidSnapshot, InvalidSnapshot,
+									  false, false, 1);
+
+	SetUserIdAndSecContext(save_userid, save_sec_context);
+
+	if (spi_result < 0)
+		elog(ERROR, "SPI_execute_snapshot returned %s", SPI_result_code_string(spi_result));
+
+	if (spi_result != SPI_OK_SELECT)
+		ereport(ERROR,
+				(errcode(ERRCODE_INTERNAL_ERROR),
+				 errmsg("referential integrity query on \"%s\" from constraint \"%s\" on \"%s\" gave unexpected result",
+						RelationGetRelationName(pk_rel),
+						NameStr(riinfo->conname),
+						RelationGetRelationName(fk_rel)),
+				 errhint("This is most likely due to a rule having rewritten the query.")));
+
+	if (SPI_processed > 0)
+	{
+		TupleDesc	fk_tupdesc = RelationGetDescr(fk_rel);
+		Datum	   *values;
+		bool	   *isnull;
+
+		/*
+		 * Report the missing key as coming from an FK row; the key columns
+		 * are all ri_ReportViolation looks at.
+		 */
+		values = (Datum *) palloc0(fk_tupdesc->natts * sizeof(Datum));
+		isnull = (bool *) palloc(fk_tupdesc->natts * sizeof(bool));
+		memset(isnull, true, fk_tupdesc->natts * sizeof(bool));
+		for (i = 0; i < riinfo->nkeys; i++)
+		{
+			int			attno = riinfo->fk_attnums[i] - 1;
+
+			values[attno] = SPI_getbinval(SPI_tuptable->vals[0],
+										  SPI_tuptable->tupdesc,
+										  i + 1, &isnull[attno]);
+		}
+
+		ri_ReportViolation(riinfo, pk_rel, fk_rel,
+						   heap_form_tuple(fk_tupdesc, values, isnull),
+						   NULL,
+						   RI_PLAN_CHECK_LOOKUPPK);
+	}
+
+	if (SPI_finish() != SPI_OK_FINISH)
+		elog(ERROR, "SPI_finish failed");
+
+	heap_close(pk_rel, RowShareLock);
+	heap_close(fk_rel, NoLock);
+
+	pending->nrows = 0;
+	MemoryContextReset(pending->valcxt);
+}
+
+/* ----------
+ * RI_FlushPendingChecks -
+ *
+ *	Look up the keys RI_FKey_check has queued up at the current
+ *	subtransaction level, or deeper.  Called once a batch of after-trigger
+ *	events has been fired.
+ * ----------
+ */
+void
+RI_FlushPendingChecks(void)
+{
+	int			nestLevel = GetCurrentTransactionNestLevel();
+	dlist_iter	iter;
+
+	dlist_foreach(iter, &ri_pending_checks)
+	{
+		RI_PendingCheck *pending = dlist_container(RI_PendingCheck, link,
+												   iter.cur);
+
+		if (pending->nrows > 0 && pending->nestLevel >= nestLevel)
+			ri_PerformPendingCheck(pending);
+	}
+}
+
+/* ----------
+ * RI_DiscardPendingChecks -
+ *
+ *	Forget about keys queued up at subtransaction level nestLevel or deeper,
+ *	at the end of the (sub)transaction.  Normally there are none, but an
+ *	error may have kept them from being looked up.
+ * ----------
+ */
+void
+RI_DiscardPendingChecks(int nestLevel)
+{
+	dlist_mutable_iter iter;
+
+	if (ri_pending_cxt == NULL)
+		return;
+
+	/* At the end of the top-level transaction, just throw it all away */
+	if (nestLevel <= 1)
+	{
+		MemoryContextDelete(ri_pending_cxt);
+		ri_pending_cxt = NULL;
+		dlist_init(&ri_pending_checks);
+		return;
+	}
+
+	dlist_foreach_modify(iter, &ri_pending_checks)
+	{
+		RI_PendingCheck *pending = dlist_container(RI_PendingCheck, link,
+												   iter.cur);
+
+		if (pending->nestLevel >= nestLevel)
+		{
+			int			i;
+
+			dlist_delete(iter.cur);
+			MemoryContextDelete(pending->valcxt);
+			for (i = 0; i < RI_MAX_NUMKEYS && pending->vals[i] != NULL; i++)
+				pfree(pending->vals[i]);
+			pfree(pending);
+		}
+	}
+}
+
+
 /* ----------
  * RI_FKey_check_ins -
  *
@@ -2229,6 +2865,7 @@ ri_LoadConstraintInfo(Oid constraintOid)
 	memcpy(&riinfo->conname, &conForm->conname, sizeof(NameData));
 	riinfo->pk_relid = conForm->confrelid;
 	riinfo->fk_relid = conForm->conrelid;
+	riinfo->conindid = conForm->conindid;
 	riinfo->confupdtype = conForm->confupdtype;
 	riinfo->confdeltype = conForm->confdeltype;
 	riinfo->confmatchtype = conForm->confmatchtype;
@@ -130,6 +130,7 @@
 #include "parser/parse_coerce.h"
 #include "parser/parsetree.h"
 #include "statistics/statistics.h"
+#include "utils/actualrangecache.h"
 #include "utils/acl.h"
 #include "utils/builtins.h"
 #include "utils/bytea.h"
@@ -584,6 +585,81 @@ scalarineqsel(PlannerInfo *root, Oid operator, bool isgt, bool iseq,
 
 	if (!HeapTupleIsValid(vardata->statsTuple))
 	{
+		/*
+		 * There are no stats for system columns, but for CTID we can estimate
+		 * based on table size.
+		 */
+		if (vardata->var && IsA(vardata->var, Var) &&
+			((Var *) vardata->var)->varattno == SelfItemPointerAttributeNumber &&
+			consttype == TIDOID && vardata->rel)
+		{
+			ItemPointer itemptr;
+			double		block;
+			double		density;
+
+			/*
+			 * If the relation's empty, we're going to include all of it.
+			 * (This is mostly to avoid divide-by-zero below.)
+			 */
+			if (vardata->rel->pages == 0)
+				return 1.0;
+
+			itemptr = (ItemPointer) DatumGetPointer(constval);
+			block = ItemPointerGetBlockNumberNoCheck(itemptr);
+
+			/*
+			 * Determine the average number of tuples per page (density).
+			 *
+			 * Since the last page will, on average, be only half full, we can
+			 * estimate it to have half as many tuples as earlier pages.  So
+			 * give it half the weight of a regular page.
+			 */
+			density = vardata->rel->tuples / (vardata->rel->pages - 0.5);
+
+			/* If target is the last page, use half the density. */
+			if (block >= vardata->rel->pages - 1)
+				density *= 0.5;
+
+			/*
+			 * Using the average tuples per page, calculate how far into the
+			 * page the itemptr is likely to be and adjust block accordingly,
+			 * by adding that fraction of a whole block (but never more than a
+			 * whole block, no matter how high the itemptr's offset is).  Here
+			 * we are ignoring the possibility of dead-tuple line pointers,
+			 * which is fairly bogus, but we lack the info to do better.
+			 */
+			if (density > 0.0)
+			{
+				OffsetNumber offset = ItemPointerGetOffsetNumberNoCheck(itemptr);
+
+				block += Min(offset / density, 1.0);
+			}
+
+			/*
+			 * Convert relative block number to selectivity.  Again, the last
+			 * page has only half weight.
+			 */
+			selec = block / (vardata->rel->pages - 0.5);
+
+			/*
+			 * The calculation so far gave us a selectivity for the "<=" case.
+			 * We'll have one fewer tuple for "<" and one additional tuple for
+			 * ">=", the latter of which we'll reverse the selectivity for
+			 * below, so we can simply subtract one tuple for both cases.  The
+			 * cases that need this adjustment can be identified by iseq being
+			 * equal to isgt.
+			 */
+			if (iseq == isgt && vardata->rel->tuples >= 1.0)
+				selec -= (1.0 / vardata->rel->tuples);
+
+			/* Finally, reverse the selectivity for the ">", ">=" cases. */
+			if (isgt)
+				selec = 1.0 - selec;
+
+			CLAMP_PROBABILITY(selec);
+			return selec;
+		}
+
 		/* no stats available, so default result */
 		return DEFAULT_INEQ_SEL;
 	}
@@ -771,6 +847,81 @@ histogram_selectivity(VariableStatData *vardata, FmgrInfo *opproc,
 	return result;
 }
 
+/*
+ *	get_sort_histogram_bounds	- Sample the values of an expression
+ *
+ * Returns the expression's histogram bounds as a list of Consts, in the
+ * order given by the btree ordering operator sortop (which may be a ">"
+ * operator), or NIL if there is no suitable histogram.  The histogram must
+ * have been computed using the given collation.
+ *
+ * The histogram excludes the most common values and nulls, but it is still
+ * a reasonable sample for choosing the boundaries between ranges of the
+ * sorted data, which is what the result is used for.
+ */
+List *
+get_sort_histogram_bounds(PlannerInfo *root, Node *expr, Oid sortop,
+						  Oid collation)
+{
+	VariableStatData vardata;
+	Oid			opfamily;
+	Oid			opcintype;
+	int16		strategy;
+	Oid			ltop;
+	AttStatsSlot sslot;
+	List	   *result = NIL;
+
+	if (!get_ordering_op_properties(sortop, &opfamily, &opcintype, &strategy))
+		return NIL;
+	ltop = get_opfamily_member(opfamily, opcintype, opcintype,
+							   BTLessStrategyNumber);
+	if (!OidIsValid(ltop))
+		return NIL;
+
+	examine_variable(root, expr, 0, &vardata);
+
+	if (HeapTupleIsValid(vardata.statsTuple) &&
+		statistic_proc_security_check(&vardata, get_opcode(ltop)) &&
+		get_attstatsslot(&sslot, vardata.statsTuple,
+						 STATISTIC_KIND_HISTOGRAM, ltop,
+						 ATTSTATSSLOT_VALUES))
+	{
+		/*
+		 * The bounds must be in the sort's own order.  A non-collatable key
+		 * has no collation to match; get_attstatsslot() reports the default
+		 * collation for it.
+		 */
+		if (!OidIsValid(collation) || sslot.stacoll == collation)
+		{
+			int16		typLen;
+			bool		typByVal;
+			int			i;
+
+			get_typlenbyval(sslot.valuetype, &typLen, &typByVal);
+
+			for (i = 0; i < sslot.nvalues; i++)
+			{
+				Const	   *con;
+
+				con = makeConst(sslot.valuetype, -1, collation, typLen,
+								datumCopy(sslot.values[i], typByVal, typLen),
+								false, typByVal);
+
+				/* Build the list in reverse order for a descending sort */
+				if (strategy == BTGreaterStrategyNumber)
+					result = lcons(con, result);
+				else
+					result = lappend(result, con);
+			}
+		}
+		free_attstatsslot(&sslot);
+	}
+
+	ReleaseVariableStats(vardata);
+
+	return result;
+}
+
 /*
  *	ineq_histogram_selectivity	- Examine the histogram for scalarineqsel
  *
@@ -5534,6 +5685,11 @@ get_actual_variable_range(PlannerInfo *root, VariableStatData *vardata,
 			Datum		values[INDEX_MAX_KEYS];
 			bool		isnull[INDEX_MAX_KEYS];
 			SnapshotData SnapshotNonVacuumable;
+			bool		min_last = ScanDirectionIsBackward(indexscandir);
+			bool		min_cached = false;
+			bool		max_cached = false;
+			uint64		min_generation = 0;
+			uint64		max_generation = 0;
 
 			estate = CreateExecutorState();
 			econtext = GetPerTupleExprContext(estate);
@@ -5571,8 +5727,25 @@ get_actual_variable_range(PlannerInfo *root, VariableStatData *vardata,
 
 			have_data = true;
 
-			/* If min is requested ... */
+			/*
+			 * Use the endpoints other backends found recently, if allowed.
+			 * Since the index is ordered in the direction of our sort
+			 * operator, the minimum is at its start unless it's scanned
+			 * backwards.
+			 */
+			MemoryContextSwitchTo(oldcontext);
 			if (min)
+				min_cached = ActualRangeCacheLookup(indexRel, min_last,
+													typLen, typByVal,
+													min, &min_generation);
+			if (max)
+				max_cached = ActualRangeCacheLookup(indexRel, !min_last,
+													typLen, typByVal,
+													max, &max_generation);
+			MemoryContextSwitchTo(tmpcontext);
+
+			/* If min is requested ... */
+			if (min && !min_cached)
 			{
 				/*
 				 * In principle, we should scan the index with our current
@@ -5623,6 +5796,10 @@ get_actual_variable_range(PlannerInfo *root, VariableStatData *vardata,
 					MemoryContextSwitchTo(oldcontext);
 					*min = datumCopy(values[0], typByVal, typLen);
 					MemoryContextSwitchTo(tmpcontext);
+
+					ActualRangeCacheStore(indexRel, min_last,
+										  typLen, typByVal,
+										  *min, min_generation);
 				}
 				else
 					have_data = false;
@@ -5631,7 +5808,7 @@ get_actual_variable_range(PlannerInfo *root, VariableStatData *vardata,
 			}
 
 			/* If max is requested, and we didn't find the index is empty */
-			if (max && have_data)
+			if (max && have_data && !max_cached)
 			{
 				index_scan = index_beginscan(heapRel, indexRel,
 											 &SnapshotNonVacuumable,
@@ -5656,6 +5833,10 @@ get_actual_variable_range(PlannerInfo *root, VariableStatData *vardata,
 					MemoryContextSwitchTo(oldcontext);
 					*max = datumCopy(values[0], typByVal, typLen);
 					MemoryContextSwitchTo(tmpcontext);
+
+					ActualRangeCacheStore(indexRel, !min_last,
+										  typLen, typByVal,
+										  *max, max_generation);
 				}
 				else
 					have_data = false;
@@ -6749,9 +6930,11 @@ genericcostestimate(PlannerInfo *root,
 
 	/*
 	 * Check for ScalarArrayOpExpr index quals, and estimate the number of
-	 * index scans that will be performed.
+	 * index scans that will be performed.  The caller may already have
+	 * supplied a number of primitive scans (as for a btree skip scan), which
+	 * the ScalarArrayOpExprs multiply.
 	 */
-	num_sa_scans = 1;
+	num_sa_scans = (costs->num_sa_scans > 1) ? costs->num_sa_scans : 1;
 	foreach(l, indexQuals)
 	{
 		RestrictInfo *rinfo = (RestrictInfo *) lfirst(l);
@@ -6956,31 +7139,26 @@ add_predicate_to_quals(IndexOptInfo *index, List *indexQuals)
 }
 
 
-void
-btcostestimate(PlannerInfo *root, IndexPath *path, double loop_count,
-			   Cost *indexStartupCost, Cost *indexTotalCost,
-			   Selectivity *indexSelectivity, double *indexCorrelation,
-			   double *indexPages)
+/*
+ * Estimate the number of leaf tuples a btree scan visits in each primitive
+ * index scan, for btcostestimate.  firstcol is the first index column whose
+ * quals can be boundary quals: 0 normally, or 1 for a skip scan, whose skip
+ * key acts like an '=' qual on the first column.  *num_sa_scans is set to
+ * the number of primitive index scans induced by ScalarArrayOpExpr quals
+ * among the boundary quals.
+ */
+static double
+btcost_boundary_tuples(PlannerInfo *root, IndexOptInfo *index, List *qinfos,
+					   int firstcol, double *num_sa_scans)
 {
-	IndexOptInfo *index = path->indexinfo;
-	List	   *qinfos;
-	GenericCosts costs;
-	Oid			relid;
-	AttrNumber	colnum;
-	VariableStatData vardata;
 	double		numIndexTuples;
-	Cost		descentCost;
 	List	   *indexBoundQuals;
 	int			indexcol;
 	bool		eqQualHere;
 	bool		found_saop;
 	bool		found_is_null_op;
-	double		num_sa_scans;
 	ListCell   *lc;
 
-	/* Do preliminary analysis of indexquals */
-	qinfos = deconstruct_indexquals(path);
-
 	/*
 	 * For a btree scan, only leading '=' quals plus inequality quals for the
 	 * immediately next attribute contribute to index selectivity (these are
@@ -6999,11 +7177,11 @@ btcostestimate(PlannerInfo *root, IndexPath *path, double loop_count,
 	 * considered to act the same as it normally does.
 	 */
 	indexBoundQuals = NIL;
-	indexcol = 0;
+	indexcol = firstcol;
 	eqQualHere = false;
 	found_saop = false;
 	found_is_null_op = false;
-	num_sa_scans = 1;
+	*num_sa_scans = 1;
 	foreach(lc, qinfos)
 	{
 		IndexQualInfo *qinfo = (IndexQualInfo *) lfirst(lc);
@@ -7030,7 +7208,7 @@ btcostestimate(PlannerInfo *root, IndexPath *path, double loop_count,
 			found_saop = true;
 			/* count up number of SA scans induced by indexBoundQuals only */
 			if (alength > 1)
-				num_sa_scans *= alength;
+				*num_sa_scans *= alength;
 		}
 		else if (IsA(clause, NullTest))
 		{
@@ -7099,16 +7277,20 @@ btcostestimate(PlannerInfo *root, IndexPath *path, double loop_count,
 		 * ScalarArrayOpExpr quals included in indexBoundQuals, and then round
 		 * to integer.
 		 */
-		numIndexTuples = rint(numIndexTuples / num_sa_scans);
+		numIndexTuples = rint(numIndexTuples / *num_sa_scans);
 	}
 
-	/*
-	 * Now do generic index cost estimation.
-	 */
-	MemSet(&costs, 0, sizeof(costs));
-	costs.numIndexTuples = numIndexTuples;
+	return numIndexTuples;
+}
 
-	genericcostestimate(root, path, loop_count, qinfos, &costs);
+
+/*
+ * Add the costs of descending the btree to GenericCosts, for btcostestimate.
+ */
+static void
+btcost_add_descent(IndexOptInfo *index, GenericCosts *costs)
+{
+	Cost		descentCost;
 
 	/*
 	 * Add a CPU-cost component to represent the costs of initial btree
@@ -7124,8 +7306,8 @@ btcostestimate(PlannerInfo *root, IndexPath *path, double loop_count,
 	if (index->tuples > 1)		/* avoid computing log(0) */
 	{
 		descentCost = ceil(log(index->tuples) / log(2.0)) * cpu_operator_cost;
-		costs.indexStartupCost += descentCost;
-		costs.indexTotalCost += costs.num_sa_scans * descentCost;
+		costs->indexStartupCost += descentCost;
+		costs->indexTotalCost += costs->num_sa_scans * descentCost;
 	}
 
 	/*
@@ -7139,8 +7321,104 @@ btcostestimate(PlannerInfo *root, IndexPath *path, double loop_count,
 	 * we charge for the leaf page too).  As above, charge once per SA scan.
 	 */
 	descentCost = (index->tree_height + 1) * 50.0 * cpu_operator_cost;
-	costs.indexStartupCost += descentCost;
-	costs.indexTotalCost += costs.num_sa_scans * descentCost;
+	costs->indexStartupCost += descentCost;
+	costs->indexTotalCost += costs->num_sa_scans * descentCost;
+}
+
+/*
+ * Estimate the number of distinct values of a btree index's first column,
+ * for costing a skip scan.  Returns 0 if there are no useful statistics.
+ */
+static double
+btcost_leading_ndistinct(PlannerInfo *root, IndexOptInfo *index)
+{
+	TargetEntry *tle = (TargetEntry *) linitial(index->indextlist);
+	VariableStatData vardata;
+	double		ndistinct;
+	bool		isdefault;
+
+	examine_variable(root, (Node *) tle->expr, 0, &vardata);
+	ndistinct = get_variable_numdistinct(&vardata, &isdefault);
+	ReleaseVariableStats(vardata);
+
+	return isdefault ? 0 : ndistinct;
+}
+
+void
+btcostestimate(PlannerInfo *root, IndexPath *path, double loop_count,
+			   Cost *indexStartupCost, Cost *indexTotalCost,
+			   Selectivity *indexSelectivity, double *indexCorrelation,
+			   double *indexPages)
+{
+	IndexOptInfo *index = path->indexinfo;
+	List	   *qinfos;
+	GenericCosts costs;
+	Oid			relid;
+	AttrNumber	colnum;
+	VariableStatData vardata;
+	double		numIndexTuples;
+	double		num_sa_scans;
+
+	/* Do preliminary analysis of indexquals */
+	qinfos = deconstruct_indexquals(path);
+
+	numIndexTuples = btcost_boundary_tuples(root, index, qinfos, 0,
+											&num_sa_scans);
+
+	/*
+	 * Now do generic index cost estimation.
+	 */
+	MemSet(&costs, 0, sizeof(costs));
+	costs.numIndexTuples = numIndexTuples;
+
+	genericcostestimate(root, path, loop_count, qinfos, &costs);
+
+	btcost_add_descent(index, &costs);
+
+	/*
+	 * If there are no quals on the first index column but some on the
+	 * second, the scan could instead skip through the first column's
+	 * distinct values, doing one primitive index scan per value with the
+	 * second column's quals as boundary quals, much like "col1 = ANY(all
+	 * values)" (see _bt_preprocess_skip_key).  That pays off when there are
+	 * few distinct values, so cost it like a ScalarArrayOpExpr with ndistinct
+	 * elements, and use it if it's cheaper.  The next value is usually found
+	 * on the leaf page where the previous primitive scan stopped, so we don't
+	 * charge separately for locating it.
+	 */
+	path->indexskip = false;
+	if (enable_indexskipscan &&
+		index->nkeycolumns > 1 &&
+		qinfos != NIL &&
+		((IndexQualInfo *) linitial(qinfos))->indexcol == 1)
+	{
+		double		ndistinct = btcost_leading_ndistinct(root, index);
+
+		if (ndistinct >= 1.0 && ndistinct < index->tuples)
+		{
+			GenericCosts skipcosts;
+			double		skip_sa_scans;
+
+			numIndexTuples = btcost_boundary_tuples(root, index, qinfos, 1,
+													&skip_sa_scans);
+
+			MemSet(&skipcosts, 0, sizeof(skipcosts));
+			if (numIndexTuples > 0)
+				skipcosts.numIndexTuples = Max(rint(numIndexTuples / ndistinct),
+											   1.0);
+			skipcosts.num_sa_scans = ndistinct;
+
+			genericcostestimate(root, path, loop_count, qinfos, &skipcosts);
+
+			btcost_add_descent(index, &skipcosts);
+
+			if (skipcosts.indexTotalCost < costs.indexTotalCost)
+			{
+				costs = skipcosts;
+				path->indexskip = true;
+			}
+		}
+	}
 
 	/*
 	 * If we can get an estimate of the first column's ordering correlation C
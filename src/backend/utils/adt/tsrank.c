@@ -40,14 +40,32 @@ static float calc_rank_and(const float *w, TSVector t, TSQuery q);
 
 /*
  * Returns a weight of a word collocation
+ *
+ * calc_rank_and() calls this for every pair of positions of every pair of
+ * query terms, so the values for the distances that matter are computed
+ * once per backend rather than calling exp() each time.
  */
+#define WORD_DISTANCE_MAX	100
+
 static float4
 word_distance(int32 w)
 {
-	if (w > 100)
+	static float4 distance_weights[WORD_DISTANCE_MAX + 1];
+	static bool distance_weights_valid = false;
+
+	if (w > WORD_DISTANCE_MAX)
 		return 1e-30f;
 
-	return 1.0 / (1.005 + 0.05 * exp(((float4) w) / 1.5 - 2));
+	if (!distance_weights_valid)
+	{
+		int			i;
+
+		for (i = 0; i <= WORD_DISTANCE_MAX; i++)
+			distance_weights[i] = 1.0 / (1.005 + 0.05 * exp(((float4) i) / 1.5 - 2));
+		distance_weights_valid = true;
+	}
+
+	return distance_weights[w];
 }
 
 static int
@@ -373,12 +391,14 @@ calc_rank(const float *w, TSVector t, TSQuery q, int32 method)
 	if (res < 0)
 		res = 1e-20f;
 
+	/* both length normalizations need the same count; compute it once */
+	len = (method & (RANK_NORM_LOGLENGTH | RANK_NORM_LENGTH)) ? cnt_length(t) : 0;
+
 	if ((method & RANK_NORM_LOGLENGTH) && t->size > 0)
-		res /= log((double) (cnt_length(t) + 1)) / log(2.0);
+		res /= log((double) (len + 1)) / log(2.0);
 
 	if (method & RANK_NORM_LENGTH)
 	{
-		len = cnt_length(t);
 		if (len > 0)
 			res /= (float) len;
 	}
@@ -917,12 +937,13 @@ calc_rank_cd(const float4 *arrdata, TSVector txt, TSQuery query, int method)
 		NExtent++;
 	}
 
+	len = (method & (RANK_NORM_LOGLENGTH | RANK_NORM_LENGTH)) ? cnt_length(txt) : 0;
+
 	if ((method & RANK_NORM_LOGLENGTH) && txt->size > 0)
-		Wdoc /= log((double) (cnt_length(txt) + 1));
+		Wdoc /= log((double) (len + 1));
 
 	if (method & RANK_NORM_LENGTH)
 	{
-		len = cnt_length(txt);
 		if (len > 0)
 			Wdoc /= (double) len;
 	}
@@ -0,0 +1,290 @@
+/*-------------------------------------------------------------------------
+ *
+ * actualrangecache.c
+ *	  Shared cache of btree index endpoints found by the planner
+ *
+ * When a range predicate falls near the end of a column's histogram, the
+ * planner asks a btree index for the actual minimum or maximum value (see
+ * get_actual_variable_range() in selfuncs.c).  That's normally a couple of
+ * page reads, but if many dead tuples have piled up at that end of the
+ * index, as they do at the head of a queue table, each probe visits every
+ * one of their heap tuples until they can be removed.  Every planning cycle
+ * in every backend pays that again, so when actual_range_cache_timeout is
+ * set, the endpoints found are remembered here for that long.
+ *
+ * The cache is a direct-mapped array of ARC_NUM_ENTRIES entries, one per
+ * index, keyed by the index's RelFileNode so that TRUNCATE, REINDEX and
+ * anything else giving the index new storage misses the old entry.  Each
+ * entry holds the first and the last value of the index's leading column in
+ * index order, each with the time it was found.  Only pass-by-value values,
+ * and pass-by-reference values of up to ARC_MAX_DATA_LEN bytes, are cached.
+ *
+ * Deletions can only move the endpoints inwards, and the planner tolerates
+ * an endpoint that's somewhat too wide for the timeout's duration.  An
+ * insertion beyond an endpoint would make it too narrow, though, so btree
+ * insertion reports insertions into the leftmost and rightmost leaf pages
+ * by calling ActualRangeCacheInserted(), which invalidates the endpoint on
+ * that side.  A probe might miss an insertion made while it's running; to
+ * detect that, each endpoint has a generation counter that invalidation
+ * advances, and a probe's result is stored only if the counter hasn't moved
+ * since the probe missed the cache.  Insertions are replayed without going
+ * through here, so the cache isn't used during recovery.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/utils/cache/actualrangecache.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/xlog.h"
+#include "storage/shmem.h"
+#include "storage/spin.h"
+#include "utils/actualrangecache.h"
+#include "utils/datum.h"
+#include "utils/hashutils.h"
+#include "utils/rel.h"
+#include "utils/timestamp.h"
+
+
+/* Number of cached indexes */
+#define ARC_NUM_ENTRIES		1024
+
+/* Longest pass-by-reference value that is cached */
+#define ARC_MAX_DATA_LEN	64
+
+typedef struct ActualRangeEnd
+{
+	bool		valid;			/* is the value below valid? */
+	uint64		generation;		/* advanced whenever invalidated */
+	TimestampTz found;			/* when the value was found */
+	Datum		value;			/* the value, if pass-by-value */
+	int			len;			/* length of data, if pass-by-reference */
+	char		data[ARC_MAX_DATA_LEN];
+} ActualRangeEnd;
+
+typedef struct ActualRangeCacheEntry
+{
+	slock_t		mutex;			/* protects all fields of the entry */
+	RelFileNode node;			/* identity of the index */
+	ActualRangeEnd ends[2];		/* first and last value in index order */
+} ActualRangeCacheEntry;
+
+/* GUC variable */
+int			actual_range_cache_timeout = 0;
+
+static ActualRangeCacheEntry *ActualRangeCache = NULL;
+
+static ActualRangeCacheEntry *ActualRangeCacheEntryFor(RelFileNode *node);
+
+
+/*
+ * Report shared memory space needed by ActualRangeCacheShmemInit
+ */
+Size
+ActualRangeCacheShmemSize(void)
+{
+	return mul_size(ARC_NUM_ENTRIES, sizeof(ActualRangeCacheEntry));
+}
+
+/*
+ * Allocate and initialize the cache
+ */
+void
+ActualRangeCacheShmemInit(void)
+{
+	bool		found;
+	int			i;
+
+	ActualRangeCache = (ActualRangeCacheEntry *)
+		ShmemInitStruct("Actual Range Cache", ActualRangeCacheShmemSize(),
+						&found);
+
+	if (!found)
+	{
+		MemSet(ActualRangeCache, 0, ActualRangeCacheShmemSize());
+		for (i = 0; i < ARC_NUM_ENTRIES; i++)
+			SpinLockInit(&ActualRangeCache[i].mutex);
+	}
+}
+
+/*
+ * Look up the first (last = false) or last (last = true) value of an index's
+ * leading column, in index order.
+ *
+ * If it's cached and not older than actual_range_cache_timeout, a copy of
+ * it is stored in *value in the caller's memory context, and we return true.
+ * Otherwise, the caller may probe the index and pass the value it found to
+ * ActualRangeCacheStore(), together with the *generation we return.
+ */
+bool
+ActualRangeCacheLookup(Relation indexRel, bool last,
+					   int16 typLen, bool typByVal,
+					   Datum *value, uint64 *generation)
+{
+	ActualRangeCacheEntry *entry;
+	ActualRangeEnd *end;
+	TimestampTz now;
+	char		data[ARC_MAX_DATA_LEN];
+	int			len = 0;
+	bool		hit = false;
+
+	*generation = 0;
+	if (actual_range_cache_timeout <= 0 || ActualRangeCache == NULL ||
+		RecoveryInProgress())
+		return false;
+
+	now = GetCurrentTimestamp();
+	entry = ActualRangeCacheEntryFor(&indexRel->rd_node);
+
+	SpinLockAcquire(&entry->mutex);
+	if (!RelFileNodeEquals(entry->node, indexRel->rd_node))
+	{
+		/* Take over the entry, so that insertions start invalidating it */
+		entry->node = indexRel->rd_node;
+		entry->ends[0].valid = false;
+		entry->ends[0].generation++;
+		entry->ends[1].valid = false;
+		entry->ends[1].generation++;
+	}
+	end = &entry->ends[last ? 1 : 0];
+	if (end->valid &&
+		!TimestampDifferenceExceeds(end->found, now,
+									actual_range_cache_timeout))
+	{
+		hit = true;
+		if (typByVal)
+			*value = end->value;
+		else
+		{
+			len = end->len;
+			memcpy(data, end->data, len);
+		}
+	}
+	*generation = end->generation;
+	SpinLockRelease(&entry->mutex);
+
+	if (hit && !typByVal)
+	{
+		char	   *copy = palloc(len);
+
+		memcpy(copy, data, len);
+		*value = PointerGetDatum(copy);
+	}
+
+	return hit;
+}
+
+/*
+ * Remember an endpoint of an index, as found after ActualRangeCacheLookup()
+ * returned the given generation.
+ *
+ * Nothing happens if the endpoint may have changed since then, or if the
+ * value is too large to cache.
+ */
+void
+ActualRangeCacheStore(Relation indexRel, bool last,
+					  int16 typLen, bool typByVal,
+					  Datum value, uint64 generation)
+{
+	ActualRangeCacheEntry *entry;
+	ActualRangeEnd *end;
+	TimestampTz now;
+	int			len = 0;
+
+	if (actual_range_cache_timeout <= 0 || ActualRangeCache == NULL ||
+		RecoveryInProgress())
+		return;
+
+	if (!typByVal)
+	{
+		/* the copy must not depend on any out-of-line storage */
+		if (typLen == -1 &&
+			VARATT_IS_EXTERNAL(DatumGetPointer(value)))
+			return;
+		len = datumGetSize(value, typByVal, typLen);
+		if (len > ARC_MAX_DATA_LEN)
+			return;
+	}
+
+	now = GetCurrentTimestamp();
+	entry = ActualRangeCacheEntryFor(&indexRel->rd_node);
+
+	SpinLockAcquire(&entry->mutex);
+	end = &entry->ends[last ? 1 : 0];
+	if (RelFileNodeEquals(entry->node, indexRel->rd_node) &&
+		end->generation == generation)
+	{
+		end->valid = true;
+		end->found = now;
+		if (typByVal)
+			end->value = value;
+		else
+		{
+			end->len = len;
+			memcpy(end->data, DatumGetPointer(value), len);
+		}
+	}
+	SpinLockRelease(&entry->mutex);
+}
+
+/*
+ * Report that a tuple has been inserted into the leftmost (first = true)
+ * and/or rightmost (last = true) leaf page of a btree index.
+ *
+ * This must be called after the tuple has been added to the page.
+ */
+void
+ActualRangeCacheInserted(Relation indexRel, bool first, bool last)
+{
+	ActualRangeCacheEntry *entry;
+
+	if (ActualRangeCache == NULL)
+		return;
+
+	entry = ActualRangeCacheEntryFor(&indexRel->rd_node);
+
+	/*
+	 * Most indexes aren't cached, so check that without the lock first.  A
+	 * torn read can't match, and if we don't see another backend taking
+	 * over the entry for this index, that backend hasn't read the page we
+	 * inserted into yet, because the buffer lock orders us.
+	 */
+	if (!RelFileNodeEquals(entry->node, indexRel->rd_node))
+		return;
+
+	SpinLockAcquire(&entry->mutex);
+	if (RelFileNodeEquals(entry->node, indexRel->rd_node))
+	{
+		if (first)
+		{
+			entry->ends[0].valid = false;
+			entry->ends[0].generation++;
+		}
+		if (last)
+		{
+			entry->ends[1].valid = false;
+			entry->ends[1].generation++;
+		}
+	}
+	SpinLockRelease(&entry->mutex);
+}
+
+/*
+ * Find the entry an index maps to.
+ */
+static ActualRangeCacheEntry *
+ActualRangeCacheEntryFor(RelFileNode *node)
+{
+	uint32		hash;
+
+	hash = hash_combine(murmurhash32(node->relNode),
+						hash_combine(murmurhash32(node->dbNode),
+									 murmurhash32(node->spcNode)));
+
+	return &ActualRangeCache[hash % ARC_NUM_ENTRIES];
+}
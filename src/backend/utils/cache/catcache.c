@@ -22,9 +22,11 @@
 #include "access/tuptoaster.h"
 #include "access/valid.h"
 #include "access/xact.h"
+#include "catalog/pg_class.h"
 #include "catalog/pg_collation.h"
 #include "catalog/pg_operator.h"
 #include "catalog/pg_type.h"
+#include "funcapi.h"
 #include "miscadmin.h"
 #ifdef CATCACHE_STATS
 #include "storage/ipc.h"		/* for on_proc_exit */
@@ -38,6 +40,8 @@
 #include "utils/memutils.h"
 #include "utils/rel.h"
 #include "utils/resowner_private.h"
+#include "utils/sharedcatcache.h"
+#include "utils/snapmgr.h"
 #include "utils/syscache.h"
 #include "utils/tqual.h"
 
@@ -75,6 +79,11 @@
 /* Cache management header --- pointer is NULL until created */
 static CatCacheHeader *CacheHdr = NULL;
 
+/* GUC variable */
+int			catalog_cache_memory_target = 0;
+
+uint64		catalog_cache_clock = 0;
+
 static inline HeapTuple SearchCatCacheInternal(CatCache *cache,
 					   int nkeys,
 					   Datum v1, Datum v2,
@@ -100,6 +109,8 @@ static void CatCachePrintStats(int code, Datum arg);
 #endif
 static void CatCacheRemoveCTup(CatCache *cache, CatCTup *ct);
 static void CatCacheRemoveCList(CatCache *cache, CatCList *cl);
+static Size CatCacheKeysSpace(TupleDesc tupdesc, int nkeys, int *attnos,
+				  Datum *keys);
 static void CatalogCacheInitializeCache(CatCache *cache);
 static CatCTup *CatalogCacheCreateEntry(CatCache *cache, HeapTuple ntp,
 						Datum *arguments,
@@ -465,6 +476,8 @@ CatCachePrintStats(int code, Datum arg)
 static void
 CatCacheRemoveCTup(CatCache *cache, CatCTup *ct)
 {
+	Size		space;
+
 	Assert(ct->refcount == 0);
 	Assert(ct->my_cache == cache);
 
@@ -480,16 +493,24 @@ CatCacheRemoveCTup(CatCache *cache, CatCTup *ct)
 		return;					/* nothing left to do */
 	}
 
-	/* delink from linked list */
+	/* delink from linked lists */
 	dlist_delete(&ct->cache_elem);
+	dlist_delete(&ct->lru_elem);
 
 	/*
 	 * Free keys when we're dealing with a negative entry, normal entries just
 	 * point into tuple, allocated together with the CatCTup.
 	 */
+	space = GetMemoryChunkSpace(ct);
 	if (ct->negative)
+	{
+		space += CatCacheKeysSpace(cache->cc_tupdesc, cache->cc_nkeys,
+								   cache->cc_keyno, ct->keys);
 		CatCacheFreeKeys(cache->cc_tupdesc, cache->cc_nkeys,
 						 cache->cc_keyno, ct->keys);
+	}
+	cache->cc_memusage -= space;
+	CacheHdr->ch_memusage -= space;
 
 	pfree(ct);
 
@@ -508,6 +529,7 @@ static void
 CatCacheRemoveCList(CatCache *cache, CatCList *cl)
 {
 	int			i;
+	Size		space;
 
 	Assert(cl->refcount == 0);
 	Assert(cl->my_cache == cache);
@@ -532,6 +554,11 @@ CatCacheRemoveCList(CatCache *cache, CatCList *cl)
 	dlist_delete(&cl->cache_elem);
 
 	/* free associated column data */
+	space = GetMemoryChunkSpace(cl) +
+		CatCacheKeysSpace(cache->cc_tupdesc, cl->nkeys,
+						  cache->cc_keyno, cl->keys);
+	cache->cc_memusage -= space;
+	CacheHdr->ch_memusage -= space;
 	CatCacheFreeKeys(cache->cc_tupdesc, cl->nkeys,
 					 cache->cc_keyno, cl->keys);
 
@@ -604,9 +631,7 @@ CatCacheInvalidate(CatCache *cache, uint32 hashValue)
 			else
 				CatCacheRemoveCTup(cache, ct);
 			CACHE1_elog(DEBUG2, "CatCacheInvalidate: invalidated");
-#ifdef CATCACHE_STATS
 			cache->cc_invals++;
-#endif
 			/* could be multiple matches, so keep looking! */
 		}
 	}
@@ -682,9 +707,7 @@ ResetCatalogCache(CatCache *cache)
 			}
 			else
 				CatCacheRemoveCTup(cache, ct);
-#ifdef CATCACHE_STATS
 			cache->cc_invals++;
-#endif
 		}
 	}
 }
@@ -811,6 +834,8 @@ InitCatCache(int id,
 		CacheHdr = (CatCacheHeader *) palloc(sizeof(CatCacheHeader));
 		slist_init(&CacheHdr->ch_caches);
 		CacheHdr->ch_ntup = 0;
+		dlist_init(&CacheHdr->ch_lru);
+		CacheHdr->ch_memusage = 0;
 #ifdef CATCACHE_STATS
 		/* set up to dump stats at backend exit */
 		on_proc_exit(CatCachePrintStats, 0);
@@ -1231,9 +1256,7 @@ SearchCatCacheInternal(CatCache *cache,
 	if (unlikely(cache->cc_tupdesc == NULL))
 		CatalogCacheInitializeCache(cache);
 
-#ifdef CATCACHE_STATS
 	cache->cc_searches++;
-#endif
 
 	/* Initialize local parameter array */
 	arguments[0] = v1;
@@ -1274,6 +1297,8 @@ SearchCatCacheInternal(CatCache *cache,
 		 * near the front of the hashbucket's list.)
 		 */
 		dlist_move_head(bucket, &ct->cache_elem);
+		dlist_move_tail(&CacheHdr->ch_lru, &ct->lru_elem);
+		ct->lastaccess = ++catalog_cache_clock;
 
 		/*
 		 * If it's a positive entry, bump its refcount and return it. If it's
@@ -1288,9 +1313,7 @@ SearchCatCacheInternal(CatCache *cache,
 			CACHE3_elog(DEBUG2, "SearchCatCache(%s): found in bucket %d",
 						cache->cc_relname, hashIndex);
 
-#ifdef CATCACHE_STATS
 			cache->cc_hits++;
-#endif
 
 			return &ct->tuple;
 		}
@@ -1299,9 +1322,7 @@ SearchCatCacheInternal(CatCache *cache,
 			CACHE3_elog(DEBUG2, "SearchCatCache(%s): found neg entry in bucket %d",
 						cache->cc_relname, hashIndex);
 
-#ifdef CATCACHE_STATS
 			cache->cc_neg_hits++;
-#endif
 
 			return NULL;
 		}
@@ -1333,6 +1354,9 @@ SearchCatCacheMiss(CatCache *cache,
 	HeapTuple	ntp;
 	CatCTup    *ct;
 	Datum		arguments[CATCACHE_MAXKEYS];
+	bool		use_shared;
+	Oid			shared_dbid = InvalidOid;
+	uint64		shared_version = 0;
 
 	/* Initialize local parameter array */
 	arguments[0] = v1;
@@ -1340,6 +1364,70 @@ SearchCatCacheMiss(CatCache *cache,
 	arguments[2] = v3;
 	arguments[3] = v4;
 
+	/*
+	 * Try the shared catalog cache first, if there is one and we may use it:
+	 * not while our own transaction has catalog changes that other backends
+	 * can't see yet, nor while decoding with a historic snapshot.
+	 */
+	use_shared = shared_catalog_cache_size > 0 &&
+		IsNormalProcessingMode() &&
+		!HistoricSnapshotActive() &&
+		!InvalidationsPending();
+
+	if (use_shared)
+	{
+		List	   *tuples;
+		ListCell   *lc;
+
+		shared_dbid = cache->cc_relisshared ? InvalidOid : MyDatabaseId;
+		tuples = SharedCatCacheSearch(shared_dbid, cache->id, hashValue);
+
+		ct = NULL;
+		foreach(lc, tuples)
+		{
+			HeapTuple	stup = (HeapTuple) lfirst(lc);
+			Datum		keys[CATCACHE_MAXKEYS];
+			int			i;
+
+			for (i = 0; i < nkeys; i++)
+			{
+				bool		isnull;
+
+				keys[i] = heap_getattr(stup, cache->cc_keyno[i],
+									   cache->cc_tupdesc, &isnull);
+				Assert(!isnull);
+			}
+
+			if (CatalogCacheCompareTuple(cache, nkeys, keys, arguments))
+			{
+				ct = CatalogCacheCreateEntry(cache, stup, arguments,
+											 hashValue, hashIndex,
+											 false);
+				break;
+			}
+		}
+		list_free_deep(tuples);
+
+		if (ct != NULL)
+		{
+			/* immediately set the refcount to 1 */
+			ResourceOwnerEnlargeCatCacheRefs(CurrentResourceOwner);
+			ct->refcount++;
+			ResourceOwnerRememberCatCacheRef(CurrentResourceOwner, &ct->tuple);
+
+			cache->cc_newloads++;
+
+			return &ct->tuple;
+		}
+
+		/*
+		 * We'll offer what we find to the shared cache.  Get the version
+		 * before the snapshot for the scan; see sharedcatcache.c.
+		 */
+		shared_version = SharedCatCacheGetVersion();
+		InvalidateCatalogSnapshot();
+	}
+
 	/*
 	 * Ok, need to make a lookup in the relation, copy the scankey and fill
 	 * out any per-call fields.
@@ -1385,6 +1473,10 @@ SearchCatCacheMiss(CatCache *cache,
 		ResourceOwnerEnlargeCatCacheRefs(CurrentResourceOwner);
 		ct->refcount++;
 		ResourceOwnerRememberCatCacheRef(CurrentResourceOwner, &ct->tuple);
+		/* ct->tuple has no out-of-line values, unlike ntp perhaps */
+		if (use_shared)
+			SharedCatCacheInsert(shared_dbid, cache->id, cache->cc_reloid,
+								 hashValue, &ct->tuple, shared_version);
 		break;					/* assume only one match */
 	}
 
@@ -1429,9 +1521,7 @@ SearchCatCacheMiss(CatCache *cache,
 	CACHE3_elog(DEBUG2, "SearchCatCache(%s): put in bucket %d",
 				cache->cc_relname, hashIndex);
 
-#ifdef CATCACHE_STATS
 	cache->cc_newloads++;
-#endif
 
 	return &ct->tuple;
 }
@@ -1532,6 +1622,7 @@ SearchCatCacheList(CatCache *cache,
 	bool		ordered;
 	HeapTuple	ntp;
 	MemoryContext oldcxt;
+	Size		space;
 	int			i;
 
 	/*
@@ -1542,9 +1633,7 @@ SearchCatCacheList(CatCache *cache,
 
 	Assert(nkeys > 0 && nkeys < cache->cc_nkeys);
 
-#ifdef CATCACHE_STATS
 	cache->cc_lsearches++;
-#endif
 
 	/* Initialize local parameter array */
 	arguments[0] = v1;
@@ -1601,9 +1690,7 @@ SearchCatCacheList(CatCache *cache,
 		CACHE2_elog(DEBUG2, "SearchCatCacheList(%s): found list",
 					cache->cc_relname);
 
-#ifdef CATCACHE_STATS
 		cache->cc_lhits++;
-#endif
 
 		return cl;
 	}
@@ -1718,6 +1805,12 @@ SearchCatCacheList(CatCache *cache,
 						 arguments, cl->keys);
 		MemoryContextSwitchTo(oldcxt);
 
+		space = GetMemoryChunkSpace(cl) +
+			CatCacheKeysSpace(cache->cc_tupdesc, nkeys,
+							  cache->cc_keyno, cl->keys);
+		cache->cc_memusage += space;
+		CacheHdr->ch_memusage += space;
+
 		/*
 		 * We are now past the last thing that could trigger an elog before we
 		 * have finished building the CatCList and remembering it in the
@@ -1820,6 +1913,13 @@ CatalogCacheCreateEntry(CatCache *cache, HeapTuple ntp, Datum *arguments,
 	CatCTup    *ct;
 	HeapTuple	dtp;
 	MemoryContext oldcxt;
+	Size		space;
+
+	/*
+	 * Make room first, if the caches have grown too large, so that the new
+	 * entry is safe from eviction until the caller has pinned it.
+	 */
+	CatalogCacheEnforceMemoryTarget(false);
 
 	/* negative entries have no tuple associated */
 	if (ntp)
@@ -1899,12 +1999,21 @@ CatalogCacheCreateEntry(CatCache *cache, HeapTuple ntp, Datum *arguments,
 	ct->dead = false;
 	ct->negative = negative;
 	ct->hash_value = hashValue;
+	ct->lastaccess = ++catalog_cache_clock;
 
 	dlist_push_head(&cache->cc_bucket[hashIndex], &ct->cache_elem);
+	dlist_push_tail(&CacheHdr->ch_lru, &ct->lru_elem);
 
 	cache->cc_ntup++;
 	CacheHdr->ch_ntup++;
 
+	space = GetMemoryChunkSpace(ct);
+	if (negative)
+		space += CatCacheKeysSpace(cache->cc_tupdesc, cache->cc_nkeys,
+								   cache->cc_keyno, ct->keys);
+	cache->cc_memusage += space;
+	CacheHdr->ch_memusage += space;
+
 	/*
 	 * If the hash table has become too full, enlarge the buckets array. Quite
 	 * arbitrarily, we enlarge when fill factor > 2.
@@ -1938,6 +2047,27 @@ CatCacheFreeKeys(TupleDesc tupdesc, int nkeys, int *attnos, Datum *keys)
 	}
 }
 
+/*
+ * Helper routine that returns the space taken by keys stored in the keys
+ * array, not counting the array itself.
+ */
+static Size
+CatCacheKeysSpace(TupleDesc tupdesc, int nkeys, int *attnos, Datum *keys)
+{
+	Size		space = 0;
+	int			i;
+
+	for (i = 0; i < nkeys; i++)
+	{
+		Form_pg_attribute att = TupleDescAttr(tupdesc, attnos[i] - 1);
+
+		if (!att->attbyval)
+			space += GetMemoryChunkSpace(DatumGetPointer(keys[i]));
+	}
+
+	return space;
+}
+
 /*
  * Helper routine that copies the keys in the srckeys array into the dstkeys
  * one, guaranteeing that the datums are fully allocated in the current memory
@@ -2074,6 +2204,176 @@ PrepareToInvalidateCacheTuple(Relation relation,
 }
 
 
+/*
+ * CatalogCacheEnforceMemoryTarget
+ *
+ *	Evict least recently used entries until the caches fit into
+ *	catalog_cache_memory_target again, or nothing more can be evicted.
+ *
+ *	Entries that are pinned, or that belong to a pinned CatCList, can't be
+ *	evicted; evicting a member of an unpinned list removes the list, too.
+ *
+ *	Relcache entries can only be removed safely at transaction end, since
+ *	many places hold on to relcache entries briefly without pinning them,
+ *	or scan the relcache hash table while building entries.  Therefore
+ *	AtEOXact_RelationCache() passes include_relcache = true, to apply the
+ *	target to the catcache and the relcache together, evicting whichever
+ *	entry has gone unused the longest.  Otherwise, we're called when a new
+ *	catcache entry is about to be made, and only the catcache's own size is
+ *	held against the target.
+ */
+void
+CatalogCacheEnforceMemoryTarget(bool include_relcache)
+{
+	Size		target;
+
+	if (catalog_cache_memory_target <= 0 || CacheHdr == NULL)
+		return;
+
+	target = (Size) catalog_cache_memory_target * 1024;
+
+	for (;;)
+	{
+		Size		usage = CacheHdr->ch_memusage;
+		CatCTup    *victim = NULL;
+		dlist_iter	iter;
+
+		if (include_relcache)
+			usage += RelationCacheMemoryUsage();
+		if (usage <= target)
+			break;
+
+		/*
+		 * Find the oldest evictable entry.  We have to start over from the
+		 * head each time, since removing a list can remove other entries.
+		 */
+		dlist_foreach(iter, &CacheHdr->ch_lru)
+		{
+			CatCTup    *ct = dlist_container(CatCTup, lru_elem, iter.cur);
+
+			if (ct->refcount == 0 &&
+				(ct->c_list == NULL || ct->c_list->refcount == 0))
+			{
+				victim = ct;
+				break;
+			}
+		}
+
+		if (include_relcache &&
+			RelationCacheEvictOldest(victim ? victim->lastaccess : PG_UINT64_MAX))
+			continue;
+
+		if (victim == NULL)
+			break;
+
+		victim->my_cache->cc_evictions++;
+		CatCacheRemoveCTup(victim->my_cache, victim);
+	}
+}
+
+/*
+ * pg_catalog_caches
+ *
+ *	SQL SRF showing the statistics of this backend's catalog caches, one row
+ *	per catcache followed by one for the relcache.
+ */
+Datum
+pg_catalog_caches(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext per_query_ctx;
+	MemoryContext oldcontext;
+	Datum		values[11];
+	bool		nulls[11];
+	long		rc_entries;
+	Size		rc_memusage;
+	long		rc_hits;
+	long		rc_loads;
+	long		rc_evictions;
+	long		rc_invals;
+
+	/* check to see if caller supports us returning a tuplestore */
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not " \
+						"allowed in this context")));
+
+	/* need to build tuplestore in query context */
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	tupstore =
+		tuplestore_begin_heap(rsinfo->allowedModes & SFRM_Materialize_Random,
+							  false, work_mem);
+
+	/* generate junk in short-term context */
+	MemoryContextSwitchTo(oldcontext);
+
+	if (CacheHdr != NULL)
+	{
+		slist_iter	iter;
+
+		slist_foreach(iter, &CacheHdr->ch_caches)
+		{
+			CatCache   *cache = slist_container(CatCache, cc_next, iter.cur);
+
+			MemSet(nulls, 0, sizeof(nulls));
+
+			values[0] = Int32GetDatum(cache->id);
+			values[1] = ObjectIdGetDatum(cache->cc_reloid);
+			values[2] = ObjectIdGetDatum(cache->cc_indexoid);
+			values[3] = Int64GetDatum(cache->cc_ntup);
+			values[4] = Int64GetDatum(cache->cc_memusage);
+			values[5] = Int64GetDatum(cache->cc_searches);
+			values[6] = Int64GetDatum(cache->cc_hits);
+			values[7] = Int64GetDatum(cache->cc_neg_hits);
+			values[8] = Int64GetDatum(cache->cc_newloads);
+			values[9] = Int64GetDatum(cache->cc_evictions);
+			values[10] = Int64GetDatum(cache->cc_invals);
+
+			tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+		}
+	}
+
+	RelationCacheGetStats(&rc_entries, &rc_memusage, &rc_hits, &rc_loads,
+						  &rc_evictions, &rc_invals);
+
+	MemSet(nulls, 0, sizeof(nulls));
+
+	nulls[0] = true;
+	values[1] = ObjectIdGetDatum(RelationRelationId);
+	nulls[2] = true;
+	values[3] = Int64GetDatum(rc_entries);
+	values[4] = Int64GetDatum(rc_memusage);
+	values[5] = Int64GetDatum(rc_hits + rc_loads);
+	values[6] = Int64GetDatum(rc_hits);
+	nulls[7] = true;
+	values[8] = Int64GetDatum(rc_loads);
+	values[9] = Int64GetDatum(rc_evictions);
+	values[10] = Int64GetDatum(rc_invals);
+
+	tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+
+	/* clean up and return the tuplestore */
+	tuplestore_donestoring(tupstore);
+
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	return (Datum) 0;
+}
+
 /*
  * Subroutines for warning about reference leaks.  These are exported so
  * that resowner.c can call them.
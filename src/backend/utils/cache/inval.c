@@ -722,6 +722,19 @@ AcceptInvalidationMessages(void)
 #endif
 }
 
+/*
+ * InvalidationsPending
+ *		Has the current transaction queued any invalidation messages?
+ *
+ * If so, it may have modified catalog rows that other backends can't see
+ * yet.
+ */
+bool
+InvalidationsPending(void)
+{
+	return transInvalInfo != NULL;
+}
+
 /*
  * PrepareInvalidationState
  *		Initialize inval lists for the current (sub)transaction.
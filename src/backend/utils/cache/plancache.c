@@ -70,10 +70,12 @@
 #include "storage/lmgr.h"
 #include "tcop/pquery.h"
 #include "tcop/utility.h"
+#include "portability/instr_time.h"
 #include "utils/inval.h"
 #include "utils/memutils.h"
 #include "utils/resowner_private.h"
 #include "utils/rls.h"
+#include "utils/sharedplancache.h"
 #include "utils/snapmgr.h"
 #include "utils/syscache.h"
 
@@ -105,9 +107,19 @@ static List *RevalidateCachedQuery(CachedPlanSource *plansource,
 static bool CheckCachedPlan(CachedPlanSource *plansource);
 static CachedPlan *BuildCachedPlan(CachedPlanSource *plansource, List *qlist,
 				ParamListInfo boundParams, QueryEnvironment *queryEnv);
+static CachedPlan *MakeCachedPlan(CachedPlanSource *plansource, List *plist,
+			   MemoryContext plan_context);
+static void LinkGenericPlan(CachedPlanSource *plansource, CachedPlan *plan);
+static char *SharedPlanKey(CachedPlanSource *plansource,
+			  QueryEnvironment *queryEnv);
+static CachedPlan *AdoptSharedPlan(CachedPlanSource *plansource,
+				char *sharedkey);
+static void OfferSharedPlan(CachedPlanSource *plansource, CachedPlan *plan,
+				char *sharedkey, uint64 version);
 static bool choose_custom_plan(CachedPlanSource *plansource,
 				   ParamListInfo boundParams);
 static double cached_plan_cost(CachedPlan *plan, bool include_planner);
+static void update_time_average(double *average, double sample);
 static Query *QueryListGetPrimaryStmt(List *stmts);
 static void AcquireExecutorLocks(List *stmt_list, bool acquire);
 static void AcquirePlannerLocks(List *stmt_list, bool acquire);
@@ -118,6 +130,15 @@ static void PlanCacheRelCallback(Datum arg, Oid relid);
 static void PlanCacheObjectCallback(Datum arg, int cacheid, uint32 hashvalue);
 static void PlanCacheSysCallback(Datum arg, int cacheid, uint32 hashvalue);
 
+/*
+ * In "adaptive" mode, the measured times are running averages over roughly
+ * the last ADAPTIVE_SMOOTHING samples, and every ADAPTIVE_PROBE_INTERVAL'th
+ * choice goes against them, so that the average for the kind of plan not
+ * currently preferred is kept up to date.
+ */
+#define ADAPTIVE_SMOOTHING			8
+#define ADAPTIVE_PROBE_INTERVAL		32
+
 /* GUC parameter */
 int			plan_cache_mode;
 
@@ -222,6 +243,10 @@ CreateCachedPlan(RawStmt *raw_parse_tree,
 	plansource->generic_cost = -1;
 	plansource->total_custom_cost = 0;
 	plansource->num_custom_plans = 0;
+	plansource->generic_time = -1;
+	plansource->custom_time = -1;
+	plansource->custom_plan_time = -1;
+	plansource->num_adaptive_choices = 0;
 
 	MemoryContextSwitchTo(oldcxt);
 
@@ -289,6 +314,10 @@ CreateOneShotCachedPlan(RawStmt *raw_parse_tree,
 	plansource->generic_cost = -1;
 	plansource->total_custom_cost = 0;
 	plansource->num_custom_plans = 0;
+	plansource->generic_time = -1;
+	plansource->custom_time = -1;
+	plansource->custom_plan_time = -1;
+	plansource->num_adaptive_choices = 0;
 
 	return plansource;
 }
@@ -883,10 +912,8 @@ BuildCachedPlan(CachedPlanSource *plansource, List *qlist,
 	CachedPlan *plan;
 	List	   *plist;
 	bool		snapshot_set;
-	bool		is_transient;
 	MemoryContext plan_context;
 	MemoryContext oldcxt = CurrentMemoryContext;
-	ListCell   *lc;
 
 	/*
 	 * Normally the querytree should be valid already, but if it's not,
@@ -933,7 +960,8 @@ BuildCachedPlan(CachedPlanSource *plansource, List *qlist,
 	/*
 	 * Generate the plan.
 	 */
-	plist = pg_plan_queries(qlist, plansource->cursor_options, boundParams);
+	plist = pg_plan_queries(qlist, plansource->query_string,
+							plansource->cursor_options, boundParams);
 
 	/* Release snapshot if we got one */
 	if (snapshot_set)
@@ -962,9 +990,28 @@ BuildCachedPlan(CachedPlanSource *plansource, List *qlist,
 	else
 		plan_context = CurrentMemoryContext;
 
-	/*
-	 * Create and fill the CachedPlan struct within the new context.
-	 */
+	/* Create and fill the CachedPlan struct within the new context */
+	plan = MakeCachedPlan(plansource, plist, plan_context);
+
+	MemoryContextSwitchTo(oldcxt);
+
+	return plan;
+}
+
+/*
+ * MakeCachedPlan: create the CachedPlan struct for a completed plan.
+ *
+ * The struct is allocated in the current memory context, which should be
+ * plan_context.
+ */
+static CachedPlan *
+MakeCachedPlan(CachedPlanSource *plansource, List *plist,
+			   MemoryContext plan_context)
+{
+	CachedPlan *plan;
+	bool		is_transient;
+	ListCell   *lc;
+
 	plan = (CachedPlan *) palloc(sizeof(CachedPlan));
 	plan->magic = CACHEDPLAN_MAGIC;
 	plan->stmt_list = plist;
@@ -1005,11 +1052,156 @@ BuildCachedPlan(CachedPlanSource *plansource, List *qlist,
 	/* assign generation number to new plan */
 	plan->generation = ++(plansource->generation);
 
+	return plan;
+}
+
+/*
+ * LinkGenericPlan: install a new generic plan in the plansource.
+ */
+static void
+LinkGenericPlan(CachedPlanSource *plansource, CachedPlan *plan)
+{
+	/* Just make real sure plansource->gplan is clear */
+	ReleaseGenericPlan(plansource);
+	/* Link the new generic plan into the plansource */
+	plansource->gplan = plan;
+	plan->refcount++;
+	/* Immediately reparent into appropriate context */
+	if (plansource->is_saved)
+	{
+		/* saved plans all live under CacheMemoryContext */
+		MemoryContextSetParent(plan->context, CacheMemoryContext);
+		plan->is_saved = true;
+	}
+	else
+	{
+		/* otherwise, it should be a sibling of the plansource */
+		MemoryContextSetParent(plan->context,
+							   MemoryContextGetParent(plansource->context));
+	}
+}
+
+/*
+ * SharedPlanKey: compute the key of the plansource's generic plan in the
+ * shared plan cache.
+ *
+ * Returns NULL if the plan must not be shared.  The plansource's query_list
+ * must be valid.
+ */
+static char *
+SharedPlanKey(CachedPlanSource *plansource, QueryEnvironment *queryEnv)
+{
+	ListCell   *lc;
+
+	if (shared_plan_cache_size <= 0 ||
+		!plansource->is_saved ||
+		plansource->is_oneshot ||
+		queryEnv != NULL ||
+		IsTransactionStmtPlan(plansource) ||
+		!IsNormalProcessingMode())
+		return NULL;
+
+	/*
+	 * Plans made while our own transaction has changed the catalogs might
+	 * depend on things other sessions can't see yet.
+	 */
+	if (InvalidationsPending())
+		return NULL;
+
+	foreach(lc, plansource->query_list)
+	{
+		Query	   *query = lfirst_node(Query, lc);
+
+		if (query->commandType == CMD_UTILITY)
+			return NULL;
+	}
+
+	return psprintf("%d %s", plansource->cursor_options,
+					nodeToString(plansource->query_list));
+}
+
+/*
+ * AdoptSharedPlan: make a generic plan from the shared plan cache, if it
+ * has one for the plansource.
+ *
+ * On success, the plan is installed as the plansource's gplan, and
+ * CheckCachedPlan has acquired the locks needed to run it.  Returns NULL
+ * if there is no usable shared plan.
+ */
+static CachedPlan *
+AdoptSharedPlan(CachedPlanSource *plansource, char *sharedkey)
+{
+	CachedPlan *plan;
+	MemoryContext plan_context;
+	MemoryContext oldcxt;
+	List	   *plist;
+	char	   *planstr;
+
+	planstr = SharedPlanCacheLookup(sharedkey, strlen(sharedkey));
+	if (planstr == NULL)
+		return NULL;
+
+	plan_context = AllocSetContextCreate(CurrentMemoryContext,
+										 "CachedPlan",
+										 ALLOCSET_START_SMALL_SIZES);
+	MemoryContextCopyAndSetIdentifier(plan_context, plansource->query_string);
+	oldcxt = MemoryContextSwitchTo(plan_context);
+	plist = (List *) stringToNode(planstr);
+	plan = MakeCachedPlan(plansource, plist, plan_context);
 	MemoryContextSwitchTo(oldcxt);
+	pfree(planstr);
+
+	LinkGenericPlan(plansource, plan);
+
+	/*
+	 * Lock the relations the plan uses.  This also notices any invalidation
+	 * that arrived since the plan was found.
+	 */
+	if (!CheckCachedPlan(plansource))
+		return NULL;
 
 	return plan;
 }
 
+/*
+ * OfferSharedPlan: store a newly built generic plan in the shared plan
+ * cache.
+ *
+ * "version" is the shared plan cache's invalidation version as of before
+ * the query was revalidated.
+ */
+static void
+OfferSharedPlan(CachedPlanSource *plansource, CachedPlan *plan,
+				char *sharedkey, uint64 version)
+{
+	List	   *relationOids;
+	List	   *invalItems;
+	ListCell   *lc;
+
+	/* Transient plans are only good for a while */
+	if (TransactionIdIsValid(plan->saved_xmin))
+		return;
+
+	relationOids = list_copy(plansource->relationOids);
+	invalItems = list_copy(plansource->invalItems);
+	foreach(lc, plan->stmt_list)
+	{
+		PlannedStmt *plannedstmt = lfirst_node(PlannedStmt, lc);
+
+		relationOids = list_concat_unique_oid(relationOids,
+											  plannedstmt->relationOids);
+		invalItems = list_concat(invalItems,
+								 list_copy(plannedstmt->invalItems));
+	}
+
+	SharedPlanCacheInsert(sharedkey, strlen(sharedkey),
+						  nodeToString(plan->stmt_list),
+						  relationOids, invalItems, version);
+
+	list_free(relationOids);
+	list_free(invalItems);
+}
+
 /*
  * choose_custom_plan: choose whether to use custom or generic plan
  *
@@ -1047,6 +1239,27 @@ choose_custom_plan(CachedPlanSource *plansource, ParamListInfo boundParams)
 	if (plansource->num_custom_plans < 5)
 		return true;
 
+	/*
+	 * In adaptive mode, once both kinds of plan have actually been run,
+	 * prefer whichever has taken less time, counting planning time for the
+	 * custom plans.  The estimated costs can be far off, in particular when
+	 * the parameter values are skewed.
+	 */
+	if (plan_cache_mode == PLAN_CACHE_MODE_ADAPTIVE &&
+		plansource->generic_time >= 0 &&
+		plansource->custom_time >= 0)
+	{
+		bool		prefer_custom;
+
+		prefer_custom = (plansource->custom_time +
+						 Max(plansource->custom_plan_time, 0) <
+						 plansource->generic_time);
+
+		if (++plansource->num_adaptive_choices % ADAPTIVE_PROBE_INTERVAL == 0)
+			return !prefer_custom;
+		return prefer_custom;
+	}
+
 	avg_custom_cost = plansource->total_custom_cost / plansource->num_custom_plans;
 
 	/*
@@ -1065,6 +1278,20 @@ choose_custom_plan(CachedPlanSource *plansource, ParamListInfo boundParams)
 	return true;
 }
 
+/*
+ * update_time_average: fold a new sample into a running average
+ *
+ * A negative average means there have been no samples yet.
+ */
+static void
+update_time_average(double *average, double sample)
+{
+	if (*average < 0)
+		*average = sample;
+	else
+		*average += (sample - *average) / ADAPTIVE_SMOOTHING;
+}
+
 /*
  * cached_plan_cost: calculate estimated cost of a plan
  *
@@ -1144,6 +1371,8 @@ GetCachedPlan(CachedPlanSource *plansource, ParamListInfo boundParams,
 	CachedPlan *plan = NULL;
 	List	   *qlist;
 	bool		customplan;
+	char	   *sharedkey = NULL;
+	uint64		shared_version = 0;
 
 	/* Assert caller is doing things in a sane order */
 	Assert(plansource->magic == CACHEDPLANSOURCE_MAGIC);
@@ -1152,13 +1381,45 @@ GetCachedPlan(CachedPlanSource *plansource, ParamListInfo boundParams,
 	if (useResOwner && !plansource->is_saved)
 		elog(ERROR, "cannot apply ResourceOwner to non-saved cached plan");
 
+	/*
+	 * A generic plan we build may be offered to the shared plan cache, which
+	 * must be able to tell whether it was made before or after concurrent
+	 * invalidations.
+	 */
+	if (shared_plan_cache_size > 0 && plansource->is_saved)
+		shared_version = SharedPlanCacheGetVersion();
+
 	/* Make sure the querytree list is valid and we have parse-time locks */
 	qlist = RevalidateCachedQuery(plansource, queryEnv);
 
 	/* Decide whether to use a custom plan */
 	customplan = choose_custom_plan(plansource, boundParams);
 
-	if (!customplan)
+	/*
+	 * While we are still making custom plans to compare the generic plan
+	 * against, a generic plan in the shared plan cache means some other
+	 * session has already made that comparison and settled on it.
+	 */
+	if (customplan && shared_plan_cache_size > 0 &&
+		plansource->gplan == NULL &&
+		plansource->num_custom_plans < 5 &&
+		(plan_cache_mode == PLAN_CACHE_MODE_AUTO ||
+		 plan_cache_mode == PLAN_CACHE_MODE_ADAPTIVE) &&
+		!(plansource->cursor_options & CURSOR_OPT_CUSTOM_PLAN))
+	{
+		sharedkey = SharedPlanKey(plansource, queryEnv);
+		if (sharedkey != NULL)
+		{
+			plan = AdoptSharedPlan(plansource, sharedkey);
+			if (plan != NULL)
+			{
+				plansource->generic_cost = cached_plan_cost(plan, false);
+				customplan = false;
+			}
+		}
+	}
+
+	if (!customplan && plan == NULL)
 	{
 		if (CheckCachedPlan(plansource))
 		{
@@ -1168,28 +1429,26 @@ GetCachedPlan(CachedPlanSource *plansource, ParamListInfo boundParams,
 		}
 		else
 		{
-			/* Build a new generic plan */
-			plan = BuildCachedPlan(plansource, qlist, NULL, queryEnv);
-			/* Just make real sure plansource->gplan is clear */
-			ReleaseGenericPlan(plansource);
-			/* Link the new generic plan into the plansource */
-			plansource->gplan = plan;
-			plan->refcount++;
-			/* Immediately reparent into appropriate context */
-			if (plansource->is_saved)
-			{
-				/* saved plans all live under CacheMemoryContext */
-				MemoryContextSetParent(plan->context, CacheMemoryContext);
-				plan->is_saved = true;
-			}
-			else
+			/* Try the shared plan cache first */
+			if (sharedkey == NULL)
+				sharedkey = SharedPlanKey(plansource, queryEnv);
+			if (sharedkey != NULL)
+				plan = AdoptSharedPlan(plansource, sharedkey);
+
+			if (plan == NULL)
 			{
-				/* otherwise, it should be a sibling of the plansource */
-				MemoryContextSetParent(plan->context,
-									   MemoryContextGetParent(plansource->context));
+				/* Build a new generic plan */
+				plan = BuildCachedPlan(plansource, qlist, NULL, queryEnv);
+				LinkGenericPlan(plansource, plan);
+				if (sharedkey != NULL)
+					OfferSharedPlan(plansource, plan, sharedkey,
+									shared_version);
 			}
+
 			/* Update generic_cost whenever we make a new generic plan */
 			plansource->generic_cost = cached_plan_cost(plan, false);
+			/* ... and forget how long the previous one took */
+			plansource->generic_time = -1;
 
 			/*
 			 * If, based on the now-known value of generic_cost, we'd not have
@@ -1213,8 +1472,22 @@ GetCachedPlan(CachedPlanSource *plansource, ParamListInfo boundParams,
 
 	if (customplan)
 	{
+		instr_time	starttime;
+		instr_time	duration;
+
+		if (plan_cache_mode == PLAN_CACHE_MODE_ADAPTIVE)
+			INSTR_TIME_SET_CURRENT(starttime);
+
 		/* Build a custom plan */
 		plan = BuildCachedPlan(plansource, qlist, boundParams, queryEnv);
+
+		if (plan_cache_mode == PLAN_CACHE_MODE_ADAPTIVE)
+		{
+			INSTR_TIME_SET_CURRENT(duration);
+			INSTR_TIME_SUBTRACT(duration, starttime);
+			update_time_average(&plansource->custom_plan_time,
+								INSTR_TIME_GET_MILLISEC(duration));
+		}
 		/* Accumulate total costs of custom plans, but 'ware overflow */
 		if (plansource->num_custom_plans < INT_MAX)
 		{
@@ -1247,6 +1520,82 @@ GetCachedPlan(CachedPlanSource *plansource, ParamListInfo boundParams,
 	return plan;
 }
 
+/*
+ * GetSimplyValidCachedPlan: cheaply re-fetch a generic plan known to be valid
+ *
+ * This is a fast path for callers, such as PL/pgSQL's simple-expression
+ * evaluation, that repeatedly execute a plansource whose plan references no
+ * tables.  If the plansource's generic plan is still the one with the given
+ * generation and nothing has invalidated it, we can hand it back without the
+ * revalidation and locking work done by GetCachedPlan: with no relations
+ * involved there are no locks to take, and any invalidation of functions or
+ * types the plan depends on will already have cleared the is_valid flags.
+ *
+ * Returns NULL if the plan can't be proven valid this way; the caller should
+ * then fall back to GetCachedPlan.  On success the plan's refcount has been
+ * incremented exactly as GetCachedPlan would have done.
+ */
+CachedPlan *
+GetSimplyValidCachedPlan(CachedPlanSource *plansource, int generation,
+						 bool useResOwner)
+{
+	CachedPlan *plan = plansource->gplan;
+
+	Assert(plansource->magic == CACHEDPLANSOURCE_MAGIC);
+	Assert(plansource->is_complete);
+
+	if (!plansource->is_valid || plan == NULL ||
+		!plan->is_valid || plan->generation != generation)
+		return NULL;
+	Assert(plan->magic == CACHEDPLAN_MAGIC);
+	if (useResOwner && !plansource->is_saved)
+		return NULL;
+
+	/* Anything that involves tables needs the full treatment */
+	if (plansource->relationOids != NIL || plansource->is_oneshot ||
+		plansource->dependsOnRLS || plan->dependsOnRole ||
+		TransactionIdIsValid(plan->saved_xmin))
+		return NULL;
+
+	/* The plan could have been made for a different search_path */
+	if (!OverrideSearchPathMatchesCurrent(plansource->search_path))
+		return NULL;
+
+	/* Flag the plan as in use by caller */
+	if (useResOwner)
+		ResourceOwnerEnlargePlanCacheRefs(CurrentResourceOwner);
+	plan->refcount++;
+	if (useResOwner)
+		ResourceOwnerRememberPlanCacheRef(CurrentResourceOwner, plan);
+
+	return plan;
+}
+
+/*
+ * CachedPlanRecordRuntime: report how long a plan took to run.
+ *
+ * "plan" must have been obtained from GetCachedPlan on this plansource, and
+ * "elapsed" is the time in milliseconds it took to run it to completion.
+ * The measurements drive the choice between generic and custom plans when
+ * plan_cache_mode is "adaptive"; otherwise this does nothing, and callers
+ * need not measure anything.
+ */
+void
+CachedPlanRecordRuntime(CachedPlanSource *plansource, CachedPlan *plan,
+						double elapsed)
+{
+	Assert(plansource->magic == CACHEDPLANSOURCE_MAGIC);
+	Assert(plan->magic == CACHEDPLAN_MAGIC);
+
+	if (plan_cache_mode != PLAN_CACHE_MODE_ADAPTIVE)
+		return;
+
+	if (plan == plansource->gplan)
+		update_time_average(&plansource->generic_time, elapsed);
+	else
+		update_time_average(&plansource->custom_time, elapsed);
+}
+
 /*
  * ReleaseCachedPlan: release active use of a cached plan.
  *
@@ -1400,6 +1749,10 @@ CopyCachedPlan(CachedPlanSource *plansource)
 	newsource->generic_cost = plansource->generic_cost;
 	newsource->total_custom_cost = plansource->total_custom_cost;
 	newsource->num_custom_plans = plansource->num_custom_plans;
+	newsource->generic_time = plansource->generic_time;
+	newsource->custom_time = plansource->custom_time;
+	newsource->custom_plan_time = plansource->custom_plan_time;
+	newsource->num_adaptive_choices = plansource->num_adaptive_choices;
 
 	MemoryContextSwitchTo(oldcxt);
 
@@ -1563,6 +1916,32 @@ static void
 AcquireExecutorLocks(List *stmt_list, bool acquire)
 {
 	ListCell   *lc1;
+	Oid		   *relids = NULL;
+	LOCKMODE   *lockmodes = NULL;
+	int			nrels = 0;
+
+	/*
+	 * When acquiring, collect the relations from all the statements and lock
+	 * them in one batch, which is much cheaper than locking them one by one
+	 * when there are many, as with plans for heavily partitioned tables.
+	 */
+	if (acquire)
+	{
+		int			maxrels = 0;
+
+		foreach(lc1, stmt_list)
+		{
+			PlannedStmt *plannedstmt = lfirst_node(PlannedStmt, lc1);
+
+			if (plannedstmt->commandType != CMD_UTILITY)
+				maxrels += list_length(plannedstmt->rtable);
+		}
+		if (maxrels > 0)
+		{
+			relids = (Oid *) palloc(maxrels * sizeof(Oid));
+			lockmodes = (LOCKMODE *) palloc(maxrels * sizeof(LOCKMODE));
+		}
+	}
 
 	foreach(lc1, stmt_list)
 	{
@@ -1599,11 +1978,23 @@ AcquireExecutorLocks(List *stmt_list, bool acquire)
 			 * acquire a non-conflicting lock.
 			 */
 			if (acquire)
-				LockRelationOid(rte->relid, rte->rellockmode);
+			{
+				relids[nrels] = rte->relid;
+				lockmodes[nrels] = rte->rellockmode;
+				nrels++;
+			}
 			else
 				UnlockRelationOid(rte->relid, rte->rellockmode);
 		}
 	}
+
+	if (nrels > 0)
+		LockRelationOids(nrels, relids, lockmodes);
+	if (relids)
+	{
+		pfree(relids);
+		pfree(lockmodes);
+	}
 }
 
 /*
@@ -36,6 +36,7 @@
 #include "access/nbtree.h"
 #include "access/reloptions.h"
 #include "access/sysattr.h"
+#include "access/tableam.h"
 #include "access/tupdesc_details.h"
 #include "access/xact.h"
 #include "access/xlog.h"
@@ -120,10 +121,26 @@ typedef struct relidcacheent
 {
 	Oid			reloid;
 	Relation	reldesc;
+	dlist_node	lru_elem;		/* member of RelationLRU */
+	uint64		lastaccess;		/* catalog_cache_clock at last access */
+	Size		memusage;		/* estimated space taken by the entry */
 } RelIdCacheEnt;
 
 static HTAB *RelationIdCache;
 
+/*
+ * All entries of RelationIdCache, least recently used first, for evicting
+ * entries when catalog_cache_memory_target is exceeded; and statistics for
+ * the pg_catalog_caches view.  The space estimate for an entry is made where
+ * it is entered into the hash table and not updated when it is rebuilt in
+ * place.
+ */
+static dlist_head RelationLRU = DLIST_STATIC_INIT(RelationLRU);
+static Size relcacheMemUsage = 0;
+static long relcacheHits = 0L;
+static long relcacheLoads = 0L;
+static long relcacheEvictions = 0L;
+
 /*
  * This flag is false until we have prepared the critical relcache entries
  * that are needed to do indexscans on the tables read by relcache building.
@@ -196,9 +213,15 @@ do { \
 		else if (!IsBootstrapProcessingMode()) \
 			elog(WARNING, "leaking still-referenced relcache entry for \"%s\"", \
 				 RelationGetRelationName(_old_rel)); \
+		relcacheMemUsage -= hentry->memusage; \
+		dlist_delete(&hentry->lru_elem); \
 	} \
 	else \
 		hentry->reldesc = (RELATION); \
+	hentry->memusage = RelationMemoryEstimate(RELATION); \
+	relcacheMemUsage += hentry->memusage; \
+	hentry->lastaccess = ++catalog_cache_clock; \
+	dlist_push_tail(&RelationLRU, &hentry->lru_elem); \
 } while(0)
 
 #define RelationIdCacheLookup(ID, RELATION) \
@@ -222,6 +245,11 @@ do { \
 	if (hentry == NULL) \
 		elog(WARNING, "failed to delete relcache entry for OID %u", \
 			 (RELATION)->rd_id); \
+	else \
+	{ \
+		relcacheMemUsage -= hentry->memusage; \
+		dlist_delete(&hentry->lru_elem); \
+	} \
 } while(0)
 
 
@@ -247,6 +275,7 @@ static HTAB *OpClassCache = NULL;
 /* non-export function prototypes */
 
 static void RelationDestroyRelation(Relation relation, bool remember_tupdesc);
+static Size RelationMemoryEstimate(Relation relation);
 static void RelationClearRelation(Relation relation, bool rebuild);
 
 static void RelationReloadIndexInfo(Relation relation);
@@ -1196,10 +1225,32 @@ RelationBuildDesc(Oid targetRelId, bool insertIt)
 	}
 
 	/*
-	 * if it's an index, initialize index-related information
+	 * initialize access method information
 	 */
-	if (OidIsValid(relation->rd_rel->relam))
-		RelationInitIndexAccessInfo(relation);
+	switch (relation->rd_rel->relkind)
+	{
+		case RELKIND_INDEX:
+		case RELKIND_PARTITIONED_INDEX:
+			Assert(relation->rd_rel->relam != InvalidOid);
+			RelationInitIndexAccessInfo(relation);
+			break;
+		case RELKIND_RELATION:
+		case RELKIND_TOASTVALUE:
+		case RELKIND_MATVIEW:
+			Assert(relation->rd_rel->relam != InvalidOid);
+			RelationInitTableAccessMethod(relation);
+			break;
+		case RELKIND_SEQUENCE:
+			Assert(relation->rd_rel->relam == InvalidOid);
+			RelationInitTableAccessMethod(relation);
+			break;
+		case RELKIND_VIEW:
+		case RELKIND_COMPOSITE_TYPE:
+		case RELKIND_FOREIGN_TABLE:
+		case RELKIND_PARTITIONED_TABLE:
+			Assert(relation->rd_rel->relam == InvalidOid);
+			break;
+	}
 
 	/* extract reloptions if any */
 	RelationParseRelOptions(relation, pg_class_tuple);
@@ -1338,6 +1389,46 @@ InitIndexAmRoutine(Relation relation)
 	pfree(tmp);
 }
 
+/*
+ * Initialize table access method support for a relation with table storage
+ *
+ * Catalogs and sequences always use the heap, and we set them up without
+ * any catalog access: catalogs may need to be opened before the syscaches
+ * work, and sequences have no pg_class.relam.
+ */
+void
+RelationInitTableAccessMethod(Relation relation)
+{
+	HeapTuple	tuple;
+	Form_pg_am	aform;
+
+	if (relation->rd_rel->relkind == RELKIND_SEQUENCE)
+		relation->rd_amhandler = F_HEAP_TABLEAM_HANDLER;
+	else if (IsCatalogRelation(relation))
+	{
+		Assert(relation->rd_rel->relam == HEAP_TABLE_AM_OID);
+		relation->rd_amhandler = F_HEAP_TABLEAM_HANDLER;
+	}
+	else
+	{
+		/*
+		 * Look up the table's access method, save the OID of its handler
+		 * function
+		 */
+		tuple = SearchSysCache1(AMOID,
+								ObjectIdGetDatum(relation->rd_rel->relam));
+		if (!HeapTupleIsValid(tuple))
+			elog(ERROR, "cache lookup failed for access method %u",
+				 relation->rd_rel->relam);
+		aform = (Form_pg_am) GETSTRUCT(tuple);
+		relation->rd_amhandler = aform->amhandler;
+		ReleaseSysCache(tuple);
+	}
+
+	/* the handler returns a static struct, so there's nothing to copy */
+	relation->rd_tableam = GetTableAmRoutine(relation->rd_amhandler);
+}
+
 /*
  * Initialize index-access-method support data for an index relation
  */
@@ -1858,6 +1949,13 @@ formrdesc(const char *relationName, Oid relationReltype,
 	 */
 	RelationInitPhysicalAddr(relation);
 
+	/*
+	 * initialize the table AM handler; the nailed catalogs are all heaps
+	 */
+	relation->rd_rel->relam = HEAP_TABLE_AM_OID;
+	relation->rd_amhandler = F_HEAP_TABLEAM_HANDLER;
+	relation->rd_tableam = GetHeapamTableAmRoutine();
+
 	/*
 	 * initialize the rel-has-index flag, using hardwired knowledge
 	 */
@@ -1906,6 +2004,7 @@ formrdesc(const char *relationName, Oid relationReltype,
 Relation
 RelationIdGetRelation(Oid relationId)
 {
+	RelIdCacheEnt *hentry;
 	Relation	rd;
 
 	/* Make sure we're in an xact, even if this ends up being a cache hit */
@@ -1914,10 +2013,17 @@ RelationIdGetRelation(Oid relationId)
 	/*
 	 * first try to find reldesc in the cache
 	 */
-	RelationIdCacheLookup(relationId, rd);
+	hentry = (RelIdCacheEnt *) hash_search(RelationIdCache,
+										   (void *) &relationId,
+										   HASH_FIND, NULL);
 
-	if (RelationIsValid(rd))
+	if (hentry != NULL)
 	{
+		rd = hentry->reldesc;
+		relcacheHits++;
+		hentry->lastaccess = ++catalog_cache_clock;
+		dlist_move_tail(&RelationLRU, &hentry->lru_elem);
+
 		RelationIncrementReferenceCount(rd);
 		/* revalidate cache entry if necessary */
 		if (!rd->rd_isvalid)
@@ -1952,7 +2058,10 @@ RelationIdGetRelation(Oid relationId)
 	 */
 	rd = RelationBuildDesc(relationId, true);
 	if (RelationIsValid(rd))
+	{
+		relcacheLoads++;
 		RelationIncrementReferenceCount(rd);
+	}
 	return rd;
 }
 
@@ -2266,6 +2375,7 @@ RelationDestroyRelation(Relation relation, bool remember_tupdesc)
 	list_free(relation->rd_indexlist);
 	bms_free(relation->rd_indexattr);
 	bms_free(relation->rd_projindexattr);
+	bms_free(relation->rd_summarizedattr);
 	bms_free(relation->rd_keyattr);
 	bms_free(relation->rd_pkattr);
 	bms_free(relation->rd_idattr);
@@ -2293,6 +2403,114 @@ RelationDestroyRelation(Relation relation, bool remember_tupdesc)
 	pfree(relation);
 }
 
+/*
+ * Total space in a relcache entry's private memory context, if any
+ */
+static Size
+RelationContextSpace(MemoryContext context)
+{
+	MemoryContextCounters counters;
+
+	if (context == NULL)
+		return 0;
+
+	memset(&counters, 0, sizeof(counters));
+	context->methods->stats(context, NULL, NULL, &counters);
+
+	return counters.totalspace;
+}
+
+/*
+ * RelationMemoryEstimate
+ *
+ *	Estimate the space taken by a relcache entry, for
+ *	catalog_cache_memory_target.  We count the main structures and the
+ *	entry's private contexts, and ignore the smaller odds and ends.
+ */
+static Size
+RelationMemoryEstimate(Relation relation)
+{
+	Size		space;
+
+	space = GetMemoryChunkSpace(relation);
+	if (relation->rd_rel)
+		space += GetMemoryChunkSpace(relation->rd_rel);
+	if (relation->rd_att)
+		space += GetMemoryChunkSpace(relation->rd_att);
+	space += RelationContextSpace(relation->rd_indexcxt);
+	space += RelationContextSpace(relation->rd_rulescxt);
+	space += RelationContextSpace(relation->rd_partkeycxt);
+	space += RelationContextSpace(relation->rd_pdcxt);
+
+	return space;
+}
+
+/*
+ * RelationCacheMemoryUsage
+ *
+ *	Return the estimated space taken by the relcache.
+ */
+Size
+RelationCacheMemoryUsage(void)
+{
+	return relcacheMemUsage;
+}
+
+/*
+ * RelationCacheEvictOldest
+ *
+ *	Remove the least recently used relcache entry that nobody needs, provided
+ *	it was last used before "older_than" (a catalog_cache_clock value).
+ *	Returns true if an entry was removed.
+ *
+ *	Only to be called at transaction end; see CatalogCacheEnforceMemoryTarget.
+ */
+bool
+RelationCacheEvictOldest(uint64 older_than)
+{
+	dlist_iter	iter;
+
+	dlist_foreach(iter, &RelationLRU)
+	{
+		RelIdCacheEnt *hentry = dlist_container(RelIdCacheEnt, lru_elem,
+												iter.cur);
+		Relation	relation = hentry->reldesc;
+
+		if (hentry->lastaccess >= older_than)
+			break;
+
+		/* entries made or given new storage in this transaction must stay */
+		if (!RelationHasReferenceCountZero(relation) ||
+			relation->rd_isnailed ||
+			relation->rd_createSubid != InvalidSubTransactionId ||
+			relation->rd_newRelfilenodeSubid != InvalidSubTransactionId)
+			continue;
+
+		relcacheEvictions++;
+		RelationClearRelation(relation, false);
+		return true;
+	}
+
+	return false;
+}
+
+/*
+ * RelationCacheGetStats
+ *
+ *	Report the relcache's statistics, for the pg_catalog_caches view.
+ */
+void
+RelationCacheGetStats(long *entries, Size *memusage, long *hits, long *loads,
+					  long *evictions, long *invals)
+{
+	*entries = RelationIdCache ? hash_get_num_entries(RelationIdCache) : 0;
+	*memusage = relcacheMemUsage;
+	*hits = relcacheHits;
+	*loads = relcacheLoads;
+	*evictions = relcacheEvictions;
+	*invals = relcacheInvalsReceived;
+}
+
 /*
  * RelationClearRelation
  *
@@ -2880,6 +3098,9 @@ AtEOXact_RelationCache(bool isCommit)
 	eoxact_list_overflowed = false;
 	NextEOXactTupleDescNum = 0;
 	EOXactTupleDescArrayLen = 0;
+
+	/* This is the one safe place to evict relcache entries */
+	CatalogCacheEnforceMemoryTarget(true);
 }
 
 /*
@@ -3094,6 +3315,7 @@ RelationBuildLocalRelation(const char *relname,
 						   TupleDesc tupDesc,
 						   Oid relid,
 						   Oid relfilenode,
+						   Oid accessmtd,
 						   Oid reltablespace,
 						   bool shared_relation,
 						   bool mapped_relation,
@@ -3272,6 +3494,14 @@ RelationBuildLocalRelation(const char *relname,
 
 	RelationInitPhysicalAddr(rel);
 
+	rel->rd_rel->relam = accessmtd;
+
+	if (relkind == RELKIND_RELATION ||
+		relkind == RELKIND_SEQUENCE ||
+		relkind == RELKIND_TOASTVALUE ||
+		relkind == RELKIND_MATVIEW)
+		RelationInitTableAccessMethod(rel);
+
 	/*
 	 * Okay to insert into the relcache hash table.
 	 *
@@ -4757,6 +4987,11 @@ IsProjectionFunctionalIndex(Relation index, IndexInfo *ii)
  * for all potential foreign key columns, or for all columns in the configured
  * replica identity index is returned.
  *
+ * Columns used only by summarizing indexes (see amsummarizing) don't prevent
+ * HOT updates, since those indexes point at block ranges rather than at
+ * tuples.  They are reported by INDEX_ATTR_BITMAP_SUMMARIZED instead of
+ * INDEX_ATTR_BITMAP_HOT.
+ *
  * Attribute numbers are offset by FirstLowInvalidHeapAttributeNumber so that
  * we can include system attributes (e.g., OID) in the bitmap representation.
  *
@@ -4774,6 +5009,7 @@ RelationGetIndexAttrBitmap(Relation relation, IndexAttrBitmapKind attrKind)
 {
 	Bitmapset  *indexattrs;		/* columns used in non-projection indexes */
 	Bitmapset  *projindexattrs; /* columns used in projection indexes */
+	Bitmapset  *summarizedattrs;	/* columns used in summarizing indexes */
 	Bitmapset  *uindexattrs;	/* columns in unique indexes */
 	Bitmapset  *pkindexattrs;	/* columns in the primary index */
 	Bitmapset  *idindexattrs;	/* columns in the replica identity */
@@ -4795,6 +5031,8 @@ RelationGetIndexAttrBitmap(Relation relation, IndexAttrBitmapKind attrKind)
 				return bms_copy(relation->rd_indexattr);
 			case INDEX_ATTR_BITMAP_PROJ:
 				return bms_copy(relation->rd_projindexattr);
+			case INDEX_ATTR_BITMAP_SUMMARIZED:
+				return bms_copy(relation->rd_summarizedattr);
 			case INDEX_ATTR_BITMAP_KEY:
 				return bms_copy(relation->rd_keyattr);
 			case INDEX_ATTR_BITMAP_PRIMARY_KEY:
@@ -4842,6 +5080,7 @@ restart:
 	 */
 	indexattrs = NULL;
 	projindexattrs = NULL;
+	summarizedattrs = NULL;
 	uindexattrs = NULL;
 	pkindexattrs = NULL;
 	idindexattrs = NULL;
@@ -4856,6 +5095,7 @@ restart:
 		bool		isKey;		/* candidate key */
 		bool		isPK;		/* primary key */
 		bool		isIDKey;	/* replica identity index */
+		Bitmapset **attrs;
 
 		indexDesc = index_open(indexOid, AccessShareLock);
 
@@ -4873,6 +5113,16 @@ restart:
 		/* Is this index the configured (or default) replica identity? */
 		isIDKey = (indexOid == relreplindex);
 
+		/*
+		 * Decide where to put the columns this index uses: summarizing
+		 * indexes don't block HOT updates, so their columns are tracked
+		 * separately.
+		 */
+		if (indexDesc->rd_amroutine->amsummarizing)
+			attrs = &summarizedattrs;
+		else
+			attrs = &indexattrs;
+
 		/* Collect simple attribute references */
 		for (i = 0; i < indexInfo->ii_NumIndexAttrs; i++)
 		{
@@ -4888,8 +5138,8 @@ restart:
 			 */
 			if (attrnum != 0)
 			{
-				indexattrs = bms_add_member(indexattrs,
-											attrnum - FirstLowInvalidHeapAttributeNumber);
+				*attrs = bms_add_member(*attrs,
+										attrnum - FirstLowInvalidHeapAttributeNumber);
 
 				if (isKey && i < indexInfo->ii_NumIndexKeyAttrs)
 					uindexattrs = bms_add_member(uindexattrs,
@@ -4906,7 +5156,8 @@ restart:
 		}
 
 		/* Collect attributes used in expressions, too */
-		if (IsProjectionFunctionalIndex(indexDesc, indexInfo))
+		if (attrs == &indexattrs &&
+			IsProjectionFunctionalIndex(indexDesc, indexInfo))
 		{
 			projindexes = bms_add_member(projindexes, indexno);
 			pull_varattnos((Node *) indexInfo->ii_Expressions, 1, &projindexattrs);
@@ -4914,10 +5165,10 @@ restart:
 		else
 		{
 			/* Collect all attributes used in expressions, too */
-			pull_varattnos((Node *) indexInfo->ii_Expressions, 1, &indexattrs);
+			pull_varattnos((Node *) indexInfo->ii_Expressions, 1, attrs);
 		}
 		/* Collect all attributes in the index predicate, too */
-		pull_varattnos((Node *) indexInfo->ii_Predicate, 1, &indexattrs);
+		pull_varattnos((Node *) indexInfo->ii_Predicate, 1, attrs);
 
 		index_close(indexDesc, AccessShareLock);
 		indexno += 1;
@@ -4948,6 +5199,7 @@ restart:
 		bms_free(idindexattrs);
 		bms_free(indexattrs);
 		bms_free(projindexattrs);
+		bms_free(summarizedattrs);
 		bms_free(projindexes);
 
 		goto restart;
@@ -4958,6 +5210,8 @@ restart:
 	relation->rd_indexattr = NULL;
 	bms_free(relation->rd_projindexattr);
 	relation->rd_projindexattr = NULL;
+	bms_free(relation->rd_summarizedattr);
+	relation->rd_summarizedattr = NULL;
 	bms_free(relation->rd_keyattr);
 	relation->rd_keyattr = NULL;
 	bms_free(relation->rd_pkattr);
@@ -4980,6 +5234,7 @@ restart:
 	relation->rd_idattr = bms_copy(idindexattrs);
 	relation->rd_indexattr = bms_copy(indexattrs);
 	relation->rd_projindexattr = bms_copy(projindexattrs);
+	relation->rd_summarizedattr = bms_copy(summarizedattrs);
 	relation->rd_projidx = bms_copy(projindexes);
 	MemoryContextSwitchTo(oldcxt);
 
@@ -4990,6 +5245,8 @@ restart:
 			return indexattrs;
 		case INDEX_ATTR_BITMAP_PROJ:
 			return projindexattrs;
+		case INDEX_ATTR_BITMAP_SUMMARIZED:
+			return summarizedattrs;
 		case INDEX_ATTR_BITMAP_KEY:
 			return uindexattrs;
 		case INDEX_ATTR_BITMAP_PRIMARY_KEY:
@@ -5577,6 +5834,17 @@ load_relcache_init_file(bool shared)
 			Assert(rel->rd_supportinfo == NULL);
 			Assert(rel->rd_indoption == NULL);
 			Assert(rel->rd_indcollation == NULL);
+
+			/*
+			 * As for indexes, the table AM's API struct can't be stored in
+			 * the init file, so look it up again.
+			 */
+			rel->rd_tableam = NULL;
+			if (relform->relkind == RELKIND_RELATION ||
+				relform->relkind == RELKIND_SEQUENCE ||
+				relform->relkind == RELKIND_TOASTVALUE ||
+				relform->relkind == RELKIND_MATVIEW)
+				RelationInitTableAccessMethod(rel);
 		}
 
 		/*
@@ -5619,6 +5887,7 @@ load_relcache_init_file(bool shared)
 		rel->rd_replidindex = InvalidOid;
 		rel->rd_indexattr = NULL;
 		rel->rd_projindexattr = NULL;
+		rel->rd_summarizedattr = NULL;
 		rel->rd_keyattr = NULL;
 		rel->rd_pkattr = NULL;
 		rel->rd_idattr = NULL;
@@ -0,0 +1,512 @@
+/*-------------------------------------------------------------------------
+ *
+ * sharedcatcache.c
+ *	  Shared second-level catalog cache.
+ *
+ * Each backend keeps its own catalog caches (see catcache.c), and a new
+ * backend starts with all of them empty, so it has to read every catalog
+ * row it needs from the catalogs again.  With many short-lived connections
+ * that warm-up cost is paid over and over, for the same rows.  When
+ * shared_catalog_cache_size is set, catalog tuples that a backend loads are
+ * also copied into a dshash table in a dynamic shared memory area that lives
+ * in the main shared memory segment, and a catcache miss looks there before
+ * scanning the catalog.  A backend still builds its own CatCTup from the
+ * shared copy, since reference counts and list membership are per-backend;
+ * only the catalog access is saved.
+ *
+ * Entries are keyed by database, cache ID and hash value, the same triple
+ * that catcache invalidation messages carry, and each entry holds the
+ * tuples with that hash value (normally one).  Negative entries are never
+ * shared.
+ *
+ * Keeping the shared copies correct relies on the ordinary invalidation
+ * messages: SendSharedInvalidMessages() hands every batch to
+ * SharedCatCacheInvalidateMessages() before queueing it, which removes the
+ * affected entries.  The catalog changes become visible to other backends
+ * before their transaction sends its messages, so a backend may have read
+ * the old version of a row just before the messages are sent.  To keep it
+ * from storing that stale tuple after the entries were removed, a global
+ * version counter is advanced before any entries are removed;
+ * a backend reads the counter before taking a fresh catalog snapshot for
+ * its scan and stores what it found only if the counter hasn't moved in the
+ * meantime.  The check is made under the partition lock, which the removal
+ * also takes, so no stale tuple can slip in between.
+ *
+ * The shared cache is bypassed whenever a backend might see catalog rows
+ * that other backends must not: while the current transaction has pending
+ * invalidations (i.e. has modified the catalogs itself), with a historic
+ * snapshot during logical decoding, and outside normal processing.
+ *
+ * The area never grows beyond its preallocated size.  Insertions stop once
+ * the entries take up half of it, which leaves room for the hash table's
+ * bucket arrays and for fragmentation, and resume as invalidations free
+ * space.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *	  src/backend/utils/cache/sharedcatcache.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/htup_details.h"
+#include "lib/dshash.h"
+#include "miscadmin.h"
+#include "port/atomics.h"
+#include "storage/ipc.h"
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
+#include "utils/dsa.h"
+#include "utils/memutils.h"
+#include "utils/sharedcatcache.h"
+
+
+/* GUC variable */
+int			shared_catalog_cache_size = 0;
+
+/* The area is never made smaller than this, whatever the setting */
+#define SCC_MIN_AREA_SIZE	(1024 * 1024)
+
+typedef struct SharedCatCacheKey
+{
+	Oid			dbId;			/* InvalidOid for shared catalogs */
+	int			cacheId;
+	uint32		hashValue;
+} SharedCatCacheKey;
+
+typedef struct SharedCatCacheEntry
+{
+	SharedCatCacheKey key;		/* hash key; must be first */
+	Oid			reloid;			/* catalog the tuples come from */
+	dsa_pointer tuples;			/* chain of SharedCatCacheTuple */
+} SharedCatCacheEntry;
+
+typedef struct SharedCatCacheTuple
+{
+	dsa_pointer next;
+	ItemPointerData t_self;
+	Oid			t_tableOid;
+	uint32		t_len;
+	/* tuple header and data follow, at SCC_TUPLE_HDRSZ */
+} SharedCatCacheTuple;
+
+#define SCC_TUPLE_HDRSZ		MAXALIGN(sizeof(SharedCatCacheTuple))
+
+typedef struct SharedCatCacheControl
+{
+	dshash_table_handle hash_handle;
+	pg_atomic_uint64 version;	/* advanced before entries are removed */
+	pg_atomic_uint64 bytes_used;	/* space taken by entries and tuples */
+} SharedCatCacheControl;
+
+#define SharedCatCacheDSAPlace(ctl) \
+	((char *) (ctl) + MAXALIGN(sizeof(SharedCatCacheControl)))
+
+static const dshash_parameters scc_hash_params = {
+	sizeof(SharedCatCacheKey),
+	sizeof(SharedCatCacheEntry),
+	dshash_memcmp,
+	dshash_memhash,
+	LWTRANCHE_SHARED_CATCACHE_HASH
+};
+
+static SharedCatCacheControl *sccShmem = NULL;
+
+/* this backend's attachment, made on first use */
+static dsa_area *sccArea = NULL;
+static dshash_table *sccHash = NULL;
+
+static void scc_attach(void);
+static void scc_detach(int code, Datum arg);
+static void scc_free_tuples(SharedCatCacheEntry *entry);
+
+
+static Size
+scc_area_size(void)
+{
+	Size		size;
+
+	size = mul_size((Size) shared_catalog_cache_size, 1024);
+	size = Max(size, SCC_MIN_AREA_SIZE);
+
+	return MAXALIGN(add_size(dsa_minimum_size(), size));
+}
+
+/*
+ * SharedCatCacheShmemSize
+ *		Compute space needed for the shared catalog cache
+ */
+Size
+SharedCatCacheShmemSize(void)
+{
+	Size		size;
+
+	if (shared_catalog_cache_size <= 0)
+		return 0;
+
+	size = MAXALIGN(sizeof(SharedCatCacheControl));
+	size = add_size(size, scc_area_size());
+
+	return size;
+}
+
+/*
+ * SharedCatCacheShmemInit
+ *		Allocate and initialize the shared catalog cache
+ *
+ * As in StatsShmemInit(), the postmaster (or a standalone backend) creates
+ * the DSA area and the hash table in it, and backends attach on first use.
+ */
+void
+SharedCatCacheShmemInit(void)
+{
+	bool		found;
+
+	if (shared_catalog_cache_size <= 0)
+		return;
+
+	sccShmem = (SharedCatCacheControl *)
+		ShmemInitStruct("Shared Catalog Cache", SharedCatCacheShmemSize(),
+						&found);
+
+	if (!IsUnderPostmaster)
+	{
+		dsa_area   *area;
+		dshash_table *dsh;
+
+		Assert(!found);
+
+		area = dsa_create_in_place(SharedCatCacheDSAPlace(sccShmem),
+								   scc_area_size(),
+								   LWTRANCHE_SHARED_CATCACHE_DSA, NULL);
+		dsa_pin(area);
+
+		/*
+		 * Unlike the statistics area, this one is never allowed to grow into
+		 * DSM segments, so the limit stays in place.
+		 */
+		dsa_set_size_limit(area, scc_area_size());
+
+		dsh = dshash_create(area, &scc_hash_params, NULL);
+		sccShmem->hash_handle = dshash_get_hash_table_handle(dsh);
+		dshash_detach(dsh);
+
+		dsa_detach(area);
+
+		pg_atomic_init_u64(&sccShmem->version, 0);
+		pg_atomic_init_u64(&sccShmem->bytes_used, 0);
+	}
+	else
+		Assert(found);
+}
+
+/*
+ * Attach to the shared hash table, unless we already did.  The attachment is
+ * kept until process exit.
+ */
+static void
+scc_attach(void)
+{
+	MemoryContext oldcontext;
+
+	if (sccArea != NULL)
+		return;
+
+	Assert(sccShmem != NULL);
+
+	oldcontext = MemoryContextSwitchTo(TopMemoryContext);
+
+	sccArea = dsa_attach_in_place(SharedCatCacheDSAPlace(sccShmem), NULL);
+	dsa_pin_mapping(sccArea);
+	sccHash = dshash_attach(sccArea, &scc_hash_params,
+							sccShmem->hash_handle, NULL);
+
+	MemoryContextSwitchTo(oldcontext);
+
+	on_shmem_exit(scc_detach, (Datum) 0);
+}
+
+static void
+scc_detach(int code, Datum arg)
+{
+	if (sccArea == NULL)
+		return;
+
+	dshash_detach(sccHash);
+	dsa_detach(sccArea);
+	sccHash = NULL;
+	sccArea = NULL;
+}
+
+/*
+ * Free the tuple chain of an entry, which must be locked exclusively.
+ */
+static void
+scc_free_tuples(SharedCatCacheEntry *entry)
+{
+	dsa_pointer dp = entry->tuples;
+
+	while (DsaPointerIsValid(dp))
+	{
+		SharedCatCacheTuple *stup = dsa_get_address(sccArea, dp);
+		dsa_pointer next = stup->next;
+
+		pg_atomic_fetch_sub_u64(&sccShmem->bytes_used,
+								SCC_TUPLE_HDRSZ + stup->t_len);
+		dsa_free(sccArea, dp);
+		dp = next;
+	}
+	entry->tuples = InvalidDsaPointer;
+}
+
+/*
+ * SharedCatCacheGetVersion
+ *		Return the current invalidation version
+ *
+ * A caller that wants to insert tuples read from a catalog must get the
+ * version before taking the snapshot for its scan.
+ */
+uint64
+SharedCatCacheGetVersion(void)
+{
+	uint64		version;
+
+	Assert(sccShmem != NULL);
+
+	version = pg_atomic_read_u64(&sccShmem->version);
+	/* keep the caller's snapshot from being taken before the read */
+	pg_memory_barrier();
+
+	return version;
+}
+
+/*
+ * SharedCatCacheSearch
+ *		Return copies of the shared tuples with the given key
+ *
+ * The result is a list of palloc'd HeapTuples in the current memory context,
+ * possibly including tuples that only share the hash value; callers must
+ * check the keys themselves.  NIL means the shared cache knows nothing
+ * about the key.
+ */
+List *
+SharedCatCacheSearch(Oid dbId, int cacheId, uint32 hashValue)
+{
+	SharedCatCacheKey key;
+	SharedCatCacheEntry *entry;
+	dsa_pointer dp;
+	List	   *result = NIL;
+
+	scc_attach();
+
+	key.dbId = dbId;
+	key.cacheId = cacheId;
+	key.hashValue = hashValue;
+
+	entry = dshash_find(sccHash, &key, false);
+	if (entry == NULL)
+		return NIL;
+
+	for (dp = entry->tuples; DsaPointerIsValid(dp);)
+	{
+		SharedCatCacheTuple *stup = dsa_get_address(sccArea, dp);
+		HeapTuple	tuple;
+
+		tuple = (HeapTuple) palloc(HEAPTUPLESIZE + stup->t_len);
+		tuple->t_len = stup->t_len;
+		tuple->t_self = stup->t_self;
+		tuple->t_tableOid = stup->t_tableOid;
+		tuple->t_data = (HeapTupleHeader) ((char *) tuple + HEAPTUPLESIZE);
+		memcpy(tuple->t_data, (char *) stup + SCC_TUPLE_HDRSZ, stup->t_len);
+
+		result = lappend(result, tuple);
+		dp = stup->next;
+	}
+
+	dshash_release_lock(sccHash, entry);
+
+	return result;
+}
+
+/*
+ * SharedCatCacheInsert
+ *		Store a catalog tuple in the shared cache
+ *
+ * "version" is what SharedCatCacheGetVersion() returned before the tuple was
+ * read; if invalidations have been sent since, the tuple may be stale and is
+ * not stored.  Nor is it stored when the cache is full.  The tuple must not
+ * contain any out-of-line values.
+ */
+void
+SharedCatCacheInsert(Oid dbId, int cacheId, Oid reloid, uint32 hashValue,
+					 HeapTuple tuple, uint64 version)
+{
+	SharedCatCacheKey key;
+	SharedCatCacheEntry *entry;
+	SharedCatCacheTuple *stup;
+	dsa_pointer dp;
+	Size		tupsize;
+	bool		found;
+
+	Assert(!HeapTupleHasExternal(tuple));
+
+	scc_attach();
+
+	/* cheap checks before locking anything */
+	if (pg_atomic_read_u64(&sccShmem->version) != version)
+		return;
+	tupsize = SCC_TUPLE_HDRSZ + tuple->t_len;
+	if (pg_atomic_read_u64(&sccShmem->bytes_used) +
+		tupsize + sizeof(SharedCatCacheEntry) > scc_area_size() / 2)
+		return;
+
+	/*
+	 * Allocate the copy first, so that running out of space costs nothing
+	 * but the allocation attempt.
+	 */
+	dp = dsa_allocate_extended(sccArea, tupsize, DSA_ALLOC_NO_OOM);
+	if (!DsaPointerIsValid(dp))
+		return;
+	stup = dsa_get_address(sccArea, dp);
+	stup->next = InvalidDsaPointer;
+	stup->t_self = tuple->t_self;
+	stup->t_tableOid = tuple->t_tableOid;
+	stup->t_len = tuple->t_len;
+	memcpy((char *) stup + SCC_TUPLE_HDRSZ, tuple->t_data, tuple->t_len);
+
+	key.dbId = dbId;
+	key.cacheId = cacheId;
+	key.hashValue = hashValue;
+
+	entry = dshash_find_or_insert(sccHash, &key, &found);
+	if (!found)
+	{
+		entry->reloid = reloid;
+		entry->tuples = InvalidDsaPointer;
+		pg_atomic_fetch_add_u64(&sccShmem->bytes_used,
+								sizeof(SharedCatCacheEntry));
+	}
+
+	/*
+	 * Recheck the version now that we hold the partition lock; any removal
+	 * of this entry that comes after the version was advanced will have to
+	 * wait for us.
+	 */
+	if (pg_atomic_read_u64(&sccShmem->version) != version)
+	{
+		dsa_free(sccArea, dp);
+		if (!DsaPointerIsValid(entry->tuples))
+		{
+			pg_atomic_fetch_sub_u64(&sccShmem->bytes_used,
+									sizeof(SharedCatCacheEntry));
+			dshash_delete_entry(sccHash, entry);
+		}
+		else
+			dshash_release_lock(sccHash, entry);
+		return;
+	}
+
+	/* another backend may have stored the same tuple already */
+	if (found)
+	{
+		dsa_pointer cur;
+
+		for (cur = entry->tuples; DsaPointerIsValid(cur);)
+		{
+			SharedCatCacheTuple *other = dsa_get_address(sccArea, cur);
+
+			if (ItemPointerEquals(&other->t_self, &tuple->t_self))
+			{
+				dsa_free(sccArea, dp);
+				dshash_release_lock(sccHash, entry);
+				return;
+			}
+			cur = other->next;
+		}
+	}
+
+	stup->next = entry->tuples;
+	entry->tuples = dp;
+	pg_atomic_fetch_add_u64(&sccShmem->bytes_used, tupsize);
+
+	dshash_release_lock(sccHash, entry);
+}
+
+/*
+ * SharedCatCacheInvalidateMessages
+ *		Remove the entries that a batch of invalidation messages affects
+ *
+ * Called for every batch of messages sent to the other backends, before
+ * they are queued.
+ */
+void
+SharedCatCacheInvalidateMessages(const SharedInvalidationMessage *msgs, int n)
+{
+	bool		relevant = false;
+	int			i;
+
+	if (sccShmem == NULL)
+		return;
+
+	for (i = 0; i < n; i++)
+	{
+		if (msgs[i].id >= 0 || msgs[i].id == SHAREDINVALCATALOG_ID)
+		{
+			relevant = true;
+			break;
+		}
+	}
+	if (!relevant)
+		return;
+
+	scc_attach();
+
+	/* must come before any removal; see file header */
+	pg_atomic_fetch_add_u64(&sccShmem->version, 1);
+
+	for (i = 0; i < n; i++)
+	{
+		const SharedInvalidationMessage *msg = &msgs[i];
+
+		if (msg->id >= 0)
+		{
+			SharedCatCacheKey key;
+			SharedCatCacheEntry *entry;
+
+			key.dbId = msg->cc.dbId;
+			key.cacheId = msg->cc.id;
+			key.hashValue = msg->cc.hashValue;
+
+			entry = dshash_find(sccHash, &key, true);
+			if (entry != NULL)
+			{
+				scc_free_tuples(entry);
+				pg_atomic_fetch_sub_u64(&sccShmem->bytes_used,
+										sizeof(SharedCatCacheEntry));
+				dshash_delete_entry(sccHash, entry);
+			}
+		}
+		else if (msg->id == SHAREDINVALCATALOG_ID)
+		{
+			dshash_seq_status status;
+			SharedCatCacheEntry *entry;
+
+			dshash_seq_init(&status, sccHash, true);
+			while ((entry = dshash_seq_next(&status)) != NULL)
+			{
+				if (entry->reloid != msg->cat.catId ||
+					entry->key.dbId != msg->cat.dbId)
+					continue;
+
+				scc_free_tuples(entry);
+				pg_atomic_fetch_sub_u64(&sccShmem->bytes_used,
+										sizeof(SharedCatCacheEntry));
+				dshash_delete_current(&status);
+			}
+			dshash_seq_term(&status);
+		}
+	}
+}
@@ -0,0 +1,574 @@
+/*-------------------------------------------------------------------------
+ *
+ * sharedplancache.c
+ *	  Shared cache of generic plans.
+ *
+ * The plan cache (see plancache.c) is private to each backend, so when many
+ * connections run the same statements each of them plans every statement
+ * for itself, and keeps its own copy of the plan.  This is at its worst
+ * behind a transaction-mode connection pooler, where a client cannot rely
+ * on named prepared statements surviving and every query arrives as a new
+ * unnamed one.  When shared_plan_cache_size is set, generic plans that a
+ * backend builds are also stored, in nodeToString() form, in a dshash table
+ * in a dynamic shared memory area that lives in the main shared memory
+ * segment, and GetCachedPlan() looks there before planning.  A backend that
+ * finds a plan reads it back into its own memory and uses it like one it
+ * had built itself.
+ *
+ * Parse analysis and rewriting are still done locally; the cache is keyed
+ * by the resulting query trees, serialized, together with the database,
+ * the current user and the cursor options.  Keying on the query trees
+ * rather than on the query text takes care of everything that can make the
+ * same text mean different things in different sessions: the search_path,
+ * temporary objects, and settings such as TimeZone that affect how
+ * constants are read.  The hash table key holds only a hash of the string;
+ * each entry has a chain of plans whose full key strings are compared on
+ * lookup.  Settings that affect only the planner, such as work_mem or the
+ * enable_* parameters, are not part of the key: a backend may be given a
+ * plan that was made under different planner settings.
+ *
+ * A shared plan is removed by the same invalidation events that would make
+ * a backend discard its local copy, following the rules that
+ * PlanCacheRelCallback() and friends apply: relcache invalidations for any
+ * relation the plan depends on, pg_proc and pg_type invalidations for the
+ * functions and domains it depends on, and invalidations of the catalogs
+ * for which the plan cache simply drops everything.  The removal is done by
+ * the backend sending the messages, in SendSharedInvalidMessages(), and
+ * uses the same version counter scheme as sharedcatcache.c to keep a plan
+ * made from stale catalog contents from being stored just after the
+ * invalidation went by.
+ *
+ * The area never grows beyond its preallocated size.  Insertions stop once
+ * the plans take up half of it, and resume as invalidations free space.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *	  src/backend/utils/cache/sharedplancache.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/hash.h"
+#include "lib/dshash.h"
+#include "miscadmin.h"
+#include "nodes/plannodes.h"
+#include "port/atomics.h"
+#include "storage/ipc.h"
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
+#include "utils/dsa.h"
+#include "utils/memutils.h"
+#include "utils/sharedplancache.h"
+#include "utils/syscache.h"
+
+
+/* GUC variable */
+int			shared_plan_cache_size = 0;
+
+/* The area is never made smaller than this, whatever the setting */
+#define SPC_MIN_AREA_SIZE	(1024 * 1024)
+
+typedef struct SharedPlanCacheKey
+{
+	Oid			dbId;
+	Oid			roleId;
+	uint32		hashValue;		/* hash of the key string */
+} SharedPlanCacheKey;
+
+typedef struct SharedPlanCacheEntry
+{
+	SharedPlanCacheKey key;		/* hash key; must be first */
+	dsa_pointer plans;			/* chain of SharedPlan */
+} SharedPlanCacheEntry;
+
+typedef struct SharedPlanInvalItem
+{
+	int			cacheId;
+	uint32		hashValue;
+} SharedPlanInvalItem;
+
+/*
+ * A stored plan.  The header is followed by the relation OIDs, the
+ * invalidation items, the key string and the plan string, in that order.
+ */
+typedef struct SharedPlan
+{
+	dsa_pointer next;
+	Size		size;			/* total allocated size */
+	int			nrels;
+	int			nitems;
+	Size		keylen;
+	Size		planlen;		/* not counting the terminating NUL */
+} SharedPlan;
+
+#define SPC_PLAN_HDRSZ		MAXALIGN(sizeof(SharedPlan))
+#define SharedPlanRels(sp) \
+	((Oid *) ((char *) (sp) + SPC_PLAN_HDRSZ))
+#define SharedPlanItems(sp) \
+	((SharedPlanInvalItem *) MAXALIGN(SharedPlanRels(sp) + (sp)->nrels))
+#define SharedPlanKeyString(sp) \
+	((char *) (SharedPlanItems(sp) + (sp)->nitems))
+#define SharedPlanString(sp) \
+	(SharedPlanKeyString(sp) + (sp)->keylen)
+
+typedef struct SharedPlanCacheControl
+{
+	dshash_table_handle hash_handle;
+	pg_atomic_uint64 version;	/* advanced before plans are removed */
+	pg_atomic_uint64 bytes_used;	/* space taken by entries and plans */
+} SharedPlanCacheControl;
+
+#define SharedPlanCacheDSAPlace(ctl) \
+	((char *) (ctl) + MAXALIGN(sizeof(SharedPlanCacheControl)))
+
+static const dshash_parameters spc_hash_params = {
+	sizeof(SharedPlanCacheKey),
+	sizeof(SharedPlanCacheEntry),
+	dshash_memcmp,
+	dshash_memhash,
+	LWTRANCHE_SHARED_PLANCACHE_HASH
+};
+
+static SharedPlanCacheControl *spcShmem = NULL;
+
+/* this backend's attachment, made on first use */
+static dsa_area *spcArea = NULL;
+static dshash_table *spcHash = NULL;
+
+static void spc_attach(void);
+static void spc_detach(int code, Datum arg);
+static bool spc_plan_affected(Oid dbId, SharedPlan *sp,
+				  const SharedInvalidationMessage *msgs, int n);
+
+
+static Size
+spc_area_size(void)
+{
+	Size		size;
+
+	size = mul_size((Size) shared_plan_cache_size, 1024);
+	size = Max(size, SPC_MIN_AREA_SIZE);
+
+	return MAXALIGN(add_size(dsa_minimum_size(), size));
+}
+
+/*
+ * SharedPlanCacheShmemSize
+ *		Compute space needed for the shared plan cache
+ */
+Size
+SharedPlanCacheShmemSize(void)
+{
+	Size		size;
+
+	if (shared_plan_cache_size <= 0)
+		return 0;
+
+	size = MAXALIGN(sizeof(SharedPlanCacheControl));
+	size = add_size(size, spc_area_size());
+
+	return size;
+}
+
+/*
+ * SharedPlanCacheShmemInit
+ *		Allocate and initialize the shared plan cache
+ *
+ * This works like SharedCatCacheShmemInit().
+ */
+void
+SharedPlanCacheShmemInit(void)
+{
+	bool		found;
+
+	if (shared_plan_cache_size <= 0)
+		return;
+
+	spcShmem = (SharedPlanCacheControl *)
+		ShmemInitStruct("Shared Plan Cache", SharedPlanCacheShmemSize(),
+						&found);
+
+	if (!IsUnderPostmaster)
+	{
+		dsa_area   *area;
+		dshash_table *dsh;
+
+		Assert(!found);
+
+		area = dsa_create_in_place(SharedPlanCacheDSAPlace(spcShmem),
+								   spc_area_size(),
+								   LWTRANCHE_SHARED_PLANCACHE_DSA, NULL);
+		dsa_pin(area);
+		dsa_set_size_limit(area, spc_area_size());
+
+		dsh = dshash_create(area, &spc_hash_params, NULL);
+		spcShmem->hash_handle = dshash_get_hash_table_handle(dsh);
+		dshash_detach(dsh);
+
+		dsa_detach(area);
+
+		pg_atomic_init_u64(&spcShmem->version, 0);
+		pg_atomic_init_u64(&spcShmem->bytes_used, 0);
+	}
+	else
+		Assert(found);
+}
+
+/*
+ * Attach to the shared hash table, unless we already did.  The attachment is
+ * kept until process exit.
+ */
+static void
+spc_attach(void)
+{
+	MemoryContext oldcontext;
+
+	if (spcArea != NULL)
+		return;
+
+	Assert(spcShmem != NULL);
+
+	oldcontext = MemoryContextSwitchTo(TopMemoryContext);
+
+	spcArea = dsa_attach_in_place(SharedPlanCacheDSAPlace(spcShmem), NULL);
+	dsa_pin_mapping(spcArea);
+	spcHash = dshash_attach(spcArea, &spc_hash_params,
+							spcShmem->hash_handle, NULL);
+
+	MemoryContextSwitchTo(oldcontext);
+
+	on_shmem_exit(spc_detach, (Datum) 0);
+}
+
+static void
+spc_detach(int code, Datum arg)
+{
+	if (spcArea == NULL)
+		return;
+
+	dshash_detach(spcHash);
+	dsa_detach(spcArea);
+	spcHash = NULL;
+	spcArea = NULL;
+}
+
+static void
+spc_set_key(SharedPlanCacheKey *hkey, const char *key, Size keylen)
+{
+	hkey->dbId = MyDatabaseId;
+	hkey->roleId = GetUserId();
+	hkey->hashValue = DatumGetUInt32(hash_any((const unsigned char *) key,
+											  (int) keylen));
+}
+
+/*
+ * SharedPlanCacheGetVersion
+ *		Return the current invalidation version
+ *
+ * A caller that wants to insert a plan must get the version before it
+ * revalidates the query the plan is made from.
+ */
+uint64
+SharedPlanCacheGetVersion(void)
+{
+	uint64		version;
+
+	Assert(spcShmem != NULL);
+
+	version = pg_atomic_read_u64(&spcShmem->version);
+	/* keep the caller's catalog reads from being done before this */
+	pg_memory_barrier();
+
+	return version;
+}
+
+/*
+ * SharedPlanCacheLookup
+ *		Return a palloc'd copy of the plan stored under the given key
+ *
+ * Returns NULL if there is none.  The key is only valid for the current
+ * database and user.
+ */
+char *
+SharedPlanCacheLookup(const char *key, Size keylen)
+{
+	SharedPlanCacheKey hkey;
+	SharedPlanCacheEntry *entry;
+	dsa_pointer dp;
+	char	   *result = NULL;
+
+	spc_attach();
+
+	spc_set_key(&hkey, key, keylen);
+
+	entry = dshash_find(spcHash, &hkey, false);
+	if (entry == NULL)
+		return NULL;
+
+	for (dp = entry->plans; DsaPointerIsValid(dp);)
+	{
+		SharedPlan *sp = dsa_get_address(spcArea, dp);
+
+		if (sp->keylen == keylen &&
+			memcmp(SharedPlanKeyString(sp), key, keylen) == 0)
+		{
+			result = palloc(sp->planlen + 1);
+			memcpy(result, SharedPlanString(sp), sp->planlen + 1);
+			break;
+		}
+		dp = sp->next;
+	}
+
+	dshash_release_lock(spcHash, entry);
+
+	return result;
+}
+
+/*
+ * SharedPlanCacheInsert
+ *		Store a plan in the shared cache
+ *
+ * "relationOids" and "invalItems" are the plan's dependencies, as collected
+ * by the planner.  "version" is what SharedPlanCacheGetVersion() returned
+ * before the query was revalidated; if invalidations have been sent since,
+ * the plan may be stale and is not stored.  Nor is it stored when the cache
+ * is full.
+ */
+void
+SharedPlanCacheInsert(const char *key, Size keylen, const char *plan,
+					  List *relationOids, List *invalItems, uint64 version)
+{
+	SharedPlanCacheKey hkey;
+	SharedPlanCacheEntry *entry;
+	SharedPlan *sp;
+	dsa_pointer dp;
+	dsa_pointer cur;
+	Size		planlen = strlen(plan);
+	Size		size;
+	bool		found;
+	ListCell   *lc;
+	int			i;
+
+	spc_attach();
+
+	/* cheap checks before locking anything */
+	if (pg_atomic_read_u64(&spcShmem->version) != version)
+		return;
+
+	size = SPC_PLAN_HDRSZ;
+	size = add_size(size, MAXALIGN(mul_size(sizeof(Oid),
+											list_length(relationOids))));
+	size = add_size(size, mul_size(sizeof(SharedPlanInvalItem),
+								   list_length(invalItems)));
+	size = add_size(size, keylen);
+	size = add_size(size, planlen + 1);
+
+	if (pg_atomic_read_u64(&spcShmem->bytes_used) +
+		size + sizeof(SharedPlanCacheEntry) > spc_area_size() / 2)
+		return;
+
+	dp = dsa_allocate_extended(spcArea, size, DSA_ALLOC_NO_OOM);
+	if (!DsaPointerIsValid(dp))
+		return;
+	sp = dsa_get_address(spcArea, dp);
+	sp->next = InvalidDsaPointer;
+	sp->size = size;
+	sp->nrels = list_length(relationOids);
+	sp->nitems = list_length(invalItems);
+	sp->keylen = keylen;
+	sp->planlen = planlen;
+
+	i = 0;
+	foreach(lc, relationOids)
+		SharedPlanRels(sp)[i++] = lfirst_oid(lc);
+	i = 0;
+	foreach(lc, invalItems)
+	{
+		PlanInvalItem *item = lfirst_node(PlanInvalItem, lc);
+
+		SharedPlanItems(sp)[i].cacheId = item->cacheId;
+		SharedPlanItems(sp)[i].hashValue = item->hashValue;
+		i++;
+	}
+	memcpy(SharedPlanKeyString(sp), key, keylen);
+	memcpy(SharedPlanString(sp), plan, planlen + 1);
+
+	spc_set_key(&hkey, key, keylen);
+
+	entry = dshash_find_or_insert(spcHash, &hkey, &found);
+	if (!found)
+	{
+		entry->plans = InvalidDsaPointer;
+		pg_atomic_fetch_add_u64(&spcShmem->bytes_used,
+								sizeof(SharedPlanCacheEntry));
+	}
+
+	/* recheck under the partition lock; see sharedcatcache.c */
+	if (pg_atomic_read_u64(&spcShmem->version) != version)
+	{
+		dsa_free(spcArea, dp);
+		if (!DsaPointerIsValid(entry->plans))
+		{
+			pg_atomic_fetch_sub_u64(&spcShmem->bytes_used,
+									sizeof(SharedPlanCacheEntry));
+			dshash_delete_entry(spcHash, entry);
+		}
+		else
+			dshash_release_lock(spcHash, entry);
+		return;
+	}
+
+	/* another backend may have stored a plan for the same query already */
+	for (cur = entry->plans; DsaPointerIsValid(cur);)
+	{
+		SharedPlan *other = dsa_get_address(spcArea, cur);
+
+		if (other->keylen == keylen &&
+			memcmp(SharedPlanKeyString(other), key, keylen) == 0)
+		{
+			dsa_free(spcArea, dp);
+			dshash_release_lock(spcHash, entry);
+			return;
+		}
+		cur = other->next;
+	}
+
+	sp->next = entry->plans;
+	entry->plans = dp;
+	pg_atomic_fetch_add_u64(&spcShmem->bytes_used, size);
+
+	dshash_release_lock(spcHash, entry);
+}
+
+/*
+ * Would any of the messages make a backend discard this plan?  This mirrors
+ * PlanCacheRelCallback, PlanCacheObjectCallback and PlanCacheSysCallback.
+ */
+static bool
+spc_plan_affected(Oid dbId, SharedPlan *sp,
+				  const SharedInvalidationMessage *msgs, int n)
+{
+	int			i;
+	int			j;
+
+	for (i = 0; i < n; i++)
+	{
+		const SharedInvalidationMessage *msg = &msgs[i];
+
+		if (msg->id == SHAREDINVALRELCACHE_ID)
+		{
+			if (OidIsValid(msg->rc.dbId) && msg->rc.dbId != dbId)
+				continue;
+			if (!OidIsValid(msg->rc.relId))
+			{
+				if (sp->nrels > 0)
+					return true;
+				continue;
+			}
+			for (j = 0; j < sp->nrels; j++)
+			{
+				if (SharedPlanRels(sp)[j] == msg->rc.relId)
+					return true;
+			}
+		}
+		else if (msg->id == PROCOID || msg->id == TYPEOID)
+		{
+			if (OidIsValid(msg->cc.dbId) && msg->cc.dbId != dbId)
+				continue;
+			for (j = 0; j < sp->nitems; j++)
+			{
+				SharedPlanInvalItem *item = &SharedPlanItems(sp)[j];
+
+				if (item->cacheId == msg->cc.id &&
+					item->hashValue == msg->cc.hashValue)
+					return true;
+			}
+		}
+		else if (msg->id == NAMESPACEOID || msg->id == OPEROID ||
+				 msg->id == AMOPOPID || msg->id == FOREIGNSERVEROID ||
+				 msg->id == FOREIGNDATAWRAPPEROID)
+		{
+			if (!OidIsValid(msg->cc.dbId) || msg->cc.dbId == dbId)
+				return true;
+		}
+		else if (msg->id == SHAREDINVALCATALOG_ID)
+		{
+			if (!OidIsValid(msg->cat.dbId) || msg->cat.dbId == dbId)
+				return true;
+		}
+	}
+
+	return false;
+}
+
+/*
+ * SharedPlanCacheInvalidateMessages
+ *		Remove the plans that a batch of invalidation messages affects
+ *
+ * Called for every batch of messages sent to the other backends, before
+ * they are queued.
+ */
+void
+SharedPlanCacheInvalidateMessages(const SharedInvalidationMessage *msgs, int n)
+{
+	dshash_seq_status status;
+	SharedPlanCacheEntry *entry;
+	bool		relevant = false;
+	int			i;
+
+	if (spcShmem == NULL)
+		return;
+
+	for (i = 0; i < n; i++)
+	{
+		int8		id = msgs[i].id;
+
+		if (id == SHAREDINVALRELCACHE_ID || id == SHAREDINVALCATALOG_ID ||
+			id == PROCOID || id == TYPEOID || id == NAMESPACEOID ||
+			id == OPEROID || id == AMOPOPID || id == FOREIGNSERVEROID ||
+			id == FOREIGNDATAWRAPPEROID)
+		{
+			relevant = true;
+			break;
+		}
+	}
+	if (!relevant)
+		return;
+
+	spc_attach();
+
+	/* must come before any removal */
+	pg_atomic_fetch_add_u64(&spcShmem->version, 1);
+
+	dshash_seq_init(&status, spcHash, true);
+	while ((entry = dshash_seq_next(&status)) != NULL)
+	{
+		dsa_pointer *link = &entry->plans;
+
+		while (DsaPointerIsValid(*link))
+		{
+			dsa_pointer dp = *link;
+			SharedPlan *sp = dsa_get_address(spcArea, dp);
+
+			if (spc_plan_affected(entry->key.dbId, sp, msgs, n))
+			{
+				*link = sp->next;
+				pg_atomic_fetch_sub_u64(&spcShmem->bytes_used, sp->size);
+				dsa_free(spcArea, dp);
+			}
+			else
+				link = &sp->next;
+		}
+
+		if (!DsaPointerIsValid(entry->plans))
+		{
+			pg_atomic_fetch_sub_u64(&spcShmem->bytes_used,
+									sizeof(SharedPlanCacheEntry));
+			dshash_delete_current(&status);
+		}
+	}
+	dshash_seq_term(&status);
+}
@@ -69,6 +69,7 @@
 #include "libpq/pqformat.h"
 #include "mb/pg_wchar.h"
 #include "miscadmin.h"
+#include "pgstat.h"
 #include "postmaster/postmaster.h"
 #include "postmaster/syslogger.h"
 #include "storage/ipc.h"
@@ -2594,6 +2595,14 @@ log_line_prefix(StringInfo buf, ErrorData *edata)
 				else
 					appendStringInfoString(buf, unpack_sql_state(edata->sqlerrcode));
 				break;
+			case 'Q':
+				if (padding != 0)
+					appendStringInfo(buf, "%*" INT64_MODIFIER "d", padding,
+									 (int64) pgstat_get_my_query_id());
+				else
+					appendStringInfo(buf, INT64_FORMAT,
+									 (int64) pgstat_get_my_query_id());
+				break;
 			default:
 				/* format error - ignore it */
 				break;
@@ -17,14 +17,85 @@
  *	  to poor performance of hash tables.  In most cases a hash
  *	  function should use hash_any() or its variant hash_uint32().
  *
+ *	  The hash values computed by string_hash, tag_hash and uint32_hash are
+ *	  only ever used in memory, so unlike hash_any() they are free to use
+ *	  cheaper algorithms whose results might change between releases or
+ *	  differ between platforms.  Don't use them for anything that's stored
+ *	  on disk or sent to another server.
+ *
  *-------------------------------------------------------------------------
  */
 #include "postgres.h"
 
 #include "access/hash.h"
+#include "utils/hashutils.h"
 #include "utils/hsearch.h"
 
 
+/*
+ * hash_bytes_inmem: hash a byte string of any length, for in-memory use
+ *
+ * This is MurmurHash64A, which consumes eight bytes per step rather than the
+ * twelve-byte rounds of hash_any()'s lookup3, at a fraction of the cost per
+ * byte, and is much faster for the short fixed-size keys typical of dynahash
+ * tables.  The result depends on the platform's byte order.
+ */
+static inline uint32
+hash_bytes_inmem(const unsigned char *k, Size len)
+{
+	const uint64 m = UINT64CONST(0xc6a4a7935bd1e995);
+	const int	r = 47;
+	uint64		h = UINT64CONST(0x5bd1e9955bd1e995) ^ (len * m);
+
+	while (len >= 8)
+	{
+		uint64		w;
+
+		memcpy(&w, k, sizeof(w));
+		w *= m;
+		w ^= w >> r;
+		w *= m;
+
+		h ^= w;
+		h *= m;
+
+		k += 8;
+		len -= 8;
+	}
+
+	switch (len)
+	{
+		case 7:
+			h ^= (uint64) k[6] << 48;
+			/* fall through */
+		case 6:
+			h ^= (uint64) k[5] << 40;
+			/* fall through */
+		case 5:
+			h ^= (uint64) k[4] << 32;
+			/* fall through */
+		case 4:
+			h ^= (uint64) k[3] << 24;
+			/* fall through */
+		case 3:
+			h ^= (uint64) k[2] << 16;
+			/* fall through */
+		case 2:
+			h ^= (uint64) k[1] << 8;
+			/* fall through */
+		case 1:
+			h ^= (uint64) k[0];
+			h *= m;
+	}
+
+	h ^= h >> r;
+	h *= m;
+	h ^= h >> r;
+
+	return (uint32) (h ^ (h >> 32));
+}
+
+
 /*
  * string_hash: hash function for keys that are NUL-terminated strings.
  *
@@ -41,8 +112,7 @@ string_hash(const void *key, Size keysize)
 	Size		s_len = strlen((const char *) key);
 
 	s_len = Min(s_len, keysize - 1);
-	return DatumGetUInt32(hash_any((const unsigned char *) key,
-								   (int) s_len));
+	return hash_bytes_inmem((const unsigned char *) key, s_len);
 }
 
 /*
@@ -51,8 +121,7 @@ string_hash(const void *key, Size keysize)
 uint32
 tag_hash(const void *key, Size keysize)
 {
-	return DatumGetUInt32(hash_any((const unsigned char *) key,
-								   (int) keysize));
+	return hash_bytes_inmem((const unsigned char *) key, keysize);
 }
 
 /*
@@ -64,7 +133,7 @@ uint32
 uint32_hash(const void *key, Size keysize)
 {
 	Assert(keysize == sizeof(uint32));
-	return DatumGetUInt32(hash_uint32(*((const uint32 *) key)));
+	return murmurhash32(*((const uint32 *) key));
 }
 
 /*
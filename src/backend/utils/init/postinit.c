@@ -33,12 +33,15 @@
 #include "catalog/pg_db_role_setting.h"
 #include "catalog/pg_tablespace.h"
 #include "libpq/auth.h"
+#include "libpq/hba.h"
+#include "libpq/libpq.h"
 #include "libpq/libpq-be.h"
 #include "mb/pg_wchar.h"
 #include "miscadmin.h"
 #include "pgstat.h"
 #include "postmaster/autovacuum.h"
 #include "postmaster/postmaster.h"
+#include "postmaster/proxy.h"
 #include "replication/walsender.h"
 #include "storage/bufmgr.h"
 #include "storage/fd.h"
@@ -233,9 +236,16 @@ PerformAuthentication(Port *port)
 	enable_timeout_after(STATEMENT_TIMEOUT, AuthenticationTimeout * 1000);
 
 	/*
-	 * Now perform authentication exchange.
+	 * Now perform authentication exchange.  A backend started by the
+	 * connection proxy for its session pool has no client yet; clients are
+	 * authenticated as they are handed to it, by ReauthenticateProxiedClient.
 	 */
-	ClientAuthentication(port); /* might not return, if failure */
+	if (!port->proxy_authenticated)
+		ClientAuthentication(port); /* might not return, if failure */
+
+	/* Compress the rest of the traffic, if the client asked for it */
+	if (port->compression)
+		pq_start_compression();
 
 	/*
 	 * Done with authentication.  Disable the timeout, and log if needed.
@@ -308,6 +318,47 @@ PerformAuthentication(Port *port)
 }
 
 
+/*
+ * ReauthenticateProxiedClient -- authenticate a new client of this session
+ *
+ * The connection proxy calls on this when it hands a new client to a backend
+ * of its session pool.  The client connected with the same startup options
+ * as the one this backend was started for, including user and database, so
+ * all that is needed is to pass the authentication exchange with it, using
+ * the current contents of pg_hba.conf, and to tell it the parameter values
+ * that a new connection would have received.
+ */
+void
+ReauthenticateProxiedClient(const char *client)
+{
+	Assert(MyProcPort != NULL && MyProcPort->proxied);
+
+	if (IsTransactionOrTransactionBlock())
+		ereport(FATAL,
+				(errcode(ERRCODE_PROTOCOL_VIOLATION),
+				 errmsg("cannot authenticate a new client inside a transaction")));
+
+	ProxySetClientAddress(MyProcPort, client);
+	MyProcPort->proxy_authenticated = false;
+
+	/* Reload the authentication configuration, as the postmaster would */
+	if (PostmasterContext == NULL)
+		PostmasterContext = AllocSetContextCreate(TopMemoryContext,
+												  "Postmaster",
+												  ALLOCSET_DEFAULT_SIZES);
+	if (!load_hba())
+		ereport(FATAL,
+				(errmsg("could not load pg_hba.conf")));
+	(void) load_ident();
+
+	StartTransactionCommand();
+	PerformAuthentication(MyProcPort);
+	CommitTransactionCommand();
+
+	BeginReportingGUCOptions();
+}
+
+
 /*
  * CheckMyDatabase -- fetch information from the pg_database entry for our DB
  */
@@ -532,6 +583,9 @@ InitializeMaxBackends(void)
 	/* internal error because the values were all checked previously */
 	if (MaxBackends > MAX_BACKENDS)
 		elog(ERROR, "too many backends configured");
+
+	/* The size of the fast-path lock arrays must be known by now, too */
+	InitializeFastPathLocks();
 }
 
 /*
@@ -545,6 +599,13 @@ InitializeMaxBackends(void)
 void
 BaseInit(void)
 {
+	static bool done = false;
+
+	/* A spare backend has already done this before it got its client */
+	if (done)
+		return;
+	done = true;
+
 	/*
 	 * Attach to shared memory and semaphores, and initialize our
 	 * input/output/debugging file descriptors.
@@ -685,8 +746,17 @@ InitPostgres(const char *in_dbname, Oid dboid, const char *username,
 
 	/* Initialize stats collection --- must happen before first xact */
 	if (!bootstrap)
+	{
 		pgstat_initialize();
 
+		/*
+		 * A standalone backend is the only process of the "server", so it
+		 * has to save the statistics at exit, as the checkpointer would.
+		 */
+		if (!IsUnderPostmaster)
+			before_shmem_exit(pgstat_before_server_shutdown, 0);
+	}
+
 	/*
 	 * Load relcache entries for the shared system catalogs.  This must create
 	 * at least entries for pg_database and catalogs used for authentication.
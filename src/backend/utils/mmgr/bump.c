@@ -0,0 +1,579 @@
+/*-------------------------------------------------------------------------
+ *
+ * bump.c
+ *	  Bump allocator definitions.
+ *
+ * Bump is a MemoryContext implementation for chunks that are all released
+ * together, by resetting or deleting the context, and are never freed or
+ * resized one at a time.
+ *
+ * Portions Copyright (c) 2019, PostgreSQL Global Development Group
+ *
+ * IDENTIFICATION
+ *	  src/backend/utils/mmgr/bump.c
+ *
+ *
+ *	Allocation just advances a pointer within the current block, and the
+ *	only per-chunk overhead is the "context" link that every chunk must be
+ *	preceded by (cf. GetMemoryChunkContext), plus the padding needed to
+ *	MAXALIGN the request.  Compared with aset.c, that saves both the size
+ *	word in the chunk header and the rounding up to a power of two, which
+ *	for small chunks can add up to most of the space used.
+ *
+ *	The price is that a chunk's size is not recorded anywhere, so pfree(),
+ *	repalloc() and GetMemoryChunkSpace() are not supported and throw an
+ *	error.  Users must do their own space accounting; BumpChunkSpace()
+ *	tells them how much a chunk of a given size takes up.
+ *
+ *	Blocks start out at initBlockSize and double in size up to maxBlockSize,
+ *	as in aset.c.  Requests bigger than an eighth of maxBlockSize get a
+ *	dedicated block.  On reset, the first block is kept.
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "lib/ilist.h"
+#include "utils/memdebug.h"
+#include "utils/memutils.h"
+
+
+#define Bump_BLOCKHDRSZ		MAXALIGN(sizeof(BumpBlock))
+#define Bump_CHUNKHDRSZ		sizeof(BumpChunk)
+
+typedef struct BumpBlock BumpBlock; /* forward reference */
+typedef struct BumpChunk BumpChunk;
+
+/*
+ * BumpContext is a memory context that hands out chunks from the end of the
+ * current block and never reuses space until it is reset.
+ */
+typedef struct BumpContext
+{
+	MemoryContextData header;	/* Standard memory-context fields */
+
+	/* Bump context parameters */
+	Size		initBlockSize;	/* initial block size */
+	Size		maxBlockSize;	/* maximum block size */
+	Size		nextBlockSize;	/* next block size to allocate */
+	Size		allocChunkLimit;	/* effective chunk size limit */
+
+	BumpBlock  *block;			/* current block, or NULL */
+	dlist_head	blocks;			/* list of blocks, current one first */
+} BumpContext;
+
+/*
+ * BumpBlock
+ *		The unit of memory obtained from malloc().  Chunks are carved out of
+ *		it from freeptr on; the usable space begins at the next alignment
+ *		boundary after the header.
+ */
+struct BumpBlock
+{
+	dlist_node	node;			/* doubly-linked list of blocks */
+	Size		blksize;		/* allocated size of this block */
+	int			nchunks;		/* number of chunks in the block */
+	char	   *freeptr;		/* start of free space in this block */
+	char	   *endptr;			/* end of space in this block */
+};
+
+/*
+ * BumpChunk
+ *		The prefix of each piece of memory in a BumpBlock
+ *
+ * As in generation.c, the "context" link must be immediately adjacent to
+ * the payload area, which must be maxaligned; we pad in front of it if
+ * pointers are narrower than MAXIMUM_ALIGNOF.
+ */
+struct BumpChunk
+{
+#if (SIZEOF_VOID_P % MAXIMUM_ALIGNOF) != 0
+	char		padding[MAXIMUM_ALIGNOF - SIZEOF_VOID_P % MAXIMUM_ALIGNOF];
+#endif
+	BumpContext *context;		/* owning context */
+	/* there must not be any padding to reach a MAXALIGN boundary here! */
+};
+
+#define BumpIsValid(set) PointerIsValid(set)
+
+#define BumpChunkGetPointer(chk) \
+	((void *)(((char *)(chk)) + Bump_CHUNKHDRSZ))
+
+/*
+ * These functions implement the MemoryContext API for Bump contexts.
+ */
+static void *BumpAlloc(MemoryContext context, Size size);
+static void BumpFree(MemoryContext context, void *pointer);
+static void *BumpRealloc(MemoryContext context, void *pointer, Size size);
+static void BumpReset(MemoryContext context);
+static void BumpDelete(MemoryContext context);
+static Size BumpGetChunkSpace(MemoryContext context, void *pointer);
+static bool BumpIsEmpty(MemoryContext context);
+static void BumpStats(MemoryContext context,
+		  MemoryStatsPrintFunc printfunc, void *passthru,
+		  MemoryContextCounters *totals);
+
+#ifdef MEMORY_CONTEXT_CHECKING
+static void BumpCheck(MemoryContext context);
+#endif
+
+/*
+ * This is the virtual function table for Bump contexts.
+ */
+static const MemoryContextMethods BumpMethods = {
+	BumpAlloc,
+	BumpFree,
+	BumpRealloc,
+	BumpReset,
+	BumpDelete,
+	BumpGetChunkSpace,
+	BumpIsEmpty,
+	BumpStats
+#ifdef MEMORY_CONTEXT_CHECKING
+	,BumpCheck
+#endif
+};
+
+
+/*
+ * Public routines
+ */
+
+
+/*
+ * BumpContextCreate
+ *		Create a new Bump context.
+ *
+ * parent: parent context, or NULL if top-level context
+ * name: name of context (must be statically allocated)
+ * initBlockSize: size of the first block
+ * maxBlockSize: maximum block size
+ */
+MemoryContext
+BumpContextCreate(MemoryContext parent,
+				  const char *name,
+				  Size initBlockSize,
+				  Size maxBlockSize)
+{
+	BumpContext *set;
+
+	/* Assert we padded BumpChunk properly */
+	StaticAssertStmt(Bump_CHUNKHDRSZ == MAXALIGN(Bump_CHUNKHDRSZ),
+					 "sizeof(BumpChunk) is not maxaligned");
+	StaticAssertStmt(offsetof(BumpChunk, context) + sizeof(MemoryContext) ==
+					 Bump_CHUNKHDRSZ,
+					 "padding calculation in BumpChunk is wrong");
+
+	/*
+	 * Validate parameters the way AllocSetContextCreate does, before the
+	 * context is created.
+	 */
+	if (initBlockSize != MAXALIGN(initBlockSize) ||
+		initBlockSize < 1024)
+		elog(ERROR, "invalid initBlockSize for memory context: %zu",
+			 initBlockSize);
+	if (maxBlockSize != MAXALIGN(maxBlockSize) ||
+		maxBlockSize < initBlockSize ||
+		!AllocHugeSizeIsValid(maxBlockSize))
+		elog(ERROR, "invalid maxBlockSize for memory context: %zu",
+			 maxBlockSize);
+
+	set = (BumpContext *) malloc(MAXALIGN(sizeof(BumpContext)));
+	if (set == NULL)
+	{
+		MemoryContextStats(TopMemoryContext);
+		ereport(ERROR,
+				(errcode(ERRCODE_OUT_OF_MEMORY),
+				 errmsg("out of memory"),
+				 errdetail("Failed while creating memory context \"%s\".",
+						   name)));
+	}
+
+	/*
+	 * Avoid writing code that can fail between here and MemoryContextCreate;
+	 * we'd leak the header if we ereport in this stretch.
+	 */
+
+	/* Fill in BumpContext-specific header fields */
+	set->initBlockSize = initBlockSize;
+	set->maxBlockSize = maxBlockSize;
+	set->nextBlockSize = initBlockSize;
+	set->allocChunkLimit = maxBlockSize / 8;
+	set->block = NULL;
+	dlist_init(&set->blocks);
+
+	/* Finally, do the type-independent part of context creation */
+	MemoryContextCreate((MemoryContext) set,
+						T_BumpContext,
+						&BumpMethods,
+						parent,
+						name);
+
+	return (MemoryContext) set;
+}
+
+/*
+ * BumpReset
+ *		Frees all memory which is allocated in the given set.
+ *
+ * The first block allocated, which is the last one in the list, is kept
+ * and reused, since a context that is reset is usually filled again.
+ */
+static void
+BumpReset(MemoryContext context)
+{
+	BumpContext *set = (BumpContext *) context;
+	dlist_mutable_iter miter;
+	BumpBlock  *keeper = NULL;
+
+	AssertArg(BumpIsValid(set));
+
+#ifdef MEMORY_CONTEXT_CHECKING
+	/* Check for corruption before freeing */
+	BumpCheck(context);
+#endif
+
+	if (!dlist_is_empty(&set->blocks))
+	{
+		keeper = dlist_tail_element(BumpBlock, node, &set->blocks);
+
+		/* a dedicated block for a big chunk is not worth keeping */
+		if (keeper->blksize != set->initBlockSize)
+			keeper = NULL;
+	}
+
+	dlist_foreach_modify(miter, &set->blocks)
+	{
+		BumpBlock  *block = dlist_container(BumpBlock, node, miter.cur);
+
+		if (block == keeper)
+			continue;
+
+		dlist_delete(miter.cur);
+
+#ifdef CLOBBER_FREED_MEMORY
+		wipe_mem(block, block->blksize);
+#endif
+
+		free(block);
+	}
+
+	if (keeper != NULL)
+	{
+		keeper->nchunks = 0;
+		keeper->freeptr = ((char *) keeper) + Bump_BLOCKHDRSZ;
+#ifdef CLOBBER_FREED_MEMORY
+		wipe_mem(keeper->freeptr, keeper->endptr - keeper->freeptr);
+#endif
+		VALGRIND_MAKE_MEM_NOACCESS(keeper->freeptr,
+								   keeper->endptr - keeper->freeptr);
+	}
+
+	set->block = keeper;
+	set->nextBlockSize = set->initBlockSize;
+}
+
+/*
+ * BumpDelete
+ *		Free all memory which is allocated in the given context.
+ */
+static void
+BumpDelete(MemoryContext context)
+{
+	BumpContext *set = (BumpContext *) context;
+	dlist_mutable_iter miter;
+
+	dlist_foreach_modify(miter, &set->blocks)
+	{
+		BumpBlock  *block = dlist_container(BumpBlock, node, miter.cur);
+
+#ifdef CLOBBER_FREED_MEMORY
+		wipe_mem(block, block->blksize);
+#endif
+
+		free(block);
+	}
+
+	/* And free the context header */
+	free(context);
+}
+
+/*
+ * BumpAlloc
+ *		Returns pointer to allocated memory of given size or NULL if
+ *		request could not be completed; memory is added to the set.
+ *
+ * No request may exceed:
+ *		MAXALIGN_DOWN(SIZE_MAX) - Bump_BLOCKHDRSZ - Bump_CHUNKHDRSZ
+ * All callers use a much-lower limit.
+ */
+static void *
+BumpAlloc(MemoryContext context, Size size)
+{
+	BumpContext *set = (BumpContext *) context;
+	BumpBlock  *block;
+	BumpChunk  *chunk;
+	Size		chunk_size = MAXALIGN(size);
+
+	/* is it an over-sized chunk? if yes, allocate special block */
+	if (chunk_size > set->allocChunkLimit)
+	{
+		Size		blksize = chunk_size + Bump_BLOCKHDRSZ + Bump_CHUNKHDRSZ;
+
+		block = (BumpBlock *) malloc(blksize);
+		if (block == NULL)
+			return NULL;
+
+		/* block with a single chunk, completely full */
+		block->blksize = blksize;
+		block->nchunks = 1;
+		block->freeptr = block->endptr = ((char *) block) + blksize;
+
+		chunk = (BumpChunk *) (((char *) block) + Bump_BLOCKHDRSZ);
+		chunk->context = set;
+
+		/*
+		 * Put the block after the current one, so that the current block
+		 * stays at the head of the list and the keeper block at its tail.
+		 */
+		if (set->block != NULL)
+			dlist_insert_after(&set->block->node, &block->node);
+		else
+			dlist_push_head(&set->blocks, &block->node);
+
+#ifdef RANDOMIZE_ALLOCATED_MEMORY
+		randomize_mem((char *) BumpChunkGetPointer(chunk), size);
+#endif
+
+		/* Ensure any padding bytes are marked NOACCESS. */
+		VALGRIND_MAKE_MEM_NOACCESS((char *) BumpChunkGetPointer(chunk) + size,
+								   chunk_size - size);
+
+		return BumpChunkGetPointer(chunk);
+	}
+
+	/*
+	 * Not an over-sized chunk. Is there enough space in the current block? If
+	 * not, allocate a new block; it's always big enough, since the chunk is
+	 * no larger than allocChunkLimit.
+	 */
+	block = set->block;
+
+	if (block == NULL ||
+		(Size) (block->endptr - block->freeptr) < Bump_CHUNKHDRSZ + chunk_size)
+	{
+		Size		blksize = set->nextBlockSize;
+
+		block = (BumpBlock *) malloc(blksize);
+		if (block == NULL)
+			return NULL;
+
+		/* the next block is twice as big, up to the limit */
+		set->nextBlockSize = Min(blksize * 2, set->maxBlockSize);
+
+		block->blksize = blksize;
+		block->nchunks = 0;
+		block->freeptr = ((char *) block) + Bump_BLOCKHDRSZ;
+		block->endptr = ((char *) block) + blksize;
+
+		/* Mark unallocated space NOACCESS. */
+		VALGRIND_MAKE_MEM_NOACCESS(block->freeptr,
+								   blksize - Bump_BLOCKHDRSZ);
+
+		dlist_push_head(&set->blocks, &block->node);
+		set->block = block;
+	}
+
+	Assert((Size) (block->endptr - block->freeptr) >=
+		   Bump_CHUNKHDRSZ + chunk_size);
+
+	chunk = (BumpChunk *) block->freeptr;
+
+	/* Prepare to initialize the chunk header. */
+	VALGRIND_MAKE_MEM_UNDEFINED(chunk, Bump_CHUNKHDRSZ);
+
+	block->nchunks += 1;
+	block->freeptr += (Bump_CHUNKHDRSZ + chunk_size);
+
+	chunk->context = set;
+
+#ifdef RANDOMIZE_ALLOCATED_MEMORY
+	randomize_mem((char *) BumpChunkGetPointer(chunk), size);
+#endif
+
+	/* Ensure any padding bytes are marked NOACCESS. */
+	VALGRIND_MAKE_MEM_NOACCESS((char *) BumpChunkGetPointer(chunk) + size,
+							   chunk_size - size);
+
+	return BumpChunkGetPointer(chunk);
+}
+
+/*
+ * BumpFree
+ *		Not supported; the space is reclaimed when the context is reset.
+ */
+static void
+BumpFree(MemoryContext context, void *pointer)
+{
+	elog(ERROR, "%s is not supported by the bump memory allocator",
+		 "pfree");
+}
+
+/*
+ * BumpRealloc
+ *		Not supported, since we don't know the chunk's current size.
+ */
+static void *
+BumpRealloc(MemoryContext context, void *pointer, Size size)
+{
+	elog(ERROR, "%s is not supported by the bump memory allocator",
+		 "realloc");
+	return NULL;				/* keep compiler quiet */
+}
+
+/*
+ * BumpGetChunkSpace
+ *		Not supported; see BumpChunkSpace().
+ */
+static Size
+BumpGetChunkSpace(MemoryContext context, void *pointer)
+{
+	elog(ERROR, "%s is not supported by the bump memory allocator",
+		 "GetMemoryChunkSpace");
+	return 0;					/* keep compiler quiet */
+}
+
+/*
+ * BumpChunkSpace
+ *		Return the space a chunk of the given size takes up in a Bump
+ *		context, including the chunk header.
+ */
+Size
+BumpChunkSpace(Size size)
+{
+	return Bump_CHUNKHDRSZ + MAXALIGN(size);
+}
+
+/*
+ * BumpIsEmpty
+ *		Is a BumpContext empty of any allocated space?
+ */
+static bool
+BumpIsEmpty(MemoryContext context)
+{
+	BumpContext *set = (BumpContext *) context;
+	dlist_iter	iter;
+
+	dlist_foreach(iter, &set->blocks)
+	{
+		BumpBlock  *block = dlist_container(BumpBlock, node, iter.cur);
+
+		if (block->nchunks > 0)
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * BumpStats
+ *		Compute stats about memory consumption of a Bump context.
+ *
+ * printfunc: if not NULL, pass a human-readable stats string to this.
+ * passthru: pass this pointer through to printfunc.
+ * totals: if not NULL, add stats about this context into *totals.
+ */
+static void
+BumpStats(MemoryContext context,
+		  MemoryStatsPrintFunc printfunc, void *passthru,
+		  MemoryContextCounters *totals)
+{
+	BumpContext *set = (BumpContext *) context;
+	Size		nblocks = 0;
+	Size		nchunks = 0;
+	Size		totalspace;
+	Size		freespace = 0;
+	dlist_iter	iter;
+
+	/* Include context header in totalspace */
+	totalspace = MAXALIGN(sizeof(BumpContext));
+
+	dlist_foreach(iter, &set->blocks)
+	{
+		BumpBlock  *block = dlist_container(BumpBlock, node, iter.cur);
+
+		nblocks++;
+		nchunks += block->nchunks;
+		totalspace += block->blksize;
+		freespace += (block->endptr - block->freeptr);
+	}
+
+	if (printfunc)
+	{
+		char		stats_string[200];
+
+		snprintf(stats_string, sizeof(stats_string),
+				 "%zu total in %zd blocks (%zd chunks); %zu free; %zu used",
+				 totalspace, nblocks, nchunks, freespace,
+				 totalspace - freespace);
+		printfunc(context, passthru, stats_string);
+	}
+
+	if (totals)
+	{
+		totals->nblocks += nblocks;
+		totals->totalspace += totalspace;
+		totals->freespace += freespace;
+	}
+}
+
+
+#ifdef MEMORY_CONTEXT_CHECKING
+
+/*
+ * BumpCheck
+ *		Walk through blocks and check consistency of memory.
+ *
+ * Chunk sizes aren't recorded, so only the block headers and the context
+ * links of dedicated blocks can be checked.
+ *
+ * NOTE: report errors as WARNING, *not* ERROR or FATAL.  Otherwise you'll
+ * find yourself in an infinite loop when trouble occurs, because this
+ * routine will be entered again when elog cleanup tries to release memory!
+ */
+static void
+BumpCheck(MemoryContext context)
+{
+	BumpContext *set = (BumpContext *) context;
+	const char *name = context->name;
+	dlist_iter	iter;
+
+	dlist_foreach(iter, &set->blocks)
+	{
+		BumpBlock  *block = dlist_container(BumpBlock, node, iter.cur);
+		char	   *start = ((char *) block) + Bump_BLOCKHDRSZ;
+
+		if (block->endptr != ((char *) block) + block->blksize ||
+			block->freeptr < start ||
+			block->freeptr > block->endptr)
+			elog(WARNING, "problem in Bump %s: bogus pointers in block %p",
+				 name, block);
+
+		if (block->nchunks < 0 ||
+			(block->nchunks == 0 && block->freeptr != start))
+			elog(WARNING, "problem in Bump %s: bogus chunk count %d in block %p",
+				 name, block->nchunks, block);
+
+		if (block->nchunks > 0)
+		{
+			BumpChunk  *chunk = (BumpChunk *) start;
+
+			if (chunk->context != set)
+				elog(WARNING, "problem in Bump %s: bogus context link in block %p, chunk %p",
+					 name, block, chunk);
+		}
+	}
+}
+
+#endif							/* MEMORY_CONTEXT_CHECKING */
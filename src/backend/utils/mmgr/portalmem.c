@@ -1223,6 +1223,31 @@ ThereAreNoReadyPortals(void)
 	return true;
 }
 
+/*
+ * Are there any portals that have survived the end of the transaction that
+ * created them?  This is meant to be called between transactions, when the
+ * only remaining portals are held cursors.
+ */
+bool
+ThereAreHeldPortals(void)
+{
+	HASH_SEQ_STATUS status;
+	PortalHashEnt *hentry;
+
+	hash_seq_init(&status, PortalHashTable);
+
+	while ((hentry = (PortalHashEnt *) hash_seq_search(&status)) != NULL)
+	{
+		if (hentry->portal->createSubid == InvalidSubTransactionId)
+		{
+			hash_seq_term(&status);
+			return true;
+		}
+	}
+
+	return false;
+}
+
 /*
  * Hold all pinned portals.
  *
@@ -53,6 +53,26 @@ print <<'EOM';
 EOM
 emit_qsort_implementation();
 
+# Versions for leading keys whose comparator is one of the ssup_datum_*_cmp
+# functions.  The comparison of datum1 is inlined; cmp_tuple_unsigned() and
+# friends are defined in tuplesort.c and fall back to comparetup on ties.
+$EXTRAARGS   = ', Tuplesortstate *state';
+$EXTRAPARAMS = ', state';
+$CMPPARAMS   = ', state';
+
+$SUFFIX = 'tuple_unsigned';
+print "\n";
+emit_qsort_implementation();
+
+print "\n#if SIZEOF_DATUM >= 8\n";
+$SUFFIX = 'tuple_signed';
+emit_qsort_implementation();
+print "#endif\n";
+
+$SUFFIX = 'tuple_int32';
+print "\n";
+emit_qsort_implementation();
+
 sub emit_qsort_boilerplate
 {
 	print <<'EOM';
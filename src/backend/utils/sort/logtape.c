@@ -47,7 +47,24 @@
  *
  * To further make the I/Os more sequential, we can use a larger buffer
  * when reading, and read multiple blocks from the same tape in one go,
- * whenever the buffer becomes empty.
+ * whenever the buffer becomes empty.  After filling the buffer, we also
+ * advise the kernel to start reading the blocks that follow, so that the
+ * next refill of the buffer doesn't have to wait for the disk as much.
+ * The blocks of a tape are usually contiguous in the underlying file,
+ * at least for the runs written by the initial pass, so the blocks
+ * following the tape's next block are a good guess.
+ *
+ * Optionally, the data written to the tapes can be compressed.  The byte
+ * stream written by the caller is then cut into chunks of TAPE_CHUNK_SIZE
+ * bytes, each of which is compressed and stored in the tape, behind a
+ * TapeChunkHeader, in place of the raw data.  The block structure described
+ * above is unchanged, so space is recycled in the same way, only there are
+ * fewer blocks.  Chunks are only ever read in the order they were written,
+ * so compressed tapes don't support backspacing and seeking; random access
+ * callers have to use uncompressed tapes.  Since the callers in practice
+ * write to one tape at a time, there is a single chunk buffer for writing,
+ * shared by all tapes of the set; switching to writing another tape flushes
+ * the chunk of the previous one, even if it isn't full yet.
  *
  * To support the above policy of writing to the lowest free block,
  * ltsGetFreeBlock sorts the list of free block numbers into decreasing
@@ -82,6 +99,11 @@
 
 #include "postgres.h"
 
+#ifdef USE_LZ4
+#include <lz4.h>
+#endif
+
+#include "common/pg_lzcompress.h"
 #include "storage/buffile.h"
 #include "utils/builtins.h"
 #include "utils/logtape.h"
@@ -114,6 +136,29 @@ typedef struct TapeBlockTrailer
 #define TapeBlockSetNBytes(buf, nbytes) \
 	(TapeBlockGetTrailer(buf)->next = -(nbytes))
 
+/*
+ * In a compressed tape, each chunk of up to TAPE_CHUNK_SIZE bytes of the
+ * caller's data is stored as a TapeChunkHeader followed by the compressed
+ * data.  A chunk that didn't compress is stored as is, which is indicated by
+ * storedlen == rawlen.
+ */
+typedef struct TapeChunkHeader
+{
+	int32		rawlen;			/* # of bytes of caller's data in chunk */
+	int32		storedlen;		/* # of bytes stored after the header */
+} TapeChunkHeader;
+
+#define TAPE_CHUNK_SIZE		BLCKSZ
+
+#ifdef USE_LZ4
+#define TAPE_CHUNK_BUFSIZE \
+	Max(PGLZ_MAX_OUTPUT(TAPE_CHUNK_SIZE), LZ4_COMPRESSBOUND(TAPE_CHUNK_SIZE))
+#else
+#define TAPE_CHUNK_BUFSIZE	PGLZ_MAX_OUTPUT(TAPE_CHUNK_SIZE)
+#endif
+
+/* GUC variable */
+int			tape_compression = TAPE_COMPRESSION_NONE;
 
 /*
  * This data structure represents a single "logical tape" within the set
@@ -155,6 +200,13 @@ typedef struct LogicalTape
 	int			max_size;		/* highest useful, safe buffer_size */
 	int			pos;			/* next read/write position in buffer */
 	int			nbytes;			/* total # of valid bytes in buffer */
+
+	/*
+	 * Decompressed chunk being read, in a compressed tape set.
+	 */
+	char	   *chunk;			/* TAPE_CHUNK_SIZE bytes, or NULL */
+	int			chunk_pos;		/* next read position in chunk */
+	int			chunk_len;		/* total # of valid bytes in chunk */
 } LogicalTape;
 
 /*
@@ -200,6 +252,17 @@ struct LogicalTapeSet
 	int			nFreeBlocks;	/* # of currently free blocks */
 	int			freeBlocksLen;	/* current allocated length of freeBlocks[] */
 
+	/*
+	 * Compression state.  wchunk holds the data not yet compressed of tape
+	 * wchunk_tape (or -1 if none), the only tape that we're writing to.
+	 * cbuf is workspace for compressing and decompressing chunks.
+	 */
+	TapeCompression compression;
+	char	   *wchunk;			/* TAPE_CHUNK_SIZE bytes, or NULL */
+	int			wchunk_len;		/* # of bytes in wchunk */
+	int			wchunk_tape;	/* tape wchunk belongs to, or -1 */
+	char	   *cbuf;			/* TAPE_CHUNK_BUFSIZE bytes, or NULL */
+
 	/* The array of logical tapes. */
 	int			nTapes;			/* # of logical tapes in set */
 	LogicalTape tapes[FLEXIBLE_ARRAY_MEMBER];	/* has nTapes nentries */
@@ -211,6 +274,12 @@ static long ltsGetFreeBlock(LogicalTapeSet *lts);
 static void ltsReleaseBlock(LogicalTapeSet *lts, long blocknum);
 static void ltsConcatWorkerTapes(LogicalTapeSet *lts, TapeShare *shared,
 					 SharedFileSet *fileset);
+static void ltsWriteData(LogicalTapeSet *lts, LogicalTape *lt,
+			 void *ptr, size_t size);
+static size_t ltsReadData(LogicalTapeSet *lts, LogicalTape *lt,
+			void *ptr, size_t size);
+static void ltsFlushChunk(LogicalTapeSet *lts);
+static bool ltsReadChunk(LogicalTapeSet *lts, LogicalTape *lt);
 
 
 /*
@@ -318,6 +387,16 @@ ltsReadFillBuffer(LogicalTapeSet *lts, LogicalTape *lt)
 		/* Advance to next block, if we have buffer space left */
 	} while (lt->buffer_size - lt->nbytes > BLCKSZ);
 
+	/*
+	 * Start reading ahead the blocks we'll presumably need for the next
+	 * refill, while the caller consumes the buffer.  There's no point in
+	 * doing that with the single-block buffer used for frozen tapes.
+	 */
+	if (lt->nextBlockNumber != -1L && lt->buffer_size > BLCKSZ)
+		BufFilePrefetchBlock(lts->pfile,
+							 lt->nextBlockNumber + lt->offsetBlockNumber,
+							 lt->buffer_size / BLCKSZ);
+
 	return (lt->nbytes > 0);
 }
 
@@ -505,10 +584,14 @@ ltsConcatWorkerTapes(LogicalTapeSet *lts, TapeShare *shared,
  * for writing, but that's only to be consistent).  Leader may not write to
  * its own tape purely due to a restriction in the shared buffile
  * infrastructure that may be lifted in the future.
+ *
+ * 'compression' selects the compression method for the data written to the
+ * tapes.  Compressed tapes can't be backspaced or seeked.  A leader must
+ * pass the same method as its workers did.
  */
 LogicalTapeSet *
 LogicalTapeSetCreate(int ntapes, TapeShare *shared, SharedFileSet *fileset,
-					 int worker)
+					 int worker, TapeCompression compression)
 {
 	LogicalTapeSet *lts;
 	LogicalTape *lt;
@@ -528,6 +611,13 @@ LogicalTapeSetCreate(int ntapes, TapeShare *shared, SharedFileSet *fileset,
 	lts->freeBlocksLen = 32;	/* reasonable initial guess */
 	lts->freeBlocks = (long *) palloc(lts->freeBlocksLen * sizeof(long));
 	lts->nFreeBlocks = 0;
+	lts->compression = compression;
+	lts->wchunk = NULL;
+	lts->wchunk_len = 0;
+	lts->wchunk_tape = -1;
+	lts->cbuf = NULL;
+	if (compression != TAPE_COMPRESSION_NONE)
+		lts->cbuf = (char *) palloc(TAPE_CHUNK_BUFSIZE);
 	lts->nTapes = ntapes;
 
 	/*
@@ -552,6 +642,9 @@ LogicalTapeSetCreate(int ntapes, TapeShare *shared, SharedFileSet *fileset,
 		lt->max_size = MaxAllocSize;
 		lt->pos = 0;
 		lt->nbytes = 0;
+		lt->chunk = NULL;
+		lt->chunk_pos = 0;
+		lt->chunk_len = 0;
 	}
 
 	/*
@@ -592,7 +685,13 @@ LogicalTapeSetClose(LogicalTapeSet *lts)
 		lt = &lts->tapes[i];
 		if (lt->buffer)
 			pfree(lt->buffer);
+		if (lt->chunk)
+			pfree(lt->chunk);
 	}
+	if (lts->wchunk)
+		pfree(lts->wchunk);
+	if (lts->cbuf)
+		pfree(lts->cbuf);
 	pfree(lts->freeBlocks);
 	pfree(lts);
 }
@@ -629,6 +728,50 @@ LogicalTapeWrite(LogicalTapeSet *lts, int tapenum,
 	Assert(lt->writing);
 	Assert(lt->offsetBlockNumber == 0L);
 
+	if (lts->compression == TAPE_COMPRESSION_NONE)
+	{
+		ltsWriteData(lts, lt, ptr, size);
+		return;
+	}
+
+	/* Take over the chunk buffer, if another tape is using it */
+	if (lts->wchunk_tape != tapenum)
+	{
+		ltsFlushChunk(lts);
+		lts->wchunk_tape = tapenum;
+	}
+	if (lts->wchunk == NULL)
+		lts->wchunk = (char *) palloc(TAPE_CHUNK_SIZE);
+
+	while (size > 0)
+	{
+		if (lts->wchunk_len >= TAPE_CHUNK_SIZE)
+		{
+			ltsFlushChunk(lts);
+			lts->wchunk_tape = tapenum;
+		}
+
+		nthistime = TAPE_CHUNK_SIZE - lts->wchunk_len;
+		if (nthistime > size)
+			nthistime = size;
+		Assert(nthistime > 0);
+
+		memcpy(lts->wchunk + lts->wchunk_len, ptr, nthistime);
+
+		lts->wchunk_len += nthistime;
+		ptr = (void *) ((char *) ptr + nthistime);
+		size -= nthistime;
+	}
+}
+
+/*
+ * Write raw data to the blocks of a logical tape.
+ */
+static void
+ltsWriteData(LogicalTapeSet *lts, LogicalTape *lt, void *ptr, size_t size)
+{
+	size_t		nthistime;
+
 	/* Allocate data buffer and first block on first write */
 	if (lt->buffer == NULL)
 	{
@@ -693,6 +836,125 @@ LogicalTapeWrite(LogicalTapeSet *lts, int tapenum,
 	}
 }
 
+/*
+ * Compress the data in the chunk buffer, if any, and write it to the tape it
+ * belongs to.
+ */
+static void
+ltsFlushChunk(LogicalTapeSet *lts)
+{
+	LogicalTape *lt;
+	TapeChunkHeader hdr;
+	int32		len = -1;
+	char	   *data;
+
+	if (lts->wchunk_tape < 0)
+		return;
+	lt = &lts->tapes[lts->wchunk_tape];
+	lts->wchunk_tape = -1;
+	if (lts->wchunk_len == 0)
+		return;
+
+	switch (lts->compression)
+	{
+		case TAPE_COMPRESSION_PGLZ:
+			len = pglz_compress(lts->wchunk, lts->wchunk_len, lts->cbuf,
+								PGLZ_strategy_default);
+			break;
+		case TAPE_COMPRESSION_LZ4:
+#ifdef USE_LZ4
+			len = LZ4_compress_default(lts->wchunk, lts->cbuf,
+									   lts->wchunk_len, TAPE_CHUNK_BUFSIZE);
+			if (len <= 0)
+				len = -1;
+#else
+			elog(ERROR, "LZ4 is not supported by this build");
+#endif
+			break;
+		default:
+			elog(ERROR, "invalid tape compression method %d",
+				 (int) lts->compression);
+	}
+
+	/* Store the chunk as is, if compressing it didn't help */
+	hdr.rawlen = lts->wchunk_len;
+	if (len >= 0 && len < lts->wchunk_len)
+	{
+		hdr.storedlen = len;
+		data = lts->cbuf;
+	}
+	else
+	{
+		hdr.storedlen = lts->wchunk_len;
+		data = lts->wchunk;
+	}
+
+	ltsWriteData(lts, lt, &hdr, sizeof(hdr));
+	ltsWriteData(lts, lt, data, hdr.storedlen);
+	lts->wchunk_len = 0;
+}
+
+/*
+ * Read the next chunk of a compressed tape into its chunk buffer.
+ *
+ * Returns false on EOF.
+ */
+static bool
+ltsReadChunk(LogicalTapeSet *lts, LogicalTape *lt)
+{
+	TapeChunkHeader hdr;
+	size_t		nread;
+	int32		len = -1;
+
+	nread = ltsReadData(lts, lt, &hdr, sizeof(hdr));
+	if (nread == 0)
+		return false;
+	if (nread != sizeof(hdr) ||
+		hdr.rawlen <= 0 || hdr.rawlen > TAPE_CHUNK_SIZE ||
+		hdr.storedlen <= 0 || hdr.storedlen > hdr.rawlen)
+		elog(ERROR, "invalid chunk header in compressed tape");
+
+	if (lt->chunk == NULL)
+		lt->chunk = (char *) palloc(TAPE_CHUNK_SIZE);
+
+	if (hdr.storedlen == hdr.rawlen)
+	{
+		/* stored as is */
+		if (ltsReadData(lts, lt, lt->chunk, hdr.rawlen) != hdr.rawlen)
+			elog(ERROR, "unexpected end of compressed tape");
+	}
+	else
+	{
+		if (ltsReadData(lts, lt, lts->cbuf, hdr.storedlen) != hdr.storedlen)
+			elog(ERROR, "unexpected end of compressed tape");
+
+		switch (lts->compression)
+		{
+			case TAPE_COMPRESSION_PGLZ:
+				len = pglz_decompress(lts->cbuf, hdr.storedlen, lt->chunk,
+									  hdr.rawlen, true);
+				break;
+			case TAPE_COMPRESSION_LZ4:
+#ifdef USE_LZ4
+				len = LZ4_decompress_safe(lts->cbuf, lt->chunk,
+										  hdr.storedlen, hdr.rawlen);
+#else
+				elog(ERROR, "LZ4 is not supported by this build");
+#endif
+				break;
+			default:
+				elog(ERROR, "invalid tape compression method %d",
+					 (int) lts->compression);
+		}
+		if (len != hdr.rawlen)
+			elog(ERROR, "compressed data in tape is corrupted");
+	}
+
+	lt->chunk_pos = 0;
+	lt->chunk_len = hdr.rawlen;
+	return true;
+}
+
 /*
  * Rewind logical tape and switch from writing to reading.
  *
@@ -703,7 +965,9 @@ LogicalTapeWrite(LogicalTapeSet *lts, int tapenum,
  * BLCKSZ and MaxAllocSize, and is a multiple of BLCKSZ.  The given value is
  * rounded down and truncated to fit those constraints, if necessary.  If the
  * tape is frozen, the 'buffer_size' argument is ignored, and a small BLCKSZ
- * byte buffer is used.
+ * byte buffer is used.  In a compressed tape set, the buffer for
+ * decompressing the data is taken out of 'buffer_size', if it's large
+ * enough.
  */
 void
 LogicalTapeRewindForRead(LogicalTapeSet *lts, int tapenum, size_t buffer_size)
@@ -720,6 +984,11 @@ LogicalTapeRewindForRead(LogicalTapeSet *lts, int tapenum, size_t buffer_size)
 		buffer_size = BLCKSZ;
 	else
 	{
+		/* leave room for the chunk buffer of a compressed tape */
+		if (lts->compression != TAPE_COMPRESSION_NONE &&
+			buffer_size >= TAPE_CHUNK_SIZE + 2 * BLCKSZ)
+			buffer_size -= TAPE_CHUNK_SIZE;
+
 		/* need at least one block */
 		if (buffer_size < BLCKSZ)
 			buffer_size = BLCKSZ;
@@ -738,6 +1007,8 @@ LogicalTapeRewindForRead(LogicalTapeSet *lts, int tapenum, size_t buffer_size)
 		 * Completion of a write phase.  Flush last partial data block, and
 		 * rewind for normal (destructive) read.
 		 */
+		if (lts->wchunk_tape == tapenum)
+			ltsFlushChunk(lts);
 		if (lt->dirty)
 		{
 			/*
@@ -781,6 +1052,8 @@ LogicalTapeRewindForRead(LogicalTapeSet *lts, int tapenum, size_t buffer_size)
 	lt->nextBlockNumber = lt->firstBlockNumber;
 	lt->pos = 0;
 	lt->nbytes = 0;
+	lt->chunk_pos = 0;
+	lt->chunk_len = 0;
 	ltsReadFillBuffer(lts, lt);
 }
 
@@ -807,6 +1080,8 @@ LogicalTapeRewindForWrite(LogicalTapeSet *lts, int tapenum)
 	lt->curBlockNumber = -1L;
 	lt->pos = 0;
 	lt->nbytes = 0;
+	lt->chunk_pos = 0;
+	lt->chunk_len = 0;
 	if (lt->buffer)
 		pfree(lt->buffer);
 	lt->buffer = NULL;
@@ -830,6 +1105,43 @@ LogicalTapeRead(LogicalTapeSet *lts, int tapenum,
 	lt = &lts->tapes[tapenum];
 	Assert(!lt->writing);
 
+	if (lts->compression == TAPE_COMPRESSION_NONE)
+		return ltsReadData(lts, lt, ptr, size);
+
+	while (size > 0)
+	{
+		if (lt->chunk_pos >= lt->chunk_len)
+		{
+			/* Decompress the next chunk. */
+			if (!ltsReadChunk(lts, lt))
+				break;			/* EOF */
+		}
+
+		nthistime = lt->chunk_len - lt->chunk_pos;
+		if (nthistime > size)
+			nthistime = size;
+		Assert(nthistime > 0);
+
+		memcpy(ptr, lt->chunk + lt->chunk_pos, nthistime);
+
+		lt->chunk_pos += nthistime;
+		ptr = (void *) ((char *) ptr + nthistime);
+		size -= nthistime;
+		nread += nthistime;
+	}
+
+	return nread;
+}
+
+/*
+ * Read raw data from the blocks of a logical tape.
+ */
+static size_t
+ltsReadData(LogicalTapeSet *lts, LogicalTape *lt, void *ptr, size_t size)
+{
+	size_t		nread = 0;
+	size_t		nthistime;
+
 	while (size > 0)
 	{
 		if (lt->pos >= lt->nbytes)
@@ -886,6 +1198,8 @@ LogicalTapeFreeze(LogicalTapeSet *lts, int tapenum, TapeShare *share)
 	 * Completion of a write phase.  Flush last partial data block, and rewind
 	 * for nondestructive read.
 	 */
+	if (lts->wchunk_tape == tapenum)
+		ltsFlushChunk(lts);
 	if (lt->dirty)
 	{
 		/*
@@ -925,6 +1239,8 @@ LogicalTapeFreeze(LogicalTapeSet *lts, int tapenum, TapeShare *share)
 	lt->curBlockNumber = lt->firstBlockNumber;
 	lt->pos = 0;
 	lt->nbytes = 0;
+	lt->chunk_pos = 0;
+	lt->chunk_len = 0;
 
 	if (lt->firstBlockNumber == -1L)
 		lt->nextBlockNumber = -1L;
@@ -949,7 +1265,8 @@ LogicalTapeFreeze(LogicalTapeSet *lts, int tapenum, TapeShare *share)
  *
  * *Only* a frozen-for-read tape can be backed up; we don't support
  * random access during write, and an unfrozen read tape may have
- * already discarded the desired data!
+ * already discarded the desired data!  Nor can a compressed tape be backed
+ * up.
  *
  * Returns the number of bytes backed up.  It can be less than the
  * requested amount, if there isn't that much data before the current
@@ -966,6 +1283,7 @@ LogicalTapeBackspace(LogicalTapeSet *lts, int tapenum, size_t size)
 	lt = &lts->tapes[tapenum];
 	Assert(lt->frozen);
 	Assert(lt->buffer_size == BLCKSZ);
+	Assert(lts->compression == TAPE_COMPRESSION_NONE);
 
 	/*
 	 * Easy case for seek within current block.
@@ -1038,6 +1356,7 @@ LogicalTapeSeek(LogicalTapeSet *lts, int tapenum,
 	Assert(lt->frozen);
 	Assert(offset >= 0 && offset <= TapeBlockPayloadSize);
 	Assert(lt->buffer_size == BLCKSZ);
+	Assert(lts->compression == TAPE_COMPRESSION_NONE);
 
 	if (blocknum != lt->curBlockNumber)
 	{
@@ -1070,6 +1389,7 @@ LogicalTapeTell(LogicalTapeSet *lts, int tapenum,
 
 	/* With a larger buffer, 'pos' wouldn't be the same as offset within page */
 	Assert(lt->buffer_size == BLCKSZ);
+	Assert(lts->compression == TAPE_COMPRESSION_NONE);
 
 	*blocknum = lt->curBlockNumber;
 	*offset = lt->pos;
@@ -96,15 +96,19 @@
 
 #include <limits.h>
 
+#include "access/gin.h"
+#include "access/gin_tuple.h"
 #include "access/htup_details.h"
 #include "access/nbtree.h"
 #include "access/hash.h"
 #include "catalog/index.h"
 #include "catalog/pg_am.h"
+#include "catalog/pg_collation.h"
 #include "commands/tablespace.h"
 #include "executor/executor.h"
 #include "miscadmin.h"
 #include "pg_trace.h"
+#include "utils/builtins.h"
 #include "utils/datum.h"
 #include "utils/logtape.h"
 #include "utils/lsyscache.h"
@@ -113,6 +117,7 @@
 #include "utils/rel.h"
 #include "utils/sortsupport.h"
 #include "utils/tuplesort.h"
+#include "utils/typcache.h"
 
 
 /* sort-type codes for sort__start probes */
@@ -245,6 +250,7 @@ struct Tuplesortstate
 	int			tapeRange;		/* maxTapes-1 (Knuth's P) */
 	MemoryContext sortcontext;	/* memory context holding most sort data */
 	MemoryContext tuplecontext; /* sub-context of sortcontext for tuple data */
+	bool		bumpTuples;		/* is tuplecontext a bump context? */
 	LogicalTapeSet *tapeset;	/* logtape.c object for tapes in a temp file */
 
 	/*
@@ -333,6 +339,12 @@ struct Tuplesortstate
 	/* Buffer size to use for reading input tapes, during merge. */
 	size_t		read_buffer_size;
 
+	/*
+	 * Compression method for the tapes.  Random access needs seeking in the
+	 * result tape, which compressed tapes don't support.
+	 */
+	TapeCompression tapeCompression;
+
 	/*
 	 * When we return a tuple to the caller in tuplesort_gettuple_XXX, that
 	 * came from a tape (that is, in TSS_SORTEDONTAPE or TSS_FINALMERGE
@@ -419,6 +431,14 @@ struct Tuplesortstate
 	 */
 	SortSupport onlyKey;
 
+	/*
+	 * True if datum1 of every SortTuple holds the leading sort key (possibly
+	 * abbreviated).  This is what lets tuplesort_sort_memtuples() use the
+	 * sort routines that compare datum1 inline.  Everything except the hash
+	 * index case and CLUSTER on an expression index sets it.
+	 */
+	bool		haveDatum1;
+
 	/*
 	 * Additional state for managing "abbreviated key" sortsupport routines
 	 * (which currently may be used by all cases except the hash index case).
@@ -578,8 +598,23 @@ struct Sharedsort
  * to use the right memory context for these tuples (and to not use the
  * reset context for anything whose lifetime needs to span multiple
  * external sort runs).
+ *
+ * Unless the sort is bounded or builds an index, that context is a bump
+ * context, which saves the chunk header and power-of-2 rounding overhead of
+ * aset.c for every tuple.  A bump context can't tell how big a chunk is or
+ * free one individually, so the space used by a caller tuple must be figured
+ * from its length, with TUPLESPACE, and caller tuples must be released with
+ * FREETUP, which leaves them for the next reset of tuplecontext.
  */
 
+#define TUPLESPACE(state, tup, len) \
+	((state)->bumpTuples ? BumpChunkSpace(len) : GetMemoryChunkSpace(tup))
+#define FREETUP(state, tup) \
+	do { \
+		if (!(state)->bumpTuples) \
+			pfree(tup); \
+	} while(0)
+
 /* When using this macro, beware of double evaluation of len */
 #define LogicalTapeReadExact(tapeset, tapenum, ptr, len) \
 	do { \
@@ -590,7 +625,7 @@ struct Sharedsort
 
 static Tuplesortstate *tuplesort_begin_common(int workMem,
 					   SortCoordinate coordinate,
-					   bool randomAccess);
+					   bool randomAccess, bool bumpTuples);
 static void puttuple_common(Tuplesortstate *state, SortTuple *tuple);
 static bool consider_abort_common(Tuplesortstate *state);
 static void inittapes(Tuplesortstate *state, bool mergeruns);
@@ -635,6 +670,14 @@ static void writetup_index(Tuplesortstate *state, int tapenum,
 			   SortTuple *stup);
 static void readtup_index(Tuplesortstate *state, SortTuple *stup,
 			  int tapenum, unsigned int len);
+static int comparetup_index_gin(const SortTuple *a, const SortTuple *b,
+					 Tuplesortstate *state);
+static void copytup_index_gin(Tuplesortstate *state, SortTuple *stup,
+				  void *tup);
+static void writetup_index_gin(Tuplesortstate *state, int tapenum,
+				   SortTuple *stup);
+static void readtup_index_gin(Tuplesortstate *state, SortTuple *stup,
+				  int tapenum, unsigned int len);
 static int comparetup_datum(const SortTuple *a, const SortTuple *b,
 				 Tuplesortstate *state);
 static void copytup_datum(Tuplesortstate *state, SortTuple *stup, void *tup);
@@ -653,8 +696,68 @@ static void free_sort_tuple(Tuplesortstate *state, SortTuple *stup);
  * any variant of SortTuples, using the appropriate comparetup function.
  * qsort_ssup() is specialized for the case where the comparetup function
  * reduces to ApplySortComparator(), that is single-key MinimalTuple sorts
- * and Datum sorts.
+ * and Datum sorts.  qsort_tuple_unsigned(), qsort_tuple_signed() and
+ * qsort_tuple_int32() are used when the leading key's comparator is one of
+ * the ssup_datum_*_cmp functions; they compare datum1 inline and fall back
+ * to comparetup only on ties, or not at all if there is only one key.
  */
+static inline int
+cmp_tuple_unsigned(const SortTuple *a, const SortTuple *b,
+				   Tuplesortstate *state)
+{
+	int			compare;
+
+	compare = ApplyUnsignedSortComparator(a->datum1, a->isnull1,
+										  b->datum1, b->isnull1,
+										  &state->sortKeys[0]);
+	if (compare != 0)
+		return compare;
+
+	/* No tie-breaker needed if there's only one key, and it's not abbreviated */
+	if (state->onlyKey != NULL)
+		return 0;
+
+	return state->comparetup(a, b, state);
+}
+
+#if SIZEOF_DATUM >= 8
+static inline int
+cmp_tuple_signed(const SortTuple *a, const SortTuple *b,
+				 Tuplesortstate *state)
+{
+	int			compare;
+
+	compare = ApplySignedSortComparator(a->datum1, a->isnull1,
+										b->datum1, b->isnull1,
+										&state->sortKeys[0]);
+	if (compare != 0)
+		return compare;
+
+	if (state->onlyKey != NULL)
+		return 0;
+
+	return state->comparetup(a, b, state);
+}
+#endif
+
+static inline int
+cmp_tuple_int32(const SortTuple *a, const SortTuple *b,
+				Tuplesortstate *state)
+{
+	int			compare;
+
+	compare = ApplyInt32SortComparator(a->datum1, a->isnull1,
+									   b->datum1, b->isnull1,
+									   &state->sortKeys[0]);
+	if (compare != 0)
+		return compare;
+
+	if (state->onlyKey != NULL)
+		return 0;
+
+	return state->comparetup(a, b, state);
+}
+
 #include "qsort_tuple.c"
 
 
@@ -679,7 +782,7 @@ static void free_sort_tuple(Tuplesortstate *state, SortTuple *stup);
 
 static Tuplesortstate *
 tuplesort_begin_common(int workMem, SortCoordinate coordinate,
-					   bool randomAccess)
+					   bool randomAccess, bool bumpTuples)
 {
 	Tuplesortstate *state;
 	MemoryContext sortcontext;
@@ -706,10 +809,19 @@ tuplesort_begin_common(int workMem, SortCoordinate coordinate,
 	 * fragmentation. Note that the memtuples array of SortTuples is allocated
 	 * in the parent context, not this context, because there is no need to
 	 * free memtuples early.
+	 *
+	 * Callers that never need to free individual tuples get a bump context;
+	 * see tuplesort_set_bound() for the exception.
 	 */
-	tuplecontext = AllocSetContextCreate(sortcontext,
+	if (bumpTuples)
+		tuplecontext = BumpContextCreate(sortcontext,
 										 "Caller tuples",
-										 ALLOCSET_DEFAULT_SIZES);
+										 ALLOCSET_DEFAULT_INITSIZE,
+										 ALLOCSET_DEFAULT_MAXSIZE);
+	else
+		tuplecontext = AllocSetContextCreate(sortcontext,
+											 "Caller tuples",
+											 ALLOCSET_DEFAULT_SIZES);
 
 	/*
 	 * Make the Tuplesortstate within the per-sort context.  This way, we
@@ -726,6 +838,8 @@ tuplesort_begin_common(int workMem, SortCoordinate coordinate,
 
 	state->status = TSS_INITIAL;
 	state->randomAccess = randomAccess;
+	state->tapeCompression = randomAccess ? TAPE_COMPRESSION_NONE :
+		(TapeCompression) tape_compression;
 	state->bounded = false;
 	state->tuples = true;
 	state->boundUsed = false;
@@ -740,6 +854,7 @@ tuplesort_begin_common(int workMem, SortCoordinate coordinate,
 	state->availMem = state->allowedMem;
 	state->sortcontext = sortcontext;
 	state->tuplecontext = tuplecontext;
+	state->bumpTuples = bumpTuples;
 	state->tapeset = NULL;
 
 	state->memtupcount = 0;
@@ -810,7 +925,7 @@ tuplesort_begin_heap(TupleDesc tupDesc,
 					 int workMem, SortCoordinate coordinate, bool randomAccess)
 {
 	Tuplesortstate *state = tuplesort_begin_common(workMem, coordinate,
-												   randomAccess);
+												   randomAccess, true);
 	MemoryContext oldcontext;
 	int			i;
 
@@ -871,6 +986,8 @@ tuplesort_begin_heap(TupleDesc tupDesc,
 	if (nkeys == 1 && !state->sortKeys->abbrev_converter)
 		state->onlyKey = state->sortKeys;
 
+	state->haveDatum1 = true;
+
 	MemoryContextSwitchTo(oldcontext);
 
 	return state;
@@ -883,7 +1000,7 @@ tuplesort_begin_cluster(TupleDesc tupDesc,
 						SortCoordinate coordinate, bool randomAccess)
 {
 	Tuplesortstate *state = tuplesort_begin_common(workMem, coordinate,
-												   randomAccess);
+												   randomAccess, true);
 	ScanKey		indexScanKey;
 	MemoryContext oldcontext;
 	int			i;
@@ -917,6 +1034,9 @@ tuplesort_begin_cluster(TupleDesc tupDesc,
 
 	state->indexInfo = BuildIndexInfo(indexRel);
 
+	/* datum1 is only set up if the leading index column is a plain column */
+	state->haveDatum1 = (state->indexInfo->ii_IndexAttrNumbers[0] != 0);
+
 	state->tupDesc = tupDesc;	/* assume we need not copy tupDesc */
 
 	indexScanKey = _bt_mkscankey_nodata(indexRel);
@@ -980,7 +1100,7 @@ tuplesort_begin_index_btree(Relation heapRel,
 							bool randomAccess)
 {
 	Tuplesortstate *state = tuplesort_begin_common(workMem, coordinate,
-												   randomAccess);
+												   randomAccess, false);
 	ScanKey		indexScanKey;
 	MemoryContext oldcontext;
 	int			i;
@@ -1044,6 +1164,8 @@ tuplesort_begin_index_btree(Relation heapRel,
 
 	_bt_freeskey(indexScanKey);
 
+	state->haveDatum1 = true;
+
 	MemoryContextSwitchTo(oldcontext);
 
 	return state;
@@ -1060,7 +1182,7 @@ tuplesort_begin_index_hash(Relation heapRel,
 						   bool randomAccess)
 {
 	Tuplesortstate *state = tuplesort_begin_common(workMem, coordinate,
-												   randomAccess);
+												   randomAccess, false);
 	MemoryContext oldcontext;
 
 	oldcontext = MemoryContextSwitchTo(state->sortcontext);
@@ -1095,13 +1217,170 @@ tuplesort_begin_index_hash(Relation heapRel,
 	return state;
 }
 
+/*
+ * Sort GinTuples for a parallel GIN build.  Tuples are ordered by attribute
+ * number, null category and key, using the opclass's compare function, so
+ * that the leader sees all the entries for one key together.
+ */
+Tuplesortstate *
+tuplesort_begin_index_gin(Relation heapRel,
+						  Relation indexRel,
+						  int workMem,
+						  SortCoordinate coordinate,
+						  bool randomAccess)
+{
+	Tuplesortstate *state = tuplesort_begin_common(workMem, coordinate,
+												   randomAccess, false);
+	TupleDesc	desc = RelationGetDescr(indexRel);
+	MemoryContext oldcontext;
+	int			i;
+
+	oldcontext = MemoryContextSwitchTo(state->sortcontext);
+
+#ifdef TRACE_SORT
+	if (trace_sort)
+		elog(LOG,
+			 "begin index sort: nkeys = %d, workMem = %d, randomAccess = %c",
+			 desc->natts,
+			 workMem, randomAccess ? 't' : 'f');
+#endif
+
+	state->nKeys = desc->natts;
+
+	TRACE_POSTGRESQL_SORT_START(INDEX_SORT,
+								false,	/* no unique check */
+								state->nKeys,
+								workMem,
+								randomAccess,
+								PARALLEL_SORT(state));
+
+	state->comparetup = comparetup_index_gin;
+	state->copytup = copytup_index_gin;
+	state->writetup = writetup_index_gin;
+	state->readtup = readtup_index_gin;
+
+	state->heapRel = heapRel;
+	state->indexRel = indexRel;
+
+	/* Prepare SortSupport data for each column, as initGinState() does */
+	state->sortKeys = (SortSupport) palloc0(state->nKeys *
+											sizeof(SortSupportData));
+
+	for (i = 0; i < state->nKeys; i++)
+	{
+		SortSupport sortKey = state->sortKeys + i;
+		Form_pg_attribute attr = TupleDescAttr(desc, i);
+		Oid			cmpFunc;
+
+		sortKey->ssup_cxt = CurrentMemoryContext;
+		if (OidIsValid(indexRel->rd_indcollation[i]))
+			sortKey->ssup_collation = indexRel->rd_indcollation[i];
+		else
+			sortKey->ssup_collation = DEFAULT_COLLATION_OID;
+		sortKey->ssup_nulls_first = false;
+		sortKey->ssup_attno = i + 1;
+		sortKey->abbreviate = false;
+
+		cmpFunc = index_getprocid(indexRel, i + 1, GIN_COMPARE_PROC);
+		if (!OidIsValid(cmpFunc))
+		{
+			TypeCacheEntry *typentry;
+
+			typentry = lookup_type_cache(attr->atttypid, TYPECACHE_CMP_PROC);
+			if (!OidIsValid(typentry->cmp_proc))
+				ereport(ERROR,
+						(errcode(ERRCODE_UNDEFINED_FUNCTION),
+						 errmsg("could not identify a comparison function for type %s",
+								format_type_be(attr->atttypid))));
+			cmpFunc = typentry->cmp_proc;
+		}
+
+		PrepareSortSupportComparisonShim(cmpFunc, sortKey);
+	}
+
+	MemoryContextSwitchTo(oldcontext);
+
+	return state;
+}
+
+/*
+ * Sort GiST leaf index tuples for a sorted index build.  The tuples are
+ * ordered on their key columns by the opclasses' sortsupport functions,
+ * which see the values in their compressed, stored form.
+ */
+Tuplesortstate *
+tuplesort_begin_index_gist(Relation heapRel,
+						   Relation indexRel,
+						   int workMem,
+						   SortCoordinate coordinate,
+						   bool randomAccess)
+{
+	Tuplesortstate *state = tuplesort_begin_common(workMem, coordinate,
+												   randomAccess, false);
+	MemoryContext oldcontext;
+	int			i;
+
+	oldcontext = MemoryContextSwitchTo(state->sortcontext);
+
+#ifdef TRACE_SORT
+	if (trace_sort)
+		elog(LOG,
+			 "begin index sort: workMem = %d, randomAccess = %c",
+			 workMem, randomAccess ? 't' : 'f');
+#endif
+
+	state->nKeys = IndexRelationGetNumberOfKeyAttributes(indexRel);
+
+	TRACE_POSTGRESQL_SORT_START(INDEX_SORT,
+								false,	/* no unique check */
+								state->nKeys,
+								workMem,
+								randomAccess,
+								PARALLEL_SORT(state));
+
+	state->comparetup = comparetup_index_btree;
+	state->copytup = copytup_index;
+	state->writetup = writetup_index;
+	state->readtup = readtup_index;
+	state->abbrevNext = 10;
+
+	state->heapRel = heapRel;
+	state->indexRel = indexRel;
+
+	/* Prepare SortSupport data for each column */
+	state->sortKeys = (SortSupport) palloc0(state->nKeys *
+											sizeof(SortSupportData));
+
+	for (i = 0; i < state->nKeys; i++)
+	{
+		SortSupport sortKey = state->sortKeys + i;
+
+		sortKey->ssup_cxt = CurrentMemoryContext;
+		sortKey->ssup_collation = indexRel->rd_indcollation[i];
+		sortKey->ssup_nulls_first = false;
+		sortKey->ssup_attno = i + 1;
+		/* Convey if abbreviation optimization is applicable in principle */
+		sortKey->abbreviate = (i == 0);
+
+		AssertState(sortKey->ssup_attno != 0);
+
+		PrepareSortSupportFromGistIndexRel(indexRel, sortKey);
+	}
+
+	state->haveDatum1 = true;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	return state;
+}
+
 Tuplesortstate *
 tuplesort_begin_datum(Oid datumType, Oid sortOperator, Oid sortCollation,
 					  bool nullsFirstFlag, int workMem,
 					  SortCoordinate coordinate, bool randomAccess)
 {
 	Tuplesortstate *state = tuplesort_begin_common(workMem, coordinate,
-												   randomAccess);
+												   randomAccess, true);
 	MemoryContext oldcontext;
 	int16		typlen;
 	bool		typbyval;
@@ -1165,6 +1444,8 @@ tuplesort_begin_datum(Oid datumType, Oid sortOperator, Oid sortCollation,
 	if (!state->sortKeys->abbrev_converter)
 		state->onlyKey = state->sortKeys;
 
+	state->haveDatum1 = true;
+
 	MemoryContextSwitchTo(oldcontext);
 
 	return state;
@@ -1208,6 +1489,19 @@ tuplesort_set_bound(Tuplesortstate *state, int64 bound)
 	state->bounded = true;
 	state->bound = (int) bound;
 
+	/*
+	 * A bounded sort frees the tuples it discards, which a bump context
+	 * can't do.  No tuples have been stored yet, so just replace it.
+	 */
+	if (state->bumpTuples)
+	{
+		MemoryContextDelete(state->tuplecontext);
+		state->tuplecontext = AllocSetContextCreate(state->sortcontext,
+													"Caller tuples",
+													ALLOCSET_DEFAULT_SIZES);
+		state->bumpTuples = false;
+	}
+
 	/*
 	 * Bounded sorts are not an effective target for abbreviated key
 	 * optimization.  Disable by setting state to be consistent with no
@@ -1546,6 +1840,24 @@ tuplesort_putindextuplevalues(Tuplesortstate *state, Relation rel,
 	MemoryContextSwitchTo(oldcontext);
 }
 
+/*
+ * Accept one GinTuple while collecting input data for sort.
+ *
+ * The tuple is copied, so caller may free it afterwards.
+ */
+void
+tuplesort_putgintuple(Tuplesortstate *state, GinTuple *tuple)
+{
+	MemoryContext oldcontext = MemoryContextSwitchTo(state->sortcontext);
+	SortTuple	stup;
+
+	COPYTUP(state, &stup, (void *) tuple);
+
+	puttuple_common(state, &stup);
+
+	MemoryContextSwitchTo(oldcontext);
+}
+
 /*
  * Accept one Datum while collecting input data for sort.
  *
@@ -1586,7 +1898,9 @@ tuplesort_putdatum(Tuplesortstate *state, Datum val, bool isNull)
 
 		stup.isnull1 = false;
 		stup.tuple = DatumGetPointer(original);
-		USEMEM(state, GetMemoryChunkSpace(stup.tuple));
+		USEMEM(state, TUPLESPACE(state, stup.tuple,
+								 datumGetSize(original, false,
+											  state->datumTypeLen)));
 		MemoryContextSwitchTo(state->sortcontext);
 
 		if (!state->sortKeys->abbrev_converter)
@@ -2225,6 +2539,26 @@ tuplesort_getindextuple(Tuplesortstate *state, bool forward)
 	return (IndexTuple) stup.tuple;
 }
 
+/*
+ * Fetch the next GinTuple in either forward or back direction.
+ * Returns NULL if no more tuples.  Returned tuple belongs to tuplesort memory
+ * context, and must not be freed by caller.  Caller may not rely on tuple
+ * remaining valid after any further manipulation of tuplesort.
+ */
+GinTuple *
+tuplesort_getgintuple(Tuplesortstate *state, bool forward)
+{
+	MemoryContext oldcontext = MemoryContextSwitchTo(state->sortcontext);
+	SortTuple	stup;
+
+	if (!tuplesort_gettuple_common(state, forward, &stup))
+		stup.tuple = NULL;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	return (GinTuple *) stup.tuple;
+}
+
 /*
  * Fetch the next Datum in either forward or back direction.
  * Returns false if no more datums.
@@ -2419,7 +2753,7 @@ inittapes(Tuplesortstate *state, bool mergeruns)
 	state->tapeset =
 		LogicalTapeSetCreate(maxTapes, NULL,
 							 state->shared ? &state->shared->fileset : NULL,
-							 state->worker);
+							 state->worker, state->tapeCompression);
 
 	state->currentRun = 0;
 
@@ -3312,6 +3646,37 @@ tuplesort_sort_memtuples(Tuplesortstate *state)
 
 	if (state->memtupcount > 1)
 	{
+		/*
+		 * Do we have a sort routine specialized for the leading key's
+		 * comparator?  These beat even qsort_ssup(), since they avoid calling
+		 * through a function pointer at all.
+		 */
+		if (state->haveDatum1 && state->sortKeys != NULL)
+		{
+			SortSupport leading = state->sortKeys;
+
+			if (leading->comparator == ssup_datum_unsigned_cmp)
+			{
+				qsort_tuple_unsigned(state->memtuples, state->memtupcount,
+									 state);
+				return;
+			}
+#if SIZEOF_DATUM >= 8
+			else if (leading->comparator == ssup_datum_signed_cmp)
+			{
+				qsort_tuple_signed(state->memtuples, state->memtupcount,
+								   state);
+				return;
+			}
+#endif
+			else if (leading->comparator == ssup_datum_int32_cmp)
+			{
+				qsort_tuple_int32(state->memtuples, state->memtupcount,
+								  state);
+				return;
+			}
+		}
+
 		/* Can we use the single-key sort function? */
 		if (state->onlyKey != NULL)
 			qsort_ssup(state->memtuples, state->memtupcount,
@@ -3583,7 +3948,7 @@ copytup_heap(Tuplesortstate *state, SortTuple *stup, void *tup)
 	/* copy the tuple into sort storage */
 	tuple = ExecCopySlotMinimalTuple(slot);
 	stup->tuple = (void *) tuple;
-	USEMEM(state, GetMemoryChunkSpace(tuple));
+	USEMEM(state, TUPLESPACE(state, tuple, tuple->t_len));
 	/* set up first-column key value */
 	htup.t_len = tuple->t_len + MINIMAL_TUPLE_OFFSET;
 	htup.t_data = (HeapTupleHeader) ((char *) tuple - MINIMAL_TUPLE_OFFSET);
@@ -3667,8 +4032,8 @@ writetup_heap(Tuplesortstate *state, int tapenum, SortTuple *stup)
 
 	if (!state->slabAllocatorUsed)
 	{
-		FREEMEM(state, GetMemoryChunkSpace(tuple));
-		heap_free_minimal_tuple(tuple);
+		FREEMEM(state, TUPLESPACE(state, tuple, tuple->t_len));
+		FREETUP(state, tuple);
 	}
 }
 
@@ -3825,7 +4190,7 @@ copytup_cluster(Tuplesortstate *state, SortTuple *stup, void *tup)
 	/* copy the tuple into sort storage */
 	tuple = heap_copytuple(tuple);
 	stup->tuple = (void *) tuple;
-	USEMEM(state, GetMemoryChunkSpace(tuple));
+	USEMEM(state, TUPLESPACE(state, tuple, HEAPTUPLESIZE + tuple->t_len));
 
 	MemoryContextSwitchTo(oldcontext);
 
@@ -3907,8 +4272,8 @@ writetup_cluster(Tuplesortstate *state, int tapenum, SortTuple *stup)
 
 	if (!state->slabAllocatorUsed)
 	{
-		FREEMEM(state, GetMemoryChunkSpace(tuple));
-		heap_freetuple(tuple);
+		FREEMEM(state, TUPLESPACE(state, tuple, HEAPTUPLESIZE + tuple->t_len));
+		FREETUP(state, tuple);
 	}
 }
 
@@ -4239,6 +4604,77 @@ readtup_index(Tuplesortstate *state, SortTuple *stup,
 								 &stup->isnull1);
 }
 
+/*
+ * Routines specialized for the GIN IndexTuple case
+ *
+ * GinTuples carry no leading key in datum1; the comparison is done entirely
+ * by _gin_compare_tuples(), using the opclass compare functions set up in
+ * tuplesort_begin_index_gin().
+ */
+
+static int
+comparetup_index_gin(const SortTuple *a, const SortTuple *b,
+					 Tuplesortstate *state)
+{
+	return _gin_compare_tuples((GinTuple *) a->tuple, (GinTuple *) b->tuple,
+							   state->sortKeys);
+}
+
+static void
+copytup_index_gin(Tuplesortstate *state, SortTuple *stup, void *tup)
+{
+	GinTuple   *tuple = (GinTuple *) tup;
+	GinTuple   *newtuple;
+
+	/* copy the tuple into sort storage */
+	newtuple = (GinTuple *) MemoryContextAlloc(state->tuplecontext,
+											   tuple->tuplen);
+	memcpy(newtuple, tuple, tuple->tuplen);
+	USEMEM(state, GetMemoryChunkSpace(newtuple));
+	stup->tuple = (void *) newtuple;
+	stup->datum1 = (Datum) 0;
+	stup->isnull1 = false;
+}
+
+static void
+writetup_index_gin(Tuplesortstate *state, int tapenum, SortTuple *stup)
+{
+	GinTuple   *tuple = (GinTuple *) stup->tuple;
+	unsigned int tuplen;
+
+	tuplen = tuple->tuplen + sizeof(tuplen);
+	LogicalTapeWrite(state->tapeset, tapenum,
+					 (void *) &tuplen, sizeof(tuplen));
+	LogicalTapeWrite(state->tapeset, tapenum,
+					 (void *) tuple, tuple->tuplen);
+	if (state->randomAccess)	/* need trailing length word? */
+		LogicalTapeWrite(state->tapeset, tapenum,
+						 (void *) &tuplen, sizeof(tuplen));
+
+	if (!state->slabAllocatorUsed)
+	{
+		FREEMEM(state, GetMemoryChunkSpace(tuple));
+		pfree(tuple);
+	}
+}
+
+static void
+readtup_index_gin(Tuplesortstate *state, SortTuple *stup,
+				  int tapenum, unsigned int len)
+{
+	unsigned int tuplen = len - sizeof(unsigned int);
+	GinTuple   *tuple = (GinTuple *) readtup_alloc(state, tuplen);
+
+	LogicalTapeReadExact(state->tapeset, tapenum,
+						 tuple, tuplen);
+	if (state->randomAccess)	/* need trailing length word? */
+		LogicalTapeReadExact(state->tapeset, tapenum,
+							 &tuplen, sizeof(tuplen));
+	stup->tuple = (void *) tuple;
+	stup->datum1 = (Datum) 0;
+	stup->isnull1 = false;
+}
+
 /*
  * Routines specialized for DatumTuple case
  */
@@ -4307,8 +4743,8 @@ writetup_datum(Tuplesortstate *state, int tapenum, SortTuple *stup)
 
 	if (!state->slabAllocatorUsed && stup->tuple)
 	{
-		FREEMEM(state, GetMemoryChunkSpace(stup->tuple));
-		pfree(stup->tuple);
+		FREEMEM(state, TUPLESPACE(state, stup->tuple, tuplen));
+		FREETUP(state, stup->tuple);
 	}
 }
 
@@ -4540,7 +4976,8 @@ leader_takeover_tapes(Tuplesortstate *state)
 	 */
 	inittapestate(state, nParticipants + 1);
 	state->tapeset = LogicalTapeSetCreate(nParticipants + 1, shared->tapes,
-										  &shared->fileset, state->worker);
+										  &shared->fileset, state->worker,
+										  state->tapeCompression);
 
 	/* mergeruns() relies on currentRun for # of runs (in one-pass cases) */
 	state->currentRun = nParticipants;
@@ -4578,6 +5015,8 @@ leader_takeover_tapes(Tuplesortstate *state)
 static void
 free_sort_tuple(Tuplesortstate *state, SortTuple *stup)
 {
+	/* only bounded sorts discard tuples, and they don't use a bump context */
+	Assert(!state->bumpTuples);
 	FREEMEM(state, GetMemoryChunkSpace(stup->tuple));
 	pfree(stup->tuple);
 }
@@ -35,6 +35,10 @@
  * for minimal memory usage.  (The caller must explicitly call tuplestore_trim
  * at appropriate times for truncation to actually happen.)
  *
+ * If tuplestore_compression is enabled at the time the tuplestore spills,
+ * the temp file is written in a block-compressed format instead; see the
+ * notes about compressed spill files below.
+ *
  * Note: in TSS_WRITEFILE state, the temp file's seek position is the
  * current write position, and the write-position variables in the tuplestore
  * aren't kept up to date.  Similarly, in TSS_READFILE state the temp file's
@@ -58,12 +62,17 @@
 
 #include "access/htup_details.h"
 #include "commands/tablespace.h"
+#include "common/pg_lzcompress.h"
 #include "executor/executor.h"
 #include "miscadmin.h"
 #include "storage/buffile.h"
 #include "utils/memutils.h"
 #include "utils/resowner.h"
+#include "utils/tuplestore.h"
+
 
+/* GUC variable */
+bool		tuplestore_compression = false;
 
 /*
  * Possible states of a Tuplestore object.  These denote the states that
@@ -97,6 +106,58 @@ typedef struct
 	off_t		offset;			/* byte offset in file */
 } TSReadPointer;
 
+/*
+ * Size of the logical blocks of a compressed spill file, and the number of
+ * decompressed blocks we keep around for the read pointers to share.
+ */
+#define TS_CBLOCK_SIZE		65536
+#define TS_CBLOCK_CACHE		4
+
+/*
+ * Where one logical block of a compressed spill file is stored.  complen is
+ * the number of bytes it occupies in the temp file; a complen of
+ * TS_CBLOCK_SIZE means the block did not compress and is stored as is.
+ */
+typedef struct TSCompressedBlock
+{
+	int			file;			/* temp file# */
+	off_t		offset;			/* byte offset in file */
+	int32		complen;		/* stored length of the block */
+} TSCompressedBlock;
+
+/*
+ * A decompressed block, shared by all read pointers that are positioned in
+ * it.
+ */
+typedef struct TSCachedBlock
+{
+	int64		blockno;		/* logical block held, or -1 if none */
+	uint64		lastused;		/* for LRU replacement */
+	char	   *data;			/* TS_CBLOCK_SIZE bytes, or NULL */
+} TSCachedBlock;
+
+/*
+ * State for reading and writing a compressed spill file.
+ */
+typedef struct TSCompressState
+{
+	off_t		pos;			/* logical seek position */
+	off_t		end;			/* logical EOF, which is the write position */
+
+	/* the part of the file from block nblocks on is still in wbuf */
+	TSCompressedBlock *blocks;	/* directory of flushed blocks */
+	int64		nblocks;		/* number of blocks flushed to the file */
+	int64		maxblocks;		/* allocated length of blocks array */
+	int			physfile;		/* physical end of the temp file */
+	off_t		physoffset;
+
+	char	   *wbuf;			/* unflushed last block */
+	char	   *cbuf;			/* (de)compression workspace */
+
+	TSCachedBlock cache[TS_CBLOCK_CACHE];
+	uint64		usecount;		/* counter for cache LRU */
+} TSCompressState;
+
 /*
  * Private state of a Tuplestore operation.
  */
@@ -111,6 +172,7 @@ struct Tuplestorestate
 	int64		allowedMem;		/* total memory allowed, in bytes */
 	int64		tuples;			/* number of tuples added */
 	BufFile    *myfile;			/* underlying file, or NULL if none */
+	TSCompressState *cstate;	/* NULL unless myfile is compressed */
 	MemoryContext context;		/* memory context for holding tuples */
 	ResourceOwner resowner;		/* resowner for holding temp files */
 
@@ -216,11 +278,32 @@ struct Tuplestorestate
  * or readtup; they should ereport() on failure.
  *
  *
+ * NOTES about compressed spill files:
+ *
+ * A compressed spill file holds exactly the same stream of length words and
+ * tuple data as an uncompressed one, but the stream is cut into logical
+ * blocks of TS_CBLOCK_SIZE bytes, each of which is compressed with pglz and
+ * appended to the temp file once it is full.  File positions seen by the
+ * rest of this module are logical offsets into the stream, with a file# of
+ * zero; the ts_file_xxx routines translate them using an in-memory directory
+ * of the flushed blocks.  Since the stream is only ever appended to, the
+ * block being filled is kept in memory, and can be read from directly.
+ *
+ * Read pointers never decompress the blocks themselves.  Instead, the last
+ * TS_CBLOCK_CACHE blocks that were read are kept decompressed, and shared by
+ * all read pointers; so when CTE scans or window functions have several
+ * read pointers moving through the same part of the file, each block is
+ * read and decompressed just once.
+ *
+ *
  * NOTES about memory consumption calculations:
  *
  * We count space allocated for tuples against the maxKBytes limit,
  * plus the space used by the variable-size array memtuples.
- * Fixed-size space (primarily the BufFile I/O buffer) is not counted.
+ * Fixed-size space (primarily the BufFile I/O buffer, and the buffers of a
+ * compressed spill file) is not counted.  The block directory of a
+ * compressed spill file isn't counted either; it's small compared to the
+ * file itself.
  * We don't worry about the size of the read pointer array, either.
  *
  * Note that we count actual space used (as shown by GetMemoryChunkSpace)
@@ -238,6 +321,15 @@ static Tuplestorestate *tuplestore_begin_common(int eflags,
 						int maxKBytes);
 static void tuplestore_puttuple_common(Tuplestorestate *state, void *tuple);
 static void dumptuples(Tuplestorestate *state);
+static void ts_file_create(Tuplestorestate *state);
+static void ts_file_close(Tuplestorestate *state);
+static size_t ts_file_read(Tuplestorestate *state, void *ptr, size_t size);
+static size_t ts_file_write(Tuplestorestate *state, void *ptr, size_t size);
+static int	ts_file_seek(Tuplestorestate *state, int fileno, off_t offset,
+			  int whence);
+static void ts_file_tell(Tuplestorestate *state, int *fileno, off_t *offset);
+static void ts_flush_block(Tuplestorestate *state);
+static char *ts_get_block(Tuplestorestate *state, int64 blockno);
 static unsigned int getlen(Tuplestorestate *state, bool eofOK);
 static void *copytup_heap(Tuplestorestate *state, void *tup);
 static void writetup_heap(Tuplestorestate *state, void *tup);
@@ -263,6 +355,7 @@ tuplestore_begin_common(int eflags, bool interXact, int maxKBytes)
 	state->allowedMem = maxKBytes * 1024L;
 	state->availMem = state->allowedMem;
 	state->myfile = NULL;
+	state->cstate = NULL;
 	state->context = CurrentMemoryContext;
 	state->resowner = CurrentResourceOwner;
 
@@ -421,8 +514,7 @@ tuplestore_clear(Tuplestorestate *state)
 	TSReadPointer *readptr;
 
 	if (state->myfile)
-		BufFileClose(state->myfile);
-	state->myfile = NULL;
+		ts_file_close(state);
 	if (state->memtuples)
 	{
 		for (i = state->memtupdeleted; i < state->memtupcount; i++)
@@ -455,7 +547,7 @@ tuplestore_end(Tuplestorestate *state)
 	int			i;
 
 	if (state->myfile)
-		BufFileClose(state->myfile);
+		ts_file_close(state);
 	if (state->memtuples)
 	{
 		for (i = state->memtupdeleted; i < state->memtupcount; i++)
@@ -497,9 +589,9 @@ tuplestore_select_read_pointer(Tuplestorestate *state, int ptr)
 			 * become inactive.
 			 */
 			if (!oldptr->eof_reached)
-				BufFileTell(state->myfile,
-							&oldptr->file,
-							&oldptr->offset);
+				ts_file_tell(state,
+							 &oldptr->file,
+							 &oldptr->offset);
 
 			/*
 			 * We have to make the temp file's seek position equal to the
@@ -509,20 +601,20 @@ tuplestore_select_read_pointer(Tuplestorestate *state, int ptr)
 			 */
 			if (readptr->eof_reached)
 			{
-				if (BufFileSeek(state->myfile,
-								state->writepos_file,
-								state->writepos_offset,
-								SEEK_SET) != 0)
+				if (ts_file_seek(state,
+								 state->writepos_file,
+								 state->writepos_offset,
+								 SEEK_SET) != 0)
 					ereport(ERROR,
 							(errcode_for_file_access(),
 							 errmsg("could not seek in tuplestore temporary file: %m")));
 			}
 			else
 			{
-				if (BufFileSeek(state->myfile,
-								readptr->file,
-								readptr->offset,
-								SEEK_SET) != 0)
+				if (ts_file_seek(state,
+								 readptr->file,
+								 readptr->offset,
+								 SEEK_SET) != 0)
 					ereport(ERROR,
 							(errcode_for_file_access(),
 							 errmsg("could not seek in tuplestore temporary file: %m")));
@@ -818,7 +910,7 @@ tuplestore_puttuple_common(Tuplestorestate *state, void *tuple)
 			oldowner = CurrentResourceOwner;
 			CurrentResourceOwner = state->resowner;
 
-			state->myfile = BufFileCreateTemp(state->interXact);
+			ts_file_create(state);
 
 			CurrentResourceOwner = oldowner;
 
@@ -835,7 +927,7 @@ tuplestore_puttuple_common(Tuplestorestate *state, void *tuple)
 
 			/*
 			 * Update read pointers as needed; see API spec above. Note:
-			 * BufFileTell is quite cheap, so not worth trying to avoid
+			 * ts_file_tell is quite cheap, so not worth trying to avoid
 			 * multiple calls.
 			 */
 			readptr = state->readptrs;
@@ -844,9 +936,9 @@ tuplestore_puttuple_common(Tuplestorestate *state, void *tuple)
 				if (readptr->eof_reached && i != state->activeptr)
 				{
 					readptr->eof_reached = false;
-					BufFileTell(state->myfile,
-								&readptr->file,
-								&readptr->offset);
+					ts_file_tell(state,
+								 &readptr->file,
+								 &readptr->offset);
 				}
 			}
 
@@ -858,12 +950,12 @@ tuplestore_puttuple_common(Tuplestorestate *state, void *tuple)
 			 * Switch from reading to writing.
 			 */
 			if (!state->readptrs[state->activeptr].eof_reached)
-				BufFileTell(state->myfile,
-							&state->readptrs[state->activeptr].file,
-							&state->readptrs[state->activeptr].offset);
-			if (BufFileSeek(state->myfile,
-							state->writepos_file, state->writepos_offset,
-							SEEK_SET) != 0)
+				ts_file_tell(state,
+							 &state->readptrs[state->activeptr].file,
+							 &state->readptrs[state->activeptr].offset);
+			if (ts_file_seek(state,
+							 state->writepos_file, state->writepos_offset,
+							 SEEK_SET) != 0)
 				ereport(ERROR,
 						(errcode_for_file_access(),
 						 errmsg("could not seek in tuplestore temporary file: %m")));
@@ -962,12 +1054,12 @@ tuplestore_gettuple(Tuplestorestate *state, bool forward,
 			/*
 			 * Switch from writing to reading.
 			 */
-			BufFileTell(state->myfile,
-						&state->writepos_file, &state->writepos_offset);
+			ts_file_tell(state,
+						 &state->writepos_file, &state->writepos_offset);
 			if (!readptr->eof_reached)
-				if (BufFileSeek(state->myfile,
-								readptr->file, readptr->offset,
-								SEEK_SET) != 0)
+				if (ts_file_seek(state,
+								 readptr->file, readptr->offset,
+								 SEEK_SET) != 0)
 					ereport(ERROR,
 							(errcode_for_file_access(),
 							 errmsg("could not seek in tuplestore temporary file: %m")));
@@ -999,8 +1091,8 @@ tuplestore_gettuple(Tuplestorestate *state, bool forward,
 			 * Back up to fetch previously-returned tuple's ending length
 			 * word. If seek fails, assume we are at start of file.
 			 */
-			if (BufFileSeek(state->myfile, 0, -(long) sizeof(unsigned int),
-							SEEK_CUR) != 0)
+			if (ts_file_seek(state, 0, -(long) sizeof(unsigned int),
+							 SEEK_CUR) != 0)
 			{
 				/* even a failed backwards fetch gets you out of eof state */
 				readptr->eof_reached = false;
@@ -1019,9 +1111,9 @@ tuplestore_gettuple(Tuplestorestate *state, bool forward,
 				/*
 				 * Back up to get ending length word of tuple before it.
 				 */
-				if (BufFileSeek(state->myfile, 0,
-								-(long) (tuplen + 2 * sizeof(unsigned int)),
-								SEEK_CUR) != 0)
+				if (ts_file_seek(state, 0,
+								 -(long) (tuplen + 2 * sizeof(unsigned int)),
+								 SEEK_CUR) != 0)
 				{
 					/*
 					 * If that fails, presumably the prev tuple is the first
@@ -1029,9 +1121,9 @@ tuplestore_gettuple(Tuplestorestate *state, bool forward,
 					 * in forward direction (not obviously right, but that is
 					 * what in-memory case does).
 					 */
-					if (BufFileSeek(state->myfile, 0,
-									-(long) (tuplen + sizeof(unsigned int)),
-									SEEK_CUR) != 0)
+					if (ts_file_seek(state, 0,
+									 -(long) (tuplen + sizeof(unsigned int)),
+									 SEEK_CUR) != 0)
 						ereport(ERROR,
 								(errcode_for_file_access(),
 								 errmsg("could not seek in tuplestore temporary file: %m")));
@@ -1046,9 +1138,9 @@ tuplestore_gettuple(Tuplestorestate *state, bool forward,
 			 * Note: READTUP expects we are positioned after the initial
 			 * length word of the tuple, so back up to that point.
 			 */
-			if (BufFileSeek(state->myfile, 0,
-							-(long) tuplen,
-							SEEK_CUR) != 0)
+			if (ts_file_seek(state, 0,
+							 -(long) tuplen,
+							 SEEK_CUR) != 0)
 				ereport(ERROR,
 						(errcode_for_file_access(),
 						 errmsg("could not seek in tuplestore temporary file: %m")));
@@ -1215,8 +1307,8 @@ dumptuples(Tuplestorestate *state)
 		for (j = 0; j < state->readptrcount; readptr++, j++)
 		{
 			if (i == readptr->current && !readptr->eof_reached)
-				BufFileTell(state->myfile,
-							&readptr->file, &readptr->offset);
+				ts_file_tell(state,
+							 &readptr->file, &readptr->offset);
 		}
 		if (i >= state->memtupcount)
 			break;
@@ -1250,7 +1342,7 @@ tuplestore_rescan(Tuplestorestate *state)
 			break;
 		case TSS_READFILE:
 			readptr->eof_reached = false;
-			if (BufFileSeek(state->myfile, 0, 0L, SEEK_SET) != 0)
+			if (ts_file_seek(state, 0, 0L, SEEK_SET) != 0)
 				ereport(ERROR,
 						(errcode_for_file_access(),
 						 errmsg("could not seek in tuplestore temporary file: %m")));
@@ -1312,19 +1404,19 @@ tuplestore_copy_read_pointer(Tuplestorestate *state,
 			{
 				if (dptr->eof_reached)
 				{
-					if (BufFileSeek(state->myfile,
-									state->writepos_file,
-									state->writepos_offset,
-									SEEK_SET) != 0)
+					if (ts_file_seek(state,
+									 state->writepos_file,
+									 state->writepos_offset,
+									 SEEK_SET) != 0)
 						ereport(ERROR,
 								(errcode_for_file_access(),
 								 errmsg("could not seek in tuplestore temporary file: %m")));
 				}
 				else
 				{
-					if (BufFileSeek(state->myfile,
-									dptr->file, dptr->offset,
-									SEEK_SET) != 0)
+					if (ts_file_seek(state,
+									 dptr->file, dptr->offset,
+									 SEEK_SET) != 0)
 						ereport(ERROR,
 								(errcode_for_file_access(),
 								 errmsg("could not seek in tuplestore temporary file: %m")));
@@ -1333,9 +1425,9 @@ tuplestore_copy_read_pointer(Tuplestorestate *state,
 			else if (srcptr == state->activeptr)
 			{
 				if (!dptr->eof_reached)
-					BufFileTell(state->myfile,
-								&dptr->file,
-								&dptr->offset);
+					ts_file_tell(state,
+								 &dptr->file,
+								 &dptr->offset);
 			}
 			break;
 		default:
@@ -1458,6 +1550,304 @@ tuplestore_in_memory(Tuplestorestate *state)
 }
 
 
+/*
+ * Temp file access routines
+ *
+ * These hide the difference between plain and compressed spill files from
+ * the rest of the module.  They follow the conventions of the BufFile
+ * routines they stand in for.
+ */
+
+/*
+ * Create the temp file, deciding whether it is to be compressed.
+ */
+static void
+ts_file_create(Tuplestorestate *state)
+{
+	state->myfile = BufFileCreateTemp(state->interXact);
+
+	if (tuplestore_compression)
+	{
+		TSCompressState *cstate;
+		int			i;
+
+		cstate = (TSCompressState *)
+			MemoryContextAllocZero(state->context, sizeof(TSCompressState));
+		cstate->maxblocks = 64; /* arbitrary */
+		cstate->blocks = (TSCompressedBlock *)
+			MemoryContextAlloc(state->context,
+							   cstate->maxblocks * sizeof(TSCompressedBlock));
+		cstate->wbuf = MemoryContextAlloc(state->context, TS_CBLOCK_SIZE);
+		cstate->cbuf = MemoryContextAlloc(state->context,
+										  PGLZ_MAX_OUTPUT(TS_CBLOCK_SIZE));
+		for (i = 0; i < TS_CBLOCK_CACHE; i++)
+			cstate->cache[i].blockno = -1;
+		state->cstate = cstate;
+	}
+}
+
+/*
+ * Close the temp file, and release the compression state if any.
+ */
+static void
+ts_file_close(Tuplestorestate *state)
+{
+	TSCompressState *cstate = state->cstate;
+
+	BufFileClose(state->myfile);
+	state->myfile = NULL;
+
+	if (cstate)
+	{
+		int			i;
+
+		for (i = 0; i < TS_CBLOCK_CACHE; i++)
+		{
+			if (cstate->cache[i].data)
+				pfree(cstate->cache[i].data);
+		}
+		pfree(cstate->blocks);
+		pfree(cstate->wbuf);
+		pfree(cstate->cbuf);
+		pfree(cstate);
+		state->cstate = NULL;
+	}
+}
+
+/*
+ * Read up to size bytes at the current position.  Returns the number of
+ * bytes read, which is less than size only at EOF.
+ */
+static size_t
+ts_file_read(Tuplestorestate *state, void *ptr, size_t size)
+{
+	TSCompressState *cstate = state->cstate;
+	size_t		nread = 0;
+
+	if (cstate == NULL)
+		return BufFileRead(state->myfile, ptr, size);
+
+	while (nread < size && cstate->pos < cstate->end)
+	{
+		int64		blockno = cstate->pos / TS_CBLOCK_SIZE;
+		int			blockoff = cstate->pos % TS_CBLOCK_SIZE;
+		size_t		nthis;
+		char	   *data;
+
+		nthis = Min(size - nread, TS_CBLOCK_SIZE - blockoff);
+		nthis = Min(nthis, cstate->end - cstate->pos);
+
+		if (blockno == cstate->nblocks)
+			data = cstate->wbuf;
+		else
+			data = ts_get_block(state, blockno);
+
+		memcpy((char *) ptr + nread, data + blockoff, nthis);
+		nread += nthis;
+		cstate->pos += nthis;
+	}
+
+	return nread;
+}
+
+/*
+ * Write size bytes at the current position, which must be EOF.  Returns the
+ * number of bytes written.
+ */
+static size_t
+ts_file_write(Tuplestorestate *state, void *ptr, size_t size)
+{
+	TSCompressState *cstate = state->cstate;
+	size_t		nwritten = 0;
+
+	if (cstate == NULL)
+		return BufFileWrite(state->myfile, ptr, size);
+
+	Assert(cstate->pos == cstate->end);
+
+	while (nwritten < size)
+	{
+		int			blockoff = cstate->end % TS_CBLOCK_SIZE;
+		size_t		nthis;
+
+		nthis = Min(size - nwritten, TS_CBLOCK_SIZE - blockoff);
+		memcpy(cstate->wbuf + blockoff, (char *) ptr + nwritten, nthis);
+		nwritten += nthis;
+		cstate->end += nthis;
+
+		if (cstate->end % TS_CBLOCK_SIZE == 0)
+			ts_flush_block(state);
+	}
+	cstate->pos = cstate->end;
+
+	return nwritten;
+}
+
+/*
+ * Change the current position.  Returns 0 if OK, EOF if the new position
+ * would be outside the file.
+ */
+static int
+ts_file_seek(Tuplestorestate *state, int fileno, off_t offset, int whence)
+{
+	TSCompressState *cstate = state->cstate;
+	off_t		newpos;
+
+	if (cstate == NULL)
+		return BufFileSeek(state->myfile, fileno, offset, whence);
+
+	switch (whence)
+	{
+		case SEEK_SET:
+			Assert(fileno == 0);
+			newpos = offset;
+			break;
+		case SEEK_CUR:
+			newpos = cstate->pos + offset;
+			break;
+		default:
+			elog(ERROR, "invalid whence: %d", whence);
+			return EOF;
+	}
+
+	if (newpos < 0 || newpos > cstate->end)
+		return EOF;
+	cstate->pos = newpos;
+	return 0;
+}
+
+/*
+ * Report the current position.
+ */
+static void
+ts_file_tell(Tuplestorestate *state, int *fileno, off_t *offset)
+{
+	if (state->cstate == NULL)
+	{
+		BufFileTell(state->myfile, fileno, offset);
+		return;
+	}
+
+	*fileno = 0;
+	*offset = state->cstate->pos;
+}
+
+/*
+ * Compress the full block in wbuf, and append it to the temp file.
+ */
+static void
+ts_flush_block(Tuplestorestate *state)
+{
+	TSCompressState *cstate = state->cstate;
+	TSCompressedBlock *block;
+	char	   *data;
+	int32		complen;
+
+	Assert(cstate->end == (cstate->nblocks + 1) * TS_CBLOCK_SIZE);
+
+	complen = pglz_compress(cstate->wbuf, TS_CBLOCK_SIZE, cstate->cbuf,
+							PGLZ_strategy_default);
+	if (complen < 0)
+	{
+		/* incompressible, store it as is */
+		data = cstate->wbuf;
+		complen = TS_CBLOCK_SIZE;
+	}
+	else
+		data = cstate->cbuf;
+
+	if (cstate->nblocks >= cstate->maxblocks)
+	{
+		cstate->maxblocks *= 2;
+		cstate->blocks = (TSCompressedBlock *)
+			repalloc_huge(cstate->blocks,
+						  cstate->maxblocks * sizeof(TSCompressedBlock));
+	}
+	block = &cstate->blocks[cstate->nblocks];
+	block->file = cstate->physfile;
+	block->offset = cstate->physoffset;
+	block->complen = complen;
+
+	if (BufFileSeek(state->myfile, cstate->physfile, cstate->physoffset,
+					SEEK_SET) != 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not seek in tuplestore temporary file: %m")));
+	if (BufFileWrite(state->myfile, data, complen) != (size_t) complen)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not write to tuplestore temporary file: %m")));
+	BufFileTell(state->myfile, &cstate->physfile, &cstate->physoffset);
+
+	cstate->nblocks++;
+}
+
+/*
+ * Return the decompressed contents of a flushed block, reading it into the
+ * block cache if it isn't there already.
+ */
+static char *
+ts_get_block(Tuplestorestate *state, int64 blockno)
+{
+	TSCompressState *cstate = state->cstate;
+	TSCompressedBlock *block;
+	TSCachedBlock *victim = NULL;
+	int			i;
+
+	Assert(blockno >= 0 && blockno < cstate->nblocks);
+
+	for (i = 0; i < TS_CBLOCK_CACHE; i++)
+	{
+		TSCachedBlock *cached = &cstate->cache[i];
+
+		if (cached->blockno == blockno)
+		{
+			cached->lastused = ++cstate->usecount;
+			return cached->data;
+		}
+		if (victim == NULL || cached->lastused < victim->lastused)
+			victim = cached;
+	}
+
+	/* Not cached; read it into the least recently used slot */
+	if (victim->data == NULL)
+		victim->data = MemoryContextAlloc(state->context, TS_CBLOCK_SIZE);
+	victim->blockno = -1;
+
+	block = &cstate->blocks[blockno];
+	if (BufFileSeek(state->myfile, block->file, block->offset,
+					SEEK_SET) != 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not seek in tuplestore temporary file: %m")));
+
+	if (block->complen == TS_CBLOCK_SIZE)
+	{
+		if (BufFileRead(state->myfile, victim->data,
+						TS_CBLOCK_SIZE) != TS_CBLOCK_SIZE)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not read from tuplestore temporary file: %m")));
+	}
+	else
+	{
+		if (BufFileRead(state->myfile, cstate->cbuf,
+						block->complen) != (size_t) block->complen)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not read from tuplestore temporary file: %m")));
+		if (pglz_decompress(cstate->cbuf, block->complen, victim->data,
+							TS_CBLOCK_SIZE, true) != TS_CBLOCK_SIZE)
+			elog(ERROR, "compressed tuplestore block " INT64_FORMAT " is corrupt",
+				 blockno);
+	}
+
+	victim->blockno = blockno;
+	victim->lastused = ++cstate->usecount;
+	return victim->data;
+}
+
+
 /*
  * Tape interface routines
  */
@@ -1468,7 +1858,7 @@ getlen(Tuplestorestate *state, bool eofOK)
 	unsigned int len;
 	size_t		nbytes;
 
-	nbytes = BufFileRead(state->myfile, (void *) &len, sizeof(len));
+	nbytes = ts_file_read(state, (void *) &len, sizeof(len));
 	if (nbytes == sizeof(len))
 		return len;
 	if (nbytes != 0 || !eofOK)
@@ -1511,19 +1901,19 @@ writetup_heap(Tuplestorestate *state, void *tup)
 	/* total on-disk footprint: */
 	unsigned int tuplen = tupbodylen + sizeof(int);
 
-	if (BufFileWrite(state->myfile, (void *) &tuplen,
-					 sizeof(tuplen)) != sizeof(tuplen))
+	if (ts_file_write(state, (void *) &tuplen,
+					  sizeof(tuplen)) != sizeof(tuplen))
 		ereport(ERROR,
 				(errcode_for_file_access(),
 				 errmsg("could not write to tuplestore temporary file: %m")));
-	if (BufFileWrite(state->myfile, (void *) tupbody,
-					 tupbodylen) != (size_t) tupbodylen)
+	if (ts_file_write(state, (void *) tupbody,
+					  tupbodylen) != (size_t) tupbodylen)
 		ereport(ERROR,
 				(errcode_for_file_access(),
 				 errmsg("could not write to tuplestore temporary file: %m")));
 	if (state->backward)		/* need trailing length word? */
-		if (BufFileWrite(state->myfile, (void *) &tuplen,
-						 sizeof(tuplen)) != sizeof(tuplen))
+		if (ts_file_write(state, (void *) &tuplen,
+						  sizeof(tuplen)) != sizeof(tuplen))
 			ereport(ERROR,
 					(errcode_for_file_access(),
 					 errmsg("could not write to tuplestore temporary file: %m")));
@@ -1543,14 +1933,14 @@ readtup_heap(Tuplestorestate *state, unsigned int len)
 	USEMEM(state, GetMemoryChunkSpace(tuple));
 	/* read in the tuple proper */
 	tuple->t_len = tuplen;
-	if (BufFileRead(state->myfile, (void *) tupbody,
-					tupbodylen) != (size_t) tupbodylen)
+	if (ts_file_read(state, (void *) tupbody,
+					 tupbodylen) != (size_t) tupbodylen)
 		ereport(ERROR,
 				(errcode_for_file_access(),
 				 errmsg("could not read from tuplestore temporary file: %m")));
 	if (state->backward)		/* need trailing length word? */
-		if (BufFileRead(state->myfile, (void *) &tuplen,
-						sizeof(tuplen)) != sizeof(tuplen))
+		if (ts_file_read(state, (void *) &tuplen,
+						 sizeof(tuplen)) != sizeof(tuplen))
 			ereport(ERROR,
 					(errcode_for_file_access(),
 					 errmsg("could not read from tuplestore temporary file: %m")));
@@ -599,7 +599,10 @@ SetTransactionSnapshot(Snapshot sourcesnap, VirtualTransactionId *sourcevxid,
 	memcpy(CurrentSnapshot->subxip, sourcesnap->subxip,
 		   sourcesnap->subxcnt * sizeof(TransactionId));
 	CurrentSnapshot->suboverflowed = sourcesnap->suboverflowed;
+	CurrentSnapshot->xipSorted = false;
 	CurrentSnapshot->takenDuringRecovery = sourcesnap->takenDuringRecovery;
+	/* the imported contents aren't ours to reuse */
+	CurrentSnapshot->snapXactCompletionCount = 0;
 	/* NB: curcid should NOT be copied, it's a local matter */
 
 	/*
@@ -2151,6 +2154,7 @@ RestoreSnapshot(char *start_address)
 	snapshot->subxip = NULL;
 	snapshot->subxcnt = serialized_snapshot.subxcnt;
 	snapshot->suboverflowed = serialized_snapshot.suboverflowed;
+	snapshot->xipSorted = false;
 	snapshot->takenDuringRecovery = serialized_snapshot.takenDuringRecovery;
 	snapshot->curcid = serialized_snapshot.curcid;
 	snapshot->whenTaken = serialized_snapshot.whenTaken;
@@ -1461,6 +1461,36 @@ HeapTupleIsSurelyDead(HeapTuple htup, TransactionId OldestXmin)
 	return TransactionIdPrecedes(HeapTupleHeaderGetRawXmax(tuple), OldestXmin);
 }
 
+/*
+ * Once a snapshot's XID arrays together hold more than this many entries,
+ * XidInMVCCSnapshot sorts them in place the first time it has to search
+ * them, and uses binary search from then on.  Below this, a linear scan is
+ * as fast and saves the sort.
+ */
+#define SNAPSHOT_SORT_THRESHOLD		64
+
+/*
+ * Is xid among the nxids entries of xids[]?  If sorted, the array has been
+ * sorted with xidComparator and we can use binary search.
+ */
+static inline bool
+XidInSnapshotArray(TransactionId xid, const TransactionId *xids,
+				   uint32 nxids, bool sorted)
+{
+	uint32		i;
+
+	if (sorted)
+		return bsearch(&xid, xids, nxids, sizeof(TransactionId),
+					   xidComparator) != NULL;
+
+	for (i = 0; i < nxids; i++)
+	{
+		if (TransactionIdEquals(xid, xids[i]))
+			return true;
+	}
+	return false;
+}
+
 /*
  * XidInMVCCSnapshot
  *		Is the given XID still-in-progress according to the snapshot?
@@ -1474,8 +1504,6 @@ HeapTupleIsSurelyDead(HeapTuple htup, TransactionId OldestXmin)
 bool
 XidInMVCCSnapshot(TransactionId xid, Snapshot snapshot)
 {
-	uint32		i;
-
 	/*
 	 * Make a quick range check to eliminate most XIDs without looking at the
 	 * xip arrays.  Note that this is OK even if we convert a subxact XID to
@@ -1491,6 +1519,23 @@ XidInMVCCSnapshot(TransactionId xid, Snapshot snapshot)
 	if (TransactionIdFollowsOrEquals(xid, snapshot->xmax))
 		return true;
 
+	/*
+	 * With many concurrent transactions, a snapshot is usually consulted for
+	 * a great many tuples, so it's worth sorting the arrays once to make each
+	 * search O(log N).  The order of the entries has no other significance,
+	 * and any copy of the snapshot made later copies the flag along with
+	 * the sorted arrays.
+	 */
+	if (!snapshot->xipSorted &&
+		snapshot->xcnt + (uint32) snapshot->subxcnt > SNAPSHOT_SORT_THRESHOLD)
+	{
+		qsort(snapshot->xip, snapshot->xcnt, sizeof(TransactionId),
+			  xidComparator);
+		qsort(snapshot->subxip, snapshot->subxcnt, sizeof(TransactionId),
+			  xidComparator);
+		snapshot->xipSorted = true;
+	}
+
 	/*
 	 * Snapshot information is stored slightly differently in snapshots taken
 	 * during recovery.
@@ -1507,13 +1552,9 @@ XidInMVCCSnapshot(TransactionId xid, Snapshot snapshot)
 		if (!snapshot->suboverflowed)
 		{
 			/* we have full data, so search subxip */
-			int32		j;
-
-			for (j = 0; j < snapshot->subxcnt; j++)
-			{
-				if (TransactionIdEquals(xid, snapshot->subxip[j]))
-					return true;
-			}
+			if (XidInSnapshotArray(xid, snapshot->subxip, snapshot->subxcnt,
+								   snapshot->xipSorted))
+				return true;
 
 			/* not there, fall through to search xip[] */
 		}
@@ -1534,16 +1575,12 @@ XidInMVCCSnapshot(TransactionId xid, Snapshot snapshot)
 				return false;
 		}
 
-		for (i = 0; i < snapshot->xcnt; i++)
-		{
-			if (TransactionIdEquals(xid, snapshot->xip[i]))
-				return true;
-		}
+		if (XidInSnapshotArray(xid, snapshot->xip, snapshot->xcnt,
+							   snapshot->xipSorted))
+			return true;
 	}
 	else
 	{
-		int32		j;
-
 		/*
 		 * In recovery we store all xids in the subxact array because it is by
 		 * far the bigger array, and we mostly don't know which xids are
@@ -1573,11 +1610,9 @@ XidInMVCCSnapshot(TransactionId xid, Snapshot snapshot)
 		 * indeterminate xid. We don't know whether it's top level or subxact
 		 * but it doesn't matter. If it's present, the xid is visible.
 		 */
-		for (j = 0; j < snapshot->subxcnt; j++)
-		{
-			if (TransactionIdEquals(xid, snapshot->subxip[j]))
-				return true;
-		}
+		if (XidInSnapshotArray(xid, snapshot->subxip, snapshot->subxcnt,
+							   snapshot->xipSorted))
+			return true;
 	}
 
 	return false;
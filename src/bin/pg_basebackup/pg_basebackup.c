@@ -99,6 +99,10 @@ static bool temp_replication_slot = true;
 static bool create_slot = false;
 static bool no_slot = false;
 static bool verify_checksums = true;
+static char *server_compression = NULL;	/* gzip, lz4 or zstd */
+static int	server_compression_level = 0;	/* 0 means the method's default */
+static int	server_compression_workers = 0;
+static char *incremental_prior = NULL;	/* directory of the prior backup */
 
 static bool success = false;
 static bool made_new_pgdata = false;
@@ -143,6 +147,7 @@ static void ReceiveTarFile(PGconn *conn, PGresult *res, int rownum);
 static void ReceiveAndUnpackTarFile(PGconn *conn, PGresult *res, int rownum);
 static void GenerateRecoveryConf(PGconn *conn);
 static void WriteRecoveryConf(void);
+static char *GetPriorBackupStartLSN(const char *priordir);
 static void BaseBackup(void);
 
 static bool reached_end_position(XLogRecPtr segendpos, uint32 timeline,
@@ -353,6 +358,14 @@ usage(void)
 			 "                         include required WAL files with specified method\n"));
 	printf(_("  -z, --gzip             compress tar output\n"));
 	printf(_("  -Z, --compress=0-9     compress tar output with given compression level\n"));
+	printf(_("      --server-compress=METHOD[:LEVEL]\n"
+			 "                         compress tar output on the server with gzip, lz4\n"
+			 "                         or zstd\n"));
+	printf(_("      --server-compress-workers=N\n"
+			 "                         use N server threads for zstd compression\n"));
+	printf(_("      --incremental=PRIORDIR\n"
+			 "                         take an incremental backup relative to the plain\n"
+			 "                         format backup in PRIORDIR\n"));
 	printf(_("\nGeneral options:\n"));
 	printf(_("  -c, --checkpoint=fast|spread\n"
 			 "                         set fast or spread checkpointing\n"));
@@ -979,11 +992,22 @@ ReceiveTarFile(PGconn *conn, PGresult *res, int rownum)
 	int			file_padding_len = 0;
 	size_t		tarhdrsz = 0;
 	pgoff_t		filesz = 0;
+	const char *suffix = "";
 
 #ifdef HAVE_LIBZ
 	gzFile		ztarfile = NULL;
 #endif
 
+	/* The server sends us an already compressed stream */
+	if (server_compression == NULL)
+		suffix = "";
+	else if (strcmp(server_compression, "gzip") == 0)
+		suffix = ".gz";
+	else if (strcmp(server_compression, "lz4") == 0)
+		suffix = ".lz4";
+	else if (strcmp(server_compression, "zstd") == 0)
+		suffix = ".zst";
+
 	if (basetablespace)
 	{
 		/*
@@ -1032,7 +1056,8 @@ ReceiveTarFile(PGconn *conn, PGresult *res, int rownum)
 			else
 #endif
 			{
-				snprintf(filename, sizeof(filename), "%s/base.tar", basedir);
+				snprintf(filename, sizeof(filename), "%s/base.tar%s", basedir,
+						 suffix);
 				tarfile = fopen(filename, "wb");
 			}
 		}
@@ -1060,8 +1085,8 @@ ReceiveTarFile(PGconn *conn, PGresult *res, int rownum)
 		else
 #endif
 		{
-			snprintf(filename, sizeof(filename), "%s/%s.tar", basedir,
-					 PQgetvalue(res, rownum, 0));
+			snprintf(filename, sizeof(filename), "%s/%s.tar%s", basedir,
+					 PQgetvalue(res, rownum, 0), suffix);
 			tarfile = fopen(filename, "wb");
 		}
 	}
@@ -1120,7 +1145,9 @@ ReceiveTarFile(PGconn *conn, PGresult *res, int rownum)
 			 * file (but not stdout).
 			 *
 			 * Also, write two completely empty blocks at the end of the tar
-			 * file, as required by some tar programs.
+			 * file, as required by some tar programs.  With server-side
+			 * compression, the server has already written them inside the
+			 * compressed stream.
 			 */
 			char		zerobuf[1024];
 
@@ -1157,7 +1184,8 @@ ReceiveTarFile(PGconn *conn, PGresult *res, int rownum)
 			}
 
 			/* 2 * 512 bytes empty data at end of file */
-			WRITE_TAR_DATA(zerobuf, sizeof(zerobuf));
+			if (server_compression == NULL)
+				WRITE_TAR_DATA(zerobuf, sizeof(zerobuf));
 
 #ifdef HAVE_LIBZ
 			if (ztarfile != NULL)
@@ -1672,6 +1700,49 @@ escape_quotes(const char *src)
 	return result;
 }
 
+/*
+ * Get the start LSN of the plain format backup in priordir from its
+ * backup_label, as a string for the INCREMENTAL option of BASE_BACKUP.
+ */
+static char *
+GetPriorBackupStartLSN(const char *priordir)
+{
+	char		filename[MAXPGPATH];
+	char		line[MAXPGPATH];
+	FILE	   *fp;
+	uint32		hi,
+				lo;
+	bool		found = false;
+
+	snprintf(filename, sizeof(filename), "%s/backup_label", priordir);
+	fp = fopen(filename, "r");
+	if (fp == NULL)
+	{
+		fprintf(stderr, _("%s: could not open file \"%s\": %s\n"),
+				progname, filename, strerror(errno));
+		exit(1);
+	}
+
+	while (fgets(line, sizeof(line), fp) != NULL)
+	{
+		if (sscanf(line, "START WAL LOCATION: %X/%X", &hi, &lo) == 2)
+		{
+			found = true;
+			break;
+		}
+	}
+	fclose(fp);
+
+	if (!found)
+	{
+		fprintf(stderr, _("%s: could not find start WAL location in file \"%s\"\n"),
+				progname, filename);
+		exit(1);
+	}
+
+	return psprintf("%X/%X", hi, lo);
+}
+
 /*
  * Create a configuration file in memory using a PQExpBuffer
  */
@@ -1806,6 +1877,8 @@ BaseBackup(void)
 	char	   *basebkp;
 	char		escaped_label[MAXPGPATH];
 	char	   *maxrate_clause = NULL;
+	char	   *compression_clause = NULL;
+	char	   *incremental_clause = NULL;
 	int			i;
 	char		xlogstart[64];
 	char		xlogend[64];
@@ -1867,6 +1940,27 @@ BaseBackup(void)
 	if (maxrate > 0)
 		maxrate_clause = psprintf("MAX_RATE %u", maxrate);
 
+	if (server_compression)
+	{
+		char	   *level_clause = NULL;
+		char	   *workers_clause = NULL;
+
+		if (server_compression_level > 0)
+			level_clause = psprintf(" COMPRESSION_LEVEL %d",
+									server_compression_level);
+		if (server_compression_workers > 0)
+			workers_clause = psprintf(" COMPRESSION_WORKERS %d",
+									  server_compression_workers);
+		compression_clause = psprintf("COMPRESSION '%s'%s%s",
+									  server_compression,
+									  level_clause ? level_clause : "",
+									  workers_clause ? workers_clause : "");
+	}
+
+	if (incremental_prior)
+		incremental_clause = psprintf("INCREMENTAL '%s'",
+									  GetPriorBackupStartLSN(incremental_prior));
+
 	if (verbose)
 		fprintf(stderr,
 				_("%s: initiating base backup, waiting for checkpoint to complete\n"),
@@ -1882,7 +1976,7 @@ BaseBackup(void)
 	}
 
 	basebkp =
-		psprintf("BASE_BACKUP LABEL '%s' %s %s %s %s %s %s %s",
+		psprintf("BASE_BACKUP LABEL '%s' %s %s %s %s %s %s %s %s %s",
 				 escaped_label,
 				 showprogress ? "PROGRESS" : "",
 				 includewal == FETCH_WAL ? "WAL" : "",
@@ -1890,7 +1984,9 @@ BaseBackup(void)
 				 includewal == NO_WAL ? "" : "NOWAIT",
 				 maxrate_clause ? maxrate_clause : "",
 				 format == 't' ? "TABLESPACE_MAP" : "",
-				 verify_checksums ? "" : "NOVERIFY_CHECKSUMS");
+				 verify_checksums ? "" : "NOVERIFY_CHECKSUMS",
+				 compression_clause ? compression_clause : "",
+				 incremental_clause ? incremental_clause : "");
 
 	if (PQsendQuery(conn, basebkp) == 0)
 	{
@@ -2226,6 +2322,9 @@ main(int argc, char **argv)
 		{"waldir", required_argument, NULL, 1},
 		{"no-slot", no_argument, NULL, 2},
 		{"no-verify-checksums", no_argument, NULL, 3},
+		{"server-compress", required_argument, NULL, 4},
+		{"server-compress-workers", required_argument, NULL, 5},
+		{"incremental", required_argument, NULL, 6},
 		{NULL, 0, NULL, 0}
 	};
 	int			c;
@@ -2397,6 +2496,44 @@ main(int argc, char **argv)
 			case 3:
 				verify_checksums = false;
 				break;
+			case 4:
+				{
+					char	   *sep = strchr(optarg, ':');
+
+					if (sep)
+					{
+						*sep = '\0';
+						server_compression_level = atoi(sep + 1);
+						if (server_compression_level <= 0)
+						{
+							fprintf(stderr, _("%s: invalid compression level \"%s\"\n"),
+									progname, sep + 1);
+							exit(1);
+						}
+					}
+					if (strcmp(optarg, "gzip") != 0 &&
+						strcmp(optarg, "lz4") != 0 &&
+						strcmp(optarg, "zstd") != 0)
+					{
+						fprintf(stderr, _("%s: invalid compression method \"%s\", must be \"gzip\", \"lz4\" or \"zstd\"\n"),
+								progname, optarg);
+						exit(1);
+					}
+					server_compression = pg_strdup(optarg);
+				}
+				break;
+			case 5:
+				server_compression_workers = atoi(optarg);
+				if (server_compression_workers <= 0)
+				{
+					fprintf(stderr, _("%s: invalid number of compression workers \"%s\"\n"),
+							progname, optarg);
+					exit(1);
+				}
+				break;
+			case 6:
+				incremental_prior = pg_strdup(optarg);
+				break;
 			default:
 
 				/*
@@ -2445,6 +2582,47 @@ main(int argc, char **argv)
 		exit(1);
 	}
 
+	if (server_compression && format != 't')
+	{
+		fprintf(stderr,
+				_("%s: only tar mode backups can be compressed\n"),
+				progname);
+		fprintf(stderr, _("Try \"%s --help\" for more information.\n"),
+				progname);
+		exit(1);
+	}
+
+	if (server_compression && compresslevel != 0)
+	{
+		fprintf(stderr,
+				_("%s: --server-compress cannot be used with --gzip or --compress\n"),
+				progname);
+		fprintf(stderr, _("Try \"%s --help\" for more information.\n"),
+				progname);
+		exit(1);
+	}
+
+	if (server_compression && writerecoveryconf)
+	{
+		fprintf(stderr,
+				_("%s: --server-compress cannot be used with --write-recovery-conf\n"),
+				progname);
+		fprintf(stderr, _("Try \"%s --help\" for more information.\n"),
+				progname);
+		exit(1);
+	}
+
+	if (server_compression_workers > 0 &&
+		(server_compression == NULL || strcmp(server_compression, "zstd") != 0))
+	{
+		fprintf(stderr,
+				_("%s: --server-compress-workers requires --server-compress=zstd\n"),
+				progname);
+		fprintf(stderr, _("Try \"%s --help\" for more information.\n"),
+				progname);
+		exit(1);
+	}
+
 	if (format == 't' && includewal == STREAM_WAL && strcmp(basedir, "-") == 0)
 	{
 		fprintf(stderr,
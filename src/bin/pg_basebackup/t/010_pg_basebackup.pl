@@ -6,7 +6,7 @@ use File::Basename qw(basename dirname);
 use File::Path qw(rmtree);
 use PostgresNode;
 use TestLib;
-use Test::More tests => 106;
+use Test::More tests => 109;
 
 program_help_ok('pg_basebackup');
 program_version_ok('pg_basebackup');
@@ -174,6 +174,26 @@ $node->command_ok([ 'pg_basebackup', '-D', "$tempdir/tarbackup", '-Ft' ],
 ok(-f "$tempdir/tarbackup/base.tar", 'backup tar was created');
 rmtree("$tempdir/tarbackup");
 
+$node->command_fails(
+	[ 'pg_basebackup', '-D', "$tempdir/backup_foo", '-Fp', '--server-compress=gzip' ],
+	'server-side compression in plain format fails');
+
+SKIP:
+{
+	skip "postgres was not built with ZLIB support", 2
+	  if (!check_pg_config("#define HAVE_LIBZ 1"));
+
+	$node->command_ok(
+		[
+			'pg_basebackup', '-D', "$tempdir/tarbackup_sc", '-Ft',
+			'--server-compress=gzip:1'
+		],
+		'tar format with server-side compression');
+	ok(-f "$tempdir/tarbackup_sc/base.tar.gz",
+		'server-compressed backup tar was created');
+	rmtree("$tempdir/tarbackup_sc");
+}
+
 $node->command_fails(
 	[ 'pg_basebackup', '-D', "$tempdir/backup_foo", '-Fp', "-T=/foo" ],
 	'-T with empty old directory fails');
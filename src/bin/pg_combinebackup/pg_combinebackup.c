@@ -0,0 +1,678 @@
+/*
+ * pg_combinebackup
+ *
+ * Reconstructs a full data directory from a full base backup and a chain
+ * of incremental base backups taken after it.
+ *
+ *	Copyright (c) 2010-2019, PostgreSQL Global Development Group
+ *
+ *	src/bin/pg_combinebackup/pg_combinebackup.c
+ */
+#include "postgres_fe.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "access/xlogdefs.h"
+#include "common/file_perm.h"
+#include "common/file_utils.h"
+#include "getopt_long.h"
+#include "pg_getopt.h"
+#include "replication/basebackup_incremental.h"
+#include "storage/block.h"
+
+
+/* A backup of the chain, oldest first */
+typedef struct BackupInfo
+{
+	char	   *path;
+	XLogRecPtr	start_lsn;		/* from backup_label */
+	XLogRecPtr	incremental_lsn;	/* invalid for the full backup */
+} BackupInfo;
+
+/* Where to get a block of a reconstructed file from */
+typedef struct BlockSource
+{
+	int			backup;			/* index into backups, or -1 for zeroes */
+	off_t		offset;			/* offset in the backup's file; -1 (with
+								 * backup -1) while not found yet */
+} BlockSource;
+
+static BackupInfo *backups;
+static int	nbackups;
+static char *output_dir = NULL;
+static bool do_sync = true;
+static bool verbose = false;
+
+static int64 files_copied = 0;
+static int64 files_reconstructed = 0;
+
+static const char *progname;
+
+static void
+usage(void)
+{
+	printf(_("%s reconstructs a full data directory from incremental base backups.\n\n"), progname);
+	printf(_("Usage:\n"));
+	printf(_("  %s [OPTION]... FULLBACKUP INCREMENTAL...\n"), progname);
+	printf(_("\nOptions:\n"));
+	printf(_("  -o, --output=DIRECTORY output directory\n"));
+	printf(_("  -N, --no-sync          do not wait for changes to be written safely to disk\n"));
+	printf(_("  -v, --verbose          output verbose messages\n"));
+	printf(_("  -V, --version          output version information, then exit\n"));
+	printf(_("  -?, --help             show this help, then exit\n"));
+	printf(_("\nThe backups must be given oldest first, each incremental backup having been\n"
+			 "taken relative to the one before it.\n\n"));
+	printf(_("Report bugs to <pgsql-bugs@postgresql.org>.\n"));
+}
+
+/*
+ * Read the start LSN of a backup from its backup_label, and the LSN it is
+ * relative to if it is an incremental backup.
+ */
+static void
+read_backup_info(BackupInfo *backup)
+{
+	char		filename[MAXPGPATH];
+	char		line[MAXPGPATH];
+	FILE	   *fp;
+	uint32		hi,
+				lo;
+	bool		found = false;
+
+	snprintf(filename, sizeof(filename), "%s/backup_label", backup->path);
+	fp = fopen(filename, "r");
+	if (fp == NULL)
+	{
+		fprintf(stderr, _("%s: could not open file \"%s\": %s\n"),
+				progname, filename, strerror(errno));
+		exit(1);
+	}
+	while (fgets(line, sizeof(line), fp) != NULL)
+	{
+		if (sscanf(line, "START WAL LOCATION: %X/%X", &hi, &lo) == 2)
+		{
+			backup->start_lsn = (XLogRecPtr) hi << 32 | lo;
+			found = true;
+			break;
+		}
+	}
+	fclose(fp);
+	if (!found)
+	{
+		fprintf(stderr, _("%s: could not find start WAL location in file \"%s\"\n"),
+				progname, filename);
+		exit(1);
+	}
+
+	backup->incremental_lsn = InvalidXLogRecPtr;
+	snprintf(filename, sizeof(filename), "%s/%s", backup->path,
+			 INCREMENTAL_BACKUP_FILE);
+	fp = fopen(filename, "r");
+	if (fp == NULL)
+	{
+		if (errno == ENOENT)
+			return;
+		fprintf(stderr, _("%s: could not open file \"%s\": %s\n"),
+				progname, filename, strerror(errno));
+		exit(1);
+	}
+	if (fgets(line, sizeof(line), fp) == NULL ||
+		sscanf(line, INCREMENTAL_BACKUP_LINE, &hi, &lo) != 2)
+	{
+		fprintf(stderr, _("%s: invalid contents in file \"%s\"\n"),
+				progname, filename);
+		exit(1);
+	}
+	fclose(fp);
+	backup->incremental_lsn = (XLogRecPtr) hi << 32 | lo;
+}
+
+/*
+ * Check that the backups form a chain: a full backup followed by
+ * incremental backups, each relative to the one before it.
+ */
+static void
+check_backup_chain(void)
+{
+	int			i;
+
+	for (i = 0; i < nbackups; i++)
+	{
+		read_backup_info(&backups[i]);
+
+		if (i == 0 && !XLogRecPtrIsInvalid(backups[i].incremental_lsn))
+		{
+			fprintf(stderr, _("%s: \"%s\" is an incremental backup, but the first backup must be a full backup\n"),
+					progname, backups[i].path);
+			exit(1);
+		}
+		if (i > 0 && XLogRecPtrIsInvalid(backups[i].incremental_lsn))
+		{
+			fprintf(stderr, _("%s: \"%s\" is a full backup, but only the first backup can be a full backup\n"),
+					progname, backups[i].path);
+			exit(1);
+		}
+		if (i > 0 && backups[i].incremental_lsn != backups[i - 1].start_lsn)
+		{
+			fprintf(stderr, _("%s: backup \"%s\" is relative to LSN %X/%X, but backup \"%s\" starts at %X/%X\n"),
+					progname, backups[i].path,
+					(uint32) (backups[i].incremental_lsn >> 32),
+					(uint32) backups[i].incremental_lsn,
+					backups[i - 1].path,
+					(uint32) (backups[i - 1].start_lsn >> 32),
+					(uint32) backups[i - 1].start_lsn);
+			exit(1);
+		}
+	}
+}
+
+static int
+open_file(const char *fn, int flags)
+{
+	int			fd = open(fn, flags | PG_BINARY, pg_file_create_mode);
+
+	if (fd < 0)
+	{
+		fprintf(stderr, _("%s: could not open file \"%s\": %s\n"),
+				progname, fn, strerror(errno));
+		exit(1);
+	}
+	return fd;
+}
+
+static void
+read_fully(int fd, const char *fn, char *buf, size_t len, off_t offset)
+{
+	ssize_t		r;
+
+	if (lseek(fd, offset, SEEK_SET) < 0)
+	{
+		fprintf(stderr, _("%s: could not seek in file \"%s\": %s\n"),
+				progname, fn, strerror(errno));
+		exit(1);
+	}
+	r = read(fd, buf, len);
+	if (r < 0)
+	{
+		fprintf(stderr, _("%s: could not read file \"%s\": %s\n"),
+				progname, fn, strerror(errno));
+		exit(1);
+	}
+	if (r != len)
+	{
+		fprintf(stderr, _("%s: could not read file \"%s\": read %d of %d\n"),
+				progname, fn, (int) r, (int) len);
+		exit(1);
+	}
+}
+
+static void
+write_fully(int fd, const char *fn, const char *buf, size_t len)
+{
+	errno = 0;
+	if (write(fd, buf, len) != len)
+	{
+		/* if write didn't set errno, assume problem is no disk space */
+		if (errno == 0)
+			errno = ENOSPC;
+		fprintf(stderr, _("%s: could not write file \"%s\": %s\n"),
+				progname, fn, strerror(errno));
+		exit(1);
+	}
+}
+
+/*
+ * Read the header and block list of an incremental file.  The block list is
+ * returned as a malloc'd array.
+ */
+static BlockNumber *
+read_incremental_header(int fd, const char *fn, IncrementalFileHeader *hdr)
+{
+	BlockNumber *blocks;
+
+	read_fully(fd, fn, (char *) hdr, sizeof(*hdr), 0);
+	if (hdr->magic != INCREMENTAL_MAGIC ||
+		hdr->num_blocks > hdr->truncation_block_length ||
+		hdr->truncation_block_length > RELSEG_SIZE)
+	{
+		fprintf(stderr, _("%s: file \"%s\" is not a valid incremental file\n"),
+				progname, fn);
+		exit(1);
+	}
+
+	blocks = pg_malloc(sizeof(BlockNumber) * (hdr->num_blocks + 1));
+	if (hdr->num_blocks > 0)
+		read_fully(fd, fn, (char *) blocks,
+				   sizeof(BlockNumber) * hdr->num_blocks, sizeof(*hdr));
+	return blocks;
+}
+
+/*
+ * Copy a file of the newest backup to the output directory unchanged.
+ */
+static void
+copy_file(const char *src, const char *dst)
+{
+	char		buf[65536];
+	int			srcfd;
+	int			dstfd;
+	ssize_t		r;
+
+	srcfd = open_file(src, O_RDONLY);
+	dstfd = open_file(dst, O_WRONLY | O_CREAT | O_EXCL);
+
+	while ((r = read(srcfd, buf, sizeof(buf))) > 0)
+		write_fully(dstfd, dst, buf, r);
+	if (r < 0)
+	{
+		fprintf(stderr, _("%s: could not read file \"%s\": %s\n"),
+				progname, src, strerror(errno));
+		exit(1);
+	}
+
+	close(srcfd);
+	if (close(dstfd) != 0)
+	{
+		fprintf(stderr, _("%s: could not close file \"%s\": %s\n"),
+				progname, dst, strerror(errno));
+		exit(1);
+	}
+	files_copied++;
+}
+
+/*
+ * Reconstruct relation file "relpath" (relative to the data directory) from
+ * the INCREMENTAL.<name> file of the newest backup and the older backups.
+ *
+ * Each block comes from the newest backup that has it: the block list of an
+ * incremental file says which blocks it has, while a full file has all of
+ * them, so the search stops there.  Blocks past the length the file had in
+ * a backup were added to the relation after that backup; if no newer backup
+ * has them either, they are zeroes.
+ */
+static void
+reconstruct_file(const char *relpath, const char *dst)
+{
+	const char *name = last_dir_separator(relpath) + 1;
+	int			dirlen = name - relpath;
+	BlockSource *sources;
+	BlockNumber nblocks = 0;
+	BlockNumber unresolved;
+	int		   *fds;
+	char	  **fns;
+	int			dstfd;
+	int			i;
+	BlockNumber b;
+	char		buf[BLCKSZ];
+
+	fds = pg_malloc(sizeof(int) * nbackups);
+	fns = pg_malloc0(sizeof(char *) * nbackups);
+	sources = NULL;
+	unresolved = 0;
+
+	for (i = nbackups - 1; i >= 0; i--)
+	{
+		char		fn[MAXPGPATH];
+		struct stat st;
+
+		fds[i] = -1;
+
+		/* A full copy of the file ends the search */
+		snprintf(fn, sizeof(fn), "%s/%s", backups[i].path, relpath);
+		if (i < nbackups - 1 && stat(fn, &st) == 0)
+		{
+			BlockNumber fullblocks = st.st_size / BLCKSZ;
+
+			fns[i] = pg_strdup(fn);
+			fds[i] = open_file(fn, O_RDONLY);
+			for (b = 0; b < nblocks; b++)
+			{
+				if (sources[b].backup != -1 || sources[b].offset != -1)
+					continue;
+				if (b < fullblocks)
+				{
+					sources[b].backup = i;
+					sources[b].offset = (off_t) b * BLCKSZ;
+				}
+				else
+					sources[b].offset = 0;	/* zeroes */
+			}
+			unresolved = 0;
+			break;
+		}
+
+		snprintf(fn, sizeof(fn), "%s/%.*s%s%s", backups[i].path,
+				 dirlen, relpath, INCREMENTAL_PREFIX, name);
+		if (stat(fn, &st) == 0)
+		{
+			IncrementalFileHeader hdr;
+			BlockNumber *blocks;
+			off_t		offset;
+
+			fns[i] = pg_strdup(fn);
+			fds[i] = open_file(fn, O_RDONLY);
+			blocks = read_incremental_header(fds[i], fn, &hdr);
+			offset = sizeof(hdr) + sizeof(BlockNumber) * hdr.num_blocks;
+
+			if (sources == NULL)
+			{
+				/* The newest backup determines the length of the file */
+				nblocks = hdr.truncation_block_length;
+				sources = pg_malloc(sizeof(BlockSource) * (nblocks + 1));
+				for (b = 0; b < nblocks; b++)
+				{
+					/* not found yet */
+					sources[b].backup = -1;
+					sources[b].offset = -1;
+				}
+				unresolved = nblocks;
+			}
+
+			for (b = 0; b < hdr.num_blocks; b++)
+			{
+				BlockNumber blkno = blocks[b];
+
+				if (blkno >= hdr.truncation_block_length ||
+					(b > 0 && blkno <= blocks[b - 1]))
+				{
+					fprintf(stderr, _("%s: file \"%s\" is not a valid incremental file\n"),
+							progname, fn);
+					exit(1);
+				}
+				if (blkno < nblocks && sources[blkno].backup == -1 &&
+					sources[blkno].offset == -1)
+				{
+					sources[blkno].backup = i;
+					sources[blkno].offset = offset + (off_t) b * BLCKSZ;
+					unresolved--;
+				}
+			}
+
+			/* Blocks added after this backup that no newer one has */
+			for (b = hdr.truncation_block_length; b < nblocks; b++)
+			{
+				if (sources[b].backup == -1 && sources[b].offset == -1)
+				{
+					sources[b].offset = 0;
+					unresolved--;
+				}
+			}
+			pg_free(blocks);
+			if (unresolved == 0)
+				break;
+			continue;
+		}
+
+		/* Not in this backup, so every block must be in a newer one */
+		if (unresolved > 0)
+		{
+			fprintf(stderr, _("%s: file \"%s\" is missing from backup \"%s\"\n"),
+					progname, relpath, backups[i].path);
+			exit(1);
+		}
+		break;
+	}
+
+	if (unresolved > 0)
+	{
+		fprintf(stderr, _("%s: could not find all blocks of file \"%s\"\n"),
+				progname, relpath);
+		exit(1);
+	}
+
+	dstfd = open_file(dst, O_WRONLY | O_CREAT | O_EXCL);
+	for (b = 0; b < nblocks; b++)
+	{
+		if (sources[b].backup == -1)
+			memset(buf, 0, BLCKSZ);
+		else
+			read_fully(fds[sources[b].backup], fns[sources[b].backup],
+					   buf, BLCKSZ, sources[b].offset);
+		write_fully(dstfd, dst, buf, BLCKSZ);
+	}
+	if (close(dstfd) != 0)
+	{
+		fprintf(stderr, _("%s: could not close file \"%s\": %s\n"),
+				progname, dst, strerror(errno));
+		exit(1);
+	}
+
+	for (i = 0; i < nbackups; i++)
+	{
+		if (fds[i] >= 0)
+			close(fds[i]);
+		if (fns[i])
+			pg_free(fns[i]);
+	}
+	pg_free(fds);
+	pg_free(fns);
+	if (sources)
+		pg_free(sources);
+
+	if (verbose)
+		fprintf(stderr, _("%s: reconstructed file \"%s\"\n"), progname, relpath);
+	files_reconstructed++;
+}
+
+/*
+ * Process directory "subdir" (relative to the data directory) of the newest
+ * backup, writing its contents to the output directory.
+ */
+static void
+process_directory(const char *subdir)
+{
+	char		path[MAXPGPATH];
+	DIR		   *dir;
+	struct dirent *de;
+
+	snprintf(path, sizeof(path), "%s/%s", backups[nbackups - 1].path, subdir);
+	dir = opendir(path);
+	if (!dir)
+	{
+		fprintf(stderr, _("%s: could not open directory \"%s\": %s\n"),
+				progname, path, strerror(errno));
+		exit(1);
+	}
+	while (errno = 0, (de = readdir(dir)) != NULL)
+	{
+		char		fn[MAXPGPATH];
+		char		relpath[MAXPGPATH];
+		char		dst[MAXPGPATH];
+		struct stat st;
+
+		if (strcmp(de->d_name, ".") == 0 ||
+			strcmp(de->d_name, "..") == 0)
+			continue;
+
+		/* The result is a full backup */
+		if (subdir[0] == '.' && subdir[1] == '\0' &&
+			strcmp(de->d_name, INCREMENTAL_BACKUP_FILE) == 0)
+			continue;
+
+		snprintf(fn, sizeof(fn), "%s/%s", path, de->d_name);
+		snprintf(relpath, sizeof(relpath), "%s/%s", subdir, de->d_name);
+
+		/* Follow symlinks, such as pg_wal placed elsewhere with --waldir */
+		if (stat(fn, &st) < 0)
+		{
+			fprintf(stderr, _("%s: could not stat file \"%s\": %s\n"),
+					progname, fn, strerror(errno));
+			exit(1);
+		}
+
+		if (S_ISDIR(st.st_mode))
+		{
+			snprintf(dst, sizeof(dst), "%s/%s", output_dir, relpath);
+			if (mkdir(dst, pg_dir_create_mode) != 0)
+			{
+				fprintf(stderr, _("%s: could not create directory \"%s\": %s\n"),
+						progname, dst, strerror(errno));
+				exit(1);
+			}
+			process_directory(relpath);
+		}
+		else if (S_ISREG(st.st_mode))
+		{
+			if (strncmp(de->d_name, INCREMENTAL_PREFIX,
+						INCREMENTAL_PREFIX_LENGTH) == 0)
+			{
+				snprintf(relpath, sizeof(relpath), "%s/%s", subdir,
+						 de->d_name + INCREMENTAL_PREFIX_LENGTH);
+				snprintf(dst, sizeof(dst), "%s/%s", output_dir, relpath);
+				reconstruct_file(relpath, dst);
+			}
+			else
+			{
+				snprintf(dst, sizeof(dst), "%s/%s", output_dir, relpath);
+				copy_file(fn, dst);
+			}
+		}
+		else
+			fprintf(stderr, _("%s: skipping special file \"%s\"\n"),
+					progname, fn);
+	}
+	if (errno != 0)
+	{
+		fprintf(stderr, _("%s: could not read directory \"%s\": %s\n"),
+				progname, path, strerror(errno));
+		exit(1);
+	}
+	closedir(dir);
+}
+
+/*
+ * User tablespaces live outside the data directory, in locations chosen
+ * separately for each backup, so we don't try to combine them.
+ */
+static void
+check_no_tablespaces(void)
+{
+	char		path[MAXPGPATH];
+	DIR		   *dir;
+	struct dirent *de;
+	int			i;
+
+	for (i = 0; i < nbackups; i++)
+	{
+		snprintf(path, sizeof(path), "%s/pg_tblspc", backups[i].path);
+		dir = opendir(path);
+		if (!dir)
+		{
+			fprintf(stderr, _("%s: could not open directory \"%s\": %s\n"),
+					progname, path, strerror(errno));
+			exit(1);
+		}
+		while ((de = readdir(dir)) != NULL)
+		{
+			if (strcmp(de->d_name, ".") == 0 ||
+				strcmp(de->d_name, "..") == 0)
+				continue;
+			fprintf(stderr, _("%s: backup \"%s\" contains tablespaces, which are not supported\n"),
+					progname, backups[i].path);
+			exit(1);
+		}
+		closedir(dir);
+	}
+}
+
+int
+main(int argc, char *argv[])
+{
+	static struct option long_options[] = {
+		{"output", required_argument, NULL, 'o'},
+		{"no-sync", no_argument, NULL, 'N'},
+		{"verbose", no_argument, NULL, 'v'},
+		{NULL, 0, NULL, 0}
+	};
+
+	int			c;
+	int			option_index;
+	int			i;
+
+	set_pglocale_pgservice(argv[0], PG_TEXTDOMAIN("pg_combinebackup"));
+
+	progname = get_progname(argv[0]);
+
+	if (argc > 1)
+	{
+		if (strcmp(argv[1], "--help") == 0 || strcmp(argv[1], "-?") == 0)
+		{
+			usage();
+			exit(0);
+		}
+		if (strcmp(argv[1], "--version") == 0 || strcmp(argv[1], "-V") == 0)
+		{
+			puts("pg_combinebackup (PostgreSQL) " PG_VERSION);
+			exit(0);
+		}
+	}
+
+	while ((c = getopt_long(argc, argv, "o:Nv", long_options, &option_index)) != -1)
+	{
+		switch (c)
+		{
+			case 'o':
+				output_dir = pg_strdup(optarg);
+				break;
+			case 'N':
+				do_sync = false;
+				break;
+			case 'v':
+				verbose = true;
+				break;
+			default:
+				fprintf(stderr, _("Try \"%s --help\" for more information.\n"), progname);
+				exit(1);
+		}
+	}
+
+	if (output_dir == NULL)
+	{
+		fprintf(stderr, _("%s: no output directory specified\n"), progname);
+		fprintf(stderr, _("Try \"%s --help\" for more information.\n"), progname);
+		exit(1);
+	}
+
+	nbackups = argc - optind;
+	if (nbackups < 2)
+	{
+		fprintf(stderr, _("%s: at least one full and one incremental backup must be specified\n"),
+				progname);
+		fprintf(stderr, _("Try \"%s --help\" for more information.\n"), progname);
+		exit(1);
+	}
+
+	backups = pg_malloc0(sizeof(BackupInfo) * nbackups);
+	for (i = 0; i < nbackups; i++)
+	{
+		backups[i].path = pg_strdup(argv[optind + i]);
+		canonicalize_path(backups[i].path);
+	}
+	canonicalize_path(output_dir);
+
+	check_backup_chain();
+	check_no_tablespaces();
+
+	umask(pg_mode_mask);
+	if (mkdir(output_dir, pg_dir_create_mode) != 0)
+	{
+		fprintf(stderr, _("%s: could not create directory \"%s\": %s\n"),
+				progname, output_dir, strerror(errno));
+		exit(1);
+	}
+
+	process_directory(".");
+
+	if (do_sync)
+		fsync_pgdata(output_dir, progname, PG_VERSION_NUM);
+
+	if (verbose)
+		fprintf(stderr, _("%s: copied %s files, reconstructed %s files\n"),
+				progname, psprintf(INT64_FORMAT, files_copied),
+				psprintf(INT64_FORMAT, files_reconstructed));
+
+	return 0;
+}
@@ -0,0 +1,71 @@
+# Take a full and two incremental backups, combine them and check that the
+# result can be started and contains the expected data.
+use strict;
+use warnings;
+use File::Find;
+use PostgresNode;
+use TestLib;
+use Test::More tests => 8;
+
+my $node = get_new_node('main');
+$node->init(allows_streaming => 1);
+$node->start;
+
+my $backupdir = $node->backup_dir;
+
+$node->safe_psql('postgres',
+	"CREATE TABLE t (a int) WITH (autovacuum_enabled = off);
+	 INSERT INTO t SELECT generate_series(1, 100000);");
+
+$node->command_ok(
+	[ 'pg_basebackup', '-D', "$backupdir/full", '-X', 'fetch', '--no-sync' ],
+	'full backup');
+
+# Change a few blocks only
+$node->safe_psql('postgres', "UPDATE t SET a = -a WHERE a <= 10;");
+
+$node->command_ok(
+	[
+		'pg_basebackup', '-D', "$backupdir/incr1", '-X', 'fetch',
+		'--no-sync',     "--incremental=$backupdir/full"
+	],
+	'first incremental backup');
+ok(-f "$backupdir/incr1/incremental_backup",
+	'incremental backup is marked as such');
+
+my $relpath =
+  $node->safe_psql('postgres', "SELECT pg_relation_filepath('t')");
+$relpath =~ s{(\d+)$}{INCREMENTAL.$1};
+ok(-f "$backupdir/incr1/$relpath", 'relation sent incrementally');
+
+$node->safe_psql('postgres',
+	"INSERT INTO t SELECT generate_series(100001, 100100);");
+
+$node->command_ok(
+	[
+		'pg_basebackup', '-D', "$backupdir/incr2", '-X', 'fetch',
+		'--no-sync',     "--incremental=$backupdir/incr1"
+	],
+	'second incremental backup');
+
+$node->command_fails(
+	[
+		'pg_combinebackup', '-o', "$backupdir/broken",
+		"$backupdir/full",  "$backupdir/incr2"
+	],
+	'backups out of the chain are rejected');
+
+$node->command_ok(
+	[
+		'pg_combinebackup', '-N', '-o', "$backupdir/combined",
+		"$backupdir/full", "$backupdir/incr1", "$backupdir/incr2"
+	],
+	'combine backups');
+
+my $restored = get_new_node('restored');
+$restored->init_from_backup($node, 'combined');
+$restored->start;
+is( $restored->safe_psql(
+		'postgres', "SELECT count(*), sum(a), count(*) FILTER (WHERE a < 0) FROM t"),
+	'100100|5010054940|10',
+	'combined backup has the data of the last backup');
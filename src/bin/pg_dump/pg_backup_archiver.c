@@ -1893,7 +1893,9 @@ buildTocEntryArrays(ArchiveHandle *AH)
 		 * tableDataId provides the TABLE DATA item's dump ID for each TABLE
 		 * TOC entry that has a DATA item.  We compute this by reversing the
 		 * TABLE DATA item's dependency, knowing that a TABLE DATA item has
-		 * just one dependency and it is the TABLE item.
+		 * just one dependency and it is the TABLE item.  If the table's data
+		 * was dumped in several pieces, tableDataId identifies the first one
+		 * and the others are chained to it through nextChunk.
 		 */
 		if (strcmp(te->desc, "TABLE DATA") == 0 && te->nDeps > 0)
 		{
@@ -1907,7 +1909,16 @@ buildTocEntryArrays(ArchiveHandle *AH)
 			if (tableId <= 0 || tableId > maxDumpId)
 				exit_horribly(modulename, "bad table dumpId for TABLE DATA item\n");
 
-			AH->tableDataId[tableId] = te->dumpId;
+			if (AH->tableDataId[tableId] == 0)
+				AH->tableDataId[tableId] = te->dumpId;
+			else
+			{
+				TocEntry   *chunkte = AH->tocsByDumpId[AH->tableDataId[tableId]];
+
+				while (chunkte->nextChunk != NULL)
+					chunkte = chunkte->nextChunk;
+				chunkte->nextChunk = te;
+			}
 		}
 	}
 }
@@ -4619,6 +4630,9 @@ fix_dependencies(ArchiveHandle *AH)
  * Change dependencies on table items to depend on table data items instead,
  * but only in POST_DATA items.
  *
+ * If the table's data was dumped in several pieces, the item is made to
+ * depend on all of them.
+ *
  * Also, for any item having such dependency(s), set its dataLength to the
  * largest dataLength of the table data items it depends on.  This ensures
  * that parallel restore will prioritize larger jobs (index builds, FK
@@ -4644,11 +4658,24 @@ repoint_table_dependencies(ArchiveHandle *AH)
 			{
 				DumpId		tabledataid = AH->tableDataId[olddep];
 				TocEntry   *tabledatate = AH->tocsByDumpId[tabledataid];
+				TocEntry   *chunkte;
 
 				te->dependencies[i] = tabledataid;
 				te->dataLength = Max(te->dataLength, tabledatate->dataLength);
 				ahlog(AH, 2, "transferring dependency %d -> %d to %d\n",
 					  te->dumpId, olddep, tabledataid);
+
+				for (chunkte = tabledatate->nextChunk; chunkte != NULL;
+					 chunkte = chunkte->nextChunk)
+				{
+					te->dependencies = (DumpId *)
+						pg_realloc(te->dependencies,
+								   (te->nDeps + 1) * sizeof(DumpId));
+					te->dependencies[te->nDeps++] = chunkte->dumpId;
+					te->dataLength = Max(te->dataLength, chunkte->dataLength);
+					ahlog(AH, 2, "adding dependency %d -> %d\n",
+						  te->dumpId, chunkte->dumpId);
+				}
 			}
 		}
 	}
@@ -4762,6 +4789,10 @@ reduce_dependencies(ArchiveHandle *AH, TocEntry *te,
 /*
  * Set the created flag on the DATA member corresponding to the given
  * TABLE member
+ *
+ * If the data is in several pieces, which are loaded concurrently, we leave
+ * the flag unset: the TRUNCATE it leads to would wipe out or block on the
+ * other pieces.
  */
 static void
 mark_create_done(ArchiveHandle *AH, TocEntry *te)
@@ -4770,7 +4801,8 @@ mark_create_done(ArchiveHandle *AH, TocEntry *te)
 	{
 		TocEntry   *ted = AH->tocsByDumpId[AH->tableDataId[te->dumpId]];
 
-		ted->created = true;
+		if (ted->nextChunk == NULL)
+			ted->created = true;
 	}
 }
 
@@ -4786,9 +4818,11 @@ inhibit_data_for_failed_table(ArchiveHandle *AH, TocEntry *te)
 
 	if (AH->tableDataId[te->dumpId] != 0)
 	{
-		TocEntry   *ted = AH->tocsByDumpId[AH->tableDataId[te->dumpId]];
+		TocEntry   *ted;
 
-		ted->reqs = 0;
+		for (ted = AH->tocsByDumpId[AH->tableDataId[te->dumpId]];
+			 ted != NULL; ted = ted->nextChunk)
+			ted->reqs = 0;
 	}
 }
 
@@ -95,6 +95,10 @@ bool		g_verbose;			/* User wants verbose narration of our
 								 * activities. */
 static bool dosync = true;		/* Issue fsync() to make dump durable on disk. */
 
+/* split the data of tables larger than this many megabytes; 0 = never */
+static int	table_chunk_size = 0;
+static BlockNumber table_chunk_pages = 0;
+
 /* subquery used to convert user ID (eg, datdba) to user name */
 static const char *username_subquery;
 
@@ -156,6 +160,8 @@ static void expand_table_name_patterns(Archive *fout,
 						   bool strict_names);
 static NamespaceInfo *findNamespace(Archive *fout, Oid nsoid);
 static void dumpTableData(Archive *fout, TableDataInfo *tdinfo);
+static void dumpTableDataChunks(Archive *fout, TableDataInfo *tdinfo,
+					const char *copyStmt, DataDumperPtr dumpFn);
 static void refreshMatViewData(Archive *fout, TableDataInfo *tdinfo);
 static void guessConstraintInheritance(TableInfo *tblinfo, int numTables);
 static void dumpComment(Archive *fout, const char *type, const char *name,
@@ -376,6 +382,7 @@ main(int argc, char **argv)
 		{"no-unlogged-table-data", no_argument, &dopt.no_unlogged_table_data, 1},
 		{"no-subscriptions", no_argument, &dopt.no_subscriptions, 1},
 		{"no-sync", no_argument, NULL, 7},
+		{"table-chunk-size", required_argument, NULL, 8},
 		{"on-conflict-do-nothing", no_argument, &dopt.do_nothing, 1},
 
 		{NULL, 0, NULL, 0}
@@ -557,6 +564,15 @@ main(int argc, char **argv)
 				dosync = false;
 				break;
 
+			case 8:				/* table-chunk-size */
+				table_chunk_size = atoi(optarg);
+				if (table_chunk_size <= 0)
+				{
+					write_msg(NULL, "table chunk size must be a positive number of megabytes\n");
+					exit_nicely(1);
+				}
+				break;
+
 			default:
 				fprintf(stderr, _("Try \"%s --help\" for more information.\n"), progname);
 				exit_nicely(1);
@@ -658,6 +674,9 @@ main(int argc, char **argv)
 	if (archiveFormat != archDirectory && numWorkers > 1)
 		exit_horribly(NULL, "parallel backup only supported by the directory format\n");
 
+	if (table_chunk_size > 0 && plainText)
+		exit_horribly(NULL, "option --table-chunk-size cannot be used with plain-text format\n");
+
 	/* Open the output file */
 	fout = CreateArchive(filename, archiveFormat, compressLevel, dosync,
 						 archiveMode, setupDumpWorker);
@@ -730,6 +749,23 @@ main(int argc, char **argv)
 	else
 		g_last_builtin_oid = FirstNormalObjectId - 1;
 
+	/*
+	 * Convert the table chunk size to pages of the server's block size.
+	 * Splitting relies on comparison operators for tid, which appeared in
+	 * 8.3; silently dump whole tables from older servers.
+	 */
+	if (table_chunk_size > 0 && fout->remoteVersion >= 80300)
+	{
+		PGresult   *res;
+		int			blocksize;
+
+		res = ExecuteSqlQueryForSingleRow(fout, "SHOW block_size");
+		blocksize = atoi(PQgetvalue(res, 0, 0));
+		PQclear(res);
+
+		table_chunk_pages = Max((uint64) table_chunk_size * 1024 * 1024 / blocksize, 1);
+	}
+
 	if (g_verbose)
 		write_msg(NULL, "last built-in OID is %u\n", g_last_builtin_oid);
 
@@ -982,6 +1018,8 @@ help(const char *progname)
 	printf(_("  --snapshot=SNAPSHOT          use given snapshot for the dump\n"));
 	printf(_("  --strict-names               require table and/or schema include patterns to\n"
 			 "                               match at least one entity each\n"));
+	printf(_("  --table-chunk-size=SIZE      dump data of tables larger than SIZE megabytes\n"
+			 "                               in several separately restorable pieces\n"));
 	printf(_("  --use-set-session-authorization\n"
 			 "                               use SET SESSION AUTHORIZATION commands instead of\n"
 			 "                               ALTER OWNER commands to set ownership\n"));
@@ -1762,7 +1800,8 @@ dumpTableData_copy(Archive *fout, void *dcontext)
 		}
 		else
 			appendPQExpBufferStr(q, "* ");
-		appendPQExpBuffer(q, "FROM %s %s) TO stdout;",
+		appendPQExpBuffer(q, "FROM %s%s %s) TO stdout;",
+						  tdinfo->ischunk ? "ONLY " : "",
 						  fmtQualifiedDumpable(tbinfo),
 						  tdinfo->filtercond);
 	}
@@ -2130,7 +2169,13 @@ dumpTableData(Archive *fout, TableDataInfo *tdinfo)
 	 * dependency on its table as "special" and pass it to ArchiveEntry now.
 	 * See comments for BuildArchiveDependencies.
 	 */
-	if (tdinfo->dobj.dump & DUMP_COMPONENT_DATA)
+	if ((tdinfo->dobj.dump & DUMP_COMPONENT_DATA) &&
+		table_chunk_pages > 0 &&
+		tbinfo->relkind == RELKIND_RELATION &&
+		tdinfo->filtercond == NULL &&
+		(BlockNumber) tbinfo->relpages > table_chunk_pages)
+		dumpTableDataChunks(fout, tdinfo, copyStmt, dumpFn);
+	else if (tdinfo->dobj.dump & DUMP_COMPONENT_DATA)
 	{
 		TocEntry   *te;
 
@@ -2158,6 +2203,83 @@ dumpTableData(Archive *fout, TableDataInfo *tdinfo)
 	destroyPQExpBuffer(clistBuf);
 }
 
+/*
+ * dumpTableDataChunks -
+ *	  make several TABLE DATA ArchiveEntries for one large table
+ *
+ * The table is divided into ranges of table_chunk_pages pages, selected by
+ * ctid, each of which becomes a TABLE DATA item of its own.  In a parallel
+ * dump the pieces are dumped by different workers (into separate files, in
+ * the directory format), and a parallel restore loads them concurrently.
+ * The first piece keeps the dump ID of the TableDataInfo, so that anything
+ * depending on the table's data depends on it; pg_restore recognizes the
+ * other pieces by their dependency on the same table.
+ *
+ * We cannot trust relpages to be exact, so the last piece has no upper
+ * bound.  Each piece is read with a sequential scan that skips the rows
+ * outside its range; when the pieces are dumped at the same time, the
+ * server's synchronized scans let them share most of the I/O.
+ */
+static void
+dumpTableDataChunks(Archive *fout, TableDataInfo *tdinfo,
+					const char *copyStmt, DataDumperPtr dumpFn)
+{
+	TableInfo  *tbinfo = tdinfo->tdtable;
+	BlockNumber relpages = (BlockNumber) tbinfo->relpages;
+	BlockNumber startblk;
+	PQExpBuffer cond = createPQExpBuffer();
+
+	for (startblk = 0; startblk < relpages; startblk += table_chunk_pages)
+	{
+		TableDataInfo *chunk;
+		BlockNumber endblk;
+		TocEntry   *te;
+
+		if (startblk == 0)
+			chunk = tdinfo;
+		else
+		{
+			chunk = (TableDataInfo *) pg_malloc(sizeof(TableDataInfo));
+			memcpy(chunk, tdinfo, sizeof(TableDataInfo));
+			chunk->dobj.dumpId = createDumpId();
+		}
+
+		if (relpages - startblk <= table_chunk_pages)
+			endblk = InvalidBlockNumber;
+		else
+			endblk = startblk + table_chunk_pages;
+
+		resetPQExpBuffer(cond);
+		appendPQExpBufferStr(cond, "WHERE ");
+		if (startblk > 0)
+			appendPQExpBuffer(cond, "ctid >= '(%u,0)'::pg_catalog.tid", startblk);
+		if (startblk > 0 && endblk != InvalidBlockNumber)
+			appendPQExpBufferStr(cond, " AND ");
+		if (endblk != InvalidBlockNumber)
+			appendPQExpBuffer(cond, "ctid < '(%u,0)'::pg_catalog.tid", endblk);
+		chunk->filtercond = pg_strdup(cond->data);
+		chunk->ischunk = true;
+
+		te = ArchiveEntry(fout, chunk->dobj.catId, chunk->dobj.dumpId,
+						  tbinfo->dobj.name, tbinfo->dobj.namespace->dobj.name,
+						  NULL, tbinfo->rolname,
+						  "TABLE DATA", SECTION_DATA,
+						  "", "", copyStmt,
+						  &(tbinfo->dobj.dumpId), 1,
+						  dumpFn, chunk);
+
+		/* as in dumpTableData, dataLength is measured in pages */
+		if (endblk == InvalidBlockNumber)
+		{
+			te->dataLength = relpages - startblk;
+			break;
+		}
+		te->dataLength = table_chunk_pages;
+	}
+
+	destroyPQExpBuffer(cond);
+}
+
 /*
  * refreshMatViewData -
  *	  load or refresh the contents of a single materialized view
@@ -2277,6 +2399,7 @@ makeTableDataInfo(DumpOptions *dopt, TableInfo *tbinfo)
 	tdinfo->dobj.namespace = tbinfo->dobj.namespace;
 	tdinfo->tdtable = tbinfo;
 	tdinfo->filtercond = NULL;	/* might get set later */
+	tdinfo->ischunk = false;
 	addObjectDependency(&tdinfo->dobj, tbinfo->dobj.dumpId);
 
 	tbinfo->dataObj = tdinfo;
@@ -3845,6 +3968,8 @@ getPublicationTables(Archive *fout, TableInfo tblinfo[], int numTables)
 	int			i_tableoid;
 	int			i_oid;
 	int			i_pubname;
+	int			i_prattrs;
+	int			i_prqual;
 	int			i,
 				j,
 				ntups;
@@ -3877,12 +4002,25 @@ getPublicationTables(Archive *fout, TableInfo tblinfo[], int numTables)
 		resetPQExpBuffer(query);
 
 		/* Get the publication membership for the table. */
-		appendPQExpBuffer(query,
-						  "SELECT pr.tableoid, pr.oid, p.pubname "
-						  "FROM pg_publication_rel pr, pg_publication p "
-						  "WHERE pr.prrelid = '%u'"
-						  "  AND p.oid = pr.prpubid",
-						  tbinfo->dobj.catId.oid);
+		if (fout->remoteVersion >= 120000)
+			appendPQExpBuffer(query,
+							  "SELECT pr.tableoid, pr.oid, p.pubname, "
+							  "(SELECT pg_catalog.string_agg(pg_catalog.quote_ident(a.attname), ', ' ORDER BY a.attnum) "
+							  " FROM pg_catalog.pg_attribute a "
+							  " WHERE a.attrelid = pr.prrelid AND a.attnum = ANY(pr.prattrs)) AS prattrs, "
+							  "pg_catalog.pg_get_expr(pr.prqual, pr.prrelid) AS prqual "
+							  "FROM pg_publication_rel pr, pg_publication p "
+							  "WHERE pr.prrelid = '%u'"
+							  "  AND p.oid = pr.prpubid",
+							  tbinfo->dobj.catId.oid);
+		else
+			appendPQExpBuffer(query,
+							  "SELECT pr.tableoid, pr.oid, p.pubname, "
+							  "NULL AS prattrs, NULL AS prqual "
+							  "FROM pg_publication_rel pr, pg_publication p "
+							  "WHERE pr.prrelid = '%u'"
+							  "  AND p.oid = pr.prpubid",
+							  tbinfo->dobj.catId.oid);
 		res = ExecuteSqlQuery(fout, query->data, PGRES_TUPLES_OK);
 
 		ntups = PQntuples(res);
@@ -3899,6 +4037,8 @@ getPublicationTables(Archive *fout, TableInfo tblinfo[], int numTables)
 		i_tableoid = PQfnumber(res, "tableoid");
 		i_oid = PQfnumber(res, "oid");
 		i_pubname = PQfnumber(res, "pubname");
+		i_prattrs = PQfnumber(res, "prattrs");
+		i_prqual = PQfnumber(res, "prqual");
 
 		pubrinfo = pg_malloc(ntups * sizeof(PublicationRelInfo));
 
@@ -3913,6 +4053,14 @@ getPublicationTables(Archive *fout, TableInfo tblinfo[], int numTables)
 			pubrinfo[j].dobj.name = tbinfo->dobj.name;
 			pubrinfo[j].pubname = pg_strdup(PQgetvalue(res, j, i_pubname));
 			pubrinfo[j].pubtable = tbinfo;
+			if (PQgetisnull(res, j, i_prattrs))
+				pubrinfo[j].pubrattrs = NULL;
+			else
+				pubrinfo[j].pubrattrs = pg_strdup(PQgetvalue(res, j, i_prattrs));
+			if (PQgetisnull(res, j, i_prqual))
+				pubrinfo[j].pubrqual = NULL;
+			else
+				pubrinfo[j].pubrqual = pg_strdup(PQgetvalue(res, j, i_prqual));
 
 			/* Decide whether we want to dump it */
 			selectDumpablePublicationTable(&(pubrinfo[j].dobj), fout);
@@ -3942,8 +4090,13 @@ dumpPublicationTable(Archive *fout, PublicationRelInfo *pubrinfo)
 
 	appendPQExpBuffer(query, "ALTER PUBLICATION %s ADD TABLE ONLY",
 					  fmtId(pubrinfo->pubname));
-	appendPQExpBuffer(query, " %s;\n",
+	appendPQExpBuffer(query, " %s",
 					  fmtQualifiedDumpable(tbinfo));
+	if (pubrinfo->pubrattrs)
+		appendPQExpBuffer(query, " (%s)", pubrinfo->pubrattrs);
+	if (pubrinfo->pubrqual)
+		appendPQExpBuffer(query, " WHERE (%s)", pubrinfo->pubrqual);
+	appendPQExpBufferStr(query, ";\n");
 
 	/*
 	 * There is no point in creating drop query as drop query as the drop is
@@ -3998,6 +4151,8 @@ getSubscriptions(Archive *fout)
 	int			i_subconninfo;
 	int			i_subslotname;
 	int			i_subsynccommit;
+	int			i_substream;
+	int			i_subbinary;
 	int			i_subpublications;
 	int			i,
 				ntups;
@@ -4030,11 +4185,19 @@ getSubscriptions(Archive *fout)
 					  "SELECT s.tableoid, s.oid, s.subname,"
 					  "(%s s.subowner) AS rolname, "
 					  " s.subconninfo, s.subslotname, s.subsynccommit, "
-					  " s.subpublications "
-					  "FROM pg_subscription s "
-					  "WHERE s.subdbid = (SELECT oid FROM pg_database"
-					  "                   WHERE datname = current_database())",
+					  " s.subpublications, ",
 					  username_subquery);
+
+	if (fout->remoteVersion >= 120000)
+		appendPQExpBufferStr(query, " s.substream, s.subbinary ");
+	else
+		appendPQExpBufferStr(query,
+							 " false AS substream, false AS subbinary ");
+
+	appendPQExpBufferStr(query,
+						 "FROM pg_subscription s "
+						 "WHERE s.subdbid = (SELECT oid FROM pg_database"
+						 "                   WHERE datname = current_database())");
 	res = ExecuteSqlQuery(fout, query->data, PGRES_TUPLES_OK);
 
 	ntups = PQntuples(res);
@@ -4047,6 +4210,8 @@ getSubscriptions(Archive *fout)
 	i_subslotname = PQfnumber(res, "subslotname");
 	i_subsynccommit = PQfnumber(res, "subsynccommit");
 	i_subpublications = PQfnumber(res, "subpublications");
+	i_substream = PQfnumber(res, "substream");
+	i_subbinary = PQfnumber(res, "subbinary");
 
 	subinfo = pg_malloc(ntups * sizeof(SubscriptionInfo));
 
@@ -4068,6 +4233,10 @@ getSubscriptions(Archive *fout)
 			pg_strdup(PQgetvalue(res, i, i_subsynccommit));
 		subinfo[i].subpublications =
 			pg_strdup(PQgetvalue(res, i, i_subpublications));
+		subinfo[i].substream =
+			pg_strdup(PQgetvalue(res, i, i_substream));
+		subinfo[i].subbinary =
+			pg_strdup(PQgetvalue(res, i, i_subbinary));
 
 		if (strlen(subinfo[i].rolname) == 0)
 			write_msg(NULL, "WARNING: owner of subscription \"%s\" appears to be invalid\n",
@@ -4140,6 +4309,12 @@ dumpSubscription(Archive *fout, SubscriptionInfo *subinfo)
 	if (strcmp(subinfo->subsynccommit, "off") != 0)
 		appendPQExpBuffer(query, ", synchronous_commit = %s", fmtId(subinfo->subsynccommit));
 
+	if (strcmp(subinfo->substream, "f") != 0)
+		appendPQExpBufferStr(query, ", streaming = on");
+
+	if (strcmp(subinfo->subbinary, "f") != 0)
+		appendPQExpBufferStr(query, ", binary = true");
+
 	appendPQExpBufferStr(query, ");\n");
 
 	ArchiveEntry(fout, subinfo->dobj.catId, subinfo->dobj.dumpId,
@@ -12568,6 +12743,9 @@ dumpAccessMethod(Archive *fout, AccessMethodInfo *aminfo)
 		case AMTYPE_INDEX:
 			appendPQExpBuffer(q, "TYPE INDEX ");
 			break;
+		case AMTYPE_TABLE:
+			appendPQExpBuffer(q, "TYPE TABLE ");
+			break;
 		default:
 			write_msg(NULL, "WARNING: invalid type \"%c\" of access method \"%s\"\n",
 					  aminfo->amtype, qamname);
@@ -351,6 +351,7 @@ typedef struct _tableDataInfo
 	DumpableObject dobj;
 	TableInfo  *tdtable;		/* link to table to dump */
 	char	   *filtercond;		/* WHERE condition to limit rows dumped */
+	bool		ischunk;		/* filtercond selects one ctid range */
 } TableDataInfo;
 
 typedef struct _indxInfo
@@ -610,6 +611,8 @@ typedef struct _PublicationRelInfo
 	DumpableObject dobj;
 	TableInfo  *pubtable;
 	char	   *pubname;
+	char	   *pubrattrs;		/* column list, or NULL for all columns */
+	char	   *pubrqual;		/* row filter, or NULL for all rows */
 } PublicationRelInfo;
 
 /*
@@ -622,6 +625,8 @@ typedef struct _SubscriptionInfo
 	char	   *subconninfo;
 	char	   *subslotname;
 	char	   *subsynccommit;
+	char	   *substream;
+	char	   *subbinary;
 	char	   *subpublications;
 } SubscriptionInfo;
 
@@ -4,7 +4,7 @@ use warnings;
 use Config;
 use PostgresNode;
 use TestLib;
-use Test::More tests => 70;
+use Test::More tests => 74;
 
 my $tempdir       = TestLib::tempdir;
 my $tempdir_short = TestLib::tempdir_short;
@@ -86,6 +86,16 @@ command_fails_like(
 	qr/\Qpg_dump: invalid number of parallel jobs\E/,
 	'pg_dump: invalid number of parallel jobs');
 
+command_fails_like(
+	[ 'pg_dump', '--table-chunk-size', '0' ],
+	qr/\Qpg_dump: table chunk size must be a positive number of megabytes\E/,
+	'pg_dump: table chunk size must be a positive number of megabytes');
+
+command_fails_like(
+	[ 'pg_dump', '--table-chunk-size', '100' ],
+	qr/\Qpg_dump: option --table-chunk-size cannot be used with plain-text format\E/,
+	'pg_dump: option --table-chunk-size cannot be used with plain-text format');
+
 command_fails_like(
 	[ 'pg_dump', '-F', 'garbage' ],
 	qr/\Qpg_dump: invalid output format\E/,
@@ -250,6 +250,19 @@ sub run_pg_rewind
 			],
 			'pg_rewind remote');
 	}
+	elsif ($test_mode eq "remote_parallel")
+	{
+
+		# Same, but fetching files over several connections
+		command_ok(
+			[
+				'pg_rewind',       "--debug",
+				"--source-server", $standby_connstr,
+				"--target-pgdata=$master_pgdata",
+				"--no-sync",       "--jobs=3"
+			],
+			'pg_rewind remote with several connections');
+	}
 	else
 	{
 
@@ -250,14 +250,25 @@ execute_pagemap(datapagemap_t *pagemap, const char *path)
 {
 	datapagemap_iterator_t *iter;
 	BlockNumber blkno;
-	off_t		offset;
+	BlockNumber runstart = InvalidBlockNumber;
+	BlockNumber runend = InvalidBlockNumber;
 
+	/* Copy runs of consecutive blocks with one open/seek/close */
 	iter = datapagemap_iterate(pagemap);
 	while (datapagemap_next(iter, &blkno))
 	{
-		offset = blkno * BLCKSZ;
-		rewind_copy_file_range(path, offset, offset + BLCKSZ, false);
-		/* Ok, this block has now been copied from new data dir to old */
+		if (runstart != InvalidBlockNumber && blkno == runend + 1)
+		{
+			runend = blkno;
+			continue;
+		}
+		if (runstart != InvalidBlockNumber)
+			rewind_copy_file_range(path, (off_t) runstart * BLCKSZ,
+								   (off_t) (runend + 1) * BLCKSZ, false);
+		runstart = runend = blkno;
 	}
+	if (runstart != InvalidBlockNumber)
+		rewind_copy_file_range(path, (off_t) runstart * BLCKSZ,
+							   (off_t) (runend + 1) * BLCKSZ, false);
 	pg_free(iter);
 }
@@ -44,9 +44,8 @@ static bool check_file_excluded(const char *path, bool is_source);
 static const char *excludeDirContents[] =
 {
 	/*
-	 * Skip temporary statistics files. PG_STAT_TMP_DIR must be skipped even
-	 * when stats_temp_directory is set because PGSS_TEXT_FILE is always
-	 * created there.
+	 * Skip temporary statistics files.  Extensions such as
+	 * pg_stat_statements keep their transient files in PG_STAT_TMP_DIR.
 	 */
 	"pg_stat_tmp",				/* defined as PG_STAT_TMP_DIR */
 
@@ -101,6 +100,8 @@ static const char *excludeFiles[] =
 	"backup_label",				/* defined as BACKUP_LABEL_FILE */
 	"tablespace_map",			/* defined as TABLESPACE_MAP */
 
+	"pg_doublewrite",			/* defined as DOUBLE_WRITE_FILE */
+
 	"postmaster.pid",
 	"postmaster.opts",
 
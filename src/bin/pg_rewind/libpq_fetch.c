@@ -13,6 +13,9 @@
 #include <dirent.h>
 #include <fcntl.h>
 #include <unistd.h>
+#ifdef HAVE_SYS_SELECT_H
+#include <sys/select.h>
+#endif
 
 #include "pg_rewind.h"
 #include "datapagemap.h"
@@ -28,6 +31,18 @@
 
 static PGconn *conn = NULL;
 
+/*
+ * Connections used to fetch file contents, --jobs of them.  The first one
+ * is 'conn'.  All the ranges of a file are fetched through the same
+ * connection, so that they are received in order, and each new file goes
+ * to the connection with the least data assigned so far.
+ */
+static PGconn **fetch_conns = NULL;
+static uint64 *fetch_conn_bytes = NULL;
+static int	num_fetch_conns = 0;
+static int	cur_fetch_conn = 0;
+static char cur_fetch_path[MAXPGPATH];
+
 /*
  * Files are fetched max CHUNKSIZE bytes at a time.
  *
@@ -38,28 +53,56 @@ static PGconn *conn = NULL;
 #define CHUNKSIZE 1000000
 
 static void receiveFileChunks(const char *sql);
+static void processFileChunk(PGresult *res);
 static void execute_pagemap(datapagemap_t *pagemap, const char *path);
 static char *run_simple_query(const char *sql);
+static PGconn *connect_source(const char *connstr);
 
-void
-libpqConnect(const char *connstr)
+/*
+ * Open a connection to the source server, and set it up for our queries.
+ */
+static PGconn *
+connect_source(const char *connstr)
 {
-	char	   *str;
+	PGconn	   *c;
 	PGresult   *res;
 
-	conn = PQconnectdb(connstr);
-	if (PQstatus(conn) == CONNECTION_BAD)
+	c = PQconnectdb(connstr);
+	if (PQstatus(c) == CONNECTION_BAD)
 		pg_fatal("could not connect to server: %s",
-				 PQerrorMessage(conn));
+				 PQerrorMessage(c));
 
-	pg_log(PG_PROGRESS, "connected to server\n");
-
-	res = PQexec(conn, ALWAYS_SECURE_SEARCH_PATH_SQL);
+	res = PQexec(c, ALWAYS_SECURE_SEARCH_PATH_SQL);
 	if (PQresultStatus(res) != PGRES_TUPLES_OK)
 		pg_fatal("could not clear search_path: %s",
 				 PQresultErrorMessage(res));
 	PQclear(res);
 
+	/*
+	 * Although we don't do any "real" updates, we do work with a temporary
+	 * table. We don't care about synchronous commit for that. It doesn't
+	 * otherwise matter much, but if the server is using synchronous
+	 * replication, and replication isn't working for some reason, we don't
+	 * want to get stuck, waiting for it to start working again.
+	 */
+	res = PQexec(c, "SET synchronous_commit = off");
+	if (PQresultStatus(res) != PGRES_COMMAND_OK)
+		pg_fatal("could not set up connection context: %s",
+				 PQresultErrorMessage(res));
+	PQclear(res);
+
+	return c;
+}
+
+void
+libpqConnect(const char *connstr)
+{
+	char	   *str;
+
+	conn = connect_source(connstr);
+
+	pg_log(PG_PROGRESS, "connected to server\n");
+
 	/*
 	 * Check that the server is not in hot standby mode. There is no
 	 * fundamental reason that couldn't be made to work, but it doesn't
@@ -80,19 +123,6 @@ libpqConnect(const char *connstr)
 	if (strcmp(str, "on") != 0)
 		pg_fatal("full_page_writes must be enabled in the source server\n");
 	pg_free(str);
-
-	/*
-	 * Although we don't do any "real" updates, we do work with a temporary
-	 * table. We don't care about synchronous commit for that. It doesn't
-	 * otherwise matter much, but if the server is using synchronous
-	 * replication, and replication isn't working for some reason, we don't
-	 * want to get stuck, waiting for it to start working again.
-	 */
-	res = PQexec(conn, "SET synchronous_commit = off");
-	if (PQresultStatus(res) != PGRES_COMMAND_OK)
-		pg_fatal("could not set up connection context: %s",
-				 PQresultErrorMessage(res));
-	PQclear(res);
 }
 
 /*
@@ -231,119 +261,194 @@ libpqProcessFileList(void)
  * path		text	-- path in the data directory, e.g "base/1/123"
  * begin	int8	-- offset within the file
  * chunk	bytea	-- file content
+ *
+ * The query is run on all the fetch connections at once, each returning the
+ * ranges loaded into its own 'fetchchunks' table, and the results are
+ * processed as they arrive.
  *----
  */
 static void
 receiveFileChunks(const char *sql)
 {
-	PGresult   *res;
-
-	if (PQsendQueryParams(conn, sql, 0, NULL, NULL, NULL, NULL, 1) != 1)
-		pg_fatal("could not send query: %s", PQerrorMessage(conn));
-
-	pg_log(PG_DEBUG, "getting file chunks\n");
-
-	if (PQsetSingleRowMode(conn) != 1)
-		pg_fatal("could not set libpq connection to single row mode\n");
+	bool	   *active;
+	int			nactive = num_fetch_conns;
+	int			i;
 
-	while ((res = PQgetResult(conn)) != NULL)
+	active = pg_malloc(sizeof(bool) * num_fetch_conns);
+	for (i = 0; i < num_fetch_conns; i++)
 	{
-		char	   *filename;
-		int			filenamelen;
-		int64		chunkoff;
-		char		chunkoff_str[32];
-		int			chunksize;
-		char	   *chunk;
-
-		switch (PQresultStatus(res))
-		{
-			case PGRES_SINGLE_TUPLE:
-				break;
+		PGconn	   *c = fetch_conns[i];
 
-			case PGRES_TUPLES_OK:
-				PQclear(res);
-				continue;		/* final zero-row result */
+		if (PQsendQueryParams(c, sql, 0, NULL, NULL, NULL, NULL, 1) != 1)
+			pg_fatal("could not send query: %s", PQerrorMessage(c));
 
-			default:
-				pg_fatal("unexpected result while fetching remote files: %s",
-						 PQresultErrorMessage(res));
-		}
+		if (PQsetSingleRowMode(c) != 1)
+			pg_fatal("could not set libpq connection to single row mode\n");
+		active[i] = true;
+	}
 
-		/* sanity check the result set */
-		if (PQnfields(res) != 3 || PQntuples(res) != 1)
-			pg_fatal("unexpected result set size while fetching remote files\n");
+	pg_log(PG_DEBUG, "getting file chunks\n");
+
+	while (nactive > 0)
+	{
+		fd_set		input_mask;
+		int			maxfd = -1;
 
-		if (PQftype(res, 0) != TEXTOID ||
-			PQftype(res, 1) != INT8OID ||
-			PQftype(res, 2) != BYTEAOID)
+		/* Wait for data on any of the connections that are still running */
+		FD_ZERO(&input_mask);
+		for (i = 0; i < num_fetch_conns; i++)
 		{
-			pg_fatal("unexpected data types in result set while fetching remote files: %u %u %u\n",
-					 PQftype(res, 0), PQftype(res, 1), PQftype(res, 2));
+			int			sock;
+
+			if (!active[i])
+				continue;
+			sock = PQsocket(fetch_conns[i]);
+			if (sock < 0)
+				pg_fatal("invalid socket: %s", PQerrorMessage(fetch_conns[i]));
+			FD_SET(sock, &input_mask);
+			if (sock > maxfd)
+				maxfd = sock;
 		}
 
-		if (PQfformat(res, 0) != 1 &&
-			PQfformat(res, 1) != 1 &&
-			PQfformat(res, 2) != 1)
+		/* A single connection needs no multiplexing */
+		if (num_fetch_conns > 1 &&
+			select(maxfd + 1, &input_mask, NULL, NULL, NULL) < 0)
 		{
-			pg_fatal("unexpected result format while fetching remote files\n");
+			if (errno == EINTR)
+				continue;
+			pg_fatal("select() failed: %s\n", strerror(errno));
 		}
 
-		if (PQgetisnull(res, 0, 0) ||
-			PQgetisnull(res, 0, 1))
+		for (i = 0; i < num_fetch_conns; i++)
 		{
-			pg_fatal("unexpected null values in result while fetching remote files\n");
+			PGconn	   *c = fetch_conns[i];
+
+			if (!active[i])
+				continue;
+			if (num_fetch_conns > 1 && PQconsumeInput(c) != 1)
+				pg_fatal("could not receive data from server: %s",
+						 PQerrorMessage(c));
+
+			/* Process all the rows that have arrived in full */
+			while (num_fetch_conns == 1 || !PQisBusy(c))
+			{
+				PGresult   *res = PQgetResult(c);
+
+				if (res == NULL)
+				{
+					active[i] = false;
+					nactive--;
+					break;
+				}
+				processFileChunk(res);
+			}
 		}
+	}
 
-		if (PQgetlength(res, 0, 1) != sizeof(int64))
-			pg_fatal("unexpected result length while fetching remote files\n");
-
-		/* Read result set to local variables */
-		memcpy(&chunkoff, PQgetvalue(res, 0, 1), sizeof(int64));
-		chunkoff = pg_ntoh64(chunkoff);
-		chunksize = PQgetlength(res, 0, 2);
-
-		filenamelen = PQgetlength(res, 0, 0);
-		filename = pg_malloc(filenamelen + 1);
-		memcpy(filename, PQgetvalue(res, 0, 0), filenamelen);
-		filename[filenamelen] = '\0';
-
-		chunk = PQgetvalue(res, 0, 2);
-
-		/*
-		 * If a file has been deleted on the source, remove it on the target
-		 * as well.  Note that multiple unlink() calls may happen on the same
-		 * file if multiple data chunks are associated with it, hence ignore
-		 * unconditionally anything missing.  If this file is not a relation
-		 * data file, then it has been already truncated when creating the
-		 * file chunk list at the previous execution of the filemap.
-		 */
-		if (PQgetisnull(res, 0, 2))
-		{
-			pg_log(PG_DEBUG,
-				   "received null value for chunk for file \"%s\", file has been deleted\n",
-				   filename);
-			remove_target_file(filename, true);
-			pg_free(filename);
+	pg_free(active);
+}
+
+/*
+ * Write a piece of a file, received in 'res', to the target data directory.
+ */
+static void
+processFileChunk(PGresult *res)
+{
+	char	   *filename;
+	int			filenamelen;
+	int64		chunkoff;
+	char		chunkoff_str[32];
+	int			chunksize;
+	char	   *chunk;
+
+	switch (PQresultStatus(res))
+	{
+		case PGRES_SINGLE_TUPLE:
+			break;
+
+		case PGRES_TUPLES_OK:
 			PQclear(res);
-			continue;
-		}
+			return;			/* final zero-row result */
 
-		/*
-		 * Separate step to keep platform-dependent format code out of
-		 * translatable strings.
-		 */
-		snprintf(chunkoff_str, sizeof(chunkoff_str), INT64_FORMAT, chunkoff);
-		pg_log(PG_DEBUG, "received chunk for file \"%s\", offset %s, size %d\n",
-			   filename, chunkoff_str, chunksize);
+		default:
+			pg_fatal("unexpected result while fetching remote files: %s",
+					 PQresultErrorMessage(res));
+	}
 
-		open_target_file(filename, false);
+	/* sanity check the result set */
+	if (PQnfields(res) != 3 || PQntuples(res) != 1)
+		pg_fatal("unexpected result set size while fetching remote files\n");
 
-		write_target_range(chunk, chunkoff, chunksize);
+	if (PQftype(res, 0) != TEXTOID ||
+		PQftype(res, 1) != INT8OID ||
+		PQftype(res, 2) != BYTEAOID)
+	{
+		pg_fatal("unexpected data types in result set while fetching remote files: %u %u %u\n",
+				 PQftype(res, 0), PQftype(res, 1), PQftype(res, 2));
+	}
 
-		pg_free(filename);
+	if (PQfformat(res, 0) != 1 &&
+		PQfformat(res, 1) != 1 &&
+		PQfformat(res, 2) != 1)
+	{
+		pg_fatal("unexpected result format while fetching remote files\n");
+	}
+
+	if (PQgetisnull(res, 0, 0) ||
+		PQgetisnull(res, 0, 1))
+	{
+		pg_fatal("unexpected null values in result while fetching remote files\n");
+	}
+
+	if (PQgetlength(res, 0, 1) != sizeof(int64))
+		pg_fatal("unexpected result length while fetching remote files\n");
+
+	/* Read result set to local variables */
+	memcpy(&chunkoff, PQgetvalue(res, 0, 1), sizeof(int64));
+	chunkoff = pg_ntoh64(chunkoff);
+	chunksize = PQgetlength(res, 0, 2);
+
+	filenamelen = PQgetlength(res, 0, 0);
+	filename = pg_malloc(filenamelen + 1);
+	memcpy(filename, PQgetvalue(res, 0, 0), filenamelen);
+	filename[filenamelen] = '\0';
 
+	chunk = PQgetvalue(res, 0, 2);
+
+	/*
+	 * If a file has been deleted on the source, remove it on the target
+	 * as well.  Note that multiple unlink() calls may happen on the same
+	 * file if multiple data chunks are associated with it, hence ignore
+	 * unconditionally anything missing.  If this file is not a relation
+	 * data file, then it has been already truncated when creating the
+	 * file chunk list at the previous execution of the filemap.
+	 */
+	if (PQgetisnull(res, 0, 2))
+	{
+		pg_log(PG_DEBUG,
+			   "received null value for chunk for file \"%s\", file has been deleted\n",
+			   filename);
+		remove_target_file(filename, true);
+		pg_free(filename);
 		PQclear(res);
+		return;
 	}
+
+	/*
+	 * Separate step to keep platform-dependent format code out of
+	 * translatable strings.
+	 */
+	snprintf(chunkoff_str, sizeof(chunkoff_str), INT64_FORMAT, chunkoff);
+	pg_log(PG_DEBUG, "received chunk for file \"%s\", offset %s, size %d\n",
+		   filename, chunkoff_str, chunksize);
+
+	open_target_file(filename, false);
+
+	write_target_range(chunk, chunkoff, chunksize);
+
+	pg_free(filename);
+
+	PQclear(res);
 }
 
 /*
@@ -389,13 +494,30 @@ libpqGetFile(const char *filename, size_t *filesize)
  * Write a file range to a temporary table in the server.
  *
  * The range is sent to the server as a COPY formatted line, to be inserted
- * into the 'fetchchunks' temporary table. It is used in receiveFileChunks()
- * function to actually fetch the data.
+ * into the 'fetchchunks' temporary table of one of the fetch connections.
+ * It is used in receiveFileChunks() function to actually fetch the data.
  */
 static void
 fetch_file_range(const char *path, uint64 begin, uint64 end)
 {
 	char		linebuf[MAXPGPATH + 23];
+	PGconn	   *c;
+
+	/* Pick the least busy connection for a new file */
+	if (strcmp(path, cur_fetch_path) != 0)
+	{
+		int			i;
+
+		cur_fetch_conn = 0;
+		for (i = 1; i < num_fetch_conns; i++)
+		{
+			if (fetch_conn_bytes[i] < fetch_conn_bytes[cur_fetch_conn])
+				cur_fetch_conn = i;
+		}
+		strlcpy(cur_fetch_path, path, sizeof(cur_fetch_path));
+	}
+	c = fetch_conns[cur_fetch_conn];
+	fetch_conn_bytes[cur_fetch_conn] += end - begin;
 
 	/* Split the range into CHUNKSIZE chunks */
 	while (end - begin > 0)
@@ -410,9 +532,9 @@ fetch_file_range(const char *path, uint64 begin, uint64 end)
 
 		snprintf(linebuf, sizeof(linebuf), "%s\t" UINT64_FORMAT "\t%u\n", path, begin, len);
 
-		if (PQputCopyData(conn, linebuf, strlen(linebuf)) != 1)
+		if (PQputCopyData(c, linebuf, strlen(linebuf)) != 1)
 			pg_fatal("could not send COPY data: %s",
-					 PQerrorMessage(conn));
+					 PQerrorMessage(c));
 
 		begin += len;
 	}
@@ -429,25 +551,37 @@ libpq_executeFileMap(filemap_t *map)
 	PGresult   *res;
 	int			i;
 
+	/* Open the additional connections requested with --jobs */
+	num_fetch_conns = num_jobs;
+	fetch_conns = pg_malloc(sizeof(PGconn *) * num_fetch_conns);
+	fetch_conn_bytes = pg_malloc0(sizeof(uint64) * num_fetch_conns);
+	fetch_conns[0] = conn;
+	for (i = 1; i < num_fetch_conns; i++)
+		fetch_conns[i] = connect_source(connstr_source);
+	cur_fetch_path[0] = '\0';
+
 	/*
-	 * First create a temporary table, and load it with the blocks that we
-	 * need to fetch.
+	 * First create a temporary table in each session, and load them with
+	 * the blocks that we need to fetch.
 	 */
-	sql = "CREATE TEMPORARY TABLE fetchchunks(path text, begin int8, len int4);";
-	res = PQexec(conn, sql);
+	for (i = 0; i < num_fetch_conns; i++)
+	{
+		sql = "CREATE TEMPORARY TABLE fetchchunks(path text, begin int8, len int4);";
+		res = PQexec(fetch_conns[i], sql);
 
-	if (PQresultStatus(res) != PGRES_COMMAND_OK)
-		pg_fatal("could not create temporary table: %s",
-				 PQresultErrorMessage(res));
-	PQclear(res);
+		if (PQresultStatus(res) != PGRES_COMMAND_OK)
+			pg_fatal("could not create temporary table: %s",
+					 PQresultErrorMessage(res));
+		PQclear(res);
 
-	sql = "COPY fetchchunks FROM STDIN";
-	res = PQexec(conn, sql);
+		sql = "COPY fetchchunks FROM STDIN";
+		res = PQexec(fetch_conns[i], sql);
 
-	if (PQresultStatus(res) != PGRES_COPY_IN)
-		pg_fatal("could not send file list: %s",
-				 PQresultErrorMessage(res));
-	PQclear(res);
+		if (PQresultStatus(res) != PGRES_COPY_IN)
+			pg_fatal("could not send file list: %s",
+					 PQresultErrorMessage(res));
+		PQclear(res);
+	}
 
 	for (i = 0; i < map->narray; i++)
 	{
@@ -486,16 +620,19 @@ libpq_executeFileMap(filemap_t *map)
 		}
 	}
 
-	if (PQputCopyEnd(conn, NULL) != 1)
-		pg_fatal("could not send end-of-COPY: %s",
-				 PQerrorMessage(conn));
-
-	while ((res = PQgetResult(conn)) != NULL)
+	for (i = 0; i < num_fetch_conns; i++)
 	{
-		if (PQresultStatus(res) != PGRES_COMMAND_OK)
-			pg_fatal("unexpected result while sending file list: %s",
-					 PQresultErrorMessage(res));
-		PQclear(res);
+		if (PQputCopyEnd(fetch_conns[i], NULL) != 1)
+			pg_fatal("could not send end-of-COPY: %s",
+					 PQerrorMessage(fetch_conns[i]));
+
+		while ((res = PQgetResult(fetch_conns[i])) != NULL)
+		{
+			if (PQresultStatus(res) != PGRES_COMMAND_OK)
+				pg_fatal("unexpected result while sending file list: %s",
+						 PQresultErrorMessage(res));
+			PQclear(res);
+		}
 	}
 
 	/*
@@ -508,21 +645,39 @@ libpq_executeFileMap(filemap_t *map)
 		"FROM fetchchunks\n";
 
 	receiveFileChunks(sql);
+
+	for (i = 1; i < num_fetch_conns; i++)
+		PQfinish(fetch_conns[i]);
 }
 
+/*
+ * Fetch the blocks marked in the page map.  Runs of consecutive blocks are
+ * fetched as one range, which fetch_file_range() splits into CHUNKSIZE
+ * pieces, instead of one block at a time.
+ */
 static void
 execute_pagemap(datapagemap_t *pagemap, const char *path)
 {
 	datapagemap_iterator_t *iter;
 	BlockNumber blkno;
-	off_t		offset;
+	BlockNumber runstart = InvalidBlockNumber;
+	BlockNumber runend = InvalidBlockNumber;
 
 	iter = datapagemap_iterate(pagemap);
 	while (datapagemap_next(iter, &blkno))
 	{
-		offset = blkno * BLCKSZ;
-
-		fetch_file_range(path, offset, offset + BLCKSZ);
+		if (runstart != InvalidBlockNumber && blkno == runend + 1)
+		{
+			runend = blkno;
+			continue;
+		}
+		if (runstart != InvalidBlockNumber)
+			fetch_file_range(path, (uint64) runstart * BLCKSZ,
+							 (uint64) (runend + 1) * BLCKSZ);
+		runstart = runend = blkno;
 	}
+	if (runstart != InvalidBlockNumber)
+		fetch_file_range(path, (uint64) runstart * BLCKSZ,
+						 (uint64) (runend + 1) * BLCKSZ);
 	pg_free(iter);
 }
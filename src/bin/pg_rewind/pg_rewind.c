@@ -57,6 +57,7 @@ bool		debug = false;
 bool		showprogress = false;
 bool		dry_run = false;
 bool		do_sync = true;
+int			num_jobs = 1;
 
 /* Target history */
 TimeLineHistoryEntry *targetHistory;
@@ -71,6 +72,8 @@ usage(const char *progname)
 	printf(_("  -D, --target-pgdata=DIRECTORY  existing data directory to modify\n"));
 	printf(_("      --source-pgdata=DIRECTORY  source data directory to synchronize with\n"));
 	printf(_("      --source-server=CONNSTR    source server to synchronize with\n"));
+	printf(_("  -j, --jobs=NUM                 use this many connections to fetch files\n"
+			 "                                 from the source server\n"));
 	printf(_("  -n, --dry-run                  stop before modifying anything\n"));
 	printf(_("  -N, --no-sync                  do not wait for changes to be written\n"));
 	printf(_("                                 safely to disk\n"));
@@ -91,6 +94,7 @@ main(int argc, char **argv)
 		{"source-pgdata", required_argument, NULL, 1},
 		{"source-server", required_argument, NULL, 2},
 		{"version", no_argument, NULL, 'V'},
+		{"jobs", required_argument, NULL, 'j'},
 		{"dry-run", no_argument, NULL, 'n'},
 		{"no-sync", no_argument, NULL, 'N'},
 		{"progress", no_argument, NULL, 'P'},
@@ -129,7 +133,7 @@ main(int argc, char **argv)
 		}
 	}
 
-	while ((c = getopt_long(argc, argv, "D:nNP", long_options, &option_index)) != -1)
+	while ((c = getopt_long(argc, argv, "D:j:nNP", long_options, &option_index)) != -1)
 	{
 		switch (c)
 		{
@@ -141,6 +145,16 @@ main(int argc, char **argv)
 				showprogress = true;
 				break;
 
+			case 'j':
+				num_jobs = atoi(optarg);
+				if (num_jobs <= 0)
+				{
+					fprintf(stderr, _("%s: invalid number of jobs \"%s\"\n"),
+							progname, optarg);
+					exit(1);
+				}
+				break;
+
 			case 'n':
 				dry_run = true;
 				break;
@@ -180,6 +194,13 @@ main(int argc, char **argv)
 		exit(1);
 	}
 
+	if (num_jobs > 1 && connstr_source == NULL)
+	{
+		fprintf(stderr, _("%s: --jobs can only be used with --source-server\n"), progname);
+		fprintf(stderr, _("Try \"%s --help\" for more information.\n"), progname);
+		exit(1);
+	}
+
 	if (datadir_target == NULL)
 	{
 		fprintf(stderr, _("%s: no target data directory specified (--target-pgdata)\n"), progname);
@@ -1,7 +1,7 @@
 use strict;
 use warnings;
 use TestLib;
-use Test::More tests => 10;
+use Test::More tests => 15;
 
 use RewindTest;
 
@@ -100,8 +100,9 @@ in master, before promotion
 	return;
 }
 
-# Run the test in both modes
+# Run the test in all modes
 run_test('local');
 run_test('remote');
+run_test('remote_parallel');
 
 exit(0);
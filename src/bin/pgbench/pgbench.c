@@ -217,6 +217,7 @@ int			nclients = 1;		/* number of clients */
 int			nthreads = 1;		/* number of threads */
 bool		is_connect;			/* establish connection for each transaction */
 bool		report_per_command;	/* report per-command latencies */
+bool		latency_percentiles = false;	/* report latency percentiles */
 int			main_pid;			/* main process id used in log filename */
 
 char	   *pghost = "";
@@ -265,6 +266,30 @@ typedef struct SimpleStats
 	double		sum2;			/* sum of squared values */
 } SimpleStats;
 
+/*
+ * Latency histogram, used to report percentiles under --latency-percentiles.
+ *
+ * Values (in usec) are counted in log-linear buckets, in the manner of
+ * HdrHistogram: values below 2 * HIST_SUB_BUCKETS each get their own
+ * bucket, and above that every power of two is split into HIST_SUB_BUCKETS
+ * equal-width buckets.  Any value is therefore known to within
+ * 1 / HIST_SUB_BUCKETS (less than 1%) of its magnitude, in a fixed amount of
+ * space, and histograms can be merged and subtracted bucket by bucket.
+ * Values of HIST_MAX_BITS bits or more (about 12 days) share the last
+ * bucket.
+ */
+#define HIST_SUB_BITS		7
+#define HIST_SUB_BUCKETS	(1 << HIST_SUB_BITS)
+#define HIST_MAX_BITS		40
+#define HIST_NBUCKETS		((HIST_MAX_BITS - HIST_SUB_BITS + 1) * HIST_SUB_BUCKETS)
+
+typedef struct LatencyHistogram
+{
+	int64		count;			/* total number of values */
+	int64		max;			/* the maximum seen */
+	int64		buckets[HIST_NBUCKETS];
+} LatencyHistogram;
+
 /*
  * Data structure to hold various statistics: per-thread and per-script stats
  * are maintained and merged together.
@@ -464,6 +489,7 @@ typedef struct
 	instr_time	conn_time;
 	StatsData	stats;
 	int64		latency_late;	/* executed but late transactions */
+	LatencyHistogram *latency_hist; /* NULL unless latency_percentiles */
 } TState;
 
 #define INVALID_THREAD		((pthread_t) 0)
@@ -485,7 +511,9 @@ typedef enum MetaCommand
 	META_IF,					/* \if */
 	META_ELIF,					/* \elif */
 	META_ELSE,					/* \else */
-	META_ENDIF					/* \endif */
+	META_ENDIF,					/* \endif */
+	META_STARTPIPELINE,			/* \startpipeline */
+	META_ENDPIPELINE			/* \endpipeline */
 } MetaCommand;
 
 typedef enum QueryMode
@@ -509,6 +537,7 @@ typedef struct
 	char	   *argv[MAX_ARGS]; /* command word list */
 	PgBenchExpr *expr;			/* parsed expression, if needed */
 	SimpleStats stats;			/* time spent in this command */
+	LatencyHistogram *hist;		/* same, if latency_percentiles */
 } Command;
 
 typedef struct ParsedScript
@@ -517,6 +546,7 @@ typedef struct ParsedScript
 	int			weight;			/* selection weight */
 	Command   **commands;		/* NULL-terminated array of Commands */
 	StatsData	stats;			/* total time spent in script */
+	LatencyHistogram *hist;		/* same, if latency_percentiles */
 } ParsedScript;
 
 static ParsedScript sql_script[MAX_SCRIPTS];	/* SQL script files */
@@ -614,9 +644,11 @@ usage(void)
 		   "  %s [OPTION]... [DBNAME]\n"
 		   "\nInitialization options:\n"
 		   "  -i, --initialize         invokes initialization mode\n"
-		   "  -I, --init-steps=[dtgvpf]+ (default \"dtgvp\")\n"
+		   "  -I, --init-steps=[dtgGvpf]+ (default \"dtgvp\")\n"
 		   "                           run selected initialization steps\n"
 		   "  -F, --fillfactor=NUM     set fill factor\n"
+		   "  -j, --jobs=NUM           number of connections loading data and\n"
+		   "                           building indexes in parallel (default: 1)\n"
 		   "  -n, --no-vacuum          do not run VACUUM during initialization\n"
 		   "  -q, --quiet              quiet logging (one message each 5 seconds)\n"
 		   "  -s, --scale=NUM          scaling factor\n"
@@ -654,6 +686,7 @@ usage(void)
 		   "  --aggregate-interval=NUM aggregate data over NUM seconds\n"
 		   "  --log-prefix=PREFIX      prefix for transaction time log file\n"
 		   "                           (default: \"pgbench_log\")\n"
+		   "  --latency-percentiles    report latency percentiles\n"
 		   "  --progress-timestamp     use Unix epoch timestamps for progress\n"
 		   "  --random-seed=SEED       set random seed (\"time\", \"rand\", integer)\n"
 		   "  --sampling-rate=NUM      fraction of transactions to log (e.g., 0.01 for 1%%)\n"
@@ -1156,6 +1189,131 @@ mergeSimpleStats(SimpleStats *acc, SimpleStats *ss)
 	acc->sum2 += ss->sum2;
 }
 
+/*
+ * Allocate a zeroed LatencyHistogram
+ */
+static LatencyHistogram *
+allocHistogram(void)
+{
+	return (LatencyHistogram *) pg_malloc0(sizeof(LatencyHistogram));
+}
+
+/*
+ * Return the index of the histogram bucket holding the given value
+ */
+static int
+histogramBucket(int64 val)
+{
+	int			shift = 0;
+
+	if (val < 2 * HIST_SUB_BUCKETS)
+		return (int) Max(val, 0);
+
+	/* shift the value down until it fits in [HIST_SUB_BUCKETS, 2 * that) */
+	while ((val >> shift) >= 2 * HIST_SUB_BUCKETS)
+		shift++;
+	if (shift > HIST_MAX_BITS - HIST_SUB_BITS - 1)
+		return HIST_NBUCKETS - 1;
+
+	return shift * HIST_SUB_BUCKETS + (int) (val >> shift);
+}
+
+/*
+ * Return the highest value that falls into the given histogram bucket
+ */
+static int64
+histogramBucketValue(int bucket)
+{
+	int			shift;
+	int64		sub;
+
+	if (bucket < 2 * HIST_SUB_BUCKETS)
+		return bucket;
+
+	shift = bucket / HIST_SUB_BUCKETS - 1;
+	sub = bucket - shift * HIST_SUB_BUCKETS;
+
+	return ((sub + 1) << shift) - 1;
+}
+
+/*
+ * Accumulate one value, in usec, into a LatencyHistogram.
+ */
+static void
+addToHistogram(LatencyHistogram *hist, int64 val)
+{
+	hist->buckets[histogramBucket(val)]++;
+	hist->count++;
+	if (val > hist->max)
+		hist->max = val;
+}
+
+/*
+ * Merge two LatencyHistograms
+ */
+static void
+mergeHistogram(LatencyHistogram *acc, LatencyHistogram *hist)
+{
+	int			i;
+
+	for (i = 0; i < HIST_NBUCKETS; i++)
+		acc->buckets[i] += hist->buckets[i];
+	acc->count += hist->count;
+	if (hist->max > acc->max)
+		acc->max = hist->max;
+}
+
+/*
+ * Compute into 'result' the values added to 'cur' since it was 'last'.
+ *
+ * The maximum of those values is not known exactly; we take the upper bound
+ * of the highest nonempty bucket, or cur's maximum if that's lower.
+ */
+static void
+diffHistogram(LatencyHistogram *result, LatencyHistogram *cur,
+			  LatencyHistogram *last)
+{
+	int			i;
+
+	result->count = cur->count - last->count;
+	result->max = 0;
+	for (i = 0; i < HIST_NBUCKETS; i++)
+	{
+		result->buckets[i] = cur->buckets[i] - last->buckets[i];
+		if (result->buckets[i] > 0)
+			result->max = Min(histogramBucketValue(i), cur->max);
+	}
+}
+
+/*
+ * Return the given percentile of the values in a LatencyHistogram, in usec.
+ *
+ * The result is the upper bound of the bucket holding that value, except
+ * that it's never more than the largest value seen.
+ */
+static double
+histogramPercentile(LatencyHistogram *hist, double percentile)
+{
+	int64		rank;
+	int64		seen = 0;
+	int			i;
+
+	if (hist->count <= 0)
+		return 0.0;
+
+	rank = (int64) ceil(hist->count * percentile / 100.0);
+	rank = Max(rank, 1);
+
+	for (i = 0; i < HIST_NBUCKETS; i++)
+	{
+		seen += hist->buckets[i];
+		if (seen >= rank)
+			return (double) Min(histogramBucketValue(i), hist->max);
+	}
+
+	return (double) hist->max;
+}
+
 /*
  * Initialize a StatsData struct to mostly zeroes, with its start time set to
  * the given value.
@@ -2569,6 +2727,10 @@ getMetaCommand(const char *cmd)
 		mc = META_ELSE;
 	else if (pg_strcasecmp(cmd, "endif") == 0)
 		mc = META_ENDIF;
+	else if (pg_strcasecmp(cmd, "startpipeline") == 0)
+		mc = META_STARTPIPELINE;
+	else if (pg_strcasecmp(cmd, "endpipeline") == 0)
+		mc = META_ENDPIPELINE;
 	else
 		mc = META_NONE;
 	return mc;
@@ -2764,6 +2926,20 @@ sendCommand(CState *st, Command *command)
 				if (commands[j]->type != SQL_COMMAND)
 					continue;
 				preparedStatementName(name, st->use_file, j);
+
+				/*
+				 * Synchronous commands can't be used in pipeline mode, so
+				 * queue the Parse messages instead; their results are read
+				 * at \endpipeline along with the others.
+				 */
+				if (PQpipelineStatus(st->con) != PQ_PIPELINE_OFF)
+				{
+					if (!PQsendPrepare(st->con, name, commands[j]->argv[0],
+									   commands[j]->argc - 1, NULL))
+						fprintf(stderr, "%s", PQerrorMessage(st->con));
+					continue;
+				}
+
 				res = PQprepare(st->con, name,
 								commands[j]->argv[0], commands[j]->argc - 1, NULL);
 				if (PQresultStatus(res) != PGRES_COMMAND_OK)
@@ -2833,6 +3009,55 @@ evaluateSleep(CState *st, int argc, char **argv, int *usecs)
 	return true;
 }
 
+/*
+ * Read the results of the commands queued in a pipeline, up to and including
+ * the one for the sync point sent by \endpipeline, then leave pipeline mode.
+ *
+ * Returns false if we have to wait for more input from the server, true once
+ * st->state has been advanced to either CSTATE_END_COMMAND or CSTATE_ABORTED.
+ */
+static bool
+readPipelineResults(CState *st)
+{
+	PGresult   *res;
+
+	for (;;)
+	{
+		if (PQisBusy(st->con))
+			return false;		/* don't have the next result yet */
+
+		res = PQgetResult(st->con);
+		if (res == NULL)
+			continue;			/* end of one command's results */
+
+		switch (PQresultStatus(res))
+		{
+			case PGRES_COMMAND_OK:
+			case PGRES_TUPLES_OK:
+			case PGRES_EMPTY_QUERY:
+				/* OK */
+				PQclear(res);
+				break;
+			case PGRES_PIPELINE_SYNC:
+				PQclear(res);
+				if (!PQexitPipelineMode(st->con))
+				{
+					commandFailed(st, "endpipeline", PQerrorMessage(st->con));
+					st->state = CSTATE_ABORTED;
+				}
+				else
+					st->state = CSTATE_END_COMMAND;
+				return true;
+			default:
+				/* an error, or a command skipped because of an earlier one */
+				commandFailed(st, "SQL", PQerrorMessage(st->con));
+				PQclear(res);
+				st->state = CSTATE_ABORTED;
+				return true;
+		}
+	}
+}
+
 /*
  * Advance the state machine of a connection.
  */
@@ -3006,6 +3231,13 @@ advanceConnectionState(TState *thread, CState *st, StatsData *agg)
 				/* Transition to script end processing if done */
 				if (sql_script[st->use_file].commands[st->command] == NULL)
 				{
+					if (PQpipelineStatus(st->con) != PQ_PIPELINE_OFF)
+					{
+						commandFailed(st, "end of script",
+									  "pipeline still open at end of script");
+						st->state = CSTATE_ABORTED;
+						break;
+					}
 					st->state = CSTATE_END_TX;
 					break;
 				}
@@ -3138,6 +3370,14 @@ advanceConnectionState(TState *thread, CState *st, StatsData *agg)
 					st->state = CSTATE_ABORTED;
 					break;
 				}
+				if (PQpipelineStatus(st->con) != PQ_PIPELINE_OFF)
+				{
+					/* \endpipeline: read everything up to the sync point */
+					if (!readPipelineResults(st))
+						return;		/* don't have all the results yet */
+					break;
+				}
+
 				if (PQisBusy(st->con))
 					return;		/* don't have the whole result yet */
 
@@ -3196,6 +3436,10 @@ advanceConnectionState(TState *thread, CState *st, StatsData *agg)
 					addToSimpleStats(&command->stats,
 									 INSTR_TIME_GET_DOUBLE(now) -
 									 INSTR_TIME_GET_DOUBLE(st->stmt_begin));
+					if (command->hist)
+						addToHistogram(command->hist,
+									   INSTR_TIME_GET_MICROSEC(now) -
+									   INSTR_TIME_GET_MICROSEC(st->stmt_begin));
 				}
 
 				/* Go ahead with next command, to be executed or skipped */
@@ -3271,6 +3515,14 @@ doExecuteCommand(TState *thread, CState *st, instr_time now)
 			commandFailed(st, "SQL", "SQL command send failed");
 			st->state = CSTATE_ABORTED;
 		}
+		else if (PQpipelineStatus(st->con) != PQ_PIPELINE_OFF)
+		{
+			/*
+			 * In a pipeline, go on with the next command right away; the
+			 * result will be read at \endpipeline.
+			 */
+			st->state = CSTATE_END_COMMAND;
+		}
 		else
 			st->state = CSTATE_WAIT_RESULT;
 	}
@@ -3415,6 +3667,44 @@ doExecuteCommand(TState *thread, CState *st, instr_time now)
 				return now;
 			}
 		}
+		else if (command->meta == META_STARTPIPELINE)
+		{
+			if (PQpipelineStatus(st->con) != PQ_PIPELINE_OFF)
+			{
+				commandFailed(st, "startpipeline", "already in pipeline mode");
+				st->state = CSTATE_ABORTED;
+				return now;
+			}
+			if (!PQenterPipelineMode(st->con))
+			{
+				commandFailed(st, "startpipeline", PQerrorMessage(st->con));
+				st->state = CSTATE_ABORTED;
+				return now;
+			}
+		}
+		else if (command->meta == META_ENDPIPELINE)
+		{
+			if (PQpipelineStatus(st->con) == PQ_PIPELINE_OFF)
+			{
+				commandFailed(st, "endpipeline", "not in pipeline mode");
+				st->state = CSTATE_ABORTED;
+				return now;
+			}
+			if (!PQpipelineSync(st->con))
+			{
+				commandFailed(st, "endpipeline", PQerrorMessage(st->con));
+				st->state = CSTATE_ABORTED;
+				return now;
+			}
+
+			/*
+			 * Now wait for the results of all the queued commands.  The
+			 * per-command latency recorded for \endpipeline is thus the time
+			 * the whole pipeline took to be processed.
+			 */
+			st->state = CSTATE_WAIT_RESULT;
+			return now;
+		}
 
 		/*
 		 * executing the expression or shell command might have taken a
@@ -3523,7 +3813,8 @@ processXactStats(TState *thread, CState *st, instr_time *now,
 {
 	double		latency = 0.0,
 				lag = 0.0;
-	bool		thread_details = progress || throttle_delay || latency_limit,
+	bool		thread_details = progress || throttle_delay || latency_limit ||
+	latency_percentiles,
 				detailed = thread_details || use_log || per_script_stats;
 
 	if (detailed && !skipped)
@@ -3543,6 +3834,9 @@ processXactStats(TState *thread, CState *st, instr_time *now,
 		/* count transactions over the latency limit, if needed */
 		if (latency_limit && latency > latency_limit)
 			thread->latency_late++;
+
+		if (thread->latency_hist && !skipped)
+			addToHistogram(thread->latency_hist, (int64) latency);
 	}
 	else
 	{
@@ -3558,7 +3852,11 @@ processXactStats(TState *thread, CState *st, instr_time *now,
 
 	/* XXX could use a mutex here, but we choose not to */
 	if (per_script_stats)
+	{
 		accumStats(&sql_script[st->use_file].stats, skipped, latency, lag);
+		if (sql_script[st->use_file].hist && !skipped)
+			addToHistogram(sql_script[st->use_file].hist, (int64) latency);
+	}
 }
 
 
@@ -3689,30 +3987,51 @@ initCreateTables(PGconn *con)
 }
 
 /*
- * Fill the standard tables with some data
+ * Wait for the completion of a statement sent with PQsendQuery(), and exit
+ * if it failed
  */
 static void
-initGenerateData(PGconn *con)
+waitParallelStatement(PGconn *con)
 {
-	char		sql[256];
 	PGresult   *res;
-	int			i;
-	int64		k;
 
-	/* used to track elapsed time and estimate of the remaining time */
-	instr_time	start,
-				diff;
-	double		elapsed_sec,
-				remaining_sec;
-	int			log_interval = 1;
+	while ((res = PQgetResult(con)) != NULL)
+	{
+		if (PQresultStatus(res) != PGRES_COMMAND_OK)
+		{
+			fprintf(stderr, "%s", PQerrorMessage(con));
+			exit(1);
+		}
+		PQclear(res);
+	}
+}
 
-	fprintf(stderr, "generating data...\n");
+/*
+ * State of one of the connections loading pgbench_accounts in parallel
+ */
+typedef struct InitWorker
+{
+	int			id;				/* worker number, 0 .. ninit_workers - 1 */
+	pthread_t	thread;			/* thread handle */
+	PGconn	   *con;			/* connection used by this worker */
+	int64		first;			/* first account id to load, minus one */
+	int64		last;			/* last account id to load */
+	volatile int64 loaded;		/* rows loaded so far, for progress reports */
+} InitWorker;
 
-	/*
-	 * we do all of this in one transaction to enable the backend's
-	 * data-loading optimizations
-	 */
-	executeStatement(con, "begin");
+static InitWorker *init_workers = NULL;
+static int	ninit_workers = 0;
+
+/*
+ * Empty the standard tables, and fill pgbench_branches and pgbench_tellers.
+ *
+ * The caller has started a transaction, if it wants one.
+ */
+static void
+initFillSmallTables(PGconn *con, bool server_side)
+{
+	char		sql[256];
+	int			i;
 
 	/*
 	 * truncate away any old data, in one command in case there are foreign
@@ -3728,6 +4047,24 @@ initGenerateData(PGconn *con)
 	 * fill branches, tellers, accounts in that order in case foreign keys
 	 * already exist
 	 */
+	if (server_side)
+	{
+		/* "filler" column defaults to NULL */
+		snprintf(sql, sizeof(sql),
+				 "insert into pgbench_branches(bid,bbalance) "
+				 "select bid, 0 from generate_series(1, %d) as bid",
+				 nbranches * scale);
+		executeStatement(con, sql);
+
+		snprintf(sql, sizeof(sql),
+				 "insert into pgbench_tellers(tid,bid,tbalance) "
+				 "select tid, (tid - 1) / %d + 1, 0 "
+				 "from generate_series(1, %d) as tid",
+				 ntellers, ntellers * scale);
+		executeStatement(con, sql);
+		return;
+	}
+
 	for (i = 0; i < nbranches * scale; i++)
 	{
 		/* "filler" column defaults to NULL */
@@ -3745,10 +4082,66 @@ initGenerateData(PGconn *con)
 				 i + 1, i / ntellers + 1);
 		executeStatement(con, sql);
 	}
+}
+
+/*
+ * Divide the accounts among ninit_workers workers, each with its own
+ * connection.
+ */
+static void
+initSetupWorkers(void)
+{
+	int64		total = (int64) naccounts * scale;
+	int			i;
+
+	ninit_workers = nthreads;
+	init_workers = (InitWorker *) pg_malloc0(sizeof(InitWorker) * ninit_workers);
+
+	for (i = 0; i < ninit_workers; i++)
+	{
+		InitWorker *worker = &init_workers[i];
+
+		worker->id = i;
+		worker->first = total * i / ninit_workers;
+		worker->last = total * (i + 1) / ninit_workers;
+		if ((worker->con = doConnect()) == NULL)
+			exit(1);
+	}
+}
+
+static void
+initFinishWorkers(void)
+{
+	int			i;
+
+	for (i = 0; i < ninit_workers; i++)
+		PQfinish(init_workers[i].con);
+	pg_free(init_workers);
+	init_workers = NULL;
+	ninit_workers = 0;
+}
+
+/*
+ * Load accounts first + 1 .. last into pgbench_accounts with COPY.
+ *
+ * If we're one of several parallel workers, progress is reported by worker 0
+ * only, for all of them together.
+ */
+static void
+initCopyAccounts(PGconn *con, int64 first, int64 last, InitWorker *worker)
+{
+	char		sql[256];
+	PGresult   *res;
+	int64		total = (int64) naccounts * scale;
+	int64		k;
+
+	/* used to track elapsed time and estimate of the remaining time */
+	instr_time	start,
+				diff;
+	double		elapsed_sec,
+				remaining_sec;
+	int			log_interval = 1;
 
-	/*
-	 * accounts is big enough to be worth using COPY and tracking runtime
-	 */
 	res = PQexec(con, "copy pgbench_accounts from stdin");
 	if (PQresultStatus(res) != PGRES_COPY_IN)
 	{
@@ -3759,9 +4152,11 @@ initGenerateData(PGconn *con)
 
 	INSTR_TIME_SET_CURRENT(start);
 
-	for (k = 0; k < (int64) naccounts * scale; k++)
+	for (k = first; k < last; k++)
 	{
 		int64		j = k + 1;
+		int64		n = j - first;	/* rows loaded by this connection */
+		int64		done = j;	/* rows loaded by all connections */
 
 		/* "filler" column defaults to blank padded empty string */
 		snprintf(sql, sizeof(sql),
@@ -3773,38 +4168,52 @@ initGenerateData(PGconn *con)
 			exit(1);
 		}
 
+		if (worker != NULL)
+		{
+			int			i;
+
+			/* XXX no locking; the counts are only used for reporting */
+			worker->loaded = n;
+			if (worker->id != 0 || n % 100 != 0)
+				continue;
+
+			done = 0;
+			for (i = 0; i < ninit_workers; i++)
+				done += init_workers[i].loaded;
+		}
+
 		/*
 		 * If we want to stick with the original logging, print a message each
 		 * 100k inserted rows.
 		 */
-		if ((!use_quiet) && (j % 100000 == 0))
+		if ((!use_quiet) && (n % 100000 == 0))
 		{
 			INSTR_TIME_SET_CURRENT(diff);
 			INSTR_TIME_SUBTRACT(diff, start);
 
 			elapsed_sec = INSTR_TIME_GET_DOUBLE(diff);
-			remaining_sec = ((double) scale * naccounts - j) * elapsed_sec / j;
+			remaining_sec = (double) (total - done) * elapsed_sec / done;
 
 			fprintf(stderr, INT64_FORMAT " of " INT64_FORMAT " tuples (%d%%) done (elapsed %.2f s, remaining %.2f s)\n",
-					j, (int64) naccounts * scale,
-					(int) (((int64) j * 100) / (naccounts * (int64) scale)),
+					done, total,
+					(int) ((done * 100) / total),
 					elapsed_sec, remaining_sec);
 		}
 		/* let's not call the timing for each row, but only each 100 rows */
-		else if (use_quiet && (j % 100 == 0))
+		else if (use_quiet && (n % 100 == 0))
 		{
 			INSTR_TIME_SET_CURRENT(diff);
 			INSTR_TIME_SUBTRACT(diff, start);
 
 			elapsed_sec = INSTR_TIME_GET_DOUBLE(diff);
-			remaining_sec = ((double) scale * naccounts - j) * elapsed_sec / j;
+			remaining_sec = (double) (total - done) * elapsed_sec / done;
 
 			/* have we reached the next interval (or end)? */
-			if ((j == scale * naccounts) || (elapsed_sec >= log_interval * LOG_STEP_SECONDS))
+			if ((done == total) || (elapsed_sec >= log_interval * LOG_STEP_SECONDS))
 			{
 				fprintf(stderr, INT64_FORMAT " of " INT64_FORMAT " tuples (%d%%) done (elapsed %.2f s, remaining %.2f s)\n",
-						j, (int64) naccounts * scale,
-						(int) (((int64) j * 100) / (naccounts * (int64) scale)), elapsed_sec, remaining_sec);
+						done, total,
+						(int) ((done * 100) / total), elapsed_sec, remaining_sec);
 
 				/* skip to the next interval */
 				log_interval = (int) ceil(elapsed_sec / LOG_STEP_SECONDS);
@@ -3822,8 +4231,143 @@ initGenerateData(PGconn *con)
 		fprintf(stderr, "PQendcopy failed\n");
 		exit(1);
 	}
+}
+
+/* thread main routine of a parallel client-side data generation worker */
+static void *
+initWorkerRun(void *arg)
+{
+	InitWorker *worker = (InitWorker *) arg;
+
+	initCopyAccounts(worker->con, worker->first, worker->last, worker);
+
+	return NULL;
+}
+
+/*
+ * Fill the standard tables with some data generated on the client side
+ *
+ * With -j, pgbench_accounts is loaded by that many threads, each streaming
+ * its own range of accounts through its own COPY.
+ */
+static void
+initGenerateDataClientSide(PGconn *con)
+{
+	int			i;
+
+	fprintf(stderr, "generating data (client-side)...\n");
+
+	/*
+	 * we do all of this in one transaction to enable the backend's
+	 * data-loading optimizations
+	 */
+	executeStatement(con, "begin");
+
+	initFillSmallTables(con, false);
+
+	/*
+	 * accounts is big enough to be worth using COPY and tracking runtime
+	 */
+	if (nthreads == 1)
+	{
+		initCopyAccounts(con, 0, (int64) naccounts * scale, NULL);
+		executeStatement(con, "commit");
+		return;
+	}
+
+	/*
+	 * In parallel mode, the other connections must see the truncation, so
+	 * each COPY is its own transaction.
+	 */
+	executeStatement(con, "commit");
+
+	initSetupWorkers();
+
+#ifdef ENABLE_THREAD_SAFETY
+	for (i = 1; i < ninit_workers; i++)
+	{
+		int			err = pthread_create(&init_workers[i].thread, NULL,
+										 initWorkerRun, &init_workers[i]);
+
+		if (err != 0)
+		{
+			fprintf(stderr, "could not create thread: %s\n", strerror(err));
+			exit(1);
+		}
+	}
+
+	/* worker 0 runs in the main thread */
+	(void) initWorkerRun(&init_workers[0]);
+
+	for (i = 1; i < ninit_workers; i++)
+		pthread_join(init_workers[i].thread, NULL);
+#else
+	for (i = 0; i < ninit_workers; i++)
+		(void) initWorkerRun(&init_workers[i]);
+#endif							/* ENABLE_THREAD_SAFETY */
+
+	initFinishWorkers();
+}
+
+/*
+ * Fill the standard tables with some data generated on the server side
+ *
+ * The data is produced by generate_series(), so only the statements travel
+ * over the network.  With -j, pgbench_accounts is filled by that many
+ * concurrent INSERT ... SELECT statements, each over a range of accounts.
+ */
+static void
+initGenerateDataServerSide(PGconn *con)
+{
+	char		sql[256];
+	int			i;
+
+	fprintf(stderr, "generating data (server-side)...\n");
+
+	/*
+	 * we do all of this in one transaction to enable the backend's
+	 * data-loading optimizations
+	 */
+	executeStatement(con, "begin");
+
+	initFillSmallTables(con, true);
+
+	if (nthreads == 1)
+	{
+		snprintf(sql, sizeof(sql),
+				 "insert into pgbench_accounts(aid,bid,abalance,filler) "
+				 "select aid, (aid - 1) / %d + 1, 0, '' "
+				 "from generate_series(1, " INT64_FORMAT ") as aid",
+				 naccounts, (int64) naccounts * scale);
+		executeStatement(con, sql);
+		executeStatement(con, "commit");
+		return;
+	}
 
 	executeStatement(con, "commit");
+
+	initSetupWorkers();
+
+	for (i = 0; i < ninit_workers; i++)
+	{
+		InitWorker *worker = &init_workers[i];
+
+		snprintf(sql, sizeof(sql),
+				 "insert into pgbench_accounts(aid,bid,abalance,filler) "
+				 "select aid, (aid - 1) / %d + 1, 0, '' "
+				 "from generate_series(" INT64_FORMAT ", " INT64_FORMAT ") as aid",
+				 naccounts, worker->first + 1, worker->last);
+		if (!PQsendQuery(worker->con, sql))
+		{
+			fprintf(stderr, "%s", PQerrorMessage(worker->con));
+			exit(1);
+		}
+	}
+
+	for (i = 0; i < ninit_workers; i++)
+		waitParallelStatement(init_workers[i].con);
+
+	initFinishWorkers();
 }
 
 /*
@@ -3841,6 +4385,8 @@ initVacuum(PGconn *con)
 
 /*
  * Create primary keys on the standard tables
+ *
+ * With -j, the indexes are built concurrently, each over its own connection.
  */
 static void
 initCreatePKeys(PGconn *con)
@@ -3850,12 +4396,24 @@ initCreatePKeys(PGconn *con)
 		"alter table pgbench_tellers add primary key (tid)",
 		"alter table pgbench_accounts add primary key (aid)"
 	};
+	PGconn	   *cons[lengthof(DDLINDEXes)];
+	int			ncons = Min(nthreads, lengthof(DDLINDEXes));
 	int			i;
 
 	fprintf(stderr, "creating primary keys...\n");
+
+	for (i = 0; i < ncons; i++)
+	{
+		if (i == 0)
+			cons[i] = con;
+		else if ((cons[i] = doConnect()) == NULL)
+			exit(1);
+	}
+
 	for (i = 0; i < lengthof(DDLINDEXes); i++)
 	{
 		char		buffer[256];
+		PGconn	   *icon = cons[i % ncons];
 
 		strlcpy(buffer, DDLINDEXes[i], sizeof(buffer));
 
@@ -3870,7 +4428,29 @@ initCreatePKeys(PGconn *con)
 			PQfreemem(escape_tablespace);
 		}
 
-		executeStatement(con, buffer);
+		if (ncons == 1)
+			executeStatement(con, buffer);
+		else
+		{
+			/* wait for the connection's previous index, if any */
+			if (i >= ncons)
+				waitParallelStatement(icon);
+			if (!PQsendQuery(icon, buffer))
+			{
+				fprintf(stderr, "%s", PQerrorMessage(icon));
+				exit(1);
+			}
+		}
+	}
+
+	if (ncons > 1)
+	{
+		for (i = 0; i < ncons; i++)
+		{
+			waitParallelStatement(cons[i]);
+			if (i > 0)
+				PQfinish(cons[i]);
+		}
 	}
 }
 
@@ -3916,11 +4496,11 @@ checkInitSteps(const char *initialize_steps)
 
 	for (step = initialize_steps; *step != '\0'; step++)
 	{
-		if (strchr("dtgvpf ", *step) == NULL)
+		if (strchr("dtgGvpf ", *step) == NULL)
 		{
 			fprintf(stderr, "unrecognized initialization step \"%c\"\n",
 					*step);
-			fprintf(stderr, "allowed steps are: \"d\", \"t\", \"g\", \"v\", \"p\", \"f\"\n");
+			fprintf(stderr, "allowed steps are: \"d\", \"t\", \"g\", \"G\", \"v\", \"p\", \"f\"\n");
 			exit(1);
 		}
 	}
@@ -3949,7 +4529,10 @@ runInitSteps(const char *initialize_steps)
 				initCreateTables(con);
 				break;
 			case 'g':
-				initGenerateData(con);
+				initGenerateDataClientSide(con);
+				break;
+			case 'G':
+				initGenerateDataServerSide(con);
 				break;
 			case 'v':
 				initVacuum(con);
@@ -4305,7 +4888,9 @@ process_backslash_command(PsqlScanState sstate, const char *source)
 			syntax_error(source, lineno, my_command->line, my_command->argv[0],
 						 "missing command", NULL, -1);
 	}
-	else if (my_command->meta == META_ELSE || my_command->meta == META_ENDIF)
+	else if (my_command->meta == META_ELSE || my_command->meta == META_ENDIF ||
+			 my_command->meta == META_STARTPIPELINE ||
+			 my_command->meta == META_ENDPIPELINE)
 	{
 		if (my_command->argc != 1)
 			syntax_error(source, lineno, my_command->line, my_command->argv[0],
@@ -4402,6 +4987,7 @@ ParseScript(const char *script, const char *desc, int weight)
 	ps.weight = weight;
 	ps.commands = (Command **) pg_malloc(sizeof(Command *) * alloc_num);
 	initStats(&ps.stats, 0);
+	ps.hist = NULL;
 
 	/* Prepare to parse script */
 	sstate = psql_scan_create(&pgbench_callbacks);
@@ -4685,10 +5271,24 @@ printSimpleStats(const char *prefix, SimpleStats *ss)
 	}
 }
 
+static void
+printHistogramPercentiles(const char *prefix, LatencyHistogram *hist)
+{
+	if (hist && hist->count > 0)
+		printf("%s percentiles: p50 = %.3f ms, p90 = %.3f ms, p99 = %.3f ms, p99.9 = %.3f ms, max = %.3f ms\n",
+			   prefix,
+			   0.001 * histogramPercentile(hist, 50.0),
+			   0.001 * histogramPercentile(hist, 90.0),
+			   0.001 * histogramPercentile(hist, 99.0),
+			   0.001 * histogramPercentile(hist, 99.9),
+			   0.001 * hist->max);
+}
+
 /* print out results */
 static void
-printResults(TState *threads, StatsData *total, instr_time total_time,
-			 instr_time conn_total_time, int64 latency_late)
+printResults(TState *threads, StatsData *total, LatencyHistogram *total_hist,
+			 instr_time total_time, instr_time conn_total_time,
+			 int64 latency_late)
 {
 	double		time_include,
 				tps_include,
@@ -4747,8 +5347,11 @@ printResults(TState *threads, StatsData *total, instr_time total_time,
 			   latency_limit / 1000.0, latency_late, ntx,
 			   (ntx > 0) ? 100.0 * latency_late / ntx : 0.0);
 
-	if (throttle_delay || progress || latency_limit)
+	if (throttle_delay || progress || latency_limit || latency_percentiles)
+	{
 		printSimpleStats("latency", &total->latency);
+		printHistogramPercentiles("latency", total_hist);
+	}
 	else
 	{
 		/* no measurement, show average latency computed from run time */
@@ -4798,6 +5401,7 @@ printResults(TState *threads, StatsData *total, instr_time total_time,
 						   100.0 * sstats->skipped / sstats->cnt);
 
 				printSimpleStats(" - latency", &sstats->latency);
+				printHistogramPercentiles(" - latency", sql_script[i].hist);
 			}
 
 			/* Report per-command latencies */
@@ -4805,21 +5409,26 @@ printResults(TState *threads, StatsData *total, instr_time total_time,
 			{
 				Command   **commands;
 
-				if (per_script_stats)
-					printf(" - statement latencies in milliseconds:\n");
-				else
-					printf("statement latencies in milliseconds:\n");
+				printf("%sstatement latencies in milliseconds%s:\n",
+					   per_script_stats ? " - " : "",
+					   latency_percentiles ? " (average, p50, p99, max)" : "");
 
 				for (commands = sql_script[i].commands;
 					 *commands != NULL;
 					 commands++)
 				{
 					SimpleStats *cstats = &(*commands)->stats;
+					LatencyHistogram *chist = (*commands)->hist;
 
-					printf("   %11.3f  %s\n",
+					printf("   %11.3f",
 						   (cstats->count > 0) ?
-						   1000.0 * cstats->sum / cstats->count : 0.0,
-						   (*commands)->line);
+						   1000.0 * cstats->sum / cstats->count : 0.0);
+					if (chist)
+						printf(" %11.3f %11.3f %11.3f",
+							   0.001 * histogramPercentile(chist, 50.0),
+							   0.001 * histogramPercentile(chist, 99.0),
+							   0.001 * chist->max);
+					printf("  %s\n", (*commands)->line);
 				}
 			}
 		}
@@ -4914,6 +5523,7 @@ main(int argc, char **argv)
 		{"log-prefix", required_argument, NULL, 7},
 		{"foreign-keys", no_argument, NULL, 8},
 		{"random-seed", required_argument, NULL, 9},
+		{"latency-percentiles", no_argument, NULL, 10},
 		{NULL, 0, NULL, 0}
 	};
 
@@ -4938,6 +5548,7 @@ main(int argc, char **argv)
 	instr_time	conn_total_time;
 	int64		latency_late = 0;
 	StatsData	stats;
+	LatencyHistogram *total_hist = NULL;
 	int			weight;
 
 	int			i;
@@ -5051,8 +5662,7 @@ main(int argc, char **argv)
 				}
 #endif							/* HAVE_GETRLIMIT */
 				break;
-			case 'j':			/* jobs */
-				benchmarking_option_set = true;
+			case 'j':			/* jobs, also used by -i */
 				nthreads = atoi(optarg);
 				if (nthreads <= 0)
 				{
@@ -5271,6 +5881,10 @@ main(int argc, char **argv)
 					exit(1);
 				}
 				break;
+			case 10:			/* latency-percentiles */
+				benchmarking_option_set = true;
+				latency_percentiles = true;
+				break;
 			default:
 				fprintf(stderr, _("Try \"%s --help\" for more information.\n"), progname);
 				exit(1);
@@ -5319,12 +5933,28 @@ main(int argc, char **argv)
 	if (num_scripts > 1)
 		per_script_stats = true;
 
+	/* set up histograms for the stats that will be collected */
+	if (latency_percentiles)
+	{
+		for (i = 0; i < num_scripts; i++)
+		{
+			Command   **commands;
+
+			if (per_script_stats)
+				sql_script[i].hist = allocHistogram();
+			if (!report_per_command)
+				continue;
+			for (commands = sql_script[i].commands; *commands != NULL; commands++)
+				(*commands)->hist = allocHistogram();
+		}
+	}
+
 	/*
 	 * Don't need more threads than there are clients.  (This is not merely an
 	 * optimization; throttle_delay is calculated incorrectly below if some
 	 * threads have no clients assigned to them.)
 	 */
-	if (nthreads > nclients)
+	if (nthreads > nclients && !is_init_mode)
 		nthreads = nclients;
 
 	/*
@@ -5628,6 +6258,7 @@ main(int argc, char **argv)
 		thread->zipf_cache.current = 0;
 		thread->zipf_cache.overflowCount = 0;
 		initStats(&thread->stats, 0);
+		thread->latency_hist = latency_percentiles ? allocHistogram() : NULL;
 
 		nclients_dealt += thread->nstate;
 	}
@@ -5682,6 +6313,8 @@ main(int argc, char **argv)
 
 	/* wait for threads and accumulate results */
 	initStats(&stats, 0);
+	if (latency_percentiles)
+		total_hist = allocHistogram();
 	INSTR_TIME_SET_ZERO(conn_total_time);
 	for (i = 0; i < nthreads; i++)
 	{
@@ -5707,6 +6340,8 @@ main(int argc, char **argv)
 		mergeSimpleStats(&stats.lag, &thread->stats.lag);
 		stats.cnt += thread->stats.cnt;
 		stats.skipped += thread->stats.skipped;
+		if (total_hist)
+			mergeHistogram(total_hist, thread->latency_hist);
 		latency_late += thread->latency_late;
 		INSTR_TIME_ADD(conn_total_time, thread->conn_time);
 	}
@@ -5724,7 +6359,8 @@ main(int argc, char **argv)
 	 */
 	INSTR_TIME_SET_CURRENT(total_time);
 	INSTR_TIME_SUBTRACT(total_time, start_time);
-	printResults(threads, &stats, total_time, conn_total_time, latency_late);
+	printResults(threads, &stats, total_hist, total_time, conn_total_time,
+				 latency_late);
 
 	if (exit_code != 0)
 		fprintf(stderr, "Run was aborted; the above results are incomplete.\n");
@@ -5750,6 +6386,9 @@ threadRun(void *arg)
 	int64		next_report = last_report + (int64) progress * 1000000;
 	StatsData	last,
 				aggs;
+	LatencyHistogram *cur_hist = NULL,
+			   *last_hist = NULL,
+			   *interval_hist = NULL;
 
 	/*
 	 * Initialize throttling rate target for all of the thread's clients.  It
@@ -5765,6 +6404,14 @@ threadRun(void *arg)
 	initStats(&aggs, time(NULL));
 	last = aggs;
 
+	/* thread 0 sums up the histograms of all threads for progress reports */
+	if (progress && thread->tid == 0 && latency_percentiles)
+	{
+		cur_hist = allocHistogram();
+		last_hist = allocHistogram();
+		interval_hist = allocHistogram();
+	}
+
 	/* open log file if requested */
 	if (use_log)
 	{
@@ -6015,6 +6662,14 @@ threadRun(void *arg)
 					cur.skipped += thread[i].stats.skipped;
 				}
 
+				if (cur_hist)
+				{
+					memset(cur_hist, 0, sizeof(LatencyHistogram));
+					for (i = 0; i < nthreads; i++)
+						mergeHistogram(cur_hist, thread[i].latency_hist);
+					diffHistogram(interval_hist, cur_hist, last_hist);
+				}
+
 				/* we count only actually executed transactions */
 				ntx = (cur.cnt - cur.skipped) - (last.cnt - last.skipped);
 				total_run = (now - thread_start) / 1000000.0;
@@ -6055,6 +6710,12 @@ threadRun(void *arg)
 						"progress: %s, %.1f tps, lat %.3f ms stddev %.3f",
 						tbuf, tps, latency, stdev);
 
+				if (interval_hist)
+					fprintf(stderr, ", p50 %.3f p99 %.3f p99.9 %.3f ms",
+							0.001 * histogramPercentile(interval_hist, 50.0),
+							0.001 * histogramPercentile(interval_hist, 99.0),
+							0.001 * histogramPercentile(interval_hist, 99.9));
+
 				if (throttle_delay)
 				{
 					fprintf(stderr, ", lag %.3f ms", lag);
@@ -6066,6 +6727,13 @@ threadRun(void *arg)
 
 				last = cur;
 				last_report = now;
+				if (cur_hist)
+				{
+					LatencyHistogram *tmp = last_hist;
+
+					last_hist = cur_hist;
+					cur_hist = tmp;
+				}
 
 				/*
 				 * Ensure that the next report is in the future, in case
@@ -6095,6 +6763,12 @@ done:
 		thread->logfile = NULL;
 	}
 	free_socket_set(sockets);
+	if (cur_hist)
+	{
+		pg_free(cur_hist);
+		pg_free(last_hist);
+		pg_free(interval_hist);
+	}
 	return NULL;
 }
 
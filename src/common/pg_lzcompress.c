@@ -676,11 +676,17 @@ pglz_compress(const char *source, int32 slen, char *dest,
  *		Decompresses source into dest. Returns the number of bytes
  *		decompressed in the destination buffer, or -1 if decompression
  *		fails.
+ *
+ *		If check_complete is true, the data is considered corrupted
+ *		unless we consumed all of the source and filled all of dest.  If
+ *		it is false, we stop as soon as dest is full, and the source may
+ *		be just a prefix of the compressed data; that is how a leading
+ *		slice of a value is decompressed without inflating all of it.
  * ----------
  */
 int32
 pglz_decompress(const char *source, int32 slen, char *dest,
-				int32 rawsize)
+				int32 rawsize, bool check_complete)
 {
 	const unsigned char *sp;
 	const unsigned char *srcend;
@@ -701,7 +707,7 @@ pglz_decompress(const char *source, int32 slen, char *dest,
 		unsigned char ctrl = *sp++;
 		int			ctrlc;
 
-		for (ctrlc = 0; ctrlc < 8 && sp < srcend; ctrlc++)
+		for (ctrlc = 0; ctrlc < 8 && sp < srcend && dp < destend; ctrlc++)
 		{
 			if (ctrl & 1)
 			{
@@ -715,25 +721,44 @@ pglz_decompress(const char *source, int32 slen, char *dest,
 				int32		len;
 				int32		off;
 
+				/*
+				 * A tag cut short by the end of a truncated source can't be
+				 * decoded; report corruption rather than read past it.
+				 */
+				if (sp + 2 > srcend)
+					return -1;
 				len = (sp[0] & 0x0f) + 3;
 				off = ((sp[0] & 0xf0) << 4) | sp[1];
 				sp += 2;
 				if (len == 18)
+				{
+					if (sp >= srcend)
+						return -1;
 					len += *sp++;
+				}
 
 				/*
 				 * Check for output buffer overrun, to ensure we don't clobber
-				 * memory in case of corrupt input.  Note: we must advance dp
-				 * here to ensure the error is detected below the loop.  We
-				 * don't simply put the elog inside the loop since that will
-				 * probably interfere with optimization.
+				 * memory in case of corrupt input.  When a complete result
+				 * is required, we must advance dp here to ensure the error
+				 * is detected below the loop.  We don't simply put the elog
+				 * inside the loop since that will probably interfere with
+				 * optimization.  Otherwise, just copy what still fits.
 				 */
 				if (dp + len > destend)
 				{
-					dp += len;
-					break;
+					if (check_complete)
+					{
+						dp += len;
+						break;
+					}
+					len = destend - dp;
 				}
 
+				/* An offset pointing before the start of output is corrupt */
+				if (off == 0 || off > dp - (unsigned char *) dest)
+					return -1;
+
 				/*
 				 * Now we copy the bytes specified by the tag from OUTPUT to
 				 * OUTPUT. It is dangerous and platform dependent to use
@@ -766,13 +791,44 @@ pglz_decompress(const char *source, int32 slen, char *dest,
 	}
 
 	/*
-	 * Check we decompressed the right amount.
+	 * Check we decompressed the right amount.  If we are slicing, then we
+	 * won't necessarily be at the end of the source or dest buffers when we
+	 * hit a stop, so we don't test them.
 	 */
-	if (dp != destend || sp != srcend)
+	if (check_complete && (dp != destend || sp != srcend))
 		return -1;
 
 	/*
 	 * That's it.
 	 */
-	return rawsize;
+	return (char *) dp - dest;
+}
+
+/* ----------
+ * pglz_maximum_compressed_size -
+ *
+ *		Calculate the maximum compressed size for a given amount of raw data.
+ *		Return the maximum size, or total compressed size if maximum size is
+ *		larger than total compressed size.
+ *
+ *		This is used to fetch only as much of an out-of-line compressed value
+ *		as is needed to decompress its first rawsize bytes.
+ * ----------
+ */
+int32
+pglz_maximum_compressed_size(int32 rawsize, int32 total_compressed_size)
+{
+	int64		compressed_size;
+
+	/*
+	 * pglz uses one control bit per item, so if the entire desired prefix is
+	 * represented as literal bytes, we need rawsize * 9 bits; round up to
+	 * whole bytes.  The prefix could also end in the middle of a 2- or 3-byte
+	 * match tag that follows literals, so allow 2 more bytes to be sure the
+	 * whole tag is there.  (Earlier tags are no problem, since they stand
+	 * for more decompressed bytes than they occupy themselves.)
+	 */
+	compressed_size = ((int64) rawsize * 9 + 7) / 8 + 2;
+
+	return (int32) Min(compressed_size, total_compressed_size);
 }
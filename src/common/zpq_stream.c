@@ -0,0 +1,280 @@
+/*-------------------------------------------------------------------------
+ *
+ * zpq_stream.c
+ *	  Streaming compression of frontend/backend protocol traffic.
+ *
+ * A ZpqStream sits between the protocol buffers of libpq or the backend and
+ * the functions actually sending and receiving data on the connection.  All
+ * data written is compressed into one zlib stream, which is flushed to a
+ * byte boundary (Z_SYNC_FLUSH) whenever the caller flushes its own buffer,
+ * so that the peer can decompress every message it has been sent without
+ * waiting for more data.  Data read is decompressed from the other
+ * direction's stream.
+ *
+ * The stream doesn't use palloc, as it's also used by libpq.
+ *
+ * Portions Copyright (c) 2019, PostgreSQL Global Development Group
+ *
+ *
+ * IDENTIFICATION
+ *	  src/common/zpq_stream.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#ifndef FRONTEND
+#include "postgres.h"
+#else
+#include "postgres_fe.h"
+#endif
+
+#include "common/zpq_stream.h"
+
+#ifdef HAVE_LIBZ
+
+#include <zlib.h>
+
+#define ZPQ_BUFFER_SIZE			8192
+
+struct ZpqStream
+{
+	z_stream	tx;				/* compression state */
+	z_stream	rx;				/* decompression state */
+
+	zpq_tx_func tx_func;
+	zpq_rx_func rx_func;
+	void	   *arg;
+
+	/* compressed data not sent yet */
+	char		tx_buf[ZPQ_BUFFER_SIZE];
+	size_t		tx_pos;			/* next byte of tx_buf to send */
+	size_t		tx_len;			/* end of data in tx_buf */
+	bool		tx_more;		/* compressor may have more output */
+
+	/* compressed data not decompressed yet */
+	char	   *rx_buf;
+	size_t		rx_size;		/* allocated size of rx_buf */
+	size_t		rx_pos;			/* next byte of rx_buf to decompress */
+	size_t		rx_len;			/* end of data in rx_buf */
+	bool		rx_more;		/* decompressor may have more output */
+};
+
+/*
+ * Create a stream for a connection, using tx_func and rx_func, which are
+ * passed arg, to send and receive the compressed data.
+ *
+ * rx_data are rx_data_len bytes the caller has already received, which
+ * belong to the compressed stream and are to be decompressed first.
+ *
+ * Returns NULL if out of memory.
+ */
+ZpqStream *
+zpq_create(zpq_tx_func tx_func, zpq_rx_func rx_func, void *arg,
+		   const char *rx_data, size_t rx_data_len)
+{
+	ZpqStream  *zs;
+
+	zs = (ZpqStream *) malloc(sizeof(ZpqStream));
+	if (zs == NULL)
+		return NULL;
+	memset(zs, 0, sizeof(ZpqStream));
+
+	zs->rx_size = Max(ZPQ_BUFFER_SIZE, rx_data_len);
+	zs->rx_buf = malloc(zs->rx_size);
+	if (zs->rx_buf == NULL)
+	{
+		free(zs);
+		return NULL;
+	}
+	if (rx_data_len > 0)
+		memcpy(zs->rx_buf, rx_data, rx_data_len);
+	zs->rx_len = rx_data_len;
+
+	/*
+	 * Protocol messages are small and sent as soon as they're complete, so
+	 * favour speed over the compression ratio.
+	 */
+	if (deflateInit(&zs->tx, Z_BEST_SPEED) != Z_OK)
+	{
+		free(zs->rx_buf);
+		free(zs);
+		return NULL;
+	}
+	if (inflateInit(&zs->rx) != Z_OK)
+	{
+		deflateEnd(&zs->tx);
+		free(zs->rx_buf);
+		free(zs);
+		return NULL;
+	}
+
+	zs->tx_func = tx_func;
+	zs->rx_func = rx_func;
+	zs->arg = arg;
+
+	return zs;
+}
+
+/*
+ * Read up to size bytes of decompressed data into buf.
+ *
+ * Returns the number of bytes read if there were any.  Otherwise, returns
+ * the result of the last call of rx_func (0 at end of file, or -1 with errno
+ * set), or ZPQ_STREAM_ERROR if the received data could not be decompressed.
+ */
+ssize_t
+zpq_read(ZpqStream *zs, void *buf, size_t size)
+{
+	for (;;)
+	{
+		ssize_t		n;
+
+		if (zs->rx_pos < zs->rx_len || zs->rx_more)
+		{
+			size_t		produced;
+			int			rc;
+
+			zs->rx.next_in = (Bytef *) zs->rx_buf + zs->rx_pos;
+			zs->rx.avail_in = zs->rx_len - zs->rx_pos;
+			zs->rx.next_out = (Bytef *) buf;
+			zs->rx.avail_out = size;
+
+			rc = inflate(&zs->rx, Z_SYNC_FLUSH);
+			if (rc != Z_OK && rc != Z_BUF_ERROR)
+				return ZPQ_STREAM_ERROR;
+
+			zs->rx_pos = zs->rx_len - zs->rx.avail_in;
+			produced = size - zs->rx.avail_out;
+
+			/* if the output is full, there might be more pending */
+			zs->rx_more = (zs->rx.avail_out == 0);
+
+			if (produced > 0)
+				return produced;
+		}
+
+		/* need more input, make room for it */
+		if (zs->rx_pos > 0)
+		{
+			memmove(zs->rx_buf, zs->rx_buf + zs->rx_pos,
+					zs->rx_len - zs->rx_pos);
+			zs->rx_len -= zs->rx_pos;
+			zs->rx_pos = 0;
+		}
+
+		n = zs->rx_func(zs->arg, zs->rx_buf + zs->rx_len,
+						zs->rx_size - zs->rx_len);
+		if (n <= 0)
+			return n;
+		zs->rx_len += n;
+	}
+}
+
+/*
+ * Compress size bytes from buf and send them.
+ *
+ * Returns the number of bytes of buf consumed; these have either been sent
+ * or are buffered in the stream until the next call, see zpq_buffered_tx().
+ * Call with size 0 to only send buffered data.  If nothing could be
+ * consumed because tx_func failed to send buffered data, returns -1 with
+ * errno set by tx_func.  Returns ZPQ_STREAM_ERROR if compression failed.
+ */
+ssize_t
+zpq_write(ZpqStream *zs, const void *buf, size_t size)
+{
+	size_t		consumed;
+	int			rc;
+
+	/* first get rid of what's left over from earlier calls */
+	while (zs->tx_pos < zs->tx_len)
+	{
+		ssize_t		n;
+
+		n = zs->tx_func(zs->arg, zs->tx_buf + zs->tx_pos,
+						zs->tx_len - zs->tx_pos);
+		if (n <= 0)
+			return -1;
+		zs->tx_pos += n;
+	}
+	zs->tx_pos = zs->tx_len = 0;
+
+	if (size == 0 && !zs->tx_more)
+		return 0;
+
+	zs->tx.next_in = (Bytef *) buf;
+	zs->tx.avail_in = size;
+	zs->tx.next_out = (Bytef *) zs->tx_buf;
+	zs->tx.avail_out = ZPQ_BUFFER_SIZE;
+
+	rc = deflate(&zs->tx, Z_SYNC_FLUSH);
+	if (rc != Z_OK && rc != Z_BUF_ERROR)
+		return ZPQ_STREAM_ERROR;
+
+	consumed = size - zs->tx.avail_in;
+	zs->tx_len = ZPQ_BUFFER_SIZE - zs->tx.avail_out;
+
+	/* if the output is full, the flush isn't complete yet */
+	zs->tx_more = (zs->tx.avail_out == 0);
+
+	/*
+	 * Try to send the output right away.  Failures are reported by the next
+	 * call, the data consumed is buffered either way.
+	 */
+	while (zs->tx_pos < zs->tx_len)
+	{
+		ssize_t		n;
+
+		n = zs->tx_func(zs->arg, zs->tx_buf + zs->tx_pos,
+						zs->tx_len - zs->tx_pos);
+		if (n <= 0)
+			break;
+		zs->tx_pos += n;
+	}
+
+	return consumed;
+}
+
+/*
+ * Is there received data that zpq_read() can return without reading more?
+ */
+bool
+zpq_buffered_rx(ZpqStream *zs)
+{
+	return zs->rx_pos < zs->rx_len || zs->rx_more;
+}
+
+/*
+ * Is there data that zpq_write() still has to send?
+ */
+bool
+zpq_buffered_tx(ZpqStream *zs)
+{
+	return zs->tx_pos < zs->tx_len || zs->tx_more;
+}
+
+/*
+ * Describe the last (de)compression error.
+ */
+const char *
+zpq_error(ZpqStream *zs)
+{
+	if (zs->rx.msg)
+		return zs->rx.msg;
+	if (zs->tx.msg)
+		return zs->tx.msg;
+	return "corrupt compressed data";
+}
+
+void
+zpq_free(ZpqStream *zs)
+{
+	if (zs == NULL)
+		return;
+
+	deflateEnd(&zs->tx);
+	inflateEnd(&zs->rx);
+	free(zs->rx_buf);
+	free(zs);
+}
+
+#endif							/* HAVE_LIBZ */
@@ -13,6 +13,8 @@
 #include "access/xlogreader.h"
 #include "lib/stringinfo.h"
 #include "storage/block.h"
+#include "storage/dsm.h"
+#include "storage/shm_toc.h"
 #include "utils/relcache.h"
 
 
@@ -69,6 +71,9 @@ typedef char GinTernaryValue;
 extern PGDLLIMPORT int GinFuzzySearchLimit;
 extern int	gin_pending_list_limit;
 
+/* gininsert.c */
+extern void _gin_parallel_build_main(dsm_segment *seg, shm_toc *toc);
+
 /* ginutil.c */
 extern void ginGetStats(Relation index, GinStatsData *stats);
 extern void ginUpdateStats(Relation index, const GinStatsData *stats);
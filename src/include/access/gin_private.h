@@ -26,6 +26,7 @@ typedef struct GinOptions
 	int32		vl_len_;		/* varlena header (do not touch directly!) */
 	bool		useFastUpdate;	/* use fast updates? */
 	int			pendingListCleanupSize; /* maximum size of pending list */
+	bool		autoCleanup;	/* clean up pending list in autovacuum? */
 } GinOptions;
 
 #define GIN_DEFAULT_USE_FASTUPDATE	true
@@ -37,6 +38,9 @@ typedef struct GinOptions
 	 ((GinOptions *) (relation)->rd_options)->pendingListCleanupSize != -1 ? \
 	 ((GinOptions *) (relation)->rd_options)->pendingListCleanupSize : \
 	 gin_pending_list_limit)
+#define GinGetAutoCleanup(relation) \
+	((relation)->rd_options ? \
+	 ((GinOptions *) (relation)->rd_options)->autoCleanup : false)
 
 
 /* Macros for buffer lock/unlock operations */
@@ -0,0 +1,46 @@
+/*--------------------------------------------------------------------------
+ * gin_tuple.h
+ *	  Public header file for GIN tuples used in parallel index builds.
+ *
+ *	Copyright (c) 2006-2019, PostgreSQL Global Development Group
+ *
+ *	src/include/access/gin_tuple.h
+ *--------------------------------------------------------------------------
+ */
+#ifndef GIN_TUPLE_H
+#define GIN_TUPLE_H
+
+#include "access/ginblock.h"
+#include "storage/itemptr.h"
+#include "utils/sortsupport.h"
+
+/*
+ * A key and a sorted list of the heap TIDs that have it, as passed from the
+ * participants of a parallel GIN build to the leader through a tuplesort.
+ * Unlike index tuples, there is no limit on the length of the TID list.
+ *
+ * The key (if the category is GIN_CAT_NORM_KEY) follows the fixed-size
+ * header at a MAXALIGN'd offset, and the TIDs follow the key.
+ */
+typedef struct GinTuple
+{
+	int			tuplen;			/* length of the whole tuple */
+	OffsetNumber attrnum;		/* attnum of index key */
+	int16		typlen;			/* typlen for key */
+	bool		typbyval;		/* typbyval for key */
+	GinNullCategory category;	/* category: normal or NULL? */
+	int			keylen;			/* bytes in data for key value */
+	int			nitems;			/* number of TIDs in the data */
+	char		data[FLEXIBLE_ARRAY_MEMBER];
+} GinTuple;
+
+#define GinTupleKeyOffset	MAXALIGN(offsetof(GinTuple, data))
+
+#define GinTupleGetKeyData(tup) \
+	((char *) (tup) + GinTupleKeyOffset)
+#define GinTupleGetItems(tup) \
+	((ItemPointer) (GinTupleGetKeyData(tup) + SHORTALIGN((tup)->keylen)))
+
+extern int	_gin_compare_tuples(GinTuple *a, GinTuple *b, SortSupport ssup);
+
+#endif							/* GIN_TUPLE_H */
@@ -23,7 +23,10 @@
 #include "fmgr.h"
 #include "lib/stringinfo.h"
 #include "storage/bufmgr.h"
+#include "storage/dsm.h"
 #include "storage/lockdefs.h"
+#include "storage/shm_toc.h"
+#include "utils/fmgroids.h"
 #include "utils/hsearch.h"
 #include "utils/relcache.h"
 
@@ -386,6 +389,43 @@ extern Datum hash_any_extended(register const unsigned char *k,
 extern Datum hash_uint32(uint32 k);
 extern Datum hash_uint32_extended(uint32 k, uint64 seed);
 
+/*
+ * Compute the hash of 'value' with the hash support function 'flinfo'.
+ *
+ * This is for callers that hash many values, such as hash joins and hashed
+ * aggregation.  For the common fixed-width integer types, we compute the
+ * hash directly rather than going through the function manager; the result
+ * is the same as calling the support function.
+ */
+static inline uint32
+hash_datum_fast(FmgrInfo *flinfo, Oid collation, Datum value)
+{
+	switch (flinfo->fn_oid)
+	{
+		case F_HASHCHAR:
+			return DatumGetUInt32(hash_uint32((int32) DatumGetChar(value)));
+		case F_HASHINT2:
+			return DatumGetUInt32(hash_uint32((int32) DatumGetInt16(value)));
+		case F_HASHINT4:
+			return DatumGetUInt32(hash_uint32(DatumGetInt32(value)));
+		case F_HASHINT8:
+			{
+				/* must match hashint8() */
+				int64		val = DatumGetInt64(value);
+				uint32		lohalf = (uint32) val;
+				uint32		hihalf = (uint32) (val >> 32);
+
+				lohalf ^= (val >= 0) ? hihalf : ~hihalf;
+				return DatumGetUInt32(hash_uint32(lohalf));
+			}
+		case F_HASHOID:
+		case F_HASHENUM:
+			return DatumGetUInt32(hash_uint32((uint32) DatumGetObjectId(value)));
+		default:
+			return DatumGetUInt32(FunctionCall1Coll(flinfo, collation, value));
+	}
+}
+
 /* private routines */
 
 /* hashinsert.c */
@@ -450,6 +490,10 @@ extern void _h_spooldestroy(HSpool *hspool);
 extern void _h_spool(HSpool *hspool, ItemPointer self,
 		 Datum *values, bool *isnull);
 extern void _h_indexbuild(HSpool *hspool, Relation heapRel);
+extern HSpool *_h_parallel_spoolinit(Relation heap, Relation index,
+					  struct IndexInfo *indexInfo, uint32 num_buckets,
+					  double *reltuples, double *indtuples);
+extern void _h_parallel_build_main(dsm_segment *seg, shm_toc *toc);
 
 /* hashutil.c */
 extern bool _hash_checkqual(IndexScanDesc scan, IndexTuple itup);
@@ -24,7 +24,8 @@
  * state for bulk inserts --- private to heapam.c and hio.c
  *
  * If current_buf isn't InvalidBuffer, then we are holding an extra pin
- * on that buffer.
+ * on that buffer.  nextended counts the blocks that this bulk insert has
+ * added to the relation so far; hio.c uses it to size its extensions.
  *
  * "typedef struct BulkInsertStateData *BulkInsertState" is in heapam.h
  */
@@ -32,6 +33,7 @@ typedef struct BulkInsertStateData
 {
 	BufferAccessStrategy strategy;	/* our BULKWRITE strategy object */
 	Buffer		current_buf;	/* current insertion target page */
+	BlockNumber nextended;		/* # of blocks added by this bulk insert */
 }			BulkInsertStateData;
 
 
@@ -139,6 +139,14 @@ typedef struct BTMetaPageData
 #define BTREE_DEFAULT_FILLFACTOR	90
 #define BTREE_NONLEAF_FILLFACTOR	70
 
+/*
+ * Returns the relation's deduplicate_items storage parameter, which lets the
+ * user disable deduplication; see _bt_dedup_enabled().
+ */
+#define BTGetDeduplicateItems(relation) \
+	((relation)->rd_options ? \
+	 ((StdRdOptions *) (relation)->rd_options)->deduplicate_items : true)
+
 /*
  *	In general, the btree code tries to localize its knowledge about
  *	page layout to a couple of routines.  However, we need a special
@@ -199,25 +207,41 @@ typedef struct BTMetaPageData
  * metapage and a single leaf root page) must have some number of pivot
  * tuples, since pivot tuples are used for traversing the tree.
  *
+ * Leaf page high keys (and so the downlinks copied from them) may also omit
+ * trailing key attributes, keeping only the leading attributes needed to
+ * separate the two halves of the split that created them (suffix
+ * truncation, see _bt_keep_natts()).  Truncated key attributes are treated
+ * as minus infinity when searching.
+ *
  * We store the number of attributes present inside pivot tuples by abusing
  * their item pointer offset field, since pivot tuples never need to store a
  * real offset (downlinks only need to store a block number).  The offset
  * field only stores the number of attributes when the INDEX_ALT_TID_MASK
  * bit is set (we never assume that pivot tuples must explicitly store the
  * number of attributes, and currently do not bother storing the number of
- * attributes unless indnkeyatts actually differs from indnatts).
- * INDEX_ALT_TID_MASK is only used for pivot tuples at present, though it's
- * possible that it will be used within non-pivot tuples in the future.  Do
+ * attributes unless some attributes were actually truncated).
+ * INDEX_ALT_TID_MASK is also used by posting list tuples (see below), so do
  * not assume that a tuple with INDEX_ALT_TID_MASK set must be a pivot
  * tuple.
  *
  * The 12 least significant offset bits are used to represent the number of
- * attributes in INDEX_ALT_TID_MASK tuples, leaving 4 bits that are reserved
- * for future use (BT_RESERVED_OFFSET_MASK bits). BT_N_KEYS_OFFSET_MASK should
- * be large enough to store any number <= INDEX_MAX_KEYS.
+ * attributes in INDEX_ALT_TID_MASK tuples.  The BT_IS_POSTING bit marks a
+ * posting list tuple, leaving the remaining 3 bits reserved for future use
+ * (BT_RESERVED_OFFSET_MASK bits).  BT_N_KEYS_OFFSET_MASK should be large
+ * enough to store any number <= INDEX_MAX_KEYS.
+ *
+ * A posting list tuple is a leaf tuple that stands for several heap tuples
+ * with the same key, as formed by deduplication (see nbtdedup.c).  Its key
+ * is followed by an array of heap TIDs, starting at a SHORTALIGN()'d offset
+ * that is stored in the item pointer's block number.  The offset field holds
+ * BT_IS_POSTING and the number of heap TIDs, using the same 12 bits that
+ * pivot tuples use for the number of attributes.  Posting list tuples always
+ * have all of the index's attributes, and they never appear as pivot
+ * tuples: a high key formed from a posting list tuple only keeps its key.
  */
 #define INDEX_ALT_TID_MASK			INDEX_AM_RESERVED_BIT
-#define BT_RESERVED_OFFSET_MASK		0xF000
+#define BT_RESERVED_OFFSET_MASK		0xD000
+#define BT_IS_POSTING				0x2000
 #define BT_N_KEYS_OFFSET_MASK		0x0FFF
 
 /* Get/set downlink block number */
@@ -240,13 +264,22 @@ typedef struct BTMetaPageData
 		BTreeTupleSetNAtts((itup), 0); \
 	} while(0)
 
+/*
+ * Tell posting list tuples apart from each other kind of tuple
+ */
+#define BTreeTupleIsPosting(itup) \
+	( \
+		((itup)->t_info & INDEX_ALT_TID_MASK) != 0 && \
+		(ItemPointerGetOffsetNumberNoCheck(&(itup)->t_tid) & BT_IS_POSTING) != 0 \
+	)
+
 /*
  * Get/set number of attributes within B-tree index tuple. Asserts should be
  * removed when BT_RESERVED_OFFSET_MASK bits will be used.
  */
 #define BTreeTupleGetNAtts(itup, rel)	\
 	( \
-		(itup)->t_info & INDEX_ALT_TID_MASK ? \
+		(itup)->t_info & INDEX_ALT_TID_MASK && !BTreeTupleIsPosting(itup) ? \
 		( \
 			AssertMacro((ItemPointerGetOffsetNumberNoCheck(&(itup)->t_tid) & BT_RESERVED_OFFSET_MASK) == 0), \
 			ItemPointerGetOffsetNumberNoCheck(&(itup)->t_tid) & BT_N_KEYS_OFFSET_MASK \
@@ -254,6 +287,14 @@ typedef struct BTMetaPageData
 		: \
 		IndexRelationGetNumberOfAttributes(rel) \
 	)
+/*
+ * Get the number of key attributes within a B-tree index tuple, which is
+ * less than the index's when suffix truncation made it a pivot tuple with
+ * only some leading key attributes.  This is the key size to use with a scan
+ * key built from the tuple by _bt_mkscankey().
+ */
+#define BTreeTupleGetNKeyAtts(itup, rel) \
+	Min(BTreeTupleGetNAtts(itup, rel), IndexRelationGetNumberOfKeyAttributes(rel))
 #define BTreeTupleSetNAtts(itup, n) \
 	do { \
 		(itup)->t_info |= INDEX_ALT_TID_MASK; \
@@ -261,6 +302,53 @@ typedef struct BTMetaPageData
 		ItemPointerSetOffsetNumber(&(itup)->t_tid, (n) & BT_N_KEYS_OFFSET_MASK); \
 	} while(0)
 
+/*
+ * Get/set posting list metadata of a posting list tuple, and access its
+ * heap TIDs.  BTreeTupleGetPostingOffset is also the size of the tuple's
+ * key portion.
+ */
+#define BTreeTupleGetNPosting(itup) \
+	( \
+		AssertMacro(BTreeTupleIsPosting(itup)), \
+		ItemPointerGetOffsetNumberNoCheck(&(itup)->t_tid) & BT_N_KEYS_OFFSET_MASK \
+	)
+#define BTreeTupleGetPostingOffset(itup) \
+	( \
+		AssertMacro(BTreeTupleIsPosting(itup)), \
+		ItemPointerGetBlockNumberNoCheck(&(itup)->t_tid) \
+	)
+#define BTreeTupleSetPosting(itup, nhtids, off) \
+	do { \
+		Assert((nhtids) > 1 && ((nhtids) & BT_N_KEYS_OFFSET_MASK) == (nhtids)); \
+		Assert((off) == SHORTALIGN(off)); \
+		(itup)->t_info |= INDEX_ALT_TID_MASK; \
+		ItemPointerSetOffsetNumber(&(itup)->t_tid, (nhtids) | BT_IS_POSTING); \
+		ItemPointerSetBlockNumber(&(itup)->t_tid, (off)); \
+	} while(0)
+#define BTreeTupleGetPosting(itup) \
+	((ItemPointer) ((char *) (itup) + BTreeTupleGetPostingOffset(itup)))
+#define BTreeTupleGetPostingN(itup, n) \
+	(BTreeTupleGetPosting(itup) + (n))
+
+/*
+ * Number of heap TIDs that a leaf tuple stands for, and its n'th heap TID.
+ * These work for plain leaf tuples as well as posting list tuples.
+ */
+#define BTreeTupleGetNHeapTIDs(itup) \
+	(BTreeTupleIsPosting(itup) ? BTreeTupleGetNPosting(itup) : 1)
+#define BTreeTupleGetHeapTIDN(itup, n) \
+	(BTreeTupleIsPosting(itup) ? BTreeTupleGetPostingN(itup, n) : &(itup)->t_tid)
+
+/*
+ * MaxTIDsPerBTreePage is an upper bound on the number of heap TIDs that may
+ * be stored on a btree leaf page, counting each heap TID in a posting list
+ * tuple separately.  It is used to size the arrays that index scans keep
+ * for a whole page.
+ */
+#define MaxTIDsPerBTreePage \
+	(int) ((BLCKSZ - SizeOfPageHeaderData - sizeof(BTPageOpaqueData)) / \
+		   sizeof(ItemPointerData))
+
 /*
  *	Operator strategy numbers for B-tree have been moved to access/stratnum.h,
  *	because many places need to use them in ScanKeyInit() calls.
@@ -342,7 +430,8 @@ typedef BTStackData *BTStack;
  * If we are doing an index-only scan, we save the entire IndexTuple for each
  * matched item, otherwise only its heap TID and offset.  The IndexTuples go
  * into a separate workspace array; each BTScanPosItem stores its tuple's
- * offset within that array.
+ * offset within that array.  A posting list tuple yields one BTScanPosItem
+ * per heap TID, all of which share a single copy of the tuple's key.
  */
 
 typedef struct BTScanPosItem	/* what we remember about each match */
@@ -385,8 +474,9 @@ typedef struct BTScanPosData
 	int			firstItem;		/* first valid index in items[] */
 	int			lastItem;		/* last valid index in items[] */
 	int			itemIndex;		/* current index in items[] */
+	int			prefetchItem;	/* next index in items[] to prefetch */
 
-	BTScanPosItem items[MaxIndexTuplesPerPage]; /* MUST BE LAST */
+	BTScanPosItem items[MaxTIDsPerBTreePage];	/* MUST BE LAST */
 } BTScanPosData;
 
 typedef BTScanPosData *BTScanPos;
@@ -433,6 +523,26 @@ typedef struct BTArrayKeyInfo
 	Datum	   *elem_values;	/* array of num_elems Datums */
 } BTArrayKeyInfo;
 
+/*
+ * State of a skip scan, which supplies an equality key on the first index
+ * column in place of the missing one (see _bt_preprocess_skip_key).  The
+ * key's current value lives in arrayKeyData[0]; values are copied into
+ * arrayContext.
+ */
+typedef struct BTSkipKeyInfo
+{
+	bool		cur_valid;		/* skip key holds a value? */
+	bool		next_valid;		/* next_value already found? */
+	bool		next_null;		/* next value is NULL? */
+	Datum		next_value;		/* next value to skip to, if next_valid */
+	ScanDirection next_dir;		/* direction in which next_value was found */
+	bool		mark_valid;		/* mark_value/mark_null are valid? */
+	bool		mark_null;		/* marked value is NULL? */
+	Datum		mark_value;		/* value at the marked position */
+	int16		attlen;			/* first column's typlen */
+	bool		attbyval;		/* first column's typbyval */
+} BTSkipKeyInfo;
+
 typedef struct BTScanOpaqueData
 {
 	/* these fields are set by _bt_preprocess_keys(): */
@@ -449,6 +559,13 @@ typedef struct BTScanOpaqueData
 	BTArrayKeyInfo *arrayKeys;	/* info about each equality-type array key */
 	MemoryContext arrayContext; /* scan-lifespan context for array data */
 
+	/* workspace for skip scans (NULL if not skipping) */
+	BTSkipKeyInfo *skipKey;
+
+	/* heap prefetching state, see _bt_prefetch_heap() */
+	int			prefetchTarget; /* current prefetch distance, in items */
+	BlockNumber prefetchBlock;	/* last heap block prefetched */
+
 	/* info about killed items if any (killedItems is NULL if never used) */
 	int		   *killedItems;	/* currPos.items indexes of killed items */
 	int			numKilled;		/* number of currently stored items */
@@ -488,6 +605,43 @@ typedef BTScanOpaqueData *BTScanOpaque;
 #define SK_BT_DESC			(INDOPTION_DESC << SK_BT_INDOPTION_SHIFT)
 #define SK_BT_NULLS_FIRST	(INDOPTION_NULLS_FIRST << SK_BT_INDOPTION_SHIFT)
 
+/*
+ * BTDedupInterval describes a run of index tuples that deduplication merged
+ * into a single posting list tuple: the tuples originally at baseoff and the
+ * nitems - 1 offsets following it.  Intervals are WAL-logged so that redo
+ * can repeat the merge.
+ */
+typedef struct BTDedupInterval
+{
+	OffsetNumber baseoff;
+	uint16		nitems;
+} BTDedupInterval;
+
+/*
+ * BTDedupStateData is the working state used while merging the tuples of a
+ * leaf page, or of the sorted input of an index build, into posting list
+ * tuples.  The "pending" posting list is being built up from tuples with the
+ * same key as base.
+ */
+typedef struct BTDedupStateData
+{
+	Size		maxpostingsize; /* limit on size of final tuple */
+
+	/* pending posting list */
+	IndexTuple	base;			/* first tuple of pending posting list */
+	OffsetNumber baseoff;		/* page offset of base */
+	Size		basetupsize;	/* base size without posting list */
+	ItemPointer htids;			/* heap TIDs in pending posting list */
+	int			nhtids;			/* number of heap TIDs in htids array */
+	int			nitems;			/* number of existing tuples merged */
+
+	/* intervals merged so far; only needed for page-level deduplication */
+	int			nintervals;
+	BTDedupInterval intervals[MaxIndexTuplesPerPage];
+} BTDedupStateData;
+
+typedef BTDedupStateData *BTDedupState;
+
 /*
  * external entry points for btree, in nbtree.c
  */
@@ -523,6 +677,19 @@ extern void _bt_parallel_release(IndexScanDesc scan, BlockNumber scan_page);
 extern void _bt_parallel_done(IndexScanDesc scan);
 extern void _bt_parallel_advance_array_keys(IndexScanDesc scan);
 
+/*
+ * prototypes for functions in nbtdedup.c
+ */
+extern bool _bt_dedup_enabled(Relation rel);
+extern void _bt_dedup_one_page(Relation rel, Buffer buf, Size newitemsz);
+extern void _bt_dedup_start_pending(BTDedupState state, IndexTuple base,
+						OffsetNumber baseoff);
+extern bool _bt_dedup_save_htid(BTDedupState state, IndexTuple itup);
+extern Size _bt_dedup_finish_pending(Page newpage, BTDedupState state);
+extern bool _bt_dedup_keys_equal(IndexTuple itup1, IndexTuple itup2);
+extern IndexTuple _bt_form_posting(IndexTuple base, ItemPointer htids,
+				 int nhtids);
+
 /*
  * prototypes for functions in nbtinsert.c
  */
@@ -552,7 +719,8 @@ extern void _bt_delitems_delete(Relation rel, Buffer buf,
 					OffsetNumber *itemnos, int nitems, Relation heapRel);
 extern void _bt_delitems_vacuum(Relation rel, Buffer buf,
 					OffsetNumber *itemnos, int nitems,
-					BlockNumber lastBlockVacuumed);
+					OffsetNumber *updatedoffsets, IndexTuple *updated,
+					int nupdated, BlockNumber lastBlockVacuumed);
 extern int	_bt_pagedel(Relation rel, Buffer buf);
 
 /*
@@ -572,6 +740,8 @@ extern bool _bt_first(IndexScanDesc scan, ScanDirection dir);
 extern bool _bt_next(IndexScanDesc scan, ScanDirection dir);
 extern Buffer _bt_get_endpoint(Relation rel, uint32 level, bool rightmost,
 				 Snapshot snapshot);
+extern void _bt_prefetch_heap(IndexScanDesc scan, ScanDirection dir);
+extern bool _bt_skip_find_value(IndexScanDesc scan, ScanDirection dir);
 
 /*
  * prototypes for functions in nbtutils.c
@@ -585,6 +755,14 @@ extern void _bt_start_array_keys(IndexScanDesc scan, ScanDirection dir);
 extern bool _bt_advance_array_keys(IndexScanDesc scan, ScanDirection dir);
 extern void _bt_mark_array_keys(IndexScanDesc scan);
 extern void _bt_restore_array_keys(IndexScanDesc scan);
+extern void _bt_preprocess_skip_key(IndexScanDesc scan);
+extern bool _bt_start_skip_key(IndexScanDesc scan, ScanDirection dir);
+extern bool _bt_advance_skip_key(IndexScanDesc scan, ScanDirection dir);
+extern void _bt_skip_set_value(IndexScanDesc scan, Datum value, bool isnull);
+extern void _bt_skip_note_next(IndexScanDesc scan, ScanDirection dir,
+				   Page page, OffsetNumber offnum);
+extern void _bt_mark_skip_key(IndexScanDesc scan);
+extern void _bt_restore_skip_key(IndexScanDesc scan);
 extern void _bt_preprocess_keys(IndexScanDesc scan);
 extern IndexTuple _bt_checkkeys(IndexScanDesc scan,
 			  Page page, OffsetNumber offnum,
@@ -600,7 +778,9 @@ extern bytea *btoptions(Datum reloptions, bool validate);
 extern bool btproperty(Oid index_oid, int attno,
 		   IndexAMProperty prop, const char *propname,
 		   bool *res, bool *isnull);
-extern IndexTuple _bt_nonkey_truncate(Relation rel, IndexTuple itup);
+extern int	_bt_keep_natts(Relation rel, IndexTuple lastleft,
+			   IndexTuple firstright);
+extern IndexTuple _bt_truncate(Relation rel, IndexTuple itup, int keepnatts);
 extern bool _bt_check_natts(Relation rel, Page page, OffsetNumber offnum);
 
 /*
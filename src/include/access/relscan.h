@@ -21,6 +21,33 @@
 #include "access/tupdesc.h"
 #include "storage/spin.h"
 
+/*
+ * Generic descriptor for a scan of a table, see tableam.h.  A table access
+ * method's own scan descriptor embeds this as its first member, and adds
+ * whatever state it needs.
+ */
+typedef struct TableScanDescData
+{
+	/* scan parameters */
+	Relation	rs_rd;			/* heap relation descriptor */
+	Snapshot	rs_snapshot;	/* snapshot to see */
+	int			rs_nkeys;		/* number of scan keys */
+	ScanKey		rs_key;			/* array of scan key descriptors */
+	Bitmapset  *rs_projcols;	/* columns the caller needs, or NULL for all;
+								 * see table_scan_set_projection */
+
+	/* range of TIDs to return, see table_scan_set_tidrange */
+	ItemPointerData rs_mintid;
+	ItemPointerData rs_maxtid;
+} TableScanDescData;
+typedef struct TableScanDescData *TableScanDesc;
+
+/*
+ * Shared state for a parallel table scan.  The contents are up to the table
+ * access method; the heap's is ParallelHeapScanDescData.
+ */
+typedef struct ParallelTableScanDescData *ParallelTableScanDesc;
+
 /*
  * Shared state for parallel heap scan.
  *
@@ -45,11 +72,9 @@ typedef struct ParallelHeapScanDescData
 
 typedef struct HeapScanDescData
 {
-	/* scan parameters */
-	Relation	rs_rd;			/* heap relation descriptor */
-	Snapshot	rs_snapshot;	/* snapshot to see */
-	int			rs_nkeys;		/* number of scan keys */
-	ScanKey		rs_key;			/* array of scan key descriptors */
+	TableScanDescData rs_base;	/* AM independent part of the descriptor */
+
+	/* heap specific scan parameters */
 	bool		rs_bitmapscan;	/* true if this is really a bitmap scan */
 	bool		rs_samplescan;	/* true if this is really a sample scan */
 	bool		rs_pageatatime; /* verify visibility page-at-a-time? */
@@ -65,6 +90,12 @@ typedef struct HeapScanDescData
 	BufferAccessStrategy rs_strategy;	/* access strategy for reads */
 	bool		rs_syncscan;	/* report location to syncscan logic? */
 
+	/* read-ahead state for forward seqscans, see heap_readahead() */
+	int			rs_prefetch_maximum;	/* max blocks to prefetch, 0 = off */
+	int			rs_prefetch_target; /* current read-ahead distance */
+	BlockNumber rs_prefetch_next;	/* next block not yet prefetched */
+	BlockNumber rs_prefetch_remaining;	/* # blocks left to prefetch */
+
 	/* scan current state */
 	bool		rs_inited;		/* false = scan not init'd yet */
 	HeapTupleData rs_ctup;		/* current tuple in scan, if any */
@@ -95,6 +126,9 @@ typedef struct IndexScanDescData
 	ScanKey		keyData;		/* array of index qualifier descriptors */
 	ScanKey		orderByData;	/* array of ordering op descriptors */
 	bool		xs_want_itup;	/* caller requests index tuples */
+	bool		xs_want_skip;	/* caller requests a skip scan, if possible */
+	int			xs_prefetch_maximum;	/* max heap blocks to prefetch ahead
+										 * of the scan, 0 = none */
 	bool		xs_temp_snap;	/* unregister snapshot at scan end? */
 
 	/* signaling to index AM about killing index tuples */
@@ -35,6 +35,17 @@
 /* Maximum length of an SLRU name */
 #define SLRU_MAX_NAME_LENGTH	32
 
+/*
+ * The buffer slots of an SLRU are divided into banks of SLRU_BANK_SIZE slots
+ * (an SLRU with fewer slots than that has a single, smaller bank).  A page can
+ * only be held by a slot of bank (pageno % num_banks), so a lookup or a victim
+ * search examines at most SLRU_BANK_SIZE slots however large the pool is.
+ */
+#define SLRU_BANK_SIZE			16
+
+/* Upper limit for the configurable SLRU pool sizes: 1GB worth of pages */
+#define SLRU_MAX_ALLOWED_BUFFERS	((1024 * 1024 * 1024) / BLCKSZ)
+
 /*
  * Page status codes.  Note that these do not include the "dirty" bit.
  * page_dirty can be true only in the VALID or WRITE_IN_PROGRESS states;
@@ -54,11 +65,20 @@ typedef enum
  */
 typedef struct SlruSharedData
 {
+	/*
+	 * An SLRU is either protected by a single ControlLock, or by one lock per
+	 * bank, in which case bank_locks is non-NULL and ControlLock is NULL.  Use
+	 * SimpleLruGetBankLock() to find the lock protecting a given page.
+	 */
 	LWLock	   *ControlLock;
 
 	/* Number of buffers managed by this SLRU structure */
 	int			num_slots;
 
+	/* Number of banks, and number of slots in each; see SLRU_BANK_SIZE */
+	int			num_banks;
+	int			bank_size;
+
 	/*
 	 * Arrays holding info for each buffer slot.  Page number is undefined
 	 * when status is EMPTY, as is page_lru_count.
@@ -81,20 +101,24 @@ typedef struct SlruSharedData
 	int			lsn_groups_per_page;
 
 	/*----------
-	 * We mark a page "most recently used" by setting
-	 *		page_lru_count[slotno] = ++cur_lru_count;
-	 * The oldest page is therefore the one with the highest value of
-	 *		cur_lru_count - page_lru_count[slotno]
+	 * Each bank keeps its own LRU clock.  We mark a page "most recently used"
+	 * by setting
+	 *		page_lru_count[slotno] = ++bank_cur_lru_count[bankno];
+	 * The oldest page of a bank is therefore the one with the highest value
+	 * of
+	 *		bank_cur_lru_count[bankno] - page_lru_count[slotno]
 	 * The counts will eventually wrap around, but this calculation still
 	 * works as long as no page's age exceeds INT_MAX counts.
 	 *----------
 	 */
-	int			cur_lru_count;
+	int		   *bank_cur_lru_count;
 
 	/*
 	 * latest_page_number is the page number of the current end of the log;
 	 * this is not critical data, since we use it only to avoid swapping out
-	 * the latest page.
+	 * the latest page and to sanity-check truncation.  In an SLRU with bank
+	 * locks it is updated while holding only the lock of the new page's bank,
+	 * so other readers may see a slightly stale value.
 	 */
 	int			latest_page_number;
 
@@ -102,6 +126,9 @@ typedef struct SlruSharedData
 	int			lwlock_tranche_id;
 	char		lwlock_tranche_name[SLRU_MAX_NAME_LENGTH];
 	LWLockPadded *buffer_locks;
+	int			bank_tranche_id;
+	char		bank_tranche_name[SLRU_MAX_NAME_LENGTH];
+	LWLockPadded *bank_locks;
 } SlruSharedData;
 
 typedef SlruSharedData *SlruShared;
@@ -136,10 +163,26 @@ typedef struct SlruCtlData
 
 typedef SlruCtlData *SlruCtl;
 
+/*
+ * Return the lock that must be held to access the given page: the lock of
+ * the page's bank, or the SLRU's single control lock.
+ */
+static inline LWLock *
+SimpleLruGetBankLock(SlruCtl ctl, int pageno)
+{
+	SlruShared	shared = ctl->shared;
+
+	if (shared->bank_locks == NULL)
+		return shared->ControlLock;
+	return &shared->bank_locks[(uint32) pageno % shared->num_banks].lock;
+}
+
 
+extern int	SimpleLruAutotuneBuffers(int divisor, int max);
 extern Size SimpleLruShmemSize(int nslots, int nlsns);
 extern void SimpleLruInit(SlruCtl ctl, const char *name, int nslots, int nlsns,
-			  LWLock *ctllock, const char *subdir, int tranche_id);
+			  LWLock *ctllock, const char *subdir, int tranche_id,
+			  int bank_tranche_id);
 extern int	SimpleLruZeroPage(SlruCtl ctl, int pageno);
 extern int SimpleLruReadPage(SlruCtl ctl, int pageno, bool write_ok,
 				  TransactionId xid);
@@ -11,12 +11,16 @@
 #ifndef SUBTRANS_H
 #define SUBTRANS_H
 
-/* Number of SLRU buffers to use for subtrans */
-#define NUM_SUBTRANS_BUFFERS	32
+/* GUC variable: number of SLRU buffers to use for subtrans, 0 = automatic */
+extern int	subtransaction_buffers;
+
+/* GUC variable: number of entries in the topmost cache, 0 = disabled */
+extern int	subtransaction_topmost_cache;
 
 extern void SubTransSetParent(TransactionId xid, TransactionId parent);
 extern TransactionId SubTransGetParent(TransactionId xid);
 extern TransactionId SubTransGetTopmostTransaction(TransactionId xid);
+extern void SubTransRecordTopmost(TransactionId xid, TransactionId topxid);
 
 extern Size SUBTRANSShmemSize(void);
 extern void SUBTRANSShmemInit(void);
@@ -0,0 +1,423 @@
+/*-------------------------------------------------------------------------
+ *
+ * tableam.h
+ *	  API for Postgres table access methods.
+ *
+ * A table access method is responsible for storing and retrieving the rows
+ * of tables and materialized views.  The executor, COPY, VACUUM, ANALYZE
+ * and the planner reach the storage through the callbacks in
+ * TableAmRoutine, so that storage formats other than the heap can be
+ * provided by extensions.
+ *
+ * Copyright (c) 2019, PostgreSQL Global Development Group
+ *
+ * src/include/access/tableam.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef TABLEAM_H
+#define TABLEAM_H
+
+#include "access/heapam.h"
+#include "access/relscan.h"
+#include "executor/tuptable.h"
+#include "utils/guc.h"
+#include "utils/rel.h"
+
+
+#define DEFAULT_TABLE_ACCESS_METHOD	"heap"
+
+/* GUC */
+extern char *default_table_access_method;
+
+/* Forward declarations, to avoid including commands/vacuum.h here */
+struct VacuumParams;
+
+
+/*
+ * API struct for a table AM.  Note this must be allocated in a
+ * server-lifetime manner, typically as a static const struct, which then
+ * gets returned by the AM's handler function.  The relcache keeps a pointer
+ * to it in rd_tableam.
+ *
+ * Callback functions are described with the table_* wrappers below.  All
+ * callbacks are required.
+ */
+typedef struct TableAmRoutine
+{
+	/* this must be set to T_TableAmRoutine */
+	NodeTag		type;
+
+	/* ------------------------------------------------------------------------
+	 * Slot related callbacks.
+	 * ------------------------------------------------------------------------
+	 */
+
+	/* kind of slot that fits the rows of a relation using this AM */
+	const TupleTableSlotOps *(*slot_callbacks) (Relation rel);
+
+	/* ------------------------------------------------------------------------
+	 * Table scan callbacks.
+	 * ------------------------------------------------------------------------
+	 */
+
+	TableScanDesc (*scan_begin) (Relation rel, Snapshot snapshot,
+								 int nkeys, ScanKey key,
+								 ParallelTableScanDesc pscan);
+	void		(*scan_end) (TableScanDesc scan);
+	void		(*scan_rescan) (TableScanDesc scan, ScanKey key);
+	bool		(*scan_getnextslot) (TableScanDesc scan,
+									 ScanDirection direction,
+									 TupleTableSlot *slot);
+	void		(*scan_set_tidrange) (TableScanDesc scan,
+									  ItemPointer mintid,
+									  ItemPointer maxtid);
+	bool		(*scan_getnextslot_tidrange) (TableScanDesc scan,
+											  ScanDirection direction,
+											  TupleTableSlot *slot);
+
+	/* ------------------------------------------------------------------------
+	 * Parallel table scan callbacks.
+	 * ------------------------------------------------------------------------
+	 */
+
+	Size		(*parallelscan_estimate) (Relation rel, Snapshot snapshot);
+	void		(*parallelscan_initialize) (Relation rel,
+											ParallelTableScanDesc pscan,
+											Snapshot snapshot);
+	void		(*parallelscan_reinitialize) (Relation rel,
+											  ParallelTableScanDesc pscan);
+
+	/* ------------------------------------------------------------------------
+	 * Callbacks for non-modifying operations on individual tuples.
+	 * ------------------------------------------------------------------------
+	 */
+
+	bool		(*tuple_fetch_row_version) (Relation rel, ItemPointer tid,
+											Snapshot snapshot,
+											TupleTableSlot *slot);
+
+	/* ------------------------------------------------------------------------
+	 * Manipulations of physical tuples.
+	 * ------------------------------------------------------------------------
+	 */
+
+	void		(*tuple_insert) (Relation rel, TupleTableSlot *slot,
+								 CommandId cid, int options,
+								 BulkInsertState bistate, ItemPointer tid);
+	void		(*tuple_insert_speculative) (Relation rel,
+											 TupleTableSlot *slot,
+											 CommandId cid, int options,
+											 BulkInsertState bistate,
+											 uint32 specToken,
+											 ItemPointer tid);
+	void		(*tuple_complete_speculative) (Relation rel, ItemPointer tid,
+											   bool succeeded);
+	HTSU_Result (*tuple_delete) (Relation rel, ItemPointer tid,
+								 CommandId cid, Snapshot crosscheck,
+								 bool wait, HeapUpdateFailureData *hufd,
+								 bool changingPart);
+	HTSU_Result (*tuple_update) (Relation rel, ItemPointer otid,
+								 TupleTableSlot *slot, CommandId cid,
+								 Snapshot crosscheck, bool wait,
+								 HeapUpdateFailureData *hufd,
+								 LockTupleMode *lockmode, ItemPointer newtid,
+								 TU_UpdateIndexes *update_indexes);
+
+	/* ------------------------------------------------------------------------
+	 * Whole-relation operations.
+	 * ------------------------------------------------------------------------
+	 */
+
+	/* non-FULL VACUUM of the relation; see lazy_vacuum_rel for the heap */
+	void		(*relation_vacuum) (Relation onerel, int options,
+									struct VacuumParams *params,
+									BufferAccessStrategy bstrategy);
+
+	/* collect a random sample of rows for ANALYZE */
+	int			(*relation_acquire_sample_rows) (Relation onerel, int elevel,
+												 HeapTuple *rows, int targrows,
+												 double *totalrows,
+												 double *totaldeadrows);
+
+	/* planner's estimate of the relation's size; see estimate_rel_size */
+	void		(*relation_estimate_size) (Relation rel, int32 *attr_widths,
+										   BlockNumber *pages, double *tuples,
+										   double *allvisfrac);
+} TableAmRoutine;
+
+
+/* ----------------------------------------------------------------------------
+ * Slot functions.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * Returns the slot callbacks suitable for holding rows of the relation.
+ */
+static inline const TupleTableSlotOps *
+table_slot_callbacks(Relation rel)
+{
+	return rel->rd_tableam->slot_callbacks(rel);
+}
+
+
+/* ----------------------------------------------------------------------------
+ * Table scan functions.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * Start a scan of rel, returning rows visible to snapshot that satisfy the
+ * nkeys scan keys.
+ */
+static inline TableScanDesc
+table_beginscan(Relation rel, Snapshot snapshot, int nkeys, ScanKey key)
+{
+	return rel->rd_tableam->scan_begin(rel, snapshot, nkeys, key, NULL);
+}
+
+/*
+ * End a table scan.
+ */
+static inline void
+table_endscan(TableScanDesc scan)
+{
+	scan->rs_rd->rd_tableam->scan_end(scan);
+}
+
+/*
+ * Restart a table scan, optionally with new scan keys.
+ */
+static inline void
+table_rescan(TableScanDesc scan, ScanKey key)
+{
+	scan->rs_rd->rd_tableam->scan_rescan(scan, key);
+}
+
+/*
+ * Return the next row of the scan in slot.  Returns false, with the slot
+ * cleared, at the end of the scan.
+ */
+static inline bool
+table_scan_getnextslot(TableScanDesc scan, ScanDirection direction,
+					   TupleTableSlot *slot)
+{
+	return scan->rs_rd->rd_tableam->scan_getnextslot(scan, direction, slot);
+}
+
+/*
+ * Restrict the scan to rows whose TIDs lie between mintid and maxtid,
+ * inclusive, and restart it.  The AM should avoid reading the parts of the
+ * relation that cannot contain such rows; those rows are then returned by
+ * table_scan_getnextslot_tidrange.  The bounds need not be valid TIDs of the
+ * relation.  May be called again, after the scan has been used, to scan a
+ * different range.
+ */
+static inline void
+table_scan_set_tidrange(TableScanDesc scan, ItemPointer mintid,
+						ItemPointer maxtid)
+{
+	scan->rs_rd->rd_tableam->scan_set_tidrange(scan, mintid, maxtid);
+}
+
+/*
+ * Return the next row of the range set by table_scan_set_tidrange in slot.
+ * Returns false, with the slot cleared, at the end of the range.
+ */
+static inline bool
+table_scan_getnextslot_tidrange(TableScanDesc scan, ScanDirection direction,
+								TupleTableSlot *slot)
+{
+	return scan->rs_rd->rd_tableam->scan_getnextslot_tidrange(scan, direction,
+															  slot);
+}
+
+/*
+ * Tell the scan that the caller only needs the columns in projcols, a set of
+ * attribute numbers offset by FirstLowInvalidHeapAttributeNumber (as built
+ * by pull_varattnos), or NULL if it needs all of them.  An AM that stores
+ * columns separately can then avoid reading the others, whose values in the
+ * returned slots are unspecified; an AM that stores whole rows, like the
+ * heap, can ignore this.  Must be called before the first row is fetched;
+ * projcols must live as long as the scan.
+ */
+static inline void
+table_scan_set_projection(TableScanDesc scan, Bitmapset *projcols)
+{
+	scan->rs_projcols = projcols;
+}
+
+
+/* ----------------------------------------------------------------------------
+ * Parallel table scan functions.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * Amount of shared memory needed for the parallel scan state of rel.
+ */
+static inline Size
+table_parallelscan_estimate(Relation rel, Snapshot snapshot)
+{
+	return rel->rd_tableam->parallelscan_estimate(rel, snapshot);
+}
+
+/*
+ * Initialize the parallel scan state in pscan, which must be at least as
+ * large as table_parallelscan_estimate said.
+ */
+static inline void
+table_parallelscan_initialize(Relation rel, ParallelTableScanDesc pscan,
+							  Snapshot snapshot)
+{
+	rel->rd_tableam->parallelscan_initialize(rel, pscan, snapshot);
+}
+
+/*
+ * Reset the parallel scan state before a rescan.
+ */
+static inline void
+table_parallelscan_reinitialize(Relation rel, ParallelTableScanDesc pscan)
+{
+	rel->rd_tableam->parallelscan_reinitialize(rel, pscan);
+}
+
+/*
+ * Join a parallel scan.  The snapshot is taken from pscan.
+ */
+static inline TableScanDesc
+table_beginscan_parallel(Relation rel, ParallelTableScanDesc pscan)
+{
+	return rel->rd_tableam->scan_begin(rel, NULL, 0, NULL, pscan);
+}
+
+
+/* ----------------------------------------------------------------------------
+ * Non-modifying operations on individual tuples.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * Fetch the row version at tid into slot, if it is visible to snapshot.
+ * Returns false, with the slot cleared, otherwise.
+ */
+static inline bool
+table_tuple_fetch_row_version(Relation rel, ItemPointer tid,
+							  Snapshot snapshot, TupleTableSlot *slot)
+{
+	return rel->rd_tableam->tuple_fetch_row_version(rel, tid, snapshot, slot);
+}
+
+
+/* ----------------------------------------------------------------------------
+ * Manipulation of physical tuples.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * Insert the row in slot into rel.  options are the HEAP_INSERT_* flags.
+ * The new row's TID is stored in *tid, for use in index entries.
+ */
+static inline void
+table_tuple_insert(Relation rel, TupleTableSlot *slot, CommandId cid,
+				   int options, BulkInsertState bistate, ItemPointer tid)
+{
+	rel->rd_tableam->tuple_insert(rel, slot, cid, options, bistate, tid);
+}
+
+/*
+ * Insert the row in slot speculatively, as in INSERT ... ON CONFLICT.  The
+ * insertion must be confirmed or killed with table_complete_speculative once
+ * the unique indexes have been checked.
+ */
+static inline void
+table_tuple_insert_speculative(Relation rel, TupleTableSlot *slot,
+							   CommandId cid, int options,
+							   BulkInsertState bistate, uint32 specToken,
+							   ItemPointer tid)
+{
+	rel->rd_tableam->tuple_insert_speculative(rel, slot, cid, options,
+											  bistate, specToken, tid);
+}
+
+/*
+ * Confirm (succeeded = true) or kill a speculatively inserted row.
+ */
+static inline void
+table_complete_speculative(Relation rel, ItemPointer tid, bool succeeded)
+{
+	rel->rd_tableam->tuple_complete_speculative(rel, tid, succeeded);
+}
+
+/*
+ * Delete the row at tid.  The result and *hufd have the same meaning as for
+ * heap_delete.
+ */
+static inline HTSU_Result
+table_delete(Relation rel, ItemPointer tid, CommandId cid,
+			 Snapshot crosscheck, bool wait, HeapUpdateFailureData *hufd,
+			 bool changingPart)
+{
+	return rel->rd_tableam->tuple_delete(rel, tid, cid, crosscheck, wait,
+										 hufd, changingPart);
+}
+
+/*
+ * Replace the row at otid with the one in slot.  The result, *hufd and
+ * *lockmode have the same meaning as for heap_update.  On success, the new
+ * row's TID is stored in *newtid, and *update_indexes tells which indexes
+ * need new entries for it.
+ */
+static inline HTSU_Result
+table_update(Relation rel, ItemPointer otid, TupleTableSlot *slot,
+			 CommandId cid, Snapshot crosscheck, bool wait,
+			 HeapUpdateFailureData *hufd, LockTupleMode *lockmode,
+			 ItemPointer newtid, TU_UpdateIndexes *update_indexes)
+{
+	return rel->rd_tableam->tuple_update(rel, otid, slot, cid, crosscheck,
+										 wait, hufd, lockmode, newtid,
+										 update_indexes);
+}
+
+
+/* ----------------------------------------------------------------------------
+ * Whole-relation operations.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * Perform a non-FULL VACUUM of the relation.
+ */
+static inline void
+table_relation_vacuum(Relation rel, int options,
+					  struct VacuumParams *params,
+					  BufferAccessStrategy bstrategy)
+{
+	rel->rd_tableam->relation_vacuum(rel, options, params, bstrategy);
+}
+
+/*
+ * Estimate the size of the relation for the planner.
+ */
+static inline void
+table_relation_estimate_size(Relation rel, int32 *attr_widths,
+							 BlockNumber *pages, double *tuples,
+							 double *allvisfrac)
+{
+	rel->rd_tableam->relation_estimate_size(rel, attr_widths, pages, tuples,
+											allvisfrac);
+}
+
+
+/* ----------------------------------------------------------------------------
+ * Functions in tableamapi.c
+ * ----------------------------------------------------------------------------
+ */
+
+extern const TableAmRoutine *GetTableAmRoutine(Oid amhandler);
+extern const TableAmRoutine *GetHeapamTableAmRoutine(void);
+extern bool check_default_table_access_method(char **newval, void **extra,
+								  GucSource source);
+
+#endif							/* TABLEAM_H */
@@ -0,0 +1,41 @@
+/*-------------------------------------------------------------------------
+ *
+ * tidstore.h
+ *	  Compact, ordered storage of heap TIDs.
+ *
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/access/tidstore.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef TIDSTORE_H
+#define TIDSTORE_H
+
+#include "storage/block.h"
+#include "storage/itemptr.h"
+#include "storage/off.h"
+
+/* opaque; the struct is a single chunk of memory without pointers */
+typedef struct TidStore TidStore;
+
+extern Size TidStoreSize(Size max_bytes, BlockNumber max_blocks);
+extern TidStore *TidStoreInitialize(void *space, Size size);
+extern TidStore *TidStoreCreate(Size max_bytes, BlockNumber max_blocks);
+extern void TidStoreFree(TidStore *ts);
+extern void TidStoreReset(TidStore *ts);
+
+extern bool TidStoreIsFull(TidStore *ts);
+extern void TidStoreAddBlock(TidStore *ts, BlockNumber blkno,
+				 OffsetNumber *offsets, int noffsets);
+extern bool TidStoreIsMember(TidStore *ts, ItemPointer tid);
+
+extern int64 TidStoreNumTids(TidStore *ts);
+extern int	TidStoreNumBlocks(TidStore *ts);
+extern int64 TidStoreMinCapacity(TidStore *ts);
+extern BlockNumber TidStoreGetBlock(TidStore *ts, int blockindex,
+				 OffsetNumber *offsets, int *noffsets);
+
+#endif							/* TIDSTORE_H */
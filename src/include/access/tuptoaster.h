@@ -95,6 +95,22 @@
 	 sizeof(int32) -									\
 	 VARHDRSZ)
 
+/*
+ * Compression methods for compressed varlenas.  The value is stored in the
+ * two high bits of the raw size word of a compressed datum (see
+ * VARRAWSIZE_4B_C), so these numbers must not change and there can be at
+ * most four of them.
+ */
+typedef enum ToastCompressionId
+{
+	TOAST_PGLZ_COMPRESSION_ID = 0,
+	TOAST_LZ4_COMPRESSION_ID = 1,
+	TOAST_ZSTD_COMPRESSION_ID = 2
+} ToastCompressionId;
+
+/* GUC variable */
+extern int	default_toast_compression;
+
 /* Size of an EXTERNAL datum that contains a standard TOAST pointer */
 #define TOAST_POINTER_SIZE (VARHDRSZ_EXTERNAL + sizeof(varatt_external))
 
@@ -210,7 +226,26 @@ extern HeapTuple toast_build_flattened_tuple(TupleDesc tupleDesc,
  *	Create a compressed version of a varlena datum, if possible
  * ----------
  */
-extern Datum toast_compress_datum(Datum value);
+extern Datum toast_compress_datum(Datum value, int cmethod);
+
+/* ----------
+ * toast_compression_method_name / toast_compression_method_id -
+ *
+ *	Convert between compression method names and ToastCompressionIds
+ * ----------
+ */
+extern const char *toast_compression_method_name(int cmethod);
+extern int	toast_compression_method_id(const char *name);
+extern void toast_validate_compression_option(const char *value);
+
+/* ----------
+ * toast_get_compression_id -
+ *
+ *	Return the compression method of a compressed varlena, or -1 if the
+ *	datum isn't compressed
+ * ----------
+ */
+extern int	toast_get_compression_id(struct varlena *attr);
 
 /* ----------
  * toast_raw_datum_size -
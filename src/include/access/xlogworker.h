@@ -0,0 +1,33 @@
+/*-------------------------------------------------------------------------
+ *
+ * xlogworker.h
+ *		Declarations for parallel WAL replay by recovery workers.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/access/xlogworker.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef XLOGWORKER_H
+#define XLOGWORKER_H
+
+#include "access/xlogreader.h"
+
+/* GUC variable */
+extern int	recovery_workers;
+
+/* true in a recovery worker process */
+extern bool AmRecoveryWorker;
+
+extern void RecoveryWorkerRegister(void);
+extern Size RecoveryWorkerShmemSize(void);
+extern void RecoveryWorkerShmemInit(void);
+extern void RecoveryWorkerMain(Datum main_arg) pg_attribute_noreturn();
+
+/* used by the startup process's redo loop */
+extern bool RecoveryWorkerDispatch(XLogReaderState *record);
+extern void RecoveryWorkerWaitAll(void);
+
+#endif							/* XLOGWORKER_H */
@@ -21,6 +21,7 @@
 #include "catalog/pg_publication_d.h"
 
 #include "catalog/objectaddress.h"
+#include "nodes/bitmapset.h"
 
 /* ----------------
  *		pg_publication definition.  cpp turns this into
@@ -78,16 +79,30 @@ typedef struct Publication
 	PublicationActions pubactions;
 } Publication;
 
+/*
+ * A table to be added to a publication, with its optional column list and
+ * row filter.
+ */
+typedef struct PublicationRelInfo
+{
+	Relation	relation;
+	List	   *columns;		/* column names (Value strings), or NIL */
+	Node	   *whereClause;	/* transformed row filter, or NULL */
+} PublicationRelInfo;
+
 extern Publication *GetPublication(Oid pubid);
 extern Publication *GetPublicationByName(const char *pubname, bool missing_ok);
 extern List *GetRelationPublications(Oid relid);
 extern List *GetPublicationRelations(Oid pubid);
 extern List *GetAllTablesPublications(void);
 extern List *GetAllTablesPublicationRelations(void);
+extern void GetPublicationRelationFilters(Oid pubid, Oid relid,
+							  Bitmapset **columns, Node **qual);
 
 extern bool is_publishable_relation(Relation rel);
-extern ObjectAddress publication_add_relation(Oid pubid, Relation targetrel,
-						 bool if_not_exists);
+extern ObjectAddress publication_add_relation(Oid pubid,
+						 PublicationRelInfo *pri, bool if_not_exists);
+extern void publication_check_relation_filters(Oid pubid);
 
 extern Oid	get_publication_oid(const char *pubname, bool missing_ok);
 extern char *get_publication_name(Oid pubid, bool missing_ok);
@@ -31,6 +31,13 @@ CATALOG(pg_publication_rel,6106,PublicationRelRelationId)
 	Oid			oid;			/* oid */
 	Oid			prpubid;		/* Oid of the publication */
 	Oid			prrelid;		/* Oid of the relation */
+
+#ifdef CATALOG_VARLEN
+	int2vector	prattrs BKI_FORCE_NULL;	/* published columns, or NULL for
+										 * all columns */
+	pg_node_tree prqual;		/* row filter (nodeToString representation),
+								 * or NULL for all rows */
+#endif
 } FormData_pg_publication_rel;
 
 /* ----------------
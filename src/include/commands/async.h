@@ -17,12 +17,8 @@
 
 #include "fmgr.h"
 
-/*
- * The number of SLRU page buffers we use for the notification queue.
- */
-#define NUM_ASYNC_BUFFERS	8
-
 extern bool Trace_notify;
+extern int	notify_buffers;
 extern volatile sig_atomic_t notifyInterruptPending;
 
 extern Size AsyncShmemSize(void);
@@ -37,6 +33,7 @@ extern void Async_Notify(const char *channel, const char *payload);
 extern void Async_Listen(const char *channel);
 extern void Async_Unlisten(const char *channel);
 extern void Async_UnlistenAll(void);
+extern bool IsListeningOnAnyChannel(void);
 
 /* perform (or cancel) outbound notify processing at transaction commit */
 extern void PreCommit_Notify(void);
@@ -30,4 +30,9 @@ extern DestReceiver *CreateTransientRelDestReceiver(Oid oid);
 
 extern bool MatViewIncrementalMaintenanceIsEnabled(void);
 
+extern void CreateMatViewMaintenanceTriggers(Oid matviewOid, Query *viewQuery);
+extern void AtEOXact_MatView(bool isCommit);
+extern void AtEOSubXact_MatView(bool isCommit, SubTransactionId mySubid,
+					SubTransactionId parentSubid);
+
 #endif							/* MATVIEW_H */
@@ -14,6 +14,9 @@
 #ifndef KWLOOKUP_H
 #define KWLOOKUP_H
 
+/* Hash function used by ScanKeywordLookup */
+typedef int (*ScanKeywordHashFunc) (const void *key, size_t keylen);
+
 /*
  * This struct contains the data needed by ScanKeywordLookup to perform a
  * search within a set of keywords.  The contents are typically generated by
@@ -23,6 +26,7 @@ typedef struct ScanKeywordList
 {
 	const char *kw_string;		/* all keywords in order, separated by \0 */
 	const uint16 *kw_offsets;	/* offsets to the start of each keyword */
+	ScanKeywordHashFunc hash;	/* perfect hash function for keywords */
 	int			num_keywords;	/* number of keywords */
 	int			max_kw_len;		/* length of longest keyword */
 } ScanKeywordList;
@@ -226,6 +226,7 @@ typedef enum ExprEvalOp
 	EEOP_AGG_STRICT_INPUT_CHECK,
 	EEOP_AGG_INIT_TRANS,
 	EEOP_AGG_STRICT_TRANS_CHECK,
+	EEOP_AGG_PLAIN_PERGROUP_NULLCHECK,
 	EEOP_AGG_PLAIN_TRANS_BYVAL,
 	EEOP_AGG_PLAIN_TRANS,
 	EEOP_AGG_ORDERED_TRANS_DATUM,
@@ -631,6 +632,14 @@ typedef struct ExprEvalStep
 			int			jumpnull;
 		}			agg_strict_trans_check;
 
+		/* for EEOP_AGG_PLAIN_PERGROUP_NULLCHECK */
+		struct
+		{
+			AggState   *aggstate;
+			int			setoff;
+			int			jumpnull;
+		}			agg_plain_pergroup_nullcheck;
+
 		/* for EEOP_AGG_{PLAIN,ORDERED}_TRANS* */
 		struct
 		{
@@ -110,6 +110,16 @@ typedef struct HashSkewBucket
 #define SKEW_WORK_MEM_PERCENT  2
 #define SKEW_MIN_OUTER_FRACTION  0.01
 
+/*
+ * Parallel Hash has no skew hashtable, because both sides are partitioned
+ * before any batch is probed.  Instead, while growing the number of batches,
+ * a batch that keeps at least PHJ_SKEW_FRACTION of its parent's tuples is
+ * assumed to be dominated by a few common hash values.  It is marked as
+ * skewed and allowed to exceed the memory budget, rather than making every
+ * other batch split again in a futile attempt to shrink it.
+ */
+#define PHJ_SKEW_FRACTION  0.95
+
 /*
  * To reduce palloc overhead, the HashJoinTuples for the current batch are
  * packed in 32kB buffers instead of pallocing each tuple individually.
@@ -159,6 +169,7 @@ typedef struct ParallelHashJoinBatch
 	size_t		ntuples;		/* number of tuples loaded */
 	size_t		old_ntuples;	/* number of tuples before repartitioning */
 	bool		space_exhausted;
+	bool		skewed;			/* too skewed to be shrunk by repartitioning */
 
 	/*
 	 * Variable-sized SharedTuplestore objects follow this struct in memory.
@@ -223,7 +234,7 @@ typedef enum ParallelHashGrowth
 	PHJ_GROWTH_NEED_MORE_BUCKETS,
 	/* The memory budget would be exhausted, so we need to repartition. */
 	PHJ_GROWTH_NEED_MORE_BATCHES,
-	/* Repartitioning didn't help last time, so don't try to do that again. */
+	/* The batches are fixed, or we can't add more, so don't try again. */
 	PHJ_GROWTH_DISABLED
 } ParallelHashGrowth;
 
@@ -355,6 +366,7 @@ typedef struct HashJoinTableData
 	dsa_area   *area;			/* DSA area to allocate memory from */
 	ParallelHashJoinState *parallel_state;
 	ParallelHashJoinBatchAccessor *batches;
+	int		   *batch_order;	/* batch numbers, largest first */
 	dsa_pointer current_chunk_shared;
 }			HashJoinTableData;
 
@@ -17,6 +17,23 @@
 #include "nodes/execnodes.h"
 
 
+/*
+ * AggDistinctHashData - hashed deduplication of a DISTINCT aggregate's input
+ *
+ * When every DISTINCT column is hashable, each input value is first looked
+ * up in a hash table, so that only distinct values are ever sorted (or, for
+ * aggregates that don't care about input order, sorting is skipped
+ * entirely).  If the table outgrows work_mem, its contents are moved into
+ * the regular sort object and the rest of the group is handled by sorting.
+ */
+typedef struct AggDistinctHashData
+{
+	TupleHashTable hashtable;	/* distinct input values seen so far */
+	MemoryContext tablecxt;		/* memory holding the table's entries */
+	Size		spaceUsed;		/* approximate size of the entries */
+	bool		spilled;		/* values moved to the sortstate? */
+} AggDistinctHashData;
+
 /*
  * AggStatePerTransData - per aggregate state value information
  *
@@ -109,6 +126,17 @@ typedef struct AggStatePerTransData
 	FmgrInfo	equalfnOne;
 	ExprState  *equalfnMulti;
 
+	/*
+	 * Set up when the DISTINCT input is deduplicated by hashing.  If
+	 * distinctUnordered, the aggregate's result doesn't depend on the order
+	 * of its input (it has no ORDER BY, and has a combine function, so it's
+	 * already fed in arbitrary order by parallel aggregation), and the
+	 * hashed values are passed to the transfn without sorting them.
+	 */
+	bool		hashDistinct;
+	bool		distinctUnordered;
+	TupleTableSlot *distinctslot;	/* for reading hashtable entries */
+
 	/*
 	 * initial value from pg_aggregate entry
 	 */
@@ -151,6 +179,7 @@ typedef struct AggStatePerTransData
 	 */
 
 	Tuplesortstate **sortstates;	/* sort objects, if DISTINCT or ORDER BY */
+	AggDistinctHashData *distincthashes;	/* if hashDistinct */
 
 	/*
 	 * This field is a pre-initialized FunctionCallInfo struct used for
@@ -310,6 +339,9 @@ extern void ExecEndAgg(AggState *node);
 extern void ExecReScanAgg(AggState *node);
 
 extern Size hash_agg_entry_size(int numAggs);
+extern void ExecAggDistinctHashInsert(AggState *aggstate,
+						  AggStatePerTrans pertrans,
+						  int setno, TupleTableSlot *slot);
 
 extern Datum aggregate_dummy(PG_FUNCTION_ARGS);
 
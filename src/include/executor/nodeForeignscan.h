@@ -31,4 +31,7 @@ extern void ExecForeignScanInitializeWorker(ForeignScanState *node,
 								ParallelWorkerContext *pwcxt);
 extern void ExecShutdownForeignScan(ForeignScanState *node);
 
+extern bool ExecForeignScanAsyncCapable(ForeignScanState *node);
+extern pgsocket ExecForeignScanAsyncRequest(ForeignScanState *node);
+
 #endif							/* NODEFOREIGNSCAN_H */
@@ -19,4 +19,13 @@ extern ModifyTableState *ExecInitModifyTable(ModifyTable *node, EState *estate,
 extern void ExecEndModifyTable(ModifyTableState *node);
 extern void ExecReScanModifyTable(ModifyTableState *node);
 
+extern void ExecSetForeignInsertBatchSize(ResultRelInfo *resultRelInfo);
+extern bool ExecForeignInsertCanBatch(ModifyTableState *mtstate,
+						  ResultRelInfo *resultRelInfo);
+extern int ExecForeignInsertBuffer(ModifyTableState *mtstate,
+						ResultRelInfo *resultRelInfo,
+						TupleTableSlot *slot, TupleTableSlot *planSlot);
+extern int	ExecForeignInsertFlush(ModifyTableState *mtstate,
+					   ResultRelInfo *resultRelInfo);
+
 #endif							/* NODEMODIFYTABLE_H */
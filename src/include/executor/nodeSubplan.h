@@ -14,6 +14,7 @@
 #ifndef NODESUBPLAN_H
 #define NODESUBPLAN_H
 
+#include "access/parallel.h"
 #include "nodes/execnodes.h"
 
 extern SubPlanState *ExecInitSubPlan(SubPlan *subplan, PlanState *parent);
@@ -30,4 +31,8 @@ extern void ExecSetParamPlan(SubPlanState *node, ExprContext *econtext);
 
 extern void ExecSetParamPlanMulti(const Bitmapset *params, ExprContext *econtext);
 
+extern void ExecSubPlanEstimate(SubPlanState *node, ParallelContext *pcxt);
+extern void ExecSubPlanInitializeDSM(SubPlanState *node, ParallelContext *pcxt);
+extern void ExecSubPlanInitializeWorker(SubPlanState *node, ParallelWorkerContext *pwcxt);
+
 #endif							/* NODESUBPLAN_H */
@@ -246,6 +246,7 @@ typedef struct HeapTupleTableSlot
 	HeapTuple	tuple;		/* physical tuple */
 #define FIELDNO_HEAPTUPLETABLESLOT_OFF 2
 	uint32		off;		/* saved state for slot_deform_heap_tuple */
+	HeapTupleData tupdata;	/* optional workspace for storing tuple */
 } HeapTupleTableSlot;
 
 /* heap tuple residing in a buffer */
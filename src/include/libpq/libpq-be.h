@@ -128,6 +128,16 @@ typedef struct Port
 	char	   *remote_port;	/* text rep of remote port */
 	CAC_state	canAcceptConnections;	/* postmaster connection status */
 
+	/*
+	 * Set for connections made by the connection proxy.  raddr and the
+	 * fields derived from it then describe the client the proxy is acting
+	 * for.  proxy_authenticated means that the connection was accepted on
+	 * the strength of the proxy's key alone, because the backend is being
+	 * started for the proxy's session pool rather than for a client.
+	 */
+	bool		proxied;
+	bool		proxy_authenticated;
+
 	/*
 	 * Information that needs to be saved from the startup packet and passed
 	 * into backend execution.  "char *" fields are NULL if not set.
@@ -145,6 +155,12 @@ typedef struct Port
 	 */
 	char	   *application_name;
 
+	/* Whether the startup packet asked for compression of the traffic. */
+	bool		compression;
+
+	/* Rows per DataRowBatch message asked for, or 0 to send DataRows. */
+	int			row_batch_size;
+
 	/*
 	 * Information that needs to be held during the authentication cycle.
 	 */
@@ -70,6 +70,7 @@ extern int	pq_getmessage(StringInfo s, int maxlen);
 extern int	pq_getbyte(void);
 extern int	pq_peekbyte(void);
 extern int	pq_getbyte_if_available(unsigned char *c);
+extern void pq_start_compression(void);
 extern int	pq_putbytes(const char *s, size_t len);
 
 /*
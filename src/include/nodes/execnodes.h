@@ -18,6 +18,7 @@
 #include "access/heapam.h"
 #include "access/tupconvert.h"
 #include "executor/instrument.h"
+#include "lib/ilist.h"
 #include "lib/pairingheap.h"
 #include "nodes/params.h"
 #include "nodes/plannodes.h"
@@ -138,6 +139,7 @@ typedef struct ExprState
  *		UniqueStrats
  *		Unique				is it a unique index?
  *		ReadyForInserts		is it valid for inserts?
+ *		Summarizing			is it a summarizing index?
  *		Concurrent			are we doing a concurrent index build?
  *		BrokenHotChain		did we detect any broken HOT chains?
  *		ParallelWorkers		# of workers requested (excludes leader)
@@ -167,6 +169,7 @@ typedef struct IndexInfo
 	uint16	   *ii_UniqueStrats;	/* array with one entry per column */
 	bool		ii_Unique;
 	bool		ii_ReadyForInserts;
+	bool		ii_Summarizing;
 	bool		ii_Concurrent;
 	bool		ii_BrokenHotChain;
 	int			ii_ParallelWorkers;
@@ -437,6 +440,30 @@ typedef struct ResultRelInfo
 	/* true when modifying foreign table directly */
 	bool		ri_usesFdwDirectModify;
 
+	/*
+	 * Rows queued up for a batched foreign-table insert: ri_BatchSize is the
+	 * most the FDW accepts at once (0 or 1 means no batching), ri_NumSlots
+	 * how many are queued right now, ri_NumSlotsInitialized how many of the
+	 * slots in ri_Slots and ri_PlanSlots have been created so far.
+	 */
+	int			ri_BatchSize;
+	int			ri_NumSlots;
+	int			ri_NumSlotsInitialized;
+	TupleTableSlot **ri_Slots;
+	TupleTableSlot **ri_PlanSlots;
+
+	/*
+	 * Tuples queued up for heap_multi_insert into a heap result rel:
+	 * ri_NumBufferedTuples of them are in ri_BufferedTuples, taking up
+	 * ri_BufferedBytes.  ri_BufferedSlot is used to insert their index
+	 * entries, and ri_BulkInsertState keeps the target page between batches.
+	 */
+	HeapTuple  *ri_BufferedTuples;
+	int			ri_NumBufferedTuples;
+	Size		ri_BufferedBytes;
+	TupleTableSlot *ri_BufferedSlot;
+	BulkInsertState ri_BulkInsertState;
+
 	/* list of WithCheckOption's to be checked */
 	List	   *ri_WithCheckOptions;
 
@@ -472,6 +499,9 @@ typedef struct ResultRelInfo
 
 	/* Additional information specific to partition tuple routing */
 	struct PartitionRoutingInfo *ri_PartitionInfo;
+
+	/* For use by copy.c when performing multi-inserts */
+	struct CopyMultiInsertBuffer *ri_CopyMultiInsertBuffer;
 } ResultRelInfo;
 
 /* ----------------
@@ -863,6 +893,10 @@ typedef struct SubPlanState
 	FmgrInfo   *lhs_hash_funcs; /* hash functions for lefthand datatype(s) */
 	FmgrInfo   *cur_eq_funcs;	/* equality functions for LHS vs. table */
 	ExprState  *cur_eq_comp;	/* equality comparator for LHS vs. table */
+	/* these are used when the hash table is shared in parallel query: */
+	struct SubPlanHashShared *hash_shared;	/* shared state, or NULL */
+	bool		hash_attached;	/* using the shared table(s)? */
+	TupleTableSlot *sharedslot; /* for examining shared table entries */
 } SubPlanState;
 
 /* ----------------
@@ -945,6 +979,8 @@ typedef struct PlanState
 	/* Per-worker JIT instrumentation */
 	struct SharedJitInstrumentation *worker_jit_instrument;
 
+	bool		misestimate_logged; /* reported a row count misestimate? */
+
 	/*
 	 * Common structural data for all Plan types.  These links to subsidiary
 	 * state trees parallel links in the associated plan tree (except for the
@@ -1129,6 +1165,33 @@ typedef struct ModifyTableState
 
 	/* Per plan map for tuple conversion from child to root */
 	TupleConversionMap **mt_per_subplan_tupconv_maps;
+
+	/* foreign result rels that have had rows queued for a batched insert */
+	List	   *mt_batchrels;
+
+	/* heap result rels that have had rows queued for heap_multi_insert */
+	List	   *mt_multiinsertrels;
+
+	/*
+	 * INSERT ... ON CONFLICT rows queued up for a batch of arbiter index
+	 * probes: mt_upsert_nslots are queued right now, mt_upsert_nslots_init
+	 * slots have been created so far.  mt_upsert_cxt holds the index keys
+	 * computed for sorting a batch.
+	 */
+	TupleTableSlot **mt_upsert_slots;
+	TupleTableSlot **mt_upsert_planslots;
+	int			mt_upsert_nslots;
+	int			mt_upsert_nslots_init;
+	MemoryContext mt_upsert_cxt;
+
+	/*
+	 * When mt_upsert_probed is set, ExecInsert uses mt_upsert_found and
+	 * mt_upsert_conflictTid as the result of its first pre-check, instead of
+	 * probing the arbiter index again.
+	 */
+	bool		mt_upsert_probed;
+	bool		mt_upsert_found;
+	ItemPointerData mt_upsert_conflictTid;
 } ModifyTableState;
 
 /* ----------------
@@ -1141,6 +1204,11 @@ typedef struct ModifyTableState
  *							eliminated from the scan, or NULL if not possible.
  *		valid_subplans		for runtime pruning, valid appendplans indexes to
  *							scan.
+ *		asyncplans			appendplans indexes of asynchronous-capable
+ *							foreign scans, or NULL if none.
+ *		remaining			when asyncplans is not NULL, the valid subplans
+ *							that have not been scanned to completion yet.
+ *		async_begun			have the asynchronous subplans been started?
  * ----------------
  */
 
@@ -1163,6 +1231,9 @@ struct AppendState
 	struct PartitionPruneState *as_prune_state;
 	Bitmapset  *as_valid_subplans;
 	bool		(*choose_next_subplan) (AppendState *);
+	Bitmapset  *as_asyncplans;
+	Bitmapset  *as_remaining;
+	bool		as_async_begun;
 };
 
 /* ----------------
@@ -1268,8 +1339,9 @@ typedef struct ScanState
 {
 	PlanState	ps;				/* its first field is NodeTag */
 	Relation	ss_currentRelation;
-	HeapScanDesc ss_currentScanDesc;
+	struct TableScanDescData *ss_currentScanDesc;
 	TupleTableSlot *ss_ScanTupleSlot;
+	List	   *ss_HashJoinFilters; /* HashJoinFilters pushed down to us */
 } ScanState;
 
 /* ----------------
@@ -1279,7 +1351,9 @@ typedef struct ScanState
 typedef struct SeqScanState
 {
 	ScanState	ss;				/* its first field is NodeTag */
-	Size		pscan_len;		/* size of parallel heap scan descriptor */
+	Size		pscan_len;		/* size of parallel table scan descriptor */
+	Bitmapset  *projcols;		/* columns referenced by the plan node, or
+								 * NULL if all are needed */
 } SeqScanState;
 
 /* ----------------
@@ -1337,6 +1411,7 @@ typedef struct
  *		RuntimeContext	   expr context for evaling runtime Skeys
  *		RelationDesc	   index relation descriptor
  *		ScanDesc		   index scan descriptor
+ *		PrefetchMaximum	   max heap blocks to prefetch ahead, 0 = none
  *
  *		ReorderQueue	   tuples that need reordering due to re-check
  *		ReachedEnd		   have we fetched all tuples from index already?
@@ -1363,6 +1438,7 @@ typedef struct IndexScanState
 	ExprContext *iss_RuntimeContext;
 	Relation	iss_RelationDesc;
 	IndexScanDesc iss_ScanDesc;
+	int			iss_PrefetchMaximum;
 
 	/* These are needed for re-checking ORDER BY expr ordering */
 	pairingheap *iss_ReorderQueue;
@@ -1559,6 +1635,24 @@ typedef struct TidScanState
 	HeapTupleData tss_htup;
 } TidScanState;
 
+/* ----------------
+ *	 TidRangeScanState information
+ *
+ *		trss_tidexprs		list of TidOpExpr structs (see nodeTidrangescan.c)
+ *		trss_mintid			the lowest TID in the scan range
+ *		trss_maxtid			the highest TID in the scan range
+ *		trss_inScan			is a scan currently in progress?
+ * ----------------
+ */
+typedef struct TidRangeScanState
+{
+	ScanState	ss;				/* its first field is NodeTag */
+	List	   *trss_tidexprs;
+	ItemPointerData trss_mintid;
+	ItemPointerData trss_maxtid;
+	bool		trss_inScan;
+} TidRangeScanState;
+
 /* ----------------
  *	 SubqueryScanState information
  *
@@ -1863,6 +1957,27 @@ typedef struct MergeJoinState
 typedef struct HashJoinTupleData *HashJoinTuple;
 typedef struct HashJoinTableData *HashJoinTable;
 
+/* ----------------
+ *	 HashJoinFilter information
+ *
+ *		A Bloom filter of the hash values of a hash join's inner tuples,
+ *		which the join hands to a scan node on its outer side so that rows
+ *		that cannot find a join partner are discarded as soon as they are
+ *		fetched.  The filter is inactive (bloom == NULL) until the join has
+ *		built its hash table, and is switched off again if it turns out not
+ *		to reject enough rows to pay for itself.
+ * ----------------
+ */
+typedef struct HashJoinFilter
+{
+	HashJoinTable hashtable;	/* join's hash table, for its hash functions */
+	struct bloom_filter *bloom; /* filter, or NULL if inactive */
+	List	   *hashkeys;		/* list of ExprState nodes, evaluated on the
+								 * scan node's scan tuple */
+	double		nchecked;		/* # of rows tested since activation */
+	double		nrejected;		/* # of those that were discarded */
+} HashJoinFilter;
+
 typedef struct HashJoinState
 {
 	JoinState	js;				/* its first field is NodeTag */
@@ -1871,6 +1986,7 @@ typedef struct HashJoinState
 	List	   *hj_InnerHashKeys;	/* list of ExprState nodes */
 	List	   *hj_HashOperators;	/* list of operator OIDs */
 	HashJoinTable hj_HashTable;
+	HashJoinFilter *hj_Filter;	/* filter pushed to outer scan, or NULL */
 	uint32		hj_CurHashValue;
 	int			hj_CurBucketNo;
 	int			hj_CurSkewBucketNo;
@@ -1908,6 +2024,69 @@ typedef struct MaterialState
 	Tuplestorestate *tuplestorestate;
 } MaterialState;
 
+struct MemoizeEntry;
+struct MemoizeTuple;
+struct MemoizeKey;
+
+/* ----------------
+ *	 MemoizeInstrumentation information
+ * ----------------
+ */
+typedef struct MemoizeInstrumentation
+{
+	uint64		cache_hits;		/* number of rescans where we've found the
+								 * scan parameter values to be cached */
+	uint64		cache_misses;	/* number of rescans where we've not found the
+								 * scan parameter values to be cached */
+	uint64		cache_evictions;	/* number of cache entries removed due to
+									 * the need to free memory */
+	uint64		cache_overflows;	/* number of times we've had to bypass the
+									 * cache when filling it due to not being
+									 * able to free enough space to store the
+									 * current scan's tuples */
+	uint64		mem_peak;		/* peak memory usage in bytes */
+} MemoizeInstrumentation;
+
+/* ----------------
+ *	 MemoizeState information
+ *
+ *		memoize nodes are used to cache recent and commonly seen results
+ *		from a parameterized scan.  The cache is keyed by the values of the
+ *		scan's parameters and is bounded by work_mem; the least recently
+ *		used entries are evicted when it fills up.
+ * ----------------
+ */
+typedef struct MemoizeState
+{
+	ScanState	ss;				/* its first field is NodeTag */
+	int			mstatus;		/* value of ExecMemoize state machine */
+	int			nkeys;			/* number of cache keys */
+	struct memoize_hash *hashtable; /* hash table for cache entries */
+	TupleDesc	hashkeydesc;	/* tuple descriptor for cache keys */
+	TupleTableSlot *tableslot;	/* min tuple slot for existing cache entries */
+	TupleTableSlot *probeslot;	/* virtual slot used for hash lookups */
+	ExprState  *cache_eq_expr;	/* Compare exec params to hash key */
+	ExprState **param_exprs;	/* exprs containing the parameters to this
+								 * node */
+	FmgrInfo   *hashfunctions;	/* lookup data for hash funcs nkeys in size */
+	Oid		   *collations;		/* collation for comparisons nkeys in size */
+	uint64		mem_used;		/* bytes of memory used by cache */
+	uint64		mem_limit;		/* memory limit in bytes for the cache */
+	MemoryContext tableContext; /* memory context to store cache data */
+	dlist_head	lru_list;		/* least recently used entry list */
+	struct MemoizeTuple *last_tuple;	/* Used to point to the last tuple
+										 * returned during a cache hit and the
+										 * tuple we last stored when
+										 * populating the cache. */
+	struct MemoizeEntry *entry; /* the entry that 'last_tuple' belongs to or
+								 * NULL if 'last_tuple' is NULL. */
+	bool		singlerow;		/* true if the cache entry is to be marked as
+								 * complete after caching the first tuple. */
+	MemoizeInstrumentation stats;	/* execution statistics */
+	Bitmapset  *keyparamids;	/* Param->paramids of expressions belonging to
+								 * param_exprs */
+} MemoizeState;
+
 /* ----------------
  *	 Shared memory container for per-worker sort information
  * ----------------
@@ -1936,6 +2115,32 @@ typedef struct SortState
 	SharedSortInfo *shared_info;	/* one entry per worker */
 } SortState;
 
+/* ----------------
+ *	 IncrementalSortState information
+ *
+ *	 Input tuples are collected into batches that end where the presorted
+ *	 columns change, and each batch is sorted on its own.  A batch spans
+ *	 several groups if they are small, to spread the per-sort overhead;
+ *	 that doesn't change the result since all sort columns are compared.
+ * ----------------
+ */
+typedef struct IncrementalSortState
+{
+	ScanState	ss;				/* its first field is NodeTag */
+	bool		bounded;		/* is the result set bounded? */
+	int64		bound;			/* if bounded, how many tuples are needed */
+	int64		nreturned;		/* # of tuples returned so far */
+	bool		batch_sorted;	/* returning tuples of a sorted batch? */
+	bool		input_done;		/* outer plan exhausted? */
+	ExprState  *presorted_eq;	/* do presorted columns of two tuples match? */
+	TupleTableSlot *group_pivot;	/* tuple the next one must match */
+	TupleTableSlot *transfer_tuple; /* first tuple of the next batch */
+	void	   *tuplesortstate; /* private state of tuplesort.c */
+	/* for EXPLAIN ANALYZE: */
+	int64		nbatches;		/* # of batches sorted */
+	TuplesortInstrumentation sinstrument;	/* stats of the largest sort */
+} IncrementalSortState;
+
 /* ---------------------
  *	GroupState information
  * ---------------------
@@ -2016,6 +2221,20 @@ typedef struct AggState
 	AggStatePerGroup *all_pergroups;	/* array of first ->pergroups, than
 										 * ->hash_pergroup */
 	ProjectionInfo *combinedproj;	/* projection machinery */
+	/* these fields are used when hashed aggregation spills to disk: */
+	bool		hash_can_spill; /* may groups be spilled to disk at all? */
+	bool		hash_spill_mode;	/* no new groups fit; spill their tuples */
+	Size		hash_trans_space;	/* est. by-ref transition space per group */
+	long		hash_ngroups_limit; /* max # of groups to keep in memory */
+	long		hash_ngroups_current;	/* # of groups in the hash table */
+	double		hash_ngroups_est;	/* est. # of groups in current input */
+	int			hash_used_bits; /* # of hash bits consumed by partitioning */
+	struct HashAggSpill **hash_spills;	/* per hashed grouping set, the
+										 * partitions being written, if any */
+	List	   *hash_batches;	/* spilled partitions yet to be processed */
+	TupleTableSlot *hash_spill_slot;	/* slot for reading spilled tuples */
+	int			hash_batches_used;	/* # of batches processed, for EXPLAIN */
+	long		hash_disk_used; /* kB of temp file space used, for EXPLAIN */
 } AggState;
 
 /* ----------------
@@ -2058,6 +2277,7 @@ typedef struct WindowAggState
 	ExprState  *endOffset;		/* expression for ending bound offset */
 	Datum		startOffsetValue;	/* result of startOffset evaluation */
 	Datum		endOffsetValue; /* result of endOffset evaluation */
+	ExprState  *runcondition;	/* once false, skip rest of partition */
 
 	/* these fields are used with RANGE offset PRECEDING/FOLLOWING: */
 	FmgrInfo	startInRangeFunc;	/* in_range function for startOffset */
@@ -2147,7 +2367,9 @@ typedef struct GatherState
  *
  *		Gather merge nodes launch 1 or more parallel workers, run a
  *		subplan which produces sorted output in each worker, and then
- *		merge the results into a single sorted stream.
+ *		merge the results into a single sorted stream.  If the workers
+ *		produce disjoint ranges of the output, their results are just
+ *		concatenated instead.
  * ----------------
  */
 struct GMReaderTupleBuffer;		/* private in nodeGatherMerge.c */
@@ -2172,8 +2394,44 @@ typedef struct GatherMergeState
 	struct TupleQueueReader **reader;	/* array with nreaders active entries */
 	struct GMReaderTupleBuffer *gm_tuple_buffers;	/* nreaders tuple buffers */
 	struct binaryheap *gm_heap; /* binary heap of slot indices */
+	int			gm_concat_source;	/* slot index being read, if concat_ranges */
 } GatherMergeState;
 
+/* ----------------
+ * RedistributeState information
+ *
+ *		A Redistribute node exchanges tuples with the Redistribute nodes of the
+ *		other workers through a matrix of shared memory queues, one for each
+ *		ordered pair of participants.
+ * ----------------
+ */
+struct ParallelRedistributeState;	/* private in nodeRedistribute.c */
+
+typedef struct RedistributeState
+{
+	PlanState	ps;				/* its first field is NodeTag */
+	FmgrInfo   *hashfunctions;	/* per-column hash functions */
+	SortSupport rangesortkey;	/* comparator for range partitioning */
+	TupleTableSlot *funnel_slot;	/* for tuples received from other workers */
+	struct ParallelRedistributeState *pstate;	/* shared state, or NULL */
+	bool		am_worker;		/* are we in a parallel worker? */
+	/* all remaining fields are only used in a worker: */
+	struct dsm_segment *seg;	/* segment holding the queues */
+	bool		initialized;	/* queues attached? */
+	bool		outer_done;		/* has our subplan been exhausted? */
+	int			nparticipants;	/* number of participating workers */
+	int			myindex;		/* our participant number */
+	int			nsplitters;		/* number of range boundaries */
+	Datum	   *splitters;		/* upper bound of each participant's range */
+	struct shm_mq_handle **senders; /* outgoing queue of each destination */
+	HeapTuple  *pending;		/* tuple not yet fully sent, per destination */
+	int			npending;		/* number of non-NULL pending entries */
+	int			nreaders;		/* number of sources not yet finished */
+	int			nextreader;		/* next one to try to read from */
+	struct shm_mq_handle **receivers;	/* array with nreaders active entries */
+	struct TupleQueueReader **readers;	/* and the readers for them */
+} RedistributeState;
+
 /* ----------------
  *	 Values displayed by EXPLAIN ANALYZE
  * ----------------
@@ -2207,6 +2465,7 @@ typedef struct HashState
 	HashJoinTable hashtable;	/* hash table for the hashjoin */
 	List	   *hashkeys;		/* list of ExprState nodes */
 	/* hashkeys is same as parent's hj_InnerHashKeys */
+	struct bloom_filter *bloom; /* if not NULL, add inner hash values here */
 
 	SharedHashInfo *shared_info;	/* one entry per worker */
 	HashInstrumentation *hinstrument;	/* this worker's entry */
@@ -237,6 +237,7 @@ typedef struct ModifyTable
 	Node	   *onConflictWhere;	/* WHERE for ON CONFLICT UPDATE */
 	Index		exclRelRTI;		/* RTI of the EXCLUDED pseudo relation */
 	List	   *exclRelTlist;	/* tlist of the EXCLUDED pseudo relation */
+	bool		canMultiInsert; /* INSERT may queue rows for heap_multi_insert */
 } ModifyTable;
 
 struct PartitionPruneInfo;		/* forward reference to struct below */
@@ -404,6 +405,7 @@ typedef struct IndexScan
 	List	   *indexorderbyorig;	/* the same in original form */
 	List	   *indexorderbyops;	/* OIDs of sort ops for ORDER BY exprs */
 	ScanDirection indexorderdir;	/* forward or backward or don't care */
+	bool		indexskip;		/* skip over leading column's values? */
 } IndexScan;
 
 /* ----------------
@@ -431,6 +433,7 @@ typedef struct IndexOnlyScan
 	List	   *indexorderby;	/* list of index ORDER BY exprs */
 	List	   *indextlist;		/* TargetEntry list describing index's cols */
 	ScanDirection indexorderdir;	/* forward or backward or don't care */
+	bool		indexskip;		/* skip over leading column's values? */
 } IndexOnlyScan;
 
 /* ----------------
@@ -457,6 +460,7 @@ typedef struct BitmapIndexScan
 	bool		isshared;		/* Create shared bitmap if set */
 	List	   *indexqual;		/* list of index quals (OpExprs) */
 	List	   *indexqualorig;	/* the same in original form */
+	bool		indexskip;		/* skip over leading column's values? */
 } BitmapIndexScan;
 
 /* ----------------
@@ -488,6 +492,19 @@ typedef struct TidScan
 	List	   *tidquals;		/* qual(s) involving CTID = something */
 } TidScan;
 
+/* ----------------
+ *		tid range scan node
+ *
+ * tidrangequals is an implicitly AND'ed list of qual expressions of the form
+ * "CTID relop pseudoconstant", where relop is one of >,>=,<,<=.
+ * ----------------
+ */
+typedef struct TidRangeScan
+{
+	Scan		scan;
+	List	   *tidrangequals;	/* qual(s) involving CTID op something */
+} TidRangeScan;
+
 /* ----------------
  *		subquery scan node
  *
@@ -747,6 +764,33 @@ typedef struct Material
 	Plan		plan;
 } Material;
 
+/* ----------------
+ *		memoize node
+ *
+ * Caches the results of its parameterized subplan, keyed by the values of
+ * param_exprs, so that rescans with previously seen parameter values can be
+ * answered without executing the subplan again.
+ * ----------------
+ */
+typedef struct Memoize
+{
+	Plan		plan;
+
+	int			numKeys;		/* size of the two arrays below */
+
+	Oid		   *hashOperators;	/* hash operators for each key */
+	Oid		   *collations;		/* collations for each key */
+	List	   *param_exprs;	/* cache keys in the form of exprs containing
+								 * parameters */
+	bool		singlerow;		/* true if the cache entry should be marked as
+								 * complete after we store the first tuple in
+								 * it. */
+	uint32		est_entries;	/* The maximum number of entries that the
+								 * planner expects will fit in the cache, or 0
+								 * if unknown */
+	Bitmapset  *keyparamids;	/* paramids from param_exprs */
+} Memoize;
+
 /* ----------------
  *		sort node
  * ----------------
@@ -761,6 +805,19 @@ typedef struct Sort
 	bool	   *nullsFirst;		/* NULLS FIRST/LAST directions */
 } Sort;
 
+/* ----------------
+ *		incremental sort node
+ *
+ * The input is already sorted on the first nPresortedCols sort columns;
+ * each run of tuples with equal values in those is sorted separately.
+ * ----------------
+ */
+typedef struct IncrementalSort
+{
+	Sort		sort;
+	int			nPresortedCols; /* number of presorted columns */
+} IncrementalSort;
+
 /* ---------------
  *	 group node -
  *		Used for queries with GROUP BY (but no aggregates) specified.
@@ -821,6 +878,7 @@ typedef struct WindowAgg
 	int			frameOptions;	/* frame_clause options, see WindowDef */
 	Node	   *startOffset;	/* expression for starting bound, if any */
 	Node	   *endOffset;		/* expression for ending bound, if any */
+	List	   *runCondition;	/* once false, skip rest of partition */
 	/* these fields are used with RANGE offset PRECEDING/FOLLOWING: */
 	Oid			startInRangeFunc;	/* in_range function for startOffset */
 	Oid			endInRangeFunc; /* in_range function for endOffset */
@@ -878,10 +936,40 @@ typedef struct GatherMerge
 	Oid		   *sortOperators;	/* OIDs of operators to sort them by */
 	Oid		   *collations;		/* OIDs of collations */
 	bool	   *nullsFirst;		/* NULLS FIRST/LAST directions */
+	bool		concat_ranges;	/* workers return disjoint, ordered ranges */
 	Bitmapset  *initParam;		/* param id's of initplans which are referred
 								 * at gather merge or one of it's child node */
 } GatherMerge;
 
+/* ------------
+ *		redistribute node
+ *
+ * Redistribute runs in each parallel worker below a Gather or Gather Merge.
+ * It hash-partitions its input on the given columns across all the workers
+ * of the parallel query, so that every worker returns all the rows, and only
+ * the rows, whose key hashes to it.  Executed outside of a worker, it simply
+ * returns its input.
+ *
+ * If numCols is zero, the input is instead range-partitioned on a single
+ * sort key: rangeBounds is a sorted sample of the key's values, from which
+ * the boundaries between the workers' ranges are picked at run time.  The
+ * first worker gets the lowest keys, in the order given by rangeSortOp.
+ * ------------
+ */
+typedef struct Redistribute
+{
+	Plan		plan;
+	int			numCols;		/* number of columns to hash on */
+	AttrNumber *hashColIdx;		/* their indexes in the target list */
+	Oid		   *hashOperators;	/* equality operators to hash by */
+	/* range partitioning, used if numCols is zero: */
+	AttrNumber	rangeColIdx;	/* index of the sort key in the target list */
+	Oid			rangeSortOp;	/* OID of operator to sort it by */
+	Oid			rangeCollation; /* OID of collation */
+	bool		rangeNullsFirst;	/* NULLS FIRST/LAST direction */
+	List	   *rangeBounds;	/* Consts giving sorted sample key values */
+} Redistribute;
+
 /* ----------------
  *		hash build node
  *
@@ -559,7 +559,8 @@ typedef struct PartitionSchemeData *PartitionScheme;
  *		nparts - Number of partitions
  *		boundinfo - Partition bounds
  *		partition_qual - Partition constraint if not the root
- *		part_rels - RelOptInfos for each partition
+ *		part_rels - RelOptInfos for each partition (NULL for partitions
+ *					that were pruned while expanding the inheritance set)
  *		partexprs, nullable_partexprs - Partition key expressions
  *		partitioned_child_rels - RT indexes of unpruned partitions of
  *								 this relation that are partitioned tables
@@ -1160,6 +1161,11 @@ typedef struct Path
  * we need not recompute them when considering using the same index in a
  * bitmap index/heap scan (see BitmapHeapPath).  The costs of the IndexPath
  * itself represent the costs of an IndexScan or IndexOnlyScan plan type.
+ *
+ * 'indexskip' is set by the index AM's amcostestimate function if it costed
+ * the path as a skip scan, which the executor then asks the AM to perform.
+ * This is currently only done by btree, when there are no quals on the
+ * first index column (see btcostestimate).
  *----------
  */
 typedef struct IndexPath
@@ -1174,6 +1180,7 @@ typedef struct IndexPath
 	ScanDirection indexscandir;
 	Cost		indextotalcost;
 	Selectivity indexselectivity;
+	bool		indexskip;
 } IndexPath;
 
 /*
@@ -1238,6 +1245,18 @@ typedef struct TidPath
 	List	   *tidquals;		/* qual(s) involving CTID = something */
 } TidPath;
 
+/*
+ * TidRangePath represents a scan by a contiguous range of TIDs
+ *
+ * tidrangequals is an implicitly AND'ed list of qual expressions of the form
+ * "CTID relop pseudoconstant", where relop is one of >,>=,<,<=.
+ */
+typedef struct TidRangePath
+{
+	Path		path;
+	List	   *tidrangequals;
+} TidRangePath;
+
 /*
  * SubqueryScanPath represents a scan of an unflattened subquery-in-FROM
  *
@@ -1369,6 +1388,25 @@ typedef struct MaterialPath
 	Path	   *subpath;
 } MaterialPath;
 
+/*
+ * MemoizePath represents a Memoize plan node, i.e., a cache that caches
+ * tuples from parameterized paths to save the underlying node from having to
+ * be rescanned for parameter values which are already cached.
+ */
+typedef struct MemoizePath
+{
+	Path		path;
+	Path	   *subpath;		/* outerpath to cache tuples from */
+	List	   *hash_operators; /* hash operators for each key */
+	List	   *param_exprs;	/* cache keys */
+	bool		singlerow;		/* true if the cache entry is to be marked as
+								 * complete after caching the first record. */
+	double		calls;			/* expected number of rescans */
+	uint32		est_entries;	/* The maximum number of entries that the
+								 * planner expects will fit in the cache, or 0
+								 * if unknown */
+} MemoizePath;
+
 /*
  * UniquePath represents elimination of distinct rows from the output of
  * its subpath.
@@ -1414,14 +1452,33 @@ typedef struct GatherPath
  * GatherMergePath runs several copies of a plan in parallel and collects
  * the results, preserving their common sort order.  For gather merge, the
  * parallel leader always executes the plan too, so we don't need single_copy.
+ *
+ * If concat_ranges is set, the subpath range-partitions the rows among the
+ * workers, so the results can simply be concatenated in worker order.
  */
 typedef struct GatherMergePath
 {
 	Path		path;
 	Path	   *subpath;		/* path for each worker */
 	int			num_workers;	/* number of workers sought to help */
+	bool		concat_ranges;	/* concatenate instead of merging? */
 } GatherMergePath;
 
+/*
+ * RedistributePath represents hash-partitioning the output of a partial path
+ * across the workers executing it, on the grouping columns of groupClause.
+ * If groupClause is NIL, the output is instead range-partitioned on the
+ * single PathKey rangekey, at boundaries picked from rangeBounds.
+ */
+typedef struct RedistributePath
+{
+	Path		path;
+	Path	   *subpath;		/* path whose output is redistributed */
+	List	   *groupClause;	/* SortGroupClauses giving the hash key */
+	PathKey    *rangekey;		/* sort key to range-partition on */
+	List	   *rangeBounds;	/* Consts giving sorted sample key values */
+} RedistributePath;
+
 
 /*
  * All join-type paths share these fields.
@@ -1562,6 +1619,17 @@ typedef struct SortPath
 	Path	   *subpath;		/* path representing input source */
 } SortPath;
 
+/*
+ * IncrementalSortPath represents a sort step whose input is already sorted
+ * on a prefix of the sort keys, so that it can sort each group of tuples
+ * sharing that prefix separately
+ */
+typedef struct IncrementalSortPath
+{
+	SortPath	spath;
+	int			nPresortedCols; /* number of presorted columns */
+} IncrementalSortPath;
+
 /*
  * GroupPath represents grouping (of presorted input)
  *
@@ -1640,6 +1708,7 @@ typedef struct GroupingSetsPath
 	Path		path;
 	Path	   *subpath;		/* path representing input source */
 	AggStrategy aggstrategy;	/* basic strategy */
+	AggSplit	aggsplit;		/* agg-splitting mode, see nodes.h */
 	List	   *rollups;		/* list of RollupData */
 	List	   *qual;			/* quals (HAVING quals), if any */
 } GroupingSetsPath;
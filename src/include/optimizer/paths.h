@@ -66,6 +66,15 @@ extern void generate_partitionwise_join_paths(PlannerInfo *root,
 extern void debug_print_rel(PlannerInfo *root, RelOptInfo *rel);
 #endif
 
+/*
+ * greedyjoin.c
+ *	  routines for greedy join order search
+ */
+extern PGDLLIMPORT int greedy_join_threshold;
+
+extern RelOptInfo *greedy_join_search(PlannerInfo *root, int levels_needed,
+				   List *initial_rels);
+
 /*
  * indxpath.c
  *	  routines to generate index paths
@@ -190,6 +199,8 @@ typedef enum
 
 extern PathKeysComparison compare_pathkeys(List *keys1, List *keys2);
 extern bool pathkeys_contained_in(List *keys1, List *keys2);
+extern bool pathkeys_count_contained_in(List *keys1, List *keys2,
+							int *n_common);
 extern Path *get_cheapest_path_for_pathkeys(List *paths, List *pathkeys,
 							   Relids required_outer,
 							   CostSelector cost_criterion,
@@ -30,9 +30,13 @@ extern void get_relation_info(PlannerInfo *root, Oid relationObjectId,
 
 extern List *infer_arbiter_indexes(PlannerInfo *root);
 
+extern void set_relation_partition_info(PlannerInfo *root, RelOptInfo *rel,
+							Relation relation);
+
 extern void estimate_rel_size(Relation rel, int32 *attr_widths,
 				  BlockNumber *pages, double *tuples, double *allvisfrac);
 
+extern int32 get_rel_data_width(Relation rel, int32 *attr_widths);
 extern int32 get_relation_data_width(Oid relid, int32 *attr_widths);
 
 extern bool relation_excluded_by_constraints(PlannerInfo *root,
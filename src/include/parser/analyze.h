@@ -15,10 +15,16 @@
 #define ANALYZE_H
 
 #include "parser/parse_node.h"
+#include "utils/queryjumble.h"
 
-/* Hook for plugins to get control at end of parse analysis */
+/*
+ * Hook for plugins to get control at end of parse analysis.  jstate is the
+ * state built while computing the query identifier, or NULL if none was
+ * computed or the query is a utility statement.
+ */
 typedef void (*post_parse_analyze_hook_type) (ParseState *pstate,
-											  Query *query);
+											  Query *query,
+											  JumbleState *jstate);
 extern PGDLLIMPORT post_parse_analyze_hook_type post_parse_analyze_hook;
 
 
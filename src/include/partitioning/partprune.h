@@ -77,6 +77,7 @@ extern PartitionPruneInfo *make_partition_pruneinfo(PlannerInfo *root,
 						 List *partitioned_rels,
 						 List *prunequal);
 extern Relids prune_append_rel_partitions(RelOptInfo *rel);
+extern Bitmapset *prune_partitions_by_clauses(RelOptInfo *rel, List *clauses);
 extern Bitmapset *get_matching_partitions(PartitionPruneContext *context,
 						List *pruning_steps);
 
@@ -234,6 +234,15 @@
  */
 #define PG_CACHE_LINE_SIZE		128
 
+/*
+ * Alignment of buffers, file offsets and transfer sizes required for I/O on
+ * files opened with O_DIRECT (see io_direct).  4096 satisfies the logical
+ * block size of all common storage devices and filesystems.  It must not be
+ * larger than BLCKSZ or XLOG_BLCKSZ for direct I/O to be used for data files
+ * or WAL, respectively.
+ */
+#define PG_IO_ALIGN_SIZE		4096
+
 /*
  *------------------------------------------------------------------------
  * The following symbols are for enabling debugging code, not for
@@ -98,4 +98,35 @@ extern pg_crc32c pg_comp_crc32c_sb8(pg_crc32c crc, const void *data, size_t len)
 
 #endif
 
+/*
+ * Support for combining the CRCs of adjacent blocks, used by the hardware
+ * implementations to process several blocks of a large input in parallel.
+ * See pg_crc32c_combine.c.
+ */
+#if defined(USE_SSE42_CRC32C) || defined(USE_ARMV8_CRC32C) || \
+	defined(USE_SSE42_CRC32C_WITH_RUNTIME_CHECK) || \
+	defined(USE_ARMV8_CRC32C_WITH_RUNTIME_CHECK)
+
+typedef struct pg_crc32c_shift_table
+{
+	uint32		t[4][256];
+} pg_crc32c_shift_table;
+
+extern void pg_crc32c_make_shift_table(pg_crc32c_shift_table *table, size_t len);
+
+/*
+ * Extend 'crc' over the number of zero bytes the table was built for.  The
+ * CRC must be in the bit order used by the hardware implementations.
+ */
+static inline pg_crc32c
+pg_crc32c_shift(const pg_crc32c_shift_table *table, pg_crc32c crc)
+{
+	return table->t[0][crc & 0xFF] ^
+		table->t[1][(crc >> 8) & 0xFF] ^
+		table->t[2][(crc >> 16) & 0xFF] ^
+		table->t[3][crc >> 24];
+}
+
+#endif
+
 #endif							/* PG_CRC32C_H */
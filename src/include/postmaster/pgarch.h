@@ -26,6 +26,46 @@
 #define MAX_XFN_CHARS	40
 #define VALID_XFN_CHARS "0123456789ABCDEF.history.backup.partial"
 
+/* Upper limit for archive_workers */
+#define MAX_ARCHIVE_WORKERS 32
+
+/* GUC options */
+extern char *XLogArchiveLibrary;
+extern int	archive_workers;
+
+/* ----------
+ * Archive module callbacks
+ *
+ * An archive module is a shared library named by archive_library.  The
+ * archiver loads it at startup and calls its _PG_archive_module_init function,
+ * which must fill in the callbacks; only archive_file_cb is required.
+ *
+ * check_configured_cb returns whether the module is ready to archive; if
+ * not, archiving is retried later, as for an empty archive_command.
+ * archive_file_cb copies one file, given by its name and by its path
+ * relative to the data directory, and returns true only if that succeeded.
+ * shutdown_cb is called when the archiver exits.
+ *
+ * The callbacks run in the archiver process, which has no transaction state
+ * or database connection; raising an ERROR terminates the archiver, to be
+ * restarted by the postmaster.
+ * ----------
+ */
+typedef bool (*ArchiveCheckConfiguredCB) (void);
+typedef bool (*ArchiveFileCB) (const char *file, const char *path);
+typedef void (*ArchiveShutdownCB) (void);
+
+typedef struct ArchiveModuleCallbacks
+{
+	ArchiveCheckConfiguredCB check_configured_cb;
+	ArchiveFileCB archive_file_cb;
+	ArchiveShutdownCB shutdown_cb;
+} ArchiveModuleCallbacks;
+
+typedef void (*ArchiveModuleInit) (ArchiveModuleCallbacks *cb);
+
+extern PGDLLEXPORT void _PG_archive_module_init(ArchiveModuleCallbacks *cb);
+
 /* ----------
  * Functions called from postmaster
  * ----------
@@ -0,0 +1,40 @@
+/*-------------------------------------------------------------------------
+ *
+ * proxy.h
+ *	  Exports from postmaster/proxy.c.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/postmaster/proxy.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef _PROXY_H
+#define _PROXY_H
+
+#include "libpq/libpq-be.h"
+
+/* GUC options */
+extern int	proxy_port;
+extern int	session_pool_size;
+
+/* true in the connection proxy process */
+extern bool am_connection_proxy;
+
+/* ----------
+ * Functions called from postmaster
+ * ----------
+ */
+extern int	proxy_start(pgsocket *sockets, int nsockets);
+extern void ProxyGenerateKey(void);
+
+/* ----------
+ * Functions called from backends started by the connection proxy
+ * ----------
+ */
+extern bool ProxyKeyIsValid(const char *key);
+extern void ProxySetClientAddress(Port *port, const char *client);
+extern bool ProxySessionHasState(void);
+
+#endif							/* _PROXY_H */
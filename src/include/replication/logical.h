@@ -45,6 +45,20 @@ typedef struct LogicalDecodingContext
 	struct ReorderBuffer *reorder;
 	struct SnapBuild *snapshot_builder;
 
+	/*
+	 * Contexts fed from this context's reader and reorder buffer when several
+	 * slots are decoded together, see DecodingGroupAddMember().  The list
+	 * starts with the context driving the decoding itself; it's NIL for a
+	 * context decoding a single slot.
+	 */
+	List	   *group_members;
+
+	/*
+	 * Transactions committing before this LSN have already been confirmed by
+	 * this context's slot and are not passed to its output plugin.
+	 */
+	XLogRecPtr	group_start_lsn;
+
 	/*
 	 * Marks the logical decoding context as fast forward decoding one. Such a
 	 * context does not have plugin loaded so most of the the following
@@ -52,6 +66,13 @@ typedef struct LogicalDecodingContext
 	 */
 	bool		fast_forward;
 
+	/*
+	 * Does the output plugin support streaming of in-progress transactions,
+	 * and is it enabled?  The output plugin may switch it off in its startup
+	 * callback.
+	 */
+	bool		streaming;
+
 	OutputPluginCallbacks callbacks;
 	OutputPluginOptions options;
 
@@ -113,6 +134,12 @@ extern void DecodingContextFindStartpoint(LogicalDecodingContext *ctx);
 extern bool DecodingContextReady(LogicalDecodingContext *ctx);
 extern void FreeDecodingContext(LogicalDecodingContext *ctx);
 
+extern LogicalDecodingContext *DecodingGroupAddMember(LogicalDecodingContext *ctx,
+					   ReplicationSlot *slot,
+					   List *output_plugin_options);
+extern void DecodingGroupConfirmReceivedLocation(LogicalDecodingContext *ctx,
+									 XLogRecPtr lsn);
+
 extern void LogicalIncreaseXminForSlot(XLogRecPtr lsn, TransactionId xmin);
 extern void LogicalIncreaseRestartDecodingForSlot(XLogRecPtr current_lsn,
 									  XLogRecPtr restart_lsn);
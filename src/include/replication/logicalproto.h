@@ -19,21 +19,29 @@
 /*
  * Protocol capabilities
  *
- * LOGICAL_PROTO_VERSION_NUM is our native protocol and the greatest version
- * we can support. PGLOGICAL_PROTO_MIN_VERSION_NUM is the oldest version we
- * have backwards compatibility for. The client requests protocol version at
- * connect time.
+ * LOGICALREP_PROTO_VERSION_NUM is our native protocol, and
+ * LOGICALREP_PROTO_MAX_VERSION_NUM the greatest version we can support.
+ * LOGICALREP_PROTO_MIN_VERSION_NUM is the oldest version we have backwards
+ * compatibility for. The client requests protocol version at connect time.
+ *
+ * LOGICALREP_PROTO_STREAM_VERSION_NUM is the minimum protocol version with
+ * support for streaming large transactions while still in progress.
  */
 #define LOGICALREP_PROTO_MIN_VERSION_NUM 1
 #define LOGICALREP_PROTO_VERSION_NUM 1
+#define LOGICALREP_PROTO_STREAM_VERSION_NUM 2
+#define LOGICALREP_PROTO_MAX_VERSION_NUM LOGICALREP_PROTO_STREAM_VERSION_NUM
 
 /* Tuple coming via logical replication. */
 typedef struct LogicalRepTupleData
 {
-	/* column values in text format, or NULL for a null value: */
+	/* column values in text or binary format, or NULL for a null value: */
 	char	   *values[MaxTupleAttributeNumber];
 	/* markers for changed/unchanged column values: */
 	bool		changed[MaxTupleAttributeNumber];
+	/* markers for values in binary format, and their lengths: */
+	bool		binary[MaxTupleAttributeNumber];
+	int			lengths[MaxTupleAttributeNumber];
 } LogicalRepTupleData;
 
 typedef uint32 LogicalRepRelId;
@@ -85,25 +93,44 @@ extern void logicalrep_read_commit(StringInfo in,
 extern void logicalrep_write_origin(StringInfo out, const char *origin,
 						XLogRecPtr origin_lsn);
 extern char *logicalrep_read_origin(StringInfo in, XLogRecPtr *origin_lsn);
-extern void logicalrep_write_insert(StringInfo out, Relation rel,
-						HeapTuple newtuple);
+extern void logicalrep_write_insert(StringInfo out, TransactionId xid,
+						Relation rel, HeapTuple newtuple, bool binary,
+						Bitmapset *columns);
 extern LogicalRepRelId logicalrep_read_insert(StringInfo in, LogicalRepTupleData *newtup);
-extern void logicalrep_write_update(StringInfo out, Relation rel, HeapTuple oldtuple,
-						HeapTuple newtuple);
+extern void logicalrep_write_update(StringInfo out, TransactionId xid,
+						Relation rel, HeapTuple oldtuple,
+						HeapTuple newtuple, bool binary,
+						Bitmapset *columns);
 extern LogicalRepRelId logicalrep_read_update(StringInfo in,
 					   bool *has_oldtuple, LogicalRepTupleData *oldtup,
 					   LogicalRepTupleData *newtup);
-extern void logicalrep_write_delete(StringInfo out, Relation rel,
-						HeapTuple oldtuple);
+extern void logicalrep_write_delete(StringInfo out, TransactionId xid,
+						Relation rel, HeapTuple oldtuple, bool binary,
+						Bitmapset *columns);
 extern LogicalRepRelId logicalrep_read_delete(StringInfo in,
 					   LogicalRepTupleData *oldtup);
-extern void logicalrep_write_truncate(StringInfo out, int nrelids, Oid relids[],
+extern void logicalrep_write_truncate(StringInfo out, TransactionId xid,
+						  int nrelids, Oid relids[],
 						  bool cascade, bool restart_seqs);
 extern List *logicalrep_read_truncate(StringInfo in,
 						 bool *cascade, bool *restart_seqs);
-extern void logicalrep_write_rel(StringInfo out, Relation rel);
+extern void logicalrep_write_rel(StringInfo out, Relation rel,
+					 Bitmapset *columns);
 extern LogicalRepRelation *logicalrep_read_rel(StringInfo in);
 extern void logicalrep_write_typ(StringInfo out, Oid typoid);
 extern void logicalrep_read_typ(StringInfo out, LogicalRepTyp *ltyp);
+extern void logicalrep_write_stream_start(StringInfo out, TransactionId xid,
+							  bool first_segment);
+extern TransactionId logicalrep_read_stream_start(StringInfo in,
+							 bool *first_segment);
+extern void logicalrep_write_stream_stop(StringInfo out);
+extern void logicalrep_write_stream_commit(StringInfo out, ReorderBufferTXN *txn,
+							   XLogRecPtr commit_lsn);
+extern TransactionId logicalrep_read_stream_commit(StringInfo out,
+							  LogicalRepCommitData *commit_data);
+extern void logicalrep_write_stream_abort(StringInfo out, TransactionId xid,
+							  TransactionId subxid);
+extern void logicalrep_read_stream_abort(StringInfo in, TransactionId *xid,
+							 TransactionId *subxid);
 
 #endif							/* LOGICALREP_PROTO_H */
@@ -25,6 +25,8 @@ typedef struct PGOutputData
 
 	List	   *publication_names;
 	List	   *publications;
+	bool		streaming;		/* stream large in-progress transactions? */
+	bool		binary;			/* send column values in binary format? */
 } PGOutputData;
 
 #endif							/* PGOUTPUT_H */
@@ -17,6 +17,9 @@
 #include "utils/snapshot.h"
 #include "utils/timestamp.h"
 
+/* GUC variable */
+extern PGDLLIMPORT int logical_decoding_work_mem;
+
 /* an individual tuple, stored in one chunk of memory */
 typedef struct ReorderBufferTupleBuf
 {
@@ -79,6 +82,9 @@ typedef struct ReorderBufferChange
 
 	RepOriginId origin_id;
 
+	/* Transaction this change belongs to (NULL while not queued). */
+	struct ReorderBufferTXN *txn;
+
 	/*
 	 * Context data for the change. Which part of the union is valid depends
 	 * on action.
@@ -164,6 +170,9 @@ typedef struct ReorderBufferTXN
 	bool		is_known_as_subxact;
 	TransactionId toplevel_xid;
 
+	/* Top-level transaction, once known; NULL for top-level transactions */
+	struct ReorderBufferTXN *toptxn;
+
 	/*
 	 * LSN of the first data carrying, WAL record with knowledge about this
 	 * xid. This is allowed to *not* be first record adorned with this xid, if
@@ -238,6 +247,29 @@ typedef struct ReorderBufferTXN
 	 */
 	bool		serialized;
 
+	/*
+	 * Have some of this transaction's changes already been sent downstream
+	 * while it was still in progress (see ReorderBufferStreamTXN)?  Once a
+	 * transaction has been streamed, the remaining changes have to be sent
+	 * the same way, and its end has to be reported with the stream_commit or
+	 * stream_abort callbacks.
+	 */
+	bool		streamed;
+
+	/*
+	 * Does the list of changes end with a change that can't be sent on its
+	 * own, like a toast chunk or a speculative insertion waiting for its
+	 * main tuple or confirmation?  Streaming has to wait until it doesn't.
+	 */
+	bool		has_partial_change;
+
+	/*
+	 * Snapshot and command id to continue from when streaming the next batch
+	 * of changes of a streamed transaction.
+	 */
+	Snapshot	snapshot_now;
+	CommandId	command_id;
+
 	/*
 	 * List of ReorderBufferChange structs, including new Snapshots and new
 	 * CommandIds
@@ -286,6 +318,14 @@ typedef struct ReorderBufferTXN
 	 */
 	dlist_node	node;
 
+	/*
+	 * Memory used by this transaction's changes kept in memory, and by the
+	 * changes of the transaction together with its known subtransactions
+	 * (only maintained for top-level transactions).
+	 */
+	Size		size;
+	Size		total_size;
+
 } ReorderBufferTXN;
 
 /* so we can define the callbacks used inside struct ReorderBuffer itself */
@@ -326,6 +366,52 @@ typedef void (*ReorderBufferMessageCB) (
 										const char *prefix, Size sz,
 										const char *message);
 
+/* start streaming transaction callback signature */
+typedef void (*ReorderBufferStreamStartCB) (
+											ReorderBuffer *rb,
+											ReorderBufferTXN *txn);
+
+/* stop streaming transaction callback signature */
+typedef void (*ReorderBufferStreamStopCB) (
+										   ReorderBuffer *rb,
+										   ReorderBufferTXN *txn);
+
+/* discard streamed transaction callback signature */
+typedef void (*ReorderBufferStreamAbortCB) (
+											ReorderBuffer *rb,
+											ReorderBufferTXN *txn,
+											XLogRecPtr abort_lsn);
+
+/* commit streamed transaction callback signature */
+typedef void (*ReorderBufferStreamCommitCB) (
+											 ReorderBuffer *rb,
+											 ReorderBufferTXN *txn,
+											 XLogRecPtr commit_lsn);
+
+/* stream change callback signature */
+typedef void (*ReorderBufferStreamChangeCB) (
+											 ReorderBuffer *rb,
+											 ReorderBufferTXN *txn,
+											 Relation relation,
+											 ReorderBufferChange *change);
+
+/* stream truncate callback signature */
+typedef void (*ReorderBufferStreamTruncateCB) (
+											   ReorderBuffer *rb,
+											   ReorderBufferTXN *txn,
+											   int nrelations,
+											   Relation relations[],
+											   ReorderBufferChange *change);
+
+/* stream message callback signature */
+typedef void (*ReorderBufferStreamMessageCB) (
+											  ReorderBuffer *rb,
+											  ReorderBufferTXN *txn,
+											  XLogRecPtr message_lsn,
+											  bool transactional,
+											  const char *prefix, Size sz,
+											  const char *message);
+
 struct ReorderBuffer
 {
 	/*
@@ -364,6 +450,18 @@ struct ReorderBuffer
 	ReorderBufferCommitCB commit;
 	ReorderBufferMessageCB message;
 
+	/*
+	 * Callbacks to be called when streaming a transaction that is still in
+	 * progress.
+	 */
+	ReorderBufferStreamStartCB stream_start;
+	ReorderBufferStreamStopCB stream_stop;
+	ReorderBufferStreamAbortCB stream_abort;
+	ReorderBufferStreamCommitCB stream_commit;
+	ReorderBufferStreamChangeCB stream_change;
+	ReorderBufferStreamTruncateCB stream_truncate;
+	ReorderBufferStreamMessageCB stream_message;
+
 	/*
 	 * Pointer that will be passed untouched to the callbacks.
 	 */
@@ -391,6 +489,9 @@ struct ReorderBuffer
 	/* buffer for disk<->memory conversions */
 	char	   *outbuf;
 	Size		outbufsize;
+
+	/* memory used by the changes of all transactions kept in memory */
+	Size		size;
 };
 
 
@@ -405,7 +506,8 @@ void		ReorderBufferReturnChange(ReorderBuffer *, ReorderBufferChange *);
 Oid * ReorderBufferGetRelids(ReorderBuffer *, int nrelids);
 void ReorderBufferReturnRelids(ReorderBuffer *, Oid *relids);
 
-void		ReorderBufferQueueChange(ReorderBuffer *, TransactionId, XLogRecPtr lsn, ReorderBufferChange *);
+void ReorderBufferQueueChange(ReorderBuffer *, TransactionId, XLogRecPtr lsn,
+						 ReorderBufferChange *, bool toast_insert);
 void ReorderBufferQueueMessage(ReorderBuffer *, TransactionId, Snapshot snapshot, XLogRecPtr lsn,
 						  bool transactional, const char *prefix,
 						  Size message_size, const char *message);
@@ -187,6 +187,9 @@ extern void ReplicationSlotDrop(const char *name, bool nowait);
 
 extern void ReplicationSlotAcquire(const char *name, bool nowait);
 extern void ReplicationSlotRelease(void);
+extern ReplicationSlot *ReplicationSlotAcquireAdditional(const char *name,
+								 bool nowait);
+extern void ReplicationSlotReleaseAdditional(ReplicationSlot *slot);
 extern void ReplicationSlotCleanup(void);
 extern void ReplicationSlotSave(void);
 extern void ReplicationSlotMarkDirty(void);
@@ -17,6 +17,9 @@
 #include "access/xlogdefs.h"
 #include "catalog/pg_subscription.h"
 #include "datatype/timestamp.h"
+#include "lib/stringinfo.h"
+#include "miscadmin.h"
+#include "storage/dsm.h"
 #include "storage/lock.h"
 
 typedef struct LogicalRepWorker
@@ -42,6 +45,12 @@ typedef struct LogicalRepWorker
 	/* Subscription id for the worker. */
 	Oid			subid;
 
+	/*
+	 * PID of the apply worker this worker applies transactions for, if it is
+	 * a parallel apply worker, else InvalidPid.
+	 */
+	pid_t		leader_pid;
+
 	/* Used for initial table synchronization. */
 	Oid			relid;
 	char		relstate;
@@ -59,6 +68,9 @@ typedef struct LogicalRepWorker
 /* Main memory context for apply worker. Permanent during worker lifetime. */
 extern MemoryContext ApplyContext;
 
+/* Memory context reset after each replication protocol message. */
+extern MemoryContext ApplyMessageContext;
+
 /* libpqreceiver connection */
 extern struct WalReceiverConn *wrconn;
 
@@ -72,8 +84,9 @@ extern void logicalrep_worker_attach(int slot);
 extern LogicalRepWorker *logicalrep_worker_find(Oid subid, Oid relid,
 					   bool only_running);
 extern List *logicalrep_workers_find(Oid subid, bool only_running);
-extern void logicalrep_worker_launch(Oid dbid, Oid subid, const char *subname,
-						 Oid userid, Oid relid);
+extern bool logicalrep_worker_launch(Oid dbid, Oid subid, const char *subname,
+						 Oid userid, Oid relid,
+						 dsm_handle subworker_dsm, int subworker_index);
 extern void logicalrep_worker_stop(Oid subid, Oid relid);
 extern void logicalrep_worker_stop_at_commit(Oid subid, Oid relid);
 extern void logicalrep_worker_wakeup(Oid subid, Oid relid);
@@ -85,6 +98,19 @@ extern char *LogicalRepSyncTableStart(XLogRecPtr *origin_startpos);
 void		process_syncing_tables(XLogRecPtr current_lsn);
 void invalidate_syncing_table_states(Datum arg, int cacheid,
 								uint32 hashvalue);
+extern bool AllTablesyncsReady(void);
+
+extern void InitializeLogRepWorker(void);
+extern void apply_dispatch(StringInfo s);
+
+/* Parallel apply, in applyparallel.c */
+extern void pa_start_workers(void);
+extern bool pa_handle_message(StringInfo s);
+extern void pa_wait_for_all(void);
+extern bool pa_have_pending_txns(void);
+extern bool pa_get_progress(XLogRecPtr *remote_end, XLogRecPtr *local_end);
+extern void pa_wait_for_commit_turn(void);
+extern void pa_commit_done(XLogRecPtr remote_end, XLogRecPtr local_end);
 
 static inline bool
 am_tablesync_worker(void)
@@ -92,4 +118,10 @@ am_tablesync_worker(void)
 	return OidIsValid(MyLogicalRepWorker->relid);
 }
 
+static inline bool
+am_parallel_apply_worker(void)
+{
+	return MyLogicalRepWorker->leader_pid != InvalidPid;
+}
+
 #endif							/* WORKER_INTERNAL_H */
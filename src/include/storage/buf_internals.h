@@ -15,6 +15,7 @@
 #ifndef BUFMGR_INTERNALS_H
 #define BUFMGR_INTERNALS_H
 
+#include "pgstat.h"
 #include "storage/buf.h"
 #include "storage/bufmgr.h"
 #include "storage/latch.h"
@@ -142,9 +143,9 @@ typedef struct buftag
  * single atomic operation, without actually acquiring and releasing spinlock;
  * for instance, increase or decrease refcount.  buf_id field never changes
  * after initialization, so does not need locking.  freeNext is protected by
- * the buffer_strategy_lock not buffer header lock.  The LWLock can take care
- * of itself.  The buffer header lock is *not* used to control access to the
- * data in the buffer!
+ * the lock of the buffer's freelist partition not buffer header lock.  The
+ * LWLock can take care of itself.  The buffer header lock is *not* used to
+ * control access to the data in the buffer!
  *
  * It's assumed that nobody changes the state field while buffer header lock
  * is held.  Thus buffer header lock holder can do complex updates of the
@@ -236,6 +237,12 @@ extern PGDLLIMPORT LWLockMinimallyPadded *BufferIOLWLockArray;
 #define FREENEXT_END_OF_LIST	(-1)
 #define FREENEXT_NOT_IN_LIST	(-2)
 
+/*
+ * Number of partitions the freelist is split into; buffer i belongs to
+ * partition i % NUM_BUFFER_FREELISTS.
+ */
+#define NUM_BUFFER_FREELISTS	8
+
 /*
  * Functions for acquiring/releasing a shared buffer header's spinlock.  Do
  * not apply these to local buffers!
@@ -304,15 +311,22 @@ extern CkptSortItem *CkptBufferIds;
 extern void WritebackContextInit(WritebackContext *context, int *max_pending);
 extern void IssuePendingWritebacks(WritebackContext *context);
 extern void ScheduleBufferTagForWriteback(WritebackContext *context, BufferTag *tag);
+extern int	CheckpointWriteBuffers(const int *buf_ids, int nbuffers,
+					   WritebackContext *wb_context);
 
 /* freelist.c */
 extern BufferDesc *StrategyGetBuffer(BufferAccessStrategy strategy,
 				  uint32 *buf_state);
 extern void StrategyFreeBuffer(BufferDesc *buf);
+extern void StrategyPutVictimBuffer(BufferDesc *buf);
+extern uint32 StrategyFreeBufferCount(void);
 extern bool StrategyRejectBuffer(BufferAccessStrategy strategy,
 					 BufferDesc *buf);
+extern IOContext IOContextForStrategy(BufferAccessStrategy strategy);
 
-extern int	StrategySyncStart(uint32 *complete_passes, uint32 *num_buf_alloc);
+extern int	StrategySyncStart(uint32 *complete_passes, uint32 *num_buf_alloc,
+				  uint32 *num_dirty_victims);
+extern void StrategyCountDirtyVictim(void);
 extern void StrategyNotifyBgWriter(int bgwprocno);
 
 extern Size StrategyShmemSize(void);
@@ -333,9 +347,9 @@ extern void LocalPrefetchBuffer(SMgrRelation smgr, ForkNumber forkNum,
 extern BufferDesc *LocalBufferAlloc(SMgrRelation smgr, ForkNumber forkNum,
 				 BlockNumber blockNum, bool *foundPtr);
 extern void MarkLocalBufferDirty(Buffer buffer);
-extern void DropRelFileNodeLocalBuffers(RelFileNode rnode, ForkNumber forkNum,
+extern void DropRelFileNodeLocalBuffers(SMgrRelation smgr, ForkNumber forkNum,
 							BlockNumber firstDelBlock);
-extern void DropRelFileNodeAllLocalBuffers(RelFileNode rnode);
+extern void DropRelFileNodeAllLocalBuffers(SMgrRelation smgr);
 extern void AtEOXact_LocalBuffers(bool isCommit);
 
 #endif							/* BUFMGR_INTERNALS_H */
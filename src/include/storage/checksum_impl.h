@@ -98,10 +98,25 @@
  * to unroll the inner loop to avoid loop overhead and minimize register
  * spilling. For less sophisticated compilers it might be beneficial to
  * manually unroll the inner loop.
+ *
+ * Since a default x86-64 build can only assume SSE2, which lacks pmulld, the
+ * vectorized loop the compiler produces there is far from optimal. When the
+ * compiler supports it, we therefore also build an explicit AVX2 version of
+ * the block checksum, which holds the 32 partial sums in four 256-bit
+ * registers, and use it if a runtime check shows that the CPU supports AVX2.
+ * It computes exactly the same result as the generic version.
  */
 
 #include "storage/bufpage.h"
 
+#if defined(__x86_64__) && \
+	((defined(__clang__) && __clang_major__ >= 4) || \
+	 (!defined(__clang__) && defined(__GNUC__) && \
+	  (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define PG_CHECKSUM_USE_AVX2
+#include <immintrin.h>
+#endif
+
 /* number of checksums to calculate in parallel */
 #define N_SUMS 32
 /* prime multiplier of FNV-1a hash */
@@ -173,6 +188,86 @@ pg_checksum_block(const PGChecksummablePage *page)
 	return result;
 }
 
+#ifdef PG_CHECKSUM_USE_AVX2
+
+/*
+ * AVX2 version of pg_checksum_block().  Lane k of sums[i] holds partial
+ * checksum 8 * i + k.
+ */
+static uint32 pg_checksum_block_avx2(const PGChecksummablePage *page)
+			__attribute__((target("avx2")));
+
+static uint32
+pg_checksum_block_avx2(const PGChecksummablePage *page)
+{
+	const __m256i prime = _mm256_set1_epi32(FNV_PRIME);
+	__m256i		sums[N_SUMS / 8];
+	uint32		folded[8];
+	uint32		result = 0;
+	uint32		i,
+				j;
+
+	for (j = 0; j < N_SUMS / 8; j++)
+		sums[j] = _mm256_loadu_si256((const __m256i *) &checksumBaseOffsets[8 * j]);
+
+	/* main checksum calculation, see CHECKSUM_COMP */
+	for (i = 0; i < (uint32) (BLCKSZ / (sizeof(uint32) * N_SUMS)); i++)
+	{
+		for (j = 0; j < N_SUMS / 8; j++)
+		{
+			__m256i		tmp;
+
+			tmp = _mm256_xor_si256(sums[j],
+								   _mm256_loadu_si256((const __m256i *) &page->data[i][8 * j]));
+			sums[j] = _mm256_xor_si256(_mm256_mullo_epi32(tmp, prime),
+									   _mm256_srli_epi32(tmp, 17));
+		}
+	}
+
+	/* finally add in two rounds of zeroes for additional mixing */
+	for (i = 0; i < 2; i++)
+	{
+		for (j = 0; j < N_SUMS / 8; j++)
+			sums[j] = _mm256_xor_si256(_mm256_mullo_epi32(sums[j], prime),
+									   _mm256_srli_epi32(sums[j], 17));
+	}
+
+	/* xor fold partial checksums together */
+	_mm256_storeu_si256((__m256i *) folded,
+						_mm256_xor_si256(_mm256_xor_si256(sums[0], sums[1]),
+										 _mm256_xor_si256(sums[2], sums[3])));
+	for (i = 0; i < 8; i++)
+		result ^= folded[i];
+
+	return result;
+}
+
+static uint32 pg_checksum_block_choose(const PGChecksummablePage *page);
+
+static uint32 (*pg_checksum_block_impl) (const PGChecksummablePage *page) =
+pg_checksum_block_choose;
+
+/*
+ * On the first call, check whether the CPU supports AVX2 and select the
+ * implementation to use for this and subsequent calls.
+ */
+static uint32
+pg_checksum_block_choose(const PGChecksummablePage *page)
+{
+	if (__builtin_cpu_supports("avx2"))
+		pg_checksum_block_impl = pg_checksum_block_avx2;
+	else
+		pg_checksum_block_impl = pg_checksum_block;
+
+	return pg_checksum_block_impl(page);
+}
+
+#else							/* !PG_CHECKSUM_USE_AVX2 */
+
+#define pg_checksum_block_impl pg_checksum_block
+
+#endif							/* PG_CHECKSUM_USE_AVX2 */
+
 /*
  * Compute the checksum for a Postgres page.
  *
@@ -201,7 +296,7 @@ pg_checksum_page(char *page, BlockNumber blkno)
 	 */
 	save_checksum = cpage->phdr.pd_checksum;
 	cpage->phdr.pd_checksum = 0;
-	checksum = pg_checksum_block(cpage);
+	checksum = pg_checksum_block_impl(cpage);
 	cpage->phdr.pd_checksum = save_checksum;
 
 	/* Mix in the block number to detect transposed pages */
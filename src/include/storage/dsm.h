@@ -33,6 +33,13 @@ extern void dsm_detach_all(void);
 extern void dsm_set_control_handle(dsm_handle h);
 #endif
 
+/* GUC variable */
+extern int	min_dynamic_shared_memory;
+
+/* Preallocated space in the main shared memory segment. */
+extern size_t dsm_estimate_size(void);
+extern void dsm_shmem_init(void);
+
 /* Functions that create or remove mappings. */
 extern dsm_segment *dsm_create(Size size, int flags);
 extern dsm_segment *dsm_attach(dsm_handle h);
@@ -48,6 +48,11 @@ typedef int File;
 /* GUC parameter */
 extern PGDLLIMPORT int max_files_per_process;
 extern PGDLLIMPORT bool data_sync_retry;
+extern int	io_direct_flags;
+
+/* Bits in io_direct_flags */
+#define IO_DIRECT_DATA			0x01
+#define IO_DIRECT_WAL			0x02
 
 /*
  * This is private to fd.c, but exported for save/restore_backend_variables()
@@ -71,6 +76,7 @@ extern int	FileSync(File file, uint32 wait_event_info);
 extern off_t FileSize(File file);
 extern int	FileTruncate(File file, off_t offset, uint32 wait_event_info);
 extern void FileWriteback(File file, off_t offset, off_t nbytes, uint32 wait_event_info);
+extern void FileFallocate(File file, off_t offset, off_t amount, uint32 wait_event_info);
 extern char *FilePathName(File file);
 extern int	FileGetRawDesc(File file);
 extern int	FileGetRawFlags(File file);
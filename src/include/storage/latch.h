@@ -152,6 +152,9 @@ typedef struct WaitEvent
 /* forward declaration to avoid exposing latch.c implementation details */
 typedef struct WaitEventSet WaitEventSet;
 
+/* GUC variable */
+extern bool use_io_uring;
+
 /*
  * prototypes for functions in latch.c
  */
@@ -172,6 +175,10 @@ extern void ModifyWaitEvent(WaitEventSet *set, int pos, uint32 events, Latch *la
 extern int WaitEventSetWait(WaitEventSet *set, long timeout,
 				 WaitEvent *occurred_events, int nevents,
 				 uint32 wait_event_info);
+extern bool WaitEventSetEnableIoUring(WaitEventSet *set);
+extern int WaitEventSetWaitRecv(WaitEventSet *set, int pos, void *buf,
+					 size_t len, ssize_t *nread, WaitEvent *occurred_event,
+					 uint32 wait_event_info);
 extern int WaitLatch(volatile Latch *latch, int wakeEvents, long timeout,
 		  uint32 wait_event_info);
 extern int WaitLatchOrSocket(volatile Latch *latch, int wakeEvents,
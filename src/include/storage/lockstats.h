@@ -0,0 +1,80 @@
+/*-------------------------------------------------------------------------
+ *
+ * lockstats.h
+ *	  Lock wait and hold time statistics
+ *
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/storage/lockstats.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef LOCKSTATS_H
+#define LOCKSTATS_H
+
+#include "datatype/timestamp.h"
+#include "portability/instr_time.h"
+#include "storage/lock.h"
+
+/*
+ * Statistics are kept per LWLock tranche and per heavyweight lock tag type.
+ * Tranches with IDs beyond LOCKSTATS_MAX_LWLOCK_TRANCHES are not tracked;
+ * LOCKSTATS_LWLOCK_ENTRY() returns -1 for those.
+ */
+#define LOCKSTATS_MAX_LWLOCK_TRANCHES	128
+#define LOCKSTATS_NUM_ENTRIES \
+	(LOCKSTATS_MAX_LWLOCK_TRANCHES + LOCKTAG_LAST_TYPE + 1)
+
+#define LOCKSTATS_LWLOCK_ENTRY(tranche) \
+	((tranche) < LOCKSTATS_MAX_LWLOCK_TRANCHES ? (int) (tranche) : -1)
+#define LOCKSTATS_LOCK_ENTRY(locktype) \
+	(LOCKSTATS_MAX_LWLOCK_TRANCHES + (int) (locktype))
+
+/*
+ * Hold times are also summarized in a log2 histogram.  Bucket 0 counts holds
+ * shorter than 1 microsecond, bucket k (k > 0) those of [2^(k-1), 2^k)
+ * microseconds; the last bucket also absorbs everything longer.
+ */
+#define LOCKSTATS_HIST_BUCKETS	16
+
+/* Counters for one entry; times are in microseconds */
+typedef struct LockTimingCounts
+{
+	uint64		wait_count;
+	uint64		wait_time;
+	uint64		max_wait_time;
+	uint64		hold_count;
+	uint64		hold_time;
+	uint64		hold_hist[LOCKSTATS_HIST_BUCKETS];
+} LockTimingCounts;
+
+/* GUC variable */
+extern bool track_lock_timing;
+
+/*
+ * Start timing a wait or a hold.  The start time is left zero when timing is
+ * disabled, so that the end of the interval can tell whether to count it.
+ */
+#define LockStatsStartTiming(t) \
+	do { \
+		if (track_lock_timing) \
+			INSTR_TIME_SET_CURRENT(t); \
+		else \
+			INSTR_TIME_SET_ZERO(t); \
+	} while (0)
+
+#define LockStatsTimingStarted(t)	(!INSTR_TIME_IS_ZERO(t))
+
+extern void LockStatsCountWait(int entry, instr_time start);
+extern void LockStatsCountHold(int entry, instr_time start);
+extern void LockStatsFlush(bool force);
+
+extern Size LockStatsShmemSize(void);
+extern void LockStatsShmemInit(void);
+
+extern TimestampTz LockStatsFetch(LockTimingCounts *counts);
+extern void LockStatsReset(void);
+
+#endif							/* LOCKSTATS_H */
@@ -116,8 +116,12 @@ extern PGDLLIMPORT int NamedLWLockTrancheRequests;
 #define LOG2_NUM_LOCK_PARTITIONS  4
 #define NUM_LOCK_PARTITIONS  (1 << LOG2_NUM_LOCK_PARTITIONS)
 
-/* Number of partitions the shared predicate lock tables are divided into */
-#define LOG2_NUM_PREDICATELOCK_PARTITIONS  4
+/*
+ * Number of partitions the shared predicate lock tables are divided into.
+ * SIREAD locks are acquired for every tuple, page or index range read at
+ * SERIALIZABLE, so these see much more traffic than the regular lock tables.
+ */
+#define LOG2_NUM_PREDICATELOCK_PARTITIONS  6
 #define NUM_PREDICATELOCK_PARTITIONS  (1 << LOG2_NUM_PREDICATELOCK_PARTITIONS)
 
 /* Offsets for various chunks of preallocated lwlocks. */
@@ -202,6 +206,9 @@ typedef enum BuiltinTrancheIds
 	LWTRANCHE_MXACTMEMBER_BUFFERS,
 	LWTRANCHE_ASYNC_BUFFERS,
 	LWTRANCHE_OLDSERXID_BUFFERS,
+	LWTRANCHE_SUBTRANS_BANKS,
+	LWTRANCHE_MXACTOFFSET_BANKS,
+	LWTRANCHE_MXACTMEMBER_BANKS,
 	LWTRANCHE_WAL_INSERT,
 	LWTRANCHE_BUFFER_CONTENT,
 	LWTRANCHE_BUFFER_IO_IN_PROGRESS,
@@ -211,6 +218,7 @@ typedef enum BuiltinTrancheIds
 	LWTRANCHE_BUFFER_MAPPING,
 	LWTRANCHE_LOCK_MANAGER,
 	LWTRANCHE_PREDICATE_LOCK_MANAGER,
+	LWTRANCHE_RELATION_EXTENSION,
 	LWTRANCHE_PARALLEL_HASH_JOIN,
 	LWTRANCHE_PARALLEL_QUERY_DSA,
 	LWTRANCHE_SESSION_DSA,
@@ -219,6 +227,14 @@ typedef enum BuiltinTrancheIds
 	LWTRANCHE_SHARED_TUPLESTORE,
 	LWTRANCHE_TBM,
 	LWTRANCHE_PARALLEL_APPEND,
+	LWTRANCHE_STATS_DSA,
+	LWTRANCHE_STATS_HASH,
+	LWTRANCHE_SHARED_CATCACHE_DSA,
+	LWTRANCHE_SHARED_CATCACHE_HASH,
+	LWTRANCHE_SHARED_PLANCACHE_DSA,
+	LWTRANCHE_SHARED_PLANCACHE_HASH,
+	LWTRANCHE_RELSIZE_CACHE,
+	LWTRANCHE_FSYNC_REQUEST,
 	LWTRANCHE_FIRST_USER_DEFINED
 }			BuiltinTrancheIds;
 
@@ -41,8 +41,9 @@ typedef struct PGShmemHeader	/* standard header for all Postgres shmem */
 #endif
 } PGShmemHeader;
 
-/* GUC variable */
+/* GUC variables */
 extern int	huge_pages;
+extern int	shared_memory_numa;
 
 /* Possible values for huge_pages */
 typedef enum
@@ -52,6 +53,13 @@ typedef enum
 	HUGE_PAGES_TRY
 }			HugePagesType;
 
+/* Possible values for shared_memory_numa */
+typedef enum
+{
+	SHMEM_NUMA_OFF,
+	SHMEM_NUMA_INTERLEAVE
+}			SharedMemoryNumaType;
+
 #ifndef WIN32
 extern unsigned long UsedShmemSegID;
 #else
@@ -68,5 +76,6 @@ extern PGShmemHeader *PGSharedMemoryCreate(Size size, bool makePrivate,
 					 int port, PGShmemHeader **shim);
 extern bool PGSharedMemoryIsInUse(unsigned long id1, unsigned long id2);
 extern void PGSharedMemoryDetach(void);
+extern bool PGSharedMemoryGetNumaNodes(void **pages, int count, int *nodes);
 
 #endif							/* PG_SHMEM_H */
@@ -25,10 +25,7 @@
 extern int	max_predicate_locks_per_xact;
 extern int	max_predicate_locks_per_relation;
 extern int	max_predicate_locks_per_page;
-
-
-/* Number of SLRU buffers to use for predicate locking */
-#define NUM_OLDSERXID_BUFFERS	16
+extern int	serializable_buffers;
 
 
 /*
@@ -25,6 +25,9 @@
 #include "storage/lock.h"
 #include "storage/sinval.h"
 
+/* GUC parameter */
+extern int	sinval_queue_size;
+
 /*
  * prototypes for functions in sinvaladt.c
  */
@@ -46,6 +46,7 @@ typedef enum
 } LogStmtLevel;
 
 extern PGDLLIMPORT int log_statement;
+extern int	parse_tree_cache_size;
 
 extern List *pg_parse_query(const char *query_string);
 extern List *pg_analyze_and_rewrite(RawStmt *parsetree,
@@ -57,10 +58,10 @@ extern List *pg_analyze_and_rewrite_params(RawStmt *parsetree,
 							  ParserSetupHook parserSetup,
 							  void *parserSetupArg,
 							  QueryEnvironment *queryEnv);
-extern PlannedStmt *pg_plan_query(Query *querytree, int cursorOptions,
-			  ParamListInfo boundParams);
-extern List *pg_plan_queries(List *querytrees, int cursorOptions,
-				ParamListInfo boundParams);
+extern PlannedStmt *pg_plan_query(Query *querytree, const char *query_string,
+			  int cursorOptions, ParamListInfo boundParams);
+extern List *pg_plan_queries(List *querytrees, const char *query_string,
+				int cursorOptions, ParamListInfo boundParams);
 
 extern bool check_max_stack_depth(int *newval, void **extra, GucSource source);
 extern void assign_max_stack_depth(int newval, void *extra);
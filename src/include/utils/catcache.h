@@ -63,10 +63,10 @@ typedef struct catcache
 											 * scans */
 
 	/*
-	 * Keep these at the end, so that compiling catcache.c with CATCACHE_STATS
-	 * doesn't break ABI for other modules
+	 * Statistics, shown by the pg_catalog_caches view.  If catcache.c is
+	 * compiled with CATCACHE_STATS, they are also printed at backend exit.
 	 */
-#ifdef CATCACHE_STATS
+	Size		cc_memusage;	/* space taken by entries and lists */
 	long		cc_searches;	/* total # searches against this cache */
 	long		cc_hits;		/* # of matches against existing entry */
 	long		cc_neg_hits;	/* # of matches against negative entry */
@@ -79,7 +79,7 @@ typedef struct catcache
 	long		cc_invals;		/* # of entries invalidated from cache */
 	long		cc_lsearches;	/* total # list-searches */
 	long		cc_lhits;		/* # of matches against existing lists */
-#endif
+	long		cc_evictions;	/* # of entries removed to save memory */
 } CatCache;
 
 
@@ -103,6 +103,16 @@ typedef struct catctup
 	 */
 	dlist_node	cache_elem;		/* list member of per-bucket list */
 
+	/*
+	 * All entries of all caches are also members of a global dlist kept in
+	 * order of last access, oldest first, from which entries are evicted
+	 * when catalog_cache_memory_target is exceeded.  lastaccess is the value
+	 * of catalog_cache_clock at the last access, which lets the eviction
+	 * logic compare entries with relcache entries, too.
+	 */
+	dlist_node	lru_elem;		/* list member of global LRU list */
+	uint64		lastaccess;		/* catalog_cache_clock at last access */
+
 	/*
 	 * A tuple marked "dead" must not be returned by subsequent searches.
 	 * However, it won't be physically deleted from the cache until its
@@ -183,12 +193,20 @@ typedef struct catcacheheader
 {
 	slist_head	ch_caches;		/* head of list of CatCache structs */
 	int			ch_ntup;		/* # of tuples in all caches */
+	dlist_head	ch_lru;			/* all CatCTups, least recently used first */
+	Size		ch_memusage;	/* space taken by all caches */
 } CatCacheHeader;
 
 
 /* this extern duplicates utils/memutils.h... */
 extern PGDLLIMPORT MemoryContext CacheMemoryContext;
 
+/* GUC variable, in kilobytes; zero means no limit */
+extern int	catalog_cache_memory_target;
+
+/* advanced on every catcache and relcache access */
+extern uint64 catalog_cache_clock;
+
 extern void CreateCacheMemoryContext(void);
 
 extern CatCache *InitCatCache(int id, Oid reloid, Oid indexoid,
@@ -225,6 +243,8 @@ extern void PrepareToInvalidateCacheTuple(Relation relation,
 							  HeapTuple newtuple,
 							  void (*function) (int, uint32, Oid));
 
+extern void CatalogCacheEnforceMemoryTarget(bool include_relcache);
+
 extern void PrintCatCacheLeakWarning(HeapTuple tuple);
 extern void PrintCatCacheListLeakWarning(CatCList *list);
 
@@ -22,6 +22,17 @@
 
 typedef struct LogicalTapeSet LogicalTapeSet;
 
+/* Compression methods for the data written to logical tapes */
+typedef enum TapeCompression
+{
+	TAPE_COMPRESSION_NONE = 0,
+	TAPE_COMPRESSION_PGLZ,
+	TAPE_COMPRESSION_LZ4
+} TapeCompression;
+
+/* GUC variable */
+extern int	tape_compression;
+
 /*
  * The approach tuplesort.c takes to parallel external sorts is that workers,
  * whose state is almost the same as independent serial sorts, are made to
@@ -55,7 +66,8 @@ typedef struct TapeShare
  */
 
 extern LogicalTapeSet *LogicalTapeSetCreate(int ntapes, TapeShare *shared,
-					 SharedFileSet *fileset, int worker);
+					 SharedFileSet *fileset, int worker,
+					 TapeCompression compression);
 extern void LogicalTapeSetClose(LogicalTapeSet *lts);
 extern void LogicalTapeSetForgetFreeSpace(LogicalTapeSet *lts);
 extern size_t LogicalTapeRead(LogicalTapeSet *lts, int tapenum,
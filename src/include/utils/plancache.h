@@ -28,7 +28,8 @@ typedef enum
 {
 	PLAN_CACHE_MODE_AUTO,
 	PLAN_CACHE_MODE_FORCE_GENERIC_PLAN,
-	PLAN_CACHE_MODE_FORCE_CUSTOM_PLAN
+	PLAN_CACHE_MODE_FORCE_CUSTOM_PLAN,
+	PLAN_CACHE_MODE_ADAPTIVE
 }			PlanCacheMode;
 
 /* GUC parameter */
@@ -128,6 +129,11 @@ typedef struct CachedPlanSource
 	double		generic_cost;	/* cost of generic plan, or -1 if not known */
 	double		total_custom_cost;	/* total cost of custom plans so far */
 	int			num_custom_plans;	/* number of plans included in total */
+	/* Measured times, in ms, used when plan_cache_mode is "adaptive": */
+	double		generic_time;	/* avg run time of generic plan, or -1 */
+	double		custom_time;	/* avg run time of custom plans, or -1 */
+	double		custom_plan_time;	/* avg planning time of same, or -1 */
+	int			num_adaptive_choices;	/* choices made from measured times */
 } CachedPlanSource;
 
 /*
@@ -217,8 +223,14 @@ extern CachedPlan *GetCachedPlan(CachedPlanSource *plansource,
 			  ParamListInfo boundParams,
 			  bool useResOwner,
 			  QueryEnvironment *queryEnv);
+extern CachedPlan *GetSimplyValidCachedPlan(CachedPlanSource *plansource,
+						 int generation,
+						 bool useResOwner);
 extern void ReleaseCachedPlan(CachedPlan *plan, bool useResOwner);
 
+extern void CachedPlanRecordRuntime(CachedPlanSource *plansource,
+						CachedPlan *plan, double elapsed);
+
 extern CachedExpression *GetCachedExpression(Node *expr);
 extern void FreeCachedExpression(CachedExpression *cexpr);
 
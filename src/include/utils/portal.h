@@ -234,6 +234,7 @@ extern PlannedStmt *PortalGetPrimaryStmt(Portal portal);
 extern void PortalCreateHoldStore(Portal portal);
 extern void PortalHashTableDeleteAll(void);
 extern bool ThereAreNoReadyPortals(void);
+extern bool ThereAreHeldPortals(void);
 extern void HoldPinnedPortals(void);
 
 #endif							/* PORTAL_H */
@@ -112,6 +112,7 @@ typedef struct RelationData
 	/* data managed by RelationGetIndexAttrBitmap: */
 	Bitmapset  *rd_indexattr;	/* columns used in non-projection indexes */
 	Bitmapset  *rd_projindexattr;	/* columns used in projection indexes */
+	Bitmapset  *rd_summarizedattr;	/* columns used in summarizing indexes */
 	Bitmapset  *rd_keyattr;		/* cols that can be ref'd by foreign keys */
 	Bitmapset  *rd_pkattr;		/* cols included in primary key */
 	Bitmapset  *rd_idattr;		/* included in replica identity index */
@@ -126,6 +127,12 @@ typedef struct RelationData
 	 */
 	bytea	   *rd_options;		/* parsed pg_class.reloptions */
 
+	/*
+	 * Table access method API struct, for relations with table storage
+	 * (NULL otherwise).  rd_amhandler is the OID of its handler function.
+	 */
+	const struct TableAmRoutine *rd_tableam;
+
 	/* These are non-NULL only for an index relation: */
 	Form_pg_index rd_index;		/* pg_index tuple describing this index */
 	/* use "struct" here to avoid needing to include htup.h: */
@@ -146,7 +153,7 @@ typedef struct RelationData
 	 * rd_indexcxt.  A relcache reset will include freeing that chunk and
 	 * setting rd_amcache = NULL.
 	 */
-	Oid			rd_amhandler;	/* OID of index AM's handler function */
+	Oid			rd_amhandler;	/* OID of index or table AM's handler */
 	MemoryContext rd_indexcxt;	/* private memory cxt for this stuff */
 	/* use "struct" here to avoid needing to include amapi.h: */
 	struct IndexAmRoutine *rd_amroutine;	/* index AM's API struct */
@@ -239,6 +246,7 @@ typedef struct AutoVacOpts
 {
 	bool		enabled;
 	int			vacuum_threshold;
+	int			vacuum_ins_threshold;
 	int			analyze_threshold;
 	int			vacuum_cost_delay;
 	int			vacuum_cost_limit;
@@ -250,6 +258,7 @@ typedef struct AutoVacOpts
 	int			multixact_freeze_table_age;
 	int			log_min_duration;
 	float8		vacuum_scale_factor;
+	float8		vacuum_ins_scale_factor;
 	float8		analyze_scale_factor;
 } AutoVacOpts;
 
@@ -259,10 +268,13 @@ typedef struct StdRdOptions
 	int			fillfactor;		/* page fill factor in percent (0..100) */
 	/* fraction of newly inserted tuples prior to trigger index cleanup */
 	float8		vacuum_cleanup_index_scale_factor;
+	bool		deduplicate_items;	/* try to merge duplicate btree items? */
 	int			toast_tuple_target; /* target for tuple toasting */
 	AutoVacOpts autovacuum;		/* autovacuum-related options */
 	bool		user_catalog_table; /* use as an additional catalog relation */
 	int			parallel_workers;	/* max number of parallel workers */
+	bool		vacuum_index_cleanup;	/* enables index vacuuming and cleanup */
+	bool		incremental_maintenance;	/* matview maintained by triggers */
 } StdRdOptions;
 
 #define HEAP_MIN_FILLFACTOR			10
@@ -309,6 +321,16 @@ typedef struct StdRdOptions
 	  (relation)->rd_rel->relkind == RELKIND_MATVIEW) ? \
 	 ((StdRdOptions *) (relation)->rd_options)->user_catalog_table : false)
 
+/*
+ * RelationIsIncrementallyMaintained
+ *		Returns whether the relation is a materialized view kept up to date
+ *		by triggers on its base tables.  Note multiple eval of argument!
+ */
+#define RelationIsIncrementallyMaintained(relation) \
+	((relation)->rd_options && \
+	 (relation)->rd_rel->relkind == RELKIND_MATVIEW ? \
+	 ((StdRdOptions *) (relation)->rd_options)->incremental_maintenance : false)
+
 /*
  * RelationGetParallelWorkers
  *		Returns the relation's parallel_workers reloption setting.
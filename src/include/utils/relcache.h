@@ -54,6 +54,7 @@ typedef enum IndexAttrBitmapKind
 {
 	INDEX_ATTR_BITMAP_HOT,
 	INDEX_ATTR_BITMAP_PROJ,
+	INDEX_ATTR_BITMAP_SUMMARIZED,
 	INDEX_ATTR_BITMAP_KEY,
 	INDEX_ATTR_BITMAP_PRIMARY_KEY,
 	INDEX_ATTR_BITMAP_IDENTITY_KEY
@@ -71,6 +72,7 @@ extern void RelationSetIndexList(Relation relation,
 					 List *indexIds);
 
 extern void RelationInitIndexAccessInfo(Relation relation);
+extern void RelationInitTableAccessMethod(Relation relation);
 
 /* caller must include pg_publication.h */
 struct PublicationActions;
@@ -99,6 +101,7 @@ extern Relation RelationBuildLocalRelation(const char *relname,
 						   TupleDesc tupDesc,
 						   Oid relid,
 						   Oid relfilenode,
+						   Oid accessmtd,
 						   Oid reltablespace,
 						   bool shared_relation,
 						   bool mapped_relation,
@@ -123,6 +126,10 @@ extern void RelationCacheInvalidate(void);
 extern void RelationCloseSmgrByOid(Oid relationId);
 
 extern void AtEOXact_RelationCache(bool isCommit);
+extern Size RelationCacheMemoryUsage(void);
+extern bool RelationCacheEvictOldest(uint64 older_than);
+extern void RelationCacheGetStats(long *entries, Size *memusage, long *hits,
+					  long *loads, long *evictions, long *invals);
 extern void AtEOSubXact_RelationCache(bool isCommit, SubTransactionId mySubid,
 						  SubTransactionId parentSubid);
 
@@ -124,7 +124,9 @@ typedef struct
  *
  * Callers should initialize all fields of GenericCosts to zero.  In addition,
  * they can set numIndexTuples to some positive value if they have a better
- * than default way of estimating the number of leaf index tuples visited.
+ * than default way of estimating the number of leaf index tuples visited,
+ * and num_sa_scans to the number of primitive index scans they'll do apart
+ * from those induced by ScalarArrayOpExpr quals.
  */
 typedef struct
 {
@@ -176,6 +178,8 @@ extern double histogram_selectivity(VariableStatData *vardata, FmgrInfo *opproc,
 					  Datum constval, bool varonleft,
 					  int min_hist_size, int n_skip,
 					  int *hist_size);
+extern List *get_sort_histogram_bounds(PlannerInfo *root, Node *expr,
+						  Oid sortop, Oid collation);
 
 extern Pattern_Prefix_Status pattern_fixed_prefix(Const *patt,
 					 Pattern_Type ptype,
@@ -91,12 +91,20 @@ typedef struct SnapshotData
 	TransactionId *subxip;
 	int32		subxcnt;		/* # of xact ids in subxip[] */
 	bool		suboverflowed;	/* has the subxip array overflowed? */
+	bool		xipSorted;		/* have xip[] and subxip[] been sorted? */
 
 	bool		takenDuringRecovery;	/* recovery-shaped snapshot? */
 	bool		copied;			/* false if it's a static snapshot */
 
 	CommandId	curcid;			/* in my xact, CID < curcid are visible */
 
+	/*
+	 * For static snapshots filled in by GetSnapshotData, the procarray's
+	 * transaction completion count at that time, or 0 if the contents must
+	 * not be reused.
+	 */
+	uint64		snapXactCompletionCount;
+
 	/*
 	 * An extra return value for HeapTupleSatisfiesDirty, not used in MVCC
 	 * snapshots.
@@ -35,6 +35,9 @@
 typedef struct Tuplesortstate Tuplesortstate;
 typedef struct Sharedsort Sharedsort;
 
+/* GinTuple is declared in access/gin_tuple.h */
+struct GinTuple;
+
 /*
  * Tuplesort parallel coordination state, allocated by each participant in
  * local memory.  Participant caller initializes everything.  See usage notes
@@ -209,6 +212,14 @@ extern Tuplesortstate *tuplesort_begin_index_hash(Relation heapRel,
 						   uint32 max_buckets,
 						   int workMem, SortCoordinate coordinate,
 						   bool randomAccess);
+extern Tuplesortstate *tuplesort_begin_index_gin(Relation heapRel,
+						  Relation indexRel,
+						  int workMem, SortCoordinate coordinate,
+						  bool randomAccess);
+extern Tuplesortstate *tuplesort_begin_index_gist(Relation heapRel,
+						   Relation indexRel,
+						   int workMem, SortCoordinate coordinate,
+						   bool randomAccess);
 extern Tuplesortstate *tuplesort_begin_datum(Oid datumType,
 					  Oid sortOperator, Oid sortCollation,
 					  bool nullsFirstFlag,
@@ -225,6 +236,8 @@ extern void tuplesort_putindextuplevalues(Tuplesortstate *state,
 							  Datum *values, bool *isnull);
 extern void tuplesort_putdatum(Tuplesortstate *state, Datum val,
 				   bool isNull);
+extern void tuplesort_putgintuple(Tuplesortstate *state,
+					  struct GinTuple *tuple);
 
 extern void tuplesort_performsort(Tuplesortstate *state);
 
@@ -232,6 +245,8 @@ extern bool tuplesort_gettupleslot(Tuplesortstate *state, bool forward,
 					   bool copy, TupleTableSlot *slot, Datum *abbrev);
 extern HeapTuple tuplesort_getheaptuple(Tuplesortstate *state, bool forward);
 extern IndexTuple tuplesort_getindextuple(Tuplesortstate *state, bool forward);
+extern struct GinTuple *tuplesort_getgintuple(Tuplesortstate *state,
+					  bool forward);
 extern bool tuplesort_getdatum(Tuplesortstate *state, bool forward,
 				   Datum *val, bool *isNull, Datum *abbrev);
 
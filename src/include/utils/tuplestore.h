@@ -39,6 +39,9 @@
  */
 typedef struct Tuplestorestate Tuplestorestate;
 
+/* GUC variable */
+extern bool tuplestore_compression;
+
 /*
  * Currently we only need to store MinimalTuples, but it would be easy
  * to support the same behavior for IndexTuples and/or bare Datums.
@@ -264,6 +264,14 @@ static const internalPQconninfoOption PQconninfoOptions[] = {
 		"TCP-Keepalives-Count", "", 10, /* strlen(INT32_MAX) == 10 */
 	offsetof(struct pg_conn, keepalives_count)},
 
+	{"compression", "PGCOMPRESSION", "0", NULL,
+		"Compression", "", 1,
+	offsetof(struct pg_conn, compression)},
+
+	{"row_batch_size", "PGROWBATCHSIZE", "0", NULL,
+		"Row-Batch-Size", "", 10,	/* strlen(INT32_MAX) == 10 */
+	offsetof(struct pg_conn, row_batch_size)},
+
 	/*
 	 * ssl options are allowed even without client SSL support because the
 	 * client can still handle SSL modes "disable" and "allow". Other
@@ -362,7 +370,10 @@ static bool fillPGconn(PGconn *conn, PQconninfoOption *connOptions);
 static void freePGconn(PGconn *conn);
 static void closePGconn(PGconn *conn);
 static void release_conn_addrinfo(PGconn *conn);
+static void pqFreeCommandQueue(PGcmdQueueEntry *queue);
 static void sendTerminateConn(PGconn *conn);
+static bool parse_int_param(const char *value, int *result, PGconn *conn,
+				const char *context);
 static PQconninfoOption *conninfo_init(PQExpBuffer errorMessage);
 static PQconninfoOption *parse_connection_string(const char *conninfo,
 						PQExpBuffer errorMessage, bool use_defaults);
@@ -441,6 +452,18 @@ pqDropConnection(PGconn *conn, bool flushInput)
 	/* Always discard any unsent data */
 	conn->outCount = 0;
 
+	/* Forget about any partly processed DataRowBatch message */
+	conn->batchRow = 0;
+
+	/* A new connection starts out uncompressed */
+#ifdef HAVE_LIBZ
+	if (conn->zstream)
+	{
+		zpq_free(conn->zstream);
+		conn->zstream = NULL;
+	}
+#endif
+
 	/* Free authentication state */
 #ifdef ENABLE_GSS
 	{
@@ -1234,6 +1257,54 @@ connectOptions2(PGconn *conn)
 			goto oom_error;
 	}
 
+	/*
+	 * Validate compression option.
+	 */
+	if (conn->compression)
+	{
+		if (strcmp(conn->compression, "0") != 0
+			&& strcmp(conn->compression, "1") != 0)
+		{
+			conn->status = CONNECTION_BAD;
+			printfPQExpBuffer(&conn->errorMessage,
+							  libpq_gettext("invalid compression value: \"%s\"\n"),
+							  conn->compression);
+			return false;
+		}
+#ifndef HAVE_LIBZ
+		if (conn->compression[0] == '1')
+		{
+			conn->status = CONNECTION_BAD;
+			printfPQExpBuffer(&conn->errorMessage,
+							  libpq_gettext("compression value \"%s\" invalid when zlib support is not compiled in\n"),
+							  conn->compression);
+			return false;
+		}
+#endif
+	}
+
+	/*
+	 * Validate row_batch_size option.
+	 */
+	conn->rowBatchSize = 0;
+	if (conn->row_batch_size)
+	{
+		if (!parse_int_param(conn->row_batch_size, &conn->rowBatchSize,
+							 conn, "row_batch_size"))
+		{
+			conn->status = CONNECTION_BAD;
+			return false;
+		}
+		if (conn->rowBatchSize < 0)
+		{
+			conn->status = CONNECTION_BAD;
+			printfPQExpBuffer(&conn->errorMessage,
+							  libpq_gettext("invalid row_batch_size value: \"%s\"\n"),
+							  conn->row_batch_size);
+			return false;
+		}
+	}
+
 	/*
 	 * Validate target_session_attrs option.
 	 */
@@ -2868,10 +2939,13 @@ keep_going:						/* We will come back to here until there is
 
 				/*
 				 * Validate message type: we expect only an authentication
-				 * request or an error here.  Anything else probably means
-				 * it's not Postgres on the other end at all.
+				 * request, a protocol negotiation or an error here.  Anything
+				 * else probably means it's not Postgres on the other end at
+				 * all.
 				 */
-				if (!(beresp == 'R' || beresp == 'E'))
+				if (!(beresp == 'R' || beresp == 'E' ||
+					  (beresp == 'v' &&
+					   PG_PROTOCOL_MAJOR(conn->pversion) >= 3)))
 				{
 					appendPQExpBuffer(&conn->errorMessage,
 									  libpq_gettext(
@@ -2968,6 +3042,20 @@ keep_going:						/* We will come back to here until there is
 					return PGRES_POLLING_READING;
 				}
 
+				/*
+				 * The server doesn't know all the protocol options we sent.
+				 * The ones we send are _pq_.compression and
+				 * _pq_.row_batch_size, and without them the traffic just
+				 * isn't compressed and rows come in DataRow messages, so
+				 * carry on.
+				 */
+				if (beresp == 'v')
+				{
+					conn->inCursor += msgLength;
+					conn->inStart = conn->inCursor;
+					goto keep_going;
+				}
+
 				/* Handle errors. */
 				if (beresp == 'E')
 				{
@@ -3678,6 +3766,10 @@ freePGconn(PGconn *conn)
 		free(conn->keepalives_interval);
 	if (conn->keepalives_count)
 		free(conn->keepalives_count);
+	if (conn->compression)
+		free(conn->compression);
+	if (conn->row_batch_size)
+		free(conn->row_batch_size);
 	if (conn->sslmode)
 		free(conn->sslmode);
 	if (conn->sslcert)
@@ -3703,14 +3795,16 @@ freePGconn(PGconn *conn)
 		free(conn->gsslib);
 #endif
 	/* Note that conn->Pfdebug is not ours to close or free */
-	if (conn->last_query)
-		free(conn->last_query);
+	pqFreeCommandQueue(conn->cmd_queue_head);
+	pqFreeCommandQueue(conn->cmd_queue_recycle);
 	if (conn->inBuffer)
 		free(conn->inBuffer);
 	if (conn->outBuffer)
 		free(conn->outBuffer);
 	if (conn->rowBuf)
 		free(conn->rowBuf);
+	if (conn->batchCols)
+		free(conn->batchCols);
 	if (conn->target_session_attrs)
 		free(conn->target_session_attrs);
 	termPQExpBuffer(&conn->errorMessage);
@@ -3723,6 +3817,24 @@ freePGconn(PGconn *conn)
 #endif
 }
 
+/*
+ * pqFreeCommandQueue
+ *	 - Free all the entries of a command queue (or of its free list).
+ */
+static void
+pqFreeCommandQueue(PGcmdQueueEntry *queue)
+{
+	while (queue != NULL)
+	{
+		PGcmdQueueEntry *cur = queue;
+
+		queue = cur->next;
+		if (cur->query)
+			free(cur->query);
+		free(cur);
+	}
+}
+
 /*
  * release_conn_addrinfo
  *	 - Free any addrinfo list in the PGconn.
@@ -3792,6 +3904,9 @@ closePGconn(PGconn *conn)
 	conn->status = CONNECTION_BAD;	/* Well, not really _bad_ - just absent */
 	conn->asyncStatus = PGASYNC_IDLE;
 	conn->xactStatus = PQTRANS_IDLE;
+	conn->pipelineStatus = PQ_PIPELINE_OFF;
+	pqFreeCommandQueue(conn->cmd_queue_head);
+	conn->cmd_queue_head = conn->cmd_queue_tail = NULL;
 	pqClearAsyncResult(conn);	/* deallocate result */
 	resetPQExpBuffer(&conn->errorMessage);
 	release_conn_addrinfo(conn);
@@ -6266,6 +6381,15 @@ PQtransactionStatus(const PGconn *conn)
 	return conn->xactStatus;
 }
 
+PGpipelineStatus
+PQpipelineStatus(const PGconn *conn)
+{
+	if (!conn)
+		return PQ_PIPELINE_OFF;
+
+	return conn->pipelineStatus;
+}
+
 const char *
 PQparameterStatus(const PGconn *conn, const char *paramName)
 {
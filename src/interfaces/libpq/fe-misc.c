@@ -56,6 +56,13 @@
 
 static int	pqPutMsgBytes(const void *buf, size_t len, PGconn *conn);
 static int	pqSendSome(PGconn *conn, int len);
+static ssize_t pqRecvBytes(PGconn *conn, void *ptr, size_t len);
+static ssize_t pqSendBytes(PGconn *conn, const void *ptr, size_t len);
+static bool pqSendPending(PGconn *conn);
+#ifdef HAVE_LIBZ
+static ssize_t pqZpqTx(void *arg, const void *data, size_t size);
+static ssize_t pqZpqRx(void *arg, void *data, size_t size);
+#endif
 static int pqSocketCheck(PGconn *conn, int forRead, int forWrite,
 			  time_t end_time);
 static int	pqSocketPoll(int sock, int forRead, int forWrite, time_t end_time);
@@ -678,8 +685,8 @@ pqReadData(PGconn *conn)
 
 	/* OK, try to read some data */
 retry3:
-	nread = pqsecure_read(conn, conn->inBuffer + conn->inEnd,
-						  conn->inBufSize - conn->inEnd);
+	nread = pqRecvBytes(conn, conn->inBuffer + conn->inEnd,
+						conn->inBufSize - conn->inEnd);
 	if (nread < 0)
 	{
 		if (SOCK_ERRNO == EINTR)
@@ -705,6 +712,22 @@ retry3:
 	{
 		conn->inEnd += nread;
 
+#ifdef HAVE_LIBZ
+
+		/*
+		 * Data held by the decompressor doesn't make the socket read-ready,
+		 * so get it all now, lest we wait for data we have already received.
+		 */
+		if (conn->zstream && zpq_buffered_rx(conn->zstream))
+		{
+			if (conn->inBufSize - conn->inEnd < 8192 &&
+				pqCheckInBufferSpace(conn->inEnd + (size_t) 8192, conn))
+				return -1;		/* errorMessage already set */
+			someread = 1;
+			goto retry3;
+		}
+#endif
+
 		/*
 		 * Hack to deal with the fact that some kernels will only give us back
 		 * 1 packet per recv() call, even if we asked for more and there is
@@ -768,8 +791,8 @@ retry3:
 	 * arrived.
 	 */
 retry4:
-	nread = pqsecure_read(conn, conn->inBuffer + conn->inEnd,
-						  conn->inBufSize - conn->inEnd);
+	nread = pqRecvBytes(conn, conn->inBuffer + conn->inEnd,
+						conn->inBufSize - conn->inEnd);
 	if (nread < 0)
 	{
 		if (SOCK_ERRNO == EINTR)
@@ -794,6 +817,14 @@ retry4:
 	if (nread > 0)
 	{
 		conn->inEnd += nread;
+#ifdef HAVE_LIBZ
+		/* as above */
+		if (conn->zstream && zpq_buffered_rx(conn->zstream))
+		{
+			someread = 1;
+			goto retry3;
+		}
+#endif
 		return 1;
 	}
 
@@ -841,13 +872,16 @@ pqSendSome(PGconn *conn, int len)
 		return -1;
 	}
 
-	/* while there's still data to send */
-	while (len > 0)
+	/*
+	 * while there's still data to send, counting data that compression may
+	 * still hold
+	 */
+	while (len > 0 || pqSendPending(conn))
 	{
 		int			sent;
 
 #ifndef WIN32
-		sent = pqsecure_write(conn, ptr, len);
+		sent = pqSendBytes(conn, ptr, len);
 #else
 
 		/*
@@ -855,7 +889,7 @@ pqSendSome(PGconn *conn, int len)
 		 * failure-point appears to be different in different versions of
 		 * Windows, but 64k should always be safe.
 		 */
-		sent = pqsecure_write(conn, ptr, Min(len, 65536));
+		sent = pqSendBytes(conn, ptr, Min(len, 65536));
 #endif
 
 		if (sent < 0)
@@ -896,7 +930,7 @@ pqSendSome(PGconn *conn, int len)
 			remaining -= sent;
 		}
 
-		if (len > 0)
+		if (len > 0 || pqSendPending(conn))
 		{
 			/*
 			 * We didn't send it all, wait till we can send more.
@@ -963,12 +997,161 @@ pqFlush(PGconn *conn)
 	if (conn->Pfdebug)
 		fflush(conn->Pfdebug);
 
-	if (conn->outCount > 0)
+	if (conn->outCount > 0 || pqSendPending(conn))
 		return pqSendSome(conn, conn->outCount);
 
 	return 0;
 }
 
+/*
+ * pqRecvBytes: read data from the connection
+ *
+ * Like pqsecure_read(), but decompresses the data if the traffic is
+ * compressed.
+ */
+static ssize_t
+pqRecvBytes(PGconn *conn, void *ptr, size_t len)
+{
+#ifdef HAVE_LIBZ
+	if (conn->zstream)
+	{
+		ssize_t		n;
+
+		n = zpq_read(conn->zstream, ptr, len);
+		if (n == ZPQ_STREAM_ERROR)
+		{
+			printfPQExpBuffer(&conn->errorMessage,
+							  libpq_gettext("could not decompress data from server: %s\n"),
+							  zpq_error(conn->zstream));
+			SOCK_ERRNO_SET(EIO);
+			return -1;
+		}
+		return n;
+	}
+#endif
+
+	return pqsecure_read(conn, ptr, len);
+}
+
+/*
+ * pqSendBytes: write data to the connection
+ *
+ * Like pqsecure_write(), but compresses the data if the traffic is
+ * compressed.  In that case, some of the data consumed may still be
+ * buffered in the compression stream when this returns, see
+ * pqSendPending(); len can be 0 to only send that data.
+ */
+static ssize_t
+pqSendBytes(PGconn *conn, const void *ptr, size_t len)
+{
+#ifdef HAVE_LIBZ
+	if (conn->zstream)
+	{
+		ssize_t		n;
+
+		/*
+		 * The stream may first have to send compressed data before it takes
+		 * more input, which isn't a short write.
+		 */
+		do
+		{
+			n = zpq_write(conn->zstream, ptr, len);
+		} while (n == 0 && len > 0);
+
+		if (n == ZPQ_STREAM_ERROR)
+		{
+			printfPQExpBuffer(&conn->errorMessage,
+							  libpq_gettext("could not compress data to server: %s\n"),
+							  zpq_error(conn->zstream));
+			SOCK_ERRNO_SET(EIO);
+			return -1;
+		}
+		return n;
+	}
+#endif
+
+	return pqsecure_write(conn, ptr, len);
+}
+
+/*
+ * pqSendPending: is compressed data waiting to be sent?
+ */
+static bool
+pqSendPending(PGconn *conn)
+{
+#ifdef HAVE_LIBZ
+	if (conn->zstream)
+		return zpq_buffered_tx(conn->zstream);
+#endif
+
+	return false;
+}
+
+/*
+ * pqStartCompression: compress all further traffic
+ *
+ * Called when the server's CompressionAck message has been read.  Any data
+ * following it in the input buffer is already compressed, so it's handed
+ * over to the compression stream.
+ *
+ * Returns 0 if OK, or EOF with errorMessage set.
+ */
+int
+pqStartCompression(PGconn *conn, const char *algorithm)
+{
+#ifdef HAVE_LIBZ
+	if (conn->compression == NULL || conn->compression[0] != '1' ||
+		conn->zstream != NULL)
+	{
+		printfPQExpBuffer(&conn->errorMessage,
+						  libpq_gettext("unexpected compression acknowledgement from server\n"));
+		return EOF;
+	}
+	if (strcmp(algorithm, ZPQ_ALGORITHM_NAME) != 0)
+	{
+		printfPQExpBuffer(&conn->errorMessage,
+						  libpq_gettext("server selected unsupported compression algorithm \"%s\"\n"),
+						  algorithm);
+		return EOF;
+	}
+
+	conn->zstream = zpq_create(pqZpqTx, pqZpqRx, conn,
+							   conn->inBuffer + conn->inCursor,
+							   conn->inEnd - conn->inCursor);
+	if (conn->zstream == NULL)
+	{
+		printfPQExpBuffer(&conn->errorMessage,
+						  libpq_gettext("out of memory\n"));
+		return EOF;
+	}
+	conn->inEnd = conn->inCursor;
+
+	return 0;
+#else
+	printfPQExpBuffer(&conn->errorMessage,
+					  libpq_gettext("unexpected compression acknowledgement from server\n"));
+	return EOF;
+#endif
+}
+
+#ifdef HAVE_LIBZ
+/*
+ * Callbacks of the compression stream, sending and receiving compressed
+ * data.
+ */
+static ssize_t
+pqZpqTx(void *arg, const void *data, size_t size)
+{
+	return pqsecure_write((PGconn *) arg, data, size);
+}
+
+static ssize_t
+pqZpqRx(void *arg, void *data, size_t size)
+{
+	return pqsecure_read((PGconn *) arg, data, size);
+}
+#endif
+
 
 /*
  * pqWait: wait until we can read or write the connection socket
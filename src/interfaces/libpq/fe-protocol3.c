@@ -38,14 +38,15 @@
  * than a couple of kilobytes).
  */
 #define VALID_LONG_MESSAGE_TYPE(id) \
-	((id) == 'T' || (id) == 'D' || (id) == 'd' || (id) == 'V' || \
-	 (id) == 'E' || (id) == 'N' || (id) == 'A')
+	((id) == 'T' || (id) == 'D' || (id) == 'b' || (id) == 'd' || \
+	 (id) == 'V' || (id) == 'E' || (id) == 'N' || (id) == 'A')
 
 
 static void handleSyncLoss(PGconn *conn, char id, int msgLength);
 static int	getRowDescriptions(PGconn *conn, int msgLength);
 static int	getParamDescriptions(PGconn *conn, int msgLength);
 static int	getAnotherTuple(PGconn *conn, int msgLength);
+static int	getAnotherBatch(PGconn *conn, int msgLength);
 static int	getParameterStatus(PGconn *conn);
 static int	getNotify(PGconn *conn);
 static int	getCopyStart(PGconn *conn, ExecStatusType copytype);
@@ -218,11 +219,39 @@ pqParseInput3(PGconn *conn)
 					if (pqGetErrorNotice3(conn, true))
 						return;
 					conn->asyncStatus = PGASYNC_READY;
+
+					/*
+					 * In pipeline mode, the server now skips everything up to
+					 * the next Sync, so the queued commands before it are
+					 * aborted.
+					 */
+					if (conn->pipelineStatus != PQ_PIPELINE_OFF)
+						conn->pipelineStatus = PQ_PIPELINE_ABORTED;
 					break;
-				case 'Z':		/* backend is ready for new query */
+				case 'Z':		/* sync response, backend is ready for new
+								 * query */
 					if (getReadyForQuery(conn))
 						return;
-					conn->asyncStatus = PGASYNC_IDLE;
+					if (conn->pipelineStatus != PQ_PIPELINE_OFF)
+					{
+						conn->result = PQmakeEmptyPGresult(conn,
+														   PGRES_PIPELINE_SYNC);
+						if (!conn->result)
+						{
+							printfPQExpBuffer(&conn->errorMessage,
+											  libpq_gettext("out of memory"));
+							pqSaveErrorResult(conn);
+						}
+						else
+							conn->pipelineStatus = PQ_PIPELINE_ON;
+						conn->asyncStatus = PGASYNC_READY;
+					}
+					else
+					{
+						/* Advance the command queue and set us idle */
+						pqCommandQueueAdvance(conn, true, false);
+						conn->asyncStatus = PGASYNC_IDLE;
+					}
 					break;
 				case 'I':		/* empty query */
 					if (conn->result == NULL)
@@ -240,7 +269,8 @@ pqParseInput3(PGconn *conn)
 					break;
 				case '1':		/* Parse Complete */
 					/* If we're doing PQprepare, we're done; else ignore */
-					if (conn->queryclass == PGQUERY_PREPARE)
+					if (conn->cmd_queue_head &&
+						conn->cmd_queue_head->queryclass == PGQUERY_PREPARE)
 					{
 						if (conn->result == NULL)
 						{
@@ -276,6 +306,24 @@ pqParseInput3(PGconn *conn)
 					if (pqGetInt(&(conn->be_key), 4, conn))
 						return;
 					break;
+				case 'z':		/* CompressionAck */
+
+					/*
+					 * Sent right after the authentication, if we asked for
+					 * compression.  Everything after it is compressed.
+					 */
+					if (pqGets(&conn->workBuffer, conn))
+						return;
+					if (pqStartCompression(conn, conn->workBuffer.data))
+					{
+						/* error message already set */
+						pqSaveErrorResult(conn);
+						conn->asyncStatus = PGASYNC_READY;
+						pqDropConnection(conn, true);
+						conn->status = CONNECTION_BAD;
+						return;
+					}
+					break;
 				case 'T':		/* Row Description */
 					if (conn->result != NULL &&
 						conn->result->resultStatus == PGRES_FATAL_ERROR)
@@ -287,7 +335,8 @@ pqParseInput3(PGconn *conn)
 						conn->inCursor += msgLength;
 					}
 					else if (conn->result == NULL ||
-							 conn->queryclass == PGQUERY_DESCRIBE)
+							 (conn->cmd_queue_head &&
+							  conn->cmd_queue_head->queryclass == PGQUERY_DESCRIBE))
 					{
 						/* First 'T' in a query sequence */
 						if (getRowDescriptions(conn, msgLength))
@@ -320,7 +369,8 @@ pqParseInput3(PGconn *conn)
 					 * instead of TUPLES_OK.  Otherwise we can just ignore
 					 * this message.
 					 */
-					if (conn->queryclass == PGQUERY_DESCRIBE)
+					if (conn->cmd_queue_head &&
+						conn->cmd_queue_head->queryclass == PGQUERY_DESCRIBE)
 					{
 						if (conn->result == NULL)
 						{
@@ -370,6 +420,35 @@ pqParseInput3(PGconn *conn)
 						conn->inCursor += msgLength;
 					}
 					break;
+				case 'b':		/* Data Row Batch */
+					if (conn->result != NULL &&
+						conn->result->resultStatus == PGRES_TUPLES_OK)
+					{
+						/* Read more tuples of a normal query response */
+						if (getAnotherBatch(conn, msgLength))
+							return;
+						/* getAnotherBatch() moves inStart itself */
+						continue;
+					}
+					else if (conn->result != NULL &&
+							 conn->result->resultStatus == PGRES_FATAL_ERROR)
+					{
+						/*
+						 * We've already choked for some reason.  Just discard
+						 * tuples till we get to the end of the query.
+						 */
+						conn->inCursor += msgLength;
+					}
+					else
+					{
+						/* Set up to report error at end of query */
+						printfPQExpBuffer(&conn->errorMessage,
+										  libpq_gettext("server sent data (\"b\" message) without prior row description (\"T\" message)\n"));
+						pqSaveErrorResult(conn);
+						/* Discard the unexpected message */
+						conn->inCursor += msgLength;
+					}
+					break;
 				case 'G':		/* Start Copy In */
 					if (getCopyStart(conn, PGRES_COPY_IN))
 						return;
@@ -481,7 +560,8 @@ getRowDescriptions(PGconn *conn, int msgLength)
 	 * PGresult created by getParamDescriptions, and we should fill data into
 	 * that.  Otherwise, create a new, empty PGresult.
 	 */
-	if (conn->queryclass == PGQUERY_DESCRIBE)
+	if (conn->cmd_queue_head &&
+		conn->cmd_queue_head->queryclass == PGQUERY_DESCRIBE)
 	{
 		if (conn->result)
 			result = conn->result;
@@ -588,7 +668,8 @@ getRowDescriptions(PGconn *conn, int msgLength)
 	 * If we're doing a Describe, we're done, and ready to pass the result
 	 * back to the client.
 	 */
-	if (conn->queryclass == PGQUERY_DESCRIBE)
+	if (conn->cmd_queue_head &&
+		conn->cmd_queue_head->queryclass == PGQUERY_DESCRIBE)
 	{
 		conn->asyncStatus = PGASYNC_READY;
 		return 0;
@@ -864,6 +945,257 @@ set_error_result:
 }
 
 
+/*
+ * parseInput subroutine to read a 'b' (row data batch) message.
+ *
+ * The message holds the values of several rows, column by column.  We check
+ * the column sections and remember where each starts, then fill rowbuf from
+ * them and call the row processor once for each row.  In single-row mode,
+ * the row processor leaves the connection out of BUSY state after each row;
+ * we then return without advancing inStart, and continue with conn->batchRow
+ * when called again for the same message.
+ *
+ * Returns: 0 if processed message successfully, EOF to suspend parsing
+ * (the latter case is not actually used currently).
+ * In the former case, conn->inStart has been advanced past the message
+ * once all its rows have been processed.
+ */
+static int
+getAnotherBatch(PGconn *conn, int msgLength)
+{
+	PGresult   *result = conn->result;
+	int			nfields = result->numAttributes;
+	const char *errmsg;
+	PGdataValue *rowbuf;
+	PGbatchColumn *cols;
+	const char *msg;
+	int			i;
+
+	if (conn->batchRow == 0)
+	{
+		int			batchnfields;	/* # fields from batch */
+		int			nrows;
+
+		/* Get the field count and make sure it's what we expect */
+		if (pqGetInt(&batchnfields, 2, conn) ||
+			pqGetInt(&nrows, 4, conn))
+		{
+			/* We should not run out of data here, so complain */
+			errmsg = libpq_gettext("insufficient data in \"b\" message");
+			goto advance_and_error;
+		}
+
+		if (batchnfields != nfields)
+		{
+			errmsg = libpq_gettext("unexpected field count in \"b\" message");
+			goto advance_and_error;
+		}
+		if (nrows < 0)
+		{
+			errmsg = libpq_gettext("invalid row count in \"b\" message");
+			goto advance_and_error;
+		}
+
+		/* Resize column positions if needed */
+		cols = conn->batchCols;
+		if (nfields > conn->batchColsLen)
+		{
+			cols = (PGbatchColumn *) realloc(cols,
+											 nfields * sizeof(PGbatchColumn));
+			if (!cols)
+			{
+				errmsg = NULL;	/* means "out of memory", see below */
+				goto advance_and_error;
+			}
+			conn->batchCols = cols;
+			conn->batchColsLen = nfields;
+		}
+
+		/* Scan the column sections */
+		for (i = 0; i < nfields; i++)
+		{
+			int			width;
+			int			datalen;
+			int			nnotnull = 0;
+			int64		total = 0;
+			int			row;
+
+			if (pqGetInt(&width, 4, conn) ||
+				pqGetInt(&datalen, 4, conn))
+			{
+				errmsg = libpq_gettext("insufficient data in \"b\" message");
+				goto advance_and_error;
+			}
+			if (width < -1 || datalen < 0)
+			{
+				errmsg = libpq_gettext("invalid column data in \"b\" message");
+				goto advance_and_error;
+			}
+			cols[i].width = width;
+
+			/* skip the null bitmap, counting the non-null values */
+			cols[i].nulls = conn->inCursor - conn->inStart;
+			if (pqSkipnchar(nrows / 8 + (nrows % 8 != 0), conn))
+			{
+				errmsg = libpq_gettext("insufficient data in \"b\" message");
+				goto advance_and_error;
+			}
+			msg = conn->inBuffer + conn->inStart;
+			for (row = 0; row < nrows; row++)
+			{
+				if (msg[cols[i].nulls + row / 8] & (1 << (row % 8)))
+					nnotnull++;
+			}
+
+			/* skip their lengths, if they're given */
+			cols[i].lengths = conn->inCursor - conn->inStart;
+			if (width < 0)
+			{
+				if (nnotnull > (conn->inEnd - conn->inCursor) / 4 ||
+					pqSkipnchar(nnotnull * 4, conn))
+				{
+					errmsg = libpq_gettext("insufficient data in \"b\" message");
+					goto advance_and_error;
+				}
+				for (row = 0; row < nnotnull; row++)
+				{
+					uint32		vlen;
+
+					memcpy(&vlen, msg + cols[i].lengths + row * 4, 4);
+					vlen = pg_ntoh32(vlen);
+					if (vlen > PG_INT32_MAX)
+					{
+						errmsg = libpq_gettext("invalid column data in \"b\" message");
+						goto advance_and_error;
+					}
+					total += vlen;
+				}
+			}
+			else
+				total = (int64) width * nnotnull;
+
+			/* and the values themselves */
+			if (total != datalen)
+			{
+				errmsg = libpq_gettext("invalid column data in \"b\" message");
+				goto advance_and_error;
+			}
+			cols[i].data = conn->inCursor - conn->inStart;
+			if (pqSkipnchar(datalen, conn))
+			{
+				errmsg = libpq_gettext("insufficient data in \"b\" message");
+				goto advance_and_error;
+			}
+		}
+
+		/* Sanity check that we absorbed all the data */
+		if (conn->inCursor != conn->inStart + 5 + msgLength)
+		{
+			errmsg = libpq_gettext("extraneous data in \"b\" message");
+			goto advance_and_error;
+		}
+
+		conn->batchRows = nrows;
+	}
+
+	/* Resize row buffer if needed */
+	rowbuf = conn->rowBuf;
+	if (nfields > conn->rowBufLen)
+	{
+		rowbuf = (PGdataValue *) realloc(rowbuf,
+										 nfields * sizeof(PGdataValue));
+		if (!rowbuf)
+		{
+			errmsg = NULL;		/* means "out of memory", see below */
+			goto advance_and_error;
+		}
+		conn->rowBuf = rowbuf;
+		conn->rowBufLen = nfields;
+	}
+
+	/* Process the rows, stopping if the row processor wants us to */
+	cols = conn->batchCols;
+	msg = conn->inBuffer + conn->inStart;
+	while (conn->batchRow < conn->batchRows)
+	{
+		int			row = conn->batchRow;
+
+		for (i = 0; i < nfields; i++)
+		{
+			int			vlen;
+
+			/* as in getAnotherTuple, value points to the next value */
+			rowbuf[i].value = msg + cols[i].data;
+
+			if (!(msg[cols[i].nulls + row / 8] & (1 << (row % 8))))
+			{
+				rowbuf[i].len = -1;
+				continue;
+			}
+
+			if (cols[i].width >= 0)
+				vlen = cols[i].width;
+			else
+			{
+				uint32		len32;
+
+				memcpy(&len32, msg + cols[i].lengths, 4);
+				vlen = (int) pg_ntoh32(len32);
+				cols[i].lengths += 4;
+			}
+			rowbuf[i].len = vlen;
+			cols[i].data += vlen;
+		}
+
+		conn->batchRow++;
+
+		errmsg = NULL;
+		if (!pqRowProcessor(conn, &errmsg))
+			goto advance_and_error;		/* pqRowProcessor failed, report it */
+
+		if (conn->asyncStatus != PGASYNC_BUSY &&
+			conn->batchRow < conn->batchRows)
+			return 0;			/* come back for the remaining rows */
+	}
+
+	/* Advance inStart to show that the "b" message has been processed. */
+	conn->inStart += 5 + msgLength;
+	conn->batchRow = 0;
+
+	return 0;					/* normal, successful exit */
+
+advance_and_error:
+	/* Discard the failed message by pretending we read it */
+	conn->inStart += 5 + msgLength;
+	conn->batchRow = 0;
+
+	/*
+	 * Replace partially constructed result with an error result. First
+	 * discard the old result to try to win back some memory.
+	 */
+	pqClearAsyncResult(conn);
+
+	/*
+	 * If preceding code didn't provide an error message, assume "out of
+	 * memory" was meant.  The advantage of having this special case is that
+	 * freeing the old result first greatly improves the odds that gettext()
+	 * will succeed in providing a translation.
+	 */
+	if (!errmsg)
+		errmsg = libpq_gettext("out of memory for query result");
+
+	printfPQExpBuffer(&conn->errorMessage, "%s\n", errmsg);
+	pqSaveErrorResult(conn);
+
+	/*
+	 * Return zero to allow input parsing to continue.  Subsequent "b"
+	 * messages will be ignored until we get to end of data, since an error
+	 * result is already set up.
+	 */
+	return 0;
+}
+
+
 /*
  * Attempt to read an Error or Notice response message.
  * This is possible in several places, so we break it out as a subroutine.
@@ -935,8 +1267,9 @@ pqGetErrorNotice3(PGconn *conn, bool isError)
 	 * might need it for an error cursor display, which is only true if there
 	 * is a PG_DIAG_STATEMENT_POSITION field.
 	 */
-	if (have_position && conn->last_query && res)
-		res->errQuery = pqResultStrdup(res, conn->last_query);
+	if (have_position && res && conn->cmd_queue_head &&
+		conn->cmd_queue_head->query)
+		res->errQuery = pqResultStrdup(res, conn->cmd_queue_head->query);
 
 	/*
 	 * Now build the "overall" error message for PQresultErrorMessage.
@@ -1837,7 +2170,8 @@ pqEndcopy3(PGconn *conn)
 		 * If we sent the COPY command in extended-query mode, we must issue a
 		 * Sync as well.
 		 */
-		if (conn->queryclass != PGQUERY_SIMPLE)
+		if (conn->cmd_queue_head &&
+			conn->cmd_queue_head->queryclass != PGQUERY_SIMPLE)
 		{
 			if (pqPutMsgStart('S', false, conn) < 0 ||
 				pqPutMsgEnd(conn) < 0)
@@ -2191,6 +2525,15 @@ build_startup_packet(const PGconn *conn, char *packet,
 
 	if (conn->client_encoding_initial && conn->client_encoding_initial[0])
 		ADD_STARTUP_OPTION("client_encoding", conn->client_encoding_initial);
+	if (conn->compression && conn->compression[0] == '1')
+		ADD_STARTUP_OPTION("_pq_.compression", ZPQ_ALGORITHM_NAME);
+	if (conn->rowBatchSize > 1)
+	{
+		char		batchsize[32];
+
+		snprintf(batchsize, sizeof(batchsize), "%d", conn->rowBatchSize);
+		ADD_STARTUP_OPTION("_pq_.row_batch_size", batchsize);
+	}
 
 	/* Add any environment-driven GUC settings needed */
 	for (next_eo = options; next_eo->envName; next_eo++)
@@ -39,6 +39,7 @@
 
 /* include stuff common to fe and be */
 #include "getaddrinfo.h"
+#include "common/zpq_stream.h"
 #include "libpq/pqcomm.h"
 /* include stuff found in fe only */
 #include "pqexpbuffer.h"
@@ -220,7 +221,8 @@ typedef enum
 	PGASYNC_READY,				/* result ready for PQgetResult */
 	PGASYNC_COPY_IN,			/* Copy In data transfer in progress */
 	PGASYNC_COPY_OUT,			/* Copy Out data transfer in progress */
-	PGASYNC_COPY_BOTH			/* Copy In/Out data transfer in progress */
+	PGASYNC_COPY_BOTH,			/* Copy In/Out data transfer in progress */
+	PGASYNC_PIPELINE_IDLE		/* "Idle" between commands in pipeline mode */
 } PGAsyncStatusType;
 
 /* PGQueryClass tracks which query protocol we are now executing */
@@ -229,9 +231,23 @@ typedef enum
 	PGQUERY_SIMPLE,				/* simple Query protocol (PQexec) */
 	PGQUERY_EXTENDED,			/* full Extended protocol (PQexecParams) */
 	PGQUERY_PREPARE,			/* Parse only (PQprepare) */
-	PGQUERY_DESCRIBE			/* Describe Statement or Portal */
+	PGQUERY_DESCRIBE,			/* Describe Statement or Portal */
+	PGQUERY_SYNC				/* Sync (at end of a pipeline) */
 } PGQueryClass;
 
+/*
+ * An entry in the pending command queue.  Every command sent to the server
+ * gets one, and it stays in the queue until all of its results have been
+ * returned to the application.  Outside pipeline mode, at most one command
+ * is in the queue at a time.
+ */
+typedef struct PGcmdQueueEntry
+{
+	PGQueryClass queryclass;	/* query type */
+	char	   *query;			/* SQL command, or NULL if none/unknown/OOM */
+	struct PGcmdQueueEntry *next;	/* list link */
+} PGcmdQueueEntry;
+
 /* PGSetenvStatusType defines the state of the PQSetenv state machine */
 /* (this is used only for 2.0-protocol connections) */
 typedef enum
@@ -247,6 +263,19 @@ typedef enum
 	SETENV_STATE_IDLE
 } PGSetenvStatusType;
 
+/*
+ * Position within one column of a DataRowBatch message.  The offsets are
+ * relative to the start of the message, so that they stay valid when the
+ * input buffer is compacted.
+ */
+typedef struct pgBatchColumn
+{
+	int			width;			/* length of all values, or -1 if varying */
+	int			nulls;			/* offset of the null bitmap */
+	int			lengths;		/* offset of the next value's length */
+	int			data;			/* offset of the next value */
+} PGbatchColumn;
+
 /* Typedef for the EnvironmentOptions[] array */
 typedef struct PQEnvironmentOption
 {
@@ -351,6 +380,8 @@ struct pg_conn
 										 * retransmits */
 	char	   *keepalives_count;	/* maximum number of TCP keepalive
 									 * retransmits */
+	char	   *compression;	/* protocol compression (0 or 1) */
+	char	   *row_batch_size; /* rows per DataRowBatch message */
 	char	   *sslmode;		/* SSL mode (require,prefer,allow,disable) */
 	char	   *sslcompression; /* SSL compression (0 or 1) */
 	char	   *sslkey;			/* client key filename */
@@ -381,8 +412,6 @@ struct pg_conn
 	ConnStatusType status;
 	PGAsyncStatusType asyncStatus;
 	PGTransactionStatusType xactStatus; /* never changes to ACTIVE */
-	PGQueryClass queryclass;
-	char	   *last_query;		/* last SQL command, or NULL if unknown */
 	char		last_sqlstate[6];	/* last reported SQLSTATE */
 	bool		options_valid;	/* true if OK to attempt connection */
 	bool		nonblocking;	/* whether this connection is using nonblock
@@ -393,6 +422,15 @@ struct pg_conn
 	PGnotify   *notifyHead;		/* oldest unreported Notify msg */
 	PGnotify   *notifyTail;		/* newest unreported Notify msg */
 
+	/*
+	 * Pending commands, oldest first; in pipeline mode there can be many.
+	 * Entries no longer needed are kept on a free list for reuse.
+	 */
+	PGpipelineStatus pipelineStatus;	/* status of pipeline mode */
+	PGcmdQueueEntry *cmd_queue_head;	/* oldest command not yet finished */
+	PGcmdQueueEntry *cmd_queue_tail;	/* newest command */
+	PGcmdQueueEntry *cmd_queue_recycle; /* free list */
+
 	/* Support for multiple hosts in connection string */
 	int			nconnhost;		/* # of hosts named in conn string */
 	int			whichhost;		/* host we're currently trying/connected to */
@@ -452,6 +490,13 @@ struct pg_conn
 	PGdataValue *rowBuf;		/* array for passing values to rowProcessor */
 	int			rowBufLen;		/* number of entries allocated in rowBuf */
 
+	/* DataRowBatch message being processed; see getAnotherBatch() */
+	int			rowBatchSize;	/* parsed row_batch_size option */
+	PGbatchColumn *batchCols;	/* position within each column */
+	int			batchColsLen;	/* number of entries allocated in batchCols */
+	int			batchRows;		/* number of rows in the message */
+	int			batchRow;		/* next row to process, 0 if none yet */
+
 	/* Status for asynchronous result construction */
 	PGresult   *result;			/* result being constructed */
 	PGresult   *next_result;	/* next result (used in single-row mode) */
@@ -459,6 +504,9 @@ struct pg_conn
 	/* Assorted state for SASL, SSL, GSS, etc */
 	void	   *sasl_state;
 
+	/* Protocol compression, once the server has acknowledged it */
+	ZpqStream  *zstream;
+
 	/* SSL structures */
 	bool		ssl_in_use;
 
@@ -586,6 +634,8 @@ extern void pqSaveParameterStatus(PGconn *conn, const char *name,
 					  const char *value);
 extern int	pqRowProcessor(PGconn *conn, const char **errmsgp);
 extern void pqHandleSendFailure(PGconn *conn);
+extern void pqCommandQueueAdvance(PGconn *conn, bool isReadyForQuery,
+					  bool gotSync);
 
 /* === in fe-protocol2.c === */
 
@@ -643,6 +693,7 @@ extern int	pqPutMsgStart(char msg_type, bool force_len, PGconn *conn);
 extern int	pqPutMsgEnd(PGconn *conn);
 extern int	pqReadData(PGconn *conn);
 extern int	pqFlush(PGconn *conn);
+extern int	pqStartCompression(PGconn *conn, const char *algorithm);
 extern int	pqWait(int forRead, int forWrite, PGconn *conn);
 extern int pqWaitTimed(int forRead, int forWrite, PGconn *conn,
 			time_t finish_time);
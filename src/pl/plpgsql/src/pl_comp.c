@@ -26,6 +26,7 @@
 #include "parser/parse_type.h"
 #include "utils/builtins.h"
 #include "utils/guc.h"
+#include "utils/inval.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/regproc.h"
@@ -70,6 +71,14 @@ typedef struct plpgsql_hashent
 
 #define FUNCS_PER_USER		128 /* initial table size */
 
+/*
+ * Count of pg_proc syscache invalidations seen by this backend.  A compiled
+ * function remembers the count as of its last validation against pg_proc;
+ * while the count is unchanged, its pg_proc row can't have changed either,
+ * so calls through the same FmgrInfo need not look it up again.
+ */
+static uint64 plpgsql_proc_inval_count = 0;
+
 /* ----------
  * Lookup table for EXCEPTION condition names
  * ----------
@@ -121,6 +130,8 @@ static void plpgsql_HashTableInsert(PLpgSQL_function *function,
 						PLpgSQL_func_hashkey *func_key);
 static void plpgsql_HashTableDelete(PLpgSQL_function *function);
 static void delete_function(PLpgSQL_function *func);
+static void plpgsql_proc_inval_callback(Datum arg, int cacheid,
+							uint32 hashvalue);
 
 /* ----------
  * plpgsql_compile		Make an execution tree for a PL/pgSQL function.
@@ -142,6 +153,15 @@ plpgsql_compile(FunctionCallInfo fcinfo, bool forValidator)
 	PLpgSQL_func_hashkey hashkey;
 	bool		function_valid = false;
 	bool		hashkey_valid = false;
+	uint64		inval_count = plpgsql_proc_inval_count;
+
+	/*
+	 * If this FmgrInfo was already set up and no pg_proc invalidation has
+	 * arrived since the function was last checked, it is still valid.
+	 */
+	function = (PLpgSQL_function *) fcinfo->flinfo->fn_extra;
+	if (function && function->fn_inval_count == inval_count)
+		return function;
 
 	/*
 	 * Lookup the pg_proc tuple by Oid; we'll need it in any case
@@ -227,6 +247,9 @@ recheck:
 
 	ReleaseSysCache(procTup);
 
+	/* Remember how far it's been validated, see above */
+	function->fn_inval_count = inval_count;
+
 	/*
 	 * Save pointer in FmgrInfo to avoid search on subsequent calls
 	 */
@@ -2462,6 +2485,19 @@ plpgsql_HashTableInit(void)
 									FUNCS_PER_USER,
 									&ctl,
 									HASH_ELEM | HASH_BLOBS);
+
+	CacheRegisterSyscacheCallback(PROCOID, plpgsql_proc_inval_callback,
+								  (Datum) 0);
+}
+
+/*
+ * Syscache invalidation callback for pg_proc: just count the event, forcing
+ * the next call of each compiled function to recheck its pg_proc row.
+ */
+static void
+plpgsql_proc_inval_callback(Datum arg, int cacheid, uint32 hashvalue)
+{
+	plpgsql_proc_inval_count++;
 }
 
 static PLpgSQL_function *
@@ -6028,6 +6028,7 @@ exec_eval_simple_expr(PLpgSQL_execstate *estate,
 	LocalTransactionId curlxid = MyProc->lxid;
 	CachedPlan *cplan;
 	void	   *save_setup_arg;
+	bool		need_snapshot;
 	MemoryContext oldcontext;
 
 	/*
@@ -6044,12 +6045,20 @@ exec_eval_simple_expr(PLpgSQL_execstate *estate,
 
 	/*
 	 * Revalidate cached plan, so that we will notice if it became stale. (We
-	 * need to hold a refcount while using the plan, anyway.)  If replanning
-	 * is needed, do that work in the eval_mcontext.
+	 * need to hold a refcount while using the plan, anyway.)  Usually the
+	 * plan we saw last time is still good, and the plancache can tell us so
+	 * cheaply, since a simple expression references no tables.  Otherwise go
+	 * through the full revalidation; if replanning is needed, do that work in
+	 * the eval_mcontext.
 	 */
-	oldcontext = MemoryContextSwitchTo(get_eval_mcontext(estate));
-	cplan = SPI_plan_get_cached_plan(expr->plan);
-	MemoryContextSwitchTo(oldcontext);
+	cplan = GetSimplyValidCachedPlan(expr->expr_simple_plansource,
+									 expr->expr_simple_generation, true);
+	if (cplan == NULL)
+	{
+		oldcontext = MemoryContextSwitchTo(get_eval_mcontext(estate));
+		cplan = SPI_plan_get_cached_plan(expr->plan);
+		MemoryContextSwitchTo(oldcontext);
+	}
 
 	/*
 	 * We can't get a failure here, because the number of CachedPlanSources in
@@ -6101,10 +6110,14 @@ exec_eval_simple_expr(PLpgSQL_execstate *estate,
 	 * We have to do some of the things SPI_execute_plan would do, in
 	 * particular advance the snapshot if we are in a non-read-only function.
 	 * Without this, stable functions within the expression would fail to see
-	 * updates made so far by our own function.
+	 * updates made so far by our own function.  An expression containing only
+	 * immutable functions can't look at the database at all, so it can skip
+	 * that work, unless there is no active snapshot to run under.
 	 */
 	oldcontext = MemoryContextSwitchTo(get_eval_mcontext(estate));
-	if (!estate->readonly_func)
+	need_snapshot = !estate->readonly_func &&
+		(expr->expr_simple_mutable || !ActiveSnapshotSet());
+	if (need_snapshot)
 	{
 		CommandCounterIncrement();
 		PushActiveSnapshot(GetTransactionSnapshot());
@@ -6129,7 +6142,7 @@ exec_eval_simple_expr(PLpgSQL_execstate *estate,
 
 	estate->paramLI->parserSetupArg = save_setup_arg;
 
-	if (!estate->readonly_func)
+	if (need_snapshot)
 		PopActiveSnapshot();
 
 	MemoryContextSwitchTo(oldcontext);
@@ -7844,6 +7857,7 @@ exec_simple_check_plan(PLpgSQL_execstate *estate, PLpgSQL_expr *expr)
 	Assert(cplan != NULL);
 
 	/* Share the remaining work with replan code path */
+	expr->expr_simple_plansource = plansource;
 	exec_save_simple_expr(expr, cplan);
 
 	/* Release our plan refcount */
@@ -7926,6 +7940,8 @@ exec_save_simple_expr(PLpgSQL_expr *expr, CachedPlan *cplan)
 	/* Also stash away the expression result type */
 	expr->expr_simple_type = exprType((Node *) tle_expr);
 	expr->expr_simple_typmod = exprTypmod((Node *) tle_expr);
+	/* ... and whether evaluating it needs a fresh snapshot */
+	expr->expr_simple_mutable = contain_mutable_functions((Node *) tle_expr);
 }
 
 /*
@@ -7991,7 +8007,8 @@ exec_check_rw_parameter(PLpgSQL_expr *expr, int target_dno)
 	 * allow extensions to mark their functions as safe ...
 	 */
 	if (!(funcid == F_ARRAY_APPEND ||
-		  funcid == F_ARRAY_PREPEND))
+		  funcid == F_ARRAY_PREPEND ||
+		  funcid == F_ARRAY_CAT))
 		return;
 
 	/*
@@ -227,8 +227,10 @@ typedef struct PLpgSQL_expr
 	/* fields for "simple expression" fast-path execution: */
 	Expr	   *expr_simple_expr;	/* NULL means not a simple expr */
 	int			expr_simple_generation; /* plancache generation we checked */
+	struct CachedPlanSource *expr_simple_plansource;	/* its plansource */
 	Oid			expr_simple_type;	/* result type Oid, if simple */
 	int32		expr_simple_typmod; /* result typmod, if simple */
+	bool		expr_simple_mutable;	/* true if it calls mutable functions */
 
 	/*
 	 * if expr is simple AND prepared in current transaction,
@@ -934,6 +936,7 @@ typedef struct PLpgSQL_function
 	Oid			fn_oid;
 	TransactionId fn_xmin;
 	ItemPointerData fn_tid;
+	uint64		fn_inval_count; /* pg_proc invalidations seen at last check */
 	PLpgSQL_trigtype fn_is_trigger;
 	Oid			fn_input_collation;
 	PLpgSQL_func_hashkey *fn_hashkey;	/* back-link to hashtable key */
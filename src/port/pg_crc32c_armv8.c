@@ -18,6 +18,47 @@
 
 #include <arm_acle.h>
 
+/*
+ * Block sizes for the three-way parallel loop; see pg_crc32c_sse42.c.  Both
+ * must be multiples of 8.
+ */
+#define CRC32C_LONG_BLOCK	8192
+#define CRC32C_SHORT_BLOCK	256
+
+static pg_crc32c_shift_table crc32c_long_shift;
+static pg_crc32c_shift_table crc32c_short_shift;
+static bool crc32c_shift_ready = false;
+
+/*
+ * Compute the CRC of three adjacent blocks of 'blocklen' bytes each, starting
+ * at the 8-byte aligned pointer 'p', as three independent streams.  Returns
+ * the pointer to the end of the third block.
+ */
+static inline const unsigned char *
+crc32c_armv8_3way(pg_crc32c *crcp, const unsigned char *p, size_t blocklen,
+				  const pg_crc32c_shift_table *shift)
+{
+	uint32		crc0 = *crcp;
+	uint32		crc1 = 0;
+	uint32		crc2 = 0;
+	const unsigned char *end = p + blocklen;
+
+	do
+	{
+		crc0 = __crc32cd(crc0, *(uint64 *) p);
+		crc1 = __crc32cd(crc1, *(uint64 *) (p + blocklen));
+		crc2 = __crc32cd(crc2, *(uint64 *) (p + 2 * blocklen));
+		p += 8;
+	} while (p < end);
+
+	/* Combine: extend each CRC over the following block, and add it in. */
+	crc0 = pg_crc32c_shift(shift, crc0) ^ crc1;
+	crc0 = pg_crc32c_shift(shift, crc0) ^ crc2;
+	*crcp = crc0;
+
+	return p + 2 * blocklen;
+}
+
 pg_crc32c
 pg_comp_crc32c_armv8(pg_crc32c crc, const void *data, size_t len)
 {
@@ -48,6 +89,27 @@ pg_comp_crc32c_armv8(pg_crc32c crc, const void *data, size_t len)
 		p += 4;
 	}
 
+	/*
+	 * For large inputs, process three blocks at a time.  The tables needed to
+	 * combine the results are built on first use.
+	 */
+	if (pend - p >= 3 * CRC32C_SHORT_BLOCK)
+	{
+		if (unlikely(!crc32c_shift_ready))
+		{
+			pg_crc32c_make_shift_table(&crc32c_long_shift, CRC32C_LONG_BLOCK);
+			pg_crc32c_make_shift_table(&crc32c_short_shift, CRC32C_SHORT_BLOCK);
+			crc32c_shift_ready = true;
+		}
+
+		while (pend - p >= 3 * CRC32C_LONG_BLOCK)
+			p = crc32c_armv8_3way(&crc, p, CRC32C_LONG_BLOCK,
+								  &crc32c_long_shift);
+		while (pend - p >= 3 * CRC32C_SHORT_BLOCK)
+			p = crc32c_armv8_3way(&crc, p, CRC32C_SHORT_BLOCK,
+								  &crc32c_short_shift);
+	}
+
 	/* Process eight bytes at a time, as far as we can. */
 	while (p + 8 <= pend)
 	{
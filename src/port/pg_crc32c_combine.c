@@ -0,0 +1,97 @@
+/*-------------------------------------------------------------------------
+ *
+ * pg_crc32c_combine.c
+ *	  Support for combining CRC-32C values of adjacent blocks of data
+ *
+ * The CRC instructions on modern CPUs have a latency of several cycles, but
+ * a new one can be started every cycle.  The hardware implementations can
+ * therefore go considerably faster on large inputs by computing the CRCs of
+ * several adjacent blocks in parallel, and combining the results afterwards.
+ *
+ * Combining works because a CRC is linear: the CRC of A||B is the CRC of A,
+ * extended over len(B) zero bytes, XORed with the CRC of B computed starting
+ * from zero.  Extending a CRC over n zero bytes is the same as multiplying it
+ * by x^(8n) modulo the CRC polynomial, which for a fixed n is a linear map of
+ * the 32 CRC bits.  We precompute that map as four 256-entry tables, one per
+ * byte of the CRC, so that applying it costs four table lookups.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/port/pg_crc32c_combine.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "c.h"
+
+#include "port/pg_crc32c.h"
+
+/* The CRC-32C polynomial, in the bit-reflected form used by the CRC */
+#define CRC32C_POLY_REFLECTED	0x82F63B78
+
+/*
+ * Multiply two polynomials modulo the CRC-32C polynomial.  Both operands and
+ * the result are bit-reflected, so x^0 is represented by the high bit.  'a'
+ * must not be zero.
+ */
+static uint32
+crc32c_multmodp(uint32 a, uint32 b)
+{
+	uint32		m = UINT32_C(1) << 31;
+	uint32		p = 0;
+
+	for (;;)
+	{
+		if (a & m)
+		{
+			p ^= b;
+			if ((a & (m - 1)) == 0)
+				break;
+		}
+		m >>= 1;
+		b = (b & 1) ? (b >> 1) ^ CRC32C_POLY_REFLECTED : b >> 1;
+	}
+
+	return p;
+}
+
+/*
+ * Compute x^(8n) modulo the CRC-32C polynomial, that is, the multiplier that
+ * extends a CRC over n zero bytes.
+ */
+static uint32
+crc32c_x8nmodp(size_t n)
+{
+	uint32		result = UINT32_C(1) << 31; /* x^0 */
+	uint32		base = UINT32_C(1) << 23;	/* x^8 */
+
+	while (n != 0)
+	{
+		if (n & 1)
+			result = crc32c_multmodp(base, result);
+		base = crc32c_multmodp(base, base);
+		n >>= 1;
+	}
+
+	return result;
+}
+
+/*
+ * Fill in 'table' so that pg_crc32c_shift() extends a CRC over 'len' zero
+ * bytes.
+ */
+void
+pg_crc32c_make_shift_table(pg_crc32c_shift_table *table, size_t len)
+{
+	uint32		op = crc32c_x8nmodp(len);
+	int			k;
+	int			b;
+
+	for (k = 0; k < 4; k++)
+	{
+		for (b = 0; b < 256; b++)
+			table->t[k][b] = crc32c_multmodp(op, (uint32) b << (8 * k));
+	}
+}
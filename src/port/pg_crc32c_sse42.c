@@ -18,12 +18,83 @@
 
 #include <nmmintrin.h>
 
+#ifdef __x86_64__
+
+/*
+ * Block sizes for the three-way parallel loop.  Large inputs are processed in
+ * groups of three long blocks; what's left is processed in groups of three
+ * short blocks, and the rest serially.  Both must be multiples of 8.
+ */
+#define CRC32C_LONG_BLOCK	8192
+#define CRC32C_SHORT_BLOCK	256
+
+static pg_crc32c_shift_table crc32c_long_shift;
+static pg_crc32c_shift_table crc32c_short_shift;
+static bool crc32c_shift_ready = false;
+
+/*
+ * Compute the CRC of three adjacent blocks of 'blocklen' bytes each, starting
+ * at 'p', as three independent streams, so that the CPU can overlap the
+ * latencies of the CRC instructions.  Returns the pointer to the end of the
+ * third block.
+ */
+static inline const unsigned char *
+crc32c_sse42_3way(pg_crc32c *crcp, const unsigned char *p, size_t blocklen,
+				  const pg_crc32c_shift_table *shift)
+{
+	uint64		crc0 = *crcp;
+	uint64		crc1 = 0;
+	uint64		crc2 = 0;
+	const unsigned char *end = p + blocklen;
+
+	do
+	{
+		crc0 = _mm_crc32_u64(crc0, *((const uint64 *) p));
+		crc1 = _mm_crc32_u64(crc1, *((const uint64 *) (p + blocklen)));
+		crc2 = _mm_crc32_u64(crc2, *((const uint64 *) (p + 2 * blocklen)));
+		p += 8;
+	} while (p < end);
+
+	/* Combine: extend each CRC over the following block, and add it in. */
+	crc0 = pg_crc32c_shift(shift, (pg_crc32c) crc0) ^ crc1;
+	crc0 = pg_crc32c_shift(shift, (pg_crc32c) crc0) ^ crc2;
+	*crcp = (pg_crc32c) crc0;
+
+	return p + 2 * blocklen;
+}
+
+#endif							/* __x86_64__ */
+
 pg_crc32c
 pg_comp_crc32c_sse42(pg_crc32c crc, const void *data, size_t len)
 {
 	const unsigned char *p = data;
 	const unsigned char *pend = p + len;
 
+#ifdef __x86_64__
+	/*
+	 * For large inputs, such as full-page images in WAL, process three blocks
+	 * at a time.  The tables needed to combine the results are built on first
+	 * use.
+	 */
+	if (len >= 3 * CRC32C_SHORT_BLOCK)
+	{
+		if (unlikely(!crc32c_shift_ready))
+		{
+			pg_crc32c_make_shift_table(&crc32c_long_shift, CRC32C_LONG_BLOCK);
+			pg_crc32c_make_shift_table(&crc32c_short_shift, CRC32C_SHORT_BLOCK);
+			crc32c_shift_ready = true;
+		}
+
+		while (pend - p >= 3 * CRC32C_LONG_BLOCK)
+			p = crc32c_sse42_3way(&crc, p, CRC32C_LONG_BLOCK,
+								  &crc32c_long_shift);
+		while (pend - p >= 3 * CRC32C_SHORT_BLOCK)
+			p = crc32c_sse42_3way(&crc, p, CRC32C_SHORT_BLOCK,
+								  &crc32c_short_shift);
+	}
+#endif
+
 	/*
 	 * Process eight bytes of data at a time.
 	 *
@@ -0,0 +1,799 @@
+/*-------------------------------------------------------------------------
+ *
+ * libpq_pipeline.c
+ *		Verify libpq pipeline execution functionality
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *		src/test/modules/libpq_pipeline/libpq_pipeline.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres_fe.h"
+
+#include "catalog/pg_type_d.h"
+#include "libpq-fe.h"
+
+
+static void exit_nicely(PGconn *conn);
+static void pg_attribute_noreturn() pg_fatal_impl(int line, const char *fmt,...)
+			pg_attribute_printf(2, 3);
+
+static const char *const drop_table_sql =
+"DROP TABLE IF EXISTS pq_pipeline_demo";
+static const char *const create_table_sql =
+"CREATE UNLOGGED TABLE pq_pipeline_demo(id serial primary key, itemno integer);";
+static const char *const insert_sql =
+"INSERT INTO pq_pipeline_demo(itemno) VALUES ($1)";
+
+/* number of queries sent in a single pipeline by test_many */
+#define NUM_MANY_QUERIES 1000
+
+static void
+exit_nicely(PGconn *conn)
+{
+	PQfinish(conn);
+	exit(1);
+}
+
+/*
+ * Print an error to stderr and terminate the program.
+ */
+#define pg_fatal(...) pg_fatal_impl(__LINE__, __VA_ARGS__)
+static void
+pg_attribute_noreturn()
+pg_fatal_impl(int line, const char *fmt,...)
+{
+	va_list		args;
+
+	fflush(stdout);
+
+	fprintf(stderr, "\n%s:%d: ", __FILE__, line);
+	va_start(args, fmt);
+	vfprintf(stderr, fmt, args);
+	va_end(args);
+	Assert(fmt[strlen(fmt) - 1] != '\n');
+	fprintf(stderr, "\n");
+	exit(1);
+}
+
+/*
+ * Fetch the next result and check that it has the expected status.  The
+ * result is returned to the caller, who must PQclear it.
+ */
+static PGresult *
+get_result_status(PGconn *conn, ExecStatusType status, int line)
+{
+	PGresult   *res = PQgetResult(conn);
+
+	if (res == NULL)
+		pg_fatal_impl(line, "PQgetResult returned null unexpectedly: %s",
+					  PQerrorMessage(conn));
+	if (PQresultStatus(res) != status)
+		pg_fatal_impl(line, "unexpected result status %s, expected %s: %s",
+					  PQresStatus(PQresultStatus(res)), PQresStatus(status),
+					  PQerrorMessage(conn));
+	return res;
+}
+#define expect_result(conn, status) \
+	PQclear(get_result_status(conn, status, __LINE__))
+
+/*
+ * Check that the current query has no further results.
+ */
+static void
+expect_null_result_impl(PGconn *conn, int line)
+{
+	PGresult   *res = PQgetResult(conn);
+
+	if (res != NULL)
+		pg_fatal_impl(line, "expected null result, got %s",
+					  PQresStatus(PQresultStatus(res)));
+}
+#define expect_null_result(conn) expect_null_result_impl(conn, __LINE__)
+
+/*
+ * Commands that are not allowed in pipeline mode are rejected.
+ */
+static void
+test_disallowed_in_pipeline(PGconn *conn)
+{
+	PGresult   *res;
+
+	fprintf(stderr, "test error cases... ");
+
+	if (PQisnonblocking(conn))
+		pg_fatal("Expected blocking connection mode");
+
+	if (PQenterPipelineMode(conn) != 1)
+		pg_fatal("Unable to enter pipeline mode");
+	if (PQpipelineStatus(conn) == PQ_PIPELINE_OFF)
+		pg_fatal("Pipeline mode not activated properly");
+
+	/* PQexec should fail in pipeline mode */
+	res = PQexec(conn, "SELECT 1");
+	if (PQresultStatus(res) != PGRES_FATAL_ERROR)
+		pg_fatal("PQexec should fail in pipeline mode but succeeded");
+	PQclear(res);
+
+	/* Entering pipeline mode when already in pipeline mode is OK */
+	if (PQenterPipelineMode(conn) != 1)
+		pg_fatal("re-entering pipeline mode should be a no-op but failed");
+
+	if (PQisBusy(conn) != 0)
+		pg_fatal("PQisBusy should return 0 when idle in pipeline mode, returned 1");
+
+	/* ok, back to normal command mode */
+	if (PQexitPipelineMode(conn) != 1)
+		pg_fatal("couldn't exit idle empty pipeline mode");
+	if (PQpipelineStatus(conn) != PQ_PIPELINE_OFF)
+		pg_fatal("Pipeline mode not terminated properly");
+
+	/* exiting pipeline mode when not in pipeline mode should be a no-op */
+	if (PQexitPipelineMode(conn) != 1)
+		pg_fatal("pipeline mode exit when not in pipeline mode should succeed but failed");
+
+	/* can't sync outside pipeline mode */
+	if (PQpipelineSync(conn) != 0)
+		pg_fatal("PQpipelineSync should fail outside pipeline mode");
+
+	/* can't enter pipeline mode with a query in progress */
+	if (PQsendQuery(conn, "SELECT 1") != 1)
+		pg_fatal("failed to send query: %s", PQerrorMessage(conn));
+	if (PQenterPipelineMode(conn) != 0)
+		pg_fatal("entering pipeline mode should fail while a query is in progress");
+	expect_result(conn, PGRES_TUPLES_OK);
+	expect_null_result(conn);
+
+	/* and now PQexec should work again */
+	res = PQexec(conn, "SELECT 1");
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+		pg_fatal("PQexec should succeed after exiting pipeline mode but failed");
+	PQclear(res);
+
+	fprintf(stderr, "ok\n");
+}
+
+/*
+ * A single query followed by a sync point.
+ */
+static void
+test_simple_pipeline(PGconn *conn)
+{
+	PGresult   *res;
+	const char *dummy_params[1] = {"1"};
+	Oid			dummy_param_oids[1] = {INT4OID};
+
+	fprintf(stderr, "simple pipeline... ");
+
+	if (PQenterPipelineMode(conn) != 1)
+		pg_fatal("failed to enter pipeline mode: %s", PQerrorMessage(conn));
+
+	if (PQsendQueryParams(conn, "SELECT $1",
+						  1, dummy_param_oids, dummy_params,
+						  NULL, NULL, 0) != 1)
+		pg_fatal("dispatching SELECT failed: %s", PQerrorMessage(conn));
+
+	/* can't leave pipeline mode with a query outstanding */
+	if (PQexitPipelineMode(conn) != 0)
+		pg_fatal("exiting pipeline mode with work in progress should fail, but succeeded");
+
+	if (PQpipelineSync(conn) != 1)
+		pg_fatal("pipeline sync failed: %s", PQerrorMessage(conn));
+
+	res = get_result_status(conn, PGRES_TUPLES_OK, __LINE__);
+	if (strcmp(PQgetvalue(res, 0, 0), "1") != 0)
+		pg_fatal("unexpected result value \"%s\"", PQgetvalue(res, 0, 0));
+	PQclear(res);
+	expect_null_result(conn);
+
+	/* nothing to see here until the sync point has been consumed */
+	if (PQexitPipelineMode(conn) != 0)
+		pg_fatal("exiting pipeline mode after query but before sync succeeded incorrectly");
+
+	expect_result(conn, PGRES_PIPELINE_SYNC);
+	expect_null_result(conn);
+
+	/* we're still in pipeline mode, and can now leave it */
+	if (PQpipelineStatus(conn) == PQ_PIPELINE_OFF)
+		pg_fatal("pipeline mode ended before PQexitPipelineMode");
+	if (PQexitPipelineMode(conn) != 1)
+		pg_fatal("attempt to exit pipeline mode failed when it should've succeeded: %s",
+				 PQerrorMessage(conn));
+	if (PQpipelineStatus(conn) != PQ_PIPELINE_OFF)
+		pg_fatal("Exiting pipeline mode didn't seem to work");
+
+	fprintf(stderr, "ok\n");
+}
+
+/*
+ * Several sync points in a single pipeline, with queries sent before the
+ * results of the earlier ones have been read.
+ */
+static void
+test_multi_pipelines(PGconn *conn)
+{
+	PGresult   *res;
+	const char *dummy_params[1] = {"1"};
+	Oid			dummy_param_oids[1] = {INT4OID};
+
+	fprintf(stderr, "multi pipeline... ");
+
+	if (PQenterPipelineMode(conn) != 1)
+		pg_fatal("failed to enter pipeline mode: %s", PQerrorMessage(conn));
+
+	/* first pipeline */
+	if (PQsendQueryParams(conn, "SELECT $1", 1, dummy_param_oids,
+						  dummy_params, NULL, NULL, 0) != 1)
+		pg_fatal("dispatching first SELECT failed: %s", PQerrorMessage(conn));
+	if (PQpipelineSync(conn) != 1)
+		pg_fatal("Pipeline sync failed: %s", PQerrorMessage(conn));
+
+	/* second pipeline, using the simple query function */
+	if (PQsendQuery(conn, "SELECT 2") != 1)
+		pg_fatal("dispatching second SELECT failed: %s", PQerrorMessage(conn));
+	if (PQpipelineSync(conn) != 1)
+		pg_fatal("pipeline sync failed: %s", PQerrorMessage(conn));
+
+	/* OK, start processing the results */
+	expect_result(conn, PGRES_TUPLES_OK);
+	expect_null_result(conn);
+
+	if (PQexitPipelineMode(conn) != 0)
+		pg_fatal("exiting pipeline mode after query but before sync succeeded incorrectly");
+
+	expect_result(conn, PGRES_PIPELINE_SYNC);
+
+	/* second pipeline */
+	res = get_result_status(conn, PGRES_TUPLES_OK, __LINE__);
+	if (strcmp(PQgetvalue(res, 0, 0), "2") != 0)
+		pg_fatal("unexpected result value \"%s\"", PQgetvalue(res, 0, 0));
+	PQclear(res);
+	expect_null_result(conn);
+
+	if (PQexitPipelineMode(conn) != 0)
+		pg_fatal("exiting pipeline mode after query but before sync succeeded incorrectly");
+
+	expect_result(conn, PGRES_PIPELINE_SYNC);
+
+	/* We're still in pipeline mode ... */
+	if (PQpipelineStatus(conn) == PQ_PIPELINE_OFF)
+		pg_fatal("Fell out of pipeline mode somehow");
+
+	/* until we end it, which we can safely do now */
+	if (PQexitPipelineMode(conn) != 1)
+		pg_fatal("attempt to exit pipeline mode failed when it should've succeeded: %s",
+				 PQerrorMessage(conn));
+
+	if (PQpipelineStatus(conn) != PQ_PIPELINE_OFF)
+		pg_fatal("exiting pipeline mode didn't seem to work");
+
+	fprintf(stderr, "ok\n");
+}
+
+/*
+ * An error in a pipeline aborts the rest of it, up to the next sync point;
+ * the pipeline after that runs normally.
+ */
+static void
+test_pipeline_abort(PGconn *conn)
+{
+	PGresult   *res;
+	const char *dummy_params[1] = {"1"};
+	Oid			dummy_param_oids[1] = {INT4OID};
+	int			i;
+
+	fprintf(stderr, "aborted pipeline... ");
+
+	res = PQexec(conn, drop_table_sql);
+	if (PQresultStatus(res) != PGRES_COMMAND_OK)
+		pg_fatal("dispatching DROP TABLE failed: %s", PQerrorMessage(conn));
+	PQclear(res);
+
+	res = PQexec(conn, create_table_sql);
+	if (PQresultStatus(res) != PGRES_COMMAND_OK)
+		pg_fatal("dispatching CREATE TABLE failed: %s", PQerrorMessage(conn));
+	PQclear(res);
+
+	if (PQenterPipelineMode(conn) != 1)
+		pg_fatal("failed to enter pipeline mode: %s", PQerrorMessage(conn));
+
+	/* First pipeline: an insert, a failing query, and another insert */
+	dummy_params[0] = "1";
+	if (PQsendQueryParams(conn, insert_sql, 1, dummy_param_oids,
+						  dummy_params, NULL, NULL, 0) != 1)
+		pg_fatal("dispatching first insert failed: %s", PQerrorMessage(conn));
+
+	if (PQsendQueryParams(conn, "SELECT no_such_function($1)",
+						  1, dummy_param_oids, dummy_params,
+						  NULL, NULL, 0) != 1)
+		pg_fatal("dispatching error select failed: %s", PQerrorMessage(conn));
+
+	dummy_params[0] = "2";
+	if (PQsendQueryParams(conn, insert_sql, 1, dummy_param_oids,
+						  dummy_params, NULL, NULL, 0) != 1)
+		pg_fatal("dispatching second insert failed: %s", PQerrorMessage(conn));
+
+	if (PQpipelineSync(conn) != 1)
+		pg_fatal("pipeline sync failed: %s", PQerrorMessage(conn));
+
+	/* Second pipeline, which runs normally */
+	dummy_params[0] = "3";
+	if (PQsendQueryParams(conn, insert_sql, 1, dummy_param_oids,
+						  dummy_params, NULL, NULL, 0) != 1)
+		pg_fatal("dispatching third insert failed: %s", PQerrorMessage(conn));
+	if (PQpipelineSync(conn) != 1)
+		pg_fatal("pipeline sync failed: %s", PQerrorMessage(conn));
+
+	/* PQsendQuery sends exactly one statement; more than one is an error */
+	if (PQsendQuery(conn, "SELECT 1; SELECT 2") != 1)
+		pg_fatal("failed to send query: %s", PQerrorMessage(conn));
+	if (PQpipelineSync(conn) != 1)
+		pg_fatal("pipeline sync failed: %s", PQerrorMessage(conn));
+
+	/* Fourth pipeline, unaffected by the errors of the earlier ones */
+	if (PQsendQuery(conn, "SELECT 1") != 1)
+		pg_fatal("failed to send query: %s", PQerrorMessage(conn));
+	if (PQpipelineSync(conn) != 1)
+		pg_fatal("pipeline sync failed: %s", PQerrorMessage(conn));
+
+	/* first insert succeeds */
+	expect_result(conn, PGRES_COMMAND_OK);
+	expect_null_result(conn);
+
+	/* the failing query reports its error */
+	expect_result(conn, PGRES_FATAL_ERROR);
+	expect_null_result(conn);
+
+	if (PQpipelineStatus(conn) != PQ_PIPELINE_ABORTED)
+		pg_fatal("pipeline should be flagged as aborted but isn't");
+
+	/* the second insert is skipped */
+	expect_result(conn, PGRES_PIPELINE_ABORTED);
+	expect_null_result(conn);
+
+	/* the sync point ends the aborted state */
+	expect_result(conn, PGRES_PIPELINE_SYNC);
+
+	if (PQpipelineStatus(conn) == PQ_PIPELINE_ABORTED)
+		pg_fatal("sync didn't clear pipeline aborted state");
+
+	/* second pipeline: the insert works */
+	expect_result(conn, PGRES_COMMAND_OK);
+	expect_null_result(conn);
+	expect_result(conn, PGRES_PIPELINE_SYNC);
+
+	/* third pipeline: the multi-statement query fails */
+	expect_result(conn, PGRES_FATAL_ERROR);
+	expect_null_result(conn);
+	expect_result(conn, PGRES_PIPELINE_SYNC);
+
+	/* fourth pipeline runs normally */
+	expect_result(conn, PGRES_TUPLES_OK);
+	expect_null_result(conn);
+	expect_result(conn, PGRES_PIPELINE_SYNC);
+
+	if (PQexitPipelineMode(conn) != 1)
+		pg_fatal("exiting pipeline mode failed: %s", PQerrorMessage(conn));
+
+	/*
+	 * Each pipeline ran as an implicit transaction ending at its sync
+	 * point, so the first insert was rolled back along with the error, but
+	 * the third one was committed.
+	 */
+	res = PQexec(conn, "SELECT itemno FROM pq_pipeline_demo ORDER BY itemno");
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+		pg_fatal("Expected tuples, got %s: %s",
+				 PQresStatus(PQresultStatus(res)), PQerrorMessage(conn));
+	if (PQntuples(res) != 1)
+		pg_fatal("expected 1 result, got %d", PQntuples(res));
+	for (i = 0; i < PQntuples(res); i++)
+	{
+		const char *val = PQgetvalue(res, i, 0);
+
+		if (strcmp(val, "3") != 0)
+			pg_fatal("expected itemno 3, got \"%s\"", val);
+	}
+	PQclear(res);
+
+	fprintf(stderr, "ok\n");
+}
+
+/*
+ * Prepare, execute and describe statements in a pipeline.
+ */
+static void
+test_prepared(PGconn *conn)
+{
+	PGresult   *res;
+	Oid			param_oids[1] = {INT4OID};
+	const char *params[1] = {"7"};
+
+	fprintf(stderr, "prepared... ");
+
+	if (PQenterPipelineMode(conn) != 1)
+		pg_fatal("failed to enter pipeline mode: %s", PQerrorMessage(conn));
+	if (PQsendPrepare(conn, "select_one", "SELECT $1 + 1, '42'::numeric",
+					  1, param_oids) != 1)
+		pg_fatal("preparing query failed: %s", PQerrorMessage(conn));
+	if (PQsendDescribePrepared(conn, "select_one") != 1)
+		pg_fatal("failed to send describe prepared: %s", PQerrorMessage(conn));
+	if (PQsendQueryPrepared(conn, "select_one", 1, params,
+							NULL, NULL, 0) != 1)
+		pg_fatal("failed to execute prepared: %s", PQerrorMessage(conn));
+	if (PQpipelineSync(conn) != 1)
+		pg_fatal("pipeline sync failed: %s", PQerrorMessage(conn));
+
+	expect_result(conn, PGRES_COMMAND_OK);
+	expect_null_result(conn);
+
+	res = get_result_status(conn, PGRES_COMMAND_OK, __LINE__);
+	if (PQnfields(res) != 2)
+		pg_fatal("expected two fields, got %d", PQnfields(res));
+	if (PQftype(res, 0) != INT4OID)
+		pg_fatal("field 0 has type %u, expected %u", PQftype(res, 0), INT4OID);
+	if (PQftype(res, 1) != NUMERICOID)
+		pg_fatal("field 1 has type %u, expected %u", PQftype(res, 1), NUMERICOID);
+	if (PQnparams(res) != 1 || PQparamtype(res, 0) != INT4OID)
+		pg_fatal("unexpected parameter description");
+	PQclear(res);
+	expect_null_result(conn);
+
+	res = get_result_status(conn, PGRES_TUPLES_OK, __LINE__);
+	if (strcmp(PQgetvalue(res, 0, 0), "8") != 0 ||
+		strcmp(PQgetvalue(res, 0, 1), "42") != 0)
+		pg_fatal("unexpected result \"%s\", \"%s\"",
+				 PQgetvalue(res, 0, 0), PQgetvalue(res, 0, 1));
+	PQclear(res);
+	expect_null_result(conn);
+
+	expect_result(conn, PGRES_PIPELINE_SYNC);
+
+	if (PQexitPipelineMode(conn) != 1)
+		pg_fatal("could not exit pipeline mode: %s", PQerrorMessage(conn));
+
+	fprintf(stderr, "ok\n");
+}
+
+/*
+ * Many queries in one pipeline, with the results read only after all of
+ * them have been sent.  A flush request makes the server send the results
+ * of the queries so far without a sync point.
+ */
+static void
+test_many(PGconn *conn)
+{
+	PGresult   *res;
+	Oid			param_oids[1] = {INT4OID};
+	const char *params[1];
+	char		buf[16];
+	int			i;
+
+	fprintf(stderr, "many queries... ");
+
+	res = PQexec(conn, drop_table_sql);
+	if (PQresultStatus(res) != PGRES_COMMAND_OK)
+		pg_fatal("dispatching DROP TABLE failed: %s", PQerrorMessage(conn));
+	PQclear(res);
+
+	res = PQexec(conn, create_table_sql);
+	if (PQresultStatus(res) != PGRES_COMMAND_OK)
+		pg_fatal("dispatching CREATE TABLE failed: %s", PQerrorMessage(conn));
+	PQclear(res);
+
+	if (PQenterPipelineMode(conn) != 1)
+		pg_fatal("failed to enter pipeline mode: %s", PQerrorMessage(conn));
+
+	if (PQsendQuery(conn, "BEGIN") != 1)
+		pg_fatal("failed to send BEGIN: %s", PQerrorMessage(conn));
+
+	params[0] = buf;
+	for (i = 0; i < NUM_MANY_QUERIES; i++)
+	{
+		snprintf(buf, sizeof(buf), "%d", i);
+		if (PQsendQueryParams(conn, insert_sql, 1, param_oids, params,
+							  NULL, NULL, 0) != 1)
+			pg_fatal("failed to send insert %d: %s", i, PQerrorMessage(conn));
+	}
+	if (PQsendFlushRequest(conn) != 1)
+		pg_fatal("failed to send flush request: %s", PQerrorMessage(conn));
+	if (PQflush(conn) != 0)
+		pg_fatal("failed to flush: %s", PQerrorMessage(conn));
+
+	/* the results are there before the transaction has ended */
+	expect_result(conn, PGRES_COMMAND_OK);
+	expect_null_result(conn);
+	for (i = 0; i < NUM_MANY_QUERIES; i++)
+	{
+		res = get_result_status(conn, PGRES_COMMAND_OK, __LINE__);
+		if (strcmp(PQcmdTuples(res), "1") != 0)
+			pg_fatal("insert %d reported \"%s\" rows", i, PQcmdTuples(res));
+		PQclear(res);
+		expect_null_result(conn);
+	}
+
+	if (PQsendQuery(conn, "COMMIT") != 1)
+		pg_fatal("failed to send COMMIT: %s", PQerrorMessage(conn));
+	if (PQsendQuery(conn, "SELECT count(*), sum(itemno) FROM pq_pipeline_demo") != 1)
+		pg_fatal("failed to send SELECT: %s", PQerrorMessage(conn));
+	if (PQpipelineSync(conn) != 1)
+		pg_fatal("pipeline sync failed: %s", PQerrorMessage(conn));
+
+	expect_result(conn, PGRES_COMMAND_OK);
+	expect_null_result(conn);
+
+	res = get_result_status(conn, PGRES_TUPLES_OK, __LINE__);
+	snprintf(buf, sizeof(buf), "%d", NUM_MANY_QUERIES * (NUM_MANY_QUERIES - 1) / 2);
+	if (atoi(PQgetvalue(res, 0, 0)) != NUM_MANY_QUERIES ||
+		strcmp(PQgetvalue(res, 0, 1), buf) != 0)
+		pg_fatal("unexpected result %s, %s",
+				 PQgetvalue(res, 0, 0), PQgetvalue(res, 0, 1));
+	PQclear(res);
+	expect_null_result(conn);
+
+	expect_result(conn, PGRES_PIPELINE_SYNC);
+
+	if (PQexitPipelineMode(conn) != 1)
+		pg_fatal("could not exit pipeline mode: %s", PQerrorMessage(conn));
+
+	fprintf(stderr, "ok\n");
+}
+
+/*
+ * Single-row mode can be used for each query of a pipeline.
+ */
+static void
+test_singlerowmode(PGconn *conn)
+{
+	PGresult   *res;
+	const char *params[1] = {"44"};
+	int			i;
+
+	fprintf(stderr, "single row mode... ");
+
+	if (PQenterPipelineMode(conn) != 1)
+		pg_fatal("failed to enter pipeline mode: %s", PQerrorMessage(conn));
+
+	for (i = 0; i < 3; i++)
+	{
+		if (PQsendQueryParams(conn, "SELECT generate_series(42, $1)",
+							  1, NULL, params,
+							  NULL, NULL, 0) != 1)
+			pg_fatal("failed to send query: %s", PQerrorMessage(conn));
+	}
+	if (PQpipelineSync(conn) != 1)
+		pg_fatal("pipeline sync failed: %s", PQerrorMessage(conn));
+
+	for (i = 0; i < 3; i++)
+	{
+		int			nrows = 0;
+		bool		gotsingle = false;
+
+		/* only the first and the last query use single-row mode */
+		if (i != 1 && PQsetSingleRowMode(conn) != 1)
+			pg_fatal("PQsetSingleRowMode() failed for query %d", i);
+
+		while ((res = PQgetResult(conn)) != NULL)
+		{
+			ExecStatusType est = PQresultStatus(res);
+
+			if (est == PGRES_SINGLE_TUPLE)
+			{
+				if (i == 1)
+					pg_fatal("got a single tuple without single-row mode");
+				if (strtol(PQgetvalue(res, 0, 0), NULL, 10) != 42 + nrows)
+					pg_fatal("unexpected row value \"%s\"",
+							 PQgetvalue(res, 0, 0));
+				gotsingle = true;
+				nrows++;
+			}
+			else if (est == PGRES_TUPLES_OK)
+			{
+				/* the final result has no rows in single-row mode */
+				if (gotsingle ? PQntuples(res) != 0 : PQntuples(res) != 3)
+					pg_fatal("unexpected number of rows %d in final result",
+							 PQntuples(res));
+				nrows += PQntuples(res);
+			}
+			else
+				pg_fatal("unexpected result status %s: %s",
+						 PQresStatus(est), PQerrorMessage(conn));
+			PQclear(res);
+		}
+		if (nrows != 3)
+			pg_fatal("query %d returned %d rows, expected 3", i, nrows);
+	}
+
+	expect_result(conn, PGRES_PIPELINE_SYNC);
+
+	if (PQexitPipelineMode(conn) != 1)
+		pg_fatal("failed to end pipeline mode: %s", PQerrorMessage(conn));
+
+	fprintf(stderr, "ok\n");
+}
+
+/*
+ * Transaction control commands work in a pipeline, and an error in an
+ * explicit transaction aborts that transaction.
+ */
+static void
+test_transaction(PGconn *conn)
+{
+	PGresult   *res;
+
+	fprintf(stderr, "transaction... ");
+
+	res = PQexec(conn, "DROP TABLE IF EXISTS pq_pipeline_tst;"
+				 "CREATE TABLE pq_pipeline_tst (id int)");
+	if (PQresultStatus(res) != PGRES_COMMAND_OK)
+		pg_fatal("failed to create test table: %s", PQerrorMessage(conn));
+	PQclear(res);
+
+	if (PQenterPipelineMode(conn) != 1)
+		pg_fatal("failed to enter pipeline mode: %s", PQerrorMessage(conn));
+
+	/* an error in an explicit transaction aborts it */
+	if (PQsendQuery(conn, "BEGIN") != 1 ||
+		PQsendQuery(conn, "INSERT INTO pq_pipeline_tst VALUES (1)") != 1 ||
+		PQsendQuery(conn, "SELECT 1/0") != 1 ||
+		PQsendQuery(conn, "COMMIT") != 1)
+		pg_fatal("failed to send query: %s", PQerrorMessage(conn));
+	if (PQpipelineSync(conn) != 1)
+		pg_fatal("pipeline sync failed: %s", PQerrorMessage(conn));
+
+	/* the sync point doesn't end the failed transaction block */
+	if (PQsendQuery(conn, "ROLLBACK") != 1 ||
+		PQsendQuery(conn, "INSERT INTO pq_pipeline_tst VALUES (2)") != 1)
+		pg_fatal("failed to send query: %s", PQerrorMessage(conn));
+	if (PQpipelineSync(conn) != 1)
+		pg_fatal("pipeline sync failed: %s", PQerrorMessage(conn));
+
+	/* a transaction spanning a sync point */
+	if (PQsendQuery(conn, "BEGIN") != 1 ||
+		PQsendQuery(conn, "INSERT INTO pq_pipeline_tst VALUES (3)") != 1)
+		pg_fatal("failed to send query: %s", PQerrorMessage(conn));
+	if (PQpipelineSync(conn) != 1)
+		pg_fatal("pipeline sync failed: %s", PQerrorMessage(conn));
+	if (PQsendQuery(conn, "INSERT INTO pq_pipeline_tst VALUES (4)") != 1 ||
+		PQsendQuery(conn, "COMMIT") != 1)
+		pg_fatal("failed to send query: %s", PQerrorMessage(conn));
+	if (PQpipelineSync(conn) != 1)
+		pg_fatal("pipeline sync failed: %s", PQerrorMessage(conn));
+
+	expect_result(conn, PGRES_COMMAND_OK);	/* BEGIN */
+	expect_null_result(conn);
+	expect_result(conn, PGRES_COMMAND_OK);	/* INSERT */
+	expect_null_result(conn);
+	expect_result(conn, PGRES_FATAL_ERROR); /* SELECT 1/0 */
+	expect_null_result(conn);
+	expect_result(conn, PGRES_PIPELINE_ABORTED);	/* COMMIT */
+	expect_null_result(conn);
+	expect_result(conn, PGRES_PIPELINE_SYNC);
+
+	expect_result(conn, PGRES_COMMAND_OK);	/* ROLLBACK */
+	expect_null_result(conn);
+	expect_result(conn, PGRES_COMMAND_OK);	/* INSERT */
+	expect_null_result(conn);
+	expect_result(conn, PGRES_PIPELINE_SYNC);
+
+	expect_result(conn, PGRES_COMMAND_OK);	/* BEGIN */
+	expect_null_result(conn);
+	expect_result(conn, PGRES_COMMAND_OK);	/* INSERT */
+	expect_null_result(conn);
+	expect_result(conn, PGRES_PIPELINE_SYNC);
+	expect_result(conn, PGRES_COMMAND_OK);	/* INSERT */
+	expect_null_result(conn);
+	expect_result(conn, PGRES_COMMAND_OK);	/* COMMIT */
+	expect_null_result(conn);
+	expect_result(conn, PGRES_PIPELINE_SYNC);
+
+	if (PQexitPipelineMode(conn) != 1)
+		pg_fatal("failed to end pipeline mode: %s", PQerrorMessage(conn));
+
+	res = PQexec(conn, "SELECT string_agg(id::text, ',' ORDER BY id) FROM pq_pipeline_tst");
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+		pg_fatal("failed to query test table: %s", PQerrorMessage(conn));
+	if (strcmp(PQgetvalue(res, 0, 0), "2,3,4") != 0)
+		pg_fatal("unexpected table contents \"%s\"", PQgetvalue(res, 0, 0));
+	PQclear(res);
+
+	res = PQexec(conn, "DROP TABLE pq_pipeline_tst");
+	if (PQresultStatus(res) != PGRES_COMMAND_OK)
+		pg_fatal("failed to drop test table: %s", PQerrorMessage(conn));
+	PQclear(res);
+
+	fprintf(stderr, "ok\n");
+}
+
+static void
+usage(const char *progname)
+{
+	fprintf(stderr, "%s tests the libpq pipeline mode.\n\n", progname);
+	fprintf(stderr, "Usage:\n");
+	fprintf(stderr, "  %s tests\n", progname);
+	fprintf(stderr, "  %s TESTNAME [CONNINFO]\n", progname);
+}
+
+static void
+print_test_list(void)
+{
+	printf("disallowed_in_pipeline\n");
+	printf("many\n");
+	printf("multi_pipelines\n");
+	printf("pipeline_abort\n");
+	printf("prepared\n");
+	printf("simple_pipeline\n");
+	printf("singlerow\n");
+	printf("transaction\n");
+}
+
+int
+main(int argc, char **argv)
+{
+	const char *conninfo = "";
+	PGconn	   *conn;
+	PGresult   *res;
+
+	if (argc < 2 || argc > 3)
+	{
+		usage(argv[0]);
+		exit(1);
+	}
+
+	if (strcmp(argv[1], "tests") == 0)
+	{
+		print_test_list();
+		exit(0);
+	}
+
+	/*
+	 * If it is supplied, use the parameter as the conninfo string;
+	 * otherwise use environment variables or defaults for all connection
+	 * parameters.
+	 */
+	if (argc > 2)
+		conninfo = argv[2];
+	conn = PQconnectdb(conninfo);
+	if (PQstatus(conn) != CONNECTION_OK)
+	{
+		fprintf(stderr, "Connection to database failed: %s\n",
+				PQerrorMessage(conn));
+		exit_nicely(conn);
+	}
+
+	/* Set the output to a known state, for messages */
+	res = PQexec(conn, "SET lc_messages TO \"C\"");
+	if (PQresultStatus(res) != PGRES_COMMAND_OK)
+		pg_fatal("failed to set lc_messages: %s", PQerrorMessage(conn));
+	PQclear(res);
+
+	if (strcmp(argv[1], "disallowed_in_pipeline") == 0)
+		test_disallowed_in_pipeline(conn);
+	else if (strcmp(argv[1], "many") == 0)
+		test_many(conn);
+	else if (strcmp(argv[1], "multi_pipelines") == 0)
+		test_multi_pipelines(conn);
+	else if (strcmp(argv[1], "pipeline_abort") == 0)
+		test_pipeline_abort(conn);
+	else if (strcmp(argv[1], "prepared") == 0)
+		test_prepared(conn);
+	else if (strcmp(argv[1], "simple_pipeline") == 0)
+		test_simple_pipeline(conn);
+	else if (strcmp(argv[1], "singlerow") == 0)
+		test_singlerowmode(conn);
+	else if (strcmp(argv[1], "transaction") == 0)
+		test_transaction(conn);
+	else
+	{
+		fprintf(stderr, "\"%s\" is not a recognized test name\n", argv[1]);
+		exit(1);
+	}
+
+	/* close the connection to the database and cleanup */
+	PQfinish(conn);
+	return 0;
+}
@@ -0,0 +1,26 @@
+# Test the pipeline mode of libpq
+use strict;
+use warnings;
+
+use PostgresNode;
+use TestLib;
+use Test::More;
+
+my $program = "$ENV{TESTDIR}/libpq_pipeline";
+
+my $node = get_new_node('main');
+$node->init;
+$node->start;
+
+my @tests = split(/\s+/, `$program tests`);
+die "no tests found" if !@tests;
+
+for my $testname (@tests)
+{
+	$node->command_ok([ $program, $testname, $node->connstr('postgres') ],
+		"libpq_pipeline $testname");
+}
+
+$node->stop('fast');
+
+done_testing();
@@ -0,0 +1,19 @@
+CREATE EXTENSION test_bench;
+
+-- Timings vary from run to run, so only check that each harness does the
+-- requested amount of work and reports sane numbers.
+SELECT benchmark = 'tuplesort' AND ops = 1000 AND ns_per_op >= 0 AS ok
+  FROM bench_tuplesort(1000, 2);
+SELECT benchmark = 'hashagg' AND ops = 1000 AND ns_per_op >= 0 AS ok
+  FROM bench_hashagg(1000, 10, 2);
+SELECT benchmark = 'expr' AND ops = 1000 AND ns_per_op >= 0 AS ok
+  FROM bench_expr(1000, 2);
+SELECT benchmark = 'xlog_insert' AND ops = 100 AND ns_per_op >= 0 AS ok
+  FROM bench_xlog_insert(100, 64, 2);
+SELECT benchmark = 'buffer_pin' AND ops = 1000 AND ns_per_op >= 0 AS ok
+  FROM bench_buffer_pin('pg_class', 1000, 2);
+
+-- argument checks
+SELECT * FROM bench_tuplesort(0);
+SELECT * FROM bench_hashagg(10, 0);
+SELECT * FROM bench_xlog_insert(10, -1);
@@ -0,0 +1,509 @@
+/*--------------------------------------------------------------------------
+ *
+ * test_bench.c
+ *		Microbenchmark harnesses for executor, sort, hash and WAL hot paths.
+ *
+ * Each SQL-callable function runs one isolated workload "loops" times and
+ * reports the fastest loop, which is much more stable than the mean on a
+ * busy machine.  Input data is generated with a fixed-seed generator so
+ * that runs are repeatable across builds.
+ *
+ * Copyright (c) 2019, PostgreSQL Global Development Group
+ *
+ * IDENTIFICATION
+ *		src/test/modules/test_bench/test_bench.c
+ *
+ * -------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/heapam.h"
+#include "access/htup_details.h"
+#include "access/xlog.h"
+#include "access/xloginsert.h"
+#include "catalog/objectaddress.h"
+#include "catalog/pg_class.h"
+#include "catalog/pg_control.h"
+#include "catalog/pg_type.h"
+#include "executor/executor.h"
+#include "fmgr.h"
+#include "funcapi.h"
+#include "miscadmin.h"
+#include "nodes/makefuncs.h"
+#include "portability/instr_time.h"
+#include "storage/bufmgr.h"
+#include "utils/acl.h"
+#include "utils/builtins.h"
+#include "utils/fmgroids.h"
+#include "utils/lsyscache.h"
+#include "utils/memutils.h"
+#include "utils/rel.h"
+#include "utils/tuplesort.h"
+#include "utils/typcache.h"
+
+PG_MODULE_MAGIC;
+
+/* Largest WAL record payload bench_xlog_insert() accepts */
+#define MAX_RECORD_SIZE		(1024 * 1024)
+
+PG_FUNCTION_INFO_V1(bench_tuplesort);
+PG_FUNCTION_INFO_V1(bench_hashagg);
+PG_FUNCTION_INFO_V1(bench_expr);
+PG_FUNCTION_INFO_V1(bench_xlog_insert);
+PG_FUNCTION_INFO_V1(bench_buffer_pin);
+
+/*
+ * Timing state shared by all harnesses: the fastest loop seen so far.
+ */
+typedef struct BenchTimer
+{
+	instr_time	start;
+	double		best_ms;
+} BenchTimer;
+
+
+/*
+ * Small xorshift generator.  We don't use random() because we want the
+ * same input for every run regardless of what else the backend did.
+ */
+static inline uint64
+bench_next(uint64 *state)
+{
+	uint64		x = *state;
+
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	*state = x;
+	return x;
+}
+
+static void
+check_arguments(int64 nops, int32 loops)
+{
+	if (nops <= 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("number of operations must be positive")));
+	if (loops <= 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("number of loops must be positive")));
+}
+
+static inline void
+bench_timer_start(BenchTimer *timer)
+{
+	INSTR_TIME_SET_CURRENT(timer->start);
+}
+
+static inline void
+bench_timer_stop(BenchTimer *timer, int loop)
+{
+	instr_time	elapsed;
+	double		ms;
+
+	INSTR_TIME_SET_CURRENT(elapsed);
+	INSTR_TIME_SUBTRACT(elapsed, timer->start);
+	ms = INSTR_TIME_GET_MILLISEC(elapsed);
+
+	if (loop == 0 || ms < timer->best_ms)
+		timer->best_ms = ms;
+}
+
+/*
+ * Form the result row common to all harnesses:
+ * (benchmark text, ops int8, elapsed_ms float8, ns_per_op float8)
+ *
+ * "ops" is the number of operations done in one loop, and the timings are
+ * those of the fastest loop.
+ */
+static Datum
+bench_result(FunctionCallInfo fcinfo, const char *name, int64 ops,
+			 BenchTimer *timer)
+{
+	TupleDesc	tupdesc;
+	Datum		values[4];
+	bool		nulls[4];
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	memset(nulls, 0, sizeof(nulls));
+	values[0] = CStringGetTextDatum(name);
+	values[1] = Int64GetDatum(ops);
+	values[2] = Float8GetDatum(timer->best_ms);
+	values[3] = Float8GetDatum(timer->best_ms * 1000000.0 / ops);
+
+	return HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls));
+}
+
+/*
+ * bench_tuplesort(ntuples, loops)
+ *
+ * Sort "ntuples" pseudo-random int8 datums, with work_mem as the memory
+ * budget, and read them back.  One operation is one tuple.
+ */
+Datum
+bench_tuplesort(PG_FUNCTION_ARGS)
+{
+	int32		ntuples = PG_GETARG_INT32(0);
+	int32		loops = PG_GETARG_INT32(1);
+	TypeCacheEntry *typentry;
+	BenchTimer	timer;
+	int			loop;
+
+	check_arguments(ntuples, loops);
+
+	typentry = lookup_type_cache(INT8OID, TYPECACHE_LT_OPR);
+
+	for (loop = 0; loop < loops; loop++)
+	{
+		Tuplesortstate *sortstate;
+		uint64		seed = UINT64CONST(0x9E3779B97F4A7C15);
+		Datum		val;
+		bool		isnull;
+		int32		i;
+
+		bench_timer_start(&timer);
+
+		sortstate = tuplesort_begin_datum(INT8OID, typentry->lt_opr,
+										  InvalidOid, false, work_mem,
+										  NULL, false);
+		for (i = 0; i < ntuples; i++)
+			tuplesort_putdatum(sortstate,
+							   Int64GetDatum((int64) bench_next(&seed)),
+							   false);
+		tuplesort_performsort(sortstate);
+		while (tuplesort_getdatum(sortstate, true, &val, &isnull, NULL))
+			;
+		tuplesort_end(sortstate);
+
+		bench_timer_stop(&timer, loop);
+		CHECK_FOR_INTERRUPTS();
+	}
+
+	return bench_result(fcinfo, "tuplesort", ntuples, &timer);
+}
+
+/*
+ * bench_hashagg(ntuples, ngroups, loops)
+ *
+ * Look up "ntuples" int8 keys, drawn from "ngroups" distinct values, in an
+ * execGrouping.c tuple hash table, as hashed aggregation does.  One
+ * operation is one lookup.
+ */
+Datum
+bench_hashagg(PG_FUNCTION_ARGS)
+{
+	int32		ntuples = PG_GETARG_INT32(0);
+	int32		ngroups = PG_GETARG_INT32(1);
+	int32		loops = PG_GETARG_INT32(2);
+	TypeCacheEntry *typentry;
+	EState	   *estate;
+	PlanState  *parent;
+	TupleDesc	tupdesc;
+	TupleTableSlot *slot;
+	AttrNumber *keyColIdx;
+	Oid		   *eqfuncoids;
+	FmgrInfo   *hashfunctions;
+	MemoryContext metacxt;
+	MemoryContext tablecxt;
+	MemoryContext tempcxt;
+	BenchTimer	timer;
+	int			loop;
+
+	check_arguments(ntuples, loops);
+	if (ngroups <= 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("number of groups must be positive")));
+
+	typentry = lookup_type_cache(INT8OID, TYPECACHE_EQ_OPR);
+
+	/* The hash table wants a parent node to get at the EState */
+	estate = CreateExecutorState();
+	parent = makeNode(PlanState);
+	parent->state = estate;
+
+	tupdesc = CreateTemplateTupleDesc(1);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 1, "key", INT8OID, -1, 0);
+	slot = MakeSingleTupleTableSlot(tupdesc, &TTSOpsMinimalTuple);
+
+	keyColIdx = (AttrNumber *) palloc(sizeof(AttrNumber));
+	keyColIdx[0] = 1;
+	execTuplesHashPrepare(1, &typentry->eq_opr, &eqfuncoids, &hashfunctions);
+
+	metacxt = AllocSetContextCreate(CurrentMemoryContext,
+									"bench hash table",
+									ALLOCSET_DEFAULT_SIZES);
+	tablecxt = AllocSetContextCreate(CurrentMemoryContext,
+									 "bench hash table entries",
+									 ALLOCSET_DEFAULT_SIZES);
+	tempcxt = AllocSetContextCreate(CurrentMemoryContext,
+									"bench hash temp",
+									ALLOCSET_SMALL_SIZES);
+
+	for (loop = 0; loop < loops; loop++)
+	{
+		TupleHashTable hashtable;
+		uint64		seed = UINT64CONST(0x9E3779B97F4A7C15);
+		bool		isnew;
+		int32		i;
+
+		bench_timer_start(&timer);
+
+		hashtable = BuildTupleHashTableExt(parent, tupdesc, 1, keyColIdx,
+										   eqfuncoids, hashfunctions,
+										   ngroups, 0,
+										   metacxt, tablecxt, tempcxt,
+										   false);
+		for (i = 0; i < ntuples; i++)
+		{
+			ExecClearTuple(slot);
+			slot->tts_values[0] =
+				Int64GetDatum((int64) (bench_next(&seed) % ngroups));
+			slot->tts_isnull[0] = false;
+			ExecStoreVirtualTuple(slot);
+
+			(void) LookupTupleHashEntry(hashtable, slot, &isnew);
+		}
+
+		bench_timer_stop(&timer, loop);
+
+		MemoryContextReset(tablecxt);
+		MemoryContextReset(metacxt);
+		CHECK_FOR_INTERRUPTS();
+	}
+
+	ExecDropSingleTupleTableSlot(slot);
+	MemoryContextDelete(tempcxt);
+	MemoryContextDelete(tablecxt);
+	MemoryContextDelete(metacxt);
+	FreeExecutorState(estate);
+
+	return bench_result(fcinfo, "hashagg", ntuples, &timer);
+}
+
+/*
+ * bench_expr(ntuples, loops)
+ *
+ * Evaluate "(x * 3 + 1) > 0" with ExecInterpExpr (or JIT-compiled code,
+ * if enabled) for "ntuples" scan tuples.  One operation is one evaluation,
+ * including the per-tuple context reset the executor would do.
+ */
+Datum
+bench_expr(PG_FUNCTION_ARGS)
+{
+	int32		ntuples = PG_GETARG_INT32(0);
+	int32		loops = PG_GETARG_INT32(1);
+	TupleDesc	tupdesc;
+	TupleTableSlot *slot;
+	ExprContext *econtext;
+	ExprState  *exprstate;
+	Expr	   *expr;
+	BenchTimer	timer;
+	int			loop;
+
+	check_arguments(ntuples, loops);
+
+	tupdesc = CreateTemplateTupleDesc(1);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 1, "x", INT8OID, -1, 0);
+	slot = MakeSingleTupleTableSlot(tupdesc, &TTSOpsVirtual);
+
+	expr = (Expr *) makeVar(1, 1, INT8OID, -1, InvalidOid, 0);
+	expr = (Expr *) makeFuncExpr(F_INT8MUL, INT8OID,
+								 list_make2(expr,
+											makeConst(INT8OID, -1, InvalidOid,
+													  sizeof(int64),
+													  Int64GetDatum(3),
+													  false, FLOAT8PASSBYVAL)),
+								 InvalidOid, InvalidOid, COERCE_EXPLICIT_CALL);
+	expr = (Expr *) makeFuncExpr(F_INT8PL, INT8OID,
+								 list_make2(expr,
+											makeConst(INT8OID, -1, InvalidOid,
+													  sizeof(int64),
+													  Int64GetDatum(1),
+													  false, FLOAT8PASSBYVAL)),
+								 InvalidOid, InvalidOid, COERCE_EXPLICIT_CALL);
+	expr = (Expr *) makeFuncExpr(F_INT8GT, BOOLOID,
+								 list_make2(expr,
+											makeConst(INT8OID, -1, InvalidOid,
+													  sizeof(int64),
+													  Int64GetDatum(0),
+													  false, FLOAT8PASSBYVAL)),
+								 InvalidOid, InvalidOid, COERCE_EXPLICIT_CALL);
+
+	exprstate = ExecInitExpr(expr, NULL);
+	econtext = CreateStandaloneExprContext();
+	econtext->ecxt_scantuple = slot;
+
+	for (loop = 0; loop < loops; loop++)
+	{
+		uint64		seed = UINT64CONST(0x9E3779B97F4A7C15);
+		bool		isnull;
+		int32		i;
+
+		bench_timer_start(&timer);
+
+		for (i = 0; i < ntuples; i++)
+		{
+			ResetExprContext(econtext);
+
+			ExecClearTuple(slot);
+			/* keep it small enough that x * 3 + 1 can't overflow */
+			slot->tts_values[0] = Int64GetDatum((int64) (bench_next(&seed) >> 4));
+			slot->tts_isnull[0] = false;
+			ExecStoreVirtualTuple(slot);
+
+			(void) ExecEvalExprSwitchContext(exprstate, econtext, &isnull);
+		}
+
+		bench_timer_stop(&timer, loop);
+		CHECK_FOR_INTERRUPTS();
+	}
+
+	FreeExprContext(econtext, true);
+	ExecDropSingleTupleTableSlot(slot);
+
+	return bench_result(fcinfo, "expr", ntuples, &timer);
+}
+
+/*
+ * bench_xlog_insert(nrecords, record_size, loops)
+ *
+ * Insert "nrecords" XLOG_NOOP records carrying "record_size" bytes of
+ * payload each.  One operation is one XLogInsert() call.  Nothing is
+ * flushed here, so this measures record assembly and WAL buffer insertion
+ * rather than I/O.
+ */
+Datum
+bench_xlog_insert(PG_FUNCTION_ARGS)
+{
+	int32		nrecords = PG_GETARG_INT32(0);
+	int32		record_size = PG_GETARG_INT32(1);
+	int32		loops = PG_GETARG_INT32(2);
+	char	   *payload;
+	BenchTimer	timer;
+	int			loop;
+
+	if (!superuser())
+		ereport(ERROR,
+				(errcode(ERRCODE_INSUFFICIENT_PRIVILEGE),
+				 errmsg("must be superuser to use this function")));
+
+	if (RecoveryInProgress())
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("recovery is in progress"),
+				 errhint("WAL control functions cannot be executed during recovery.")));
+
+	check_arguments(nrecords, loops);
+	if (record_size < 0 || record_size > MAX_RECORD_SIZE)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("record size must be between 0 and %d",
+						MAX_RECORD_SIZE)));
+
+	payload = palloc0(Max(record_size, 1));
+
+	for (loop = 0; loop < loops; loop++)
+	{
+		int32		i;
+
+		bench_timer_start(&timer);
+
+		for (i = 0; i < nrecords; i++)
+		{
+			XLogBeginInsert();
+			if (record_size > 0)
+				XLogRegisterData(payload, record_size);
+			(void) XLogInsert(RM_XLOG_ID, XLOG_NOOP);
+		}
+
+		bench_timer_stop(&timer, loop);
+		CHECK_FOR_INTERRUPTS();
+	}
+
+	pfree(payload);
+
+	return bench_result(fcinfo, "xlog_insert", nrecords, &timer);
+}
+
+/*
+ * bench_buffer_pin(rel, npins, loops)
+ *
+ * Pin and unpin blocks of "rel" in turn, "npins" times.  Run it against a
+ * relation that fits in shared_buffers, after warming it up, so that each
+ * operation is a buffer mapping lookup plus a pin/unpin cycle rather than a
+ * read.
+ */
+Datum
+bench_buffer_pin(PG_FUNCTION_ARGS)
+{
+	Oid			relid = PG_GETARG_OID(0);
+	int32		npins = PG_GETARG_INT32(1);
+	int32		loops = PG_GETARG_INT32(2);
+	Relation	rel;
+	AclResult	aclresult;
+	BlockNumber nblocks;
+	BenchTimer	timer;
+	int			loop;
+
+	check_arguments(npins, loops);
+
+	rel = relation_open(relid, AccessShareLock);
+
+	aclresult = pg_class_aclcheck(relid, GetUserId(), ACL_SELECT);
+	if (aclresult != ACLCHECK_OK)
+		aclcheck_error(aclresult, get_relkind_objtype(rel->rd_rel->relkind),
+					   get_rel_name(relid));
+
+	if (rel->rd_rel->relkind != RELKIND_RELATION &&
+		rel->rd_rel->relkind != RELKIND_INDEX &&
+		rel->rd_rel->relkind != RELKIND_MATVIEW &&
+		rel->rd_rel->relkind != RELKIND_TOASTVALUE)
+		ereport(ERROR,
+				(errcode(ERRCODE_WRONG_OBJECT_TYPE),
+				 errmsg("\"%s\" is not a table, index, materialized view, or TOAST table",
+						RelationGetRelationName(rel))));
+
+	if (RELATION_IS_OTHER_TEMP(rel))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("cannot access temporary tables of other sessions")));
+
+	nblocks = RelationGetNumberOfBlocks(rel);
+	if (nblocks == 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("relation \"%s\" is empty",
+						RelationGetRelationName(rel))));
+
+	for (loop = 0; loop < loops; loop++)
+	{
+		BlockNumber blkno = 0;
+		int32		i;
+
+		bench_timer_start(&timer);
+
+		for (i = 0; i < npins; i++)
+		{
+			Buffer		buf;
+
+			buf = ReadBufferExtended(rel, MAIN_FORKNUM, blkno, RBM_NORMAL,
+									 NULL);
+			ReleaseBuffer(buf);
+
+			if (++blkno >= nblocks)
+				blkno = 0;
+		}
+
+		bench_timer_stop(&timer, loop);
+		CHECK_FOR_INTERRUPTS();
+	}
+
+	relation_close(rel, AccessShareLock);
+
+	return bench_result(fcinfo, "buffer_pin", npins, &timer);
+}
@@ -0,0 +1,181 @@
+# Test transaction-level pooling by the connection proxy
+use strict;
+use warnings;
+use PostgresNode;
+use TestLib;
+use Test::More;
+use Time::HiRes qw(usleep);
+
+if ($windows_os)
+{
+	plan skip_all => 'connection proxy is not supported on Windows';
+}
+else
+{
+	plan tests => 16;
+}
+
+# To avoid hanging while expecting some specific input from a psql
+# instance being driven by us, add a timeout high enough that it
+# should never trigger even on very slow machines, unless something
+# is really wrong.
+my $psql_timeout = IPC::Run::timer(60);
+
+my $node = get_new_node('main');
+$node->init;
+
+# Reserve a port for the proxy, so that no other node gets it
+my $proxy_port = get_new_node('proxy')->port;
+$node->append_conf(
+	'postgresql.conf', qq(
+proxy_port = $proxy_port
+session_pool_size = 1
+));
+$node->start;
+
+my $proxy_connstr =
+  "host=" . $node->host . " port=$proxy_port dbname=postgres";
+
+# Start a psql session connected through the proxy
+sub start_session
+{
+	my %session = (stdin => '', stdout => '', stderr => '');
+
+	$session{h} = IPC::Run::start(
+		[ 'psql', '-X', '-qAt', '-f', '-', '-d', $proxy_connstr ],
+		'<',  \$session{stdin},
+		'>',  \$session{stdout},
+		'2>', \$session{stderr},
+		$psql_timeout);
+	return \%session;
+}
+
+# Send SQL to a session, without waiting for the result
+sub send_query
+{
+	my ($session, $sql) = @_;
+
+	$session->{stdout} = '';
+	$session->{stdin} .= "$sql;\n\\echo __done__\n";
+	$session->{h}->pump_nb;
+	return;
+}
+
+# Wait for the result of what was sent last to a session
+sub get_result
+{
+	my ($session) = @_;
+	my $h = $session->{h};
+
+	$h->pump_nb;
+	while ($session->{stdout} !~ /__done__\n/)
+	{
+		die "psql timed out: $session->{stderr}" if $psql_timeout->is_expired;
+		die "psql died: $session->{stderr}" if !$h->pumpable;
+		$h->pump;
+	}
+	(my $result = $session->{stdout}) =~ s/__done__\n$//;
+	chomp $result;
+	return $result;
+}
+
+sub query
+{
+	my ($session, $sql) = @_;
+
+	send_query($session, $sql);
+	return get_result($session);
+}
+
+# Clients take turns on the pool's only backend
+my $s1 = start_session();
+my $s2 = start_session();
+my $pid = query($s1, 'SELECT pg_backend_pid()');
+like($pid, qr/^[0-9]+$/, 'query through the proxy');
+is(query($s2, 'SELECT pg_backend_pid()'),
+	$pid, 'second client gets the same backend');
+is(query($s1, 'SELECT pg_backend_pid()'),
+	$pid, 'first client gets the backend again');
+
+# A client in a transaction keeps the backend until the transaction ends
+query($s1, 'BEGIN; CREATE TABLE proxy_tbl (a int)');
+send_query($s2, 'SELECT count(*) FROM proxy_tbl');
+foreach my $i (0 .. 9)
+{
+	usleep(100_000);
+	$s2->{h}->pump_nb;
+}
+is($s2->{stdout}, '', 'second client waits for the backend');
+is(query($s1, 'INSERT INTO proxy_tbl VALUES (1); COMMIT'),
+	'', 'first client commits');
+is(get_result($s2), '1', 'second client runs after the commit');
+
+# Session state pins the backend to its client, so give the pool room for
+# that
+$node->append_conf('postgresql.conf', 'session_pool_size = 3');
+$node->reload;
+$node->poll_query_until('postgres',
+	"SELECT setting = '3' FROM pg_settings WHERE name = 'session_pool_size'")
+  or die "timed out waiting for session_pool_size to change";
+
+my $s3 = start_session();
+query($s1, "SET work_mem = '1234kB'");
+my $pid1 = query($s1, 'SELECT pg_backend_pid()');
+query($s2, 'PREPARE proxy_stmt(int) AS SELECT $1 + 1');
+my $pid2 = query($s2, 'SELECT pg_backend_pid()');
+query($s3, 'CREATE TEMP TABLE proxy_temp AS SELECT 42 AS a');
+my $pid3 = query($s3, 'SELECT pg_backend_pid()');
+
+is(query($s1, 'SHOW work_mem'), '1234kB', 'SET survives the transaction');
+is(query($s2, 'EXECUTE proxy_stmt(41)'),
+	'42', 'prepared statement survives the transaction');
+is(query($s3, 'SELECT a FROM proxy_temp'),
+	'42', 'temporary table survives the transaction');
+is(query($s1, 'SELECT pg_backend_pid()') . ' '
+	  . query($s2, 'SELECT pg_backend_pid()') . ' '
+	  . query($s3, 'SELECT pg_backend_pid()'),
+	"$pid1 $pid2 $pid3",
+	'sessions with state keep their backends');
+ok($pid1 != $pid2 && $pid1 != $pid3 && $pid2 != $pid3,
+	'each session with state has a backend of its own');
+
+# While all backends are pinned, a new client has to wait
+my $s4 = start_session();
+send_query($s4, 'SELECT pg_backend_pid()');
+foreach my $i (0 .. 9)
+{
+	usleep(100_000);
+	$s4->{h}->pump_nb;
+}
+is($s4->{stdout}, '', 'new client waits while all backends are pinned');
+
+# Once the state is gone, the backend goes back to the pool
+query($s1, 'RESET work_mem');
+is(get_result($s4), $pid1, 'backend is released when SET is undone');
+query($s2, 'DEALLOCATE proxy_stmt');
+query($s3, 'DROP TABLE proxy_temp');
+is(query($s4, "SELECT setting FROM pg_settings WHERE name = 'work_mem'"),
+	'4096', 'released backend has the default settings');
+
+# Each backend can serve each client again
+my %pids;
+foreach my $i (0 .. 9)
+{
+	foreach my $s ($s1, $s2, $s3, $s4)
+	{
+		$pids{ query($s, 'SELECT pg_backend_pid()') } = 1;
+	}
+}
+ok(scalar(keys %pids) <= 3, 'clients share the pool of backends');
+
+# The clients' work went through to the database
+is($node->safe_psql('postgres', 'SELECT count(*) FROM proxy_tbl'),
+	'1', 'committed data is visible through a direct connection');
+
+foreach my $s ($s1, $s2, $s3, $s4)
+{
+	$s->{stdin} .= "\\q\n";
+	$s->{h}->finish;
+}
+
+$node->stop;
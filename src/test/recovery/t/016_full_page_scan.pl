@@ -0,0 +1,174 @@
+# Test crash recovery that skips redo of blocks restored from a later
+# full-page image (recovery_full_page_scan).
+use strict;
+use warnings;
+use PostgresNode;
+use TestLib;
+use Test::More;
+use Config;
+use Time::HiRes qw(usleep);
+if ($Config{osname} eq 'MSWin32')
+{
+
+	# some Windows Perls at least don't like IPC::Run's start/kill_kill regime.
+	plan skip_all => "Test fails on Windows perl";
+}
+else
+{
+	plan tests => 12;
+}
+
+my $node = get_new_node('master');
+$node->init(allows_streaming => 1);
+
+# A checkpoint that takes its time, so that we can crash in the middle of it
+$node->append_conf(
+	'postgresql.conf', qq(
+log_min_messages = debug1
+log_checkpoints = on
+checkpoint_timeout = '1h'
+checkpoint_completion_target = 0.9
+max_wal_size = '1GB'
+shared_buffers = '64MB'
+));
+$node->start;
+
+$node->safe_psql(
+	'postgres', q[
+CREATE TABLE fpi_tbl (id int PRIMARY KEY, v int) WITH (fillfactor = 50);
+INSERT INTO fpi_tbl SELECT g, 0 FROM generate_series(1, 5000) g;
+CREATE TABLE fpi_dirty (id int, pad text);
+CHECKPOINT;
+]);
+
+# Changes since the checkpoint recovery will start from.  Then dirty plenty
+# of buffers so that the next checkpoint has to write for a while.
+$node->safe_psql(
+	'postgres', q[
+UPDATE fpi_tbl SET v = v + 1;
+INSERT INTO fpi_dirty SELECT g, repeat('x', 500) FROM generate_series(1, 40000) g;
+]);
+
+# Start a spread checkpoint in the background, and wait for it to begin.
+# The first change to each block after it has begun logs a new full-page
+# image, which makes redo of the earlier changes of the block unnecessary.
+sub start_spread_checkpoint
+{
+	my ($label) = @_;
+	my $logstart = -s $node->logfile;
+	my ($stdin, $stdout, $stderr) = ('', '', '');
+	my $ckpt = IPC::Run::start(
+		[
+			'psql', '-X', '-qAt', '-v', 'ON_ERROR_STOP=1', '-f', '-', '-d',
+			$node->connstr('postgres')
+		],
+		'<',
+		\$stdin,
+		'>',
+		\$stdout,
+		'2>',
+		\$stderr);
+	$stdin .= qq[
+SELECT pg_start_backup('$label', false);
+];
+
+	my $started = 0;
+	foreach my $i (0 .. 1800)
+	{
+		$ckpt->pump_nb;
+		if (substr(slurp_file($node->logfile), $logstart) =~
+			/checkpoint starting: force wait/)
+		{
+			$started = 1;
+			last;
+		}
+		usleep(100_000);
+	}
+	ok($started, "spread checkpoint started ($label)");
+	return $ckpt;
+}
+
+my $ckpt = start_spread_checkpoint('fpi');
+
+$node->safe_psql('postgres', 'UPDATE fpi_tbl SET v = v + 1');
+
+# Crash before the checkpoint completes
+my $logstart = -s $node->logfile;
+$node->stop('immediate');
+$ckpt->kill_kill;
+$node->start;
+
+my $log = substr(slurp_file($node->logfile), $logstart);
+like(
+	$log,
+	qr/skipped redo of [1-9][0-9]* blocks overwritten by later full-page images/,
+	'redo skipped blocks with later full-page images');
+is( $node->safe_psql(
+		'postgres', 'SELECT count(*), min(v), max(v) FROM fpi_tbl'),
+	'5000|2|2',
+	'all updates are there after recovery');
+is( $node->safe_psql(
+		'postgres',
+		'SET enable_seqscan = off; SELECT count(*) FROM fpi_tbl WHERE id > 0'),
+	'5000',
+	'index is intact after recovery');
+
+# If an earlier recovery attempt had to give up because replay ended before
+# an image it relied upon, the next one replays everything without scanning.
+$node->safe_psql(
+	'postgres', q[
+CHECKPOINT;
+UPDATE fpi_tbl SET v = v + 1;
+]);
+$logstart = -s $node->logfile;
+$node->stop('immediate');
+my $failed_file = $node->data_dir . '/recovery_full_page_scan.failed';
+open(my $fh, '>', $failed_file) or die "could not create $failed_file: $!";
+close($fh);
+$node->start;
+
+$log = substr(slurp_file($node->logfile), $logstart);
+like(
+	$log,
+	qr/not scanning WAL for full-page images/,
+	'scan is not done after a failed recovery attempt');
+unlike($log, qr/skipped redo of/, 'no blocks were skipped');
+ok(!-e $failed_file, 'marker file is removed after recovery');
+is( $node->safe_psql(
+		'postgres', 'SELECT count(*), min(v), max(v) FROM fpi_tbl'),
+	'5000|3|3',
+	'all updates are there after full recovery');
+
+# With wal_consistency_checking, every record carries an image of each block
+# to compare the replayed page with, so redo of those blocks can't be skipped.
+$node->append_conf('postgresql.conf', "wal_consistency_checking = 'all'");
+$node->reload;
+$node->safe_psql(
+	'postgres', q[
+CHECKPOINT;
+UPDATE fpi_tbl SET v = v + 1;
+INSERT INTO fpi_dirty SELECT g, repeat('x', 500) FROM generate_series(1, 40000) g;
+]);
+$ckpt = start_spread_checkpoint('fpi_consistency');
+$node->safe_psql('postgres', 'UPDATE fpi_tbl SET v = v + 1');
+
+$logstart = -s $node->logfile;
+$node->stop('immediate');
+$ckpt->kill_kill;
+$node->start;
+
+$log = substr(slurp_file($node->logfile), $logstart);
+unlike(
+	$log,
+	qr/inconsistent page found/,
+	'replayed pages match with wal_consistency_checking');
+unlike(
+	$log,
+	qr/skipped redo of [1-9]/,
+	'no blocks were skipped with wal_consistency_checking');
+is( $node->safe_psql(
+		'postgres', 'SELECT count(*), min(v), max(v) FROM fpi_tbl'),
+	'5000|5|5',
+	'all updates are there after recovery with wal_consistency_checking');
+
+$node->stop;
@@ -976,3 +976,133 @@ SELECT dense_rank(x) WITHIN GROUP (ORDER BY x) FROM (VALUES (1),(1),(2),(2),(3),
 -- 2a505161-2727-2473-7c46-591ed108ac52@email.cz
 SELECT min(x ORDER BY y) FROM (VALUES(1, NULL)) AS d(x,y);
 SELECT min(x ORDER BY y) FROM (VALUES(1, 2)) AS d(x,y);
+
+-- Test hashed aggregation whose groups don't all fit into work_mem
+BEGIN;
+SET LOCAL work_mem = '64kB';
+SET LOCAL enable_sort = off;
+SELECT count(*), sum(c), sum(s), count(DISTINCT c)
+  FROM (SELECT g % 10000 AS k, count(*) AS c, sum(g) AS s
+        FROM generate_series(0, 39999) g GROUP BY 1) ss;
+-- Spilled tuples must be partitioned by the grouping columns, here not the
+-- first column of the input, or an expression
+CREATE TEMP TABLE agg_spill_tbl AS
+  SELECT g AS a, g % 10000 AS k FROM generate_series(0, 39999) g;
+EXPLAIN (COSTS OFF)
+SELECT count(*), sum(c), count(DISTINCT c)
+  FROM (SELECT k, count(*) AS c FROM agg_spill_tbl GROUP BY k) ss;
+SELECT count(*), sum(c), count(DISTINCT c)
+  FROM (SELECT k, count(*) AS c FROM agg_spill_tbl GROUP BY k) ss;
+SELECT count(*), sum(c), count(DISTINCT c)
+  FROM (SELECT a / 8 % 5000, count(*) AS c FROM agg_spill_tbl GROUP BY 1) ss;
+SET LOCAL enable_hashagg = off;
+SET LOCAL enable_sort = on;
+SELECT count(*), sum(c), count(DISTINCT c)
+  FROM (SELECT k, count(*) AS c FROM agg_spill_tbl GROUP BY k) ss;
+SELECT count(*), sum(c), count(DISTINCT c)
+  FROM (SELECT a / 8 % 5000, count(*) AS c FROM agg_spill_tbl GROUP BY 1) ss;
+ROLLBACK;
+
+-- Test approximate aggregates
+SELECT approx_count_distinct(x), approx_percentile(x, 0.5)
+  FROM (SELECT 1.0::float8 WHERE false) v(x);
+SELECT approx_count_distinct(x), approx_percentile(x, 0.5)
+  FROM (VALUES (NULL::float8), (NULL)) v(x);
+SELECT approx_percentile(x, NULL) FROM (VALUES (1.0::float8), (2)) v(x);
+SELECT approx_count_distinct(x), approx_percentile(x, 0.5)
+  FROM (VALUES (5.0::float8), (NULL), (5)) v(x);
+-- small inputs are counted almost exactly
+SELECT abs(approx_count_distinct(g % 1000) - 1000) < 10 AS ok
+  FROM generate_series(1, 10000) g;
+SELECT abs(approx_count_distinct(('v' || g % 1000)::text COLLATE "C") - 1000) < 10 AS ok
+  FROM generate_series(1, 10000) g;
+-- the estimates must be within a few standard errors
+SELECT abs(approx_count_distinct(g) - 100000) < 2500 AS ok
+  FROM generate_series(1, 100000) g;
+SELECT abs(approx_count_distinct(md5(g::text)) - 50000) < 1250 AS ok
+  FROM generate_series(1, 50000) g;
+SELECT p, abs(approx_percentile(g, p) - p * 100000) < 100 AS ok
+  FROM generate_series(1, 100000) g,
+       (VALUES (0.01::float8), (0.25), (0.5), (0.9), (0.999)) v(p)
+  GROUP BY p ORDER BY p;
+SELECT approx_percentile(g, 0), approx_percentile(g, 1)
+  FROM generate_series(1, 100000) g;
+SELECT approx_percentile(x, 1.5) FROM (VALUES (1.0::float8)) v(x);
+SELECT approx_percentile(x, -0.1) FROM (VALUES (1.0::float8)) v(x);
+SELECT approx_percentile(x, 'NaN') FROM (VALUES (1.0::float8)) v(x);
+
+-- in parallel, the workers' states are serialized and combined; combining
+-- t-digests costs some of their precision
+CREATE TABLE approx_agg_tbl AS
+  SELECT g AS a, g % 5000 AS b FROM generate_series(1, 100000) g;
+ANALYZE approx_agg_tbl;
+BEGIN;
+SET LOCAL parallel_setup_cost = 0;
+SET LOCAL parallel_tuple_cost = 0;
+SET LOCAL min_parallel_table_scan_size = 0;
+SET LOCAL max_parallel_workers_per_gather = 4;
+SET LOCAL parallel_leader_participation = off;
+EXPLAIN (COSTS OFF)
+SELECT approx_count_distinct(b), approx_percentile(a, 0.5) FROM approx_agg_tbl;
+SELECT abs(approx_count_distinct(a) - 100000) < 2500 AS a_ok,
+       abs(approx_count_distinct(b) - 5000) < 125 AS b_ok,
+       abs(approx_percentile(a, 0.5) - 50000) < 1000 AS p_ok,
+       approx_percentile(a, 0) AS min, approx_percentile(a, 1) AS max
+  FROM approx_agg_tbl;
+-- a state that is not a HyperLogLog sketch is rejected
+CREATE AGGREGATE approx_mismatched(float8, float8) (
+  sfunc = approx_percentile_transfn, stype = internal,
+  finalfunc = approx_count_distinct_final,
+  combinefunc = approx_count_distinct_combine,
+  serialfunc = approx_percentile_serialize,
+  deserialfunc = approx_count_distinct_deserialize,
+  parallel = safe);
+SELECT approx_mismatched(a, 0.5) FROM approx_agg_tbl;
+ROLLBACK;
+DROP TABLE approx_agg_tbl;
+
+-- Test DISTINCT aggregates deduplicating their input in a hash table; the
+-- results must be the same when the table overflows work_mem
+CREATE TABLE agg_distinct_tbl AS
+  SELECT g % 10 AS a, g AS b, (g % 1500)::text AS c, g % 7 AS d
+  FROM generate_series(1, 20000) g;
+ANALYZE agg_distinct_tbl;
+CREATE TEMP TABLE agg_distinct_res AS
+  SELECT a, count(DISTINCT b) AS cb, sum(DISTINCT b % 3000) AS sb,
+         count(DISTINCT c) AS cc,
+         md5(string_agg(DISTINCT c, ',' ORDER BY c)) AS sc
+  FROM agg_distinct_tbl GROUP BY a;
+SELECT * FROM agg_distinct_res ORDER BY a;
+SET work_mem = '64kB';
+SELECT a, count(DISTINCT b) AS cb, sum(DISTINCT b % 3000) AS sb,
+       count(DISTINCT c) AS cc,
+       md5(string_agg(DISTINCT c, ',' ORDER BY c)) AS sc
+  FROM agg_distinct_tbl GROUP BY a
+EXCEPT
+SELECT * FROM agg_distinct_res;
+SELECT count(DISTINCT b), sum(DISTINCT b), count(DISTINCT (b % 5000, c))
+  FROM agg_distinct_tbl;
+RESET work_mem;
+SELECT count(DISTINCT b), sum(DISTINCT b), count(DISTINCT (b % 5000, c))
+  FROM agg_distinct_tbl;
+DROP TABLE agg_distinct_res;
+
+-- in parallel, workers remove duplicates before the leader aggregates
+BEGIN;
+SET LOCAL parallel_setup_cost = 0;
+SET LOCAL parallel_tuple_cost = 0;
+SET LOCAL min_parallel_table_scan_size = 0;
+SET LOCAL max_parallel_workers_per_gather = 2;
+EXPLAIN (COSTS OFF)
+SELECT count(DISTINCT a), sum(DISTINCT d) FROM agg_distinct_tbl;
+SELECT count(DISTINCT a), sum(DISTINCT d) FROM agg_distinct_tbl;
+EXPLAIN (COSTS OFF)
+SELECT a, count(DISTINCT d), sum(DISTINCT d) FROM agg_distinct_tbl GROUP BY a;
+SELECT a, count(DISTINCT d), sum(DISTINCT d) FROM agg_distinct_tbl GROUP BY a;
+-- not when there are plain aggregates or FILTER clauses as well
+EXPLAIN (COSTS OFF)
+SELECT a, count(DISTINCT d), sum(d) FROM agg_distinct_tbl GROUP BY a;
+EXPLAIN (COSTS OFF)
+SELECT a, count(DISTINCT d) FILTER (WHERE b > 10) FROM agg_distinct_tbl GROUP BY a;
+ROLLBACK;
+DROP TABLE agg_distinct_tbl;
@@ -2511,6 +2511,15 @@ ALTER TABLE attmp ALTER COLUMN i SET (n_distinct = 1, n_distinct_inherited = 2);
 ALTER TABLE attmp ALTER COLUMN i RESET (n_distinct_inherited);
 ANALYZE attmp;
 DROP TABLE attmp;
+-- test compression column option
+CREATE TABLE attmp(t text);
+ALTER TABLE attmp ALTER COLUMN t SET (compression = pglz);
+\set VERBOSITY terse
+ALTER TABLE attmp ALTER COLUMN t SET (compression = nosuchmethod);
+\set VERBOSITY default
+INSERT INTO attmp VALUES (repeat('1234567890', 1000)), ('short');
+SELECT pg_column_compression(t) FROM attmp;
+DROP TABLE attmp;
 
 DROP USER regress_alter_table_user1;
 
@@ -460,3 +460,67 @@ VACUUM ANALYZE brin_test;
 EXPLAIN (COSTS OFF) SELECT * FROM brin_test WHERE a = 1;
 -- Ensure brin index is not used when values are not correlated
 EXPLAIN (COSTS OFF) SELECT * FROM brin_test WHERE b = 1;
+
+-- Test minmax-multi and bloom opclasses
+CREATE TABLE brin_multi_bloom (i int4, t text, d date)
+  WITH (autovacuum_enabled = false);
+INSERT INTO brin_multi_bloom
+  SELECT x, md5(x::text), date '2000-01-01' + x FROM generate_series(1, 5000) x;
+-- outliers, which would make plain minmax ranges useless
+INSERT INTO brin_multi_bloom VALUES
+  (-1000000, 'outlier', '1900-01-01'), (1000000, 'outlier', '2100-01-01');
+CREATE INDEX brin_multi_idx ON brin_multi_bloom
+  USING brin (i int4_minmax_multi_ops, d date_minmax_multi_ops)
+  WITH (pages_per_range = 1);
+CREATE INDEX brin_bloom_idx ON brin_multi_bloom
+  USING brin (t text_bloom_ops) WITH (pages_per_range = 1);
+SET enable_seqscan = off;
+SELECT count(*) FROM brin_multi_bloom WHERE i = 2500;
+SELECT count(*) FROM brin_multi_bloom WHERE i < 10;
+SELECT count(*) FROM brin_multi_bloom WHERE i >= 4990;
+SELECT count(*) FROM brin_multi_bloom WHERE d = '2000-01-11';
+SELECT count(*) FROM brin_multi_bloom WHERE d > '2099-01-01';
+SELECT count(*) FROM brin_multi_bloom WHERE t = md5('1234');
+SELECT count(*) FROM brin_multi_bloom WHERE t = 'outlier';
+SELECT count(*) FROM brin_multi_bloom WHERE t = 'none';
+RESET enable_seqscan;
+
+-- With autosummarize, a new range at the end of the table is summarized as
+-- soon as it is started (autovacuum does not process temp tables, so
+-- nothing can interfere here)
+CREATE TEMP TABLE brin_eager (a int);
+CREATE INDEX brin_eager_idx ON brin_eager USING brin (a)
+  WITH (pages_per_range = 1, autosummarize = on);
+INSERT INTO brin_eager SELECT generate_series(1, 1000);
+SELECT brin_summarize_new_values('brin_eager_idx');
+SET enable_seqscan = off;
+SELECT count(*) FROM brin_eager WHERE a = 999;
+RESET enable_seqscan;
+
+-- An update that changes only columns covered by BRIN indexes can be HOT,
+-- but the BRIN index still has to summarize the new values.  Everything
+-- happens in one transaction, so that the transaction's counters are not
+-- sent off to the stats collector halfway.
+CREATE TABLE brin_hot (id int PRIMARY KEY, val int)
+  WITH (fillfactor = 50, autovacuum_enabled = off);
+INSERT INTO brin_hot SELECT g, g FROM generate_series(1, 100) g;
+CREATE INDEX brin_hot_val_idx ON brin_hot USING brin (val)
+  WITH (pages_per_range = 1);
+BEGIN;
+UPDATE brin_hot SET val = 1000 + id WHERE id <= 10;
+SELECT pg_stat_get_xact_tuples_updated('brin_hot'::regclass) AS updated,
+       pg_stat_get_xact_tuples_hot_updated('brin_hot'::regclass) AS hot_updated;
+SET LOCAL enable_seqscan = off;
+EXPLAIN (COSTS OFF) SELECT id FROM brin_hot WHERE val = 1005;
+SELECT id FROM brin_hot WHERE val = 1005;
+SELECT count(*) FROM brin_hot WHERE val > 1000;
+-- A B-tree index on the column makes such updates non-HOT again
+CREATE INDEX brin_hot_val_btree ON brin_hot (val);
+UPDATE brin_hot SET val = 2000 + id WHERE id <= 10;
+SELECT pg_stat_get_xact_tuples_updated('brin_hot'::regclass) AS updated,
+       pg_stat_get_xact_tuples_hot_updated('brin_hot'::regclass) AS hot_updated;
+DROP INDEX brin_hot_val_btree;
+SELECT id FROM brin_hot WHERE val = 2005;
+SELECT count(*) FROM brin_hot WHERE val > 1000;
+COMMIT;
+DROP TABLE brin_hot;
@@ -111,3 +111,73 @@ create index btree_idx_err on btree_test(a) with (vacuum_cleanup_index_scale_fac
 -- Simple ALTER INDEX
 alter index btree_idx1 set (vacuum_cleanup_index_scale_factor = 70.0);
 select reloptions from pg_class WHERE oid = 'btree_idx1'::regclass;
+
+--
+-- Test deduplication of duplicate leaf tuples
+--
+create table btree_dedup_tbl (a int, b int);
+create index btree_dedup_idx on btree_dedup_tbl (a);
+insert into btree_dedup_tbl select g % 10, g from generate_series(1, 10000) g;
+-- Scans must return every duplicate, in both directions
+set enable_seqscan to false;
+set enable_bitmapscan to false;
+select count(*) from btree_dedup_tbl where a = 5;
+select a from btree_dedup_tbl where a < 3 order by a desc limit 2;
+-- VACUUM removes some of the heap TIDs of posting list tuples
+delete from btree_dedup_tbl where a = 5 and b > 5000;
+vacuum btree_dedup_tbl;
+select count(*) from btree_dedup_tbl where a = 5;
+reset enable_seqscan;
+reset enable_bitmapscan;
+-- Index build and storage parameter
+create index btree_dedup_idx2 on btree_dedup_tbl (a) with (deduplicate_items = off);
+select reloptions from pg_class WHERE oid = 'btree_dedup_idx2'::regclass;
+alter index btree_dedup_idx2 set (deduplicate_items = on);
+select reloptions from pg_class WHERE oid = 'btree_dedup_idx2'::regclass;
+drop table btree_dedup_tbl;
+
+--
+-- Test skip scans of indexes without a qual on the leading column
+--
+create table btree_skip_tbl (a int, b int, c int);
+insert into btree_skip_tbl select g % 5, g, g % 7 from generate_series(1, 20000) g;
+insert into btree_skip_tbl select null, g, 0 from generate_series(1, 100) g;
+create index btree_skip_idx on btree_skip_tbl (a, b);
+analyze btree_skip_tbl;
+set enable_seqscan to false;
+set enable_bitmapscan to false;
+explain (costs off)
+select * from btree_skip_tbl where b = 300;
+select * from btree_skip_tbl where b = 300;
+-- The NULL leading value is visited too
+select a, b from btree_skip_tbl where b in (10, 11, 12) order by a, b;
+explain (costs off)
+select a, b from btree_skip_tbl where b between 10 and 12 order by a desc, b desc;
+select a, b from btree_skip_tbl where b between 10 and 12 order by a desc, b desc;
+select count(*), sum(a), sum(b) from btree_skip_tbl where b > 19990;
+-- Backward fetches from a cursor
+begin;
+declare btree_skip_cur scroll cursor for
+  select a, b from btree_skip_tbl where b between 10 and 12 order by a, b;
+fetch 3 from btree_skip_cur;
+fetch backward 2 from btree_skip_cur;
+fetch all from btree_skip_cur;
+fetch backward all from btree_skip_cur;
+commit;
+-- Descending leading column, with NULLs first
+create index btree_skip_desc_idx on btree_skip_tbl (c desc nulls first, b);
+update btree_skip_tbl set c = null where b % 1000 = 17;
+explain (costs off)
+select c, b from btree_skip_tbl where b between 1015 and 1018 order by c desc nulls first, b;
+select c, b from btree_skip_tbl where b between 1015 and 1018 order by c desc nulls first, b;
+-- Same answers without skipping
+set enable_indexskipscan to false;
+reset enable_seqscan;
+explain (costs off)
+select a, b from btree_skip_tbl where b in (10, 11, 12) order by a, b;
+select a, b from btree_skip_tbl where b in (10, 11, 12) order by a, b;
+select count(*), sum(a), sum(b) from btree_skip_tbl where b > 19990;
+select c, b from btree_skip_tbl where b between 1015 and 1018 order by c desc nulls first, b;
+reset enable_indexskipscan;
+reset enable_bitmapscan;
+drop table btree_skip_tbl;
@@ -414,6 +414,63 @@ test1
 SELECT * FROM instead_of_insert_tbl;
 COMMIT;
 
+-- Test parallel COPY FROM.  The workers may or may not be launched, and
+-- rows may be inserted in any order, so sort them.
+CREATE TABLE parallel_copy_tbl (a int, b text, c text DEFAULT 'dflt');
+COPY parallel_copy_tbl (a, b) FROM stdin (PARALLEL 2);
+1	one
+2	two
+3	\N
+\.
+COPY parallel_copy_tbl FROM stdin (FORMAT csv, HEADER, PARALLEL 2);
+a,b,c
+4,four,x
+5,"fi,ve",
+\.
+SELECT * FROM parallel_copy_tbl ORDER BY a;
+COPY parallel_copy_tbl TO stdout (PARALLEL 2);
+COPY parallel_copy_tbl FROM stdin (FORMAT binary, PARALLEL 2);
+COPY parallel_copy_tbl FROM stdin (PARALLEL -1);
+DROP TABLE parallel_copy_tbl;
+
+-- Long fields, so that the block scanning in the parser kicks in, with
+-- special characters at various offsets
+CREATE TABLE copy_long_tbl (a text, b text);
+COPY copy_long_tbl FROM stdin;
+abcdefghijklmnopqrstuvwxyz0123456789	abcdefghijklmnop\tqrstuvwxyz
+0123456789abcdef\\0123456789abcdef	\N
+\.
+COPY copy_long_tbl FROM stdin (FORMAT csv);
+"abcdefghijklmnopqrstuvwxyz,""0123456789""",abcdefghijklmnopqrstuvwxyz
+"0123456789abcdef
+0123456789abcdef",
+\.
+SELECT translate(a, E'\n', '~') AS a, translate(b, E'\t', '~') AS b
+  FROM copy_long_tbl ORDER BY translate(a, E'\n', '~') COLLATE "C";
+DROP TABLE copy_long_tbl;
+
+-- Input interleaving the partitions of a partitioned table, which are
+-- multi-inserted into through a buffer each.  The partitions' rowtypes differ
+-- from the parent's, and their indexes are updated from the buffers.
+CREATE TABLE parted_copytest (a int, b int, c text) PARTITION BY LIST (b);
+CREATE TABLE parted_copytest_a1 (c text, b int, a int);
+CREATE TABLE parted_copytest_a2 (a int, c text, b int);
+ALTER TABLE parted_copytest ATTACH PARTITION parted_copytest_a1 FOR VALUES IN (1);
+ALTER TABLE parted_copytest ATTACH PARTITION parted_copytest_a2 FOR VALUES IN (2);
+CREATE INDEX ON parted_copytest (a);
+COPY parted_copytest FROM stdin;
+1	1	one
+2	2	two
+3	1	three
+4	2	four
+5	1	five
+\.
+SELECT tableoid::regclass, a, b, c FROM parted_copytest ORDER BY a;
+SET enable_seqscan = off;
+SELECT a, c FROM parted_copytest_a2 WHERE a = 4;
+RESET enable_seqscan;
+DROP TABLE parted_copytest;
+
 -- clean up
 DROP TABLE forcetest;
 DROP TABLE vistest;
@@ -66,3 +66,49 @@ DROP ACCESS METHOD gist2;
 
 -- Drop access method cascade
 DROP ACCESS METHOD gist2 CASCADE;
+
+--
+-- Test table access methods
+--
+CREATE ACCESS METHOD heap2 TYPE TABLE HANDLER heap_tableam_handler;
+
+-- wrong handler type
+CREATE ACCESS METHOD bogus TYPE TABLE HANDLER bthandler;
+
+-- create a table using the new AM and check that it works
+CREATE TABLE tableam_tbl_heap2(f1 int) USING heap2;
+INSERT INTO tableam_tbl_heap2 VALUES(1);
+SELECT f1 FROM tableam_tbl_heap2 ORDER BY f1;
+
+-- CREATE TABLE AS and materialized views, with and without USING
+CREATE TABLE tableam_tblas_heap2 USING heap2 AS SELECT * FROM tableam_tbl_heap2;
+SELECT f1 FROM tableam_tblas_heap2 ORDER BY f1;
+CREATE MATERIALIZED VIEW tableam_tblmv_heap2 USING heap2 AS SELECT * FROM tableam_tbl_heap2;
+SELECT f1 FROM tableam_tblmv_heap2 ORDER BY f1;
+
+-- the default table access method is used when USING is omitted
+SET default_table_access_method = 'heap2';
+CREATE TABLE tableam_tbl_default(f1 int);
+RESET default_table_access_method;
+
+SELECT pc.relname, pa.amname
+FROM pg_class AS pc JOIN pg_am AS pa ON (pa.oid = pc.relam)
+WHERE pc.relname LIKE 'tableam_%'
+ORDER BY 1;
+
+-- USING with an index AM or on a partitioned table is rejected
+CREATE TABLE tableam_tbl_btree(f1 int) USING btree;
+CREATE TABLE tableam_parted_heap2 (a text, b int) PARTITION BY list (a) USING heap2;
+
+-- nonexistent default is rejected
+SET default_table_access_method = 'I do not exist AM';
+SET default_table_access_method = '';
+
+DROP TABLE tableam_tblas_heap2, tableam_tbl_default;
+DROP MATERIALIZED VIEW tableam_tblmv_heap2;
+
+-- can't drop the AM while a table uses it
+DROP ACCESS METHOD heap2;
+
+DROP TABLE tableam_tbl_heap2;
+DROP ACCESS METHOD heap2;
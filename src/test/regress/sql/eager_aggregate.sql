@@ -0,0 +1,120 @@
+--
+-- EAGER_AGGREGATE
+-- Test partial aggregation pushed below joins
+--
+
+-- Enable eager aggregation, which by default is disabled.
+SET enable_eager_aggregate TO true;
+-- Disable parallel plans.
+SET max_parallel_workers_per_gather TO 0;
+
+CREATE TABLE eager_agg_t1 (a int, b int, c int);
+CREATE TABLE eager_agg_t2 (a int, b int, c int);
+CREATE TABLE eager_agg_t3 (a int, b int, c int);
+INSERT INTO eager_agg_t1 SELECT i % 100, i, nullif(i % 7, 0) FROM generate_series(1, 10000) i;
+INSERT INTO eager_agg_t2 SELECT i, i % 10, i FROM generate_series(0, 99) i;
+-- some values of the join key appear more than once
+INSERT INTO eager_agg_t2 SELECT i, i % 10, -i FROM generate_series(0, 99, 7) i;
+INSERT INTO eager_agg_t3 SELECT i % 10, i, i FROM generate_series(1, 1000) i;
+ANALYZE eager_agg_t1, eager_agg_t2, eager_agg_t3;
+
+-- Partial aggregation of t1 by its join column, finalized after the join.
+-- Each partial group is joined to all the duplicates of its key.
+EXPLAIN (COSTS OFF)
+SELECT t2.b, sum(t1.c), count(t1.c), count(*), min(t1.b), max(t1.b)
+  FROM eager_agg_t1 t1 JOIN eager_agg_t2 t2 ON t1.a = t2.a
+  GROUP BY t2.b ORDER BY t2.b;
+SELECT t2.b, sum(t1.c), count(t1.c), count(*), min(t1.b), max(t1.b)
+  FROM eager_agg_t1 t1 JOIN eager_agg_t2 t2 ON t1.a = t2.a
+  GROUP BY t2.b ORDER BY t2.b;
+SET enable_eager_aggregate TO false;
+SELECT t2.b, sum(t1.c), count(t1.c), count(*), min(t1.b), max(t1.b)
+  FROM eager_agg_t1 t1 JOIN eager_agg_t2 t2 ON t1.a = t2.a
+  GROUP BY t2.b ORDER BY t2.b;
+SET enable_eager_aggregate TO true;
+
+-- Grouping by a column of the aggregated relation, with HAVING
+EXPLAIN (COSTS OFF)
+SELECT t1.a, sum(t1.b), count(*)
+  FROM eager_agg_t1 t1 JOIN eager_agg_t2 t2 ON t1.a = t2.a
+  GROUP BY t1.a HAVING count(*) > 100 ORDER BY t1.a;
+SELECT t1.a, sum(t1.b), count(*)
+  FROM eager_agg_t1 t1 JOIN eager_agg_t2 t2 ON t1.a = t2.a
+  GROUP BY t1.a HAVING count(*) > 100 ORDER BY t1.a;
+SET enable_eager_aggregate TO false;
+SELECT t1.a, sum(t1.b), count(*)
+  FROM eager_agg_t1 t1 JOIN eager_agg_t2 t2 ON t1.a = t2.a
+  GROUP BY t1.a HAVING count(*) > 100 ORDER BY t1.a;
+SET enable_eager_aggregate TO true;
+
+-- Three-way join
+EXPLAIN (COSTS OFF)
+SELECT t3.a, sum(t1.c), count(*)
+  FROM eager_agg_t1 t1
+  JOIN eager_agg_t2 t2 ON t1.a = t2.a
+  JOIN eager_agg_t3 t3 ON t2.b = t3.a
+  GROUP BY t3.a ORDER BY t3.a;
+SELECT t3.a, sum(t1.c), count(*)
+  FROM eager_agg_t1 t1
+  JOIN eager_agg_t2 t2 ON t1.a = t2.a
+  JOIN eager_agg_t3 t3 ON t2.b = t3.a
+  GROUP BY t3.a ORDER BY t3.a;
+SET enable_eager_aggregate TO false;
+SELECT t3.a, sum(t1.c), count(*)
+  FROM eager_agg_t1 t1
+  JOIN eager_agg_t2 t2 ON t1.a = t2.a
+  JOIN eager_agg_t3 t3 ON t2.b = t3.a
+  GROUP BY t3.a ORDER BY t3.a;
+SET enable_eager_aggregate TO true;
+
+-- A non-strict aggregate sees the NULLs of the aggregated relation only
+CREATE FUNCTION eager_agg_nullcount_sfunc(int8, int) RETURNS int8
+  LANGUAGE sql IMMUTABLE AS 'SELECT $1 + CASE WHEN $2 IS NULL THEN 1 ELSE 0 END';
+CREATE AGGREGATE eager_agg_nullcount(int) (
+  sfunc = eager_agg_nullcount_sfunc, stype = int8, initcond = '0',
+  combinefunc = int8pl);
+EXPLAIN (COSTS OFF)
+SELECT t2.b, eager_agg_nullcount(t1.c)
+  FROM eager_agg_t1 t1 JOIN eager_agg_t2 t2 ON t1.a = t2.a
+  GROUP BY t2.b ORDER BY t2.b;
+SELECT t2.b, eager_agg_nullcount(t1.c)
+  FROM eager_agg_t1 t1 JOIN eager_agg_t2 t2 ON t1.a = t2.a
+  GROUP BY t2.b ORDER BY t2.b;
+SET enable_eager_aggregate TO false;
+SELECT t2.b, eager_agg_nullcount(t1.c)
+  FROM eager_agg_t1 t1 JOIN eager_agg_t2 t2 ON t1.a = t2.a
+  GROUP BY t2.b ORDER BY t2.b;
+SET enable_eager_aggregate TO true;
+
+-- Outer joins are not handled: NULL-extended rows would need to be
+-- aggregated as well
+EXPLAIN (COSTS OFF)
+SELECT t2.b, sum(t1.c), eager_agg_nullcount(t1.c)
+  FROM eager_agg_t2 t2 LEFT JOIN eager_agg_t1 t1 ON t1.a = t2.a
+  GROUP BY t2.b ORDER BY t2.b;
+EXPLAIN (COSTS OFF)
+SELECT t2.b, sum(t1.c)
+  FROM eager_agg_t1 t1 FULL JOIN eager_agg_t2 t2 ON t1.a = t2.a
+  GROUP BY t2.b ORDER BY t2.b;
+
+-- Aggregates using columns of more than one relation are not handled
+EXPLAIN (COSTS OFF)
+SELECT t2.b, sum(t1.c + t2.c)
+  FROM eager_agg_t1 t1 JOIN eager_agg_t2 t2 ON t1.a = t2.a
+  GROUP BY t2.b ORDER BY t2.b;
+
+-- Nor is partial aggregation that would hardly reduce the number of rows
+EXPLAIN (COSTS OFF)
+SELECT t2.b, sum(t1.c)
+  FROM eager_agg_t1 t1 JOIN eager_agg_t2 t2 ON t1.b = t2.a
+  GROUP BY t2.b ORDER BY t2.b;
+
+-- Nor a join clause that is not an equijoin
+EXPLAIN (COSTS OFF)
+SELECT t2.b, sum(t1.c)
+  FROM eager_agg_t1 t1 JOIN eager_agg_t2 t2 ON t1.a < t2.a
+  GROUP BY t2.b ORDER BY t2.b;
+
+DROP AGGREGATE eager_agg_nullcount(int);
+DROP FUNCTION eager_agg_nullcount_sfunc(int8, int);
+DROP TABLE eager_agg_t1, eager_agg_t2, eager_agg_t3;
@@ -1289,3 +1289,81 @@ ALTER TABLE fk_partitioned_fk ATTACH PARTITION fk_partitioned_fk_2
   FOR VALUES IN (1600);
 
 -- leave these tables around intentionally
+
+--
+-- FK checks that look up the referenced key in the PK index directly
+--
+
+-- multi-column keys, with the columns in another order than in the index
+CREATE TABLE fkpk_multi (a int, b text, c int, PRIMARY KEY (a, b));
+INSERT INTO fkpk_multi SELECT g, 'k' || g, g FROM generate_series(1, 10) g;
+CREATE TABLE fkfk_multi (x text, y int,
+  FOREIGN KEY (x, y) REFERENCES fkpk_multi (b, a));
+INSERT INTO fkfk_multi VALUES ('k1', 1), ('k10', 10), (NULL, 3), ('nope', NULL);
+INSERT INTO fkfk_multi VALUES ('k1', 2);
+INSERT INTO fkfk_multi VALUES ('k2', 1);
+ALTER TABLE fkfk_multi ADD FOREIGN KEY (y, x) REFERENCES fkpk_multi MATCH FULL;
+DELETE FROM fkfk_multi WHERE x IS NULL OR y IS NULL;
+ALTER TABLE fkfk_multi ADD FOREIGN KEY (y, x) REFERENCES fkpk_multi MATCH FULL;
+INSERT INTO fkfk_multi VALUES ('k3', NULL);
+INSERT INTO fkfk_multi VALUES ('k3', 3);
+UPDATE fkfk_multi SET y = 4 WHERE x = 'k3';
+SELECT * FROM fkfk_multi ORDER BY y;
+-- changes of our own transaction are taken into account
+BEGIN;
+INSERT INTO fkpk_multi VALUES (11, 'k11', 11);
+INSERT INTO fkfk_multi VALUES ('k11', 11);
+UPDATE fkpk_multi SET b = 'k6 new' WHERE a = 6;
+INSERT INTO fkfk_multi VALUES ('k6', 6);
+ROLLBACK;
+BEGIN;
+DELETE FROM fkpk_multi WHERE a = 7;
+INSERT INTO fkfk_multi VALUES ('k7', 7);
+ROLLBACK;
+DROP TABLE fkfk_multi, fkpk_multi;
+
+-- cross-type keys
+CREATE TABLE fkpk_int4 (a int4 PRIMARY KEY);
+INSERT INTO fkpk_int4 SELECT generate_series(1, 10);
+CREATE TABLE fkfk_int2 (a int2 REFERENCES fkpk_int4);
+CREATE TABLE fkfk_int8 (a int8 REFERENCES fkpk_int4);
+INSERT INTO fkfk_int2 VALUES (1), (10);
+INSERT INTO fkfk_int2 VALUES (11);
+INSERT INTO fkfk_int8 VALUES (2), (9);
+INSERT INTO fkfk_int8 VALUES (4294967298);
+INSERT INTO fkfk_int8 VALUES (-1);
+DELETE FROM fkpk_int4 WHERE a = 9;
+DROP TABLE fkfk_int2, fkfk_int8, fkpk_int4;
+CREATE TABLE fkpk_text (a text PRIMARY KEY);
+INSERT INTO fkpk_text VALUES ('one'), ('two');
+CREATE TABLE fkfk_varchar (a varchar(10) REFERENCES fkpk_text);
+INSERT INTO fkfk_varchar VALUES ('one');
+INSERT INTO fkfk_varchar VALUES ('three');
+DROP TABLE fkfk_varchar, fkpk_text;
+-- an FK column type that has to be cast is checked with a query instead
+CREATE TABLE fkpk_numeric (a numeric PRIMARY KEY);
+INSERT INTO fkpk_numeric VALUES (1), (2.5);
+CREATE TABLE fkfk_int4 (a int4 REFERENCES fkpk_numeric);
+INSERT INTO fkfk_int4 VALUES (1);
+INSERT INTO fkfk_int4 VALUES (2);
+DROP TABLE fkfk_int4, fkpk_numeric;
+
+-- a partitioned FK table; only plain tables can be referenced
+CREATE TABLE fkpk_plain (a int, b int, PRIMARY KEY (a, b));
+INSERT INTO fkpk_plain SELECT g, g % 3 FROM generate_series(1, 30) g;
+CREATE TABLE fkfk_parted (a int, b int, FOREIGN KEY (a, b) REFERENCES fkpk_plain)
+  PARTITION BY LIST (b);
+CREATE TABLE fkfk_parted0 PARTITION OF fkfk_parted FOR VALUES IN (0);
+CREATE TABLE fkfk_parted1 (b int, a int);
+ALTER TABLE fkfk_parted ATTACH PARTITION fkfk_parted1 FOR VALUES IN (1, 2);
+INSERT INTO fkfk_parted SELECT g, g % 3 FROM generate_series(1, 30) g;
+INSERT INTO fkfk_parted VALUES (3, 1);
+INSERT INTO fkfk_parted VALUES (4, 2);
+UPDATE fkfk_parted SET b = 0 WHERE a = 5;
+UPDATE fkfk_parted SET a = a + 3 WHERE a < 27;
+SELECT tableoid::regclass, count(*) FROM fkfk_parted GROUP BY 1 ORDER BY 1;
+DELETE FROM fkpk_plain WHERE a = 30;
+DROP TABLE fkfk_parted, fkpk_plain;
+CREATE TABLE fkpk_parted (a int PRIMARY KEY) PARTITION BY RANGE (a);
+CREATE TABLE fkfk_plain (a int REFERENCES fkpk_parted);
+DROP TABLE fkpk_parted;
@@ -34,3 +34,87 @@ insert into gin_test_tbl select array[1, 3, g] from generate_series(1, 1000) g;
 
 delete from gin_test_tbl where i @> array[2];
 vacuum gin_test_tbl;
+
+-- Test parallel index builds.  Index scans of the result have to agree with
+-- a sequential scan, and with an index built serially.
+create table gin_par_tbl (id int, arr int4[], j jsonb)
+  with (autovacuum_enabled = off);
+insert into gin_par_tbl
+  select g,
+         case g % 50 when 0 then null when 1 then '{}'
+           else array[g % 100, g % 7, g / 1000] end,
+         jsonb_build_object('a', g % 100, 'b', array[g % 3, g % 11])
+  from generate_series(1, 30000) g;
+
+create function gin_par_results() returns table (q text, n bigint)
+language sql as $$
+  select 'arr @> ' || k, count(*) from generate_series(0, 100) k, gin_par_tbl
+    where arr @> array[k] group by k
+  union all
+  select 'arr && ' || k, count(*) from generate_series(0, 30) k, gin_par_tbl
+    where arr && array[k, k + 40] group by k
+  union all
+  select 'arr <@', count(*) from gin_par_tbl where arr <@ array[1, 2, 3]
+  union all
+  select 'j @> a ' || k, count(*) from generate_series(0, 100) k, gin_par_tbl
+    where j @> jsonb_build_object('a', k) group by k
+  union all
+  select 'j @> b ' || k, count(*) from generate_series(0, 10) k, gin_par_tbl
+    where j @> jsonb_build_object('b', array[k]) group by k
+$$;
+
+set enable_indexscan = off;
+set enable_bitmapscan = off;
+create temp table gin_par_seq as select * from gin_par_results();
+reset enable_indexscan;
+reset enable_bitmapscan;
+
+set max_parallel_maintenance_workers = 2;
+set min_parallel_table_scan_size = 0;
+set maintenance_work_mem = '128MB';
+-- worker spill file sizes vary from run to run
+set log_temp_files = -1;
+set client_min_messages = debug1;
+create index gin_par_arr_idx on gin_par_tbl using gin (arr);
+create index gin_par_j_idx on gin_par_tbl using gin (j jsonb_path_ops);
+reset client_min_messages;
+
+set enable_seqscan = off;
+explain (costs off)
+select count(*) from gin_par_tbl where arr @> array[5];
+explain (costs off)
+select count(*) from gin_par_tbl where j @> '{"a": 5}';
+(select * from gin_par_seq except all select * from gin_par_results())
+union all
+(select * from gin_par_results() except all select * from gin_par_seq);
+reset enable_seqscan;
+
+-- the default maintenance_work_mem leaves room for just one worker
+reset maintenance_work_mem;
+set client_min_messages = debug1;
+reindex index gin_par_arr_idx;
+reindex index gin_par_j_idx;
+reset client_min_messages;
+set enable_seqscan = off;
+(select * from gin_par_seq except all select * from gin_par_results())
+union all
+(select * from gin_par_results() except all select * from gin_par_seq);
+reset enable_seqscan;
+
+-- the same with serially built indexes
+set max_parallel_maintenance_workers = 0;
+set client_min_messages = debug1;
+reindex index gin_par_arr_idx;
+reindex index gin_par_j_idx;
+reset client_min_messages;
+set enable_seqscan = off;
+(select * from gin_par_seq except all select * from gin_par_results())
+union all
+(select * from gin_par_results() except all select * from gin_par_seq);
+reset enable_seqscan;
+
+reset max_parallel_maintenance_workers;
+reset min_parallel_table_scan_size;
+reset log_temp_files;
+drop function gin_par_results();
+drop table gin_par_tbl;
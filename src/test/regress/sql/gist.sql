@@ -39,6 +39,19 @@ vacuum analyze gist_point_tbl;
 alter index gist_pointidx SET (fillfactor = 40);
 reindex index gist_pointidx;
 
+-- point_ops has a sortsupport function, so the reindex built the index by
+-- sorting.  Check that it finds what a buffering build finds.
+set enable_seqscan=off;
+set enable_bitmapscan=off;
+select count(*) from gist_point_tbl where p <@ box(point(0,0), point(50000, 50000));
+select count(*) from gist_point_tbl where p <@ box(point(0,0), point(200000, 200000));
+alter index gist_pointidx SET (buffering = on);
+reindex index gist_pointidx;
+select count(*) from gist_point_tbl where p <@ box(point(0,0), point(50000, 50000));
+select count(*) from gist_point_tbl where p <@ box(point(0,0), point(200000, 200000));
+reset enable_seqscan;
+reset enable_bitmapscan;
+
 --
 -- Test Index-only plans on GiST indexes
 --
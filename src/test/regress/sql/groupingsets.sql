@@ -415,4 +415,72 @@ explain (costs off)
          count(*)
     from tenk1 group by grouping sets (unique1,twothousand,thousand,hundred,ten,four,two);
 
+-- hashed grouping sets spill to disk when the hash tables exceed work_mem;
+-- xid columns can only be hashed, so the planner can't avoid that
+reset work_mem;
+create table gs_spill as
+  select g % 1000 as a, (g % 2000)::text::xid as x, (g % 700)::text::xid as y,
+         g % 3 as c, g as v
+    from generate_series(1, 30000) g;
+analyze gs_spill;
+create temp table gs_spill_res as
+  select x, y, c, sum(v), count(*) from gs_spill
+    group by grouping sets ((x), (y), (x, c), ());
+create temp table gs_spill_mixed_res as
+  select a, x, sum(v), count(*) from gs_spill
+    group by grouping sets ((a), (x), ());
+set work_mem = '64kB';
+explain (costs off)
+  select x, y, c, sum(v), count(*) from gs_spill
+    group by grouping sets ((x), (y), (x, c), ());
+select count(*) from gs_spill_res;
+(select x, y, c, sum(v), count(*) from gs_spill
+   group by grouping sets ((x), (y), (x, c), ())
+ except all
+ select * from gs_spill_res)
+union all
+(select * from gs_spill_res
+ except all
+ select x, y, c, sum(v), count(*) from gs_spill
+   group by grouping sets ((x), (y), (x, c), ()));
+-- the same with sorted grouping sets in the same node
+explain (costs off)
+  select a, x, sum(v), count(*) from gs_spill
+    group by grouping sets ((a), (x), ());
+select count(*) from gs_spill_mixed_res;
+(select a, x, sum(v), count(*) from gs_spill
+   group by grouping sets ((a), (x), ())
+ except all
+ select * from gs_spill_mixed_res)
+union all
+(select * from gs_spill_mixed_res
+ except all
+ select a, x, sum(v), count(*) from gs_spill
+   group by grouping sets ((a), (x), ()));
+reset work_mem;
+drop table gs_spill_res, gs_spill_mixed_res;
+
+-- parallel grouping sets: workers aggregate by all the grouping columns, and
+-- the leader builds the grouping sets from the partial groups
+begin;
+set local parallel_setup_cost = 0;
+set local parallel_tuple_cost = 0;
+set local min_parallel_table_scan_size = 0;
+set local max_parallel_workers_per_gather = 2;
+explain (costs off)
+  select c, a % 5 as a5, sum(v), count(*), grouping(c, a % 5)
+    from gs_spill group by grouping sets ((c), (a % 5), ()) order by 1, 2;
+select c, a % 5 as a5, sum(v), count(*), grouping(c, a % 5)
+  from gs_spill group by grouping sets ((c), (a % 5), ()) order by 1, 2;
+explain (costs off)
+  select c, a % 5 as a5, min(v), max(v), avg(v)
+    from gs_spill group by rollup (c, a % 5) order by 1, 2;
+select c, a % 5 as a5, min(v), max(v), avg(v)
+  from gs_spill group by rollup (c, a % 5) order by 1, 2;
+set local max_parallel_workers_per_gather = 0;
+select c, a % 5 as a5, min(v), max(v), avg(v)
+  from gs_spill group by rollup (c, a % 5) order by 1, 2;
+rollback;
+drop table gs_spill;
+
 -- end
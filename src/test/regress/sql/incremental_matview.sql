@@ -0,0 +1,132 @@
+--
+-- Incrementally maintained materialized views
+--
+
+-- Refresh an ordinary materialized view over the same query and return the
+-- rows that the two do not have in common
+CREATE FUNCTION imv_diff(imv regclass, mv regclass)
+RETURNS SETOF text LANGUAGE plpgsql AS
+$$
+BEGIN
+  EXECUTE format('REFRESH MATERIALIZED VIEW %s', mv);
+  RETURN QUERY EXECUTE format(
+    '(SELECT ''missing: '' || t::text FROM (TABLE %2$s EXCEPT ALL TABLE %1$s) t)
+     UNION ALL
+     (SELECT ''extra: '' || t::text FROM (TABLE %1$s EXCEPT ALL TABLE %2$s) t)',
+    imv, mv);
+END;
+$$;
+
+CREATE TABLE imv_base (a int, b text);
+INSERT INTO imv_base SELECT g % 20, 'b' || (g % 7) FROM generate_series(1, 100) g;
+CREATE MATERIALIZED VIEW imv_simple WITH (incremental_maintenance) AS
+  SELECT a, b, a * 2 AS c FROM imv_base WHERE a > 3;
+CREATE MATERIALIZED VIEW imv_simple_ref AS
+  SELECT a, b, a * 2 AS c FROM imv_base WHERE a > 3;
+SELECT * FROM imv_diff('imv_simple', 'imv_simple_ref');
+SELECT count(*) FROM imv_simple;
+
+INSERT INTO imv_base SELECT g, 'new' FROM generate_series(1, 30) g;
+SELECT * FROM imv_diff('imv_simple', 'imv_simple_ref');
+UPDATE imv_base SET a = a + 2 WHERE b = 'b3';
+SELECT * FROM imv_diff('imv_simple', 'imv_simple_ref');
+UPDATE imv_base SET b = 'upd' WHERE a BETWEEN 2 AND 6;
+SELECT * FROM imv_diff('imv_simple', 'imv_simple_ref');
+DELETE FROM imv_base WHERE b = 'new' AND a % 3 = 0;
+SELECT * FROM imv_diff('imv_simple', 'imv_simple_ref');
+SELECT count(*) FROM imv_simple;
+
+-- deleting some of several duplicate rows removes only that many copies
+TRUNCATE imv_base;
+INSERT INTO imv_base VALUES (10, 'dup'), (10, 'dup'), (10, 'dup'), (11, 'dup');
+SELECT a, b, count(*) FROM imv_simple GROUP BY a, b ORDER BY a;
+DELETE FROM imv_base WHERE ctid = (SELECT min(ctid) FROM imv_base WHERE a = 10);
+SELECT a, b, count(*) FROM imv_simple GROUP BY a, b ORDER BY a;
+SELECT * FROM imv_diff('imv_simple', 'imv_simple_ref');
+-- and so does an update of one of them
+UPDATE imv_base SET a = 12 WHERE ctid = (SELECT max(ctid) FROM imv_base WHERE a = 10);
+SELECT a, b, count(*) FROM imv_simple GROUP BY a, b ORDER BY a;
+SELECT * FROM imv_diff('imv_simple', 'imv_simple_ref');
+
+-- TRUNCATE empties the view
+TRUNCATE imv_base;
+SELECT count(*) FROM imv_simple;
+INSERT INTO imv_base VALUES (5, 'x');
+SELECT * FROM imv_simple;
+
+-- changes of a rolled back transaction or subtransaction go away
+BEGIN;
+INSERT INTO imv_base VALUES (6, 'y');
+SAVEPOINT s1;
+DELETE FROM imv_base;
+SELECT count(*) FROM imv_simple;
+ROLLBACK TO s1;
+SELECT * FROM imv_simple ORDER BY a;
+ROLLBACK;
+SELECT * FROM imv_simple ORDER BY a;
+
+-- join views
+CREATE TABLE imv_dim (id int PRIMARY KEY, name text);
+INSERT INTO imv_dim SELECT g, 'name' || g FROM generate_series(0, 25) g;
+TRUNCATE imv_base;
+INSERT INTO imv_base SELECT g % 30, 'b' || (g % 4) FROM generate_series(1, 200) g;
+CREATE MATERIALIZED VIEW imv_join WITH (incremental_maintenance) AS
+  SELECT x.a, x.b, d.name FROM imv_base x JOIN imv_dim d ON x.a = d.id;
+CREATE MATERIALIZED VIEW imv_join_ref AS
+  SELECT x.a, x.b, d.name FROM imv_base x JOIN imv_dim d ON x.a = d.id;
+SELECT count(*) FROM imv_join;
+INSERT INTO imv_base VALUES (1, 'new'), (29, 'new'), (100, 'new');
+SELECT * FROM imv_diff('imv_join', 'imv_join_ref');
+INSERT INTO imv_dim VALUES (29, 'name29'), (100, 'name100');
+SELECT * FROM imv_diff('imv_join', 'imv_join_ref');
+UPDATE imv_dim SET name = upper(name) WHERE id % 5 = 0;
+SELECT * FROM imv_diff('imv_join', 'imv_join_ref');
+UPDATE imv_dim SET id = id + 1000 WHERE id BETWEEN 3 AND 5;
+SELECT * FROM imv_diff('imv_join', 'imv_join_ref');
+DELETE FROM imv_dim WHERE id % 2 = 1;
+SELECT * FROM imv_diff('imv_join', 'imv_join_ref');
+DELETE FROM imv_base WHERE b = 'b1';
+SELECT * FROM imv_diff('imv_join', 'imv_join_ref');
+UPDATE imv_base SET a = a + 1;
+SELECT * FROM imv_diff('imv_join', 'imv_join_ref');
+TRUNCATE imv_dim;
+SELECT count(*) FROM imv_join;
+-- the view over the other table is kept up to date as well
+SELECT * FROM imv_diff('imv_simple', 'imv_simple_ref');
+
+-- a statement modifying two tables of a join view is refused
+INSERT INTO imv_dim VALUES (1, 'one');
+WITH d AS (INSERT INTO imv_dim VALUES (2, 'two'))
+  INSERT INTO imv_base VALUES (2, 'cte');
+SELECT * FROM imv_diff('imv_join', 'imv_join_ref');
+
+-- so is maintenance of a join view outside READ COMMITTED
+BEGIN ISOLATION LEVEL REPEATABLE READ;
+INSERT INTO imv_base VALUES (1, 'rr');
+ROLLBACK;
+BEGIN ISOLATION LEVEL SERIALIZABLE;
+INSERT INTO imv_dim VALUES (3, 'three');
+ROLLBACK;
+SELECT * FROM imv_diff('imv_join', 'imv_join_ref');
+
+-- queries that cannot be maintained incrementally
+CREATE MATERIALIZED VIEW imv_bad WITH (incremental_maintenance) AS
+  SELECT a, count(*) FROM imv_base GROUP BY a;
+CREATE MATERIALIZED VIEW imv_bad WITH (incremental_maintenance) AS
+  SELECT DISTINCT a FROM imv_base;
+CREATE MATERIALIZED VIEW imv_bad WITH (incremental_maintenance) AS
+  SELECT x.a FROM imv_base x LEFT JOIN imv_dim d ON x.a = d.id;
+CREATE MATERIALIZED VIEW imv_bad WITH (incremental_maintenance) AS
+  SELECT x.a FROM imv_base x JOIN imv_base y ON x.a = y.a;
+CREATE MATERIALIZED VIEW imv_bad WITH (incremental_maintenance) AS
+  SELECT a FROM imv_simple_ref;
+CREATE MATERIALIZED VIEW imv_bad WITH (incremental_maintenance) AS
+  SELECT ctid AS t, a FROM imv_base;
+CREATE MATERIALIZED VIEW imv_bad WITH (incremental_maintenance) AS
+  SELECT a FROM imv_base TABLESAMPLE system (50);
+ALTER MATERIALIZED VIEW imv_simple RESET (incremental_maintenance);
+ALTER MATERIALIZED VIEW imv_simple_ref SET (incremental_maintenance);
+
+DROP MATERIALIZED VIEW imv_simple, imv_simple_ref, imv_join, imv_join_ref;
+DROP TABLE imv_base, imv_dim;
+DROP FUNCTION imv_diff(regclass, regclass);
@@ -0,0 +1,91 @@
+--
+-- Incremental sort
+--
+
+-- The batch count is stable, but memory use is not; mask it.
+create function explain_incsort(query text) returns setof text
+language plpgsql as
+$$
+declare
+    ln text;
+begin
+    for ln in
+        execute format('explain (analyze, costs off, summary off, timing off) %s',
+            query)
+    loop
+        ln := regexp_replace(ln, 'Memory: \d+kB', 'Memory: NkB');
+        ln := regexp_replace(ln, 'Disk: \d+kB', 'Disk: NkB');
+        return next ln;
+    end loop;
+end;
+$$;
+
+-- Groups of mixed sizes on the leading column: one large group of a = 0,
+-- then groups of 1 to 9 tuples.  b has NULLs.
+create table incsort_tbl (a int, b int, c text);
+insert into incsort_tbl
+  select 0, case when i % 50 = 0 then null else (i * 37) % 1000 end, 'big'
+  from generate_series(1, 2000) i;
+insert into incsort_tbl
+  select g, case when i = 3 then null else (g * 7 + i * 13) % 10 end, 'small'
+  from generate_series(1, 500) g, generate_series(1, 1 + g % 9) i;
+create index incsort_tbl_a_idx on incsort_tbl (a);
+analyze incsort_tbl;
+
+set enable_seqscan = off;
+set enable_bitmapscan = off;
+
+-- The index provides (a); the sort only needs to order b within each group.
+explain (costs off)
+select a, b from incsort_tbl order by a, b limit 10;
+select a, b from incsort_tbl order by a, b limit 10;
+
+explain (costs off)
+select a, b from incsort_tbl order by a, b nulls first limit 10;
+select a, b from incsort_tbl order by a, b nulls first limit 10;
+
+-- Small groups are combined into batches
+explain (costs off)
+select a, b from incsort_tbl where a > 0 order by a, b desc limit 25;
+select a, b from incsort_tbl where a > 0 order by a, b desc limit 25;
+select explain_incsort('select a, b from incsort_tbl where a > 0 order by a, b limit 100');
+
+-- Each batch must be returned in full even when a group exceeds work_mem
+set work_mem = '64kB';
+select explain_incsort('select a, b, c from incsort_tbl where a < 3 order by a, b, c');
+select count(*),
+       count(*) filter (where (a, coalesce(b, 1000000)) <
+                              (pa, coalesce(pb, 1000000))) as out_of_order
+from (select a, b, lag(a) over () pa, lag(b) over () pb
+      from (select a, b from incsort_tbl order by a, b limit 5000) s) s2;
+reset work_mem;
+
+-- Results must match a full sort
+create temp table incsort_res as
+  select row_number() over () rn, a, b
+  from (select a, b from incsort_tbl order by a, b limit 3000) s;
+set enable_incremental_sort = off;
+explain (costs off)
+select a, b from incsort_tbl order by a, b limit 3000;
+select count(*)
+from incsort_res r
+  full join (select row_number() over () rn, a, b
+             from (select a, b from incsort_tbl order by a, b limit 3000) s) f
+  on r.rn = f.rn and r.a = f.a and r.b is not distinct from f.b
+where r.rn is null or f.rn is null;
+reset enable_incremental_sort;
+
+-- Rescan with a changing bound on the presorted key
+explain (costs off)
+select v.x, s.a, s.b
+from (values (1), (200), (499)) v(x),
+  lateral (select a, b from incsort_tbl where a >= v.x order by a, b limit 4) s;
+select v.x, s.a, s.b
+from (values (1), (200), (499)) v(x),
+  lateral (select a, b from incsort_tbl where a >= v.x order by a, b limit 4) s;
+
+reset enable_seqscan;
+reset enable_bitmapscan;
+
+drop table incsort_tbl;
+drop function explain_incsort(text);
@@ -569,3 +569,93 @@ alter table returningwrtest2 drop c;
 alter table returningwrtest attach partition returningwrtest2 for values in (2);
 insert into returningwrtest values (2, 'foo') returning returningwrtest;
 drop table returningwrtest;
+
+--
+-- INSERT ... SELECT into a heap table queues up the rows and writes them out
+-- with heap_multi_insert, 1000 at a time
+--
+create table batchins (a int primary key, b text);
+create index batchins_lower_b on batchins (lower(b));
+begin;
+insert into batchins select g, 'Row' || g from generate_series(1, 2500) g;
+-- all the rows are visible to later commands of the same transaction
+select count(*), min(a), max(a) from batchins;
+commit;
+set enable_seqscan = off;
+explain (costs off) select a from batchins where lower(b) = 'row1234';
+select a from batchins where lower(b) = 'row1234';
+select count(*) from batchins where a > 0;
+reset enable_seqscan;
+-- a unique violation in the middle of a batch
+insert into batchins
+  select g, 'row' || g from generate_series(2501, 3000) g
+  union all select 2600, 'dup';
+select count(*), max(a) from batchins;
+-- a rolled back batch leaves nothing behind
+begin;
+insert into batchins select g, 'row' || g from generate_series(3001, 4000) g;
+rollback;
+select count(*), max(a) from batchins;
+drop table batchins;
+
+-- routed rows are queued up per partition
+create table batchins_parted (a int, b text) partition by hash (a);
+create table batchins_parted0 partition of batchins_parted
+  for values with (modulus 3, remainder 0);
+create table batchins_parted1 partition of batchins_parted
+  for values with (modulus 3, remainder 1);
+create table batchins_parted2 (b text, a int not null);
+alter table batchins_parted attach partition batchins_parted2
+  for values with (modulus 3, remainder 2);
+create unique index on batchins_parted (a);
+insert into batchins_parted select g, 'row' || g from generate_series(1, 3000) g;
+select tableoid::regclass, count(*), min(a), max(a), count(distinct b)
+  from batchins_parted group by 1 order by 1;
+set enable_seqscan = off;
+select tableoid::regclass, a, b from batchins_parted
+  where a between 1500 and 1505 order by a;
+reset enable_seqscan;
+insert into batchins_parted select g, 'dup' from generate_series(3001, 3010) g
+  union all select 3005, 'dup';
+select count(*) from batchins_parted;
+drop table batchins_parted;
+
+-- rows go in one at a time when something wants to see each of them
+create table batchins (a int, b int);
+create function batchins_count() returns trigger language plpgsql as
+$$
+begin
+  if tg_level = 'ROW' then
+    new.b := (select count(*) from batchins);
+    return new;
+  end if;
+  raise notice 'batchins_count: % new rows', (select count(*) from newtab);
+  return null;
+end;
+$$;
+create trigger batchins_before before insert on batchins
+  for each row execute function batchins_count();
+insert into batchins select g, 0 from generate_series(1, 1500) g;
+select count(*) from batchins where b = a - 1;
+drop trigger batchins_before on batchins;
+truncate batchins;
+create trigger batchins_transition after insert on batchins
+  referencing new table as newtab
+  for each statement execute function batchins_count();
+insert into batchins select g, 0 from generate_series(1, 1500) g;
+drop trigger batchins_transition on batchins;
+truncate batchins;
+alter table batchins add constraint batchins_a_key unique (a)
+  deferrable initially deferred;
+begin;
+insert into batchins select g % 1200, 0 from generate_series(1, 1500) g;
+update batchins set a = a + 2000 where ctid in
+  (select max(ctid) from batchins group by a having count(*) > 1);
+commit;
+select count(*), count(distinct a) from batchins;
+begin;
+insert into batchins select g, 0 from generate_series(1, 1500) g;
+commit;
+select count(*) from batchins;
+drop table batchins;
+drop function batchins_count();
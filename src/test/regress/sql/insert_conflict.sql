@@ -580,3 +580,36 @@ insert into parted_conflict values(0, 'cero', 1)
 
 drop table parted_conflict;
 drop function parted_conflict_update_func();
+
+-- INSERT ... ON CONFLICT with many rows probes the arbiter index for a
+-- batch of rows at a time; rows of one batch that conflict with each other
+-- must still behave as if they had been inserted one by one
+create table upsert_batch (k int unique, v text);
+insert into upsert_batch select g, 'old' from generate_series(1, 3000, 2) g;
+create function upsert_batch_count(query text) returns void language plpgsql as
+$$
+declare
+  n bigint;
+begin
+  execute query;
+  get diagnostics n = row_count;
+  raise notice 'row count %', n;
+end;
+$$;
+-- half of the rows conflict with existing ones, across several batches
+select upsert_batch_count($$insert into upsert_batch select g, 'new' from generate_series(1, 3000) g on conflict (k) do nothing$$);
+select v, count(*), min(k), max(k) from upsert_batch group by v order by v;
+select upsert_batch_count($$insert into upsert_batch select g, 'upd' from generate_series(2900, 3100) g on conflict (k) do update set v = excluded.v$$);
+select v, count(*), min(k), max(k) from upsert_batch group by v order by v;
+-- duplicate keys within one batch, both for existing and for new keys
+select upsert_batch_count($$insert into upsert_batch values (5, 'dup'), (5000, 'dup'), (5, 'dup'), (5000, 'dup') on conflict (k) do nothing$$);
+select * from upsert_batch where v = 'dup' order by k;
+insert into upsert_batch values (7, 'a'), (7, 'b') on conflict (k) do update set v = excluded.v;
+insert into upsert_batch values (6000, 'a'), (6000, 'b') on conflict (k) do update set v = excluded.v;
+select * from upsert_batch where k in (7, 6000);
+-- NULL keys never conflict
+select upsert_batch_count($$insert into upsert_batch values (null, 'n1'), (null, 'n2'), (1, 'n3') on conflict (k) do nothing$$);
+select upsert_batch_count($$insert into upsert_batch values (null, 'n4'), (null, 'n5') on conflict (k) do update set v = 'fails'$$);
+select * from upsert_batch where k is null or k = 1 order by v;
+drop function upsert_batch_count(text);
+drop table upsert_batch;
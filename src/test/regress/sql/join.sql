@@ -2492,3 +2492,16 @@ $$);
 rollback to settings;
 
 rollback;
+
+--
+-- check the greedy join search, including a clauseless join
+--
+begin;
+set local geqo = off;
+set local greedy_join_threshold = 2;
+select count(*) from tenk1 a
+  join tenk1 b on a.unique1 = b.unique2
+  join int4_tbl c on a.unique1 = c.f1
+  left join onek d on d.unique1 = b.unique1
+  cross join int8_tbl e;
+rollback;
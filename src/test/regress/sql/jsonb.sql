@@ -1164,3 +1164,21 @@ select '12345.0000000000000000000000000000000000000000000005'::jsonb::float8;
 select '12345.0000000000000000000000000000000000000000000005'::jsonb::int2;
 select '12345.0000000000000000000000000000000000000000000005'::jsonb::int4;
 select '12345.0000000000000000000000000000000000000000000005'::jsonb::int8;
+
+-- field access in large toasted documents, compressed or not
+create temp table jsonb_big (j jsonb);
+insert into jsonb_big
+  select jsonb_object_agg('k' || i, repeat('v', 10) || i)
+  from generate_series(1, 20000) i;
+alter table jsonb_big alter column j set storage external;
+insert into jsonb_big
+  select jsonb_object_agg('k' || i, repeat('v', 10) || i)
+  from generate_series(1, 20000) i;
+select j->>'k1' = 'vvvvvvvvvv1' as first,
+       j->>'k20000' = 'vvvvvvvvvv20000' as last,
+       j->'k12345' = '"vvvvvvvvvv12345"' as mid,
+       j ? 'k777' as has,
+       j ? 'nosuch' as hasnot,
+       j->'nosuch' is null as missing
+from jsonb_big;
+drop table jsonb_big;
@@ -432,3 +432,24 @@ ANALYZE prt2;
 
 EXPLAIN (COSTS OFF)
 SELECT t1.a, t1.c, t2.b, t2.c FROM prt1 t1, prt2 t2 WHERE t1.a = t2.b AND t1.b = 0 ORDER BY t1.a, t2.b;
+
+-- partitionwise join between tables whose partition bounds differ, where
+-- partitions exist on one side only
+CREATE TABLE prt5 (a int, b int) PARTITION BY RANGE (a);
+CREATE TABLE prt5_p1 PARTITION OF prt5 FOR VALUES FROM (0) TO (10);
+CREATE TABLE prt5_p2 PARTITION OF prt5 FOR VALUES FROM (10) TO (20);
+CREATE TABLE prt5_p3 PARTITION OF prt5 FOR VALUES FROM (20) TO (30);
+INSERT INTO prt5 SELECT i, i FROM generate_series(0, 29, 4) i;
+ANALYZE prt5;
+CREATE TABLE prt6 (a int, b int) PARTITION BY RANGE (a);
+CREATE TABLE prt6_p1 PARTITION OF prt6 FOR VALUES FROM (0) TO (10);
+CREATE TABLE prt6_p2 PARTITION OF prt6 FOR VALUES FROM (10) TO (20);
+INSERT INTO prt6 SELECT i, i FROM generate_series(0, 19, 3) i;
+ANALYZE prt6;
+
+SELECT t1.a, t2.a FROM prt5 t1 JOIN prt6 t2 ON t1.a = t2.a ORDER BY t1.a;
+SELECT t1.a, t2.a FROM prt6 t1 LEFT JOIN prt5 t2 ON t1.a = t2.a ORDER BY t1.a;
+SELECT t1.a, t2.a FROM prt5 t1 FULL JOIN prt6 t2 ON t1.a = t2.a ORDER BY t1.a, t2.a;
+
+DROP TABLE prt5;
+DROP TABLE prt6;
@@ -209,4 +209,12 @@ explain (costs off) execute test_mode_pp(2);
 set plan_cache_mode to force_custom_plan;
 explain (costs off) execute test_mode_pp(2);
 
+-- adaptive mode goes by measured run times, so the plans it picks are not
+-- predictable, but the results must be the same either way
+set plan_cache_mode to adaptive;
+execute test_mode_pp(2);
+execute test_mode_pp(1);
+execute test_mode_pp(2);
+reset plan_cache_mode;
+
 drop table test_mode;
@@ -2,12 +2,14 @@
 -- of the pg_prepared_statements view as prepared statements are
 -- created and removed.
 
-SELECT name, statement, parameter_types FROM pg_prepared_statements;
+SELECT name, statement, parameter_types FROM pg_prepared_statements
+    ORDER BY name;
 
 PREPARE q1 AS SELECT 1 AS a;
 EXECUTE q1;
 
-SELECT name, statement, parameter_types FROM pg_prepared_statements;
+SELECT name, statement, parameter_types FROM pg_prepared_statements
+    ORDER BY name;
 
 -- should fail
 PREPARE q1 AS SELECT 2;
@@ -18,16 +20,19 @@ PREPARE q1 AS SELECT 2;
 EXECUTE q1;
 
 PREPARE q2 AS SELECT 2 AS b;
-SELECT name, statement, parameter_types FROM pg_prepared_statements;
+SELECT name, statement, parameter_types FROM pg_prepared_statements
+    ORDER BY name;
 
 -- sql92 syntax
 DEALLOCATE PREPARE q1;
 
-SELECT name, statement, parameter_types FROM pg_prepared_statements;
+SELECT name, statement, parameter_types FROM pg_prepared_statements
+    ORDER BY name;
 
 DEALLOCATE PREPARE q2;
 -- the view should return the empty set again
-SELECT name, statement, parameter_types FROM pg_prepared_statements;
+SELECT name, statement, parameter_types FROM pg_prepared_statements
+    ORDER BY name;
 
 -- parameterized queries
 PREPARE q2(text) AS
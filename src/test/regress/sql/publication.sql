@@ -112,6 +112,64 @@ DROP PUBLICATION testpub2;
 SET ROLE regress_publication_user;
 REVOKE CREATE ON DATABASE regression FROM regress_publication_user2;
 
+-- column lists and row filters
+CREATE TABLE testpub_rf_tbl (a int PRIMARY KEY, b text, c int, d text);
+CREATE TYPE testpub_rf_type AS (x int);
+CREATE TABLE testpub_rf_udt (a int PRIMARY KEY, b testpub_rf_type);
+SET client_min_messages = 'ERROR';
+CREATE PUBLICATION testpub_rf_ins FOR TABLE testpub_rf_tbl (a, b, c)
+  WHERE (c > 10 AND b <> 'x') WITH (publish = 'insert');
+RESET client_min_messages;
+\dRp+ testpub_rf_ins
+SELECT prattrs, pg_get_expr(prqual, prrelid) FROM pg_publication_rel
+  WHERE prpubid = (SELECT oid FROM pg_publication WHERE pubname = 'testpub_rf_ins');
+-- SET TABLE replaces the column list and row filter
+ALTER PUBLICATION testpub_rf_ins SET TABLE testpub_rf_tbl WHERE (a % 2 = 0);
+\dRp+ testpub_rf_ins
+ALTER PUBLICATION testpub_rf_ins SET TABLE testpub_rf_tbl (d, a);
+\dRp+ testpub_rf_ins
+-- fail - a publication publishing UPDATE needs the replica identity columns
+ALTER PUBLICATION testpub_rf_ins SET (publish = 'insert, update');
+ALTER PUBLICATION testpub_rf_ins SET TABLE testpub_rf_tbl (b, c);
+ALTER PUBLICATION testpub_rf_ins SET TABLE testpub_rf_tbl WHERE (c > 10);
+ALTER PUBLICATION testpub_rf_ins SET (publish = 'insert, update');
+-- ok - only replica identity columns in the filter
+ALTER PUBLICATION testpub_rf_ins SET TABLE testpub_rf_tbl (a, b) WHERE (a < 100);
+ALTER PUBLICATION testpub_rf_ins SET (publish = 'insert, update, delete');
+-- fail - the filter can no longer reference other columns
+ALTER PUBLICATION testpub_rf_ins SET TABLE testpub_rf_tbl WHERE (c < 100);
+-- with REPLICA IDENTITY FULL, the filter can use any column, but the column
+-- list must contain all of them
+ALTER TABLE testpub_rf_tbl REPLICA IDENTITY FULL;
+ALTER PUBLICATION testpub_rf_ins SET TABLE testpub_rf_tbl WHERE (c < 100);
+ALTER PUBLICATION testpub_rf_ins SET TABLE testpub_rf_tbl (a, b, c);
+ALTER TABLE testpub_rf_tbl REPLICA IDENTITY DEFAULT;
+-- fail - bad column lists
+ALTER PUBLICATION testpub_rf_ins SET (publish = 'insert');
+ALTER PUBLICATION testpub_rf_ins SET TABLE testpub_rf_tbl (a, nosuchcol);
+ALTER PUBLICATION testpub_rf_ins SET TABLE testpub_rf_tbl (a, a);
+ALTER PUBLICATION testpub_rf_ins SET TABLE testpub_rf_tbl (a, ctid);
+-- fail - bad row filters
+ALTER PUBLICATION testpub_rf_ins SET TABLE testpub_rf_tbl WHERE (a);
+ALTER PUBLICATION testpub_rf_ins SET TABLE testpub_rf_tbl WHERE (random() < a);
+ALTER PUBLICATION testpub_rf_ins SET TABLE testpub_rf_tbl WHERE (a IN (SELECT 1));
+ALTER PUBLICATION testpub_rf_ins SET TABLE testpub_rf_tbl WHERE (count(*) > 1);
+ALTER PUBLICATION testpub_rf_ins SET TABLE testpub_rf_tbl WHERE (row_number() OVER () > 1);
+ALTER PUBLICATION testpub_rf_ins SET TABLE testpub_rf_tbl WHERE (generate_series(1, a) > 1);
+ALTER PUBLICATION testpub_rf_ins SET TABLE testpub_rf_tbl WHERE (testpub_rf_tbl IS NOT NULL);
+ALTER PUBLICATION testpub_rf_ins SET TABLE testpub_rf_tbl WHERE (xmin <> '0');
+ALTER PUBLICATION testpub_rf_ins SET TABLE testpub_rf_udt WHERE ((b).x > 1);
+-- fail - the type of a published column can't be changed
+ALTER PUBLICATION testpub_rf_ins SET TABLE testpub_rf_tbl (a, c) WHERE (c > 0);
+ALTER TABLE testpub_rf_tbl ALTER COLUMN c TYPE bigint;
+-- but other columns can be dropped and changed
+ALTER TABLE testpub_rf_tbl ALTER COLUMN b TYPE varchar;
+ALTER TABLE testpub_rf_tbl DROP COLUMN d;
+\dRp+ testpub_rf_ins
+DROP PUBLICATION testpub_rf_ins;
+DROP TABLE testpub_rf_tbl, testpub_rf_udt;
+DROP TYPE testpub_rf_type;
+
 DROP TABLE testpub_parted;
 DROP VIEW testpub_view;
 DROP TABLE testpub_tbl1;
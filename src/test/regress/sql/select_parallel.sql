@@ -64,6 +64,24 @@ explain (costs off)
 	from part_pa_test pa2;
 drop table part_pa_test;
 
+-- Ordered partial Append over range partitions, feeding Gather Merge
+create table part_ord_test(a int, b text) partition by range(a);
+create table part_ord_test_p1 partition of part_ord_test for values from (0) to (1000)
+  with (parallel_workers = 2);
+create table part_ord_test_p2 partition of part_ord_test for values from (1000) to (2000)
+  with (parallel_workers = 2);
+create index on part_ord_test(a);
+insert into part_ord_test select i, 'x' || i from generate_series(0, 1999) i;
+analyze part_ord_test;
+set enable_sort = off;
+explain (costs off)
+	select * from part_ord_test order by a;
+explain (costs off)
+	select * from part_ord_test order by a desc;
+select a from part_ord_test order by a desc limit 3;
+reset enable_sort;
+drop table part_ord_test;
+
 -- test with leader participation disabled
 set parallel_leader_participation = off;
 explain (costs off)
@@ -296,6 +314,31 @@ reset enable_material;
 
 reset enable_hashagg;
 
+-- test redistributing partially aggregated rows among the workers
+set enable_redistribute = on;
+
+explain (costs off)
+   select twothousand, count(*) from tenk1 group by twothousand;
+
+select twothousand, count(*) from tenk1 group by twothousand
+  having count(*) <> 5;
+
+select twothousand, count(*), sum(unique1) from tenk1
+  group by twothousand order by twothousand limit 3;
+
+-- test range-partitioning rows among the workers to sort them
+explain (costs off)
+   select tenthous from tenk1 order by tenthous offset 9995;
+
+select tenthous from tenk1 order by tenthous offset 9995;
+
+explain (costs off)
+   select tenthous from tenk1 order by tenthous desc offset 9995;
+
+select tenthous from tenk1 order by tenthous desc offset 9995;
+
+reset enable_redistribute;
+
 -- check parallelized int8 aggregate (bug #14897)
 explain (costs off)
 select avg(unique1::int8) from tenk1;
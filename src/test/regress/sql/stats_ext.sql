@@ -282,3 +282,71 @@ EXPLAIN (COSTS OFF)
  SELECT * FROM functional_dependencies WHERE a = 1 AND b = '1' AND c = 1;
 
 RESET random_page_cost;
+
+-- MCV lists
+CREATE TABLE mcv_lists (
+    filler1 TEXT,
+    filler2 NUMERIC,
+    a INT,
+    b VARCHAR,
+    filler3 DATE,
+    c INT,
+    d TEXT
+);
+
+-- check the estimated number of rows of a query
+CREATE FUNCTION check_estimated_rows(text) RETURNS int
+LANGUAGE plpgsql AS
+$$
+DECLARE
+    ln text;
+    tmp text[];
+BEGIN
+    FOR ln IN EXECUTE format('EXPLAIN %s', $1)
+    LOOP
+        tmp := regexp_match(ln, 'rows=(\d*)');
+        RETURN tmp[1]::int;
+    END LOOP;
+END;
+$$;
+
+-- 100 distinct combinations, each covering 1% of the rows
+INSERT INTO mcv_lists (a, b, c, filler1)
+     SELECT mod(i,100), mod(i,50), mod(i,25), i FROM generate_series(1,5000) s(i);
+
+ANALYZE mcv_lists;
+
+-- under-estimates when using only per-column statistics
+SELECT check_estimated_rows('SELECT * FROM mcv_lists WHERE a = 1 AND b = ''1''');
+SELECT check_estimated_rows('SELECT * FROM mcv_lists WHERE a = 1 AND b = ''1'' AND c = 1');
+SELECT check_estimated_rows('SELECT * FROM mcv_lists WHERE a < 5 AND b < ''1''');
+
+-- create statistics
+CREATE STATISTICS mcv_lists_stats (mcv) ON a, b, c FROM mcv_lists;
+
+ANALYZE mcv_lists;
+
+SELECT count(*), round(sum(m.frequency)::numeric, 2)
+  FROM pg_statistic_ext s, pg_mcv_list_items(s.stxmcv) m
+ WHERE s.stxname = 'mcv_lists_stats';
+
+SELECT m.index, m.values, m.nulls, m.frequency
+  FROM pg_statistic_ext s, pg_mcv_list_items(s.stxmcv) m
+ WHERE s.stxname = 'mcv_lists_stats' AND m.index < 3;
+
+-- the estimates are now correct
+SELECT check_estimated_rows('SELECT * FROM mcv_lists WHERE a = 1 AND b = ''1''');
+SELECT check_estimated_rows('SELECT * FROM mcv_lists WHERE a = 1 AND b = ''1'' AND c = 1');
+SELECT check_estimated_rows('SELECT * FROM mcv_lists WHERE a < 5 AND b < ''1''');
+
+-- a change of column type resets the MCV list until the next ANALYZE
+ALTER TABLE mcv_lists ALTER COLUMN c TYPE numeric;
+
+SELECT stxmcv IS NULL FROM pg_statistic_ext WHERE stxname = 'mcv_lists_stats';
+
+ANALYZE mcv_lists;
+
+SELECT check_estimated_rows('SELECT * FROM mcv_lists WHERE a = 1 AND b = ''1'' AND c = 1');
+
+DROP TABLE mcv_lists;
+DROP FUNCTION check_estimated_rows(text);
@@ -12,6 +12,16 @@ select count(*) >= 0 as ok from pg_available_extension_versions;
 
 select count(*) >= 0 as ok from pg_available_extensions;
 
+-- There is one row for the relation cache, and one for each catalog cache
+select count(*) = 1 as ok from pg_catalog_caches where cache_id is null;
+select count(*) > 0 as ok from pg_catalog_caches where cache_id is not null;
+
+-- With a tiny target, loading anything new evicts old entries
+set catalog_cache_memory_target = '1kB';
+select 'pg_am'::regclass;
+select sum(evictions) > 0 as ok from pg_catalog_caches;
+reset catalog_cache_memory_target;
+
 -- At introduction, pg_config had 23 entries; it may grow
 select count(*) > 20 as ok from pg_config;
 
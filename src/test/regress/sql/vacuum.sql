@@ -62,6 +62,30 @@ VACUUM FULL vactst;
 
 VACUUM (DISABLE_PAGE_SKIPPING) vaccluster;
 
+-- PARALLEL option
+CREATE TABLE pvactst (i int, t text);
+CREATE INDEX pvactst_i ON pvactst (i);
+CREATE INDEX pvactst_t ON pvactst (t);
+INSERT INTO pvactst SELECT i, i::text FROM generate_series(1, 1000) i;
+DELETE FROM pvactst WHERE i % 3 = 0;
+VACUUM (PARALLEL 2) pvactst;
+VACUUM (PARALLEL 0) pvactst;
+VACUUM (PARALLEL 1, FULL) pvactst;
+DROP TABLE pvactst;
+
+-- INDEX_CLEANUP option
+CREATE TABLE no_index_cleanup (i INT PRIMARY KEY) WITH (vacuum_index_cleanup = false);
+INSERT INTO no_index_cleanup SELECT generate_series(1, 100);
+DELETE FROM no_index_cleanup WHERE i % 2 = 0;
+VACUUM no_index_cleanup;
+VACUUM (INDEX_CLEANUP TRUE) no_index_cleanup;
+ALTER TABLE no_index_cleanup SET (vacuum_index_cleanup = true);
+DELETE FROM no_index_cleanup WHERE i % 5 = 0;
+VACUUM (INDEX_CLEANUP OFF, FREEZE) no_index_cleanup;
+VACUUM (INDEX_CLEANUP) no_index_cleanup;
+VACUUM (INDEX_CLEANUP maybe) no_index_cleanup;
+DROP TABLE no_index_cleanup;
+
 -- partitioned table
 CREATE TABLE vacparted (a int, b char) PARTITION BY LIST (a);
 CREATE TABLE vacparted1 PARTITION OF vacparted FOR VALUES IN (1);
@@ -908,6 +908,90 @@ SELECT
   lag(1) OVER (PARTITION BY depname ORDER BY salary,enroll_date,empno)
 FROM empsalary;
 
+-- Test run conditions: filters on monotonic window functions let the
+-- WindowAgg stop processing a partition early
+EXPLAIN (COSTS OFF)
+SELECT * FROM
+  (SELECT empno, row_number() OVER (ORDER BY salary DESC, empno) rn
+   FROM empsalary) emp
+WHERE rn <= 3;
+
+SELECT * FROM
+  (SELECT empno, row_number() OVER (ORDER BY salary DESC, empno) rn
+   FROM empsalary) emp
+WHERE rn <= 3;
+
+EXPLAIN (COSTS OFF)
+SELECT * FROM
+  (SELECT empno, salary, rank() OVER (ORDER BY salary DESC) r
+   FROM empsalary) emp
+WHERE 3 > r;
+
+SELECT * FROM
+  (SELECT empno, salary, rank() OVER (ORDER BY salary DESC) r
+   FROM empsalary) emp
+WHERE 3 > r ORDER BY empno;
+
+-- with equality, only the upper bound becomes a run condition
+EXPLAIN (COSTS OFF)
+SELECT * FROM
+  (SELECT empno, salary, dense_rank() OVER (ORDER BY salary) dr
+   FROM empsalary) emp
+WHERE dr = 2;
+
+SELECT * FROM
+  (SELECT empno, salary, dense_rank() OVER (ORDER BY salary) dr
+   FROM empsalary) emp
+WHERE dr = 2;
+
+-- with PARTITION BY, only the rest of each partition is skipped
+EXPLAIN (COSTS OFF)
+SELECT * FROM
+  (SELECT depname, empno, salary,
+          rank() OVER (PARTITION BY depname ORDER BY salary DESC) r
+   FROM empsalary) emp
+WHERE r <= 2;
+
+SELECT * FROM
+  (SELECT depname, empno, salary,
+          rank() OVER (PARTITION BY depname ORDER BY salary DESC) r
+   FROM empsalary) emp
+WHERE r <= 2 ORDER BY depname, empno;
+
+SELECT * FROM
+  (SELECT depname, empno, salary,
+          row_number() OVER (PARTITION BY depname ORDER BY salary, empno) rn
+   FROM empsalary) emp
+WHERE rn < 2 ORDER BY depname;
+
+-- no run condition for a lower bound
+EXPLAIN (COSTS OFF)
+SELECT * FROM
+  (SELECT empno, row_number() OVER (ORDER BY empno) rn
+   FROM empsalary) emp
+WHERE rn > 8;
+
+-- nor for functions that are not monotonic
+EXPLAIN (COSTS OFF)
+SELECT * FROM
+  (SELECT empno, ntile(3) OVER (ORDER BY empno) nt
+   FROM empsalary) emp
+WHERE nt <= 1;
+
+-- nor when another window function needs the rows after the ones we keep
+EXPLAIN (COSTS OFF)
+SELECT * FROM
+  (SELECT empno, row_number() OVER (ORDER BY empno) rn,
+          count(*) OVER (ORDER BY salary) c
+   FROM empsalary) emp
+WHERE rn <= 2;
+
+SELECT * FROM
+  (SELECT empno, row_number() OVER (ORDER BY empno) rn,
+          count(*) OVER (ORDER BY salary) c
+   FROM empsalary) emp
+WHERE rn <= 2;
+
 -- cleanup
 DROP TABLE empsalary;
 
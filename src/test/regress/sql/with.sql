@@ -1039,3 +1039,28 @@ create temp table test (i int);
 with test as (select 42) insert into test select * from test;
 select * from test;
 drop table test;
+
+--
+-- NOT MATERIALIZED: inline the CTE as a subquery when that is safe
+--
+explain (costs off)
+with x as (select * from int4_tbl)
+select * from x where f1 = 1;
+explain (costs off)
+with x as materialized (select * from int4_tbl)
+select * from x where f1 = 1;
+explain (costs off)
+with x as not materialized (select * from int4_tbl)
+select * from x where f1 = 1;
+-- volatile functions prevent inlining
+explain (costs off)
+with x as not materialized (select f1, random() from int4_tbl)
+select * from x where f1 = 1;
+with x as not materialized (select * from int4_tbl)
+select * from x where f1 = 0;
+-- check reverse listing
+create temp view nm_view as
+with x as not materialized (select f1 from int4_tbl)
+select * from x;
+select pg_get_viewdef('nm_view'::regclass, true);
+drop view nm_view;
@@ -0,0 +1,94 @@
+# Test replication with the binary option
+use strict;
+use warnings;
+use PostgresNode;
+use TestLib;
+use Test::More tests => 5;
+
+# setup
+
+my $node_publisher = get_new_node('publisher');
+$node_publisher->init(allows_streaming => 'logical');
+$node_publisher->start;
+
+my $node_subscriber = get_new_node('subscriber');
+$node_subscriber->init(allows_streaming => 'logical');
+$node_subscriber->start;
+
+my $publisher_connstr = $node_publisher->connstr . ' dbname=postgres';
+
+my $ddl = "CREATE TABLE test_numerical (a int PRIMARY KEY, b numeric, "
+  . "c float, d bigint, e timestamptz, f bytea, g int[], h text);";
+
+$node_publisher->safe_psql('postgres', $ddl);
+$node_subscriber->safe_psql('postgres', $ddl);
+
+# Rows copied by the initial synchronization
+$node_publisher->safe_psql('postgres',
+	"INSERT INTO test_numerical VALUES
+		(1, 10.5, 1.2, 1000000000000, '2019-01-01 10:00:00+00', '\\x0102', '{1,2}', 'one'),
+		(2, NULL, NULL, NULL, NULL, NULL, NULL, NULL)");
+
+$node_publisher->safe_psql('postgres',
+	"CREATE PUBLICATION tpub FOR TABLE test_numerical");
+$node_subscriber->safe_psql('postgres',
+	"CREATE SUBSCRIPTION tsub CONNECTION '$publisher_connstr application_name=tsub' PUBLICATION tpub WITH (binary = true)"
+);
+
+# Wait for initial sync to finish
+my $synced_query =
+  "SELECT count(1) = 0 FROM pg_subscription_rel WHERE srsubstate NOT IN ('r', 's');";
+$node_subscriber->poll_query_until('postgres', $synced_query)
+  or die "Timed out while waiting for subscriber to synchronize data";
+
+my $result = $node_subscriber->safe_psql('postgres',
+	"SELECT a, b, c, d, e AT TIME ZONE 'UTC', f, g, h FROM test_numerical ORDER BY a");
+is( $result, "1|10.5|1.2|1000000000000|2019-01-01 10:00:00|\\x0102|{1,2}|one
+2|||||||", 'initial data copied in binary format');
+
+# Changes streamed in binary format
+$node_publisher->safe_psql('postgres',
+	"INSERT INTO test_numerical VALUES
+		(3, 3.14159, 2.5, -42, '2019-06-30 23:59:59+00', '\\xff', '{3}', 'three')");
+$node_publisher->safe_psql('postgres',
+	"UPDATE test_numerical SET b = b * 2, f = '\\xabcd' WHERE a = 1");
+$node_publisher->safe_psql('postgres',
+	"DELETE FROM test_numerical WHERE a = 2");
+
+$node_publisher->wait_for_catchup('tsub');
+
+$result = $node_subscriber->safe_psql('postgres',
+	"SELECT a, b, c, d, e AT TIME ZONE 'UTC', f, g, h FROM test_numerical ORDER BY a");
+is( $result, "1|21.0|1.2|1000000000000|2019-01-01 10:00:00|\\xabcd|{1,2}|one
+3|3.14159|2.5|-42|2019-06-30 23:59:59|\\xff|{3}|three",
+	'changes replicated in binary format');
+
+# Unchanged columns are kept when only some are updated
+$node_publisher->safe_psql('postgres',
+	"UPDATE test_numerical SET h = 'changed' WHERE a = 3");
+
+$node_publisher->wait_for_catchup('tsub');
+
+$result = $node_subscriber->safe_psql('postgres',
+	"SELECT b, f, h FROM test_numerical WHERE a = 3");
+is($result, '3.14159|\\xff|changed', 'update replicated in binary format');
+
+# Switch back to text format
+$node_subscriber->safe_psql('postgres',
+	"ALTER SUBSCRIPTION tsub SET (binary = false)");
+
+$result = $node_subscriber->safe_psql('postgres',
+	"SELECT subbinary FROM pg_subscription WHERE subname = 'tsub'");
+is($result, 'f', 'binary option disabled');
+
+$node_publisher->safe_psql('postgres',
+	"INSERT INTO test_numerical VALUES (4, 4.4, 4.4, 4, NULL, '\\x04', '{4}', 'four')");
+
+$node_publisher->wait_for_catchup('tsub');
+
+$result = $node_subscriber->safe_psql('postgres',
+	"SELECT b, f, g, h FROM test_numerical WHERE a = 4");
+is($result, '4.4|\\x04|{4}|four', 'changes replicated in text format');
+
+$node_subscriber->stop('fast');
+$node_publisher->stop('fast');
@@ -0,0 +1,144 @@
+# Test parallel apply of logical replication transactions
+use strict;
+use warnings;
+use PostgresNode;
+use TestLib;
+use Test::More tests => 8;
+use Time::HiRes qw(usleep);
+
+# setup
+
+my $node_publisher = get_new_node('publisher');
+$node_publisher->init(allows_streaming => 'logical');
+$node_publisher->start;
+
+my $node_subscriber = get_new_node('subscriber');
+$node_subscriber->init(allows_streaming => 'logical');
+$node_subscriber->append_conf(
+	'postgresql.conf', qq(
+log_min_messages = debug1
+max_logical_replication_workers = 6
+max_parallel_apply_workers_per_subscription = 2
+));
+$node_subscriber->start;
+
+my $publisher_connstr = $node_publisher->connstr . ' dbname=postgres';
+my $appname           = 'tap_sub';
+
+foreach my $node ($node_publisher, $node_subscriber)
+{
+	$node->safe_psql(
+		'postgres', q{
+CREATE TABLE tab1 (a int PRIMARY KEY, b int);
+CREATE TABLE tab2 (a int PRIMARY KEY, b text);
+CREATE TABLE tab_big (a int, b text);
+});
+}
+
+$node_publisher->safe_psql('postgres',
+	"INSERT INTO tab1 SELECT g, 0 FROM generate_series(1, 10) g");
+$node_publisher->safe_psql('postgres',
+	"CREATE PUBLICATION tap_pub FOR TABLE tab1, tab2, tab_big");
+$node_subscriber->safe_psql('postgres',
+	"CREATE SUBSCRIPTION tap_sub CONNECTION '$publisher_connstr application_name=$appname' PUBLICATION tap_pub"
+);
+
+# Wait for initial sync
+my $synced_query =
+  "SELECT count(1) = 0 FROM pg_subscription_rel WHERE srsubstate NOT IN ('r', 's');";
+$node_subscriber->poll_query_until('postgres', $synced_query)
+  or die "Timed out while waiting for subscriber to synchronize data";
+
+my $started = 0;
+foreach my $i (0 .. 1800)
+{
+	if (slurp_file($node_subscriber->logfile) =~
+		/apply worker for subscription "tap_sub" started 2 parallel apply workers/)
+	{
+		$started = 1;
+		last;
+	}
+	usleep(100_000);
+}
+ok($started, 'parallel apply workers started');
+
+# Many small transactions, alternating between the tables, some of them
+# modifying both
+$node_publisher->safe_psql(
+	'postgres', q{
+DO $$
+BEGIN
+  FOR i IN 1..200 LOOP
+    IF i % 2 = 0 THEN
+      INSERT INTO tab2 VALUES (i, 'row ' || i);
+    ELSE
+      UPDATE tab1 SET b = b + 1 WHERE a = i % 10 + 1;
+    END IF;
+    IF i % 25 = 0 THEN
+      UPDATE tab1 SET b = b + 1;
+      UPDATE tab2 SET b = b || '+' WHERE a = i;
+    END IF;
+    COMMIT;
+  END LOOP;
+END
+$$;
+});
+
+$node_publisher->wait_for_catchup($appname);
+
+my $query_tab1 = "SELECT count(*), sum(b), string_agg(b::text, ',' ORDER BY a) FROM tab1";
+my $query_tab2 = "SELECT count(*), string_agg(b, ',' ORDER BY a) FROM tab2";
+is( $node_subscriber->safe_psql('postgres', $query_tab1),
+	$node_publisher->safe_psql('postgres', $query_tab1),
+	'updates of tab1 applied in order');
+is( $node_subscriber->safe_psql('postgres', $query_tab2),
+	$node_publisher->safe_psql('postgres', $query_tab2),
+	'inserts and updates of tab2 applied');
+
+# Transactions updating the same row over and over again
+$node_publisher->safe_psql(
+	'postgres', q{
+DO $$
+BEGIN
+  FOR i IN 1..100 LOOP
+    UPDATE tab1 SET b = b + 1 WHERE a = 1;
+    EXECUTE 'DELETE FROM tab2 WHERE a = $1' USING 2 * i;
+    COMMIT;
+  END LOOP;
+END
+$$;
+});
+
+$node_publisher->wait_for_catchup($appname);
+
+is( $node_subscriber->safe_psql('postgres', $query_tab1),
+	$node_publisher->safe_psql('postgres', $query_tab1),
+	'repeated updates of the same row applied');
+is($node_subscriber->safe_psql('postgres', "SELECT count(*) FROM tab2"),
+	'0', 'deletes applied');
+
+# A transaction too large to hand over is applied by the apply worker itself
+$node_publisher->safe_psql('postgres',
+	"INSERT INTO tab_big SELECT g, repeat('x', 100) FROM generate_series(1, 200000) g"
+);
+$node_publisher->safe_psql('postgres', "UPDATE tab1 SET b = 0");
+
+$node_publisher->wait_for_catchup($appname);
+
+is( $node_subscriber->safe_psql(
+		'postgres', "SELECT count(*), count(DISTINCT a) FROM tab_big"),
+	'200000|200000',
+	'large transaction applied');
+is($node_subscriber->safe_psql('postgres', "SELECT sum(b) FROM tab1"),
+	'0', 'transaction after the large one applied');
+
+# Transactions are handed over again after that
+$node_publisher->safe_psql('postgres', "INSERT INTO tab2 VALUES (1, 'last')");
+$node_publisher->wait_for_catchup($appname);
+is( $node_subscriber->safe_psql(
+		'postgres', "SELECT b FROM tab2 WHERE a = 1"),
+	'last',
+	'last transaction applied');
+
+$node_subscriber->stop('fast');
+$node_publisher->stop('fast');
@@ -0,0 +1,134 @@
+# Test publication row filters and column lists
+use strict;
+use warnings;
+use PostgresNode;
+use TestLib;
+use Test::More tests => 8;
+
+# setup
+
+my $node_publisher = get_new_node('publisher');
+$node_publisher->init(allows_streaming => 'logical');
+$node_publisher->start;
+
+my $node_subscriber = get_new_node('subscriber');
+$node_subscriber->init(allows_streaming => 'logical');
+$node_subscriber->start;
+
+my $publisher_connstr = $node_publisher->connstr . ' dbname=postgres';
+my $appname           = 'tap_sub';
+
+$node_publisher->safe_psql(
+	'postgres', q{
+CREATE TABLE tab_rf (a int PRIMARY KEY, b text, c int);
+CREATE TABLE tab_cols (a int PRIMARY KEY, b text, secret text);
+INSERT INTO tab_rf SELECT g, 'init ' || g, g FROM generate_series(1, 20) g;
+INSERT INTO tab_cols VALUES (1, 'one', 'hidden'), (2, 'two', 'hidden');
+});
+
+# The subscriber only has the published columns of tab_cols
+$node_subscriber->safe_psql(
+	'postgres', q{
+CREATE TABLE tab_rf (a int PRIMARY KEY, b text, c int);
+CREATE TABLE tab_cols (a int PRIMARY KEY, b text);
+});
+
+# Rows are published if either publication's filter accepts them
+$node_publisher->safe_psql(
+	'postgres', q{
+CREATE PUBLICATION tap_pub_1 FOR TABLE tab_rf WHERE (a > 10 AND a <= 100),
+  tab_cols (a, b);
+CREATE PUBLICATION tap_pub_2 FOR TABLE tab_rf WHERE (a = 5);
+});
+$node_subscriber->safe_psql('postgres',
+	"CREATE SUBSCRIPTION tap_sub CONNECTION '$publisher_connstr application_name=$appname' PUBLICATION tap_pub_1, tap_pub_2"
+);
+
+# Wait for initial sync
+my $synced_query =
+  "SELECT count(1) = 0 FROM pg_subscription_rel WHERE srsubstate NOT IN ('r', 's');";
+$node_subscriber->poll_query_until('postgres', $synced_query)
+  or die "Timed out while waiting for subscriber to synchronize data";
+
+my $query_rf = "SELECT string_agg(a || ':' || b, ',' ORDER BY a) FROM tab_rf";
+
+is( $node_subscriber->safe_psql(
+		'postgres', "SELECT count(*), min(a), max(a) FROM tab_rf"),
+	'11|5|20',
+	'initial sync copies the filtered rows only');
+is( $node_subscriber->safe_psql(
+		'postgres', "SELECT string_agg(a || ':' || b, ',' ORDER BY a) FROM tab_cols"),
+	'1:one,2:two',
+	'initial sync copies the listed columns only');
+
+# Inserts
+$node_publisher->safe_psql(
+	'postgres', q{
+INSERT INTO tab_rf VALUES (0, 'no', 0), (50, 'yes', 50), (500, 'no', 500);
+INSERT INTO tab_cols VALUES (3, 'three', 'hidden');
+});
+$node_publisher->wait_for_catchup($appname);
+
+is( $node_subscriber->safe_psql(
+		'postgres', "SELECT count(*), min(a), max(a) FROM tab_rf"),
+	'12|5|50',
+	'inserts are filtered');
+is( $node_subscriber->safe_psql(
+		'postgres', "SELECT string_agg(a || ':' || b, ',' ORDER BY a) FROM tab_cols"),
+	'1:one,2:two,3:three',
+	'inserts only send the listed columns');
+
+# Updates that keep a row inside or outside the filter, and ones that move
+# it into the filter (sent as an INSERT) or out of it (sent as a DELETE)
+$node_publisher->safe_psql(
+	'postgres', q{
+UPDATE tab_rf SET b = 'upd in' WHERE a = 15;
+UPDATE tab_rf SET b = 'upd out' WHERE a = 1;
+UPDATE tab_rf SET a = 30, b = 'moved in' WHERE a = 2;
+UPDATE tab_rf SET a = 200, b = 'moved out' WHERE a = 12;
+UPDATE tab_rf SET a = 25, b = 'moved within' WHERE a = 5;
+UPDATE tab_cols SET b = 'TWO', secret = 'still hidden' WHERE a = 2;
+UPDATE tab_cols SET secret = 'only hidden' WHERE a = 1;
+});
+$node_publisher->wait_for_catchup($appname);
+
+is( $node_subscriber->safe_psql('postgres', $query_rf),
+	$node_publisher->safe_psql(
+		'postgres',
+		"$query_rf WHERE (a > 10 AND a <= 100) OR a = 5"),
+	'updates moving rows into and out of the filter are applied');
+is( $node_subscriber->safe_psql(
+		'postgres', "SELECT string_agg(a || ':' || b, ',' ORDER BY a) FROM tab_cols"),
+	'1:one,2:TWO,3:three',
+	'updates only send the listed columns');
+
+# Deletes of rows inside and outside the filter
+$node_publisher->safe_psql(
+	'postgres', q{
+DELETE FROM tab_rf WHERE a IN (0, 13, 30, 200);
+DELETE FROM tab_cols WHERE a = 3;
+});
+$node_publisher->wait_for_catchup($appname);
+
+is( $node_subscriber->safe_psql('postgres', $query_rf),
+	$node_publisher->safe_psql(
+		'postgres',
+		"$query_rf WHERE (a > 10 AND a <= 100) OR a = 5"),
+	'deletes are filtered');
+
+# Changing the filter affects later changes
+$node_publisher->safe_psql('postgres',
+	"ALTER PUBLICATION tap_pub_2 SET TABLE tab_rf WHERE (a < 0)");
+$node_publisher->safe_psql('postgres',
+	"INSERT INTO tab_rf VALUES (-1, 'negative', -1), (1000, 'no', 1000)");
+$node_publisher->wait_for_catchup($appname);
+
+is( $node_subscriber->safe_psql(
+		'postgres',
+		"SELECT string_agg(a::text, ',' ORDER BY a) FROM tab_rf WHERE a < 10 OR a > 100"
+	),
+	'-1',
+	'changed row filter is used');
+
+$node_subscriber->stop('fast');
+$node_publisher->stop('fast');
@@ -0,0 +1,124 @@
+# Test streaming of large in-progress transactions
+use strict;
+use warnings;
+use PostgresNode;
+use TestLib;
+use Test::More tests => 7;
+
+# setup
+
+my $node_publisher = get_new_node('publisher');
+$node_publisher->init(allows_streaming => 'logical');
+$node_publisher->append_conf('postgresql.conf',
+	'logical_decoding_work_mem = 64kB');
+$node_publisher->start;
+
+my $node_subscriber = get_new_node('subscriber');
+$node_subscriber->init(allows_streaming => 'logical');
+$node_subscriber->append_conf('postgresql.conf', 'log_min_messages = debug1');
+$node_subscriber->start;
+
+my $publisher_connstr = $node_publisher->connstr . ' dbname=postgres';
+my $appname           = 'tap_sub';
+
+foreach my $node ($node_publisher, $node_subscriber)
+{
+	$node->safe_psql('postgres',
+		"CREATE TABLE test_tab (a int PRIMARY KEY, b varchar)");
+}
+
+$node_publisher->safe_psql('postgres',
+	"INSERT INTO test_tab VALUES (1, 'foo'), (2, 'bar')");
+$node_publisher->safe_psql('postgres',
+	"CREATE PUBLICATION tap_pub FOR TABLE test_tab");
+$node_subscriber->safe_psql('postgres',
+	"CREATE SUBSCRIPTION tap_sub CONNECTION '$publisher_connstr application_name=$appname' PUBLICATION tap_pub WITH (streaming = on)"
+);
+
+# Wait for initial sync
+my $synced_query =
+  "SELECT count(1) = 0 FROM pg_subscription_rel WHERE srsubstate NOT IN ('r', 's');";
+$node_subscriber->poll_query_until('postgres', $synced_query)
+  or die "Timed out while waiting for subscriber to synchronize data";
+
+is( $node_subscriber->safe_psql(
+		'postgres', "SELECT substream FROM pg_subscription"),
+	't',
+	'streaming is enabled for the subscription');
+
+my $query = "SELECT count(*), count(c), count(DISTINCT b) FROM test_tab";
+$node_subscriber->safe_psql('postgres',
+	"ALTER TABLE test_tab ADD COLUMN c timestamptz DEFAULT now()");
+
+# A transaction far larger than logical_decoding_work_mem, with updates and
+# deletes of rows it inserted itself
+my $logstart = -s $node_subscriber->logfile;
+$node_publisher->safe_psql(
+	'postgres', q{
+BEGIN;
+INSERT INTO test_tab SELECT g, md5(g::text) FROM generate_series(3, 5000) g;
+UPDATE test_tab SET b = md5(b) WHERE mod(a, 2) = 0;
+DELETE FROM test_tab WHERE mod(a, 3) = 0;
+COMMIT;
+});
+
+$node_publisher->wait_for_catchup($appname);
+
+is( $node_subscriber->safe_psql('postgres', $query),
+	'3334|3334|3334', 'large transaction streamed and applied');
+like(
+	substr(slurp_file($node_subscriber->logfile), $logstart),
+	qr/replayed [0-9]+ changes of streamed transaction/,
+	'changes were received as a stream');
+is( $node_subscriber->safe_psql('postgres',
+		"SELECT count(*) FROM test_tab WHERE b = md5(md5(a::text))"),
+	'1666', 'updates of streamed rows applied');
+
+# A large transaction that is rolled back leaves nothing behind
+$node_publisher->safe_psql(
+	'postgres', q{
+BEGIN;
+INSERT INTO test_tab SELECT g, md5(g::text) FROM generate_series(5001, 10000) g;
+DELETE FROM test_tab WHERE a <= 100;
+ROLLBACK;
+});
+
+# A large transaction with subtransactions, some of which are rolled back
+$node_publisher->safe_psql(
+	'postgres', q{
+BEGIN;
+INSERT INTO test_tab SELECT g, md5(g::text) FROM generate_series(5001, 7000) g;
+SAVEPOINT s1;
+INSERT INTO test_tab SELECT g, md5(g::text) FROM generate_series(7001, 9000) g;
+ROLLBACK TO s1;
+SAVEPOINT s2;
+UPDATE test_tab SET b = 'sub' WHERE a > 6000;
+SAVEPOINT s3;
+DELETE FROM test_tab WHERE a > 6500;
+RELEASE s3;
+SAVEPOINT s4;
+DELETE FROM test_tab;
+ROLLBACK TO s4;
+COMMIT;
+});
+
+$node_publisher->wait_for_catchup($appname);
+
+is( $node_subscriber->safe_psql('postgres', $query),
+	'4834|4834|4335', 'aborted transaction and subtransactions not applied');
+is( $node_subscriber->safe_psql('postgres',
+		"SELECT count(*), min(a), max(a) FROM test_tab WHERE b = 'sub'"),
+	'500|6001|6500', 'released subtransaction applied');
+
+# Once streaming is disabled, large transactions are sent at commit
+$node_subscriber->safe_psql('postgres',
+	"ALTER SUBSCRIPTION tap_sub SET (streaming = off)");
+$node_publisher->safe_psql('postgres',
+	"DELETE FROM test_tab WHERE a > 2");
+$node_publisher->wait_for_catchup($appname);
+
+is($node_subscriber->safe_psql('postgres', "SELECT count(*) FROM test_tab"),
+	'2', 'large transaction applied without streaming');
+
+$node_subscriber->stop('fast');
+$node_publisher->stop('fast');
@@ -0,0 +1,334 @@
+#----------------------------------------------------------------------
+#
+# PerfectHash.pm
+#    Perl module that constructs minimal perfect hash functions
+#
+# This code constructs a minimal perfect hash function for the given
+# set of keys, using an algorithm described in
+# "An optimal algorithm for generating minimal perfect hash functions"
+# by Czech, Havas and Majewski in Information Processing Letters,
+# 43(5):256-264, October 1992.
+# This implementation is loosely based on NetBSD's "nbperf",
+# which was written by Joerg Sonnenberger.
+#
+# The resulting hash function is perfect in the sense that if the presented
+# key is one of the original set, it will return the key's index in the set
+# (in range 0..N-1).  However, the caller must still verify the match,
+# as false positives are possible.  Also, the hash function may return
+# values that are out of range (negative or >= N), due to summing unrelated
+# hashtable entries.  This indicates that the presented key is definitely
+# not in the set.
+#
+#
+# Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+# Portions Copyright (c) 1994, Regents of the University of California
+#
+# src/tools/PerfectHash.pm
+#
+#----------------------------------------------------------------------
+
+package PerfectHash;
+
+use strict;
+use warnings;
+
+
+# At runtime, we'll compute two simple hash functions of the input key,
+# and use them to index into a mapping table.  The hash functions are just
+# multiply-and-add in uint32 arithmetic, with different multipliers and
+# initial seeds.  All the complexity in this module is concerned with
+# selecting hash parameters that will work and building the mapping table.
+
+# We support making case-insensitive hash functions, though this only
+# works for a strict-ASCII interpretation of case insensitivity,
+# ie, A-Z maps onto a-z and nothing else.
+my $case_fold = 0;
+
+
+#
+# Construct a C function implementing a perfect hash for the given keys.
+# The C function definition is returned as a string.
+#
+# The keys should be passed as an array reference.  They can be any set
+# of Perl strings; it is caller's responsibility that there not be any
+# duplicates.  (Note that the "strings" can be binary data, but hashing
+# e.g. OIDs has endianness hazards that callers must overcome.)
+#
+# The name to use for the function is specified as the second argument.
+# It will be a global function by default, but the caller may prepend
+# "static " to the result string if it wants a static function.
+#
+# Additional options can be specified as keyword-style arguments:
+#
+# case_fold => bool
+# If specified as true, the hash function is case-insensitive, for the
+# limited idea of case-insensitivity explained above.
+#
+sub generate_hash_function
+{
+	my ($keys_ref, $funcname, %options) = @_;
+
+	# It's not worth passing this around as a parameter; just use a global.
+	$case_fold = $options{case_fold} || 0;
+
+	# Try different hash function parameters until we find a set that works
+	# for these keys.  The multipliers are chosen to be primes that are cheap
+	# to calculate via shift-and-add, so we don't need to use multiply
+	# instructions.
+	my @HASH_MULTIPLIERS = (31, 127, 257, 8191, 131071);
+
+	# Just in case a particular multiplier fails for a given set of keys,
+	# try several seeds too.
+	my ($hash_mult1, $hash_mult2, $hash_seed1, $hash_seed2);
+	my @subresult;
+  FIND_PARAMS:
+	foreach (0 .. 99)
+	{
+		$hash_seed1 = $_;
+		foreach my $mult1 (@HASH_MULTIPLIERS)
+		{
+			foreach my $mult2 (@HASH_MULTIPLIERS)
+			{
+				next if $mult1 == $mult2;
+				$hash_mult1 = $mult1;
+				$hash_mult2 = $mult2;
+				$hash_seed2 = $hash_seed1 + 1;
+				@subresult = _construct_hash_table(
+					$keys_ref,   $hash_mult1, $hash_mult2,
+					$hash_seed1, $hash_seed2);
+				last FIND_PARAMS if @subresult;
+			}
+		}
+	}
+
+	# Choke if we couldn't find a workable set of parameters.
+	die "failed to generate perfect hash" if !@subresult;
+
+	# Extract info from _construct_hash_table's result array.
+	my $elemtype = $subresult[0];
+	my @hashtab  = @{ $subresult[1] };
+	my $nhash    = scalar(@hashtab);
+
+	# OK, construct the hash function definition including the hash table.
+	my $f = '';
+	$f .= sprintf "int\n";
+	$f .= sprintf "%s(const void *key, size_t keylen)\n{\n", $funcname;
+	$f .= sprintf "\tstatic const %s h[%d] = {\n", $elemtype, $nhash;
+	for (my $i = 0; $i < $nhash; $i++)
+	{
+		$f .= sprintf "%s%6d,%s",
+		  ($i % 8 == 0 ? "\t\t" : " "),
+		  $hashtab[$i],
+		  ($i % 8 == 7 ? "\n" : "");
+	}
+	$f .= sprintf "\n" if ($nhash % 8 != 0);
+	$f .= sprintf "\t};\n\n";
+	$f .= sprintf "\tconst unsigned char *k = (const unsigned char *) key;\n";
+	$f .= sprintf "\tuint32\t\ta = %d;\n",   $hash_seed1;
+	$f .= sprintf "\tuint32\t\tb = %d;\n\n", $hash_seed2;
+	$f .= sprintf "\twhile (keylen--)\n\t{\n";
+	$f .= sprintf "\t\tunsigned char c = *k++";
+	$f .= sprintf " | 0x20" if $case_fold;    # see _calc_hash()
+	$f .= sprintf ";\n\n";
+	$f .= sprintf "\t\ta = a * %d + c;\n", $hash_mult1;
+	$f .= sprintf "\t\tb = b * %d + c;\n", $hash_mult2;
+	$f .= sprintf "\t}\n";
+	$f .= sprintf "\treturn h[a %% %d] + h[b %% %d];\n", $nhash, $nhash;
+	$f .= sprintf "}\n";
+
+	return $f;
+}
+
+
+# Calculate a hash function as the run-time code will do.
+#
+# If we are making a case-insensitive hash function, we implement that
+# by OR'ing 0x20 into each byte of the key.  This correctly transforms
+# upper-case ASCII into lower-case ASCII, while not changing digits or
+# dollar signs.  (It does change '_', as well as other characters not
+# likely to appear in keywords; this has little effect on the hash's
+# ability to discriminate keywords.)
+sub _calc_hash
+{
+	my ($key, $mult, $seed) = @_;
+
+	my $result = $seed;
+	for my $c (split //, $key)
+	{
+		my $cn = ord($c);
+		$cn |= 0x20 if $case_fold;
+		$result = ($result * $mult + $cn) % 4294967296;
+	}
+	return $result;
+}
+
+
+# Attempt to construct a mapping table for a minimal perfect hash function
+# for the given keys, using the specified hash parameters.
+#
+# Returns an array containing the mapping table element type name as the
+# first element, and a ref to an array of the table values as the second.
+#
+# Returns an empty array on failure; then caller should choose different
+# hash parameter(s) and try again.
+sub _construct_hash_table
+{
+	my ($keys_ref, $hash_mult1, $hash_mult2, $hash_seed1, $hash_seed2) = @_;
+	my @keys = @{$keys_ref};
+
+	# This algorithm is based on a graph whose edges correspond to the
+	# keys and whose vertices correspond to entries of the mapping table.
+	# A key's edge links the two vertices whose indexes are the outputs of
+	# the two hash functions for that key.  The method needs the graph to
+	# be acyclic, which a random graph with K edges is reasonably likely to
+	# be if it has a little more than 2*K vertices.  We want the table size
+	# to be odd since it's used as a modulus.
+	my $nedges = scalar @keys;       # number of edges
+	my $nverts = 2 * $nedges + 1;    # number of vertices
+
+	# However, it would be very bad if $nverts were exactly equal to either
+	# $hash_mult1 or $hash_mult2: effectively, that hash function would be
+	# sensitive to only the last byte of each key.  Cases where $nverts is a
+	# multiple of either multiplier likewise lose information.  (But $nverts
+	# can't actually divide them, if they've been intelligently chosen as
+	# primes.)  We can avoid such problems by adjusting the table size.
+	while ($nverts % $hash_mult1 == 0
+		|| $nverts % $hash_mult2 == 0)
+	{
+		$nverts += 2;
+	}
+
+	# Initialize the array of edges.
+	my @E = ();
+	foreach my $kw (@keys)
+	{
+		# Calculate hashes for this key.
+		# The hashes are immediately reduced modulo the mapping table size.
+		my $hash1 = _calc_hash($kw, $hash_mult1, $hash_seed1) % $nverts;
+		my $hash2 = _calc_hash($kw, $hash_mult2, $hash_seed2) % $nverts;
+
+		# If the two hashes are the same for any key, we have to fail
+		# since this edge would itself form a cycle in the graph.
+		return () if $hash1 == $hash2;
+
+		# Add the edge for this key.
+		push @E, { left => $hash1, right => $hash2 };
+	}
+
+	# Initialize the array of vertices, giving them all empty lists
+	# of associated edges.  (The lists will hold numbers of edges.)
+	my @V = ();
+	for (my $v = 0; $v < $nverts; $v++)
+	{
+		push @V, { edges => [] };
+	}
+
+	# Insert each edge in the lists of edges connected to its vertices.
+	for (my $e = 0; $e < $nedges; $e++)
+	{
+		my $v = $E[$e]{left};
+		push @{ $V[$v]{edges} }, $e;
+
+		$v = $E[$e]{right};
+		push @{ $V[$v]{edges} }, $e;
+	}
+
+	# Now we attempt to prune the graph by removing vertices of degree 1.
+	# If it's acyclic, this will eventually remove every vertex.
+	my @output_order = ();
+	for (my $v = 0; $v < $nverts; $v++)
+	{
+		_prune_vertex(\@V, \@E, $v, \@output_order);
+	}
+
+	# If we failed to eliminate any edge, we have a cycle.
+	foreach my $v (@V)
+	{
+		return () if @{ $v->{edges} };
+	}
+
+	# Build the hash table.  The edges were removed in the order recorded
+	# in @output_order.  We assign table values in reverse order: the vertex
+	# an edge was pruned from is not yet assigned at that point, since no
+	# edge removed later touches it, so we can always give one of the
+	# edge's vertices the value that makes the edge sum to its key number.
+	my @hashtab = (0) x $nverts;
+	my @visited = (0) x $nverts;
+
+	foreach my $e (reverse @output_order)
+	{
+		my $l = $E[$e]{left};
+		my $r = $E[$e]{right};
+		if (!$visited[$l])
+		{
+			# $hashtab[$r] might be zero, or some previously assigned value.
+			$hashtab[$l] = $e - $hashtab[$r];
+		}
+		else
+		{
+			die "oops, doubly used hashtab entry" if $visited[$r];
+			# $hashtab[$l] might be zero, or some previously assigned value.
+			$hashtab[$r] = $e - $hashtab[$l];
+		}
+		# Now freeze both of these hashtab entries.
+		$visited[$l] = 1;
+		$visited[$r] = 1;
+	}
+
+	# Detect range of values needed in hash table.
+	my $hmin = $nedges;
+	my $hmax = 0;
+	for (my $v = 0; $v < $nverts; $v++)
+	{
+		next if !$visited[$v];
+		$hmin = $hashtab[$v] if $hashtab[$v] < $hmin;
+		$hmax = $hashtab[$v] if $hashtab[$v] > $hmax;
+	}
+
+	# Choose width of hashtable entries.  No key reaches an unused entry,
+	# so it's arbitrary what we put there, but the largest value of the
+	# type makes out-of-range hash results more likely.
+	my ($elemtype, $unused);
+	if ($hmin >= -0x7F && $hmax < 0x7F)
+	{
+		($elemtype, $unused) = ('int8', 0x7F);
+	}
+	elsif ($hmin >= -0x7FFF && $hmax < 0x7FFF)
+	{
+		($elemtype, $unused) = ('int16', 0x7FFF);
+	}
+	else
+	{
+		($elemtype, $unused) = ('int32', 0x7FFFFFFF);
+	}
+	for (my $v = 0; $v < $nverts; $v++)
+	{
+		$hashtab[$v] = $unused if !$visited[$v];
+	}
+
+	return ($elemtype, \@hashtab);
+}
+
+
+# Recursively prune a vertex of degree 1, and then any neighboring vertex
+# that becomes degree 1 as a result.
+sub _prune_vertex
+{
+	my ($V, $E, $v, $output_order) = @_;
+
+	# If vertex v has degree 1, remove its only edge, and recurse to the
+	# vertex at the other end of that edge.
+	while (scalar(@{ $V->[$v]{edges} }) == 1)
+	{
+		my $e = shift @{ $V->[$v]{edges} };
+		push @{$output_order}, $e;
+
+		my $other = $E->[$e]{left} == $v ? $E->[$e]{right} : $E->[$e]{left};
+		my @remaining = grep { $_ != $e } @{ $V->[$other]{edges} };
+		$V->[$other]{edges} = \@remaining;
+		$v = $other;
+	}
+	return;
+}
+
+1;
@@ -32,9 +32,12 @@ my @unlink_on_exit;
 
 # Set of variables for modules in contrib/ and src/test/modules/
 my $contrib_defines = { 'refint' => 'REFINT_VERBOSE' };
-my @contrib_uselibpq = ('dblink', 'oid2name', 'postgres_fdw', 'vacuumlo');
-my @contrib_uselibpgport   = ('oid2name', 'pg_standby', 'vacuumlo');
-my @contrib_uselibpgcommon = ('oid2name', 'pg_standby', 'vacuumlo');
+my @contrib_uselibpq =
+  ('dblink', 'libpq_pipeline', 'oid2name', 'postgres_fdw', 'vacuumlo');
+my @contrib_uselibpgport =
+  ('libpq_pipeline', 'oid2name', 'pg_standby', 'vacuumlo');
+my @contrib_uselibpgcommon =
+  ('libpq_pipeline', 'oid2name', 'pg_standby', 'vacuumlo');
 my $contrib_extralibs      = undef;
 my $contrib_extraincludes = { 'dblink' => ['src/backend'] };
 my $contrib_extrasource = {
@@ -110,6 +113,7 @@ sub mkvcbuild
 		push(@pgportfiles, 'pg_crc32c_sse42_choose.c');
 		push(@pgportfiles, 'pg_crc32c_sse42.c');
 		push(@pgportfiles, 'pg_crc32c_sb8.c');
+		push(@pgportfiles, 'pg_crc32c_combine.c');
 	}
 	else
 	{
@@ -121,7 +125,7 @@ sub mkvcbuild
 	  keywords.c kwlookup.c link-canary.c md5.c
 	  pg_lzcompress.c pgfnames.c psprintf.c relpath.c rmtree.c
 	  saslprep.c scram-common.c string.c unicode_norm.c username.c
-	  wait_error.c);
+	  wait_error.c zpq_stream.c);
 
 	if ($solution->{options}->{openssl})
 	{
@@ -440,7 +440,7 @@ sub GenerateFiles
 	{
 		print "Generating c_kwlist_d.h and ecpg_kwlist_d.h...\n";
 		chdir('src/interfaces/ecpg/preproc');
-		system('perl ../../../tools/gen_keywordlist.pl --varname ScanCKeywords c_kwlist.h');
+		system('perl ../../../tools/gen_keywordlist.pl --varname ScanCKeywords --no-case-fold c_kwlist.h');
 		system('perl ../../../tools/gen_keywordlist.pl --varname ScanECPGKeywords ecpg_kwlist.h');
 		chdir('../../../..');
 	}
@@ -0,0 +1,38 @@
+/*-------------------------------------------------------------------------
+ *
+ * xlogprefetch.h
+ *		Declarations for the recovery prefetching module.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/access/xlogprefetch.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef XLOGPREFETCH_H
+#define XLOGPREFETCH_H
+
+#include "access/xlogdefs.h"
+#include "common/relpath.h"
+#include "storage/block.h"
+#include "storage/relfilenode.h"
+
+/* GUC variables */
+extern int	recovery_prefetch_distance;
+extern bool recovery_full_page_scan;
+
+typedef struct XLogPrefetchState XLogPrefetchState;
+
+extern XLogPrefetchState *XLogPrefetchBegin(void);
+extern void XLogPrefetchEnd(XLogPrefetchState *state);
+extern void XLogPrefetchReadAhead(XLogPrefetchState *state,
+					  XLogRecPtr replayPtr, TimeLineID tli,
+					  XLogRecPtr readLimit);
+
+extern void XLogFullPageImageScan(XLogRecPtr startPtr, TimeLineID tli);
+extern bool XLogFullPageImageFollows(RelFileNode rnode, ForkNumber forknum,
+						 BlockNumber blkno, XLogRecPtr lsn);
+extern void XLogFullPageImageScanEnd(XLogRecPtr lastReplayedPtr);
+
+#endif							/* XLOGPREFETCH_H */
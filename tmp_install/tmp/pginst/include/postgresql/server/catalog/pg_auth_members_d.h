@@ -0,0 +1,32 @@
+/*-------------------------------------------------------------------------
+ *
+ * pg_auth_members_d.h
+ *    Macro definitions for pg_auth_members
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * NOTES
+ *  ******************************
+ *  *** DO NOT EDIT THIS FILE! ***
+ *  ******************************
+ *
+ *  It has been GENERATED by src/backend/catalog/genbki.pl
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef PG_AUTH_MEMBERS_D_H
+#define PG_AUTH_MEMBERS_D_H
+
+#define AuthMemRelationId 1261
+#define AuthMemRelation_Rowtype_Id 2843
+
+#define Anum_pg_auth_members_roleid 1
+#define Anum_pg_auth_members_member 2
+#define Anum_pg_auth_members_grantor 3
+#define Anum_pg_auth_members_admin_option 4
+
+#define Natts_pg_auth_members 4
+
+
+#endif							/* PG_AUTH_MEMBERS_D_H */
@@ -0,0 +1,125 @@
+/*-------------------------------------------------------------------------
+ *
+ * progress.h
+ *	  Constants used with the progress reporting facilities defined in
+ *	  pgstat.h.  These are possibly interesting to extensions, so we
+ *	  expose them via this header file.  Note that if you update these
+ *	  constants, you probably also need to update the views based on them
+ *	  in system_views.sql.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/commands/progress.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef PROGRESS_H
+#define PROGRESS_H
+
+/* Progress parameters for (lazy) vacuum */
+#define PROGRESS_VACUUM_PHASE					0
+#define PROGRESS_VACUUM_TOTAL_HEAP_BLKS			1
+#define PROGRESS_VACUUM_HEAP_BLKS_SCANNED		2
+#define PROGRESS_VACUUM_HEAP_BLKS_VACUUMED		3
+#define PROGRESS_VACUUM_NUM_INDEX_VACUUMS		4
+#define PROGRESS_VACUUM_MAX_DEAD_TUPLES			5
+#define PROGRESS_VACUUM_NUM_DEAD_TUPLES			6
+
+/* Phases of vacuum (as advertised via PROGRESS_VACUUM_PHASE) */
+#define PROGRESS_VACUUM_PHASE_SCAN_HEAP			1
+#define PROGRESS_VACUUM_PHASE_VACUUM_INDEX		2
+#define PROGRESS_VACUUM_PHASE_VACUUM_HEAP		3
+#define PROGRESS_VACUUM_PHASE_INDEX_CLEANUP		4
+#define PROGRESS_VACUUM_PHASE_TRUNCATE			5
+#define PROGRESS_VACUUM_PHASE_FINAL_CLEANUP		6
+
+/* Progress parameters for CLUSTER and VACUUM FULL */
+#define PROGRESS_CLUSTER_COMMAND				0
+#define PROGRESS_CLUSTER_PHASE					1
+#define PROGRESS_CLUSTER_INDEX_RELID			2
+#define PROGRESS_CLUSTER_HEAP_TUPLES_SCANNED	3
+#define PROGRESS_CLUSTER_HEAP_TUPLES_WRITTEN	4
+#define PROGRESS_CLUSTER_TOTAL_HEAP_BLKS		5
+#define PROGRESS_CLUSTER_HEAP_BLKS_SCANNED		6
+#define PROGRESS_CLUSTER_INDEX_REBUILD_COUNT	7
+
+/* Phases of cluster (as advertised via PROGRESS_CLUSTER_PHASE) */
+#define PROGRESS_CLUSTER_PHASE_SEQ_SCAN_HEAP	1
+#define PROGRESS_CLUSTER_PHASE_INDEX_SCAN_HEAP	2
+#define PROGRESS_CLUSTER_PHASE_SORT_TUPLES		3
+#define PROGRESS_CLUSTER_PHASE_WRITE_NEW_HEAP	4
+#define PROGRESS_CLUSTER_PHASE_SWAP_REL_FILES	5
+#define PROGRESS_CLUSTER_PHASE_REBUILD_INDEX	6
+#define PROGRESS_CLUSTER_PHASE_FINAL_CLEANUP	7
+
+/* Commands of PROGRESS_CLUSTER */
+#define PROGRESS_CLUSTER_COMMAND_CLUSTER		1
+#define PROGRESS_CLUSTER_COMMAND_VACUUM_FULL	2
+
+/*
+ * Progress parameters for CREATE INDEX.
+ *
+ * The parameters from PROGRESS_CREATEIDX_SUBPHASE on are reported by the
+ * index build itself, which also happens when CLUSTER rebuilds the indexes
+ * of its table; they are numbered so as not to overwrite CLUSTER's own.
+ */
+#define PROGRESS_CREATEIDX_COMMAND				0
+#define PROGRESS_CREATEIDX_INDEX_OID			1
+#define PROGRESS_CREATEIDX_PHASE				2
+#define PROGRESS_CREATEIDX_PARTITIONS_TOTAL		3
+#define PROGRESS_CREATEIDX_PARTITIONS_DONE		4
+#define PROGRESS_CREATEIDX_SUBPHASE				10
+#define PROGRESS_CREATEIDX_TUPLES_TOTAL			11
+#define PROGRESS_CREATEIDX_TUPLES_DONE			12
+#define PROGRESS_CREATEIDX_BLOCKS_TOTAL			13
+#define PROGRESS_CREATEIDX_BLOCKS_DONE			14
+
+/* Phases of CREATE INDEX (as advertised via PROGRESS_CREATEIDX_PHASE) */
+#define PROGRESS_CREATEIDX_PHASE_WAIT_1			1
+#define PROGRESS_CREATEIDX_PHASE_BUILD			2
+#define PROGRESS_CREATEIDX_PHASE_WAIT_2			3
+#define PROGRESS_CREATEIDX_PHASE_VALIDATE		4
+#define PROGRESS_CREATEIDX_PHASE_WAIT_3			5
+
+/* Subphases of the build phase (as advertised via PROGRESS_CREATEIDX_SUBPHASE) */
+#define PROGRESS_CREATEIDX_SUBPHASE_SCAN_TABLE	1
+#define PROGRESS_CREATEIDX_SUBPHASE_SORT		2
+#define PROGRESS_CREATEIDX_SUBPHASE_LOAD		3
+
+/* Commands of PROGRESS_CREATEIDX */
+#define PROGRESS_CREATEIDX_COMMAND_CREATE		1
+#define PROGRESS_CREATEIDX_COMMAND_CREATE_CONCURRENTLY	2
+
+/* Progress parameters for COPY */
+#define PROGRESS_COPY_COMMAND					0
+#define PROGRESS_COPY_TYPE						1
+#define PROGRESS_COPY_BYTES_PROCESSED			2
+#define PROGRESS_COPY_BYTES_TOTAL				3
+#define PROGRESS_COPY_TUPLES_PROCESSED			4
+
+/* Commands of PROGRESS_COPY */
+#define PROGRESS_COPY_COMMAND_FROM				1
+#define PROGRESS_COPY_COMMAND_TO				2
+
+/* Types of PROGRESS_COPY */
+#define PROGRESS_COPY_TYPE_FILE					1
+#define PROGRESS_COPY_TYPE_PROGRAM				2
+#define PROGRESS_COPY_TYPE_PIPE					3
+#define PROGRESS_COPY_TYPE_CALLBACK				4
+
+/* Progress parameters for BASE_BACKUP */
+#define PROGRESS_BASEBACKUP_PHASE				0
+#define PROGRESS_BASEBACKUP_BACKUP_TOTAL		1
+#define PROGRESS_BASEBACKUP_BACKUP_STREAMED		2
+#define PROGRESS_BASEBACKUP_TBLSPC_TOTAL		3
+#define PROGRESS_BASEBACKUP_TBLSPC_STREAMED		4
+
+/* Phases of BASE_BACKUP (as advertised via PROGRESS_BASEBACKUP_PHASE) */
+#define PROGRESS_BASEBACKUP_PHASE_WAIT_CHECKPOINT		1
+#define PROGRESS_BASEBACKUP_PHASE_ESTIMATE_BACKUP_SIZE	2
+#define PROGRESS_BASEBACKUP_PHASE_STREAM_BACKUP			3
+#define PROGRESS_BASEBACKUP_PHASE_WAIT_WAL_ARCHIVE		4
+#define PROGRESS_BASEBACKUP_PHASE_TRANSFER_WAL			5
+
+#endif
@@ -0,0 +1,36 @@
+/*
+ * zpq_stream.h
+ *	  Streaming compression of frontend/backend protocol traffic.
+ *
+ * Portions Copyright (c) 2019, PostgreSQL Global Development Group
+ *
+ * src/include/common/zpq_stream.h
+ */
+#ifndef ZPQ_STREAM_H
+#define ZPQ_STREAM_H
+
+/* name of the algorithm, as negotiated in the startup packet */
+#define ZPQ_ALGORITHM_NAME		"zlib"
+
+/* returned by zpq_read() and zpq_write() if (de)compression fails */
+#define ZPQ_STREAM_ERROR		(-2)
+
+/*
+ * Callbacks used to send and receive compressed data, with the semantics of
+ * send(2) and recv(2).
+ */
+typedef ssize_t (*zpq_tx_func) (void *arg, const void *data, size_t size);
+typedef ssize_t (*zpq_rx_func) (void *arg, void *data, size_t size);
+
+typedef struct ZpqStream ZpqStream;
+
+extern ZpqStream *zpq_create(zpq_tx_func tx_func, zpq_rx_func rx_func,
+		   void *arg, const char *rx_data, size_t rx_data_len);
+extern ssize_t zpq_read(ZpqStream *zs, void *buf, size_t size);
+extern ssize_t zpq_write(ZpqStream *zs, const void *buf, size_t size);
+extern bool zpq_buffered_rx(ZpqStream *zs);
+extern bool zpq_buffered_tx(ZpqStream *zs);
+extern const char *zpq_error(ZpqStream *zs);
+extern void zpq_free(ZpqStream *zs);
+
+#endif							/* ZPQ_STREAM_H */
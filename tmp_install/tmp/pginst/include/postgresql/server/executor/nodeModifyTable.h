@@ -0,0 +1,31 @@
+/*-------------------------------------------------------------------------
+ *
+ * nodeModifyTable.h
+ *
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/executor/nodeModifyTable.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef NODEMODIFYTABLE_H
+#define NODEMODIFYTABLE_H
+
+#include "nodes/execnodes.h"
+
+extern ModifyTableState *ExecInitModifyTable(ModifyTable *node, EState *estate, int eflags);
+extern void ExecEndModifyTable(ModifyTableState *node);
+extern void ExecReScanModifyTable(ModifyTableState *node);
+
+extern void ExecSetForeignInsertBatchSize(ResultRelInfo *resultRelInfo);
+extern bool ExecForeignInsertCanBatch(ModifyTableState *mtstate,
+						  ResultRelInfo *resultRelInfo);
+extern int ExecForeignInsertBuffer(ModifyTableState *mtstate,
+						ResultRelInfo *resultRelInfo,
+						TupleTableSlot *slot, TupleTableSlot *planSlot);
+extern int	ExecForeignInsertFlush(ModifyTableState *mtstate,
+					   ResultRelInfo *resultRelInfo);
+
+#endif							/* NODEMODIFYTABLE_H */
@@ -0,0 +1,118 @@
+/*-------------------------------------------------------------------------
+ *
+ * simd.h
+ *	  Support for platform-specific vector operations.
+ *
+ * The operations work on Vector8, a vector of 16 uint8 values.  SSE2 is
+ * part of the x86-64 baseline and Advanced SIMD (NEON) of the AArch64 one,
+ * so no runtime CPU check is needed for either.  On other platforms
+ * USE_NO_SIMD is defined, and callers must fall back to scalar code.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/port/simd.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef SIMD_H
+#define SIMD_H
+
+#if (defined(__x86_64__) || defined(_M_AMD64))
+#include <emmintrin.h>
+#define USE_SSE2
+typedef __m128i Vector8;
+
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define USE_NEON
+typedef uint8x16_t Vector8;
+
+#else
+#define USE_NO_SIMD
+#endif
+
+#ifndef USE_NO_SIMD
+
+/*
+ * Load 16 bytes from memory, which needn't be aligned.
+ */
+static inline void
+vector8_load(Vector8 *v, const uint8 *s)
+{
+#ifdef USE_SSE2
+	*v = _mm_loadu_si128((const __m128i *) s);
+#else
+	*v = vld1q_u8(s);
+#endif
+}
+
+/*
+ * Create a vector with all elements set to c.
+ */
+static inline Vector8
+vector8_broadcast(const uint8 c)
+{
+#ifdef USE_SSE2
+	return _mm_set1_epi8((char) c);
+#else
+	return vdupq_n_u8(c);
+#endif
+}
+
+/*
+ * Compare the elements of two vectors, setting each element of the result
+ * to all ones where they are equal and to zero where they are not.
+ */
+static inline Vector8
+vector8_eq(const Vector8 v1, const Vector8 v2)
+{
+#ifdef USE_SSE2
+	return _mm_cmpeq_epi8(v1, v2);
+#else
+	return vceqq_u8(v1, v2);
+#endif
+}
+
+/*
+ * Compare the elements of two vectors as unsigned values, setting each
+ * element of the result to all ones where v1's element is less than or equal
+ * to v2's and to zero where it is not.
+ */
+static inline Vector8
+vector8_le(const Vector8 v1, const Vector8 v2)
+{
+#ifdef USE_SSE2
+	return _mm_cmpeq_epi8(_mm_min_epu8(v1, v2), v1);
+#else
+	return vcleq_u8(v1, v2);
+#endif
+}
+
+static inline Vector8
+vector8_or(const Vector8 v1, const Vector8 v2)
+{
+#ifdef USE_SSE2
+	return _mm_or_si128(v1, v2);
+#else
+	return vorrq_u8(v1, v2);
+#endif
+}
+
+/*
+ * Is the high bit of any element set?  Applied to the result of
+ * vector8_eq, this tells whether any elements were equal.
+ */
+static inline bool
+vector8_is_highbit_set(const Vector8 v)
+{
+#ifdef USE_SSE2
+	return _mm_movemask_epi8(v) != 0;
+#else
+	return vmaxvq_u8(v) > 0x7F;
+#endif
+}
+
+#endif							/* ! USE_NO_SIMD */
+
+#endif							/* SIMD_H */
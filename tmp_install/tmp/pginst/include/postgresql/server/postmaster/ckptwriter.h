@@ -0,0 +1,28 @@
+/*-------------------------------------------------------------------------
+ *
+ * ckptwriter.h
+ *	  Exports from postmaster/ckptwriter.c.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ *
+ * src/include/postmaster/ckptwriter.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef _CKPTWRITER_H
+#define _CKPTWRITER_H
+
+/* GUC options */
+extern int	checkpoint_writers;
+
+extern void CkptWriterRegister(void);
+extern Size CkptWriterShmemSize(void);
+extern void CkptWriterShmemInit(void);
+extern void CkptWriterMain(Datum main_arg) pg_attribute_noreturn();
+
+/* used by BufferSync() in the checkpointer */
+extern bool CkptWriterStartBatches(int nstreams);
+extern void CkptWriterQueueBuffer(int stream, int buf_id);
+extern int	CkptWriterFinishBatches(void);
+
+#endif							/* _CKPTWRITER_H */
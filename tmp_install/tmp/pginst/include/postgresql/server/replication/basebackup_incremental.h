@@ -0,0 +1,52 @@
+/*-------------------------------------------------------------------------
+ *
+ * basebackup_incremental.h
+ *	  On-disk format of incremental base backups.
+ *
+ * An incremental base backup is a base backup taken with the INCREMENTAL
+ * option of BASE_BACKUP.  Relation files are replaced by INCREMENTAL.<name>
+ * files holding only the blocks whose page LSN is at or after the start of
+ * the prior backup; all other files are sent in full.  A marker file in the
+ * data directory records the LSN the backup is relative to.  pg_combinebackup
+ * reconstructs a regular data directory from a chain of such backups.
+ *
+ * This file is included by frontend programs, so it must not depend on
+ * backend-only headers.
+ *
+ * Portions Copyright (c) 2010-2019, PostgreSQL Global Development Group
+ *
+ * src/include/replication/basebackup_incremental.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef BASEBACKUP_INCREMENTAL_H
+#define BASEBACKUP_INCREMENTAL_H
+
+/* Marker file, present only in backups that are not full backups */
+#define INCREMENTAL_BACKUP_FILE		"incremental_backup"
+
+/* Its only line */
+#define INCREMENTAL_BACKUP_LINE		"INCREMENTAL FROM LSN: %X/%X\n"
+
+/* Prefix of the names of incrementally-sent relation files */
+#define INCREMENTAL_PREFIX			"INCREMENTAL."
+#define INCREMENTAL_PREFIX_LENGTH	(sizeof(INCREMENTAL_PREFIX) - 1)
+
+#define INCREMENTAL_MAGIC			0xd3ae1f0d
+
+/*
+ * An incremental file starts with this header, followed by num_blocks block
+ * numbers (in ascending order) and then the contents of those blocks.
+ * truncation_block_length is the length of the relation segment, in blocks,
+ * when it was backed up; blocks beyond it are to be discarded, and blocks
+ * below it that are not included come from the prior backup (or are zeroes,
+ * if the prior backup's file was shorter).
+ */
+typedef struct IncrementalFileHeader
+{
+	uint32		magic;
+	uint32		truncation_block_length;
+	uint32		num_blocks;
+} IncrementalFileHeader;
+
+#endif							/* BASEBACKUP_INCREMENTAL_H */
@@ -0,0 +1,27 @@
+/*-------------------------------------------------------------------------
+ *
+ * doublewrite.h
+ *	  Torn-page protection for data file writes via a double-write file.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/storage/doublewrite.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef DOUBLEWRITE_H
+#define DOUBLEWRITE_H
+
+#include "access/xlogdefs.h"
+#include "storage/buf_internals.h"
+
+#define DOUBLE_WRITE_FILE		"pg_doublewrite"
+
+/* GUC option */
+extern bool double_writes;
+
+extern char *DoubleWritePage(const BufferTag *tag, const char *page);
+extern void StartupDoubleWrite(bool crashRecovery, XLogRecPtr redo);
+
+#endif							/* DOUBLEWRITE_H */
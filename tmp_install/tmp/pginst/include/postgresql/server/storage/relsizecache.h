@@ -0,0 +1,37 @@
+/*-------------------------------------------------------------------------
+ *
+ * relsizecache.h
+ *	  Shared cache of relation fork sizes
+ *
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/storage/relsizecache.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef RELSIZECACHE_H
+#define RELSIZECACHE_H
+
+#include "storage/block.h"
+#include "storage/relfilenode.h"
+
+/* GUC variable */
+extern int	smgr_shared_relations;
+
+extern Size RelSizeCacheShmemSize(void);
+extern void RelSizeCacheShmemInit(void);
+
+extern BlockNumber RelSizeCacheLookup(RelFileNode rnode, ForkNumber forknum,
+				   uint64 *generation);
+extern void RelSizeCacheFill(RelFileNode rnode, ForkNumber forknum,
+				 BlockNumber nblocks, uint64 generation);
+extern void RelSizeCacheExtended(RelFileNode rnode, ForkNumber forknum,
+					 BlockNumber nblocks);
+extern void RelSizeCacheTruncated(RelFileNode rnode, ForkNumber forknum,
+					  BlockNumber nblocks);
+extern void RelSizeCacheForget(RelFileNode rnode, ForkNumber forknum);
+extern void RelSizeCacheForgetDatabase(Oid dbid);
+
+#endif							/* RELSIZECACHE_H */
@@ -0,0 +1,34 @@
+/*-------------------------------------------------------------------------
+ *
+ * actualrangecache.h
+ *	  Shared cache of btree index endpoints found by the planner
+ *
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/utils/actualrangecache.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef ACTUALRANGECACHE_H
+#define ACTUALRANGECACHE_H
+
+#include "utils/relcache.h"
+
+/* GUC variable */
+extern int	actual_range_cache_timeout;
+
+extern Size ActualRangeCacheShmemSize(void);
+extern void ActualRangeCacheShmemInit(void);
+
+extern bool ActualRangeCacheLookup(Relation indexRel, bool last,
+					   int16 typLen, bool typByVal,
+					   Datum *value, uint64 *generation);
+extern void ActualRangeCacheStore(Relation indexRel, bool last,
+					  int16 typLen, bool typByVal,
+					  Datum value, uint64 generation);
+extern void ActualRangeCacheInserted(Relation indexRel, bool first,
+						 bool last);
+
+#endif							/* ACTUALRANGECACHE_H */
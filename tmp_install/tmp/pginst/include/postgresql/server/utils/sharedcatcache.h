@@ -0,0 +1,33 @@
+/*-------------------------------------------------------------------------
+ *
+ * sharedcatcache.h
+ *	  Shared second-level catalog cache.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/utils/sharedcatcache.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef SHAREDCATCACHE_H
+#define SHAREDCATCACHE_H
+
+#include "access/htup.h"
+#include "nodes/pg_list.h"
+#include "storage/sinval.h"
+
+/* GUC variable, in kilobytes; zero disables the shared cache */
+extern int	shared_catalog_cache_size;
+
+extern Size SharedCatCacheShmemSize(void);
+extern void SharedCatCacheShmemInit(void);
+
+extern uint64 SharedCatCacheGetVersion(void);
+extern List *SharedCatCacheSearch(Oid dbId, int cacheId, uint32 hashValue);
+extern void SharedCatCacheInsert(Oid dbId, int cacheId, Oid reloid,
+					 uint32 hashValue, HeapTuple tuple, uint64 version);
+extern void SharedCatCacheInvalidateMessages(const SharedInvalidationMessage *msgs,
+								 int n);
+
+#endif							/* SHAREDCATCACHE_H */
@@ -0,0 +1,33 @@
+/*-------------------------------------------------------------------------
+ *
+ * sharedplancache.h
+ *	  Shared cache of generic plans.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/utils/sharedplancache.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef SHAREDPLANCACHE_H
+#define SHAREDPLANCACHE_H
+
+#include "nodes/pg_list.h"
+#include "storage/sinval.h"
+
+/* GUC variable, in kilobytes; zero disables the shared cache */
+extern int	shared_plan_cache_size;
+
+extern Size SharedPlanCacheShmemSize(void);
+extern void SharedPlanCacheShmemInit(void);
+
+extern uint64 SharedPlanCacheGetVersion(void);
+extern char *SharedPlanCacheLookup(const char *key, Size keylen);
+extern void SharedPlanCacheInsert(const char *key, Size keylen,
+					  const char *plan, List *relationOids,
+					  List *invalItems, uint64 version);
+extern void SharedPlanCacheInvalidateMessages(const SharedInvalidationMessage *msgs,
+								  int n);
+
+#endif							/* SHAREDPLANCACHE_H */
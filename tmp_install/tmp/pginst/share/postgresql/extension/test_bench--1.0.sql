@@ -0,0 +1,67 @@
+/* src/test/modules/test_bench/test_bench--1.0.sql */
+
+-- complain if script is sourced in psql, rather than via CREATE EXTENSION
+\echo Use "CREATE EXTENSION test_bench" to load this file. \quit
+
+--
+-- Harnesses.  All of them return one row describing the fastest of "loops"
+-- runs; see README.
+--
+CREATE FUNCTION bench_tuplesort(ntuples integer, loops integer DEFAULT 1,
+	OUT benchmark text, OUT ops bigint,
+	OUT elapsed_ms double precision, OUT ns_per_op double precision)
+	RETURNS record STRICT
+	AS 'MODULE_PATHNAME' LANGUAGE C;
+
+CREATE FUNCTION bench_hashagg(ntuples integer, ngroups integer,
+	loops integer DEFAULT 1,
+	OUT benchmark text, OUT ops bigint,
+	OUT elapsed_ms double precision, OUT ns_per_op double precision)
+	RETURNS record STRICT
+	AS 'MODULE_PATHNAME' LANGUAGE C;
+
+CREATE FUNCTION bench_expr(ntuples integer, loops integer DEFAULT 1,
+	OUT benchmark text, OUT ops bigint,
+	OUT elapsed_ms double precision, OUT ns_per_op double precision)
+	RETURNS record STRICT
+	AS 'MODULE_PATHNAME' LANGUAGE C;
+
+CREATE FUNCTION bench_xlog_insert(nrecords integer, record_size integer,
+	loops integer DEFAULT 1,
+	OUT benchmark text, OUT ops bigint,
+	OUT elapsed_ms double precision, OUT ns_per_op double precision)
+	RETURNS record STRICT
+	AS 'MODULE_PATHNAME' LANGUAGE C;
+
+CREATE FUNCTION bench_buffer_pin(rel regclass, npins integer,
+	loops integer DEFAULT 1,
+	OUT benchmark text, OUT ops bigint,
+	OUT elapsed_ms double precision, OUT ns_per_op double precision)
+	RETURNS record STRICT
+	AS 'MODULE_PATHNAME' LANGUAGE C;
+
+--
+-- Canonical workload set.  Keep the workload names stable: output from
+-- different builds is compared by joining on them.
+--
+CREATE FUNCTION test_bench_run(loops integer DEFAULT 5,
+	OUT workload text, OUT benchmark text, OUT ops bigint,
+	OUT elapsed_ms double precision, OUT ns_per_op double precision)
+	RETURNS SETOF record STRICT
+	AS $$
+	SELECT 'sort_int8_10k', * FROM bench_tuplesort(10000, loops)
+	UNION ALL
+	SELECT 'sort_int8_1m', * FROM bench_tuplesort(1000000, loops)
+	UNION ALL
+	SELECT 'hashagg_int8_1m_100', * FROM bench_hashagg(1000000, 100, loops)
+	UNION ALL
+	SELECT 'hashagg_int8_1m_100k', * FROM bench_hashagg(1000000, 100000, loops)
+	UNION ALL
+	SELECT 'expr_int8_arith_1m', * FROM bench_expr(1000000, loops)
+	UNION ALL
+	SELECT 'xlog_noop_0b_100k', * FROM bench_xlog_insert(100000, 0, loops)
+	UNION ALL
+	SELECT 'xlog_noop_1kb_100k', * FROM bench_xlog_insert(100000, 1024, loops)
+	UNION ALL
+	SELECT 'pin_pg_class_1m', * FROM bench_buffer_pin('pg_catalog.pg_class', 1000000, loops)
+	$$ LANGUAGE sql;
@@ -0,0 +1 @@
+grant usage on schema @extschema@ to public;